@@ -29,6 +29,7 @@
 #define SVN_CXXHL_HPP
 
 // Expose the whole API and alias the default version namespace
+#include "svncxxhl/cancel.hpp"
 #include "svncxxhl/exception.hpp"
 #include "svncxxhl/tristate.hpp"
 
@@ -0,0 +1,93 @@
+/**
+ * @copyright
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ * @endcopyright
+ */
+
+#ifndef __cplusplus
+#error "This is a C++ header file."
+#endif
+
+#ifndef SVN_CXXHL_CANCEL_HPP
+#define SVN_CXXHL_CANCEL_HPP
+
+#include "svncxxhl/_compat.hpp"
+
+namespace apache {
+namespace subversion {
+namespace cxxhl {
+
+namespace compat {} // Announce the compat namespace for shared_ptr lookup
+
+class Cancellation;
+
+namespace detail {
+// Forward declaration of implementation-specific structure
+class CancelState;
+
+// Forward declaration of the baton accessor
+void* cancel_baton(const Cancellation& cancellation) throw();
+} // namespace detail
+
+/**
+ * A request to cancel one or more running operations.
+ *
+ * Operations that take a Cancellation object check it whenever the
+ * underlying Subversion library checks for cancellation, and throw a
+ * Cancelled exception after cancel() has been called.  cancel() may be
+ * called from any thread.
+ *
+ * Copies of a Cancellation object share their state; cancelling any
+ * of them cancels all.
+ */
+class Cancellation
+{
+public:
+  /**
+   * Creates a new Cancellation object that is not cancelled.
+   */
+  Cancellation();
+
+  Cancellation(const Cancellation& that) throw();
+  Cancellation& operator=(const Cancellation& that) throw();
+  ~Cancellation() throw();
+
+  /**
+   * Requests cancellation.
+   */
+  void cancel() throw();
+
+  /**
+   * Returns @c true if cancel() has been called.
+   */
+  bool cancelled() const throw();
+
+private:
+  friend void* detail::cancel_baton(const Cancellation&) throw();
+
+  typedef compat::shared_ptr<detail::CancelState> state_ptr;
+  state_ptr m_state;
+};
+
+} // namespace cxxhl
+} // namespace subversion
+} // namespace apache
+
+#endif  // SVN_CXXHL_CANCEL_HPP
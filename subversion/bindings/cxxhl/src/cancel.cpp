@@ -0,0 +1,103 @@
+/**
+ * @copyright
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ * @endcopyright
+ */
+
+#include <apr_atomic.h>
+
+#include "svncxxhl/cancel.hpp"
+#include "private.hpp"
+
+#include "svn_error.h"
+#undef TRUE
+#undef FALSE
+
+namespace apache {
+namespace subversion {
+namespace cxxhl {
+
+namespace detail {
+
+class CancelState
+{
+public:
+  CancelState() throw()
+    : m_cancelled(0)
+    {}
+
+  void cancel() throw()
+    {
+      apr_atomic_set32(&m_cancelled, 1);
+    }
+
+  bool cancelled() throw()
+    {
+      return (0 != apr_atomic_read32(&m_cancelled));
+    }
+
+private:
+  volatile apr_uint32_t m_cancelled;
+};
+
+svn_error_t* cancel_func(void* baton)
+{
+  if (static_cast<CancelState*>(baton)->cancelled())
+    return svn_error_create(SVN_ERR_CANCELLED, NULL, NULL);
+  return SVN_NO_ERROR;
+}
+
+void* cancel_baton(const Cancellation& cancellation) throw()
+{
+  return cancellation.m_state.get();
+}
+
+} // namespace detail
+
+
+Cancellation::Cancellation()
+  : m_state(new detail::CancelState)
+{}
+
+Cancellation::Cancellation(const Cancellation& that) throw()
+  : m_state(that.m_state)
+{}
+
+Cancellation& Cancellation::operator=(const Cancellation& that) throw()
+{
+  m_state = that.m_state;
+  return *this;
+}
+
+Cancellation::~Cancellation() throw() {}
+
+void Cancellation::cancel() throw()
+{
+  m_state->cancel();
+}
+
+bool Cancellation::cancelled() const throw()
+{
+  return m_state->cancelled();
+}
+
+} // namespace cxxhl
+} // namespace subversion
+} // namespace apache
@@ -24,6 +24,7 @@
 #ifndef SVN_CXXHL_PRIVATE_PRIVATE_H
 #define SVN_CXXHL_PRIVATE_PRIVATE_H
 
+#include "private/cancel-private.hpp"
 #include "private/exception-private.hpp"
 
 #endif // SVN_CXXHL_PRIVATE_PRIVATE_H
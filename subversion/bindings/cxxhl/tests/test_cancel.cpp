@@ -0,0 +1,67 @@
+/*
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include "svncxxhl.hpp"
+#include "../src/private.hpp"
+
+#include <apr.h>
+#include "svn_error.h"
+#undef TRUE
+#undef FALSE
+
+#include <gmock/gmock.h>
+
+TEST(Cancellation, NotCancelled)
+{
+  SVN::Cancellation cancellation;
+  EXPECT_FALSE(cancellation.cancelled());
+  EXPECT_NO_THROW(SVN::detail::checked_call(
+                      SVN::detail::cancel_func(
+                          SVN::detail::cancel_baton(cancellation))));
+}
+
+TEST(Cancellation, Cancel)
+{
+  SVN::Cancellation cancellation;
+  void* const baton = SVN::detail::cancel_baton(cancellation);
+
+  cancellation.cancel();
+  EXPECT_TRUE(cancellation.cancelled());
+  EXPECT_THROW(SVN::detail::checked_call(SVN::detail::cancel_func(baton)),
+               SVN::Cancelled);
+}
+
+TEST(Cancellation, SharedState)
+{
+  SVN::Cancellation cancellation;
+  SVN::Cancellation copy(cancellation);
+  SVN::Cancellation other;
+
+  EXPECT_EQ(SVN::detail::cancel_baton(cancellation),
+            SVN::detail::cancel_baton(copy));
+
+  copy.cancel();
+  EXPECT_TRUE(cancellation.cancelled());
+  EXPECT_FALSE(other.cancelled());
+
+  other = cancellation;
+  EXPECT_TRUE(other.cancelled());
+}
@@ -118,6 +118,11 @@ public:
             ::Java::ByteArray::MutableContents& dst,
             jint offset, jint length);
 
+  /**
+   * Implements @c NativeInputStream.read(ByteBuffer).
+   */
+  jint read(::Java::Env env, jobject jdst);
+
   /**
    * Implements @c InputStream.skip(long).
    */
@@ -199,6 +204,11 @@ public:
              const ::Java::ByteArray::Contents& src,
              jint offset, jint length);
 
+  /**
+   * Implements @c NativeOutputStream.write(ByteBuffer).
+   */
+  jint write(::Java::Env env, jobject jsrc);
+
 private:
   virtual void dispose(jobject jthis);
 
@@ -218,13 +218,20 @@ SVNClient::status(const char *path, svn_depth_t depth,
 
     rev.kind = svn_opt_revision_unspecified;
 
-    SVN_JNI_ERR(svn_client_status6(&youngest, ctx, checkedPath.c_str(),
-                                   &rev, depth,
-                                   getAll, onServer, onDisk,
-                                   noIgnore, ignoreExternals, depthAsSticky,
-                                   changelists.array(subPool),
-                                   StatusCallback::callback, callback,
-                                   subPool.getPool()), );
+    svn_error_t *err = svn_client_status6(&youngest, ctx, checkedPath.c_str(),
+                                          &rev, depth,
+                                          getAll, onServer, onDisk,
+                                          noIgnore, ignoreExternals,
+                                          depthAsSticky,
+                                          changelists.array(subPool),
+                                          StatusCallback::callback, callback,
+                                          subPool.getPool());
+
+    // Deliver the items found before any error, just like unbatched
+    // callbacks would have seen them; unless the callback itself failed.
+    if (!svn_error_find_cause(err, SVN_ERR_JAVAHL_WRAPPED))
+      err = svn_error_compose_create(err, callback->flush());
+    SVN_JNI_ERR(err, );
 }
 
 /* Convert a vector of revision ranges to an APR array of same. */
@@ -30,13 +30,52 @@
 #include "JNIUtil.h"
 #include "svn_time.h"
 
+/**
+ * The number of status items passed to a StatusBatchCallback at once.
+ */
+static const jsize BATCH_SIZE = 256;
+
+/**
+ * Return a new array of class @a className[] holding the first @a count
+ * elements of @a jArray.
+ */
+static jobjectArray
+trimArray(JNIEnv *env, jobjectArray jArray, const char *className,
+          jsize count)
+{
+  jclass clazz = env->FindClass(className);
+  if (JNIUtil::isJavaExceptionThrown())
+    return NULL;
+
+  jobjectArray jTrimmed = env->NewObjectArray(count, clazz, NULL);
+  if (JNIUtil::isJavaExceptionThrown())
+    return NULL;
+
+  for (jsize i = 0; i < count; ++i)
+    {
+      jobject jItem = env->GetObjectArrayElement(jArray, i);
+      if (JNIUtil::isJavaExceptionThrown())
+        return NULL;
+
+      env->SetObjectArrayElement(jTrimmed, i, jItem);
+      if (JNIUtil::isJavaExceptionThrown())
+        return NULL;
+
+      env->DeleteLocalRef(jItem);
+    }
+
+  env->DeleteLocalRef(clazz);
+  return jTrimmed;
+}
+
 /**
  * Create a StatusCallback object
  * @param jcallback the Java callback object.
  */
 StatusCallback::StatusCallback(jobject jcallback)
+  : m_callback(jcallback), wc_ctx(NULL), m_batched(-1),
+    m_paths(NULL), m_statuses(NULL), m_count(0)
 {
-  m_callback = jcallback;
 }
 
 /**
@@ -45,7 +84,16 @@ StatusCallback::StatusCallback(jobject jcallback)
 StatusCallback::~StatusCallback()
 {
   // the m_callback does not need to be destroyed, because it is the passed
-  // in parameter to the Java SVNClient.status method.
+  // in parameter to the Java SVNClient.status method.  The batch, however,
+  // is ours.
+  if (m_paths || m_statuses)
+    {
+      JNIEnv *env = JNIUtil::getEnv();
+      if (m_paths)
+        env->DeleteGlobalRef(m_paths);
+      if (m_statuses)
+        env->DeleteGlobalRef(m_statuses);
+    }
 }
 
 svn_error_t *
@@ -76,10 +124,20 @@ StatusCallback::doStatus(const char *local_abspath,
   if (JNIUtil::isJavaExceptionThrown())
     return SVN_NO_ERROR;
 
+  if (m_batched < 0)
+    {
+      jclass clazz =
+        env->FindClass(JAVAHL_CLASS("/callback/StatusBatchCallback"));
+      if (JNIUtil::isJavaExceptionThrown())
+        POP_AND_RETURN(SVN_NO_ERROR);
+
+      m_batched = env->IsInstanceOf(m_callback, clazz) ? 1 : 0;
+    }
+
   static jmethodID mid = 0; // the method id will not change during
   // the time this library is loaded, so
   // it can be cached.
-  if (mid == 0)
+  if (mid == 0 && !m_batched)
     {
       jclass clazz = env->FindClass(JAVAHL_CLASS("/callback/StatusCallback"));
       if (JNIUtil::isJavaExceptionThrown())
@@ -100,11 +158,136 @@ StatusCallback::doStatus(const char *local_abspath,
   if (JNIUtil::isJavaExceptionThrown())
     POP_AND_RETURN(SVN_NO_ERROR);
 
+  if (m_batched)
+    {
+      svn_error_t *err = addToBatch(jPath, jStatus);
+      env->PopLocalFrame(NULL);
+      return err;
+    }
+
   env->CallVoidMethod(m_callback, mid, jPath, jStatus);
 
   POP_AND_RETURN_EXCEPTION_AS_SVNERROR();
 }
 
+/**
+ * Append a status item to the pending batch and deliver the batch if
+ * it is full.
+ */
+svn_error_t *
+StatusCallback::addToBatch(jstring jPath, jobject jStatus)
+{
+  JNIEnv *env = JNIUtil::getEnv();
+
+  if (m_paths == NULL)
+    {
+      jclass stringClazz = env->FindClass("java/lang/String");
+      if (JNIUtil::isJavaExceptionThrown())
+        return SVN_NO_ERROR;
+
+      jclass statusClazz = env->FindClass(JAVAHL_CLASS("/types/Status"));
+      if (JNIUtil::isJavaExceptionThrown())
+        return SVN_NO_ERROR;
+
+      jobjectArray jPaths = env->NewObjectArray(BATCH_SIZE, stringClazz,
+                                                NULL);
+      if (JNIUtil::isJavaExceptionThrown())
+        return SVN_NO_ERROR;
+
+      jobjectArray jStatuses = env->NewObjectArray(BATCH_SIZE, statusClazz,
+                                                   NULL);
+      if (JNIUtil::isJavaExceptionThrown())
+        return SVN_NO_ERROR;
+
+      m_paths = static_cast<jobjectArray>(env->NewGlobalRef(jPaths));
+      m_statuses = static_cast<jobjectArray>(env->NewGlobalRef(jStatuses));
+      env->DeleteLocalRef(jPaths);
+      env->DeleteLocalRef(jStatuses);
+    }
+
+  env->SetObjectArrayElement(m_paths, m_count, jPath);
+  if (JNIUtil::isJavaExceptionThrown())
+    return SVN_NO_ERROR;
+
+  env->SetObjectArrayElement(m_statuses, m_count, jStatus);
+  if (JNIUtil::isJavaExceptionThrown())
+    return SVN_NO_ERROR;
+
+  if (++m_count == BATCH_SIZE)
+    return flush();
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+StatusCallback::flush()
+{
+  if (m_count == 0)
+    return SVN_NO_ERROR;
+
+  JNIEnv *env = JNIUtil::getEnv();
+  jobjectArray jPaths = m_paths;
+  jobjectArray jStatuses = m_statuses;
+  const jsize count = m_count;
+
+  // The Java callback owns the arrays once we passed them on; the next
+  // batch will need new ones.
+  m_paths = NULL;
+  m_statuses = NULL;
+  m_count = 0;
+
+  // Create a local frame for our references
+  env->PushLocalFrame(LOCAL_FRAME_SIZE);
+  if (JNIUtil::isJavaExceptionThrown())
+    {
+      env->DeleteGlobalRef(jPaths);
+      env->DeleteGlobalRef(jStatuses);
+      return SVN_NO_ERROR;
+    }
+
+  // Hand over local references; the frame will release them.
+  jobjectArray jLocalPaths =
+    static_cast<jobjectArray>(env->NewLocalRef(jPaths));
+  jobjectArray jLocalStatuses =
+    static_cast<jobjectArray>(env->NewLocalRef(jStatuses));
+  env->DeleteGlobalRef(jPaths);
+  env->DeleteGlobalRef(jStatuses);
+
+  static jmethodID mid = 0; // the method id will not change during
+  // the time this library is loaded, so
+  // it can be cached.
+  if (mid == 0)
+    {
+      jclass clazz =
+        env->FindClass(JAVAHL_CLASS("/callback/StatusBatchCallback"));
+      if (JNIUtil::isJavaExceptionThrown())
+        POP_AND_RETURN(SVN_NO_ERROR);
+
+      mid = env->GetMethodID(clazz, "doStatus",
+                             "([Ljava/lang/String;"
+                             "[" JAVAHL_ARG("/types/Status;") ")V");
+      if (JNIUtil::isJavaExceptionThrown() || mid == 0)
+        POP_AND_RETURN(SVN_NO_ERROR);
+    }
+
+  // The last batch is usually not full; trim the arrays to size.
+  if (count < BATCH_SIZE)
+    {
+      jLocalPaths = trimArray(env, jLocalPaths, "java/lang/String", count);
+      if (JNIUtil::isJavaExceptionThrown())
+        POP_AND_RETURN(SVN_NO_ERROR);
+
+      jLocalStatuses = trimArray(env, jLocalStatuses,
+                                 JAVAHL_CLASS("/types/Status"), count);
+      if (JNIUtil::isJavaExceptionThrown())
+        POP_AND_RETURN(SVN_NO_ERROR);
+    }
+
+  env->CallVoidMethod(m_callback, mid, jLocalPaths, jLocalStatuses);
+
+  POP_AND_RETURN_EXCEPTION_AS_SVNERROR();
+}
+
 void
 StatusCallback::setWcCtx(svn_wc_context_t *wc_ctx_in)
 {
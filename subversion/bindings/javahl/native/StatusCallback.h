@@ -33,6 +33,10 @@
 /**
  * This class holds a Java callback object, each status item
  * for which the callback information is requested.
+ *
+ * If the Java object implements StatusBatchCallback, the items are
+ * collected and passed on in batches; call flush() after the status
+ * walk to deliver the last one.
  */
 class StatusCallback
 {
@@ -47,6 +51,11 @@ class StatusCallback
                                const svn_client_status_t *status,
                                apr_pool_t *pool);
 
+  /**
+   * Deliver the pending batch of status items, if any.
+   */
+  svn_error_t *flush();
+
  protected:
   svn_error_t *doStatus(const char *local_abspath,
                         const svn_client_status_t *status,
@@ -59,6 +68,22 @@ class StatusCallback
   jobject m_callback;
 
   svn_wc_context_t *wc_ctx;
+
+  /**
+   * Whether m_callback is a StatusBatchCallback: 1 if it is, 0 if
+   * not and -1 if we don't know yet.
+   */
+  int m_batched;
+
+  /**
+   * Global references to the pending batch of paths and statuses,
+   * and the number of items in them.
+   */
+  jobjectArray m_paths;
+  jobjectArray m_statuses;
+  jsize m_count;
+
+  svn_error_t *addToBatch(jstring jPath, jobject jStatus);
 };
 
 #endif // STATUSCALLBACK_H
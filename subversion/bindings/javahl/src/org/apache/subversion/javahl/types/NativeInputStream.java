@@ -27,6 +27,7 @@ import org.apache.subversion.javahl.NativeResources;
 
 import java.io.IOException;
 import java.io.InputStream;
+import java.nio.ByteBuffer;
 
 /**
  * Implementation class for {@link InputStream} objects returned from
@@ -85,6 +86,18 @@ public class NativeInputStream extends InputStream
     @Override
     public native int read(byte[] b, int off, int len) throws IOException;
 
+    /**
+     * Reads bytes from the underyling native stream into the remaining
+     * space of <code>dst</code> and advances its position.
+     * <p>
+     * A direct buffer is filled in place, without copying the data
+     * through a temporary <code>byte[]</code>.
+     * @return the number of bytes read, which may be zero if
+     *         <code>dst</code> has no space left, or -1 at end of stream.
+     * @since 1.11
+     */
+    public native int read(ByteBuffer dst) throws IOException;
+
     /**
      * @see InputStream.skip(long)
      */
@@ -27,6 +27,7 @@ import org.apache.subversion.javahl.NativeResources;
 
 import java.io.IOException;
 import java.io.OutputStream;
+import java.nio.ByteBuffer;
 
 /**
  * Implementation class for {@link OutputStream} objects returned from
@@ -67,6 +68,17 @@ public class NativeOutputStream extends OutputStream
     @Override
     public native void write(byte[] b, int off, int len) throws IOException;
 
+    /**
+     * Writes the remaining bytes of <code>src</code> to the underyling
+     * native stream and advances its position.
+     * <p>
+     * The contents of a direct buffer are written in place, without
+     * copying them through a temporary <code>byte[]</code>.
+     * @return the number of bytes written.
+     * @since 1.11
+     */
+    public native int write(ByteBuffer src) throws IOException;
+
 
     private long cppAddr;
 
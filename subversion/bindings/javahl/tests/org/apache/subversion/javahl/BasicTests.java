@@ -346,6 +346,43 @@ public class BasicTests extends SVNTests
             fail("File foo.c should return exactly one empty status.");
     }
 
+    /**
+     * Test that {@link StatusBatchCallback} sees the same status items as
+     * a plain {@link StatusCallback}.
+     * @throws Throwable
+     */
+    public void testBatchedStatus() throws Throwable
+    {
+        // build the test setup
+        OneTest thisTest = new OneTest();
+
+        // Add enough unversioned files to fill more than one batch.
+        File dir = new File(thisTest.getWorkingCopy(), "A/B");
+        for (int i = 0; i < 600; ++i)
+            new File(dir, "unversioned-" + i).createNewFile();
+
+        MyStatusCallback statusCallback = new MyStatusCallback();
+        client.status(thisTest.getWCPath(), Depth.infinity,
+                      false, true, true, false, false, false,
+                      null, statusCallback);
+
+        MyStatusBatchCallback batchCallback = new MyStatusBatchCallback();
+        client.status(thisTest.getWCPath(), Depth.infinity,
+                      false, true, true, false, false, false,
+                      null, batchCallback);
+
+        Status[] expected = statusCallback.getStatusArray();
+        Status[] actual = batchCallback.getStatusArray();
+        assertTrue(batchCallback.getBatchCount() > 1);
+        assertEquals(expected.length, actual.length);
+        for (int i = 0; i < expected.length; ++i)
+        {
+            assertEquals(expected[i].getPath(), actual[i].getPath());
+            assertEquals(expected[i].getNodeStatus(),
+                         actual[i].getNodeStatus());
+        }
+    }
+
     /**
      * Test the "out of date" info from {@link
      * org.apache.subversion.javahl.SVNClient#status()}.
@@ -4520,6 +4557,30 @@ public class BasicTests extends SVNTests
         }
     }
 
+    private class MyStatusBatchCallback extends MyStatusCallback
+        implements StatusBatchCallback
+    {
+        private int batches = 0;
+
+        public void doStatus(String[] paths, Status[] statuses)
+        {
+            assertEquals(paths.length, statuses.length);
+            ++batches;
+            for (int i = 0; i < paths.length; ++i)
+                super.doStatus(paths[i], statuses[i]);
+        }
+
+        public void doStatus(String path, Status status)
+        {
+            fail("StatusBatchCallback got a single status item");
+        }
+
+        public int getBatchCount()
+        {
+            return batches;
+        }
+    }
+
     private class ConstMsg implements CommitMessageCallback
     {
         private String message;
@@ -24,6 +24,8 @@
 package org.apache.subversion.javahl;
 
 import org.apache.subversion.javahl.types.ExternalItem;
+import org.apache.subversion.javahl.types.NativeInputStream;
+import org.apache.subversion.javahl.types.NativeOutputStream;
 import org.apache.subversion.javahl.types.NodeKind;
 import org.apache.subversion.javahl.types.Revision;
 
@@ -35,6 +37,7 @@ import java.io.ByteArrayInputStream;
 import java.io.ByteArrayOutputStream;
 import java.io.InputStream;
 import java.io.OutputStream;
+import java.nio.ByteBuffer;
 import java.util.Arrays;
 import java.util.ArrayList;
 import java.util.Date;
@@ -589,6 +592,57 @@ public class UtilTests extends SVNTests
         }
     }
 
+    public void testTranslateStreamByteBuffer() throws Throwable
+    {
+        final byte[] contentsContracted = "line1\nline2\n".getBytes();
+        final byte[] contentsExpanded = "line1\r\nline2\r\n".getBytes();
+        final Map<String, byte[]> keywords = new HashMap<String, byte[]>();
+
+        // Both direct and heap buffers; read in small pieces.
+        for (boolean direct : new boolean[]{ true, false })
+        {
+            ByteBuffer buffer = (direct ? ByteBuffer.allocateDirect(5)
+                                        : ByteBuffer.allocate(5));
+            ByteArrayOutputStream result = new ByteArrayOutputStream();
+            NativeInputStream testin = (NativeInputStream)
+                SVNUtil.translateStream(
+                    new ByteArrayInputStream(contentsContracted),
+                    SVNUtil.EOL_CRLF, true, keywords, false);
+            try {
+                while (testin.read(buffer) >= 0)
+                {
+                    byte[] piece = new byte[buffer.flip().remaining()];
+                    buffer.get(piece);
+                    result.write(piece);
+                    buffer.clear();
+                }
+            } finally {
+                testin.close();
+            }
+
+            assertEquals("read InputStream into ByteBuffer",
+                         new String(contentsExpanded), result.toString());
+
+            result = new ByteArrayOutputStream();
+            NativeOutputStream testout = (NativeOutputStream)
+                SVNUtil.translateStream(result, SVNUtil.EOL_LF, true,
+                                        keywords, false);
+            try {
+                buffer = (direct
+                          ? ByteBuffer.allocateDirect(contentsExpanded.length)
+                          : ByteBuffer.allocate(contentsExpanded.length));
+                buffer.put(contentsExpanded).flip();
+                assertEquals(contentsExpanded.length, testout.write(buffer));
+                assertEquals(0, buffer.remaining());
+            } finally {
+                testout.close();
+            }
+
+            assertEquals("write OutputStream from ByteBuffer",
+                         new String(contentsContracted), result.toString());
+        }
+    }
+
 
     // Credentials definitions for testing the credentials utilities
     private static final String util_cred_hash =
@@ -892,6 +892,11 @@ static void svn_auth_set_gnome_keyring_unlock_prompt_func(svn_auth_baton_t *ab,
 void svn_swig_py_set_application_pool(PyObject *py_pool, apr_pool_t *pool);
 void svn_swig_py_clear_application_pool();
 
+/* This one handles the Python lock itself because it needs it to access
+   the buffer object. */
+%noexception svn_swig_py_stream_readinto;
+PyObject *svn_swig_py_stream_readinto(svn_stream_t *stream, PyObject *buffer);
+
 %init %{
 /* Theoretically, we should be checking for errors here,
    but I do not know of any useful way to signal an error to Python
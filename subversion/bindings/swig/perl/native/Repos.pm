@@ -263,7 +263,8 @@ push @methods,
          lock_dir db_lockfile db_logs_lockfile hook_dir
          pre_revprop_change_hook pre_lock_hook pre_unlock_hook
          begin_report2 begin_report link_path3 link_path2 link_path
-         delete_path finish_report dir_delta2 dir_delta replay2 replay
+         delete_path finish_report dir_delta3 dir_delta2 dir_delta replay2
+         replay
          dated_revision stat deleted_rev history2 history
          trace_node_locations fs_begin_txn_for_commit2
          fs_begin_txn_for_commit fs_begin_txn_for_update fs_lock
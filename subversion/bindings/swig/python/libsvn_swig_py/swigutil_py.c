@@ -139,6 +139,13 @@ apr_status_t svn_swig_py_initialize(void)
     return status;
   if (atexit(apr_terminate) != 0)
     return APR_EGENERAL;
+
+#ifdef ACQUIRE_PYTHON_LOCK
+  /* Make sure there is a lock to release, even if the calling script
+     didn't start any threads yet. */
+  PyEval_InitThreads();
+#endif
+
   return APR_SUCCESS;
 }
 
@@ -2588,6 +2595,35 @@ svn_swig_py_make_stream(PyObject *py_io, apr_pool_t *pool)
   return stream;
 }
 
+PyObject *
+svn_swig_py_stream_readinto(svn_stream_t *stream, PyObject *buffer)
+{
+  Py_buffer view;
+  apr_size_t len;
+  svn_error_t *err;
+
+  /* The buffer can't be resized or freed while we hold the view, so it is
+     safe to fill it without the Python lock. */
+  if (PyObject_GetBuffer(buffer, &view, PyBUF_WRITABLE) < 0)
+    return NULL;
+
+  len = view.len;
+  svn_swig_py_release_py_lock();
+  err = svn_stream_read_full(stream, view.buf, &len);
+  svn_swig_py_acquire_py_lock();
+
+  PyBuffer_Release(&view);
+
+  if (err)
+    {
+      svn_swig_py_svn_exception(err);
+      svn_error_clear(err);
+      return NULL;
+    }
+
+  return PyInt_FromSsize_t((Py_ssize_t)len);
+}
+
 PyObject *
 svn_swig_py_convert_txdelta_op_c_array(int num_ops,
                                        svn_txdelta_op_t *ops,
@@ -264,6 +264,13 @@ apr_file_t *svn_swig_py_make_file(PyObject *py_file,
 svn_stream_t *svn_swig_py_make_stream(PyObject *py_io,
                                       apr_pool_t *pool);
 
+/* Read from STREAM directly into the writable BUFFER object, using the
+   buffer protocol, until it is full or STREAM is exhausted.  Return the
+   number of bytes read as a Python integer, or NULL with an exception
+   set.  The Python lock is released while reading. */
+PyObject *svn_swig_py_stream_readinto(svn_stream_t *stream,
+                                      PyObject *buffer);
+
 /* Convert ops, a C array of num_ops elements, to a Python list of SWIG
    objects with descriptor op_type_info and pool set to parent_pool. */
 PyObject *
@@ -176,6 +176,15 @@ class Stream:
     # read the amount specified
     return svn_stream_read(self._stream, int(amt))
 
+  def readinto(self, b):
+    """Read up to len(b) bytes into the writable buffer object B, e.g. a
+    bytearray, without creating intermediate strings.  Return the number
+    of bytes read, which is smaller than len(b) only at the end of the
+    stream."""
+    if self._stream is None:
+      raise ValueError
+    return _libsvncore.svn_swig_py_stream_readinto(self._stream, b)
+
   def write(self, buf):
     if self._stream is None:
       raise ValueError
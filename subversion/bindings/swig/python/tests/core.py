@@ -170,6 +170,24 @@ class SubversionCoreTestCase(unittest.TestCase):
     self.assertEqual(
       svn.core.svn_config_enumerate_sections2(cfg, enumerator), 1)
 
+  def test_stream_readinto(self):
+    data = "0123456789" * 1000
+    stream = svn.core.Stream(svn.core.svn_stream_from_stringbuf(data))
+
+    buf = bytearray(4096)
+    self.assertEqual(stream.readinto(buf), 4096)
+    self.assertEqual(str(buf), data[:4096])
+
+    # Short reads only happen at the end of the stream.
+    self.assertEqual(stream.readinto(buf), 4096)
+    self.assertEqual(stream.readinto(buf), len(data) - 8192)
+    self.assertEqual(str(buf[:len(data) - 8192]), data[8192:])
+    self.assertEqual(stream.readinto(buf), 0)
+
+    # Only writable buffers will do.
+    self.assertRaises((TypeError, BufferError), stream.readinto, "immutable")
+    stream.close()
+
 def suite():
     return unittest.defaultTestLoader.loadTestsFromTestCase(
       SubversionCoreTestCase)
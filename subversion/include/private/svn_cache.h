@@ -36,6 +36,7 @@
 #include "svn_iter.h"
 #include "svn_config.h"
 #include "svn_string.h"
+#include "svn_io.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -148,6 +149,23 @@ typedef struct svn_cache__info_t
    */
   apr_uint64_t failures;
 
+  /** Number of entries dropped to make room for new ones.
+   * Only reported by membuffer caches.
+   */
+  apr_uint64_t evictions;
+
+  /** Number of lock-free lookups that had to be retried or fall back to
+   * the locked path due to concurrent modifications.
+   * Only reported by membuffer caches.
+   */
+  apr_uint64_t optimistic_retries;
+
+  /** Number of hits that have been served without taking any lock.
+   * Counted per back-end, i.e. shared by all front-end caches using it.
+   * Only reported by membuffer caches.
+   */
+  apr_uint64_t lock_free_hits;
+
   /** Size of the data currently stored in the cache.
    * May be 0 if that information is not available.
    */
@@ -299,6 +317,15 @@ svn_cache__make_memcache_from_config(svn_memcache_t **memcache_p,
  * (no data being written to the cache) if some reader or another writer
  * currently holds the segment lock.
  *
+ * If @a shared_memory is set, the data buffers and index will be placed
+ * in an anonymous shared memory block and access will be serialized by
+ * cross-process locks.  All child processes forked after this call will
+ * then see and update the same cache contents.  Keys will not be shared
+ * through a process-local prefix pool in that mode, i.e. each entry will
+ * store its full key.  Returns #SVN_ERR_UNSUPPORTED_FEATURE if the platform
+ * does not support shared memory.  Child processes must call
+ * svn_cache__membuffer_child_init() before accessing the cache.
+ *
  * Allocations will be made in @a result_pool, in particular the data buffers.
  */
 svn_error_t *
@@ -308,8 +335,106 @@ svn_cache__membuffer_cache_create(svn_membuffer_t **cache,
                                   apr_size_t segment_count,
                                   svn_boolean_t thread_safe,
                                   svn_boolean_t allow_blocking_writes,
+                                  svn_boolean_t shared_memory,
                                   apr_pool_t *result_pool);
 
+/**
+ * Re-attach the current process to the cross-process locks of the shared
+ * memory @a cache, see svn_cache__membuffer_cache_create().  This must be
+ * called in every process forked from the one that created @a cache,
+ * before it accesses @a cache.  Does nothing for process-local caches.
+ *
+ * The lock handles will be allocated in @a pool, which must live as long
+ * as the process uses @a cache.
+ *
+ * @since New in 1.11.
+ */
+svn_error_t *
+svn_cache__membuffer_child_init(svn_membuffer_t *cache,
+                                apr_pool_t *pool);
+
+/**
+ * Add a third cache level to the membuffer @a cache that lives in a
+ * memory-mapped file of @a size bytes in the directory @a dir_path,
+ * typically on a local SSD.  Items evicted from @a cache will be written
+ * to that file, unless they have #SVN_CACHE__MEMBUFFER_LOW_PRIORITY, and
+ * cache misses will be looked up there.  Items found in the file get
+ * promoted back into @a cache.  The file is a circular buffer with an
+ * in-memory index of about 40 bytes per 16kB of file size, allocated in
+ * @a result_pool.  The file gets deleted when @a result_pool is cleaned up.
+ *
+ * If @a thread_safe is set, access to the file will be serialized.
+ * This must be called before @a cache is being used.  Returns
+ * #SVN_ERR_UNSUPPORTED_FEATURE for caches in shared memory or if the
+ * platform does not support memory-mapped files.
+ *
+ * @since New in 1.11.
+ */
+svn_error_t *
+svn_cache__membuffer_attach_overflow(svn_membuffer_t *cache,
+                                     const char *dir_path,
+                                     apr_uint64_t size,
+                                     svn_boolean_t thread_safe,
+                                     apr_pool_t *result_pool);
+
+/**
+ * A callback deciding whether cache entries with the given key @a prefix
+ * shall be kept in a cache snapshot.  Set @a *keep accordingly.
+ * @a baton is provided by the caller.  Use @a scratch_pool for temporary
+ * allocations.
+ *
+ * @since New in 1.11.
+ */
+typedef svn_error_t *(*svn_cache__prefix_filter_t)(svn_boolean_t *keep,
+                                                   void *baton,
+                                                   const char *prefix,
+                                                   apr_pool_t *scratch_pool);
+
+/**
+ * Write the contents of the membuffer @a cache to @a stream, such that
+ * they can be restored by svn_cache__membuffer_load(), e.g. after a
+ * server restart.  If @a filter is not @c NULL, only entries whose key
+ * prefix gets accepted by @a filter (called with @a filter_baton) will
+ * be written.  Use @a scratch_pool for temporary allocations.
+ *
+ * Each cache segment is being written under a read lock, so concurrent
+ * reads may continue while writes to that segment will usually be
+ * dropped.  Snapshots can only be read by processes with the same native
+ * byte order and cache serialization formats.
+ *
+ * Returns #SVN_ERR_UNSUPPORTED_FEATURE for builds that perform cache
+ * consistency checks.
+ *
+ * @since New in 1.11.
+ */
+svn_error_t *
+svn_cache__membuffer_save(svn_membuffer_t *cache,
+                          svn_stream_t *stream,
+                          svn_cache__prefix_filter_t filter,
+                          void *filter_baton,
+                          apr_pool_t *scratch_pool);
+
+/**
+ * Read the snapshot written by svn_cache__membuffer_save() from
+ * @a stream and add its entries to the membuffer @a cache, replacing
+ * existing entries with the same keys.  If @a filter is not @c NULL,
+ * only entries whose key prefix gets accepted by @a filter (called with
+ * @a filter_baton) will be added.  Use @a scratch_pool for temporary
+ * allocations.
+ *
+ * Returns #SVN_ERR_MALFORMED_FILE if @a stream does not contain a
+ * compatible snapshot.  Entries read before the error was detected remain
+ * in @a cache.
+ *
+ * @since New in 1.11.
+ */
+svn_error_t *
+svn_cache__membuffer_load(svn_membuffer_t *cache,
+                          svn_stream_t *stream,
+                          svn_cache__prefix_filter_t filter,
+                          void *filter_baton,
+                          apr_pool_t *scratch_pool);
+
 /**
  * @defgroup Standard priority classes for #svn_cache__create_membuffer_cache.
  * @{
@@ -378,6 +503,22 @@ svn_cache__create_membuffer_cache(svn_cache__t **cache_p,
                                   apr_pool_t *result_pool,
                                   apr_pool_t *scratch_pool);
 
+/**
+ * Make the membuffer cache @a cache check @a *bulk_scan whenever it writes
+ * an item.  While that is set, the data is assumed to belong to a bulk
+ * scan like "svnadmin dump" and gets written with
+ * #SVN_CACHE__MEMBUFFER_LOW_PRIORITY, so it won't replace other data that
+ * is being used frequently.  @a bulk_scan may be @c NULL and must remain
+ * valid for the lifetime of @a cache.
+ *
+ * No-op if @a cache is not a membuffer cache.
+ *
+ * @since New in 1.11.
+ */
+void
+svn_cache__membuffer_set_bulk_hint(svn_cache__t *cache,
+                                   const svn_boolean_t *bulk_scan);
+
 /**
  * Creates a null-cache instance in @a *cache_p, allocated from
  * @a result_pool.  The given @c id is the only data stored in it and can
@@ -433,6 +574,25 @@ svn_cache__get(void **value,
                const void *key,
                apr_pool_t *result_pool);
 
+/**
+ * Fetches the values indexed by @a keys, an array of <tt>const void *</tt>,
+ * from @a cache.  Sets @a *values to an array of <tt>void *</tt> holding
+ * the value for the key at the same position in @a keys or @c NULL if that
+ * key is not found.  Keys may be NULL, in which case they will not be
+ * found.  The values and the array are allocated in @a result_pool.
+ *
+ * This is equivalent to calling svn_cache__get() for each key but allows
+ * the backend to process all lookups in a single batch.  For memcached,
+ * this means one round trip per server instead of one per key.
+ *
+ * @since New in 1.11.
+ */
+svn_error_t *
+svn_cache__get_many(apr_array_header_t **values,
+                    svn_cache__t *cache,
+                    const apr_array_header_t *keys,
+                    apr_pool_t *result_pool);
+
 /**
  * Looks for an entry indexed by @a key in @a cache,  setting @a *found
  * to TRUE if an entry has been found and FALSE otherwise.  @a key may be
@@ -464,6 +624,23 @@ svn_cache__set(svn_cache__t *cache,
                void *value,
                apr_pool_t *scratch_pool);
 
+/**
+ * Stores the values in @a values, an array of <tt>void *</tt>, in
+ * @a cache under the respective keys in @a keys, an array of
+ * <tt>const void *</tt> with the same number of elements.  NULL keys
+ * will be skipped.
+ *
+ * This is equivalent to calling svn_cache__set() for each key but allows
+ * the backend to process all updates in a single batch.
+ *
+ * @since New in 1.11.
+ */
+svn_error_t *
+svn_cache__set_many(svn_cache__t *cache,
+                    const apr_array_header_t *keys,
+                    const apr_array_header_t *values,
+                    apr_pool_t *scratch_pool);
+
 /**
  * Iterates over the elements currently in @a cache, calling @a func
  * for each one until there are no more elements or @a func returns an
@@ -508,6 +685,58 @@ svn_cache__get_partial(void **value,
                        void *baton,
                        apr_pool_t *result_pool);
 
+/**
+ * A reference to a cache entry returned by svn_cache__get_pinned().
+ *
+ * @since New in 1.11.
+ */
+typedef struct svn_cache__pinned_t svn_cache__pinned_t;
+
+/**
+ * Looks for the entry indexed by @a key in @a cache and provides
+ * read-only access to its serialized form, i.e. the data produced by
+ * the cache's serialize function.  If it has been found, set @a *found
+ * to TRUE, set @a *data and @a *data_len to the serialized entry and
+ * set @a *pin to the reference that keeps @a *data valid.  Otherwise,
+ * set @a *found to FALSE and both, @a *data and @a *pin to NULL.  For a
+ * @c NULL @a key, no data will be found.
+ *
+ * @a *data must not be modified.  Pointers within it are still relative
+ * to the start of the buffer, use svn_temp_deserializer__ptr() to follow
+ * them.
+ *
+ * Membuffer caches return a pointer directly into the cache memory and
+ * will not modify or evict any entry in the respective cache segment
+ * until @a *pin has been released.  Therefore, call svn_cache__unpin()
+ * in the same thread as soon as possible, and don't access any cache
+ * sharing the same membuffer while holding the pin.  Other cache
+ * implementations return a copy allocated in @a result_pool.
+ *
+ * @a *pin is allocated in @a result_pool and will be released
+ * automatically when that pool gets cleaned up.  It may be @c NULL if
+ * there is nothing to release.
+ *
+ * @since New in 1.11.
+ */
+svn_error_t *
+svn_cache__get_pinned(const void **data,
+                      apr_size_t *data_len,
+                      svn_boolean_t *found,
+                      svn_cache__pinned_t **pin,
+                      svn_cache__t *cache,
+                      const void *key,
+                      apr_pool_t *result_pool);
+
+/**
+ * Release the cache entry reference @a pin returned by
+ * svn_cache__get_pinned().  After that, the data returned with @a pin
+ * must no longer be accessed.  @a pin may be @c NULL.
+ *
+ * @since New in 1.11.
+ */
+svn_error_t *
+svn_cache__unpin(svn_cache__pinned_t *pin);
+
 /**
  * Find the item identified by @a key in the @a cache. If it has been found,
  * call @a func for it and @a baton to potentially modify the data. Changed
@@ -554,6 +783,52 @@ svn_cache__format_info(const svn_cache__info_t *info,
 struct svn_membuffer_t *
 svn_cache__get_global_membuffer_cache(void);
 
+/**
+ * Request that the process-global membuffer cache be placed in shared
+ * memory if @a shared is set.  This must be called before the first call
+ * to svn_cache__get_global_membuffer_cache() to have any effect.  Server
+ * processes that fork their workers should then create the global cache
+ * in the parent process, e.g. by calling that function, so that all
+ * workers use the same cache contents.
+ *
+ * If the shared memory cache cannot be created, a normal process-local
+ * cache will be used instead.
+ *
+ * This function is not thread-safe.
+ *
+ * @since New in 1.11.
+ */
+void
+svn_cache__set_global_membuffer_shared(svn_boolean_t shared);
+
+/**
+ * Return whether the process-global membuffer cache has been configured
+ * to use shared memory.
+ *
+ * @since New in 1.11.
+ */
+svn_boolean_t
+svn_cache__get_global_membuffer_shared(void);
+
+/**
+ * Request that the process-global membuffer cache overflow into a file
+ * of @a size bytes in the directory @a dir_path, see
+ * svn_cache__membuffer_attach_overflow().  A @a size of 0 disables the
+ * overflow file.  @a dir_path must remain valid until the global cache
+ * has been created.  This must be called before the first call to
+ * svn_cache__get_global_membuffer_cache() to have any effect.
+ *
+ * The overflow file is not available for caches in shared memory.  If it
+ * cannot be created, the global cache will simply not use one.
+ *
+ * This function is not thread-safe.
+ *
+ * @since New in 1.11.
+ */
+void
+svn_cache__set_global_membuffer_overflow(const char *dir_path,
+                                         apr_uint64_t size);
+
 /**
  * Return total access and size stats over all membuffer caches as they
  * share the underlying data buffer.  The result will be allocated in POOL.
@@ -101,6 +101,29 @@ svn_delta__delta_from_editor(const svn_delta_editor_t **deditor,
                              struct svn_delta__extra_baton *exb,
                              apr_pool_t *pool);
 
+/** Like svn_txdelta2() but produce windows of up to 1 MB of target data
+ * whose source views slide forward, each one repeating the last 512 kB
+ * of the previous one.  This finds matches across window boundaries and
+ * despite insertions and deletions that shift the data.
+ *
+ * Such windows can only be written as svndiff version 3.
+ */
+void
+svn_txdelta__large(svn_txdelta_stream_t **stream,
+                   svn_stream_t *source,
+                   svn_stream_t *target,
+                   svn_boolean_t calculate_checksum,
+                   apr_pool_t *pool);
+
+/** Like svn_txdelta_target_push() but produce windows as described for
+ * svn_txdelta__large().
+ */
+svn_stream_t *
+svn_txdelta__target_push_large(svn_txdelta_window_handler_t handler,
+                               void *handler_baton,
+                               svn_stream_t *source,
+                               apr_pool_t *pool);
+
 /** Read the txdelta window header from @a stream and return the total
     length of the unparsed window data in @a *window_len. */
 svn_error_t *
@@ -108,6 +131,32 @@ svn_txdelta__read_raw_window_len(apr_size_t *window_len,
                                  svn_stream_t *stream,
                                  apr_pool_t *pool);
 
+/** A function to fetch the next window of a delta stream in its stored
+ * svndiff form.  Set @a *raw_window to the svndiff data of that window,
+ * excluding the svndiff stream header, and @a *svndiff_version to the
+ * format version it is in.  Set @a *raw_window to @c NULL if there are
+ * no more windows.  @a baton is the baton given to
+ * svn_txdelta_stream_create().  Allocate the result in @a pool.
+ *
+ * Calls to this function and to the stream's #svn_txdelta_next_window_fn_t
+ * must not be mixed.
+ */
+typedef svn_error_t *
+(*svn_txdelta__next_raw_window_fn_t)(const svn_string_t **raw_window,
+                                     int *svndiff_version,
+                                     void *baton,
+                                     apr_pool_t *pool);
+
+/** Allow svn_txdelta_send_txstream() to fetch the windows of @a stream
+ * through @a next_raw_window and to forward them verbatim to svndiff
+ * encoders that use the same format version instead of parsing and
+ * re-encoding them.
+ */
+void
+svn_txdelta__stream_set_raw_window_func(
+  svn_txdelta_stream_t *stream,
+  svn_txdelta__next_raw_window_fn_t next_raw_window);
+
 /* Return a debug editor that wraps @a wrapped_editor.
  *
  * The debug editor simply prints an indication of what callbacks are being
@@ -127,6 +176,51 @@ svn_delta__get_debug_editor(const svn_delta_editor_t **editor,
                             apr_pool_t *pool);
 
 
+/* The recorded drive of a delta editor. */
+typedef struct svn_delta__spool_t svn_delta__spool_t;
+
+/* Set *EDITOR and *EDIT_BATON to an editor that records all calls made
+ * to it in *SPOOL, except close_edit() and abort_edit().  Keep up to
+ * MEMORY_SIZE bytes of text delta data in memory and write the rest to
+ * a temporary file.  Allocate everything in POOL, which must outlive
+ * the use of *SPOOL.
+ *
+ * @since New in 1.11.
+ */
+svn_error_t *
+svn_delta__get_spool_editor(const svn_delta_editor_t **editor,
+                            void **edit_baton,
+                            svn_delta__spool_t **spool,
+                            apr_size_t memory_size,
+                            apr_pool_t *pool);
+
+/* Make the calls recorded in SPOOL to EDITOR and EDIT_BATON, in the
+ * original order.  This may only be done once per SPOOL.  Use
+ * SCRATCH_POOL for temporary allocations.
+ *
+ * @since New in 1.11.
+ */
+svn_error_t *
+svn_delta__replay_spool(svn_delta__spool_t *spool,
+                        const svn_delta_editor_t *editor,
+                        void *edit_baton,
+                        apr_pool_t *scratch_pool);
+
+/* Like svn_delta__replay_spool() but for a SPOOL that records the edit of
+ * a sub-tree:  Its recording started with open_root() and the root
+ * directory has not been closed.  Instead of opening a new root, make
+ * the calls recorded for that directory to DIR_BATON of EDITOR.  SPOOL
+ * must not contain set_target_revision() calls.
+ *
+ * @since New in 1.11.
+ */
+svn_error_t *
+svn_delta__replay_spool_into(svn_delta__spool_t *spool,
+                             const svn_delta_editor_t *editor,
+                             void *dir_baton,
+                             apr_pool_t *scratch_pool);
+
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -62,6 +62,14 @@ extern "C" {
 char *
 svn_eol__find_eol_start(char *buf, apr_size_t len);
 
+/* Like svn_eol__find_eol_start() but also stop at the '$' that may start
+ * a keyword.
+ *
+ * @since New in 1.11.
+ */
+char *
+svn_eol__find_eol_or_keyword_start(char *buf, apr_size_t len);
+
 /* Return the first eol marker found in buffer @a buf as a NUL-terminated
  * string, or NULL if no eol marker is found. Do not examine more than
  * @a len bytes in @a buf.
@@ -155,6 +155,9 @@ typedef struct svn_fs_fs__representation_stats_t
 
   /* sum of all representation delta chain lengths */
   apr_uint64_t chain_len;
+
+  /* histogram of the delta chain lengths */
+  svn_fs_fs__histogram_t chain_len_histogram;
 } svn_fs_fs__representation_stats_t;
 
 /* Basic statistics we collect over a given set of noderevs.
@@ -179,6 +182,12 @@ typedef struct svn_fs_fs__stats_t
   /* number of revisions in the repository */
   apr_uint64_t revision_count;
 
+  /* number of revisions in pack files */
+  apr_uint64_t packed_revision_count;
+
+  /* sum total of all pack file sizes in bytes */
+  apr_uint64_t packed_size;
+
   /* total number of changed paths */
   apr_uint64_t change_count;
 
@@ -256,14 +265,38 @@ typedef struct svn_fs_fs__stats_t
 } svn_fs_fs__stats_t;
 
 
+/* Callback type used by svn_fs_fs__pack and svn_fs_fs__get_stats.  Open
+ * another, independent instance of the repository being processed and
+ * return it in *FS.  BATON is the user-provided baton.  Allocate *FS in
+ * RESULT_POOL.
+ *
+ * The callback may be called from any thread but never concurrently for
+ * the same RESULT_POOL.
+ */
+typedef svn_error_t *
+(*svn_fs_fs__open_fs_func_t)(svn_fs_t **fs,
+                             void *baton,
+                             apr_pool_t *result_pool);
+
 /* Scan all contents of the repository FS and return statistics in *STATS,
  * allocated in RESULT_POOL.  Report progress through PROGRESS_FUNC with
  * PROGRESS_BATON, if PROGRESS_FUNC is not NULL.
+ *
+ * If JOBS is larger than 1, APR supports threads and FS uses logical
+ * addressing, read that many rev / pack files concurrently.  Each worker
+ * thread uses its own instance of FS as returned by OPEN_FS_FUNC with
+ * OPEN_FS_BATON.  OPEN_FS_FUNC may be NULL if JOBS is 1.  Callbacks other
+ * than OPEN_FS_FUNC will only be invoked from within the calling thread.
+ * The result does not depend on the number of JOBS.
+ *
  * Use SCRATCH_POOL for temporary allocations.
  */
 svn_error_t *
 svn_fs_fs__get_stats(svn_fs_fs__stats_t **stats,
                      svn_fs_t *fs,
+                     int jobs,
+                     svn_fs_fs__open_fs_func_t open_fs_func,
+                     void *open_fs_baton,
                      svn_fs_progress_notify_func_t progress_func,
                      void *progress_baton,
                      svn_cancel_func_t cancel_func,
@@ -353,6 +386,70 @@ svn_fs_fs__load_index(svn_fs_t *fs,
                       apr_array_header_t *entries,
                       apr_pool_t *scratch_pool);
 
+/* Rewrite the pack file of the packed SHARD in FS, placing its items
+ * the same way "svnadmin pack" would place them if the whole shard fit
+ * into MAX_MEM bytes of memory.  Item contents and addresses don't change,
+ * so this is transparent to all references into the shard.  It only
+ * improves the locality of shards that have been packed with less memory
+ * or by older releases.
+ *
+ * The new pack file replaces the old one atomically.  However, other
+ * svn_fs_t instances for this repository, including FS itself, may still
+ * have index information of the old pack file cached and should not read
+ * the shard afterwards.  A MAX_MEM of 0 selects the default limit of
+ * svn_fs_fs__pack().  If not NULL, call CANCEL_FUNC with CANCEL_BATON from
+ * time to time.  Use SCRATCH_POOL for temporary allocations.
+ */
+svn_error_t *
+svn_fs_fs__repack_shard(svn_fs_t *fs,
+                        apr_int64_t shard,
+                        apr_size_t max_mem,
+                        svn_cancel_func_t cancel_func,
+                        void *cancel_baton,
+                        apr_pool_t *scratch_pool);
+
+/* Change the number of revisions per shard in FS to NEW_SHARD_SIZE while
+ * the repository stays online.  0 selects the linear layout, which is not
+ * available with logical addressing.  FS must not contain packed shards.
+ *
+ * The revision and revprop files get hard-linked into the new layout,
+ * falling back to copies where links are not supported, using up to JOBS
+ * threads.  Only the final switch to the new layout blocks commits.  An
+ * interrupted run leaves the repository in the old layout and the next
+ * run will clean up after it.  If not NULL, call CANCEL_FUNC with
+ * CANCEL_BATON from time to time.  Use SCRATCH_POOL for temporary
+ * allocations.
+ */
+svn_error_t *
+svn_fs_fs__reshard(svn_fs_t *fs,
+                   int new_shard_size,
+                   int jobs,
+                   svn_cancel_func_t cancel_func,
+                   void *cancel_baton,
+                   apr_pool_t *scratch_pool);
+
+/* Set *USES_LOCK_LOG to TRUE if FS stores its locks in a single lock
+ * log and to FALSE if it uses the tree of digest files.
+ * Use SCRATCH_POOL for temporary allocations.
+ */
+svn_error_t *
+svn_fs_fs__uses_lock_log(svn_boolean_t *uses_lock_log,
+                         svn_fs_t *fs,
+                         apr_pool_t *scratch_pool);
+
+/* Convert the lock storage of FS to a single lock log if USE_LOCK_LOG is
+ * set and to a tree of digest files otherwise, keeping all unexpired
+ * locks.  Do nothing if FS already uses the requested storage.
+ * If not NULL, call CANCEL_FUNC with CANCEL_BATON from time to time.
+ * Use SCRATCH_POOL for temporary allocations.
+ */
+svn_error_t *
+svn_fs_fs__convert_locks(svn_fs_t *fs,
+                         svn_boolean_t use_lock_log,
+                         svn_cancel_func_t cancel_func,
+                         void *cancel_baton,
+                         apr_pool_t *scratch_pool);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -195,6 +195,83 @@ svn_fs__get_mergeinfo_for_path(svn_mergeinfo_t *mergeinfo,
                                apr_pool_t *result_pool,
                                apr_pool_t *scratch_pool);
 
+/** If the contents of the file @a target_path under @a target_root are
+ * stored as a delta against the contents of @a source_path under
+ * @a source_root, using svndiff version @a max_version or older, set
+ * @a *svndiff_p to a stream of that svndiff data, including its header,
+ * and @a *len_p to its length.  Otherwise, set @a *svndiff_p to @c NULL.
+ *
+ * This allows callers to pass on the stored delta instead of decoding it
+ * and encoding it again.  Backends that don't support it always return
+ * @c NULL.  The stream does not verify the resulting contents.
+ *
+ * Allocate the stream in @a result_pool while using @a scratch_pool for
+ * temporaries.
+ */
+svn_error_t *
+svn_fs__get_stored_delta(svn_stream_t **svndiff_p,
+                         svn_filesize_t *len_p,
+                         svn_fs_root_t *source_root,
+                         const char *source_path,
+                         svn_fs_root_t *target_root,
+                         const char *target_path,
+                         int max_version,
+                         apr_pool_t *result_pool,
+                         apr_pool_t *scratch_pool);
+
+/** Append the revisions following the youngest revision of @a dst_fs up
+ * to and including @a end_rev of @a src_fs to @a dst_fs, reusing the
+ * stored revision data of @a src_fs byte-for-byte.  Revision properties
+ * get copied verbatim as well, except for those of revision 0.  No hooks
+ * are run and the rep-cache of @a dst_fs is not updated.
+ *
+ * The caller must make sure that all revisions of @a dst_fs are identical
+ * to their counterparts in @a src_fs, e.g. because @a dst_fs has been
+ * populated by this function alone.  @a dst_fs must not be modified by
+ * other means in the meantime.
+ *
+ * Invoke @a notify_func with @a notify_baton, if not @c NULL, for each
+ * range of revisions that has become visible in @a dst_fs.
+ *
+ * Return #SVN_ERR_UNSUPPORTED_FEATURE if the backends of the filesystems
+ * differ or don't support this, or if their formats or layouts don't
+ * match.  Use @a scratch_pool for temporary allocations.
+ */
+svn_error_t *
+svn_fs__copy_revisions(svn_fs_t *dst_fs,
+                       svn_fs_t *src_fs,
+                       svn_revnum_t end_rev,
+                       svn_fs_hotcopy_notify_t notify_func,
+                       void *notify_baton,
+                       svn_cancel_func_t cancel_func,
+                       void *cancel_baton,
+                       apr_pool_t *scratch_pool);
+
+/** Set @a *revisions to the ascending array of all revisions (as
+ * #svn_revnum_t) between @a start and @a end whose contents have been
+ * verified successfully by @a fs in the background after they had been
+ * committed.  Revisions whose verification failed or never completed
+ * are not included.  Set it to an empty array if the backend does not
+ * support this.  Allocate the result in @a result_pool and use
+ * @a scratch_pool for temporary allocations.
+ */
+svn_error_t *
+svn_fs__get_verified_revisions(apr_array_header_t **revisions,
+                               svn_fs_t *fs,
+                               svn_revnum_t start,
+                               svn_revnum_t end,
+                               apr_pool_t *result_pool,
+                               apr_pool_t *scratch_pool);
+
+/** Make sure that other processes, e.g. hook scripts, can access all of
+ * @a txn.  Backends may keep small transactions in memory until they
+ * get committed; this writes them to disk.  Use @a scratch_pool for
+ * temporary allocations.
+ */
+svn_error_t *
+svn_fs__flush_txn(svn_fs_txn_t *txn,
+                  apr_pool_t *scratch_pool);
+
 /** Determine the previous location of @a path under @a root and return it
  * as @a *node_path under @a *node_root.  This may be called for arbitrary
  * nodes but is intended for nodes that got deleted in @a root, i.e. when
@@ -215,6 +292,167 @@ svn_fs__get_deleted_node(svn_fs_root_t **node_root,
 /** @} */
 
 
+/** I/O tracing
+ *
+ * Servers may trace the I/O of a filesystem object while it serves a
+ * single request or connection.  Tracing costs next to nothing while
+ * disabled.  Only FSFS provides data; other backends leave the
+ * counters at 0.
+ *
+ * @defgroup svn_fs_io_trace Filesystem I/O tracing
+ * @{
+ */
+
+/** Counters collected by the I/O tracing of a filesystem object. */
+typedef struct svn_fs__io_stats_t
+{
+  /** Number of revision and pack files opened. */
+  apr_uint64_t files_opened;
+
+  /** Number of items read and parsed from disk, i.e. cache misses. */
+  apr_uint64_t items_read;
+
+  /** Total size of the items read from disk, as far as known. */
+  apr_uint64_t bytes_read;
+
+  /** Number of item lookups answered from the caches. */
+  apr_uint64_t cache_hits;
+} svn_fs__io_stats_t;
+
+/** Start tracing the I/O done through @a fs, resetting all counters.
+ *
+ * If @a events is not @c NULL, write one line for each item access to it,
+ * formatted as a JSON object with the members "rev", "item", "offset",
+ * "size", "type" and "cache".  "offset" and "size" are -1 for items not
+ * read from disk.
+ *
+ * Tracing stops automatically when @a pool gets cleared, so @a events
+ * must live at least as long as @a pool.
+ */
+svn_error_t *
+svn_fs__io_trace_start(svn_fs_t *fs,
+                       svn_stream_t *events,
+                       apr_pool_t *pool);
+
+/** Stop tracing the I/O done through @a fs.  No-op if not tracing.
+ */
+void
+svn_fs__io_trace_stop(svn_fs_t *fs);
+
+/** Return the counters collected since the last svn_fs__io_trace_start()
+ * on @a fs or @c NULL if @a fs is not being traced.
+ */
+const svn_fs__io_stats_t *
+svn_fs__io_trace_stats(svn_fs_t *fs);
+
+/** @} */
+
+/** Commit timing
+ *
+ * Servers may ask for a breakdown of the time spent in the individual
+ * phases of a commit, e.g. waiting for the write lock or flushing the
+ * new revision to disk.  Reporting is disabled by default and costs
+ * no more than a pointer comparison per phase then.
+ *
+ * @defgroup svn_fs_commit_timing Commit latency breakdown
+ * @{
+ */
+
+/** The type of a callback receiving the commit phase @a phase, e.g.
+ * "lock-wait", and its @a duration.  @a baton is the baton given to
+ * svn_fs__set_commit_timing_func().  Use @a scratch_pool for temporary
+ * allocations.
+ *
+ * Phases are reported in the order they complete.  Some may be reported
+ * more than once, e.g. when a commit needs to be retried.
+ */
+typedef void (*svn_fs__commit_timing_func_t)(void *baton,
+                                             const char *phase,
+                                             apr_interval_time_t duration,
+                                             apr_pool_t *scratch_pool);
+
+/** Report the phases of all commits done through @a fs to @a func with
+ * @a baton.  Setting @a func to @c NULL disables the reporting.
+ */
+void
+svn_fs__set_commit_timing_func(svn_fs_t *fs,
+                               svn_fs__commit_timing_func_t func,
+                               void *baton);
+
+/** Return the current time if @a fs reports commit timings and 0
+ * otherwise.  Pass the result to svn_fs__commit_timing_phase().
+ */
+apr_time_t
+svn_fs__commit_timing_start(svn_fs_t *fs);
+
+/** Report @a phase of a commit done through @a fs as having started at
+ * @a start, as returned by svn_fs__commit_timing_start().  No-op if @a fs
+ * does not report commit timings.  Use @a scratch_pool for temporary
+ * allocations.
+ *
+ * This allows layers above the filesystem, e.g. the repository hooks,
+ * to contribute to the breakdown.
+ */
+void
+svn_fs__commit_timing_phase(svn_fs_t *fs,
+                            const char *phase,
+                            apr_time_t start,
+                            apr_pool_t *scratch_pool);
+
+/** @} */
+
+/** Hint that the data read through @a fs from now on is part of a bulk
+ * scan if @a bulk_scan is set, e.g. a dump, verification or export of a
+ * whole tree.  Most of that data will not be needed again any time soon.
+ * The backend may then keep it from replacing frequently used data in
+ * the caches shared with other filesystem objects.
+ *
+ * Callers should restore the previous value, see svn_fs__is_bulk_scan(),
+ * once they are done.
+ */
+void
+svn_fs__set_bulk_scan(svn_fs_t *fs,
+                      svn_boolean_t bulk_scan);
+
+/** Return whether @a fs has been marked as being used for a bulk scan.
+ * @see svn_fs__set_bulk_scan().
+ */
+svn_boolean_t
+svn_fs__is_bulk_scan(svn_fs_t *fs);
+
+/** Write the contents of the process-global membuffer cache that belong
+ * to the repositories opened by this process to the file at @a path,
+ * replacing it atomically.  Servers may load that snapshot after a
+ * restart with svn_fs__load_cache_snapshot() to start with warm caches.
+ * Do nothing if there is no global membuffer cache.  Use @a scratch_pool
+ * for temporary allocations.
+ *
+ * The file also records the UUID, youngest revision and that revision's
+ * date of each repository.
+ *
+ * @since New in 1.11.
+ */
+svn_error_t *
+svn_fs__save_cache_snapshot(const char *path,
+                            apr_pool_t *scratch_pool);
+
+/** Restore the cache snapshot written by svn_fs__save_cache_snapshot()
+ * from the file at @a path into the process-global membuffer cache.
+ * Entries are only restored for repositories that still have the same
+ * UUID, whose youngest revision is at least the one recorded and whose
+ * recorded revision still has the same date.  Do nothing if @a path does
+ * not exist or if there is no global membuffer cache.  Use @a scratch_pool
+ * for temporary allocations.
+ *
+ * This should be called before serving any requests.
+ *
+ * @since New in 1.11.
+ */
+svn_error_t *
+svn_fs__load_cache_snapshot(const char *path,
+                            apr_pool_t *scratch_pool);
+
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
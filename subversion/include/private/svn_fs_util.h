@@ -244,6 +244,58 @@ svn_fs__prop_lists_equal(apr_hash_t *a,
                          apr_hash_t *b,
                          apr_pool_t *pool);
 
+/* The I/O tracing state of a filesystem object.  See fs-loader.h. */
+typedef struct svn_fs__io_trace_t svn_fs__io_trace_t;
+
+/* Record in TRACE an access to item ITEM_INDEX in REVISION of type
+   ITEM_TYPE, e.g. "noderev".  CACHE_HIT tells whether it has been found
+   in some cache.  Otherwise, the item has been read from OFFSET in the
+   rev / pack file and is SIZE bytes long; both may be -1 if unknown.
+   TRACE may be NULL.  Use SCRATCH_POOL for temporary allocations. */
+svn_error_t *
+svn_fs__io_trace_item(svn_fs__io_trace_t *trace,
+                      svn_revnum_t revision,
+                      apr_uint64_t item_index,
+                      const char *item_type,
+                      svn_boolean_t cache_hit,
+                      apr_off_t offset,
+                      apr_off_t size,
+                      apr_pool_t *scratch_pool);
+
+/* The commit timing reporting of a filesystem object.  See fs-loader.h. */
+typedef struct svn_fs__commit_timing_t svn_fs__commit_timing_t;
+
+/* Return the current time if TIMING is enabled and 0 otherwise.
+   TIMING may be NULL. */
+apr_time_t
+svn_fs__timing_start(const svn_fs__commit_timing_t *timing);
+
+/* Report the commit phase PHASE that began at START, as returned by
+   svn_fs__timing_start(), to TIMING.  TIMING may be NULL.  Use
+   SCRATCH_POOL for temporary allocations. */
+void
+svn_fs__timing_phase(const svn_fs__commit_timing_t *timing,
+                     const char *phase,
+                     apr_time_t start,
+                     apr_pool_t *scratch_pool);
+
+/* Remember that the filesystem at FS_PATH uses PREFIX for the keys of
+   its caches in the global membuffer cache.  PREFIX must not depend on
+   the process and be followed by the name of the respective cache, i.e.
+   it identifies the repository contents.  Cache snapshots will only
+   contain entries of registered prefixes; see svn_fs__save_cache_snapshot.
+   Use SCRATCH_POOL for temporary allocations. */
+svn_error_t *
+svn_fs__register_cache_prefix(const char *prefix,
+                              const char *fs_path,
+                              apr_pool_t *scratch_pool);
+
+/* Set *PREFIXES to a hash mapping all registered cache key prefixes to
+   the absolute paths of their filesystems, allocated in RESULT_POOL. */
+svn_error_t *
+svn_fs__get_cache_prefixes(apr_hash_t **prefixes,
+                           apr_pool_t *result_pool);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -72,6 +72,20 @@ svn_io__is_finfo_read_only(svn_boolean_t *read_only,
                            apr_finfo_t *file_info,
                            apr_pool_t *pool);
 
+/** Create @a dst_abspath, which must not exist yet, as a hard link to the
+ * existing file @a src_abspath.  Set @a *linked to TRUE on success and to
+ * FALSE if this platform or the filesystem at hand doesn't support that,
+ * e.g. because the paths are on different filesystems.  Hard links are
+ * not supported on Windows.  Use @a scratch_pool for temporary allocations.
+ *
+ * @since New in 1.11.
+ */
+svn_error_t *
+svn_io__create_hardlink(svn_boolean_t *linked,
+                        const char *src_abspath,
+                        const char *dst_abspath,
+                        apr_pool_t *scratch_pool);
+
 
 /**
  * Lock file at @a lock_file. If that file does not exist, create an empty
@@ -135,6 +149,130 @@ svn_stream__from_aprfile(apr_file_t *file,
                          svn_boolean_t truncate_on_seek,
                          apr_pool_t *pool);
 
+/* Like svn_stream_checksummed2() but calculate the MD5 and the SHA-1
+   checksum in a single pass over the data.  Any of the checksum output
+   pointers may be NULL. */
+svn_stream_t *
+svn_stream__checksummed_md5_sha1(svn_stream_t *stream,
+                                 svn_checksum_t **read_md5_checksum,
+                                 svn_checksum_t **read_sha1_checksum,
+                                 svn_checksum_t **write_md5_checksum,
+                                 svn_checksum_t **write_sha1_checksum,
+                                 svn_boolean_t read_all,
+                                 apr_pool_t *pool);
+
+/* Callback type for streams that can lend out their internal buffers.
+   Set *DATA to the next bytes of the stream's data and *LEN to their
+   number.  On entry, *LEN is the maximum number of bytes the caller
+   wants to consume.  *LEN may be set to less than that but is only set
+   to 0 at the end of the stream.  The data is considered consumed and
+   remains valid until the next operation on the stream. */
+typedef svn_error_t *(*svn_stream__borrow_fn_t)(void *baton,
+                                                const char **data,
+                                                apr_size_t *len);
+
+/* Set STREAM's borrow function to BORROW_FN. */
+void
+svn_stream__set_borrow(svn_stream_t *stream,
+                       svn_stream__borrow_fn_t borrow_fn);
+
+/* Return TRUE if STREAM supports svn_stream__borrow(). */
+svn_boolean_t
+svn_stream__supports_borrow(svn_stream_t *stream);
+
+/* Read up to *LEN bytes from STREAM without copying them, i.e. set *DATA
+   to point into the STREAM's data.  See svn_stream__borrow_fn_t for the
+   exact semantics.  Return SVN_ERR_STREAM_NOT_SUPPORTED if STREAM does
+   not support this kind of access.
+
+   Borrowing and the other read functions may be mixed freely.  Streams
+   that simply pass data through, e.g. checksumming streams, support
+   borrowing if the underlying stream does.  Consumers like
+   svn_stream_copy3() use it to move the data without intermediate copies.
+ */
+svn_error_t *
+svn_stream__borrow(svn_stream_t *stream,
+                   const char **data,
+                   apr_size_t *len);
+
+/* Infrastructure for efficiently calling fsync on files and directories.
+ *
+ * The idea is to have a container of open file handles (including
+ * directory handles on POSIX), at most one per file.  During the course
+ * of an operation that needs to be fsync'ed, all touched files and
+ * folders accumulate in the container.
+ *
+ * At the end of the operation, all file changes will be written the
+ * physical disk, once per file and folder.  Afterwards, all handles will
+ * be closed and the container is ready for reuse.
+ *
+ * To minimize the delay caused by the batch flush, run all fsync calls
+ * concurrently - if the OS supports multi-threading.
+ */
+
+/* Opaque container type.
+ */
+typedef struct svn_io__batch_fsync_t svn_io__batch_fsync_t;
+
+/* Initialize the concurrent fsync infrastructure.  Clean it up when
+ * OWNING_POOL gets cleared.
+ *
+ * This function must be called before using any of the other functions in
+ * in this module.  Calling it more than once is harmless; only the first
+ * call has any effect.
+ */
+svn_error_t *
+svn_io__batch_fsync_init(apr_pool_t *owning_pool);
+
+/* Set *RESULT_P to a new batch fsync structure, allocated in RESULT_POOL.
+ * If FLUSH_TO_DISK is not set, the resulting struct will not actually use
+ * fsync. */
+svn_error_t *
+svn_io__batch_fsync_create(svn_io__batch_fsync_t **result_p,
+                           svn_boolean_t flush_to_disk,
+                           apr_pool_t *result_pool);
+
+/* Open the file at FILENAME for read and write access.  Return it in *FILE
+ * and schedule it for fsync in BATCH.  If BATCH already contains an open
+ * file for FILENAME, return that instead creating a new instance.
+ *
+ * Use SCRATCH_POOL for temporaries. */
+svn_error_t *
+svn_io__batch_fsync_open_file(apr_file_t **file,
+                              svn_io__batch_fsync_t *batch,
+                              const char *filename,
+                              apr_pool_t *scratch_pool);
+
+/* Schedule the existing file at FILENAME for fsync in BATCH.  Do nothing
+ * if BATCH already contains FILENAME.
+ *
+ * On POSIX, the file will only be opened for reading, so this works for
+ * read-only files as well.  Other systems need write access to flush a
+ * file, i.e. FILENAME must not have been made read-only, yet.
+ *
+ * Use SCRATCH_POOL for temporaries. */
+svn_error_t *
+svn_io__batch_fsync_add_file(svn_io__batch_fsync_t *batch,
+                             const char *filename,
+                             apr_pool_t *scratch_pool);
+
+/* Inform the BATCH that a file or directory has been created at PATH.
+ * "Created" means either newly created to renamed to PATH - even if another
+ * item with the same name existed before.  Depending on the OS, the correct
+ * path will scheduled for fsync.
+ *
+ * Use SCRATCH_POOL for temporaries. */
+svn_error_t *
+svn_io__batch_fsync_new_path(svn_io__batch_fsync_t *batch,
+                             const char *path,
+                             apr_pool_t *scratch_pool);
+
+/* For all files and directories in BATCH, flush all changes to disk and
+ * close the file handles.  Use SCRATCH_POOL for temporaries. */
+svn_error_t *
+svn_io__batch_fsync_run(svn_io__batch_fsync_t *batch,
+                        apr_pool_t *scratch_pool);
+
 #if defined(WIN32)
 
 /* ### Move to something like io.h or subr.h, to avoid making it
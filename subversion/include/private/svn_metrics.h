@@ -0,0 +1,118 @@
+/**
+ * @copyright
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ * @endcopyright
+ *
+ * @file svn_metrics.h
+ * @brief Process-wide statistics for server monitoring
+ *
+ * Libraries register named counters and histograms here, optionally
+ * qualified by labels, and update them as they go.  Servers export the
+ * current values in the Prometheus / OpenMetrics text format.
+ *
+ * Like the statistics of the membuffer cache, updates are purely
+ * statistical and not synchronized, so they cost no more than an
+ * increment.  Concurrent updates of the same metric may occasionally
+ * get lost.  Only registration and export take a lock.
+ */
+
+#ifndef SVN_METRICS_H
+#define SVN_METRICS_H
+
+#include <apr_pools.h>
+#include <apr_time.h>
+
+#include "svn_types.h"
+#include "svn_string.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/** An opaque metric, i.e. a counter or histogram with a given set of
+ * label values.  Metrics live for the lifetime of the process.
+ */
+typedef struct svn_metrics__t svn_metrics__t;
+
+/** Return the counter @a name qualified by @a labels, creating it if
+ * necessary.  @a help is the description exported for @a name.
+ *
+ * @a name must be a valid metric name and should end in "_total".
+ * @a labels is either @c NULL or a comma-separated list of
+ * <tt>label="value"</tt> pairs as returned by svn_metrics__label().
+ *
+ * Returns @c NULL if the metric could not be created; all other
+ * functions accept that as a metric to ignore.  Looking up a metric
+ * takes a lock, so frequently updated metrics should be looked up once
+ * and remembered.
+ */
+svn_metrics__t *
+svn_metrics__counter(const char *name,
+                     const char *labels,
+                     const char *help);
+
+/** Like svn_metrics__counter() but return a histogram of durations.
+ * @a name should end in "_seconds".  The histogram uses fixed buckets
+ * from 100 microseconds to 10 seconds.
+ */
+svn_metrics__t *
+svn_metrics__histogram(const char *name,
+                       const char *labels,
+                       const char *help);
+
+/** Add @a value to the counter @a metric.  @a metric may be @c NULL.
+ */
+void
+svn_metrics__add(svn_metrics__t *metric,
+                 apr_uint64_t value);
+
+/** Record a duration of @a duration in the histogram @a metric.
+ * @a metric may be @c NULL.
+ */
+void
+svn_metrics__observe(svn_metrics__t *metric,
+                     apr_interval_time_t duration);
+
+/** Return the label specification <tt>NAME="VALUE"</tt>, with @a value
+ * escaped as needed, allocated in @a result_pool.
+ */
+const char *
+svn_metrics__label(const char *name,
+                   const char *value,
+                   apr_pool_t *result_pool);
+
+/** Return all metrics of this process in the Prometheus text exposition
+ * format, allocated in @a result_pool.  This includes the global
+ * statistics of the membuffer cache.  Use @a scratch_pool for temporary
+ * allocations.
+ */
+svn_error_t *
+svn_metrics__format(svn_stringbuf_t **text,
+                    apr_pool_t *result_pool,
+                    apr_pool_t *scratch_pool);
+
+/** The content type of the text returned by svn_metrics__format(). */
+#define SVN_METRICS__CONTENT_TYPE "text/plain; version=0.0.4; charset=utf-8"
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* SVN_METRICS_H */
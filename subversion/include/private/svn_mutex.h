@@ -104,6 +104,81 @@ do {                                                    \
   SVN_ERR(svn_mutex__unlock(svn_mutex__m, (expr)));     \
 } while (0)
 
+/** A reader / writer lock for synchronization between threads.  Any number
+ * of threads may hold a read lock at the same time while a write lock is
+ * exclusive.  Like #svn_mutex__t, it may be NULL, in which case no
+ * synchronization will take place.
+ */
+typedef struct svn_rwlock__t svn_rwlock__t;
+
+/** Initialize the @a *lock.  If @a lock_required is TRUE, the lock will
+ * actually be created with a lifetime defined by @a result_pool.
+ * Otherwise, the pointer will be set to @c NULL and all other
+ * svn_rwlock__* functions will be no-ops.
+ *
+ * If @a spin is set, a thread that finds the lock taken will retry a few
+ * times before blocking.  The number of retries adapts to how many
+ * attempts it took to get the lock before.  This only pays off for locks
+ * that are held very briefly, e.g. for a hash lookup.
+ *
+ * As with #svn_mutex__t, recursive locking is not supported.
+ *
+ * If threading is not supported by APR, this function is a no-op.
+ */
+svn_error_t *
+svn_rwlock__init(svn_rwlock__t **lock,
+                 svn_boolean_t lock_required,
+                 svn_boolean_t spin,
+                 apr_pool_t *result_pool);
+
+/** Acquire a shared read lock on @a lock, if that has been enabled in
+ * svn_rwlock__init().  Make sure to call svn_rwlock__unlock() some time
+ * later in the same thread.
+ *
+ * @note You should use #SVN_RWLOCK__WITH_READ_LOCK instead of explicit
+ * lock acquisition and release.
+ */
+svn_error_t *
+svn_rwlock__read_lock(svn_rwlock__t *lock);
+
+/** Acquire an exclusive write lock on @a lock, if that has been enabled
+ * in svn_rwlock__init().  Make sure to call svn_rwlock__unlock() some
+ * time later in the same thread.
+ *
+ * @note You should use #SVN_RWLOCK__WITH_WRITE_LOCK instead of explicit
+ * lock acquisition and release.
+ */
+svn_error_t *
+svn_rwlock__write_lock(svn_rwlock__t *lock);
+
+/** Release the read or write lock on @a lock, previously acquired using
+ * svn_rwlock__read_lock() or svn_rwlock__write_lock().  @a err is handled
+ * the same way as in svn_mutex__unlock().
+ */
+svn_error_t *
+svn_rwlock__unlock(svn_rwlock__t *lock,
+                   svn_error_t *err);
+
+/** Acquires a read lock on @a lock, executes the expression @a expr and
+ * finally releases the lock again.  Otherwise like #SVN_MUTEX__WITH_LOCK.
+ */
+#define SVN_RWLOCK__WITH_READ_LOCK(lock, expr)          \
+do {                                                    \
+  svn_rwlock__t *svn_rwlock__l = (lock);                \
+  SVN_ERR(svn_rwlock__read_lock(svn_rwlock__l));        \
+  SVN_ERR(svn_rwlock__unlock(svn_rwlock__l, (expr)));   \
+} while (0)
+
+/** Acquires a write lock on @a lock, executes the expression @a expr and
+ * finally releases the lock again.  Otherwise like #SVN_MUTEX__WITH_LOCK.
+ */
+#define SVN_RWLOCK__WITH_WRITE_LOCK(lock, expr)         \
+do {                                                    \
+  svn_rwlock__t *svn_rwlock__l = (lock);                \
+  SVN_ERR(svn_rwlock__write_lock(svn_rwlock__l));       \
+  SVN_ERR(svn_rwlock__unlock(svn_rwlock__l, (expr)));   \
+} while (0)
+
 #if APR_HAS_THREADS
 
 /** Return the APR mutex encapsulated in @a mutex.
@@ -154,6 +154,152 @@ svn_ra__release_operational_lock(svn_ra_session_t *session,
                                  const svn_string_t *mylocktoken,
                                  apr_pool_t *scratch_pool);
 
+/** Set @a *revisions to an array of svn_revnum_t that holds, for every
+ * line of the file at @a path (relative to the URL of @a session) in
+ * @a revision, the revision that last changed that line.  The whole
+ * history of the file is taken into account and lines are compared like
+ * svn_diff_file_diff_2() does with default options.
+ *
+ * This lets the server compute blame information, possibly from cached
+ * results.  Return #SVN_ERR_RA_NOT_IMPLEMENTED if the RA layer does not
+ * support that; callers should then fall back to svn_ra_get_file_revs2().
+ *
+ * Allocate the result in @a result_pool and use @a scratch_pool for
+ * temporary allocations.
+ *
+ * @since New in 1.11.
+ */
+svn_error_t *
+svn_ra__get_blame(apr_array_header_t **revisions,
+                  svn_ra_session_t *session,
+                  const char *path,
+                  svn_revnum_t revision,
+                  apr_pool_t *result_pool,
+                  apr_pool_t *scratch_pool);
+
+/** Fetch everything needed to find the revisions of a merge source that
+ * are eligible for merging into a merge target in a single request:
+ *
+ * Set @a *source_history to the location history, expressed as mergeinfo,
+ * of @a source_path in @a source_peg_rev between @a source_youngest_rev
+ * and @a source_oldest_rev.  Invalid revision numbers default to
+ * @a source_peg_rev and 0, respectively.
+ *
+ * If @a target_history is not NULL, set @a *target_history to the
+ * complete location history of @a target_path in @a target_rev.
+ *
+ * Set @a *target_mergeinfo to the explicit or inherited mergeinfo of
+ * @a target_path in @a target_rev and, if @a include_descendants is set,
+ * the explicit mergeinfo of its subtrees; NULL if there is none.  Unlike
+ * svn_ra_get_mergeinfo(), the catalog is keyed by repository relpaths.
+ *
+ * @a source_path and @a target_path are relative to the URL of
+ * @a session.  Return #SVN_ERR_RA_NOT_IMPLEMENTED if the RA layer does
+ * not support this; callers should then fall back to
+ * svn_ra_get_location_segments() and svn_ra_get_mergeinfo().
+ *
+ * Allocate the results in @a result_pool and use @a scratch_pool for
+ * temporary allocations.
+ *
+ * @since New in 1.11.
+ */
+svn_error_t *
+svn_ra__get_merge_plan(svn_mergeinfo_t *source_history,
+                       svn_mergeinfo_t *target_history,
+                       svn_mergeinfo_catalog_t *target_mergeinfo,
+                       svn_ra_session_t *session,
+                       const char *source_path,
+                       svn_revnum_t source_peg_rev,
+                       svn_revnum_t source_youngest_rev,
+                       svn_revnum_t source_oldest_rev,
+                       const char *target_path,
+                       svn_revnum_t target_rev,
+                       svn_boolean_t include_descendants,
+                       apr_pool_t *result_pool,
+                       apr_pool_t *scratch_pool);
+
+/** Stat all of the @a paths in @a revision in as few requests as the RA
+ * layer allows.
+ *
+ * @a paths is an array of const char * relpaths, relative to the URL of
+ * @a session.  Set @a *dirents to a hash mapping each of them that exists
+ * in @a revision to its #svn_dirent_t, as svn_ra_stat() would return it.
+ * Paths that don't exist are not in the hash.  If @a revision is
+ * #SVN_INVALID_REVNUM, use HEAD.
+ *
+ * If @a locks is not NULL, set @a *locks to a hash mapping those of the
+ * existing paths that are currently locked to their #svn_lock_t.  Like
+ * svn_ra_get_lock(), this refers to the paths in HEAD.
+ *
+ * This is svn_ra_stat_many() for a single revision, with locks and
+ * collecting the results.
+ *
+ * Allocate the results in @a result_pool and use @a scratch_pool for
+ * temporary allocations.
+ *
+ * @since New in 1.11.
+ */
+svn_error_t *
+svn_ra__stat_many(apr_hash_t **dirents,
+                  apr_hash_t **locks,
+                  svn_ra_session_t *session,
+                  const apr_array_header_t *paths,
+                  svn_revnum_t revision,
+                  apr_pool_t *result_pool,
+                  apr_pool_t *scratch_pool);
+
+/**
+ * Apply the revision property @a changes, an array of #svn_prop_t, to
+ * revision @a rev in the repository of @a session.  A @c NULL value
+ * deletes the property.  This is like calling svn_ra_change_rev_prop2()
+ * without an old value for each of them, and stops at the first change
+ * that fails.  Hooks run for each of the properties.
+ *
+ * Servers that support it get all changes in a single request.
+ *
+ * Use @a scratch_pool for temporary allocations.
+ *
+ * @since New in 1.11.
+ */
+svn_error_t *
+svn_ra__change_rev_props(svn_ra_session_t *session,
+                         svn_revnum_t rev,
+                         const apr_array_header_t *changes,
+                         apr_pool_t *scratch_pool);
+
+/** Summarize the differences of @a path between @a start_rev and
+ * @a end_rev down to @a depth, based on the changed-path lists of the
+ * revisions in between instead of a full tree delta.
+ *
+ * Set @a *changes to a hash mapping the relpaths of all changed nodes
+ * below @a path ("" for @a path itself) to svn_log_changed_path2_t.
+ * Their @c action is 'A', 'D' or 'M' as seen from @a start_rev; the
+ * @c node_kind, @c text_modified and @c props_modified members describe
+ * the node and how it differs.  Deleted directories get all their former
+ * descendants reported as well.
+ *
+ * @a path is relative to the URL of @a session and @a start_rev must not
+ * be larger than @a end_rev.  Return #SVN_ERR_RA_NOT_IMPLEMENTED if the
+ * RA layer does not support this and #SVN_ERR_UNSUPPORTED_FEATURE if the
+ * changes can't be summarized this way, e.g. because nodes have been
+ * copied or replaced.  In both cases, callers should fall back to
+ * svn_ra_do_diff3().
+ *
+ * Allocate the results in @a result_pool and use @a scratch_pool for
+ * temporary allocations.
+ *
+ * @since New in 1.11.
+ */
+svn_error_t *
+svn_ra__get_changes_summary(apr_hash_t **changes,
+                            svn_ra_session_t *session,
+                            const char *path,
+                            svn_revnum_t start_rev,
+                            svn_revnum_t end_rev,
+                            svn_depth_t depth,
+                            apr_pool_t *result_pool,
+                            apr_pool_t *scratch_pool);
+
 /** Register CALLBACKS to be used with the Ev2 shims in RA_SESSION. */
 svn_error_t *
 svn_ra__register_editor_shim_callbacks(svn_ra_session_t *ra_session,
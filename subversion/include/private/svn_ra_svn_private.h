@@ -88,8 +88,35 @@ typedef struct svn_ra_svn__cmd_entry_t
   /** Termination flag.  If set, command-handling will cease after
    * command is processed. */
   svn_boolean_t terminate;
+
+  /** Bulk flag.  If set, the command streams many items, e.g. an editor
+   * drive or a log, and the connection switches to larger I/O buffers
+   * before the command gets processed. */
+  svn_boolean_t bulk;
 } svn_ra_svn__cmd_entry_t;
 
+/** Transfer statistics of a ra_svn connection. */
+typedef struct svn_ra_svn__conn_stats_t
+{
+  /** Number of write calls to the underlying stream. */
+  apr_uint64_t writes;
+
+  /** Number of bytes written. */
+  apr_uint64_t bytes_written;
+
+  /** Number of strings that bypassed the write buffer. */
+  apr_uint64_t direct_writes;
+
+  /** Number of read calls to the underlying stream. */
+  apr_uint64_t reads;
+
+  /** Number of bytes read. */
+  apr_uint64_t bytes_read;
+
+  /** Current size of the write buffer. */
+  apr_size_t write_buf_size;
+} svn_ra_svn__conn_stats_t;
+
 
 /* Return a deep copy of the SOURCE array containing private API
  * svn_ra_svn__item_t SOURCE to public API *TARGET, allocating
@@ -132,6 +159,21 @@ svn_ra_svn__set_capabilities(svn_ra_svn_conn_t *conn,
 int
 svn_ra_svn__svndiff_version(svn_ra_svn_conn_t *conn);
 
+/** Compress all further data sent and received through @a conn using
+ * @a method, which must be either #SVN_RA_SVN_CAP_COMPRESS_LZ4 or
+ * #SVN_RA_SVN_CAP_COMPRESS_ZLIB.  Pending output will be flushed first.
+ *
+ * Both sides must enable compression at the same point in the protocol
+ * exchange, i.e. while the other side is waiting for a response.  Calling
+ * this function on a compressed connection has no effect.
+ *
+ * Use @a scratch_pool for temporary allocations.
+ */
+svn_error_t *
+svn_ra_svn__enable_compression(svn_ra_svn_conn_t *conn,
+                               const char *method,
+                               apr_pool_t *scratch_pool);
+
 
 /**
  * Set the shim callbacks to be used by @a conn to @a shim_callbacks.
@@ -146,6 +188,12 @@ svn_ra_svn__set_shim_callbacks(svn_ra_svn_conn_t *conn,
 apr_pool_t *
 svn_ra_svn__get_pool(svn_ra_svn_conn_t *conn);
 
+/**
+ * Return the transfer statistics of @a conn since its creation.
+ */
+const svn_ra_svn__conn_stats_t *
+svn_ra_svn__get_conn_stats(svn_ra_svn_conn_t *conn);
+
 /**
  * @defgroup ra_svn_deprecated ra_svn low-level functions
  * @{
@@ -586,6 +634,18 @@ svn_ra_svn__write_cmd_apply_textdelta(svn_ra_svn_conn_t *conn,
                                       const svn_string_t *token,
                                       const char *base_checksum);
 
+/** Send a "apply-text-by-checksum" command over connection @a conn.  Ask
+ * the receiver to use the text with the hex SHA-1 checksum @a sha1_checksum
+ * as the new contents of the file identified by @a token.  The receiver
+ * answers with a command response telling whether it did.
+ * Use @a pool for allocations.
+ */
+svn_error_t *
+svn_ra_svn__write_cmd_apply_text_by_checksum(svn_ra_svn_conn_t *conn,
+                                             apr_pool_t *pool,
+                                             const svn_string_t *token,
+                                             const char *sha1_checksum);
+
 /** Send a "textdelta-chunk" command over connection @a conn.  Apply
  * textdelta @a chunk to the file identified by @a token.
  * Use @a pool for allocations.
@@ -127,6 +127,19 @@ svn_repos__fs_type(const char **fs_type,
                    const char *repos_path,
                    apr_pool_t *pool);
 
+/* Make svn_repos_authz_read3() keep the compiled authz model in files
+ * below the existing directory DIR, named after the checksum of the
+ * authz file contents.  Other processes reading the same authz data can
+ * then load the compiled form instead of parsing the rules again.
+ * DIR may be NULL to disable the file cache, which is the default.
+ * Otherwise, it must remain valid for the lifetime of the process.
+ *
+ * This function is not thread-safe and should be called during
+ * server initialization.
+ */
+void
+svn_repos__authz_set_cache_dir(const char *dir);
+
 
 /* Create a commit editor for REPOS, based on REVISION.  */
 svn_error_t *
@@ -227,6 +240,55 @@ svn_repos__config_pool_get(svn_config_t **cfg,
 
 /** @} */
 
+/**
+ * @defgroup svn_repos_pool Repository object pool API
+ * @{
+ */
+
+/* Opaque thread-safe factory and container for repository objects.
+ *
+ * Unlike configuration objects, repository instances are not thread-safe.
+ * Each instance is handed out to at most one user at a time.  When that
+ * user is done with it, the instance is kept open to serve the next
+ * request for the same repository.
+ */
+typedef struct svn_repos__repos_pool_t svn_repos__repos_pool_t;
+
+/* Create a new repository pool object with a lifetime determined by
+ * POOL and return it in *REPOS_POOL.
+ *
+ * The THREAD_SAFE flag indicates whether the pool actually needs to be
+ * thread-safe and POOL must be also be thread-safe if this flag is set.
+ */
+svn_error_t *
+svn_repos__repos_pool_create(svn_repos__repos_pool_t **repos_pool,
+                             svn_boolean_t thread_safe,
+                             apr_pool_t *pool);
+
+/* Set *REPOS_P to an opened repository at the local absolute PATH, just
+ * like svn_repos_open3 would.  If REPOS_POOL contains an idle instance
+ * for PATH, make sure it is up to date and return it.  Otherwise, open
+ * a new instance with FS_CONFIG.  All users of REPOS_POOL should pass in
+ * the same FS_CONFIG.
+ *
+ * The caller has exclusive access to *REPOS_P until RESULT_POOL gets
+ * cleaned up.  After that, *REPOS_P returns into REPOS_POOL.  Any client
+ * capabilities and FS warning function set by the caller will be reset.
+ * RESULT_POOL must not outlive the pool given to
+ * #svn_repos__repos_pool_create.
+ *
+ * Use SCRATCH_POOL for temporary allocations.
+ */
+svn_error_t *
+svn_repos__repos_pool_get(svn_repos_t **repos_p,
+                          svn_repos__repos_pool_t *repos_pool,
+                          const char *path,
+                          apr_hash_t *fs_config,
+                          apr_pool_t *result_pool,
+                          apr_pool_t *scratch_pool);
+
+/** @} */
+
 /* Adjust mergeinfo paths and revisions in ways that are useful when loading
  * a dump stream.
  *
@@ -260,6 +322,24 @@ svn_repos__adjust_mergeinfo_property(svn_string_t **new_value_p,
                                      apr_pool_t *result_pool,
                                      apr_pool_t *scratch_pool);
 
+/* Like svn_repos_parse_dumpstream3() but parse STREAM in a separate
+ * thread.  The PARSE_FNS callbacks get invoked in the calling thread,
+ * in the same order and with the same arguments as they would be by
+ * svn_repos_parse_dumpstream3().  Parsing runs ahead of the callbacks
+ * by a limited amount of buffered data.
+ *
+ * CANCEL_FUNC may be invoked from either thread.  Without thread support,
+ * this is equivalent to svn_repos_parse_dumpstream3().
+ */
+svn_error_t *
+svn_repos__parse_dumpstream_pipelined(svn_stream_t *stream,
+                                      const svn_repos_parse_fns3_t *parse_fns,
+                                      void *parse_baton,
+                                      svn_boolean_t deltas_are_text,
+                                      svn_cancel_func_t cancel_func,
+                                      void *cancel_baton,
+                                      apr_pool_t *pool);
+
 /* A (nearly) opaque representation of an ordered list of header lines.
  */
 typedef struct apr_array_header_t svn_repos__dumpfile_headers_t;
@@ -349,6 +429,108 @@ svn_repos__dump_node_record(svn_stream_t *dump_stream,
                             svn_boolean_t content_length_always,
                             apr_pool_t *scratch_pool);
 
+/* Set *REVISIONS to an array of svn_revnum_t that holds, for every line
+ * of the file PATH in REVISION of REPOS, the revision that last changed
+ * that line, taking the whole history of the file into account.  Lines
+ * are compared like svn_diff_file_diff_2() does with default options.
+ *
+ * If REPOS has a changed-paths index (see svn_repos_build_log_index()),
+ * use it as a cache:  Start from the annotation cached for the youngest
+ * history location of PATH that has one and add the result to the cache.
+ *
+ * If AUTHZ_READ_FUNC is not NULL, stop at the first history location of
+ * PATH that it denies access to, like svn_repos_get_file_revs2() does,
+ * and bypass the cache.  Check for cancellation using CANCEL_FUNC and
+ * CANCEL_BATON.
+ *
+ * Allocate the result in RESULT_POOL and use SCRATCH_POOL for temporary
+ * allocations.
+ */
+svn_error_t *
+svn_repos__get_blame(apr_array_header_t **revisions,
+                     svn_repos_t *repos,
+                     const char *path,
+                     svn_revnum_t revision,
+                     svn_repos_authz_func_t authz_read_func,
+                     void *authz_read_baton,
+                     svn_cancel_func_t cancel_func,
+                     void *cancel_baton,
+                     apr_pool_t *result_pool,
+                     apr_pool_t *scratch_pool);
+
+/* Gather in one go what a client needs from REPOS to find the revisions
+ * of a merge source that are eligible for merging into a merge target:
+ *
+ * Set *SOURCE_HISTORY to the location history of SOURCE_PATH@SOURCE_PEG_REV
+ * between SOURCE_YOUNGEST_REV and SOURCE_OLDEST_REV, expressed as
+ * mergeinfo.  Invalid revision numbers default to SOURCE_PEG_REV and 0,
+ * respectively.
+ *
+ * If TARGET_HISTORY is not NULL, set *TARGET_HISTORY to the complete
+ * location history of TARGET_PATH@TARGET_REV as mergeinfo.
+ *
+ * Set *TARGET_MERGEINFO to the explicit or inherited mergeinfo of
+ * TARGET_PATH in TARGET_REV and, if INCLUDE_DESCENDANTS is set, the
+ * explicit mergeinfo of its subtrees, as svn_repos_fs_get_mergeinfo2()
+ * would report it.  Set it to NULL if there is none.
+ *
+ * SOURCE_PATH and TARGET_PATH are canonical fspaths.  Pass AUTHZ_READ_FUNC
+ * and AUTHZ_READ_BATON through to the history and mergeinfo lookups.
+ *
+ * Allocate the results in RESULT_POOL and use SCRATCH_POOL for temporary
+ * allocations.
+ */
+svn_error_t *
+svn_repos__get_merge_plan(svn_mergeinfo_t *source_history,
+                          svn_mergeinfo_t *target_history,
+                          svn_mergeinfo_catalog_t *target_mergeinfo,
+                          svn_repos_t *repos,
+                          const char *source_path,
+                          svn_revnum_t source_peg_rev,
+                          svn_revnum_t source_youngest_rev,
+                          svn_revnum_t source_oldest_rev,
+                          const char *target_path,
+                          svn_revnum_t target_rev,
+                          svn_boolean_t include_descendants,
+                          svn_repos_authz_func_t authz_read_func,
+                          void *authz_read_baton,
+                          apr_pool_t *result_pool,
+                          apr_pool_t *scratch_pool);
+
+/* Summarize the differences between PATH@START_REV and PATH@END_REV in
+ * REPOS down to DEPTH, using the changed-path lists of the revisions in
+ * between rather than comparing the trees.
+ *
+ * Set *CHANGES to a hash mapping the relpaths of all changed nodes below
+ * PATH ("" for PATH itself) to svn_log_changed_path2_t.  Their ACTION is
+ * 'A', 'D' or 'M'; NODE_KIND, TEXT_MODIFIED and PROPS_MODIFIED describe
+ * the node and how it differs between both revisions.  Paths that have
+ * been touched but ended up unchanged are not reported.  Deleted
+ * directories get all their former descendants reported as well.
+ *
+ * PATH is a canonical fspath and START_REV must not be larger than END_REV.
+ * Return SVN_ERR_UNSUPPORTED_FEATURE if PATH is not the same node in both
+ * revisions or if anything below it has been copied or replaced in between;
+ * callers should then fall back to a full tree comparison.
+ *
+ * Skip paths that AUTHZ_READ_FUNC with AUTHZ_READ_BATON denies access to.
+ * Use CANCEL_FUNC with CANCEL_BATON for cancellation.  Allocate the results
+ * in RESULT_POOL and use SCRATCH_POOL for temporary allocations.
+ */
+svn_error_t *
+svn_repos__get_changes_summary(apr_hash_t **changes,
+                               svn_repos_t *repos,
+                               const char *path,
+                               svn_revnum_t start_rev,
+                               svn_revnum_t end_rev,
+                               svn_depth_t depth,
+                               svn_repos_authz_func_t authz_read_func,
+                               void *authz_read_baton,
+                               svn_cancel_func_t cancel_func,
+                               void *cancel_baton,
+                               apr_pool_t *result_pool,
+                               apr_pool_t *scratch_pool);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
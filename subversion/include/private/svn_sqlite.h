@@ -133,6 +133,19 @@ svn_sqlite__open(svn_sqlite__db_t **db, const char *path,
 svn_error_t *
 svn_sqlite__close(svn_sqlite__db_t *db);
 
+/* Switch the database in DB to write-ahead logging, if ENABLE is set, and
+   back to the default rollback journal otherwise.  WAL mode lets readers
+   proceed while a writer is active but requires all users of the database
+   to have write access to its directory and to be on the same host.
+
+   The journal mode is persistent; svn_sqlite__open() keeps databases in
+   WAL mode.  Switching back only takes effect if no other connection uses
+   the database.  Use SCRATCH_POOL for temporary allocations. */
+svn_error_t *
+svn_sqlite__set_wal_mode(svn_sqlite__db_t *db,
+                         svn_boolean_t enable,
+                         apr_pool_t *scratch_pool);
+
 /* Add a custom function to be used with this database connection.  The data
    in BATON should live at least as long as the connection in DB.
 
@@ -418,6 +431,24 @@ svn_sqlite__begin_immediate_transaction(svn_sqlite__db_t *db);
 svn_error_t *
 svn_sqlite__begin_savepoint(svn_sqlite__db_t *db);
 
+/* Start a read transaction in DB that lasts until the matching
+ * svn_sqlite__end_read_snapshot() call, so that all reads in between see
+ * the same state of the database.  Meanwhile, other connections cannot
+ * commit changes to the database.
+ *
+ * Transactions begun in DB while the snapshot is active become savepoints
+ * within it.  DB should be opened with #svn_sqlite__mode_readonly, as
+ * writes would only become visible to others once the snapshot ends. */
+svn_error_t *
+svn_sqlite__begin_read_snapshot(svn_sqlite__db_t *db);
+
+/* End the read transaction started by svn_sqlite__begin_read_snapshot().
+ * Reset all statements of DB.  Return a composition of ERR and any error
+ * that may occur while doing so. */
+svn_error_t *
+svn_sqlite__end_read_snapshot(svn_sqlite__db_t *db,
+                              svn_error_t *err);
+
 /* Commit the current transaction in DB if ERR is SVN_NO_ERROR, otherwise
  * roll back the transaction.  Return a composition of ERR and any error
  * that may occur during the commit or roll-back. */
@@ -295,6 +295,76 @@ svn_checksum__wrap_write_stream_fnv1a_32x4(apr_uint32_t *digest,
                                            svn_stream_t *inner_stream,
                                            apr_pool_t *pool);
 
+/**
+ * The bit representing checksum @a kind in the @a kinds mask parameter
+ * of svn_checksum__multi_ctx_create().
+ *
+ * @since New in 1.11.
+ */
+#define SVN_CHECKSUM__KIND_FLAG(kind) (1u << (kind))
+
+/**
+ * Opaque context to calculate checksums of several kinds over the same
+ * data in a single pass.
+ *
+ * @since New in 1.11.
+ */
+typedef struct svn_checksum__multi_ctx_t svn_checksum__multi_ctx_t;
+
+/**
+ * Return a new multi-checksum context allocated in @a pool that
+ * calculates all checksum kinds set in @a kinds.  Use
+ * #SVN_CHECKSUM__KIND_FLAG to construct that mask.
+ *
+ * @since New in 1.11.
+ */
+svn_checksum__multi_ctx_t *
+svn_checksum__multi_ctx_create(unsigned kinds,
+                               apr_pool_t *pool);
+
+/**
+ * Reset all checksums in @a ctx to their initial state.
+ *
+ * @since New in 1.11.
+ */
+svn_error_t *
+svn_checksum__multi_ctx_reset(svn_checksum__multi_ctx_t *ctx);
+
+/**
+ * Feed @a len bytes from @a data into all checksums in @a ctx.  Unlike
+ * separate calls to svn_checksum_update(), this touches each part of
+ * @a data only once while it is still in the CPU cache.
+ *
+ * @since New in 1.11.
+ */
+svn_error_t *
+svn_checksum__multi_update(svn_checksum__multi_ctx_t *ctx,
+                           const void *data,
+                           apr_size_t len);
+
+/**
+ * Return the checksum context for @a kind in @a ctx or @c NULL, if @a ctx
+ * does not calculate that kind of checksum.
+ *
+ * @since New in 1.11.
+ */
+svn_checksum_ctx_t *
+svn_checksum__multi_ctx_get(const svn_checksum__multi_ctx_t *ctx,
+                            svn_checksum_kind_t kind);
+
+/**
+ * Finalize the checksum of type @a kind in @a ctx and return it in
+ * @a *checksum, allocated in @a pool.  Return #SVN_ERR_BAD_CHECKSUM_KIND,
+ * if @a ctx does not calculate that kind of checksum.
+ *
+ * @since New in 1.11.
+ */
+svn_error_t *
+svn_checksum__multi_final(svn_checksum_t **checksum,
+                          const svn_checksum__multi_ctx_t *ctx,
+                          svn_checksum_kind_t kind,
+                          apr_pool_t *pool);
+
 /**
  * Return a 32 bit FNV-1a checksum for the first @a len bytes in @a input.
  *
@@ -316,6 +386,33 @@ svn__fnv1a_32(const void *input, apr_size_t len);
 apr_uint32_t
 svn__fnv1a_32x4(const void *input, apr_size_t len);
 
+/**
+ * For all @a count buffers, i.e. the first @a lens[i] bytes in
+ * @a inputs[i], calculate the same checksum as svn__fnv1a_32x4 and
+ * store it in @a checksums[i].
+ *
+ * Depending on the CPU, this uses SIMD code that hashes many buffers in
+ * parallel and will then be several times faster than calling
+ * svn__fnv1a_32x4 for each buffer individually.  That works best for
+ * large sets of similarly sized buffers.
+ *
+ * @since New in 1.11.
+ */
+void
+svn__fnv1a_32x4_multi(apr_uint32_t *checksums,
+                      const void *const *inputs,
+                      const apr_size_t *lens,
+                      apr_size_t count);
+
+/**
+ * Return a short description of the code used by svn__fnv1a_32x4_multi
+ * on the current CPU, e.g. "AVX2", "SSE4.1", "NEON" or "generic".
+ *
+ * @since New in 1.11.
+ */
+const char *
+svn__fnv1a_32x4_implementation(void);
+
 /** @} */
 
 
@@ -591,6 +688,25 @@ svn__decompress_lz4(const void *data, apr_size_t len,
                     svn_stringbuf_t *out,
                     apr_size_t limit);
 
+/* Same as svn__compress_zlib(), but use Zstandard compression at the
+ * given LEVEL, which is passed on to ZSTD_compress() as is.  Return
+ * SVN_ERR_UNSUPPORTED_FEATURE if Zstandard support has not been compiled
+ * in, see svn_zstd__compiled_version().
+ */
+svn_error_t *
+svn__compress_zstd(const void *data, apr_size_t len,
+                   svn_stringbuf_t *out,
+                   int level);
+
+/* Same as svn__decompress_zlib(), but use Zstandard compression.  Return
+ * SVN_ERR_UNSUPPORTED_FEATURE if Zstandard support has not been compiled
+ * in.
+ */
+svn_error_t *
+svn__decompress_zstd(const void *data, apr_size_t len,
+                     svn_stringbuf_t *out,
+                     apr_size_t limit);
+
 /** @} */
 
 /**
@@ -626,6 +742,62 @@ svn_root_pools__release_pool(apr_pool_t *pool,
 
 /** @} */
 
+/**
+ * @defgroup svn_pool_profile Pool usage profiling
+ * @{
+ */
+
+/* The environment variable that enables pool profiling in the command
+ * line tools and servers.  Its value is the file to write the profile to.
+ */
+#define SVN_POOL__PROFILE_ENV "SVN_POOL_PROFILE"
+
+/* Start recording the memory usage of all pools subsequently created by
+ * svn_pool_create() and friends, summarized per creation site.  Pools
+ * that exist already will not be included.
+ *
+ * For each site, the profile counts the pools created and those still
+ * alive, the bytes which these held when they got cleared or destroyed,
+ * the largest number of bytes a single pool held so far and the bytes
+ * held by the pools that are still alive.  Once a pool got cleared by
+ * apr_pool_clear() instead of svn_pool_clear(), it will no longer be
+ * tracked.
+ *
+ * The profile depends on the per-pool byte counts of APR's pool
+ * debugging.  Return #SVN_ERR_UNSUPPORTED_FEATURE if APR_POOL_DEBUG is
+ * not enabled.  Profiling cannot be switched off again.
+ */
+svn_error_t *
+svn_pool__profile_enable(void);
+
+/* Return TRUE if svn_pool__profile_enable() has been called successfully.
+ */
+svn_boolean_t
+svn_pool__profile_enabled(void);
+
+/* Return the current pool profile as a plain text table in *TEXT,
+ * allocated in RESULT_POOL.  Creation sites are sorted by the bytes that
+ * their live pools hold, then by total bytes.  Use SCRATCH_POOL for
+ * temporary allocations.
+ *
+ * In multi-threaded processes, the numbers for pools currently in use
+ * by other threads are approximations.
+ */
+svn_error_t *
+svn_pool__profile_format(svn_stringbuf_t **text,
+                         apr_pool_t *result_pool,
+                         apr_pool_t *scratch_pool);
+
+/* Write the current pool profile to the file at PATH, replacing it
+ * atomically.  This is a no-op if profiling has not been enabled.  Use
+ * SCRATCH_POOL for temporary allocations.
+ */
+svn_error_t *
+svn_pool__profile_write(const char *path,
+                        apr_pool_t *scratch_pool);
+
+/** @} */
+
 /**
  * @defgroup svn_config_private Private configuration handling API
  * @{
@@ -726,6 +898,78 @@ svn_dso__pool(void);
 /** @} */
 
 
+/**
+ * @defgroup svn_string_map Compact string-keyed maps
+ * @{
+ */
+
+/* This opaque data struct is an alternative to apr_hash_t for hot code
+ * paths that map STRING -> VOID* and do not need to pass the container
+ * through public APIs.
+ *
+ * Technically, it is an open-addressing hash table with linear probing.
+ * The entries are stored in a separate, dense array in insertion order,
+ * together with their hash values, i.e. iteration order is deterministic
+ * and growing the table never needs to re-hash the keys.  Keys get copied
+ * into the map's pool.
+ */
+typedef struct svn_string_map__t svn_string_map__t;
+
+/* Return a new, empty map allocated in POOL.  CAPACITY is a mere hint
+ * for the number of entries to expect.
+ */
+svn_string_map__t *
+svn_string_map__create(apr_size_t capacity,
+                       apr_pool_t *pool);
+
+/* Return the value stored for the LEN bytes long KEY in MAP or NULL
+ * if there is none.
+ */
+void *
+svn_string_map__get(const svn_string_map__t *map,
+                    const char *key,
+                    apr_size_t len);
+
+/* Set the value for the LEN bytes long KEY in MAP to VALUE.  A NULL
+ * VALUE removes the entry.  Removed keys keep their position in the
+ * iteration order should they get set again.
+ */
+void
+svn_string_map__set(svn_string_map__t *map,
+                    const char *key,
+                    apr_size_t len,
+                    void *value);
+
+/* Return the number of entries in MAP.
+ */
+apr_size_t
+svn_string_map__count(const svn_string_map__t *map);
+
+/* Iterate over all entries of MAP in insertion order.  *IDX must be 0
+ * for the first call.  For each entry, set *KEY, *LEN and *VALUE and
+ * return TRUE.  Return FALSE after the last entry.  Any of KEY, LEN and
+ * VALUE may be NULL.
+ *
+ * Removing entries while iterating is allowed, adding new keys is not.
+ */
+svn_boolean_t
+svn_string_map__next(apr_size_t *idx,
+                     const char **key,
+                     apr_size_t *len,
+                     void **value,
+                     const svn_string_map__t *map);
+
+/* Return a new hash allocated in RESULT_POOL that contains all entries
+ * of MAP.  The keys will not be copied, i.e. MAP's pool must live at
+ * least as long as RESULT_POOL.
+ */
+apr_hash_t *
+svn_string_map__to_hash(const svn_string_map__t *map,
+                        apr_pool_t *result_pool);
+
+/** @} */
+
+
 /* Return the xml (expat) version we compiled against. */
 const char *svn_xml__compiled_version(void);
 
@@ -746,6 +990,16 @@ const char *svn_lz4__compiled_version(void);
  */
 int svn_lz4__runtime_version(void);
 
+/* Return the Zstandard version we compiled against or NULL, if we have
+ * been compiled without Zstandard support. */
+const char *svn_zstd__compiled_version(void);
+
+/* Return the Zstandard version we run against as a composed value:
+ * major * 100 * 100 + minor * 100 + release.  Return 0 if we have been
+ * compiled without Zstandard support.
+ */
+int svn_zstd__runtime_version(void);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
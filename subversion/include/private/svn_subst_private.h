@@ -0,0 +1,64 @@
+/**
+ * @copyright
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ * @endcopyright
+ *
+ * @file svn_subst_private.h
+ * @brief Subversion's data substitution - Internal routines
+ */
+
+#ifndef SVN_SUBST_PRIVATE_H
+#define SVN_SUBST_PRIVATE_H
+
+#include <apr_pools.h>
+#include <apr_hash.h>
+
+#include "svn_types.h"
+#include "svn_error.h"
+#include "svn_io.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/* Set *NOOP to TRUE if svn_subst_stream_translated() with EOL_STR and
+ * KEYWORDS would return the contents of STREAM unchanged, regardless of
+ * whether keywords get expanded or contracted and whether EOLs get
+ * repaired.  Set it to FALSE if they might be changed.
+ *
+ * This reads STREAM up to the first byte that might need translation,
+ * i.e. all of it if *NOOP is TRUE.  STREAM will not be closed.
+ *
+ * Use SCRATCH_POOL for temporary allocations.
+ *
+ * @since New in 1.11.
+ */
+svn_error_t *
+svn_subst__translation_is_noop(svn_boolean_t *noop,
+                               svn_stream_t *stream,
+                               const char *eol_str,
+                               apr_hash_t *keywords,
+                               apr_pool_t *scratch_pool);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* SVN_SUBST_PRIVATE_H */
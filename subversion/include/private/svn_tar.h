@@ -0,0 +1,125 @@
+/* svn_tar.h : writing tar archives
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#ifndef SVN_TAR_H
+#define SVN_TAR_H
+
+#include <apr_hash.h>
+
+#include "svn_types.h"
+#include "svn_io.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/* This API writes POSIX.1-2001 (pax) tar archives to a stream.
+ *
+ * Entries use the ustar header format.  Paths, link targets and sizes
+ * that don't fit into it are written as pax extended headers, which all
+ * common tar implementations understand.  Owners are not recorded.
+ *
+ * Entry paths are relpaths within the archive.  The caller adds parent
+ * directories before their contents.
+ */
+
+/* Opaque tar archive writer. */
+typedef struct svn_tar__writer_t svn_tar__writer_t;
+
+/* Return a new writer of a tar archive to OUTPUT, allocated in
+   RESULT_POOL.  OUTPUT will not be closed by the writer. */
+svn_tar__writer_t *
+svn_tar__writer_create(svn_stream_t *output,
+                       apr_pool_t *result_pool);
+
+/* Add a directory entry for RELPATH with modification time MTIME to
+   WRITER.  Use SCRATCH_POOL for temporary allocations. */
+svn_error_t *
+svn_tar__add_directory(svn_tar__writer_t *writer,
+                       const char *relpath,
+                       apr_time_t mtime,
+                       apr_pool_t *scratch_pool);
+
+/* Add a regular file entry for RELPATH with modification time MTIME to
+   WRITER.  Mark it as executable if EXECUTABLE is set.  Read its
+   contents from CONTENTS, which gets closed.  If SIZE is not negative,
+   it is the number of bytes CONTENTS delivers.  Otherwise, the contents
+   get buffered to determine their size.  Use SCRATCH_POOL for temporary
+   allocations. */
+svn_error_t *
+svn_tar__add_file(svn_tar__writer_t *writer,
+                  const char *relpath,
+                  svn_stream_t *contents,
+                  svn_filesize_t size,
+                  svn_boolean_t executable,
+                  apr_time_t mtime,
+                  svn_cancel_func_t cancel_func,
+                  void *cancel_baton,
+                  apr_pool_t *scratch_pool);
+
+/* Add a symbolic link entry for RELPATH pointing to TARGET with
+   modification time MTIME to WRITER.  Use SCRATCH_POOL for temporary
+   allocations. */
+svn_error_t *
+svn_tar__add_symlink(svn_tar__writer_t *writer,
+                     const char *relpath,
+                     const char *target,
+                     apr_time_t mtime,
+                     apr_pool_t *scratch_pool);
+
+/* Add the versioned file RELPATH with the normal form text CONTENTS of
+   SIZE bytes to WRITER, the way an export would put it on disk.
+   CONTENTS gets closed.
+
+   Translate line endings according to the svn:eol-style value
+   EOL_STYLE_VAL, if not NULL.  For the native style, use the NATIVE_EOL
+   override if not NULL ("LF", "CR" or "CRLF").  Expand the KEYWORDS
+   built by svn_subst_build_keywords3(), if not NULL.  Add a symbolic link
+   instead of a file if SPECIAL is set and the text describes one.  Mark
+   the file as executable if EXECUTABLE is set.  Use MTIME as
+   modification time.  Use SCRATCH_POOL for temporary allocations. */
+svn_error_t *
+svn_tar__add_versioned_file(svn_tar__writer_t *writer,
+                            const char *relpath,
+                            svn_stream_t *contents,
+                            svn_filesize_t size,
+                            const char *eol_style_val,
+                            const char *native_eol,
+                            apr_hash_t *keywords,
+                            svn_boolean_t special,
+                            svn_boolean_t executable,
+                            apr_time_t mtime,
+                            svn_cancel_func_t cancel_func,
+                            void *cancel_baton,
+                            apr_pool_t *scratch_pool);
+
+/* Write the end-of-archive marker of WRITER.  Nothing may be added to
+   WRITER afterwards.  Use SCRATCH_POOL for temporary allocations. */
+svn_error_t *
+svn_tar__writer_finish(svn_tar__writer_t *writer,
+                       apr_pool_t *scratch_pool);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* SVN_TAR_H */
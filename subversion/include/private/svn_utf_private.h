@@ -46,6 +46,13 @@ extern "C" {
 svn_boolean_t
 svn_utf__is_valid(const char *src, apr_size_t len);
 
+/* Return TRUE if all LEN bytes of SRC are 7-bit ASCII characters, FALSE
+ * otherwise.  Such strings are valid UTF-8 and most character encodings
+ * represent them by the very same bytes.
+ */
+svn_boolean_t
+svn_utf__is_ascii(const char *src, apr_size_t len);
+
 /* As for svn_utf__is_valid but SRC is NULL terminated. */
 svn_boolean_t
 svn_utf__cstring_is_valid(const char *src);
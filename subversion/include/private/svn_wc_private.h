@@ -348,6 +348,52 @@ svn_wc__get_wcroot(const char **wcroot_abspath,
                    apr_pool_t *result_pool,
                    apr_pool_t *scratch_pool);
 
+/** Like svn_wc_walk_status() with @a no_ignore set and @a ignore_text_mods
+ * and @a ignore_patterns unset, but don't report any unversioned, ignored
+ * or external items below @a local_abspath unless they are tree conflicted.
+ *
+ * This saves reading the ignore properties of all directories containing
+ * unversioned items, e.g. build results, for callers like the commit
+ * harvester that only care about versioned nodes.
+ *
+ * @since New in 1.11.
+ */
+svn_error_t *
+svn_wc__walk_versioned_status(svn_wc_context_t *wc_ctx,
+                              const char *local_abspath,
+                              svn_depth_t depth,
+                              svn_boolean_t get_all,
+                              svn_wc_status_func4_t status_func,
+                              void *status_baton,
+                              svn_cancel_func_t cancel_func,
+                              void *cancel_baton,
+                              apr_pool_t *scratch_pool);
+
+/** Make all following reads of the working copy containing
+ * @a local_abspath through @a wc_ctx see a single consistent state of
+ * the working copy database, until the matching call of
+ * svn_wc__end_read_snapshot(), if the #SVN_CONFIG_OPTION_SQLITE_READ_SNAPSHOT
+ * option is enabled.  Otherwise do nothing.
+ *
+ * Modifying the working copy while the snapshot is active fails, so this
+ * must only be used around read-only operations like svn_wc_walk_status()
+ * with a status callback that doesn't write.  Calls may be nested.
+ */
+svn_error_t *
+svn_wc__begin_read_snapshot(svn_wc_context_t *wc_ctx,
+                            const char *local_abspath,
+                            apr_pool_t *scratch_pool);
+
+/** End the snapshot started by svn_wc__begin_read_snapshot() for
+ * @a local_abspath in @a wc_ctx, and return @a err composed with any
+ * error that occurred while doing so.
+ */
+svn_error_t *
+svn_wc__end_read_snapshot(svn_wc_context_t *wc_ctx,
+                          const char *local_abspath,
+                          svn_error_t *err,
+                          apr_pool_t *scratch_pool);
+
 /** Set @a *dir to the abspath of the directory in which shelved patches
  * are stored, which is inside the WC's administrative directory, and ensure
  * the directory exists.
@@ -845,6 +891,21 @@ svn_wc__prop_retrieve_recursive(apr_hash_t **values,
                                 apr_pool_t *result_pool,
                                 apr_pool_t *scratch_pool);
 
+/** Alternative version of svn_wc_prop_set4() with a NULL value and
+ * svn_depth_empty.  It deletes the property @a name from all
+ * const char * local_abspaths in @a targets more efficiently, within a
+ * single sqlite transaction.  All targets must be within the same working
+ * copy.  No notifications are sent.
+ *
+ * @a name must be a regular property that does not affect the translation
+ * of working files, e.g. #SVN_PROP_MERGEINFO.
+ */
+svn_error_t *
+svn_wc__prop_delete_many(svn_wc_context_t *wc_ctx,
+                         const apr_array_header_t *targets,
+                         const char *name,
+                         apr_pool_t *scratch_pool);
+
 /**
  * Set @a *iprops_paths to a hash mapping const char * absolute working
  * copy paths to the nodes repository root relative path for each path
@@ -1019,10 +1080,26 @@ svn_wc__node_get_md5_from_sha1(const svn_checksum_t **md5_checksum,
                                apr_pool_t *result_pool,
                                apr_pool_t *scratch_pool);
 
+/* Set *SHA1_CHECKSUM to the SHA-1 checksum of the pristine text of the
+   file LOCAL_ABSPATH, i.e. of the text svn_wc_get_pristine_contents2()
+   would return.  Set it to NULL if the node has no pristine text, e.g.
+   because it is a simply added file or not a file at all.
+
+   Wraps svn_wc__db_read_pristine_info().
+ */
+svn_error_t *
+svn_wc__node_get_pristine_sha1(const svn_checksum_t **sha1_checksum,
+                               svn_wc_context_t *wc_ctx,
+                               const char *local_abspath,
+                               apr_pool_t *result_pool,
+                               apr_pool_t *scratch_pool);
+
 /* Like svn_wc_get_pristine_contents2(), but keyed on the CHECKSUM
    rather than on the local absolute path of the working file.
    WRI_ABSPATH is any versioned path of the working copy in whose
-   pristine database we'll be looking for these contents.  */
+   pristine database we'll be looking for these contents.  If they are
+   not there, look in the machine-wide shared pristine store, if one
+   has been configured.  */
 svn_error_t *
 svn_wc__get_pristine_contents_by_checksum(svn_stream_t **contents,
                                           svn_wc_context_t *wc_ctx,
@@ -1031,6 +1108,84 @@ svn_wc__get_pristine_contents_by_checksum(svn_stream_t **contents,
                                           apr_pool_t *result_pool,
                                           apr_pool_t *scratch_pool);
 
+/* Callback that writes the text of REPOS_RELPATH at REVISION in the
+ * repository at REPOS_ROOT_URL, in repository normal form, to CONTENTS.
+ * It must not close CONTENTS.
+ *
+ * Working copies that don't store a pristine copy of every file use this
+ * to fetch pristine texts when an operation needs them.
+ */
+typedef svn_error_t *(*svn_wc__pristine_fetch_func_t)(
+  void *baton,
+  svn_stream_t *contents,
+  const char *repos_root_url,
+  const char *repos_relpath,
+  svn_revnum_t revision,
+  apr_pool_t *scratch_pool);
+
+/* Make WC_CTX use FETCH_FUNC with FETCH_BATON to fetch pristine texts that
+ * are not stored locally.  Without such a callback, operations that need
+ * those texts fail with SVN_ERR_WC_PRISTINE_NOT_STORED.
+ */
+void
+svn_wc__context_set_pristine_fetch(svn_wc_context_t *wc_ctx,
+                                   svn_wc__pristine_fetch_func_t fetch_func,
+                                   void *fetch_baton);
+
+/* Set *STORE_PRISTINE to whether the working copy containing LOCAL_ABSPATH
+ * stores a pristine copy of every file.  New working copies store them
+ * unless the store-pristine option in the [working-copy] section of the
+ * client configuration is disabled.
+ */
+svn_error_t *
+svn_wc__get_store_pristine(svn_boolean_t *store_pristine,
+                           svn_wc_context_t *wc_ctx,
+                           const char *local_abspath,
+                           apr_pool_t *scratch_pool);
+
+/* A queue of files whose text deltas get computed concurrently ahead of
+ * their transmission to a commit editor.  */
+typedef struct svn_wc__text_delta_queue_t svn_wc__text_delta_queue_t;
+
+/* Create a text delta queue for WC_CTX in *QUEUE that computes deltas with
+ * up to THREADS worker threads.  With THREADS <= 1 or without thread
+ * support, all files will be handled sequentially upon transmission.
+ * The queue and its threads live until RESULT_POOL gets cleaned up.
+ */
+svn_error_t *
+svn_wc__text_delta_queue_create(svn_wc__text_delta_queue_t **queue,
+                                svn_wc_context_t *wc_ctx,
+                                int threads,
+                                apr_pool_t *result_pool);
+
+/* Append the working file LOCAL_ABSPATH to QUEUE and start computing its
+ * text delta in the background; delta against the empty text if FULLTEXT
+ * is set.  Errors during that preparation are not reported here but by
+ * svn_wc__text_delta_queue_transmit().  Use SCRATCH_POOL for temporary
+ * allocations.
+ */
+svn_error_t *
+svn_wc__text_delta_queue_add(svn_wc__text_delta_queue_t *queue,
+                             const char *local_abspath,
+                             svn_boolean_t fulltext,
+                             apr_pool_t *scratch_pool);
+
+/* Like svn_wc_transmit_text_deltas3() but for the first file in QUEUE,
+ * which must be LOCAL_ABSPATH.  Wait for its delta to be computed, send
+ * it to EDITOR and FILE_BATON and remove the file from QUEUE.  Files must
+ * be transmitted in the order in which they were added.
+ */
+svn_error_t *
+svn_wc__text_delta_queue_transmit(
+  const svn_checksum_t **new_text_base_md5_checksum,
+  const svn_checksum_t **new_text_base_sha1_checksum,
+  svn_wc__text_delta_queue_t *queue,
+  const char *local_abspath,
+  const svn_delta_editor_t *editor,
+  void *file_baton,
+  apr_pool_t *result_pool,
+  apr_pool_t *scratch_pool);
+
 /* Gets an array of const char *repos_relpaths of descendants of LOCAL_ABSPATH,
  * which must be the op root of an addition, copy or move. The descendants
  * returned are at the same op_depth, but are to be deleted by the commit
@@ -0,0 +1,240 @@
+/**
+ * @copyright
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ * @endcopyright
+ *
+ * @file svn_worker_pool.h
+ * @brief A set of worker threads running queued jobs
+ */
+
+#ifndef SVN_WORKER_POOL_H
+#define SVN_WORKER_POOL_H
+
+#include <apr_pools.h>
+
+#include "svn_types.h"
+#include "svn_error.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/**
+ * A worker pool runs jobs in a fixed number of background threads, in
+ * the order in which they have been posted.  Jobs that remain unfinished
+ * when the pool gets cleaned up are dropped if they have not been started
+ * yet and completed otherwise.
+ *
+ * All functions are thread-safe.  Besides running the jobs, the pool
+ * provides a mutex and a condition variable that callers may use to
+ * protect and wait for any additional state shared with their jobs.
+ * The condition gets signaled whenever a job completes.
+ */
+typedef struct svn_worker_pool__t svn_worker_pool__t;
+
+/** A job posted to a #svn_worker_pool__t. */
+typedef struct svn_worker_pool__job_t svn_worker_pool__job_t;
+
+/** The function run by a job, with the @a baton given to
+ * svn_worker_pool__post().  @a scratch_pool belongs to the worker thread
+ * and will be cleared when the function returns; allocate results in
+ * a pool owned by @a baton instead.
+ */
+typedef svn_error_t *(*svn_worker_pool__func_t)(void *baton,
+                                                apr_pool_t *scratch_pool);
+
+/** Start a worker pool with up to @a threads threads and return it in
+ * @a *workers.  Set @a *workers to NULL if no thread could be started,
+ * which is always the case if APR does not support threading.
+ *
+ * The threads exit when @a pool gets cleaned up.  Cleanups registered
+ * with @a pool before calling this function run after that, so they may
+ * release whatever the jobs have been working on.
+ */
+svn_error_t *
+svn_worker_pool__create(svn_worker_pool__t **workers,
+                        int threads,
+                        apr_pool_t *pool);
+
+/** Return the number of threads in @a workers. */
+int
+svn_worker_pool__thread_count(const svn_worker_pool__t *workers);
+
+/** Queue a job running @a func with @a baton in @a workers.  Return it
+ * in @a *job, allocated in @a result_pool, unless @a job is NULL.  In
+ * the latter case, errors returned by @a func will be ignored.
+ *
+ * @a result_pool must not be cleaned up before the job has finished or
+ * @a workers have been stopped.
+ */
+svn_error_t *
+svn_worker_pool__post(svn_worker_pool__job_t **job,
+                      svn_worker_pool__t *workers,
+                      svn_worker_pool__func_t func,
+                      void *baton,
+                      apr_pool_t *result_pool);
+
+/** Set @a *done to TRUE if @a job has finished and FALSE otherwise. */
+svn_error_t *
+svn_worker_pool__is_done(svn_boolean_t *done,
+                         svn_worker_pool__job_t *job);
+
+/** Block until @a job has finished and return its error.  Only the first
+ * call for a given @a job will return the error.  If the pool stops
+ * before the job could be started, return #SVN_ERR_CANCELLED.
+ */
+svn_error_t *
+svn_worker_pool__wait(svn_worker_pool__job_t *job);
+
+/** If @a job has not been started yet, remove it from the queue and set
+ * @a *cancelled to TRUE.  Otherwise, set @a *cancelled to FALSE and
+ * return the result of svn_worker_pool__wait().
+ */
+svn_error_t *
+svn_worker_pool__cancel(svn_boolean_t *cancelled,
+                        svn_worker_pool__job_t *job);
+
+/** Acquire the mutex of @a workers.  While holding it, the caller must
+ * not call any of the job functions above.
+ */
+svn_error_t *
+svn_worker_pool__lock(svn_worker_pool__t *workers);
+
+/** Release the mutex of @a workers, returning @a err like
+ * svn_mutex__unlock().
+ */
+svn_error_t *
+svn_worker_pool__unlock(svn_worker_pool__t *workers,
+                        svn_error_t *err);
+
+/** With the mutex of @a workers held, block until some job completes,
+ * somebody calls svn_worker_pool__notify() or the pool stops.
+ */
+svn_error_t *
+svn_worker_pool__wait_for_change(svn_worker_pool__t *workers);
+
+/** With the mutex of @a workers held, wake up all threads blocked in
+ * svn_worker_pool__wait_for_change().
+ */
+svn_error_t *
+svn_worker_pool__notify(svn_worker_pool__t *workers);
+
+/** With the mutex of @a workers held, return TRUE if the pool is being
+ * cleaned up.  Jobs waiting for some other thread must give up then.
+ */
+svn_boolean_t
+svn_worker_pool__stopping(svn_worker_pool__t *workers);
+
+/**
+ * An ordered queue runs a function for a sequence of items in its own
+ * worker pool and hands them back to the caller in the order in which
+ * they have been added, as each one of them completes.  Every thread
+ * may set up private state to process the items with, e.g. its own FS
+ * instance.
+ *
+ * Only one thread shall add and take items.  The items must not be
+ * accessed while they are in the queue.
+ */
+typedef struct svn_worker_pool__ordered_t svn_worker_pool__ordered_t;
+
+/** Set @a *thread_baton to the state that the calling worker thread of
+ * an ordered queue passes to every item it processes.  @a baton is the
+ * one given to svn_worker_pool__ordered_create().  Allocate the state
+ * in @a thread_pool, which will be cleared once the thread is done with
+ * the queue.
+ */
+typedef svn_error_t *(*svn_worker_pool__open_func_t)(void **thread_baton,
+                                                     void *baton,
+                                                     apr_pool_t *thread_pool);
+
+/** Process @a item of an ordered queue with the @a thread_baton of the
+ * calling worker thread.  @a scratch_pool will be cleared when the
+ * function returns; allocate results in a pool owned by @a item instead.
+ */
+typedef svn_error_t *(*svn_worker_pool__item_func_t)(void *item,
+                                                     void *thread_baton,
+                                                     apr_pool_t *scratch_pool);
+
+/** Release @a item that has never been taken from an ordered queue. */
+typedef void (*svn_worker_pool__release_func_t)(void *item);
+
+/** Start an ordered queue with up to @a threads threads, running
+ * @a item_func on all items added to it, and return it in @a *queue.
+ * Set @a *queue to NULL if no thread could be started, which is always
+ * the case if APR does not support threading.
+ *
+ * Every thread calls @a open_func with @a baton once before processing
+ * any item.  If it fails, the queue stops and the error will be returned
+ * by svn_worker_pool__ordered_take().  If @a open_func is NULL, @a baton
+ * is passed to @a item_func as the thread baton.
+ *
+ * Once more than @a capacity items are waiting to be taken, taking the
+ * next one blocks until it has been processed.  Items that never got
+ * taken are passed to @a release_func, unless that is NULL.  That
+ * happens when the queue is destroyed or @a pool gets cleaned up,
+ * whichever comes first.
+ */
+svn_error_t *
+svn_worker_pool__ordered_create(svn_worker_pool__ordered_t **queue,
+                                int threads,
+                                int capacity,
+                                svn_worker_pool__open_func_t open_func,
+                                svn_worker_pool__item_func_t item_func,
+                                svn_worker_pool__release_func_t release_func,
+                                void *baton,
+                                apr_pool_t *pool);
+
+/** Return the number of threads in @a queue. */
+int
+svn_worker_pool__ordered_thread_count(const svn_worker_pool__ordered_t *queue);
+
+/** Append @a item to @a queue. */
+svn_error_t *
+svn_worker_pool__ordered_add(svn_worker_pool__ordered_t *queue,
+                             void *item);
+
+/** Remove the oldest item from @a queue, return it in @a *item and the
+ * error that processing it returned in @a *item_err.  Set @a *item to
+ * NULL if @a queue is empty or if that item has not been processed yet,
+ * unless @a wait is TRUE or @a queue holds more items than it may.  In
+ * the latter cases, block until it has been.
+ *
+ * If some thread failed to set up its state, return that error instead.
+ * After that, @a queue may only be destroyed.
+ */
+svn_error_t *
+svn_worker_pool__ordered_take(void **item,
+                              svn_error_t **item_err,
+                              svn_worker_pool__ordered_t *queue,
+                              svn_boolean_t wait);
+
+/** Stop the threads of @a queue, wait for them to exit and release all
+ * items that have not been taken.  Return @a err, combined with any error
+ * that svn_worker_pool__ordered_take() did not return yet.
+ */
+svn_error_t *
+svn_worker_pool__ordered_destroy(svn_worker_pool__ordered_t *queue,
+                                 svn_error_t *err);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* SVN_WORKER_POOL_H */
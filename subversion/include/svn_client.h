@@ -6435,6 +6435,48 @@ svn_client_export5(svn_revnum_t *result_rev,
                    svn_client_ctx_t *ctx,
                    apr_pool_t *pool);
 
+/**
+ * Export the tree at @a from_path_or_url like svn_client_export5() does,
+ * but write it as a tar archive to @a tar_stream instead of creating it
+ * on disk.  @a tar_stream will not be closed.
+ *
+ * All archive entries are put below @a archive_root, a relpath that
+ * becomes the top-level directory of the archive.  If @a archive_root is
+ * empty, the exported tree's children become the top-level entries, or
+ * for a file, its basename is used.
+ *
+ * Translation is applied as svn_client_export5() would do.  Files with
+ * svn:executable get mode 0755.  Files are recorded with the date of
+ * their last change, directories with the date of the exported revision.
+ * Files with svn:special become symbolic links.  Externals get added
+ * below the directories defining them unless @a ignore_externals is set;
+ * failing to export one is an error.
+ *
+ * @a from_path_or_url may be a working copy path only if @a revision
+ * refers to a repository revision.  Otherwise, return
+ * #SVN_ERR_UNSUPPORTED_FEATURE.  @a result_rev, @a peg_revision,
+ * @a revision, @a ignore_keywords, @a depth, @a native_eol and @a ctx are
+ * as for svn_client_export5().  The paths of notifications are archive
+ * paths.
+ *
+ * All allocations are done in @a pool.
+ *
+ * @since New in 1.11.
+ */
+svn_error_t *
+svn_client_export_tar(svn_revnum_t *result_rev,
+                      svn_stream_t *tar_stream,
+                      const char *from_path_or_url,
+                      const char *archive_root,
+                      const svn_opt_revision_t *peg_revision,
+                      const svn_opt_revision_t *revision,
+                      svn_boolean_t ignore_externals,
+                      svn_boolean_t ignore_keywords,
+                      svn_depth_t depth,
+                      const char *native_eol,
+                      svn_client_ctx_t *ctx,
+                      apr_pool_t *pool);
+
 /**
  * Similar to svn_client_export5(), but with @a ignore_keywords set
  * to FALSE.
@@ -6602,12 +6644,21 @@ typedef svn_error_t *(*svn_client_list_func_t)(void *baton,
  * patterns.  This does not affect the size of the tree nor the number of
  * externals being covered.
  *
+ * If @a since_rev is a valid revision, only report entries that changed
+ * in @a since_rev or later, i.e. whose created revision is at least
+ * @a since_rev.  Sub-trees that did not change since then are skipped
+ * as a whole, including any externals defined within them.
+ *
  * If @a fetch_locks is TRUE, include locks when reporting directory entries.
  *
  * If @a include_externals is TRUE, also list all external items
  * reached by recursion. @a depth value passed to the original list target
  * applies for the externals also.
  *
+ * The entries are reported as they get received from the server, in
+ * depth-first order.  Memory usage does not depend on the size of the
+ * tree unless @a include_externals or @a fetch_locks are set.
+ *
  * Use @a scratch_pool for temporary allocations.
  *
  * Use authentication baton cached in @a ctx to authenticate against the
@@ -6624,8 +6675,31 @@ typedef svn_error_t *(*svn_client_list_func_t)(void *baton,
  * otherwise simply bitwise OR together the combination of @c SVN_DIRENT_
  * fields you care about.
  *
+ * @since New in 1.11.
+ */
+svn_error_t *
+svn_client_list5(const char *path_or_url,
+                 const svn_opt_revision_t *peg_revision,
+                 const svn_opt_revision_t *revision,
+                 const apr_array_header_t *patterns,
+                 svn_depth_t depth,
+                 svn_revnum_t since_rev,
+                 apr_uint32_t dirent_fields,
+                 svn_boolean_t fetch_locks,
+                 svn_boolean_t include_externals,
+                 svn_client_list_func2_t list_func,
+                 void *baton,
+                 svn_client_ctx_t *ctx,
+                 apr_pool_t *scratch_pool);
+
+/** Similar to svn_client_list5(), but with @a since_rev set to
+ * #SVN_INVALID_REVNUM.
+ *
  * @since New in 1.10.
+ *
+ * @deprecated Provided for backwards compatibility with the 1.10 API.
  */
+SVN_DEPRECATED
 svn_error_t *
 svn_client_list4(const char *path_or_url,
                  const svn_opt_revision_t *peg_revision,
@@ -7780,6 +7854,35 @@ svn_client_info4(const char *abspath_or_url,
                  svn_client_ctx_t *ctx,
                  apr_pool_t *scratch_pool);
 
+/**
+ * Like svn_client_info4() with an unspecified @a revision, but for all of
+ * the repository @a urls (<tt>const char *</tt>) at once.
+ *
+ * The URLs get looked up in @a peg_revision, which must not require a
+ * working copy.  If it is #svn_opt_revision_unspecified, it defaults to
+ * HEAD.  The URLs of the same repository share one RA session, and are
+ * stat'ed in a single request if the server supports that, instead of
+ * requiring a session and several round trips each.
+ *
+ * Invoke @a receiver with @a receiver_baton for each URL in the order of
+ * @a urls, followed by its children down to @a depth like
+ * svn_client_info4() does.  If a URL does not exist in @a peg_revision,
+ * don't return #SVN_ERR_RA_ILLEGAL_URL but invoke @a receiver with the URL
+ * as @a abspath_or_url and an info of kind #svn_node_none, of which only
+ * the repository and revision fields are set, and continue with the next
+ * URL.
+ *
+ * @since New in 1.11.
+ */
+svn_error_t *
+svn_client_info_many(const apr_array_header_t *urls,
+                     const svn_opt_revision_t *peg_revision,
+                     svn_depth_t depth,
+                     svn_client_info_receiver2_t receiver,
+                     void *receiver_baton,
+                     svn_client_ctx_t *ctx,
+                     apr_pool_t *scratch_pool);
+
 
 /** Similar to svn_client_info4, but doesn't support walking externals.
  *
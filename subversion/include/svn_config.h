@@ -112,6 +112,10 @@ typedef struct svn_config_t svn_config_t;
 #define SVN_CONFIG_OPTION_HTTP_MAX_CONNECTIONS      "http-max-connections"
 /** @since New in 1.9. */
 #define SVN_CONFIG_OPTION_HTTP_CHUNKED_REQUESTS     "http-chunked-requests"
+/** @since New in 1.11. */
+#define SVN_CONFIG_OPTION_HTTP_H2                   "http-h2"
+/** @since New in 1.11. */
+#define SVN_CONFIG_OPTION_HTTP_ADAPTIVE_CONCURRENCY "http-adaptive-concurrency"
 
 /** @since New in 1.9. */
 #define SVN_CONFIG_OPTION_SERF_LOG_COMPONENTS       "serf-log-components"
@@ -161,6 +165,18 @@ typedef struct svn_config_t svn_config_t;
 #define SVN_CONFIG_OPTION_MEMORY_CACHE_SIZE         "memory-cache-size"
 /** @since New in 1.9. */
 #define SVN_CONFIG_OPTION_DIFF_IGNORE_CONTENT_TYPE  "diff-ignore-content-type"
+/** @since New in 1.11. */
+#define SVN_CONFIG_OPTION_COMMIT_DELTA_THREADS      "commit-delta-threads"
+/** @since New in 1.11. */
+#define SVN_CONFIG_OPTION_BLAME_DIFF_THREADS        "blame-diff-threads"
+/** @since New in 1.11. */
+#define SVN_CONFIG_OPTION_EXPORT_THREADS            "export-threads"
+/** @since New in 1.11. */
+#define SVN_CONFIG_OPTION_DIFF_THREADS              "diff-threads"
+/** @since New in 1.11. */
+#define SVN_CONFIG_OPTION_CHECKOUT_THREADS          "checkout-threads"
+/** @since New in 1.11. */
+#define SVN_CONFIG_OPTION_IMPORT_THREADS            "import-threads"
 #define SVN_CONFIG_SECTION_TUNNELS              "tunnels"
 #define SVN_CONFIG_SECTION_AUTO_PROPS           "auto-props"
 /** @since New in 1.8. */
@@ -171,6 +187,20 @@ typedef struct svn_config_t svn_config_t;
 #define SVN_CONFIG_OPTION_SQLITE_EXCLUSIVE_CLIENTS  "exclusive-locking-clients"
 /** @since New in 1.9. */
 #define SVN_CONFIG_OPTION_SQLITE_BUSY_TIMEOUT       "busy-timeout"
+/** @since New in 1.11. */
+#define SVN_CONFIG_OPTION_SHARED_PRISTINE_DIR       "shared-pristine-directory"
+/** @since New in 1.11. */
+#define SVN_CONFIG_OPTION_FSMONITOR_HOOK            "fsmonitor-hook"
+/** @since New in 1.11. */
+#define SVN_CONFIG_OPTION_INSTALL_THREADS           "install-threads"
+/** @since New in 1.11. */
+#define SVN_CONFIG_OPTION_LINK_PRISTINES            "link-pristines"
+/** @since New in 1.11. */
+#define SVN_CONFIG_OPTION_STORE_PRISTINE            "store-pristine"
+/** @since New in 1.11. */
+#define SVN_CONFIG_OPTION_PRISTINE_CACHE_SIZE       "pristine-cache-size"
+/** @since New in 1.11. */
+#define SVN_CONFIG_OPTION_SQLITE_READ_SNAPSHOT      "read-snapshot"
 /** @} */
 
 /** @name Repository conf directory configuration files strings
@@ -191,6 +221,10 @@ typedef struct svn_config_t svn_config_t;
 #define SVN_CONFIG_OPTION_FORCE_USERNAME_CASE       "force-username-case"
 /** @since New in 1.8. */
 #define SVN_CONFIG_OPTION_HOOKS_ENV                 "hooks-env"
+/** @since New in 1.11. */
+#define SVN_CONFIG_OPTION_STREAM_COMPRESSION        "stream-compression"
+/** @since New in 1.11. */
+#define SVN_CONFIG_OPTION_MAX_CHANGED_PATHS         "max-changed-paths"
 /** @since New in 1.5. */
 #define SVN_CONFIG_SECTION_SASL                 "sasl"
 /** @since New in 1.5. */
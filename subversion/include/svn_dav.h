@@ -205,6 +205,34 @@ extern "C" {
  * @since New in 1.8.  */
 #define SVN_DAV_REPOSITORY_MERGEINFO "SVN-Repository-MergeInfo"
 
+/** This header provides an opaque URI that the client can append the
+ * hex SHA-1 digest of a file's contents to, in order to GET those
+ * contents under a name that does not depend on any path or revision.
+ * The request must carry #SVN_DAV_TEXT_LOCATION_HEADER.  As the
+ * response is determined by the URI alone, the server allows shared
+ * HTTP caches to keep it forever.  (HTTP protocol v2 only)
+ * @since New in 1.11.  */
+#define SVN_DAV_TEXT_STUB_HEADER "SVN-Text-Stub"
+
+/** This header provides an opaque URI that the client can append
+ * BASE-MD5/SHA-1, i.e. the hex MD5 digest of a delta base, a slash and
+ * the hex SHA-1 digest of a file's contents, in order to GET an svndiff
+ * that turns the former into the latter.  The request must carry
+ * #SVN_DAV_TEXT_LOCATION_HEADER and #SVN_DAV_DELTA_BASE_HEADER.  The
+ * response is cacheable like those for #SVN_DAV_TEXT_STUB_HEADER but
+ * depends on the Accept-Encoding header, too.  (HTTP protocol v2 only)
+ * @since New in 1.11.  */
+#define SVN_DAV_DELTA_STUB_HEADER "SVN-Delta-Stub"
+
+/** This header is used in GET requests for the URIs described in
+ * #SVN_DAV_TEXT_STUB_HEADER and #SVN_DAV_DELTA_STUB_HEADER.  It tells the
+ * server where to find the requested contents, as a URI built from
+ * #SVN_DAV_REV_ROOT_STUB_HEADER.  The server fails the request if the
+ * contents found there don't match the digest given in the URI.
+ * (HTTP protocol v2 only)
+ * @since New in 1.11.  */
+#define SVN_DAV_TEXT_LOCATION_HEADER "SVN-Text-Location"
+
 /**
  * @name Fulltext MD5 headers
  *
@@ -404,6 +432,33 @@ extern "C" {
 #define SVN_DAV_NS_DAV_SVN_LIST\
             SVN_DAV_PROP_NS_DAV "svn/list"
 
+/** Presence of this in a DAV header in an OPTIONS response indicates
+ * that the transmitter (in this case, the server) knows how to handle
+ * the since-revision element of 'list' requests.
+ *
+ * @since New in 1.11.
+ */
+#define SVN_DAV_NS_DAV_SVN_LIST_SINCE\
+            SVN_DAV_PROP_NS_DAV "svn/list-since"
+
+/** Presence of this in a DAV header in an OPTIONS response indicates
+ * that the transmitter (in this case, the server) supports the
+ * stat-many-report.
+ *
+ * @since New in 1.11.
+ */
+#define SVN_DAV_NS_DAV_SVN_STAT_MANY\
+            SVN_DAV_PROP_NS_DAV "svn/stat-many"
+
+/** Presence of this in a DAV header in an OPTIONS response indicates
+ * that the transmitter (in this case, the server) supports the
+ * rev-proplist-range-report.
+ *
+ * @since New in 1.11.
+ */
+#define SVN_DAV_NS_DAV_SVN_REV_PROPLIST_RANGE\
+            SVN_DAV_PROP_NS_DAV "svn/rev-proplist-range"
+
 /** Presence of this in a DAV header in an OPTIONS response indicates
  * that the transmitter (in this case, the server) knows how to handle
  * svndiff2 format encoding.
@@ -413,6 +468,15 @@ extern "C" {
 #define SVN_DAV_NS_DAV_SVN_SVNDIFF2\
             SVN_DAV_PROP_NS_DAV "svn/svndiff2"
 
+/** Presence of this in a DAV header in an OPTIONS response indicates
+ * that the transmitter (in this case, the server) knows how to handle
+ * svndiff3 format encoding.
+ *
+ * @since New in 1.11.
+ */
+#define SVN_DAV_NS_DAV_SVN_SVNDIFF3\
+            SVN_DAV_PROP_NS_DAV "svn/svndiff3"
+
 /** Presence of this in a DAV header in an OPTIONS response indicates
  * that the transmitter (in this case, the server) sends the result
  * checksum in the response to a successful PUT request.
@@ -422,6 +486,30 @@ extern "C" {
 #define SVN_DAV_NS_DAV_SVN_PUT_RESULT_CHECKSUM\
             SVN_DAV_PROP_NS_DAV "svn/put-result-checksum"
 
+/** Presence of this in a DAV header in an OPTIONS response indicates
+ * that the transmitter (in this case, the server) sends log reports
+ * as a series of skels instead of XML if the request contains the
+ * binary-report element.
+ *
+ * Such responses have the content type #SVN_SKEL_MIME_TYPE.  The body
+ * consists of records, each being the decimal length of a skel, a
+ * newline and the skel itself.  The records are
+ *
+ *   ( change PATH ACTION NODE-KIND TEXT-MODS PROP-MODS
+ *            [ COPYFROM-PATH COPYFROM-REV ] )
+ *   ( log-item REVISION PROPLIST [ has-children ] [ subtractive-merge ] )
+ *   ( failure APR-ERR MESSAGE )
+ *   ( done )
+ *
+ * where the change records of a revision precede its log-item record
+ * and ACTION is one of "A", "D", "M" and "R".  Property values and paths
+ * are sent verbatim, i.e. without any escaping or base64 encoding.
+ *
+ * @since New in 1.11.
+ */
+#define SVN_DAV_NS_DAV_SVN_BINARY_LOG\
+            SVN_DAV_PROP_NS_DAV "svn/binary-log"
+
 /** @} */
 
 /** @} */
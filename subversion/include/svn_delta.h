@@ -522,7 +522,13 @@ svn_txdelta_apply(svn_stream_t *source,
  *
  * @since New in 1.7.  Since 1.10, @a svndiff_version can be 2 for the
  * svndiff2 format.  @a compression_level is currently ignored if
- * @a svndiff_version is set to 2.
+ * @a svndiff_version is set to 2.  Since 1.11, @a svndiff_version can
+ * be 3 for the svndiff3 format, which is the only one that can carry
+ * the large windows produced by some repository back ends.  It can also
+ * be 4 for the svndiff4 format, which is svndiff3 using Zstandard instead
+ * of zlib.  @a compression_level is then the Zstandard level from 1 to 19.
+ * Writing and reading svndiff4 fails with #SVN_ERR_UNSUPPORTED_FEATURE if
+ * Subversion has been built without Zstandard support.
  */
 void
 svn_txdelta_to_svndiff3(svn_txdelta_window_handler_t *handler,
@@ -1181,8 +1187,39 @@ typedef struct svn_delta_editor_t
     void *open_baton,
     apr_pool_t *scratch_pool);
 
-  /* Be sure to update svn_delta_get_cancellation_editor() and
-   * svn_delta_default_editor() if you add a new callback here. */
+  /** Try to provide the new revision of a file by naming its contents
+   * rather than transmitting them.
+   * This callback operates on the passed-in @a editor instance.
+   *
+   * @a file_baton indicates the file we're creating or updating; it is
+   * the baton set by some prior @c add_file or @c open_file callback.
+   *
+   * @a sha1_checksum is the SHA-1 checksum of the new fulltext of the
+   * file.  If the receiver already has content with that checksum
+   * available, it will use it as the file's new text and set @a *applied
+   * to TRUE; the driver must then not call @c apply_textdelta or
+   * @c apply_textdelta_stream for this file.  Otherwise, @a *applied is
+   * set to FALSE, nothing is changed, and the driver must transmit the
+   * text as usual.
+   *
+   * This callback is optional: drivers must check for @c NULL and fall
+   * back to @c apply_textdelta in that case.  svn_delta_default_editor()
+   * leaves it @c NULL.
+   *
+   * Any temporary allocations may be performed in @a scratch_pool.
+   *
+   * @since New in 1.11.
+   */
+  svn_error_t *(*apply_text_by_checksum)(
+    svn_boolean_t *applied,
+    const struct svn_delta_editor_t *editor,
+    void *file_baton,
+    const svn_checksum_t *sha1_checksum,
+    apr_pool_t *scratch_pool);
+
+  /* Be sure to update svn_delta_get_cancellation_editor(),
+   * svn_delta__get_debug_editor() and svn_delta_default_editor() if you
+   * add a new callback here. */
 } svn_delta_editor_t;
 
 
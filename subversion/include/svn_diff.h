@@ -455,6 +455,24 @@ typedef enum svn_diff_file_ignore_space_t
   svn_diff_file_ignore_space_all
 } svn_diff_file_ignore_space_t;
 
+/** Which algorithm to use when looking for the differences between files.
+ *
+ * @since New in 1.11.
+ */
+typedef enum svn_diff_file_algorithm_t
+{
+  /** Find a minimal diff using the O(ND) longest common subsequence
+   * algorithm. */
+  svn_diff_file_algorithm_lcs,
+
+  /** Match the lines that occur exactly once in both files first ("patience
+   * diff") and only use the LCS algorithm for the remaining regions that
+   * have no such lines.  This is much faster on large, heavily rewritten
+   * files and tends to give more readable diffs, but they may not be
+   * minimal. */
+  svn_diff_file_algorithm_patience
+} svn_diff_file_algorithm_t;
+
 /** Options to control the behaviour of the file diff routines.
  *
  * @since New in 1.4.
@@ -487,6 +505,12 @@ typedef struct svn_diff_file_options_t
    *
    * @since New in 1.9 */
   int context_size;
+
+  /** The algorithm to use for two-way diffs and three-way merges.  The
+   * default is @c svn_diff_file_algorithm_lcs.
+   *
+   * @since New in 1.11 */
+  svn_diff_file_algorithm_t algorithm;
 } svn_diff_file_options_t;
 
 /** Allocate a @c svn_diff_file_options_t structure in @a pool, initializing
@@ -510,6 +534,7 @@ svn_diff_file_options_create(apr_pool_t *pool);
  * - --ignore-eol-style
  * - --show-c-function, -p @since New in 1.5.
  * - --context, -U ARG @since New in 1.9.
+ * - --patience @since New in 1.11.
  * - --unified, -u (for compatibility, does nothing).
  */
 svn_error_t *
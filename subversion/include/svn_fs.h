@@ -115,6 +115,12 @@ typedef struct svn_fs_t svn_fs_t;
  * i.e. this will not create warning at runtime if there
  * is no efficient support for revprop caching.
  *
+ * Since 1.11, FSFS enables this by default.  Cached revprops are then
+ * shared between all FS instances of the process and remain valid across
+ * svn_fs_refresh_revision_props() for as long as no revprop has been
+ * changed in the repository.  If disabled, FSFS still caches revprops
+ * but discards them at every refresh.
+ *
  * @since New in 1.8.
  */
 #define SVN_FS_CONFIG_FSFS_CACHE_REVPROPS       "fsfs-cache-revprops"
@@ -166,6 +172,76 @@ typedef struct svn_fs_t svn_fs_t;
  */
 #define SVN_FS_CONFIG_FSFS_LOG_ADDRESSING       "fsfs-log-addressing"
 
+/** Select how a newly created FSFS repository stores its locks.  The
+ * value is either "digest", the default, storing one file per locked
+ * path and its parent folders, or "log", keeping all locks in a single
+ * append-only file that the server indexes in memory.  The latter
+ * scales better with large numbers of locks.
+ *
+ * This option will only be used during the creation of new repositories
+ * and is otherwise ignored.  Use "svnfsfs convert-locks" to change the
+ * lock storage of an existing repository.  "log" requires FSFS format 8
+ * and older releases can't open repositories that use it.
+ *
+ * @since New in 1.11.
+ */
+#define SVN_FS_CONFIG_FSFS_LOCK_STORAGE         "fsfs-lock-storage"
+
+/** Enable / disable large delta windows for a newly created FSFS
+ * repository.  If enabled, deltas are stored as svndiff3 with windows
+ * of up to 1 MB whose source views overlap, which compresses large
+ * binary files much better.  Only Subversion 1.11 and later can open
+ * such repositories.  Defaults to disabled.
+ *
+ * This option will only be used during the creation of new repositories
+ * and is otherwise ignored.
+ *
+ * @since New in 1.11.
+ */
+#define SVN_FS_CONFIG_FSFS_LARGE_DELTA_WINDOWS  "fsfs-large-delta-windows"
+
+/** Enable / disable chunked storage of large file representations in a
+ * FSFS repository.  If enabled, files above a size threshold set in
+ * fsfs.conf are split into content-defined chunks, each of which is
+ * shared through the rep-cache, so that small edits to large binaries
+ * only add the chunks that actually changed.  Only Subversion 1.11 and
+ * later can open such repositories.  Defaults to disabled.
+ *
+ * This option will only be used during the creation of new repositories
+ * and is otherwise ignored.
+ *
+ * @since New in 1.11.
+ */
+#define SVN_FS_CONFIG_FSFS_CHUNKED_REPS         "fsfs-chunked-reps"
+
+/** Enable / disable indexed storage of large directories in a FSFS
+ * repository.  If enabled, the listings of large directories are split
+ * into blocks of sorted entries plus an index of these blocks.  Looking
+ * up a single entry then only reads the index and one block, and
+ * modifying a directory only writes the blocks that actually changed.
+ * Only Subversion 1.11 and later can open such repositories.  Defaults
+ * to disabled.
+ *
+ * This option will only be used during the creation of new repositories
+ * and is otherwise ignored.
+ *
+ * @since New in 1.11.
+ */
+#define SVN_FS_CONFIG_FSFS_INDEXED_DIRS         "fsfs-indexed-dirs"
+
+/** Enable / disable Zstandard compression of deltas in a FSFS repository.
+ * If enabled, the repository may store deltas in svndiff version 4, and
+ * Zstandard becomes the default compression of fsfs.conf.  Creating such
+ * repositories fails if Subversion has been built without Zstandard.
+ * Only Subversion 1.11 and later can open them.  Defaults to disabled.
+ *
+ * This option will only be used during the creation of new repositories
+ * and is otherwise ignored.
+ *
+ * @since New in 1.11.
+ */
+#define SVN_FS_CONFIG_FSFS_ZSTD_COMPRESSION     "fsfs-zstd-compression"
+
 /* Note to maintainers: if you add further SVN_FS_CONFIG_FSFS_CACHE_* knobs,
    update fs_fs.c:verify_as_revision_before_current_plus_plus(). */
 
@@ -1735,6 +1811,49 @@ svn_fs_paths_changed3(svn_fs_path_change_iterator_t **iterator,
                       apr_pool_t *result_pool,
                       apr_pool_t *scratch_pool);
 
+/** Callback type used with svn_fs_paths_changed_range().
+ *
+ * @a iterator gives access to the changed paths of @a revision, just like
+ * svn_fs_paths_changed3() would for the respective revision root.  It
+ * becomes invalid as soon as this callback returns.  @a baton is the
+ * receiver baton given to svn_fs_paths_changed_range().
+ *
+ * Use @a scratch_pool for temporary allocations.
+ *
+ * @since New in 1.11.
+ */
+typedef svn_error_t *
+(*svn_fs_paths_changed_receiver_t)(void *baton,
+                                   svn_revnum_t revision,
+                                   svn_fs_path_change_iterator_t *iterator,
+                                   apr_pool_t *scratch_pool);
+
+/** Determine what has changed in each revision from @a start to @a end
+ * (inclusive) in @a fs.
+ *
+ * Invoke @a receiver with @a receiver_baton once per revision, in the
+ * order given by @a start and @a end, i.e. in descending order if
+ * @a start is larger than @a end.  This is equivalent to calling
+ * svn_fs_paths_changed3() on each revision root but allows backends to
+ * fetch the change lists of many revisions in a single pass.
+ *
+ * If @a cancel_func is not @c NULL, call it with @a cancel_baton to
+ * check for cancellation between revisions.
+ *
+ * Use @a scratch_pool for temporary allocations.
+ *
+ * @since New in 1.11.
+ */
+svn_error_t *
+svn_fs_paths_changed_range(svn_fs_t *fs,
+                           svn_revnum_t start,
+                           svn_revnum_t end,
+                           svn_fs_paths_changed_receiver_t receiver,
+                           void *receiver_baton,
+                           svn_cancel_func_t cancel_func,
+                           void *cancel_baton,
+                           apr_pool_t *scratch_pool);
+
 /** Same as svn_fs_paths_changed3() but returning all changes in a single,
  * large data structure and using a single pool for all allocations.
  *
@@ -1784,6 +1903,54 @@ svn_fs_check_path(svn_node_kind_t *kind_p,
                   const char *path,
                   apr_pool_t *pool);
 
+/** Basic information about a node, as returned by svn_fs_stat_paths().
+ *
+ * @note To allow for extending this structure in future releases, never
+ * allocate it yourself.
+ *
+ * @since New in 1.11.
+ */
+typedef struct svn_fs_path_stat_t
+{
+  /** The node kind or #svn_node_none if the path does not exist.
+   * All other members are undefined in the latter case. */
+  svn_node_kind_t kind;
+
+  /** The file length or #SVN_INVALID_FILESIZE for directories. */
+  svn_filesize_t size;
+
+  /** Whether the node has any properties. */
+  svn_boolean_t has_props;
+
+  /** The revision in which the node was last changed, as returned by
+   * svn_fs_node_created_rev(). */
+  svn_revnum_t created_rev;
+} svn_fs_path_stat_t;
+
+/** Look up all @a paths (an array of <tt>const char *</tt>) under @a root
+ * and set @a *stats to an array of the same length whose elements are the
+ * #svn_fs_path_stat_t * for the respective path.  Paths that do not exist
+ * under @a root get a #svn_node_none entry.
+ *
+ * This is equivalent to but may be much faster than calling
+ * svn_fs_check_path(), svn_fs_file_length(), svn_fs_node_has_props()
+ * and svn_fs_node_created_rev() for each path: backends may resolve all
+ * paths in a single traversal, sharing the lookup of common parent
+ * directories.  That works best for batches of sibling paths such as the
+ * entries of a directory.
+ *
+ * Allocate @a *stats in @a result_pool and use @a scratch_pool for
+ * temporary allocations.
+ *
+ * @since New in 1.11.
+ */
+svn_error_t *
+svn_fs_stat_paths(apr_array_header_t **stats,
+                  svn_fs_root_t *root,
+                  const apr_array_header_t *paths,
+                  apr_pool_t *result_pool,
+                  apr_pool_t *scratch_pool);
+
 
 /** An opaque node history object. */
 typedef struct svn_fs_history_t svn_fs_history_t;
@@ -2626,6 +2793,34 @@ svn_fs_apply_text(svn_stream_t **contents_p,
                   const char *result_checksum,
                   apr_pool_t *pool);
 
+/** Try to set the contents of the file @a path in @a root to a text
+ * that already exists in the filesystem.  @a root must be the root of a
+ * transaction, not a revision.
+ *
+ * @a sha1_checksum is the SHA-1 checksum of the desired fulltext.  If
+ * the filesystem can locate and verify an existing representation with
+ * that checksum, it becomes the new contents of @a path exactly as if
+ * it had been written through svn_fs_apply_text(), and @a *applied is
+ * set to #TRUE.  Otherwise, @a *applied is set to #FALSE and the
+ * transaction is left unchanged; the caller must then provide the
+ * contents in one of the usual ways.
+ *
+ * Backends that do not support representation sharing, or
+ * repositories that have it disabled, always set @a *applied to #FALSE.
+ *
+ * If @a path does not exist in @a root, return an error.
+ *
+ * Do any necessary temporary allocation in @a pool.
+ *
+ * @since New in 1.11.
+ */
+svn_error_t *
+svn_fs_apply_text_by_checksum(svn_boolean_t *applied,
+                              svn_fs_root_t *root,
+                              const char *path,
+                              const svn_checksum_t *sha1_checksum,
+                              apr_pool_t *pool);
+
 
 /** Check if the contents of two root/path combos are different.
  *
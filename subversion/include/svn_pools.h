@@ -72,11 +72,22 @@ svn_pool_create_ex_debug(pool, allocator, APR_POOL__FILE_LINE__)
 /** Create a pool as a subpool of @a parent_pool */
 #define svn_pool_create(parent_pool) svn_pool_create_ex(parent_pool, NULL)
 
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+void
+svn_pool__clear_debug(apr_pool_t *pool,
+                      const char *file_line);
+#endif /* DOXYGEN_SHOULD_SKIP_THIS */
+
 /** Clear a @a pool destroying its children.
  *
  * This define for @c svn_pool_clear exists for completeness.
  */
+#if APR_POOL_DEBUG
+#define svn_pool_clear(pool) \
+svn_pool__clear_debug(pool, APR_POOL__FILE_LINE__)
+#else
 #define svn_pool_clear apr_pool_clear
+#endif /* APR_POOL_DEBUG */
 
 
 /** Destroy a @a pool and all of its children.
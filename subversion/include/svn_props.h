@@ -672,6 +672,12 @@ svn_prop_name_is_valid(const char *prop_name);
  */
 #define SVNSYNC_PROP_CURRENTLY_COPYING  SVNSYNC_PROP_PREFIX "currently-copying"
 
+/** Identifies the last revision up to which all revisions have been
+ * copied at the filesystem level, see 'svnsync synchronize --fs-copy'.
+ * @since New in 1.11.
+ */
+#define SVNSYNC_PROP_FS_COPIED_REV      SVNSYNC_PROP_PREFIX "fs-copied-rev"
+
 
 /**
  * This is a list of all revision properties.
@@ -685,7 +691,8 @@ svn_prop_name_is_valid(const char *prop_name);
                                     SVNSYNC_PROP_FROM_URL, \
                                     SVNSYNC_PROP_FROM_UUID, \
                                     SVNSYNC_PROP_LAST_MERGED_REV, \
-                                    SVNSYNC_PROP_CURRENTLY_COPYING,
+                                    SVNSYNC_PROP_CURRENTLY_COPYING, \
+                                    SVNSYNC_PROP_FS_COPIED_REV,
 
 /** @} */
 
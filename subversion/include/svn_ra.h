@@ -221,6 +221,18 @@ typedef void (*svn_ra_progress_notify_func_t)(apr_off_t progress,
                                               void *baton,
                                               apr_pool_t *pool);
 
+/**
+ * Callback function type for concurrency notification.
+ *
+ * @a concurrency is the number of requests that the RA layer now allows
+ * to be outstanding at the same time, @a baton is the callback baton.
+ *
+ * @since New in 1.11.
+ */
+typedef void (*svn_ra_concurrency_notify_func_t)(int concurrency,
+                                                 void *baton,
+                                                 apr_pool_t *pool);
+
 /**
  * Callback function type for replay_range actions.
  *
@@ -621,6 +633,16 @@ typedef struct svn_ra_callbacks2_t
    * @since New in 1.9.
    */
   void *tunnel_baton;
+
+  /** Notification callback used by RA modules that adapt the number of
+   * parallel requests to the observed network and server behavior, e.g.
+   * ra_serf with the "http-adaptive-concurrency" option.  It is invoked
+   * whenever that number changes.  May be NULL if not used.
+   *
+   * As its baton, progress_baton is used.
+   * @since New in 1.11.
+   */
+  svn_ra_concurrency_notify_func_t concurrency_func;
 } svn_ra_callbacks2_t;
 
 /** Similar to svn_ra_callbacks2_t, except that the progress
@@ -929,6 +951,51 @@ svn_ra_rev_proplist(svn_ra_session_t *session,
                     apr_hash_t **props,
                     apr_pool_t *pool);
 
+/**
+ * The callback invoked by svn_ra_rev_proplist_range() for each of the
+ * requested revisions.  @a props maps (<tt>const char *</tt>) names to
+ * (<tt>@c svn_string_t *</tt>) values of the unversioned properties of
+ * @a revision, like svn_ra_rev_proplist() would return them.  @a baton
+ * is the caller's baton.
+ *
+ * Use @a scratch_pool for temporary allocations.
+ *
+ * @since New in 1.11.
+ */
+typedef svn_error_t *(*svn_ra_rev_proplist_receiver_t)(
+  svn_revnum_t revision,
+  apr_hash_t *props,
+  void *baton,
+  apr_pool_t *scratch_pool);
+
+/**
+ * Fetch the unversioned properties of all revisions from @a start_rev
+ * to @a end_rev, inclusive, in the repository of @a session.
+ * @a start_rev must not be greater than @a end_rev.
+ *
+ * Invoke @a receiver with @a receiver_baton for each of the revisions,
+ * in ascending order.  The results are being reported while they are
+ * being received from the server.  Hence @a receiver must not use
+ * @a session.
+ *
+ * Servers with the #SVN_RA_CAPABILITY_REV_PROPLIST_RANGE capability send
+ * all of the properties in response to a single request, which makes
+ * this much faster than calling svn_ra_rev_proplist() for each revision.
+ * For other servers, this falls back to one svn_ra_rev_proplist() call
+ * per revision.
+ *
+ * Use @a scratch_pool for temporary allocations.
+ *
+ * @since New in 1.11.
+ */
+svn_error_t *
+svn_ra_rev_proplist_range(svn_ra_session_t *session,
+                          svn_revnum_t start_rev,
+                          svn_revnum_t end_rev,
+                          svn_ra_rev_proplist_receiver_t receiver,
+                          void *receiver_baton,
+                          apr_pool_t *scratch_pool);
+
 /**
  * Set @a *value to the value of unversioned property @a name attached to
  * revision @a rev in the repository of @a session.  If @a rev has no
@@ -1075,6 +1142,58 @@ svn_ra_get_file(svn_ra_session_t *session,
                 apr_hash_t **props,
                 apr_pool_t *pool);
 
+/**
+ * The callback invoked by svn_ra_get_files() for each of the requested
+ * files, before their contents arrive.  @a path and @a revision identify
+ * the file; if HEAD was requested, @a revision is the actual revision
+ * number.  @a props contains the file's properties, like svn_ra_get_file()
+ * would return them, or is @c NULL if they were not requested.  @a baton
+ * is the caller's baton.
+ *
+ * Set @a *stream to the stream to push the file's contents to, or to
+ * @c NULL to discard them.  The stream will be closed once all of the
+ * contents have been written to it.  It may be allocated in
+ * @a result_pool, which remains valid until then.
+ *
+ * @since New in 1.11.
+ */
+typedef svn_error_t *(*svn_ra_file_receiver_t)(svn_stream_t **stream,
+                                               const char *path,
+                                               svn_revnum_t revision,
+                                               apr_hash_t *props,
+                                               void *baton,
+                                               apr_pool_t *result_pool);
+
+/**
+ * Fetch the contents and, if @a want_props is set, the properties of many
+ * files at once.  @a paths is an array of const char * paths relative to
+ * the @a session's URL, and @a revisions is an array of #svn_revnum_t of
+ * the same length.  Fetch each of the @a paths in the corresponding
+ * revision; #SVN_INVALID_REVNUM means HEAD.
+ *
+ * Invoke @a receiver with @a receiver_baton for each of the files, in no
+ * particular order, and push the contents to the stream it returns.
+ * The files are being reported while they are being received from the
+ * server.  Hence neither @a receiver nor the streams may use @a session.
+ *
+ * Servers with the #SVN_RA_CAPABILITY_GET_FILES capability send all of
+ * the files in response to a single request, which keeps the connection
+ * busy instead of waiting for a round trip per file.  For other servers,
+ * this falls back to one svn_ra_get_file() call per file.
+ *
+ * Use @a scratch_pool for temporary allocations.
+ *
+ * @since New in 1.11.
+ */
+svn_error_t *
+svn_ra_get_files(svn_ra_session_t *session,
+                 const apr_array_header_t *paths,
+                 const apr_array_header_t *revisions,
+                 svn_boolean_t want_props,
+                 svn_ra_file_receiver_t receiver,
+                 void *receiver_baton,
+                 apr_pool_t *scratch_pool);
+
 /**
  * If @a dirents is non @c NULL, set @a *dirents to contain all the entries
  * of directory @a path at @a revision.  The keys of @a dirents will be
@@ -1164,6 +1283,14 @@ typedef svn_error_t *(* svn_ra_dirent_receiver_t)(const char *rel_path,
  * apr_fnmatch() for glob matching and requiring '.' to matched by dots
  * in the path.
  *
+ * If @a since_rev is a valid revision, only report entries whose created
+ * revision is @a since_rev or younger.  Servers that support it skip
+ * sub-trees that did not change since then without walking them.  For
+ * older servers, the entries get filtered on the client side instead.
+ *
+ * The entries are being reported while they are being received from the
+ * server, so memory usage does not depend on the size of the sub-tree.
+ *
  * @a path must point to a directory and @a depth must be at least
  * #svn_depth_empty.
  *
@@ -1173,8 +1300,27 @@ typedef svn_error_t *(* svn_ra_dirent_receiver_t)(const char *rel_path,
  *
  * Use @a scratch_pool for temporary memory allocation.
  *
+ * @since New in 1.11.
+ */
+svn_error_t *
+svn_ra_list2(svn_ra_session_t *session,
+             const char *path,
+             svn_revnum_t revision,
+             const apr_array_header_t *patterns,
+             svn_depth_t depth,
+             svn_revnum_t since_rev,
+             apr_uint32_t dirent_fields,
+             svn_ra_dirent_receiver_t receiver,
+             void *receiver_baton,
+             apr_pool_t *scratch_pool);
+
+/**
+ * Like svn_ra_list2(), but with @a since_rev set to #SVN_INVALID_REVNUM.
+ *
  * @since New in 1.10.
+ * @deprecated Provided for backward compatibility with the 1.10 API.
  */
+SVN_DEPRECATED
 svn_error_t *
 svn_ra_list(svn_ra_session_t *session,
             const char *path,
@@ -1721,6 +1867,51 @@ svn_ra_stat(svn_ra_session_t *session,
             svn_dirent_t **dirent,
             apr_pool_t *pool);
 
+/**
+ * The callback invoked by svn_ra_stat_many() for each of the requested
+ * nodes.  @a path and @a revision identify the node; if HEAD was
+ * requested, @a revision is the actual revision number.  @a dirent
+ * describes the node, like svn_ra_stat() would, or is @c NULL if it
+ * does not exist.  @a baton is the caller's baton.
+ *
+ * Use @a scratch_pool for temporary allocations.
+ *
+ * @since New in 1.11.
+ */
+typedef svn_error_t *(*svn_ra_stat_receiver_t)(const char *path,
+                                               svn_revnum_t revision,
+                                               svn_dirent_t *dirent,
+                                               void *baton,
+                                               apr_pool_t *scratch_pool);
+
+/**
+ * Stat many nodes at once.  @a paths is an array of const char * paths
+ * relative to the @a session's URL, and @a revisions is an array of
+ * #svn_revnum_t of the same length.  Look up each of the @a paths in the
+ * corresponding revision; #SVN_INVALID_REVNUM means HEAD.
+ *
+ * Invoke @a receiver with @a receiver_baton for each of the nodes, in the
+ * order of @a paths.  The results are being reported while they are
+ * being received from the server.  Hence @a receiver must not use
+ * @a session.
+ *
+ * Servers with the #SVN_RA_CAPABILITY_STAT_MANY capability handle all of
+ * the nodes in a single request, which makes this much faster than
+ * calling svn_ra_stat() for each of them.  For other servers, this falls
+ * back to one svn_ra_stat() call per node.
+ *
+ * Use @a scratch_pool for temporary allocations.
+ *
+ * @since New in 1.11.
+ */
+svn_error_t *
+svn_ra_stat_many(svn_ra_session_t *session,
+                 const apr_array_header_t *paths,
+                 const apr_array_header_t *revisions,
+                 svn_ra_stat_receiver_t receiver,
+                 void *receiver_baton,
+                 apr_pool_t *scratch_pool);
+
 
 /**
  * Set @a *uuid to the repository's UUID, allocated in @a pool.
@@ -2239,6 +2430,39 @@ svn_ra_has_capability(svn_ra_session_t *session,
  */
 #define SVN_RA_CAPABILITY_LIST "list"
 
+/**
+ * The capability of a server to skip unchanged sub-trees in the list
+ * command, as requested by the @a since_rev parameter of svn_ra_list2().
+ *
+ * @since New in 1.11.
+ */
+#define SVN_RA_CAPABILITY_LIST_SINCE "list-since"
+
+/**
+ * The capability of a server to stat many nodes in a single request, as
+ * used by svn_ra_stat_many().
+ *
+ * @since New in 1.11.
+ */
+#define SVN_RA_CAPABILITY_STAT_MANY "stat-many"
+
+/**
+ * The capability of a server to send many files in response to a single
+ * request, as used by svn_ra_get_files().
+ *
+ * @since New in 1.11.
+ */
+#define SVN_RA_CAPABILITY_GET_FILES "get-files"
+
+/**
+ * The capability of a server to send the revision properties of a range
+ * of revisions in response to a single request, as used by
+ * svn_ra_rev_proplist_range().
+ *
+ * @since New in 1.11.
+ */
+#define SVN_RA_CAPABILITY_REV_PROPLIST_RANGE "rev-proplist-range"
+
 
 /*       *** PLEASE READ THIS IF YOU ADD A NEW CAPABILITY ***
  *
@@ -50,6 +50,7 @@ extern "C" {
 #define SVN_RA_SVN_CAP_EDIT_PIPELINE "edit-pipeline"
 #define SVN_RA_SVN_CAP_SVNDIFF1 "svndiff1"
 #define SVN_RA_SVN_CAP_SVNDIFF2_ACCEPTED "accepts-svndiff2"
+#define SVN_RA_SVN_CAP_SVNDIFF3_ACCEPTED "accepts-svndiff3"
 #define SVN_RA_SVN_CAP_ABSENT_ENTRIES "absent-entries"
 /* maps to SVN_RA_CAPABILITY_COMMIT_REVPROPS: */
 #define SVN_RA_SVN_CAP_COMMIT_REVPROPS "commit-revprops"
@@ -71,6 +72,33 @@ extern "C" {
 #define SVN_RA_SVN_CAP_GET_FILE_REVS_REVERSE "file-revs-reverse"
 /* maps to SVN_RA_CAPABILITY_LIST */
 #define SVN_RA_SVN_CAP_LIST "list"
+/** maps to SVN_RA_CAPABILITY_LIST_SINCE.  @since New in 1.11. */
+#define SVN_RA_SVN_CAP_LIST_SINCE "list-since"
+/** maps to SVN_RA_CAPABILITY_STAT_MANY.  @since New in 1.11. */
+#define SVN_RA_SVN_CAP_STAT_MANY "stat-many"
+
+/** maps to SVN_RA_CAPABILITY_GET_FILES.  @since New in 1.11. */
+#define SVN_RA_SVN_CAP_GET_FILES "get-files"
+/** maps to SVN_RA_CAPABILITY_REV_PROPLIST_RANGE.  @since New in 1.11. */
+#define SVN_RA_SVN_CAP_REV_PROPLIST_RANGE "rev-proplist-range"
+/** Server supports the change-rev-props command.  @since New in 1.11. */
+#define SVN_RA_SVN_CAP_CHANGE_REV_PROPS "change-rev-props"
+/** Client accepts LZ4 stream compression of the whole connection.
+ * @since New in 1.11. */
+#define SVN_RA_SVN_CAP_COMPRESS_LZ4_ACCEPTED "accepts-compress-lz4"
+/** Client accepts zlib stream compression of the whole connection.
+ * @since New in 1.11. */
+#define SVN_RA_SVN_CAP_COMPRESS_ZLIB_ACCEPTED "accepts-compress-zlib"
+/** Server compresses the connection with LZ4 after the repository
+ * info response.  @since New in 1.11. */
+#define SVN_RA_SVN_CAP_COMPRESS_LZ4 "compress-lz4"
+/** Server compresses the connection with zlib after the repository
+ * info response.  @since New in 1.11. */
+#define SVN_RA_SVN_CAP_COMPRESS_ZLIB "compress-zlib"
+/** Server understands the "apply-text-by-checksum" edit command, which
+ * lets a committing client skip sending texts the repository already
+ * has.  @since New in 1.11. */
+#define SVN_RA_SVN_CAP_APPLY_TEXT_BY_CHECKSUM "apply-text-by-checksum"
 
 
 /** ra_svn passes @c svn_dirent_t fields over the wire as a list of
@@ -250,7 +250,11 @@ typedef enum svn_repos_notify_action_t
   svn_repos_notify_pack_noop,
 
   /** The revision properties got set. @since New in 1.10. */
-  svn_repos_notify_load_revprop_set
+  svn_repos_notify_load_revprop_set,
+
+  /** A revision got added to the changed-paths index.
+   * @since New in 1.11. */
+  svn_repos_notify_log_index_rev
 } svn_repos_notify_action_t;
 
 /** The type of warning occurring.
@@ -317,8 +321,8 @@ typedef struct svn_repos_notify_t
   /** Action that describes what happened in the repository. */
   svn_repos_notify_action_t action;
 
-  /** For #svn_repos_notify_dump_rev_end and #svn_repos_notify_verify_rev_end,
-   * the revision which just completed.
+  /** For #svn_repos_notify_dump_rev_end, #svn_repos_notify_verify_rev_end
+   * and #svn_repos_notify_log_index_rev, the revision which just completed.
    * For #svn_fs_upgrade_format_bumped, the new format version. */
   svn_revnum_t revision;
 
@@ -998,6 +1002,121 @@ svn_repos_hooks_setenv(svn_repos_t *repos,
                        const char *hooks_env_path,
                        apr_pool_t *scratch_pool);
 
+/** The name of the function that a hook module exports.
+ *
+ * @see svn_repos_hook_func_t
+ * @since New in 1.11.
+ */
+#define SVN_REPOS_HOOK_MODULE_FUNC "svn_repos_hook"
+
+/** Information about a hook event, passed to in-process hook modules.
+ *
+ * Only the members relevant to the hook named @a hook_name are set;
+ * all others are @c NULL, @c FALSE, @c SVN_INVALID_REVNUM or 0.  The
+ * members correspond to the arguments and standard input that the
+ * equally named hook program would receive; see the hook templates
+ * for details.
+ *
+ * @note Fields may be added to the end of this structure in future
+ * versions.  Therefore, hook modules shouldn't allocate structures of
+ * this type, to preserve binary compatibility.
+ *
+ * @since New in 1.11.
+ */
+typedef struct svn_repos_hook_info_t
+{
+  /** The name of the hook, e.g. "pre-commit". */
+  const char *hook_name;
+
+  /** The repository the hook is run for. */
+  svn_repos_t *repos;
+
+  /** The environment configured for this hook by
+   * svn_repos_hooks_setenv(), mapping <tt>const char *</tt> names to
+   * <tt>const char *</tt> values.  May be @c NULL. */
+  apr_hash_t *hook_env;
+
+  /** The authenticated user performing the action.  May be @c NULL. */
+  const char *user;
+
+  /** The client capabilities as <tt>const char *</tt> (start-commit). */
+  const apr_array_header_t *capabilities;
+
+  /** The name of the transaction (start-commit, pre-commit and
+   * post-commit). */
+  const char *txn_name;
+
+  /** The transaction root (start-commit and pre-commit) or the root of
+   * the new revision (post-commit). */
+  svn_fs_root_t *root;
+
+  /** The revision (post-commit, pre- and post-revprop-change). */
+  svn_revnum_t revision;
+
+  /** The lock tokens supplied with the commit, mapping
+   * <tt>const char *</tt> tokens to <tt>const char *</tt> paths
+   * (pre-commit). */
+  apr_hash_t *lock_tokens;
+
+  /** The path being locked or unlocked (pre-lock and pre-unlock). */
+  const char *path;
+
+  /** The paths that have been locked or unlocked as
+   * <tt>const char *</tt> (post-lock and post-unlock). */
+  const apr_array_header_t *paths;
+
+  /** The lock comment (pre-lock). */
+  const char *comment;
+
+  /** Whether an existing lock will be stolen (pre-lock) or broken
+   * (pre-unlock). */
+  svn_boolean_t steal_lock;
+
+  /** The token of the lock being removed (pre-unlock). */
+  const char *token;
+
+  /** The name of the changed revision property (pre- and
+   * post-revprop-change). */
+  const char *propname;
+
+  /** 'A'dded, 'M'odified or 'D'eleted (pre- and post-revprop-change). */
+  char action;
+
+  /** The new property value (pre-revprop-change) or the old one
+   * (post-revprop-change).  May be @c NULL. */
+  const svn_string_t *value;
+} svn_repos_hook_info_t;
+
+/** The type of the function #SVN_REPOS_HOOK_MODULE_FUNC exported by
+ * hook modules.
+ *
+ * A hook module is a shared library in the hook directory of a
+ * repository, named after the hook it implements plus the platform's
+ * shared library extension, e.g. "pre-lock.so" or "pre-lock.dll".
+ * If it exists, it is loaded once per process and its function is
+ * called in-process with the event described by @a info instead of
+ * running the hook program.  This avoids the cost of starting a
+ * process for every operation.  Without a module, the hook program
+ * gets run as usual.
+ *
+ * To block the operation, a pre- or start- hook function returns an
+ * error, which gets wrapped in an #SVN_ERR_REPOS_HOOK_FAILURE error.
+ * A pre-lock hook function may set @a *output to the lock token to
+ * use, allocated in @a result_pool; this corresponds to the output of
+ * the hook program.  @a *output is @c NULL when called.
+ *
+ * The function may be called concurrently from several threads.  It
+ * must not keep references into @a info beyond the call.  Use
+ * @a scratch_pool for temporary allocations.
+ *
+ * @since New in 1.11.
+ */
+typedef svn_error_t *(*svn_repos_hook_func_t)(
+  const char **output,
+  const svn_repos_hook_info_t *info,
+  apr_pool_t *result_pool,
+  apr_pool_t *scratch_pool);
+
 /** @} */
 
 /* ---------------------------------------------------------------*/
@@ -1398,26 +1517,61 @@ svn_repos_abort_report(void *report_baton,
  * @a ignore_ancestry instructs the function to ignore node ancestry
  * when determining how to transmit differences.
  *
+ * If @a jobs is larger than 1, compare up to @a jobs sub-trees at a time,
+ * each in its own thread using separate filesystem instances.  This
+ * happens for the directories that are changed on both sides, starting
+ * at the first level with at least two of them.  Their edits get spooled
+ * and @a editor is still driven from the calling thread, in the same
+ * order as with a single job.  Calls to @a authz_read_func may then come
+ * from any of the worker threads, but never concurrently, and may get
+ * a root different from @a src_root or @a tgt_root for the same revision.
+ * Unless both roots are revision roots or if APR has been built without
+ * thread support, @a jobs is ignored.
+ *
  * Before completing successfully, this function calls @a editor's
  * close_edit(), so the caller should expect its @a edit_baton to be
  * invalid after its use with this function.
  *
  * Do any allocation necessary for the delta computation in @a pool.
- * This function's maximum memory consumption is at most roughly
- * proportional to the greatest depth of the tree under @a tgt_root, not
- * the total size of the delta.
+ * With a single job, this function's maximum memory consumption is at
+ * most roughly proportional to the greatest depth of the tree under
+ * @a tgt_root, not the total size of the delta.
  *
- * ### svn_repos_dir_delta2 is mostly superseded by the reporter
+ * ### svn_repos_dir_delta3 is mostly superseded by the reporter
  * ### functionality (svn_repos_begin_report3 and friends).
- * ### svn_repos_dir_delta2 does allow the roots to be transaction
+ * ### svn_repos_dir_delta3 does allow the roots to be transaction
  * ### roots rather than just revision roots, and it has the
  * ### entry_props flag.  Almost all of Subversion's own code uses the
  * ### reporter instead; there are some stray references to the
- * ### svn_repos_dir_delta[2] in comments which should probably
+ * ### svn_repos_dir_delta[23] in comments which should probably
  * ### actually refer to the reporter.
  *
+ * @since New in 1.11.
+ */
+svn_error_t *
+svn_repos_dir_delta3(svn_fs_root_t *src_root,
+                     const char *src_parent_dir,
+                     const char *src_entry,
+                     svn_fs_root_t *tgt_root,
+                     const char *tgt_path,
+                     const svn_delta_editor_t *editor,
+                     void *edit_baton,
+                     svn_repos_authz_func_t authz_read_func,
+                     void *authz_read_baton,
+                     svn_boolean_t text_deltas,
+                     svn_depth_t depth,
+                     svn_boolean_t entry_props,
+                     svn_boolean_t ignore_ancestry,
+                     int jobs,
+                     apr_pool_t *pool);
+
+/**
+ * Like svn_repos_dir_delta3(), but with @a jobs set to 1.
+ *
  * @since New in 1.5.
+ * @deprecated Provided for backward compatibility with the 1.10 API.
  */
+SVN_DEPRECATED
 svn_error_t *
 svn_repos_dir_delta2(svn_fs_root_t *src_root,
                      const char *src_parent_dir,
@@ -1753,7 +1907,9 @@ typedef svn_error_t *(* svn_repos_dirent_receiver_t)(const char *path,
  * with @a receiver_baton.  The starting @a path will be reported as well.
  * Because retrieving all elements of a #svn_dirent_t can be expensive,
  * you may set @a path_info_only to receive only the path name and the node
- * kind.  The entries will be reported ordered by their path.
+ * kind.  The entries will be reported ordered by their path, depth-first,
+ * and as soon as they have been found, i.e. memory usage does not depend
+ * on the size of the sub-tree.
  *
  * @a patterns is an optional array of <tt>const char *</tt>.  If it is
  * not @c NULL, only those directory entries will be reported whose last
@@ -1761,6 +1917,12 @@ typedef svn_error_t *(* svn_repos_dirent_receiver_t)(const char *path,
  * apr_fnmatch() for glob matching and requiring '.' to matched by dots
  * in the path.
  *
+ * If @a since_rev is a valid revision, only report entries that changed
+ * in @a since_rev or later, i.e. whose created revision is at least
+ * @a since_rev.  Because the created revision of a directory reflects
+ * all changes below it, sub-trees that did not change since then will
+ * be skipped without walking them.
+ *
  * If @a authz_read_func is not @c NULL, this function will neither report
  * entries nor recurse into directories that the user has no access to.
  *
@@ -1772,8 +1934,31 @@ typedef svn_error_t *(* svn_repos_dirent_receiver_t)(const char *path,
  *
  * Use @a scratch_pool for temporary memory allocation.
  *
+ * @since New in 1.11.
+ */
+svn_error_t *
+svn_repos_list2(svn_fs_root_t *root,
+                const char *path,
+                const apr_array_header_t *patterns,
+                svn_depth_t depth,
+                svn_revnum_t since_rev,
+                svn_boolean_t path_info_only,
+                svn_repos_authz_func_t authz_read_func,
+                void *authz_read_baton,
+                svn_repos_dirent_receiver_t receiver,
+                void *receiver_baton,
+                svn_cancel_func_t cancel_func,
+                void *cancel_baton,
+                apr_pool_t *scratch_pool);
+
+/**
+ * Like svn_repos_list2(), but with @a since_rev set to
+ * #SVN_INVALID_REVNUM.
+ *
  * @since New in 1.10.
+ * @deprecated Provided for backward compatibility with the 1.10 API.
  */
+SVN_DEPRECATED
 svn_error_t *
 svn_repos_list(svn_fs_root_t *root,
                const char *path,
@@ -1788,6 +1973,50 @@ svn_repos_list(svn_fs_root_t *root,
                void *cancel_baton,
                apr_pool_t *scratch_pool);
 
+/**
+ * Write the tree at @a path under @a root as a tar archive to
+ * @a tar_stream, the way svn_client_export5() would create it on disk.
+ * @a tar_stream will not be closed.
+ *
+ * All archive entries are put below @a archive_root, a relpath that
+ * becomes the top-level directory of the archive.  If @a archive_root is
+ * empty, the children of @a path become the top-level entries, or for a
+ * file, its basename is used.  Entries are sorted by name within each
+ * directory.  Recurse down to @a depth, where #svn_depth_unknown means
+ * #svn_depth_infinity.
+ *
+ * Line endings are translated according to svn:eol-style, with
+ * @a native_eol overriding the native style unless it is @c NULL; see
+ * svn_client_export5().  Keywords are expanded unless @a ignore_keywords
+ * is set, using @a repos_root_url as the repository root URL.  Files with
+ * svn:executable get mode 0755 and files with svn:special become
+ * symbolic links.  Every node is recorded with the date of its last
+ * change.  Externals definitions are not followed.
+ *
+ * If @a authz_read_func is not @c NULL, silently leave out the nodes it
+ * does not allow reading, calling it with @a authz_read_baton.  Return
+ * #SVN_ERR_AUTHZ_UNREADABLE if @a path itself is not readable.
+ *
+ * If @a cancel_func is not @c NULL, call it with @a cancel_baton as
+ * needed.  Use @a scratch_pool for temporary allocations.
+ *
+ * @since New in 1.11.
+ */
+svn_error_t *
+svn_repos_export_tar(svn_stream_t *tar_stream,
+                     svn_fs_root_t *root,
+                     const char *path,
+                     const char *archive_root,
+                     svn_depth_t depth,
+                     svn_boolean_t ignore_keywords,
+                     const char *native_eol,
+                     const char *repos_root_url,
+                     svn_repos_authz_func_t authz_read_func,
+                     void *authz_read_baton,
+                     svn_cancel_func_t cancel_func,
+                     void *cancel_baton,
+                     apr_pool_t *scratch_pool);
+
 /**
  * Given @a path which exists at revision @a start in @a fs, set
  * @a *deleted to the revision @a path was first deleted, within the
@@ -2002,6 +2231,12 @@ svn_repos_path_change_dup(svn_repos_path_change_t *change,
  * Use @a scratch_pool for temporary allocation.  The caller may clear it
  * between or after invocations.
  *
+ * The receiver may return #SVN_ERR_CEASE_INVOCATION to indicate that it
+ * does not want to receive any further changes for the current revision.
+ * The log looper will then clear that error and continue with the next
+ * revision, reading no more of the current revision's changes list than
+ * necessary to determine its readability.  (New in 1.11.)
+ *
  * @since New in 1.10.
  */
 typedef svn_error_t *(*svn_repos_path_change_receiver_t)(
@@ -2288,6 +2523,38 @@ svn_repos_get_logs(svn_repos_t *repos,
                    void *receiver_baton,
                    apr_pool_t *pool);
 
+/**
+ * Bring the changed-paths index of @a repos up to date, creating it
+ * first if it does not exist yet.
+ *
+ * As long as that index covers the youngest revision, svn_repos_get_logs5()
+ * uses it to find the revisions that changed the requested paths instead
+ * of walking their node histories.  svn_repos_fs_get_mergeinfo2() and
+ * the mergeinfo lookups of svn_repos_get_logs5() read the svn:mergeinfo
+ * values recorded in the index in the same way.  Once it exists, every
+ * commit made through svn_repos_fs_commit_txn() adds its revision to the
+ * index.  Commits made by other means leave the index behind, which makes
+ * these functions ignore it until this function is called again.
+ *
+ * After each revision added to the index, call @a notify_func with
+ * @a notify_baton and a notification of type
+ * #svn_repos_notify_log_index_rev, if @a notify_func is not @c NULL.
+ *
+ * If @a cancel_func is not @c NULL, call it with @a cancel_baton
+ * periodically to see if the operation should be cancelled.
+ *
+ * Use @a scratch_pool for temporary allocations.
+ *
+ * @since New in 1.11.
+ */
+svn_error_t *
+svn_repos_build_log_index(svn_repos_t *repos,
+                          svn_repos_notify_func_t notify_func,
+                          void *notify_baton,
+                          svn_cancel_func_t cancel_func,
+                          void *cancel_baton,
+                          apr_pool_t *scratch_pool);
+
 
 
 /* ---------------------------------------------------------------*/
@@ -3131,10 +3398,10 @@ enum svn_repos_load_uuid
   svn_repos_load_uuid_force
 };
 
-/** Callback type for use with svn_repos_verify_fs3().  @a revision
+/** Callback type for use with svn_repos_verify_fs4().  @a revision
  * and @a verify_err are the details of a single verification failure
- * that occurred during the svn_repos_verify_fs3() call.  @a baton is
- * the same baton given to svn_repos_verify_fs3().  @a scratch_pool is
+ * that occurred during the svn_repos_verify_fs4() call.  @a baton is
+ * the same baton given to svn_repos_verify_fs4().  @a scratch_pool is
  * provided for the convenience of the implementor, who should not
  * expect it to live longer than a single callback call.
  *
@@ -3144,7 +3411,7 @@ enum svn_repos_load_uuid
  * should also call svn_error_dup() for @a verify_err.  Implementors of this
  * callback are forbidden to call svn_error_clear() for @a verify_err.
  *
- * @see svn_repos_verify_fs3
+ * @see svn_repos_verify_fs4
  *
  * @since New in 1.9.
  */
@@ -3217,12 +3484,42 @@ typedef svn_error_t *(*svn_repos_verify_callback_t)(void *baton,
  * cancel_baton as argument to see if the caller wishes to cancel the
  * verification.
  *
+ * If @a jobs is larger than 1, verify up to @a jobs revisions at a time,
+ * each in its own thread using a separate FS instance.  Notifications and
+ * calls to @a verify_callback are still delivered from the calling thread
+ * and in revision order.  @a cancel_func must be thread-safe in that case.
+ * If APR has been built without thread support, @a jobs is being ignored.
+ * The global metadata checks done by svn_fs_verify() are not affected
+ * by @a jobs.
+ *
  * Use @a scratch_pool for temporary allocation.
  *
  * @see svn_repos_verify_callback_t
  *
+ * @since New in 1.11.
+ */
+svn_error_t *
+svn_repos_verify_fs4(svn_repos_t *repos,
+                     svn_revnum_t start_rev,
+                     svn_revnum_t end_rev,
+                     svn_boolean_t check_normalization,
+                     svn_boolean_t metadata_only,
+                     int jobs,
+                     svn_repos_notify_func_t notify_func,
+                     void *notify_baton,
+                     svn_repos_verify_callback_t verify_callback,
+                     void *verify_baton,
+                     svn_cancel_func_t cancel,
+                     void *cancel_baton,
+                     apr_pool_t *scratch_pool);
+
+/**
+ * Like svn_repos_verify_fs4(), but with @a jobs set to 1.
+ *
  * @since New in 1.9.
+ * @deprecated Provided for backward compatibility with the 1.10 API.
  */
+SVN_DEPRECATED
 svn_error_t *
 svn_repos_verify_fs3(svn_repos_t *repos,
                      svn_revnum_t start_rev,
@@ -3280,7 +3577,7 @@ svn_repos_verify_fs(svn_repos_t *repos,
  * Dump the contents of the filesystem within already-open @a repos into
  * writable @a dumpstream.  If @a dumpstream is
  * @c NULL, this is effectively a primitive verify.  It is not complete,
- * however; see instead svn_repos_verify_fs3().
+ * however; see instead svn_repos_verify_fs4().
  *
  * Begin at revision @a start_rev, and dump every revision up through
  * @a end_rev.  If @a start_rev is #SVN_INVALID_REVNUM, start at revision
@@ -3335,10 +3632,44 @@ svn_repos_verify_fs(svn_repos_t *repos,
  * @a cancel_baton as argument to see if the client wishes to cancel
  * the dump.
  *
+ * If @a jobs is larger than 1, dump up to @a jobs ranges of revisions at
+ * a time, each in its own thread using a separate repository instance.
+ * The dump data of each range gets spooled and then written to
+ * @a dumpstream in revision order, so the result is the same as for a
+ * single job.  Notifications are still delivered from the calling thread
+ * and in revision order.  @a filter_func and @a cancel_func must be
+ * thread-safe in that case.  If APR has been built without thread
+ * support, @a jobs is ignored.
+ *
  * Use @a scratch_pool for temporary allocation.
  *
+ * @since New in 1.11.
+ */
+svn_error_t *
+svn_repos_dump_fs5(svn_repos_t *repos,
+                   svn_stream_t *dumpstream,
+                   svn_revnum_t start_rev,
+                   svn_revnum_t end_rev,
+                   svn_boolean_t incremental,
+                   svn_boolean_t use_deltas,
+                   svn_boolean_t include_revprops,
+                   svn_boolean_t include_changes,
+                   int jobs,
+                   svn_repos_notify_func_t notify_func,
+                   void *notify_baton,
+                   svn_repos_dump_filter_func_t filter_func,
+                   void *filter_baton,
+                   svn_cancel_func_t cancel_func,
+                   void *cancel_baton,
+                   apr_pool_t *scratch_pool);
+
+/**
+ * Like svn_repos_dump_fs5(), but with @a jobs set to 1.
+ *
  * @since New in 1.10.
+ * @deprecated Provided for backward compatibility with the 1.10 API.
  */
+SVN_DEPRECATED
 svn_error_t *
 svn_repos_dump_fs4(svn_repos_t *repos,
                    svn_stream_t *stream,
@@ -3357,7 +3688,7 @@ svn_repos_dump_fs4(svn_repos_t *repos,
                    apr_pool_t *pool);
 
 /**
- * Similar to svn_repos_dump_fs4(), but with @a include_revprops and 
+ * Similar to svn_repos_dump_fs4(), but with @a include_revprops and
  * @a include_changes both set to @c TRUE and @a filter_func and
  * @a filter_baton set to @c NULL.
  *
@@ -3469,15 +3800,47 @@ svn_repos_dump_fs(svn_repos_t *repos,
  * @note The details or the performed normalizations are deliberately
  * left unspecified and may change in the future.
  *
+ * If @a pipelined is set, parse @a dumpstream in a separate thread while
+ * the revisions are being committed.  Callbacks and notifications still
+ * happen in the calling thread and revisions are committed in order.
+ * This option is ignored if APR has no thread support.
+ *
  * If non-NULL, use @a notify_func and @a notify_baton to send notification
  * of events to the caller.
  *
  * If @a cancel_func is not @c NULL, it is called periodically with
  * @a cancel_baton as argument to see if the client wishes to cancel
- * the load.
+ * the load.  With @a pipelined set, it may get called from either thread.
+ *
+ * @since New in 1.11.
+ */
+svn_error_t *
+svn_repos_load_fs7(svn_repos_t *repos,
+                   svn_stream_t *dumpstream,
+                   svn_revnum_t start_rev,
+                   svn_revnum_t end_rev,
+                   enum svn_repos_load_uuid uuid_action,
+                   const char *parent_dir,
+                   svn_boolean_t use_pre_commit_hook,
+                   svn_boolean_t use_post_commit_hook,
+                   svn_boolean_t validate_props,
+                   svn_boolean_t ignore_dates,
+                   svn_boolean_t normalize_props,
+                   svn_boolean_t pipelined,
+                   svn_repos_notify_func_t notify_func,
+                   void *notify_baton,
+                   svn_cancel_func_t cancel_func,
+                   void *cancel_baton,
+                   apr_pool_t *pool);
+
+/**
+ * Similar to svn_repos_load_fs7(), but with the @a pipelined
+ * parameter always set to @c FALSE.
  *
  * @since New in 1.10.
+ * @deprecated Provided for backward compatibility with the 1.10 API.
  */
+SVN_DEPRECATED
 svn_error_t *
 svn_repos_load_fs6(svn_repos_t *repos,
                    svn_stream_t *dumpstream,
@@ -4244,6 +4607,30 @@ svn_repos_authz_check_access(svn_authz_t *authz,
                              svn_boolean_t *access_granted,
                              apr_pool_t *pool);
 
+/**
+ * Like svn_repos_authz_check_access() but check all @a paths, an array
+ * of <tt>const char *</tt>, at once.  Set @a *access_granted to an array
+ * of #svn_boolean_t, allocated in @a result_pool, that indicates the
+ * result for the path at the same index in @a paths.
+ *
+ * Each check continues from the longest parent path that the respective
+ * path has in common with the previous one.  Therefore, passing @a paths
+ * in sorted order is much faster than checking them in random order.
+ *
+ * Use @a scratch_pool for temporary allocations.
+ *
+ * @since New in 1.11.
+ */
+svn_error_t *
+svn_repos_authz_check_access_many(apr_array_header_t **access_granted,
+                                  svn_authz_t *authz,
+                                  const char *repos_name,
+                                  const apr_array_header_t *paths,
+                                  const char *user,
+                                  svn_repos_authz_access_t required_access,
+                                  apr_pool_t *result_pool,
+                                  apr_pool_t *scratch_pool);
+
 
 
 /** Revision Access Levels
@@ -36,8 +36,11 @@
 #include "svn_props.h"
 #include "svn_hash.h"
 #include "svn_sorts.h"
+#include "svn_config.h"
 
+#include "private/svn_ra_private.h"
 #include "private/svn_wc_private.h"
+#include "private/svn_worker_pool.h"
 
 #include "svn_private_config.h"
 
@@ -74,6 +77,10 @@ struct diff_baton {
   const struct rev *rev;
 };
 
+/* Computes the diffs between consecutive file revisions concurrently.
+   See diff_queue_create(). */
+typedef struct diff_queue_t diff_queue_t;
+
 /* The baton used for a file revision. Lives the entire operation */
 struct file_rev_baton {
   svn_revnum_t start_rev, end_rev;
@@ -106,6 +113,9 @@ struct file_rev_baton {
      happens when we move to the previous revision */
   svn_revnum_t last_revnum;
   apr_hash_t *last_props;
+
+  /* If not NULL, compute the diffs in the threads of this queue. */
+  diff_queue_t *diff_queue;
 };
 
 /* The baton used by the txdelta window handler. Allocated per revision */
@@ -282,35 +292,27 @@ static const svn_diff_output_fns_t output_fns = {
         output_diff_modified
 };
 
-/* Add the blame for the diffs between LAST_FILE and CUR_FILE to CHAIN,
-   for revision REV.  LAST_FILE may be NULL in which
-   case blame is added for every line of CUR_FILE. */
+/* Add the blame for DIFF to CHAIN, for revision REV.  DIFF may be NULL
+   for the first revision, in which case blame is added for every line. */
 static svn_error_t *
-add_file_blame(const char *last_file,
-               const char *cur_file,
+add_diff_blame(svn_diff_t *diff,
                struct blame_chain *chain,
-               struct rev *rev,
-               const svn_diff_file_options_t *diff_options,
+               const struct rev *rev,
                svn_cancel_func_t cancel_func,
-               void *cancel_baton,
-               apr_pool_t *pool)
+               void *cancel_baton)
 {
-  if (!last_file)
+  if (!diff)
     {
       SVN_ERR_ASSERT(chain->blame == NULL);
       chain->blame = blame_create(chain, rev, 0);
     }
   else
     {
-      svn_diff_t *diff;
       struct diff_baton diff_baton;
 
       diff_baton.chain = chain;
       diff_baton.rev = rev;
 
-      /* We have a previous file.  Get the diff and adjust blame info. */
-      SVN_ERR(svn_diff_file_diff_2(&diff, last_file, cur_file,
-                                   diff_options, pool));
       SVN_ERR(svn_diff_output2(diff, &diff_baton, &output_fns,
                                cancel_func, cancel_baton));
     }
@@ -318,6 +320,246 @@ add_file_blame(const char *last_file,
   return SVN_NO_ERROR;
 }
 
+/* Add the blame for the diffs between LAST_FILE and CUR_FILE to CHAIN,
+   for revision REV.  LAST_FILE may be NULL in which
+   case blame is added for every line of CUR_FILE. */
+static svn_error_t *
+add_file_blame(const char *last_file,
+               const char *cur_file,
+               struct blame_chain *chain,
+               struct rev *rev,
+               const svn_diff_file_options_t *diff_options,
+               svn_cancel_func_t cancel_func,
+               void *cancel_baton,
+               apr_pool_t *pool)
+{
+  svn_diff_t *diff = NULL;
+
+  /* If we have a previous file, get the diff and adjust blame info. */
+  if (last_file)
+    SVN_ERR(svn_diff_file_diff_2(&diff, last_file, cur_file,
+                                 diff_options, pool));
+
+  return svn_error_trace(add_diff_blame(diff, chain, rev,
+                                        cancel_func, cancel_baton));
+}
+
+
+/*** Concurrent diff computation.
+ *
+ * With many file revisions, diffing each pair of consecutive ones is what
+ * keeps blame busy while the server streams them to us.  Those diffs are
+ * independent of each other, so worker threads of a diff_queue_t compute
+ * them as soon as both fulltexts are on disk.  The caller's thread keeps
+ * receiving revisions and applies the finished diffs to the blame chain,
+ * strictly in order.
+ *
+ * Every revision's fulltext lives in the root pool of its diff_job_t, so
+ * the workers never share a pool with the caller's thread.  A fulltext is
+ * released once the diff against the next revision has been applied.
+ ***/
+
+/* The most threads that SVN_CONFIG_OPTION_BLAME_DIFF_THREADS may ask for. */
+#define DIFF_QUEUE_MAX_THREADS 32
+
+/* One diff to compute. */
+typedef struct diff_job_t
+{
+  /* Files to diff.  LAST_FILE is NULL for the first revision. */
+  const char *last_file;
+  const char *cur_file;
+
+  /* The revision to blame for the changes. */
+  const struct rev *rev;
+
+  /* The options to diff with. */
+  const svn_diff_file_options_t *diff_options;
+
+  /* The result, once the job has been taken from the queue. */
+  svn_diff_t *diff;
+
+  /* Root pool owned by this job, containing CUR_FILE.  It is only ever
+     used by one thread at a time. */
+  apr_pool_t *pool;
+} diff_job_t;
+
+struct diff_queue_t
+{
+  const svn_diff_file_options_t *diff_options;
+
+  /* Job whose file is currently being received.  Not queued yet. */
+  diff_job_t *receiving;
+
+  /* Last job applied to the blame chain.  Its file may still be needed. */
+  diff_job_t *applied;
+
+  /* Computes the diffs of all jobs that have not been applied yet, in
+     order of addition. */
+  svn_worker_pool__ordered_t *jobs;
+};
+
+#if APR_HAS_THREADS
+
+/* Implements svn_worker_pool__item_func_t.  ITEM is a diff_job_t. */
+static svn_error_t *
+diff_job(void *item,
+         void *thread_baton,
+         apr_pool_t *scratch_pool)
+{
+  diff_job_t *job = item;
+
+  if (job->last_file)
+    SVN_ERR(svn_diff_file_diff_2(&job->diff, job->last_file, job->cur_file,
+                                 job->diff_options, job->pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_worker_pool__release_func_t.  Release the diff_job_t in
+   ITEM and everything it owns. */
+static void
+diff_job_destroy(void *item)
+{
+  diff_job_t *job = item;
+
+  svn_pool_destroy(job->pool);
+}
+
+/* Pool cleanup function releasing the jobs of the diff_queue_t in DATA
+   that are not queued. */
+static apr_status_t
+release_diff_jobs(void *data)
+{
+  diff_queue_t *queue = data;
+
+  /* Runs after the queued jobs are gone. */
+  if (queue->receiving)
+    diff_job_destroy(queue->receiving);
+  if (queue->applied)
+    diff_job_destroy(queue->applied);
+
+  queue->receiving = NULL;
+  queue->applied = NULL;
+
+  return APR_SUCCESS;
+}
+
+/* Set *QUEUE to a new diff queue with THREADS workers that diff using
+   DIFF_OPTIONS, allocated in RESULT_POOL.  Set it to NULL if no worker
+   could be started. */
+static svn_error_t *
+diff_queue_create(diff_queue_t **queue,
+                  int threads,
+                  const svn_diff_file_options_t *diff_options,
+                  apr_pool_t *result_pool)
+{
+  diff_queue_t *result = apr_pcalloc(result_pool, sizeof(*result));
+
+  result->diff_options = diff_options;
+
+  apr_pool_cleanup_register(result_pool, result, release_diff_jobs,
+                            apr_pool_cleanup_null);
+  threads = MIN(threads, DIFF_QUEUE_MAX_THREADS);
+  SVN_ERR(svn_worker_pool__ordered_create(&result->jobs, threads,
+                                          2 * threads, NULL, diff_job,
+                                          diff_job_destroy, NULL,
+                                          result_pool));
+
+  *queue = result->jobs ? result : NULL;
+  return SVN_NO_ERROR;
+}
+
+/* Return the pool to put the fulltext of the next revision into,
+   replacing any job of QUEUE that has been left incomplete. */
+static apr_pool_t *
+diff_queue_file_pool(diff_queue_t *queue)
+{
+  apr_pool_t *pool;
+
+  if (queue->receiving)
+    diff_job_destroy(queue->receiving);
+
+  pool = apr_allocator_owner_get(svn_pool_create_allocator(FALSE));
+  queue->receiving = apr_pcalloc(pool, sizeof(*queue->receiving));
+  queue->receiving->pool = pool;
+
+  return pool;
+}
+
+/* Apply the diffs in QUEUE to CHAIN, in order, as long as they are
+   completed already or QUEUE can't hold them anymore.  If WAIT is set,
+   apply all of them. */
+static svn_error_t *
+diff_queue_apply(diff_queue_t *queue,
+                 svn_boolean_t wait,
+                 struct blame_chain *chain,
+                 svn_cancel_func_t cancel_func,
+                 void *cancel_baton)
+{
+  while (TRUE)
+    {
+      void *item;
+      diff_job_t *job;
+      svn_error_t *err;
+
+      SVN_ERR(svn_worker_pool__ordered_take(&item, &err, queue->jobs, wait));
+      if (!item)
+        return SVN_NO_ERROR;
+
+      /* The job's file is needed until the next diff has been applied. */
+      job = item;
+      if (queue->applied)
+        diff_job_destroy(queue->applied);
+      queue->applied = job;
+
+      SVN_ERR(err);
+      SVN_ERR(add_diff_blame(job->diff, chain, job->rev,
+                             cancel_func, cancel_baton));
+    }
+}
+
+/* Queue the diff from LAST_FILE to CUR_FILE, which has been received into
+   the pool returned by the latest diff_queue_file_pool() call on QUEUE,
+   blaming REV for the changes.  Apply all diffs that are completed
+   already to CHAIN, as well as those that QUEUE can't hold anymore. */
+static svn_error_t *
+diff_queue_add(diff_queue_t *queue,
+               const char *last_file,
+               const char *cur_file,
+               const struct rev *rev,
+               struct blame_chain *chain,
+               svn_cancel_func_t cancel_func,
+               void *cancel_baton)
+{
+  diff_job_t *job = queue->receiving;
+
+  SVN_ERR_ASSERT(job);
+  queue->receiving = NULL;
+
+  job->last_file = last_file;
+  job->cur_file = cur_file;
+  job->rev = rev;
+  job->diff_options = queue->diff_options;
+
+  SVN_ERR(svn_worker_pool__ordered_add(queue->jobs, job));
+
+  return svn_error_trace(diff_queue_apply(queue, FALSE, chain, cancel_func,
+                                          cancel_baton));
+}
+
+/* Apply all diffs in QUEUE to CHAIN, in order. */
+static svn_error_t *
+diff_queue_finish(diff_queue_t *queue,
+                  struct blame_chain *chain,
+                  svn_cancel_func_t cancel_func,
+                  void *cancel_baton)
+{
+  return svn_error_trace(diff_queue_apply(queue, TRUE, chain, cancel_func,
+                                          cancel_baton));
+}
+
+#endif /* APR_HAS_THREADS */
+
 /* Record the blame information for the revision in BATON->file_rev_baton.
  */
 static svn_error_t *
@@ -342,11 +584,18 @@ update_blame(void *baton)
     chain = frb->chain;
 
   /* Process this file. */
-  SVN_ERR(add_file_blame(frb->last_filename,
-                         dbaton->filename, chain, dbaton->rev,
-                         frb->diff_options,
-                         frb->ctx->cancel_func, frb->ctx->cancel_baton,
-                         frb->currpool));
+#if APR_HAS_THREADS
+  if (frb->diff_queue)
+    SVN_ERR(diff_queue_add(frb->diff_queue, frb->last_filename,
+                           dbaton->filename, dbaton->rev, chain,
+                           frb->ctx->cancel_func, frb->ctx->cancel_baton));
+  else
+#endif
+    SVN_ERR(add_file_blame(frb->last_filename,
+                           dbaton->filename, chain, dbaton->rev,
+                           frb->diff_options,
+                           frb->ctx->cancel_func, frb->ctx->cancel_baton,
+                           frb->currpool));
 
   /* If we are including merged revisions, and the current revision is not a
      merged one, we need to add its blame info to the chain for the original
@@ -505,6 +754,10 @@ file_rev_handler(void *baton, const char *path, svn_revnum_t revnum,
 
   if (frb->include_merged_revisions && !merged_revision)
     filepool = frb->filepool;
+#if APR_HAS_THREADS
+  else if (frb->diff_queue)
+    filepool = diff_queue_file_pool(frb->diff_queue);
+#endif
   else
     filepool = frb->currpool;
 
@@ -655,6 +908,106 @@ normalize_blames(struct blame_chain *chain,
     }
 }
 
+/* Try to let the server behind RA_SESSION annotate all lines of its
+   session URL in END_REVNUM and send them to RECEIVER / RECEIVER_BATON.
+   Set *HANDLED to FALSE, if the server does not support this, and to
+   TRUE otherwise.  START_REVNUM is only passed through to RECEIVER.
+   Use POOL for allocations. */
+static svn_error_t *
+blame_from_server(svn_boolean_t *handled,
+                  svn_ra_session_t *ra_session,
+                  svn_revnum_t start_revnum,
+                  svn_revnum_t end_revnum,
+                  svn_client_blame_receiver3_t receiver,
+                  void *receiver_baton,
+                  svn_client_ctx_t *ctx,
+                  apr_pool_t *pool)
+{
+  apr_array_header_t *revisions;
+  apr_hash_t *rev_props_cache = apr_hash_make(pool);
+  svn_stream_t *tempfile;
+  svn_stream_t *stream;
+  const char *temppath;
+  apr_pool_t *iterpool;
+  apr_int64_t line_no;
+  svn_error_t *err;
+
+  err = svn_ra__get_blame(&revisions, ra_session, "", end_revnum,
+                          pool, pool);
+  if (err && err->apr_err == SVN_ERR_RA_NOT_IMPLEMENTED)
+    {
+      svn_error_clear(err);
+      *handled = FALSE;
+      return SVN_NO_ERROR;
+    }
+  SVN_ERR(err);
+
+  /* Fetch the text that the annotation refers to. */
+  SVN_ERR(svn_stream_open_unique(&tempfile, &temppath, NULL,
+                                 svn_io_file_del_on_pool_cleanup,
+                                 pool, pool));
+  SVN_ERR(svn_ra_get_file(ra_session, "", end_revnum, tempfile, NULL, NULL,
+                          pool));
+  SVN_ERR(svn_stream_close(tempfile));
+
+  SVN_ERR(svn_stream_open_readonly(&stream, temppath, pool, pool));
+  stream = svn_subst_stream_translated(stream, "\n", TRUE, NULL, FALSE,
+                                       pool);
+
+  iterpool = svn_pool_create(pool);
+  for (line_no = 0; ; ++line_no)
+    {
+      svn_boolean_t eof;
+      svn_stringbuf_t *sb;
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_stream_readline(stream, &sb, "\n", &eof, iterpool));
+      if (ctx->cancel_func)
+        SVN_ERR(ctx->cancel_func(ctx->cancel_baton));
+      if (eof && !sb->len)
+        break;
+
+      if (line_no < revisions->nelts)
+        {
+          svn_revnum_t revision = APR_ARRAY_IDX(revisions, line_no,
+                                                svn_revnum_t);
+          apr_hash_t *rev_props = apr_hash_get(rev_props_cache, &revision,
+                                               sizeof(revision));
+
+          if (!rev_props)
+            {
+              svn_revnum_t *key = apr_pmemdup(pool, &revision,
+                                              sizeof(revision));
+
+              SVN_ERR(svn_ra_rev_proplist(ra_session, revision, &rev_props,
+                                          pool));
+              apr_hash_set(rev_props_cache, key, sizeof(*key), rev_props);
+            }
+
+          SVN_ERR(receiver(receiver_baton, start_revnum, end_revnum,
+                           line_no, revision, rev_props,
+                           SVN_INVALID_REVNUM, NULL, NULL,
+                           sb->data, FALSE, iterpool));
+        }
+      else
+        {
+          SVN_ERR(receiver(receiver_baton, start_revnum, end_revnum,
+                           line_no, SVN_INVALID_REVNUM, NULL,
+                           SVN_INVALID_REVNUM, NULL, NULL,
+                           sb->data, TRUE, iterpool));
+        }
+
+      if (eof)
+        break;
+    }
+  svn_pool_destroy(iterpool);
+
+  SVN_ERR(svn_stream_close(stream));
+
+  *handled = TRUE;
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *
 svn_client_blame5(const char *target,
                   const svn_opt_revision_t *peg_revision,
@@ -767,6 +1120,24 @@ svn_client_blame5(const char *target,
         }
     }
 
+  /* Servers that keep their own annotations can do all the work for
+     a plain blame of the full history. */
+  if (!include_merged_revisions
+      && start_revnum <= 1 && start_revnum <= end_revnum
+      && end->kind != svn_opt_revision_working
+      && (!diff_options
+          || (diff_options->ignore_space == svn_diff_file_ignore_space_none
+              && !diff_options->ignore_eol_style)))
+    {
+      svn_boolean_t handled;
+
+      SVN_ERR(blame_from_server(&handled, ra_session, start_revnum,
+                                end_revnum, receiver, receiver_baton,
+                                ctx, pool));
+      if (handled)
+        return SVN_NO_ERROR;
+    }
+
   frb.start_rev = start_revnum;
   frb.end_rev = end_revnum;
   frb.target = target;
@@ -791,6 +1162,29 @@ svn_client_blame5(const char *target,
   frb.last_revnum = SVN_INVALID_REVNUM;
   frb.last_props = NULL;
   frb.check_mime_type = (frb.backwards && !ignore_mime_type);
+  frb.diff_queue = NULL;
+
+#if APR_HAS_THREADS
+  /* Merged revisions need two chains diffed against different files,
+     so only plain blames compute their diffs concurrently. */
+  if (!include_merged_revisions)
+    {
+      svn_config_t *cfg;
+      apr_int64_t diff_threads;
+
+      cfg = ctx->config ? svn_hash_gets(ctx->config,
+                                        SVN_CONFIG_CATEGORY_CONFIG)
+                        : NULL;
+      SVN_ERR(svn_config_get_int64(cfg, &diff_threads,
+                                   SVN_CONFIG_SECTION_MISCELLANY,
+                                   SVN_CONFIG_OPTION_BLAME_DIFF_THREADS, 1));
+      if (diff_threads > 1)
+        SVN_ERR(diff_queue_create(&frb.diff_queue,
+                                  (int)MIN(diff_threads,
+                                           DIFF_QUEUE_MAX_THREADS),
+                                  diff_options, pool));
+    }
+#endif
 
   SVN_ERR(svn_ra_get_repos_root2(ra_session, &frb.repos_root_url, pool));
 
@@ -817,6 +1211,12 @@ svn_client_blame5(const char *target,
                                 include_merged_revisions,
                                 file_rev_handler, &frb, pool));
 
+#if APR_HAS_THREADS
+  if (frb.diff_queue)
+    SVN_ERR(diff_queue_finish(frb.diff_queue, frb.chain,
+                              ctx->cancel_func, ctx->cancel_baton));
+#endif
+
   if (end->kind == svn_opt_revision_working)
     {
       /* If the local file is modified we have to call the handler on the
@@ -63,6 +63,18 @@ typedef struct svn_client__private_ctx_t
   /* Total number of bytes transferred over network across all RA sessions. */
   apr_off_t total_progress;
 
+  /* The pool that this context has been allocated in. */
+  apr_pool_t *pool;
+
+  /* Idle RA sessions that svn_client__ra_session_acquire() may hand out
+     again.  Created on first use, allocated in POOL.  The element type is
+     private to ra.c. */
+  apr_array_header_t *idle_ra_sessions;
+
+  /* Set once POOL is being destroyed.  Sessions released after that point
+     will not be kept for reuse. */
+  svn_boolean_t ra_sessions_closed;
+
   /* The public context. */
   svn_client_ctx_t public_ctx;
 } svn_client__private_ctx_t;
@@ -316,6 +328,54 @@ svn_client__open_ra_session_internal(svn_ra_session_t **ra_session,
                                      apr_pool_t *result_pool,
                                      apr_pool_t *scratch_pool);
 
+/* The maximum number of idle RA sessions that a client context keeps
+   around for reuse by svn_client__ra_session_acquire(). */
+#define SVN_CLIENT__MAX_IDLE_RA_SESSIONS 4
+
+/* Set *RA_SESSION to an RA session parented at URL, taken from the session
+   pool of CTX if it has an idle session to the same repository, or newly
+   opened with the callbacks of CTX otherwise.  Redirects will be followed
+   when opening a new session; use svn_ra_get_session_url() to find out the
+   actual session URL.
+
+   The session is owned by the caller until RESULT_POOL gets cleared, at
+   which point it is returned to the pool of CTX.  Sessions are opened
+   without working copy context, i.e. like svn_client_open_ra_session2()
+   with a NULL WRI_ABSPATH, so they must not be used to drive editors that
+   depend on working copy properties.  RESULT_POOL must not outlive CTX.
+
+   Use SCRATCH_POOL for temporary allocations. */
+svn_error_t *
+svn_client__ra_session_acquire(svn_ra_session_t **ra_session,
+                               const char *url,
+                               svn_client_ctx_t *ctx,
+                               apr_pool_t *result_pool,
+                               apr_pool_t *scratch_pool);
+
+/* Like svn_client__ra_session_from_path2() with a NULL BASE_DIR_ABSPATH
+   but take the session from the session pool of CTX, see
+   svn_client__ra_session_acquire().  The session will not be able to
+   fetch pristine contents from the working copy, so this is meant for
+   queries such as mergeinfo and log lookups.  The session returns to the
+   pool when POOL gets cleared. */
+svn_error_t *
+svn_client__pooled_ra_session_from_path(svn_ra_session_t **ra_session_p,
+                                        svn_client__pathrev_t **resolved_loc_p,
+                                        const char *path_or_url,
+                                        const svn_opt_revision_t *peg_revision,
+                                        const svn_opt_revision_t *revision,
+                                        svn_client_ctx_t *ctx,
+                                        apr_pool_t *pool);
+
+
+/* Make the working copy context of CTX fetch pristine texts that are not
+   stored locally from the repository, using RA sessions opened with the
+   authentication and callbacks of CTX.  Allocate state in POOL, which
+   must live as long as CTX. */
+void
+svn_client__set_pristine_fetch(svn_client_ctx_t *ctx,
+                               apr_pool_t *pool);
+
 
 svn_error_t *
 svn_client__ra_provide_base(svn_stream_t **contents,
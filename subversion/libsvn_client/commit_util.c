@@ -38,6 +38,8 @@
 #include "svn_props.h"
 #include "svn_iter.h"
 #include "svn_hash.h"
+#include "svn_config.h"
+#include "svn_sorts.h"
 
 #include <assert.h>
 
@@ -437,17 +439,17 @@ harvest_committables(const char *local_abspath,
 
   baton.skip_below_abspath = NULL;
 
-  SVN_ERR(svn_wc_walk_status(wc_ctx,
-                             local_abspath,
-                             depth,
-                             (copy_mode_relpath != NULL) /* get_all */,
-                             FALSE /* no_ignore */,
-                             FALSE /* ignore_text_mods */,
-                             NULL /* ignore_patterns */,
-                             harvest_status_callback,
-                             &baton,
-                             cancel_func, cancel_baton,
-                             scratch_pool));
+  /* Unversioned nodes are never committable, so don't have the walker
+     determine which of them are ignored. */
+  SVN_ERR(svn_wc__walk_versioned_status(wc_ctx,
+                                        local_abspath,
+                                        depth,
+                                        (copy_mode_relpath != NULL)
+                                          /* get_all */,
+                                        harvest_status_callback,
+                                        &baton,
+                                        cancel_func, cancel_baton,
+                                        scratch_pool));
 
   return SVN_NO_ERROR;
 }
@@ -1211,6 +1213,7 @@ svn_client__harvest_committables(svn_client__committables_t **committables,
   for (i = 0; i < targets->nelts; ++i)
     {
       const char *target_abspath;
+      svn_error_t *err;
 
       svn_pool_clear(iterpool);
 
@@ -1231,15 +1234,20 @@ svn_client__harvest_committables(svn_client__committables_t **committables,
       if (i == depth_empty_start)
         depth = svn_depth_empty;
 
-      SVN_ERR(harvest_committables(target_abspath,
-                                   *committables, *lock_tokens,
-                                   NULL /* COPY_MODE_RELPATH */,
-                                   depth, just_locked, changelist_hash,
-                                   danglers,
-                                   check_url_func, check_url_baton,
-                                   ctx->cancel_func, ctx->cancel_baton,
-                                   ctx->notify_func2, ctx->notify_baton2,
-                                   ctx->wc_ctx, result_pool, iterpool));
+      /* Harvesting only reads the working copy. */
+      SVN_ERR(svn_wc__begin_read_snapshot(ctx->wc_ctx, target_abspath,
+                                          iterpool));
+      err = harvest_committables(target_abspath,
+                                 *committables, *lock_tokens,
+                                 NULL /* COPY_MODE_RELPATH */,
+                                 depth, just_locked, changelist_hash,
+                                 danglers,
+                                 check_url_func, check_url_baton,
+                                 ctx->cancel_func, ctx->cancel_baton,
+                                 ctx->notify_func2, ctx->notify_baton2,
+                                 ctx->wc_ctx, result_pool, iterpool);
+      SVN_ERR(svn_wc__end_read_snapshot(ctx->wc_ctx, target_abspath, err,
+                                        iterpool));
     }
 
   hdb.wc_ctx = ctx->wc_ctx;
@@ -1853,6 +1861,12 @@ svn_client__do_commit(const char *base_url,
   struct item_commit_baton cb_baton;
   apr_array_header_t *paths =
     apr_array_make(scratch_pool, commit_items->nelts, sizeof(const char *));
+  apr_array_header_t *mods;
+  svn_wc__text_delta_queue_t *delta_queue;
+  svn_config_t *cfg;
+  apr_int64_t delta_threads;
+  int lookahead;
+  int queued;
 
   /* Ditto for the checksums. */
   if (sha1_checksums)
@@ -1883,20 +1897,51 @@ svn_client__do_commit(const char *base_url,
   SVN_ERR(svn_delta_path_driver2(editor, edit_baton, paths, TRUE,
                                  do_item_commit, &cb_baton, scratch_pool));
 
-  /* Transmit outstanding text deltas. */
+  /* Transmit outstanding text deltas.  Their computation may run ahead
+     of the transmission in up to DELTA_THREADS threads. */
+  cfg = ctx->config ? svn_hash_gets(ctx->config, SVN_CONFIG_CATEGORY_CONFIG)
+                    : NULL;
+  SVN_ERR(svn_config_get_int64(cfg, &delta_threads,
+                               SVN_CONFIG_SECTION_MISCELLANY,
+                               SVN_CONFIG_OPTION_COMMIT_DELTA_THREADS, 1));
+  delta_threads = MAX(1, MIN(delta_threads, 64));
+  lookahead = delta_threads > 1 ? 2 * (int)delta_threads : 0;
+
+  SVN_ERR(svn_wc__text_delta_queue_create(&delta_queue, ctx->wc_ctx,
+                                          (int)delta_threads, scratch_pool));
+
+  mods = apr_array_make(scratch_pool, apr_hash_count(file_mods),
+                        sizeof(struct file_mod_t *));
   for (hi = apr_hash_first(scratch_pool, file_mods);
        hi;
        hi = apr_hash_next(hi))
+    APR_ARRAY_PUSH(mods, struct file_mod_t *) = apr_hash_this_val(hi);
+
+  for (i = 0, queued = 0; i < mods->nelts; i++)
     {
-      struct file_mod_t *mod = apr_hash_this_val(hi);
+      struct file_mod_t *mod = APR_ARRAY_IDX(mods, i, struct file_mod_t *);
       const svn_client_commit_item3_t *item = mod->item;
       const svn_checksum_t *new_text_base_md5_checksum;
       const svn_checksum_t *new_text_base_sha1_checksum;
-      svn_boolean_t fulltext = FALSE;
       svn_error_t *err;
 
       svn_pool_clear(iterpool);
 
+      /* Keep the delta computation LOOKAHEAD files ahead of us. */
+      for (; queued < mods->nelts && queued <= i + lookahead; queued++)
+        {
+          const svn_client_commit_item3_t *next_item
+            = APR_ARRAY_IDX(mods, queued, struct file_mod_t *)->item;
+
+          /* If the node has no history, transmit full text */
+          svn_boolean_t fulltext
+            = ((next_item->state_flags & SVN_CLIENT_COMMIT_ITEM_ADD)
+               && ! (next_item->state_flags & SVN_CLIENT_COMMIT_ITEM_IS_COPY));
+
+          SVN_ERR(svn_wc__text_delta_queue_add(delta_queue, next_item->path,
+                                               fulltext, iterpool));
+        }
+
       /* Transmit the entry. */
       if (ctx->cancel_func)
         SVN_ERR(ctx->cancel_func(ctx->cancel_baton));
@@ -1912,16 +1957,11 @@ svn_client__do_commit(const char *base_url,
           ctx->notify_func2(ctx->notify_baton2, notify, iterpool);
         }
 
-      /* If the node has no history, transmit full text */
-      if ((item->state_flags & SVN_CLIENT_COMMIT_ITEM_ADD)
-          && ! (item->state_flags & SVN_CLIENT_COMMIT_ITEM_IS_COPY))
-        fulltext = TRUE;
-
-      err = svn_wc_transmit_text_deltas3(&new_text_base_md5_checksum,
-                                         &new_text_base_sha1_checksum,
-                                         ctx->wc_ctx, item->path,
-                                         fulltext, editor, mod->file_baton,
-                                         result_pool, iterpool);
+      err = svn_wc__text_delta_queue_transmit(&new_text_base_md5_checksum,
+                                              &new_text_base_sha1_checksum,
+                                              delta_queue, item->path,
+                                              editor, mod->file_baton,
+                                              result_pool, iterpool);
 
       if (err)
         {
@@ -106,6 +106,7 @@ svn_client_create_context2(svn_client_ctx_t **ctx,
 
   private_ctx->magic_null = 0;
   private_ctx->magic_id = CLIENT_CTX_MAGIC;
+  private_ctx->pool = pool;
 
   public_ctx->notify_func2 = call_notify_func;
   public_ctx->notify_baton2 = public_ctx;
@@ -122,6 +123,7 @@ svn_client_create_context2(svn_client_ctx_t **ctx,
 
   SVN_ERR(svn_wc_context_create(&public_ctx->wc_ctx, cfg_config,
                                 pool, pool));
+  svn_client__set_pristine_fetch(public_ctx, pool);
   *ctx = public_ctx;
 
   return SVN_NO_ERROR;
@@ -1413,6 +1413,29 @@ svn_client_export(svn_revnum_t *result_rev,
 
 /*** From list.c ***/
 
+svn_error_t *
+svn_client_list4(const char *path_or_url,
+                 const svn_opt_revision_t *peg_revision,
+                 const svn_opt_revision_t *revision,
+                 const apr_array_header_t *patterns,
+                 svn_depth_t depth,
+                 apr_uint32_t dirent_fields,
+                 svn_boolean_t fetch_locks,
+                 svn_boolean_t include_externals,
+                 svn_client_list_func2_t list_func,
+                 void *baton,
+                 svn_client_ctx_t *ctx,
+                 apr_pool_t *scratch_pool)
+{
+  return svn_error_trace(svn_client_list5(path_or_url, peg_revision,
+                                          revision, patterns, depth,
+                                          SVN_INVALID_REVNUM,
+                                          dirent_fields, fetch_locks,
+                                          include_externals,
+                                          list_func, baton, ctx,
+                                          scratch_pool));
+}
+
 svn_error_t *
 svn_client_list3(const char *path_or_url,
                  const svn_opt_revision_t *peg_revision,
@@ -1426,8 +1449,9 @@ svn_client_list3(const char *path_or_url,
                  svn_client_ctx_t *ctx,
                  apr_pool_t *pool)
 {
-  return svn_error_trace(svn_client_list4(path_or_url, peg_revision,
+  return svn_error_trace(svn_client_list5(path_or_url, peg_revision,
                                           revision, NULL, depth,
+                                          SVN_INVALID_REVNUM,
                                           dirent_fields, fetch_locks,
                                           include_externals,
                                           list_func, baton, ctx, pool));
@@ -49,6 +49,7 @@
 #include "svn_config.h"
 #include "svn_props.h"
 #include "svn_subst.h"
+#include "svn_sorts.h"
 #include "client.h"
 
 #include "private/svn_wc_private.h"
@@ -56,6 +57,8 @@
 #include "private/svn_subr_private.h"
 #include "private/svn_io_private.h"
 #include "private/svn_ra_private.h"
+#include "private/svn_sorts_private.h"
+#include "private/svn_worker_pool.h"
 
 #include "svn_private_config.h"
 
@@ -91,6 +94,11 @@ typedef struct diff_driver_info_t
      (for example, when comparing a trunk against a branch). */
   const char *orig_path_1;
   const char *orig_path_2;
+
+  /* Set by drivers whose files stay unchanged until the end of the diff,
+     except for those in the temporary directory.  Lets the diff writer
+     compare them concurrently; see diff_file_queue_t. */
+  svn_boolean_t concurrent_files;
 } diff_driver_info_t;
 
 
@@ -710,6 +718,15 @@ typedef struct diff_writer_info_t
   void *cancel_baton;
 
   struct diff_driver_info_t ddi;
+
+  /* Number of threads to compare files in.  Only used if greater than 1
+     and DDI.CONCURRENT_FILES is set. */
+  int diff_threads;
+
+#if APR_HAS_THREADS
+  /* The queue of files being compared, created on demand. */
+  struct diff_file_queue_t *file_queue;
+#endif
 } diff_writer_info_t;
 
 /* An helper for diff_dir_props_changed, diff_file_changed and diff_file_added
@@ -1402,6 +1419,544 @@ diff_dir_deleted(const char *relpath,
   return SVN_NO_ERROR;
 }
 
+/*** Concurrent file comparison.
+ *
+ * Comparing the BASE and WORKING versions of many modified files keeps
+ * 'svn diff' busy in svn_diff_file_diff_2() or in the external diff
+ * command, one file after the other.  With more than one diff thread,
+ * the file callbacks therefore only record their arguments in a
+ * diff_file_job_t.  Worker threads of a diff_file_queue_t run the
+ * regular callbacks on them, writing into buffers, and the caller's
+ * thread copies the buffers to the output streams strictly in the order
+ * of the callbacks.  Directory callbacks and the end of the diff wait
+ * for all queued files.
+ *
+ * Every job lives in its own root pool together with copies of all
+ * arguments, so the workers never share a pool with the caller's thread.
+ * Drivers remove files in the temporary directory, e.g. detranslated
+ * working files, as soon as the callback returns; those get linked or
+ * copied into the job's pool.
+ *
+ * Git-style diffs look up repository paths in the working copy while
+ * writing their headers, which is not thread-safe, so they never use a
+ * queue.
+ ***/
+
+#if APR_HAS_THREADS
+
+/* The most threads that SVN_CONFIG_OPTION_DIFF_THREADS may ask for. */
+#define DIFF_FILE_QUEUE_MAX_THREADS 32
+
+/* The diff writer callback to run for a diff_file_job_t. */
+typedef enum diff_file_job_kind_t
+{
+  diff_file_job_changed,
+  diff_file_job_added,
+  diff_file_job_deleted
+} diff_file_job_kind_t;
+
+/* One file to compare, with copies of the callback's arguments. */
+typedef struct diff_file_job_t
+{
+  diff_file_job_kind_t kind;
+
+  /* The callback's arguments.  For added files, LEFT_* is the copyfrom
+     side. */
+  const char *relpath;
+  svn_diff_source_t *left_source;
+  svn_diff_source_t *right_source;
+  const char *left_file;
+  const char *right_file;
+  apr_hash_t *left_props;
+  apr_hash_t *right_props;
+  svn_boolean_t file_modified;
+  apr_array_header_t *prop_changes;
+
+  /* Copy of the diff writer state, writing to OUT and ERR_OUT instead of
+     the output streams, and the processor passing it to the callback. */
+  diff_writer_info_t dwi;
+  svn_diff_tree_processor_t processor;
+  svn_stringbuf_t *out;
+  svn_stringbuf_t *err_out;
+
+  /* Root pool owned by this job, containing all of the above.  It is only
+     ever used by one thread at a time. */
+  apr_pool_t *pool;
+} diff_file_job_t;
+
+typedef struct diff_file_queue_t
+{
+  /* Files in this directory get copied into the jobs. */
+  const char *temp_dir;
+
+  /* Compares the files of all jobs whose output has not been written
+     yet, in callback order. */
+  svn_worker_pool__ordered_t *jobs;
+} diff_file_queue_t;
+
+/* Run the diff writer callback for JOB, using SCRATCH_POOL for temporary
+   allocations. */
+static svn_error_t *
+run_file_job(diff_file_job_t *job,
+             apr_pool_t *scratch_pool)
+{
+  switch (job->kind)
+    {
+      case diff_file_job_changed:
+        return svn_error_trace(diff_file_changed(job->relpath,
+                                                 job->left_source,
+                                                 job->right_source,
+                                                 job->left_file,
+                                                 job->right_file,
+                                                 job->left_props,
+                                                 job->right_props,
+                                                 job->file_modified,
+                                                 job->prop_changes,
+                                                 NULL, &job->processor,
+                                                 scratch_pool));
+      case diff_file_job_added:
+        return svn_error_trace(diff_file_added(job->relpath,
+                                               job->left_source,
+                                               job->right_source,
+                                               job->left_file,
+                                               job->right_file,
+                                               job->left_props,
+                                               job->right_props,
+                                               NULL, &job->processor,
+                                               scratch_pool));
+      default:
+        return svn_error_trace(diff_file_deleted(job->relpath,
+                                                 job->left_source,
+                                                 job->left_file,
+                                                 job->left_props,
+                                                 NULL, &job->processor,
+                                                 scratch_pool));
+    }
+}
+
+/* Implements svn_worker_pool__item_func_t.  ITEM is a diff_file_job_t. */
+static svn_error_t *
+diff_file_job(void *item,
+              void *thread_baton,
+              apr_pool_t *scratch_pool)
+{
+  return svn_error_trace(run_file_job(item, scratch_pool));
+}
+
+/* Implements svn_worker_pool__release_func_t.  Release the
+   diff_file_job_t in ITEM and everything it owns. */
+static void
+diff_file_job_destroy(void *item)
+{
+  diff_file_job_t *job = item;
+
+  svn_pool_destroy(job->pool);
+}
+
+/* Set *QUEUE to a new diff file queue with THREADS workers, allocated in
+   RESULT_POOL.  Set it to NULL if no worker could be started. */
+static svn_error_t *
+diff_file_queue_create(diff_file_queue_t **queue,
+                       int threads,
+                       apr_pool_t *result_pool)
+{
+  diff_file_queue_t *result = apr_pcalloc(result_pool, sizeof(*result));
+
+  SVN_ERR(svn_io_temp_dir(&result->temp_dir, result_pool));
+
+  threads = MIN(threads, DIFF_FILE_QUEUE_MAX_THREADS);
+  SVN_ERR(svn_worker_pool__ordered_create(&result->jobs, threads,
+                                          2 * threads, NULL, diff_file_job,
+                                          diff_file_job_destroy, NULL,
+                                          result_pool));
+
+  *queue = result->jobs ? result : NULL;
+  return SVN_NO_ERROR;
+}
+
+/* Write the output of JOB, which returned ERR, to the output streams of
+   DWI and release JOB. */
+static svn_error_t *
+diff_file_job_write(diff_file_job_t *job,
+                    svn_error_t *err,
+                    diff_writer_info_t *dwi)
+{
+  apr_size_t len;
+
+  len = job->out->len;
+  if (!err && len)
+    err = svn_stream_write(dwi->outstream, job->out->data, &len);
+
+  len = job->err_out->len;
+  if (!err && len)
+    err = svn_stream_write(dwi->errstream, job->err_out->data, &len);
+
+  diff_file_job_destroy(job);
+  SVN_ERR(err);
+
+  if (dwi->cancel_func)
+    SVN_ERR(dwi->cancel_func(dwi->cancel_baton));
+
+  return SVN_NO_ERROR;
+}
+
+/* Write the output of the jobs in QUEUE to the output streams of DWI, in
+   order, as long as they are completed already or QUEUE can't hold them
+   anymore.  If WAIT is set, write all of them. */
+static svn_error_t *
+diff_file_queue_write(diff_file_queue_t *queue,
+                      svn_boolean_t wait,
+                      diff_writer_info_t *dwi)
+{
+  while (TRUE)
+    {
+      void *job;
+      svn_error_t *err;
+
+      SVN_ERR(svn_worker_pool__ordered_take(&job, &err, queue->jobs, wait));
+      if (!job)
+        return SVN_NO_ERROR;
+
+      SVN_ERR(diff_file_job_write(job, err, dwi));
+    }
+}
+
+/* Queue JOB in QUEUE.  Write the output of all jobs that are completed
+   already to the output streams of DWI, as well as of those that QUEUE
+   can't hold anymore. */
+static svn_error_t *
+diff_file_queue_add(diff_file_queue_t *queue,
+                    diff_file_job_t *job,
+                    diff_writer_info_t *dwi)
+{
+  SVN_ERR(svn_worker_pool__ordered_add(queue->jobs, job));
+
+  return svn_error_trace(diff_file_queue_write(queue, FALSE, dwi));
+}
+
+/* Write the output of all jobs queued by DWI, in order. */
+static svn_error_t *
+diff_file_queue_finish(diff_writer_info_t *dwi)
+{
+  if (dwi->file_queue)
+    SVN_ERR(diff_file_queue_write(dwi->file_queue, TRUE, dwi));
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *QUEUE to the queue to compare the files of DWI in, creating it on
+   demand.  Set it to NULL if the files have to be compared right away;
+   in that case, all queued files have been written. */
+static svn_error_t *
+get_diff_file_queue(diff_file_queue_t **queue,
+                    diff_writer_info_t *dwi)
+{
+  if (!dwi->ddi.concurrent_files || dwi->diff_threads <= 1)
+    {
+      *queue = NULL;
+      return svn_error_trace(diff_file_queue_finish(dwi));
+    }
+
+  if (!dwi->file_queue)
+    {
+      /* All jobs share the empty file, so create it up-front.  Its
+         cleanup is registered first and will run after the queue's. */
+      if (!dwi->empty_file)
+        SVN_ERR(svn_io_open_unique_file3(NULL, &dwi->empty_file,
+                                         NULL, svn_io_file_del_on_pool_cleanup,
+                                         dwi->pool, dwi->pool));
+
+      SVN_ERR(diff_file_queue_create(&dwi->file_queue, dwi->diff_threads,
+                                     dwi->pool));
+
+      /* Don't try again if no worker could be started. */
+      if (!dwi->file_queue)
+        dwi->diff_threads = 1;
+    }
+
+  *queue = dwi->file_queue;
+  return SVN_NO_ERROR;
+}
+
+/* Return a new job of KIND for RELPATH, writing its output like DWI, in
+   its own root pool. */
+static diff_file_job_t *
+diff_file_job_create(diff_file_job_kind_t kind,
+                     const char *relpath,
+                     const diff_writer_info_t *dwi)
+{
+  apr_pool_t *pool
+    = apr_allocator_owner_get(svn_pool_create_allocator(FALSE));
+  diff_file_job_t *job = apr_pcalloc(pool, sizeof(*job));
+
+  job->kind = kind;
+  job->relpath = apr_pstrdup(pool, relpath);
+  job->pool = pool;
+  job->out = svn_stringbuf_create_empty(pool);
+  job->err_out = svn_stringbuf_create_empty(pool);
+
+  /* The options, paths and the empty file are shared read-only.  The
+     cancel callback is not known to be thread-safe. */
+  job->dwi = *dwi;
+  job->dwi.pool = pool;
+  job->dwi.outstream = svn_stream_from_stringbuf(job->out, pool);
+  job->dwi.errstream = svn_stream_from_stringbuf(job->err_out, pool);
+  job->dwi.cancel_func = NULL;
+  job->dwi.cancel_baton = NULL;
+  job->dwi.file_queue = NULL;
+  job->processor.baton = &job->dwi;
+
+  return job;
+}
+
+/* Return a copy of SOURCE, which may be NULL, allocated in RESULT_POOL. */
+static svn_diff_source_t *
+diff_source_dup(const svn_diff_source_t *source,
+                apr_pool_t *result_pool)
+{
+  svn_diff_source_t *result;
+
+  if (!source)
+    return NULL;
+
+  result = apr_pmemdup(result_pool, source, sizeof(*source));
+  result->repos_relpath = apr_pstrdup(result_pool, source->repos_relpath);
+  result->moved_from_relpath = apr_pstrdup(result_pool,
+                                           source->moved_from_relpath);
+
+  return result;
+}
+
+/* Set *JOB_FILE to FILE, which may be NULL, for use by JOB of QUEUE.
+   Files in the temporary directory are linked, or else copied, to a file
+   that lives as long as JOB; all other files stay where they are.  Use
+   SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+diff_file_job_keep_file(const char **job_file,
+                        const char *file,
+                        diff_file_job_t *job,
+                        diff_file_queue_t *queue,
+                        apr_pool_t *scratch_pool)
+{
+  svn_boolean_t linked;
+
+  if (!file
+      || (job->dwi.empty_file && !strcmp(file, job->dwi.empty_file))
+      || !svn_dirent_is_ancestor(queue->temp_dir, file))
+    {
+      *job_file = apr_pstrdup(job->pool, file);
+      return SVN_NO_ERROR;
+    }
+
+  /* Reserve a name that will be removed together with JOB. */
+  SVN_ERR(svn_io_open_unique_file3(NULL, job_file, queue->temp_dir,
+                                   svn_io_file_del_on_pool_cleanup,
+                                   job->pool, scratch_pool));
+  SVN_ERR(svn_io_remove_file2(*job_file, FALSE, scratch_pool));
+
+  SVN_ERR(svn_io__create_hardlink(&linked, file, *job_file, scratch_pool));
+  if (!linked)
+    SVN_ERR(svn_io_copy_file(file, *job_file, FALSE, scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Complete JOB of QUEUE with LEFT_FILE and RIGHT_FILE and queue it, on
+   behalf of DWI.  Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+queue_file_job(diff_file_job_t *job,
+               const char *left_file,
+               const char *right_file,
+               diff_file_queue_t *queue,
+               diff_writer_info_t *dwi,
+               apr_pool_t *scratch_pool)
+{
+  svn_error_t *err;
+
+  err = diff_file_job_keep_file(&job->left_file, left_file, job, queue,
+                                scratch_pool);
+  if (!err)
+    err = diff_file_job_keep_file(&job->right_file, right_file, job, queue,
+                                  scratch_pool);
+  if (err)
+    {
+      diff_file_job_destroy(job);
+      return svn_error_trace(err);
+    }
+
+  return svn_error_trace(diff_file_queue_add(queue, job, dwi));
+}
+
+/* An svn_diff_tree_processor_t callback queueing diff_file_changed(). */
+static svn_error_t *
+queue_file_changed(const char *relpath,
+                   const svn_diff_source_t *left_source,
+                   const svn_diff_source_t *right_source,
+                   const char *left_file,
+                   const char *right_file,
+                   /*const*/ apr_hash_t *left_props,
+                   /*const*/ apr_hash_t *right_props,
+                   svn_boolean_t file_modified,
+                   const apr_array_header_t *prop_changes,
+                   void *file_baton,
+                   const struct svn_diff_tree_processor_t *processor,
+                   apr_pool_t *scratch_pool)
+{
+  diff_writer_info_t *dwi = processor->baton;
+  diff_file_queue_t *queue;
+  diff_file_job_t *job;
+
+  SVN_ERR(get_diff_file_queue(&queue, dwi));
+  if (!queue)
+    return svn_error_trace(diff_file_changed(relpath,
+                                             left_source, right_source,
+                                             left_file, right_file,
+                                             left_props, right_props,
+                                             file_modified, prop_changes,
+                                             file_baton, processor,
+                                             scratch_pool));
+
+  job = diff_file_job_create(diff_file_job_changed, relpath, dwi);
+  job->left_source = diff_source_dup(left_source, job->pool);
+  job->right_source = diff_source_dup(right_source, job->pool);
+  job->left_props = svn_prop_hash_dup(left_props, job->pool);
+  job->right_props = svn_prop_hash_dup(right_props, job->pool);
+  job->file_modified = file_modified;
+  job->prop_changes = svn_prop_array_dup(prop_changes, job->pool);
+
+  return svn_error_trace(queue_file_job(job, left_file, right_file,
+                                        queue, dwi, scratch_pool));
+}
+
+/* An svn_diff_tree_processor_t callback queueing diff_file_added(). */
+static svn_error_t *
+queue_file_added(const char *relpath,
+                 const svn_diff_source_t *copyfrom_source,
+                 const svn_diff_source_t *right_source,
+                 const char *copyfrom_file,
+                 const char *right_file,
+                 /*const*/ apr_hash_t *copyfrom_props,
+                 /*const*/ apr_hash_t *right_props,
+                 void *file_baton,
+                 const struct svn_diff_tree_processor_t *processor,
+                 apr_pool_t *scratch_pool)
+{
+  diff_writer_info_t *dwi = processor->baton;
+  diff_file_queue_t *queue;
+  diff_file_job_t *job;
+
+  SVN_ERR(get_diff_file_queue(&queue, dwi));
+  if (!queue)
+    return svn_error_trace(diff_file_added(relpath,
+                                           copyfrom_source, right_source,
+                                           copyfrom_file, right_file,
+                                           copyfrom_props, right_props,
+                                           file_baton, processor,
+                                           scratch_pool));
+
+  job = diff_file_job_create(diff_file_job_added, relpath, dwi);
+  job->left_source = diff_source_dup(copyfrom_source, job->pool);
+  job->right_source = diff_source_dup(right_source, job->pool);
+  job->left_props = copyfrom_props
+                      ? svn_prop_hash_dup(copyfrom_props, job->pool)
+                      : NULL;
+  job->right_props = svn_prop_hash_dup(right_props, job->pool);
+
+  return svn_error_trace(queue_file_job(job, copyfrom_file, right_file,
+                                        queue, dwi, scratch_pool));
+}
+
+/* An svn_diff_tree_processor_t callback queueing diff_file_deleted(). */
+static svn_error_t *
+queue_file_deleted(const char *relpath,
+                   const svn_diff_source_t *left_source,
+                   const char *left_file,
+                   /*const*/ apr_hash_t *left_props,
+                   void *file_baton,
+                   const struct svn_diff_tree_processor_t *processor,
+                   apr_pool_t *scratch_pool)
+{
+  diff_writer_info_t *dwi = processor->baton;
+  diff_file_queue_t *queue;
+  diff_file_job_t *job;
+
+  SVN_ERR(get_diff_file_queue(&queue, dwi));
+  if (!queue)
+    return svn_error_trace(diff_file_deleted(relpath, left_source,
+                                             left_file, left_props,
+                                             file_baton, processor,
+                                             scratch_pool));
+
+  job = diff_file_job_create(diff_file_job_deleted, relpath, dwi);
+  job->left_source = diff_source_dup(left_source, job->pool);
+  job->left_props = left_props ? svn_prop_hash_dup(left_props, job->pool)
+                               : NULL;
+
+  return svn_error_trace(queue_file_job(job, left_file, NULL,
+                                        queue, dwi, scratch_pool));
+}
+
+/* An svn_diff_tree_processor_t callback writing all queued files before
+   calling diff_dir_changed(). */
+static svn_error_t *
+queue_dir_changed(const char *relpath,
+                  const svn_diff_source_t *left_source,
+                  const svn_diff_source_t *right_source,
+                  /*const*/ apr_hash_t *left_props,
+                  /*const*/ apr_hash_t *right_props,
+                  const apr_array_header_t *prop_changes,
+                  void *dir_baton,
+                  const struct svn_diff_tree_processor_t *processor,
+                  apr_pool_t *scratch_pool)
+{
+  SVN_ERR(diff_file_queue_finish(processor->baton));
+
+  return svn_error_trace(diff_dir_changed(relpath, left_source,
+                                          right_source, left_props,
+                                          right_props, prop_changes,
+                                          dir_baton, processor,
+                                          scratch_pool));
+}
+
+/* An svn_diff_tree_processor_t callback writing all queued files before
+   calling diff_dir_added(). */
+static svn_error_t *
+queue_dir_added(const char *relpath,
+                const svn_diff_source_t *copyfrom_source,
+                const svn_diff_source_t *right_source,
+                /*const*/ apr_hash_t *copyfrom_props,
+                /*const*/ apr_hash_t *right_props,
+                void *dir_baton,
+                const struct svn_diff_tree_processor_t *processor,
+                apr_pool_t *scratch_pool)
+{
+  SVN_ERR(diff_file_queue_finish(processor->baton));
+
+  return svn_error_trace(diff_dir_added(relpath, copyfrom_source,
+                                        right_source, copyfrom_props,
+                                        right_props, dir_baton, processor,
+                                        scratch_pool));
+}
+
+/* An svn_diff_tree_processor_t callback writing all queued files before
+   calling diff_dir_deleted(). */
+static svn_error_t *
+queue_dir_deleted(const char *relpath,
+                  const svn_diff_source_t *left_source,
+                  /*const*/ apr_hash_t *left_props,
+                  void *dir_baton,
+                  const struct svn_diff_tree_processor_t *processor,
+                  apr_pool_t *scratch_pool)
+{
+  SVN_ERR(diff_file_queue_finish(processor->baton));
+
+  return svn_error_trace(diff_dir_deleted(relpath, left_source, left_props,
+                                          dir_baton, processor,
+                                          scratch_pool));
+}
+
+#endif /* APR_HAS_THREADS */
+
 /*-----------------------------------------------------------------*/
 
 /** The logic behind 'svn diff' and 'svn merge'.  */
@@ -2522,6 +3077,12 @@ do_diff(diff_driver_info_t *ddi,
                                      depth, ignore_ancestry,
                                      diff_processor, ctx, scratch_pool));
               }
+
+              /* BASE and WORKING files stay where they are while we
+                 diff, so the diff writer may compare them later. */
+              if (ddi)
+                ddi->concurrent_files = TRUE;
+
               SVN_ERR(diff_wc_wc(path_or_url1, revision1,
                                  path_or_url2, revision2,
                                  depth, ignore_ancestry, changelists,
@@ -2649,6 +3210,24 @@ get_diff_processor(svn_diff_tree_processor_t **diff_processor,
   dwi->ddi.session_relpath = NULL;
   dwi->ddi.anchor = NULL;
 
+#if APR_HAS_THREADS
+  /* Git-style headers need the working copy, see diff_file_queue_t. */
+  if (!use_git_diff_format)
+    {
+      svn_config_t *cfg;
+      apr_int64_t diff_threads;
+
+      cfg = ctx->config ? svn_hash_gets(ctx->config,
+                                        SVN_CONFIG_CATEGORY_CONFIG)
+                        : NULL;
+      SVN_ERR(svn_config_get_int64(cfg, &diff_threads,
+                                   SVN_CONFIG_SECTION_MISCELLANY,
+                                   SVN_CONFIG_OPTION_DIFF_THREADS, 1));
+      dwi->diff_threads = (int)MIN(diff_threads,
+                                   DIFF_FILE_QUEUE_MAX_THREADS);
+    }
+#endif
+
   processor = svn_diff__tree_processor_create(dwi, pool);
 
   processor->dir_added = diff_dir_added;
@@ -2659,6 +3238,19 @@ get_diff_processor(svn_diff_tree_processor_t **diff_processor,
   processor->file_changed = diff_file_changed;
   processor->file_deleted = diff_file_deleted;
 
+#if APR_HAS_THREADS
+  if (dwi->diff_threads > 1)
+    {
+      processor->dir_added = queue_dir_added;
+      processor->dir_changed = queue_dir_changed;
+      processor->dir_deleted = queue_dir_deleted;
+
+      processor->file_added = queue_file_added;
+      processor->file_changed = queue_file_changed;
+      processor->file_deleted = queue_file_deleted;
+    }
+#endif
+
   *diff_processor = processor;
   *ddi = &dwi->ddi;
   return SVN_NO_ERROR;
@@ -2798,13 +3390,19 @@ svn_client_diff7(const apr_array_header_t *options,
                              outstream, errstream,
                              ctx, pool));
 
-  return svn_error_trace(do_diff(ddi,
-                                 path_or_url1, path_or_url2,
-                                 revision1, revision2,
-                                 &peg_revision, TRUE /* no_peg_revision */,
-                                 depth, ignore_ancestry, changelists,
-                                 TRUE /* text_deltas */,
-                                 diff_processor, ctx, pool, pool));
+  SVN_ERR(do_diff(ddi,
+                  path_or_url1, path_or_url2,
+                  revision1, revision2,
+                  &peg_revision, TRUE /* no_peg_revision */,
+                  depth, ignore_ancestry, changelists,
+                  TRUE /* text_deltas */,
+                  diff_processor, ctx, pool, pool));
+
+#if APR_HAS_THREADS
+  SVN_ERR(diff_file_queue_finish(diff_processor->baton));
+#endif
+
+  return SVN_NO_ERROR;
 }
 
 svn_error_t *
@@ -2858,13 +3456,126 @@ svn_client_diff_peg7(const apr_array_header_t *options,
                              outstream, errstream,
                              ctx, pool));
 
-  return svn_error_trace(do_diff(ddi,
-                                 path_or_url, path_or_url,
-                                 start_revision, end_revision,
-                                 peg_revision, FALSE /* no_peg_revision */,
-                                 depth, ignore_ancestry, changelists,
-                                 TRUE /* text_deltas */,
-                                 diff_processor, ctx, pool, pool));
+  SVN_ERR(do_diff(ddi,
+                  path_or_url, path_or_url,
+                  start_revision, end_revision,
+                  peg_revision, FALSE /* no_peg_revision */,
+                  depth, ignore_ancestry, changelists,
+                  TRUE /* text_deltas */,
+                  diff_processor, ctx, pool, pool));
+
+#if APR_HAS_THREADS
+  SVN_ERR(diff_file_queue_finish(diff_processor->baton));
+#endif
+
+  return SVN_NO_ERROR;
+}
+
+/* If PATH_OR_URL1@REVISION1 and PATH_OR_URL2@REVISION2, as resolved by
+   diff_prepare_repos_repos() using PEG_REVISION, are the same node in
+   the repository, try to summarize their differences down to DEPTH from
+   the changed-path lists of the revisions in between instead of
+   receiving a full tree delta.  Pass the results to SUMMARIZE_FUNC with
+   SUMMARIZE_BATON and set *DONE.
+
+   Set *DONE to FALSE if the caller has to use do_diff() instead, e.g.
+   because the server does not support this or the range contains copies.
+
+   Use client context CTX.  Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+summarize_from_changed_paths(svn_boolean_t *done,
+                             const char *path_or_url1,
+                             const char *path_or_url2,
+                             const svn_opt_revision_t *revision1,
+                             const svn_opt_revision_t *revision2,
+                             const svn_opt_revision_t *peg_revision,
+                             svn_depth_t depth,
+                             svn_client_diff_summarize_func_t summarize_func,
+                             void *summarize_baton,
+                             svn_client_ctx_t *ctx,
+                             apr_pool_t *scratch_pool)
+{
+  svn_boolean_t is_repos1, is_repos2;
+  const char *url1, *url2;
+  svn_revnum_t rev1, rev2;
+  const char *anchor1, *anchor2, *target1, *target2;
+  svn_node_kind_t kind1, kind2;
+  svn_ra_session_t *ra_session;
+  apr_hash_t *changes;
+  apr_array_header_t *sorted;
+  svn_boolean_t reverse;
+  apr_pool_t *iterpool;
+  svn_error_t *err;
+  int i;
+
+  *done = FALSE;
+
+  SVN_ERR(check_paths(&is_repos1, &is_repos2, path_or_url1, path_or_url2,
+                      revision1, revision2, peg_revision));
+  if (!is_repos1 || !is_repos2)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(diff_prepare_repos_repos(&url1, &url2, &rev1, &rev2,
+                                   &anchor1, &anchor2, &target1, &target2,
+                                   &kind1, &kind2, &ra_session,
+                                   ctx, path_or_url1, path_or_url2,
+                                   revision1, revision2, peg_revision,
+                                   scratch_pool));
+  if (strcmp(url1, url2) != 0 || kind1 != kind2 || kind1 == svn_node_none)
+    return SVN_NO_ERROR;
+
+  /* The server folds the changes in ascending revision order. */
+  reverse = (rev1 > rev2);
+  SVN_ERR(svn_ra_reparent(ra_session, url1, scratch_pool));
+  err = svn_ra__get_changes_summary(&changes, ra_session, "",
+                                    reverse ? rev2 : rev1,
+                                    reverse ? rev1 : rev2,
+                                    depth, scratch_pool, scratch_pool);
+  if (err && (err->apr_err == SVN_ERR_RA_NOT_IMPLEMENTED
+              || err->apr_err == SVN_ERR_UNSUPPORTED_FEATURE))
+    {
+      svn_error_clear(err);
+      return SVN_NO_ERROR;
+    }
+  SVN_ERR(err);
+
+  sorted = svn_sort__hash(changes, svn_sort_compare_items_as_paths,
+                          scratch_pool);
+  iterpool = svn_pool_create(scratch_pool);
+  for (i = 0; i < sorted->nelts; i++)
+    {
+      svn_sort__item_t *item = &APR_ARRAY_IDX(sorted, i, svn_sort__item_t);
+      const svn_log_changed_path2_t *change = item->value;
+      svn_client_diff_summarize_t *sum;
+
+      svn_pool_clear(iterpool);
+      if (ctx->cancel_func)
+        SVN_ERR(ctx->cancel_func(ctx->cancel_baton));
+
+      sum = apr_pcalloc(iterpool, sizeof(*sum));
+      sum->path = item->key;
+      sum->node_kind = change->node_kind;
+      if (change->action == 'A')
+        sum->summarize_kind = reverse ? svn_client_diff_summarize_kind_deleted
+                                      : svn_client_diff_summarize_kind_added;
+      else if (change->action == 'D')
+        sum->summarize_kind = reverse ? svn_client_diff_summarize_kind_added
+                                      : svn_client_diff_summarize_kind_deleted;
+      else
+        {
+          sum->summarize_kind
+            = (change->text_modified == svn_tristate_true)
+                ? svn_client_diff_summarize_kind_modified
+                : svn_client_diff_summarize_kind_normal;
+          sum->prop_changed = (change->props_modified == svn_tristate_true);
+        }
+
+      SVN_ERR(summarize_func(sum, summarize_baton, iterpool));
+    }
+  svn_pool_destroy(iterpool);
+
+  *done = TRUE;
+  return SVN_NO_ERROR;
 }
 
 svn_error_t *
@@ -2883,9 +3594,18 @@ svn_client_diff_summarize2(const char *path_or_url1,
   svn_diff_tree_processor_t *diff_processor;
   svn_opt_revision_t peg_revision;
 
+  svn_boolean_t done;
+
   /* We will never do a pegged diff from here. */
   peg_revision.kind = svn_opt_revision_unspecified;
 
+  SVN_ERR(summarize_from_changed_paths(&done, path_or_url1, path_or_url2,
+                                       revision1, revision2, &peg_revision,
+                                       depth, summarize_func,
+                                       summarize_baton, ctx, pool));
+  if (done)
+    return SVN_NO_ERROR;
+
   SVN_ERR(svn_client__get_diff_summarize_callbacks(&diff_processor,
                      summarize_func, summarize_baton,
                      pool, pool));
@@ -2913,6 +3633,14 @@ svn_client_diff_summarize_peg2(const char *path_or_url,
                                apr_pool_t *pool)
 {
   svn_diff_tree_processor_t *diff_processor;
+  svn_boolean_t done;
+
+  SVN_ERR(summarize_from_changed_paths(&done, path_or_url, path_or_url,
+                                       start_revision, end_revision,
+                                       peg_revision, depth, summarize_func,
+                                       summarize_baton, ctx, pool));
+  if (done)
+    return SVN_NO_ERROR;
 
   SVN_ERR(svn_client__get_diff_summarize_callbacks(&diff_processor,
                      summarize_func, summarize_baton,
@@ -31,6 +31,7 @@
 #include <apr_md5.h>
 #include "svn_types.h"
 #include "svn_client.h"
+#include "svn_config.h"
 #include "svn_string.h"
 #include "svn_error.h"
 #include "svn_dirent_uri.h"
@@ -40,12 +41,16 @@
 #include "svn_subst.h"
 #include "svn_time.h"
 #include "svn_props.h"
+#include "svn_sorts.h"
 #include "client.h"
 
 #include "svn_private_config.h"
 #include "private/svn_subr_private.h"
 #include "private/svn_delta_private.h"
+#include "private/svn_sorts_private.h"
+#include "private/svn_tar.h"
 #include "private/svn_wc_private.h"
+#include "private/svn_worker_pool.h"
 
 #ifndef ENABLE_EV2_IMPL
 #define ENABLE_EV2_IMPL 0
@@ -493,6 +498,229 @@ open_root_internal(const char *path,
 /* ---------------------------------------------------------------------- */
 
 
+/*** Concurrent file writing.
+ *
+ * Exporting a large tree is mostly bound by the latency of creating the
+ * files on disk.  Once a file's text has been received into its temporary
+ * file, worker threads of a file_writer_t translate it, move it into place
+ * and set its timestamp while the editor keeps receiving the next files.
+ * The editor's thread sends the notifications, strictly in the order the
+ * files were closed.
+ *
+ * Every write_job_t lives in its own root pool, so the workers never share
+ * a pool with the editor's thread.
+ ***/
+
+/* The most threads that SVN_CONFIG_OPTION_EXPORT_THREADS may ask for. */
+#define FILE_WRITER_MAX_THREADS 32
+
+/* Everything needed to put one exported file into place. */
+typedef struct write_job_t
+{
+  /* The received, untranslated text and its final location. */
+  const char *tmppath;
+  const char *path;
+
+  /* Translation to apply.  If EOL, KEYWORDS and SPECIAL are all unset,
+     TMPPATH simply gets renamed. */
+  const char *eol;
+  svn_boolean_t repair;
+  apr_hash_t *keywords;
+  svn_boolean_t special;
+
+  svn_boolean_t executable;
+
+  /* Timestamp to set on PATH, or 0. */
+  apr_time_t date;
+
+  /* Root pool owned by this job when it is queued.  It is only ever used
+     by one thread at a time. */
+  apr_pool_t *pool;
+} write_job_t;
+
+typedef struct file_writer_t file_writer_t;
+
+/* Put the file described by JOB into place.  Use SCRATCH_POOL for
+   temporary allocations. */
+static svn_error_t *
+write_job_run(const write_job_t *job,
+              svn_cancel_func_t cancel_func,
+              void *cancel_baton,
+              apr_pool_t *scratch_pool)
+{
+  if (!job->eol && !job->keywords && !job->special)
+    {
+      SVN_ERR(svn_io_file_rename2(job->tmppath, job->path, FALSE,
+                                  scratch_pool));
+    }
+  else
+    {
+      SVN_ERR(svn_subst_copy_and_translate4(job->tmppath, job->path,
+                                            job->eol, job->repair,
+                                            job->keywords,
+                                            TRUE, /* expand */
+                                            job->special,
+                                            cancel_func, cancel_baton,
+                                            scratch_pool));
+
+      SVN_ERR(svn_io_remove_file2(job->tmppath, FALSE, scratch_pool));
+    }
+
+  if (job->executable)
+    SVN_ERR(svn_io_set_file_executable(job->path, TRUE, FALSE,
+                                       scratch_pool));
+
+  if (job->date && (! job->special))
+    SVN_ERR(svn_io_set_file_affected_time(job->date, job->path,
+                                          scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Send the notification for the file of JOB having been exported. */
+static void
+notify_file_added(const write_job_t *job,
+                  svn_wc_notify_func2_t notify_func,
+                  void *notify_baton,
+                  apr_pool_t *scratch_pool)
+{
+  if (notify_func)
+    {
+      svn_wc_notify_t *notify = svn_wc_create_notify(job->path,
+                                                     svn_wc_notify_update_add,
+                                                     scratch_pool);
+      notify->kind = svn_node_file;
+      (*notify_func)(notify_baton, notify, scratch_pool);
+    }
+}
+
+#if APR_HAS_THREADS
+
+struct file_writer_t
+{
+  /* Puts the files of all jobs that have not been reaped yet into place,
+     in order of addition. */
+  svn_worker_pool__ordered_t *jobs;
+};
+
+/* Implements svn_worker_pool__item_func_t.  ITEM is a write_job_t. */
+static svn_error_t *
+write_job(void *item,
+          void *thread_baton,
+          apr_pool_t *scratch_pool)
+{
+  /* The cancellation callback is not thread-safe.  The editor's thread
+     keeps checking it while receiving the next files. */
+  return svn_error_trace(write_job_run(item, NULL, NULL, scratch_pool));
+}
+
+/* Implements svn_worker_pool__release_func_t.  Release the write_job_t
+   in ITEM and everything it owns. */
+static void
+write_job_destroy(void *item)
+{
+  write_job_t *job = item;
+
+  svn_pool_destroy(job->pool);
+}
+
+/* Set *WRITER to a new file writer with THREADS workers, allocated in
+   RESULT_POOL.  Set it to NULL if no worker could be started. */
+static svn_error_t *
+file_writer_create(file_writer_t **writer,
+                   int threads,
+                   apr_pool_t *result_pool)
+{
+  file_writer_t *result = apr_pcalloc(result_pool, sizeof(*result));
+
+  /* Each pending job keeps a temporary file around.  Limit their number
+     without letting the workers run dry while the editor is waiting for
+     the network. */
+  threads = MIN(threads, FILE_WRITER_MAX_THREADS);
+  SVN_ERR(svn_worker_pool__ordered_create(&result->jobs, threads,
+                                          8 * threads, NULL, write_job,
+                                          write_job_destroy, NULL,
+                                          result_pool));
+
+  *writer = result->jobs ? result : NULL;
+  return SVN_NO_ERROR;
+}
+
+/* Return a new job to be queued in a file writer. */
+static write_job_t *
+write_job_create(void)
+{
+  apr_pool_t *pool = apr_allocator_owner_get(svn_pool_create_allocator(FALSE));
+  write_job_t *job = apr_pcalloc(pool, sizeof(*job));
+
+  job->pool = pool;
+  return job;
+}
+
+/* Notify NOTIFY_FUNC with NOTIFY_BATON about the jobs in WRITER, in
+   order, as long as they are completed already or WRITER can't hold them
+   anymore.  If WAIT is set, reap all of them.  Return the first job's
+   error, if any. */
+static svn_error_t *
+file_writer_reap(file_writer_t *writer,
+                 svn_boolean_t wait,
+                 svn_wc_notify_func2_t notify_func,
+                 void *notify_baton,
+                 apr_pool_t *scratch_pool)
+{
+  while (TRUE)
+    {
+      void *job;
+      svn_error_t *err;
+
+      SVN_ERR(svn_worker_pool__ordered_take(&job, &err, writer->jobs, wait));
+      if (!job)
+        break;
+
+      if (!err)
+        notify_file_added(job, notify_func, notify_baton, scratch_pool);
+
+      write_job_destroy(job);
+      SVN_ERR(err);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Queue JOB, created by write_job_create(), in WRITER.  Reap all jobs that
+   are completed already, as well as those that WRITER can't hold
+   anymore, notifying NOTIFY_FUNC with NOTIFY_BATON about each. */
+static svn_error_t *
+file_writer_add(file_writer_t *writer,
+                write_job_t *job,
+                svn_wc_notify_func2_t notify_func,
+                void *notify_baton,
+                apr_pool_t *scratch_pool)
+{
+  SVN_ERR(svn_worker_pool__ordered_add(writer->jobs, job));
+
+  return svn_error_trace(file_writer_reap(writer, FALSE, notify_func,
+                                          notify_baton, scratch_pool));
+}
+
+/* Wait for all jobs in WRITER to finish, notifying NOTIFY_FUNC with
+   NOTIFY_BATON about each, in order. */
+static svn_error_t *
+file_writer_finish(file_writer_t *writer,
+                   svn_wc_notify_func2_t notify_func,
+                   void *notify_baton,
+                   apr_pool_t *scratch_pool)
+{
+  return svn_error_trace(file_writer_reap(writer, TRUE, notify_func,
+                                          notify_baton, scratch_pool));
+}
+
+#endif /* APR_HAS_THREADS */
+
+
+/* ---------------------------------------------------------------------- */
+
+
 /*** A dedicated 'export' editor, which does no .svn/ accounting.  ***/
 
 
@@ -511,6 +739,16 @@ struct edit_baton
   void *cancel_baton;
   svn_wc_notify_func2_t notify_func;
   void *notify_baton;
+
+  /* If not NULL, put the files into place in the threads of this
+     writer. */
+  file_writer_t *writer;
+
+  /* If not NULL, add everything to this archive instead of writing to
+     disk.  ROOT_PATH is the relpath within the archive then and MTIME
+     is the timestamp for directories. */
+  svn_tar__writer_t *tar;
+  apr_time_t mtime;
 };
 
 
@@ -707,9 +945,12 @@ apply_textdelta(void *file_baton,
   struct handler_baton *hb = apr_palloc(pool, sizeof(*hb));
 
   /* Create a temporary file in the same directory as the file. We're going
-     to rename the thing into place when we're done. */
+     to rename the thing into place when we're done.  Archived files only
+     need a temporary file anywhere. */
   SVN_ERR(svn_stream_open_unique(&fb->tmp_stream, &fb->tmppath,
-                                 svn_dirent_dirname(fb->path, pool),
+                                 fb->edit_baton->tar
+                                   ? NULL
+                                   : svn_dirent_dirname(fb->path, pool),
                                  svn_io_file_del_none, fb->pool, fb->pool));
 
   hb->pool = pool;
@@ -785,21 +1026,15 @@ change_dir_prop(void *dir_baton,
 }
 
 
-/* Move the tmpfile to file, and send feedback. */
+/* Close the tmpfile of FB and verify its contents against TEXT_DIGEST. */
 static svn_error_t *
-close_file(void *file_baton,
-           const char *text_digest,
-           apr_pool_t *pool)
+close_tmp_stream(struct file_baton *fb,
+                 const char *text_digest,
+                 apr_pool_t *pool)
 {
-  struct file_baton *fb = file_baton;
-  struct edit_baton *eb = fb->edit_baton;
   svn_checksum_t *text_checksum;
   svn_checksum_t *actual_checksum;
 
-  /* Was a txdelta even sent? */
-  if (! fb->tmppath)
-    return SVN_NO_ERROR;
-
   SVN_ERR(svn_stream_close(fb->tmp_stream));
 
   SVN_ERR(svn_checksum_parse_hex(&text_checksum, svn_checksum_md5, text_digest,
@@ -814,55 +1049,70 @@ close_file(void *file_baton,
                                      _("Checksum mismatch for '%s'"),
                                      svn_dirent_local_style(fb->path, pool));
 
-  if ((! fb->eol_style_val) && (! fb->keywords_val) && (! fb->special))
+  return SVN_NO_ERROR;
+}
+
+/* Move the tmpfile to file, and send feedback.  If the edit baton has a
+   file writer, leave both to that writer. */
+static svn_error_t *
+close_file(void *file_baton,
+           const char *text_digest,
+           apr_pool_t *pool)
+{
+  struct file_baton *fb = file_baton;
+  struct edit_baton *eb = fb->edit_baton;
+  write_job_t *job;
+  apr_pool_t *job_pool;
+
+  /* Was a txdelta even sent? */
+  if (! fb->tmppath)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(close_tmp_stream(fb, text_digest, pool));
+
+  /* A queued job outlives FB and POOL. */
+#if APR_HAS_THREADS
+  if (eb->writer)
     {
-      SVN_ERR(svn_io_file_rename2(fb->tmppath, fb->path, FALSE, pool));
+      job = write_job_create();
+      job_pool = job->pool;
     }
   else
+#endif
     {
-      svn_subst_eol_style_t style;
-      const char *eol = NULL;
-      svn_boolean_t repair = FALSE;
-      apr_hash_t *final_kw = NULL;
-
-      if (fb->eol_style_val)
-        {
-          SVN_ERR(get_eol_style(&style, &eol, fb->eol_style_val->data,
-                                eb->native_eol));
-          repair = TRUE;
-        }
+      job = apr_pcalloc(pool, sizeof(*job));
+      job_pool = pool;
+    }
 
-      if (fb->keywords_val)
-        SVN_ERR(svn_subst_build_keywords3(&final_kw, fb->keywords_val->data,
-                                          fb->revision, fb->url,
-                                          fb->repos_root_url, fb->date,
-                                          fb->author, pool));
+  job->tmppath = apr_pstrdup(job_pool, fb->tmppath);
+  job->path = apr_pstrdup(job_pool, fb->path);
+  job->special = fb->special;
+  job->executable = (fb->executable_val != NULL);
+  job->date = fb->date;
 
-      SVN_ERR(svn_subst_copy_and_translate4(fb->tmppath, fb->path,
-                                            eol, repair, final_kw,
-                                            TRUE, /* expand */
-                                            fb->special,
-                                            eb->cancel_func, eb->cancel_baton,
-                                            pool));
+  if (fb->eol_style_val)
+    {
+      svn_subst_eol_style_t style;
 
-      SVN_ERR(svn_io_remove_file2(fb->tmppath, FALSE, pool));
+      SVN_ERR(get_eol_style(&style, &job->eol, fb->eol_style_val->data,
+                            eb->native_eol));
+      job->repair = TRUE;
     }
 
-  if (fb->executable_val)
-    SVN_ERR(svn_io_set_file_executable(fb->path, TRUE, FALSE, pool));
+  if (fb->keywords_val)
+    SVN_ERR(svn_subst_build_keywords3(&job->keywords, fb->keywords_val->data,
+                                      fb->revision, fb->url,
+                                      fb->repos_root_url, fb->date,
+                                      fb->author, job_pool));
 
-  if (fb->date && (! fb->special))
-    SVN_ERR(svn_io_set_file_affected_time(fb->date, fb->path, pool));
+#if APR_HAS_THREADS
+  if (eb->writer)
+    return svn_error_trace(file_writer_add(eb->writer, job, eb->notify_func,
+                                           eb->notify_baton, pool));
+#endif
 
-  if (fb->edit_baton->notify_func)
-    {
-      svn_wc_notify_t *notify = svn_wc_create_notify(fb->path,
-                                                     svn_wc_notify_update_add,
-                                                     pool);
-      notify->kind = svn_node_file;
-      (*fb->edit_baton->notify_func)(fb->edit_baton->notify_baton, notify,
-                                     pool);
-    }
+  SVN_ERR(write_job_run(job, eb->cancel_func, eb->cancel_baton, pool));
+  notify_file_added(job, eb->notify_func, eb->notify_baton, pool);
 
   return SVN_NO_ERROR;
 }
@@ -1299,9 +1549,35 @@ export_directory(const char *from_url,
   const svn_ra_reporter3_t *reporter;
   void *report_baton;
   svn_node_kind_t kind;
+#if APR_HAS_THREADS
+  apr_pool_t *writer_pool = NULL;
+#endif
 
   SVN_ERR_ASSERT(svn_path_is_url(from_url));
 
+#if APR_HAS_THREADS
+  if (!ENABLE_EV2_IMPL)
+    {
+      svn_config_t *cfg;
+      apr_int64_t export_threads;
+
+      cfg = ctx->config ? svn_hash_gets(ctx->config,
+                                        SVN_CONFIG_CATEGORY_CONFIG)
+                        : NULL;
+      SVN_ERR(svn_config_get_int64(cfg, &export_threads,
+                                   SVN_CONFIG_SECTION_MISCELLANY,
+                                   SVN_CONFIG_OPTION_EXPORT_THREADS, 1));
+      if (export_threads > 1)
+        {
+          writer_pool = svn_pool_create(scratch_pool);
+          SVN_ERR(file_writer_create(&eb->writer,
+                                     (int)MIN(export_threads,
+                                              FILE_WRITER_MAX_THREADS),
+                                     writer_pool));
+        }
+    }
+#endif
+
   if (!ENABLE_EV2_IMPL)
     SVN_ERR(get_editor_ev1(&export_editor, &edit_baton, eb, ctx,
                            scratch_pool, scratch_pool));
@@ -1329,6 +1605,19 @@ export_directory(const char *from_url,
 
   SVN_ERR(reporter->finish_report(report_baton, scratch_pool));
 
+#if APR_HAS_THREADS
+  /* All files must be in place before the externals get exported into
+     their directories. */
+  if (eb->writer)
+    {
+      SVN_ERR(file_writer_finish(eb->writer, eb->notify_func,
+                                 eb->notify_baton, scratch_pool));
+      eb->writer = NULL;
+    }
+  if (writer_pool)
+    svn_pool_destroy(writer_pool);
+#endif
+
   /* Special case: Due to our sly export/checkout method of updating an
    * empty directory, no target will have been created if the exported
    * item is itself an empty directory (export_editor->open_root never
@@ -1361,6 +1650,404 @@ export_directory(const char *from_url,
 }
 
 
+
+/*** Exporting into a tar archive. ***/
+
+/* Send the svn_wc_notify_update_add notification about the archive entry
+   RELPATH of KIND. */
+static void
+notify_entry_added(struct edit_baton *eb,
+                   const char *relpath,
+                   svn_node_kind_t kind,
+                   apr_pool_t *pool)
+{
+  if (eb->notify_func)
+    {
+      svn_wc_notify_t *notify = svn_wc_create_notify(relpath,
+                                                     svn_wc_notify_update_add,
+                                                     pool);
+      notify->kind = kind;
+      (*eb->notify_func)(eb->notify_baton, notify, pool);
+    }
+}
+
+/* The root directory entry, if any, has been added by the caller. */
+static svn_error_t *
+tar_open_root(void *edit_baton,
+              svn_revnum_t base_revision,
+              apr_pool_t *pool,
+              void **root_baton)
+{
+  struct edit_baton *eb = edit_baton;
+  struct dir_baton *db = apr_pcalloc(pool, sizeof(*db));
+
+  db->path = eb->root_path;
+  db->edit_baton = eb;
+  *root_baton = db;
+
+  return SVN_NO_ERROR;
+}
+
+/* Add the directory entry, and send feedback. */
+static svn_error_t *
+tar_add_directory(const char *path,
+                  void *parent_baton,
+                  const char *copyfrom_path,
+                  svn_revnum_t copyfrom_revision,
+                  apr_pool_t *pool,
+                  void **baton)
+{
+  struct dir_baton *pb = parent_baton;
+  struct dir_baton *db = apr_pcalloc(pool, sizeof(*db));
+  struct edit_baton *eb = pb->edit_baton;
+  const char *relpath = svn_relpath_join(eb->root_path, path, pool);
+
+  SVN_ERR(svn_tar__add_directory(eb->tar, relpath, eb->mtime, pool));
+  notify_entry_added(eb, relpath, svn_node_dir, pool);
+
+  db->path = relpath;
+  db->edit_baton = eb;
+  *baton = db;
+
+  return SVN_NO_ERROR;
+}
+
+/* Remember externals definitions by the archive path of DIR_BATON. */
+static svn_error_t *
+tar_change_dir_prop(void *dir_baton,
+                    const char *name,
+                    const svn_string_t *value,
+                    apr_pool_t *pool)
+{
+  struct dir_baton *db = dir_baton;
+  struct edit_baton *eb = db->edit_baton;
+
+  if (value && (strcmp(name, SVN_PROP_EXTERNALS) == 0))
+    {
+      apr_pool_t *hash_pool = apr_hash_pool_get(eb->externals);
+
+      svn_hash_sets(eb->externals, apr_pstrdup(hash_pool, db->path),
+                    apr_pstrmemdup(hash_pool, value->data, value->len));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Add the translated tmpfile to the archive, and send feedback. */
+static svn_error_t *
+tar_close_file(void *file_baton,
+               const char *text_digest,
+               apr_pool_t *pool)
+{
+  struct file_baton *fb = file_baton;
+  struct edit_baton *eb = fb->edit_baton;
+  apr_hash_t *keywords = NULL;
+  svn_stream_t *contents;
+  apr_finfo_t finfo;
+
+  /* Was a txdelta even sent? */
+  if (! fb->tmppath)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(close_tmp_stream(fb, text_digest, pool));
+
+  if (fb->keywords_val)
+    SVN_ERR(svn_subst_build_keywords3(&keywords, fb->keywords_val->data,
+                                      fb->revision, fb->url,
+                                      fb->repos_root_url, fb->date,
+                                      fb->author, pool));
+
+  SVN_ERR(svn_io_stat(&finfo, fb->tmppath, APR_FINFO_SIZE, pool));
+  SVN_ERR(svn_stream_open_readonly(&contents, fb->tmppath, pool, pool));
+  SVN_ERR(svn_tar__add_versioned_file(eb->tar, fb->path, contents,
+                                      finfo.size,
+                                      fb->eol_style_val
+                                        ? fb->eol_style_val->data
+                                        : NULL,
+                                      eb->native_eol, keywords,
+                                      fb->special,
+                                      fb->executable_val != NULL,
+                                      fb->date ? fb->date : eb->mtime,
+                                      eb->cancel_func, eb->cancel_baton,
+                                      pool));
+  SVN_ERR(svn_io_remove_file2(fb->tmppath, FALSE, pool));
+
+  notify_entry_added(eb, fb->path, svn_node_file, pool);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+get_tar_editor(const svn_delta_editor_t **export_editor,
+               void **edit_baton,
+               struct edit_baton *eb,
+               svn_client_ctx_t *ctx,
+               apr_pool_t *result_pool,
+               apr_pool_t *scratch_pool)
+{
+  svn_delta_editor_t *editor = svn_delta_default_editor(result_pool);
+
+  editor->set_target_revision = set_target_revision;
+  editor->open_root = tar_open_root;
+  editor->add_directory = tar_add_directory;
+  editor->add_file = add_file;
+  editor->apply_textdelta = apply_textdelta;
+  editor->close_file = tar_close_file;
+  editor->change_file_prop = change_file_prop;
+  editor->change_dir_prop = tar_change_dir_prop;
+
+  SVN_ERR(svn_delta_get_cancellation_editor(ctx->cancel_func,
+                                            ctx->cancel_baton,
+                                            editor,
+                                            eb,
+                                            export_editor,
+                                            edit_baton,
+                                            result_pool));
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+export_tar_externals(svn_tar__writer_t *tar,
+                     apr_hash_t *externals,
+                     const char *from_url,
+                     const char *archive_relpath,
+                     const char *repos_root_url,
+                     const char *native_eol,
+                     svn_boolean_t ignore_keywords,
+                     svn_client_ctx_t *ctx,
+                     apr_pool_t *scratch_pool);
+
+/* Add the tree at FROM_PATH_OR_URL in REVISION, looked up at PEG_REVISION,
+   to TAR below ARCHIVE_RELPATH.  IGNORE_EXTERNALS, IGNORE_KEYWORDS, DEPTH,
+   NATIVE_EOL and CTX are as for svn_client_export_tar().  Set
+   *RESULT_REV to the exported revision unless RESULT_REV is NULL.  Use
+   SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+export_tar_internal(svn_revnum_t *result_rev,
+                    svn_tar__writer_t *tar,
+                    const char *archive_relpath,
+                    const char *from_path_or_url,
+                    const svn_opt_revision_t *peg_revision,
+                    const svn_opt_revision_t *revision,
+                    svn_boolean_t ignore_externals,
+                    svn_boolean_t ignore_keywords,
+                    svn_depth_t depth,
+                    const char *native_eol,
+                    svn_client_ctx_t *ctx,
+                    apr_pool_t *scratch_pool)
+{
+  svn_revnum_t edit_revision = SVN_INVALID_REVNUM;
+  struct edit_baton *eb = apr_pcalloc(scratch_pool, sizeof(*eb));
+  svn_client__pathrev_t *loc;
+  svn_ra_session_t *ra_session;
+  svn_node_kind_t kind;
+  const char *from_url;
+  svn_string_t *date;
+
+  SVN_ERR(svn_client_url_from_path2(&from_url, from_path_or_url,
+                                    ctx, scratch_pool, scratch_pool));
+  SVN_ERR(svn_client__ra_session_from_path2(&ra_session, &loc,
+                                            from_path_or_url, NULL,
+                                            peg_revision, revision,
+                                            ctx, scratch_pool));
+
+  SVN_ERR(svn_ra_get_repos_root2(ra_session, &eb->repos_root_url,
+                                 scratch_pool));
+  eb->root_path = archive_relpath;
+  eb->root_url = loc->url;
+  eb->target_revision = &edit_revision;
+  eb->externals = apr_hash_make(scratch_pool);
+  eb->native_eol = native_eol;
+  eb->ignore_keywords = ignore_keywords;
+  eb->cancel_func = ctx->cancel_func;
+  eb->cancel_baton = ctx->cancel_baton;
+  eb->notify_func = ctx->notify_func2;
+  eb->notify_baton = ctx->notify_baton2;
+  eb->tar = tar;
+
+  /* Directories get the date of the exported revision, so exporting the
+     same revision twice produces the same archive. */
+  SVN_ERR(svn_ra_rev_prop(ra_session, loc->rev, SVN_PROP_REVISION_DATE,
+                          &date, scratch_pool));
+  if (date)
+    SVN_ERR(svn_time_from_cstring(&eb->mtime, date->data, scratch_pool));
+
+  SVN_ERR(svn_ra_check_path(ra_session, "", loc->rev, &kind, scratch_pool));
+
+  if (kind == svn_node_file)
+    {
+      struct file_baton *fb = apr_pcalloc(scratch_pool, sizeof(*fb));
+      apr_hash_t *props;
+      apr_hash_index_t *hi;
+
+      if (! *archive_relpath)
+        eb->root_path = svn_uri_basename(from_url, scratch_pool);
+
+      /* Drive the editor functions like export_file() does. */
+      fb->edit_baton = eb;
+      fb->path = eb->root_path;
+      fb->url = eb->root_url;
+      fb->pool = scratch_pool;
+      fb->repos_root_url = eb->repos_root_url;
+
+      SVN_ERR(svn_stream_open_unique(&fb->tmp_stream, &fb->tmppath, NULL,
+                                     svn_io_file_del_none,
+                                     fb->pool, fb->pool));
+      SVN_ERR(svn_ra_get_file(ra_session, "", loc->rev, fb->tmp_stream,
+                              NULL, &props, scratch_pool));
+
+      for (hi = apr_hash_first(scratch_pool, props);
+           hi;
+           hi = apr_hash_next(hi))
+        SVN_ERR(change_file_prop(fb, apr_hash_this_key(hi),
+                                 apr_hash_this_val(hi), scratch_pool));
+
+      SVN_ERR(tar_close_file(fb, NULL, scratch_pool));
+      edit_revision = loc->rev;
+    }
+  else if (kind == svn_node_dir)
+    {
+      void *edit_baton;
+      const svn_delta_editor_t *export_editor;
+      const svn_ra_reporter3_t *reporter;
+      void *report_baton;
+
+      if (*archive_relpath)
+        {
+          SVN_ERR(svn_tar__add_directory(tar, archive_relpath, eb->mtime,
+                                         scratch_pool));
+          notify_entry_added(eb, archive_relpath, svn_node_dir,
+                             scratch_pool);
+        }
+
+      SVN_ERR(get_tar_editor(&export_editor, &edit_baton, eb, ctx,
+                             scratch_pool, scratch_pool));
+
+      SVN_ERR(svn_ra_do_update3(ra_session,
+                                &reporter, &report_baton,
+                                loc->rev,
+                                "", /* no sub-target */
+                                depth,
+                                FALSE, /* don't want copyfrom-args */
+                                FALSE, /* don't want ignore_ancestry */
+                                export_editor, edit_baton,
+                                scratch_pool, scratch_pool));
+
+      SVN_ERR(reporter->set_path(report_baton, "", loc->rev,
+                                 svn_depth_infinity,
+                                 TRUE, /* "help, my dir is empty!" */
+                                 NULL, scratch_pool));
+
+      SVN_ERR(reporter->finish_report(report_baton, scratch_pool));
+
+      if (! ignore_externals && depth == svn_depth_infinity)
+        SVN_ERR(export_tar_externals(tar, eb->externals, from_url,
+                                     archive_relpath, eb->repos_root_url,
+                                     native_eol, ignore_keywords,
+                                     ctx, scratch_pool));
+    }
+  else if (kind == svn_node_none)
+    {
+      return svn_error_createf(SVN_ERR_RA_ILLEGAL_URL, NULL,
+                               _("URL '%s' doesn't exist"),
+                               from_path_or_url);
+    }
+
+  if (result_rev)
+    *result_rev = edit_revision;
+
+  return SVN_NO_ERROR;
+}
+
+/* Add the EXTERNALS, which map archive relpaths below ARCHIVE_RELPATH to
+   the externals definitions found there, to TAR.  ARCHIVE_RELPATH
+   corresponds to FROM_URL in the repository at REPOS_ROOT_URL.  The other
+   parameters are as for export_tar_internal(). */
+static svn_error_t *
+export_tar_externals(svn_tar__writer_t *tar,
+                     apr_hash_t *externals,
+                     const char *from_url,
+                     const char *archive_relpath,
+                     const char *repos_root_url,
+                     const char *native_eol,
+                     svn_boolean_t ignore_keywords,
+                     svn_client_ctx_t *ctx,
+                     apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  apr_array_header_t *sorted;
+  int i;
+
+  /* Keep the order of the archive independent of hash ordering. */
+  sorted = svn_sort__hash(externals, svn_sort_compare_items_as_paths,
+                          scratch_pool);
+
+  for (i = 0; i < sorted->nelts; i++)
+    {
+      const svn_sort__item_t *item = &APR_ARRAY_IDX(sorted, i,
+                                                    svn_sort__item_t);
+      const char *dir_relpath = item->key;
+      const char *dir_url;
+      apr_array_header_t *items;
+      int j;
+
+      svn_pool_clear(iterpool);
+
+      dir_url = svn_path_url_add_component2(
+                  from_url,
+                  svn_relpath_skip_ancestor(archive_relpath, dir_relpath),
+                  iterpool);
+
+      SVN_ERR(svn_wc_parse_externals_description3(&items, dir_url,
+                                                  item->value, FALSE,
+                                                  iterpool));
+
+      for (j = 0; j < items->nelts; j++)
+        {
+          svn_wc_external_item2_t *external
+            = APR_ARRAY_IDX(items, j, svn_wc_external_item2_t *);
+          const char *external_relpath;
+          const char *new_url;
+
+          if (svn_path_is_backpath_present(external->target_dir)
+              || ! svn_relpath_is_canonical(external->target_dir))
+            return svn_error_createf(SVN_ERR_WC_OBSTRUCTED_UPDATE, NULL,
+                                     _("External '%s' defined on '%s' is "
+                                       "not in the exported tree"),
+                                     external->target_dir, dir_relpath);
+
+          external_relpath = svn_relpath_join(dir_relpath,
+                                              external->target_dir,
+                                              iterpool);
+
+          SVN_ERR(svn_wc__resolve_relative_external_url(&new_url, external,
+                                                        repos_root_url,
+                                                        dir_url, iterpool,
+                                                        iterpool));
+
+          if (ctx->notify_func2)
+            ctx->notify_func2(ctx->notify_baton2,
+                              svn_wc_create_notify(
+                                  external_relpath,
+                                  svn_wc_notify_update_external, iterpool),
+                              iterpool);
+
+          SVN_ERR(export_tar_internal(NULL, tar, external_relpath, new_url,
+                                      &external->peg_revision,
+                                      &external->revision,
+                                      FALSE, ignore_keywords,
+                                      svn_depth_infinity, native_eol,
+                                      ctx, iterpool));
+        }
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+
 
 /*** Public Interfaces ***/
 
@@ -1589,3 +2276,56 @@ svn_client_export5(svn_revnum_t *result_rev,
   return SVN_NO_ERROR;
 }
 
+svn_error_t *
+svn_client_export_tar(svn_revnum_t *result_rev,
+                      svn_stream_t *tar_stream,
+                      const char *from_path_or_url,
+                      const char *archive_root,
+                      const svn_opt_revision_t *peg_revision,
+                      const svn_opt_revision_t *revision,
+                      svn_boolean_t ignore_externals,
+                      svn_boolean_t ignore_keywords,
+                      svn_depth_t depth,
+                      const char *native_eol,
+                      svn_client_ctx_t *ctx,
+                      apr_pool_t *pool)
+{
+  svn_revnum_t edit_revision;
+  svn_tar__writer_t *tar;
+
+  SVN_ERR_ASSERT(peg_revision != NULL);
+  SVN_ERR_ASSERT(revision != NULL);
+  SVN_ERR_ASSERT(svn_relpath_is_canonical(archive_root));
+
+  peg_revision = svn_cl__rev_default_to_head_or_working(peg_revision,
+                                                        from_path_or_url);
+  revision = svn_cl__rev_default_to_peg(revision, peg_revision);
+
+  if (! svn_path_is_url(from_path_or_url)
+      && SVN_CLIENT__REVKIND_IS_LOCAL_TO_WC(revision->kind))
+    return svn_error_createf(SVN_ERR_UNSUPPORTED_FEATURE, NULL,
+                             _("Cannot export the working copy '%s' into "
+                               "an archive; specify a repository revision"),
+                             svn_dirent_local_style(from_path_or_url, pool));
+
+  tar = svn_tar__writer_create(tar_stream, pool);
+  SVN_ERR(export_tar_internal(&edit_revision, tar, archive_root,
+                              from_path_or_url, peg_revision, revision,
+                              ignore_externals, ignore_keywords, depth,
+                              native_eol, ctx, pool));
+  SVN_ERR(svn_tar__writer_finish(tar, pool));
+
+  if (ctx->notify_func2)
+    {
+      svn_wc_notify_t *notify
+        = svn_wc_create_notify(archive_root,
+                               svn_wc_notify_update_completed, pool);
+      notify->revision = edit_revision;
+      ctx->notify_func2(ctx->notify_baton2, notify, pool);
+    }
+
+  if (result_rev)
+    *result_rev = edit_revision;
+
+  return SVN_NO_ERROR;
+}
@@ -41,6 +41,7 @@
 #include "client.h"
 
 #include "svn_private_config.h"
+#include "private/svn_sorts_private.h"
 #include "private/svn_wc_private.h"
 
 
@@ -745,6 +746,79 @@ handle_external_item_removal(const svn_client_ctx_t *ctx,
   return svn_error_trace(err);
 }
 
+/* The RA sessions that may be reused while processing externals.
+ * Externals tend to point to a few repositories only, so repeating the
+ * connection setup and authentication for every external is wasteful.
+ */
+typedef struct externals_sessions_t
+{
+  /* All sessions opened so far, including the one of the driving
+   * operation (if any).  Each one points to a different repository. */
+  apr_array_header_t *sessions;
+
+  /* Pool that new sessions are acquired for.  They return to the session
+   * pool of the client context when this one gets cleared. */
+  apr_pool_t *pool;
+} externals_sessions_t;
+
+/* Return a new externals_sessions_t, allocated in RESULT_POOL, that
+ * contains RA_SESSION, if not NULL.
+ */
+static externals_sessions_t *
+create_externals_sessions(svn_ra_session_t *ra_session,
+                          apr_pool_t *result_pool)
+{
+  externals_sessions_t *result = apr_pcalloc(result_pool, sizeof(*result));
+  result->sessions = apr_array_make(result_pool, 4,
+                                    sizeof(svn_ra_session_t *));
+  result->pool = result_pool;
+
+  if (ra_session)
+    APR_ARRAY_PUSH(result->sessions, svn_ra_session_t *) = ra_session;
+
+  return result;
+}
+
+/* Set *RA_SESSION to the session in SESSIONS that can be reparented to
+ * URL and do so.  If there is none, acquire a session to URL from the
+ * session pool of CTX and add it to SESSIONS.  Use CTX to open sessions and SCRATCH_POOL for temporary
+ * allocations.
+ */
+static svn_error_t *
+get_externals_session(svn_ra_session_t **ra_session,
+                      externals_sessions_t *sessions,
+                      const char *url,
+                      svn_client_ctx_t *ctx,
+                      apr_pool_t *scratch_pool)
+{
+  int i;
+
+  for (i = 0; i < sessions->sessions->nelts; ++i)
+    {
+      svn_ra_session_t *session
+        = APR_ARRAY_IDX(sessions->sessions, i, svn_ra_session_t *);
+      svn_error_t *err = svn_ra_reparent(session, url, scratch_pool);
+
+      if (!err)
+        {
+          *ra_session = session;
+          return SVN_NO_ERROR;
+        }
+
+      /* Different repository? */
+      if (err->apr_err != SVN_ERR_RA_ILLEGAL_URL)
+        return svn_error_trace(err);
+
+      svn_error_clear(err);
+    }
+
+  SVN_ERR(svn_client__ra_session_acquire(ra_session, url, ctx,
+                                         sessions->pool, scratch_pool));
+  APR_ARRAY_PUSH(sessions->sessions, svn_ra_session_t *) = *ra_session;
+
+  return SVN_NO_ERROR;
+}
+
 static svn_error_t *
 handle_external_item_change(svn_client_ctx_t *ctx,
                             const char *repos_root_url,
@@ -753,13 +827,14 @@ handle_external_item_change(svn_client_ctx_t *ctx,
                             const char *local_abspath,
                             const char *old_defining_abspath,
                             const svn_wc_external_item2_t *new_item,
-                            svn_ra_session_t *ra_session,
+                            externals_sessions_t *sessions,
                             svn_boolean_t *timestamp_sleep,
                             apr_pool_t *scratch_pool)
 {
   svn_client__pathrev_t *new_loc;
   const char *new_url;
   svn_node_kind_t ext_kind;
+  svn_ra_session_t *ra_session;
 
   SVN_ERR_ASSERT(repos_root_url && parent_dir_url);
   SVN_ERR_ASSERT(new_item != NULL);
@@ -777,39 +852,17 @@ handle_external_item_change(svn_client_ctx_t *ctx,
                                                 scratch_pool, scratch_pool));
 
   /* Determine if the external is a file or directory. */
-  /* Get the RA connection, if needed. */
-  if (ra_session)
-    {
-      svn_error_t *err = svn_ra_reparent(ra_session, new_url, scratch_pool);
-
-      if (err)
-        {
-          if (err->apr_err == SVN_ERR_RA_ILLEGAL_URL)
-            {
-              svn_error_clear(err);
-              ra_session = NULL;
-            }
-          else
-            return svn_error_trace(err);
-        }
-      else
-        {
-          SVN_ERR(svn_client__resolve_rev_and_url(&new_loc,
-                                                  ra_session, new_url,
-                                                  &(new_item->peg_revision),
-                                                  &(new_item->revision), ctx,
-                                                  scratch_pool));
-
-          SVN_ERR(svn_ra_reparent(ra_session, new_loc->url, scratch_pool));
-        }
-    }
-
-  if (!ra_session)
-    SVN_ERR(svn_client__ra_session_from_path2(&ra_session, &new_loc,
-                                              new_url, NULL,
-                                              &(new_item->peg_revision),
-                                              &(new_item->revision), ctx,
-                                              scratch_pool));
+  /* Get the RA connection, reusing an existing one if possible. */
+  SVN_ERR(get_externals_session(&ra_session, sessions, new_url, ctx,
+                                scratch_pool));
+
+  /* Opening a new session may have followed a redirect. */
+  SVN_ERR(svn_ra_get_session_url(ra_session, &new_url, scratch_pool));
+  SVN_ERR(svn_client__resolve_rev_and_url(&new_loc, ra_session, new_url,
+                                          &(new_item->peg_revision),
+                                          &(new_item->revision), ctx,
+                                          scratch_pool));
+  SVN_ERR(svn_ra_reparent(ra_session, new_loc->url, scratch_pool));
 
   SVN_ERR(svn_ra_check_path(ra_session, "", new_loc->rev, &ext_kind,
                             scratch_pool));
@@ -967,7 +1020,7 @@ handle_externals_change(svn_client_ctx_t *ctx,
                         apr_hash_t *old_externals,
                         svn_depth_t ambient_depth,
                         svn_depth_t requested_depth,
-                        svn_ra_session_t *ra_session,
+                        externals_sessions_t *sessions,
                         apr_pool_t *scratch_pool)
 {
   apr_array_header_t *new_desc;
@@ -1036,7 +1089,7 @@ handle_externals_change(svn_client_ctx_t *ctx,
                                                   local_abspath, url,
                                                   target_abspath,
                                                   old_defining_abspath,
-                                                  new_item, ra_session,
+                                                  new_item, sessions,
                                                   timestamp_sleep,
                                                   iterpool),
                       iterpool));
@@ -1066,6 +1119,9 @@ svn_client__handle_externals(apr_hash_t *externals_new,
   apr_hash_t *old_external_defs;
   apr_hash_index_t *hi;
   apr_pool_t *iterpool;
+  apr_array_header_t *sorted_externals;
+  externals_sessions_t *sessions;
+  int i;
 
   SVN_ERR_ASSERT(repos_root_url);
 
@@ -1075,12 +1131,22 @@ svn_client__handle_externals(apr_hash_t *externals_new,
                                           ctx->wc_ctx, target_abspath,
                                           scratch_pool, iterpool));
 
-  for (hi = apr_hash_first(scratch_pool, externals_new);
-       hi;
-       hi = apr_hash_next(hi))
+  /* Sessions opened for some external will be reused for all following
+   * externals from the same repository. */
+  sessions = create_externals_sessions(ra_session, scratch_pool);
+
+  /* Process the definitions in a stable, path-wise order such that the
+   * notifications don't depend on hash ordering. */
+  sorted_externals = svn_sort__hash(externals_new,
+                                    svn_sort_compare_items_as_paths,
+                                    scratch_pool);
+
+  for (i = 0; i < sorted_externals->nelts; ++i)
     {
-      const char *local_abspath = apr_hash_this_key(hi);
-      const char *desc_text = apr_hash_this_val(hi);
+      svn_sort__item_t *item = &APR_ARRAY_IDX(sorted_externals, i,
+                                              svn_sort__item_t);
+      const char *local_abspath = item->key;
+      const char *desc_text = item->value;
       svn_depth_t ambient_depth = svn_depth_infinity;
 
       svn_pool_clear(iterpool);
@@ -1090,7 +1156,7 @@ svn_client__handle_externals(apr_hash_t *externals_new,
           const char *ambient_depth_w;
 
           ambient_depth_w = apr_hash_get(ambient_depths, local_abspath,
-                                         apr_hash_this_key_len(hi));
+                                         item->klen);
 
           if (ambient_depth_w == NULL)
             {
@@ -1109,7 +1175,7 @@ svn_client__handle_externals(apr_hash_t *externals_new,
                                       local_abspath,
                                       desc_text, old_external_defs,
                                       ambient_depth, requested_depth,
-                                      ra_session, iterpool));
+                                      sessions, iterpool));
     }
 
   /* Remove the remaining externals */
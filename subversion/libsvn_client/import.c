@@ -45,12 +45,14 @@
 #include "svn_io.h"
 #include "svn_sorts.h"
 #include "svn_props.h"
+#include "svn_config.h"
 
 #include "client.h"
 #include "private/svn_ra_private.h"
 #include "private/svn_sorts_private.h"
 #include "private/svn_subr_private.h"
 #include "private/svn_magic.h"
+#include "private/svn_worker_pool.h"
 
 #include "svn_private_config.h"
 
@@ -71,6 +73,12 @@ typedef struct import_ctx_t
      svn:executable, simply map the property name to an empty string.
      May be NULL if autoprops are disabled. */
   apr_hash_t *autoprops;
+
+#if APR_HAS_THREADS
+  /* Prepares and sends the contents of imported files while the tree is
+     still being walked.  NULL if files are sent one after the other. */
+  struct import_text_queue_t *text_queue;
+#endif
 } import_ctx_t;
 
 typedef struct open_txdelta_stream_baton_t
@@ -103,19 +111,13 @@ open_txdelta_stream(svn_txdelta_stream_t **txdelta_stream_p,
   return SVN_NO_ERROR;
 }
 
-/* Apply LOCAL_ABSPATH's contents (as a delta against the empty string) to
-   FILE_BATON in EDITOR.  Use POOL for any temporary allocation.
-   PROPERTIES is the set of node properties set on this file.
-
-   Return the resulting checksum in *RESULT_MD5_CHECKSUM_P. */
-
-/* ### how does this compare against svn_wc_transmit_text_deltas2() ??? */
-
+/* Set *CONTENTS_P to a stream reading LOCAL_ABSPATH's contents in the
+   form they are sent to the repository, i.e. detranslated according to
+   PROPERTIES, the set of node properties set on this file.  Allocate
+   the stream in POOL, which is also used for temporary allocations. */
 static svn_error_t *
-send_file_contents(svn_checksum_t **result_md5_checksum_p,
+open_file_contents(svn_stream_t **contents_p,
                    const char *local_abspath,
-                   void *file_baton,
-                   const svn_delta_editor_t *editor,
                    apr_hash_t *properties,
                    apr_pool_t *pool)
 {
@@ -125,7 +127,6 @@ send_file_contents(svn_checksum_t **result_md5_checksum_p,
   svn_subst_eol_style_t eol_style;
   const char *eol;
   apr_hash_t *keywords;
-  open_txdelta_stream_baton_t baton = { 0 };
 
   /* If there are properties, look for EOL-style and keywords ones. */
   if (properties)
@@ -191,6 +192,31 @@ send_file_contents(svn_checksum_t **result_md5_checksum_p,
         }
     }
 
+  *contents_p = contents;
+  return SVN_NO_ERROR;
+}
+
+/* Apply LOCAL_ABSPATH's contents (as a delta against the empty string) to
+   FILE_BATON in EDITOR.  Use POOL for any temporary allocation.
+   PROPERTIES is the set of node properties set on this file.
+
+   Return the resulting checksum in *RESULT_MD5_CHECKSUM_P. */
+
+/* ### how does this compare against svn_wc_transmit_text_deltas2() ??? */
+
+static svn_error_t *
+send_file_contents(svn_checksum_t **result_md5_checksum_p,
+                   const char *local_abspath,
+                   void *file_baton,
+                   const svn_delta_editor_t *editor,
+                   apr_hash_t *properties,
+                   apr_pool_t *pool)
+{
+  svn_stream_t *contents;
+  open_txdelta_stream_baton_t baton = { 0 };
+
+  SVN_ERR(open_file_contents(&contents, local_abspath, properties, pool));
+
   /* Arrange the stream to calculate the resulting MD5. */
   contents = svn_stream_checksummed2(contents, result_md5_checksum_p, NULL,
                                      svn_checksum_md5, TRUE, pool);
@@ -205,6 +231,270 @@ send_file_contents(svn_checksum_t **result_md5_checksum_p,
 }
 
 
+/*** Concurrent import.
+ *
+ * Sending one file after the other keeps 'svn import' waiting for the
+ * disk and, over http://, for the round trip of every single PUT.  With
+ * more than one import thread, import_file() adds the file and sets its
+ * properties as usual but leaves it open and queues an import_text_job_t
+ * in an import_text_queue_t.  Worker threads read and detranslate the
+ * queued files into spill buffers, computing their MD5 checksums on the
+ * way, and the caller's thread sends them through apply_textdelta()
+ * before closing them -- as "postfix" text deltas, like a commit does.
+ * The RA layers don't wait for the contents there: ra_serf runs the PUTs
+ * in the background and ra_svn pipelines all editor commands anyway, so
+ * the whole tree still gets committed in a single transaction.
+ *
+ * Every job lives in its own root pool together with copies of the path
+ * and of the translation properties, so the workers never share a pool
+ * with the caller's thread.  The file batons are only ever used by the
+ * caller's thread.
+ ***/
+
+#if APR_HAS_THREADS
+
+/* The most threads that SVN_CONFIG_OPTION_IMPORT_THREADS may ask for. */
+#define IMPORT_TEXT_QUEUE_MAX_THREADS 32
+
+/* Keep up to this many bytes of a prepared file in memory before
+   spilling it to disk. */
+#define IMPORT_TEXT_MEMORY_SIZE (1024 * 1024)
+
+/* One file whose contents are to be sent. */
+typedef struct import_text_job_t
+{
+  /* The file and the properties that control its detranslation. */
+  const char *local_abspath;
+  apr_hash_t *properties;
+
+  /* Set by the worker: the detranslated contents and their MD5. */
+  svn_spillbuf_t *contents;
+  svn_checksum_t *md5_checksum;
+
+  /* Root pool owned by this job, containing all of the above.  It is only
+     ever used by one thread at a time. */
+  apr_pool_t *pool;
+
+  /* The open file in the editor and the pool it has been added in.  Only
+     used by the caller's thread. */
+  void *file_baton;
+  apr_pool_t *file_pool;
+} import_text_job_t;
+
+typedef struct import_text_queue_t
+{
+  /* The editor to send the contents to. */
+  const svn_delta_editor_t *editor;
+
+  /* Checked by the caller's thread after every file sent. */
+  svn_cancel_func_t cancel_func;
+  void *cancel_baton;
+
+  /* The file batons' pools are created in this pool. */
+  apr_pool_t *pool;
+
+  /* Prepares the contents of all jobs that have not been sent yet, in
+     import order. */
+  svn_worker_pool__ordered_t *jobs;
+} import_text_queue_t;
+
+/* Read the detranslated contents of the file of JOB into its spill
+   buffer and calculate their MD5.  Use SCRATCH_POOL for temporary
+   allocations. */
+static svn_error_t *
+prepare_import_text(import_text_job_t *job,
+                    apr_pool_t *scratch_pool)
+{
+  svn_stream_t *contents;
+
+  job->contents = svn_spillbuf__create(SVN__STREAM_CHUNK_SIZE,
+                                       IMPORT_TEXT_MEMORY_SIZE, job->pool);
+
+  SVN_ERR(open_file_contents(&contents, job->local_abspath, job->properties,
+                             scratch_pool));
+  contents = svn_stream_checksummed2(contents, &job->md5_checksum, NULL,
+                                     svn_checksum_md5, TRUE, job->pool);
+
+  return svn_error_trace(svn_stream_copy3(contents,
+                                          svn_stream__from_spillbuf(
+                                            job->contents, scratch_pool),
+                                          NULL, NULL, scratch_pool));
+}
+
+/* Implements svn_worker_pool__item_func_t.  ITEM is an
+   import_text_job_t. */
+static svn_error_t *
+import_text_job(void *item,
+                void *thread_baton,
+                apr_pool_t *scratch_pool)
+{
+  return svn_error_trace(prepare_import_text(item, scratch_pool));
+}
+
+/* Implements svn_worker_pool__release_func_t.  Release the
+   import_text_job_t in ITEM and everything it owns, but not its file
+   baton.  The file pools are subpools of the queue's pool and get
+   destroyed with it. */
+static void
+import_text_job_destroy(void *item)
+{
+  import_text_job_t *job = item;
+
+  svn_pool_destroy(job->pool);
+}
+
+/* Set *QUEUE to a new import text queue with THREADS workers sending the
+   file contents to EDITOR, allocated in RESULT_POOL.  Use the cancellation
+   callback of CTX.  Set *QUEUE to NULL if no worker could be started. */
+static svn_error_t *
+import_text_queue_create(import_text_queue_t **queue,
+                         int threads,
+                         const svn_delta_editor_t *editor,
+                         svn_client_ctx_t *ctx,
+                         apr_pool_t *result_pool)
+{
+  import_text_queue_t *result = apr_pcalloc(result_pool, sizeof(*result));
+
+  result->editor = editor;
+  result->cancel_func = ctx->cancel_func;
+  result->cancel_baton = ctx->cancel_baton;
+  result->pool = result_pool;
+
+  threads = MIN(threads, IMPORT_TEXT_QUEUE_MAX_THREADS);
+  SVN_ERR(svn_worker_pool__ordered_create(&result->jobs, threads,
+                                          2 * threads, NULL, import_text_job,
+                                          import_text_job_destroy, NULL,
+                                          result_pool));
+
+  *queue = result->jobs ? result : NULL;
+  return SVN_NO_ERROR;
+}
+
+/* Send the contents of JOB of QUEUE, whose preparation returned ERR, to
+   its file, close the file and release JOB.  Use SCRATCH_POOL for
+   temporary allocations. */
+static svn_error_t *
+import_text_job_send(import_text_queue_t *queue,
+                     import_text_job_t *job,
+                     svn_error_t *err,
+                     apr_pool_t *scratch_pool)
+{
+  svn_txdelta_window_handler_t handler;
+  void *handler_baton;
+
+  /* The window-based variant lets the RA layer buffer the delta and
+     return before the server has received it. */
+  if (!err)
+    err = queue->editor->apply_textdelta(job->file_baton, NULL,
+                                         scratch_pool, &handler,
+                                         &handler_baton);
+  if (!err)
+    err = svn_txdelta_send_stream(svn_stream__from_spillbuf(job->contents,
+                                                            scratch_pool),
+                                  handler, handler_baton, NULL,
+                                  scratch_pool);
+  if (!err)
+    err = queue->editor->close_file(job->file_baton,
+                                    svn_checksum_to_cstring(
+                                      job->md5_checksum, scratch_pool),
+                                    scratch_pool);
+
+  svn_pool_destroy(job->file_pool);
+  import_text_job_destroy(job);
+  SVN_ERR(err);
+
+  if (queue->cancel_func)
+    SVN_ERR(queue->cancel_func(queue->cancel_baton));
+
+  return SVN_NO_ERROR;
+}
+
+/* Send and close the files in QUEUE, in order, as long as they are
+   prepared already or QUEUE can't hold them anymore.  If WAIT is set,
+   send all of them.  Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+import_text_queue_send(import_text_queue_t *queue,
+                       svn_boolean_t wait,
+                       apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+
+  while (TRUE)
+    {
+      void *job;
+      svn_error_t *err;
+
+      svn_pool_clear(iterpool);
+
+      SVN_ERR(svn_worker_pool__ordered_take(&job, &err, queue->jobs, wait));
+      if (!job)
+        break;
+
+      SVN_ERR(import_text_job_send(queue, job, err, iterpool));
+    }
+
+  svn_pool_destroy(iterpool);
+  return SVN_NO_ERROR;
+}
+
+/* Queue the contents of LOCAL_ABSPATH, detranslated according to
+   PROPERTIES, to be sent to the open file FILE_BATON in QUEUE.  FILE_POOL
+   is the pool FILE_BATON has been added in; QUEUE takes over ownership.
+   Send and close all files that are prepared already, as well as those
+   that QUEUE can't hold anymore.  Use SCRATCH_POOL for temporary
+   allocations. */
+static svn_error_t *
+import_text_queue_add(import_text_queue_t *queue,
+                      const char *local_abspath,
+                      apr_hash_t *properties,
+                      void *file_baton,
+                      apr_pool_t *file_pool,
+                      apr_pool_t *scratch_pool)
+{
+  apr_pool_t *pool
+    = apr_allocator_owner_get(svn_pool_create_allocator(FALSE));
+  import_text_job_t *job = apr_pcalloc(pool, sizeof(*job));
+
+  job->local_abspath = apr_pstrdup(pool, local_abspath);
+  job->properties = apr_hash_make(pool);
+  job->pool = pool;
+  job->file_baton = file_baton;
+  job->file_pool = file_pool;
+
+  /* Only these properties affect the detranslation. */
+  if (properties)
+    {
+      const char *names[] = { SVN_PROP_EOL_STYLE, SVN_PROP_KEYWORDS,
+                              SVN_PROP_SPECIAL };
+      apr_size_t i;
+
+      for (i = 0; i < sizeof(names) / sizeof(names[0]); i++)
+        {
+          const svn_string_t *value = svn_hash_gets(properties, names[i]);
+
+          if (value)
+            svn_hash_sets(job->properties, names[i],
+                          svn_string_dup(value, pool));
+        }
+    }
+
+  SVN_ERR(svn_worker_pool__ordered_add(queue->jobs, job));
+
+  return svn_error_trace(import_text_queue_send(queue, FALSE, scratch_pool));
+}
+
+/* Send the contents of all files queued in QUEUE, in order, and close
+   them.  Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+import_text_queue_finish(import_text_queue_t *queue,
+                         apr_pool_t *scratch_pool)
+{
+  return svn_error_trace(import_text_queue_send(queue, TRUE, scratch_pool));
+}
+
+#endif /* APR_HAS_THREADS */
+
+
 /* Import file PATH as EDIT_PATH in the repository directory indicated
  * by DIR_BATON in EDITOR.
  *
@@ -232,12 +522,19 @@ import_file(const svn_delta_editor_t *editor,
   const char *text_checksum;
   apr_hash_t* properties;
   apr_hash_index_t *hi;
+  apr_pool_t *file_pool = pool;
 
   SVN_ERR(svn_path_check_valid(local_abspath, pool));
 
+#if APR_HAS_THREADS
+  /* Queued files stay open after we return. */
+  if (import_ctx->text_queue)
+    file_pool = svn_pool_create(import_ctx->text_queue->pool);
+#endif
+
   /* Add the file, using the pool from the FILES hash. */
   SVN_ERR(editor->add_file(edit_path, dir_baton, NULL, SVN_INVALID_REVNUM,
-                           pool, &file_baton));
+                           file_pool, &file_baton));
 
   /* Remember that the repository was modified */
   import_ctx->repos_changed = TRUE;
@@ -291,6 +588,15 @@ import_file(const svn_delta_editor_t *editor,
                                        pool));
     }
 
+#if APR_HAS_THREADS
+  /* Let the queue transmit the contents and close the file. */
+  if (import_ctx->text_queue)
+    return svn_error_trace(import_text_queue_add(import_ctx->text_queue,
+                                                 local_abspath, properties,
+                                                 file_baton, file_pool,
+                                                 pool));
+#endif
+
   /* Now, transmit the file contents. */
   SVN_ERR(send_file_contents(&result_md5_checksum, local_abspath,
                              file_baton, editor, properties, pool));
@@ -693,6 +999,24 @@ import(svn_boolean_t *updated_repository,
   import_ctx.autoprops = autoprops;
   SVN_ERR(svn_magic__init(&import_ctx.magic_cookie, ctx->config, pool));
 
+#if APR_HAS_THREADS
+  {
+    svn_config_t *cfg;
+    apr_int64_t import_threads;
+
+    cfg = ctx->config ? svn_hash_gets(ctx->config, SVN_CONFIG_CATEGORY_CONFIG)
+                      : NULL;
+    SVN_ERR(svn_config_get_int64(cfg, &import_threads,
+                                 SVN_CONFIG_SECTION_MISCELLANY,
+                                 SVN_CONFIG_OPTION_IMPORT_THREADS, 1));
+    if (import_threads > 1)
+      SVN_ERR(import_text_queue_create(&import_ctx.text_queue,
+                                       (int)MIN(import_threads,
+                                                IMPORT_TEXT_QUEUE_MAX_THREADS),
+                                       editor, ctx, pool));
+  }
+#endif
+
   /* Get a root dir baton.  We pass the revnum we used for testing our
      assumptions and obtaining inherited properties. */
   SVN_ERR(editor->open_root(edit_baton, base_rev, pool, &root_baton));
@@ -799,6 +1123,12 @@ import(svn_boolean_t *updated_repository,
         }
     }
 
+#if APR_HAS_THREADS
+  /* Send the contents of the files still open. */
+  if (import_ctx.text_queue)
+    SVN_ERR(import_text_queue_finish(import_ctx.text_queue, pool));
+#endif
+
   if (import_ctx.repos_changed)
     {
       if (ctx->notify_func2)
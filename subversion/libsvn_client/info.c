@@ -29,6 +29,7 @@
 #include "svn_client.h"
 #include "svn_dirent_uri.h"
 #include "svn_hash.h"
+#include "svn_path.h"
 #include "svn_pools.h"
 #include "svn_sorts.h"
 
@@ -36,6 +37,7 @@
 
 #include "svn_private_config.h"
 #include "private/svn_fspath.h"
+#include "private/svn_ra_private.h"
 #include "private/svn_sorts_private.h"
 #include "private/svn_wc_private.h"
 
@@ -322,6 +324,96 @@ wc_info_receiver(void *baton,
                                  abspath_or_url, &client_info, scratch_pool);
 }
 
+/* Push the info for PATHREV with dirent THE_ENT at RECEIVER, followed
+   by its children down to DEPTH.  RA_SESSION is an open RA session for
+   PATHREV->URL.
+
+   If LOCK_KNOWN is set, LOCK is the (possibly NULL) lock on the node;
+   otherwise, look that up.  PEG_KIND is the kind of the peg revision
+   that PATHREV was found in.  Use POOL for temporary allocations. */
+static svn_error_t *
+push_repos_info(svn_ra_session_t *ra_session,
+                const svn_client__pathrev_t *pathrev,
+                const svn_dirent_t *the_ent,
+                svn_boolean_t lock_known,
+                svn_lock_t *lock,
+                enum svn_opt_revision_kind peg_kind,
+                svn_depth_t depth,
+                svn_client_info_receiver2_t receiver,
+                void *receiver_baton,
+                svn_client_ctx_t *ctx,
+                apr_pool_t *pool)
+{
+  svn_boolean_t related;
+  svn_client_info2_t *info;
+  svn_error_t *err;
+
+  /* Check if the URL exists in HEAD and refers to the same resource.
+     In this case, we check the repository for a lock on this URL.
+
+     ### There is a possible race here, since HEAD might have changed since
+     ### we checked it.  A solution to this problem could be to do the below
+     ### check in a loop which only terminates if the HEAD revision is the same
+     ### before and after this check.  That could, however, lead to a
+     ### starvation situation instead.  */
+  if (!lock_known)
+    {
+      SVN_ERR(same_resource_in_head(&related, pathrev->url, pathrev->rev,
+                                    ra_session, ctx, pool));
+      if (related)
+        {
+          err = svn_ra_get_lock(ra_session, &lock, "", pool);
+
+          /* An old mod_dav_svn will always work; there's nothing wrong
+             with doing a PROPFIND for a property named
+             "DAV:supportedlock". But an old svnserve will error. */
+          if (err && err->apr_err == SVN_ERR_RA_NOT_IMPLEMENTED)
+            {
+              svn_error_clear(err);
+              lock = NULL;
+            }
+          else if (err)
+            return svn_error_trace(err);
+        }
+      else
+        lock = NULL;
+    }
+
+  /* Push the URL's dirent (and lock) at the callback.*/
+  SVN_ERR(build_info_from_dirent(&info, the_ent, lock, pathrev, pool));
+  SVN_ERR(receiver(receiver_baton, svn_uri_basename(pathrev->url, pool),
+                   info, pool));
+
+  /* Possibly recurse, using the original RA session. */
+  if (depth > svn_depth_empty && (the_ent->kind == svn_node_dir))
+    {
+      apr_hash_t *locks;
+
+      if (peg_kind == svn_opt_revision_head)
+        {
+          err = svn_ra_get_locks2(ra_session, &locks, "", depth,
+                                  pool);
+
+          /* Catch specific errors thrown by old mod_dav_svn or svnserve. */
+          if (err && err->apr_err == SVN_ERR_RA_NOT_IMPLEMENTED)
+            {
+              svn_error_clear(err);
+              locks = apr_hash_make(pool); /* use an empty hash */
+            }
+          else if (err)
+            return svn_error_trace(err);
+        }
+      else
+        locks = apr_hash_make(pool); /* use an empty hash */
+
+      SVN_ERR(push_dir_info(ra_session, pathrev, "",
+                            receiver, receiver_baton,
+                            depth, ctx, locks, pool));
+    }
+
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *
 svn_client_info4(const char *abspath_or_url,
                  const svn_opt_revision_t *peg_revision,
@@ -338,12 +430,7 @@ svn_client_info4(const char *abspath_or_url,
 {
   svn_ra_session_t *ra_session;
   svn_client__pathrev_t *pathrev;
-  svn_lock_t *lock;
-  svn_boolean_t related;
-  const char *base_name;
   svn_dirent_t *the_ent;
-  svn_client_info2_t *info;
-  svn_error_t *err;
 
   if (depth == svn_depth_unknown)
     depth = svn_depth_empty;
@@ -384,11 +471,20 @@ svn_client_info4(const char *abspath_or_url,
 
   /* Trace rename history (starting at path_or_url@peg_revision) and
      return RA session to the possibly-renamed URL as it exists in REVISION.
-     The ra_session returned will be anchored on this "final" URL. */
-  SVN_ERR(svn_client__ra_session_from_path2(&ra_session, &pathrev,
-                                            abspath_or_url, NULL, peg_revision,
-                                            revision, ctx, pool));
-  base_name = svn_uri_basename(pathrev->url, pool);
+     The ra_session returned will be anchored on this "final" URL.
+     Repository URLs don't need working copy context, so take a pooled
+     session for them.  Then info on several URLs of the same repository
+     doesn't need a new connection each. */
+  if (svn_path_is_url(abspath_or_url))
+    SVN_ERR(svn_client__pooled_ra_session_from_path(&ra_session, &pathrev,
+                                                    abspath_or_url,
+                                                    peg_revision, revision,
+                                                    ctx, pool));
+  else
+    SVN_ERR(svn_client__ra_session_from_path2(&ra_session, &pathrev,
+                                              abspath_or_url, NULL,
+                                              peg_revision, revision,
+                                              ctx, pool));
 
   /* Get the dirent for the URL itself. */
   SVN_ERR(svn_ra_stat(ra_session, "", pathrev->rev, &the_ent, pool));
@@ -398,65 +494,134 @@ svn_client_info4(const char *abspath_or_url,
                              _("URL '%s' non-existent in revision %ld"),
                              pathrev->url, pathrev->rev);
 
-  /* Check if the URL exists in HEAD and refers to the same resource.
-     In this case, we check the repository for a lock on this URL.
+  return svn_error_trace(push_repos_info(ra_session, pathrev, the_ent,
+                                         FALSE, NULL, peg_revision->kind,
+                                         depth, receiver, receiver_baton,
+                                         ctx, pool));
+}
 
-     ### There is a possible race here, since HEAD might have changed since
-     ### we checked it.  A solution to this problem could be to do the below
-     ### check in a loop which only terminates if the HEAD revision is the same
-     ### before and after this check.  That could, however, lead to a
-     ### starvation situation instead.  */
-  SVN_ERR(same_resource_in_head(&related, pathrev->url, pathrev->rev,
-                                ra_session, ctx, pool));
-  if (related)
-    {
-      err = svn_ra_get_lock(ra_session, &lock, "", pool);
+svn_error_t *
+svn_client_info_many(const apr_array_header_t *urls,
+                     const svn_opt_revision_t *peg_revision,
+                     svn_depth_t depth,
+                     svn_client_info_receiver2_t receiver,
+                     void *receiver_baton,
+                     svn_client_ctx_t *ctx,
+                     apr_pool_t *scratch_pool)
+{
+  svn_opt_revision_t peg_rev = *peg_revision;
+  apr_pool_t *batch_pool = svn_pool_create(scratch_pool);
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  int i = 0;
+
+  if (depth == svn_depth_unknown)
+    depth = svn_depth_empty;
+  if (peg_rev.kind == svn_opt_revision_unspecified)
+    peg_rev.kind = svn_opt_revision_head;
+
+  if (SVN_CLIENT__REVKIND_NEEDS_WC(peg_rev.kind))
+    return svn_error_create(SVN_ERR_CLIENT_BAD_REVISION, NULL, NULL);
 
-      /* An old mod_dav_svn will always work; there's nothing wrong with
-         doing a PROPFIND for a property named "DAV:supportedlock". But
-         an old svnserve will error. */
-      if (err && err->apr_err == SVN_ERR_RA_NOT_IMPLEMENTED)
+  while (i < urls->nelts)
+    {
+      svn_ra_session_t *ra_session;
+      const char *session_url, *repos_root_url, *repos_uuid;
+      apr_array_header_t *relpaths;
+      apr_hash_t *dirents, *locks;
+      svn_revnum_t rev;
+      svn_boolean_t want_locks;
+      int first = i;
+      int j;
+
+      svn_pool_clear(batch_pool);
+
+      SVN_ERR(svn_client__ra_session_acquire(&ra_session,
+                                             APR_ARRAY_IDX(urls, i,
+                                                           const char *),
+                                             ctx, batch_pool, batch_pool));
+      SVN_ERR(svn_ra_get_repos_root2(ra_session, &repos_root_url,
+                                     batch_pool));
+      SVN_ERR(svn_ra_get_uuid2(ra_session, &repos_uuid, batch_pool));
+      SVN_ERR(svn_client__get_revision_number(&rev, NULL, ctx->wc_ctx, NULL,
+                                              ra_session, &peg_rev,
+                                              batch_pool));
+
+      /* The session may have followed a redirect for the first URL. */
+      SVN_ERR(svn_ra_get_session_url(ra_session, &session_url, batch_pool));
+      relpaths = apr_array_make(batch_pool, urls->nelts - i,
+                                sizeof(const char *));
+      APR_ARRAY_PUSH(relpaths, const char *)
+        = svn_uri_skip_ancestor(repos_root_url, session_url, batch_pool);
+
+      /* Batch all directly following URLs of the same repository. */
+      for (j = i + 1; j < urls->nelts; j++)
         {
-          svn_error_clear(err);
-          lock = NULL;
+          const char *relpath
+            = svn_uri_skip_ancestor(repos_root_url,
+                                    APR_ARRAY_IDX(urls, j, const char *),
+                                    batch_pool);
+          if (!relpath)
+            break;
+
+          APR_ARRAY_PUSH(relpaths, const char *) = relpath;
         }
-      else if (err)
-        return svn_error_trace(err);
-    }
-  else
-    lock = NULL;
 
-  /* Push the URL's dirent (and lock) at the callback.*/
-  SVN_ERR(build_info_from_dirent(&info, the_ent, lock, pathrev, pool));
-  SVN_ERR(receiver(receiver_baton, base_name, info, pool));
+      /* Locks are looked up in HEAD.  For older revisions, we have to
+         check whether the node still is the same one first. */
+      want_locks = (peg_rev.kind == svn_opt_revision_head);
 
-  /* Possibly recurse, using the original RA session. */
-  if (depth > svn_depth_empty && (the_ent->kind == svn_node_dir))
-    {
-      apr_hash_t *locks;
+      SVN_ERR(svn_ra_reparent(ra_session, repos_root_url, batch_pool));
+      SVN_ERR(svn_ra__stat_many(&dirents, want_locks ? &locks : NULL,
+                                ra_session, relpaths, rev,
+                                batch_pool, batch_pool));
 
-      if (peg_revision->kind == svn_opt_revision_head)
+      for (; i < j; i++)
         {
-          err = svn_ra_get_locks2(ra_session, &locks, "", depth,
-                                  pool);
+          const char *relpath = APR_ARRAY_IDX(relpaths, i - first,
+                                              const char *);
+          svn_dirent_t *the_ent = svn_hash_gets(dirents, relpath);
+          svn_client__pathrev_t *pathrev;
 
-          /* Catch specific errors thrown by old mod_dav_svn or svnserve. */
-          if (err && err->apr_err == SVN_ERR_RA_NOT_IMPLEMENTED)
+          svn_pool_clear(iterpool);
+
+          if (ctx->cancel_func)
+            SVN_ERR(ctx->cancel_func(ctx->cancel_baton));
+
+          pathrev = svn_client__pathrev_create_with_relpath(repos_root_url,
+                                                            repos_uuid, rev,
+                                                            relpath,
+                                                            iterpool);
+          if (!the_ent)
             {
-              svn_error_clear(err);
-              locks = apr_hash_make(pool); /* use an empty hash */
+              svn_client_info2_t *info = apr_pcalloc(iterpool,
+                                                     sizeof(*info));
+
+              info->URL = pathrev->url;
+              info->rev = pathrev->rev;
+              info->kind = svn_node_none;
+              info->repos_root_URL = pathrev->repos_root_url;
+              info->repos_UUID = pathrev->repos_uuid;
+              info->last_changed_rev = SVN_INVALID_REVNUM;
+              info->size = SVN_INVALID_FILESIZE;
+
+              SVN_ERR(receiver(receiver_baton, pathrev->url, info,
+                               iterpool));
+              continue;
             }
-          else if (err)
-            return svn_error_trace(err);
-        }
-      else
-        locks = apr_hash_make(pool); /* use an empty hash */
 
-      SVN_ERR(push_dir_info(ra_session, pathrev, "",
-                            receiver, receiver_baton,
-                            depth, ctx, locks, pool));
+          SVN_ERR(svn_ra_reparent(ra_session, pathrev->url, iterpool));
+          SVN_ERR(push_repos_info(ra_session, pathrev, the_ent,
+                                  want_locks,
+                                  want_locks ? svn_hash_gets(locks, relpath)
+                                             : NULL,
+                                  peg_rev.kind, depth,
+                                  receiver, receiver_baton, ctx, iterpool));
+        }
     }
 
+  svn_pool_destroy(iterpool);
+  svn_pool_destroy(batch_pool);
+
   return SVN_NO_ERROR;
 }
 
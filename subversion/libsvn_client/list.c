@@ -46,6 +46,7 @@ static svn_error_t *
 list_externals(apr_hash_t *externals,
                const apr_array_header_t *patterns,
                svn_depth_t depth,
+               svn_revnum_t since_rev,
                apr_uint32_t dirent_fields,
                svn_boolean_t fetch_locks,
                svn_client_list_func2_t list_func,
@@ -59,6 +60,7 @@ list_internal(const char *path_or_url,
               const svn_opt_revision_t *revision,
               const apr_array_header_t *patterns,
               svn_depth_t depth,
+              svn_revnum_t since_rev,
               apr_uint32_t dirent_fields,
               svn_boolean_t fetch_locks,
               svn_boolean_t include_externals,
@@ -82,6 +84,16 @@ match_patterns(const char *s,
        : TRUE;
 }
 
+/* Return TRUE if DIRENT did not change in SINCE_REV or later. */
+static svn_boolean_t
+unchanged_since(const svn_dirent_t *dirent,
+                svn_revnum_t since_rev)
+{
+  return SVN_IS_VALID_REVNUM(since_rev)
+      && SVN_IS_VALID_REVNUM(dirent->created_rev)
+      && dirent->created_rev < since_rev;
+}
+
 /* Get the directory entries of DIR at REV (relative to the root of
    RA_SESSION), getting at least the fields specified by DIRENT_FIELDS.
    Use the cancellation function/baton of CTX to check for cancellation.
@@ -96,6 +108,10 @@ match_patterns(const char *s,
    one of const char * patterns in it or the respective dirent will not
    be reported.
 
+   If SINCE_REV is valid, skip all entries that did not change since that
+   revision, including whole sub-trees.  DIRENT_FIELDS must contain
+   SVN_DIRENT_CREATED_REV in that case.
+
    LOCKS, if non-NULL, is a hash mapping const char * paths to svn_lock_t
    objects and FS_PATH is the absolute filesystem path of the RA session.
    Use SCRATCH_POOL for temporary allocations.
@@ -119,6 +135,7 @@ get_dir_contents(apr_uint32_t dirent_fields,
                  const char *fs_path,
                  const apr_array_header_t *patterns,
                  svn_depth_t depth,
+                 svn_revnum_t since_rev,
                  svn_client_ctx_t *ctx,
                  apr_hash_t *externals,
                  const char *external_parent_url,
@@ -187,6 +204,10 @@ get_dir_contents(apr_uint32_t dirent_fields,
 
       svn_pool_clear(iterpool);
 
+      /* Nothing changed in this sub-tree since SINCE_REV. */
+      if (unchanged_since(the_ent, since_rev))
+        continue;
+
       path = svn_relpath_join(dir, item->key, iterpool);
 
       if (locks)
@@ -208,8 +229,8 @@ get_dir_contents(apr_uint32_t dirent_fields,
          recursively for all directory entries. */
       if (depth == svn_depth_infinity && the_ent->kind == svn_node_dir)
         SVN_ERR(get_dir_contents(dirent_fields, path, rev, ra_session,
-                                 locks, fs_path, patterns, depth, ctx,
-                                 externals, external_parent_url,
+                                 locks, fs_path, patterns, depth, since_rev,
+                                 ctx, externals, external_parent_url,
                                  external_target, list_func, baton,
                                  scratch_buffer, result_pool, iterpool));
     }
@@ -281,6 +302,9 @@ list_receiver(const char *rel_path,
    one of const char * patterns in it or the respective dirent will not
    be reported.
 
+   If SINCE_REV is valid, only report entries that changed in that
+   revision or later and skip unchanged sub-trees.
+
    DIRENT_FIELDS controls which fields in the svn_dirent_t's are
    filled in.  To have them totally filled in use SVN_DIRENT_ALL,
    otherwise simply bitwise OR together the combination of SVN_DIRENT_*
@@ -309,6 +333,7 @@ list_internal(const char *path_or_url,
               const svn_opt_revision_t *revision,
               const apr_array_header_t *patterns,
               svn_depth_t depth,
+              svn_revnum_t since_rev,
               apr_uint32_t dirent_fields,
               svn_boolean_t fetch_locks,
               svn_boolean_t include_externals,
@@ -337,11 +362,18 @@ list_internal(const char *path_or_url,
      always need it. */
   dirent_fields |= SVN_DIRENT_KIND;
 
-  /* Get an RA plugin for this filesystem object. */
-  SVN_ERR(svn_client__ra_session_from_path2(&ra_session, &loc,
-                                            path_or_url, NULL,
-                                            peg_revision,
-                                            revision, ctx, pool));
+  /* Get an RA plugin for this filesystem object.  URLs don't need working
+     copy context, so listing several of them can share a pooled session. */
+  if (svn_path_is_url(path_or_url))
+    SVN_ERR(svn_client__pooled_ra_session_from_path(&ra_session, &loc,
+                                                    path_or_url,
+                                                    peg_revision,
+                                                    revision, ctx, pool));
+  else
+    SVN_ERR(svn_client__ra_session_from_path2(&ra_session, &loc,
+                                              path_or_url, NULL,
+                                              peg_revision,
+                                              revision, ctx, pool));
 
   fs_path = svn_client__pathrev_fspath(loc, pool);
 
@@ -373,8 +405,9 @@ list_internal(const char *path_or_url,
       receiver_baton.locks = locks;
       receiver_baton.fs_base_path = fs_path;
 
-      err = svn_ra_list(ra_session, "", loc->rev, patterns, depth,
-                        dirent_fields, list_receiver, &receiver_baton, pool);
+      err = svn_ra_list2(ra_session, "", loc->rev, patterns, depth,
+                         since_rev, dirent_fields, list_receiver,
+                         &receiver_baton, pool);
 
       if (svn_error_find_cause(err, SVN_ERR_UNSUPPORTED_FEATURE))
         svn_error_clear(err);
@@ -389,6 +422,15 @@ list_internal(const char *path_or_url,
                              _("URL '%s' non-existent in revision %ld"),
                              loc->url, loc->rev);
 
+  /* Nothing changed in the whole tree since SINCE_REV. */
+  if (unchanged_since(dirent, since_rev))
+    return SVN_NO_ERROR;
+
+  /* We need the created revisions to skip unchanged sub-trees.  Reporting
+     them to callers that did not ask for them does no harm. */
+  if (SVN_IS_VALID_REVNUM(since_rev))
+    dirent_fields |= SVN_DIRENT_CREATED_REV;
+
   /* We need a scratch buffer for temporary string data.
    * Create one with a reasonable initial size. */
   svn_membuf__create(&scratch_buffer, 256, pool);
@@ -406,7 +448,8 @@ list_internal(const char *path_or_url,
           || depth == svn_depth_immediates
           || depth == svn_depth_infinity))
     SVN_ERR(get_dir_contents(dirent_fields, "", loc->rev, ra_session, locks,
-                             fs_path, patterns, depth, ctx, externals,
+                             fs_path, patterns, depth, since_rev, ctx,
+                             externals,
                              external_parent_url, external_target, list_func,
                              baton, &scratch_buffer, pool, pool));
 
@@ -417,8 +460,8 @@ list_internal(const char *path_or_url,
     {
       /* The 'externals' hash populated by get_dir_contents() is processed
          here. */
-      SVN_ERR(list_externals(externals, patterns, depth, dirent_fields,
-                             fetch_locks, list_func, baton,
+      SVN_ERR(list_externals(externals, patterns, depth, since_rev,
+                             dirent_fields, fetch_locks, list_func, baton,
                              ctx, pool));
     }
 
@@ -456,6 +499,7 @@ list_external_items(apr_array_header_t *external_items,
                     const char *externals_parent_url,
                     const apr_array_header_t *patterns,
                     svn_depth_t depth,
+                    svn_revnum_t since_rev,
                     apr_uint32_t dirent_fields,
                     svn_boolean_t fetch_locks,
                     svn_client_list_func2_t list_func,
@@ -496,7 +540,7 @@ list_external_items(apr_array_header_t *external_items,
                                             &item->peg_revision,
                                             &item->revision,
                                             patterns,
-                                            depth, dirent_fields,
+                                            depth, since_rev, dirent_fields,
                                             fetch_locks,
                                             TRUE,
                                             externals_parent_url,
@@ -520,6 +564,7 @@ static svn_error_t *
 list_externals(apr_hash_t *externals,
                const apr_array_header_t *patterns,
                svn_depth_t depth,
+               svn_revnum_t since_rev,
                apr_uint32_t dirent_fields,
                svn_boolean_t fetch_locks,
                svn_client_list_func2_t list_func,
@@ -549,7 +594,7 @@ list_externals(apr_hash_t *externals,
         continue;
 
       SVN_ERR(list_external_items(external_items, externals_parent_url,
-                                  patterns, depth, dirent_fields,
+                                  patterns, depth, since_rev, dirent_fields,
                                   fetch_locks, list_func, baton, ctx,
                                   iterpool));
 
@@ -561,11 +606,12 @@ list_externals(apr_hash_t *externals,
 
 
 svn_error_t *
-svn_client_list4(const char *path_or_url,
+svn_client_list5(const char *path_or_url,
                  const svn_opt_revision_t *peg_revision,
                  const svn_opt_revision_t *revision,
                  const apr_array_header_t *patterns,
                  svn_depth_t depth,
+                 svn_revnum_t since_rev,
                  apr_uint32_t dirent_fields,
                  svn_boolean_t fetch_locks,
                  svn_boolean_t include_externals,
@@ -577,7 +623,7 @@ svn_client_list4(const char *path_or_url,
 
   return svn_error_trace(list_internal(path_or_url, peg_revision,
                                        revision, patterns,
-                                       depth, dirent_fields,
+                                       depth, since_rev, dirent_fields,
                                        fetch_locks,
                                        include_externals,
                                        NULL, NULL, list_func,
@@ -8518,6 +8518,7 @@ record_mergeinfo_for_dir_merge(svn_mergeinfo_catalog_t result_catalog,
   int i;
   svn_boolean_t is_rollback = (merged_range->start > merged_range->end);
   svn_boolean_t operative_merge;
+  apr_array_header_t *elide_abspaths;
 
   /* Update the WC mergeinfo here to account for our new
      merges, minus any unresolved conflicts and skips. */
@@ -8552,7 +8553,10 @@ record_mergeinfo_for_dir_merge(svn_mergeinfo_catalog_t result_catalog,
                                           mergeinfo_fspath, depth,
                                           merge_b, iterpool));
 
-  /* ...and then record it. */
+  /* ...and then record it.  Subtrees that may elide only as far as the
+     merge target get collected in ELIDE_ABSPATHS and are handled in a
+     single pass afterwards. */
+  elide_abspaths = apr_array_make(scratch_pool, 0, sizeof(const char *));
   for (i = 0; i < children_with_mergeinfo->nelts; i++)
     {
       const char *child_repos_path;
@@ -8757,13 +8761,20 @@ record_mergeinfo_for_dir_merge(svn_mergeinfo_catalog_t result_catalog,
              repository. Otherwise limit elision to the merge target
              for now.  do_merge() will eventually try to
              elide that when the merge is complete. */
-          SVN_ERR(svn_client__elide_mergeinfo(
-            child->abspath,
-            in_switched_subtree ? NULL : merge_b->target->abspath,
-            merge_b->ctx, iterpool));
+          if (in_switched_subtree)
+            SVN_ERR(svn_client__elide_mergeinfo(child->abspath, NULL,
+                                                merge_b->ctx, iterpool));
+          else
+            APR_ARRAY_PUSH(elide_abspaths, const char *) = child->abspath;
         }
     } /* (i = 0; i < notify_b->children_with_mergeinfo->nelts; i++) */
 
+  /* The elision of a subtree depends only on its ancestors, which are
+     all final by now. */
+  SVN_ERR(svn_client__elide_mergeinfo_many(elide_abspaths,
+                                           merge_b->target->abspath,
+                                           merge_b->ctx, iterpool));
+
   svn_pool_destroy(iterpool);
   return SVN_NO_ERROR;
 }
@@ -12578,15 +12589,15 @@ find_automatic_merge_no_wc(automatic_merge_t **merge_p,
   automatic_merge_t *merge = apr_palloc(result_pool, sizeof(*merge));
 
   /* Source */
-  SVN_ERR(svn_client__ra_session_from_path2(
+  SVN_ERR(svn_client__pooled_ra_session_from_path(
             &s_t->source_ra_session, &s_t->source,
-            source_path_or_url, NULL, source_revision, source_revision,
+            source_path_or_url, source_revision, source_revision,
             ctx, result_pool));
 
   /* Target */
-  SVN_ERR(svn_client__ra_session_from_path2(
+  SVN_ERR(svn_client__pooled_ra_session_from_path(
             &s_t->target_ra_session, &target_loc,
-            target_path_or_url, NULL, target_revision, target_revision,
+            target_path_or_url, target_revision, target_revision,
             ctx, result_pool));
   s_t->target = apr_palloc(scratch_pool, sizeof(*s_t->target));
   s_t->target->abspath = NULL;  /* indicate the target is not a WC */
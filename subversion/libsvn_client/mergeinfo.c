@@ -684,9 +684,9 @@ svn_client__get_wc_or_repos_mergeinfo_catalog(
               if (! ra_session)
                 {
                   sesspool = svn_pool_create(scratch_pool);
-                  SVN_ERR(svn_client_open_ra_session2(&ra_session, url, NULL,
-                                                      ctx,
-                                                      sesspool, sesspool));
+                  SVN_ERR(svn_client__ra_session_acquire(&ra_session, url,
+                                                         ctx, sesspool,
+                                                         sesspool));
                 }
 
               SVN_ERR(svn_client__get_repos_mergeinfo_catalog(
@@ -1006,6 +1006,229 @@ svn_client__elide_mergeinfo(const char *target_abspath,
   return SVN_NO_ERROR;
 }
 
+/* The explicit mergeinfo of a working copy node, as read by
+   svn_client__elide_mergeinfo_many(). */
+typedef struct cached_mergeinfo_t
+{
+  /* The parsed svn:mergeinfo property; NULL if there is none.  Empty if
+     the property could not be parsed. */
+  svn_mergeinfo_t mergeinfo;
+
+  /* Whether the property could not be parsed. */
+  svn_boolean_t invalid;
+} cached_mergeinfo_t;
+
+/* Set *RESULT to the explicit mergeinfo of LOCAL_ABSPATH, reading it
+   into CACHE only if it is not there already.  CACHE maps abspaths to
+   cached_mergeinfo_t * and is allocated in CACHE_POOL.  Use SCRATCH_POOL
+   for temporary allocations. */
+static svn_error_t *
+get_cached_mergeinfo(cached_mergeinfo_t **result,
+                     apr_hash_t *cache,
+                     const char *local_abspath,
+                     svn_client_ctx_t *ctx,
+                     apr_pool_t *cache_pool,
+                     apr_pool_t *scratch_pool)
+{
+  cached_mergeinfo_t *entry = svn_hash_gets(cache, local_abspath);
+  svn_error_t *err;
+
+  if (!entry)
+    {
+      entry = apr_pcalloc(cache_pool, sizeof(*entry));
+      err = svn_client__parse_mergeinfo(&entry->mergeinfo, ctx->wc_ctx,
+                                        local_abspath, cache_pool,
+                                        scratch_pool);
+      if (err && err->apr_err == SVN_ERR_MERGEINFO_PARSE_ERROR)
+        {
+          svn_error_clear(err);
+          entry->mergeinfo = apr_hash_make(cache_pool);
+          entry->invalid = TRUE;
+        }
+      else
+        SVN_ERR(err);
+
+      svn_hash_sets(cache, apr_pstrdup(cache_pool, local_abspath), entry);
+    }
+
+  *result = entry;
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *MERGEINFO to the mergeinfo that LOCAL_ABSPATH inherits from its
+   nearest working copy ancestor with explicit mergeinfo, not looking
+   above LIMIT_ABSPATH.  Set it to NULL if there is none.  Get explicit
+   mergeinfo through CACHE and CACHE_POOL, see get_cached_mergeinfo().
+
+   This is what svn_client__get_wc_mergeinfo() returns for
+   svn_mergeinfo_nearest_ancestor.  Allocate *MERGEINFO in RESULT_POOL.
+   Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+get_nearest_wc_mergeinfo(svn_mergeinfo_t *mergeinfo,
+                         apr_hash_t *cache,
+                         const char *local_abspath,
+                         const char *limit_abspath,
+                         svn_client_ctx_t *ctx,
+                         apr_pool_t *cache_pool,
+                         apr_pool_t *result_pool,
+                         apr_pool_t *scratch_pool)
+{
+  const char *walk_relpath = "";
+  cached_mergeinfo_t *parent = NULL;
+  svn_revnum_t base_revision;
+
+  *mergeinfo = NULL;
+
+  SVN_ERR(svn_wc__node_get_base(NULL, &base_revision, NULL, NULL, NULL, NULL,
+                                ctx->wc_ctx, local_abspath,
+                                TRUE /* ignore_enoent */,
+                                scratch_pool, scratch_pool));
+
+  while (!parent || !parent->mergeinfo)
+    {
+      svn_boolean_t is_wc_root;
+      svn_boolean_t is_switched;
+      svn_revnum_t parent_base_rev;
+      svn_revnum_t parent_changed_rev;
+
+      /* Don't look any higher than the limit path or the root of the
+         working copy. */
+      if (strcmp(limit_abspath, local_abspath) == 0
+          || svn_dirent_is_root(local_abspath, strlen(local_abspath)))
+        return SVN_NO_ERROR;
+
+      SVN_ERR(svn_wc_check_root(&is_wc_root, &is_switched, NULL,
+                                ctx->wc_ctx, local_abspath, scratch_pool));
+      if (is_wc_root || is_switched)
+        return SVN_NO_ERROR;
+
+      walk_relpath = svn_relpath_join(svn_dirent_basename(local_abspath,
+                                                          NULL),
+                                      walk_relpath, scratch_pool);
+      local_abspath = svn_dirent_dirname(local_abspath, scratch_pool);
+
+      SVN_ERR(svn_wc__node_get_base(NULL, &parent_base_rev, NULL, NULL,
+                                    NULL, NULL,
+                                    ctx->wc_ctx, local_abspath,
+                                    TRUE /* ignore_enoent */,
+                                    scratch_pool, scratch_pool));
+      SVN_ERR(svn_wc__node_get_changed_info(&parent_changed_rev,
+                                            NULL, NULL,
+                                            ctx->wc_ctx, local_abspath,
+                                            scratch_pool,
+                                            scratch_pool));
+
+      /* Same rules as in svn_client__get_wc_mergeinfo(). */
+      if (SVN_IS_VALID_REVNUM(base_revision)
+          && (base_revision < parent_changed_rev
+              || parent_base_rev < base_revision))
+        return SVN_NO_ERROR;
+
+      /* Invalid inherited mergeinfo counts as empty. */
+      SVN_ERR(get_cached_mergeinfo(&parent, cache, local_abspath, ctx,
+                                   cache_pool, scratch_pool));
+    }
+
+  SVN_ERR(svn_mergeinfo__add_suffix_to_mergeinfo(mergeinfo,
+                                                 parent->mergeinfo,
+                                                 walk_relpath,
+                                                 result_pool,
+                                                 scratch_pool));
+
+  /* Remove non-inheritable mergeinfo and paths mapped to empty ranges. */
+  if (apr_hash_count(*mergeinfo))
+    {
+      SVN_ERR(svn_mergeinfo_inheritable2(mergeinfo, *mergeinfo, NULL,
+                                         SVN_INVALID_REVNUM,
+                                         SVN_INVALID_REVNUM,
+                                         TRUE, result_pool, scratch_pool));
+      svn_mergeinfo__remove_empty_rangelists(*mergeinfo, scratch_pool);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_client__elide_mergeinfo_many(const apr_array_header_t *targets,
+                                 const char *wc_elision_limit_abspath,
+                                 svn_client_ctx_t *ctx,
+                                 apr_pool_t *scratch_pool)
+{
+  apr_hash_t *cache = apr_hash_make(scratch_pool);
+  apr_array_header_t *elided = apr_array_make(scratch_pool, 0,
+                                              sizeof(const char *));
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  int i;
+
+  SVN_ERR_ASSERT(svn_dirent_is_absolute(wc_elision_limit_abspath));
+
+  /* Since TARGETS are in depth-first order, the ancestors of each target
+     have been elided already and their mergeinfo is in the cache.  So,
+     compare each target with its *remaining* nearest ancestor just like
+     the sequence of svn_client__elide_mergeinfo() calls would. */
+  for (i = 0; i < targets->nelts; i++)
+    {
+      const char *target_abspath = APR_ARRAY_IDX(targets, i, const char *);
+      cached_mergeinfo_t *target;
+      svn_mergeinfo_t mergeinfo;
+      svn_boolean_t elides;
+
+      svn_pool_clear(iterpool);
+      SVN_ERR_ASSERT(svn_dirent_is_child(wc_elision_limit_abspath,
+                                         target_abspath, NULL));
+
+      /* Issue #3896: Skip the elision attempt for invalid mergeinfo. */
+      SVN_ERR(get_cached_mergeinfo(&target, cache, target_abspath, ctx,
+                                   scratch_pool, iterpool));
+      if (!target->mergeinfo || target->invalid)
+        continue;
+
+      /* If there is nowhere to elide to within the limit, we are done. */
+      SVN_ERR(get_nearest_wc_mergeinfo(&mergeinfo, cache, target_abspath,
+                                       wc_elision_limit_abspath, ctx,
+                                       scratch_pool, iterpool, iterpool));
+      if (!mergeinfo)
+        continue;
+
+      SVN_ERR(should_elide_mergeinfo(&elides, mergeinfo, target->mergeinfo,
+                                     NULL, iterpool));
+      if (elides)
+        {
+          APR_ARRAY_PUSH(elided, const char *) = target_abspath;
+          target->mergeinfo = NULL;
+        }
+    }
+
+  SVN_ERR(svn_wc__prop_delete_many(ctx->wc_ctx, elided, SVN_PROP_MERGEINFO,
+                                   scratch_pool));
+
+  if (ctx->notify_func2)
+    for (i = 0; i < elided->nelts; i++)
+      {
+        const char *local_abspath = APR_ARRAY_IDX(elided, i, const char *);
+        svn_wc_notify_t *notify;
+
+        svn_pool_clear(iterpool);
+
+        notify = svn_wc_create_notify(local_abspath,
+                                      svn_wc_notify_merge_elide_info,
+                                      iterpool);
+        ctx->notify_func2(ctx->notify_baton2, notify, iterpool);
+
+        notify = svn_wc_create_notify(local_abspath,
+                                      svn_wc_notify_update_update,
+                                      iterpool);
+        notify->prop_state = svn_wc_notify_state_changed;
+
+        ctx->notify_func2(ctx->notify_baton2, notify, iterpool);
+      }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
 
 /* Set *MERGEINFO_CATALOG to the explicit or inherited mergeinfo for
    PATH_OR_URL@PEG_REVISION.  If INCLUDE_DESCENDANTS is true, also
@@ -1055,10 +1278,11 @@ get_mergeinfo(svn_mergeinfo_catalog_t *mergeinfo_catalog,
     }
   else
     {
-      SVN_ERR(svn_client__ra_session_from_path2(&ra_session, &peg_loc,
-                                                path_or_url, NULL,
-                                                peg_revision,
-                                                peg_revision, ctx, scratch_pool));
+      SVN_ERR(svn_client__pooled_ra_session_from_path(&ra_session, &peg_loc,
+                                                      path_or_url,
+                                                      peg_revision,
+                                                      peg_revision, ctx,
+                                                      scratch_pool));
     }
 
   /* If PATH_OR_URL is as working copy path determine if we will need to
@@ -1552,9 +1776,8 @@ logs_for_mergeinfo_rangelist(const char *source_url,
   fleb.ctx = ctx;
 
   if (!ra_session)
-    SVN_ERR(svn_client__open_ra_session_internal(&ra_session, NULL, source_url,
-                                                 NULL, NULL, FALSE, FALSE, ctx,
-                                                 scratch_pool, scratch_pool));
+    SVN_ERR(svn_client__ra_session_acquire(&ra_session, source_url, ctx,
+                                           scratch_pool, scratch_pool));
   else
     SVN_ERR(svn_ra_reparent(ra_session, source_url, scratch_pool));
 
@@ -1665,6 +1888,128 @@ svn_client_mergeinfo_get_merged(apr_hash_t **mergeinfo_p,
   return SVN_NO_ERROR;
 }
 
+/* Fetch the inputs of svn_client__mergeinfo_log() for a URL merge target
+   with a single svn_ra__get_merge_plan() request instead of separate
+   mergeinfo and location segment requests.
+
+   Set *TARGET_MERGEINFO_CAT to the mergeinfo catalog of
+   TARGET_URL@TARGET_PEG_REVISION, including subtrees if
+   INCLUDE_DESCENDANTS is set, keyed by repository relpaths.  Set
+   *SOURCE_HISTORY to the history of SOURCE_URL@SOURCE_PEG_REVISION between
+   SOURCE_START_REVISION and SOURCE_END_REVISION and, unless TARGET_HISTORY
+   is NULL, *TARGET_HISTORY to the complete history of the target.  Set
+   *OLDEST_REVS_FIRST if SOURCE_START_REVISION is older than
+   SOURCE_END_REVISION.
+
+   Set *SESSION to the session used, which will be RA_SESSION if that is
+   not NULL and a session acquired for SESSION_POOL otherwise, and
+   *REPOS_ROOT to the repository root URL.
+
+   If the server does not support this or SOURCE_URL is in a different
+   repository, set *GOT_PLAN to FALSE and leave all other outputs
+   undefined.  Otherwise, set *GOT_PLAN to TRUE.
+
+   Allocate *TARGET_MERGEINFO_CAT in RESULT_POOL and everything else in
+   SCRATCH_POOL. */
+static svn_error_t *
+get_merge_plan(svn_boolean_t *got_plan,
+               svn_mergeinfo_catalog_t *target_mergeinfo_cat,
+               svn_mergeinfo_t *source_history,
+               svn_mergeinfo_t *target_history,
+               svn_boolean_t *oldest_revs_first,
+               svn_ra_session_t **session,
+               const char **repos_root,
+               const char *target_url,
+               const svn_opt_revision_t *target_peg_revision,
+               const char *source_url,
+               const svn_opt_revision_t *source_peg_revision,
+               const svn_opt_revision_t *source_start_revision,
+               const svn_opt_revision_t *source_end_revision,
+               svn_boolean_t include_descendants,
+               svn_client_ctx_t *ctx,
+               svn_ra_session_t *ra_session,
+               apr_pool_t *session_pool,
+               apr_pool_t *result_pool,
+               apr_pool_t *scratch_pool)
+{
+  svn_client__pathrev_t *target_loc, *source_loc;
+  svn_revnum_t start_rev, end_rev, youngest_rev = SVN_INVALID_REVNUM;
+  svn_error_t *err;
+
+  *got_plan = FALSE;
+
+  if (ra_session)
+    {
+      SVN_ERR(svn_ra_reparent(ra_session, target_url, scratch_pool));
+      SVN_ERR(svn_client__resolve_rev_and_url(&target_loc, ra_session,
+                                              target_url,
+                                              target_peg_revision,
+                                              target_peg_revision,
+                                              ctx, scratch_pool));
+    }
+  else
+    {
+      SVN_ERR(svn_client__pooled_ra_session_from_path(&ra_session,
+                                                      &target_loc,
+                                                      target_url,
+                                                      target_peg_revision,
+                                                      target_peg_revision,
+                                                      ctx, session_pool));
+    }
+
+  *session = ra_session;
+  *repos_root = target_loc->repos_root_url;
+  if (!svn_uri_skip_ancestor(*repos_root, source_url, scratch_pool))
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_ra_reparent(ra_session, source_url, scratch_pool));
+  SVN_ERR(svn_client__resolve_rev_and_url(&source_loc, ra_session,
+                                          source_url,
+                                          source_peg_revision,
+                                          source_peg_revision,
+                                          ctx, scratch_pool));
+  SVN_ERR(svn_client__get_revision_number(&start_rev, &youngest_rev,
+                                          ctx->wc_ctx, source_url,
+                                          ra_session, source_start_revision,
+                                          scratch_pool));
+  SVN_ERR(svn_client__get_revision_number(&end_rev, &youngest_rev,
+                                          ctx->wc_ctx, source_url,
+                                          ra_session, source_end_revision,
+                                          scratch_pool));
+
+  SVN_ERR(svn_ra_reparent(ra_session, *repos_root, scratch_pool));
+  err = svn_ra__get_merge_plan(source_history, target_history,
+                               target_mergeinfo_cat, ra_session,
+                               svn_client__pathrev_relpath(source_loc,
+                                                           scratch_pool),
+                               source_loc->rev,
+                               MAX(end_rev, start_rev),
+                               MIN(end_rev, start_rev),
+                               svn_client__pathrev_relpath(target_loc,
+                                                           scratch_pool),
+                               target_loc->rev, include_descendants,
+                               result_pool, scratch_pool);
+  if (err && err->apr_err == SVN_ERR_RA_NOT_IMPLEMENTED)
+    {
+      svn_error_clear(err);
+      return SVN_NO_ERROR;
+    }
+  SVN_ERR(err);
+
+  /* Keep the histories where the caller expects them. */
+  if (result_pool != scratch_pool)
+    {
+      *source_history = svn_mergeinfo_dup(*source_history, scratch_pool);
+      if (target_history)
+        *target_history = svn_mergeinfo_dup(*target_history, scratch_pool);
+    }
+
+  *oldest_revs_first = (start_rev <= end_rev);
+  *got_plan = TRUE;
+
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *
 svn_client__mergeinfo_log(svn_boolean_t finding_merged,
                           const char *target_path_or_url,
@@ -1706,6 +2051,7 @@ svn_client__mergeinfo_log(svn_boolean_t finding_merged,
   apr_hash_index_t *hi;
   apr_pool_t *iterpool;
   svn_boolean_t oldest_revs_first = TRUE;
+  svn_boolean_t got_plan = FALSE;
   apr_pool_t *subpool;
 
   /* We currently only support depth = empty | infinity. */
@@ -1737,6 +2083,31 @@ svn_client__mergeinfo_log(svn_boolean_t finding_merged,
   if (ra_session)
     target_session = ra_session;
 
+  /* If the target mergeinfo comes from the repository anyway, let the
+     server supply everything we need for the calculation in one go. */
+  if (svn_path_is_url(target_path_or_url)
+      && svn_path_is_url(source_path_or_url)
+      && !(target_mergeinfo_catalog && *target_mergeinfo_catalog))
+    {
+      SVN_ERR(get_merge_plan(&got_plan, &target_mergeinfo_cat,
+                             &source_history,
+                             finding_merged ? NULL : &target_history,
+                             &oldest_revs_first, &target_session,
+                             &repos_root, target_path_or_url,
+                             target_peg_revision, source_path_or_url,
+                             source_peg_revision, source_start_revision,
+                             source_end_revision,
+                             depth == svn_depth_infinity,
+                             ctx, ra_session, subpool,
+                             target_mergeinfo_catalog ? result_pool
+                                                      : scratch_pool,
+                             scratch_pool));
+      if (got_plan && target_mergeinfo_catalog)
+        *target_mergeinfo_catalog = target_mergeinfo_cat;
+      else if (! got_plan)
+        target_session = ra_session;
+    }
+
   /* We need the union of TARGET_PATH_OR_URL@TARGET_PEG_REVISION's mergeinfo
      and MERGE_SOURCE_URL's history.  It's not enough to do path
      matching, because renames in the history of MERGE_SOURCE_URL
@@ -1744,7 +2115,11 @@ svn_client__mergeinfo_log(svn_boolean_t finding_merged,
      the target, that vastly simplifies matters (we'll have nothing to
      do). */
   /* This get_mergeinfo() call doubles as a mergeinfo capabilities check. */
-  if (target_mergeinfo_catalog)
+  if (got_plan)
+    {
+      /* Already provided by the server. */
+    }
+  else if (target_mergeinfo_catalog)
     {
       if (*target_mergeinfo_catalog)
         {
@@ -1766,13 +2141,10 @@ svn_client__mergeinfo_log(svn_boolean_t finding_merged,
             }
           else
             {
-              SVN_ERR(svn_client__ra_session_from_path2(&target_session,
-                                                        &pathrev,
-                                                        target_path_or_url,
-                                                        NULL,
-                                                        target_peg_revision,
-                                                        target_peg_revision,
-                                                        ctx, subpool));
+              SVN_ERR(svn_client__pooled_ra_session_from_path(
+                        &target_session, &pathrev, target_path_or_url,
+                        target_peg_revision, target_peg_revision,
+                        ctx, subpool));
             }
           SVN_ERR(svn_ra_get_repos_root2(target_session, &repos_root,
                                          scratch_pool));
@@ -1847,6 +2219,7 @@ svn_client__mergeinfo_log(svn_boolean_t finding_merged,
    *
    * ### TODO: As the source and target must be in the same repository, we
    * should share a single session, tracking the two URLs separately. */
+  if (! got_plan)
   {
     svn_ra_session_t *source_session;
     svn_revnum_t start_rev, end_rev, youngest_rev = SVN_INVALID_REVNUM;
@@ -1854,11 +2227,10 @@ svn_client__mergeinfo_log(svn_boolean_t finding_merged,
     if (! finding_merged)
       {
         if (!target_session)
-          SVN_ERR(svn_client__ra_session_from_path2(&target_session, &pathrev,
-                                                    target_path_or_url, NULL,
-                                                    target_peg_revision,
-                                                    target_peg_revision,
-                                                    ctx, subpool));
+          SVN_ERR(svn_client__pooled_ra_session_from_path(
+                    &target_session, &pathrev, target_path_or_url,
+                    target_peg_revision, target_peg_revision,
+                    ctx, subpool));
         SVN_ERR(svn_client__get_history_as_mergeinfo(&target_history, NULL,
                                                      pathrev,
                                                      SVN_INVALID_REVNUM,
@@ -1883,11 +2255,10 @@ svn_client__mergeinfo_log(svn_boolean_t finding_merged,
       }
     else
       {
-        SVN_ERR(svn_client__ra_session_from_path2(&source_session, &pathrev,
-                                                  source_path_or_url, NULL,
-                                                  source_peg_revision,
-                                                  source_peg_revision,
-                                                  ctx, subpool));
+        SVN_ERR(svn_client__pooled_ra_session_from_path(
+                  &source_session, &pathrev, source_path_or_url,
+                  source_peg_revision, source_peg_revision,
+                  ctx, subpool));
       }
     SVN_ERR(svn_client__get_revision_number(&start_rev, &youngest_rev,
                                             ctx->wc_ctx, source_path_or_url,
@@ -2245,9 +2616,10 @@ svn_client_suggest_merge_sources(apr_array_header_t **suggestions,
         1. The copyfrom source.
         2. All remaining merge sources (unordered).
   */
-  SVN_ERR(svn_client__ra_session_from_path2(&ra_session, NULL, path_or_url,
-                                            NULL, peg_revision, peg_revision,
-                                            ctx, session_pool));
+  SVN_ERR(svn_client__pooled_ra_session_from_path(&ra_session, NULL,
+                                                  path_or_url,
+                                                  peg_revision, peg_revision,
+                                                  ctx, session_pool));
 
   SVN_ERR(get_mergeinfo(&mergeinfo_cat, &repos_root, path_or_url,
                         peg_revision, FALSE, FALSE,
@@ -390,6 +390,20 @@ svn_client__elide_mergeinfo(const char *target_abspath,
                             svn_client_ctx_t *ctx,
                             apr_pool_t *pool);
 
+/* Like calling svn_client__elide_mergeinfo() for each const char *
+   abspath in TARGETS, in order, with WC_ELISION_LIMIT_ABSPATH as the
+   limit, but more efficiently.
+
+   TARGETS must be sorted in depth-first order and all of them must be
+   strict descendants of WC_ELISION_LIMIT_ABSPATH in the same working
+   copy.  Each explicit mergeinfo gets read and parsed only once, and
+   all elided mergeinfo is removed within a single wc.db transaction. */
+svn_error_t *
+svn_client__elide_mergeinfo_many(const apr_array_header_t *targets,
+                                 const char *wc_elision_limit_abspath,
+                                 svn_client_ctx_t *ctx,
+                                 apr_pool_t *scratch_pool);
+
 /* Simplify a mergeinfo catalog, if possible, via elision.
 
    For each path in MERGEINFO_CATALOG, check if the path's mergeinfo can
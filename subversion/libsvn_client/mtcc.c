@@ -89,8 +89,35 @@ struct svn_client__mtcc_t
   svn_client_ctx_t *ctx;
 
   mtcc_op_t *root_op;
+
+  /* "REV:RELPATH" -> svn_node_kind_t *, for the repository locations
+     whose kind has been obtained from the server. */
+  apr_hash_t *kinds;
+
+  /* "REV:RELPATH" -> mtcc_dir_info_t *, for the parent directories of
+     these locations. */
+  apr_hash_t *dirs;
 };
 
+/* After this many kind lookups within the same repository directory,
+   fetch its entries with a single request instead of asking for every
+   node.  This keeps bulk operations like many puts in one directory
+   from needing a round trip per node. */
+#define MTCC_LIST_THRESHOLD 8
+
+/* What we know about a directory in the repository. */
+typedef struct mtcc_dir_info_t
+{
+  /* Number of kind lookups of children so far. */
+  int lookups;
+
+  /* const char * name -> svn_dirent_t *, once listed. */
+  apr_hash_t *dirents;
+
+  /* Listing the directory failed, so don't try again. */
+  svn_boolean_t list_failed;
+} mtcc_dir_info_t;
+
 static mtcc_op_t *
 mtcc_op_create(const char *name,
                svn_boolean_t add,
@@ -288,6 +315,83 @@ get_origin(svn_boolean_t *done,
   return SVN_NO_ERROR;
 }
 
+/* Set *KIND to the kind of RELPATH at REVISION in the repository of MTCC,
+   where REVISION is a valid revision.  Remember the answers, as the same
+   locations are typically checked several times, and list the parent
+   directory once MTCC_LIST_THRESHOLD of its children have been checked.
+   Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+mtcc_ra_check_path(svn_node_kind_t *kind,
+                   svn_client__mtcc_t *mtcc,
+                   const char *relpath,
+                   svn_revnum_t revision,
+                   apr_pool_t *scratch_pool)
+{
+  const char *key = apr_psprintf(scratch_pool, "%ld:%s", revision, relpath);
+  svn_node_kind_t *cached = svn_hash_gets(mtcc->kinds, key);
+  svn_boolean_t found = FALSE;
+
+  if (cached)
+    {
+      *kind = *cached;
+      return SVN_NO_ERROR;
+    }
+
+  if (!SVN_PATH_IS_EMPTY(relpath))
+    {
+      const char *parent_relpath;
+      const char *name;
+      const char *parent_key;
+      mtcc_dir_info_t *dir;
+
+      svn_relpath_split(&parent_relpath, &name, relpath, scratch_pool);
+      parent_key = apr_psprintf(scratch_pool, "%ld:%s", revision,
+                                parent_relpath);
+      dir = svn_hash_gets(mtcc->dirs, parent_key);
+      if (!dir)
+        {
+          dir = apr_pcalloc(mtcc->pool, sizeof(*dir));
+          svn_hash_sets(mtcc->dirs, apr_pstrdup(mtcc->pool, parent_key), dir);
+        }
+
+      if (!dir->dirents && !dir->list_failed
+          && ++dir->lookups >= MTCC_LIST_THRESHOLD)
+        {
+          svn_error_t *err = svn_ra_get_dir2(mtcc->ra_session, &dir->dirents,
+                                             NULL, NULL, parent_relpath,
+                                             revision, SVN_DIRENT_KIND,
+                                             mtcc->pool);
+
+          /* Not being able to list the parent isn't fatal; the node
+             itself may still be accessible. */
+          if (err)
+            {
+              svn_error_clear(err);
+              dir->dirents = NULL;
+              dir->list_failed = TRUE;
+            }
+        }
+
+      if (dir->dirents)
+        {
+          svn_dirent_t *dirent = svn_hash_gets(dir->dirents, name);
+
+          *kind = dirent ? dirent->kind : svn_node_none;
+          found = TRUE;
+        }
+    }
+
+  if (!found)
+    SVN_ERR(svn_ra_check_path(mtcc->ra_session, relpath, revision, kind,
+                              scratch_pool));
+
+  cached = apr_palloc(mtcc->pool, sizeof(*cached));
+  *cached = *kind;
+  svn_hash_sets(mtcc->kinds, apr_pstrdup(mtcc->pool, key), cached);
+
+  return SVN_NO_ERROR;
+}
+
 /* Obtains the original repository location for an mtcc relpath as
    *ORIGIN_RELPATH @ *REV, if it has one. If it has not and IGNORE_ENOENT
    is TRUE report *ORIGIN_RELPATH as NULL, otherwise return an error */
@@ -339,6 +443,8 @@ svn_client__mtcc_create(svn_client__mtcc_t **mtcc,
   (*mtcc)->pool = mtcc_pool;
 
   (*mtcc)->root_op = mtcc_op_create(NULL, FALSE, TRUE, mtcc_pool);
+  (*mtcc)->kinds = apr_hash_make(mtcc_pool);
+  (*mtcc)->dirs = apr_hash_make(mtcc_pool);
 
   (*mtcc)->ctx = ctx;
 
@@ -417,6 +523,10 @@ mtcc_reparent(const char *new_anchor_url,
 
   SVN_ERR(svn_ra_reparent(mtcc->ra_session, new_anchor_url, scratch_pool));
 
+  /* The remembered locations are relative to the old anchor. */
+  mtcc->kinds = apr_hash_make(mtcc->pool);
+  mtcc->dirs = apr_hash_make(mtcc->pool);
+
   /* Create directory open operations for new ancestors */
   while (*up)
     {
@@ -541,8 +651,8 @@ svn_client__mtcc_add_copy(const char *src_relpath,
   SVN_ERR(mtcc_verify_create(mtcc, dst_relpath, scratch_pool));
 
   /* Subversion requires the kind of a copy */
-  SVN_ERR(svn_ra_check_path(mtcc->ra_session, src_relpath, revision, &kind,
-                            scratch_pool));
+  SVN_ERR(mtcc_ra_check_path(&kind, mtcc, src_relpath, revision,
+                             scratch_pool));
 
   if (kind != svn_node_dir && kind != svn_node_file)
     {
@@ -1025,8 +1135,8 @@ svn_client__mtcc_check_path(svn_node_kind_t *kind,
       if (!origin_relpath)
         *kind = svn_node_none;
       else
-        SVN_ERR(svn_ra_check_path(mtcc->ra_session, origin_relpath,
-                                  origin_rev, kind, scratch_pool));
+        SVN_ERR(mtcc_ra_check_path(kind, mtcc, origin_relpath, origin_rev,
+                                   scratch_pool));
 
       if (op && *kind == svn_node_dir)
         {
@@ -29,6 +29,7 @@
 
 #include <apr_hash.h>
 #include <apr_fnmatch.h>
+#include <apr_lib.h>
 #include "svn_client.h"
 #include "svn_dirent_uri.h"
 #include "svn_diff.h"
@@ -73,6 +74,26 @@ typedef struct hunk_info_t {
   svn_linenum_t report_fuzz;
 } hunk_info_t;
 
+/* An entry of the line index, see line_index_t. */
+typedef struct line_hash_t {
+  apr_uint32_t hash;
+  svn_linenum_t line;
+} line_hash_t;
+
+/* Hashes of all lines of the unpatched content of a target.  They let
+ * scan_for_match() find the few lines at which a hunk may match without
+ * reading the content for every line it passes. */
+typedef struct line_index_t {
+  /* Whether whitespace has been ignored when hashing the lines. */
+  svn_boolean_t ignore_whitespace;
+
+  /* The apr_uint32_t hash of the Nth line is at index N - 1. */
+  apr_array_header_t *hashes;
+
+  /* A line_hash_t for every line, ordered by hash and then by line. */
+  apr_array_header_t *sorted;
+} line_index_t;
+
 /* A struct carrying information related to the patched and unpatched
  * content of a target, be it a property or the text of a file. */
 typedef struct target_content_t {
@@ -98,6 +119,10 @@ typedef struct target_content_t {
   /* An array containing hunk_info_t structures for hunks already matched. */
   apr_array_header_t *hunks;
 
+  /* Index of the unpatched content, built by the first scan_for_match().
+   * NULL until then. */
+  line_index_t *index;
+
   /* True if end-of-file was reached while reading from the unpatched
    * content. */
   svn_boolean_t eof;
@@ -1662,6 +1687,272 @@ match_hunk(svn_boolean_t *matched, target_content_t *content,
   return SVN_NO_ERROR;
 }
 
+/* Return a hash of LINE.  If IGNORE_WHITESPACE is set, skip whitespace
+ * just like apr_collapse_spaces() in match_hunk() does. */
+static apr_uint32_t
+hash_line(const char *line,
+          svn_boolean_t ignore_whitespace)
+{
+  /* FNV-1a */
+  apr_uint32_t hash = 0x811c9dc5;
+
+  for (; *line; ++line)
+    if (!ignore_whitespace || !apr_isspace(*line))
+      hash = (hash ^ (unsigned char)*line) * 0x01000193;
+
+  return hash;
+}
+
+/* Sort line_hash_t elements by hash and then by line number. */
+static int
+compare_line_hashes(const void *lhs,
+                    const void *rhs)
+{
+  const line_hash_t *a = lhs;
+  const line_hash_t *b = rhs;
+
+  if (a->hash != b->hash)
+    return a->hash < b->hash ? -1 : 1;
+
+  return a->line < b->line ? -1 : (a->line > b->line ? 1 : 0);
+}
+
+/* Set *INDEX to the line index of CONTENT, hashed according to
+ * IGNORE_WHITESPACE, building it if necessary.  Set it to NULL if there
+ * is no content to index or CONTENT is at EOF already.  This reads all
+ * of CONTENT once; its current line will not have changed when this
+ * function returns.
+ * Allocate the index in RESULT_POOL and use SCRATCH_POOL for temporary
+ * allocations. */
+static svn_error_t *
+get_line_index(line_index_t **index,
+               target_content_t *content,
+               svn_boolean_t ignore_whitespace,
+               apr_pool_t *result_pool,
+               apr_pool_t *scratch_pool)
+{
+  line_index_t *new_index;
+  svn_linenum_t saved_line;
+  svn_boolean_t saved_eof;
+  apr_pool_t *iterpool;
+  int i;
+
+  if (!content->existed || content->readline == NULL || content->eof)
+    {
+      *index = NULL;
+      return SVN_NO_ERROR;
+    }
+
+  if (content->index && content->index->ignore_whitespace == ignore_whitespace)
+    {
+      *index = content->index;
+      return SVN_NO_ERROR;
+    }
+
+  new_index = apr_pcalloc(result_pool, sizeof(*new_index));
+  new_index->ignore_whitespace = ignore_whitespace;
+  new_index->hashes = apr_array_make(result_pool, 0, sizeof(apr_uint32_t));
+
+  saved_line = content->current_line;
+  saved_eof = content->eof;
+  SVN_ERR(seek_to_line(content, 1, scratch_pool));
+
+  iterpool = svn_pool_create(scratch_pool);
+  while (! content->eof)
+    {
+      const char *line;
+      svn_linenum_t line_number = content->current_line;
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(readline(content, &line, iterpool, iterpool));
+
+      /* An empty read at EOF is no line. */
+      if (content->current_line > line_number)
+        APR_ARRAY_PUSH(new_index->hashes, apr_uint32_t)
+          = hash_line(line, ignore_whitespace);
+    }
+  svn_pool_destroy(iterpool);
+
+  SVN_ERR(seek_to_line(content, saved_line, scratch_pool));
+  content->eof = saved_eof;
+
+  new_index->sorted = apr_array_make(result_pool, new_index->hashes->nelts,
+                                     sizeof(line_hash_t));
+  for (i = 0; i < new_index->hashes->nelts; ++i)
+    {
+      line_hash_t *entry = apr_array_push(new_index->sorted);
+
+      entry->hash = APR_ARRAY_IDX(new_index->hashes, i, apr_uint32_t);
+      entry->line = i + 1;
+    }
+  svn_sort__array(new_index->sorted, compare_line_hashes);
+
+  content->index = new_index;
+  *index = new_index;
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *HASHES to an array with the apr_uint32_t hashes of the lines of
+ * HUNK as match_hunk() would compare them against CONTENT, using the
+ * FUZZ, IGNORE_WHITESPACE and MATCH_MODIFIED parameters as documented
+ * there.  Set *MUST_MATCH to an array of the same size with an
+ * svn_boolean_t that is FALSE for the lines that match_hunk() treats as
+ * always matching.  Set *ANCHOR to the index of the first line that must
+ * match or to -1 if there is no such line or HUNK can't match at all.
+ * Allocate the arrays in RESULT_POOL.  Use SCRATCH_POOL for temporary
+ * allocations. */
+static svn_error_t *
+get_hunk_hashes(apr_array_header_t **hashes,
+                apr_array_header_t **must_match,
+                int *anchor,
+                target_content_t *content,
+                svn_diff_hunk_t *hunk,
+                svn_linenum_t fuzz,
+                svn_boolean_t ignore_whitespace,
+                svn_boolean_t match_modified,
+                apr_pool_t *result_pool,
+                apr_pool_t *scratch_pool)
+{
+  svn_linenum_t leading_context = svn_diff_hunk_get_leading_context(hunk);
+  svn_linenum_t trailing_context = svn_diff_hunk_get_trailing_context(hunk);
+  svn_linenum_t hunk_length;
+  svn_linenum_t lines_read = 0;
+  svn_linenum_t fuzz_penalty = svn_diff_hunk__get_fuzz_penalty(hunk);
+  apr_pool_t *iterpool;
+
+  *hashes = apr_array_make(result_pool, 0, sizeof(apr_uint32_t));
+  *must_match = apr_array_make(result_pool, 0, sizeof(svn_boolean_t));
+  *anchor = -1;
+
+  /* Same fuzz adjustment and lines as in match_hunk(). */
+  if (fuzz_penalty > fuzz)
+    return SVN_NO_ERROR;
+
+  fuzz -= fuzz_penalty;
+  if (match_modified)
+    {
+      svn_diff_hunk_reset_modified_text(hunk);
+      hunk_length = svn_diff_hunk_get_modified_length(hunk);
+    }
+  else
+    {
+      svn_diff_hunk_reset_original_text(hunk);
+      hunk_length = svn_diff_hunk_get_original_length(hunk);
+    }
+
+  iterpool = svn_pool_create(scratch_pool);
+  while (TRUE)
+    {
+      svn_stringbuf_t *hunk_line;
+      const char *hunk_line_translated;
+      svn_boolean_t hunk_eof;
+      svn_boolean_t fuzzy;
+
+      svn_pool_clear(iterpool);
+
+      if (match_modified)
+        SVN_ERR(svn_diff_hunk_readline_modified_text(hunk, &hunk_line,
+                                                     NULL, &hunk_eof,
+                                                     iterpool, iterpool));
+      else
+        SVN_ERR(svn_diff_hunk_readline_original_text(hunk, &hunk_line,
+                                                     NULL, &hunk_eof,
+                                                     iterpool, iterpool));
+
+      if (hunk_eof && hunk_line->len == 0)
+        break;
+
+      SVN_ERR(svn_subst_translate_cstring2(hunk_line->data,
+                                           &hunk_line_translated,
+                                           NULL, FALSE,
+                                           content->keywords, FALSE,
+                                           iterpool));
+
+      lines_read++;
+      fuzzy = ((lines_read <= fuzz && leading_context > fuzz) ||
+               (lines_read > hunk_length - fuzz && trailing_context > fuzz));
+      if (!fuzzy && *anchor < 0)
+        *anchor = (*hashes)->nelts;
+
+      APR_ARRAY_PUSH(*hashes, apr_uint32_t)
+        = hash_line(hunk_line_translated, ignore_whitespace);
+      APR_ARRAY_PUSH(*must_match, svn_boolean_t) = !fuzzy;
+    }
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Return TRUE if HASHES and MUST_MATCH as returned by get_hunk_hashes()
+ * may match the lines of INDEX starting at LINE.  FALSE means that
+ * match_hunk() would definitely not match there. */
+static svn_boolean_t
+may_match_at(const line_index_t *index,
+             const apr_array_header_t *hashes,
+             const apr_array_header_t *must_match,
+             svn_linenum_t line)
+{
+  int i;
+
+  /* A hunk that runs past EOF does not match. */
+  if (line - 1 + hashes->nelts > (svn_linenum_t)index->hashes->nelts)
+    return FALSE;
+
+  for (i = 0; i < hashes->nelts; ++i)
+    if (APR_ARRAY_IDX(must_match, i, svn_boolean_t)
+        && (APR_ARRAY_IDX(hashes, i, apr_uint32_t)
+            != APR_ARRAY_IDX(index->hashes, line - 1 + i, apr_uint32_t)))
+      return FALSE;
+
+  return TRUE;
+}
+
+/* Set *MATCHED to whether HUNK matches CONTENT at its current line as
+ * determined by match_hunk() and does not overlap any of the hunks
+ * matched before.  FUZZ, IGNORE_WHITESPACE and MATCH_MODIFIED are passed
+ * to match_hunk().  Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+match_untaken_hunk(svn_boolean_t *matched,
+                   target_content_t *content,
+                   svn_diff_hunk_t *hunk,
+                   svn_linenum_t fuzz,
+                   svn_boolean_t ignore_whitespace,
+                   svn_boolean_t match_modified,
+                   apr_pool_t *scratch_pool)
+{
+  int i;
+
+  SVN_ERR(match_hunk(matched, content, hunk, fuzz, ignore_whitespace,
+                     match_modified, scratch_pool));
+  if (! *matched)
+    return SVN_NO_ERROR;
+
+  /* Don't allow hunks to match at overlapping locations. */
+  for (i = 0; i < content->hunks->nelts; i++)
+    {
+      const hunk_info_t *hi;
+      svn_linenum_t length;
+
+      hi = APR_ARRAY_IDX(content->hunks, i, const hunk_info_t *);
+
+      if (match_modified)
+        length = svn_diff_hunk_get_modified_length(hi->hunk);
+      else
+        length = svn_diff_hunk_get_original_length(hi->hunk);
+
+      if (! hi->rejected &&
+          content->current_line >= hi->matched_line &&
+          content->current_line < (hi->matched_line + length))
+        {
+          *matched = FALSE;
+          break;
+        }
+    }
+
+  return SVN_NO_ERROR;
+}
+
 /* Scan lines of CONTENT for a match of the original text of HUNK,
  * up to but not including the specified UPPER_LINE. Use fuzz factor FUZZ.
  * If UPPER_LINE is zero scan until EOF occurs when reading from TARGET.
@@ -1686,59 +1977,109 @@ scan_for_match(svn_linenum_t *matched_line,
                svn_cancel_func_t cancel_func, void *cancel_baton,
                apr_pool_t *pool)
 {
+  line_index_t *index;
+  apr_array_header_t *hashes;
+  apr_array_header_t *must_match;
+  int anchor;
   apr_pool_t *iterpool;
 
   *matched_line = 0;
+
+  /* Probing a single line is cheaper without the index.  The index lives
+   * as long as CONTENT and its other arrays do. */
+  if (upper_line == 0 || upper_line > content->current_line + 1)
+    SVN_ERR(get_line_index(&index, content, ignore_whitespace,
+                           content->hunks->pool, pool));
+  else
+    index = NULL;
+
+  if (index)
+    SVN_ERR(get_hunk_hashes(&hashes, &must_match, &anchor, content, hunk,
+                            fuzz, ignore_whitespace, match_modified,
+                            pool, pool));
+  else
+    anchor = -1;
+
   iterpool = svn_pool_create(pool);
-  while ((content->current_line < upper_line || upper_line == 0) &&
-         ! content->eof)
+  if (anchor >= 0)
     {
-      svn_boolean_t matched;
-
-      svn_pool_clear(iterpool);
+      /* Only look at the lines where the anchor line of HUNK appears in
+       * CONTENT and verify the candidates with the other hunk lines'
+       * hashes before actually comparing any text. */
+      svn_linenum_t end_line = index->hashes->nelts + 1;
+      apr_uint32_t anchor_hash = APR_ARRAY_IDX(hashes, anchor, apr_uint32_t);
+      line_hash_t key;
+      int i;
 
-      if (cancel_func)
-        SVN_ERR(cancel_func(cancel_baton));
+      if (upper_line > 0 && upper_line < end_line)
+        end_line = upper_line;
 
-      SVN_ERR(match_hunk(&matched, content, hunk, fuzz, ignore_whitespace,
-                         match_modified, iterpool));
-      if (matched)
+      key.hash = anchor_hash;
+      key.line = content->current_line + anchor;
+      for (i = svn_sort__bsearch_lower_bound(index->sorted, &key,
+                                             compare_line_hashes);
+           i < index->sorted->nelts;
+           ++i)
         {
-          svn_boolean_t taken = FALSE;
-          int i;
+          const line_hash_t *entry = &APR_ARRAY_IDX(index->sorted, i,
+                                                    line_hash_t);
+          svn_linenum_t start_line = entry->line - anchor;
+          svn_boolean_t matched;
 
-          /* Don't allow hunks to match at overlapping locations. */
-          for (i = 0; i < content->hunks->nelts; i++)
-            {
-              const hunk_info_t *hi;
-              svn_linenum_t length;
+          if (entry->hash != anchor_hash || start_line >= end_line)
+            break;
 
-              hi = APR_ARRAY_IDX(content->hunks, i, const hunk_info_t *);
+          svn_pool_clear(iterpool);
 
-              if (match_modified)
-                length = svn_diff_hunk_get_modified_length(hi->hunk);
-              else
-                length = svn_diff_hunk_get_original_length(hi->hunk);
+          if (cancel_func)
+            SVN_ERR(cancel_func(cancel_baton));
 
-              taken = (! hi->rejected &&
-                       content->current_line >= hi->matched_line &&
-                       content->current_line < (hi->matched_line + length));
-              if (taken)
-                break;
-            }
+          if (! may_match_at(index, hashes, must_match, start_line))
+            continue;
 
-          if (! taken)
+          SVN_ERR(seek_to_line(content, start_line, iterpool));
+          SVN_ERR(match_untaken_hunk(&matched, content, hunk, fuzz,
+                                     ignore_whitespace, match_modified,
+                                     iterpool));
+          if (matched)
             {
-              *matched_line = content->current_line;
+              *matched_line = start_line;
               if (match_first)
                 break;
             }
         }
 
-      if (! content->eof)
-        SVN_ERR(seek_to_line(content, content->current_line + 1,
-                             iterpool));
+      /* Leave CONTENT where the sequential scan would have left it. */
+      if (match_first && *matched_line)
+        SVN_ERR(seek_to_line(content, *matched_line, iterpool));
+      else
+        SVN_ERR(seek_to_line(content, end_line, iterpool));
     }
+  else
+    while ((content->current_line < upper_line || upper_line == 0) &&
+           ! content->eof)
+      {
+        svn_boolean_t matched;
+
+        svn_pool_clear(iterpool);
+
+        if (cancel_func)
+          SVN_ERR(cancel_func(cancel_baton));
+
+        SVN_ERR(match_untaken_hunk(&matched, content, hunk, fuzz,
+                                   ignore_whitespace, match_modified,
+                                   iterpool));
+        if (matched)
+          {
+            *matched_line = content->current_line;
+            if (match_first)
+              break;
+          }
+
+        if (! content->eof)
+          SVN_ERR(seek_to_line(content, content->current_line + 1,
+                               iterpool));
+      }
   svn_pool_destroy(iterpool);
 
   return SVN_NO_ERROR;
@@ -478,6 +478,140 @@ svn_client_open_ra_session2(svn_ra_session_t **session,
                                                   scratch_pool));
 }
 
+/* An RA session managed by the session pool of a client context. */
+typedef struct pooled_ra_session_t
+{
+  /* The session itself, allocated in POOL. */
+  svn_ra_session_t *session;
+
+  /* Root URL of the repository that SESSION points to. */
+  const char *repos_root_url;
+
+  /* Sub-pool of the client context pool that owns SESSION.  Destroying it
+     closes the session. */
+  apr_pool_t *pool;
+
+  /* The context whose session pool this session belongs to. */
+  svn_client__private_ctx_t *owner;
+} pooled_ra_session_t;
+
+/* Pool pre-cleanup function for the client context pool.  BATON is the
+   svn_client__private_ctx_t.  Prevents sessions from being put back into
+   the pool while the context is being destroyed. */
+static apr_status_t
+close_ra_session_pool(void *baton)
+{
+  svn_client__private_ctx_t *private_ctx = baton;
+
+  private_ctx->ra_sessions_closed = TRUE;
+  private_ctx->idle_ra_sessions = NULL;
+
+  return APR_SUCCESS;
+}
+
+/* Pool cleanup function, returning the pooled_ra_session_t BATON to the
+   session pool of its context or closing it if that is full. */
+static apr_status_t
+release_ra_session(void *baton)
+{
+  pooled_ra_session_t *entry = baton;
+  svn_client__private_ctx_t *private_ctx = entry->owner;
+
+  if (private_ctx->ra_sessions_closed)
+    return APR_SUCCESS;
+
+  if (private_ctx->idle_ra_sessions->nelts < SVN_CLIENT__MAX_IDLE_RA_SESSIONS)
+    APR_ARRAY_PUSH(private_ctx->idle_ra_sessions, pooled_ra_session_t *)
+      = entry;
+  else
+    svn_pool_destroy(entry->pool);
+
+  return APR_SUCCESS;
+}
+
+svn_error_t *
+svn_client__ra_session_acquire(svn_ra_session_t **ra_session,
+                               const char *url,
+                               svn_client_ctx_t *ctx,
+                               apr_pool_t *result_pool,
+                               apr_pool_t *scratch_pool)
+{
+  svn_client__private_ctx_t *private_ctx = svn_client__get_private_ctx(ctx);
+  apr_array_header_t *idle = private_ctx->idle_ra_sessions;
+  pooled_ra_session_t *entry = NULL;
+  const char *corrected_url;
+  int i;
+
+  SVN_ERR_ASSERT(!private_ctx->ra_sessions_closed);
+
+  if (idle == NULL)
+    {
+      idle = apr_array_make(private_ctx->pool,
+                            SVN_CLIENT__MAX_IDLE_RA_SESSIONS,
+                            sizeof(pooled_ra_session_t *));
+      private_ctx->idle_ra_sessions = idle;
+      apr_pool_pre_cleanup_register(private_ctx->pool, private_ctx,
+                                    close_ra_session_pool);
+    }
+
+  /* Prefer the most recently released sessions, which are the least likely
+     to have been dropped by the server. */
+  for (i = idle->nelts - 1; i >= 0; --i)
+    {
+      pooled_ra_session_t *candidate
+        = APR_ARRAY_IDX(idle, i, pooled_ra_session_t *);
+      svn_error_t *err;
+
+      if (!svn_uri__is_ancestor(candidate->repos_root_url, url))
+        continue;
+
+      err = svn_ra_reparent(candidate->session, url, scratch_pool);
+      if (err)
+        {
+          /* The repository may have moved.  Don't hand out nor keep
+             this session. */
+          svn_error_clear(err);
+          svn_sort__array_delete(idle, i, 1);
+          svn_pool_destroy(candidate->pool);
+          continue;
+        }
+
+      svn_sort__array_delete(idle, i, 1);
+      entry = candidate;
+      break;
+    }
+
+  if (entry == NULL)
+    {
+      apr_pool_t *session_pool = svn_pool_create(private_ctx->pool);
+      svn_error_t *err;
+
+      entry = apr_pcalloc(session_pool, sizeof(*entry));
+      entry->pool = session_pool;
+      entry->owner = private_ctx;
+
+      err = svn_client__open_ra_session_internal(&entry->session,
+                                                 &corrected_url, url,
+                                                 NULL, NULL, FALSE, FALSE,
+                                                 ctx, session_pool,
+                                                 scratch_pool);
+      if (!err)
+        err = svn_ra_get_repos_root2(entry->session, &entry->repos_root_url,
+                                     session_pool);
+      if (err)
+        {
+          svn_pool_destroy(session_pool);
+          return svn_error_trace(err);
+        }
+    }
+
+  apr_pool_cleanup_register(result_pool, entry, release_ra_session,
+                            apr_pool_cleanup_null);
+  *ra_session = entry->session;
+
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *
 svn_client__resolve_rev_and_url(svn_client__pathrev_t **resolved_loc_p,
                                 svn_ra_session_t *ra_session,
@@ -566,6 +700,48 @@ svn_client__ra_session_from_path2(svn_ra_session_t **ra_session_p,
 }
 
 
+svn_error_t *
+svn_client__pooled_ra_session_from_path(svn_ra_session_t **ra_session_p,
+                                        svn_client__pathrev_t **resolved_loc_p,
+                                        const char *path_or_url,
+                                        const svn_opt_revision_t *peg_revision,
+                                        const svn_opt_revision_t *revision,
+                                        svn_client_ctx_t *ctx,
+                                        apr_pool_t *pool)
+{
+  svn_ra_session_t *ra_session;
+  const char *initial_url;
+  const char *session_url;
+  svn_client__pathrev_t *resolved_loc;
+
+  SVN_ERR(svn_client_url_from_path2(&initial_url, path_or_url, ctx, pool,
+                                    pool));
+  if (! initial_url)
+    return svn_error_createf(SVN_ERR_ENTRY_MISSING_URL, NULL,
+                             _("'%s' has no URL"), path_or_url);
+
+  SVN_ERR(svn_client__ra_session_acquire(&ra_session, initial_url, ctx,
+                                         pool, pool));
+
+  /* A newly opened session may have followed a redirect. */
+  SVN_ERR(svn_ra_get_session_url(ra_session, &session_url, pool));
+  if (svn_path_is_url(path_or_url) && strcmp(session_url, initial_url) != 0)
+    path_or_url = session_url;
+
+  SVN_ERR(svn_client__resolve_rev_and_url(&resolved_loc, ra_session,
+                                          path_or_url, peg_revision, revision,
+                                          ctx, pool));
+
+  /* Make the session point to the real URL. */
+  SVN_ERR(svn_ra_reparent(ra_session, resolved_loc->url, pool));
+
+  *ra_session_p = ra_session;
+  if (resolved_loc_p)
+    *resolved_loc_p = resolved_loc;
+
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *
 svn_client__ensure_ra_session_url(const char **old_session_url,
                                   svn_ra_session_t *ra_session,
@@ -1047,6 +1223,68 @@ svn_client__get_youngest_common_ancestor(svn_client__pathrev_t **ancestor_p,
   return SVN_NO_ERROR;
 }
 
+/* Baton for fetch_pristine(). */
+typedef struct fetch_pristine_baton_t
+{
+  svn_client_ctx_t *ctx;
+
+  /* A session to the repository root SESSION_ROOT_URL, kept open for
+     further fetches, or NULL.  Allocated in POOL. */
+  svn_ra_session_t *session;
+  const char *session_root_url;
+  apr_pool_t *pool;
+} fetch_pristine_baton_t;
+
+/* Implements svn_wc__pristine_fetch_func_t. */
+static svn_error_t *
+fetch_pristine(void *baton,
+               svn_stream_t *contents,
+               const char *repos_root_url,
+               const char *repos_relpath,
+               svn_revnum_t revision,
+               apr_pool_t *scratch_pool)
+{
+  fetch_pristine_baton_t *fpb = baton;
+  svn_error_t *err;
+
+  /* Working copies rarely span repositories, so a single session
+     usually serves all fetches. */
+  if (!fpb->session || strcmp(fpb->session_root_url, repos_root_url) != 0)
+    {
+      svn_pool_clear(fpb->pool);
+      fpb->session = NULL;
+      SVN_ERR(svn_client__open_ra_session_internal(&fpb->session, NULL,
+                                                   repos_root_url, NULL,
+                                                   NULL, FALSE, FALSE,
+                                                   fpb->ctx, fpb->pool,
+                                                   scratch_pool));
+      fpb->session_root_url = apr_pstrdup(fpb->pool, repos_root_url);
+    }
+
+  err = svn_ra_get_file(fpb->session, repos_relpath, revision, contents,
+                        NULL, NULL, scratch_pool);
+  if (err)
+    {
+      /* Don't reuse a session that might be in an undefined state. */
+      fpb->session = NULL;
+      return svn_error_trace(err);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+void
+svn_client__set_pristine_fetch(svn_client_ctx_t *ctx,
+                               apr_pool_t *pool)
+{
+  fetch_pristine_baton_t *fpb = apr_pcalloc(pool, sizeof(*fpb));
+
+  fpb->ctx = ctx;
+  fpb->pool = svn_pool_create(pool);
+
+  svn_wc__context_set_pristine_fetch(ctx->wc_ctx, fetch_pristine, fpb);
+}
+
 struct ra_ev2_baton {
   /* The working copy context, from the client context.  */
   svn_wc_context_t *wc_ctx;
@@ -36,6 +36,8 @@
 #include "svn_utf.h"
 #include "svn_ctype.h"
 #include "svn_props.h"
+#include "svn_checksum.h"
+#include "svn_delta.h"
 
 #include "client.h"
 #include "private/svn_client_private.h"
@@ -234,6 +236,76 @@ get_working_props_abspath(char **work_abspath,
   return SVN_NO_ERROR;
 }
 
+/* Set *ABSPATH to the abspath of the base text reference file for
+ * SHELF_VERSION node at RELPATH, no matter whether it exists.
+ */
+static svn_error_t *
+get_base_ref_abspath(char **ref_abspath,
+                     svn_client_shelf_version_t *shelf_version,
+                     const char *wc_relpath,
+                     apr_pool_t *result_pool,
+                     apr_pool_t *scratch_pool)
+{
+  wc_relpath = apr_psprintf(scratch_pool, "%s.base-ref", wc_relpath);
+  *ref_abspath = svn_dirent_join(shelf_version->files_dir_abspath, wc_relpath,
+                                 result_pool);
+  return SVN_NO_ERROR;
+}
+
+/* Set *ABSPATH to the abspath of the working text delta file for
+ * SHELF_VERSION node at RELPATH, no matter whether it exists.
+ */
+static svn_error_t *
+get_working_delta_abspath(char **delta_abspath,
+                          svn_client_shelf_version_t *shelf_version,
+                          const char *wc_relpath,
+                          apr_pool_t *result_pool,
+                          apr_pool_t *scratch_pool)
+{
+  wc_relpath = apr_psprintf(scratch_pool, "%s.delta", wc_relpath);
+  *delta_abspath = svn_dirent_join(shelf_version->files_dir_abspath,
+                                   wc_relpath, result_pool);
+  return SVN_NO_ERROR;
+}
+
+/* Set *ABSPATH to the abspath of the pristine text store of SHELF, which
+ * is shared by all its versions, no matter whether it exists.
+ */
+static svn_error_t *
+get_pristine_dir_abspath(char **abspath,
+                         svn_client_shelf_t *shelf,
+                         apr_pool_t *result_pool,
+                         apr_pool_t *scratch_pool)
+{
+  char *codename;
+  const char *filename;
+
+  SVN_ERR(shelf_name_encode(&codename, shelf->name, scratch_pool));
+  filename = apr_pstrcat(scratch_pool, codename, ".pristine", SVN_VA_NULL);
+  *abspath = svn_dirent_join(shelf->shelves_dir, filename, result_pool);
+  return SVN_NO_ERROR;
+}
+
+/* Set *ABSPATH to the abspath of the text with SHA-1 CHECKSUM in the
+ * pristine text store of SHELF, no matter whether it exists.
+ */
+static svn_error_t *
+get_pristine_abspath(char **abspath,
+                     svn_client_shelf_t *shelf,
+                     const svn_checksum_t *checksum,
+                     apr_pool_t *result_pool,
+                     apr_pool_t *scratch_pool)
+{
+  char *dir_abspath;
+
+  SVN_ERR(get_pristine_dir_abspath(&dir_abspath, shelf,
+                                   scratch_pool, scratch_pool));
+  *abspath = svn_dirent_join(dir_abspath,
+                             svn_checksum_to_cstring(checksum, scratch_pool),
+                             result_pool);
+  return SVN_NO_ERROR;
+}
+
 /* Delete the storage for SHELF:VERSION. */
 static svn_error_t *
 shelf_version_delete(svn_client_shelf_t *shelf,
@@ -899,10 +971,220 @@ read_props_from_shelf(apr_hash_t **base_props,
   return SVN_NO_ERROR;
 }
 
-/* Store metadata for any node, and base and working files if it's a file.
+/* Store the pristine text with SHA-1 CHECKSUM of the WC file at
+ * FROM_WC_ABSPATH in the pristine text store of SHELF_VERSION's shelf,
+ * unless it is there already, and record a reference to it as the base
+ * text of SHELF_VERSION:WC_RELPATH.
+ */
+static svn_error_t *
+store_base_text(const char *from_wc_abspath,
+                const char *wc_relpath,
+                const svn_checksum_t *checksum,
+                svn_client_shelf_version_t *shelf_version,
+                svn_client_ctx_t *ctx,
+                apr_pool_t *scratch_pool)
+{
+  char *pristine_abspath;
+  char *ref_abspath;
+  svn_node_kind_t kind;
+
+  SVN_ERR(get_pristine_abspath(&pristine_abspath, shelf_version->shelf,
+                               checksum, scratch_pool, scratch_pool));
+  SVN_ERR(svn_io_check_path(pristine_abspath, &kind, scratch_pool));
+  if (kind == svn_node_none)
+    {
+      const char *pristine_dir_abspath;
+      const char *tmp_abspath;
+      svn_stream_t *wc_base_stream;
+      svn_stream_t *tmp_stream;
+
+      /* Write to a temporary file and move it into place, so that the
+       * store never contains incomplete texts. */
+      pristine_dir_abspath = svn_dirent_dirname(pristine_abspath,
+                                                scratch_pool);
+      SVN_ERR(svn_io_make_dir_recursively(pristine_dir_abspath,
+                                          scratch_pool));
+      SVN_ERR(svn_wc__get_pristine_contents_by_checksum(&wc_base_stream,
+                                                        ctx->wc_ctx,
+                                                        from_wc_abspath,
+                                                        checksum,
+                                                        scratch_pool,
+                                                        scratch_pool));
+      SVN_ERR(svn_stream_open_unique(&tmp_stream, &tmp_abspath,
+                                     pristine_dir_abspath,
+                                     svn_io_file_del_none,
+                                     scratch_pool, scratch_pool));
+      SVN_ERR(svn_stream_copy3(wc_base_stream, tmp_stream,
+                               NULL, NULL, scratch_pool));
+      SVN_ERR(svn_io_file_rename2(tmp_abspath, pristine_abspath, FALSE,
+                                  scratch_pool));
+    }
+
+  SVN_ERR(get_base_ref_abspath(&ref_abspath, shelf_version, wc_relpath,
+                               scratch_pool, scratch_pool));
+  SVN_ERR(svn_io_file_create(ref_abspath,
+                             svn_checksum_to_cstring(checksum, scratch_pool),
+                             scratch_pool));
+  return SVN_NO_ERROR;
+}
+
+/* Set *STREAM to a readable stream of the stored base text of
+ * SHELF_VERSION node at RELPATH, or to an empty stream if the node has
+ * no stored base text.  Set *ABSPATH to the file holding the base text
+ * in the current format if there is one, else to where the base text
+ * of the old format would be, no matter whether it exists.
+ */
+static svn_error_t *
+open_stored_base_text(svn_stream_t **stream,
+                      char **abspath,
+                      svn_client_shelf_version_t *shelf_version,
+                      const char *wc_relpath,
+                      apr_pool_t *result_pool,
+                      apr_pool_t *scratch_pool)
+{
+  char *ref_abspath;
+  svn_stringbuf_t *ref;
+  svn_checksum_t *checksum;
+  svn_node_kind_t kind;
+  svn_error_t *err;
+
+  SVN_ERR(get_base_ref_abspath(&ref_abspath, shelf_version, wc_relpath,
+                               scratch_pool, scratch_pool));
+  err = svn_stringbuf_from_file2(&ref, ref_abspath, scratch_pool);
+  if (err && APR_STATUS_IS_ENOENT(err->apr_err))
+    {
+      /* No reference: a shelf written in the old format or a node without
+       * base text. */
+      svn_error_clear(err);
+      SVN_ERR(get_base_file_abspath(abspath, shelf_version, wc_relpath,
+                                    result_pool, scratch_pool));
+      SVN_ERR(svn_io_check_path(*abspath, &kind, scratch_pool));
+      if (kind == svn_node_file)
+        SVN_ERR(svn_stream_open_readonly(stream, *abspath,
+                                         result_pool, scratch_pool));
+      else
+        *stream = svn_stream_empty(result_pool);
+      return SVN_NO_ERROR;
+    }
+  SVN_ERR(err);
+
+  svn_stringbuf_strip_whitespace(ref);
+  SVN_ERR(svn_checksum_parse_hex(&checksum, svn_checksum_sha1, ref->data,
+                                 scratch_pool));
+  SVN_ERR(get_pristine_abspath(abspath, shelf_version->shelf, checksum,
+                               result_pool, scratch_pool));
+  SVN_ERR(svn_stream_open_readonly(stream, *abspath,
+                                   result_pool, scratch_pool));
+  return SVN_NO_ERROR;
+}
+
+/* Store the text of the working file at FROM_WC_ABSPATH in SHELF_VERSION
+ * as an svndiff delta against the base text stored for WC_RELPATH
+ * before.
+ */
+static svn_error_t *
+store_working_text(const char *from_wc_abspath,
+                   const char *wc_relpath,
+                   svn_client_shelf_version_t *shelf_version,
+                   apr_pool_t *scratch_pool)
+{
+  char *base_abspath;
+  char *delta_abspath;
+  svn_stream_t *base_stream;
+  svn_stream_t *work_stream;
+  svn_stream_t *delta_stream;
+  svn_txdelta_stream_t *txdelta_stream;
+  svn_txdelta_window_handler_t handler;
+  void *handler_baton;
+
+  SVN_ERR(open_stored_base_text(&base_stream, &base_abspath,
+                                shelf_version, wc_relpath,
+                                scratch_pool, scratch_pool));
+  SVN_ERR(svn_stream_open_readonly(&work_stream, from_wc_abspath,
+                                   scratch_pool, scratch_pool));
+  SVN_ERR(get_working_delta_abspath(&delta_abspath, shelf_version,
+                                    wc_relpath, scratch_pool, scratch_pool));
+  SVN_ERR(svn_stream_open_writable(&delta_stream, delta_abspath,
+                                   scratch_pool, scratch_pool));
+
+  /* The svndiff handler closes DELTA_STREAM at the end. */
+  svn_txdelta2(&txdelta_stream, base_stream, work_stream,
+               FALSE /*calculate_checksum*/, scratch_pool);
+  svn_txdelta_to_svndiff3(&handler, &handler_baton, delta_stream,
+                          1 /*svndiff_version*/,
+                          SVN_DELTA_COMPRESSION_LEVEL_DEFAULT,
+                          scratch_pool);
+  SVN_ERR(svn_txdelta_send_txstream(txdelta_stream, handler, handler_baton,
+                                    scratch_pool));
+
+  SVN_ERR(svn_stream_close(base_stream));
+  SVN_ERR(svn_stream_close(work_stream));
+  return SVN_NO_ERROR;
+}
+
+/* Set *BASE_ABSPATH and *WORK_ABSPATH to files with the stored base and
+ * working texts of SHELF_VERSION node at RELPATH, no matter whether they
+ * exist.  If the working text is stored as a delta, reconstruct it into
+ * a temporary file that will be removed when RESULT_POOL gets cleaned up.
+ */
+static svn_error_t *
+get_stored_texts(char **base_abspath,
+                 char **work_abspath,
+                 svn_client_shelf_version_t *shelf_version,
+                 const char *wc_relpath,
+                 apr_pool_t *result_pool,
+                 apr_pool_t *scratch_pool)
+{
+  char *delta_abspath;
+  const char *tmp_abspath;
+  svn_stream_t *base_stream;
+  svn_stream_t *delta_stream;
+  svn_stream_t *work_stream;
+  svn_txdelta_window_handler_t handler;
+  void *handler_baton;
+  svn_node_kind_t kind;
+
+  SVN_ERR(open_stored_base_text(&base_stream, base_abspath,
+                                shelf_version, wc_relpath,
+                                result_pool, scratch_pool));
+
+  SVN_ERR(get_working_delta_abspath(&delta_abspath, shelf_version,
+                                    wc_relpath, scratch_pool, scratch_pool));
+  SVN_ERR(svn_io_check_path(delta_abspath, &kind, scratch_pool));
+  if (kind != svn_node_file)
+    {
+      /* The old format, or no working text at all. */
+      SVN_ERR(svn_stream_close(base_stream));
+      return svn_error_trace(get_working_file_abspath(work_abspath,
+                                                      shelf_version,
+                                                      wc_relpath,
+                                                      result_pool,
+                                                      scratch_pool));
+    }
+
+  SVN_ERR(svn_stream_open_unique(&work_stream, &tmp_abspath, NULL,
+                                 svn_io_file_del_on_pool_cleanup,
+                                 result_pool, scratch_pool));
+  SVN_ERR(svn_stream_open_readonly(&delta_stream, delta_abspath,
+                                   scratch_pool, scratch_pool));
+
+  /* Applying the last window closes WORK_STREAM. */
+  svn_txdelta_apply(base_stream, work_stream, NULL, NULL, scratch_pool,
+                    &handler, &handler_baton);
+  SVN_ERR(svn_stream_copy3(delta_stream,
+                           svn_txdelta_parse_svndiff(handler, handler_baton,
+                                                     TRUE, scratch_pool),
+                           NULL, NULL, scratch_pool));
+  SVN_ERR(svn_stream_close(base_stream));
+
+  *work_abspath = apr_pstrdup(result_pool, tmp_abspath);
+  return SVN_NO_ERROR;
+}
+
+/* Store metadata for any node, and base and working texts if it's a file.
  *
- * Copy the WC base and working files at FROM_WC_ABSPATH to the storage
- * area in SHELF_VERSION.
+ * Store a reference to the WC base text of FROM_WC_ABSPATH and a delta
+ * of its working text against it in the storage area in SHELF_VERSION.
  */
 static svn_error_t *
 store_file(const char *from_wc_abspath,
@@ -936,35 +1218,23 @@ store_file(const char *from_wc_abspath,
   /* file text */
   if (status->kind == svn_node_file)
     {
-      svn_stream_t *wc_base_stream;
+      const svn_checksum_t *base_checksum;
       svn_node_kind_t work_kind;
 
-      /* Copy the base file (copy-from base, if copied/moved), if present */
-      SVN_ERR(svn_wc_get_pristine_contents2(&wc_base_stream,
-                                            ctx->wc_ctx, from_wc_abspath,
-                                            scratch_pool, scratch_pool));
-      if (wc_base_stream)
-        {
-          char *stored_base_abspath;
-          svn_stream_t *stored_base_stream;
+      /* Reference the base text (copy-from base, if copied/moved), if
+       * present */
+      SVN_ERR(svn_wc__node_get_pristine_sha1(&base_checksum,
+                                             ctx->wc_ctx, from_wc_abspath,
+                                             scratch_pool, scratch_pool));
+      if (base_checksum)
+        SVN_ERR(store_base_text(from_wc_abspath, wc_relpath, base_checksum,
+                                shelf_version, ctx, scratch_pool));
 
-          SVN_ERR(get_base_file_abspath(&stored_base_abspath,
-                                        shelf_version, wc_relpath,
-                                        scratch_pool, scratch_pool));
-          SVN_ERR(svn_stream_open_writable(&stored_base_stream,
-                                           stored_base_abspath,
-                                           scratch_pool, scratch_pool));
-          SVN_ERR(svn_stream_copy3(wc_base_stream, stored_base_stream,
-                                   NULL, NULL, scratch_pool));
-        }
-
-      /* Copy the working file, if present */
+      /* Store the working text as a delta, if present */
       SVN_ERR(svn_io_check_path(from_wc_abspath, &work_kind, scratch_pool));
       if (work_kind == svn_node_file)
-        {
-          SVN_ERR(svn_io_copy_file(from_wc_abspath, stored_abspath,
-                                   TRUE /*copy_perms*/, scratch_pool));
-        }
+        SVN_ERR(store_working_text(from_wc_abspath, wc_relpath,
+                                   shelf_version, scratch_pool));
     }
   return SVN_NO_ERROR;
 }
@@ -1264,6 +1534,11 @@ svn_client_shelf_delete(const char *name,
   SVN_ERR(svn_io_remove_file2(abspath, TRUE /*ignore_enoent*/, scratch_pool));
   SVN_ERR(get_current_abspath(&abspath, shelf, scratch_pool));
   SVN_ERR(svn_io_remove_file2(abspath, TRUE /*ignore_enoent*/, scratch_pool));
+  SVN_ERR(get_pristine_dir_abspath(&abspath, shelf,
+                                   scratch_pool, scratch_pool));
+  SVN_ERR(svn_io_remove_dir2(abspath, TRUE /*ignore_enoent*/,
+                             NULL, NULL, /*cancel*/
+                             scratch_pool));
 
   SVN_ERR(svn_client_shelf_close(shelf, scratch_pool));
   return SVN_NO_ERROR;
@@ -1513,12 +1788,9 @@ apply_file_visitor(void *baton,
                                               scratch_pool);
   const char *to_dir_abspath = svn_dirent_dirname(to_wc_abspath, scratch_pool);
 
-  SVN_ERR(get_base_file_abspath(&stored_base_abspath,
-                                b->shelf_version, relpath,
-                                scratch_pool, scratch_pool));
-  SVN_ERR(get_working_file_abspath(&stored_work_abspath,
-                                   b->shelf_version, relpath,
-                                   scratch_pool, scratch_pool));
+  SVN_ERR(get_stored_texts(&stored_base_abspath, &stored_work_abspath,
+                           b->shelf_version, relpath,
+                           scratch_pool, scratch_pool));
   SVN_ERR(read_props_from_shelf(&base_props, &work_props,
                                 s->node_status,
                                 b->shelf_version, relpath,
@@ -1772,12 +2044,9 @@ diff_visitor(void *baton,
 
       left_source = svn_diff__source_create(s->revision, scratch_pool);
       right_source = svn_diff__source_create(SVN_INVALID_REVNUM, scratch_pool);
-      SVN_ERR(get_base_file_abspath(&left_stored_abspath,
-                                    b->shelf_version, relpath,
-                                    scratch_pool, scratch_pool));
-      SVN_ERR(get_working_file_abspath(&right_stored_abspath,
-                                       b->shelf_version, relpath,
-                                       scratch_pool, scratch_pool));
+      SVN_ERR(get_stored_texts(&left_stored_abspath, &right_stored_abspath,
+                               b->shelf_version, relpath,
+                               scratch_pool, scratch_pool));
 
       switch (s->node_status)
         {
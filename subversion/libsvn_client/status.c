@@ -665,11 +665,16 @@ svn_client_status6(svn_revnum_t *result_rev,
       SVN_ERR(shelves_status(changelists, target_abspath,
                              tweak_status, &sb,
                              ctx, pool));
+      /* Nothing in this walk writes to the working copy. */
+      SVN_ERR(svn_wc__begin_read_snapshot(ctx->wc_ctx, target_abspath,
+                                          pool));
       err = svn_wc_walk_status(ctx->wc_ctx, target_abspath,
                                depth, get_all, no_ignore, FALSE, ignores,
                                tweak_status, &sb,
                                ctx->cancel_func, ctx->cancel_baton,
                                pool);
+      err = svn_wc__end_read_snapshot(ctx->wc_ctx, target_abspath, err,
+                                      pool);
 
       if (err && err->apr_err == SVN_ERR_WC_MISSING)
         {
@@ -37,10 +37,12 @@
 #include "svn_path.h"
 #include "svn_pools.h"
 #include "svn_io.h"
+#include "svn_sorts.h"
 #include "client.h"
 
 #include "svn_private_config.h"
 #include "private/svn_wc_private.h"
+#include "private/svn_worker_pool.h"
 
 /* Implements svn_wc_dirents_func_t for update and switch handling. Assumes
    a struct svn_client__dirent_fetcher_baton_t * baton */
@@ -264,6 +266,963 @@ reuse_ra_session(svn_ra_session_t **ra_session_p,
   return SVN_NO_ERROR;
 }
 
+/*** Concurrent checkout.
+ *
+ * A fresh checkout of a tree at depth infinity receives the whole tree
+ * through a single update report.  With more than one checkout thread,
+ * update_internal() first receives the target at depth immediates and
+ * then checks out every top-level directory at depth infinity through
+ * its own update report.  Worker threads with an RA session each drive
+ * those reports.  Their editors only record the editor calls in a
+ * checkout_queue_t, and the caller's thread replays them on one update
+ * editor per directory, so only that thread ever writes to the working
+ * copy.
+ *
+ * All recorded calls live in their own pool together with copies of
+ * their arguments.  The pool of the call that opened a directory or file
+ * also holds the checkout_node_t representing it, and gets destroyed by
+ * the caller's thread when that node is closed.
+ ***/
+
+#if APR_HAS_THREADS
+
+/* Upper limit to the number of worker threads of a checkout. */
+#define CHECKOUT_MAX_THREADS 16
+
+/* Don't let more than this many editor calls pile up per thread. */
+#define CHECKOUT_QUEUE_OPS_PER_THREAD 256
+
+/* The editor callback recorded in a checkout_op_t. */
+typedef enum checkout_op_kind_t
+{
+  checkout_op_set_target_revision,
+  checkout_op_open_root,
+  checkout_op_delete_entry,
+  checkout_op_add_directory,
+  checkout_op_open_directory,
+  checkout_op_change_dir_prop,
+  checkout_op_close_directory,
+  checkout_op_absent_directory,
+  checkout_op_add_file,
+  checkout_op_open_file,
+  checkout_op_apply_textdelta,
+  checkout_op_textdelta_window,
+  checkout_op_change_file_prop,
+  checkout_op_close_file,
+  checkout_op_absent_file,
+  checkout_op_close_edit,
+  checkout_op_abort_edit
+} checkout_op_kind_t;
+
+/* A directory or file opened by a recorded editor drive. */
+typedef struct checkout_node_t
+{
+  /* The directory being checked out that contains this node. */
+  struct checkout_subtree_t *subtree;
+
+  /* The baton and pool of the node in the update editor.  Only used by
+     the caller's thread. */
+  void *baton;
+  apr_pool_t *pool;
+
+  /* Window handler returned by the update editor's apply_textdelta. */
+  svn_txdelta_window_handler_t handler;
+  void *handler_baton;
+
+  /* The pool of the editor call that opened this node. */
+  apr_pool_t *op_pool;
+} checkout_node_t;
+
+/* One top-level directory to check out. */
+typedef struct checkout_subtree_t
+{
+  /* Working copy path and URL of the directory. */
+  const char *local_abspath;
+  const char *url;
+
+  /* The update editor for this directory and its target revision. */
+  const svn_delta_editor_t *editor;
+  void *edit_baton;
+  svn_revnum_t target_revision;
+
+  /* The queue that the recording editor adds to. */
+  struct checkout_queue_t *queue;
+} checkout_subtree_t;
+
+/* One recorded editor call. */
+typedef struct checkout_op_t
+{
+  checkout_op_kind_t kind;
+  checkout_subtree_t *subtree;
+
+  /* The directory or file that the call applies to, i.e. the parent
+     for added, opened, deleted and absent nodes. */
+  checkout_node_t *node;
+
+  /* The node opened by this call, if any. */
+  checkout_node_t *new_node;
+
+  /* The callback's arguments, as far as applicable. */
+  const char *path;
+  const char *copyfrom_path;
+  svn_revnum_t revision;
+  const svn_string_t *value;
+  const char *checksum;
+  svn_txdelta_window_t *window;
+
+  /* Pool containing this structure and all of the above. */
+  apr_pool_t *pool;
+
+  /* Next call in the queue. */
+  struct checkout_op_t *next;
+} checkout_op_t;
+
+/* A worker thread and its RA session. */
+typedef struct checkout_worker_t
+{
+  struct checkout_queue_t *queue;
+  svn_ra_session_t *ra_session;
+
+  /* The job driving this worker's update reports. */
+  svn_worker_pool__job_t *job;
+
+  /* Root pool owned by this worker, containing RA_SESSION and JOB. */
+  apr_pool_t *pool;
+} checkout_worker_t;
+
+typedef struct checkout_queue_t
+{
+  /* Revision to check out. */
+  svn_revnum_t revision;
+
+  /* The recording editor. */
+  svn_delta_editor_t *editor;
+
+  /* The directories to check out. */
+  checkout_subtree_t *subtrees;
+  int subtree_count;
+
+  /* Pool for the update editors' node pools, used by the caller's
+     thread only. */
+  apr_pool_t *pool;
+
+  /* Thread-safe pool, the parent of all checkout_op_t pools. */
+  apr_pool_t *op_pool;
+
+  /* Runs one checkout_job() per worker.  Its mutex protects all members
+     below; it gets notified whenever a call got added or removed or a
+     worker finished, and when shutting down. */
+  svn_worker_pool__t *threads;
+
+  /* Recorded editor calls in the order of the workers' drives. */
+  checkout_op_t *first;
+  checkout_op_t *last;
+  int count;
+  int max_count;
+
+  /* Index of the first subtree not picked up by any worker yet. */
+  int next_subtree;
+
+  /* Number of workers that have not finished yet. */
+  int running;
+
+  /* Set when a worker failed or the queue is about to be destroyed. */
+  svn_boolean_t shutdown;
+
+  /* The workers, one per thread. */
+  checkout_worker_t workers[CHECKOUT_MAX_THREADS];
+} checkout_queue_t;
+
+/* Set *OP to a new recorded call of KIND for SUBTREE, applying to NODE,
+   in its own pool. */
+static void
+create_checkout_op(checkout_op_t **op,
+                   checkout_subtree_t *subtree,
+                   checkout_op_kind_t kind,
+                   checkout_node_t *node)
+{
+  apr_pool_t *pool = svn_pool_create(subtree->queue->op_pool);
+
+  *op = apr_pcalloc(pool, sizeof(**op));
+  (*op)->kind = kind;
+  (*op)->subtree = subtree;
+  (*op)->node = node;
+  (*op)->revision = SVN_INVALID_REVNUM;
+  (*op)->pool = pool;
+}
+
+/* Return a new node opened by OP and set it as OP's NEW_NODE. */
+static checkout_node_t *
+create_checkout_node(checkout_op_t *op)
+{
+  checkout_node_t *node = apr_pcalloc(op->pool, sizeof(*node));
+
+  node->subtree = op->subtree;
+  node->op_pool = op->pool;
+  op->new_node = node;
+
+  return node;
+}
+
+/* Append OP to its queue, waiting while the queue is full.  Return
+   SVN_ERR_CANCELLED if the queue has been shut down. */
+static svn_error_t *
+queue_checkout_op(checkout_op_t *op)
+{
+  checkout_queue_t *queue = op->subtree->queue;
+  svn_error_t *err = SVN_NO_ERROR;
+
+  SVN_ERR(svn_worker_pool__lock(queue->threads));
+  while (!err && queue->count >= queue->max_count && !queue->shutdown
+         && !svn_worker_pool__stopping(queue->threads))
+    err = svn_worker_pool__wait_for_change(queue->threads);
+
+  if (err || queue->shutdown || svn_worker_pool__stopping(queue->threads))
+    {
+      SVN_ERR(svn_worker_pool__unlock(queue->threads, err));
+      svn_pool_destroy(op->pool);
+      return svn_error_create(SVN_ERR_CANCELLED, NULL, NULL);
+    }
+
+  if (queue->last)
+    queue->last->next = op;
+  else
+    queue->first = op;
+  queue->last = op;
+  queue->count++;
+
+  return svn_error_trace(svn_worker_pool__unlock(queue->threads,
+                           svn_worker_pool__notify(queue->threads)));
+}
+
+/* The recording editor.  Its callbacks run in the worker threads.  The
+   edit baton is the checkout_subtree_t, all other batons are
+   checkout_node_t. */
+
+static svn_error_t *
+record_set_target_revision(void *edit_baton,
+                           svn_revnum_t target_revision,
+                           apr_pool_t *pool)
+{
+  checkout_op_t *op;
+
+  create_checkout_op(&op, edit_baton, checkout_op_set_target_revision,
+                     NULL);
+  op->revision = target_revision;
+
+  return svn_error_trace(queue_checkout_op(op));
+}
+
+static svn_error_t *
+record_open_root(void *edit_baton,
+                 svn_revnum_t base_revision,
+                 apr_pool_t *dir_pool,
+                 void **root_baton)
+{
+  checkout_op_t *op;
+
+  create_checkout_op(&op, edit_baton, checkout_op_open_root, NULL);
+  op->revision = base_revision;
+  *root_baton = create_checkout_node(op);
+
+  return svn_error_trace(queue_checkout_op(op));
+}
+
+static svn_error_t *
+record_delete_entry(const char *path,
+                    svn_revnum_t revision,
+                    void *parent_baton,
+                    apr_pool_t *pool)
+{
+  checkout_node_t *parent = parent_baton;
+  checkout_op_t *op;
+
+  create_checkout_op(&op, parent->subtree, checkout_op_delete_entry,
+                     parent);
+  op->path = apr_pstrdup(op->pool, path);
+  op->revision = revision;
+
+  return svn_error_trace(queue_checkout_op(op));
+}
+
+/* Record an add_* or open_* call of KIND for PATH in PARENT_BATON and
+   return the new node in *CHILD_BATON.  COPYFROM_PATH is NULL for open_*
+   calls and REVISION is the respective revision argument. */
+static svn_error_t *
+record_child(checkout_op_kind_t kind,
+             const char *path,
+             void *parent_baton,
+             const char *copyfrom_path,
+             svn_revnum_t revision,
+             void **child_baton)
+{
+  checkout_node_t *parent = parent_baton;
+  checkout_op_t *op;
+
+  create_checkout_op(&op, parent->subtree, kind, parent);
+  op->path = apr_pstrdup(op->pool, path);
+  op->copyfrom_path = copyfrom_path ? apr_pstrdup(op->pool, copyfrom_path)
+                                    : NULL;
+  op->revision = revision;
+  *child_baton = create_checkout_node(op);
+
+  return svn_error_trace(queue_checkout_op(op));
+}
+
+static svn_error_t *
+record_add_directory(const char *path,
+                     void *parent_baton,
+                     const char *copyfrom_path,
+                     svn_revnum_t copyfrom_revision,
+                     apr_pool_t *dir_pool,
+                     void **child_baton)
+{
+  return svn_error_trace(record_child(checkout_op_add_directory, path,
+                                      parent_baton, copyfrom_path,
+                                      copyfrom_revision, child_baton));
+}
+
+static svn_error_t *
+record_open_directory(const char *path,
+                      void *parent_baton,
+                      svn_revnum_t base_revision,
+                      apr_pool_t *dir_pool,
+                      void **child_baton)
+{
+  return svn_error_trace(record_child(checkout_op_open_directory, path,
+                                      parent_baton, NULL, base_revision,
+                                      child_baton));
+}
+
+static svn_error_t *
+record_add_file(const char *path,
+                void *parent_baton,
+                const char *copyfrom_path,
+                svn_revnum_t copyfrom_revision,
+                apr_pool_t *file_pool,
+                void **file_baton)
+{
+  return svn_error_trace(record_child(checkout_op_add_file, path,
+                                      parent_baton, copyfrom_path,
+                                      copyfrom_revision, file_baton));
+}
+
+static svn_error_t *
+record_open_file(const char *path,
+                 void *parent_baton,
+                 svn_revnum_t base_revision,
+                 apr_pool_t *file_pool,
+                 void **file_baton)
+{
+  return svn_error_trace(record_child(checkout_op_open_file, path,
+                                      parent_baton, NULL, base_revision,
+                                      file_baton));
+}
+
+/* Record a change_*_prop call of KIND for NAME and VALUE on BATON. */
+static svn_error_t *
+record_prop(checkout_op_kind_t kind,
+            void *baton,
+            const char *name,
+            const svn_string_t *value)
+{
+  checkout_node_t *node = baton;
+  checkout_op_t *op;
+
+  create_checkout_op(&op, node->subtree, kind, node);
+  op->path = apr_pstrdup(op->pool, name);
+  op->value = value ? svn_string_dup(value, op->pool) : NULL;
+
+  return svn_error_trace(queue_checkout_op(op));
+}
+
+static svn_error_t *
+record_change_dir_prop(void *dir_baton,
+                       const char *name,
+                       const svn_string_t *value,
+                       apr_pool_t *pool)
+{
+  return svn_error_trace(record_prop(checkout_op_change_dir_prop,
+                                     dir_baton, name, value));
+}
+
+static svn_error_t *
+record_change_file_prop(void *file_baton,
+                        const char *name,
+                        const svn_string_t *value,
+                        apr_pool_t *pool)
+{
+  return svn_error_trace(record_prop(checkout_op_change_file_prop,
+                                     file_baton, name, value));
+}
+
+/* Record a close_* call of KIND on BATON.  CHECKSUM is the text checksum
+   of closed files. */
+static svn_error_t *
+record_close(checkout_op_kind_t kind,
+             void *baton,
+             const char *checksum)
+{
+  checkout_node_t *node = baton;
+  checkout_op_t *op;
+
+  create_checkout_op(&op, node->subtree, kind, node);
+  op->checksum = checksum ? apr_pstrdup(op->pool, checksum) : NULL;
+
+  return svn_error_trace(queue_checkout_op(op));
+}
+
+static svn_error_t *
+record_close_directory(void *dir_baton,
+                       apr_pool_t *pool)
+{
+  return svn_error_trace(record_close(checkout_op_close_directory,
+                                      dir_baton, NULL));
+}
+
+static svn_error_t *
+record_close_file(void *file_baton,
+                  const char *text_checksum,
+                  apr_pool_t *pool)
+{
+  return svn_error_trace(record_close(checkout_op_close_file,
+                                      file_baton, text_checksum));
+}
+
+/* Record an absent_* call of KIND for PATH in PARENT_BATON. */
+static svn_error_t *
+record_absent(checkout_op_kind_t kind,
+              const char *path,
+              void *parent_baton)
+{
+  checkout_node_t *parent = parent_baton;
+  checkout_op_t *op;
+
+  create_checkout_op(&op, parent->subtree, kind, parent);
+  op->path = apr_pstrdup(op->pool, path);
+
+  return svn_error_trace(queue_checkout_op(op));
+}
+
+static svn_error_t *
+record_absent_directory(const char *path,
+                        void *parent_baton,
+                        apr_pool_t *pool)
+{
+  return svn_error_trace(record_absent(checkout_op_absent_directory,
+                                       path, parent_baton));
+}
+
+static svn_error_t *
+record_absent_file(const char *path,
+                   void *parent_baton,
+                   apr_pool_t *pool)
+{
+  return svn_error_trace(record_absent(checkout_op_absent_file,
+                                       path, parent_baton));
+}
+
+/* Implements svn_txdelta_window_handler_t for the recording editor.
+   BATON is the checkout_node_t of the file. */
+static svn_error_t *
+record_textdelta_window(svn_txdelta_window_t *window,
+                        void *baton)
+{
+  checkout_node_t *node = baton;
+  checkout_op_t *op;
+
+  create_checkout_op(&op, node->subtree, checkout_op_textdelta_window,
+                     node);
+  op->window = window ? svn_txdelta_window_dup(window, op->pool) : NULL;
+
+  return svn_error_trace(queue_checkout_op(op));
+}
+
+static svn_error_t *
+record_apply_textdelta(void *file_baton,
+                       const char *base_checksum,
+                       apr_pool_t *pool,
+                       svn_txdelta_window_handler_t *handler,
+                       void **handler_baton)
+{
+  checkout_node_t *node = file_baton;
+  checkout_op_t *op;
+
+  create_checkout_op(&op, node->subtree, checkout_op_apply_textdelta,
+                     node);
+  op->checksum = base_checksum ? apr_pstrdup(op->pool, base_checksum)
+                               : NULL;
+
+  *handler = record_textdelta_window;
+  *handler_baton = node;
+  return svn_error_trace(queue_checkout_op(op));
+}
+
+static svn_error_t *
+record_close_edit(void *edit_baton,
+                  apr_pool_t *pool)
+{
+  checkout_op_t *op;
+
+  create_checkout_op(&op, edit_baton, checkout_op_close_edit, NULL);
+  return svn_error_trace(queue_checkout_op(op));
+}
+
+static svn_error_t *
+record_abort_edit(void *edit_baton,
+                  apr_pool_t *pool)
+{
+  checkout_op_t *op;
+
+  create_checkout_op(&op, edit_baton, checkout_op_abort_edit, NULL);
+  return svn_error_trace(queue_checkout_op(op));
+}
+
+/* Replay the recorded call OP on the update editor of its subtree, using
+   SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+replay_checkout_op(checkout_op_t *op,
+                   apr_pool_t *scratch_pool)
+{
+  const svn_delta_editor_t *editor = op->subtree->editor;
+  void *edit_baton = op->subtree->edit_baton;
+  checkout_node_t *node = op->node;
+  checkout_node_t *new_node = op->new_node;
+
+  switch (op->kind)
+    {
+      case checkout_op_set_target_revision:
+        return svn_error_trace(editor->set_target_revision(edit_baton,
+                                                           op->revision,
+                                                           scratch_pool));
+      case checkout_op_open_root:
+        new_node->pool = svn_pool_create(op->subtree->queue->pool);
+        return svn_error_trace(editor->open_root(edit_baton, op->revision,
+                                                 new_node->pool,
+                                                 &new_node->baton));
+      case checkout_op_delete_entry:
+        return svn_error_trace(editor->delete_entry(op->path, op->revision,
+                                                    node->baton,
+                                                    scratch_pool));
+      case checkout_op_add_directory:
+        new_node->pool = svn_pool_create(node->pool);
+        return svn_error_trace(editor->add_directory(op->path, node->baton,
+                                                     op->copyfrom_path,
+                                                     op->revision,
+                                                     new_node->pool,
+                                                     &new_node->baton));
+      case checkout_op_open_directory:
+        new_node->pool = svn_pool_create(node->pool);
+        return svn_error_trace(editor->open_directory(op->path,
+                                                      node->baton,
+                                                      op->revision,
+                                                      new_node->pool,
+                                                      &new_node->baton));
+      case checkout_op_change_dir_prop:
+        return svn_error_trace(editor->change_dir_prop(node->baton,
+                                                       op->path, op->value,
+                                                       scratch_pool));
+      case checkout_op_close_directory:
+        return svn_error_trace(editor->close_directory(node->baton,
+                                                       scratch_pool));
+      case checkout_op_absent_directory:
+        return svn_error_trace(editor->absent_directory(op->path,
+                                                        node->baton,
+                                                        scratch_pool));
+      case checkout_op_add_file:
+        new_node->pool = svn_pool_create(node->pool);
+        return svn_error_trace(editor->add_file(op->path, node->baton,
+                                                op->copyfrom_path,
+                                                op->revision,
+                                                new_node->pool,
+                                                &new_node->baton));
+      case checkout_op_open_file:
+        new_node->pool = svn_pool_create(node->pool);
+        return svn_error_trace(editor->open_file(op->path, node->baton,
+                                                 op->revision,
+                                                 new_node->pool,
+                                                 &new_node->baton));
+      case checkout_op_apply_textdelta:
+        return svn_error_trace(editor->apply_textdelta(node->baton,
+                                                       op->checksum,
+                                                       node->pool,
+                                                       &node->handler,
+                                                       &node->handler_baton));
+      case checkout_op_textdelta_window:
+        return svn_error_trace(node->handler(op->window,
+                                             node->handler_baton));
+      case checkout_op_change_file_prop:
+        return svn_error_trace(editor->change_file_prop(node->baton,
+                                                        op->path, op->value,
+                                                        scratch_pool));
+      case checkout_op_close_file:
+        return svn_error_trace(editor->close_file(node->baton, op->checksum,
+                                                  scratch_pool));
+      case checkout_op_absent_file:
+        return svn_error_trace(editor->absent_file(op->path, node->baton,
+                                                   scratch_pool));
+      case checkout_op_close_edit:
+        return svn_error_trace(editor->close_edit(edit_baton, scratch_pool));
+      default:
+        return svn_error_trace(editor->abort_edit(edit_baton, scratch_pool));
+    }
+}
+
+/* Send an update report for SUBTREE through RA_SESSION and let the server
+   drive EDITOR with EDIT_BATON.  SUBTREE is at depth empty in revision
+   REVISION and will be updated to depth infinity in REVISION.  Use
+   SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+drive_checkout_subtree(svn_ra_session_t *ra_session,
+                       checkout_subtree_t *subtree,
+                       svn_revnum_t revision,
+                       const svn_delta_editor_t *editor,
+                       void *edit_baton,
+                       apr_pool_t *scratch_pool)
+{
+  const svn_ra_reporter3_t *reporter;
+  void *report_baton;
+
+  SVN_ERR(svn_ra_reparent(ra_session, subtree->url, scratch_pool));
+  SVN_ERR(svn_ra_do_update3(ra_session, &reporter, &report_baton,
+                            revision, "", svn_depth_infinity,
+                            FALSE /* send_copyfrom_args */,
+                            FALSE /* ignore_ancestry */,
+                            editor, edit_baton,
+                            scratch_pool, scratch_pool));
+
+  /* This is what svn_wc_crawl_revisions5() reports for a directory
+     without children at depth empty. */
+  SVN_ERR(reporter->set_path(report_baton, "", revision, svn_depth_empty,
+                             FALSE, NULL, scratch_pool));
+
+  return svn_error_trace(reporter->finish_report(report_baton,
+                                                 scratch_pool));
+}
+
+/* Implements svn_worker_pool__func_t.  BATON is the checkout_worker_t. */
+static svn_error_t *
+checkout_job(void *baton,
+             apr_pool_t *scratch_pool)
+{
+  checkout_worker_t *worker = baton;
+  checkout_queue_t *queue = worker->queue;
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  svn_error_t *err = SVN_NO_ERROR;
+
+  svn_error_clear(svn_worker_pool__lock(queue->threads));
+  while (!err && !queue->shutdown
+         && queue->next_subtree < queue->subtree_count)
+    {
+      checkout_subtree_t *subtree = &queue->subtrees[queue->next_subtree++];
+
+      svn_error_clear(svn_worker_pool__unlock(queue->threads, SVN_NO_ERROR));
+      svn_pool_clear(iterpool);
+      err = drive_checkout_subtree(worker->ra_session, subtree,
+                                   queue->revision, queue->editor, subtree,
+                                   iterpool);
+      svn_error_clear(svn_worker_pool__lock(queue->threads));
+    }
+
+  /* Don't let the caller wait for calls that will never come. */
+  if (err)
+    queue->shutdown = TRUE;
+
+  queue->running--;
+  svn_error_clear(svn_worker_pool__notify(queue->threads));
+  svn_error_clear(svn_worker_pool__unlock(queue->threads, SVN_NO_ERROR));
+
+  svn_pool_destroy(iterpool);
+  return svn_error_trace(err);
+}
+
+/* Tell the workers of QUEUE to give up, wait for them to finish and
+   return their errors.  Prefer the error that made the others give up. */
+static svn_error_t *
+finish_checkout_workers(checkout_queue_t *queue)
+{
+  svn_error_t *err = SVN_NO_ERROR;
+  svn_error_t *cancelled = SVN_NO_ERROR;
+  int i;
+
+  SVN_ERR(svn_worker_pool__lock(queue->threads));
+  queue->shutdown = TRUE;
+  SVN_ERR(svn_worker_pool__unlock(queue->threads,
+            svn_worker_pool__notify(queue->threads)));
+
+  for (i = 0; i < CHECKOUT_MAX_THREADS; i++)
+    if (queue->workers[i].job)
+      {
+        svn_error_t *job_err = svn_worker_pool__wait(queue->workers[i].job);
+
+        if (!job_err)
+          continue;
+
+        if (job_err->apr_err != SVN_ERR_CANCELLED && !err)
+          err = job_err;
+        else if (job_err->apr_err == SVN_ERR_CANCELLED && !cancelled)
+          cancelled = job_err;
+        else
+          svn_error_clear(job_err);
+      }
+
+  if (err)
+    {
+      svn_error_clear(cancelled);
+      return svn_error_trace(err);
+    }
+
+  return svn_error_trace(cancelled);
+}
+
+/* Pool cleanup function releasing the workers and all recorded calls of
+   the checkout_queue_t in DATA. */
+static apr_status_t
+release_checkout_queue(void *data)
+{
+  checkout_queue_t *queue = data;
+  int i;
+
+  /* Runs after the workers are gone. */
+  for (i = 0; i < CHECKOUT_MAX_THREADS; i++)
+    if (queue->workers[i].pool)
+      svn_pool_destroy(queue->workers[i].pool);
+
+  svn_pool_destroy(queue->op_pool);
+
+  return APR_SUCCESS;
+}
+
+/* Replay the recorded calls of QUEUE until all workers are finished.
+   Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+run_checkout_queue(checkout_queue_t *queue,
+                   apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+
+  while (TRUE)
+    {
+      checkout_op_t *op;
+      checkout_node_t *closed = NULL;
+      svn_error_t *err;
+
+      err = SVN_NO_ERROR;
+      SVN_ERR(svn_worker_pool__lock(queue->threads));
+      while (!err && !queue->first && queue->running && !queue->shutdown)
+        err = svn_worker_pool__wait_for_change(queue->threads);
+
+      op = (err || queue->shutdown) ? NULL : queue->first;
+      if (op)
+        {
+          queue->first = op->next;
+          if (!queue->first)
+            queue->last = NULL;
+          queue->count--;
+          err = svn_worker_pool__notify(queue->threads);
+        }
+      SVN_ERR(svn_worker_pool__unlock(queue->threads, err));
+
+      if (!op)
+        break;
+
+      svn_pool_clear(iterpool);
+      err = replay_checkout_op(op, iterpool);
+
+      /* Nodes live until they get closed. */
+      if (op->kind == checkout_op_close_directory
+          || op->kind == checkout_op_close_file)
+        closed = op->node;
+      if (!op->new_node)
+        svn_pool_destroy(op->pool);
+      if (closed)
+        {
+          svn_pool_destroy(closed->pool);
+          svn_pool_destroy(closed->op_pool);
+        }
+
+      SVN_ERR(err);
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Check out the top-level directories below LOCAL_ABSPATH, which has
+   just been updated to REVISION at depth immediates from ANCHOR_URL,
+   through up to THREADS concurrent update reports.  The other parameters
+   are as for update_internal() and configure the update editors.  Use
+   SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+checkout_subtrees(const char *local_abspath,
+                  const char *anchor_url,
+                  svn_revnum_t revision,
+                  int threads,
+                  apr_hash_t *conflicted_paths,
+                  svn_boolean_t use_commit_times,
+                  svn_boolean_t allow_unver_obstructions,
+                  svn_boolean_t adds_as_modification,
+                  const char *diff3_cmd,
+                  const apr_array_header_t *preserved_exts,
+                  struct svn_client__dirent_fetcher_baton_t *dfb,
+                  svn_client_ctx_t *ctx,
+                  apr_pool_t *scratch_pool)
+{
+  apr_pool_t *queue_pool = svn_pool_create(scratch_pool);
+  checkout_queue_t *queue = apr_pcalloc(queue_pool, sizeof(*queue));
+  const apr_array_header_t *children;
+  svn_error_t *err;
+  int i;
+
+  SVN_ERR(svn_wc__node_get_children_of_working_node(&children, ctx->wc_ctx,
+                                                    local_abspath,
+                                                    scratch_pool,
+                                                    scratch_pool));
+
+  queue->pool = queue_pool;
+  queue->revision = revision;
+  queue->subtrees = apr_pcalloc(queue_pool,
+                                children->nelts * sizeof(*queue->subtrees));
+
+  for (i = 0; i < children->nelts; i++)
+    {
+      const char *child_abspath = APR_ARRAY_IDX(children, i, const char *);
+      checkout_subtree_t *subtree = &queue->subtrees[queue->subtree_count];
+      svn_node_kind_t kind;
+
+      SVN_ERR(svn_wc_read_kind2(&kind, ctx->wc_ctx, child_abspath,
+                                FALSE, FALSE, scratch_pool));
+      if (kind != svn_node_dir)
+        continue;
+
+      subtree->local_abspath = child_abspath;
+      subtree->url = svn_path_url_add_component2(
+                         anchor_url, svn_dirent_basename(child_abspath, NULL),
+                         queue_pool);
+      subtree->target_revision = revision;
+      subtree->queue = queue;
+
+      SVN_ERR(svn_wc__get_update_editor(&subtree->editor,
+                                        &subtree->edit_baton,
+                                        &subtree->target_revision,
+                                        ctx->wc_ctx, child_abspath, "",
+                                        NULL, use_commit_times,
+                                        svn_depth_infinity, TRUE,
+                                        allow_unver_obstructions,
+                                        adds_as_modification,
+                                        TRUE /* server_performs_filtering */,
+                                        TRUE /* clean_checkout */,
+                                        diff3_cmd, preserved_exts,
+                                        svn_client__dirent_fetcher, dfb,
+                                        conflicted_paths
+                                          ? record_conflict : NULL,
+                                        conflicted_paths,
+                                        NULL, NULL,
+                                        ctx->cancel_func, ctx->cancel_baton,
+                                        ctx->notify_func2, ctx->notify_baton2,
+                                        queue_pool, scratch_pool));
+      queue->subtree_count++;
+    }
+
+  if (queue->subtree_count == 0)
+    {
+      svn_pool_destroy(queue_pool);
+      return SVN_NO_ERROR;
+    }
+
+  threads = MIN(MIN(threads, CHECKOUT_MAX_THREADS), queue->subtree_count);
+
+  queue->editor = svn_delta_default_editor(queue_pool);
+  queue->editor->set_target_revision = record_set_target_revision;
+  queue->editor->open_root = record_open_root;
+  queue->editor->delete_entry = record_delete_entry;
+  queue->editor->add_directory = record_add_directory;
+  queue->editor->open_directory = record_open_directory;
+  queue->editor->change_dir_prop = record_change_dir_prop;
+  queue->editor->close_directory = record_close_directory;
+  queue->editor->absent_directory = record_absent_directory;
+  queue->editor->add_file = record_add_file;
+  queue->editor->open_file = record_open_file;
+  queue->editor->apply_textdelta = record_apply_textdelta;
+  queue->editor->change_file_prop = record_change_file_prop;
+  queue->editor->close_file = record_close_file;
+  queue->editor->absent_file = record_absent_file;
+  queue->editor->close_edit = record_close_edit;
+  queue->editor->abort_edit = record_abort_edit;
+
+  /* The workers' calls get allocated in, and released by, different
+     threads. */
+  queue->op_pool = apr_allocator_owner_get(svn_pool_create_allocator(TRUE));
+  queue->max_count = threads * CHECKOUT_QUEUE_OPS_PER_THREAD;
+
+  apr_pool_cleanup_register(queue_pool, queue, release_checkout_queue,
+                            apr_pool_cleanup_null);
+
+  /* Open all sessions up-front, so any authentication happens in this
+     thread.  The sessions don't access the working copy. */
+  for (i = 0; i < threads; i++)
+    {
+      checkout_worker_t *worker = &queue->workers[i];
+
+      worker->queue = queue;
+      worker->pool = apr_allocator_owner_get(svn_pool_create_allocator(FALSE));
+      SVN_ERR(svn_client__open_ra_session_internal(&worker->ra_session, NULL,
+                                                   anchor_url, NULL, NULL,
+                                                   FALSE, FALSE, ctx,
+                                                   worker->pool,
+                                                   scratch_pool));
+    }
+
+  SVN_ERR(svn_worker_pool__create(&queue->threads, threads, queue_pool));
+  if (queue->threads)
+    {
+      int count = svn_worker_pool__thread_count(queue->threads);
+
+      /* Set before any job can finish.  If posting fails, we don't wait
+         for the missing jobs. */
+      queue->running = count;
+
+      err = SVN_NO_ERROR;
+      for (i = 0; !err && i < count; i++)
+        err = svn_worker_pool__post(&queue->workers[i].job, queue->threads,
+                                    checkout_job, &queue->workers[i],
+                                    queue->workers[i].pool);
+
+      if (!err)
+        err = run_checkout_queue(queue, scratch_pool);
+
+      /* Once the workers are gone, their errors are final. */
+      if (err)
+        svn_error_clear(finish_checkout_workers(queue));
+      else
+        err = finish_checkout_workers(queue);
+    }
+  else
+    {
+      /* No threads available.  Drive the update editors directly. */
+      apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+
+      err = SVN_NO_ERROR;
+      for (i = 0; !err && i < queue->subtree_count; i++)
+        {
+          checkout_subtree_t *subtree = &queue->subtrees[i];
+
+          svn_pool_clear(iterpool);
+          err = drive_checkout_subtree(queue->workers[0].ra_session,
+                                       subtree, revision, subtree->editor,
+                                       subtree->edit_baton, iterpool);
+        }
+
+      svn_pool_destroy(iterpool);
+    }
+
+  svn_pool_destroy(queue_pool);
+
+  return svn_error_trace(err);
+}
+
+#endif /* APR_HAS_THREADS */
 /* This is a helper for svn_client__update_internal(), which see for
    an explanation of most of these parameters.  Some stuff that's
    unique is as follows:
@@ -324,6 +1283,9 @@ update_internal(svn_revnum_t *result_rev,
   svn_boolean_t server_supports_depth;
   svn_boolean_t cropping_target;
   svn_boolean_t target_conflicted = FALSE;
+  svn_depth_t edit_depth;
+  svn_boolean_t edit_depth_is_sticky;
+  int checkout_threads = 1;
   svn_config_t *cfg = ctx->config
                       ? svn_hash_gets(ctx->config, SVN_CONFIG_CATEGORY_CONFIG)
                       : NULL;
@@ -511,6 +1473,44 @@ update_internal(svn_revnum_t *result_rev,
   SVN_ERR(svn_ra_has_capability(ra_session, &server_supports_depth,
                                 SVN_RA_CAPABILITY_DEPTH, scratch_pool));
 
+#if APR_HAS_THREADS
+  /* A fresh checkout may receive its top-level directories through
+     concurrent update reports. */
+  if (clean_checkout && !*target && depth == svn_depth_infinity
+      && server_supports_depth)
+    {
+      apr_int64_t threads;
+      svn_depth_t anchor_depth;
+
+      SVN_ERR(svn_config_get_int64(cfg, &threads,
+                                   SVN_CONFIG_SECTION_MISCELLANY,
+                                   SVN_CONFIG_OPTION_CHECKOUT_THREADS, 1));
+      if (threads > 1)
+        {
+          SVN_ERR(svn_wc__node_get_origin(NULL, NULL, NULL, NULL, NULL,
+                                          &anchor_depth, NULL, ctx->wc_ctx,
+                                          local_abspath, FALSE,
+                                          scratch_pool, scratch_pool));
+          if (anchor_depth == svn_depth_infinity)
+            checkout_threads = (int)MIN(threads, CHECKOUT_MAX_THREADS);
+        }
+    }
+#endif
+
+  /* When checking out concurrently, receive the target with its direct
+     children first, leaving the subdirectories at depth empty.  The
+     target's recorded depth stays at infinity. */
+  if (checkout_threads > 1)
+    {
+      edit_depth = svn_depth_immediates;
+      edit_depth_is_sticky = FALSE;
+    }
+  else
+    {
+      edit_depth = depth;
+      edit_depth_is_sticky = depth_is_sticky;
+    }
+
   dfb.ra_session = ra_session;
   dfb.target_revision = revnum;
   dfb.anchor_url = anchor_url;
@@ -524,7 +1524,7 @@ update_internal(svn_revnum_t *result_rev,
   SVN_ERR(svn_wc__get_update_editor(&update_editor, &update_edit_baton,
                                     &revnum, ctx->wc_ctx, anchor_abspath,
                                     target, wcroot_iprops, use_commit_times,
-                                    depth, depth_is_sticky,
+                                    edit_depth, edit_depth_is_sticky,
                                     allow_unver_obstructions,
                                     adds_as_modification,
                                     server_supports_depth,
@@ -542,8 +1542,9 @@ update_internal(svn_revnum_t *result_rev,
      invalid revnum, that means RA will use the latest revision.  */
   SVN_ERR(svn_ra_do_update3(ra_session, &reporter, &report_baton,
                             revnum, target,
-                            (!server_supports_depth || depth_is_sticky
-                             ? depth
+                            (!server_supports_depth || edit_depth_is_sticky
+                             || checkout_threads > 1
+                             ? edit_depth
                              : svn_depth_unknown),
                             FALSE /* send_copyfrom_args */,
                             FALSE /* ignore_ancestry */,
@@ -559,13 +1560,22 @@ update_internal(svn_revnum_t *result_rev,
      reporter will drive the update_editor. */
   SVN_ERR(svn_wc_crawl_revisions5(ctx->wc_ctx, local_abspath, reporter,
                                   report_baton, TRUE,
-                                  depth, (! depth_is_sticky),
+                                  edit_depth, (! edit_depth_is_sticky),
                                   (! server_supports_depth),
                                   use_commit_times,
                                   ctx->cancel_func, ctx->cancel_baton,
                                   ctx->notify_func2, ctx->notify_baton2,
                                   scratch_pool));
 
+#if APR_HAS_THREADS
+  if (checkout_threads > 1)
+    SVN_ERR(checkout_subtrees(local_abspath, anchor_url, revnum,
+                              checkout_threads, conflicted_paths,
+                              use_commit_times, allow_unver_obstructions,
+                              adds_as_modification, diff3_cmd,
+                              preserved_exts, &dfb, ctx, scratch_pool));
+#endif
+
   /* We handle externals after the update is complete, so that
      handling external items (and any errors therefrom) doesn't delay
      the primary operation.  */
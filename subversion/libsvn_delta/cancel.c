@@ -241,6 +241,25 @@ apply_textdelta_stream(const svn_delta_editor_t *editor,
                                                     scratch_pool);
 }
 
+static svn_error_t *
+apply_text_by_checksum(svn_boolean_t *applied,
+                       const svn_delta_editor_t *editor,
+                       void *file_baton,
+                       const svn_checksum_t *sha1_checksum,
+                       apr_pool_t *scratch_pool)
+{
+  struct file_baton *fb = file_baton;
+  struct edit_baton *eb = fb->edit_baton;
+
+  SVN_ERR(eb->cancel_func(eb->cancel_baton));
+
+  return eb->wrapped_editor->apply_text_by_checksum(applied,
+                                                    eb->wrapped_editor,
+                                                    fb->wrapped_file_baton,
+                                                    sha1_checksum,
+                                                    scratch_pool);
+}
+
 static svn_error_t *
 close_file(void *file_baton,
            const char *text_checksum,
@@ -375,6 +394,8 @@ svn_delta_get_cancellation_editor(svn_cancel_func_t cancel_func,
       tree_editor->open_file = open_file;
       tree_editor->apply_textdelta = apply_textdelta;
       tree_editor->apply_textdelta_stream = apply_textdelta_stream;
+      if (wrapped_editor->apply_text_by_checksum)
+        tree_editor->apply_text_by_checksum = apply_text_by_checksum;
       tree_editor->change_file_prop = change_file_prop;
       tree_editor->close_file = close_file;
       tree_editor->absent_file = absent_file;
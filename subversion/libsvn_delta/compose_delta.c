@@ -212,12 +212,28 @@ search_offset_index(const offset_index_t *ndx,
 /* ==================================================================== */
 /* Mapping ranges in the source stream to ranges in the composed delta. */
 
-/* The range index tree. */
+/* The range index tree.
+
+   As long as all ranges get inserted in ascending order without
+   overlapping each other -- which is what most delta windows do -- the
+   index may be kept "flat", i.e. as a sorted array of nodes in ARENA.
+   The nodes still form the tree that splaying would have produced in
+   that case: a chain of LEFT links starting at the last node.  In flat
+   mode, TREE is only a cursor pointing to the node that
+   splay_range_index() found.  The first insertion that doesn't simply
+   append a range makes the chain a regular splay tree and clears ARENA. */
 typedef struct range_index_t
 {
   range_index_node_t *tree;
   alloc_block_t *free_list;
   apr_pool_t *pool;
+
+  /* Nodes of the flat index, or NULL if we use the splay tree. */
+  alloc_block_t *arena;
+
+  /* Number of nodes used and allocated in ARENA. */
+  int arena_count;
+  int arena_size;
 } range_index_t;
 
 /* Create a range index tree. Allocate from POOL. */
@@ -228,9 +244,49 @@ create_range_index(apr_pool_t *pool)
   ndx->tree = NULL;
   ndx->pool = pool;
   ndx->free_list = NULL;
+  ndx->arena = NULL;
+  ndx->arena_count = 0;
+  ndx->arena_size = 0;
   return ndx;
 }
 
+/* Let the empty range index NDX start as a flat index with room for
+   up to SIZE ranges. */
+static void
+use_range_index_arena(range_index_t *ndx, int size)
+{
+  assert(ndx->tree == NULL);
+  if (size > 0)
+    {
+      ndx->arena = apr_palloc(ndx->pool, size * sizeof(*ndx->arena));
+      ndx->arena_size = size;
+    }
+}
+
+/* Return TRUE, if NDX is flat and contains no range that ends after
+   OFFSET.  In that case, looking up OFFSET would yield a single source
+   range and inserting a range at OFFSET is a simple append. */
+static APR_INLINE svn_boolean_t
+beyond_range_index(apr_size_t offset, const range_index_t *ndx)
+{
+  return ndx->arena != NULL
+      && (ndx->arena_count == 0
+          || ndx->arena[ndx->arena_count - 1].index_node.limit <= offset);
+}
+
+/* Turn the flat range index NDX into a splay tree.  Note that the
+   exact shape of the tree matters because clean_tree() depends on it. */
+static void
+unflatten_range_index(range_index_t *ndx)
+{
+  ndx->tree = ndx->arena_count
+            ? &ndx->arena[ndx->arena_count - 1].index_node
+            : NULL;
+  ndx->arena = NULL;
+  ndx->arena_count = 0;
+  ndx->arena_size = 0;
+}
+
 /* Allocate a node for the range index tree. */
 static range_index_node_t *
 alloc_range_index_node(range_index_t *ndx,
@@ -259,7 +315,10 @@ free_range_index_node(range_index_t *ndx, range_index_node_t *node)
 }
 
 
-/* Splay the index tree, using OFFSET as the key. */
+/* Splay the index tree, using OFFSET as the key.  For a flat index,
+   just point the cursor to the node the splayed tree would have at its
+   root, i.e. the node with the largest offset not exceeding OFFSET or,
+   if there is none, the first node. */
 
 static void
 splay_range_index(apr_size_t offset, range_index_t *ndx)
@@ -268,6 +327,28 @@ splay_range_index(apr_size_t offset, range_index_t *ndx)
   range_index_node_t scratch_node;
   range_index_node_t *left, *right;
 
+  if (ndx->arena)
+    {
+      int lo = 0;
+      int hi = ndx->arena_count;
+
+      if (hi == 0)
+        return;
+
+      /* Find the first node with an offset larger than OFFSET. */
+      while (lo < hi)
+        {
+          const int mid = lo + (hi - lo) / 2;
+          if (ndx->arena[mid].index_node.offset <= offset)
+            lo = mid + 1;
+          else
+            hi = mid;
+        }
+
+      ndx->tree = &ndx->arena[lo > 0 ? lo - 1 : 0].index_node;
+      return;
+    }
+
   if (tree == NULL)
     return;
 
@@ -437,6 +518,38 @@ insert_range(apr_size_t offset, apr_size_t limit, apr_size_t target_offset,
 {
   range_index_node_t *node = NULL;
 
+  if (ndx->arena)
+    {
+      if (beyond_range_index(offset, ndx))
+        {
+          /* Append to the flat index.  This is exactly what the splay
+             tree code below would do in that case. */
+          assert(ndx->arena_count < ndx->arena_size);
+          node = &ndx->arena[ndx->arena_count].index_node;
+          node->offset = offset;
+          node->limit = limit;
+          node->target_offset = target_offset;
+          node->right = NULL;
+          node->next = NULL;
+          if (ndx->arena_count > 0)
+            {
+              node->prev = &ndx->arena[ndx->arena_count - 1].index_node;
+              node->prev->next = node;
+            }
+          else
+            node->prev = NULL;
+          node->left = node->prev;
+
+          ndx->tree = node;
+          ++ndx->arena_count;
+          return;
+        }
+
+      /* Ranges are no longer sorted.  Continue with a full splay tree. */
+      unflatten_range_index(ndx);
+      splay_range_index(offset, ndx);
+    }
+
   if (ndx->tree == NULL)
     {
       node = alloc_range_index_node(ndx, offset, limit, target_offset);
@@ -761,9 +874,10 @@ copy_source_ops(apr_size_t offset, apr_size_t limit,
 
 
 svn_txdelta_window_t *
-svn_txdelta_compose_windows(const svn_txdelta_window_t *window_A,
-                            const svn_txdelta_window_t *window_B,
-                            apr_pool_t *pool)
+svn_txdelta__compose_windows(const svn_txdelta_window_t *window_A,
+                             const svn_txdelta_window_t *window_B,
+                             svn_boolean_t flat_index,
+                             apr_pool_t *pool)
 {
   svn_txdelta__ops_baton_t build_baton = { 0 };
   svn_txdelta_window_t *composite;
@@ -773,6 +887,18 @@ svn_txdelta_compose_windows(const svn_txdelta_window_t *window_A,
   apr_size_t target_offset = 0;
   int i;
 
+  /* Every source copy in window_B inserts at most one range.  Don't
+     rely on window_B->src_ops; not all windows get created by us. */
+  if (flat_index)
+    {
+      int src_ops = 0;
+      for (i = 0; i < window_B->num_ops; ++i)
+        if (window_B->ops[i].action_code == svn_txdelta_source)
+          ++src_ops;
+
+      use_range_index_arena(range_index, src_ops);
+    }
+
   /* Read the description of the delta composition algorithm in
      notes/fs-improvements.txt before going any further.
      You have been warned. */
@@ -799,29 +925,41 @@ svn_txdelta_compose_windows(const svn_txdelta_window_t *window_A,
              same as window_A's _target_ stream! */
           const apr_size_t offset = op->offset;
           const apr_size_t limit = op->offset + op->length;
-          range_list_node_t *range_list, *range;
-          apr_size_t tgt_off = target_offset;
 
-          splay_range_index(offset, range_index);
-          range_list = build_range_list(offset, limit, range_index);
-
-          for (range = range_list; range; range = range->next)
+          if (beyond_range_index(offset, range_index))
             {
-              if (range->kind == range_from_target)
-                svn_txdelta__insert_op(&build_baton, svn_txdelta_target,
-                                       range->target_offset,
-                                       range->limit - range->offset,
-                                       NULL, pool);
-              else
-                copy_source_ops(range->offset, range->limit, tgt_off, 0,
-                                &build_baton, window_A, offset_index,
-                                pool);
+              /* Nothing in the index could help us, so the whole range
+                 must come from window_A.  No need to build a list. */
+              copy_source_ops(offset, limit, target_offset, 0,
+                              &build_baton, window_A, offset_index, pool);
+            }
+          else
+            {
+              range_list_node_t *range_list, *range;
+              apr_size_t tgt_off = target_offset;
+
+              splay_range_index(offset, range_index);
+              range_list = build_range_list(offset, limit, range_index);
+
+              for (range = range_list; range; range = range->next)
+                {
+                  if (range->kind == range_from_target)
+                    svn_txdelta__insert_op(&build_baton, svn_txdelta_target,
+                                           range->target_offset,
+                                           range->limit - range->offset,
+                                           NULL, pool);
+                  else
+                    copy_source_ops(range->offset, range->limit, tgt_off, 0,
+                                    &build_baton, window_A, offset_index,
+                                    pool);
+
+                  tgt_off += range->limit - range->offset;
+                }
+              assert(tgt_off == target_offset + op->length);
 
-              tgt_off += range->limit - range->offset;
+              free_range_list(range_list, range_index);
             }
-          assert(tgt_off == target_offset + op->length);
 
-          free_range_list(range_list, range_index);
           insert_range(offset, limit, target_offset, range_index);
         }
 
@@ -837,3 +975,11 @@ svn_txdelta_compose_windows(const svn_txdelta_window_t *window_A,
   composite->tview_len = window_B->tview_len;
   return composite;
 }
+
+svn_txdelta_window_t *
+svn_txdelta_compose_windows(const svn_txdelta_window_t *window_A,
+                            const svn_txdelta_window_t *window_B,
+                            apr_pool_t *pool)
+{
+  return svn_txdelta__compose_windows(window_A, window_B, TRUE, pool);
+}
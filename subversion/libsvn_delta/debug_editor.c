@@ -300,6 +300,31 @@ apply_textdelta_stream(const struct svn_delta_editor_t *editor,
   return SVN_NO_ERROR;
 }
 
+static svn_error_t *
+apply_text_by_checksum(svn_boolean_t *applied,
+                       const struct svn_delta_editor_t *editor,
+                       void *file_baton,
+                       const svn_checksum_t *sha1_checksum,
+                       apr_pool_t *scratch_pool)
+{
+  struct file_baton *fb = file_baton;
+  struct edit_baton *eb = fb->edit_baton;
+
+  SVN_ERR(write_indent(eb, scratch_pool));
+  SVN_ERR(svn_stream_printf(eb->out, scratch_pool,
+                            "apply_text_by_checksum : %s\n",
+                            svn_checksum_to_cstring_display(sha1_checksum,
+                                                            scratch_pool)));
+
+  SVN_ERR(eb->wrapped_editor->apply_text_by_checksum(applied,
+                                                     eb->wrapped_editor,
+                                                     fb->wrapped_file_baton,
+                                                     sha1_checksum,
+                                                     scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
 static svn_error_t *
 close_file(void *file_baton,
            const char *text_checksum,
@@ -481,6 +506,8 @@ svn_delta__get_debug_editor(const svn_delta_editor_t **editor,
   tree_editor->open_file = open_file;
   tree_editor->apply_textdelta = apply_textdelta;
   tree_editor->apply_textdelta_stream = apply_textdelta_stream;
+  if (wrapped_editor && wrapped_editor->apply_text_by_checksum)
+    tree_editor->apply_text_by_checksum = apply_text_by_checksum;
   tree_editor->change_file_prop = change_file_prop;
   tree_editor->close_file = close_file;
   tree_editor->absent_file = absent_file;
@@ -179,7 +179,8 @@ static const svn_delta_editor_t default_editor =
   absent_xxx_func,
   single_baton_func,
   single_baton_func,
-  apply_textdelta_stream
+  apply_textdelta_stream,
+  NULL /* apply_text_by_checksum */
 };
 
 svn_delta_editor_t *
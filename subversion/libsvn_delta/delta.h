@@ -44,6 +44,18 @@ extern "C" {
 
 #define SVN_DELTA_WINDOW_SIZE 102400
 
+/* The size of the target view of large windows, as produced by
+   svn_txdelta__large() and svn_txdelta__target_push_large().  Only
+   svndiff version 3 can carry them. */
+
+#define SVN_DELTA_LARGE_WINDOW_SIZE 1048576
+
+/* How much of the previous window's source view the source view of the
+   next large window still covers.  This lets data moved by insertions
+   or deletions of up to this size still be found in the source. */
+
+#define SVN_DELTA_LARGE_WINDOW_OVERLAP (SVN_DELTA_LARGE_WINDOW_SIZE / 2)
+
 
 /* Context/baton for building an operation sequence. */
 
@@ -81,6 +93,67 @@ svn_txdelta__make_window(const svn_txdelta__ops_baton_t *build_baton,
                          apr_pool_t *pool);
 
 
+/* Return TRUE, if HANDLER has been returned by svn_txdelta_to_svndiff3()
+   and can therefore accept raw svndiff windows through
+   svn_txdelta__send_raw_window(). */
+svn_boolean_t
+svn_txdelta__accepts_raw_windows(svn_txdelta_window_handler_t handler);
+
+/* If the svndiff encoder HANDLER_BATON, created by
+   svn_txdelta_to_svndiff3(), produces svndiff format SVNDIFF_VERSION,
+   write the svndiff data of a single window RAW_WINDOW verbatim to its
+   output and set *SENT to TRUE.  Otherwise, only set *SENT to FALSE. */
+svn_error_t *
+svn_txdelta__send_raw_window(svn_boolean_t *sent,
+                             void *handler_baton,
+                             const svn_string_t *raw_window,
+                             int svndiff_version);
+
+/* Implement svn_txdelta_compose_windows() for WINDOW_A and WINDOW_B,
+   allocating the result in POOL.  If FLAT_INDEX is set, keep the range
+   index in a sorted array for as long as window_B's source copies come
+   in ascending order.  Otherwise, always use the splay tree.  Both
+   produce the same composite window; the latter is only useful for
+   testing and benchmarking. */
+svn_txdelta_window_t *
+svn_txdelta__compose_windows(const svn_txdelta_window_t *window_A,
+                             const svn_txdelta_window_t *window_B,
+                             svn_boolean_t flat_index,
+                             apr_pool_t *pool);
+
+/* Copy LEN bytes from SOURCE to TARGET within the same target view.
+   If the ranges overlap, repeat the pattern between SOURCE and TARGET,
+   as target copy instructions require.  */
+void
+svn_txdelta__patterning_copy(char *target, const char *source,
+                             apr_size_t len);
+
+/* Return TRUE, if HANDLER has been returned by svn_txdelta_apply().
+   Instead of sending windows to such a handler, callers may then write
+   the target views directly into its buffers, using
+   svn_txdelta__apply_begin() and svn_txdelta__apply_end(). */
+svn_boolean_t
+svn_txdelta__is_apply_handler(svn_txdelta_window_handler_t handler);
+
+/* Prepare the delta applicator HANDLER_BATON for the next window, which
+   has the given source view and target view length.  Set *SBUF to the
+   source view data and *TBUF to a buffer of at least TVIEW_LEN bytes for
+   the target view.  Both remain valid until svn_txdelta__apply_end(). */
+svn_error_t *
+svn_txdelta__apply_begin(char **tbuf,
+                         const char **sbuf,
+                         void *handler_baton,
+                         svn_filesize_t sview_offset,
+                         apr_size_t sview_len,
+                         apr_size_t tview_len);
+
+/* Tell the delta applicator HANDLER_BATON that the first TVIEW_LEN bytes
+   of the target buffer returned by svn_txdelta__apply_begin() contain
+   the target view and write it out. */
+svn_error_t *
+svn_txdelta__apply_end(void *handler_baton,
+                       apr_size_t tview_len);
+
 /* Create xdelta window data. Allocate temporary data from POOL. */
 void svn_txdelta__xdelta(svn_txdelta__ops_baton_t *build_baton,
                          const char *start,
@@ -0,0 +1,647 @@
+/*
+ * spool.c :  record an editor drive and play it back later
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include "svn_pools.h"
+#include "svn_delta.h"
+#include "svn_sorts.h"
+#include "svn_string.h"
+
+#include "private/svn_delta_private.h"
+#include "private/svn_subr_private.h"
+
+#include "svn_private_config.h"
+
+
+/* The spool keeps the tree structure of the edit in memory, while the
+ * text deltas are written as svndiff into a spill buffer.  Since the
+ * playback happens in the order of recording, the deltas can be read
+ * back sequentially.
+ */
+
+/* The kinds of recorded editor calls. */
+typedef enum op_kind_t
+{
+  op_set_target_revision,
+  op_open_root,
+  op_delete_entry,
+  op_add_directory,
+  op_open_directory,
+  op_change_dir_prop,
+  op_close_directory,
+  op_absent_directory,
+  op_add_file,
+  op_open_file,
+  op_apply_textdelta,
+  op_change_file_prop,
+  op_close_file,
+  op_absent_file
+} op_kind_t;
+
+/* A recorded editor call. */
+typedef struct spool_op_t
+{
+  op_kind_t kind;
+
+  /* The node baton that the call got, as index into the batons array
+     during playback.  -1 for calls that don't take a node baton. */
+  int node;
+
+  /* For calls that create a node baton, the index of the new one. */
+  int new_node;
+
+  /* Depending on KIND: the path, property name and text or base
+     checksum. */
+  const char *path;
+  const char *name;
+  const char *checksum;
+
+  /* Depending on KIND: the copy source path, the base or target
+     revision and the property value. */
+  const char *copyfrom_path;
+  svn_revnum_t revision;
+  const svn_string_t *value;
+
+  /* For op_apply_textdelta, the number of svndiff bytes in the spill
+     buffer. */
+  svn_filesize_t delta_len;
+} spool_op_t;
+
+struct svn_delta__spool_t
+{
+  /* The spool_op_t in recording order. */
+  apr_array_header_t *ops;
+
+  /* Number of node batons handed out so far. */
+  int node_count;
+
+  /* The text deltas of all op_apply_textdelta calls, concatenated. */
+  svn_spillbuf_t *deltas;
+  svn_stream_t *deltas_stream;
+
+  apr_pool_t *pool;
+};
+
+/* A node baton of the recording editor. */
+typedef struct node_baton_t
+{
+  svn_delta__spool_t *spool;
+  int node;
+} node_baton_t;
+
+/* Append a new operation of KIND on NODE to SPOOL and return it. */
+static spool_op_t *
+add_op(svn_delta__spool_t *spool,
+       op_kind_t kind,
+       int node)
+{
+  spool_op_t *op = apr_array_push(spool->ops);
+
+  memset(op, 0, sizeof(*op));
+  op->kind = kind;
+  op->node = node;
+  op->new_node = -1;
+  op->revision = SVN_INVALID_REVNUM;
+
+  return op;
+}
+
+/* Let OP create a new node baton in SPOOL and return it in *BATON. */
+static void
+add_node(void **baton,
+         svn_delta__spool_t *spool,
+         spool_op_t *op)
+{
+  node_baton_t *nb = apr_palloc(spool->pool, sizeof(*nb));
+
+  nb->spool = spool;
+  nb->node = spool->node_count++;
+  op->new_node = nb->node;
+
+  *baton = nb;
+}
+
+
+/*** Recording editor vtable functions ***/
+
+static svn_error_t *
+record_set_target_revision(void *edit_baton,
+                           svn_revnum_t target_revision,
+                           apr_pool_t *pool)
+{
+  svn_delta__spool_t *spool = edit_baton;
+  spool_op_t *op = add_op(spool, op_set_target_revision, -1);
+
+  op->revision = target_revision;
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+record_open_root(void *edit_baton,
+                 svn_revnum_t base_revision,
+                 apr_pool_t *pool,
+                 void **root_baton)
+{
+  svn_delta__spool_t *spool = edit_baton;
+  spool_op_t *op = add_op(spool, op_open_root, -1);
+
+  op->revision = base_revision;
+  add_node(root_baton, spool, op);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+record_delete_entry(const char *path,
+                    svn_revnum_t base_revision,
+                    void *parent_baton,
+                    apr_pool_t *pool)
+{
+  node_baton_t *pb = parent_baton;
+  spool_op_t *op = add_op(pb->spool, op_delete_entry, pb->node);
+
+  op->path = apr_pstrdup(pb->spool->pool, path);
+  op->revision = base_revision;
+
+  return SVN_NO_ERROR;
+}
+
+/* Record an addition of KIND.  Implements the common part of
+   add_directory() and add_file(). */
+static svn_error_t *
+record_add(op_kind_t kind,
+           const char *path,
+           void *parent_baton,
+           const char *copyfrom_path,
+           svn_revnum_t copyfrom_rev,
+           void **child_baton)
+{
+  node_baton_t *pb = parent_baton;
+  spool_op_t *op = add_op(pb->spool, kind, pb->node);
+
+  op->path = apr_pstrdup(pb->spool->pool, path);
+  op->copyfrom_path = copyfrom_path
+                    ? apr_pstrdup(pb->spool->pool, copyfrom_path)
+                    : NULL;
+  op->revision = copyfrom_rev;
+  add_node(child_baton, pb->spool, op);
+
+  return SVN_NO_ERROR;
+}
+
+/* Record an operation of KIND that opens the node at PATH.  Implements
+   the common part of open_directory() and open_file(). */
+static svn_error_t *
+record_open(op_kind_t kind,
+            const char *path,
+            void *parent_baton,
+            svn_revnum_t base_revision,
+            void **child_baton)
+{
+  node_baton_t *pb = parent_baton;
+  spool_op_t *op = add_op(pb->spool, kind, pb->node);
+
+  op->path = apr_pstrdup(pb->spool->pool, path);
+  op->revision = base_revision;
+  add_node(child_baton, pb->spool, op);
+
+  return SVN_NO_ERROR;
+}
+
+/* Record an operation of KIND that takes PATH and the node baton only.
+   Implements absent_directory() and absent_file(). */
+static svn_error_t *
+record_path_op(op_kind_t kind,
+               const char *path,
+               void *baton)
+{
+  node_baton_t *nb = baton;
+  spool_op_t *op = add_op(nb->spool, kind, nb->node);
+
+  op->path = apr_pstrdup(nb->spool->pool, path);
+
+  return SVN_NO_ERROR;
+}
+
+/* Record a property change of KIND.  Implements change_dir_prop() and
+   change_file_prop(). */
+static svn_error_t *
+record_change_prop(op_kind_t kind,
+                   void *baton,
+                   const char *name,
+                   const svn_string_t *value)
+{
+  node_baton_t *nb = baton;
+  spool_op_t *op = add_op(nb->spool, kind, nb->node);
+
+  op->name = apr_pstrdup(nb->spool->pool, name);
+  op->value = value ? svn_string_dup(value, nb->spool->pool) : NULL;
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+record_add_directory(const char *path,
+                     void *parent_baton,
+                     const char *copyfrom_path,
+                     svn_revnum_t copyfrom_rev,
+                     apr_pool_t *pool,
+                     void **child_baton)
+{
+  return record_add(op_add_directory, path, parent_baton, copyfrom_path,
+                    copyfrom_rev, child_baton);
+}
+
+static svn_error_t *
+record_open_directory(const char *path,
+                      void *parent_baton,
+                      svn_revnum_t base_revision,
+                      apr_pool_t *pool,
+                      void **child_baton)
+{
+  return record_open(op_open_directory, path, parent_baton, base_revision,
+                     child_baton);
+}
+
+static svn_error_t *
+record_change_dir_prop(void *dir_baton,
+                       const char *name,
+                       const svn_string_t *value,
+                       apr_pool_t *pool)
+{
+  return record_change_prop(op_change_dir_prop, dir_baton, name, value);
+}
+
+static svn_error_t *
+record_close_directory(void *dir_baton,
+                       apr_pool_t *pool)
+{
+  node_baton_t *db = dir_baton;
+
+  add_op(db->spool, op_close_directory, db->node);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+record_absent_directory(const char *path,
+                        void *parent_baton,
+                        apr_pool_t *pool)
+{
+  return record_path_op(op_absent_directory, path, parent_baton);
+}
+
+static svn_error_t *
+record_add_file(const char *path,
+                void *parent_baton,
+                const char *copyfrom_path,
+                svn_revnum_t copyfrom_rev,
+                apr_pool_t *pool,
+                void **file_baton)
+{
+  return record_add(op_add_file, path, parent_baton, copyfrom_path,
+                    copyfrom_rev, file_baton);
+}
+
+static svn_error_t *
+record_open_file(const char *path,
+                 void *parent_baton,
+                 svn_revnum_t base_revision,
+                 apr_pool_t *pool,
+                 void **file_baton)
+{
+  return record_open(op_open_file, path, parent_baton, base_revision,
+                     file_baton);
+}
+
+/* Baton for record_window(). */
+typedef struct window_baton_t
+{
+  svn_txdelta_window_handler_t handler;
+  void *handler_baton;
+
+  /* The spool and the operation to set the delta length for. */
+  svn_delta__spool_t *spool;
+  spool_op_t *op;
+} window_baton_t;
+
+/* Implements svn_txdelta_window_handler_t.  Write WINDOW as svndiff to
+   the spill buffer and note the total length after the last window. */
+static svn_error_t *
+record_window(svn_txdelta_window_t *window,
+              void *baton)
+{
+  window_baton_t *wb = baton;
+
+  SVN_ERR(wb->handler(window, wb->handler_baton));
+  if (window == NULL)
+    wb->op->delta_len = svn_spillbuf__get_size(wb->spool->deltas)
+                      - wb->op->delta_len;
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+record_apply_textdelta(void *file_baton,
+                       const char *base_checksum,
+                       apr_pool_t *pool,
+                       svn_txdelta_window_handler_t *handler,
+                       void **handler_baton)
+{
+  node_baton_t *fb = file_baton;
+  svn_delta__spool_t *spool = fb->spool;
+  spool_op_t *op = add_op(spool, op_apply_textdelta, fb->node);
+  window_baton_t *wb = apr_palloc(pool, sizeof(*wb));
+
+  op->checksum = base_checksum ? apr_pstrdup(spool->pool, base_checksum)
+                               : NULL;
+
+  /* Until the last window, this is the buffer size to start from. */
+  op->delta_len = svn_spillbuf__get_size(spool->deltas);
+
+  /* The data gets read back locally, so don't spend time compressing it. */
+  svn_txdelta_to_svndiff3(&wb->handler, &wb->handler_baton,
+                          svn_stream_disown(spool->deltas_stream, pool),
+                          0, SVN_DELTA_COMPRESSION_LEVEL_NONE, pool);
+  wb->spool = spool;
+  wb->op = op;
+
+  *handler = record_window;
+  *handler_baton = wb;
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+record_change_file_prop(void *file_baton,
+                        const char *name,
+                        const svn_string_t *value,
+                        apr_pool_t *pool)
+{
+  return record_change_prop(op_change_file_prop, file_baton, name, value);
+}
+
+static svn_error_t *
+record_close_file(void *file_baton,
+                  const char *text_checksum,
+                  apr_pool_t *pool)
+{
+  node_baton_t *fb = file_baton;
+  spool_op_t *op = add_op(fb->spool, op_close_file, fb->node);
+
+  op->checksum = text_checksum ? apr_pstrdup(fb->spool->pool, text_checksum)
+                               : NULL;
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+record_absent_file(const char *path,
+                   void *parent_baton,
+                   apr_pool_t *pool)
+{
+  return record_path_op(op_absent_file, path, parent_baton);
+}
+
+
+/*** Public interface ***/
+
+svn_error_t *
+svn_delta__get_spool_editor(const svn_delta_editor_t **editor,
+                         void **edit_baton,
+                         svn_delta__spool_t **spool_p,
+                         apr_size_t memory_size,
+                         apr_pool_t *pool)
+{
+  svn_delta_editor_t *tree_editor = svn_delta_default_editor(pool);
+  svn_delta__spool_t *spool = apr_pcalloc(pool, sizeof(*spool));
+
+  tree_editor->set_target_revision = record_set_target_revision;
+  tree_editor->open_root = record_open_root;
+  tree_editor->delete_entry = record_delete_entry;
+  tree_editor->add_directory = record_add_directory;
+  tree_editor->open_directory = record_open_directory;
+  tree_editor->change_dir_prop = record_change_dir_prop;
+  tree_editor->close_directory = record_close_directory;
+  tree_editor->absent_directory = record_absent_directory;
+  tree_editor->add_file = record_add_file;
+  tree_editor->open_file = record_open_file;
+  tree_editor->apply_textdelta = record_apply_textdelta;
+  tree_editor->change_file_prop = record_change_file_prop;
+  tree_editor->close_file = record_close_file;
+  tree_editor->absent_file = record_absent_file;
+
+  spool->ops = apr_array_make(pool, 16, sizeof(spool_op_t));
+  spool->deltas = svn_spillbuf__create(SVN__STREAM_CHUNK_SIZE, memory_size,
+                                       pool);
+  spool->deltas_stream = svn_stream__from_spillbuf(spool->deltas, pool);
+  spool->pool = pool;
+
+  *editor = tree_editor;
+  *edit_baton = spool;
+  *spool_p = spool;
+
+  return SVN_NO_ERROR;
+}
+
+/* Read the next LEN bytes of svndiff data from the spill buffer of SPOOL
+   and send the windows to HANDLER / HANDLER_BATON.  Use SCRATCH_POOL for
+   temporary allocations. */
+static svn_error_t *
+replay_delta(svn_delta__spool_t *spool,
+             svn_filesize_t len,
+             svn_txdelta_window_handler_t handler,
+             void *handler_baton,
+             apr_pool_t *scratch_pool)
+{
+  svn_stream_t *parser = svn_txdelta_parse_svndiff(handler, handler_baton,
+                                                   TRUE, scratch_pool);
+  char *buffer = apr_palloc(scratch_pool, SVN__STREAM_CHUNK_SIZE);
+
+  while (len)
+    {
+      apr_size_t chunk = len > SVN__STREAM_CHUNK_SIZE
+                       ? SVN__STREAM_CHUNK_SIZE
+                       : (apr_size_t)len;
+      apr_size_t read = chunk;
+
+      SVN_ERR(svn_stream_read_full(spool->deltas_stream, buffer, &read));
+      if (read != chunk)
+        return svn_error_create(SVN_ERR_INCOMPLETE_DATA, NULL,
+                                _("Spooled text delta data is incomplete"));
+
+      SVN_ERR(svn_stream_write(parser, buffer, &read));
+      len -= read;
+    }
+
+  return svn_error_trace(svn_stream_close(parser));
+}
+
+/* Implement svn_delta__replay_spool() and, if ROOT_BATON is not NULL,
+   svn_delta__replay_spool_into(). */
+static svn_error_t *
+replay(svn_delta__spool_t *spool,
+       const svn_delta_editor_t *editor,
+       void *edit_baton,
+       void *root_baton,
+       apr_pool_t *scratch_pool)
+{
+  /* The node batons of EDITOR, indexed like the ones of the spool, and
+     the pools they live in.  Like with other editor drivers, each node
+     pool is a sub-pool of the parent's and gets destroyed upon close. */
+  void **batons = apr_pcalloc(scratch_pool,
+                              MAX(spool->node_count, 1) * sizeof(*batons));
+  apr_pool_t **pools = apr_pcalloc(scratch_pool,
+                                   MAX(spool->node_count, 1)
+                                     * sizeof(*pools));
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  int i;
+
+  for (i = 0; i < spool->ops->nelts; i++)
+    {
+      const spool_op_t *op = &APR_ARRAY_IDX(spool->ops, i, spool_op_t);
+      void *baton = op->node >= 0 ? batons[op->node] : NULL;
+      apr_pool_t *parent_pool = op->node >= 0 ? pools[op->node]
+                                              : scratch_pool;
+      apr_pool_t *node_pool = NULL;
+      svn_txdelta_window_handler_t handler;
+      void *handler_baton;
+
+      svn_pool_clear(iterpool);
+
+      if (op->new_node >= 0)
+        node_pool = svn_pool_create(parent_pool);
+
+      switch (op->kind)
+        {
+          case op_set_target_revision:
+            SVN_ERR_ASSERT(!root_baton);
+            SVN_ERR(editor->set_target_revision(edit_baton, op->revision,
+                                                iterpool));
+            break;
+
+          case op_open_root:
+            if (root_baton)
+              batons[op->new_node] = root_baton;
+            else
+              SVN_ERR(editor->open_root(edit_baton, op->revision, node_pool,
+                                        &batons[op->new_node]));
+            break;
+
+          case op_delete_entry:
+            SVN_ERR(editor->delete_entry(op->path, op->revision, baton,
+                                         iterpool));
+            break;
+
+          case op_add_directory:
+            SVN_ERR(editor->add_directory(op->path, baton, op->copyfrom_path,
+                                          op->revision, node_pool,
+                                          &batons[op->new_node]));
+            break;
+
+          case op_open_directory:
+            SVN_ERR(editor->open_directory(op->path, baton, op->revision,
+                                           node_pool,
+                                           &batons[op->new_node]));
+            break;
+
+          case op_change_dir_prop:
+            SVN_ERR(editor->change_dir_prop(baton, op->name, op->value,
+                                            iterpool));
+            break;
+
+          case op_close_directory:
+            SVN_ERR(editor->close_directory(baton, iterpool));
+            svn_pool_destroy(pools[op->node]);
+            pools[op->node] = NULL;
+            break;
+
+          case op_absent_directory:
+            SVN_ERR(editor->absent_directory(op->path, baton, iterpool));
+            break;
+
+          case op_add_file:
+            SVN_ERR(editor->add_file(op->path, baton, op->copyfrom_path,
+                                     op->revision, node_pool,
+                                     &batons[op->new_node]));
+            break;
+
+          case op_open_file:
+            SVN_ERR(editor->open_file(op->path, baton, op->revision,
+                                      node_pool, &batons[op->new_node]));
+            break;
+
+          case op_apply_textdelta:
+            SVN_ERR(editor->apply_textdelta(baton, op->checksum,
+                                            parent_pool,
+                                            &handler, &handler_baton));
+            SVN_ERR(replay_delta(spool, op->delta_len, handler,
+                                 handler_baton, iterpool));
+            break;
+
+          case op_change_file_prop:
+            SVN_ERR(editor->change_file_prop(baton, op->name, op->value,
+                                             iterpool));
+            break;
+
+          case op_close_file:
+            SVN_ERR(editor->close_file(baton, op->checksum, iterpool));
+            svn_pool_destroy(pools[op->node]);
+            pools[op->node] = NULL;
+            break;
+
+          case op_absent_file:
+            SVN_ERR(editor->absent_file(op->path, baton, iterpool));
+            break;
+        }
+
+      if (op->new_node >= 0)
+        pools[op->new_node] = node_pool;
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_delta__replay_spool(svn_delta__spool_t *spool,
+                        const svn_delta_editor_t *editor,
+                        void *edit_baton,
+                        apr_pool_t *scratch_pool)
+{
+  return svn_error_trace(replay(spool, editor, edit_baton, NULL,
+                                scratch_pool));
+}
+
+svn_error_t *
+svn_delta__replay_spool_into(svn_delta__spool_t *spool,
+                             const svn_delta_editor_t *editor,
+                             void *dir_baton,
+                             apr_pool_t *scratch_pool)
+{
+  SVN_ERR_ASSERT(dir_baton);
+
+  return svn_error_trace(replay(spool, editor, NULL, dir_baton,
+                                scratch_pool));
+}
@@ -39,13 +39,19 @@
 static const char SVNDIFF_V0[] = { 'S', 'V', 'N', 0 };
 static const char SVNDIFF_V1[] = { 'S', 'V', 'N', 1 };
 static const char SVNDIFF_V2[] = { 'S', 'V', 'N', 2 };
+static const char SVNDIFF_V3[] = { 'S', 'V', 'N', 3 };
+static const char SVNDIFF_V4[] = { 'S', 'V', 'N', 4 };
 
 #define SVNDIFF_HEADER_SIZE (sizeof(SVNDIFF_V0))
 
 static const char *
 get_svndiff_header(int version)
 {
-  if (version == 2)
+  if (version == 4)
+    return SVNDIFF_V4;
+  else if (version == 3)
+    return SVNDIFF_V3;
+  else if (version == 2)
     return SVNDIFF_V2;
   else if (version == 1)
     return SVNDIFF_V1;
@@ -74,6 +80,32 @@ struct encoder_baton {
    1-byte copy-from-source instructions (though this is very unlikely). */
 #define MAX_INSTRUCTION_SECTION_LEN (SVN_DELTA_WINDOW_SIZE*MAX_INSTRUCTION_LEN)
 
+/* Return the maximum target view length, and therefore new data length,
+   of windows in svndiff format VERSION. */
+static apr_size_t
+max_tview_len(int version)
+{
+  return version >= 3 ? SVN_DELTA_LARGE_WINDOW_SIZE : SVN_DELTA_WINDOW_SIZE;
+}
+
+/* Return the maximum source view length of windows in svndiff format
+   VERSION. */
+static apr_size_t
+max_sview_len(int version)
+{
+  return version >= 3
+       ? SVN_DELTA_LARGE_WINDOW_SIZE + SVN_DELTA_LARGE_WINDOW_OVERLAP
+       : SVN_DELTA_WINDOW_SIZE;
+}
+
+/* Return the maximum length of the instructions section of windows in
+   svndiff format VERSION, see MAX_INSTRUCTION_SECTION_LEN. */
+static apr_size_t
+max_instruction_section_len(int version)
+{
+  return max_tview_len(version) * MAX_INSTRUCTION_LEN;
+}
+
 
 /* Append an encoded integer to a string.  */
 static void
@@ -169,6 +201,7 @@ encode_window(svn_stringbuf_t **instructions_p,
   const svn_string_t *newdata;
   unsigned char ibuf[MAX_INSTRUCTION_LEN], *ip;
   const svn_txdelta_op_t *op;
+  apr_size_t tpos = 0, spos = 0;
 
   /* create the necessary data buffers */
   instructions = svn_stringbuf_create_empty(pool);
@@ -189,8 +222,24 @@ encode_window(svn_stringbuf_t **instructions_p,
         *ip++ |= (unsigned char)op->length;
       else
         ip = svn__encode_uint(ip + 1, op->length);
-      if (op->action_code != svn_txdelta_new)
+
+      /* Svndiff3 and 4 encode source copies relative to the end of the
+         previous one, which keeps sequential copies short, and target
+         copies as distance back from the current target position. */
+      if (op->action_code == svn_txdelta_new)
+        ;
+      else if (version < 3)
         ip = svn__encode_uint(ip, op->offset);
+      else if (op->action_code == svn_txdelta_source)
+        {
+          ip = svn__encode_int(ip, (apr_int64_t)op->offset
+                                   - (apr_int64_t)spos);
+          spos = op->offset + op->length;
+        }
+      else
+        ip = svn__encode_uint(ip, tpos - op->offset - 1);
+
+      tpos += op->length;
       svn_stringbuf_appendbytes(instructions, (const char *)ibuf, ip - ibuf);
     }
 
@@ -206,7 +255,7 @@ encode_window(svn_stringbuf_t **instructions_p,
                                 compressed_instructions));
       instructions = compressed_instructions;
     }
-  else if (version == 1)
+  else if (version == 1 || version == 3)
     {
       svn_stringbuf_t *compressed_instructions;
       compressed_instructions = svn_stringbuf_create_empty(pool);
@@ -214,6 +263,14 @@ encode_window(svn_stringbuf_t **instructions_p,
                                  compressed_instructions, compression_level));
       instructions = compressed_instructions;
     }
+  else if (version == 4)
+    {
+      svn_stringbuf_t *compressed_instructions;
+      compressed_instructions = svn_stringbuf_create_empty(pool);
+      SVN_ERR(svn__compress_zstd(instructions->data, instructions->len,
+                                 compressed_instructions, compression_level));
+      instructions = compressed_instructions;
+    }
   append_encoded_int(header, instructions->len);
 
   /* Encode the data. */
@@ -225,7 +282,7 @@ encode_window(svn_stringbuf_t **instructions_p,
                                 compressed));
       newdata = svn_stringbuf__morph_into_string(compressed);
     }
-  else if (version == 1)
+  else if (version == 1 || version == 3)
     {
       svn_stringbuf_t *compressed = svn_stringbuf_create_empty(pool);
 
@@ -233,6 +290,14 @@ encode_window(svn_stringbuf_t **instructions_p,
                                  compressed, compression_level));
       newdata = svn_stringbuf__morph_into_string(compressed);
     }
+  else if (version == 4)
+    {
+      svn_stringbuf_t *compressed = svn_stringbuf_create_empty(pool);
+
+      SVN_ERR(svn__compress_zstd(window->new_data->data, window->new_data->len,
+                                 compressed, compression_level));
+      newdata = svn_stringbuf__morph_into_string(compressed);
+    }
   else
     newdata = window->new_data;
 
@@ -279,6 +344,13 @@ window_handler(svn_txdelta_window_t *window, void *baton)
       return SVN_NO_ERROR;
     }
 
+  /* Large windows would make the output unreadable. */
+  if (window->tview_len > max_tview_len(eb->version)
+      || window->sview_len > max_sview_len(eb->version))
+    return svn_error_createf(SVN_ERR_SVNDIFF_CORRUPT_WINDOW, NULL,
+                             _("Delta window too large for svndiff%d"),
+                             eb->version);
+
   svn_pool_clear(eb->scratch_pool);
 
   SVN_ERR(encode_window(&instructions, &header, &newdata, window,
@@ -302,6 +374,40 @@ window_handler(svn_txdelta_window_t *window, void *baton)
   return SVN_NO_ERROR;
 }
 
+svn_boolean_t
+svn_txdelta__accepts_raw_windows(svn_txdelta_window_handler_t handler)
+{
+  return handler == window_handler;
+}
+
+svn_error_t *
+svn_txdelta__send_raw_window(svn_boolean_t *sent,
+                             void *handler_baton,
+                             const svn_string_t *raw_window,
+                             int svndiff_version)
+{
+  struct encoder_baton *eb = handler_baton;
+  apr_size_t len;
+
+  /* Windows of different versions can't be mixed in one stream and
+     the receiver may not support newer ones. */
+  *sent = eb->version == svndiff_version;
+  if (!*sent)
+    return SVN_NO_ERROR;
+
+  if (!eb->header_done)
+    {
+      len = SVNDIFF_HEADER_SIZE;
+      SVN_ERR(svn_stream_write(eb->output, get_svndiff_header(eb->version),
+                               &len));
+      eb->header_done = TRUE;
+    }
+
+  len = raw_window->len;
+  return svn_error_trace(svn_stream_write(eb->output, raw_window->data,
+                                          &len));
+}
+
 void
 svn_txdelta_to_svndiff3(svn_txdelta_window_handler_t *handler,
                         void **handler_baton,
@@ -424,13 +530,28 @@ decode_size(apr_size_t *val,
   return result;
 }
 
+/* Position within the window being decoded, as needed to decode the
+   relative copy offsets of svndiff3 instructions. */
+typedef struct insn_position_t
+{
+  /* Target view position of the next instruction. */
+  apr_size_t tpos;
+
+  /* End of the previous source copy. */
+  apr_size_t spos;
+} insn_position_t;
+
 /* Decode an instruction into OP, returning a pointer to the text
    after the instruction.  Note that if the action code is
-   svn_txdelta_new, the offset field of *OP will not be set.  */
+   svn_txdelta_new, the offset field of *OP will not be set.
+
+   POS must be NULL for svndiff versions before 3.  Otherwise, decode
+   the offsets relative to *POS and update it.  */
 static const unsigned char *
 decode_instruction(svn_txdelta_op_t *op,
                    const unsigned char *p,
-                   const unsigned char *end)
+                   const unsigned char *end,
+                   insn_position_t *pos)
 {
   apr_size_t c;
   apr_size_t action;
@@ -458,16 +579,124 @@ decode_instruction(svn_txdelta_op_t *op,
       if (p == NULL)
         return NULL;
     }
-  if (action != svn_txdelta_new)
+  if (action == svn_txdelta_new)
+    ;
+  else if (pos == NULL)
     {
       p = decode_size(&op->offset, p, end);
       if (p == NULL)
         return NULL;
     }
+  else if (action == svn_txdelta_source)
+    {
+      apr_int64_t delta;
+      apr_int64_t offset;
+
+      p = svn__decode_int(&delta, p, end);
+      if (p == NULL)
+        return NULL;
+
+      offset = (apr_int64_t)pos->spos + delta;
+      if (offset < 0 || (apr_uint64_t)offset > APR_SIZE_MAX)
+        return NULL;
+
+      op->offset = (apr_size_t)offset;
+      pos->spos = op->offset + op->length;
+    }
+  else
+    {
+      apr_size_t distance;
+
+      p = decode_size(&distance, p, end);
+      if (p == NULL || distance >= pos->tpos)
+        return NULL;
+
+      op->offset = pos->tpos - distance - 1;
+    }
+
+  if (pos)
+    pos->tpos += op->length;
 
   return p;
 }
 
+/* Make sure that instruction number N, OP, as decoded by
+   decode_instruction() returning P, is valid for the given window
+   lengths, if TPOS bytes of the target view and NPOS bytes of new data
+   have been used by the previous instructions.  Return an error if it
+   is invalid.  */
+static svn_error_t *
+verify_instruction(const svn_txdelta_op_t *op,
+                   const unsigned char *p,
+                   int n,
+                   apr_size_t tpos,
+                   apr_size_t npos,
+                   apr_size_t sview_len,
+                   apr_size_t tview_len,
+                   apr_size_t new_len)
+{
+  /* Detect any malformed operations from the instruction stream. */
+  if (p == NULL)
+    return svn_error_createf
+      (SVN_ERR_SVNDIFF_INVALID_OPS, NULL,
+       _("Invalid diff stream: insn %d cannot be decoded"), n);
+  else if (op->length == 0)
+    return svn_error_createf
+      (SVN_ERR_SVNDIFF_INVALID_OPS, NULL,
+       _("Invalid diff stream: insn %d has length zero"), n);
+  else if (op->length > tview_len - tpos)
+    return svn_error_createf
+      (SVN_ERR_SVNDIFF_INVALID_OPS, NULL,
+       _("Invalid diff stream: insn %d overflows the target view"), n);
+
+  switch (op->action_code)
+    {
+    case svn_txdelta_source:
+      if (op->length > sview_len - op->offset ||
+          op->offset > sview_len)
+        return svn_error_createf
+          (SVN_ERR_SVNDIFF_INVALID_OPS, NULL,
+           _("Invalid diff stream: "
+             "[src] insn %d overflows the source view"), n);
+      break;
+    case svn_txdelta_target:
+      if (op->offset >= tpos)
+        return svn_error_createf
+          (SVN_ERR_SVNDIFF_INVALID_OPS, NULL,
+           _("Invalid diff stream: "
+             "[tgt] insn %d starts beyond the target view position"), n);
+      break;
+    case svn_txdelta_new:
+      if (op->length > new_len - npos)
+        return svn_error_createf
+          (SVN_ERR_SVNDIFF_INVALID_OPS, NULL,
+           _("Invalid diff stream: "
+             "[new] insn %d overflows the new data section"), n);
+      break;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Make sure that the instructions of a window used TPOS bytes of target
+   view and NPOS bytes of new data, i.e. exactly what the window header
+   said.  Return an error otherwise.  */
+static svn_error_t *
+verify_window_filled(apr_size_t tpos,
+                     apr_size_t npos,
+                     apr_size_t tview_len,
+                     apr_size_t new_len)
+{
+  if (tpos != tview_len)
+    return svn_error_create(SVN_ERR_SVNDIFF_INVALID_OPS, NULL,
+                            _("Delta does not fill the target window"));
+  if (npos != new_len)
+    return svn_error_create(SVN_ERR_SVNDIFF_INVALID_OPS, NULL,
+                            _("Delta does not contain enough new data"));
+
+  return SVN_NO_ERROR;
+}
+
 /* Count the instructions in the range [P..END-1] and make sure they
    are valid for the given window lengths.  Return an error if the
    instructions are invalid; otherwise set *NINST to the number of
@@ -478,70 +707,105 @@ count_and_verify_instructions(int *ninst,
                               const unsigned char *end,
                               apr_size_t sview_len,
                               apr_size_t tview_len,
-                              apr_size_t new_len)
+                              apr_size_t new_len,
+                              unsigned int version)
 {
   int n = 0;
   svn_txdelta_op_t op;
   apr_size_t tpos = 0, npos = 0;
+  insn_position_t pos = { 0 };
 
   while (p < end)
     {
-      p = decode_instruction(&op, p, end);
-
-      /* Detect any malformed operations from the instruction stream. */
-      if (p == NULL)
-        return svn_error_createf
-          (SVN_ERR_SVNDIFF_INVALID_OPS, NULL,
-           _("Invalid diff stream: insn %d cannot be decoded"), n);
-      else if (op.length == 0)
-        return svn_error_createf
-          (SVN_ERR_SVNDIFF_INVALID_OPS, NULL,
-           _("Invalid diff stream: insn %d has length zero"), n);
-      else if (op.length > tview_len - tpos)
-        return svn_error_createf
-          (SVN_ERR_SVNDIFF_INVALID_OPS, NULL,
-           _("Invalid diff stream: insn %d overflows the target view"), n);
+      p = decode_instruction(&op, p, end, version >= 3 ? &pos : NULL);
+      SVN_ERR(verify_instruction(&op, p, n, tpos, npos,
+                                 sview_len, tview_len, new_len));
 
-      switch (op.action_code)
-        {
-        case svn_txdelta_source:
-          if (op.length > sview_len - op.offset ||
-              op.offset > sview_len)
-            return svn_error_createf
-              (SVN_ERR_SVNDIFF_INVALID_OPS, NULL,
-               _("Invalid diff stream: "
-                 "[src] insn %d overflows the source view"), n);
-          break;
-        case svn_txdelta_target:
-          if (op.offset >= tpos)
-            return svn_error_createf
-              (SVN_ERR_SVNDIFF_INVALID_OPS, NULL,
-               _("Invalid diff stream: "
-                 "[tgt] insn %d starts beyond the target view position"), n);
-          break;
-        case svn_txdelta_new:
-          if (op.length > new_len - npos)
-            return svn_error_createf
-              (SVN_ERR_SVNDIFF_INVALID_OPS, NULL,
-               _("Invalid diff stream: "
-                 "[new] insn %d overflows the new data section"), n);
-          npos += op.length;
-          break;
-        }
+      if (op.action_code == svn_txdelta_new)
+        npos += op.length;
       tpos += op.length;
       n++;
     }
-  if (tpos != tview_len)
-    return svn_error_create(SVN_ERR_SVNDIFF_INVALID_OPS, NULL,
-                            _("Delta does not fill the target window"));
-  if (npos != new_len)
-    return svn_error_create(SVN_ERR_SVNDIFF_INVALID_OPS, NULL,
-                            _("Delta does not contain enough new data"));
+  SVN_ERR(verify_window_filled(tpos, npos, tview_len, new_len));
 
   *ninst = n;
   return SVN_NO_ERROR;
 }
 
+/* Set [*INSNS, *INSEND) to the instructions and [*NEW_DATA, *NEW_DATA +
+   *NEWLEN) to the new data of the window contents at DATA with section
+   lengths INSLEN and NEWLEN, as stored in svndiff version VERSION.
+   Decompress them as necessary, allocating from POOL.  If the sections
+   were compressed, set *NDOUT to the buffer holding the new data;
+   otherwise, set it to NULL and *NEW_DATA will point into DATA. */
+static svn_error_t *
+decode_sections(const unsigned char **insns,
+                const unsigned char **insend,
+                const char **new_data,
+                apr_size_t *newlen,
+                svn_stringbuf_t **ndout,
+                const unsigned char *data,
+                apr_size_t inslen,
+                unsigned int version,
+                apr_pool_t *pool)
+{
+  *insns = data;
+  *insend = data + inslen;
+  *ndout = NULL;
+
+  if (version == 2)
+    {
+      svn_stringbuf_t *instout = svn_stringbuf_create_empty(pool);
+      *ndout = svn_stringbuf_create_empty(pool);
+
+      SVN_ERR(svn__decompress_lz4(*insend, *newlen, *ndout,
+                                  max_tview_len(version)));
+      SVN_ERR(svn__decompress_lz4(data, inslen, instout,
+                                  MAX_INSTRUCTION_SECTION_LEN));
+
+      *insns = (unsigned char *)instout->data;
+      *insend = (unsigned char *)instout->data + instout->len;
+    }
+  else if (version == 1 || version == 3)
+    {
+      svn_stringbuf_t *instout = svn_stringbuf_create_empty(pool);
+      *ndout = svn_stringbuf_create_empty(pool);
+
+      SVN_ERR(svn__decompress_zlib(*insend, *newlen, *ndout,
+                                   max_tview_len(version)));
+      SVN_ERR(svn__decompress_zlib(data, inslen, instout,
+                                   max_instruction_section_len(version)));
+
+      *insns = (unsigned char *)instout->data;
+      *insend = (unsigned char *)instout->data + instout->len;
+    }
+  else if (version == 4)
+    {
+      svn_stringbuf_t *instout = svn_stringbuf_create_empty(pool);
+      *ndout = svn_stringbuf_create_empty(pool);
+
+      SVN_ERR(svn__decompress_zstd(*insend, *newlen, *ndout,
+                                   max_tview_len(version)));
+      SVN_ERR(svn__decompress_zstd(data, inslen, instout,
+                                   max_instruction_section_len(version)));
+
+      *insns = (unsigned char *)instout->data;
+      *insend = (unsigned char *)instout->data + instout->len;
+    }
+
+  if (*ndout)
+    {
+      *new_data = (*ndout)->data;
+      *newlen = (*ndout)->len;
+    }
+  else
+    {
+      *new_data = (const char *)data + inslen;
+    }
+
+  return SVN_NO_ERROR;
+}
+
 /* Given the five integer fields of a window header and a pointer to
    the remainder of the window contents, fill in a delta window
    structure *WINDOW.  New allocations will be performed in POOL;
@@ -558,55 +822,28 @@ decode_window(svn_txdelta_window_t *window, svn_filesize_t sview_offset,
   apr_size_t npos;
   svn_txdelta_op_t *ops, *op;
   svn_string_t *new_data;
+  svn_stringbuf_t *ndout;
+  const char *new_bytes;
+  insn_position_t pos = { 0 };
 
   window->sview_offset = sview_offset;
   window->sview_len = sview_len;
   window->tview_len = tview_len;
 
-  insend = data + inslen;
-
-  if (version == 2)
-    {
-      svn_stringbuf_t *instout = svn_stringbuf_create_empty(pool);
-      svn_stringbuf_t *ndout = svn_stringbuf_create_empty(pool);
-
-      SVN_ERR(svn__decompress_lz4(insend, newlen, ndout,
-                                  SVN_DELTA_WINDOW_SIZE));
-      SVN_ERR(svn__decompress_lz4(data, insend - data, instout,
-                                  MAX_INSTRUCTION_SECTION_LEN));
-
-      newlen = ndout->len;
-      data = (unsigned char *)instout->data;
-      insend = (unsigned char *)instout->data + instout->len;
-
-      new_data = svn_stringbuf__morph_into_string(ndout);
-    }
-  else if (version == 1)
-    {
-      svn_stringbuf_t *instout = svn_stringbuf_create_empty(pool);
-      svn_stringbuf_t *ndout = svn_stringbuf_create_empty(pool);
+  SVN_ERR(decode_sections(&data, &insend, &new_bytes, &newlen, &ndout,
+                          data, inslen, version, pool));
 
-      SVN_ERR(svn__decompress_zlib(insend, newlen, ndout,
-                                   SVN_DELTA_WINDOW_SIZE));
-      SVN_ERR(svn__decompress_zlib(data, insend - data, instout,
-                                   MAX_INSTRUCTION_SECTION_LEN));
-
-      newlen = ndout->len;
-      data = (unsigned char *)instout->data;
-      insend = (unsigned char *)instout->data + instout->len;
-
-      new_data = svn_stringbuf__morph_into_string(ndout);
-    }
+  if (ndout)
+    new_data = svn_stringbuf__morph_into_string(ndout);
   else
-    {
-      /* Copy the data because an svn_string_t must have the invariant
-         data[len]=='\0'. */
-      new_data = svn_string_ncreate((const char*)insend, newlen, pool);
-    }
+    /* Copy the data because an svn_string_t must have the invariant
+       data[len]=='\0'. */
+    new_data = svn_string_ncreate(new_bytes, newlen, pool);
 
   /* Count the instructions and make sure they are all valid.  */
   SVN_ERR(count_and_verify_instructions(&ninst, data, insend,
-                                        sview_len, tview_len, newlen));
+                                        sview_len, tview_len, newlen,
+                                        version));
 
   /* Allocate a buffer for the instructions and decode them. */
   ops = apr_palloc(pool, ninst * sizeof(*ops));
@@ -614,7 +851,8 @@ decode_window(svn_txdelta_window_t *window, svn_filesize_t sview_offset,
   window->src_ops = 0;
   for (op = ops; op < ops + ninst; op++)
     {
-      data = decode_instruction(op, data, insend);
+      data = decode_instruction(op, data, insend,
+                                version >= 3 ? &pos : NULL);
       if (op->action_code == svn_txdelta_source)
         ++window->src_ops;
       else if (op->action_code == svn_txdelta_new)
@@ -632,6 +870,62 @@ decode_window(svn_txdelta_window_t *window, svn_filesize_t sview_offset,
   return SVN_NO_ERROR;
 }
 
+/* Like decode_window() but apply the instructions one by one, as they
+   get decoded, to the delta applicator APPLY_BATON, as returned by
+   svn_txdelta_apply().  This saves the allocation of the instruction
+   array and a second pass over the instruction data. */
+static svn_error_t *
+decode_and_apply_window(void *apply_baton, svn_filesize_t sview_offset,
+                        apr_size_t sview_len, apr_size_t tview_len,
+                        apr_size_t inslen, apr_size_t newlen,
+                        const unsigned char *data, apr_pool_t *pool,
+                        unsigned int version)
+{
+  const unsigned char *insend;
+  svn_stringbuf_t *ndout;
+  const char *new_data;
+  const char *sbuf;
+  char *tbuf;
+  apr_size_t tpos = 0, npos = 0;
+  insn_position_t pos = { 0 };
+  svn_txdelta_op_t op;
+  int n = 0;
+
+  SVN_ERR(decode_sections(&data, &insend, &new_data, &newlen, &ndout,
+                          data, inslen, version, pool));
+  SVN_ERR(svn_txdelta__apply_begin(&tbuf, &sbuf, apply_baton,
+                                   sview_offset, sview_len, tview_len));
+
+  while (data < insend)
+    {
+      data = decode_instruction(&op, data, insend,
+                                version >= 3 ? &pos : NULL);
+      SVN_ERR(verify_instruction(&op, data, n, tpos, npos,
+                                 sview_len, tview_len, newlen));
+
+      switch (op.action_code)
+        {
+        case svn_txdelta_source:
+          memcpy(tbuf + tpos, sbuf + op.offset, op.length);
+          break;
+        case svn_txdelta_target:
+          svn_txdelta__patterning_copy(tbuf + tpos, tbuf + op.offset,
+                                       op.length);
+          break;
+        default:
+          memcpy(tbuf + tpos, new_data + npos, op.length);
+          npos += op.length;
+          break;
+        }
+
+      tpos += op.length;
+      n++;
+    }
+  SVN_ERR(verify_window_filled(tpos, npos, tview_len, newlen));
+
+  return svn_txdelta__apply_end(apply_baton, tview_len);
+}
+
 static svn_error_t *
 write_handler(void *baton,
               const char *buffer,
@@ -653,6 +947,10 @@ write_handler(void *baton,
         db->version = 1;
       else if (memcmp(buffer, SVNDIFF_V2 + db->header_bytes, nheader) == 0)
         db->version = 2;
+      else if (memcmp(buffer, SVNDIFF_V3 + db->header_bytes, nheader) == 0)
+        db->version = 3;
+      else if (memcmp(buffer, SVNDIFF_V4 + db->header_bytes, nheader) == 0)
+        db->version = 4;
       else
         return svn_error_create(SVN_ERR_SVNDIFF_INVALID_HEADER, NULL,
                                 _("Svndiff has invalid header"));
@@ -710,11 +1008,11 @@ write_handler(void *baton,
           if (p == NULL)
               break;
 
-          if (tview_len > SVN_DELTA_WINDOW_SIZE ||
-              sview_len > SVN_DELTA_WINDOW_SIZE ||
+          if (tview_len > max_tview_len(db->version) ||
+              sview_len > max_sview_len(db->version) ||
               /* for svndiff1, newlen includes the original length */
-              newlen > SVN_DELTA_WINDOW_SIZE + SVN__MAX_ENCODED_UINT_LEN ||
-              inslen > MAX_INSTRUCTION_SECTION_LEN)
+              newlen > max_tview_len(db->version) + SVN__MAX_ENCODED_UINT_LEN ||
+              inslen > max_instruction_section_len(db->version))
             return svn_error_create(
                      SVN_ERR_SVNDIFF_CORRUPT_WINDOW, NULL,
                      _("Svndiff contains a too-large window"));
@@ -755,11 +1053,23 @@ write_handler(void *baton,
       if ((apr_size_t) (end - p) < db->inslen + db->newlen)
         return SVN_NO_ERROR;
 
-      /* Decode the window and send it off. */
-      SVN_ERR(decode_window(&window, db->sview_offset, db->sview_len,
-                            db->tview_len, db->inslen, db->newlen, p,
-                            db->subpool, db->version));
-      SVN_ERR(db->consumer_func(&window, db->consumer_baton));
+      /* Decode the window and send it off.  If it goes straight to
+         the delta applicator, skip the window structure. */
+      if (svn_txdelta__is_apply_handler(db->consumer_func))
+        {
+          SVN_ERR(decode_and_apply_window(db->consumer_baton,
+                                          db->sview_offset, db->sview_len,
+                                          db->tview_len, db->inslen,
+                                          db->newlen, p, db->subpool,
+                                          db->version));
+        }
+      else
+        {
+          SVN_ERR(decode_window(&window, db->sview_offset, db->sview_len,
+                                db->tview_len, db->inslen, db->newlen, p,
+                                db->subpool, db->version));
+          SVN_ERR(db->consumer_func(&window, db->consumer_baton));
+        }
 
       p += db->inslen + db->newlen;
 
@@ -894,9 +1204,11 @@ read_one_size(apr_size_t *size,
   return SVN_NO_ERROR;
 }
 
-/* Read a window header from STREAM and check it for integer overflow. */
+/* Read a window header in svndiff format VERSION from STREAM and check
+   it for integer overflow. */
 static svn_error_t *
-read_window_header(svn_stream_t *stream, svn_filesize_t *sview_offset,
+read_window_header(svn_stream_t *stream, int version,
+                   svn_filesize_t *sview_offset,
                    apr_size_t *sview_len, apr_size_t *tview_len,
                    apr_size_t *inslen, apr_size_t *newlen,
                    apr_size_t *header_len)
@@ -921,11 +1233,11 @@ read_window_header(svn_stream_t *stream, svn_filesize_t *sview_offset,
   SVN_ERR(read_one_size(inslen, header_len, stream));
   SVN_ERR(read_one_size(newlen, header_len, stream));
 
-  if (*tview_len > SVN_DELTA_WINDOW_SIZE ||
-      *sview_len > SVN_DELTA_WINDOW_SIZE ||
+  if (*tview_len > max_tview_len(version) ||
+      *sview_len > max_sview_len(version) ||
       /* for svndiff1, newlen includes the original length */
-      *newlen > SVN_DELTA_WINDOW_SIZE + SVN__MAX_ENCODED_UINT_LEN ||
-      *inslen > MAX_INSTRUCTION_SECTION_LEN)
+      *newlen > max_tview_len(version) + SVN__MAX_ENCODED_UINT_LEN ||
+      *inslen > max_instruction_section_len(version))
     return svn_error_create(SVN_ERR_SVNDIFF_CORRUPT_WINDOW, NULL,
                             _("Svndiff contains a too-large window"));
 
@@ -949,8 +1261,9 @@ svn_txdelta_read_svndiff_window(svn_txdelta_window_t **window,
   apr_size_t sview_len, tview_len, inslen, newlen, len, header_len;
   unsigned char *buf;
 
-  SVN_ERR(read_window_header(stream, &sview_offset, &sview_len, &tview_len,
-                             &inslen, &newlen, &header_len));
+  SVN_ERR(read_window_header(stream, svndiff_version, &sview_offset,
+                             &sview_len, &tview_len, &inslen, &newlen,
+                             &header_len));
   len = inslen + newlen;
   buf = apr_palloc(pool, len);
   SVN_ERR(svn_stream_read_full(stream, (char*)buf, &len));
@@ -973,8 +1286,9 @@ svn_txdelta_skip_svndiff_window(apr_file_t *file,
   apr_size_t sview_len, tview_len, inslen, newlen, header_len;
   apr_off_t offset;
 
-  SVN_ERR(read_window_header(stream, &sview_offset, &sview_len, &tview_len,
-                             &inslen, &newlen, &header_len));
+  SVN_ERR(read_window_header(stream, svndiff_version, &sview_offset,
+                             &sview_len, &tview_len, &inslen, &newlen,
+                             &header_len));
 
   offset = inslen + newlen;
   return svn_io_file_seek(file, APR_CUR, &offset, pool);
@@ -988,8 +1302,11 @@ svn_txdelta__read_raw_window_len(apr_size_t *window_len,
   svn_filesize_t sview_offset;
   apr_size_t sview_len, tview_len, inslen, newlen, header_len;
 
-  SVN_ERR(read_window_header(stream, &sview_offset, &sview_len, &tview_len,
-                             &inslen, &newlen, &header_len));
+  /* The format is not known here, so accept the largest windows of any
+     version.  The window will be checked when it gets parsed. */
+  SVN_ERR(read_window_header(stream, 3, &sview_offset,
+                             &sview_len, &tview_len, &inslen, &newlen,
+                             &header_len));
 
   *window_len = inslen + newlen + header_len;
   return SVN_NO_ERROR;
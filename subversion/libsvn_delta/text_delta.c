@@ -32,6 +32,9 @@
 #include "svn_io.h"
 #include "svn_pools.h"
 #include "svn_checksum.h"
+#include "svn_sorts.h"
+
+#include "private/svn_delta_private.h"
 
 #include "delta.h"
 
@@ -43,6 +46,9 @@ struct svn_txdelta_stream_t {
   void *baton;
   svn_txdelta_next_window_fn_t next_window;
   svn_txdelta_md5_digest_fn_t md5_digest;
+
+  /* Set by svn_txdelta__stream_set_raw_window_func().  May be NULL. */
+  svn_txdelta__next_raw_window_fn_t next_raw_window;
 };
 
 /* Delta stream baton. */
@@ -56,6 +62,13 @@ struct txdelta_baton {
   svn_boolean_t more;           /* TRUE if there are more data in the pool. */
   svn_filesize_t pos;           /* Offset of next read in source file. */
   char *buf;                    /* Buffer for input data. */
+  apr_size_t source_len;        /* Length of the last source view. */
+
+  apr_size_t window_size;       /* Amount of new data per source / target
+                                   view, see SVN_DELTA_WINDOW_SIZE. */
+  apr_size_t overlap;           /* Source data to keep from the previous
+                                   source view, see
+                                   SVN_DELTA_LARGE_WINDOW_OVERLAP. */
 
   svn_checksum_ctx_t *context;  /* If not NULL, the context for computing
                                    the checksum. */
@@ -80,6 +93,13 @@ struct tpush_baton {
   apr_size_t source_len;
   svn_boolean_t source_done;
   apr_size_t target_len;
+
+  /* Window geometry, as in struct txdelta_baton. */
+  apr_size_t window_size;
+  apr_size_t overlap;
+
+  /* Length of the source data kept from the previous window. */
+  apr_size_t kept;
 };
 
 
@@ -333,10 +353,19 @@ svn_txdelta_stream_create(void *baton,
   stream->baton = baton;
   stream->next_window = next_window;
   stream->md5_digest = md5_digest;
+  stream->next_raw_window = NULL;
 
   return stream;
 }
 
+void
+svn_txdelta__stream_set_raw_window_func(
+  svn_txdelta_stream_t *stream,
+  svn_txdelta__next_raw_window_fn_t next_raw_window)
+{
+  stream->next_raw_window = next_raw_window;
+}
+
 svn_error_t *
 svn_txdelta_next_window(svn_txdelta_window_t **window,
                         svn_txdelta_stream_t *stream,
@@ -359,21 +388,32 @@ txdelta_next_window(svn_txdelta_window_t **window,
                     apr_pool_t *pool)
 {
   struct txdelta_baton *b = baton;
-  apr_size_t source_len = SVN_DELTA_WINDOW_SIZE;
-  apr_size_t target_len = SVN_DELTA_WINDOW_SIZE;
+  apr_size_t keep = MIN(b->overlap, b->source_len);
+  apr_size_t read_len = b->window_size;
+  apr_size_t target_len = b->window_size;
+  apr_size_t source_len;
+
+  /* Slide the tail of the previous source view to the front of the
+     buffer.  That lets matches span window boundaries while the source
+     views still only ever move forward. */
+  if (keep)
+    memmove(b->buf, b->buf + b->source_len - keep, keep);
 
   /* Read the source stream. */
   if (b->more_source)
     {
-      SVN_ERR(svn_stream_read_full(b->source, b->buf, &source_len));
-      b->more_source = (source_len == SVN_DELTA_WINDOW_SIZE);
+      SVN_ERR(svn_stream_read_full(b->source, b->buf + keep, &read_len));
+      b->more_source = (read_len == b->window_size);
     }
   else
-    source_len = 0;
+    read_len = 0;
+
+  source_len = keep + read_len;
+  b->source_len = source_len;
 
   /* Read the target stream. */
   SVN_ERR(svn_stream_read_full(b->target, b->buf + source_len, &target_len));
-  b->pos += source_len;
+  b->pos += read_len;
 
   if (target_len == 0)
     {
@@ -436,6 +476,7 @@ svn_txdelta_run(svn_stream_t *source,
   tb.more = TRUE;
   tb.pos = 0;
   tb.buf = apr_palloc(scratch_pool, 2 * SVN_DELTA_WINDOW_SIZE);
+  tb.window_size = SVN_DELTA_WINDOW_SIZE;
   tb.result_pool = result_pool;
 
   if (checksum != NULL)
@@ -466,12 +507,17 @@ svn_txdelta_run(svn_stream_t *source,
 }
 
 
-void
-svn_txdelta2(svn_txdelta_stream_t **stream,
-             svn_stream_t *source,
-             svn_stream_t *target,
-             svn_boolean_t calculate_checksum,
-             apr_pool_t *pool)
+/* Implement svn_txdelta2 and svn_txdelta__large, using WINDOW_SIZE bytes
+ * of new data per window and keeping OVERLAP bytes of the previous source
+ * view in the next one. */
+static void
+txdelta_create(svn_txdelta_stream_t **stream,
+               svn_stream_t *source,
+               svn_stream_t *target,
+               svn_boolean_t calculate_checksum,
+               apr_size_t window_size,
+               apr_size_t overlap,
+               apr_pool_t *pool)
 {
   struct txdelta_baton *b = apr_pcalloc(pool, sizeof(*b));
 
@@ -479,7 +525,9 @@ svn_txdelta2(svn_txdelta_stream_t **stream,
   b->target = target;
   b->more_source = TRUE;
   b->more = TRUE;
-  b->buf = apr_palloc(pool, 2 * SVN_DELTA_WINDOW_SIZE);
+  b->buf = apr_palloc(pool, 2 * window_size + overlap);
+  b->window_size = window_size;
+  b->overlap = overlap;
   b->context = calculate_checksum
              ? svn_checksum_ctx_create(svn_checksum_md5, pool)
              : NULL;
@@ -489,6 +537,29 @@ svn_txdelta2(svn_txdelta_stream_t **stream,
                                       txdelta_md5_digest, pool);
 }
 
+void
+svn_txdelta2(svn_txdelta_stream_t **stream,
+             svn_stream_t *source,
+             svn_stream_t *target,
+             svn_boolean_t calculate_checksum,
+             apr_pool_t *pool)
+{
+  txdelta_create(stream, source, target, calculate_checksum,
+                 SVN_DELTA_WINDOW_SIZE, 0, pool);
+}
+
+void
+svn_txdelta__large(svn_txdelta_stream_t **stream,
+                   svn_stream_t *source,
+                   svn_stream_t *target,
+                   svn_boolean_t calculate_checksum,
+                   apr_pool_t *pool)
+{
+  txdelta_create(stream, source, target, calculate_checksum,
+                 SVN_DELTA_LARGE_WINDOW_SIZE, SVN_DELTA_LARGE_WINDOW_OVERLAP,
+                 pool);
+}
+
 void
 svn_txdelta(svn_txdelta_stream_t **stream,
             svn_stream_t *source,
@@ -518,16 +589,19 @@ tpush_write_handler(void *baton, const char *data, apr_size_t *len)
       svn_pool_clear(pool);
 
       /* Make sure we're all full up on source data, if possible. */
-      if (tb->source_len == 0 && !tb->source_done)
+      if (tb->source_len == tb->kept && !tb->source_done)
         {
-          tb->source_len = SVN_DELTA_WINDOW_SIZE;
-          SVN_ERR(svn_stream_read_full(tb->source, tb->buf, &tb->source_len));
-          if (tb->source_len < SVN_DELTA_WINDOW_SIZE)
+          apr_size_t read_len = tb->window_size;
+
+          SVN_ERR(svn_stream_read_full(tb->source, tb->buf + tb->kept,
+                                       &read_len));
+          if (read_len < tb->window_size)
             tb->source_done = TRUE;
+          tb->source_len += read_len;
         }
 
-      /* Copy in the target data, up to SVN_DELTA_WINDOW_SIZE. */
-      chunk_len = SVN_DELTA_WINDOW_SIZE - tb->target_len;
+      /* Copy in the target data, up to the window size. */
+      chunk_len = tb->window_size - tb->target_len;
       if (chunk_len > data_len)
         chunk_len = data_len;
       memcpy(tb->buf + tb->source_len + tb->target_len, data, chunk_len);
@@ -536,13 +610,19 @@ tpush_write_handler(void *baton, const char *data, apr_size_t *len)
       tb->target_len += chunk_len;
 
       /* If we're full of target data, compute and fire off a window. */
-      if (tb->target_len == SVN_DELTA_WINDOW_SIZE)
+      if (tb->target_len == tb->window_size)
         {
           window = compute_window(tb->buf, tb->source_len, tb->target_len,
                                   tb->source_offset, pool);
           SVN_ERR(tb->wh(window, tb->whb));
-          tb->source_offset += tb->source_len;
-          tb->source_len = 0;
+
+          /* Keep the tail of the source view for the next window. */
+          tb->kept = MIN(tb->overlap, tb->source_len);
+          if (tb->kept)
+            memmove(tb->buf, tb->buf + tb->source_len - tb->kept, tb->kept);
+
+          tb->source_offset += tb->source_len - tb->kept;
+          tb->source_len = tb->kept;
           tb->target_len = 0;
         }
     }
@@ -574,10 +654,15 @@ tpush_close_handler(void *baton)
 }
 
 
-svn_stream_t *
-svn_txdelta_target_push(svn_txdelta_window_handler_t handler,
-                        void *handler_baton, svn_stream_t *source,
-                        apr_pool_t *pool)
+/* Implement svn_txdelta_target_push and svn_txdelta__target_push_large.
+ * WINDOW_SIZE and OVERLAP are as for txdelta_create. */
+static svn_stream_t *
+target_push_create(svn_txdelta_window_handler_t handler,
+                   void *handler_baton,
+                   svn_stream_t *source,
+                   apr_size_t window_size,
+                   apr_size_t overlap,
+                   apr_pool_t *pool)
 {
   struct tpush_baton *tb;
   svn_stream_t *stream;
@@ -588,11 +673,14 @@ svn_txdelta_target_push(svn_txdelta_window_handler_t handler,
   tb->wh = handler;
   tb->whb = handler_baton;
   tb->pool = pool;
-  tb->buf = apr_palloc(pool, 2 * SVN_DELTA_WINDOW_SIZE);
+  tb->buf = apr_palloc(pool, 2 * window_size + overlap);
   tb->source_offset = 0;
   tb->source_len = 0;
   tb->source_done = FALSE;
   tb->target_len = 0;
+  tb->window_size = window_size;
+  tb->overlap = overlap;
+  tb->kept = 0;
 
   /* Create and return writable stream. */
   stream = svn_stream_create(tb, pool);
@@ -601,6 +689,26 @@ svn_txdelta_target_push(svn_txdelta_window_handler_t handler,
   return stream;
 }
 
+svn_stream_t *
+svn_txdelta_target_push(svn_txdelta_window_handler_t handler,
+                        void *handler_baton, svn_stream_t *source,
+                        apr_pool_t *pool)
+{
+  return target_push_create(handler, handler_baton, source,
+                            SVN_DELTA_WINDOW_SIZE, 0, pool);
+}
+
+svn_stream_t *
+svn_txdelta__target_push_large(svn_txdelta_window_handler_t handler,
+                               void *handler_baton,
+                               svn_stream_t *source,
+                               apr_pool_t *pool)
+{
+  return target_push_create(handler, handler_baton, source,
+                            SVN_DELTA_LARGE_WINDOW_SIZE,
+                            SVN_DELTA_LARGE_WINDOW_OVERLAP, pool);
+}
+
 
 
 /* Functions for applying deltas.  */
@@ -628,17 +736,29 @@ size_buffer(char **buf, apr_size_t *buf_size,
 static APR_INLINE char *
 patterning_copy(char *target, const char *source, apr_size_t len)
 {
+  apr_size_t chunk = target - source;
+
+  /* Runs of a single byte are common in padded binary data.  */
+  if (chunk == 1)
+    {
+      memset(target, *source, len);
+      return target + len;
+    }
+
   /* If the source and target overlap, repeat the overlapping pattern
-     in the target buffer. Always copy from the source buffer because
-     presumably it will be in the L1 cache after the first iteration
-     and doing this should avoid pipeline stalls due to write/read
-     dependencies. */
-  const apr_size_t overlap = target - source;
-  while (len > overlap)
+     in the target buffer.  Everything from SOURCE up to TARGET is a
+     whole number of pattern periods, so we may always copy all of it.
+     That doubles the size of the next copy and short patterns need
+     only a few wide memcpy() calls instead of one per period.  Always
+     copy from the start of the source buffer because presumably it
+     will be in the L1 cache after the first iteration and doing this
+     should avoid pipeline stalls due to write/read dependencies. */
+  while (len > chunk)
     {
-      memcpy(target, source, overlap);
-      target += overlap;
-      len -= overlap;
+      memcpy(target, source, chunk);
+      target += chunk;
+      len -= chunk;
+      chunk *= 2;
     }
 
   /* Copy any remaining source pattern. */
@@ -651,6 +771,13 @@ patterning_copy(char *target, const char *source, apr_size_t len)
   return target;
 }
 
+void
+svn_txdelta__patterning_copy(char *target, const char *source,
+                             apr_size_t len)
+{
+  patterning_copy(target, source, len);
+}
+
 void
 svn_txdelta_apply_instructions(svn_txdelta_window_t *window,
                                const char *sbuf, char *tbuf,
@@ -714,79 +841,109 @@ svn_txdelta_apply_instructions(svn_txdelta_window_t *window,
   *tlen = tpos;
 }
 
-/* Apply WINDOW to the streams given by APPL.  */
+/* Make AB ready to apply a window with the given source view and
+ * target view length: Read the source view into AB->SBUF and make room
+ * for the target view in AB->TBUF.  */
 static svn_error_t *
-apply_window(svn_txdelta_window_t *window, void *baton)
+begin_apply_window(struct apply_baton *ab,
+                   svn_filesize_t sview_offset,
+                   apr_size_t sview_len,
+                   apr_size_t tview_len)
 {
-  struct apply_baton *ab = (struct apply_baton *) baton;
   apr_size_t len;
 
-  if (window == NULL)
-    {
-      svn_error_t *err = SVN_NO_ERROR;
-
-      /* We're done; just clean up.  */
-      if (ab->result_digest)
-        {
-          svn_checksum_t *md5_checksum;
-
-          err = svn_checksum_final(&md5_checksum, ab->md5_context, ab->pool);
-          if (!err)
-            memcpy(ab->result_digest, md5_checksum->digest,
-                   svn_checksum_size(md5_checksum));
-        }
-
-      err = svn_error_compose_create(err, svn_stream_close(ab->target));
-      svn_pool_destroy(ab->pool);
-
-      return err;
-    }
-
   /* Make sure the source view didn't slide backwards.  */
-  SVN_ERR_ASSERT(window->sview_len == 0
-                 || (window->sview_offset >= ab->sbuf_offset
-                     && (window->sview_offset + window->sview_len
+  SVN_ERR_ASSERT(sview_len == 0
+                 || (sview_offset >= ab->sbuf_offset
+                     && (sview_offset + sview_len
                          >= ab->sbuf_offset + ab->sbuf_len)));
 
   /* Make sure there's enough room in the target buffer.  */
-  SVN_ERR(size_buffer(&ab->tbuf, &ab->tbuf_size, window->tview_len, ab->pool));
+  SVN_ERR(size_buffer(&ab->tbuf, &ab->tbuf_size, tview_len, ab->pool));
 
   /* Prepare the source buffer for reading from the input stream.  */
-  if (window->sview_offset != ab->sbuf_offset
-      || window->sview_len > ab->sbuf_size)
+  if (sview_offset != ab->sbuf_offset
+      || sview_len > ab->sbuf_size)
     {
       char *old_sbuf = ab->sbuf;
 
       /* Make sure there's enough room.  */
-      SVN_ERR(size_buffer(&ab->sbuf, &ab->sbuf_size, window->sview_len,
+      SVN_ERR(size_buffer(&ab->sbuf, &ab->sbuf_size, sview_len,
               ab->pool));
 
       /* If the existing view overlaps with the new view, copy the
        * overlap to the beginning of the new buffer.  */
       if (  (apr_size_t)ab->sbuf_offset + ab->sbuf_len
-          > (apr_size_t)window->sview_offset)
+          > (apr_size_t)sview_offset)
         {
           apr_size_t start =
-            (apr_size_t)(window->sview_offset - ab->sbuf_offset);
+            (apr_size_t)(sview_offset - ab->sbuf_offset);
           memmove(ab->sbuf, old_sbuf + start, ab->sbuf_len - start);
           ab->sbuf_len -= start;
         }
       else
         ab->sbuf_len = 0;
-      ab->sbuf_offset = window->sview_offset;
+      ab->sbuf_offset = sview_offset;
     }
 
   /* Read the remainder of the source view into the buffer.  */
-  if (ab->sbuf_len < window->sview_len)
+  if (ab->sbuf_len < sview_len)
     {
-      len = window->sview_len - ab->sbuf_len;
+      len = sview_len - ab->sbuf_len;
       SVN_ERR(svn_stream_read_full(ab->source, ab->sbuf + ab->sbuf_len, &len));
-      if (len != window->sview_len - ab->sbuf_len)
+      if (len != sview_len - ab->sbuf_len)
         return svn_error_create(SVN_ERR_INCOMPLETE_DATA, NULL,
                                 "Delta source ended unexpectedly");
-      ab->sbuf_len = window->sview_len;
+      ab->sbuf_len = sview_len;
     }
 
+  return SVN_NO_ERROR;
+}
+
+/* Write the first LEN bytes of AB->TBUF, i.e. the target view just
+ * created, to the target stream.  */
+static svn_error_t *
+end_apply_window(struct apply_baton *ab,
+                 apr_size_t len)
+{
+  /* Just update the context here. */
+  if (ab->result_digest)
+    SVN_ERR(svn_checksum_update(ab->md5_context, ab->tbuf, len));
+
+  return svn_stream_write(ab->target, ab->tbuf, &len);
+}
+
+/* Apply WINDOW to the streams given by APPL.  */
+static svn_error_t *
+apply_window(svn_txdelta_window_t *window, void *baton)
+{
+  struct apply_baton *ab = (struct apply_baton *) baton;
+  apr_size_t len;
+
+  if (window == NULL)
+    {
+      svn_error_t *err = SVN_NO_ERROR;
+
+      /* We're done; just clean up.  */
+      if (ab->result_digest)
+        {
+          svn_checksum_t *md5_checksum;
+
+          err = svn_checksum_final(&md5_checksum, ab->md5_context, ab->pool);
+          if (!err)
+            memcpy(ab->result_digest, md5_checksum->digest,
+                   svn_checksum_size(md5_checksum));
+        }
+
+      err = svn_error_compose_create(err, svn_stream_close(ab->target));
+      svn_pool_destroy(ab->pool);
+
+      return err;
+    }
+
+  SVN_ERR(begin_apply_window(ab, window->sview_offset, window->sview_len,
+                             window->tview_len));
+
   /* Apply the window instructions to the source view to generate
      the target view.  */
   len = window->tview_len;
@@ -794,12 +951,37 @@ apply_window(svn_txdelta_window_t *window, void *baton)
   SVN_ERR_ASSERT(len == window->tview_len);
 
   /* Write out the output. */
+  return end_apply_window(ab, len);
+}
 
-  /* Just update the context here. */
-  if (ab->result_digest)
-    SVN_ERR(svn_checksum_update(ab->md5_context, ab->tbuf, len));
+svn_boolean_t
+svn_txdelta__is_apply_handler(svn_txdelta_window_handler_t handler)
+{
+  return handler == apply_window;
+}
 
-  return svn_stream_write(ab->target, ab->tbuf, &len);
+svn_error_t *
+svn_txdelta__apply_begin(char **tbuf,
+                         const char **sbuf,
+                         void *handler_baton,
+                         svn_filesize_t sview_offset,
+                         apr_size_t sview_len,
+                         apr_size_t tview_len)
+{
+  struct apply_baton *ab = handler_baton;
+
+  SVN_ERR(begin_apply_window(ab, sview_offset, sview_len, tview_len));
+  *tbuf = ab->tbuf;
+  *sbuf = ab->sbuf;
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_txdelta__apply_end(void *handler_baton,
+                       apr_size_t tview_len)
+{
+  return end_apply_window(handler_baton, tview_len);
 }
 
 
@@ -936,6 +1118,40 @@ svn_error_t *svn_txdelta_send_txstream(svn_txdelta_stream_t *txstream,
   /* create a pool just for the windows */
   apr_pool_t *wpool = svn_pool_create(pool);
 
+  /* Don't parse windows only to have them encoded again. */
+  if (txstream->next_raw_window && svn_txdelta__accepts_raw_windows(handler))
+    {
+      while (TRUE)
+        {
+          const svn_string_t *raw_window;
+          int svndiff_version;
+          svn_boolean_t sent;
+
+          svn_pool_clear(wpool);
+          SVN_ERR(txstream->next_raw_window(&raw_window, &svndiff_version,
+                                            txstream->baton, wpool));
+          if (!raw_window)
+            break;
+
+          SVN_ERR(svn_txdelta__send_raw_window(&sent, handler_baton,
+                                               raw_window, svndiff_version));
+          if (!sent)
+            {
+              /* Format mismatch.  Take the long route for this one. */
+              svn_stream_t *stream = svn_stream_from_string(raw_window,
+                                                            wpool);
+              SVN_ERR(svn_txdelta_read_svndiff_window(&window, stream,
+                                                      svndiff_version,
+                                                      wpool));
+              SVN_ERR((*handler)(window, handler_baton));
+            }
+        }
+
+      svn_pool_destroy(wpool);
+
+      return svn_error_trace((*handler)(NULL, handler_baton));
+    }
+
   do
     {
       /* free the window (if any) */
@@ -31,6 +31,13 @@
 #include "svn_delta.h"
 #include "private/svn_string_private.h"
 #include "delta.h"
+
+/* SSE2 is part of the x86-64 base ISA, so it can be used without runtime
+ * detection. */
+#if defined(__GNUC__) && defined(__SSE2__)
+#  define SVN_XDELTA_SSE2 1
+#  include <emmintrin.h>
+#endif
 
 /* This is pseudo-adler32. It is adler32 without the prime modulus.
    The idea is borrowed from monotone, and is a translation of the C++
@@ -82,6 +89,44 @@ adler32_replace(apr_uint32_t adler32, const char c_out, const char c_in)
 static APR_INLINE apr_uint32_t
 init_adler32(const char *data)
 {
+#if SVN_XDELTA_SSE2 && (MATCH_BLOCKSIZE == 64)
+
+  /* Same result as the scalar code below:  S1 is the plain byte sum and
+     S2 sums up each byte weighted by its distance to the end of the
+     block.  Both are exact in 32 bits, so the final result is identical. */
+  const __m128i zero = _mm_setzero_si128();
+  __m128i sum1 = zero;
+  __m128i sum2 = zero;
+  __m128i weights = _mm_setr_epi16(64, 63, 62, 61, 60, 59, 58, 57);
+  const __m128i step = _mm_set1_epi16(8);
+  apr_uint32_t s1, s2;
+  int i;
+
+  for (i = 0; i < MATCH_BLOCKSIZE; i += 16)
+    {
+      __m128i chunk = _mm_loadu_si128((const __m128i *)(data + i));
+      __m128i lo = _mm_unpacklo_epi8(chunk, zero);
+      __m128i hi = _mm_unpackhi_epi8(chunk, zero);
+
+      sum1 = _mm_add_epi64(sum1, _mm_sad_epu8(chunk, zero));
+
+      sum2 = _mm_add_epi32(sum2, _mm_madd_epi16(lo, weights));
+      weights = _mm_sub_epi16(weights, step);
+      sum2 = _mm_add_epi32(sum2, _mm_madd_epi16(hi, weights));
+      weights = _mm_sub_epi16(weights, step);
+    }
+
+  s1 = (apr_uint32_t)_mm_cvtsi128_si32(sum1)
+     + (apr_uint32_t)_mm_cvtsi128_si32(_mm_srli_si128(sum1, 8));
+
+  sum2 = _mm_add_epi32(sum2, _mm_srli_si128(sum2, 8));
+  sum2 = _mm_add_epi32(sum2, _mm_srli_si128(sum2, 4));
+  s2 = (apr_uint32_t)_mm_cvtsi128_si32(sum2);
+
+  return s2 * 0x10000 + s1;
+
+#else
+
   const unsigned char *input = (const unsigned char *)data;
   const unsigned char *last = input + MATCH_BLOCKSIZE;
 
@@ -101,6 +146,8 @@ init_adler32(const char *data)
     }
 
   return s2 * 0x10000 + s1;
+
+#endif
 }
 
 /* Information for a block of the delta source.  The length of the
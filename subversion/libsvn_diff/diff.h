@@ -33,7 +33,6 @@
 
 #define SVN_DIFF__UNIFIED_CONTEXT_SIZE 3
 
-typedef struct svn_diff__node_t svn_diff__node_t;
 typedef struct svn_diff__tree_t svn_diff__tree_t;
 typedef struct svn_diff__position_t svn_diff__position_t;
 typedef struct svn_diff__lcs_t svn_diff__lcs_t;
@@ -115,6 +114,27 @@ svn_diff__lcs(svn_diff__position_t *position_list1, /* pointer to tail (ring) */
               apr_pool_t *pool);
 
 
+/*
+ * Like svn_diff__lcs() but using the patience diff algorithm: Lines that
+ * occur exactly once in both compared ranges get matched first, along
+ * their longest increasing subsequence.  The ranges between those matches
+ * are handled the same way, recursively.  Ranges without any such lines
+ * fall back to svn_diff__lcs().
+ *
+ * The result will also be a common subsequence but not necessarily the
+ * longest one.
+ */
+svn_diff__lcs_t *
+svn_diff__lcs_patience(svn_diff__position_t *position_list1, /* tail (ring) */
+                       svn_diff__position_t *position_list2, /* tail (ring) */
+                       svn_diff__token_index_t *token_counts_list1,
+                       svn_diff__token_index_t *token_counts_list2,
+                       svn_diff__token_index_t num_tokens,
+                       apr_off_t prefix_lines,
+                       apr_off_t suffix_lines,
+                       apr_pool_t *pool);
+
+
 /*
  * Returns number of tokens in a tree
  */
@@ -151,6 +171,22 @@ svn_diff__get_token_counts(svn_diff__position_t *loop_start,
                            svn_diff__token_index_t num_tokens,
                            apr_pool_t *pool);
 
+/* Like svn_diff_diff_2() and svn_diff_diff3_2() but using ALGORITHM
+ * to find the common subsequences. */
+svn_error_t *
+svn_diff__diff_2(svn_diff_t **diff,
+                 void *diff_baton,
+                 const svn_diff_fns2_t *vtable,
+                 svn_diff_file_algorithm_t algorithm,
+                 apr_pool_t *pool);
+
+svn_error_t *
+svn_diff__diff3_2(svn_diff_t **diff,
+                  void *diff_baton,
+                  const svn_diff_fns2_t *vtable,
+                  svn_diff_file_algorithm_t algorithm,
+                  apr_pool_t *pool);
+
 /* Morph a svn_lcs_t into a svn_diff_t. */
 svn_diff_t *
 svn_diff__diff(svn_diff__lcs_t *lcs,
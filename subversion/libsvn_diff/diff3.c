@@ -248,10 +248,11 @@ svn_diff__resolve_conflict(svn_diff_t *hunk,
 
 
 svn_error_t *
-svn_diff_diff3_2(svn_diff_t **diff,
-                 void *diff_baton,
-                 const svn_diff_fns2_t *vtable,
-                 apr_pool_t *pool)
+svn_diff__diff3_2(svn_diff_t **diff,
+                  void *diff_baton,
+                  const svn_diff_fns2_t *vtable,
+                  svn_diff_file_algorithm_t algorithm,
+                  apr_pool_t *pool)
 {
   svn_diff__tree_t *tree;
   svn_diff__position_t *position_list[3];
@@ -315,12 +316,26 @@ svn_diff_diff3_2(svn_diff_t **diff,
                                                subpool);
 
   /* Get the lcs for original-modified and original-latest */
-  lcs_om = svn_diff__lcs(position_list[0], position_list[1], token_counts[0],
-                         token_counts[1], num_tokens, prefix_lines,
-                         suffix_lines, subpool);
-  lcs_ol = svn_diff__lcs(position_list[0], position_list[2], token_counts[0],
-                         token_counts[2], num_tokens, prefix_lines,
-                         suffix_lines, subpool);
+  if (algorithm == svn_diff_file_algorithm_patience)
+    {
+      lcs_om = svn_diff__lcs_patience(position_list[0], position_list[1],
+                                      token_counts[0], token_counts[1],
+                                      num_tokens, prefix_lines,
+                                      suffix_lines, subpool);
+      lcs_ol = svn_diff__lcs_patience(position_list[0], position_list[2],
+                                      token_counts[0], token_counts[2],
+                                      num_tokens, prefix_lines,
+                                      suffix_lines, subpool);
+    }
+  else
+    {
+      lcs_om = svn_diff__lcs(position_list[0], position_list[1],
+                             token_counts[0], token_counts[1], num_tokens,
+                             prefix_lines, suffix_lines, subpool);
+      lcs_ol = svn_diff__lcs(position_list[0], position_list[2],
+                             token_counts[0], token_counts[2], num_tokens,
+                             prefix_lines, suffix_lines, subpool);
+    }
 
   /* Produce a merged diff */
   {
@@ -530,3 +545,14 @@ svn_diff_diff3_2(svn_diff_t **diff,
 
   return SVN_NO_ERROR;
 }
+
+svn_error_t *
+svn_diff_diff3_2(svn_diff_t **diff,
+                 void *diff_baton,
+                 const svn_diff_fns2_t *vtable,
+                 apr_pool_t *pool)
+{
+  return svn_error_trace(svn_diff__diff3_2(diff, diff_baton, vtable,
+                                           svn_diff_file_algorithm_lcs,
+                                           pool));
+}
@@ -28,7 +28,6 @@
 #include <apr_file_io.h>
 #include <apr_file_info.h>
 #include <apr_time.h>
-#include <apr_mmap.h>
 #include <apr_getopt.h>
 
 #include <assert.h>
@@ -152,82 +151,6 @@ read_chunk(apr_file_t *file,
 }
 
 
-/* Map or read a file at PATH. *BUFFER will point to the file
- * contents; if the file was mapped, *FILE and *MM will contain the
- * mmap context; otherwise they will be NULL.  SIZE will contain the
- * file size.  Allocate from POOL.
- */
-#if APR_HAS_MMAP
-#define MMAP_T_PARAM(NAME) apr_mmap_t **NAME,
-#define MMAP_T_ARG(NAME)   &(NAME),
-#else
-#define MMAP_T_PARAM(NAME)
-#define MMAP_T_ARG(NAME)
-#endif
-
-static svn_error_t *
-map_or_read_file(apr_file_t **file,
-                 MMAP_T_PARAM(mm)
-                 char **buffer, apr_size_t *size_p,
-                 const char *path, apr_pool_t *pool)
-{
-  apr_finfo_t finfo;
-  apr_status_t rv;
-  apr_size_t size;
-
-  *buffer = NULL;
-
-  SVN_ERR(svn_io_file_open(file, path, APR_READ, APR_OS_DEFAULT, pool));
-  SVN_ERR(svn_io_file_info_get(&finfo, APR_FINFO_SIZE, *file, pool));
-
-  if (finfo.size > APR_SIZE_MAX)
-    {
-      return svn_error_createf(APR_ENOMEM, NULL,
-                               _("File '%s' is too large to be read in "
-                                 "to memory"), path);
-    }
-
-  size = (apr_size_t) finfo.size;
-#if APR_HAS_MMAP
-  if (size > APR_MMAP_THRESHOLD)
-    {
-      rv = apr_mmap_create(mm, *file, 0, size, APR_MMAP_READ, pool);
-      if (rv == APR_SUCCESS)
-        {
-          *buffer = (*mm)->mm;
-        }
-      else
-        {
-          /* Clear *MM because output parameters are undefined on error. */
-          *mm = NULL;
-        }
-
-      /* On failure we just fall through and try reading the file into
-       * memory instead.
-       */
-    }
-#endif /* APR_HAS_MMAP */
-
-   if (*buffer == NULL && size > 0)
-    {
-      *buffer = apr_palloc(pool, size);
-
-      SVN_ERR(svn_io_file_read_full2(*file, *buffer, size, NULL, NULL, pool));
-
-      /* Since we have the entire contents of the file we can
-       * close it now.
-       */
-      SVN_ERR(svn_io_file_close(*file, pool));
-
-      *file = NULL;
-    }
-
-  *size_p = size;
-
-  return SVN_NO_ERROR;
-}
-
-
 /* For all files in the FILE array, increment the curp pointer.  If a file
  * points before the beginning of file, let it point at the first byte again.
  * If the end of the current chunk is reached, read the next chunk in the
@@ -912,6 +835,29 @@ datasource_get_next_token(apr_uint32_t *hash, void **token, void *baton,
   file_token->raw_length = 0;
   file_token->length = 0;
 
+  /* Fast path: without normalization, a line that ends within the current
+   * chunk can be hashed in place. */
+  if (!file_baton->options->ignore_space
+      && !file_baton->options->ignore_eol_style)
+    {
+      eol = svn_eol__find_eol_start(curp, endp - curp);
+      if (eol && (*eol == '\n' || eol + 1 < endp))
+        {
+          if (*eol++ == '\r' && *eol == '\n')
+            eol++;
+
+          length = eol - curp;
+          file_token->raw_length = length;
+          file_token->length = length;
+          file->curp = eol;
+
+          *hash = svn__adler32(0, curp, length);
+          *token = file_token;
+
+          return SVN_NO_ERROR;
+        }
+    }
+
   while (1)
     {
       eol = svn_eol__find_eol_start(curp, endp - curp);
@@ -1179,8 +1125,9 @@ static const svn_diff_fns2_t svn_diff__file_vtable =
   token_discard_all
 };
 
-/* Id for the --ignore-eol-style option, which doesn't have a short name. */
+/* Ids for the options that don't have a short name. */
 #define SVN_DIFF__OPT_IGNORE_EOL_STYLE 256
+#define SVN_DIFF__OPT_PATIENCE 257
 
 /* Options supported by svn_diff_file_options_parse(). */
 static const apr_getopt_option_t diff_options[] =
@@ -1193,6 +1140,7 @@ static const apr_getopt_option_t diff_options[] =
    * ### we don't have optional argument support. */
   { "unified", 'u', 0, NULL },
   { "context", 'U', 1, NULL },
+  { "patience", SVN_DIFF__OPT_PATIENCE, 0, NULL },
   { NULL, 0, 0, NULL }
 };
 
@@ -1298,6 +1246,9 @@ svn_diff_file_options_parse(svn_diff_file_options_t *options,
         case 'U':
           SVN_ERR(svn_cstring_atoi(&options->context_size, opt_arg));
           break;
+        case SVN_DIFF__OPT_PATIENCE:
+          options->algorithm = svn_diff_file_algorithm_patience;
+          break;
         default:
           break;
         }
@@ -1326,7 +1277,8 @@ svn_diff_file_diff_2(svn_diff_t **diff,
   baton.files[1].path = modified;
   baton.pool = svn_pool_create(pool);
 
-  SVN_ERR(svn_diff_diff_2(diff, &baton, &svn_diff__file_vtable, pool));
+  SVN_ERR(svn_diff__diff_2(diff, &baton, &svn_diff__file_vtable,
+                           options->algorithm, pool));
 
   svn_pool_destroy(baton.pool);
   return SVN_NO_ERROR;
@@ -1348,7 +1300,8 @@ svn_diff_file_diff3_2(svn_diff_t **diff,
   baton.files[2].path = latest;
   baton.pool = svn_pool_create(pool);
 
-  SVN_ERR(svn_diff_diff3_2(diff, &baton, &svn_diff__file_vtable, pool));
+  SVN_ERR(svn_diff__diff3_2(diff, &baton, &svn_diff__file_vtable,
+                            options->algorithm, pool));
 
   svn_pool_destroy(baton.pool);
   return SVN_NO_ERROR;
@@ -1973,14 +1926,13 @@ svn_diff_file_output_unified4(svn_stream_t *output_stream,
 
 /** Display diff3 **/
 
-/* A stream to remember *leading* context.  Note that this stream does
-   *not* copy the data that it is remembering; it just saves
-   *pointers! */
+/* A stream to remember *leading* context.  The input files are read in
+   chunks, so this stream copies the lines that it is remembering. */
 typedef struct context_saver_t {
   svn_stream_t *stream;
   int context_size;
-  const char **data; /* const char *data[context_size] */
-  apr_size_t *len;   /* apr_size_t len[context_size] */
+  svn_stringbuf_t **data; /* svn_stringbuf_t *data[context_size] */
+  apr_pool_t *pool;
   apr_size_t next_slot;
   apr_ssize_t total_writes;
 } context_saver_t;
@@ -1995,8 +1947,18 @@ context_saver_stream_write(void *baton,
 
   if (cs->context_size > 0)
     {
-      cs->data[cs->next_slot] = data;
-      cs->len[cs->next_slot] = *len;
+      svn_stringbuf_t **slot = &cs->data[cs->next_slot];
+
+      if (*slot)
+        {
+          svn_stringbuf_setempty(*slot);
+          svn_stringbuf_appendbytes(*slot, data, *len);
+        }
+      else
+        {
+          *slot = svn_stringbuf_ncreate(data, *len, cs->pool);
+        }
+
       cs->next_slot = (cs->next_slot + 1) % cs->context_size;
       cs->total_writes++;
     }
@@ -2011,9 +1973,18 @@ typedef struct svn_diff3__file_output_baton_t
 
   apr_off_t   current_line[3];
 
+  /* The input files are read in chunks into BUFFER.  CURP points to the
+     next line to process and ENDP behind the data read so far.  BUFFER
+     grows as needed to hold the longest line. */
+  apr_file_t *file[3];
   char       *buffer[3];
+  apr_size_t  buffer_size[3];
   char       *endp[3];
   char       *curp[3];
+  svn_boolean_t eof[3];
+
+  /* Pool for the BUFFERs and file reads. */
+  apr_pool_t *buffer_pool;
 
   /* The following four members are in the encoding used for the output. */
   const char *conflict_modified;
@@ -2053,8 +2024,9 @@ flush_context_saver(context_saver_t *cs,
       apr_size_t slot = (i + cs->next_slot) % cs->context_size;
       if (cs->data[slot])
         {
-          apr_size_t len = cs->len[slot];
-          SVN_ERR(svn_stream_write(output_stream, cs->data[slot], &len));
+          apr_size_t len = cs->data[slot]->len;
+          SVN_ERR(svn_stream_write(output_stream, cs->data[slot]->data,
+                                   &len));
         }
     }
   return SVN_NO_ERROR;
@@ -2076,7 +2048,7 @@ make_context_saver(svn_diff3__file_output_baton_t *fob)
   fob->output_stream = cs->stream;
   cs->context_size = fob->context_size;
   cs->data = apr_pcalloc(fob->pool, sizeof(*cs->data) * cs->context_size);
-  cs->len = apr_pcalloc(fob->pool, sizeof(*cs->len) * cs->context_size);
+  cs->pool = fob->pool;
 }
 
 
@@ -2132,6 +2104,70 @@ typedef enum svn_diff3__file_output_type_e
 } svn_diff3__file_output_type_e;
 
 
+/* Move the unprocessed data of input file IDX in BATON to the start of
+   its buffer, growing the buffer if it is full, and append the next
+   chunk of the file to it. */
+static svn_error_t *
+read_more(svn_diff3__file_output_baton_t *baton, int idx)
+{
+  apr_size_t keep = baton->endp[idx] - baton->curp[idx];
+  apr_size_t len;
+
+  if (keep == baton->buffer_size[idx])
+    {
+      char *buffer = apr_palloc(baton->buffer_pool, 2 * keep);
+
+      memcpy(buffer, baton->curp[idx], keep);
+      baton->buffer[idx] = buffer;
+      baton->buffer_size[idx] *= 2;
+    }
+  else if (keep > 0 && baton->curp[idx] != baton->buffer[idx])
+    {
+      memmove(baton->buffer[idx], baton->curp[idx], keep);
+    }
+
+  baton->curp[idx] = baton->buffer[idx];
+  baton->endp[idx] = baton->buffer[idx] + keep;
+
+  len = baton->buffer_size[idx] - keep;
+  SVN_ERR(svn_io_file_read_full2(baton->file[idx], baton->endp[idx], len,
+                                 &len, &baton->eof[idx],
+                                 baton->buffer_pool));
+  baton->endp[idx] += len;
+
+  return SVN_NO_ERROR;
+}
+
+/* Find the end of the line starting at CURP of input file IDX in BATON,
+   reading more data as needed.  Set *EOL to the first EOL character or
+   to NULL if the line has none.  The whole line will be in the buffer. */
+static svn_error_t *
+find_line_end(char **eol,
+              svn_diff3__file_output_baton_t *baton,
+              int idx)
+{
+  apr_size_t scanned = 0;
+
+  while (1)
+    {
+      char *curp = baton->curp[idx];
+      char *endp = baton->endp[idx];
+
+      *eol = svn_eol__find_eol_start(curp + scanned,
+                                     endp - curp - scanned);
+
+      /* A CR at the end of the buffer may be followed by a LF. */
+      if (*eol && (**eol == '\n' || *eol + 1 < endp || baton->eof[idx]))
+        return SVN_NO_ERROR;
+
+      if (baton->eof[idx])
+        return SVN_NO_ERROR;
+
+      scanned = *eol ? (apr_size_t)(*eol - curp) : (apr_size_t)(endp - curp);
+      SVN_ERR(read_more(baton, idx));
+    }
+}
+
 static svn_error_t *
 output_line(svn_diff3__file_output_baton_t *baton,
             svn_diff3__file_output_type_e type, int idx)
@@ -2141,17 +2177,18 @@ output_line(svn_diff3__file_output_baton_t *baton,
   char *eol;
   apr_size_t len;
 
-  curp = baton->curp[idx];
-  endp = baton->endp[idx];
-
   /* Lazily update the current line even if we're at EOF.
    */
   baton->current_line[idx]++;
 
+  SVN_ERR(find_line_end(&eol, baton, idx));
+
+  curp = baton->curp[idx];
+  endp = baton->endp[idx];
+
   if (curp == endp)
     return SVN_NO_ERROR;
 
-  eol = svn_eol__find_eol_start(curp, endp - curp);
   if (!eol)
     eol = endp;
   else
@@ -2389,11 +2426,8 @@ svn_diff_file_output_merge3(svn_stream_t *output_stream,
                             apr_pool_t *scratch_pool)
 {
   svn_diff3__file_output_baton_t baton;
-  apr_file_t *file[3];
   int idx;
-#if APR_HAS_MMAP
-  apr_mmap_t *mm[3] = { 0 };
-#endif /* APR_HAS_MMAP */
+  char *eolp;
   const char *eol;
   svn_boolean_t conflicts_only =
     (style == svn_diff_conflict_display_only_conflicts);
@@ -2432,26 +2466,27 @@ svn_diff_file_output_merge3(svn_stream_t *output_stream,
 
   baton.conflict_style = style;
 
+  /* Read the files in chunks, so that memory usage does not depend on
+     the file sizes. */
+  baton.buffer_pool = scratch_pool;
   for (idx = 0; idx < 3; idx++)
     {
-      apr_size_t size;
-
-      SVN_ERR(map_or_read_file(&file[idx],
-                               MMAP_T_ARG(mm[idx])
-                               &baton.buffer[idx], &size,
-                               baton.path[idx], scratch_pool));
+      SVN_ERR(svn_io_file_open(&baton.file[idx], baton.path[idx],
+                               APR_READ, APR_OS_DEFAULT,
+                               scratch_pool));
 
+      baton.buffer_size[idx] = CHUNK_SIZE;
+      baton.buffer[idx] = apr_palloc(scratch_pool, CHUNK_SIZE);
       baton.curp[idx] = baton.buffer[idx];
       baton.endp[idx] = baton.buffer[idx];
-
-      if (baton.endp[idx])
-        baton.endp[idx] += size;
+      SVN_ERR(read_more(&baton, idx));
     }
 
   /* Check what eol marker we should use for conflict markers.
      We use the eol marker of the modified file and fall back on the
      platform's eol marker if that file doesn't contain any newlines. */
-  eol = svn_eol__detect_eol(baton.buffer[1], baton.endp[1] - baton.buffer[1],
+  SVN_ERR(find_line_end(&eolp, &baton, 1));
+  eol = svn_eol__detect_eol(baton.curp[1], baton.endp[1] - baton.curp[1],
                             NULL);
   if (! eol)
     eol = APR_EOL_STR;
@@ -2465,24 +2500,7 @@ svn_diff_file_output_merge3(svn_stream_t *output_stream,
                           cancel_func, cancel_baton));
 
   for (idx = 0; idx < 3; idx++)
-    {
-#if APR_HAS_MMAP
-      if (mm[idx])
-        {
-          apr_status_t rv = apr_mmap_delete(mm[idx]);
-          if (rv != APR_SUCCESS)
-            {
-              return svn_error_wrap_apr(rv, _("Failed to delete mmap '%s'"),
-                                        baton.path[idx]);
-            }
-        }
-#endif /* APR_HAS_MMAP */
-
-      if (file[idx])
-        {
-          SVN_ERR(svn_io_file_close(file[idx], scratch_pool));
-        }
-    }
+    SVN_ERR(svn_io_file_close(baton.file[idx], scratch_pool));
 
   if (conflicts_only)
     svn_pool_destroy(baton.pool);
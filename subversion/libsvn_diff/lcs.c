@@ -26,6 +26,9 @@
 #include <apr_pools.h>
 #include <apr_general.h>
 
+#include "svn_pools.h"
+#include "svn_sorts.h"
+
 #include "diff.h"
 
 
@@ -228,20 +231,22 @@ prepend_lcs(svn_diff__lcs_t *lcs, apr_off_t lines,
 }
 
 
-svn_diff__lcs_t *
-svn_diff__lcs(svn_diff__position_t *position_list1, /* pointer to tail (ring) */
-              svn_diff__position_t *position_list2, /* pointer to tail (ring) */
-              svn_diff__token_index_t *token_counts_list1, /* array of counts */
-              svn_diff__token_index_t *token_counts_list2, /* array of counts */
-              svn_diff__token_index_t num_tokens,
-              apr_off_t prefix_lines,
-              apr_off_t suffix_lines,
-              apr_pool_t *pool)
+/* The implementation of svn_diff__lcs(), with UNIQUE_COUNT[0] and
+ * UNIQUE_COUNT[1] being the number of tokens in POSITION_LIST1 and
+ * POSITION_LIST2 that are not in the respective other list.
+ */
+static svn_diff__lcs_t *
+lcs_internal(svn_diff__position_t *position_list1,
+             svn_diff__position_t *position_list2,
+             svn_diff__token_index_t *token_counts_list1,
+             svn_diff__token_index_t *token_counts_list2,
+             const svn_diff__token_index_t unique_count[2],
+             apr_off_t prefix_lines,
+             apr_off_t suffix_lines,
+             apr_pool_t *pool)
 {
   apr_off_t length[2];
   svn_diff__token_index_t *token_counts[2];
-  svn_diff__token_index_t unique_count[2];
-  svn_diff__token_index_t token_index;
   svn_diff__snake_t *fp;
   apr_off_t d;
   apr_off_t k;
@@ -279,15 +284,6 @@ svn_diff__lcs(svn_diff__position_t *position_list1, /* pointer to tail (ring) */
       return lcs;
     }
 
-  unique_count[1] = unique_count[0] = 0;
-  for (token_index = 0; token_index < num_tokens; token_index++)
-    {
-      if (token_counts_list1[token_index] == 0)
-        unique_count[1] += token_counts_list2[token_index];
-      if (token_counts_list2[token_index] == 0)
-        unique_count[0] += token_counts_list1[token_index];
-    }
-
   /* Calculate lengths M and N of the sequences to be compared. Do not
    * count tokens unique to one file, as those are ignored in __snake.
    */
@@ -373,3 +369,483 @@ svn_diff__lcs(svn_diff__position_t *position_list1, /* pointer to tail (ring) */
   else
     return lcs;
 }
+
+svn_diff__lcs_t *
+svn_diff__lcs(svn_diff__position_t *position_list1, /* pointer to tail (ring) */
+              svn_diff__position_t *position_list2, /* pointer to tail (ring) */
+              svn_diff__token_index_t *token_counts_list1, /* array of counts */
+              svn_diff__token_index_t *token_counts_list2, /* array of counts */
+              svn_diff__token_index_t num_tokens,
+              apr_off_t prefix_lines,
+              apr_off_t suffix_lines,
+              apr_pool_t *pool)
+{
+  svn_diff__token_index_t unique_count[2];
+  svn_diff__token_index_t token_index;
+
+  unique_count[1] = unique_count[0] = 0;
+  if (position_list1 != NULL && position_list2 != NULL)
+    for (token_index = 0; token_index < num_tokens; token_index++)
+      {
+        if (token_counts_list1[token_index] == 0)
+          unique_count[1] += token_counts_list2[token_index];
+        if (token_counts_list2[token_index] == 0)
+          unique_count[0] += token_counts_list1[token_index];
+      }
+
+  return lcs_internal(position_list1, position_list2, token_counts_list1,
+                      token_counts_list2, unique_count, prefix_lines,
+                      suffix_lines, pool);
+}
+
+
+/*
+ * Patience diff.
+ *
+ * Lines that occur exactly once in both ranges to compare are very likely
+ * to correspond to each other.  So we match those first, along the longest
+ * subsequence in which they appear in the same order in both ranges, and
+ * then handle the gaps between those anchors the same way.  Common lines
+ * at the start and the end of a range simply get matched, which is what
+ * extends the anchors into the regions around them.
+ *
+ * If a range has no unique lines, we use the lines with the lowest number
+ * of occurrences instead, as long as they occur equally often in both
+ * ranges, and pair their occurrences in order.  Only ranges without any
+ * such lines fall back to the O(ND) algorithm above.  Ranges that are too
+ * large for it get reported as changed as a whole, which keeps the worst
+ * case bounded.
+ */
+
+/* Don't use lines that occur more often than this as anchors. */
+#define PATIENCE_MAX_OCCURRENCES 64
+
+/* Maximum total length of the two token ranges in a fallback to the
+ * O(ND) algorithm. */
+#define PATIENCE_MAX_LCS_LENGTH 8192
+
+/* A range of tokens still to be compared, or a match to be recorded once
+ * everything before it has been processed.  START and END are indexes
+ * into patience_baton_t.POSITIONS. */
+typedef struct patience_work_t
+{
+  apr_off_t start[2];
+  apr_off_t end[2];
+  svn_boolean_t is_match;
+} patience_work_t;
+
+/* A common run of LENGTH tokens found so far. */
+typedef struct patience_match_t
+{
+  svn_diff__position_t *position[2];
+  apr_off_t length;
+} patience_match_t;
+
+typedef struct patience_baton_t
+{
+  /* All tokens to compare, in order. */
+  svn_diff__position_t **positions[2];
+
+  /* Number of occurrences of each token within the current range.  All
+   * zero between ranges. */
+  svn_diff__token_index_t *counts[2];
+
+  /* Per token: index of the next occurrence in the second range that
+   * has not been paired yet. */
+  apr_off_t *cursor;
+
+  /* The patience_match_t found so far, in order. */
+  apr_array_header_t *matches;
+} patience_baton_t;
+
+/* Record a match of LENGTH tokens at POSITION0 and POSITION1 in PB,
+ * extending the previous match if possible. */
+static void
+patience_add_match(patience_baton_t *pb,
+                   svn_diff__position_t *position0,
+                   svn_diff__position_t *position1,
+                   apr_off_t length)
+{
+  patience_match_t *match;
+
+  if (length == 0)
+    return;
+
+  if (pb->matches->nelts)
+    {
+      match = &APR_ARRAY_IDX(pb->matches, pb->matches->nelts - 1,
+                             patience_match_t);
+      if (match->position[0]->offset + match->length == position0->offset
+          && match->position[1]->offset + match->length == position1->offset)
+        {
+          match->length += length;
+          return;
+        }
+    }
+
+  match = apr_array_push(pb->matches);
+  match->position[0] = position0;
+  match->position[1] = position1;
+  match->length = length;
+}
+
+/* Set *ANCHOR_COUNT to the length of the longest subsequence of the
+ * ANCHOR_COUNT anchors in ANCHORS[0] / ANCHORS[1] that is increasing in
+ * both, and return it in place.  ANCHORS[0] must be increasing already.
+ * Use SCRATCH_POOL for temporaries. */
+static void
+patience_longest_sequence(apr_off_t *anchors[2],
+                          apr_off_t *anchor_count,
+                          apr_pool_t *scratch_pool)
+{
+  apr_off_t count = *anchor_count;
+  apr_off_t *tails = apr_palloc(scratch_pool, count * sizeof(*tails));
+  apr_off_t *previous = apr_palloc(scratch_pool, count * sizeof(*previous));
+  apr_off_t length = 0;
+  apr_off_t i, k;
+
+  /* Patience sorting: TAILS[K] is the anchor ending the best increasing
+   * sequence of length K+1 found so far. */
+  for (i = 0; i < count; i++)
+    {
+      apr_off_t lo = 0;
+      apr_off_t hi = length;
+
+      while (lo < hi)
+        {
+          apr_off_t mid = lo + (hi - lo) / 2;
+          if (anchors[1][tails[mid]] < anchors[1][i])
+            lo = mid + 1;
+          else
+            hi = mid;
+        }
+
+      previous[i] = lo ? tails[lo - 1] : -1;
+      tails[lo] = i;
+      if (lo == length)
+        length++;
+    }
+
+  /* Collect the indexes of the sequence in TAILS, which we don't need
+   * anymore, and compact the anchors front to back such that we never
+   * overwrite one we still have to read. */
+  for (k = length - 1, i = tails[length - 1]; k >= 0; k--, i = previous[i])
+    tails[k] = i;
+
+  for (k = 0; k < length; k++)
+    {
+      anchors[0][k] = anchors[0][tails[k]];
+      anchors[1][k] = anchors[1][tails[k]];
+    }
+
+  *anchor_count = length;
+}
+
+/* Compare the tokens in RANGE of PB using the O(ND) algorithm and record
+ * the matches in PB.  The counts in PB must be those of RANGE.  Use
+ * SCRATCH_POOL for temporaries. */
+static void
+patience_fallback(patience_baton_t *pb,
+                  const patience_work_t *range,
+                  apr_pool_t *scratch_pool)
+{
+  svn_diff__position_t *tail[2];
+  svn_diff__position_t *next[2];
+  svn_diff__token_index_t unique_count[2];
+  svn_diff__lcs_t *lcs;
+  apr_off_t i;
+  int j;
+
+  if (range->end[0] - range->start[0] + range->end[1] - range->start[1]
+      > PATIENCE_MAX_LCS_LENGTH)
+    return;
+
+  for (j = 0; j < 2; j++)
+    {
+      unique_count[j] = 0;
+      for (i = range->start[j]; i < range->end[j]; i++)
+        if (pb->counts[1 - j][pb->positions[j][i]->token_index] == 0)
+          unique_count[j]++;
+    }
+
+  /* Temporarily turn the ranges into rings of their own. */
+  for (j = 0; j < 2; j++)
+    {
+      tail[j] = pb->positions[j][range->end[j] - 1];
+      next[j] = tail[j]->next;
+      tail[j]->next = pb->positions[j][range->start[j]];
+    }
+
+  lcs = lcs_internal(tail[0], tail[1], pb->counts[0], pb->counts[1],
+                     unique_count, 0, 0, scratch_pool);
+
+  for (j = 0; j < 2; j++)
+    tail[j]->next = next[j];
+
+  for (; lcs; lcs = lcs->next)
+    patience_add_match(pb, lcs->position[0], lcs->position[1], lcs->length);
+}
+
+/* Compare the tokens in RANGE of PB, recording the common ones either in
+ * PB directly or as more work on STACK.  Use SCRATCH_POOL for temporaries
+ * that are not needed anymore upon return. */
+static void
+patience_process_range(patience_baton_t *pb,
+                       patience_work_t range,
+                       apr_array_header_t *stack,
+                       apr_pool_t *scratch_pool)
+{
+  svn_diff__position_t **positions0 = pb->positions[0];
+  svn_diff__position_t **positions1 = pb->positions[1];
+  apr_off_t *next_occurrence;
+  apr_off_t *anchors[2];
+  apr_off_t anchor_count = 0;
+  svn_diff__token_index_t min_count = PATIENCE_MAX_OCCURRENCES + 1;
+  apr_off_t length;
+  apr_off_t i;
+  int j;
+
+  /* Match the common start ... */
+  for (length = 0;
+       range.start[0] + length < range.end[0]
+       && range.start[1] + length < range.end[1]
+       && positions0[range.start[0] + length]->token_index
+          == positions1[range.start[1] + length]->token_index;
+       length++)
+    ;
+
+  if (length)
+    {
+      patience_add_match(pb, positions0[range.start[0]],
+                         positions1[range.start[1]], length);
+      range.start[0] += length;
+      range.start[1] += length;
+    }
+
+  /* ... and the common end, after everything else. */
+  for (length = 0;
+       range.end[0] - length > range.start[0]
+       && range.end[1] - length > range.start[1]
+       && positions0[range.end[0] - length - 1]->token_index
+          == positions1[range.end[1] - length - 1]->token_index;
+       length++)
+    ;
+
+  if (length)
+    {
+      patience_work_t *tail = apr_array_push(stack);
+
+      range.end[0] -= length;
+      range.end[1] -= length;
+
+      tail->start[0] = range.end[0];
+      tail->start[1] = range.end[1];
+      tail->end[0] = range.end[0] + length;
+      tail->end[1] = range.end[1] + length;
+      tail->is_match = TRUE;
+    }
+
+  /* Anything left is a pure insertion or deletion. */
+  if (range.start[0] == range.end[0] || range.start[1] == range.end[1])
+    return;
+
+  /* Count the occurrences of all tokens and chain the occurrences in the
+   * second range. */
+  for (i = range.start[0]; i < range.end[0]; i++)
+    pb->counts[0][positions0[i]->token_index]++;
+
+  next_occurrence = apr_palloc(scratch_pool,
+                               (range.end[1] - range.start[1])
+                               * sizeof(*next_occurrence));
+  for (i = range.end[1] - 1; i >= range.start[1]; i--)
+    {
+      svn_diff__token_index_t token_index = positions1[i]->token_index;
+
+      next_occurrence[i - range.start[1]]
+        = pb->counts[1][token_index] ? pb->cursor[token_index] : -1;
+      pb->cursor[token_index] = i;
+      pb->counts[1][token_index]++;
+    }
+
+  /* Find the rarest lines that occur equally often in both ranges. */
+  for (i = range.start[0]; i < range.end[0] && min_count > 1; i++)
+    {
+      svn_diff__token_index_t token_index = positions0[i]->token_index;
+      svn_diff__token_index_t count = pb->counts[0][token_index];
+
+      if (count < min_count && count == pb->counts[1][token_index])
+        min_count = count;
+    }
+
+  /* Pair their occurrences in order. */
+  if (min_count <= PATIENCE_MAX_OCCURRENCES)
+    {
+      apr_off_t max_anchors = MIN(range.end[0] - range.start[0],
+                                  range.end[1] - range.start[1]);
+
+      anchors[0] = apr_palloc(scratch_pool, max_anchors * sizeof(apr_off_t));
+      anchors[1] = apr_palloc(scratch_pool, max_anchors * sizeof(apr_off_t));
+
+      for (i = range.start[0]; i < range.end[0]; i++)
+        {
+          svn_diff__token_index_t token_index = positions0[i]->token_index;
+
+          if (pb->counts[0][token_index] == min_count
+              && pb->counts[1][token_index] == min_count)
+            {
+              apr_off_t other = pb->cursor[token_index];
+
+              anchors[0][anchor_count] = i;
+              anchors[1][anchor_count] = other;
+              anchor_count++;
+
+              pb->cursor[token_index]
+                = next_occurrence[other - range.start[1]];
+            }
+        }
+
+      patience_longest_sequence(anchors, &anchor_count, scratch_pool);
+    }
+  else
+    {
+      patience_fallback(pb, &range, scratch_pool);
+    }
+
+  /* Leave the counts clean for the next range. */
+  for (j = 0; j < 2; j++)
+    for (i = range.start[j]; i < range.end[j]; i++)
+      pb->counts[j][pb->positions[j][i]->token_index] = 0;
+
+  /* Queue the anchors and the gaps between them, last one first. */
+  if (anchor_count)
+    {
+      apr_off_t k;
+
+      for (k = anchor_count; k >= 0; k--)
+        {
+          patience_work_t *gap = apr_array_push(stack);
+
+          gap->start[0] = k ? anchors[0][k - 1] + 1 : range.start[0];
+          gap->start[1] = k ? anchors[1][k - 1] + 1 : range.start[1];
+          gap->end[0] = k < anchor_count ? anchors[0][k] : range.end[0];
+          gap->end[1] = k < anchor_count ? anchors[1][k] : range.end[1];
+          gap->is_match = FALSE;
+
+          if (k)
+            {
+              patience_work_t *anchor = apr_array_push(stack);
+
+              anchor->start[0] = anchors[0][k - 1];
+              anchor->start[1] = anchors[1][k - 1];
+              anchor->end[0] = anchor->start[0] + 1;
+              anchor->end[1] = anchor->start[1] + 1;
+              anchor->is_match = TRUE;
+            }
+        }
+    }
+}
+
+svn_diff__lcs_t *
+svn_diff__lcs_patience(svn_diff__position_t *position_list1,
+                       svn_diff__position_t *position_list2,
+                       svn_diff__token_index_t *token_counts_list1,
+                       svn_diff__token_index_t *token_counts_list2,
+                       svn_diff__token_index_t num_tokens,
+                       apr_off_t prefix_lines,
+                       apr_off_t suffix_lines,
+                       apr_pool_t *pool)
+{
+  patience_baton_t pb;
+  patience_work_t *range;
+  apr_array_header_t *stack;
+  apr_pool_t *iterpool;
+  svn_diff__position_t *list[2];
+  svn_diff__lcs_t *lcs;
+  apr_off_t length[2];
+  int i, j;
+
+  /* Nothing to compare. */
+  if (position_list1 == NULL || position_list2 == NULL)
+    return svn_diff__lcs(position_list1, position_list2, token_counts_list1,
+                         token_counts_list2, num_tokens, prefix_lines,
+                         suffix_lines, pool);
+
+  list[0] = position_list1;
+  list[1] = position_list2;
+  for (j = 0; j < 2; j++)
+    {
+      svn_diff__position_t *position = list[j]->next;
+      apr_off_t k;
+
+      length[j] = list[j]->offset - list[j]->next->offset + 1;
+      pb.positions[j] = apr_palloc(pool, length[j] * sizeof(position));
+      for (k = 0; k < length[j]; k++, position = position->next)
+        pb.positions[j][k] = position;
+
+      pb.counts[j] = apr_pcalloc(pool, num_tokens * sizeof(*pb.counts[j]));
+    }
+
+  pb.cursor = apr_palloc(pool, num_tokens * sizeof(*pb.cursor));
+  pb.matches = apr_array_make(pool, 16, sizeof(patience_match_t));
+
+  stack = apr_array_make(pool, 16, sizeof(patience_work_t));
+  range = apr_array_push(stack);
+  range->start[0] = 0;
+  range->start[1] = 0;
+  range->end[0] = length[0];
+  range->end[1] = length[1];
+  range->is_match = FALSE;
+
+  iterpool = svn_pool_create(pool);
+  while (stack->nelts)
+    {
+      patience_work_t work = *(patience_work_t *)apr_array_pop(stack);
+
+      svn_pool_clear(iterpool);
+
+      if (work.is_match)
+        patience_add_match(&pb, pb.positions[0][work.start[0]],
+                           pb.positions[1][work.start[1]],
+                           work.end[0] - work.start[0]);
+      else
+        patience_process_range(&pb, work, stack, iterpool);
+    }
+  svn_pool_destroy(iterpool);
+
+  /* Since EOF is always a sync point we tack on an EOF link
+   * with sentinel positions, just like svn_diff__lcs().
+   */
+  lcs = apr_palloc(pool, sizeof(*lcs));
+  lcs->position[0] = apr_pcalloc(pool, sizeof(*lcs->position[0]));
+  lcs->position[0]->offset = position_list1->offset + suffix_lines + 1;
+  lcs->position[1] = apr_pcalloc(pool, sizeof(*lcs->position[1]));
+  lcs->position[1]->offset = position_list2->offset + suffix_lines + 1;
+  lcs->length = 0;
+  lcs->refcount = 1;
+  lcs->next = NULL;
+
+  if (suffix_lines)
+    lcs = prepend_lcs(lcs, suffix_lines,
+                      lcs->position[0]->offset - suffix_lines,
+                      lcs->position[1]->offset - suffix_lines,
+                      pool);
+
+  for (i = pb.matches->nelts - 1; i >= 0; i--)
+    {
+      patience_match_t *match = &APR_ARRAY_IDX(pb.matches, i,
+                                               patience_match_t);
+      svn_diff__lcs_t *new_lcs = apr_palloc(pool, sizeof(*new_lcs));
+
+      new_lcs->position[0] = match->position[0];
+      new_lcs->position[1] = match->position[1];
+      new_lcs->length = match->length;
+      new_lcs->refcount = 1;
+      new_lcs->next = lcs;
+      lcs = new_lcs;
+    }
+
+  if (prefix_lines)
+    return prepend_lcs(lcs, prefix_lines, 1, 1, pool);
+  else
+    return lcs;
+}
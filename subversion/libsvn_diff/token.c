@@ -27,6 +27,7 @@
 #include <apr_general.h>
 
 #include "svn_error.h"
+#include "svn_pools.h"
 #include "svn_diff.h"
 #include "svn_types.h"
 
@@ -34,27 +35,35 @@
 
 
 /*
- * Prime number to use as the size of the hash table.  This number was
- * not selected by testing of any kind and may need tweaking.
+ * Initial number of slots in the hash table.  Must be a power of two.
  */
-#define SVN_DIFF__HASH_SIZE 127
+#define SVN_DIFF__INITIAL_SLOTS 256
 
-struct svn_diff__node_t
+/*
+ * The tree interns the tokens of all datasources: equal tokens get the
+ * same index.  It is an open-addressing hash table with linear probing,
+ * storing just the token index in each slot and the token data in arrays
+ * indexed by it.  That takes about 20 bytes per distinct token.
+ */
+struct svn_diff__tree_t
 {
-  svn_diff__node_t       *parent;
-  svn_diff__node_t       *left;
-  svn_diff__node_t       *right;
+  /* Token index + 1 for each used slot, 0 for empty ones.
+     SLOT_COUNT is a power of two. */
+  apr_uint32_t           *slots;
+  apr_size_t              slot_count;
 
-  apr_uint32_t            hash;
-  svn_diff__token_index_t index;
-  void                   *token;
-};
+  /* Hash value and latest token instance, indexed by token index.
+     Both have space for SLOT_COUNT / 2 entries. */
+  apr_uint32_t           *hashes;
+  void                  **tokens;
 
-struct svn_diff__tree_t
-{
-  svn_diff__node_t       *root[SVN_DIFF__HASH_SIZE];
-  apr_pool_t             *pool;
+  /* Number of distinct tokens, i.e. the next token index to use. */
   svn_diff__token_index_t node_count;
+
+  /* SLOTS, HASHES and TOKENS are allocated in TABLE_POOL, which is
+     a sub-pool of POOL that gets replaced whenever the table grows. */
+  apr_pool_t             *table_pool;
+  apr_pool_t             *pool;
 };
 
 
@@ -67,6 +76,49 @@ svn_diff__get_node_count(svn_diff__tree_t *tree)
   return tree->node_count;
 }
 
+/* Return the first slot to probe for HASH in TREE.  Adler32 checksums
+ * of short lines have poorly distributed low bits, so mix them first. */
+static APR_INLINE apr_size_t
+first_slot(const svn_diff__tree_t *tree, apr_uint32_t hash)
+{
+  hash *= 0x9e3779b1U;
+  return (apr_size_t)(hash ^ (hash >> 16)) & (tree->slot_count - 1);
+}
+
+/* Allocate the tables of TREE for SLOT_COUNT slots, copy the existing
+ * tokens over and release the previous tables. */
+static void
+tree_resize(svn_diff__tree_t *tree, apr_size_t slot_count)
+{
+  apr_pool_t *table_pool = svn_pool_create(tree->pool);
+  apr_uint32_t *hashes = apr_palloc(table_pool,
+                                    slot_count / 2 * sizeof(*hashes));
+  void **tokens = apr_palloc(table_pool, slot_count / 2 * sizeof(*tokens));
+  svn_diff__token_index_t i;
+
+  tree->slots = apr_pcalloc(table_pool, slot_count * sizeof(*tree->slots));
+  tree->slot_count = slot_count;
+
+  for (i = 0; i < tree->node_count; i++)
+    {
+      apr_size_t slot = first_slot(tree, tree->hashes[i]);
+
+      while (tree->slots[slot])
+        slot = (slot + 1) & (slot_count - 1);
+
+      tree->slots[slot] = (apr_uint32_t)(i + 1);
+      hashes[i] = tree->hashes[i];
+      tokens[i] = tree->tokens[i];
+    }
+
+  tree->hashes = hashes;
+  tree->tokens = tokens;
+
+  if (tree->table_pool)
+    svn_pool_destroy(tree->table_pool);
+  tree->table_pool = table_pool;
+}
+
 /*
  * Support functions to build a tree of token positions
  */
@@ -77,66 +129,62 @@ svn_diff__tree_create(svn_diff__tree_t **tree, apr_pool_t *pool)
   *tree = apr_pcalloc(pool, sizeof(**tree));
   (*tree)->pool = pool;
   (*tree)->node_count = 0;
+
+  tree_resize(*tree, SVN_DIFF__INITIAL_SLOTS);
 }
 
 
+/* Look up TOKEN with hash value HASH in TREE, add it if it is new, and
+ * return its token index in *INDEX. */
 static svn_error_t *
-tree_insert_token(svn_diff__node_t **node, svn_diff__tree_t *tree,
+tree_insert_token(svn_diff__token_index_t *index, svn_diff__tree_t *tree,
                   void *diff_baton,
                   const svn_diff_fns2_t *vtable,
                   apr_uint32_t hash, void *token)
 {
-  svn_diff__node_t *new_node;
-  svn_diff__node_t **node_ref;
-  svn_diff__node_t *parent;
+  apr_size_t slot;
   int rv;
 
   SVN_ERR_ASSERT(token);
 
-  parent = NULL;
-  node_ref = &tree->root[hash % SVN_DIFF__HASH_SIZE];
+  /* Keep the load factor at or below 1/2.  This also guarantees that
+   * there is space for a new entry in the token arrays. */
+  if (tree->node_count >= (svn_diff__token_index_t)(tree->slot_count / 2))
+    {
+      SVN_ERR_ASSERT(tree->slot_count < APR_UINT32_MAX / 2);
+      tree_resize(tree, tree->slot_count * 2);
+    }
 
-  while (*node_ref != NULL)
+  for (slot = first_slot(tree, hash);
+       tree->slots[slot];
+       slot = (slot + 1) & (tree->slot_count - 1))
     {
-      parent = *node_ref;
+      svn_diff__token_index_t i = tree->slots[slot] - 1;
 
-      rv = hash - parent->hash;
-      if (!rv)
-        SVN_ERR(vtable->token_compare(diff_baton, parent->token, token, &rv));
+      if (tree->hashes[i] != hash)
+        continue;
 
+      SVN_ERR(vtable->token_compare(diff_baton, tree->tokens[i], token, &rv));
       if (rv == 0)
         {
           /* Discard the previous token.  This helps in cases where
            * only recently read tokens are still in memory.
            */
           if (vtable->token_discard != NULL)
-            vtable->token_discard(diff_baton, parent->token);
+            vtable->token_discard(diff_baton, tree->tokens[i]);
 
-          parent->token = token;
-          *node = parent;
+          tree->tokens[i] = token;
+          *index = i;
 
           return SVN_NO_ERROR;
         }
-      else if (rv > 0)
-        {
-          node_ref = &parent->left;
-        }
-      else
-        {
-          node_ref = &parent->right;
-        }
     }
 
-  /* Create a new node */
-  new_node = apr_palloc(tree->pool, sizeof(*new_node));
-  new_node->parent = parent;
-  new_node->left = NULL;
-  new_node->right = NULL;
-  new_node->hash = hash;
-  new_node->token = token;
-  new_node->index = tree->node_count++;
-
-  *node = *node_ref = new_node;
+  /* Add a new entry */
+  *index = tree->node_count++;
+  tree->slots[slot] = (apr_uint32_t)tree->node_count;
+  tree->hashes[*index] = hash;
+  tree->tokens[*index] = token;
 
   return SVN_NO_ERROR;
 }
@@ -158,7 +206,7 @@ svn_diff__get_tokens(svn_diff__position_t **position_list,
   svn_diff__position_t *start_position;
   svn_diff__position_t *position = NULL;
   svn_diff__position_t **position_ref;
-  svn_diff__node_t *node;
+  svn_diff__token_index_t token_index;
   void *token;
   apr_off_t offset;
   apr_uint32_t hash;
@@ -176,12 +224,13 @@ svn_diff__get_tokens(svn_diff__position_t **position_list,
         break;
 
       offset++;
-      SVN_ERR(tree_insert_token(&node, tree, diff_baton, vtable, hash, token));
+      SVN_ERR(tree_insert_token(&token_index, tree, diff_baton, vtable,
+                                hash, token));
 
       /* Create a new position */
       position = apr_palloc(pool, sizeof(*position));
       position->next = NULL;
-      position->token_index = node->index;
+      position->token_index = token_index;
       position->offset = offset;
 
       *position_ref = position;
@@ -0,0 +1,367 @@
+/*
+ * cache-snapshot.c:  Persist the global membuffer cache across restarts
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include <string.h>
+
+#include <apr_pools.h>
+#include <apr_hash.h>
+#include <apr_strings.h>
+
+#include "svn_types.h"
+#include "svn_error.h"
+#include "svn_dirent_uri.h"
+#include "svn_hash.h"
+#include "svn_io.h"
+#include "svn_pools.h"
+#include "svn_fs.h"
+#include "svn_props.h"
+
+#include "svn_private_config.h"
+
+#include "private/svn_cache.h"
+#include "private/svn_fs_private.h"
+#include "private/svn_fs_util.h"
+
+/* A snapshot file starts with a hash in svn_hash_write2() format that
+ * maps each cache key prefix to its "stamp", followed by the contents of
+ * the membuffer cache as written by svn_cache__membuffer_save().
+ *
+ * The stamp identifies the repository contents at the time the snapshot
+ * was taken:  "<youngest rev> <uuid> <svn:date of youngest> <fs path>".
+ * Since revisions are immutable, everything cached for that repository
+ * remains valid as long as the repository at FS_PATH still has the same
+ * UUID and revision YOUNGEST still has the same date.  A repository that
+ * got replaced by a different copy, e.g. restored from a backup with a
+ * lower youngest revision and new commits on top, fails that test.
+ */
+
+/* Parsed form of a stamp, see above. */
+typedef struct stamp_t
+{
+  const char *fs_path;
+  const char *uuid;
+  svn_revnum_t youngest;
+  const char *date;
+} stamp_t;
+
+/* Set *STAMP to the current stamp of the repository filesystem at
+ * FS_PATH, allocated in RESULT_POOL.  Use SCRATCH_POOL for temporary
+ * allocations.
+ */
+static svn_error_t *
+read_stamp(stamp_t **stamp,
+           const char *fs_path,
+           apr_pool_t *result_pool,
+           apr_pool_t *scratch_pool)
+{
+  svn_fs_t *fs;
+  svn_string_t *date;
+  stamp_t *result = apr_pcalloc(result_pool, sizeof(*result));
+
+  SVN_ERR(svn_fs_open2(&fs, fs_path, NULL, scratch_pool, scratch_pool));
+  SVN_ERR(svn_fs_get_uuid(fs, &result->uuid, result_pool));
+  SVN_ERR(svn_fs_youngest_rev(&result->youngest, fs, scratch_pool));
+  SVN_ERR(svn_fs_revision_prop2(&date, fs, result->youngest,
+                                SVN_PROP_REVISION_DATE, FALSE,
+                                scratch_pool, scratch_pool));
+
+  result->fs_path = apr_pstrdup(result_pool, fs_path);
+  result->date = date ? apr_pstrmemdup(result_pool, date->data, date->len)
+                      : "";
+  *stamp = result;
+
+  return SVN_NO_ERROR;
+}
+
+/* Return the textual representation of STAMP, allocated in RESULT_POOL.
+ */
+static svn_string_t *
+unparse_stamp(const stamp_t *stamp,
+              apr_pool_t *result_pool)
+{
+  return svn_string_createf(result_pool, "%ld %s %s %s",
+                            stamp->youngest, stamp->uuid,
+                            *stamp->date ? stamp->date : "-",
+                            stamp->fs_path);
+}
+
+/* Parse the textual representation TEXT of a stamp into *STAMP,
+ * allocated in RESULT_POOL.
+ */
+static svn_error_t *
+parse_stamp(stamp_t **stamp,
+            const svn_string_t *text,
+            apr_pool_t *result_pool)
+{
+  stamp_t *result = apr_pcalloc(result_pool, sizeof(*result));
+  char *data = apr_pstrmemdup(result_pool, text->data, text->len);
+  char *uuid, *date, *fs_path;
+  apr_int64_t youngest;
+
+  uuid = strchr(data, ' ');
+  date = uuid ? strchr(uuid + 1, ' ') : NULL;
+  fs_path = date ? strchr(date + 1, ' ') : NULL;
+  if (!fs_path)
+    return svn_error_create(SVN_ERR_MALFORMED_FILE, NULL,
+                            _("Corrupt cache snapshot header"));
+
+  *uuid++ = '\0';
+  *date++ = '\0';
+  *fs_path++ = '\0';
+
+  SVN_ERR(svn_cstring_atoi64(&youngest, data));
+  result->youngest = (svn_revnum_t)youngest;
+  result->uuid = uuid;
+  result->date = strcmp(date, "-") ? date : "";
+  result->fs_path = fs_path;
+  *stamp = result;
+
+  return SVN_NO_ERROR;
+}
+
+/* Return whether STAMP still describes the contents of its repository.
+ * Use SCRATCH_POOL for temporary allocations.
+ */
+static svn_boolean_t
+stamp_is_valid(const stamp_t *stamp,
+               apr_pool_t *scratch_pool)
+{
+  svn_fs_t *fs;
+  const char *uuid;
+  svn_revnum_t youngest;
+  svn_string_t *date;
+  svn_error_t *err;
+
+  err = svn_fs_open2(&fs, stamp->fs_path, NULL, scratch_pool, scratch_pool);
+  if (!err)
+    err = svn_fs_get_uuid(fs, &uuid, scratch_pool);
+  if (!err)
+    err = svn_fs_youngest_rev(&youngest, fs, scratch_pool);
+  if (!err && youngest < stamp->youngest)
+    return FALSE;
+  if (!err)
+    err = svn_fs_revision_prop2(&date, fs, stamp->youngest,
+                                SVN_PROP_REVISION_DATE, FALSE,
+                                scratch_pool, scratch_pool);
+
+  /* Repositories that we can't read anymore are simply dropped. */
+  if (err)
+    {
+      svn_error_clear(err);
+      return FALSE;
+    }
+
+  return strcmp(uuid, stamp->uuid) == 0
+      && strcmp(date ? date->data : "", stamp->date) == 0;
+}
+
+/* Baton for the filter functions below. */
+typedef struct filter_baton_t
+{
+  /* Accepted cache key prefixes (const char *). */
+  apr_array_header_t *prefixes;
+} filter_baton_t;
+
+/* Implements svn_cache__prefix_filter_t.  Accept all cache prefixes that
+ * start with one of the prefixes in the filter_baton_t BATON.
+ */
+static svn_error_t *
+filter_prefix(svn_boolean_t *keep,
+              void *baton,
+              const char *prefix,
+              apr_pool_t *scratch_pool)
+{
+  filter_baton_t *fb = baton;
+  int i;
+
+  *keep = FALSE;
+  for (i = 0; i < fb->prefixes->nelts && !*keep; ++i)
+    {
+      const char *accepted = APR_ARRAY_IDX(fb->prefixes, i, const char *);
+      *keep = strncmp(prefix, accepted, strlen(accepted)) == 0;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Write the stamps of all registered cache prefixes and the contents of
+ * MEMBUFFER to STREAM.  Use SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+write_snapshot(svn_stream_t *stream,
+               svn_membuffer_t *membuffer,
+               apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  apr_hash_t *registered;
+  apr_hash_t *stamps = apr_hash_make(scratch_pool);
+  apr_hash_t *by_path = apr_hash_make(scratch_pool);
+  apr_hash_index_t *hi;
+  filter_baton_t fb;
+
+  fb.prefixes = apr_array_make(scratch_pool, 4, sizeof(const char *));
+
+  SVN_ERR(svn_fs__get_cache_prefixes(&registered, scratch_pool));
+  for (hi = apr_hash_first(scratch_pool, registered);
+       hi;
+       hi = apr_hash_next(hi))
+    {
+      const char *prefix = apr_hash_this_key(hi);
+      const char *fs_path = apr_hash_this_val(hi);
+      stamp_t *stamp = svn_hash_gets(by_path, fs_path);
+      svn_error_t *err = SVN_NO_ERROR;
+
+      svn_pool_clear(iterpool);
+
+      /* Skip repositories that have been removed in the meantime. */
+      if (!stamp)
+        err = read_stamp(&stamp, fs_path, scratch_pool, iterpool);
+      if (err)
+        {
+          svn_error_clear(err);
+          continue;
+        }
+
+      svn_hash_sets(by_path, fs_path, stamp);
+      svn_hash_sets(stamps, prefix, unparse_stamp(stamp, scratch_pool));
+      APR_ARRAY_PUSH(fb.prefixes, const char *) = prefix;
+    }
+
+  svn_pool_destroy(iterpool);
+
+  SVN_ERR(svn_hash_write2(stamps, stream, SVN_HASH_TERMINATOR,
+                          scratch_pool));
+  SVN_ERR(svn_cache__membuffer_save(membuffer, stream, filter_prefix, &fb,
+                                    scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_fs__save_cache_snapshot(const char *path,
+                            apr_pool_t *scratch_pool)
+{
+  svn_membuffer_t *membuffer = svn_cache__get_global_membuffer_cache();
+  svn_stream_t *stream;
+  const char *tmp_path;
+  svn_error_t *err;
+
+  if (!membuffer)
+    return SVN_NO_ERROR;
+
+  /* Readers must never see a partially written snapshot. */
+  SVN_ERR(svn_stream_open_unique(&stream, &tmp_path,
+                                 svn_dirent_dirname(path, scratch_pool),
+                                 svn_io_file_del_none,
+                                 scratch_pool, scratch_pool));
+
+  err = write_snapshot(stream, membuffer, scratch_pool);
+  err = svn_error_compose_create(err, svn_stream_close(stream));
+  if (!err)
+    err = svn_io_file_rename2(tmp_path, path, FALSE, scratch_pool);
+
+  if (err)
+    return svn_error_compose_create(err,
+                                    svn_io_remove_file2(tmp_path, TRUE,
+                                                        scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Read the snapshot from STREAM into MEMBUFFER.  Use SCRATCH_POOL for
+ * temporary allocations.
+ */
+static svn_error_t *
+read_snapshot(svn_stream_t *stream,
+              svn_membuffer_t *membuffer,
+              apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  apr_hash_t *stamps = apr_hash_make(scratch_pool);
+  apr_hash_t *checked = apr_hash_make(scratch_pool);
+  apr_hash_index_t *hi;
+  filter_baton_t fb;
+
+  fb.prefixes = apr_array_make(scratch_pool, 4, sizeof(const char *));
+
+  SVN_ERR(svn_hash_read2(stamps, stream, SVN_HASH_TERMINATOR,
+                         scratch_pool));
+  for (hi = apr_hash_first(scratch_pool, stamps); hi; hi = apr_hash_next(hi))
+    {
+      const char *prefix = apr_hash_this_key(hi);
+      const svn_string_t *text = apr_hash_this_val(hi);
+      const char *valid;
+      stamp_t *stamp;
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(parse_stamp(&stamp, text, scratch_pool));
+
+      /* All prefixes of the same repository share the same stamp. */
+      valid = svn_hash_gets(checked, text->data);
+      if (!valid)
+        {
+          valid = stamp_is_valid(stamp, iterpool) ? "y" : "n";
+          svn_hash_sets(checked, text->data, valid);
+        }
+      if (*valid == 'n')
+        continue;
+
+      SVN_ERR(svn_fs__register_cache_prefix(prefix, stamp->fs_path,
+                                            iterpool));
+      APR_ARRAY_PUSH(fb.prefixes, const char *) = prefix;
+    }
+
+  svn_pool_destroy(iterpool);
+
+  /* Nothing left to restore? */
+  if (fb.prefixes->nelts == 0)
+    return SVN_NO_ERROR;
+
+  return svn_error_trace(svn_cache__membuffer_load(membuffer, stream,
+                                                   filter_prefix, &fb,
+                                                   scratch_pool));
+}
+
+svn_error_t *
+svn_fs__load_cache_snapshot(const char *path,
+                            apr_pool_t *scratch_pool)
+{
+  svn_membuffer_t *membuffer = svn_cache__get_global_membuffer_cache();
+  svn_stream_t *stream;
+  svn_error_t *err;
+
+  if (!membuffer)
+    return SVN_NO_ERROR;
+
+  err = svn_stream_open_readonly(&stream, path, scratch_pool, scratch_pool);
+  if (err && APR_STATUS_IS_ENOENT(err->apr_err))
+    {
+      svn_error_clear(err);
+      return SVN_NO_ERROR;
+    }
+  SVN_ERR(err);
+
+  err = read_snapshot(stream, membuffer, scratch_pool);
+
+  return svn_error_compose_create(err, svn_stream_close(stream));
+}
@@ -504,6 +504,10 @@ fs_new(apr_hash_t *fs_config, apr_pool_t *pool)
   fs->vtable = NULL;
   fs->fsap_data = NULL;
   fs->uuid = NULL;
+  fs->io_trace = NULL;
+  fs->commit_timing.func = NULL;
+  fs->commit_timing.baton = NULL;
+  fs->bulk_scan = FALSE;
   return fs;
 }
 
@@ -521,6 +525,87 @@ svn_fs_set_warning_func(svn_fs_t *fs, svn_fs_warning_callback_t warning,
   fs->warning_baton = warning_baton;
 }
 
+/* Pool cleanup function stopping the I/O tracing of the svn_fs_t BATON.
+   svn_fs__io_trace_stop() unregisters it, so it always belongs to the
+   current tracing state. */
+static apr_status_t
+io_trace_cleanup(void *baton)
+{
+  svn_fs_t *fs = baton;
+  fs->io_trace = NULL;
+
+  return APR_SUCCESS;
+}
+
+svn_error_t *
+svn_fs__io_trace_start(svn_fs_t *fs,
+                       svn_stream_t *events,
+                       apr_pool_t *pool)
+{
+  svn_fs__io_trace_stop(fs);
+
+  fs->io_trace = apr_pcalloc(pool, sizeof(*fs->io_trace));
+  fs->io_trace->events = events;
+  fs->io_trace->pool = pool;
+  apr_pool_cleanup_register(pool, fs, io_trace_cleanup,
+                            apr_pool_cleanup_null);
+
+  return SVN_NO_ERROR;
+}
+
+void
+svn_fs__io_trace_stop(svn_fs_t *fs)
+{
+  if (fs->io_trace)
+    {
+      apr_pool_cleanup_kill(fs->io_trace->pool, fs, io_trace_cleanup);
+      fs->io_trace = NULL;
+    }
+}
+
+const svn_fs__io_stats_t *
+svn_fs__io_trace_stats(svn_fs_t *fs)
+{
+  return fs->io_trace ? &fs->io_trace->stats : NULL;
+}
+
+void
+svn_fs__set_commit_timing_func(svn_fs_t *fs,
+                               svn_fs__commit_timing_func_t func,
+                               void *baton)
+{
+  fs->commit_timing.func = func;
+  fs->commit_timing.baton = baton;
+}
+
+apr_time_t
+svn_fs__commit_timing_start(svn_fs_t *fs)
+{
+  return svn_fs__timing_start(&fs->commit_timing);
+}
+
+void
+svn_fs__commit_timing_phase(svn_fs_t *fs,
+                            const char *phase,
+                            apr_time_t start,
+                            apr_pool_t *scratch_pool)
+{
+  svn_fs__timing_phase(&fs->commit_timing, phase, start, scratch_pool);
+}
+
+void
+svn_fs__set_bulk_scan(svn_fs_t *fs,
+                      svn_boolean_t bulk_scan)
+{
+  fs->bulk_scan = bulk_scan;
+}
+
+svn_boolean_t
+svn_fs__is_bulk_scan(svn_fs_t *fs)
+{
+  return fs->bulk_scan;
+}
+
 svn_error_t *
 svn_fs_create2(svn_fs_t **fs_p,
                const char *path,
@@ -1216,6 +1301,51 @@ svn_fs_paths_changed3(svn_fs_path_change_iterator_t **iterator,
   return SVN_NO_ERROR;
 }
 
+svn_error_t *
+svn_fs_paths_changed_range(svn_fs_t *fs,
+                           svn_revnum_t start,
+                           svn_revnum_t end,
+                           svn_fs_paths_changed_receiver_t receiver,
+                           void *receiver_baton,
+                           svn_cancel_func_t cancel_func,
+                           void *cancel_baton,
+                           apr_pool_t *scratch_pool)
+{
+  svn_revnum_t rev;
+  apr_pool_t *iterpool;
+
+  if (fs->vtable->paths_changed_range)
+    return svn_error_trace(fs->vtable->paths_changed_range(fs, start, end,
+                                                           receiver,
+                                                           receiver_baton,
+                                                           cancel_func,
+                                                           cancel_baton,
+                                                           scratch_pool));
+
+  /* Emulate it on top of revision roots. */
+  iterpool = svn_pool_create(scratch_pool);
+  for (rev = start; ; rev += (start <= end) ? 1 : -1)
+    {
+      svn_fs_root_t *root;
+      svn_fs_path_change_iterator_t *iterator;
+
+      svn_pool_clear(iterpool);
+      if (cancel_func)
+        SVN_ERR(cancel_func(cancel_baton));
+
+      SVN_ERR(svn_fs_revision_root(&root, fs, rev, iterpool));
+      SVN_ERR(svn_fs_paths_changed3(&iterator, root, iterpool, iterpool));
+      SVN_ERR(receiver(receiver_baton, rev, iterator, iterpool));
+
+      if (rev == end)
+        break;
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *
 svn_fs_check_path(svn_node_kind_t *kind_p, svn_fs_root_t *root,
                   const char *path, apr_pool_t *pool)
@@ -1223,6 +1353,54 @@ svn_fs_check_path(svn_node_kind_t *kind_p, svn_fs_root_t *root,
   return svn_error_trace(root->vtable->check_path(kind_p, root, path, pool));
 }
 
+svn_error_t *
+svn_fs_stat_paths(apr_array_header_t **stats,
+                  svn_fs_root_t *root,
+                  const apr_array_header_t *paths,
+                  apr_pool_t *result_pool,
+                  apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool;
+  int i;
+
+  if (root->vtable->stat_paths)
+    return svn_error_trace(root->vtable->stat_paths(stats, root, paths,
+                                                    result_pool,
+                                                    scratch_pool));
+
+  /* Fallback: Look up each path individually. */
+  *stats = apr_array_make(result_pool, paths->nelts,
+                          sizeof(svn_fs_path_stat_t *));
+  iterpool = svn_pool_create(scratch_pool);
+  for (i = 0; i < paths->nelts; ++i)
+    {
+      const char *path = APR_ARRAY_IDX(paths, i, const char *);
+      svn_fs_path_stat_t *stat = apr_pcalloc(result_pool, sizeof(*stat));
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(root->vtable->check_path(&stat->kind, root, path, iterpool));
+      if (stat->kind != svn_node_none)
+        {
+          if (stat->kind == svn_node_file)
+            SVN_ERR(root->vtable->file_length(&stat->size, root, path,
+                                              iterpool));
+          else
+            stat->size = SVN_INVALID_FILESIZE;
+
+          SVN_ERR(root->vtable->node_has_props(&stat->has_props, root, path,
+                                               iterpool));
+          SVN_ERR(root->vtable->node_created_rev(&stat->created_rev, root,
+                                                 path, iterpool));
+        }
+
+      APR_ARRAY_PUSH(*stats, svn_fs_path_stat_t *) = stat;
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *
 svn_fs_node_history2(svn_fs_history_t **history_p, svn_fs_root_t *root,
                      const char *path, apr_pool_t *result_pool,
@@ -1611,6 +1789,27 @@ svn_fs_apply_text(svn_stream_t **contents_p, svn_fs_root_t *root,
                                                   result, pool));
 }
 
+svn_error_t *
+svn_fs_apply_text_by_checksum(svn_boolean_t *applied,
+                              svn_fs_root_t *root,
+                              const char *path,
+                              const svn_checksum_t *sha1_checksum,
+                              apr_pool_t *pool)
+{
+  if (!root->vtable->apply_text_by_checksum
+      || sha1_checksum == NULL
+      || sha1_checksum->kind != svn_checksum_sha1)
+    {
+      *applied = FALSE;
+      return SVN_NO_ERROR;
+    }
+
+  return svn_error_trace(root->vtable->apply_text_by_checksum(applied, root,
+                                                              path,
+                                                              sha1_checksum,
+                                                              pool));
+}
+
 svn_error_t *
 svn_fs_contents_different(svn_boolean_t *changed_p, svn_fs_root_t *root1,
                           const char *path1, svn_fs_root_t *root2,
@@ -1728,6 +1927,86 @@ svn_fs_get_file_delta_stream(svn_txdelta_stream_t **stream_p,
                            target_root, target_path, pool));
 }
 
+svn_error_t *
+svn_fs__get_stored_delta(svn_stream_t **svndiff_p,
+                         svn_filesize_t *len_p,
+                         svn_fs_root_t *source_root,
+                         const char *source_path,
+                         svn_fs_root_t *target_root,
+                         const char *target_path,
+                         int max_version,
+                         apr_pool_t *result_pool,
+                         apr_pool_t *scratch_pool)
+{
+  *svndiff_p = NULL;
+
+  /* Deltas can only refer to representations within the same FS. */
+  if (   !target_root->vtable->get_stored_delta
+      || source_root->fs != target_root->fs)
+    return SVN_NO_ERROR;
+
+  return svn_error_trace(target_root->vtable->get_stored_delta(
+                           svndiff_p, len_p, source_root, source_path,
+                           target_root, target_path, max_version,
+                           result_pool, scratch_pool));
+}
+
+svn_error_t *
+svn_fs__copy_revisions(svn_fs_t *dst_fs,
+                       svn_fs_t *src_fs,
+                       svn_revnum_t end_rev,
+                       svn_fs_hotcopy_notify_t notify_func,
+                       void *notify_baton,
+                       svn_cancel_func_t cancel_func,
+                       void *cancel_baton,
+                       apr_pool_t *scratch_pool)
+{
+  /* Revision data can only be shared within the same backend. */
+  if (   !dst_fs->vtable->copy_revisions
+      || dst_fs->vtable != src_fs->vtable)
+    return svn_error_create(SVN_ERR_UNSUPPORTED_FEATURE, NULL,
+                            _("Revisions can't be copied between these "
+                              "filesystems"));
+
+  return svn_error_trace(dst_fs->vtable->copy_revisions(dst_fs, src_fs,
+                                                        end_rev,
+                                                        notify_func,
+                                                        notify_baton,
+                                                        cancel_func,
+                                                        cancel_baton,
+                                                        scratch_pool));
+}
+
+svn_error_t *
+svn_fs__get_verified_revisions(apr_array_header_t **revisions,
+                               svn_fs_t *fs,
+                               svn_revnum_t start,
+                               svn_revnum_t end,
+                               apr_pool_t *result_pool,
+                               apr_pool_t *scratch_pool)
+{
+  if (!fs->vtable->get_verified_revisions)
+    {
+      *revisions = apr_array_make(result_pool, 0, sizeof(svn_revnum_t));
+      return SVN_NO_ERROR;
+    }
+
+  return svn_error_trace(fs->vtable->get_verified_revisions(revisions, fs,
+                                                            start, end,
+                                                            result_pool,
+                                                            scratch_pool));
+}
+
+svn_error_t *
+svn_fs__flush_txn(svn_fs_txn_t *txn,
+                  apr_pool_t *scratch_pool)
+{
+  if (!txn->vtable->flush)
+    return SVN_NO_ERROR;
+
+  return svn_error_trace(txn->vtable->flush(txn, scratch_pool));
+}
+
 svn_error_t *
 svn_fs__get_deleted_node(svn_fs_root_t **node_root,
                          const char **node_path,
@@ -29,6 +29,7 @@
 #include "svn_fs.h"
 #include "svn_props.h"
 #include "private/svn_mutex.h"
+#include "private/svn_fs_private.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -266,6 +267,31 @@ typedef struct fs_vtable_t
   svn_error_t *(*bdb_set_errcall)(svn_fs_t *fs,
                                   void (*handler)(const char *errpfx,
                                                   char *msg));
+  /* May be NULL, in which case the loader falls back to revision roots. */
+  svn_error_t *(*paths_changed_range)(svn_fs_t *fs,
+                                      svn_revnum_t start,
+                                      svn_revnum_t end,
+                                      svn_fs_paths_changed_receiver_t receiver,
+                                      void *receiver_baton,
+                                      svn_cancel_func_t cancel_func,
+                                      void *cancel_baton,
+                                      apr_pool_t *scratch_pool);
+  /* May be NULL if the backend can't share revision data. */
+  svn_error_t *(*copy_revisions)(svn_fs_t *dst_fs,
+                                 svn_fs_t *src_fs,
+                                 svn_revnum_t end_rev,
+                                 svn_fs_hotcopy_notify_t notify_func,
+                                 void *notify_baton,
+                                 svn_cancel_func_t cancel_func,
+                                 void *cancel_baton,
+                                 apr_pool_t *scratch_pool);
+  /* May be NULL if the backend doesn't verify revisions after commit. */
+  svn_error_t *(*get_verified_revisions)(apr_array_header_t **revisions,
+                                         svn_fs_t *fs,
+                                         svn_revnum_t start,
+                                         svn_revnum_t end,
+                                         apr_pool_t *result_pool,
+                                         apr_pool_t *scratch_pool);
 } fs_vtable_t;
 
 
@@ -284,6 +310,8 @@ typedef struct txn_vtable_t
                        apr_pool_t *pool);
   svn_error_t *(*change_props)(svn_fs_txn_t *txn, const apr_array_header_t *props,
                                apr_pool_t *pool);
+  /* May be NULL if the backend always keeps transactions on disk. */
+  svn_error_t *(*flush)(svn_fs_txn_t *txn, apr_pool_t *scratch_pool);
 } txn_vtable_t;
 
 
@@ -427,6 +455,32 @@ typedef struct root_vtable_t
                                 svn_fs_mergeinfo_receiver_t receiver,
                                 void *baton,
                                 apr_pool_t *scratch_pool);
+
+  /* Optional; NULL if the backend cannot share existing texts this way. */
+  svn_error_t *(*apply_text_by_checksum)(svn_boolean_t *applied,
+                                         svn_fs_root_t *root,
+                                         const char *path,
+                                         const svn_checksum_t *sha1_checksum,
+                                         apr_pool_t *pool);
+
+  /* Optional; NULL if the backend has no better way to do it than
+     looking up the paths one-by-one. */
+  svn_error_t *(*stat_paths)(apr_array_header_t **stats,
+                             svn_fs_root_t *root,
+                             const apr_array_header_t *paths,
+                             apr_pool_t *result_pool,
+                             apr_pool_t *scratch_pool);
+
+  /* Optional; NULL if the backend does not store svndiff data. */
+  svn_error_t *(*get_stored_delta)(svn_stream_t **svndiff_p,
+                                   svn_filesize_t *len_p,
+                                   svn_fs_root_t *source_root,
+                                   const char *source_path,
+                                   svn_fs_root_t *target_root,
+                                   const char *target_path,
+                                   int max_version,
+                                   apr_pool_t *result_pool,
+                                   apr_pool_t *scratch_pool);
 } root_vtable_t;
 
 
@@ -466,6 +520,30 @@ typedef struct id_vtable_t
 /* Set to "0" at the start of the txn, to "1" when svn:date changes. */
 #define SVN_FS__PROP_TXN_CLIENT_DATE           SVN_PROP_PREFIX "client-date"
 
+/* I/O tracing state of a filesystem object, see svn_fs__io_trace_start().
+   Backends update it through svn_fs__io_trace_item(). */
+struct svn_fs__io_trace_t
+{
+  /* The counters reported to the user. */
+  svn_fs__io_stats_t stats;
+
+  /* Receives a line per item access.  May be NULL. */
+  svn_stream_t *events;
+
+  /* The pool this structure lives in.  Clearing it stops the tracing. */
+  apr_pool_t *pool;
+};
+
+/* Commit timing reporting of a filesystem object, see
+   svn_fs__set_commit_timing_func().  Backends report through
+   svn_fs__timing_phase(). */
+struct svn_fs__commit_timing_t
+{
+  /* The receiver of the phases.  NULL if disabled. */
+  svn_fs__commit_timing_func_t func;
+  void *baton;
+};
+
 struct svn_fs_t
 {
   /* The pool in which this fs object is allocated */
@@ -490,6 +568,15 @@ struct svn_fs_t
 
   /* UUID, stored by open(), create(), and set_uuid(). */
   const char *uuid;
+
+  /* I/O tracing state.  NULL while not tracing. */
+  struct svn_fs__io_trace_t *io_trace;
+
+  /* Commit timing reporting.  Disabled by default. */
+  struct svn_fs__commit_timing_t commit_timing;
+
+  /* Set while reading data in bulk, see svn_fs__set_bulk_scan(). */
+  svn_boolean_t bulk_scan;
 };
 
 
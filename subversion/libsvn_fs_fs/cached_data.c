@@ -26,9 +26,12 @@
 
 #include "svn_hash.h"
 #include "svn_ctype.h"
+#include "svn_props.h"
 #include "svn_sorts.h"
 #include "private/svn_delta_private.h"
+#include "private/svn_fs_util.h"
 #include "private/svn_io_private.h"
+#include "private/svn_metrics.h"
 #include "private/svn_sorts_private.h"
 #include "private/svn_subr_private.h"
 #include "private/svn_temp_serializer.h"
@@ -38,6 +41,7 @@
 #include "index.h"
 #include "low_level.h"
 #include "pack.h"
+#include "transaction.h"
 #include "util.h"
 #include "temp_serializer.h"
 
@@ -57,6 +61,20 @@ block_read(void **result,
            apr_pool_t *scratch_pool);
 
 
+/* Return the name of ITEM_TYPE (SVN_FS_FS__ITEM_TYPE_*) as reported by
+ * the I/O tracing.
+ */
+static const char *
+trace_item_type(apr_uint32_t item_type)
+{
+  static const char *types[] = {"unused", "frep", "drep", "fprop", "dprop",
+                                "noderev", "changes", "rep"};
+
+  return item_type < sizeof(types) / sizeof(types[0])
+       ? types[item_type]
+       : "unknown";
+}
+
 /* Define this to enable access logging via dbg_log_access
 #define SVN_FS_FS__LOG_ACCESS
  */
@@ -133,6 +151,10 @@ dbg_log_access(svn_fs_t *fs,
         description = "  PLAIN";
       else if (header->type == svn_fs_fs__rep_self_delta)
         description = "  DELTA";
+      else if (header->type == svn_fs_fs__rep_chunked)
+        description = "  CHUNKED";
+      else if (header->type == svn_fs_fs__rep_dir_index)
+        description = "  DIRINDEX";
       else
         description = apr_psprintf(scratch_pool,
                                    "  DELTA against %ld/%" APR_UINT64_T_FMT,
@@ -417,28 +439,42 @@ get_node_revision_body(node_revision_t **noderev_p,
   if (svn_fs_fs__id_is_txn(id))
     {
       apr_file_t *file;
+      svn_stringbuf_t *contents;
+      svn_boolean_t staged;
+      svn_stream_t *stream;
+      const char *path = svn_fs_fs__path_txn_node_rev(fs, id, scratch_pool);
 
       /* This is a transaction node-rev.  Its storage logic is very
-         different from that of rev / pack files. */
-      err = svn_io_file_open(&file,
-                             svn_fs_fs__path_txn_node_rev(fs, id,
-                             scratch_pool),
-                             APR_READ | APR_BUFFERED, APR_OS_DEFAULT,
-                             scratch_pool);
-      if (err && APR_STATUS_IS_ENOENT(err->apr_err))
+         different from that of rev / pack files.  Small transactions
+         may still be kept in memory. */
+      SVN_ERR(svn_fs_fs__read_staged_txn_file(&staged, &contents, fs,
+                                              svn_fs_fs__id_txn_id(id),
+                                              path, scratch_pool));
+      if (staged)
         {
-          svn_error_clear(err);
-          return svn_error_trace(err_dangling_id(fs, id));
+          if (!contents)
+            return svn_error_trace(err_dangling_id(fs, id));
+
+          stream = svn_stream_from_stringbuf(contents, scratch_pool);
         }
-      else if (err)
+      else
         {
-          return svn_error_trace(err);
+          err = svn_io_file_open(&file, path, APR_READ | APR_BUFFERED,
+                                 APR_OS_DEFAULT, scratch_pool);
+          if (err && APR_STATUS_IS_ENOENT(err->apr_err))
+            {
+              svn_error_clear(err);
+              return svn_error_trace(err_dangling_id(fs, id));
+            }
+          else if (err)
+            {
+              return svn_error_trace(err);
+            }
+
+          stream = svn_stream_from_aprfile2(file, FALSE, scratch_pool);
         }
 
-      SVN_ERR(svn_fs_fs__read_noderev(noderev_p,
-                                      svn_stream_from_aprfile2(file,
-                                                               FALSE,
-                                                               scratch_pool),
+      SVN_ERR(svn_fs_fs__read_noderev(noderev_p, stream,
                                       result_pool, scratch_pool));
     }
   else
@@ -461,7 +497,9 @@ get_node_revision_body(node_revision_t **noderev_p,
                                  &key,
                                  result_pool));
           if (is_cached)
-            return SVN_NO_ERROR;
+            return svn_error_trace(svn_fs__io_trace_item(
+                                     fs->io_trace, key.revision, key.second,
+                                     "noderev", TRUE, -1, -1, scratch_pool));
         }
 
       /* read the data from disk */
@@ -488,6 +526,9 @@ get_node_revision_body(node_revision_t **noderev_p,
                                           revision_file->stream,
                                           result_pool,
                                           scratch_pool));
+          SVN_ERR(svn_fs__io_trace_item(fs->io_trace, key.revision,
+                                        key.second, "noderev", FALSE,
+                                        -1, -1, scratch_pool));
           SVN_ERR(fixup_node_revision(fs, *noderev_p, scratch_pool));
 
           /* The noderev is not in cache, yet. Add it, if caching has been enabled. */
@@ -533,6 +574,129 @@ svn_fs_fs__get_node_revision(node_revision_t **noderev_p,
   return svn_error_trace(err);
 }
 
+svn_error_t *
+svn_fs_fs__get_node_revisions(apr_array_header_t **noderevs,
+                              svn_fs_t *fs,
+                              const apr_array_header_t *ids,
+                              apr_pool_t *result_pool,
+                              apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  apr_array_header_t *cached = NULL;
+  apr_pool_t *iterpool;
+  int i;
+
+  if (ffd->node_revision_cache && ids->nelts > 1)
+    {
+      apr_array_header_t *keys = apr_array_make(scratch_pool, ids->nelts,
+                                                sizeof(const void *));
+      for (i = 0; i < ids->nelts; ++i)
+        {
+          const svn_fs_id_t *id = APR_ARRAY_IDX(ids, i, const svn_fs_id_t *);
+          pair_cache_key_t *key = NULL;
+
+          /* Transaction noderevs are never cached. */
+          if (!svn_fs_fs__id_is_txn(id))
+            {
+              const svn_fs_fs__id_part_t *rev_item
+                = svn_fs_fs__id_rev_item(id);
+
+              key = apr_pcalloc(scratch_pool, sizeof(*key));
+              key->revision = rev_item->revision;
+              key->second = rev_item->number;
+            }
+
+          APR_ARRAY_PUSH(keys, const void *) = key;
+        }
+
+      SVN_ERR(svn_cache__get_many(&cached, ffd->node_revision_cache, keys,
+                                  result_pool));
+    }
+
+  *noderevs = apr_array_make(result_pool, ids->nelts,
+                             sizeof(node_revision_t *));
+  iterpool = svn_pool_create(scratch_pool);
+  for (i = 0; i < ids->nelts; ++i)
+    {
+      const svn_fs_id_t *id = APR_ARRAY_IDX(ids, i, const svn_fs_id_t *);
+      node_revision_t *noderev = NULL;
+
+      svn_pool_clear(iterpool);
+      if (cached)
+        noderev = APR_ARRAY_IDX(cached, i, node_revision_t *);
+
+      if (noderev)
+        {
+          const svn_fs_fs__id_part_t *rev_item = svn_fs_fs__id_rev_item(id);
+          SVN_ERR(svn_fs__io_trace_item(fs->io_trace, rev_item->revision,
+                                        rev_item->number, "noderev", TRUE,
+                                        -1, -1, iterpool));
+        }
+      else
+        {
+          SVN_ERR(svn_fs_fs__get_node_revision(&noderev, fs, id, result_pool,
+                                               iterpool));
+        }
+
+      APR_ARRAY_PUSH(*noderevs, node_revision_t *) = noderev;
+    }
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_fs_fs__get_ancestor(node_revision_t **ancestor_p,
+                        svn_fs_t *fs,
+                        node_revision_t *noderev,
+                        int count,
+                        apr_pool_t *result_pool,
+                        apr_pool_t *scratch_pool)
+{
+  node_revision_t *ancestor = noderev;
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+
+  SVN_ERR_ASSERT(count >= 0 && count <= noderev->predecessor_count);
+
+  while (ancestor->predecessor_count > count)
+    {
+      const svn_fs_id_t *next_id = ancestor->predecessor_id;
+      int next_count = ancestor->predecessor_count - 1;
+      int skip_count = ancestor->predecessor_count
+                     & (ancestor->predecessor_count - 1);
+
+      /* Take the long jump unless it would overshoot. */
+      if (ancestor->skip_id && skip_count >= count)
+        {
+          next_id = ancestor->skip_id;
+          next_count = skip_count;
+        }
+
+      if (!next_id)
+        return svn_error_createf(SVN_ERR_FS_CORRUPT, NULL,
+                                 _("Missing predecessor of node-rev '%s'"),
+                                 svn_fs_fs__id_unparse(ancestor->id,
+                                                       iterpool)->data);
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_fs_fs__get_node_revision(&ancestor, fs, next_id,
+                                           result_pool, iterpool));
+
+      if (ancestor->predecessor_count != next_count)
+        return svn_error_createf(SVN_ERR_FS_CORRUPT, NULL,
+                                 _("Predecessor count mismatch: node-rev "
+                                   "'%s' has %d, but %d was expected"),
+                                 svn_fs_fs__id_unparse(ancestor->id,
+                                                       iterpool)->data,
+                                 ancestor->predecessor_count, next_count);
+    }
+
+  svn_pool_destroy(iterpool);
+  *ancestor_p = ancestor;
+
+  return SVN_NO_ERROR;
+}
+
 
 /* Given a revision file REV_FILE, opened to REV in FS, find the Node-ID
    of the header located at OFFSET and store it in *ID_P.  Allocate
@@ -913,7 +1077,13 @@ create_rep_state_body(rep_state_t **rep_state,
     }
 
   /* read rep header, if necessary */
-  if (!is_cached)
+  if (is_cached)
+    {
+      SVN_ERR(svn_fs__io_trace_item(fs->io_trace, rep->revision,
+                                    rep->item_index, "rep", TRUE, -1, -1,
+                                    scratch_pool));
+    }
+  else
     {
       /* ensure file is open and navigate to the start of rep header */
       if (reuse_shared_file)
@@ -964,8 +1134,11 @@ create_rep_state_body(rep_state_t **rep_state,
   *rep_state = rs;
   *rep_header = rh;
 
-  if (rh->type == svn_fs_fs__rep_plain)
-    /* This is a plaintext, so just return the current rep_state. */
+  if (   rh->type == svn_fs_fs__rep_plain
+      || rh->type == svn_fs_fs__rep_chunked
+      || rh->type == svn_fs_fs__rep_dir_index)
+    /* This is a plaintext, chunk list or directory index, so just return
+       the current rep_state. */
     return SVN_NO_ERROR;
 
   /* skip "SVNx" diff marker */
@@ -1484,6 +1657,14 @@ build_rep_list(apr_array_header_t **list,
           break;
         }
 
+      /* Chunk lists and directory indexes must be read through
+         svn_fs_fs__get_rep_chunks and can never be delta bases. */
+      if (   rep_header->type == svn_fs_fs__rep_chunked
+          || rep_header->type == svn_fs_fs__rep_dir_index)
+        return svn_error_createf(SVN_ERR_FS_CORRUPT, NULL,
+                                 _("Unexpected chunked representation "
+                                   "in r%ld"), rep.revision);
+
       /* Push this rep onto the list.  If it's self-compressed, we're done. */
       APR_ARRAY_PUSH(*list, rep_state_t *) = rs;
       if (rep_header->type == svn_fs_fs__rep_self_delta)
@@ -1541,6 +1722,33 @@ rep_read_get_baton(struct rep_read_baton **rb_p,
   return SVN_NO_ERROR;
 }
 
+/* Baton type for read_mapped(). */
+typedef struct mapped_stream_baton_t
+{
+  /* The LEN bytes of mapped file contents to read from. */
+  const char *data;
+  apr_size_t len;
+
+  /* Number of bytes consumed so far. */
+  apr_size_t pos;
+} mapped_stream_baton_t;
+
+/* Implements svn_read_fn_t, reading from the mapped_stream_baton_t in
+   BATON. */
+static svn_error_t *
+read_mapped(void *baton,
+            char *buffer,
+            apr_size_t *len)
+{
+  mapped_stream_baton_t *b = baton;
+
+  *len = MIN(*len, b->len - b->pos);
+  memcpy(buffer, b->data + b->pos, *len);
+  b->pos += *len;
+
+  return SVN_NO_ERROR;
+}
+
 /* Skip forwards to THIS_CHUNK in REP_STATE and then read the next delta
    window into *NWIN.  Note that RS->CHUNK_INDEX will be THIS_CHUNK rather
    than THIS_CHUNK + 1 when this function returns. */
@@ -1552,7 +1760,9 @@ read_delta_window(svn_txdelta_window_t **nwin, int this_chunk,
   svn_boolean_t is_cached;
   apr_off_t start_offset;
   apr_off_t end_offset;
+  apr_off_t window_start;
   apr_pool_t *iterpool;
+  const char *mapped;
 
   SVN_ERR_ASSERT(rs->chunk_index <= this_chunk);
 
@@ -1563,7 +1773,10 @@ read_delta_window(svn_txdelta_window_t **nwin, int this_chunk,
   SVN_ERR(get_cached_window(nwin, rs, this_chunk, &is_cached,
                             result_pool, scratch_pool));
   if (is_cached)
-    return SVN_NO_ERROR;
+    return svn_error_trace(svn_fs__io_trace_item(rs->sfile->fs->io_trace,
+                                                 rs->revision, rs->item_index,
+                                                 "window", TRUE, -1, -1,
+                                                 scratch_pool));
 
   /* someone has to actually read the data from file.  Open it */
   SVN_ERR(auto_open_shared_file(rs->sfile));
@@ -1614,17 +1827,46 @@ read_delta_window(svn_txdelta_window_t **nwin, int this_chunk,
                                   "representation"));
     }
   svn_pool_destroy(iterpool);
+  window_start = rs->current;
+
+  /* Actually read the next window.  Parse it directly from the mapped
+   * pack file, if available. */
+  mapped = svn_fs_fs__rev_file_mapped(rs->sfile->rfile,
+                                      rs->start + rs->current,
+                                      (apr_size_t)(rs->size - rs->current));
+  if (mapped)
+    {
+      mapped_stream_baton_t baton;
+      svn_stream_t *stream = svn_stream_create(&baton, scratch_pool);
+
+      baton.data = mapped;
+      baton.len = (apr_size_t)(rs->size - rs->current);
+      baton.pos = 0;
+      svn_stream_set_read2(stream, read_mapped, read_mapped);
+
+      SVN_ERR(svn_txdelta_read_svndiff_window(nwin, stream, rs->ver,
+                                              result_pool));
+      rs->current += baton.pos;
+    }
+  else
+    {
+      SVN_ERR(svn_txdelta_read_svndiff_window(nwin,
+                                              rs->sfile->rfile->stream,
+                                              rs->ver, result_pool));
+      SVN_ERR(get_file_offset(&end_offset, rs, scratch_pool));
+      rs->current = end_offset - rs->start;
+    }
 
-  /* Actually read the next window. */
-  SVN_ERR(svn_txdelta_read_svndiff_window(nwin, rs->sfile->rfile->stream,
-                                          rs->ver, result_pool));
-  SVN_ERR(get_file_offset(&end_offset, rs, scratch_pool));
-  rs->current = end_offset - rs->start;
   if (rs->current > rs->size)
     return svn_error_create(SVN_ERR_FS_CORRUPT, NULL,
                             _("Reading one svndiff window read beyond "
                               "the end of the representation"));
 
+  SVN_ERR(svn_fs__io_trace_item(rs->sfile->fs->io_trace, rs->revision,
+                                rs->item_index, "window", FALSE,
+                                rs->start + window_start,
+                                rs->current - window_start, scratch_pool));
+
   /* the window has not been cached before, thus cache it now
    * (if caching is used for them at all) */
   if (SVN_IS_VALID_REVNUM(rs->revision))
@@ -1640,6 +1882,7 @@ read_plain_window(svn_stringbuf_t **nwin, rep_state_t *rs,
                   apr_pool_t *scratch_pool)
 {
   apr_off_t offset;
+  const char *mapped;
 
   /* RS->FILE may be shared between RS instances -> make sure we point
    * to the right data. */
@@ -1647,13 +1890,24 @@ read_plain_window(svn_stringbuf_t **nwin, rep_state_t *rs,
   SVN_ERR(auto_set_start_offset(rs, scratch_pool));
 
   offset = rs->start + rs->current;
-  SVN_ERR(rs_aligned_seek(rs, NULL, offset, scratch_pool));
 
-  /* Read the plain data. */
-  *nwin = svn_stringbuf_create_ensure(size, result_pool);
-  SVN_ERR(svn_io_file_read_full2(rs->sfile->rfile->file, (*nwin)->data, size,
-                                 NULL, NULL, result_pool));
-  (*nwin)->data[size] = 0;
+  /* Copy directly from the OS file cache, if the file is mapped. */
+  mapped = svn_fs_fs__rev_file_mapped(rs->sfile->rfile, offset, size);
+  if (mapped)
+    {
+      *nwin = svn_stringbuf_ncreate(mapped, size, result_pool);
+    }
+  else
+    {
+      SVN_ERR(rs_aligned_seek(rs, NULL, offset, scratch_pool));
+
+      /* Read the plain data. */
+      *nwin = svn_stringbuf_create_ensure(size, result_pool);
+      SVN_ERR(svn_io_file_read_full2(rs->sfile->rfile->file, (*nwin)->data,
+                                     size, NULL, NULL, result_pool));
+      (*nwin)->data[size] = 0;
+      (*nwin)->len = size;
+    }
 
   /* Update RS. */
   rs->current += (apr_off_t)size;
@@ -1672,6 +1926,200 @@ skip_plain_window(rep_state_t *rs,
   return SVN_NO_ERROR;
 }
 
+/* Location and read state of a representation in prefetch_delta_windows. */
+typedef struct prefetch_entry_t
+{
+  /* The representation. */
+  rep_state_t *rs;
+
+  /* Its index in the delta chain. */
+  int index;
+
+  /* Values of RS->CURRENT, RS->VER and RS->CHUNK_INDEX before the
+     prefetch. */
+  apr_off_t current;
+  int ver;
+  int chunk_index;
+} prefetch_entry_t;
+
+/* Sort helper used by prefetch_delta_windows.  Orders prefetch_entry_t
+   elements by the file they live in and then by their offset within it. */
+static int
+compare_prefetch_entries(const void *lhs, const void *rhs)
+{
+  const prefetch_entry_t *a = lhs;
+  const prefetch_entry_t *b = rhs;
+
+  if (a->rs->sfile->revision != b->rs->sfile->revision)
+    return a->rs->sfile->revision < b->rs->sfile->revision ? -1 : 1;
+
+  if (a->rs->start != b->rs->start)
+    return a->rs->start < b->rs->start ? -1 : 1;
+
+  return 0;
+}
+
+/* Read the first delta window of the representations in RB->RS_LIST and
+   append them to the empty array WINDOWS.  Set *COUNT to the number of
+   windows that actually need to be combined, i.e. stop after the first
+   window that does not depend on its predecessors.
+
+   Rather than following the delta chain from the top, the windows that
+   are not already in cache get read in file order, i.e. sorted by rev /
+   pack file and by offset within that file.  Long chains within a pack
+   file are then read in a single forward sweep instead of jumping back
+   and forth, which allows block-read and the OS read-ahead to kick in.
+
+   Allocate the windows in RESULT_POOL and use SCRATCH_POOL for temporary
+   allocations. */
+static svn_error_t *
+prefetch_delta_windows(apr_array_header_t *windows,
+                       int *count,
+                       struct rep_read_baton *rb,
+                       apr_pool_t *result_pool,
+                       apr_pool_t *scratch_pool)
+{
+  int i;
+  apr_array_header_t *states;
+  apr_array_header_t *to_read;
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+
+  states = apr_array_make(scratch_pool, rb->rs_list->nelts,
+                          sizeof(prefetch_entry_t));
+  to_read = apr_array_make(scratch_pool, rb->rs_list->nelts,
+                           sizeof(prefetch_entry_t));
+
+  /* Collect the windows we already have and determine the location of
+     all others.  Remember the read state of every rep, since getting a
+     window from cache moves the read position just like reading it. */
+  for (i = 0; i < rb->rs_list->nelts; ++i)
+    {
+      svn_boolean_t is_cached;
+      svn_txdelta_window_t *window = NULL;
+      rep_state_t *rs = APR_ARRAY_IDX(rb->rs_list, i, rep_state_t *);
+      prefetch_entry_t *state = apr_array_push(states);
+
+      state->rs = rs;
+      state->index = i;
+      state->current = rs->current;
+      state->ver = rs->ver;
+      state->chunk_index = rs->chunk_index;
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(get_cached_window(&window, rs, 0, &is_cached, result_pool,
+                                iterpool));
+
+      APR_ARRAY_PUSH(windows, svn_txdelta_window_t *) = window;
+      if (!is_cached)
+        {
+          SVN_ERR(auto_open_shared_file(rs->sfile));
+          SVN_ERR(auto_set_start_offset(rs, iterpool));
+
+          APR_ARRAY_PUSH(to_read, prefetch_entry_t) = *state;
+        }
+    }
+
+  /* Read the missing windows in the order given by their location.
+     Announce all of them first, so the OS may fetch them concurrently. */
+  svn_sort__array(to_read, compare_prefetch_entries);
+  for (i = 0; i < to_read->nelts; ++i)
+    {
+      prefetch_entry_t *entry = &APR_ARRAY_IDX(to_read, i, prefetch_entry_t);
+      rep_state_t *rs = entry->rs;
+
+      svn_fs_fs__rev_file_prefetch(rs->sfile->rfile, rs->start + rs->current,
+                                   MIN(rs->size - rs->current,
+                                       rs->sfile->rfile->block_size));
+    }
+
+  for (i = 0; i < to_read->nelts; ++i)
+    {
+      prefetch_entry_t *entry = &APR_ARRAY_IDX(to_read, i, prefetch_entry_t);
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(read_delta_window(&APR_ARRAY_IDX(windows, entry->index,
+                                               svn_txdelta_window_t *),
+                                0, entry->rs, result_pool, iterpool));
+    }
+
+  svn_pool_destroy(iterpool);
+
+  /* Find the end of the chain for this chunk. */
+  for (*count = 0; *count < windows->nelts; ++*count)
+    if (APR_ARRAY_IDX(windows, *count, svn_txdelta_window_t *)->src_ops == 0)
+      {
+        ++*count;
+        break;
+      }
+
+  /* Reps beyond that point will not be combined.  Reset their read
+     position such that the next chunk will be read from the right place,
+     just as if we had not fetched their first window, be it from cache
+     or from disk. */
+  for (i = *count; i < states->nelts; ++i)
+    {
+      prefetch_entry_t *state = &APR_ARRAY_IDX(states, i, prefetch_entry_t);
+
+      /* auto_read_diff_version leaves us right behind the svndiff header */
+      if (state->ver == -1 && state->rs->ver != -1)
+        state->rs->current = 4;
+      else
+        state->rs->current = state->current;
+
+      state->rs->chunk_index = state->chunk_index;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Look up the txdelta windows number CHUNK_INDEX of all representations
+ * in RB->RS_LIST in a single cache request.  Set *WINDOWS to an array of
+ * svn_fs_fs__txdelta_cached_window_t * with one element per entry in
+ * RB->RS_LIST, NULL for windows that are not cached.  Set *WINDOWS to
+ * NULL if there is no window cache to ask.
+ *
+ * With a remote cache like memcached, this turns one round trip per
+ * delta in the chain into one round trip per chunk.  Allocate the windows
+ * in RESULT_POOL and use SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+get_cached_windows(apr_array_header_t **windows,
+                   struct rep_read_baton *rb,
+                   int chunk_index,
+                   apr_pool_t *result_pool,
+                   apr_pool_t *scratch_pool)
+{
+  svn_cache__t *window_cache = NULL;
+  apr_array_header_t *keys;
+  int i;
+
+  keys = apr_array_make(scratch_pool, rb->rs_list->nelts,
+                        sizeof(const void *));
+  for (i = 0; i < rb->rs_list->nelts; ++i)
+    {
+      rep_state_t *rs = APR_ARRAY_IDX(rb->rs_list, i, rep_state_t *);
+      window_cache_key_t *key = NULL;
+
+      /* All reps in a chain use the same cache, if any. */
+      if (rs->window_cache)
+        {
+          window_cache = rs->window_cache;
+          key = apr_pcalloc(scratch_pool, sizeof(*key));
+          get_window_key(key, rs);
+          key->chunk_index = chunk_index;
+        }
+
+      APR_ARRAY_PUSH(keys, const void *) = key;
+    }
+
+  if (window_cache)
+    SVN_ERR(svn_cache__get_many(windows, window_cache, keys, result_pool));
+  else
+    *windows = NULL;
+
+  return SVN_NO_ERROR;
+}
+
 /* Get the undeltified window that is a result of combining all deltas
    from the current desired representation identified in *RB with its
    base representation.  Store the window in *RESULT. */
@@ -1685,6 +2133,7 @@ get_combined_window(svn_stringbuf_t **result,
   svn_stringbuf_t *source, *buf = rb->base_window;
   rep_state_t *rs;
   apr_pool_t *iterpool;
+  fs_fs_data_t *ffd = rb->fs->fsap_data;
 
   /* Read all windows that we need to combine. This is fine because
      the size of each window is relatively small (100kB) and skip-
@@ -1693,21 +2142,61 @@ get_combined_window(svn_stringbuf_t **result,
   window_pool = svn_pool_create(rb->pool);
   windows = apr_array_make(window_pool, 0, sizeof(svn_txdelta_window_t *));
   iterpool = svn_pool_create(rb->pool);
-  for (i = 0; i < rb->rs_list->nelts; ++i)
-    {
-      svn_txdelta_window_t *window;
 
-      svn_pool_clear(iterpool);
+  /* The first chunk determines the first-byte latency.  If configured,
+     fetch all its windows in file order instead of chain order. */
+  if (   ffd->prefetch_delta_chain
+      && rb->chunk_index == 0
+      && rb->rs_list->nelts > 1)
+    {
+      SVN_ERR(prefetch_delta_windows(windows, &i, rb, window_pool,
+                                     iterpool));
+    }
+  else
+    {
+      apr_array_header_t *cached_windows = NULL;
 
-      rs = APR_ARRAY_IDX(rb->rs_list, i, rep_state_t *);
-      SVN_ERR(read_delta_window(&window, rb->chunk_index, rs, window_pool,
-                                iterpool));
+      /* Fetch whatever the cache has for this chunk in one go. */
+      if (rb->rs_list->nelts > 1)
+        SVN_ERR(get_cached_windows(&cached_windows, rb, rb->chunk_index,
+                                   window_pool, iterpool));
 
-      APR_ARRAY_PUSH(windows, svn_txdelta_window_t *) = window;
-      if (window->src_ops == 0)
+      for (i = 0; i < rb->rs_list->nelts; ++i)
         {
-          ++i;
-          break;
+          svn_txdelta_window_t *window;
+          svn_fs_fs__txdelta_cached_window_t *cached_window = NULL;
+
+          svn_pool_clear(iterpool);
+
+          rs = APR_ARRAY_IDX(rb->rs_list, i, rep_state_t *);
+          if (cached_windows)
+            cached_window = APR_ARRAY_IDX(cached_windows, i,
+                                  svn_fs_fs__txdelta_cached_window_t *);
+
+          if (cached_window)
+            {
+              /* manipulate the RS as if we just read the data */
+              window = cached_window->window;
+              rs->current = cached_window->end_offset;
+              rs->chunk_index = rb->chunk_index;
+              SVN_ERR(svn_fs__io_trace_item(rs->sfile->fs->io_trace,
+                                            rs->revision,
+                                            rs->item_index, "window", TRUE,
+                                            -1, -1, iterpool));
+            }
+          else
+            {
+              /* Falls back to the raw window cache and the file. */
+              SVN_ERR(read_delta_window(&window, rb->chunk_index, rs,
+                                        window_pool, iterpool));
+            }
+
+          APR_ARRAY_PUSH(windows, svn_txdelta_window_t *) = window;
+          if (window->src_ops == 0)
+            {
+              ++i;
+              break;
+            }
         }
     }
 
@@ -2210,49 +2699,375 @@ rep_read_contents(void *baton,
   return SVN_NO_ERROR;
 }
 
-svn_error_t *
-svn_fs_fs__get_contents(svn_stream_t **contents_p,
-                        svn_fs_t *fs,
-                        representation_t *rep,
-                        svn_boolean_t cache_fulltext,
-                        apr_pool_t *pool)
+/* Read the chunk list of the chunked representation REP from STREAM,
+ * which must be positioned directly behind the rep header.  Return the
+ * fully qualified chunk reps in *CHUNKS.  If NAMES is not NULL, REP is
+ * an indexed directory and *NAMES receives the first entry names of the
+ * blocks in *CHUNKS.  Allocate the result in RESULT_POOL and use
+ * SCRATCH_POOL for temporaries.
+ */
+static svn_error_t *
+read_chunks(apr_array_header_t **chunks,
+            apr_array_header_t **names,
+            svn_stream_t *stream,
+            representation_t *rep,
+            apr_pool_t *result_pool,
+            apr_pool_t *scratch_pool)
 {
-  if (! rep)
-    {
-      *contents_p = svn_stream_empty(pool);
-    }
-  else
-    {
-      fs_fs_data_t *ffd = fs->fsap_data;
-      struct rep_read_baton *rb;
-
-      pair_cache_key_t fulltext_cache_key = { 0 };
-      fulltext_cache_key.revision = rep->revision;
-      fulltext_cache_key.second = rep->item_index;
+  svn_stringbuf_t *body;
+  apr_size_t len;
+  svn_filesize_t total = 0;
+  int i;
 
-      /* Initialize the reader baton.  Some members may added lazily
-       * while reading from the stream */
-      SVN_ERR(rep_read_get_baton(&rb, fs, rep, fulltext_cache_key, pool));
+  if (rep->size < 0 || rep->size >= APR_INT32_MAX)
+    return svn_error_create(SVN_ERR_FS_CORRUPT, NULL,
+                            _("Invalid chunked representation size"));
+
+  len = (apr_size_t)rep->size;
+  body = svn_stringbuf_create_ensure(len, scratch_pool);
+  SVN_ERR(svn_stream_read_full(stream, body->data, &len));
+  body->len = len;
+  body->data[len] = '\0';
+
+  if (names)
+    SVN_ERR(svn_fs_fs__read_dir_index(chunks, names,
+                                      svn_stream_from_stringbuf(body,
+                                                                scratch_pool),
+                                      result_pool, scratch_pool));
+  else
+    SVN_ERR(svn_fs_fs__read_chunk_list(chunks,
+                                       svn_stream_from_stringbuf(body,
+                                                                 scratch_pool),
+                                       result_pool, scratch_pool));
 
-      /* Make the stream attempt fulltext cache lookups if the fulltext
-       * is cacheable.  If it is not, then also don't try to buffer and
-       * cache it. */
-      if (ffd->fulltext_cache && cache_fulltext
-          && SVN_IS_VALID_REVNUM(rep->revision)
-          && fulltext_size_is_cachable(ffd, rep->expanded_size))
-        {
-          rb->fulltext_cache = ffd->fulltext_cache;
-        }
-      else
+  /* Chunks without revision info have been written along with REP. */
+  for (i = 0; i < (*chunks)->nelts; ++i)
+    {
+      representation_t *chunk = APR_ARRAY_IDX(*chunks, i,
+                                              representation_t *);
+      if (!SVN_IS_VALID_REVNUM(chunk->revision))
         {
-          /* This will also prevent the reconstructed fulltext from being
-             put into the cache. */
-          rb->fulltext_cache_key.revision = SVN_INVALID_REVNUM;
+          chunk->revision = rep->revision;
+          chunk->txn_id = rep->txn_id;
         }
 
-      *contents_p = svn_stream_create(rb, pool);
-      svn_stream_set_read2(*contents_p, NULL /* only full read support */,
-                           rep_read_contents);
+      total += chunk->expanded_size;
+    }
+
+  if (total != rep->expanded_size)
+    return svn_error_createf(SVN_ERR_FS_CORRUPT, NULL,
+                             _("Chunks of representation add up to %s "
+                               "bytes instead of %s"),
+                             apr_psprintf(scratch_pool,
+                                          "%" SVN_FILESIZE_T_FMT, total),
+                             apr_psprintf(scratch_pool,
+                                          "%" SVN_FILESIZE_T_FMT,
+                                          rep->expanded_size));
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *CHUNKS to the chunks of REP in FS, if that is a chunked rep or an
+ * indexed directory, and to NULL otherwise.  In the latter case, also set
+ * *NAMES to the first entry names of the blocks, unless NAMES is NULL.
+ * Allocate the result in RESULT_POOL and use SCRATCH_POOL for temporaries.
+ */
+static svn_error_t *
+get_rep_chunks(apr_array_header_t **chunks,
+               apr_array_header_t **names,
+               svn_fs_t *fs,
+               representation_t *rep,
+               apr_pool_t *result_pool,
+               apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  svn_fs_fs__revision_file_t *rev_file;
+  svn_fs_fs__rep_header_t *rh;
+
+  /* Only large file reps and directories in repositories that allow for
+     it are chunked. */
+  *chunks = NULL;
+  if (names)
+    *names = NULL;
+  if (   !rep
+      || !(   (   ffd->chunked_reps
+               && rep->expanded_size >= SVN_FS_FS__CHUNKED_REP_MIN_THRESHOLD)
+           || (   ffd->indexed_dirs
+               && rep->expanded_size >= SVN_FS_FS__INDEXED_DIR_MIN_SIZE)))
+    return SVN_NO_ERROR;
+
+  /* A cached header may tell us that there is nothing to do. */
+  if (ffd->rep_header_cache && !svn_fs_fs__id_txn_used(&rep->txn_id))
+    {
+      svn_boolean_t is_cached;
+      pair_cache_key_t key;
+      key.revision = rep->revision;
+      key.second = rep->item_index;
+
+      SVN_ERR(svn_cache__get((void **) &rh, &is_cached,
+                             ffd->rep_header_cache, &key, scratch_pool));
+      if (   is_cached
+          && rh->type != svn_fs_fs__rep_chunked
+          && rh->type != svn_fs_fs__rep_dir_index)
+        return SVN_NO_ERROR;
+    }
+
+  SVN_ERR(open_and_seek_representation(&rev_file, fs, rep, scratch_pool));
+  SVN_ERR(svn_fs_fs__read_rep_header(&rh, rev_file->stream, scratch_pool,
+                                     scratch_pool));
+  if (rh->type == svn_fs_fs__rep_chunked)
+    {
+      SVN_ERR(read_chunks(chunks, NULL, rev_file->stream, rep, result_pool,
+                          scratch_pool));
+    }
+  else if (rh->type == svn_fs_fs__rep_dir_index)
+    {
+      apr_array_header_t *block_names;
+
+      SVN_ERR(read_chunks(chunks, &block_names, rev_file->stream, rep,
+                          result_pool, scratch_pool));
+      if (names)
+        *names = block_names;
+    }
+
+  return svn_error_trace(svn_fs_fs__close_revision_file(rev_file));
+}
+
+svn_error_t *
+svn_fs_fs__get_rep_chunks(apr_array_header_t **chunks,
+                          svn_fs_t *fs,
+                          representation_t *rep,
+                          apr_pool_t *result_pool,
+                          apr_pool_t *scratch_pool)
+{
+  return svn_error_trace(get_rep_chunks(chunks, NULL, fs, rep, result_pool,
+                                        scratch_pool));
+}
+
+svn_error_t *
+svn_fs_fs__get_dir_index(apr_array_header_t **blocks,
+                         apr_array_header_t **names,
+                         svn_fs_t *fs,
+                         representation_t *rep,
+                         apr_pool_t *result_pool,
+                         apr_pool_t *scratch_pool)
+{
+  SVN_ERR(get_rep_chunks(blocks, names, fs, rep, result_pool,
+                         scratch_pool));
+
+  /* Chunked file reps are not what the caller is looking for. */
+  if (*blocks && !*names)
+    *blocks = NULL;
+
+  return SVN_NO_ERROR;
+}
+
+/* Baton type for the chunked representation streams. */
+typedef struct chunked_read_baton_t
+{
+  /* The FS from which we read. */
+  svn_fs_t *fs;
+
+  /* The chunk reps (representation_t *) to concatenate. */
+  apr_array_header_t *chunks;
+
+  /* Index of the next element in CHUNKS to open. */
+  int next_chunk;
+
+  /* Contents of the current chunk.  NULL if we need to open the next. */
+  svn_stream_t *current;
+
+  /* Passed through to svn_fs_fs__get_contents for each chunk. */
+  svn_boolean_t cache_fulltext;
+
+  /* MD5 checksum context and expected digest of the whole contents. */
+  svn_checksum_ctx_t *md5_checksum_ctx;
+  svn_boolean_t checksum_finalized;
+  unsigned char md5_digest[APR_MD5_DIGESTSIZE];
+
+  /* Expected length of the whole contents and number of bytes read. */
+  svn_filesize_t len;
+  svn_filesize_t off;
+
+  /* Holds CURRENT.  Gets cleared for every chunk. */
+  apr_pool_t *chunk_pool;
+
+  /* For everything else. */
+  apr_pool_t *pool;
+} chunked_read_baton_t;
+
+/* Implements svn_read_fn_t for chunked_read_baton_t in BATON, reading
+ * the chunks one after another.  Validates length and checksum of the
+ * whole contents at EOF.
+ */
+static svn_error_t *
+chunked_read_contents(void *baton,
+                      char *buffer,
+                      apr_size_t *len)
+{
+  chunked_read_baton_t *b = baton;
+  apr_size_t done = 0;
+
+  while (done < *len)
+    {
+      apr_size_t to_read = *len - done;
+
+      if (b->current == NULL)
+        {
+          representation_t *chunk;
+          if (b->next_chunk == b->chunks->nelts)
+            break;
+
+          svn_pool_clear(b->chunk_pool);
+          chunk = APR_ARRAY_IDX(b->chunks, b->next_chunk,
+                                representation_t *);
+          SVN_ERR(svn_fs_fs__get_contents(&b->current, b->fs, chunk,
+                                          b->cache_fulltext, b->chunk_pool));
+          b->next_chunk++;
+        }
+
+      SVN_ERR(svn_stream_read_full(b->current, buffer + done, &to_read));
+      if (done + to_read < *len)
+        {
+          SVN_ERR(svn_stream_close(b->current));
+          b->current = NULL;
+        }
+
+      done += to_read;
+    }
+
+  if (!b->checksum_finalized)
+    SVN_ERR(svn_checksum_update(b->md5_checksum_ctx, buffer, done));
+  b->off += done;
+
+  /* A short read means EOF.  Verify what we delivered. */
+  if (done < *len && !b->checksum_finalized)
+    {
+      svn_checksum_t *md5_checksum;
+      svn_checksum_t expected;
+      expected.kind = svn_checksum_md5;
+      expected.digest = b->md5_digest;
+
+      if (b->off != b->len)
+        return svn_error_createf(SVN_ERR_FS_CORRUPT, NULL,
+                            _("Length mismatch while reading chunked "
+                              "representation: expected %s, got %s"),
+                            apr_psprintf(b->pool, "%" SVN_FILESIZE_T_FMT,
+                                         b->len),
+                            apr_psprintf(b->pool, "%" SVN_FILESIZE_T_FMT,
+                                         b->off));
+
+      b->checksum_finalized = TRUE;
+      SVN_ERR(svn_checksum_final(&md5_checksum, b->md5_checksum_ctx,
+                                 b->pool));
+      if (!svn_checksum_match(md5_checksum, &expected))
+        return svn_error_create(SVN_ERR_FS_CORRUPT,
+                svn_checksum_mismatch_err(&expected, md5_checksum, b->pool,
+                    _("Checksum mismatch while reading representation")),
+                NULL);
+    }
+
+  *len = done;
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_close_fn_t for chunked_read_baton_t in BATON. */
+static svn_error_t *
+chunked_read_contents_close(void *baton)
+{
+  chunked_read_baton_t *b = baton;
+
+  svn_pool_destroy(b->pool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *CONTENTS_P to a stream concatenating the contents of CHUNKS in FS,
+ * which make up the chunked representation REP.  CACHE_FULLTEXT gets
+ * passed to svn_fs_fs__get_contents.  Allocate the stream in POOL.
+ */
+static void
+get_chunked_contents(svn_stream_t **contents_p,
+                     svn_fs_t *fs,
+                     representation_t *rep,
+                     apr_array_header_t *chunks,
+                     svn_boolean_t cache_fulltext,
+                     apr_pool_t *pool)
+{
+  chunked_read_baton_t *b = apr_pcalloc(pool, sizeof(*b));
+
+  b->fs = fs;
+  b->chunks = chunks;
+  b->next_chunk = 0;
+  b->current = NULL;
+  b->cache_fulltext = cache_fulltext;
+  b->pool = svn_pool_create(pool);
+  b->chunk_pool = svn_pool_create(b->pool);
+  b->md5_checksum_ctx = svn_checksum_ctx_create(svn_checksum_md5, b->pool);
+  b->checksum_finalized = FALSE;
+  memcpy(b->md5_digest, rep->md5_digest, sizeof(rep->md5_digest));
+  b->len = rep->expanded_size;
+  b->off = 0;
+
+  *contents_p = svn_stream_create(b, pool);
+  svn_stream_set_read2(*contents_p, NULL /* only full read support */,
+                       chunked_read_contents);
+  svn_stream_set_close(*contents_p, chunked_read_contents_close);
+}
+
+svn_error_t *
+svn_fs_fs__get_contents(svn_stream_t **contents_p,
+                        svn_fs_t *fs,
+                        representation_t *rep,
+                        svn_boolean_t cache_fulltext,
+                        apr_pool_t *pool)
+{
+  if (! rep)
+    {
+      *contents_p = svn_stream_empty(pool);
+    }
+  else
+    {
+      fs_fs_data_t *ffd = fs->fsap_data;
+      struct rep_read_baton *rb;
+      apr_array_header_t *chunks;
+
+      pair_cache_key_t fulltext_cache_key = { 0 };
+      fulltext_cache_key.revision = rep->revision;
+      fulltext_cache_key.second = rep->item_index;
+
+      /* Chunked reps are simply the concatenation of their chunks. */
+      SVN_ERR(svn_fs_fs__get_rep_chunks(&chunks, fs, rep, pool, pool));
+      if (chunks)
+        {
+          get_chunked_contents(contents_p, fs, rep, chunks, cache_fulltext,
+                               pool);
+          return SVN_NO_ERROR;
+        }
+
+      /* Initialize the reader baton.  Some members may added lazily
+       * while reading from the stream */
+      SVN_ERR(rep_read_get_baton(&rb, fs, rep, fulltext_cache_key, pool));
+
+      /* Make the stream attempt fulltext cache lookups if the fulltext
+       * is cacheable.  If it is not, then also don't try to buffer and
+       * cache it. */
+      if (ffd->fulltext_cache && cache_fulltext
+          && SVN_IS_VALID_REVNUM(rep->revision)
+          && fulltext_size_is_cachable(ffd, rep->expanded_size))
+        {
+          rb->fulltext_cache = ffd->fulltext_cache;
+        }
+      else
+        {
+          /* This will also prevent the reconstructed fulltext from being
+             put into the cache. */
+          rb->fulltext_cache_key.revision = SVN_INVALID_REVNUM;
+        }
+
+      *contents_p = svn_stream_create(rb, pool);
+      svn_stream_set_read2(*contents_p, NULL /* only full read support */,
+                           rep_read_contents);
       svn_stream_set_close(*contents_p, rep_read_contents_close);
     }
 
@@ -2307,7 +3122,20 @@ svn_fs_fs__get_contents_from_file(svn_stream_t **contents_p,
                          SVN_FS_FS__ITEM_TYPE_ANY_REP, pool));
 
   /* Build the representation list (delta chain). */
-  if (rh->type == svn_fs_fs__rep_plain)
+  if (   rh->type == svn_fs_fs__rep_chunked
+      || rh->type == svn_fs_fs__rep_dir_index)
+    {
+      apr_array_header_t *chunks;
+      apr_array_header_t *names;
+
+      SVN_ERR(read_chunks(&chunks,
+                          rh->type == svn_fs_fs__rep_dir_index ? &names : NULL,
+                          rs->sfile->rfile->stream, rep, pool, pool));
+      get_chunked_contents(contents_p, fs, rep, chunks, FALSE, pool);
+
+      return SVN_NO_ERROR;
+    }
+  else if (rh->type == svn_fs_fs__rep_plain)
     {
       rb->rs_list = apr_array_make(pool, 0, sizeof(rep_state_t *));
       rb->src_state = rs;
@@ -2447,6 +3275,91 @@ delta_read_next_window(svn_txdelta_window_t **window, void *baton,
   return SVN_NO_ERROR;
 }
 
+/* This implements the svn_txdelta__next_raw_window_fn_t interface. */
+static svn_error_t *
+delta_read_next_raw_window(const svn_string_t **raw_window,
+                           int *svndiff_version,
+                           void *baton,
+                           apr_pool_t *pool)
+{
+  struct delta_read_baton *drb = baton;
+  rep_state_t *rs = drb->rs;
+  apr_pool_t *scratch_pool;
+  svn_string_t *result;
+  apr_off_t start_offset;
+  apr_size_t window_len;
+  const char *mapped;
+
+  *raw_window = NULL;
+  if (rs->current >= rs->size)
+    return SVN_NO_ERROR;
+
+  /* Block-read may already have put the window into the cache for us. */
+  if (rs->raw_window_cache && SVN_IS_VALID_REVNUM(rs->revision))
+    {
+      svn_fs_fs__raw_cached_window_t *cached_window;
+      window_cache_key_t key = { 0 };
+      svn_boolean_t is_cached;
+
+      SVN_ERR(svn_cache__get((void **)&cached_window, &is_cached,
+                             rs->raw_window_cache, get_window_key(&key, rs),
+                             pool));
+      if (is_cached)
+        {
+          *raw_window = &cached_window->window;
+          *svndiff_version = cached_window->ver;
+
+          rs->current = cached_window->end_offset;
+          rs->chunk_index++;
+
+          return SVN_NO_ERROR;
+        }
+    }
+
+  /* Read it from disk, without parsing it. */
+  scratch_pool = svn_pool_create(pool);
+  SVN_ERR(auto_open_shared_file(rs->sfile));
+  SVN_ERR(auto_set_start_offset(rs, scratch_pool));
+  SVN_ERR(auto_read_diff_version(rs, scratch_pool));
+
+  start_offset = rs->start + rs->current;
+  SVN_ERR(rs_aligned_seek(rs, NULL, start_offset, scratch_pool));
+  SVN_ERR(svn_txdelta__read_raw_window_len(&window_len,
+                                           rs->sfile->rfile->stream,
+                                           scratch_pool));
+  if ((apr_off_t)window_len > rs->size - rs->current)
+    return svn_error_create(SVN_ERR_FS_CORRUPT, NULL,
+                            _("Reading one svndiff window read beyond "
+                              "the end of the representation"));
+
+  result = apr_palloc(pool, sizeof(*result));
+  result->len = window_len;
+  mapped = svn_fs_fs__rev_file_mapped(rs->sfile->rfile, start_offset,
+                                      window_len);
+  if (mapped)
+    {
+      result->data = mapped;
+    }
+  else
+    {
+      char *buf = apr_palloc(pool, window_len + 1);
+      SVN_ERR(rs_aligned_seek(rs, NULL, start_offset, scratch_pool));
+      SVN_ERR(svn_io_file_read_full2(rs->sfile->rfile->file, buf,
+                                     window_len, NULL, NULL, scratch_pool));
+      buf[window_len] = 0;
+      result->data = buf;
+    }
+
+  rs->current += window_len;
+  rs->chunk_index++;
+
+  *raw_window = result;
+  *svndiff_version = rs->ver;
+  svn_pool_destroy(scratch_pool);
+
+  return SVN_NO_ERROR;
+}
+
 /* This implements the svn_txdelta_md5_digest_fn_t interface. */
 static const unsigned char *
 delta_read_md5_digest(void *baton)
@@ -2465,11 +3378,18 @@ get_storaged_delta_stream(rep_state_t *rep_state,
 {
   /* Create the delta read baton. */
   struct delta_read_baton *drb = apr_pcalloc(pool, sizeof(*drb));
+  svn_txdelta_stream_t *stream;
+
   drb->rs = rep_state;
   memcpy(drb->md5_digest, target->data_rep->md5_digest,
          sizeof(drb->md5_digest));
-  return svn_txdelta_stream_create(drb, delta_read_next_window,
-                                   delta_read_md5_digest, pool);
+
+  stream = svn_txdelta_stream_create(drb, delta_read_next_window,
+                                     delta_read_md5_digest, pool);
+  svn_txdelta__stream_set_raw_window_func(stream,
+                                          delta_read_next_raw_window);
+
+  return stream;
 }
 
 svn_error_t *
@@ -2486,8 +3406,10 @@ svn_fs_fs__get_file_delta_stream(svn_txdelta_stream_t **stream_p,
 
   /* Try a shortcut: if the target is stored as a delta against the source,
      then just use that delta.  However, prefer using the fulltext cache
-     whenever that is available. */
-  if (target->data_rep && (source || ! ffd->fulltext_cache))
+     whenever that is available.  Large delta windows are only for storage;
+     our callers may need to encode windows as older svndiff versions. */
+  if (target->data_rep && (source || ! ffd->fulltext_cache)
+      && !ffd->large_delta_windows)
     {
       /* Read target's base rep if any. */
       SVN_ERR(create_rep_state(&rep_state, &rep_header, NULL,
@@ -2543,6 +3465,119 @@ svn_fs_fs__get_file_delta_stream(svn_txdelta_stream_t **stream_p,
   return SVN_NO_ERROR;
 }
 
+/* Baton for read_stored_delta. */
+typedef struct stored_delta_baton_t
+{
+  /* The representation to read.  Its file has been opened and positioned
+     at the start of the svndiff data. */
+  rep_state_t *rs;
+
+  /* Number of bytes not read, yet. */
+  apr_off_t remaining;
+} stored_delta_baton_t;
+
+/* Implements svn_read_fn_t.  Copy bytes from the stored_delta_baton_t
+   BATON.  Close the file once all data has been read. */
+static svn_error_t *
+read_stored_delta(void *baton,
+                  char *buffer,
+                  apr_size_t *len)
+{
+  stored_delta_baton_t *b = baton;
+  shared_file_t *sfile = b->rs->sfile;
+
+  if (*len > b->remaining)
+    *len = (apr_size_t)b->remaining;
+
+  if (*len)
+    SVN_ERR(svn_io_file_read_full2(sfile->rfile->file, buffer, *len,
+                                   NULL, NULL, sfile->pool));
+
+  b->remaining -= *len;
+  if (b->remaining == 0 && sfile->rfile)
+    {
+      SVN_ERR(svn_fs_fs__close_revision_file(sfile->rfile));
+      sfile->rfile = NULL;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_close_fn_t.  Release the file of the
+   stored_delta_baton_t BATON. */
+static svn_error_t *
+close_stored_delta(void *baton)
+{
+  stored_delta_baton_t *b = baton;
+  shared_file_t *sfile = b->rs->sfile;
+
+  if (sfile->rfile)
+    {
+      SVN_ERR(svn_fs_fs__close_revision_file(sfile->rfile));
+      sfile->rfile = NULL;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_fs_fs__get_stored_delta(svn_stream_t **svndiff_p,
+                            svn_filesize_t *len_p,
+                            svn_fs_t *fs,
+                            node_revision_t *source,
+                            node_revision_t *target,
+                            int max_version,
+                            apr_pool_t *result_pool,
+                            apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  rep_state_t *rs;
+  svn_fs_fs__rep_header_t *rep_header;
+  stored_delta_baton_t *baton;
+
+  *svndiff_p = NULL;
+
+  /* Same restrictions as for the shortcut in
+     svn_fs_fs__get_file_delta_stream.  Reps in transactions may still
+     change, so only committed ones qualify. */
+  if (   !source || !source->data_rep || !target->data_rep
+      || svn_fs_fs__id_txn_used(&target->data_rep->txn_id)
+      || ffd->large_delta_windows)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(create_rep_state(&rs, &rep_header, NULL, target->data_rep, fs,
+                           result_pool, scratch_pool));
+  if (   rep_header->type != svn_fs_fs__rep_delta
+      || rep_header->base_revision != source->data_rep->revision
+      || rep_header->base_item_index != source->data_rep->item_index)
+    return SVN_NO_ERROR;
+
+  /* Position the file at the start of the svndiff data. */
+  SVN_ERR(auto_open_shared_file(rs->sfile));
+  SVN_ERR(auto_set_start_offset(rs, scratch_pool));
+  SVN_ERR(auto_read_diff_version(rs, scratch_pool));
+  if (rs->ver > max_version)
+    {
+      SVN_ERR(svn_fs_fs__close_revision_file(rs->sfile->rfile));
+      rs->sfile->rfile = NULL;
+      return SVN_NO_ERROR;
+    }
+
+  SVN_ERR(rs_aligned_seek(rs, NULL, rs->start, scratch_pool));
+
+  baton = apr_pcalloc(result_pool, sizeof(*baton));
+  baton->rs = rs;
+  baton->remaining = rs->size;
+
+  *svndiff_p = svn_stream_create(baton, result_pool);
+  svn_stream_set_read2(*svndiff_p, NULL /* only full read support */,
+                       read_stored_delta);
+  svn_stream_set_close(*svndiff_p, close_stored_delta);
+  *len_p = rs->size;
+
+  return SVN_NO_ERROR;
+}
+
 /* Return TRUE when all svn_fs_dirent_t* in ENTRIES are already sorted
    by their respective name. */
 static svn_boolean_t
@@ -2896,6 +3931,105 @@ svn_fs_fs__find_dir_entry(apr_array_header_t *entries,
   return result ? *result : NULL;
 }
 
+/* Return a copy of DIRENT allocated in RESULT_POOL. */
+static svn_fs_dirent_t *
+dirent_dup(const svn_fs_dirent_t *dirent,
+           apr_pool_t *result_pool)
+{
+  svn_fs_dirent_t *copy = apr_palloc(result_pool, sizeof(*copy));
+  copy->name = apr_pstrdup(result_pool, dirent->name);
+  copy->id = svn_fs_fs__id_copy(dirent->id, result_pool);
+  copy->kind = dirent->kind;
+
+  return copy;
+}
+
+/* Set *DIRENT to the entry NAME of the directory NODEREV in FS, whose
+ * representation is an index of BLOCKS, each starting with the entry
+ * in NAMES.  Only read and cache the block that may contain NAME.  Set
+ * *DIRENT to NULL, if there is no such entry.  Allocate the result in
+ * RESULT_POOL and use SCRATCH_POOL for temporaries.
+ */
+static svn_error_t *
+get_indexed_dir_entry(svn_fs_dirent_t **dirent,
+                      svn_fs_t *fs,
+                      node_revision_t *noderev,
+                      apr_array_header_t *blocks,
+                      apr_array_header_t *names,
+                      const char *name,
+                      apr_pool_t *result_pool,
+                      apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  representation_t *block;
+  pair_cache_key_t key = { 0 };
+  extract_dir_entry_baton_t baton;
+  svn_boolean_t found = FALSE;
+  int lower = 0;
+  int upper = names->nelts;
+
+  /* Find the last block that does not start behind NAME. */
+  while (lower < upper)
+    {
+      int middle = lower + (upper - lower) / 2;
+      if (strcmp(APR_ARRAY_IDX(names, middle, const char *), name) <= 0)
+        lower = middle + 1;
+      else
+        upper = middle;
+    }
+
+  *dirent = NULL;
+  if (lower == 0)
+    return SVN_NO_ERROR;
+
+  /* Blocks are cached just like directories of their own. */
+  block = APR_ARRAY_IDX(blocks, lower - 1, representation_t *);
+  key.revision = block->revision;
+  key.second = block->item_index;
+  if (ffd->dir_cache)
+    {
+      baton.txn_filesize = SVN_INVALID_FILESIZE;
+      baton.name = name;
+      SVN_ERR(svn_cache__get_partial((void **)dirent, &found,
+                                     ffd->dir_cache, &key,
+                                     svn_fs_fs__extract_dir_entry,
+                                     &baton, result_pool));
+    }
+
+  if (!found || baton.out_of_date)
+    {
+      svn_fs_fs__dir_data_t dir;
+      svn_fs_dirent_t *entry;
+      svn_stringbuf_t *text;
+      svn_stream_t *contents;
+
+      SVN_ERR(svn_fs_fs__get_contents(&contents, fs, block, FALSE,
+                                      scratch_pool));
+      SVN_ERR(svn_stringbuf_from_stream(&text, contents,
+                                        (apr_size_t)block->expanded_size,
+                                        scratch_pool));
+      SVN_ERR(svn_stream_close(contents));
+
+      /* Only the last block contains the terminator. */
+      if (lower < blocks->nelts)
+        svn_stringbuf_appendcstr(text, SVN_HASH_TERMINATOR "\n");
+
+      contents = svn_stream_from_stringbuf(text, scratch_pool);
+      SVN_ERR(read_dir_entries(&dir.entries, contents, FALSE, noderev->id,
+                               scratch_pool, scratch_pool));
+      dir.txn_filesize = SVN_INVALID_FILESIZE;
+
+      if (ffd->dir_cache)
+        SVN_ERR(svn_cache__set(ffd->dir_cache, &key, &dir, scratch_pool));
+
+      entry = svn_fs_fs__find_dir_entry(dir.entries, name, NULL);
+      if (entry)
+        *dirent = dirent_dup(entry, result_pool);
+    }
+
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *
 svn_fs_fs__rep_contents_dir_entry(svn_fs_dirent_t **dirent,
                                   svn_fs_t *fs,
@@ -2936,6 +4070,25 @@ svn_fs_fs__rep_contents_dir_entry(svn_fs_dirent_t **dirent,
       svn_fs_dirent_t *entry_copy = NULL;
       svn_fs_fs__dir_data_t dir;
 
+      /* Large committed directories may be indexed.  Then, there is no
+       * need to read all of it. */
+      if (   noderev->data_rep
+          && !svn_fs_fs__id_txn_used(&noderev->data_rep->txn_id))
+        {
+          apr_array_header_t *blocks;
+          apr_array_header_t *names;
+
+          SVN_ERR(svn_fs_fs__get_dir_index(&blocks, &names, fs,
+                                           noderev->data_rep, scratch_pool,
+                                           scratch_pool));
+          if (blocks)
+            return svn_error_trace(get_indexed_dir_entry(dirent, fs,
+                                                         noderev, blocks,
+                                                         names, name,
+                                                         result_pool,
+                                                         scratch_pool));
+        }
+
       /* Read in the directory contents. */
       SVN_ERR(get_dir_contents(&dir, fs, noderev, scratch_pool,
                                scratch_pool));
@@ -2951,12 +4104,7 @@ svn_fs_fs__rep_contents_dir_entry(svn_fs_dirent_t **dirent,
       /* find desired entry and return a copy in POOL, if found */
       entry = svn_fs_fs__find_dir_entry(dir.entries, name, NULL);
       if (entry)
-        {
-          entry_copy = apr_palloc(result_pool, sizeof(*entry_copy));
-          entry_copy->name = apr_pstrdup(result_pool, entry->name);
-          entry_copy->id = svn_fs_fs__id_copy(entry->id, result_pool);
-          entry_copy->kind = entry->kind;
-        }
+        entry_copy = dirent_dup(entry, result_pool);
 
       *dirent = entry_copy;
     }
@@ -3008,7 +4156,10 @@ svn_fs_fs__get_proplist(apr_hash_t **proplist_p,
           SVN_ERR(svn_cache__get((void **) proplist_p, &is_cached,
                                  ffd->properties_cache, &key, pool));
           if (is_cached)
-            return SVN_NO_ERROR;
+            return svn_error_trace(svn_fs__io_trace_item(
+                                     fs->io_trace, rep->revision,
+                                     rep->item_index, "props", TRUE, -1, -1,
+                                     pool));
         }
 
       proplist = apr_hash_make(pool);
@@ -3040,6 +4191,57 @@ svn_fs_fs__get_proplist(apr_hash_t **proplist_p,
   return SVN_NO_ERROR;
 }
 
+svn_error_t *
+svn_fs_fs__get_mergeinfo(svn_mergeinfo_t *mergeinfo,
+                         svn_fs_t *fs,
+                         node_revision_t *noderev,
+                         apr_pool_t *result_pool,
+                         apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  representation_t *rep = noderev->prop_rep;
+  pair_cache_key_t key = { 0 };
+  svn_boolean_t use_cache;
+  apr_hash_t *proplist;
+  svn_string_t *value;
+
+  /* Committed property reps never change, so the parsed mergeinfo can
+     be keyed by the rep's location, just like the property list itself.
+     The same rep is often shared by many node-revisions. */
+  use_cache = ffd->parsed_mergeinfo_cache && rep
+           && !svn_fs_fs__id_txn_used(&rep->txn_id)
+           && SVN_IS_VALID_REVNUM(rep->revision);
+  if (use_cache)
+    {
+      svn_boolean_t is_cached;
+
+      key.revision = rep->revision;
+      key.second = rep->item_index;
+      SVN_ERR(svn_cache__get((void **) mergeinfo, &is_cached,
+                             ffd->parsed_mergeinfo_cache, &key,
+                             result_pool));
+      if (is_cached)
+        return SVN_NO_ERROR;
+    }
+
+  SVN_ERR(svn_fs_fs__get_proplist(&proplist, fs, noderev, scratch_pool));
+  value = svn_hash_gets(proplist, SVN_PROP_MERGEINFO);
+  if (!value)
+    {
+      *mergeinfo = NULL;
+      return SVN_NO_ERROR;
+    }
+
+  /* Invalid mergeinfo is rare, so we don't bother caching parser
+     failures. */
+  SVN_ERR(svn_mergeinfo_parse(mergeinfo, value->data, result_pool));
+  if (use_cache)
+    SVN_ERR(svn_cache__set(ffd->parsed_mergeinfo_cache, &key, *mergeinfo,
+                           scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *
 svn_fs_fs__create_changes_context(svn_fs_fs__changes_context_t **context,
                                   svn_fs_t *fs,
@@ -3077,6 +4279,11 @@ svn_fs_fs__get_changes(apr_array_header_t **changes,
     {
       SVN_ERR(svn_cache__get((void **)&changes_list, &found,
                              ffd->changes_cache, &key, result_pool));
+      if (found)
+        SVN_ERR(svn_fs__io_trace_item(context->fs->io_trace,
+                                      context->revision, item_index,
+                                      "changes", TRUE, -1, -1,
+                                      scratch_pool));
     }
   else
     {
@@ -3156,6 +4363,14 @@ svn_fs_fs__get_changes(apr_array_header_t **changes,
           SVN_ERR(svn_io_file_get_offset(&changes_list->end_offset,
                                          context->revision_file->file,
                                          scratch_pool));
+          SVN_ERR(svn_fs__io_trace_item(context->fs->io_trace,
+                                        context->revision, item_index,
+                                        "changes", FALSE,
+                                        changes_offset + context->next_offset,
+                                        changes_list->end_offset
+                                          - changes_offset
+                                          - context->next_offset,
+                                        scratch_pool));
           changes_list->end_offset -= changes_offset;
           changes_list->start_offset = context->next_offset;
           changes_list->count = (*changes)->nelts;
@@ -3185,7 +4400,7 @@ svn_fs_fs__get_changes(apr_array_header_t **changes,
   context->eol = changes_list->eol;
 
   /* Close the revision file after we read all data. */
-  if (context->eol && context->revision_file)
+  if (context->eol && context->revision_file && !context->keep_revision_file)
     {
       SVN_ERR(svn_fs_fs__close_revision_file(context->revision_file));
       context->revision_file = NULL;
@@ -3388,6 +4603,11 @@ block_read_windows(svn_fs_fs__rep_header_t *rep_header,
   apr_off_t offset;
   window_cache_key_t key = { 0 };
 
+  /* Chunk lists and directory indexes are small and get read directly. */
+  if (   rep_header->type == svn_fs_fs__rep_chunked
+      || rep_header->type == svn_fs_fs__rep_dir_index)
+    return SVN_NO_ERROR;
+
   if (   (rep_header->type != svn_fs_fs__rep_plain
           && (!ffd->txdelta_window_cache || !ffd->raw_window_cache))
       || (rep_header->type == svn_fs_fs__rep_plain
@@ -3658,6 +4878,10 @@ block_read_noderev(node_revision_t **noderev_p,
   return SVN_NO_ERROR;
 }
 
+/* Server statistics on block_read().  Looked up on first use. */
+static svn_metrics__t *block_reads_metric = NULL;
+static svn_metrics__t *block_read_bytes_metric = NULL;
+
 /* Read the whole (e.g. 64kB) block containing ITEM_INDEX of REVISION in FS
  * and put all data into cache.  If necessary and depending on heuristics,
  * neighboring blocks may also get read.  The data is being read from
@@ -3721,6 +4945,18 @@ block_read(void **result,
       SVN_ERR(aligned_seek(fs, revision_file->file, &block_start, offset,
                            iterpool));
 
+      if (!block_reads_metric)
+        {
+          block_reads_metric
+            = svn_metrics__counter("svn_fsfs_block_reads_total", NULL,
+                                   "FSFS blocks read from rev / pack files.");
+          block_read_bytes_metric
+            = svn_metrics__counter("svn_fsfs_block_read_bytes_total", NULL,
+                                   "Bytes covered by FSFS block reads.");
+        }
+      svn_metrics__add(block_reads_metric, 1);
+      svn_metrics__add(block_read_bytes_metric, ffd->block_size);
+
       /* read all items from the block */
       for (i = 0; i < entries->nelts; ++i)
         {
@@ -3783,6 +5019,13 @@ block_read(void **result,
                     break;
                 }
 
+              SVN_ERR(svn_fs__io_trace_item(fs->io_trace,
+                                            entry->item.revision,
+                                            entry->item.number,
+                                            trace_item_type(entry->type),
+                                            FALSE, entry->offset,
+                                            entry->size, iterpool));
+
               if (is_result)
                 *result = item;
 
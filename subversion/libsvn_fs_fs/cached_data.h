@@ -51,6 +51,31 @@ svn_fs_fs__get_node_revision(node_revision_t **noderev_p,
                              apr_pool_t *result_pool,
                              apr_pool_t *scratch_pool);
 
+/* Set *ANCESTOR_P to the node-revision in FS that has COUNT predecessors
+   and lies on the predecessor chain of NODEREV.  COUNT must not exceed
+   the predecessor count of NODEREV.  Follow the skip-list pointers where
+   available, which takes a logarithmic number of reads.  Allocate the
+   result in RESULT_POOL and use SCRATCH_POOL for temporaries. */
+svn_error_t *
+svn_fs_fs__get_ancestor(node_revision_t **ancestor_p,
+                        svn_fs_t *fs,
+                        node_revision_t *noderev,
+                        int count,
+                        apr_pool_t *result_pool,
+                        apr_pool_t *scratch_pool);
+
+/* Set *NODEREVS to an array of node_revision_t * with the node-revisions
+   in FS for the svn_fs_id_t * in IDS, in the same order.  Look up all
+   committed node-revisions in the node-revision cache at once before
+   reading the remaining ones.  Allocate the result in RESULT_POOL and
+   use SCRATCH_POOL for temporaries. */
+svn_error_t *
+svn_fs_fs__get_node_revisions(apr_array_header_t **noderevs,
+                              svn_fs_t *fs,
+                              const apr_array_header_t *ids,
+                              apr_pool_t *result_pool,
+                              apr_pool_t *scratch_pool);
+
 /* Set *ROOT_ID to the node-id for the root of revision REV in
    filesystem FS.  Do any allocations in POOL. */
 svn_error_t *
@@ -105,6 +130,32 @@ svn_fs_fs__get_contents_from_file(svn_stream_t **contents_p,
                                   apr_off_t offset,
                                   apr_pool_t *pool);
 
+/* If the file representation REP in FS is stored as a list of chunks,
+   or the directory representation REP as an indexed list of blocks,
+   set *CHUNKS to the chunk representations (representation_t *) in
+   content order.  Otherwise, set *CHUNKS to NULL.  The chunks will be
+   fully qualified, i.e. refer to REP's revision or transaction where
+   applicable.  Allocate *CHUNKS in RESULT_POOL and use SCRATCH_POOL for
+   temporaries. */
+svn_error_t *
+svn_fs_fs__get_rep_chunks(apr_array_header_t **chunks,
+                          svn_fs_t *fs,
+                          representation_t *rep,
+                          apr_pool_t *result_pool,
+                          apr_pool_t *scratch_pool);
+
+/* Like svn_fs_fs__get_rep_chunks but only for directory representations
+   stored as indexed lists of blocks.  Also set *NAMES to the name of the
+   first entry (const char *) of each block.  These are strictly sorted.
+   Set *BLOCKS to NULL for all other representations. */
+svn_error_t *
+svn_fs_fs__get_dir_index(apr_array_header_t **blocks,
+                         apr_array_header_t **names,
+                         svn_fs_t *fs,
+                         representation_t *rep,
+                         apr_pool_t *result_pool,
+                         apr_pool_t *scratch_pool);
+
 /* Attempt to fetch the text representation of node-revision NODEREV as
    seen in filesystem FS and pass it along with the BATON to the PROCESSOR.
    Set *SUCCESS only of the data could be provided and the processing
@@ -129,6 +180,22 @@ svn_fs_fs__get_file_delta_stream(svn_txdelta_stream_t **stream_p,
                                  node_revision_t *target,
                                  apr_pool_t *pool);
 
+/* If the contents of the file TARGET in FS are stored as a delta against
+   the contents of the file SOURCE, using svndiff version MAX_VERSION or
+   older, set *SVNDIFF_P to a stream of that svndiff data, including its
+   header, and *LEN_P to its length.  Otherwise, set *SVNDIFF_P to NULL.
+   Allocate the stream in RESULT_POOL and use SCRATCH_POOL for temporary
+   allocations. */
+svn_error_t *
+svn_fs_fs__get_stored_delta(svn_stream_t **svndiff_p,
+                            svn_filesize_t *len_p,
+                            svn_fs_t *fs,
+                            node_revision_t *source,
+                            node_revision_t *target,
+                            int max_version,
+                            apr_pool_t *result_pool,
+                            apr_pool_t *scratch_pool);
+
 /* Set *ENTRIES to an apr_array_header_t of dirent structs that contain
    the directory entries of node-revision NODEREV in filesystem FS.  The
    returned table is allocated in RESULT_POOL and entries are sorted
@@ -170,6 +237,18 @@ svn_fs_fs__get_proplist(apr_hash_t **proplist,
                         node_revision_t *noderev,
                         apr_pool_t *pool);
 
+/* Set *MERGEINFO to the parsed svn:mergeinfo property of node-revision
+   NODEREV as seen in filesystem FS, or to NULL if NODEREV has no such
+   property.  Return SVN_ERR_MERGEINFO_PARSE_ERROR if the property value
+   is not valid mergeinfo.  Allocate *MERGEINFO in RESULT_POOL and use
+   SCRATCH_POOL for temporary allocations. */
+svn_error_t *
+svn_fs_fs__get_mergeinfo(svn_mergeinfo_t *mergeinfo,
+                         svn_fs_t *fs,
+                         node_revision_t *noderev,
+                         apr_pool_t *result_pool,
+                         apr_pool_t *scratch_pool);
+
 /* Create a changes retrieval context object in *RESULT_POOL and return it
  * in *CONTEXT.  It will allow svn_fs_fs__get_changes to fetch consecutive
  * blocks (one per invocation) from REV's changed paths list in FS. */
@@ -37,6 +37,7 @@
 #include "svn_pools.h"
 
 #include "private/svn_debug.h"
+#include "private/svn_fs_util.h"
 #include "private/svn_subr_private.h"
 
 /* Take the ORIGINAL string and replace all occurrences of ":" without
@@ -66,9 +67,9 @@ normalize_key_part(const char *original,
   return normalized->data;
 }
 
-/* *CACHE_TXDELTAS, *CACHE_FULLTEXTS, *CACHE_NODEPROPS flags will be set
-   according to FS->CONFIG. *CACHE_NAMESPACE receives the cache prefix to
-   use.
+/* *CACHE_TXDELTAS, *CACHE_FULLTEXTS, *CACHE_NODEPROPS and *CACHE_REVPROPS
+   flags will be set according to FS->CONFIG. *CACHE_NAMESPACE receives
+   the cache prefix to use.
 
    Use FS->pool for allocating the memcache and CACHE_NAMESPACE, and POOL
    for temporary allocations. */
@@ -77,6 +78,7 @@ read_config(const char **cache_namespace,
             svn_boolean_t *cache_txdeltas,
             svn_boolean_t *cache_fulltexts,
             svn_boolean_t *cache_nodeprops,
+            svn_boolean_t *cache_revprops,
             svn_fs_t *fs,
             apr_pool_t *pool)
 {
@@ -124,6 +126,17 @@ read_config(const char **cache_namespace,
     = svn_hash__get_bool(fs->config,
                          SVN_FS_CONFIG_FSFS_CACHE_NODEPROPS,
                          TRUE);
+
+  /* By default, share cached revprops between FS instances and keep them
+   * across sync barriers for as long as the repository-wide revprop
+   * generation does not change.  Revprops are always being cached within
+   * the same FS instance between barriers.  "2" ("enable if efficient")
+   * means the same as "yes", here.
+   */
+  *cache_revprops
+    = svn_hash__get_bool(fs->config,
+                         SVN_FS_CONFIG_FSFS_CACHE_REVPROPS,
+                         TRUE);
   return SVN_NO_ERROR;
 }
 
@@ -329,6 +342,9 @@ create_cache(svn_cache__t **cache_p,
                 cache_p, membuffer, serializer, deserializer,
                 klen, prefix, priority, FALSE, has_namespace,
                 result_pool, scratch_pool));
+
+      /* Don't let bulk scans through FS push out frequently used data. */
+      svn_cache__membuffer_set_bulk_hint(*cache_p, &fs->bulk_scan);
     }
   else if (pages)
     {
@@ -353,6 +369,7 @@ svn_fs_fs__initialize_caches(svn_fs_t *fs,
   fs_fs_data_t *ffd = fs->fsap_data;
   const char *prefix = apr_pstrcat(pool,
                                    "fsfs:", fs->uuid,
+                                   "/", ffd->instance_id,
                                    "/", normalize_key_part(fs->path, pool),
                                    ":",
                                    SVN_VA_NULL);
@@ -361,6 +378,7 @@ svn_fs_fs__initialize_caches(svn_fs_t *fs,
   svn_boolean_t cache_txdeltas;
   svn_boolean_t cache_fulltexts;
   svn_boolean_t cache_nodeprops;
+  svn_boolean_t cache_revprops;
   const char *cache_namespace;
   svn_boolean_t has_namespace;
 
@@ -369,14 +387,20 @@ svn_fs_fs__initialize_caches(svn_fs_t *fs,
                       &cache_txdeltas,
                       &cache_fulltexts,
                       &cache_nodeprops,
+                      &cache_revprops,
                       fs,
                       pool));
+  ffd->use_revprop_generation = cache_revprops;
 
   prefix = apr_pstrcat(pool, "ns:", cache_namespace, ":", prefix, SVN_VA_NULL);
   has_namespace = strlen(cache_namespace) > 0;
 
   membuffer = svn_cache__get_global_membuffer_cache();
 
+  /* Allow the contents of our caches to survive server restarts. */
+  if (membuffer)
+    SVN_ERR(svn_fs__register_cache_prefix(prefix, fs->path, pool));
+
   /* General rules for assigning cache priorities:
    *
    * - Data that can be reconstructed from other elements has low prio
@@ -525,7 +549,23 @@ svn_fs_fs__initialize_caches(svn_fs_t *fs,
                        sizeof(pair_cache_key_t),
                        apr_pstrcat(pool, prefix, "REVPROP", SVN_VA_NULL),
                        SVN_CACHE__MEMBUFFER_DEFAULT_PRIORITY,
-                       TRUE, /* contents is short-lived */
+                       !cache_revprops, /* short-lived unless shared */
+                       fs,
+                       no_handler,
+                       fs->pool, pool));
+
+  /* if enabled, cache the manifests of packed revprop shards */
+  SVN_ERR(create_cache(&(ffd->revprop_manifest_cache),
+                       NULL,
+                       membuffer,
+                       4, 1, /* ~8 kBytes / entry, capa for ~4 shards */
+                       /* Values are svn_stringbuf_t */
+                       NULL, NULL,
+                       sizeof(pair_cache_key_t),
+                       apr_pstrcat(pool, prefix, "REVPROP-MANIFEST",
+                                   SVN_VA_NULL),
+                       SVN_CACHE__MEMBUFFER_HIGH_PRIORITY,
+                       !cache_revprops, /* short-lived unless shared */
                        fs,
                        no_handler,
                        fs->pool, pool));
@@ -601,10 +641,26 @@ svn_fs_fs__initialize_caches(svn_fs_t *fs,
                            fs,
                            no_handler,
                            fs->pool, pool));
+
+      SVN_ERR(create_cache(&(ffd->parsed_mergeinfo_cache),
+                           NULL,
+                           membuffer,
+                           0, 0, /* Do not use the inprocess cache */
+                           svn_fs_fs__serialize_mergeinfo,
+                           svn_fs_fs__deserialize_mergeinfo,
+                           sizeof(pair_cache_key_t),
+                           apr_pstrcat(pool, prefix, "PARSED_MERGEINFO",
+                                       SVN_VA_NULL),
+                           SVN_CACHE__MEMBUFFER_DEFAULT_PRIORITY,
+                           has_namespace,
+                           fs,
+                           no_handler,
+                           fs->pool, pool));
     }
   else
     {
       ffd->properties_cache = NULL;
+      ffd->parsed_mergeinfo_cache = NULL;
     }
 
   /* if enabled, cache text deltas and their combinations */
@@ -124,6 +124,8 @@ copy_node_revision(node_revision_t *noderev,
   nr->kind = noderev->kind;
   if (noderev->predecessor_id)
     nr->predecessor_id = svn_fs_fs__id_copy(noderev->predecessor_id, pool);
+  if (noderev->skip_id)
+    nr->skip_id = svn_fs_fs__id_copy(noderev->skip_id, pool);
   nr->predecessor_count = noderev->predecessor_count;
   if (noderev->copyfrom_path)
     nr->copyfrom_path = apr_pstrdup(pool, noderev->copyfrom_path);
@@ -498,6 +500,21 @@ svn_fs_fs__dag_get_proplist(apr_hash_t **proplist_p,
   return SVN_NO_ERROR;
 }
 
+svn_error_t *
+svn_fs_fs__dag_get_mergeinfo(svn_mergeinfo_t *mergeinfo,
+                             dag_node_t *node,
+                             apr_pool_t *result_pool,
+                             apr_pool_t *scratch_pool)
+{
+  node_revision_t *noderev;
+
+  SVN_ERR(get_node_revision(&noderev, node));
+
+  return svn_error_trace(svn_fs_fs__get_mergeinfo(mergeinfo, node->fs,
+                                                  noderev, result_pool,
+                                                  scratch_pool));
+}
+
 svn_error_t *
 svn_fs_fs__dag_has_props(svn_boolean_t *has_props,
                          dag_node_t *node,
@@ -754,6 +771,7 @@ svn_fs_fs__dag_clone_child(dag_node_t **child_p,
 
       noderev->predecessor_id = svn_fs_fs__id_copy(cur_entry->id, pool);
       noderev->predecessor_count++;
+      noderev->skip_id = NULL;
       noderev->created_path = svn_fspath__join(parent_path, name, pool);
 
       SVN_ERR(svn_fs_fs__create_successor(&new_node_id, fs, cur_entry->id,
@@ -1002,6 +1020,33 @@ svn_fs_fs__dag_get_file_delta_stream(svn_txdelta_stream_t **stream_p,
 }
 
 
+svn_error_t *
+svn_fs_fs__dag_get_stored_delta(svn_stream_t **svndiff_p,
+                                svn_filesize_t *len_p,
+                                dag_node_t *source,
+                                dag_node_t *target,
+                                int max_version,
+                                apr_pool_t *result_pool,
+                                apr_pool_t *scratch_pool)
+{
+  node_revision_t *src_noderev;
+  node_revision_t *tgt_noderev;
+
+  /* Make sure our nodes are files. */
+  if (source->kind != svn_node_file || target->kind != svn_node_file)
+    return svn_error_createf
+      (SVN_ERR_FS_NOT_FILE, NULL,
+       "Attempted to get textual contents of a *non*-file node");
+
+  SVN_ERR(get_node_revision(&src_noderev, source));
+  SVN_ERR(get_node_revision(&tgt_noderev, target));
+
+  return svn_fs_fs__get_stored_delta(svndiff_p, len_p, target->fs,
+                                     src_noderev, tgt_noderev, max_version,
+                                     result_pool, scratch_pool);
+}
+
+
 svn_error_t *
 svn_fs_fs__dag_try_process_file_contents(svn_boolean_t *success,
                                          dag_node_t *node,
@@ -1091,6 +1136,33 @@ svn_fs_fs__dag_get_edit_stream(svn_stream_t **contents,
 
 
 
+svn_error_t *
+svn_fs_fs__dag_set_shared_contents(dag_node_t *file,
+                                   representation_t *rep,
+                                   apr_pool_t *pool)
+{
+  node_revision_t *noderev;
+
+  /* Make sure our node is a file. */
+  if (file->kind != svn_node_file)
+    return svn_error_createf
+      (SVN_ERR_FS_NOT_FILE, NULL,
+       "Attempted to set textual contents of a *non*-file node");
+
+  /* Make sure our node is mutable. */
+  if (! svn_fs_fs__dag_check_mutable(file))
+    return svn_error_createf
+      (SVN_ERR_FS_NOT_MUTABLE, NULL,
+       "Attempted to set textual contents of an immutable node");
+
+  /* Get the node revision. */
+  SVN_ERR(get_node_revision(&noderev, file));
+
+  return svn_error_trace(svn_fs_fs__set_shared_contents(file->fs, noderev,
+                                                        rep, pool));
+}
+
+
 svn_error_t *
 svn_fs_fs__dag_finalize_edits(dag_node_t *file,
                               const svn_checksum_t *checksum,
@@ -1267,6 +1339,7 @@ svn_fs_fs__dag_copy(dag_node_t *to_node,
          source. */
       to_noderev->predecessor_id = svn_fs_fs__id_copy(src_id, pool);
       to_noderev->predecessor_count++;
+      to_noderev->skip_id = NULL;
       to_noderev->created_path =
         svn_fspath__join(svn_fs_fs__dag_get_created_path(to_node), entry,
                      pool);
@@ -1422,6 +1495,7 @@ svn_fs_fs__dag_update_ancestry(dag_node_t *target,
   target_noderev->predecessor_id = source->id;
   target_noderev->predecessor_count = source_noderev->predecessor_count;
   target_noderev->predecessor_count++;
+  target_noderev->skip_id = NULL;
 
   return svn_fs_fs__put_node_revision(target->fs, target->id, target_noderev,
                                       FALSE, pool);
@@ -28,6 +28,7 @@
 #include "private/svn_cache.h"
 
 #include "id.h"
+#include "fs.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -177,6 +178,18 @@ svn_error_t *svn_fs_fs__dag_get_proplist(apr_hash_t **proplist_p,
                                          dag_node_t *node,
                                          apr_pool_t *pool);
 
+/* Set *MERGEINFO to the parsed svn:mergeinfo property of NODE, or to
+   NULL if NODE does not have that property.  Return
+   SVN_ERR_MERGEINFO_PARSE_ERROR if the property value is invalid.
+
+   Allocate *MERGEINFO in RESULT_POOL and use SCRATCH_POOL for temporary
+   allocations.
+ */
+svn_error_t *svn_fs_fs__dag_get_mergeinfo(svn_mergeinfo_t *mergeinfo,
+                                          dag_node_t *node,
+                                          apr_pool_t *result_pool,
+                                          apr_pool_t *scratch_pool);
+
 /* Set *HAS_PROPS to TRUE if NODE has properties. Use SCRATCH_POOL
    for temporary allocations */
 svn_error_t *svn_fs_fs__dag_has_props(svn_boolean_t *has_props,
@@ -439,6 +452,23 @@ svn_fs_fs__dag_get_file_delta_stream(svn_txdelta_stream_t **stream_p,
                                      dag_node_t *target,
                                      apr_pool_t *pool);
 
+/* Set *SVNDIFF_P to a stream of the svndiff data stored for the contents
+   of TARGET, if that is a delta against the contents of SOURCE written
+   with svndiff version MAX_VERSION or older, and *LEN_P to its length.
+   Otherwise, set *SVNDIFF_P to NULL.
+
+   Allocate the stream in RESULT_POOL and use SCRATCH_POOL for temporary
+   allocations.
+ */
+svn_error_t *
+svn_fs_fs__dag_get_stored_delta(svn_stream_t **svndiff_p,
+                                svn_filesize_t *len_p,
+                                dag_node_t *source,
+                                dag_node_t *target,
+                                int max_version,
+                                apr_pool_t *result_pool,
+                                apr_pool_t *scratch_pool);
+
 /* Return a generic writable stream in *CONTENTS with which to set the
    contents of FILE.  Allocate the stream in POOL.
 
@@ -452,6 +482,17 @@ svn_error_t *svn_fs_fs__dag_get_edit_stream(svn_stream_t **contents,
                                             apr_pool_t *pool);
 
 
+/* Set the contents of the mutable FILE to the existing representation
+   REP, as found by svn_fs_fs__find_rep_by_sha1().  Any previous edits on
+   the file will be replaced.
+
+   Use POOL for all allocations.
+ */
+svn_error_t *svn_fs_fs__dag_set_shared_contents(dag_node_t *file,
+                                                representation_t *rep,
+                                                apr_pool_t *pool);
+
+
 /* Signify the completion of edits to FILE made using the stream
    returned by svn_fs_fs__dag_get_edit_stream, allocating from POOL.
 
@@ -47,6 +47,7 @@
 #include "verify.h"
 #include "svn_private_config.h"
 #include "private/svn_fs_util.h"
+#include "private/svn_io_private.h"
 
 #include "../libsvn_fs/fs-loader.h"
 
@@ -123,6 +124,35 @@ fs_serialized_init(svn_fs_t *fs, apr_pool_t *common_pool, apr_pool_t *pool)
          transaction list and free transaction pointer. */
       SVN_ERR(svn_mutex__init(&ffsd->txn_list_lock, TRUE, common_pool));
 
+      /* Concurrent commits may be grouped. */
+      SVN_ERR(svn_fs_fs__create_commit_queue(&ffsd->commit_queue,
+                                             common_pool));
+
+      /* Speed up rep-cache lookups. */
+      SVN_ERR(svn_fs_fs__create_rep_filter(&ffsd->rep_filter, common_pool));
+
+      /* Lock log contents, if used. */
+      SVN_ERR(svn_fs_fs__create_lock_index(&ffsd->lock_index, common_pool));
+
+      /* Revprop caches shared between FS instances. */
+      SVN_ERR(svn_fs_fs__create_revprop_generation(&ffsd->revprop_generation,
+                                                   common_pool));
+
+      /* Hot revision paths get resolved only once per process. */
+      SVN_ERR(svn_fs_fs__create_shared_dag_cache(&ffsd->dag_cache,
+                                                 common_pool));
+
+      /* HEAD may be looked up without reading 'current'. */
+      SVN_ERR(svn_fs_fs__create_shared_youngest(&ffsd->shared_youngest,
+                                                common_pool));
+
+      /* Pack files are immutable and need to be mapped only once. */
+      SVN_ERR(svn_fs_fs__create_shared_rev_data(&ffsd->rev_data,
+                                                common_pool));
+
+      /* Contents may be verified after commit. */
+      SVN_ERR(svn_fs_fs__create_verifier(&ffsd->verifier, common_pool));
+
       key = apr_pstrdup(common_pool, key);
       status = apr_pool_userdata_set(ffsd, key, NULL, common_pool);
       if (status)
@@ -279,7 +309,10 @@ static fs_vtable_t fs_vtable = {
   fs_info,
   svn_fs_fs__verify_root,
   fs_freeze,
-  fs_set_errcall
+  fs_set_errcall,
+  svn_fs_fs__paths_changed_range,
+  svn_fs_fs__copy_revisions,
+  svn_fs_fs__get_verified_revisions
 };
 
 
@@ -463,6 +496,39 @@ fs_verify(svn_fs_t *fs, const char *path,
                            cancel_func, cancel_baton, pool);
 }
 
+/* Baton type used with open_fs_instance(). */
+typedef struct open_fs_instance_baton_t
+{
+  /* The FS instance to clone. */
+  svn_fs_t *fs;
+
+  /* The parameters passed to fs_pack(). */
+  svn_mutex__t *common_pool_lock;
+  apr_pool_t *common_pool;
+} open_fs_instance_baton_t;
+
+/* Implements svn_fs_fs__open_fs_func_t.  Open a new instance of the
+   repository given by the open_fs_instance_baton_t in BATON. */
+static svn_error_t *
+open_fs_instance(svn_fs_t **fs,
+                 void *baton,
+                 apr_pool_t *result_pool)
+{
+  open_fs_instance_baton_t *b = baton;
+  svn_fs_t *new_fs = apr_pcalloc(result_pool, sizeof(*new_fs));
+
+  new_fs->pool = result_pool;
+  new_fs->warning = b->fs->warning;
+  new_fs->warning_baton = b->fs->warning_baton;
+  new_fs->config = b->fs->config;
+
+  SVN_ERR(fs_open(new_fs, b->fs->path, b->common_pool_lock, result_pool,
+                  b->common_pool));
+
+  *fs = new_fs;
+  return SVN_NO_ERROR;
+}
+
 static svn_error_t *
 fs_pack(svn_fs_t *fs,
         const char *path,
@@ -474,8 +540,16 @@ fs_pack(svn_fs_t *fs,
         apr_pool_t *pool,
         apr_pool_t *common_pool)
 {
+  open_fs_instance_baton_t open_baton;
+
   SVN_ERR(fs_open(fs, path, common_pool_lock, pool, common_pool));
-  return svn_fs_fs__pack(fs, 0, notify_func, notify_baton,
+
+  open_baton.fs = fs;
+  open_baton.common_pool_lock = common_pool_lock;
+  open_baton.common_pool = common_pool;
+
+  return svn_fs_fs__pack(fs, 0, open_fs_instance, &open_baton,
+                         notify_func, notify_baton,
                          cancel_func, cancel_baton, pool);
 }
 
@@ -625,6 +699,8 @@ svn_fs_fs__init(const svn_version_t *loader_version,
                              loader_version->major);
   SVN_ERR(svn_ver_check_list2(fs_version(), checklist, svn_ver_equal));
 
+  SVN_ERR(svn_io__batch_fsync_init(common_pool));
+
   *vtable = &library_vtable;
   return SVN_NO_ERROR;
 }
@@ -64,12 +64,22 @@ extern "C" {
 #define PATH_TXN_CURRENT      "txn-current"      /* File with next txn key */
 #define PATH_TXN_CURRENT_LOCK "txn-current-lock" /* Lock for txn-current */
 #define PATH_LOCKS_DIR        "locks"            /* Directory of locks */
+#define PATH_LOCK_LOG         "lock-log"         /* Lock log (in locks dir) */
 #define PATH_MIN_UNPACKED_REV "min-unpacked-rev" /* Oldest revision which
                                                     has not been packed. */
 #define PATH_REVPROP_GENERATION "revprop-generation"
                                                  /* Current revprop generation*/
+#define PATH_REVPROP_COUNTER  "revprop-counter"  /* Shared revprop generation
+                                                    counter */
 #define PATH_MANIFEST         "manifest"         /* Manifest file name */
 #define PATH_PACKED           "pack"             /* Packed revision data file */
+#define PATH_REPACK_TEMP      "pack.tmp"         /* Pack file being rebuilt */
+#define PATH_RESHARD_TEMP     ".reshard"         /* Suffix of the revs and
+                                                    revprops dirs being
+                                                    rebuilt by reshard */
+#define PATH_RESHARD_OLD      ".old"             /* Suffix of the revs and
+                                                    revprops dirs replaced
+                                                    by reshard */
 #define PATH_EXT_PACKED_SHARD ".pack"            /* Extension for packed
                                                     shards */
 #define PATH_EXT_L2P_INDEX    ".l2p"             /* extension of the log-
@@ -78,6 +88,8 @@ extern "C" {
                                                     to-log index */
 /* If you change this, look at tests/svn_test_fs.c(maybe_install_fsfs_conf) */
 #define PATH_CONFIG           "fsfs.conf"        /* Configuration */
+#define PATH_VERIFY_LOG       "verify-log"       /* Results of verifications
+                                                    after commit */
 
 /* Names of special files and file extensions for transactions */
 #define PATH_CHANGES       "changes"       /* Records changes made so far */
@@ -102,11 +114,16 @@ extern "C" {
 #define CONFIG_OPTION_FAIL_STOP          "fail-stop"
 #define CONFIG_SECTION_REP_SHARING       "rep-sharing"
 #define CONFIG_OPTION_ENABLE_REP_SHARING "enable-rep-sharing"
+#define CONFIG_OPTION_CHUNKED_REP_THRESHOLD "chunked-rep-threshold"
+#define CONFIG_OPTION_REP_CACHE_WAL      "rep-cache-wal"
+#define CONFIG_OPTION_REP_CACHE_BATCH_SIZE "rep-cache-batch-size"
 #define CONFIG_SECTION_DELTIFICATION     "deltification"
 #define CONFIG_OPTION_ENABLE_DIR_DELTIFICATION   "enable-dir-deltification"
 #define CONFIG_OPTION_ENABLE_PROPS_DELTIFICATION "enable-props-deltification"
 #define CONFIG_OPTION_MAX_DELTIFICATION_WALK     "max-deltification-walk"
 #define CONFIG_OPTION_MAX_LINEAR_DELTIFICATION   "max-linear-deltification"
+#define CONFIG_OPTION_SAMPLE_DELTA_BASES         "sample-delta-bases"
+#define CONFIG_OPTION_ANCESTOR_SKIP_POINTERS     "ancestor-skip-pointers"
 #define CONFIG_OPTION_COMPRESSION_LEVEL  "compression-level"
 #define CONFIG_SECTION_PACKED_REVPROPS   "packed-revprops"
 #define CONFIG_OPTION_REVPROP_PACK_SIZE  "revprop-pack-size"
@@ -115,10 +132,20 @@ extern "C" {
 #define CONFIG_OPTION_BLOCK_SIZE         "block-size"
 #define CONFIG_OPTION_L2P_PAGE_SIZE      "l2p-page-size"
 #define CONFIG_OPTION_P2L_PAGE_SIZE      "p2l-page-size"
+#define CONFIG_OPTION_PREFETCH_DELTA_CHAIN "prefetch-delta-chain"
+#define CONFIG_OPTION_MMAP_PACKED_FILES  "mmap-packed-files"
+#define CONFIG_OPTION_GROUP_COMMIT       "group-commit"
+#define CONFIG_OPTION_SHARED_YOUNGEST_DIR "shared-youngest-dir"
+#define CONFIG_OPTION_TXN_STAGING_SIZE   "txn-staging-size"
 #define CONFIG_SECTION_DEBUG             "debug"
 #define CONFIG_OPTION_PACK_AFTER_COMMIT  "pack-after-commit"
 #define CONFIG_OPTION_VERIFY_BEFORE_COMMIT "verify-before-commit"
+#define CONFIG_OPTION_VERIFY_AFTER_COMMIT "verify-after-commit"
 #define CONFIG_OPTION_COMPRESSION        "compression"
+#define CONFIG_SECTION_PACK              "pack"
+#define CONFIG_OPTION_PACK_JOBS          "jobs"
+#define CONFIG_SECTION_HOTCOPY           "hotcopy"
+#define CONFIG_OPTION_HOTCOPY_JOBS       "jobs"
 
 /* The format number of this filesystem.
    This is independent of the repository format number, and
@@ -188,6 +215,37 @@ extern "C" {
 /* The minimum format number that supports svndiff version 2. */
 #define SVN_FS_FS__MIN_SVNDIFF2_FORMAT 8
 
+/* The minimum format number that supports the "deltas" format option,
+   i.e. svndiff version 3 with large delta windows. */
+#define SVN_FS_FS__MIN_LARGE_DELTA_WINDOWS_FORMAT 8
+
+/* The minimum format number that supports the "reps" format option,
+   i.e. file representations stored as lists of chunks. */
+#define SVN_FS_FS__MIN_CHUNKED_REPS_FORMAT 8
+
+/* Files smaller than this are never stored as chunked representations.
+   Matches the largest chunk that the chunker will produce. */
+#define SVN_FS_FS__CHUNKED_REP_MIN_THRESHOLD 0x40000
+
+/* The minimum format number that supports the "dirs" format option,
+   i.e. directory representations stored as indexed lists of blocks. */
+#define SVN_FS_FS__MIN_INDEXED_DIRS_FORMAT 8
+
+/* Directories whose listing is smaller than this are never indexed.
+   That is a few thousand entries. */
+#define SVN_FS_FS__INDEXED_DIR_MIN_SIZE 0x40000
+
+/* The minimum format number that supports the "compression" format
+   option, i.e. svndiff version 4 with Zstandard compression. */
+#define SVN_FS_FS__MIN_ZSTD_FORMAT 8
+
+/* The minimum format number that supports the "locks" format option,
+   i.e. all locks stored in a single lock log. */
+#define SVN_FS_FS__MIN_LOCK_LOG_FORMAT 8
+
+/* Compression level used for "compression = zstd". */
+#define SVN_FS_FS__ZSTD_COMPRESSION_LEVEL_DEFAULT 3
+
 /* The minimum format number that supports the special notation ("-")
    for optional values that are not present in the representation strings,
    such as SHA1 or the uniquifier.  For example:
@@ -234,11 +292,46 @@ typedef struct fs_fs_shared_txn_data_t
      a non-recursive mutex. */
   svn_boolean_t being_written;
 
+  /* If not NULL, the transaction is being staged in memory.  This maps
+     the paths of its node revision and changes files, which have not
+     been written to disk, to their svn_stringbuf_t * contents. */
+  apr_hash_t *staged_files;
+
+  /* Total size of the contents in STAGED_FILES. */
+  apr_size_t staged_size;
+
+  /* Pool for STAGED_FILES; a subpool of POOL. */
+  apr_pool_t *staged_pool;
+
   /* The pool in which this object has been allocated; a subpool of the
      common pool. */
   apr_pool_t *pool;
 } fs_fs_shared_txn_data_t;
 
+/* Queue of commits waiting to become part of a group commit.
+   See svn_fs_fs__commit(). */
+typedef struct fs_fs_commit_queue_t fs_fs_commit_queue_t;
+
+/* Probabilistic filter over the keys in rep-cache.db.
+   See svn_fs_fs__get_rep_reference(). */
+typedef struct fs_fs_rep_filter_t fs_fs_rep_filter_t;
+
+/* In-memory index of the lock log.  See lock.c. */
+typedef struct fs_fs_lock_index_t fs_fs_lock_index_t;
+
+/* Thread verifying the contents of new revisions.  See verify.c. */
+typedef struct fs_fs_verifier_t fs_fs_verifier_t;
+
+/* Memory-mapped revprop generation counter.  See revprops.c. */
+typedef struct fs_fs_revprop_generation_t fs_fs_revprop_generation_t;
+
+/* DAG node cache for revision roots shared by all svn_fs_t instances
+   of a repository.  See tree.c. */
+typedef struct fs_fs_shared_dag_cache_t fs_fs_shared_dag_cache_t;
+
+/* Access to the youngest revision published between processes. */
+typedef struct fs_fs_shared_youngest_t fs_fs_shared_youngest_t;
+
 /* Private FSFS-specific data shared between all svn_fs_t objects that
    relate to a particular filesystem, as identified by filesystem UUID.
    Objects of this type are allocated in the common pool. */
@@ -275,6 +368,48 @@ typedef struct fs_fs_shared_data_t
      txn-current file. */
   svn_mutex__t *txn_current_lock;
 
+  /* Commits waiting for the repository write lock as part of a group
+     commit.  It comes with its own lock, which must be acquired after
+     any of the above and never be held while acquiring them.  NULL if
+     APR has been built without thread support. */
+  fs_fs_commit_queue_t *commit_queue;
+
+  /* In-memory filter telling which SHA1s are definitely not in the
+     rep-cache.  It comes with its own lock, which is subject to the same
+     rules as the COMMIT_QUEUE lock.  The two are never held together. */
+  fs_fs_rep_filter_t *rep_filter;
+
+  /* Contents of the lock log as far as we have read it, if the repository
+     uses one.  It comes with its own lock, which may be acquired while
+     holding the repository write lock but not the other way around. */
+  fs_fs_lock_index_t *lock_index;
+
+  /* Access to the repository-wide revprop generation counter.  It comes
+     with its own lock, which never gets held while acquiring any other. */
+  fs_fs_revprop_generation_t *revprop_generation;
+
+  /* Immutable DAG nodes of revision roots, looked up before the
+     per-svn_fs_t DAG caches.  It comes with its own lock, which never
+     gets held while acquiring any other. */
+  fs_fs_shared_dag_cache_t *dag_cache;
+
+  /* The youngest revision as published by the processes on this host.
+     It comes with its own lock, which never gets held while acquiring
+     any other. */
+  fs_fs_shared_youngest_t *shared_youngest;
+
+  /* Memory mappings and footers of the pack files, reused by all
+     svn_fs_t instances instead of being created for each of them.  It
+     comes with its own lock, which never gets held while acquiring any
+     other. */
+  fs_fs_shared_rev_data_t *rev_data;
+
+  /* Verifies the contents of the revisions committed by this process in
+     the background.  It comes with its own lock, which never gets held
+     while acquiring any other.  NULL if APR has been built without thread
+     support. */
+  fs_fs_verifier_t *verifier;
+
   /* The common pool, under which this object is allocated, subpools
      of which are used to allocate the transaction objects. */
   apr_pool_t *common_pool;
@@ -315,7 +450,8 @@ typedef enum compression_type_t
 {
   compression_type_none,
   compression_type_zlib,
-  compression_type_lz4
+  compression_type_lz4,
+  compression_type_zstd
 } compression_type_t;
 
 /* Private (non-shared) FSFS-specific data for each svn_fs_t object.
@@ -333,6 +469,30 @@ typedef struct fs_fs_data_t
      physical addressing. */
   svn_boolean_t use_log_addressing;
 
+  /* If set, deltas get written as svndiff3 using large, sliding windows.
+     Set by the "deltas" format option. */
+  svn_boolean_t large_delta_windows;
+
+  /* If set, large file contents may be stored as lists of chunks.
+     Set by the "reps" format option. */
+  svn_boolean_t chunked_reps;
+
+  /* If set, large directories may be stored as indexed lists of blocks.
+     Set by the "dirs" format option. */
+  svn_boolean_t indexed_dirs;
+
+  /* If set, deltas may be written as Zstandard compressed svndiff4.
+     Set by the "compression" format option. */
+  svn_boolean_t zstd_compression;
+
+  /* If set, locks are stored in a lock log instead of digest files.
+     Set by the "locks" format option. */
+  svn_boolean_t lock_log;
+
+  /* Files of at least this many bytes will be stored as chunked reps.
+     Only used if CHUNKED_REPS has been set.  0 disables chunking. */
+  apr_int64_t chunked_rep_threshold;
+
   /* Rev / pack file read granularity in bytes. */
   apr_int64_t block_size;
 
@@ -343,10 +503,36 @@ typedef struct fs_fs_data_t
    * index page. */
   apr_int64_t p2l_page_size;
 
+  /* Maximum number of shards to pack concurrently. */
+  int pack_jobs;
+
+  /* Maximum number of shards to copy concurrently during hotcopy. */
+  int hotcopy_jobs;
+
   /* If set, parse and cache *all* data of each block that we read
    * (not just the one bit that we need, atm). */
   svn_boolean_t use_block_read;
 
+  /* If set, read the first delta windows of all reps in a delta chain
+   * in file order before combining them. */
+  svn_boolean_t prefetch_delta_chain;
+
+  /* If set, map pack files into memory for reading. */
+  svn_boolean_t mmap_packed_files;
+
+  /* Whether concurrent commits from the same process shall be written
+     under a single write lock and fsync barrier. */
+  svn_boolean_t group_commit;
+
+  /* Local directory in which the processes on this host share the
+     youngest revision.  NULL, if they don't. */
+  const char *shared_youngest_dir;
+
+  /* Maximum size in bytes of the node revisions and changes of
+     transactions kept in memory.  0, if transactions are only staged
+     on disk. */
+  apr_size_t txn_staging_size;
+
   /* The revision that was youngest, last time we checked. */
   svn_revnum_t youngest_rev_cache;
 
@@ -384,14 +570,26 @@ typedef struct fs_fs_data_t
      If this is 0, a new unique prefix must be chosen. */
   apr_uint64_t revprop_prefix;
 
+  /* Whether to bind revprop cache entries to the repository-wide revprop
+     generation, if available, instead of a unique per-instance prefix. */
+  svn_boolean_t use_revprop_generation;
+
   /* Revision property cache.  Maps from (rev,prefix) to apr_hash_t.
      Unparsed svn_string_t representations of the serialized hash
      will be written to the cache but the getter returns apr_hash_t. */
   svn_cache__t *revprop_cache;
 
+  /* Packed revprop manifest cache.  Maps from (first rev in shard,prefix)
+     to the svn_stringbuf_t contents of the shard's manifest file. */
+  svn_cache__t *revprop_manifest_cache;
+
   /* Node properties cache.  Maps from rep key to apr_hash_t. */
   svn_cache__t *properties_cache;
 
+  /* Parsed svn:mergeinfo cache.  Maps from the rep key of a property list
+     to the svn_mergeinfo_t stored in it. */
+  svn_cache__t *parsed_mergeinfo_cache;
+
   /* Pack manifest cache; a cache mapping (svn_revnum_t) shard number to
      a manifest; and a manifest is a mapping from (svn_revnum_t) revision
      number offset within a shard to (apr_off_t) byte-offset in the
@@ -473,6 +671,21 @@ typedef struct fs_fs_data_t
    * and allowed by the configuration. */
   svn_boolean_t rep_sharing_allowed;
 
+  /* Whether rep-cache.db shall use write-ahead logging. */
+  svn_boolean_t rep_cache_wal;
+
+  /* Number of new rep-cache entries to collect before writing them to
+   * the database.  0 writes them at the end of each commit. */
+  int rep_cache_batch_size;
+
+  /* New rep-cache entries (representation_t *) not written yet and the
+   * same entries keyed by their SHA1 digest.  Both are allocated in
+   * REP_QUEUE_POOL, which is NULL until we queue the first entry.
+   * See svn_fs_fs__add_rep_references(). */
+  apr_array_header_t *rep_queue;
+  apr_hash_t *rep_queue_hash;
+  apr_pool_t *rep_queue_pool;
+
   /* File size limit in bytes up to which multiple revprops shall be packed
    * into a single file. */
   apr_int64_t revprop_pack_size;
@@ -493,10 +706,19 @@ typedef struct fs_fs_data_t
    * deltification history after which skip deltas will be used. */
   apr_int64_t max_linear_deltification;
 
+  /* Whether to pick the delta base for file contents among several
+   * candidates by comparing the delta sizes for a sample of the data. */
+  svn_boolean_t sample_delta_bases;
+
+  /* Whether new node-revisions record a skip-list pointer to one of
+   * their older ancestors. */
+  svn_boolean_t ancestor_skip_pointers;
+
   /* Compression type to use with txdelta storage format in new revs. */
   compression_type_t delta_compression_type;
 
-  /* Compression level (currently, only used with compression_type_zlib). */
+  /* Compression level (only used with compression_type_zlib and
+     compression_type_zstd). */
   int delta_compression_level;
 
   /* Pack after every commit. */
@@ -505,6 +727,10 @@ typedef struct fs_fs_data_t
   /* Verify each new revision before commit. */
   svn_boolean_t verify_before_commit;
 
+  /* Verify the structure of each new revision before commit and its
+     contents in the background after commit. */
+  svn_boolean_t verify_after_commit;
+
   /* Per-instance filesystem ID, which provides an additional level of
      uniqueness for filesystems that share the same UUID, but should
      still be distinguishable (e.g. backups produced by svn_fs_hotcopy()
@@ -624,6 +850,12 @@ typedef struct node_revision_t
      A difference from the BDB backend is that it cannot be -1. */
   int predecessor_count;
 
+  /* The ancestor whose predecessor count is PREDECESSOR_COUNT with the
+     lowest set bit cleared.  NULL if that ancestor is the immediate
+     predecessor or if no pointer has been recorded.  Never set for
+     mutable node revisions. */
+  const svn_fs_id_t *skip_id;
+
   /* representation key for this node's properties.  may be NULL if
      there are no properties.  */
   representation_t *prop_rep;
@@ -674,6 +906,10 @@ typedef struct svn_fs_fs__changes_context_t
   /* Pool to create REVISION_FILE in. */
   apr_pool_t *rev_file_pool;
 
+  /* If set, REVISION_FILE has been provided by the creator of this context
+     and must not be closed here. */
+  svn_boolean_t keep_revision_file;
+
   /* Index of the next change to fetch. */
   apr_size_t next;
 
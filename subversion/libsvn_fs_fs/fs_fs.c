@@ -37,6 +37,7 @@
 #include "cached_data.h"
 #include "id.h"
 #include "index.h"
+#include "lock.h"
 #include "rep-cache.h"
 #include "revprops.h"
 #include "transaction.h"
@@ -45,6 +46,7 @@
 
 #include "private/svn_fs_util.h"
 #include "private/svn_io_private.h"
+#include "private/svn_metrics.h"
 #include "private/svn_string_private.h"
 #include "private/svn_subr_private.h"
 #include "../libsvn_fs/fs-loader.h"
@@ -111,12 +113,25 @@ svn_fs_fs__path_current(svn_fs_t *fs, apr_pool_t *pool)
 
 
 
+/* Time spent waiting for FS lock files, for server statistics.
+   Looked up on first use. */
+static svn_metrics__t *lock_wait_metric = NULL;
+
 /* Get a lock on empty file LOCK_FILENAME, creating it in POOL. */
 static svn_error_t *
 get_lock_on_filesystem(const char *lock_filename,
                        apr_pool_t *pool)
 {
-  return svn_error_trace(svn_io__file_lock_autocreate(lock_filename, pool));
+  apr_time_t start = apr_time_now();
+  svn_error_t *err = svn_io__file_lock_autocreate(lock_filename, pool);
+
+  if (!lock_wait_metric)
+    lock_wait_metric
+      = svn_metrics__histogram("svn_fsfs_write_lock_wait_seconds", NULL,
+                               "Time spent acquiring FSFS lock files.");
+  svn_metrics__observe(lock_wait_metric, apr_time_now() - start);
+
+  return svn_error_trace(err);
 }
 
 /* Reset the HAS_WRITE_LOCK member in the FFD given as BATON_VOID.
@@ -208,10 +223,12 @@ with_some_lock_file(with_lock_baton_t *baton)
         }
 
       /* nobody else will modify the repo state
-         => read HEAD & pack info once */
+         => read HEAD, pack info and shard layout once */
       if (baton->is_inner_most_lock)
         {
           if (ffd->format >= SVN_FS_FS__MIN_PACKED_FORMAT)
+            err = svn_fs_fs__read_format_file(fs, pool);
+          if (!err && ffd->format >= SVN_FS_FS__MIN_PACKED_FORMAT)
             err = svn_fs_fs__update_min_unpacked_rev(fs, pool);
           if (!err)
             err = get_youngest(&ffd->youngest_rev_cache, fs, pool);
@@ -464,12 +481,27 @@ check_format(int format)
    will be set to zero if a linear scheme should be used.
    *USE_LOG_ADDRESSIONG is obtained from the 'addressing' format option,
    and will be set to FALSE for physical addressing.
+   *LARGE_DELTA_WINDOWS is obtained from the 'deltas' format option,
+   and will be set to FALSE for standard delta windows.
+   *CHUNKED_REPS is obtained from the 'reps' format option, and will be
+   set to FALSE if file representations are never chunked.
+   *INDEXED_DIRS is obtained from the 'dirs' format option, and will be
+   set to FALSE if directory representations are never indexed.
+   *ZSTD_COMPRESSION is obtained from the 'compression' format option,
+   and will be set to FALSE if deltas never use Zstandard compression.
+   *LOCK_LOG is obtained from the 'locks' format option, and will be set
+   to FALSE if locks are stored in digest files.
 
    Use POOL for temporary allocation. */
 static svn_error_t *
 read_format(int *pformat,
             int *max_files_per_dir,
             svn_boolean_t *use_log_addressing,
+            svn_boolean_t *large_delta_windows,
+            svn_boolean_t *chunked_reps,
+            svn_boolean_t *indexed_dirs,
+            svn_boolean_t *zstd_compression,
+            svn_boolean_t *lock_log,
             const char *path,
             apr_pool_t *pool)
 {
@@ -493,6 +525,11 @@ read_format(int *pformat,
       *pformat = 1;
       *max_files_per_dir = 0;
       *use_log_addressing = FALSE;
+      *large_delta_windows = FALSE;
+      *chunked_reps = FALSE;
+      *indexed_dirs = FALSE;
+      *zstd_compression = FALSE;
+      *lock_log = FALSE;
 
       return SVN_NO_ERROR;
     }
@@ -518,6 +555,11 @@ read_format(int *pformat,
   /* Set the default values for anything that can be set via an option. */
   *max_files_per_dir = 0;
   *use_log_addressing = FALSE;
+  *large_delta_windows = FALSE;
+  *chunked_reps = FALSE;
+  *indexed_dirs = FALSE;
+  *zstd_compression = FALSE;
+  *lock_log = FALSE;
 
   /* Read any options. */
   while (!eos)
@@ -560,6 +602,86 @@ read_format(int *pformat,
             }
         }
 
+      if (*pformat >= SVN_FS_FS__MIN_LARGE_DELTA_WINDOWS_FORMAT &&
+          strncmp(buf->data, "deltas ", 7) == 0)
+        {
+          if (strcmp(buf->data + 7, "standard") == 0)
+            {
+              *large_delta_windows = FALSE;
+              continue;
+            }
+
+          if (strcmp(buf->data + 7, "large-windows") == 0)
+            {
+              *large_delta_windows = TRUE;
+              continue;
+            }
+        }
+
+      if (*pformat >= SVN_FS_FS__MIN_CHUNKED_REPS_FORMAT &&
+          strncmp(buf->data, "reps ", 5) == 0)
+        {
+          if (strcmp(buf->data + 5, "standard") == 0)
+            {
+              *chunked_reps = FALSE;
+              continue;
+            }
+
+          if (strcmp(buf->data + 5, "chunked") == 0)
+            {
+              *chunked_reps = TRUE;
+              continue;
+            }
+        }
+
+      if (*pformat >= SVN_FS_FS__MIN_INDEXED_DIRS_FORMAT &&
+          strncmp(buf->data, "dirs ", 5) == 0)
+        {
+          if (strcmp(buf->data + 5, "standard") == 0)
+            {
+              *indexed_dirs = FALSE;
+              continue;
+            }
+
+          if (strcmp(buf->data + 5, "indexed") == 0)
+            {
+              *indexed_dirs = TRUE;
+              continue;
+            }
+        }
+
+      if (*pformat >= SVN_FS_FS__MIN_ZSTD_FORMAT &&
+          strncmp(buf->data, "compression ", 12) == 0)
+        {
+          if (strcmp(buf->data + 12, "standard") == 0)
+            {
+              *zstd_compression = FALSE;
+              continue;
+            }
+
+          if (strcmp(buf->data + 12, "zstd") == 0)
+            {
+              *zstd_compression = TRUE;
+              continue;
+            }
+        }
+
+      if (*pformat >= SVN_FS_FS__MIN_LOCK_LOG_FORMAT &&
+          strncmp(buf->data, "locks ", 6) == 0)
+        {
+          if (strcmp(buf->data + 6, "digest") == 0)
+            {
+              *lock_log = FALSE;
+              continue;
+            }
+
+          if (strcmp(buf->data + 6, "log") == 0)
+            {
+              *lock_log = TRUE;
+              continue;
+            }
+        }
+
       return svn_error_createf(SVN_ERR_BAD_VERSION_FILE_FORMAT, NULL,
          _("'%s' contains invalid filesystem format option '%s'"),
          svn_dirent_local_style(path, pool), buf->data);
@@ -613,6 +735,24 @@ svn_fs_fs__write_format(svn_fs_t *fs,
         svn_stringbuf_appendcstr(sb, "addressing physical\n");
     }
 
+  /* Only write the option when it is needed, so that releases that don't
+     know it can still open the repository. */
+  if (ffd->format >= SVN_FS_FS__MIN_LARGE_DELTA_WINDOWS_FORMAT
+      && ffd->large_delta_windows)
+    svn_stringbuf_appendcstr(sb, "deltas large-windows\n");
+  if (ffd->format >= SVN_FS_FS__MIN_CHUNKED_REPS_FORMAT
+      && ffd->chunked_reps)
+    svn_stringbuf_appendcstr(sb, "reps chunked\n");
+  if (ffd->format >= SVN_FS_FS__MIN_INDEXED_DIRS_FORMAT
+      && ffd->indexed_dirs)
+    svn_stringbuf_appendcstr(sb, "dirs indexed\n");
+  if (ffd->format >= SVN_FS_FS__MIN_ZSTD_FORMAT
+      && ffd->zstd_compression)
+    svn_stringbuf_appendcstr(sb, "compression zstd\n");
+  if (ffd->format >= SVN_FS_FS__MIN_LOCK_LOG_FORMAT
+      && ffd->lock_log)
+    svn_stringbuf_appendcstr(sb, "locks log\n");
+
   /* svn_io_write_version_file() does a load of magic to allow it to
      replace version files that already exist.  We only need to do
      that when we're allowed to overwrite an existing file. */
@@ -692,7 +832,8 @@ parse_compression_option(compression_type_t *compression_type_p,
   int level;
   svn_boolean_t is_valid = TRUE;
 
-  /* compression = none | lz4 | zlib | zlib-1 ... zlib-9 */
+  /* compression = none | lz4 | zlib | zlib-1 ... zlib-9
+                 | zstd | zstd-1 ... zstd-19 */
   if (strcmp(value, "none") == 0)
     {
       type = compression_type_none;
@@ -722,6 +863,25 @@ parse_compression_option(compression_type_t *compression_type_p,
       else
         is_valid = FALSE;
     }
+  else if (strncmp(value, "zstd", 4) == 0)
+    {
+      const char *p = value + 4;
+
+      type = compression_type_zstd;
+      if (*p == 0)
+        {
+          level = SVN_FS_FS__ZSTD_COMPRESSION_LEVEL_DEFAULT;
+        }
+      else if (*p == '-')
+        {
+          p++;
+          SVN_ERR(svn_cstring_atoi(&level, p));
+          if (level < 1 || level > 19)
+            is_valid = FALSE;
+        }
+      else
+        is_valid = FALSE;
+    }
   else
     {
       is_valid = FALSE;
@@ -760,6 +920,45 @@ read_config(fs_fs_data_t *ffd,
   else
     ffd->rep_sharing_allowed = FALSE;
 
+  /* Rep-cache tuning. */
+  if (ffd->rep_sharing_allowed)
+    {
+      apr_int64_t batch_size;
+
+      SVN_ERR(svn_config_get_bool(config, &ffd->rep_cache_wal,
+                                  CONFIG_SECTION_REP_SHARING,
+                                  CONFIG_OPTION_REP_CACHE_WAL, FALSE));
+      SVN_ERR(svn_config_get_int64(config, &batch_size,
+                                   CONFIG_SECTION_REP_SHARING,
+                                   CONFIG_OPTION_REP_CACHE_BATCH_SIZE, 0));
+      ffd->rep_cache_batch_size = (int)MAX(MIN(batch_size, 100000), 0);
+    }
+  else
+    {
+      ffd->rep_cache_wal = FALSE;
+      ffd->rep_cache_batch_size = 0;
+    }
+
+  /* Initialize ffd->chunked_rep_threshold.  Chunks are only worth something
+     if they can be shared. */
+  if (ffd->chunked_reps && ffd->rep_sharing_allowed)
+    {
+      SVN_ERR(svn_config_get_int64(config, &ffd->chunked_rep_threshold,
+                                   CONFIG_SECTION_REP_SHARING,
+                                   CONFIG_OPTION_CHUNKED_REP_THRESHOLD,
+                                   4096));
+
+      /* convert kBytes to bytes and silently enforce the lower limit */
+      if (ffd->chunked_rep_threshold > 0)
+        ffd->chunked_rep_threshold
+          = MAX(MIN(ffd->chunked_rep_threshold, APR_INT32_MAX) * 0x400,
+                SVN_FS_FS__CHUNKED_REP_MIN_THRESHOLD);
+      else
+        ffd->chunked_rep_threshold = 0;
+    }
+  else
+    ffd->chunked_rep_threshold = 0;
+
   /* Initialize deltification settings in ffd. */
   if (ffd->format >= SVN_FS_FS__MIN_DELTIFICATION_FORMAT)
     {
@@ -779,6 +978,14 @@ read_config(fs_fs_data_t *ffd,
                                    CONFIG_SECTION_DELTIFICATION,
                                    CONFIG_OPTION_MAX_LINEAR_DELTIFICATION,
                                    SVN_FS_FS_MAX_LINEAR_DELTIFICATION));
+      SVN_ERR(svn_config_get_bool(config, &ffd->sample_delta_bases,
+                                  CONFIG_SECTION_DELTIFICATION,
+                                  CONFIG_OPTION_SAMPLE_DELTA_BASES,
+                                  FALSE));
+      SVN_ERR(svn_config_get_bool(config, &ffd->ancestor_skip_pointers,
+                                  CONFIG_SECTION_DELTIFICATION,
+                                  CONFIG_OPTION_ANCESTOR_SKIP_POINTERS,
+                                  FALSE));
     }
   else
     {
@@ -786,6 +993,8 @@ read_config(fs_fs_data_t *ffd,
       ffd->deltify_properties = FALSE;
       ffd->max_deltification_walk = SVN_FS_FS_MAX_DELTIFICATION_WALK;
       ffd->max_linear_deltification = SVN_FS_FS_MAX_LINEAR_DELTIFICATION;
+      ffd->sample_delta_bases = FALSE;
+      ffd->ancestor_skip_pointers = FALSE;
     }
 
   /* Initialize revprop packing settings in ffd. */
@@ -848,16 +1057,79 @@ read_config(fs_fs_data_t *ffd,
       ffd->p2l_page_size = 0x100000;  /* Matches above default in bytes. */
     }
 
+  SVN_ERR(svn_config_get_bool(config, &ffd->prefetch_delta_chain,
+                              CONFIG_SECTION_IO,
+                              CONFIG_OPTION_PREFETCH_DELTA_CHAIN,
+                              FALSE));
+
+  if (ffd->format >= SVN_FS_FS__MIN_PACKED_FORMAT)
+    SVN_ERR(svn_config_get_bool(config, &ffd->mmap_packed_files,
+                                CONFIG_SECTION_IO,
+                                CONFIG_OPTION_MMAP_PACKED_FILES,
+                                FALSE));
+  else
+    ffd->mmap_packed_files = FALSE;
+
+  SVN_ERR(svn_config_get_bool(config, &ffd->group_commit,
+                              CONFIG_SECTION_IO,
+                              CONFIG_OPTION_GROUP_COMMIT,
+                              FALSE));
+
+  {
+    const char *dir;
+
+    svn_config_get(config, &dir, CONFIG_SECTION_IO,
+                   CONFIG_OPTION_SHARED_YOUNGEST_DIR, NULL);
+    ffd->shared_youngest_dir = (dir && *dir)
+                             ? svn_dirent_internal_style(dir, result_pool)
+                             : NULL;
+  }
+
+  {
+    apr_int64_t staging_size;
+
+    SVN_ERR(svn_config_get_int64(config, &staging_size,
+                                 CONFIG_SECTION_IO,
+                                 CONFIG_OPTION_TXN_STAGING_SIZE,
+                                 0));
+
+    /* convert kBytes to bytes and silently limit it to 64MB */
+    ffd->txn_staging_size = (apr_size_t)MAX(0, MIN(staging_size, 0x10000))
+                          * 0x400;
+  }
+
+  {
+    apr_int64_t hotcopy_jobs;
+
+    SVN_ERR(svn_config_get_int64(config, &hotcopy_jobs,
+                                 CONFIG_SECTION_HOTCOPY,
+                                 CONFIG_OPTION_HOTCOPY_JOBS,
+                                 1));
+
+    /* Silently limit the number of jobs to something reasonable. */
+    ffd->hotcopy_jobs = (int)MAX(1, MIN(hotcopy_jobs, 64));
+  }
+
   if (ffd->format >= SVN_FS_FS__MIN_PACKED_FORMAT)
     {
+      apr_int64_t pack_jobs;
+
       SVN_ERR(svn_config_get_bool(config, &ffd->pack_after_commit,
                                   CONFIG_SECTION_DEBUG,
                                   CONFIG_OPTION_PACK_AFTER_COMMIT,
                                   FALSE));
+      SVN_ERR(svn_config_get_int64(config, &pack_jobs,
+                                   CONFIG_SECTION_PACK,
+                                   CONFIG_OPTION_PACK_JOBS,
+                                   1));
+
+      /* Silently limit the number of jobs to something reasonable. */
+      ffd->pack_jobs = (int)MAX(1, MIN(pack_jobs, 64));
     }
   else
     {
       ffd->pack_after_commit = FALSE;
+      ffd->pack_jobs = 1;
     }
 
   /* Initialize compression settings in ffd. */
@@ -890,6 +1162,22 @@ read_config(fs_fs_data_t *ffd,
                                       _("Compression type 'lz4' requires "
                                         "filesystem format 8 or higher"));
             }
+
+          /* svndiff4 would make the repository unreadable for builds
+           * that don't know the format option. */
+          if (ffd->delta_compression_type == compression_type_zstd)
+            {
+              if (!ffd->zstd_compression)
+                return svn_error_create(SVN_ERR_BAD_CONFIG_VALUE, NULL,
+                                        _("Compression type 'zstd' requires "
+                                          "a repository created with "
+                                          "Zstandard support"));
+
+              if (!svn_zstd__compiled_version())
+                return svn_error_create(SVN_ERR_UNSUPPORTED_FEATURE, NULL,
+                                        _("Zstandard compression has not "
+                                          "been compiled into this build"));
+            }
         }
       else if (compression_level_val)
         {
@@ -905,13 +1193,25 @@ read_config(fs_fs_data_t *ffd,
       else
         {
           /* Nothing specified explicitly, use the default settings:
-           * LZ4 compression for formats supporting it and zlib otherwise. */
-          if (ffd->format >= SVN_FS_FS__MIN_SVNDIFF2_FORMAT)
-            ffd->delta_compression_type = compression_type_lz4;
+           * Zstandard if the repository has been created for it and this
+           * build supports it, LZ4 compression for formats supporting it
+           * and zlib otherwise. */
+          if (ffd->zstd_compression && svn_zstd__compiled_version())
+            {
+              ffd->delta_compression_type = compression_type_zstd;
+              ffd->delta_compression_level
+                = SVN_FS_FS__ZSTD_COMPRESSION_LEVEL_DEFAULT;
+            }
           else
-            ffd->delta_compression_type = compression_type_zlib;
+            {
+              if (ffd->format >= SVN_FS_FS__MIN_SVNDIFF2_FORMAT)
+                ffd->delta_compression_type = compression_type_lz4;
+              else
+                ffd->delta_compression_type = compression_type_zlib;
 
-          ffd->delta_compression_level = SVN_DELTA_COMPRESSION_LEVEL_DEFAULT;
+              ffd->delta_compression_level
+                = SVN_DELTA_COMPRESSION_LEVEL_DEFAULT;
+            }
         }
     }
   else if (ffd->format >= SVN_FS_FS__MIN_SVNDIFF1_FORMAT)
@@ -936,6 +1236,10 @@ read_config(fs_fs_data_t *ffd,
                               CONFIG_OPTION_VERIFY_BEFORE_COMMIT,
                               FALSE));
 #endif
+  SVN_ERR(svn_config_get_bool(config, &ffd->verify_after_commit,
+                              CONFIG_SECTION_DEBUG,
+                              CONFIG_OPTION_VERIFY_AFTER_COMMIT,
+                              FALSE));
 
   /* memcached configuration */
   SVN_ERR(svn_cache__make_memcache_from_config(&ffd->memcache, config,
@@ -993,6 +1297,35 @@ write_config(svn_fs_t *fs,
 "### 'svnadmin verify' will check the rep-cache regardless of this setting." NL
 "### rep-sharing is enabled by default."                                     NL
 "# " CONFIG_OPTION_ENABLE_REP_SHARING " = true"                              NL
+"###"                                                                        NL
+"### In repositories created with chunked representations enabled, files"    NL
+"### of at least the size (in kBytes) given by the following parameter are"  NL
+"### split into content-defined chunks which are shared individually.  An"   NL
+"### edit to a large binary will then only add the chunks that changed."     NL
+"### Smaller files are deltified as usual.  Values below 256 are rounded up" NL
+"### to 256 and 0 disables chunking for future revisions."                   NL
+"### Requires rep-sharing to be enabled.  Other repositories and versions"   NL
+"### prior to 1.11 ignore this option.  The default is 4096 (4 MBytes)."     NL
+"# " CONFIG_OPTION_CHUNKED_REP_THRESHOLD " = 4096"                           NL
+"###"                                                                        NL
+"### The rep-sharing database normally uses a rollback journal which makes"  NL
+"### concurrent readers and writers wait for each other.  Setting the"       NL
+"### following option to true switches it to write-ahead logging instead."   NL
+"### All users of the repository then need write access to the db/"          NL
+"### directory, even for read-only access, and the repository must not be"   NL
+"### on a network file system.  Disabling the option again switches the"     NL
+"### database back when no other process uses it.  The default is false."    NL
+"# " CONFIG_OPTION_REP_CACHE_WAL " = false"                                  NL
+"###"                                                                        NL
+"### New entries of the rep-sharing database are normally written at the"    NL
+"### end of each commit.  If the following option is set to a value N > 0," NL
+"### they are collected and written once N entries have accumulated or the"  NL
+"### repository gets closed, whichever comes first.  This takes the"         NL
+"### database writes out of most commits, e.g. during 'svnadmin load', but"  NL
+"### entries still in memory when the process is killed are lost.  The"      NL
+"### contents of such representations will simply not be shared.  The"       NL
+"### default is 0."                                                          NL
+"# " CONFIG_OPTION_REP_CACHE_BATCH_SIZE " = 0"                               NL
 ""                                                                           NL
 "[" CONFIG_SECTION_DELTIFICATION "]"                                         NL
 "### To conserve space, the filesystem stores data as differences against"   NL
@@ -1055,6 +1388,25 @@ write_config(svn_fs_t *fs,
 "### For 1.8, the default value is 16; earlier versions use 1."              NL
 "# " CONFIG_OPTION_MAX_LINEAR_DELTIFICATION " = 16"                          NL
 "###"                                                                        NL
+"### File contents are normally deltified against the base that the rules"   NL
+"### above select.  That is a poor choice for files that return to older"    NL
+"### contents, for instance.  If this option is enabled, the delta sizes"    NL
+"### for the first 64 kBytes of new file contents are compared for that"     NL
+"### base, the closest predecessors and an empty base, and the one with"     NL
+"### the smallest delta is used.  The rules above still limit the length"    NL
+"### of the delta chains.  This speeds up reading at the expense of CPU"     NL
+"### time during commits.  The default is false."                            NL
+"# " CONFIG_OPTION_SAMPLE_DELTA_BASES " = false"                             NL
+"###"                                                                        NL
+"### Finding an older node-revision of a file or directory, e.g. the delta"  NL
+"### base selected by the rules above or the origin of a node, normally"     NL
+"### means reading every node-revision in between.  If this option is"       NL
+"### enabled, new node-revisions also point to one of their older"           NL
+"### ancestors, such that the walk only needs a logarithmic number of"       NL
+"### reads.  Older node-revisions don't have these pointers.  Older"         NL
+"### releases of Subversion ignore them.  The default is false."             NL
+"# " CONFIG_OPTION_ANCESTOR_SKIP_POINTERS " = false"                         NL
+"###"                                                                        NL
 "### After deltification, we compress the data to minimize on-disk size."    NL
 "### This setting controls the compression algorithm, which will be used in" NL
 "### future revisions.  It can be used to either disable compression or to"  NL
@@ -1066,11 +1418,19 @@ write_config(svn_fs_t *fs,
 "### significantly speed up commits as well as reading the data."            NL
 "### lz4 compression algorithm is supported, starting from format 8"         NL
 "### repositories, available in Subversion 1.10 and higher."                 NL
+"### zstd (Zstandard) compresses almost as fast as lz4 while reaching"       NL
+"### ratios better than zlib.  It is only available if Subversion has"       NL
+"### been built with it and for repositories created with Zstandard"         NL
+"### support, i.e. with the 'fsfs-zstd-compression' filesystem config"       NL
+"### option.  Existing data remains readable but is not converted;"          NL
+"### use dump / load for that."                                              NL
 "### The syntax of this option is:"                                          NL
 "###   " CONFIG_OPTION_COMPRESSION " = none | lz4 | zlib | zlib-1 ... zlib-9" NL
+"###                 | zstd | zstd-1 ... zstd-19"                            NL
 "### Versions prior to Subversion 1.10 will ignore this option."             NL
-"### The default value is 'lz4' if supported by the repository format and"   NL
-"### 'zlib' otherwise.  'zlib' is currently equivalent to 'zlib-5'."         NL
+"### The default value is 'zstd' for repositories with Zstandard support,"   NL
+"### 'lz4' if supported by the repository format and 'zlib' otherwise."      NL
+"### 'zlib' is currently equivalent to 'zlib-5' and 'zstd' to 'zstd-3'."     NL
 "# " CONFIG_OPTION_COMPRESSION " = lz4"                                      NL
 "###"                                                                        NL
 "### DEPRECATED: The new '" CONFIG_OPTION_COMPRESSION "' option deprecates previously used" NL
@@ -1147,6 +1507,90 @@ write_config(svn_fs_t *fs,
 "### Must be a power of 2."                                                  NL
 "### p2l-page-size is given in kBytes and with a default of 1024 kBytes."    NL
 "# " CONFIG_OPTION_P2L_PAGE_SIZE " = 1024"                                   NL
+"###"                                                                        NL
+"### When reading a file with a long delta chain, the first window of each"  NL
+"### delta in the chain is needed before any content can be returned.  If"   NL
+"### this option is enabled, those windows get read in the order they are"   NL
+"### stored on disk instead of following the chain.  Where supported, the"   NL
+"### OS is asked to fetch all of them at once, overlapping their I/O on"     NL
+"### storage with a high latency or queue depth.  This reduces seeks and"    NL
+"### the latency of the first bytes delivered on cold caches, at the"        NL
+"### expense of occasionally reading a window that is not needed."           NL
+"### This option applies to all repository formats and is disabled by"       NL
+"### default."                                                               NL
+"# " CONFIG_OPTION_PREFETCH_DELTA_CHAIN " = false"                           NL
+"###"                                                                        NL
+"### Pack files never change once they have been written.  If this option"   NL
+"### is enabled, they get mapped into memory and representation contents"    NL
+"### are being read directly from the OS file cache.  This saves system"     NL
+"### calls and copying data through intermediate buffers.  It may not be"    NL
+"### supported on all platforms and should not be used with network file"    NL
+"### systems that don't fully support memory-mapped files.  The mappings"    NL
+"### are shared by all connections to the repository within a server"        NL
+"### process.  This option applies to repositories in format 4 or newer"     NL
+"### and is disabled by default."                                            NL
+"# " CONFIG_OPTION_MMAP_PACKED_FILES " = false"                              NL
+"###"                                                                        NL
+"### Every commit makes its revision durable with several fsync calls while" NL
+"### holding the repository write lock.  If this option is enabled,"         NL
+"### concurrent commits made by the same server process get written under"   NL
+"### a single write lock and made durable by a single, shared fsync"         NL
+"### barrier, after which the 'current' file is updated once for all of"     NL
+"### them.  Each revision is still committed atomically and the commits"     NL
+"### of other processes remain unaffected.  This helps multi-threaded"       NL
+"### servers on storage with a high fsync latency.  It has no effect if"     NL
+"### APR has been built without thread support, for repositories older"      NL
+"### than format 3 or if fsync has been disabled.  This option is disabled"  NL
+"### by default."                                                            NL
+"# " CONFIG_OPTION_GROUP_COMMIT " = false"                                   NL
+"###"                                                                        NL
+"### Every lookup of the youngest revision reads the 'current' file, which"  NL
+"### can be expensive on network file systems.  If this option is set to a"  NL
+"### directory on a local file system, e.g. /dev/shm, all processes on this" NL
+"### host that use this repository share the youngest revision through a"    NL
+"### small memory-mapped file in that directory.  Commits publish their"     NL
+"### new revision there and readers don't need to touch 'current' anymore."  NL
+"### The directory must be writable by all server processes.  Only set"      NL
+"### this option if all commits are made on this host by Subversion 1.11"    NL
+"### or newer, because commits made elsewhere won't be seen until the next"  NL
+"### local commit.  Remove the file after restoring this repository by"      NL
+"### other means than svnadmin.  This option is not set by default."         NL
+"# " CONFIG_OPTION_SHARED_YOUNGEST_DIR " ="                                  NL
+"###"                                                                        NL
+"### Every transaction writes a file per node revision plus a changes file"  NL
+"### to its directory.  If this option is set to a non-zero size in"         NL
+"### kBytes, transactions are staged in memory instead until their node"     NL
+"### revisions and changes exceed that size.  This saves many file system"   NL
+"### operations for small commits.  All changes to a transaction must then"  NL
+"### be made by the process that created it.  That is the case for"          NL
+"### svnserve and for local access but not for an Apache server running"     NL
+"### multiple processes.  Hook scripts can still inspect the transaction."   NL
+"### The default is 0, i.e. transactions are only staged on disk."           NL
+"# " CONFIG_OPTION_TXN_STAGING_SIZE " = 0"                                  NL
+""                                                                           NL
+"[" CONFIG_SECTION_PACK "]"                                                  NL
+"### 'svnadmin pack' may create the pack files of multiple shards at the"    NL
+"### same time.  This parameter sets the maximum number of shards being"     NL
+"### packed concurrently.  The memory used for reordering data items will"   NL
+"### be split between them.  Shards are still being switched over to their"  NL
+"### packed form one after another and in order, such that the repository"   NL
+"### remains consistent and fully usable while the pack is in progress."     NL
+"### This setting has no effect if APR has been built without thread"        NL
+"### support and it is ignored during commits when pack-after-commit has"    NL
+"### been enabled.  The default is 1, i.e. sequential packing."              NL
+"# " CONFIG_OPTION_PACK_JOBS " = 1"                                          NL
+""                                                                           NL
+"[" CONFIG_SECTION_HOTCOPY "]"                                               NL
+"### 'svnadmin hotcopy' may copy the files of multiple shards at the same"   NL
+"### time when this repository is the source.  This parameter sets the"      NL
+"### maximum number of shards being copied concurrently.  Higher values"     NL
+"### help mostly when copying to network storage with a high latency per"    NL
+"### file.  The hotcopy destination is still being updated in revision"      NL
+"### order, such that an interrupted hotcopy can be resumed incrementally."  NL
+"### This setting has no effect if APR has been built without thread"        NL
+"### support or for repositories without sharding.  The default is 1,"       NL
+"### i.e. sequential copying."                                               NL
+"# " CONFIG_OPTION_HOTCOPY_JOBS " = 1"                                       NL
 ""                                                                           NL
 "[" CONFIG_SECTION_DEBUG "]"                                                 NL
 "###"                                                                        NL
@@ -1154,6 +1598,18 @@ write_config(svn_fs_t *fs,
 "### the commit.  This is disabled by default except in maintainer-mode"     NL
 "### builds."                                                                NL
 "# " CONFIG_OPTION_VERIFY_BEFORE_COMMIT " = false"                           NL
+"### Whether to split the verification of each new revision:  Check"         NL
+"### its structure immediately before finalizing the commit like"            NL
+"### " CONFIG_OPTION_VERIFY_BEFORE_COMMIT " does, but reconstruct its"       NL
+"### fulltexts and compare their checksums in a background thread"           NL
+"### right after the commit.  The results get appended to the"               NL
+"### '" PATH_VERIFY_LOG "' file in the repository's db directory, which"     NL
+"### 'svnadmin verify --skip-verified' uses to skip revisions that"          NL
+"### have been verified already.  A process finishes the pending"            NL
+"### verifications of the revisions it committed before it exits."           NL
+"### This setting has no effect if APR has been built without thread"        NL
+"### support.  It works best with long-running servers."                     NL
+"# " CONFIG_OPTION_VERIFY_AFTER_COMMIT " = false"                            NL
 ;
 #undef NL
   return svn_io_file_create(svn_dirent_join(fs->path, PATH_CONFIG, pool),
@@ -1226,15 +1682,27 @@ svn_fs_fs__read_format_file(svn_fs_t *fs, apr_pool_t *scratch_pool)
   fs_fs_data_t *ffd = fs->fsap_data;
   int format, max_files_per_dir;
   svn_boolean_t use_log_addressing;
+  svn_boolean_t large_delta_windows;
+  svn_boolean_t chunked_reps;
+  svn_boolean_t indexed_dirs;
+  svn_boolean_t zstd_compression;
+  svn_boolean_t lock_log;
 
   /* Read info from format file. */
   SVN_ERR(read_format(&format, &max_files_per_dir, &use_log_addressing,
+                      &large_delta_windows, &chunked_reps, &indexed_dirs,
+                      &zstd_compression, &lock_log,
                       path_format(fs, scratch_pool), scratch_pool));
 
   /* Now that we've got *all* info, store / update values in FFD. */
   ffd->format = format;
   ffd->max_files_per_dir = max_files_per_dir;
   ffd->use_log_addressing = use_log_addressing;
+  ffd->large_delta_windows = large_delta_windows;
+  ffd->chunked_reps = chunked_reps;
+  ffd->indexed_dirs = indexed_dirs;
+  ffd->zstd_compression = zstd_compression;
+  ffd->lock_log = lock_log;
 
   return SVN_NO_ERROR;
 }
@@ -1300,12 +1768,19 @@ upgrade_body(void *baton, apr_pool_t *pool)
   fs_fs_data_t *ffd = fs->fsap_data;
   int format, max_files_per_dir;
   svn_boolean_t use_log_addressing;
+  svn_boolean_t large_delta_windows;
+  svn_boolean_t chunked_reps;
+  svn_boolean_t indexed_dirs;
+  svn_boolean_t zstd_compression;
+  svn_boolean_t lock_log;
   const char *format_path = path_format(fs, pool);
   svn_node_kind_t kind;
   svn_boolean_t needs_revprop_shard_cleanup = FALSE;
 
   /* Read the FS format number and max-files-per-dir setting. */
   SVN_ERR(read_format(&format, &max_files_per_dir, &use_log_addressing,
+                      &large_delta_windows, &chunked_reps, &indexed_dirs,
+                      &zstd_compression, &lock_log,
                       format_path, pool));
 
   /* If the config file does not exist, create one. */
@@ -1382,6 +1857,11 @@ upgrade_body(void *baton, apr_pool_t *pool)
   ffd->format = SVN_FS_FS__FORMAT_NUMBER;
   ffd->max_files_per_dir = max_files_per_dir;
   ffd->use_log_addressing = use_log_addressing;
+  ffd->large_delta_windows = large_delta_windows;
+  ffd->chunked_reps = chunked_reps;
+  ffd->indexed_dirs = indexed_dirs;
+  ffd->zstd_compression = zstd_compression;
+  ffd->lock_log = lock_log;
 
   /* Always add / bump the instance ID such that no form of caching
      accidentally uses outdated information.  Keep the UUID. */
@@ -1436,9 +1916,23 @@ get_youngest(svn_revnum_t *youngest_p,
              svn_fs_t *fs,
              apr_pool_t *pool)
 {
+  fs_fs_data_t *ffd = fs->fsap_data;
   apr_uint64_t dummy;
+
+  /* Writers must always see the actual state of the repository. */
+  if (!ffd->has_write_lock)
+    {
+      SVN_ERR(svn_fs_fs__read_shared_youngest(youngest_p, fs, pool));
+      if (SVN_IS_VALID_REVNUM(*youngest_p))
+        return SVN_NO_ERROR;
+    }
+
   SVN_ERR(svn_fs_fs__read_current(youngest_p, &dummy, &dummy, fs, pool));
-  return SVN_NO_ERROR;
+
+  /* Under the write lock, 'current' cannot change and the value we read
+     replaces whatever may have been published. */
+  return svn_error_trace(svn_fs_fs__publish_shared_youngest(
+                           fs, *youngest_p, ffd->has_write_lock, pool));
 }
 
 
@@ -1916,10 +2410,16 @@ svn_fs_fs__create(svn_fs_t *fs,
   int format = SVN_FS_FS__FORMAT_NUMBER;
   int shard_size = SVN_FS_FS_DEFAULT_MAX_FILES_PER_DIR;
   svn_boolean_t log_addressing;
+  svn_boolean_t large_delta_windows;
+  svn_boolean_t chunked_reps;
+  svn_boolean_t indexed_dirs;
+  svn_boolean_t zstd_compression;
+  svn_boolean_t lock_log = FALSE;
 
   /* Process the given filesystem config. */
   if (fs->config)
     {
+      const char *lock_storage;
       svn_version_t *compatible_version;
       const char *shard_size_str;
       SVN_ERR(svn_fs__compatible_version(&compatible_version, fs->config,
@@ -1963,16 +2463,85 @@ svn_fs_fs__create(svn_fs_t *fs,
 
           shard_size = (int) val;
         }
+
+      lock_storage = svn_hash_gets(fs->config,
+                                   SVN_FS_CONFIG_FSFS_LOCK_STORAGE);
+      if (lock_storage && strcmp(lock_storage, "log") == 0)
+        lock_log = TRUE;
+      else if (lock_storage && strcmp(lock_storage, "digest") != 0)
+        return svn_error_createf(SVN_ERR_BAD_CONFIG_VALUE, NULL,
+                                 _("Unknown lock storage '%s'"),
+                                 lock_storage);
+
+      /* The format must record the lock log, so that releases that don't
+         know it refuse to open the repository instead of finding no
+         locks. */
+      if (lock_log && format < SVN_FS_FS__MIN_LOCK_LOG_FORMAT)
+        return svn_error_createf(SVN_ERR_UNSUPPORTED_FEATURE, NULL,
+                                 _("FSFS format %d does not support "
+                                   "lock storage '%s'"),
+                                 format, lock_storage);
     }
 
   log_addressing = svn_hash__get_bool(fs->config,
                                       SVN_FS_CONFIG_FSFS_LOG_ADDRESSING,
                                       TRUE);
 
+  large_delta_windows
+    = svn_hash__get_bool(fs->config, SVN_FS_CONFIG_FSFS_LARGE_DELTA_WINDOWS,
+                         FALSE);
+
+  chunked_reps = svn_hash__get_bool(fs->config,
+                                    SVN_FS_CONFIG_FSFS_CHUNKED_REPS, FALSE);
+
+  indexed_dirs = svn_hash__get_bool(fs->config,
+                                    SVN_FS_CONFIG_FSFS_INDEXED_DIRS, FALSE);
+
+  zstd_compression
+    = svn_hash__get_bool(fs->config, SVN_FS_CONFIG_FSFS_ZSTD_COMPRESSION,
+                         FALSE);
+  if (zstd_compression && !svn_zstd__compiled_version())
+    return svn_error_create(SVN_ERR_UNSUPPORTED_FEATURE, NULL,
+                            _("Zstandard compression has not been "
+                              "compiled into this build"));
+
   /* Actual FS creation. */
   SVN_ERR(svn_fs_fs__create_file_tree(fs, path, format, shard_size,
                                       log_addressing, pool));
 
+  /* Large windows need svndiff3, which older formats can't store. */
+  if (format >= SVN_FS_FS__MIN_LARGE_DELTA_WINDOWS_FORMAT)
+    {
+      fs_fs_data_t *ffd = fs->fsap_data;
+      ffd->large_delta_windows = large_delta_windows;
+    }
+
+  /* Likewise, older formats don't know about chunked reps. */
+  if (format >= SVN_FS_FS__MIN_CHUNKED_REPS_FORMAT)
+    {
+      fs_fs_data_t *ffd = fs->fsap_data;
+      ffd->chunked_reps = chunked_reps;
+    }
+
+  /* Nor about indexed directories. */
+  if (format >= SVN_FS_FS__MIN_INDEXED_DIRS_FORMAT)
+    {
+      fs_fs_data_t *ffd = fs->fsap_data;
+      ffd->indexed_dirs = indexed_dirs;
+    }
+
+  /* Nor about Zstandard compressed deltas.  The config has been read
+     before the option got set, so re-read it to pick the new default. */
+  if (format >= SVN_FS_FS__MIN_ZSTD_FORMAT && zstd_compression)
+    {
+      fs_fs_data_t *ffd = fs->fsap_data;
+      ffd->zstd_compression = zstd_compression;
+      SVN_ERR(read_config(ffd, fs->path, fs->pool, pool));
+    }
+
+  if (lock_log)
+    SVN_ERR(svn_fs_fs__create_lock_log(fs, pool));
+
   /* This filesystem is ready.  Stamp it with a format number. */
   SVN_ERR(svn_fs_fs__write_format(fs, FALSE, pool));
 
@@ -21,7 +21,12 @@
  */
 #include "svn_pools.h"
 #include "svn_path.h"
+#include "svn_io.h"
 #include "svn_dirent_uri.h"
+#include "svn_sorts.h"
+#include "private/svn_dep_compat.h"
+#include "private/svn_io_private.h"
+#include "private/svn_worker_pool.h"
 
 #include "fs_fs.h"
 #include "hotcopy.h"
@@ -279,19 +284,22 @@ hotcopy_copy_shard_file(svn_boolean_t *skipped_p,
 
 /* Copy a packed shard containing revision REV, and which contains
  * MAX_FILES_PER_DIR revisions, from SRC_FS to DST_FS.
- * Update *DST_MIN_UNPACKED_REV in case the shard is new in DST_FS.
  * Do not re-copy data which already exists in DST_FS.
  * Set *SKIPPED_P to FALSE only if at least one part of the shard
  * was copied, do not change the value in *SKIPPED_P otherwise.
- * SKIPPED_P may be NULL if not required.
- * Use SCRATCH_POOL for temporary allocations. */
+ * SKIPPED_P may be NULL if not required.  Leave the revprops of
+ * revision 0 alone unless COPY_REV0_PROPS is set.
+ *
+ * This only reads the paths of both filesystems and may be called from
+ * multiple threads at once.  The caller has to update DST_FS's
+ * min-unpacked-rev.  Use SCRATCH_POOL for temporary allocations. */
 static svn_error_t *
 hotcopy_copy_packed_shard(svn_boolean_t *skipped_p,
-                          svn_revnum_t *dst_min_unpacked_rev,
                           svn_fs_t *src_fs,
                           svn_fs_t *dst_fs,
                           svn_revnum_t rev,
                           int max_files_per_dir,
+                          svn_boolean_t copy_rev0_props,
                           apr_pool_t *scratch_pool)
 {
   const char *src_subdir;
@@ -330,6 +338,9 @@ hotcopy_copy_packed_shard(svn_boolean_t *skipped_p,
         {
           svn_pool_clear(iterpool);
 
+          if (revprop_rev == 0 && !copy_rev0_props)
+            continue;
+
           SVN_ERR(hotcopy_copy_shard_file(skipped_p, src_subdir, dst_subdir,
                                           revprop_rev, max_files_per_dir,
                                           iterpool));
@@ -339,7 +350,7 @@ hotcopy_copy_packed_shard(svn_boolean_t *skipped_p,
   else
     {
       /* revprop for revision 0 will never be packed */
-      if (rev == 0)
+      if (rev == 0 && copy_rev0_props)
         SVN_ERR(hotcopy_copy_shard_file(skipped_p, src_subdir, dst_subdir,
                                         0, max_files_per_dir,
                                         scratch_pool));
@@ -357,15 +368,46 @@ hotcopy_copy_packed_shard(svn_boolean_t *skipped_p,
                                               scratch_pool));
     }
 
-  /* If necessary, update the min-unpacked rev file in the hotcopy. */
-  if (*dst_min_unpacked_rev < rev + max_files_per_dir)
+  return SVN_NO_ERROR;
+}
+
+/* Copy the rev and revprop files of all revisions in the non-packed
+ * shard starting at revision REV in SRC_REVS_DIR and SRC_REVPROPS_DIR to
+ * DST_REVS_DIR and DST_REVPROPS_DIR, respectively.  Stop after revision
+ * YOUNGEST.  Assume a sharding layout based on MAX_FILES_PER_DIR.
+ * For all revisions I being copied, set SKIPPED[I - REV] to FALSE if any
+ * of its files had to be copied and to TRUE otherwise.
+ * Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+hotcopy_copy_shard(svn_boolean_t *skipped,
+                   const char *src_revs_dir,
+                   const char *dst_revs_dir,
+                   const char *src_revprops_dir,
+                   const char *dst_revprops_dir,
+                   svn_revnum_t rev,
+                   svn_revnum_t youngest,
+                   int max_files_per_dir,
+                   apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  svn_revnum_t end_rev = MIN(rev + max_files_per_dir - 1, youngest);
+  svn_revnum_t i;
+
+  for (i = rev; i <= end_rev; ++i)
     {
-      *dst_min_unpacked_rev = rev + max_files_per_dir;
-      SVN_ERR(svn_fs_fs__write_min_unpacked_rev(dst_fs,
-                                                *dst_min_unpacked_rev,
-                                                scratch_pool));
+      svn_pool_clear(iterpool);
+
+      skipped[i - rev] = TRUE;
+      SVN_ERR(hotcopy_copy_shard_file(&skipped[i - rev],
+                                      src_revs_dir, dst_revs_dir, i,
+                                      max_files_per_dir, iterpool));
+      SVN_ERR(hotcopy_copy_shard_file(&skipped[i - rev],
+                                      src_revprops_dir, dst_revprops_dir, i,
+                                      max_files_per_dir, iterpool));
     }
 
+  svn_pool_destroy(iterpool);
+
   return SVN_NO_ERROR;
 }
 
@@ -507,6 +549,28 @@ hotcopy_incremental_check_preconditions(svn_fs_t *src_fs,
                               "of the hotcopy source does not match "
                               "the sharding layout configuration of "
                               "the hotcopy destination"));
+
+  /* The destination must be able to read the deltas we copy. */
+  if (src_ffd->large_delta_windows && !dst_ffd->large_delta_windows)
+    return svn_error_create(SVN_ERR_UNSUPPORTED_FEATURE, NULL,
+                            _("The hotcopy source uses large delta "
+                              "windows but the hotcopy destination "
+                              "does not"));
+  if (src_ffd->chunked_reps && !dst_ffd->chunked_reps)
+    return svn_error_create(SVN_ERR_UNSUPPORTED_FEATURE, NULL,
+                            _("The hotcopy source uses chunked "
+                              "representations but the hotcopy "
+                              "destination does not"));
+  if (src_ffd->indexed_dirs && !dst_ffd->indexed_dirs)
+    return svn_error_create(SVN_ERR_UNSUPPORTED_FEATURE, NULL,
+                            _("The hotcopy source uses indexed "
+                              "directories but the hotcopy "
+                              "destination does not"));
+  if (src_ffd->zstd_compression && !dst_ffd->zstd_compression)
+    return svn_error_create(SVN_ERR_UNSUPPORTED_FEATURE, NULL,
+                            _("The hotcopy source uses Zstandard "
+                              "compression but the hotcopy "
+                              "destination does not"));
   return SVN_NO_ERROR;
 }
 
@@ -532,69 +596,374 @@ remove_folder(const char *path,
   return svn_error_trace(err);
 }
 
-/* Copy the revision and revprop files (possibly sharded / packed) from
- * SRC_FS to DST_FS.  Do not re-copy data which already exists in DST_FS.
- * When copying packed or unpacked shards, checkpoint the result in DST_FS
- * for every shard by updating the 'current' file if necessary.  Assume
- * the >= SVN_FS_FS__MIN_NO_GLOBAL_IDS_FORMAT filesystem format without
- * global next-ID counters.  Indicate progress via the optional NOTIFY_FUNC
- * callback using NOTIFY_BATON.  Use POOL for temporary allocations.
+/* Copies the files of multiple shards concurrently for hotcopy_rev_files(),
+   see below.  Opaque if APR has been built without thread support. */
+typedef struct hotcopy_copier_t hotcopy_copier_t;
+
+#if APR_HAS_THREADS
+
+/* A shard to copy in a worker thread. */
+typedef struct copier_item_t
+{
+  hotcopy_copier_t *copier;
+  apr_int64_t shard;
+
+  /* Whether copying the respective revision's files could be skipped.
+     Packed shards only use the first entry. */
+  svn_boolean_t *skipped;
+
+  /* Next unused item. */
+  struct copier_item_t *next;
+} copier_item_t;
+
+/* Parameters and state of a parallel hotcopy.  The members up to and
+   including CAPACITY are constant while the workers are running, the
+   others are only used by the main thread. */
+struct hotcopy_copier_t
+{
+  /* Copy the files of all revisions up to and including YOUNGEST from
+     SRC_FS to DST_FS.  Shards before MIN_UNPACKED_REV are packed.  The
+     workers only use the paths of the filesystems. */
+  svn_fs_t *src_fs;
+  svn_fs_t *dst_fs;
+  svn_revnum_t youngest;
+  svn_revnum_t min_unpacked_rev;
+  int max_files_per_dir;
+  const char *src_revs_dir;
+  const char *dst_revs_dir;
+  const char *src_revprops_dir;
+  const char *dst_revprops_dir;
+
+  /* The number of shards to copy, starting at shard 0. */
+  apr_int64_t end_shard;
+
+  /* Limits the number of copied shards waiting to be processed by the
+     main thread. */
+  int capacity;
+
+  /* Copies the shards in order. */
+  svn_worker_pool__ordered_t *queue;
+
+  /* The next shard to add to QUEUE. */
+  apr_int64_t next_shard;
+
+  /* The shard taken from QUEUE that the main thread is processing.
+     NULL between shards. */
+  copier_item_t *current;
+
+  /* Items to recycle and the pool to allocate new ones in. */
+  copier_item_t *unused;
+  apr_pool_t *pool;
+};
+
+/* Implements svn_worker_pool__item_func_t.  ITEM is the copier_item_t
+   whose shard to copy. */
+static svn_error_t *
+copy_shard_item(void *item,
+                void *thread_baton,
+                apr_pool_t *scratch_pool)
+{
+  copier_item_t *ci = item;
+  hotcopy_copier_t *copier = ci->copier;
+  int max_files_per_dir = copier->max_files_per_dir;
+  svn_revnum_t rev = (svn_revnum_t)(ci->shard * max_files_per_dir);
+
+  if (rev < copier->min_unpacked_rev)
+    {
+      ci->skipped[0] = TRUE;
+      return svn_error_trace(hotcopy_copy_packed_shard(&ci->skipped[0],
+                                                       copier->src_fs,
+                                                       copier->dst_fs, rev,
+                                                       max_files_per_dir,
+                                                       TRUE, scratch_pool));
+    }
+
+  return svn_error_trace(hotcopy_copy_shard(ci->skipped,
+                                            copier->src_revs_dir,
+                                            copier->dst_revs_dir,
+                                            copier->src_revprops_dir,
+                                            copier->dst_revprops_dir,
+                                            rev, copier->youngest,
+                                            max_files_per_dir,
+                                            scratch_pool));
+}
+
+/* Release COPIER and all outstanding results.  Return ERR, combined with
+   any error reported by the workers. */
+static svn_error_t *
+copier_stop(hotcopy_copier_t *copier,
+            svn_error_t *err)
+{
+  return svn_error_trace(svn_worker_pool__ordered_destroy(copier->queue,
+                                                          err));
+}
+
+/* Start copying the files of all revisions up to and including YOUNGEST
+   from SRC_FS to DST_FS in the background, using up to JOBS threads, and
+   return the new copier in *COPIER.  Set it to NULL if no thread could be
+   started.  SRC_MIN_UNPACKED_REV is the first non-packed revision in
+   SRC_FS.  The directory parameters are the same as for
+   hotcopy_revisions().  Use POOL for allocations.
+
+   The caller must retrieve the results by calling copier_fetch() for
+   every revision in order and finally release COPIER with copier_stop(). */
+static svn_error_t *
+copier_start(hotcopy_copier_t **copier_p,
+             svn_fs_t *src_fs,
+             svn_fs_t *dst_fs,
+             svn_revnum_t youngest,
+             svn_revnum_t src_min_unpacked_rev,
+             const char *src_revs_dir,
+             const char *dst_revs_dir,
+             const char *src_revprops_dir,
+             const char *dst_revprops_dir,
+             int jobs,
+             apr_pool_t *pool)
+{
+  hotcopy_copier_t *copier = apr_pcalloc(pool, sizeof(*copier));
+  fs_fs_data_t *src_ffd = src_fs->fsap_data;
+
+  copier->src_fs = src_fs;
+  copier->dst_fs = dst_fs;
+  copier->youngest = youngest;
+  copier->min_unpacked_rev = src_min_unpacked_rev;
+  copier->max_files_per_dir = src_ffd->max_files_per_dir;
+  copier->src_revs_dir = src_revs_dir;
+  copier->dst_revs_dir = dst_revs_dir;
+  copier->src_revprops_dir = src_revprops_dir;
+  copier->dst_revprops_dir = dst_revprops_dir;
+  copier->end_shard = youngest / copier->max_files_per_dir + 1;
+  copier->pool = pool;
+
+  /* There is no point in having more workers than shards. */
+  jobs = (int)MIN(jobs, copier->end_shard);
+
+  /* Allow for some imbalance between shards. */
+  copier->capacity = 2 * jobs;
+
+  SVN_ERR(svn_worker_pool__ordered_create(&copier->queue, jobs,
+                                          copier->capacity, NULL,
+                                          copy_shard_item, NULL, copier,
+                                          pool));
+
+  *copier_p = copier->queue ? copier : NULL;
+
+  return SVN_NO_ERROR;
+}
+
+/* Queue the next shard of COPIER for copying. */
+static svn_error_t *
+copier_add_shard(hotcopy_copier_t *copier)
+{
+  copier_item_t *ci = copier->unused;
+
+  if (ci)
+    {
+      copier->unused = ci->next;
+    }
+  else
+    {
+      ci = apr_pcalloc(copier->pool, sizeof(*ci));
+      ci->copier = copier;
+      ci->skipped = apr_pcalloc(copier->pool, copier->max_files_per_dir
+                                              * sizeof(*ci->skipped));
+    }
+
+  ci->shard = copier->next_shard++;
+
+  return svn_error_trace(svn_worker_pool__ordered_add(copier->queue, ci));
+}
+
+/* Wait until COPIER has copied the files of revision REV and return the
+   result.  For packed shards, REV must be the first revision in the shard.
+   Set *SKIPPED_P to FALSE if any of the files had to be copied, do not
+   change the value in *SKIPPED_P otherwise.  The caller must process the
+   revisions in order. */
+static svn_error_t *
+copier_fetch(svn_boolean_t *skipped_p,
+             hotcopy_copier_t *copier,
+             svn_revnum_t rev)
+{
+  int max_files_per_dir = copier->max_files_per_dir;
+  apr_int64_t shard = rev / max_files_per_dir;
+  copier_item_t *ci = copier->current;
+  svn_error_t *err = SVN_NO_ERROR;
+
+  /* Starting another shard? */
+  if (!ci)
+    {
+      void *item;
+
+      while (   copier->next_shard < copier->end_shard
+             && copier->next_shard < shard + copier->capacity)
+        SVN_ERR(copier_add_shard(copier));
+
+      SVN_ERR(svn_worker_pool__ordered_take(&item, &err, copier->queue,
+                                            TRUE));
+      ci = item;
+      copier->current = ci;
+    }
+
+  if (!ci->skipped[rev % max_files_per_dir])
+    *skipped_p = FALSE;
+
+  /* Recycle the item once we are done with the whole shard. */
+  if (   rev < copier->min_unpacked_rev
+      || rev % max_files_per_dir == max_files_per_dir - 1
+      || rev == copier->youngest)
+    {
+      copier->current = NULL;
+      ci->next = copier->unused;
+      copier->unused = ci;
+    }
+
+  return svn_error_trace(err);
+}
+
+#endif
+
+/* Schedule all files directly within DIR and their directory entries for
+ * fsync in BATCH.  Do nothing if DIR does not exist.
+ * Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+schedule_folder_fsync(svn_io__batch_fsync_t *batch,
+                      const char *dir,
+                      apr_pool_t *scratch_pool)
+{
+  apr_hash_t *dirents;
+  apr_hash_index_t *hi;
+  svn_node_kind_t kind;
+
+  SVN_ERR(svn_io_check_path(dir, &kind, scratch_pool));
+  if (kind != svn_node_dir)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_io_get_dirents3(&dirents, dir, TRUE, scratch_pool,
+                              scratch_pool));
+  for (hi = apr_hash_first(scratch_pool, dirents); hi; hi = apr_hash_next(hi))
+    {
+      const char *name = apr_hash_this_key(hi);
+      svn_io_dirent2_t *dirent = apr_hash_this_val(hi);
+
+      if (dirent->kind == svn_node_file)
+        {
+          const char *path = svn_dirent_join(dir, name, scratch_pool);
+          SVN_ERR(svn_io__batch_fsync_add_file(batch, path, scratch_pool));
+          SVN_ERR(svn_io__batch_fsync_new_path(batch, path, scratch_pool));
+        }
+    }
+
+  /* The folder itself may be new as well. */
+  SVN_ERR(svn_io__batch_fsync_new_path(batch, dir, scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Schedule the hotcopied packed shard starting at revision REV in DST_FS
+ * for fsync in BATCH.  Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+schedule_packed_shard_fsync(svn_io__batch_fsync_t *batch,
+                            svn_fs_t *dst_fs,
+                            svn_revnum_t rev,
+                            apr_pool_t *scratch_pool)
+{
+  const char *pack_file_path = svn_fs_fs__path_rev_packed(dst_fs, rev,
+                                                          PATH_PACKED,
+                                                          scratch_pool);
+
+  SVN_ERR(schedule_folder_fsync(batch,
+                                svn_dirent_dirname(pack_file_path,
+                                                   scratch_pool),
+                                scratch_pool));
+
+  /* Revprops may or may not have been packed. */
+  SVN_ERR(schedule_folder_fsync(batch,
+                                svn_fs_fs__path_revprops_pack_shard(
+                                    dst_fs, rev, scratch_pool),
+                                scratch_pool));
+  SVN_ERR(schedule_folder_fsync(batch,
+                                svn_fs_fs__path_revprops_shard(
+                                    dst_fs, rev, scratch_pool),
+                                scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Schedule the hotcopied rev and revprop files of the non-packed revision
+ * REV in DST_FS and their directory entries for fsync in BATCH.
+ * Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+schedule_rev_fsync(svn_io__batch_fsync_t *batch,
+                   svn_fs_t *dst_fs,
+                   svn_revnum_t rev,
+                   apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *dst_ffd = dst_fs->fsap_data;
+  const char *rev_path = svn_fs_fs__path_rev(dst_fs, rev, scratch_pool);
+  const char *revprops_path = svn_fs_fs__path_revprops(dst_fs, rev,
+                                                       scratch_pool);
+
+  SVN_ERR(svn_io__batch_fsync_add_file(batch, rev_path, scratch_pool));
+  SVN_ERR(svn_io__batch_fsync_new_path(batch, rev_path, scratch_pool));
+  SVN_ERR(svn_io__batch_fsync_add_file(batch, revprops_path, scratch_pool));
+  SVN_ERR(svn_io__batch_fsync_new_path(batch, revprops_path, scratch_pool));
+
+  /* The first revision of a shard created the shard folders. */
+  if (dst_ffd->max_files_per_dir && rev % dst_ffd->max_files_per_dir == 0)
+    {
+      SVN_ERR(svn_io__batch_fsync_new_path(batch,
+                                           svn_dirent_dirname(rev_path,
+                                                              scratch_pool),
+                                           scratch_pool));
+      SVN_ERR(svn_io__batch_fsync_new_path(batch,
+                                           svn_dirent_dirname(revprops_path,
+                                                              scratch_pool),
+                                           scratch_pool));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Copy the revision and revprop files of SRC_FS to DST_FS for
+ * hotcopy_revisions(), whose parameters are the same.  SRC_MIN_UNPACKED_REV
+ * and DST_MIN_UNPACKED_REV are the first non-packed revisions in SRC_FS
+ * and DST_FS.  If COPIER is not NULL, take the files from there instead
+ * of copying them from within this function.  Use POOL for temporary
+ * allocations.
  */
 static svn_error_t *
-hotcopy_revisions(svn_fs_t *src_fs,
+hotcopy_rev_files(svn_fs_t *src_fs,
                   svn_fs_t *dst_fs,
                   svn_revnum_t src_youngest,
                   svn_revnum_t dst_youngest,
+                  svn_revnum_t src_min_unpacked_rev,
+                  svn_revnum_t dst_min_unpacked_rev,
                   svn_boolean_t incremental,
                   const char *src_revs_dir,
                   const char *dst_revs_dir,
                   const char *src_revprops_dir,
                   const char *dst_revprops_dir,
+                  hotcopy_copier_t *copier,
                   svn_fs_hotcopy_notify_t notify_func,
                   void* notify_baton,
                   svn_cancel_func_t cancel_func,
                   void* cancel_baton,
                   apr_pool_t *pool)
 {
-  fs_fs_data_t *src_ffd = src_fs->fsap_data;
   fs_fs_data_t *dst_ffd = dst_fs->fsap_data;
-  int max_files_per_dir = src_ffd->max_files_per_dir;
-  svn_revnum_t src_min_unpacked_rev;
-  svn_revnum_t dst_min_unpacked_rev;
+  int max_files_per_dir = ((fs_fs_data_t *)src_fs->fsap_data)
+                            ->max_files_per_dir;
   svn_revnum_t rev;
   apr_pool_t *iterpool;
+  svn_io__batch_fsync_t *batch = NULL;
 
-  /* Copy the min unpacked rev, and read its value. */
-  if (src_ffd->format >= SVN_FS_FS__MIN_PACKED_FORMAT)
-    {
-      SVN_ERR(svn_fs_fs__read_min_unpacked_rev(&src_min_unpacked_rev,
-                                               src_fs, pool));
-      SVN_ERR(svn_fs_fs__read_min_unpacked_rev(&dst_min_unpacked_rev,
-                                               dst_fs, pool));
-
-      /* We only support packs coming from the hotcopy source.
-       * The destination should not be packed independently from
-       * the source. This also catches the case where users accidentally
-       * swap the source and destination arguments. */
-      if (src_min_unpacked_rev < dst_min_unpacked_rev)
-        return svn_error_createf(SVN_ERR_UNSUPPORTED_FEATURE, NULL,
-                                 _("The hotcopy destination already contains "
-                                   "more packed revisions (%lu) than the "
-                                   "hotcopy source contains (%lu)"),
-                                   dst_min_unpacked_rev - 1,
-                                   src_min_unpacked_rev - 1);
-
-      SVN_ERR(svn_io_dir_file_copy(src_fs->path, dst_fs->path,
-                                   PATH_MIN_UNPACKED_REV, pool));
-    }
-  else
-    {
-      src_min_unpacked_rev = 0;
-      dst_min_unpacked_rev = 0;
-    }
-
-  if (cancel_func)
-    SVN_ERR(cancel_func(cancel_baton));
+  /* Copied files must be on disk before 'current' or 'min-unpacked-rev'
+   * make them visible in DST_FS.  Only POSIX lets us fsync the read-only
+   * copies, so elsewhere, we keep relying on the OS to write them. */
+#ifdef SVN_ON_POSIX
+  if (dst_ffd->flush_to_disk)
+    SVN_ERR(svn_io__batch_fsync_create(&batch, TRUE, pool));
+#endif
 
   /*
    * Copy the necessary rev files.
@@ -613,10 +982,30 @@ hotcopy_revisions(svn_fs_t *src_fs,
         SVN_ERR(cancel_func(cancel_baton));
 
       /* Copy the packed shard. */
-      SVN_ERR(hotcopy_copy_packed_shard(&skipped, &dst_min_unpacked_rev,
-                                        src_fs, dst_fs,
-                                        rev, max_files_per_dir,
-                                        iterpool));
+#if APR_HAS_THREADS
+      if (copier)
+        SVN_ERR(copier_fetch(&skipped, copier, rev));
+      else
+#endif
+        SVN_ERR(hotcopy_copy_packed_shard(&skipped, src_fs, dst_fs,
+                                          rev, max_files_per_dir, TRUE,
+                                          iterpool));
+
+      /* Flush the new shard to disk before we refer to it. */
+      if (batch && !skipped)
+        {
+          SVN_ERR(schedule_packed_shard_fsync(batch, dst_fs, rev, iterpool));
+          SVN_ERR(svn_io__batch_fsync_run(batch, iterpool));
+        }
+
+      /* If necessary, update the min-unpacked rev file in the hotcopy. */
+      if (dst_min_unpacked_rev < rev + max_files_per_dir)
+        {
+          dst_min_unpacked_rev = rev + max_files_per_dir;
+          SVN_ERR(svn_fs_fs__write_min_unpacked_rev(dst_fs,
+                                                    dst_min_unpacked_rev,
+                                                    iterpool));
+        }
 
       pack_end_rev = rev + max_files_per_dir - 1;
 
@@ -690,24 +1079,39 @@ hotcopy_revisions(svn_fs_t *src_fs,
        * hotcopy with an ENOENT (revision file moved to a pack, so it is no
        * longer where we expect it to be). */
 
-      /* Copy the rev file. */
-      SVN_ERR(hotcopy_copy_shard_file(&skipped,
-                                      src_revs_dir, dst_revs_dir, rev,
-                                      max_files_per_dir,
-                                      iterpool));
-      /* Copy the revprop file. */
-      SVN_ERR(hotcopy_copy_shard_file(&skipped,
-                                      src_revprops_dir, dst_revprops_dir,
-                                      rev, max_files_per_dir,
-                                      iterpool));
+#if APR_HAS_THREADS
+      if (copier)
+        {
+          SVN_ERR(copier_fetch(&skipped, copier, rev));
+        }
+      else
+#endif
+        {
+          /* Copy the rev file. */
+          SVN_ERR(hotcopy_copy_shard_file(&skipped,
+                                          src_revs_dir, dst_revs_dir, rev,
+                                          max_files_per_dir,
+                                          iterpool));
+          /* Copy the revprop file. */
+          SVN_ERR(hotcopy_copy_shard_file(&skipped,
+                                          src_revprops_dir, dst_revprops_dir,
+                                          rev, max_files_per_dir,
+                                          iterpool));
+        }
+
+      if (batch && !skipped)
+        SVN_ERR(schedule_rev_fsync(batch, dst_fs, rev, iterpool));
 
       /* Whenever this revision did not previously exist in the destination,
        * checkpoint the progress via 'current' (do that once per full shard
-       * in order not to slow things down). */
+       * in order not to slow things down).  Flush all files copied so far
+       * in parallel before that. */
       if (rev > dst_youngest)
         {
           if (max_files_per_dir && (rev % max_files_per_dir == 0))
             {
+              if (batch)
+                SVN_ERR(svn_io__batch_fsync_run(batch, iterpool));
               SVN_ERR(svn_fs_fs__write_current(dst_fs, rev, 0, 0,
                                                iterpool));
             }
@@ -718,6 +1122,10 @@ hotcopy_revisions(svn_fs_t *src_fs,
     }
   svn_pool_destroy(iterpool);
 
+  /* Our caller will update 'current' to the final revision. */
+  if (batch)
+    SVN_ERR(svn_io__batch_fsync_run(batch, pool));
+
   /* We assume that all revisions were copied now, i.e. we didn't exit the
    * above loop early. 'rev' was last incremented during exit of the loop. */
   SVN_ERR_ASSERT(rev == src_youngest + 1);
@@ -725,6 +1133,108 @@ hotcopy_revisions(svn_fs_t *src_fs,
   return SVN_NO_ERROR;
 }
 
+/* Copy the revision and revprop files (possibly sharded / packed) from
+ * SRC_FS to DST_FS.  Do not re-copy data which already exists in DST_FS.
+ * When copying packed or unpacked shards, checkpoint the result in DST_FS
+ * for every shard by updating the 'current' file if necessary.  Assume
+ * the >= SVN_FS_FS__MIN_NO_GLOBAL_IDS_FORMAT filesystem format without
+ * global next-ID counters.  Indicate progress via the optional NOTIFY_FUNC
+ * callback using NOTIFY_BATON.  Use POOL for temporary allocations.
+ */
+static svn_error_t *
+hotcopy_revisions(svn_fs_t *src_fs,
+                  svn_fs_t *dst_fs,
+                  svn_revnum_t src_youngest,
+                  svn_revnum_t dst_youngest,
+                  svn_boolean_t incremental,
+                  const char *src_revs_dir,
+                  const char *dst_revs_dir,
+                  const char *src_revprops_dir,
+                  const char *dst_revprops_dir,
+                  svn_fs_hotcopy_notify_t notify_func,
+                  void* notify_baton,
+                  svn_cancel_func_t cancel_func,
+                  void* cancel_baton,
+                  apr_pool_t *pool)
+{
+  fs_fs_data_t *src_ffd = src_fs->fsap_data;
+  int max_files_per_dir = src_ffd->max_files_per_dir;
+  svn_revnum_t src_min_unpacked_rev;
+  svn_revnum_t dst_min_unpacked_rev;
+
+  /* Copy the min unpacked rev, and read its value. */
+  if (src_ffd->format >= SVN_FS_FS__MIN_PACKED_FORMAT)
+    {
+      SVN_ERR(svn_fs_fs__read_min_unpacked_rev(&src_min_unpacked_rev,
+                                               src_fs, pool));
+      SVN_ERR(svn_fs_fs__read_min_unpacked_rev(&dst_min_unpacked_rev,
+                                               dst_fs, pool));
+
+      /* We only support packs coming from the hotcopy source.
+       * The destination should not be packed independently from
+       * the source. This also catches the case where users accidentally
+       * swap the source and destination arguments. */
+      if (src_min_unpacked_rev < dst_min_unpacked_rev)
+        return svn_error_createf(SVN_ERR_UNSUPPORTED_FEATURE, NULL,
+                                 _("The hotcopy destination already contains "
+                                   "more packed revisions (%lu) than the "
+                                   "hotcopy source contains (%lu)"),
+                                   dst_min_unpacked_rev - 1,
+                                   src_min_unpacked_rev - 1);
+
+      SVN_ERR(svn_io_dir_file_copy(src_fs->path, dst_fs->path,
+                                   PATH_MIN_UNPACKED_REV, pool));
+    }
+  else
+    {
+      src_min_unpacked_rev = 0;
+      dst_min_unpacked_rev = 0;
+    }
+
+  if (cancel_func)
+    SVN_ERR(cancel_func(cancel_baton));
+
+#if APR_HAS_THREADS
+  /* Copy multiple shards at once, if allowed and worthwhile. */
+  if (   src_ffd->hotcopy_jobs > 1
+      && max_files_per_dir
+      && src_youngest >= max_files_per_dir)
+    {
+      hotcopy_copier_t *copier;
+      svn_error_t *err;
+
+      SVN_ERR(copier_start(&copier, src_fs, dst_fs, src_youngest,
+                           src_min_unpacked_rev, src_revs_dir, dst_revs_dir,
+                           src_revprops_dir, dst_revprops_dir,
+                           src_ffd->hotcopy_jobs, pool));
+      if (copier)
+        {
+          err = hotcopy_rev_files(src_fs, dst_fs, src_youngest,
+                                  dst_youngest, src_min_unpacked_rev,
+                                  dst_min_unpacked_rev, incremental,
+                                  src_revs_dir, dst_revs_dir,
+                                  src_revprops_dir, dst_revprops_dir,
+                                  copier, notify_func, notify_baton,
+                                  cancel_func, cancel_baton, pool);
+
+          return svn_error_trace(copier_stop(copier, err));
+        }
+    }
+#endif
+
+  return svn_error_trace(hotcopy_rev_files(src_fs, dst_fs, src_youngest,
+                                           dst_youngest,
+                                           src_min_unpacked_rev,
+                                           dst_min_unpacked_rev,
+                                           incremental,
+                                           src_revs_dir, dst_revs_dir,
+                                           src_revprops_dir,
+                                           dst_revprops_dir, NULL,
+                                           notify_func, notify_baton,
+                                           cancel_func, cancel_baton,
+                                           pool));
+}
+
 /* Shortcut for the revision and revprop copying for old (1 or 2) format
  * filesystems without sharding and packing.  Copy the non-sharded revision
  * and revprop files from SRC_FS to DST_FS.  Do not re-copy data which
@@ -925,6 +1435,11 @@ hotcopy_body(void *baton, apr_pool_t *pool)
    * due to the absense of sharding and packing. However, it requires special
    * care when updating the 'current' file (which contains not just the
    * revision number, but also the next-ID counters). */
+  /* Incremental hotcopies may replace revprops that readers of the
+   * destination have already cached. */
+  if (incremental)
+    SVN_ERR(svn_fs_fs__begin_revprop_change(dst_fs, pool));
+
   if (src_ffd->format >= SVN_FS_FS__MIN_NO_GLOBAL_IDS_FORMAT)
     {
       SVN_ERR(hotcopy_revisions(src_fs, dst_fs, src_youngest, dst_youngest,
@@ -945,6 +1460,9 @@ hotcopy_body(void *baton, apr_pool_t *pool)
                                        src_next_copy_id, pool));
     }
 
+  if (incremental)
+    SVN_ERR(svn_fs_fs__end_revprop_change(dst_fs, pool));
+
   /* Replace the locks tree.
    * This is racy in case readers are currently trying to list locks in
    * the destination. However, we need to get rid of stale locks.
@@ -959,6 +1477,10 @@ hotcopy_body(void *baton, apr_pool_t *pool)
                                         PATH_LOCKS_DIR, TRUE,
                                         cancel_func, cancel_baton, pool));
 
+  /* The lock storage comes with the locks tree.  The format file gets
+   * written below. */
+  dst_ffd->lock_log = src_ffd->lock_log;
+
   /* Now copy the node-origins cache tree. */
   src_subdir = svn_dirent_join(src_fs->path, PATH_NODE_ORIGINS_DIR, pool);
   SVN_ERR(svn_io_check_path(src_subdir, &kind, pool));
@@ -1053,12 +1575,18 @@ svn_fs_fs__hotcopy(svn_fs_t *src_fs,
       /* Start out with an empty destination using the same configuration
        * as the source. */
       fs_fs_data_t *src_ffd = src_fs->fsap_data;
+      fs_fs_data_t *dst_ffd;
 
       /* Create the DST_FS repository with the same layout as SRC_FS. */
       SVN_ERR(svn_fs_fs__create_file_tree(dst_fs, dst_path, src_ffd->format,
                                           src_ffd->max_files_per_dir,
                                           src_ffd->use_log_addressing,
                                           pool));
+      dst_ffd = dst_fs->fsap_data;
+      dst_ffd->large_delta_windows = src_ffd->large_delta_windows;
+      dst_ffd->chunked_reps = src_ffd->chunked_reps;
+      dst_ffd->indexed_dirs = src_ffd->indexed_dirs;
+      dst_ffd->zstd_compression = src_ffd->zstd_compression;
 
       /* Copy the UUID.  Hotcopy destination receives a new instance ID, but
        * has the same filesystem UUID as the source. */
@@ -1098,3 +1626,267 @@ svn_fs_fs__hotcopy(svn_fs_t *src_fs,
 
   return SVN_NO_ERROR;
 }
+
+/* Verify that the revision files of SRC_FS can be used verbatim in DST_FS.
+ * Use POOL for temporary allocations. */
+static svn_error_t *
+copy_revisions_check_preconditions(svn_fs_t *src_fs,
+                                   svn_fs_t *dst_fs,
+                                   apr_pool_t *pool)
+{
+  fs_fs_data_t *src_ffd = src_fs->fsap_data;
+  fs_fs_data_t *dst_ffd = dst_fs->fsap_data;
+
+  if (src_ffd->format != dst_ffd->format)
+    return svn_error_createf(SVN_ERR_UNSUPPORTED_FEATURE, NULL,
+      _("The FSFS format (%d) of the source does not match the "
+        "FSFS format (%d) of the destination"),
+      src_ffd->format, dst_ffd->format);
+
+  /* Older formats number their node IDs globally. */
+  if (src_ffd->format < SVN_FS_FS__MIN_NO_GLOBAL_IDS_FORMAT)
+    return svn_error_createf(SVN_ERR_UNSUPPORTED_FEATURE, NULL,
+      _("Copying revisions requires FSFS format %d or newer"),
+      SVN_FS_FS__MIN_NO_GLOBAL_IDS_FORMAT);
+
+  if (src_ffd->max_files_per_dir != dst_ffd->max_files_per_dir)
+    return svn_error_create(SVN_ERR_UNSUPPORTED_FEATURE, NULL,
+                            _("The sharding layout configuration "
+                              "of the source does not match the "
+                              "sharding layout configuration of "
+                              "the destination"));
+
+  if (src_ffd->use_log_addressing != dst_ffd->use_log_addressing)
+    return svn_error_create(SVN_ERR_UNSUPPORTED_FEATURE, NULL,
+                            _("The addressing mode of the source does "
+                              "not match the addressing mode of the "
+                              "destination"));
+
+  if (src_ffd->large_delta_windows && !dst_ffd->large_delta_windows)
+    return svn_error_create(SVN_ERR_UNSUPPORTED_FEATURE, NULL,
+                            _("The source uses large delta windows but "
+                              "the destination does not"));
+  if (src_ffd->chunked_reps && !dst_ffd->chunked_reps)
+    return svn_error_create(SVN_ERR_UNSUPPORTED_FEATURE, NULL,
+                            _("The source uses chunked representations "
+                              "but the destination does not"));
+  if (src_ffd->indexed_dirs && !dst_ffd->indexed_dirs)
+    return svn_error_create(SVN_ERR_UNSUPPORTED_FEATURE, NULL,
+                            _("The source uses indexed directories "
+                              "but the destination does not"));
+  if (src_ffd->zstd_compression && !dst_ffd->zstd_compression)
+    return svn_error_create(SVN_ERR_UNSUPPORTED_FEATURE, NULL,
+                            _("The source uses Zstandard compression "
+                              "but the destination does not"));
+
+  return SVN_NO_ERROR;
+}
+
+/* Baton for copy_revisions_body(). */
+struct copy_revisions_baton
+{
+  svn_fs_t *dst_fs;
+  svn_fs_t *src_fs;
+  svn_revnum_t end_rev;
+  svn_fs_hotcopy_notify_t notify_func;
+  void *notify_baton;
+  svn_cancel_func_t cancel_func;
+  void *cancel_baton;
+};
+
+/* Append the revisions requested in BATON, a struct copy_revisions_baton,
+ * to its DST_FS.  The caller must hold DST_FS' write lock.
+ * Use POOL for temporary allocations. */
+static svn_error_t *
+copy_revisions_body(void *baton, apr_pool_t *pool)
+{
+  struct copy_revisions_baton *crb = baton;
+  svn_fs_t *src_fs = crb->src_fs;
+  svn_fs_t *dst_fs = crb->dst_fs;
+  fs_fs_data_t *src_ffd = src_fs->fsap_data;
+  fs_fs_data_t *dst_ffd = dst_fs->fsap_data;
+  int max_files_per_dir = src_ffd->max_files_per_dir;
+  svn_revnum_t src_youngest;
+  svn_revnum_t dst_youngest;
+  svn_revnum_t published_rev;
+  svn_revnum_t rev;
+  const char *src_revs_dir;
+  const char *dst_revs_dir;
+  const char *src_revprops_dir;
+  const char *dst_revprops_dir;
+  svn_io__batch_fsync_t *batch = NULL;
+  apr_pool_t *iterpool;
+
+  SVN_ERR(svn_fs_fs__youngest_rev(&src_youngest, src_fs, pool));
+  SVN_ERR(svn_fs_fs__youngest_rev(&dst_youngest, dst_fs, pool));
+  if (crb->end_rev > src_youngest)
+    return svn_error_createf(SVN_ERR_FS_NO_SUCH_REVISION, NULL,
+                             _("No such revision %ld"), crb->end_rev);
+  if (crb->end_rev <= dst_youngest)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_fs_fs__update_min_unpacked_rev(src_fs, pool));
+  SVN_ERR(svn_fs_fs__update_min_unpacked_rev(dst_fs, pool));
+
+  src_revs_dir = svn_dirent_join(src_fs->path, PATH_REVS_DIR, pool);
+  dst_revs_dir = svn_dirent_join(dst_fs->path, PATH_REVS_DIR, pool);
+  src_revprops_dir = svn_dirent_join(src_fs->path, PATH_REVPROPS_DIR, pool);
+  dst_revprops_dir = svn_dirent_join(dst_fs->path, PATH_REVPROPS_DIR, pool);
+
+  /* Same as in hotcopy_rev_files(). */
+#ifdef SVN_ON_POSIX
+  if (dst_ffd->flush_to_disk)
+    SVN_ERR(svn_io__batch_fsync_create(&batch, TRUE, pool));
+#endif
+
+  /* Packing the destination below replaces existing revprop files. */
+  SVN_ERR(svn_fs_fs__begin_revprop_change(dst_fs, pool));
+
+  /* Take over the packed shards of SRC_FS that DST_FS has not packed yet.
+   * The revisions that DST_FS already has in them are identical to the
+   * source, so the packs simply replace them. */
+  iterpool = svn_pool_create(pool);
+  for (rev = dst_ffd->min_unpacked_rev;
+          max_files_per_dir
+       && rev < src_ffd->min_unpacked_rev
+       && rev + max_files_per_dir - 1 <= crb->end_rev;
+       rev += max_files_per_dir)
+    {
+      svn_revnum_t pack_end_rev = rev + max_files_per_dir - 1;
+
+      svn_pool_clear(iterpool);
+
+      if (crb->cancel_func)
+        SVN_ERR(crb->cancel_func(crb->cancel_baton));
+
+      /* Revision 0 carries the destination's own revprops. */
+      SVN_ERR(hotcopy_copy_packed_shard(NULL, src_fs, dst_fs, rev,
+                                        max_files_per_dir, FALSE,
+                                        iterpool));
+      if (batch)
+        {
+          SVN_ERR(schedule_packed_shard_fsync(batch, dst_fs, rev, iterpool));
+          SVN_ERR(svn_io__batch_fsync_run(batch, iterpool));
+        }
+
+      SVN_ERR(svn_fs_fs__write_min_unpacked_rev(dst_fs,
+                                                rev + max_files_per_dir,
+                                                iterpool));
+      dst_ffd->min_unpacked_rev = rev + max_files_per_dir;
+
+      if (pack_end_rev > dst_youngest)
+        {
+          SVN_ERR(svn_fs_fs__write_current(dst_fs, pack_end_rev, 0, 0,
+                                           iterpool));
+          if (crb->notify_func)
+            crb->notify_func(crb->notify_baton, MAX(rev, dst_youngest + 1),
+                             pack_end_rev, iterpool);
+          dst_youngest = pack_end_rev;
+        }
+
+      /* Remove the files that the pack has superseded. */
+      SVN_ERR(hotcopy_remove_rev_files(dst_fs, rev, rev + max_files_per_dir,
+                                       max_files_per_dir, iterpool));
+      SVN_ERR(remove_folder(svn_fs_fs__path_rev_shard(dst_fs, rev, iterpool),
+                            crb->cancel_func, crb->cancel_baton, iterpool));
+      if (dst_ffd->format >= SVN_FS_FS__MIN_PACKED_REVPROP_FORMAT
+          && src_ffd->min_unpacked_rev >= rev + max_files_per_dir)
+        {
+          SVN_ERR(hotcopy_remove_revprop_files(dst_fs, rev,
+                                               rev + max_files_per_dir,
+                                               max_files_per_dir,
+                                               iterpool));
+          if (rev > 0)
+            SVN_ERR(remove_folder(svn_fs_fs__path_revprops_shard(dst_fs, rev,
+                                                                 iterpool),
+                                  crb->cancel_func, crb->cancel_baton,
+                                  iterpool));
+        }
+    }
+
+  /* Copy the remaining revisions file by file.  Publish them once per
+   * shard, after they have been flushed to disk. */
+  published_rev = dst_youngest;
+  for (rev = dst_youngest + 1; rev <= crb->end_rev; rev++)
+    {
+      svn_pool_clear(iterpool);
+
+      if (crb->cancel_func)
+        SVN_ERR(crb->cancel_func(crb->cancel_baton));
+
+      if (rev < src_ffd->min_unpacked_rev)
+        return svn_error_createf(SVN_ERR_UNSUPPORTED_FEATURE, NULL,
+                                 _("Can't copy revision %ld on its own "
+                                   "because it is part of a packed shard"),
+                                 rev);
+
+      SVN_ERR(hotcopy_copy_shard_file(NULL, src_revs_dir, dst_revs_dir, rev,
+                                      max_files_per_dir, iterpool));
+      SVN_ERR(hotcopy_copy_shard_file(NULL, src_revprops_dir,
+                                      dst_revprops_dir, rev,
+                                      max_files_per_dir, iterpool));
+      if (batch)
+        SVN_ERR(schedule_rev_fsync(batch, dst_fs, rev, iterpool));
+
+      if (rev == crb->end_rev
+          || (max_files_per_dir && (rev + 1) % max_files_per_dir == 0))
+        {
+          if (batch)
+            SVN_ERR(svn_io__batch_fsync_run(batch, iterpool));
+          SVN_ERR(svn_fs_fs__write_current(dst_fs, rev, 0, 0, iterpool));
+          if (crb->notify_func)
+            crb->notify_func(crb->notify_baton, published_rev + 1, rev,
+                             iterpool);
+          published_rev = rev;
+        }
+    }
+  svn_pool_destroy(iterpool);
+
+  SVN_ERR(svn_fs_fs__end_revprop_change(dst_fs, pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Run copy_revisions_body() with BATON and POOL while SRC_FS cannot be
+ * packed.  The caller must hold all locks of DST_FS. */
+static svn_error_t *
+copy_revisions_locked(void *baton, apr_pool_t *pool)
+{
+  struct copy_revisions_baton *crb = baton;
+  fs_fs_data_t *src_ffd = crb->src_fs->fsap_data;
+
+  if (src_ffd->format >= SVN_FS_FS__MIN_PACK_LOCK_FORMAT)
+    return svn_error_trace(svn_fs_fs__with_pack_lock(crb->src_fs,
+                                                     copy_revisions_body,
+                                                     crb, pool));
+
+  return svn_error_trace(copy_revisions_body(crb, pool));
+}
+
+svn_error_t *
+svn_fs_fs__copy_revisions(svn_fs_t *dst_fs,
+                          svn_fs_t *src_fs,
+                          svn_revnum_t end_rev,
+                          svn_fs_hotcopy_notify_t notify_func,
+                          void *notify_baton,
+                          svn_cancel_func_t cancel_func,
+                          void *cancel_baton,
+                          apr_pool_t *scratch_pool)
+{
+  struct copy_revisions_baton crb;
+
+  SVN_ERR(copy_revisions_check_preconditions(src_fs, dst_fs, scratch_pool));
+
+  crb.dst_fs = dst_fs;
+  crb.src_fs = src_fs;
+  crb.end_rev = end_rev;
+  crb.notify_func = notify_func;
+  crb.notify_baton = notify_baton;
+  crb.cancel_func = cancel_func;
+  crb.cancel_baton = cancel_baton;
+
+  /* Neither repository may get packed while we copy whole shards. */
+  return svn_error_trace(svn_fs_fs__with_all_locks(dst_fs,
+                                                   copy_revisions_locked,
+                                                   &crb, scratch_pool));
+}
@@ -44,4 +44,19 @@ svn_error_t * svn_fs_fs__hotcopy(svn_fs_t *src_fs,
                                  apr_pool_t *pool,
                                  apr_pool_t *common_pool);
 
+/* Append the revisions following the youngest revision of DST_FS up to
+ * END_REV to DST_FS by copying their files verbatim from SRC_FS.  Take
+ * over packed shards of SRC_FS that DST_FS has not packed yet, too.
+ * Indicate progress via the optional NOTIFY_FUNC callback using
+ * NOTIFY_BATON.  Use SCRATCH_POOL for temporary allocations. */
+svn_error_t *
+svn_fs_fs__copy_revisions(svn_fs_t *dst_fs,
+                          svn_fs_t *src_fs,
+                          svn_revnum_t end_rev,
+                          svn_fs_hotcopy_notify_t notify_func,
+                          void *notify_baton,
+                          svn_cancel_func_t cancel_func,
+                          void *cancel_baton,
+                          apr_pool_t *scratch_pool);
+
 #endif
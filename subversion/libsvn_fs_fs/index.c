@@ -1458,6 +1458,75 @@ prefetch_l2p_pages(svn_boolean_t *end,
   return SVN_NO_ERROR;
 }
 
+/* Read the l2p index pages that REV_FILE stores in the same block as
+ * the page described by INFO_BATON, which covers REVISION in FS, and put
+ * them into the cache.  Start with the pages of REVISION and its following
+ * revisions, then do the preceding ones.  If READ_AHEAD is set, extend the
+ * range by one block beyond the current one, which will be useful for
+ * sequential scans.  The page in INFO_BATON itself is not being read.
+ * Use SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+prefetch_l2p_neighbors(svn_fs_t *fs,
+                       svn_fs_fs__revision_file_t *rev_file,
+                       svn_revnum_t revision,
+                       const l2p_page_info_baton_t *info_baton,
+                       svn_boolean_t read_ahead,
+                       apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  apr_array_header_t *pages;
+  svn_revnum_t prefetch_revision;
+  svn_revnum_t last_revision
+    = info_baton->first_revision
+      + (svn_fs_fs__is_packed_rev(fs, revision) ? ffd->max_files_per_dir : 1);
+  svn_boolean_t end;
+  apr_off_t max_offset
+    = APR_ALIGN(info_baton->entry.offset + info_baton->entry.size,
+                ffd->block_size);
+  apr_off_t min_offset = max_offset - ffd->block_size;
+
+  if (read_ahead)
+    max_offset += ffd->block_size;
+
+  /* prefetch pages from following and preceding revisions */
+  pages = apr_array_make(scratch_pool, 16, sizeof(l2p_page_table_entry_t));
+  end = FALSE;
+  for (prefetch_revision = revision;
+      prefetch_revision < last_revision && !end;
+      ++prefetch_revision)
+    {
+      int excluded_page_no = prefetch_revision == revision
+                          ? info_baton->page_no
+                          : -1;
+      svn_pool_clear(iterpool);
+
+      SVN_ERR(prefetch_l2p_pages(&end, fs, rev_file,
+                                info_baton->first_revision,
+                                prefetch_revision, pages,
+                                excluded_page_no, min_offset,
+                                max_offset, iterpool));
+    }
+
+  end = FALSE;
+  for (prefetch_revision = revision-1;
+      prefetch_revision >= info_baton->first_revision && !end;
+      --prefetch_revision)
+    {
+      svn_pool_clear(iterpool);
+
+      SVN_ERR(prefetch_l2p_pages(&end, fs, rev_file,
+                                info_baton->first_revision,
+                                prefetch_revision, pages, -1,
+                                min_offset, max_offset, iterpool));
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
 /* Request data structure for l2p_entry_access_func.
  */
 typedef struct l2p_entry_baton_t
@@ -1566,18 +1635,6 @@ l2p_index_lookup(apr_off_t *offset,
     {
       /* we need to read the info from disk (might already be in the
        * APR file buffer, though) */
-      apr_array_header_t *pages;
-      svn_revnum_t prefetch_revision;
-      svn_revnum_t last_revision
-        = info_baton.first_revision
-          + (key.is_packed ? ffd->max_files_per_dir : 1);
-      svn_boolean_t end;
-      apr_off_t max_offset
-        = APR_ALIGN(info_baton.entry.offset + info_baton.entry.size,
-                    ffd->block_size);
-      apr_off_t min_offset = max_offset - ffd->block_size;
-
-      /* read the relevant page */
       SVN_ERR(get_l2p_page(&page, rev_file, fs, info_baton.first_revision,
                            &info_baton.entry, scratch_pool));
 
@@ -1587,44 +1644,8 @@ l2p_index_lookup(apr_off_t *offset,
                                  scratch_pool));
 
       if (ffd->use_block_read)
-        {
-          apr_pool_t *iterpool = svn_pool_create(scratch_pool);
-
-          /* prefetch pages from following and preceding revisions */
-          pages = apr_array_make(scratch_pool, 16,
-                                 sizeof(l2p_page_table_entry_t));
-          end = FALSE;
-          for (prefetch_revision = revision;
-              prefetch_revision < last_revision && !end;
-              ++prefetch_revision)
-            {
-              int excluded_page_no = prefetch_revision == revision
-                                  ? info_baton.page_no
-                                  : -1;
-              svn_pool_clear(iterpool);
-
-              SVN_ERR(prefetch_l2p_pages(&end, fs, rev_file,
-                                        info_baton.first_revision,
-                                        prefetch_revision, pages,
-                                        excluded_page_no, min_offset,
-                                        max_offset, iterpool));
-            }
-
-          end = FALSE;
-          for (prefetch_revision = revision-1;
-              prefetch_revision >= info_baton.first_revision && !end;
-              --prefetch_revision)
-            {
-              svn_pool_clear(iterpool);
-
-              SVN_ERR(prefetch_l2p_pages(&end, fs, rev_file,
-                                        info_baton.first_revision,
-                                        prefetch_revision, pages, -1,
-                                        min_offset, max_offset, iterpool));
-            }
-
-          svn_pool_destroy(iterpool);
-        }
+        SVN_ERR(prefetch_l2p_neighbors(fs, rev_file, revision, &info_baton,
+                                       FALSE, scratch_pool));
     }
 
   *offset = page_baton.offset;
@@ -1816,6 +1837,231 @@ svn_fs_fs__item_offset(apr_off_t *absolute_position,
   return svn_error_trace(err);
 }
 
+/* A single (REVISION, ITEM_INDEX) request to svn_fs_fs__item_offsets().
+ */
+typedef struct l2p_bulk_request_t
+{
+  svn_revnum_t revision;
+  apr_uint64_t item_index;
+
+  /* position of the request in the caller's ITEMS array */
+  int pos;
+} l2p_bulk_request_t;
+
+/* Implement the comparison function of svn_sort__array: order the
+ * l2p_bulk_request_t elements by revision and item index, i.e. by the
+ * index page that contains them.
+ */
+static int
+compare_l2p_bulk_requests(const void *lhs,
+                          const void *rhs)
+{
+  const l2p_bulk_request_t *a = lhs;
+  const l2p_bulk_request_t *b = rhs;
+
+  if (a->revision != b->revision)
+    return a->revision < b->revision ? -1 : 1;
+
+  if (a->item_index != b->item_index)
+    return a->item_index < b->item_index ? -1 : 1;
+
+  return 0;
+}
+
+/* Request data structure for l2p_entries_access_func.
+ */
+typedef struct l2p_entries_baton_t
+{
+  /* in data */
+  /* revision. Used for error messages only */
+  svn_revnum_t revision;
+
+  /* COUNT requests, all of them on the page that starts with item
+   * FIRST_ITEM_INDEX of REVISION */
+  const l2p_bulk_request_t *requests;
+  int count;
+  apr_uint64_t first_item_index;
+
+  /* out data */
+  /* absolute item or container offsets in rev / pack file, indexed by
+   * the POS of the respective request */
+  apr_off_t *offsets;
+} l2p_entries_baton_t;
+
+/* Return the rev / pack file offsets of all requests in BATON from
+ * OFFSETS of PAGE.
+ */
+static svn_error_t *
+l2p_page_get_entries(l2p_entries_baton_t *baton,
+                     const l2p_page_t *page,
+                     const apr_uint64_t *offsets,
+                     apr_pool_t *scratch_pool)
+{
+  int i;
+
+  for (i = 0; i < baton->count; ++i)
+    {
+      const l2p_bulk_request_t *request = &baton->requests[i];
+      l2p_entry_baton_t entry_baton;
+
+      entry_baton.revision = baton->revision;
+      entry_baton.item_index = request->item_index;
+      entry_baton.page_offset
+        = (apr_uint32_t)(request->item_index - baton->first_item_index);
+
+      SVN_ERR(l2p_page_get_entry(&entry_baton, page, offsets,
+                                 scratch_pool));
+      baton->offsets[request->pos] = (apr_off_t)entry_baton.offset;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Implement svn_cache__partial_getter_func_t: copy the data requested in
+ * l2p_entries_baton_t *BATON from l2p_page_t *DATA into BATON->OFFSETS.
+ * *OUT remains unchanged.
+ */
+static svn_error_t *
+l2p_entries_access_func(void **out,
+                        const void *data,
+                        apr_size_t data_len,
+                        void *baton,
+                        apr_pool_t *result_pool)
+{
+  /* resolve all in-cache pointers */
+  const l2p_page_t *page = data;
+  const apr_uint64_t *offsets
+    = svn_temp_deserializer__ptr(page, (const void *const *)&page->offsets);
+
+  /* return the requested data */
+  return l2p_page_get_entries(baton, page, offsets, result_pool);
+}
+
+svn_error_t *
+svn_fs_fs__item_offsets(apr_array_header_t **offsets,
+                        svn_fs_t *fs,
+                        svn_fs_fs__revision_file_t *rev_file,
+                        const apr_array_header_t *items,
+                        svn_boolean_t prefetch,
+                        apr_pool_t *result_pool,
+                        apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  apr_array_header_t *requests;
+  apr_off_t *result;
+  apr_pool_t *iterpool;
+  int i, k;
+
+  *offsets = apr_array_make(result_pool, items->nelts, sizeof(apr_off_t));
+  (*offsets)->nelts = items->nelts;
+  result = (apr_off_t *)(*offsets)->elts;
+
+  iterpool = svn_pool_create(scratch_pool);
+
+  /* Without log addressing, there are no index pages to share. */
+  if (!svn_fs_fs__use_log_addressing(fs))
+    {
+      for (i = 0; i < items->nelts; ++i)
+        {
+          const svn_fs_fs__id_part_t *item
+            = &APR_ARRAY_IDX(items, i, svn_fs_fs__id_part_t);
+
+          svn_pool_clear(iterpool);
+          SVN_ERR(svn_fs_fs__item_offset(&result[i], fs, rev_file,
+                                         item->revision, NULL, item->number,
+                                         iterpool));
+        }
+
+      svn_pool_destroy(iterpool);
+      return SVN_NO_ERROR;
+    }
+
+  /* Sort the requests such that those on the same page become adjacent. */
+  requests = apr_array_make(scratch_pool, items->nelts,
+                            sizeof(l2p_bulk_request_t));
+  for (i = 0; i < items->nelts; ++i)
+    {
+      const svn_fs_fs__id_part_t *item
+        = &APR_ARRAY_IDX(items, i, svn_fs_fs__id_part_t);
+      l2p_bulk_request_t *request = apr_array_push(requests);
+
+      request->revision = item->revision;
+      request->item_index = item->number;
+      request->pos = i;
+    }
+
+  svn_sort__array(requests, compare_l2p_bulk_requests);
+
+  /* Resolve one page at a time. */
+  for (i = 0; i < requests->nelts; i = k)
+    {
+      const l2p_bulk_request_t *first
+        = &APR_ARRAY_IDX(requests, i, l2p_bulk_request_t);
+      l2p_page_info_baton_t info_baton;
+      l2p_entries_baton_t entries_baton;
+      svn_fs_fs__page_cache_key_t key = { 0 };
+      svn_boolean_t is_cached = FALSE;
+      void *dummy = NULL;
+
+      svn_pool_clear(iterpool);
+
+      /* locate the page containing the first pending request */
+      info_baton.revision = first->revision;
+      info_baton.item_index = first->item_index;
+      SVN_ERR(get_l2p_page_info(&info_baton, rev_file, fs, iterpool));
+
+      /* all following requests up to the end of that page use it, too */
+      entries_baton.revision = first->revision;
+      entries_baton.first_item_index
+        = first->item_index - info_baton.page_offset;
+      entries_baton.requests = first;
+      entries_baton.offsets = result;
+
+      for (k = i + 1; k < requests->nelts; ++k)
+        {
+          const l2p_bulk_request_t *request
+            = &APR_ARRAY_IDX(requests, k, l2p_bulk_request_t);
+          if (   request->revision != first->revision
+              || request->item_index >= entries_baton.first_item_index
+                                        + info_baton.entry.entry_count)
+            break;
+        }
+
+      entries_baton.count = k - i;
+
+      /* try to find the page in the cache and get the offsets from it */
+      assert(first->revision <= APR_UINT32_MAX);
+      key.revision = (apr_uint32_t)first->revision;
+      key.is_packed = svn_fs_fs__is_packed_rev(fs, first->revision);
+      key.page = info_baton.page_no;
+
+      SVN_ERR(svn_cache__get_partial(&dummy, &is_cached,
+                                     ffd->l2p_page_cache, &key,
+                                     l2p_entries_access_func, &entries_baton,
+                                     iterpool));
+
+      if (!is_cached)
+        {
+          l2p_page_t *page = NULL;
+
+          SVN_ERR(get_l2p_page(&page, rev_file, fs,
+                               info_baton.first_revision, &info_baton.entry,
+                               iterpool));
+          SVN_ERR(svn_cache__set(ffd->l2p_page_cache, &key, page, iterpool));
+          SVN_ERR(l2p_page_get_entries(&entries_baton, page, page->offsets,
+                                       iterpool));
+
+          if (prefetch || ffd->use_block_read)
+            SVN_ERR(prefetch_l2p_neighbors(fs, rev_file, first->revision,
+                                           &info_baton, prefetch, iterpool));
+        }
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
 /*
  * phys-to-log index
  */
@@ -200,6 +200,28 @@ svn_fs_fs__item_offset(apr_off_t *absolute_position,
                        apr_uint64_t item_index,
                        apr_pool_t *scratch_pool);
 
+/* Like svn_fs_fs__item_offset but look up all ITEMS of committed
+ * revisions in FS at once and return their absolute positions in
+ * the apr_off_t array *OFFSETS, in the same order.  ITEMS contains
+ * svn_fs_fs__id_part_t elements and all of them must be stored in
+ * REV_FILE.  With log addressing, the items get sorted by index page and
+ * every page gets looked up once.  If PREFETCH is set, read and cache
+ * the pages that are close to the ones read from disk even if block-read
+ * has been disabled, including the following block of the index.  Use it
+ * for sequential scans.
+ *
+ * Allocate *OFFSETS in RESULT_POOL and use SCRATCH_POOL for temporary
+ * allocations.
+ */
+svn_error_t *
+svn_fs_fs__item_offsets(apr_array_header_t **offsets,
+                        svn_fs_t *fs,
+                        svn_fs_fs__revision_file_t *rev_file,
+                        const apr_array_header_t *items,
+                        svn_boolean_t prefetch,
+                        apr_pool_t *result_pool,
+                        apr_pool_t *scratch_pool);
+
 /* Use the log-to-phys indexes in FS to determine the maximum item indexes
  * assigned to revision START_REV to START_REV + COUNT - 1.  That is a
  * close upper limit to the actual number of items in the respective revs.
@@ -26,6 +26,7 @@
 #include "svn_path.h"
 #include "svn_fs.h"
 #include "svn_hash.h"
+#include "svn_sorts.h"
 #include "svn_time.h"
 #include "svn_utf.h"
 
@@ -39,6 +40,7 @@
 #include "util.h"
 #include "../libsvn_fs/fs-loader.h"
 
+#include "private/svn_fs_fs_private.h"
 #include "private/svn_fs_util.h"
 #include "private/svn_fspath.h"
 #include "private/svn_sorts_private.h"
@@ -121,6 +123,82 @@ err_corrupt_lockfile(const char *fs_path, const char *path)
      path, fs_path);
 }
 
+
+/* Store LOCK in HASH, using the hash keys defined above.  Allocate the
+   values in POOL. */
+static void
+lock_to_hash(apr_hash_t *hash,
+             const svn_lock_t *lock,
+             apr_pool_t *pool)
+{
+  const char *creation_date = NULL, *expiration_date = NULL;
+  if (lock->creation_date)
+    creation_date = svn_time_to_cstring(lock->creation_date, pool);
+  if (lock->expiration_date)
+    expiration_date = svn_time_to_cstring(lock->expiration_date, pool);
+  hash_store(hash, PATH_KEY, sizeof(PATH_KEY)-1,
+             lock->path, APR_HASH_KEY_STRING, pool);
+  hash_store(hash, TOKEN_KEY, sizeof(TOKEN_KEY)-1,
+             lock->token, APR_HASH_KEY_STRING, pool);
+  hash_store(hash, OWNER_KEY, sizeof(OWNER_KEY)-1,
+             lock->owner, APR_HASH_KEY_STRING, pool);
+  hash_store(hash, COMMENT_KEY, sizeof(COMMENT_KEY)-1,
+             lock->comment, APR_HASH_KEY_STRING, pool);
+  hash_store(hash, IS_DAV_COMMENT_KEY, sizeof(IS_DAV_COMMENT_KEY)-1,
+             lock->is_dav_comment ? "1" : "0", 1, pool);
+  hash_store(hash, CREATION_DATE_KEY, sizeof(CREATION_DATE_KEY)-1,
+             creation_date, APR_HASH_KEY_STRING, pool);
+  hash_store(hash, EXPIRATION_DATE_KEY, sizeof(EXPIRATION_DATE_KEY)-1,
+             expiration_date, APR_HASH_KEY_STRING, pool);
+}
+
+
+/* Set *LOCK_P to the lock stored in HASH by lock_to_hash(), or to NULL
+   if HASH does not contain a lock path.  The lock will reference the
+   strings in HASH.  FS_PATH is used for error messages only.  Use POOL
+   for all allocations. */
+static svn_error_t *
+lock_from_hash(svn_lock_t **lock_p,
+               apr_hash_t *hash,
+               const char *fs_path,
+               apr_pool_t *pool)
+{
+  svn_lock_t *lock;
+  const char *path = hash_fetch(hash, PATH_KEY);
+  const char *val;
+
+  /* If we have a lock path in our hash, we'll assume we have a lock. */
+  *lock_p = NULL;
+  if (! path)
+    return SVN_NO_ERROR;
+
+  /* Create our lock and load it up. */
+  lock = svn_lock_create(pool);
+  lock->path = path;
+
+  if (! ((lock->token = hash_fetch(hash, TOKEN_KEY))))
+    return svn_error_trace(err_corrupt_lockfile(fs_path, path));
+
+  if (! ((lock->owner = hash_fetch(hash, OWNER_KEY))))
+    return svn_error_trace(err_corrupt_lockfile(fs_path, path));
+
+  if (! ((val = hash_fetch(hash, IS_DAV_COMMENT_KEY))))
+    return svn_error_trace(err_corrupt_lockfile(fs_path, path));
+  lock->is_dav_comment = (val[0] == '1');
+
+  if (! ((val = hash_fetch(hash, CREATION_DATE_KEY))))
+    return svn_error_trace(err_corrupt_lockfile(fs_path, path));
+  SVN_ERR(svn_time_from_cstring(&(lock->creation_date), val, pool));
+
+  if ((val = hash_fetch(hash, EXPIRATION_DATE_KEY)))
+    SVN_ERR(svn_time_from_cstring(&(lock->expiration_date), val, pool));
+
+  lock->comment = hash_fetch(hash, COMMENT_KEY);
+
+  *lock_p = lock;
+  return SVN_NO_ERROR;
+}
+
 
 /*** Digest file handling functions. ***/
 
@@ -182,27 +260,7 @@ write_digest_file(apr_hash_t *children,
                                        fs_path, pool));
 
   if (lock)
-    {
-      const char *creation_date = NULL, *expiration_date = NULL;
-      if (lock->creation_date)
-        creation_date = svn_time_to_cstring(lock->creation_date, pool);
-      if (lock->expiration_date)
-        expiration_date = svn_time_to_cstring(lock->expiration_date, pool);
-      hash_store(hash, PATH_KEY, sizeof(PATH_KEY)-1,
-                 lock->path, APR_HASH_KEY_STRING, pool);
-      hash_store(hash, TOKEN_KEY, sizeof(TOKEN_KEY)-1,
-                 lock->token, APR_HASH_KEY_STRING, pool);
-      hash_store(hash, OWNER_KEY, sizeof(OWNER_KEY)-1,
-                 lock->owner, APR_HASH_KEY_STRING, pool);
-      hash_store(hash, COMMENT_KEY, sizeof(COMMENT_KEY)-1,
-                 lock->comment, APR_HASH_KEY_STRING, pool);
-      hash_store(hash, IS_DAV_COMMENT_KEY, sizeof(IS_DAV_COMMENT_KEY)-1,
-                 lock->is_dav_comment ? "1" : "0", 1, pool);
-      hash_store(hash, CREATION_DATE_KEY, sizeof(CREATION_DATE_KEY)-1,
-                 creation_date, APR_HASH_KEY_STRING, pool);
-      hash_store(hash, EXPIRATION_DATE_KEY, sizeof(EXPIRATION_DATE_KEY)-1,
-                 expiration_date, APR_HASH_KEY_STRING, pool);
-    }
+    lock_to_hash(hash, lock, pool);
   if (apr_hash_count(children))
     {
       svn_stringbuf_t *children_list = svn_stringbuf_create_empty(pool);
@@ -248,7 +306,6 @@ read_digest_file(apr_hash_t **children_p,
                  apr_pool_t *pool)
 {
   svn_error_t *err = SVN_NO_ERROR;
-  svn_lock_t *lock;
   apr_hash_t *hash;
   svn_stream_t *stream;
   const char *val;
@@ -281,38 +338,9 @@ read_digest_file(apr_hash_t **children_p,
     }
   SVN_ERR(svn_stream_close(stream));
 
-  /* If our caller cares, see if we have a lock path in our hash. If
-     so, we'll assume we have a lock here. */
-  val = hash_fetch(hash, PATH_KEY);
-  if (val && lock_p)
-    {
-      const char *path = val;
-
-      /* Create our lock and load it up. */
-      lock = svn_lock_create(pool);
-      lock->path = path;
-
-      if (! ((lock->token = hash_fetch(hash, TOKEN_KEY))))
-        return svn_error_trace(err_corrupt_lockfile(fs_path, path));
-
-      if (! ((lock->owner = hash_fetch(hash, OWNER_KEY))))
-        return svn_error_trace(err_corrupt_lockfile(fs_path, path));
-
-      if (! ((val = hash_fetch(hash, IS_DAV_COMMENT_KEY))))
-        return svn_error_trace(err_corrupt_lockfile(fs_path, path));
-      lock->is_dav_comment = (val[0] == '1');
-
-      if (! ((val = hash_fetch(hash, CREATION_DATE_KEY))))
-        return svn_error_trace(err_corrupt_lockfile(fs_path, path));
-      SVN_ERR(svn_time_from_cstring(&(lock->creation_date), val, pool));
-
-      if ((val = hash_fetch(hash, EXPIRATION_DATE_KEY)))
-        SVN_ERR(svn_time_from_cstring(&(lock->expiration_date), val, pool));
-
-      lock->comment = hash_fetch(hash, COMMENT_KEY);
-
-      *lock_p = lock;
-    }
+  /* If our caller cares, see if we have a lock in our hash. */
+  if (lock_p)
+    SVN_ERR(lock_from_hash(lock_p, hash, fs_path, pool));
 
   /* If our caller cares, see if we have any children for this path. */
   val = hash_fetch(hash, CHILDREN_KEY);
@@ -332,6 +360,635 @@ read_digest_file(apr_hash_t **children_p,
 
 
 
+/*** Lock log handling functions. ***/
+
+/* Instead of the digest file tree, a repository may keep all its locks
+   in a single file, PATH_LOCK_LOG within PATH_LOCKS_DIR.  The "locks"
+   option in the format file selects this storage, such that releases
+   that don't support it refuse to open the repository.
+
+   The log starts with a header line consisting of LOCK_LOG_HEADER and
+   a UUID that changes whenever the log gets rewritten.  It is followed
+   by a sequence of records, each consisting of a line "L <len>" or
+   "U <len>" and LEN bytes of hash data.  The latter uses the same keys
+   as the digest files.  "L" records contain a lock that replaces any
+   previous lock on the same path and "U" records just the path of a lock
+   that got removed.
+
+   Records are only ever appended, under the repository write lock, and
+   readers ignore incomplete records at the end of the file.  Once the
+   number of records exceeds LOCK_LOG_COMPACT_MIN as well as
+   LOCK_LOG_COMPACT_RATIO times the number of actual locks, the log gets
+   replaced by one that contains the current locks only, sorted by path.
+
+   Because existing parts of the log never change, every process keeps
+   an index of its contents in the shared FS data and only needs to read
+   what has been appended since the last time. */
+
+#define LOCK_LOG_HEADER "locks-1 "
+#define LOCK_LOG_COMPACT_MIN 1000
+#define LOCK_LOG_COMPACT_RATIO 2
+
+/* In-memory index of the lock log of a repository. */
+struct fs_fs_lock_index_t
+{
+  /* Header line of the log file that we indexed.  NULL if the index
+     is empty. */
+  const char *header;
+
+  /* Offset within the log file up to which we parsed all records. */
+  apr_off_t offset;
+
+  /* Number of records parsed so far. */
+  apr_int64_t records;
+
+  /* Map from const char * path to svn_lock_t *. */
+  apr_hash_t *locks;
+
+  /* The keys of LOCKS ordered by svn_sort_compare_paths().  Only valid
+     if SORTED_VALID is set. */
+  apr_array_header_t *sorted;
+  svn_boolean_t sorted_valid;
+
+  /* All of the above is allocated in this pool.  It gets cleared when
+     the log file has been replaced. */
+  apr_pool_t *pool;
+
+  /* Serializes access to this structure. */
+  svn_mutex__t *mutex;
+};
+
+/* Return the path of the lock log in the filesystem at FS_PATH. */
+static const char *
+path_lock_log(const char *fs_path,
+              apr_pool_t *pool)
+{
+  return svn_dirent_join_many(pool, fs_path, PATH_LOCKS_DIR, PATH_LOCK_LOG,
+                              SVN_VA_NULL);
+}
+
+/* SVN_ERR_FS_CORRUPT: the lock log in FS is corrupt.  */
+static svn_error_t *
+err_corrupt_lock_log(const char *fs_path)
+{
+  return
+    svn_error_createf(
+     SVN_ERR_FS_CORRUPT, 0,
+     _("Corrupt lock log in filesystem '%s'"),
+     fs_path);
+}
+
+/* Drop all contents from INDEX and make it represent an empty log file
+   with header line HEADER.  HEADER may be NULL and does not need to
+   survive this call. */
+static void
+reset_lock_index(fs_fs_lock_index_t *index,
+                 const char *header)
+{
+  svn_pool_clear(index->pool);
+
+  index->header = header ? apr_pstrdup(index->pool, header) : NULL;
+  index->offset = header ? strlen(header) + 1 : 0;
+  index->records = 0;
+  index->locks = apr_hash_make(index->pool);
+  index->sorted = apr_array_make(index->pool, 0, sizeof(const char *));
+  index->sorted_valid = TRUE;
+}
+
+/* Make sure INDEX->SORTED is valid. */
+static void
+sort_lock_index(fs_fs_lock_index_t *index)
+{
+  apr_hash_index_t *hi;
+
+  if (index->sorted_valid)
+    return;
+
+  apr_array_clear(index->sorted);
+  for (hi = apr_hash_first(NULL, index->locks); hi; hi = apr_hash_next(hi))
+    APR_ARRAY_PUSH(index->sorted, const char *) = apr_hash_this_key(hi);
+
+  svn_sort__array(index->sorted, svn_sort_compare_paths);
+  index->sorted_valid = TRUE;
+}
+
+/* Apply the lock log records in CONTENT, which has been read from the log
+   file at INDEX->OFFSET, to INDEX.  Stop at the first incomplete record.
+   FS_PATH is used for error messages only.  Use SCRATCH_POOL for
+   temporary allocations. */
+static svn_error_t *
+parse_lock_records(fs_fs_lock_index_t *index,
+                   const svn_stringbuf_t *content,
+                   const char *fs_path,
+                   apr_pool_t *scratch_pool)
+{
+  apr_size_t pos = 0;
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+
+  while (pos < content->len)
+    {
+      const char *line = content->data + pos;
+      const char *eol = memchr(line, '\n', content->len - pos);
+      apr_uint64_t len;
+      apr_size_t data_pos;
+      svn_string_t data;
+      apr_hash_t *hash;
+      svn_lock_t *lock;
+      svn_error_t *err;
+
+      /* The writer may still be busy appending this record. */
+      if (! eol)
+        break;
+
+      svn_pool_clear(iterpool);
+      if ((line[0] != 'L' && line[0] != 'U') || line[1] != ' ')
+        return svn_error_trace(err_corrupt_lock_log(fs_path));
+
+      err = svn_cstring_strtoui64(&len,
+                                  apr_pstrmemdup(iterpool, line + 2,
+                                                 eol - line - 2),
+                                  0, APR_SIZE_MAX, 10);
+      if (err)
+        return svn_error_compose_create(err_corrupt_lock_log(fs_path), err);
+
+      data_pos = eol - content->data + 1;
+      if (len > content->len - data_pos)
+        break;
+
+      data.data = content->data + data_pos;
+      data.len = (apr_size_t)len;
+      hash = apr_hash_make(iterpool);
+      SVN_ERR(svn_hash_read2(hash, svn_stream_from_string(&data, iterpool),
+                             SVN_HASH_TERMINATOR, iterpool));
+
+      if (line[0] == 'L')
+        {
+          SVN_ERR(lock_from_hash(&lock, hash, fs_path, iterpool));
+          if (! lock)
+            return svn_error_trace(err_corrupt_lock_log(fs_path));
+
+          lock = svn_lock_dup(lock, index->pool);
+          if (! svn_hash_gets(index->locks, lock->path))
+            index->sorted_valid = FALSE;
+
+          svn_hash_sets(index->locks, lock->path, lock);
+        }
+      else
+        {
+          const char *path = hash_fetch(hash, PATH_KEY);
+          if (! path)
+            return svn_error_trace(err_corrupt_lock_log(fs_path));
+
+          if (svn_hash_gets(index->locks, path))
+            {
+              svn_hash_sets(index->locks, path, NULL);
+              index->sorted_valid = FALSE;
+            }
+        }
+
+      pos = data_pos + (apr_size_t)len;
+      index->records++;
+    }
+
+  index->offset += pos;
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Bring INDEX up to date with the lock log of FS and set *IN_USE.  If FS
+   does not use a lock log, set *IN_USE to FALSE and empty INDEX.
+
+   INDEX->MUTEX must be held by the caller.  Use SCRATCH_POOL for
+   temporary allocations. */
+static svn_error_t *
+refresh_lock_index(svn_boolean_t *in_use,
+                   fs_fs_lock_index_t *index,
+                   svn_fs_t *fs,
+                   apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  apr_file_t *file = NULL;
+  svn_stringbuf_t *header;
+  svn_boolean_t eof;
+  apr_off_t size;
+  svn_error_t *err;
+
+  if (ffd->lock_log)
+    {
+      err = svn_io_file_open(&file, path_lock_log(fs->path, scratch_pool),
+                             APR_READ | APR_BUFFERED, APR_OS_DEFAULT,
+                             scratch_pool);
+      if (err && APR_STATUS_IS_ENOENT(err->apr_err))
+        {
+          /* The locks may have been converted to digest files since we
+             read the format file.  Otherwise, the log is simply gone. */
+          svn_error_clear(err);
+          SVN_ERR(svn_fs_fs__read_format_file(fs, scratch_pool));
+          if (ffd->lock_log)
+            return svn_error_trace(err_corrupt_lock_log(fs->path));
+        }
+      else
+        SVN_ERR(err);
+    }
+
+  if (! file)
+    {
+      if (index->header)
+        reset_lock_index(index, NULL);
+
+      *in_use = FALSE;
+      return SVN_NO_ERROR;
+    }
+
+  SVN_ERR(svn_io_file_readline(file, &header, NULL, &eof, 128,
+                               scratch_pool, scratch_pool));
+  if (eof || strncmp(header->data, LOCK_LOG_HEADER,
+                     sizeof(LOCK_LOG_HEADER) - 1))
+    return svn_error_trace(err_corrupt_lock_log(fs->path));
+
+  /* A different header means that the log has been replaced. */
+  SVN_ERR(svn_io_file_size_get(&size, file, scratch_pool));
+  if (   !index->header
+      || strcmp(index->header, header->data)
+      || size < index->offset)
+    reset_lock_index(index, header->data);
+
+  if (size > index->offset)
+    {
+      apr_off_t offset = index->offset;
+      apr_size_t len = (apr_size_t)(size - offset);
+      svn_stringbuf_t *content = svn_stringbuf_create_ensure(len,
+                                                             scratch_pool);
+
+      SVN_ERR(svn_io_file_seek(file, APR_SET, &offset, scratch_pool));
+      SVN_ERR(svn_io_file_read_full2(file, content->data, len, &content->len,
+                                     NULL, scratch_pool));
+      content->data[content->len] = '\0';
+
+      SVN_ERR(parse_lock_records(index, content, fs->path, scratch_pool));
+    }
+
+  SVN_ERR(svn_io_file_close(file, scratch_pool));
+  *in_use = TRUE;
+
+  return SVN_NO_ERROR;
+}
+
+/* Append a lock log record for HASH to BUFFER.  KIND is either 'L' or 'U'.
+   Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+append_lock_record(svn_stringbuf_t *buffer,
+                   char kind,
+                   apr_hash_t *hash,
+                   apr_pool_t *scratch_pool)
+{
+  svn_stringbuf_t *data = svn_stringbuf_create_empty(scratch_pool);
+  svn_stream_t *stream = svn_stream_from_stringbuf(data, scratch_pool);
+
+  SVN_ERR(svn_hash_write2(hash, stream, SVN_HASH_TERMINATOR, scratch_pool));
+  SVN_ERR(svn_stream_close(stream));
+
+  svn_stringbuf_appendcstr(buffer,
+                           apr_psprintf(scratch_pool, "%c %" APR_SIZE_T_FMT
+                                        "\n", kind, data->len));
+  svn_stringbuf_appendstr(buffer, data);
+
+  return SVN_NO_ERROR;
+}
+
+/* Replace the lock log of FS with a new one containing the svn_lock_t *
+   LOCKS, in that order.  Return the new header line in *HEADER and the
+   size of the file in *SIZE.  Set the permissions of the file to those
+   of PERMS_REFERENCE.  Allocate *HEADER in RESULT_POOL and use
+   SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+write_lock_log(const char **header,
+               apr_off_t *size,
+               svn_fs_t *fs,
+               const apr_array_header_t *locks,
+               const char *perms_reference,
+               apr_pool_t *result_pool,
+               apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  const char *log_path = path_lock_log(fs->path, scratch_pool);
+  const char *tmp_path;
+  svn_stringbuf_t *buffer;
+  svn_stream_t *stream;
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  int i;
+
+  *header = apr_pstrcat(result_pool, LOCK_LOG_HEADER,
+                        svn_uuid_generate(scratch_pool), SVN_VA_NULL);
+  *size = strlen(*header) + 1;
+
+  SVN_ERR(svn_fs_fs__ensure_dir_exists(svn_dirent_join(fs->path,
+                                                       PATH_LOCKS_DIR,
+                                                       scratch_pool),
+                                       fs->path, scratch_pool));
+  SVN_ERR(svn_stream_open_unique(&stream, &tmp_path,
+                                 svn_dirent_dirname(log_path, scratch_pool),
+                                 svn_io_file_del_none,
+                                 scratch_pool, scratch_pool));
+  SVN_ERR(svn_stream_printf(stream, scratch_pool, "%s\n", *header));
+
+  buffer = svn_stringbuf_create_empty(scratch_pool);
+  for (i = 0; i < locks->nelts; ++i)
+    {
+      const svn_lock_t *lock = APR_ARRAY_IDX(locks, i, const svn_lock_t *);
+      apr_hash_t *hash;
+      apr_size_t len;
+
+      svn_pool_clear(iterpool);
+      svn_stringbuf_setempty(buffer);
+
+      hash = apr_hash_make(iterpool);
+      lock_to_hash(hash, lock, iterpool);
+      SVN_ERR(append_lock_record(buffer, 'L', hash, iterpool));
+
+      len = buffer->len;
+      SVN_ERR(svn_stream_write(stream, buffer->data, &len));
+      *size += len;
+    }
+
+  SVN_ERR(svn_stream_close(stream));
+  SVN_ERR(svn_io_file_rename2(tmp_path, log_path, ffd->flush_to_disk,
+                              scratch_pool));
+  SVN_ERR(svn_io_copy_perms(perms_reference, log_path, scratch_pool));
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Rewrite the lock log of FS if it contains too many obsolete records.
+   INDEX must be up to date and its mutex be held by the caller.
+   Use PERMS_REFERENCE for the permissions of the new log file.
+   Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+compact_lock_log(fs_fs_lock_index_t *index,
+                 svn_fs_t *fs,
+                 const char *perms_reference,
+                 apr_pool_t *scratch_pool)
+{
+  apr_array_header_t *locks;
+  const char *header;
+  apr_off_t size;
+  int i;
+
+  if (   index->records < LOCK_LOG_COMPACT_MIN
+      || index->records <= (apr_int64_t)LOCK_LOG_COMPACT_RATIO
+                           * apr_hash_count(index->locks))
+    return SVN_NO_ERROR;
+
+  /* Store the current locks in path order.  This keeps the records for any
+     sub-tree close together in the new log. */
+  sort_lock_index(index);
+  locks = apr_array_make(scratch_pool, index->sorted->nelts,
+                         sizeof(svn_lock_t *));
+  for (i = 0; i < index->sorted->nelts; ++i)
+    APR_ARRAY_PUSH(locks, svn_lock_t *)
+      = svn_hash_gets(index->locks,
+                      APR_ARRAY_IDX(index->sorted, i, const char *));
+
+  SVN_ERR(write_lock_log(&header, &size, fs, locks, perms_reference,
+                         index->pool, scratch_pool));
+
+  /* The contents of the new log is what we already have in memory. */
+  index->header = header;
+  index->offset = size;
+  index->records = locks->nelts;
+
+  return SVN_NO_ERROR;
+}
+
+/* Baton type for the lock log functions below, needed for the
+   SVN_MUTEX__WITH_LOCK calls. */
+typedef struct lock_log_baton_t
+{
+  svn_fs_t *fs;
+  fs_fs_lock_index_t *index;
+
+  /* Whether the FS uses a lock log at all. */
+  svn_boolean_t in_use;
+
+  /* Path to look up or sub-tree to list. */
+  const char *path;
+
+  /* Result of the lookup of PATH. */
+  svn_lock_t *lock;
+
+  /* Locks to list or to store, svn_lock_t * elements. */
+  apr_array_header_t *locks;
+
+  /* Paths to unlock, const char * elements. */
+  const apr_array_header_t *unlocked;
+
+  /* Buffer containing the records to append to the log. */
+  svn_stringbuf_t *records;
+
+  const char *perms_reference;
+  apr_pool_t *result_pool;
+  apr_pool_t *scratch_pool;
+} lock_log_baton_t;
+
+/* Initialize B for FS, using RESULT_POOL and SCRATCH_POOL. */
+static void
+init_lock_log_baton(lock_log_baton_t *b,
+                    svn_fs_t *fs,
+                    apr_pool_t *result_pool,
+                    apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+
+  memset(b, 0, sizeof(*b));
+  b->fs = fs;
+  b->index = ffd->shared->lock_index;
+  b->result_pool = result_pool;
+  b->scratch_pool = scratch_pool;
+}
+
+/* Set B->IN_USE and, if that is set, B->LOCK to a copy of the lock on
+   B->PATH in the lock log of B->FS. */
+static svn_error_t *
+get_logged_lock_body(lock_log_baton_t *b)
+{
+  svn_lock_t *lock;
+
+  SVN_ERR(refresh_lock_index(&b->in_use, b->index, b->fs, b->scratch_pool));
+  if (! b->in_use)
+    return SVN_NO_ERROR;
+
+  lock = svn_hash_gets(b->index->locks, b->path);
+  b->lock = lock ? svn_lock_dup(lock, b->result_pool) : NULL;
+
+  return SVN_NO_ERROR;
+}
+
+/* Set B->IN_USE and, if that is set, add copies of all locks at or below
+   B->PATH in the lock log of B->FS to B->LOCKS, in path order. */
+static svn_error_t *
+get_logged_locks_body(lock_log_baton_t *b)
+{
+  fs_fs_lock_index_t *index = b->index;
+  int i;
+
+  SVN_ERR(refresh_lock_index(&b->in_use, index, b->fs, b->scratch_pool));
+  if (! b->in_use)
+    return SVN_NO_ERROR;
+
+  /* The locks of any sub-tree form a consecutive section in path order. */
+  sort_lock_index(index);
+  for (i = svn_sort__bsearch_lower_bound(index->sorted, &b->path,
+                                         svn_sort_compare_paths);
+       i < index->sorted->nelts;
+       ++i)
+    {
+      const char *path = APR_ARRAY_IDX(index->sorted, i, const char *);
+      if (! svn_fspath__skip_ancestor(b->path, path))
+        break;
+
+      APR_ARRAY_PUSH(b->locks, svn_lock_t *)
+        = svn_lock_dup(svn_hash_gets(index->locks, path), b->result_pool);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Append B->RECORDS to the lock log of B->FS that must exist, update
+   B->INDEX accordingly and compact the log if necessary. */
+static svn_error_t *
+append_lock_log_body(lock_log_baton_t *b)
+{
+  fs_fs_data_t *ffd = b->fs->fsap_data;
+  apr_file_t *file;
+
+  /* Other processes may have modified the log before we got the
+     repository write lock.  Catch up before appending to it - not
+     because we have to but to get a meaningful file offset. */
+  SVN_ERR(refresh_lock_index(&b->in_use, b->index, b->fs, b->scratch_pool));
+  if (! b->in_use)
+    return svn_error_trace(err_corrupt_lock_log(b->fs->path));
+
+  SVN_ERR(svn_io_file_open(&file, path_lock_log(b->fs->path, b->scratch_pool),
+                           APR_WRITE | APR_APPEND, APR_OS_DEFAULT,
+                           b->scratch_pool));
+  SVN_ERR(svn_io_file_write_full(file, b->records->data, b->records->len,
+                                 NULL, b->scratch_pool));
+  if (ffd->flush_to_disk)
+    SVN_ERR(svn_io_file_flush_to_disk(file, b->scratch_pool));
+  SVN_ERR(svn_io_file_close(file, b->scratch_pool));
+
+  /* Read back what we just wrote. */
+  SVN_ERR(refresh_lock_index(&b->in_use, b->index, b->fs, b->scratch_pool));
+  SVN_ERR(compact_lock_log(b->index, b->fs, b->perms_reference,
+                           b->scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* If FS uses a lock log, set *IN_USE to TRUE and *LOCK_P to the lock on
+   PATH, or to NULL if PATH is not locked.  Otherwise, set *IN_USE to
+   FALSE.  Allocate *LOCK_P in POOL. */
+static svn_error_t *
+get_logged_lock(svn_boolean_t *in_use,
+                svn_lock_t **lock_p,
+                svn_fs_t *fs,
+                const char *path,
+                apr_pool_t *pool)
+{
+  lock_log_baton_t baton;
+
+  init_lock_log_baton(&baton, fs, pool, pool);
+  baton.path = path;
+  SVN_MUTEX__WITH_LOCK(baton.index->mutex, get_logged_lock_body(&baton));
+
+  *in_use = baton.in_use;
+  *lock_p = baton.lock;
+
+  return SVN_NO_ERROR;
+}
+
+/* If FS uses a lock log, set *IN_USE to TRUE and *LOCKS to an array of
+   all svn_lock_t * at or below PATH, in path order.  Otherwise, set
+   *IN_USE to FALSE.  Allocate *LOCKS in RESULT_POOL and use SCRATCH_POOL
+   for temporaries. */
+static svn_error_t *
+get_logged_locks(svn_boolean_t *in_use,
+                 apr_array_header_t **locks,
+                 svn_fs_t *fs,
+                 const char *path,
+                 apr_pool_t *result_pool,
+                 apr_pool_t *scratch_pool)
+{
+  lock_log_baton_t baton;
+
+  init_lock_log_baton(&baton, fs, result_pool, scratch_pool);
+  baton.path = path;
+  baton.locks = apr_array_make(result_pool, 0, sizeof(svn_lock_t *));
+  SVN_MUTEX__WITH_LOCK(baton.index->mutex, get_logged_locks_body(&baton));
+
+  *in_use = baton.in_use;
+  *locks = baton.locks;
+
+  return SVN_NO_ERROR;
+}
+
+/* Add the svn_lock_t * LOCKS to the lock log of FS and remove the locks
+   on the const char * paths in UNLOCKED from it.  Either array may be
+   NULL.  Use PERMS_REFERENCE for the permissions of the log file, should
+   it need to be replaced.  This assumes that the write lock is held and
+   FS uses a lock log.  Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+write_logged_locks(svn_fs_t *fs,
+                   const apr_array_header_t *locks,
+                   const apr_array_header_t *unlocked,
+                   const char *perms_reference,
+                   apr_pool_t *scratch_pool)
+{
+  lock_log_baton_t baton;
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  int i;
+
+  init_lock_log_baton(&baton, fs, scratch_pool, scratch_pool);
+  baton.perms_reference = perms_reference;
+  baton.records = svn_stringbuf_create_empty(scratch_pool);
+
+  /* Serialize all changes into a single chunk such that they will be
+     appended to the log in a single write. */
+  for (i = 0; locks && i < locks->nelts; ++i)
+    {
+      const svn_lock_t *lock = APR_ARRAY_IDX(locks, i, const svn_lock_t *);
+      apr_hash_t *hash;
+
+      svn_pool_clear(iterpool);
+      hash = apr_hash_make(iterpool);
+      lock_to_hash(hash, lock, iterpool);
+      SVN_ERR(append_lock_record(baton.records, 'L', hash, iterpool));
+    }
+
+  for (i = 0; unlocked && i < unlocked->nelts; ++i)
+    {
+      const char *path = APR_ARRAY_IDX(unlocked, i, const char *);
+      apr_hash_t *hash;
+
+      svn_pool_clear(iterpool);
+      hash = apr_hash_make(iterpool);
+      hash_store(hash, PATH_KEY, sizeof(PATH_KEY)-1,
+                 path, APR_HASH_KEY_STRING, iterpool);
+      SVN_ERR(append_lock_record(baton.records, 'U', hash, iterpool));
+    }
+
+  svn_pool_destroy(iterpool);
+
+  if (baton.records->len)
+    SVN_MUTEX__WITH_LOCK(baton.index->mutex, append_lock_log_body(&baton));
+
+  return SVN_NO_ERROR;
+}
+
+
 /*** Lock helper functions (path here are still FS paths, not on-disk
      schema-supporting paths) ***/
 
@@ -474,13 +1131,18 @@ get_lock(svn_lock_t **lock_p,
   svn_lock_t *lock = NULL;
   const char *digest_path;
   svn_node_kind_t kind;
-
-  SVN_ERR(digest_path_from_path(&digest_path, fs->path, path, pool));
-  SVN_ERR(svn_io_check_path(digest_path, &kind, pool));
+  svn_boolean_t use_log;
 
   *lock_p = NULL;
-  if (kind != svn_node_none)
-    SVN_ERR(read_digest_file(NULL, &lock, fs->path, digest_path, pool));
+  SVN_ERR(get_logged_lock(&use_log, &lock, fs, path, pool));
+  if (! use_log)
+    {
+      SVN_ERR(digest_path_from_path(&digest_path, fs->path, path, pool));
+      SVN_ERR(svn_io_check_path(digest_path, &kind, pool));
+
+      if (kind != svn_node_none)
+        SVN_ERR(read_digest_file(NULL, &lock, fs->path, digest_path, pool));
+    }
 
   if (! lock)
     return must_exist ? SVN_FS__ERR_NO_SUCH_LOCK(fs, path) : SVN_NO_ERROR;
@@ -539,7 +1201,7 @@ get_lock_helper(svn_fs_t *fs,
    has the FS write lock. */
 static svn_error_t *
 walk_locks(svn_fs_t *fs,
-           const char *digest_path,
+           const char *path,
            svn_fs_get_locks_callback_t get_locks_func,
            void *get_locks_baton,
            svn_boolean_t have_write_lock,
@@ -549,8 +1211,39 @@ walk_locks(svn_fs_t *fs,
   apr_hash_t *children;
   apr_pool_t *subpool;
   svn_lock_t *lock;
+  const char *digest_path;
+  apr_array_header_t *locks;
+  svn_boolean_t use_log;
+  int i;
+
+  /* With a lock log, we get all locks of the sub-tree in one go. */
+  SVN_ERR(get_logged_locks(&use_log, &locks, fs, path, pool, pool));
+  if (use_log)
+    {
+      subpool = svn_pool_create(pool);
+      for (i = 0; i < locks->nelts; ++i)
+        {
+          lock = APR_ARRAY_IDX(locks, i, svn_lock_t *);
+          svn_pool_clear(subpool);
+
+          if (lock_expired(lock))
+            {
+              /* Only remove the lock if we have the write lock.
+                 Read operations shouldn't change the filesystem. */
+              if (have_write_lock)
+                SVN_ERR(unlock_single(fs, lock, subpool));
+            }
+          else
+            {
+              SVN_ERR(get_locks_func(get_locks_baton, lock, subpool));
+            }
+        }
+      svn_pool_destroy(subpool);
+      return SVN_NO_ERROR;
+    }
 
   /* First, send up any locks in the current digest file. */
+  SVN_ERR(digest_path_from_path(&digest_path, fs->path, path, pool));
   SVN_ERR(read_digest_file(&children, &lock, fs->path, digest_path, pool));
 
   if (lock && lock_expired(lock))
@@ -652,9 +1345,7 @@ svn_fs_fs__allow_locked_operation(const char *path,
   if (recurse)
     {
       /* Discover all locks at or below the path. */
-      const char *digest_path;
-      SVN_ERR(digest_path_from_path(&digest_path, fs->path, path, pool));
-      SVN_ERR(walk_locks(fs, digest_path, get_locks_callback,
+      SVN_ERR(walk_locks(fs, path, get_locks_callback,
                          fs, have_write_lock, pool));
     }
   else
@@ -845,6 +1536,9 @@ lock_body(void *baton, apr_pool_t *pool)
   apr_hash_t *index_updates = apr_hash_make(pool);
   apr_hash_index_t *hi;
   apr_pool_t *iterpool = svn_pool_create(pool);
+  svn_boolean_t use_log;
+  apr_array_header_t *new_locks = apr_array_make(pool, lb->targets->nelts,
+                                                 sizeof(svn_lock_t *));
 
   /* Until we implement directory locks someday, we only allow locks
      on files. */
@@ -853,6 +1547,9 @@ lock_body(void *baton, apr_pool_t *pool)
   SVN_ERR(lb->fs->vtable->youngest_rev(&youngest, lb->fs, pool));
   SVN_ERR(lb->fs->vtable->revision_root(&root, lb->fs, youngest, pool));
 
+  /* The lock log does not need any index updates. */
+  SVN_ERR(svn_fs_fs__uses_lock_log(&use_log, lb->fs, pool));
+
   for (i = 0; i < lb->targets->nelts; ++i)
     {
       const svn_sort__item_t *item = &APR_ARRAY_IDX(lb->targets, i,
@@ -870,7 +1567,7 @@ lock_body(void *baton, apr_pool_t *pool)
 
       /* If no error occurred while pre-checking, schedule the index updates for
          this path. */
-      if (!info.fs_err)
+      if (!info.fs_err && !use_log)
         schedule_index_update(index_updates, info.path, iterpool);
 
       APR_ARRAY_PUSH(lb->infos, struct lock_info_t) = info;
@@ -925,8 +1622,26 @@ lock_body(void *baton, apr_pool_t *pool)
           info->lock->creation_date = apr_time_now();
           info->lock->expiration_date = lb->expiration_date;
 
-          info->fs_err = set_lock(lb->fs->path, info->lock, rev_0_path,
-                                  iterpool);
+          if (use_log)
+            APR_ARRAY_PUSH(new_locks, svn_lock_t *) = info->lock;
+          else
+            info->fs_err = set_lock(lb->fs->path, info->lock, rev_0_path,
+                                    iterpool);
+        }
+    }
+
+  /* Add all new locks to the log at once.  If that fails, none of them
+     has been created. */
+  if (new_locks->nelts)
+    {
+      svn_error_t *err = write_logged_locks(lb->fs, new_locks, NULL,
+                                            rev_0_path, iterpool);
+      if (err)
+        {
+          for (i = 0; i < lb->infos->nelts; ++i)
+            APR_ARRAY_IDX(lb->infos, i, struct lock_info_t).lock = NULL;
+
+          return svn_error_trace(err);
         }
     }
 
@@ -997,10 +1712,16 @@ unlock_body(void *baton, apr_pool_t *pool)
   apr_hash_t *indices_updates = apr_hash_make(pool);
   apr_hash_index_t *hi;
   apr_pool_t *iterpool = svn_pool_create(pool);
+  svn_boolean_t use_log;
+  apr_array_header_t *unlocked = apr_array_make(pool, ub->targets->nelts,
+                                                sizeof(const char *));
 
   SVN_ERR(ub->fs->vtable->youngest_rev(&youngest, ub->fs, pool));
   SVN_ERR(ub->fs->vtable->revision_root(&root, ub->fs, youngest, pool));
 
+  /* The lock log does not need any index updates. */
+  SVN_ERR(svn_fs_fs__uses_lock_log(&use_log, ub->fs, pool));
+
   for (i = 0; i < ub->targets->nelts; ++i)
     {
       const svn_sort__item_t *item = &APR_ARRAY_IDX(ub->targets, i,
@@ -1020,7 +1741,7 @@ unlock_body(void *baton, apr_pool_t *pool)
 
       /* If no error occurred while pre-checking, schedule the index updates for
          this path. */
-      if (!info.fs_err)
+      if (!info.fs_err && !use_log)
         schedule_index_update(indices_updates, info.path, iterpool);
 
       APR_ARRAY_PUSH(ub->infos, struct unlock_info_t) = info;
@@ -1038,13 +1759,32 @@ unlock_body(void *baton, apr_pool_t *pool)
 
       svn_pool_clear(iterpool);
 
-      if (! info->fs_err)
+      if (! info->fs_err && use_log)
+        {
+          APR_ARRAY_PUSH(unlocked, const char *) = info->path;
+        }
+      else if (! info->fs_err)
         {
           SVN_ERR(delete_lock(ub->fs->path, info->path, iterpool));
           info->done = TRUE;
         }
     }
 
+  /* Remove all locks from the log at once. */
+  if (unlocked->nelts)
+    {
+      SVN_ERR(write_logged_locks(ub->fs, NULL, unlocked, rev_0_path,
+                                 iterpool));
+
+      for (i = 0; i < ub->infos->nelts; ++i)
+        {
+          struct unlock_info_t *info = &APR_ARRAY_IDX(ub->infos, i,
+                                                      struct unlock_info_t);
+          if (! info->fs_err)
+            info->done = TRUE;
+        }
+    }
+
   for (hi = apr_hash_first(pool, indices_updates); hi; hi = apr_hash_next(hi))
     {
       const char *path = apr_hash_this_key(hi);
@@ -1348,7 +2088,6 @@ svn_fs_fs__get_locks(svn_fs_t *fs,
                      void *get_locks_baton,
                      apr_pool_t *pool)
 {
-  const char *digest_path;
   get_locks_filter_baton_t glfb;
 
   SVN_ERR(svn_fs__check_fs(fs, TRUE));
@@ -1359,9 +2098,236 @@ svn_fs_fs__get_locks(svn_fs_t *fs,
   glfb.get_locks_func = get_locks_func;
   glfb.get_locks_baton = get_locks_baton;
 
-  /* Get the top digest path in our tree of interest, and then walk it. */
-  SVN_ERR(digest_path_from_path(&digest_path, fs->path, path, pool));
-  SVN_ERR(walk_locks(fs, digest_path, get_locks_filter_func, &glfb,
+  /* Walk our tree of interest. */
+  SVN_ERR(walk_locks(fs, path, get_locks_filter_func, &glfb,
                      FALSE, pool));
   return SVN_NO_ERROR;
 }
+
+
+/*** Lock storage management ***/
+
+svn_error_t *
+svn_fs_fs__create_lock_index(fs_fs_lock_index_t **index,
+                             apr_pool_t *result_pool)
+{
+  fs_fs_lock_index_t *new_index = apr_pcalloc(result_pool,
+                                              sizeof(*new_index));
+
+  new_index->pool = svn_pool_create(result_pool);
+  reset_lock_index(new_index, NULL);
+  SVN_ERR(svn_mutex__init(&new_index->mutex, TRUE, result_pool));
+
+  *index = new_index;
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_fs_fs__create_lock_log(svn_fs_t *fs,
+                           apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  const char *header;
+  apr_off_t size;
+  apr_array_header_t *locks = apr_array_make(scratch_pool, 0,
+                                             sizeof(svn_lock_t *));
+
+  SVN_ERR_ASSERT(ffd->format >= SVN_FS_FS__MIN_LOCK_LOG_FORMAT);
+  SVN_ERR(write_lock_log(&header, &size, fs, locks,
+                         svn_fs_fs__path_rev_absolute(fs, 0, scratch_pool),
+                         scratch_pool, scratch_pool));
+  ffd->lock_log = TRUE;
+
+  return SVN_NO_ERROR;
+}
+
+/* Set B->IN_USE after updating B->INDEX. */
+static svn_error_t *
+refresh_lock_log_body(lock_log_baton_t *b)
+{
+  return svn_error_trace(refresh_lock_index(&b->in_use, b->index, b->fs,
+                                            b->scratch_pool));
+}
+
+svn_error_t *
+svn_fs_fs__uses_lock_log(svn_boolean_t *uses_lock_log,
+                         svn_fs_t *fs,
+                         apr_pool_t *scratch_pool)
+{
+  lock_log_baton_t baton;
+
+  init_lock_log_baton(&baton, fs, scratch_pool, scratch_pool);
+  SVN_MUTEX__WITH_LOCK(baton.index->mutex, refresh_lock_log_body(&baton));
+  *uses_lock_log = baton.in_use;
+
+  return SVN_NO_ERROR;
+}
+
+/* This implements the svn_fs_get_locks_callback_t interface, where
+   BATON is an array of svn_lock_t * to which a copy of LOCK gets added. */
+static svn_error_t *
+collect_locks_callback(void *baton,
+                       svn_lock_t *lock,
+                       apr_pool_t *pool)
+{
+  apr_array_header_t *locks = baton;
+  APR_ARRAY_PUSH(locks, svn_lock_t *) = svn_lock_dup(lock, locks->pool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Sort svn_lock_t * elements by path, using svn_path_compare_paths(). */
+static int
+compare_lock_paths(const void *lhs,
+                   const void *rhs)
+{
+  const svn_lock_t *lhs_lock = *(const svn_lock_t * const *)lhs;
+  const svn_lock_t *rhs_lock = *(const svn_lock_t * const *)rhs;
+
+  return svn_path_compare_paths(lhs_lock->path, rhs_lock->path);
+}
+
+/* The effective arguments for convert_locks_body() below. */
+typedef struct convert_locks_baton_t
+{
+  svn_fs_t *fs;
+  svn_boolean_t use_lock_log;
+  svn_cancel_func_t cancel_func;
+  void *cancel_baton;
+} convert_locks_baton_t;
+
+/* The body of svn_fs_fs__convert_locks(), which see.  BATON is a
+   'convert_locks_baton_t *' holding the effective arguments.
+
+   This implements the svn_fs_fs__with_write_lock() 'body' callback
+   type, and assumes that the write lock is held.
+ */
+static svn_error_t *
+convert_locks_body(void *baton,
+                   apr_pool_t *pool)
+{
+  convert_locks_baton_t *b = baton;
+  svn_fs_t *fs = b->fs;
+  fs_fs_data_t *ffd = fs->fsap_data;
+  svn_boolean_t use_log;
+  apr_array_header_t *locks;
+  const char *rev_0_path;
+  apr_pool_t *iterpool;
+  int i;
+
+  SVN_ERR(svn_fs_fs__uses_lock_log(&use_log, fs, pool));
+  if (use_log == b->use_lock_log)
+    return SVN_NO_ERROR;
+
+  /* Older formats can't record the lock log, see read_format(). */
+  if (b->use_lock_log && ffd->format < SVN_FS_FS__MIN_LOCK_LOG_FORMAT)
+    return svn_error_createf(SVN_ERR_UNSUPPORTED_FEATURE, NULL,
+                             _("FSFS format %d does not support a lock "
+                               "log; please upgrade the repository"),
+                             ffd->format);
+
+  /* Read all locks from the current storage.  This also drops expired
+     ones. */
+  locks = apr_array_make(pool, 16, sizeof(svn_lock_t *));
+  SVN_ERR(walk_locks(fs, "/", collect_locks_callback, locks, TRUE, pool));
+
+  rev_0_path = svn_fs_fs__path_rev_absolute(fs, 0, pool);
+  iterpool = svn_pool_create(pool);
+
+  /* In both directions, the old storage remains valid until the new one
+     is complete.  Readers switch over once the format file has been
+     updated and the old storage gets removed only after that. */
+  if (b->use_lock_log)
+    {
+      const char *header;
+      apr_off_t size;
+      const char *locks_dir = svn_dirent_join(fs->path, PATH_LOCKS_DIR, pool);
+      apr_hash_t *dirents;
+      apr_hash_index_t *hi;
+
+      svn_sort__array(locks, compare_lock_paths);
+      SVN_ERR(write_lock_log(&header, &size, fs, locks, rev_0_path,
+                             pool, pool));
+
+      ffd->lock_log = TRUE;
+      SVN_ERR(svn_fs_fs__write_format(fs, TRUE, pool));
+
+      /* All digest files live in sub-folders of LOCKS_DIR. */
+      SVN_ERR(svn_io_get_dirents3(&dirents, locks_dir, TRUE, pool, pool));
+      for (hi = apr_hash_first(pool, dirents); hi; hi = apr_hash_next(hi))
+        {
+          const svn_io_dirent2_t *dirent = apr_hash_this_val(hi);
+
+          svn_pool_clear(iterpool);
+          if (dirent->kind == svn_node_dir)
+            SVN_ERR(svn_io_remove_dir2(svn_dirent_join(locks_dir,
+                                                       apr_hash_this_key(hi),
+                                                       iterpool),
+                                       FALSE, b->cancel_func, b->cancel_baton,
+                                       iterpool));
+        }
+    }
+  else
+    {
+      apr_hash_t *index_updates = apr_hash_make(pool);
+      apr_hash_index_t *hi;
+
+      /* Same order as in lock_body(): indexes first, then the locks. */
+      for (i = 0; i < locks->nelts; ++i)
+        schedule_index_update(index_updates,
+                              APR_ARRAY_IDX(locks, i, svn_lock_t *)->path,
+                              pool);
+
+      for (hi = apr_hash_first(pool, index_updates); hi; hi = apr_hash_next(hi))
+        {
+          svn_pool_clear(iterpool);
+          if (b->cancel_func)
+            SVN_ERR(b->cancel_func(b->cancel_baton));
+
+          SVN_ERR(add_to_digest(fs->path, apr_hash_this_val(hi),
+                                apr_hash_this_key(hi), rev_0_path,
+                                iterpool));
+        }
+
+      for (i = 0; i < locks->nelts; ++i)
+        {
+          svn_pool_clear(iterpool);
+          if (b->cancel_func)
+            SVN_ERR(b->cancel_func(b->cancel_baton));
+
+          SVN_ERR(set_lock(fs->path, APR_ARRAY_IDX(locks, i, svn_lock_t *),
+                           rev_0_path, iterpool));
+        }
+
+      ffd->lock_log = FALSE;
+      SVN_ERR(svn_fs_fs__write_format(fs, TRUE, pool));
+
+      SVN_ERR(svn_io_remove_file2(path_lock_log(fs->path, pool), FALSE,
+                                  pool));
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_fs_fs__convert_locks(svn_fs_t *fs,
+                         svn_boolean_t use_lock_log,
+                         svn_cancel_func_t cancel_func,
+                         void *cancel_baton,
+                         apr_pool_t *scratch_pool)
+{
+  convert_locks_baton_t baton;
+
+  SVN_ERR(svn_fs__check_fs(fs, TRUE));
+
+  baton.fs = fs;
+  baton.use_lock_log = use_lock_log;
+  baton.cancel_func = cancel_func;
+  baton.cancel_baton = cancel_baton;
+
+  return svn_error_trace(svn_fs_fs__with_write_lock(fs, convert_locks_body,
+                                                    &baton, scratch_pool));
+}
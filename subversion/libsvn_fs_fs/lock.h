@@ -23,12 +23,24 @@
 #ifndef SVN_LIBSVN_FS_LOCK_H
 #define SVN_LIBSVN_FS_LOCK_H
 
+#include "fs.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif /* __cplusplus */
 
 
 
+/* Set *INDEX to a new, empty in-memory lock log index allocated in
+   RESULT_POOL. */
+svn_error_t *svn_fs_fs__create_lock_index(fs_fs_lock_index_t **index,
+                                          apr_pool_t *result_pool);
+
+/* Make the newly created FS store its locks in a lock log.
+   Use SCRATCH_POOL for temporary allocations. */
+svn_error_t *svn_fs_fs__create_lock_log(svn_fs_t *fs,
+                                        apr_pool_t *scratch_pool);
+
 /* These functions implement some of the calls in the FS loader
    library's fs vtables. */
 
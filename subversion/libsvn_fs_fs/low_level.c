@@ -41,6 +41,7 @@
 #define HEADER_TEXT        "text"
 #define HEADER_CPATH       "cpath"
 #define HEADER_PRED        "pred"
+#define HEADER_SKIP        "skip"
 #define HEADER_COPYFROM    "copyfrom"
 #define HEADER_COPYROOT    "copyroot"
 #define HEADER_FRESHTXNRT  "is-fresh-txn-root"
@@ -61,6 +62,8 @@
 /* Kinds of representation. */
 #define REP_PLAIN          "PLAIN"
 #define REP_DELTA          "DELTA"
+#define REP_CHUNKED        "CHUNKED"
+#define REP_DIR_INDEX      "DIRINDEX"
 
 /* An arbitrary maximum path length, so clients can't run us out of memory
  * by giving us arbitrarily large paths. */
@@ -1003,6 +1006,11 @@ svn_fs_fs__read_noderev(node_revision_t **noderev_p,
     SVN_ERR(svn_fs_fs__id_parse(&noderev->predecessor_id, value,
                                 result_pool));
 
+  /* Get the optional skip-list ancestor ID. */
+  value = svn_hash_gets(headers, HEADER_SKIP);
+  if (value)
+    SVN_ERR(svn_fs_fs__id_parse(&noderev->skip_id, value, result_pool));
+
   /* Get the copyroot. */
   value = svn_hash_gets(headers, HEADER_COPYROOT);
   if (value == NULL)
@@ -1198,6 +1206,11 @@ svn_fs_fs__write_noderev(svn_stream_t *outfile,
   SVN_ERR(svn_stream_printf(outfile, scratch_pool, HEADER_COUNT ": %d\n",
                             noderev->predecessor_count));
 
+  if (noderev->skip_id)
+    SVN_ERR(svn_stream_printf(outfile, scratch_pool, HEADER_SKIP ": %s\n",
+                              svn_fs_fs__id_unparse(noderev->skip_id,
+                                                    scratch_pool)->data));
+
   if (noderev->data_rep)
     SVN_ERR(svn_stream_printf(outfile, scratch_pool, HEADER_TEXT ": %s\n",
                               svn_fs_fs__unparse_representation
@@ -1273,6 +1286,20 @@ svn_fs_fs__read_rep_header(svn_fs_fs__rep_header_t **header,
       return SVN_NO_ERROR;
     }
 
+  if (strcmp(buffer->data, REP_CHUNKED) == 0)
+    {
+      /* This is a list of chunk reps. */
+      (*header)->type = svn_fs_fs__rep_chunked;
+      return SVN_NO_ERROR;
+    }
+
+  if (strcmp(buffer->data, REP_DIR_INDEX) == 0)
+    {
+      /* This is a list of directory blocks. */
+      (*header)->type = svn_fs_fs__rep_dir_index;
+      return SVN_NO_ERROR;
+    }
+
   (*header)->type = svn_fs_fs__rep_delta;
 
   /* We have hopefully a DELTA vs. a non-empty base revision. */
@@ -1319,6 +1346,14 @@ svn_fs_fs__write_rep_header(svn_fs_fs__rep_header_t *header,
         text = REP_DELTA "\n";
         break;
 
+      case svn_fs_fs__rep_chunked:
+        text = REP_CHUNKED "\n";
+        break;
+
+      case svn_fs_fs__rep_dir_index:
+        text = REP_DIR_INDEX "\n";
+        break;
+
       default:
         text = apr_psprintf(scratch_pool, REP_DELTA " %ld %" APR_OFF_T_FMT
                                           " %" SVN_FILESIZE_T_FMT "\n",
@@ -1328,3 +1363,148 @@ svn_fs_fs__write_rep_header(svn_fs_fs__rep_header_t *header,
 
   return svn_error_trace(svn_stream_puts(stream, text));
 }
+
+svn_error_t *
+svn_fs_fs__read_chunk_list(apr_array_header_t **chunks,
+                           svn_stream_t *stream,
+                           apr_pool_t *result_pool,
+                           apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  svn_boolean_t eof = FALSE;
+
+  *chunks = apr_array_make(result_pool, 16, sizeof(representation_t *));
+  while (!eof)
+    {
+      svn_stringbuf_t *line;
+      representation_t *chunk;
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_stream_readline(stream, &line, "\n", &eof, iterpool));
+      if (line->len == 0)
+        continue;
+
+      SVN_ERR(svn_fs_fs__parse_representation(&chunk, line, result_pool,
+                                              iterpool));
+      if (chunk->size == 0 && chunk->expanded_size == 0)
+        return svn_error_create(SVN_ERR_FS_CORRUPT, NULL,
+                                _("Malformed chunk reference in "
+                                  "chunked representation"));
+
+      APR_ARRAY_PUSH(*chunks, representation_t *) = chunk;
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_fs_fs__write_chunk_list(svn_stream_t *stream,
+                            const apr_array_header_t *chunks,
+                            int format,
+                            apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  int i;
+
+  for (i = 0; i < chunks->nelts; ++i)
+    {
+      representation_t *chunk = APR_ARRAY_IDX(chunks, i, representation_t *);
+      svn_stringbuf_t *str;
+
+      svn_pool_clear(iterpool);
+      str = svn_fs_fs__unparse_representation(chunk, format, FALSE,
+                                              iterpool, iterpool);
+      svn_stringbuf_appendbyte(str, '\n');
+      SVN_ERR(svn_stream_write(stream, str->data, &str->len));
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_fs_fs__read_dir_index(apr_array_header_t **blocks,
+                          apr_array_header_t **names,
+                          svn_stream_t *stream,
+                          apr_pool_t *result_pool,
+                          apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  svn_boolean_t eof = FALSE;
+  const char *previous = NULL;
+
+  *blocks = apr_array_make(result_pool, 16, sizeof(representation_t *));
+  *names = apr_array_make(result_pool, 16, sizeof(const char *));
+  while (!eof)
+    {
+      svn_stringbuf_t *name;
+      svn_stringbuf_t *line;
+      representation_t *block;
+
+      svn_pool_clear(iterpool);
+
+      /* Each block is given by the name of its first entry, followed by
+       * the block representation. */
+      SVN_ERR(svn_stream_readline(stream, &name, "\n", &eof, result_pool));
+      if (name->len == 0 && eof)
+        break;
+
+      SVN_ERR(svn_stream_readline(stream, &line, "\n", &eof, iterpool));
+      SVN_ERR(svn_fs_fs__parse_representation(&block, line, result_pool,
+                                              iterpool));
+
+      /* The names must be strictly sorted for lookups to work. */
+      if (   (block->size == 0 && block->expanded_size == 0)
+          || (previous && strcmp(previous, name->data) >= 0))
+        return svn_error_create(SVN_ERR_FS_CORRUPT, NULL,
+                                _("Malformed block reference in "
+                                  "directory index"));
+
+      APR_ARRAY_PUSH(*blocks, representation_t *) = block;
+      APR_ARRAY_PUSH(*names, const char *) = name->data;
+      previous = name->data;
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_fs_fs__write_dir_index(svn_stream_t *stream,
+                           const apr_array_header_t *blocks,
+                           const apr_array_header_t *names,
+                           int format,
+                           apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  int i;
+
+  SVN_ERR_ASSERT(blocks->nelts == names->nelts);
+  for (i = 0; i < blocks->nelts; ++i)
+    {
+      representation_t *block = APR_ARRAY_IDX(blocks, i, representation_t *);
+      svn_stringbuf_t *str;
+
+      svn_pool_clear(iterpool);
+
+      /* Entry names never contain newlines. */
+      str = svn_stringbuf_create(APR_ARRAY_IDX(names, i, const char *),
+                                 iterpool);
+      svn_stringbuf_appendbyte(str, '\n');
+      svn_stringbuf_appendstr(str,
+                              svn_fs_fs__unparse_representation(block, format,
+                                                                FALSE,
+                                                                iterpool,
+                                                                iterpool));
+      svn_stringbuf_appendbyte(str, '\n');
+      SVN_ERR(svn_stream_write(stream, str->data, &str->len));
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
@@ -189,7 +189,14 @@ typedef enum svn_fs_fs__rep_type_t
   svn_fs_fs__rep_self_delta,
 
   /* this is a DELTA representation against some base representation */
-  svn_fs_fs__rep_delta
+  svn_fs_fs__rep_delta,
+
+  /* this is a list of chunk representations to be concatenated */
+  svn_fs_fs__rep_chunked,
+
+  /* this is a list of directory blocks to be concatenated, each with
+   * the name of its first entry */
+  svn_fs_fs__rep_dir_index
 } svn_fs_fs__rep_type_t;
 
 /* This structure is used to hold the information stored in a representation
@@ -233,3 +240,48 @@ svn_error_t *
 svn_fs_fs__write_rep_header(svn_fs_fs__rep_header_t *header,
                             svn_stream_t *stream,
                             apr_pool_t *scratch_pool);
+
+/* Read the body of a chunked representation from STREAM until EOF and
+ * return the chunk representations in *CHUNKS as an array of
+ * representation_t *, in content order.  Chunks stored in the same
+ * revision or transaction as the chunked representation itself have
+ * an invalid revision number.  Allocate the result in RESULT_POOL and
+ * use SCRATCH_POOL for temporary allocations. */
+svn_error_t *
+svn_fs_fs__read_chunk_list(apr_array_header_t **chunks,
+                           svn_stream_t *stream,
+                           apr_pool_t *result_pool,
+                           apr_pool_t *scratch_pool);
+
+/* Write the body of a chunked representation, i.e. the references to
+ * the representation_t * in CHUNKS, to STREAM.  FORMAT is the FS format.
+ * Use SCRATCH_POOL for temporary allocations. */
+svn_error_t *
+svn_fs_fs__write_chunk_list(svn_stream_t *stream,
+                            const apr_array_header_t *chunks,
+                            int format,
+                            apr_pool_t *scratch_pool);
+
+/* Read the body of an indexed directory representation from STREAM until
+ * EOF.  Return the block representations in *BLOCKS as an array of
+ * representation_t * and the names of their respective first entries in
+ * *NAMES as an array of const char *, both in content order.  Allocate
+ * the result in RESULT_POOL and use SCRATCH_POOL for temporary
+ * allocations. */
+svn_error_t *
+svn_fs_fs__read_dir_index(apr_array_header_t **blocks,
+                          apr_array_header_t **names,
+                          svn_stream_t *stream,
+                          apr_pool_t *result_pool,
+                          apr_pool_t *scratch_pool);
+
+/* Write the body of an indexed directory representation, i.e. the
+ * references to the representation_t * in BLOCKS and the first entry
+ * names given as const char * in NAMES, to STREAM.  FORMAT is the FS
+ * format.  Use SCRATCH_POOL for temporary allocations. */
+svn_error_t *
+svn_fs_fs__write_dir_index(svn_stream_t *stream,
+                           const apr_array_header_t *blocks,
+                           const apr_array_header_t *names,
+                           int format,
+                           apr_pool_t *scratch_pool);
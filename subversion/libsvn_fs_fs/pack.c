@@ -30,6 +30,9 @@
 #include "private/svn_subr_private.h"
 #include "private/svn_string_private.h"
 #include "private/svn_io_private.h"
+#include "private/svn_cache.h"
+#include "private/svn_fs_fs_private.h"
+#include "private/svn_worker_pool.h"
 
 #include "fs_fs.h"
 #include "pack.h"
@@ -234,25 +237,26 @@ typedef struct pack_context_t
    * the next range of revisions is being processed */
   apr_pool_t *info_pool;
 
-  /* ensure that all filesystem changes are written to disk. */
-  svn_boolean_t flush_to_disk;
+  /* schedule all files to be written to disk here. */
+  svn_io__batch_fsync_t *batch;
 } pack_context_t;
 
 /* Create and initialize a new pack context for packing shard SHARD_REV in
- * SHARD_DIR into PACK_FILE_DIR within filesystem FS.  Allocate it in POOL
- * and return the structure in *CONTEXT.
+ * SHARD_DIR into the file PACK_FILE_NAME in PACK_FILE_DIR within filesystem
+ * FS.  Allocate it in POOL and return the structure in *CONTEXT.
  *
  * Limit the number of items being copied per iteration to MAX_ITEMS.
- * Set FLUSH_TO_DISK, CANCEL_FUNC and CANCEL_BATON as well.
+ * Set BATCH, CANCEL_FUNC and CANCEL_BATON as well.
  */
 static svn_error_t *
 initialize_pack_context(pack_context_t *context,
                         svn_fs_t *fs,
                         const char *pack_file_dir,
+                        const char *pack_file_name,
                         const char *shard_dir,
                         svn_revnum_t shard_rev,
                         int max_items,
-                        svn_boolean_t flush_to_disk,
+                        svn_io__batch_fsync_t *batch,
                         svn_cancel_func_t cancel_func,
                         void *cancel_baton,
                         apr_pool_t *pool)
@@ -281,13 +285,13 @@ initialize_pack_context(pack_context_t *context,
   context->info_pool = svn_pool_create(pool);
   context->paths = svn_prefix_tree__create(context->info_pool);
 
-  context->flush_to_disk = flush_to_disk;
+  context->batch = batch;
 
   /* Create the new directory and pack file. */
   context->shard_dir = shard_dir;
   context->pack_file_dir = pack_file_dir;
   context->pack_file_path
-    = svn_dirent_join(pack_file_dir, PATH_PACKED, pool);
+    = svn_dirent_join(pack_file_dir, pack_file_name, pool);
   SVN_ERR(svn_io_file_open(&context->pack_file, context->pack_file_path,
                            APR_WRITE | APR_BUFFERED | APR_BINARY | APR_EXCL
                              | APR_CREATE, APR_OS_DEFAULT, pool));
@@ -412,10 +416,10 @@ close_pack_context(pack_context_t *context,
   SVN_ERR(svn_io_remove_file2(proto_l2p_index_path, FALSE, pool));
   SVN_ERR(svn_io_remove_file2(proto_p2l_index_path, FALSE, pool));
 
-  /* Ensure that packed file is written to disk.*/
-  if (context->flush_to_disk)
-    SVN_ERR(svn_io_file_flush_to_disk(context->pack_file, pool));
+  /* Ensure that packed file will be written to disk.*/
   SVN_ERR(svn_io_file_close(context->pack_file, pool));
+  SVN_ERR(svn_io__batch_fsync_add_file(context->batch,
+                                       context->pack_file_path, pool));
 
   return SVN_NO_ERROR;
 }
@@ -1197,11 +1201,14 @@ store_items(pack_context_t *context,
 
 /* Copy (append) the items identified by svn_fs_fs__p2l_entry_t * elements
  * in ENTRIES strictly in order from TEMP_FILE into CONTEXT->PACK_FILE.
+ * The first ITEM_COUNT elements of CONTEXT->REPS are the items read
+ * from the revisions being packed.
  * Use POOL for temporary allocations.
  */
 static svn_error_t *
 copy_reps_from_temp(pack_context_t *context,
                     apr_file_t *temp_file,
+                    int item_count,
                     apr_pool_t *pool)
 {
   apr_pool_t *iterpool = svn_pool_create(pool);
@@ -1244,6 +1251,22 @@ copy_reps_from_temp(pack_context_t *context,
         SVN_ERR(store_item(context, temp_file, node_part, iterpool));
     }
 
+  /* copy the reps not referenced by any noderev, i.e. the chunks of
+   * chunked representations. */
+  for (i = 0; i < item_count; ++i)
+    {
+      svn_fs_fs__p2l_entry_t *rep_part
+        = APR_ARRAY_IDX(context->reps, i, svn_fs_fs__p2l_entry_t *);
+
+      svn_pool_clear(iterpool);
+
+      if (rep_part)
+        {
+          APR_ARRAY_IDX(context->reps, i, svn_fs_fs__p2l_entry_t *) = NULL;
+          SVN_ERR(store_item(context, temp_file, rep_part, iterpool));
+        }
+    }
+
   svn_pool_destroy(iterpool);
 
   return SVN_NO_ERROR;
@@ -1324,109 +1347,109 @@ write_l2p_index(pack_context_t *context,
   return SVN_NO_ERROR;
 }
 
-/* Pack the current revision range of CONTEXT, i.e. this covers phases 2
- * to 4.  Use POOL for allocations.
+/* Copy all items of REV_FILE, which contains REVISION, into the various
+ * buckets of CONTEXT and build the tracking info for them.  REV_FILE may
+ * be a revision file or a pack file.  Use POOL for temporary allocations.
  */
 static svn_error_t *
-pack_range(pack_context_t *context,
-           apr_pool_t *pool)
+copy_items_to_temp(pack_context_t *context,
+                   svn_fs_fs__revision_file_t *rev_file,
+                   svn_revnum_t revision,
+                   apr_pool_t *pool)
 {
   fs_fs_data_t *ffd = context->fs->fsap_data;
-  apr_pool_t *revpool = svn_pool_create(pool);
   apr_pool_t *iterpool = svn_pool_create(pool);
   apr_pool_t *iterpool2 = svn_pool_create(pool);
+  apr_off_t offset = 0;
 
-  /* Phase 2: Copy items into various buckets and build tracking info */
-  svn_revnum_t revision;
-  for (revision = context->start_rev; revision < context->end_rev; ++revision)
+  /* read the phys-to-log index file until we covered the whole rev file.
+   * That index contains enough info to build both target indexes from it. */
+  while (offset < rev_file->l2p_offset)
     {
-      apr_off_t offset = 0;
-      svn_fs_fs__revision_file_t *rev_file;
-
-      svn_pool_clear(revpool);
+      /* read one cluster */
+      int i;
+      apr_array_header_t *entries;
 
-      /* Get the rev file dimensions (mainly index locations). */
-      SVN_ERR(svn_fs_fs__open_pack_or_rev_file(&rev_file, context->fs,
-                                               revision, revpool, iterpool));
-      SVN_ERR(svn_fs_fs__auto_read_footer(rev_file));
+      svn_pool_clear(iterpool);
 
-      /* store the indirect array index */
-      APR_ARRAY_PUSH(context->rev_offsets, int) = context->reps->nelts;
+      SVN_ERR(svn_fs_fs__p2l_index_lookup(&entries, context->fs,
+                                          rev_file, revision, offset,
+                                          ffd->p2l_page_size, iterpool,
+                                          iterpool));
 
-      /* read the phys-to-log index file until we covered the whole rev file.
-       * That index contains enough info to build both target indexes from it. */
-      while (offset < rev_file->l2p_offset)
+      for (i = 0; i < entries->nelts; ++i)
         {
-          /* read one cluster */
-          int i;
-          apr_array_header_t *entries;
+          svn_fs_fs__p2l_entry_t *entry
+            = &APR_ARRAY_IDX(entries, i, svn_fs_fs__p2l_entry_t);
 
-          svn_pool_clear(iterpool);
+          /* skip first entry if that was duplicated due crossing a
+             cluster boundary */
+          if (offset > entry->offset)
+            continue;
 
-          SVN_ERR(svn_fs_fs__p2l_index_lookup(&entries, context->fs,
-                                              rev_file, revision, offset,
-                                              ffd->p2l_page_size, iterpool,
-                                              iterpool));
+          svn_pool_clear(iterpool2);
 
-          for (i = 0; i < entries->nelts; ++i)
+          /* process entry while inside the rev file */
+          offset = entry->offset;
+          if (offset < rev_file->l2p_offset)
             {
-              svn_fs_fs__p2l_entry_t *entry
-                = &APR_ARRAY_IDX(entries, i, svn_fs_fs__p2l_entry_t);
-
-              /* skip first entry if that was duplicated due crossing a
-                 cluster boundary */
-              if (offset > entry->offset)
-                continue;
-
-              svn_pool_clear(iterpool2);
-
-              /* process entry while inside the rev file */
-              offset = entry->offset;
-              if (offset < rev_file->l2p_offset)
-                {
-                  SVN_ERR(svn_io_file_seek(rev_file->file, APR_SET, &offset,
-                                           iterpool2));
-
-                  if (entry->type == SVN_FS_FS__ITEM_TYPE_CHANGES)
-                    SVN_ERR(copy_item_to_temp(context,
-                                              context->changes,
-                                              context->changes_file,
-                                              rev_file->file, entry,
-                                              iterpool2));
-                  else if (entry->type == SVN_FS_FS__ITEM_TYPE_FILE_PROPS)
-                    SVN_ERR(copy_item_to_temp(context,
-                                              context->file_props,
-                                              context->file_props_file,
-                                              rev_file->file, entry,
-                                              iterpool2));
-                  else if (entry->type == SVN_FS_FS__ITEM_TYPE_DIR_PROPS)
-                    SVN_ERR(copy_item_to_temp(context,
-                                              context->dir_props,
-                                              context->dir_props_file,
-                                              rev_file->file, entry,
-                                              iterpool2));
-                  else if (   entry->type == SVN_FS_FS__ITEM_TYPE_FILE_REP
-                           || entry->type == SVN_FS_FS__ITEM_TYPE_DIR_REP)
-                    SVN_ERR(copy_rep_to_temp(context, rev_file->file, entry,
-                                             iterpool2));
-                  else if (entry->type == SVN_FS_FS__ITEM_TYPE_NODEREV)
-                    SVN_ERR(copy_node_to_temp(context, rev_file, entry,
-                                              iterpool2));
-                  else
-                    SVN_ERR_ASSERT(entry->type == SVN_FS_FS__ITEM_TYPE_UNUSED);
-
-                  offset += entry->size;
-                }
-            }
+              SVN_ERR(svn_io_file_seek(rev_file->file, APR_SET, &offset,
+                                       iterpool2));
+
+              if (entry->type == SVN_FS_FS__ITEM_TYPE_CHANGES)
+                SVN_ERR(copy_item_to_temp(context,
+                                          context->changes,
+                                          context->changes_file,
+                                          rev_file->file, entry,
+                                          iterpool2));
+              else if (entry->type == SVN_FS_FS__ITEM_TYPE_FILE_PROPS)
+                SVN_ERR(copy_item_to_temp(context,
+                                          context->file_props,
+                                          context->file_props_file,
+                                          rev_file->file, entry,
+                                          iterpool2));
+              else if (entry->type == SVN_FS_FS__ITEM_TYPE_DIR_PROPS)
+                SVN_ERR(copy_item_to_temp(context,
+                                          context->dir_props,
+                                          context->dir_props_file,
+                                          rev_file->file, entry,
+                                          iterpool2));
+              else if (   entry->type == SVN_FS_FS__ITEM_TYPE_FILE_REP
+                       || entry->type == SVN_FS_FS__ITEM_TYPE_DIR_REP)
+                SVN_ERR(copy_rep_to_temp(context, rev_file->file, entry,
+                                         iterpool2));
+              else if (entry->type == SVN_FS_FS__ITEM_TYPE_NODEREV)
+                SVN_ERR(copy_node_to_temp(context, rev_file, entry,
+                                          iterpool2));
+              else
+                SVN_ERR_ASSERT(entry->type == SVN_FS_FS__ITEM_TYPE_UNUSED);
 
-          if (context->cancel_func)
-            SVN_ERR(context->cancel_func(context->cancel_baton));
+              offset += entry->size;
+            }
         }
+
+      if (context->cancel_func)
+        SVN_ERR(context->cancel_func(context->cancel_baton));
     }
 
   svn_pool_destroy(iterpool2);
   svn_pool_destroy(iterpool);
 
+  return SVN_NO_ERROR;
+}
+
+/* Place and write all items that have been copied into the buckets of
+ * CONTEXT, i.e. this covers phases 3 and 4.  The first ITEM_COUNT elements
+ * of CONTEXT->REPS are the items read from the source files.  Use POOL
+ * for temporary allocations.
+ */
+static svn_error_t *
+store_range(pack_context_t *context,
+            int item_count,
+            apr_pool_t *pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(pool);
+
   /* phase 3: placement.
    * Use "newest first" placement for simple items. */
   sort_items(context->changes);
@@ -1438,25 +1461,62 @@ pack_range(pack_context_t *context,
 
   /* phase 4: copy bucket data to pack file.  Write P2L index. */
   SVN_ERR(store_items(context, context->changes_file, context->changes,
-                      revpool));
-  svn_pool_clear(revpool);
+                      iterpool));
+  svn_pool_clear(iterpool);
   SVN_ERR(store_items(context, context->file_props_file, context->file_props,
-                      revpool));
-  svn_pool_clear(revpool);
+                      iterpool));
+  svn_pool_clear(iterpool);
   SVN_ERR(store_items(context, context->dir_props_file, context->dir_props,
-                      revpool));
-  svn_pool_clear(revpool);
-  SVN_ERR(copy_reps_from_temp(context, context->reps_file, revpool));
-  svn_pool_clear(revpool);
+                      iterpool));
+  svn_pool_clear(iterpool);
+  SVN_ERR(copy_reps_from_temp(context, context->reps_file, item_count,
+                              iterpool));
+  svn_pool_clear(iterpool);
 
   /* write L2P index as well (now that we know all target offsets) */
-  SVN_ERR(write_l2p_index(context, revpool));
+  SVN_ERR(write_l2p_index(context, iterpool));
 
-  svn_pool_destroy(revpool);
+  svn_pool_destroy(iterpool);
 
   return SVN_NO_ERROR;
 }
 
+/* Pack the current revision range of CONTEXT, i.e. this covers phases 2
+ * to 4.  Use POOL for allocations.
+ */
+static svn_error_t *
+pack_range(pack_context_t *context,
+           apr_pool_t *pool)
+{
+  apr_pool_t *revpool = svn_pool_create(pool);
+  apr_pool_t *iterpool = svn_pool_create(pool);
+
+  /* Phase 2: Copy items into various buckets and build tracking info */
+  svn_revnum_t revision;
+  for (revision = context->start_rev; revision < context->end_rev; ++revision)
+    {
+      svn_fs_fs__revision_file_t *rev_file;
+
+      svn_pool_clear(revpool);
+      svn_pool_clear(iterpool);
+
+      /* Get the rev file dimensions (mainly index locations). */
+      SVN_ERR(svn_fs_fs__open_pack_or_rev_file(&rev_file, context->fs,
+                                               revision, revpool, iterpool));
+      SVN_ERR(svn_fs_fs__auto_read_footer(rev_file));
+
+      /* store the indirect array index */
+      APR_ARRAY_PUSH(context->rev_offsets, int) = context->reps->nelts;
+
+      SVN_ERR(copy_items_to_temp(context, rev_file, revision, iterpool));
+    }
+
+  svn_pool_destroy(iterpool);
+  svn_pool_destroy(revpool);
+
+  return svn_error_trace(store_range(context, context->reps->nelts, pool));
+}
+
 /* Append CONTEXT->START_REV to the context's pack file with no re-ordering.
  * This function will only be used for very large revisions (>>100k changes).
  * Use POOL for temporary allocations.
@@ -1534,13 +1594,40 @@ append_revision(pack_context_t *context,
   return SVN_NO_ERROR;
 }
 
+/* Estimated amount of memory used to represent one item in memory
+ * during rev file packing. */
+enum
+  {
+    PER_ITEM_MEM = APR_ALIGN_DEFAULT(sizeof(path_order_t))
+                 + APR_ALIGN_DEFAULT(2 *sizeof(void*))
+                 + APR_ALIGN_DEFAULT(sizeof(reference_t))
+                 + APR_ALIGN_DEFAULT(sizeof(svn_fs_fs__p2l_entry_t))
+                 + 6 * sizeof(void*)
+  };
+
+/* Set *MAX_ITEMS to the number of items that we may process at once
+ * without exceeding MAX_MEM bytes of memory.
+ */
+static svn_error_t *
+get_max_items(int *max_items,
+              apr_size_t max_mem)
+{
+  /* Prevent integer overflow.  We use apr arrays to process the items so
+   * the maximum number of items is INT_MAX. */
+  apr_size_t temp = max_mem / PER_ITEM_MEM;
+  SVN_ERR_ASSERT(temp <= INT_MAX);
+  *max_items = (int)temp;
+
+  return SVN_NO_ERROR;
+}
+
 /* Logical addressing mode packing logic.
  *
  * Pack the revision shard starting at SHARD_REV in filesystem FS from
  * SHARD_DIR into the PACK_FILE_DIR, using POOL for allocations.  Limit
- * the extra memory consumption to MAX_MEM bytes.  If FLUSH_TO_DISK is
- * non-zero, do not return until the data has actually been written on
- * the disk.  CANCEL_FUNC and CANCEL_BATON are what you think they are.
+ * the extra memory consumption to MAX_MEM bytes.  Schedule the pack file
+ * for fsync in BATCH.  CANCEL_FUNC and CANCEL_BATON are what you think
+ * they are.
  */
 static svn_error_t *
 pack_log_addressed(svn_fs_t *fs,
@@ -1548,22 +1635,11 @@ pack_log_addressed(svn_fs_t *fs,
                    const char *shard_dir,
                    svn_revnum_t shard_rev,
                    apr_size_t max_mem,
-                   svn_boolean_t flush_to_disk,
+                   svn_io__batch_fsync_t *batch,
                    svn_cancel_func_t cancel_func,
                    void *cancel_baton,
                    apr_pool_t *pool)
 {
-  enum
-    {
-      /* estimated amount of memory used to represent one item in memory
-       * during rev file packing */
-      PER_ITEM_MEM = APR_ALIGN_DEFAULT(sizeof(path_order_t))
-                   + APR_ALIGN_DEFAULT(2 *sizeof(void*))
-                   + APR_ALIGN_DEFAULT(sizeof(reference_t))
-                   + APR_ALIGN_DEFAULT(sizeof(svn_fs_fs__p2l_entry_t))
-                   + 6 * sizeof(void*)
-    };
-
   int max_items;
   apr_array_header_t *max_ids;
   pack_context_t context = { 0 };
@@ -1571,17 +1647,11 @@ pack_log_addressed(svn_fs_t *fs,
   apr_size_t item_count = 0;
   apr_pool_t *iterpool = svn_pool_create(pool);
 
-  /* Prevent integer overflow.  We use apr arrays to process the items so
-   * the maximum number of items is INT_MAX. */
-    {
-      apr_size_t temp = max_mem / PER_ITEM_MEM;
-      SVN_ERR_ASSERT(temp <= INT_MAX);
-      max_items = (int)temp;
-    }
+  SVN_ERR(get_max_items(&max_items, max_mem));
 
   /* set up a pack context */
-  SVN_ERR(initialize_pack_context(&context, fs, pack_file_dir, shard_dir,
-                                  shard_rev, max_items, flush_to_disk,
+  SVN_ERR(initialize_pack_context(&context, fs, pack_file_dir, PATH_PACKED,
+                                  shard_dir, shard_rev, max_items, batch,
                                   cancel_func, cancel_baton, pool));
 
   /* phase 1: determine the size of the revisions to pack */
@@ -1706,16 +1776,16 @@ svn_fs_fs__get_packed_offset(apr_off_t *rev_offset,
  *
  * Pack the revision shard starting at SHARD_REV containing exactly
  * MAX_FILES_PER_DIR revisions from SHARD_PATH into the PACK_FILE_DIR,
- * using POOL for allocations.  If FLUSH_TO_DISK is non-zero, do not
- * return until the data has actually been written on the disk.
- * CANCEL_FUNC and CANCEL_BATON are what you think they are.
+ * using POOL for allocations.  Schedule the pack and manifest files for
+ * fsync in BATCH.  CANCEL_FUNC and CANCEL_BATON are what you think they
+ * are.
  */
 static svn_error_t *
 pack_phys_addressed(const char *pack_file_dir,
                     const char *shard_path,
                     svn_revnum_t start_rev,
                     int max_files_per_dir,
-                    svn_boolean_t flush_to_disk,
+                    svn_io__batch_fsync_t *batch,
                     svn_cancel_func_t cancel_func,
                     void *cancel_baton,
                     apr_pool_t *pool)
@@ -1782,18 +1852,16 @@ pack_phys_addressed(const char *pack_file_dir,
   /* Close stream over APR file. */
   SVN_ERR(svn_stream_close(manifest_stream));
 
-  /* Ensure that pack file is written to disk. */
-  if (flush_to_disk)
-    SVN_ERR(svn_io_file_flush_to_disk(manifest_file, pool));
+  /* Ensure that the manifest file will be written to disk. */
   SVN_ERR(svn_io_file_close(manifest_file, pool));
+  SVN_ERR(svn_io__batch_fsync_add_file(batch, manifest_file_path, pool));
 
   /* disallow write access to the manifest file */
   SVN_ERR(svn_io_set_file_read_only(manifest_file_path, FALSE, iterpool));
 
-  /* Ensure that pack file is written to disk. */
-  if (flush_to_disk)
-    SVN_ERR(svn_io_file_flush_to_disk(pack_file, pool));
+  /* Ensure that pack file will be written to disk. */
   SVN_ERR(svn_io_file_close(pack_file, pool));
+  SVN_ERR(svn_io__batch_fsync_add_file(batch, pack_file_path, pool));
 
   svn_pool_destroy(iterpool);
 
@@ -1826,6 +1894,10 @@ pack_rev_shard(svn_fs_t *fs,
 {
   const char *pack_file_path;
   svn_revnum_t shard_rev = (svn_revnum_t) (shard * max_files_per_dir);
+  svn_io__batch_fsync_t *batch;
+
+  /* Perform all fsyncs through this instance. */
+  SVN_ERR(svn_io__batch_fsync_create(&batch, flush_to_disk, pool));
 
   /* Some useful paths. */
   pack_file_path = svn_dirent_join(pack_file_dir, PATH_PACKED, pool);
@@ -1836,20 +1908,26 @@ pack_rev_shard(svn_fs_t *fs,
 
   /* Create the new directory and pack file. */
   SVN_ERR(svn_io_dir_make(pack_file_dir, APR_OS_DEFAULT, pool));
+  SVN_ERR(svn_io__batch_fsync_new_path(batch, pack_file_dir, pool));
 
   /* Index information files */
   if (svn_fs_fs__use_log_addressing(fs))
     SVN_ERR(pack_log_addressed(fs, pack_file_dir, shard_path,
-                               shard_rev, max_mem, flush_to_disk,
+                               shard_rev, max_mem, batch,
                                cancel_func, cancel_baton, pool));
   else
     SVN_ERR(pack_phys_addressed(pack_file_dir, shard_path, shard_rev,
-                                max_files_per_dir, flush_to_disk,
+                                max_files_per_dir, batch,
                                 cancel_func, cancel_baton, pool));
+  SVN_ERR(svn_io__batch_fsync_new_path(batch, pack_file_path, pool));
 
   SVN_ERR(svn_io_copy_perms(shard_path, pack_file_dir, pool));
   SVN_ERR(svn_io_set_file_read_only(pack_file_path, FALSE, pool));
 
+  /* Ensure that the pack files and their folders are written to disk,
+   * all in one go. */
+  SVN_ERR(svn_io__batch_fsync_run(batch, pool));
+
   return SVN_NO_ERROR;
 }
 
@@ -1865,6 +1943,8 @@ struct pack_baton
   svn_cancel_func_t cancel_func;
   void *cancel_baton;
   size_t max_mem;
+  svn_fs_fs__open_fs_func_t open_fs_func;
+  void *open_fs_baton;
 
   /* Additional entries valid when entering pack_shard(). */
   const char *revs_dir;
@@ -1957,6 +2037,32 @@ synced_pack_shard(void *baton,
   return SVN_NO_ERROR;
 }
 
+/* Replace the non-packed shard described by BATON with its already
+ * completed pack file and notify the caller.
+ */
+static svn_error_t *
+switch_to_packed_shard(struct pack_baton *baton,
+                       apr_pool_t *pool)
+{
+  fs_fs_data_t *ffd = baton->fs->fsap_data;
+
+  /* For newer repo formats, we only acquired the pack lock so far.
+     Before modifying the repo state by switching over to the packed
+     data, we need to acquire the global (write) lock. */
+  if (ffd->format >= SVN_FS_FS__MIN_PACK_LOCK_FORMAT)
+    SVN_ERR(svn_fs_fs__with_write_lock(baton->fs, synced_pack_shard, baton,
+                                       pool));
+  else
+    SVN_ERR(synced_pack_shard(baton, pool));
+
+  /* Notify caller we're starting to pack this shard. */
+  if (baton->notify_func)
+    SVN_ERR(baton->notify_func(baton->notify_baton, baton->shard,
+                               svn_fs_pack_notify_end, pool));
+
+  return SVN_NO_ERROR;
+}
+
 /* Pack the shard described by BATON.
  *
  * If for some reason we detect a partial packing already performed,
@@ -1992,21 +2098,7 @@ pack_shard(struct pack_baton *baton,
                          baton->max_mem, ffd->flush_to_disk,
                          baton->cancel_func, baton->cancel_baton, pool));
 
-  /* For newer repo formats, we only acquired the pack lock so far.
-     Before modifying the repo state by switching over to the packed
-     data, we need to acquire the global (write) lock. */
-  if (ffd->format >= SVN_FS_FS__MIN_PACK_LOCK_FORMAT)
-    SVN_ERR(svn_fs_fs__with_write_lock(baton->fs, synced_pack_shard, baton,
-                                       pool));
-  else
-    SVN_ERR(synced_pack_shard(baton, pool));
-
-  /* Notify caller we're starting to pack this shard. */
-  if (baton->notify_func)
-    SVN_ERR(baton->notify_func(baton->notify_baton, baton->shard,
-                               svn_fs_pack_notify_end, pool));
-
-  return SVN_NO_ERROR;
+  return svn_error_trace(switch_to_packed_shard(baton, pool));
 }
 
 /* Read the youngest rev and the first non-packed rev info for FS from disk.
@@ -2037,6 +2129,160 @@ get_pack_status(svn_boolean_t *fully_packed,
   return SVN_NO_ERROR;
 }
 
+#if APR_HAS_THREADS
+
+/* Parameters of a parallel pack run.  They are constant while the
+   workers are running. */
+typedef struct parallel_pack_t
+{
+  /* Pack parameters.  PB->FS must only be used by the main thread. */
+  struct pack_baton *pb;
+
+  /* Memory to use per worker. */
+  apr_size_t max_mem;
+} parallel_pack_t;
+
+/* A shard to pack in a worker thread. */
+typedef struct pack_item_t
+{
+  const parallel_pack_t *pp;
+  apr_int64_t shard;
+} pack_item_t;
+
+/* Implements svn_worker_pool__open_func_t.  BATON is the
+   parallel_pack_t. */
+static svn_error_t *
+open_pack_fs(void **thread_baton,
+             void *baton,
+             apr_pool_t *thread_pool)
+{
+  parallel_pack_t *pp = baton;
+  svn_fs_t *fs;
+
+  /* svn_fs_t instances must not be shared between threads. */
+  SVN_ERR(pp->pb->open_fs_func(&fs, pp->pb->open_fs_baton, thread_pool));
+
+  *thread_baton = fs;
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_worker_pool__item_func_t.  ITEM is a pack_item_t whose
+   shard to pack into a new pack file, THREAD_BATON the svn_fs_t. */
+static svn_error_t *
+pack_shard_item(void *item,
+                void *thread_baton,
+                apr_pool_t *scratch_pool)
+{
+  pack_item_t *pi = item;
+  struct pack_baton *pb = pi->pp->pb;
+  svn_fs_t *fs = thread_baton;
+  fs_fs_data_t *ffd = fs->fsap_data;
+  const char *pack_file_dir, *shard_path;
+
+  pack_file_dir = svn_dirent_join(pb->revs_dir,
+                    apr_psprintf(scratch_pool,
+                                 "%" APR_INT64_T_FMT PATH_EXT_PACKED_SHARD,
+                                 pi->shard),
+                    scratch_pool);
+  shard_path = svn_dirent_join(pb->revs_dir,
+                               apr_psprintf(scratch_pool, "%" APR_INT64_T_FMT,
+                                            pi->shard),
+                               scratch_pool);
+
+  return svn_error_trace(pack_rev_shard(fs, pack_file_dir, shard_path,
+                                        pi->shard, ffd->max_files_per_dir,
+                                        pi->pp->max_mem, ffd->flush_to_disk,
+                                        pb->cancel_func, pb->cancel_baton,
+                                        scratch_pool));
+}
+
+/* Pack the shards in PB from FIRST_SHARD up to but not including
+   END_SHARD, using up to JOBS worker threads to create the pack files.
+   Switch to the packed shards strictly in order from within this thread,
+   just as the serial code does.  Set *PACKED to FALSE, without packing
+   anything, if no thread could be started.  Use POOL for allocations. */
+static svn_error_t *
+pack_shards_in_parallel(svn_boolean_t *packed,
+                        struct pack_baton *pb,
+                        apr_int64_t first_shard,
+                        apr_int64_t end_shard,
+                        int jobs,
+                        apr_pool_t *pool)
+{
+  parallel_pack_t *pp = apr_pcalloc(pool, sizeof(*pp));
+  svn_worker_pool__ordered_t *queue;
+  apr_pool_t *iterpool;
+  apr_int64_t next_shard;
+  int capacity;
+
+  /* Allow for some imbalance between shards.  That also limits the number
+     of packed shards waiting to be switched to. */
+  capacity = 2 * jobs;
+
+  pp->pb = pb;
+  SVN_ERR(svn_worker_pool__ordered_create(&queue, jobs, capacity,
+                                          open_pack_fs, pack_shard_item,
+                                          NULL, pp, pool));
+  *packed = queue != NULL;
+  if (!queue)
+    return SVN_NO_ERROR;
+
+  /* The memory limit applies to the whole operation. */
+  pp->max_mem = pb->max_mem / svn_worker_pool__ordered_thread_count(queue);
+
+  iterpool = svn_pool_create(pool);
+  next_shard = first_shard;
+  for (pb->shard = first_shard; pb->shard < end_shard; pb->shard++)
+    {
+      void *item;
+      svn_error_t *item_err;
+      svn_error_t *err = SVN_NO_ERROR;
+
+      svn_pool_clear(iterpool);
+
+      while (   !err
+             && next_shard < end_shard
+             && next_shard < pb->shard + capacity)
+        {
+          pack_item_t *pi = apr_palloc(pool, sizeof(*pi));
+
+          pi->pp = pp;
+          pi->shard = next_shard++;
+          err = svn_worker_pool__ordered_add(queue, pi);
+        }
+
+      if (!err && pb->notify_func)
+        err = pb->notify_func(pb->notify_baton, pb->shard,
+                              svn_fs_pack_notify_start, iterpool);
+
+      /* Wait for the pack file to be complete. */
+      if (!err)
+        err = svn_worker_pool__ordered_take(&item, &item_err, queue, TRUE);
+      if (!err)
+        err = item_err;
+
+      /* Switch over to the packed shard. */
+      if (!err)
+        {
+          pb->rev_shard_path = svn_dirent_join(pb->revs_dir,
+                                 apr_psprintf(iterpool, "%" APR_INT64_T_FMT,
+                                              pb->shard),
+                                 iterpool);
+          err = switch_to_packed_shard(pb, iterpool);
+        }
+
+      if (err)
+        return svn_error_trace(svn_worker_pool__ordered_destroy(queue, err));
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return svn_error_trace(svn_worker_pool__ordered_destroy(queue,
+                                                          SVN_NO_ERROR));
+}
+
+#endif
+
 /* The work-horse for svn_fs_fs__pack, called with the FS write lock.
    This implements the svn_fs_fs__with_write_lock() 'body' callback
    type.  BATON is a 'struct pack_baton *'.
@@ -2080,6 +2326,25 @@ pack_body(void *baton,
     pb->revsprops_dir = svn_dirent_join(pb->fs->path, PATH_REVPROPS_DIR,
                                         pool);
 
+#if APR_HAS_THREADS
+  /* Create multiple pack files at once, if allowed and worthwhile. */
+  if (   ffd->pack_jobs > 1
+      && pb->open_fs_func
+      && ffd->min_unpacked_rev / ffd->max_files_per_dir + 1
+           < completed_shards)
+    {
+      apr_int64_t first_shard = ffd->min_unpacked_rev
+                              / ffd->max_files_per_dir;
+      int jobs = (int)MIN(ffd->pack_jobs, completed_shards - first_shard);
+      svn_boolean_t packed;
+
+      SVN_ERR(pack_shards_in_parallel(&packed, pb, first_shard,
+                                      completed_shards, jobs, pool));
+      if (packed)
+        return SVN_NO_ERROR;
+    }
+#endif
+
   iterpool = svn_pool_create(pool);
   for (pb->shard = ffd->min_unpacked_rev / ffd->max_files_per_dir;
        pb->shard < completed_shards;
@@ -2100,6 +2365,8 @@ pack_body(void *baton,
 svn_error_t *
 svn_fs_fs__pack(svn_fs_t *fs,
                 apr_size_t max_mem,
+                svn_fs_fs__open_fs_func_t open_fs_func,
+                void *open_fs_baton,
                 svn_fs_pack_notify_t notify_func,
                 void *notify_baton,
                 svn_cancel_func_t cancel_func,
@@ -2146,6 +2413,8 @@ svn_fs_fs__pack(svn_fs_t *fs,
   pb.cancel_func = cancel_func;
   pb.cancel_baton = cancel_baton;
   pb.max_mem = max_mem ? max_mem : DEFAULT_MAX_MEM;
+  pb.open_fs_func = open_fs_func;
+  pb.open_fs_baton = open_fs_baton;
 
   if (ffd->format >= SVN_FS_FS__MIN_PACK_LOCK_FORMAT)
     {
@@ -2166,3 +2435,145 @@ svn_fs_fs__pack(svn_fs_t *fs,
 
   return svn_error_trace(err);
 }
+
+/* Baton struct used by repack_body(). */
+struct repack_baton
+{
+  svn_fs_t *fs;
+  apr_int64_t shard;
+  apr_size_t max_mem;
+  svn_cancel_func_t cancel_func;
+  void *cancel_baton;
+};
+
+/* Rewrite the pack file of the shard described by BATON with freshly
+ * placed items and swap it in.  Implements the callback of
+ * svn_fs_fs__with_pack_lock.
+ */
+static svn_error_t *
+repack_body(void *baton,
+            apr_pool_t *pool)
+{
+  struct repack_baton *rb = baton;
+  fs_fs_data_t *ffd = rb->fs->fsap_data;
+  svn_revnum_t shard_rev = (svn_revnum_t)(rb->shard * ffd->max_files_per_dir);
+  pack_context_t context = { 0 };
+  svn_fs_fs__revision_file_t *pack_file;
+  svn_io__batch_fsync_t *batch;
+  apr_array_header_t *max_ids;
+  const char *pack_file_path;
+  const char *pack_file_dir;
+  const char *temp_path;
+  apr_uint64_t item_count = 0;
+  svn_membuffer_t *membuffer;
+  int max_items;
+  int i;
+
+  /* Another process might have packed the repo in the meantime. */
+  SVN_ERR(svn_fs_fs__update_min_unpacked_rev(rb->fs, pool));
+  if (!svn_fs_fs__is_packed_rev(rb->fs, shard_rev))
+    return svn_error_createf(SVN_ERR_FS_NO_SUCH_REVISION, NULL,
+                             _("Shard %s has not been packed"),
+                             apr_psprintf(pool, "%" APR_INT64_T_FMT,
+                                          rb->shard));
+
+  /* All items of the shard get placed in one go. */
+  SVN_ERR(get_max_items(&max_items, rb->max_mem));
+  SVN_ERR(svn_fs_fs__l2p_get_max_ids(&max_ids, rb->fs, shard_rev,
+                                     ffd->max_files_per_dir, pool, pool));
+  for (i = 0; i < max_ids->nelts; ++i)
+    item_count += APR_ARRAY_IDX(max_ids, i, apr_uint64_t);
+
+  if (item_count > (apr_uint64_t)max_items)
+    return svn_error_createf(SVN_ERR_FS_GENERAL, NULL,
+                             _("Repacking shard %s requires more than %s "
+                               "bytes of memory"),
+                             apr_psprintf(pool, "%" APR_INT64_T_FMT,
+                                          rb->shard),
+                             apr_psprintf(pool, "%" APR_SIZE_T_FMT,
+                                          rb->max_mem));
+
+  /* Some useful paths.  Remove the leftovers of interrupted attempts. */
+  pack_file_path = svn_fs_fs__path_rev_packed(rb->fs, shard_rev, PATH_PACKED,
+                                              pool);
+  pack_file_dir = svn_dirent_dirname(pack_file_path, pool);
+  temp_path = svn_dirent_join(pack_file_dir, PATH_REPACK_TEMP, pool);
+
+  SVN_ERR(svn_io_remove_file2(temp_path, TRUE, pool));
+  SVN_ERR(svn_io_remove_file2(svn_dirent_join(pack_file_dir,
+                                              PATH_INDEX PATH_EXT_L2P_INDEX,
+                                              pool),
+                              TRUE, pool));
+  SVN_ERR(svn_io_remove_file2(svn_dirent_join(pack_file_dir,
+                                              PATH_INDEX PATH_EXT_P2L_INDEX,
+                                              pool),
+                              TRUE, pool));
+
+  /* Write the new pack file next to the existing one. */
+  SVN_ERR(svn_io__batch_fsync_create(&batch, ffd->flush_to_disk, pool));
+  SVN_ERR(initialize_pack_context(&context, rb->fs, pack_file_dir,
+                                  PATH_REPACK_TEMP, pack_file_dir, shard_rev,
+                                  max_items, batch, rb->cancel_func,
+                                  rb->cancel_baton, pool));
+
+  /* The items of all revisions are interleaved in the pack file, so
+   * determine where the items of each revision go up-front. */
+  context.end_rev = context.shard_end_rev;
+  for (i = 0, item_count = 0; i < max_ids->nelts; ++i)
+    {
+      APR_ARRAY_PUSH(context.rev_offsets, int) = (int)item_count;
+      item_count += APR_ARRAY_IDX(max_ids, i, apr_uint64_t);
+    }
+
+  /* Phase 2 reads the whole pack file in one go. */
+  SVN_ERR(svn_fs_fs__open_pack_or_rev_file(&pack_file, rb->fs, shard_rev,
+                                           pool, pool));
+  SVN_ERR(svn_fs_fs__auto_read_footer(pack_file));
+  SVN_ERR(copy_items_to_temp(&context, pack_file, shard_rev, pool));
+  SVN_ERR(svn_fs_fs__close_revision_file(pack_file));
+
+  SVN_ERR(store_range(&context, context.reps->nelts, pool));
+  SVN_ERR(close_pack_context(&context, pool));
+
+  /* Make the new pack file look like the old one and put it on disk. */
+  SVN_ERR(svn_io_copy_perms(pack_file_path, temp_path, pool));
+  SVN_ERR(svn_io_set_file_read_only(temp_path, FALSE, pool));
+  SVN_ERR(svn_io__batch_fsync_run(batch, pool));
+
+  /* Atomically replace the old pack file.  Readers that already opened
+   * it continue to use the old contents. */
+  SVN_ERR(svn_io_set_file_read_write(pack_file_path, FALSE, pool));
+  SVN_ERR(svn_io_file_rename2(temp_path, pack_file_path, ffd->flush_to_disk,
+                              pool));
+
+  /* Index data for the old pack file may still be in our caches. */
+  membuffer = svn_cache__get_global_membuffer_cache();
+  if (membuffer)
+    SVN_ERR(svn_cache__membuffer_clear(membuffer));
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_fs_fs__repack_shard(svn_fs_t *fs,
+                        apr_int64_t shard,
+                        apr_size_t max_mem,
+                        svn_cancel_func_t cancel_func,
+                        void *cancel_baton,
+                        apr_pool_t *scratch_pool)
+{
+  struct repack_baton rb = { 0 };
+
+  /* Only log-addressed pack files can be re-ordered. */
+  if (! svn_fs_fs__use_log_addressing(fs))
+    return svn_error_create(SVN_ERR_FS_UNSUPPORTED_FORMAT, NULL, NULL);
+
+  rb.fs = fs;
+  rb.shard = shard;
+  rb.max_mem = max_mem ? max_mem : DEFAULT_MAX_MEM;
+  rb.cancel_func = cancel_func;
+  rb.cancel_baton = cancel_baton;
+
+  return svn_error_trace(svn_fs_fs__with_pack_lock(fs, repack_body, &rb,
+                                                   scratch_pool));
+}
@@ -32,6 +32,13 @@
    MAX_MEM limits the size of in-memory data structures needed for reordering
    items in format 7 repositories.  0 means use the built-in default.
 
+   If OPEN_FS_FUNC is not NULL and FS has been configured to use more than
+   one pack job, create the pack files for multiple shards in parallel.
+   Each worker thread will then use its own FS instance provided by
+   OPEN_FS_FUNC with OPEN_FS_BATON.  Shards are still being switched to
+   their packed form in order, such that the repository stays consistent.
+   MAX_MEM is being split between those workers.
+
    If given, NOTIFY_FUNC will be called with NOTIFY_BATON to report progress.
    Use optional CANCEL_FUNC/CANCEL_BATON for cancellation support.
 
@@ -39,6 +46,8 @@
 svn_error_t *
 svn_fs_fs__pack(svn_fs_t *fs,
                 apr_size_t max_mem,
+                svn_fs_fs__open_fs_func_t open_fs_func,
+                void *open_fs_baton,
                 svn_fs_pack_notify_t notify_func,
                 void *notify_baton,
                 svn_cancel_func_t cancel_func,
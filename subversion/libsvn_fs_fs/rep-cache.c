@@ -32,6 +32,7 @@
 
 #include "svn_path.h"
 
+#include "private/svn_mutex.h"
 #include "private/svn_sqlite.h"
 
 #include "rep-cache-db.h"
@@ -48,9 +49,433 @@ path_rep_cache_db(const char *fs_path,
   return svn_dirent_join(fs_path, REP_CACHE_DB_NAME, result_pool);
 }
 
+
+/** The rep-cache filter.
+ *
+ * Most lookups in the rep-cache miss, in particular during large imports.
+ * To avoid an SQLite query for each of them, we keep a Bloom filter of the
+ * SHA1 keys in the database, shared between all svn_fs_t instances of the
+ * same repository within this process.
+ *
+ * The filter covers all entries for revisions up to COVERED_REV and gets
+ * extended lazily as the youngest revision known to the svn_fs_t moves
+ * on.  Entries are created after the revision has been published, so an
+ * entry added by another process may be missed, if it came in after we
+ * extended the filter to its revision.  That only costs us the sharing
+ * of that representation, never correctness.  False positives simply
+ * result in an SQLite query as before.
+ **/
+
+/* Number of rep-cache lookups, per repository and process, before we
+ * build the filter.  Small commits are served more cheaply by SQLite
+ * than by scanning the whole rep-cache table. */
+#define FILTER_MIN_LOOKUPS 1024
+
+/* Number of filter bits per entry and number of bits to set per entry.
+ * At the filter capacity, this gives a false positive rate below 0.1%. */
+#define FILTER_BITS_PER_ENTRY 16
+#define FILTER_HASHES 8
+
+/* Size limits of the filter in bits, i.e. 128kB to 16MB. */
+#define FILTER_MIN_BITS APR_UINT64_C(0x100000)
+#define FILTER_MAX_BITS APR_UINT64_C(0x8000000)
+
+struct fs_fs_rep_filter_t
+{
+  /* Bit array of MASK + 1 bits.  NULL, if the filter has not been built. */
+  apr_uint64_t *bits;
+  apr_uint64_t mask;
+
+  /* Number of keys added to BITS and the number of keys that BITS may
+   * hold before we rebuild it with a larger size. */
+  apr_int64_t count;
+  apr_int64_t capacity;
+
+  /* All rep-cache entries up to and including this revision have been
+   * added to BITS. */
+  svn_revnum_t covered_rev;
+
+  /* Number of lookups while BITS was NULL. */
+  int lookups;
+
+  /* Owns BITS.  Gets cleared whenever we discard the filter contents. */
+  apr_pool_t *pool;
+
+  /* Serializes all access to this structure. */
+  svn_mutex__t *mutex;
+};
+
+/* Set *H1 and *H2 to two independent hash values for the SHA1 DIGEST.
+ * We use them for double hashing. */
+static void
+filter_hashes(apr_uint64_t *h1,
+              apr_uint64_t *h2,
+              const unsigned char *digest)
+{
+  /* SHA1 digests are evenly distributed, so we can simply take their
+   * bits.  An odd step size makes all probes different. */
+  memcpy(h1, digest, sizeof(*h1));
+  memcpy(h2, digest + sizeof(*h1), sizeof(*h2));
+  *h2 |= 1;
+}
+
+/* Add the SHA1 DIGEST to FILTER, which must have been built. */
+static void
+filter_add(fs_fs_rep_filter_t *filter,
+           const unsigned char *digest)
+{
+  apr_uint64_t h1, h2;
+  int i;
+
+  filter_hashes(&h1, &h2, digest);
+  for (i = 0; i < FILTER_HASHES; ++i, h1 += h2)
+    {
+      apr_uint64_t bit = h1 & filter->mask;
+      filter->bits[bit / 64] |= APR_UINT64_C(1) << (bit % 64);
+    }
+
+  filter->count++;
+}
+
+/* Return FALSE, if the SHA1 DIGEST has definitely not been added to
+ * FILTER, which must have been built. */
+static svn_boolean_t
+filter_test(const fs_fs_rep_filter_t *filter,
+            const unsigned char *digest)
+{
+  apr_uint64_t h1, h2;
+  int i;
+
+  filter_hashes(&h1, &h2, digest);
+  for (i = 0; i < FILTER_HASHES; ++i, h1 += h2)
+    {
+      apr_uint64_t bit = h1 & filter->mask;
+      if ((filter->bits[bit / 64] & (APR_UINT64_C(1) << (bit % 64))) == 0)
+        return FALSE;
+    }
+
+  return TRUE;
+}
+
+/* Discard the contents of FILTER. */
+static void
+filter_reset(fs_fs_rep_filter_t *filter)
+{
+  svn_pool_clear(filter->pool);
+  filter->bits = NULL;
+  filter->mask = 0;
+  filter->count = 0;
+  filter->capacity = 0;
+  filter->covered_rev = SVN_INVALID_REVNUM;
+  filter->lookups = 0;
+}
+
+/* Add the keys of all rep-cache entries in FS for revisions FIRST to LAST
+ * to FILTER.  Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+filter_add_range(fs_fs_rep_filter_t *filter,
+                 svn_fs_t *fs,
+                 svn_revnum_t first,
+                 svn_revnum_t last,
+                 apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  svn_sqlite__stmt_t *stmt;
+  svn_boolean_t have_row;
+  int iterations = 0;
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, ffd->rep_cache_db,
+                                    STMT_GET_REPS_FOR_RANGE));
+  SVN_ERR(svn_sqlite__bindf(stmt, "rr", first, last));
+
+  SVN_ERR(svn_sqlite__step(&have_row, stmt));
+  while (have_row)
+    {
+      svn_checksum_t *checksum;
+      svn_error_t *err;
+
+      /* Clear ITERPOOL occasionally. */
+      if (iterations++ % 16 == 0)
+        svn_pool_clear(iterpool);
+
+      err = svn_checksum_parse_hex(&checksum, svn_checksum_sha1,
+                                   svn_sqlite__column_text(stmt, 0, NULL),
+                                   iterpool);
+      if (err)
+        return svn_error_compose_create(err, svn_sqlite__reset(stmt));
+
+      /* All-zero digests get parsed into NULL. */
+      if (checksum)
+        filter_add(filter, checksum->digest);
+
+      SVN_ERR(svn_sqlite__step(&have_row, stmt));
+    }
+
+  SVN_ERR(svn_sqlite__reset(stmt));
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Build FILTER from scratch, covering all rep-cache entries in FS up to
+ * its youngest revision.  Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+filter_build(fs_fs_rep_filter_t *filter,
+             svn_fs_t *fs,
+             apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  svn_sqlite__stmt_t *stmt;
+  apr_int64_t entries;
+  apr_uint64_t bits = FILTER_MIN_BITS;
+
+  filter_reset(filter);
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, ffd->rep_cache_db,
+                                    STMT_GET_REP_COUNT));
+  SVN_ERR(svn_sqlite__step_row(stmt));
+  entries = svn_sqlite__column_int64(stmt, 0);
+  SVN_ERR(svn_sqlite__reset(stmt));
+
+  /* Leave room for as many new entries as there are existing ones.
+   * If we hit the size limit, the false positive rate will go up but
+   * there is no point in rebuilding the filter. */
+  while (   bits < FILTER_MAX_BITS
+         && bits < (apr_uint64_t)entries * 2 * FILTER_BITS_PER_ENTRY)
+    bits *= 2;
+
+  filter->bits = apr_pcalloc(filter->pool, (apr_size_t)(bits / 8));
+  filter->mask = bits - 1;
+  filter->capacity = bits < FILTER_MAX_BITS
+                   ? (apr_int64_t)(bits / FILTER_BITS_PER_ENTRY)
+                   : APR_INT64_MAX;
+  filter->covered_rev = ffd->youngest_rev_cache;
+
+  return svn_error_trace(filter_add_range(filter, fs, 0,
+                                          filter->covered_rev,
+                                          scratch_pool));
+}
+
+/* Set *MAYBE_PRESENT to FALSE if the rep-cache of FS definitely contains
+ * no entry for the SHA1 DIGEST and to TRUE otherwise.  Build or extend
+ * FILTER as necessary.  FILTER->MUTEX must be held.
+ * Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+filter_check(svn_boolean_t *maybe_present,
+             fs_fs_rep_filter_t *filter,
+             svn_fs_t *fs,
+             const unsigned char *digest,
+             apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  svn_error_t *err = SVN_NO_ERROR;
+
+  *maybe_present = TRUE;
+
+  if (filter->bits == NULL)
+    {
+      if (++filter->lookups < FILTER_MIN_LOOKUPS)
+        return SVN_NO_ERROR;
+
+      err = filter_build(filter, fs, scratch_pool);
+    }
+  else if (filter->count > filter->capacity)
+    {
+      err = filter_build(filter, fs, scratch_pool);
+    }
+  else if (ffd->youngest_rev_cache > filter->covered_rev)
+    {
+      err = filter_add_range(filter, fs, filter->covered_rev + 1,
+                             ffd->youngest_rev_cache, scratch_pool);
+      filter->covered_rev = ffd->youngest_rev_cache;
+    }
+
+  /* Never use an incomplete filter. */
+  if (err)
+    {
+      filter_reset(filter);
+      return svn_error_trace(err);
+    }
+
+  *maybe_present = filter_test(filter, digest);
+
+  return SVN_NO_ERROR;
+}
+
+/* Tell FILTER that the rep-cache has a new entry for the SHA1 DIGEST.
+ * FILTER->MUTEX must be held. */
+static svn_error_t *
+filter_insert(fs_fs_rep_filter_t *filter,
+              const unsigned char *digest)
+{
+  if (filter->bits)
+    filter_add(filter, digest);
+
+  return SVN_NO_ERROR;
+}
+
+/* Tell FILTER that all rep-cache entries younger than YOUNGEST have been
+ * removed.  They may get re-added by other processes later, so FILTER
+ * must not claim to cover them anymore.  FILTER->MUTEX must be held. */
+static svn_error_t *
+filter_truncate(fs_fs_rep_filter_t *filter,
+                svn_revnum_t youngest)
+{
+  if (filter->bits && filter->covered_rev > youngest)
+    filter->covered_rev = youngest;
+
+  return SVN_NO_ERROR;
+}
+
 
+/** The rep-cache write queue.
+ *
+ * If the repository is configured with a rep-cache batch size, commits
+ * don't write their new rep-cache entries themselves but add them to
+ * FFD->REP_QUEUE.  The queue gets written in a single SQLite transaction
+ * once it is full, before anything else modifies or walks the database,
+ * and when the svn_fs_t gets closed.  Lookups check the queue before the
+ * database.  Entries that never make it to the database because the
+ * process died only cost us sharing opportunities.
+ **/
+
+/* Write the representations in REPS (an array of representation_t *) to
+ * the rep-cache database of FS.  Use SCRATCH_POOL for temporary
+ * allocations.
+ *
+ * We use an sqlite transaction to speed things up;
+ * see <http://www.sqlite.org/faq.html#q19>. */
+static svn_error_t *
+write_reps(svn_fs_t *fs,
+           const apr_array_header_t *reps,
+           apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  apr_pool_t *iterpool;
+  svn_error_t *err = SVN_NO_ERROR;
+  int i;
+
+  if (! ffd->rep_cache_db)
+    SVN_ERR(svn_fs_fs__open_rep_cache(fs, scratch_pool));
+
+  SVN_ERR(svn_sqlite__begin_transaction(ffd->rep_cache_db));
+
+  iterpool = svn_pool_create(scratch_pool);
+  for (i = 0; i < reps->nelts && !err; i++)
+    {
+      representation_t *rep = APR_ARRAY_IDX(reps, i, representation_t *);
+
+      svn_pool_clear(iterpool);
+      err = svn_fs_fs__set_rep_reference(fs, rep, iterpool);
+    }
+  svn_pool_destroy(iterpool);
+
+  err = svn_sqlite__finish_transaction(ffd->rep_cache_db, err);
+  if (svn_error_find_cause(err, SVN_ERR_SQLITE_ROLLBACK_FAILED))
+    {
+      /* Failed rollback means that our db connection is unusable, and
+         the only thing we can do is close it.  The connection will be
+         reopened during the next operation with rep-cache.db. */
+      return svn_error_trace(
+          svn_error_compose_create(err, svn_fs_fs__close_rep_cache(fs)));
+    }
+
+  return svn_error_trace(err);
+}
+
+/* Return the queued rep-cache entry in FS for the SHA1 DIGEST or NULL,
+ * if there is none. */
+static representation_t *
+queue_lookup(svn_fs_t *fs,
+             const unsigned char *digest)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+
+  if (! ffd->rep_queue_hash)
+    return NULL;
+
+  return apr_hash_get(ffd->rep_queue_hash, digest, APR_SHA1_DIGESTSIZE);
+}
+
+/* Pool pre-cleanup function writing the rep-cache queue of the svn_fs_t
+ * in BATON before its pool and database connection go away.  Errors are
+ * ignored; there is nobody to report them to. */
+static apr_status_t
+flush_queue_on_close(void *baton)
+{
+  svn_fs_t *fs = baton;
+  fs_fs_data_t *ffd = fs->fsap_data;
+
+  /* Don't reopen the database in a pool that is being destroyed. */
+  if (ffd->rep_cache_db && ffd->rep_queue->nelts)
+    {
+      apr_pool_t *scratch_pool = svn_pool_create(NULL);
+      svn_error_clear(write_reps(fs, ffd->rep_queue, scratch_pool));
+      svn_pool_destroy(scratch_pool);
+    }
+
+  ffd->rep_queue = NULL;
+  ffd->rep_queue_hash = NULL;
+  ffd->rep_queue_pool = NULL;
+
+  return APR_SUCCESS;
+}
+
+/* Add copies of the representations in REPS (an array of
+ * representation_t *) to the rep-cache queue of FS. */
+static void
+queue_reps(svn_fs_t *fs,
+           const apr_array_header_t *reps)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  int i;
+
+  if (! ffd->rep_queue_pool)
+    {
+      ffd->rep_queue_pool = svn_pool_create(fs->pool);
+      ffd->rep_queue = apr_array_make(ffd->rep_queue_pool,
+                                      ffd->rep_cache_batch_size,
+                                      sizeof(representation_t *));
+      ffd->rep_queue_hash = apr_hash_make(ffd->rep_queue_pool);
+
+      /* Pre-cleanups run before the database connection gets closed. */
+      apr_pool_pre_cleanup_register(fs->pool, fs, flush_queue_on_close);
+    }
+
+  for (i = 0; i < reps->nelts; i++)
+    {
+      representation_t *rep = APR_ARRAY_IDX(reps, i, representation_t *);
+
+      if (! queue_lookup(fs, rep->sha1_digest))
+        {
+          rep = svn_fs_fs__rep_copy(rep, ffd->rep_queue_pool);
+          APR_ARRAY_PUSH(ffd->rep_queue, representation_t *) = rep;
+          apr_hash_set(ffd->rep_queue_hash, rep->sha1_digest,
+                       APR_SHA1_DIGESTSIZE, rep);
+        }
+    }
+}
+
+
 /** Library-private API's. **/
 
+svn_error_t *
+svn_fs_fs__create_rep_filter(fs_fs_rep_filter_t **filter,
+                             apr_pool_t *result_pool)
+{
+  fs_fs_rep_filter_t *new_filter = apr_pcalloc(result_pool,
+                                               sizeof(*new_filter));
+
+  new_filter->pool = svn_pool_create(result_pool);
+  new_filter->covered_rev = SVN_INVALID_REVNUM;
+  SVN_ERR(svn_mutex__init(&new_filter->mutex, TRUE, result_pool));
+
+  *filter = new_filter;
+
+  return SVN_NO_ERROR;
+}
+
 /* Body of svn_fs_fs__open_rep_cache().
    Implements svn_atomic__init_once().init_func.
  */
@@ -112,6 +537,10 @@ open_rep_cache(void *baton,
       SVN_SQLITE__ERR_CLOSE(svn_sqlite__exec_statements(sdb, stmt), sdb);
     }
 
+  SVN_SQLITE__ERR_CLOSE(svn_sqlite__set_wal_mode(sdb, ffd->rep_cache_wal,
+                                                 pool),
+                        sdb);
+
   /* This is used as a flag that the database is available so don't
      set it earlier. */
   ffd->rep_cache_db = sdb;
@@ -183,6 +612,7 @@ svn_fs_fs__walk_rep_reference(svn_fs_t *fs,
   /* Don't check ffd->rep_sharing_allowed. */
   SVN_ERR_ASSERT(ffd->format >= SVN_FS_FS__MIN_REP_SHARING_FORMAT);
 
+  SVN_ERR(svn_fs_fs__flush_rep_references(fs, pool));
   if (! ffd->rep_cache_db)
     SVN_ERR(svn_fs_fs__open_rep_cache(fs, pool));
 
@@ -267,8 +697,10 @@ svn_fs_fs__get_rep_reference(representation_t **rep_p,
                              apr_pool_t *pool)
 {
   fs_fs_data_t *ffd = fs->fsap_data;
+  fs_fs_rep_filter_t *filter = ffd->shared->rep_filter;
   svn_sqlite__stmt_t *stmt;
   svn_boolean_t have_row;
+  svn_boolean_t maybe_present;
   representation_t *rep;
 
   SVN_ERR_ASSERT(ffd->rep_sharing_allowed);
@@ -281,6 +713,24 @@ svn_fs_fs__get_rep_reference(representation_t **rep_p,
                             _("Only SHA1 checksums can be used as keys in the "
                               "rep_cache table.\n"));
 
+  /* Entries that we did not write yet. */
+  rep = queue_lookup(fs, checksum->digest);
+  if (rep)
+    {
+      *rep_p = svn_fs_fs__rep_copy(rep, pool);
+      return SVN_NO_ERROR;
+    }
+
+  /* Don't bother SQLite if we know that there is no such entry. */
+  SVN_MUTEX__WITH_LOCK(filter->mutex,
+                       filter_check(&maybe_present, filter, fs,
+                                    checksum->digest, pool));
+  if (!maybe_present)
+    {
+      *rep_p = NULL;
+      return SVN_NO_ERROR;
+    }
+
   SVN_ERR(svn_sqlite__get_statement(&stmt, ffd->rep_cache_db, STMT_GET_REP));
   SVN_ERR(svn_sqlite__bindf(stmt, "s",
                             svn_checksum_to_cstring(checksum, pool)));
@@ -327,6 +777,7 @@ svn_fs_fs__set_rep_reference(svn_fs_t *fs,
                              apr_pool_t *pool)
 {
   fs_fs_data_t *ffd = fs->fsap_data;
+  fs_fs_rep_filter_t *filter = ffd->shared->rep_filter;
   svn_sqlite__stmt_t *stmt;
   svn_error_t *err;
   svn_checksum_t checksum;
@@ -373,11 +824,53 @@ svn_fs_fs__set_rep_reference(svn_fs_t *fs,
              to flag this? */
         }
     }
+  else
+    {
+      SVN_MUTEX__WITH_LOCK(filter->mutex,
+                           filter_insert(filter, rep->sha1_digest));
+    }
 
   return SVN_NO_ERROR;
 }
 
 
+svn_error_t *
+svn_fs_fs__add_rep_references(svn_fs_t *fs,
+                              const apr_array_header_t *reps,
+                              apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+
+  SVN_ERR_ASSERT(ffd->rep_sharing_allowed);
+  if (ffd->rep_cache_batch_size == 0)
+    return svn_error_trace(write_reps(fs, reps, scratch_pool));
+
+  queue_reps(fs, reps);
+  if (ffd->rep_queue->nelts >= ffd->rep_cache_batch_size)
+    SVN_ERR(svn_fs_fs__flush_rep_references(fs, scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_fs_fs__flush_rep_references(svn_fs_t *fs,
+                                apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  svn_error_t *err;
+
+  if (! ffd->rep_queue || ffd->rep_queue->nelts == 0)
+    return SVN_NO_ERROR;
+
+  /* Lookups during the write still find the queued entries.  Don't keep
+     them around for another attempt, though. */
+  err = write_reps(fs, ffd->rep_queue, scratch_pool);
+  apr_array_clear(ffd->rep_queue);
+  apr_hash_clear(ffd->rep_queue_hash);
+
+  return svn_error_trace(err);
+}
+
 svn_error_t *
 svn_fs_fs__del_rep_reference(svn_fs_t *fs,
                              svn_revnum_t youngest,
@@ -387,6 +880,7 @@ svn_fs_fs__del_rep_reference(svn_fs_t *fs,
   svn_sqlite__stmt_t *stmt;
 
   SVN_ERR_ASSERT(ffd->format >= SVN_FS_FS__MIN_REP_SHARING_FORMAT);
+  SVN_ERR(svn_fs_fs__flush_rep_references(fs, pool));
   if (! ffd->rep_cache_db)
     SVN_ERR(svn_fs_fs__open_rep_cache(fs, pool));
 
@@ -395,6 +889,9 @@ svn_fs_fs__del_rep_reference(svn_fs_t *fs,
   SVN_ERR(svn_sqlite__bindf(stmt, "r", youngest));
   SVN_ERR(svn_sqlite__step_done(stmt));
 
+  SVN_MUTEX__WITH_LOCK(ffd->shared->rep_filter->mutex,
+                       filter_truncate(ffd->shared->rep_filter, youngest));
+
   return SVN_NO_ERROR;
 }
 
@@ -408,6 +905,7 @@ lock_rep_cache(svn_fs_t *fs,
 {
   fs_fs_data_t *ffd = fs->fsap_data;
 
+  SVN_ERR(svn_fs_fs__flush_rep_references(fs, pool));
   if (! ffd->rep_cache_db)
     SVN_ERR(svn_fs_fs__open_rep_cache(fs, pool));
 
@@ -63,10 +63,21 @@ svn_fs_fs__walk_rep_reference(svn_fs_t *fs,
                               void *cancel_baton,
                               apr_pool_t *pool);
 
+/* Set *FILTER to a new, empty rep-cache filter allocated in RESULT_POOL.
+   The filter itself gets built on demand. */
+svn_error_t *
+svn_fs_fs__create_rep_filter(fs_fs_rep_filter_t **filter,
+                             apr_pool_t *result_pool);
+
 /* Return the representation REP in FS which has fulltext CHECKSUM.
    *REP_P is allocated in POOL.  If the rep cache database has not been
    opened, just set *REP_P to NULL.  Returns SVN_ERR_FS_CORRUPT if
-   a reference beyond HEAD is detected. */
+   a reference beyond HEAD is detected.
+
+   Once FS has seen enough lookups, they are answered from an in-memory
+   filter whenever that tells us that CHECKSUM is not in the database.
+   References added by other processes for revisions that FS does not
+   know about, yet, may then be missed. */
 svn_error_t *
 svn_fs_fs__get_rep_reference(representation_t **rep_p,
                              svn_fs_t *fs,
@@ -83,6 +94,29 @@ svn_fs_fs__set_rep_reference(svn_fs_t *fs,
                              representation_t *rep,
                              apr_pool_t *pool);
 
+/* Add the representations REPS (an array of representation_t *) of a
+   new revision in FS to the rep cache, using their SHA1 checksums.  Use
+   SCRATCH_POOL for temporary allocations.
+
+   If FS has been configured with a rep-cache batch size, the entries may
+   only be queued in FS.  They will then be visible to lookups in FS but
+   get written to the database later.  See
+   svn_fs_fs__flush_rep_references(). */
+svn_error_t *
+svn_fs_fs__add_rep_references(svn_fs_t *fs,
+                              const apr_array_header_t *reps,
+                              apr_pool_t *scratch_pool);
+
+/* Write the rep cache entries queued in FS by
+   svn_fs_fs__add_rep_references() to the database.  This happens
+   automatically when the queue is full, before the database gets
+   modified or walked otherwise, and when FS gets closed.  The queue will
+   be empty afterwards, even if writing failed.  Use SCRATCH_POOL for
+   temporary allocations. */
+svn_error_t *
+svn_fs_fs__flush_rep_references(svn_fs_t *fs,
+                                apr_pool_t *scratch_pool);
+
 /* Delete from the cache all reps corresponding to revisions younger
    than YOUNGEST. */
 svn_error_t *
@@ -0,0 +1,448 @@
+/* reshard.c --- change the shard size of a FSFS repository
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include "svn_pools.h"
+#include "svn_dirent_uri.h"
+#include "svn_io.h"
+#include "svn_sorts.h"
+
+#include "private/svn_fs_fs_private.h"
+#include "private/svn_io_private.h"
+#include "private/svn_mutex.h"
+#include "private/svn_worker_pool.h"
+
+#include "fs_fs.h"
+#include "util.h"
+
+#include "../libsvn_fs/fs-loader.h"
+
+#include "svn_private_config.h"
+
+/* Resharding works on copies of the "revs" and "revprops" directories.
+ * The files of revisions that are already in the repository never change
+ * (revision files) or get replaced atomically (revprop files), so we can
+ * hard-link them into the new layout while the repository stays online.
+ *
+ * First, we link all revision files into the new layout while holding the
+ * pack lock only.  Then, we take the write lock to link the revisions
+ * added meanwhile as well as all revprop files, swap the directories and
+ * write the new layout to the format file.  Readers that don't find a
+ * file in the old layout re-read the format file and retry.
+ */
+
+/* Number of revisions linked per batch in an unsharded layout. */
+#define LINEAR_BATCH_SIZE 1000
+
+/* Return the path of REV's file within DIR, a "revs" or "revprops"
+ * directory using SHARD_SIZE revisions per shard.  0 means linear.
+ * Allocate the result in POOL. */
+static const char *
+layout_path(const char *dir,
+            svn_revnum_t rev,
+            int shard_size,
+            apr_pool_t *pool)
+{
+  if (shard_size)
+    return svn_dirent_join_many(pool, dir,
+                                apr_psprintf(pool, "%ld", rev / shard_size),
+                                apr_psprintf(pool, "%ld", rev),
+                                SVN_VA_NULL);
+
+  return svn_dirent_join(dir, apr_psprintf(pool, "%ld", rev), pool);
+}
+
+/* Make DST_PATH a hard link to SRC_PATH.  Fall back to copying the file
+ * if the filesystem does not support that.  Use SCRATCH_POOL for
+ * temporary allocations. */
+static svn_error_t *
+link_or_copy(const char *src_path,
+             const char *dst_path,
+             apr_pool_t *scratch_pool)
+{
+  svn_boolean_t linked;
+
+  SVN_ERR(svn_io__create_hardlink(&linked, src_path, dst_path,
+                                  scratch_pool));
+  if (!linked)
+    SVN_ERR(svn_io_copy_file(src_path, dst_path, TRUE, scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Links the files of a range of revisions from one layout into another,
+ * one new shard at a time and optionally using multiple threads. */
+typedef struct linker_t
+{
+  /* Link the files of revisions START_REV up to but not including
+     END_REV from SRC_DIR using OLD_SHARD_SIZE to DST_DIR using
+     NEW_SHARD_SIZE.  Constant while the workers are running. */
+  const char *src_dir;
+  const char *dst_dir;
+  int old_shard_size;
+  int new_shard_size;
+  svn_revnum_t end_rev;
+
+  /* The first revision not yet claimed by some worker. */
+  svn_revnum_t next_rev;
+
+  /* If set, the workers shall exit ASAP. */
+  svn_boolean_t stop;
+
+  /* First error that prevented some worker from doing its job. */
+  svn_error_t *err;
+
+  /* Protects the members above. */
+  svn_mutex__t *mutex;
+} linker_t;
+
+/* Claim the next batch of revisions from LINKER and return its range in
+ * *START and *END.  Set *START to SVN_INVALID_REVNUM if there is nothing
+ * left to do.  A batch never spans more than one new shard. */
+static svn_error_t *
+linker_claim(svn_revnum_t *start,
+             svn_revnum_t *end,
+             linker_t *linker)
+{
+  int batch_size = linker->new_shard_size ? linker->new_shard_size
+                                          : LINEAR_BATCH_SIZE;
+
+  SVN_ERR(svn_mutex__lock(linker->mutex));
+
+  if (linker->stop || linker->next_rev >= linker->end_rev)
+    {
+      *start = SVN_INVALID_REVNUM;
+    }
+  else
+    {
+      *start = linker->next_rev;
+      *end = MIN(linker->end_rev, (*start / batch_size + 1) * batch_size);
+      linker->next_rev = *end;
+    }
+
+  return svn_error_trace(svn_mutex__unlock(linker->mutex, SVN_NO_ERROR));
+}
+
+/* Record ERR as a failure in LINKER and tell all workers to stop. */
+static void
+linker_fail(linker_t *linker,
+            svn_error_t *err)
+{
+  svn_error_clear(svn_mutex__lock(linker->mutex));
+  if (linker->err)
+    svn_error_clear(err);
+  else
+    linker->err = err;
+
+  linker->stop = TRUE;
+  svn_error_clear(svn_mutex__unlock(linker->mutex, SVN_NO_ERROR));
+}
+
+/* Link the batches claimed from LINKER until there are none left.
+ * Call CANCEL_FUNC with CANCEL_BATON between batches unless it is NULL.
+ * Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+linker_run(linker_t *linker,
+           svn_cancel_func_t cancel_func,
+           void *cancel_baton,
+           apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+
+  while (TRUE)
+    {
+      svn_revnum_t start, end, rev;
+      const char *dst_dir = linker->dst_dir;
+
+      svn_pool_clear(iterpool);
+
+      if (cancel_func)
+        SVN_ERR(cancel_func(cancel_baton));
+
+      SVN_ERR(linker_claim(&start, &end, linker));
+      if (!SVN_IS_VALID_REVNUM(start))
+        break;
+
+      if (linker->new_shard_size)
+        dst_dir = svn_dirent_join(dst_dir,
+                                  apr_psprintf(iterpool, "%ld",
+                                               start / linker->new_shard_size),
+                                  iterpool);
+      SVN_ERR(svn_io_make_dir_recursively(dst_dir, iterpool));
+
+      for (rev = start; rev < end; ++rev)
+        SVN_ERR(link_or_copy(layout_path(linker->src_dir, rev,
+                                         linker->old_shard_size, iterpool),
+                             svn_dirent_join(dst_dir,
+                                             apr_psprintf(iterpool, "%ld",
+                                                          rev),
+                                             iterpool),
+                             iterpool));
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_worker_pool__func_t.  BATON is the linker_t. */
+static svn_error_t *
+linker_job(void *baton,
+           apr_pool_t *scratch_pool)
+{
+  linker_t *linker = baton;
+  svn_error_t *err = linker_run(linker, NULL, NULL, scratch_pool);
+
+  if (err)
+    linker_fail(linker, err);
+
+  return SVN_NO_ERROR;
+}
+
+/* Link the files of revisions START_REV up to but not including END_REV
+ * from SRC_DIR using OLD_SHARD_SIZE to DST_DIR using NEW_SHARD_SIZE.
+ * Use up to JOBS threads.  Only the calling thread invokes CANCEL_FUNC
+ * with CANCEL_BATON.  Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+link_files(const char *src_dir,
+           const char *dst_dir,
+           int old_shard_size,
+           int new_shard_size,
+           svn_revnum_t start_rev,
+           svn_revnum_t end_rev,
+           int jobs,
+           svn_cancel_func_t cancel_func,
+           void *cancel_baton,
+           apr_pool_t *scratch_pool)
+{
+  linker_t linker = { 0 };
+  apr_pool_t *workers_pool;
+  svn_worker_pool__t *workers = NULL;
+  svn_error_t *err;
+  int i;
+
+  if (start_rev >= end_rev)
+    return SVN_NO_ERROR;
+
+  linker.src_dir = src_dir;
+  linker.dst_dir = dst_dir;
+  linker.old_shard_size = old_shard_size;
+  linker.new_shard_size = new_shard_size;
+  linker.end_rev = end_rev;
+  linker.next_rev = start_rev;
+
+  /* This thread does its share of the work. */
+  workers_pool = svn_pool_create(scratch_pool);
+  if (jobs > 1)
+    SVN_ERR(svn_worker_pool__create(&workers, jobs - 1, workers_pool));
+
+  SVN_ERR(svn_mutex__init(&linker.mutex, workers != NULL, scratch_pool));
+
+  for (i = 0; workers && i < svn_worker_pool__thread_count(workers); ++i)
+    {
+      err = svn_worker_pool__post(NULL, workers, linker_job, &linker,
+                                  workers_pool);
+      if (err)
+        {
+          linker_fail(&linker, err);
+          break;
+        }
+    }
+
+  err = linker_run(&linker, cancel_func, cancel_baton, scratch_pool);
+  if (err)
+    linker_fail(&linker, err);
+
+  /* Waits for the running jobs to return. */
+  svn_pool_destroy(workers_pool);
+
+  return svn_error_trace(linker.err);
+}
+
+/* Baton for reshard_body() and reshard_swap(). */
+typedef struct reshard_baton_t
+{
+  svn_fs_t *fs;
+  int new_shard_size;
+  int jobs;
+  svn_cancel_func_t cancel_func;
+  void *cancel_baton;
+
+  /* The youngest revision whose files have been linked before getting
+     the write lock. */
+  svn_revnum_t youngest;
+} reshard_baton_t;
+
+/* Return the path of the FS subdirectory NAME with SUFFIX appended.
+ * Allocate the result in POOL. */
+static const char *
+path_with_suffix(svn_fs_t *fs,
+                 const char *name,
+                 const char *suffix,
+                 apr_pool_t *pool)
+{
+  return svn_dirent_join(fs->path, apr_pstrcat(pool, name, suffix,
+                                               SVN_VA_NULL),
+                         pool);
+}
+
+/* Remove the temporary directories of a previous, interrupted reshard
+ * of FS.  Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+remove_temp_dirs(svn_fs_t *fs,
+                 svn_cancel_func_t cancel_func,
+                 void *cancel_baton,
+                 apr_pool_t *scratch_pool)
+{
+  const char *names[] = { PATH_REVS_DIR, PATH_REVPROPS_DIR };
+  const char *suffixes[] = { PATH_RESHARD_TEMP, PATH_RESHARD_OLD };
+  apr_size_t i, k;
+
+  for (i = 0; i < sizeof(names) / sizeof(names[0]); ++i)
+    for (k = 0; k < sizeof(suffixes) / sizeof(suffixes[0]); ++k)
+      SVN_ERR(svn_io_remove_dir2(path_with_suffix(fs, names[i], suffixes[k],
+                                                  scratch_pool),
+                                 TRUE, cancel_func, cancel_baton,
+                                 scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Link the files of the revisions added since BATON->YOUNGEST and all
+ * revprop files into the new layout, put it into place and update the
+ * format file.  This implements the svn_fs_fs__with_write_lock() 'body'
+ * callback type.  BATON is a reshard_baton_t *. */
+static svn_error_t *
+reshard_swap(void *baton,
+             apr_pool_t *pool)
+{
+  reshard_baton_t *rb = baton;
+  svn_fs_t *fs = rb->fs;
+  fs_fs_data_t *ffd = fs->fsap_data;
+  svn_revnum_t youngest;
+  const char *revs_dir = svn_dirent_join(fs->path, PATH_REVS_DIR, pool);
+  const char *revprops_dir = svn_dirent_join(fs->path, PATH_REVPROPS_DIR,
+                                             pool);
+  const char *revs_temp = path_with_suffix(fs, PATH_REVS_DIR,
+                                           PATH_RESHARD_TEMP, pool);
+  const char *revprops_temp = path_with_suffix(fs, PATH_REVPROPS_DIR,
+                                               PATH_RESHARD_TEMP, pool);
+
+  SVN_ERR(svn_fs_fs__youngest_rev(&youngest, fs, pool));
+  SVN_ERR(link_files(revs_dir, revs_temp, ffd->max_files_per_dir,
+                     rb->new_shard_size, rb->youngest + 1, youngest + 1,
+                     rb->jobs, rb->cancel_func, rb->cancel_baton, pool));
+  SVN_ERR(link_files(revprops_dir, revprops_temp, ffd->max_files_per_dir,
+                     rb->new_shard_size, 0, youngest + 1,
+                     rb->jobs, rb->cancel_func, rb->cancel_baton, pool));
+
+  /* No way back from here.  Readers will not find the files they are
+     looking for until the format file has been updated. */
+  SVN_ERR(svn_io_file_rename2(revs_dir,
+                              path_with_suffix(fs, PATH_REVS_DIR,
+                                               PATH_RESHARD_OLD, pool),
+                              FALSE, pool));
+  SVN_ERR(svn_io_file_rename2(revs_temp, revs_dir, FALSE, pool));
+  SVN_ERR(svn_io_file_rename2(revprops_dir,
+                              path_with_suffix(fs, PATH_REVPROPS_DIR,
+                                               PATH_RESHARD_OLD, pool),
+                              FALSE, pool));
+  SVN_ERR(svn_io_file_rename2(revprops_temp, revprops_dir, FALSE, pool));
+
+  ffd->max_files_per_dir = rb->new_shard_size;
+  SVN_ERR(svn_fs_fs__write_format(fs, TRUE, pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Reshard the repository according to BATON.  This implements the
+ * svn_fs_fs__with_pack_lock() 'body' callback type.  BATON is a
+ * reshard_baton_t *. */
+static svn_error_t *
+reshard_body(void *baton,
+             apr_pool_t *pool)
+{
+  reshard_baton_t *rb = baton;
+  svn_fs_t *fs = rb->fs;
+  fs_fs_data_t *ffd = fs->fsap_data;
+
+  if (ffd->max_files_per_dir == rb->new_shard_size)
+    return SVN_NO_ERROR;
+
+  if (ffd->min_unpacked_rev > 0)
+    return svn_error_create(SVN_ERR_UNSUPPORTED_FEATURE, NULL,
+                            _("Repositories with packed shards cannot be "
+                              "resharded"));
+
+  SVN_ERR(remove_temp_dirs(fs, rb->cancel_func, rb->cancel_baton, pool));
+
+  /* Revision files never change, so we can link them without blocking
+     commits. */
+  SVN_ERR(svn_fs_fs__youngest_rev(&rb->youngest, fs, pool));
+  SVN_ERR(link_files(svn_dirent_join(fs->path, PATH_REVS_DIR, pool),
+                     path_with_suffix(fs, PATH_REVS_DIR, PATH_RESHARD_TEMP,
+                                      pool),
+                     ffd->max_files_per_dir, rb->new_shard_size,
+                     0, rb->youngest + 1, rb->jobs,
+                     rb->cancel_func, rb->cancel_baton, pool));
+
+  SVN_ERR(svn_fs_fs__with_write_lock(fs, reshard_swap, rb, pool));
+
+  /* The old layout is no longer referenced. */
+  return svn_error_trace(remove_temp_dirs(fs, rb->cancel_func,
+                                          rb->cancel_baton, pool));
+}
+
+svn_error_t *
+svn_fs_fs__reshard(svn_fs_t *fs,
+                   int new_shard_size,
+                   int jobs,
+                   svn_cancel_func_t cancel_func,
+                   void *cancel_baton,
+                   apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  reshard_baton_t rb = { 0 };
+
+  if (ffd->format < SVN_FS_FS__MIN_PACKED_FORMAT)
+    return svn_error_createf(SVN_ERR_FS_UNSUPPORTED_FORMAT, NULL,
+                             _("FSFS format (%d) too old to reshard; "
+                               "please upgrade the filesystem."),
+                             ffd->format);
+
+  if (new_shard_size < 0)
+    return svn_error_createf(SVN_ERR_INCORRECT_PARAMS, NULL,
+                             _("Invalid shard size %d"), new_shard_size);
+
+  if (ffd->use_log_addressing && new_shard_size == 0)
+    return svn_error_create(SVN_ERR_FS_UNSUPPORTED_FORMAT, NULL,
+                            _("Repositories using logical addressing "
+                              "must be sharded"));
+
+  rb.fs = fs;
+  rb.new_shard_size = new_shard_size;
+  rb.jobs = MAX(jobs, 1);
+  rb.cancel_func = cancel_func;
+  rb.cancel_baton = cancel_baton;
+
+  return svn_error_trace(svn_fs_fs__with_pack_lock(fs, reshard_body, &rb,
+                                                   scratch_pool));
+}
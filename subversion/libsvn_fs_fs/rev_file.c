@@ -20,6 +20,11 @@
  * ====================================================================
  */
 
+#include <apr_portable.h>
+#include <apr_mmap.h>
+
+#include "svn_pools.h"
+
 #include "rev_file.h"
 #include "fs_fs.h"
 #include "index.h"
@@ -29,8 +34,14 @@
 #include "../libsvn_fs/fs-loader.h"
 
 #include "private/svn_io_private.h"
+#include "private/svn_metrics.h"
+#include "private/svn_mutex.h"
 #include "svn_private_config.h"
 
+#ifdef HAVE_POSIX_FADVISE
+#include <fcntl.h>
+#endif
+
 /* Initialize the *FILE structure for REVISION in filesystem FS.  Set its
  * pool member to the provided POOL. */
 static void
@@ -45,6 +56,9 @@ init_revision_file(svn_fs_fs__revision_file_t *file,
   file->start_revision = svn_fs_fs__packed_base_rev(fs, revision);
 
   file->file = NULL;
+  file->mmap = NULL;
+  file->mapped_data = NULL;
+  file->mapped_size = 0;
   file->stream = NULL;
   file->p2l_stream = NULL;
   file->l2p_stream = NULL;
@@ -54,6 +68,7 @@ init_revision_file(svn_fs_fs__revision_file_t *file,
   file->p2l_offset = -1;
   file->p2l_checksum = NULL;
   file->footer_offset = -1;
+  file->shared_pack = NULL;
   file->pool = pool;
 }
 
@@ -120,6 +135,198 @@ auto_make_writable(const char *path,
   return SVN_NO_ERROR;
 }
 
+/* Map all of FILE->FILE read-only into memory.  Any failure to do so
+ * will simply leave FILE unmapped.
+ */
+static void
+map_revision_file(svn_fs_fs__revision_file_t *file)
+{
+#if APR_HAS_MMAP
+  apr_finfo_t finfo;
+  apr_mmap_t *mmap;
+
+  if (apr_file_info_get(&finfo, APR_FINFO_SIZE, file->file))
+    return;
+
+  /* Don't bother with empty files and those that don't fit into our
+   * address space. */
+  if (finfo.size <= 0 || (apr_uint64_t)finfo.size > APR_SIZE_MAX)
+    return;
+
+  if (apr_mmap_create(&mmap, file->file, 0, (apr_size_t)finfo.size,
+                      APR_MMAP_READ, file->pool))
+    return;
+
+  file->mmap = mmap;
+  file->mapped_data = mmap->mm;
+  file->mapped_size = mmap->size;
+#endif
+}
+
+/* The data of a pack file that is shared between all svn_fs_t instances
+ * of a repository: the memory mapping of the whole file and its footer
+ * contents.  The file is being identified by SIZE, MTIME and INODE, so
+ * that a repacked shard will not be mistaken for the old one.
+ */
+typedef struct shared_pack_t
+{
+  /* first revision in the pack file, also the key in the hash */
+  svn_revnum_t start_revision;
+
+  /* identity of the file */
+  apr_off_t size;
+  apr_time_t mtime;
+  apr_ino_t inode;
+
+  /* mapping of the whole file.  NULL if it has not been mapped. */
+  apr_mmap_t *mmap;
+
+  /* footer contents.  L2P_OFFSET is -1 if nobody has read them, yet. */
+  apr_off_t l2p_offset;
+  svn_checksum_t *l2p_checksum;
+  apr_off_t p2l_offset;
+  svn_checksum_t *p2l_checksum;
+  apr_off_t footer_offset;
+
+  /* the store that this entry belongs to */
+  fs_fs_shared_rev_data_t *data;
+} shared_pack_t;
+
+/* Pack file data shared by all svn_fs_t instances of a repository.
+ * Entries never get removed because any svn_fs_fs__revision_file_t may
+ * still be using their mappings.  So, memory usage grows with the number
+ * of pack files read, plus the number of times they got repacked while
+ * this process was running.  Any access requires MUTEX to be held, which
+ * includes the contents of the entries.
+ */
+struct fs_fs_shared_rev_data_t
+{
+  /* svn_revnum_t start revision -> shared_pack_t * */
+  apr_hash_t *packs;
+
+  /* pool used for all entries and mappings */
+  apr_pool_t *pool;
+
+  /* serializes all access to the members above */
+  svn_mutex__t *mutex;
+};
+
+svn_error_t *
+svn_fs_fs__create_shared_rev_data(fs_fs_shared_rev_data_t **data,
+                                  apr_pool_t *result_pool)
+{
+  fs_fs_shared_rev_data_t *result = apr_pcalloc(result_pool,
+                                                sizeof(*result));
+  result->pool = svn_pool_create(result_pool);
+  result->packs = apr_hash_make(result->pool);
+  SVN_ERR(svn_mutex__init(&result->mutex, TRUE, result_pool));
+
+  *data = result;
+
+  return SVN_NO_ERROR;
+}
+
+/* Return the entry for the pack file FILE, described by FINFO, from DATA
+ * in *PACK.  Create the entry if necessary, replacing any entry for an
+ * older version of the file.  If MAP is set, also make sure that FILE
+ * has been mapped into memory.  The caller must hold the mutex.
+ */
+static svn_error_t *
+get_shared_pack_body(shared_pack_t **pack,
+                     fs_fs_shared_rev_data_t *data,
+                     svn_fs_fs__revision_file_t *file,
+                     const apr_finfo_t *finfo,
+                     svn_boolean_t map)
+{
+  shared_pack_t *entry = apr_hash_get(data->packs, &file->start_revision,
+                                      sizeof(file->start_revision));
+
+  /* The pack file may have been replaced by a different one. */
+  if (   !entry
+      || entry->size != finfo->size
+      || entry->mtime != finfo->mtime
+      || entry->inode != finfo->inode)
+    {
+      entry = apr_pcalloc(data->pool, sizeof(*entry));
+      entry->start_revision = file->start_revision;
+      entry->size = finfo->size;
+      entry->mtime = finfo->mtime;
+      entry->inode = finfo->inode;
+      entry->l2p_offset = -1;
+      entry->p2l_offset = -1;
+      entry->footer_offset = -1;
+      entry->data = data;
+
+      apr_hash_set(data->packs, &entry->start_revision,
+                   sizeof(entry->start_revision), entry);
+    }
+
+#if APR_HAS_MMAP
+  /* Don't bother with empty files and those that don't fit into our
+   * address space.  Failing to map simply means no mapping. */
+  if (   map
+      && !entry->mmap
+      && finfo->size > 0
+      && (apr_uint64_t)finfo->size <= APR_SIZE_MAX
+      && apr_mmap_create(&entry->mmap, file->file, 0,
+                         (apr_size_t)finfo->size, APR_MMAP_READ,
+                         data->pool))
+    entry->mmap = NULL;
+#endif
+
+  *pack = entry;
+
+  return SVN_NO_ERROR;
+}
+
+/* Attach the pack file data shared within FS to the newly opened, packed
+ * FILE.  Use the shared memory mapping if MAP is set.  Any failure to
+ * identify the file will simply leave FILE on its own.
+ */
+static svn_error_t *
+use_shared_pack(svn_fs_fs__revision_file_t *file,
+                svn_fs_t *fs,
+                svn_boolean_t map)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  fs_fs_shared_rev_data_t *data = ffd->shared->rev_data;
+  apr_finfo_t finfo;
+  shared_pack_t *entry;
+  apr_status_t status;
+
+  status = apr_file_info_get(&finfo,
+                             APR_FINFO_SIZE | APR_FINFO_MTIME
+                             | APR_FINFO_INODE,
+                             file->file);
+  if (status && !APR_STATUS_IS_INCOMPLETE(status))
+    return SVN_NO_ERROR;
+
+  if ((finfo.valid & (APR_FINFO_SIZE | APR_FINFO_MTIME))
+      != (APR_FINFO_SIZE | APR_FINFO_MTIME))
+    return SVN_NO_ERROR;
+
+  /* Not all platforms provide the inode.  Don't rely on it then. */
+  if (!(finfo.valid & APR_FINFO_INODE))
+    finfo.inode = 0;
+
+  SVN_MUTEX__WITH_LOCK(data->mutex,
+                       get_shared_pack_body(&entry, data, file, &finfo,
+                                            map));
+
+  file->shared_pack = entry;
+  if (map && entry->mmap)
+    {
+      file->mapped_data = entry->mmap->mm;
+      file->mapped_size = entry->mmap->size;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Number of rev / pack files opened, for server statistics.
+ * Looked up on first use. */
+static svn_metrics__t *rev_file_opens_metric = NULL;
+
 /* Core implementation of svn_fs_fs__open_pack_or_rev_file working on an
  * existing, initialized FILE structure.  If WRITABLE is TRUE, give write
  * access to the file - temporarily resetting the r/o state if necessary.
@@ -160,6 +367,23 @@ open_pack_or_rev_file(svn_fs_fs__revision_file_t *file,
                                                   result_pool);
           file->is_packed = svn_fs_fs__is_packed_rev(fs, rev);
 
+          if (!rev_file_opens_metric)
+            rev_file_opens_metric
+              = svn_metrics__counter("svn_fsfs_rev_file_opens_total", NULL,
+                                     "FSFS rev and pack files opened.");
+          svn_metrics__add(rev_file_opens_metric, 1);
+          if (fs->io_trace)
+            ++fs->io_trace->stats.files_opened;
+
+          /* Only pack files are guaranteed to never change.  Share their
+           * data with all other users in this process. */
+          if (file->is_packed && !writable)
+            {
+              SVN_ERR(use_shared_pack(file, fs, ffd->mmap_packed_files));
+              if (!file->shared_pack && ffd->mmap_packed_files)
+                map_revision_file(file);
+            }
+
           return SVN_NO_ERROR;
         }
 
@@ -176,7 +400,10 @@ open_pack_or_rev_file(svn_fs_fs__revision_file_t *file,
                 return svn_error_createf(SVN_ERR_FS_NO_SUCH_REVISION, NULL,
                                          _("No such revision %ld"), rev);
 
-              /* We failed for the first time. Refresh cache & retry. */
+              /* We failed for the first time. Refresh cache & retry.
+               * The shard layout may have changed as well, see
+               * svn_fs_fs__reshard(). */
+              SVN_ERR(svn_fs_fs__read_format_file(fs, scratch_pool));
               SVN_ERR(svn_fs_fs__update_min_unpacked_rev(fs, scratch_pool));
               file->start_revision = svn_fs_fs__packed_base_rev(fs, rev);
 
@@ -227,9 +454,52 @@ svn_fs_fs__open_pack_or_rev_file_writable(svn_fs_fs__revision_file_t** file,
                                                result_pool, scratch_pool));
 }
 
+/* Copy the footer contents of ENTRY to FILE, if known.  The caller must
+ * hold the mutex. */
+static svn_error_t *
+get_shared_footer(svn_fs_fs__revision_file_t *file,
+                  shared_pack_t *entry)
+{
+  if (entry->l2p_offset != -1)
+    {
+      file->l2p_offset = entry->l2p_offset;
+      file->l2p_checksum = svn_checksum_dup(entry->l2p_checksum, file->pool);
+      file->p2l_offset = entry->p2l_offset;
+      file->p2l_checksum = svn_checksum_dup(entry->p2l_checksum, file->pool);
+      file->footer_offset = entry->footer_offset;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Copy the footer contents of FILE to ENTRY unless it has them already.
+ * The caller must hold the mutex. */
+static svn_error_t *
+set_shared_footer(shared_pack_t *entry,
+                  svn_fs_fs__revision_file_t *file)
+{
+  if (entry->l2p_offset == -1)
+    {
+      entry->l2p_offset = file->l2p_offset;
+      entry->l2p_checksum = svn_checksum_dup(file->l2p_checksum,
+                                             entry->data->pool);
+      entry->p2l_offset = file->p2l_offset;
+      entry->p2l_checksum = svn_checksum_dup(file->p2l_checksum,
+                                             entry->data->pool);
+      entry->footer_offset = file->footer_offset;
+    }
+
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *
 svn_fs_fs__auto_read_footer(svn_fs_fs__revision_file_t *file)
 {
+  /* Some other user of the same pack file may have read it already. */
+  if (file->l2p_offset == -1 && file->shared_pack)
+    SVN_MUTEX__WITH_LOCK(file->shared_pack->data->mutex,
+                         get_shared_footer(file, file->shared_pack));
+
   if (file->l2p_offset == -1)
     {
       apr_off_t filesize = 0;
@@ -262,6 +532,10 @@ svn_fs_fs__auto_read_footer(svn_fs_fs__revision_file_t *file)
                                       filesize - footer_length - 1,
                                       file->pool));
       file->footer_offset = filesize - footer_length - 1;
+
+      if (file->shared_pack)
+        SVN_MUTEX__WITH_LOCK(file->shared_pack->data->mutex,
+                             set_shared_footer(file->shared_pack, file));
     }
 
   return SVN_NO_ERROR;
@@ -290,15 +564,65 @@ svn_fs_fs__open_proto_rev_file(svn_fs_fs__revision_file_t **file,
   return SVN_NO_ERROR;
 }
 
+const char *
+svn_fs_fs__rev_file_mapped(svn_fs_fs__revision_file_t *file,
+                           apr_off_t offset,
+                           apr_size_t len)
+{
+  if (   file->mapped_data
+      && offset >= 0
+      && (apr_uint64_t)offset <= file->mapped_size
+      && len <= file->mapped_size - (apr_size_t)offset)
+    return file->mapped_data + offset;
+
+  return NULL;
+}
+
+void
+svn_fs_fs__rev_file_prefetch(svn_fs_fs__revision_file_t *file,
+                             apr_off_t offset,
+                             apr_off_t length)
+{
+#ifdef HAVE_POSIX_FADVISE
+  apr_os_file_t fd;
+  apr_off_t start = offset;
+  apr_off_t end = offset + length;
+
+  /* Proto-rev files have no block size. */
+  if (file->block_size > 0)
+    {
+      start &= ~(file->block_size - 1);
+      end = (end + file->block_size - 1) & ~(file->block_size - 1);
+    }
+
+  /* This is only a hint.  Failures don't matter. */
+  if (apr_os_file_get(&fd, file->file) == APR_SUCCESS)
+    posix_fadvise(fd, start, end - start, POSIX_FADV_WILLNEED);
+#endif
+}
+
 svn_error_t *
 svn_fs_fs__close_revision_file(svn_fs_fs__revision_file_t *file)
 {
+#if APR_HAS_MMAP
+  if (file->mmap)
+    {
+      apr_status_t status = apr_mmap_delete(file->mmap);
+      if (status)
+        return svn_error_wrap_apr(status, _("Can't unmap revision file"));
+    }
+#endif
+
   if (file->stream)
     SVN_ERR(svn_stream_close(file->stream));
   if (file->file)
     SVN_ERR(svn_io_file_close(file->file, file->pool));
 
   file->file = NULL;
+  file->mmap = NULL;
+  file->mapped_data = NULL;
+  file->mapped_size = 0;
+  file->shared_pack = NULL;
   file->stream = NULL;
   file->l2p_stream = NULL;
   file->p2l_stream = NULL;
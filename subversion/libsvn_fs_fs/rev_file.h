@@ -54,6 +54,18 @@ typedef struct svn_fs_fs__revision_file_t
   /* rev / pack file */
   apr_file_t *file;
 
+  /* If not NULL, all of FILE mapped read-only into memory.  May only be
+   * set for pack files, which are immutable.  MAPPED_SIZE is the size of
+   * the mapping in bytes. */
+  struct apr_mmap_t *mmap;
+  const char *mapped_data;
+  apr_size_t mapped_size;
+
+  /* If not NULL, the pack file data shared between all svn_fs_t of the
+   * repository that this FILE uses.  MAPPED_DATA may then point into a
+   * shared mapping, in which case MMAP is NULL. */
+  struct shared_pack_t *shared_pack;
+
   /* stream based on FILE and not NULL exactly when FILE is not NULL */
   svn_stream_t *stream;
 
@@ -137,6 +149,39 @@ svn_fs_fs__open_proto_rev_file(svn_fs_fs__revision_file_t **file,
                                apr_pool_t* result_pool,
                                apr_pool_t *scratch_pool);
 
+/* If FILE has been mapped into memory, return a pointer to the LEN bytes
+ * starting at OFFSET in its mapping.  Return NULL if FILE is not mapped
+ * or the range is not fully contained in it.
+ */
+const char *
+svn_fs_fs__rev_file_mapped(svn_fs_fs__revision_file_t *file,
+                           apr_off_t offset,
+                           apr_size_t len);
+
+/* Tell the OS that the LENGTH bytes starting at OFFSET in FILE will be
+ * read soon, rounded to full blocks.  This allows it to fetch multiple
+ * such ranges concurrently in the background and to overlap their I/O
+ * latencies.  It is merely a hint and does nothing on systems that don't
+ * support it.  FILE must be open.
+ */
+void
+svn_fs_fs__rev_file_prefetch(svn_fs_fs__revision_file_t *file,
+                             apr_off_t offset,
+                             apr_off_t length);
+
+/* Pack file data shared by all svn_fs_t instances of a repository:
+ * memory mappings and footer contents.
+ */
+typedef struct fs_fs_shared_rev_data_t fs_fs_shared_rev_data_t;
+
+/* Create the initially empty store of pack file data shared between
+ * all svn_fs_t instances of a repository and return it in *DATA.
+ * Allocate it in RESULT_POOL, which must be thread-safe.
+ */
+svn_error_t *
+svn_fs_fs__create_shared_rev_data(fs_fs_shared_rev_data_t **data,
+                                  apr_pool_t *result_pool);
+
 /* Close all files and streams in FILE.
  */
 svn_error_t *
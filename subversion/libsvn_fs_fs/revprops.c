@@ -21,6 +21,7 @@
  */
 
 #include <assert.h>
+#include <apr_mmap.h>
 
 #include "svn_pools.h"
 #include "svn_hash.h"
@@ -207,6 +208,279 @@ parse_revprop(apr_hash_t **properties,
   return SVN_NO_ERROR;
 }
 
+/* Revprop generation.
+ *
+ * Without further information, cached revprops must be discarded at every
+ * sync barrier, i.e. whenever the REFRESH flag or
+ * svn_fs_refresh_revision_props() is being used.  Every FS instance uses
+ * its own, unique cache key prefix, so nothing gets shared between them.
+ *
+ * To allow cached revprops to survive barriers and to be shared between
+ * all FS instances of a process, every writer bumps a repository-wide
+ * counter stored in the PATH_REVPROP_COUNTER file.  The file contains a
+ * single svn_atomic_t in native byte order.  Readers map it into memory,
+ * i.e. fetching the current value requires no I/O in the common case and
+ * works the same for forked and threaded server processes.
+ *
+ * Under the repository write lock, the counter gets set to an odd value
+ * before revprops are being modified and to the next even value after
+ * that.  Readers only use even values as cache key prefix and fall back
+ * to unique per-instance prefixes otherwise.  The same happens if the
+ * counter file does not exist at all or cannot be mapped.  Values are
+ * never reused, so outdated cache entries will simply not be found.
+ *
+ * The counter file is only ever modified in place, so existing mappings
+ * remain valid for the lifetime of the process.
+ */
+
+/* Cache key prefixes derived from the revprop generation have this bit
+ * set.  Prefixes from svn_atomic__unique_counter() never do. */
+#define REVPROP_GENERATION_PREFIX (((apr_uint64_t)1) << 63)
+
+/* Per-process, per-repository state of the revprop counter file. */
+struct fs_fs_revprop_generation_t
+{
+  /* The mapped counter.  NULL, if the file has not been mapped (yet). */
+  volatile svn_atomic_t *counter;
+
+  /* The counter file that gets / got mapped.  Naively copied repositories
+   * share this structure; copies at other paths read the file instead. */
+  const char *path;
+
+  /* The mapping and its file are allocated in this pool. */
+  apr_pool_t *pool;
+
+  /* Serializes attempts to map the counter file. */
+  svn_mutex__t *mutex;
+};
+
+svn_error_t *
+svn_fs_fs__create_revprop_generation(fs_fs_revprop_generation_t **generation,
+                                     apr_pool_t *result_pool)
+{
+  fs_fs_revprop_generation_t *result = apr_pcalloc(result_pool,
+                                                   sizeof(*result));
+
+  result->pool = result_pool;
+  SVN_ERR(svn_mutex__init(&result->mutex, TRUE, result_pool));
+
+  *generation = result;
+
+  return SVN_NO_ERROR;
+}
+
+/* Map the counter file at PATH into GENERATION unless that has already
+ * been done.  Any failure to do so will simply leave GENERATION unmapped.
+ * Set *COUNTER to the mapped counter, if that belongs to PATH, or to NULL
+ * otherwise.  Call this only while holding GENERATION->MUTEX.
+ */
+static svn_error_t *
+map_revprop_counter(volatile svn_atomic_t **counter,
+                    fs_fs_revprop_generation_t *generation,
+                    const char *path)
+{
+#if APR_HAS_MMAP
+  if (!generation->path)
+    {
+      apr_pool_t *pool;
+      apr_file_t *file;
+      apr_finfo_t finfo;
+      apr_mmap_t *mmap;
+
+      /* Only keep the file handle and the mapping upon success. */
+      pool = svn_pool_create(generation->pool);
+      if (   apr_file_open(&file, path, APR_READ, APR_OS_DEFAULT, pool)
+          || apr_file_info_get(&finfo, APR_FINFO_SIZE, file)
+          || finfo.size != sizeof(svn_atomic_t)
+          || apr_mmap_create(&mmap, file, 0, sizeof(svn_atomic_t),
+                             APR_MMAP_READ, pool))
+        {
+          svn_pool_destroy(pool);
+        }
+      else
+        {
+          generation->counter = mmap->mm;
+          generation->path = apr_pstrdup(generation->pool, path);
+        }
+    }
+#endif
+
+  *counter = (generation->path && !strcmp(generation->path, path))
+           ? generation->counter
+           : NULL;
+
+  return SVN_NO_ERROR;
+}
+
+/* Read the counter from the open FILE into *VALUE.  Set *VALID to FALSE,
+ * if the file does not contain a counter.  Use SCRATCH_POOL for
+ * temporaries. */
+static svn_error_t *
+read_revprop_counter_file(svn_atomic_t *value,
+                          svn_boolean_t *valid,
+                          apr_file_t *file,
+                          apr_pool_t *scratch_pool)
+{
+  apr_size_t len;
+  apr_off_t offset = 0;
+
+  SVN_ERR(svn_io_file_seek(file, APR_SET, &offset, scratch_pool));
+  SVN_ERR(svn_io_file_read_full2(file, value, sizeof(*value), &len, NULL,
+                                 scratch_pool));
+  *valid = len == sizeof(*value);
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *PREFIX to the revprop cache prefix corresponding to the current
+ * revprop generation in FS.  Set it to 0, if there is no such prefix
+ * because the revprop counter is not available or revprops are being
+ * modified right now.  Use SCRATCH_POOL for temporaries.
+ */
+static svn_error_t *
+read_revprop_generation(apr_uint64_t *prefix,
+                        svn_fs_t *fs,
+                        apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  fs_fs_revprop_generation_t *generation = ffd->shared->revprop_generation;
+  const char *path = svn_fs_fs__path_revprop_counter(fs, scratch_pool);
+  volatile svn_atomic_t *counter;
+  svn_atomic_t value;
+
+  *prefix = 0;
+
+  /* Fast path: the counter is mapped into memory. */
+  SVN_MUTEX__WITH_LOCK(generation->mutex,
+                       map_revprop_counter(&counter, generation, path));
+
+  if (counter)
+    {
+      value = svn_atomic_read(counter);
+    }
+  else
+    {
+      /* Not mappable.  Read the file instead. */
+      apr_file_t *file;
+      svn_boolean_t valid;
+      svn_error_t *err = svn_io_file_open(&file, path, APR_READ,
+                                          APR_OS_DEFAULT, scratch_pool);
+      if (err)
+        {
+          svn_error_clear(err);
+          return SVN_NO_ERROR;
+        }
+
+      SVN_ERR(read_revprop_counter_file(&value, &valid, file,
+                                        scratch_pool));
+      SVN_ERR(svn_io_file_close(file, scratch_pool));
+
+      if (!valid)
+        return SVN_NO_ERROR;
+    }
+
+  /* Odd values mean that revprops are currently being modified (or that
+   * the modification has been aborted). */
+  if ((value & 1) == 0)
+    *prefix = REVPROP_GENERATION_PREFIX | value;
+
+  return SVN_NO_ERROR;
+}
+
+/* Store VALUE in the counter FILE.  Use SCRATCH_POOL for temporaries. */
+static svn_error_t *
+write_revprop_counter_file(apr_file_t *file,
+                           svn_atomic_t value,
+                           apr_pool_t *scratch_pool)
+{
+  apr_off_t offset = 0;
+
+#if APR_HAS_MMAP
+  /* Not all platforms keep file I/O and mappings of the same file
+   * coherent.  So, prefer updating the counter through a mapping. */
+  apr_mmap_t *mmap;
+  if (!apr_mmap_create(&mmap, file, 0, sizeof(value),
+                       APR_MMAP_READ | APR_MMAP_WRITE, scratch_pool))
+    {
+      apr_status_t status;
+
+      svn_atomic_set((volatile svn_atomic_t *)mmap->mm, value);
+      status = apr_mmap_delete(mmap);
+      if (status)
+        return svn_error_wrap_apr(status, _("Can't unmap revprop counter"));
+
+      return SVN_NO_ERROR;
+    }
+#endif
+
+  SVN_ERR(svn_io_file_seek(file, APR_SET, &offset, scratch_pool));
+  SVN_ERR(svn_io_file_write_full(file, &value, sizeof(value), NULL,
+                                 scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Set the revprop counter in FS to the next odd value, if STARTING is
+ * set, or to the next even value otherwise.  Create the counter file if
+ * it does not exist.  Use SCRATCH_POOL for temporaries.
+ */
+static svn_error_t *
+bump_revprop_generation(svn_fs_t *fs,
+                        svn_boolean_t starting,
+                        apr_pool_t *scratch_pool)
+{
+  const char *path = svn_fs_fs__path_revprop_counter(fs, scratch_pool);
+  apr_file_t *file;
+  svn_atomic_t value;
+  svn_boolean_t valid;
+
+  SVN_ERR(svn_io_file_open(&file, path, APR_READ | APR_WRITE | APR_CREATE,
+                           APR_OS_DEFAULT, scratch_pool));
+  SVN_ERR(read_revprop_counter_file(&value, &valid, file, scratch_pool));
+
+  if (!valid)
+    {
+      apr_off_t offset = 0;
+
+      /* New or damaged file.  Start at some arbitrary value that is
+       * unlikely to repeat values that older instances of the file
+       * might have had.  The file must have its final size before it
+       * may be mapped, hence the plain write. */
+      value = (svn_atomic_t)(apr_time_now() / APR_USEC_PER_SEC) | 1;
+
+      SVN_ERR(svn_io_file_trunc(file, 0, scratch_pool));
+      SVN_ERR(svn_io_file_seek(file, APR_SET, &offset, scratch_pool));
+      SVN_ERR(svn_io_file_write_full(file, &value, sizeof(value), NULL,
+                                     scratch_pool));
+    }
+
+  value |= 1;
+  if (!starting)
+    ++value;
+
+  SVN_ERR(write_revprop_counter_file(file, value, scratch_pool));
+  SVN_ERR(svn_io_file_close(file, scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_fs_fs__begin_revprop_change(svn_fs_t *fs,
+                                apr_pool_t *scratch_pool)
+{
+  return svn_error_trace(bump_revprop_generation(fs, TRUE, scratch_pool));
+}
+
+svn_error_t *
+svn_fs_fs__end_revprop_change(svn_fs_t *fs,
+                              apr_pool_t *scratch_pool)
+{
+  /* Our own cache contents is outdated as well. */
+  svn_fs_fs__reset_revprop_cache(fs);
+
+  return svn_error_trace(bump_revprop_generation(fs, FALSE, scratch_pool));
+}
+
 void
 svn_fs_fs__reset_revprop_cache(svn_fs_t *fs)
 {
@@ -222,6 +496,13 @@ prepare_revprop_cache(svn_fs_t *fs,
                       apr_pool_t *scratch_pool)
 {
   fs_fs_data_t *ffd = fs->fsap_data;
+
+  /* Prefer prefixes that are shared with other FS instances and
+   * remain valid across sync barriers. */
+  if (!ffd->revprop_prefix && ffd->use_revprop_generation)
+    SVN_ERR(read_revprop_generation(&ffd->revprop_prefix, fs,
+                                    scratch_pool));
+
   if (!ffd->revprop_prefix)
     SVN_ERR(svn_atomic__unique_counter(&ffd->revprop_prefix));
 
@@ -320,18 +601,21 @@ get_min_filename_len(packed_revprops_t *revprops)
 }
 
 /* Given FS and REVPROPS->REVISION, fill the FILENAME, FOLDER and MANIFEST
- * members. Use RESULT_POOL for allocating results and SCRATCH_POOL for
- * temporaries.
+ * members.  If USE_CACHE is set, the manifest may be taken from the
+ * manifest cache instead of reading it from disk.  Use RESULT_POOL for
+ * allocating results and SCRATCH_POOL for temporaries.
  */
 static svn_error_t *
 get_revprop_packname(svn_fs_t *fs,
                      packed_revprops_t *revprops,
+                     svn_boolean_t use_cache,
                      apr_pool_t *result_pool,
                      apr_pool_t *scratch_pool)
 {
   fs_fs_data_t *ffd = fs->fsap_data;
   svn_stringbuf_t *content = NULL;
   const char *manifest_file_path;
+  pair_cache_key_t key;
   int idx, rev_count;
   char *buffer, *buffer_end;
   const char **filenames, **filenames_end;
@@ -360,7 +644,34 @@ get_revprop_packname(svn_fs_t *fs,
   manifest_file_path
     = svn_dirent_join(revprops->folder, PATH_MANIFEST, result_pool);
 
-  SVN_ERR(svn_fs_fs__read_content(&content, manifest_file_path, result_pool));
+  /* The manifest only changes when a pack file gets split, which also
+   * invalidates the revprop cache.  So, we may use the cached manifest
+   * contents as long as the revprop cache prefix does not change.
+   * Callers retry with USE_CACHE unset should the data turn out to be
+   * outdated anyway. */
+  key.revision = revprops->manifest_start;
+  key.second = ffd->revprop_prefix;
+
+  if (use_cache && ffd->revprop_prefix)
+    {
+      svn_boolean_t is_cached;
+      SVN_ERR(svn_cache__get((void **)&content, &is_cached,
+                             ffd->revprop_manifest_cache, &key,
+                             result_pool));
+      if (!is_cached)
+        content = NULL;
+    }
+
+  if (!content)
+    {
+      SVN_ERR(svn_fs_fs__read_content(&content, manifest_file_path,
+                                      result_pool));
+
+      /* Cache the manifest before the parser below modifies it. */
+      if (ffd->revprop_prefix)
+        SVN_ERR(svn_cache__set(ffd->revprop_manifest_cache, &key, content,
+                               scratch_pool));
+    }
 
   /* There CONTENT must have a certain minimal size and there no
    * unterminated lines at the end of the file.  Both guarantees also
@@ -599,19 +910,150 @@ parse_packed_revprops(svn_fs_t *fs,
   return SVN_NO_ERROR;
 }
 
-/* In filesystem FS, read the packed revprops for revision REV into
- * *REVPROPS. Populate the revprop cache, if POPULATE_CACHE is set.
- * If you want to modify revprop contents / update REVPROPS, READ_ALL
- * must be set.  Otherwise, only the properties of REV are being provided.
- * Allocate data in POOL.
+/* Number of bytes to read from the beginning of a pack file when trying
+ * to access a single revision's revprops in it.  This is enough to cover
+ * the pack header for the typical pack sizes. */
+#define PACK_HEADER_READ_SIZE 0x1000
+
+/* Parse the decimal number at *P, which must be terminated by a newline,
+ * into *VALUE and move *P beyond that newline.  Return FALSE if there is
+ * no such number at *P. */
+static svn_boolean_t
+parse_header_number(apr_uint64_t *value,
+                    const char **p)
+{
+  const char *end;
+
+  *value = svn__strtoul(*p, &end);
+  if (end == *p || *end != '\n')
+    return FALSE;
+
+  *p = end + 1;
+  return TRUE;
+}
+
+/* Try to read the revprops of REVPROPS->REVISION from the pack file at
+ * FILE_PATH without reading the whole file.  That is possible for packs
+ * that are stored without compression (the default) and whose header is
+ * found within the first PACK_HEADER_READ_SIZE bytes.  Upon success, set
+ * the PROPERTIES, SERIALIZED_SIZE and START_REVISION members of REVPROPS.
+ * Otherwise, leave them untouched so the caller can fall back to parsing
+ * the whole pack.
+ *
+ * If the file does not exist and LAST_ATTEMPT is not set, set *MISSING
+ * and return without error.  Allocate the properties in RESULT_POOL and
+ * use SCRATCH_POOL for temporaries.
  */
 static svn_error_t *
-read_pack_revprop(packed_revprops_t **revprops,
-                  svn_fs_t *fs,
-                  svn_revnum_t rev,
-                  svn_boolean_t read_all,
-                  svn_boolean_t populate_cache,
-                  apr_pool_t *pool)
+read_packed_revprop_directly(svn_boolean_t *missing,
+                             svn_fs_t *fs,
+                             packed_revprops_t *revprops,
+                             const char *file_path,
+                             svn_boolean_t last_attempt,
+                             apr_pool_t *result_pool,
+                             apr_pool_t *scratch_pool)
+{
+  apr_file_t *file;
+  svn_error_t *err;
+  char buffer[PACK_HEADER_READ_SIZE + 1];
+  apr_size_t len = PACK_HEADER_READ_SIZE;
+  apr_off_t file_size;
+  apr_off_t offset;
+  apr_uint64_t data_len, first_rev, count, entry_size, size = 0;
+  apr_uint64_t i;
+  apr_off_t preceding_size = 0;
+  const char *p;
+  svn_stringbuf_t *serialized;
+
+  *missing = FALSE;
+
+  err = svn_io_file_open(&file, file_path, APR_READ | APR_BUFFERED,
+                         APR_OS_DEFAULT, scratch_pool);
+  if (err && APR_STATUS_IS_ENOENT(err->apr_err) && !last_attempt)
+    {
+      svn_error_clear(err);
+      *missing = TRUE;
+      return SVN_NO_ERROR;
+    }
+  SVN_ERR(err);
+
+  SVN_ERR(svn_io_file_size_get(&file_size, file, scratch_pool));
+  SVN_ERR(svn_io_file_read_full2(file, buffer, len, &len, NULL,
+                                 scratch_pool));
+  buffer[len] = '\0';
+
+  /* Uncompressed data is prefixed by its length and fills the rest of
+   * the file (see svn__compress_zlib).  Compressed data is always shorter
+   * than its uncompressed length. */
+  p = (const char *)svn__decode_uint(&data_len,
+                                     (const unsigned char *)buffer,
+                                     (const unsigned char *)buffer + len);
+  if (p == NULL || data_len != (apr_uint64_t)(file_size - (p - buffer)))
+    return svn_error_trace(svn_io_file_close(file, scratch_pool));
+
+  /* Parse the header.  Give up if it does not fit into BUFFER. */
+  if (   !parse_header_number(&first_rev, &p)
+      || !parse_header_number(&count, &p))
+    return svn_error_trace(svn_io_file_close(file, scratch_pool));
+
+  if (   revprops->revision < (svn_revnum_t)first_rev
+      || revprops->revision >= (svn_revnum_t)(first_rev + count))
+    return svn_error_createf(SVN_ERR_FS_CORRUPT, NULL,
+                             _("Revprop pack for revision r%ld"
+                               " contains revprops for r%ld .. r%ld"),
+                             revprops->revision,
+                             (svn_revnum_t)first_rev,
+                             (svn_revnum_t)(first_rev + count - 1));
+
+  for (i = 0; i < count; ++i)
+    {
+      if (!parse_header_number(&entry_size, &p))
+        return svn_error_trace(svn_io_file_close(file, scratch_pool));
+
+      if ((svn_revnum_t)(first_rev + i) < revprops->revision)
+        preceding_size += (apr_off_t)entry_size;
+      else if ((svn_revnum_t)(first_rev + i) == revprops->revision)
+        size = entry_size;
+    }
+
+  /* The header is terminated by an empty line. */
+  if (*p != '\n')
+    return svn_error_trace(svn_io_file_close(file, scratch_pool));
+
+  offset = (p + 1 - buffer) + preceding_size;
+  if (offset + (apr_off_t)size > file_size)
+    return svn_error_create(SVN_ERR_FS_CORRUPT, NULL,
+                    _("Packed revprop size exceeds pack file size"));
+
+  /* Read just the revprops of REVPROPS->REVISION. */
+  serialized = svn_stringbuf_create_ensure((apr_size_t)size, scratch_pool);
+  SVN_ERR(svn_io_file_seek(file, APR_SET, &offset, scratch_pool));
+  SVN_ERR(svn_io_file_read_full2(file, serialized->data, (apr_size_t)size,
+                                 NULL, NULL, scratch_pool));
+  serialized->len = (apr_size_t)size;
+  serialized->data[serialized->len] = '\0';
+  SVN_ERR(svn_io_file_close(file, scratch_pool));
+
+  SVN_ERR(parse_revprop(&revprops->properties, fs, revprops->revision,
+                        svn_stringbuf__morph_into_string(serialized),
+                        result_pool, scratch_pool));
+  revprops->serialized_size = serialized->len;
+  revprops->start_revision = (svn_revnum_t)first_rev;
+
+  return SVN_NO_ERROR;
+}
+
+/* Implement read_pack_revprop.  If USE_MANIFEST_CACHE is set, try the
+ * cached pack manifest first.
+ */
+static svn_error_t *
+read_pack_revprop_body(packed_revprops_t **revprops,
+                       svn_fs_t *fs,
+                       svn_revnum_t rev,
+                       svn_boolean_t read_all,
+                       svn_boolean_t populate_cache,
+                       svn_boolean_t use_manifest_cache,
+                       apr_pool_t *pool)
 {
   apr_pool_t *iterpool = svn_pool_create(pool);
   svn_boolean_t missing = FALSE;
@@ -634,7 +1076,9 @@ read_pack_revprop(packed_revprops_t **revprops,
   /* try to read the packed revprops. This may require retries if we have
    * concurrent writers. */
   for (i = 0;
-       i < SVN_FS_FS__RECOVERABLE_RETRY_COUNT && !result->packed_revprops;
+       i < SVN_FS_FS__RECOVERABLE_RETRY_COUNT
+         && !result->packed_revprops
+         && !result->properties;
        ++i)
     {
       const char *file_path;
@@ -643,10 +1087,24 @@ read_pack_revprop(packed_revprops_t **revprops,
       /* there might have been concurrent writes.
        * Re-read the manifest and the pack file.
        */
-      SVN_ERR(get_revprop_packname(fs, result, pool, iterpool));
+      SVN_ERR(get_revprop_packname(fs, result, use_manifest_cache && i == 0,
+                                   pool, iterpool));
       file_path  = svn_dirent_join(result->folder,
                                    result->filename,
                                    iterpool);
+
+      /* If we need nothing but the revprops of REV, try to read just
+       * those instead of the whole pack. */
+      if (!read_all && !populate_cache)
+        {
+          SVN_ERR(read_packed_revprop_directly(&missing, fs, result,
+                                 file_path,
+                                 i + 1 >= SVN_FS_FS__RECOVERABLE_RETRY_COUNT,
+                                 pool, iterpool));
+          if (result->properties || missing)
+            continue;
+        }
+
       SVN_ERR(svn_fs_fs__try_stringbuf_from_file(&result->packed_revprops,
                                 &missing,
                                 file_path,
@@ -654,6 +1112,15 @@ read_pack_revprop(packed_revprops_t **revprops,
                                 pool));
     }
 
+  /* We might be done already. */
+  if (result->properties)
+    {
+      svn_pool_destroy(iterpool);
+      *revprops = result;
+
+      return SVN_NO_ERROR;
+    }
+
   /* the file content should be available now */
   if (!result->packed_revprops)
     return svn_error_createf(SVN_ERR_FS_PACKED_REVPROP_READ_FAILURE, NULL,
@@ -672,6 +1139,38 @@ read_pack_revprop(packed_revprops_t **revprops,
   return SVN_NO_ERROR;
 }
 
+/* In filesystem FS, read the packed revprops for revision REV into
+ * *REVPROPS. Populate the revprop cache, if POPULATE_CACHE is set.
+ * If you want to modify revprop contents / update REVPROPS, READ_ALL
+ * must be set.  Otherwise, only the properties of REV are being provided.
+ * Allocate data in POOL.
+ */
+static svn_error_t *
+read_pack_revprop(packed_revprops_t **revprops,
+                  svn_fs_t *fs,
+                  svn_revnum_t rev,
+                  svn_boolean_t read_all,
+                  svn_boolean_t populate_cache,
+                  apr_pool_t *pool)
+{
+  /* Writers always need to see the latest manifest.  Readers may use a
+   * cached one.  Should that be outdated, start over with the one on disk.
+   */
+  if (!read_all)
+    {
+      svn_error_t *err = read_pack_revprop_body(revprops, fs, rev, FALSE,
+                                                populate_cache, TRUE, pool);
+      if (!err)
+        return SVN_NO_ERROR;
+
+      svn_error_clear(err);
+    }
+
+  return svn_error_trace(read_pack_revprop_body(revprops, fs, rev, read_all,
+                                                populate_cache, FALSE,
+                                                pool));
+}
+
 /* Read the revprops for revision REV in FS and return them in *PROPERTIES_P.
  *
  * Allocations will be done in POOL.
@@ -699,10 +1198,15 @@ svn_fs_fs__get_revision_proplist(apr_hash_t **proplist_p,
 
   if (refresh)
     {
-      /* Previous cache contents is invalid now. */
+      /* Previous cache contents is invalid now - unless it is bound to
+       * the current, repository-wide revprop generation. */
       svn_fs_fs__reset_revprop_cache(fs);
+      SVN_ERR(prepare_revprop_cache(fs, scratch_pool));
+      populate_cache
+        = (ffd->revprop_prefix & REVPROP_GENERATION_PREFIX) != 0;
     }
-  else
+
+  if (populate_cache)
     {
       /* Try cache lookup first. */
       svn_boolean_t is_cached;
@@ -739,6 +1243,18 @@ svn_fs_fs__get_revision_proplist(apr_hash_t **proplist_p,
           svn_error_clear(err);
           *proplist_p = NULL; /* in case read_non_packed_revprop changed it */
         }
+
+      /* The shard layout may have been changed by svn_fs_fs__reshard()
+       * since we read it.  If so, look again at the new location. */
+      if (!*proplist_p)
+        {
+          int max_files_per_dir = ffd->max_files_per_dir;
+
+          SVN_ERR(svn_fs_fs__read_format_file(fs, scratch_pool));
+          if (ffd->max_files_per_dir != max_files_per_dir)
+            SVN_ERR(read_non_packed_revprop(proplist_p, fs, rev,
+                                            populate_cache, result_pool));
+        }
     }
 
   /* if revprop packing is available and we have not read the revprops, yet,
@@ -1175,6 +1691,7 @@ svn_fs_fs__set_revision_proplist(svn_fs_t *fs,
   const char *tmp_path;
   const char *perms_reference;
   apr_array_header_t *files_to_delete = NULL;
+  svn_error_t *err;
 
   SVN_ERR(svn_fs_fs__ensure_revision_exists(rev, fs, pool));
 
@@ -1199,11 +1716,16 @@ svn_fs_fs__set_revision_proplist(svn_fs_t *fs,
    */
   perms_reference = svn_fs_fs__path_rev_absolute(fs, rev, pool);
 
-  /* Now, switch to the new revprop data. */
-  SVN_ERR(switch_to_new_revprop(fs, final_path, tmp_path, perms_reference,
-                                files_to_delete, pool));
+  /* Now, switch to the new revprop data.  Other processes must not
+   * cache anything while we do that. */
+  SVN_ERR(svn_fs_fs__begin_revprop_change(fs, pool));
+  err = switch_to_new_revprop(fs, final_path, tmp_path, perms_reference,
+                              files_to_delete, pool);
 
-  return SVN_NO_ERROR;
+  /* Even if we failed, revprops may have changed.  So, always publish a
+   * new generation. */
+  return svn_error_trace(svn_error_compose_create(err,
+                           svn_fs_fs__end_revprop_change(fs, pool)));
 }
 
 /* Return TRUE, if for REVISION in FS, we can find the revprop pack file.
@@ -1290,7 +1812,7 @@ svn_fs_fs__copy_revprops(const char *pack_file_dir,
                          apr_array_header_t *sizes,
                          apr_size_t total_size,
                          int compression_level,
-                         svn_boolean_t flush_to_disk,
+                         svn_io__batch_fsync_t *batch,
                          svn_cancel_func_t cancel_func,
                          void *cancel_baton,
                          apr_pool_t *scratch_pool)
@@ -1298,6 +1820,7 @@ svn_fs_fs__copy_revprops(const char *pack_file_dir,
   svn_stream_t *pack_stream;
   apr_file_t *pack_file;
   svn_revnum_t rev;
+  const char *pack_file_path;
   apr_pool_t *iterpool = svn_pool_create(scratch_pool);
 
   /* create empty data buffer and a write stream on top of it */
@@ -1312,9 +1835,9 @@ svn_fs_fs__copy_revprops(const char *pack_file_dir,
                                     sizes->nelts, iterpool));
 
   /* Some useful paths. */
-  SVN_ERR(svn_io_file_open(&pack_file, svn_dirent_join(pack_file_dir,
-                                                       pack_filename,
-                                                       scratch_pool),
+  pack_file_path = svn_dirent_join(pack_file_dir, pack_filename,
+                                   scratch_pool);
+  SVN_ERR(svn_io_file_open(&pack_file, pack_file_path,
                            APR_WRITE | APR_CREATE, APR_OS_DEFAULT,
                            scratch_pool));
 
@@ -1351,9 +1874,8 @@ svn_fs_fs__copy_revprops(const char *pack_file_dir,
   /* write the pack file content to disk */
   SVN_ERR(svn_io_file_write_full(pack_file, compressed->data, compressed->len,
                                  NULL, scratch_pool));
-  if (flush_to_disk)
-    SVN_ERR(svn_io_file_flush_to_disk(pack_file, scratch_pool));
   SVN_ERR(svn_io_file_close(pack_file, scratch_pool));
+  SVN_ERR(svn_io__batch_fsync_add_file(batch, pack_file_path, scratch_pool));
 
   svn_pool_destroy(iterpool);
 
@@ -1379,6 +1901,7 @@ svn_fs_fs__pack_revprops_shard(const char *pack_file_dir,
   apr_size_t total_size;
   apr_pool_t *iterpool = svn_pool_create(scratch_pool);
   apr_array_header_t *sizes;
+  svn_io__batch_fsync_t *batch;
 
   /* Sanitize config file values. */
   apr_size_t max_size = (apr_size_t)MIN(MAX(max_pack_size, 1),
@@ -1392,8 +1915,11 @@ svn_fs_fs__pack_revprops_shard(const char *pack_file_dir,
   SVN_ERR(svn_io_remove_dir2(pack_file_dir, TRUE, cancel_func, cancel_baton,
                              scratch_pool));
 
-  /* Create the new directory and manifest file stream. */
+  /* Create the new directory and manifest file stream.  Perform all
+   * fsyncs through a single batch instance. */
+  SVN_ERR(svn_io__batch_fsync_create(&batch, flush_to_disk, scratch_pool));
   SVN_ERR(svn_io_dir_make(pack_file_dir, APR_OS_DEFAULT, scratch_pool));
+  SVN_ERR(svn_io__batch_fsync_new_path(batch, pack_file_dir, scratch_pool));
 
   SVN_ERR(svn_io_file_open(&manifest_file, manifest_file_path,
                            APR_WRITE | APR_BUFFERED | APR_CREATE | APR_EXCL,
@@ -1439,7 +1965,7 @@ svn_fs_fs__pack_revprops_shard(const char *pack_file_dir,
           SVN_ERR(svn_fs_fs__copy_revprops(pack_file_dir, pack_filename,
                                            shard_path, start_rev, rev-1,
                                            sizes, total_size,
-                                           compression_level, flush_to_disk,
+                                           compression_level, batch,
                                            cancel_func, cancel_baton,
                                            iterpool));
 
@@ -1467,16 +1993,19 @@ svn_fs_fs__pack_revprops_shard(const char *pack_file_dir,
     SVN_ERR(svn_fs_fs__copy_revprops(pack_file_dir, pack_filename,
                                      shard_path, start_rev, rev-1,
                                      sizes, (apr_size_t)total_size,
-                                     compression_level, flush_to_disk,
+                                     compression_level, batch,
                                      cancel_func, cancel_baton, iterpool));
 
-  /* flush the manifest file to disk and update permissions */
+  /* close the manifest file and update permissions */
   SVN_ERR(svn_stream_close(manifest_stream));
-  if (flush_to_disk)
-    SVN_ERR(svn_io_file_flush_to_disk(manifest_file, iterpool));
   SVN_ERR(svn_io_file_close(manifest_file, iterpool));
+  SVN_ERR(svn_io__batch_fsync_add_file(batch, manifest_file_path, iterpool));
+  SVN_ERR(svn_io__batch_fsync_new_path(batch, manifest_file_path, iterpool));
   SVN_ERR(svn_io_copy_perms(shard_path, pack_file_dir, iterpool));
 
+  /* flush all pack files, the manifest and the new folder to disk */
+  SVN_ERR(svn_io__batch_fsync_run(batch, iterpool));
+
   svn_pool_destroy(iterpool);
 
   return SVN_NO_ERROR;
@@ -21,6 +21,9 @@
  */
 
 #include "svn_fs.h"
+#include "fs.h"
+
+#include "private/svn_io_private.h"
 
 /* In the filesystem FS, pack all revprop shards up to min_unpacked_rev.
  *
@@ -58,6 +61,27 @@ svn_fs_fs__upgrade_cleanup_pack_revprops(svn_fs_t *fs,
                                          void *cancel_baton,
                                          apr_pool_t *scratch_pool);
 
+/* Create the per-process access structure for the revprop generation
+ * counter of a repository in *GENERATION.  Allocate it in RESULT_POOL. */
+svn_error_t *
+svn_fs_fs__create_revprop_generation(fs_fs_revprop_generation_t **generation,
+                                     apr_pool_t *result_pool);
+
+/* Tell everybody that revprops in FS are about to change.  Until the
+ * matching svn_fs_fs__end_revprop_change() call, no process will use
+ * cached revprops across sync barriers.  The caller must hold the FS
+ * write lock.  Use SCRATCH_POOL for temporaries. */
+svn_error_t *
+svn_fs_fs__begin_revprop_change(svn_fs_t *fs,
+                                apr_pool_t *scratch_pool);
+
+/* Publish a new revprop generation for FS after revprops have been
+ * changed, invalidating all previously cached revprops.  The caller must
+ * hold the FS write lock.  Use SCRATCH_POOL for temporaries. */
+svn_error_t *
+svn_fs_fs__end_revprop_change(svn_fs_t *fs,
+                              apr_pool_t *scratch_pool);
+
 /* Invalidate the revprop cache in FS. */
 void
 svn_fs_fs__reset_revprop_cache(svn_fs_t *fs);
@@ -111,9 +135,9 @@ svn_fs_fs__packed_revprop_available(svn_boolean_t *missing,
  * a hint on which initial buffer size we should use to hold the pack file
  * content.
  *
- * If FLUSH_TO_DISK is non-zero, do not return until the data has actually
- * been written on the disk.  CANCEL_FUNC and CANCEL_BATON are used as usual.
- * Temporary allocations are done in SCRATCH_POOL.
+ * Schedule the new pack file for fsync in BATCH.  CANCEL_FUNC and
+ * CANCEL_BATON are used as usual.  Temporary allocations are done in
+ * SCRATCH_POOL.
  */
 svn_error_t *
 svn_fs_fs__copy_revprops(const char *pack_file_dir,
@@ -124,7 +148,7 @@ svn_fs_fs__copy_revprops(const char *pack_file_dir,
                          apr_array_header_t *sizes,
                          apr_size_t total_size,
                          int compression_level,
-                         svn_boolean_t flush_to_disk,
+                         svn_io__batch_fsync_t *batch,
                          svn_cancel_func_t cancel_func,
                          void *cancel_baton,
                          apr_pool_t *scratch_pool);
@@ -29,6 +29,7 @@
 #include "private/svn_sorts_private.h"
 #include "private/svn_string_private.h"
 #include "private/svn_fs_fs_private.h"
+#include "private/svn_worker_pool.h"
 
 #include "index.h"
 #include "pack.h"
@@ -192,6 +193,13 @@ typedef struct query_t
   /* collected statistics */
   svn_fs_fs__stats_t *stats;
 
+  /* Number of log. addressed rev / pack files to read concurrently. */
+  int jobs;
+
+  /* Callback to open per-thread FS instances and its baton. */
+  svn_fs_fs__open_fs_func_t open_fs_func;
+  void *open_fs_baton;
+
   /* Progress notification callback to call after each shard.  May be NULL. */
   svn_fs_progress_notify_func_t progress_func;
 
@@ -988,53 +996,175 @@ resolve_representation_refs(query_t *query,
   return SVN_NO_ERROR;
 }
 
-/* Process the logically addressed revision contents of revisions BASE to
- * BASE + COUNT - 1 in QUERY.
+/* A reference from a noderev to one of its representations.  We collect
+ * this info while scanning a log. addressed rev / pack file and apply it
+ * afterwards. */
+typedef struct node_ref_t
+{
+  /* Revision that contains the representation. */
+  svn_revnum_t revision;
+
+  /* Item index of the rep within REVISION. */
+  apr_uint64_t item_index;
+
+  /* Size of the (deltified) representation. */
+  apr_uint64_t size;
+
+  /* Size of the representation after de-deltification. */
+  apr_uint64_t expanded_size;
+
+  /* Path of the node with this representation. */
+  const char *path;
+
+  /* Classification of the representation if we are the first to use it.
+   * Values of rep_kind_t. */
+  char kind;
+
+  /* Whether the node has no deltification predecessor. */
+  svn_boolean_t plain_added;
+} node_ref_t;
+
+/* Everything we found while scanning a single log. addressed rev / pack
+ * file.  Apart from the file, this is independent from the rest of the
+ * repository and may be gathered in parallel with other files.
+ */
+typedef struct file_stats_t
+{
+  /* First revision in that file. */
+  svn_revnum_t base;
+
+  /* Number of revisions in that file. */
+  int count;
+
+  /* COUNT revisions starting at BASE.  Their REPRESENTATIONS are not
+   * filled in, yet. */
+  revision_info_t *revisions;
+
+  /* Noderev -> representation links as node_ref_t, in file order. */
+  apr_array_header_t *node_refs;
+
+  /* All delta chain links as rep_ref_t *. */
+  apr_array_header_t *rep_refs;
+} file_stats_t;
+
+/* Record the representation REP of NODEREV in FILE_STATS.  KIND is the
+ * classification if this happens to be the first use of REP.  Allocate
+ * the data in RESULT_POOL.
+ */
+static void
+add_node_ref(file_stats_t *file_stats,
+             node_revision_t *noderev,
+             representation_t *rep,
+             rep_kind_t kind,
+             apr_pool_t *result_pool)
+{
+  node_ref_t *ref = apr_array_push(file_stats->node_refs);
+
+  ref->revision = rep->revision;
+  ref->item_index = rep->item_index;
+  ref->size = rep->size;
+  ref->expanded_size = rep->expanded_size;
+  ref->path = apr_pstrdup(result_pool, noderev->created_path);
+  ref->kind = (char)kind;
+  ref->plain_added = !noderev->predecessor_id;
+}
+
+/* Parse the noderev given as NODEREV_STR in FS and record it in
+ * FILE_STATS.  Allocate the data in RESULT_POOL and use SCRATCH_POOL for
+ * temporaries.  Only used in log. addressing mode.
+ */
+static svn_error_t *
+scan_noderev(file_stats_t *file_stats,
+             svn_fs_t *fs,
+             svn_stringbuf_t *noderev_str,
+             revision_info_t *revision_info,
+             apr_pool_t *result_pool,
+             apr_pool_t *scratch_pool)
+{
+  node_revision_t *noderev;
+
+  svn_stream_t *stream = svn_stream_from_stringbuf(noderev_str, scratch_pool);
+  SVN_ERR(svn_fs_fs__read_noderev(&noderev, stream, scratch_pool,
+                                  scratch_pool));
+  SVN_ERR(svn_fs_fs__fixup_expanded_size(fs, noderev->data_rep,
+                                         scratch_pool));
+  SVN_ERR(svn_fs_fs__fixup_expanded_size(fs, noderev->prop_rep,
+                                         scratch_pool));
+
+  if (noderev->data_rep)
+    add_node_ref(file_stats, noderev, noderev->data_rep,
+                 noderev->kind == svn_node_dir ? dir_rep : file_rep,
+                 result_pool);
+
+  if (noderev->prop_rep)
+    add_node_ref(file_stats, noderev, noderev->prop_rep,
+                 noderev->kind == svn_node_dir ? dir_property_rep
+                                               : file_property_rep,
+                 result_pool);
+
+  /* update stats */
+  if (noderev->kind == svn_node_dir)
+    {
+      revision_info->dir_noderev_size += noderev_str->len;
+      revision_info->dir_noderev_count++;
+    }
+  else
+    {
+      revision_info->file_noderev_size += noderev_str->len;
+      revision_info->file_noderev_count++;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Scan the logically addressed revision contents of revisions BASE to
+ * BASE + COUNT - 1 in FS and return them in *FILE_STATS.  This does not
+ * depend on any data outside that file.  If not NULL, call CANCEL_FUNC
+ * with CANCEL_BATON once in a while.
  *
  * Use RESULT_POOL for persistent allocations and SCRATCH_POOL for
  * temporaries.
  */
 static svn_error_t *
-read_log_rev_or_packfile(query_t *query,
+scan_log_rev_or_packfile(file_stats_t **file_stats,
+                         svn_fs_t *fs,
                          svn_revnum_t base,
                          int count,
+                         svn_cancel_func_t cancel_func,
+                         void *cancel_baton,
                          apr_pool_t *result_pool,
                          apr_pool_t *scratch_pool)
 {
-  fs_fs_data_t *ffd = query->fs->fsap_data;
+  fs_fs_data_t *ffd = fs->fsap_data;
   apr_pool_t *iterpool = svn_pool_create(scratch_pool);
   apr_off_t max_offset;
   apr_off_t offset = 0;
   int i;
   svn_fs_fs__revision_file_t *rev_file;
-
-  /* We collect the delta chain links as we scan the file.  Afterwards,
-   * we determine the lengths of those delta chains and throw this
-   * temporary container away. */
-  apr_array_header_t *rep_refs = apr_array_make(scratch_pool, 64,
-                                                sizeof(rep_ref_t *));
+  file_stats_t *result = apr_pcalloc(result_pool, sizeof(*result));
 
   /* we will process every revision in the rev / pack file */
+  result->base = base;
+  result->count = count;
+  result->revisions = apr_pcalloc(result_pool,
+                                  count * sizeof(*result->revisions));
   for (i = 0; i < count; ++i)
-    {
-      /* create the revision info for the current rev */
-      revision_info_t *info = apr_pcalloc(result_pool, sizeof(*info));
-      info->representations = apr_array_make(result_pool, 4,
-                                             sizeof(rep_stats_t*));
-      info->revision = base + i;
+    result->revisions[i].revision = base + i;
 
-      APR_ARRAY_PUSH(query->revisions, revision_info_t*) = info;
-    }
+  /* We collect the delta chain links as we scan the file.  They get
+   * resolved when merging the result into the query. */
+  result->node_refs = apr_array_make(result_pool, 64, sizeof(node_ref_t));
+  result->rep_refs = apr_array_make(result_pool, 64, sizeof(rep_ref_t *));
 
   /* open the pack / rev file that is covered by the p2l index */
-  SVN_ERR(svn_fs_fs__open_pack_or_rev_file(&rev_file, query->fs, base,
+  SVN_ERR(svn_fs_fs__open_pack_or_rev_file(&rev_file, fs, base,
                                            scratch_pool, iterpool));
-  SVN_ERR(svn_fs_fs__p2l_get_max_offset(&max_offset, query->fs, rev_file,
+  SVN_ERR(svn_fs_fs__p2l_get_max_offset(&max_offset, fs, rev_file,
                                         base, scratch_pool));
 
   /* record the whole pack size in the first rev so the total sum will
      still be correct */
-  APR_ARRAY_IDX(query->revisions, base, revision_info_t*)->end = max_offset;
+  result->revisions[0].end = max_offset;
 
   /* for all offsets in the file, get the P2L index entries and process
      the interesting items (change lists, noderevs) */
@@ -1045,11 +1175,11 @@ read_log_rev_or_packfile(query_t *query,
       svn_pool_clear(iterpool);
 
       /* cancellation support */
-      if (query->cancel_func)
-        SVN_ERR(query->cancel_func(query->cancel_baton));
+      if (cancel_func)
+        SVN_ERR(cancel_func(cancel_baton));
 
       /* get all entries for the current block */
-      SVN_ERR(svn_fs_fs__p2l_index_lookup(&entries, query->fs, rev_file, base,
+      SVN_ERR(svn_fs_fs__p2l_index_lookup(&entries, fs, rev_file, base,
                                           offset, ffd->p2l_page_size,
                                           iterpool, iterpool));
 
@@ -1070,13 +1200,13 @@ read_log_rev_or_packfile(query_t *query,
             continue;
 
           /* read and process interesting items */
-          info = APR_ARRAY_IDX(query->revisions, entry->item.revision,
-                               revision_info_t*);
+          info = &result->revisions[entry->item.revision - base];
 
           if (entry->type == SVN_FS_FS__ITEM_TYPE_NODEREV)
             {
               SVN_ERR(read_item(&item, rev_file, entry, iterpool, iterpool));
-              SVN_ERR(read_noderev(query, item, info, result_pool, iterpool));
+              SVN_ERR(scan_noderev(result, fs, item, info, result_pool,
+                                   iterpool));
             }
           else if (entry->type == SVN_FS_FS__ITEM_TYPE_CHANGES)
             {
@@ -1092,7 +1222,7 @@ read_log_rev_or_packfile(query_t *query,
             {
               /* Collect the delta chain link. */
               svn_fs_fs__rep_header_t *header;
-              rep_ref_t *ref = apr_pcalloc(scratch_pool, sizeof(*ref));
+              rep_ref_t *ref = apr_pcalloc(result_pool, sizeof(*ref));
 
               SVN_ERR(svn_io_file_aligned_seek(rev_file->file,
                                                rev_file->block_size,
@@ -1117,7 +1247,7 @@ read_log_rev_or_packfile(query_t *query,
                   ref->base_revision = SVN_INVALID_REVNUM;
                 }
 
-              APR_ARRAY_PUSH(rep_refs, rep_ref_t *) = ref;
+              APR_ARRAY_PUSH(result->rep_refs, rep_ref_t *) = ref;
             }
 
           /* advance offset */
@@ -1125,15 +1255,122 @@ read_log_rev_or_packfile(query_t *query,
         }
     }
 
-  /* Resolve the delta chain links. */
-  SVN_ERR(resolve_representation_refs(query, rep_refs));
-
   /* clean up and close file handles */
+  SVN_ERR(svn_fs_fs__close_revision_file(rev_file));
   svn_pool_destroy(iterpool);
 
+  *file_stats = result;
+
+  return SVN_NO_ERROR;
+}
+
+/* Add the data gathered in FILE_STATS to QUERY.  Files must be merged in
+ * revision order.  Allocate persistent data in RESULT_POOL.
+ */
+static svn_error_t *
+merge_file_stats(query_t *query,
+                 file_stats_t *file_stats,
+                 apr_pool_t *result_pool)
+{
+  int i;
+
+  /* The revisions and their reps need to survive FILE_STATS. */
+  for (i = 0; i < file_stats->count; ++i)
+    {
+      revision_info_t *info = apr_pmemdup(result_pool,
+                                          &file_stats->revisions[i],
+                                          sizeof(*info));
+      info->representations = apr_array_make(result_pool, 4,
+                                             sizeof(rep_stats_t*));
+
+      APR_ARRAY_PUSH(query->revisions, revision_info_t*) = info;
+    }
+
+  /* Apply the rep references in file order, i.e. in the same order as
+   * a sequential scan would do. */
+  for (i = 0; i < file_stats->node_refs->nelts; ++i)
+    {
+      int idx;
+      revision_info_t *revision_info = NULL;
+      node_ref_t *ref = &APR_ARRAY_IDX(file_stats->node_refs, i, node_ref_t);
+      rep_stats_t *rep = find_representation(&idx, query, &revision_info,
+                                             ref->revision, ref->item_index);
+
+      if (!rep)
+        {
+          /* The rep header will be found as part of one linear walk
+           * through a rev / pack file. */
+          rep = apr_pcalloc(result_pool, sizeof(*rep));
+          rep->revision = ref->revision;
+          rep->expanded_size = ref->expanded_size;
+          rep->item_index = ref->item_index;
+          rep->size = ref->size;
+
+          svn_sort__array_insert(revision_info->representations, &rep, idx);
+        }
+
+      /* if we are the first to use this rep, classify it and record
+       * it amongst the largest changes */
+      if (++rep->ref_count == 1)
+        {
+          rep->kind = ref->kind;
+          add_change(query->stats, rep->size, rep->expanded_size,
+                     rep->revision, ref->path, rep->kind, ref->plain_added);
+        }
+    }
+
+  /* Resolve the delta chain links. */
+  SVN_ERR(resolve_representation_refs(query, file_stats->rep_refs));
+
   return SVN_NO_ERROR;
 }
 
+/* Process the logically addressed revision contents of revisions BASE to
+ * BASE + COUNT - 1 in QUERY.
+ *
+ * Use RESULT_POOL for persistent allocations and SCRATCH_POOL for
+ * temporaries.
+ */
+static svn_error_t *
+read_log_rev_or_packfile(query_t *query,
+                         svn_revnum_t base,
+                         int count,
+                         apr_pool_t *result_pool,
+                         apr_pool_t *scratch_pool)
+{
+  file_stats_t *file_stats;
+
+  SVN_ERR(scan_log_rev_or_packfile(&file_stats, query->fs, base, count,
+                                   query->cancel_func, query->cancel_baton,
+                                   scratch_pool, scratch_pool));
+  SVN_ERR(merge_file_stats(query, file_stats, result_pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Report progress in QUERY after the log. addressed rev / pack file
+ * starting at BASE has been processed.  Use SCRATCH_POOL for temporary
+ * allocations.
+ */
+static void
+notify_log_progress(query_t *query,
+                    svn_revnum_t base,
+                    apr_pool_t *scratch_pool)
+{
+  if (!query->progress_func)
+    return;
+
+  /* one notification per pack file */
+  if (base < query->min_unpacked_rev)
+    query->progress_func(base, query->progress_baton, scratch_pool);
+
+  /* show progress every 1000 revs or so */
+  else if (query->shard_size && (base % query->shard_size == 0))
+    query->progress_func(base, query->progress_baton, scratch_pool);
+  else if (!query->shard_size && (base % 1000 == 0))
+    query->progress_func(base, query->progress_baton, scratch_pool);
+}
+
 /* Read the content of the pack file staring at revision BASE logical
  * addressing mode and store it in QUERY.
  *
@@ -1150,8 +1387,7 @@ read_log_pack_file(query_t *query,
                                    result_pool, scratch_pool));
 
   /* one more pack file processed */
-  if (query->progress_func)
-    query->progress_func(base, query->progress_baton, scratch_pool);
+  notify_log_progress(query, base, scratch_pool);
 
   return SVN_NO_ERROR;
 }
@@ -1170,19 +1406,271 @@ read_log_revision_file(query_t *query,
 {
   SVN_ERR(read_log_rev_or_packfile(query, revision, 1,
                                    result_pool, scratch_pool));
+  notify_log_progress(query, revision, scratch_pool);
 
-  /* show progress every 1000 revs or so */
-  if (query->progress_func)
+  return SVN_NO_ERROR;
+}
+
+#if APR_HAS_THREADS
+
+/* A single log. addressed rev / pack file to be read by a worker thread.
+ */
+typedef struct stats_job_t
+{
+  /* First revision in the file. */
+  svn_revnum_t base;
+
+  /* Number of revisions that the file contains. */
+  int count;
+
+  /* Root pool owning RESULT.  NULL until the worker is done. */
+  apr_pool_t *pool;
+
+  /* Scan result.  Only valid if DONE is set and ERR is NULL. */
+  file_stats_t *result;
+
+  /* Error returned by the scan. */
+  svn_error_t *err;
+
+  /* Set once the worker is done with this job. */
+  svn_boolean_t done;
+} stats_job_t;
+
+/* The list of all files to read, shared between the main thread and the
+ * workers.  CLAIMED, MERGED and STOP as well as the jobs' results are
+ * protected by the mutex of WORKERS.
+ */
+typedef struct stats_queue_t
+{
+  /* All files in revision order. */
+  stats_job_t *jobs;
+  int job_count;
+
+  /* Number of jobs that have been claimed by some worker. */
+  int claimed;
+
+  /* Number of jobs that have been merged into the result. */
+  int merged;
+
+  /* Maximum number of scan results that may be waiting to get merged. */
+  int window;
+
+  /* If set, the workers shall exit ASAP. */
+  svn_boolean_t stop;
+
+  /* Opens the per-thread FS instances. */
+  svn_fs_fs__open_fs_func_t open_fs_func;
+  void *open_fs_baton;
+
+  /* Runs one scan_files_job() per thread.  Notified whenever any of the
+   * above has been changed. */
+  svn_worker_pool__t *workers;
+
+  /* Owns WORKERS. */
+  apr_pool_t *workers_pool;
+} stats_queue_t;
+
+/* Implements svn_worker_pool__func_t.  BATON is the stats_queue_t.
+ * Scan the files claimed from it until there are none left.
+ */
+static svn_error_t *
+scan_files_job(void *baton,
+               apr_pool_t *scratch_pool)
+{
+  stats_queue_t *queue = baton;
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  svn_fs_t *fs = NULL;
+  svn_error_t *open_err = SVN_NO_ERROR;
+
+  while (TRUE)
     {
-      if (query->shard_size && (revision % query->shard_size == 0))
-        query->progress_func(revision, query->progress_baton, scratch_pool);
-      if (!query->shard_size && (revision % 1000 == 0))
-        query->progress_func(revision, query->progress_baton, scratch_pool);
+      stats_job_t *job;
+      apr_pool_t *job_pool;
+      svn_error_t *err = SVN_NO_ERROR;
+
+      svn_error_clear(svn_worker_pool__lock(queue->workers));
+      while (   !err
+             && !queue->stop
+             && queue->claimed < queue->job_count
+             && queue->claimed >= queue->merged + queue->window)
+        err = svn_worker_pool__wait_for_change(queue->workers);
+
+      if (err || queue->stop || queue->claimed == queue->job_count)
+        {
+          svn_error_clear(svn_worker_pool__unlock(queue->workers, err));
+          break;
+        }
+
+      job = &queue->jobs[queue->claimed++];
+      svn_error_clear(svn_worker_pool__unlock(queue->workers,
+                                              SVN_NO_ERROR));
+
+      /* Late FS instance creation keeps idle workers cheap. */
+      svn_pool_clear(iterpool);
+      if (!fs && !open_err)
+        open_err = queue->open_fs_func(&fs, queue->open_fs_baton,
+                                       scratch_pool);
+
+      job_pool = apr_allocator_owner_get(svn_pool_create_allocator(FALSE));
+      if (open_err)
+        err = svn_error_dup(open_err);
+      else
+        err = scan_log_rev_or_packfile(&job->result, fs, job->base,
+                                       job->count, NULL, NULL, job_pool,
+                                       iterpool);
+
+      svn_error_clear(svn_worker_pool__lock(queue->workers));
+      job->pool = job_pool;
+      job->err = err;
+      job->done = TRUE;
+      svn_error_clear(svn_worker_pool__notify(queue->workers));
+      svn_error_clear(svn_worker_pool__unlock(queue->workers,
+                                              SVN_NO_ERROR));
     }
 
+  svn_error_clear(open_err);
+  svn_pool_destroy(iterpool);
+
   return SVN_NO_ERROR;
 }
 
+/* Tell the workers of QUEUE to stop, wait for all of them to exit and
+ * release all outstanding results.  Return ERR.
+ */
+static svn_error_t *
+stop_stats_workers(stats_queue_t *queue,
+                   svn_error_t *err)
+{
+  int i;
+
+  svn_error_clear(svn_worker_pool__lock(queue->workers));
+  queue->stop = TRUE;
+  svn_error_clear(svn_worker_pool__notify(queue->workers));
+  svn_error_clear(svn_worker_pool__unlock(queue->workers, SVN_NO_ERROR));
+
+  /* Waits for the running jobs to return. */
+  svn_pool_destroy(queue->workers_pool);
+
+  for (i = queue->merged; i < queue->job_count; ++i)
+    {
+      svn_error_clear(queue->jobs[i].err);
+      if (queue->jobs[i].pool)
+        svn_pool_destroy(queue->jobs[i].pool);
+    }
+
+  return err;
+}
+
+/* Read the log. addressed repository in QUERY using up to QUERY->JOBS
+ * worker threads and merge the results in revision order from within
+ * this thread.  Set *SCANNED to FALSE, without reading anything, if no
+ * thread could be started.
+ *
+ * Use RESULT_POOL for persistent allocations and SCRATCH_POOL for
+ * temporaries.
+ */
+static svn_error_t *
+read_log_revisions_in_parallel(svn_boolean_t *scanned,
+                               query_t *query,
+                               apr_pool_t *result_pool,
+                               apr_pool_t *scratch_pool)
+{
+  stats_queue_t *queue = apr_pcalloc(scratch_pool, sizeof(*queue));
+  apr_pool_t *iterpool;
+  svn_revnum_t revision;
+  int threads;
+  int i;
+
+  queue->workers_pool = svn_pool_create(scratch_pool);
+  SVN_ERR(svn_worker_pool__create(&queue->workers, query->jobs,
+                                  queue->workers_pool));
+  if (!queue->workers)
+    {
+      svn_pool_destroy(queue->workers_pool);
+      *scanned = FALSE;
+      return SVN_NO_ERROR;
+    }
+
+  *scanned = TRUE;
+  threads = svn_worker_pool__thread_count(queue->workers);
+
+  /* One job per rev / pack file. */
+  queue->jobs = apr_pcalloc(scratch_pool,
+                            (query->head + 1) * sizeof(*queue->jobs));
+  for (revision = 0; revision <= query->head; )
+    {
+      stats_job_t *job = &queue->jobs[queue->job_count++];
+      job->base = revision;
+      job->count = revision < query->min_unpacked_rev ? query->shard_size
+                                                      : 1;
+      revision += job->count;
+    }
+
+  /* Keep all workers busy while we merge but limit the memory usage. */
+  queue->window = 4 * threads;
+  queue->open_fs_func = query->open_fs_func;
+  queue->open_fs_baton = query->open_fs_baton;
+
+  for (i = 0; i < threads; ++i)
+    {
+      svn_error_t *err = svn_worker_pool__post(NULL, queue->workers,
+                                               scan_files_job, queue,
+                                               queue->workers_pool);
+      if (err)
+        return svn_error_trace(stop_stats_workers(queue, err));
+    }
+
+  iterpool = svn_pool_create(scratch_pool);
+
+  /* Merge the results strictly in revision order. */
+  while (queue->merged < queue->job_count)
+    {
+      stats_job_t *job = &queue->jobs[queue->merged];
+      svn_error_t *err;
+
+      svn_pool_clear(iterpool);
+
+      err = svn_worker_pool__lock(queue->workers);
+      if (!err)
+        {
+          while (!err && !job->done)
+            err = svn_worker_pool__wait_for_change(queue->workers);
+          err = svn_worker_pool__unlock(queue->workers, err);
+        }
+
+      if (!err)
+        {
+          err = job->err;
+          job->err = SVN_NO_ERROR;
+        }
+      if (!err)
+        err = merge_file_stats(query, job->result, result_pool);
+      if (!err && query->cancel_func)
+        err = query->cancel_func(query->cancel_baton);
+
+      if (err)
+        return svn_error_trace(stop_stats_workers(queue, err));
+
+      notify_log_progress(query, job->base, iterpool);
+
+      /* Make room for the next job. */
+      svn_pool_destroy(job->pool);
+      job->pool = NULL;
+
+      SVN_ERR(svn_worker_pool__lock(queue->workers));
+      queue->merged++;
+      SVN_ERR(svn_worker_pool__unlock(queue->workers,
+                svn_worker_pool__notify(queue->workers)));
+    }
+
+  SVN_ERR(stop_stats_workers(queue, SVN_NO_ERROR));
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+#endif
+
 /* Read the repository and collect the stats info in QUERY.
  *
  * Use RESULT_POOL for persistent allocations and SCRATCH_POOL for
@@ -1193,9 +1681,23 @@ read_revisions(query_t *query,
                apr_pool_t *result_pool,
                apr_pool_t *scratch_pool)
 {
-  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  apr_pool_t *iterpool;
   svn_revnum_t revision;
 
+#if APR_HAS_THREADS
+  if (query->jobs > 1 && svn_fs_fs__use_log_addressing(query->fs))
+    {
+      svn_boolean_t scanned;
+
+      SVN_ERR(read_log_revisions_in_parallel(&scanned, query, result_pool,
+                                             scratch_pool));
+      if (scanned)
+        return SVN_NO_ERROR;
+    }
+#endif
+
+  iterpool = svn_pool_create(scratch_pool);
+
   /* read all packed revs */
   for ( revision = 0
       ; revision < query->min_unpacked_rev
@@ -1255,13 +1757,16 @@ add_rep_stats(svn_fs_fs__representation_stats_t *stats,
   stats->references += rep->ref_count;
   stats->expanded_size += rep->ref_count * rep->expanded_size;
   stats->chain_len += rep->chain_length;
+  add_to_histogram(&stats->chain_len_histogram, rep->chain_length);
 }
 
 /* Aggregate the info the in revision_info_t * array REVISIONS into the
- * respectve fields of STATS.
+ * respectve fields of STATS.  Revisions before MIN_UNPACKED_REV count as
+ * packed.
  */
 static void
 aggregate_stats(const apr_array_header_t *revisions,
+                svn_revnum_t min_unpacked_rev,
                 svn_fs_fs__stats_t *stats)
 {
   int i, k;
@@ -1277,6 +1782,11 @@ aggregate_stats(const apr_array_header_t *revisions,
       stats->change_count += revision->change_count;
       stats->change_len += revision->changes_len;
       stats->total_size += revision->end - revision->offset;
+      if (revision->revision < min_unpacked_rev)
+        {
+          stats->packed_revision_count++;
+          stats->packed_size += revision->end - revision->offset;
+        }
 
       stats->dir_node_stats.count += revision->dir_noderev_count;
       stats->dir_node_stats.size += revision->dir_noderev_size;
@@ -1339,6 +1849,9 @@ static svn_error_t *
 create_query(query_t **query,
              svn_fs_t *fs,
              svn_fs_fs__stats_t *stats,
+             int jobs,
+             svn_fs_fs__open_fs_func_t open_fs_func,
+             void *open_fs_baton,
              svn_fs_progress_notify_func_t progress_func,
              void *progress_baton,
              svn_cancel_func_t cancel_func,
@@ -1368,6 +1881,9 @@ create_query(query_t **query,
   /* Store other parameters */
   (*query)->fs = fs;
   (*query)->stats = stats;
+  (*query)->jobs = open_fs_func ? MAX(jobs, 1) : 1;
+  (*query)->open_fs_func = open_fs_func;
+  (*query)->open_fs_baton = open_fs_baton;
   (*query)->progress_func = progress_func;
   (*query)->progress_baton = progress_baton;
   (*query)->cancel_func = cancel_func;
@@ -1379,6 +1895,9 @@ create_query(query_t **query,
 svn_error_t *
 svn_fs_fs__get_stats(svn_fs_fs__stats_t **stats,
                      svn_fs_t *fs,
+                     int jobs,
+                     svn_fs_fs__open_fs_func_t open_fs_func,
+                     void *open_fs_baton,
                      svn_fs_progress_notify_func_t progress_func,
                      void *progress_baton,
                      svn_cancel_func_t cancel_func,
@@ -1389,11 +1908,12 @@ svn_fs_fs__get_stats(svn_fs_fs__stats_t **stats,
   query_t *query;
 
   *stats = create_stats(result_pool);
-  SVN_ERR(create_query(&query, fs, *stats, progress_func, progress_baton,
+  SVN_ERR(create_query(&query, fs, *stats, jobs, open_fs_func,
+                       open_fs_baton, progress_func, progress_baton,
                        cancel_func, cancel_baton, scratch_pool,
                        scratch_pool));
   SVN_ERR(read_revisions(query, scratch_pool, scratch_pool));
-  aggregate_stats(query->revisions, *stats);
+  aggregate_stats(query->revisions, query->min_unpacked_rev, *stats);
 
   return SVN_NO_ERROR;
 }
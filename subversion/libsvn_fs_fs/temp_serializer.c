@@ -313,6 +313,7 @@ svn_fs_fs__noderev_serialize(svn_temp_serializer__context_t *context,
   /* serialize sub-structures */
   svn_fs_fs__id_serialize(context, &noderev->id);
   svn_fs_fs__id_serialize(context, &noderev->predecessor_id);
+  svn_fs_fs__id_serialize(context, &noderev->skip_id);
   serialize_representation(context, &noderev->prop_rep);
   serialize_representation(context, &noderev->data_rep);
 
@@ -343,6 +344,7 @@ svn_fs_fs__noderev_deserialize(void *buffer,
   /* fixup of sub-structures */
   svn_fs_fs__id_deserialize(noderev, (svn_fs_id_t **)&noderev->id);
   svn_fs_fs__id_deserialize(noderev, (svn_fs_id_t **)&noderev->predecessor_id);
+  svn_fs_fs__id_deserialize(noderev, (svn_fs_id_t **)&noderev->skip_id);
   svn_temp_deserializer__resolve(noderev, (void **)&noderev->prop_rep);
   svn_temp_deserializer__resolve(noderev, (void **)&noderev->data_rep);
 
@@ -1141,7 +1143,10 @@ svn_fs_fs__reset_txn_filesize(void **data,
                               apr_pool_t *pool)
 {
   dir_data_t *dir_data = (dir_data_t *)*data;
-  dir_data->txn_filesize = SVN_INVALID_FILESIZE;
+  const svn_filesize_t *expected = baton;
+
+  if (!expected || dir_data->txn_filesize == *expected)
+    dir_data->txn_filesize = SVN_INVALID_FILESIZE;
 
   return SVN_NO_ERROR;
 }
@@ -336,7 +336,8 @@ svn_fs_fs__replace_dir_entry(void **data,
 /**
  * Implements #svn_cache__partial_setter_func_t for a #svn_fs_fs__dir_data_t
  * at @a *data, resetting its txn_filesize field to SVN_INVALID_FILESIZE.
- * &a baton should be NULL.
+ * If @a baton is not NULL, it points to a #svn_filesize_t and the entry
+ * will only be modified if its txn_filesize matches that value.
  */
 svn_error_t *
 svn_fs_fs__reset_txn_filesize(void **data,
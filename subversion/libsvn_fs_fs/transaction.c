@@ -23,6 +23,7 @@
 #include "transaction.h"
 
 #include <assert.h>
+#include <apr_thread_cond.h>
 #include <apr_sha1.h>
 
 #include "svn_error_codes.h"
@@ -42,9 +43,12 @@
 #include "cached_data.h"
 #include "lock.h"
 #include "rep-cache.h"
+#include "verify.h"
 
+#include "private/svn_delta_private.h"
 #include "private/svn_fs_util.h"
 #include "private/svn_fspath.h"
+#include "private/svn_io_private.h"
 #include "private/svn_sorts_private.h"
 #include "private/svn_subr_private.h"
 #include "private/svn_string_private.h"
@@ -106,7 +110,8 @@ static txn_vtable_t txn_vtable = {
   svn_fs_fs__txn_proplist,
   svn_fs_fs__change_txn_prop,
   svn_fs_fs__txn_root,
-  svn_fs_fs__change_txn_props
+  svn_fs_fs__change_txn_props,
+  svn_fs_fs__flush_txn
 };
 
 /* FSFS-specific data being attached to svn_fs_txn_t.
@@ -163,6 +168,9 @@ get_shared_txn(svn_fs_t *fs,
 
   txn->txn_id = *txn_id;
   txn->being_written = FALSE;
+  txn->staged_files = NULL;
+  txn->staged_size = 0;
+  txn->staged_pool = NULL;
 
   /* Link this transaction into the head of the list.  We will typically
      be dealing with only one active transaction at a time, so it makes
@@ -201,7 +209,12 @@ free_shared_txn(svn_fs_t *fs, const svn_fs_fs__id_part_t *txn_id)
      we will maintain a single-object free list so that we can hopefully
      keep reusing the same transaction object. */
   if (!ffsd->free_txn)
-    ffsd->free_txn = txn;
+    {
+      if (txn->staged_pool)
+        svn_pool_destroy(txn->staged_pool);
+
+      ffsd->free_txn = txn;
+    }
   else
     svn_pool_destroy(txn->pool);
 }
@@ -496,6 +509,222 @@ purge_shared_txn(svn_fs_t *fs,
 {
   return with_txnlist_lock(fs, purge_shared_txn_body, txn_id, pool);
 }
+
+/* Functions for staging small transactions in memory. */
+
+/* Write all files that are staged in memory for TXN to disk and stop
+   staging TXN.  TXN must be locked via the txn_list_lock mutex.  Use
+   SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+spill_staged_txn(fs_fs_shared_txn_data_t *txn,
+                 apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  apr_hash_index_t *hi;
+
+  for (hi = apr_hash_first(scratch_pool, txn->staged_files);
+       hi;
+       hi = apr_hash_next(hi))
+    {
+      const char *path = apr_hash_this_key(hi);
+      svn_stringbuf_t *contents = apr_hash_this_val(hi);
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_io_file_create_bytes(path, contents->data, contents->len,
+                                       iterpool));
+    }
+
+  svn_pool_destroy(iterpool);
+
+  svn_pool_destroy(txn->staged_pool);
+  txn->staged_pool = NULL;
+  txn->staged_files = NULL;
+  txn->staged_size = 0;
+
+  return SVN_NO_ERROR;
+}
+
+/* Callback used in the implementation of start_staged_txn(). */
+static svn_error_t *
+start_staged_txn_body(svn_fs_t *fs, const void *baton, apr_pool_t *pool)
+{
+  const svn_fs_fs__id_part_t *txn_id = baton;
+  fs_fs_shared_txn_data_t *txn = get_shared_txn(fs, txn_id, TRUE);
+
+  txn->staged_pool = svn_pool_create(txn->pool);
+  txn->staged_files = svn_hash__make(txn->staged_pool);
+  txn->staged_size = 0;
+
+  /* Every transaction starts with an empty changes file. */
+  svn_hash_sets(txn->staged_files,
+                path_txn_changes(fs, txn_id, txn->staged_pool),
+                svn_stringbuf_create_empty(txn->staged_pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Keep the node revisions and changes of the new transaction TXN_ID in
+   FS in memory until they exceed the configured txn-staging-size.
+   Perform all allocations in POOL. */
+static svn_error_t *
+start_staged_txn(svn_fs_t *fs,
+                 const svn_fs_fs__id_part_t *txn_id,
+                 apr_pool_t *pool)
+{
+  return with_txnlist_lock(fs, start_staged_txn_body, txn_id, pool);
+}
+
+/* A structure used by stage_txn_file() and stage_txn_file_body(),
+   which see. */
+struct stage_txn_file_baton
+{
+  svn_boolean_t *staged;
+  svn_fs_fs__id_part_t txn_id;
+  const char *path;
+  const svn_stringbuf_t *contents;
+  svn_boolean_t append;
+};
+
+/* Callback used in the implementation of stage_txn_file(). */
+static svn_error_t *
+stage_txn_file_body(svn_fs_t *fs, const void *baton, apr_pool_t *pool)
+{
+  const struct stage_txn_file_baton *b = baton;
+  fs_fs_data_t *ffd = fs->fsap_data;
+  fs_fs_shared_txn_data_t *txn = get_shared_txn(fs, &b->txn_id, FALSE);
+  svn_stringbuf_t *staged;
+
+  *b->staged = txn && txn->staged_files;
+  if (!*b->staged)
+    return SVN_NO_ERROR;
+
+  staged = svn_hash_gets(txn->staged_files, b->path);
+  if (!b->contents)
+    {
+      if (staged)
+        {
+          txn->staged_size -= staged->len;
+          svn_hash_sets(txn->staged_files, b->path, NULL);
+        }
+
+      return SVN_NO_ERROR;
+    }
+
+  if (!staged)
+    {
+      staged = svn_stringbuf_create_ensure(b->contents->len,
+                                           txn->staged_pool);
+      svn_hash_sets(txn->staged_files,
+                    apr_pstrdup(txn->staged_pool, b->path), staged);
+    }
+  else if (!b->append)
+    {
+      /* Node revisions get rewritten many times.  Reuse the buffer. */
+      txn->staged_size -= staged->len;
+      svn_stringbuf_setempty(staged);
+    }
+
+  svn_stringbuf_appendstr(staged, b->contents);
+  txn->staged_size += b->contents->len;
+
+  /* Large transactions continue in their directory on disk. */
+  if (txn->staged_size > ffd->txn_staging_size)
+    SVN_ERR(spill_staged_txn(txn, pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* If transaction TXN_ID in FS is being staged in memory, set *STAGED to
+   TRUE and replace the contents of the staged file at PATH with CONTENTS,
+   or append CONTENTS to it if APPEND is set.  Remove the file if CONTENTS
+   is NULL.  Otherwise, set *STAGED to FALSE and leave it to the caller to
+   update the file on disk.  Perform temporary allocations in POOL. */
+static svn_error_t *
+stage_txn_file(svn_boolean_t *staged,
+               svn_fs_t *fs,
+               const svn_fs_fs__id_part_t *txn_id,
+               const char *path,
+               const svn_stringbuf_t *contents,
+               svn_boolean_t append,
+               apr_pool_t *pool)
+{
+  struct stage_txn_file_baton b;
+
+  b.staged = staged;
+  b.txn_id = *txn_id;
+  b.path = path;
+  b.contents = contents;
+  b.append = append;
+
+  return with_txnlist_lock(fs, stage_txn_file_body, &b, pool);
+}
+
+/* A structure used by svn_fs_fs__read_staged_txn_file() and
+   read_staged_txn_file_body(), which see. */
+struct read_staged_txn_file_baton
+{
+  svn_boolean_t *staged;
+  svn_stringbuf_t **contents;
+  svn_fs_fs__id_part_t txn_id;
+  const char *path;
+};
+
+/* Callback used in the implementation of
+   svn_fs_fs__read_staged_txn_file(). */
+static svn_error_t *
+read_staged_txn_file_body(svn_fs_t *fs, const void *baton, apr_pool_t *pool)
+{
+  const struct read_staged_txn_file_baton *b = baton;
+  fs_fs_shared_txn_data_t *txn = get_shared_txn(fs, &b->txn_id, FALSE);
+
+  *b->staged = txn && txn->staged_files;
+  if (*b->staged)
+    {
+      svn_stringbuf_t *staged = svn_hash_gets(txn->staged_files, b->path);
+      *b->contents = staged ? svn_stringbuf_dup(staged, pool) : NULL;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_fs_fs__read_staged_txn_file(svn_boolean_t *staged,
+                                svn_stringbuf_t **contents,
+                                svn_fs_t *fs,
+                                const svn_fs_fs__id_part_t *txn_id,
+                                const char *path,
+                                apr_pool_t *result_pool)
+{
+  struct read_staged_txn_file_baton b;
+
+  b.staged = staged;
+  b.contents = contents;
+  b.txn_id = *txn_id;
+  b.path = path;
+
+  return with_txnlist_lock(fs, read_staged_txn_file_body, &b, result_pool);
+}
+
+/* Callback used in the implementation of svn_fs_fs__flush_txn(). */
+static svn_error_t *
+flush_txn_body(svn_fs_t *fs, const void *baton, apr_pool_t *pool)
+{
+  const svn_fs_fs__id_part_t *txn_id = baton;
+  fs_fs_shared_txn_data_t *txn = get_shared_txn(fs, txn_id, FALSE);
+
+  if (txn && txn->staged_files)
+    SVN_ERR(spill_staged_txn(txn, pool));
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_fs_fs__flush_txn(svn_fs_txn_t *txn,
+                     apr_pool_t *scratch_pool)
+{
+  return with_txnlist_lock(txn->fs, flush_txn_body,
+                           svn_fs_fs__txn_get_id(txn), scratch_pool);
+}
 
 
 svn_error_t *
@@ -507,6 +736,9 @@ svn_fs_fs__put_node_revision(svn_fs_t *fs,
 {
   fs_fs_data_t *ffd = fs->fsap_data;
   apr_file_t *noderev_file;
+  const char *path;
+  svn_stringbuf_t *contents;
+  svn_boolean_t staged;
 
   noderev->is_fresh_txn_root = fresh_txn_root;
 
@@ -515,48 +747,51 @@ svn_fs_fs__put_node_revision(svn_fs_t *fs,
                              _("Attempted to write to non-transaction '%s'"),
                              svn_fs_fs__id_unparse(id, pool)->data);
 
-  SVN_ERR(svn_io_file_open(&noderev_file,
-                           svn_fs_fs__path_txn_node_rev(fs, id, pool),
-                           APR_WRITE | APR_CREATE | APR_TRUNCATE
-                           | APR_BUFFERED, APR_OS_DEFAULT, pool));
-
-  SVN_ERR(svn_fs_fs__write_noderev(svn_stream_from_aprfile2(noderev_file, TRUE,
-                                                            pool),
+  contents = svn_stringbuf_create_empty(pool);
+  SVN_ERR(svn_fs_fs__write_noderev(svn_stream_from_stringbuf(contents, pool),
                                    noderev, ffd->format,
                                    svn_fs_fs__fs_supports_mergeinfo(fs),
                                    pool));
 
-  SVN_ERR(svn_io_file_close(noderev_file, pool));
+  path = svn_fs_fs__path_txn_node_rev(fs, id, pool);
+  SVN_ERR(stage_txn_file(&staged, fs, svn_fs_fs__id_txn_id(id), path,
+                         contents, FALSE, pool));
+  if (staged)
+    return SVN_NO_ERROR;
 
-  return SVN_NO_ERROR;
+  SVN_ERR(svn_io_file_open(&noderev_file, path,
+                           APR_WRITE | APR_CREATE | APR_TRUNCATE
+                           | APR_BUFFERED, APR_OS_DEFAULT, pool));
+  SVN_ERR(svn_io_file_write_full(noderev_file, contents->data, contents->len,
+                                 NULL, pool));
+
+  return svn_error_trace(svn_io_file_close(noderev_file, pool));
 }
 
-/* For the in-transaction NODEREV within FS, write the sha1->rep mapping
- * file in the respective transaction, if rep sharing has been enabled etc.
+/* For the in-transaction representation REP within FS, write the
+ * sha1->rep mapping file in the respective transaction, if rep sharing
+ * has been enabled etc.  MUTABLE_REP_TRUNCATED is passed through to
+ * svn_fs_fs__unparse_representation.
  * Use SCATCH_POOL for temporary allocations.
  */
 static svn_error_t *
-store_sha1_rep_mapping(svn_fs_t *fs,
-                       node_revision_t *noderev,
-                       apr_pool_t *scratch_pool)
+store_sha1_rep_mapping_for_rep(svn_fs_t *fs,
+                               representation_t *rep,
+                               svn_boolean_t mutable_rep_truncated,
+                               apr_pool_t *scratch_pool)
 {
   fs_fs_data_t *ffd = fs->fsap_data;
 
-  /* if rep sharing has been enabled and the noderev has a data rep and
-   * its SHA-1 is known, store the rep struct under its SHA1. */
-  if (   ffd->rep_sharing_allowed
-      && noderev->data_rep
-      && noderev->data_rep->has_sha1)
+  /* if rep sharing has been enabled and the rep's SHA-1 is known,
+   * store the rep struct under its SHA1. */
+  if (ffd->rep_sharing_allowed && rep->has_sha1)
     {
       apr_file_t *rep_file;
-      const char *file_name = path_txn_sha1(fs,
-                                            &noderev->data_rep->txn_id,
-                                            noderev->data_rep->sha1_digest,
-                                            scratch_pool);
+      const char *file_name = path_txn_sha1(fs, &rep->txn_id,
+                                            rep->sha1_digest, scratch_pool);
       svn_stringbuf_t *rep_string
-        = svn_fs_fs__unparse_representation(noderev->data_rep,
-                                            ffd->format,
-                                            (noderev->kind == svn_node_dir),
+        = svn_fs_fs__unparse_representation(rep, ffd->format,
+                                            mutable_rep_truncated,
                                             scratch_pool, scratch_pool);
       SVN_ERR(svn_io_file_open(&rep_file, file_name,
                                APR_WRITE | APR_CREATE | APR_TRUNCATE
@@ -571,6 +806,23 @@ store_sha1_rep_mapping(svn_fs_t *fs,
   return SVN_NO_ERROR;
 }
 
+/* For the in-transaction NODEREV within FS, write the sha1->rep mapping
+ * file in the respective transaction, if rep sharing has been enabled etc.
+ * Use SCATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+store_sha1_rep_mapping(svn_fs_t *fs,
+                       node_revision_t *noderev,
+                       apr_pool_t *scratch_pool)
+{
+  if (noderev->data_rep)
+    SVN_ERR(store_sha1_rep_mapping_for_rep(fs, noderev->data_rep,
+                                           noderev->kind == svn_node_dir,
+                                           scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
 static svn_error_t *
 unparse_dir_entry(svn_fs_dirent_t *dirent,
                   svn_stream_t *stream,
@@ -674,22 +926,23 @@ path_change_dup(const svn_fs_path_change2_t *source,
   return result;
 }
 
-/* Merge the internal-use-only CHANGE into a hash of public-FS
+/* Merge the internal-use-only CHANGE into a map of public-FS
    svn_fs_path_change2_t CHANGED_PATHS, collapsing multiple changes into a
    single summarical (is that real word?) change per path.  DELETIONS is
-   also a path->svn_fs_path_change2_t hash and contains all the deletions
-   that got turned into a replacement. */
+   also a path->svn_fs_path_change2_t map and contains all the deletions
+   that got turned into a replacement.  Allocate new changes in POOL. */
 static svn_error_t *
-fold_change(apr_hash_t *changed_paths,
-            apr_hash_t *deletions,
-            const change_t *change)
+fold_change(svn_string_map__t *changed_paths,
+            svn_string_map__t *deletions,
+            const change_t *change,
+            apr_pool_t *pool)
 {
-  apr_pool_t *pool = apr_hash_pool_get(changed_paths);
   svn_fs_path_change2_t *old_change, *new_change;
   const svn_string_t *path = &change->path;
   const svn_fs_path_change2_t *info = &change->info;
 
-  if ((old_change = apr_hash_get(changed_paths, path->data, path->len)))
+  if ((old_change = svn_string_map__get(changed_paths, path->data,
+                                        path->len)))
     {
       /* This path already exists in the hash, so we have to merge
          this change into the already existing one. */
@@ -738,7 +991,7 @@ fold_change(apr_hash_t *changed_paths,
         case svn_fs_path_change_reset:
           /* A reset here will simply remove the path change from the
              hash. */
-          apr_hash_set(changed_paths, path->data, path->len, NULL);
+          svn_string_map__set(changed_paths, path->data, path->len, NULL);
           break;
 
         case svn_fs_path_change_delete:
@@ -747,20 +1000,23 @@ fold_change(apr_hash_t *changed_paths,
               /* If the path was introduced in this transaction via an
                  add, and we are deleting it, just remove the path
                  altogether.  (The caller will delete any child paths.) */
-              apr_hash_set(changed_paths, path->data, path->len, NULL);
+              svn_string_map__set(changed_paths, path->data, path->len, NULL);
             }
           else if (old_change->change_kind == svn_fs_path_change_replace)
             {
               /* A deleting a 'replace' restore the original deletion. */
-              new_change = apr_hash_get(deletions, path->data, path->len);
+              new_change = svn_string_map__get(deletions, path->data,
+                                               path->len);
               SVN_ERR_ASSERT(new_change);
-              apr_hash_set(changed_paths, path->data, path->len, new_change);
+              svn_string_map__set(changed_paths, path->data, path->len,
+                                  new_change);
             }
           else
             {
               /* A deletion overrules a previous change (modify). */
               new_change = path_change_dup(info, pool);
-              apr_hash_set(changed_paths, path->data, path->len, new_change);
+              svn_string_map__set(changed_paths, path->data, path->len,
+                                  new_change);
             }
           break;
 
@@ -773,14 +1029,11 @@ fold_change(apr_hash_t *changed_paths,
           new_change = path_change_dup(info, pool);
           new_change->change_kind = svn_fs_path_change_replace;
 
-          apr_hash_set(changed_paths, path->data, path->len, new_change);
+          svn_string_map__set(changed_paths, path->data, path->len,
+                              new_change);
 
-          /* Remember the original change.
-           * Make sure to allocate the hash key in a durable pool. */
-          apr_hash_set(deletions,
-                       apr_pstrmemdup(apr_hash_pool_get(deletions),
-                                      path->data, path->len),
-                       path->len, old_change);
+          /* Remember the original change. */
+          svn_string_map__set(deletions, path->data, path->len, old_change);
           break;
 
         case svn_fs_path_change_modify:
@@ -799,12 +1052,9 @@ fold_change(apr_hash_t *changed_paths,
     }
   else
     {
-      /* Add this path.  The API makes no guarantees that this (new) key
-         will not be retained.  Thus, we copy the key into the target pool
-         to ensure a proper lifetime.  */
-      apr_hash_set(changed_paths,
-                   apr_pstrmemdup(pool, path->data, path->len), path->len,
-                   path_change_dup(info, pool));
+      /* Add this path.  The map copies the key. */
+      svn_string_map__set(changed_paths, path->data, path->len,
+                          path_change_dup(info, pool));
     }
 
   return SVN_NO_ERROR;
@@ -814,12 +1064,15 @@ fold_change(apr_hash_t *changed_paths,
 typedef struct process_changes_baton_t
 {
   /* Folded list of path changes. */
-  apr_hash_t *changed_paths;
+  svn_string_map__t *changed_paths;
 
   /* Path changes that are deletions and have been turned into
      replacements.  If those replacements get deleted again, this
      container contains the record that we have to revert to. */
-  apr_hash_t *deletions;
+  svn_string_map__t *deletions;
+
+  /* Allocate the folded changes in here. */
+  apr_pool_t *pool;
 } process_changes_baton_t;
 
 /* An implementation of svn_fs_fs__change_receiver_t.
@@ -833,7 +1086,8 @@ process_changes(void *baton_p,
 {
   process_changes_baton_t *baton = baton_p;
 
-  SVN_ERR(fold_change(baton->changed_paths, baton->deletions, change));
+  SVN_ERR(fold_change(baton->changed_paths, baton->deletions, change,
+                      baton->pool));
 
   /* Now, if our change was a deletion or replacement, we have to
      blow away any changes thus far on paths that are (or, were)
@@ -846,15 +1100,17 @@ process_changes(void *baton_p,
   if ((change->info.change_kind == svn_fs_path_change_delete)
        || (change->info.change_kind == svn_fs_path_change_replace))
     {
-      apr_hash_index_t *hi;
+      apr_size_t idx = 0;
+      const char *path;
+      apr_size_t klen;
 
       /* a potential child path must contain at least 2 more chars
          (the path separator plus at least one char for the name).
          Also, we should not assume that all paths have been normalized
          i.e. some might have trailing path separators.
       */
-      apr_ssize_t path_len = change->path.len;
-      apr_ssize_t min_child_len = path_len == 0
+      apr_size_t path_len = change->path.len;
+      apr_size_t min_child_len = path_len == 0
                                 ? 1
                                 : change->path.data[path_len-1] == '/'
                                     ? path_len + 1
@@ -864,16 +1120,9 @@ process_changes(void *baton_p,
          The number of changes to process may be >> 1000.
          Therefore, keep the inner loop as tight as possible.
       */
-      for (hi = apr_hash_first(scratch_pool, baton->changed_paths);
-           hi;
-           hi = apr_hash_next(hi))
+      while (svn_string_map__next(&idx, &path, &klen, NULL,
+                                  baton->changed_paths))
         {
-          /* KEY is the path. */
-          const void *path;
-          apr_ssize_t klen;
-          svn_fs_path_change2_t *old_change;
-          apr_hash_this(hi, &path, &klen, (void**)&old_change);
-
           /* If we come across a child of our path, remove it.
              Call svn_fspath__skip_ancestor only if there is a chance that
              this is actually a sub-path.
@@ -885,7 +1134,8 @@ process_changes(void *baton_p,
               child = svn_fspath__skip_ancestor(change->path.data, path);
               if (child && child[0] != '\0')
                 {
-                  apr_hash_set(baton->changed_paths, path, klen, NULL);
+                  svn_string_map__set(baton->changed_paths, path, klen,
+                                      NULL);
                 }
             }
         }
@@ -901,26 +1151,42 @@ svn_fs_fs__txn_changes_fetch(apr_hash_t **changed_paths_p,
                              apr_pool_t *pool)
 {
   apr_file_t *file;
-  apr_hash_t *changed_paths = apr_hash_make(pool);
   apr_pool_t *scratch_pool = svn_pool_create(pool);
   process_changes_baton_t baton;
+  const char *path = path_txn_changes(fs, txn_id, scratch_pool);
+  svn_stringbuf_t *contents;
+  svn_boolean_t staged;
+  svn_stream_t *stream;
 
-  baton.changed_paths = changed_paths;
-  baton.deletions = apr_hash_make(scratch_pool);
+  /* The folded changes and their keys must survive SCRATCH_POOL. */
+  baton.changed_paths = svn_string_map__create(0, pool);
+  baton.deletions = svn_string_map__create(0, scratch_pool);
+  baton.pool = pool;
 
-  SVN_ERR(svn_io_file_open(&file,
-                           path_txn_changes(fs, txn_id, scratch_pool),
-                           APR_READ | APR_BUFFERED, APR_OS_DEFAULT,
-                           scratch_pool));
+  SVN_ERR(svn_fs_fs__read_staged_txn_file(&staged, &contents, fs, txn_id,
+                                          path, scratch_pool));
+  if (staged)
+    {
+      if (!contents)
+        return svn_error_createf(SVN_ERR_FS_CORRUPT, NULL,
+                                 _("No changes staged for transaction '%s'"),
+                                 svn_fs_fs__id_txn_unparse(txn_id, pool));
+
+      stream = svn_stream_from_stringbuf(contents, scratch_pool);
+    }
+  else
+    {
+      SVN_ERR(svn_io_file_open(&file, path, APR_READ | APR_BUFFERED,
+                               APR_OS_DEFAULT, scratch_pool));
+      stream = svn_stream_from_aprfile2(file, TRUE, scratch_pool);
+    }
 
-  SVN_ERR(svn_fs_fs__read_changes_incrementally(
-                                  svn_stream_from_aprfile2(file, TRUE,
-                                                           scratch_pool),
-                                  process_changes, &baton,
-                                  scratch_pool));
+  SVN_ERR(svn_fs_fs__read_changes_incrementally(stream,
+                                                process_changes, &baton,
+                                                scratch_pool));
   svn_pool_destroy(scratch_pool);
 
-  *changed_paths_p = changed_paths;
+  *changed_paths_p = svn_string_map__to_hash(baton.changed_paths, pool);
 
   return SVN_NO_ERROR;
 }
@@ -987,6 +1253,7 @@ create_new_txn_noderev_from_rev(svn_fs_t *fs,
 
   noderev->predecessor_id = noderev->id;
   noderev->predecessor_count++;
+  noderev->skip_id = NULL;
   noderev->copyfrom_path = NULL;
   noderev->copyfrom_rev = SVN_INVALID_REVNUM;
 
@@ -1150,6 +1417,10 @@ svn_fs_fs__create_txn(svn_fs_txn_t **txn_p,
   txn->fsap_data = ftd;
   *txn_p = txn;
 
+  /* Small transactions may be kept in memory until they get committed. */
+  if (ffd->txn_staging_size)
+    SVN_ERR(start_staged_txn(fs, &ftd->txn_id, pool));
+
   /* Create a new root node for this transaction. */
   SVN_ERR(svn_fs_fs__rev_get_root(&root_id, fs, rev, pool, pool));
   SVN_ERR(create_new_txn_noderev_from_rev(fs, &ftd->txn_id, root_id, pool));
@@ -1164,9 +1435,11 @@ svn_fs_fs__create_txn(svn_fs_txn_t **txn_p,
                svn_fs_fs__path_txn_proto_rev_lock(fs, &ftd->txn_id, pool),
                pool));
 
-  /* Create an empty changes file. */
-  SVN_ERR(svn_io_file_create_empty(path_txn_changes(fs, &ftd->txn_id, pool),
-                                   pool));
+  /* Create an empty changes file, unless it is being staged. */
+  if (!ffd->txn_staging_size)
+    SVN_ERR(svn_io_file_create_empty(path_txn_changes(fs, &ftd->txn_id,
+                                                      pool),
+                                     pool));
 
   /* Create the next-ids file. */
   return svn_io_file_create(path_txn_next_ids(fs, &ftd->txn_id, pool),
@@ -1706,11 +1979,9 @@ svn_fs_fs__add_change(svn_fs_t *fs,
   apr_file_t *file;
   svn_fs_path_change2_t *change;
   apr_hash_t *changes = apr_hash_make(pool);
-
-  /* Not using APR_BUFFERED to append change in one atomic write operation. */
-  SVN_ERR(svn_io_file_open(&file, path_txn_changes(fs, txn_id, pool),
-                           APR_APPEND | APR_WRITE | APR_CREATE,
-                           APR_OS_DEFAULT, pool));
+  const char *changes_path = path_txn_changes(fs, txn_id, pool);
+  svn_stringbuf_t *contents = svn_stringbuf_create_empty(pool);
+  svn_boolean_t staged;
 
   change = svn_fs__path_change_create_internal(id, change_kind, pool);
   change->text_mod = text_mod;
@@ -1725,9 +1996,21 @@ svn_fs_fs__add_change(svn_fs_t *fs,
     change->copyfrom_path = apr_pstrdup(pool, copyfrom_path);
 
   svn_hash_sets(changes, path, change);
-  SVN_ERR(svn_fs_fs__write_changes(svn_stream_from_aprfile2(file, TRUE, pool),
+  SVN_ERR(svn_fs_fs__write_changes(svn_stream_from_stringbuf(contents, pool),
                                    fs, changes, FALSE, pool));
 
+  SVN_ERR(stage_txn_file(&staged, fs, txn_id, changes_path, contents, TRUE,
+                         pool));
+  if (staged)
+    return SVN_NO_ERROR;
+
+  /* Not using APR_BUFFERED to append change in one atomic write operation. */
+  SVN_ERR(svn_io_file_open(&file, changes_path,
+                           APR_APPEND | APR_WRITE | APR_CREATE,
+                           APR_OS_DEFAULT, pool));
+  SVN_ERR(svn_io_file_write_full(file, contents->data, contents->len, NULL,
+                                 pool));
+
   return svn_io_file_close(file, pool);
 }
 
@@ -1902,6 +2185,20 @@ fnv1a_checksum_finalize(apr_uint32_t *digest,
   return SVN_NO_ERROR;
 }
 
+/* Checksum kinds mask for the MD5 and SHA1 sums of representations. */
+#define MD5_AND_SHA1 (  SVN_CHECKSUM__KIND_FLAG(svn_checksum_md5) \
+                      | SVN_CHECKSUM__KIND_FLAG(svn_checksum_sha1))
+
+/* Content-defined chunking of large file reps.  A chunk ends where the
+   bits in CHUNK_MASK of a gear hash over the last 32 bytes are all 0,
+   but chunks are at least CHUNK_MIN_SIZE and at most CHUNK_MAX_SIZE
+   bytes long.  Because boundaries only depend on the local content,
+   inserting data into a file only changes the chunks around the edit.
+   This gives an average chunk size of about 80 kBytes. */
+#define CHUNK_MIN_SIZE 0x4000
+#define CHUNK_MAX_SIZE SVN_FS_FS__CHUNKED_REP_MIN_THRESHOLD
+#define CHUNK_MASK 0xffff0000
+
 /* This baton is used by the representation writing streams.  It keeps
    track of the checksum information as well as the total size of the
    representation so far. */
@@ -1935,12 +2232,31 @@ struct rep_write_baton
      writing to it. */
   void *lockcookie;
 
-  svn_checksum_ctx_t *md5_checksum_ctx;
-  svn_checksum_ctx_t *sha1_checksum_ctx;
+  /* MD5 and SHA1 of the fulltext, calculated in a single pass. */
+  svn_checksum__multi_ctx_t *checksum_ctx;
 
   /* calculate a modified FNV-1a checksum of the on-disk representation */
   svn_checksum_ctx_t *fnv1a_checksum_ctx;
 
+  /* Contents written while we don't know yet whether this will become a
+     chunked rep.  NULL, once we are writing a delta or chunks. */
+  svn_stringbuf_t *pending;
+
+  /* If not NULL, we are writing a chunked rep and these are the chunk
+     reps (representation_t *) written so far. */
+  apr_array_header_t *chunks;
+
+  /* Maps the SHA1 of each chunk written by us to its representation_t *,
+     such that repeated chunks can be shared. */
+  apr_hash_t *chunk_reps;
+
+  /* Contents of the current, incomplete chunk. */
+  svn_stringbuf_t *chunk;
+
+  /* Rolling gear hash over the current chunk and its lookup table. */
+  apr_uint32_t gear_hash;
+  apr_uint32_t gear[256];
+
   /* Local / scratch pool, available for temporary allocations. */
   apr_pool_t *scratch_pool;
 
@@ -1948,6 +2264,37 @@ struct rep_write_baton
   apr_pool_t *result_pool;
 };
 
+/* Number of bytes at the start of new file contents used to compare the
+   delta sizes for different delta base candidates. */
+#define DELTA_BASE_SAMPLE_SIZE 0x10000
+
+static svn_error_t *
+begin_delta_rep(struct rep_write_baton *b,
+                const svn_stringbuf_t *sample);
+
+static svn_error_t *
+begin_chunked_rep(struct rep_write_baton *b);
+
+static svn_error_t *
+write_chunked(struct rep_write_baton *b,
+              const char *data,
+              apr_size_t len);
+
+/* Switch B from collecting pending data to writing a delta and write
+   all data collected so far. */
+static svn_error_t *
+end_pending(struct rep_write_baton *b)
+{
+  svn_stringbuf_t *pending = b->pending;
+  apr_size_t len = pending->len;
+
+  b->pending = NULL;
+  SVN_ERR(begin_delta_rep(b, pending));
+
+  return svn_error_trace(svn_stream_write(b->delta_stream, pending->data,
+                                          &len));
+}
+
 /* Handler for the write method of the representation writable stream.
    BATON is a rep_write_baton, DATA is the data to write, and *LEN is
    the length of this data. */
@@ -1957,11 +2304,32 @@ rep_write_contents(void *baton,
                    apr_size_t *len)
 {
   struct rep_write_baton *b = baton;
+  fs_fs_data_t *ffd = b->fs->fsap_data;
 
-  SVN_ERR(svn_checksum_update(b->md5_checksum_ctx, data, *len));
-  SVN_ERR(svn_checksum_update(b->sha1_checksum_ctx, data, *len));
+  SVN_ERR(svn_checksum__multi_update(b->checksum_ctx, data, *len));
   b->rep_size += *len;
 
+  /* Collect data until we know whether it is large enough to be chunked
+     and, if requested, have a sample to select the delta base with. */
+  if (b->pending)
+    {
+      svn_stringbuf_appendbytes(b->pending, data, *len);
+      if (ffd->chunked_rep_threshold > 0)
+        {
+          if ((apr_int64_t)b->pending->len >= ffd->chunked_rep_threshold)
+            SVN_ERR(begin_chunked_rep(b));
+        }
+      else if (b->pending->len >= DELTA_BASE_SAMPLE_SIZE)
+        {
+          SVN_ERR(end_pending(b));
+        }
+
+      return SVN_NO_ERROR;
+    }
+
+  if (b->chunks)
+    return svn_error_trace(write_chunked(b, data, *len));
+
   /* If we are writing a delta, use that stream. */
   if (b->delta_stream)
     return svn_stream_write(b->delta_stream, data, len);
@@ -2005,6 +2373,68 @@ shards_spanned(int *spanned,
   return SVN_NO_ERROR;
 }
 
+/* Reset *REP to NULL if it is not suitable as a delta base for new
+   contents in FS.  PROPS tells whether *REP contains properties.
+   Perform temporary allocations in POOL. */
+static svn_error_t *
+check_delta_base(representation_t **rep,
+                 svn_fs_t *fs,
+                 svn_boolean_t props,
+                 apr_pool_t *pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  int chain_length = 0;
+  int shard_count = 0;
+  svn_filesize_t rep_size;
+
+  if (!*rep)
+    return SVN_NO_ERROR;
+
+  /* Very short rep bases are simply not worth it as we are unlikely
+   * to re-coup the deltification space overhead of 20+ bytes. */
+  rep_size = (*rep)->expanded_size;
+  if (rep_size < 64)
+    {
+      *rep = NULL;
+      return SVN_NO_ERROR;
+    }
+
+  /* Chunked reps are no suitable base.  Their chunks are shared
+   * instead. */
+  if (!props)
+    {
+      apr_array_header_t *chunks;
+      SVN_ERR(svn_fs_fs__get_rep_chunks(&chunks, fs, *rep, pool, pool));
+      if (chunks)
+        {
+          *rep = NULL;
+          return SVN_NO_ERROR;
+        }
+    }
+
+  /* Check whether the length of the deltification chain is acceptable.
+   * Otherwise, shared reps may form a non-skipping delta chain in
+   * extreme cases. */
+  SVN_ERR(svn_fs_fs__rep_chain_length(&chain_length, &shard_count,
+                                      *rep, fs, pool));
+
+  /* Some reasonable limit, depending on how acceptable longer linear
+   * chains are in this repo.  Also, allow for some minimal chain. */
+  if (chain_length >= 2 * (int)ffd->max_linear_deltification + 2)
+    *rep = NULL;
+  else
+    /* To make it worth opening additional shards / pack files, we
+     * require that the reps have a certain minimal size.  To deltify
+     * against a rep in different shard, the lower limit is 512 bytes
+     * and doubles with every extra shard to visit along the delta
+     * chain. */
+    if (   shard_count > 1
+        && ((svn_filesize_t)128 << shard_count) >= rep_size)
+      *rep = NULL;
+
+  return SVN_NO_ERROR;
+}
+
 /* Given a node-revision NODEREV in filesystem FS, return the
    representation in *REP to use as the base for a text representation
    delta if PROPS is FALSE.  If PROPS has been set, a suitable props
@@ -2026,7 +2456,6 @@ choose_delta_base(representation_t **rep,
   int walk;
   node_revision_t *base;
   fs_fs_data_t *ffd = fs->fsap_data;
-  apr_pool_t *iterpool;
 
   /* If we have no predecessors, or that one is empty, then use the empty
    * stream as a base. */
@@ -2071,59 +2500,16 @@ choose_delta_base(representation_t **rep,
   /* Walk back a number of predecessors equal to the difference
      between count and the original predecessor count.  (For example,
      if noderev has ten predecessors and we want the eighth file rev,
-     walk back two predecessors.) */
-  base = noderev;
-  iterpool = svn_pool_create(pool);
-  while ((count++) < noderev->predecessor_count)
-    {
-      svn_pool_clear(iterpool);
-      SVN_ERR(svn_fs_fs__get_node_revision(&base, fs,
-                                           base->predecessor_id, pool,
-                                           iterpool));
-    }
-  svn_pool_destroy(iterpool);
+     walk back two predecessors.)  Skip-list pointers shorten that walk
+     where available. */
+  SVN_ERR(svn_fs_fs__get_ancestor(&base, fs, noderev, count, pool, pool));
 
-  /* return a suitable base representation */
+  /* return a suitable base representation.  If we encountered a shared
+   * rep, its parent chain may be different from the node-rev parent
+   * chain. */
   *rep = props ? base->prop_rep : base->data_rep;
 
-  /* if we encountered a shared rep, its parent chain may be different
-   * from the node-rev parent chain. */
-  if (*rep)
-    {
-      int chain_length = 0;
-      int shard_count = 0;
-
-      /* Very short rep bases are simply not worth it as we are unlikely
-       * to re-coup the deltification space overhead of 20+ bytes. */
-      svn_filesize_t rep_size = (*rep)->expanded_size;
-      if (rep_size < 64)
-        {
-          *rep = NULL;
-          return SVN_NO_ERROR;
-        }
-
-      /* Check whether the length of the deltification chain is acceptable.
-       * Otherwise, shared reps may form a non-skipping delta chain in
-       * extreme cases. */
-      SVN_ERR(svn_fs_fs__rep_chain_length(&chain_length, &shard_count,
-                                          *rep, fs, pool));
-
-      /* Some reasonable limit, depending on how acceptable longer linear
-       * chains are in this repo.  Also, allow for some minimal chain. */
-      if (chain_length >= 2 * (int)ffd->max_linear_deltification + 2)
-        *rep = NULL;
-      else
-        /* To make it worth opening additional shards / pack files, we
-         * require that the reps have a certain minimal size.  To deltify
-         * against a rep in different shard, the lower limit is 512 bytes
-         * and doubles with every extra shard to visit along the delta
-         * chain. */
-        if (   shard_count > 1
-            && ((svn_filesize_t)128 << shard_count) >= rep_size)
-          *rep = NULL;
-    }
-
-  return SVN_NO_ERROR;
+  return svn_error_trace(check_delta_base(rep, fs, props, pool));
 }
 
 /* Something went wrong and the pool for the rep write is being
@@ -2169,7 +2555,20 @@ txdelta_to_svndiff(svn_txdelta_window_handler_t *handler,
   fs_fs_data_t *ffd = fs->fsap_data;
   int svndiff_version;
 
-  if (ffd->delta_compression_type == compression_type_lz4)
+  if (ffd->delta_compression_type == compression_type_zstd)
+    {
+      /* svndiff4 carries large windows as well. */
+      SVN_ERR_ASSERT_NO_RETURN(ffd->zstd_compression);
+      svndiff_version = 4;
+    }
+  else if (ffd->large_delta_windows)
+    {
+      /* Only svndiff3 can carry large windows.  It always uses zlib. */
+      SVN_ERR_ASSERT_NO_RETURN(ffd->format
+                               >= SVN_FS_FS__MIN_LARGE_DELTA_WINDOWS_FORMAT);
+      svndiff_version = 3;
+    }
+  else if (ffd->delta_compression_type == compression_type_lz4)
     {
       SVN_ERR_ASSERT_NO_RETURN(ffd->format >= SVN_FS_FS__MIN_SVNDIFF2_FORMAT);
       svndiff_version = 2;
@@ -2188,51 +2587,179 @@ txdelta_to_svndiff(svn_txdelta_window_handler_t *handler,
                           ffd->delta_compression_level, pool);
 }
 
-/* Get a rep_write_baton and store it in *WB_P for the representation
-   indicated by NODEREV in filesystem FS.  Perform allocations in
-   POOL.  Only appropriate for file contents, not for props or
-   directory contents. */
-static svn_error_t *
-rep_write_get_baton(struct rep_write_baton **wb_p,
-                    svn_fs_t *fs,
-                    node_revision_t *noderev,
-                    apr_pool_t *pool)
+/* Return a target push stream for SOURCE in FS that sends its windows to
+   HANDLER with HANDLER_BATON, using the window scheme selected for FS.
+   Allocate the result in POOL.  See svn_txdelta_target_push. */
+static svn_stream_t *
+delta_target_push(svn_txdelta_window_handler_t handler,
+                  void *handler_baton,
+                  svn_stream_t *source,
+                  svn_fs_t *fs,
+                  apr_pool_t *pool)
 {
-  struct rep_write_baton *b;
-  apr_file_t *file;
-  representation_t *base_rep;
-  svn_stream_t *source;
+  fs_fs_data_t *ffd = fs->fsap_data;
+
+  if (ffd->large_delta_windows)
+    return svn_txdelta__target_push_large(handler, handler_baton, source,
+                                          pool);
+
+  return svn_txdelta_target_push(handler, handler_baton, source, pool);
+}
+
+/* Number of immediate predecessors to consider as delta base candidates
+   besides the one selected by choose_delta_base(). */
+#define DELTA_BASE_PREDECESSORS 3
+
+/* Set *SIZE to the size of the svndiff data that FS would write for the
+   first DELTA_BASE_SAMPLE_SIZE bytes of SAMPLE when deltified against
+   the start of BASE.  BASE may be NULL for self-compressed data.  Perform
+   temporary allocations in POOL. */
+static svn_error_t *
+sample_delta_size(apr_size_t *size,
+                  svn_fs_t *fs,
+                  representation_t *base,
+                  const svn_stringbuf_t *sample,
+                  apr_pool_t *pool)
+{
+  apr_size_t sample_len = MIN(sample->len, DELTA_BASE_SAMPLE_SIZE);
+  svn_stringbuf_t *base_sample = svn_stringbuf_create_ensure(sample_len,
+                                                             pool);
+  svn_stringbuf_t *svndiff = svn_stringbuf_create_empty(pool);
   svn_txdelta_window_handler_t wh;
   void *whb;
-  svn_fs_fs__rep_header_t header = { 0 };
+  svn_stream_t *stream;
+  apr_size_t len = sample_len;
 
-  b = apr_pcalloc(pool, sizeof(*b));
+  if (base)
+    {
+      SVN_ERR(svn_fs_fs__get_contents(&stream, fs, base, FALSE, pool));
+      SVN_ERR(svn_stream_read_full(stream, base_sample->data, &len));
+      base_sample->len = len;
+      base_sample->data[len] = '\0';
+      SVN_ERR(svn_stream_close(stream));
+    }
 
-  b->sha1_checksum_ctx = svn_checksum_ctx_create(svn_checksum_sha1, pool);
-  b->md5_checksum_ctx = svn_checksum_ctx_create(svn_checksum_md5, pool);
+  txdelta_to_svndiff(&wh, &whb, svn_stream_from_stringbuf(svndiff, pool), fs,
+                     pool);
+  stream = delta_target_push(wh, whb,
+                             svn_stream_from_stringbuf(base_sample, pool),
+                             fs, pool);
 
-  b->fs = fs;
-  b->result_pool = pool;
-  b->scratch_pool = svn_pool_create(pool);
-  b->rep_size = 0;
-  b->noderev = noderev;
+  len = sample_len;
+  SVN_ERR(svn_stream_write(stream, sample->data, &len));
+  SVN_ERR(svn_stream_close(stream));
 
-  /* Open the prototype rev file and seek to its end. */
-  SVN_ERR(get_writable_proto_rev(&file, &b->lockcookie,
-                                 fs, svn_fs_fs__id_txn_id(noderev->id),
-                                 b->scratch_pool));
+  *size = svndiff->len;
 
-  b->file = file;
-  b->rep_stream = svn_stream_from_aprfile2(file, TRUE, b->scratch_pool);
-  if (svn_fs_fs__use_log_addressing(fs))
-    b->rep_stream = fnv1a_wrap_stream(&b->fnv1a_checksum_ctx, b->rep_stream,
-                                      b->scratch_pool);
+  return SVN_NO_ERROR;
+}
 
-  SVN_ERR(svn_io_file_get_offset(&b->rep_offset, file, b->scratch_pool));
+/* Given the delta base *REP selected by choose_delta_base() for the new
+   contents of NODEREV in FS, try the immediate predecessors and an empty
+   base as well.  Set *REP to the one that gives the smallest delta for
+   SAMPLE, the first bytes of the new contents.  Perform temporary
+   allocations in POOL. */
+static svn_error_t *
+pick_sampled_delta_base(representation_t **rep,
+                        svn_fs_t *fs,
+                        node_revision_t *noderev,
+                        const svn_stringbuf_t *sample,
+                        apr_pool_t *pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  apr_array_header_t *candidates
+    = apr_array_make(pool, DELTA_BASE_PREDECESSORS + 2,
+                     sizeof(representation_t *));
+  node_revision_t *pred = noderev;
+  representation_t *best = *rep;
+  apr_size_t best_size = 0;
+  int i, k;
+
+  /* The default goes first, such that ties go to it. */
+  APR_ARRAY_PUSH(candidates, representation_t *) = *rep;
+
+  /* The rules of choose_delta_base() still apply to all predecessors.
+     Copies and renames are covered, too, because their predecessor is
+     the source node. */
+  for (i = 0;
+          i < DELTA_BASE_PREDECESSORS
+       && i < ffd->max_deltification_walk
+       && pred->predecessor_count;
+       ++i)
+    {
+      representation_t *candidate;
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_fs_fs__get_node_revision(&pred, fs, pred->predecessor_id,
+                                           pool, iterpool));
+
+      candidate = pred->data_rep;
+      SVN_ERR(check_delta_base(&candidate, fs, FALSE, iterpool));
+      if (candidate)
+        APR_ARRAY_PUSH(candidates, representation_t *) = candidate;
+    }
+
+  /* Self-compression might be best, e.g. after a complete rewrite. */
+  APR_ARRAY_PUSH(candidates, representation_t *) = NULL;
+
+  for (i = 0; i < candidates->nelts; ++i)
+    {
+      representation_t *candidate
+        = APR_ARRAY_IDX(candidates, i, representation_t *);
+      apr_size_t size;
+
+      /* Predecessors often share their reps.  Try each one only once. */
+      for (k = 0; k < i; ++k)
+        {
+          representation_t *other
+            = APR_ARRAY_IDX(candidates, k, representation_t *);
+          if (candidate == other
+              || (   candidate && other
+                  && candidate->revision == other->revision
+                  && candidate->item_index == other->item_index))
+            break;
+        }
+
+      if (k < i)
+        continue;
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(sample_delta_size(&size, fs, candidate, sample, iterpool));
+      if (i == 0 || size < best_size)
+        {
+          best = candidate;
+          best_size = size;
+        }
+    }
+
+  svn_pool_destroy(iterpool);
+  *rep = best;
+
+  return SVN_NO_ERROR;
+}
+
+/* Write the rep header for a delta rep at the current position in B's
+   proto-rev file and prepare B->DELTA_STREAM to receive the contents.
+   If not NULL, SAMPLE is the start of the contents. */
+static svn_error_t *
+begin_delta_rep(struct rep_write_baton *b,
+                const svn_stringbuf_t *sample)
+{
+  fs_fs_data_t *ffd = b->fs->fsap_data;
+  representation_t *base_rep;
+  svn_stream_t *source;
+  svn_txdelta_window_handler_t wh;
+  void *whb;
+  svn_fs_fs__rep_header_t header = { 0 };
 
   /* Get the base for this delta. */
-  SVN_ERR(choose_delta_base(&base_rep, fs, noderev, FALSE, b->scratch_pool));
-  SVN_ERR(svn_fs_fs__get_contents(&source, fs, base_rep, TRUE,
+  SVN_ERR(choose_delta_base(&base_rep, b->fs, b->noderev, FALSE,
+                            b->scratch_pool));
+  if (ffd->sample_delta_bases && sample && sample->len)
+    SVN_ERR(pick_sampled_delta_base(&base_rep, b->fs, b->noderev, sample,
+                                    b->scratch_pool));
+  SVN_ERR(svn_fs_fs__get_contents(&source, b->fs, base_rep, TRUE,
                                   b->scratch_pool));
 
   /* Write out the rep header. */
@@ -2251,18 +2778,65 @@ rep_write_get_baton(struct rep_write_baton **wb_p,
                                       b->scratch_pool));
 
   /* Now determine the offset of the actual svndiff data. */
-  SVN_ERR(svn_io_file_get_offset(&b->delta_start, file,
+  SVN_ERR(svn_io_file_get_offset(&b->delta_start, b->file,
+                                 b->scratch_pool));
+
+  /* Prepare to write the svndiff data. */
+  txdelta_to_svndiff(&wh, &whb, b->rep_stream, b->fs, b->result_pool);
+
+  b->delta_stream = delta_target_push(wh, whb, source, b->fs,
+                                      b->scratch_pool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Get a rep_write_baton and store it in *WB_P for the representation
+   indicated by NODEREV in filesystem FS.  Perform allocations in
+   POOL.  Only appropriate for file contents, not for props or
+   directory contents. */
+static svn_error_t *
+rep_write_get_baton(struct rep_write_baton **wb_p,
+                    svn_fs_t *fs,
+                    node_revision_t *noderev,
+                    apr_pool_t *pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  struct rep_write_baton *b;
+  apr_file_t *file;
+
+  b = apr_pcalloc(pool, sizeof(*b));
+
+  b->checksum_ctx = svn_checksum__multi_ctx_create(MD5_AND_SHA1, pool);
+
+  b->fs = fs;
+  b->result_pool = pool;
+  b->scratch_pool = svn_pool_create(pool);
+  b->rep_size = 0;
+  b->noderev = noderev;
+
+  /* Open the prototype rev file and seek to its end. */
+  SVN_ERR(get_writable_proto_rev(&file, &b->lockcookie,
+                                 fs, svn_fs_fs__id_txn_id(noderev->id),
                                  b->scratch_pool));
 
+  b->file = file;
+  b->rep_stream = svn_stream_from_aprfile2(file, TRUE, b->scratch_pool);
+  if (svn_fs_fs__use_log_addressing(fs))
+    b->rep_stream = fnv1a_wrap_stream(&b->fnv1a_checksum_ctx, b->rep_stream,
+                                      b->scratch_pool);
+
+  SVN_ERR(svn_io_file_get_offset(&b->rep_offset, file, b->scratch_pool));
+
   /* Cleanup in case something goes wrong. */
   apr_pool_cleanup_register(b->scratch_pool, b, rep_write_cleanup,
                             apr_pool_cleanup_null);
 
-  /* Prepare to write the svndiff data. */
-  txdelta_to_svndiff(&wh, &whb, b->rep_stream, fs, pool);
-
-  b->delta_stream = svn_txdelta_target_push(wh, whb, source,
-                                            b->scratch_pool);
+  /* Large files may get chunked and the delta base may depend on the
+     contents, so we can't write a header just yet. */
+  if (ffd->chunked_rep_threshold > 0 || ffd->sample_delta_bases)
+    b->pending = svn_stringbuf_create_empty(b->scratch_pool);
+  else
+    SVN_ERR(begin_delta_rep(b, NULL));
 
   *wb_p = b;
 
@@ -2483,30 +3057,197 @@ get_shared_rep(representation_t **old_rep,
   return SVN_NO_ERROR;
 }
 
-/* Copy the hash sum calculation results from MD5_CTX, SHA1_CTX into REP.
- * SHA1 results are only be set if SHA1_CTX is not NULL.
+/* Copy the hash sum calculation results from CTX into REP.
+ * SHA1 results are only be set if CTX calculates SHA1 sums.
  * Use POOL for allocations.
  */
 static svn_error_t *
 digests_final(representation_t *rep,
-              const svn_checksum_ctx_t *md5_ctx,
-              const svn_checksum_ctx_t *sha1_ctx,
+              const svn_checksum__multi_ctx_t *ctx,
               apr_pool_t *pool)
 {
   svn_checksum_t *checksum;
 
-  SVN_ERR(svn_checksum_final(&checksum, md5_ctx, pool));
+  SVN_ERR(svn_checksum__multi_final(&checksum, ctx, svn_checksum_md5, pool));
   memcpy(rep->md5_digest, checksum->digest, svn_checksum_size(checksum));
-  rep->has_sha1 = sha1_ctx != NULL;
+  rep->has_sha1
+    = svn_checksum__multi_ctx_get(ctx, svn_checksum_sha1) != NULL;
   if (rep->has_sha1)
     {
-      SVN_ERR(svn_checksum_final(&checksum, sha1_ctx, pool));
+      SVN_ERR(svn_checksum__multi_final(&checksum, ctx, svn_checksum_sha1,
+                                        pool));
       memcpy(rep->sha1_digest, checksum->digest, svn_checksum_size(checksum));
     }
 
   return SVN_NO_ERROR;
 }
 
+/* Write the current chunk of B as a self-delta rep to the proto-rev file,
+   unless an identical rep already exists, and append it to B->CHUNKS. */
+static svn_error_t *
+write_chunk(struct rep_write_baton *b)
+{
+  svn_fs_t *fs = b->fs;
+  apr_pool_t *scratch_pool = svn_pool_create(b->scratch_pool);
+  representation_t *rep = apr_pcalloc(b->result_pool, sizeof(*rep));
+  representation_t *old_rep;
+  svn_checksum__multi_ctx_t *checksum_ctx;
+  svn_checksum_ctx_t *fnv1a_checksum_ctx = NULL;
+  svn_fs_fs__rep_header_t header = { 0 };
+  svn_stream_t *stream;
+  svn_stream_t *delta_stream;
+  svn_txdelta_window_handler_t wh;
+  void *whb;
+  apr_off_t delta_start;
+  apr_off_t offset;
+  apr_size_t len = b->chunk->len;
+
+  /* Each chunk is an item of its own with its own FNV checksum. */
+  stream = svn_stream_from_aprfile2(b->file, TRUE, scratch_pool);
+  if (svn_fs_fs__use_log_addressing(fs))
+    stream = fnv1a_wrap_stream(&fnv1a_checksum_ctx, stream, scratch_pool);
+
+  header.type = svn_fs_fs__rep_self_delta;
+  SVN_ERR(svn_fs_fs__write_rep_header(&header, stream, scratch_pool));
+  SVN_ERR(svn_io_file_get_offset(&delta_start, b->file, scratch_pool));
+
+  txdelta_to_svndiff(&wh, &whb, stream, fs, scratch_pool);
+  delta_stream = delta_target_push(wh, whb, svn_stream_empty(scratch_pool),
+                                   fs, scratch_pool);
+  SVN_ERR(svn_stream_write(delta_stream, b->chunk->data, &len));
+  SVN_ERR(svn_stream_close(delta_stream));
+
+  SVN_ERR(svn_io_file_get_offset(&offset, b->file, scratch_pool));
+  rep->size = offset - delta_start;
+  rep->expanded_size = b->chunk->len;
+  rep->txn_id = *svn_fs_fs__id_txn_id(b->noderev->id);
+  rep->revision = SVN_INVALID_REVNUM;
+
+  checksum_ctx = svn_checksum__multi_ctx_create(MD5_AND_SHA1, scratch_pool);
+  SVN_ERR(svn_checksum__multi_update(checksum_ctx, b->chunk->data,
+                                     b->chunk->len));
+  SVN_ERR(digests_final(rep, checksum_ctx, b->result_pool));
+
+  /* Share repeated and already committed chunks.  Shared chunks may have
+     been written by us and the comparison will read them through a
+     different file handle. */
+  SVN_ERR(svn_io_file_flush(b->file, scratch_pool));
+  SVN_ERR(get_shared_rep(&old_rep, fs, rep, b->file, b->rep_offset,
+                         b->chunk_reps, b->result_pool, scratch_pool));
+
+  if (old_rep)
+    {
+      /* We need to erase from the protorev the data we just wrote. */
+      SVN_ERR(svn_io_file_trunc(b->file, b->rep_offset, scratch_pool));
+      rep = old_rep;
+    }
+  else
+    {
+      /* Write out our cosmetic end marker. */
+      SVN_ERR(svn_stream_puts(stream, "ENDREP\n"));
+      SVN_ERR(allocate_item_index(&rep->item_index, fs, &rep->txn_id,
+                                  b->rep_offset, scratch_pool));
+
+      SVN_ERR(svn_io_file_get_offset(&offset, b->file, scratch_pool));
+      if (svn_fs_fs__use_log_addressing(fs))
+        {
+          svn_fs_fs__p2l_entry_t entry;
+
+          entry.offset = b->rep_offset;
+          entry.size = offset - b->rep_offset;
+          entry.type = SVN_FS_FS__ITEM_TYPE_FILE_REP;
+          entry.item.revision = SVN_INVALID_REVNUM;
+          entry.item.number = rep->item_index;
+          SVN_ERR(fnv1a_checksum_finalize(&entry.fnv1_checksum,
+                                          fnv1a_checksum_ctx,
+                                          scratch_pool));
+
+          SVN_ERR(store_p2l_index_entry(fs, &rep->txn_id, &entry,
+                                        scratch_pool));
+        }
+
+      /* The chunk is now a proper item that must not be removed by
+         rep_write_cleanup. */
+      b->rep_offset = offset;
+
+      SVN_ERR(store_sha1_rep_mapping_for_rep(fs, rep, FALSE, scratch_pool));
+      apr_hash_set(b->chunk_reps, rep->sha1_digest, APR_SHA1_DIGESTSIZE,
+                   rep);
+    }
+
+  APR_ARRAY_PUSH(b->chunks, representation_t *) = rep;
+  svn_stringbuf_setempty(b->chunk);
+  b->gear_hash = 0;
+  svn_pool_destroy(scratch_pool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Split the LEN bytes of DATA into content-defined chunks for B and write
+   every completed chunk.  Keep the rest in B->CHUNK. */
+static svn_error_t *
+write_chunked(struct rep_write_baton *b,
+              const char *data,
+              apr_size_t len)
+{
+  while (len)
+    {
+      apr_uint32_t hash = b->gear_hash;
+      apr_size_t chunk_len = b->chunk->len;
+      svn_boolean_t boundary = FALSE;
+      apr_size_t i;
+
+      for (i = 0; i < len && !boundary; ++i)
+        {
+          hash = (hash << 1) + b->gear[(unsigned char)data[i]];
+          ++chunk_len;
+          boundary =    chunk_len >= CHUNK_MAX_SIZE
+                     || (chunk_len >= CHUNK_MIN_SIZE
+                         && (hash & CHUNK_MASK) == 0);
+        }
+
+      svn_stringbuf_appendbytes(b->chunk, data, i);
+      b->gear_hash = hash;
+      data += i;
+      len -= i;
+
+      if (boundary)
+        SVN_ERR(write_chunk(b));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Switch B from collecting pending data to writing a chunked rep and
+   chunk all data collected so far. */
+static svn_error_t *
+begin_chunked_rep(struct rep_write_baton *b)
+{
+  svn_stringbuf_t *pending = b->pending;
+  apr_uint32_t seed = 0x9e3779b9;
+  int i;
+
+  b->pending = NULL;
+  b->chunks = apr_array_make(b->result_pool, 16,
+                             sizeof(representation_t *));
+  b->chunk_reps = apr_hash_make(b->scratch_pool);
+  b->chunk = svn_stringbuf_create_ensure(CHUNK_MAX_SIZE, b->scratch_pool);
+  b->gear_hash = 0;
+
+  /* The table must never change or equal contents written by different
+     versions would not produce the same chunks anymore.  Use a simple
+     xorshift sequence to fill it. */
+  for (i = 0; i < 256; ++i)
+    {
+      seed ^= seed << 13;
+      seed ^= seed >> 17;
+      seed ^= seed << 5;
+      b->gear[i] = seed;
+    }
+
+  return svn_error_trace(write_chunked(b, pending->data, pending->len));
+}
+
 /* Close handler for the representation write stream.  BATON is a
    rep_write_baton.  Writes out a new node-rev that correctly
    references the representation we just finished writing. */
@@ -2520,6 +3261,32 @@ rep_write_contents_close(void *baton)
 
   rep = apr_pcalloc(b->result_pool, sizeof(*rep));
 
+  /* Too small for chunking?  Then write it as a normal delta. */
+  if (b->pending)
+    SVN_ERR(end_pending(b));
+
+  /* Finish the chunks and write the list of them as the actual rep. */
+  if (b->chunks)
+    {
+      fs_fs_data_t *ffd = b->fs->fsap_data;
+      svn_fs_fs__rep_header_t header = { 0 };
+
+      if (b->chunk->len)
+        SVN_ERR(write_chunk(b));
+
+      header.type = svn_fs_fs__rep_chunked;
+      SVN_ERR(svn_fs_fs__write_rep_header(&header, b->rep_stream,
+                                          b->scratch_pool));
+      SVN_ERR(svn_io_file_get_offset(&b->delta_start, b->file,
+                                     b->scratch_pool));
+      SVN_ERR(svn_fs_fs__write_chunk_list(b->rep_stream, b->chunks,
+                                          ffd->format, b->scratch_pool));
+
+      /* Comparing with existing reps will read our chunks through
+         different file handles. */
+      SVN_ERR(svn_io_file_flush(b->file, b->scratch_pool));
+    }
+
   /* Close our delta stream so the last bits of svndiff are written
      out. */
   if (b->delta_stream)
@@ -2536,8 +3303,7 @@ rep_write_contents_close(void *baton)
   rep->revision = SVN_INVALID_REVNUM;
 
   /* Finalize the checksum. */
-  SVN_ERR(digests_final(rep, b->md5_checksum_ctx, b->sha1_checksum_ctx,
-                        b->result_pool));
+  SVN_ERR(digests_final(rep, b->checksum_ctx, b->result_pool));
 
   /* Check and see if we already have a representation somewhere that's
      identical to the one we just wrote out. */
@@ -2640,6 +3406,98 @@ svn_fs_fs__set_contents(svn_stream_t **stream,
   return set_representation(stream, fs, noderev, pool);
 }
 
+svn_error_t *
+svn_fs_fs__find_rep_by_sha1(representation_t **rep_p,
+                            svn_fs_t *fs,
+                            const svn_checksum_t *sha1_checksum,
+                            apr_pool_t *result_pool,
+                            apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  representation_t *rep;
+  svn_stream_t *contents;
+  svn_checksum_t *md5_checksum;
+  svn_checksum_t *actual_sha1;
+  svn_error_t *err;
+
+  *rep_p = NULL;
+  if (!ffd->rep_sharing_allowed || sha1_checksum->kind != svn_checksum_sha1)
+    return SVN_NO_ERROR;
+
+  err = svn_fs_fs__get_rep_reference(&rep, fs,
+                                     svn_checksum_dup(sha1_checksum,
+                                                      scratch_pool),
+                                     result_pool);
+  if (err)
+    {
+      /* Same policy as in get_shared_rep(): do not mask corruptions but
+         otherwise simply continue without rep-sharing. */
+      if (err->apr_err == SVN_ERR_FS_CORRUPT
+          || SVN_ERROR_IN_CATEGORY(err->apr_err,
+                                   SVN_ERR_MALFUNC_CATEGORY_START))
+        return svn_error_trace(err);
+
+      (fs->warning)(fs->warning_baton, err);
+      svn_error_clear(err);
+      return SVN_NO_ERROR;
+    }
+
+  if (!rep)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_fs_fs__check_rep(rep, fs, NULL, scratch_pool));
+
+  /* The rep-cache does not record MD5 checksums but the node-revision
+     needs one.  Reading the fulltext gives us that and lets us verify
+     that the cache entry really matches the requested SHA-1. */
+  SVN_ERR(svn_fs_fs__get_contents(&contents, fs, rep, FALSE, scratch_pool));
+  contents = svn_stream_checksummed2(contents, &md5_checksum, NULL,
+                                     svn_checksum_md5, FALSE, scratch_pool);
+  contents = svn_stream_checksummed2(contents, &actual_sha1, NULL,
+                                     svn_checksum_sha1, TRUE, scratch_pool);
+  SVN_ERR(svn_stream_close(contents));
+
+  if (!svn_checksum_match(sha1_checksum, actual_sha1))
+    {
+      err = svn_checksum_mismatch_err(sha1_checksum, actual_sha1,
+                                      scratch_pool,
+                                      _("Representation in rep-cache.db "
+                                        "does not match its SHA1; it will "
+                                        "not be shared"));
+      (fs->warning)(fs->warning_baton, err);
+      svn_error_clear(err);
+      return SVN_NO_ERROR;
+    }
+
+  memcpy(rep->md5_digest, md5_checksum->digest, sizeof(rep->md5_digest));
+  *rep_p = rep;
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_fs_fs__set_shared_contents(svn_fs_t *fs,
+                               node_revision_t *noderev,
+                               representation_t *rep,
+                               apr_pool_t *pool)
+{
+  representation_t uniquifier_rep = { 0 };
+
+  if (noderev->kind != svn_node_file)
+    return svn_error_create(SVN_ERR_FS_NOT_FILE, NULL,
+                            _("Can't set text contents of a directory"));
+
+  /* Like any shared rep, give it a uniquifier of this txn. */
+  uniquifier_rep.txn_id = *svn_fs_fs__id_txn_id(noderev->id);
+  SVN_ERR(set_uniquifier(fs, &uniquifier_rep, pool));
+  rep->uniquifier = uniquifier_rep.uniquifier;
+
+  noderev->data_rep = rep;
+
+  return svn_error_trace(svn_fs_fs__put_node_revision(fs, noderev->id,
+                                                      noderev, FALSE, pool));
+}
+
 svn_error_t *
 svn_fs_fs__create_successor(const svn_fs_id_t **new_id_p,
                             svn_fs_t *fs,
@@ -2713,10 +3571,8 @@ struct write_container_baton
 
   apr_size_t size;
 
-  svn_checksum_ctx_t *md5_ctx;
-
-  /* SHA1 calculation is optional. If not needed, this will be NULL. */
-  svn_checksum_ctx_t *sha1_ctx;
+  /* MD5 and, optionally, SHA1 of the container's contents. */
+  svn_checksum__multi_ctx_t *checksum_ctx;
 };
 
 /* The handler for the write_container_rep stream.  BATON is a
@@ -2729,9 +3585,7 @@ write_container_handler(void *baton,
 {
   struct write_container_baton *whb = baton;
 
-  SVN_ERR(svn_checksum_update(whb->md5_ctx, data, *len));
-  if (whb->sha1_ctx)
-    SVN_ERR(svn_checksum_update(whb->sha1_ctx, data, *len));
+  SVN_ERR(svn_checksum__multi_update(whb->checksum_ctx, data, *len));
 
   SVN_ERR(svn_stream_write(whb->stream, data, len));
   whb->size += *len;
@@ -2809,9 +3663,11 @@ write_container_rep(representation_t *rep,
   else
     fnv1a_checksum_ctx = NULL;
   whb->size = 0;
-  whb->md5_ctx = svn_checksum_ctx_create(svn_checksum_md5, scratch_pool);
-  if (item_type != SVN_FS_FS__ITEM_TYPE_DIR_REP)
-    whb->sha1_ctx = svn_checksum_ctx_create(svn_checksum_sha1, scratch_pool);
+  whb->checksum_ctx = svn_checksum__multi_ctx_create(
+                        item_type == SVN_FS_FS__ITEM_TYPE_DIR_REP
+                          ? SVN_CHECKSUM__KIND_FLAG(svn_checksum_md5)
+                          : MD5_AND_SHA1,
+                        scratch_pool);
 
   stream = svn_stream_create(whb, scratch_pool);
   svn_stream_set_write(stream, write_container_handler);
@@ -2821,7 +3677,7 @@ write_container_rep(representation_t *rep,
   SVN_ERR(writer(stream, collection, scratch_pool));
 
   /* Store the results. */
-  SVN_ERR(digests_final(rep, whb->md5_ctx, whb->sha1_ctx, scratch_pool));
+  SVN_ERR(digests_final(rep, whb->checksum_ctx, scratch_pool));
 
   /* Update size info. */
   rep->expanded_size = whb->size;
@@ -2950,12 +3806,14 @@ write_container_delta_rep(representation_t *rep,
   txdelta_to_svndiff(&diff_wh, &diff_whb, file_stream, fs, scratch_pool);
 
   whb = apr_pcalloc(scratch_pool, sizeof(*whb));
-  whb->stream = svn_txdelta_target_push(diff_wh, diff_whb, source,
-                                        scratch_pool);
+  whb->stream = delta_target_push(diff_wh, diff_whb, source, fs,
+                                  scratch_pool);
   whb->size = 0;
-  whb->md5_ctx = svn_checksum_ctx_create(svn_checksum_md5, scratch_pool);
-  if (item_type != SVN_FS_FS__ITEM_TYPE_DIR_REP)
-    whb->sha1_ctx = svn_checksum_ctx_create(svn_checksum_sha1, scratch_pool);
+  whb->checksum_ctx = svn_checksum__multi_ctx_create(
+                        item_type == SVN_FS_FS__ITEM_TYPE_DIR_REP
+                          ? SVN_CHECKSUM__KIND_FLAG(svn_checksum_md5)
+                          : MD5_AND_SHA1,
+                        scratch_pool);
 
   /* serialize the hash */
   stream = svn_stream_create(whb, scratch_pool);
@@ -2965,7 +3823,7 @@ write_container_delta_rep(representation_t *rep,
   SVN_ERR(svn_stream_close(whb->stream));
 
   /* Store the results. */
-  SVN_ERR(digests_final(rep, whb->md5_ctx, whb->sha1_ctx, scratch_pool));
+  SVN_ERR(digests_final(rep, whb->checksum_ctx, scratch_pool));
 
   /* Update size info. */
   SVN_ERR(svn_io_file_get_offset(&rep_end, file, scratch_pool));
@@ -3017,24 +3875,246 @@ write_container_delta_rep(representation_t *rep,
   return SVN_NO_ERROR;
 }
 
-/* Sanity check ROOT_NODEREV, a candidate for being the root node-revision
-   of (not yet committed) revision REV in FS.  Use POOL for temporary
-   allocations.
-
-   If you change this function, consider updating svn_fs_fs__verify() too.
- */
+/* Blocks of indexed directories end behind an entry whose name hashes to
+   a multiple of DIR_BLOCK_DIVISOR, but they are at least DIR_BLOCK_MIN_SIZE
+   and at most DIR_BLOCK_MAX_SIZE bytes.  Like chunk boundaries, this only
+   depends on the entries, so modifying a directory only changes the blocks
+   around the modified entries.  A block holds about 400 entries. */
+#define DIR_BLOCK_MIN_SIZE 0x2000
+#define DIR_BLOCK_MAX_SIZE 0x10000
+#define DIR_BLOCK_DIVISOR 256
+
+/* Implement collection_writer_t writing the svn_stringbuf_t given as
+   BATON. */
 static svn_error_t *
-validate_root_noderev(svn_fs_t *fs,
-                      node_revision_t *root_noderev,
-                      svn_revnum_t rev,
-                      apr_pool_t *pool)
+write_stringbuf_to_stream(svn_stream_t *stream,
+                          void *baton,
+                          apr_pool_t *pool)
 {
-  svn_revnum_t head_revnum = rev-1;
-  int head_predecessor_count;
+  svn_stringbuf_t *text = baton;
+  apr_size_t len = text->len;
 
-  SVN_ERR_ASSERT(rev > 0);
+  return svn_error_trace(svn_stream_write(stream, text->data, &len));
+}
 
-  /* Compute HEAD_PREDECESSOR_COUNT. */
+/* Set *BLOCK to a PLAIN directory block with the LEN bytes of DATA in FS,
+   written to FILE for the directory representation REP.  If OLD_BLOCK is
+   not NULL and has the same contents, return that one instead.  Allocate
+   *BLOCK in RESULT_POOL and use SCRATCH_POOL for temporaries. */
+static svn_error_t *
+write_dir_block(representation_t **block,
+                apr_file_t *file,
+                svn_fs_t *fs,
+                representation_t *rep,
+                const char *data,
+                apr_size_t len,
+                representation_t *old_block,
+                apr_pool_t *result_pool,
+                apr_pool_t *scratch_pool)
+{
+  svn_checksum_t *md5;
+
+  /* Unmodified blocks simply get reused. */
+  SVN_ERR(svn_checksum(&md5, svn_checksum_md5, data, len, scratch_pool));
+  if (   old_block
+      && old_block->expanded_size == len
+      && memcmp(old_block->md5_digest, md5->digest,
+                sizeof(old_block->md5_digest)) == 0)
+    {
+      *block = svn_fs_fs__rep_copy(old_block, result_pool);
+      return SVN_NO_ERROR;
+    }
+
+  *block = apr_pcalloc(result_pool, sizeof(**block));
+  (*block)->revision = rep->revision;
+  (*block)->txn_id = rep->txn_id;
+  SVN_ERR(write_container_rep(*block, file,
+                              svn_stringbuf_ncreate(data, len, scratch_pool),
+                              write_stringbuf_to_stream, fs, NULL, FALSE,
+                              SVN_FS_FS__ITEM_TYPE_DIR_REP, scratch_pool));
+  reset_txn_in_rep(*block);
+
+  return SVN_NO_ERROR;
+}
+
+/* If FS supports indexed directories and the ENTRIES of the directory
+   NODEREV are large enough, write them to FILE as an indexed list of
+   blocks, record that in REP and set *INDEXED to TRUE.  Reuse the blocks
+   of the predecessor that did not change.  Otherwise, set *INDEXED to
+   FALSE.  Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+write_indexed_dir_rep(svn_boolean_t *indexed,
+                      representation_t *rep,
+                      apr_file_t *file,
+                      apr_array_header_t *entries,
+                      svn_fs_t *fs,
+                      node_revision_t *noderev,
+                      apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  apr_pool_t *iterpool;
+  apr_hash_t *old_blocks = apr_hash_make(scratch_pool);
+  apr_array_header_t *ends;
+  apr_array_header_t *blocks;
+  apr_array_header_t *names;
+  svn_stringbuf_t *text;
+  svn_stream_t *stream;
+  svn_checksum_t *md5;
+  svn_checksum_ctx_t *fnv1a_checksum_ctx = NULL;
+  svn_fs_fs__rep_header_t header = { 0 };
+  apr_off_t offset;
+  apr_off_t body_start;
+  apr_off_t body_end;
+  apr_size_t start;
+  int first;
+  int i;
+
+  /* Don't even serialize directories that are very unlikely to reach the
+     size threshold. */
+  *indexed = FALSE;
+  if (   !ffd->indexed_dirs
+      || entries->nelts < SVN_FS_FS__INDEXED_DIR_MIN_SIZE / 128)
+    return SVN_NO_ERROR;
+
+  /* Serialize the directory and remember where each entry ends. */
+  text = svn_stringbuf_create_empty(scratch_pool);
+  stream = svn_stream_from_stringbuf(text, scratch_pool);
+  ends = apr_array_make(scratch_pool, entries->nelts, sizeof(apr_size_t));
+  iterpool = svn_pool_create(scratch_pool);
+  for (i = 0; i < entries->nelts; ++i)
+    {
+      svn_pool_clear(iterpool);
+      SVN_ERR(unparse_dir_entry(APR_ARRAY_IDX(entries, i, svn_fs_dirent_t *),
+                                stream, iterpool));
+      APR_ARRAY_PUSH(ends, apr_size_t) = text->len;
+    }
+
+  if (text->len < SVN_FS_FS__INDEXED_DIR_MIN_SIZE)
+    {
+      svn_pool_destroy(iterpool);
+      return SVN_NO_ERROR;
+    }
+
+  /* The terminator becomes part of the last block. */
+  SVN_ERR(svn_stream_puts(stream, SVN_HASH_TERMINATOR "\n"));
+
+  /* Blocks of the previous version, by the name of their first entry. */
+  if (noderev->predecessor_id)
+    {
+      node_revision_t *pred;
+      apr_array_header_t *old_list;
+      apr_array_header_t *old_names;
+
+      SVN_ERR(svn_fs_fs__get_node_revision(&pred, fs, noderev->predecessor_id,
+                                           scratch_pool, iterpool));
+      SVN_ERR(svn_fs_fs__get_dir_index(&old_list, &old_names, fs,
+                                       pred->data_rep, scratch_pool,
+                                       iterpool));
+      for (i = 0; old_list && i < old_list->nelts; ++i)
+        svn_hash_sets(old_blocks, APR_ARRAY_IDX(old_names, i, const char *),
+                      APR_ARRAY_IDX(old_list, i, representation_t *));
+    }
+
+  /* Cut the directory into blocks and write those that changed. */
+  blocks = apr_array_make(scratch_pool, 16, sizeof(representation_t *));
+  names = apr_array_make(scratch_pool, 16, sizeof(const char *));
+  start = 0;
+  first = 0;
+  for (i = 0; i < entries->nelts; ++i)
+    {
+      const char *name = APR_ARRAY_IDX(entries, i, svn_fs_dirent_t *)->name;
+      const char *first_name;
+      representation_t *block;
+      apr_size_t end = i + 1 < entries->nelts
+                     ? APR_ARRAY_IDX(ends, i, apr_size_t)
+                     : text->len;
+      apr_size_t size = end - start;
+
+      if (   i + 1 < entries->nelts
+          && size < DIR_BLOCK_MAX_SIZE
+          && (   size < DIR_BLOCK_MIN_SIZE
+              || svn__fnv1a_32(name, strlen(name)) % DIR_BLOCK_DIVISOR))
+        continue;
+
+      svn_pool_clear(iterpool);
+      first_name = APR_ARRAY_IDX(entries, first, svn_fs_dirent_t *)->name;
+      SVN_ERR(write_dir_block(&block, file, fs, rep, text->data + start,
+                              size, svn_hash_gets(old_blocks, first_name),
+                              scratch_pool, iterpool));
+
+      APR_ARRAY_PUSH(blocks, representation_t *) = block;
+      APR_ARRAY_PUSH(names, const char *) = first_name;
+      start = end;
+      first = i + 1;
+    }
+
+  svn_pool_destroy(iterpool);
+
+  /* Write the index as the actual directory rep. */
+  SVN_ERR(svn_io_file_get_offset(&offset, file, scratch_pool));
+  stream = svn_stream_from_aprfile2(file, TRUE, scratch_pool);
+  if (svn_fs_fs__use_log_addressing(fs))
+    stream = fnv1a_wrap_stream(&fnv1a_checksum_ctx, stream, scratch_pool);
+
+  header.type = svn_fs_fs__rep_dir_index;
+  SVN_ERR(svn_fs_fs__write_rep_header(&header, stream, scratch_pool));
+  SVN_ERR(svn_io_file_get_offset(&body_start, file, scratch_pool));
+  SVN_ERR(svn_fs_fs__write_dir_index(stream, blocks, names, ffd->format,
+                                     scratch_pool));
+  SVN_ERR(svn_io_file_get_offset(&body_end, file, scratch_pool));
+  SVN_ERR(svn_stream_puts(stream, "ENDREP\n"));
+
+  /* The checksum covers the whole listing, just like for PLAIN reps. */
+  SVN_ERR(svn_checksum(&md5, svn_checksum_md5, text->data, text->len,
+                       scratch_pool));
+  memcpy(rep->md5_digest, md5->digest, sizeof(rep->md5_digest));
+  rep->has_sha1 = FALSE;
+  rep->size = body_end - body_start;
+  rep->expanded_size = text->len;
+
+  SVN_ERR(allocate_item_index(&rep->item_index, fs, &rep->txn_id,
+                              offset, scratch_pool));
+
+  if (svn_fs_fs__use_log_addressing(fs))
+    {
+      svn_fs_fs__p2l_entry_t entry;
+
+      entry.offset = offset;
+      SVN_ERR(svn_io_file_get_offset(&offset, file, scratch_pool));
+      entry.size = offset - entry.offset;
+      entry.type = SVN_FS_FS__ITEM_TYPE_DIR_REP;
+      entry.item.revision = SVN_INVALID_REVNUM;
+      entry.item.number = rep->item_index;
+      SVN_ERR(fnv1a_checksum_finalize(&entry.fnv1_checksum,
+                                      fnv1a_checksum_ctx,
+                                      scratch_pool));
+
+      SVN_ERR(store_p2l_index_entry(fs, &rep->txn_id, &entry, scratch_pool));
+    }
+
+  *indexed = TRUE;
+
+  return SVN_NO_ERROR;
+}
+
+/* Sanity check ROOT_NODEREV, a candidate for being the root node-revision
+   of (not yet committed) revision REV in FS.  Use POOL for temporary
+   allocations.
+
+   If you change this function, consider updating svn_fs_fs__verify() too.
+ */
+static svn_error_t *
+validate_root_noderev(svn_fs_t *fs,
+                      node_revision_t *root_noderev,
+                      svn_revnum_t rev,
+                      apr_pool_t *pool)
+{
+  svn_revnum_t head_revnum = rev-1;
+  int head_predecessor_count;
+
+  SVN_ERR_ASSERT(rev > 0);
+
+  /* Compute HEAD_PREDECESSOR_COUNT. */
   {
     svn_fs_root_t *head_revision;
     const svn_fs_id_t *head_root_id;
@@ -3100,6 +4180,38 @@ get_final_id(svn_fs_fs__id_part_t *part,
     }
 }
 
+/* Return the txn_filesize value that marks directory contents cached
+   while committing TXN_ID as not yet valid. */
+static svn_filesize_t
+get_stale_dir_filesize(const svn_fs_fs__id_part_t *txn_id)
+{
+  return -2 - (svn_filesize_t)txn_id->number;
+}
+
+/* Set the skip_id of NODEREV in FS to its ancestor with the lowest set bit
+   of the predecessor count cleared.  Leave it NULL if that ancestor is the
+   immediate predecessor anyway.  Use POOL for allocations. */
+static svn_error_t *
+set_skip_id(node_revision_t *noderev,
+            svn_fs_t *fs,
+            apr_pool_t *pool)
+{
+  int count = noderev->predecessor_count & (noderev->predecessor_count - 1);
+  node_revision_t *ancestor;
+
+  noderev->skip_id = NULL;
+  if (count >= noderev->predecessor_count - 1)
+    return SVN_NO_ERROR;
+
+  /* The predecessors already form a skip-list as far as they have the
+     pointers.  So, this takes a logarithmic number of steps. */
+  SVN_ERR(svn_fs_fs__get_ancestor(&ancestor, fs, noderev, count, pool,
+                                  pool));
+  noderev->skip_id = ancestor->id;
+
+  return SVN_NO_ERROR;
+}
+
 /* Copy a node-revision specified by id ID in fileystem FS from a
    transaction into the proto-rev-file FILE.  Set *NEW_ID_P to a
    pointer to the new node-id which will be allocated in POOL.
@@ -3153,6 +4265,7 @@ write_final_rev(const svn_fs_id_t **new_id_p,
   const svn_fs_fs__id_part_t *txn_id = svn_fs_fs__id_txn_id(id);
   svn_stream_t *file_stream;
   svn_checksum_ctx_t *fnv1a_checksum_ctx;
+  apr_array_header_t *chunks = NULL;
   apr_pool_t *subpool;
 
   *new_id_p = NULL;
@@ -3191,17 +4304,20 @@ write_final_rev(const svn_fs_id_t **new_id_p,
         {
           pair_cache_key_t *key;
           svn_fs_fs__dir_data_t dir_data;
+          svn_boolean_t indexed;
 
           /* Write out the contents of this directory as a text rep. */
           noderev->data_rep->revision = rev;
-          if (ffd->deltify_directories)
+          SVN_ERR(write_indexed_dir_rep(&indexed, noderev->data_rep, file,
+                                        entries, fs, noderev, pool));
+          if (!indexed && ffd->deltify_directories)
             SVN_ERR(write_container_delta_rep(noderev->data_rep, file,
                                               entries,
                                               write_directory_to_stream,
                                               fs, noderev, NULL, FALSE,
                                               SVN_FS_FS__ITEM_TYPE_DIR_REP,
                                               pool));
-          else
+          else if (!indexed)
             SVN_ERR(write_container_rep(noderev->data_rep, file, entries,
                                         write_directory_to_stream, fs, NULL,
                                         FALSE, SVN_FS_FS__ITEM_TYPE_DIR_REP,
@@ -3217,12 +4333,15 @@ write_final_rev(const svn_fs_id_t **new_id_p,
           key->second = noderev->data_rep->item_index;
 
           /* Store directory contents under the new revision number but mark
-           * it as "stale" by setting the file length to 0.  Committed dirs
-           * will report -1, in-txn dirs will report > 0, so that this can
-           * never match.  We reset that to -1 after the commit is complete.
+           * it as "stale" by setting the file length to a negative value
+           * specific to this txn.  Committed dirs will report -1, in-txn
+           * dirs will report >= 0, so that this can never match.  We reset
+           * that to -1 after the commit is complete.  Since we may write
+           * this before getting the write lock, a concurrent commit may
+           * overwrite the entry and must then not promote ours or v.v.
            */
           dir_data.entries = entries;
-          dir_data.txn_filesize = 0;
+          dir_data.txn_filesize = get_stale_dir_filesize(txn_id);
 
           SVN_ERR(svn_cache__set(ffd->dir_cache, key, &dir_data, subpool));
         }
@@ -3235,6 +4354,11 @@ write_final_rev(const svn_fs_id_t **new_id_p,
 
       if (noderev->data_rep && is_txn_rep(noderev->data_rep))
         {
+          /* New chunks need to go into the rep cache as well. */
+          if (ffd->rep_sharing_allowed)
+            SVN_ERR(svn_fs_fs__get_rep_chunks(&chunks, fs, noderev->data_rep,
+                                              pool, subpool));
+
           reset_txn_in_rep(noderev->data_rep);
           noderev->data_rep->revision = rev;
 
@@ -3315,6 +4439,27 @@ write_final_rev(const svn_fs_id_t **new_id_p,
             = svn_fs_fs__rep_copy(noderev->data_rep, reps_pool);
         }
 
+      /* Likewise for the chunks written in this txn. */
+      if (chunks)
+        {
+          int i;
+          for (i = 0; i < chunks->nelts; ++i)
+            {
+              representation_t *chunk
+                = APR_ARRAY_IDX(chunks, i, representation_t *);
+
+              if (is_txn_rep(chunk))
+                {
+                  representation_t *copy
+                    = svn_fs_fs__rep_copy(chunk, reps_pool);
+                  reset_txn_in_rep(copy);
+                  copy->revision = rev;
+
+                  APR_ARRAY_PUSH(reps_to_cache, representation_t *) = copy;
+                }
+            }
+        }
+
       if (noderev->prop_rep && noderev->prop_rep->revision == rev)
         {
           /* Add new property reps to hash and on-disk cache. */
@@ -3354,6 +4499,10 @@ write_final_rev(const svn_fs_id_t **new_id_p,
       noderev->prop_rep->has_sha1 = FALSE;
     }
 
+  /* Record where the skip-list continues from this node-rev. */
+  if (ffd->ancestor_skip_pointers)
+    SVN_ERR(set_skip_id(noderev, fs, pool));
+
   /* Workaround issue #4031: is-fresh-txn-root in revision files. */
   noderev->is_fresh_txn_root = FALSE;
 
@@ -3689,14 +4838,16 @@ svn_fs_fs__add_index_data(svn_fs_t *fs,
   return SVN_NO_ERROR;
 }
 
-/* Mark the directories cached in FS with the keys from DIRECTORY_IDS
- * as "valid" now.  Use SCRATCH_POOL for temporaries. */
+/* Mark the directories cached in FS by the commit of TXN_ID with the keys
+ * from DIRECTORY_IDS as "valid" now.  Use SCRATCH_POOL for temporaries. */
 static svn_error_t *
 promote_cached_directories(svn_fs_t *fs,
+                           const svn_fs_fs__id_part_t *txn_id,
                            apr_array_header_t *directory_ids,
                            apr_pool_t *scratch_pool)
 {
   fs_fs_data_t *ffd = fs->fsap_data;
+  svn_filesize_t stale_filesize = get_stale_dir_filesize(txn_id);
   apr_pool_t *iterpool;
   int i;
 
@@ -3713,10 +4864,10 @@ promote_cached_directories(svn_fs_t *fs,
 
       /* Currently, the entry for KEY - if it still exists - is marked
        * as "stale" and would not be used.  Mark it as current for in-
-       * revison data. */
+       * revison data unless another commit replaced it. */
       SVN_ERR(svn_cache__set_partial(ffd->dir_cache, key,
-                                     svn_fs_fs__reset_txn_filesize, NULL,
-                                     iterpool));
+                                     svn_fs_fs__reset_txn_filesize,
+                                     &stale_filesize, iterpool));
     }
 
   svn_pool_destroy(iterpool);
@@ -3732,114 +4883,325 @@ struct commit_baton {
   apr_array_header_t *reps_to_cache;
   apr_hash_t *reps_hash;
   apr_pool_t *reps_pool;
+
+  /* The changes list of the txn.  NULL until fetched. */
+  apr_hash_t *changed_paths;
+
+  /* If TRUE, the final revision data for REVISION has been written to
+     the proto-rev file but that has not been moved into place, yet.
+     The remaining members describe that state. */
+  svn_boolean_t written;
+  svn_revnum_t revision;
+  int format;
+  svn_boolean_t log_addressing;
+  const svn_fs_id_t *new_root_id;
+  apr_array_header_t *directory_ids;
+  void *proto_file_lockcookie;
+
+  /* Sizes and contents of the txn files before writing the final
+     revision data.  Used to revert to the original txn state. */
+  apr_off_t initial_offset;
+  apr_off_t l2p_proto_index_size;
+  apr_off_t p2l_proto_index_size;
+  svn_stringbuf_t *item_index;
+
+  /* Flush the new revision data to disk while still holding the write
+     lock?  If FALSE, the caller takes care of that. */
+  svn_boolean_t flush_to_disk;
+
+  /* The revision that has been written to disk by write_new_revision(). */
+  svn_revnum_t new_rev;
+
+  /* Receives the duration of the commit phases.  NULL for group commit
+     members, which get written by another thread.  LOCK_REQUESTED is
+     the time at which we asked for the write lock. */
+  const svn_fs__commit_timing_t *timing;
+  apr_time_t lock_requested;
+
+  /* Group commit members only: see svn_fs_fs__commit(). */
+  svn_fs_fs__commit_rebase_t rebase_func;
+  void *rebase_baton;
+  apr_pool_t *pool;
+
+  /* Group commit members only: Outcome of the commit, valid once DONE
+     has been set.  NEXT links the waiting commits in the queue. */
+  svn_error_t *err;
+  svn_boolean_t done;
+  struct commit_baton *next;
 };
 
-/* The work-horse for svn_fs_fs__commit, called with the FS write lock.
-   This implements the svn_fs_fs__with_write_lock() 'body' callback
-   type.  BATON is a 'struct commit_baton *'. */
+/* Set *SIZE to the size of file PATH, or -1 if it does not exist.
+   Use SCRATCH_POOL for temporaries. */
 static svn_error_t *
-commit_body(void *baton, apr_pool_t *pool)
+get_txn_file_size(apr_off_t *size,
+                  const char *path,
+                  apr_pool_t *scratch_pool)
 {
-  struct commit_baton *cb = baton;
-  fs_fs_data_t *ffd = cb->fs->fsap_data;
-  const char *old_rev_filename, *rev_filename, *proto_filename;
-  const char *revprop_filename;
-  const svn_fs_id_t *root_id, *new_root_id;
-  apr_uint64_t start_node_id;
-  apr_uint64_t start_copy_id;
-  svn_revnum_t old_rev, new_rev;
-  apr_file_t *proto_file;
-  void *proto_file_lockcookie;
-  apr_off_t initial_offset, changed_path_offset;
-  const svn_fs_fs__id_part_t *txn_id = svn_fs_fs__txn_get_id(cb->txn);
-  apr_hash_t *changed_paths;
-  apr_array_header_t *directory_ids = apr_array_make(pool, 4,
-                                                     sizeof(pair_cache_key_t));
+  const svn_io_dirent2_t *dirent;
 
-  /* Re-Read the current repository format.  All our repo upgrade and
-     config evaluation strategies are such that existing information in
-     FS and FFD remains valid.
+  SVN_ERR(svn_io_stat_dirent2(&dirent, path, FALSE, TRUE, scratch_pool,
+                              scratch_pool));
+  *size = dirent->kind == svn_node_file ? (apr_off_t)dirent->filesize : -1;
 
-     Although we don't recommend upgrading hot repositories, people may
-     still do it and we must make sure to either handle them gracefully
-     or to error out.
+  return SVN_NO_ERROR;
+}
 
-     Committing pre-format 3 txns will fail after upgrade to format 3+
-     because the proto-rev cannot be found; no further action needed.
-     Upgrades from pre-f7 to f7+ means a potential change in addressing
-     mode for the final rev.  We must be sure to detect that cause because
-     the failure would only manifest once the new revision got committed.
-   */
-  SVN_ERR(svn_fs_fs__read_format_file(cb->fs, pool));
+/* Truncate file PATH to SIZE or remove it if SIZE is -1.
+   Use SCRATCH_POOL for temporaries. */
+static svn_error_t *
+reset_txn_file_size(const char *path,
+                    apr_off_t size,
+                    apr_pool_t *scratch_pool)
+{
+  apr_file_t *file;
 
-  /* Read the current youngest revision and, possibly, the next available
-     node id and copy id (for old format filesystems).  Update the cached
-     value for the youngest revision, because we have just checked it. */
-  SVN_ERR(svn_fs_fs__read_current(&old_rev, &start_node_id, &start_copy_id,
-                                  cb->fs, pool));
-  ffd->youngest_rev_cache = old_rev;
+  if (size < 0)
+    return svn_error_trace(svn_io_remove_file2(path, TRUE, scratch_pool));
 
-  /* Check to make sure this transaction is based off the most recent
-     revision. */
-  if (cb->txn->base_rev != old_rev)
-    return svn_error_create(SVN_ERR_FS_TXN_OUT_OF_DATE, NULL,
-                            _("Transaction out of date"));
+  SVN_ERR(svn_io_file_open(&file, path, APR_WRITE, APR_OS_DEFAULT,
+                           scratch_pool));
+  SVN_ERR(svn_io_file_trunc(file, size, scratch_pool));
 
-  /* We need the changes list for verification as well as for writing it
-     to the final rev file. */
-  SVN_ERR(svn_fs_fs__txn_changes_fetch(&changed_paths, cb->fs, txn_id,
-                                       pool));
+  return svn_error_trace(svn_io_file_close(file, scratch_pool));
+}
 
-  /* Locks may have been added (or stolen) between the calling of
-     previous svn_fs.h functions and svn_fs_commit_txn(), so we need
-     to re-examine every changed-path in the txn and re-verify all
-     discovered locks. */
-  SVN_ERR(verify_locks(cb->fs, txn_id, changed_paths, pool));
+/* Write the final representation of CB->TXN as revision NEW_REV to the
+   end of its proto-rev file: all node-revisions, directory contents, the
+   changed-path information and either the index data or the revision
+   trailer.  Flush the file to disk if CB->FLUSH_TO_DISK is set.  On
+   success, the proto-rev file remains locked and CB->WRITTEN is set;
+   see revert_final_rev_data() for how to undo this.
 
-  /* We are going to be one better than this puny old revision. */
-  new_rev = old_rev + 1;
+   START_NODE_ID and START_COPY_ID are the first available node and copy
+   ids for older formats.  Use POOL for allocations. */
+static svn_error_t *
+write_final_rev_data(struct commit_baton *cb,
+                     svn_revnum_t new_rev,
+                     apr_uint64_t start_node_id,
+                     apr_uint64_t start_copy_id,
+                     apr_pool_t *pool)
+{
+  fs_fs_data_t *ffd = cb->fs->fsap_data;
+  const svn_fs_fs__id_part_t *txn_id = svn_fs_fs__txn_get_id(cb->txn);
+  const svn_fs_id_t *root_id;
+  apr_off_t changed_path_offset;
+  apr_file_t *proto_file;
+  svn_error_t *err;
+
+  SVN_ERR_ASSERT(!cb->written);
+
+  /* We need the changes list for verification as well as for writing it
+     to the final rev file. */
+  if (cb->changed_paths == NULL)
+    SVN_ERR(svn_fs_fs__txn_changes_fetch(&cb->changed_paths, cb->fs, txn_id,
+                                         pool));
 
   /* Get a write handle on the proto revision file. */
-  SVN_ERR(get_writable_proto_rev(&proto_file, &proto_file_lockcookie,
+  SVN_ERR(get_writable_proto_rev(&proto_file, &cb->proto_file_lockcookie,
                                  cb->fs, txn_id, pool));
-  SVN_ERR(svn_io_file_get_offset(&initial_offset, proto_file, pool));
+  err = svn_io_file_get_offset(&cb->initial_offset, proto_file, pool);
+
+  /* Remember the state of all other txn files that we are going to
+     modify. */
+  cb->log_addressing = svn_fs_fs__use_log_addressing(cb->fs);
+  cb->item_index = NULL;
+  if (!err && cb->log_addressing)
+    {
+      apr_off_t item_index_size;
+      const char *item_index_path
+        = svn_fs_fs__path_txn_item_index(cb->fs, txn_id, pool);
+
+      err = get_txn_file_size(&cb->l2p_proto_index_size,
+                  svn_fs_fs__path_l2p_proto_index(cb->fs, txn_id, pool),
+                  pool);
+      if (!err)
+        err = get_txn_file_size(&cb->p2l_proto_index_size,
+                  svn_fs_fs__path_p2l_proto_index(cb->fs, txn_id, pool),
+                  pool);
+      if (!err)
+        err = get_txn_file_size(&item_index_size, item_index_path, pool);
+      if (!err && item_index_size >= 0)
+        err = svn_stringbuf_from_file2(&cb->item_index, item_index_path,
+                                       pool);
+    }
+
+  if (err)
+    {
+      err = svn_error_compose_create(err,
+                                     svn_io_file_close(proto_file, pool));
+      return svn_error_compose_create(err,
+                                      unlock_proto_rev(cb->fs, txn_id,
+                                               cb->proto_file_lockcookie,
+                                               pool));
+    }
+
+  /* From here on, errors can be undone by revert_final_rev_data(). */
+  cb->written = TRUE;
+  cb->revision = new_rev;
+  cb->format = ffd->format;
+  cb->directory_ids = apr_array_make(pool, 4, sizeof(pair_cache_key_t));
 
   /* Write out all the node-revisions and directory contents. */
   root_id = svn_fs_fs__id_txn_create_root(txn_id, pool);
-  SVN_ERR(write_final_rev(&new_root_id, proto_file, new_rev, cb->fs, root_id,
-                          start_node_id, start_copy_id, initial_offset,
-                          directory_ids, cb->reps_to_cache, cb->reps_hash,
-                          cb->reps_pool, TRUE, pool));
+  err = write_final_rev(&cb->new_root_id, proto_file, new_rev, cb->fs,
+                        root_id, start_node_id, start_copy_id,
+                        cb->initial_offset, cb->directory_ids,
+                        cb->reps_to_cache, cb->reps_hash, cb->reps_pool,
+                        TRUE, pool);
 
   /* Write the changed-path information. */
-  SVN_ERR(write_final_changed_path_info(&changed_path_offset, proto_file,
-                                        cb->fs, txn_id, changed_paths,
-                                        pool));
+  if (!err)
+    err = write_final_changed_path_info(&changed_path_offset, proto_file,
+                                        cb->fs, txn_id, cb->changed_paths,
+                                        pool);
 
-  if (svn_fs_fs__use_log_addressing(cb->fs))
+  if (!err && cb->log_addressing)
     {
       /* Append the index data to the rev file. */
-      SVN_ERR(svn_fs_fs__add_index_data(cb->fs, proto_file,
+      err = svn_fs_fs__add_index_data(cb->fs, proto_file,
                       svn_fs_fs__path_l2p_proto_index(cb->fs, txn_id, pool),
                       svn_fs_fs__path_p2l_proto_index(cb->fs, txn_id, pool),
-                      new_rev, pool));
+                      new_rev, pool);
     }
-  else
+  else if (!err)
     {
       /* Write the final line. */
 
       svn_stringbuf_t *trailer
         = svn_fs_fs__unparse_revision_trailer
-                  ((apr_off_t)svn_fs_fs__id_item(new_root_id),
+                  ((apr_off_t)svn_fs_fs__id_item(cb->new_root_id),
                    changed_path_offset,
                    pool);
-      SVN_ERR(svn_io_file_write_full(proto_file, trailer->data, trailer->len,
-                                     NULL, pool));
+      err = svn_io_file_write_full(proto_file, trailer->data, trailer->len,
+                                   NULL, pool);
+    }
+
+  if (!err && cb->flush_to_disk)
+    err = svn_io_file_flush_to_disk(proto_file, pool);
+
+  return svn_error_compose_create(err, svn_io_file_close(proto_file, pool));
+}
+
+/* Undo the effects of write_final_rev_data() on the txn in CB, i.e.
+   truncate its proto-rev and index files to their original sizes, forget
+   about all reps collected for the rep-cache and unlock the proto-rev
+   file.  Use SCRATCH_POOL for temporaries. */
+static svn_error_t *
+revert_final_rev_data(struct commit_baton *cb,
+                      apr_pool_t *scratch_pool)
+{
+  const svn_fs_fs__id_part_t *txn_id = svn_fs_fs__txn_get_id(cb->txn);
+  svn_error_t *err;
+
+  SVN_ERR_ASSERT(cb->written);
+  cb->written = FALSE;
+
+  if (cb->reps_to_cache)
+    apr_array_clear(cb->reps_to_cache);
+  if (cb->reps_hash)
+    apr_hash_clear(cb->reps_hash);
+
+  err = reset_txn_file_size(svn_fs_fs__path_txn_proto_rev(cb->fs, txn_id,
+                                                          scratch_pool),
+                            cb->initial_offset, scratch_pool);
+  if (!err && cb->log_addressing)
+    {
+      const char *item_index_path
+        = svn_fs_fs__path_txn_item_index(cb->fs, txn_id, scratch_pool);
+
+      err = reset_txn_file_size(
+              svn_fs_fs__path_l2p_proto_index(cb->fs, txn_id, scratch_pool),
+              cb->l2p_proto_index_size, scratch_pool);
+      if (!err)
+        err = reset_txn_file_size(
+              svn_fs_fs__path_p2l_proto_index(cb->fs, txn_id, scratch_pool),
+              cb->p2l_proto_index_size, scratch_pool);
+
+      if (!err && cb->item_index)
+        {
+          apr_file_t *file;
+
+          err = svn_io_file_open(&file, item_index_path,
+                                 APR_WRITE | APR_CREATE | APR_TRUNCATE,
+                                 APR_OS_DEFAULT, scratch_pool);
+          if (!err)
+            {
+              err = svn_io_file_write_full(file, cb->item_index->data,
+                                           cb->item_index->len, NULL,
+                                           scratch_pool);
+              err = svn_error_compose_create(err,
+                                             svn_io_file_close(file,
+                                                               scratch_pool));
+            }
+        }
+      else if (!err)
+        err = svn_io_remove_file2(item_index_path, TRUE, scratch_pool);
     }
 
-  if (ffd->flush_to_disk)
-    SVN_ERR(svn_io_file_flush_to_disk(proto_file, pool));
-  SVN_ERR(svn_io_file_close(proto_file, pool));
+  return svn_error_compose_create(err,
+                                  unlock_proto_rev(cb->fs, txn_id,
+                                                   cb->proto_file_lockcookie,
+                                                   scratch_pool));
+}
+
+/* Turn the txn in CB into revision OLD_REV + 1 on disk and set
+   CB->NEW_REV accordingly.  This does everything short of updating the
+   'current' file, which makes the new revision visible.  OLD_REV must
+   be the youngest revision in the repository, START_NODE_ID and
+   START_COPY_ID are the next available ids for older formats as read
+   from 'current'.  The FS write lock must be held.
+
+   Usually, the final revision data has already been written by the
+   caller and we only need to move it into place.  Data gets flushed
+   to disk only if CB->FLUSH_TO_DISK is set.  Use POOL for allocations. */
+static svn_error_t *
+write_new_revision(struct commit_baton *cb,
+                   svn_revnum_t old_rev,
+                   apr_uint64_t start_node_id,
+                   apr_uint64_t start_copy_id,
+                   apr_pool_t *pool)
+{
+  fs_fs_data_t *ffd = cb->fs->fsap_data;
+  const char *old_rev_filename, *rev_filename, *proto_filename;
+  const char *revprop_filename;
+  svn_revnum_t new_rev;
+  const svn_fs_fs__id_part_t *txn_id = svn_fs_fs__txn_get_id(cb->txn);
+  apr_time_t start;
+
+  /* Check to make sure this transaction is based off the most recent
+     revision. */
+  if (cb->txn->base_rev != old_rev)
+    return svn_error_create(SVN_ERR_FS_TXN_OUT_OF_DATE, NULL,
+                            _("Transaction out of date"));
+
+  /* We are going to be one better than this puny old revision. */
+  new_rev = old_rev + 1;
+
+  /* If the revision data that our caller wrote does not match the
+     repository format anymore, we have to write it again. */
+  if (   cb->written
+      && (   cb->revision != new_rev
+          || cb->format != ffd->format
+          || cb->log_addressing != svn_fs_fs__use_log_addressing(cb->fs)))
+    SVN_ERR(revert_final_rev_data(cb, pool));
+
+  /* Locks may have been added (or stolen) between the calling of
+     previous svn_fs.h functions and svn_fs_commit_txn(), so we need
+     to re-examine every changed-path in the txn and re-verify all
+     discovered locks. */
+  if (cb->changed_paths == NULL)
+    SVN_ERR(svn_fs_fs__txn_changes_fetch(&cb->changed_paths, cb->fs, txn_id,
+                                         pool));
+  SVN_ERR(verify_locks(cb->fs, txn_id, cb->changed_paths, pool));
+
+  /* Write out the revision data unless that has already been done. */
+  if (!cb->written)
+    {
+      start = svn_fs__timing_start(cb->timing);
+      SVN_ERR(write_final_rev_data(cb, new_rev, start_node_id,
+                                   start_copy_id, pool));
+      svn_fs__timing_phase(cb->timing, "write-rev", start, pool);
+    }
 
   /* We don't unlock the prototype revision file immediately to avoid a
      race with another caller writing to the prototype revision file
@@ -3887,70 +5249,409 @@ commit_body(void *baton, apr_pool_t *pool)
      ### This "breaks" the transaction by removing the protorev file
      ### but the revision is not yet complete.  If this commit does
      ### not complete for any reason the transaction will be lost. */
+  start = svn_fs__timing_start(cb->timing);
   old_rev_filename = svn_fs_fs__path_rev_absolute(cb->fs, old_rev, pool);
   rev_filename = svn_fs_fs__path_rev(cb->fs, new_rev, pool);
   proto_filename = svn_fs_fs__path_txn_proto_rev(cb->fs, txn_id, pool);
   SVN_ERR(svn_fs_fs__move_into_place(proto_filename, rev_filename,
-                                     old_rev_filename, ffd->flush_to_disk,
+                                     old_rev_filename, cb->flush_to_disk,
                                      pool));
+  cb->written = FALSE;
 
   /* Now that we've moved the prototype revision file out of the way,
      we can unlock it (since further attempts to write to the file
      will fail as it no longer exists).  We must do this so that we can
      remove the transaction directory later. */
-  SVN_ERR(unlock_proto_rev(cb->fs, txn_id, proto_file_lockcookie, pool));
+  SVN_ERR(unlock_proto_rev(cb->fs, txn_id, cb->proto_file_lockcookie, pool));
 
   /* Write final revprops file. */
   SVN_ERR_ASSERT(! svn_fs_fs__is_packed_revprop(cb->fs, new_rev));
   revprop_filename = svn_fs_fs__path_revprops(cb->fs, new_rev, pool);
   SVN_ERR(write_final_revprop(revprop_filename, old_rev_filename,
-                              cb->txn, ffd->flush_to_disk, pool));
+                              cb->txn, cb->flush_to_disk, pool));
+  svn_fs__timing_phase(cb->timing, "move-into-place", start, pool);
 
-  /* Run paranoia checks. */
-  if (ffd->verify_before_commit)
+  /* Run paranoia checks.  The expensive content checks of the split
+     verification run after the commit, see finalize_new_revision(). */
+  if (ffd->verify_before_commit || ffd->verify_after_commit)
     {
+      start = svn_fs__timing_start(cb->timing);
       SVN_ERR(verify_before_commit(cb->fs, new_rev, pool));
+      svn_fs__timing_phase(cb->timing, "verify", start, pool);
     }
 
-  /* Update the 'current' file. */
-  SVN_ERR(write_final_current(cb->fs, txn_id, new_rev, start_node_id,
-                              start_copy_id, pool));
+  cb->new_rev = new_rev;
+
+  return SVN_NO_ERROR;
+}
+
+/* To be called once CB->NEW_REV has been made visible by updating the
+   'current' file:  Let the caller know and clean up the txn.
+   Use POOL for temporary allocations. */
+static svn_error_t *
+finalize_new_revision(struct commit_baton *cb,
+                      apr_pool_t *pool)
+{
+  fs_fs_data_t *ffd = cb->fs->fsap_data;
+  const svn_fs_fs__id_part_t *txn_id = svn_fs_fs__txn_get_id(cb->txn);
 
   /* At this point the new revision is committed and globally visible
      so let the caller know it succeeded by giving it the new revision
      number, which fulfills svn_fs_commit_txn() contract.  Any errors
      after this point do not change the fact that a new revision was
      created. */
-  *cb->new_rev_p = new_rev;
+  *cb->new_rev_p = cb->new_rev;
 
-  ffd->youngest_rev_cache = new_rev;
+  ffd->youngest_rev_cache = cb->new_rev;
 
   /* Make the directory contents alreday cached for the new revision
    * visible. */
-  SVN_ERR(promote_cached_directories(cb->fs, directory_ids, pool));
+  SVN_ERR(promote_cached_directories(cb->fs, txn_id, cb->directory_ids,
+                                     pool));
 
   /* Remove this transaction directory. */
   SVN_ERR(svn_fs_fs__purge_txn(cb->fs, cb->txn->id, pool));
 
+  /* Check the contents in the background. */
+  if (ffd->verify_after_commit)
+    SVN_ERR(svn_fs_fs__verify_after_commit(cb->fs, cb->new_rev, pool));
+
   return SVN_NO_ERROR;
 }
 
-/* Add the representations in REPS_TO_CACHE (an array of representation_t *)
- * to the rep-cache database of FS. */
+/* The work-horse for svn_fs_fs__commit, called with the FS write lock.
+   This implements the svn_fs_fs__with_write_lock() 'body' callback
+   type.  BATON is a 'struct commit_baton *'. */
 static svn_error_t *
-write_reps_to_cache(svn_fs_t *fs,
-                    const apr_array_header_t *reps_to_cache,
-                    apr_pool_t *scratch_pool)
+commit_body(void *baton, apr_pool_t *pool)
 {
+  struct commit_baton *cb = baton;
+  fs_fs_data_t *ffd = cb->fs->fsap_data;
+  apr_uint64_t start_node_id;
+  apr_uint64_t start_copy_id;
+  svn_revnum_t old_rev;
+  const svn_fs_fs__id_part_t *txn_id = svn_fs_fs__txn_get_id(cb->txn);
+  apr_time_t start;
+
+  svn_fs__timing_phase(cb->timing, "lock-wait", cb->lock_requested, pool);
+
+  /* Re-Read the current repository format.  All our repo upgrade and
+     config evaluation strategies are such that existing information in
+     FS and FFD remains valid.
+
+     Although we don't recommend upgrading hot repositories, people may
+     still do it and we must make sure to either handle them gracefully
+     or to error out.
+
+     Committing pre-format 3 txns will fail after upgrade to format 3+
+     because the proto-rev cannot be found; no further action needed.
+     Upgrades from pre-f7 to f7+ means a potential change in addressing
+     mode for the final rev.  We must be sure to detect that cause because
+     the failure would only manifest once the new revision got committed.
+   */
+  SVN_ERR(svn_fs_fs__read_format_file(cb->fs, pool));
+
+  /* Read the current youngest revision and, possibly, the next available
+     node id and copy id (for old format filesystems).  Update the cached
+     value for the youngest revision, because we have just checked it. */
+  SVN_ERR(svn_fs_fs__read_current(&old_rev, &start_node_id, &start_copy_id,
+                                  cb->fs, pool));
+  ffd->youngest_rev_cache = old_rev;
+
+  SVN_ERR(write_new_revision(cb, old_rev, start_node_id, start_copy_id,
+                             pool));
+
+  /* Update the 'current' file. */
+  start = svn_fs__timing_start(cb->timing);
+  SVN_ERR(write_final_current(cb->fs, txn_id, cb->new_rev, start_node_id,
+                              start_copy_id, pool));
+  svn_fs__timing_phase(cb->timing, "current", start, pool);
+
+  start = svn_fs__timing_start(cb->timing);
+  SVN_ERR(finalize_new_revision(cb, pool));
+  svn_fs__timing_phase(cb->timing, "finalize", start, pool);
+
+  return SVN_NO_ERROR;
+}
+
+#if APR_HAS_THREADS
+
+/* Commits waiting for the write lock as part of a group commit, oldest
+   first, and the state of the group commit in progress.  All members
+   are protected by MUTEX. */
+struct fs_fs_commit_queue_t
+{
+  /* The first waiting commit and the NEXT pointer of the last one. */
+  struct commit_baton *first;
+  struct commit_baton **last_next;
+
+  /* If set, some thread is running a group commit.  It will not take
+     any commits queued after it acquired the write lock. */
+  svn_boolean_t busy;
+
+  svn_mutex__t *mutex;
+
+  /* Signaled whenever commits have been completed or BUSY got reset. */
+  apr_thread_cond_t *changed;
+};
+
+/* Make the revisions written for the group commit members in GROUP
+   (an array of struct commit_baton *) durable, i.e. flush their rev and
+   revprop files as well as the directories containing them to disk.
+   Each directory gets flushed only once and all flushes run in parallel.
+
+   This is a no-op on non-POSIX systems, where the members flush their
+   files themselves.  Use SCRATCH_POOL for temporaries. */
+static svn_error_t *
+flush_group(apr_array_header_t *group,
+            apr_pool_t *scratch_pool)
+{
+#ifdef SVN_ON_POSIX
+  svn_io__batch_fsync_t *batch;
   int i;
 
-  for (i = 0; i < reps_to_cache->nelts; i++)
+  SVN_ERR(svn_io__batch_fsync_create(&batch, TRUE, scratch_pool));
+
+  for (i = 0; i < group->nelts; ++i)
     {
-      representation_t *rep = APR_ARRAY_IDX(reps_to_cache, i, representation_t *);
+      struct commit_baton *cb = APR_ARRAY_IDX(group, i,
+                                              struct commit_baton *);
+      fs_fs_data_t *ffd = cb->fs->fsap_data;
+      const char *rev_path = svn_fs_fs__path_rev(cb->fs, cb->new_rev,
+                                                 scratch_pool);
+      const char *revprop_path = svn_fs_fs__path_revprops(cb->fs,
+                                                          cb->new_rev,
+                                                          scratch_pool);
+
+      /* Rev files are read-only but fsync() works with any file handle.
+         On POSIX, the file names are stored in the directory entries.
+         Hence, we need to fsync() those directories as well. */
+      SVN_ERR(svn_io__batch_fsync_add_file(batch, rev_path, scratch_pool));
+      SVN_ERR(svn_io__batch_fsync_new_path(batch, rev_path, scratch_pool));
+      SVN_ERR(svn_io__batch_fsync_add_file(batch, revprop_path,
+                                           scratch_pool));
+      SVN_ERR(svn_io__batch_fsync_new_path(batch, revprop_path,
+                                           scratch_pool));
+
+      /* Same for newly created shard directories. */
+      if (ffd->max_files_per_dir
+          && cb->new_rev % ffd->max_files_per_dir == 0)
+        {
+          const char *rev_shard = svn_dirent_dirname(rev_path,
+                                                     scratch_pool);
+          const char *revprop_shard = svn_dirent_dirname(revprop_path,
+                                                         scratch_pool);
+
+          SVN_ERR(svn_io__batch_fsync_new_path(batch, rev_shard,
+                                               scratch_pool));
+          SVN_ERR(svn_io__batch_fsync_new_path(batch, revprop_shard,
+                                               scratch_pool));
+        }
+    }
+
+  SVN_ERR(svn_io__batch_fsync_run(batch, scratch_pool));
+#endif
+
+  return SVN_NO_ERROR;
+}
+
+/* Write the txn of the group commit member CB as the revision following
+   YOUNGEST, rebasing it first if necessary.  YOUNGEST may have been
+   written by an earlier member of the same group and not be visible in
+   'current', yet.  The FS write lock must be held.  Use POOL for
+   allocations. */
+static svn_error_t *
+write_group_member(struct commit_baton *cb,
+                   svn_revnum_t youngest,
+                   apr_pool_t *pool)
+{
+  fs_fs_data_t *ffd = cb->fs->fsap_data;
+
+  /* CB->FS is not being used by its owner until CB is done.  Update it
+     the same way with_some_lock_file() would and make the revisions of
+     our group accessible for the rebase. */
+  SVN_ERR(svn_fs_fs__read_format_file(cb->fs, pool));
+  if (ffd->format >= SVN_FS_FS__MIN_PACKED_FORMAT)
+    SVN_ERR(svn_fs_fs__update_min_unpacked_rev(cb->fs, pool));
+  ffd->youngest_rev_cache = youngest;
+
+  if (cb->txn->base_rev != youngest)
+    SVN_ERR(cb->rebase_func(cb->rebase_baton, cb->txn, youngest, pool));
+
+  return svn_error_trace(write_new_revision(cb, youngest, 0, 0, pool));
+}
+
+/* Implements the svn_fs_fs__with_write_lock() 'body' callback type for
+   group commits.  BATON is the 'struct commit_baton *' of the thread that
+   acquired the write lock and is itself waiting in the commit queue.
+
+   Take all commits waiting in the queue, write them as consecutive
+   revisions, flush them to disk and make them visible with a single
+   update of the 'current' file.  Failing members don't affect the others.
+   The outcome is reported in the members' ERR and DONE fields.  Once the
+   waiting commits have been taken, this function will always succeed. */
+static svn_error_t *
+group_commit_body(void *baton,
+                  apr_pool_t *pool)
+{
+  struct commit_baton *leader = baton;
+  fs_fs_data_t *ffd = leader->fs->fsap_data;
+  fs_fs_commit_queue_t *queue = ffd->shared->commit_queue;
+  apr_array_header_t *written
+    = apr_array_make(pool, 16, sizeof(struct commit_baton *));
+  struct commit_baton *members;
+  struct commit_baton *cb;
+  svn_revnum_t old_rev, youngest;
+  svn_error_t *err;
+  int i;
+
+  SVN_ERR(svn_fs_fs__youngest_rev(&old_rev, leader->fs, pool));
+
+  /* Take all commits that have queued up so far, including our own. */
+  SVN_ERR(svn_mutex__lock(queue->mutex));
+  members = queue->first;
+  queue->first = NULL;
+  queue->last_next = &queue->first;
+  svn_error_clear(svn_mutex__unlock(queue->mutex, SVN_NO_ERROR));
+
+  /* Write them one after another, each one based on its predecessor. */
+  youngest = old_rev;
+  for (cb = members; cb; cb = cb->next)
+    {
+      cb->err = write_group_member(cb, youngest, cb->pool);
+      if (cb->err)
+        {
+          fs_fs_data_t *member_ffd = cb->fs->fsap_data;
+          member_ffd->youngest_rev_cache = old_rev;
+        }
+      else
+        {
+          youngest = cb->new_rev;
+          APR_ARRAY_PUSH(written, struct commit_baton *) = cb;
+        }
+    }
+
+  /* The common barrier.  Once the new revisions have been made durable,
+     publish them all at once. */
+  if (written->nelts)
+    {
+      err = flush_group(written, pool);
+      if (!err)
+        err = svn_fs_fs__write_current(leader->fs, youngest, 0, 0, pool);
+
+      for (i = 0; i < written->nelts; ++i)
+        {
+          cb = APR_ARRAY_IDX(written, i, struct commit_baton *);
+          if (err)
+            {
+              fs_fs_data_t *member_ffd = cb->fs->fsap_data;
+              member_ffd->youngest_rev_cache = old_rev;
+              cb->err = svn_error_dup(err);
+            }
+          else
+            {
+              cb->err = finalize_new_revision(cb, cb->pool);
+            }
+        }
+
+      svn_error_clear(err);
+    }
+
+  /* Wake up the members. */
+  svn_error_clear(svn_mutex__lock(queue->mutex));
+  for (cb = members; cb; cb = cb->next)
+    cb->done = TRUE;
+  apr_thread_cond_broadcast(queue->changed);
+  svn_error_clear(svn_mutex__unlock(queue->mutex, SVN_NO_ERROR));
+
+  return SVN_NO_ERROR;
+}
 
-      SVN_ERR(svn_fs_fs__set_rep_reference(fs, rep, scratch_pool));
+/* Queue CB in QUEUE and wait for it to be committed as part of a group
+   commit.  If no group commit is in progress, run it ourselves.
+   Use POOL for temporaries. */
+static svn_error_t *
+commit_grouped(struct commit_baton *cb,
+               fs_fs_commit_queue_t *queue,
+               apr_pool_t *pool)
+{
+  SVN_ERR(svn_mutex__lock(queue->mutex));
+
+  cb->next = NULL;
+  *queue->last_next = cb;
+  queue->last_next = &cb->next;
+
+  /* CB must not leave this loop while still being queued. */
+  while (!cb->done)
+    {
+      if (queue->busy)
+        {
+          apr_thread_cond_wait(queue->changed, svn_mutex__get(queue->mutex));
+        }
+      else
+        {
+          svn_error_t *err;
+
+          /* We have to run the next group commit ourselves. */
+          queue->busy = TRUE;
+          svn_error_clear(svn_mutex__unlock(queue->mutex, SVN_NO_ERROR));
+
+          err = svn_fs_fs__with_write_lock(cb->fs, group_commit_body, cb,
+                                           pool);
+
+          svn_error_clear(svn_mutex__lock(queue->mutex));
+          queue->busy = FALSE;
+          apr_thread_cond_broadcast(queue->changed);
+
+          if (err && cb->done)
+            {
+              cb->err = svn_error_compose_create(cb->err, err);
+            }
+          else if (err)
+            {
+              /* The group commit did not even start.  Leave the queue. */
+              struct commit_baton **link = &queue->first;
+              while (*link != cb)
+                link = &(*link)->next;
+
+              *link = cb->next;
+              if (queue->last_next == &cb->next)
+                queue->last_next = link;
+
+              cb->err = err;
+              cb->done = TRUE;
+            }
+        }
     }
 
+  svn_error_clear(svn_mutex__unlock(queue->mutex, SVN_NO_ERROR));
+
+  return svn_error_trace(cb->err);
+}
+
+#endif
+
+svn_error_t *
+svn_fs_fs__create_commit_queue(fs_fs_commit_queue_t **queue,
+                               apr_pool_t *result_pool)
+{
+#if APR_HAS_THREADS
+  fs_fs_commit_queue_t *new_queue = apr_pcalloc(result_pool,
+                                                sizeof(*new_queue));
+  apr_status_t status;
+
+  new_queue->last_next = &new_queue->first;
+  SVN_ERR(svn_mutex__init(&new_queue->mutex, TRUE, result_pool));
+
+  status = apr_thread_cond_create(&new_queue->changed, result_pool);
+  if (status)
+    return svn_error_wrap_apr(status, _("Can't create condition variable"));
+
+  *queue = new_queue;
+#else
+  *queue = NULL;
+#endif
+
   return SVN_NO_ERROR;
 }
 
@@ -3958,14 +5659,27 @@ svn_error_t *
 svn_fs_fs__commit(svn_revnum_t *new_rev_p,
                   svn_fs_t *fs,
                   svn_fs_txn_t *txn,
+                  svn_fs_fs__commit_rebase_t rebase_func,
+                  void *rebase_baton,
                   apr_pool_t *pool)
 {
   struct commit_baton cb;
   fs_fs_data_t *ffd = fs->fsap_data;
+  svn_error_t *err;
+  apr_time_t start;
 
   cb.new_rev_p = new_rev_p;
   cb.fs = fs;
   cb.txn = txn;
+  cb.flush_to_disk = ffd->flush_to_disk;
+  cb.rebase_func = rebase_func;
+  cb.rebase_baton = rebase_baton;
+  cb.pool = pool;
+  cb.err = SVN_NO_ERROR;
+  cb.done = FALSE;
+  cb.next = NULL;
+  cb.timing = &fs->commit_timing;
+  cb.lock_requested = 0;
 
   if (ffd->rep_sharing_allowed)
     {
@@ -3980,40 +5694,71 @@ svn_fs_fs__commit(svn_revnum_t *new_rev_p,
       cb.reps_pool = NULL;
     }
 
-  SVN_ERR(svn_fs_fs__with_write_lock(fs, commit_body, &cb, pool));
+  cb.changed_paths = NULL;
+  cb.written = FALSE;
+
+  /* Most of the commit work does not depend on the other commits that
+     may be going on in parallel, as long as the txn will become the
+     revision following its base revision.  Do that work before getting
+     the write lock and only re-do it in the rare case that we guessed
+     wrong.  This is not possible for old formats that use global node
+     and copy IDs. */
+  SVN_ERR(svn_fs_fs__read_format_file(fs, pool));
+
+#if APR_HAS_THREADS
+  /* With group commits, members of the same group depend on each other
+     and get written with the write lock held.  All of them are flushed
+     to disk by a common barrier instead of one by one.  See
+     flush_group(). */
+  if (   rebase_func
+      && ffd->group_commit
+      && ffd->flush_to_disk
+      && ffd->format >= SVN_FS_FS__MIN_NO_GLOBAL_IDS_FORMAT)
+    {
+#ifdef SVN_ON_POSIX
+      cb.flush_to_disk = FALSE;
+#endif
+      /* The group leader writes all members, so we can only tell how
+         long the whole group commit took. */
+      cb.timing = NULL;
+      start = svn_fs__timing_start(&fs->commit_timing);
+      err = commit_grouped(&cb, ffd->shared->commit_queue, pool);
+      svn_fs__timing_phase(&fs->commit_timing, "group-commit", start, pool);
+    }
+  else
+#endif
+    {
+      if (ffd->format >= SVN_FS_FS__MIN_NO_GLOBAL_IDS_FORMAT)
+        {
+          start = svn_fs__timing_start(cb.timing);
+          err = write_final_rev_data(&cb, txn->base_rev + 1, 0, 0, pool);
+          svn_fs__timing_phase(cb.timing, "prepare", start, pool);
+        }
+      else
+        err = SVN_NO_ERROR;
+
+      cb.lock_requested = svn_fs__timing_start(cb.timing);
+      if (!err)
+        err = svn_fs_fs__with_write_lock(fs, commit_body, &cb, pool);
+    }
+
+  /* If the revision data has not been committed, restore the txn to its
+     previous state such that it may be committed again - possibly after
+     being rebased by our caller. */
+  if (err && cb.written)
+    err = svn_error_compose_create(err, revert_final_rev_data(&cb, pool));
+  SVN_ERR(err);
 
   /* At this point, *NEW_REV_P has been set, so errors below won't affect
      the success of the commit.  (See svn_fs_commit_txn().)  */
 
   if (ffd->rep_sharing_allowed)
     {
-      svn_error_t *err;
-
-      SVN_ERR(svn_fs_fs__open_rep_cache(fs, pool));
-
-      /* Write new entries to the rep-sharing database.
-       *
-       * We use an sqlite transaction to speed things up;
-       * see <http://www.sqlite.org/faq.html#q19>.
-       */
-      /* ### A commit that touches thousands of files will starve other
-             (reader/writer) commits for the duration of the below call.
-             Maybe write in batches? */
-      SVN_ERR(svn_sqlite__begin_transaction(ffd->rep_cache_db));
-      err = write_reps_to_cache(fs, cb.reps_to_cache, pool);
-      err = svn_sqlite__finish_transaction(ffd->rep_cache_db, err);
-
-      if (svn_error_find_cause(err, SVN_ERR_SQLITE_ROLLBACK_FAILED))
-        {
-          /* Failed rollback means that our db connection is unusable, and
-             the only thing we can do is close it.  The connection will be
-             reopened during the next operation with rep-cache.db. */
-          return svn_error_trace(
-              svn_error_compose_create(err,
-                                       svn_fs_fs__close_rep_cache(fs)));
-        }
-      else if (err)
-        return svn_error_trace(err);
+      /* Write new entries to the rep-sharing database or queue them
+         for a later batch write, depending on the configuration. */
+      start = svn_fs__timing_start(&fs->commit_timing);
+      SVN_ERR(svn_fs_fs__add_rep_references(fs, cb.reps_to_cache, pool));
+      svn_fs__timing_phase(&fs->commit_timing, "rep-cache", start, pool);
     }
 
   return SVN_NO_ERROR;
@@ -4124,6 +5869,8 @@ svn_fs_fs__delete_node_revision(svn_fs_t *fs,
                                 apr_pool_t *pool)
 {
   node_revision_t *noderev;
+  const char *path = svn_fs_fs__path_txn_node_rev(fs, id, pool);
+  svn_boolean_t staged;
 
   SVN_ERR(svn_fs_fs__get_node_revision(&noderev, fs, id, pool, pool));
 
@@ -4149,8 +5896,12 @@ svn_fs_fs__delete_node_revision(svn_fs_t *fs,
         }
     }
 
-  return svn_io_remove_file2(svn_fs_fs__path_txn_node_rev(fs, id, pool),
-                             FALSE, pool);
+  SVN_ERR(stage_txn_file(&staged, fs, svn_fs_fs__id_txn_id(id), path, NULL,
+                         FALSE, pool));
+  if (staged)
+    return SVN_NO_ERROR;
+
+  return svn_io_remove_file2(path, FALSE, pool);
 }
 
 
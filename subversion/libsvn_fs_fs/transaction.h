@@ -82,6 +82,26 @@ svn_fs_fs__change_txn_props(svn_fs_txn_t *txn,
                             const apr_array_header_t *props,
                             apr_pool_t *pool);
 
+/* Write all data of transaction TXN that is being staged in memory to
+   its directory on disk, such that other processes can access it.
+   Perform temporary allocations from SCRATCH_POOL. */
+svn_error_t *
+svn_fs_fs__flush_txn(svn_fs_txn_t *txn,
+                     apr_pool_t *scratch_pool);
+
+/* If transaction TXN_ID in FS is being staged in memory, set *STAGED to
+   TRUE and *CONTENTS to a copy of the staged file at PATH, allocated in
+   RESULT_POOL, or to NULL if there is no such file.  Otherwise, set
+   *STAGED to FALSE and leave *CONTENTS untouched; the file can then be
+   read from disk. */
+svn_error_t *
+svn_fs_fs__read_staged_txn_file(svn_boolean_t *staged,
+                                svn_stringbuf_t **contents,
+                                svn_fs_t *fs,
+                                const svn_fs_fs__id_part_t *txn_id,
+                                const char *path,
+                                apr_pool_t *result_pool);
+
 /* Store a transaction record in *TXN_P for the transaction identified
    by TXN_ID in filesystem FS.  Allocate everything from POOL. */
 svn_error_t *
@@ -167,6 +187,30 @@ svn_fs_fs__set_contents(svn_stream_t **stream,
                         node_revision_t *noderev,
                         apr_pool_t *pool);
 
+/* Look up an existing representation in FS whose fulltext has the SHA-1
+   checksum SHA1_CHECKSUM and return it in *REP_P, allocated in
+   RESULT_POOL.  The fulltext is read and its SHA-1 verified, so a stale or
+   corrupt rep-cache entry will not be returned; its MD5 checksum is filled
+   in from that read.  Set *REP_P to NULL if rep sharing is disabled for
+   FS or no suitable representation exists.  Use SCRATCH_POOL for
+   temporary allocations. */
+svn_error_t *
+svn_fs_fs__find_rep_by_sha1(representation_t **rep_p,
+                            svn_fs_t *fs,
+                            const svn_checksum_t *sha1_checksum,
+                            apr_pool_t *result_pool,
+                            apr_pool_t *scratch_pool);
+
+/* Make the existing representation REP, as returned by
+   svn_fs_fs__find_rep_by_sha1(), the text representation of the mutable
+   file node-revision NODEREV in filesystem FS and write NODEREV to the
+   transaction.  Use POOL for temporary allocations. */
+svn_error_t *
+svn_fs_fs__set_shared_contents(svn_fs_t *fs,
+                               node_revision_t *noderev,
+                               representation_t *rep,
+                               apr_pool_t *pool);
+
 /* Create a node revision in FS which is an immediate successor of
    OLD_ID, whose contents are NEW_NR.  Set *NEW_ID_P to the new node
    revision's ID.  Use POOL for any temporary allocation.
@@ -210,16 +254,42 @@ svn_fs_fs__add_index_data(svn_fs_t *fs,
                           svn_revnum_t revision,
                           apr_pool_t *pool);
 
+/* Callback type used by svn_fs_fs__commit() to merge the changes
+   between TXN's base revision and the revision YOUNGEST into TXN and to
+   make YOUNGEST the new base revision of TXN.  BATON is the REBASE_BATON
+   given to svn_fs_fs__commit().  Use SCRATCH_POOL for temporaries. */
+typedef svn_error_t *
+(*svn_fs_fs__commit_rebase_t)(void *baton,
+                              svn_fs_txn_t *txn,
+                              svn_revnum_t youngest,
+                              apr_pool_t *scratch_pool);
+
 /* Commit the transaction TXN in filesystem FS and return its new
    revision number in *REV.  If the transaction is out of date, return
    the error SVN_ERR_FS_TXN_OUT_OF_DATE. Use POOL for temporary
-   allocations. */
+   allocations.
+
+   If REBASE_FUNC is not NULL and FS has been configured to use group
+   commits, TXN may be committed together with concurrent commits made
+   through the same process.  REBASE_FUNC and REBASE_BATON will then be
+   used to bring TXN up to date with the revisions committed before it
+   in the same group.  Note that they may be called from another thread
+   while the calling thread is blocked in this function. */
 svn_error_t *
 svn_fs_fs__commit(svn_revnum_t *new_rev_p,
                   svn_fs_t *fs,
                   svn_fs_txn_t *txn,
+                  svn_fs_fs__commit_rebase_t rebase_func,
+                  void *rebase_baton,
                   apr_pool_t *pool);
 
+/* Allocate an empty commit queue for group commits in *QUEUE, using
+   RESULT_POOL.  Set *QUEUE to NULL if APR has been built without thread
+   support. */
+svn_error_t *
+svn_fs_fs__create_commit_queue(fs_fs_commit_queue_t **queue,
+                               apr_pool_t *result_pool);
+
 /* Set *NAMES_P to an array of names which are all the active
    transactions in filesystem FS.  Allocate the array from POOL. */
 svn_error_t *
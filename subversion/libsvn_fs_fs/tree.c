@@ -67,6 +67,7 @@
 #include "private/svn_subr_private.h"
 #include "private/svn_fs_util.h"
 #include "private/svn_fspath.h"
+#include "private/svn_mutex.h"
 #include "../libsvn_fs/fs-loader.h"
 
 
@@ -386,6 +387,193 @@ cache_lookup_last_path(fs_fs_dag_cache_t *cache,
   return NULL;
 }
 
+/* Process-wide cache */
+
+/* Number of entries in the shared cache.  It holds the union of the hot
+   paths of all svn_fs_t instances of the same repository, i.e. of all
+   server connections, so it needs to be larger than the 1st level cache.
+   Entries carry their node revisions, which limits the memory use to a
+   few MB per repository.
+ */
+enum { SHARED_BUCKET_COUNT = 2048 };
+
+/* The DAG node cache shared by all svn_fs_t instances of a repository.
+   Only immutable nodes from revision roots will be stored here.  They are
+   allocated in POOL, belong to no particular FS and get copied in and out
+   of the cache.  Any access requires MUTEX to be held.
+ */
+struct fs_fs_shared_dag_cache_t
+{
+  /* fixed number of (possibly empty) cache entries */
+  cache_entry_t buckets[SHARED_BUCKET_COUNT];
+
+  /* pool used for all node allocation */
+  apr_pool_t *pool;
+
+  /* number of entries created from POOL since the last cleanup */
+  apr_size_t insertions;
+
+  /* serializes all access to the members above */
+  svn_mutex__t *mutex;
+};
+
+svn_error_t *
+svn_fs_fs__create_shared_dag_cache(fs_fs_shared_dag_cache_t **cache,
+                                   apr_pool_t *result_pool)
+{
+  fs_fs_shared_dag_cache_t *result = apr_pcalloc(result_pool,
+                                                 sizeof(*result));
+  result->pool = svn_pool_create(result_pool);
+  SVN_ERR(svn_mutex__init(&result->mutex, TRUE, result_pool));
+
+  *cache = result;
+
+  return SVN_NO_ERROR;
+}
+
+/* Return the bucket in the shared CACHE to use for HASH_VALUE. */
+static cache_entry_t *
+shared_cache_bucket(fs_fs_shared_dag_cache_t *cache,
+                    apr_uint32_t hash_value)
+{
+  apr_size_t bucket_index = hash_value + (hash_value >> 16);
+  bucket_index = (bucket_index + (bucket_index >> 8)) % SHARED_BUCKET_COUNT;
+
+  return &cache->buckets[bucket_index];
+}
+
+/* Return TRUE if ENTRY contains a node for REVISION and PATH of PATH_LEN
+   chars, which hash to HASH_VALUE. */
+static svn_boolean_t
+shared_entry_matches(const cache_entry_t *entry,
+                     apr_uint32_t hash_value,
+                     svn_revnum_t revision,
+                     const char *path,
+                     apr_size_t path_len)
+{
+  return entry->node
+      && (entry->hash_value == hash_value)
+      && (entry->revision == revision)
+      && (entry->path_len == path_len)
+      && !memcmp(entry->path, path, path_len);
+}
+
+/* Body of shared_cache_lookup.  CACHE->MUTEX must be held. */
+static svn_error_t *
+shared_cache_lookup_body(dag_node_t **node_p,
+                         fs_fs_shared_dag_cache_t *cache,
+                         apr_uint32_t hash_value,
+                         svn_revnum_t revision,
+                         const char *path,
+                         apr_size_t path_len,
+                         apr_pool_t *result_pool)
+{
+  cache_entry_t *entry = shared_cache_bucket(cache, hash_value);
+
+  if (shared_entry_matches(entry, hash_value, revision, path, path_len))
+    *node_p = svn_fs_fs__dag_dup(entry->node, result_pool);
+  else
+    *node_p = NULL;
+
+  return SVN_NO_ERROR;
+}
+
+/* For the given REVISION and PATH, return a copy of the respective node
+ * found in the shared CACHE in *NODE_P, allocated in RESULT_POOL.  The
+ * node's FS will not be set.  Set *NODE_P to NULL if there is none.
+ */
+static svn_error_t *
+shared_cache_lookup(dag_node_t **node_p,
+                    fs_fs_shared_dag_cache_t *cache,
+                    svn_revnum_t revision,
+                    const char *path,
+                    apr_pool_t *result_pool)
+{
+  apr_size_t path_len = strlen(path);
+  apr_uint32_t hash_value = hash_func(revision, path, path_len);
+
+  SVN_MUTEX__WITH_LOCK(cache->mutex,
+                       shared_cache_lookup_body(node_p, cache, hash_value,
+                                                revision, path, path_len,
+                                                result_pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Body of shared_cache_insert.  CACHE->MUTEX must be held. */
+static svn_error_t *
+shared_cache_insert_body(fs_fs_shared_dag_cache_t *cache,
+                         apr_uint32_t hash_value,
+                         svn_revnum_t revision,
+                         const char *path,
+                         apr_size_t path_len,
+                         dag_node_t *node)
+{
+  cache_entry_t *entry;
+
+  /* Clear the cache at regular intervals to limit its memory usage. */
+  if (cache->insertions > SHARED_BUCKET_COUNT)
+    {
+      svn_pool_clear(cache->pool);
+
+      memset(cache->buckets, 0, sizeof(cache->buckets));
+      cache->insertions = 0;
+    }
+
+  /* Another svn_fs_t may have beaten us to it.  Nodes from the same
+     location are identical, so there is nothing left to do then. */
+  entry = shared_cache_bucket(cache, hash_value);
+  if (shared_entry_matches(entry, hash_value, revision, path, path_len))
+    return SVN_NO_ERROR;
+
+  entry->hash_value = hash_value;
+  entry->revision = revision;
+  if (entry->path_len < path_len)
+    entry->path = apr_palloc(cache->pool, path_len + 1);
+  entry->path_len = path_len;
+  memcpy(entry->path, path, path_len + 1);
+
+  /* The node may outlive the svn_fs_t it came from. */
+  entry->node = svn_fs_fs__dag_dup(node, cache->pool);
+  svn_fs_fs__dag_set_fs(entry->node, NULL);
+  cache->insertions++;
+
+  return SVN_NO_ERROR;
+}
+
+/* Store a copy of the immutable NODE in the shared CACHE, taking REVISION
+ * and PATH as key.  This function will clean the cache at regular
+ * intervals.
+ */
+static svn_error_t *
+shared_cache_insert(fs_fs_shared_dag_cache_t *cache,
+                    svn_revnum_t revision,
+                    const char *path,
+                    dag_node_t *node)
+{
+  apr_size_t path_len = strlen(path);
+  apr_uint32_t hash_value = hash_func(revision, path, path_len);
+
+  SVN_MUTEX__WITH_LOCK(cache->mutex,
+                       shared_cache_insert_body(cache, hash_value, revision,
+                                                path, path_len, node));
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_fs_fs__shared_dag_cache_lookup(dag_node_t **node_p,
+                                   svn_fs_t *fs,
+                                   svn_revnum_t revision,
+                                   const char *path,
+                                   apr_pool_t *result_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+
+  return svn_error_trace(shared_cache_lookup(node_p, ffd->shared->dag_cache,
+                                             revision, path, result_pool));
+}
+
 /* 2nd level cache */
 
 /* Find and return the DAG node cache for ROOT and the key that
@@ -443,9 +631,20 @@ dag_node_cache_get(dag_node_t **node_p,
       node = cache_lookup(ffd->dag_node_cache, root->rev, path);
       if (node == NULL)
         {
-          locate_cache(&cache, &key, root, path, pool);
-          SVN_ERR(svn_cache__get((void **)&node, &found, cache, key, pool));
-          if (found && node)
+          /* Some other connection to this repository may have seen it. */
+          SVN_ERR(shared_cache_lookup(&node, ffd->shared->dag_cache,
+                                      root->rev, path, pool));
+          if (node == NULL)
+            {
+              locate_cache(&cache, &key, root, path, pool);
+              SVN_ERR(svn_cache__get((void **)&node, &found, cache, key,
+                                     pool));
+              if (found && node)
+                SVN_ERR(shared_cache_insert(ffd->shared->dag_cache,
+                                            root->rev, path, node));
+            }
+
+          if (node)
             {
               /* Patch up the FS, since this might have come from an old FS
                * object. */
@@ -494,6 +693,14 @@ dag_node_cache_set(svn_fs_root_t *root,
 
   SVN_ERR_ASSERT(*path == '/');
 
+  /* Immutable nodes become visible to all connections to the repository. */
+  if (!root->is_txn_root)
+    {
+      fs_fs_data_t *ffd = root->fs->fsap_data;
+      SVN_ERR(shared_cache_insert(ffd->shared->dag_cache, root->rev, path,
+                                  node));
+    }
+
   locate_cache(&cache, &key, root, path, pool);
   return svn_cache__set(cache, key, node, pool);
 }
@@ -2197,6 +2404,29 @@ merge_changes(dag_node_t *ancestor_node,
 }
 
 
+/* Implements svn_fs_fs__commit_rebase_t for group commits.  BATON is
+   the svn_stringbuf_t to receive the conflicting path like the CONFLICT
+   argument of merge_changes(). */
+static svn_error_t *
+rebase_txn(void *baton,
+           svn_fs_txn_t *txn,
+           svn_revnum_t youngest,
+           apr_pool_t *scratch_pool)
+{
+  svn_stringbuf_t *conflict = baton;
+  svn_fs_root_t *youngest_root;
+  dag_node_t *youngest_root_node;
+
+  SVN_ERR(svn_fs_fs__revision_root(&youngest_root, txn->fs, youngest,
+                                   scratch_pool));
+  SVN_ERR(get_root(&youngest_root_node, youngest_root, scratch_pool));
+  SVN_ERR(merge_changes(NULL, youngest_root_node, txn, conflict,
+                        scratch_pool));
+  txn->base_rev = youngest;
+
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *
 svn_fs_fs__commit_txn(const char **conflict_p,
                       svn_revnum_t *new_rev,
@@ -2264,6 +2494,7 @@ svn_fs_fs__commit_txn(const char **conflict_p,
       svn_revnum_t youngish_rev;
       svn_fs_root_t *youngish_root;
       dag_node_t *youngish_root_node;
+      apr_time_t start;
 
       svn_pool_clear(iterpool);
 
@@ -2288,7 +2519,9 @@ svn_fs_fs__commit_txn(const char **conflict_p,
          TARGET's txn will become the same as youngish_root_node, so
          any future merges will only be between that node and whatever
          the root node of the youngest rev is by then. */
+      start = svn_fs__timing_start(&fs->commit_timing);
       err = merge_changes(NULL, youngish_root_node, txn, conflict, iterpool);
+      svn_fs__timing_phase(&fs->commit_timing, "merge", start, iterpool);
       if (err)
         {
           if ((err->apr_err == SVN_ERR_FS_CONFLICT) && conflict_p)
@@ -2298,7 +2531,8 @@ svn_fs_fs__commit_txn(const char **conflict_p,
       txn->base_rev = youngish_rev;
 
       /* Try to commit. */
-      err = svn_fs_fs__commit(new_rev, fs, txn, iterpool);
+      err = svn_fs_fs__commit(new_rev, fs, txn, rebase_txn, conflict,
+                              iterpool);
       if (err && (err->apr_err == SVN_ERR_FS_TXN_OUT_OF_DATE))
         {
           /* Did someone else finish committing a new revision while we
@@ -2315,6 +2549,9 @@ svn_fs_fs__commit_txn(const char **conflict_p,
         }
       else if (err)
         {
+          /* Group commits may have to merge again. */
+          if ((err->apr_err == SVN_ERR_FS_CONFLICT) && conflict_p)
+            *conflict_p = conflict->data;
           goto cleanup;
         }
       else
@@ -2334,7 +2571,8 @@ svn_fs_fs__commit_txn(const char **conflict_p,
 
   if (ffd->pack_after_commit)
     {
-      SVN_ERR(svn_fs_fs__pack(fs, 0, NULL, NULL, NULL, NULL, pool));
+      SVN_ERR(svn_fs_fs__pack(fs, 0, NULL, NULL, NULL, NULL, NULL, NULL,
+                              pool));
     }
 
   return SVN_NO_ERROR;
@@ -3218,6 +3456,54 @@ fs_apply_text(svn_stream_t **contents_p,
 /* --- End machinery for svn_fs_apply_text() ---  */
 
 
+/* Set *APPLIED and, if possible, make the existing fulltext with SHA-1
+   checksum SHA1_CHECKSUM the contents of PATH under ROOT.  This
+   implements svn_fs_apply_text_by_checksum().  Temporary allocations
+   are in POOL. */
+static svn_error_t *
+fs_apply_text_by_checksum(svn_boolean_t *applied,
+                          svn_fs_root_t *root,
+                          const char *path,
+                          const svn_checksum_t *sha1_checksum,
+                          apr_pool_t *pool)
+{
+  parent_path_t *parent_path;
+  representation_t *rep;
+  const svn_fs_fs__id_part_t *txn_id = root_txn_id(root);
+
+  path = svn_fs__canonicalize_abspath(path, pool);
+
+  /* Call open_path with no flags, as we want this to return an error
+     if the node for which we are searching doesn't exist. */
+  SVN_ERR(open_path(&parent_path, root, path, 0, TRUE, pool));
+
+  /* Find out whether we have that text before touching the txn. */
+  SVN_ERR(svn_fs_fs__find_rep_by_sha1(&rep, root->fs, sha1_checksum,
+                                      pool, pool));
+  if (!rep)
+    {
+      *applied = FALSE;
+      return SVN_NO_ERROR;
+    }
+
+  /* From here on, same sequence as in apply_text(). */
+  if (root->txn_flags & SVN_FS_TXN_CHECK_LOCKS)
+    SVN_ERR(svn_fs_fs__allow_locked_operation(path, root->fs,
+                                              FALSE, FALSE, pool));
+
+  SVN_ERR(make_path_mutable(root, parent_path, path, pool));
+  SVN_ERR(svn_fs_fs__dag_set_shared_contents(parent_path->node, rep, pool));
+
+  SVN_ERR(add_change(root->fs, txn_id, path,
+                     svn_fs_fs__dag_get_id(parent_path->node),
+                     svn_fs_path_change_modify, TRUE, FALSE, FALSE,
+                     svn_node_file, SVN_INVALID_REVNUM, NULL, pool));
+
+  *applied = TRUE;
+  return SVN_NO_ERROR;
+}
+
+
 /* Check if the contents of PATH1 under ROOT1 are different from the
    contents of PATH2 under ROOT2.  If they are different set
    *CHANGED_P to TRUE, otherwise set it to FALSE. */
@@ -3279,6 +3565,31 @@ fs_get_file_delta_stream(svn_txdelta_stream_t **stream_p,
                                               target_node, pool);
 }
 
+/* Implement root_vtable_t.get_stored_delta for FSFS. */
+static svn_error_t *
+fs_get_stored_delta(svn_stream_t **svndiff_p,
+                    svn_filesize_t *len_p,
+                    svn_fs_root_t *source_root,
+                    const char *source_path,
+                    svn_fs_root_t *target_root,
+                    const char *target_path,
+                    int max_version,
+                    apr_pool_t *result_pool,
+                    apr_pool_t *scratch_pool)
+{
+  dag_node_t *source_node, *target_node;
+
+  SVN_ERR(get_dag(&source_node, source_root, source_path, scratch_pool));
+  SVN_ERR(get_dag(&target_node, target_root, target_path, scratch_pool));
+
+  return svn_error_trace(svn_fs_fs__dag_get_stored_delta(svndiff_p, len_p,
+                                                         source_node,
+                                                         target_node,
+                                                         max_version,
+                                                         result_pool,
+                                                         scratch_pool));
+}
+
 
 
 /* Finding Changes */
@@ -3430,6 +3741,51 @@ static changes_iterator_vtable_t rev_changes_iterator_vtable =
   fs_revision_changes_iterator_get
 };
 
+/* Initialize RESULT as an iterator over the changes of revision REV in
+ * FS.  If REVISION_FILE is not NULL, read the changes from it; it must
+ * remain open while RESULT is in use.  Allocate the iterator data in
+ * RESULT_POOL and use SCRATCH_POOL for temporaries.
+ */
+static svn_error_t *
+init_rev_changes_iterator(svn_fs_path_change_iterator_t *result,
+                          svn_fs_t *fs,
+                          svn_revnum_t rev,
+                          svn_fs_fs__revision_file_t *revision_file,
+                          apr_pool_t *result_pool,
+                          apr_pool_t *scratch_pool)
+{
+  /* The block of changes that we retrieve need to live in a separately
+     cleanable pool. */
+  apr_pool_t *changes_pool = svn_pool_create(result_pool);
+
+  /* Our iteration context info. */
+  fs_revision_changes_iterator_data_t *data = apr_pcalloc(result_pool,
+                                                          sizeof(*data));
+
+  /* This pool must remain valid as long as ITERATOR lives but will
+     be used only for temporary allocations and will be cleaned up
+     frequently.  So, this must be a sub-pool of RESULT_POOL. */
+  data->scratch_pool = svn_pool_create(result_pool);
+
+  /* Fetch the first block of data. */
+  SVN_ERR(svn_fs_fs__create_changes_context(&data->context, fs, rev,
+                                            result_pool));
+  if (revision_file)
+    {
+      data->context->revision_file = revision_file;
+      data->context->keep_revision_file = TRUE;
+    }
+
+  SVN_ERR(svn_fs_fs__get_changes(&data->changes, data->context,
+                                 changes_pool, scratch_pool));
+
+  /* Return the fully initialized object. */
+  result->fsap_data = data;
+  result->vtable = &rev_changes_iterator_vtable;
+
+  return SVN_NO_ERROR;
+}
+
 static svn_error_t *
 fs_report_changes(svn_fs_path_change_iterator_t **iterator,
                   svn_fs_root_t *root,
@@ -3452,29 +3808,8 @@ fs_report_changes(svn_fs_path_change_iterator_t **iterator,
     }
   else
     {
-      /* The block of changes that we retrieve need to live in a separately
-         cleanable pool. */
-      apr_pool_t *changes_pool = svn_pool_create(result_pool);
-
-      /* Our iteration context info. */
-      fs_revision_changes_iterator_data_t *data = apr_pcalloc(result_pool,
-                                                              sizeof(*data));
-
-      /* This pool must remain valid as long as ITERATOR lives but will
-         be used only for temporary allocations and will be cleaned up
-         frequently.  So, this must be a sub-pool of RESULT_POOL. */
-      data->scratch_pool = svn_pool_create(result_pool);
-
-      /* Fetch the first block of data. */
-      SVN_ERR(svn_fs_fs__create_changes_context(&data->context,
-                                                root->fs, root->rev,
-                                                result_pool));
-      SVN_ERR(svn_fs_fs__get_changes(&data->changes, data->context,
-                                     changes_pool, scratch_pool));
-
-      /* Return the fully initialized object. */
-      result->fsap_data = data;
-      result->vtable = &rev_changes_iterator_vtable;
+      SVN_ERR(init_rev_changes_iterator(result, root->fs, root->rev, NULL,
+                                        result_pool, scratch_pool));
     }
 
   *iterator = result;
@@ -3482,6 +3817,67 @@ fs_report_changes(svn_fs_path_change_iterator_t **iterator,
   return SVN_NO_ERROR;
 }
 
+svn_error_t *
+svn_fs_fs__paths_changed_range(svn_fs_t *fs,
+                               svn_revnum_t start,
+                               svn_revnum_t end,
+                               svn_fs_paths_changed_receiver_t receiver,
+                               void *receiver_baton,
+                               svn_cancel_func_t cancel_func,
+                               void *cancel_baton,
+                               apr_pool_t *scratch_pool)
+{
+  svn_fs_fs__revision_file_t *pack_file = NULL;
+  apr_pool_t *pack_pool = svn_pool_create(scratch_pool);
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  svn_revnum_t rev;
+
+  SVN_ERR(svn_fs_fs__ensure_revision_exists(start > end ? start : end, fs,
+                                            iterpool));
+
+  for (rev = start; ; rev += (start <= end) ? 1 : -1)
+    {
+      svn_fs_path_change_iterator_t iterator = { 0 };
+
+      svn_pool_clear(iterpool);
+      if (cancel_func)
+        SVN_ERR(cancel_func(cancel_baton));
+
+      /* All revisions in a pack file share the same open file.  With
+       * log addressing, their change lists are even stored next to each
+       * other (newest first), so block-read will fetch them in a single
+       * sequential pass and serve most revisions from the cache. */
+      if (pack_file
+          && (   !svn_fs_fs__is_packed_rev(fs, rev)
+              || pack_file->start_revision
+                   != svn_fs_fs__packed_base_rev(fs, rev)))
+        {
+          SVN_ERR(svn_fs_fs__close_revision_file(pack_file));
+          svn_pool_clear(pack_pool);
+          pack_file = NULL;
+        }
+
+      if (!pack_file && svn_fs_fs__is_packed_rev(fs, rev))
+        SVN_ERR(svn_fs_fs__open_pack_or_rev_file(&pack_file, fs, rev,
+                                                 pack_pool, iterpool));
+
+      SVN_ERR(init_rev_changes_iterator(&iterator, fs, rev, pack_file,
+                                        iterpool, iterpool));
+      SVN_ERR(receiver(receiver_baton, rev, &iterator, iterpool));
+
+      if (rev == end)
+        break;
+    }
+
+  if (pack_file)
+    SVN_ERR(svn_fs_fs__close_revision_file(pack_file));
+
+  svn_pool_destroy(iterpool);
+  svn_pool_destroy(pack_pool);
+
+  return SVN_NO_ERROR;
+}
+
 
 /* Our coolio opaque history object. */
 typedef struct fs_history_data_t
@@ -3760,7 +4156,7 @@ fs_node_origin_rev(svn_revnum_t *revision,
     apr_pool_t *predidpool = svn_pool_create(pool);
     svn_stringbuf_t *lastpath = svn_stringbuf_create(path, pool);
     svn_revnum_t lastrev = SVN_INVALID_REVNUM;
-    dag_node_t *node;
+    node_revision_t *noderev;
     const svn_fs_id_t *pred_id;
 
     /* Walk the closest-copy chain back to the first copy in our history.
@@ -3793,33 +4189,21 @@ fs_node_origin_rev(svn_revnum_t *revision,
         lastrev = currev;
       }
 
-    /* Walk the predecessor links back to origin. */
+    /* Walk the predecessor links back to origin, i.e. to the first
+       node-revision in our chain.  Skip-list pointers shorten that walk
+       where available. */
+    svn_pool_clear(subpool);
     SVN_ERR(svn_fs_fs__node_id(&pred_id, curroot, lastpath->data, predidpool));
-    do
-      {
-        svn_pool_clear(subpool);
-        SVN_ERR(svn_fs_fs__dag_get_node(&node, fs, pred_id, subpool));
-
-        /* Why not just fetch the predecessor ID in PREDIDPOOL?
-           Because svn_fs_fs__dag_get_predecessor_id() doesn't
-           necessarily honor the passed-in pool, and might return a
-           value cached in the node (which is allocated in
-           SUBPOOL... maybe). */
-        svn_pool_clear(predidpool);
-        SVN_ERR(svn_fs_fs__dag_get_predecessor_id(&pred_id, node));
-        pred_id = pred_id ? svn_fs_fs__id_copy(pred_id, predidpool) : NULL;
-      }
-    while (pred_id);
-
-    /* When we get here, NODE should be the first node-revision in our
-       chain. */
-    SVN_ERR(svn_fs_fs__dag_get_revision(revision, node, pool));
+    SVN_ERR(svn_fs_fs__get_node_revision(&noderev, fs, pred_id, pool,
+                                         subpool));
+    SVN_ERR(svn_fs_fs__get_ancestor(&noderev, fs, noderev, 0, pool,
+                                    subpool));
+    *revision = svn_fs_fs__id_rev(noderev->id);
 
     /* Wow, I don't want to have to do all that again.  Let's cache
        the result. */
     if (node_id->revision != SVN_INVALID_REVNUM)
-      SVN_ERR(svn_fs_fs__set_node_origin(fs, node_id,
-                                         svn_fs_fs__dag_get_id(node), pool));
+      SVN_ERR(svn_fs_fs__set_node_origin(fs, node_id, noderev->id, pool));
 
     svn_pool_destroy(subpool);
     svn_pool_destroy(predidpool);
@@ -4180,35 +4564,29 @@ crawl_directory_dag_for_mergeinfo(svn_fs_root_t *root,
       if (has_mergeinfo)
         {
           /* Save this particular node's mergeinfo. */
-          apr_hash_t *proplist;
           svn_mergeinfo_t kid_mergeinfo;
-          svn_string_t *mergeinfo_string;
           svn_error_t *err;
 
-          SVN_ERR(svn_fs_fs__dag_get_proplist(&proplist, kid_dag, iterpool));
-          mergeinfo_string = svn_hash_gets(proplist, SVN_PROP_MERGEINFO);
-          if (!mergeinfo_string)
-            {
-              svn_string_t *idstr = svn_fs_fs__id_unparse(dirent->id, iterpool);
-              return svn_error_createf
-                (SVN_ERR_FS_CORRUPT, NULL,
-                 _("Node-revision #'%s' claims to have mergeinfo but doesn't"),
-                 idstr->data);
-            }
-
           /* Issue #3896: If a node has syntactically invalid mergeinfo, then
              treat it as if no mergeinfo is present rather than raising a parse
              error. */
-          err = svn_mergeinfo_parse(&kid_mergeinfo,
-                                    mergeinfo_string->data,
-                                    iterpool);
+          err = svn_fs_fs__dag_get_mergeinfo(&kid_mergeinfo, kid_dag,
+                                             iterpool, iterpool);
           if (err)
             {
               if (err->apr_err == SVN_ERR_MERGEINFO_PARSE_ERROR)
                 svn_error_clear(err);
               else
                 return svn_error_trace(err);
-              }
+            }
+          else if (!kid_mergeinfo)
+            {
+              svn_string_t *idstr = svn_fs_fs__id_unparse(dirent->id, iterpool);
+              return svn_error_createf
+                (SVN_ERR_FS_CORRUPT, NULL,
+                 _("Node-revision #'%s' claims to have mergeinfo but doesn't"),
+                 idstr->data);
+            }
           else
             {
               SVN_ERR(receiver(kid_path, kid_mergeinfo, baton, iterpool));
@@ -4262,8 +4640,6 @@ get_mergeinfo_for_path_internal(svn_mergeinfo_t *mergeinfo,
                                 apr_pool_t *scratch_pool)
 {
   parent_path_t *parent_path, *nearest_ancestor;
-  apr_hash_t *proplist;
-  svn_string_t *mergeinfo_string;
 
   path = svn_fs__canonicalize_abspath(path, scratch_pool);
 
@@ -4301,23 +4677,15 @@ get_mergeinfo_for_path_internal(svn_mergeinfo_t *mergeinfo,
         }
     }
 
-  SVN_ERR(svn_fs_fs__dag_get_proplist(&proplist, nearest_ancestor->node,
-                                      scratch_pool));
-  mergeinfo_string = svn_hash_gets(proplist, SVN_PROP_MERGEINFO);
-  if (!mergeinfo_string)
-    return svn_error_createf
-      (SVN_ERR_FS_CORRUPT, NULL,
-       _("Node-revision '%s@%ld' claims to have mergeinfo but doesn't"),
-       parent_path_path(nearest_ancestor, scratch_pool), rev_root->rev);
-
   /* Parse the mergeinfo; store the result in *MERGEINFO. */
   {
     /* Issue #3896: If a node has syntactically invalid mergeinfo, then
        treat it as if no mergeinfo is present rather than raising a parse
        error. */
-    svn_error_t *err = svn_mergeinfo_parse(mergeinfo,
-                                           mergeinfo_string->data,
-                                           result_pool);
+    svn_error_t *err = svn_fs_fs__dag_get_mergeinfo(mergeinfo,
+                                                    nearest_ancestor->node,
+                                                    result_pool,
+                                                    scratch_pool);
     if (err)
       {
         if (err->apr_err == SVN_ERR_MERGEINFO_PARSE_ERROR)
@@ -4330,6 +4698,12 @@ get_mergeinfo_for_path_internal(svn_mergeinfo_t *mergeinfo,
       }
   }
 
+  if (!*mergeinfo)
+    return svn_error_createf
+      (SVN_ERR_FS_CORRUPT, NULL,
+       _("Node-revision '%s@%ld' claims to have mergeinfo but doesn't"),
+       parent_path_path(nearest_ancestor, scratch_pool), rev_root->rev);
+
   /* If our nearest ancestor is the very path we inquired about, we
      can return the mergeinfo results directly.  Otherwise, we're
      inheriting the mergeinfo, so we need to a) remove non-inheritable
@@ -4554,6 +4928,9 @@ static root_vtable_t root_vtable = {
   fs_get_file_delta_stream,
   fs_merge,
   fs_get_mergeinfo,
+  fs_apply_text_by_checksum,
+  NULL,
+  fs_get_stored_delta
 };
 
 /* Construct a new root object in FS, allocated from POOL.  */
@@ -4726,11 +5103,31 @@ verify_node(dag_node_t *node,
   if (kind == svn_node_dir)
     {
       apr_array_header_t *entries;
+      apr_array_header_t *other_ids;
+      apr_array_header_t *other_noderevs;
       apr_int64_t children_mergeinfo = 0;
+      apr_pool_t *noderev_pool;
+      int other_idx = 0;
       APR_ARRAY_PUSH(parent_nodes, dag_node_t*) = node;
 
       SVN_ERR(svn_fs_fs__dag_dir_entries(&entries, node, pool));
 
+      /* Fetch the noderevs of all children from older revisions in one
+       * batch.  We only need their mergeinfo counters. */
+      noderev_pool = svn_pool_create(pool);
+      other_ids = apr_array_make(noderev_pool, entries->nelts,
+                                 sizeof(const svn_fs_id_t *));
+      for (i = 0; i < entries->nelts; ++i)
+        {
+          svn_fs_dirent_t *dirent
+            = APR_ARRAY_IDX(entries, i, svn_fs_dirent_t *);
+          if (svn_fs_fs__id_rev(dirent->id) != rev)
+            APR_ARRAY_PUSH(other_ids, const svn_fs_id_t *) = dirent->id;
+        }
+
+      SVN_ERR(svn_fs_fs__get_node_revisions(&other_noderevs, fs, other_ids,
+                                            noderev_pool, iterpool));
+
       /* Compute CHILDREN_MERGEINFO. */
       for (i = 0; i < entries->nelts; ++i)
         {
@@ -4753,14 +5150,15 @@ verify_node(dag_node_t *node,
           else
             {
               /* access mergeinfo counter with minimal overhead */
-              node_revision_t *noderev;
-              SVN_ERR(svn_fs_fs__get_node_revision(&noderev, fs, dirent->id,
-                                                   iterpool, iterpool));
+              node_revision_t *noderev
+                = APR_ARRAY_IDX(other_noderevs, other_idx++,
+                                node_revision_t *);
               child_mergeinfo = noderev->mergeinfo_count;
             }
 
           children_mergeinfo += child_mergeinfo;
         }
+      svn_pool_destroy(noderev_pool);
 
       /* Side-effect of issue #4129. */
       if (children_mergeinfo+has_mergeinfo != mergeinfo_count)
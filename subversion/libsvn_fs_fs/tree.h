@@ -24,6 +24,7 @@
 #define SVN_LIBSVN_FS_TREE_H
 
 #include "fs.h"
+#include "dag.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -36,11 +37,40 @@ extern "C" {
 fs_fs_dag_cache_t*
 svn_fs_fs__create_dag_cache(apr_pool_t *pool);
 
+/* In RESULT_POOL, create a thread-safe DAG node cache for revision roots
+   to be shared between all svn_fs_t instances of a repository and return
+   it in *CACHE.  The cache will be cleared at regular intervals. */
+svn_error_t *
+svn_fs_fs__create_shared_dag_cache(fs_fs_shared_dag_cache_t **cache,
+                                   apr_pool_t *result_pool);
+
+/* Set *NODE_P to a copy of the node for PATH in REVISION found in the
+   DAG node cache shared by all svn_fs_t instances of FS's repository, or
+   to NULL if there is none.  The node's FS will not be set.  Allocate it
+   in RESULT_POOL.  This is meant for tests. */
+svn_error_t *
+svn_fs_fs__shared_dag_cache_lookup(dag_node_t **node_p,
+                                   svn_fs_t *fs,
+                                   svn_revnum_t revision,
+                                   const char *path,
+                                   apr_pool_t *result_pool);
+
 /* Set *ROOT_P to the root directory of revision REV in filesystem FS.
    Allocate the structure in POOL. */
 svn_error_t *svn_fs_fs__revision_root(svn_fs_root_t **root_p, svn_fs_t *fs,
                                       svn_revnum_t rev, apr_pool_t *pool);
 
+/* Implement fs_vtable_t.paths_changed_range(). */
+svn_error_t *
+svn_fs_fs__paths_changed_range(svn_fs_t *fs,
+                               svn_revnum_t start,
+                               svn_revnum_t end,
+                               svn_fs_paths_changed_receiver_t receiver,
+                               void *receiver_baton,
+                               svn_cancel_func_t cancel_func,
+                               void *cancel_baton,
+                               apr_pool_t *scratch_pool);
+
 /* Does nothing, but included for Subversion 1.0.x compatibility. */
 svn_error_t *svn_fs_fs__deltify(svn_fs_t *fs, svn_revnum_t rev,
                                 apr_pool_t *pool);
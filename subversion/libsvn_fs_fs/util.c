@@ -21,9 +21,12 @@
  */
 
 #include <assert.h>
+#include <apr_mmap.h>
 
+#include "svn_checksum.h"
 #include "svn_ctype.h"
 #include "svn_dirent_uri.h"
+#include "svn_pools.h"
 #include "private/svn_string_private.h"
 
 #include "fs_fs.h"
@@ -100,6 +103,13 @@ svn_fs_fs__path_revprop_generation(svn_fs_t *fs,
   return svn_dirent_join(fs->path, PATH_REVPROP_GENERATION, pool);
 }
 
+const char *
+svn_fs_fs__path_revprop_counter(svn_fs_t *fs,
+                                apr_pool_t *pool)
+{
+  return svn_dirent_join(fs->path, PATH_REVPROP_COUNTER, pool);
+}
+
 const char *
 svn_fs_fs__path_rev_packed(svn_fs_t *fs,
                            svn_revnum_t rev,
@@ -518,11 +528,210 @@ svn_fs_fs__write_current(svn_fs_t *fs,
       buf = apr_psprintf(pool, "%ld %s %s\n", rev, node_id_str, copy_id_str);
     }
 
+  /* Readers must not see the old value anymore once 'current' has been
+     replaced, so withdraw it first. */
+  SVN_ERR(svn_fs_fs__publish_shared_youngest(fs, SVN_INVALID_REVNUM, TRUE,
+                                             pool));
+
   name = svn_fs_fs__path_current(fs, pool);
   SVN_ERR(svn_io_write_atomic2(name, buf, strlen(buf),
                                name /* copy_perms_path */,
                                ffd->flush_to_disk, pool));
 
+  return svn_error_trace(svn_fs_fs__publish_shared_youngest(fs, rev, TRUE,
+                                                            pool));
+}
+
+
+/*** Shared youngest revision. ***/
+
+/*
+ * Finding HEAD requires reading the 'current' file, which is expensive
+ * on network file systems and happens for almost every request.  If the
+ * CONFIG_OPTION_SHARED_YOUNGEST_DIR has been set, all processes on this
+ * host share the youngest revision through a small file in that local
+ * directory instead, which every process maps into memory.
+ *
+ * The file contains a single svn_atomic_t in native byte order.  0 means
+ * "unknown", any other value is the youngest revision plus 1.  Writers
+ * of 'current' withdraw the value before replacing the file and publish
+ * the new revision afterwards.  Processes holding the write lock always
+ * read 'current' and correct the published value.  Everybody else only
+ * reads 'current' while the value is unknown and then fills it in.
+ *
+ * Like the revprop counter, the file is only ever modified in place, so
+ * existing mappings remain valid for the lifetime of the process.
+ */
+
+/* Per-process, per-repository state of the shared youngest revision. */
+struct fs_fs_shared_youngest_t
+{
+  /* The mapped value.  NULL, if the file has not been mapped (yet). */
+  volatile svn_atomic_t *value;
+
+  /* The repository whose file got mapped or that we failed to map.
+   * Naively copied repositories share this structure; copies at other
+   * paths don't use the shared youngest revision. */
+  const char *fs_path;
+
+  /* The mapping and its file are allocated in this pool. */
+  apr_pool_t *pool;
+
+  /* Serializes attempts to map the file. */
+  svn_mutex__t *mutex;
+};
+
+svn_error_t *
+svn_fs_fs__create_shared_youngest(fs_fs_shared_youngest_t **shared,
+                                  apr_pool_t *result_pool)
+{
+  fs_fs_shared_youngest_t *result = apr_pcalloc(result_pool,
+                                                sizeof(*result));
+
+  result->pool = result_pool;
+  SVN_ERR(svn_mutex__init(&result->mutex, TRUE, result_pool));
+
+  *shared = result;
+
+  return SVN_NO_ERROR;
+}
+
+/* Map the shared youngest file of FS into SHARED unless that has already
+ * been attempted.  Any failure to do so will simply leave SHARED unmapped.
+ * Set *VALUE to the mapped value, if that belongs to FS, or to NULL
+ * otherwise.  Call this only while holding SHARED->MUTEX.  Use
+ * SCRATCH_POOL for temporaries.
+ */
+static svn_error_t *
+map_shared_youngest(volatile svn_atomic_t **value,
+                    fs_fs_shared_youngest_t *shared,
+                    svn_fs_t *fs,
+                    apr_pool_t *scratch_pool)
+{
+#if APR_HAS_MMAP
+  if (!shared->fs_path)
+    {
+      fs_fs_data_t *ffd = fs->fsap_data;
+      svn_checksum_t *checksum;
+      const char *key;
+      const char *path;
+      apr_pool_t *pool;
+      apr_file_t *file;
+      apr_finfo_t finfo;
+      apr_mmap_t *mmap;
+
+      /* Different repositories and copies of the same repository must
+       * not share a file, so make the name depend on all of them. */
+      key = apr_pstrcat(scratch_pool, fs->uuid, ":", ffd->instance_id, ":",
+                        svn_dirent_join(fs->path, "", scratch_pool),
+                        SVN_VA_NULL);
+      SVN_ERR(svn_checksum(&checksum, svn_checksum_md5, key, strlen(key),
+                           scratch_pool));
+      path = svn_dirent_join(ffd->shared_youngest_dir,
+                             apr_pstrcat(scratch_pool, "svn-youngest-",
+                                         svn_checksum_to_cstring(checksum,
+                                                                 scratch_pool),
+                                         SVN_VA_NULL),
+                             scratch_pool);
+
+      /* Only keep the file handle and the mapping upon success.  Never
+       * truncate the file as others may have mapped it already. */
+      pool = svn_pool_create(shared->pool);
+      if (   apr_file_open(&file, path,
+                           APR_READ | APR_WRITE | APR_CREATE | APR_BINARY,
+                           APR_OS_DEFAULT, pool)
+          || apr_file_info_get(&finfo, APR_FINFO_SIZE, file)
+          || (   finfo.size < sizeof(svn_atomic_t)
+              && apr_file_write_full(file, "\0\0\0\0", sizeof(svn_atomic_t),
+                                     NULL))
+          || apr_mmap_create(&mmap, file, 0, sizeof(svn_atomic_t),
+                             APR_MMAP_READ | APR_MMAP_WRITE, pool))
+        {
+          svn_pool_destroy(pool);
+        }
+      else
+        {
+          shared->value = mmap->mm;
+        }
+
+      /* Don't try again. */
+      shared->fs_path = apr_pstrdup(shared->pool, fs->path);
+    }
+#endif
+
+  *value = (shared->value && !strcmp(shared->fs_path, fs->path))
+         ? shared->value
+         : NULL;
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *VALUE to the mapped shared youngest value of FS or to NULL, if
+ * that is not available.  Use SCRATCH_POOL for temporaries. */
+static svn_error_t *
+get_shared_youngest(volatile svn_atomic_t **value,
+                    svn_fs_t *fs,
+                    apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  fs_fs_shared_youngest_t *shared;
+
+  *value = NULL;
+  if (!ffd->shared_youngest_dir || !ffd->shared || !fs->uuid)
+    return SVN_NO_ERROR;
+
+  shared = ffd->shared->shared_youngest;
+  SVN_MUTEX__WITH_LOCK(shared->mutex,
+                       map_shared_youngest(value, shared, fs, scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_fs_fs__read_shared_youngest(svn_revnum_t *youngest_p,
+                                svn_fs_t *fs,
+                                apr_pool_t *scratch_pool)
+{
+  volatile svn_atomic_t *value;
+  svn_atomic_t published;
+
+  *youngest_p = SVN_INVALID_REVNUM;
+
+  SVN_ERR(get_shared_youngest(&value, fs, scratch_pool));
+  if (value)
+    {
+      published = svn_atomic_read(value);
+      if (published)
+        *youngest_p = (svn_revnum_t)(published - 1);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_fs_fs__publish_shared_youngest(svn_fs_t *fs,
+                                   svn_revnum_t youngest,
+                                   svn_boolean_t replace,
+                                   apr_pool_t *scratch_pool)
+{
+  volatile svn_atomic_t *value;
+  svn_atomic_t published;
+
+  SVN_ERR(get_shared_youngest(&value, fs, scratch_pool));
+  if (!value)
+    return SVN_NO_ERROR;
+
+  /* Revisions that don't fit are simply not published. */
+  published = (   SVN_IS_VALID_REVNUM(youngest)
+               && (apr_uint64_t)youngest < APR_UINT32_MAX)
+            ? (svn_atomic_t)youngest + 1
+            : 0;
+
+  if (replace)
+    svn_atomic_set(value, published);
+  else
+    svn_atomic_cas(value, published, 0);
+
   return SVN_NO_ERROR;
 }
 
@@ -143,6 +143,13 @@ const char *
 svn_fs_fs__path_revprop_generation(svn_fs_t *fs,
                                    apr_pool_t *pool);
 
+/* Return the full path of the revprop counter file in FS.
+ * Allocate the result in POOL.
+ */
+const char *
+svn_fs_fs__path_revprop_counter(svn_fs_t *fs,
+                                apr_pool_t *pool);
+
 /* Return the full path of the revision properties pack shard directory
  * that will contain the packed properties of revision REV in FS.
  * Allocate the result in POOL.
@@ -338,7 +345,8 @@ svn_fs_fs__read_current(svn_revnum_t *rev,
 
 /* Atomically update the 'current' file to hold the specifed REV,
    NEXT_NODE_ID, and NEXT_COPY_ID.  (The two next-ID parameters are
-   ignored and may be 0 if the FS format does not use them.)
+   ignored and may be 0 if the FS format does not use them.)  Publish
+   REV as the shared youngest revision, if enabled.
    Perform temporary allocations in POOL. */
 svn_error_t *
 svn_fs_fs__write_current(svn_fs_t *fs,
@@ -347,6 +355,35 @@ svn_fs_fs__write_current(svn_fs_t *fs,
                          apr_uint64_t next_copy_id,
                          apr_pool_t *pool);
 
+/* Allocate the per-process state for the shared youngest revision in
+ * RESULT_POOL and return it in *SHARED.
+ */
+svn_error_t *
+svn_fs_fs__create_shared_youngest(fs_fs_shared_youngest_t **shared,
+                                  apr_pool_t *result_pool);
+
+/* Set *YOUNGEST_P to the youngest revision of FS as published by the
+ * processes on this host.  Set it to SVN_INVALID_REVNUM, if that is not
+ * available.  Use SCRATCH_POOL for temporary allocations.
+ */
+svn_error_t *
+svn_fs_fs__read_shared_youngest(svn_revnum_t *youngest_p,
+                                svn_fs_t *fs,
+                                apr_pool_t *scratch_pool);
+
+/* Publish YOUNGEST, which has just been read from or written to the
+ * 'current' file of FS, to the other processes on this host.  Unless
+ * REPLACE is set, do so only if no value has been published, yet.
+ * SVN_INVALID_REVNUM withdraws the published value.  This is a no-op
+ * if the shared youngest revision has not been enabled for FS.  Use
+ * SCRATCH_POOL for temporary allocations.
+ */
+svn_error_t *
+svn_fs_fs__publish_shared_youngest(svn_fs_t *fs,
+                                   svn_revnum_t youngest,
+                                   svn_boolean_t replace,
+                                   apr_pool_t *scratch_pool);
+
 /* Read the file at PATH and return its content in *CONTENT. *CONTENT will
  * not be modified unless the whole file was read successfully.
  *
@@ -23,7 +23,12 @@
 #include "svn_sorts.h"
 #include "svn_checksum.h"
 #include "svn_time.h"
+#include "svn_hash.h"
+#include "svn_dirent_uri.h"
+#include "private/svn_fs_private.h"
+#include "private/svn_mutex.h"
 #include "private/svn_subr_private.h"
+#include "private/svn_worker_pool.h"
 
 #include "verify.h"
 #include "fs_fs.h"
@@ -263,6 +268,7 @@ compare_l2p_to_p2l_index(svn_fs_t *fs,
 {
   svn_revnum_t i;
   apr_pool_t *iterpool = svn_pool_create(pool);
+  apr_pool_t *revision_pool = svn_pool_create(pool);
   apr_array_header_t *max_ids;
 
   /* common file access structure */
@@ -280,16 +286,30 @@ compare_l2p_to_p2l_index(svn_fs_t *fs,
       apr_uint64_t k;
       apr_uint64_t max_id = APR_ARRAY_IDX(max_ids, i, apr_uint64_t);
       svn_revnum_t revision = start + i;
+      apr_array_header_t *items;
+      apr_array_header_t *offsets;
 
+      /* get all L2P entries of REVISION in one go */
+      svn_pool_clear(revision_pool);
+      items = apr_array_make(revision_pool, (int)max_id,
+                             sizeof(svn_fs_fs__id_part_t));
       for (k = 0; k < max_id; ++k)
         {
-          apr_off_t offset;
+          svn_fs_fs__id_part_t *item = apr_array_push(items);
+          item->revision = revision;
+          item->number = k;
+        }
+
+      SVN_ERR(svn_fs_fs__item_offsets(&offsets, fs, rev_file, items, TRUE,
+                                      revision_pool, revision_pool));
+
+      for (k = 0; k < max_id; ++k)
+        {
+          apr_off_t offset = APR_ARRAY_IDX(offsets, k, apr_off_t);
           svn_fs_fs__p2l_entry_t *p2l_entry;
           svn_pool_clear(iterpool);
 
-          /* get L2P entry.  Ignore unused entries. */
-          SVN_ERR(svn_fs_fs__item_offset(&offset, fs, rev_file, revision,
-                                         NULL, k, iterpool));
+          /* Ignore unused entries. */
           if (offset == -1)
             continue;
 
@@ -323,6 +343,7 @@ compare_l2p_to_p2l_index(svn_fs_t *fs,
         SVN_ERR(cancel_func(cancel_baton));
     }
 
+  svn_pool_destroy(revision_pool);
   svn_pool_destroy(iterpool);
 
   SVN_ERR(svn_fs_fs__close_revision_file(rev_file));
@@ -534,23 +555,88 @@ expected_checksum(apr_file_t *file,
   return SVN_NO_ERROR;
 }
 
-/* Verify that the FNV checksum over the next ENTRY->SIZE bytes read
- * from FILE will match ENTRY's expected checksum.  SIZE must not
- * exceed STREAM_THRESHOLD.  Use POOL for allocations.
+/* Maximum number of items and their total size that get checksummed in
+ * a single batch.  Must allow for at least one item of STREAM_THRESHOLD
+ * bytes. */
+#define BATCH_MAX_ITEMS 64
+#define BATCH_SIZE (16 * STREAM_THRESHOLD)
+
+/* A sequence of consecutive small items in a rev / pack file that we will
+ * read in one go and whose checksums can be calculated in parallel.
+ */
+typedef struct checksum_batch_t
+{
+  /* The items in this batch. */
+  svn_fs_fs__p2l_entry_t *entries[BATCH_MAX_ITEMS];
+
+  /* Number of valid elements in ENTRIES. */
+  int count;
+
+  /* Sum of all ENTRIES' sizes. */
+  apr_size_t size;
+
+  /* BATCH_SIZE bytes of buffer to read the data into. */
+  unsigned char *buffer;
+} checksum_batch_t;
+
+/* Verify that the FNV checksums over the next BATCH->SIZE bytes read from
+ * FILE match those expected by the entries in BATCH.  Reset BATCH to empty
+ * afterwards.  Use POOL for allocations.
  */
 static svn_error_t *
-expected_buffered_checksum(apr_file_t *file,
-                           svn_fs_fs__p2l_entry_t *entry,
-                           apr_pool_t *pool)
+flush_checksum_batch(apr_file_t *file,
+                     checksum_batch_t *batch,
+                     apr_pool_t *pool)
 {
-  unsigned char buffer[STREAM_THRESHOLD];
-  SVN_ERR_ASSERT(entry->size <= STREAM_THRESHOLD);
+  const void *inputs[BATCH_MAX_ITEMS];
+  apr_size_t lens[BATCH_MAX_ITEMS];
+  apr_uint32_t checksums[BATCH_MAX_ITEMS];
+  const unsigned char *data = batch->buffer;
+  int i;
+
+  if (batch->count == 0)
+    return SVN_NO_ERROR;
 
-  SVN_ERR(svn_io_file_read_full2(file, buffer, (apr_size_t)entry->size,
+  SVN_ERR(svn_io_file_read_full2(file, batch->buffer, batch->size,
                                  NULL, NULL, pool));
-  SVN_ERR(expected_checksum(file, entry,
-                            svn__fnv1a_32x4(buffer, (apr_size_t)entry->size),
-                            pool));
+
+  for (i = 0; i < batch->count; ++i)
+    {
+      inputs[i] = data;
+      lens[i] = (apr_size_t)batch->entries[i]->size;
+      data += lens[i];
+    }
+
+  svn__fnv1a_32x4_multi(checksums, inputs, lens, batch->count);
+
+  for (i = 0; i < batch->count; ++i)
+    SVN_ERR(expected_checksum(file, batch->entries[i], checksums[i], pool));
+
+  batch->count = 0;
+  batch->size = 0;
+
+  return SVN_NO_ERROR;
+}
+
+/* Add ENTRY, which must not exceed STREAM_THRESHOLD in size and must
+ * directly follow the last entry in BATCH, to BATCH.  If BATCH is full,
+ * verify the checksums in it first, reading the data from FILE.
+ * Use POOL for allocations.
+ */
+static svn_error_t *
+add_to_checksum_batch(apr_file_t *file,
+                      checksum_batch_t *batch,
+                      svn_fs_fs__p2l_entry_t *entry,
+                      apr_pool_t *pool)
+{
+  SVN_ERR_ASSERT(entry->size <= STREAM_THRESHOLD);
+
+  if (   batch->count == BATCH_MAX_ITEMS
+      || batch->size + (apr_size_t)entry->size > BATCH_SIZE)
+    SVN_ERR(flush_checksum_batch(file, batch, pool));
+
+  batch->entries[batch->count++] = entry;
+  batch->size += (apr_size_t)entry->size;
 
   return SVN_NO_ERROR;
 }
@@ -609,6 +695,10 @@ compare_p2l_to_rev(svn_fs_t *fs,
   apr_off_t max_offset;
   apr_off_t offset = 0;
   svn_fs_fs__revision_file_t *rev_file;
+  checksum_batch_t batch = { { NULL }, 0, 0, NULL };
+
+  /* Small items will be checksummed in batches. */
+  batch.buffer = apr_palloc(pool, BATCH_SIZE);
 
   /* open the pack / rev file that is covered by the p2l index */
   SVN_ERR(svn_fs_fs__open_pack_or_rev_file(&rev_file, fs, start, pool,
@@ -701,11 +791,14 @@ compare_p2l_to_rev(svn_fs_t *fs,
                                      entry->type,
                                      apr_off_t_toa(pool, offset));
 
-          /* Check contents. */
+          /* Check contents.  Small items are queued in BATCH, everything
+           * else requires BATCH to be processed first because we read the
+           * file sequentially. */
           if (entry->type == SVN_FS_FS__ITEM_TYPE_UNUSED)
             {
               /* Empty sections must contain NUL bytes only.
                * Beware of the filler at the end of the p2l index. */
+              SVN_ERR(flush_checksum_batch(rev_file->file, &batch, pool));
               if (entry->offset != max_offset)
                 SVN_ERR(read_all_nul(rev_file->file, entry->size, pool));
             }
@@ -713,17 +806,26 @@ compare_p2l_to_rev(svn_fs_t *fs,
             {
               /* Generic contents check against checksum. */
               if (entry->size < STREAM_THRESHOLD)
-                SVN_ERR(expected_buffered_checksum(rev_file->file, entry,
-                                                   pool));
+                {
+                  SVN_ERR(add_to_checksum_batch(rev_file->file, &batch,
+                                                entry, pool));
+                }
               else
-                SVN_ERR(expected_streamed_checksum(rev_file->file, entry,
-                                                   pool));
+                {
+                  SVN_ERR(flush_checksum_batch(rev_file->file, &batch,
+                                               pool));
+                  SVN_ERR(expected_streamed_checksum(rev_file->file, entry,
+                                                     pool));
+                }
             }
 
           /* advance offset */
           offset += entry->size;
         }
 
+      /* ENTRIES will be gone in the next iteration. */
+      SVN_ERR(flush_checksum_batch(rev_file->file, &batch, iterpool));
+
       if (cancel_func)
         SVN_ERR(cancel_func(cancel_baton));
     }
@@ -920,3 +1022,463 @@ svn_fs_fs__verify(svn_fs_t *fs,
 
   return SVN_NO_ERROR;
 }
+
+
+/** Verifying after commit. **/
+
+/* Reconstruct the fulltext of REP in FS and compare it against the
+ * checksums recorded in REP.  NODE_ID is used in error messages only.
+ * Call the optional CANCEL_FUNC with CANCEL_BATON periodically.  Use
+ * SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+verify_rep_fulltext(svn_fs_t *fs,
+                    representation_t *rep,
+                    const svn_fs_id_t *node_id,
+                    svn_cancel_func_t cancel_func,
+                    void *cancel_baton,
+                    apr_pool_t *scratch_pool)
+{
+  svn_stream_t *contents;
+  svn_checksum_ctx_t *md5_ctx
+    = svn_checksum_ctx_create(svn_checksum_md5, scratch_pool);
+  svn_checksum_ctx_t *sha1_ctx
+    = svn_checksum_ctx_create(svn_checksum_sha1, scratch_pool);
+  char *buffer = apr_palloc(scratch_pool, SVN__STREAM_CHUNK_SIZE);
+  svn_checksum_t *actual;
+  svn_checksum_t expected;
+  apr_size_t len;
+
+  SVN_ERR(svn_fs_fs__get_contents(&contents, fs, rep, FALSE, scratch_pool));
+  do
+    {
+      if (cancel_func)
+        SVN_ERR(cancel_func(cancel_baton));
+
+      len = SVN__STREAM_CHUNK_SIZE;
+      SVN_ERR(svn_stream_read_full(contents, buffer, &len));
+      SVN_ERR(svn_checksum_update(md5_ctx, buffer, len));
+      SVN_ERR(svn_checksum_update(sha1_ctx, buffer, len));
+    }
+  while (len == SVN__STREAM_CHUNK_SIZE);
+  SVN_ERR(svn_stream_close(contents));
+
+  expected.kind = svn_checksum_md5;
+  expected.digest = rep->md5_digest;
+  SVN_ERR(svn_checksum_final(&actual, md5_ctx, scratch_pool));
+  if (!svn_checksum_match(&expected, actual))
+    return svn_checksum_mismatch_err(&expected, actual, scratch_pool,
+                                     _("Fulltext checksum mismatch on "
+                                       "node '%s'"),
+                                     svn_fs_fs__id_unparse(node_id,
+                                                           scratch_pool)
+                                       ->data);
+
+  if (rep->has_sha1)
+    {
+      expected.kind = svn_checksum_sha1;
+      expected.digest = rep->sha1_digest;
+      SVN_ERR(svn_checksum_final(&actual, sha1_ctx, scratch_pool));
+      if (!svn_checksum_match(&expected, actual))
+        return svn_checksum_mismatch_err(&expected, actual, scratch_pool,
+                                         _("Fulltext checksum mismatch on "
+                                           "node '%s'"),
+                                         svn_fs_fs__id_unparse(node_id,
+                                                               scratch_pool)
+                                           ->data);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Verify the fulltexts of the representations of node ID in FS that have
+ * been added in revision REV and recurse into the directory entries
+ * added in REV.  Call the optional CANCEL_FUNC with CANCEL_BATON
+ * periodically.  Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+verify_node_contents(svn_fs_t *fs,
+                     const svn_fs_id_t *id,
+                     svn_revnum_t rev,
+                     svn_cancel_func_t cancel_func,
+                     void *cancel_baton,
+                     apr_pool_t *scratch_pool)
+{
+  node_revision_t *noderev;
+
+  SVN_ERR(svn_fs_fs__get_node_revision(&noderev, fs, id, scratch_pool,
+                                       scratch_pool));
+
+  /* Shared representations of older revisions have been verified with
+     their own revision. */
+  if (noderev->prop_rep && noderev->prop_rep->revision == rev)
+    SVN_ERR(verify_rep_fulltext(fs, noderev->prop_rep, id,
+                                cancel_func, cancel_baton, scratch_pool));
+  if (noderev->data_rep && noderev->data_rep->revision == rev)
+    SVN_ERR(verify_rep_fulltext(fs, noderev->data_rep, id,
+                                cancel_func, cancel_baton, scratch_pool));
+
+  if (noderev->kind == svn_node_dir)
+    {
+      apr_array_header_t *entries;
+      apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+      int i;
+
+      SVN_ERR(svn_fs_fs__rep_contents_dir(&entries, fs, noderev,
+                                          scratch_pool, iterpool));
+      for (i = 0; i < entries->nelts; ++i)
+        {
+          svn_fs_dirent_t *dirent
+            = APR_ARRAY_IDX(entries, i, svn_fs_dirent_t *);
+
+          svn_pool_clear(iterpool);
+          if (svn_fs_fs__id_rev(dirent->id) == rev)
+            SVN_ERR(verify_node_contents(fs, dirent->id, rev, cancel_func,
+                                         cancel_baton, iterpool));
+        }
+
+      svn_pool_destroy(iterpool);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_fs_fs__verify_rev_contents(svn_fs_t *fs,
+                               svn_revnum_t rev,
+                               svn_cancel_func_t cancel_func,
+                               void *cancel_baton,
+                               apr_pool_t *scratch_pool)
+{
+  svn_fs_id_t *root_id;
+
+  SVN_ERR(svn_fs_fs__verify(fs, rev, rev, NULL, NULL, cancel_func,
+                            cancel_baton, scratch_pool));
+
+  SVN_ERR(svn_fs_fs__rev_get_root(&root_id, fs, rev, scratch_pool,
+                                  scratch_pool));
+  return svn_error_trace(verify_node_contents(fs, root_id, rev, cancel_func,
+                                              cancel_baton, scratch_pool));
+}
+
+#if APR_HAS_THREADS
+
+/* Append the result ERR of verifying revision REV of the repository at
+ * FS_PATH to its verify log.  Clear ERR.  Use SCRATCH_POOL for temporary
+ * allocations.
+ *
+ * Every line of the log reads "<rev> ok" or "<rev> failed <message>".
+ * Lines get appended with a single write, so concurrent writers don't
+ * interleave. */
+static svn_error_t *
+append_to_verify_log(const char *fs_path,
+                     svn_revnum_t rev,
+                     svn_error_t *err,
+                     apr_pool_t *scratch_pool)
+{
+  apr_file_t *file;
+  const char *line;
+
+  if (err)
+    {
+      char buffer[256];
+      svn_error_t *first = svn_error_purge_tracing(err);
+      char *message = apr_pstrdup(scratch_pool,
+                                  svn_err_best_message(first, buffer,
+                                                       sizeof(buffer)));
+      char *eol;
+
+      /* One line per revision. */
+      while ((eol = strchr(message, '\n')) != NULL)
+        *eol = ' ';
+
+      line = apr_psprintf(scratch_pool, "%ld failed E%06d: %s\n",
+                          rev, first->apr_err, message);
+      svn_error_clear(err);
+    }
+  else
+    {
+      line = apr_psprintf(scratch_pool, "%ld ok\n", rev);
+    }
+
+  SVN_ERR(svn_io_file_open(&file,
+                           svn_dirent_join(fs_path, PATH_VERIFY_LOG,
+                                           scratch_pool),
+                           APR_WRITE | APR_CREATE | APR_APPEND,
+                           APR_OS_DEFAULT, scratch_pool));
+  SVN_ERR(svn_io_file_write_full(file, line, strlen(line), NULL,
+                                 scratch_pool));
+
+  return svn_error_trace(svn_io_file_close(file, scratch_pool));
+}
+
+struct fs_fs_verifier_t
+{
+  /* Serializes starting the worker. */
+  svn_mutex__t *mutex;
+
+  /* Set by the first commit: The repository to verify and how to open a
+     separate svn_fs_t for it. */
+  const char *fs_path;
+  svn_error_t *(*svn_fs_open_)(svn_fs_t **, const char *, apr_hash_t *,
+                               apr_pool_t *, apr_pool_t *);
+
+  /* Runs the verifier_job(), started on demand, and the pool owning it.
+     The mutex of WORKERS protects the members below; it gets notified
+     whenever a revision got queued or when shutting down. */
+  svn_worker_pool__t *workers;
+  apr_pool_t *workers_pool;
+
+  /* Queued svn_revnum_t, the ones before NEXT have been picked up by the
+     worker already. */
+  apr_array_header_t *pending;
+  int next;
+
+  /* Set when the process is about to release the shared data.  The worker
+     finishes the pending revisions first. */
+  svn_boolean_t shutdown;
+
+  /* Pool for the members above. */
+  apr_pool_t *pool;
+};
+
+/* Verify revision REV of the repository known to VERIFIER in a separate
+ * svn_fs_t that does not share cached data with other instances and log
+ * the result.  Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+verify_and_log(fs_fs_verifier_t *verifier,
+               svn_revnum_t rev,
+               apr_pool_t *scratch_pool)
+{
+  apr_hash_t *fs_config = apr_hash_make(scratch_pool);
+  svn_fs_t *fs;
+  fs_fs_data_t *ffd;
+  svn_error_t *err;
+
+  /* Make sure we actually read the data from disk. */
+  svn_hash_sets(fs_config, SVN_FS_CONFIG_FSFS_CACHE_NS,
+                svn_uuid_generate(scratch_pool));
+  err = verifier->svn_fs_open_(&fs, verifier->fs_path, fs_config,
+                               scratch_pool, scratch_pool);
+  if (!err)
+    {
+      /* Don't displace the data of the foreground operations. */
+      svn_fs__set_bulk_scan(fs, TRUE);
+      ffd = fs->fsap_data;
+      ffd->rep_sharing_allowed = FALSE;
+
+      err = svn_fs_fs__verify_rev_contents(fs, rev, NULL, NULL,
+                                           scratch_pool);
+    }
+
+  return svn_error_trace(append_to_verify_log(verifier->fs_path, rev, err,
+                                              scratch_pool));
+}
+
+/* Implements svn_worker_pool__func_t.  BATON is the fs_fs_verifier_t.
+   Verify the queued revisions until shutdown. */
+static svn_error_t *
+verifier_job(void *baton,
+             apr_pool_t *scratch_pool)
+{
+  fs_fs_verifier_t *verifier = baton;
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  svn_error_t *err = SVN_NO_ERROR;
+
+  SVN_ERR(svn_worker_pool__lock(verifier->workers));
+  while (!err)
+    {
+      svn_revnum_t rev;
+
+      if (verifier->next == verifier->pending->nelts)
+        {
+          apr_array_clear(verifier->pending);
+          verifier->next = 0;
+
+          if (verifier->shutdown)
+            break;
+
+          err = svn_worker_pool__wait_for_change(verifier->workers);
+          continue;
+        }
+
+      rev = APR_ARRAY_IDX(verifier->pending, verifier->next++,
+                          svn_revnum_t);
+
+      SVN_ERR(svn_worker_pool__unlock(verifier->workers, SVN_NO_ERROR));
+      svn_pool_clear(iterpool);
+      svn_error_clear(verify_and_log(verifier, rev, iterpool));
+      SVN_ERR(svn_worker_pool__lock(verifier->workers));
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return svn_error_trace(svn_worker_pool__unlock(verifier->workers, err));
+}
+
+/* Pool pre-cleanup function stopping the fs_fs_verifier_t in DATA once it
+   has verified all pending revisions. */
+static apr_status_t
+stop_verifier(void *data)
+{
+  fs_fs_verifier_t *verifier = data;
+
+  if (!verifier->workers)
+    return APR_SUCCESS;
+
+  svn_error_clear(svn_worker_pool__lock(verifier->workers));
+  verifier->shutdown = TRUE;
+  svn_error_clear(svn_worker_pool__notify(verifier->workers));
+  svn_error_clear(svn_worker_pool__unlock(verifier->workers, SVN_NO_ERROR));
+
+  /* Waits for the job to return. */
+  svn_pool_destroy(verifier->workers_pool);
+
+  return APR_SUCCESS;
+}
+
+#endif
+
+svn_error_t *
+svn_fs_fs__create_verifier(fs_fs_verifier_t **verifier,
+                           apr_pool_t *result_pool)
+{
+#if APR_HAS_THREADS
+  fs_fs_verifier_t *new_verifier = apr_pcalloc(result_pool,
+                                               sizeof(*new_verifier));
+
+  new_verifier->pool = result_pool;
+  new_verifier->pending = apr_array_make(result_pool, 16,
+                                         sizeof(svn_revnum_t));
+  SVN_ERR(svn_mutex__init(&new_verifier->mutex, TRUE, result_pool));
+
+  /* The worker still needs the shared data and the FS library, so stop
+     it before anything in the common pool gets destroyed. */
+  apr_pool_pre_cleanup_register(result_pool, new_verifier, stop_verifier);
+
+  *verifier = new_verifier;
+#else
+  *verifier = NULL;
+#endif
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_fs_fs__verify_after_commit(svn_fs_t *fs,
+                               svn_revnum_t rev,
+                               apr_pool_t *scratch_pool)
+{
+#if APR_HAS_THREADS
+  fs_fs_data_t *ffd = fs->fsap_data;
+  fs_fs_verifier_t *verifier = ffd->shared->verifier;
+  svn_error_t *err = SVN_NO_ERROR;
+
+  if (!verifier)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_mutex__lock(verifier->mutex));
+
+  if (!verifier->workers)
+    {
+      verifier->fs_path = apr_pstrdup(verifier->pool, fs->path);
+      verifier->svn_fs_open_ = ffd->svn_fs_open_;
+
+      verifier->workers_pool = svn_pool_create(verifier->pool);
+      err = svn_worker_pool__create(&verifier->workers, 1,
+                                    verifier->workers_pool);
+      if (!err && !verifier->workers)
+        err = svn_error_create(SVN_ERR_FS_GENERAL, NULL,
+                               _("Can't create verification thread"));
+      if (!err)
+        err = svn_worker_pool__post(NULL, verifier->workers, verifier_job,
+                                    verifier, verifier->workers_pool);
+
+      /* Try again with the next commit. */
+      if (err)
+        {
+          svn_pool_destroy(verifier->workers_pool);
+          verifier->workers = NULL;
+        }
+    }
+
+  if (!err)
+    {
+      err = svn_worker_pool__lock(verifier->workers);
+      if (!err)
+        {
+          APR_ARRAY_PUSH(verifier->pending, svn_revnum_t) = rev;
+          err = svn_worker_pool__unlock(verifier->workers,
+                  svn_worker_pool__notify(verifier->workers));
+        }
+    }
+
+  return svn_error_trace(svn_mutex__unlock(verifier->mutex, err));
+#else
+  return SVN_NO_ERROR;
+#endif
+}
+
+svn_error_t *
+svn_fs_fs__get_verified_revisions(apr_array_header_t **revisions,
+                                  svn_fs_t *fs,
+                                  svn_revnum_t start,
+                                  svn_revnum_t end,
+                                  apr_pool_t *result_pool,
+                                  apr_pool_t *scratch_pool)
+{
+  svn_stringbuf_t *contents;
+  apr_array_header_t *lines;
+  char *verified;
+  svn_revnum_t rev;
+  svn_error_t *err;
+  int i;
+
+  *revisions = apr_array_make(result_pool, 0, sizeof(svn_revnum_t));
+  if (start > end)
+    return SVN_NO_ERROR;
+
+  err = svn_stringbuf_from_file2(&contents,
+                                 svn_dirent_join(fs->path, PATH_VERIFY_LOG,
+                                                 scratch_pool),
+                                 scratch_pool);
+  if (err && APR_STATUS_IS_ENOENT(err->apr_err))
+    {
+      svn_error_clear(err);
+      return SVN_NO_ERROR;
+    }
+  SVN_ERR(err);
+
+  /* Ignore a line that is still being written. */
+  while (contents->len && contents->data[contents->len - 1] != '\n')
+    svn_stringbuf_chop(contents, 1);
+
+  /* 1 for verified revisions, 2 for those that failed at least once. */
+  verified = apr_pcalloc(scratch_pool, end - start + 1);
+  lines = svn_cstring_split(contents->data, "\n", TRUE, scratch_pool);
+  for (i = 0; i < lines->nelts; ++i)
+    {
+      const char *line = APR_ARRAY_IDX(lines, i, const char *);
+      const char *status;
+
+      if (svn_revnum_parse(&rev, line, &status) || *status != ' ')
+        return svn_error_createf(SVN_ERR_FS_CORRUPT, NULL,
+                                 _("Invalid line '%s' in the verify log "
+                                   "of '%s'"),
+                                 line,
+                                 svn_dirent_local_style(fs->path,
+                                                        scratch_pool));
+
+      if (rev < start || rev > end)
+        continue;
+
+      if (strcmp(status + 1, "ok") == 0)
+        verified[rev - start] |= 1;
+      else
+        verified[rev - start] |= 2;
+    }
+
+  for (rev = start; rev <= end; ++rev)
+    if (verified[rev - start] == 1)
+      APR_ARRAY_PUSH(*revisions, svn_revnum_t) = rev;
+
+  return SVN_NO_ERROR;
+}
@@ -39,4 +39,43 @@ svn_error_t *svn_fs_fs__verify(svn_fs_t *fs,
                                void *cancel_baton,
                                apr_pool_t *pool);
 
+/* Reconstruct the fulltexts of all representations added in revision REV
+ * of FS and compare them against their checksums, after checking the
+ * revision's index and rep-cache entries like svn_fs_fs__verify().  The
+ * revision's structure is not checked; see svn_fs_fs__verify_root().
+ * The optional CANCEL_FUNC will periodically be called with CANCEL_BATON.
+ * Use SCRATCH_POOL for temporary allocations. */
+svn_error_t *
+svn_fs_fs__verify_rev_contents(svn_fs_t *fs,
+                               svn_revnum_t rev,
+                               svn_cancel_func_t cancel_func,
+                               void *cancel_baton,
+                               apr_pool_t *scratch_pool);
+
+/* Allocate a background verifier in *VERIFIER, using RESULT_POOL, which
+ * must be the common pool of the FSFS shared data.  Set *VERIFIER to NULL
+ * if APR has been built without thread support. */
+svn_error_t *
+svn_fs_fs__create_verifier(fs_fs_verifier_t **verifier,
+                           apr_pool_t *result_pool);
+
+/* Let the background verifier of FS call svn_fs_fs__verify_rev_contents()
+ * for the just committed revision REV and append the result to the
+ * verify log.  Do nothing if there is no verifier.  Use SCRATCH_POOL for
+ * temporary allocations. */
+svn_error_t *
+svn_fs_fs__verify_after_commit(svn_fs_t *fs,
+                               svn_revnum_t rev,
+                               apr_pool_t *scratch_pool);
+
+/* Implements svn_fs__get_verified_revisions() by reading the verify log
+ * of FS. */
+svn_error_t *
+svn_fs_fs__get_verified_revisions(apr_array_header_t **revisions,
+                                  svn_fs_t *fs,
+                                  svn_revnum_t start,
+                                  svn_revnum_t end,
+                                  apr_pool_t *result_pool,
+                                  apr_pool_t *scratch_pool);
+
 #endif
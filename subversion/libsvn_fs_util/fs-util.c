@@ -28,13 +28,16 @@
 
 #include "svn_private_config.h"
 #include "svn_hash.h"
+#include "svn_pools.h"
 #include "svn_fs.h"
 #include "svn_dirent_uri.h"
 #include "svn_path.h"
 #include "svn_version.h"
 
+#include "private/svn_atomic.h"
 #include "private/svn_fs_util.h"
 #include "private/svn_fspath.h"
+#include "private/svn_mutex.h"
 #include "private/svn_subr_private.h"
 #include "../libsvn_fs/fs-loader.h"
 
@@ -347,3 +350,146 @@ svn_fs__prop_lists_equal(apr_hash_t *a,
   /* No difference found. */
   return TRUE;
 }
+
+svn_error_t *
+svn_fs__io_trace_item(svn_fs__io_trace_t *trace,
+                      svn_revnum_t revision,
+                      apr_uint64_t item_index,
+                      const char *item_type,
+                      svn_boolean_t cache_hit,
+                      apr_off_t offset,
+                      apr_off_t size,
+                      apr_pool_t *scratch_pool)
+{
+  if (!trace)
+    return SVN_NO_ERROR;
+
+  if (cache_hit)
+    {
+      ++trace->stats.cache_hits;
+    }
+  else
+    {
+      ++trace->stats.items_read;
+      if (size > 0)
+        trace->stats.bytes_read += size;
+    }
+
+  if (trace->events)
+    {
+      const char *line
+        = apr_psprintf(scratch_pool,
+                       "{\"rev\":%ld,\"item\":%" APR_UINT64_T_FMT ","
+                       "\"offset\":%" APR_OFF_T_FMT ","
+                       "\"size\":%" APR_OFF_T_FMT ","
+                       "\"type\":\"%s\",\"cache\":\"%s\"}\n",
+                       revision, item_index,
+                       cache_hit ? (apr_off_t)-1 : offset,
+                       cache_hit ? (apr_off_t)-1 : size,
+                       item_type, cache_hit ? "hit" : "miss");
+
+      SVN_ERR(svn_stream_puts(trace->events, line));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+apr_time_t
+svn_fs__timing_start(const svn_fs__commit_timing_t *timing)
+{
+  return (timing && timing->func) ? apr_time_now() : 0;
+}
+
+void
+svn_fs__timing_phase(const svn_fs__commit_timing_t *timing,
+                     const char *phase,
+                     apr_time_t start,
+                     apr_pool_t *scratch_pool)
+{
+  if (timing && timing->func)
+    timing->func(timing->baton, phase, apr_time_now() - start,
+                 scratch_pool);
+}
+
+/* Process-global registry of cache key prefixes, initialized by
+ * init_cache_prefixes(). */
+static volatile svn_atomic_t cache_prefixes_init_state = 0;
+static apr_pool_t *cache_prefixes_pool = NULL;
+static svn_mutex__t *cache_prefixes_mutex = NULL;
+
+/* Key prefix -> absolute repository filesystem path. */
+static apr_hash_t *cache_prefixes = NULL;
+
+/* Implements svn_atomic__err_init_func_t. */
+static svn_error_t *
+init_cache_prefixes(void *baton,
+                    apr_pool_t *pool)
+{
+  cache_prefixes_pool = svn_pool_create(NULL);
+  SVN_ERR(svn_mutex__init(&cache_prefixes_mutex, TRUE,
+                          cache_prefixes_pool));
+  cache_prefixes = apr_hash_make(cache_prefixes_pool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Add PREFIX for FS_PATH to the registry unless it is already known.
+ * To be called with CACHE_PREFIXES_MUTEX being held. */
+static svn_error_t *
+add_cache_prefix(const char *prefix,
+                 const char *fs_path)
+{
+  if (!svn_hash_gets(cache_prefixes, prefix))
+    svn_hash_sets(cache_prefixes,
+                  apr_pstrdup(cache_prefixes_pool, prefix),
+                  apr_pstrdup(cache_prefixes_pool, fs_path));
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_fs__register_cache_prefix(const char *prefix,
+                              const char *fs_path,
+                              apr_pool_t *scratch_pool)
+{
+  SVN_ERR(svn_atomic__init_once(&cache_prefixes_init_state,
+                                init_cache_prefixes, NULL, scratch_pool));
+  SVN_ERR(svn_dirent_get_absolute(&fs_path, fs_path, scratch_pool));
+
+  SVN_MUTEX__WITH_LOCK(cache_prefixes_mutex,
+                       add_cache_prefix(prefix, fs_path));
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *PREFIXES to a copy of the registry allocated in RESULT_POOL.
+ * To be called with CACHE_PREFIXES_MUTEX being held. */
+static svn_error_t *
+copy_cache_prefixes(apr_hash_t **prefixes,
+                    apr_pool_t *result_pool)
+{
+  apr_hash_index_t *hi;
+
+  *prefixes = apr_hash_make(result_pool);
+  for (hi = apr_hash_first(result_pool, cache_prefixes);
+       hi;
+       hi = apr_hash_next(hi))
+    svn_hash_sets(*prefixes,
+                  apr_pstrdup(result_pool, apr_hash_this_key(hi)),
+                  apr_pstrdup(result_pool, apr_hash_this_val(hi)));
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_fs__get_cache_prefixes(apr_hash_t **prefixes,
+                           apr_pool_t *result_pool)
+{
+  SVN_ERR(svn_atomic__init_once(&cache_prefixes_init_state,
+                                init_cache_prefixes, NULL, result_pool));
+
+  SVN_MUTEX__WITH_LOCK(cache_prefixes_mutex,
+                       copy_cache_prefixes(prefixes, result_pool));
+
+  return SVN_NO_ERROR;
+}
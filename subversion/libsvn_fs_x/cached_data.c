@@ -1425,6 +1425,56 @@ read_container_window(svn_stringbuf_t **nwin,
   return SVN_NO_ERROR;
 }
 
+/* Look up the txdelta windows number CHUNK_INDEX of all representations
+ * in RB->RS_LIST in a single cache request.  Set *WINDOWS to an array of
+ * svn_fs_x__txdelta_cached_window_t * with one element per entry in
+ * RB->RS_LIST, NULL for windows that are not cached.  Set *WINDOWS to
+ * NULL if there is no window cache to ask.  Only windows that
+ * read_delta_window would look up in the cache will be considered.
+ *
+ * Allocate the windows in RESULT_POOL and use SCRATCH_POOL for temporary
+ * allocations.
+ */
+static svn_error_t *
+get_cached_windows(apr_array_header_t **windows,
+                   rep_read_baton_t *rb,
+                   int chunk_index,
+                   apr_pool_t *result_pool,
+                   apr_pool_t *scratch_pool)
+{
+  svn_cache__t *window_cache = NULL;
+  apr_array_header_t *keys;
+  int i;
+
+  keys = apr_array_make(scratch_pool, rb->rs_list->nelts,
+                        sizeof(const void *));
+  for (i = 0; i < rb->rs_list->nelts; ++i)
+    {
+      rep_state_t *rs = APR_ARRAY_IDX(rb->rs_list, i, rep_state_t *);
+      svn_fs_x__window_cache_key_t *key = NULL;
+
+      /* Same condition as in read_delta_window. */
+      if (   rs->chunk_index == 0
+          && svn_fs_x__is_revision(rs->rep_id.change_set)
+          && rs->window_cache)
+        {
+          window_cache = rs->window_cache;
+          key = apr_pcalloc(scratch_pool, sizeof(*key));
+          get_window_key(key, rs);
+          key->chunk_index = chunk_index;
+        }
+
+      APR_ARRAY_PUSH(keys, const void *) = key;
+    }
+
+  if (window_cache)
+    SVN_ERR(svn_cache__get_many(windows, window_cache, keys, result_pool));
+  else
+    *windows = NULL;
+
+  return SVN_NO_ERROR;
+}
+
 /* Get the undeltified window that is a result of combining all deltas
    from the current desired representation identified in *RB with its
    base representation.  Store the window in *RESULT. */
@@ -1438,6 +1488,7 @@ get_combined_window(svn_stringbuf_t **result,
   svn_stringbuf_t *source, *buf = rb->base_window;
   rep_state_t *rs;
   apr_pool_t *iterpool;
+  apr_array_header_t *cached_windows = NULL;
 
   /* Read all windows that we need to combine. This is fine because
      the size of each window is relatively small (100kB) and skip-
@@ -1446,15 +1497,36 @@ get_combined_window(svn_stringbuf_t **result,
   window_pool = svn_pool_create(rb->scratch_pool);
   windows = apr_array_make(window_pool, 0, sizeof(svn_txdelta_window_t *));
   iterpool = svn_pool_create(rb->scratch_pool);
+
+  /* Fetch whatever the cache has for this chunk in one go. */
+  if (rb->rs_list->nelts > 1)
+    SVN_ERR(get_cached_windows(&cached_windows, rb, rb->chunk_index,
+                               window_pool, iterpool));
+
   for (i = 0; i < rb->rs_list->nelts; ++i)
     {
       svn_txdelta_window_t *window;
+      svn_fs_x__txdelta_cached_window_t *cached_window = NULL;
 
       svn_pool_clear(iterpool);
 
       rs = APR_ARRAY_IDX(rb->rs_list, i, rep_state_t *);
-      SVN_ERR(read_delta_window(&window, rb->chunk_index, rs, window_pool,
-                                iterpool));
+      if (cached_windows)
+        cached_window = APR_ARRAY_IDX(cached_windows, i,
+                                      svn_fs_x__txdelta_cached_window_t *);
+
+      if (cached_window)
+        {
+          /* manipulate the RS as if we just read the data */
+          window = cached_window->window;
+          rs->current = cached_window->end_offset;
+          rs->chunk_index = rb->chunk_index;
+        }
+      else
+        {
+          SVN_ERR(read_delta_window(&window, rb->chunk_index, rs,
+                                    window_pool, iterpool));
+        }
 
       APR_ARRAY_PUSH(windows, svn_txdelta_window_t *) = window;
       if (window->src_ops == 0)
@@ -2375,11 +2447,13 @@ svn_fs_x__get_file_delta_stream(svn_txdelta_stream_t **stream_p,
   svn_stream_t *source_stream, *target_stream;
   rep_state_t *rep_state;
   svn_fs_x__rep_header_t *rep_header;
+  svn_fs_x__data_t *ffd = fs->fsap_data;
 
   /* Try a shortcut: if the target is stored as a delta against the source,
      then just use that delta.  However, prefer using the fulltext cache
-     whenever that is available. */
-  if (target->data_rep && source)
+     whenever that is available.  Large delta windows are only for storage;
+     our callers may need to encode windows as older svndiff versions. */
+  if (target->data_rep && source && !ffd->large_delta_windows)
     {
       /* Read target's base rep if any. */
       SVN_ERR(create_rep_state(&rep_state, &rep_header, NULL,
@@ -39,6 +39,7 @@
 #include "svn_pools.h"
 
 #include "private/svn_debug.h"
+#include "private/svn_fs_util.h"
 #include "private/svn_subr_private.h"
 
 /* Take the ORIGINAL string and replace all occurrences of ":" without
@@ -356,6 +357,9 @@ create_cache(svn_cache__t **cache_p,
                 cache_p, membuffer, serializer, deserializer,
                 klen, prefix, priority, FALSE, has_namespace,
                 result_pool, scratch_pool));
+
+      /* Don't let bulk scans through FS push out frequently used data. */
+      svn_cache__membuffer_set_bulk_hint(*cache_p, &fs->bulk_scan);
     }
   else if (pages)
     {
@@ -409,6 +413,10 @@ svn_fs_x__initialize_caches(svn_fs_t *fs,
 
   membuffer = svn_cache__get_global_membuffer_cache();
 
+  /* Allow the contents of our caches to survive server restarts. */
+  if (membuffer)
+    SVN_ERR(svn_fs__register_cache_prefix(prefix, fs->path, scratch_pool));
+
   /* General rules for assigning cache priorities:
    *
    * - Data that can be reconstructed from other elements has low prio
@@ -66,6 +66,7 @@
 
 #include "private/svn_mergeinfo_private.h"
 #include "private/svn_subr_private.h"
+#include "private/svn_sorts_private.h"
 #include "private/svn_fs_util.h"
 #include "private/svn_fspath.h"
 #include "../libsvn_fs/fs-loader.h"
@@ -1086,6 +1087,153 @@ svn_fs_x__get_temp_dag_node(dag_node_t **node_p,
 }
 
 
+/* A path to look up with svn_fs_x__get_dag_nodes. */
+typedef struct batch_path_t
+{
+  /* The normalized path. */
+  svn_string_t path;
+
+  /* Its index in the caller's PATHS array. */
+  int index;
+} batch_path_t;
+
+/* One directory of the path currently being looked up by
+   svn_fs_x__get_dag_nodes. */
+typedef struct batch_level_t
+{
+  /* The directory's node.  Not owned by the DAG cache. */
+  dag_node_t *node;
+
+  /* Name of the directory within its parent. */
+  const char *name;
+} batch_level_t;
+
+/* Compare the normalized paths of batch_path_t LHS and RHS such that all
+   paths of the same sub-tree end up next to each other. */
+static int
+compare_batch_paths(const void *lhs,
+                    const void *rhs)
+{
+  const svn_string_t *lhs_path = &((const batch_path_t *)lhs)->path;
+  const svn_string_t *rhs_path = &((const batch_path_t *)rhs)->path;
+  apr_size_t len = MIN(lhs_path->len, rhs_path->len);
+  apr_size_t i;
+
+  for (i = 0; i < len; ++i)
+    if (lhs_path->data[i] != rhs_path->data[i])
+      {
+        /* '/' sorts before all other characters. */
+        unsigned char lhs_char = lhs_path->data[i] == '/'
+                               ? 0 : (unsigned char)lhs_path->data[i];
+        unsigned char rhs_char = rhs_path->data[i] == '/'
+                               ? 0 : (unsigned char)rhs_path->data[i];
+
+        return lhs_char < rhs_char ? -1 : 1;
+      }
+
+  return lhs_path->len < rhs_path->len ? -1
+       : lhs_path->len > rhs_path->len ? 1
+       : 0;
+}
+
+svn_error_t *
+svn_fs_x__get_dag_nodes(apr_array_header_t **nodes_p,
+                        svn_fs_root_t *root,
+                        const apr_array_header_t *paths,
+                        apr_pool_t *result_pool,
+                        apr_pool_t *scratch_pool)
+{
+  svn_fs_x__change_set_t change_set = svn_fs_x__root_change_set(root);
+  apr_array_header_t *nodes = apr_array_make(result_pool, paths->nelts,
+                                             sizeof(dag_node_t *));
+  apr_array_header_t *sorted = apr_array_make(scratch_pool, paths->nelts,
+                                              sizeof(batch_path_t));
+  apr_array_header_t *stack = apr_array_make(scratch_pool, 16,
+                                             sizeof(batch_level_t));
+  svn_stringbuf_t *entry_buffer = svn_stringbuf_create_ensure(64,
+                                                              scratch_pool);
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  batch_level_t level;
+  dag_node_t *node;
+  int i;
+
+  /* Process the paths in tree order such that consecutive paths will
+     share as many parent directories as possible. */
+  for (i = 0; i < paths->nelts; ++i)
+    {
+      batch_path_t batch_path;
+      normalize_path(&batch_path.path, APR_ARRAY_IDX(paths, i, const char *));
+      batch_path.index = i;
+
+      APR_ARRAY_PUSH(sorted, batch_path_t) = batch_path;
+      APR_ARRAY_PUSH(nodes, dag_node_t *) = NULL;
+    }
+
+  svn_sort__array(sorted, compare_batch_paths);
+
+  /* STACK holds the directories along the last path, starting at the
+     root.  Nodes in the DAG cache may become invalid upon the next
+     insertion, so keep copies of them. */
+  SVN_ERR(get_root_node(&node, root, change_set, iterpool));
+  level.node = svn_fs_x__dag_dup(node, scratch_pool);
+  level.name = "";
+  APR_ARRAY_PUSH(stack, batch_level_t) = level;
+
+  for (i = 0; i < sorted->nelts; ++i)
+    {
+      const batch_path_t *batch_path = &APR_ARRAY_IDX(sorted, i,
+                                                      batch_path_t);
+      svn_string_t path = { batch_path->path.data, 0 };
+      const char *entry;
+      int depth = 1;
+
+      svn_pool_clear(iterpool);
+
+      /* Skip the directories shared with the previous path. */
+      for (entry = next_entry_name(&path, entry_buffer);
+           entry
+             && depth < stack->nelts
+             && strcmp(entry, APR_ARRAY_IDX(stack, depth,
+                                            batch_level_t).name) == 0;
+           entry = next_entry_name(&path, entry_buffer))
+        ++depth;
+
+      stack->nelts = depth;
+      node = APR_ARRAY_IDX(stack, depth - 1, batch_level_t).node;
+
+      /* Walk the remainder of the path. */
+      for (; entry && node; entry = next_entry_name(&path, entry_buffer))
+        {
+          /* Files don't have sub-nodes. */
+          if (svn_fs_x__dag_node_kind(node) != svn_node_dir)
+            {
+              node = NULL;
+              break;
+            }
+
+          SVN_ERR(dag_step(&node, root, node, entry, &path, change_set,
+                           TRUE, iterpool));
+          if (node)
+            {
+              level.node = svn_fs_x__dag_dup(node, scratch_pool);
+              level.name = apr_pstrdup(scratch_pool, entry);
+              APR_ARRAY_PUSH(stack, batch_level_t) = level;
+
+              node = level.node;
+            }
+        }
+
+      if (node)
+        APR_ARRAY_IDX(nodes, batch_path->index, dag_node_t *)
+          = svn_fs_x__dag_dup(node, result_pool);
+    }
+
+  svn_pool_destroy(iterpool);
+  *nodes_p = nodes;
+
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *
 svn_fs_x__get_dag_node(dag_node_t **dag_node_p,
                        svn_fs_root_t *root,
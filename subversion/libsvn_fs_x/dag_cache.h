@@ -163,6 +163,19 @@ svn_fs_x__get_dag_node(dag_node_t **dag_node_p,
                        apr_pool_t *result_pool,
                        apr_pool_t *scratch_pool);
 
+/* Open the nodes identified by the const char * PATHS in ROOT in a single
+   traversal that looks up common parent directories only once.  Set *NODES
+   to an array of the same length, holding the dag_node_t * for each of the
+   PATHS, allocated in RESULT_POOL, or NULL if that path does not exist.
+   Use SCRATCH_POOL for temporary allocations.
+ */
+svn_error_t *
+svn_fs_x__get_dag_nodes(apr_array_header_t **nodes,
+                        svn_fs_root_t *root,
+                        const apr_array_header_t *paths,
+                        apr_pool_t *result_pool,
+                        apr_pool_t *scratch_pool);
+
 /* Add / update the NODE in the node cache. */
 void
 svn_fs_x__update_dag_cache(dag_node_t *node);
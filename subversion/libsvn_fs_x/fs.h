@@ -104,6 +104,7 @@ extern "C" {
 #define CONFIG_OPTION_MAX_DELTIFICATION_WALK     "max-deltification-walk"
 #define CONFIG_OPTION_MAX_LINEAR_DELTIFICATION   "max-linear-deltification"
 #define CONFIG_OPTION_COMPRESSION_LEVEL  "compression-level"
+#define CONFIG_OPTION_LARGE_DELTA_WINDOWS  "large-delta-windows"
 #define CONFIG_SECTION_PACKED_REVPROPS   "packed-revprops"
 #define CONFIG_OPTION_REVPROP_PACK_SIZE  "revprop-pack-size"
 #define CONFIG_OPTION_COMPRESS_PACKED_REVPROPS  "compress-packed-revprops"
@@ -111,6 +112,9 @@ extern "C" {
 #define CONFIG_OPTION_BLOCK_SIZE         "block-size"
 #define CONFIG_OPTION_L2P_PAGE_SIZE      "l2p-page-size"
 #define CONFIG_OPTION_P2L_PAGE_SIZE      "p2l-page-size"
+#define CONFIG_SECTION_PACK              "pack"
+#define CONFIG_OPTION_PACK_JOBS          "jobs"
+#define CONFIG_OPTION_ADAPTIVE_CONTAINERS "adaptive-containers"
 #define CONFIG_SECTION_DEBUG             "debug"
 #define CONFIG_OPTION_PACK_AFTER_COMMIT  "pack-after-commit"
 
@@ -274,6 +278,14 @@ typedef struct svn_fs_x__data_t
   /* Rev / pack file granularity covered by phys-to-log index pages */
   apr_int64_t p2l_page_size;
 
+  /* Maximum number of threads building representation containers
+   * concurrently during pack. */
+  int pack_jobs;
+
+  /* If set, pack may grow representation containers beyond the block
+   * size as long as the added reps are estimated to compress well. */
+  svn_boolean_t adaptive_containers;
+
   /* The revision that was youngest, last time we checked. */
   svn_revnum_t youngest_rev_cache;
 
@@ -394,6 +406,9 @@ typedef struct svn_fs_x__data_t
   /* Compression level to use with txdelta storage format in new revs. */
   int delta_compression_level;
 
+  /* Store new deltas as svndiff3 using large, sliding windows. */
+  svn_boolean_t large_delta_windows;
+
   /* Pack after every commit. */
   svn_boolean_t pack_after_commit;
 
@@ -262,6 +262,7 @@ read_config(svn_fs_x__data_t *ffd,
 {
   svn_config_t *config;
   apr_int64_t compression_level;
+  apr_int64_t pack_jobs;
 
   SVN_ERR(svn_config_read3(&config,
                            svn_dirent_join(fs_path, PATH_CONFIG, scratch_pool),
@@ -288,6 +289,10 @@ read_config(svn_fs_x__data_t *ffd,
   ffd->delta_compression_level
     = (int)MIN(MAX(SVN_DELTA_COMPRESSION_LEVEL_NONE, compression_level),
                 SVN_DELTA_COMPRESSION_LEVEL_MAX);
+  SVN_ERR(svn_config_get_bool(config, &ffd->large_delta_windows,
+                              CONFIG_SECTION_DELTIFICATION,
+                              CONFIG_OPTION_LARGE_DELTA_WINDOWS,
+                              FALSE));
 
   /* Initialize revprop packing settings in ffd. */
   SVN_ERR(svn_config_get_bool(config, &ffd->compress_packed_revprops,
@@ -332,6 +337,19 @@ read_config(svn_fs_x__data_t *ffd,
   ffd->p2l_page_size *= 0x400;
   /* L2P pages are in entries - not in (k)Bytes */
 
+  /* Pack settings. */
+  SVN_ERR(svn_config_get_int64(config, &pack_jobs,
+                               CONFIG_SECTION_PACK,
+                               CONFIG_OPTION_PACK_JOBS,
+                               1));
+  SVN_ERR(svn_config_get_bool(config, &ffd->adaptive_containers,
+                              CONFIG_SECTION_PACK,
+                              CONFIG_OPTION_ADAPTIVE_CONTAINERS,
+                              FALSE));
+
+  /* Silently limit the number of jobs to something reasonable. */
+  ffd->pack_jobs = (int)MAX(1, MIN(pack_jobs, 64));
+
   /* Debug options. */
   SVN_ERR(svn_config_get_bool(config, &ffd->pack_after_commit,
                               CONFIG_SECTION_DEBUG,
@@ -457,6 +475,17 @@ write_config(svn_fs_t *fs,
 "### and 0 disabling it altogether."                                         NL
 "### The default value is 5."                                                NL
 "# " CONFIG_OPTION_COMPRESSION_LEVEL " = 5"                                  NL
+"###"                                                                        NL
+"### Deltas normally use windows of 100 kB that start at fixed offsets."     NL
+"### Data that insertions or deletions move across window boundaries is"    NL
+"### then no longer found, which makes deltas of zip-based documents and"   NL
+"### other large binaries ineffective.  Enabling this option stores new"    NL
+"### deltas in svndiff3 format with 1 MB windows whose source views slide"  NL
+"### forward by half a window at a time.  That costs more memory and CPU"   NL
+"### during commits.  Once enabled, this option should not be disabled"     NL
+"### again, as revisions written in the meantime need it."                  NL
+"### The default value is false."                                           NL
+"# " CONFIG_OPTION_LARGE_DELTA_WINDOWS " = false"                           NL
 ""                                                                           NL
 "[" CONFIG_SECTION_PACKED_REVPROPS "]"                                       NL
 "### This parameter controls the size (in kBytes) of packed revprop files."  NL
@@ -528,6 +557,23 @@ write_config(svn_fs_t *fs,
 "### Must be a power of 2."                                                  NL
 "### p2l-page-size is given in kBytes and with a default of 1024 kBytes."    NL
 "# " CONFIG_OPTION_P2L_PAGE_SIZE " = 1024"                                   NL
+""                                                                           NL
+"[" CONFIG_SECTION_PACK "]"                                                  NL
+"### 'svnadmin pack' combines file and directory properties into star-delta" NL
+"### containers.  This parameter sets the maximum number of threads that"    NL
+"### build those containers concurrently.  The disk access itself remains"   NL
+"### sequential, i.e. this only helps on multi-core machines.  It has no"    NL
+"### effect if APR has been built without thread support.  The default is"   NL
+"### 1, i.e. containers get built by the packing thread itself."             NL
+"# " CONFIG_OPTION_PACK_JOBS " = 1"                                          NL
+"###"                                                                        NL
+"### By default, containers are limited to about the size of one block."     NL
+"### If adaptive-containers is enabled, containers will keep growing up to"  NL
+"### 16 blocks for as long as the properties being added are estimated to"   NL
+"### compress well against the data already in the container.  This saves"   NL
+"### disk space for repositories with many similar properties at the cost"   NL
+"### of slightly slower access to individual properties."                    NL
+"# " CONFIG_OPTION_ADAPTIVE_CONTAINERS " = false"                            NL
 ;
 #undef NL
   return svn_io_file_create(svn_dirent_join(fs->path, PATH_CONFIG,
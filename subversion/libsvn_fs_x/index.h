@@ -75,33 +75,6 @@ svn_fs_x__packed_stream_open(svn_fs_x__packed_number_stream_t **stream,
                              apr_pool_t *result_pool,
                              apr_pool_t *scratch_pool);
 
-/* (user visible) entry in the phys-to-log index.  It describes a section
- * of some packed / non-packed rev file as containing a specific item.
- * There must be no overlapping / conflicting entries.
- */
-typedef struct svn_fs_x__p2l_entry_t
-{
-  /* offset of the first byte that belongs to the item */
-  apr_off_t offset;
-
-  /* length of the item in bytes */
-  apr_off_t size;
-
-  /* type of the item (see SVN_FS_X__ITEM_TYPE_*) defines */
-  apr_uint32_t type;
-
-  /* modified FNV-1a checksum.  0 if unknown checksum */
-  apr_uint32_t fnv1_checksum;
-
-  /* Number of items in this block / container.  Their list can be found
-   * in *ITEMS.  0 for unused sections.  1 for non-container items,
-   * > 1 for containers. */
-  apr_uint32_t item_count;
-
-  /* List of items in that block / container */
-  svn_fs_x__id_t *items;
-} svn_fs_x__p2l_entry_t;
-
 /* Return a (deep) copy of ENTRY, allocated in RESULT_POOL.
  */
 svn_fs_x__p2l_entry_t *
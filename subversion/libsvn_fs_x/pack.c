@@ -28,6 +28,7 @@
 #include "private/svn_subr_private.h"
 #include "private/svn_string_private.h"
 #include "private/svn_temp_serializer.h"
+#include "private/svn_worker_pool.h"
 
 #include "fs_x.h"
 #include "pack.h"
@@ -65,6 +66,9 @@
  * revision files to temporary files.  The latter serve as buckets for a
  * very coarse bucket presort:  Separate change lists, file properties,
  * directory properties and noderevs + representations from one another.
+ * Each revision file gets read strictly sequentially and only once: We
+ * first read its whole P2L index and then stream its data section through
+ * a bounded read buffer, see rev_data_reader_t.
  *
  * The third step will determine an optimized placement for the items in
  * each of the 4 buckets separately.  The first three will simply order
@@ -90,6 +94,16 @@
  */
 #define DEFAULT_MAX_MEM (64 * 1024 * 1024)
 
+/* Size of the buffer through which we read the revision files.  Items up
+ * to that size will be processed in memory.  Larger ones get streamed.
+ */
+#define READ_BUFFER_SIZE (1024 * 1024)
+
+/* Upper limit for the size of adaptively sized reps containers, given in
+ * blocks.  Reps batches handed to a single builder are of that size, too.
+ */
+#define MAX_ADAPTIVE_CONTAINER_BLOCKS 16
+
 /* Data structure describing a node change at PATH, REVISION.
  * We will sort these instances by PATH and NODE_ID such that we can combine
  * similar nodes in the same reps container and store containers in path
@@ -126,6 +140,31 @@ typedef struct reference_t
   svn_fs_x__id_t from;
 } reference_t;
 
+/* Reads the data section of a revision file strictly sequentially and
+ * buffers it such that the items in it can be processed in memory.
+ */
+typedef struct rev_data_reader_t
+{
+  /* revision file to read from */
+  svn_fs_x__revision_file_t *rev_file;
+
+  /* buffered data, starting at offset BUFFER_START in REV_FILE */
+  char *buffer;
+
+  /* allocated and used bytes in BUFFER */
+  apr_size_t buffer_size;
+  apr_size_t buffer_len;
+
+  /* rev file offset corresponding to BUFFER[0] */
+  apr_off_t buffer_start;
+
+  /* end of the data section, i.e. where the indexes begin */
+  apr_off_t data_size;
+
+  /* pool to allocate larger buffers in */
+  apr_pool_t *pool;
+} rev_data_reader_t;
+
 /* This structure keeps track of all the temporary data and status that
  * needs to be kept around during the creation of one pack file.  After
  * each revision range (in case we can't process all revs at once due to
@@ -244,7 +283,7 @@ initialize_pack_context(pack_context_t *context,
                         const char *shard_dir,
                         svn_revnum_t shard_rev,
                         int max_items,
-                        svn_fs_x__batch_fsync_t *batch,
+                        svn_io__batch_fsync_t *batch,
                         svn_cancel_func_t cancel_func,
                         void *cancel_baton,
                         apr_pool_t *pool)
@@ -274,8 +313,8 @@ initialize_pack_context(pack_context_t *context,
   context->pack_file_path
     = svn_dirent_join(pack_file_dir, PATH_PACKED, pool);
 
-  SVN_ERR(svn_fs_x__batch_fsync_open_file(&context->pack_file, batch,
-                                          context->pack_file_path, pool));
+  SVN_ERR(svn_io__batch_fsync_open_file(&context->pack_file, batch,
+                                        context->pack_file_path, pool));
 
   /* Proto index files */
   SVN_ERR(svn_fs_x__l2p_proto_index_open(
@@ -461,21 +500,159 @@ write_null_bytes(apr_file_t *dest,
   return SVN_NO_ERROR;
 }
 
+/* Initialize READER for reading the data section of REV_FILE from the
+ * start.  Allocate buffers in RESULT_POOL.
+ */
+static svn_error_t *
+init_rev_data_reader(rev_data_reader_t *reader,
+                     svn_fs_x__revision_file_t *rev_file,
+                     apr_pool_t *result_pool)
+{
+  svn_filesize_t data_size;
+
+  SVN_ERR(svn_fs_x__rev_file_data_size(&data_size, rev_file));
+  SVN_ERR(svn_fs_x__rev_file_seek(rev_file, NULL, 0));
+
+  reader->rev_file = rev_file;
+  reader->buffer_size = (apr_size_t)MIN(READ_BUFFER_SIZE, data_size);
+  reader->buffer = apr_palloc(result_pool, reader->buffer_size);
+  reader->buffer_len = 0;
+  reader->buffer_start = 0;
+  reader->data_size = data_size;
+  reader->pool = result_pool;
+
+  return SVN_NO_ERROR;
+}
+
+/* Make sure that the SIZE bytes at OFFSET in READER's revision file are
+ * in READER's buffer and return a pointer to them in *DATA.  OFFSET must
+ * not be lower than in any previous call.  Data before OFFSET will be
+ * discarded.  Unless GROW is set, SIZE must not exceed the buffer size.
+ */
+static svn_error_t *
+read_rev_data(const char **data,
+              rev_data_reader_t *reader,
+              apr_off_t offset,
+              apr_size_t size,
+              svn_boolean_t grow)
+{
+  apr_off_t buffer_end = reader->buffer_start + reader->buffer_len;
+  apr_size_t to_read;
+
+  SVN_ERR_ASSERT(offset >= reader->buffer_start);
+  SVN_ERR_ASSERT(offset + (apr_off_t)size <= reader->data_size);
+
+  if (offset + (apr_off_t)size > buffer_end)
+    {
+      /* Keep the part of the buffer that we still need. */
+      apr_size_t keep = offset < buffer_end
+                      ? (apr_size_t)(buffer_end - offset)
+                      : 0;
+
+      if (size > reader->buffer_size)
+        {
+          char *old_buffer = reader->buffer;
+
+          SVN_ERR_ASSERT(grow);
+          reader->buffer_size = size;
+          reader->buffer = apr_palloc(reader->pool, size);
+          memcpy(reader->buffer, old_buffer + reader->buffer_len - keep,
+                 keep);
+        }
+      else
+        {
+          memmove(reader->buffer, reader->buffer + reader->buffer_len - keep,
+                  keep);
+        }
+
+      /* Skip unused space between the buffered data and OFFSET. */
+      if (offset > buffer_end)
+        SVN_ERR(svn_fs_x__rev_file_seek(reader->rev_file, NULL, offset));
+
+      /* Fill the buffer as far as the data section allows. */
+      reader->buffer_start = offset;
+      reader->buffer_len = keep;
+      to_read = (apr_size_t)MIN(reader->buffer_size - keep,
+                                reader->data_size - offset - keep);
+      SVN_ERR(svn_fs_x__rev_file_read(reader->rev_file,
+                                      reader->buffer + keep, to_read));
+      reader->buffer_len += to_read;
+    }
+
+  *data = reader->buffer + (offset - reader->buffer_start);
+
+  return SVN_NO_ERROR;
+}
+
+/* Return a stream for parsing the item given by ENTRY in READER's
+ * revision file.  If the item is larger than the buffer, only its first
+ * part will be available through the stream.  The stream becomes invalid
+ * with the next read from READER.  Allocate it in RESULT_POOL.
+ */
+static svn_error_t *
+rev_data_stream(svn_stream_t **stream,
+                rev_data_reader_t *reader,
+                svn_fs_x__p2l_entry_t *entry,
+                apr_pool_t *result_pool)
+{
+  svn_string_t *contents = apr_palloc(result_pool, sizeof(*contents));
+  contents->len = (apr_size_t)MIN(entry->size, reader->buffer_size);
+
+  /* Parse directly from the buffer. */
+  SVN_ERR(read_rev_data(&contents->data, reader, entry->offset,
+                        contents->len, FALSE));
+  *stream = svn_stream_from_string(contents, result_pool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Copy the item given by ENTRY from READER's revision file to the end of
+ * DEST using CONTEXT.  Use SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+copy_rev_data(pack_context_t *context,
+              apr_file_t *dest,
+              rev_data_reader_t *reader,
+              svn_fs_x__p2l_entry_t *entry,
+              apr_pool_t *scratch_pool)
+{
+  const char *data;
+  apr_size_t size = (apr_size_t)MIN(entry->size, reader->buffer_size);
+  apr_file_t *file;
+
+  SVN_ERR(read_rev_data(&data, reader, entry->offset, size, FALSE));
+  SVN_ERR(svn_io_file_write_full(dest, data, size, NULL, scratch_pool));
+  if (entry->size == size)
+    return SVN_NO_ERROR;
+
+  /* Large items get streamed.  They fill the whole buffer, i.e. the rev
+   * file is now positioned right behind the part that we just wrote. */
+  SVN_ERR_ASSERT(reader->buffer_start == entry->offset);
+  SVN_ERR(svn_fs_x__rev_file_get(&file, reader->rev_file));
+  SVN_ERR(copy_file_data(context, dest, file, entry->size - size,
+                         scratch_pool));
+
+  /* The buffer contents are all before the current file position now. */
+  reader->buffer_start = entry->offset + entry->size;
+  reader->buffer_len = 0;
+
+  return SVN_NO_ERROR;
+}
+
 /* Copy the "simple" item (changed paths list or property representation)
- * from the current position in REV_FILE to TEMP_FILE using CONTEXT.  Add
- * a copy of ENTRY to ENTRIES but with an updated offset value that points
- * to the copy destination in TEMP_FILE.
+ * given by ENTRY from READER to TEMP_FILE using CONTEXT.  Add a copy of
+ * ENTRY to ENTRIES but with an updated offset value that points to the
+ * copy destination in TEMP_FILE.
  * Use SCRATCH_POOL for temporary allocations.
  */
 static svn_error_t *
 copy_item_to_temp(pack_context_t *context,
                   apr_array_header_t *entries,
                   apr_file_t *temp_file,
-                  svn_fs_x__revision_file_t *rev_file,
+                  rev_data_reader_t *reader,
                   svn_fs_x__p2l_entry_t *entry,
                   apr_pool_t *scratch_pool)
 {
-  apr_file_t *file;
   svn_fs_x__p2l_entry_t *new_entry
     = svn_fs_x__p2l_entry_dup(entry, context->info_pool);
 
@@ -483,9 +660,7 @@ copy_item_to_temp(pack_context_t *context,
                                  scratch_pool));
   APR_ARRAY_PUSH(entries, svn_fs_x__p2l_entry_t *) = new_entry;
 
-  SVN_ERR(svn_fs_x__rev_file_get(&file, rev_file));
-  SVN_ERR(copy_file_data(context, temp_file, file, entry->size,
-                         scratch_pool));
+  SVN_ERR(copy_rev_data(context, temp_file, reader, entry, scratch_pool));
 
   return SVN_NO_ERROR;
 }
@@ -554,21 +729,20 @@ get_item(pack_context_t *context,
   return result;
 }
 
-/* Copy representation item identified by ENTRY from the current position
- * in REV_FILE into CONTEXT->REPS_FILE.  Add all tracking into needed by
- * our placement algorithm to CONTEXT.
+/* Copy representation item identified by ENTRY from READER into
+ * CONTEXT->REPS_FILE.  Add all tracking into needed by our placement
+ * algorithm to CONTEXT.
  * Use SCRATCH_POOL for temporary allocations.
  */
 static svn_error_t *
 copy_rep_to_temp(pack_context_t *context,
-                 svn_fs_x__revision_file_t *rev_file,
+                 rev_data_reader_t *reader,
                  svn_fs_x__p2l_entry_t *entry,
                  apr_pool_t *scratch_pool)
 {
   svn_fs_x__rep_header_t *rep_header;
   svn_stream_t *stream;
-  apr_file_t *file;
-  apr_off_t source_offset = entry->offset;
+  svn_fs_x__p2l_entry_t *source_entry = entry;
 
   /* create a copy of ENTRY, make it point to the copy destination and
    * store it in CONTEXT */
@@ -578,7 +752,7 @@ copy_rep_to_temp(pack_context_t *context,
   add_item_rep_mapping(context, entry);
 
   /* read & parse the representation header */
-  SVN_ERR(svn_fs_x__rev_file_stream(&stream, rev_file));
+  SVN_ERR(rev_data_stream(&stream, reader, source_entry, scratch_pool));
   SVN_ERR(svn_fs_x__read_rep_header(&rep_header, stream,
                                     scratch_pool, scratch_pool));
 
@@ -596,10 +770,8 @@ copy_rep_to_temp(pack_context_t *context,
     }
 
   /* copy the whole rep (including header!) to our temp file */
-  SVN_ERR(svn_fs_x__rev_file_seek(rev_file, NULL, source_offset));
-  SVN_ERR(svn_fs_x__rev_file_get(&file, rev_file));
-  SVN_ERR(copy_file_data(context, context->reps_file, file, entry->size,
-                         scratch_pool));
+  SVN_ERR(copy_rev_data(context, context->reps_file, reader, source_entry,
+                        scratch_pool));
 
   return SVN_NO_ERROR;
 }
@@ -672,14 +844,14 @@ tweak_path_for_ordering(const char *original,
    return path;
 }
 
-/* Copy node revision item identified by ENTRY from the current position
- * in REV_FILE into CONTEXT->REPS_FILE.  Add all tracking into needed by
- * our placement algorithm to CONTEXT.
+/* Copy node revision item identified by ENTRY from READER into
+ * CONTEXT->REPS_FILE.  Add all tracking into needed by our placement
+ * algorithm to CONTEXT.
  * Use SCRATCH_POOL for temporary allocations.
  */
 static svn_error_t *
 copy_node_to_temp(pack_context_t *context,
-                  svn_fs_x__revision_file_t *rev_file,
+                  rev_data_reader_t *reader,
                   svn_fs_x__p2l_entry_t *entry,
                   apr_pool_t *scratch_pool)
 {
@@ -687,12 +859,14 @@ copy_node_to_temp(pack_context_t *context,
                                          sizeof(*path_order));
   svn_fs_x__noderev_t *noderev;
   svn_stream_t *stream;
-  apr_file_t *file;
   const char *sort_path;
-  apr_off_t source_offset = entry->offset;
+  const char *data;
+  svn_fs_x__p2l_entry_t *source_entry = entry;
 
-  /* read & parse noderev */
-  SVN_ERR(svn_fs_x__rev_file_stream(&stream, rev_file));
+  /* read & parse noderev.  Those always get processed in memory. */
+  SVN_ERR(read_rev_data(&data, reader, entry->offset,
+                        (apr_size_t)entry->size, TRUE));
+  SVN_ERR(rev_data_stream(&stream, reader, entry, scratch_pool));
   SVN_ERR(svn_fs_x__read_noderev(&noderev, stream, scratch_pool,
                                  scratch_pool));
 
@@ -704,10 +878,8 @@ copy_node_to_temp(pack_context_t *context,
   add_item_rep_mapping(context, entry);
 
   /* copy the noderev to our temp file */
-  SVN_ERR(svn_fs_x__rev_file_seek(rev_file, NULL, source_offset));
-  SVN_ERR(svn_fs_x__rev_file_get(&file, rev_file));
-  SVN_ERR(copy_file_data(context, context->reps_file, file, entry->size,
-                         scratch_pool));
+  SVN_ERR(copy_rev_data(context, context->reps_file, reader, source_entry,
+                        scratch_pool));
 
   /* if the node has a data representation, make that the node's "base".
    * This will (often) cause the noderev to be placed right in front of
@@ -1164,13 +1336,15 @@ store_nodes(pack_context_t *context,
 }
 
 
-/* Finalize CONTAINER and write it to CONTEXT's pack file.
+/* Finalize CONTAINER and write it to CONTEXT's pack file.  If CONTAINER
+ * is NULL, write the already SERIALIZED container instead.
  * Append an P2L entry containing the given SUB_ITEMS to NEW_ENTRIES.
  * Use SCRATCH_POOL for temporary allocations.
  */
 static svn_error_t *
 write_reps_container(pack_context_t *context,
                      svn_fs_x__reps_builder_t *container,
+                     const svn_stringbuf_t *serialized,
                      apr_array_header_t *sub_items,
                      apr_array_header_t *new_entries,
                      apr_pool_t *scratch_pool)
@@ -1185,8 +1359,14 @@ write_reps_container(pack_context_t *context,
                                                           TRUE, scratch_pool),
                                  scratch_pool);
 
-  SVN_ERR(svn_fs_x__write_reps_container(pack_stream, container,
-                                         scratch_pool));
+  if (container)
+    SVN_ERR(svn_fs_x__write_reps_container(pack_stream, container,
+                                           scratch_pool));
+  else
+    {
+      apr_size_t len = serialized->len;
+      SVN_ERR(svn_stream_write(pack_stream, serialized->data, &len));
+    }
   SVN_ERR(svn_stream_close(pack_stream));
   SVN_ERR(svn_io_file_seek(context->pack_file, APR_CUR, &offset,
                            scratch_pool));
@@ -1207,6 +1387,49 @@ write_reps_container(pack_context_t *context,
   return SVN_NO_ERROR;
 }
 
+/* Read the fulltext of the representation identified by ENTRY from
+ * TEMP_FILE, which has also been wrapped as FILE, and return it in
+ * *CONTENTS.  Use CONTEXT for FS access.  Allocate the result in
+ * RESULT_POOL and use SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+read_rep_contents(svn_string_t **contents,
+                  pack_context_t *context,
+                  svn_fs_x__revision_file_t *file,
+                  apr_file_t *temp_file,
+                  svn_fs_x__p2l_entry_t *entry,
+                  apr_pool_t *result_pool,
+                  apr_pool_t *scratch_pool)
+{
+  svn_fs_x__representation_t representation = { 0 };
+  svn_stringbuf_t *text;
+  svn_stream_t *stream;
+
+  assert(entry->item_count == 1);
+  representation.id = entry->items[0];
+
+  /* select the rep in the source file and read its contents */
+  SVN_ERR(svn_io_file_seek(temp_file, APR_SET, &entry->offset,
+                           scratch_pool));
+  SVN_ERR(svn_fs_x__get_representation_length(&representation.size,
+                                         &representation.expanded_size,
+                                         context->fs, file,
+                                         entry, scratch_pool));
+  SVN_ERR(svn_fs_x__get_contents(&stream, context->fs, &representation,
+                                 FALSE, scratch_pool));
+  text = svn_stringbuf_create_ensure(representation.expanded_size,
+                                     result_pool);
+  text->len = representation.expanded_size;
+
+  /* The representation is immutable.  Read it normally. */
+  SVN_ERR(svn_stream_read_full(stream, text->data, &text->len));
+  SVN_ERR(svn_stream_close(stream));
+
+  *contents = svn_stringbuf__morph_into_string(text);
+
+  return SVN_NO_ERROR;
+}
+
 /* Read the (property) representations identified by svn_fs_x__p2l_entry_t
  * elements in ENTRIES from TEMP_FILE, aggregate them and write them into
  * CONTEXT->PACK_FILE.  Use SCRATCH_POOL for temporary allocations.
@@ -1236,9 +1459,7 @@ write_reps_containers(pack_context_t *context,
   /* copy all items in strict order */
   for (i = entries->nelts-1; i >= 0; --i)
     {
-      svn_fs_x__representation_t representation = { 0 };
-      svn_stringbuf_t *contents;
-      svn_stream_t *stream;
+      svn_string_t *contents;
       apr_size_t list_index;
       svn_fs_x__p2l_entry_t *entry
         = APR_ARRAY_IDX(entries, i, svn_fs_x__p2l_entry_t *);
@@ -1251,7 +1472,7 @@ write_reps_containers(pack_context_t *context,
 
       if ((block_left < entry->size) && sub_items->nelts)
         {
-          SVN_ERR(write_reps_container(context, container, sub_items,
+          SVN_ERR(write_reps_container(context, container, NULL, sub_items,
                                        new_entries, iterpool));
 
           apr_array_clear(sub_items);
@@ -1268,29 +1489,10 @@ write_reps_containers(pack_context_t *context,
           block_left = get_block_left(context);
         }
 
-      assert(entry->item_count == 1);
-      representation.id = entry->items[0];
-
-      /* select the change list in the source file, parse it and add it to
-       * the container */
-      SVN_ERR(svn_io_file_seek(temp_file, APR_SET, &entry->offset,
-                               iterpool));
-      SVN_ERR(svn_fs_x__get_representation_length(&representation.size,
-                                             &representation.expanded_size,
-                                             context->fs, file,
-                                             entry, iterpool));
-      SVN_ERR(svn_fs_x__get_contents(&stream, context->fs, &representation,
-                                     FALSE, iterpool));
-      contents = svn_stringbuf_create_ensure(representation.expanded_size,
-                                             iterpool);
-      contents->len = representation.expanded_size;
-
-      /* The representation is immutable.  Read it normally. */
-      SVN_ERR(svn_stream_read_full(stream, contents->data, &contents->len));
-      SVN_ERR(svn_stream_close(stream));
-
-      SVN_ERR(svn_fs_x__reps_add(&list_index, container,
-                                 svn_stringbuf__morph_into_string(contents)));
+      /* read the rep's contents and add it to the container */
+      SVN_ERR(read_rep_contents(&contents, context, file, temp_file, entry,
+                                iterpool, iterpool));
+      SVN_ERR(svn_fs_x__reps_add(&list_index, container, contents));
       SVN_ERR_ASSERT(list_index == sub_items->nelts);
       block_left -= entry->size;
 
@@ -1300,7 +1502,7 @@ write_reps_containers(pack_context_t *context,
     }
 
   if (sub_items->nelts)
-    SVN_ERR(write_reps_container(context, container, sub_items,
+    SVN_ERR(write_reps_container(context, container, NULL, sub_items,
                                  new_entries, iterpool));
 
   svn_pool_destroy(iterpool);
@@ -1309,6 +1511,448 @@ write_reps_containers(pack_context_t *context,
   return SVN_NO_ERROR;
 }
 
+/* A sequence of consecutive representations that will be turned into one
+ * or more reps containers, independently of any other batch.
+ */
+typedef struct reps_batch_t
+{
+  /* The reps as svn_fs_x__p2l_entry_t * in container order. */
+  apr_array_header_t *entries;
+
+  /* The fulltexts of ENTRIES as svn_string_t *. */
+  apr_array_header_t *contents;
+
+  /* The serialized containers (svn_stringbuf_t *) and the number of reps
+   * in each of them (int). */
+  apr_array_header_t *containers;
+  apr_array_header_t *rep_counts;
+
+  /* When building in parallel, the queue this batch belongs to and the
+   * job building CONTAINERS and REP_COUNTS. */
+  struct reps_batch_queue_t *queue;
+  svn_worker_pool__job_t *job;
+
+  /* Everything above gets allocated in this root pool.  It is only ever
+   * used by one thread at a time. */
+  apr_pool_t *pool;
+} reps_batch_t;
+
+/* Return TRUE if the rep given by ENTRY, with fulltext size CONTENTS_LEN,
+ * shall not be added to BUILDER but start a new reps container.
+ * BLOCK_SIZE and ADAPTIVE are the respective FS settings.  LAST_GROWTH
+ * and LAST_LEN are the increase in estimated container size caused by
+ * the rep added last and that rep's fulltext size.
+ */
+static svn_boolean_t
+reps_container_full(svn_fs_x__reps_builder_t *builder,
+                    svn_fs_x__p2l_entry_t *entry,
+                    apr_int64_t block_size,
+                    svn_boolean_t adaptive,
+                    apr_size_t last_growth,
+                    apr_size_t last_len)
+{
+  apr_size_t estimate = svn_fs_x__reps_estimate_size(builder);
+  if (estimate + entry->size <= block_size)
+    return FALSE;
+
+  /* If the reps still compress to less than a quarter of their size,
+   * the container is likely to stay efficient for a while. */
+  return !adaptive
+      || estimate + entry->size > MAX_ADAPTIVE_CONTAINER_BLOCKS * block_size
+      || last_growth * 4 > last_len;
+}
+
+/* Serialize BUILDER into a new entry of BATCH->CONTAINERS and record that
+ * it contains COUNT reps.  Use SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+serialize_reps_container(reps_batch_t *batch,
+                         svn_fs_x__reps_builder_t *builder,
+                         int count,
+                         apr_pool_t *scratch_pool)
+{
+  svn_stringbuf_t *serialized
+    = svn_stringbuf_create_ensure(svn_fs_x__reps_estimate_size(builder),
+                                  batch->pool);
+  svn_stream_t *stream = svn_stream_from_stringbuf(serialized, scratch_pool);
+
+  SVN_ERR(svn_fs_x__write_reps_container(stream, builder, scratch_pool));
+  SVN_ERR(svn_stream_close(stream));
+
+  APR_ARRAY_PUSH(batch->containers, svn_stringbuf_t *) = serialized;
+  APR_ARRAY_PUSH(batch->rep_counts, int) = count;
+
+  return SVN_NO_ERROR;
+}
+
+/* Build the containers for all reps in BATCH, using FS for the builders
+ * and sizing the containers according to BLOCK_SIZE and ADAPTIVE.
+ * This does not access FS itself and may be run in any thread.
+ */
+static svn_error_t *
+build_reps_batch(reps_batch_t *batch,
+                 svn_fs_t *fs,
+                 apr_int64_t block_size,
+                 svn_boolean_t adaptive)
+{
+  apr_pool_t *container_pool = svn_pool_create(batch->pool);
+  svn_fs_x__reps_builder_t *builder
+    = svn_fs_x__reps_builder_create(fs, container_pool);
+  apr_size_t last_growth = 0, last_len = 0;
+  int count = 0;
+  int i;
+
+  for (i = 0; i < batch->entries->nelts; ++i)
+    {
+      svn_fs_x__p2l_entry_t *entry
+        = APR_ARRAY_IDX(batch->entries, i, svn_fs_x__p2l_entry_t *);
+      const svn_string_t *contents
+        = APR_ARRAY_IDX(batch->contents, i, const svn_string_t *);
+      apr_size_t estimate = svn_fs_x__reps_estimate_size(builder);
+      apr_size_t list_index = 0;
+      svn_error_t *err;
+
+      if (count && reps_container_full(builder, entry, block_size, adaptive,
+                                       last_growth, last_len))
+        err = svn_error_create(SVN_ERR_FS_CONTAINER_SIZE, NULL, NULL);
+      else
+        err = svn_fs_x__reps_add(&list_index, builder, contents);
+
+      /* Start a new container if the current one is full. */
+      if (err && err->apr_err == SVN_ERR_FS_CONTAINER_SIZE && count)
+        {
+          svn_error_clear(err);
+          SVN_ERR(serialize_reps_container(batch, builder, count,
+                                           container_pool));
+
+          svn_pool_clear(container_pool);
+          builder = svn_fs_x__reps_builder_create(fs, container_pool);
+          count = 0;
+          estimate = svn_fs_x__reps_estimate_size(builder);
+
+          err = svn_fs_x__reps_add(&list_index, builder, contents);
+        }
+
+      SVN_ERR(err);
+      SVN_ERR_ASSERT(list_index == count);
+
+      last_growth = svn_fs_x__reps_estimate_size(builder) - estimate;
+      last_len = contents->len;
+      ++count;
+    }
+
+  if (count)
+    SVN_ERR(serialize_reps_container(batch, builder, count, container_pool));
+
+  svn_pool_destroy(container_pool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Clear BATCH and fill it with the reps from ENTRIES, going down from
+ * index *NEXT, until their total size reaches the maximum container size.
+ * Update *NEXT to the first entry not taken.  Read the reps from
+ * TEMP_FILE, which has also been wrapped as FILE.  Use CONTEXT for FS
+ * access and SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+read_reps_batch(reps_batch_t *batch,
+                pack_context_t *context,
+                apr_array_header_t *entries,
+                int *next,
+                svn_fs_x__revision_file_t *file,
+                apr_file_t *temp_file,
+                apr_pool_t *scratch_pool)
+{
+  svn_fs_x__data_t *ffd = context->fs->fsap_data;
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  apr_int64_t batch_size = 0;
+
+  svn_pool_clear(batch->pool);
+  batch->entries = apr_array_make(batch->pool, 16,
+                                  sizeof(svn_fs_x__p2l_entry_t *));
+  batch->contents = apr_array_make(batch->pool, 16, sizeof(svn_string_t *));
+  batch->containers = apr_array_make(batch->pool, 4,
+                                     sizeof(svn_stringbuf_t *));
+  batch->rep_counts = apr_array_make(batch->pool, 4, sizeof(int));
+
+  for (; *next >= 0; --*next)
+    {
+      svn_string_t *contents;
+      svn_fs_x__p2l_entry_t *entry
+        = APR_ARRAY_IDX(entries, *next, svn_fs_x__p2l_entry_t *);
+
+      if (   batch->entries->nelts
+          && batch_size + entry->size
+               > MAX_ADAPTIVE_CONTAINER_BLOCKS * ffd->block_size)
+        break;
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(read_rep_contents(&contents, context, file, temp_file, entry,
+                                batch->pool, iterpool));
+
+      APR_ARRAY_PUSH(batch->entries, svn_fs_x__p2l_entry_t *) = entry;
+      APR_ARRAY_PUSH(batch->contents, svn_string_t *) = contents;
+      batch_size += entry->size;
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Write the containers of the completed BATCH to CONTEXT's pack file and
+ * append their P2L entries to NEW_ENTRIES.  Use SCRATCH_POOL for temporary
+ * allocations.
+ */
+static svn_error_t *
+store_reps_batch(pack_context_t *context,
+                 reps_batch_t *batch,
+                 apr_array_header_t *new_entries,
+                 apr_pool_t *scratch_pool)
+{
+  svn_fs_x__data_t *ffd = context->fs->fsap_data;
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  int first = 0;
+  int i, k;
+
+  for (i = 0; i < batch->containers->nelts; ++i)
+    {
+      const svn_stringbuf_t *serialized
+        = APR_ARRAY_IDX(batch->containers, i, const svn_stringbuf_t *);
+      int count = APR_ARRAY_IDX(batch->rep_counts, i, int);
+      apr_array_header_t *sub_items;
+
+      svn_pool_clear(iterpool);
+      sub_items = apr_array_make(iterpool, count, sizeof(svn_fs_x__id_t));
+
+      for (k = first; k < first + count; ++k)
+        {
+          svn_fs_x__p2l_entry_t *entry
+            = APR_ARRAY_IDX(batch->entries, k, svn_fs_x__p2l_entry_t *);
+          APR_ARRAY_PUSH(sub_items, svn_fs_x__id_t) = entry->items[0];
+        }
+      first += count;
+
+      /* Don't let block-sized containers straddle block boundaries. */
+      if (   get_block_left(context) < (apr_ssize_t)serialized->len
+          && serialized->len <= ffd->block_size)
+        SVN_ERR(auto_pad_block(context, iterpool));
+
+      SVN_ERR(write_reps_container(context, NULL, serialized, sub_items,
+                                   new_entries, iterpool));
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+#if APR_HAS_THREADS
+
+/* The batches being built by worker threads.  Only used by the thread
+ * reading and writing the pack file.
+ */
+typedef struct reps_batch_queue_t
+{
+  /* Ring buffer of batches.  Batch N uses slot N % CAPACITY. */
+  reps_batch_t *batches;
+  int capacity;
+
+  /* Builder parameters.  FS must not be accessed by the workers. */
+  svn_fs_t *fs;
+  apr_int64_t block_size;
+  svn_boolean_t adaptive;
+
+  /* Builds the batches. */
+  svn_worker_pool__t *workers;
+} reps_batch_queue_t;
+
+/* Implements svn_worker_pool__func_t.  BATON is a reps_batch_t. */
+static svn_error_t *
+build_reps_batch_job(void *baton,
+                     apr_pool_t *scratch_pool)
+{
+  reps_batch_t *batch = baton;
+  const reps_batch_queue_t *queue = batch->queue;
+
+  return svn_error_trace(build_reps_batch(batch, queue->fs,
+                                          queue->block_size,
+                                          queue->adaptive));
+}
+
+/* Pool cleanup function releasing the batches of the reps_batch_queue_t
+ * in DATA.
+ */
+static apr_status_t
+release_reps_batches(void *data)
+{
+  reps_batch_queue_t *queue = data;
+  int i;
+
+  /* Runs after the workers are gone. */
+  for (i = 0; i < queue->capacity; ++i)
+    svn_pool_destroy(queue->batches[i].pool);
+
+  return APR_SUCCESS;
+}
+
+/* Implement write_reps_batches for up to JOBS worker threads.  Read and
+ * write the data from within this thread, strictly in order, and have the
+ * workers build the containers.  Set *WRITTEN to FALSE, without writing
+ * anything, if no thread could be started.  Use POOL for allocations.
+ */
+static svn_error_t *
+write_reps_batches_in_parallel(svn_boolean_t *written,
+                               pack_context_t *context,
+                               apr_array_header_t *entries,
+                               svn_fs_x__revision_file_t *file,
+                               apr_file_t *temp_file,
+                               apr_array_header_t *new_entries,
+                               int jobs,
+                               apr_pool_t *pool)
+{
+  svn_fs_x__data_t *ffd = context->fs->fsap_data;
+  apr_pool_t *queue_pool = svn_pool_create(pool);
+  reps_batch_queue_t *queue = apr_pcalloc(queue_pool, sizeof(*queue));
+  apr_pool_t *iterpool;
+  int next = entries->nelts - 1;
+  int produced = 0;
+  int consumed = 0;
+  int i;
+
+  apr_pool_cleanup_register(queue_pool, queue, release_reps_batches,
+                            apr_pool_cleanup_null);
+  SVN_ERR(svn_worker_pool__create(&queue->workers, jobs, queue_pool));
+  if (!queue->workers)
+    {
+      svn_pool_destroy(queue_pool);
+      *written = FALSE;
+      return SVN_NO_ERROR;
+    }
+
+  *written = TRUE;
+  queue->fs = context->fs;
+  queue->block_size = ffd->block_size;
+  queue->adaptive = ffd->adaptive_containers;
+
+  /* Keep all workers busy while we read and write. */
+  queue->capacity = 2 * svn_worker_pool__thread_count(queue->workers);
+  queue->batches = apr_pcalloc(queue_pool,
+                               queue->capacity * sizeof(*queue->batches));
+  for (i = 0; i < queue->capacity; ++i)
+    {
+      queue->batches[i].queue = queue;
+      queue->batches[i].pool
+        = apr_allocator_owner_get(svn_pool_create_allocator(FALSE));
+    }
+
+  iterpool = svn_pool_create(pool);
+  while (TRUE)
+    {
+      reps_batch_t *batch;
+      svn_error_t *err = SVN_NO_ERROR;
+
+      svn_pool_clear(iterpool);
+
+      /* Fill all free slots.  The workers don't touch them until we
+       * post them. */
+      if (next >= 0 && produced < consumed + queue->capacity)
+        {
+          batch = &queue->batches[produced % queue->capacity];
+          err = read_reps_batch(batch, context, entries, &next, file,
+                                temp_file, iterpool);
+          if (!err && context->cancel_func)
+            err = context->cancel_func(context->cancel_baton);
+          if (!err)
+            err = svn_worker_pool__post(&batch->job, queue->workers,
+                                        build_reps_batch_job, batch,
+                                        batch->pool);
+          if (!err)
+            produced++;
+        }
+      else if (consumed < produced)
+        {
+          /* Wait for the oldest batch and write it. */
+          batch = &queue->batches[consumed % queue->capacity];
+
+          err = svn_worker_pool__wait(batch->job);
+          if (!err)
+            err = store_reps_batch(context, batch, new_entries, iterpool);
+
+          consumed++;
+        }
+      else
+        {
+          break;
+        }
+
+      if (err)
+        {
+          svn_pool_destroy(queue_pool);
+          return svn_error_trace(err);
+        }
+    }
+
+  svn_pool_destroy(queue_pool);
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+#endif
+
+/* Like write_reps_containers but split ENTRIES into batches whose
+ * containers get built independently from one another, with the number
+ * of worker threads and the container sizing given by CONTEXT's FS
+ * configuration.  Use SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+write_reps_batches(pack_context_t *context,
+                   apr_array_header_t *entries,
+                   apr_file_t *temp_file,
+                   apr_array_header_t *new_entries,
+                   apr_pool_t *scratch_pool)
+{
+  svn_fs_x__data_t *ffd = context->fs->fsap_data;
+  svn_fs_x__revision_file_t *file;
+  reps_batch_t batch = { 0 };
+  int next = entries->nelts - 1;
+
+  SVN_ERR(svn_fs_x__rev_file_wrap_temp(&file, context->fs, temp_file,
+                                       scratch_pool));
+
+#if APR_HAS_THREADS
+  if (ffd->pack_jobs > 1)
+    {
+      svn_boolean_t written;
+
+      SVN_ERR(write_reps_batches_in_parallel(&written, context, entries,
+                                             file, temp_file, new_entries,
+                                             ffd->pack_jobs, scratch_pool));
+      if (written)
+        return SVN_NO_ERROR;
+    }
+#endif
+
+  batch.pool = svn_pool_create(scratch_pool);
+  while (next >= 0)
+    {
+      SVN_ERR(read_reps_batch(&batch, context, entries, &next, file,
+                              temp_file, scratch_pool));
+      SVN_ERR(build_reps_batch(&batch, context->fs, ffd->block_size,
+                               ffd->adaptive_containers));
+      SVN_ERR(store_reps_batch(context, &batch, new_entries, batch.pool));
+
+      if (context->cancel_func)
+        SVN_ERR(context->cancel_func(context->cancel_baton));
+    }
+
+  svn_pool_destroy(batch.pool);
+
+  return SVN_NO_ERROR;
+}
+
 /* Return TRUE if the estimated size of the NODES_IN_CONTAINER plus the
  * representations given as svn_fs_x__p2l_entry_t * in ENTRIES may exceed
  * the space left in the current block.
@@ -1640,8 +2284,16 @@ write_property_containers(pack_context_t *context,
   apr_array_header_t *new_entries
     = apr_array_make(context->info_pool, 16, entries->elt_size);
 
-  SVN_ERR(write_reps_containers(context, entries, temp_file, new_entries,
-                                scratch_pool));
+  svn_fs_x__data_t *ffd = context->fs->fsap_data;
+
+  /* Containers of the exact space left in the current block can only be
+   * determined by building them one after another. */
+  if (ffd->pack_jobs > 1 || ffd->adaptive_containers)
+    SVN_ERR(write_reps_batches(context, entries, temp_file, new_entries,
+                               scratch_pool));
+  else
+    SVN_ERR(write_reps_containers(context, entries, temp_file, new_entries,
+                                  scratch_pool));
 
   *entries = *new_entries;
 
@@ -1720,6 +2372,10 @@ pack_range(pack_context_t *context,
       apr_off_t offset = 0;
       svn_fs_x__revision_file_t *rev_file;
       svn_fs_x__index_info_t l2p_index_info;
+      rev_data_reader_t reader;
+      apr_array_header_t *items
+        = apr_array_make(revpool, 16, sizeof(svn_fs_x__p2l_entry_t *));
+      int i;
 
       /* Get the rev file dimensions (mainly index locations). */
       SVN_ERR(svn_fs_x__rev_file_init(&rev_file, context->fs, revision,
@@ -1730,17 +2386,17 @@ pack_range(pack_context_t *context,
       APR_ARRAY_PUSH(context->rev_offsets, int) = context->reps->nelts;
 
       /* read the phys-to-log index file until we covered the whole rev file.
-       * That index contains enough info to build both target indexes from it. */
+       * That index contains enough info to build both target indexes from it.
+       * Do that before reading any item, so we don't have to jump back and
+       * forth between the index and the data section of the file. */
       while (offset < l2p_index_info.start)
         {
           /* read one cluster */
-          int i;
           apr_array_header_t *entries;
-          svn_pool_clear(iterpool);
 
           SVN_ERR(svn_fs_x__p2l_index_lookup(&entries, context->fs,
                                              rev_file, revision, offset,
-                                             ffd->p2l_page_size, iterpool,
+                                             ffd->p2l_page_size, revpool,
                                              iterpool));
 
           for (i = 0; i < entries->nelts; ++i)
@@ -1753,43 +2409,52 @@ pack_range(pack_context_t *context,
               if (offset > entry->offset)
                 continue;
 
-              /* process entry while inside the rev file */
+              /* keep entry while inside the rev file */
               offset = entry->offset;
               if (offset < l2p_index_info.start)
                 {
-                  SVN_ERR(svn_fs_x__rev_file_seek(rev_file, NULL, offset));
-
-                  if (entry->type == SVN_FS_X__ITEM_TYPE_CHANGES)
-                    SVN_ERR(copy_item_to_temp(context,
-                                              context->changes,
-                                              context->changes_file,
-                                              rev_file, entry, iterpool));
-                  else if (entry->type == SVN_FS_X__ITEM_TYPE_FILE_PROPS)
-                    SVN_ERR(copy_item_to_temp(context,
-                                              context->file_props,
-                                              context->file_props_file,
-                                              rev_file, entry, iterpool));
-                  else if (entry->type == SVN_FS_X__ITEM_TYPE_DIR_PROPS)
-                    SVN_ERR(copy_item_to_temp(context,
-                                              context->dir_props,
-                                              context->dir_props_file,
-                                              rev_file, entry, iterpool));
-                  else if (   entry->type == SVN_FS_X__ITEM_TYPE_FILE_REP
-                           || entry->type == SVN_FS_X__ITEM_TYPE_DIR_REP)
-                    SVN_ERR(copy_rep_to_temp(context, rev_file, entry,
-                                             iterpool));
-                  else if (entry->type == SVN_FS_X__ITEM_TYPE_NODEREV)
-                    SVN_ERR(copy_node_to_temp(context, rev_file, entry,
-                                              iterpool));
-                  else
-                    SVN_ERR_ASSERT(entry->type == SVN_FS_X__ITEM_TYPE_UNUSED);
-
+                  APR_ARRAY_PUSH(items, svn_fs_x__p2l_entry_t *) = entry;
                   offset += entry->size;
                 }
             }
 
-          if (context->cancel_func)
+          svn_pool_clear(iterpool);
+        }
+
+      /* Scan the data section once, front to back. */
+      SVN_ERR(init_rev_data_reader(&reader, rev_file, revpool));
+      for (i = 0; i < items->nelts; ++i)
+        {
+          svn_fs_x__p2l_entry_t *entry
+            = APR_ARRAY_IDX(items, i, svn_fs_x__p2l_entry_t *);
+
+          if (entry->type == SVN_FS_X__ITEM_TYPE_CHANGES)
+            SVN_ERR(copy_item_to_temp(context,
+                                      context->changes,
+                                      context->changes_file,
+                                      &reader, entry, iterpool));
+          else if (entry->type == SVN_FS_X__ITEM_TYPE_FILE_PROPS)
+            SVN_ERR(copy_item_to_temp(context,
+                                      context->file_props,
+                                      context->file_props_file,
+                                      &reader, entry, iterpool));
+          else if (entry->type == SVN_FS_X__ITEM_TYPE_DIR_PROPS)
+            SVN_ERR(copy_item_to_temp(context,
+                                      context->dir_props,
+                                      context->dir_props_file,
+                                      &reader, entry, iterpool));
+          else if (   entry->type == SVN_FS_X__ITEM_TYPE_FILE_REP
+                   || entry->type == SVN_FS_X__ITEM_TYPE_DIR_REP)
+            SVN_ERR(copy_rep_to_temp(context, &reader, entry, iterpool));
+          else if (entry->type == SVN_FS_X__ITEM_TYPE_NODEREV)
+            SVN_ERR(copy_node_to_temp(context, &reader, entry, iterpool));
+          else
+            SVN_ERR_ASSERT(entry->type == SVN_FS_X__ITEM_TYPE_UNUSED);
+
+          if (context->cancel_func && i % 100 == 0)
             SVN_ERR(context->cancel_func(context->cancel_baton));
+
+          svn_pool_clear(iterpool);
         }
 
       svn_pool_clear(revpool);
@@ -1919,7 +2584,7 @@ pack_log_addressed(svn_fs_t *fs,
                    const char *shard_dir,
                    svn_revnum_t shard_rev,
                    apr_size_t max_mem,
-                   svn_fs_x__batch_fsync_t *batch,
+                   svn_io__batch_fsync_t *batch,
                    svn_cancel_func_t cancel_func,
                    void *cancel_baton,
                    apr_pool_t *scratch_pool)
@@ -2019,7 +2684,7 @@ pack_rev_shard(svn_fs_t *fs,
                apr_int64_t shard,
                int max_files_per_dir,
                apr_size_t max_mem,
-               svn_fs_x__batch_fsync_t *batch,
+               svn_io__batch_fsync_t *batch,
                svn_cancel_func_t cancel_func,
                void *cancel_baton,
                apr_pool_t *scratch_pool)
@@ -2036,7 +2701,7 @@ pack_rev_shard(svn_fs_t *fs,
 
   /* Create the new directory and pack file. */
   SVN_ERR(svn_io_dir_make(pack_file_dir, APR_OS_DEFAULT, scratch_pool));
-  SVN_ERR(svn_fs_x__batch_fsync_new_path(batch, pack_file_dir, scratch_pool));
+  SVN_ERR(svn_io__batch_fsync_new_path(batch, pack_file_dir, scratch_pool));
 
   /* Index information files */
   SVN_ERR(pack_log_addressed(fs, pack_file_dir, shard_path, shard_rev,
@@ -2076,7 +2741,7 @@ pack_shard(const char *dir,
 {
   svn_fs_x__data_t *ffd = fs->fsap_data;
   const char *shard_path, *pack_file_dir;
-  svn_fs_x__batch_fsync_t *batch;
+  svn_io__batch_fsync_t *batch;
 
   /* Notify caller we're starting to pack this shard. */
   if (notify_func)
@@ -2084,8 +2749,8 @@ pack_shard(const char *dir,
                         scratch_pool));
 
   /* Perform all fsyncs through this instance. */
-  SVN_ERR(svn_fs_x__batch_fsync_create(&batch, ffd->flush_to_disk,
-                                       scratch_pool));
+  SVN_ERR(svn_io__batch_fsync_create(&batch, ffd->flush_to_disk,
+                                     scratch_pool));
 
   /* Some useful paths. */
   pack_file_dir = svn_dirent_join(dir,
@@ -2119,7 +2784,7 @@ pack_shard(const char *dir,
   ffd->min_unpacked_rev = (svn_revnum_t)((shard + 1) * max_files_per_dir);
 
   /* Ensure that packed file is written to disk.*/
-  SVN_ERR(svn_fs_x__batch_fsync_run(batch, scratch_pool));
+  SVN_ERR(svn_io__batch_fsync_run(batch, scratch_pool));
 
   /* Finally, remove the existing shard directories. */
   SVN_ERR(svn_io_remove_dir2(shard_path, TRUE,
@@ -0,0 +1,1404 @@
+/* stats.c -- implements the svn_fs_x__get_stats private API.
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include "svn_dirent_uri.h"
+#include "svn_fs.h"
+#include "svn_pools.h"
+#include "svn_sorts.h"
+
+#include "private/svn_sorts_private.h"
+#include "private/svn_string_private.h"
+#include "private/svn_fs_x_private.h"
+#include "private/svn_worker_pool.h"
+
+#include "index.h"
+#include "rev_file.h"
+#include "util.h"
+#include "fs_x.h"
+#include "cached_data.h"
+#include "low_level.h"
+
+#include "../libsvn_fs/fs-loader.h"
+
+#include "svn_private_config.h"
+
+/* We group representations into 2x2 different kinds plus one default:
+ * [dir / file] x [text / prop]. The assignment is done by the first node
+ * that references the respective representation.
+ */
+typedef enum rep_kind_t
+{
+  /* The representation is not used _directly_, i.e. not referenced by any
+   * noderev. However, some other representation may use it as delta base.
+   * Null value. Should not occur in real-word repositories. */
+  unused_rep,
+
+  /* a properties on directory rep  */
+  dir_property_rep,
+
+  /* a properties on file rep  */
+  file_property_rep,
+
+  /* a directory rep  */
+  dir_rep,
+
+  /* a file rep  */
+  file_rep
+} rep_kind_t;
+
+/* A representation fragment.
+ */
+typedef struct rep_stats_t
+{
+  /* item index within REVISION */
+  apr_uint64_t item_index;
+
+  /* item length in bytes */
+  apr_uint64_t size;
+
+  /* item length after de-deltification */
+  apr_uint64_t expanded_size;
+
+  /* revision that contains this representation
+   * (may be referenced by other revisions, though) */
+  svn_revnum_t revision;
+
+  /* number of nodes that reference this representation */
+  apr_uint32_t ref_count;
+
+  /* length of the DELTA line in the source file in bytes,
+   * 0 for representations in containers */
+  apr_uint16_t header_size;
+
+  /* classification of the representation. values of rep_kind_t */
+  char kind;
+
+  /* length of the delta chain, including this representation,
+   * saturated to 255 - if need be */
+  apr_byte_t chain_length;
+} rep_stats_t;
+
+/* Represents a link in the rep delta chain.  REVISION + ITEM_INDEX points
+ * to BASE_REVISION + BASE_ITEM_INDEX.  We collect this info while scanning
+ * a rev / pack file and resolve it afterwards. */
+typedef struct rep_ref_t
+{
+  /* Revision that contains this representation. */
+  svn_revnum_t revision;
+
+  /* Item index of this rep within REVISION. */
+  apr_uint64_t item_index;
+
+  /* Revision of the representation we deltified against.
+   * -1 if this representation is either PLAIN or a self-delta. */
+  svn_revnum_t base_revision;
+
+  /* Item index of that rep within BASE_REVISION. */
+  apr_uint64_t base_item_index;
+
+  /* On-disk size of the representation item.  Only used for reps that no
+   * noderev refers to. */
+  apr_uint64_t size;
+
+  /* Length of the DELTA line in the source file in bytes.
+   * We use this to update the info in the rep stats after scanning the
+   * whole file. */
+  apr_uint16_t header_size;
+
+} rep_ref_t;
+
+/* A reference from a noderev to one of its representations.  We collect
+ * this info while scanning a rev / pack file and apply it afterwards. */
+typedef struct node_ref_t
+{
+  /* Revision that contains the representation. */
+  svn_revnum_t revision;
+
+  /* Item index of the rep within REVISION. */
+  apr_uint64_t item_index;
+
+  /* Size of the (deltified) representation. */
+  apr_uint64_t size;
+
+  /* Size of the representation after de-deltification. */
+  apr_uint64_t expanded_size;
+
+  /* Path of the node with this representation. */
+  const char *path;
+
+  /* Classification of the representation if we are the first to use it.
+   * Values of rep_kind_t. */
+  char kind;
+
+  /* Whether the node has no deltification predecessor. */
+  svn_boolean_t plain_added;
+} node_ref_t;
+
+/* Represents a single revision.
+ * There will be only one instance per revision. */
+typedef struct revision_info_t
+{
+  /* number of this revision */
+  svn_revnum_t revision;
+
+  /* length of the changes list on bytes */
+  apr_uint64_t changes_len;
+
+  /* number of entries in the changes list */
+  apr_uint64_t change_count;
+
+  /* size of the rev / pack file data in the first revision of that file,
+   * 0 for all others */
+  apr_off_t end;
+
+  /* number of directory noderevs in this revision */
+  apr_uint64_t dir_noderev_count;
+
+  /* number of file noderevs in this revision */
+  apr_uint64_t file_noderev_count;
+
+  /* total size of directory noderevs (i.e. the structs - not the rep) */
+  apr_uint64_t dir_noderev_size;
+
+  /* total size of file noderevs (i.e. the structs - not the rep) */
+  apr_uint64_t file_noderev_size;
+
+  /* all rep_stats_t of this revision (in no particular order),
+   * i.e. those that point back to this struct */
+  apr_array_header_t *representations;
+} revision_info_t;
+
+/* Everything we found while scanning a single rev / pack file.  Apart from
+ * the file, this is independent from the rest of the repository and may be
+ * gathered in parallel with other files.
+ */
+typedef struct file_stats_t
+{
+  /* First revision in that file. */
+  svn_revnum_t base;
+
+  /* Number of revisions in that file. */
+  int count;
+
+  /* COUNT revisions starting at BASE.  Their REPRESENTATIONS are not
+   * filled in, yet. */
+  revision_info_t *revisions;
+
+  /* Noderev -> representation links as node_ref_t, in file order. */
+  apr_array_header_t *node_refs;
+
+  /* All delta chain links as rep_ref_t. */
+  apr_array_header_t *rep_refs;
+
+  /* Container statistics for this file. */
+  svn_fs_x__container_stats_t noderevs_containers;
+  svn_fs_x__container_stats_t changes_containers;
+  svn_fs_x__container_stats_t reps_containers;
+} file_stats_t;
+
+/* Root data structure containing all information about a given repository.
+ * We use it as a wrapper around svn_fs_t and pass it around where we would
+ * otherwise just use a svn_fs_t.
+ */
+typedef struct query_t
+{
+  /* FS API object*/
+  svn_fs_t *fs;
+
+  /* The HEAD revision. */
+  svn_revnum_t head;
+
+  /* Number of revs per shard. */
+  int shard_size;
+
+  /* First non-packed revision. */
+  svn_revnum_t min_unpacked_rev;
+
+  /* all revisions */
+  apr_array_header_t *revisions;
+
+  /* Pool to allocate the revision infos and rep stats in. */
+  apr_pool_t *pool;
+
+  /* collected statistics */
+  svn_fs_x__stats_t *stats;
+
+  /* Number of rev / pack files to read concurrently. */
+  int jobs;
+
+  /* Callback to open per-thread FS instances and its baton. */
+  svn_fs_x__open_fs_func_t open_fs_func;
+  void *open_fs_baton;
+
+  /* Progress notification callback to call after each shard.  May be NULL. */
+  svn_fs_progress_notify_func_t progress_func;
+
+  /* Baton for PROGRESS_FUNC. */
+  void *progress_baton;
+
+  /* Cancellation support callback to call once in a while.  May be NULL. */
+  svn_cancel_func_t cancel_func;
+
+  /* Baton for CANCEL_FUNC. */
+  void *cancel_baton;
+} query_t;
+
+/* Initialize the LARGEST_CHANGES member in STATS with a capacity of COUNT
+ * entries.  Allocate the result in RESULT_POOL.
+ */
+static void
+initialize_largest_changes(svn_fs_x__stats_t *stats,
+                           apr_size_t count,
+                           apr_pool_t *result_pool)
+{
+  apr_size_t i;
+
+  stats->largest_changes = apr_pcalloc(result_pool,
+                                       sizeof(*stats->largest_changes));
+  stats->largest_changes->count = count;
+  stats->largest_changes->min_size = 1;
+  stats->largest_changes->changes
+    = apr_palloc(result_pool, count * sizeof(*stats->largest_changes->changes));
+
+  /* allocate *all* entries before the path stringbufs.  This increases
+   * cache locality and enhances performance significantly. */
+  for (i = 0; i < count; ++i)
+    stats->largest_changes->changes[i]
+      = apr_palloc(result_pool, sizeof(**stats->largest_changes->changes));
+
+  /* now initialize them and allocate the stringbufs */
+  for (i = 0; i < count; ++i)
+    {
+      stats->largest_changes->changes[i]->size = 0;
+      stats->largest_changes->changes[i]->revision = SVN_INVALID_REVNUM;
+      stats->largest_changes->changes[i]->path
+        = svn_stringbuf_create_ensure(1024, result_pool);
+    }
+}
+
+/* Add entry for SIZE to HISTOGRAM.
+ */
+static void
+add_to_histogram(svn_fs_x__histogram_t *histogram,
+                 apr_int64_t size)
+{
+  apr_int64_t shift = 0;
+
+  while (((apr_int64_t)(1) << shift) <= size)
+    shift++;
+
+  histogram->total.count++;
+  histogram->total.sum += size;
+  histogram->lines[(apr_size_t)shift].count++;
+  histogram->lines[(apr_size_t)shift].sum += size;
+}
+
+/* Update data aggregators in STATS with this representation of type KIND,
+ * on-disk REP_SIZE and expanded node size EXPANDED_SIZE for PATH in REVSION.
+ * PLAIN_ADDED indicates whether the node has a deltification predecessor.
+ */
+static void
+add_change(svn_fs_x__stats_t *stats,
+           apr_uint64_t rep_size,
+           apr_uint64_t expanded_size,
+           svn_revnum_t revision,
+           const char *path,
+           rep_kind_t kind,
+           svn_boolean_t plain_added)
+{
+  /* identify largest reps */
+  if (rep_size >= stats->largest_changes->min_size)
+    {
+      apr_size_t i;
+      svn_fs_x__largest_changes_t *largest_changes = stats->largest_changes;
+      svn_fs_x__large_change_info_t *info
+        = largest_changes->changes[largest_changes->count - 1];
+      info->size = rep_size;
+      info->revision = revision;
+      svn_stringbuf_set(info->path, path);
+
+      /* linear insertion but not too bad since count is low and insertions
+       * near the end are more likely than close to front */
+      for (i = largest_changes->count - 1; i > 0; --i)
+        if (largest_changes->changes[i-1]->size >= rep_size)
+          break;
+        else
+          largest_changes->changes[i] = largest_changes->changes[i-1];
+
+      largest_changes->changes[i] = info;
+      largest_changes->min_size
+        = largest_changes->changes[largest_changes->count-1]->size;
+    }
+
+  /* global histograms */
+  add_to_histogram(&stats->rep_size_histogram, rep_size);
+  add_to_histogram(&stats->node_size_histogram, expanded_size);
+
+  if (plain_added)
+    {
+      add_to_histogram(&stats->added_rep_size_histogram, rep_size);
+      add_to_histogram(&stats->added_node_size_histogram, expanded_size);
+    }
+
+  /* specific histograms by type */
+  switch (kind)
+    {
+      case unused_rep:
+        add_to_histogram(&stats->unused_rep_histogram, rep_size);
+        break;
+      case dir_property_rep:
+        add_to_histogram(&stats->dir_prop_rep_histogram, rep_size);
+        add_to_histogram(&stats->dir_prop_histogram, expanded_size);
+        break;
+      case file_property_rep:
+        add_to_histogram(&stats->file_prop_rep_histogram, rep_size);
+        add_to_histogram(&stats->file_prop_histogram, expanded_size);
+        break;
+      case dir_rep:
+        add_to_histogram(&stats->dir_rep_histogram, rep_size);
+        add_to_histogram(&stats->dir_histogram, expanded_size);
+        break;
+      case file_rep:
+        add_to_histogram(&stats->file_rep_histogram, rep_size);
+        add_to_histogram(&stats->file_histogram, expanded_size);
+        break;
+    }
+
+  /* by extension */
+  if (kind == file_rep)
+    {
+      /* determine extension */
+      svn_fs_x__extension_info_t *info;
+      const char * file_name = strrchr(path, '/');
+      const char * extension = file_name ? strrchr(file_name, '.') : NULL;
+
+      if (extension == NULL || extension == file_name + 1)
+        extension = "(none)";
+
+      /* get / auto-insert entry for this extension */
+      info = apr_hash_get(stats->by_extension, extension, APR_HASH_KEY_STRING);
+      if (info == NULL)
+        {
+          apr_pool_t *pool = apr_hash_pool_get(stats->by_extension);
+          info = apr_pcalloc(pool, sizeof(*info));
+          info->extension = apr_pstrdup(pool, extension);
+
+          apr_hash_set(stats->by_extension, info->extension,
+                       APR_HASH_KEY_STRING, info);
+        }
+
+      /* update per-extension histogram */
+      add_to_histogram(&info->node_histogram, expanded_size);
+      add_to_histogram(&info->rep_histogram, rep_size);
+    }
+}
+
+/* Comparator used for binary search comparing the item index of
+ * a representation to some other item index. DATA is a *rep_stats_t,
+ * KEY is a pointer to an apr_uint64_t.
+ */
+static int
+compare_representation_item_index(const void *data, const void *key)
+{
+  apr_uint64_t lhs = (*(const rep_stats_t *const *)data)->item_index;
+  apr_uint64_t rhs = *(const apr_uint64_t *)key;
+
+  if (lhs < rhs)
+    return -1;
+  return (lhs > rhs ? 1 : 0);
+}
+
+/* Find the representation stats for item ITEM_INDEX of REVISION in QUERY.
+ * If no such object exists, yet, auto-construct it with on-disk SIZE and
+ * EXPANDED_SIZE.  Return it in *REPRESENTATION.
+ */
+static svn_error_t *
+get_representation(rep_stats_t **representation,
+                   query_t *query,
+                   svn_revnum_t revision,
+                   apr_uint64_t item_index,
+                   apr_uint64_t size,
+                   apr_uint64_t expanded_size)
+{
+  revision_info_t *info;
+  rep_stats_t *result;
+  int idx;
+
+  /* Only revisions merged so far can be referenced. */
+  if (revision < 0 || revision >= query->revisions->nelts)
+    return svn_error_createf(SVN_ERR_FS_CORRUPT, NULL,
+                             _("Reference to representation in unknown "
+                               "revision r%ld"), revision);
+
+  info = APR_ARRAY_IDX(query->revisions, revision, revision_info_t *);
+  idx = svn_sort__bsearch_lower_bound(info->representations,
+                                      &item_index,
+                                      compare_representation_item_index);
+  if (idx < info->representations->nelts)
+    {
+      result = APR_ARRAY_IDX(info->representations, idx, rep_stats_t *);
+      if (result->item_index == item_index)
+        {
+          *representation = result;
+          return SVN_NO_ERROR;
+        }
+    }
+
+  result = apr_pcalloc(query->pool, sizeof(*result));
+  result->revision = revision;
+  result->item_index = item_index;
+  result->size = size;
+  result->expanded_size = expanded_size;
+
+  svn_sort__array_insert(info->representations, &result, idx);
+  *representation = result;
+
+  return SVN_NO_ERROR;
+}
+
+/* Return the revision_info_t for REVISION within FILE_STATS. */
+static revision_info_t *
+get_revision_info(file_stats_t *file_stats,
+                  svn_revnum_t revision)
+{
+  return &file_stats->revisions[revision - file_stats->base];
+}
+
+/* Add the usage of representation REP by NODEREV to FILE_STATS.
+ * Allocate the data in RESULT_POOL.
+ */
+static void
+add_node_ref(file_stats_t *file_stats,
+             svn_fs_x__noderev_t *noderev,
+             svn_fs_x__representation_t *rep,
+             rep_kind_t kind,
+             apr_pool_t *result_pool)
+{
+  node_ref_t *ref = apr_array_push(file_stats->node_refs);
+
+  ref->revision = svn_fs_x__get_revnum(rep->id.change_set);
+  ref->item_index = rep->id.number;
+  ref->size = rep->size;
+  ref->expanded_size = rep->expanded_size;
+  ref->path = apr_pstrdup(result_pool, noderev->created_path);
+  ref->kind = (char)kind;
+  ref->plain_added = !svn_fs_x__id_used(&noderev->predecessor_id);
+}
+
+/* Read the noderev ID from FS and record it with its on-disk SIZE in
+ * FILE_STATS.  Allocate the data in RESULT_POOL and use SCRATCH_POOL for
+ * temporaries.
+ */
+static svn_error_t *
+read_noderev(file_stats_t *file_stats,
+             svn_fs_t *fs,
+             const svn_fs_x__id_t *id,
+             apr_uint64_t size,
+             apr_pool_t *result_pool,
+             apr_pool_t *scratch_pool)
+{
+  svn_fs_x__noderev_t *noderev;
+  revision_info_t *info
+    = get_revision_info(file_stats, svn_fs_x__get_revnum(id->change_set));
+
+  SVN_ERR(svn_fs_x__get_node_revision(&noderev, fs, id, scratch_pool,
+                                      scratch_pool));
+
+  if (noderev->data_rep)
+    add_node_ref(file_stats, noderev, noderev->data_rep,
+                 noderev->kind == svn_node_dir ? dir_rep : file_rep,
+                 result_pool);
+
+  if (noderev->prop_rep)
+    add_node_ref(file_stats, noderev, noderev->prop_rep,
+                 noderev->kind == svn_node_dir ? dir_property_rep
+                                               : file_property_rep,
+                 result_pool);
+
+  /* update stats */
+  if (noderev->kind == svn_node_dir)
+    {
+      info->dir_noderev_size += size;
+      info->dir_noderev_count++;
+    }
+  else
+    {
+      info->file_noderev_size += size;
+      info->file_noderev_count++;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Add the changed paths list of REVISION in FS with on-disk SIZE to
+ * FILE_STATS.  Use SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+read_changes(file_stats_t *file_stats,
+             svn_fs_t *fs,
+             svn_revnum_t revision,
+             apr_uint64_t size,
+             apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  revision_info_t *info = get_revision_info(file_stats, revision);
+  svn_fs_x__changes_context_t *context;
+
+  SVN_ERR(svn_fs_x__create_changes_context(&context, fs, revision,
+                                           scratch_pool, scratch_pool));
+
+  while (!context->eol)
+    {
+      apr_array_header_t *changes;
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_fs_x__get_changes(&changes, context, iterpool, iterpool));
+      info->change_count += changes->nelts;
+    }
+
+  info->changes_len += size;
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Record the delta chain link for the representation in REV_FILE
+ * described by the non-container ENTRY in FILE_STATS.  Allocate the data
+ * in RESULT_POOL and use SCRATCH_POOL for temporaries.
+ */
+static svn_error_t *
+read_rep_header(file_stats_t *file_stats,
+                svn_fs_x__revision_file_t *rev_file,
+                svn_fs_x__p2l_entry_t *entry,
+                apr_pool_t *result_pool,
+                apr_pool_t *scratch_pool)
+{
+  svn_fs_x__rep_header_t *header;
+  svn_stream_t *stream;
+  rep_ref_t *ref = apr_pcalloc(result_pool, sizeof(*ref));
+
+  SVN_ERR(svn_fs_x__rev_file_seek(rev_file, NULL, entry->offset));
+  SVN_ERR(svn_fs_x__rev_file_stream(&stream, rev_file));
+  SVN_ERR(svn_fs_x__read_rep_header(&header, stream, scratch_pool,
+                                    scratch_pool));
+
+  ref->header_size = (apr_uint16_t)MIN(header->header_size, 0xffff);
+  ref->revision = svn_fs_x__get_revnum(entry->items[0].change_set);
+  ref->item_index = entry->items[0].number;
+  ref->size = entry->size;
+
+  if (header->type == svn_fs_x__rep_delta)
+    {
+      ref->base_item_index = header->base_item_index;
+      ref->base_revision = header->base_revision;
+    }
+  else
+    {
+      ref->base_item_index = SVN_FS_X__ITEM_INDEX_UNUSED;
+      ref->base_revision = SVN_INVALID_REVNUM;
+    }
+
+  APR_ARRAY_PUSH(file_stats->rep_refs, rep_ref_t *) = ref;
+
+  return SVN_NO_ERROR;
+}
+
+/* Add the container ENTRY to STATS and return the share of its on-disk
+ * size that is attributed to each of its items.
+ */
+static apr_uint64_t
+add_container(svn_fs_x__container_stats_t *stats,
+              svn_fs_x__p2l_entry_t *entry)
+{
+  stats->count++;
+  stats->size += entry->size;
+  stats->items += entry->item_count;
+
+  return entry->item_count ? entry->size / entry->item_count : 0;
+}
+
+/* Read the COUNT revisions starting at BASE in FS and return what was
+ * found in *FILE_STATS.  This does not depend on any revision outside that
+ * range.  If not NULL, call CANCEL_FUNC with CANCEL_BATON from time to
+ * time.  Allocate the result RESULT_POOL and use SCRATCH_POOL for
+ * temporaries.
+ */
+static svn_error_t *
+read_rev_or_pack_file(file_stats_t **file_stats,
+                      svn_fs_t *fs,
+                      svn_revnum_t base,
+                      int count,
+                      svn_cancel_func_t cancel_func,
+                      void *cancel_baton,
+                      apr_pool_t *result_pool,
+                      apr_pool_t *scratch_pool)
+{
+  svn_fs_x__data_t *ffd = fs->fsap_data;
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  apr_off_t max_offset;
+  apr_off_t offset = 0;
+  int i;
+  svn_fs_x__revision_file_t *rev_file;
+  file_stats_t *result = apr_pcalloc(result_pool, sizeof(*result));
+
+  /* create the revision infos for all revs in this file */
+  result->base = base;
+  result->count = count;
+  result->revisions = apr_pcalloc(result_pool,
+                                  count * sizeof(*result->revisions));
+  for (i = 0; i < count; ++i)
+    result->revisions[i].revision = base + i;
+
+  result->node_refs = apr_array_make(result_pool, 64, sizeof(node_ref_t));
+  result->rep_refs = apr_array_make(result_pool, 64, sizeof(rep_ref_t *));
+
+  /* open the pack / rev file that is covered by the p2l index */
+  SVN_ERR(svn_fs_x__rev_file_init(&rev_file, fs, base, scratch_pool));
+  SVN_ERR(svn_fs_x__p2l_get_max_offset(&max_offset, fs, rev_file,
+                                       base, scratch_pool));
+
+  /* record the whole pack size in the first rev so the total sum will
+     still be correct */
+  result->revisions[0].end = max_offset;
+
+  /* for all offsets in the file, get the P2L index entries and process
+     the interesting items (change lists, noderevs) */
+  for (offset = 0; offset < max_offset; )
+    {
+      apr_array_header_t *entries;
+
+      svn_pool_clear(iterpool);
+
+      /* cancellation support */
+      if (cancel_func)
+        SVN_ERR(cancel_func(cancel_baton));
+
+      /* get all entries for the current block */
+      SVN_ERR(svn_fs_x__p2l_index_lookup(&entries, fs, rev_file, base,
+                                         offset, ffd->p2l_page_size,
+                                         iterpool, iterpool));
+
+      /* process all entries (and later continue with the next block) */
+      for (i = 0; i < entries->nelts; ++i)
+        {
+          svn_fs_x__p2l_entry_t *entry
+            = &APR_ARRAY_IDX(entries, i, svn_fs_x__p2l_entry_t);
+          apr_uint64_t item_size;
+          apr_uint32_t k;
+
+          /* skip bits we previously processed */
+          if (i == 0 && entry->offset < offset)
+            continue;
+
+          /* advance offset */
+          offset += entry->size;
+
+          /* skip zero-sized and unused entries */
+          if (entry->size == 0 || entry->item_count == 0)
+            continue;
+
+          /* read and process interesting items */
+          switch (entry->type)
+            {
+              case SVN_FS_X__ITEM_TYPE_NODEREV:
+                SVN_ERR(read_noderev(result, fs, &entry->items[0],
+                                     entry->size, result_pool, iterpool));
+                break;
+
+              case SVN_FS_X__ITEM_TYPE_NODEREVS_CONT:
+                item_size = add_container(&result->noderevs_containers,
+                                          entry);
+                for (k = 0; k < entry->item_count; ++k)
+                  SVN_ERR(read_noderev(result, fs, &entry->items[k],
+                                       item_size, result_pool, iterpool));
+                break;
+
+              case SVN_FS_X__ITEM_TYPE_CHANGES:
+                SVN_ERR(read_changes(result, fs,
+                            svn_fs_x__get_revnum(entry->items[0].change_set),
+                            entry->size, iterpool));
+                break;
+
+              case SVN_FS_X__ITEM_TYPE_CHANGES_CONT:
+                item_size = add_container(&result->changes_containers,
+                                          entry);
+                for (k = 0; k < entry->item_count; ++k)
+                  SVN_ERR(read_changes(result, fs,
+                            svn_fs_x__get_revnum(entry->items[k].change_set),
+                            item_size, iterpool));
+                break;
+
+              case SVN_FS_X__ITEM_TYPE_FILE_REP:
+              case SVN_FS_X__ITEM_TYPE_DIR_REP:
+              case SVN_FS_X__ITEM_TYPE_FILE_PROPS:
+              case SVN_FS_X__ITEM_TYPE_DIR_PROPS:
+              case SVN_FS_X__ITEM_TYPE_ANY_REP:
+                SVN_ERR(read_rep_header(result, rev_file, entry,
+                                        result_pool, iterpool));
+                break;
+
+              case SVN_FS_X__ITEM_TYPE_REPS_CONT:
+                /* Container reps are star-deltas within the container.
+                 * They don't have headers nor outside delta bases. */
+                item_size = add_container(&result->reps_containers, entry);
+                for (k = 0; k < entry->item_count; ++k)
+                  {
+                    rep_ref_t *ref = apr_pcalloc(result_pool, sizeof(*ref));
+                    ref->revision
+                      = svn_fs_x__get_revnum(entry->items[k].change_set);
+                    ref->item_index = entry->items[k].number;
+                    ref->base_revision = SVN_INVALID_REVNUM;
+                    ref->base_item_index = SVN_FS_X__ITEM_INDEX_UNUSED;
+                    ref->size = item_size;
+
+                    APR_ARRAY_PUSH(result->rep_refs, rep_ref_t *) = ref;
+                  }
+                break;
+
+              default:
+                break;
+            }
+        }
+    }
+
+  /* clean up and close file handles */
+  SVN_ERR(svn_fs_x__close_revision_file(rev_file));
+  svn_pool_destroy(iterpool);
+
+  *file_stats = result;
+
+  return SVN_NO_ERROR;
+}
+
+/* Predicate comparing the two rep_ref_t** LHS and RHS by the respective
+ * representation's revision and item index.
+ */
+static int
+compare_representation_refs(const void *lhs, const void *rhs)
+{
+  const rep_ref_t *lhs_ref = *(const rep_ref_t *const *)lhs;
+  const rep_ref_t *rhs_ref = *(const rep_ref_t *const *)rhs;
+
+  if (lhs_ref->revision != rhs_ref->revision)
+    return lhs_ref->revision < rhs_ref->revision ? -1 : 1;
+
+  if (lhs_ref->item_index != rhs_ref->item_index)
+    return lhs_ref->item_index < rhs_ref->item_index ? -1 : 1;
+
+  return 0;
+}
+
+/* Add the data gathered in FILE_STATS to QUERY.  Files must be added in
+ * revision order.
+ */
+static svn_error_t *
+merge_file_stats(query_t *query,
+                 file_stats_t *file_stats)
+{
+  int i;
+
+  /* The revisions and their reps need to survive FILE_STATS. */
+  for (i = 0; i < file_stats->count; ++i)
+    {
+      revision_info_t *info = apr_pmemdup(query->pool,
+                                          &file_stats->revisions[i],
+                                          sizeof(*info));
+      info->representations = apr_array_make(query->pool, 4,
+                                             sizeof(rep_stats_t *));
+
+      APR_ARRAY_PUSH(query->revisions, revision_info_t *) = info;
+    }
+
+  /* Apply the reps usage in file order, i.e. in the order FSFS stats
+   * would have encountered them, too. */
+  for (i = 0; i < file_stats->node_refs->nelts; ++i)
+    {
+      node_ref_t *ref = &APR_ARRAY_IDX(file_stats->node_refs, i, node_ref_t);
+      rep_stats_t *rep;
+
+      SVN_ERR(get_representation(&rep, query, ref->revision,
+                                 ref->item_index, ref->size,
+                                 ref->expanded_size));
+
+      /* if we are the first to use this rep, classify it and record it
+       * with the largest changes */
+      if (++rep->ref_count == 1)
+        {
+          rep->kind = ref->kind;
+          add_change(query->stats, rep->size, rep->expanded_size,
+                     rep->revision, ref->path, rep->kind, ref->plain_added);
+        }
+    }
+
+  /* Because delta chains can only point to previous reps, after sorting
+   * the refs, all base refs have already been updated. */
+  svn_sort__array(file_stats->rep_refs, compare_representation_refs);
+
+  /* Build up the CHAIN_LENGTH values. */
+  for (i = 0; i < file_stats->rep_refs->nelts; ++i)
+    {
+      rep_ref_t *ref = APR_ARRAY_IDX(file_stats->rep_refs, i, rep_ref_t *);
+      rep_stats_t *rep;
+
+      SVN_ERR(get_representation(&rep, query, ref->revision,
+                                 ref->item_index, ref->size, 0));
+
+      /* Set the HEADER_SIZE as we found it during the scan. */
+      rep->header_size = ref->header_size;
+
+      /* The delta chain got 1 element longer. */
+      if (ref->base_revision == SVN_INVALID_REVNUM)
+        {
+          rep->chain_length = 1;
+        }
+      else
+        {
+          rep_stats_t *base;
+
+          SVN_ERR(get_representation(&base, query, ref->base_revision,
+                                     ref->base_item_index, 0, 0));
+          rep->chain_length = 1 + MIN(base->chain_length, (apr_byte_t)0xfe);
+        }
+    }
+
+  /* Containers don't need any cross-file processing. */
+  query->stats->noderevs_containers.count
+    += file_stats->noderevs_containers.count;
+  query->stats->noderevs_containers.size
+    += file_stats->noderevs_containers.size;
+  query->stats->noderevs_containers.items
+    += file_stats->noderevs_containers.items;
+  query->stats->changes_containers.count
+    += file_stats->changes_containers.count;
+  query->stats->changes_containers.size
+    += file_stats->changes_containers.size;
+  query->stats->changes_containers.items
+    += file_stats->changes_containers.items;
+  query->stats->reps_containers.count += file_stats->reps_containers.count;
+  query->stats->reps_containers.size += file_stats->reps_containers.size;
+  query->stats->reps_containers.items += file_stats->reps_containers.items;
+
+  return SVN_NO_ERROR;
+}
+
+/* Return the number of revisions in the rev / pack file starting at BASE
+ * in QUERY.
+ */
+static int
+get_file_rev_count(query_t *query,
+                   svn_revnum_t base)
+{
+  return base < query->min_unpacked_rev ? query->shard_size : 1;
+}
+
+/* Report progress in QUERY after the rev / pack file starting at BASE
+ * has been processed.  Use SCRATCH_POOL for temporary allocations.
+ */
+static void
+notify_progress(query_t *query,
+                svn_revnum_t base,
+                apr_pool_t *scratch_pool)
+{
+  /* one notification per pack file or once per shard */
+  if (query->progress_func && base % query->shard_size == 0)
+    query->progress_func(base, query->progress_baton, scratch_pool);
+}
+
+#if APR_HAS_THREADS
+
+/* A single rev / pack file to be read by some worker thread.
+ */
+typedef struct stats_job_t
+{
+  /* First revision in the file. */
+  svn_revnum_t base;
+
+  /* Number of revisions that the file contains. */
+  int count;
+
+  /* Root pool owning RESULT.  NULL until claimed by a worker. */
+  apr_pool_t *pool;
+
+  /* Scan result.  Only valid if DONE is set and ERR is NULL. */
+  file_stats_t *result;
+
+  /* Error returned by the scan. */
+  svn_error_t *err;
+
+  /* Set once the worker is done with this job. */
+  svn_boolean_t done;
+} stats_job_t;
+
+/* The list of all files to read, shared between the main thread and the
+ * workers.  CLAIMED, MERGED and STOP as well as the jobs' results are
+ * protected by the mutex of WORKERS.
+ */
+typedef struct stats_queue_t
+{
+  /* All files in revision order. */
+  stats_job_t *jobs;
+  int job_count;
+
+  /* Number of jobs that have been claimed by some worker. */
+  int claimed;
+
+  /* Number of jobs that have been merged into the result. */
+  int merged;
+
+  /* Maximum number of scan results that may be waiting to get merged. */
+  int window;
+
+  /* If set, the workers shall exit ASAP. */
+  svn_boolean_t stop;
+
+  /* Opens the per-thread FS instances. */
+  svn_fs_x__open_fs_func_t open_fs_func;
+  void *open_fs_baton;
+
+  /* Runs one scan_files_job() per thread.  Notified whenever any of the
+   * above has been changed. */
+  svn_worker_pool__t *workers;
+
+  /* Owns WORKERS. */
+  apr_pool_t *workers_pool;
+} stats_queue_t;
+
+/* Implements svn_worker_pool__func_t.  BATON is the stats_queue_t.
+ * Scan the files claimed from it until there are none left.
+ */
+static svn_error_t *
+scan_files_job(void *baton,
+               apr_pool_t *scratch_pool)
+{
+  stats_queue_t *queue = baton;
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  svn_fs_t *fs = NULL;
+  svn_error_t *open_err = SVN_NO_ERROR;
+
+  while (TRUE)
+    {
+      stats_job_t *job;
+      apr_pool_t *job_pool;
+      svn_error_t *err = SVN_NO_ERROR;
+
+      svn_error_clear(svn_worker_pool__lock(queue->workers));
+      while (   !err
+             && !queue->stop
+             && queue->claimed < queue->job_count
+             && queue->claimed >= queue->merged + queue->window)
+        err = svn_worker_pool__wait_for_change(queue->workers);
+
+      if (err || queue->stop || queue->claimed == queue->job_count)
+        {
+          svn_error_clear(svn_worker_pool__unlock(queue->workers, err));
+          break;
+        }
+
+      job = &queue->jobs[queue->claimed++];
+      svn_error_clear(svn_worker_pool__unlock(queue->workers,
+                                              SVN_NO_ERROR));
+
+      /* Late FS instance creation keeps idle workers cheap. */
+      svn_pool_clear(iterpool);
+      if (!fs && !open_err)
+        open_err = queue->open_fs_func(&fs, queue->open_fs_baton,
+                                       scratch_pool, iterpool);
+
+      job_pool = apr_allocator_owner_get(svn_pool_create_allocator(FALSE));
+      if (open_err)
+        err = svn_error_dup(open_err);
+      else
+        err = read_rev_or_pack_file(&job->result, fs, job->base, job->count,
+                                    NULL, NULL, job_pool, iterpool);
+
+      svn_error_clear(svn_worker_pool__lock(queue->workers));
+      job->pool = job_pool;
+      job->err = err;
+      job->done = TRUE;
+      svn_error_clear(svn_worker_pool__notify(queue->workers));
+      svn_error_clear(svn_worker_pool__unlock(queue->workers,
+                                              SVN_NO_ERROR));
+    }
+
+  svn_error_clear(open_err);
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Tell the workers of QUEUE to stop, wait for all of them to exit and
+ * release all outstanding results.  Return ERR.
+ */
+static svn_error_t *
+stop_stats_workers(stats_queue_t *queue,
+                   svn_error_t *err)
+{
+  int i;
+
+  svn_error_clear(svn_worker_pool__lock(queue->workers));
+  queue->stop = TRUE;
+  svn_error_clear(svn_worker_pool__notify(queue->workers));
+  svn_error_clear(svn_worker_pool__unlock(queue->workers, SVN_NO_ERROR));
+
+  /* Waits for the running jobs to return. */
+  svn_pool_destroy(queue->workers_pool);
+
+  for (i = queue->merged; i < queue->job_count; ++i)
+    {
+      svn_error_clear(queue->jobs[i].err);
+      if (queue->jobs[i].pool)
+        svn_pool_destroy(queue->jobs[i].pool);
+    }
+
+  return err;
+}
+
+/* Read the repository in QUERY using up to QUERY->JOBS worker threads
+ * and merge the results in revision order from within this thread.  Set
+ * *SCANNED to FALSE, without reading anything, if no thread could be
+ * started.  Use SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+read_revisions_in_parallel(svn_boolean_t *scanned,
+                           query_t *query,
+                           apr_pool_t *scratch_pool)
+{
+  stats_queue_t *queue = apr_pcalloc(scratch_pool, sizeof(*queue));
+  apr_pool_t *iterpool;
+  svn_revnum_t revision;
+  int threads;
+  int i;
+
+  queue->workers_pool = svn_pool_create(scratch_pool);
+  SVN_ERR(svn_worker_pool__create(&queue->workers, query->jobs,
+                                  queue->workers_pool));
+  if (!queue->workers)
+    {
+      svn_pool_destroy(queue->workers_pool);
+      *scanned = FALSE;
+      return SVN_NO_ERROR;
+    }
+
+  *scanned = TRUE;
+  threads = svn_worker_pool__thread_count(queue->workers);
+
+  /* One job per rev / pack file. */
+  queue->jobs = apr_pcalloc(scratch_pool,
+                            (query->head + 1) * sizeof(*queue->jobs));
+  for (revision = 0; revision <= query->head; )
+    {
+      stats_job_t *job = &queue->jobs[queue->job_count++];
+      job->base = revision;
+      job->count = get_file_rev_count(query, revision);
+      revision += job->count;
+    }
+
+  /* Keep all workers busy while we merge but limit the memory usage. */
+  queue->window = 4 * threads;
+  queue->open_fs_func = query->open_fs_func;
+  queue->open_fs_baton = query->open_fs_baton;
+
+  for (i = 0; i < threads; ++i)
+    {
+      svn_error_t *err = svn_worker_pool__post(NULL, queue->workers,
+                                               scan_files_job, queue,
+                                               queue->workers_pool);
+      if (err)
+        return svn_error_trace(stop_stats_workers(queue, err));
+    }
+
+  iterpool = svn_pool_create(scratch_pool);
+
+  /* Merge the results strictly in revision order. */
+  while (queue->merged < queue->job_count)
+    {
+      stats_job_t *job = &queue->jobs[queue->merged];
+      svn_error_t *err;
+
+      svn_pool_clear(iterpool);
+
+      err = svn_worker_pool__lock(queue->workers);
+      if (!err)
+        {
+          while (!err && !job->done)
+            err = svn_worker_pool__wait_for_change(queue->workers);
+          err = svn_worker_pool__unlock(queue->workers, err);
+        }
+
+      if (!err)
+        {
+          err = job->err;
+          job->err = SVN_NO_ERROR;
+        }
+      if (!err)
+        err = merge_file_stats(query, job->result);
+      if (!err && query->cancel_func)
+        err = query->cancel_func(query->cancel_baton);
+
+      if (err)
+        return svn_error_trace(stop_stats_workers(queue, err));
+
+      notify_progress(query, job->base, iterpool);
+
+      /* Make room for the next job. */
+      svn_pool_destroy(job->pool);
+      job->pool = NULL;
+
+      SVN_ERR(svn_worker_pool__lock(queue->workers));
+      queue->merged++;
+      SVN_ERR(svn_worker_pool__unlock(queue->workers,
+                svn_worker_pool__notify(queue->workers)));
+    }
+
+  SVN_ERR(stop_stats_workers(queue, SVN_NO_ERROR));
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+#endif
+
+/* Read the repository and collect the stats info in QUERY.
+ * Use SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+read_revisions(query_t *query,
+               apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool;
+  svn_revnum_t revision;
+
+#if APR_HAS_THREADS
+  if (query->jobs > 1)
+    {
+      svn_boolean_t scanned;
+
+      SVN_ERR(read_revisions_in_parallel(&scanned, query, scratch_pool));
+      if (scanned)
+        return SVN_NO_ERROR;
+    }
+#endif
+
+  iterpool = svn_pool_create(scratch_pool);
+
+  /* read all rev / pack files in order */
+  for (revision = 0; revision <= query->head; )
+    {
+      file_stats_t *file_stats;
+      int count = get_file_rev_count(query, revision);
+
+      svn_pool_clear(iterpool);
+
+      SVN_ERR(read_rev_or_pack_file(&file_stats, query->fs, revision, count,
+                                    query->cancel_func, query->cancel_baton,
+                                    iterpool, iterpool));
+      SVN_ERR(merge_file_stats(query, file_stats));
+      notify_progress(query, revision, iterpool);
+
+      revision += count;
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Accumulate stats of REP in STATS.
+ */
+static void
+add_rep_pack_stats(svn_fs_x__rep_pack_stats_t *stats,
+                   rep_stats_t *rep)
+{
+  stats->count++;
+
+  stats->packed_size += rep->size;
+  stats->expanded_size += rep->expanded_size;
+  stats->overhead_size += rep->header_size;
+}
+
+/* Accumulate stats of REP in STATS.
+ */
+static void
+add_rep_stats(svn_fs_x__representation_stats_t *stats,
+              rep_stats_t *rep)
+{
+  add_rep_pack_stats(&stats->total, rep);
+  if (rep->ref_count == 1)
+    add_rep_pack_stats(&stats->uniques, rep);
+  else
+    add_rep_pack_stats(&stats->shared, rep);
+
+  stats->references += rep->ref_count;
+  stats->expanded_size += rep->ref_count * rep->expanded_size;
+  stats->chain_len += rep->chain_length;
+}
+
+/* Aggregate the info the in revision_info_t * array REVISIONS into the
+ * respectve fields of STATS.
+ */
+static void
+aggregate_stats(const apr_array_header_t *revisions,
+                svn_fs_x__stats_t *stats)
+{
+  int i, k;
+
+  /* aggregate info from all revisions */
+  stats->revision_count = revisions->nelts;
+  for (i = 0; i < revisions->nelts; ++i)
+    {
+      revision_info_t *revision = APR_ARRAY_IDX(revisions, i,
+                                                revision_info_t *);
+
+      /* data gathered on a revision level */
+      stats->change_count += revision->change_count;
+      stats->change_len += revision->changes_len;
+      stats->total_size += revision->end;
+
+      stats->dir_node_stats.count += revision->dir_noderev_count;
+      stats->dir_node_stats.size += revision->dir_noderev_size;
+      stats->file_node_stats.count += revision->file_noderev_count;
+      stats->file_node_stats.size += revision->file_noderev_size;
+      stats->total_node_stats.count += revision->dir_noderev_count
+                                    + revision->file_noderev_count;
+      stats->total_node_stats.size += revision->dir_noderev_size
+                                   + revision->file_noderev_size;
+
+      /* process representations */
+      for (k = 0; k < revision->representations->nelts; ++k)
+        {
+          rep_stats_t *rep = APR_ARRAY_IDX(revision->representations, k,
+                                           rep_stats_t *);
+
+          /* accumulate in the right bucket */
+          switch(rep->kind)
+            {
+              case file_rep:
+                add_rep_stats(&stats->file_rep_stats, rep);
+                break;
+              case dir_rep:
+                add_rep_stats(&stats->dir_rep_stats, rep);
+                break;
+              case file_property_rep:
+                add_rep_stats(&stats->file_prop_rep_stats, rep);
+                break;
+              case dir_property_rep:
+                add_rep_stats(&stats->dir_prop_rep_stats, rep);
+                break;
+              default:
+                break;
+            }
+
+          add_rep_stats(&stats->total_rep_stats, rep);
+        }
+    }
+}
+
+/* Return a new svn_fs_x__stats_t instance, allocated in RESULT_POOL.
+ */
+static svn_fs_x__stats_t *
+create_stats(apr_pool_t *result_pool)
+{
+  svn_fs_x__stats_t *stats = apr_pcalloc(result_pool, sizeof(*stats));
+
+  initialize_largest_changes(stats, 64, result_pool);
+  stats->by_extension = apr_hash_make(result_pool);
+
+  return stats;
+}
+
+/* Create a *QUERY, allocated in RESULT_POOL, reading filesystem FS and
+ * collecting results in STATS.  Store the optional PROCESS_FUNC and
+ * PROGRESS_BATON as well as CANCEL_FUNC and CANCEL_BATON in *QUERY, too.
+ * Use SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+create_query(query_t **query,
+             svn_fs_t *fs,
+             svn_fs_x__stats_t *stats,
+             int jobs,
+             svn_fs_x__open_fs_func_t open_fs_func,
+             void *open_fs_baton,
+             svn_fs_progress_notify_func_t progress_func,
+             void *progress_baton,
+             svn_cancel_func_t cancel_func,
+             void *cancel_baton,
+             apr_pool_t *result_pool,
+             apr_pool_t *scratch_pool)
+{
+  svn_fs_x__data_t *ffd = fs->fsap_data;
+  *query = apr_pcalloc(result_pool, sizeof(**query));
+
+  /* Read repository dimensions. */
+  (*query)->shard_size = ffd->max_files_per_dir;
+  SVN_ERR(svn_fs_x__youngest_rev(&(*query)->head, fs, scratch_pool));
+  SVN_ERR(svn_fs_x__update_min_unpacked_rev(fs, scratch_pool));
+  (*query)->min_unpacked_rev = ffd->min_unpacked_rev;
+
+  /* create data containers and caches
+   * Note: this assumes that int is at least 32-bits and that we only support
+   * 32-bit wide revision numbers (actually 31-bits due to the signedness
+   * of both the nelts field of the array and our revision numbers). This
+   * means this code will fail on platforms where int is less than 32-bits
+   * and the repository has more revisions than int can hold. */
+  (*query)->revisions = apr_array_make(result_pool, (int) (*query)->head + 1,
+                                       sizeof(revision_info_t *));
+  (*query)->pool = result_pool;
+
+  /* Store other parameters */
+  (*query)->fs = fs;
+  (*query)->stats = stats;
+  (*query)->jobs = open_fs_func ? MAX(jobs, 1) : 1;
+  (*query)->open_fs_func = open_fs_func;
+  (*query)->open_fs_baton = open_fs_baton;
+  (*query)->progress_func = progress_func;
+  (*query)->progress_baton = progress_baton;
+  (*query)->cancel_func = cancel_func;
+  (*query)->cancel_baton = cancel_baton;
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_fs_x__get_stats(svn_fs_x__stats_t **stats,
+                    svn_fs_t *fs,
+                    int jobs,
+                    svn_fs_x__open_fs_func_t open_fs_func,
+                    void *open_fs_baton,
+                    svn_fs_progress_notify_func_t progress_func,
+                    void *progress_baton,
+                    svn_cancel_func_t cancel_func,
+                    void *cancel_baton,
+                    apr_pool_t *result_pool,
+                    apr_pool_t *scratch_pool)
+{
+  query_t *query;
+
+  *stats = create_stats(result_pool);
+  SVN_ERR(create_query(&query, fs, *stats, jobs, open_fs_func,
+                       open_fs_baton, progress_func, progress_baton,
+                       cancel_func, cancel_baton, scratch_pool,
+                       scratch_pool));
+  SVN_ERR(read_revisions(query, scratch_pool));
+  aggregate_stats(query->revisions, *stats);
+
+  return SVN_NO_ERROR;
+}
@@ -64,6 +64,7 @@ typedef struct builder_table_t
   builder_string_t *last;
   apr_array_header_t *short_strings;
   apr_array_header_t *long_strings;
+  apr_hash_t *short_string_dict;
   apr_hash_t *long_string_dict;
   apr_size_t long_string_size;
 } builder_table_t;
@@ -113,6 +114,7 @@ add_table(string_table_builder_t *builder)
                                         sizeof(builder_string_t *));
   table->long_strings = apr_array_make(builder->pool, 0,
                                        sizeof(svn_string_t));
+  table->short_string_dict = svn_hash__make(builder->pool);
   table->long_string_dict = svn_hash__make(builder->pool);
 
   APR_ARRAY_PUSH(builder->tables, builder_table_t *) = table;
@@ -281,13 +283,10 @@ svn_fs_x__string_table_builder_add(string_table_builder_t *builder,
   if (len == 0)
     len = strlen(string);
 
-  string = apr_pstrmemdup(builder->pool, string, len);
   if (len > MAX_SHORT_STRING_LEN)
     {
       void *idx_void;
       svn_string_t item;
-      item.data = string;
-      item.len = len;
 
       idx_void = apr_hash_get(table->long_string_dict, string, len);
       result = (apr_uintptr_t)idx_void;
@@ -296,6 +295,11 @@ svn_fs_x__string_table_builder_add(string_table_builder_t *builder,
              + LONG_STRING_MASK
              + (((apr_size_t)builder->tables->nelts - 1) << TABLE_SHIFT);
 
+      /* Copy new strings only. */
+      string = apr_pstrmemdup(builder->pool, string, len);
+      item.data = string;
+      item.len = len;
+
       if (table->long_strings->nelts == MAX_STRINGS_PER_TABLE)
         table = add_table(builder);
 
@@ -310,7 +314,18 @@ svn_fs_x__string_table_builder_add(string_table_builder_t *builder,
     }
   else
     {
-      builder_string_t *item = apr_pcalloc(builder->pool, sizeof(*item));
+      builder_string_t *item;
+
+      /* Duplicates are common.  Find them without walking the tree and
+         without copying the string. */
+      result = (apr_uintptr_t)apr_hash_get(table->short_string_dict,
+                                           string, len);
+      if (result)
+        return result - 1
+             + (((apr_size_t)builder->tables->nelts - 1) << TABLE_SHIFT);
+
+      string = apr_pstrmemdup(builder->pool, string, len);
+      item = apr_pcalloc(builder->pool, sizeof(*item));
       item->string.data = string;
       item->string.len = len;
       item->previous_match_len = 0;
@@ -337,6 +352,9 @@ svn_fs_x__string_table_builder_add(string_table_builder_t *builder,
           result = insert_string(table, &table->top, item)
                  + (((apr_size_t)builder->tables->nelts - 1) << TABLE_SHIFT);
         }
+
+      apr_hash_set(table->short_string_dict, string, len,
+                   (void*)(apr_uintptr_t)((result & STRING_INDEX_MASK) + 1));
     }
 
   return result;
@@ -368,6 +368,54 @@ svn_fs_x__node_created_rev(svn_revnum_t *revision,
 }
 
 
+/* Implement root_vtable_t.stat_paths for FSX. */
+static svn_error_t *
+x_stat_paths(apr_array_header_t **stats,
+             svn_fs_root_t *root,
+             const apr_array_header_t *paths,
+             apr_pool_t *result_pool,
+             apr_pool_t *scratch_pool)
+{
+  apr_array_header_t *nodes;
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  int i;
+
+  SVN_ERR(svn_fs_x__get_dag_nodes(&nodes, root, paths, scratch_pool,
+                                  scratch_pool));
+
+  *stats = apr_array_make(result_pool, nodes->nelts,
+                          sizeof(svn_fs_path_stat_t *));
+  for (i = 0; i < nodes->nelts; ++i)
+    {
+      dag_node_t *node = APR_ARRAY_IDX(nodes, i, dag_node_t *);
+      svn_fs_path_stat_t *stat = apr_pcalloc(result_pool, sizeof(*stat));
+      apr_hash_t *proplist;
+
+      svn_pool_clear(iterpool);
+
+      stat->kind = node ? svn_fs_x__dag_node_kind(node) : svn_node_none;
+      if (node)
+        {
+          if (stat->kind == svn_node_file)
+            SVN_ERR(svn_fs_x__dag_file_length(&stat->size, node));
+          else
+            stat->size = SVN_INVALID_FILESIZE;
+
+          SVN_ERR(svn_fs_x__dag_get_proplist(&proplist, node, iterpool,
+                                             iterpool));
+          stat->has_props = proplist && apr_hash_count(proplist);
+          stat->created_rev = svn_fs_x__dag_get_revision(node);
+        }
+
+      APR_ARRAY_PUSH(*stats, svn_fs_path_stat_t *) = stat;
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+
 /* Set *CREATED_PATH to the path at which PATH under ROOT was created.
    Return a string allocated in POOL. */
 static svn_error_t *
@@ -3229,6 +3277,8 @@ static root_vtable_t root_vtable = {
   x_get_file_delta_stream,
   x_merge,
   x_get_mergeinfo,
+  NULL,
+  x_stat_paths
 };
 
 /* Construct a new root object in FS, allocated from RESULT_POOL.  */
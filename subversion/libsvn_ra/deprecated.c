@@ -484,6 +484,23 @@ svn_error_t *svn_ra_get_dir(svn_ra_session_t *session,
                                   path, revision, SVN_DIRENT_ALL, pool);
 }
 
+svn_error_t *
+svn_ra_list(svn_ra_session_t *session,
+            const char *path,
+            svn_revnum_t revision,
+            const apr_array_header_t *patterns,
+            svn_depth_t depth,
+            apr_uint32_t dirent_fields,
+            svn_ra_dirent_receiver_t receiver,
+            void *receiver_baton,
+            apr_pool_t *scratch_pool)
+{
+  return svn_error_trace(svn_ra_list2(session, path, revision, patterns,
+                                      depth, SVN_INVALID_REVNUM,
+                                      dirent_fields, receiver,
+                                      receiver_baton, scratch_pool));
+}
+
 svn_error_t *
 svn_ra_local__deprecated_init(int abi_version,
                               apr_pool_t *pool,
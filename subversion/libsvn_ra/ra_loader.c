@@ -54,6 +54,7 @@
 
 #include "private/svn_auth_private.h"
 #include "private/svn_ra_private.h"
+#include "private/svn_subr_private.h"
 #include "svn_private_config.h"
 
 
@@ -645,17 +646,58 @@ svn_error_t *svn_ra_get_dir2(svn_ra_session_t *session,
                                   path, revision, dirent_fields, pool);
 }
 
+/* Baton type to be used with since_rev_filter(). */
+typedef struct since_rev_filter_baton_t
+{
+  /* Only pass on entries that changed in this revision or later. */
+  svn_revnum_t since_rev;
+
+  /* The DIRENT_FIELDS requested by the caller. */
+  apr_uint32_t dirent_fields;
+
+  /* The wrapped receiver and its baton. */
+  svn_ra_dirent_receiver_t receiver;
+  void *receiver_baton;
+} since_rev_filter_baton_t;
+
+/* Implements svn_ra_dirent_receiver_t.  Pass on entries to the receiver
+   in the since_rev_filter_baton_t BATON unless their created revision
+   is older than that baton's SINCE_REV. */
+static svn_error_t *
+since_rev_filter(const char *rel_path,
+                 svn_dirent_t *dirent,
+                 void *baton,
+                 apr_pool_t *scratch_pool)
+{
+  since_rev_filter_baton_t *b = baton;
+
+  if (SVN_IS_VALID_REVNUM(dirent->created_rev)
+      && dirent->created_rev < b->since_rev)
+    return SVN_NO_ERROR;
+
+  /* Don't report more than the caller asked for. */
+  if (!(b->dirent_fields & SVN_DIRENT_CREATED_REV))
+    dirent->created_rev = SVN_INVALID_REVNUM;
+
+  return svn_error_trace(b->receiver(rel_path, dirent, b->receiver_baton,
+                                     scratch_pool));
+}
+
 svn_error_t *
-svn_ra_list(svn_ra_session_t *session,
-            const char *path,
-            svn_revnum_t revision,
-            const apr_array_header_t *patterns,
-            svn_depth_t depth,
-            apr_uint32_t dirent_fields,
-            svn_ra_dirent_receiver_t receiver,
-            void *receiver_baton,
-            apr_pool_t *scratch_pool)
+svn_ra_list2(svn_ra_session_t *session,
+             const char *path,
+             svn_revnum_t revision,
+             const apr_array_header_t *patterns,
+             svn_depth_t depth,
+             svn_revnum_t since_rev,
+             apr_uint32_t dirent_fields,
+             svn_ra_dirent_receiver_t receiver,
+             void *receiver_baton,
+             apr_pool_t *scratch_pool)
 {
+  since_rev_filter_baton_t baton;
+  svn_boolean_t has_since;
+
   SVN_ERR_ASSERT(svn_relpath_is_canonical(path));
   if (!session->vtable->list)
     return svn_error_create(SVN_ERR_UNSUPPORTED_FEATURE, NULL, NULL);
@@ -663,9 +705,29 @@ svn_ra_list(svn_ra_session_t *session,
   SVN_ERR(svn_ra__assert_capable_server(session, SVN_RA_CAPABILITY_LIST,
                                         NULL, scratch_pool));
 
+  if (SVN_IS_VALID_REVNUM(since_rev))
+    SVN_ERR(svn_ra_has_capability(session, &has_since,
+                                  SVN_RA_CAPABILITY_LIST_SINCE,
+                                  scratch_pool));
+  else
+    has_since = TRUE;
+
+  if (has_since)
+    return session->vtable->list(session, path, revision, patterns, depth,
+                                 since_rev, dirent_fields,
+                                 receiver, receiver_baton, scratch_pool);
+
+  /* The server does not know how to skip unchanged sub-trees.  Let it
+     send everything and filter by created revision ourselves. */
+  baton.since_rev = since_rev;
+  baton.dirent_fields = dirent_fields;
+  baton.receiver = receiver;
+  baton.receiver_baton = receiver_baton;
+
   return session->vtable->list(session, path, revision, patterns, depth,
-                               dirent_fields, receiver, receiver_baton,
-                               scratch_pool);
+                               since_rev,
+                               dirent_fields | SVN_DIRENT_CREATED_REV,
+                               since_rev_filter, &baton, scratch_pool);
 }
 
 svn_error_t *svn_ra_get_mergeinfo(svn_ra_session_t *session,
@@ -1065,6 +1127,511 @@ svn_error_t *svn_ra_get_file_revs2(svn_ra_session_t *session,
   return svn_error_trace(err);
 }
 
+svn_error_t *
+svn_ra__get_blame(apr_array_header_t **revisions,
+                  svn_ra_session_t *session,
+                  const char *path,
+                  svn_revnum_t revision,
+                  apr_pool_t *result_pool,
+                  apr_pool_t *scratch_pool)
+{
+  SVN_ERR_ASSERT(svn_relpath_is_canonical(path));
+  if (!session->vtable->get_blame)
+    return svn_error_create(SVN_ERR_RA_NOT_IMPLEMENTED, NULL, NULL);
+
+  return session->vtable->get_blame(session, revisions, path, revision,
+                                    result_pool, scratch_pool);
+}
+
+svn_error_t *
+svn_ra__get_merge_plan(svn_mergeinfo_t *source_history,
+                       svn_mergeinfo_t *target_history,
+                       svn_mergeinfo_catalog_t *target_mergeinfo,
+                       svn_ra_session_t *session,
+                       const char *source_path,
+                       svn_revnum_t source_peg_rev,
+                       svn_revnum_t source_youngest_rev,
+                       svn_revnum_t source_oldest_rev,
+                       const char *target_path,
+                       svn_revnum_t target_rev,
+                       svn_boolean_t include_descendants,
+                       apr_pool_t *result_pool,
+                       apr_pool_t *scratch_pool)
+{
+  SVN_ERR_ASSERT(svn_relpath_is_canonical(source_path));
+  SVN_ERR_ASSERT(svn_relpath_is_canonical(target_path));
+  SVN_ERR_ASSERT(SVN_IS_VALID_REVNUM(source_peg_rev));
+  SVN_ERR_ASSERT(SVN_IS_VALID_REVNUM(target_rev));
+  if (!session->vtable->get_merge_plan)
+    return svn_error_create(SVN_ERR_RA_NOT_IMPLEMENTED, NULL, NULL);
+
+  return session->vtable->get_merge_plan(session, source_history,
+                                         target_history, target_mergeinfo,
+                                         source_path, source_peg_rev,
+                                         source_youngest_rev,
+                                         source_oldest_rev,
+                                         target_path, target_rev,
+                                         include_descendants,
+                                         result_pool, scratch_pool);
+}
+
+svn_error_t *
+svn_ra__get_changes_summary(apr_hash_t **changes,
+                            svn_ra_session_t *session,
+                            const char *path,
+                            svn_revnum_t start_rev,
+                            svn_revnum_t end_rev,
+                            svn_depth_t depth,
+                            apr_pool_t *result_pool,
+                            apr_pool_t *scratch_pool)
+{
+  SVN_ERR_ASSERT(svn_relpath_is_canonical(path));
+  SVN_ERR_ASSERT(SVN_IS_VALID_REVNUM(start_rev));
+  SVN_ERR_ASSERT(SVN_IS_VALID_REVNUM(end_rev));
+  SVN_ERR_ASSERT(start_rev <= end_rev);
+  if (!session->vtable->get_changes_summary)
+    return svn_error_create(SVN_ERR_RA_NOT_IMPLEMENTED, NULL, NULL);
+
+  return session->vtable->get_changes_summary(session, changes, path,
+                                              start_rev, end_rev, depth,
+                                              result_pool, scratch_pool);
+}
+
+/* Baton for stat_collector(). */
+typedef struct stat_collector_baton_t
+{
+  /* The svn_revnum_t revisions and the (possibly NULL) svn_dirent_t *
+     dirents received so far, in order. */
+  apr_array_header_t *revisions;
+  apr_array_header_t *dirents;
+
+  /* Pool to allocate the results in. */
+  apr_pool_t *pool;
+} stat_collector_baton_t;
+
+/* Implements svn_ra__stat_receiver_t, collecting revision and dirent in
+   the stat_collector_baton_t BATON. */
+static svn_error_t *
+stat_collector(const char *path,
+               svn_revnum_t revision,
+               svn_dirent_t *dirent,
+               svn_lock_t *lock,
+               void *baton,
+               apr_pool_t *scratch_pool)
+{
+  stat_collector_baton_t *b = baton;
+
+  APR_ARRAY_PUSH(b->revisions, svn_revnum_t) = revision;
+  APR_ARRAY_PUSH(b->dirents, svn_dirent_t *)
+    = dirent ? svn_dirent_dup(dirent, b->pool) : NULL;
+
+  return SVN_NO_ERROR;
+}
+
+/* Fetch the lock on PATH in SESSION into *LOCK, allocated in POOL.
+   Treat servers that don't support locking as if there was none. */
+static svn_error_t *
+get_lock_if_supported(svn_lock_t **lock,
+                      svn_ra_session_t *session,
+                      const char *path,
+                      apr_pool_t *pool)
+{
+  svn_error_t *err = svn_ra_get_lock(session, lock, path, pool);
+
+  if (err && err->apr_err == SVN_ERR_RA_NOT_IMPLEMENTED)
+    {
+      svn_error_clear(err);
+      *lock = NULL;
+      return SVN_NO_ERROR;
+    }
+
+  return svn_error_trace(err);
+}
+
+/* Implement svn_ra_stat_many() and svn_ra__stat_many(), passing locks
+   to RECEIVER if FETCH_LOCKS is set. */
+static svn_error_t *
+stat_many(svn_ra_session_t *session,
+          const apr_array_header_t *paths,
+          const apr_array_header_t *revisions,
+          svn_boolean_t fetch_locks,
+          svn_ra__stat_receiver_t receiver,
+          void *receiver_baton,
+          apr_pool_t *scratch_pool)
+{
+  svn_revnum_t youngest = SVN_INVALID_REVNUM;
+  svn_boolean_t has_stat_many = FALSE;
+  apr_pool_t *iterpool;
+  int i;
+
+  SVN_ERR_ASSERT(paths->nelts == revisions->nelts);
+  for (i = 0; i < paths->nelts; i++)
+    {
+      const char *path = APR_ARRAY_IDX(paths, i, const char *);
+      SVN_ERR_ASSERT(svn_relpath_is_canonical(path));
+    }
+
+  if (session->vtable->stat_many)
+    SVN_ERR(svn_ra_has_capability(session, &has_stat_many,
+                                  SVN_RA_CAPABILITY_STAT_MANY,
+                                  scratch_pool));
+  if (has_stat_many)
+    {
+      svn_error_t *err = session->vtable->stat_many(session, paths,
+                                                    revisions, fetch_locks,
+                                                    receiver, receiver_baton,
+                                                    scratch_pool);
+      if (!err || err->apr_err != SVN_ERR_RA_NOT_IMPLEMENTED || !fetch_locks)
+        return svn_error_trace(err);
+
+      svn_error_clear(err);
+    }
+
+  /* The RA layer can stat in bulk, but not send the locks along.  Collect
+     the dirents, then ask for the locks, since RECEIVER can't be called
+     while the session is busy. */
+  if (has_stat_many)
+    {
+      stat_collector_baton_t b;
+
+      b.revisions = apr_array_make(scratch_pool, paths->nelts,
+                                   sizeof(svn_revnum_t));
+      b.dirents = apr_array_make(scratch_pool, paths->nelts,
+                                 sizeof(svn_dirent_t *));
+      b.pool = scratch_pool;
+      SVN_ERR(session->vtable->stat_many(session, paths, revisions, FALSE,
+                                         stat_collector, &b, scratch_pool));
+      if (b.dirents->nelts != paths->nelts)
+        return svn_error_create(SVN_ERR_INCOMPLETE_DATA, NULL,
+                                _("Incomplete stat results"));
+
+      iterpool = svn_pool_create(scratch_pool);
+      for (i = 0; i < paths->nelts; i++)
+        {
+          const char *path = APR_ARRAY_IDX(paths, i, const char *);
+          svn_dirent_t *dirent = APR_ARRAY_IDX(b.dirents, i, svn_dirent_t *);
+          svn_lock_t *lock = NULL;
+
+          svn_pool_clear(iterpool);
+
+          if (dirent)
+            SVN_ERR(get_lock_if_supported(&lock, session, path, iterpool));
+
+          SVN_ERR(receiver(path, APR_ARRAY_IDX(b.revisions, i, svn_revnum_t),
+                           dirent, lock, receiver_baton, iterpool));
+        }
+      svn_pool_destroy(iterpool);
+
+      return SVN_NO_ERROR;
+    }
+
+  /* Fall back to one request (or two) per path. */
+  iterpool = svn_pool_create(scratch_pool);
+  for (i = 0; i < paths->nelts; i++)
+    {
+      const char *path = APR_ARRAY_IDX(paths, i, const char *);
+      svn_revnum_t revision = APR_ARRAY_IDX(revisions, i, svn_revnum_t);
+      svn_dirent_t *dirent;
+      svn_lock_t *lock = NULL;
+
+      svn_pool_clear(iterpool);
+
+      if (!SVN_IS_VALID_REVNUM(revision))
+        {
+          if (!SVN_IS_VALID_REVNUM(youngest))
+            SVN_ERR(svn_ra_get_latest_revnum(session, &youngest, iterpool));
+          revision = youngest;
+        }
+
+      SVN_ERR(svn_ra_stat(session, path, revision, &dirent, iterpool));
+      if (dirent && fetch_locks)
+        SVN_ERR(get_lock_if_supported(&lock, session, path, iterpool));
+
+      SVN_ERR(receiver(path, revision, dirent, lock, receiver_baton,
+                       iterpool));
+    }
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Baton for stat_many_receiver(). */
+typedef struct stat_many_baton_t
+{
+  svn_ra_stat_receiver_t receiver;
+  void *receiver_baton;
+} stat_many_baton_t;
+
+/* Implements svn_ra__stat_receiver_t, calling the svn_ra_stat_receiver_t
+   in the stat_many_baton_t BATON. */
+static svn_error_t *
+stat_many_receiver(const char *path,
+                   svn_revnum_t revision,
+                   svn_dirent_t *dirent,
+                   svn_lock_t *lock,
+                   void *baton,
+                   apr_pool_t *scratch_pool)
+{
+  stat_many_baton_t *b = baton;
+
+  return svn_error_trace(b->receiver(path, revision, dirent,
+                                     b->receiver_baton, scratch_pool));
+}
+
+svn_error_t *
+svn_ra_stat_many(svn_ra_session_t *session,
+                 const apr_array_header_t *paths,
+                 const apr_array_header_t *revisions,
+                 svn_ra_stat_receiver_t receiver,
+                 void *receiver_baton,
+                 apr_pool_t *scratch_pool)
+{
+  stat_many_baton_t baton;
+
+  baton.receiver = receiver;
+  baton.receiver_baton = receiver_baton;
+
+  return svn_error_trace(stat_many(session, paths, revisions, FALSE,
+                                   stat_many_receiver, &baton,
+                                   scratch_pool));
+}
+
+/* Baton for stat_hash_receiver(). */
+typedef struct stat_hash_baton_t
+{
+  apr_hash_t *dirents;
+  apr_hash_t *locks;
+  apr_pool_t *pool;
+} stat_hash_baton_t;
+
+/* Implements svn_ra__stat_receiver_t, adding the results to the hashes
+   in the stat_hash_baton_t BATON. */
+static svn_error_t *
+stat_hash_receiver(const char *path,
+                   svn_revnum_t revision,
+                   svn_dirent_t *dirent,
+                   svn_lock_t *lock,
+                   void *baton,
+                   apr_pool_t *scratch_pool)
+{
+  stat_hash_baton_t *b = baton;
+
+  if (!dirent)
+    return SVN_NO_ERROR;
+
+  path = apr_pstrdup(b->pool, path);
+  svn_hash_sets(b->dirents, path, svn_dirent_dup(dirent, b->pool));
+  if (b->locks && lock)
+    svn_hash_sets(b->locks, path, svn_lock_dup(lock, b->pool));
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_ra__stat_many(apr_hash_t **dirents,
+                  apr_hash_t **locks,
+                  svn_ra_session_t *session,
+                  const apr_array_header_t *paths,
+                  svn_revnum_t revision,
+                  apr_pool_t *result_pool,
+                  apr_pool_t *scratch_pool)
+{
+  apr_array_header_t *revisions;
+  stat_hash_baton_t baton;
+  int i;
+
+  revisions = apr_array_make(scratch_pool, paths->nelts,
+                             sizeof(svn_revnum_t));
+  for (i = 0; i < paths->nelts; i++)
+    APR_ARRAY_PUSH(revisions, svn_revnum_t) = revision;
+
+  baton.dirents = apr_hash_make(result_pool);
+  baton.locks = locks ? apr_hash_make(result_pool) : NULL;
+  baton.pool = result_pool;
+
+  SVN_ERR(stat_many(session, paths, revisions, locks != NULL,
+                    stat_hash_receiver, &baton, scratch_pool));
+
+  *dirents = baton.dirents;
+  if (locks)
+    *locks = baton.locks;
+
+  return SVN_NO_ERROR;
+}
+
+/* Contents of up to this size get buffered in memory by svn_ra_get_files()
+   when falling back to svn_ra_get_file().  Anything larger gets spilled to
+   a temporary file. */
+#define GET_FILES_SPILL_SIZE (1024 * 1024)
+
+svn_error_t *
+svn_ra_get_files(svn_ra_session_t *session,
+                 const apr_array_header_t *paths,
+                 const apr_array_header_t *revisions,
+                 svn_boolean_t want_props,
+                 svn_ra_file_receiver_t receiver,
+                 void *receiver_baton,
+                 apr_pool_t *scratch_pool)
+{
+  svn_revnum_t youngest = SVN_INVALID_REVNUM;
+  svn_boolean_t has_get_files = FALSE;
+  apr_pool_t *iterpool;
+  int i;
+
+  SVN_ERR_ASSERT(paths->nelts == revisions->nelts);
+  for (i = 0; i < paths->nelts; i++)
+    {
+      const char *path = APR_ARRAY_IDX(paths, i, const char *);
+      SVN_ERR_ASSERT(svn_relpath_is_canonical(path));
+    }
+
+  if (session->vtable->get_files)
+    SVN_ERR(svn_ra_has_capability(session, &has_get_files,
+                                  SVN_RA_CAPABILITY_GET_FILES,
+                                  scratch_pool));
+  if (has_get_files)
+    return svn_error_trace(session->vtable->get_files(session, paths,
+                                                      revisions, want_props,
+                                                      receiver,
+                                                      receiver_baton,
+                                                      scratch_pool));
+
+  /* Fall back to one request per file.  svn_ra_get_file() sends the
+     contents before we know the props, so the contents have to be
+     buffered until RECEIVER can be called if it wants both. */
+  iterpool = svn_pool_create(scratch_pool);
+  for (i = 0; i < paths->nelts; i++)
+    {
+      const char *path = APR_ARRAY_IDX(paths, i, const char *);
+      svn_revnum_t revision = APR_ARRAY_IDX(revisions, i, svn_revnum_t);
+      svn_stream_t *stream;
+
+      svn_pool_clear(iterpool);
+
+      if (!SVN_IS_VALID_REVNUM(revision))
+        {
+          if (!SVN_IS_VALID_REVNUM(youngest))
+            SVN_ERR(svn_ra_get_latest_revnum(session, &youngest,
+                                             scratch_pool));
+          revision = youngest;
+        }
+
+      if (want_props)
+        {
+          svn_spillbuf_t *buf = svn_spillbuf__create(SVN__STREAM_CHUNK_SIZE,
+                                                     GET_FILES_SPILL_SIZE,
+                                                     iterpool);
+          svn_stream_t *spool = svn_stream__from_spillbuf(buf, iterpool);
+          apr_hash_t *props;
+
+          SVN_ERR(svn_ra_get_file(session, path, revision, spool, NULL,
+                                  &props, iterpool));
+          SVN_ERR(receiver(&stream, path, revision, props, receiver_baton,
+                           iterpool));
+          if (stream)
+            SVN_ERR(svn_stream_copy3(spool, stream, NULL, NULL, iterpool));
+          else
+            SVN_ERR(svn_stream_close(spool));
+        }
+      else
+        {
+          SVN_ERR(receiver(&stream, path, revision, NULL, receiver_baton,
+                           iterpool));
+          SVN_ERR(svn_ra_get_file(session, path, revision, stream, NULL,
+                                  NULL, iterpool));
+          if (stream)
+            SVN_ERR(svn_stream_close(stream));
+        }
+    }
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_ra_rev_proplist_range(svn_ra_session_t *session,
+                          svn_revnum_t start_rev,
+                          svn_revnum_t end_rev,
+                          svn_ra_rev_proplist_receiver_t receiver,
+                          void *receiver_baton,
+                          apr_pool_t *scratch_pool)
+{
+  svn_boolean_t has_range = FALSE;
+  apr_pool_t *iterpool;
+  svn_revnum_t rev;
+
+  SVN_ERR_ASSERT(SVN_IS_VALID_REVNUM(start_rev)
+                 && SVN_IS_VALID_REVNUM(end_rev)
+                 && start_rev <= end_rev);
+
+  if (session->vtable->rev_proplist_range)
+    SVN_ERR(svn_ra_has_capability(session, &has_range,
+                                  SVN_RA_CAPABILITY_REV_PROPLIST_RANGE,
+                                  scratch_pool));
+  if (has_range)
+    return svn_error_trace(session->vtable->rev_proplist_range(
+                             session, start_rev, end_rev,
+                             receiver, receiver_baton, scratch_pool));
+
+  /* Fall back to one request per revision. */
+  iterpool = svn_pool_create(scratch_pool);
+  for (rev = start_rev; rev <= end_rev; rev++)
+    {
+      apr_hash_t *props;
+
+      svn_pool_clear(iterpool);
+
+      SVN_ERR(session->vtable->rev_proplist(session, rev, &props, iterpool));
+      SVN_ERR(receiver(rev, props, receiver_baton, iterpool));
+    }
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_ra__change_rev_props(svn_ra_session_t *session,
+                         svn_revnum_t rev,
+                         const apr_array_header_t *changes,
+                         apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool;
+  int i;
+
+  SVN_ERR_ASSERT(SVN_IS_VALID_REVNUM(rev));
+  for (i = 0; i < changes->nelts; i++)
+    {
+      const svn_prop_t *prop = &APR_ARRAY_IDX(changes, i, svn_prop_t);
+      SVN_ERR_ASSERT(prop->name);
+    }
+
+  /* A single change doesn't need a batch. */
+  if (session->vtable->change_rev_props && changes->nelts > 1)
+    {
+      svn_error_t *err = session->vtable->change_rev_props(session, rev,
+                                                           changes,
+                                                           scratch_pool);
+      if (!err || err->apr_err != SVN_ERR_RA_NOT_IMPLEMENTED)
+        return svn_error_trace(err);
+
+      svn_error_clear(err);
+    }
+
+  iterpool = svn_pool_create(scratch_pool);
+  for (i = 0; i < changes->nelts; i++)
+    {
+      const svn_prop_t *prop = &APR_ARRAY_IDX(changes, i, svn_prop_t);
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(session->vtable->change_rev_prop(session, rev, prop->name,
+                                               NULL, prop->value,
+                                               iterpool));
+    }
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *svn_ra_lock(svn_ra_session_t *session,
                          apr_hash_t *path_revs,
                          const char *comment,
@@ -49,6 +49,15 @@ typedef svn_error_t * (*svn_ra__open_func_t)(svn_ra_session_t **session_p,
                                               apr_hash_t *config,
                                               apr_pool_t *pool);
 
+/* Like svn_ra_stat_receiver_t, but also receiving the (possibly NULL)
+   LOCK on the node, if requested. */
+typedef svn_error_t *(*svn_ra__stat_receiver_t)(const char *path,
+                                                svn_revnum_t revision,
+                                                svn_dirent_t *dirent,
+                                                svn_lock_t *lock,
+                                                void *baton,
+                                                apr_pool_t *scratch_pool);
+
 /* The RA layer vtable. */
 typedef struct svn_ra__vtable_t {
   /* This field should always remain first in the vtable. */
@@ -332,12 +341,14 @@ typedef struct svn_ra__vtable_t {
   svn_error_t *(*set_svn_ra_open)(svn_ra_session_t *session,
                                   svn_ra__open_func_t func);
 
-  /* See svn_ra_list(). */
+  /* See svn_ra_list2().  SINCE_REV will only be valid if the server has
+     the SVN_RA_CAPABILITY_LIST_SINCE capability. */
   svn_error_t *(*list)(svn_ra_session_t *session,
                        const char *path,
                        svn_revnum_t revision,
                        const apr_array_header_t *patterns,
                        svn_depth_t depth,
+                       svn_revnum_t since_rev,
                        apr_uint32_t dirent_fields,
                        svn_ra_dirent_receiver_t receiver,
                        void *receiver_baton,
@@ -378,6 +389,77 @@ typedef struct svn_ra__vtable_t {
     void *replay_baton,
     apr_pool_t *scratch_pool);
 
+  /* See svn_ra__get_blame().  May be NULL. */
+  svn_error_t *(*get_blame)(svn_ra_session_t *session,
+                            apr_array_header_t **revisions,
+                            const char *path,
+                            svn_revnum_t revision,
+                            apr_pool_t *result_pool,
+                            apr_pool_t *scratch_pool);
+
+  /* See svn_ra__get_merge_plan().  May be NULL. */
+  svn_error_t *(*get_merge_plan)(svn_ra_session_t *session,
+                                 svn_mergeinfo_t *source_history,
+                                 svn_mergeinfo_t *target_history,
+                                 svn_mergeinfo_catalog_t *target_mergeinfo,
+                                 const char *source_path,
+                                 svn_revnum_t source_peg_rev,
+                                 svn_revnum_t source_youngest_rev,
+                                 svn_revnum_t source_oldest_rev,
+                                 const char *target_path,
+                                 svn_revnum_t target_rev,
+                                 svn_boolean_t include_descendants,
+                                 apr_pool_t *result_pool,
+                                 apr_pool_t *scratch_pool);
+
+  /* See svn_ra_stat_many().  If FETCH_LOCKS is set, also pass the lock
+     in HEAD for each existing node to RECEIVER.  Only called if the
+     session has SVN_RA_CAPABILITY_STAT_MANY.  May return
+     SVN_ERR_RA_NOT_IMPLEMENTED if FETCH_LOCKS is set. */
+  svn_error_t *(*stat_many)(svn_ra_session_t *session,
+                            const apr_array_header_t *paths,
+                            const apr_array_header_t *revisions,
+                            svn_boolean_t fetch_locks,
+                            svn_ra__stat_receiver_t receiver,
+                            void *receiver_baton,
+                            apr_pool_t *scratch_pool);
+
+  /* See svn_ra_get_files().  Only called if the session has
+     SVN_RA_CAPABILITY_GET_FILES. */
+  svn_error_t *(*get_files)(svn_ra_session_t *session,
+                            const apr_array_header_t *paths,
+                            const apr_array_header_t *revisions,
+                            svn_boolean_t want_props,
+                            svn_ra_file_receiver_t receiver,
+                            void *receiver_baton,
+                            apr_pool_t *scratch_pool);
+
+  /* See svn_ra_rev_proplist_range().  Only called if the session has
+     SVN_RA_CAPABILITY_REV_PROPLIST_RANGE. */
+  svn_error_t *(*rev_proplist_range)(svn_ra_session_t *session,
+                                     svn_revnum_t start_rev,
+                                     svn_revnum_t end_rev,
+                                     svn_ra_rev_proplist_receiver_t receiver,
+                                     void *receiver_baton,
+                                     apr_pool_t *scratch_pool);
+
+  /* See svn_ra__change_rev_props().  May be NULL.  May return
+     SVN_ERR_RA_NOT_IMPLEMENTED if the server doesn't support it. */
+  svn_error_t *(*change_rev_props)(svn_ra_session_t *session,
+                                   svn_revnum_t rev,
+                                   const apr_array_header_t *changes,
+                                   apr_pool_t *scratch_pool);
+
+  /* See svn_ra__get_changes_summary().  May be NULL. */
+  svn_error_t *(*get_changes_summary)(svn_ra_session_t *session,
+                                      apr_hash_t **changes,
+                                      const char *path,
+                                      svn_revnum_t start_rev,
+                                      svn_revnum_t end_rev,
+                                      svn_depth_t depth,
+                                      apr_pool_t *result_pool,
+                                      apr_pool_t *scratch_pool);
+
 } svn_ra__vtable_t;
 
 /* The RA session object. */
@@ -731,6 +731,89 @@ svn_ra_local__get_file_revs(svn_ra_session_t *session,
                                   handler, handler_baton, pool);
 }
 
+static svn_error_t *
+svn_ra_local__get_blame(svn_ra_session_t *session,
+                        apr_array_header_t **revisions,
+                        const char *path,
+                        svn_revnum_t revision,
+                        apr_pool_t *result_pool,
+                        apr_pool_t *scratch_pool)
+{
+  svn_ra_local__session_baton_t *sess = session->priv;
+  const char *abs_path = svn_fspath__join(sess->fs_path->data, path,
+                                          scratch_pool);
+
+  return svn_error_trace(svn_repos__get_blame(revisions, sess->repos,
+                                              abs_path, revision, NULL, NULL,
+                                              session->cancel_func,
+                                              session->cancel_baton,
+                                              result_pool, scratch_pool));
+}
+
+static svn_error_t *
+svn_ra_local__get_merge_plan(svn_ra_session_t *session,
+                             svn_mergeinfo_t *source_history,
+                             svn_mergeinfo_t *target_history,
+                             svn_mergeinfo_catalog_t *target_mergeinfo,
+                             const char *source_path,
+                             svn_revnum_t source_peg_rev,
+                             svn_revnum_t source_youngest_rev,
+                             svn_revnum_t source_oldest_rev,
+                             const char *target_path,
+                             svn_revnum_t target_rev,
+                             svn_boolean_t include_descendants,
+                             apr_pool_t *result_pool,
+                             apr_pool_t *scratch_pool)
+{
+  svn_ra_local__session_baton_t *sess = session->priv;
+  svn_mergeinfo_catalog_t catalog;
+  apr_hash_index_t *hi;
+
+  SVN_ERR(svn_repos__get_merge_plan(
+            source_history, target_history, &catalog, sess->repos,
+            svn_fspath__join(sess->fs_path->data, source_path, scratch_pool),
+            source_peg_rev, source_youngest_rev, source_oldest_rev,
+            svn_fspath__join(sess->fs_path->data, target_path, scratch_pool),
+            target_rev, include_descendants, NULL, NULL,
+            result_pool, scratch_pool));
+
+  /* Key the catalog by repository relpaths. */
+  *target_mergeinfo = NULL;
+  if (catalog)
+    {
+      *target_mergeinfo = apr_hash_make(result_pool);
+      for (hi = apr_hash_first(scratch_pool, catalog);
+           hi;
+           hi = apr_hash_next(hi))
+        svn_hash_sets(*target_mergeinfo,
+                      svn_fspath__skip_ancestor("/", apr_hash_this_key(hi)),
+                      apr_hash_this_val(hi));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+svn_ra_local__get_changes_summary(svn_ra_session_t *session,
+                                  apr_hash_t **changes,
+                                  const char *path,
+                                  svn_revnum_t start_rev,
+                                  svn_revnum_t end_rev,
+                                  svn_depth_t depth,
+                                  apr_pool_t *result_pool,
+                                  apr_pool_t *scratch_pool)
+{
+  svn_ra_local__session_baton_t *sess = session->priv;
+  const char *abs_path = svn_fspath__join(sess->fs_path->data, path,
+                                          scratch_pool);
+
+  return svn_error_trace(svn_repos__get_changes_summary(
+                           changes, sess->repos, abs_path, start_rev,
+                           end_rev, depth, NULL, NULL,
+                           session->cancel_func, session->cancel_baton,
+                           result_pool, scratch_pool));
+}
+
 static svn_error_t *
 svn_ra_local__get_dated_revision(svn_ra_session_t *session,
                                  svn_revnum_t *revision,
@@ -789,6 +872,33 @@ svn_ra_local__rev_proplist(svn_ra_session_t *session,
                                         NULL, NULL, pool);
 }
 
+static svn_error_t *
+svn_ra_local__rev_proplist_range(svn_ra_session_t *session,
+                                 svn_revnum_t start_rev,
+                                 svn_revnum_t end_rev,
+                                 svn_ra_rev_proplist_receiver_t receiver,
+                                 void *receiver_baton,
+                                 apr_pool_t *scratch_pool)
+{
+  svn_ra_local__session_baton_t *sess = session->priv;
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  svn_revnum_t rev;
+
+  for (rev = start_rev; rev <= end_rev; rev++)
+    {
+      apr_hash_t *props;
+
+      svn_pool_clear(iterpool);
+
+      SVN_ERR(svn_repos_fs_revision_proplist(&props, sess->repos, rev,
+                                             NULL, NULL, iterpool));
+      SVN_ERR(receiver(rev, props, receiver_baton, iterpool));
+    }
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
 static svn_error_t *
 svn_ra_local__rev_prop(svn_ra_session_t *session,
                        svn_revnum_t rev,
@@ -1210,6 +1320,63 @@ svn_ra_local__stat(svn_ra_session_t *session,
   return svn_repos_stat(dirent, root, abs_path, pool);
 }
 
+static svn_error_t *
+svn_ra_local__stat_many(svn_ra_session_t *session,
+                        const apr_array_header_t *paths,
+                        const apr_array_header_t *revisions,
+                        svn_boolean_t fetch_locks,
+                        svn_ra__stat_receiver_t receiver,
+                        void *receiver_baton,
+                        apr_pool_t *scratch_pool)
+{
+  svn_ra_local__session_baton_t *sess = session->priv;
+  svn_revnum_t youngest = SVN_INVALID_REVNUM;
+  svn_revnum_t root_rev = SVN_INVALID_REVNUM;
+  svn_fs_root_t *root = NULL;
+  apr_pool_t *root_pool = svn_pool_create(scratch_pool);
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  int i;
+
+  for (i = 0; i < paths->nelts; i++)
+    {
+      const char *path = APR_ARRAY_IDX(paths, i, const char *);
+      svn_revnum_t revision = APR_ARRAY_IDX(revisions, i, svn_revnum_t);
+      const char *abs_path;
+      svn_dirent_t *dirent;
+      svn_lock_t *lock = NULL;
+
+      svn_pool_clear(iterpool);
+
+      if (! SVN_IS_VALID_REVNUM(revision))
+        {
+          if (! SVN_IS_VALID_REVNUM(youngest))
+            SVN_ERR(svn_fs_youngest_rev(&youngest, sess->fs, scratch_pool));
+          revision = youngest;
+        }
+
+      /* Re-use the root for consecutive paths in the same revision. */
+      if (revision != root_rev)
+        {
+          svn_pool_clear(root_pool);
+          SVN_ERR(svn_fs_revision_root(&root, sess->fs, revision,
+                                       root_pool));
+          root_rev = revision;
+        }
+
+      abs_path = svn_fspath__join(sess->fs_path->data, path, iterpool);
+      SVN_ERR(svn_repos_stat(&dirent, root, abs_path, iterpool));
+      if (dirent && fetch_locks)
+        SVN_ERR(svn_fs_get_lock(&lock, sess->fs, abs_path, iterpool));
+
+      SVN_ERR(receiver(path, revision, dirent, lock, receiver_baton,
+                       iterpool));
+    }
+  svn_pool_destroy(iterpool);
+  svn_pool_destroy(root_pool);
+
+  return SVN_NO_ERROR;
+}
+
 
 
 
@@ -1321,6 +1488,85 @@ svn_ra_local__get_file(svn_ra_session_t *session,
   return SVN_NO_ERROR;
 }
 
+/* Getting many files. */
+static svn_error_t *
+svn_ra_local__get_files(svn_ra_session_t *session,
+                        const apr_array_header_t *paths,
+                        const apr_array_header_t *revisions,
+                        svn_boolean_t want_props,
+                        svn_ra_file_receiver_t receiver,
+                        void *receiver_baton,
+                        apr_pool_t *scratch_pool)
+{
+  svn_ra_local__session_baton_t *sess = session->priv;
+  svn_revnum_t youngest = SVN_INVALID_REVNUM;
+  svn_revnum_t root_rev = SVN_INVALID_REVNUM;
+  svn_fs_root_t *root = NULL;
+  apr_pool_t *root_pool = svn_pool_create(scratch_pool);
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  int i;
+
+  for (i = 0; i < paths->nelts; i++)
+    {
+      const char *path = APR_ARRAY_IDX(paths, i, const char *);
+      svn_revnum_t revision = APR_ARRAY_IDX(revisions, i, svn_revnum_t);
+      const char *abs_path;
+      svn_node_kind_t node_kind;
+      apr_hash_t *props = NULL;
+      svn_stream_t *stream;
+
+      svn_pool_clear(iterpool);
+
+      if (! SVN_IS_VALID_REVNUM(revision))
+        {
+          if (! SVN_IS_VALID_REVNUM(youngest))
+            SVN_ERR(svn_fs_youngest_rev(&youngest, sess->fs, scratch_pool));
+          revision = youngest;
+        }
+
+      /* Re-use the root for consecutive files in the same revision. */
+      if (revision != root_rev)
+        {
+          svn_pool_clear(root_pool);
+          SVN_ERR(svn_fs_revision_root(&root, sess->fs, revision,
+                                       root_pool));
+          root_rev = revision;
+        }
+
+      abs_path = svn_fspath__join(sess->fs_path->data, path, iterpool);
+      SVN_ERR(svn_fs_check_path(&node_kind, root, abs_path, iterpool));
+      if (node_kind == svn_node_none)
+        return svn_error_createf(SVN_ERR_FS_NOT_FOUND, NULL,
+                                 _("'%s' path not found"), abs_path);
+      else if (node_kind != svn_node_file)
+        return svn_error_createf(SVN_ERR_FS_NOT_FILE, NULL,
+                                 _("'%s' is not a file"), abs_path);
+
+      if (want_props)
+        SVN_ERR(get_node_props(&props, root, abs_path, sess->uuid,
+                               iterpool, iterpool));
+
+      SVN_ERR(receiver(&stream, path, revision, props, receiver_baton,
+                       iterpool));
+      if (stream)
+        {
+          svn_stream_t *contents;
+
+          /* As in svn_ra_local__get_file(), the FS verifies the checksum. */
+          SVN_ERR(svn_fs_file_contents(&contents, root, abs_path, iterpool));
+          SVN_ERR(svn_stream_copy3(contents, stream,
+                                   sess->callbacks
+                                     ? sess->callbacks->cancel_func : NULL,
+                                   sess->callback_baton,
+                                   iterpool));
+        }
+    }
+  svn_pool_destroy(iterpool);
+  svn_pool_destroy(root_pool);
+
+  return SVN_NO_ERROR;
+}
+
 
 
 /* Getting a directory's entries */
@@ -1673,6 +1919,10 @@ svn_ra_local__has_capability(svn_ra_session_t *session,
       || strcmp(capability, SVN_RA_CAPABILITY_EPHEMERAL_TXNPROPS) == 0
       || strcmp(capability, SVN_RA_CAPABILITY_GET_FILE_REVS_REVERSE) == 0
       || strcmp(capability, SVN_RA_CAPABILITY_LIST) == 0
+      || strcmp(capability, SVN_RA_CAPABILITY_LIST_SINCE) == 0
+      || strcmp(capability, SVN_RA_CAPABILITY_STAT_MANY) == 0
+      || strcmp(capability, SVN_RA_CAPABILITY_GET_FILES) == 0
+      || strcmp(capability, SVN_RA_CAPABILITY_REV_PROPLIST_RANGE) == 0
       )
     {
       *has = TRUE;
@@ -1839,6 +2089,7 @@ svn_ra_local__list(svn_ra_session_t *session,
                    svn_revnum_t revision,
                    const apr_array_header_t *patterns,
                    svn_depth_t depth,
+                   svn_revnum_t since_rev,
                    apr_uint32_t dirent_fields,
                    svn_ra_dirent_receiver_t receiver,
                    void *receiver_baton,
@@ -1854,13 +2105,13 @@ svn_ra_local__list(svn_ra_session_t *session,
 
   SVN_ERR(svn_fs_revision_root(&root, sess->fs, revision, pool));
   path = svn_dirent_join(sess->fs_path->data, path, pool);
-  return svn_error_trace(svn_repos_list(root, path, patterns, depth,
-                                        path_info_only, NULL, NULL,
-                                        dirent_receiver, &baton,
-                                        sess->callbacks
-                                          ? sess->callbacks->cancel_func
-                                          : NULL,
-                                        sess->callback_baton, pool));
+  return svn_error_trace(svn_repos_list2(root, path, patterns, depth,
+                                         since_rev, path_info_only, NULL, NULL,
+                                         dirent_receiver, &baton,
+                                         sess->callbacks
+                                           ? sess->callbacks->cancel_func
+                                           : NULL,
+                                         sess->callback_baton, pool));
 }
 
 /*----------------------------------------------------------------*/
@@ -1916,7 +2167,14 @@ static const svn_ra__vtable_t ra_local_vtable =
   svn_ra_local__list ,
   svn_ra_local__register_editor_shim_callbacks,
   svn_ra_local__get_commit_ev2,
-  NULL /* replay_range_ev2 */
+  NULL /* replay_range_ev2 */,
+  svn_ra_local__get_blame,
+  svn_ra_local__get_merge_plan,
+  svn_ra_local__stat_many,
+  svn_ra_local__get_files,
+  svn_ra_local__rev_proplist_range,
+  NULL /* change_rev_props */,
+  svn_ra_local__get_changes_summary
 };
 
 
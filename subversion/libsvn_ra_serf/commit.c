@@ -72,8 +72,16 @@ typedef struct commit_context_t {
   const char *vcc_url;           /* vcc url */
 
   int open_batons;               /* Number of open batons */
+
+  /* PUT requests queued by close_file() that haven't been reaped yet,
+     most recent first. */
+  struct put_context_t *puts;
+  int put_count;                 /* Number of PUTs queued so far */
 } commit_context_t;
 
+/* Maximum number of PUT requests in flight at any time. */
+#define MAX_PENDING_PUTS 16
+
 #define USING_HTTPV2_COMMIT_SUPPORT(commit_ctx) ((commit_ctx)->txn_url != NULL)
 
 /* Structure associated with a PROPPATCH request. */
@@ -194,8 +202,27 @@ typedef struct file_context_t {
   /* URL to PUT the file at. */
   const char *url;
 
+  /* Pool holding SVNDIFF; it outlives POOL until the PUT completes. */
+  apr_pool_t *put_pool;
+
 } file_context_t;
 
+/* A PUT request running in the background. */
+typedef struct put_context_t {
+  /* Pool holding this structure, the request and its body. */
+  apr_pool_t *pool;
+
+  /* Copy of the file this PUT is for, allocated in POOL. */
+  file_context_t *file;
+
+  svn_ra_serf__handler_t *handler;
+
+  /* The HTTP status that indicates success. */
+  int expected_result;
+
+  struct put_context_t *next;
+} put_context_t;
+
 
 /* Setup routines and handlers for various requests we'll invoke. */
 
@@ -873,6 +900,139 @@ proppatch_resource(svn_ra_serf__session_t *session,
   return svn_error_trace(err);
 }
 
+/* Implements svn_ra_serf__response_done_delegate_t for PUT requests
+   queued by queue_put(). */
+static svn_error_t *
+put_done(serf_request_t *request,
+         void *baton,
+         apr_pool_t *scratch_pool)
+{
+  put_context_t *put = baton;
+  svn_ra_serf__handler_t *handler = put->handler;
+
+  if (handler->server_error)
+    return svn_ra_serf__server_error_create(handler, scratch_pool);
+
+  if (handler->sline.code != put->expected_result)
+    return svn_error_trace(svn_ra_serf__unexpected_status(handler));
+
+  return SVN_NO_ERROR;
+}
+
+/* Release the completed PUT requests of CTX and return the number of
+   requests still in flight. */
+static int
+reap_puts(commit_context_t *ctx,
+          apr_pool_t *scratch_pool)
+{
+  put_context_t **link = &ctx->puts;
+  int pending = 0;
+
+  while (*link)
+    {
+      put_context_t *put = *link;
+
+      if (put->handler->done)
+        {
+          *link = put->next;
+          if (put->file->svndiff)
+            svn_error_clear(svn_ra_serf__request_body_cleanup(
+                              put->file->svndiff, scratch_pool));
+          svn_pool_destroy(put->pool);
+        }
+      else
+        {
+          pending++;
+          link = &put->next;
+        }
+    }
+
+  return pending;
+}
+
+/* Run the serf context of CTX until PUT (if not NULL) has completed and
+   no more than MAX_PENDING requests queued by queue_put() are in flight.
+   Errors of the PUTs completed meanwhile are returned by the context run. */
+static svn_error_t *
+wait_for_puts(commit_context_t *ctx,
+              put_context_t *put,
+              int max_pending,
+              apr_pool_t *scratch_pool)
+{
+  apr_interval_time_t waittime_left = ctx->session->timeout;
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+
+  while ((put && !put->handler->done)
+         || reap_puts(ctx, iterpool) > max_pending)
+    {
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_ra_serf__context_run(ctx->session, &waittime_left,
+                                       iterpool));
+    }
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Queue the PUT request HANDLER with body baton BODY_BATON for FILE.
+   FILE->PUT_POOL must be the pool of HANDLER.  Spread the requests over
+   the connections after the first one (which serves the requests that
+   the commit waits for) and run them in the background while the editor
+   driver continues.  Set *PUT to the queued request. */
+static svn_error_t *
+queue_put(put_context_t **put,
+          file_context_t *file,
+          svn_ra_serf__handler_t *handler,
+          int expected_result,
+          apr_pool_t *scratch_pool)
+{
+  commit_context_t *ctx = file->commit_ctx;
+  svn_ra_serf__session_t *sess = ctx->session;
+  put_context_t *new_put;
+  int pending;
+
+  /* Throttle the number of requests (and buffered request bodies). */
+  SVN_ERR(wait_for_puts(ctx, NULL, MAX_PENDING_PUTS - 1, scratch_pool));
+  pending = reap_puts(ctx, scratch_pool);
+
+  /* A single http/2 connection multiplexes any number of requests. */
+  if (!sess->http20
+      && sess->num_conns < sess->max_connections
+      && pending >= sess->num_conns - 1)
+    SVN_ERR(svn_ra_serf__open_connection(sess));
+
+  if (sess->num_conns > 1)
+    handler->conn = sess->conns[1 + ctx->put_count % (sess->num_conns - 1)];
+  ctx->put_count++;
+
+  /* The file baton and its pool may be gone before the request is sent. */
+  new_put = apr_pcalloc(file->put_pool, sizeof(*new_put));
+  new_put->pool = file->put_pool;
+  new_put->file = apr_pmemdup(new_put->pool, file, sizeof(*file));
+  new_put->file->pool = new_put->pool;
+  new_put->file->relpath = apr_pstrdup(new_put->pool, file->relpath);
+  new_put->file->url = apr_pstrdup(new_put->pool, file->url);
+  new_put->file->base_checksum = apr_pstrdup(new_put->pool,
+                                             file->base_checksum);
+  new_put->file->result_checksum = apr_pstrdup(new_put->pool,
+                                               file->result_checksum);
+  new_put->file->prop_changes = NULL;
+  new_put->handler = handler;
+  new_put->expected_result = expected_result;
+
+  handler->header_delegate_baton = new_put->file;
+  handler->done_delegate = put_done;
+  handler->done_delegate_baton = new_put;
+
+  new_put->next = ctx->puts;
+  ctx->puts = new_put;
+
+  svn_ra_serf__request_create(handler);
+
+  *put = new_put;
+  return SVN_NO_ERROR;
+}
+
 /* Implements svn_ra_serf__request_body_delegate_t */
 static svn_error_t *
 create_empty_put_body(serf_bucket_t **body_bkt,
@@ -1886,6 +2046,8 @@ negotiate_put_encoding(int *svndiff_version_p,
       if (session->supports_svndiff2 &&
           svn_ra_serf__is_low_latency_connection(session))
         svndiff_version = 2;
+      else if (session->supports_svndiff3)
+        svndiff_version = 3;
       else if (session->supports_svndiff1)
         svndiff_version = 1;
       else if (session->supports_svndiff2)
@@ -1898,12 +2060,15 @@ negotiate_put_encoding(int *svndiff_version_p,
       /* Otherwise, prefer svndiff1, as svndiff2 is not a reasonable
        * substitute for svndiff1 with default compression level.  (It gives
        * better speed and compression ratio comparable to svndiff1 with
-       * compression level 1, but not 5).
+       * compression level 1, but not 5).  Svndiff3 compresses like svndiff1
+       * but encodes instructions more compactly, so use it if we can.
        *
        * Note: For future compatibility, we also handle a theoretically
        * possible case where the server has advertised only svndiff2 support.
        */
-      if (session->supports_svndiff1)
+      if (session->supports_svndiff3)
+        svndiff_version = 3;
+      else if (session->supports_svndiff1)
         svndiff_version = 1;
       else if (session->supports_svndiff2)
         svndiff_version = 2;
@@ -1956,9 +2121,10 @@ apply_textdelta(void *file_baton,
    * in response to a PUT" capability, and only if the editor driver uses the
    * new callback.
    */
+  ctx->put_pool = svn_pool_create(ctx->commit_ctx->pool);
   ctx->svndiff =
     svn_ra_serf__request_body_create(SVN_RA_SERF__REQUEST_BODY_IN_MEM_SIZE,
-                                     ctx->pool);
+                                     ctx->put_pool);
   ctx->stream = svn_ra_serf__request_body_get_stream(ctx->svndiff);
 
   negotiate_put_encoding(&svndiff_version, &compression_level,
@@ -2153,10 +2319,14 @@ close_file(void *file_baton,
   if ((ctx->svndiff || put_empty_file) && !ctx->svndiff_sent)
     {
       svn_ra_serf__handler_t *handler;
+      put_context_t *put;
       int expected_result;
 
+      if (!ctx->put_pool)
+        ctx->put_pool = svn_pool_create(ctx->commit_ctx->pool);
+
       handler = svn_ra_serf__create_handler(ctx->commit_ctx->session,
-                                            scratch_pool);
+                                            ctx->put_pool);
 
       handler->method = "PUT";
       handler->path = ctx->url;
@@ -2181,22 +2351,26 @@ close_file(void *file_baton,
         }
 
       handler->header_delegate = setup_put_headers;
-      handler->header_delegate_baton = ctx;
-
-      SVN_ERR(svn_ra_serf__context_run_one(handler, scratch_pool));
 
       if (ctx->added && ! ctx->copy_path)
         expected_result = 201; /* Created */
       else
         expected_result = 204; /* Updated */
 
-      if (handler->sline.code != expected_result)
-        return svn_error_trace(svn_ra_serf__unexpected_status(handler));
-    }
+      /* Let the PUT run in the background; close_edit() waits for it. */
+      SVN_ERR(queue_put(&put, ctx, handler, expected_result, scratch_pool));
 
-  /* Don't keep open file handles longer than necessary. */
-  if (ctx->svndiff)
-    SVN_ERR(svn_ra_serf__request_body_cleanup(ctx->svndiff, scratch_pool));
+      /* Requests on other connections are not ordered against the PUT,
+         so the PROPPATCH below has to wait for it. */
+      if (apr_hash_count(ctx->prop_changes))
+        SVN_ERR(wait_for_puts(ctx->commit_ctx, put, MAX_PENDING_PUTS,
+                              scratch_pool));
+    }
+  else if (ctx->svndiff)
+    {
+      /* Don't keep open file handles longer than necessary. */
+      SVN_ERR(svn_ra_serf__request_body_cleanup(ctx->svndiff, scratch_pool));
+    }
 
   /* If we had any prop changes, push them via PROPPATCH. */
   if (apr_hash_count(ctx->prop_changes))
@@ -2251,6 +2425,9 @@ close_edit(void *edit_baton,
               SVN_ERR_FS_INCORRECT_EDITOR_COMPLETION, NULL,
               _("Closing editor with directories or files open"));
 
+  /* All file contents must have arrived before the MERGE. */
+  SVN_ERR(wait_for_puts(ctx, NULL, 0, pool));
+
   /* MERGE our activity */
   SVN_ERR(svn_ra_serf__run_merge(&commit_info,
                                  ctx->session,
@@ -2305,6 +2482,16 @@ abort_edit(void *edit_baton,
   if (! (ctx->activity_url || ctx->txn_url))
     return SVN_NO_ERROR;
 
+  /* Cancel the PUTs still in flight; destroying their pools resets
+     their connections. */
+  while (ctx->puts)
+    {
+      put_context_t *put = ctx->puts;
+
+      ctx->puts = put->next;
+      svn_pool_destroy(put->pool);
+    }
+
   /* An error occurred on conns[0]. serf 0.4.0 remembers that the connection
      had a problem. We need to reset it, in order to use it again.  */
   serf_connection_reset(ctx->session->conns[0]->conn);
@@ -2427,6 +2614,32 @@ svn_ra_serf__get_commit_editor(svn_ra_session_t *ra_session,
   return SVN_NO_ERROR;
 }
 
+/* Set *TARGET to the URL of the resource that holds the revision
+   properties of REV in SESSION, allocated in POOL. */
+static svn_error_t *
+get_revprop_target(const char **target,
+                   svn_ra_serf__session_t *session,
+                   svn_revnum_t rev,
+                   apr_pool_t *pool)
+{
+  if (SVN_RA_SERF__HAVE_HTTPV2_SUPPORT(session))
+    {
+      *target = apr_psprintf(pool, "%s/%ld", session->rev_stub, rev);
+    }
+  else
+    {
+      const char *vcc_url;
+
+      SVN_ERR(svn_ra_serf__discover_vcc(&vcc_url, session, pool));
+
+      SVN_ERR(svn_ra_serf__fetch_dav_prop(target,
+                                          session, vcc_url, rev, "href",
+                                          pool, pool));
+    }
+
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *
 svn_ra_serf__change_rev_prop(svn_ra_session_t *ra_session,
                              svn_revnum_t rev,
@@ -2475,20 +2688,7 @@ svn_ra_serf__change_rev_prop(svn_ra_session_t *ra_session,
       old_value_p = &tmp_old_value;
     }
 
-  if (SVN_RA_SERF__HAVE_HTTPV2_SUPPORT(session))
-    {
-      proppatch_target = apr_psprintf(pool, "%s/%ld", session->rev_stub, rev);
-    }
-  else
-    {
-      const char *vcc_url;
-
-      SVN_ERR(svn_ra_serf__discover_vcc(&vcc_url, session, pool));
-
-      SVN_ERR(svn_ra_serf__fetch_dav_prop(&proppatch_target,
-                                          session, vcc_url, rev, "href",
-                                          pool, pool));
-    }
+  SVN_ERR(get_revprop_target(&proppatch_target, session, rev, pool));
 
   /* PROPPATCH our log message and pass it along.  */
   proppatch_ctx = apr_pcalloc(pool, sizeof(*proppatch_ctx));
@@ -2532,3 +2732,47 @@ svn_ra_serf__change_rev_prop(svn_ra_session_t *ra_session,
 
   return svn_error_trace(err);
 }
+
+svn_error_t *
+svn_ra_serf__change_rev_props(svn_ra_session_t *ra_session,
+                              svn_revnum_t rev,
+                              const apr_array_header_t *changes,
+                              apr_pool_t *scratch_pool)
+{
+  svn_ra_serf__session_t *session = ra_session->priv;
+  proppatch_context_t *proppatch_ctx;
+  apr_pool_t *iterpool;
+  int i;
+
+  proppatch_ctx = apr_pcalloc(scratch_pool, sizeof(*proppatch_ctx));
+  proppatch_ctx->pool = scratch_pool;
+  proppatch_ctx->commit_ctx = NULL; /* No lock headers */
+  proppatch_ctx->prop_changes = apr_hash_make(scratch_pool);
+  proppatch_ctx->base_revision = SVN_INVALID_REVNUM;
+
+  /* Deletions go through svn_ra_serf__change_rev_prop(), which knows how
+     to detect their failure.  All other changes share one PROPPATCH. */
+  iterpool = svn_pool_create(scratch_pool);
+  for (i = 0; i < changes->nelts; i++)
+    {
+      const svn_prop_t *prop = &APR_ARRAY_IDX(changes, i, svn_prop_t);
+
+      svn_pool_clear(iterpool);
+
+      if (prop->value)
+        svn_hash_sets(proppatch_ctx->prop_changes, prop->name, prop);
+      else
+        SVN_ERR(svn_ra_serf__change_rev_prop(ra_session, rev, prop->name,
+                                             NULL, NULL, iterpool));
+    }
+  svn_pool_destroy(iterpool);
+
+  if (apr_hash_count(proppatch_ctx->prop_changes) == 0)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(get_revprop_target(&proppatch_ctx->path, session, rev,
+                             scratch_pool));
+
+  return svn_error_trace(proppatch_resource(session, proppatch_ctx,
+                                            scratch_pool));
+}
@@ -53,6 +53,7 @@ typedef struct list_context_t {
   svn_revnum_t revision;
   const apr_array_header_t *patterns;
   svn_depth_t depth;
+  svn_revnum_t since_rev;
   apr_uint32_t dirent_fields;
   apr_array_header_t *props;
 
@@ -193,6 +194,11 @@ create_list_body(serf_bucket_t **body_bkt,
   svn_ra_serf__add_tag_buckets(buckets,
                                "S:depth", svn_depth_to_word(list_ctx->depth),
                                alloc);
+  if (SVN_IS_VALID_REVNUM(list_ctx->since_rev))
+    svn_ra_serf__add_tag_buckets(buckets,
+                                 "S:since-revision",
+                                 apr_ltoa(pool, list_ctx->since_rev),
+                                 alloc);
 
   if (list_ctx->patterns)
     {
@@ -234,6 +240,7 @@ svn_ra_serf__list(svn_ra_session_t *ra_session,
                   svn_revnum_t revision,
                   const apr_array_header_t *patterns,
                   svn_depth_t depth,
+                  svn_revnum_t since_rev,
                   apr_uint32_t dirent_fields,
                   svn_ra_dirent_receiver_t receiver,
                   void *receiver_baton,
@@ -253,6 +260,7 @@ svn_ra_serf__list(svn_ra_session_t *ra_session,
   list_ctx->revision = revision;
   list_ctx->patterns = patterns;
   list_ctx->depth = depth;
+  list_ctx->since_rev = since_rev;
   list_ctx->dirent_fields = dirent_fields;
   list_ctx->props = svn_ra_serf__get_dirent_props(dirent_fields, session,
                                                   scratch_pool);
@@ -34,10 +34,13 @@
 
 #include "../libsvn_ra/ra_loader.h"
 #include "svn_config.h"
+#include "svn_dirent_uri.h"
 #include "svn_path.h"
 #include "svn_sorts.h"
 #include "svn_time.h"
 #include "svn_private_config.h"
+#include "private/svn_fspath.h"
+#include "private/svn_skel.h"
 #include "private/svn_sorts_private.h"
 
 #include "ra_serf.h"
@@ -440,6 +443,384 @@ create_lock_body(serf_bucket_t **body_bkt,
   return SVN_NO_ERROR;
 }
 
+/* Context of a lock-many or unlock-many POST request. */
+typedef struct lock_many_ctx_t
+{
+  svn_ra_serf__handler_t *handler;
+
+  /* The serialized request skel. */
+  svn_stringbuf_t *request;
+
+  /* The response body received so far. */
+  svn_stringbuf_t *response;
+} lock_many_ctx_t;
+
+/* Implements svn_ra_serf__request_body_delegate_t */
+static svn_error_t *
+create_lock_many_body(serf_bucket_t **body_bkt,
+                      void *baton,
+                      serf_bucket_alloc_t *alloc,
+                      apr_pool_t *pool /* request pool */,
+                      apr_pool_t *scratch_pool)
+{
+  lock_many_ctx_t *ctx = baton;
+
+  *body_bkt = SERF_BUCKET_SIMPLE_STRING_LEN(ctx->request->data,
+                                            ctx->request->len, alloc);
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_ra_serf__response_handler_t */
+static svn_error_t *
+handle_lock_many(serf_request_t *request,
+                 serf_bucket_t *response,
+                 void *handler_baton,
+                 apr_pool_t *pool)
+{
+  lock_many_ctx_t *ctx = handler_baton;
+
+  /* Let the generic code parse any error response. */
+  if (ctx->handler->sline.code != 200)
+    return svn_error_trace(svn_ra_serf__expect_empty_body(request, response,
+                                                          ctx->handler,
+                                                          pool));
+
+  while (1)
+    {
+      const char *data;
+      apr_size_t len;
+      apr_status_t status;
+
+      status = serf_bucket_read(response, 8000, &data, &len);
+      if (SERF_BUCKET_READ_ERROR(status))
+        return svn_ra_serf__wrap_err(status, NULL);
+
+      svn_stringbuf_appendbytes(ctx->response, data, len);
+
+      /* Also returns on APR_EOF and APR_EAGAIN. */
+      if (status)
+        return svn_ra_serf__wrap_err(status, NULL);
+    }
+}
+
+/* Return the repository-relative FS path for PATH, which is relative to
+ * the URL of SESSION.  Allocate the result in RESULT_POOL. */
+static svn_error_t *
+get_lock_many_fspath(const char **fspath,
+                     svn_ra_serf__session_t *session,
+                     const char *path,
+                     apr_pool_t *result_pool)
+{
+  const char *rel_path;
+
+  SVN_ERR(svn_ra_serf__get_relative_path(&rel_path,
+                                         session->session_url.path,
+                                         session, result_pool));
+  *fspath = svn_fspath__join("/", svn_relpath_join(rel_path, path,
+                                                   result_pool),
+                             result_pool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Return a "malformed response" error. */
+static svn_error_t *
+malformed_lock_many_response(void)
+{
+  return svn_error_create(SVN_ERR_RA_DAV_MALFORMED_DATA, NULL,
+                          _("Malformed lock-many response"));
+}
+
+/* Parse the optional string SKEL, i.e. "( )" or "( STR )", and return
+ * its contents in *STR, allocated in RESULT_POOL.  The empty list gives
+ * NULL. */
+static svn_error_t *
+parse_optional_str(const char **str,
+                   const svn_skel_t *skel,
+                   apr_pool_t *result_pool)
+{
+  int len = svn_skel__list_length(skel);
+
+  if (len == 0)
+    {
+      *str = NULL;
+      return SVN_NO_ERROR;
+    }
+
+  if (len != 1 || !skel->children->is_atom)
+    return svn_error_trace(malformed_lock_many_response());
+
+  *str = apr_pstrmemdup(result_pool, skel->children->data,
+                        skel->children->len);
+  return SVN_NO_ERROR;
+}
+
+/* Parse the lock description LOCK_SKEL returned for PATH into *LOCK,
+ * allocated in RESULT_POOL.  See mod_dav_svn/posts/lock_many.c for the
+ * format. */
+static svn_error_t *
+parse_lock_many_lock(svn_lock_t **lock,
+                     const char *path,
+                     const svn_skel_t *lock_skel,
+                     apr_pool_t *result_pool)
+{
+  const svn_skel_t *token_skel, *owner_skel, *comment_skel;
+  const svn_skel_t *creation_skel, *expiration_skel;
+  const char *expiration;
+
+  if (svn_skel__list_length(lock_skel) != 5)
+    return svn_error_trace(malformed_lock_many_response());
+
+  token_skel = lock_skel->children;
+  owner_skel = token_skel->next;
+  comment_skel = owner_skel->next;
+  creation_skel = comment_skel->next;
+  expiration_skel = creation_skel->next;
+
+  if (!token_skel->is_atom || !owner_skel->is_atom
+      || !creation_skel->is_atom)
+    return svn_error_trace(malformed_lock_many_response());
+
+  *lock = svn_lock_create(result_pool);
+  (*lock)->path = path;
+  (*lock)->token = apr_pstrmemdup(result_pool, token_skel->data,
+                                  token_skel->len);
+  (*lock)->owner = apr_pstrmemdup(result_pool, owner_skel->data,
+                                  owner_skel->len);
+  SVN_ERR(parse_optional_str(&(*lock)->comment, comment_skel, result_pool));
+  SVN_ERR(svn_time_from_cstring(&(*lock)->creation_date,
+                                apr_pstrmemdup(result_pool,
+                                               creation_skel->data,
+                                               creation_skel->len),
+                                result_pool));
+
+  SVN_ERR(parse_optional_str(&expiration, expiration_skel, result_pool));
+  if (expiration)
+    SVN_ERR(svn_time_from_cstring(&(*lock)->expiration_date, expiration,
+                                  result_pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Send REQUEST_SKEL as a lock-many (if LOCKING is set) or unlock-many
+ * POST through SESSION and invoke LOCK_FUNC with LOCK_BATON for each of
+ * the PATHS, which have been sent in that order.  Use SCRATCH_POOL for
+ * temporary allocations. */
+static svn_error_t *
+run_lock_many(svn_ra_serf__session_t *session,
+              const svn_skel_t *request_skel,
+              const apr_array_header_t *paths,
+              svn_boolean_t locking,
+              svn_ra_lock_callback_t lock_func,
+              void *lock_baton,
+              apr_pool_t *scratch_pool)
+{
+  lock_many_ctx_t *ctx = apr_pcalloc(scratch_pool, sizeof(*ctx));
+  svn_ra_serf__handler_t *handler;
+  const svn_skel_t *response_skel;
+  const svn_skel_t *result;
+  apr_pool_t *iterpool;
+  int i;
+
+  ctx->request = svn_skel__unparse(request_skel, scratch_pool);
+  ctx->response = svn_stringbuf_create_empty(scratch_pool);
+
+  handler = svn_ra_serf__create_handler(session, scratch_pool);
+  handler->method = "POST";
+  handler->path = session->me_resource;
+  handler->body_type = SVN_SKEL_MIME_TYPE;
+  handler->body_delegate = create_lock_many_body;
+  handler->body_delegate_baton = ctx;
+  handler->response_handler = handle_lock_many;
+  handler->response_baton = ctx;
+  ctx->handler = handler;
+
+  SVN_ERR(svn_ra_serf__context_run_one(handler, scratch_pool));
+
+  if (handler->sline.code != 200)
+    return svn_error_trace(svn_ra_serf__unexpected_status(handler));
+
+  response_skel = svn_skel__parse(ctx->response->data, ctx->response->len,
+                                  scratch_pool);
+  if (svn_skel__list_length(response_skel) != paths->nelts)
+    return svn_error_trace(malformed_lock_many_response());
+
+  /* The server reports the results in request order. */
+  iterpool = svn_pool_create(scratch_pool);
+  for (i = 0, result = response_skel->children;
+       i < paths->nelts;
+       ++i, result = result->next)
+    {
+      const char *path = APR_ARRAY_IDX(paths, i, const char *);
+      const svn_skel_t *status_skel;
+      svn_lock_t *lock = NULL;
+      svn_error_t *err = SVN_NO_ERROR;
+      svn_error_t *cb_err = SVN_NO_ERROR;
+
+      svn_pool_clear(iterpool);
+
+      if (svn_skel__list_length(result) < 2)
+        return svn_error_trace(malformed_lock_many_response());
+
+      status_skel = result->children->next;
+      if (svn_skel__matches_atom(status_skel, "success"))
+        {
+          if (locking)
+            {
+              if (!status_skel->next)
+                return svn_error_trace(malformed_lock_many_response());
+
+              SVN_ERR(parse_lock_many_lock(&lock, path, status_skel->next,
+                                           iterpool));
+            }
+        }
+      else if (svn_skel__matches_atom(status_skel, "failure"))
+        {
+          const svn_skel_t *error_skel = status_skel->next;
+          apr_int64_t apr_err;
+
+          if (svn_skel__list_length(error_skel) != 2
+              || !error_skel->children->next->is_atom)
+            return svn_error_trace(malformed_lock_many_response());
+
+          SVN_ERR(svn_skel__parse_int(&apr_err, error_skel->children,
+                                      iterpool));
+          err = svn_error_create((apr_status_t)apr_err, NULL,
+                                 apr_pstrmemdup(iterpool,
+                                       error_skel->children->next->data,
+                                       error_skel->children->next->len));
+        }
+      else
+        return svn_error_trace(malformed_lock_many_response());
+
+      if (lock_func)
+        cb_err = lock_func(lock_baton, path, locking, lock, err, iterpool);
+      svn_error_clear(err);
+
+      SVN_ERR(cb_err);
+    }
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Return TRUE if the server behind SESSION supports the POST named
+ * POST_NAME. */
+static svn_boolean_t
+supports_post(svn_ra_serf__session_t *session,
+              const char *post_name)
+{
+  return SVN_RA_SERF__HAVE_HTTPV2_SUPPORT(session)
+      && session->supported_posts
+      && svn_hash_gets(session->supported_posts, post_name);
+}
+
+/* Implement svn_ra_serf__lock() using a single lock-many POST against
+ * SESSION. */
+static svn_error_t *
+lock_many(svn_ra_serf__session_t *session,
+          apr_hash_t *path_revs,
+          const char *comment,
+          svn_boolean_t force,
+          svn_ra_lock_callback_t lock_func,
+          void *lock_baton,
+          apr_pool_t *scratch_pool)
+{
+  svn_skel_t *request_skel = svn_skel__make_empty_list(scratch_pool);
+  svn_skel_t *targets_skel = svn_skel__make_empty_list(scratch_pool);
+  svn_skel_t *comment_skel = svn_skel__make_empty_list(scratch_pool);
+  apr_array_header_t *paths;
+  apr_hash_index_t *hi;
+
+  paths = apr_array_make(scratch_pool, apr_hash_count(path_revs),
+                         sizeof(const char *));
+
+  for (hi = apr_hash_first(scratch_pool, path_revs);
+       hi;
+       hi = apr_hash_next(hi))
+    {
+      const char *path = apr_hash_this_key(hi);
+      svn_revnum_t revision = *((svn_revnum_t*)apr_hash_this_val(hi));
+      svn_skel_t *target_skel = svn_skel__make_empty_list(scratch_pool);
+      const char *fspath;
+
+      SVN_ERR(get_lock_many_fspath(&fspath, session, path, scratch_pool));
+
+      svn_skel__prepend_int(SVN_IS_VALID_REVNUM(revision) ? revision : -1,
+                            target_skel, scratch_pool);
+      svn_skel__prepend_str(fspath, target_skel, scratch_pool);
+      svn_skel__prepend(target_skel, targets_skel);
+
+      APR_ARRAY_PUSH(paths, const char *) = path;
+    }
+
+  /* Prepending reversed the order of the targets. */
+  svn_sort__array_reverse(paths, scratch_pool);
+
+  if (comment)
+    svn_skel__prepend_str(comment, comment_skel, scratch_pool);
+
+  svn_skel__prepend(targets_skel, request_skel);
+  svn_skel__prepend_int(force ? 1 : 0, request_skel, scratch_pool);
+  svn_skel__prepend(comment_skel, request_skel);
+  svn_skel__prepend_str("lock-many", request_skel, scratch_pool);
+
+  return svn_error_trace(run_lock_many(session, request_skel, paths, TRUE,
+                                       lock_func, lock_baton, scratch_pool));
+}
+
+/* Implement svn_ra_serf__unlock() using a single unlock-many POST against
+ * SESSION. */
+static svn_error_t *
+unlock_many(svn_ra_serf__session_t *session,
+            apr_hash_t *path_tokens,
+            svn_boolean_t force,
+            svn_ra_lock_callback_t lock_func,
+            void *lock_baton,
+            apr_pool_t *scratch_pool)
+{
+  svn_skel_t *request_skel = svn_skel__make_empty_list(scratch_pool);
+  svn_skel_t *targets_skel = svn_skel__make_empty_list(scratch_pool);
+  apr_array_header_t *paths;
+  apr_hash_index_t *hi;
+
+  paths = apr_array_make(scratch_pool, apr_hash_count(path_tokens),
+                         sizeof(const char *));
+
+  for (hi = apr_hash_first(scratch_pool, path_tokens);
+       hi;
+       hi = apr_hash_next(hi))
+    {
+      const char *path = apr_hash_this_key(hi);
+      const char *token = apr_hash_this_val(hi);
+      svn_skel_t *target_skel = svn_skel__make_empty_list(scratch_pool);
+      svn_skel_t *token_skel = svn_skel__make_empty_list(scratch_pool);
+      const char *fspath;
+
+      SVN_ERR(get_lock_many_fspath(&fspath, session, path, scratch_pool));
+
+      /* When breaking locks, the server does not need the token. */
+      if (token && token[0])
+        svn_skel__prepend_str(token, token_skel, scratch_pool);
+
+      svn_skel__prepend(token_skel, target_skel);
+      svn_skel__prepend_str(fspath, target_skel, scratch_pool);
+      svn_skel__prepend(target_skel, targets_skel);
+
+      APR_ARRAY_PUSH(paths, const char *) = path;
+    }
+
+  /* Prepending reversed the order of the targets. */
+  svn_sort__array_reverse(paths, scratch_pool);
+
+  svn_skel__prepend(targets_skel, request_skel);
+  svn_skel__prepend_int(force ? 1 : 0, request_skel, scratch_pool);
+  svn_skel__prepend_str("unlock-many", request_skel, scratch_pool);
+
+  return svn_error_trace(run_lock_many(session, request_skel, paths, FALSE,
+                                       lock_func, lock_baton, scratch_pool));
+}
+
 svn_error_t *
 svn_ra_serf__lock(svn_ra_session_t *ra_session,
                   apr_hash_t *path_revs,
@@ -454,6 +835,11 @@ svn_ra_serf__lock(svn_ra_session_t *ra_session,
   apr_pool_t *iterpool;
   apr_array_header_t *lock_requests;
 
+  /* Newer servers can lock all paths with a single request. */
+  if (supports_post(session, "lock-many"))
+    return svn_error_trace(lock_many(session, path_revs, comment, force,
+                                     lock_func, lock_baton, scratch_pool));
+
   lock_requests = apr_array_make(scratch_pool, apr_hash_count(path_revs),
                                  sizeof(lock_ctx_t*));
 
@@ -564,6 +950,12 @@ svn_ra_serf__unlock(svn_ra_session_t *ra_session,
   apr_pool_t *iterpool;
   apr_array_header_t *lock_requests;
 
+  /* Newer servers can unlock all paths with a single request.  They also
+     don't need the lock tokens when breaking locks. */
+  if (supports_post(session, "unlock-many"))
+    return svn_error_trace(unlock_many(session, path_tokens, force,
+                                       lock_func, lock_baton, scratch_pool));
+
   iterpool = svn_pool_create(scratch_pool);
 
   /* If we are stealing locks we need the lock tokens */
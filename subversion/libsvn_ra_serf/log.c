@@ -38,6 +38,7 @@
 #include "svn_props.h"
 
 #include "private/svn_dav_protocol.h"
+#include "private/svn_skel.h"
 #include "private/svn_string_private.h"
 #include "private/svn_subr_private.h"
 #include "svn_private_config.h"
@@ -96,6 +97,16 @@ typedef struct log_context_t {
   svn_boolean_t want_author;
   svn_boolean_t want_date;
   svn_boolean_t want_message;
+
+  /* Binary reports (see SVN_DAV_NS_DAV_SVN_BINARY_LOG) only: the request
+     handler, unprocessed response data, the pool for COLLECT_PATHS and
+     the revprops of the current revision and whether we got the final
+     record. */
+  svn_boolean_t binary;
+  svn_ra_serf__handler_t *handler;
+  svn_stringbuf_t *buffer;
+  apr_pool_t *item_pool;
+  svn_boolean_t done;
 } log_context_t;
 
 #define D_ "DAV:"
@@ -234,6 +245,38 @@ collect_path(apr_hash_t *paths,
 }
 
 
+/* Pass LOG_ENTRY to the receiver of LOG_CTX unless we already reached
+   the limit, and keep track of the merged revisions nesting.  */
+static svn_error_t *
+deliver_log_entry(log_context_t *log_ctx,
+                  svn_log_entry_t *log_entry,
+                  apr_pool_t *scratch_pool)
+{
+  if ((log_ctx->limit > 0) && (log_ctx->nest_level == 0)
+      && (++log_ctx->count > log_ctx->limit))
+    {
+      return SVN_NO_ERROR;
+    }
+
+  /* Give the info to the reporter */
+  SVN_ERR(log_ctx->receiver(log_ctx->receiver_baton,
+                            log_entry,
+                            scratch_pool));
+
+  if (log_entry->has_children)
+    {
+      log_ctx->nest_level++;
+    }
+  if (! SVN_IS_VALID_REVNUM(log_entry->revision))
+    {
+      SVN_ERR_ASSERT(log_ctx->nest_level);
+      log_ctx->nest_level--;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+
 /* Conforms to svn_ra_serf__xml_opened_t  */
 static svn_error_t *
 log_opened(svn_ra_serf__xml_estate_t *xes,
@@ -272,12 +315,6 @@ log_closed(svn_ra_serf__xml_estate_t *xes,
       svn_log_entry_t *log_entry;
       const char *rev_str;
 
-      if ((log_ctx->limit > 0) && (log_ctx->nest_level == 0)
-          && (++log_ctx->count > log_ctx->limit))
-        {
-          return SVN_NO_ERROR;
-        }
-
       log_entry = svn_log_entry_create(scratch_pool);
 
       /* Pick up the paths from the context. These have the same lifetime
@@ -310,20 +347,7 @@ log_closed(svn_ra_serf__xml_estate_t *xes,
       else
         log_entry->revision = SVN_INVALID_REVNUM;
 
-      /* Give the info to the reporter */
-      SVN_ERR(log_ctx->receiver(log_ctx->receiver_baton,
-                                log_entry,
-                                scratch_pool));
-
-      if (log_entry->has_children)
-        {
-          log_ctx->nest_level++;
-        }
-      if (! SVN_IS_VALID_REVNUM(log_entry->revision))
-        {
-          SVN_ERR_ASSERT(log_ctx->nest_level);
-          log_ctx->nest_level--;
-        }
+      SVN_ERR(deliver_log_entry(log_ctx, log_entry, scratch_pool));
 
       /* These hash tables are going to be unusable once this state's
          pool is destroyed. But let's not leave stale pointers in
@@ -407,6 +431,262 @@ log_closed(svn_ra_serf__xml_estate_t *xes,
   return SVN_NO_ERROR;
 }
 
+/* Return the error for a malformed binary log report.  */
+static svn_error_t *
+malformed_record_error(void)
+{
+  return svn_error_create(SVN_ERR_RA_DAV_MALFORMED_DATA, NULL,
+                          _("Malformed record in binary log report"));
+}
+
+/* Set *STR to a copy of the atom SKEL, allocated in RESULT_POOL.  SKEL
+   may be NULL, which is an error just like SKEL being a list.  */
+static svn_error_t *
+dup_atom(const char **str,
+         const svn_skel_t *skel,
+         apr_pool_t *result_pool)
+{
+  if (skel == NULL || !skel->is_atom)
+    return svn_error_trace(malformed_record_error());
+
+  *str = apr_pstrmemdup(result_pool, skel->data, skel->len);
+  return SVN_NO_ERROR;
+}
+
+/* Record the changed path described by the "change" record SKEL in
+   LOG_CTX.  Use SCRATCH_POOL for temporary allocations.  */
+static svn_error_t *
+process_change_record(log_context_t *log_ctx,
+                      const svn_skel_t *skel,
+                      apr_pool_t *scratch_pool)
+{
+  /* The optional parts of the record, in that order. */
+  static const char *const attr_names[] = {
+    "node-kind", "text-mods", "prop-mods", "copyfrom-path", "copyfrom-rev",
+    NULL
+  };
+
+  apr_hash_t *attrs = apr_hash_make(scratch_pool);
+  const svn_skel_t *elt = skel->children->next;
+  const char *action;
+  svn_string_t path;
+  int i;
+
+  if (elt == NULL || !elt->is_atom)
+    return svn_error_trace(malformed_record_error());
+
+  path.data = elt->data;
+  path.len = elt->len;
+
+  elt = elt->next;
+  SVN_ERR(dup_atom(&action, elt, scratch_pool));
+  if (strlen(action) != 1 || !strchr("ADMR", *action))
+    return svn_error_trace(malformed_record_error());
+
+  for (i = 0, elt = elt->next; attr_names[i] && elt; ++i, elt = elt->next)
+    {
+      const char *value;
+
+      SVN_ERR(dup_atom(&value, elt, scratch_pool));
+      svn_hash_sets(attrs, attr_names[i], value);
+    }
+
+  return svn_error_trace(collect_path(log_ctx->collect_paths, *action,
+                                      &path, attrs));
+}
+
+/* Send the log entry described by the "log-item" record SKEL and the
+   changed paths collected before it to the receiver of LOG_CTX.  Use
+   SCRATCH_POOL for temporary allocations.  */
+static svn_error_t *
+process_log_item_record(log_context_t *log_ctx,
+                        const svn_skel_t *skel,
+                        apr_pool_t *scratch_pool)
+{
+  svn_log_entry_t *log_entry = svn_log_entry_create(scratch_pool);
+  const svn_skel_t *elt = skel->children->next;
+  const char *rev_str;
+  apr_int64_t rev;
+
+  SVN_ERR(dup_atom(&rev_str, elt, scratch_pool));
+  SVN_ERR(svn_cstring_atoi64(&rev, rev_str));
+  log_entry->revision = (svn_revnum_t)rev;
+
+  elt = elt->next;
+  if (elt == NULL || elt->is_atom)
+    return svn_error_trace(malformed_record_error());
+
+  SVN_ERR(svn_skel__parse_proplist(&log_entry->revprops, elt,
+                                   log_ctx->item_pool));
+
+  /* Drop the standard revprops that the caller did not ask for, just like
+     we do with XML reports. */
+  if (!log_ctx->want_author)
+    svn_hash_sets(log_entry->revprops, SVN_PROP_REVISION_AUTHOR, NULL);
+  if (!log_ctx->want_date)
+    svn_hash_sets(log_entry->revprops, SVN_PROP_REVISION_DATE, NULL);
+  if (!log_ctx->want_message)
+    svn_hash_sets(log_entry->revprops, SVN_PROP_REVISION_LOG, NULL);
+
+  for (elt = elt->next; elt; elt = elt->next)
+    {
+      if (svn_skel__matches_atom(elt, "has-children"))
+        log_entry->has_children = TRUE;
+      else if (svn_skel__matches_atom(elt, "subtractive-merge"))
+        log_entry->subtractive_merge = TRUE;
+    }
+
+  if (apr_hash_count(log_ctx->collect_paths) > 0)
+    {
+      log_entry->changed_paths = log_ctx->collect_paths;
+      log_entry->changed_paths2 = log_ctx->collect_paths;
+    }
+
+  SVN_ERR(deliver_log_entry(log_ctx, log_entry, scratch_pool));
+
+  /* Start over with the next revision. */
+  svn_pool_clear(log_ctx->item_pool);
+  log_ctx->collect_paths = apr_hash_make(log_ctx->item_pool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Return the error that the server reported in the "failure" record
+   SKEL.  Use SCRATCH_POOL for temporary allocations.  */
+static svn_error_t *
+process_failure_record(const svn_skel_t *skel,
+                       apr_pool_t *scratch_pool)
+{
+  const svn_skel_t *elt = skel->children->next;
+  const char *apr_err_str;
+  const char *message;
+  apr_int64_t apr_err;
+
+  SVN_ERR(dup_atom(&apr_err_str, elt, scratch_pool));
+  SVN_ERR(dup_atom(&message, elt->next, scratch_pool));
+  SVN_ERR(svn_cstring_atoi64(&apr_err, apr_err_str));
+
+  return svn_error_create((apr_status_t)apr_err, NULL, message);
+}
+
+/* Process all complete records in LOG_CTX->BUFFER and remove them from
+   it.  Use SCRATCH_POOL for temporary allocations.  */
+static svn_error_t *
+process_records(log_context_t *log_ctx,
+                apr_pool_t *scratch_pool)
+{
+  svn_stringbuf_t *buffer = log_ctx->buffer;
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  apr_size_t offset = 0;
+
+  while (offset < buffer->len && !log_ctx->done)
+    {
+      const char *start = buffer->data + offset;
+      const char *eol = memchr(start, '\n', buffer->len - offset);
+      apr_size_t header_len;
+      apr_uint64_t record_len;
+      svn_skel_t *skel;
+
+      svn_pool_clear(iterpool);
+
+      /* Wait for the rest of the record length. */
+      if (eol == NULL)
+        {
+          if (buffer->len - offset > SVN_INT64_BUFFER_SIZE)
+            return svn_error_trace(malformed_record_error());
+          break;
+        }
+
+      header_len = eol - start + 1;
+      SVN_ERR(svn_cstring_strtoui64(&record_len,
+                                    apr_pstrmemdup(iterpool, start,
+                                                   header_len - 1),
+                                    0, APR_SIZE_MAX, 10));
+
+      /* Wait for the rest of the record. */
+      if (record_len > buffer->len - offset - header_len)
+        break;
+
+      skel = svn_skel__parse(eol + 1, (apr_size_t)record_len, iterpool);
+      if (skel == NULL || skel->is_atom || skel->children == NULL
+          || !skel->children->is_atom)
+        return svn_error_trace(malformed_record_error());
+
+      if (svn_skel__matches_atom(skel->children, "change"))
+        SVN_ERR(process_change_record(log_ctx, skel, iterpool));
+      else if (svn_skel__matches_atom(skel->children, "log-item"))
+        SVN_ERR(process_log_item_record(log_ctx, skel, iterpool));
+      else if (svn_skel__matches_atom(skel->children, "failure"))
+        return svn_error_trace(process_failure_record(skel, iterpool));
+      else if (svn_skel__matches_atom(skel->children, "done"))
+        log_ctx->done = TRUE;
+      /* else unknown record; skip it */
+
+      offset += header_len + (apr_size_t)record_len;
+    }
+
+  svn_stringbuf_remove(buffer, 0, offset);
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_ra_serf__response_handler_t for binary log reports. */
+static svn_error_t *
+handle_binary_log(serf_request_t *request,
+                  serf_bucket_t *response,
+                  void *baton,
+                  apr_pool_t *scratch_pool)
+{
+  log_context_t *log_ctx = baton;
+  svn_ra_serf__handler_t *handler = log_ctx->handler;
+
+  if (handler->sline.code != 200)
+    return svn_error_trace(svn_ra_serf__expect_empty_body(request, response,
+                                                          handler,
+                                                          scratch_pool));
+
+  if (log_ctx->buffer == NULL)
+    {
+      serf_bucket_t *hdrs = serf_bucket_response_get_headers(response);
+      const char *val = serf_bucket_headers_get(hdrs, "Content-Type");
+
+      if (val == NULL
+          || strncmp(val, SVN_SKEL_MIME_TYPE,
+                     sizeof(SVN_SKEL_MIME_TYPE) - 1) != 0)
+        return svn_error_createf(SVN_ERR_RA_DAV_MALFORMED_DATA, NULL,
+                                 _("Unexpected content type '%s' of "
+                                   "binary log report"),
+                                 val ? val : "");
+
+      log_ctx->buffer = svn_stringbuf_create_empty(log_ctx->pool);
+    }
+
+  while (1)
+    {
+      apr_status_t status;
+      const char *data;
+      apr_size_t len;
+
+      status = serf_bucket_read(response, 8000, &data, &len);
+      if (SERF_BUCKET_READ_ERROR(status))
+        return svn_ra_serf__wrap_err(status, NULL);
+
+      svn_stringbuf_appendbytes(log_ctx->buffer, data, len);
+      SVN_ERR(process_records(log_ctx, scratch_pool));
+
+      /* Make sure we got the whole report. */
+      if (APR_STATUS_IS_EOF(status) && !log_ctx->done)
+        return svn_error_create(SVN_ERR_RA_DAV_MALFORMED_DATA, NULL,
+                                _("Unexpected end of binary log report"));
+
+      if (status)
+        return svn_ra_serf__wrap_err(status, NULL);
+    }
+
+  /* NOTREACHED */
+}
+
 /* Implements svn_ra_serf__request_body_delegate_t */
 static svn_error_t *
 create_log_body(serf_bucket_t **body_bkt,
@@ -498,6 +778,10 @@ create_log_body(serf_bucket_t **body_bkt,
   svn_ra_serf__add_empty_tag_buckets(buckets, alloc,
                                      "S:encode-binary-props", SVN_VA_NULL);
 
+  if (log_ctx->binary)
+    svn_ra_serf__add_empty_tag_buckets(buckets, alloc,
+                                       "S:binary-report", SVN_VA_NULL);
+
   svn_ra_serf__add_close_tag_buckets(buckets, alloc,
                                      "S:log-report");
 
@@ -584,11 +868,26 @@ svn_ra_serf__get_log(svn_ra_session_t *ra_session,
                                       NULL /* url */, peg_rev,
                                       pool, pool));
 
-  xmlctx = svn_ra_serf__xml_context_create(log_ttable,
-                                           log_opened, log_closed, NULL,
-                                           log_ctx,
-                                           pool);
-  handler = svn_ra_serf__create_expat_handler(session, xmlctx, NULL, pool);
+  if (session->supports_binary_log)
+    {
+      log_ctx->binary = TRUE;
+      log_ctx->item_pool = svn_pool_create(pool);
+      log_ctx->collect_paths = apr_hash_make(log_ctx->item_pool);
+
+      handler = svn_ra_serf__create_handler(session, pool);
+      handler->response_handler = handle_binary_log;
+      handler->response_baton = log_ctx;
+      log_ctx->handler = handler;
+    }
+  else
+    {
+      xmlctx = svn_ra_serf__xml_context_create(log_ttable,
+                                               log_opened, log_closed, NULL,
+                                               log_ctx,
+                                               pool);
+      handler = svn_ra_serf__create_expat_handler(session, xmlctx, NULL,
+                                                  pool);
+    }
 
   handler->method = "REPORT";
   handler->path = req_url;
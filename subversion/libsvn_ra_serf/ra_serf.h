@@ -42,6 +42,7 @@
 #include "private/svn_editor.h"
 
 #include "blncache.h"
+#include "../libsvn_ra/ra_loader.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -91,6 +92,14 @@ typedef struct svn_ra_serf__connection_t {
  */
 #define SVN_RA_SERF__MAX_CONNECTIONS_LIMIT 8
 
+/* Default for the "http-h2" option.  Builds for testing against serf
+ * trunk may switch it on by defining SVN__SERF_TEST_HTTP2. */
+#ifdef SVN__SERF_TEST_HTTP2
+#define SVN_RA_SERF__DEFAULT_NEGOTIATE_HTTP2 TRUE
+#else
+#define SVN_RA_SERF__DEFAULT_NEGOTIATE_HTTP2 FALSE
+#endif
+
 /*
  * The master serf RA session.
  *
@@ -144,6 +153,13 @@ struct svn_ra_serf__session_t {
      requests may come in any order */
   svn_boolean_t http20;
 
+  /* Should we offer http/2 via ALPN when connecting to https:// URLs? */
+  svn_boolean_t negotiate_http2;
+
+  /* Should the update editor adapt the number of outstanding requests to
+     the observed throughput and latency? */
+  svn_boolean_t adaptive_concurrency;
+
   /* Should we use Transfer-Encoding: chunked for HTTP/1.1 servers. */
   svn_boolean_t using_chunked_requests;
 
@@ -234,6 +250,8 @@ struct svn_ra_serf__session_t {
   const char *txn_root_stub;    /* for accessing TXN/PATH pairs */
   const char *vtxn_stub;        /* for accessing transactions (i.e. txnprops) */
   const char *vtxn_root_stub;   /* for accessing TXN/PATH pairs */
+  const char *text_stub;        /* for accessing texts by SHA-1; optional */
+  const char *delta_stub;       /* for accessing deltas by digests; optional */
 
   /* Hash mapping const char * server-supported POST types to
      disinteresting-but-non-null values. */
@@ -269,10 +287,17 @@ struct svn_ra_serf__session_t {
   /* Indicates whether the server can understand svndiff version 2. */
   svn_boolean_t supports_svndiff2;
 
+  /* Indicates whether the server can understand svndiff version 3. */
+  svn_boolean_t supports_svndiff3;
+
   /* Indicates whether the server sends the result checksum in the response
    * to a successful PUT request. */
   svn_boolean_t supports_put_result_checksum;
 
+  /* Indicates whether the server can send log reports in the binary
+   * encoding, see SVN_DAV_NS_DAV_SVN_BINARY_LOG. */
+  svn_boolean_t supports_binary_log;
+
   apr_interval_time_t conn_latency;
 };
 
@@ -715,6 +740,15 @@ svn_ra_serf__create_expat_handler(svn_ra_serf__session_t *session,
                                   const int *expected_status,
                                   apr_pool_t *result_pool);
 
+/* Feed the whole XML document in STREAM through XMLCTX and finish it with
+   svn_ra_serf__xml_context_done().  This is the parser part of the expat
+   handler without any HTTP processing, e.g. for benchmarks over captured
+   response bodies.  Use SCRATCH_POOL for temporary allocations.  */
+svn_error_t *
+svn_ra_serf__xml_parse_stream(svn_ra_serf__xml_context_t *xmlctx,
+                              svn_stream_t *stream,
+                              apr_pool_t *scratch_pool);
+
 
 /* Allocated within XES->STATE_POOL. Changes are not allowd (callers
    should make a deep copy if they need to make changes).
@@ -1438,11 +1472,39 @@ svn_ra_serf__list(svn_ra_session_t *ra_session,
                   svn_revnum_t revision,
                   const apr_array_header_t *patterns,
                   svn_depth_t depth,
+                  svn_revnum_t since_rev,
                   apr_uint32_t dirent_fields,
                   svn_ra_dirent_receiver_t receiver,
                   void *receiver_baton,
                   apr_pool_t *scratch_pool);
 
+/* Implements svn_ra__vtable_t.stat_many().  Returns
+   SVN_ERR_RA_NOT_IMPLEMENTED if FETCH_LOCKS is set. */
+svn_error_t *
+svn_ra_serf__stat_many(svn_ra_session_t *ra_session,
+                       const apr_array_header_t *paths,
+                       const apr_array_header_t *revisions,
+                       svn_boolean_t fetch_locks,
+                       svn_ra__stat_receiver_t receiver,
+                       void *receiver_baton,
+                       apr_pool_t *scratch_pool);
+
+/* Implements svn_ra__vtable_t.rev_proplist_range(). */
+svn_error_t *
+svn_ra_serf__rev_proplist_range(svn_ra_session_t *ra_session,
+                                svn_revnum_t start_rev,
+                                svn_revnum_t end_rev,
+                                svn_ra_rev_proplist_receiver_t receiver,
+                                void *receiver_baton,
+                                apr_pool_t *scratch_pool);
+
+/* Implements svn_ra__vtable_t.change_rev_props(). */
+svn_error_t *
+svn_ra_serf__change_rev_props(svn_ra_session_t *ra_session,
+                              svn_revnum_t rev,
+                              const apr_array_header_t *changes,
+                              apr_pool_t *scratch_pool);
+
 /* Request a mergeinfo-report from the URL attached to SESSION,
    and fill in the MERGEINFO hash with the results.
 
@@ -1546,6 +1608,12 @@ svn_ra_serf__error_on_status(serf_status_line sline,
 svn_error_t *
 svn_ra_serf__unexpected_status(svn_ra_serf__handler_t *handler);
 
+/* Open an additional connection to the server of SESS and append it to
+   SESS->CONNS.  The caller makes sure that SESS->MAX_CONNECTIONS is not
+   exceeded. */
+svn_error_t *
+svn_ra_serf__open_connection(svn_ra_serf__session_t *sess);
+
 /* Make sure handler is no longer scheduled on its connection. Resetting
    the connection if necessary */
 void
@@ -0,0 +1,220 @@
+/*
+ * rev_proplist_range.c :  entry point for the rev_proplist_range RA function
+ *                         in ra_serf
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include <serf.h>
+
+#include "svn_hash.h"
+#include "svn_base64.h"
+#include "svn_xml.h"
+
+#include "svn_private_config.h"
+
+#include "ra_serf.h"
+#include "../libsvn_ra/ra_loader.h"
+
+
+
+/*
+ * This enum represents the current state of our XML parsing for a REPORT.
+ */
+enum rev_proplist_range_state_e {
+  INITIAL = XML_STATE_INITIAL,
+  REPORT,
+  REVPROPS,
+  PROP
+};
+
+typedef struct rev_proplist_range_context_t {
+  /* parameters set by our caller */
+  svn_revnum_t start_rev;
+  svn_revnum_t end_rev;
+
+  /* The revision we expect to receive next. */
+  svn_revnum_t next_rev;
+
+  /* The properties of the current revision, and their pool. */
+  apr_hash_t *props;
+  apr_pool_t *props_pool;
+
+  /* receiver function and baton */
+  svn_ra_rev_proplist_receiver_t receiver;
+  void *receiver_baton;
+} rev_proplist_range_context_t;
+
+#define S_ SVN_XML_NAMESPACE
+static const svn_ra_serf__xml_transition_t rev_proplist_range_ttable[] = {
+  { INITIAL, S_, "rev-proplist-range-report", REPORT,
+    FALSE, { NULL }, FALSE },
+
+  { REPORT, S_, "revprops", REVPROPS,
+    FALSE, { "rev", NULL }, TRUE },
+
+  { REVPROPS, S_, "prop", PROP,
+    TRUE, { "name", "?encoding", NULL }, TRUE },
+
+  { 0 }
+};
+
+/* Conforms to svn_ra_serf__xml_closed_t  */
+static svn_error_t *
+revprops_closed(svn_ra_serf__xml_estate_t *xes,
+                void *baton,
+                int leaving_state,
+                const svn_string_t *cdata,
+                apr_hash_t *attrs,
+                apr_pool_t *scratch_pool)
+{
+  rev_proplist_range_context_t *ctx = baton;
+
+  if (leaving_state == PROP)
+    {
+      const char *encoding = svn_hash_gets(attrs, "encoding");
+      const char *name = svn_hash_gets(attrs, "name");
+
+      if (encoding)
+        {
+          if (strcmp(encoding, "base64") != 0)
+            {
+              return svn_error_createf(SVN_ERR_RA_DAV_MALFORMED_DATA, NULL,
+                                       _("Unsupported encoding '%s'"),
+                                       encoding);
+            }
+
+          cdata = svn_base64_decode_string(cdata, ctx->props_pool);
+        }
+      else
+        cdata = svn_string_dup(cdata, ctx->props_pool);
+
+      svn_hash_sets(ctx->props, apr_pstrdup(ctx->props_pool, name), cdata);
+    }
+  else if (leaving_state == REVPROPS)
+    {
+      svn_revnum_t revision;
+
+      /* The server sends the revisions in ascending order. */
+      SVN_ERR(svn_revnum_parse(&revision, svn_hash_gets(attrs, "rev"),
+                               NULL));
+      if (revision != ctx->next_rev || revision > ctx->end_rev)
+        return svn_error_create(SVN_ERR_RA_DAV_MALFORMED_DATA, NULL,
+                                _("Unexpected revision in "
+                                  "rev-proplist-range response"));
+
+      /* Invoke RECEIVER */
+      SVN_ERR(ctx->receiver(revision, ctx->props, ctx->receiver_baton,
+                            scratch_pool));
+
+      /* Reset buffered info. */
+      svn_pool_clear(ctx->props_pool);
+      ctx->props = apr_hash_make(ctx->props_pool);
+      ctx->next_rev++;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_ra_serf__request_body_delegate_t */
+static svn_error_t *
+create_rev_proplist_range_body(serf_bucket_t **body_bkt,
+                               void *baton,
+                               serf_bucket_alloc_t *alloc,
+                               apr_pool_t *pool /* request pool */,
+                               apr_pool_t *scratch_pool)
+{
+  serf_bucket_t *buckets;
+  rev_proplist_range_context_t *ctx = baton;
+
+  buckets = serf_bucket_aggregate_create(alloc);
+
+  svn_ra_serf__add_open_tag_buckets(buckets, alloc,
+                                    "S:rev-proplist-range-report",
+                                    "xmlns:S", SVN_XML_NAMESPACE,
+                                    SVN_VA_NULL);
+
+  svn_ra_serf__add_tag_buckets(buckets, "S:start-revision",
+                               apr_ltoa(pool, ctx->start_rev), alloc);
+  svn_ra_serf__add_tag_buckets(buckets, "S:end-revision",
+                               apr_ltoa(pool, ctx->end_rev), alloc);
+
+  svn_ra_serf__add_close_tag_buckets(buckets, alloc,
+                                     "S:rev-proplist-range-report");
+
+  *body_bkt = buckets;
+  return SVN_NO_ERROR;
+}
+
+
+svn_error_t *
+svn_ra_serf__rev_proplist_range(svn_ra_session_t *ra_session,
+                                svn_revnum_t start_rev,
+                                svn_revnum_t end_rev,
+                                svn_ra_rev_proplist_receiver_t receiver,
+                                void *receiver_baton,
+                                apr_pool_t *scratch_pool)
+{
+  rev_proplist_range_context_t *ctx;
+  svn_ra_serf__session_t *session = ra_session->priv;
+  svn_ra_serf__handler_t *handler;
+  svn_ra_serf__xml_context_t *xmlctx;
+  const char *report_target;
+
+  ctx = apr_pcalloc(scratch_pool, sizeof(*ctx));
+  ctx->start_rev = start_rev;
+  ctx->end_rev = end_rev;
+  ctx->next_rev = start_rev;
+  ctx->receiver = receiver;
+  ctx->receiver_baton = receiver_baton;
+  ctx->props_pool = svn_pool_create(scratch_pool);
+  ctx->props = apr_hash_make(ctx->props_pool);
+
+  /* The report is independent of the resource it is run against. */
+  SVN_ERR(svn_ra_serf__report_resource(&report_target, session,
+                                       scratch_pool));
+
+  xmlctx = svn_ra_serf__xml_context_create(rev_proplist_range_ttable,
+                                           NULL, revprops_closed, NULL,
+                                           ctx,
+                                           scratch_pool);
+  handler = svn_ra_serf__create_expat_handler(session, xmlctx, NULL,
+                                              scratch_pool);
+
+  handler->method = "REPORT";
+  handler->path = report_target;
+  handler->body_delegate = create_rev_proplist_range_body;
+  handler->body_delegate_baton = ctx;
+  handler->body_type = "text/xml";
+
+  SVN_ERR(svn_ra_serf__context_run_one(handler, scratch_pool));
+
+  if (handler->sline.code != 200)
+    SVN_ERR(svn_ra_serf__unexpected_status(handler));
+
+  if (ctx->next_rev != end_rev + 1)
+    return svn_error_create(SVN_ERR_RA_DAV_MALFORMED_DATA, NULL,
+                            _("Missing revisions in rev-proplist-range "
+                              "response"));
+
+  svn_pool_destroy(ctx->props_pool);
+
+  return SVN_NO_ERROR;
+}
@@ -251,6 +251,18 @@ load_config(svn_ra_serf__session_t *session,
                                   SVN_CONFIG_OPTION_HTTP_CHUNKED_REQUESTS,
                                   "auto", svn_tristate_unknown));
 
+  /* Should we try to talk http/2 to the server. */
+  SVN_ERR(svn_config_get_bool(config, &session->negotiate_http2,
+                              SVN_CONFIG_SECTION_GLOBAL,
+                              SVN_CONFIG_OPTION_HTTP_H2,
+                              SVN_RA_SERF__DEFAULT_NEGOTIATE_HTTP2));
+
+  /* Should we adapt the number of parallel requests. */
+  SVN_ERR(svn_config_get_bool(config, &session->adaptive_concurrency,
+                              SVN_CONFIG_SECTION_GLOBAL,
+                              SVN_CONFIG_OPTION_HTTP_ADAPTIVE_CONCURRENCY,
+                              FALSE));
+
 #if SERF_VERSION_AT_LEAST(1, 4, 0) && !defined(SVN_SERF_NO_LOGGING)
   SVN_ERR(svn_config_get_int64(config, &log_components,
                                SVN_CONFIG_SECTION_GLOBAL,
@@ -318,6 +330,18 @@ load_config(svn_ra_serf__session_t *session,
                                       SVN_CONFIG_OPTION_HTTP_CHUNKED_REQUESTS,
                                       "auto", chunked_requests));
 
+      /* Should we try to talk http/2 to the server. */
+      SVN_ERR(svn_config_get_bool(config, &session->negotiate_http2,
+                                  server_group,
+                                  SVN_CONFIG_OPTION_HTTP_H2,
+                                  session->negotiate_http2));
+
+      /* Should we adapt the number of parallel requests. */
+      SVN_ERR(svn_config_get_bool(config, &session->adaptive_concurrency,
+                                  server_group,
+                                  SVN_CONFIG_OPTION_HTTP_ADAPTIVE_CONCURRENCY,
+                                  session->adaptive_concurrency));
+
 #if SERF_VERSION_AT_LEAST(1, 4, 0) && !defined(SVN_SERF_NO_LOGGING)
       SVN_ERR(svn_config_get_int64(config, &log_components,
                                    server_group,
@@ -643,6 +667,8 @@ ra_serf_dup_session(svn_ra_session_t *new_session,
   /* using_compression */
   /* http10 */
   /* http20 */
+  /* negotiate_http2 */
+  /* adaptive_concurrency */
   /* using_chunked_requests */
   /* detect_chunking */
 
@@ -725,6 +751,10 @@ ra_serf_dup_session(svn_ra_session_t *new_session,
   if (new_sess->vtxn_root_stub)
     new_sess->vtxn_root_stub = apr_pstrdup(result_pool,
                                            new_sess->vtxn_root_stub);
+  if (new_sess->text_stub)
+    new_sess->text_stub = apr_pstrdup(result_pool, new_sess->text_stub);
+  if (new_sess->delta_stub)
+    new_sess->delta_stub = apr_pstrdup(result_pool, new_sess->delta_stub);
 
   /* Keys and values are static */
   if (new_sess->supported_posts)
@@ -758,7 +788,9 @@ ra_serf_dup_session(svn_ra_session_t *new_session,
   /* supports_rev_rsrc_replay */
   /* supports_svndiff1 */
   /* supports_svndiff2 */
+  /* supports_svndiff3 */
   /* supports_put_result_checksum */
+  /* supports_binary_log */
   /* conn_latency */
 
   new_sess->context = serf_context_create(result_pool);
@@ -1066,7 +1098,14 @@ static const svn_ra__vtable_t serf_vtable = {
   svn_ra_serf__list,
   svn_ra_serf__register_editor_shim_callbacks,
   NULL /* commit_ev2 */,
-  NULL /* replay_range_ev2 */
+  NULL /* replay_range_ev2 */,
+  NULL /* get_blame */,
+  NULL /* get_merge_plan */,
+  svn_ra_serf__stat_many,
+  NULL /* get_files */,
+  svn_ra_serf__rev_proplist_range,
+  svn_ra_serf__change_rev_props,
+  NULL /* get_changes_summary */
 };
 
 svn_error_t *
@@ -0,0 +1,274 @@
+/*
+ * stat_many.c :  entry point for the stat_many RA function in ra_serf
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include <serf.h>
+
+#include "svn_hash.h"
+#include "svn_base64.h"
+#include "svn_path.h"
+#include "svn_xml.h"
+#include "svn_time.h"
+
+#include "svn_private_config.h"
+
+#include "ra_serf.h"
+#include "../libsvn_ra/ra_loader.h"
+
+
+
+/*
+ * This enum represents the current state of our XML parsing for a REPORT.
+ */
+enum stat_many_state_e {
+  INITIAL = XML_STATE_INITIAL,
+  REPORT,
+  ENTRY,
+  AUTHOR
+};
+
+typedef struct stat_many_context_t {
+  /* parameters set by our caller */
+  const apr_array_header_t *paths;
+  const apr_array_header_t *revisions;
+
+  /* The session path relative to the repository root. */
+  const char *session_relpath;
+
+  /* Number of entries received so far. */
+  int received;
+
+  /* Buffer the author info for the current entry.
+   * We use the AUTHOR pointer to differentiate between 0-length author
+   * strings and missing / NULL authors. */
+  const char *author;
+  svn_stringbuf_t *author_buf;
+
+  /* receiver function and baton */
+  svn_ra__stat_receiver_t receiver;
+  void *receiver_baton;
+} stat_many_context_t;
+
+#define D_ "DAV:"
+#define S_ SVN_XML_NAMESPACE
+static const svn_ra_serf__xml_transition_t stat_many_ttable[] = {
+  { INITIAL, S_, "stat-many-report", REPORT,
+    FALSE, { NULL }, FALSE },
+
+  { REPORT, S_, "entry", ENTRY,
+    TRUE, { "rev", "node-kind", "?size", "?has-props", "?created-rev",
+             "?date", NULL }, TRUE },
+
+  { ENTRY, D_, "creator-displayname", AUTHOR,
+    TRUE, { "?encoding", NULL }, TRUE },
+
+  { 0 }
+};
+
+/* Conforms to svn_ra_serf__xml_closed_t  */
+static svn_error_t *
+entry_closed(svn_ra_serf__xml_estate_t *xes,
+             void *baton,
+             int leaving_state,
+             const svn_string_t *cdata,
+             apr_hash_t *attrs,
+             apr_pool_t *scratch_pool)
+{
+  stat_many_context_t *ctx = baton;
+
+  if (leaving_state == AUTHOR)
+    {
+      /* See list.c for the encoding. */
+      const char *encoding = svn_hash_gets(attrs, "encoding");
+      if (encoding)
+        {
+          if (strcmp(encoding, "base64") != 0)
+            {
+              return svn_error_createf(SVN_ERR_RA_DAV_MALFORMED_DATA, NULL,
+                                       _("Unsupported encoding '%s'"),
+                                       encoding);
+            }
+
+          cdata = svn_base64_decode_string(cdata, scratch_pool);
+        }
+
+      /* Remember until the next ENTRY closing tag. */
+      svn_stringbuf_set(ctx->author_buf, cdata->data);
+      ctx->author = ctx->author_buf->data;
+    }
+  else if (leaving_state == ENTRY)
+    {
+      const char *kind_word, *date, *crev, *size;
+      svn_revnum_t revision;
+      svn_dirent_t dirent = { 0 };
+
+      /* The server sends the entries in the order we asked for them. */
+      if (ctx->received >= ctx->paths->nelts)
+        return svn_error_create(SVN_ERR_RA_DAV_MALFORMED_DATA, NULL,
+                                _("Too many entries in stat-many response"));
+
+      SVN_ERR(svn_revnum_parse(&revision, svn_hash_gets(attrs, "rev"),
+                               NULL));
+      kind_word = svn_hash_gets(attrs, "node-kind");
+      size = svn_hash_gets(attrs, "size");
+
+      dirent.has_props = svn_hash__get_bool(attrs, "has-props", FALSE);
+      crev = svn_hash_gets(attrs, "created-rev");
+      date = svn_hash_gets(attrs, "date");
+
+      /* Convert data. */
+      dirent.kind = svn_node_kind_from_word(kind_word);
+
+      if (size)
+        SVN_ERR(svn_cstring_atoi64(&dirent.size, size));
+      else
+        dirent.size = SVN_INVALID_FILESIZE;
+
+      if (crev)
+        SVN_ERR(svn_revnum_parse(&dirent.created_rev, crev, NULL));
+      else
+        dirent.created_rev = SVN_INVALID_REVNUM;
+
+      if (date)
+        SVN_ERR(svn_time_from_cstring(&dirent.time, date, scratch_pool));
+
+      if (ctx->author)
+        dirent.last_author = ctx->author;
+
+      /* Invoke RECEIVER */
+      SVN_ERR(ctx->receiver(APR_ARRAY_IDX(ctx->paths, ctx->received,
+                                          const char *),
+                            revision,
+                            dirent.kind == svn_node_none ? NULL : &dirent,
+                            NULL, ctx->receiver_baton, scratch_pool));
+
+      /* Reset buffered info. */
+      ctx->author = NULL;
+      ctx->received++;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_ra_serf__request_body_delegate_t */
+static svn_error_t *
+create_stat_many_body(serf_bucket_t **body_bkt,
+                      void *baton,
+                      serf_bucket_alloc_t *alloc,
+                      apr_pool_t *pool /* request pool */,
+                      apr_pool_t *scratch_pool)
+{
+  serf_bucket_t *buckets;
+  stat_many_context_t *ctx = baton;
+  int i;
+
+  buckets = serf_bucket_aggregate_create(alloc);
+
+  svn_ra_serf__add_open_tag_buckets(buckets, alloc,
+                                    "S:stat-many-report",
+                                    "xmlns:S", SVN_XML_NAMESPACE,
+                                    SVN_VA_NULL);
+
+  for (i = 0; i < ctx->paths->nelts; i++)
+    {
+      const char *path = APR_ARRAY_IDX(ctx->paths, i, const char *);
+      svn_revnum_t revision = APR_ARRAY_IDX(ctx->revisions, i, svn_revnum_t);
+
+      path = svn_relpath_join(ctx->session_relpath, path, pool);
+      if (SVN_IS_VALID_REVNUM(revision))
+        svn_ra_serf__add_open_tag_buckets(buckets, alloc, "S:entry",
+                                          "rev", apr_ltoa(pool, revision),
+                                          SVN_VA_NULL);
+      else
+        svn_ra_serf__add_open_tag_buckets(buckets, alloc, "S:entry",
+                                          SVN_VA_NULL);
+      svn_ra_serf__add_cdata_len_buckets(buckets, alloc, path, strlen(path));
+      svn_ra_serf__add_close_tag_buckets(buckets, alloc, "S:entry");
+    }
+
+  svn_ra_serf__add_close_tag_buckets(buckets, alloc,
+                                     "S:stat-many-report");
+
+  *body_bkt = buckets;
+  return SVN_NO_ERROR;
+}
+
+
+svn_error_t *
+svn_ra_serf__stat_many(svn_ra_session_t *ra_session,
+                       const apr_array_header_t *paths,
+                       const apr_array_header_t *revisions,
+                       svn_boolean_t fetch_locks,
+                       svn_ra__stat_receiver_t receiver,
+                       void *receiver_baton,
+                       apr_pool_t *scratch_pool)
+{
+  stat_many_context_t *ctx;
+  svn_ra_serf__session_t *session = ra_session->priv;
+  svn_ra_serf__handler_t *handler;
+  svn_ra_serf__xml_context_t *xmlctx;
+  const char *report_target;
+
+  /* The report doesn't include lock information; let the caller get those
+     separately. */
+  if (fetch_locks)
+    return svn_error_create(SVN_ERR_RA_NOT_IMPLEMENTED, NULL, NULL);
+
+  ctx = apr_pcalloc(scratch_pool, sizeof(*ctx));
+  ctx->paths = paths;
+  ctx->revisions = revisions;
+  ctx->receiver = receiver;
+  ctx->receiver_baton = receiver_baton;
+  ctx->author_buf = svn_stringbuf_create_empty(scratch_pool);
+
+  /* The report is independent of the resource it is run against and
+     takes paths relative to the repository root. */
+  SVN_ERR(svn_ra_serf__get_relative_path(&ctx->session_relpath,
+                                         session->session_url.path,
+                                         session, scratch_pool));
+  SVN_ERR(svn_ra_serf__report_resource(&report_target, session,
+                                       scratch_pool));
+
+  xmlctx = svn_ra_serf__xml_context_create(stat_many_ttable,
+                                           NULL, entry_closed, NULL,
+                                           ctx,
+                                           scratch_pool);
+  handler = svn_ra_serf__create_expat_handler(session, xmlctx, NULL,
+                                              scratch_pool);
+
+  handler->method = "REPORT";
+  handler->path = report_target;
+  handler->body_delegate = create_stat_many_body;
+  handler->body_delegate_baton = ctx;
+  handler->body_type = "text/xml";
+
+  SVN_ERR(svn_ra_serf__context_run_one(handler, scratch_pool));
+
+  if (handler->sline.code != 200)
+    SVN_ERR(svn_ra_serf__unexpected_status(handler));
+
+  if (ctx->received != paths->nelts)
+    return svn_error_create(SVN_ERR_RA_DAV_MALFORMED_DATA, NULL,
+                            _("Missing entries in stat-many response"));
+
+  return SVN_NO_ERROR;
+}
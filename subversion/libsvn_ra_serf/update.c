@@ -40,6 +40,7 @@
 #include "svn_path.h"
 #include "svn_base64.h"
 #include "svn_props.h"
+#include "svn_sorts.h"
 
 #include "svn_private_config.h"
 #include "private/svn_dep_compat.h"
@@ -251,9 +252,34 @@ static const svn_ra_serf__xml_transition_t update_ttable[] = {
    can make the measurements quite imprecise.
 
    We measure outstanding requests as the sum of NUM_ACTIVE_FETCHES and
-   NUM_ACTIVE_PROPFINDS in the report_context_t structure.  */
+   NUM_ACTIVE_PROPFINDS in the report_context_t structure.
+
+   With http/2, all requests get multiplexed over a single connection and
+   the server processes them concurrently.  So, we allow for many more of
+   them to be outstanding at any time.  */
 #define REQUEST_COUNT_TO_PAUSE 50
 #define REQUEST_COUNT_TO_RESUME 40
+#define REQUEST_COUNT_TO_RESUME_HTTP2 400
+
+/* Return the REQUEST_COUNT_TO_RESUME value to use for session SESS. */
+#define REQUEST_COUNT_TO_RESUME_FOR(sess) \
+  ((sess)->http20 ? REQUEST_COUNT_TO_RESUME_HTTP2 : REQUEST_COUNT_TO_RESUME)
+
+/* With the "http-adaptive-concurrency" option, the static limit above is
+   replaced by a request window that grows by ADAPTIVE_WINDOW_INCREMENT
+   after each sample period without signs of congestion and gets halved
+   once the average response latency exceeds ADAPTIVE_LATENCY_FACTOR times
+   the best one seen so far without the throughput improving.
+
+   The window never drops below REQS_PER_CONN and is limited to
+   ADAPTIVE_REQUESTS_PER_CONN requests per permitted connection, i.e. it
+   is bounded by http-max-connections.  A sample period ends once the
+   number of fetches completed within it reaches the current window size,
+   but no earlier than ADAPTIVE_MIN_SAMPLE_TIME. */
+#define ADAPTIVE_WINDOW_INCREMENT 4
+#define ADAPTIVE_LATENCY_FACTOR 2
+#define ADAPTIVE_REQUESTS_PER_CONN 32
+#define ADAPTIVE_MIN_SAMPLE_TIME apr_time_from_msec(100)
 
 #define SPILLBUF_BLOCKSIZE 4096
 #define SPILLBUF_MAXBUFFSIZE 131072
@@ -388,6 +414,13 @@ typedef struct fetch_ctx_t {
   /* The base-rev header  */
   const char *delta_base;
 
+  /* Where the server finds the text requested through a content-addressed
+     URI, see SVN_DAV_TEXT_LOCATION_HEADER.  NULL for other URIs. */
+  const char *text_location;
+
+  /* When the GET request got created. */
+  apr_time_t start_time;
+
 } fetch_ctx_t;
 
 /*
@@ -445,6 +478,19 @@ struct report_context_t {
   /* number of pending PROPFIND requests */
   unsigned int num_active_propfinds;
 
+  /* Adaptive concurrency state.  REQUEST_WINDOW is the maximum number of
+     outstanding requests before we pause the REPORT processing, 0 if the
+     static limits apply.  The SAMPLE_* members accumulate the completed
+     GETs of the current sample period. */
+  unsigned int request_window;
+  unsigned int request_window_max;
+  apr_time_t sample_start;
+  unsigned int sample_fetches;
+  apr_off_t sample_bytes;
+  apr_interval_time_t sample_latency;
+  apr_interval_time_t min_latency;
+  double last_throughput;
+
   /* Are we done parsing the REPORT response? */
   svn_boolean_t done;
 
@@ -551,40 +597,114 @@ create_file_baton(file_baton_t **new_file,
 /** This function creates a new connection for this serf session, but only
  * if the number of NUM_ACTIVE_REQS > REQS_PER_CONN or if there currently is
  * only one main connection open.
+ *
+ * For http/2 sessions, a single auxiliary connection is all we will ever
+ * need as it multiplexes any number of requests.
  */
 static svn_error_t *
 open_connection_if_needed(svn_ra_serf__session_t *sess, int num_active_reqs)
 {
+  if (sess->http20 && sess->num_conns > 1)
+    return SVN_NO_ERROR;
+
   /* For each REQS_PER_CONN outstanding requests open a new connection, with
    * a minimum of 1 extra connection. */
   if (sess->num_conns == 1 ||
       ((num_active_reqs / REQS_PER_CONN) > sess->num_conns))
-    {
-      int cur = sess->num_conns;
-      apr_status_t status;
-
-      sess->conns[cur] = apr_pcalloc(sess->pool, sizeof(*sess->conns[cur]));
-      sess->conns[cur]->bkt_alloc = serf_bucket_allocator_create(sess->pool,
-                                                                 NULL, NULL);
-      sess->conns[cur]->last_status_code = -1;
-      sess->conns[cur]->session = sess;
-      status = serf_connection_create2(&sess->conns[cur]->conn,
-                                       sess->context,
-                                       sess->session_url,
-                                       svn_ra_serf__conn_setup,
-                                       sess->conns[cur],
-                                       svn_ra_serf__conn_closed,
-                                       sess->conns[cur],
-                                       sess->pool);
-      if (status)
-        return svn_ra_serf__wrap_err(status, NULL);
-
-      sess->num_conns++;
-    }
+    SVN_ERR(svn_ra_serf__open_connection(sess));
 
   return SVN_NO_ERROR;
 }
 
+/* Return the number of outstanding requests below which CTX continues
+   processing the REPORT response. */
+static unsigned int
+request_count_to_resume(const report_context_t *ctx)
+{
+  if (ctx->request_window)
+    return ctx->request_window;
+
+  return REQUEST_COUNT_TO_RESUME_FOR(ctx->sess);
+}
+
+/* Start adaptive concurrency control for CTX, if enabled. */
+static void
+init_request_window(report_context_t *ctx)
+{
+  svn_ra_serf__session_t *sess = ctx->sess;
+
+  if (!sess->adaptive_concurrency)
+    return;
+
+  if (sess->http20)
+    ctx->request_window_max = REQUEST_COUNT_TO_RESUME_HTTP2;
+  else
+    ctx->request_window_max = (unsigned int)sess->max_connections
+                            * ADAPTIVE_REQUESTS_PER_CONN;
+
+  ctx->request_window = MIN(REQUEST_COUNT_TO_RESUME_FOR(sess),
+                            ctx->request_window_max);
+  ctx->sample_start = apr_time_now();
+}
+
+/* Record in CTX that a GET request transferring BYTES took LATENCY to
+   complete and adjust the request window at the end of each sample
+   period.  Use SCRATCH_POOL for temporary allocations. */
+static void
+record_fetch(report_context_t *ctx,
+             apr_off_t bytes,
+             apr_interval_time_t latency,
+             apr_pool_t *scratch_pool)
+{
+  apr_time_t now;
+  apr_interval_time_t elapsed;
+  apr_interval_time_t avg_latency;
+  double throughput;
+  unsigned int old_window = ctx->request_window;
+  const svn_ra_callbacks2_t *callbacks = ctx->sess->wc_callbacks;
+
+  if (!ctx->request_window)
+    return;
+
+  ctx->sample_fetches++;
+  ctx->sample_bytes += bytes;
+  ctx->sample_latency += latency;
+
+  if (ctx->sample_fetches < ctx->request_window)
+    return;
+
+  now = apr_time_now();
+  elapsed = now - ctx->sample_start;
+  if (elapsed < ADAPTIVE_MIN_SAMPLE_TIME)
+    return;
+
+  avg_latency = ctx->sample_latency / ctx->sample_fetches;
+  throughput = (double)ctx->sample_bytes / (double)elapsed;
+
+  if (ctx->min_latency == 0 || avg_latency < ctx->min_latency)
+    ctx->min_latency = avg_latency;
+
+  /* Requests queue up at the server or in the network, yet we don't get
+     any more data through: back off.  Otherwise, probe for more. */
+  if (avg_latency > ADAPTIVE_LATENCY_FACTOR * ctx->min_latency
+      && throughput <= ctx->last_throughput)
+    ctx->request_window = MAX(ctx->request_window / 2, REQS_PER_CONN);
+  else
+    ctx->request_window = MIN(ctx->request_window + ADAPTIVE_WINDOW_INCREMENT,
+                              ctx->request_window_max);
+
+  ctx->last_throughput = throughput;
+  ctx->sample_start = now;
+  ctx->sample_fetches = 0;
+  ctx->sample_bytes = 0;
+  ctx->sample_latency = 0;
+
+  if (ctx->request_window != old_window && callbacks
+      && callbacks->concurrency_func)
+    callbacks->concurrency_func(ctx->request_window,
+                                ctx->sess->progress_baton, scratch_pool);
+}
+
 /* Returns best connection for fetching files/properties. */
 static svn_ra_serf__connection_t *
 get_best_connection(report_context_t *ctx)
@@ -792,6 +912,10 @@ headers_fetch(serf_bucket_t *headers,
 {
   fetch_ctx_t *fetch_ctx = baton;
 
+  if (fetch_ctx->text_location)
+    serf_bucket_headers_setn(headers, SVN_DAV_TEXT_LOCATION_HEADER,
+                             fetch_ctx->text_location);
+
   /* note that we have old VC URL */
   if (fetch_ctx->delta_base)
     {
@@ -1189,6 +1313,9 @@ file_fetch_done(serf_request_t *request,
   if (handler->sline.code != 200)
     return svn_error_trace(svn_ra_serf__unexpected_status(handler));
 
+  record_fetch(file->parent_dir->ctx, fetch_ctx->read_size,
+               apr_time_now() - fetch_ctx->start_time, scratch_pool);
+
   file->parent_dir->ctx->num_active_fetches--;
 
   file->fetch_file = FALSE;
@@ -1329,6 +1456,31 @@ fetch_for_file(file_baton_t *file,
           handler->method = "GET";
           handler->path = file->url;
 
+          /* Prefer URIs that don't depend on the path and revision, so
+             shared HTTP caches can answer them for all clients that
+             fetch the same text. */
+          if (ctx->sess->text_stub && ctx->sess->delta_stub
+              && file->final_sha1_checksum)
+            {
+              const char *sha1
+                = svn_checksum_to_cstring(file->final_sha1_checksum,
+                                          scratch_pool);
+
+              if (!fetch_ctx->delta_base)
+                handler->path = apr_psprintf(file->pool, "%s/%s",
+                                             ctx->sess->text_stub, sha1);
+              else if (file->base_md5_checksum)
+                handler->path = apr_psprintf(file->pool, "%s/%s/%s",
+                                             ctx->sess->delta_stub,
+                                             svn_checksum_to_cstring(
+                                               file->base_md5_checksum,
+                                               scratch_pool),
+                                             sha1);
+
+              if (handler->path != file->url)
+                fetch_ctx->text_location = file->url;
+            }
+
           handler->conn = conn; /* Explicit scheduling */
 
           handler->custom_accept_encoding = TRUE;
@@ -1346,6 +1498,7 @@ fetch_for_file(file_baton_t *file,
           handler->done_delegate_baton = fetch_ctx;
 
           fetch_ctx->handler = handler;
+          fetch_ctx->start_time = apr_time_now();
 
           svn_ra_serf__request_create(handler);
 
@@ -2251,7 +2404,7 @@ update_delay_handler(serf_request_t *request,
         }
 
       while ((udb->report->num_active_fetches + udb->report->num_active_propfinds)
-                 < REQUEST_COUNT_TO_RESUME)
+                 < request_count_to_resume(udb->report))
         {
           const char *data;
           apr_size_t len;
@@ -2335,7 +2488,7 @@ process_pending(update_delay_baton_t *udb,
   serf_bucket_alloc_t *alloc = NULL;
 
   while ((udb->report->num_active_fetches + udb->report->num_active_propfinds)
-            < REQUEST_COUNT_TO_RESUME)
+            < request_count_to_resume(udb->report))
     {
       const char *data;
       apr_size_t len;
@@ -2409,6 +2562,8 @@ process_editor_report(report_context_t *ctx,
   /* Open the first extra connection. */
   SVN_ERR(open_connection_if_needed(sess, 0));
 
+  init_request_window(ctx);
+
   sess->cur_conn = 1;
 
   /* Note that we may have no active GET or PROPFIND requests, yet the
@@ -480,7 +480,7 @@ load_authorities(svn_ra_serf__connection_t *conn, const char *authorities,
   return SVN_NO_ERROR;
 }
 
-#if SERF_VERSION_AT_LEAST(1, 4, 0) && defined(SVN__SERF_TEST_HTTP2)
+#if SERF_VERSION_AT_LEAST(1, 4, 0)
 /* Implements serf_ssl_protocol_result_cb_t */
 static apr_status_t
 conn_negotiate_protocol(void *data,
@@ -557,8 +557,9 @@ conn_setup(apr_socket_t *sock,
               SVN_ERR(load_authorities(conn, conn->session->ssl_authorities,
                                        conn->session->pool));
             }
-#if SERF_VERSION_AT_LEAST(1, 4, 0) && defined(SVN__SERF_TEST_HTTP2)
-          if (APR_SUCCESS ==
+#if SERF_VERSION_AT_LEAST(1, 4, 0)
+          if (conn->session->negotiate_http2
+              && APR_SUCCESS ==
                 serf_ssl_negotiate_protocol(conn->ssl_context, "h2,http/1.1",
                                             conn_negotiate_protocol, conn))
             {
@@ -1008,6 +1009,35 @@ svn_ra_serf__unschedule_handler(svn_ra_serf__handler_t *handler)
   handler->scheduled = FALSE;
 }
 
+svn_error_t *
+svn_ra_serf__open_connection(svn_ra_serf__session_t *sess)
+{
+  int cur = sess->num_conns;
+  apr_status_t status;
+
+  SVN_ERR_ASSERT(cur < SVN_RA_SERF__MAX_CONNECTIONS_LIMIT);
+
+  sess->conns[cur] = apr_pcalloc(sess->pool, sizeof(*sess->conns[cur]));
+  sess->conns[cur]->bkt_alloc = serf_bucket_allocator_create(sess->pool,
+                                                             NULL, NULL);
+  sess->conns[cur]->last_status_code = -1;
+  sess->conns[cur]->session = sess;
+  status = serf_connection_create2(&sess->conns[cur]->conn,
+                                   sess->context,
+                                   sess->session_url,
+                                   svn_ra_serf__conn_setup,
+                                   sess->conns[cur],
+                                   svn_ra_serf__conn_closed,
+                                   sess->conns[cur],
+                                   sess->pool);
+  if (status)
+    return svn_ra_serf__wrap_err(status, NULL);
+
+  sess->num_conns++;
+
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *
 svn_ra_serf__context_run_one(svn_ra_serf__handler_t *handler,
                              apr_pool_t *scratch_pool)
@@ -2044,7 +2074,7 @@ svn_ra_serf__setup_svndiff_accept_encoding(serf_bucket_t *headers,
          don't care about worse compression ratio. */
       serf_bucket_headers_setn(
         headers, "Accept-Encoding",
-        "gzip,svndiff2;q=0.9,svndiff1;q=0.8,svndiff;q=0.7");
+        "gzip,svndiff2;q=0.9,svndiff3;q=0.85,svndiff1;q=0.8,svndiff;q=0.7");
     }
   else
     {
@@ -2052,10 +2082,12 @@ svn_ra_serf__setup_svndiff_accept_encoding(serf_bucket_t *headers,
          svndiff2 is not a reasonable substitute for svndiff1 with default
          compression level, because, while it is faster, it also gives worse
          compression ratio.  While we can use svndiff2 in some cases (see
-         above), we can't do this generally. */
+         above), we can't do this generally.  Svndiff3 uses the same
+         compression as svndiff1 with more compact instructions, so we
+         prefer it over both. */
       serf_bucket_headers_setn(
         headers, "Accept-Encoding",
-        "gzip,svndiff1;q=0.9,svndiff2;q=0.8,svndiff;q=0.7");
+        "gzip,svndiff3;q=0.95,svndiff1;q=0.9,svndiff2;q=0.8,svndiff;q=0.7");
     }
 }
 
@@ -68,6 +68,14 @@ struct svn_ra_serf__xml_context_t {
   /* Linked list of free states.  */
   svn_ra_serf__xml_estate_t *free_states;
 
+  /* State pools that have been cleared and may be handed out again
+     (apr_pool_t *).  Reports contain a huge number of elements, so we
+     don't want to create and destroy a pool for each of them. */
+  apr_array_header_t *free_pools;
+
+  /* Pool that the states, their tag names and state pools live in.  */
+  apr_pool_t *pool;
+
 #ifdef SVN_DEBUG
   /* Used to verify we are not re-entering a callback, specifically to
      ensure SCRATCH_POOL is not cleared while an outer callback is
@@ -106,6 +114,14 @@ struct svn_ra_serf__xml_estate_t {
   /* The xml tag that opened this state. Waiting for the tag to close.  */
   svn_ra_serf__dav_props_t tag;
 
+  /* Buffer holding TAG.NAME and its capacity.  States get recycled, so
+     this buffer will be reused for other elements.  */
+  char *name_buf;
+  apr_size_t name_buf_size;
+
+  /* The context this state belongs to.  */
+  svn_ra_serf__xml_context_t *xmlctx;
+
   /* Should the CLOSED_CB function be called for custom processing when
      this tag is closed?  */
   svn_boolean_t custom_close;
@@ -442,23 +458,68 @@ void svn_ra_serf__add_tag_buckets(serf_bucket_t *agg_bucket, const char *tag,
   svn_ra_serf__add_close_tag_buckets(agg_bucket, bkt_alloc, tag);
 }
 
-/* Return a pool for XES to use for self-alloc (and other specifics).  */
-static apr_pool_t *
-xes_pool(const svn_ra_serf__xml_estate_t *xes)
+static void
+ensure_pool(svn_ra_serf__xml_estate_t *xes)
 {
-  /* Move up through parent states looking for one with a pool. This
-     will always terminate since the initial state has a pool.  */
-  while (xes->state_pool == NULL)
-    xes = xes->prev;
-  return xes->state_pool;
+  if (xes->state_pool == NULL)
+    {
+      apr_array_header_t *free_pools = xes->xmlctx->free_pools;
+
+      /* Recycle state pools from elements that have been closed. */
+      if (free_pools->nelts)
+        xes->state_pool = *(apr_pool_t **)apr_array_pop(free_pools);
+      else
+        xes->state_pool = svn_pool_create(xes->xmlctx->pool);
+    }
 }
 
+/* Return a new state for XMLCTX with all members being 0 except for
+   a possibly recycled name buffer.  */
+static svn_ra_serf__xml_estate_t *
+alloc_state(svn_ra_serf__xml_context_t *xmlctx)
+{
+  svn_ra_serf__xml_estate_t *xes = xmlctx->free_states;
+
+  if (xes)
+    {
+      char *name_buf = xes->name_buf;
+      apr_size_t name_buf_size = xes->name_buf_size;
+
+      xmlctx->free_states = xes->prev;
+      memset(xes, 0, sizeof(*xes));
+      xes->name_buf = name_buf;
+      xes->name_buf_size = name_buf_size;
+    }
+  else
+    {
+      xes = apr_pcalloc(xmlctx->pool, sizeof(*xes));
+    }
+
+  xes->xmlctx = xmlctx;
+  return xes;
+}
 
+/* Set XES->TAG to a copy of ELEMNAME.  */
 static void
-ensure_pool(svn_ra_serf__xml_estate_t *xes)
+set_tag(svn_ra_serf__xml_estate_t *xes,
+        const svn_ra_serf__dav_props_t *elemname)
 {
-  if (xes->state_pool == NULL)
-    xes->state_pool = svn_pool_create(xes_pool(xes));
+  apr_size_t len = strlen(elemname->name);
+
+  if (len >= xes->name_buf_size)
+    {
+      xes->name_buf_size = 2 * xes->name_buf_size > len
+                         ? 2 * xes->name_buf_size
+                         : len + 1;
+      xes->name_buf = apr_palloc(xes->xmlctx->pool, xes->name_buf_size);
+    }
+
+  memcpy(xes->name_buf, elemname->name, len + 1);
+  xes->tag.name = xes->name_buf;
+
+  /* Namespace URLs are either static or live in the pool of the state
+     that declared them, i.e. in one of our parent states.  */
+  xes->tag.xmlns = elemname->xmlns;
 }
 
 
@@ -486,7 +547,8 @@ svn_ra_serf__xml_context_done(svn_ra_serf__xml_context_t *xmlctx)
   else if (! xmlctx->free_states)
     {
       /* If we have no items on the free_states list, we didn't push anything,
-         which tells us that we found an empty xml body */
+         which tells us that we found an empty xml body.  States only get
+         recycled while parsing, so this test still works. */
       const svn_ra_serf__xml_transition_t *scan;
       const svn_ra_serf__xml_transition_t *document = NULL;
       const char *msg;
@@ -515,6 +577,9 @@ svn_ra_serf__xml_context_done(svn_ra_serf__xml_context_t *xmlctx)
                                msg);
     }
 
+  while (xmlctx->free_pools->nelts)
+    svn_pool_destroy(*(apr_pool_t **)apr_array_pop(xmlctx->free_pools));
+
   svn_pool_destroy(xmlctx->scratch_pool);
   return SVN_NO_ERROR;
 }
@@ -538,13 +603,15 @@ svn_ra_serf__xml_context_create(
   xmlctx->cdata_cb = cdata_cb;
   xmlctx->baton = baton;
   xmlctx->scratch_pool = svn_pool_create(result_pool);
+  xmlctx->pool = result_pool;
+  xmlctx->free_pools = apr_array_make(result_pool, 8, sizeof(apr_pool_t *));
 
-  xes = apr_pcalloc(result_pool, sizeof(*xes));
+  xes = alloc_state(xmlctx);
   /* XES->STATE == 0  */
 
-  /* Child states may use this pool to allocate themselves. If a child
-     needs to collect information, then it will construct a subpool and
-     will use that to allocate itself and its collected data.  */
+  /* If a child state needs to collect information, then it will get a
+     subpool of this pool and will use that for its collected data.
+     The initial state never closes, so its pool never gets recycled.  */
   xes->state_pool = result_pool;
 
   xmlctx->current = xes;
@@ -639,7 +706,6 @@ xml_cb_start(svn_ra_serf__xml_context_t *xmlctx,
   svn_ra_serf__xml_estate_t *current = xmlctx->current;
   svn_ra_serf__dav_props_t elemname;
   const svn_ra_serf__xml_transition_t *scan;
-  apr_pool_t *new_pool;
   svn_ra_serf__xml_estate_t *new_xes;
 
   /* If we're waiting for an element to close, then just ignore all
@@ -690,22 +756,16 @@ xml_cb_start(svn_ra_serf__xml_context_t *xmlctx,
 
   /* Found a transition. Make it happen.  */
 
-  /* ### todo. push state  */
-
-  /* ### how to use free states?  */
-  /* This state should be allocated in the extent pool. If we will be
-     collecting information for this state, then construct a subpool.
-
-     ### potentially optimize away the subpool if none of the
-     ### attributes are present. subpools are cheap, tho...  */
-  new_pool = xes_pool(current);
+  /* Recycle the state of some element that has been closed already.
+     If we will be collecting information for this state, then also get
+     a state pool for it.  */
+  new_xes = alloc_state(xmlctx);
   if (scan->collect_cdata || scan->collect_attrs[0])
     {
-      new_pool = svn_pool_create(new_pool);
+      apr_pool_t *new_pool;
 
-      /* Prep the new state.  */
-      new_xes = apr_pcalloc(new_pool, sizeof(*new_xes));
-      new_xes->state_pool = new_pool;
+      ensure_pool(new_xes);
+      new_pool = new_xes->state_pool;
 
       /* If we're supposed to collect cdata, then set up a buffer for
          this. The existence of this buffer will instruct our cdata
@@ -746,17 +806,11 @@ xml_cb_start(svn_ra_serf__xml_context_t *xmlctx,
             }
         }
     }
-  else
-    {
-      /* Prep the new state.  */
-      new_xes = apr_pcalloc(new_pool, sizeof(*new_xes));
-      /* STATE_POOL remains NULL.  */
-    }
+  /* ... else STATE_POOL remains NULL.  */
 
   /* Some basic copies to set up the new estate.  */
   new_xes->state = scan->to_state;
-  new_xes->tag.name = apr_pstrdup(new_pool, elemname.name);
-  new_xes->tag.xmlns = apr_pstrdup(new_pool, elemname.xmlns);
+  set_tag(new_xes, &elemname);
   new_xes->custom_close = scan->custom_close;
 
   /* Start with the parent's namespace set.  */
@@ -820,16 +874,18 @@ xml_cb_end(svn_ra_serf__xml_context_t *xmlctx,
   /* Pop the state.  */
   xmlctx->current = xes->prev;
 
-  /* ### not everything should go on the free state list. XES may go
-     ### away with the state pool.  */
+  /* States always live in the context pool, so they can be recycled.  */
   xes->prev = xmlctx->free_states;
   xmlctx->free_states = xes;
 
-  /* If there is a STATE_POOL, then toss it. This will get rid of as much
-     memory as possible. Potentially the XES (if we didn't create a pool
-     right away, then XES may be in a parent pool).  */
+  /* If there is a STATE_POOL, then clear it and keep it around for the
+     next element that needs one.  */
   if (xes->state_pool)
-    svn_pool_destroy(xes->state_pool);
+    {
+      svn_pool_clear(xes->state_pool);
+      APR_ARRAY_PUSH(xmlctx->free_pools, apr_pool_t *) = xes->state_pool;
+      xes->state_pool = NULL;
+    }
 
   return SVN_NO_ERROR;
 }
@@ -1028,3 +1084,28 @@ svn_ra_serf__create_expat_handler(svn_ra_serf__session_t *session,
 
   return handler;
 }
+
+svn_error_t *
+svn_ra_serf__xml_parse_stream(svn_ra_serf__xml_context_t *xmlctx,
+                              svn_stream_t *stream,
+                              apr_pool_t *scratch_pool)
+{
+  struct expat_ctx_t ectx = { 0 };
+  char *buffer = apr_palloc(scratch_pool, PARSE_CHUNK_SIZE);
+  apr_size_t len;
+
+  ectx.xmlctx = xmlctx;
+  ectx.cleanup_pool = scratch_pool;
+  ectx.parser = svn_xml_make_parser(&ectx, expat_start, expat_end,
+                                    expat_cdata, scratch_pool);
+
+  do
+    {
+      len = PARSE_CHUNK_SIZE;
+      SVN_ERR(svn_stream_read_full(stream, buffer, &len));
+      SVN_ERR(parse_xml(&ectx, buffer, len, len < PARSE_CHUNK_SIZE));
+    }
+  while (len == PARSE_CHUNK_SIZE);
+
+  return svn_error_trace(svn_ra_serf__xml_context_done(xmlctx));
+}
@@ -47,12 +47,14 @@
 #include "svn_mergeinfo.h"
 #include "svn_version.h"
 #include "svn_ctype.h"
+#include "svn_sorts.h"
 
 #include "svn_private_config.h"
 
 #include "private/svn_fspath.h"
 #include "private/svn_string_private.h"
 #include "private/svn_subr_private.h"
+#include "private/svn_worker_pool.h"
 
 #include "../libsvn_ra/ra_loader.h"
 
@@ -747,15 +749,18 @@ static svn_error_t *open_session(svn_ra_svn__session_baton_t **sess_p,
    * capability list, and the URL, and subsequently there is an auth
    * request. */
   /* Client-side capabilities list: */
-  SVN_ERR(svn_ra_svn__write_tuple(conn, pool, "n(wwwwwww)cc(?c)",
+  SVN_ERR(svn_ra_svn__write_tuple(conn, pool, "n(wwwwwwwwww)cc(?c)",
                                   (apr_uint64_t) 2,
                                   SVN_RA_SVN_CAP_EDIT_PIPELINE,
                                   SVN_RA_SVN_CAP_SVNDIFF1,
                                   SVN_RA_SVN_CAP_SVNDIFF2_ACCEPTED,
+                                  SVN_RA_SVN_CAP_SVNDIFF3_ACCEPTED,
                                   SVN_RA_SVN_CAP_ABSENT_ENTRIES,
                                   SVN_RA_SVN_CAP_DEPTH,
                                   SVN_RA_SVN_CAP_MERGEINFO,
                                   SVN_RA_SVN_CAP_LOG_REVPROPS,
+                                  SVN_RA_SVN_CAP_COMPRESS_LZ4_ACCEPTED,
+                                  SVN_RA_SVN_CAP_COMPRESS_ZLIB_ACCEPTED,
                                   url,
                                   SVN_RA_SVN__DEFAULT_USERAGENT,
                                   client_string));
@@ -771,6 +776,14 @@ static svn_error_t *open_session(svn_ra_svn__session_baton_t **sess_p,
   if (repos_caplist)
     SVN_ERR(svn_ra_svn__set_capabilities(conn, repos_caplist));
 
+  /* The server may have chosen to compress the rest of the session. */
+  if (svn_ra_svn_has_capability(conn, SVN_RA_SVN_CAP_COMPRESS_LZ4))
+    SVN_ERR(svn_ra_svn__enable_compression(conn, SVN_RA_SVN_CAP_COMPRESS_LZ4,
+                                           pool));
+  else if (svn_ra_svn_has_capability(conn, SVN_RA_SVN_CAP_COMPRESS_ZLIB))
+    SVN_ERR(svn_ra_svn__enable_compression(conn, SVN_RA_SVN_CAP_COMPRESS_ZLIB,
+                                           pool));
+
   if (conn->repos_root)
     {
       conn->repos_root = svn_uri_canonicalize(conn->repos_root, pool);
@@ -2133,6 +2146,40 @@ static svn_error_t *handle_unsupported_cmd(svn_error_t *err,
 }
 
 
+/* Set *DIRENT to the dirent described by LIST, as sent in response to
+   "stat".  Allocate it in POOL. */
+static svn_error_t *
+parse_stat_dirent(svn_dirent_t **dirent,
+                  const svn_ra_svn__list_t *list,
+                  apr_pool_t *pool)
+{
+  const char *kind, *cdate, *cauthor;
+  svn_boolean_t has_props;
+  svn_revnum_t crev;
+  apr_uint64_t size;
+  svn_dirent_t *the_dirent;
+
+  SVN_ERR(svn_ra_svn__parse_tuple(list, "wnbr(?c)(?c)",
+                                  &kind, &size, &has_props,
+                                  &crev, &cdate, &cauthor));
+
+  /* Sizes are unsigned on the wire but svn_filesize_t is signed. */
+  if (size > APR_INT64_MAX)
+    return svn_error_create(SVN_ERR_RA_SVN_MALFORMED_DATA, NULL,
+                            _("Invalid file size in stat response"));
+
+  the_dirent = svn_dirent_create(pool);
+  the_dirent->kind = svn_node_kind_from_word(kind);
+  the_dirent->size = (svn_filesize_t)size;
+  the_dirent->has_props = has_props;
+  the_dirent->created_rev = crev;
+  SVN_ERR(svn_time_from_cstring(&the_dirent->time, cdate, pool));
+  the_dirent->last_author = cauthor;
+
+  *dirent = the_dirent;
+  return SVN_NO_ERROR;
+}
+
 static svn_error_t *ra_svn_stat(svn_ra_session_t *session,
                                 const char *path, svn_revnum_t rev,
                                 svn_dirent_t **dirent, apr_pool_t *pool)
@@ -2140,7 +2187,6 @@ static svn_error_t *ra_svn_stat(svn_ra_session_t *session,
   svn_ra_svn__session_baton_t *sess_baton = session->priv;
   svn_ra_svn_conn_t *conn = sess_baton->conn;
   svn_ra_svn__list_t *list = NULL;
-  svn_dirent_t *the_dirent;
 
   path = reparent_path(session, path, pool);
   SVN_ERR(svn_ra_svn__write_cmd_stat(conn, pool, path, rev));
@@ -2149,29 +2195,462 @@ static svn_error_t *ra_svn_stat(svn_ra_session_t *session,
   SVN_ERR(svn_ra_svn__read_cmd_response(conn, pool, "(?l)", &list));
 
   if (! list)
+    *dirent = NULL;
+  else
+    SVN_ERR(parse_stat_dirent(dirent, list, pool));
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+ra_svn_stat_many(svn_ra_session_t *session,
+                 const apr_array_header_t *paths,
+                 const apr_array_header_t *revisions,
+                 svn_boolean_t fetch_locks,
+                 svn_ra__stat_receiver_t receiver,
+                 void *receiver_baton,
+                 apr_pool_t *scratch_pool)
+{
+  svn_ra_svn__session_baton_t *sess_baton = session->priv;
+  svn_ra_svn_conn_t *conn = sess_baton->conn;
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  int i;
+
+  SVN_ERR(svn_ra_svn__write_tuple(conn, scratch_pool, "w((!", "stat-many"));
+  for (i = 0; i < paths->nelts; i++)
     {
-      *dirent = NULL;
+      const char *path = APR_ARRAY_IDX(paths, i, const char *);
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_ra_svn__write_tuple(conn, iterpool, "(c(?r))",
+                                      reparent_path(session, path, iterpool),
+                                      APR_ARRAY_IDX(revisions, i,
+                                                    svn_revnum_t)));
     }
-  else
+  SVN_ERR(svn_ra_svn__write_tuple(conn, scratch_pool, "!)b)", fetch_locks));
+
+  SVN_ERR(handle_auth_request(sess_baton, scratch_pool));
+
+  /* Read and process the results.  They come in the order of PATHS. */
+  for (i = 0; ; i++)
     {
-      const char *kind, *cdate, *cauthor;
-      svn_boolean_t has_props;
-      svn_revnum_t crev;
-      apr_uint64_t size;
+      svn_ra_svn__item_t *item;
+      svn_ra_svn__list_t *dirent_list, *lock_list;
+      const char *path;
+      svn_revnum_t revision;
+      svn_dirent_t *dirent = NULL;
+      svn_lock_t *lock = NULL;
 
-      SVN_ERR(svn_ra_svn__parse_tuple(list, "wnbr(?c)(?c)",
-                                      &kind, &size, &has_props,
-                                      &crev, &cdate, &cauthor));
+      svn_pool_clear(iterpool);
+
+      /* Read the next entry or bail out on "done", respectively */
+      SVN_ERR(svn_ra_svn__read_item(conn, iterpool, &item));
+      if (is_done_response(item))
+        break;
+      if (item->kind != SVN_RA_SVN_LIST)
+        return svn_error_create(SVN_ERR_RA_SVN_MALFORMED_DATA, NULL,
+                                _("Stat entry not a list"));
+      if (i >= paths->nelts)
+        return svn_error_create(SVN_ERR_RA_SVN_MALFORMED_DATA, NULL,
+                                _("Stat response does not match the "
+                                  "request"));
+
+      SVN_ERR(svn_ra_svn__parse_tuple(&item->u.list, "crll", &path,
+                                      &revision, &dirent_list, &lock_list));
+
+      if (dirent_list->nelts != 0)
+        SVN_ERR(parse_stat_dirent(&dirent, dirent_list, iterpool));
+      if (lock_list->nelts != 0)
+        SVN_ERR(parse_lock(lock_list, iterpool, &lock));
+
+      /* Report the caller's path, not the one relative to the server's
+         parent URL. */
+      SVN_ERR(receiver(APR_ARRAY_IDX(paths, i, const char *), revision,
+                       dirent, lock, receiver_baton, iterpool));
+    }
+  svn_pool_destroy(iterpool);
+
+  /* Read the response.  This is so the server would have a chance to
+   * report an error. */
+  SVN_ERR(svn_ra_svn__read_cmd_response(conn, scratch_pool, ""));
+
+  if (i != paths->nelts)
+    return svn_error_create(SVN_ERR_RA_SVN_MALFORMED_DATA, NULL,
+                            _("Stat response does not match the request"));
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+ra_svn_get_files(svn_ra_session_t *session,
+                 const apr_array_header_t *paths,
+                 const apr_array_header_t *revisions,
+                 svn_boolean_t want_props,
+                 svn_ra_file_receiver_t receiver,
+                 void *receiver_baton,
+                 apr_pool_t *scratch_pool)
+{
+  svn_ra_svn__session_baton_t *sess_baton = session->priv;
+  svn_ra_svn_conn_t *conn = sess_baton->conn;
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  apr_pool_t *chunkpool = svn_pool_create(scratch_pool);
+  svn_boolean_t *received;
+  int count;
+  int i;
+
+  /* Send all requests at once, so the server can keep the connection
+     busy while we process the files. */
+  SVN_ERR(svn_ra_svn__write_tuple(conn, scratch_pool, "w((!", "get-files"));
+  for (i = 0; i < paths->nelts; i++)
+    {
+      const char *path = APR_ARRAY_IDX(paths, i, const char *);
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_ra_svn__write_tuple(conn, iterpool, "(c(?r))",
+                                      reparent_path(session, path, iterpool),
+                                      APR_ARRAY_IDX(revisions, i,
+                                                    svn_revnum_t)));
+    }
+  SVN_ERR(svn_ra_svn__write_tuple(conn, scratch_pool, "!)b)", want_props));
+
+  SVN_ERR(handle_auth_request(sess_baton, scratch_pool));
+
+  /* Read and process the files.  Each one is tagged with its index in
+     PATHS, as the server may send them in any order. */
+  received = apr_pcalloc(scratch_pool, paths->nelts * sizeof(*received));
+  for (count = 0; ; count++)
+    {
+      svn_ra_svn__item_t *item;
+      svn_ra_svn__list_t *proplist;
+      apr_uint64_t tag;
+      svn_revnum_t revision;
+      const char *expected_digest;
+      svn_checksum_t *expected_checksum = NULL;
+      svn_checksum_ctx_t *checksum_ctx = NULL;
+      apr_hash_t *props = NULL;
+      svn_stream_t *stream;
+      const char *path;
+
+      svn_pool_clear(iterpool);
+
+      /* Read the next file header or bail out on "done", respectively */
+      SVN_ERR(svn_ra_svn__read_item(conn, iterpool, &item));
+      if (is_done_response(item))
+        break;
+      if (item->kind != SVN_RA_SVN_LIST)
+        return svn_error_create(SVN_ERR_RA_SVN_MALFORMED_DATA, NULL,
+                                _("File entry not a list"));
+
+      SVN_ERR(svn_ra_svn__parse_tuple(&item->u.list, "nr(?c)l", &tag,
+                                      &revision, &expected_digest,
+                                      &proplist));
+      if (tag >= (apr_uint64_t)paths->nelts || received[tag])
+        return svn_error_create(SVN_ERR_RA_SVN_MALFORMED_DATA, NULL,
+                                _("File response does not match the "
+                                  "request"));
+      received[tag] = TRUE;
+      path = APR_ARRAY_IDX(paths, (int)tag, const char *);
+
+      if (want_props)
+        SVN_ERR(svn_ra_svn__parse_proplist(proplist, iterpool, &props));
+
+      if (expected_digest)
+        {
+          SVN_ERR(svn_checksum_parse_hex(&expected_checksum,
+                                         svn_checksum_md5, expected_digest,
+                                         iterpool));
+          checksum_ctx = svn_checksum_ctx_create(svn_checksum_md5,
+                                                 iterpool);
+        }
+
+      SVN_ERR(receiver(&stream, path, revision, props, receiver_baton,
+                       iterpool));
+
+      /* Read the file's contents, even if the receiver didn't want them. */
+      while (1)
+        {
+          svn_pool_clear(chunkpool);
+          SVN_ERR(svn_ra_svn__read_item(conn, chunkpool, &item));
+          if (item->kind != SVN_RA_SVN_STRING)
+            return svn_error_create(SVN_ERR_RA_SVN_MALFORMED_DATA, NULL,
+                                    _("Non-string as part of file "
+                                      "contents"));
+          if (item->u.string.len == 0)
+            break;
+
+          if (!stream)
+            continue;
+
+          if (expected_checksum)
+            SVN_ERR(svn_checksum_update(checksum_ctx, item->u.string.data,
+                                        item->u.string.len));
+
+          SVN_ERR(svn_stream_write(stream, item->u.string.data,
+                                   &item->u.string.len));
+        }
 
-      the_dirent = svn_dirent_create(pool);
-      the_dirent->kind = svn_node_kind_from_word(kind);
-      the_dirent->size = size;/* FIXME: svn_filesize_t */
-      the_dirent->has_props = has_props;
-      the_dirent->created_rev = crev;
-      SVN_ERR(svn_time_from_cstring(&the_dirent->time, cdate, pool));
-      the_dirent->last_author = cauthor;
+      if (stream)
+        {
+          SVN_ERR(svn_stream_close(stream));
 
-      *dirent = the_dirent;
+          if (expected_checksum)
+            {
+              svn_checksum_t *checksum;
+
+              SVN_ERR(svn_checksum_final(&checksum, checksum_ctx,
+                                         iterpool));
+              if (!svn_checksum_match(checksum, expected_checksum))
+                return svn_checksum_mismatch_err(expected_checksum,
+                                                 checksum, iterpool,
+                                                 _("Checksum mismatch for "
+                                                   "'%s'"),
+                                                 path);
+            }
+        }
+    }
+  svn_pool_destroy(chunkpool);
+  svn_pool_destroy(iterpool);
+
+  /* Read the response.  This is so the server would have a chance to
+   * report an error. */
+  SVN_ERR(svn_ra_svn__read_cmd_response(conn, scratch_pool, ""));
+
+  if (count != paths->nelts)
+    return svn_error_create(SVN_ERR_RA_SVN_MALFORMED_DATA, NULL,
+                            _("File response does not match the request"));
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+ra_svn_rev_proplist_range(svn_ra_session_t *session,
+                          svn_revnum_t start_rev,
+                          svn_revnum_t end_rev,
+                          svn_ra_rev_proplist_receiver_t receiver,
+                          void *receiver_baton,
+                          apr_pool_t *scratch_pool)
+{
+  svn_ra_svn__session_baton_t *sess_baton = session->priv;
+  svn_ra_svn_conn_t *conn = sess_baton->conn;
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  svn_revnum_t expected_rev = start_rev;
+
+  SVN_ERR(svn_ra_svn__write_tuple(conn, scratch_pool, "w(rr)",
+                                  "rev-proplist-range", start_rev, end_rev));
+  SVN_ERR(handle_auth_request(sess_baton, scratch_pool));
+
+  /* Read and process the results.  They come in ascending order. */
+  while (1)
+    {
+      svn_ra_svn__item_t *item;
+      svn_ra_svn__list_t *proplist;
+      svn_revnum_t rev;
+      apr_hash_t *props;
+
+      svn_pool_clear(iterpool);
+
+      /* Read the next entry or bail out on "done", respectively */
+      SVN_ERR(svn_ra_svn__read_item(conn, iterpool, &item));
+      if (is_done_response(item))
+        break;
+      if (item->kind != SVN_RA_SVN_LIST)
+        return svn_error_create(SVN_ERR_RA_SVN_MALFORMED_DATA, NULL,
+                                _("Revprop entry not a list"));
+
+      SVN_ERR(svn_ra_svn__parse_tuple(&item->u.list, "rl", &rev, &proplist));
+      if (rev != expected_rev || rev > end_rev)
+        return svn_error_create(SVN_ERR_RA_SVN_MALFORMED_DATA, NULL,
+                                _("Revprop response does not match the "
+                                  "request"));
+
+      SVN_ERR(svn_ra_svn__parse_proplist(proplist, iterpool, &props));
+      SVN_ERR(receiver(rev, props, receiver_baton, iterpool));
+      expected_rev++;
+    }
+  svn_pool_destroy(iterpool);
+
+  /* Read the response.  This is so the server would have a chance to
+   * report an error. */
+  SVN_ERR(svn_ra_svn__read_cmd_response(conn, scratch_pool, ""));
+
+  if (expected_rev != end_rev + 1)
+    return svn_error_create(SVN_ERR_RA_SVN_MALFORMED_DATA, NULL,
+                            _("Revprop response does not match the "
+                              "request"));
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+ra_svn_change_rev_props(svn_ra_session_t *session,
+                        svn_revnum_t rev,
+                        const apr_array_header_t *changes,
+                        apr_pool_t *scratch_pool)
+{
+  svn_ra_svn__session_baton_t *sess_baton = session->priv;
+  svn_ra_svn_conn_t *conn = sess_baton->conn;
+  apr_pool_t *iterpool;
+  int i;
+
+  if (!svn_ra_svn_has_capability(conn, SVN_RA_SVN_CAP_CHANGE_REV_PROPS))
+    return svn_error_create(SVN_ERR_RA_NOT_IMPLEMENTED, NULL, NULL);
+
+  SVN_ERR(svn_ra_svn__write_tuple(conn, scratch_pool, "w(r(!",
+                                  "change-rev-props", rev));
+  iterpool = svn_pool_create(scratch_pool);
+  for (i = 0; i < changes->nelts; i++)
+    {
+      const svn_prop_t *prop = &APR_ARRAY_IDX(changes, i, svn_prop_t);
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_ra_svn__write_tuple(conn, iterpool, "(c(?s))",
+                                      prop->name, prop->value));
+    }
+  svn_pool_destroy(iterpool);
+  SVN_ERR(svn_ra_svn__write_tuple(conn, scratch_pool, "!))"));
+
+  SVN_ERR(handle_auth_request(sess_baton, scratch_pool));
+  SVN_ERR(svn_ra_svn__read_cmd_response(conn, scratch_pool, ""));
+
+  return SVN_NO_ERROR;
+}
+
+
+static svn_error_t *
+ra_svn_get_merge_plan(svn_ra_session_t *session,
+                      svn_mergeinfo_t *source_history,
+                      svn_mergeinfo_t *target_history,
+                      svn_mergeinfo_catalog_t *target_mergeinfo,
+                      const char *source_path,
+                      svn_revnum_t source_peg_rev,
+                      svn_revnum_t source_youngest_rev,
+                      svn_revnum_t source_oldest_rev,
+                      const char *target_path,
+                      svn_revnum_t target_rev,
+                      svn_boolean_t include_descendants,
+                      apr_pool_t *result_pool,
+                      apr_pool_t *scratch_pool)
+{
+  svn_ra_svn__session_baton_t *sess_baton = session->priv;
+  svn_ra_svn_conn_t *conn = sess_baton->conn;
+  const char *source_history_str;
+  const char *target_history_str;
+  svn_ra_svn__list_t *mergeinfo_list;
+  int i;
+
+  source_path = reparent_path(session, source_path, scratch_pool);
+  target_path = reparent_path(session, target_path, scratch_pool);
+  SVN_ERR(svn_ra_svn__write_tuple(conn, scratch_pool, "w(cr(?r)(?r)crbb)",
+                                  "get-merge-plan", source_path,
+                                  source_peg_rev, source_youngest_rev,
+                                  source_oldest_rev, target_path, target_rev,
+                                  target_history != NULL,
+                                  include_descendants));
+
+  SVN_ERR(handle_unsupported_cmd(handle_auth_request(sess_baton,
+                                                     scratch_pool),
+                                 N_("'get-merge-plan' not implemented")));
+  SVN_ERR(svn_ra_svn__read_cmd_response(conn, scratch_pool, "c(?c)l",
+                                        &source_history_str,
+                                        &target_history_str,
+                                        &mergeinfo_list));
+
+  SVN_ERR(svn_mergeinfo_parse(source_history, source_history_str,
+                              result_pool));
+  if (target_history)
+    {
+      if (!target_history_str)
+        return svn_error_create(SVN_ERR_RA_SVN_MALFORMED_DATA, NULL,
+                                _("Missing target history in merge plan"));
+      SVN_ERR(svn_mergeinfo_parse(target_history, target_history_str,
+                                  result_pool));
+    }
+
+  *target_mergeinfo = NULL;
+  if (mergeinfo_list->nelts > 0)
+    {
+      *target_mergeinfo = svn_hash__make(result_pool);
+      for (i = 0; i < mergeinfo_list->nelts; i++)
+        {
+          svn_ra_svn__item_t *elt = &SVN_RA_SVN__LIST_ITEM(mergeinfo_list, i);
+          svn_mergeinfo_t for_path;
+          const char *path;
+          const char *to_parse;
+
+          if (elt->kind != SVN_RA_SVN_LIST)
+            return svn_error_create(SVN_ERR_RA_SVN_MALFORMED_DATA, NULL,
+                                    _("Mergeinfo element is not a list"));
+          SVN_ERR(svn_ra_svn__parse_tuple(&elt->u.list, "cc",
+                                          &path, &to_parse));
+          SVN_ERR(svn_mergeinfo_parse(&for_path, to_parse, result_pool));
+
+          /* The server sends fspaths; we want repository relpaths. */
+          if (path[0] == '/')
+            ++path;
+
+          svn_hash_sets(*target_mergeinfo,
+                        svn_relpath_canonicalize(path, result_pool),
+                        for_path);
+        }
+    }
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+ra_svn_get_changes_summary(svn_ra_session_t *session,
+                           apr_hash_t **changes,
+                           const char *path,
+                           svn_revnum_t start_rev,
+                           svn_revnum_t end_rev,
+                           svn_depth_t depth,
+                           apr_pool_t *result_pool,
+                           apr_pool_t *scratch_pool)
+{
+  svn_ra_svn__session_baton_t *sess_baton = session->priv;
+  svn_ra_svn_conn_t *conn = sess_baton->conn;
+  svn_ra_svn__list_t *list;
+  int i;
+
+  path = reparent_path(session, path, scratch_pool);
+  SVN_ERR(svn_ra_svn__write_tuple(conn, scratch_pool, "w(crrw)",
+                                  "get-changes-summary", path, start_rev,
+                                  end_rev, svn_depth_to_word(depth)));
+
+  SVN_ERR(handle_unsupported_cmd(handle_auth_request(sess_baton,
+                                                     scratch_pool),
+                                 N_("'get-changes-summary' not "
+                                    "implemented")));
+  SVN_ERR(svn_ra_svn__read_cmd_response(conn, scratch_pool, "l", &list));
+
+  *changes = svn_hash__make(result_pool);
+  for (i = 0; i < list->nelts; i++)
+    {
+      svn_ra_svn__item_t *elt = &SVN_RA_SVN__LIST_ITEM(list, i);
+      svn_log_changed_path2_t *change;
+      const char *relpath, *action, *kind_word;
+      svn_boolean_t text_mods, prop_mods;
+
+      if (elt->kind != SVN_RA_SVN_LIST)
+        return svn_error_create(SVN_ERR_RA_SVN_MALFORMED_DATA, NULL,
+                                _("Changes summary element is not a list"));
+      SVN_ERR(svn_ra_svn__parse_tuple(&elt->u.list, "cwwbb", &relpath,
+                                      &action, &kind_word, &text_mods,
+                                      &prop_mods));
+      if (!*action || action[1] || !strchr("ADM", *action))
+        return svn_error_create(SVN_ERR_RA_SVN_MALFORMED_DATA, NULL,
+                                _("Unknown changed path action in "
+                                  "changes summary"));
+
+      change = svn_log_changed_path2_create(result_pool);
+      change->action = *action;
+      change->node_kind = svn_node_kind_from_word(kind_word);
+      change->text_modified = text_mods ? svn_tristate_true
+                                        : svn_tristate_false;
+      change->props_modified = prop_mods ? svn_tristate_true
+                                         : svn_tristate_false;
+      svn_hash_sets(*changes, svn_relpath_canonicalize(relpath, result_pool),
+                    change);
     }
 
   return SVN_NO_ERROR;
@@ -2973,33 +3452,330 @@ static svn_error_t *ra_svn_replay(svn_ra_session_t *session,
 }
 
 
+/* Maximum amount of replay data that we read ahead of the editor drive.
+   Once that much data has been buffered, we stop reading from the
+   connection and let TCP flow control hold back the server. */
+#define REPLAY_READ_AHEAD_SIZE (16 * 1024 * 1024)
+
+/* A bounded, in-memory FIFO between a writer and a reader thread. */
+typedef struct read_ahead_t
+{
+  /* The connection to read the replay data from.  Only the worker thread
+     accesses it while the read-ahead is active. */
+  svn_ra_svn_conn_t *source;
+
+  /* Ring buffer with CAPACITY bytes.  LEN bytes starting at START
+     contain unread data. */
+  char *buffer;
+  apr_size_t capacity;
+  apr_size_t start;
+  apr_size_t len;
+
+  /* Set by the worker when it will not add more data.  ERR is the error
+     it stopped with, to be returned after all buffered data. */
+  svn_boolean_t closed;
+  svn_error_t *err;
+
+  /* Set by the reader when it is no longer interested in any data. */
+  svn_boolean_t aborted;
+
+  /* Runs the read_ahead_job().  Its mutex protects all of the above,
+     except SOURCE, and it gets notified whenever any of them has been
+     changed. */
+  svn_worker_pool__t *workers;
+
+  /* Owns WORKERS. */
+  apr_pool_t *workers_pool;
+} read_ahead_t;
+
+/* Implements svn_write_fn_t for the worker side of the read_ahead_t in
+   BATON.  Block while the buffer is full. */
 static svn_error_t *
-ra_svn_replay_range(svn_ra_session_t *session,
-                    svn_revnum_t start_revision,
-                    svn_revnum_t end_revision,
-                    svn_revnum_t low_water_mark,
-                    svn_boolean_t send_deltas,
-                    svn_ra_replay_revstart_callback_t revstart_func,
-                    svn_ra_replay_revfinish_callback_t revfinish_func,
-                    void *replay_baton,
-                    apr_pool_t *pool)
+read_ahead_write(void *baton,
+                 const char *data,
+                 apr_size_t *len)
+{
+  read_ahead_t *ra = baton;
+  apr_size_t remaining = *len;
+  svn_error_t *err = SVN_NO_ERROR;
+
+  SVN_ERR(svn_worker_pool__lock(ra->workers));
+  while (!err && remaining && !ra->aborted)
+    {
+      apr_size_t end, count;
+
+      while (!err && ra->len == ra->capacity && !ra->aborted)
+        err = svn_worker_pool__wait_for_change(ra->workers);
+
+      if (err || ra->aborted)
+        break;
+
+      /* Copy as much as fits in contiguously. */
+      end = (ra->start + ra->len) % ra->capacity;
+      count = end < ra->start ? ra->start - end : ra->capacity - end;
+      count = MIN(count, remaining);
+
+      memcpy(ra->buffer + end, data, count);
+      ra->len += count;
+      data += count;
+      remaining -= count;
+
+      err = svn_worker_pool__notify(ra->workers);
+    }
+
+  if (!err && ra->aborted)
+    err = svn_error_create(SVN_ERR_CANCELLED, NULL, NULL);
+
+  return svn_error_trace(svn_worker_pool__unlock(ra->workers, err));
+}
+
+/* Implements svn_read_fn_t for the reader side of the read_ahead_t in
+   BATON.  Block until at least some data is available. */
+static svn_error_t *
+read_ahead_read(void *baton,
+                char *buffer,
+                apr_size_t *len)
+{
+  read_ahead_t *ra = baton;
+  svn_error_t *err = SVN_NO_ERROR;
+
+  SVN_ERR(svn_worker_pool__lock(ra->workers));
+
+  while (!err && !ra->len && !ra->closed)
+    err = svn_worker_pool__wait_for_change(ra->workers);
+
+  if (err)
+    {
+      *len = 0;
+    }
+  else if (ra->len)
+    {
+      apr_size_t count = MIN(*len, ra->len);
+      count = MIN(count, ra->capacity - ra->start);
+
+      memcpy(buffer, ra->buffer + ra->start, count);
+      ra->start = (ra->start + count) % ra->capacity;
+      ra->len -= count;
+      *len = count;
+
+      err = svn_worker_pool__notify(ra->workers);
+    }
+  else
+    {
+      /* All data has been read.  Report the worker's error once. */
+      *len = 0;
+      err = ra->err;
+      ra->err = SVN_NO_ERROR;
+    }
+
+  return svn_error_trace(svn_worker_pool__unlock(ra->workers, err));
+}
+
+/* Implements svn_stream_data_available_fn_t for the reader side of the
+   read_ahead_t in BATON. */
+static svn_error_t *
+read_ahead_data_available(void *baton,
+                          svn_boolean_t *data_available)
+{
+  read_ahead_t *ra = baton;
+
+  SVN_ERR(svn_worker_pool__lock(ra->workers));
+  *data_available = ra->len > 0 || ra->closed;
+
+  return svn_error_trace(svn_worker_pool__unlock(ra->workers, SVN_NO_ERROR));
+}
+
+/* Implements svn_write_fn_t for the reader side of the read_ahead_t in
+   BATON.  Pass the data directly to the server.  This is only used to
+   report editor errors and does not interfere with the worker thread
+   reading from the same connection. */
+static svn_error_t *
+read_ahead_reply(void *baton,
+                 const char *data,
+                 apr_size_t *len)
+{
+  read_ahead_t *ra = baton;
+  return svn_error_trace(svn_ra_svn__stream_write(ra->source->stream,
+                                                  data, len));
+}
+
+/* Write ITEM to CONN, using POOL for temporary allocations. */
+static svn_error_t *
+write_item(svn_ra_svn_conn_t *conn,
+           apr_pool_t *pool,
+           const svn_ra_svn__item_t *item)
+{
+  int i;
+
+  switch (item->kind)
+    {
+      case SVN_RA_SVN_NUMBER:
+        return svn_error_trace(svn_ra_svn__write_number(conn, pool,
+                                                        item->u.number));
+
+      case SVN_RA_SVN_STRING:
+        return svn_error_trace(svn_ra_svn__write_string(conn, pool,
+                                                        &item->u.string));
+
+      case SVN_RA_SVN_WORD:
+        return svn_error_trace(svn_ra_svn__write_word(conn, pool,
+                                                      item->u.word.data));
+
+      case SVN_RA_SVN_LIST:
+        SVN_ERR(svn_ra_svn__start_list(conn, pool));
+        for (i = 0; i < item->u.list.nelts; ++i)
+          SVN_ERR(write_item(conn, pool,
+                             &SVN_RA_SVN__LIST_ITEM(&item->u.list, i)));
+        return svn_error_trace(svn_ra_svn__end_list(conn, pool));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Return TRUE, if ITEM is the final command response that terminates
+   a replay-range response. */
+static svn_boolean_t
+is_command_response(const svn_ra_svn__item_t *item)
+{
+  const svn_ra_svn__item_t *first;
+
+  if (item->kind != SVN_RA_SVN_LIST || item->u.list.nelts == 0)
+    return FALSE;
+
+  first = &SVN_RA_SVN__LIST_ITEM(&item->u.list, 0);
+  return first->kind == SVN_RA_SVN_WORD
+      && (   strcmp(first->u.word.data, "success") == 0
+          || strcmp(first->u.word.data, "failure") == 0);
+}
+
+/* Implements svn_worker_pool__func_t.  BATON is the read_ahead_t.  Copy
+   all data items up to and including the final command response from the
+   source connection into the read-ahead buffer. */
+static svn_error_t *
+read_ahead_job(void *baton,
+               apr_pool_t *scratch_pool)
+{
+  read_ahead_t *ra = baton;
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  svn_stream_t *stream = svn_stream_create(ra, scratch_pool);
+  svn_ra_svn_conn_t *target;
+  svn_error_t *err = SVN_NO_ERROR;
+  svn_boolean_t done = FALSE;
+
+  svn_stream_set_write(stream, read_ahead_write);
+  target = svn_ra_svn_create_conn5(NULL, svn_stream_empty(scratch_pool),
+                                   stream, SVN_DELTA_COMPRESSION_LEVEL_NONE,
+                                   0, 0, 0, 0, scratch_pool);
+
+  while (!err && !done)
+    {
+      svn_ra_svn__item_t *item;
+
+      svn_pool_clear(iterpool);
+
+      err = svn_ra_svn__read_item(ra->source, iterpool, &item);
+      if (!err)
+        err = write_item(target, iterpool, item);
+
+      /* Hand the data over frequently enough for the reader to never
+         wait for a full buffer. */
+      done = !err && is_command_response(item);
+      if (!err)
+        err = svn_ra_svn__flush(target, iterpool);
+    }
+
+  svn_pool_destroy(iterpool);
+
+  SVN_ERR(svn_worker_pool__lock(ra->workers));
+  ra->err = err;
+  ra->closed = TRUE;
+
+  return svn_error_trace(svn_worker_pool__unlock(ra->workers,
+                           svn_worker_pool__notify(ra->workers)));
+}
+
+/* Start a worker thread reading the remainder of the current command
+   response from SESS's connection.  Return the connection that provides
+   the buffered data in *CONN and the object to pass to stop_read_ahead
+   in *READ_AHEAD.  Set *READ_AHEAD to NULL if no thread could be
+   started.  Allocate everything in POOL. */
+static svn_error_t *
+start_read_ahead(svn_ra_svn_conn_t **conn,
+                 read_ahead_t **read_ahead,
+                 svn_ra_svn__session_baton_t *sess,
+                 apr_pool_t *pool)
+{
+  read_ahead_t *ra = apr_pcalloc(pool, sizeof(*ra));
+  svn_stream_t *stream = svn_stream_create(ra, pool);
+
+  ra->workers_pool = svn_pool_create(pool);
+  SVN_ERR(svn_worker_pool__create(&ra->workers, 1, ra->workers_pool));
+  if (!ra->workers)
+    {
+      svn_pool_destroy(ra->workers_pool);
+      *read_ahead = NULL;
+      return SVN_NO_ERROR;
+    }
+
+  ra->source = sess->conn;
+  ra->capacity = REPLAY_READ_AHEAD_SIZE;
+  ra->buffer = apr_palloc(pool, ra->capacity);
+
+  svn_stream_set_read2(stream, read_ahead_read, read_ahead_read);
+  svn_stream_set_data_available(stream, read_ahead_data_available);
+  svn_stream_set_write(stream, read_ahead_reply);
+
+  *conn = svn_ra_svn_create_conn5(NULL, stream, stream,
+                                  SVN_DELTA_COMPRESSION_LEVEL_NONE, 0, 0,
+                                  0, 0, pool);
+  (*conn)->capabilities = sess->conn->capabilities;
+
+  SVN_ERR(svn_worker_pool__post(NULL, ra->workers, read_ahead_job, ra,
+                                ra->workers_pool));
+
+  *read_ahead = ra;
+  return SVN_NO_ERROR;
+}
+
+/* Tell the worker thread of RA to stop and wait for it to finish.
+   Return ERR, or the worker's error if ERR is NULL. */
+static svn_error_t *
+stop_read_ahead(read_ahead_t *ra,
+                svn_error_t *err)
+{
+  svn_error_clear(svn_worker_pool__lock(ra->workers));
+  ra->aborted = TRUE;
+  svn_error_clear(svn_worker_pool__notify(ra->workers));
+  svn_error_clear(svn_worker_pool__unlock(ra->workers, SVN_NO_ERROR));
+
+  /* Waits for the job to return. */
+  svn_pool_destroy(ra->workers_pool);
+
+  if (err)
+    {
+      svn_error_clear(ra->err);
+      return err;
+    }
+
+  return ra->err;
+}
+
+/* Read the replay-range response for START_REVISION to END_REVISION from
+   CONN, using the callbacks as in svn_ra_replay_range().  Use POOL for
+   temporary allocations. */
+static svn_error_t *
+replay_range_revisions(svn_ra_svn_conn_t *conn,
+                       svn_revnum_t start_revision,
+                       svn_revnum_t end_revision,
+                       svn_ra_replay_revstart_callback_t revstart_func,
+                       svn_ra_replay_revfinish_callback_t revfinish_func,
+                       void *replay_baton,
+                       apr_pool_t *pool)
 {
-  svn_ra_svn__session_baton_t *sess = session->priv;
   apr_pool_t *iterpool;
   svn_revnum_t rev;
   svn_boolean_t drive_aborted = FALSE;
 
-  /* Complex EDITOR callbacks may rely on client and server parent path
-     being in sync. */
-  SVN_ERR(ensure_exact_server_parent(session, pool));
-  SVN_ERR(svn_ra_svn__write_cmd_replay_range(sess->conn, pool,
-                                             start_revision, end_revision,
-                                             low_water_mark, send_deltas));
-
-  SVN_ERR(handle_unsupported_cmd(handle_auth_request(sess, pool),
-                                 N_("Server doesn't support the "
-                                    "replay-range command")));
-
   iterpool = svn_pool_create(pool);
   for (rev = start_revision; rev <= end_revision; rev++)
     {
@@ -3011,7 +3787,7 @@ ra_svn_replay_range(svn_ra_session_t *session,
 
       svn_pool_clear(iterpool);
 
-      SVN_ERR(svn_ra_svn__read_tuple(sess->conn, iterpool,
+      SVN_ERR(svn_ra_svn__read_tuple(conn, iterpool,
                                      "wl", &word, &list));
 
       if (strcmp(word, "revprops") != 0)
@@ -3030,7 +3806,7 @@ ra_svn_replay_range(svn_ra_session_t *session,
                             &editor, &edit_baton,
                             rev_props,
                             iterpool));
-      SVN_ERR(svn_ra_svn_drive_editor2(sess->conn, iterpool,
+      SVN_ERR(svn_ra_svn_drive_editor2(conn, iterpool,
                                        editor, edit_baton,
                                        &drive_aborted, TRUE));
       /* If drive_editor2() aborted the commit, do NOT try to call
@@ -3047,7 +3823,62 @@ ra_svn_replay_range(svn_ra_session_t *session,
     }
   svn_pool_destroy(iterpool);
 
-  return svn_error_trace(svn_ra_svn__read_cmd_response(sess->conn, pool, ""));
+  return svn_error_trace(svn_ra_svn__read_cmd_response(conn, pool, ""));
+}
+
+static svn_error_t *
+ra_svn_replay_range(svn_ra_session_t *session,
+                    svn_revnum_t start_revision,
+                    svn_revnum_t end_revision,
+                    svn_revnum_t low_water_mark,
+                    svn_boolean_t send_deltas,
+                    svn_ra_replay_revstart_callback_t revstart_func,
+                    svn_ra_replay_revfinish_callback_t revfinish_func,
+                    void *replay_baton,
+                    apr_pool_t *pool)
+{
+  svn_ra_svn__session_baton_t *sess = session->priv;
+
+  /* Complex EDITOR callbacks may rely on client and server parent path
+     being in sync. */
+  SVN_ERR(ensure_exact_server_parent(session, pool));
+  SVN_ERR(svn_ra_svn__write_cmd_replay_range(sess->conn, pool,
+                                             start_revision, end_revision,
+                                             low_water_mark, send_deltas));
+
+  SVN_ERR(handle_unsupported_cmd(handle_auth_request(sess, pool),
+                                 N_("Server doesn't support the "
+                                    "replay-range command")));
+
+  /* The server streams all revisions without waiting for us.  Keep
+     receiving them while the callbacks process earlier revisions, e.g.
+     commit them to some other repository. */
+  if (end_revision > start_revision)
+    {
+      svn_ra_svn_conn_t *conn;
+      read_ahead_t *read_ahead;
+      apr_pool_t *subpool = svn_pool_create(pool);
+      svn_error_t *err;
+
+      SVN_ERR(start_read_ahead(&conn, &read_ahead, sess, subpool));
+      if (read_ahead)
+        {
+          err = replay_range_revisions(conn, start_revision, end_revision,
+                                       revstart_func, revfinish_func,
+                                       replay_baton, subpool);
+          err = stop_read_ahead(read_ahead, err);
+          svn_pool_destroy(subpool);
+
+          return svn_error_trace(err);
+        }
+
+      svn_pool_destroy(subpool);
+    }
+
+  return svn_error_trace(replay_range_revisions(sess->conn,
+                                                start_revision, end_revision,
+                                                revstart_func, revfinish_func,
+                                                replay_baton, pool));
 }
 
 
@@ -3073,6 +3904,11 @@ ra_svn_has_capability(svn_ra_session_t *session,
       {SVN_RA_CAPABILITY_GET_FILE_REVS_REVERSE,
                                        SVN_RA_SVN_CAP_GET_FILE_REVS_REVERSE},
       {SVN_RA_CAPABILITY_LIST, SVN_RA_SVN_CAP_LIST},
+      {SVN_RA_CAPABILITY_LIST_SINCE, SVN_RA_SVN_CAP_LIST_SINCE},
+      {SVN_RA_CAPABILITY_STAT_MANY, SVN_RA_SVN_CAP_STAT_MANY},
+      {SVN_RA_CAPABILITY_GET_FILES, SVN_RA_SVN_CAP_GET_FILES},
+      {SVN_RA_CAPABILITY_REV_PROPLIST_RANGE,
+                                       SVN_RA_SVN_CAP_REV_PROPLIST_RANGE},
 
       {NULL, NULL} /* End of list marker */
   };
@@ -3171,6 +4007,7 @@ ra_svn_list(svn_ra_session_t *session,
             svn_revnum_t revision,
             const apr_array_header_t *patterns,
             svn_depth_t depth,
+            svn_revnum_t since_rev,
             apr_uint32_t dirent_fields,
             svn_ra_dirent_receiver_t receiver,
             void *receiver_baton,
@@ -3188,18 +4025,24 @@ ra_svn_list(svn_ra_session_t *session,
                                   path, revision, svn_depth_to_word(depth)));
   SVN_ERR(send_dirent_fields(conn, dirent_fields, scratch_pool));
 
-  if (patterns)
+  if (patterns || SVN_IS_VALID_REVNUM(since_rev))
     {
       SVN_ERR(svn_ra_svn__write_tuple(conn, scratch_pool, "!)(!"));
 
-      for (i = 0; i < patterns->nelts; ++i)
+      for (i = 0; patterns && i < patterns->nelts; ++i)
         {
           const char *pattern = APR_ARRAY_IDX(patterns, i, const char *);
           SVN_ERR(svn_ra_svn__write_cstring(conn, scratch_pool, pattern));
         }
     }
 
-  SVN_ERR(svn_ra_svn__write_tuple(conn, scratch_pool, "!))"));
+  /* We only get a valid SINCE_REV if the server supports it.  It then
+     also understands that the pattern list above may be a dummy. */
+  if (SVN_IS_VALID_REVNUM(since_rev))
+    SVN_ERR(svn_ra_svn__write_tuple(conn, scratch_pool, "!)(r)b)",
+                                    since_rev, patterns == NULL));
+  else
+    SVN_ERR(svn_ra_svn__write_tuple(conn, scratch_pool, "!))"));
 
   /* Handle auth request by server */
   SVN_ERR(handle_auth_request(sess_baton, scratch_pool));
@@ -3284,7 +4127,14 @@ static const svn_ra__vtable_t ra_svn_vtable = {
   ra_svn_list,
   ra_svn_register_editor_shim_callbacks,
   NULL /* commit_ev2 */,
-  NULL /* replay_range_ev2 */
+  NULL /* replay_range_ev2 */,
+  NULL /* get_blame */,
+  ra_svn_get_merge_plan,
+  ra_svn_stat_many,
+  ra_svn_get_files,
+  ra_svn_rev_proplist_range,
+  ra_svn_change_rev_props,
+  ra_svn_get_changes_summary
 };
 
 svn_error_t *
@@ -0,0 +1,275 @@
+/*
+ * compress.c :  connection-level stream compression for ra_svn
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+
+
+#include <string.h>
+
+#include "svn_types.h"
+#include "svn_error.h"
+#include "svn_string.h"
+#include "svn_ra_svn.h"
+#include "svn_private_config.h"
+
+#include "private/svn_subr_private.h"
+
+#include "ra_svn.h"
+
+/* Once enabled, all data is sent as a sequence of frames.  Each frame
+ * consists of a 4 byte payload length in network byte order followed
+ * by the payload, which is the output of svn__compress_lz4() or
+ * svn__compress_zlib() for at most COMPRESS_FRAME_SIZE bytes of
+ * uncompressed data. */
+#define COMPRESS_FRAME_SIZE 0x10000
+#define COMPRESS_HEADER_SIZE 4
+#define COMPRESS_MAX_PAYLOAD (COMPRESS_FRAME_SIZE + SVN__MAX_ENCODED_UINT_LEN)
+
+/* Baton for a compressing svn_ra_svn__stream_t. */
+typedef struct compress_baton_t {
+  svn_ra_svn__stream_t *stream; /* Inherited stream. */
+  svn_boolean_t use_lz4;        /* LZ4 instead of zlib? */
+  int compression_level;        /* zlib compression level. */
+
+  /* Compressed payload of the last frame read. */
+  svn_stringbuf_t *frame;
+
+  /* Decompressed data not yet returned to the reader. */
+  svn_stringbuf_t *read_buf;
+  apr_size_t read_pos;
+
+  /* Encoded frame not yet completely sent. */
+  svn_stringbuf_t *write_buf;
+  apr_size_t write_pos;
+
+  /* Scratch buffer used while compressing. */
+  svn_stringbuf_t *scratch;
+} compress_baton_t;
+
+/* Read up to LEN - *RECEIVED more bytes from B's inner stream into DATA
+ * at offset *RECEIVED and update *RECEIVED accordingly. */
+static svn_error_t *
+read_some(compress_baton_t *b,
+          unsigned char *data,
+          apr_size_t *received,
+          apr_size_t len)
+{
+  apr_size_t count = len - *received;
+
+  SVN_ERR(svn_ra_svn__stream_read(b->stream, (char *)data + *received,
+                                  &count));
+  *received += count;
+
+  return SVN_NO_ERROR;
+}
+
+/* Read the next frame from B's inner stream and decompress it into
+ * B->READ_BUF. */
+static svn_error_t *
+read_frame(compress_baton_t *b)
+{
+  unsigned char header[COMPRESS_HEADER_SIZE];
+  apr_size_t received = 0;
+  apr_size_t frame_len;
+
+  while (received < COMPRESS_HEADER_SIZE)
+    SVN_ERR(read_some(b, header, &received, COMPRESS_HEADER_SIZE));
+
+  frame_len = ((apr_size_t)header[0] << 24)
+            | ((apr_size_t)header[1] << 16)
+            | ((apr_size_t)header[2] << 8)
+            | ((apr_size_t)header[3]);
+  if (frame_len == 0 || frame_len > COMPRESS_MAX_PAYLOAD)
+    return svn_error_create(SVN_ERR_RA_SVN_MALFORMED_DATA, NULL,
+                            _("Invalid compressed frame size"));
+
+  received = 0;
+  while (received < frame_len)
+    SVN_ERR(read_some(b, (unsigned char *)b->frame->data, &received,
+                      frame_len));
+
+  if (b->use_lz4)
+    SVN_ERR(svn__decompress_lz4(b->frame->data, frame_len, b->read_buf,
+                                COMPRESS_FRAME_SIZE));
+  else
+    SVN_ERR(svn__decompress_zlib(b->frame->data, frame_len, b->read_buf,
+                                 COMPRESS_FRAME_SIZE));
+  b->read_pos = 0;
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_read_fn_t. */
+static svn_error_t *
+compress_read_cb(void *baton, char *buffer, apr_size_t *len)
+{
+  compress_baton_t *b = baton;
+  apr_size_t available;
+
+  /* Empty frames are not sent but be robust against them anyway. */
+  while (b->read_pos == b->read_buf->len)
+    SVN_ERR(read_frame(b));
+
+  available = b->read_buf->len - b->read_pos;
+  if (*len > available)
+    *len = available;
+
+  memcpy(buffer, b->read_buf->data + b->read_pos, *len);
+  b->read_pos += *len;
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_write_fn_t. */
+static svn_error_t *
+compress_write_cb(void *baton, const char *buffer, apr_size_t *len)
+{
+  compress_baton_t *b = baton;
+
+  if (b->write_pos == b->write_buf->len)
+    {
+      apr_size_t payload_len;
+
+      /* Make sure we don't write too much. */
+      if (*len > COMPRESS_FRAME_SIZE)
+        *len = COMPRESS_FRAME_SIZE;
+
+      if (b->use_lz4)
+        SVN_ERR(svn__compress_lz4(buffer, *len, b->scratch));
+      else
+        SVN_ERR(svn__compress_zlib(buffer, *len, b->scratch,
+                                   b->compression_level));
+
+      payload_len = b->scratch->len;
+      svn_stringbuf_setempty(b->write_buf);
+      svn_stringbuf_appendbyte(b->write_buf, (char)(payload_len >> 24));
+      svn_stringbuf_appendbyte(b->write_buf, (char)(payload_len >> 16));
+      svn_stringbuf_appendbyte(b->write_buf, (char)(payload_len >> 8));
+      svn_stringbuf_appendbyte(b->write_buf, (char)(payload_len));
+      svn_stringbuf_appendstr(b->write_buf, b->scratch);
+      b->write_pos = 0;
+    }
+
+  do
+    {
+      apr_size_t tmplen = b->write_buf->len - b->write_pos;
+      SVN_ERR(svn_ra_svn__stream_write(b->stream,
+                                       b->write_buf->data + b->write_pos,
+                                       &tmplen));
+      if (tmplen == 0)
+        {
+          /* The encoded frame will be preserved in B and written out
+             during the next call to this function (which will have the
+             same arguments). */
+          *len = 0;
+          return SVN_NO_ERROR;
+        }
+      b->write_pos += tmplen;
+    }
+  while (b->write_pos < b->write_buf->len);
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements ra_svn_timeout_fn_t. */
+static void
+compress_timeout_cb(void *baton, apr_interval_time_t interval)
+{
+  compress_baton_t *b = baton;
+  svn_ra_svn__stream_timeout(b->stream, interval);
+}
+
+/* Implements svn_stream_data_available_fn_t. */
+static svn_error_t *
+compress_data_available_cb(void *baton, svn_boolean_t *data_available)
+{
+  compress_baton_t *b = baton;
+
+  if (b->read_pos < b->read_buf->len)
+    {
+      *data_available = TRUE;
+      return SVN_NO_ERROR;
+    }
+
+  return svn_error_trace(svn_ra_svn__stream_data_available(b->stream,
+                                                           data_available));
+}
+
+svn_error_t *
+svn_ra_svn__enable_compression(svn_ra_svn_conn_t *conn,
+                               const char *method,
+                               apr_pool_t *scratch_pool)
+{
+  compress_baton_t *b;
+  svn_stream_t *compress_in;
+  svn_stream_t *compress_out;
+
+  if (conn->compressed)
+    return SVN_NO_ERROR;
+
+  /* Flush the connection, as we're about to replace its stream. */
+  SVN_ERR(svn_ra_svn__flush(conn, scratch_pool));
+
+  /* Both sides switch at a point where the other one is waiting for us.
+     Anything already buffered has been sent uncompressed and can't be
+     part of the compressed stream. */
+  if (conn->read_end > conn->read_ptr)
+    return svn_error_create(SVN_ERR_RA_SVN_MALFORMED_DATA, NULL,
+                            _("Unexpected data before enabling "
+                              "compression"));
+
+  b = apr_pcalloc(conn->pool, sizeof(*b));
+  if (strcmp(method, SVN_RA_SVN_CAP_COMPRESS_LZ4) == 0)
+    b->use_lz4 = TRUE;
+  else if (strcmp(method, SVN_RA_SVN_CAP_COMPRESS_ZLIB) == 0)
+    b->use_lz4 = FALSE;
+  else
+    return svn_error_createf(SVN_ERR_BAD_COMPRESSION_METHOD, NULL,
+                             _("Unsupported compression method '%s'"),
+                             method);
+
+  b->compression_level = conn->compression_level > SVN__COMPRESSION_NONE
+                       ? conn->compression_level
+                       : SVN__COMPRESSION_ZLIB_DEFAULT;
+  b->frame = svn_stringbuf_create_ensure(COMPRESS_MAX_PAYLOAD, conn->pool);
+  b->read_buf = svn_stringbuf_create_ensure(COMPRESS_FRAME_SIZE, conn->pool);
+  b->write_buf = svn_stringbuf_create_ensure(COMPRESS_HEADER_SIZE
+                                               + COMPRESS_MAX_PAYLOAD,
+                                             conn->pool);
+  b->scratch = svn_stringbuf_create_ensure(COMPRESS_MAX_PAYLOAD, conn->pool);
+
+  /* Wrap the existing stream. */
+  b->stream = conn->stream;
+
+  compress_in = svn_stream_create(b, conn->pool);
+  compress_out = svn_stream_create(b, conn->pool);
+
+  svn_stream_set_read2(compress_in, compress_read_cb, NULL /* use default */);
+  svn_stream_set_data_available(compress_in, compress_data_available_cb);
+  svn_stream_set_write(compress_out, compress_write_cb);
+
+  conn->stream = svn_ra_svn__stream_create(compress_in, compress_out, b,
+                                           compress_timeout_cb, conn->pool);
+  conn->compressed = TRUE;
+
+  return SVN_NO_ERROR;
+}
@@ -357,6 +357,41 @@ static svn_error_t *ra_svn_apply_textdelta(void *file_baton,
   return SVN_NO_ERROR;
 }
 
+static svn_error_t *
+ra_svn_apply_text_by_checksum(svn_boolean_t *applied,
+                              const svn_delta_editor_t *editor,
+                              void *file_baton,
+                              const svn_checksum_t *sha1_checksum,
+                              apr_pool_t *scratch_pool)
+{
+  ra_svn_baton_t *b = file_baton;
+  ra_svn_edit_baton_t *eb = b->eb;
+  svn_boolean_t result;
+  svn_error_t *err;
+
+  SVN_ERR(check_for_error(eb, scratch_pool));
+  SVN_ERR(svn_ra_svn__write_cmd_apply_text_by_checksum(
+            b->conn, scratch_pool, b->token,
+            svn_checksum_to_cstring(sha1_checksum, scratch_pool)));
+
+  /* Unlike the other edit commands, this one gets an answer.  A failure
+     here may also be an early error report for a previous command.
+     Either way, the consumer now waits for us to abort the edit. */
+  err = svn_ra_svn__read_cmd_response(b->conn, scratch_pool, "b", &result);
+  if (err)
+    {
+      eb->got_status = TRUE;
+      return svn_error_compose_create(
+                    svn_error_trace(err),
+                    svn_error_trace(
+                        svn_ra_svn__write_cmd_abort_edit(b->conn,
+                                                         scratch_pool)));
+    }
+
+  *applied = result;
+  return SVN_NO_ERROR;
+}
+
 static svn_error_t *ra_svn_change_file_prop(void *file_baton,
                                             const char *name,
                                             const svn_string_t *value,
@@ -456,6 +491,8 @@ void svn_ra_svn_get_editor(const svn_delta_editor_t **editor,
   ra_svn_editor->add_file = ra_svn_add_file;
   ra_svn_editor->open_file = ra_svn_open_file;
   ra_svn_editor->apply_textdelta = ra_svn_apply_textdelta;
+  if (svn_ra_svn_has_capability(conn, SVN_RA_SVN_CAP_APPLY_TEXT_BY_CHECKSUM))
+    ra_svn_editor->apply_text_by_checksum = ra_svn_apply_text_by_checksum;
   ra_svn_editor->change_file_prop = ra_svn_change_file_prop;
   ra_svn_editor->close_file = ra_svn_close_file;
   ra_svn_editor->absent_file = ra_svn_absent_file;
@@ -784,6 +821,36 @@ ra_svn_handle_apply_textdelta(svn_ra_svn_conn_t *conn,
   return SVN_NO_ERROR;
 }
 
+static svn_error_t *
+ra_svn_handle_apply_text_by_checksum(svn_ra_svn_conn_t *conn,
+                                     apr_pool_t *pool,
+                                     const svn_ra_svn__list_t *params,
+                                     ra_svn_driver_state_t *ds)
+{
+  svn_string_t *token;
+  ra_svn_token_entry_t *entry;
+  const char *hex_digest;
+  svn_checksum_t *sha1_checksum;
+  svn_boolean_t applied = FALSE;
+
+  /* Parse arguments and look up the token. */
+  SVN_ERR(svn_ra_svn__parse_tuple(params, "sc", &token, &hex_digest));
+  SVN_ERR(lookup_token(ds, token, TRUE, &entry));
+  if (entry->dstream)
+    return svn_error_create(SVN_ERR_RA_SVN_MALFORMED_DATA, NULL,
+                            _("Apply-textdelta already active"));
+  SVN_CMD_ERR(svn_checksum_parse_hex(&sha1_checksum, svn_checksum_sha1,
+                                     hex_digest, pool));
+
+  if (ds->editor->apply_text_by_checksum && sha1_checksum)
+    SVN_CMD_ERR(ds->editor->apply_text_by_checksum(&applied, ds->editor,
+                                                   entry->baton,
+                                                   sha1_checksum, pool));
+
+  return svn_error_trace(svn_ra_svn__write_cmd_response(conn, pool, "b",
+                                                        applied));
+}
+
 static svn_error_t *
 ra_svn_handle_textdelta_chunk(svn_ra_svn_conn_t *conn,
                               apr_pool_t *pool,
@@ -963,6 +1030,7 @@ static const struct {
   { "target-rev",       ra_svn_handle_target_rev },
   { "open-root",        ra_svn_handle_open_root },
   { "close-edit",       ra_svn_handle_close_edit },
+  { "apply-text-by-checksum", ra_svn_handle_apply_text_by_checksum },
   { NULL }
 };
 
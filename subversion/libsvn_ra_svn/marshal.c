@@ -48,6 +48,7 @@
 #include "private/svn_string_private.h"
 #include "private/svn_dep_compat.h"
 #include "private/svn_error_private.h"
+#include "private/svn_metrics.h"
 #include "private/svn_subr_private.h"
 
 #define svn_iswhitespace(c) ((c) == ' ' || (c) == '\n')
@@ -60,11 +61,14 @@
 
 /* We don't use "words" longer than this in our protocol.  The longest word
  * we are currently using is only about 16 chars long but we leave room for
- * longer future capability and command names.  See read_item() to understand
- * why MAX_WORD_LENGTH - 1 should be a multiple of 8.
+ * longer future capability and command names.
  */
 #define MAX_WORD_LENGTH 25
 
+/* The number of digits in APR_UINT64_MAX.  Longer numbers are invalid.
+ */
+#define MAX_NUMBER_LENGTH 20
+
 /* The generic parsers will use the following value to limit the recursion
  * depth to some reasonable value.  The current protocol implementation
  * actually uses only maximum item nesting level of around 5.  So, there is
@@ -190,8 +194,20 @@ svn_ra_svn_conn_t *svn_ra_svn_create_conn5(apr_socket_t *sock,
                                            apr_pool_t *result_pool)
 {
   svn_ra_svn_conn_t *conn;
-  void *mem = apr_palloc(result_pool, sizeof(*conn) + SVN_RA_SVN__PAGE_SIZE);
+  void *mem = apr_palloc(result_pool, sizeof(*conn)
+                                      + SVN_RA_SVN__WRITEBUF_SIZE
+                                      + SVN_RA_SVN__READBUF_SIZE
+                                      + SVN_RA_SVN__PAGE_SIZE);
+
+  /* Put the initial buffers right after the page-aligned connection
+   * struct.  They will only be replaced if the connection serves bulk
+   * commands. */
   conn = (void*)APR_ALIGN((apr_uintptr_t)mem, SVN_RA_SVN__PAGE_SIZE);
+  conn->write_buf = (char *)conn + sizeof(*conn);
+  conn->read_buf = conn->write_buf + SVN_RA_SVN__WRITEBUF_SIZE;
+  conn->write_buf_size = SVN_RA_SVN__WRITEBUF_SIZE;
+  conn->read_buf_size = SVN_RA_SVN__READBUF_SIZE;
+  memset(&conn->stats, 0, sizeof(conn->stats));
 
   assert((sock && !in_stream && !out_stream)
          || (!sock && in_stream && out_stream));
@@ -215,6 +231,7 @@ svn_ra_svn_conn_t *svn_ra_svn_create_conn5(apr_socket_t *sock,
   conn->capabilities = apr_hash_make(result_pool);
   conn->compression_level = compression_level;
   conn->zero_copy_limit = zero_copy_limit;
+  conn->compressed = FALSE;
   conn->pool = result_pool;
 
   if (sock != NULL)
@@ -273,13 +290,25 @@ svn_ra_svn__svndiff_version(svn_ra_svn_conn_t *conn)
   if (svn_ra_svn_compression_level(conn) <= 0)
     return 0;
 
-  /* Prefer SVNDIFF2 over SVNDIFF1. */
+  /* Don't compress twice if the whole connection is compressed already. */
+  if (conn->compressed)
+    return 0;
+
+  /* If stronger compression than the default has been asked for, use
+   * the zlib-based SVNDIFF3 with its more compact instructions. */
+  if (svn_ra_svn_compression_level(conn) > SVN_DELTA_COMPRESSION_LEVEL_DEFAULT
+      && svn_ra_svn_has_capability(conn, SVN_RA_SVN_CAP_SVNDIFF3_ACCEPTED))
+    return 3;
+
+  /* Prefer SVNDIFF2 over SVNDIFF3 and SVNDIFF1. */
   if (svn_ra_svn_has_capability(conn, SVN_RA_SVN_CAP_SVNDIFF2_ACCEPTED))
     return 2;
+  if (svn_ra_svn_has_capability(conn, SVN_RA_SVN_CAP_SVNDIFF3_ACCEPTED))
+    return 3;
   if (svn_ra_svn_has_capability(conn, SVN_RA_SVN_CAP_SVNDIFF1))
     return 1;
 
-  /* The connection does not support SVNDIFF1/2; default to "version 0". */
+  /* The connection does not support SVNDIFF1/2/3; default to "version 0". */
   return 0;
 }
 
@@ -289,6 +318,13 @@ svn_ra_svn__get_pool(svn_ra_svn_conn_t *conn)
   return conn->pool;
 }
 
+const svn_ra_svn__conn_stats_t *
+svn_ra_svn__get_conn_stats(svn_ra_svn_conn_t *conn)
+{
+  conn->stats.write_buf_size = conn->write_buf_size;
+  return &conn->stats;
+}
+
 svn_error_t *
 svn_ra_svn__set_shim_callbacks(svn_ra_svn_conn_t *conn,
                                svn_delta_shim_callbacks_t *shim_callbacks)
@@ -386,6 +422,8 @@ static svn_error_t *writebuf_output(svn_ra_svn_conn_t *conn, apr_pool_t *pool,
         SVN_ERR((session->callbacks->cancel_func)(session->callbacks_baton));
 
       SVN_ERR(svn_ra_svn__stream_write(conn->stream, data, &count));
+      conn->stats.writes++;
+      conn->stats.bytes_written += count;
       if (count == 0)
         {
           if (!subpool)
@@ -430,17 +468,18 @@ static svn_error_t *writebuf_flush(svn_ra_svn_conn_t *conn, apr_pool_t *pool)
 static svn_error_t *writebuf_write(svn_ra_svn_conn_t *conn, apr_pool_t *pool,
                                    const char *data, apr_size_t len)
 {
-  /* data >= 8k is sent immediately */
-  if (len >= sizeof(conn->write_buf) / 2)
+  /* data >= 8k is sent immediately, even if the buffer has grown */
+  if (len >= SVN_RA_SVN__DIRECT_WRITE_SIZE)
     {
       if (conn->write_pos > 0)
         SVN_ERR(writebuf_flush(conn, pool));
 
+      conn->stats.direct_writes++;
       return writebuf_output(conn, pool, data, len);
     }
 
   /* ensure room for the data to add */
-  if (conn->write_pos + len > sizeof(conn->write_buf))
+  if (conn->write_pos + len > conn->write_buf_size)
     SVN_ERR(writebuf_flush(conn, pool));
 
   /* buffer the new data block as well */
@@ -461,7 +500,7 @@ static svn_error_t *writebuf_write(svn_ra_svn_conn_t *conn, apr_pool_t *pool,
 static APR_INLINE svn_error_t *
 writebuf_writechar(svn_ra_svn_conn_t *conn, apr_pool_t *pool, char data)
 {
-  if (conn->write_pos < sizeof(conn->write_buf))
+  if (conn->write_pos < conn->write_buf_size)
   {
     conn->write_buf[conn->write_pos] = data;
     conn->write_pos++;
@@ -475,6 +514,31 @@ writebuf_writechar(svn_ra_svn_conn_t *conn, apr_pool_t *pool, char data)
   }
 }
 
+/* Replace the I/O buffers of CONN with SVN_RA_SVN__BULK_BUF_SIZE sized
+ * ones, keeping all buffered contents.  Do nothing if that has been done
+ * before. */
+static void
+grow_buffers(svn_ra_svn_conn_t *conn)
+{
+  apr_size_t unread = conn->read_end - conn->read_ptr;
+  char *buf;
+
+  if (conn->write_buf_size >= SVN_RA_SVN__BULK_BUF_SIZE)
+    return;
+
+  buf = apr_palloc(conn->pool, SVN_RA_SVN__BULK_BUF_SIZE);
+  memcpy(buf, conn->write_buf, conn->write_pos);
+  conn->write_buf = buf;
+  conn->write_buf_size = SVN_RA_SVN__BULK_BUF_SIZE;
+
+  buf = apr_palloc(conn->pool, SVN_RA_SVN__BULK_BUF_SIZE);
+  memcpy(buf, conn->read_ptr, unread);
+  conn->read_buf = buf;
+  conn->read_ptr = buf;
+  conn->read_end = buf + unread;
+  conn->read_buf_size = SVN_RA_SVN__BULK_BUF_SIZE;
+}
+
 /* --- READ BUFFER MANAGEMENT --- */
 
 /* Read bytes into DATA until either the read buffer is empty or
@@ -509,6 +573,8 @@ static svn_error_t *readbuf_input(svn_ra_svn_conn_t *conn, char *data,
   if (*len == 0)
     return svn_error_create(SVN_ERR_RA_SVN_CONNECTION_CLOSED, NULL, NULL);
   conn->current_in += *len;
+  conn->stats.reads++;
+  conn->stats.bytes_read += *len;
 
   if (session)
     {
@@ -535,10 +601,12 @@ static svn_error_t *readbuf_skip(svn_ra_svn_conn_t *conn, apr_uint64_t len)
     if (len == 0)
       break;
 
-    buflen = sizeof(conn->read_buf);
+    buflen = conn->read_buf_size;
     SVN_ERR(svn_ra_svn__stream_read(conn->stream, conn->read_buf, &buflen));
     if (buflen == 0)
       return svn_error_create(SVN_ERR_RA_SVN_CONNECTION_CLOSED, NULL, NULL);
+    conn->stats.reads++;
+    conn->stats.bytes_read += buflen;
 
     conn->read_end = conn->read_buf + buflen;
     conn->read_ptr = conn->read_buf;
@@ -561,7 +629,7 @@ static svn_error_t *readbuf_fill(svn_ra_svn_conn_t *conn, apr_pool_t *pool)
     SVN_ERR(writebuf_flush(conn, pool));
 
   /* Fill (some of the) buffer. */
-  len = sizeof(conn->read_buf);
+  len = conn->read_buf_size;
   SVN_ERR(readbuf_input(conn, conn->read_buf, &len, pool));
   conn->read_ptr = conn->read_buf;
   conn->read_end = conn->read_buf + len;
@@ -585,10 +653,25 @@ static svn_error_t *readbuf_getchar_skip_whitespace(svn_ra_svn_conn_t *conn,
                                                     apr_pool_t *pool,
                                                     char *result)
 {
-  do
-    SVN_ERR(readbuf_getchar(conn, pool, result));
-  while (svn_iswhitespace(*result));
-  return SVN_NO_ERROR;
+  while (TRUE)
+    {
+      /* Scan what we already have in the buffer before refilling it. */
+      const char *p = conn->read_ptr;
+      const char *end = conn->read_end;
+
+      while (p != end && svn_iswhitespace(*p))
+        ++p;
+
+      if (p != end)
+        {
+          *result = *p;
+          conn->read_ptr = (char *)p + 1;
+          return SVN_NO_ERROR;
+        }
+
+      conn->read_ptr = conn->read_end;
+      SVN_ERR(readbuf_fill(conn, pool));
+    }
 }
 
 /* Read the next LEN bytes from CONN and copy them to *DATA. */
@@ -602,7 +685,7 @@ static svn_error_t *readbuf_read(svn_ra_svn_conn_t *conn, apr_pool_t *pool,
   data = readbuf_drain(conn, data, end);
 
   /* Read large chunks directly into buffer. */
-  while (end - data > (apr_ssize_t)sizeof(conn->read_buf))
+  while (end - data > (apr_ssize_t)conn->read_buf_size)
     {
       SVN_ERR(writebuf_flush(conn, pool));
       count = end - data;
@@ -624,7 +707,7 @@ static svn_error_t *readbuf_read(svn_ra_svn_conn_t *conn, apr_pool_t *pool,
 static svn_error_t *readbuf_skip_leading_garbage(svn_ra_svn_conn_t *conn,
                                                  apr_pool_t *pool)
 {
-  char buf[256];  /* Must be smaller than sizeof(conn->read_buf) - 1. */
+  char buf[256];  /* Must be smaller than conn->read_buf_size - 1. */
   const char *p, *end;
   apr_size_t len;
   svn_boolean_t lparen = FALSE;
@@ -668,7 +751,7 @@ static svn_error_t *write_number(svn_ra_svn_conn_t *conn, apr_pool_t *pool,
 
   /* SVN_INT64_BUFFER_SIZE includes space for a terminating NUL that
    * svn__ui64toa will always append. */
-  if (conn->write_pos + SVN_INT64_BUFFER_SIZE >= sizeof(conn->write_buf))
+  if (conn->write_pos + SVN_INT64_BUFFER_SIZE >= conn->write_buf_size)
     SVN_ERR(writebuf_flush(conn, pool));
 
   written = svn__ui64toa(conn->write_buf + conn->write_pos, number);
@@ -728,13 +811,15 @@ svn_ra_svn__write_ncstring(svn_ra_svn_conn_t *conn,
 {
   /* Apart from LEN bytes of string contents, we need room for a number,
      a colon and a space. */
-  apr_size_t max_fill = sizeof(conn->write_buf) - SVN_INT64_BUFFER_SIZE - 2;
+  apr_size_t max_fill = conn->write_buf_size - SVN_INT64_BUFFER_SIZE - 2;
 
   /* In most cases, there is enough left room in the WRITE_BUF
      the we can serialize directly into it.  On platforms with
      segmented memory, LEN might actually be close to APR_SIZE_MAX.
-     Blindly doing arithmetic on it might cause an overflow. */
-  if ((len <= max_fill) && (conn->write_pos <= max_fill - len))
+     Blindly doing arithmetic on it might cause an overflow.
+     Large strings go through writebuf_write() to be sent directly. */
+  if ((len < SVN_RA_SVN__DIRECT_WRITE_SIZE) && (len <= max_fill)
+      && (conn->write_pos <= max_fill - len))
     {
       /* Quick path. */
       conn->write_pos = write_ncstring_quick(conn->write_buf
@@ -830,7 +915,7 @@ svn_error_t *
 svn_ra_svn__start_list(svn_ra_svn_conn_t *conn,
                        apr_pool_t *pool)
 {
-  if (conn->write_pos + 2 <= sizeof(conn->write_buf))
+  if (conn->write_pos + 2 <= conn->write_buf_size)
     {
       conn->write_buf[conn->write_pos] = '(';
       conn->write_buf[conn->write_pos+1] = ' ';
@@ -845,7 +930,7 @@ svn_error_t *
 svn_ra_svn__end_list(svn_ra_svn_conn_t *conn,
                      apr_pool_t *pool)
 {
-  if (conn->write_pos + 2 <= sizeof(conn->write_buf))
+  if (conn->write_pos + 2 <= conn->write_buf_size)
   {
     conn->write_buf[conn->write_pos] = ')';
     conn->write_buf[conn->write_pos+1] = ' ';
@@ -990,15 +1075,17 @@ write_tuple_string_opt_list(svn_ra_svn_conn_t *conn,
 
   /* If this how far we can fill the WRITE_BUF with string data and still
      guarantee that the length info will fit in as well. */
-  max_fill = sizeof(conn->write_buf)
+  max_fill = conn->write_buf_size
            - 2                       /* open list */
            - SVN_INT64_BUFFER_SIZE   /* string length + separator */
            - 2;                      /* close list */
 
    /* On platforms with segmented memory, STR->LEN might actually be
       close to APR_SIZE_MAX.  Blindly doing arithmetic on it might
-      cause an overflow. */
-  if ((str->len <= max_fill) && (conn->write_pos <= max_fill - str->len))
+      cause an overflow.  Large strings take the fallback path that sends
+      them directly. */
+  if ((str->len < SVN_RA_SVN__DIRECT_WRITE_SIZE) && (str->len <= max_fill)
+      && (conn->write_pos <= max_fill - str->len))
     {
       /* Quick path. */
       /* Open list. */
@@ -1314,20 +1401,54 @@ static svn_error_t *read_item(svn_ra_svn_conn_t *conn, apr_pool_t *pool,
   if (svn_ctype_isdigit(c))
     {
       /* It's a number or a string.  Read the number part, either way. */
+      svn_boolean_t parsed = FALSE;
+
       val = c - '0';
-      while (1)
+      if (conn->read_end - conn->read_ptr > MAX_NUMBER_LENGTH)
         {
-          apr_uint64_t prev_val = val;
-          SVN_ERR(readbuf_getchar(conn, pool, &c));
-          if (!svn_ctype_isdigit(c))
-            break;
-          val = val * 10 + (c - '0');
-          /* val wrapped past maximum value? */
-          if ((prev_val >= (APR_UINT64_MAX / 10))
-              && (val < APR_UINT64_MAX - 10))
-            return svn_error_create(SVN_ERR_RA_SVN_MALFORMED_DATA, NULL,
-                                    _("Number is larger than maximum"));
+          /* Fast path: the longest number without leading zeros and the
+           * character following it are in the read buffer.  Parse it in
+           * place, looking at no more than those characters. */
+          const char *p = conn->read_ptr;
+          const char *end = p + MAX_NUMBER_LENGTH + 1;
+          apr_uint64_t fast_val = val;
+          while (p < end && svn_ctype_isdigit(*p))
+            {
+              apr_uint64_t prev_val = fast_val;
+              fast_val = fast_val * 10 + (*p++ - '0');
+              /* val wrapped past maximum value? */
+              if ((prev_val >= (APR_UINT64_MAX / 10))
+                  && (fast_val < APR_UINT64_MAX - 10))
+                return svn_error_create(SVN_ERR_RA_SVN_MALFORMED_DATA, NULL,
+                                        _("Number is larger than maximum"));
+            }
+
+          /* Leading zeros may make the number longer than that.  Leave
+           * those to the slow path below. */
+          if (p < end)
+            {
+              val = fast_val;
+              c = *p++;
+              conn->read_ptr = (char *)p;
+              parsed = TRUE;
+            }
         }
+
+      if (!parsed)
+        while (1)
+          {
+            apr_uint64_t prev_val = val;
+            SVN_ERR(readbuf_getchar(conn, pool, &c));
+            if (!svn_ctype_isdigit(c))
+              break;
+            val = val * 10 + (c - '0');
+            /* val wrapped past maximum value? */
+            if ((prev_val >= (APR_UINT64_MAX / 10))
+                && (val < APR_UINT64_MAX - 10))
+              return svn_error_create(SVN_ERR_RA_SVN_MALFORMED_DATA, NULL,
+                                      _("Number is larger than maximum"));
+          }
+
       if (c == ':')
         {
           /* It's a string. */
@@ -1344,44 +1465,55 @@ static svn_error_t *read_item(svn_ra_svn_conn_t *conn, apr_pool_t *pool,
   else if (svn_ctype_isalpha(c))
     {
       /* It's a word.  Read it into a buffer of limited size. */
-      char *buffer = apr_palloc(pool, MAX_WORD_LENGTH + 1);
-      char *end = buffer + MAX_WORD_LENGTH;
-      char *p = buffer + 1;
+      char *buffer;
+      char *p;
 
-      buffer[0] = c;
       if (conn->read_ptr + MAX_WORD_LENGTH <= conn->read_end)
         {
-          /* Fast path: we can simply take a chunk from the read
-           * buffer and inspect it with no overflow checks etc.
-           *
-           * Copying these 24 bytes unconditionally is also faster
-           * than a variable-sized memcpy.  Note that P is at BUFFER[1].
-           */
-          memcpy(p, conn->read_ptr, MAX_WORD_LENGTH - 1);
-          *end = 0;
-
-          /* This will terminate at P == END because of *END == NUL. */
-          while (svn_ctype_isalnum(*p) || *p == '-')
-            ++p;
+          /* Fast path: the longest valid word is in the read buffer.
+           * Find its end in place and allocate just what it needs. */
+          const char *start = conn->read_ptr;
+          const char *end = start + MAX_WORD_LENGTH - 1;
+          const char *q = start;
+          apr_size_t len;
+
+          while (q != end && (svn_ctype_isalnum(*q) || *q == '-'))
+            ++q;
+
+          if (q == end)
+            return svn_error_create(SVN_ERR_RA_SVN_MALFORMED_DATA, NULL,
+                                    _("Word is too long"));
+
+          len = q - start;
+          buffer = apr_palloc(pool, len + 2);
+          buffer[0] = c;
+          memcpy(buffer + 1, start, len);
+          p = buffer + 1 + len;
 
           /* Only now do we mark data as actually read. */
-          conn->read_ptr += p - buffer;
+          *p = *q;
+          conn->read_ptr = (char *)q + 1;
         }
       else
         {
           /* Slow path. Byte-by-byte copying and checking for
            * input and output buffer boundaries. */
+          char *end;
+
+          buffer = apr_palloc(pool, MAX_WORD_LENGTH + 1);
+          end = buffer + MAX_WORD_LENGTH;
+          buffer[0] = c;
           for (p = buffer + 1; p != end; ++p)
             {
               SVN_ERR(readbuf_getchar(conn, pool, p));
               if (!svn_ctype_isalnum(*p) && *p != '-')
                 break;
             }
-        }
 
-      if (p == end)
-        return svn_error_create(SVN_ERR_RA_SVN_MALFORMED_DATA, NULL,
-                                _("Word is too long"));
+          if (p == end)
+            return svn_error_create(SVN_ERR_RA_SVN_MALFORMED_DATA, NULL,
+                                    _("Word is too long"));
+        }
 
       c = *p;
       *p = '\0';
@@ -1937,6 +2069,13 @@ svn_ra_svn__handle_command(svn_boolean_t *terminate,
   command = svn_hash_gets(cmd_hash, cmdname);
   if (command)
     {
+      apr_time_t start = apr_time_now();
+
+      /* Bulk commands send many small items.  Coalesce them into fewer,
+       * larger writes for the rest of the session. */
+      if (command->bulk)
+        grow_buffers(conn);
+
       /* Call the standard command handler.
        * If that is not set, then this is a lecagy API call and we invoke
        * the legacy command handler. */
@@ -1959,6 +2098,14 @@ svn_ra_svn__handle_command(svn_boolean_t *terminate,
        * processing quickly if we may have truncated data. */
       err = svn_error_compose_create(check_io_limits(conn), err);
 
+      /* Only known commands get recorded, so the number of distinct
+       * label values is bounded. */
+      svn_metrics__observe(
+          svn_metrics__histogram("svn_ra_svn_command_duration_seconds",
+                                 svn_metrics__label("command", cmdname, pool),
+                                 "Time spent processing ra_svn commands."),
+          apr_time_now() - start);
+
       *terminate = command->terminate;
     }
   else
@@ -2250,6 +2397,20 @@ svn_ra_svn__write_cmd_apply_textdelta(svn_ra_svn_conn_t *conn,
   return SVN_NO_ERROR;
 }
 
+svn_error_t *
+svn_ra_svn__write_cmd_apply_text_by_checksum(svn_ra_svn_conn_t *conn,
+                                             apr_pool_t *pool,
+                                             const svn_string_t *token,
+                                             const char *sha1_checksum)
+{
+  SVN_ERR(writebuf_write_literal(conn, pool, "( apply-text-by-checksum ( "));
+  SVN_ERR(write_tuple_string(conn, pool, token));
+  SVN_ERR(write_tuple_cstring(conn, pool, sha1_checksum));
+  SVN_ERR(writebuf_write_literal(conn, pool, ") ) "));
+
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *
 svn_ra_svn__write_cmd_close_edit(svn_ra_svn_conn_t *conn,
                                  apr_pool_t *pool)
@@ -2848,7 +3009,7 @@ svn_ra_svn__write_data_log_changed_path(svn_ra_svn_conn_t *conn,
   apr_size_t flags_len = flags_str->len;
 
   /* How much buffer space can we use for non-string data (worst case)? */
-  apr_size_t max_fill = sizeof(conn->write_buf)
+  apr_size_t max_fill = conn->write_buf_size
                       - 2                          /* list start */
                       - 2 - SVN_INT64_BUFFER_SIZE  /* path */
                       - 2                          /* action */
@@ -67,6 +67,14 @@ typedef svn_error_t *(*ra_svn_block_handler_t)(svn_ra_svn_conn_t *conn,
 #define SVN_RA_SVN__READBUF_SIZE (4 * SVN_RA_SVN__PAGE_SIZE)
 #define SVN_RA_SVN__WRITEBUF_SIZE (4 * SVN_RA_SVN__PAGE_SIZE)
 
+/* The size that both buffers grow to once the connection has served a
+ * bulk command, i.e. one that streams many small items. */
+#define SVN_RA_SVN__BULK_BUF_SIZE (64 * SVN_RA_SVN__PAGE_SIZE)
+
+/* Strings of at least this size bypass the write buffer, independent of
+ * its current size. */
+#define SVN_RA_SVN__DIRECT_WRITE_SIZE (SVN_RA_SVN__WRITEBUF_SIZE / 2)
+
 /* Create forward reference */
 typedef struct svn_ra_svn__session_baton_t svn_ra_svn__session_baton_t;
 
@@ -74,13 +82,19 @@ typedef struct svn_ra_svn__session_baton_t svn_ra_svn__session_baton_t;
  * first few fields during setup and cleanup. */
 struct svn_ra_svn_conn_st {
 
-  /* I/O buffers */
-  char write_buf[SVN_RA_SVN__WRITEBUF_SIZE];
-  char read_buf[SVN_RA_SVN__READBUF_SIZE];
+  /* I/O buffers.  They start with SVN_RA_SVN__WRITEBUF_SIZE and
+   * SVN_RA_SVN__READBUF_SIZE bytes, respectively, and may grow later. */
+  char *write_buf;
+  char *read_buf;
+  apr_size_t write_buf_size;
+  apr_size_t read_buf_size;
   char *read_ptr;
   char *read_end;
   apr_size_t write_pos;
 
+  /* Transfer statistics over the lifetime of the connection */
+  svn_ra_svn__conn_stats_t stats;
+
   svn_ra_svn__stream_t *stream;
   svn_ra_svn__session_baton_t *session;
 #ifdef SVN_HAVE_SASL
@@ -115,6 +129,9 @@ struct svn_ra_svn_conn_st {
   int compression_level;
   apr_size_t zero_copy_limit;
 
+  /* Has the stream been wrapped by svn_ra_svn__enable_compression()? */
+  svn_boolean_t compressed;
+
   /* who's on the other side of the connection? */
   char *remote_ip;
 
@@ -37,6 +37,7 @@
 #include "svn_ctype.h"
 #include "private/svn_atomic.h"
 #include "private/svn_fspath.h"
+#include "private/svn_metrics.h"
 #include "private/svn_repos_private.h"
 #include "private/svn_sorts_private.h"
 #include "private/svn_subr_private.h"
@@ -130,6 +131,9 @@ static svn_object_pool__t *authz_pool = NULL;
 static svn_object_pool__t *filtered_pool = NULL;
 static svn_atomic_t authz_pool_initialized = FALSE;
 
+/* Directory to store compiled authz models in.  NULL if disabled. */
+static const char *authz_cache_dir = NULL;
+
 /* Implements svn_atomic__err_init_func_t. */
 static svn_error_t *
 synchronized_authz_initialize(void *baton, apr_pool_t *pool)
@@ -155,6 +159,12 @@ svn_repos_authz_initialize(apr_pool_t *pool)
                                                NULL, pool));
 }
 
+void
+svn_repos__authz_set_cache_dir(const char *dir)
+{
+  authz_cache_dir = dir;
+}
+
 /* Return a combination of AUTHZ_KEY and GROUPS_KEY, allocated in RESULT_POOL.
  * GROUPS_KEY may be NULL.  This is the key for the AUTHZ_POOL.
  */
@@ -967,6 +977,20 @@ create_user_authz(authz_full_t *authz,
 
 /*** Lookup. ***/
 
+/* Snapshot of a lookup_state_t after following some parent path of its
+ * PARENT_PATH. */
+typedef struct lookup_level_t
+{
+  /* Length of the PARENT_PATH prefix that this snapshot is for. */
+  apr_size_t path_len;
+
+  /* Copy of CURRENT at this path. */
+  apr_array_header_t *nodes;
+
+  /* PARENT_RIGHTS at this path. */
+  limited_rights_t rights;
+} lookup_level_t;
+
 /* Reusable lookup state object. It is easy to pass to functions and
  * recycling it between lookups saves significant setup costs. */
 typedef struct lookup_state_t
@@ -992,6 +1016,14 @@ typedef struct lookup_state_t
   /* Rights that apply at PARENT_PATH, if PARENT_PATH is not empty. */
   limited_rights_t parent_rights;
 
+  /* lookup_level_t for every non-empty parent path of PARENT_PATH and
+   * PARENT_PATH itself, outermost first.  Only the first DEPTH entries
+   * are valid.  The others keep their NODES arrays to be reused.
+   * This allows a lookup to continue from the longest parent path that
+   * it has in common with the previous lookup. */
+  apr_array_header_t *levels;
+  int depth;
+
 } lookup_state_t;
 
 /* Constructor for lookup_state_t. */
@@ -1015,9 +1047,39 @@ create_lookup_state(apr_pool_t *result_pool)
    * above applies. */
   state->parent_path = svn_stringbuf_create_ensure(200, result_pool);
 
+  state->levels = apr_array_make(result_pool, 8, sizeof(lookup_level_t));
+  state->depth = 0;
+
   return state;
 }
 
+/* Record the current PARENT_PATH, CURRENT and PARENT_RIGHTS of STATE as
+ * its next level. */
+static void
+push_lookup_level(lookup_state_t *state)
+{
+  lookup_level_t *level;
+
+  if (state->depth == state->levels->nelts)
+    {
+      level = apr_array_push(state->levels);
+      level->nodes = apr_array_make(state->levels->pool,
+                                    state->current->nelts,
+                                    sizeof(node_t *));
+    }
+  else
+    {
+      level = &APR_ARRAY_IDX(state->levels, state->depth, lookup_level_t);
+      apr_array_clear(level->nodes);
+    }
+
+  level->path_len = state->parent_path->len;
+  level->rights = state->parent_rights;
+  apr_array_cat(level->nodes, state->current);
+
+  ++state->depth;
+}
+
 /* Clear the current contents of STATE and re-initialize it for ROOT.
  * Check whether we can reuse a previous parent path lookup to shorten
  * the current PATH walk.  Return the full or remaining portion of
@@ -1027,19 +1089,36 @@ init_lockup_state(lookup_state_t *state,
                   node_t *root,
                   const char *path)
 {
-  apr_size_t len = strlen(path);
-  if (   (len > state->parent_path->len)
-      && state->parent_path->len
-      && (path[state->parent_path->len] == '/')
-      && !memcmp(path, state->parent_path->data, state->parent_path->len))
-    {
-      /* The PARENT_PATH of the previous lookup is actually a parent path
-       * of PATH.  The CURRENT node list already matches the parent path
-       * and we only have to set the correct rights info. */
-      state->rights = state->parent_rights;
+  apr_size_t common = 0;
+  int i;
+
+  /* How far does PATH follow the PARENT_PATH of the previous lookup? */
+  while (   common < state->parent_path->len
+         && path[common] == state->parent_path->data[common])
+    ++common;
 
-      /* Tell the caller where to proceed. */
-      return path + state->parent_path->len;
+  /* Find the deepest parent path of the previous lookup that is also
+   * a parent path of PATH. */
+  for (i = state->depth; i > 0; --i)
+    {
+      lookup_level_t *level = &APR_ARRAY_IDX(state->levels, i - 1,
+                                             lookup_level_t);
+      if (level->path_len <= common && path[level->path_len] == '/')
+        {
+          /* Continue from there.  We only have to restore the node list
+           * and the rights info for that parent path. */
+          state->depth = i;
+          state->parent_path->len = level->path_len;
+          state->parent_path->data[level->path_len] = '\0';
+
+          apr_array_clear(state->current);
+          apr_array_cat(state->current, level->nodes);
+          state->parent_rights = level->rights;
+          state->rights = state->parent_rights;
+
+          /* Tell the caller where to proceed. */
+          return path + level->path_len;
+        }
     }
 
   /* Start lookup at ROOT for the full PATH. */
@@ -1063,6 +1142,7 @@ init_lockup_state(lookup_state_t *state,
 
   svn_stringbuf_setempty(state->parent_path);
   svn_stringbuf_setempty(state->scratch_pad);
+  state->depth = 0;
 
   return path;
 }
@@ -1359,6 +1439,7 @@ lookup(lookup_state_t *state,
 
           /* In STATE, PARENT_PATH, PARENT_RIGHTS and CURRENT are now in sync. */
           state->parent_rights = state->rights;
+          push_lookup_level(state);
         }
     }
 
@@ -1377,6 +1458,24 @@ lookup(lookup_state_t *state,
 
 /*** The authz data structure. ***/
 
+/* Number of entries in authz_user_rules_t's DECISIONS cache.
+ * Must be a power of two. */
+#define DECISION_CACHE_SIZE 1024
+
+/* A cached result of a path rule tree lookup. */
+typedef struct authz_decision_t
+{
+  /* The path as passed to the lookup.  NULL for unused entries. */
+  svn_stringbuf_t *path;
+
+  /* Parameters of the lookup. */
+  authz_access_t required;
+  svn_boolean_t recursive;
+
+  /* Result of the lookup. */
+  svn_boolean_t granted;
+} authz_decision_t;
+
 /* An entry in svn_authz_t's USER_RULES cache.  All members must be
  * allocated in the POOL and the latter has to be cleared / destroyed
  * before overwriting the entries' contents.
@@ -1401,6 +1500,10 @@ struct authz_user_rules_t
   /* Reusable lookup state instance. */
   lookup_state_t *lookup_state;
 
+  /* Direct-mapped cache of recent lookup results, indexed by a hash of
+   * the path.  Allocated upon first use. */
+  authz_decision_t *decisions;
+
   /* Pool from which all data within this struct got allocated.
    * Can be destroyed or cleaned up with no further side-effects. */
   apr_pool_t *pool;
@@ -1459,6 +1562,7 @@ get_user_rules(svn_authz_t *authz,
   authz->filtered->repository = apr_pstrdup(pool, repos_name);
   authz->filtered->user = user ? apr_pstrdup(pool, user) : NULL;
   authz->filtered->lookup_state = create_lookup_state(pool);
+  authz->filtered->decisions = NULL;
   authz->filtered->root = NULL;
 
   svn_authz__get_global_rights(&authz->filtered->global_rights,
@@ -1529,6 +1633,75 @@ filter_tree(svn_authz_t *authz,
 
 
 
+/* Return the path of the compiled authz model file for AUTHZ_ID in
+   AUTHZ_CACHE_DIR, allocated in RESULT_POOL. */
+static const char *
+authz_cache_path(const svn_membuf_t *authz_id,
+                 apr_pool_t *result_pool)
+{
+  static const char hex[] = "0123456789abcdef";
+  const unsigned char *data = authz_id->data;
+  char *name = apr_palloc(result_pool, 2 * authz_id->size + 1);
+  apr_size_t i;
+
+  for (i = 0; i < authz_id->size; ++i)
+    {
+      name[2 * i] = hex[data[i] >> 4];
+      name[2 * i + 1] = hex[data[i] & 0xf];
+    }
+  name[2 * i] = '\0';
+
+  return svn_dirent_join(authz_cache_dir, name, result_pool);
+}
+
+/* Like svn_authz__parse() but, if AUTHZ_CACHE_DIR is set, try loading an
+   already compiled model for AUTHZ_ID from there first.  If there is none,
+   parse RULES and GROUPS and store the result for other processes.
+   The file cache is optional and failures to use it are ignored. */
+static svn_error_t *
+parse_authz(authz_full_t **authz_p,
+            const svn_membuf_t *authz_id,
+            svn_stream_t *rules,
+            svn_stream_t *groups,
+            apr_pool_t *result_pool,
+            apr_pool_t *scratch_pool)
+{
+  const char *cache_path = NULL;
+  svn_stringbuf_t *serialized;
+  svn_error_t *err;
+
+  if (authz_cache_dir)
+    {
+      cache_path = authz_cache_path(authz_id, scratch_pool);
+      err = svn_stringbuf_from_file2(&serialized, cache_path, scratch_pool);
+      if (!err)
+        err = svn_authz__deserialize(authz_p, serialized->data,
+                                     serialized->len, result_pool);
+      if (!err)
+        return SVN_NO_ERROR;
+
+      svn_error_clear(err);
+    }
+
+  SVN_ERR(svn_authz__parse(authz_p, rules, groups, result_pool,
+                           scratch_pool));
+
+  if (cache_path)
+    {
+      /* Writing atomically makes sure that concurrent readers either see
+         all of the data or none of it. */
+      err = svn_authz__serialize(&serialized, *authz_p, scratch_pool,
+                                 scratch_pool);
+      if (!err)
+        err = svn_io_write_atomic2(cache_path, serialized->data,
+                                   serialized->len, NULL, FALSE,
+                                   scratch_pool);
+      svn_error_clear(err);
+    }
+
+  return SVN_NO_ERROR;
+}
+
 /* Read authz configuration data from PATH into *AUTHZ_P, allocated in
    RESULT_POOL.  Return the cache key in *AUTHZ_ID.  If GROUPS_PATH is set,
    use the global groups parsed from it.  Use SCRATCH_POOL for temporary
@@ -1586,8 +1759,8 @@ authz_read(authz_full_t **authz_p,
 
           /* Parse the configuration(s) and construct the full authz model
            * from it. */
-          err = svn_authz__parse(authz_p, rules_stream, groups_stream,
-                                item_pool, scratch_pool);
+          err = parse_authz(authz_p, *authz_id, rules_stream,
+                            groups_stream, item_pool, scratch_pool);
           if (err != SVN_NO_ERROR)
             {
               /* That pool would otherwise never get destroyed. */
@@ -1611,9 +1784,9 @@ authz_read(authz_full_t **authz_p,
     {
       /* Parse the configuration(s) and construct the full authz model from
        * it. */
-      err = svn_error_quick_wrapf(svn_authz__parse(authz_p, rules_stream,
-                                                   groups_stream,
-                                                   result_pool, scratch_pool),
+      err = svn_error_quick_wrapf(parse_authz(authz_p, *authz_id,
+                                              rules_stream, groups_stream,
+                                              result_pool, scratch_pool),
                                   "Error while parsing authz file: '%s':",
                                   path);
     }
@@ -1665,22 +1838,22 @@ svn_repos_authz_parse(svn_authz_t **authz_p, svn_stream_t *stream,
   return SVN_NO_ERROR;
 }
 
-svn_error_t *
-svn_repos_authz_check_access(svn_authz_t *authz, const char *repos_name,
-                             const char *path, const char *user,
-                             svn_repos_authz_access_t required_access,
-                             svn_boolean_t *access_granted,
-                             apr_pool_t *pool)
+/* Set *ACCESS_GRANTED to TRUE, iff the user that RULES of AUTHZ got
+ * filtered for has the REQUIRED access to PATH, recursively if RECURSIVE
+ * is set.  PATH may be NULL, see svn_repos_authz_check_access().  Use
+ * SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+check_access(svn_boolean_t *access_granted,
+             svn_authz_t *authz,
+             authz_user_rules_t *rules,
+             const char *path,
+             authz_access_t required,
+             svn_boolean_t recursive,
+             apr_pool_t *scratch_pool)
 {
-  const authz_access_t required =
-    ((required_access & svn_authz_read ? authz_access_read_flag : 0)
-     | (required_access & svn_authz_write ? authz_access_write_flag : 0));
-
-  /* Pick or create the suitable pre-filtered path rule tree. */
-  authz_user_rules_t *rules = get_user_rules(
-      authz,
-      (repos_name ? repos_name : AUTHZ_ANY_REPOSITORY),
-      user);
+  apr_size_t path_len;
+  authz_decision_t *decision;
 
   /* In many scenarios, users have uniform access to a repository
    * (blanket access or no access at all).
@@ -1707,23 +1880,139 @@ svn_repos_authz_check_access(svn_authz_t *authz, const char *repos_name,
       return SVN_NO_ERROR;
     }
 
+  /* Did we check the same path recently?  Callers like log tend to ask
+   * for the same paths over and over again. */
+  if (!rules->decisions)
+    rules->decisions = apr_pcalloc(rules->pool, DECISION_CACHE_SIZE
+                                                * sizeof(*rules->decisions));
+
+  path_len = strlen(path);
+  decision = &rules->decisions[svn__fnv1a_32(path, path_len)
+                               & (DECISION_CACHE_SIZE - 1)];
+  if (   decision->path
+      && decision->required == required
+      && decision->recursive == recursive
+      && decision->path->len == path_len
+      && !memcmp(decision->path->data, path, path_len))
+    {
+      *access_granted = decision->granted;
+      return SVN_NO_ERROR;
+    }
+
   /* Rules tree lookup */
 
   /* Did we already filter the data model? */
   if (!rules->root)
-    SVN_ERR(filter_tree(authz, pool));
+    SVN_ERR(filter_tree(authz, scratch_pool));
 
-  /* Re-use previous lookup results, if possible. */
-  path = init_lockup_state(authz->filtered->lookup_state,
-                           authz->filtered->root, path);
+  /* Determine the granted access for the requested path.
+   * Re-use previous lookup results, if possible.
+   * PATH does not need to be normalized for lockup(). */
+  *access_granted = lookup(rules->lookup_state,
+                           init_lockup_state(rules->lookup_state,
+                                             rules->root, path),
+                           required, recursive, scratch_pool);
+
+  /* Remember the result. */
+  if (decision->path)
+    svn_stringbuf_set(decision->path, path);
+  else
+    decision->path = svn_stringbuf_create(path, rules->pool);
+
+  decision->required = required;
+  decision->recursive = recursive;
+  decision->granted = *access_granted;
+
+  return SVN_NO_ERROR;
+}
+
+/* Return the authz_access_t flags for REQUIRED_ACCESS. */
+static authz_access_t
+required_rights(svn_repos_authz_access_t required_access)
+{
+  return ((required_access & svn_authz_read ? authz_access_read_flag : 0)
+          | (required_access & svn_authz_write ? authz_access_write_flag : 0));
+}
+
+/* Outcomes of svn_repos_authz_check_access(), for server statistics. */
+static svn_metrics__t *authz_granted_metric = NULL;
+static svn_metrics__t *authz_denied_metric = NULL;
+
+svn_error_t *
+svn_repos_authz_check_access(svn_authz_t *authz, const char *repos_name,
+                             const char *path, const char *user,
+                             svn_repos_authz_access_t required_access,
+                             svn_boolean_t *access_granted,
+                             apr_pool_t *pool)
+{
+  /* Pick or create the suitable pre-filtered path rule tree. */
+  authz_user_rules_t *rules = get_user_rules(
+      authz,
+      (repos_name ? repos_name : AUTHZ_ANY_REPOSITORY),
+      user);
 
   /* Sanity check. */
-  SVN_ERR_ASSERT(path[0] == '/');
+  SVN_ERR_ASSERT(!path || path[0] == '/');
 
-  /* Determine the granted access for the requested path.
-   * PATH does not need to be normalized for lockup(). */
-  *access_granted = lookup(rules->lookup_state, path, required,
-                           !!(required_access & svn_authz_recursive), pool);
+  SVN_ERR(check_access(access_granted, authz, rules, path,
+                       required_rights(required_access),
+                       !!(required_access & svn_authz_recursive),
+                       pool));
+
+  /* Server statistics.  The metrics are looked up on first use. */
+  if (!authz_granted_metric)
+    {
+      authz_granted_metric
+        = svn_metrics__counter("svn_authz_checks_total",
+                               "result=\"granted\"",
+                               "Path-based authorization checks.");
+      authz_denied_metric
+        = svn_metrics__counter("svn_authz_checks_total",
+                               "result=\"denied\"",
+                               "Path-based authorization checks.");
+    }
+  svn_metrics__add(*access_granted ? authz_granted_metric
+                                   : authz_denied_metric, 1);
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_repos_authz_check_access_many(apr_array_header_t **access_granted,
+                                  svn_authz_t *authz,
+                                  const char *repos_name,
+                                  const apr_array_header_t *paths,
+                                  const char *user,
+                                  svn_repos_authz_access_t required_access,
+                                  apr_pool_t *result_pool,
+                                  apr_pool_t *scratch_pool)
+{
+  const authz_access_t required = required_rights(required_access);
+  const svn_boolean_t recursive = !!(required_access & svn_authz_recursive);
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  authz_user_rules_t *rules = get_user_rules(
+      authz,
+      (repos_name ? repos_name : AUTHZ_ANY_REPOSITORY),
+      user);
+  int i;
+
+  *access_granted = apr_array_make(result_pool, paths->nelts,
+                                   sizeof(svn_boolean_t));
+
+  /* The lookup state is shared between all checks, so every path gets
+   * to continue from the longest parent path that it has in common with
+   * the previous one. */
+  for (i = 0; i < paths->nelts; ++i)
+    {
+      const char *path = APR_ARRAY_IDX(paths, i, const char *);
+
+      svn_pool_clear(iterpool);
+      SVN_ERR_ASSERT(path[0] == '/');
+      SVN_ERR(check_access(apr_array_push(*access_granted), authz, rules,
+                           path, required, recursive, iterpool));
+    }
+
+  svn_pool_destroy(iterpool);
 
   return SVN_NO_ERROR;
 }
@@ -307,6 +307,27 @@ svn_authz__parse(authz_full_t **authz,
                  apr_pool_t *scratch_pool);
 
 
+/* Serialize AUTHZ into *SERIALIZED, a compact binary form that does not
+ * depend on the address at which it gets loaded.  Allocate the result
+ * in RESULT_POOL and use SCRATCH_POOL for temporary allocations.
+ */
+svn_error_t *
+svn_authz__serialize(svn_stringbuf_t **serialized,
+                     const authz_full_t *authz,
+                     apr_pool_t *result_pool,
+                     apr_pool_t *scratch_pool);
+
+/* Reconstruct the authz model serialized by svn_authz__serialize() in
+ * the LEN bytes at DATA and return it in *AUTHZ, allocated in
+ * RESULT_POOL.  Return SVN_ERR_MALFORMED_FILE if DATA is not valid.
+ */
+svn_error_t *
+svn_authz__deserialize(authz_full_t **authz,
+                       const void *data,
+                       apr_size_t len,
+                       apr_pool_t *result_pool);
+
+
 /* Reverse a STRING of length LEN in place. */
 void
 svn_authz__reverse_string(char *string, apr_size_t len);
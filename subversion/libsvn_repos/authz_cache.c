@@ -0,0 +1,582 @@
+/* authz_cache.c : Compiled authz model in a portable binary form.
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include <apr_hash.h>
+#include <apr_pools.h>
+#include <apr_tables.h>
+
+#include "svn_hash.h"
+#include "svn_string.h"
+
+#include "private/svn_subr_private.h"
+
+#include "svn_private_config.h"
+
+#include "authz.h"
+
+
+/* The serialized form starts with this header, followed by the string
+ * table, the group member sets and finally the model itself.
+ *
+ * All numbers are encoded with svn__encode_uint().  Strings and member
+ * sets are referred to by their index + 1 in their respective table,
+ * with 0 representing NULL.  Arrays that may be NULL store their number
+ * of elements + 1, again with 0 representing NULL.
+ *
+ * The authz code compares interned strings by pointer.  Having a single
+ * table entry for all equal strings preserves that property.
+ */
+#define AUTHZ_CACHE_MAGIC "SVN-AUTHZ-1\n"
+
+/* Members of the group member hashes map to this value. */
+static const char interned_empty_string[] = "";
+
+
+/*** Serialization. ***/
+
+/* Baton used while serializing. */
+typedef struct serialize_baton_t
+{
+  /* Maps string contents to their 1-based table index (apr_size_t *). */
+  apr_hash_t *string_index;
+
+  /* Maps member set hashes, keyed by pointer, to their 1-based table
+   * index (apr_size_t *). */
+  apr_hash_t *set_index;
+
+  /* The string table and member set table contents. */
+  svn_stringbuf_t *strings;
+  svn_stringbuf_t *sets;
+
+  /* Number of entries in those tables. */
+  apr_size_t string_count;
+  apr_size_t set_count;
+
+  /* The model itself. */
+  svn_stringbuf_t *body;
+
+  apr_pool_t *pool;
+} serialize_baton_t;
+
+/* Append VALUE to BUFFER. */
+static void
+put_uint(svn_stringbuf_t *buffer,
+         apr_uint64_t value)
+{
+  unsigned char encoded[SVN__MAX_ENCODED_UINT_LEN];
+  unsigned char *end = svn__encode_uint(encoded, value);
+
+  svn_stringbuf_appendbytes(buffer, (const char *)encoded, end - encoded);
+}
+
+/* Append a reference to the LEN bytes at DATA to BUFFER, adding them to
+ * the string table in SB if necessary.  DATA may be NULL. */
+static void
+put_string(serialize_baton_t *sb,
+           svn_stringbuf_t *buffer,
+           const char *data,
+           apr_size_t len)
+{
+  apr_size_t *index;
+
+  if (!data)
+    {
+      put_uint(buffer, 0);
+      return;
+    }
+
+  index = apr_hash_get(sb->string_index, data, len);
+  if (!index)
+    {
+      index = apr_palloc(sb->pool, sizeof(*index));
+      *index = ++sb->string_count;
+      apr_hash_set(sb->string_index, data, len, index);
+
+      put_uint(sb->strings, len);
+      svn_stringbuf_appendbytes(sb->strings, data, len);
+    }
+
+  put_uint(buffer, *index);
+}
+
+/* Append the C string CSTR to BUFFER using SB. */
+static void
+put_cstring(serialize_baton_t *sb,
+            svn_stringbuf_t *buffer,
+            const char *cstr)
+{
+  put_string(sb, buffer, cstr, cstr ? strlen(cstr) : 0);
+}
+
+/* Append a reference to the group member set MEMBERS to BUFFER, adding
+ * it to the set table in SB if necessary.  MEMBERS may be NULL. */
+static void
+put_member_set(serialize_baton_t *sb,
+               svn_stringbuf_t *buffer,
+               apr_hash_t *members)
+{
+  apr_size_t *index;
+  apr_hash_index_t *hi;
+
+  if (!members)
+    {
+      put_uint(buffer, 0);
+      return;
+    }
+
+  index = apr_hash_get(sb->set_index, &members, sizeof(members));
+  if (!index)
+    {
+      apr_hash_t **key = apr_pmemdup(sb->pool, &members, sizeof(members));
+
+      index = apr_palloc(sb->pool, sizeof(*index));
+      *index = ++sb->set_count;
+      apr_hash_set(sb->set_index, key, sizeof(*key), index);
+
+      put_uint(sb->sets, apr_hash_count(members));
+      for (hi = apr_hash_first(sb->pool, members); hi; hi = apr_hash_next(hi))
+        put_string(sb, sb->sets, apr_hash_this_key(hi),
+                   apr_hash_this_key_len(hi));
+    }
+
+  put_uint(buffer, *index);
+}
+
+/* Append RIGHTS to the model in SB. */
+static void
+put_rights(serialize_baton_t *sb,
+           const authz_rights_t *rights)
+{
+  put_uint(sb->body, rights->min_access);
+  put_uint(sb->body, rights->max_access);
+}
+
+/* Append RIGHTS to the model in SB. */
+static void
+put_global_rights(serialize_baton_t *sb,
+                  const authz_global_rights_t *rights)
+{
+  apr_hash_index_t *hi;
+
+  put_cstring(sb, sb->body, rights->user);
+  put_rights(sb, &rights->any_repos_rights);
+  put_rights(sb, &rights->all_repos_rights);
+
+  put_uint(sb->body, apr_hash_count(rights->per_repos_rights));
+  for (hi = apr_hash_first(sb->pool, rights->per_repos_rights);
+       hi;
+       hi = apr_hash_next(hi))
+    {
+      put_string(sb, sb->body, apr_hash_this_key(hi),
+                 apr_hash_this_key_len(hi));
+      put_rights(sb, apr_hash_this_val(hi));
+    }
+}
+
+/* Append ACL to the model in SB. */
+static void
+put_acl(serialize_baton_t *sb,
+        const authz_acl_t *acl)
+{
+  int i;
+
+  put_uint(sb->body, acl->sequence_number);
+  put_cstring(sb, sb->body, acl->rule.repos);
+
+  put_uint(sb->body, acl->rule.len);
+  for (i = 0; i < acl->rule.len; ++i)
+    {
+      const authz_rule_segment_t *segment = &acl->rule.path[i];
+
+      put_uint(sb->body, segment->kind);
+      put_string(sb, sb->body, segment->pattern.data, segment->pattern.len);
+    }
+
+  put_uint(sb->body, acl->has_anon_access);
+  put_uint(sb->body, acl->anon_access);
+  put_uint(sb->body, acl->has_authn_access);
+  put_uint(sb->body, acl->authn_access);
+
+  put_uint(sb->body, acl->user_access ? acl->user_access->nelts + 1 : 0);
+  for (i = 0; acl->user_access && i < acl->user_access->nelts; ++i)
+    {
+      const authz_ace_t *ace = &APR_ARRAY_IDX(acl->user_access, i,
+                                              authz_ace_t);
+
+      put_cstring(sb, sb->body, ace->name);
+      put_member_set(sb, sb->body, ace->members);
+      put_uint(sb->body, ace->inverted);
+      put_uint(sb->body, ace->access);
+    }
+}
+
+svn_error_t *
+svn_authz__serialize(svn_stringbuf_t **serialized,
+                     const authz_full_t *authz,
+                     apr_pool_t *result_pool,
+                     apr_pool_t *scratch_pool)
+{
+  serialize_baton_t sb;
+  apr_hash_index_t *hi;
+  int i;
+
+  sb.string_index = apr_hash_make(scratch_pool);
+  sb.set_index = apr_hash_make(scratch_pool);
+  sb.strings = svn_stringbuf_create_empty(scratch_pool);
+  sb.sets = svn_stringbuf_create_empty(scratch_pool);
+  sb.string_count = 0;
+  sb.set_count = 0;
+  sb.body = svn_stringbuf_create_empty(scratch_pool);
+  sb.pool = scratch_pool;
+
+  put_uint(sb.body, authz->acls->nelts);
+  for (i = 0; i < authz->acls->nelts; ++i)
+    put_acl(&sb, &APR_ARRAY_IDX(authz->acls, i, authz_acl_t));
+
+  put_uint(sb.body, authz->has_anon_rights);
+  put_global_rights(&sb, &authz->anon_rights);
+  put_uint(sb.body, authz->has_authn_rights);
+  put_global_rights(&sb, &authz->authn_rights);
+
+  put_uint(sb.body, apr_hash_count(authz->user_rights));
+  for (hi = apr_hash_first(scratch_pool, authz->user_rights);
+       hi;
+       hi = apr_hash_next(hi))
+    {
+      put_string(&sb, sb.body, apr_hash_this_key(hi),
+                 apr_hash_this_key_len(hi));
+      put_global_rights(&sb, apr_hash_this_val(hi));
+    }
+
+  /* Put it all together.  The member sets refer to strings, so the
+   * string table must only be written after them. */
+  *serialized = svn_stringbuf_create_ensure(sizeof(AUTHZ_CACHE_MAGIC)
+                                            + sb.strings->len + sb.sets->len
+                                            + sb.body->len
+                                            + 2 * SVN__MAX_ENCODED_UINT_LEN,
+                                            result_pool);
+  svn_stringbuf_appendcstr(*serialized, AUTHZ_CACHE_MAGIC);
+  put_uint(*serialized, sb.string_count);
+  svn_stringbuf_appendstr(*serialized, sb.strings);
+  put_uint(*serialized, sb.set_count);
+  svn_stringbuf_appendstr(*serialized, sb.sets);
+  svn_stringbuf_appendstr(*serialized, sb.body);
+
+  return SVN_NO_ERROR;
+}
+
+
+/*** Deserialization. ***/
+
+/* Baton used while deserializing. */
+typedef struct deserialize_baton_t
+{
+  /* The remaining data to read. */
+  const unsigned char *current;
+  const unsigned char *end;
+
+  /* The string and member set tables. */
+  const char **strings;
+  apr_size_t string_count;
+  apr_hash_t **sets;
+  apr_size_t set_count;
+
+  /* Allocate the model in this pool. */
+  apr_pool_t *pool;
+} deserialize_baton_t;
+
+/* Return the error for malformed input. */
+static svn_error_t *
+malformed(void)
+{
+  return svn_error_create(SVN_ERR_MALFORMED_FILE, NULL,
+                          _("Malformed compiled authz data"));
+}
+
+/* Read the next number from DB into *VALUE. */
+static svn_error_t *
+get_uint(apr_uint64_t *value,
+         deserialize_baton_t *db)
+{
+  db->current = svn__decode_uint(value, db->current, db->end);
+  if (!db->current)
+    return malformed();
+
+  return SVN_NO_ERROR;
+}
+
+/* Read the next number from DB into *VALUE and make sure it is no larger
+ * than LIMIT. */
+static svn_error_t *
+get_size(apr_size_t *value,
+         apr_uint64_t limit,
+         deserialize_baton_t *db)
+{
+  apr_uint64_t temp;
+
+  SVN_ERR(get_uint(&temp, db));
+  if (temp > limit)
+    return malformed();
+
+  *value = (apr_size_t)temp;
+  return SVN_NO_ERROR;
+}
+
+/* Read the next number from DB into *VALUE as an int. */
+static svn_error_t *
+get_int(int *value,
+        deserialize_baton_t *db)
+{
+  apr_size_t temp;
+
+  SVN_ERR(get_size(&temp, APR_INT32_MAX, db));
+  *value = (int)temp;
+
+  return SVN_NO_ERROR;
+}
+
+/* Read the next string reference from DB and return the string in *STR.
+ * The result may be NULL. */
+static svn_error_t *
+get_string(const char **str,
+           deserialize_baton_t *db)
+{
+  apr_size_t index;
+
+  SVN_ERR(get_size(&index, db->string_count, db));
+  *str = index ? db->strings[index - 1] : NULL;
+
+  return SVN_NO_ERROR;
+}
+
+/* Read the next access rights value from DB into *ACCESS. */
+static svn_error_t *
+get_access(authz_access_t *access,
+           deserialize_baton_t *db)
+{
+  apr_size_t temp;
+
+  SVN_ERR(get_size(&temp, authz_access_write, db));
+  *access = (authz_access_t)temp;
+
+  return SVN_NO_ERROR;
+}
+
+/* Read authz_rights_t from DB into *RIGHTS. */
+static svn_error_t *
+get_rights(authz_rights_t *rights,
+           deserialize_baton_t *db)
+{
+  SVN_ERR(get_access(&rights->min_access, db));
+  SVN_ERR(get_access(&rights->max_access, db));
+
+  return SVN_NO_ERROR;
+}
+
+/* Read authz_global_rights_t from DB into *RIGHTS. */
+static svn_error_t *
+get_global_rights(authz_global_rights_t *rights,
+                  deserialize_baton_t *db)
+{
+  apr_size_t count, i;
+
+  SVN_ERR(get_string(&rights->user, db));
+  SVN_ERR(get_rights(&rights->any_repos_rights, db));
+  SVN_ERR(get_rights(&rights->all_repos_rights, db));
+
+  rights->per_repos_rights = apr_hash_make(db->pool);
+  SVN_ERR(get_size(&count, db->end - db->current, db));
+  for (i = 0; i < count; ++i)
+    {
+      const char *repos;
+      authz_rights_t *repos_rights = apr_palloc(db->pool,
+                                                sizeof(*repos_rights));
+
+      SVN_ERR(get_string(&repos, db));
+      if (!repos)
+        return malformed();
+
+      SVN_ERR(get_rights(repos_rights, db));
+      svn_hash_sets(rights->per_repos_rights, repos, repos_rights);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Read authz_acl_t from DB into *ACL. */
+static svn_error_t *
+get_acl(authz_acl_t *acl,
+        deserialize_baton_t *db)
+{
+  apr_size_t count, i;
+  apr_uint64_t temp;
+
+  SVN_ERR(get_int(&acl->sequence_number, db));
+  SVN_ERR(get_string(&acl->rule.repos, db));
+  if (!acl->rule.repos)
+    return malformed();
+
+  SVN_ERR(get_int(&acl->rule.len, db));
+  if (acl->rule.len > db->end - db->current)
+    return malformed();
+
+  acl->rule.path = acl->rule.len
+                 ? apr_palloc(db->pool, acl->rule.len * sizeof(*acl->rule.path))
+                 : NULL;
+  for (i = 0; i < (apr_size_t)acl->rule.len; ++i)
+    {
+      authz_rule_segment_t *segment = &acl->rule.path[i];
+
+      SVN_ERR(get_size(&count, authz_rule_fnmatch, db));
+      segment->kind = (int)count;
+      SVN_ERR(get_string(&segment->pattern.data, db));
+      if (!segment->pattern.data)
+        return malformed();
+      segment->pattern.len = strlen(segment->pattern.data);
+    }
+
+  SVN_ERR(get_uint(&temp, db));
+  acl->has_anon_access = (temp != 0);
+  SVN_ERR(get_access(&acl->anon_access, db));
+  SVN_ERR(get_uint(&temp, db));
+  acl->has_authn_access = (temp != 0);
+  SVN_ERR(get_access(&acl->authn_access, db));
+
+  SVN_ERR(get_size(&count, db->end - db->current, db));
+  acl->user_access = count
+                   ? apr_array_make(db->pool, (int)count - 1,
+                                    sizeof(authz_ace_t))
+                   : NULL;
+  for (i = 1; i < count; ++i)
+    {
+      authz_ace_t *ace = apr_array_push(acl->user_access);
+      apr_size_t set;
+
+      SVN_ERR(get_string(&ace->name, db));
+      if (!ace->name)
+        return malformed();
+
+      SVN_ERR(get_size(&set, db->set_count, db));
+      ace->members = set ? db->sets[set - 1] : NULL;
+
+      SVN_ERR(get_uint(&temp, db));
+      ace->inverted = (temp != 0);
+      SVN_ERR(get_access(&ace->access, db));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_authz__deserialize(authz_full_t **authz_p,
+                       const void *data,
+                       apr_size_t len,
+                       apr_pool_t *result_pool)
+{
+  const apr_size_t magic_len = sizeof(AUTHZ_CACHE_MAGIC) - 1;
+  authz_full_t *authz = apr_pcalloc(result_pool, sizeof(*authz));
+  deserialize_baton_t db;
+  apr_size_t count, i;
+  apr_uint64_t temp;
+
+  if (len < magic_len || memcmp(data, AUTHZ_CACHE_MAGIC, magic_len))
+    return malformed();
+
+  db.current = (const unsigned char *)data + magic_len;
+  db.end = (const unsigned char *)data + len;
+  db.pool = result_pool;
+
+  /* String table.  Every entry takes at least one byte. */
+  SVN_ERR(get_size(&db.string_count, db.end - db.current, &db));
+  db.strings = apr_palloc(result_pool,
+                          db.string_count * sizeof(*db.strings) + 1);
+  for (i = 0; i < db.string_count; ++i)
+    {
+      apr_size_t str_len;
+
+      SVN_ERR(get_size(&str_len, db.end - db.current, &db));
+      db.strings[i] = apr_pstrmemdup(result_pool,
+                                     (const char *)db.current, str_len);
+      db.current += str_len;
+    }
+
+  /* Member set table. */
+  db.set_count = 0;
+  SVN_ERR(get_size(&count, db.end - db.current, &db));
+  db.sets = apr_palloc(result_pool, count * sizeof(*db.sets) + 1);
+  for (; db.set_count < count; ++db.set_count)
+    {
+      apr_hash_t *members = svn_hash__make(result_pool);
+      apr_size_t member_count;
+
+      SVN_ERR(get_size(&member_count, db.end - db.current, &db));
+      for (i = 0; i < member_count; ++i)
+        {
+          const char *member;
+
+          SVN_ERR(get_string(&member, &db));
+          if (!member)
+            return malformed();
+
+          svn_hash_sets(members, member, interned_empty_string);
+        }
+
+      db.sets[db.set_count] = members;
+    }
+
+  /* The model. */
+  SVN_ERR(get_size(&count, db.end - db.current, &db));
+  authz->acls = apr_array_make(result_pool, (int)count, sizeof(authz_acl_t));
+  for (i = 0; i < count; ++i)
+    SVN_ERR(get_acl(apr_array_push(authz->acls), &db));
+
+  SVN_ERR(get_uint(&temp, &db));
+  authz->has_anon_rights = (temp != 0);
+  SVN_ERR(get_global_rights(&authz->anon_rights, &db));
+  SVN_ERR(get_uint(&temp, &db));
+  authz->has_authn_rights = (temp != 0);
+  SVN_ERR(get_global_rights(&authz->authn_rights, &db));
+
+  authz->user_rights = svn_hash__make(result_pool);
+  SVN_ERR(get_size(&count, db.end - db.current, &db));
+  for (i = 0; i < count; ++i)
+    {
+      const char *user;
+      authz_global_rights_t *rights = apr_palloc(result_pool,
+                                                 sizeof(*rights));
+
+      SVN_ERR(get_string(&user, &db));
+      if (!user)
+        return malformed();
+
+      SVN_ERR(get_global_rights(rights, &db));
+      svn_hash_sets(authz->user_rights, user, rights);
+    }
+
+  if (db.current != db.end)
+    return malformed();
+
+  authz->pool = result_pool;
+  *authz_p = authz;
+
+  return SVN_NO_ERROR;
+}
@@ -0,0 +1,300 @@
+/* blame.c --- server-side blame annotations
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include "svn_diff.h"
+#include "svn_fs.h"
+#include "svn_pools.h"
+#include "svn_repos.h"
+#include "private/svn_fspath.h"
+#include "private/svn_repos_private.h"
+#include "svn_private_config.h"
+#include "repos.h"
+
+
+
+/* Baton for history_receiver(). */
+typedef struct history_baton_t
+{
+  /* The svn_repos__log_index_location_t of the file's history so far,
+     youngest first. */
+  apr_array_header_t *locations;
+
+  /* The cache to look into.  May be NULL. */
+  svn_repos__log_index_t *index;
+
+  /* The cached annotation of the last entry in LOCATIONS, if any. */
+  apr_array_header_t *cached;
+
+  /* Allocate the members above in this pool. */
+  apr_pool_t *result_pool;
+} history_baton_t;
+
+/* Implements svn_repos_history_func_t.  Collect the history locations
+   in BATON, which is a history_baton_t, and stop at the first one that
+   has a cached annotation. */
+static svn_error_t *
+history_receiver(void *baton,
+                 const char *path,
+                 svn_revnum_t revision,
+                 apr_pool_t *pool)
+{
+  history_baton_t *hb = baton;
+  svn_repos__log_index_location_t *location;
+
+  location = apr_array_push(hb->locations);
+  location->path = apr_pstrdup(hb->result_pool, path);
+  location->revision = revision;
+
+  if (hb->index)
+    {
+      SVN_ERR(svn_repos__log_index_get_blame(&hb->cached, hb->index, path,
+                                             revision, hb->result_pool,
+                                             pool));
+      if (hb->cached)
+        return svn_error_create(SVN_ERR_CEASE_INVOCATION, NULL, NULL);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Baton for the diff output functions below. */
+typedef struct annotate_baton_t
+{
+  /* Annotation of the previous file contents. */
+  const apr_array_header_t *original;
+
+  /* Annotation of the current file contents, being built. */
+  apr_array_header_t *modified;
+
+  /* The revision to blame for all lines that changed. */
+  svn_revnum_t revision;
+} annotate_baton_t;
+
+/* Implements svn_diff_output_fns_t.output_common.
+   Lines that did not change keep their original annotation. */
+static svn_error_t *
+annotate_common(void *baton,
+                apr_off_t original_start,
+                apr_off_t original_length,
+                apr_off_t modified_start,
+                apr_off_t modified_length,
+                apr_off_t latest_start,
+                apr_off_t latest_length)
+{
+  annotate_baton_t *ab = baton;
+  apr_off_t i;
+
+  for (i = original_start; i < original_start + original_length; ++i)
+    APR_ARRAY_PUSH(ab->modified, svn_revnum_t)
+      = APR_ARRAY_IDX(ab->original, i, svn_revnum_t);
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_diff_output_fns_t.output_diff_modified.
+   Lines that got added or changed are blamed on the current revision. */
+static svn_error_t *
+annotate_modified(void *baton,
+                  apr_off_t original_start,
+                  apr_off_t original_length,
+                  apr_off_t modified_start,
+                  apr_off_t modified_length,
+                  apr_off_t latest_start,
+                  apr_off_t latest_length)
+{
+  annotate_baton_t *ab = baton;
+  apr_off_t i;
+
+  for (i = 0; i < modified_length; ++i)
+    APR_ARRAY_PUSH(ab->modified, svn_revnum_t) = ab->revision;
+
+  return SVN_NO_ERROR;
+}
+
+static const svn_diff_output_fns_t annotate_fns = {
+  annotate_common,
+  annotate_modified
+};
+
+/* Read the full contents of PATH in REVISION of FS into *CONTENTS,
+   allocated in RESULT_POOL.  Use SCRATCH_POOL for temporaries. */
+static svn_error_t *
+read_contents(svn_string_t **contents,
+              svn_fs_t *fs,
+              const char *path,
+              svn_revnum_t revision,
+              apr_pool_t *result_pool,
+              apr_pool_t *scratch_pool)
+{
+  svn_fs_root_t *root;
+  svn_stream_t *stream;
+
+  SVN_ERR(svn_fs_revision_root(&root, fs, revision, scratch_pool));
+  SVN_ERR(svn_fs_file_contents(&stream, root, path, scratch_pool));
+
+  return svn_error_trace(svn_string_from_stream2(contents, stream, 0,
+                                                 result_pool));
+}
+
+svn_error_t *
+svn_repos__get_blame(apr_array_header_t **revisions,
+                     svn_repos_t *repos,
+                     const char *path,
+                     svn_revnum_t revision,
+                     svn_repos_authz_func_t authz_read_func,
+                     void *authz_read_baton,
+                     svn_cancel_func_t cancel_func,
+                     void *cancel_baton,
+                     apr_pool_t *result_pool,
+                     apr_pool_t *scratch_pool)
+{
+  svn_fs_t *fs = svn_repos_fs(repos);
+  svn_fs_root_t *root;
+  svn_node_kind_t kind;
+  history_baton_t hb;
+  svn_diff_file_options_t *options = svn_diff_file_options_create(
+                                       scratch_pool);
+  svn_repos__log_index_location_t *last = NULL;
+  svn_string_t *last_contents = svn_string_create_empty(scratch_pool);
+  apr_array_header_t *annotation;
+  apr_pool_t *lastpool = svn_pool_create(scratch_pool);
+  apr_pool_t *currpool = svn_pool_create(scratch_pool);
+  int i;
+
+  path = svn_fspath__canonicalize(path, scratch_pool);
+
+  SVN_ERR(svn_fs_revision_root(&root, fs, revision, scratch_pool));
+  SVN_ERR(svn_fs_check_path(&kind, root, path, scratch_pool));
+  if (kind != svn_node_file)
+    return svn_error_createf(SVN_ERR_FS_NOT_FILE, NULL,
+                             _("'%s' is not a file in revision %ld"),
+                             path, revision);
+
+  hb.locations = apr_array_make(scratch_pool, 16,
+                                sizeof(svn_repos__log_index_location_t));
+  hb.cached = NULL;
+  hb.result_pool = scratch_pool;
+
+  /* Cached annotations are shared by all users, so they must not depend
+     on what the current one may read.  Annotations never become stale,
+     so the index may lag behind REVISION. */
+  hb.index = NULL;
+  if (!authz_read_func)
+    SVN_ERR(svn_repos__log_index_open(&hb.index, repos, 0, scratch_pool,
+                                      scratch_pool));
+
+  SVN_ERR(svn_repos_history2(fs, path, history_receiver, &hb,
+                             authz_read_func, authz_read_baton,
+                             0, revision, TRUE, scratch_pool));
+  SVN_ERR_ASSERT(hb.locations->nelts > 0);
+
+  /* Start from the youngest cached annotation, if there is one. */
+  i = hb.locations->nelts - 1;
+  if (hb.cached)
+    {
+      last = &APR_ARRAY_IDX(hb.locations, i,
+                            svn_repos__log_index_location_t);
+      SVN_ERR(read_contents(&last_contents, fs, last->path, last->revision,
+                            lastpool, scratch_pool));
+      annotation = hb.cached;
+      --i;
+    }
+  else
+    {
+      annotation = apr_array_make(scratch_pool, 0, sizeof(svn_revnum_t));
+    }
+
+  /* Apply the changes of all younger revisions in turn. */
+  for (; i >= 0; --i)
+    {
+      svn_repos__log_index_location_t *location
+        = &APR_ARRAY_IDX(hb.locations, i, svn_repos__log_index_location_t);
+      svn_string_t *contents;
+      svn_diff_t *diff;
+      annotate_baton_t ab;
+      apr_pool_t *tmppool;
+
+      if (cancel_func)
+        SVN_ERR(cancel_func(cancel_baton));
+
+      svn_pool_clear(currpool);
+
+      /* Skip revisions that only changed properties. */
+      if (last)
+        {
+          svn_fs_root_t *last_root, *this_root;
+          svn_boolean_t different;
+
+          SVN_ERR(svn_fs_revision_root(&last_root, fs, last->revision,
+                                       currpool));
+          SVN_ERR(svn_fs_revision_root(&this_root, fs, location->revision,
+                                       currpool));
+          SVN_ERR(svn_fs_contents_different(&different, last_root,
+                                            last->path, this_root,
+                                            location->path, currpool));
+          if (!different)
+            continue;
+        }
+
+      SVN_ERR(read_contents(&contents, fs, location->path,
+                            location->revision, currpool, currpool));
+      SVN_ERR(svn_diff_mem_string_diff(&diff, last_contents, contents,
+                                       options, currpool));
+
+      ab.original = annotation;
+      ab.modified = apr_array_make(currpool, annotation->nelts,
+                                   sizeof(svn_revnum_t));
+      ab.revision = location->revision;
+      SVN_ERR(svn_diff_output2(diff, &ab, &annotate_fns,
+                               cancel_func, cancel_baton));
+
+      annotation = ab.modified;
+      last_contents = contents;
+      last = location;
+
+      /* Keep the current contents and annotation for the next round. */
+      tmppool = lastpool;
+      lastpool = currpool;
+      currpool = tmppool;
+    }
+
+  /* Cache the result unless we found it in the cache already.
+     Failing to update the cache must not fail the request. */
+  if (hb.index && !(hb.cached && hb.locations->nelts == 1))
+    {
+      svn_repos__log_index_location_t *youngest
+        = &APR_ARRAY_IDX(hb.locations, 0, svn_repos__log_index_location_t);
+
+      svn_error_clear(svn_repos__log_index_set_blame(hb.index,
+                                                     youngest->path,
+                                                     youngest->revision,
+                                                     annotation,
+                                                     scratch_pool));
+    }
+
+  *revisions = apr_array_copy(result_pool, annotation);
+
+  svn_pool_destroy(currpool);
+  svn_pool_destroy(lastpool);
+
+  return SVN_NO_ERROR;
+}
@@ -0,0 +1,381 @@
+/* changes_summary.c --- summarize a diff from the changed-path lists
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+/* Instead of comparing two trees node by node, we fold the changed-path
+ * lists of all revisions in the range into the set of paths that have
+ * been touched at all.  Only those get compared between the two roots;
+ * everything else is known to be unchanged.
+ *
+ * That reasoning only holds as long as no node has been copied into the
+ * tree or replaced within the range.  In these cases, we give up and let
+ * the caller fall back to a full tree comparison.
+ */
+
+#include "svn_dirent_uri.h"
+#include "svn_hash.h"
+#include "svn_fs.h"
+#include "svn_path.h"
+#include "svn_pools.h"
+#include "svn_props.h"
+#include "svn_repos.h"
+#include "svn_sorts.h"
+#include "private/svn_fspath.h"
+#include "private/svn_repos_private.h"
+#include "private/svn_sorts_private.h"
+#include "svn_private_config.h"
+
+
+
+/* Baton for collect_changes(). */
+typedef struct collect_baton_t
+{
+  /* The fspath whose changes we summarize. */
+  const char *path;
+
+  /* Prune changes that are too deep for this. */
+  svn_depth_t depth;
+
+  /* The filesystem, needed to find copy sources. */
+  svn_fs_t *fs;
+
+  /* Relpaths below PATH that have been touched, mapped to themselves. */
+  apr_hash_t *touched;
+
+  /* Pool to allocate TOUCHED's contents in. */
+  apr_pool_t *pool;
+} collect_baton_t;
+
+/* Return an error telling the caller to use a full tree comparison
+   because PATH has been copied or replaced in REVISION. */
+static svn_error_t *
+not_summarizable(const char *path,
+                 svn_revnum_t revision)
+{
+  return svn_error_createf(SVN_ERR_UNSUPPORTED_FEATURE, NULL,
+                           _("Path '%s' has been copied or replaced "
+                             "in r%ld"), path, revision);
+}
+
+/* Return TRUE if RELPATH is not too deep to be reported for DEPTH. */
+static svn_boolean_t
+within_depth(const char *relpath,
+             svn_depth_t depth)
+{
+  if (depth == svn_depth_infinity || depth == svn_depth_unknown)
+    return TRUE;
+
+  if (depth == svn_depth_empty)
+    return *relpath == '\0';
+
+  /* files or immediates */
+  return svn_path_component_count(relpath) <= 1;
+}
+
+/* Implements svn_fs_paths_changed_receiver_t.  Add all paths below
+   B->PATH that ITERATOR reports as changed in REVISION to B->TOUCHED.
+   B is a collect_baton_t. */
+static svn_error_t *
+collect_changes(void *baton,
+                svn_revnum_t revision,
+                svn_fs_path_change_iterator_t *iterator,
+                apr_pool_t *scratch_pool)
+{
+  collect_baton_t *b = baton;
+  svn_fs_path_change3_t *change;
+
+  SVN_ERR(svn_fs_path_change_get(&change, iterator));
+  while (change)
+    {
+      const char *changed_path = change->path.data;
+      const char *relpath = svn_fspath__skip_ancestor(b->path, changed_path);
+
+      if (!relpath)
+        {
+          /* Changes outside of PATH don't matter -- unless they replace
+             or remove PATH itself. */
+          if (svn_fspath__skip_ancestor(changed_path, b->path)
+              && change->change_kind != svn_fs_path_change_modify)
+            return svn_error_trace(not_summarizable(b->path, revision));
+        }
+      else
+        {
+          if (change->change_kind == svn_fs_path_change_replace)
+            return svn_error_trace(not_summarizable(changed_path, revision));
+
+          if (change->change_kind == svn_fs_path_change_add)
+            {
+              svn_revnum_t copyfrom_rev = change->copyfrom_rev;
+
+              if (!change->copyfrom_known)
+                {
+                  svn_fs_root_t *root;
+                  const char *copyfrom_path;
+
+                  SVN_ERR(svn_fs_revision_root(&root, b->fs, revision,
+                                               scratch_pool));
+                  SVN_ERR(svn_fs_copied_from(&copyfrom_rev, &copyfrom_path,
+                                             root, changed_path,
+                                             scratch_pool));
+                }
+
+              if (SVN_IS_VALID_REVNUM(copyfrom_rev))
+                return svn_error_trace(not_summarizable(changed_path,
+                                                        revision));
+            }
+
+          if (within_depth(relpath, b->depth)
+              && !svn_hash_gets(b->touched, relpath))
+            {
+              relpath = apr_pstrdup(b->pool, relpath);
+              svn_hash_sets(b->touched, relpath, relpath);
+            }
+        }
+
+      SVN_ERR(svn_fs_path_change_get(&change, iterator));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Add an entry for RELPATH with ACTION, KIND, TEXT_MODIFIED and
+   PROPS_MODIFIED to CHANGES.  Allocate it in RESULT_POOL. */
+static void
+add_change(apr_hash_t *changes,
+           const char *relpath,
+           char action,
+           svn_node_kind_t kind,
+           svn_boolean_t text_modified,
+           svn_boolean_t props_modified,
+           apr_pool_t *result_pool)
+{
+  svn_log_changed_path2_t *change = svn_log_changed_path2_create(result_pool);
+
+  change->action = action;
+  change->node_kind = kind;
+  change->text_modified = text_modified ? svn_tristate_true
+                                        : svn_tristate_false;
+  change->props_modified = props_modified ? svn_tristate_true
+                                          : svn_tristate_false;
+
+  svn_hash_sets(changes, apr_pstrdup(result_pool, relpath), change);
+}
+
+/* Report RELPATH and, if it is a directory, all nodes below it in ROOT
+   below PATH as deleted in CHANGES.  Skip paths that AUTHZ_READ_FUNC with
+   AUTHZ_READ_BATON denies access to.  Allocate the results in RESULT_POOL
+   and use SCRATCH_POOL for temporaries. */
+static svn_error_t *
+add_deletion(apr_hash_t *changes,
+             svn_fs_root_t *root,
+             const char *path,
+             const char *relpath,
+             svn_node_kind_t kind,
+             svn_repos_authz_func_t authz_read_func,
+             void *authz_read_baton,
+             apr_pool_t *result_pool,
+             apr_pool_t *scratch_pool)
+{
+  apr_hash_t *entries;
+  apr_hash_index_t *hi;
+  apr_pool_t *iterpool;
+
+  add_change(changes, relpath, 'D', kind, FALSE, FALSE, result_pool);
+  if (kind != svn_node_dir)
+    return SVN_NO_ERROR;
+
+  /* Like the tree delta, report the whole deleted sub-tree, regardless
+     of the depth. */
+  iterpool = svn_pool_create(scratch_pool);
+  SVN_ERR(svn_fs_dir_entries(&entries, root,
+                             svn_fspath__join(path, relpath, scratch_pool),
+                             scratch_pool));
+  for (hi = apr_hash_first(scratch_pool, entries); hi; hi = apr_hash_next(hi))
+    {
+      svn_fs_dirent_t *dirent = apr_hash_this_val(hi);
+      const char *child_relpath;
+
+      svn_pool_clear(iterpool);
+      child_relpath = svn_relpath_join(relpath, dirent->name, iterpool);
+
+      if (authz_read_func)
+        {
+          svn_boolean_t allowed;
+          SVN_ERR(authz_read_func(&allowed, root,
+                                  svn_fspath__join(path, child_relpath,
+                                                   iterpool),
+                                  authz_read_baton, iterpool));
+          if (!allowed)
+            continue;
+        }
+
+      SVN_ERR(add_deletion(changes, root, path, child_relpath, dirent->kind,
+                           authz_read_func, authz_read_baton,
+                           result_pool, iterpool));
+    }
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_repos__get_changes_summary(apr_hash_t **changes,
+                               svn_repos_t *repos,
+                               const char *path,
+                               svn_revnum_t start_rev,
+                               svn_revnum_t end_rev,
+                               svn_depth_t depth,
+                               svn_repos_authz_func_t authz_read_func,
+                               void *authz_read_baton,
+                               svn_cancel_func_t cancel_func,
+                               void *cancel_baton,
+                               apr_pool_t *result_pool,
+                               apr_pool_t *scratch_pool)
+{
+  svn_fs_t *fs = svn_repos_fs(repos);
+  svn_fs_root_t *root1, *root2;
+  svn_node_kind_t kind1, kind2;
+  svn_fs_node_relation_t relation;
+  collect_baton_t baton;
+  apr_array_header_t *sorted;
+  const char *deleted_relpath = NULL;
+  apr_pool_t *iterpool;
+  int i;
+
+  SVN_ERR_ASSERT(svn_fspath__is_canonical(path));
+  SVN_ERR_ASSERT(start_rev <= end_rev);
+
+  /* The target must be the same node on both ends. */
+  SVN_ERR(svn_fs_revision_root(&root1, fs, start_rev, scratch_pool));
+  SVN_ERR(svn_fs_revision_root(&root2, fs, end_rev, scratch_pool));
+  SVN_ERR(svn_fs_check_path(&kind1, root1, path, scratch_pool));
+  SVN_ERR(svn_fs_check_path(&kind2, root2, path, scratch_pool));
+  if (kind1 == svn_node_none || kind1 != kind2)
+    return svn_error_createf(SVN_ERR_UNSUPPORTED_FEATURE, NULL,
+                             _("Path '%s' does not exist as the same kind "
+                               "of node in r%ld and r%ld"),
+                             path, start_rev, end_rev);
+
+  SVN_ERR(svn_fs_node_relation(&relation, root1, path, root2, path,
+                               scratch_pool));
+  if (relation == svn_fs_node_unrelated)
+    return svn_error_createf(SVN_ERR_UNSUPPORTED_FEATURE, NULL,
+                             _("Path '%s' in r%ld is not related to "
+                               "itself in r%ld"),
+                             path, start_rev, end_rev);
+
+  if (kind1 != svn_node_dir)
+    depth = svn_depth_empty;
+
+  /* Fold the change lists into the set of paths to look at. */
+  baton.path = path;
+  baton.depth = depth;
+  baton.fs = fs;
+  baton.touched = apr_hash_make(scratch_pool);
+  baton.pool = scratch_pool;
+  if (start_rev < end_rev)
+    SVN_ERR(svn_fs_paths_changed_range(fs, start_rev + 1, end_rev,
+                                       collect_changes, &baton,
+                                       cancel_func, cancel_baton,
+                                       scratch_pool));
+
+  /* Compare the touched paths between both roots.  Parents sort before
+     their children, so deleted sub-trees are easy to skip. */
+  *changes = apr_hash_make(result_pool);
+  sorted = svn_sort__hash(baton.touched, svn_sort_compare_items_as_paths,
+                          scratch_pool);
+  iterpool = svn_pool_create(scratch_pool);
+  for (i = 0; i < sorted->nelts; ++i)
+    {
+      const char *relpath = APR_ARRAY_IDX(sorted, i, svn_sort__item_t).key;
+      const char *node_path;
+      svn_boolean_t props_changed = FALSE, text_changed = FALSE;
+
+      svn_pool_clear(iterpool);
+      if (cancel_func)
+        SVN_ERR(cancel_func(cancel_baton));
+
+      if (deleted_relpath
+          && svn_relpath_skip_ancestor(deleted_relpath, relpath))
+        continue;
+
+      node_path = svn_fspath__join(path, relpath, iterpool);
+      SVN_ERR(svn_fs_check_path(&kind1, root1, node_path, iterpool));
+      SVN_ERR(svn_fs_check_path(&kind2, root2, node_path, iterpool));
+
+      if (kind1 == svn_node_none && kind2 == svn_node_none)
+        continue;
+
+      if (depth == svn_depth_files && *relpath
+          && (kind1 == svn_node_dir || kind2 == svn_node_dir))
+        continue;
+
+      if (authz_read_func)
+        {
+          svn_boolean_t allowed;
+          SVN_ERR(authz_read_func(&allowed,
+                                  kind2 == svn_node_none ? root1 : root2,
+                                  node_path, authz_read_baton, iterpool));
+          if (!allowed)
+            continue;
+        }
+
+      if (kind1 == svn_node_none)
+        {
+          SVN_ERR(svn_fs_node_has_props(&props_changed, root2, node_path,
+                                        iterpool));
+          add_change(*changes, relpath, 'A', kind2,
+                     kind2 == svn_node_file, props_changed, result_pool);
+          continue;
+        }
+
+      if (kind2 == svn_node_none)
+        {
+          SVN_ERR(add_deletion(*changes, root1, path, relpath, kind1,
+                               authz_read_func, authz_read_baton,
+                               result_pool, iterpool));
+          deleted_relpath = apr_pstrdup(scratch_pool, relpath);
+          continue;
+        }
+
+      /* A node that went away and came back within the range. */
+      SVN_ERR(svn_fs_node_relation(&relation, root1, node_path,
+                                   root2, node_path, iterpool));
+      if (kind1 != kind2 || relation == svn_fs_node_unrelated)
+        return svn_error_createf(SVN_ERR_UNSUPPORTED_FEATURE, NULL,
+                                 _("Path '%s' has been replaced between "
+                                   "r%ld and r%ld"),
+                                 node_path, start_rev, end_rev);
+
+      SVN_ERR(svn_fs_props_different(&props_changed, root1, node_path,
+                                     root2, node_path, iterpool));
+      if (kind1 == svn_node_file)
+        SVN_ERR(svn_fs_contents_different(&text_changed, root1, node_path,
+                                          root2, node_path, iterpool));
+
+      if (props_changed || text_changed)
+        add_change(*changes, relpath, 'M', kind1, text_changed,
+                   props_changed, result_pool);
+    }
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
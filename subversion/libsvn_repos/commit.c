@@ -586,6 +586,41 @@ apply_textdelta(void *file_baton,
 }
 
 
+static svn_error_t *
+apply_text_by_checksum(svn_boolean_t *applied,
+                       const svn_delta_editor_t *editor,
+                       void *file_baton,
+                       const svn_checksum_t *sha1_checksum,
+                       apr_pool_t *scratch_pool)
+{
+  struct file_baton *fb = file_baton;
+  struct edit_baton *eb = fb->edit_baton;
+
+  /* With path-based authz in place, answering this would tell the client
+     whether some text exists anywhere in the repository, including paths
+     it may not read.  Always let it send the text in that case. */
+  if (eb->authz_callback)
+    {
+      *applied = FALSE;
+      return SVN_NO_ERROR;
+    }
+
+  if (!fb->checked_write)
+    {
+      /* Check for write authorization. */
+      SVN_ERR(check_authz(eb, fb->path, eb->txn_root,
+                          svn_authz_write, scratch_pool));
+      fb->checked_write = TRUE;
+    }
+
+  return svn_error_trace(svn_fs_apply_text_by_checksum(applied,
+                                                       eb->txn_root,
+                                                       fb->path,
+                                                       sha1_checksum,
+                                                       scratch_pool));
+}
+
+
 static svn_error_t *
 add_file(const char *path,
          void *parent_baton,
@@ -1036,6 +1071,7 @@ svn_repos_get_commit_editor5(const svn_delta_editor_t **editor,
   e->open_file         = open_file;
   e->close_file        = close_file;
   e->apply_textdelta   = apply_textdelta;
+  e->apply_text_by_checksum = apply_text_by_checksum;
   e->change_file_prop  = change_file_prop;
   e->close_edit        = close_edit;
   e->abort_edit        = abort_edit;
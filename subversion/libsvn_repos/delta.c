@@ -33,8 +33,12 @@
 #include "svn_repos.h"
 #include "svn_pools.h"
 #include "svn_props.h"
+#include "svn_sorts.h"
 #include "svn_private_config.h"
 #include "repos.h"
+#include "private/svn_delta_private.h"
+#include "private/svn_mutex.h"
+#include "private/svn_worker_pool.h"
 
 
 
@@ -61,6 +65,10 @@ struct context {
   svn_boolean_t text_deltas;
   svn_boolean_t entry_props;
   svn_boolean_t ignore_ancestry;
+
+  /* Maximum number of threads to compare sub-trees with.  1 when
+     running in a worker thread. */
+  int jobs;
 };
 
 
@@ -198,7 +206,7 @@ authz_root_check(svn_fs_root_t *root,
 
 /* Public interface to computing directory deltas.  */
 svn_error_t *
-svn_repos_dir_delta2(svn_fs_root_t *src_root,
+svn_repos_dir_delta3(svn_fs_root_t *src_root,
                      const char *src_parent_dir,
                      const char *src_entry,
                      svn_fs_root_t *tgt_root,
@@ -211,6 +219,7 @@ svn_repos_dir_delta2(svn_fs_root_t *src_root,
                      svn_depth_t depth,
                      svn_boolean_t entry_props,
                      svn_boolean_t ignore_ancestry,
+                     int jobs,
                      apr_pool_t *pool)
 {
   void *root_baton = NULL;
@@ -297,6 +306,10 @@ svn_repos_dir_delta2(svn_fs_root_t *src_root,
   c.entry_props = entry_props;
   c.ignore_ancestry = ignore_ancestry;
 
+  /* Only revision roots can be re-opened safely by other threads. */
+  c.jobs = (svn_fs_is_revision_root(src_root)
+            && svn_fs_is_revision_root(tgt_root)) ? MAX(jobs, 1) : 1;
+
   /* Get our editor root's revision. */
   rootrev = get_path_revision(src_root, src_parent_dir, pool);
 
@@ -825,34 +838,344 @@ absent_file_or_dir(struct context *c,
 }
 
 
-/* Emit deltas to turn SOURCE_PATH into TARGET_PATH.  Assume that
-   DIR_BATON represents the directory we're constructing to the editor
-   in the context C.  */
+#if APR_HAS_THREADS
+
+/* Sub-tree edits beyond this size will be spooled to disk instead of
+   being held in memory. */
+#define DELTA_SPOOL_SIZE (1024 * 1024)
+
+/* A sub-tree to be compared by some worker thread. */
+typedef struct subtree_job_t
+{
+  /* The paths to pass to replace_file_or_dir().  Constant while the
+     workers are running. */
+  const char *source_path;
+  const char *target_path;
+  const char *edit_path;
+
+  /* The recorded edit of the sub-tree, rooted at its parent directory.
+     If the comparison failed, it is complete up to the failure. */
+  svn_delta__spool_t *spool;
+
+  /* Root pool holding SPOOL.  Owned by the receiver. */
+  apr_pool_t *pool;
+} subtree_job_t;
+
+/* State shared between the threads comparing the sub-trees of one
+   directory.  Unless noted otherwise, all members are constant while
+   the workers are running. */
+typedef struct parallel_delta_t
+{
+  /* The context of the calling thread. */
+  const struct context *c;
+
+  /* Where to find the filesystems, how to open them and which revisions
+     to compare. */
+  const char *source_fs_path;
+  apr_hash_t *source_fs_config;
+  svn_revnum_t source_rev;
+  const char *target_fs_path;
+  apr_hash_t *target_fs_config;
+  svn_revnum_t target_rev;
+
+  /* The sub-trees to compare, in the order of the editor drive. */
+  subtree_job_t *jobs;
+  int job_count;
+
+  /* Compares the sub-trees in order.  The jobs before NEXT_JOB have
+     been added to it.  NEXT_JOB is only used by the calling thread. */
+  svn_worker_pool__ordered_t *queue;
+  int next_job;
+
+  /* Serializes the calls to C->AUTHZ_READ_FUNC. */
+  svn_mutex__t *authz_mutex;
+} parallel_delta_t;
+
+/* Implements svn_repos_authz_func_t for worker threads.  BATON is
+   the parallel_delta_t.  Call the original authz function, one thread
+   at a time. */
 static svn_error_t *
-delta_dirs(struct context *c,
-           void *dir_baton,
-           svn_depth_t depth,
-           const char *source_path,
-           const char *target_path,
-           const char *edit_path,
-           apr_pool_t *pool)
+serialized_authz_func(svn_boolean_t *allowed,
+                      svn_fs_root_t *root,
+                      const char *path,
+                      void *baton,
+                      apr_pool_t *pool)
 {
-  apr_hash_t *s_entries = 0, *t_entries = 0;
+  parallel_delta_t *pd = baton;
+
+  SVN_MUTEX__WITH_LOCK(pd->authz_mutex,
+                       pd->c->authz_read_func(allowed, root, path,
+                                              pd->c->authz_read_baton,
+                                              pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *C to a copy of the context of PD's calling thread but with source
+   and target roots in filesystem instances of our own.  Allocate them in
+   POOL. */
+static svn_error_t *
+open_worker_context(struct context *c,
+                    parallel_delta_t *pd,
+                    apr_pool_t *pool)
+{
+  svn_fs_t *source_fs, *target_fs;
+
+  *c = *pd->c;
+  c->jobs = 1;
+  if (c->authz_read_func)
+    {
+      c->authz_read_func = serialized_authz_func;
+      c->authz_read_baton = pd;
+    }
+
+  SVN_ERR(svn_fs_open2(&source_fs, pd->source_fs_path, pd->source_fs_config,
+                       pool, pool));
+  if (strcmp(pd->source_fs_path, pd->target_fs_path) == 0)
+    target_fs = source_fs;
+  else
+    SVN_ERR(svn_fs_open2(&target_fs, pd->target_fs_path,
+                         pd->target_fs_config, pool, pool));
+
+  SVN_ERR(svn_fs_revision_root(&c->source_root, source_fs, pd->source_rev,
+                               pool));
+  SVN_ERR(svn_fs_revision_root(&c->target_root, target_fs, pd->target_rev,
+                               pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_worker_pool__open_func_t.  BATON is the
+   parallel_delta_t. */
+static svn_error_t *
+open_delta_context(void **thread_baton,
+                   void *baton,
+                   apr_pool_t *thread_pool)
+{
+  struct context *c = apr_palloc(thread_pool, sizeof(*c));
+
+  /* svn_fs_t instances and their roots must not be shared between
+     threads. */
+  SVN_ERR(open_worker_context(c, baton, thread_pool));
+
+  *thread_baton = c;
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_worker_pool__item_func_t.  ITEM is the subtree_job_t
+   to compare, THREAD_BATON the struct context of the calling thread. */
+static svn_error_t *
+delta_subtree_item(void *item,
+                   void *thread_baton,
+                   apr_pool_t *scratch_pool)
+{
+  subtree_job_t *job = item;
+  struct context *c = thread_baton;
+  const svn_delta_editor_t *editor;
+  void *edit_baton, *root_baton;
+
+  /* The receiver will destroy that pool, so it must not share an
+     allocator with any pool that we are still using. */
+  job->pool = apr_allocator_owner_get(svn_pool_create_allocator(FALSE));
+
+  /* Record the edit below a dummy root that stands in for the parent
+     directory of the sub-tree. */
+  SVN_ERR(svn_delta__get_spool_editor(&editor, &edit_baton, &job->spool,
+                                      DELTA_SPOOL_SIZE, job->pool));
+  SVN_ERR(editor->open_root(edit_baton, SVN_INVALID_REVNUM, job->pool,
+                            &root_baton));
+
+  c->editor = editor;
+  return svn_error_trace(replace_file_or_dir(c, root_baton,
+                                             svn_depth_infinity,
+                                             job->source_path,
+                                             job->target_path,
+                                             job->edit_path, svn_node_dir,
+                                             scratch_pool));
+}
+
+/* Implements svn_worker_pool__release_func_t for subtree_job_t. */
+static void
+release_subtree_job(void *item)
+{
+  subtree_job_t *job = item;
+
+  if (job->pool)
+    svn_pool_destroy(job->pool);
+}
+
+/* Wait for the workers in PD to exit and release all unreported results.
+   Return ERR, combined with any error reported by the workers. */
+static svn_error_t *
+stop_parallel_delta(parallel_delta_t *pd,
+                    svn_error_t *err)
+{
+  return svn_error_trace(svn_worker_pool__ordered_destroy(pd->queue, err));
+}
+
+/* Return TRUE if the comparison of S_ENTRY, which may be NULL, with
+   T_ENTRY in context C recurses into a directory on both sides. */
+static svn_boolean_t
+is_subtree_change(const struct context *c,
+                  const svn_fs_dirent_t *s_entry,
+                  const svn_fs_dirent_t *t_entry)
+{
+  int distance;
+
+  if (!s_entry || s_entry->kind != svn_node_dir
+      || t_entry->kind != svn_node_dir)
+    return FALSE;
+
+  distance = svn_fs_compare_ids(s_entry->id, t_entry->id);
+  return distance == 1 || (distance == -1 && c->ignore_ancestry);
+}
+
+/* If the directory SOURCE_PATH with S_ENTRIES and TARGET_PATH with
+   T_ENTRIES has at least two sub-directories that get compared
+   recursively in context C, start worker threads for them and return
+   the shared state in *PD.  Otherwise, or if no thread could be started,
+   set *PD to NULL.  EDIT_PATH is
+   the editor path of the directory.  Allocate the result in POOL. */
+static svn_error_t *
+start_parallel_delta(parallel_delta_t **pd_p,
+                     const struct context *c,
+                     apr_hash_t *s_entries,
+                     apr_hash_t *t_entries,
+                     const char *source_path,
+                     const char *target_path,
+                     const char *edit_path,
+                     apr_pool_t *pool)
+{
+  parallel_delta_t *pd;
+  svn_fs_t *source_fs = svn_fs_root_fs(c->source_root);
+  svn_fs_t *target_fs = svn_fs_root_fs(c->target_root);
   apr_hash_index_t *hi;
-  apr_pool_t *subpool;
+  int count = 0;
+  int capacity;
+  svn_error_t *err = SVN_NO_ERROR;
 
-  SVN_ERR_ASSERT(target_path);
+  *pd_p = NULL;
 
-  /* Compare the property lists.  */
-  SVN_ERR(delta_proplists(c, source_path, target_path,
-                          change_dir_prop, dir_baton, pool));
+  /* Iterate just like delta_dirs() will. */
+  for (hi = apr_hash_first(pool, t_entries); hi; hi = apr_hash_next(hi))
+    if (is_subtree_change(c, apr_hash_get(s_entries, apr_hash_this_key(hi),
+                                          apr_hash_this_key_len(hi)),
+                          apr_hash_this_val(hi)))
+      ++count;
+
+  if (count < 2)
+    return SVN_NO_ERROR;
+
+  pd = apr_pcalloc(pool, sizeof(*pd));
+  pd->c = c;
+  pd->source_fs_path = svn_fs_path(source_fs, pool);
+  pd->source_fs_config = svn_fs_config(source_fs, pool);
+  pd->source_rev = svn_fs_revision_root_revision(c->source_root);
+  pd->target_fs_path = svn_fs_path(target_fs, pool);
+  pd->target_fs_config = svn_fs_config(target_fs, pool);
+  pd->target_rev = svn_fs_revision_root_revision(c->target_root);
+
+  pd->jobs = apr_pcalloc(pool, count * sizeof(*pd->jobs));
+  for (hi = apr_hash_first(pool, t_entries); hi; hi = apr_hash_next(hi))
+    {
+      const svn_fs_dirent_t *t_entry = apr_hash_this_val(hi);
+      subtree_job_t *job;
+
+      if (!is_subtree_change(c, apr_hash_get(s_entries,
+                                             apr_hash_this_key(hi),
+                                             apr_hash_this_key_len(hi)),
+                             t_entry))
+        continue;
+
+      job = &pd->jobs[pd->job_count++];
+      job->source_path = svn_relpath_join(source_path, t_entry->name, pool);
+      job->target_path = svn_relpath_join(target_path, t_entry->name, pool);
+      job->edit_path = svn_relpath_join(edit_path, t_entry->name, pool);
+    }
 
-  /* Get the list of entries in each of source and target.  */
-  SVN_ERR(svn_fs_dir_entries(&t_entries, c->target_root,
-                             target_path, pool));
-  if (source_path)
-    SVN_ERR(svn_fs_dir_entries(&s_entries, c->source_root,
-                               source_path, pool));
+  SVN_ERR(svn_mutex__init(&pd->authz_mutex, TRUE, pool));
+
+  /* As with parallel dumps, let the workers run somewhat ahead such that
+     a single expensive sub-tree does not stall them. */
+  capacity = 4 * MIN(c->jobs, count);
+  SVN_ERR(svn_worker_pool__ordered_create(&pd->queue, MIN(c->jobs, count),
+                                          capacity, open_delta_context,
+                                          delta_subtree_item,
+                                          release_subtree_job, pd, pool));
+  if (!pd->queue)
+    return SVN_NO_ERROR;
+
+  while (!err && pd->next_job < MIN(pd->job_count, capacity))
+    err = svn_worker_pool__ordered_add(pd->queue, &pd->jobs[pd->next_job++]);
+
+  if (err)
+    return svn_error_trace(stop_parallel_delta(pd, err));
+
+  *pd_p = pd;
+
+  return SVN_NO_ERROR;
+}
+
+/* Wait for the comparison of the next sub-tree in PD to finish and send
+   its edit to the editor of the calling thread, below DIR_BATON.  Use
+   SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+replay_subtree(parallel_delta_t *pd,
+               void *dir_baton,
+               apr_pool_t *scratch_pool)
+{
+  subtree_job_t *job;
+  void *item;
+  svn_error_t *err;
+
+  SVN_ERR(svn_worker_pool__ordered_take(&item, &err, pd->queue, TRUE));
+  job = item;
+
+  /* Keep the workers busy. */
+  if (pd->next_job < pd->job_count)
+    err = svn_error_compose_create(err,
+            svn_worker_pool__ordered_add(pd->queue,
+                                         &pd->jobs[pd->next_job++]));
+
+  /* Even for a failed comparison, this is what the serial code would
+     have sent before failing. */
+  if (job->spool)
+    err = svn_error_compose_create(err,
+            svn_delta__replay_spool_into(job->spool, pd->c->editor,
+                                         dir_baton, scratch_pool));
+
+  svn_pool_destroy(job->pool);
+  job->pool = NULL;
+
+  return svn_error_trace(err);
+}
+
+#else
+
+/* Without thread support, there are no parallel comparisons. */
+typedef struct parallel_delta_t parallel_delta_t;
+
+#endif
+
+
+/* Emit deltas to turn SOURCE_PATH with S_ENTRIES into TARGET_PATH with
+   T_ENTRIES, except for the properties of the directory itself.  If PD
+   is not NULL, take the edits of the sub-trees from there instead of
+   comparing them here.  Otherwise like delta_dirs(). */
+static svn_error_t *
+delta_dir_entries(struct context *c,
+                  void *dir_baton,
+                  svn_depth_t depth,
+                  const char *source_path,
+                  const char *target_path,
+                  const char *edit_path,
+                  apr_hash_t *s_entries,
+                  apr_hash_t *t_entries,
+                  parallel_delta_t *pd,
+                  apr_pool_t *pool)
+{
+  apr_hash_index_t *hi;
+  apr_pool_t *subpool;
 
   /* Make a subpool for local allocations. */
   subpool = svn_pool_create(pool);
@@ -921,6 +1244,12 @@ delta_dirs(struct context *c,
                                           t_fullpath, e_fullpath, tgt_kind,
                                           subpool));
                 }
+#if APR_HAS_THREADS
+              else if (pd && is_subtree_change(c, s_entry, t_entry))
+                {
+                  SVN_ERR(replay_subtree(pd, dir_baton, subpool));
+                }
+#endif
               else
                 {
                   SVN_ERR(replace_file_or_dir(c, dir_baton,
@@ -981,3 +1310,53 @@ delta_dirs(struct context *c,
 
   return SVN_NO_ERROR;
 }
+
+
+/* Emit deltas to turn SOURCE_PATH into TARGET_PATH.  Assume that
+   DIR_BATON represents the directory we're constructing to the editor
+   in the context C.  */
+static svn_error_t *
+delta_dirs(struct context *c,
+           void *dir_baton,
+           svn_depth_t depth,
+           const char *source_path,
+           const char *target_path,
+           const char *edit_path,
+           apr_pool_t *pool)
+{
+  apr_hash_t *s_entries = 0, *t_entries = 0;
+  parallel_delta_t *pd = NULL;
+  svn_error_t *err;
+
+  SVN_ERR_ASSERT(target_path);
+
+  /* Compare the property lists.  */
+  SVN_ERR(delta_proplists(c, source_path, target_path,
+                          change_dir_prop, dir_baton, pool));
+
+  /* Get the list of entries in each of source and target.  */
+  SVN_ERR(svn_fs_dir_entries(&t_entries, c->target_root,
+                             target_path, pool));
+  if (source_path)
+    SVN_ERR(svn_fs_dir_entries(&s_entries, c->source_root,
+                               source_path, pool));
+
+#if APR_HAS_THREADS
+  /* Fan out at the first level that has several changed sub-trees.
+     Further down, the workers compare everything serially. */
+  if (c->jobs > 1 && s_entries && depth == svn_depth_infinity)
+    SVN_ERR(start_parallel_delta(&pd, c, s_entries, t_entries,
+                                 source_path, target_path, edit_path,
+                                 pool));
+#endif
+
+  err = delta_dir_entries(c, dir_baton, depth, source_path, target_path,
+                          edit_path, s_entries, t_entries, pd, pool);
+
+#if APR_HAS_THREADS
+  if (pd)
+    err = stop_parallel_delta(pd, err);
+#endif
+
+  return svn_error_trace(err);
+}
@@ -44,6 +44,8 @@
 #include "private/svn_sorts_private.h"
 #include "private/svn_utf_private.h"
 #include "private/svn_cache.h"
+#include "private/svn_subr_private.h"
+#include "private/svn_worker_pool.h"
 
 #define ARE_VALID_COPY_ARGS(p,r) ((p) && SVN_IS_VALID_REVNUM(r))
 
@@ -314,29 +316,46 @@ tracker_path_delete(path_tracker_t *tracker,
 }
 
 
-/* Compute the delta between OLDROOT/OLDPATH and NEWROOT/NEWPATH and
-   store it into a new temporary file *TEMPFILE.  OLDROOT may be NULL,
-   in which case the delta will be computed against an empty file, as
-   per the svn_fs_get_file_delta_stream docstring.  Record the length
-   of the temporary file in *LEN, and rewind the file before
-   returning. */
+/* Newest svndiff version of stored deltas that we copy into the dump
+   as they are.  Any loader since 1.4 can read svndiff1. */
+#define MAX_STORED_SVNDIFF_VERSION 1
+
+/* Set *DELTA to a readable stream of the svndiff delta between
+   OLDROOT/OLDPATH and NEWROOT/NEWPATH and *LEN to its length.  OLDROOT
+   may be NULL, in which case the delta will be computed against an empty
+   file, as per the svn_fs_get_file_delta_stream docstring.
+
+   Take the data straight from the repository if it is stored as such a
+   delta.  Otherwise, compute the delta and store it into a temporary
+   file first. */
 static svn_error_t *
-store_delta(apr_file_t **tempfile, svn_filesize_t *len,
+store_delta(svn_stream_t **delta, svn_filesize_t *len,
             svn_fs_root_t *oldroot, const char *oldpath,
             svn_fs_root_t *newroot, const char *newpath, apr_pool_t *pool)
 {
+  apr_file_t *tempfile;
   svn_stream_t *temp_stream;
   apr_off_t offset;
   svn_txdelta_stream_t *delta_stream;
   svn_txdelta_window_handler_t wh;
   void *whb;
 
+  if (oldroot)
+    {
+      SVN_ERR(svn_fs__get_stored_delta(delta, len, oldroot, oldpath,
+                                       newroot, newpath,
+                                       MAX_STORED_SVNDIFF_VERSION,
+                                       pool, pool));
+      if (*delta)
+        return SVN_NO_ERROR;
+    }
+
   /* Create a temporary file and open a stream to it. Note that we need
      the file handle in order to rewind it. */
-  SVN_ERR(svn_io_open_unique_file3(tempfile, NULL, NULL,
+  SVN_ERR(svn_io_open_unique_file3(&tempfile, NULL, NULL,
                                    svn_io_file_del_on_pool_cleanup,
                                    pool, pool));
-  temp_stream = svn_stream_from_aprfile2(*tempfile, TRUE, pool);
+  temp_stream = svn_stream_from_aprfile2(tempfile, TRUE, pool);
 
   /* Compute the delta and send it to the temporary file. */
   SVN_ERR(svn_fs_get_file_delta_stream(&delta_stream, oldroot, oldpath,
@@ -346,10 +365,15 @@ store_delta(apr_file_t **tempfile, svn_filesize_t *len,
   SVN_ERR(svn_txdelta_send_txstream(delta_stream, wh, whb, pool));
 
   /* Get the length of the temporary file and rewind it. */
-  SVN_ERR(svn_io_file_get_offset(&offset, *tempfile, pool));
+  SVN_ERR(svn_io_file_get_offset(&offset, tempfile, pool));
   *len = offset;
   offset = 0;
-  return svn_io_file_seek(*tempfile, APR_SET, &offset, pool);
+  SVN_ERR(svn_io_file_seek(tempfile, APR_SET, &offset, pool));
+
+  /* Make sure to close the underlying file when the stream is closed. */
+  *delta = svn_stream_from_aprfile2(tempfile, FALSE, pool);
+
+  return SVN_NO_ERROR;
 }
 
 
@@ -1100,7 +1124,7 @@ dump_node(struct edit_baton *eb,
   const char *compare_path = path;
   svn_revnum_t compare_rev = eb->current_rev - 1;
   svn_fs_root_t *compare_root = NULL;
-  apr_file_t *delta_file = NULL;
+  svn_stream_t *delta_contents = NULL;
   svn_repos__dumpfile_headers_t *headers
     = svn_repos__dumpfile_headers_create(pool);
   svn_filesize_t textlen;
@@ -1426,10 +1450,10 @@ dump_node(struct edit_baton *eb,
 
       if (eb->use_deltas)
         {
-          /* Compute the text delta now and write it into a temporary
-             file, so that we can find its length.  Output a header
-             saying our text contents are a delta. */
-          SVN_ERR(store_delta(&delta_file, &textlen, compare_root,
+          /* Fetch or compute the text delta now, so that we can find
+             its length.  Output a header saying our text contents are
+             a delta. */
+          SVN_ERR(store_delta(&delta_contents, &textlen, compare_root,
                               compare_path, eb->fs_root, path, pool));
           svn_repos__dumpfile_header_push(
             headers, SVN_REPOS_DUMPFILE_TEXT_DELTA, "true");
@@ -1489,12 +1513,8 @@ dump_node(struct edit_baton *eb,
     {
       svn_stream_t *contents;
 
-      if (delta_file)
-        {
-          /* Make sure to close the underlying file when the stream is
-             closed. */
-          contents = svn_stream_from_aprfile2(delta_file, FALSE, pool);
-        }
+      if (delta_contents)
+        contents = delta_contents;
       else
         SVN_ERR(svn_fs_file_contents(&contents, eb->fs_root, path, pool));
 
@@ -1992,26 +2012,406 @@ dump_filter_authz_func(svn_boolean_t *allowed,
 
 
 
-/* The main dumper. */
-svn_error_t *
-svn_repos_dump_fs4(svn_repos_t *repos,
-                   svn_stream_t *stream,
-                   svn_revnum_t start_rev,
-                   svn_revnum_t end_rev,
-                   svn_boolean_t incremental,
-                   svn_boolean_t use_deltas,
-                   svn_boolean_t include_revprops,
-                   svn_boolean_t include_changes,
-                   svn_repos_notify_func_t notify_func,
-                   void *notify_baton,
-                   svn_repos_dump_filter_func_t filter_func,
-                   void *filter_baton,
-                   svn_cancel_func_t cancel_func,
-                   void *cancel_baton,
-                   apr_pool_t *pool)
+/* Dump revision REV of REPOS to STREAM, as part of a dump starting at
+   START_REV.  INCREMENTAL, USE_DELTAS, INCLUDE_REVPROPS and INCLUDE_CHANGES
+   are the options of svn_repos_dump_fs5().  AUTHZ_FUNC and AUTHZ_BATON
+   implement the dump filter.  Set *FOUND_OLD_REFERENCE and
+   *FOUND_OLD_MERGEINFO, if the respective warnings have been issued;
+   they are never reset.  Send warnings to NOTIFY_FUNC with NOTIFY_BATON.
+   Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+dump_revision(svn_stream_t *stream,
+              svn_repos_t *repos,
+              svn_revnum_t rev,
+              svn_revnum_t start_rev,
+              svn_boolean_t incremental,
+              svn_boolean_t use_deltas,
+              svn_boolean_t include_revprops,
+              svn_boolean_t include_changes,
+              svn_repos_authz_func_t authz_func,
+              dump_filter_baton_t *authz_baton,
+              svn_boolean_t *found_old_reference,
+              svn_boolean_t *found_old_mergeinfo,
+              svn_repos_notify_func_t notify_func,
+              void *notify_baton,
+              apr_pool_t *scratch_pool)
 {
   const svn_delta_editor_t *dump_editor;
   void *dump_edit_baton = NULL;
+  svn_fs_t *fs = svn_repos_fs(repos);
+  svn_fs_root_t *to_root;
+  svn_boolean_t use_deltas_for_rev;
+
+  /* Write the revision record. */
+  SVN_ERR(write_revision_record(stream, repos, rev, include_revprops,
+                                authz_func, authz_baton, scratch_pool));
+
+  /* When dumping revision 0, we just write out the revision record.
+     The parser might want to use its properties.
+     If we don't want revision changes at all, skip in any case. */
+  if (rev == 0 || !include_changes)
+    return SVN_NO_ERROR;
+
+  /* Fetch the editor which dumps nodes to a file.  Regardless of
+     what we've been told, don't use deltas for the first rev of a
+     non-incremental dump. */
+  use_deltas_for_rev = use_deltas && (incremental || rev != start_rev);
+  SVN_ERR(get_dump_editor(&dump_editor, &dump_edit_baton, fs, rev,
+                          "", stream, found_old_reference,
+                          found_old_mergeinfo, NULL,
+                          notify_func, notify_baton,
+                          start_rev, use_deltas_for_rev, FALSE, FALSE,
+                          scratch_pool));
+
+  /* Drive the editor in one way or another. */
+  SVN_ERR(svn_fs_revision_root(&to_root, fs, rev, scratch_pool));
+
+  /* If this is the first revision of a non-incremental dump,
+     we're in for a full tree dump.  Otherwise, we want to simply
+     replay the revision.  */
+  if ((rev == start_rev) && (! incremental))
+    {
+      /* Compare against revision 0, so everything appears to be added. */
+      svn_fs_root_t *from_root;
+      SVN_ERR(svn_fs_revision_root(&from_root, fs, 0, scratch_pool));
+      SVN_ERR(svn_repos_dir_delta3(from_root, "", "",
+                                   to_root, "",
+                                   dump_editor, dump_edit_baton,
+                                   authz_func, authz_baton,
+                                   FALSE, /* don't send text-deltas */
+                                   svn_depth_infinity,
+                                   FALSE, /* don't send entry props */
+                                   FALSE, /* don't ignore ancestry */
+                                   1,
+                                   scratch_pool));
+    }
+  else
+    {
+      /* The normal case: compare consecutive revs. */
+      SVN_ERR(svn_repos_replay2(to_root, "", SVN_INVALID_REVNUM, FALSE,
+                                dump_editor, dump_edit_baton,
+                                authz_func, authz_baton, scratch_pool));
+
+      /* While our editor close_edit implementation is a no-op, we still
+         do this for completeness. */
+      SVN_ERR(dump_editor->close_edit(dump_edit_baton, scratch_pool));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+#if APR_HAS_THREADS
+
+/* Baton for buffer_notification. */
+typedef struct notify_buffer_t
+{
+  apr_array_header_t *notifications;
+  apr_pool_t *pool;
+} notify_buffer_t;
+
+/* Implements svn_repos_notify_func_t.  Append a copy of NOTIFY to the
+   notify_buffer_t in BATON. */
+static void
+buffer_notification(void *baton,
+                    const svn_repos_notify_t *notify,
+                    apr_pool_t *scratch_pool)
+{
+  notify_buffer_t *buffer = baton;
+  svn_repos_notify_t *copy = apr_pmemdup(buffer->pool, notify,
+                                         sizeof(*notify));
+
+  copy->warning_str = apr_pstrdup(buffer->pool, notify->warning_str);
+  copy->path = apr_pstrdup(buffer->pool, notify->path);
+
+  APR_ARRAY_PUSH(buffer->notifications, svn_repos_notify_t *) = copy;
+}
+
+/* Number of consecutive revisions that a dump worker handles at once. */
+#define DUMP_RANGE_SIZE 16
+
+/* Dump data of a range of revisions beyond this size will be spooled to
+   disk instead of being held in memory. */
+#define DUMP_SPOOL_SIZE (4 * 1024 * 1024)
+
+/* Options of a parallel dump run, as passed to svn_repos_dump_fs5. */
+typedef struct parallel_dump_t
+{
+  /* Where to find the repository and how to open its FS. */
+  const char *repos_path;
+  apr_hash_t *fs_config;
+
+  svn_revnum_t start_rev;
+  svn_boolean_t incremental;
+  svn_boolean_t use_deltas;
+  svn_boolean_t include_revprops;
+  svn_boolean_t include_changes;
+  svn_repos_authz_func_t authz_func;
+  dump_filter_baton_t *authz_baton;
+  svn_boolean_t want_notifications;
+  svn_cancel_func_t cancel_func;
+  void *cancel_baton;
+} parallel_dump_t;
+
+/* A range of revisions to dump in a worker thread. */
+typedef struct dump_item_t
+{
+  const parallel_dump_t *pd;
+  svn_revnum_t first_rev;
+  svn_revnum_t last_rev;
+
+  /* The dump data of the range, readable from its start.  Complete up to
+     the failed revision if dumping failed. */
+  svn_stream_t *contents;
+
+  /* Notifications sent while dumping, as svn_repos_notify_t *, in the
+     item's root pool.  NOTIFICATIONS is NULL if the caller did not ask
+     for notifications.  The pool is owned by the receiver. */
+  notify_buffer_t buffer;
+
+  /* Whether the respective warnings have been issued for this range. */
+  svn_boolean_t found_old_reference;
+  svn_boolean_t found_old_mergeinfo;
+} dump_item_t;
+
+/* Implements svn_worker_pool__open_func_t.  BATON is the
+   parallel_dump_t. */
+static svn_error_t *
+open_dump_repos(void **thread_baton,
+                void *baton,
+                apr_pool_t *thread_pool)
+{
+  parallel_dump_t *pd = baton;
+  svn_repos_t *repos;
+
+  /* svn_fs_t instances must not be shared between threads. */
+  SVN_ERR(svn_repos_open3(&repos, pd->repos_path, pd->fs_config,
+                          thread_pool, thread_pool));
+  svn_fs__set_bulk_scan(svn_repos_fs(repos), TRUE);
+
+  *thread_baton = repos;
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_worker_pool__item_func_t.  ITEM is a dump_item_t,
+   THREAD_BATON the svn_repos_t to dump it from. */
+static svn_error_t *
+dump_item(void *item,
+          void *thread_baton,
+          apr_pool_t *scratch_pool)
+{
+  dump_item_t *di = item;
+  const parallel_dump_t *pd = di->pd;
+  svn_repos_notify_t *notify = NULL;
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  svn_revnum_t rev;
+
+  if (pd->want_notifications)
+    notify = svn_repos_notify_create(svn_repos_notify_dump_rev_end,
+                                     scratch_pool);
+
+  for (rev = di->first_rev; rev <= di->last_rev; rev++)
+    {
+      svn_pool_clear(iterpool);
+
+      if (pd->cancel_func)
+        SVN_ERR(pd->cancel_func(pd->cancel_baton));
+
+      SVN_ERR(dump_revision(di->contents, thread_baton, rev, pd->start_rev,
+                            pd->incremental, pd->use_deltas,
+                            pd->include_revprops, pd->include_changes,
+                            pd->authz_func, pd->authz_baton,
+                            &di->found_old_reference,
+                            &di->found_old_mergeinfo,
+                            pd->want_notifications
+                              ? buffer_notification : NULL,
+                            &di->buffer, iterpool));
+
+      /* Queue the progress notification for this revision. */
+      if (notify)
+        {
+          notify->revision = rev;
+          buffer_notification(&di->buffer, notify, iterpool);
+        }
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_worker_pool__release_func_t for dump_item_t. */
+static void
+release_dump_item(void *item)
+{
+  dump_item_t *di = item;
+
+  svn_pool_destroy(di->buffer.pool);
+}
+
+/* Queue the range of at most DUMP_RANGE_SIZE revisions starting at
+   FIRST_REV and ending no later than END_REV for dumping according to PD
+   in QUEUE. */
+static svn_error_t *
+add_dump_item(svn_worker_pool__ordered_t *queue,
+              const parallel_dump_t *pd,
+              svn_revnum_t first_rev,
+              svn_revnum_t end_rev)
+{
+  /* The receiver will destroy that pool, so it must not share an
+     allocator with any pool that we are still using. */
+  apr_pool_t *pool = apr_allocator_owner_get(svn_pool_create_allocator(FALSE));
+  dump_item_t *di = apr_pcalloc(pool, sizeof(*di));
+
+  di->pd = pd;
+  di->first_rev = first_rev;
+  di->last_rev = MIN(first_rev + DUMP_RANGE_SIZE - 1, end_rev);
+  di->contents = svn_stream__from_spillbuf(
+                   svn_spillbuf__create(SVN__STREAM_CHUNK_SIZE,
+                                        DUMP_SPOOL_SIZE, pool),
+                   pool);
+  di->buffer.pool = pool;
+  di->buffer.notifications = pd->want_notifications
+                           ? apr_array_make(pool, 0,
+                                            sizeof(svn_repos_notify_t *))
+                           : NULL;
+
+  return svn_error_trace(svn_worker_pool__ordered_add(queue, di));
+}
+
+/* Dump the revisions START_REV to END_REV of REPOS to STREAM using up to
+   JOBS worker threads, in ranges of DUMP_RANGE_SIZE revisions.  Write the
+   data and deliver the notifications in revision order, just like the
+   serial loop in svn_repos_dump_fs5 does.  Set *DUMPED to FALSE, without
+   dumping anything, if no thread could be started.  The other parameters
+   are the same as for dump_revision().  Use POOL for allocations. */
+static svn_error_t *
+dump_revisions_in_parallel(svn_boolean_t *dumped,
+                           svn_stream_t *stream,
+                           svn_repos_t *repos,
+                           svn_revnum_t start_rev,
+                           svn_revnum_t end_rev,
+                           int jobs,
+                           svn_boolean_t incremental,
+                           svn_boolean_t use_deltas,
+                           svn_boolean_t include_revprops,
+                           svn_boolean_t include_changes,
+                           svn_repos_authz_func_t authz_func,
+                           dump_filter_baton_t *authz_baton,
+                           svn_boolean_t *found_old_reference,
+                           svn_boolean_t *found_old_mergeinfo,
+                           svn_repos_notify_func_t notify_func,
+                           void *notify_baton,
+                           svn_cancel_func_t cancel_func,
+                           void *cancel_baton,
+                           apr_pool_t *pool)
+{
+  parallel_dump_t *pd = apr_pcalloc(pool, sizeof(*pd));
+  svn_worker_pool__ordered_t *queue;
+  apr_pool_t *iterpool;
+  svn_revnum_t rev, next_rev;
+  int capacity;
+
+  pd->repos_path = svn_repos_path(repos, pool);
+  pd->fs_config = svn_fs_config(svn_repos_fs(repos), pool);
+  pd->start_rev = start_rev;
+  pd->incremental = incremental;
+  pd->use_deltas = use_deltas;
+  pd->include_revprops = include_revprops;
+  pd->include_changes = include_changes;
+  pd->authz_func = authz_func;
+  pd->authz_baton = authz_baton;
+  pd->want_notifications = notify_func != NULL;
+  pd->cancel_func = cancel_func;
+  pd->cancel_baton = cancel_baton;
+
+  /* As with verification, let the workers run somewhat ahead such that
+     a single expensive range does not stall them. */
+  capacity = 4 * jobs;
+  SVN_ERR(svn_worker_pool__ordered_create(&queue, jobs, capacity,
+                                          open_dump_repos, dump_item,
+                                          release_dump_item, pd, pool));
+  *dumped = queue != NULL;
+  if (!queue)
+    return SVN_NO_ERROR;
+
+  /* Write the ranges in revision order. */
+  iterpool = svn_pool_create(pool);
+  next_rev = start_rev;
+  for (rev = start_rev; rev <= end_rev; rev += DUMP_RANGE_SIZE)
+    {
+      dump_item_t *di;
+      void *item;
+      svn_error_t *item_err;
+      svn_error_t *err = SVN_NO_ERROR;
+      int i;
+
+      svn_pool_clear(iterpool);
+
+      while (   !err
+             && next_rev <= end_rev
+             && next_rev < rev + capacity * DUMP_RANGE_SIZE)
+        {
+          err = add_dump_item(queue, pd, next_rev, end_rev);
+          next_rev += DUMP_RANGE_SIZE;
+        }
+
+      if (!err)
+        err = svn_worker_pool__ordered_take(&item, &item_err, queue, TRUE);
+      if (err)
+        return svn_error_trace(svn_worker_pool__ordered_destroy(queue, err));
+
+      di = item;
+
+      /* Pass on what the worker produced.  Even for a failed range, this
+         is what the serial dump would have written before failing. */
+      err = svn_stream_copy3(di->contents,
+                             svn_stream_disown(stream, iterpool),
+                             NULL, NULL, iterpool);
+      if (!err && di->buffer.notifications)
+        for (i = 0; i < di->buffer.notifications->nelts; ++i)
+          notify_func(notify_baton,
+                      APR_ARRAY_IDX(di->buffer.notifications, i,
+                                    svn_repos_notify_t *),
+                      iterpool);
+
+      *found_old_reference |= di->found_old_reference;
+      *found_old_mergeinfo |= di->found_old_mergeinfo;
+
+      svn_pool_destroy(di->buffer.pool);
+
+      err = svn_error_compose_create(err, item_err);
+      if (err)
+        return svn_error_trace(svn_worker_pool__ordered_destroy(queue, err));
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return svn_error_trace(svn_worker_pool__ordered_destroy(queue,
+                                                          SVN_NO_ERROR));
+}
+
+#endif
+
+/* The main dumper.  Implements svn_repos_dump_fs5() except for the
+   bulk scan hint. */
+static svn_error_t *
+dump_fs(svn_repos_t *repos,
+        svn_stream_t *stream,
+        svn_revnum_t start_rev,
+        svn_revnum_t end_rev,
+        svn_boolean_t incremental,
+        svn_boolean_t use_deltas,
+        svn_boolean_t include_revprops,
+        svn_boolean_t include_changes,
+        int jobs,
+        svn_repos_notify_func_t notify_func,
+        void *notify_baton,
+        svn_repos_dump_filter_func_t filter_func,
+        void *filter_baton,
+        svn_cancel_func_t cancel_func,
+        void *cancel_baton,
+        apr_pool_t *pool)
+{
   svn_revnum_t rev;
   svn_fs_t *fs = svn_repos_fs(repos);
   apr_pool_t *iterpool = svn_pool_create(pool);
@@ -2023,6 +2423,7 @@ svn_repos_dump_fs4(svn_repos_t *repos,
   svn_repos_notify_t *notify;
   svn_repos_authz_func_t authz_func;
   dump_filter_baton_t authz_baton = {0};
+  svn_boolean_t dumped = FALSE;
 
   /* Make sure we catch up on the latest revprop changes.  This is the only
    * time we will refresh the revprop data in this query. */
@@ -2087,73 +2488,38 @@ svn_repos_dump_fs4(svn_repos_t *repos,
     notify = svn_repos_notify_create(svn_repos_notify_dump_rev_end,
                                      pool);
 
+#if APR_HAS_THREADS
+  if (jobs > 1 && end_rev - start_rev >= DUMP_RANGE_SIZE)
+    SVN_ERR(dump_revisions_in_parallel(&dumped, stream, repos,
+                                       start_rev, end_rev,
+                                       (int)MIN(jobs,
+                                                (end_rev - start_rev)
+                                                  / DUMP_RANGE_SIZE + 1),
+                                       incremental, use_deltas,
+                                       include_revprops, include_changes,
+                                       authz_func, &authz_baton,
+                                       &found_old_reference,
+                                       &found_old_mergeinfo,
+                                       notify_func, notify_baton,
+                                       cancel_func, cancel_baton,
+                                       iterpool));
+#endif
+
   /* Main loop:  we're going to dump revision REV.  */
-  for (rev = start_rev; rev <= end_rev; rev++)
+  for (rev = start_rev; rev <= end_rev && !dumped; rev++)
     {
-      svn_fs_root_t *to_root;
-      svn_boolean_t use_deltas_for_rev;
-
       svn_pool_clear(iterpool);
 
       /* Check for cancellation. */
       if (cancel_func)
         SVN_ERR(cancel_func(cancel_baton));
 
-      /* Write the revision record. */
-      SVN_ERR(write_revision_record(stream, repos, rev, include_revprops,
-                                    authz_func, &authz_baton, iterpool));
-
-      /* When dumping revision 0, we just write out the revision record.
-         The parser might want to use its properties.
-         If we don't want revision changes at all, skip in any case. */
-      if (rev == 0 || !include_changes)
-        goto loop_end;
-
-      /* Fetch the editor which dumps nodes to a file.  Regardless of
-         what we've been told, don't use deltas for the first rev of a
-         non-incremental dump. */
-      use_deltas_for_rev = use_deltas && (incremental || rev != start_rev);
-      SVN_ERR(get_dump_editor(&dump_editor, &dump_edit_baton, fs, rev,
-                              "", stream, &found_old_reference,
-                              &found_old_mergeinfo, NULL,
-                              notify_func, notify_baton,
-                              start_rev, use_deltas_for_rev, FALSE, FALSE,
-                              iterpool));
-
-      /* Drive the editor in one way or another. */
-      SVN_ERR(svn_fs_revision_root(&to_root, fs, rev, iterpool));
-
-      /* If this is the first revision of a non-incremental dump,
-         we're in for a full tree dump.  Otherwise, we want to simply
-         replay the revision.  */
-      if ((rev == start_rev) && (! incremental))
-        {
-          /* Compare against revision 0, so everything appears to be added. */
-          svn_fs_root_t *from_root;
-          SVN_ERR(svn_fs_revision_root(&from_root, fs, 0, iterpool));
-          SVN_ERR(svn_repos_dir_delta2(from_root, "", "",
-                                       to_root, "",
-                                       dump_editor, dump_edit_baton,
-                                       authz_func, &authz_baton,
-                                       FALSE, /* don't send text-deltas */
-                                       svn_depth_infinity,
-                                       FALSE, /* don't send entry props */
-                                       FALSE, /* don't ignore ancestry */
-                                       iterpool));
-        }
-      else
-        {
-          /* The normal case: compare consecutive revs. */
-          SVN_ERR(svn_repos_replay2(to_root, "", SVN_INVALID_REVNUM, FALSE,
-                                    dump_editor, dump_edit_baton,
-                                    authz_func, &authz_baton, iterpool));
-
-          /* While our editor close_edit implementation is a no-op, we still
-             do this for completeness. */
-          SVN_ERR(dump_editor->close_edit(dump_edit_baton, iterpool));
-        }
+      SVN_ERR(dump_revision(stream, repos, rev, start_rev, incremental,
+                            use_deltas, include_revprops, include_changes,
+                            authz_func, &authz_baton,
+                            &found_old_reference, &found_old_mergeinfo,
+                            notify_func, notify_baton, iterpool));
 
-    loop_end:
       if (notify_func)
         {
           notify->revision = rev;
@@ -2199,6 +2565,39 @@ svn_repos_dump_fs4(svn_repos_t *repos,
   return SVN_NO_ERROR;
 }
 
+svn_error_t *
+svn_repos_dump_fs5(svn_repos_t *repos,
+                   svn_stream_t *stream,
+                   svn_revnum_t start_rev,
+                   svn_revnum_t end_rev,
+                   svn_boolean_t incremental,
+                   svn_boolean_t use_deltas,
+                   svn_boolean_t include_revprops,
+                   svn_boolean_t include_changes,
+                   int jobs,
+                   svn_repos_notify_func_t notify_func,
+                   void *notify_baton,
+                   svn_repos_dump_filter_func_t filter_func,
+                   void *filter_baton,
+                   svn_cancel_func_t cancel_func,
+                   void *cancel_baton,
+                   apr_pool_t *pool)
+{
+  svn_fs_t *fs = svn_repos_fs(repos);
+  svn_boolean_t was_bulk_scan = svn_fs__is_bulk_scan(fs);
+  svn_error_t *err;
+
+  /* Most of the data being dumped will not be needed again soon. */
+  svn_fs__set_bulk_scan(fs, TRUE);
+  err = dump_fs(repos, stream, start_rev, end_rev, incremental, use_deltas,
+                include_revprops, include_changes, jobs,
+                notify_func, notify_baton, filter_func, filter_baton,
+                cancel_func, cancel_baton, pool);
+  svn_fs__set_bulk_scan(fs, was_bulk_scan);
+
+  return svn_error_trace(err);
+}
+
 
 /*----------------------------------------------------------------------*/
 
@@ -2433,19 +2832,231 @@ report_error(svn_revnum_t revision,
     }
 }
 
-svn_error_t *
-svn_repos_verify_fs3(svn_repos_t *repos,
-                     svn_revnum_t start_rev,
-                     svn_revnum_t end_rev,
-                     svn_boolean_t check_normalization,
-                     svn_boolean_t metadata_only,
-                     svn_repos_notify_func_t notify_func,
-                     void *notify_baton,
-                     svn_repos_verify_callback_t verify_callback,
-                     void *verify_baton,
-                     svn_cancel_func_t cancel_func,
-                     void *cancel_baton,
-                     apr_pool_t *pool)
+#if APR_HAS_THREADS
+
+/* Options of a parallel verification run, as passed to
+   svn_repos_verify_fs4. */
+typedef struct parallel_verify_t
+{
+  /* Where to find the repository's FS and how to open it. */
+  const char *fs_path;
+  apr_hash_t *fs_config;
+
+  svn_revnum_t start_rev;
+  svn_boolean_t check_normalization;
+  svn_boolean_t want_notifications;
+  svn_cancel_func_t cancel_func;
+  void *cancel_baton;
+} parallel_verify_t;
+
+/* A revision to verify in a worker thread. */
+typedef struct verify_item_t
+{
+  const parallel_verify_t *pv;
+  svn_revnum_t rev;
+
+  /* Notifications sent while verifying, as svn_repos_notify_t *, in the
+     item's root pool.  NOTIFICATIONS is NULL if the caller did not ask
+     for notifications.  The pool is owned by the receiver. */
+  notify_buffer_t buffer;
+} verify_item_t;
+
+/* Implements svn_worker_pool__open_func_t.  BATON is the
+   parallel_verify_t. */
+static svn_error_t *
+open_verify_fs(void **thread_baton,
+               void *baton,
+               apr_pool_t *thread_pool)
+{
+  parallel_verify_t *pv = baton;
+  svn_fs_t *fs;
+
+  /* svn_fs_t instances must not be shared between threads. */
+  SVN_ERR(svn_fs_open2(&fs, pv->fs_path, pv->fs_config,
+                       thread_pool, thread_pool));
+  svn_fs__set_bulk_scan(fs, TRUE);
+
+  *thread_baton = fs;
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_worker_pool__item_func_t.  ITEM is a verify_item_t,
+   THREAD_BATON the svn_fs_t to verify it in. */
+static svn_error_t *
+verify_item(void *item,
+            void *thread_baton,
+            apr_pool_t *scratch_pool)
+{
+  verify_item_t *vi = item;
+  const parallel_verify_t *pv = vi->pv;
+
+  return svn_error_trace(verify_one_revision(thread_baton, vi->rev,
+                                             pv->want_notifications
+                                               ? buffer_notification
+                                               : NULL,
+                                             &vi->buffer, pv->start_rev,
+                                             pv->check_normalization,
+                                             pv->cancel_func,
+                                             pv->cancel_baton,
+                                             scratch_pool));
+}
+
+/* Implements svn_worker_pool__release_func_t for verify_item_t. */
+static void
+release_verify_item(void *item)
+{
+  verify_item_t *vi = item;
+
+  svn_pool_destroy(vi->buffer.pool);
+}
+
+/* Queue REV for verification according to PV in QUEUE. */
+static svn_error_t *
+add_verify_item(svn_worker_pool__ordered_t *queue,
+                const parallel_verify_t *pv,
+                svn_revnum_t rev)
+{
+  /* The receiver will destroy that pool, so it must not share an
+     allocator with any pool that we are still using. */
+  apr_pool_t *pool = apr_allocator_owner_get(svn_pool_create_allocator(FALSE));
+  verify_item_t *vi = apr_pcalloc(pool, sizeof(*vi));
+
+  vi->pv = pv;
+  vi->rev = rev;
+  vi->buffer.pool = pool;
+  vi->buffer.notifications = pv->want_notifications
+                           ? apr_array_make(pool, 0,
+                                            sizeof(svn_repos_notify_t *))
+                           : NULL;
+
+  return svn_error_trace(svn_worker_pool__ordered_add(queue, vi));
+}
+
+/* Verify the revisions START_REV to END_REV in FS using up to JOBS worker
+   threads.  Deliver notifications and failures to the other parameters
+   in revision order, just as the serial loop in svn_repos_verify_fs4
+   does.  Set *VERIFIED to FALSE, without verifying anything, if no thread
+   could be started.  NOTIFY is the reusable svn_repos_notify_verify_rev_end
+   object to use, if NOTIFY_FUNC is not NULL.  Use POOL for allocations. */
+static svn_error_t *
+verify_revisions_in_parallel(svn_boolean_t *verified,
+                             svn_fs_t *fs,
+                             svn_revnum_t start_rev,
+                             svn_revnum_t end_rev,
+                             int jobs,
+                             svn_boolean_t check_normalization,
+                             svn_repos_notify_t *notify,
+                             svn_repos_notify_func_t notify_func,
+                             void *notify_baton,
+                             svn_repos_verify_callback_t verify_callback,
+                             void *verify_baton,
+                             svn_cancel_func_t cancel_func,
+                             void *cancel_baton,
+                             apr_pool_t *pool)
+{
+  parallel_verify_t *pv = apr_pcalloc(pool, sizeof(*pv));
+  svn_worker_pool__ordered_t *queue;
+  apr_pool_t *iterpool;
+  svn_revnum_t rev, next_rev;
+  int capacity;
+
+  pv->fs_path = svn_fs_path(fs, pool);
+  pv->fs_config = svn_fs_config(fs, pool);
+  pv->start_rev = start_rev;
+  pv->check_normalization = check_normalization;
+  pv->want_notifications = notify_func != NULL;
+  pv->cancel_func = cancel_func;
+  pv->cancel_baton = cancel_baton;
+
+  /* Let the workers run somewhat ahead of the reporting such that a single
+     slow revision does not stall them.  Beyond that, limit the number of
+     buffered results. */
+  capacity = 4 * jobs;
+  SVN_ERR(svn_worker_pool__ordered_create(&queue, jobs, capacity,
+                                          open_verify_fs, verify_item,
+                                          release_verify_item, pv, pool));
+  *verified = queue != NULL;
+  if (!queue)
+    return SVN_NO_ERROR;
+
+  /* Report the results in revision order. */
+  iterpool = svn_pool_create(pool);
+  next_rev = start_rev;
+  for (rev = start_rev; rev <= end_rev; rev++)
+    {
+      verify_item_t *vi;
+      void *item;
+      svn_error_t *item_err;
+      svn_error_t *err = SVN_NO_ERROR;
+      int i;
+
+      svn_pool_clear(iterpool);
+
+      while (!err && next_rev <= end_rev && next_rev < rev + capacity)
+        err = add_verify_item(queue, pv, next_rev++);
+
+      if (!err)
+        err = svn_worker_pool__ordered_take(&item, &item_err, queue, TRUE);
+      if (err)
+        return svn_error_trace(svn_worker_pool__ordered_destroy(queue, err));
+
+      vi = item;
+
+      /* Replay what the worker saw. */
+      if (vi->buffer.notifications)
+        for (i = 0; i < vi->buffer.notifications->nelts; ++i)
+          notify_func(notify_baton,
+                      APR_ARRAY_IDX(vi->buffer.notifications, i,
+                                    svn_repos_notify_t *),
+                      iterpool);
+
+      svn_pool_destroy(vi->buffer.pool);
+
+      err = item_err;
+      if (err && err->apr_err == SVN_ERR_CANCELLED)
+        {
+          return svn_error_trace(svn_worker_pool__ordered_destroy(queue,
+                                                                  err));
+        }
+      else if (err)
+        {
+          err = report_error(rev, err, verify_callback, verify_baton,
+                             iterpool);
+          if (err)
+            return svn_error_trace(svn_worker_pool__ordered_destroy(queue,
+                                                                    err));
+        }
+      else if (notify_func)
+        {
+          /* Tell the caller that we're done with this revision. */
+          notify->revision = rev;
+          notify_func(notify_baton, notify, iterpool);
+        }
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return svn_error_trace(svn_worker_pool__ordered_destroy(queue,
+                                                          SVN_NO_ERROR));
+}
+
+#endif
+
+/* Implements svn_repos_verify_fs4() except for the bulk scan hint. */
+static svn_error_t *
+verify_fs(svn_repos_t *repos,
+          svn_revnum_t start_rev,
+          svn_revnum_t end_rev,
+          svn_boolean_t check_normalization,
+          svn_boolean_t metadata_only,
+          int jobs,
+          svn_repos_notify_func_t notify_func,
+          void *notify_baton,
+          svn_repos_verify_callback_t verify_callback,
+          void *verify_baton,
+          svn_cancel_func_t cancel_func,
+          void *cancel_baton,
+          apr_pool_t *pool)
 {
   svn_fs_t *fs = svn_repos_fs(repos);
   svn_revnum_t youngest;
@@ -2454,6 +3065,7 @@ svn_repos_verify_fs3(svn_repos_t *repos,
   svn_repos_notify_t *notify;
   svn_fs_progress_notify_func_t verify_notify = NULL;
   struct verify_fs_notify_func_baton_t *verify_notify_baton = NULL;
+  svn_boolean_t verified = FALSE;
   svn_error_t *err;
 
   /* Make sure we catch up on the latest revprop changes.  This is the only
@@ -2511,7 +3123,19 @@ svn_repos_verify_fs3(svn_repos_t *repos,
                            verify_baton, iterpool));
     }
 
-  if (!metadata_only)
+#if APR_HAS_THREADS
+  if (!metadata_only && jobs > 1 && start_rev < end_rev)
+    SVN_ERR(verify_revisions_in_parallel(&verified, fs, start_rev, end_rev,
+                                         (int)MIN(jobs,
+                                                  end_rev - start_rev + 1),
+                                         check_normalization,
+                                         notify, notify_func, notify_baton,
+                                         verify_callback, verify_baton,
+                                         cancel_func, cancel_baton,
+                                         iterpool));
+#endif
+
+  if (!metadata_only && !verified)
     for (rev = start_rev; rev <= end_rev; rev++)
       {
         svn_pool_clear(iterpool);
@@ -2550,3 +3174,33 @@ svn_repos_verify_fs3(svn_repos_t *repos,
 
   return SVN_NO_ERROR;
 }
+
+svn_error_t *
+svn_repos_verify_fs4(svn_repos_t *repos,
+                     svn_revnum_t start_rev,
+                     svn_revnum_t end_rev,
+                     svn_boolean_t check_normalization,
+                     svn_boolean_t metadata_only,
+                     int jobs,
+                     svn_repos_notify_func_t notify_func,
+                     void *notify_baton,
+                     svn_repos_verify_callback_t verify_callback,
+                     void *verify_baton,
+                     svn_cancel_func_t cancel_func,
+                     void *cancel_baton,
+                     apr_pool_t *pool)
+{
+  svn_fs_t *fs = svn_repos_fs(repos);
+  svn_boolean_t was_bulk_scan = svn_fs__is_bulk_scan(fs);
+  svn_error_t *err;
+
+  /* Verification reads all data once. */
+  svn_fs__set_bulk_scan(fs, TRUE);
+  err = verify_fs(repos, start_rev, end_rev, check_normalization,
+                  metadata_only, jobs, notify_func, notify_baton,
+                  verify_callback, verify_baton, cancel_func, cancel_baton,
+                  pool);
+  svn_fs__set_bulk_scan(fs, was_bulk_scan);
+
+  return svn_error_trace(err);
+}
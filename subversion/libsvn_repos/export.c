@@ -0,0 +1,348 @@
+/* export.c : exporting repository trees into archives
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include <apr_pools.h>
+
+#include "svn_pools.h"
+#include "svn_error.h"
+#include "svn_dirent_uri.h"
+#include "svn_hash.h"
+#include "svn_path.h"
+#include "svn_props.h"
+#include "svn_repos.h"
+#include "svn_subst.h"
+#include "svn_time.h"
+
+#include "private/svn_fs_private.h"
+#include "private/svn_fspath.h"
+#include "private/svn_sorts_private.h"
+#include "private/svn_tar.h"
+#include "svn_private_config.h"
+
+#include "repos.h"
+
+
+
+/* The svn:date and svn:author of a revision. */
+typedef struct rev_info_t
+{
+  apr_time_t date;
+  const char *author;
+} rev_info_t;
+
+/* Data shared by all nodes of an export. */
+typedef struct export_baton_t
+{
+  svn_tar__writer_t *tar;
+  svn_fs_root_t *root;
+  svn_boolean_t ignore_keywords;
+  const char *native_eol;
+  const char *repos_root_url;
+  svn_repos_authz_func_t authz_read_func;
+  void *authz_read_baton;
+  svn_cancel_func_t cancel_func;
+  void *cancel_baton;
+
+  /* Timestamp for nodes without a committed revision. */
+  apr_time_t default_mtime;
+
+  /* svn_revnum_t -> rev_info_t *, for the revisions seen so far. */
+  apr_hash_t *rev_infos;
+
+  /* Pool for REV_INFOS. */
+  apr_pool_t *pool;
+} export_baton_t;
+
+/* Set *INFO to the date and author of REVISION, cached in EB.  Use
+   SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+get_rev_info(const rev_info_t **info,
+             export_baton_t *eb,
+             svn_revnum_t revision,
+             apr_pool_t *scratch_pool)
+{
+  rev_info_t *result = apr_hash_get(eb->rev_infos, &revision,
+                                    sizeof(revision));
+
+  if (!result)
+    {
+      svn_fs_t *fs = svn_fs_root_fs(eb->root);
+      svn_revnum_t *key = apr_palloc(eb->pool, sizeof(*key));
+      svn_string_t *value;
+
+      result = apr_pcalloc(eb->pool, sizeof(*result));
+
+      SVN_ERR(svn_fs_revision_prop2(&value, fs, revision,
+                                    SVN_PROP_REVISION_DATE, FALSE,
+                                    scratch_pool, scratch_pool));
+      if (value)
+        SVN_ERR(svn_time_from_cstring(&result->date, value->data,
+                                      scratch_pool));
+
+      SVN_ERR(svn_fs_revision_prop2(&value, fs, revision,
+                                    SVN_PROP_REVISION_AUTHOR, FALSE,
+                                    scratch_pool, scratch_pool));
+      if (value)
+        result->author = apr_pstrmemdup(eb->pool, value->data, value->len);
+
+      *key = revision;
+      apr_hash_set(eb->rev_infos, key, sizeof(*key), result);
+    }
+
+  *info = result;
+  return SVN_NO_ERROR;
+}
+
+/* Set *REVISION to the revision in which PATH was last changed, and *DATE
+   and *AUTHOR to that revision's properties.  Nodes changed in a
+   transaction get an invalid *REVISION, the default date of EB and no
+   author. */
+static svn_error_t *
+get_last_change(svn_revnum_t *revision,
+                apr_time_t *date,
+                const char **author,
+                export_baton_t *eb,
+                const char *path,
+                apr_pool_t *scratch_pool)
+{
+  const rev_info_t *info;
+
+  SVN_ERR(svn_fs_node_created_rev(revision, eb->root, path, scratch_pool));
+  if (!SVN_IS_VALID_REVNUM(*revision))
+    {
+      *date = eb->default_mtime;
+      *author = NULL;
+      return SVN_NO_ERROR;
+    }
+
+  SVN_ERR(get_rev_info(&info, eb, *revision, scratch_pool));
+  *date = info->date ? info->date : eb->default_mtime;
+  *author = info->author;
+
+  return SVN_NO_ERROR;
+}
+
+/* Add the file at PATH to the archive as ARCHIVE_RELPATH. */
+static svn_error_t *
+export_file(export_baton_t *eb,
+            const char *path,
+            const char *archive_relpath,
+            apr_pool_t *scratch_pool)
+{
+  apr_hash_t *props;
+  svn_string_t *eol_style;
+  svn_string_t *keywords_val;
+  apr_hash_t *keywords = NULL;
+  svn_stream_t *contents;
+  svn_filesize_t size;
+  svn_revnum_t revision;
+  apr_time_t date;
+  const char *author;
+
+  SVN_ERR(svn_fs_node_proplist(&props, eb->root, path, scratch_pool));
+  SVN_ERR(get_last_change(&revision, &date, &author, eb, path,
+                          scratch_pool));
+
+  eol_style = svn_hash_gets(props, SVN_PROP_EOL_STYLE);
+  keywords_val = svn_hash_gets(props, SVN_PROP_KEYWORDS);
+  if (keywords_val && !eb->ignore_keywords)
+    {
+      const char *url = svn_path_url_add_component2(eb->repos_root_url,
+                                                    path + 1,
+                                                    scratch_pool);
+
+      SVN_ERR(svn_subst_build_keywords3(&keywords, keywords_val->data,
+                                        SVN_IS_VALID_REVNUM(revision)
+                                          ? apr_psprintf(scratch_pool,
+                                                         "%ld", revision)
+                                          : "",
+                                        url, eb->repos_root_url, date,
+                                        author ? author : "",
+                                        scratch_pool));
+    }
+
+  SVN_ERR(svn_fs_file_length(&size, eb->root, path, scratch_pool));
+  SVN_ERR(svn_fs_file_contents(&contents, eb->root, path, scratch_pool));
+
+  return svn_error_trace(svn_tar__add_versioned_file(
+                           eb->tar, archive_relpath, contents, size,
+                           eol_style ? eol_style->data : NULL,
+                           eb->native_eol, keywords,
+                           svn_hash_gets(props, SVN_PROP_SPECIAL) != NULL,
+                           svn_hash_gets(props, SVN_PROP_EXECUTABLE) != NULL,
+                           date, eb->cancel_func, eb->cancel_baton,
+                           scratch_pool));
+}
+
+/* Add the directory at PATH to the archive as ARCHIVE_RELPATH, followed
+   by its contents down to DEPTH.  Don't add an entry for the directory
+   itself if ARCHIVE_RELPATH is empty. */
+static svn_error_t *
+export_directory(export_baton_t *eb,
+                 const char *path,
+                 const char *archive_relpath,
+                 svn_depth_t depth,
+                 apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool;
+  apr_hash_t *entries;
+  apr_array_header_t *sorted;
+  int i;
+
+  if (*archive_relpath)
+    {
+      svn_revnum_t revision;
+      apr_time_t date;
+      const char *author;
+
+      SVN_ERR(get_last_change(&revision, &date, &author, eb, path,
+                              scratch_pool));
+      SVN_ERR(svn_tar__add_directory(eb->tar, archive_relpath, date,
+                                     scratch_pool));
+    }
+
+  if (depth == svn_depth_empty)
+    return SVN_NO_ERROR;
+
+  /* Sort the entries, so the same tree always gives the same archive. */
+  SVN_ERR(svn_fs_dir_entries(&entries, eb->root, path, scratch_pool));
+  sorted = svn_sort__hash(entries, svn_sort_compare_items_lexically,
+                          scratch_pool);
+
+  iterpool = svn_pool_create(scratch_pool);
+  for (i = 0; i < sorted->nelts; i++)
+    {
+      const svn_fs_dirent_t *dirent
+        = APR_ARRAY_IDX(sorted, i, svn_sort__item_t).value;
+      const char *child_path;
+      const char *child_relpath;
+
+      svn_pool_clear(iterpool);
+
+      if (eb->cancel_func)
+        SVN_ERR(eb->cancel_func(eb->cancel_baton));
+
+      if (dirent->kind == svn_node_dir && depth == svn_depth_files)
+        continue;
+
+      child_path = svn_fspath__join(path, dirent->name, iterpool);
+      child_relpath = svn_relpath_join(archive_relpath, dirent->name,
+                                       iterpool);
+
+      if (eb->authz_read_func)
+        {
+          svn_boolean_t readable;
+
+          SVN_ERR(eb->authz_read_func(&readable, eb->root, child_path,
+                                      eb->authz_read_baton, iterpool));
+          if (!readable)
+            continue;
+        }
+
+      if (dirent->kind == svn_node_dir)
+        SVN_ERR(export_directory(eb, child_path, child_relpath,
+                                 depth == svn_depth_infinity
+                                   ? svn_depth_infinity
+                                   : svn_depth_empty,
+                                 iterpool));
+      else
+        SVN_ERR(export_file(eb, child_path, child_relpath, iterpool));
+    }
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_repos_export_tar(svn_stream_t *tar_stream,
+                     svn_fs_root_t *root,
+                     const char *path,
+                     const char *archive_root,
+                     svn_depth_t depth,
+                     svn_boolean_t ignore_keywords,
+                     const char *native_eol,
+                     const char *repos_root_url,
+                     svn_repos_authz_func_t authz_read_func,
+                     void *authz_read_baton,
+                     svn_cancel_func_t cancel_func,
+                     void *cancel_baton,
+                     apr_pool_t *scratch_pool)
+{
+  export_baton_t eb = { 0 };
+  svn_node_kind_t kind;
+  svn_fs_t *fs = svn_fs_root_fs(root);
+  svn_boolean_t was_bulk_scan;
+  svn_error_t *err;
+
+  SVN_ERR_ASSERT(svn_relpath_is_canonical(archive_root));
+
+  path = svn_fspath__canonicalize(path, scratch_pool);
+  if (depth == svn_depth_unknown)
+    depth = svn_depth_infinity;
+
+  if (authz_read_func)
+    {
+      svn_boolean_t readable;
+
+      SVN_ERR(authz_read_func(&readable, root, path, authz_read_baton,
+                              scratch_pool));
+      if (!readable)
+        return svn_error_createf(SVN_ERR_AUTHZ_UNREADABLE, NULL,
+                                 _("Access to '%s' forbidden"), path);
+    }
+
+  SVN_ERR(svn_fs_check_path(&kind, root, path, scratch_pool));
+  if (kind == svn_node_none)
+    return svn_error_createf(SVN_ERR_FS_NOT_FOUND, NULL,
+                             _("Path '%s' not found"), path);
+
+  eb.tar = svn_tar__writer_create(tar_stream, scratch_pool);
+  eb.root = root;
+  eb.ignore_keywords = ignore_keywords;
+  eb.native_eol = native_eol;
+  eb.repos_root_url = repos_root_url;
+  eb.authz_read_func = authz_read_func;
+  eb.authz_read_baton = authz_read_baton;
+  eb.cancel_func = cancel_func;
+  eb.cancel_baton = cancel_baton;
+  eb.default_mtime = apr_time_now();
+  eb.rev_infos = apr_hash_make(scratch_pool);
+  eb.pool = scratch_pool;
+
+  /* Most of the exported contents will not be needed again soon. */
+  was_bulk_scan = svn_fs__is_bulk_scan(fs);
+  svn_fs__set_bulk_scan(fs, TRUE);
+
+  if (kind == svn_node_dir)
+    err = export_directory(&eb, path, archive_root, depth, scratch_pool);
+  else
+    err = export_file(&eb, path,
+                      *archive_root
+                        ? archive_root
+                        : svn_fspath__basename(path, scratch_pool),
+                      scratch_pool);
+
+  svn_fs__set_bulk_scan(fs, was_bulk_scan);
+  SVN_ERR(err);
+
+  return svn_error_trace(svn_tar__writer_finish(eb.tar, scratch_pool));
+}
@@ -36,6 +36,7 @@
 #include "svn_subst.h"
 #include "repos.h"
 #include "svn_private_config.h"
+#include "private/svn_fs_private.h"
 #include "private/svn_repos_private.h"
 #include "private/svn_sorts_private.h"
 #include "private/svn_utf_private.h"
@@ -57,6 +58,7 @@ svn_repos_fs_commit_txn(const char **conflict_p,
   apr_pool_t *iterpool;
   apr_hash_index_t *hi;
   apr_hash_t *hooks_env;
+  apr_time_t start;
 
   *new_rev = SVN_INVALID_REVNUM;
   if (conflict_p)
@@ -68,7 +70,9 @@ svn_repos_fs_commit_txn(const char **conflict_p,
 
   /* Run pre-commit hooks. */
   SVN_ERR(svn_fs_txn_name(&txn_name, txn, pool));
+  start = svn_fs__commit_timing_start(repos->fs);
   SVN_ERR(svn_repos__hooks_pre_commit(repos, hooks_env, txn_name, pool));
+  svn_fs__commit_timing_phase(repos->fs, "pre-commit-hook", start, pool);
 
   /* Remove any ephemeral transaction properties.  If the commit fails
      we will attempt to restore the properties but if that fails, or
@@ -90,7 +94,9 @@ svn_repos_fs_commit_txn(const char **conflict_p,
   svn_pool_destroy(iterpool);
 
   /* Commit. */
+  start = svn_fs__commit_timing_start(repos->fs);
   err = svn_fs_commit_txn(conflict_p, new_rev, txn, pool);
+  svn_fs__commit_timing_phase(repos->fs, "fs-commit", start, pool);
   if (! SVN_IS_VALID_REVNUM(*new_rev))
     {
       /* The commit failed, try to restore the ephemeral properties. */
@@ -111,7 +117,13 @@ svn_repos_fs_commit_txn(const char **conflict_p,
       return err;
     }
 
+  /* Keep the changed-paths index current, if there is one.  The commit
+     itself already succeeded and a stale index simply won't be used, so
+     don't let any failure here get in the way. */
+  svn_error_clear(svn_repos__log_index_update(repos, *new_rev, pool));
+
   /* Run post-commit hooks. */
+  start = svn_fs__commit_timing_start(repos->fs);
   if ((err2 = svn_repos__hooks_post_commit(repos, hooks_env,
                                            *new_rev, txn_name, pool)))
     {
@@ -119,6 +131,7 @@ svn_repos_fs_commit_txn(const char **conflict_p,
                (SVN_ERR_REPOS_POST_COMMIT_HOOK_FAILED, err2,
                 _("Commit succeeded, but post-commit hook failed"));
     }
+  svn_fs__commit_timing_phase(repos->fs, "post-commit-hook", start, pool);
 
   return svn_error_compose_create(err, err2);
 }
@@ -932,6 +945,65 @@ svn_repos_fs_get_locks2(apr_hash_t **locks,
 }
 
 
+/* Like svn_fs_get_mergeinfo3() with ADJUST_INHERITED_MERGEINFO set but
+ * answer from the changed-paths index LOG_INDEX.  Use SCRATCH_POOL for
+ * temporary allocations. */
+static svn_error_t *
+get_indexed_mergeinfo(svn_fs_root_t *root,
+                      svn_repos__log_index_t *log_index,
+                      const apr_array_header_t *paths,
+                      svn_mergeinfo_inheritance_t inherit,
+                      svn_boolean_t include_descendants,
+                      svn_repos_mergeinfo_receiver_t receiver,
+                      void *receiver_baton,
+                      apr_pool_t *scratch_pool)
+{
+  svn_revnum_t rev = svn_fs_revision_root_revision(root);
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  int i;
+
+  /* The index knows nothing about paths that don't exist.  Let the FS
+     report those in its usual way. */
+  for (i = 0; i < paths->nelts; i++)
+    {
+      const char *path = APR_ARRAY_IDX(paths, i, const char *);
+      svn_node_kind_t kind;
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_fs_check_path(&kind, root, path, iterpool));
+      if (kind == svn_node_none)
+        {
+          svn_pool_destroy(iterpool);
+          return svn_error_trace(svn_fs_get_mergeinfo3(root, paths, inherit,
+                                                       include_descendants,
+                                                       TRUE, receiver,
+                                                       receiver_baton,
+                                                       scratch_pool));
+        }
+    }
+
+  for (i = 0; i < paths->nelts; i++)
+    {
+      const char *path = APR_ARRAY_IDX(paths, i, const char *);
+      svn_mergeinfo_t mergeinfo;
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_repos__log_index_get_mergeinfo(&mergeinfo, log_index,
+                                                 path, rev, inherit, TRUE,
+                                                 iterpool, iterpool));
+      if (mergeinfo)
+        SVN_ERR(receiver(path, mergeinfo, receiver_baton, iterpool));
+
+      if (include_descendants)
+        SVN_ERR(svn_repos__log_index_get_descendant_mergeinfo(
+                  log_index, path, rev, receiver, receiver_baton,
+                  iterpool));
+    }
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *
 svn_repos_fs_get_mergeinfo2(svn_repos_t *repos,
                             const apr_array_header_t *paths,
@@ -990,10 +1062,22 @@ svn_repos_fs_get_mergeinfo2(svn_repos_t *repos,
      the change itself. */
   /* ### TODO(reint): ... but how about descendant merged-to paths? */
   if (readable_paths->nelts > 0)
-    SVN_ERR(svn_fs_get_mergeinfo3(root, readable_paths, inherit,
-                                  include_descendants, TRUE,
-                                  receiver, receiver_baton,
-                                  scratch_pool));
+    {
+      svn_repos__log_index_t *log_index;
+
+      SVN_ERR(svn_repos__log_index_open(&log_index, repos, rev,
+                                        scratch_pool, scratch_pool));
+      if (log_index)
+        SVN_ERR(get_indexed_mergeinfo(root, log_index, readable_paths,
+                                      inherit, include_descendants,
+                                      receiver, receiver_baton,
+                                      scratch_pool));
+      else
+        SVN_ERR(svn_fs_get_mergeinfo3(root, readable_paths, inherit,
+                                      include_descendants, TRUE,
+                                      receiver, receiver_baton,
+                                      scratch_pool));
+    }
 
   svn_pool_destroy(iterpool);
   return SVN_NO_ERROR;
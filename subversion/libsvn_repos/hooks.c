@@ -28,6 +28,7 @@
 #include <apr_file_io.h>
 
 #include "svn_config.h"
+#include "svn_dso.h"
 #include "svn_hash.h"
 #include "svn_error.h"
 #include "svn_dirent_uri.h"
@@ -45,6 +46,24 @@
 
 /*** Hook drivers. ***/
 
+/* Return the name of the action blocked by a failure of the hook NAME,
+   or NULL if the hook is not run before an action. */
+static const char *
+hook_action(const char *name)
+{
+  if (strcmp(name, "start-commit") == 0
+      || strcmp(name, "pre-commit") == 0)
+    return _("Commit");
+  else if (strcmp(name, "pre-revprop-change") == 0)
+    return _("Revprop change");
+  else if (strcmp(name, "pre-lock") == 0)
+    return _("Lock");
+  else if (strcmp(name, "pre-unlock") == 0)
+    return _("Unlock");
+  else
+    return NULL;
+}
+
 /* Helper function for run_hook_cmd().  Wait for a hook to finish
    executing and return either SVN_NO_ERROR if the hook script completed
    without error, or an error describing the reason for failure.
@@ -124,18 +143,7 @@ check_hook_result(const char *name, const char *cmd, apr_proc_t *cmd_proc,
     }
   else
     {
-      const char *action;
-      if (strcmp(name, "start-commit") == 0
-          || strcmp(name, "pre-commit") == 0)
-        action = _("Commit");
-      else if (strcmp(name, "pre-revprop-change") == 0)
-        action = _("Revprop change");
-      else if (strcmp(name, "pre-lock") == 0)
-        action = _("Lock");
-      else if (strcmp(name, "pre-unlock") == 0)
-        action = _("Unlock");
-      else
-        action = NULL;
+      const char *action = hook_action(name);
       if (action == NULL)
         failure_message = svn_stringbuf_createf(
             pool, _("%s hook failed (exit code %d)"),
@@ -454,6 +462,123 @@ hook_symlink_error(const char *hook)
      _("Failed to run '%s' hook; broken symlink"), hook);
 }
 
+/* Make transaction TXN_NAME in REPOS visible to hook scripts, which run
+   in a separate process.  Use POOL for temporary allocations. */
+static svn_error_t *
+flush_txn(svn_repos_t *repos,
+          const char *txn_name,
+          apr_pool_t *pool)
+{
+  svn_fs_txn_t *txn;
+
+  SVN_ERR(svn_fs_open_txn(&txn, repos->fs, txn_name, pool));
+  return svn_error_trace(svn_fs__flush_txn(txn, pool));
+}
+
+/* Set *FUNC to the function of the in-process module for the HOOK
+   program, or to NULL if there is no such module.  Use POOL for
+   temporary allocations. */
+static svn_error_t *
+find_hook_module(svn_repos_hook_func_t *func,
+                 const char *hook,
+                 apr_pool_t *pool)
+{
+  *func = NULL;
+
+#if APR_HAS_DSO
+  {
+    const char *module = apr_pstrcat(pool, hook, SVN_REPOS__HOOK_MODULE_EXT,
+                                     SVN_VA_NULL);
+    svn_node_kind_t kind;
+    apr_dso_handle_t *dso;
+    apr_dso_handle_sym_t symbol;
+    apr_status_t status;
+
+    SVN_ERR(svn_io_check_resolved_path(module, &kind, pool));
+    if (kind != svn_node_file)
+      return SVN_NO_ERROR;
+
+    /* Modules stay loaded for the lifetime of the process, so this
+       is cheap after the first call. */
+    SVN_ERR(svn_dso_load(&dso, module));
+    if (! dso)
+      return svn_error_createf(SVN_ERR_REPOS_HOOK_FAILURE, NULL,
+                               _("Failed to load hook module '%s'"),
+                               svn_dirent_local_style(module, pool));
+
+    status = apr_dso_sym(&symbol, dso, SVN_REPOS_HOOK_MODULE_FUNC);
+    if (status)
+      return svn_error_wrap_apr(status, _("'%s' does not define '%s()'"),
+                                svn_dirent_local_style(module, pool),
+                                SVN_REPOS_HOOK_MODULE_FUNC);
+
+    *func = (svn_repos_hook_func_t) symbol;
+  }
+#endif /* APR_HAS_DSO */
+
+  return SVN_NO_ERROR;
+}
+
+/* Initialize INFO for the hook NAME of REPOS. */
+static void
+init_hook_info(svn_repos_hook_info_t *info,
+               const char *name,
+               svn_repos_t *repos)
+{
+  memset(info, 0, sizeof(*info));
+  info->hook_name = name;
+  info->repos = repos;
+  info->revision = SVN_INVALID_REVNUM;
+}
+
+/* Call the hook module function FUNC for the event described by INFO,
+   with the environment for INFO->HOOK_NAME taken from HOOKS_ENV.  If
+   OUTPUT is not NULL, set *OUTPUT to the module's output or to "" if
+   it has none.  Wrap errors of FUNC the way check_hook_result() reports
+   failing hook programs.  Use POOL for all allocations. */
+static svn_error_t *
+run_hook_module(const char **output,
+                svn_repos_hook_func_t func,
+                svn_repos_hook_info_t *info,
+                apr_hash_t *hooks_env,
+                apr_pool_t *pool)
+{
+  const char *result = NULL;
+  apr_pool_t *scratch_pool;
+  svn_error_t *err;
+
+  if (hooks_env)
+    {
+      info->hook_env = svn_hash_gets(hooks_env, info->hook_name);
+      if (info->hook_env == NULL)
+        info->hook_env = svn_hash_gets(hooks_env,
+                                       SVN_REPOS__HOOKS_ENV_DEFAULT_SECTION);
+    }
+
+  scratch_pool = svn_pool_create(pool);
+  err = func(&result, info, pool, scratch_pool);
+  svn_pool_destroy(scratch_pool);
+
+  if (err)
+    {
+      const char *action = hook_action(info->hook_name);
+
+      if (action == NULL)
+        return svn_error_createf(SVN_ERR_REPOS_HOOK_FAILURE, err,
+                                 _("%s hook module failed"),
+                                 info->hook_name);
+      else
+        return svn_error_createf(SVN_ERR_REPOS_HOOK_FAILURE, err,
+                                 _("%s blocked by %s hook module"),
+                                 action, info->hook_name);
+    }
+
+  if (output)
+    *output = result ? result : "";
+
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *
 svn_repos__hooks_start_commit(svn_repos_t *repos,
                               apr_hash_t *hooks_env,
@@ -463,9 +588,25 @@ svn_repos__hooks_start_commit(svn_repos_t *repos,
                               apr_pool_t *pool)
 {
   const char *hook = svn_repos_start_commit_hook(repos, pool);
+  svn_repos_hook_func_t func;
   svn_boolean_t broken_link;
 
-  if ((hook = check_hook_cmd(hook, &broken_link, pool)) && broken_link)
+  SVN_ERR(find_hook_module(&func, hook, pool));
+  if (func)
+    {
+      svn_repos_hook_info_t info;
+      svn_fs_txn_t *txn;
+
+      init_hook_info(&info, SVN_REPOS__HOOK_START_COMMIT, repos);
+      info.user = user;
+      info.capabilities = capabilities;
+      info.txn_name = txn_name;
+      SVN_ERR(svn_fs_open_txn(&txn, repos->fs, txn_name, pool));
+      SVN_ERR(svn_fs_txn_root(&info.root, txn, pool));
+
+      SVN_ERR(run_hook_module(NULL, func, &info, hooks_env, pool));
+    }
+  else if ((hook = check_hook_cmd(hook, &broken_link, pool)) && broken_link)
     {
       return hook_symlink_error(hook);
     }
@@ -491,6 +632,7 @@ svn_repos__hooks_start_commit(svn_repos_t *repos,
       args[4] = txn_name;
       args[5] = NULL;
 
+      SVN_ERR(flush_txn(repos, txn_name, pool));
       SVN_ERR(run_hook_cmd(NULL, SVN_REPOS__HOOK_START_COMMIT, hook, args,
                            hooks_env, NULL, pool));
     }
@@ -548,9 +690,31 @@ svn_repos__hooks_pre_commit(svn_repos_t *repos,
                             apr_pool_t *pool)
 {
   const char *hook = svn_repos_pre_commit_hook(repos, pool);
+  svn_repos_hook_func_t func;
   svn_boolean_t broken_link;
 
-  if ((hook = check_hook_cmd(hook, &broken_link, pool)) && broken_link)
+  SVN_ERR(find_hook_module(&func, hook, pool));
+  if (func)
+    {
+      svn_repos_hook_info_t info;
+      svn_fs_access_t *access_ctx;
+      svn_fs_txn_t *txn;
+
+      init_hook_info(&info, SVN_REPOS__HOOK_PRE_COMMIT, repos);
+      info.txn_name = txn_name;
+      SVN_ERR(svn_fs_open_txn(&txn, repos->fs, txn_name, pool));
+      SVN_ERR(svn_fs_txn_root(&info.root, txn, pool));
+
+      SVN_ERR(svn_fs_get_access(&access_ctx, repos->fs));
+      if (access_ctx)
+        {
+          SVN_ERR(svn_fs_access_get_username(&info.user, access_ctx));
+          info.lock_tokens = svn_fs__access_get_lock_tokens(access_ctx);
+        }
+
+      SVN_ERR(run_hook_module(NULL, func, &info, hooks_env, pool));
+    }
+  else if ((hook = check_hook_cmd(hook, &broken_link, pool)) && broken_link)
     {
       return hook_symlink_error(hook);
     }
@@ -565,6 +729,7 @@ svn_repos__hooks_pre_commit(svn_repos_t *repos,
       args[2] = txn_name;
       args[3] = NULL;
 
+      SVN_ERR(flush_txn(repos, txn_name, pool));
       SVN_ERR(svn_fs_get_access(&access_ctx, repos->fs));
       if (access_ctx)
         {
@@ -594,9 +759,22 @@ svn_repos__hooks_post_commit(svn_repos_t *repos,
                              apr_pool_t *pool)
 {
   const char *hook = svn_repos_post_commit_hook(repos, pool);
+  svn_repos_hook_func_t func;
   svn_boolean_t broken_link;
 
-  if ((hook = check_hook_cmd(hook, &broken_link, pool)) && broken_link)
+  SVN_ERR(find_hook_module(&func, hook, pool));
+  if (func)
+    {
+      svn_repos_hook_info_t info;
+
+      init_hook_info(&info, SVN_REPOS__HOOK_POST_COMMIT, repos);
+      info.revision = rev;
+      info.txn_name = txn_name;
+      SVN_ERR(svn_fs_revision_root(&info.root, repos->fs, rev, pool));
+
+      SVN_ERR(run_hook_module(NULL, func, &info, hooks_env, pool));
+    }
+  else if ((hook = check_hook_cmd(hook, &broken_link, pool)) && broken_link)
     {
       return hook_symlink_error(hook);
     }
@@ -629,9 +807,24 @@ svn_repos__hooks_pre_revprop_change(svn_repos_t *repos,
                                     apr_pool_t *pool)
 {
   const char *hook = svn_repos_pre_revprop_change_hook(repos, pool);
+  svn_repos_hook_func_t func;
   svn_boolean_t broken_link;
 
-  if ((hook = check_hook_cmd(hook, &broken_link, pool)) && broken_link)
+  SVN_ERR(find_hook_module(&func, hook, pool));
+  if (func)
+    {
+      svn_repos_hook_info_t info;
+
+      init_hook_info(&info, SVN_REPOS__HOOK_PRE_REVPROP_CHANGE, repos);
+      info.revision = rev;
+      info.user = author;
+      info.propname = name;
+      info.action = action;
+      info.value = new_value;
+
+      SVN_ERR(run_hook_module(NULL, func, &info, hooks_env, pool));
+    }
+  else if ((hook = check_hook_cmd(hook, &broken_link, pool)) && broken_link)
     {
       return hook_symlink_error(hook);
     }
@@ -692,9 +885,24 @@ svn_repos__hooks_post_revprop_change(svn_repos_t *repos,
                                      apr_pool_t *pool)
 {
   const char *hook = svn_repos_post_revprop_change_hook(repos, pool);
+  svn_repos_hook_func_t func;
   svn_boolean_t broken_link;
 
-  if ((hook = check_hook_cmd(hook, &broken_link, pool)) && broken_link)
+  SVN_ERR(find_hook_module(&func, hook, pool));
+  if (func)
+    {
+      svn_repos_hook_info_t info;
+
+      init_hook_info(&info, SVN_REPOS__HOOK_POST_REVPROP_CHANGE, repos);
+      info.revision = rev;
+      info.user = author;
+      info.propname = name;
+      info.action = action;
+      info.value = old_value;
+
+      SVN_ERR(run_hook_module(NULL, func, &info, hooks_env, pool));
+    }
+  else if ((hook = check_hook_cmd(hook, &broken_link, pool)) && broken_link)
     {
       return hook_symlink_error(hook);
     }
@@ -743,9 +951,24 @@ svn_repos__hooks_pre_lock(svn_repos_t *repos,
                           apr_pool_t *pool)
 {
   const char *hook = svn_repos_pre_lock_hook(repos, pool);
+  svn_repos_hook_func_t func;
   svn_boolean_t broken_link;
 
-  if ((hook = check_hook_cmd(hook, &broken_link, pool)) && broken_link)
+  SVN_ERR(find_hook_module(&func, hook, pool));
+  if (func)
+    {
+      svn_repos_hook_info_t info;
+
+      init_hook_info(&info, SVN_REPOS__HOOK_PRE_LOCK, repos);
+      info.path = path;
+      info.user = username;
+      info.comment = comment;
+      info.steal_lock = steal_lock;
+
+      /* No validation of the token here; the FS will take care of that. */
+      SVN_ERR(run_hook_module(token, func, &info, hooks_env, pool));
+    }
+  else if ((hook = check_hook_cmd(hook, &broken_link, pool)) && broken_link)
     {
       return hook_symlink_error(hook);
     }
@@ -786,9 +1009,21 @@ svn_repos__hooks_post_lock(svn_repos_t *repos,
                            apr_pool_t *pool)
 {
   const char *hook = svn_repos_post_lock_hook(repos, pool);
+  svn_repos_hook_func_t func;
   svn_boolean_t broken_link;
 
-  if ((hook = check_hook_cmd(hook, &broken_link, pool)) && broken_link)
+  SVN_ERR(find_hook_module(&func, hook, pool));
+  if (func)
+    {
+      svn_repos_hook_info_t info;
+
+      init_hook_info(&info, SVN_REPOS__HOOK_POST_LOCK, repos);
+      info.paths = paths;
+      info.user = username;
+
+      SVN_ERR(run_hook_module(NULL, func, &info, hooks_env, pool));
+    }
+  else if ((hook = check_hook_cmd(hook, &broken_link, pool)) && broken_link)
     {
       return hook_symlink_error(hook);
     }
@@ -828,9 +1063,23 @@ svn_repos__hooks_pre_unlock(svn_repos_t *repos,
                             apr_pool_t *pool)
 {
   const char *hook = svn_repos_pre_unlock_hook(repos, pool);
+  svn_repos_hook_func_t func;
   svn_boolean_t broken_link;
 
-  if ((hook = check_hook_cmd(hook, &broken_link, pool)) && broken_link)
+  SVN_ERR(find_hook_module(&func, hook, pool));
+  if (func)
+    {
+      svn_repos_hook_info_t info;
+
+      init_hook_info(&info, SVN_REPOS__HOOK_PRE_UNLOCK, repos);
+      info.path = path;
+      info.user = username;
+      info.token = token;
+      info.steal_lock = break_lock;
+
+      SVN_ERR(run_hook_module(NULL, func, &info, hooks_env, pool));
+    }
+  else if ((hook = check_hook_cmd(hook, &broken_link, pool)) && broken_link)
     {
       return hook_symlink_error(hook);
     }
@@ -862,9 +1111,21 @@ svn_repos__hooks_post_unlock(svn_repos_t *repos,
                              apr_pool_t *pool)
 {
   const char *hook = svn_repos_post_unlock_hook(repos, pool);
+  svn_repos_hook_func_t func;
   svn_boolean_t broken_link;
 
-  if ((hook = check_hook_cmd(hook, &broken_link, pool)) && broken_link)
+  SVN_ERR(find_hook_module(&func, hook, pool));
+  if (func)
+    {
+      svn_repos_hook_info_t info;
+
+      init_hook_info(&info, SVN_REPOS__HOOK_POST_UNLOCK, repos);
+      info.paths = paths;
+      info.user = username;
+
+      SVN_ERR(run_hook_module(NULL, func, &info, hooks_env, pool));
+    }
+  else if ((hook = check_hook_cmd(hook, &broken_link, pool)) && broken_link)
     {
       return hook_symlink_error(hook);
     }
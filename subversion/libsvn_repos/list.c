@@ -26,6 +26,8 @@
 #include "svn_pools.h"
 #include "svn_error.h"
 #include "svn_dirent_uri.h"
+#include "svn_hash.h"
+#include "svn_props.h"
 #include "svn_time.h"
 
 #include "private/svn_repos_private.h"
@@ -38,56 +40,75 @@
 
 
 /* Utility function.  Given DIRENT->KIND, set all other elements of *DIRENT
- * with the values retrieved for PATH under ROOT.  Allocate them in POOL.
+ * with the values from STAT, which has been retrieved under ROOT.
+ * Allocate them in POOL.
  */
 static svn_error_t *
 fill_dirent(svn_dirent_t *dirent,
             svn_fs_root_t *root,
-            const char *path,
+            const svn_fs_path_stat_t *stat,
             apr_pool_t *scratch_pool)
 {
-  const char *datestring;
+  apr_hash_t *revprops;
+  svn_string_t *datestring, *author;
 
-  if (dirent->kind == svn_node_file)
-    SVN_ERR(svn_fs_file_length(&(dirent->size), root, path, scratch_pool));
-  else
-    dirent->size = SVN_INVALID_FILESIZE;
+  dirent->size = stat->size;
+  dirent->has_props = stat->has_props;
+  dirent->created_rev = stat->created_rev;
 
-  SVN_ERR(svn_fs_node_has_props(&dirent->has_props, root, path,
-                                scratch_pool));
+  /* Same as svn_repos_get_committed_info but without another lookup. */
+  SVN_ERR(svn_fs_revision_proplist2(&revprops, svn_fs_root_fs(root),
+                                    stat->created_rev, TRUE,
+                                    scratch_pool, scratch_pool));
+  datestring = svn_hash_gets(revprops, SVN_PROP_REVISION_DATE);
+  author = svn_hash_gets(revprops, SVN_PROP_REVISION_AUTHOR);
 
-  SVN_ERR(svn_repos_get_committed_info(&(dirent->created_rev),
-                                       &datestring,
-                                       &(dirent->last_author),
-                                       root, path, scratch_pool));
+  dirent->last_author = author ? author->data : NULL;
   if (datestring)
-    SVN_ERR(svn_time_from_cstring(&(dirent->time), datestring,
+    SVN_ERR(svn_time_from_cstring(&(dirent->time), datestring->data,
                                   scratch_pool));
 
   return SVN_NO_ERROR;
 }
 
+/* Return the svn_fs_path_stat_t for PATH under ROOT, allocated in POOL. */
+static svn_error_t *
+stat_path(const svn_fs_path_stat_t **stat,
+          svn_fs_root_t *root,
+          const char *path,
+          apr_pool_t *pool)
+{
+  apr_array_header_t *paths = apr_array_make(pool, 1, sizeof(path));
+  apr_array_header_t *stats;
+
+  APR_ARRAY_PUSH(paths, const char *) = path;
+  SVN_ERR(svn_fs_stat_paths(&stats, root, paths, pool, pool));
+  *stat = APR_ARRAY_IDX(stats, 0, const svn_fs_path_stat_t *);
+
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *
 svn_repos_stat(svn_dirent_t **dirent,
                svn_fs_root_t *root,
                const char *path,
                apr_pool_t *pool)
 {
-  svn_node_kind_t kind;
+  const svn_fs_path_stat_t *stat;
   svn_dirent_t *ent;
 
-  SVN_ERR(svn_fs_check_path(&kind, root, path, pool));
+  SVN_ERR(stat_path(&stat, root, path, pool));
 
-  if (kind == svn_node_none)
+  if (stat->kind == svn_node_none)
     {
       *dirent = NULL;
       return SVN_NO_ERROR;
     }
 
   ent = svn_dirent_create(pool);
-  ent->kind = kind;
+  ent->kind = stat->kind;
 
-  SVN_ERR(fill_dirent(ent, root, path, pool));
+  SVN_ERR(fill_dirent(ent, root, stat, pool));
 
   *dirent = ent;
   return SVN_NO_ERROR;
@@ -106,11 +127,22 @@ matches_any(const char *dirname,
        : TRUE;
 }
 
+/* Return TRUE if the node described by STAT did not change in SINCE_REV
+ * or later.  Nodes in transactions always count as changed. */
+static svn_boolean_t
+unchanged_since(const svn_fs_path_stat_t *stat,
+                svn_revnum_t since_rev)
+{
+  return SVN_IS_VALID_REVNUM(since_rev)
+      && SVN_IS_VALID_REVNUM(stat->created_rev)
+      && stat->created_rev < since_rev;
+}
+
 /* Utility to prevent code duplication.
  *
  * Construct a svn_dirent_t for PATH of type KIND under ROOT and, if
- * PATH_INFO_ONLY is not set, fill it.  Call RECEIVER with the result
- * and RECEIVER_BATON.
+ * STAT is not NULL, fill it with the details from STAT.  Call RECEIVER
+ * with the result and RECEIVER_BATON.
  *
  * Use SCRATCH_POOL for temporary allocations.
  */
@@ -118,7 +150,7 @@ static svn_error_t *
 report_dirent(svn_fs_root_t *root,
               const char *path,
               svn_node_kind_t kind,
-              svn_boolean_t path_info_only,
+              const svn_fs_path_stat_t *stat,
               svn_repos_dirent_receiver_t receiver,
               void *receiver_baton,
               apr_pool_t *scratch_pool)
@@ -127,8 +159,8 @@ report_dirent(svn_fs_root_t *root,
 
   /* Fetch the details to report - if required. */
   dirent.kind = kind;
-  if (!path_info_only)
-    SVN_ERR(fill_dirent(&dirent, root, path, scratch_pool));
+  if (stat)
+    SVN_ERR(fill_dirent(&dirent, root, stat, scratch_pool));
 
   /* Report the entry. */
   SVN_ERR(receiver(path, &dirent, receiver_baton, scratch_pool));
@@ -144,6 +176,12 @@ typedef struct filtered_dirent_t
 
   /* DIRENT passed the filter. */
   svn_boolean_t is_match;
+
+  /* Full path of DIRENT.  NULL if we may not access it. */
+  const char *path;
+
+  /* Details on DIRENT.  NULL if they have not been requested. */
+  const svn_fs_path_stat_t *stat;
 } filtered_dirent_t;
 
 /* Implement a standard sort function for filtered_dirent_t *, sorting them
@@ -163,6 +201,9 @@ compare_filtered_dirent(const void *lhs,
  * However, DEPTH is not svn_depth_empty and PATH has already been reported.
  * Therefore, we can call this recursively.
  *
+ * Only the entries of a single directory are being held in memory at
+ * any time, per recursion level.
+ *
  * Uses SCRATCH_BUFFER for temporary string contents.
  */
 static svn_error_t *
@@ -170,6 +211,7 @@ do_list(svn_fs_root_t *root,
         const char *path,
         const apr_array_header_t *patterns,
         svn_depth_t depth,
+        svn_revnum_t since_rev,
         svn_boolean_t path_info_only,
         svn_repos_authz_func_t authz_read_func,
         void *authz_read_baton,
@@ -184,7 +226,7 @@ do_list(svn_fs_root_t *root,
   apr_pool_t *iterpool = svn_pool_create(scratch_pool);
   apr_hash_index_t *hi;
   apr_array_header_t *sorted;
-  int i;
+  int i, k;
 
   /* Fetch all directory entries, filter and sort them.
    *
@@ -203,6 +245,7 @@ do_list(svn_fs_root_t *root,
       svn_pool_clear(iterpool);
 
       filtered.dirent = apr_hash_this_val(hi);
+      filtered.stat = NULL;
 
       /* Skip directories if we want to report files only. */
       if (filtered.dirent->kind == svn_node_dir && depth == svn_depth_files)
@@ -219,33 +262,82 @@ do_list(svn_fs_root_t *root,
 
   svn_sort__array(sorted, compare_filtered_dirent);
 
-  /* Iterate over all remaining directory entries and report them.
-   * Recurse into sub-directories if requested. */
+  /* Skip paths that we don't have access to. */
   for (i = 0; i < sorted->nelts; ++i)
     {
-      const char *sub_path;
       filtered_dirent_t *filtered;
-      svn_fs_dirent_t *dirent;
 
       svn_pool_clear(iterpool);
 
       filtered = &APR_ARRAY_IDX(sorted, i, filtered_dirent_t);
-      dirent = filtered->dirent;
-
-      /* Skip paths that we don't have access to? */
-      sub_path = svn_dirent_join(path, dirent->name, iterpool);
+      filtered->path = svn_dirent_join(path, filtered->dirent->name,
+                                       scratch_pool);
       if (authz_read_func)
         {
           svn_boolean_t has_access;
-          SVN_ERR(authz_read_func(&has_access, root, sub_path,
+          SVN_ERR(authz_read_func(&has_access, root, filtered->path,
                                   authz_read_baton, iterpool));
           if (!has_access)
-            continue;
+            filtered->path = NULL;
         }
+    }
+
+  /* Fetch the details for all entries to report in a single FS call.
+   * Filtering by SINCE_REV needs them for all entries, including the
+   * directories that we only recurse into. */
+  if (!path_info_only || SVN_IS_VALID_REVNUM(since_rev))
+    {
+      apr_array_header_t *paths = apr_array_make(scratch_pool, sorted->nelts,
+                                                 sizeof(const char *));
+      apr_array_header_t *stats;
+
+      for (i = 0; i < sorted->nelts; ++i)
+        {
+          filtered_dirent_t *filtered
+            = &APR_ARRAY_IDX(sorted, i, filtered_dirent_t);
+          if (filtered->path
+              && (filtered->is_match || SVN_IS_VALID_REVNUM(since_rev)))
+            APR_ARRAY_PUSH(paths, const char *) = filtered->path;
+        }
+
+      SVN_ERR(svn_fs_stat_paths(&stats, root, paths, scratch_pool,
+                                scratch_pool));
+
+      for (i = 0, k = 0; i < sorted->nelts; ++i)
+        {
+          filtered_dirent_t *filtered
+            = &APR_ARRAY_IDX(sorted, i, filtered_dirent_t);
+          if (filtered->path
+              && (filtered->is_match || SVN_IS_VALID_REVNUM(since_rev)))
+            filtered->stat = APR_ARRAY_IDX(stats, k++,
+                                           const svn_fs_path_stat_t *);
+        }
+    }
+
+  /* Iterate over all remaining directory entries and report them.
+   * Recurse into sub-directories if requested. */
+  for (i = 0; i < sorted->nelts; ++i)
+    {
+      const char *sub_path;
+      filtered_dirent_t *filtered;
+      svn_fs_dirent_t *dirent;
+
+      svn_pool_clear(iterpool);
+
+      filtered = &APR_ARRAY_IDX(sorted, i, filtered_dirent_t);
+      dirent = filtered->dirent;
+      sub_path = filtered->path;
+      if (!sub_path)
+        continue;
+
+      /* Nothing changed in this sub-tree since SINCE_REV. */
+      if (filtered->stat && unchanged_since(filtered->stat, since_rev))
+        continue;
 
       /* Report entry, if it passed the filter. */
       if (filtered->is_match)
-        SVN_ERR(report_dirent(root, sub_path, dirent->kind, path_info_only,
+        SVN_ERR(report_dirent(root, sub_path, dirent->kind,
+                              path_info_only ? NULL : filtered->stat,
                               receiver, receiver_baton, iterpool));
 
       /* Check for cancellation before recursing down.  This should be
@@ -256,7 +348,8 @@ do_list(svn_fs_root_t *root,
       /* Recurse on directories. */
       if (depth == svn_depth_infinity && dirent->kind == svn_node_dir)
         SVN_ERR(do_list(root, sub_path, patterns, svn_depth_infinity,
-                        path_info_only, authz_read_func, authz_read_baton,
+                        since_rev, path_info_only,
+                        authz_read_func, authz_read_baton,
                         receiver, receiver_baton, cancel_func,
                         cancel_baton, scratch_buffer, iterpool));
     }
@@ -267,26 +360,28 @@ do_list(svn_fs_root_t *root,
 }
 
 svn_error_t *
-svn_repos_list(svn_fs_root_t *root,
-               const char *path,
-               const apr_array_header_t *patterns,
-               svn_depth_t depth,
-               svn_boolean_t path_info_only,
-               svn_repos_authz_func_t authz_read_func,
-               void *authz_read_baton,
-               svn_repos_dirent_receiver_t receiver,
-               void *receiver_baton,
-               svn_cancel_func_t cancel_func,
-               void *cancel_baton,
-               apr_pool_t *scratch_pool)
+svn_repos_list2(svn_fs_root_t *root,
+                const char *path,
+                const apr_array_header_t *patterns,
+                svn_depth_t depth,
+                svn_revnum_t since_rev,
+                svn_boolean_t path_info_only,
+                svn_repos_authz_func_t authz_read_func,
+                void *authz_read_baton,
+                svn_repos_dirent_receiver_t receiver,
+                void *receiver_baton,
+                svn_cancel_func_t cancel_func,
+                void *cancel_baton,
+                apr_pool_t *scratch_pool)
 {
   svn_membuf_t scratch_buffer;
+  const svn_fs_path_stat_t *stat;
 
   /* Parameter check. */
   svn_node_kind_t kind;
   if (depth < svn_depth_empty)
     return svn_error_createf(SVN_ERR_REPOS_BAD_ARGS, NULL,
-                             "Invalid depth '%d' in svn_repos_list", depth);
+                             "Invalid depth '%d' in svn_repos_list2", depth);
 
   /* Do we have access this sub-tree? */
   if (authz_read_func)
@@ -302,7 +397,8 @@ svn_repos_list(svn_fs_root_t *root,
    *
    * Note that we must do this after the authz check to not indirectly
    * confirm the existence of PATH. */
-  SVN_ERR(svn_fs_check_path(&kind, root, path, scratch_pool));
+  SVN_ERR(stat_path(&stat, root, path, scratch_pool));
+  kind = stat->kind;
   if (kind == svn_node_file)
     {
       /* There is no recursion on files. */
@@ -319,6 +415,10 @@ svn_repos_list(svn_fs_root_t *root,
   if (patterns && patterns->nelts == 0)
     return SVN_NO_ERROR;
 
+  /* Nothing changed in the whole sub-tree since SINCE_REV. */
+  if (unchanged_since(stat, since_rev))
+    return SVN_NO_ERROR;
+
   /* We need a scratch buffer for temporary string data.
    * Create one with a reasonable initial size. */
   svn_membuf__create(&scratch_buffer, 256, scratch_pool);
@@ -326,12 +426,12 @@ svn_repos_list(svn_fs_root_t *root,
   /* Actually report PATH, if it passes the filters. */
   if (matches_any(svn_dirent_basename(path, scratch_pool), patterns,
                   &scratch_buffer))
-    SVN_ERR(report_dirent(root, path, kind, path_info_only,
+    SVN_ERR(report_dirent(root, path, kind, path_info_only ? NULL : stat,
                           receiver, receiver_baton, scratch_pool));
 
   /* Report directory contents if requested. */
   if (depth > svn_depth_empty)
-    SVN_ERR(do_list(root, path, patterns, depth,
+    SVN_ERR(do_list(root, path, patterns, depth, since_rev,
                     path_info_only, authz_read_func, authz_read_baton,
                     receiver, receiver_baton, cancel_func, cancel_baton,
                     &scratch_buffer, scratch_pool));
@@ -47,6 +47,44 @@
 
 /** Batons used herein **/
 
+/* Number of revision mappings that we keep in memory before spilling
+   them to disk.  With 8 bytes per entry, this limits the memory used by
+   the revision map to 512kB regardless of the size of the dump stream. */
+#define REV_MAP_MEMORY_LIMIT 0x10000
+
+/* A mapping of dump stream revisions (svn_revnum_t) to the corresponding
+   revisions in the loaded repository (svn_revnum_t).
+
+   Dump stream revisions are usually mapped in ascending order without
+   gaps, so we store them as a dense array indexed by the dump stream
+   revision number relative to FIRST_REV.  Only the youngest entries are
+   kept in memory; older ones get spilled to a temporary file.  The rare
+   mappings that don't fit into that scheme go into a hash instead. */
+typedef struct rev_map_t
+{
+  /* The dump stream revision mapped by the first entry in the dense
+     map.  SVN_INVALID_REVNUM if we did not map any revision yet. */
+  svn_revnum_t first_rev;
+
+  /* Number of entries spilled to SPILL_FILE.  Those map FIRST_REV up to
+     FIRST_REV + SPILLED - 1. */
+  apr_int64_t spilled;
+
+  /* Entries mapping FIRST_REV + SPILLED and younger, svn_revnum_t. */
+  apr_array_header_t *revs;
+
+  /* Temporary file containing the spilled entries.  NULL, if we did not
+     have to spill any entries yet. */
+  apr_file_t *spill_file;
+
+  /* Mappings that are not part of the dense map.  Maps svn_revnum_t *
+     to svn_revnum_t *. */
+  apr_hash_t *sparse;
+
+  /* Pool for the temporary file and all in-memory entries. */
+  apr_pool_t *pool;
+} rev_map_t;
+
 struct parse_baton
 {
   svn_repos_t *repos;
@@ -71,13 +109,10 @@ struct parse_baton
   svn_revnum_t start_rev;
   svn_revnum_t end_rev;
 
-  /* A hash mapping copy-from revisions and mergeinfo range revisions
-     (svn_revnum_t *) in the dump stream to their corresponding revisions
-     (svn_revnum_t *) in the loaded repository.  The hash and its
-     contents are allocated in POOL. */
-  /* ### See https://issues.apache.org/jira/browse/SVN-3903
-     ### for discussion about improving the memory costs of this mapping. */
-  apr_hash_t *rev_map;
+  /* Maps copy-from revisions and mergeinfo range revisions in the dump
+     stream to their corresponding revisions in the loaded repository.
+     Its memory usage is bounded; see SVN-3903 for the background. */
+  rev_map_t *rev_map;
 
   /* The most recent (youngest) revision from the dump stream mapped in
      REV_MAP.  If no revisions have been mapped yet, this is set to
@@ -128,30 +163,164 @@ struct node_baton
 
 /*----------------------------------------------------------------------*/
 
-/* Record the mapping of FROM_REV to TO_REV in REV_MAP, ensuring that
-   anything added to the hash is allocated in the hash's pool. */
-static void
-set_revision_mapping(apr_hash_t *rev_map,
+/* Return a new, empty revision map allocated in POOL. */
+static rev_map_t *
+rev_map_create(apr_pool_t *pool)
+{
+  rev_map_t *rev_map = apr_pcalloc(pool, sizeof(*rev_map));
+  rev_map->first_rev = SVN_INVALID_REVNUM;
+  rev_map->revs = apr_array_make(pool, 16, sizeof(svn_revnum_t));
+  rev_map->sparse = apr_hash_make(pool);
+  rev_map->pool = pool;
+
+  return rev_map;
+}
+
+/* Append the in-memory part of REV_MAP to its spill file and empty it.
+   Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+rev_map_spill(rev_map_t *rev_map,
+              apr_pool_t *scratch_pool)
+{
+  apr_off_t offset = rev_map->spilled * sizeof(svn_revnum_t);
+
+  if (rev_map->spill_file == NULL)
+    SVN_ERR(svn_io_open_unique_file3(&rev_map->spill_file, NULL, NULL,
+                                     svn_io_file_del_on_pool_cleanup,
+                                     rev_map->pool, scratch_pool));
+
+  SVN_ERR(svn_io_file_seek(rev_map->spill_file, APR_SET, &offset,
+                           scratch_pool));
+  SVN_ERR(svn_io_file_write_full(rev_map->spill_file, rev_map->revs->elts,
+                                 rev_map->revs->nelts * sizeof(svn_revnum_t),
+                                 NULL, scratch_pool));
+
+  rev_map->spilled += rev_map->revs->nelts;
+  apr_array_clear(rev_map->revs);
+
+  return SVN_NO_ERROR;
+}
+
+/* Record the mapping of FROM_REV to TO_REV in REV_MAP, replacing any
+   previous mapping of FROM_REV.  Use SCRATCH_POOL for temporary
+   allocations. */
+static svn_error_t *
+set_revision_mapping(rev_map_t *rev_map,
                      svn_revnum_t from_rev,
-                     svn_revnum_t to_rev)
+                     svn_revnum_t to_rev,
+                     apr_pool_t *scratch_pool)
+{
+  apr_int64_t idx;
+
+  if (! SVN_IS_VALID_REVNUM(rev_map->first_rev))
+    rev_map->first_rev = from_rev;
+
+  idx = (apr_int64_t)from_rev - rev_map->first_rev;
+  if (idx == rev_map->spilled + rev_map->revs->nelts)
+    {
+      /* The common case: extend the dense map. */
+      if (rev_map->revs->nelts >= REV_MAP_MEMORY_LIMIT)
+        SVN_ERR(rev_map_spill(rev_map, scratch_pool));
+
+      APR_ARRAY_PUSH(rev_map->revs, svn_revnum_t) = to_rev;
+    }
+  else if (idx >= rev_map->spilled
+           && idx < rev_map->spilled + rev_map->revs->nelts)
+    {
+      APR_ARRAY_IDX(rev_map->revs, idx - rev_map->spilled, svn_revnum_t)
+        = to_rev;
+    }
+  else if (idx >= 0 && idx < rev_map->spilled)
+    {
+      apr_off_t offset = idx * sizeof(svn_revnum_t);
+
+      SVN_ERR(svn_io_file_seek(rev_map->spill_file, APR_SET, &offset,
+                               scratch_pool));
+      SVN_ERR(svn_io_file_write_full(rev_map->spill_file, &to_rev,
+                                     sizeof(to_rev), NULL, scratch_pool));
+    }
+  else
+    {
+      svn_revnum_t *mapped_revs = apr_palloc(rev_map->pool,
+                                             sizeof(svn_revnum_t) * 2);
+      mapped_revs[0] = from_rev;
+      mapped_revs[1] = to_rev;
+      apr_hash_set(rev_map->sparse, mapped_revs,
+                   sizeof(svn_revnum_t), mapped_revs + 1);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *TO_REV to the revision to which FROM_REV maps in REV_MAP, or to
+   SVN_INVALID_REVNUM if no such mapping exists.  Use SCRATCH_POOL for
+   temporary allocations. */
+static svn_error_t *
+get_revision_mapping(svn_revnum_t *to_rev,
+                     rev_map_t *rev_map,
+                     svn_revnum_t from_rev,
+                     apr_pool_t *scratch_pool)
+{
+  apr_int64_t idx = (apr_int64_t)from_rev - rev_map->first_rev;
+
+  if (! SVN_IS_VALID_REVNUM(rev_map->first_rev) || idx < 0
+      || idx >= rev_map->spilled + rev_map->revs->nelts)
+    {
+      svn_revnum_t *mapped_rev = apr_hash_get(rev_map->sparse, &from_rev,
+                                              sizeof(from_rev));
+      *to_rev = mapped_rev ? *mapped_rev : SVN_INVALID_REVNUM;
+    }
+  else if (idx >= rev_map->spilled)
+    {
+      *to_rev = APR_ARRAY_IDX(rev_map->revs, idx - rev_map->spilled,
+                              svn_revnum_t);
+    }
+  else
+    {
+      apr_off_t offset = idx * sizeof(svn_revnum_t);
+
+      SVN_ERR(svn_io_file_seek(rev_map->spill_file, APR_SET, &offset,
+                               scratch_pool));
+      SVN_ERR(svn_io_file_read_full2(rev_map->spill_file, to_rev,
+                                     sizeof(*to_rev), NULL, NULL,
+                                     scratch_pool));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Function type used to look up revision mappings.  Set *TO_REV to the
+   revision to which FROM_REV maps in BATON, or to SVN_INVALID_REVNUM if
+   no such mapping exists. */
+typedef svn_error_t *(*rev_lookup_func_t)(svn_revnum_t *to_rev,
+                                          void *baton,
+                                          svn_revnum_t from_rev,
+                                          apr_pool_t *scratch_pool);
+
+/* Implements rev_lookup_func_t for BATON being a rev_map_t. */
+static svn_error_t *
+rev_map_lookup(svn_revnum_t *to_rev,
+               void *baton,
+               svn_revnum_t from_rev,
+               apr_pool_t *scratch_pool)
 {
-  svn_revnum_t *mapped_revs = apr_palloc(apr_hash_pool_get(rev_map),
-                                         sizeof(svn_revnum_t) * 2);
-  mapped_revs[0] = from_rev;
-  mapped_revs[1] = to_rev;
-  apr_hash_set(rev_map, mapped_revs,
-               sizeof(svn_revnum_t), mapped_revs + 1);
+  return svn_error_trace(get_revision_mapping(to_rev, baton, from_rev,
+                                              scratch_pool));
 }
 
-/* Return the revision to which FROM_REV maps in REV_MAP, or
-   SVN_INVALID_REVNUM if no such mapping exists. */
-static svn_revnum_t
-get_revision_mapping(apr_hash_t *rev_map,
-                     svn_revnum_t from_rev)
+/* Implements rev_lookup_func_t for BATON being a hash mapping
+   svn_revnum_t * to svn_revnum_t *. */
+static svn_error_t *
+rev_hash_lookup(svn_revnum_t *to_rev,
+                void *baton,
+                svn_revnum_t from_rev,
+                apr_pool_t *scratch_pool)
 {
-  svn_revnum_t *to_rev = apr_hash_get(rev_map, &from_rev,
-                                      sizeof(from_rev));
-  return to_rev ? *to_rev : SVN_INVALID_REVNUM;
+  svn_revnum_t *mapped_rev = apr_hash_get(baton, &from_rev,
+                                          sizeof(from_rev));
+  *to_rev = mapped_rev ? *mapped_rev : SVN_INVALID_REVNUM;
+
+  return SVN_NO_ERROR;
 }
 
 
@@ -232,7 +401,7 @@ prefix_mergeinfo_paths(svn_string_t **mergeinfo_val,
    (allocated from POOL).
 
    Adjust any mergeinfo revisions not older than OLDEST_DUMPSTREAM_REV by
-   using REV_MAP which maps (svn_revnum_t) old rev to (svn_revnum_t) new rev.
+   using LOOKUP_FUNC with LOOKUP_BATON which maps old rev to new rev.
 
    Adjust any mergeinfo revisions older than OLDEST_DUMPSTREAM_REV by
    (-OLDER_REVS_OFFSET), dropping any that become <= 0.
@@ -240,7 +409,8 @@ prefix_mergeinfo_paths(svn_string_t **mergeinfo_val,
 static svn_error_t *
 renumber_mergeinfo_revs(svn_string_t **final_val,
                         const svn_string_t *initial_val,
-                        apr_hash_t *rev_map,
+                        rev_lookup_func_t lookup_func,
+                        void *lookup_baton,
                         svn_revnum_t oldest_dumpstream_rev,
                         apr_int32_t older_revs_offset,
                         apr_pool_t *pool)
@@ -291,7 +461,8 @@ renumber_mergeinfo_revs(svn_string_t **final_val,
           svn_revnum_t rev_from_map;
           svn_merge_range_t *range = APR_ARRAY_IDX(rangelist, i,
                                                    svn_merge_range_t *);
-          rev_from_map = get_revision_mapping(rev_map, range->start);
+          SVN_ERR(lookup_func(&rev_from_map, lookup_baton, range->start,
+                              subpool));
           if (SVN_IS_VALID_REVNUM(rev_from_map))
             {
               range->start = rev_from_map;
@@ -310,8 +481,8 @@ renumber_mergeinfo_revs(svn_string_t **final_val,
                  If that is what we have here, then find the mapping for the
                  oldest rev from the load stream and subtract 1 to get the
                  renumbered, non-inclusive, start revision. */
-              rev_from_map = get_revision_mapping(rev_map,
-                                                  oldest_dumpstream_rev);
+              SVN_ERR(lookup_func(&rev_from_map, lookup_baton,
+                                  oldest_dumpstream_rev, subpool));
               if (SVN_IS_VALID_REVNUM(rev_from_map))
                 range->start = rev_from_map - 1;
             }
@@ -328,7 +499,8 @@ renumber_mergeinfo_revs(svn_string_t **final_val,
               continue;
             }
 
-          rev_from_map = get_revision_mapping(rev_map, range->end);
+          SVN_ERR(lookup_func(&rev_from_map, lookup_baton, range->end,
+                              subpool));
           if (SVN_IS_VALID_REVNUM(rev_from_map))
             range->end = rev_from_map;
         }
@@ -585,7 +757,8 @@ maybe_add_with_history(struct node_baton *nb,
 
       /* Try to find the copyfrom revision in the revision map;
          failing that, fall back to the revision offset approach. */
-      copyfrom_rev = get_revision_mapping(rb->pb->rev_map, nb->copyfrom_rev);
+      SVN_ERR(get_revision_mapping(&copyfrom_rev, rb->pb->rev_map,
+                                   nb->copyfrom_rev, pool));
       if (! SVN_IS_VALID_REVNUM(copyfrom_rev))
         copyfrom_rev = nb->copyfrom_rev - rb->rev_offset;
 
@@ -748,17 +921,20 @@ set_revision_property(void *baton,
 }
 
 
-svn_error_t *
-svn_repos__adjust_mergeinfo_property(svn_string_t **new_value_p,
-                                     const svn_string_t *old_value,
-                                     const char *parent_dir,
-                                     apr_hash_t *rev_map,
-                                     svn_revnum_t oldest_dumpstream_rev,
-                                     apr_int32_t older_revs_offset,
-                                     svn_repos_notify_func_t notify_func,
-                                     void *notify_baton,
-                                     apr_pool_t *result_pool,
-                                     apr_pool_t *scratch_pool)
+/* Implement svn_repos__adjust_mergeinfo_property with the revision
+   mapping being provided by LOOKUP_FUNC and LOOKUP_BATON. */
+static svn_error_t *
+adjust_mergeinfo_property(svn_string_t **new_value_p,
+                          const svn_string_t *old_value,
+                          const char *parent_dir,
+                          rev_lookup_func_t lookup_func,
+                          void *lookup_baton,
+                          svn_revnum_t oldest_dumpstream_rev,
+                          apr_int32_t older_revs_offset,
+                          svn_repos_notify_func_t notify_func,
+                          void *notify_baton,
+                          apr_pool_t *result_pool,
+                          apr_pool_t *scratch_pool)
 {
   svn_string_t prop_val = *old_value;
 
@@ -793,7 +969,8 @@ svn_repos__adjust_mergeinfo_property(svn_string_t **new_value_p,
 
   /* Renumber mergeinfo as appropriate. */
   SVN_ERR(renumber_mergeinfo_revs(new_value_p, &prop_val,
-                                  rev_map, oldest_dumpstream_rev,
+                                  lookup_func, lookup_baton,
+                                  oldest_dumpstream_rev,
                                   older_revs_offset,
                                   result_pool));
 
@@ -808,6 +985,28 @@ svn_repos__adjust_mergeinfo_property(svn_string_t **new_value_p,
   return SVN_NO_ERROR;
 }
 
+svn_error_t *
+svn_repos__adjust_mergeinfo_property(svn_string_t **new_value_p,
+                                     const svn_string_t *old_value,
+                                     const char *parent_dir,
+                                     apr_hash_t *rev_map,
+                                     svn_revnum_t oldest_dumpstream_rev,
+                                     apr_int32_t older_revs_offset,
+                                     svn_repos_notify_func_t notify_func,
+                                     void *notify_baton,
+                                     apr_pool_t *result_pool,
+                                     apr_pool_t *scratch_pool)
+{
+  return svn_error_trace(adjust_mergeinfo_property(new_value_p, old_value,
+                                                   parent_dir,
+                                                   rev_hash_lookup, rev_map,
+                                                   oldest_dumpstream_rev,
+                                                   older_revs_offset,
+                                                   notify_func, notify_baton,
+                                                   result_pool,
+                                                   scratch_pool));
+}
+
 
 static svn_error_t *
 set_node_property(void *baton,
@@ -832,13 +1031,12 @@ set_node_property(void *baton,
       svn_string_t *new_value;
       svn_error_t *err;
 
-      err = svn_repos__adjust_mergeinfo_property(&new_value, value,
-                                                 pb->parent_dir,
-                                                 pb->rev_map,
-                                                 pb->oldest_dumpstream_rev,
-                                                 rb->rev_offset,
-                                                 pb->notify_func, pb->notify_baton,
-                                                 nb->pool, pb->notify_pool);
+      err = adjust_mergeinfo_property(&new_value, value, pb->parent_dir,
+                                      rev_map_lookup, pb->rev_map,
+                                      pb->oldest_dumpstream_rev,
+                                      rb->rev_offset,
+                                      pb->notify_func, pb->notify_baton,
+                                      nb->pool, pb->notify_pool);
       svn_pool_clear(pb->notify_pool);
       if (err)
         {
@@ -999,6 +1197,7 @@ close_revision(void *baton)
   svn_error_t *err;
   const char *txn_name = NULL;
   apr_hash_t *hooks_env;
+  apr_pool_t *scratch_pool;
 
   /* If we're skipping this revision we're done here. */
   if (rb->skipped)
@@ -1085,20 +1284,26 @@ close_revision(void *baton)
         }
     }
 
+  /* The commit and the deltification each build structures, e.g. hashes
+     of all changed paths, that grow with the size of the revision.  Give
+     each of them its own scratch pool, so they don't add up. */
+  scratch_pool = svn_pool_create(rb->pool);
+
   /* Run the pre-commit hook, if so commanded. */
   if (pb->use_pre_commit_hook)
     {
       err = svn_repos__hooks_pre_commit(pb->repos, hooks_env,
-                                        txn_name, rb->pool);
+                                        txn_name, scratch_pool);
       if (err)
         {
-          svn_error_clear(svn_fs_abort_txn(rb->txn, rb->pool));
+          svn_error_clear(svn_fs_abort_txn(rb->txn, scratch_pool));
           return svn_error_trace(err);
         }
     }
 
   /* Commit. */
-  err = svn_fs_commit_txn(&conflict_msg, &committed_rev, rb->txn, rb->pool);
+  err = svn_fs_commit_txn(&conflict_msg, &committed_rev, rb->txn,
+                          scratch_pool);
   if (SVN_IS_VALID_REVNUM(committed_rev))
     {
       if (err)
@@ -1111,50 +1316,59 @@ close_revision(void *baton)
     }
   else
     {
-      svn_error_clear(svn_fs_abort_txn(rb->txn, rb->pool));
+      svn_error_clear(svn_fs_abort_txn(rb->txn, scratch_pool));
       if (conflict_msg)
         return svn_error_quick_wrap(err, conflict_msg);
       else
         return svn_error_trace(err);
     }
 
+  svn_pool_clear(scratch_pool);
+
   /* Run post-commit hook, if so commanded.  */
   if (pb->use_post_commit_hook)
     {
       if ((err = svn_repos__hooks_post_commit(pb->repos, hooks_env,
                                               committed_rev, txn_name,
-                                              rb->pool)))
+                                              scratch_pool)))
         return svn_error_create
           (SVN_ERR_REPOS_POST_COMMIT_HOOK_FAILED, err,
            _("Commit succeeded, but post-commit hook failed"));
     }
 
-  /* After a successful commit, must record the dump-rev -> in-repos-rev
-     mapping, so that copyfrom instructions in the dump file can look up the
-     correct repository revision to copy from. */
-  set_revision_mapping(pb->rev_map, rb->rev, committed_rev);
-
   /* If the incoming dump stream has non-contiguous revisions (e.g. from
      using svndumpfilter --drop-empty-revs without --renumber-revs) then
      we must account for the missing gaps in PB->REV_MAP.  Otherwise we
      might not be able to map all mergeinfo source revisions to the correct
-     revisions in the target repos. */
+     revisions in the target repos.  Filling the gaps first keeps the
+     revision map dense. */
   if ((pb->last_rev_mapped != SVN_INVALID_REVNUM)
-      && (rb->rev != pb->last_rev_mapped + 1))
+      && (rb->rev > pb->last_rev_mapped + 1))
     {
       svn_revnum_t i;
 
       for (i = pb->last_rev_mapped + 1; i < rb->rev; i++)
         {
-          set_revision_mapping(pb->rev_map, i, pb->last_rev_mapped);
+          svn_pool_clear(scratch_pool);
+          SVN_ERR(set_revision_mapping(pb->rev_map, i, pb->last_rev_mapped,
+                                       scratch_pool));
         }
     }
 
+  /* After a successful commit, must record the dump-rev -> in-repos-rev
+     mapping, so that copyfrom instructions in the dump file can look up the
+     correct repository revision to copy from. */
+  svn_pool_clear(scratch_pool);
+  SVN_ERR(set_revision_mapping(pb->rev_map, rb->rev, committed_rev,
+                               scratch_pool));
+
   /* Update our "last revision mapped". */
   pb->last_rev_mapped = rb->rev;
 
   /* Deltify the predecessors of paths changed in this revision. */
-  SVN_ERR(svn_fs_deltify_revision(pb->fs, committed_rev, rb->pool));
+  svn_pool_clear(scratch_pool);
+  SVN_ERR(svn_fs_deltify_revision(pb->fs, committed_rev, scratch_pool));
+  svn_pool_destroy(scratch_pool);
 
   if (pb->notify_func)
     {
@@ -1234,7 +1448,7 @@ svn_repos_get_fs_build_parser6(const svn_repos_parse_fns3_t **callbacks,
   pb->parent_dir = parent_dir;
   pb->pool = pool;
   pb->notify_pool = svn_pool_create(pool);
-  pb->rev_map = apr_hash_make(pool);
+  pb->rev_map = rev_map_create(pool);
   pb->oldest_dumpstream_rev = SVN_INVALID_REVNUM;
   pb->last_rev_mapped = SVN_INVALID_REVNUM;
   pb->start_rev = start_rev;
@@ -1251,7 +1465,7 @@ svn_repos_get_fs_build_parser6(const svn_repos_parse_fns3_t **callbacks,
 
 
 svn_error_t *
-svn_repos_load_fs6(svn_repos_t *repos,
+svn_repos_load_fs7(svn_repos_t *repos,
                    svn_stream_t *dumpstream,
                    svn_revnum_t start_rev,
                    svn_revnum_t end_rev,
@@ -1262,6 +1476,7 @@ svn_repos_load_fs6(svn_repos_t *repos,
                    svn_boolean_t validate_props,
                    svn_boolean_t ignore_dates,
                    svn_boolean_t normalize_props,
+                   svn_boolean_t pipelined,
                    svn_repos_notify_func_t notify_func,
                    void *notify_baton,
                    svn_cancel_func_t cancel_func,
@@ -1288,6 +1503,12 @@ svn_repos_load_fs6(svn_repos_t *repos,
                                          notify_baton,
                                          pool));
 
+  if (pipelined)
+    return svn_repos__parse_dumpstream_pipelined(dumpstream, parser,
+                                                 parse_baton, FALSE,
+                                                 cancel_func, cancel_baton,
+                                                 pool);
+
   return svn_repos_parse_dumpstream3(dumpstream, parser, parse_baton, FALSE,
                                      cancel_func, cancel_baton, pool);
 }
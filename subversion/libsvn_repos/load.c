@@ -33,6 +33,8 @@
 #include "svn_ctype.h"
 
 #include "private/svn_dep_compat.h"
+#include "private/svn_repos_private.h"
+#include "private/svn_worker_pool.h"
 
 /*----------------------------------------------------------------------*/
 
@@ -283,6 +285,24 @@ parse_property_block(svn_stream_t *stream,
 }
 
 
+/* Skip CONTENT_LENGTH bytes of STREAM. */
+static svn_error_t *
+skip_content(svn_stream_t *stream,
+             svn_filesize_t content_length)
+{
+  while (content_length)
+    {
+      apr_size_t len = content_length > APR_SIZE_MAX
+                     ? APR_SIZE_MAX
+                     : (apr_size_t)content_length;
+
+      SVN_ERR(svn_stream_skip(stream, len));
+      content_length -= len;
+    }
+
+  return SVN_NO_ERROR;
+}
+
 /* Read CONTENT_LENGTH bytes from STREAM. If IS_DELTA is true, use
    PARSE_FNS->apply_textdelta to push a text delta, otherwise use
    PARSE_FNS->set_fulltext to push those bytes as replace fulltext for
@@ -317,8 +337,11 @@ parse_text_block(svn_stream_t *stream,
       SVN_ERR(parse_fns->set_fulltext(&text_stream, record_baton));
     }
 
-  /* Regardless of whether or not we have a sink for our data, we
-     need to read it. */
+  /* Without a sink for our data, just get past it.  For files, this
+     seeks instead of reading the data. */
+  if (!text_stream)
+    return svn_error_trace(skip_content(stream, content_length));
+
   while (content_length)
     {
       if (content_length >= (svn_filesize_t)buflen)
@@ -749,7 +772,6 @@ svn_repos_parse_dumpstream3(svn_stream_t *stream,
       */
       if (content_length && ! old_v1_with_cl)
         {
-          apr_size_t rlen, num_to_read;
           svn_filesize_t remaining =
             svn__atoui64(content_length) -
             (prop_cl ? svn__atoui64(prop_cl) : 0) -
@@ -761,20 +783,8 @@ svn_repos_parse_dumpstream3(svn_stream_t *stream,
                                     _("Sum of subblock sizes larger than "
                                       "total block content length"));
 
-          /* Consume remaining bytes in this content block */
-          while (remaining > 0)
-            {
-              if (remaining >= (svn_filesize_t)buflen)
-                rlen = buflen;
-              else
-                rlen = (apr_size_t) remaining;
-
-              num_to_read = rlen;
-              SVN_ERR(svn_stream_read_full(stream, buffer, &rlen));
-              remaining -= rlen;
-              if (rlen != num_to_read)
-                return stream_ran_dry();
-            }
+          /* Skip remaining bytes in this content block */
+          SVN_ERR(skip_content(stream, remaining));
         }
 
       /* If we just finished processing a node record, we need to
@@ -798,3 +808,781 @@ svn_repos_parse_dumpstream3(svn_stream_t *stream,
   svn_pool_destroy(nodepool);
   return SVN_NO_ERROR;
 }
+
+
+/*----------------------------------------------------------------------*/
+
+/** Pipelined parsing **/
+
+/* Approximate number of bytes of parser output to collect in one batch
+   before handing it over to the consumer. */
+#define PIPELINE_BATCH_SIZE 0x100000
+
+/* Maximum number of batches that the parser may run ahead of the
+   consumer. */
+#define PIPELINE_QUEUE_SIZE 4
+
+/* The vtable calls that the parser thread records for the consumer. */
+typedef enum pipeline_op_kind_t
+{
+  pipeline_magic_header_record,
+  pipeline_uuid_record,
+  pipeline_new_revision_record,
+  pipeline_new_node_record,
+  pipeline_set_revision_property,
+  pipeline_set_node_property,
+  pipeline_delete_node_property,
+  pipeline_remove_node_props,
+  pipeline_set_fulltext,
+  pipeline_write_fulltext,
+  pipeline_close_fulltext,
+  pipeline_apply_textdelta,
+  pipeline_push_window,
+  pipeline_close_node,
+  pipeline_close_revision
+} pipeline_op_kind_t;
+
+/* A single recorded vtable call.  Only the members that are relevant
+   for KIND are being set. */
+typedef struct pipeline_op_t
+{
+  pipeline_op_kind_t kind;
+
+  /* Dump format version. */
+  int version;
+
+  /* UUID or property name. */
+  const char *name;
+
+  /* Property value or fulltext chunk. */
+  const svn_string_t *value;
+
+  /* Record headers, const char * -> const char *. */
+  apr_hash_t *headers;
+
+  /* Delta window; NULL for the final window. */
+  svn_txdelta_window_t *window;
+
+  /* Next call in the same batch or NULL. */
+  struct pipeline_op_t *next;
+} pipeline_op_t;
+
+/* A sequence of recorded vtable calls. */
+typedef struct pipeline_batch_t
+{
+  /* Linked list of calls, in order. */
+  pipeline_op_t *first;
+  pipeline_op_t *last;
+
+  /* Approximate memory size of the recorded data. */
+  apr_size_t size;
+
+  /* Root pool containing the batch.  The batch gets handed over to the
+     consumer thread, so this must not share an allocator with any other
+     pool. */
+  apr_pool_t *pool;
+} pipeline_batch_t;
+
+/* State of a pipelined parse, shared between the parser thread and the
+   consumer. */
+typedef struct pipeline_t
+{
+  /* Parameters as passed to svn_repos__parse_dumpstream_pipelined. */
+  svn_stream_t *stream;
+  svn_boolean_t deltas_are_text;
+  svn_cancel_func_t cancel_func;
+  void *cancel_baton;
+
+  /* The batch being filled by the parser thread.  NULL if there is none.
+     Only accessed by the parser thread. */
+  pipeline_batch_t *batch;
+
+  /* The stream returned by record_set_fulltext.  Only one text can be
+     open at any time, so we reuse it.  Only accessed by the parser
+     thread. */
+  svn_stream_t *fulltext_stream;
+
+  /* Ring buffer of COUNT batches that are ready to be consumed, the
+     oldest being at index FIRST. */
+  pipeline_batch_t *queue[PIPELINE_QUEUE_SIZE];
+  int first;
+  int count;
+
+  /* Set by the parser thread when it is done.  PARSER_ERR is the result
+     of svn_repos_parse_dumpstream3. */
+  svn_boolean_t done;
+  svn_error_t *parser_err;
+
+  /* Set by the consumer when it won't accept any more batches. */
+  svn_boolean_t aborted;
+
+  /* Runs the parse_job().  Its mutex protects QUEUE, FIRST, COUNT, DONE,
+     PARSER_ERR and ABORTED and it gets notified whenever any of them has
+     been changed. */
+  svn_worker_pool__t *workers;
+
+  /* Owns WORKERS. */
+  apr_pool_t *workers_pool;
+} pipeline_t;
+
+/* Append a new call of type KIND to the current batch in PIPELINE and
+   return it.  Add SIZE to the batch's size. */
+static pipeline_op_t *
+add_op(pipeline_t *pipeline,
+       pipeline_op_kind_t kind,
+       apr_size_t size)
+{
+  pipeline_batch_t *batch = pipeline->batch;
+  pipeline_op_t *op;
+
+  if (batch == NULL)
+    {
+      apr_pool_t *pool
+        = apr_allocator_owner_get(svn_pool_create_allocator(FALSE));
+
+      batch = apr_pcalloc(pool, sizeof(*batch));
+      batch->pool = pool;
+      pipeline->batch = batch;
+    }
+
+  op = apr_pcalloc(batch->pool, sizeof(*op));
+  op->kind = kind;
+
+  if (batch->last)
+    batch->last->next = op;
+  else
+    batch->first = op;
+
+  batch->last = op;
+  batch->size += size + sizeof(*op);
+
+  return op;
+}
+
+/* Return a deep copy of HEADERS, allocated in RESULT_POOL.  If SIZE is
+   not NULL, add the length of all keys and values to *SIZE. */
+static apr_hash_t *
+dup_headers(apr_hash_t *headers,
+            apr_size_t *size,
+            apr_pool_t *result_pool)
+{
+  apr_hash_t *result = apr_hash_make(result_pool);
+  apr_hash_index_t *hi;
+
+  for (hi = apr_hash_first(result_pool, headers); hi; hi = apr_hash_next(hi))
+    {
+      const char *key = apr_hash_this_key(hi);
+      const char *val = apr_hash_this_val(hi);
+
+      svn_hash_sets(result, apr_pstrdup(result_pool, key),
+                    apr_pstrdup(result_pool, val));
+      if (size)
+        *size += strlen(key) + strlen(val);
+    }
+
+  return result;
+}
+
+/* Hand the current batch in PIPELINE over to the consumer, blocking
+   while the queue is full.  Return SVN_ERR_CANCELLED if the consumer
+   stopped accepting batches. */
+static svn_error_t *
+flush_batch(pipeline_t *pipeline)
+{
+  pipeline_batch_t *batch = pipeline->batch;
+  svn_boolean_t aborted;
+  svn_error_t *err = SVN_NO_ERROR;
+
+  if (batch == NULL)
+    return SVN_NO_ERROR;
+
+  pipeline->batch = NULL;
+
+  err = svn_worker_pool__lock(pipeline->workers);
+  if (err)
+    {
+      svn_pool_destroy(batch->pool);
+      return svn_error_trace(err);
+    }
+
+  while (!err && !pipeline->aborted
+         && !svn_worker_pool__stopping(pipeline->workers)
+         && pipeline->count == PIPELINE_QUEUE_SIZE)
+    err = svn_worker_pool__wait_for_change(pipeline->workers);
+
+  aborted = err || pipeline->aborted
+         || svn_worker_pool__stopping(pipeline->workers);
+  if (!aborted)
+    {
+      pipeline->queue[(pipeline->first + pipeline->count)
+                      % PIPELINE_QUEUE_SIZE] = batch;
+      pipeline->count++;
+      err = svn_worker_pool__notify(pipeline->workers);
+    }
+
+  err = svn_worker_pool__unlock(pipeline->workers, err);
+
+  if (aborted)
+    {
+      svn_pool_destroy(batch->pool);
+      if (!err)
+        err = svn_error_create(SVN_ERR_CANCELLED, NULL, NULL);
+    }
+
+  return svn_error_trace(err);
+}
+
+/* Hand the current batch in PIPELINE over to the consumer if it has
+   grown large enough. */
+static svn_error_t *
+maybe_flush_batch(pipeline_t *pipeline)
+{
+  if (pipeline->batch && pipeline->batch->size >= PIPELINE_BATCH_SIZE)
+    SVN_ERR(flush_batch(pipeline));
+
+  return SVN_NO_ERROR;
+}
+
+/* The recording vtable used by the parser thread.  All batons are the
+   pipeline_t. */
+
+/* Implements svn_repos_parse_fns3_t.magic_header_record. */
+static svn_error_t *
+record_magic_header_record(int version,
+                           void *parse_baton,
+                           apr_pool_t *pool)
+{
+  pipeline_t *pipeline = parse_baton;
+  pipeline_op_t *op = add_op(pipeline, pipeline_magic_header_record, 0);
+
+  op->version = version;
+
+  return svn_error_trace(maybe_flush_batch(pipeline));
+}
+
+/* Implements svn_repos_parse_fns3_t.uuid_record. */
+static svn_error_t *
+record_uuid_record(const char *uuid,
+                   void *parse_baton,
+                   apr_pool_t *pool)
+{
+  pipeline_t *pipeline = parse_baton;
+  pipeline_op_t *op = add_op(pipeline, pipeline_uuid_record, strlen(uuid));
+
+  op->name = apr_pstrdup(pipeline->batch->pool, uuid);
+
+  return svn_error_trace(maybe_flush_batch(pipeline));
+}
+
+/* Implements svn_repos_parse_fns3_t.new_revision_record. */
+static svn_error_t *
+record_new_revision_record(void **revision_baton,
+                           apr_hash_t *headers,
+                           void *parse_baton,
+                           apr_pool_t *pool)
+{
+  pipeline_t *pipeline = parse_baton;
+  pipeline_op_t *op = add_op(pipeline, pipeline_new_revision_record, 0);
+
+  op->headers = dup_headers(headers, &pipeline->batch->size,
+                            pipeline->batch->pool);
+  *revision_baton = pipeline;
+
+  return svn_error_trace(maybe_flush_batch(pipeline));
+}
+
+/* Implements svn_repos_parse_fns3_t.new_node_record. */
+static svn_error_t *
+record_new_node_record(void **node_baton,
+                       apr_hash_t *headers,
+                       void *revision_baton,
+                       apr_pool_t *pool)
+{
+  pipeline_t *pipeline = revision_baton;
+  pipeline_op_t *op;
+
+  /* Nodes outside any revision would not even make sense to the
+     non-pipelined consumers. */
+  if (pipeline == NULL)
+    return svn_error_create(SVN_ERR_STREAM_MALFORMED_DATA, NULL,
+                            _("Node record outside of any revision "
+                              "in dumpstream"));
+
+  op = add_op(pipeline, pipeline_new_node_record, 0);
+  op->headers = dup_headers(headers, &pipeline->batch->size,
+                            pipeline->batch->pool);
+  *node_baton = pipeline;
+
+  return svn_error_trace(maybe_flush_batch(pipeline));
+}
+
+/* Record a property change of type KIND for NAME and VALUE in
+   PIPELINE. */
+static svn_error_t *
+record_property(pipeline_t *pipeline,
+                pipeline_op_kind_t kind,
+                const char *name,
+                const svn_string_t *value)
+{
+  pipeline_op_t *op = add_op(pipeline, kind,
+                             strlen(name) + (value ? value->len : 0));
+
+  op->name = apr_pstrdup(pipeline->batch->pool, name);
+  if (value)
+    op->value = svn_string_dup(value, pipeline->batch->pool);
+
+  return svn_error_trace(maybe_flush_batch(pipeline));
+}
+
+/* Implements svn_repos_parse_fns3_t.set_revision_property. */
+static svn_error_t *
+record_set_revision_property(void *revision_baton,
+                             const char *name,
+                             const svn_string_t *value)
+{
+  return svn_error_trace(record_property(revision_baton,
+                                         pipeline_set_revision_property,
+                                         name, value));
+}
+
+/* Implements svn_repos_parse_fns3_t.set_node_property. */
+static svn_error_t *
+record_set_node_property(void *node_baton,
+                         const char *name,
+                         const svn_string_t *value)
+{
+  return svn_error_trace(record_property(node_baton,
+                                         pipeline_set_node_property,
+                                         name, value));
+}
+
+/* Implements svn_repos_parse_fns3_t.delete_node_property. */
+static svn_error_t *
+record_delete_node_property(void *node_baton,
+                            const char *name)
+{
+  return svn_error_trace(record_property(node_baton,
+                                         pipeline_delete_node_property,
+                                         name, NULL));
+}
+
+/* Implements svn_repos_parse_fns3_t.remove_node_props. */
+static svn_error_t *
+record_remove_node_props(void *node_baton)
+{
+  pipeline_t *pipeline = node_baton;
+  add_op(pipeline, pipeline_remove_node_props, 0);
+
+  return svn_error_trace(maybe_flush_batch(pipeline));
+}
+
+/* Implements svn_write_fn_t for the fulltext recording stream. */
+static svn_error_t *
+record_write_fulltext(void *baton,
+                      const char *data,
+                      apr_size_t *len)
+{
+  pipeline_t *pipeline = baton;
+  pipeline_op_t *op = add_op(pipeline, pipeline_write_fulltext, *len);
+
+  op->value = svn_string_ncreate(data, *len, pipeline->batch->pool);
+
+  return svn_error_trace(maybe_flush_batch(pipeline));
+}
+
+/* Implements svn_close_fn_t for the fulltext recording stream. */
+static svn_error_t *
+record_close_fulltext(void *baton)
+{
+  pipeline_t *pipeline = baton;
+  add_op(pipeline, pipeline_close_fulltext, 0);
+
+  return svn_error_trace(maybe_flush_batch(pipeline));
+}
+
+/* Implements svn_repos_parse_fns3_t.set_fulltext. */
+static svn_error_t *
+record_set_fulltext(svn_stream_t **stream,
+                    void *node_baton)
+{
+  pipeline_t *pipeline = node_baton;
+  add_op(pipeline, pipeline_set_fulltext, 0);
+
+  *stream = pipeline->fulltext_stream;
+
+  return svn_error_trace(maybe_flush_batch(pipeline));
+}
+
+/* Implements svn_txdelta_window_handler_t. */
+static svn_error_t *
+record_push_window(svn_txdelta_window_t *window,
+                   void *baton)
+{
+  pipeline_t *pipeline = baton;
+  pipeline_op_t *op;
+
+  if (window)
+    {
+      op = add_op(pipeline, pipeline_push_window,
+                  window->num_ops * sizeof(*window->ops)
+                  + (window->new_data ? window->new_data->len : 0));
+      op->window = svn_txdelta_window_dup(window, pipeline->batch->pool);
+    }
+  else
+    {
+      add_op(pipeline, pipeline_push_window, 0);
+    }
+
+  return svn_error_trace(maybe_flush_batch(pipeline));
+}
+
+/* Implements svn_repos_parse_fns3_t.apply_textdelta. */
+static svn_error_t *
+record_apply_textdelta(svn_txdelta_window_handler_t *handler,
+                       void **handler_baton,
+                       void *node_baton)
+{
+  pipeline_t *pipeline = node_baton;
+  add_op(pipeline, pipeline_apply_textdelta, 0);
+
+  *handler = record_push_window;
+  *handler_baton = pipeline;
+
+  return svn_error_trace(maybe_flush_batch(pipeline));
+}
+
+/* Implements svn_repos_parse_fns3_t.close_node. */
+static svn_error_t *
+record_close_node(void *node_baton)
+{
+  pipeline_t *pipeline = node_baton;
+  add_op(pipeline, pipeline_close_node, 0);
+
+  return svn_error_trace(maybe_flush_batch(pipeline));
+}
+
+/* Implements svn_repos_parse_fns3_t.close_revision. */
+static svn_error_t *
+record_close_revision(void *revision_baton)
+{
+  pipeline_t *pipeline = revision_baton;
+  add_op(pipeline, pipeline_close_revision, 0);
+
+  return svn_error_trace(maybe_flush_batch(pipeline));
+}
+
+/* Implements svn_worker_pool__func_t.  BATON is the pipeline_t.  Parse
+   the dump stream and queue up the resulting vtable calls for the
+   consumer. */
+static svn_error_t *
+parse_job(void *baton,
+          apr_pool_t *scratch_pool)
+{
+  pipeline_t *pipeline = baton;
+  svn_repos_parse_fns3_t *recorder = apr_pcalloc(scratch_pool,
+                                                 sizeof(*recorder));
+  svn_error_t *err;
+
+  recorder->magic_header_record = record_magic_header_record;
+  recorder->uuid_record = record_uuid_record;
+  recorder->new_revision_record = record_new_revision_record;
+  recorder->new_node_record = record_new_node_record;
+  recorder->set_revision_property = record_set_revision_property;
+  recorder->set_node_property = record_set_node_property;
+  recorder->delete_node_property = record_delete_node_property;
+  recorder->remove_node_props = record_remove_node_props;
+  recorder->set_fulltext = record_set_fulltext;
+  recorder->apply_textdelta = record_apply_textdelta;
+  recorder->close_node = record_close_node;
+  recorder->close_revision = record_close_revision;
+
+  pipeline->fulltext_stream = svn_stream_create(pipeline, scratch_pool);
+  svn_stream_set_write(pipeline->fulltext_stream, record_write_fulltext);
+  svn_stream_set_close(pipeline->fulltext_stream, record_close_fulltext);
+
+  err = svn_repos_parse_dumpstream3(pipeline->stream, recorder, pipeline,
+                                    pipeline->deltas_are_text,
+                                    pipeline->cancel_func,
+                                    pipeline->cancel_baton, scratch_pool);
+
+  /* Even after a parser error, the consumer shall see all the calls that
+     were made before it, just as with the non-pipelined parser. */
+  err = svn_error_compose_create(err, flush_batch(pipeline));
+
+  SVN_ERR(svn_worker_pool__lock(pipeline->workers));
+  pipeline->parser_err = err;
+  pipeline->done = TRUE;
+
+  return svn_error_trace(svn_worker_pool__unlock(pipeline->workers,
+                           svn_worker_pool__notify(pipeline->workers)));
+}
+
+/* The consumer's state while replaying the recorded calls. */
+typedef struct pipeline_consumer_t
+{
+  /* The vtable to drive, with all callbacks being set. */
+  const svn_repos_parse_fns3_t *parse_fns;
+  void *parse_baton;
+
+  /* The currently open revision and node, if any. */
+  void *rev_baton;
+  void *node_baton;
+  svn_boolean_t node_open;
+
+  /* Where to send text changes for the current record.  May be NULL. */
+  svn_stream_t *text_stream;
+  svn_txdelta_window_handler_t window_handler;
+  void *window_baton;
+
+  /* Pools with the same lifetimes as those used by the parser. */
+  apr_pool_t *pool;
+  apr_pool_t *revpool;
+  apr_pool_t *nodepool;
+} pipeline_consumer_t;
+
+/* Replay the calls recorded in BATCH against the vtable in CONSUMER. */
+static svn_error_t *
+consume_batch(pipeline_consumer_t *consumer,
+              pipeline_batch_t *batch)
+{
+  const svn_repos_parse_fns3_t *parse_fns = consumer->parse_fns;
+  pipeline_op_t *op;
+
+  for (op = batch->first; op; op = op->next)
+    {
+      void *record_baton = consumer->node_open ? consumer->node_baton
+                                               : consumer->rev_baton;
+      apr_size_t len;
+
+      switch (op->kind)
+        {
+          case pipeline_magic_header_record:
+            SVN_ERR(parse_fns->magic_header_record(op->version,
+                                                   consumer->parse_baton,
+                                                   consumer->pool));
+            break;
+
+          case pipeline_uuid_record:
+            SVN_ERR(parse_fns->uuid_record(apr_pstrdup(consumer->pool,
+                                                       op->name),
+                                           consumer->parse_baton,
+                                           consumer->pool));
+            break;
+
+          case pipeline_new_revision_record:
+            SVN_ERR(parse_fns->new_revision_record(
+                                  &consumer->rev_baton,
+                                  dup_headers(op->headers, NULL,
+                                              consumer->revpool),
+                                  consumer->parse_baton,
+                                  consumer->revpool));
+            break;
+
+          case pipeline_new_node_record:
+            SVN_ERR(parse_fns->new_node_record(
+                                  &consumer->node_baton,
+                                  dup_headers(op->headers, NULL,
+                                              consumer->nodepool),
+                                  consumer->rev_baton,
+                                  consumer->nodepool));
+            consumer->node_open = TRUE;
+            break;
+
+          case pipeline_set_revision_property:
+            SVN_ERR(parse_fns->set_revision_property(consumer->rev_baton,
+                                                     op->name, op->value));
+            break;
+
+          case pipeline_set_node_property:
+            SVN_ERR(parse_fns->set_node_property(consumer->node_baton,
+                                                 op->name, op->value));
+            break;
+
+          case pipeline_delete_node_property:
+            SVN_ERR(parse_fns->delete_node_property(consumer->node_baton,
+                                                    op->name));
+            break;
+
+          case pipeline_remove_node_props:
+            SVN_ERR(parse_fns->remove_node_props(consumer->node_baton));
+            break;
+
+          case pipeline_set_fulltext:
+            SVN_ERR(parse_fns->set_fulltext(&consumer->text_stream,
+                                            record_baton));
+            break;
+
+          case pipeline_write_fulltext:
+            if (consumer->text_stream)
+              {
+                len = op->value->len;
+                SVN_ERR(svn_stream_write(consumer->text_stream,
+                                         op->value->data, &len));
+                if (len != op->value->len)
+                  return svn_error_create(SVN_ERR_STREAM_UNEXPECTED_EOF,
+                                          NULL,
+                                          _("Unexpected EOF writing "
+                                            "contents"));
+              }
+            break;
+
+          case pipeline_close_fulltext:
+            if (consumer->text_stream)
+              SVN_ERR(svn_stream_close(consumer->text_stream));
+            consumer->text_stream = NULL;
+            break;
+
+          case pipeline_apply_textdelta:
+            SVN_ERR(parse_fns->apply_textdelta(&consumer->window_handler,
+                                               &consumer->window_baton,
+                                               record_baton));
+            break;
+
+          case pipeline_push_window:
+            if (consumer->window_handler)
+              SVN_ERR(consumer->window_handler(op->window,
+                                               consumer->window_baton));
+            if (op->window == NULL)
+              consumer->window_handler = NULL;
+            break;
+
+          case pipeline_close_node:
+            SVN_ERR(parse_fns->close_node(consumer->node_baton));
+            svn_pool_clear(consumer->nodepool);
+            consumer->node_open = FALSE;
+            break;
+
+          case pipeline_close_revision:
+            if (consumer->rev_baton)
+              SVN_ERR(parse_fns->close_revision(consumer->rev_baton));
+            svn_pool_clear(consumer->revpool);
+            consumer->rev_baton = NULL;
+            break;
+        }
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Tell the parser thread in PIPELINE to stop, wait for it to exit and
+   release all unconsumed batches.  Return ERR, or the parser's error if
+   ERR is NULL. */
+static svn_error_t *
+stop_pipeline(pipeline_t *pipeline,
+              svn_error_t *err)
+{
+  svn_error_clear(svn_worker_pool__lock(pipeline->workers));
+  pipeline->aborted = TRUE;
+  svn_error_clear(svn_worker_pool__notify(pipeline->workers));
+  svn_error_clear(svn_worker_pool__unlock(pipeline->workers, SVN_NO_ERROR));
+
+  /* Waits for the running job to return. */
+  svn_pool_destroy(pipeline->workers_pool);
+
+  for (; pipeline->count; pipeline->count--)
+    {
+      svn_pool_destroy(pipeline->queue[pipeline->first]->pool);
+      pipeline->first = (pipeline->first + 1) % PIPELINE_QUEUE_SIZE;
+    }
+
+  if (err)
+    {
+      svn_error_clear(pipeline->parser_err);
+      return err;
+    }
+
+  return pipeline->parser_err;
+}
+
+svn_error_t *
+svn_repos__parse_dumpstream_pipelined(svn_stream_t *stream,
+                                      const svn_repos_parse_fns3_t *parse_fns,
+                                      void *parse_baton,
+                                      svn_boolean_t deltas_are_text,
+                                      svn_cancel_func_t cancel_func,
+                                      void *cancel_baton,
+                                      apr_pool_t *pool)
+{
+  pipeline_t *pipeline = apr_pcalloc(pool, sizeof(*pipeline));
+  pipeline_consumer_t *consumer;
+  svn_error_t *err;
+
+  pipeline->workers_pool = svn_pool_create(pool);
+  SVN_ERR(svn_worker_pool__create(&pipeline->workers, 1,
+                                  pipeline->workers_pool));
+  if (!pipeline->workers)
+    {
+      svn_pool_destroy(pipeline->workers_pool);
+      return svn_error_trace(svn_repos_parse_dumpstream3(stream, parse_fns,
+                                                         parse_baton,
+                                                         deltas_are_text,
+                                                         cancel_func,
+                                                         cancel_baton,
+                                                         pool));
+    }
+
+  pipeline->stream = stream;
+  pipeline->deltas_are_text = deltas_are_text;
+  pipeline->cancel_func = cancel_func;
+  pipeline->cancel_baton = cancel_baton;
+
+  consumer = apr_pcalloc(pool, sizeof(*consumer));
+  consumer->parse_fns = complete_vtable(parse_fns, pool);
+  consumer->parse_baton = parse_baton;
+  consumer->pool = pool;
+  consumer->revpool = svn_pool_create(pool);
+  consumer->nodepool = svn_pool_create(pool);
+
+  err = svn_worker_pool__post(NULL, pipeline->workers, parse_job, pipeline,
+                              pipeline->workers_pool);
+  if (err)
+    return svn_error_trace(stop_pipeline(pipeline, err));
+
+  /* Replay the parser's calls in order. */
+  while (TRUE)
+    {
+      pipeline_batch_t *batch = NULL;
+
+      err = svn_worker_pool__lock(pipeline->workers);
+      if (err)
+        return svn_error_trace(stop_pipeline(pipeline, err));
+
+      while (!err && !pipeline->count && !pipeline->done)
+        err = svn_worker_pool__wait_for_change(pipeline->workers);
+
+      if (!err && pipeline->count)
+        {
+          batch = pipeline->queue[pipeline->first];
+          pipeline->first = (pipeline->first + 1) % PIPELINE_QUEUE_SIZE;
+          pipeline->count--;
+          err = svn_worker_pool__notify(pipeline->workers);
+        }
+
+      err = svn_worker_pool__unlock(pipeline->workers, err);
+      if (err)
+        {
+          if (batch)
+            svn_pool_destroy(batch->pool);
+          return svn_error_trace(stop_pipeline(pipeline, err));
+        }
+
+      if (batch == NULL)
+        break;
+
+      if (cancel_func)
+        err = cancel_func(cancel_baton);
+      if (!err)
+        err = consume_batch(consumer, batch);
+
+      svn_pool_destroy(batch->pool);
+      if (err)
+        return svn_error_trace(stop_pipeline(pipeline, err));
+    }
+
+  SVN_ERR(stop_pipeline(pipeline, SVN_NO_ERROR));
+
+  svn_pool_destroy(consumer->revpool);
+  svn_pool_destroy(consumer->nodepool);
+
+  return SVN_NO_ERROR;
+}
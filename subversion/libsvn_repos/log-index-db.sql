@@ -0,0 +1,138 @@
+/* log-index-db.sql -- schema of the changed-paths index used by svn log
+ *   This is intended for use with SQLite 3
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+-- STMT_CREATE_SCHEMA
+/* For every revision, the paths that got changed in it plus all their
+   parent directories.  These are exactly the revisions in which the
+   respective node shows up in the node history. */
+CREATE TABLE path_revs (
+  path TEXT NOT NULL,
+  revision INTEGER NOT NULL,
+  PRIMARY KEY (path, revision)
+  ) WITHOUT ROWID;
+
+/* Paths that got added or replaced in REVISION, with their copy source
+   if they were copied.  This is where a node's history begins. */
+CREATE TABLE origins (
+  path TEXT NOT NULL,
+  revision INTEGER NOT NULL,
+  copyfrom_path TEXT,
+  copyfrom_rev INTEGER,
+  PRIMARY KEY (path, revision)
+  ) WITHOUT ROWID;
+
+/* The svn:mergeinfo of PATH as of REVISION, normalized if it parses and
+   NULL if the property got removed or PATH got deleted.  There is a row
+   for every revision in which that value changed, including those in
+   which PATH got copied along with one of its parents. */
+CREATE TABLE mergeinfo (
+  path TEXT NOT NULL,
+  revision INTEGER NOT NULL,
+  mergeinfo TEXT,
+  PRIMARY KEY (path, revision)
+  ) WITHOUT ROWID;
+
+/* Cached blame results:  For every line of PATH@REVISION, the revision
+   that last changed it, as a sequence of (revision, line count) pairs of
+   7b/8b encoded unsigned integers.  REVISION is the one in which PATH got
+   last changed, i.e. a location in the file's node history.  These rows
+   never become stale. */
+CREATE TABLE blame (
+  path TEXT NOT NULL,
+  revision INTEGER NOT NULL,
+  annotation BLOB NOT NULL,
+  PRIMARY KEY (path, revision)
+  ) WITHOUT ROWID;
+
+/* The single row with ID 0 holds the youngest revision indexed so far.
+   All revisions up to and including it are in the tables above. */
+CREATE TABLE progress (
+  id INTEGER NOT NULL PRIMARY KEY CHECK (id = 0),
+  revision INTEGER NOT NULL
+  );
+
+INSERT INTO progress (id, revision) VALUES (0, 0);
+
+PRAGMA USER_VERSION = 3;
+
+-- STMT_GET_INDEXED_REV
+SELECT revision
+FROM progress
+WHERE id = 0
+
+-- STMT_SET_INDEXED_REV
+UPDATE progress
+SET revision = ?1
+WHERE id = 0
+
+-- STMT_INSERT_PATH_REV
+INSERT OR IGNORE INTO path_revs (path, revision)
+VALUES (?1, ?2)
+
+-- STMT_INSERT_ORIGIN
+INSERT OR REPLACE INTO origins (path, revision, copyfrom_path, copyfrom_rev)
+VALUES (?1, ?2, ?3, ?4)
+
+-- STMT_SELECT_PATH_REVS
+SELECT revision
+FROM path_revs
+WHERE path = ?1 AND revision > ?2 AND revision <= ?3
+ORDER BY revision DESC
+
+-- STMT_SELECT_LATEST_ORIGIN
+SELECT revision, copyfrom_path, copyfrom_rev
+FROM origins
+WHERE path = ?1 AND revision <= ?2
+ORDER BY revision DESC
+LIMIT 1
+
+-- STMT_INSERT_MERGEINFO
+INSERT OR REPLACE INTO mergeinfo (path, revision, mergeinfo)
+VALUES (?1, ?2, ?3)
+
+-- STMT_SELECT_MERGEINFO
+SELECT mergeinfo
+FROM mergeinfo
+WHERE path = ?1 AND revision <= ?2
+ORDER BY revision DESC
+LIMIT 1
+
+-- STMT_SELECT_MERGEINFO_IN_RANGE
+/* The latest non-NULL mergeinfo as of revision ?3 of every path P
+   with ?1 < P < ?2. */
+SELECT path, mergeinfo
+FROM mergeinfo AS m
+WHERE path > ?1 AND path < ?2
+  AND revision = (SELECT MAX(revision) FROM mergeinfo
+                  WHERE path = m.path AND revision <= ?3)
+  AND mergeinfo IS NOT NULL
+ORDER BY path
+
+-- STMT_INSERT_BLAME
+INSERT OR REPLACE INTO blame (path, revision, annotation)
+VALUES (?1, ?2, ?3)
+
+-- STMT_SELECT_BLAME
+SELECT annotation
+FROM blame
+WHERE path = ?1 AND revision = ?2
@@ -56,6 +56,14 @@ typedef struct log_callbacks_t
   void *revision_receiver_baton;
   svn_repos_authz_func_t authz_read_func;
   void *authz_read_baton;
+
+  /* The changed-paths index of the repository, if it is current.
+     May be NULL. */
+  svn_repos__log_index_t *log_index;
+
+  /* The changes of the revision currently being sent, if they have been
+     fetched as part of a batch already.  May be NULL. */
+  svn_fs_path_change_iterator_t *changes;
 } log_callbacks_t;
 
 
@@ -226,6 +234,10 @@ svn_repos_check_revision_access(svn_repos_revision_access_level_t *access_level,
  * text or properties of the node were changed, or that the node was added
  * or deleted.
  *
+ * If CALLBACKS->PATH_CHANGE_RECEIVER returns SVN_ERR_CEASE_INVOCATION,
+ * stop reporting changes for ROOT.  Without CALLBACKS->AUTHZ_READ_FUNC,
+ * don't even read the remainder of the changes list.
+ *
  * If optional CALLBACKS->AUTHZ_READ_FUNC is non-NULL, then use it (with
  * CALLBACKS->AUTHZ_READ_BATON and FS) to check whether each changed-path
  * (and copyfrom_path) is readable:
@@ -256,9 +268,14 @@ detect_changed(svn_repos_revision_access_level_t *access_level,
   apr_pool_t *iterpool;
   svn_boolean_t found_readable = FALSE;
   svn_boolean_t found_unreadable = FALSE;
+  svn_boolean_t receiver_ceased = FALSE;
 
   /* Retrieve the first change in the list. */
-  SVN_ERR(svn_fs_paths_changed3(&iterator, root, scratch_pool, scratch_pool));
+  if (callbacks->changes)
+    iterator = callbacks->changes;
+  else
+    SVN_ERR(svn_fs_paths_changed3(&iterator, root, scratch_pool,
+                                  scratch_pool));
   SVN_ERR(svn_fs_path_change_get(&change, iterator));
 
   if (!change)
@@ -297,8 +314,8 @@ detect_changed(svn_repos_revision_access_level_t *access_level,
       found_readable = TRUE;
 
       /* Pre-1.6 revision files don't store the change path kind, so fetch
-         it manually. */
-      if (change->node_kind == svn_node_unknown)
+         it manually.  Not needed for changes we won't report. */
+      if (change->node_kind == svn_node_unknown && !receiver_ceased)
         {
           svn_fs_root_t *check_root = root;
           const char *check_path = path;
@@ -377,11 +394,26 @@ detect_changed(svn_repos_revision_access_level_t *access_level,
             }
         }
 
-      if (callbacks->path_change_receiver)
-        SVN_ERR(callbacks->path_change_receiver(
+      if (callbacks->path_change_receiver && !receiver_ceased)
+        {
+          svn_error_t *err
+            = callbacks->path_change_receiver(
                                      callbacks->path_change_receiver_baton,
                                      change,
-                                     iterpool));
+                                     iterpool);
+
+          /* The receiver does not want to see any more changes of this
+             revision.  Without authz, there is nothing left to do. */
+          if (err && err->apr_err == SVN_ERR_CEASE_INVOCATION)
+            {
+              svn_error_clear(err);
+              receiver_ceased = TRUE;
+              if (!callbacks->authz_read_func)
+                break;
+            }
+          else
+            SVN_ERR(err);
+        }
 
       /* Next changed path. */
       SVN_ERR(svn_fs_path_change_get(&change, iterator));
@@ -429,6 +461,13 @@ struct path_info
   svn_fs_history_t *hist;
   apr_pool_t *newpool;
   apr_pool_t *oldpool;
+
+  /* If the changed-paths index could tell us the whole history up front,
+     these are its svn_repos__log_index_location_t entries, youngest first,
+     and NEXT_LOCATION is the index of the one to report next.  HIST will
+     be NULL then. */
+  apr_array_header_t *locations;
+  int next_location;
 };
 
 /* Advance to the next history for the path.
@@ -462,6 +501,46 @@ get_history(struct path_info *info,
   apr_pool_t *subpool;
   const char *path;
 
+  if (info->locations)
+    {
+      const svn_repos__log_index_location_t *location;
+
+      if (info->next_location >= info->locations->nelts)
+        {
+          info->done = TRUE;
+          return SVN_NO_ERROR;
+        }
+
+      location = &APR_ARRAY_IDX(info->locations, info->next_location,
+                                svn_repos__log_index_location_t);
+      ++info->next_location;
+
+      svn_stringbuf_set(info->path, location->path);
+      info->history_rev = location->revision;
+
+      if (info->history_rev < start)
+        {
+          info->done = TRUE;
+          return SVN_NO_ERROR;
+        }
+
+      if (authz_read_func)
+        {
+          svn_boolean_t readable;
+          SVN_ERR(svn_fs_revision_root(&history_root, fs,
+                                       info->history_rev,
+                                       scratch_pool));
+          SVN_ERR(authz_read_func(&readable, history_root,
+                                  info->path->data,
+                                  authz_read_baton,
+                                  scratch_pool));
+          if (! readable)
+            info->done = TRUE;
+        }
+
+      return SVN_NO_ERROR;
+    }
+
   if (info->hist)
     {
       subpool = info->newpool;
@@ -548,70 +627,138 @@ get_history(struct path_info *info,
   return SVN_NO_ERROR;
 }
 
-/* Set INFO->HIST to the next history for the path *if* there is history
- * available and INFO->HISTORY_REV is equal to or greater than CURRENT.
- *
- * *CHANGED is set to TRUE if the path has history in the CURRENT revision,
- * otherwise it is not touched.
- *
- * If we do need to get the next history revision for the path, call
- * get_history to do it -- see it for details.
- */
-static svn_error_t *
-check_history(svn_boolean_t *changed,
-              struct path_info *info,
-              svn_fs_t *fs,
-              svn_revnum_t current,
-              svn_boolean_t strict,
-              svn_repos_authz_func_t authz_read_func,
-              void *authz_read_baton,
-              svn_revnum_t start,
-              apr_pool_t *result_pool,
-              apr_pool_t *scratch_pool)
+/* Priority queue comparison function for struct path_info * elements
+   in A and B.  Put the path with the youngest history revision first. */
+static int
+compare_history_rev(const void *a,
+                    const void *b)
 {
-  /* If we're already done with histories for this path,
-     don't try to fetch any more. */
-  if (info->done)
-    return SVN_NO_ERROR;
+  const struct path_info *lhs = *(const struct path_info * const *)a;
+  const struct path_info *rhs = *(const struct path_info * const *)b;
 
-  /* If the last rev we got for this path is less than CURRENT,
-     then just return and don't fetch history for this path.
-     The caller will get to this rev eventually or else reach
-     the limit. */
-  if (info->history_rev < current)
-    return SVN_NO_ERROR;
+  if (lhs->history_rev == rhs->history_rev)
+    return 0;
 
-  /* If the last rev we got for this path is equal to CURRENT
-     then set *CHANGED to true and get the next history
-     rev where this path was changed. */
-  *changed = TRUE;
-  return get_history(info, fs, strict, authz_read_func,
-                     authz_read_baton, start, result_pool, scratch_pool);
+  return lhs->history_rev > rhs->history_rev ? -1 : 1;
 }
 
-/* Return the next interesting revision in our list of HISTORIES. */
-static svn_revnum_t
-next_history_rev(const apr_array_header_t *histories)
+/* Return a priority queue of all path histories in HISTORIES that are not
+   done yet, youngest history revision first.  Allocate it in RESULT_POOL.
+ */
+static svn_priority_queue__t *
+make_history_queue(const apr_array_header_t *histories,
+                   apr_pool_t *result_pool)
 {
-  svn_revnum_t next_rev = SVN_INVALID_REVNUM;
+  apr_array_header_t *elements
+    = apr_array_make(result_pool, histories->nelts,
+                     sizeof(struct path_info *));
   int i;
 
   for (i = 0; i < histories->nelts; ++i)
     {
       struct path_info *info = APR_ARRAY_IDX(histories, i,
                                              struct path_info *);
-      if (info->done)
-        continue;
-      if (info->history_rev > next_rev)
-        next_rev = info->history_rev;
+      if (! info->done)
+        APR_ARRAY_PUSH(elements, struct path_info *) = info;
+    }
+
+  return svn_priority_queue__create(elements, compare_history_rev);
+}
+
+/* Set *CURRENT to the youngest revision in which any of the histories in
+   QUEUE has changed and advance all histories that changed in *CURRENT by
+   calling get_history for them -- see there for the other parameters.
+   Histories that are done get removed from QUEUE.
+
+   Set *CURRENT to SVN_INVALID_REVNUM if QUEUE is empty.  Histories that
+   did not change in *CURRENT are not touched.
+ */
+static svn_error_t *
+next_history_rev(svn_revnum_t *current,
+                 svn_priority_queue__t *queue,
+                 svn_fs_t *fs,
+                 svn_boolean_t strict,
+                 svn_repos_authz_func_t authz_read_func,
+                 void *authz_read_baton,
+                 svn_revnum_t start,
+                 apr_pool_t *result_pool,
+                 apr_pool_t *scratch_pool)
+{
+  apr_array_header_t *changed;
+  apr_pool_t *iterpool;
+  struct path_info *info = svn_priority_queue__peek(queue);
+  int i;
+
+  if (! info)
+    {
+      *current = SVN_INVALID_REVNUM;
+      return SVN_NO_ERROR;
+    }
+
+  /* Take all histories that changed in *CURRENT out of the queue before
+     advancing them, so each one gets advanced exactly once. */
+  *current = info->history_rev;
+  changed = apr_array_make(scratch_pool, 4, sizeof(info));
+  do
+    {
+      APR_ARRAY_PUSH(changed, struct path_info *) = info;
+      svn_priority_queue__pop(queue);
+      info = svn_priority_queue__peek(queue);
+    }
+  while (info && info->history_rev == *current);
+
+  iterpool = svn_pool_create(scratch_pool);
+  for (i = 0; i < changed->nelts; ++i)
+    {
+      info = APR_ARRAY_IDX(changed, i, struct path_info *);
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(get_history(info, fs, strict, authz_read_func,
+                          authz_read_baton, start, result_pool, iterpool));
+      if (! info->done)
+        svn_priority_queue__push(queue, info);
+    }
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Like svn_fs__get_mergeinfo_for_path() but answer from the changed-paths
+   index LOG_INDEX if that is not NULL. */
+static svn_error_t *
+get_mergeinfo_for_path(svn_mergeinfo_t *mergeinfo,
+                       svn_repos__log_index_t *log_index,
+                       svn_fs_root_t *root,
+                       const char *path,
+                       svn_mergeinfo_inheritance_t inherit,
+                       svn_boolean_t adjust_inherited_mergeinfo,
+                       apr_pool_t *result_pool,
+                       apr_pool_t *scratch_pool)
+{
+  if (log_index)
+    {
+      svn_node_kind_t kind;
+
+      /* Leave reporting missing paths to the FS. */
+      SVN_ERR(svn_fs_check_path(&kind, root, path, scratch_pool));
+      if (kind != svn_node_none)
+        return svn_error_trace(svn_repos__log_index_get_mergeinfo(
+                                 mergeinfo, log_index, path,
+                                 svn_fs_revision_root_revision(root),
+                                 inherit, adjust_inherited_mergeinfo,
+                                 result_pool, scratch_pool));
     }
 
-  return next_rev;
+  return svn_error_trace(svn_fs__get_mergeinfo_for_path(
+                           mergeinfo, root, path, inherit,
+                           adjust_inherited_mergeinfo,
+                           result_pool, scratch_pool));
 }
 
 /* Set *DELETED_MERGEINFO_CATALOG and *ADDED_MERGEINFO_CATALOG to
    catalogs describing how mergeinfo values on paths (which are the
-   keys of those catalogs) were changed in REV. */
+   keys of those catalogs) were changed in REV.  Use LOG_INDEX, if not NULL, to look up
+   inherited mergeinfo. */
 /* ### TODO: This would make a *great*, useful public function,
    ### svn_repos_fs_mergeinfo_changed()!  -- cmpilato  */
 static svn_error_t *
@@ -619,6 +766,7 @@ fs_mergeinfo_changed(svn_mergeinfo_catalog_t *deleted_mergeinfo_catalog,
                      svn_mergeinfo_catalog_t *added_mergeinfo_catalog,
                      svn_fs_t *fs,
                      svn_revnum_t rev,
+                     svn_repos__log_index_t *log_index,
                      apr_pool_t *result_pool,
                      apr_pool_t *scratch_pool)
 {
@@ -817,10 +965,10 @@ fs_mergeinfo_changed(svn_mergeinfo_catalog_t *deleted_mergeinfo_catalog,
         {
           svn_mergeinfo_t tmp_mergeinfo;
 
-          SVN_ERR(svn_fs__get_mergeinfo_for_path(&tmp_mergeinfo,
-                                                 root, changed_path,
-                                                 svn_mergeinfo_inherited, TRUE,
-                                                 iterpool, iterpool));
+          SVN_ERR(get_mergeinfo_for_path(&tmp_mergeinfo, log_index,
+                                         root, changed_path,
+                                         svn_mergeinfo_inherited, TRUE,
+                                         iterpool, iterpool));
           if (tmp_mergeinfo)
             SVN_ERR(svn_mergeinfo_to_string(&mergeinfo_value,
                                             tmp_mergeinfo,
@@ -831,10 +979,10 @@ fs_mergeinfo_changed(svn_mergeinfo_catalog_t *deleted_mergeinfo_catalog,
         {
           svn_mergeinfo_t tmp_mergeinfo;
 
-          SVN_ERR(svn_fs__get_mergeinfo_for_path(&tmp_mergeinfo,
-                                                 base_root, base_path,
-                                                 svn_mergeinfo_inherited, TRUE,
-                                                 iterpool, iterpool));
+          SVN_ERR(get_mergeinfo_for_path(&tmp_mergeinfo, log_index,
+                                         base_root, base_path,
+                                         svn_mergeinfo_inherited, TRUE,
+                                         iterpool, iterpool));
           if (tmp_mergeinfo)
             SVN_ERR(svn_mergeinfo_to_string(&prev_mergeinfo_value,
                                             tmp_mergeinfo,
@@ -877,13 +1025,15 @@ fs_mergeinfo_changed(svn_mergeinfo_catalog_t *deleted_mergeinfo_catalog,
 
 /* Determine what (if any) mergeinfo for PATHS was modified in
    revision REV, returning the differences for added mergeinfo in
-   *ADDED_MERGEINFO and deleted mergeinfo in *DELETED_MERGEINFO. */
+   *ADDED_MERGEINFO and deleted mergeinfo in *DELETED_MERGEINFO.
+   Use LOG_INDEX, if not NULL, to look up mergeinfo. */
 static svn_error_t *
 get_combined_mergeinfo_changes(svn_mergeinfo_t *added_mergeinfo,
                                svn_mergeinfo_t *deleted_mergeinfo,
                                svn_fs_t *fs,
                                const apr_array_header_t *paths,
                                svn_revnum_t rev,
+                               svn_repos__log_index_t *log_index,
                                apr_pool_t *result_pool,
                                apr_pool_t *scratch_pool)
 {
@@ -909,7 +1059,7 @@ get_combined_mergeinfo_changes(svn_mergeinfo_t *added_mergeinfo,
   /* Fetch the mergeinfo changes for REV. */
   err = fs_mergeinfo_changed(&deleted_mergeinfo_catalog,
                              &added_mergeinfo_catalog,
-                             fs, rev,
+                             fs, rev, log_index,
                              scratch_pool, scratch_pool);
   if (err)
     {
@@ -982,10 +1132,10 @@ get_combined_mergeinfo_changes(svn_mergeinfo_t *added_mergeinfo,
          this path.  Ignore not-found errors returned by the
          filesystem or invalid mergeinfo (Issue #3896).*/
       SVN_ERR(svn_fs_revision_root(&prev_root, fs, prev_rev, iterpool));
-      err = svn_fs__get_mergeinfo_for_path(&prev_mergeinfo,
-                                           prev_root, prev_path,
-                                           svn_mergeinfo_inherited, TRUE,
-                                           iterpool, iterpool);
+      err = get_mergeinfo_for_path(&prev_mergeinfo, log_index,
+                                   prev_root, prev_path,
+                                   svn_mergeinfo_inherited, TRUE,
+                                   iterpool, iterpool);
       if (err && (err->apr_err == SVN_ERR_FS_NOT_FOUND ||
                   err->apr_err == SVN_ERR_FS_NOT_DIRECTORY ||
                   err->apr_err == SVN_ERR_MERGEINFO_PARSE_ERROR))
@@ -1005,25 +1155,25 @@ get_combined_mergeinfo_changes(svn_mergeinfo_t *added_mergeinfo,
 
          To check for this we must fetch the "raw" previous inherited
          mergeinfo and the "raw" mergeinfo @REV then compare these. */
-      SVN_ERR(svn_fs__get_mergeinfo_for_path(&prev_inherited_mergeinfo,
-                                             prev_root, prev_path,
-                                             svn_mergeinfo_nearest_ancestor,
-                                             FALSE, /* adjust_inherited_mergeinfo */
-                                             iterpool, iterpool));
+      SVN_ERR(get_mergeinfo_for_path(&prev_inherited_mergeinfo, log_index,
+                                     prev_root, prev_path,
+                                     svn_mergeinfo_nearest_ancestor,
+                                     FALSE, /* adjust_inherited_mergeinfo */
+                                     iterpool, iterpool));
 
       /* Fetch the current mergeinfo (as of REV, and including
          inherited stuff) for this path. */
-      SVN_ERR(svn_fs__get_mergeinfo_for_path(&mergeinfo,
-                                             root, path,
-                                             svn_mergeinfo_inherited, TRUE,
-                                             iterpool, iterpool));
+      SVN_ERR(get_mergeinfo_for_path(&mergeinfo, log_index,
+                                     root, path,
+                                     svn_mergeinfo_inherited, TRUE,
+                                     iterpool, iterpool));
 
       /* Issue #4022 again, fetch the raw inherited mergeinfo. */
-      SVN_ERR(svn_fs__get_mergeinfo_for_path(&inherited_mergeinfo,
-                                             root, path,
-                                             svn_mergeinfo_nearest_ancestor,
-                                             FALSE, /* adjust_inherited_mergeinfo */
-                                             iterpool, iterpool));
+      SVN_ERR(get_mergeinfo_for_path(&inherited_mergeinfo, log_index,
+                                     root, path,
+                                     svn_mergeinfo_nearest_ancestor,
+                                     FALSE, /* adjust_inherited_mergeinfo */
+                                     iterpool, iterpool));
 
       if (!prev_mergeinfo && !mergeinfo)
         continue;
@@ -1381,6 +1531,33 @@ send_log(svn_revnum_t rev,
   return SVN_NO_ERROR;
 }
 
+/* Baton type for send_log_with_changes. */
+typedef struct send_logs_baton_t
+{
+  svn_fs_t *fs;
+  const apr_array_header_t *revprops;
+  log_callbacks_t *callbacks;
+} send_logs_baton_t;
+
+/* Implement svn_fs_paths_changed_receiver_t.  Send the log for REVISION
+   with the changes given by ITERATOR.  BATON is a send_logs_baton_t. */
+static svn_error_t *
+send_log_with_changes(void *baton,
+                      svn_revnum_t revision,
+                      svn_fs_path_change_iterator_t *iterator,
+                      apr_pool_t *scratch_pool)
+{
+  send_logs_baton_t *b = baton;
+  svn_error_t *err;
+
+  b->callbacks->changes = iterator;
+  err = send_log(revision, b->fs, NULL, NULL, FALSE, FALSE, b->revprops,
+                 FALSE, b->callbacks, scratch_pool);
+  b->callbacks->changes = NULL;
+
+  return svn_error_trace(err);
+}
+
 /* This controls how many history objects we keep open.  For any targets
    over this number we have to open and close their histories as needed,
    which is CPU intensive, but keeps us from using an unbounded amount of
@@ -1401,6 +1578,7 @@ get_path_histories(apr_array_header_t **histories,
                    svn_boolean_t ignore_missing_locations,
                    svn_repos_authz_func_t authz_read_func,
                    void *authz_read_baton,
+                   svn_repos__log_index_t *log_index,
                    apr_pool_t *pool)
 {
   svn_fs_root_t *root;
@@ -1442,8 +1620,35 @@ get_path_histories(apr_array_header_t **histories,
       info->done = FALSE;
       info->history_rev = hist_end;
       info->first_time = TRUE;
+      info->locations = NULL;
+      info->next_location = 0;
 
-      if (i < MAX_OPEN_HISTORIES)
+      if (log_index)
+        {
+          svn_fs_history_t *hist;
+
+          /* Reject bogus locations just like the history walk would. */
+          err = svn_fs_node_history2(&hist, root, this_path, iterpool,
+                                     iterpool);
+          if (!err)
+            err = svn_repos__log_index_get_history(&info->locations,
+                                                   log_index, this_path,
+                                                   hist_start, hist_end,
+                                                   strict_node_history,
+                                                   pool, iterpool);
+          if (err
+              && ignore_missing_locations
+              && (err->apr_err == SVN_ERR_FS_NOT_FOUND ||
+                  err->apr_err == SVN_ERR_FS_NOT_DIRECTORY ||
+                  err->apr_err == SVN_ERR_FS_NO_SUCH_REVISION))
+            {
+              svn_error_clear(err);
+              continue;
+            }
+          SVN_ERR(err);
+        }
+
+      if (!info->locations && i < MAX_OPEN_HISTORIES)
         {
           err = svn_fs_node_history2(&info->hist, root, this_path, pool,
                                      iterpool);
@@ -1935,10 +2140,212 @@ store_search(svn_mergeinfo_t processed,
   return SVN_NO_ERROR;
 }
 
+/* Return TRUE if all HISTORIES have been taken from the changed-paths
+   index, i.e. if we know their full location lists up front. */
+static svn_boolean_t
+all_histories_indexed(const apr_array_header_t *histories)
+{
+  int i;
+
+  for (i = 0; i < histories->nelts; ++i)
+    if (!APR_ARRAY_IDX(histories, i, struct path_info *)->locations)
+      return FALSE;
+
+  return TRUE;
+}
+
+/* For the index-based history INFO as returned by get_path_histories,
+   return in *COUNT the number of leading entries in INFO->LOCATIONS that
+   the descending history walk in do_logs would report.  That is, stop at
+   the first location older than START or that is not readable according
+   to AUTHZ_READ_FUNC and AUTHZ_READ_BATON.  Use SCRATCH_POOL for
+   temporary allocations. */
+static svn_error_t *
+count_reported_locations(int *count,
+                         const struct path_info *info,
+                         svn_fs_t *fs,
+                         svn_revnum_t start,
+                         svn_repos_authz_func_t authz_read_func,
+                         void *authz_read_baton,
+                         apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool;
+  int i;
+
+  /* get_path_histories already checked the first location. */
+  if (info->done)
+    {
+      *count = 0;
+      return SVN_NO_ERROR;
+    }
+
+  iterpool = svn_pool_create(scratch_pool);
+  for (i = info->next_location; i < info->locations->nelts; ++i)
+    {
+      const svn_repos__log_index_location_t *location
+        = &APR_ARRAY_IDX(info->locations, i,
+                         svn_repos__log_index_location_t);
+
+      svn_pool_clear(iterpool);
+      if (location->revision < start)
+        break;
+
+      if (authz_read_func)
+        {
+          svn_boolean_t readable;
+          svn_fs_root_t *history_root;
+
+          SVN_ERR(svn_fs_revision_root(&history_root, fs,
+                                       location->revision, iterpool));
+          SVN_ERR(authz_read_func(&readable, history_root, location->path,
+                                  authz_read_baton, iterpool));
+          if (! readable)
+            break;
+        }
+    }
+  svn_pool_destroy(iterpool);
+
+  *count = i;
+  return SVN_NO_ERROR;
+}
+
+/* Send the logs for the index-based HISTORIES in FS from oldest to
+   youngest, without collecting the list of revisions first.  HIST_START,
+   LIMIT, REVPROPS and CALLBACKS are the same as for do_logs.  Use POOL
+   for temporary allocations.
+
+   The location lists are already in memory, so we simply merge them
+   backwards, i.e. we report exactly the revisions that the descending
+   history walk would - just in reverse order. */
+static svn_error_t *
+send_indexed_logs_ascending(svn_fs_t *fs,
+                            const apr_array_header_t *histories,
+                            svn_revnum_t hist_start,
+                            int limit,
+                            const apr_array_header_t *revprops,
+                            log_callbacks_t *callbacks,
+                            apr_pool_t *pool)
+{
+  /* For each history, the index of the next location to report.
+     They count down to -1. */
+  int *next = apr_palloc(pool, histories->nelts * sizeof(*next));
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  int send_count = 0;
+  int i;
+
+  for (i = 0; i < histories->nelts; ++i)
+    {
+      const struct path_info *info = APR_ARRAY_IDX(histories, i,
+                                                   struct path_info *);
+      int count;
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(count_reported_locations(&count, info, fs, hist_start,
+                                       callbacks->authz_read_func,
+                                       callbacks->authz_read_baton,
+                                       iterpool));
+      next[i] = count - 1;
+    }
+
+  while (!limit || send_count < limit)
+    {
+      svn_revnum_t current = SVN_INVALID_REVNUM;
+
+      /* Find the oldest revision not reported yet. */
+      for (i = 0; i < histories->nelts; ++i)
+        if (next[i] >= 0)
+          {
+            const struct path_info *info = APR_ARRAY_IDX(histories, i,
+                                                         struct path_info *);
+            svn_revnum_t rev
+              = APR_ARRAY_IDX(info->locations, next[i],
+                              svn_repos__log_index_location_t).revision;
+
+            if (!SVN_IS_VALID_REVNUM(current) || rev < current)
+              current = rev;
+          }
+
+      if (!SVN_IS_VALID_REVNUM(current))
+        break;
+
+      /* Several paths may have changed in that revision. */
+      for (i = 0; i < histories->nelts; ++i)
+        if (next[i] >= 0)
+          {
+            const struct path_info *info = APR_ARRAY_IDX(histories, i,
+                                                         struct path_info *);
+            if (APR_ARRAY_IDX(info->locations, next[i],
+                              svn_repos__log_index_location_t).revision
+                == current)
+              --next[i];
+          }
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(send_log(current, fs, NULL, NULL, FALSE, FALSE, revprops,
+                       FALSE, callbacks, iterpool));
+      ++send_count;
+    }
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* In the list of REVS, found from youngest to oldest, and the associated
+   REV_MERGEINFO (may be NULL), keep only the KEEP oldest revisions.
+   Move the remaining mergeinfo to a new pool allocated in PARENT_POOL and
+   destroy the old one in *MERGEINFO_POOL in the process. */
+static void
+drop_youngest_revs(apr_array_header_t *revs,
+                   apr_hash_t **rev_mergeinfo,
+                   apr_pool_t **mergeinfo_pool,
+                   int keep,
+                   apr_pool_t *parent_pool)
+{
+  int drop = revs->nelts - keep;
+  int i;
+
+  memmove(revs->elts, revs->elts + drop * revs->elt_size,
+          keep * revs->elt_size);
+  revs->nelts = keep;
+
+  if (*rev_mergeinfo)
+    {
+      apr_pool_t *new_pool = svn_pool_create(parent_pool);
+      apr_hash_t *new_mergeinfo = svn_hash__make(new_pool);
+
+      for (i = 0; i < revs->nelts; ++i)
+        {
+          svn_revnum_t *rev = &APR_ARRAY_IDX(revs, i, svn_revnum_t);
+          struct added_deleted_mergeinfo *old
+            = apr_hash_get(*rev_mergeinfo, rev, sizeof(*rev));
+
+          if (old)
+            {
+              struct added_deleted_mergeinfo *add_and_del_mergeinfo
+                = apr_palloc(new_pool, sizeof(*add_and_del_mergeinfo));
+
+              add_and_del_mergeinfo->added_mergeinfo
+                = svn_mergeinfo_dup(old->added_mergeinfo, new_pool);
+              add_and_del_mergeinfo->deleted_mergeinfo
+                = svn_mergeinfo_dup(old->deleted_mergeinfo, new_pool);
+              apr_hash_set(new_mergeinfo,
+                           apr_pmemdup(new_pool, rev, sizeof(*rev)),
+                           sizeof(*rev), add_and_del_mergeinfo);
+            }
+        }
+
+      svn_pool_destroy(*mergeinfo_pool);
+      *mergeinfo_pool = new_pool;
+      *rev_mergeinfo = new_mergeinfo;
+    }
+}
+
 /* Find logs for PATHS from HIST_START to HIST_END in FS, and invoke the
    CALLBACKS on them.  If DESCENDING_ORDER is TRUE, send the logs back as
-   we find them, else buffer the logs and send them back in youngest->oldest
-   order.
+   we find them, else send them back in oldest->youngest order.  The latter
+   is done without buffering if the changed-paths index provided all path
+   histories.  Otherwise, we buffer the revisions but only the LIMIT oldest
+   ones if LIMIT is not 0.
 
    If IGNORE_MISSING_LOCATIONS is set, don't treat requests for bogus
    repository locations as fatal -- just ignore them.
@@ -1986,11 +2393,12 @@ do_logs(svn_fs_t *fs,
 {
   apr_pool_t *iterpool, *iterpool2;
   apr_pool_t *subpool = NULL;
+  apr_pool_t *mergeinfo_pool = NULL;
   apr_array_header_t *revs = NULL;
   apr_hash_t *rev_mergeinfo = NULL;
   svn_revnum_t current;
   apr_array_header_t *histories;
-  svn_boolean_t any_histories_left = TRUE;
+  svn_priority_queue__t *queue;
   int send_count = 0;
   int i;
 
@@ -2015,138 +2423,145 @@ do_logs(svn_fs_t *fs,
   SVN_ERR(get_path_histories(&histories, fs, paths, hist_start, hist_end,
                              strict_node_history, ignore_missing_locations,
                              callbacks->authz_read_func,
-                             callbacks->authz_read_baton, pool));
+                             callbacks->authz_read_baton,
+                             callbacks->log_index, pool));
+
+  /* Without merged revisions, ascending logs can be streamed if we know
+     all path histories already. */
+  if (   !descending_order
+      && !include_merged_revisions
+      && all_histories_indexed(histories))
+    return svn_error_trace(send_indexed_logs_ascending(fs, histories,
+                                                       hist_start, limit,
+                                                       revprops, callbacks,
+                                                       pool));
 
   /* Loop through all the revisions in the range and add any
      where a path was changed to the array, or if they wanted
      history in reverse order just send it to them right away. */
+  queue = make_history_queue(histories, pool);
   iterpool = svn_pool_create(pool);
   iterpool2 = svn_pool_create(pool);
-  for (current = hist_end;
-       any_histories_left;
-       current = next_history_rev(histories))
+  while (svn_priority_queue__size(queue))
     {
-      svn_boolean_t changed = FALSE;
-      any_histories_left = FALSE;
+      svn_mergeinfo_t added_mergeinfo = NULL;
+      svn_mergeinfo_t deleted_mergeinfo = NULL;
+      svn_boolean_t has_children = FALSE;
+
       svn_pool_clear(iterpool);
+      svn_pool_clear(iterpool2);
 
-      for (i = 0; i < histories->nelts; i++)
+      /* Advance all paths that changed in the youngest revision left. */
+      SVN_ERR(next_history_rev(&current, queue, fs, strict_node_history,
+                               callbacks->authz_read_func,
+                               callbacks->authz_read_baton,
+                               hist_start, pool, iterpool2));
+
+      /* If we're including merged revisions, we need to calculate
+         the mergeinfo deltas committed in this revision to our
+         various paths. */
+      if (include_merged_revisions)
         {
-          struct path_info *info = APR_ARRAY_IDX(histories, i,
-                                                 struct path_info *);
-
-          svn_pool_clear(iterpool2);
-
-          /* Check history for this path in current rev. */
-          SVN_ERR(check_history(&changed, info, fs, current,
-                                strict_node_history,
-                                callbacks->authz_read_func,
-                                callbacks->authz_read_baton,
-                                hist_start, pool, iterpool2));
-          if (! info->done)
-            any_histories_left = TRUE;
-        }
+          apr_array_header_t *cur_paths =
+            apr_array_make(iterpool, paths->nelts, sizeof(const char *));
 
-      svn_pool_clear(iterpool2);
+          /* Get the current paths of our history objects so we can
+             query mergeinfo. */
+          /* ### TODO: Should this be ignoring depleted history items? */
+          for (i = 0; i < histories->nelts; i++)
+            {
+              struct path_info *info = APR_ARRAY_IDX(histories, i,
+                                                     struct path_info *);
+              APR_ARRAY_PUSH(cur_paths, const char *) = info->path->data;
+            }
+          SVN_ERR(get_combined_mergeinfo_changes(&added_mergeinfo,
+                                                 &deleted_mergeinfo,
+                                                 fs, cur_paths,
+                                                 current,
+                                                 callbacks->log_index,
+                                                 iterpool, iterpool));
+          has_children = (apr_hash_count(added_mergeinfo) > 0
+                          || apr_hash_count(deleted_mergeinfo) > 0);
+        }
 
-      /* If any of the paths changed in this rev then add or send it. */
-      if (changed)
+      /* If our caller wants logs in descending order, we can send
+         'em now (because that's the order we're crawling history
+         in anyway). */
+      if (descending_order)
         {
-          svn_mergeinfo_t added_mergeinfo = NULL;
-          svn_mergeinfo_t deleted_mergeinfo = NULL;
-          svn_boolean_t has_children = FALSE;
+          SVN_ERR(send_log(current, fs,
+                           log_target_history_as_mergeinfo, nested_merges,
+                           subtractive_merge, handling_merged_revisions,
+                           revprops, has_children, callbacks, iterpool));
 
-          /* If we're including merged revisions, we need to calculate
-             the mergeinfo deltas committed in this revision to our
-             various paths. */
-          if (include_merged_revisions)
+          if (has_children) /* Implies include_merged_revisions == TRUE */
             {
-              apr_array_header_t *cur_paths =
-                apr_array_make(iterpool, paths->nelts, sizeof(const char *));
-
-              /* Get the current paths of our history objects so we can
-                 query mergeinfo. */
-              /* ### TODO: Should this be ignoring depleted history items? */
-              for (i = 0; i < histories->nelts; i++)
+              if (!nested_merges)
                 {
-                  struct path_info *info = APR_ARRAY_IDX(histories, i,
-                                                         struct path_info *);
-                  APR_ARRAY_PUSH(cur_paths, const char *) = info->path->data;
+                  /* We're at the start of the recursion stack, create a
+                     single hash to be shared across all of the merged
+                     recursions so we can track and squelch duplicates. */
+                  subpool = svn_pool_create(pool);
+                  nested_merges = svn_bit_array__create(hist_end, subpool);
+                  processed = svn_hash__make(subpool);
                 }
-              SVN_ERR(get_combined_mergeinfo_changes(&added_mergeinfo,
-                                                     &deleted_mergeinfo,
-                                                     fs, cur_paths,
-                                                     current,
-                                                     iterpool, iterpool));
-              has_children = (apr_hash_count(added_mergeinfo) > 0
-                              || apr_hash_count(deleted_mergeinfo) > 0);
+
+              SVN_ERR(handle_merged_revisions(
+                current, fs,
+                log_target_history_as_mergeinfo, nested_merges,
+                processed,
+                added_mergeinfo, deleted_mergeinfo,
+                strict_node_history,
+                revprops,
+                callbacks,
+                iterpool));
             }
+          if (limit && ++send_count >= limit)
+            break;
+        }
+      /* Otherwise, the caller wanted logs in ascending order, so
+         we have to buffer up a list of revs and (if doing
+         mergeinfo) a hash of related mergeinfo deltas, and
+         process them later. */
+      else
+        {
+          if (! revs)
+            revs = apr_array_make(pool, 64, sizeof(svn_revnum_t));
+          APR_ARRAY_PUSH(revs, svn_revnum_t) = current;
 
-          /* If our caller wants logs in descending order, we can send
-             'em now (because that's the order we're crawling history
-             in anyway). */
-          if (descending_order)
+          if (added_mergeinfo || deleted_mergeinfo)
             {
-              SVN_ERR(send_log(current, fs,
-                               log_target_history_as_mergeinfo, nested_merges,
-                               subtractive_merge, handling_merged_revisions,
-                               revprops, has_children, callbacks, iterpool));
+              svn_revnum_t *cur_rev;
+              struct added_deleted_mergeinfo *add_and_del_mergeinfo;
 
-              if (has_children) /* Implies include_merged_revisions == TRUE */
+              if (! rev_mergeinfo)
                 {
-                  if (!nested_merges)
-                    {
-                      /* We're at the start of the recursion stack, create a
-                         single hash to be shared across all of the merged
-                         recursions so we can track and squelch duplicates. */
-                      subpool = svn_pool_create(pool);
-                      nested_merges = svn_bit_array__create(hist_end, subpool);
-                      processed = svn_hash__make(subpool);
-                    }
-
-                  SVN_ERR(handle_merged_revisions(
-                    current, fs,
-                    log_target_history_as_mergeinfo, nested_merges,
-                    processed,
-                    added_mergeinfo, deleted_mergeinfo,
-                    strict_node_history,
-                    revprops,
-                    callbacks,
-                    iterpool));
+                  mergeinfo_pool = svn_pool_create(pool);
+                  rev_mergeinfo = svn_hash__make(mergeinfo_pool);
                 }
-              if (limit && ++send_count >= limit)
-                break;
-            }
-          /* Otherwise, the caller wanted logs in ascending order, so
-             we have to buffer up a list of revs and (if doing
-             mergeinfo) a hash of related mergeinfo deltas, and
-             process them later. */
-          else
-            {
-              if (! revs)
-                revs = apr_array_make(pool, 64, sizeof(svn_revnum_t));
-              APR_ARRAY_PUSH(revs, svn_revnum_t) = current;
 
-              if (added_mergeinfo || deleted_mergeinfo)
-                {
-                  svn_revnum_t *cur_rev =
-                    apr_pmemdup(pool, &current, sizeof(*cur_rev));
-                  struct added_deleted_mergeinfo *add_and_del_mergeinfo =
-                    apr_palloc(pool, sizeof(*add_and_del_mergeinfo));
-
-                  /* If we have added or deleted mergeinfo, both are non-null */
-                  SVN_ERR_ASSERT(added_mergeinfo && deleted_mergeinfo);
-                  add_and_del_mergeinfo->added_mergeinfo =
-                    svn_mergeinfo_dup(added_mergeinfo, pool);
-                  add_and_del_mergeinfo->deleted_mergeinfo =
-                    svn_mergeinfo_dup(deleted_mergeinfo, pool);
-
-                  if (! rev_mergeinfo)
-                    rev_mergeinfo = svn_hash__make(pool);
-                  apr_hash_set(rev_mergeinfo, cur_rev, sizeof(*cur_rev),
-                               add_and_del_mergeinfo);
-                }
+              cur_rev = apr_pmemdup(mergeinfo_pool, &current,
+                                    sizeof(*cur_rev));
+              add_and_del_mergeinfo
+                = apr_palloc(mergeinfo_pool,
+                             sizeof(*add_and_del_mergeinfo));
+
+              /* If we have added or deleted mergeinfo, both are non-null */
+              SVN_ERR_ASSERT(added_mergeinfo && deleted_mergeinfo);
+              add_and_del_mergeinfo->added_mergeinfo =
+                svn_mergeinfo_dup(added_mergeinfo, mergeinfo_pool);
+              add_and_del_mergeinfo->deleted_mergeinfo =
+                svn_mergeinfo_dup(deleted_mergeinfo, mergeinfo_pool);
+
+              apr_hash_set(rev_mergeinfo, cur_rev, sizeof(*cur_rev),
+                           add_and_del_mergeinfo);
             }
+
+          /* We will only send the LIMIT oldest revisions, so there is
+             no need to remember the younger ones. */
+          if (limit && revs->nelts >= 2 * limit)
+            drop_youngest_revs(revs, &rev_mergeinfo, &mergeinfo_pool,
+                               limit, pool);
         }
     }
   svn_pool_destroy(iterpool2);
@@ -2332,6 +2747,8 @@ svn_repos_get_logs5(svn_repos_t *repos,
   callbacks.revision_receiver_baton = revision_receiver_baton;
   callbacks.authz_read_func = authz_read_func;
   callbacks.authz_read_baton = authz_read_baton;
+  callbacks.log_index = NULL;
+  callbacks.changes = NULL;
 
   if (revprops)
     {
@@ -2424,19 +2841,41 @@ svn_repos_get_logs5(svn_repos_t *repos,
       send_count = end - start + 1;
       if (limit > 0 && send_count > limit)
         send_count = limit;
-      for (i = 0; i < send_count; ++i)
+
+      /* If we need the changed paths of every revision, let the FS
+         fetch them in as few passes as possible. */
+      if (authz_read_func || path_change_receiver)
+        {
+          send_logs_baton_t baton;
+          svn_revnum_t first = descending_order ? end : start;
+          svn_revnum_t last = descending_order
+                            ? end - (svn_revnum_t)send_count + 1
+                            : start + (svn_revnum_t)send_count - 1;
+
+          baton.fs = fs;
+          baton.revprops = revprops;
+          baton.callbacks = &callbacks;
+
+          SVN_ERR(svn_fs_paths_changed_range(fs, first, last,
+                                             send_log_with_changes, &baton,
+                                             NULL, NULL, iterpool));
+        }
+      else
         {
-          svn_revnum_t rev;
+          for (i = 0; i < send_count; ++i)
+            {
+              svn_revnum_t rev;
 
-          svn_pool_clear(iterpool);
+              svn_pool_clear(iterpool);
 
-          if (descending_order)
-            rev = end - i;
-          else
-            rev = start + i;
-          SVN_ERR(send_log(rev, fs, NULL, NULL,
-                           FALSE, FALSE, revprops, FALSE,
-                           &callbacks, iterpool));
+              if (descending_order)
+                rev = end - i;
+              else
+                rev = start + i;
+              SVN_ERR(send_log(rev, fs, NULL, NULL,
+                               FALSE, FALSE, revprops, FALSE,
+                               &callbacks, iterpool));
+            }
         }
       svn_pool_destroy(iterpool);
 
@@ -2460,6 +2899,10 @@ svn_repos_get_logs5(svn_repos_t *repos,
       svn_pool_destroy(subpool);
     }
 
+  /* Only an index that knows about HEAD can replace the history walk. */
+  SVN_ERR(svn_repos__log_index_open(&callbacks.log_index, repos, head,
+                                    scratch_pool, scratch_pool));
+
   return do_logs(repos->fs, paths, paths_history_mergeinfo, NULL, NULL,
                  start, end, limit, strict_node_history,
                  include_merged_revisions, FALSE, FALSE, FALSE,
@@ -0,0 +1,1133 @@
+/* log_index.c --- the changed-paths index that speeds up svn log
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include "svn_dirent_uri.h"
+#include "svn_fs.h"
+#include "svn_hash.h"
+#include "svn_mergeinfo.h"
+#include "svn_pools.h"
+#include "svn_props.h"
+#include "svn_repos.h"
+#include "svn_sorts.h"
+
+#include "private/svn_fspath.h"
+#include "private/svn_mergeinfo_private.h"
+#include "private/svn_sorts_private.h"
+#include "private/svn_sqlite.h"
+#include "private/svn_string_private.h"
+#include "private/svn_subr_private.h"
+
+#include "svn_private_config.h"
+
+#include "repos.h"
+#include "log-index-db.h"
+
+LOG_INDEX_DB_SQL_DECLARE_STATEMENTS(statements);
+
+
+/* The schema version of the index that we know how to use. */
+#define LOG_INDEX_SCHEMA_VERSION 3
+
+/* Commits catch up with at most that many revisions that are missing
+ * from the index, e.g. because concurrent commits updated it out of
+ * order.  If the index lags further behind, we leave it to
+ * svn_repos_build_log_index() to fill the gap. */
+#define LOG_INDEX_MAX_CATCH_UP 16
+
+struct svn_repos__log_index_t
+{
+  /* The open index database. */
+  svn_sqlite__db_t *sdb;
+
+  /* The youngest revision covered by the index. */
+  svn_revnum_t indexed_rev;
+};
+
+
+/*** Helper functions. ***/
+
+/* Return the path of the changed-paths index of REPOS,
+ * allocated in RESULT_POOL. */
+static const char *
+log_index_path(svn_repos_t *repos,
+               apr_pool_t *result_pool)
+{
+  return svn_dirent_join(repos->db_path, SVN_REPOS__LOG_INDEX, result_pool);
+}
+
+/* Open the index database of REPOS in *SDB, allocated in RESULT_POOL.
+ * If it does not exist, create it when CREATE is set and return NULL
+ * otherwise.  Also return NULL if the index uses a schema that we don't
+ * know.  An index using an older schema is discarded and recreated when
+ * CREATE is set.  Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+open_index_db(svn_sqlite__db_t **sdb,
+              svn_repos_t *repos,
+              svn_boolean_t create,
+              apr_pool_t *result_pool,
+              apr_pool_t *scratch_pool)
+{
+  const char *db_path = log_index_path(repos, scratch_pool);
+  svn_node_kind_t kind;
+  int version;
+
+  *sdb = NULL;
+
+  SVN_ERR(svn_io_check_path(db_path, &kind, scratch_pool));
+  if (kind == svn_node_none && !create)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_sqlite__open(sdb, db_path,
+                           svn_sqlite__mode_rwcreate, statements,
+                           0, NULL, 0,
+                           result_pool, scratch_pool));
+
+  SVN_SQLITE__ERR_CLOSE(svn_sqlite__read_schema_version(&version, *sdb,
+                                                        scratch_pool),
+                        *sdb);
+
+  /* If we have an uninitialized database, go ahead and create the schema. */
+  if (version <= 0)
+    {
+      SVN_SQLITE__ERR_CLOSE(svn_sqlite__exec_statements(*sdb,
+                                                        STMT_CREATE_SCHEMA),
+                            *sdb);
+    }
+  else if (version != LOG_INDEX_SCHEMA_VERSION)
+    {
+      SVN_ERR(svn_sqlite__close(*sdb));
+      *sdb = NULL;
+
+      /* Older indexes lack data that we need, so start afresh. */
+      if (create && version < LOG_INDEX_SCHEMA_VERSION)
+        {
+          SVN_ERR(svn_io_remove_file2(db_path, FALSE, scratch_pool));
+          return svn_error_trace(open_index_db(sdb, repos, create,
+                                               result_pool, scratch_pool));
+        }
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *REVISION to the youngest revision recorded in SDB. */
+static svn_error_t *
+get_indexed_rev(svn_revnum_t *revision,
+                svn_sqlite__db_t *sdb)
+{
+  svn_sqlite__stmt_t *stmt;
+  svn_boolean_t have_row;
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, sdb, STMT_GET_INDEXED_REV));
+  SVN_ERR(svn_sqlite__step(&have_row, stmt));
+  *revision = have_row ? svn_sqlite__column_revnum(stmt, 0)
+                       : SVN_INVALID_REVNUM;
+
+  return svn_error_trace(svn_sqlite__reset(stmt));
+}
+
+/* Set *VALUE to the svn:mergeinfo of FSPATH as of REVISION as recorded
+ * in SDB, allocated in RESULT_POOL.  Set it to NULL if there is none. */
+static svn_error_t *
+get_mergeinfo_value(const char **value,
+                    svn_sqlite__db_t *sdb,
+                    const char *fspath,
+                    svn_revnum_t revision,
+                    apr_pool_t *result_pool)
+{
+  svn_sqlite__stmt_t *stmt;
+  svn_boolean_t have_row;
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, sdb, STMT_SELECT_MERGEINFO));
+  SVN_ERR(svn_sqlite__bindf(stmt, "sr", fspath, revision));
+  SVN_ERR(svn_sqlite__step(&have_row, stmt));
+  *value = have_row ? svn_sqlite__column_text(stmt, 0, result_pool) : NULL;
+
+  return svn_error_trace(svn_sqlite__reset(stmt));
+}
+
+/* Set *PATHS and *VALUES to matching arrays of the const char * paths
+ * of all strict descendants of FSPATH that have svn:mergeinfo as of
+ * REVISION in SDB and the respective values.  Allocate the results in
+ * RESULT_POOL and use SCRATCH_POOL for temporaries. */
+static svn_error_t *
+get_descendant_mergeinfo_values(apr_array_header_t **paths,
+                                apr_array_header_t **values,
+                                svn_sqlite__db_t *sdb,
+                                const char *fspath,
+                                svn_revnum_t revision,
+                                apr_pool_t *result_pool,
+                                apr_pool_t *scratch_pool)
+{
+  svn_sqlite__stmt_t *stmt;
+  svn_boolean_t have_row;
+  const char *lower, *upper;
+
+  /* All descendants sort between FSPATH/ and FSPATH0. */
+  if (svn_fspath__is_root(fspath, strlen(fspath)))
+    {
+      lower = "/";
+      upper = "0";
+    }
+  else
+    {
+      lower = apr_pstrcat(scratch_pool, fspath, "/", SVN_VA_NULL);
+      upper = apr_pstrcat(scratch_pool, fspath, "0", SVN_VA_NULL);
+    }
+
+  *paths = apr_array_make(result_pool, 0, sizeof(const char *));
+  *values = apr_array_make(result_pool, 0, sizeof(const char *));
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, sdb,
+                                    STMT_SELECT_MERGEINFO_IN_RANGE));
+  SVN_ERR(svn_sqlite__bindf(stmt, "ssr", lower, upper, revision));
+  SVN_ERR(svn_sqlite__step(&have_row, stmt));
+  while (have_row)
+    {
+      APR_ARRAY_PUSH(*paths, const char *)
+        = svn_sqlite__column_text(stmt, 0, result_pool);
+      APR_ARRAY_PUSH(*values, const char *)
+        = svn_sqlite__column_text(stmt, 1, result_pool);
+
+      SVN_ERR(svn_sqlite__step(&have_row, stmt));
+    }
+
+  return svn_error_trace(svn_sqlite__reset(stmt));
+}
+
+/* Record VALUE as the svn:mergeinfo of FSPATH in REVISION in SDB.
+ * A NULL VALUE means that there is none. */
+static svn_error_t *
+set_mergeinfo_value(svn_sqlite__db_t *sdb,
+                    const char *fspath,
+                    svn_revnum_t revision,
+                    const char *value)
+{
+  svn_sqlite__stmt_t *stmt;
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, sdb, STMT_INSERT_MERGEINFO));
+  SVN_ERR(svn_sqlite__bindf(stmt, "srs", fspath, revision, value));
+
+  return svn_error_trace(svn_sqlite__step_done(stmt));
+}
+
+/* Record in SDB that FSPATH and all of its descendants have no
+ * svn:mergeinfo as of REVISION.  Use SCRATCH_POOL for temporaries. */
+static svn_error_t *
+clear_subtree_mergeinfo(svn_sqlite__db_t *sdb,
+                        const char *fspath,
+                        svn_revnum_t revision,
+                        apr_pool_t *scratch_pool)
+{
+  apr_array_header_t *paths, *values;
+  const char *value;
+  int i;
+
+  SVN_ERR(get_mergeinfo_value(&value, sdb, fspath, revision, scratch_pool));
+  if (value)
+    SVN_ERR(set_mergeinfo_value(sdb, fspath, revision, NULL));
+
+  SVN_ERR(get_descendant_mergeinfo_values(&paths, &values, sdb, fspath,
+                                          revision, scratch_pool,
+                                          scratch_pool));
+  for (i = 0; i < paths->nelts; ++i)
+    SVN_ERR(set_mergeinfo_value(sdb, APR_ARRAY_IDX(paths, i, const char *),
+                                revision, NULL));
+
+  return SVN_NO_ERROR;
+}
+
+/* Record in SDB the svn:mergeinfo that the sub-tree at FSPATH in
+ * REVISION inherited from its copy source COPYFROM_PATH@COPYFROM_REV.
+ * Use SCRATCH_POOL for temporaries. */
+static svn_error_t *
+copy_subtree_mergeinfo(svn_sqlite__db_t *sdb,
+                       const char *fspath,
+                       svn_revnum_t revision,
+                       const char *copyfrom_path,
+                       svn_revnum_t copyfrom_rev,
+                       apr_pool_t *scratch_pool)
+{
+  apr_array_header_t *paths, *values;
+  const char *value;
+  int i;
+
+  SVN_ERR(get_mergeinfo_value(&value, sdb, copyfrom_path, copyfrom_rev,
+                              scratch_pool));
+  if (value)
+    SVN_ERR(set_mergeinfo_value(sdb, fspath, revision, value));
+
+  SVN_ERR(get_descendant_mergeinfo_values(&paths, &values, sdb,
+                                          copyfrom_path, copyfrom_rev,
+                                          scratch_pool, scratch_pool));
+  for (i = 0; i < paths->nelts; ++i)
+    {
+      const char *relpath
+        = svn_fspath__skip_ancestor(copyfrom_path,
+                                    APR_ARRAY_IDX(paths, i, const char *));
+
+      SVN_ERR(set_mergeinfo_value(sdb,
+                                  svn_fspath__join(fspath, relpath,
+                                                   scratch_pool),
+                                  revision,
+                                  APR_ARRAY_IDX(values, i, const char *)));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *NORMALIZED to the normalized form of the svn:mergeinfo property
+ * VALUE, allocated in RESULT_POOL. */
+static svn_error_t *
+normalize_mergeinfo(const char **normalized,
+                    const svn_string_t *value,
+                    apr_pool_t *result_pool)
+{
+  svn_mergeinfo_t mergeinfo;
+  svn_string_t *mergeinfo_string;
+  svn_error_t *err;
+
+  err = svn_mergeinfo_parse(&mergeinfo, value->data, result_pool);
+  if (err && err->apr_err == SVN_ERR_MERGEINFO_PARSE_ERROR)
+    {
+      /* Issue #3896: Keep invalid mergeinfo as it is.  Readers will then
+         treat it like the FS does: present but without any ranges. */
+      svn_error_clear(err);
+      *normalized = value->data;
+      return SVN_NO_ERROR;
+    }
+  SVN_ERR(err);
+
+  SVN_ERR(svn_mergeinfo_to_string(&mergeinfo_string, mergeinfo,
+                                  result_pool));
+  *normalized = mergeinfo_string->data;
+
+  return SVN_NO_ERROR;
+}
+
+/* A change that may affect the svn:mergeinfo recorded for a sub-tree. */
+typedef struct mergeinfo_change_t
+{
+  /* The changed path. */
+  const char *path;
+
+  /* How it changed. */
+  svn_fs_path_change_kind_t change_kind;
+
+  /* Copy source, if PATH got copied.  NULL / SVN_INVALID_REVNUM if not. */
+  const char *copyfrom_path;
+  svn_revnum_t copyfrom_rev;
+
+  /* Whether the svn:mergeinfo on PATH itself may have been modified. */
+  svn_boolean_t mergeinfo_mod;
+} mergeinfo_change_t;
+
+/* Sort mergeinfo_change_t elements by path, parents before their
+ * children.  Implements the qsort() comparison function interface. */
+static int
+compare_mergeinfo_changes(const void *lhs,
+                          const void *rhs)
+{
+  const mergeinfo_change_t *lhs_change = lhs;
+  const mergeinfo_change_t *rhs_change = rhs;
+
+  return strcmp(lhs_change->path, rhs_change->path);
+}
+
+/* Sort svn_prefix_string__t * elements.  Implements the qsort() comparison
+ * function interface. */
+static int
+compare_prefix_strings(const void *lhs,
+                       const void *rhs)
+{
+  return svn_prefix_string__compare(*(svn_prefix_string__t * const *)lhs,
+                                    *(svn_prefix_string__t * const *)rhs);
+}
+
+/* Add the changes of REVISION in FS to SDB, provided that SDB covers
+ * all older revisions.  Set *ADDED to TRUE if REVISION got added and to
+ * FALSE if SDB already contained it or lags further behind.  Use
+ * SCRATCH_POOL for temporary allocations.
+ *
+ * The caller must run this within a write transaction. */
+static svn_error_t *
+index_revision(svn_boolean_t *added,
+               svn_sqlite__db_t *sdb,
+               svn_fs_t *fs,
+               svn_revnum_t revision,
+               apr_pool_t *scratch_pool)
+{
+  svn_revnum_t indexed_rev;
+  svn_fs_root_t *root;
+  svn_fs_path_change_iterator_t *iterator;
+  svn_fs_path_change3_t *change;
+  svn_sqlite__stmt_t *stmt;
+  svn_prefix_tree__t *tree = svn_prefix_tree__create(scratch_pool);
+  apr_hash_t *seen = svn_hash__make(scratch_pool);
+  apr_array_header_t *paths
+    = apr_array_make(scratch_pool, 16, sizeof(svn_prefix_string__t *));
+  apr_array_header_t *mergeinfo_changes
+    = apr_array_make(scratch_pool, 16, sizeof(mergeinfo_change_t));
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  int i;
+
+  /* Re-read the progress now that we hold the write lock. */
+  SVN_ERR(get_indexed_rev(&indexed_rev, sdb));
+  *added = (indexed_rev == revision - 1);
+  if (!*added)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_fs_revision_root(&root, fs, revision, scratch_pool));
+  SVN_ERR(svn_fs_paths_changed3(&iterator, root, scratch_pool, scratch_pool));
+  SVN_ERR(svn_fs_path_change_get(&change, iterator));
+
+  while (change)
+    {
+      char *path;
+      apr_size_t len = change->path.len;
+      svn_revnum_t copyfrom_rev = SVN_INVALID_REVNUM;
+      const char *copyfrom_path = NULL;
+
+      svn_pool_clear(iterpool);
+      path = apr_pstrmemdup(iterpool, change->path.data, len);
+
+      /* A node's history starts where it got added. */
+      if (   change->change_kind == svn_fs_path_change_add
+          || change->change_kind == svn_fs_path_change_replace)
+        {
+          copyfrom_rev = change->copyfrom_rev;
+          copyfrom_path = change->copyfrom_path;
+
+          if (!change->copyfrom_known)
+            SVN_ERR(svn_fs_copied_from(&copyfrom_rev, &copyfrom_path,
+                                       root, path, iterpool));
+
+          if (SVN_IS_VALID_REVNUM(copyfrom_rev))
+            copyfrom_path = apr_pstrdup(scratch_pool, copyfrom_path);
+          else
+            copyfrom_path = NULL;
+
+          SVN_ERR(svn_sqlite__get_statement(&stmt, sdb, STMT_INSERT_ORIGIN));
+          SVN_ERR(svn_sqlite__bindf(stmt, "srsr", path, revision,
+                                    copyfrom_path, copyfrom_rev));
+          SVN_ERR(svn_sqlite__step_done(stmt));
+        }
+
+      /* Remember anything that may change the mergeinfo in a sub-tree. */
+      if (   change->change_kind == svn_fs_path_change_delete
+          || copyfrom_path
+          || (change->prop_mod
+              && change->mergeinfo_mod != svn_tristate_false))
+        {
+          mergeinfo_change_t *mergeinfo_change
+            = apr_array_push(mergeinfo_changes);
+
+          mergeinfo_change->path = apr_pstrmemdup(scratch_pool, path, len);
+          mergeinfo_change->change_kind = change->change_kind;
+          mergeinfo_change->copyfrom_path = copyfrom_path;
+          mergeinfo_change->copyfrom_rev = copyfrom_rev;
+          mergeinfo_change->mergeinfo_mod
+            = change->prop_mod && change->mergeinfo_mod != svn_tristate_false;
+        }
+
+      /* Every change bubbles up to the root.  Large revisions touch many
+         paths in the same few directories, so intern them instead of
+         keeping a full copy of each.  Equal paths share the same interned
+         string, i.e. we only need to compare pointers. */
+      while (TRUE)
+        {
+          svn_prefix_string__t *interned
+            = svn_prefix_string__create(tree, path);
+          svn_prefix_string__t **key;
+
+          if (apr_hash_get(seen, &interned, sizeof(interned)))
+            break;
+
+          key = apr_palloc(scratch_pool, sizeof(*key));
+          *key = interned;
+          apr_hash_set(seen, key, sizeof(*key), key);
+          APR_ARRAY_PUSH(paths, svn_prefix_string__t *) = interned;
+
+          if (svn_fspath__is_root(path, len))
+            break;
+
+          /* Chop off the last segment in-place. */
+          while (len > 1 && path[len - 1] != '/')
+            --len;
+          if (len > 1)
+            --len;
+          path[len] = '\0';
+        }
+
+      SVN_ERR(svn_fs_path_change_get(&change, iterator));
+    }
+
+  /* Inserting in key order keeps the index updates local. */
+  svn_sort__array(paths, compare_prefix_strings);
+  SVN_ERR(svn_sqlite__get_statement(&stmt, sdb, STMT_INSERT_PATH_REV));
+  for (i = 0; i < paths->nelts; ++i)
+    {
+      svn_prefix_string__t *interned
+        = APR_ARRAY_IDX(paths, i, svn_prefix_string__t *);
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_sqlite__bindf(stmt, "sr",
+                                svn_prefix_string__expand(interned,
+                                                          iterpool)->data,
+                                revision));
+      SVN_ERR(svn_sqlite__step_done(stmt));
+    }
+
+  /* Deletions and copies replace whole sub-trees.  Process parents first,
+     so that changes to their children within the same revision win. */
+  svn_sort__array(mergeinfo_changes, compare_mergeinfo_changes);
+  for (i = 0; i < mergeinfo_changes->nelts; ++i)
+    {
+      const mergeinfo_change_t *mergeinfo_change
+        = &APR_ARRAY_IDX(mergeinfo_changes, i, mergeinfo_change_t);
+
+      svn_pool_clear(iterpool);
+
+      if (   mergeinfo_change->change_kind == svn_fs_path_change_delete
+          || mergeinfo_change->change_kind == svn_fs_path_change_replace)
+        SVN_ERR(clear_subtree_mergeinfo(sdb, mergeinfo_change->path,
+                                        revision, iterpool));
+
+      if (mergeinfo_change->copyfrom_path)
+        SVN_ERR(copy_subtree_mergeinfo(sdb, mergeinfo_change->path, revision,
+                                       mergeinfo_change->copyfrom_path,
+                                       mergeinfo_change->copyfrom_rev,
+                                       iterpool));
+    }
+
+  /* Finally, record the properties that got set explicitly. */
+  for (i = 0; i < mergeinfo_changes->nelts; ++i)
+    {
+      const mergeinfo_change_t *mergeinfo_change
+        = &APR_ARRAY_IDX(mergeinfo_changes, i, mergeinfo_change_t);
+      svn_string_t *value;
+      const char *normalized = NULL;
+
+      if (!mergeinfo_change->mergeinfo_mod)
+        continue;
+
+      svn_pool_clear(iterpool);
+
+      SVN_ERR(svn_fs_node_prop(&value, root, mergeinfo_change->path,
+                               SVN_PROP_MERGEINFO, iterpool));
+      if (value)
+        SVN_ERR(normalize_mergeinfo(&normalized, value, iterpool));
+
+      SVN_ERR(set_mergeinfo_value(sdb, mergeinfo_change->path, revision,
+                                  normalized));
+    }
+  svn_pool_destroy(iterpool);
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, sdb, STMT_SET_INDEXED_REV));
+  SVN_ERR(svn_sqlite__bind_revnum(stmt, 1, revision));
+  SVN_ERR(svn_sqlite__step_done(stmt));
+
+  return SVN_NO_ERROR;
+}
+
+/* Add all revisions of REPOS up to and including REVISION that are not
+ * in SDB yet.  Stop early if the index turns out to lag further behind
+ * than expected.  If not NULL, invoke NOTIFY_FUNC with NOTIFY_BATON for
+ * every revision added and CANCEL_FUNC with CANCEL_BATON between them.
+ * Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+catch_up(svn_sqlite__db_t *sdb,
+         svn_repos_t *repos,
+         svn_revnum_t revision,
+         svn_repos_notify_func_t notify_func,
+         void *notify_baton,
+         svn_cancel_func_t cancel_func,
+         void *cancel_baton,
+         apr_pool_t *scratch_pool)
+{
+  svn_revnum_t indexed_rev;
+  svn_revnum_t rev;
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+
+  SVN_ERR(get_indexed_rev(&indexed_rev, sdb));
+  if (!SVN_IS_VALID_REVNUM(indexed_rev))
+    return SVN_NO_ERROR;
+
+  for (rev = indexed_rev + 1; rev <= revision; ++rev)
+    {
+      svn_boolean_t added;
+
+      svn_pool_clear(iterpool);
+      if (cancel_func)
+        SVN_ERR(cancel_func(cancel_baton));
+
+      SVN_SQLITE__WITH_IMMEDIATE_TXN(index_revision(&added, sdb, repos->fs,
+                                                    rev, iterpool),
+                                     sdb);
+
+      /* Someone else might have been faster.  Start over from wherever
+       * they left the index. */
+      if (!added)
+        {
+          SVN_ERR(get_indexed_rev(&indexed_rev, sdb));
+          if (!SVN_IS_VALID_REVNUM(indexed_rev) || indexed_rev < rev)
+            break;
+
+          rev = indexed_rev;
+          continue;
+        }
+
+      if (notify_func)
+        {
+          svn_repos_notify_t *notify
+            = svn_repos_notify_create(svn_repos_notify_log_index_rev,
+                                      iterpool);
+
+          notify->revision = rev;
+          notify_func(notify_baton, notify, iterpool);
+        }
+    }
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+
+/*** Library-private API's. ***/
+
+svn_error_t *
+svn_repos__log_index_open(svn_repos__log_index_t **index,
+                          svn_repos_t *repos,
+                          svn_revnum_t min_rev,
+                          apr_pool_t *result_pool,
+                          apr_pool_t *scratch_pool)
+{
+  svn_sqlite__db_t *sdb;
+  svn_revnum_t indexed_rev;
+
+  *index = NULL;
+
+  SVN_ERR(open_index_db(&sdb, repos, FALSE, result_pool, scratch_pool));
+  if (!sdb)
+    return SVN_NO_ERROR;
+
+  /* A stale index would hide the latest changes. */
+  SVN_ERR(get_indexed_rev(&indexed_rev, sdb));
+  if (!SVN_IS_VALID_REVNUM(indexed_rev) || indexed_rev < min_rev)
+    return svn_error_trace(svn_sqlite__close(sdb));
+
+  *index = apr_pcalloc(result_pool, sizeof(**index));
+  (*index)->sdb = sdb;
+  (*index)->indexed_rev = indexed_rev;
+
+  return SVN_NO_ERROR;
+}
+
+/* Find the youngest revision <= REVISION in which FSPATH or one of its
+ * parents got added in INDEX.  Return it in *ORIGIN_REV and the path
+ * that got added in *ORIGIN_PATH.  If that path was copied, return the
+ * copy source in *COPYFROM_PATH and *COPYFROM_REV and NULL and
+ * SVN_INVALID_REVNUM otherwise.
+ *
+ * Set *ORIGIN_REV to SVN_INVALID_REVNUM and *ORIGIN_PATH to NULL if no
+ * such revision is known.  Allocate the results in RESULT_POOL and use
+ * SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+find_origin(svn_revnum_t *origin_rev,
+            const char **origin_path,
+            const char **copyfrom_path,
+            svn_revnum_t *copyfrom_rev,
+            svn_repos__log_index_t *index,
+            const char *fspath,
+            svn_revnum_t revision,
+            apr_pool_t *result_pool,
+            apr_pool_t *scratch_pool)
+{
+  svn_sqlite__stmt_t *stmt;
+  const char *path;
+
+  *origin_rev = SVN_INVALID_REVNUM;
+  *origin_path = NULL;
+  *copyfrom_path = NULL;
+  *copyfrom_rev = SVN_INVALID_REVNUM;
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, index->sdb,
+                                    STMT_SELECT_LATEST_ORIGIN));
+
+  /* Deeper paths win in case of a tie, e.g. if a path got replaced
+   * within a copied sub-tree. */
+  for (path = fspath; ; path = svn_fspath__dirname(path, scratch_pool))
+    {
+      svn_boolean_t have_row;
+
+      SVN_ERR(svn_sqlite__bindf(stmt, "sr", path, revision));
+      SVN_ERR(svn_sqlite__step(&have_row, stmt));
+      if (have_row && svn_sqlite__column_revnum(stmt, 0) > *origin_rev)
+        {
+          *origin_rev = svn_sqlite__column_revnum(stmt, 0);
+          *origin_path = apr_pstrdup(result_pool, path);
+          *copyfrom_path = svn_sqlite__column_text(stmt, 1, result_pool);
+          *copyfrom_rev = svn_sqlite__column_revnum(stmt, 2);
+        }
+      SVN_ERR(svn_sqlite__reset(stmt));
+
+      if (svn_fspath__is_root(path, strlen(path)))
+        break;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_repos__log_index_get_history(apr_array_header_t **locations,
+                                 svn_repos__log_index_t *index,
+                                 const char *path,
+                                 svn_revnum_t start,
+                                 svn_revnum_t end,
+                                 svn_boolean_t strict,
+                                 apr_pool_t *result_pool,
+                                 apr_pool_t *scratch_pool)
+{
+  apr_array_header_t *result
+    = apr_array_make(result_pool, 16,
+                     sizeof(svn_repos__log_index_location_t));
+  const char *fspath = svn_fspath__canonicalize(path, result_pool);
+  svn_revnum_t revision = end;
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+
+  *locations = NULL;
+
+  while (revision >= start)
+    {
+      svn_revnum_t origin_rev, copyfrom_rev;
+      const char *origin_path, *copyfrom_path;
+      svn_sqlite__stmt_t *stmt;
+      svn_boolean_t have_row;
+      svn_repos__log_index_location_t *location;
+
+      svn_pool_clear(iterpool);
+
+      SVN_ERR(find_origin(&origin_rev, &origin_path,
+                          &copyfrom_path, &copyfrom_rev,
+                          index, fspath, revision, iterpool, iterpool));
+
+      /* Only the root exists without ever having been added. */
+      if (!SVN_IS_VALID_REVNUM(origin_rev))
+        {
+          if (!svn_fspath__is_root(fspath, strlen(fspath)))
+            {
+              svn_pool_destroy(iterpool);
+              return SVN_NO_ERROR;
+            }
+
+          origin_rev = 0;
+        }
+
+      /* All changes since the node got added at this path ... */
+      SVN_ERR(svn_sqlite__get_statement(&stmt, index->sdb,
+                                        STMT_SELECT_PATH_REVS));
+      SVN_ERR(svn_sqlite__bindf(stmt, "srr", fspath,
+                                MAX(origin_rev, start - 1), revision));
+      SVN_ERR(svn_sqlite__step(&have_row, stmt));
+      while (have_row)
+        {
+          location = apr_array_push(result);
+          location->path = fspath;
+          location->revision = svn_sqlite__column_revnum(stmt, 0);
+
+          SVN_ERR(svn_sqlite__step(&have_row, stmt));
+        }
+      SVN_ERR(svn_sqlite__reset(stmt));
+
+      /* ... plus the addition itself. */
+      if (origin_rev < start)
+        break;
+
+      location = apr_array_push(result);
+      location->path = fspath;
+      location->revision = origin_rev;
+
+      /* Continue at the copy source, if requested. */
+      if (strict || !copyfrom_path)
+        break;
+
+      fspath = svn_fspath__join(copyfrom_path,
+                                svn_fspath__skip_ancestor(origin_path,
+                                                          fspath),
+                                result_pool);
+      revision = copyfrom_rev;
+    }
+  svn_pool_destroy(iterpool);
+
+  *locations = result;
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_repos__log_index_get_segments(apr_array_header_t **segments,
+                                  svn_repos__log_index_t *index,
+                                  const char *path,
+                                  svn_revnum_t revision,
+                                  svn_revnum_t end_rev,
+                                  apr_pool_t *result_pool,
+                                  apr_pool_t *scratch_pool)
+{
+  apr_array_header_t *result;
+  const char *fspath;
+  apr_pool_t *iterpool;
+
+  *segments = NULL;
+
+  /* Younger revisions are the caller's business. */
+  if (revision > index->indexed_rev)
+    return SVN_NO_ERROR;
+
+  result = apr_array_make(result_pool, 4, sizeof(svn_location_segment_t *));
+  fspath = svn_fspath__canonicalize(path, result_pool);
+  iterpool = svn_pool_create(scratch_pool);
+
+  while (TRUE)
+    {
+      svn_revnum_t origin_rev, copyfrom_rev;
+      const char *origin_path, *copyfrom_path;
+      svn_location_segment_t *segment;
+
+      svn_pool_clear(iterpool);
+
+      SVN_ERR(find_origin(&origin_rev, &origin_path,
+                          &copyfrom_path, &copyfrom_rev,
+                          index, fspath, revision, result_pool, iterpool));
+
+      /* Only the root exists without ever having been added. */
+      if (!SVN_IS_VALID_REVNUM(origin_rev))
+        {
+          if (!svn_fspath__is_root(fspath, strlen(fspath)))
+            {
+              svn_pool_destroy(iterpool);
+              return SVN_NO_ERROR;
+            }
+
+          origin_rev = 0;
+        }
+
+      /* The node lived at FSPATH since it got added or copied there. */
+      segment = apr_pcalloc(result_pool, sizeof(*segment));
+      segment->range_start = origin_rev;
+      segment->range_end = revision;
+      segment->path = fspath + 1;
+      APR_ARRAY_PUSH(result, svn_location_segment_t *) = segment;
+
+      if (origin_rev <= end_rev || !copyfrom_path)
+        break;
+
+      /* Continue at the copy source, reporting any gap in between. */
+      if (origin_rev - copyfrom_rev > 1)
+        {
+          segment = apr_pcalloc(result_pool, sizeof(*segment));
+          segment->range_start = copyfrom_rev + 1;
+          segment->range_end = origin_rev - 1;
+          segment->path = NULL;
+          APR_ARRAY_PUSH(result, svn_location_segment_t *) = segment;
+        }
+
+      fspath = svn_fspath__join(copyfrom_path,
+                                svn_fspath__skip_ancestor(origin_path,
+                                                          fspath),
+                                result_pool);
+      revision = copyfrom_rev;
+    }
+  svn_pool_destroy(iterpool);
+
+  *segments = result;
+  return SVN_NO_ERROR;
+}
+
+/* Set *MERGEINFO to the parsed svn:mergeinfo VALUE, allocated in
+ * RESULT_POOL.  Invalid mergeinfo results in NULL, just as the FS
+ * would report it. */
+static svn_error_t *
+parse_mergeinfo_value(svn_mergeinfo_t *mergeinfo,
+                      const char *value,
+                      apr_pool_t *result_pool)
+{
+  svn_error_t *err = svn_mergeinfo_parse(mergeinfo, value, result_pool);
+  if (err && err->apr_err == SVN_ERR_MERGEINFO_PARSE_ERROR)
+    {
+      svn_error_clear(err);
+      *mergeinfo = NULL;
+      return SVN_NO_ERROR;
+    }
+
+  return svn_error_trace(err);
+}
+
+svn_error_t *
+svn_repos__log_index_get_mergeinfo(svn_mergeinfo_t *mergeinfo,
+                                   svn_repos__log_index_t *index,
+                                   const char *path,
+                                   svn_revnum_t revision,
+                                   svn_mergeinfo_inheritance_t inherit,
+                                   svn_boolean_t adjust_inherited_mergeinfo,
+                                   apr_pool_t *result_pool,
+                                   apr_pool_t *scratch_pool)
+{
+  const char *fspath = svn_fspath__canonicalize(path, scratch_pool);
+  const char *ancestor = fspath;
+  const char *value;
+
+  *mergeinfo = NULL;
+
+  if (inherit == svn_mergeinfo_nearest_ancestor)
+    {
+      if (svn_fspath__is_root(fspath, strlen(fspath)))
+        return SVN_NO_ERROR;
+
+      ancestor = svn_fspath__dirname(fspath, scratch_pool);
+    }
+
+  /* Find the nearest node with mergeinfo, as the FS would. */
+  while (TRUE)
+    {
+      SVN_ERR(get_mergeinfo_value(&value, index->sdb, ancestor, revision,
+                                  scratch_pool));
+      if (value)
+        break;
+
+      if (   inherit == svn_mergeinfo_explicit
+          || svn_fspath__is_root(ancestor, strlen(ancestor)))
+        return SVN_NO_ERROR;
+
+      ancestor = svn_fspath__dirname(ancestor, scratch_pool);
+    }
+
+  SVN_ERR(parse_mergeinfo_value(mergeinfo, value, result_pool));
+
+  /* Inherited mergeinfo loses its non-inheritable ranges and applies
+     to the respective sub-paths of the merge sources. */
+  if (*mergeinfo && adjust_inherited_mergeinfo && ancestor != fspath)
+    {
+      svn_mergeinfo_t inheritable;
+
+      SVN_ERR(svn_mergeinfo_inheritable2(&inheritable, *mergeinfo,
+                                         NULL, SVN_INVALID_REVNUM,
+                                         SVN_INVALID_REVNUM, TRUE,
+                                         scratch_pool, scratch_pool));
+      SVN_ERR(svn_mergeinfo__add_suffix_to_mergeinfo(
+                mergeinfo, inheritable,
+                svn_fspath__skip_ancestor(ancestor, fspath),
+                result_pool, scratch_pool));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_repos__log_index_get_descendant_mergeinfo(
+  svn_repos__log_index_t *index,
+  const char *path,
+  svn_revnum_t revision,
+  svn_fs_mergeinfo_receiver_t receiver,
+  void *receiver_baton,
+  apr_pool_t *scratch_pool)
+{
+  apr_array_header_t *paths, *values;
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  int i;
+
+  SVN_ERR(get_descendant_mergeinfo_values(&paths, &values, index->sdb,
+                                          svn_fspath__canonicalize(
+                                            path, scratch_pool),
+                                          revision, scratch_pool,
+                                          scratch_pool));
+  for (i = 0; i < paths->nelts; ++i)
+    {
+      svn_mergeinfo_t mergeinfo;
+
+      svn_pool_clear(iterpool);
+
+      SVN_ERR(parse_mergeinfo_value(&mergeinfo,
+                                    APR_ARRAY_IDX(values, i, const char *),
+                                    iterpool));
+      if (mergeinfo)
+        SVN_ERR(receiver(APR_ARRAY_IDX(paths, i, const char *), mergeinfo,
+                         receiver_baton, iterpool));
+    }
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_repos__log_index_get_blame(apr_array_header_t **revisions,
+                               svn_repos__log_index_t *index,
+                               const char *path,
+                               svn_revnum_t revision,
+                               apr_pool_t *result_pool,
+                               apr_pool_t *scratch_pool)
+{
+  svn_sqlite__stmt_t *stmt;
+  svn_boolean_t have_row;
+  const unsigned char *p, *end;
+  apr_size_t len;
+  apr_array_header_t *result = NULL;
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, index->sdb, STMT_SELECT_BLAME));
+  SVN_ERR(svn_sqlite__bindf(stmt, "sr",
+                            svn_fspath__canonicalize(path, scratch_pool),
+                            revision));
+  SVN_ERR(svn_sqlite__step(&have_row, stmt));
+
+  if (have_row)
+    {
+      p = svn_sqlite__column_blob(stmt, 0, &len, NULL);
+      end = p + len;
+      result = apr_array_make(result_pool, 16, sizeof(svn_revnum_t));
+
+      while (p && p < end)
+        {
+          apr_uint64_t line_rev, count;
+
+          p = svn__decode_uint(&line_rev, p, end);
+          if (p)
+            p = svn__decode_uint(&count, p, end);
+
+          /* Treat broken entries as cache misses. */
+          if (!p)
+            {
+              result = NULL;
+              break;
+            }
+
+          while (count--)
+            APR_ARRAY_PUSH(result, svn_revnum_t) = (svn_revnum_t)line_rev;
+        }
+    }
+
+  *revisions = result;
+  return svn_error_trace(svn_sqlite__reset(stmt));
+}
+
+svn_error_t *
+svn_repos__log_index_set_blame(svn_repos__log_index_t *index,
+                               const char *path,
+                               svn_revnum_t revision,
+                               const apr_array_header_t *revisions,
+                               apr_pool_t *scratch_pool)
+{
+  svn_sqlite__stmt_t *stmt;
+  svn_stringbuf_t *annotation = svn_stringbuf_create_empty(scratch_pool);
+  int i, count;
+
+  /* Run-length encode the per-line revisions. */
+  for (i = 0; i < revisions->nelts; i += count)
+    {
+      svn_revnum_t line_rev = APR_ARRAY_IDX(revisions, i, svn_revnum_t);
+      unsigned char buffer[2 * SVN__MAX_ENCODED_UINT_LEN];
+      unsigned char *p;
+
+      for (count = 1; i + count < revisions->nelts; ++count)
+        if (APR_ARRAY_IDX(revisions, i + count, svn_revnum_t) != line_rev)
+          break;
+
+      p = svn__encode_uint(buffer, line_rev);
+      p = svn__encode_uint(p, count);
+      svn_stringbuf_appendbytes(annotation, (const char *)buffer,
+                                p - buffer);
+    }
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, index->sdb, STMT_INSERT_BLAME));
+  SVN_ERR(svn_sqlite__bindf(stmt, "srb",
+                            svn_fspath__canonicalize(path, scratch_pool),
+                            revision, annotation->data, annotation->len));
+
+  return svn_error_trace(svn_sqlite__insert(NULL, stmt));
+}
+
+svn_error_t *
+svn_repos__log_index_update(svn_repos_t *repos,
+                            svn_revnum_t revision,
+                            apr_pool_t *scratch_pool)
+{
+  svn_sqlite__db_t *sdb;
+  svn_revnum_t indexed_rev;
+  apr_pool_t *subpool = svn_pool_create(scratch_pool);
+  svn_error_t *err;
+
+  /* The index is opt-in; never create it here. */
+  SVN_ERR(open_index_db(&sdb, repos, FALSE, subpool, subpool));
+  if (!sdb)
+    {
+      svn_pool_destroy(subpool);
+      return SVN_NO_ERROR;
+    }
+
+  err = get_indexed_rev(&indexed_rev, sdb);
+  if (!err
+      && SVN_IS_VALID_REVNUM(indexed_rev)
+      && indexed_rev < revision
+      && revision - indexed_rev <= LOG_INDEX_MAX_CATCH_UP)
+    err = catch_up(sdb, repos, revision, NULL, NULL, NULL, NULL, subpool);
+
+  /* Closes the database. */
+  svn_pool_destroy(subpool);
+
+  return svn_error_trace(err);
+}
+
+
+/*** Public API's. ***/
+
+svn_error_t *
+svn_repos_build_log_index(svn_repos_t *repos,
+                          svn_repos_notify_func_t notify_func,
+                          void *notify_baton,
+                          svn_cancel_func_t cancel_func,
+                          void *cancel_baton,
+                          apr_pool_t *scratch_pool)
+{
+  svn_sqlite__db_t *sdb;
+  svn_revnum_t youngest;
+  apr_pool_t *subpool = svn_pool_create(scratch_pool);
+  svn_error_t *err;
+
+  SVN_ERR(open_index_db(&sdb, repos, TRUE, subpool, subpool));
+  if (!sdb)
+    {
+      svn_pool_destroy(subpool);
+      return svn_error_createf(SVN_ERR_REPOS_UNSUPPORTED_VERSION, NULL,
+                               _("Unsupported changed-paths index format "
+                                 "in '%s'"),
+                               svn_dirent_local_style(
+                                 log_index_path(repos, scratch_pool),
+                                 scratch_pool));
+    }
+
+  err = svn_fs_youngest_rev(&youngest, repos->fs, subpool);
+  if (!err)
+    err = catch_up(sdb, repos, youngest, notify_func, notify_baton,
+                   cancel_func, cancel_baton, subpool);
+
+  /* Closes the database. */
+  svn_pool_destroy(subpool);
+
+  return svn_error_trace(err);
+}
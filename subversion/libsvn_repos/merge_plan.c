@@ -0,0 +1,179 @@
+/* merge_plan.c --- gather the repository data needed to plan a merge
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include "svn_hash.h"
+#include "svn_fs.h"
+#include "svn_mergeinfo.h"
+#include "svn_pools.h"
+#include "svn_repos.h"
+#include "private/svn_fspath.h"
+#include "private/svn_mergeinfo_private.h"
+#include "private/svn_repos_private.h"
+#include "private/svn_sorts_private.h"
+#include "svn_private_config.h"
+
+
+
+/* Baton for segment_receiver(). */
+typedef struct segment_baton_t
+{
+  /* The svn_location_segment_t * received so far, youngest first. */
+  apr_array_header_t *segments;
+
+  /* Pool to allocate the segments in. */
+  apr_pool_t *pool;
+} segment_baton_t;
+
+/* Implements svn_location_segment_receiver_t.  Collect copies of
+   SEGMENT in the segment_baton_t BATON. */
+static svn_error_t *
+segment_receiver(svn_location_segment_t *segment,
+                 void *baton,
+                 apr_pool_t *pool)
+{
+  segment_baton_t *b = baton;
+  APR_ARRAY_PUSH(b->segments, svn_location_segment_t *)
+    = svn_location_segment_dup(segment, b->pool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *HISTORY to the location history of PATH@PEG_REV in REPOS between
+   YOUNGEST_REV and OLDEST_REV, expressed as mergeinfo.  Pass AUTHZ_READ_FUNC
+   and AUTHZ_READ_BATON through to svn_repos_node_location_segments().
+   Allocate the result in RESULT_POOL and use SCRATCH_POOL for temporaries.
+ */
+static svn_error_t *
+history_as_mergeinfo(svn_mergeinfo_t *history,
+                     svn_repos_t *repos,
+                     const char *path,
+                     svn_revnum_t peg_rev,
+                     svn_revnum_t youngest_rev,
+                     svn_revnum_t oldest_rev,
+                     svn_repos_authz_func_t authz_read_func,
+                     void *authz_read_baton,
+                     apr_pool_t *result_pool,
+                     apr_pool_t *scratch_pool)
+{
+  segment_baton_t baton;
+
+  baton.segments = apr_array_make(scratch_pool, 8,
+                                  sizeof(svn_location_segment_t *));
+  baton.pool = scratch_pool;
+
+  SVN_ERR(svn_repos_node_location_segments(repos, path, peg_rev,
+                                           youngest_rev, oldest_rev,
+                                           segment_receiver, &baton,
+                                           authz_read_func, authz_read_baton,
+                                           scratch_pool));
+
+  /* svn_mergeinfo__mergeinfo_from_segments() wants them oldest first. */
+  svn_sort__array_reverse(baton.segments, scratch_pool);
+  SVN_ERR(svn_mergeinfo__mergeinfo_from_segments(history, baton.segments,
+                                                 result_pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Baton for mergeinfo_receiver(). */
+typedef struct mergeinfo_baton_t
+{
+  /* The catalog to add to. */
+  svn_mergeinfo_catalog_t catalog;
+
+  /* Pool that CATALOG has been allocated in. */
+  apr_pool_t *pool;
+} mergeinfo_baton_t;
+
+/* Implements svn_repos_mergeinfo_receiver_t.  Add a copy of MERGEINFO
+   for PATH to the catalog in the mergeinfo_baton_t BATON. */
+static svn_error_t *
+mergeinfo_receiver(const char *path,
+                   svn_mergeinfo_t mergeinfo,
+                   void *baton,
+                   apr_pool_t *scratch_pool)
+{
+  mergeinfo_baton_t *b = baton;
+  svn_hash_sets(b->catalog, apr_pstrdup(b->pool, path),
+                svn_mergeinfo_dup(mergeinfo, b->pool));
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_repos__get_merge_plan(svn_mergeinfo_t *source_history,
+                          svn_mergeinfo_t *target_history,
+                          svn_mergeinfo_catalog_t *target_mergeinfo,
+                          svn_repos_t *repos,
+                          const char *source_path,
+                          svn_revnum_t source_peg_rev,
+                          svn_revnum_t source_youngest_rev,
+                          svn_revnum_t source_oldest_rev,
+                          const char *target_path,
+                          svn_revnum_t target_rev,
+                          svn_boolean_t include_descendants,
+                          svn_repos_authz_func_t authz_read_func,
+                          void *authz_read_baton,
+                          apr_pool_t *result_pool,
+                          apr_pool_t *scratch_pool)
+{
+  apr_array_header_t *paths;
+  mergeinfo_baton_t baton;
+
+  SVN_ERR_ASSERT(svn_fspath__is_canonical(source_path));
+  SVN_ERR_ASSERT(svn_fspath__is_canonical(target_path));
+
+  /* Default to the complete history of the source as of its peg rev. */
+  if (!SVN_IS_VALID_REVNUM(source_youngest_rev))
+    source_youngest_rev = source_peg_rev;
+  if (!SVN_IS_VALID_REVNUM(source_oldest_rev))
+    source_oldest_rev = 0;
+
+  SVN_ERR(history_as_mergeinfo(source_history, repos, source_path,
+                               source_peg_rev, source_youngest_rev,
+                               source_oldest_rev,
+                               authz_read_func, authz_read_baton,
+                               result_pool, scratch_pool));
+
+  if (target_history)
+    SVN_ERR(history_as_mergeinfo(target_history, repos, target_path,
+                                 target_rev, target_rev, 0,
+                                 authz_read_func, authz_read_baton,
+                                 result_pool, scratch_pool));
+
+  /* The explicit or inherited mergeinfo of the target. */
+  paths = apr_array_make(scratch_pool, 1, sizeof(const char *));
+  APR_ARRAY_PUSH(paths, const char *) = target_path;
+
+  baton.catalog = apr_hash_make(result_pool);
+  baton.pool = result_pool;
+  SVN_ERR(svn_repos_fs_get_mergeinfo2(repos, paths, target_rev,
+                                      svn_mergeinfo_inherited,
+                                      include_descendants,
+                                      authz_read_func, authz_read_baton,
+                                      mergeinfo_receiver, &baton,
+                                      scratch_pool));
+
+  *target_mergeinfo = apr_hash_count(baton.catalog) ? baton.catalog : NULL;
+
+  return SVN_NO_ERROR;
+}
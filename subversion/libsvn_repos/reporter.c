@@ -1095,6 +1095,68 @@ update_entry(report_baton_t *b, svn_revnum_t s_rev, const char *s_path,
     }
 }
 
+/* Warm the filesystem caches for the entries in ORDERED_ENTRIES, the
+   contents of directory T_PATH in B->t_root as returned by
+   svn_fs_dir_optimal_order(), before the editor drive descends into them.
+
+   Without this, each child noderev and each sub-directory representation
+   gets read only when update_entry() reaches it, i.e. after the complete
+   sub-tree of the previous sibling has been sent.  For large checkouts,
+   that turns into a long chain of dependent, random reads.  Touching all
+   entries up-front and in physical order lets the backend read them in
+   sequence, typically as part of a few block reads, so they are hot in
+   cache by the time we need them.  Sub-directory contents are only
+   fetched if RECURSE is set.
+
+   This is purely an optimization; errors are ignored and will be reported
+   by the actual editor drive if they matter.  Use SCRATCH_POOL for
+   temporary allocations. */
+static void
+prefetch_entries(report_baton_t *b,
+                 const char *t_path,
+                 const apr_array_header_t *ordered_entries,
+                 svn_boolean_t recurse,
+                 apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool;
+  int i;
+
+  /* Nothing to gain from a single entry. */
+  if (ordered_entries->nelts < 2)
+    return;
+
+  iterpool = svn_pool_create(scratch_pool);
+  for (i = 0; i < ordered_entries->nelts; ++i)
+    {
+      const svn_fs_dirent_t *t_entry
+         = APR_ARRAY_IDX(ordered_entries, i, svn_fs_dirent_t *);
+      const char *t_fullpath;
+      svn_error_t *err;
+
+      svn_pool_clear(iterpool);
+      t_fullpath = svn_fspath__join(t_path, t_entry->name, iterpool);
+
+      if (recurse && t_entry->kind == svn_node_dir)
+        {
+          /* Reads the noderev as well as the directory rep. */
+          apr_hash_t *entries;
+          err = svn_fs_dir_entries(&entries, b->t_root, t_fullpath,
+                                   iterpool);
+        }
+      else
+        {
+          /* Reads the noderev only. */
+          svn_revnum_t created_rev;
+          err = svn_fs_node_created_rev(&created_rev, b->t_root, t_fullpath,
+                                        iterpool);
+        }
+
+      svn_error_clear(err);
+    }
+
+  svn_pool_destroy(iterpool);
+}
+
 /* A helper macro for when we have to recurse into subdirectories. */
 #define DEPTH_BELOW_HERE(depth) ((depth) == svn_depth_immediates) ? \
                                  svn_depth_empty : (depth)
@@ -1304,6 +1366,11 @@ delta_dirs(report_baton_t *b, svn_revnum_t s_rev, const char *s_path,
       /* Loop over the dirents in the target. */
       SVN_ERR(svn_fs_dir_optimal_order(&t_ordered_entries, b->t_root,
                                        t_entries, subpool, iterpool));
+      prefetch_entries(b, t_path, t_ordered_entries,
+                       requested_depth == svn_depth_infinity
+                       || (requested_depth == svn_depth_unknown
+                           && wc_depth == svn_depth_infinity),
+                       iterpool);
       for (i = 0; i < t_ordered_entries->nelts; ++i)
         {
           const svn_fs_dirent_t *t_entry
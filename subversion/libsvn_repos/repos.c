@@ -878,6 +878,18 @@ create_conf(svn_repos_t *repos, apr_pool_t *pool)
 "### Unless you specify an absolute path, the file's location is relative"   NL
 "### to the directory containing this file."                                 NL
 "# hooks-env = " SVN_REPOS__CONF_HOOKS_ENV                                   NL
+"### The stream-compression option selects whether svnserve compresses"      NL
+"### the whole connection after authentication. \"lz4\" is fast and cheap"   NL
+"### and suits fast networks, \"zlib\" compresses better at the cost of CPU" NL
+"### time and suits slow networks. Clients that do not support the chosen"   NL
+"### method, and connections using SASL, are not compressed. The default"    NL
+"### is \"none\"; file contents are still compressed individually then."     NL
+"# stream-compression = none"                                                NL
+"### The max-changed-paths option limits the number of changed paths that"   NL
+"### svnserve reports per revision in 'svn log -v' responses.  Longer lists" NL
+"### get truncated silently.  This protects the server against revisions"    NL
+"### like huge vendor imports.  The default is 0, i.e. no limit."            NL
+"# max-changed-paths = 0"                                                    NL
 ""                                                                           NL
 "[sasl]"                                                                     NL
 "### This option specifies whether you want to use the Cyrus SASL"           NL
@@ -70,6 +70,9 @@ extern "C" {
 #define SVN_REPOS__DB_LOCKFILE "db.lock" /* Our Berkeley lockfile. */
 #define SVN_REPOS__DB_LOGS_LOCKFILE "db-logs.lock" /* BDB logs lockfile. */
 
+/* The optional changed-paths index, within the db directory. */
+#define SVN_REPOS__LOG_INDEX   "log-index.db"
+
 /* In the repository hooks directory, look for these files. */
 #define SVN_REPOS__HOOK_START_COMMIT    "start-commit"
 #define SVN_REPOS__HOOK_PRE_COMMIT      "pre-commit"
@@ -87,6 +90,14 @@ extern "C" {
 /* The extension added to the names of example hook scripts. */
 #define SVN_REPOS__HOOK_DESC_EXT        ".tmpl"
 
+/* The extension added to a hook's name to get the name of its in-process
+   hook module, see svn_repos_hook_func_t. */
+#ifdef WIN32
+#define SVN_REPOS__HOOK_MODULE_EXT      ".dll"
+#else
+#define SVN_REPOS__HOOK_MODULE_EXT      ".so"
+#endif
+
 /* The file which contains a custom set of environment variables
  * passed inherited to hook scripts, in the repository conf directory. */
 #define SVN_REPOS__CONF_HOOKS_ENV "hooks-env"
@@ -387,6 +398,139 @@ svn_repos__prev_location(svn_revnum_t *appeared_rev,
                          const char *path,
                          apr_pool_t *pool);
 
+
+/*** Changed-paths Index ***/
+
+/* An open changed-paths index.  It records for every revision which
+   paths changed, where nodes got added or copied and how their
+   svn:mergeinfo changed.  That allows the log and mergeinfo functions
+   to find a path's history and mergeinfo without walking the node
+   history or reading properties in the filesystem. */
+typedef struct svn_repos__log_index_t svn_repos__log_index_t;
+
+/* A single step in a path's history as reported by the index. */
+typedef struct svn_repos__log_index_location_t
+{
+  /* The path within the repository at REVISION. */
+  const char *path;
+
+  /* The revision in which PATH changed. */
+  svn_revnum_t revision;
+} svn_repos__log_index_location_t;
+
+/* Set *INDEX to the changed-paths index of REPOS, allocated in
+   RESULT_POOL.  Set it to NULL if REPOS has no such index or if it
+   does not cover all revisions up to and including MIN_REV, i.e. if
+   the caller should not rely on it.  Use SCRATCH_POOL for temporaries.
+ */
+svn_error_t *
+svn_repos__log_index_open(svn_repos__log_index_t **index,
+                          svn_repos_t *repos,
+                          svn_revnum_t min_rev,
+                          apr_pool_t *result_pool,
+                          apr_pool_t *scratch_pool);
+
+/* Set *LOCATIONS to the svn_repos__log_index_location_t history of the
+   node at PATH in revision END, as svn_fs_history_prev2 would report it,
+   from youngest to oldest and stopping before START.  Follow copies
+   unless STRICT is set.  PATH must exist in END.
+
+   If INDEX lacks the information needed, set *LOCATIONS to NULL and
+   let the caller walk the filesystem history instead.
+
+   Allocate the result in RESULT_POOL and use SCRATCH_POOL for temporary
+   allocations. */
+svn_error_t *
+svn_repos__log_index_get_history(apr_array_header_t **locations,
+                                 svn_repos__log_index_t *index,
+                                 const char *path,
+                                 svn_revnum_t start,
+                                 svn_revnum_t end,
+                                 svn_boolean_t strict,
+                                 apr_pool_t *result_pool,
+                                 apr_pool_t *scratch_pool);
+
+/* Set *SEGMENTS to the svn_location_segment_t * history of the node at
+   PATH in REVISION, as svn_repos_node_location_segments() would report
+   it, from youngest to oldest and including gap segments.  Stop after
+   the first segment that reaches back to END_REV; the segments are not
+   cropped to it.  PATH must exist in REVISION.
+
+   If INDEX does not cover REVISION or lacks the information needed, set
+   *SEGMENTS to NULL and let the caller walk the filesystem instead.
+
+   Allocate the result in RESULT_POOL and use SCRATCH_POOL for temporary
+   allocations. */
+svn_error_t *
+svn_repos__log_index_get_segments(apr_array_header_t **segments,
+                                  svn_repos__log_index_t *index,
+                                  const char *path,
+                                  svn_revnum_t revision,
+                                  svn_revnum_t end_rev,
+                                  apr_pool_t *result_pool,
+                                  apr_pool_t *scratch_pool);
+
+/* Set *MERGEINFO to the mergeinfo of PATH in REVISION as recorded in
+   INDEX, just like svn_fs__get_mergeinfo_for_path() would for INHERIT and
+   ADJUST_INHERITED_MERGEINFO.  Set it to NULL if there is none.  PATH must
+   exist in REVISION.
+
+   Allocate the result in RESULT_POOL and use SCRATCH_POOL for temporary
+   allocations. */
+svn_error_t *
+svn_repos__log_index_get_mergeinfo(svn_mergeinfo_t *mergeinfo,
+                                   svn_repos__log_index_t *index,
+                                   const char *path,
+                                   svn_revnum_t revision,
+                                   svn_mergeinfo_inheritance_t inherit,
+                                   svn_boolean_t adjust_inherited_mergeinfo,
+                                   apr_pool_t *result_pool,
+                                   apr_pool_t *scratch_pool);
+
+/* Invoke RECEIVER with RECEIVER_BATON for the explicit mergeinfo of each
+   strict descendant of PATH in REVISION as recorded in INDEX.  Skip any
+   invalid mergeinfo, like the FS does.  Use SCRATCH_POOL for temporaries.
+ */
+svn_error_t *
+svn_repos__log_index_get_descendant_mergeinfo(
+  svn_repos__log_index_t *index,
+  const char *path,
+  svn_revnum_t revision,
+  svn_fs_mergeinfo_receiver_t receiver,
+  void *receiver_baton,
+  apr_pool_t *scratch_pool);
+
+/* Set *REVISIONS to the array of svn_revnum_t that INDEX caches as the
+   blame annotation of PATH@REVISION, or to NULL if it has none.  See
+   svn_repos__get_blame() for the semantics.
+
+   Allocate the result in RESULT_POOL and use SCRATCH_POOL for temporary
+   allocations. */
+svn_error_t *
+svn_repos__log_index_get_blame(apr_array_header_t **revisions,
+                               svn_repos__log_index_t *index,
+                               const char *path,
+                               svn_revnum_t revision,
+                               apr_pool_t *result_pool,
+                               apr_pool_t *scratch_pool);
+
+/* Store REVISIONS as the blame annotation of PATH@REVISION in INDEX,
+   replacing any previous one.  Use SCRATCH_POOL for temporaries. */
+svn_error_t *
+svn_repos__log_index_set_blame(svn_repos__log_index_t *index,
+                               const char *path,
+                               svn_revnum_t revision,
+                               const apr_array_header_t *revisions,
+                               apr_pool_t *scratch_pool);
+
+/* If REPOS has a changed-paths index that is at most a few revisions
+   behind REVISION, bring it up to date up to and including REVISION.
+   Otherwise, leave it alone.  Use SCRATCH_POOL for temporaries. */
+svn_error_t *
+svn_repos__log_index_update(svn_repos_t *repos,
+                            svn_revnum_t revision,
+                            apr_pool_t *scratch_pool);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
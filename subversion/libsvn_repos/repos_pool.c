@@ -0,0 +1,260 @@
+/*
+ * repos_pool.c :  pool of opened repository objects
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+
+
+
+#include "svn_dirent_uri.h"
+#include "svn_fs.h"
+#include "svn_hash.h"
+#include "svn_pools.h"
+#include "svn_repos.h"
+
+#include "private/svn_mutex.h"
+#include "private/svn_repos_private.h"
+#include "private/svn_subr_private.h"
+
+#include "svn_private_config.h"
+
+
+/* Maximum number of unused repository instances to keep around.
+ * Instances returned while that many are idle will simply be destroyed.
+ */
+#define MAX_IDLE_REPOS 64
+
+/* A repository instance owned by a svn_repos__repos_pool_t.
+ */
+typedef struct repos_entry_t
+{
+  /* The pool that we will return this instance to. */
+  svn_repos__repos_pool_t *owner;
+
+  /* The opened repository.  Allocated in POOL. */
+  svn_repos_t *repos;
+
+  /* Absolute local path to the repository.  Allocated in POOL. */
+  const char *path;
+
+  /* Pool that contains this entry and the repository instance. */
+  apr_pool_t *pool;
+
+  /* Next idle instance of the same repository, NULL at the end of
+   * the list. */
+  struct repos_entry_t *next;
+} repos_entry_t;
+
+/* List of idle instances of the same repository.
+ */
+typedef struct idle_list_t
+{
+  /* First entry.  NULL if the list is empty. */
+  repos_entry_t *first;
+} idle_list_t;
+
+/* The pool structure itself.
+ */
+struct svn_repos__repos_pool_t
+{
+  /* Serialization object for all members below. */
+  svn_mutex__t *mutex;
+
+  /* Maps the const char * repository paths to an idle_list_t.  Entries
+   * never get removed, to keep the memory usage bounded. */
+  apr_hash_t *idle;
+
+  /* Total number of entries in IDLE. */
+  apr_size_t idle_count;
+
+  /* Owning pool.  All entries get allocated in sub-pools of it. */
+  apr_pool_t *pool;
+};
+
+/* Implements svn_fs_warning_callback_t.  Used for idle instances that
+ * don't have a user to report to.
+ */
+static void
+discard_warning(void *baton,
+                svn_error_t *err)
+{
+  /* The FS will clear ERR for us. */
+}
+
+/* Return ENTRY to its owner's list of idle instances.  If there are
+ * already more than enough of them, destroy ENTRY instead.
+ */
+static svn_error_t *
+release_entry(repos_entry_t *entry)
+{
+  svn_repos__repos_pool_t *owner = entry->owner;
+  svn_boolean_t keep;
+
+  /* Forget the state that the last user attached to the instance. */
+  SVN_ERR(svn_repos_remember_client_capabilities(entry->repos, NULL));
+  svn_fs_set_warning_func(svn_repos_fs(entry->repos), discard_warning,
+                          NULL);
+
+  SVN_ERR(svn_mutex__lock(owner->mutex));
+
+  keep = owner->idle_count < MAX_IDLE_REPOS;
+  if (keep)
+    {
+      idle_list_t *list = svn_hash_gets(owner->idle, entry->path);
+      if (!list)
+        {
+          list = apr_pcalloc(owner->pool, sizeof(*list));
+          svn_hash_sets(owner->idle, apr_pstrdup(owner->pool, entry->path),
+                        list);
+        }
+
+      entry->next = list->first;
+      list->first = entry;
+      ++owner->idle_count;
+    }
+
+  SVN_ERR(svn_mutex__unlock(owner->mutex, SVN_NO_ERROR));
+
+  if (!keep)
+    svn_pool_destroy(entry->pool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Pool cleanup function returning the repos_entry_t in BATON to its
+ * owner once the user's pool gets cleaned up.
+ */
+static apr_status_t
+release_entry_cleanup(void *baton)
+{
+  svn_error_clear(release_entry(baton));
+  return APR_SUCCESS;
+}
+
+/* Remove the first idle instance of the repository at PATH from
+ * REPOS_POOL and return it in *ENTRY.  Set *ENTRY to NULL if there is
+ * no such instance.
+ */
+static svn_error_t *
+take_idle_entry(repos_entry_t **entry,
+                svn_repos__repos_pool_t *repos_pool,
+                const char *path)
+{
+  idle_list_t *list;
+
+  SVN_ERR(svn_mutex__lock(repos_pool->mutex));
+
+  list = svn_hash_gets(repos_pool->idle, path);
+  *entry = list ? list->first : NULL;
+  if (*entry)
+    {
+      list->first = (*entry)->next;
+      (*entry)->next = NULL;
+      --repos_pool->idle_count;
+    }
+
+  return svn_error_trace(svn_mutex__unlock(repos_pool->mutex,
+                                           SVN_NO_ERROR));
+}
+
+/* Return an error, if the idle repository instance in ENTRY is out of
+ * sync with the repository on disk or if that repository is not
+ * accessible anymore.  Use SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+refresh_entry(repos_entry_t *entry,
+              apr_pool_t *scratch_pool)
+{
+  svn_fs_t *fs = svn_repos_fs(entry->repos);
+  svn_revnum_t youngest;
+
+  /* Data that we cached locally may have changed while we were idle. */
+  SVN_ERR(svn_fs_refresh_revision_props(fs, scratch_pool));
+
+  /* Reading the youngest revision also tells us whether the repository
+   * is still there. */
+  return svn_error_trace(svn_fs_youngest_rev(&youngest, fs, scratch_pool));
+}
+
+svn_error_t *
+svn_repos__repos_pool_create(svn_repos__repos_pool_t **repos_pool,
+                             svn_boolean_t thread_safe,
+                             apr_pool_t *pool)
+{
+  svn_repos__repos_pool_t *result = apr_pcalloc(pool, sizeof(*result));
+
+  SVN_ERR(svn_mutex__init(&result->mutex, thread_safe, pool));
+  result->idle = svn_hash__make(pool);
+  result->pool = pool;
+
+  *repos_pool = result;
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_repos__repos_pool_get(svn_repos_t **repos_p,
+                          svn_repos__repos_pool_t *repos_pool,
+                          const char *path,
+                          apr_hash_t *fs_config,
+                          apr_pool_t *result_pool,
+                          apr_pool_t *scratch_pool)
+{
+  repos_entry_t *entry;
+
+  SVN_ERR(take_idle_entry(&entry, repos_pool, path));
+  if (entry)
+    {
+      svn_error_t *err = refresh_entry(entry, scratch_pool);
+
+      /* Simply open a new instance if this one is too stale. */
+      if (err)
+        {
+          svn_error_clear(err);
+          svn_pool_destroy(entry->pool);
+          entry = NULL;
+        }
+    }
+
+  if (!entry)
+    {
+      apr_pool_t *entry_pool = svn_pool_create(repos_pool->pool);
+      svn_error_t *err;
+
+      entry = apr_pcalloc(entry_pool, sizeof(*entry));
+      entry->owner = repos_pool;
+      entry->pool = entry_pool;
+      entry->path = apr_pstrdup(entry_pool, path);
+
+      err = svn_repos_open3(&entry->repos, path, fs_config, entry_pool,
+                            scratch_pool);
+      if (err)
+        {
+          svn_pool_destroy(entry_pool);
+          return svn_error_trace(err);
+        }
+    }
+
+  apr_pool_cleanup_register(result_pool, entry, release_entry_cleanup,
+                            apr_pool_cleanup_null);
+
+  *repos_p = entry->repos;
+  return SVN_NO_ERROR;
+}
@@ -821,6 +821,57 @@ maybe_crop_and_send_segment(svn_location_segment_t *segment,
   return SVN_NO_ERROR;
 }
 
+/* Transmit the segments from the changed-paths index SEGMENTS, as
+   returned by svn_repos__log_index_get_segments(), the same way
+   svn_repos_node_location_segments() would report them from the FS
+   history walk.  Stop at the first segment that is not readable as per
+   AUTHZ_READ_FUNC and AUTHZ_READ_BATON.  Use POOL for temporaries. */
+static svn_error_t *
+send_indexed_segments(apr_array_header_t *segments,
+                      svn_fs_t *fs,
+                      svn_revnum_t start_rev,
+                      svn_revnum_t end_rev,
+                      svn_location_segment_receiver_t receiver,
+                      void *receiver_baton,
+                      svn_repos_authz_func_t authz_read_func,
+                      void *authz_read_baton,
+                      apr_pool_t *pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  int i;
+
+  for (i = 0; i < segments->nelts; i++)
+    {
+      svn_location_segment_t *segment
+        = APR_ARRAY_IDX(segments, i, svn_location_segment_t *);
+
+      svn_pool_clear(iterpool);
+
+      /* Gaps don't need authz checks. */
+      if (segment->path && authz_read_func)
+        {
+          svn_boolean_t readable;
+          svn_fs_root_t *cur_rev_root;
+          const char *abs_path = apr_pstrcat(iterpool, "/", segment->path,
+                                             SVN_VA_NULL);
+
+          SVN_ERR(svn_fs_revision_root(&cur_rev_root, fs,
+                                       segment->range_end, iterpool));
+          SVN_ERR(authz_read_func(&readable, cur_rev_root, abs_path,
+                                  authz_read_baton, iterpool));
+          if (! readable)
+            break;
+        }
+
+      SVN_ERR(maybe_crop_and_send_segment(segment, start_rev, end_rev,
+                                          receiver, receiver_baton,
+                                          iterpool));
+    }
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
 
 svn_error_t *
 svn_repos_node_location_segments(svn_repos_t *repos,
@@ -837,6 +888,7 @@ svn_repos_node_location_segments(svn_repos_t *repos,
   svn_fs_t *fs = svn_repos_fs(repos);
   svn_stringbuf_t *current_path;
   svn_revnum_t youngest_rev, current_rev;
+  svn_repos__log_index_t *log_index;
   apr_pool_t *subpool;
 
   SVN_ERR(svn_fs_youngest_rev(&youngest_rev, fs, pool));
@@ -882,6 +934,21 @@ svn_repos_node_location_segments(svn_repos_t *repos,
                                 authz_read_func, authz_read_baton, pool));
     }
 
+  /* The changed-paths index knows all copies and additions, so it can
+     replace the history walk for all revisions that it covers.  Make
+     sure that PATH exists, though, because the index can't tell. */
+  SVN_ERR(svn_repos__log_index_open(&log_index, repos, 0, pool, pool));
+  if (log_index)
+    {
+      svn_fs_root_t *peg_root;
+      svn_node_kind_t kind;
+
+      SVN_ERR(svn_fs_revision_root(&peg_root, fs, peg_revision, pool));
+      SVN_ERR(svn_fs_check_path(&kind, peg_root, path, pool));
+      if (kind == svn_node_none)
+        log_index = NULL;
+    }
+
   /* Okay, let's get searching! */
   subpool = svn_pool_create(pool);
   current_rev = peg_revision;
@@ -896,6 +963,26 @@ svn_repos_node_location_segments(svn_repos_t *repos,
 
       cur_path = apr_pstrmemdup(subpool, current_path->data,
                                 current_path->len);
+
+      /* Once we are back in the revisions covered by the index, it
+         can provide the remainder of the history at once. */
+      if (log_index)
+        {
+          apr_array_header_t *segments;
+
+          SVN_ERR(svn_repos__log_index_get_segments(&segments, log_index,
+                                                    cur_path, current_rev,
+                                                    end_rev, subpool,
+                                                    subpool));
+          if (segments)
+            {
+              SVN_ERR(send_indexed_segments(segments, fs, start_rev, end_rev,
+                                            receiver, receiver_baton,
+                                            authz_read_func,
+                                            authz_read_baton, subpool));
+              break;
+            }
+        }
       segment = apr_pcalloc(subpool, sizeof(*segment));
       segment->range_end = current_rev;
       segment->range_start = end_rev;
@@ -998,13 +1085,45 @@ struct path_revision
   svn_boolean_t merged;
 };
 
+/* Like svn_fs__get_mergeinfo_for_path() for the adjusted inherited
+   mergeinfo of PATH in ROOT, but answer from the changed-paths index
+   LOG_INDEX if that is not NULL. */
+static svn_error_t *
+get_inherited_mergeinfo(svn_mergeinfo_t *mergeinfo,
+                        svn_repos__log_index_t *log_index,
+                        svn_fs_root_t *root,
+                        const char *path,
+                        apr_pool_t *result_pool,
+                        apr_pool_t *scratch_pool)
+{
+  if (log_index)
+    {
+      svn_node_kind_t kind;
+
+      /* Leave reporting missing paths to the FS. */
+      SVN_ERR(svn_fs_check_path(&kind, root, path, scratch_pool));
+      if (kind != svn_node_none)
+        return svn_error_trace(svn_repos__log_index_get_mergeinfo(
+                                 mergeinfo, log_index, path,
+                                 svn_fs_revision_root_revision(root),
+                                 svn_mergeinfo_inherited, TRUE,
+                                 result_pool, scratch_pool));
+    }
+
+  return svn_error_trace(svn_fs__get_mergeinfo_for_path(
+                           mergeinfo, root, path, svn_mergeinfo_inherited,
+                           TRUE, result_pool, scratch_pool));
+}
+
 /* Check for merges in OLD_PATH_REV->PATH at OLD_PATH_REV->REVNUM.  Store
    the mergeinfo difference in *MERGED_MERGEINFO, allocated in POOL.  The
    difference is the union of both additions and (negated) deletions.  The
-   returned *MERGED_MERGEINFO will be NULL if there are no changes. */
+   returned *MERGED_MERGEINFO will be NULL if there are no changes.  Read
+   the mergeinfo from LOG_INDEX if that is not NULL. */
 static svn_error_t *
 get_merged_mergeinfo(apr_hash_t **merged_mergeinfo,
                      svn_repos_t *repos,
+                     svn_repos__log_index_t *log_index,
                      struct path_revision *old_path_rev,
                      apr_pool_t *result_pool,
                      apr_pool_t *scratch_pool)
@@ -1052,10 +1171,9 @@ get_merged_mergeinfo(apr_hash_t **merged_mergeinfo,
   /* We do not need to call svn_repos_fs_get_mergeinfo() (which performs authz)
      because we will filter out unreadable revisions in
      find_interesting_revision() */
-  err = svn_fs__get_mergeinfo_for_path(&curr_mergeinfo,
-                                       root, old_path_rev->path,
-                                       svn_mergeinfo_inherited, TRUE,
-                                       scratch_pool, scratch_pool);
+  err = get_inherited_mergeinfo(&curr_mergeinfo, log_index,
+                                root, old_path_rev->path,
+                                scratch_pool, scratch_pool);
   if (err)
     {
       if (err->apr_err == SVN_ERR_MERGEINFO_PARSE_ERROR)
@@ -1075,10 +1193,9 @@ get_merged_mergeinfo(apr_hash_t **merged_mergeinfo,
 
   SVN_ERR(svn_fs_revision_root(&prev_root, repos->fs, old_path_rev->revnum - 1,
                                scratch_pool));
-  err = svn_fs__get_mergeinfo_for_path(&prev_mergeinfo,
-                                       prev_root, old_path_rev->path,
-                                       svn_mergeinfo_inherited, TRUE,
-                                       scratch_pool, scratch_pool);
+  err = get_inherited_mergeinfo(&prev_mergeinfo, log_index,
+                                prev_root, old_path_rev->path,
+                                scratch_pool, scratch_pool);
   if (err && (err->apr_err == SVN_ERR_FS_NOT_FOUND
               || err->apr_err == SVN_ERR_MERGEINFO_PARSE_ERROR))
     {
@@ -1107,9 +1224,13 @@ get_merged_mergeinfo(apr_hash_t **merged_mergeinfo,
   return SVN_NO_ERROR;
 }
 
+/* Add the struct path_revision * history of PATH between START and END
+   to PATH_REVISIONS, youngest first.  Take the history and mergeinfo from
+   the changed-paths index LOG_INDEX if that is not NULL. */
 static svn_error_t *
 find_interesting_revisions(apr_array_header_t *path_revisions,
                            svn_repos_t *repos,
+                           svn_repos__log_index_t *log_index,
                            const char *path,
                            svn_revnum_t start,
                            svn_revnum_t end,
@@ -1122,7 +1243,9 @@ find_interesting_revisions(apr_array_header_t *path_revisions,
                            apr_pool_t *scratch_pool)
 {
   apr_pool_t *iterpool, *last_pool;
-  svn_fs_history_t *history;
+  svn_fs_history_t *history = NULL;
+  apr_array_header_t *locations = NULL;
+  int next_location = 0;
   svn_fs_root_t *root;
   svn_node_kind_t kind;
 
@@ -1139,9 +1262,17 @@ find_interesting_revisions(apr_array_header_t *path_revisions,
       (SVN_ERR_FS_NOT_FILE, NULL, _("'%s' is not a file in revision %ld"),
        path, end);
 
-  /* Open a history object. */
-  SVN_ERR(svn_fs_node_history2(&history, root, path, scratch_pool,
-                               scratch_pool));
+  /* The index provides the whole history at once.  We need the location
+     at or before START as well, so don't limit the lookup to START. */
+  if (log_index)
+    SVN_ERR(svn_repos__log_index_get_history(&locations, log_index, path,
+                                             0, end, FALSE,
+                                             scratch_pool, scratch_pool));
+
+  /* Otherwise, open a history object. */
+  if (!locations)
+    SVN_ERR(svn_fs_node_history2(&history, root, path, scratch_pool,
+                                 scratch_pool));
   while (1)
     {
       struct path_revision *path_rev;
@@ -1151,13 +1282,29 @@ find_interesting_revisions(apr_array_header_t *path_revisions,
 
       svn_pool_clear(iterpool);
 
-      /* Fetch the history object to walk through. */
-      SVN_ERR(svn_fs_history_prev2(&history, history, TRUE, iterpool,
-                                   iterpool));
-      if (!history)
-        break;
-      SVN_ERR(svn_fs_history_location(&tmp_path, &tmp_revnum,
-                                      history, iterpool));
+      if (locations)
+        {
+          const svn_repos__log_index_location_t *location;
+
+          if (next_location == locations->nelts)
+            break;
+
+          location = &APR_ARRAY_IDX(locations, next_location,
+                                    svn_repos__log_index_location_t);
+          tmp_path = location->path;
+          tmp_revnum = location->revision;
+          next_location++;
+        }
+      else
+        {
+          /* Fetch the history object to walk through. */
+          SVN_ERR(svn_fs_history_prev2(&history, history, TRUE, iterpool,
+                                       iterpool));
+          if (!history)
+            break;
+          SVN_ERR(svn_fs_history_location(&tmp_path, &tmp_revnum,
+                                          history, iterpool));
+        }
 
       /* Check to see if we already saw this path (and it's ancestors) */
       if (include_merged_revisions
@@ -1188,7 +1335,8 @@ find_interesting_revisions(apr_array_header_t *path_revisions,
 
       if (include_merged_revisions)
         SVN_ERR(get_merged_mergeinfo(&path_rev->merged_mergeinfo, repos,
-                                     path_rev, result_pool, iterpool));
+                                     log_index, path_rev, result_pool,
+                                     iterpool));
       else
         path_rev->merged_mergeinfo = NULL;
 
@@ -1233,6 +1381,7 @@ find_merged_revisions(apr_array_header_t **merged_path_revisions_out,
                       svn_revnum_t start,
                       const apr_array_header_t *mainline_path_revisions,
                       svn_repos_t *repos,
+                      svn_repos__log_index_t *log_index,
                       apr_hash_t *duplicate_path_revs,
                       svn_repos_authz_func_t authz_read_func,
                       void *authz_read_baton,
@@ -1303,7 +1452,7 @@ find_merged_revisions(apr_array_header_t **merged_path_revisions_out,
 
                   /* Search and find revisions to add to the NEW list. */
                   SVN_ERR(find_interesting_revisions(new_merged_path_revs,
-                                                     repos, path,
+                                                     repos, log_index, path,
                                                      range->start, range->end,
                                                      TRUE, TRUE,
                                                      duplicate_path_revs,
@@ -1620,6 +1769,7 @@ svn_repos_get_file_revs2(svn_repos_t *repos,
 {
   apr_array_header_t *mainline_path_revisions, *merged_path_revisions;
   apr_hash_t *duplicate_path_revs;
+  svn_repos__log_index_t *log_index;
   struct send_baton sb;
   int mainline_pos, merged_pos;
 
@@ -1670,11 +1820,17 @@ svn_repos_get_file_revs2(svn_repos_t *repos,
    * may be needed. */
   sb.include_merged_revisions = include_merged_revisions;
 
+  /* Blaming popular files over and over again mostly walks the same
+     node histories and mergeinfo.  The changed-paths index has both. */
+  SVN_ERR(svn_repos__log_index_open(&log_index, repos, end, scratch_pool,
+                                    scratch_pool));
+
   /* Get the revisions we are interested in. */
   duplicate_path_revs = apr_hash_make(scratch_pool);
   mainline_path_revisions = apr_array_make(scratch_pool, 100,
                                            sizeof(struct path_revision *));
-  SVN_ERR(find_interesting_revisions(mainline_path_revisions, repos, path,
+  SVN_ERR(find_interesting_revisions(mainline_path_revisions, repos,
+                                     log_index, path,
                                      start, end, include_merged_revisions,
                                      FALSE, duplicate_path_revs,
                                      authz_read_func, authz_read_baton,
@@ -1683,7 +1839,7 @@ svn_repos_get_file_revs2(svn_repos_t *repos,
   /* If we are including merged revisions, go get those, too. */
   if (include_merged_revisions)
     SVN_ERR(find_merged_revisions(&merged_path_revisions, start,
-                                  mainline_path_revisions, repos,
+                                  mainline_path_revisions, repos, log_index,
                                   duplicate_path_revs, authz_read_func,
                                   authz_read_baton,
                                   scratch_pool, sb.iterpool));
@@ -26,6 +26,18 @@
 #include <zlib.h>
 
 #include "private/svn_adler32.h"
+#include "simd.h"
+
+/* Short-block kernels that this compiler can produce.  SSSE3 support has
+ * to be checked at runtime, NEON is mandatory on AArch64.
+ */
+#if SVN_SIMD__X86
+#  define SVN_ADLER32_SSSE3 1
+#  include <immintrin.h>
+#elif defined(__GNUC__) && defined(__ARM_NEON) && defined(__aarch64__)
+#  define SVN_ADLER32_NEON 1
+#  include <arm_neon.h>
+#endif
 
 /**
  * An Adler-32 implementation per RFC1950.
@@ -41,6 +53,171 @@
  */
 #define ADLER_MOD_BASE 65521
 
+/* Number of bytes that the SIMD kernels process per step. */
+#define SIMD_BLOCK_SIZE 16
+
+/* Update the Adler-32 sums *S1 and *S2 for the first COUNT blocks of
+ * SIMD_BLOCK_SIZE bytes at INPUT.  The sums will not be reduced modulo
+ * ADLER_MOD_BASE, i.e. the caller must make sure that they don't overflow.
+ */
+typedef void (*blocks_func_t)(apr_uint32_t *s1,
+                              apr_uint32_t *s2,
+                              const unsigned char *input,
+                              apr_size_t count);
+
+/* For a block of SIMD_BLOCK_SIZE bytes b[0] .. b[15], the sums get updated
+ * as follows:
+ *
+ *   s2 += 16 * s1 + 16 * b[0] + 15 * b[1] + ... + 1 * b[15]
+ *   s1 += b[0] + b[1] + ... + b[15]
+ *
+ * The vector code accumulates the weighted byte sums, the plain byte sums
+ * and the running totals of the latter per block.  The 16 * s1 term for
+ * block K is then 16 * (s1 + sum of the byte sums of blocks 0 .. K-1).
+ */
+
+#if SVN_ADLER32_SSSE3
+
+/* Return the sum of the 4 32 bit lanes in V. */
+SVN_SIMD__TARGET("ssse3")
+static APR_INLINE apr_uint32_t
+ssse3_hsum(__m128i v)
+{
+  v = _mm_add_epi32(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2)));
+  v = _mm_add_epi32(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(2, 3, 0, 1)));
+  return (apr_uint32_t)_mm_cvtsi128_si32(v);
+}
+
+/* Implements blocks_func_t using SSSE3. */
+SVN_SIMD__TARGET("ssse3")
+static void
+blocks_ssse3(apr_uint32_t *s1,
+             apr_uint32_t *s2,
+             const unsigned char *input,
+             apr_size_t count)
+{
+  const __m128i weights = _mm_setr_epi8(16, 15, 14, 13, 12, 11, 10, 9,
+                                        8, 7, 6, 5, 4, 3, 2, 1);
+  const __m128i ones = _mm_set1_epi16(1);
+  const __m128i zero = _mm_setzero_si128();
+  __m128i byte_sums = zero;
+  __m128i prefix_sums = zero;
+  __m128i weighted_sums = zero;
+  apr_size_t i;
+
+  for (i = 0; i < count; ++i, input += SIMD_BLOCK_SIZE)
+    {
+      __m128i block = _mm_loadu_si128((const __m128i *)input);
+
+      prefix_sums = _mm_add_epi32(prefix_sums, byte_sums);
+      byte_sums = _mm_add_epi32(byte_sums, _mm_sad_epu8(block, zero));
+      weighted_sums
+        = _mm_add_epi32(weighted_sums,
+                        _mm_madd_epi16(_mm_maddubs_epi16(block, weights),
+                                       ones));
+    }
+
+  *s2 += (apr_uint32_t)count * SIMD_BLOCK_SIZE * *s1
+       + SIMD_BLOCK_SIZE * ssse3_hsum(prefix_sums)
+       + ssse3_hsum(weighted_sums);
+  *s1 += ssse3_hsum(byte_sums);
+}
+
+#endif /* SVN_ADLER32_SSSE3 */
+
+#if SVN_ADLER32_NEON
+
+/* Implements blocks_func_t using NEON. */
+static void
+blocks_neon(apr_uint32_t *s1,
+            apr_uint32_t *s2,
+            const unsigned char *input,
+            apr_size_t count)
+{
+  static const unsigned char weight_values[SIMD_BLOCK_SIZE]
+    = { 16, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1 };
+  const uint8x16_t weights = vld1q_u8(weight_values);
+  uint32x4_t byte_sums = vdupq_n_u32(0);
+  uint32x4_t prefix_sums = vdupq_n_u32(0);
+  uint32x4_t weighted_sums = vdupq_n_u32(0);
+  apr_size_t i;
+
+  for (i = 0; i < count; ++i, input += SIMD_BLOCK_SIZE)
+    {
+      uint8x16_t block = vld1q_u8(input);
+      uint16x8_t weighted = vmull_u8(vget_low_u8(block),
+                                     vget_low_u8(weights));
+      weighted = vmlal_u8(weighted, vget_high_u8(block),
+                          vget_high_u8(weights));
+
+      prefix_sums = vaddq_u32(prefix_sums, byte_sums);
+      byte_sums = vpadalq_u16(byte_sums, vpaddlq_u8(block));
+      weighted_sums = vpadalq_u16(weighted_sums, weighted);
+    }
+
+  *s2 += (apr_uint32_t)count * SIMD_BLOCK_SIZE * *s1
+       + SIMD_BLOCK_SIZE * vaddvq_u32(prefix_sums)
+       + vaddvq_u32(weighted_sums);
+  *s1 += vaddvq_u32(byte_sums);
+}
+
+#endif /* SVN_ADLER32_NEON */
+
+/* Return the SIMD kernel to use on this CPU or NULL if there is none. */
+static blocks_func_t
+select_blocks_func(void)
+{
+#if SVN_ADLER32_SSSE3
+  if (svn_simd__features() & SVN_SIMD__SSSE3)
+    return blocks_ssse3;
+#elif SVN_ADLER32_NEON
+  return blocks_neon;
+#endif
+
+  return NULL;
+}
+
+/* Maximum number of SIMD blocks that we may process before the sums must
+ * be reduced modulo ADLER_MOD_BASE.  This is the same limit as zlib's
+ * NMAX of 5552 bytes. */
+#define MAX_SIMD_BLOCKS (5552 / SIMD_BLOCK_SIZE)
+
+/* Start with CHECKSUM and update it by processing the LEN bytes at INPUT
+ * using the SIMD kernel BLOCKS.  Return the updated checksum.
+ */
+static apr_uint32_t
+adler32_simd(blocks_func_t blocks,
+             apr_uint32_t checksum,
+             const unsigned char *input,
+             apr_size_t len)
+{
+  apr_uint32_t s1 = checksum & 0xFFFF;
+  apr_uint32_t s2 = checksum >> 16;
+
+  while (len >= SIMD_BLOCK_SIZE)
+    {
+      apr_size_t count = len / SIMD_BLOCK_SIZE;
+      if (count > MAX_SIMD_BLOCKS)
+        count = MAX_SIMD_BLOCKS;
+
+      blocks(&s1, &s2, input, count);
+      s1 %= ADLER_MOD_BASE;
+      s2 %= ADLER_MOD_BASE;
+
+      input += count * SIMD_BLOCK_SIZE;
+      len -= count * SIMD_BLOCK_SIZE;
+    }
+
+  /* Process the remaining bytes if any. */
+  while (len--)
+    {
+      s1 += *input++;
+      s2 += s1;
+    }
+
+  return ((s2 % ADLER_MOD_BASE) << 16) | (s1 % ADLER_MOD_BASE);
+}
+
 /*
  * Start with CHECKSUM and update the checksum by processing a chunk
  * of DATA sized LEN.
@@ -48,6 +225,16 @@
 apr_uint32_t
 svn__adler32(apr_uint32_t checksum, const char *data, apr_off_t len)
 {
+  /* Our SIMD code is faster than zlib for all but the shortest inputs
+   * and, unlike zlib, also speeds up the short tokens in diff. */
+  if (len >= SIMD_BLOCK_SIZE)
+    {
+      blocks_func_t blocks = select_blocks_func();
+      if (blocks)
+        return adler32_simd(blocks, checksum,
+                            (const unsigned char *)data, (apr_size_t)len);
+    }
+
   /* The actual limit can be set somewhat higher but should
    * not be lower because the SIMD code would not be used
    * in that case.
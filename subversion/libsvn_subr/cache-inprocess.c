@@ -245,6 +245,59 @@ inprocess_cache_get(void **value_p,
   return SVN_NO_ERROR;
 }
 
+/* Core of inprocess_cache_get_many: For all non-NULL KEYS, fetch the
+ * serialized data from CACHE into BUFFERS and SIZES.  Both arrays must
+ * have one element per key.  Allocate the data in RESULT_POOL.
+ */
+static svn_error_t *
+inprocess_cache_get_many_internal(char **buffers,
+                                  apr_size_t *sizes,
+                                  inprocess_cache_t *cache,
+                                  const apr_array_header_t *keys,
+                                  apr_pool_t *result_pool)
+{
+  int i;
+
+  for (i = 0; i < keys->nelts; ++i)
+    {
+      const void *key = APR_ARRAY_IDX(keys, i, const void *);
+      if (key)
+        SVN_ERR(inprocess_cache_get_internal(&buffers[i], &sizes[i], cache,
+                                             key, result_pool));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Implement svn_cache__vtable_t.get_many, taking the mutex only once.
+ */
+static svn_error_t *
+inprocess_cache_get_many(apr_array_header_t *values,
+                         void *cache_void,
+                         const apr_array_header_t *keys,
+                         apr_pool_t *result_pool)
+{
+  inprocess_cache_t *cache = cache_void;
+  char **buffers = apr_pcalloc(result_pool, keys->nelts * sizeof(*buffers));
+  apr_size_t *sizes = apr_pcalloc(result_pool, keys->nelts * sizeof(*sizes));
+  int i;
+
+  SVN_MUTEX__WITH_LOCK(cache->mutex,
+                       inprocess_cache_get_many_internal(buffers,
+                                                         sizes,
+                                                         cache,
+                                                         keys,
+                                                         result_pool));
+
+  /* Deserialize outside the lock, just like inprocess_cache_get. */
+  for (i = 0; i < keys->nelts; ++i)
+    if (buffers[i] && sizes[i])
+      SVN_ERR(cache->deserialize_func(&APR_ARRAY_IDX(values, i, void *),
+                                      buffers[i], sizes[i], result_pool));
+
+  return SVN_NO_ERROR;
+}
+
 static svn_error_t *
 inprocess_cache_has_key_internal(svn_boolean_t *found,
                                  inprocess_cache_t *cache,
@@ -453,6 +506,48 @@ inprocess_cache_set(void *cache_void,
   return SVN_NO_ERROR;
 }
 
+/* Core of inprocess_cache_set_many: Store all VALUES under the
+ * respective non-NULL KEYS in CACHE.
+ */
+static svn_error_t *
+inprocess_cache_set_many_internal(inprocess_cache_t *cache,
+                                  const apr_array_header_t *keys,
+                                  const apr_array_header_t *values,
+                                  apr_pool_t *scratch_pool)
+{
+  int i;
+
+  for (i = 0; i < keys->nelts; ++i)
+    {
+      const void *key = APR_ARRAY_IDX(keys, i, const void *);
+      if (key)
+        SVN_ERR(inprocess_cache_set_internal(cache, key,
+                                             APR_ARRAY_IDX(values, i, void *),
+                                             scratch_pool));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Implement svn_cache__vtable_t.set_many, taking the mutex only once.
+ */
+static svn_error_t *
+inprocess_cache_set_many(void *cache_void,
+                         const apr_array_header_t *keys,
+                         const apr_array_header_t *values,
+                         apr_pool_t *scratch_pool)
+{
+  inprocess_cache_t *cache = cache_void;
+
+  SVN_MUTEX__WITH_LOCK(cache->mutex,
+                       inprocess_cache_set_many_internal(cache,
+                                                         keys,
+                                                         values,
+                                                         scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
 /* Baton type for svn_cache__iter. */
 struct cache_iter_baton {
   svn_iter_apr_hash_cb_t user_cb;
@@ -640,7 +735,11 @@ static svn_cache__vtable_t inprocess_cache_vtable = {
   inprocess_cache_is_cachable,
   inprocess_cache_get_partial,
   inprocess_cache_set_partial,
-  inprocess_cache_get_info
+  inprocess_cache_get_info,
+  inprocess_cache_get_many,
+  inprocess_cache_set_many,
+  NULL, /* get_pinned */
+  NULL  /* unpin */
 };
 
 svn_error_t *
@@ -24,16 +24,22 @@
 #include <assert.h>
 #include <apr_md5.h>
 #include <apr_thread_rwlock.h>
+#include <apr_global_mutex.h>
+#include <apr_shm.h>
+#include <apr_mmap.h>
 
 #include "svn_pools.h"
 #include "svn_checksum.h"
+#include "svn_dirent_uri.h"
 #include "svn_private_config.h"
 #include "svn_hash.h"
+#include "svn_io.h"
 #include "svn_string.h"
 #include "svn_sorts.h"  /* get the MIN macro */
 
 #include "private/svn_atomic.h"
 #include "private/svn_dep_compat.h"
+#include "private/svn_metrics.h"
 #include "private/svn_mutex.h"
 #include "private/svn_subr_private.h"
 #include "private/svn_string_private.h"
@@ -63,8 +69,22 @@
  * Only the start address of these two data parts are given as a native
  * pointer. All other references are expressed as offsets to these pointers.
  * With that design, it is relatively easy to share the same data structure
- * between different processes and / or to persist them on disk. These
- * out-of-process features have not been implemented, yet.
+ * between different processes and / or to persist them on disk.
+ *
+ * Sharing between processes is supported for the pre-fork model, i.e. the
+ * cache gets created in a parent process before it forks its workers.  All
+ * segment data then lives in an anonymous shared memory block that gets
+ * inherited at the same address by every child, and segment access gets
+ * serialized by an APR global mutex instead of a thread-local lock.  The
+ * prefix pool is process-local and will therefore be disabled in that mode
+ * such that all entries carry their full keys.
+ *
+ * Process-local caches may get a third level (L3) that lives in a memory-
+ * mapped file, typically on a local SSD.  It is a plain circular buffer
+ * shared by all segments with its own, lossy index.  Items evicted from L1
+ * and L2 get copied to that file unless they have low priority; membuffer
+ * misses will be looked up there and get promoted back into the membuffer.
+ * Hence, L3 holds the most recently evicted items.
  *
  * Superficially, cache levels are being used as usual: insertion happens
  * into L1 and evictions will promote items to L2.  But their whole point
@@ -146,6 +166,40 @@
 #  define USE_SIMPLE_MUTEX 0
 #endif
 
+/* Cross-process sharing of cache segments requires anonymous shared memory
+ * that survives fork() at the same address.
+ */
+#if APR_HAS_SHARED_MEMORY
+#  define USE_SHARED_MEMORY 1
+#else
+#  define USE_SHARED_MEMORY 0
+#endif
+
+/* Cache hits may be served without taking the segment lock (see
+ * read_optimistically).  That requires a full memory barrier, which we
+ * can only portably get from the compiler.  Debug builds keep using the
+ * locked path because they verify the entry tags.
+ */
+#if defined(__GNUC__) \
+    && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 7)) \
+    && !defined(SVN_DEBUG_CACHE_MEMBUFFER)
+#  define USE_OPTIMISTIC_READS 1
+#  define MEMORY_BARRIER() __atomic_thread_fence(__ATOMIC_SEQ_CST)
+#else
+#  define USE_OPTIMISTIC_READS 0
+#endif
+
+/* Number of attempts to read an entry optimistically before falling back
+ * to the locked path.
+ */
+#define OPTIMISTIC_READ_ATTEMPTS 2
+
+/* Partial getters work on a private copy of the item when reading without
+ * a lock.  Larger items use the locked path to not lose the zero-copy
+ * advantage of partial getters.
+ */
+#define OPTIMISTIC_PARTIAL_READ_LIMIT 0x4000
+
 /* For more efficient copy operations, let's align all data items properly.
  * Since we can't portably align pointers, this is rather the item size
  * granularity which ensures *relative* alignment within the cache - still
@@ -197,6 +251,26 @@
  */
 #define MAX_ITEM_SIZE ((apr_uint32_t)(0 - ITEM_ALIGNMENT))
 
+/* Counters in the access frequency sketch saturate at this value.  Like
+ * TinyLFU, we only need to tell "rarely" from "frequently" accessed.
+ */
+#define MAX_FREQUENCY 15
+
+/* Halve all counters in the access frequency sketch after this many
+ * accesses per counter, so the sketch reflects recent usage only.
+ */
+#define FREQUENCY_SAMPLE_FACTOR 10
+
+/* Number of index slots per bucket in the overflow (L3) index.
+ */
+#define OVERFLOW_BUCKET_SIZE 8
+
+/* Number of bytes in the overflow file per index slot.  Smaller items
+ * will be more likely to be dropped from the index before they get
+ * overwritten in the file.
+ */
+#define OVERFLOW_BYTES_PER_SLOT 0x4000
+
 /* We use this structure to identify cache entries. There cannot be two
  * entries with the same entry key. However unlikely, though, two different
  * full keys (see full_key_t) may have the same entry key.  That is a
@@ -692,6 +766,71 @@ typedef struct cache_level_t
 
 } cache_level_t;
 
+/* Header in front of every item in the overflow file (L3).  It gets
+ * followed by the item data as it is stored in the membuffer, i.e. the
+ * full key (if any) plus the serialized item.
+ */
+typedef struct overflow_header_t
+{
+  /* Identifies the item. */
+  entry_key_t key;
+
+  /* Size of the item data following this header. */
+  apr_uint64_t size;
+
+  /* Priority that the item had in the membuffer. */
+  apr_uint32_t priority;
+} overflow_header_t;
+
+/* Index entry for an item in the overflow file.
+ */
+typedef struct overflow_slot_t
+{
+  /* Fingerprint of the item's entry key. */
+  apr_uint64_t fingerprint[2];
+
+  /* Position of the item's header in the circular overflow file, counted
+   * from the first item ever written, i.e. not wrapped around.  Once the
+   * write position has moved beyond this value plus the file size, the
+   * item has been overwritten.
+   */
+  apr_uint64_t position;
+
+  /* Size of the item in the overflow file including its header.
+   * 0 for unused or invalidated slots.
+   */
+  apr_uint64_t size;
+} overflow_slot_t;
+
+/* The overflow cache level (L3).  One instance is being shared by all
+ * segments of a membuffer.  Access to it is serialized by its own MUTEX.
+ * If a segment lock is needed as well, it must be acquired first.
+ */
+typedef struct overflow_t
+{
+  /* The memory-mapped file contents, DATA_SIZE bytes. */
+  unsigned char *data;
+  apr_uint64_t data_size;
+
+  /* Position at which the next item will be written.  Never wraps
+   * around; take it modulo DATA_SIZE to get the file offset. */
+  apr_uint64_t write_position;
+
+  /* BUCKET_COUNT * OVERFLOW_BUCKET_SIZE index slots.  An item with the
+   * entry key K may only be found in bucket (K modulo BUCKET_COUNT). */
+  overflow_slot_t *slots;
+  apr_uint64_t bucket_count;
+
+  /* Serializes access to all members.  May be NULL. */
+  svn_mutex__t *mutex;
+
+  /* Number of membuffer misses served from L3. */
+  svn_metrics__t *hits;
+
+  /* Number of items written to L3. */
+  svn_metrics__t *writes;
+} overflow_t;
+
 /* The cache header structure.
  */
 struct svn_membuffer_t
@@ -767,6 +906,24 @@ struct svn_membuffer_t
    */
   cache_level_t l2;
 
+  /* Access frequency sketch, FREQUENCY_MASK+1 counters indexed by two
+   * hashes of the entry key each (see get_frequency_slots).  Every read
+   * access increments the counters of its key, whether it hits or not.
+   * Data that has been read only once recently, e.g. during a scan like
+   * "svnadmin dump", may then not evict frequently read data from L2.
+   * Purely heuristical information.  Updates are not synchronized.
+   */
+  unsigned char *frequencies;
+  apr_uint32_t frequency_mask;
+
+  /* Number of accesses recorded since the counters were last halved. */
+  apr_uint64_t frequency_samples;
+
+  /* The disk-based third cache level.  NULL if there is none.  Shared by
+   * all segments.
+   */
+  overflow_t *overflow;
+
 
   /* Number of used dictionary entries, i.e. number of cached items.
    * Purely statistical information that may be used for profiling only.
@@ -796,6 +953,13 @@ struct svn_membuffer_t
    */
   apr_uint64_t total_hits;
 
+  /* Total number of entries dropped to make room for new ones.
+   * Purely statistical information that may be used for profiling only.
+   * Updates are not synchronized and values may be nonsensicle on some
+   * platforms.
+   */
+  apr_uint64_t total_evictions;
+
 #if (APR_HAS_THREADS && USE_SIMPLE_MUTEX)
   /* A lock for intra-process synchronization to the cache, or NULL if
    * the cache's creator doesn't feel the cache needs to be
@@ -813,21 +977,100 @@ struct svn_membuffer_t
   svn_boolean_t allow_blocking_writes;
 #endif
 
+#if USE_SHARED_MEMORY
+  /* If not NULL, this segment lives in shared memory and this lock
+   * serializes all access to it across processes and threads.  LOCK
+   * will then be NULL.  Reads and writes use the same exclusive lock.
+   * The handle itself is process-local memory, so forked children can
+   * re-attach to the lock without affecting each other.
+   */
+  apr_global_mutex_t **shared_lock;
+
+  /* The file that SHARED_LOCK may be based upon, depending on the lock
+   * mechanism.  Needed to re-attach to the lock in child processes. */
+  const char *shared_lock_file;
+
+  /* Copy of ALLOW_BLOCKING_WRITES for the SHARED_LOCK case. */
+  svn_boolean_t shared_blocking_writes;
+#endif
+
   /* A write lock counter, must be either 0 or 1.
    * This one is only used in debug assertions to verify that you used
    * the correct multi-threading settings. */
   svn_atomic_t write_lock_count;
+
+  /* Change counter for lock-free readers.  Writers increment it right
+   * after acquiring the write lock and once more before releasing it.
+   * I.e. it is odd while the segment is being modified and any change
+   * of its value invalidates data read without holding the lock.
+   */
+  volatile svn_atomic_t generation;
+
+  /* If set, try reading entries without acquiring the lock first. */
+  svn_boolean_t optimistic_reads;
+
+  /* Number of lock-free read attempts that had to be retried because
+   * of concurrent modifications.
+   * Purely statistical information that may be used for profiling only.
+   * Updates are not synchronized and values may be nonsensicle on some
+   * platforms.
+   */
+  apr_uint64_t optimistic_retries;
+
+  /* Number of lookups resp. hits served without acquiring the lock.
+   * Concurrent lock-free readers bump them, so they must use atomics.
+   * Purely statistical information that may be used for profiling only.
+   */
+  volatile svn_atomic_t lock_free_reads;
+  volatile svn_atomic_t lock_free_hits;
 };
 
 /* Align integer VALUE to the next ITEM_ALIGNMENT boundary.
  */
 #define ALIGN_VALUE(value) (((value) + ITEM_ALIGNMENT-1) & -ITEM_ALIGNMENT)
 
+#if USE_SHARED_MEMORY
+/* Acquire the cross-process lock of the shared memory segment CACHE.
+ * If BLOCKING is not set and the lock is currently held by someone else,
+ * set *SUCCESS to FALSE; leave it untouched otherwise.
+ */
+static svn_error_t *
+lock_shared_segment(svn_membuffer_t *cache,
+                    svn_boolean_t blocking,
+                    svn_boolean_t *success)
+{
+  apr_status_t status;
+  if (blocking)
+    {
+      status = apr_global_mutex_lock(*cache->shared_lock);
+    }
+  else
+    {
+      status = apr_global_mutex_trylock(*cache->shared_lock);
+      if (SVN_LOCK_IS_BUSY(status))
+        {
+          *success = FALSE;
+          status = APR_SUCCESS;
+        }
+    }
+
+  if (status)
+    return svn_error_wrap_apr(status, _("Can't lock shared cache mutex"));
+
+  return SVN_NO_ERROR;
+}
+#endif
+
 /* If locking is supported for CACHE, acquire a read lock for it.
  */
 static svn_error_t *
 read_lock_cache(svn_membuffer_t *cache)
 {
+#if USE_SHARED_MEMORY
+  if (cache->shared_lock)
+    return lock_shared_segment(cache, TRUE, NULL);
+#endif
+
 #if (APR_HAS_THREADS && USE_SIMPLE_MUTEX)
   return svn_mutex__lock(cache->lock);
 #elif (APR_HAS_THREADS && !USE_SIMPLE_MUTEX)
@@ -851,6 +1094,12 @@ read_lock_cache(svn_membuffer_t *cache)
 static svn_error_t *
 write_lock_cache(svn_membuffer_t *cache, svn_boolean_t *success)
 {
+#if USE_SHARED_MEMORY
+  if (cache->shared_lock)
+    return lock_shared_segment(cache, cache->shared_blocking_writes,
+                               success);
+#endif
+
 #if (APR_HAS_THREADS && USE_SIMPLE_MUTEX)
   return svn_mutex__lock(cache->lock);
 #elif (APR_HAS_THREADS && !USE_SIMPLE_MUTEX)
@@ -888,6 +1137,11 @@ write_lock_cache(svn_membuffer_t *cache, svn_boolean_t *success)
 static svn_error_t *
 force_write_lock_cache(svn_membuffer_t *cache)
 {
+#if USE_SHARED_MEMORY
+  if (cache->shared_lock)
+    return lock_shared_segment(cache, TRUE, NULL);
+#endif
+
 #if (APR_HAS_THREADS && USE_SIMPLE_MUTEX)
   return svn_mutex__lock(cache->lock);
 #elif (APR_HAS_THREADS && !USE_SIMPLE_MUTEX)
@@ -908,6 +1162,21 @@ force_write_lock_cache(svn_membuffer_t *cache)
 static svn_error_t *
 unlock_cache(svn_membuffer_t *cache, svn_error_t *err)
 {
+#if USE_SHARED_MEMORY
+  if (cache->shared_lock)
+    {
+      apr_status_t status = apr_global_mutex_unlock(*cache->shared_lock);
+      if (err)
+        return err;
+
+      if (status)
+        return svn_error_wrap_apr(status,
+                                  _("Can't unlock shared cache mutex"));
+
+      return SVN_NO_ERROR;
+    }
+#endif
+
 #if (APR_HAS_THREADS && USE_SIMPLE_MUTEX)
   return svn_mutex__unlock(cache->lock, err);
 #elif (APR_HAS_THREADS && !USE_SIMPLE_MUTEX)
@@ -936,6 +1205,24 @@ do {                                        \
   SVN_ERR(unlock_cache(cache, (expr)));     \
 } while (0)
 
+/* Mark CACHE as being modified, i.e. invalidate all concurrent lock-free
+ * reads.  Must be called while holding the write lock.
+ */
+static APR_INLINE void
+begin_modification(svn_membuffer_t *cache)
+{
+  svn_atomic_inc(&cache->generation);
+}
+
+/* Counterpart to begin_modification.  Return ERR.
+ */
+static APR_INLINE svn_error_t *
+end_modification(svn_membuffer_t *cache, svn_error_t *err)
+{
+  svn_atomic_inc(&cache->generation);
+  return err;
+}
+
 /* If supported, guard the execution of EXPR with a write lock to CACHE.
  * The macro has been modeled after SVN_MUTEX__WITH_LOCK.
  *
@@ -959,7 +1246,9 @@ do {                                                            \
       else                                                      \
         break;                                                  \
     }                                                           \
-  SVN_ERR(unlock_cache(cache, (expr)));                         \
+  begin_modification(cache);                                    \
+  SVN_ERR(unlock_cache(cache,                                   \
+                       end_modification(cache, (expr))));       \
 } while (0)
 
 /* Returns 0 if the entry group identified by GROUP_INDEX in CACHE has not
@@ -1365,6 +1654,65 @@ let_entry_age(svn_membuffer_t *cache, entry_t *entry)
     }
 }
 
+/* Set *FIRST and *SECOND to the indexes of the counters for KEY in the
+ * access frequency sketch of CACHE.  The group index and segment depend
+ * on the key fingerprint in a different way.
+ */
+static APR_INLINE void
+get_frequency_slots(apr_uint32_t *first,
+                    apr_uint32_t *second,
+                    const svn_membuffer_t *cache,
+                    const entry_key_t *key)
+{
+  *first = (apr_uint32_t)((key->fingerprint[0]
+                           * APR_UINT64_C(0x9E3779B97F4A7C15)) >> 32)
+         & cache->frequency_mask;
+  *second = (apr_uint32_t)((key->fingerprint[1]
+                            * APR_UINT64_C(0xC2B2AE3D27D4EB4F)) >> 32)
+          & cache->frequency_mask;
+}
+
+/* Record a read access to the item identified by KEY in the frequency
+ * sketch of CACHE.  This may be called without holding the lock.
+ */
+static void
+record_access(svn_membuffer_t *cache,
+              const entry_key_t *key)
+{
+  apr_uint32_t first, second;
+
+  get_frequency_slots(&first, &second, cache, key);
+  if (cache->frequencies[first] < MAX_FREQUENCY)
+    cache->frequencies[first]++;
+  if (cache->frequencies[second] < MAX_FREQUENCY)
+    cache->frequencies[second]++;
+
+  /* Let old accesses fade such that recent ones dominate. */
+  if (++cache->frequency_samples / FREQUENCY_SAMPLE_FACTOR
+      > cache->frequency_mask)
+    {
+      apr_size_t i;
+      for (i = 0; i <= cache->frequency_mask; ++i)
+        cache->frequencies[i] >>= 1;
+
+      cache->frequency_samples = 0;
+    }
+}
+
+/* Return the estimated number of recent read accesses to the item
+ * identified by KEY in CACHE.  This may overestimate but never
+ * underestimates the actual number (ignoring aging and saturation).
+ */
+static apr_uint32_t
+estimate_frequency(const svn_membuffer_t *cache,
+                   const entry_key_t *key)
+{
+  apr_uint32_t first, second;
+
+  get_frequency_slots(&first, &second, cache, key);
+  return MIN(cache->frequencies[first], cache->frequencies[second]);
+}
+
 /* Return whether the keys in LHS and RHS match.
  */
 static svn_boolean_t
@@ -1377,6 +1725,301 @@ entry_keys_match(const entry_key_t *lhs,
       && (lhs->key_len == rhs->key_len);
 }
 
+/* Return the number of bytes that an item of SIZE bytes occupies in the
+ * overflow file, including its header.
+ */
+static APR_INLINE apr_uint64_t
+overflow_record_size(apr_uint64_t size)
+{
+  return ALIGN_VALUE(sizeof(overflow_header_t)) + ALIGN_VALUE(size);
+}
+
+/* Return the first index slot of the bucket in OVERFLOW that may contain
+ * the item identified by KEY.
+ */
+static APR_INLINE overflow_slot_t *
+overflow_bucket(overflow_t *overflow,
+                const entry_key_t *key)
+{
+  return overflow->slots
+       + (key->fingerprint[0] % overflow->bucket_count)
+         * OVERFLOW_BUCKET_SIZE;
+}
+
+/* Return the number of bytes written to OVERFLOW after the item indexed
+ * by SLOT.  Unused slots and those whose item has already been overwritten
+ * will return APR_UINT64_MAX.
+ */
+static apr_uint64_t
+overflow_slot_age(const overflow_t *overflow,
+                  const overflow_slot_t *slot)
+{
+  apr_uint64_t age = overflow->write_position - slot->position;
+  return (slot->size && age <= overflow->data_size) ? age : APR_UINT64_MAX;
+}
+
+/* Return the header of the item in OVERFLOW that is identified by TO_FIND
+ * and set *SLOT_P to its index slot.  Return NULL if there is no such item.
+ *
+ * Note: This function requires the caller to hold OVERFLOW->MUTEX.
+ */
+static overflow_header_t *
+overflow_find(overflow_slot_t **slot_p,
+              overflow_t *overflow,
+              const full_key_t *to_find)
+{
+  overflow_slot_t *bucket = overflow_bucket(overflow, &to_find->entry_key);
+  int i;
+
+  for (i = 0; i < OVERFLOW_BUCKET_SIZE; ++i)
+    {
+      overflow_slot_t *slot = &bucket[i];
+      overflow_header_t *header;
+
+      if (   slot->fingerprint[0] != to_find->entry_key.fingerprint[0]
+          || slot->fingerprint[1] != to_find->entry_key.fingerprint[1]
+          || overflow_slot_age(overflow, slot) == APR_UINT64_MAX)
+        continue;
+
+      /* Key conflict?  Then, the item cannot be anywhere else. */
+      header = (overflow_header_t *)
+               (overflow->data + slot->position % overflow->data_size);
+      if (!entry_keys_match(&header->key, &to_find->entry_key))
+        return NULL;
+
+      if (   header->key.key_len
+          && memcmp(to_find->full_key.data,
+                    (char *)header + ALIGN_VALUE(sizeof(*header)),
+                    header->key.key_len) != 0)
+        return NULL;
+
+      *slot_p = slot;
+      return header;
+    }
+
+  return NULL;
+}
+
+/* Copy the item ENTRY with the given DATA (full key plus serialized item)
+ * to OVERFLOW.  Items that are still present in OVERFLOW will not be
+ * written again; they cannot have changed since any modification removes
+ * them from OVERFLOW.
+ *
+ * Note: This function requires the caller to hold OVERFLOW->MUTEX.
+ */
+static void
+overflow_store(overflow_t *overflow,
+               const entry_t *entry,
+               const unsigned char *data)
+{
+  overflow_slot_t *bucket = overflow_bucket(overflow, &entry->key);
+  overflow_slot_t *slot = NULL;
+  overflow_header_t *header;
+  apr_uint64_t record_size = overflow_record_size(entry->size);
+  apr_uint64_t position = overflow->write_position;
+  apr_uint64_t offset;
+  int i;
+
+  /* Don't let single items wipe large parts of the file. */
+  if (record_size > overflow->data_size / 4)
+    return;
+
+  /* Re-use the slot for the same key or replace the oldest one. */
+  for (i = 0; i < OVERFLOW_BUCKET_SIZE; ++i)
+    {
+      overflow_slot_t *candidate = &bucket[i];
+      if (   candidate->fingerprint[0] == entry->key.fingerprint[0]
+          && candidate->fingerprint[1] == entry->key.fingerprint[1])
+        {
+          if (overflow_slot_age(overflow, candidate) != APR_UINT64_MAX)
+            return;
+
+          slot = candidate;
+          break;
+        }
+
+      if (   slot == NULL
+          || (  overflow_slot_age(overflow, candidate)
+              > overflow_slot_age(overflow, slot)))
+        slot = candidate;
+    }
+
+  /* Items don't wrap around the end of the file. */
+  offset = position % overflow->data_size;
+  if (offset + record_size > overflow->data_size)
+    {
+      position += overflow->data_size - offset;
+      offset = 0;
+    }
+
+  header = (overflow_header_t *)(overflow->data + offset);
+  header->key = entry->key;
+  header->size = entry->size;
+  header->priority = entry->priority;
+  memcpy((char *)header + ALIGN_VALUE(sizeof(*header)), data, entry->size);
+
+  overflow->write_position = position + record_size;
+
+  slot->fingerprint[0] = entry->key.fingerprint[0];
+  slot->fingerprint[1] = entry->key.fingerprint[1];
+  slot->position = position;
+  slot->size = record_size;
+
+  svn_metrics__add(overflow->writes, 1);
+}
+
+/* Before ENTRY gets evicted from CACHE, copy it to the overflow file of
+ * CACHE, if there is one.  Low-priority data is not worth the I/O.
+ *
+ * Note: This function requires the caller to hold the write lock.
+ */
+static void
+spill_entry(svn_membuffer_t *cache,
+            const entry_t *entry)
+{
+  overflow_t *overflow = cache->overflow;
+  svn_error_t *err;
+
+  if (!overflow || entry->priority <= SVN_CACHE__MEMBUFFER_LOW_PRIORITY)
+    return;
+
+  /* Not being able to keep a copy is not an error. */
+  err = svn_mutex__lock(overflow->mutex);
+  if (err)
+    {
+      svn_error_clear(err);
+      return;
+    }
+
+  overflow_store(overflow, entry, cache->data + entry->offset);
+  svn_error_clear(svn_mutex__unlock(overflow->mutex, SVN_NO_ERROR));
+}
+
+/* Remove the item identified by TO_FIND from OVERFLOW, if it is present.
+ *
+ * Note: This function requires the caller to hold OVERFLOW->MUTEX.
+ * Don't call it directly, call overflow_remove instead.
+ */
+static svn_error_t *
+overflow_remove_internal(overflow_t *overflow,
+                         const full_key_t *to_find)
+{
+  overflow_slot_t *bucket = overflow_bucket(overflow, &to_find->entry_key);
+  int i;
+
+  /* Remove key conflicts as well.  That is cheaper than comparing keys. */
+  for (i = 0; i < OVERFLOW_BUCKET_SIZE; ++i)
+    if (   bucket[i].fingerprint[0] == to_find->entry_key.fingerprint[0]
+        && bucket[i].fingerprint[1] == to_find->entry_key.fingerprint[1])
+      bucket[i].size = 0;
+
+  return SVN_NO_ERROR;
+}
+
+/* Remove the item identified by KEY from OVERFLOW, e.g. because it is
+ * about to be modified.  OVERFLOW may be NULL.
+ */
+static svn_error_t *
+overflow_remove(overflow_t *overflow,
+                const full_key_t *key)
+{
+  if (overflow)
+    SVN_MUTEX__WITH_LOCK(overflow->mutex,
+                         overflow_remove_internal(overflow, key));
+
+  return SVN_NO_ERROR;
+}
+
+/* Look for the item identified by TO_FIND in OVERFLOW.  If it is not
+ * present, set *BUFFER to NULL.  Otherwise, return a copy of the
+ * serialized item in *BUFFER, its size in *ITEM_SIZE, its priority in
+ * *PRIORITY and its position within OVERFLOW in *POSITION.  Allocate the
+ * copy in RESULT_POOL.
+ *
+ * Note: This function requires the caller to hold OVERFLOW->MUTEX.
+ * Don't call it directly, call read_overflow instead.
+ */
+static svn_error_t *
+overflow_get_internal(overflow_t *overflow,
+                      const full_key_t *to_find,
+                      char **buffer,
+                      apr_size_t *item_size,
+                      apr_uint32_t *priority,
+                      apr_uint64_t *position,
+                      apr_pool_t *result_pool)
+{
+  overflow_slot_t *slot;
+  overflow_header_t *header = overflow_find(&slot, overflow, to_find);
+  const char *data;
+  apr_size_t size;
+
+  if (header == NULL)
+    {
+      *buffer = NULL;
+      return SVN_NO_ERROR;
+    }
+
+  /* Allocate the padding as well, like membuffer_cache_get_internal. */
+  data = (const char *)header + ALIGN_VALUE(sizeof(*header))
+       + header->key.key_len;
+  size = (apr_size_t)(header->size - header->key.key_len);
+  *buffer = apr_palloc(result_pool, ALIGN_VALUE(size));
+  memcpy(*buffer, data, size);
+
+  *item_size = size;
+  *priority = header->priority;
+  *position = slot->position;
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *UNCHANGED to whether the item identified by TO_FIND is still at
+ * POSITION in OVERFLOW, i.e. whether it has not been modified since.
+ *
+ * Note: This function requires the caller to hold OVERFLOW->MUTEX.
+ */
+static svn_error_t *
+overflow_check_internal(svn_boolean_t *unchanged,
+                        overflow_t *overflow,
+                        const full_key_t *to_find,
+                        apr_uint64_t position)
+{
+  overflow_slot_t *slot;
+  *unchanged = overflow_find(&slot, overflow, to_find)
+            && slot->position == position;
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *FOUND to whether OVERFLOW contains the item identified by TO_FIND.
+ *
+ * Note: This function requires the caller to hold OVERFLOW->MUTEX.
+ */
+static svn_error_t *
+overflow_has_key_internal(svn_boolean_t *found,
+                          overflow_t *overflow,
+                          const full_key_t *to_find)
+{
+  overflow_slot_t *slot;
+  *found = overflow_find(&slot, overflow, to_find) != NULL;
+
+  return SVN_NO_ERROR;
+}
+
+/* Forget about all items in OVERFLOW.
+ *
+ * Note: This function requires the caller to hold OVERFLOW->MUTEX.
+ */
+static svn_error_t *
+overflow_clear_internal(overflow_t *overflow)
+{
+  memset(overflow->slots, 0,
+         overflow->bucket_count * OVERFLOW_BUCKET_SIZE
+                                * sizeof(*overflow->slots));
+
+  return SVN_NO_ERROR;
+}
+
 /* Given the GROUP_INDEX that shall contain an entry with the hash key
  * TO_FIND, find that entry in the specified group.
  *
@@ -1538,6 +2181,7 @@ find_entry(svn_membuffer_t *cache,
             if (entry != &to_shrink->entries[i])
               let_entry_age(cache, &to_shrink->entries[i]);
 
+          spill_entry(cache, entry);
           drop_entry(cache, entry);
         }
 
@@ -1622,7 +2266,8 @@ promote_entry(svn_membuffer_t *cache, entry_t *entry)
  * If necessary, enlarge the insertion window of CACHE->L2 until it is at
  * least TO_FIT_IN->SIZE bytes long. TO_FIT_IN->SIZE must not exceed the
  * data buffer size allocated to CACHE->L2.  IDX is the item index of
- * TO_FIT_IN and is given for performance reasons.
+ * TO_FIT_IN and is given for performance reasons.  The access frequency
+ * of TO_FIT_IN->KEY decides over entries that are being used more often.
  *
  * Return TRUE if enough room could be found or made.  A FALSE result
  * indicates that the respective item shall not be added.
@@ -1650,6 +2295,9 @@ ensure_data_insertable_l2(svn_membuffer_t *cache,
   apr_uint64_t drop_hits_limit = (to_fit_in->hit_count + 1)
                                * (apr_uint64_t)to_fit_in->priority;
 
+  /* how often the new entry has been asked for recently */
+  apr_uint32_t frequency = estimate_frequency(cache, &to_fit_in->key);
+
   /* This loop will eventually terminate because every cache entry
    * would get dropped eventually:
    *
@@ -1735,7 +2383,18 @@ ensure_data_insertable_l2(svn_membuffer_t *cache,
                    : entry->priority > to_fit_in->priority;
             }
 
-          /* keepers or destroyers? */
+          /* Admission control (similar to TinyLFU):  An entry that is
+           * being asked for more frequently than the new one most likely
+           * holds hot data.  Don't replace it with e.g. data that passes
+           * through the cache only once during a scan, no matter what
+           * the priorities are.  Moving it still costs and lets it age.
+           */
+          if (   !keep
+              && entry->priority > SVN_CACHE__MEMBUFFER_LOW_PRIORITY
+              && estimate_frequency(cache, &entry->key) > frequency)
+            keep = TRUE;
+
+          /* keepers or destroyers? */
           if (keep)
             {
               /* Moving entries around is not for free -> track costs. */
@@ -1755,7 +2414,9 @@ ensure_data_insertable_l2(svn_membuffer_t *cache,
               if (entry->priority > SVN_CACHE__MEMBUFFER_LOW_PRIORITY)
                 drop_hits += entry->hit_count * (apr_uint64_t)entry->priority;
 
+              spill_entry(cache, entry);
               drop_entry(cache, entry);
+              cache->total_evictions++;
             }
         }
     }
@@ -1823,7 +2484,11 @@ ensure_data_insertable_l1(svn_membuffer_t *cache, apr_size_t size)
               if (keep)
                 promote_entry(cache, entry);
               else
-                drop_entry(cache, entry);
+                {
+                  spill_entry(cache, entry);
+                  drop_entry(cache, entry);
+                  cache->total_evictions++;
+                }
             }
         }
     }
@@ -1839,24 +2504,45 @@ svn_cache__membuffer_cache_create(svn_membuffer_t **cache,
                                   apr_size_t segment_count,
                                   svn_boolean_t thread_safe,
                                   svn_boolean_t allow_blocking_writes,
+                                  svn_boolean_t shared_memory,
                                   apr_pool_t *pool)
 {
   svn_membuffer_t *c;
   prefix_pool_t *prefix_pool;
 
+  /* If not NULL, the next unused byte in the shared memory block. */
+  char *shm_base = NULL;
+
+  /* Common prefix of the lock file names of the shared segments. */
+  const char *lock_file_base = NULL;
+
+  /* Segment-local thread synchronization is not needed in shared memory
+   * mode because the cross-process locks cover threads as well. */
+  svn_boolean_t thread_local_locks = thread_safe && !shared_memory;
+
   apr_uint32_t seg;
   apr_uint32_t group_count;
   apr_uint32_t main_group_count;
   apr_uint32_t spare_group_count;
   apr_uint32_t group_init_size;
+  apr_uint32_t frequency_count;
   apr_uint64_t data_size;
   apr_uint64_t max_entry_size;
 
   /* Allocate 1% of the cache capacity to the prefix string pool.
+   * Prefix indexes are only valid within the process that assigned them.
+   * So, don't share prefixes when the data lives in shared memory.
    */
-  SVN_ERR(prefix_pool_create(&prefix_pool, total_size / 100, thread_safe,
-                             pool));
-  total_size -= total_size / 100;
+  if (shared_memory)
+    {
+      SVN_ERR(prefix_pool_create(&prefix_pool, 0, thread_safe, pool));
+    }
+  else
+    {
+      SVN_ERR(prefix_pool_create(&prefix_pool, total_size / 100,
+                                 thread_safe, pool));
+      total_size -= total_size / 100;
+    }
 
   /* Limit the total size (only relevant if we can address > 4GB)
    */
@@ -1910,9 +2596,6 @@ svn_cache__membuffer_cache_create(svn_membuffer_t **cache,
          && segment_count < MAX_SEGMENT_COUNT)
     segment_count *= 2;
 
-  /* allocate cache as an array of segments / cache objects */
-  c = apr_palloc(pool, segment_count * sizeof(*c));
-
   /* Split total cache size into segments of equal size
    */
   total_size /= segment_count;
@@ -1963,6 +2646,55 @@ svn_cache__membuffer_cache_create(svn_membuffer_t **cache,
   assert(spare_group_count > 0 && main_group_count > 0);
 
   group_init_size = 1 + group_count / (8 * GROUP_INIT_GRANULARITY);
+
+  /* One frequency counter (byte) per entry the directory can hold.
+   * The sketch needs a power of two counters. */
+  frequency_count = 64;
+  while (   frequency_count < main_group_count * (apr_uint64_t)GROUP_SIZE
+         && frequency_count < APR_UINT32_MAX / 2 + 1)
+    frequency_count *= 2;
+
+  /* allocate cache as an array of segments / cache objects */
+  if (shared_memory)
+    {
+#if USE_SHARED_MEMORY
+      /* Allocate one block for all segment headers and their buffers.
+       * Anonymous shared memory is zero-initialized and will be inherited
+       * by all child processes at the same address. */
+      apr_shm_t *shm;
+      apr_status_t status;
+      apr_size_t shm_size
+        = ALIGN_VALUE(segment_count * sizeof(*c))
+        + segment_count * (  ALIGN_VALUE(group_count * sizeof(entry_group_t))
+                           + ALIGN_VALUE(group_init_size)
+                           + ALIGN_VALUE(frequency_count)
+                           + (apr_size_t)ALIGN_VALUE(data_size));
+
+      status = apr_shm_create(&shm, shm_size, NULL, pool);
+      if (status)
+        return svn_error_wrap_apr(status,
+                                  _("Can't create shared memory cache"));
+
+      shm_base = apr_shm_baseaddr_get(shm);
+      c = (svn_membuffer_t *)shm_base;
+      shm_base += ALIGN_VALUE(segment_count * sizeof(*c));
+
+      /* Reserve a unique name for the lock files.  Depending on the
+       * mechanism, APR creates and removes the actual files. */
+      SVN_ERR(svn_io_open_unique_file3(NULL, &lock_file_base, NULL,
+                                       svn_io_file_del_on_pool_cleanup,
+                                       pool, pool));
+#else
+      return svn_error_create(SVN_ERR_UNSUPPORTED_FEATURE, NULL,
+                              _("Shared memory caches are not supported "
+                                "on this platform"));
+#endif
+    }
+  else
+    {
+      c = apr_palloc(pool, segment_count * sizeof(*c));
+    }
+
   for (seg = 0; seg < segment_count; ++seg)
     {
       /* allocate buffers and initialize cache members
@@ -1975,15 +2707,41 @@ svn_cache__membuffer_cache_create(svn_membuffer_t **cache,
       c[seg].first_spare_group = NO_INDEX;
       c[seg].max_spare_used = 0;
 
-      /* Allocate but don't clear / zero the directory because it would add
-         significantly to the server start-up time if the caches are large.
-         Group initialization will take care of that in stead. */
-      c[seg].directory = apr_palloc(pool,
-                                    group_count * sizeof(entry_group_t));
+      if (shm_base)
+        {
+          /* Carve the buffers from the shared memory block. */
+          c[seg].directory = (entry_group_t *)shm_base;
+          shm_base += ALIGN_VALUE(group_count * sizeof(entry_group_t));
+
+          c[seg].group_initialized = (unsigned char *)shm_base;
+          memset(c[seg].group_initialized, 0, group_init_size);
+          shm_base += ALIGN_VALUE(group_init_size);
+
+          c[seg].frequencies = (unsigned char *)shm_base;
+          memset(c[seg].frequencies, 0, frequency_count);
+          shm_base += ALIGN_VALUE(frequency_count);
+
+          c[seg].data = (unsigned char *)shm_base;
+          shm_base += (apr_size_t)ALIGN_VALUE(data_size);
+        }
+      else
+        {
+          /* Allocate but don't clear / zero the directory because it would
+             add significantly to the server start-up time if the caches are
+             large.  Group initialization will take care of that in stead. */
+          c[seg].directory = apr_palloc(pool,
+                                        group_count * sizeof(entry_group_t));
+
+          /* Allocate and initialize directory entries as "not initialized",
+             hence "unused" */
+          c[seg].group_initialized = apr_pcalloc(pool, group_init_size);
+
+          /* No accesses recorded, yet. */
+          c[seg].frequencies = apr_pcalloc(pool, frequency_count);
 
-      /* Allocate and initialize directory entries as "not initialized",
-         hence "unused" */
-      c[seg].group_initialized = apr_pcalloc(pool, group_init_size);
+          /* This cast is safe because DATA_SIZE <= MAX_SEGMENT_SIZE. */
+          c[seg].data = apr_palloc(pool, (apr_size_t)ALIGN_VALUE(data_size));
+        }
 
       /* Allocate 1/4th of the data buffer to L1
        */
@@ -2003,8 +2761,12 @@ svn_cache__membuffer_cache_create(svn_membuffer_t **cache,
       c[seg].l2.size = ALIGN_VALUE(data_size) - c[seg].l1.size;
       c[seg].l2.current_data = c[seg].l2.start_offset;
 
-      /* This cast is safe because DATA_SIZE <= MAX_SEGMENT_SIZE. */
-      c[seg].data = apr_palloc(pool, (apr_size_t)ALIGN_VALUE(data_size));
+      c[seg].frequency_mask = frequency_count - 1;
+      c[seg].frequency_samples = 0;
+
+      /* L3 may get attached later. */
+      c[seg].overflow = NULL;
+
       c[seg].data_used = 0;
       c[seg].max_entry_size = max_entry_size;
 
@@ -2012,11 +2774,13 @@ svn_cache__membuffer_cache_create(svn_membuffer_t **cache,
       c[seg].total_reads = 0;
       c[seg].total_writes = 0;
       c[seg].total_hits = 0;
+      c[seg].total_evictions = 0;
 
       /* were allocations successful?
        * If not, initialize a minimal cache structure.
        */
-      if (c[seg].data == NULL || c[seg].directory == NULL)
+      if (   c[seg].data == NULL || c[seg].directory == NULL
+          || c[seg].frequencies == NULL)
         {
           /* We are OOM. There is no need to proceed with "half a cache".
            */
@@ -2028,11 +2792,11 @@ svn_cache__membuffer_cache_create(svn_membuffer_t **cache,
        * the cache's creator doesn't feel the cache needs to be
        * thread-safe.
        */
-      SVN_ERR(svn_mutex__init(&c[seg].lock, thread_safe, pool));
+      SVN_ERR(svn_mutex__init(&c[seg].lock, thread_local_locks, pool));
 #elif (APR_HAS_THREADS && !USE_SIMPLE_MUTEX)
       /* Same for read-write lock. */
       c[seg].lock = NULL;
-      if (thread_safe)
+      if (thread_local_locks)
         {
           apr_status_t status =
               apr_thread_rwlock_create(&(c[seg].lock), pool);
@@ -2043,9 +2807,39 @@ svn_cache__membuffer_cache_create(svn_membuffer_t **cache,
       /* Select the behavior of write operations.
        */
       c[seg].allow_blocking_writes = allow_blocking_writes;
+#endif
+#if USE_SHARED_MEMORY
+      /* Cross-process lock for shared memory segments.  Child processes
+       * inherit it together with the segment itself but must re-attach
+       * to it using svn_cache__membuffer_child_init(). */
+      c[seg].shared_lock = NULL;
+      c[seg].shared_lock_file = NULL;
+      c[seg].shared_blocking_writes = allow_blocking_writes;
+      if (shared_memory)
+        {
+          apr_status_t status;
+
+          c[seg].shared_lock_file = apr_psprintf(pool, "%s.%u",
+                                                 lock_file_base, seg);
+          c[seg].shared_lock = apr_pcalloc(pool,
+                                           sizeof(*c[seg].shared_lock));
+          status = apr_global_mutex_create(c[seg].shared_lock,
+                                           c[seg].shared_lock_file,
+                                           APR_LOCK_DEFAULT, pool);
+          if (status)
+            return svn_error_wrap_apr(status,
+                                      _("Can't create shared cache mutex"));
+        }
 #endif
       /* No writers at the moment. */
       c[seg].write_lock_count = 0;
+
+      /* Lock-free reads only make sense if there is a lock to avoid. */
+      c[seg].generation = 0;
+      c[seg].optimistic_reads = thread_safe;
+      c[seg].optimistic_retries = 0;
+      c[seg].lock_free_reads = 0;
+      c[seg].lock_free_hits = 0;
     }
 
   /* done here
@@ -2078,6 +2872,7 @@ svn_cache__membuffer_clear(svn_membuffer_t *cache)
     {
       /* Unconditionally acquire the write lock. */
       SVN_ERR(force_write_lock_cache(&cache[seg]));
+      begin_modification(&cache[seg]);
 
       /* Mark all groups as "not initialized", which implies "empty". */
       cache[seg].first_spare_group = NO_INDEX;
@@ -2101,14 +2896,129 @@ svn_cache__membuffer_clear(svn_membuffer_t *cache)
       cache[seg].data_used = 0;
       cache[seg].used_entries = 0;
 
+      /* Forget about past accesses. */
+      memset(cache[seg].frequencies, 0, cache[seg].frequency_mask + 1);
+      cache[seg].frequency_samples = 0;
+
       /* Segment may be used again. */
-      SVN_ERR(unlock_cache(&cache[seg], SVN_NO_ERROR));
+      SVN_ERR(unlock_cache(&cache[seg],
+                           end_modification(&cache[seg], SVN_NO_ERROR)));
     }
 
+  /* Forget the contents of L3 as well. */
+  if (cache->overflow)
+    SVN_MUTEX__WITH_LOCK(cache->overflow->mutex,
+                         overflow_clear_internal(cache->overflow));
+
   /* done here */
   return SVN_NO_ERROR;
 }
 
+svn_error_t *
+svn_cache__membuffer_child_init(svn_membuffer_t *cache,
+                                apr_pool_t *pool)
+{
+#if USE_SHARED_MEMORY
+  apr_uint32_t seg;
+
+  if (!cache->shared_lock)
+    return SVN_NO_ERROR;
+
+  for (seg = 0; seg < cache->segment_count; ++seg)
+    {
+      svn_membuffer_t *segment = &cache[seg];
+      apr_status_t status
+        = apr_global_mutex_child_init(segment->shared_lock,
+                                      segment->shared_lock_file, pool);
+      if (status)
+        return svn_error_wrap_apr(status,
+                                  _("Can't attach to shared cache mutex"));
+    }
+#endif
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_cache__membuffer_attach_overflow(svn_membuffer_t *cache,
+                                     const char *dir_path,
+                                     apr_uint64_t size,
+                                     svn_boolean_t thread_safe,
+                                     apr_pool_t *result_pool)
+{
+#if APR_HAS_MMAP
+  overflow_t *overflow;
+  apr_file_t *file;
+  const char *path;
+  apr_mmap_t *mmap;
+  apr_status_t status;
+  apr_uint32_t seg;
+
+#if USE_SHARED_MEMORY
+  /* Our index is process-local. */
+  if (cache->shared_lock)
+    return svn_error_create(SVN_ERR_UNSUPPORTED_FEATURE, NULL,
+                            _("Caches in shared memory can't overflow "
+                              "to disk"));
+#endif
+
+  /* The whole file gets mapped into our address space. */
+  size = MIN(size, (apr_uint64_t)SVN_MAX_OBJECT_SIZE / 2);
+  size -= size % ITEM_ALIGNMENT;
+  if (size < MIN_SEGMENT_SIZE)
+    return svn_error_createf(SVN_ERR_INCORRECT_PARAMS, NULL,
+                             _("Cache overflow file size must be at least "
+                               "%" APR_UINT64_T_FMT " bytes"),
+                             MIN_SEGMENT_SIZE);
+
+  overflow = apr_pcalloc(result_pool, sizeof(*overflow));
+  overflow->data_size = size;
+  overflow->bucket_count = MAX(size / OVERFLOW_BYTES_PER_SLOT
+                                    / OVERFLOW_BUCKET_SIZE, 1);
+  overflow->slots = apr_pcalloc(result_pool,
+                                (apr_size_t)overflow->bucket_count
+                                  * OVERFLOW_BUCKET_SIZE
+                                  * sizeof(*overflow->slots));
+  if (overflow->slots == NULL)
+    return svn_error_wrap_apr(APR_ENOMEM, "OOM");
+
+  /* Contents of the file don't survive the process, so neither does the
+   * file itself.  Its size will typically exceed the physical memory.
+   * Don't actually allocate the space before it is being used. */
+  SVN_ERR(svn_io_open_unique_file3(&file, &path, dir_path,
+                                   svn_io_file_del_on_pool_cleanup,
+                                   result_pool, result_pool));
+  SVN_ERR(svn_io_file_trunc(file, (apr_off_t)size, result_pool));
+
+  status = apr_mmap_create(&mmap, file, 0, (apr_size_t)size,
+                           APR_MMAP_READ | APR_MMAP_WRITE, result_pool);
+  if (status)
+    return svn_error_wrap_apr(status, _("Can't map cache file '%s'"),
+                              svn_dirent_local_style(path, result_pool));
+
+  overflow->data = mmap->mm;
+  SVN_ERR(svn_mutex__init(&overflow->mutex, thread_safe, result_pool));
+
+  overflow->hits
+    = svn_metrics__counter("svn_cache_overflow_hits_total", NULL,
+                           "Membuffer cache misses served from the "
+                           "overflow file");
+  overflow->writes
+    = svn_metrics__counter("svn_cache_overflow_writes_total", NULL,
+                           "Items evicted from the membuffer cache and "
+                           "written to its overflow file");
+
+  for (seg = 0; seg < cache->segment_count; ++seg)
+    cache[seg].overflow = overflow;
+
+  return SVN_NO_ERROR;
+#else
+  return svn_error_create(SVN_ERR_UNSUPPORTED_FEATURE, NULL,
+                          _("Cache overflow files are not supported "
+                            "on this platform"));
+#endif
+}
+
 /* Look for the cache entry in group GROUP_INDEX of CACHE, identified
  * by the hash value TO_FIND and set *FOUND accordingly.
  *
@@ -2143,12 +3053,13 @@ entry_exists(svn_membuffer_t *cache,
   return SVN_NO_ERROR;
 }
 
-/* Given the SIZE and PRIORITY of a new item, return the cache level
+/* Given the KEY, SIZE and PRIORITY of a new item, return the cache level
    (L1 or L2) in fragment CACHE that this item shall be inserted into.
    If we can't find nor make enough room for the item, return NULL.
  */
 static cache_level_t *
 select_level(svn_membuffer_t *cache,
+             const entry_key_t *key,
              apr_size_t size,
              apr_uint32_t priority)
 {
@@ -2165,6 +3076,7 @@ select_level(svn_membuffer_t *cache,
     {
       /* Large but important items go into L2. */
       entry_t dummy_entry = { { { 0 } } };
+      dummy_entry.key = *key;
       dummy_entry.priority = priority;
       dummy_entry.size = size;
 
@@ -2257,7 +3169,9 @@ membuffer_cache_set_internal(svn_membuffer_t *cache,
 
   /* if necessary, enlarge the insertion window.
    */
-  level = buffer ? select_level(cache, size, priority) : NULL;
+  level = buffer
+        ? select_level(cache, &to_find->entry_key, size, priority)
+        : NULL;
   if (level)
     {
       /* Remove old data for this key, if that exists.
@@ -2341,6 +3255,10 @@ membuffer_cache_set(svn_membuffer_t *cache,
   if (item)
     SVN_ERR(serializer(&buffer, &size, item, scratch_pool));
 
+  /* Any copy in L3 is about to become stale.
+   */
+  SVN_ERR(overflow_remove(cache->overflow, key));
+
   /* The actual cache data access needs to sync'ed
    */
   WITH_WRITE_LOCK(cache,
@@ -2355,6 +3273,94 @@ membuffer_cache_set(svn_membuffer_t *cache,
   return SVN_NO_ERROR;
 }
 
+/* Insert the serialized item given in BUFFER with ITEM_SIZE and PRIORITY,
+ * that has been read from POSITION in the overflow file of CACHE, into
+ * the group GROUP_INDEX of CACHE and uniquely identify it by hash value
+ * TO_FIND.  Don't do that if the item has been modified in the meantime.
+ *
+ * Note: This function requires the caller to serialization access.
+ * Don't call it directly, call read_overflow instead.
+ */
+static svn_error_t *
+membuffer_cache_promote_internal(svn_membuffer_t *cache,
+                                 const full_key_t *to_find,
+                                 apr_uint32_t group_index,
+                                 char *buffer,
+                                 apr_size_t item_size,
+                                 apr_uint32_t priority,
+                                 apr_uint64_t position,
+                                 DEBUG_CACHE_MEMBUFFER_TAG_ARG
+                                 apr_pool_t *scratch_pool)
+{
+  svn_boolean_t unchanged;
+
+  /* Someone else might have been quicker. */
+  if (find_entry(cache, group_index, to_find, FALSE))
+    return SVN_NO_ERROR;
+
+  /* Any writer removes the item from L3 before updating the membuffer.
+   * Since we hold the segment lock, no writer can interfere now. */
+  SVN_MUTEX__WITH_LOCK(cache->overflow->mutex,
+                       overflow_check_internal(&unchanged, cache->overflow,
+                                               to_find, position));
+  if (!unchanged)
+    return SVN_NO_ERROR;
+
+  return svn_error_trace(membuffer_cache_set_internal(cache,
+                                                      to_find,
+                                                      group_index,
+                                                      buffer,
+                                                      item_size,
+                                                      priority,
+                                                      DEBUG_CACHE_MEMBUFFER_TAG
+                                                      scratch_pool));
+}
+
+/* Look for the item identified by KEY in the overflow file of CACHE, if
+ * there is one.  If no item has been stored there for KEY, *BUFFER will
+ * be NULL.  Otherwise, return a copy of the serialized data in *BUFFER
+ * and its size in *ITEM_SIZE and promote the item back into the group
+ * GROUP_INDEX of CACHE.  Allocations will be done in RESULT_POOL.
+ */
+static svn_error_t *
+read_overflow(svn_membuffer_t *cache,
+              apr_uint32_t group_index,
+              const full_key_t *key,
+              char **buffer,
+              apr_size_t *item_size,
+              DEBUG_CACHE_MEMBUFFER_TAG_ARG
+              apr_pool_t *result_pool)
+{
+  overflow_t *overflow = cache->overflow;
+  apr_uint32_t priority;
+  apr_uint64_t position;
+
+  *buffer = NULL;
+  if (overflow == NULL)
+    return SVN_NO_ERROR;
+
+  SVN_MUTEX__WITH_LOCK(overflow->mutex,
+                       overflow_get_internal(overflow, key, buffer,
+                                             item_size, &priority,
+                                             &position, result_pool));
+  if (*buffer == NULL)
+    return SVN_NO_ERROR;
+
+  svn_metrics__add(overflow->hits, 1);
+
+  WITH_WRITE_LOCK(cache,
+                  membuffer_cache_promote_internal(cache,
+                                                   key,
+                                                   group_index,
+                                                   *buffer,
+                                                   *item_size,
+                                                   priority,
+                                                   position,
+                                                   DEBUG_CACHE_MEMBUFFER_TAG
+                                                   result_pool));
+  return SVN_NO_ERROR;
+}
+
 /* Count a hit in ENTRY within CACHE.
  */
 static void
@@ -2370,6 +3376,171 @@ increment_hit_counters(svn_membuffer_t *cache, entry_t *entry)
   cache->total_hits++;
 }
 
+#if USE_OPTIMISTIC_READS
+
+/* Count a lock-free read from CACHE that found ENTRY or, if that is
+ * NULL, nothing.  We don't hold the lock, so a writer may have reused
+ * ENTRY in the meantime and it may reset the hit counter concurrently.
+ * ENTRY is still within the directory, though, and an approximate hit
+ * count is good enough to keep hot entries from being evicted.
+ */
+static void
+count_optimistic_read(svn_membuffer_t *cache,
+                      entry_t *entry)
+{
+  svn_atomic_inc(&cache->lock_free_reads);
+  if (entry)
+    {
+      svn_atomic_inc(&entry->hit_count);
+      svn_atomic_inc(&cache->lock_free_hits);
+    }
+}
+
+/* Lock-free variant of find_entry with FIND_EMPTY being FALSE.  CACHE may
+ * be modified concurrently, so all references get bounds-checked before
+ * being followed.  Copy the entry matching TO_FIND in group GROUP_INDEX
+ * to *RESULT, set *ENTRY to its location and set *FOUND to TRUE.  If
+ * there is no such entry, set *FOUND to FALSE.
+ *
+ * Return FALSE if an inconsistent state has been detected.  The caller
+ * must validate the result against CACHE->GENERATION in any case.
+ */
+static svn_boolean_t
+find_entry_optimistic(entry_t *result,
+                      entry_t **entry,
+                      svn_boolean_t *found,
+                      svn_membuffer_t *cache,
+                      apr_uint32_t group_index,
+                      const full_key_t *to_find)
+{
+  entry_group_t *group = &cache->directory[group_index];
+  apr_uint32_t group_limit = cache->group_count + cache->spare_group_count;
+  apr_uint64_t data_limit = cache->l1.size + cache->l2.size;
+  apr_size_t chain_length;
+
+  *found = FALSE;
+  if (! is_group_initialized(cache, group_index))
+    return TRUE;
+
+  for (chain_length = 0;
+       chain_length < MAX_GROUP_CHAIN_LENGTH;
+       ++chain_length)
+    {
+      apr_uint32_t used = group->header.used;
+      apr_uint32_t next = group->header.next;
+      apr_uint32_t i;
+
+      if (used > GROUP_SIZE)
+        return FALSE;
+
+      for (i = 0; i < used; ++i)
+        if (entry_keys_match(&group->entries[i].key, &to_find->entry_key))
+          {
+            *entry = &group->entries[i];
+            *result = **entry;
+
+            if (   result->key.key_len > result->size
+                || result->offset > data_limit
+                || ALIGN_VALUE(result->size) > data_limit - result->offset)
+              return FALSE;
+
+            /* Key conflict?  Then, it is not cached. */
+            if (   result->key.key_len
+                && memcmp(to_find->full_key.data,
+                          cache->data + result->offset,
+                          result->key.key_len) != 0)
+              return TRUE;
+
+            *found = TRUE;
+            return TRUE;
+          }
+
+      if (next == NO_INDEX)
+        return TRUE;
+
+      if (next >= group_limit)
+        return FALSE;
+
+      group = &cache->directory[next];
+    }
+
+  /* Chains can't be that long, i.e. we read a stale NEXT link. */
+  return FALSE;
+}
+
+#endif
+
+/* Try to look for the cache entry in group GROUP_INDEX of CACHE,
+ * identified by the hash value TO_FIND, without acquiring the segment
+ * lock.  Return FALSE if that is not supported or not possible, e.g.
+ * because of concurrent writes.  The caller must then use the locked
+ * path.
+ *
+ * Otherwise, return TRUE and set *FOUND to indicate whether the entry
+ * exists.  If it does, return a copy of the serialized data in *BUFFER
+ * and return its size in *ITEM_SIZE.  Entries larger than SIZE_LIMIT
+ * will not be read.  Allocations will be done in RESULT_POOL.
+ */
+static svn_boolean_t
+read_optimistically(svn_membuffer_t *cache,
+                    apr_uint32_t group_index,
+                    const full_key_t *to_find,
+                    svn_boolean_t *found,
+                    char **buffer,
+                    apr_size_t *item_size,
+                    apr_size_t size_limit,
+                    apr_pool_t *result_pool)
+{
+#if USE_OPTIMISTIC_READS
+  int attempt;
+
+  if (!cache->optimistic_reads)
+    return FALSE;
+
+  for (attempt = 0; attempt < OPTIMISTIC_READ_ATTEMPTS; ++attempt)
+    {
+      entry_t copy;
+      entry_t *entry = NULL;
+      svn_boolean_t consistent;
+      char *data = NULL;
+      apr_size_t size = 0;
+
+      svn_atomic_t generation = svn_atomic_read(&cache->generation);
+
+      /* Don't fight an active writer. */
+      if (generation & 1)
+        break;
+
+      MEMORY_BARRIER();
+      consistent = find_entry_optimistic(&copy, &entry, found, cache,
+                                         group_index, to_find);
+      if (consistent && *found)
+        {
+          size = ALIGN_VALUE(copy.size) - copy.key.key_len;
+          if (size > size_limit)
+            return FALSE;
+
+          data = apr_palloc(result_pool, size);
+          memcpy(data, cache->data + copy.offset + copy.key.key_len, size);
+        }
+
+      MEMORY_BARRIER();
+      if (consistent && svn_atomic_read(&cache->generation) == generation)
+        {
+          count_optimistic_read(cache, *found ? entry : NULL);
+          *item_size = *found ? copy.size - copy.key.key_len : 0;
+
+          *buffer = data;
+          return TRUE;
+        }
+
+      cache->optimistic_retries++;
+    }
+#endif
+
+  return FALSE;
+}
+
 /* Look for the cache entry in group GROUP_INDEX of CACHE, identified
  * by the hash value TO_FIND. If no item has been stored for KEY,
  * *BUFFER will be NULL. Otherwise, return a copy of the serialized
@@ -2449,18 +3620,30 @@ membuffer_cache_get(svn_membuffer_t *cache,
   apr_uint32_t group_index;
   char *buffer;
   apr_size_t size;
+  svn_boolean_t found;
 
   /* find the entry group that will hold the key.
    */
   group_index = get_group_index(&cache, &key->entry_key);
-  WITH_READ_LOCK(cache,
-                 membuffer_cache_get_internal(cache,
-                                              group_index,
-                                              key,
-                                              &buffer,
-                                              &size,
-                                              DEBUG_CACHE_MEMBUFFER_TAG
-                                              result_pool));
+  record_access(cache, &key->entry_key);
+
+  /* Most hits won't need to acquire the lock. */
+  if (!read_optimistically(cache, group_index, key, &found, &buffer, &size,
+                           MAX_ITEM_SIZE, result_pool))
+    WITH_READ_LOCK(cache,
+                   membuffer_cache_get_internal(cache,
+                                                group_index,
+                                                key,
+                                                &buffer,
+                                                &size,
+                                                DEBUG_CACHE_MEMBUFFER_TAG
+                                                result_pool));
+
+  /* Evicted items may still be found in L3.
+   */
+  if (buffer == NULL)
+    SVN_ERR(read_overflow(cache, group_index, key, &buffer, &size,
+                          DEBUG_CACHE_MEMBUFFER_TAG result_pool));
 
   /* re-construct the original data object from its serialized form.
    */
@@ -2473,6 +3656,186 @@ membuffer_cache_get(svn_membuffer_t *cache,
   return deserializer(item, buffer, size, result_pool);
 }
 
+/* The batch operations need to track the consistency tag of every item.
+ * Fall back to individual accesses when consistency checks are enabled.
+ */
+#ifndef SVN_DEBUG_CACHE_MEMBUFFER
+
+/* A single item of a batch access, see membuffer_cache_get_many() and
+ * membuffer_cache_set_many().
+ */
+typedef struct batch_item_t
+{
+  /* The globally unique key of the item. */
+  full_key_t key;
+
+  /* The cache segment and the group within it that hold the item. */
+  svn_membuffer_t *segment;
+  apr_uint32_t group_index;
+
+  /* The serialized item and its size.  NULL if not found or empty. */
+  char *buffer;
+  apr_size_t size;
+
+  /* Index of the item in the caller's key / value arrays. */
+  int index;
+
+  /* Whether the L1 / L2 lookup has already been completed. */
+  svn_boolean_t done;
+} batch_item_t;
+
+/* qsort-compatible comparison function ordering batch_item_t by segment
+ * and then by their original position.
+ */
+static int
+compare_batch_items(const void *lhs, const void *rhs)
+{
+  const batch_item_t *lhs_item = lhs;
+  const batch_item_t *rhs_item = rhs;
+
+  if (lhs_item->segment != rhs_item->segment)
+    return lhs_item->segment < rhs_item->segment ? -1 : 1;
+
+  return lhs_item->index - rhs_item->index;
+}
+
+/* Return the number of items following and including ITEMS[FIRST] within
+ * the first COUNT ITEMS that belong to the same segment.  ITEMS must be
+ * sorted by compare_batch_items.
+ */
+static int
+segment_run_length(const batch_item_t *items,
+                   int first,
+                   int count)
+{
+  int last = first + 1;
+  while (last < count && items[last].segment == items[first].segment)
+    ++last;
+
+  return last - first;
+}
+
+/* Look up the first COUNT ITEMS, sorted by compare_batch_items, in their
+ * respective segments.  Set their BUFFER and SIZE members to the
+ * serialized data and size.  Acquire each segment lock at most once.
+ * Allocations will be done in RESULT_POOL.
+ */
+static svn_error_t *
+membuffer_cache_get_many(batch_item_t *items,
+                         int count,
+                         apr_pool_t *result_pool)
+{
+  int first, i, run_length;
+
+  /* Most hits won't need to acquire the lock. */
+  for (i = 0; i < count; ++i)
+    {
+      batch_item_t *item = &items[i];
+      svn_boolean_t found;
+
+      record_access(item->segment, &item->key.entry_key);
+      item->done = read_optimistically(item->segment, item->group_index,
+                                       &item->key, &found, &item->buffer,
+                                       &item->size, MAX_ITEM_SIZE,
+                                       result_pool);
+    }
+
+  /* Process the remainder one segment at a time. */
+  for (first = 0; first < count; first += run_length)
+    {
+      svn_membuffer_t *segment = items[first].segment;
+      svn_boolean_t needs_lock = FALSE;
+      svn_error_t *err = SVN_NO_ERROR;
+
+      run_length = segment_run_length(items, first, count);
+      for (i = first; i < first + run_length; ++i)
+        needs_lock |= !items[i].done;
+
+      if (!needs_lock)
+        continue;
+
+      SVN_ERR(read_lock_cache(segment));
+      for (i = first; i < first + run_length && !err; ++i)
+        if (!items[i].done)
+          err = membuffer_cache_get_internal(segment,
+                                             items[i].group_index,
+                                             &items[i].key,
+                                             &items[i].buffer,
+                                             &items[i].size,
+                                             result_pool);
+      SVN_ERR(unlock_cache(segment, err));
+    }
+
+  /* Evicted items may still be found in L3.
+   */
+  for (i = 0; i < count; ++i)
+    if (items[i].buffer == NULL)
+      SVN_ERR(read_overflow(items[i].segment, items[i].group_index,
+                            &items[i].key, &items[i].buffer,
+                            &items[i].size, result_pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Store the serialized data of the first COUNT ITEMS, sorted by
+ * compare_batch_items, in their respective segments with the given
+ * PRIORITY.  Acquire each segment lock at most once.  Use SCRATCH_POOL
+ * for temporary allocations.
+ */
+static svn_error_t *
+membuffer_cache_set_many(batch_item_t *items,
+                         int count,
+                         apr_uint32_t priority,
+                         apr_pool_t *scratch_pool)
+{
+  int first, i, run_length;
+
+  /* Any copy in L3 is about to become stale.
+   */
+  for (i = 0; i < count; ++i)
+    SVN_ERR(overflow_remove(items[i].segment->overflow, &items[i].key));
+
+  for (first = 0; first < count; first += run_length)
+    {
+      svn_membuffer_t *segment = items[first].segment;
+      svn_boolean_t got_lock = TRUE;
+      svn_error_t *err = SVN_NO_ERROR;
+
+      run_length = segment_run_length(items, first, count);
+
+      /* Like WITH_WRITE_LOCK: If we could not get the lock, we may skip
+       * the update unless it would leave stale entries behind. */
+      SVN_ERR(write_lock_cache(segment, &got_lock));
+      if (!got_lock)
+        {
+          svn_boolean_t exists = FALSE;
+          for (i = first; i < first + run_length && !exists; ++i)
+            SVN_ERR(entry_exists(segment, items[i].group_index,
+                                 &items[i].key, &exists));
+
+          if (!exists)
+            continue;
+
+          SVN_ERR(force_write_lock_cache(segment));
+        }
+
+      begin_modification(segment);
+      for (i = first; i < first + run_length && !err; ++i)
+        err = membuffer_cache_set_internal(segment,
+                                           &items[i].key,
+                                           items[i].group_index,
+                                           items[i].buffer,
+                                           items[i].size,
+                                           priority,
+                                           scratch_pool);
+      SVN_ERR(unlock_cache(segment, end_modification(segment, err)));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+#endif /* SVN_DEBUG_CACHE_MEMBUFFER */
+
 /* Look for the cache entry in group GROUP_INDEX of CACHE, identified
  * by the hash value TO_FIND.  If no item has been stored for KEY, *FOUND
  * will be FALSE and TRUE otherwise.
@@ -2516,6 +3879,7 @@ membuffer_cache_has_key(svn_membuffer_t *cache,
    */
   apr_uint32_t group_index = get_group_index(&cache, &key->entry_key);
   cache->total_reads++;
+  record_access(cache, &key->entry_key);
 
   WITH_READ_LOCK(cache,
                  membuffer_cache_has_key_internal(cache,
@@ -2523,6 +3887,12 @@ membuffer_cache_has_key(svn_membuffer_t *cache,
                                                   key,
                                                   found));
 
+  /* Evicted items may still be found in L3. */
+  if (!*found && cache->overflow)
+    SVN_MUTEX__WITH_LOCK(cache->overflow->mutex,
+                         overflow_has_key_internal(found, cache->overflow,
+                                                   key));
+
   return SVN_NO_ERROR;
 }
 
@@ -2600,18 +3970,154 @@ membuffer_cache_get_partial(svn_membuffer_t *cache,
                             apr_pool_t *result_pool)
 {
   apr_uint32_t group_index = get_group_index(&cache, &key->entry_key);
+  char *buffer;
+  apr_size_t size;
 
-  WITH_READ_LOCK(cache,
-                 membuffer_cache_get_partial_internal
-                     (cache, group_index, key, item, found,
-                      deserializer, baton, DEBUG_CACHE_MEMBUFFER_TAG
-                      result_pool));
+  record_access(cache, &key->entry_key);
 
-  return SVN_NO_ERROR;
+  /* Small items can be copied and then processed without holding the
+   * lock. */
+  if (read_optimistically(cache, group_index, key, found, &buffer, &size,
+                          OPTIMISTIC_PARTIAL_READ_LIMIT, result_pool))
+    {
+      if (*found)
+        return deserializer(item, buffer, size, baton, result_pool);
+    }
+  else
+    {
+      WITH_READ_LOCK(cache,
+                     membuffer_cache_get_partial_internal
+                         (cache, group_index, key, item, found,
+                          deserializer, baton, DEBUG_CACHE_MEMBUFFER_TAG
+                          result_pool));
+      if (*found)
+        return SVN_NO_ERROR;
+    }
+
+  /* Evicted items may still be found in L3. */
+  SVN_ERR(read_overflow(cache, group_index, key, &buffer, &size,
+                        DEBUG_CACHE_MEMBUFFER_TAG result_pool));
+  *found = buffer != NULL;
+  if (!*found)
+    {
+      *item = NULL;
+      return SVN_NO_ERROR;
+    }
+
+  return deserializer(item, buffer, size, baton, result_pool);
 }
 
 /* Look for the cache entry in group GROUP_INDEX of CACHE, identified
- * by the hash value TO_FIND. If no entry has been found, the function
+ * by the hash value TO_FIND.  FOUND indicates whether that entry exists.
+ * If it does, return its serialized data in *DATA and its size in
+ * *DATA_SIZE.  Otherwise, set *DATA to NULL.  *DATA points directly into
+ * the cache memory.  Allocations will be done in RESULT_POOL.
+ *
+ * Note: This function requires the caller to serialization access and
+ * *DATA is only valid while the caller holds it.
+ * Don't call it directly, call membuffer_cache_get_pinned instead.
+ */
+static svn_error_t *
+membuffer_cache_get_pinned_internal(svn_membuffer_t *cache,
+                                    apr_uint32_t group_index,
+                                    const full_key_t *to_find,
+                                    const void **data,
+                                    apr_size_t *data_size,
+                                    svn_boolean_t *found,
+                                    DEBUG_CACHE_MEMBUFFER_TAG_ARG
+                                    apr_pool_t *result_pool)
+{
+  entry_t *entry = find_entry(cache, group_index, to_find, FALSE);
+  cache->total_reads++;
+  if (entry == NULL)
+    {
+      *data = NULL;
+      *data_size = 0;
+      *found = FALSE;
+
+      return SVN_NO_ERROR;
+    }
+
+  *data = cache->data + entry->offset + entry->key.key_len;
+  *data_size = entry->size - entry->key.key_len;
+  *found = TRUE;
+  increment_hit_counters(cache, entry);
+
+#ifdef SVN_DEBUG_CACHE_MEMBUFFER
+
+  /* Check for overlapping entries.
+   */
+  SVN_ERR_ASSERT(entry->next == NO_INDEX ||
+                 entry->offset + entry->size
+                    <= get_entry(cache, entry->next)->offset);
+
+  /* Compare original content, type and key (hashes)
+   */
+  SVN_ERR(store_content_part(tag, *data, *data_size, result_pool));
+  SVN_ERR(assert_equal_tags(&entry->tag, tag));
+
+#endif
+
+  return SVN_NO_ERROR;
+}
+
+/* Look for the cache entry identified by KEY.  FOUND indicates whether
+ * that entry exists.  If it does, return its serialized data in *DATA
+ * and its size in *DATA_SIZE.  Otherwise, set *DATA to NULL.
+ *
+ * If *DATA points into the cache memory, return the segment that it
+ * belongs to in *LOCKED.  That segment remains read-locked and it is
+ * the caller's responsibility to unlock it.  Otherwise, i.e. for entries
+ * that are not cached or that have been read from L3, *LOCKED will be
+ * NULL and *DATA will be allocated in RESULT_POOL.
+ *
+ * The lock-free read path is not used here because it has to copy the
+ * data anyway.
+ */
+static svn_error_t *
+membuffer_cache_get_pinned(svn_membuffer_t *cache,
+                           const full_key_t *key,
+                           const void **data,
+                           apr_size_t *data_size,
+                           svn_boolean_t *found,
+                           svn_membuffer_t **locked,
+                           DEBUG_CACHE_MEMBUFFER_TAG_ARG
+                           apr_pool_t *result_pool)
+{
+  apr_uint32_t group_index = get_group_index(&cache, &key->entry_key);
+  svn_error_t *err;
+  char *buffer;
+
+  record_access(cache, &key->entry_key);
+  *locked = NULL;
+
+  /* Keep the read lock upon success.  It prevents any modification of
+   * the segment, i.e. the entry can neither be moved nor evicted. */
+  SVN_ERR(read_lock_cache(cache));
+  err = membuffer_cache_get_pinned_internal(cache, group_index, key,
+                                            data, data_size, found,
+                                            DEBUG_CACHE_MEMBUFFER_TAG
+                                            result_pool);
+  if (err || !*found)
+    SVN_ERR(unlock_cache(cache, err));
+
+  if (*found)
+    {
+      *locked = cache;
+      return SVN_NO_ERROR;
+    }
+
+  /* Evicted items may still be found in L3. */
+  SVN_ERR(read_overflow(cache, group_index, key, &buffer, data_size,
+                        DEBUG_CACHE_MEMBUFFER_TAG result_pool));
+  *data = buffer;
+  *found = buffer != NULL;
+
+  return SVN_NO_ERROR;
+}
+
+/* Look for the cache entry in group GROUP_INDEX of CACHE, identified
+ * by the hash value TO_FIND. If no entry has been found, the function
  * returns without modifying the cache.
  *
  * Otherwise, FUNC is called with that entry and the BATON provided
@@ -2742,6 +4248,11 @@ membuffer_cache_set_partial(svn_membuffer_t *cache,
   /* cache item lookup
    */
   apr_uint32_t group_index = get_group_index(&cache, &key->entry_key);
+
+  /* Any copy in L3 is about to become stale.
+   */
+  SVN_ERR(overflow_remove(cache->overflow, key));
+
   WITH_WRITE_LOCK(cache,
                   membuffer_cache_set_partial_internal
                      (cache, group_index, key, func, baton,
@@ -2799,6 +4310,12 @@ typedef struct svn_membuffer_cache_t
   /* priority class for all items written through this interface */
   apr_uint32_t priority;
 
+  /* If not NULL and set, items written through this interface belong to
+   * a bulk scan and get written with low priority instead of PRIORITY.
+   * See svn_cache__membuffer_set_bulk_hint().
+   */
+  const svn_boolean_t *bulk_scan;
+
   /* Temporary buffer containing the hash key for the current access
    */
   full_key_t combined_key;
@@ -2806,6 +4323,12 @@ typedef struct svn_membuffer_cache_t
   /* if enabled, this will serialize the access to this instance.
    */
   svn_mutex__t *mutex;
+
+  /* Lookups through this instance that found / didn't find data,
+   * counted per kind of cache.  May be NULL.
+   */
+  svn_metrics__t *hits;
+  svn_metrics__t *misses;
 } svn_membuffer_cache_t;
 
 /* Return the prefix key used by CACHE. */
@@ -2954,6 +4477,7 @@ svn_membuffer_cache_get(void **value_p,
 
   /* return result */
   *found = *value_p != NULL;
+  svn_metrics__add(*found ? cache->hits : cache->misses, 1);
 
   return SVN_NO_ERROR;
 }
@@ -2990,6 +4514,16 @@ svn_membuffer_cache_has_key(svn_boolean_t *found,
   return SVN_NO_ERROR;
 }
 
+/* Return the priority with which to write new items through CACHE.
+ */
+static apr_uint32_t
+get_write_priority(svn_membuffer_cache_t *cache)
+{
+  return (cache->bulk_scan && *cache->bulk_scan)
+       ? MIN(cache->priority, SVN_CACHE__MEMBUFFER_LOW_PRIORITY)
+       : cache->priority;
+}
+
 /* Implement svn_cache__vtable_t.set (not thread-safe)
  */
 static svn_error_t *
@@ -3018,11 +4552,128 @@ svn_membuffer_cache_set(void *cache_void,
                              &cache->combined_key,
                              value,
                              cache->serializer,
-                             cache->priority,
+                             get_write_priority(cache),
                              DEBUG_CACHE_MEMBUFFER_TAG
                              scratch_pool);
 }
 
+#ifndef SVN_DEBUG_CACHE_MEMBUFFER
+
+/* Set *ITEMS to an array of batch_item_t for all non-NULL KEYS of CACHE
+ * and return their number in *COUNT.  The items will be sorted by cache
+ * segment.  Allocate them in RESULT_POOL.
+ */
+static void
+make_batch_items(batch_item_t **items,
+                 int *count,
+                 svn_membuffer_cache_t *cache,
+                 const apr_array_header_t *keys,
+                 apr_pool_t *result_pool)
+{
+  int i;
+
+  *items = apr_pcalloc(result_pool, keys->nelts * sizeof(**items));
+  *count = 0;
+  for (i = 0; i < keys->nelts; ++i)
+    {
+      const void *key = APR_ARRAY_IDX(keys, i, const void *);
+      batch_item_t *item;
+
+      if (key == NULL)
+        continue;
+
+      /* CACHE->COMBINED_KEY gets overwritten by the next key. */
+      combine_key(cache, key, cache->key_len);
+
+      item = &(*items)[(*count)++];
+      item->key.entry_key = cache->combined_key.entry_key;
+      if (cache->prefix.prefix_idx == NO_INDEX)
+        {
+          apr_size_t key_len = cache->combined_key.entry_key.key_len;
+          svn_membuf__create(&item->key.full_key, key_len, result_pool);
+          memcpy(item->key.full_key.data,
+                 cache->combined_key.full_key.data, key_len);
+        }
+
+      item->segment = cache->membuffer;
+      item->group_index = get_group_index(&item->segment,
+                                          &item->key.entry_key);
+      item->index = i;
+    }
+
+  qsort(*items, *count, sizeof(**items), compare_batch_items);
+}
+
+/* Implement svn_cache__vtable_t.get_many (not thread-safe)
+ */
+static svn_error_t *
+svn_membuffer_cache_get_many(apr_array_header_t *values,
+                             void *cache_void,
+                             const apr_array_header_t *keys,
+                             apr_pool_t *result_pool)
+{
+  svn_membuffer_cache_t *cache = cache_void;
+  apr_pool_t *scratch_pool = svn_pool_create(result_pool);
+  batch_item_t *items;
+  int count, i;
+  int hits = 0;
+
+  make_batch_items(&items, &count, cache, keys, scratch_pool);
+
+  /* The buffers will be deserialized in-place, so they must live in
+   * RESULT_POOL. */
+  SVN_ERR(membuffer_cache_get_many(items, count, result_pool));
+
+  for (i = 0; i < count; ++i)
+    if (items[i].buffer)
+      {
+        SVN_ERR(cache->deserializer(&APR_ARRAY_IDX(values, items[i].index,
+                                                   void *),
+                                    items[i].buffer, items[i].size,
+                                    result_pool));
+        ++hits;
+      }
+
+  svn_metrics__add(cache->hits, hits);
+  svn_metrics__add(cache->misses, count - hits);
+  svn_pool_destroy(scratch_pool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Implement svn_cache__vtable_t.set_many (not thread-safe)
+ */
+static svn_error_t *
+svn_membuffer_cache_set_many(void *cache_void,
+                             const apr_array_header_t *keys,
+                             const apr_array_header_t *values,
+                             apr_pool_t *scratch_pool)
+{
+  svn_membuffer_cache_t *cache = cache_void;
+  apr_pool_t *subpool = svn_pool_create(scratch_pool);
+  batch_item_t *items;
+  int count, i;
+
+  make_batch_items(&items, &count, cache, keys, subpool);
+
+  /* Serialize all data before taking any lock. */
+  for (i = 0; i < count; ++i)
+    {
+      void *value = APR_ARRAY_IDX(values, items[i].index, void *);
+      if (value)
+        SVN_ERR(cache->serializer((void **)&items[i].buffer, &items[i].size,
+                                  value, subpool));
+    }
+
+  SVN_ERR(membuffer_cache_set_many(items, count, get_write_priority(cache),
+                                   subpool));
+  svn_pool_destroy(subpool);
+
+  return SVN_NO_ERROR;
+}
+
+#endif /* SVN_DEBUG_CACHE_MEMBUFFER */
+
 /* Implement svn_cache__vtable_t.iter as "not implemented"
  */
 static svn_error_t *
@@ -3068,10 +4719,59 @@ svn_membuffer_cache_get_partial(void **value_p,
                                       baton,
                                       DEBUG_CACHE_MEMBUFFER_TAG
                                       result_pool));
+  svn_metrics__add(*found ? cache->hits : cache->misses, 1);
 
   return SVN_NO_ERROR;
 }
 
+/* Implement svn_cache__vtable_t.get_pinned (not thread-safe)
+ */
+static svn_error_t *
+svn_membuffer_cache_get_pinned(const void **data,
+                               apr_size_t *data_len,
+                               svn_boolean_t *found,
+                               void **pin_baton,
+                               void *cache_void,
+                               const void *key,
+                               apr_pool_t *result_pool)
+{
+  svn_membuffer_cache_t *cache = cache_void;
+  svn_membuffer_t *locked;
+
+  DEBUG_CACHE_MEMBUFFER_INIT_TAG(result_pool)
+
+  if (key == NULL)
+    {
+      *data = NULL;
+      *found = FALSE;
+
+      return SVN_NO_ERROR;
+    }
+
+  combine_key(cache, key, cache->key_len);
+  SVN_ERR(membuffer_cache_get_pinned(cache->membuffer,
+                                     &cache->combined_key,
+                                     data,
+                                     data_len,
+                                     found,
+                                     &locked,
+                                     DEBUG_CACHE_MEMBUFFER_TAG
+                                     result_pool));
+  svn_metrics__add(*found ? cache->hits : cache->misses, 1);
+  *pin_baton = locked;
+
+  return SVN_NO_ERROR;
+}
+
+/* Implement svn_cache__vtable_t.unpin.  PIN_BATON is the segment that
+ * svn_membuffer_cache_get_pinned left read-locked.
+ */
+static svn_error_t *
+svn_membuffer_cache_unpin(void *pin_baton)
+{
+  return svn_error_trace(unlock_cache(pin_baton, SVN_NO_ERROR));
+}
+
 /* Implement svn_cache__vtable_t.set_partial (not thread-safe)
  */
 static svn_error_t *
@@ -3131,6 +4831,7 @@ svn_membuffer_get_segment_info(svn_membuffer_t *segment,
 
   info->used_entries += segment->used_entries;
   info->total_entries += segment->group_count * GROUP_SIZE;
+  info->lock_free_hits += svn_atomic_read(&segment->lock_free_hits);
 
   if (include_histogram)
     for (i = 0; i < segment->group_count; ++i)
@@ -3186,7 +4887,16 @@ static svn_cache__vtable_t membuffer_cache_vtable = {
   svn_membuffer_cache_is_cachable,
   svn_membuffer_cache_get_partial,
   svn_membuffer_cache_set_partial,
-  svn_membuffer_cache_get_info
+  svn_membuffer_cache_get_info,
+#ifdef SVN_DEBUG_CACHE_MEMBUFFER
+  NULL, /* get_many */
+  NULL, /* set_many */
+#else
+  svn_membuffer_cache_get_many,
+  svn_membuffer_cache_set_many,
+#endif
+  svn_membuffer_cache_get_pinned,
+  svn_membuffer_cache_unpin
 };
 
 /* Implement svn_cache__vtable_t.get and serialize all cache access.
@@ -3245,6 +4955,46 @@ svn_membuffer_cache_set_synced(void *cache_void,
   return SVN_NO_ERROR;
 }
 
+#ifndef SVN_DEBUG_CACHE_MEMBUFFER
+
+/* Implement svn_cache__vtable_t.get_many and serialize all cache access.
+ */
+static svn_error_t *
+svn_membuffer_cache_get_many_synced(apr_array_header_t *values,
+                                    void *cache_void,
+                                    const apr_array_header_t *keys,
+                                    apr_pool_t *result_pool)
+{
+  svn_membuffer_cache_t *cache = cache_void;
+  SVN_MUTEX__WITH_LOCK(cache->mutex,
+                       svn_membuffer_cache_get_many(values,
+                                                    cache_void,
+                                                    keys,
+                                                    result_pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Implement svn_cache__vtable_t.set_many and serialize all cache access.
+ */
+static svn_error_t *
+svn_membuffer_cache_set_many_synced(void *cache_void,
+                                    const apr_array_header_t *keys,
+                                    const apr_array_header_t *values,
+                                    apr_pool_t *scratch_pool)
+{
+  svn_membuffer_cache_t *cache = cache_void;
+  SVN_MUTEX__WITH_LOCK(cache->mutex,
+                       svn_membuffer_cache_set_many(cache_void,
+                                                    keys,
+                                                    values,
+                                                    scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+#endif /* SVN_DEBUG_CACHE_MEMBUFFER */
+
 /* Implement svn_cache__vtable_t.get_partial and serialize all cache access.
  */
 static svn_error_t *
@@ -3269,6 +5019,31 @@ svn_membuffer_cache_get_partial_synced(void **value_p,
   return SVN_NO_ERROR;
 }
 
+/* Implement svn_cache__vtable_t.get_pinned and serialize all cache access.
+ * The pin itself does not need that serialization.
+ */
+static svn_error_t *
+svn_membuffer_cache_get_pinned_synced(const void **data,
+                                      apr_size_t *data_len,
+                                      svn_boolean_t *found,
+                                      void **pin_baton,
+                                      void *cache_void,
+                                      const void *key,
+                                      apr_pool_t *result_pool)
+{
+  svn_membuffer_cache_t *cache = cache_void;
+  SVN_MUTEX__WITH_LOCK(cache->mutex,
+                       svn_membuffer_cache_get_pinned(data,
+                                                      data_len,
+                                                      found,
+                                                      pin_baton,
+                                                      cache_void,
+                                                      key,
+                                                      result_pool));
+
+  return SVN_NO_ERROR;
+}
+
 /* Implement svn_cache__vtable_t.set_partial and serialize all cache access.
  */
 static svn_error_t *
@@ -3299,7 +5074,16 @@ static svn_cache__vtable_t membuffer_cache_synced_vtable = {
   svn_membuffer_cache_is_cachable,        /* no sync required */
   svn_membuffer_cache_get_partial_synced,
   svn_membuffer_cache_set_partial_synced,
-  svn_membuffer_cache_get_info            /* no sync required */
+  svn_membuffer_cache_get_info,           /* no sync required */
+#ifdef SVN_DEBUG_CACHE_MEMBUFFER
+  NULL, /* get_many */
+  NULL, /* set_many */
+#else
+  svn_membuffer_cache_get_many_synced,
+  svn_membuffer_cache_set_many_synced,
+#endif
+  svn_membuffer_cache_get_pinned_synced,
+  svn_membuffer_cache_unpin               /* no sync required */
 };
 
 /* standard serialization function for svn_stringbuf_t items.
@@ -3356,6 +5140,8 @@ svn_cache__create_membuffer_cache(svn_cache__t **cache_p,
 {
   svn_checksum_t *checksum;
   apr_size_t prefix_len, prefix_orig_len;
+  const char *kind;
+  const char *labels;
 
   /* allocate the cache header structures
    */
@@ -3376,6 +5162,16 @@ svn_cache__create_membuffer_cache(svn_cache__t **cache_p,
 
   SVN_ERR(svn_mutex__init(&cache->mutex, thread_safe, result_pool));
 
+  /* Count lookups by the kind of cache, i.e. the last part of prefixes
+   * like "fsfs:UUID/PATH:DAG", not per repository. */
+  kind = strrchr(prefix, ':');
+  kind = (kind && kind[1]) ? kind + 1 : prefix;
+  labels = svn_metrics__label("cache", kind, scratch_pool);
+  cache->hits = svn_metrics__counter("svn_cache_hits_total", labels,
+                                     "Cache lookups that found data.");
+  cache->misses = svn_metrics__counter("svn_cache_misses_total", labels,
+                                       "Cache lookups that found no data.");
+
   /* Copy the prefix into the prefix full key. Align it to ITEM_ALIGMENT.
    * Don't forget to include the terminating NUL. */
   prefix_orig_len = strlen(prefix) + 1;
@@ -3444,6 +5240,400 @@ svn_cache__create_membuffer_cache(svn_cache__t **cache_p,
   return SVN_NO_ERROR;
 }
 
+void
+svn_cache__membuffer_set_bulk_hint(svn_cache__t *cache,
+                                   const svn_boolean_t *bulk_scan)
+{
+  if (   cache->vtable == &membuffer_cache_vtable
+      || cache->vtable == &membuffer_cache_synced_vtable)
+    {
+      svn_membuffer_cache_t *membuffer_cache = cache->cache_internal;
+      membuffer_cache->bulk_scan = bulk_scan;
+    }
+}
+
+/* Snapshot files start with this line, followed by SNAPSHOT_BYTE_ORDER
+ * in the native byte order of the process that wrote the file.
+ */
+#define SNAPSHOT_MAGIC "SVN membuffer snapshot 1\n"
+#define SNAPSHOT_BYTE_ORDER APR_UINT32_C(0x01020304)
+
+/* Record types in a snapshot file.  Each record is tagged with one of
+ * them.  Prefix records consist of a 32 bit string length followed by
+ * the prefix string.  Entry records consist of a snapshot_entry_t
+ * followed by the KEY_LEN bytes of full key and SIZE bytes of data.
+ */
+#define SNAPSHOT_PREFIX APR_UINT32_C(0x50524546)
+#define SNAPSHOT_ENTRY  APR_UINT32_C(0x454e5452)
+#define SNAPSHOT_END    APR_UINT32_C(0x454e4421)
+
+/* Header of an entry record in a snapshot file.
+ */
+typedef struct snapshot_entry_t
+{
+  /* Copied from the entry_key_t.  Fingerprints don't depend on any
+   * process-local state. */
+  apr_uint64_t fingerprint[2];
+
+  /* Index of the key prefix within the prefix records of the file. */
+  apr_uint32_t prefix_id;
+
+  /* Length of the full key that precedes the data.  0 for shared
+   * prefixes. */
+  apr_uint32_t key_len;
+
+  /* Size of the serialized item. */
+  apr_uint32_t size;
+
+  /* Priority of the entry. */
+  apr_uint32_t priority;
+} snapshot_entry_t;
+
+/* A prefix found in a snapshot, see svn_cache__membuffer_save() and
+ * svn_cache__membuffer_load().
+ */
+typedef struct snapshot_prefix_t
+{
+  /* The prefix string. */
+  const char *prefix;
+
+  /* Index into the prefix records of the snapshot file or NO_INDEX if
+   * the filter rejected this prefix. */
+  apr_uint32_t id;
+
+  /* Index in the prefix_pool_t of the cache we load into.  NO_INDEX if
+   * the prefix is not shared or could not be added to the pool. */
+  apr_uint32_t prefix_idx;
+} snapshot_prefix_t;
+
+#ifndef SVN_DEBUG_CACHE_MEMBUFFER
+
+/* Write the LEN bytes in DATA to STREAM.
+ */
+static svn_error_t *
+snapshot_write(svn_stream_t *stream,
+               const void *data,
+               apr_size_t len)
+{
+  return svn_error_trace(svn_stream_write(stream, data, &len));
+}
+
+/* Read exactly LEN bytes from STREAM into DATA.
+ */
+static svn_error_t *
+snapshot_read(svn_stream_t *stream,
+              void *data,
+              apr_size_t len)
+{
+  apr_size_t read = len;
+  SVN_ERR(svn_stream_read_full(stream, data, &read));
+  if (read != len)
+    return svn_error_create(SVN_ERR_MALFORMED_FILE, NULL,
+                            _("Unexpected end of cache snapshot"));
+
+  return SVN_NO_ERROR;
+}
+
+/* Write ENTRY of CACHE to STREAM, unless FILTER rejects its key prefix.
+ * PREFIXES maps the known prefix strings to snapshot_prefix_t.  Write
+ * a prefix record for all new prefixes, passing FILTER_BATON to FILTER,
+ * and count them in *PREFIX_COUNT.  Allocate new PREFIXES in RESULT_POOL.
+ */
+static svn_error_t *
+snapshot_save_entry(svn_stream_t *stream,
+                    svn_membuffer_t *cache,
+                    const entry_t *entry,
+                    apr_hash_t *prefixes,
+                    apr_uint32_t *prefix_count,
+                    svn_cache__prefix_filter_t filter,
+                    void *filter_baton,
+                    apr_pool_t *result_pool)
+{
+  const char *data = cache->data + entry->offset;
+  const char *prefix;
+  snapshot_prefix_t *known;
+  snapshot_entry_t header;
+
+  /* Unshared prefixes are the first part of the full key. */
+  prefix = entry->key.prefix_idx == NO_INDEX
+         ? data
+         : cache->prefix_pool->values[entry->key.prefix_idx];
+
+  known = svn_hash_gets(prefixes, prefix);
+  if (known == NULL)
+    {
+      svn_boolean_t keep = TRUE;
+      apr_uint32_t tag = SNAPSHOT_PREFIX;
+      apr_uint32_t len = (apr_uint32_t)strlen(prefix);
+
+      if (filter)
+        SVN_ERR(filter(&keep, filter_baton, prefix, result_pool));
+
+      known = apr_pcalloc(result_pool, sizeof(*known));
+      known->prefix = apr_pstrdup(result_pool, prefix);
+      known->id = NO_INDEX;
+      svn_hash_sets(prefixes, known->prefix, known);
+
+      if (keep)
+        {
+          known->id = (*prefix_count)++;
+          SVN_ERR(snapshot_write(stream, &tag, sizeof(tag)));
+          SVN_ERR(snapshot_write(stream, &len, sizeof(len)));
+          SVN_ERR(snapshot_write(stream, prefix, len));
+        }
+    }
+
+  if (known->id == NO_INDEX)
+    return SVN_NO_ERROR;
+
+  memset(&header, 0, sizeof(header));
+  header.fingerprint[0] = entry->key.fingerprint[0];
+  header.fingerprint[1] = entry->key.fingerprint[1];
+  header.prefix_id = known->id;
+  header.key_len = (apr_uint32_t)entry->key.key_len;
+  header.size = (apr_uint32_t)(entry->size - entry->key.key_len);
+  header.priority = entry->priority;
+
+  {
+    apr_uint32_t tag = SNAPSHOT_ENTRY;
+    SVN_ERR(snapshot_write(stream, &tag, sizeof(tag)));
+  }
+  SVN_ERR(snapshot_write(stream, &header, sizeof(header)));
+
+  return svn_error_trace(snapshot_write(stream, data,
+                                        header.key_len + header.size));
+}
+
+/* Write all entries of the cache segment SEGMENT to STREAM.  The other
+ * parameters are the same as for snapshot_save_entry.
+ *
+ * Note: This function requires the caller to serialization access.
+ */
+static svn_error_t *
+snapshot_save_segment(svn_stream_t *stream,
+                      svn_membuffer_t *segment,
+                      apr_hash_t *prefixes,
+                      apr_uint32_t *prefix_count,
+                      svn_cache__prefix_filter_t filter,
+                      void *filter_baton,
+                      apr_pool_t *result_pool)
+{
+  cache_level_t *levels[2];
+  int i;
+
+  /* Save L2 first, which holds the more valuable entries.  They will
+   * then be inserted before the L1 contents when loading the snapshot. */
+  levels[0] = &segment->l2;
+  levels[1] = &segment->l1;
+
+  for (i = 0; i < 2; ++i)
+    {
+      apr_uint32_t idx = levels[i]->first;
+      while (idx != NO_INDEX)
+        {
+          entry_t *entry = get_entry(segment, idx);
+          SVN_ERR(snapshot_save_entry(stream, segment, entry, prefixes,
+                                      prefix_count, filter, filter_baton,
+                                      result_pool));
+          idx = entry->next;
+        }
+    }
+
+  return SVN_NO_ERROR;
+}
+
+#endif /* SVN_DEBUG_CACHE_MEMBUFFER */
+
+svn_error_t *
+svn_cache__membuffer_save(svn_membuffer_t *cache,
+                          svn_stream_t *stream,
+                          svn_cache__prefix_filter_t filter,
+                          void *filter_baton,
+                          apr_pool_t *scratch_pool)
+{
+#ifdef SVN_DEBUG_CACHE_MEMBUFFER
+  return svn_error_create(SVN_ERR_UNSUPPORTED_FEATURE, NULL,
+                          _("Cache snapshots are not supported with "
+                            "cache consistency checks"));
+#else
+  apr_hash_t *prefixes = apr_hash_make(scratch_pool);
+  apr_uint32_t prefix_count = 0;
+  apr_uint32_t byte_order = SNAPSHOT_BYTE_ORDER;
+  apr_uint32_t tag = SNAPSHOT_END;
+  apr_uint32_t seg;
+
+  SVN_ERR(snapshot_write(stream, SNAPSHOT_MAGIC, strlen(SNAPSHOT_MAGIC)));
+  SVN_ERR(snapshot_write(stream, &byte_order, sizeof(byte_order)));
+
+  /* Readers of a segment may proceed while we write it.  Writers will
+   * usually skip the update instead of waiting for us. */
+  for (seg = 0; seg < cache->segment_count; ++seg)
+    WITH_READ_LOCK(&cache[seg],
+                   snapshot_save_segment(stream, &cache[seg], prefixes,
+                                         &prefix_count, filter,
+                                         filter_baton, scratch_pool));
+
+  return svn_error_trace(snapshot_write(stream, &tag, sizeof(tag)));
+#endif
+}
+
+#ifndef SVN_DEBUG_CACHE_MEMBUFFER
+
+/* Insert the item with the given KEY, serialized DATA of SIZE bytes and
+ * PRIORITY into CACHE, replacing any previous entry.  Use SCRATCH_POOL
+ * for temporary allocations.
+ */
+static svn_error_t *
+snapshot_load_entry(svn_membuffer_t *cache,
+                    const full_key_t *key,
+                    char *data,
+                    apr_size_t size,
+                    apr_uint32_t priority,
+                    apr_pool_t *scratch_pool)
+{
+  apr_uint32_t group_index = get_group_index(&cache, &key->entry_key);
+
+  SVN_ERR(overflow_remove(cache->overflow, key));
+
+  /* We are restoring a consistent state from before, so always wait for
+   * the lock. */
+  SVN_ERR(force_write_lock_cache(cache));
+  begin_modification(cache);
+  SVN_ERR(unlock_cache(cache,
+                       end_modification(cache,
+                          membuffer_cache_set_internal(cache, key,
+                                                       group_index,
+                                                       data, size,
+                                                       priority,
+                                                       scratch_pool))));
+
+  return SVN_NO_ERROR;
+}
+
+#endif /* SVN_DEBUG_CACHE_MEMBUFFER */
+
+svn_error_t *
+svn_cache__membuffer_load(svn_membuffer_t *cache,
+                          svn_stream_t *stream,
+                          svn_cache__prefix_filter_t filter,
+                          void *filter_baton,
+                          apr_pool_t *scratch_pool)
+{
+#ifdef SVN_DEBUG_CACHE_MEMBUFFER
+  return svn_error_create(SVN_ERR_UNSUPPORTED_FEATURE, NULL,
+                          _("Cache snapshots are not supported with "
+                            "cache consistency checks"));
+#else
+  apr_array_header_t *prefixes
+    = apr_array_make(scratch_pool, 16, sizeof(snapshot_prefix_t *));
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  char magic[sizeof(SNAPSHOT_MAGIC) - 1];
+  apr_uint32_t byte_order;
+
+  SVN_ERR(snapshot_read(stream, magic, sizeof(magic)));
+  SVN_ERR(snapshot_read(stream, &byte_order, sizeof(byte_order)));
+  if (   memcmp(magic, SNAPSHOT_MAGIC, sizeof(magic))
+      || byte_order != SNAPSHOT_BYTE_ORDER)
+    return svn_error_create(SVN_ERR_MALFORMED_FILE, NULL,
+                            _("Not a compatible cache snapshot"));
+
+  while (TRUE)
+    {
+      apr_uint32_t tag;
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(snapshot_read(stream, &tag, sizeof(tag)));
+
+      if (tag == SNAPSHOT_END)
+        break;
+
+      if (tag == SNAPSHOT_PREFIX)
+        {
+          snapshot_prefix_t *prefix;
+          apr_uint32_t len;
+          char *str;
+          svn_boolean_t keep = TRUE;
+
+          SVN_ERR(snapshot_read(stream, &len, sizeof(len)));
+          if (len >= SVN_MAX_OBJECT_SIZE)
+            return svn_error_create(SVN_ERR_MALFORMED_FILE, NULL,
+                                    _("Corrupt cache snapshot"));
+
+          str = apr_palloc(scratch_pool, len + 1);
+          SVN_ERR(snapshot_read(stream, str, len));
+          str[len] = '\0';
+
+          if (filter)
+            SVN_ERR(filter(&keep, filter_baton, str, iterpool));
+
+          prefix = apr_pcalloc(scratch_pool, sizeof(*prefix));
+          prefix->prefix = str;
+          prefix->id = keep ? (apr_uint32_t)prefixes->nelts : NO_INDEX;
+          prefix->prefix_idx = NO_INDEX;
+          APR_ARRAY_PUSH(prefixes, snapshot_prefix_t *) = prefix;
+        }
+      else if (tag == SNAPSHOT_ENTRY)
+        {
+          snapshot_entry_t header;
+          snapshot_prefix_t *prefix;
+          full_key_t key;
+          char *data;
+
+          SVN_ERR(snapshot_read(stream, &header, sizeof(header)));
+          if (   header.prefix_id >= (apr_uint32_t)prefixes->nelts
+              || header.key_len != ALIGN_VALUE(header.key_len)
+              || header.size > MAX_ITEM_SIZE - header.key_len)
+            return svn_error_create(SVN_ERR_MALFORMED_FILE, NULL,
+                                    _("Corrupt cache snapshot"));
+
+          data = apr_palloc(iterpool, header.key_len + header.size);
+          SVN_ERR(snapshot_read(stream, data, header.key_len + header.size));
+
+          prefix = APR_ARRAY_IDX(prefixes, header.prefix_id,
+                                 snapshot_prefix_t *);
+          if (prefix->id == NO_INDEX)
+            continue;
+
+          memset(&key, 0, sizeof(key));
+          key.entry_key.fingerprint[0] = header.fingerprint[0];
+          key.entry_key.fingerprint[1] = header.fingerprint[1];
+          key.entry_key.key_len = header.key_len;
+
+          if (header.key_len)
+            {
+              key.entry_key.prefix_idx = NO_INDEX;
+              key.full_key.data = data;
+              key.full_key.size = header.key_len;
+            }
+          else
+            {
+              /* Shared prefixes must be in our prefix pool. */
+              if (prefix->prefix_idx == NO_INDEX)
+                SVN_ERR(prefix_pool_get(&prefix->prefix_idx,
+                                        cache->prefix_pool,
+                                        prefix->prefix));
+              if (prefix->prefix_idx == NO_INDEX)
+                continue;
+
+              key.entry_key.prefix_idx = prefix->prefix_idx;
+            }
+
+          SVN_ERR(snapshot_load_entry(cache, &key, data + header.key_len,
+                                      header.size, header.priority,
+                                      iterpool));
+        }
+      else
+        {
+          return svn_error_create(SVN_ERR_MALFORMED_FILE, NULL,
+                                  _("Corrupt cache snapshot"));
+        }
+    }
+
+  svn_pool_destroy(iterpool);
+  return SVN_NO_ERROR;
+#endif
+}
+
 static svn_error_t *
 svn_membuffer_get_global_segment_info(svn_membuffer_t *segment,
                                       svn_cache__info_t *info)
@@ -3451,6 +5641,10 @@ svn_membuffer_get_global_segment_info(svn_membuffer_t *segment,
   info->gets += segment->total_reads;
   info->sets += segment->total_writes;
   info->hits += segment->total_hits;
+  info->evictions += segment->total_evictions;
+  info->optimistic_retries += segment->optimistic_retries;
+  info->gets += svn_atomic_read(&segment->lock_free_reads);
+  info->hits += svn_atomic_read(&segment->lock_free_hits);
 
   WITH_READ_LOCK(segment,
                   svn_membuffer_get_segment_info(segment, info, TRUE));
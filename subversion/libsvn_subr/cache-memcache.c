@@ -25,6 +25,7 @@
 
 #include "svn_pools.h"
 #include "svn_base64.h"
+#include "svn_hash.h"
 #include "svn_path.h"
 
 #include "svn_private_config.h"
@@ -176,6 +177,33 @@ memcache_internal_get(char **data,
 }
 
 
+/* De-serialize the DATA_LEN bytes of DATA read from CACHE into *VALUE_P.
+ * DATA must have been allocated in RESULT_POOL.
+ */
+static svn_error_t *
+deserialize_value(void **value_p,
+                  memcache_t *cache,
+                  char *data,
+                  apr_size_t data_len,
+                  apr_pool_t *result_pool)
+{
+  if (cache->deserialize_func)
+    {
+      SVN_ERR((cache->deserialize_func)(value_p, data, data_len,
+                                        result_pool));
+    }
+  else
+    {
+      svn_stringbuf_t *value = svn_stringbuf_create_empty(result_pool);
+      value->data = data;
+      value->blocksize = data_len;
+      value->len = data_len - 1; /* account for trailing NUL */
+      *value_p = value;
+    }
+
+  return SVN_NO_ERROR;
+}
+
 static svn_error_t *
 memcache_get(void **value_p,
              svn_boolean_t *found,
@@ -195,22 +223,70 @@ memcache_get(void **value_p,
 
   /* If we found it, de-serialize it. */
   if (*found)
+    SVN_ERR(deserialize_value(value_p, cache, data, data_len, result_pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Implement vtable.get_many.  apr_memcache sends a single pipelined
+ * "get" request for all keys to each server involved and collects the
+ * responses in parallel.
+ */
+static svn_error_t *
+memcache_get_many(apr_array_header_t *values,
+                  void *cache_void,
+                  const apr_array_header_t *keys,
+                  apr_pool_t *result_pool)
+{
+  memcache_t *cache = cache_void;
+  apr_hash_t *mc_values = NULL;
+  const char **mc_keys;
+  apr_status_t apr_err;
+  apr_pool_t *subpool;
+  int i;
+
+  subpool = svn_pool_create(result_pool);
+  mc_keys = apr_pcalloc(subpool, keys->nelts * sizeof(*mc_keys));
+  for (i = 0; i < keys->nelts; ++i)
     {
-      if (cache->deserialize_func)
-        {
-          SVN_ERR((cache->deserialize_func)(value_p, data, data_len,
-                                            result_pool));
-        }
-      else
+      const void *key = APR_ARRAY_IDX(keys, i, const void *);
+      if (key)
         {
-          svn_stringbuf_t *value = svn_stringbuf_create_empty(result_pool);
-          value->data = data;
-          value->blocksize = data_len;
-          value->len = data_len - 1; /* account for trailing NUL */
-          *value_p = value;
+          SVN_ERR(build_key(&mc_keys[i], cache, key, subpool));
+          apr_memcache_add_multget_key(subpool, mc_keys[i], &mc_values);
         }
     }
 
+  /* Nothing to look up? */
+  if (mc_values == NULL)
+    {
+      svn_pool_destroy(subpool);
+      return SVN_NO_ERROR;
+    }
+
+  /* The data will be allocated in RESULT_POOL, everything else in
+   * SUBPOOL. */
+  apr_err = apr_memcache_multgetp(cache->memcache, subpool, result_pool,
+                                  mc_values);
+  if (apr_err != APR_SUCCESS)
+    return svn_error_wrap_apr(apr_err,
+                              _("Unknown memcached error while reading"));
+
+  for (i = 0; i < keys->nelts; ++i)
+    {
+      apr_memcache_value_t *mc_value;
+
+      if (mc_keys[i] == NULL)
+        continue;
+
+      mc_value = svn_hash_gets(mc_values, mc_keys[i]);
+      if (mc_value && mc_value->status == APR_SUCCESS && mc_value->data)
+        SVN_ERR(deserialize_value(&APR_ARRAY_IDX(values, i, void *), cache,
+                                  mc_value->data, mc_value->len,
+                                  result_pool));
+    }
+
+  svn_pool_destroy(subpool);
   return SVN_NO_ERROR;
 }
 
@@ -398,7 +474,11 @@ static svn_cache__vtable_t memcache_vtable = {
   memcache_is_cachable,
   memcache_get_partial,
   memcache_set_partial,
-  memcache_get_info
+  memcache_get_info,
+  memcache_get_many,
+  NULL, /* set_many: apr_memcache has no batch store */
+  NULL, /* get_pinned */
+  NULL  /* unpin */
 };
 
 svn_error_t *
@@ -138,7 +138,11 @@ static svn_cache__vtable_t null_cache_vtable = {
   null_cache_is_cachable,
   null_cache_get_partial,
   null_cache_set_partial,
-  null_cache_get_info
+  null_cache_get_info,
+  NULL, /* get_many */
+  NULL, /* set_many */
+  NULL, /* get_pinned */
+  NULL  /* unpin */
 };
 
 svn_error_t *
@@ -95,6 +95,63 @@ svn_cache__get(void **value_p,
   return err;
 }
 
+svn_error_t *
+svn_cache__get_many(apr_array_header_t **values,
+                    svn_cache__t *cache,
+                    const apr_array_header_t *keys,
+                    apr_pool_t *result_pool)
+{
+  svn_error_t *err = SVN_NO_ERROR;
+  int i;
+
+  /* In case any errors happen and are quelched, make sure we start
+     out with nothing found. */
+  *values = apr_array_make(result_pool, keys->nelts, sizeof(void *));
+  for (i = 0; i < keys->nelts; ++i)
+    APR_ARRAY_PUSH(*values, void *) = NULL;
+
+#ifdef SVN_DEBUG
+  if (cache->pretend_empty)
+    return SVN_NO_ERROR;
+#endif
+
+  cache->reads += keys->nelts;
+  if (cache->vtable->get_many)
+    {
+      err = (cache->vtable->get_many)(*values,
+                                      cache->cache_internal,
+                                      keys,
+                                      result_pool);
+    }
+  else
+    {
+      for (i = 0; i < keys->nelts && !err; ++i)
+        {
+          void *value;
+          svn_boolean_t found = FALSE;
+
+          err = (cache->vtable->get)(&value,
+                                     &found,
+                                     cache->cache_internal,
+                                     APR_ARRAY_IDX(keys, i, const void *),
+                                     result_pool);
+          if (!err && found)
+            APR_ARRAY_IDX(*values, i, void *) = value;
+        }
+    }
+
+  /* Don't return partial results. */
+  if (err)
+    for (i = 0; i < keys->nelts; ++i)
+      APR_ARRAY_IDX(*values, i, void *) = NULL;
+
+  for (i = 0; i < keys->nelts; ++i)
+    if (APR_ARRAY_IDX(*values, i, void *))
+      cache->hits++;
+
+  return handle_error(cache, err, result_pool);
+}
+
 svn_error_t *
 svn_cache__has_key(svn_boolean_t *found,
                    svn_cache__t *cache,
@@ -130,6 +187,37 @@ svn_cache__set(svn_cache__t *cache,
                       scratch_pool);
 }
 
+svn_error_t *
+svn_cache__set_many(svn_cache__t *cache,
+                    const apr_array_header_t *keys,
+                    const apr_array_header_t *values,
+                    apr_pool_t *scratch_pool)
+{
+  svn_error_t *err = SVN_NO_ERROR;
+  int i;
+
+  SVN_ERR_ASSERT(keys->nelts == values->nelts);
+
+  cache->writes += keys->nelts;
+  if (cache->vtable->set_many)
+    {
+      err = (cache->vtable->set_many)(cache->cache_internal,
+                                      keys,
+                                      values,
+                                      scratch_pool);
+    }
+  else
+    {
+      for (i = 0; i < keys->nelts && !err; ++i)
+        err = (cache->vtable->set)(cache->cache_internal,
+                                   APR_ARRAY_IDX(keys, i, const void *),
+                                   APR_ARRAY_IDX(values, i, void *),
+                                   scratch_pool);
+    }
+
+  return handle_error(cache, err, scratch_pool);
+}
+
 
 svn_error_t *
 svn_cache__iter(svn_boolean_t *completed,
@@ -187,6 +275,119 @@ svn_cache__get_partial(void **value,
   return err;
 }
 
+/* Reference to a pinned cache entry.
+ */
+struct svn_cache__pinned_t
+{
+  /* The cache that returned the entry. */
+  svn_cache__t *cache;
+
+  /* To be passed to CACHE's unpin function. */
+  void *baton;
+
+  /* The pool that the release is registered with. */
+  apr_pool_t *pool;
+};
+
+/* Release the entry referenced by the svn_cache__pinned_t in DATA.
+ * Implements a pool cleanup function.
+ */
+static apr_status_t
+release_pin(void *data)
+{
+  svn_cache__pinned_t *pin = data;
+  svn_error_t *err = (pin->cache->vtable->unpin)(pin->baton);
+  apr_status_t status = err ? err->apr_err : APR_SUCCESS;
+
+  svn_error_clear(err);
+  return status;
+}
+
+/* Implement svn_cache__partial_getter_func_t by returning a copy of
+ * DATA in *OUT, allocated in RESULT_POOL, and its length in *BATON.
+ * This is the fallback for caches that don't support pinned access.
+ */
+static svn_error_t *
+copy_serialized(void **out,
+                const void *data,
+                apr_size_t data_len,
+                void *baton,
+                apr_pool_t *result_pool)
+{
+  *(apr_size_t *)baton = data_len;
+  *out = apr_pmemdup(result_pool, data, data_len);
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_cache__get_pinned(const void **data,
+                      apr_size_t *data_len,
+                      svn_boolean_t *found,
+                      svn_cache__pinned_t **pin,
+                      svn_cache__t *cache,
+                      const void *key,
+                      apr_pool_t *result_pool)
+{
+  svn_error_t *err;
+  void *baton = NULL;
+
+  /* In case any errors happen and are quelched, make sure we start
+  out with FOUND set to false. */
+  *found = FALSE;
+  *data = NULL;
+  *data_len = 0;
+  *pin = NULL;
+#ifdef SVN_DEBUG
+  if (cache->pretend_empty)
+    return SVN_NO_ERROR;
+#endif
+
+  if (cache->vtable->get_pinned == NULL)
+    return svn_error_trace(svn_cache__get_partial((void **)data, found,
+                                                  cache, key,
+                                                  copy_serialized,
+                                                  data_len,
+                                                  result_pool));
+
+  cache->reads++;
+  err = handle_error(cache,
+                     (cache->vtable->get_pinned)(data,
+                                                 data_len,
+                                                 found,
+                                                 &baton,
+                                                 cache->cache_internal,
+                                                 key,
+                                                 result_pool),
+                     result_pool);
+
+  if (*found)
+    cache->hits++;
+
+  if (baton)
+    {
+      *pin = apr_palloc(result_pool, sizeof(**pin));
+      (*pin)->cache = cache;
+      (*pin)->baton = baton;
+      (*pin)->pool = result_pool;
+
+      apr_pool_cleanup_register(result_pool, *pin, release_pin,
+                                apr_pool_cleanup_null);
+    }
+
+  return err;
+}
+
+svn_error_t *
+svn_cache__unpin(svn_cache__pinned_t *pin)
+{
+  if (pin == NULL)
+    return SVN_NO_ERROR;
+
+  apr_pool_cleanup_kill(pin->pool, pin, release_pin);
+  return svn_error_trace((pin->cache->vtable->unpin)(pin->baton));
+}
+
 svn_error_t *
 svn_cache__set_partial(svn_cache__t *cache,
                        const void *key,
@@ -296,6 +497,8 @@ svn_cache__format_info(const svn_cache__info_t *info,
                             "sets    : %" APR_UINT64_T_FMT
                             " (%5.2f%% of misses)\n"
                             "failures: %" APR_UINT64_T_FMT "\n"
+                            "lockfree: %" APR_UINT64_T_FMT " hits"
+                            ", %" APR_UINT64_T_FMT " retries\n"
                             "used    : %" APR_UINT64_T_FMT " MB (%5.2f%%)"
                             " of %" APR_UINT64_T_FMT " MB data cache"
                             " / %" APR_UINT64_T_FMT " MB total cache memory\n"
@@ -308,6 +511,8 @@ svn_cache__format_info(const svn_cache__info_t *info,
                             info->hits, hit_rate,
                             info->sets, write_rate,
                             info->failures,
+                            info->lock_free_hits,
+                            info->optimistic_retries,
 
                             info->used_size / _1MB, data_usage_rate,
                             info->data_size / _1MB,
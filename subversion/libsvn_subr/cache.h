@@ -82,6 +82,36 @@ typedef struct svn_cache__vtable_t {
                            svn_cache__info_t *info,
                            svn_boolean_t reset,
                            apr_pool_t *result_pool);
+
+  /* See svn_cache__get_many().  VALUES has already been filled with
+     NULL values for all KEYS.  May be NULL, in which case the values
+     will be fetched one by one using GET. */
+  svn_error_t *(*get_many)(apr_array_header_t *values,
+                           void *cache_implementation,
+                           const apr_array_header_t *keys,
+                           apr_pool_t *result_pool);
+
+  /* See svn_cache__set_many().  May be NULL, in which case the values
+     will be stored one by one using SET. */
+  svn_error_t *(*set_many)(void *cache_implementation,
+                           const apr_array_header_t *keys,
+                           const apr_array_header_t *values,
+                           apr_pool_t *scratch_pool);
+
+  /* See svn_cache__get_pinned().  Set *PIN_BATON to whatever UNPIN needs
+     to release the entry or to NULL if there is nothing to release.
+     May be NULL, in which case a copy will be fetched using GET_PARTIAL. */
+  svn_error_t *(*get_pinned)(const void **data,
+                             apr_size_t *data_len,
+                             svn_boolean_t *found,
+                             void **pin_baton,
+                             void *cache_implementation,
+                             const void *key,
+                             apr_pool_t *result_pool);
+
+  /* Release the entry referenced by PIN_BATON, as returned by GET_PINNED.
+     Only used (and required) if GET_PINNED is not NULL. */
+  svn_error_t *(*unpin)(void *pin_baton);
 } svn_cache__vtable_t;
 
 struct svn_cache__t {
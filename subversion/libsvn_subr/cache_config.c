@@ -64,6 +64,17 @@ static svn_cache_config_t cache_settings =
 #endif
 };
 
+/* Whether the process-global membuffer cache shall be placed in shared
+ * memory.  Not part of svn_cache_config_t to keep that ABI stable.
+ */
+static svn_boolean_t cache_shared = FALSE;
+
+/* Directory and size of the overflow file of the process-global membuffer
+ * cache.  No overflow file is being used if CACHE_OVERFLOW_SIZE is 0.
+ */
+static const char *cache_overflow_dir = NULL;
+static apr_uint64_t cache_overflow_size = 0;
+
 /* Get the current FSFS cache configuration. */
 const svn_cache_config_t *
 svn_cache_config_get(void)
@@ -120,14 +131,39 @@ initialize_cache(void *baton, apr_pool_t *unused_pool)
         return SVN_NO_ERROR;
       apr_allocator_owner_set(allocator, pool);
 
-      err = svn_cache__membuffer_cache_create(
-          &cache,
-          (apr_size_t)cache_size,
-          (apr_size_t)(cache_size / 5),
-          0,
-          ! svn_cache_config_get()->single_threaded,
-          FALSE,
-          pool);
+      /* Try shared memory first, if requested, and fall back to a
+       * process-local cache if that is not available.
+       */
+      if (cache_shared)
+        {
+          err = svn_cache__membuffer_cache_create(
+              &cache,
+              (apr_size_t)cache_size,
+              (apr_size_t)(cache_size / 5),
+              0,
+              ! svn_cache_config_get()->single_threaded,
+              FALSE,
+              TRUE,
+              pool);
+          if (err)
+            {
+              svn_error_clear(err);
+              svn_pool_clear(pool);
+              cache = NULL;
+            }
+        }
+
+      err = cache
+          ? SVN_NO_ERROR
+          : svn_cache__membuffer_cache_create(
+              &cache,
+              (apr_size_t)cache_size,
+              (apr_size_t)(cache_size / 5),
+              0,
+              ! svn_cache_config_get()->single_threaded,
+              FALSE,
+              FALSE,
+              pool);
 
       /* Some error occurred. Most likely it's an OOM error but we don't
        * really care. Simply release all cache memory and disable caching
@@ -143,6 +179,16 @@ initialize_cache(void *baton, apr_pool_t *unused_pool)
           return svn_error_trace(err);
         }
 
+      /* Extend the cache to disk, if requested.  The cache is still fully
+       * functional if that fails. */
+      if (cache_overflow_size && cache_overflow_dir)
+        svn_error_clear(svn_cache__membuffer_attach_overflow(
+                            cache,
+                            cache_overflow_dir,
+                            cache_overflow_size,
+                            ! svn_cache_config_get()->single_threaded,
+                            pool));
+
       /* done */
       *cache_p = cache;
     }
@@ -179,3 +225,22 @@ svn_cache_config_set(const svn_cache_config_t *settings)
   cache_settings = *settings;
 }
 
+void
+svn_cache__set_global_membuffer_shared(svn_boolean_t shared)
+{
+  cache_shared = shared;
+}
+
+svn_boolean_t
+svn_cache__get_global_membuffer_shared(void)
+{
+  return cache_shared;
+}
+
+void
+svn_cache__set_global_membuffer_overflow(const char *dir_path,
+                                         apr_uint64_t size)
+{
+  cache_overflow_dir = dir_path;
+  cache_overflow_size = size;
+}
@@ -35,6 +35,7 @@
 
 #include "checksum.h"
 #include "fnv1a.h"
+#include "sha.h"
 
 #include "private/svn_subr_private.h"
 
@@ -93,6 +94,9 @@ static const char *ckind_str[] = {
 #define DIGESTSIZE(k) \
   (((k) < svn_checksum_md5 || (k) > svn_checksum_fnv1a_32x4) ? 0 : digest_sizes[k])
 
+/* Number of supported checksum kinds. */
+#define KIND_COUNT (svn_checksum_fnv1a_32x4 + 1)
+
 /* Largest supported digest size */
 #define MAX_DIGESTSIZE (MAX(APR_MD5_DIGESTSIZE,APR_SHA1_DIGESTSIZE))
 
@@ -475,7 +479,7 @@ svn_checksum(svn_checksum_t **checksum,
              apr_size_t len,
              apr_pool_t *pool)
 {
-  apr_sha1_ctx_t sha1_ctx;
+  svn_sha1__context_t *sha1_ctx;
 
   SVN_ERR(validate_kind(kind));
   *checksum = svn_checksum_create(kind, pool);
@@ -487,9 +491,9 @@ svn_checksum(svn_checksum_t **checksum,
         break;
 
       case svn_checksum_sha1:
-        apr_sha1_init(&sha1_ctx);
-        apr_sha1_update(&sha1_ctx, data, (unsigned int)len);
-        apr_sha1_final((unsigned char *)(*checksum)->digest, &sha1_ctx);
+        sha1_ctx = svn_sha1__context_create(pool);
+        svn_sha1__update(sha1_ctx, data, len);
+        svn_sha1__finalize((unsigned char *)(*checksum)->digest, sha1_ctx);
         break;
 
       case svn_checksum_fnv1a_32:
@@ -550,8 +554,7 @@ svn_checksum_ctx_create(svn_checksum_kind_t kind,
         break;
 
       case svn_checksum_sha1:
-        ctx->apr_ctx = apr_palloc(pool, sizeof(apr_sha1_ctx_t));
-        apr_sha1_init(ctx->apr_ctx);
+        ctx->apr_ctx = svn_sha1__context_create(pool);
         break;
 
       case svn_checksum_fnv1a_32:
@@ -580,8 +583,7 @@ svn_checksum_ctx_reset(svn_checksum_ctx_t *ctx)
         break;
 
       case svn_checksum_sha1:
-        memset(ctx->apr_ctx, 0, sizeof(apr_sha1_ctx_t));
-        apr_sha1_init(ctx->apr_ctx);
+        svn_sha1__context_reset(ctx->apr_ctx);
         break;
 
       case svn_checksum_fnv1a_32:
@@ -611,7 +613,7 @@ svn_checksum_update(svn_checksum_ctx_t *ctx,
         break;
 
       case svn_checksum_sha1:
-        apr_sha1_update(ctx->apr_ctx, data, (unsigned int)len);
+        svn_sha1__update(ctx->apr_ctx, data, len);
         break;
 
       case svn_checksum_fnv1a_32:
@@ -644,7 +646,8 @@ svn_checksum_final(svn_checksum_t **checksum,
         break;
 
       case svn_checksum_sha1:
-        apr_sha1_final((unsigned char *)(*checksum)->digest, ctx->apr_ctx);
+        svn_sha1__finalize((unsigned char *)(*checksum)->digest,
+                           ctx->apr_ctx);
         break;
 
       case svn_checksum_fnv1a_32:
@@ -665,6 +668,86 @@ svn_checksum_final(svn_checksum_t **checksum,
   return SVN_NO_ERROR;
 }
 
+/* Feed data into multi-checksum contexts in chunks of that size.  Small
+ * enough to stay in the L1 cache while we update all checksums with it. */
+#define MULTI_CHUNK_SIZE 0x2000
+
+struct svn_checksum__multi_ctx_t
+{
+  /* Contexts of the checksums to calculate, indexed by kind, or NULL. */
+  svn_checksum_ctx_t *contexts[KIND_COUNT];
+};
+
+svn_checksum__multi_ctx_t *
+svn_checksum__multi_ctx_create(unsigned kinds,
+                               apr_pool_t *pool)
+{
+  svn_checksum__multi_ctx_t *ctx = apr_pcalloc(pool, sizeof(*ctx));
+  int kind;
+
+  for (kind = 0; kind < KIND_COUNT; ++kind)
+    if (kinds & SVN_CHECKSUM__KIND_FLAG(kind))
+      ctx->contexts[kind] = svn_checksum_ctx_create(kind, pool);
+
+  return ctx;
+}
+
+svn_error_t *
+svn_checksum__multi_ctx_reset(svn_checksum__multi_ctx_t *ctx)
+{
+  int kind;
+
+  for (kind = 0; kind < KIND_COUNT; ++kind)
+    if (ctx->contexts[kind])
+      SVN_ERR(svn_checksum_ctx_reset(ctx->contexts[kind]));
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_checksum__multi_update(svn_checksum__multi_ctx_t *ctx,
+                           const void *data,
+                           apr_size_t len)
+{
+  const char *chunk = data;
+
+  while (len)
+    {
+      apr_size_t chunk_len = MIN(len, MULTI_CHUNK_SIZE);
+      int kind;
+
+      for (kind = 0; kind < KIND_COUNT; ++kind)
+        if (ctx->contexts[kind])
+          SVN_ERR(svn_checksum_update(ctx->contexts[kind], chunk,
+                                      chunk_len));
+
+      chunk += chunk_len;
+      len -= chunk_len;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+svn_checksum_ctx_t *
+svn_checksum__multi_ctx_get(const svn_checksum__multi_ctx_t *ctx,
+                            svn_checksum_kind_t kind)
+{
+  return (kind < KIND_COUNT) ? ctx->contexts[kind] : NULL;
+}
+
+svn_error_t *
+svn_checksum__multi_final(svn_checksum_t **checksum,
+                          const svn_checksum__multi_ctx_t *ctx,
+                          svn_checksum_kind_t kind,
+                          apr_pool_t *pool)
+{
+  if (kind >= KIND_COUNT || !ctx->contexts[kind])
+    return svn_error_create(SVN_ERR_BAD_CHECKSUM_KIND, NULL, NULL);
+
+  return svn_error_trace(svn_checksum_final(checksum, ctx->contexts[kind],
+                                            pool));
+}
+
 apr_size_t
 svn_checksum_size(const svn_checksum_t *checksum)
 {
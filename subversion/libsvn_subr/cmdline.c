@@ -66,6 +66,7 @@
 #include "private/svn_utf_private.h"
 #include "private/svn_sorts_private.h"
 #include "private/svn_string_private.h"
+#include "private/svn_subr_private.h"
 
 #include "svn_private_config.h"
 
@@ -92,6 +93,26 @@ static svn_boolean_t shortcut_stderr_to_console = FALSE;
 #endif
 
 
+/* The file to write the pool profile to at exit, if requested. */
+static const char *pool_profile_path = NULL;
+
+/* atexit() handler writing the pool profile to POOL_PROFILE_PATH. */
+static void
+write_pool_profile(void)
+{
+  apr_pool_t *pool = svn_pool_create(NULL);
+  const char *path;
+  svn_error_t *err;
+
+  err = svn_utf_cstring_to_utf8(&path, pool_profile_path, pool);
+  if (!err)
+    err = svn_pool__profile_write(svn_dirent_internal_style(path, pool),
+                                  pool);
+
+  svn_error_clear(err);
+  svn_pool_destroy(pool);
+}
+
 int
 svn_cmdline_init(const char *progname, FILE *error_stream)
 {
@@ -252,6 +273,25 @@ svn_cmdline_init(const char *progname, FILE *error_stream)
       return EXIT_FAILURE;
     }
 
+  /* Include all pools created from here on in the pool profile.  Being
+     registered after apr_terminate(), the profile gets written first. */
+  pool_profile_path = getenv(SVN_POOL__PROFILE_ENV);
+  if (pool_profile_path && *pool_profile_path)
+    {
+      err = svn_pool__profile_enable();
+      if (!err && 0 > atexit(write_pool_profile))
+        err = svn_error_create(SVN_ERR_BASE, NULL,
+                               "atexit registration failed");
+
+      if (err)
+        {
+          if (error_stream)
+            svn_handle_warning2(error_stream, err, prefix_buf);
+
+          svn_error_clear(err);
+        }
+    }
+
   /* Create a pool for use by the UTF-8 routines.  It will be cleaned
      up by APR at exit time. */
   pool = svn_pool_create(NULL);
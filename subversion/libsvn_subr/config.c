@@ -31,13 +31,16 @@
 
 #include <apr_general.h>
 #include <apr_lib.h>
+#include "svn_ctype.h"
 #include "svn_hash.h"
 #include "svn_error.h"
 #include "svn_string.h"
 #include "svn_pools.h"
+#include "svn_io.h"
 #include "config_impl.h"
 
 #include "private/svn_dep_compat.h"
+#include "private/svn_string_private.h"
 #include "private/svn_subr_private.h"
 #include "private/svn_config_private.h"
 
@@ -286,6 +289,278 @@ read_all(svn_config_t **cfgp,
 }
 
 
+/* Iterate through CFG, passing BATON to CALLBACK for every (SECTION, OPTION)
+   pair.  Stop if CALLBACK returns TRUE.  Allocate from POOL. */
+static void
+for_each_option(svn_config_t *cfg, void *baton, apr_pool_t *pool,
+                svn_boolean_t callback(void *same_baton,
+                                       cfg_section_t *section,
+                                       cfg_option_t *option))
+{
+  apr_hash_index_t *sec_ndx;
+  for (sec_ndx = apr_hash_first(pool, cfg->sections);
+       sec_ndx != NULL;
+       sec_ndx = apr_hash_next(sec_ndx))
+    {
+      cfg_section_t *sec = apr_hash_this_val(sec_ndx);
+      apr_hash_index_t *opt_ndx;
+
+      for (opt_ndx = apr_hash_first(pool, sec->options);
+           opt_ndx != NULL;
+           opt_ndx = apr_hash_next(opt_ndx))
+        {
+          cfg_option_t *opt = apr_hash_this_val(opt_ndx);
+
+          if (callback(baton, sec, opt))
+            return;
+        }
+    }
+}
+
+/* Parsed run-time configurations get cached in a file next to the user's
+ * configuration file.  The cache starts with CONFIG_CACHE_MAGIC, followed
+ * by the length-prefixed stamp of the source files (see append_stamp())
+ * and one length-prefixed record for each "section option value" triple.
+ */
+#define CONFIG_CACHE_SUFFIX ".cache"
+#define CONFIG_CACHE_MAGIC "svn-config-cache 1\n"
+
+/* Files modified less than this time ago may get modified again without
+ * changing their timestamp; don't trust a cache for them. */
+#define CONFIG_CACHE_MIN_AGE apr_time_from_sec(2)
+
+/* Append the size and modification time of the file PATH to STAMP.  If
+ * PATH is NULL or the file does not exist, record that instead.  Set
+ * *RECENT if the file has been modified less than CONFIG_CACHE_MIN_AGE
+ * ago.  Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+append_stamp(svn_stringbuf_t *stamp,
+             svn_boolean_t *recent,
+             const char *path,
+             apr_pool_t *scratch_pool)
+{
+  apr_finfo_t finfo;
+  svn_error_t *err;
+
+  if (!path)
+    {
+      svn_stringbuf_appendcstr(stamp, "-\n");
+      return SVN_NO_ERROR;
+    }
+
+  err = svn_io_stat(&finfo, path, APR_FINFO_SIZE | APR_FINFO_MTIME,
+                    scratch_pool);
+  if (err && (APR_STATUS_IS_ENOENT(err->apr_err)
+              || SVN__APR_STATUS_IS_ENOTDIR(err->apr_err)))
+    {
+      svn_error_clear(err);
+      svn_stringbuf_appendcstr(stamp,
+                               apr_psprintf(scratch_pool, "%s -\n", path));
+      return SVN_NO_ERROR;
+    }
+  SVN_ERR(err);
+
+  if (finfo.mtime > apr_time_now() - CONFIG_CACHE_MIN_AGE)
+    *recent = TRUE;
+
+  svn_stringbuf_appendcstr(stamp,
+                           apr_psprintf(scratch_pool,
+                                        "%s %" APR_OFF_T_FMT
+                                        " %" APR_TIME_T_FMT "\n",
+                                        path, finfo.size, finfo.mtime));
+  return SVN_NO_ERROR;
+}
+
+/* Read the length prefix at *P, which must be followed by TERMINATOR and
+ * at most END - *P - 1 bytes of data, into *LEN and move *P behind the
+ * terminator.  Return FALSE if the data is malformed. */
+static svn_boolean_t
+read_length(apr_size_t *len,
+            const char **p,
+            const char *end,
+            char terminator)
+{
+  const char *next;
+
+  if (*p >= end || !svn_ctype_isdigit(**p))
+    return FALSE;
+
+  *len = svn__strtoul(*p, &next);
+  if (   next >= end || *next != terminator
+      || *len > (apr_size_t)(end - next - 1))
+    return FALSE;
+
+  *p = next + 1;
+  return TRUE;
+}
+
+/* If the cache file CACHE_PATH exists and matches STAMP, return the
+ * configuration cached in it in *CFGP, allocated in RESULT_POOL.
+ * Otherwise, set *CFGP to NULL.  Use SCRATCH_POOL for temporary
+ * allocations. */
+static svn_error_t *
+read_config_cache(svn_config_t **cfgp,
+                  const char *cache_path,
+                  const svn_stringbuf_t *stamp,
+                  apr_pool_t *result_pool,
+                  apr_pool_t *scratch_pool)
+{
+  svn_stringbuf_t *content;
+  svn_config_t *cfg;
+  const char *p, *end;
+  apr_size_t len;
+  svn_error_t *err;
+
+  *cfgp = NULL;
+
+  err = svn_stringbuf_from_file2(&content, cache_path, scratch_pool);
+  if (err && APR_STATUS_IS_ENOENT(err->apr_err))
+    {
+      svn_error_clear(err);
+      return SVN_NO_ERROR;
+    }
+  SVN_ERR(err);
+
+  p = content->data;
+  end = p + content->len;
+  if (strncmp(p, CONFIG_CACHE_MAGIC, sizeof(CONFIG_CACHE_MAGIC) - 1))
+    return SVN_NO_ERROR;
+
+  /* Out of date? */
+  p += sizeof(CONFIG_CACHE_MAGIC) - 1;
+  if (   !read_length(&len, &p, end, '\n')
+      || len != stamp->len
+      || memcmp(p, stamp->data, len))
+    return SVN_NO_ERROR;
+
+  p += len;
+
+  /* Read all options.  Ignore the cache if it is malformed. */
+  SVN_ERR(svn_config_create2(&cfg, FALSE, FALSE, result_pool));
+  while (p < end)
+    {
+      apr_size_t section_len, option_len, value_len;
+      const char *section, *option, *value;
+
+      if (   !read_length(&section_len, &p, end, ' ')
+          || !read_length(&option_len, &p, end, ' ')
+          || !read_length(&value_len, &p, end, '\n')
+          || section_len + option_len + value_len > (apr_size_t)(end - p))
+        return SVN_NO_ERROR;
+
+      section = apr_pstrmemdup(scratch_pool, p, section_len);
+      p += section_len;
+      option = apr_pstrmemdup(scratch_pool, p, option_len);
+      p += option_len;
+      value = apr_pstrmemdup(scratch_pool, p, value_len);
+      p += value_len;
+
+      svn_config_set(cfg, section, option, value);
+    }
+
+  *cfgp = cfg;
+  return SVN_NO_ERROR;
+}
+
+/* Implements the for_each_option() callback appending the unexpanded
+ * OPTION in SECTION to the svn_stringbuf_t BATON. */
+static svn_boolean_t
+cache_callback(void *baton, cfg_section_t *section, cfg_option_t *option)
+{
+  svn_stringbuf_t *content = baton;
+  apr_size_t section_len = strlen(section->name);
+  apr_size_t option_len = strlen(option->name);
+  apr_size_t value_len = strlen(option->value);
+
+  svn_stringbuf_appendcstr(content,
+                           apr_psprintf(content->pool,
+                                        "%" APR_SIZE_T_FMT
+                                        " %" APR_SIZE_T_FMT
+                                        " %" APR_SIZE_T_FMT "\n",
+                                        section_len, option_len,
+                                        value_len));
+  svn_stringbuf_appendbytes(content, section->name, section_len);
+  svn_stringbuf_appendbytes(content, option->name, option_len);
+  svn_stringbuf_appendbytes(content, option->value, value_len);
+
+  return FALSE;
+}
+
+/* Write CFG with the sources' STAMP to CACHE_PATH.  Use SCRATCH_POOL for
+ * temporary allocations. */
+static svn_error_t *
+write_config_cache(const char *cache_path,
+                   svn_config_t *cfg,
+                   const svn_stringbuf_t *stamp,
+                   apr_pool_t *scratch_pool)
+{
+  svn_stringbuf_t *content
+    = svn_stringbuf_create(CONFIG_CACHE_MAGIC, scratch_pool);
+
+  svn_stringbuf_appendcstr(content,
+                           apr_psprintf(scratch_pool,
+                                        "%" APR_SIZE_T_FMT "\n",
+                                        stamp->len));
+  svn_stringbuf_appendstr(content, stamp);
+  for_each_option(cfg, content, scratch_pool, cache_callback);
+
+  return svn_error_trace(svn_io_write_atomic2(cache_path, content->data,
+                                              content->len, NULL, FALSE,
+                                              scratch_pool));
+}
+
+/* Like read_all() without registry paths but use the cache file next to
+ * USR_FILE_PATH if it is up to date and update it otherwise.  Parsing
+ * text files is a noticeable part of the start-up time of short-lived
+ * client processes. */
+static svn_error_t *
+read_all_cached(svn_config_t **cfgp,
+                const char *sys_file_path,
+                const char *usr_file_path,
+                apr_pool_t *pool)
+{
+  apr_pool_t *scratch_pool = svn_pool_create(pool);
+  svn_stringbuf_t *stamp = svn_stringbuf_create_empty(scratch_pool);
+  svn_boolean_t recent = FALSE;
+  const char *cache_path = apr_pstrcat(scratch_pool, usr_file_path,
+                                       CONFIG_CACHE_SUFFIX, SVN_VA_NULL);
+  svn_error_t *err;
+
+  /* Take the stamp before reading the files, so that modifications
+     after this point invalidate the new cache.  The cache is an
+     optimization only, so ignore all errors with it. */
+  err = append_stamp(stamp, &recent, sys_file_path, scratch_pool);
+  if (!err)
+    err = append_stamp(stamp, &recent, usr_file_path, scratch_pool);
+  if (err)
+    {
+      svn_error_clear(err);
+      recent = TRUE;
+    }
+
+  *cfgp = NULL;
+  if (!recent)
+    {
+      err = read_config_cache(cfgp, cache_path, stamp, pool, scratch_pool);
+      svn_error_clear(err);
+    }
+
+  if (!*cfgp)
+    {
+      SVN_ERR(read_all(cfgp, NULL, NULL, sys_file_path, usr_file_path,
+                       pool));
+      if (!recent)
+        {
+          err = write_config_cache(cache_path, *cfgp, stamp, scratch_pool);
+          svn_error_clear(err);
+        }
+    }
+
+  svn_pool_destroy(scratch_pool);
+  return SVN_NO_ERROR;
+}
+
+
 /* CONFIG_DIR provides an override for the default behavior of reading
    the default set of overlay files described by read_all()'s doc
    string.  Returns non-NULL *CFG or an error. */
@@ -324,6 +599,10 @@ get_category_config(svn_config_t **cfg,
 
   SVN_ERR(svn_config_get_user_config_path(&usr_cfg_path, config_dir, category,
                                           pool));
+  if (usr_cfg_path && !sys_reg_path && !usr_reg_path)
+    return svn_error_trace(read_all_cached(cfg, sys_cfg_path, usr_cfg_path,
+                                           pool));
+
   return read_all(cfg, sys_reg_path, usr_reg_path,
                   sys_cfg_path, usr_cfg_path, pool);
 }
@@ -365,36 +644,6 @@ svn_config__get_default_config(apr_hash_t **cfg_hash,
 }
 
 
-
-/* Iterate through CFG, passing BATON to CALLBACK for every (SECTION, OPTION)
-   pair.  Stop if CALLBACK returns TRUE.  Allocate from POOL. */
-static void
-for_each_option(svn_config_t *cfg, void *baton, apr_pool_t *pool,
-                svn_boolean_t callback(void *same_baton,
-                                       cfg_section_t *section,
-                                       cfg_option_t *option))
-{
-  apr_hash_index_t *sec_ndx;
-  for (sec_ndx = apr_hash_first(pool, cfg->sections);
-       sec_ndx != NULL;
-       sec_ndx = apr_hash_next(sec_ndx))
-    {
-      cfg_section_t *sec = apr_hash_this_val(sec_ndx);
-      apr_hash_index_t *opt_ndx;
-
-      for (opt_ndx = apr_hash_first(pool, sec->options);
-           opt_ndx != NULL;
-           opt_ndx = apr_hash_next(opt_ndx))
-        {
-          cfg_option_t *opt = apr_hash_this_val(opt_ndx);
-
-          if (callback(baton, sec, opt))
-            return;
-        }
-    }
-}
-
-
 
 static svn_boolean_t
 merge_callback(void *baton, cfg_section_t *section, cfg_option_t *option)
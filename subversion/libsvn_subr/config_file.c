@@ -1155,6 +1155,12 @@ svn_config_ensure(const char *config_dir, apr_pool_t *pool)
         "###                              HTTP operation."                   NL
         "###   http-chunked-requests      Whether to use chunked transfer"   NL
         "###                              encoding for HTTP requests body."  NL
+        "###   http-h2                    Whether to offer HTTP/2 to https://"
+                                                                             NL
+        "###                              servers (requires serf 1.4+)."     NL
+        "###   http-adaptive-concurrency  Whether to adjust the number of"   NL
+        "###                              parallel requests during updates"  NL
+        "###                              to the observed throughput."       NL
         "###   ssl-authority-files        List of files, each of a trusted CA"
                                                                              NL
         "###   ssl-trust-default-ca       Trust the system 'default' CAs"    NL
@@ -1513,6 +1519,43 @@ svn_config_ensure(const char *config_dir, apr_pool_t *pool)
         "### to show meaningful differences for binary file formats.  [New"  NL
         "### in 1.9]"                                                        NL
         "# diff-ignore-content-type = no"                                    NL
+        "### Set commit-delta-threads to the number of threads computing"    NL
+        "### the text deltas and checksums of modified files while a commit" NL
+        "### is sending them to the repository.  The deltas are still sent"  NL
+        "### in order; only their computation is done concurrently.  It"     NL
+        "### defaults to 1, i.e. no concurrency.  [New in 1.11]"             NL
+        "# commit-delta-threads = 1"                                         NL
+        "### Set blame-diff-threads to the number of threads comparing"      NL
+        "### consecutive file revisions while 'svn blame' is receiving"      NL
+        "### them.  The results are still combined in order.  It defaults"   NL
+        "### to 1, i.e. no concurrency.  [New in 1.11]"                      NL
+        "# blame-diff-threads = 1"                                           NL
+        "### Set export-threads to the number of threads translating and"    NL
+        "### writing the files of 'svn export' from a repository while"      NL
+        "### further files are being received.  It defaults to 1, i.e. each" NL
+        "### file is written before the next one is received."               NL
+        "### [New in 1.11]"                                                  NL
+        "# export-threads = 1"                                               NL
+        "### Set diff-threads to the number of threads comparing files and"  NL
+        "### running the diff-cmd while 'svn diff' compares the BASE and"    NL
+        "### WORKING versions of a working copy.  The output is still"       NL
+        "### written in order.  Git-style diffs are always written by a"     NL
+        "### single thread.  It defaults to 1, i.e. no concurrency."         NL
+        "### [New in 1.11]"                                                  NL
+        "# diff-threads = 1"                                                 NL
+        "### Set checkout-threads to the number of connections over which"   NL
+        "### a fresh checkout receives the top-level directories of the"     NL
+        "### tree concurrently.  All changes are still written to the"       NL
+        "### working copy by a single thread.  It defaults to 1, i.e. the"   NL
+        "### whole tree is received over one connection.  [New in 1.11]"     NL
+        "# checkout-threads = 1"                                             NL
+        "### Set import-threads to the number of threads reading,"           NL
+        "### detranslating and checksumming files while 'svn import'"        NL
+        "### sends them to the repository.  Their contents are then"         NL
+        "### uploaded in the background, over several connections for"       NL
+        "### http:// URLs.  It defaults to 1, i.e. no concurrency."          NL
+        "### [New in 1.11]"                                                  NL
+        "# import-threads = 1"                                               NL
         ""                                                                   NL
         "### Section for configuring automatic properties."                  NL
         "[auto-props]"                                                       NL
@@ -1554,6 +1597,47 @@ svn_config_ensure(const char *config_dir, apr_pool_t *pool)
         "### returning an error.  The default is 10000, i.e. 10 seconds."    NL
         "### Longer values may be useful when exclusive locking is enabled." NL
         "# busy-timeout = 10000"                                             NL
+        "### Set to the absolute path of a directory that all working"       NL
+        "### copies on this machine share as a store of pristine texts."    NL
+        "### Files already in that store need not be downloaded again when"  NL
+        "### checking out or updating other working copies over http://."   NL
+        "# shared-pristine-directory ="                                      NL
+        "### Set to a command that reports the paths changed within a"       NL
+        "### working copy since the last 'svn status', as tracked by a"      NL
+        "### filesystem monitor.  Status then only checks directories with"  NL
+        "### changes for local modifications.  The command gets invoked"     NL
+        "### with the working copy root and the token it printed last time"  NL
+        "### and must print a new token followed by one changed path per"    NL
+        "### line, or a line containing only '/' if everything may have"    NL
+        "### changed."                                                       NL
+        "# fsmonitor-hook ="                                                 NL
+        "### Set install-threads to the number of threads translating and"   NL
+        "### installing working files while checkouts, updates and reverts"  NL
+        "### process their work queue.  It defaults to 1, i.e. all files"    NL
+        "### are installed one after the other."                             NL
+        "# install-threads = 1"                                              NL
+        "### Set link-pristines to true to install read-only working files"  NL
+        "### (those with svn:needs-lock) that need no translation as hard"   NL
+        "### links to their pristine copy, if the filesystem doesn't"       NL
+        "### support copy-on-write clones.  This saves disk space but lets"  NL
+        "### any modification made to such a file bypassing 'svn lock'"      NL
+        "### corrupt the pristine copy."                                     NL
+        "# link-pristines = false"                                           NL
+        "### Set store-pristine to false to create new working copies that"  NL
+        "### don't keep a pristine copy of every file.  Such working copies" NL
+        "### remember this setting and fetch pristine texts from the"        NL
+        "### repository when an operation like diff, revert or commit"       NL
+        "### needs them, keeping only the most recently used ones."          NL
+        "# store-pristine = true"                                            NL
+        "### Set pristine-cache-size to the number of megabytes of pristine" NL
+        "### texts that working copies without stored pristines keep."       NL
+        "# pristine-cache-size = 256"                                        NL
+        "### Set to true to let 'svn status' read the working copy database" NL
+        "### through a separate read-only connection that sees one"          NL
+        "### consistent snapshot for the whole operation.  While it runs,"   NL
+        "### other clients cannot modify that working copy; they wait up"    NL
+        "### to busy-timeout and then fail."                                 NL
+        "# read-snapshot = false"                                            NL
         ;
 
       err = svn_io_file_open(&f, path,
@@ -1640,22 +1640,42 @@ svn_dirent_get_absolute(const char **pabsolute,
   return SVN_NO_ERROR;
 }
 
+/* Most paths passed to the *_canonicalize() functions are canonical
+   already.  Validating them is much cheaper than rebuilding them, so the
+   functions below try that first and merely copy PATH to POOL on
+   success. */
+
 const char *
 svn_uri_canonicalize(const char *uri, apr_pool_t *pool)
 {
+  if (svn_uri_is_canonical(uri, pool))
+    return apr_pstrdup(pool, uri);
+
   return canonicalize(type_uri, uri, pool);
 }
 
 const char *
 svn_relpath_canonicalize(const char *relpath, apr_pool_t *pool)
 {
+  if (relpath_is_canonical(relpath))
+    return apr_pstrdup(pool, relpath);
+
   return canonicalize(type_relpath, relpath, pool);
 }
 
 const char *
 svn_dirent_canonicalize(const char *dirent, apr_pool_t *pool)
 {
-  const char *dst = canonicalize(type_dirent, dirent, pool);
+  const char *dst;
+
+#ifdef SVN_USE_DOS_PATHS
+  /* svn_dirent_is_canonical() calls us for UNC paths. */
+  if (dirent[0] != '/' || dirent[1] != '/')
+#endif
+    if (svn_dirent_is_canonical(dirent, pool))
+      return apr_pstrdup(pool, dirent);
+
+  dst = canonicalize(type_dirent, dirent, pool);
 
 #ifdef SVN_USE_DOS_PATHS
   /* Handle a specific case on Windows where path == "X:/". Here we have to
@@ -1718,9 +1738,7 @@ svn_dirent_is_canonical(const char *dirent, apr_pool_t *scratch_pool)
 static svn_boolean_t
 relpath_is_canonical(const char *relpath)
 {
-  const char *dot_pos, *ptr = relpath;
-  apr_size_t i, len;
-  unsigned pattern = 0;
+  const char *slash, *end, *ptr = relpath;
 
   /* RELPATH is canonical if it has:
    *  - no '.' segments
@@ -1735,30 +1753,19 @@ relpath_is_canonical(const char *relpath)
   if (ptr[0] == '.' && (ptr[1] == '/' || ptr[1] == '\0'))
     return FALSE;
 
-  /* valid special cases */
-  len = strlen(ptr);
-  if (len < 2)
-    return TRUE;
-
-  /* invalid endings */
-  if (ptr[len-1] == '/' || (ptr[len-1] == '.' && ptr[len-2] == '/'))
-    return FALSE;
-
-  /* '.' are rare. So, search for them globally. There will often be no
-   * more than one hit.  Also note that we already checked for invalid
-   * starts and endings, i.e. we only need to check for "/./"
+  /* All remaining violations follow a '/': an empty segment (which
+   * includes a closing '/') or a '.' segment.  Let memchr(), which is
+   * vectorized on most platforms, skip the segment names in between.
    */
-  for (dot_pos = memchr(ptr, '.', len);
-       dot_pos;
-       dot_pos = strchr(dot_pos+1, '.'))
-    if (dot_pos > ptr && dot_pos[-1] == '/' && dot_pos[1] == '/')
-      return FALSE;
-
-  /* Now validate the rest of the path. */
-  for (i = 0; i < len - 1; ++i)
+  end = ptr + strlen(ptr);
+  for (slash = memchr(ptr, '/', end - ptr);
+       slash;
+       slash = memchr(slash + 1, '/', end - slash - 1))
     {
-      pattern = ((pattern & 0xff) << 8) + (unsigned char)ptr[i];
-      if (pattern == 0x101 * (unsigned char)('/'))
+      if (slash[1] == '/' || slash[1] == '\0')
+        return FALSE;
+
+      if (slash[1] == '.' && (slash[2] == '/' || slash[2] == '\0'))
         return FALSE;
     }
 
@@ -2510,6 +2517,9 @@ svn_fspath__canonicalize(const char *fspath,
   if ((fspath[0] == '/') && (fspath[1] == '\0'))
     return "/";
 
+  if (svn_fspath__is_canonical(fspath))
+    return apr_pstrdup(pool, fspath);
+
   return apr_pstrcat(pool, "/", svn_relpath_canonicalize(fspath, pool),
                      SVN_VA_NULL);
 }
@@ -30,10 +30,119 @@
 #include "private/svn_eol_private.h"
 #include "private/svn_dep_compat.h"
 
-char *
-svn_eol__find_eol_start(char *buf, apr_size_t len)
+#include "simd.h"
+
+/* SSE2 is part of the x86-64 base ISA and NEON is mandatory on AArch64,
+ * so they can be used without runtime detection. */
+#if defined(__GNUC__) && defined(__SSE2__)
+#  define SVN_FIND_EOL_SSE2 1
+#  include <emmintrin.h>
+#elif defined(__GNUC__) && defined(__ARM_NEON) && defined(__aarch64__) \
+   && defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+#  define SVN_FIND_EOL_NEON 1
+#  include <arm_neon.h>
+#endif
+
+/* AVX2 support has to be checked at runtime. */
+#if SVN_SIMD__X86 && defined(__GNUC__)
+#  define SVN_FIND_EOL_AVX2 1
+#  include <immintrin.h>
+#endif
+
+/* Mask for '$' in the word-at-a-time scan. */
+#if APR_SIZEOF_VOIDP == 8
+#  define DOLLAR_MASK 0x2424242424242424
+#else
+#  define DOLLAR_MASK 0x24242424
+#endif
+
+/* Inputs shorter than this are not worth the AVX2 setup. */
+#define AVX2_THRESHOLD 64
+
+#if SVN_FIND_EOL_AVX2
+
+/* Return the number of whole 32-byte blocks in BUF of length LEN, in bytes,
+ * that don't contain CR, LF or (if KEYWORDS is set) '$'. */
+SVN_SIMD__TARGET("avx2")
+static apr_size_t
+skip_blocks_avx2(const char *buf, apr_size_t len, svn_boolean_t keywords)
 {
-#if SVN_UNALIGNED_ACCESS_IS_OK
+  const __m256i cr = _mm256_set1_epi8('\r');
+  const __m256i lf = _mm256_set1_epi8('\n');
+  const __m256i dollar = _mm256_set1_epi8('$');
+  apr_size_t pos;
+
+  for (pos = 0; pos + 32 <= len; pos += 32)
+    {
+      __m256i chunk = _mm256_loadu_si256((const __m256i *)(buf + pos));
+      __m256i found = _mm256_or_si256(_mm256_cmpeq_epi8(chunk, cr),
+                                      _mm256_cmpeq_epi8(chunk, lf));
+      if (keywords)
+        found = _mm256_or_si256(found, _mm256_cmpeq_epi8(chunk, dollar));
+
+      if (_mm256_movemask_epi8(found))
+        break;
+    }
+
+  return pos;
+}
+
+#endif /* SVN_FIND_EOL_AVX2 */
+
+/* Implement svn_eol__find_eol_start and, if KEYWORDS is set,
+ * svn_eol__find_eol_or_keyword_start. */
+static APR_INLINE char *
+find_interesting(char *buf, apr_size_t len, svn_boolean_t keywords)
+{
+#if SVN_FIND_EOL_SSE2
+
+  /* Scan 16 bytes at a time.  The mask has one bit per byte with
+   * bit 0 corresponding to the first byte. */
+  const __m128i cr = _mm_set1_epi8('\r');
+  const __m128i lf = _mm_set1_epi8('\n');
+  const __m128i dollar = _mm_set1_epi8('$');
+
+  for (; len >= 16; buf += 16, len -= 16)
+    {
+      __m128i chunk = _mm_loadu_si128((const __m128i *)buf);
+      __m128i found = _mm_or_si128(_mm_cmpeq_epi8(chunk, cr),
+                                   _mm_cmpeq_epi8(chunk, lf));
+      unsigned mask;
+
+      if (keywords)
+        found = _mm_or_si128(found, _mm_cmpeq_epi8(chunk, dollar));
+
+      mask = _mm_movemask_epi8(found);
+      if (mask)
+        return buf + __builtin_ctz(mask);
+    }
+
+#elif SVN_FIND_EOL_NEON
+
+  /* Scan 16 bytes at a time.  Matching bytes become 0xff in FOUND. */
+  const uint8x16_t cr = vdupq_n_u8('\r');
+  const uint8x16_t lf = vdupq_n_u8('\n');
+  const uint8x16_t dollar = vdupq_n_u8('$');
+
+  for (; len >= 16; buf += 16, len -= 16)
+    {
+      uint8x16_t chunk = vld1q_u8((const uint8_t *)buf);
+      uint8x16_t found = vorrq_u8(vceqq_u8(chunk, cr), vceqq_u8(chunk, lf));
+      uint64_t lo, hi;
+
+      if (keywords)
+        found = vorrq_u8(found, vceqq_u8(chunk, dollar));
+
+      lo = vgetq_lane_u64(vreinterpretq_u64_u8(found), 0);
+      hi = vgetq_lane_u64(vreinterpretq_u64_u8(found), 1);
+
+      if (lo)
+        return buf + __builtin_ctzll(lo) / 8;
+      if (hi)
+        return buf + 8 + __builtin_ctzll(hi) / 8;
+    }
+
+#elif SVN_UNALIGNED_ACCESS_IS_OK
 
   /* Scan the input one machine word at a time. */
   for (; len > sizeof(apr_uintptr_t)
@@ -52,6 +161,14 @@ svn_eol__find_eol_start(char *buf, apr_size_t len)
       r_test |= (r_test & SVN__LOWER_7BITS_SET) + SVN__LOWER_7BITS_SET;
       n_test |= (n_test & SVN__LOWER_7BITS_SET) + SVN__LOWER_7BITS_SET;
 
+      /* Same for '$'. */
+      if (keywords)
+        {
+          apr_uintptr_t d_test = chunk ^ DOLLAR_MASK;
+          d_test |= (d_test & SVN__LOWER_7BITS_SET) + SVN__LOWER_7BITS_SET;
+          r_test &= d_test;
+        }
+
       /* Check whether at least one of the words contains a byte <0x80
        * (if one is detected, there was a \r or \n in CHUNK). */
       if ((r_test & n_test & SVN__BIT_7_SET) != SVN__BIT_7_SET)
@@ -63,13 +180,45 @@ svn_eol__find_eol_start(char *buf, apr_size_t len)
   /* The remaining odd bytes will be examined the naive way: */
   for (; len > 0; ++buf, --len)
     {
-      if (*buf == '\n' || *buf == '\r')
+      if (*buf == '\n' || *buf == '\r' || (keywords && *buf == '$'))
         return buf;
     }
 
   return NULL;
 }
 
+/* Return the number of leading bytes in BUF of length LEN that
+ * find_interesting() may skip without looking at them.
+ */
+static APR_INLINE apr_size_t
+skip_boring(const char *buf, apr_size_t len, svn_boolean_t keywords)
+{
+#if SVN_FIND_EOL_AVX2
+
+  /* Skip the bulk of the data in 32-byte blocks.  find_interesting()
+   * will then find the exact position within the block that stopped us. */
+  if (len >= AVX2_THRESHOLD && (svn_simd__features() & SVN_SIMD__AVX2))
+    return skip_blocks_avx2(buf, len, keywords);
+
+#endif
+
+  return 0;
+}
+
+char *
+svn_eol__find_eol_start(char *buf, apr_size_t len)
+{
+  apr_size_t skipped = skip_boring(buf, len, FALSE);
+  return find_interesting(buf + skipped, len - skipped, FALSE);
+}
+
+char *
+svn_eol__find_eol_or_keyword_start(char *buf, apr_size_t len)
+{
+  apr_size_t skipped = skip_boring(buf, len, TRUE);
+  return find_interesting(buf + skipped, len - skipped, TRUE);
+}
+
 const char *
 svn_eol__detect_eol(char *buf, apr_size_t len, char **eolp)
 {
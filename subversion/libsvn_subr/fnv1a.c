@@ -28,6 +28,19 @@
 
 #include "private/svn_subr_private.h"
 #include "fnv1a.h"
+#include "simd.h"
+
+/* Multi-buffer kernels that this compiler can produce.  SSE4.1 and AVX2
+ * support has to be checked at runtime, NEON is mandatory on AArch64.
+ */
+#if SVN_SIMD__X86
+#  define SVN_FNV1A_X86 1
+#  include <immintrin.h>
+#elif defined(__GNUC__) && defined(__ARM_NEON) && defined(__aarch64__) \
+   && defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+#  define SVN_FNV1A_NEON 1
+#  include <arm_neon.h>
+#endif
 
 /**
  * See http://www.isthe.com/chongo/tech/comp/fnv/ for more info on FNV-1
@@ -114,6 +127,450 @@ finalize_fnv1a_32x4(apr_uint32_t hashes[SCALING],
                   sizeof(apr_uint32_t) * SCALING + len);
 }
 
+/*** Multi-buffer implementation of the modified FNV-1a ***/
+
+/* The 4 interleaved FNV-1a sums of a single buffer form a serial chain of
+ * multiplications.  A single buffer is therefore limited by the latency of
+ * the multiplication and SIMD does not help.  With many independent
+ * buffers, however, we can keep several chains in flight per instruction.
+ *
+ * The multi-buffer code assigns buffers to "slots".  Each slot holds the
+ * 4 partial hashes of one buffer.  A kernel advances all slots in lock-step
+ * and whenever a buffer has been exhausted, its slot gets refilled with the
+ * next pending buffer.
+ */
+
+/* Maximum number of slots that any kernel processes in parallel. */
+#define MAX_SLOTS 16
+
+/* Advance the hashes of all slots by STEPS * SCALING bytes each.  HASHES
+ * and DATA are the hash states and current data pointers of the slots.
+ * Update both accordingly.
+ */
+typedef void (*multi_kernel_t)(apr_uint32_t hashes[][SCALING],
+                               const unsigned char *data[],
+                               apr_size_t steps);
+
+/* Read a 32 bit word from the potentially unaligned address DATA. */
+static APR_INLINE apr_uint32_t
+load_u32(const unsigned char *data)
+{
+  apr_uint32_t result;
+  memcpy(&result, data, sizeof(result));
+  return result;
+}
+
+#if SVN_FNV1A_X86
+
+/* Number of bytes per slot that the x86 kernels process at once in their
+ * main loop. */
+#define X86_BLOCK_SIZE (4 * SCALING)
+
+/* Return the next SCALING bytes at DATA zero-extended to 32 bit lanes. */
+SVN_SIMD__TARGET("sse4.1")
+static APR_INLINE __m128i
+sse41_load(const unsigned char *data)
+{
+  return _mm_cvtepu8_epi32(_mm_cvtsi32_si128((int)load_u32(data)));
+}
+
+/* Multi-buffer kernel for SSE4.1.  Slot K is lane vector K. */
+#define SSE41_SLOTS 8
+
+/* Update hash vector H with the next SCALING bytes at data pointer P. */
+#define SSE41_STEP(h, p) \
+  h = _mm_mullo_epi32(_mm_xor_si128(h, sse41_load(p + i)), prime)
+
+/* Update hash vector H with the next X86_BLOCK_SIZE bytes at data
+ * pointer P.  The byte shuffles M0 to M3 extract the SCALING bytes for
+ * the respective step. */
+#define SSE41_BLOCK(h, p)                                                 \
+  do {                                                                    \
+    __m128i block = _mm_loadu_si128((const __m128i *)(p + i));            \
+    h = _mm_mullo_epi32(_mm_xor_si128(h, _mm_shuffle_epi8(block, m0)),    \
+                        prime);                                           \
+    h = _mm_mullo_epi32(_mm_xor_si128(h, _mm_shuffle_epi8(block, m1)),    \
+                        prime);                                           \
+    h = _mm_mullo_epi32(_mm_xor_si128(h, _mm_shuffle_epi8(block, m2)),    \
+                        prime);                                           \
+    h = _mm_mullo_epi32(_mm_xor_si128(h, _mm_shuffle_epi8(block, m3)),    \
+                        prime);                                           \
+  } while (0)
+
+/* Implements multi_kernel_t for SSE4.1 with SSE41_SLOTS slots. */
+SVN_SIMD__TARGET("sse4.1")
+static void
+multi_kernel_sse41(apr_uint32_t hashes[][SCALING],
+                   const unsigned char *data[],
+                   apr_size_t steps)
+{
+  const __m128i prime = _mm_set1_epi32(FNV1_PRIME_32);
+  const __m128i m0 = _mm_setr_epi8(0, -1, -1, -1, 1, -1, -1, -1,
+                                   2, -1, -1, -1, 3, -1, -1, -1);
+  const __m128i m1 = _mm_setr_epi8(4, -1, -1, -1, 5, -1, -1, -1,
+                                   6, -1, -1, -1, 7, -1, -1, -1);
+  const __m128i m2 = _mm_setr_epi8(8, -1, -1, -1, 9, -1, -1, -1,
+                                   10, -1, -1, -1, 11, -1, -1, -1);
+  const __m128i m3 = _mm_setr_epi8(12, -1, -1, -1, 13, -1, -1, -1,
+                                   14, -1, -1, -1, 15, -1, -1, -1);
+  const unsigned char *p0 = data[0], *p1 = data[1];
+  const unsigned char *p2 = data[2], *p3 = data[3];
+  const unsigned char *p4 = data[4], *p5 = data[5];
+  const unsigned char *p6 = data[6], *p7 = data[7];
+  __m128i h0 = _mm_loadu_si128((const __m128i *)hashes[0]);
+  __m128i h1 = _mm_loadu_si128((const __m128i *)hashes[1]);
+  __m128i h2 = _mm_loadu_si128((const __m128i *)hashes[2]);
+  __m128i h3 = _mm_loadu_si128((const __m128i *)hashes[3]);
+  __m128i h4 = _mm_loadu_si128((const __m128i *)hashes[4]);
+  __m128i h5 = _mm_loadu_si128((const __m128i *)hashes[5]);
+  __m128i h6 = _mm_loadu_si128((const __m128i *)hashes[6]);
+  __m128i h7 = _mm_loadu_si128((const __m128i *)hashes[7]);
+  apr_size_t i;
+  apr_size_t len = steps * SCALING;
+  int k;
+
+  for (i = 0; i + X86_BLOCK_SIZE <= len; i += X86_BLOCK_SIZE)
+    {
+      SSE41_BLOCK(h0, p0);
+      SSE41_BLOCK(h1, p1);
+      SSE41_BLOCK(h2, p2);
+      SSE41_BLOCK(h3, p3);
+      SSE41_BLOCK(h4, p4);
+      SSE41_BLOCK(h5, p5);
+      SSE41_BLOCK(h6, p6);
+      SSE41_BLOCK(h7, p7);
+    }
+
+  for (; i < len; i += SCALING)
+    {
+      SSE41_STEP(h0, p0);
+      SSE41_STEP(h1, p1);
+      SSE41_STEP(h2, p2);
+      SSE41_STEP(h3, p3);
+      SSE41_STEP(h4, p4);
+      SSE41_STEP(h5, p5);
+      SSE41_STEP(h6, p6);
+      SSE41_STEP(h7, p7);
+    }
+
+  _mm_storeu_si128((__m128i *)hashes[0], h0);
+  _mm_storeu_si128((__m128i *)hashes[1], h1);
+  _mm_storeu_si128((__m128i *)hashes[2], h2);
+  _mm_storeu_si128((__m128i *)hashes[3], h3);
+  _mm_storeu_si128((__m128i *)hashes[4], h4);
+  _mm_storeu_si128((__m128i *)hashes[5], h5);
+  _mm_storeu_si128((__m128i *)hashes[6], h6);
+  _mm_storeu_si128((__m128i *)hashes[7], h7);
+
+  for (k = 0; k < SSE41_SLOTS; ++k)
+    data[k] += len;
+}
+
+#undef SSE41_STEP
+#undef SSE41_BLOCK
+
+/* Return the next SCALING bytes at DATA1 and at DATA2 zero-extended to
+ * 32 bit lanes, the former in the lower and the latter in the upper half.
+ */
+SVN_SIMD__TARGET("avx2")
+static APR_INLINE __m256i
+avx2_load(const unsigned char *data1, const unsigned char *data2)
+{
+  return _mm256_cvtepu8_epi32(_mm_set_epi32(0, 0, (int)load_u32(data2),
+                                            (int)load_u32(data1)));
+}
+
+/* Multi-buffer kernel for AVX2.  Slots 2K and 2K+1 are lane vector K. */
+#define AVX2_SLOTS 16
+
+/* Update hash vector H with the next SCALING bytes at data pointers P and
+ * Q, respectively. */
+#define AVX2_STEP(h, p, q) \
+  h = _mm256_mullo_epi32(_mm256_xor_si256(h, avx2_load(p + i, q + i)), \
+                         prime)
+
+/* Update hash vector H with the next X86_BLOCK_SIZE bytes at data
+ * pointers P and Q, respectively.  The byte shuffles M0 to M3 extract the
+ * SCALING bytes for the respective step. */
+#define AVX2_BLOCK(h, p, q)                                               \
+  do {                                                                    \
+    __m256i block = _mm256_inserti128_si256(                              \
+        _mm256_castsi128_si256(_mm_loadu_si128((const __m128i *)(p + i))),\
+        _mm_loadu_si128((const __m128i *)(q + i)), 1);                    \
+    h = _mm256_mullo_epi32(                                               \
+          _mm256_xor_si256(h, _mm256_shuffle_epi8(block, m0)), prime);    \
+    h = _mm256_mullo_epi32(                                               \
+          _mm256_xor_si256(h, _mm256_shuffle_epi8(block, m1)), prime);    \
+    h = _mm256_mullo_epi32(                                               \
+          _mm256_xor_si256(h, _mm256_shuffle_epi8(block, m2)), prime);    \
+    h = _mm256_mullo_epi32(                                               \
+          _mm256_xor_si256(h, _mm256_shuffle_epi8(block, m3)), prime);    \
+  } while (0)
+
+/* Load / store the hashes of slots K and K+1 into / from vector H. */
+#define AVX2_LOAD(k) _mm256_loadu_si256((const __m256i *)hashes[k])
+#define AVX2_STORE(k, h) _mm256_storeu_si256((__m256i *)hashes[k], h)
+
+/* Implements multi_kernel_t for AVX2 with AVX2_SLOTS slots. */
+SVN_SIMD__TARGET("avx2")
+static void
+multi_kernel_avx2(apr_uint32_t hashes[][SCALING],
+                  const unsigned char *data[],
+                  apr_size_t steps)
+{
+  const __m256i prime = _mm256_set1_epi32(FNV1_PRIME_32);
+  const __m256i m0 = _mm256_setr_epi8(0, -1, -1, -1, 1, -1, -1, -1,
+                                      2, -1, -1, -1, 3, -1, -1, -1,
+                                      0, -1, -1, -1, 1, -1, -1, -1,
+                                      2, -1, -1, -1, 3, -1, -1, -1);
+  const __m256i m1 = _mm256_setr_epi8(4, -1, -1, -1, 5, -1, -1, -1,
+                                      6, -1, -1, -1, 7, -1, -1, -1,
+                                      4, -1, -1, -1, 5, -1, -1, -1,
+                                      6, -1, -1, -1, 7, -1, -1, -1);
+  const __m256i m2 = _mm256_setr_epi8(8, -1, -1, -1, 9, -1, -1, -1,
+                                      10, -1, -1, -1, 11, -1, -1, -1,
+                                      8, -1, -1, -1, 9, -1, -1, -1,
+                                      10, -1, -1, -1, 11, -1, -1, -1);
+  const __m256i m3 = _mm256_setr_epi8(12, -1, -1, -1, 13, -1, -1, -1,
+                                      14, -1, -1, -1, 15, -1, -1, -1,
+                                      12, -1, -1, -1, 13, -1, -1, -1,
+                                      14, -1, -1, -1, 15, -1, -1, -1);
+  const unsigned char *p0 = data[0], *p1 = data[1];
+  const unsigned char *p2 = data[2], *p3 = data[3];
+  const unsigned char *p4 = data[4], *p5 = data[5];
+  const unsigned char *p6 = data[6], *p7 = data[7];
+  const unsigned char *p8 = data[8], *p9 = data[9];
+  const unsigned char *p10 = data[10], *p11 = data[11];
+  const unsigned char *p12 = data[12], *p13 = data[13];
+  const unsigned char *p14 = data[14], *p15 = data[15];
+  __m256i h0 = AVX2_LOAD(0);
+  __m256i h1 = AVX2_LOAD(2);
+  __m256i h2 = AVX2_LOAD(4);
+  __m256i h3 = AVX2_LOAD(6);
+  __m256i h4 = AVX2_LOAD(8);
+  __m256i h5 = AVX2_LOAD(10);
+  __m256i h6 = AVX2_LOAD(12);
+  __m256i h7 = AVX2_LOAD(14);
+  apr_size_t i;
+  apr_size_t len = steps * SCALING;
+  int k;
+
+  for (i = 0; i + X86_BLOCK_SIZE <= len; i += X86_BLOCK_SIZE)
+    {
+      AVX2_BLOCK(h0, p0, p1);
+      AVX2_BLOCK(h1, p2, p3);
+      AVX2_BLOCK(h2, p4, p5);
+      AVX2_BLOCK(h3, p6, p7);
+      AVX2_BLOCK(h4, p8, p9);
+      AVX2_BLOCK(h5, p10, p11);
+      AVX2_BLOCK(h6, p12, p13);
+      AVX2_BLOCK(h7, p14, p15);
+    }
+
+  for (; i < len; i += SCALING)
+    {
+      AVX2_STEP(h0, p0, p1);
+      AVX2_STEP(h1, p2, p3);
+      AVX2_STEP(h2, p4, p5);
+      AVX2_STEP(h3, p6, p7);
+      AVX2_STEP(h4, p8, p9);
+      AVX2_STEP(h5, p10, p11);
+      AVX2_STEP(h6, p12, p13);
+      AVX2_STEP(h7, p14, p15);
+    }
+
+  AVX2_STORE(0, h0);
+  AVX2_STORE(2, h1);
+  AVX2_STORE(4, h2);
+  AVX2_STORE(6, h3);
+  AVX2_STORE(8, h4);
+  AVX2_STORE(10, h5);
+  AVX2_STORE(12, h6);
+  AVX2_STORE(14, h7);
+
+  for (k = 0; k < AVX2_SLOTS; ++k)
+    data[k] += len;
+}
+
+#undef AVX2_STEP
+#undef AVX2_BLOCK
+#undef AVX2_LOAD
+#undef AVX2_STORE
+
+#endif /* SVN_FNV1A_X86 */
+
+#if SVN_FNV1A_NEON
+
+/* Return the next SCALING bytes at DATA zero-extended to 32 bit lanes. */
+static APR_INLINE uint32x4_t
+neon_load(const unsigned char *data)
+{
+  uint8x8_t bytes = vreinterpret_u8_u32(vdup_n_u32(load_u32(data)));
+  return vmovl_u16(vget_low_u16(vmovl_u8(bytes)));
+}
+
+/* Multi-buffer kernel for NEON.  Slot K is lane vector K. */
+#define NEON_SLOTS 8
+
+/* Update hash vector H with the next SCALING bytes at data pointer P. */
+#define NEON_STEP(h, p) \
+  h = vmulq_n_u32(veorq_u32(h, neon_load(p + i)), FNV1_PRIME_32)
+
+/* Implements multi_kernel_t for NEON with NEON_SLOTS slots. */
+static void
+multi_kernel_neon(apr_uint32_t hashes[][SCALING],
+                  const unsigned char *data[],
+                  apr_size_t steps)
+{
+  const unsigned char *p0 = data[0], *p1 = data[1];
+  const unsigned char *p2 = data[2], *p3 = data[3];
+  const unsigned char *p4 = data[4], *p5 = data[5];
+  const unsigned char *p6 = data[6], *p7 = data[7];
+  uint32x4_t h0 = vld1q_u32(hashes[0]);
+  uint32x4_t h1 = vld1q_u32(hashes[1]);
+  uint32x4_t h2 = vld1q_u32(hashes[2]);
+  uint32x4_t h3 = vld1q_u32(hashes[3]);
+  uint32x4_t h4 = vld1q_u32(hashes[4]);
+  uint32x4_t h5 = vld1q_u32(hashes[5]);
+  uint32x4_t h6 = vld1q_u32(hashes[6]);
+  uint32x4_t h7 = vld1q_u32(hashes[7]);
+  apr_size_t i;
+  apr_size_t len = steps * SCALING;
+  int k;
+
+  for (i = 0; i < len; i += SCALING)
+    {
+      NEON_STEP(h0, p0);
+      NEON_STEP(h1, p1);
+      NEON_STEP(h2, p2);
+      NEON_STEP(h3, p3);
+      NEON_STEP(h4, p4);
+      NEON_STEP(h5, p5);
+      NEON_STEP(h6, p6);
+      NEON_STEP(h7, p7);
+    }
+
+  vst1q_u32(hashes[0], h0);
+  vst1q_u32(hashes[1], h1);
+  vst1q_u32(hashes[2], h2);
+  vst1q_u32(hashes[3], h3);
+  vst1q_u32(hashes[4], h4);
+  vst1q_u32(hashes[5], h5);
+  vst1q_u32(hashes[6], h6);
+  vst1q_u32(hashes[7], h7);
+
+  for (k = 0; k < NEON_SLOTS; ++k)
+    data[k] += len;
+}
+
+#undef NEON_STEP
+
+#endif /* SVN_FNV1A_NEON */
+
+/* Select the fastest multi-buffer kernel for this CPU.  Return it in
+ * *KERNEL together with its number of slots in *SLOTS.  Set *KERNEL to
+ * NULL if there is none.
+ */
+static void
+select_multi_kernel(multi_kernel_t *kernel, int *slots)
+{
+#if SVN_FNV1A_X86
+  apr_uint32_t features = svn_simd__features();
+  if (features & SVN_SIMD__AVX2)
+    {
+      *kernel = multi_kernel_avx2;
+      *slots = AVX2_SLOTS;
+      return;
+    }
+
+  if (features & SVN_SIMD__SSE4_1)
+    {
+      *kernel = multi_kernel_sse41;
+      *slots = SSE41_SLOTS;
+      return;
+    }
+#elif SVN_FNV1A_NEON
+  *kernel = multi_kernel_neon;
+  *slots = NEON_SLOTS;
+  return;
+#endif
+
+  *kernel = NULL;
+  *slots = 0;
+}
+
+/* Slot states for fnv1a_32x4_multi(). */
+typedef struct multi_state_t
+{
+  /* Partial hashes per slot. */
+  apr_uint32_t hashes[MAX_SLOTS][SCALING];
+
+  /* Next data to process per slot. */
+  const unsigned char *data[MAX_SLOTS];
+
+  /* Number of SCALING-sized steps left to process per slot. */
+  apr_size_t steps[MAX_SLOTS];
+
+  /* Index of the buffer being processed in each slot. */
+  apr_size_t index[MAX_SLOTS];
+} multi_state_t;
+
+/* Minimum number of steps to run a kernel for. */
+#define MIN_KERNEL_STEPS 16
+
+/* Start processing buffer INDEX of INPUTS with LENS in slot K of STATE.
+ */
+static void
+assign_slot(multi_state_t *state,
+            int k,
+            const void *const *inputs,
+            const apr_size_t *lens,
+            apr_size_t index)
+{
+  state->hashes[k][0] = FNV1_BASE_32;
+  state->hashes[k][1] = FNV1_BASE_32;
+  state->hashes[k][2] = FNV1_BASE_32;
+  state->hashes[k][3] = FNV1_BASE_32;
+  state->data[k] = inputs[index];
+  state->steps[k] = lens[index] / SCALING;
+  state->index[k] = index;
+}
+
+/* Process the remainder of the buffer in slot K of STATE with the scalar
+ * code and return its checksum.  LENS are the buffer lengths.
+ */
+static apr_uint32_t
+finish_slot(multi_state_t *state,
+            int k,
+            const apr_size_t *lens)
+{
+  const unsigned char *data = state->data[k];
+  data += fnv1a_32x4(state->hashes[k], data, state->steps[k] * SCALING);
+
+  return finalize_fnv1a_32x4(state->hashes[k], data,
+                             lens[state->index[k]] % SCALING);
+}
+
+const char *
+svn__fnv1a_32x4_implementation(void)
+{
+  multi_kernel_t kernel;
+  int slots;
+  select_multi_kernel(&kernel, &slots);
+
+#if SVN_FNV1A_X86
+  if (kernel == multi_kernel_avx2)
+    return "AVX2";
+  if (kernel == multi_kernel_sse41)
+    return "SSE4.1";
+#elif SVN_FNV1A_NEON
+  if (kernel == multi_kernel_neon)
+    return "NEON";
+#endif
+
+  return "generic";
+}
+
 apr_uint32_t
 svn__fnv1a_32(const void *input, apr_size_t len)
 {
@@ -261,3 +718,74 @@ svn_fnv1a_32x4__finalize(svn_fnv1a_32x4__context_t *context)
                              context->buffer,
                              context->buffered);
 }
+
+void
+svn__fnv1a_32x4_multi(apr_uint32_t *checksums,
+                      const void *const *inputs,
+                      const apr_size_t *lens,
+                      apr_size_t count)
+{
+  multi_state_t state;
+  multi_kernel_t kernel;
+  apr_size_t next = 0;
+  int slots;
+  int k;
+
+  /* Without enough buffers to fill all slots, we would hash garbage.
+   * Simply use the scalar code in that case. */
+  select_multi_kernel(&kernel, &slots);
+  if (kernel == NULL || count < (apr_size_t)slots)
+    {
+      for (; next < count; ++next)
+        checksums[next] = svn__fnv1a_32x4(inputs[next], lens[next]);
+
+      return;
+    }
+
+  /* Put the first buffers into the slots. */
+  for (k = 0; k < slots; ++k)
+    assign_slot(&state, k, inputs, lens, next++);
+
+  /* Run the kernel as long as all slots are in use. */
+  while (TRUE)
+    {
+      apr_size_t steps;
+      svn_boolean_t all_used = TRUE;
+
+      /* Complete buffers that have little data left with the scalar code
+       * and refill their slots.  Running the kernel for just a few steps
+       * would not be worth its overhead. */
+      for (k = 0; k < slots; ++k)
+        while (   state.steps[k] < MIN_KERNEL_STEPS
+               && state.index[k] < count)
+          {
+            checksums[state.index[k]] = finish_slot(&state, k, lens);
+            if (next < count)
+              {
+                assign_slot(&state, k, inputs, lens, next++);
+              }
+            else
+              {
+                state.index[k] = count;
+                all_used = FALSE;
+              }
+          }
+
+      if (!all_used)
+        break;
+
+      steps = state.steps[0];
+      for (k = 1; k < slots; ++k)
+        if (state.steps[k] < steps)
+          steps = state.steps[k];
+
+      kernel(state.hashes, state.data, steps);
+      for (k = 0; k < slots; ++k)
+        state.steps[k] -= steps;
+    }
+
+  /* Finish the remaining buffers with the scalar code. */
+  for (k = 0; k < slots; ++k)
+    if (state.index[k] < count)
+      checksums[state.index[k]] = finish_slot(&state, k, lens);
+}
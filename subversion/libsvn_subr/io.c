@@ -27,6 +27,13 @@
 
 #ifndef WIN32
 #include <unistd.h>
+#include <errno.h>
+#endif
+
+#if defined(HAVE_DIRFD) && defined(HAVE_FSTATAT)
+#include <dirent.h>
+#include <sys/stat.h>
+#define SVN_IO__READDIR_AT
 #endif
 
 #ifndef APR_STATUS_IS_EPERM
@@ -69,6 +76,16 @@
 #include "private/svn_utf_private.h"
 #include "private/svn_dep_compat.h"
 
+#if defined(HAVE_SYS_CLONEFILE_H) && defined(HAVE_CLONEFILE)
+#include <sys/clonefile.h>
+#define SVN_IO__CLONEFILE
+#endif
+
+#ifdef HAVE_LINUX_FS_H
+#include <sys/ioctl.h>
+#include <linux/fs.h>
+#endif
+
 #define SVN_SLEEP_ENV_VAR "SVN_I_LOVE_CORRUPTED_WORKING_COPIES_SO_DISABLE_SLEEP_FOR_TIMESTAMPS"
 
 /*
@@ -874,6 +891,175 @@ copy_contents(apr_file_t *from_file,
   /* NOTREACHED */
 }
 
+#if (defined(HAVE_LINUX_FS_H) && defined(FICLONE)) \
+    || defined(HAVE_COPY_FILE_RANGE)
+/* Let the kernel copy the whole contents of FROM_FILE to the empty
+ * TO_FILE, if it can.  Clone the data blocks if the filesystem supports
+ * that (e.g. btrfs, XFS with reflinks); otherwise, try to copy without
+ * moving the data through user space, which also allows network file
+ * systems to do server-side copies.
+ *
+ * Return APR_ENOTIMPL if neither is available for these files.  Nothing
+ * has been written to TO_FILE in that case.  Neither file may have been
+ * read from or written to through APR before.
+ */
+static apr_status_t
+copy_contents_in_kernel(apr_file_t *from_file,
+                        apr_file_t *to_file)
+{
+  apr_os_file_t from_fd;
+  apr_os_file_t to_fd;
+  apr_status_t status;
+
+  status = apr_os_file_get(&from_fd, from_file);
+  if (status)
+    return status;
+
+  status = apr_os_file_get(&to_fd, to_file);
+  if (status)
+    return status;
+
+#if defined(HAVE_LINUX_FS_H) && defined(FICLONE)
+  if (ioctl(to_fd, FICLONE, from_fd) == 0)
+    return APR_SUCCESS;
+#endif
+
+#ifdef HAVE_COPY_FILE_RANGE
+  {
+    svn_boolean_t first = TRUE;
+
+    while (TRUE)
+      {
+        ssize_t copied = copy_file_range(from_fd, NULL, to_fd, NULL,
+                                         0x40000000, 0);
+        if (copied == 0)
+          return APR_SUCCESS;
+
+        if (copied < 0)
+          {
+            status = apr_get_os_error();
+
+            /* Across filesystems, with old kernels etc.
+               We may still fall back to the generic code. */
+            if (first)
+              return APR_ENOTIMPL;
+
+            return status;
+          }
+
+        first = FALSE;
+      }
+  }
+#else
+  return APR_ENOTIMPL;
+#endif
+}
+#endif
+
+#ifdef SVN_IO__CLONEFILE
+/* Clone SRC into a new temporary file in the directory of DST, if the
+ * filesystem supports that (e.g. APFS).  Like a copy, the clone gets the
+ * permissions that svn_io_open_unique_file3 would have given it and the
+ * current time as its modification time.  Set *DST_TMP to the path of the
+ * clone or to NULL if SRC could not be cloned.  Use POOL for allocations.
+ */
+static svn_error_t *
+clone_to_temp_file(const char **dst_tmp,
+                   const char *src,
+                   const char *dst,
+                   apr_pool_t *pool)
+{
+  apr_file_t *placeholder;
+  apr_finfo_t finfo;
+  const char *tmp_path;
+  const char *src_apr;
+  const char *tmp_apr;
+  apr_status_t status;
+  svn_error_t *err;
+
+  *dst_tmp = NULL;
+
+  /* Reserve a name and find the default permissions.  clonefile() wants
+     to create the target itself. */
+  SVN_ERR(svn_io_open_unique_file3(&placeholder, &tmp_path,
+                                   svn_dirent_dirname(dst, pool),
+                                   svn_io_file_del_none, pool, pool));
+  SVN_ERR(svn_io_file_info_get(&finfo, APR_FINFO_PROT, placeholder, pool));
+  SVN_ERR(svn_io_file_close(placeholder, pool));
+  SVN_ERR(svn_io_remove_file2(tmp_path, FALSE, pool));
+
+  SVN_ERR(cstring_from_utf8(&src_apr, src, pool));
+  SVN_ERR(cstring_from_utf8(&tmp_apr, tmp_path, pool));
+
+  /* Unsupported filesystem, different volumes etc.
+     The caller will simply copy the data. */
+  if (clonefile(src_apr, tmp_apr, 0))
+    return SVN_NO_ERROR;
+
+  status = apr_file_perms_set(tmp_apr, finfo.protection);
+  if (status)
+    err = svn_error_wrap_apr(status, _("Can't set permissions on '%s'"),
+                             svn_dirent_local_style(tmp_path, pool));
+  else
+    err = svn_io_set_file_affected_time(apr_time_now(), tmp_path, pool);
+
+  if (err)
+    return svn_error_compose_create(err,
+                                    svn_io_remove_file2(tmp_path, TRUE, pool));
+
+  *dst_tmp = tmp_path;
+  return SVN_NO_ERROR;
+}
+#endif
+
+svn_error_t *
+svn_io__create_hardlink(svn_boolean_t *linked,
+                        const char *src_abspath,
+                        const char *dst_abspath,
+                        apr_pool_t *scratch_pool)
+{
+#ifndef WIN32
+  const char *src_apr;
+  const char *dst_apr;
+  apr_status_t status;
+  int rv;
+
+  SVN_ERR(cstring_from_utf8(&src_apr, src_abspath, scratch_pool));
+  SVN_ERR(cstring_from_utf8(&dst_apr, dst_abspath, scratch_pool));
+
+  do {
+    rv = link(src_apr, dst_apr);
+  } while (rv == -1 && APR_STATUS_IS_EINTR(apr_get_os_error()));
+
+  *linked = (rv == 0);
+  if (*linked)
+    return SVN_NO_ERROR;
+
+  /* Different filesystems, too many links, no link support etc. */
+  status = apr_get_os_error();
+  switch (APR_TO_OS_ERROR(status))
+    {
+      case EXDEV:
+      case EMLINK:
+      case EPERM:
+#ifdef EOPNOTSUPP
+      case EOPNOTSUPP:
+#endif
+#if defined(ENOTSUP) && (!defined(EOPNOTSUPP) || ENOTSUP != EOPNOTSUPP)
+      case ENOTSUP:
+#endif
+        return SVN_NO_ERROR;
+
+      default:
+        return svn_error_wrap_apr(status, _("Can't create hard link '%s'"),
+                                  svn_dirent_local_style(dst_abspath,
+                                                         scratch_pool));
+    }
+#else
+  *linked = FALSE;
+  return SVN_NO_ERROR;
+#endif
+}
 
 svn_error_t *
 svn_io_copy_file(const char *src,
@@ -904,6 +1090,18 @@ svn_io_copy_file(const char *src,
     return SVN_NO_ERROR;
 #endif
 
+#ifdef SVN_IO__CLONEFILE
+  /* Cloning shares the data blocks, i.e. nothing needs to be copied. */
+  SVN_ERR(clone_to_temp_file(&dst_tmp, src, dst, pool));
+  if (dst_tmp)
+    {
+      if (copy_perms)
+        SVN_ERR(svn_io_copy_perms(src, dst_tmp, pool));
+
+      return svn_error_trace(svn_io_file_rename2(dst_tmp, dst, FALSE, pool));
+    }
+#endif
+
   SVN_ERR(svn_io_file_open(&from_file, src, APR_READ,
                            APR_OS_DEFAULT, pool));
 
@@ -914,7 +1112,12 @@ svn_io_copy_file(const char *src,
                                    svn_dirent_dirname(dst, pool),
                                    svn_io_file_del_none, pool, pool));
 
-  apr_err = copy_contents(from_file, to_file, pool);
+#if (defined(HAVE_LINUX_FS_H) && defined(FICLONE)) \
+    || defined(HAVE_COPY_FILE_RANGE)
+  apr_err = copy_contents_in_kernel(from_file, to_file);
+  if (apr_err == APR_ENOTIMPL)
+#endif
+    apr_err = copy_contents(from_file, to_file, pool);
 
   if (apr_err)
     {
@@ -2814,12 +3017,245 @@ svn_io_dirent2_dup(const svn_io_dirent2_t *item,
                      sizeof(*item));
 }
 
-svn_error_t *
-svn_io_get_dirents3(apr_hash_t **dirents,
-                    const char *path,
-                    svn_boolean_t only_check_type,
-                    apr_pool_t *result_pool,
-                    apr_pool_t *scratch_pool)
+#if defined(SVN_IO__READDIR_AT)
+/* Implement svn_io_get_dirents3 for POSIX systems.
+ *
+ * Instead of letting APR stat every entry by its full path, stat them
+ * relative to the open directory.  The file type usually comes with the
+ * directory entry itself, i.e. we don't stat at all if ONLY_CHECK_TYPE
+ * is set.  Add the entries to DIRENTS.
+ */
+static svn_error_t *
+get_dirents_at(apr_hash_t *dirents,
+               const char *path,
+               svn_boolean_t only_check_type,
+               apr_pool_t *result_pool,
+               apr_pool_t *scratch_pool)
+{
+  const char *path_apr;
+  DIR *dir;
+  int fd;
+  svn_error_t *err = SVN_NO_ERROR;
+
+  SVN_ERR(cstring_from_utf8(&path_apr, path[0] ? path : ".", scratch_pool));
+
+  dir = opendir(path_apr);
+  if (!dir)
+    return svn_error_wrap_apr(apr_get_os_error(),
+                              _("Can't open directory '%s'"),
+                              svn_dirent_local_style(path, scratch_pool));
+
+  fd = dirfd(dir);
+  while (!err)
+    {
+      struct dirent *entry;
+      struct stat info;
+      svn_io_dirent2_t *dirent;
+      const char *name;
+      svn_boolean_t need_stat = !only_check_type;
+
+      errno = 0;
+      entry = readdir(dir);
+      if (!entry)
+        {
+          if (errno)
+            err = svn_error_wrap_apr(apr_get_os_error(),
+                                     _("Can't read directory '%s'"),
+                                     svn_dirent_local_style(path,
+                                                            scratch_pool));
+          break;
+        }
+
+      if ((entry->d_name[0] == '.')
+          && ((entry->d_name[1] == '\0')
+              || ((entry->d_name[1] == '.')
+                  && (entry->d_name[2] == '\0'))))
+        continue;
+
+      dirent = svn_io_dirent2_create(result_pool);
+
+#ifdef DT_UNKNOWN
+      if (entry->d_type == DT_REG)
+        dirent->kind = svn_node_file;
+      else if (entry->d_type == DT_DIR)
+        dirent->kind = svn_node_dir;
+      else if (entry->d_type == DT_LNK)
+        {
+          dirent->kind = svn_node_file;
+          dirent->special = TRUE;
+        }
+      else if (entry->d_type == DT_UNKNOWN)
+        need_stat = TRUE;
+      else
+        dirent->kind = svn_node_unknown;
+#else
+      need_stat = TRUE;
+#endif
+
+      if (need_stat)
+        {
+          if (fstatat(fd, entry->d_name, &info, AT_SYMLINK_NOFOLLOW))
+            {
+              apr_status_t status = apr_get_os_error();
+
+              /* Entries removed since we read the directory don't exist. */
+              if (APR_STATUS_IS_ENOENT(status))
+                continue;
+
+              err = svn_error_wrap_apr(status, _("Can't stat '%s'"),
+                                       svn_dirent_local_style(
+                                         svn_dirent_join(path, entry->d_name,
+                                                         scratch_pool),
+                                         scratch_pool));
+              break;
+            }
+
+          dirent->special = FALSE;
+          if (S_ISREG(info.st_mode))
+            dirent->kind = svn_node_file;
+          else if (S_ISDIR(info.st_mode))
+            dirent->kind = svn_node_dir;
+          else if (S_ISLNK(info.st_mode))
+            {
+              dirent->kind = svn_node_file;
+              dirent->special = TRUE;
+            }
+          else
+            dirent->kind = svn_node_unknown;
+
+          if (!only_check_type)
+            {
+              dirent->filesize = info.st_size;
+#ifdef HAVE_STRUCT_STAT_ST_MTIM
+              dirent->mtime = apr_time_from_sec(info.st_mtim.tv_sec)
+                            + info.st_mtim.tv_nsec / 1000;
+#else
+              dirent->mtime = apr_time_from_sec(info.st_mtime);
+#endif
+            }
+        }
+
+      err = entry_name_to_utf8(&name, entry->d_name, path, result_pool);
+      if (!err)
+        svn_hash_sets(dirents, name, dirent);
+    }
+
+  if (closedir(dir) && !err)
+    err = svn_error_wrap_apr(apr_get_os_error(),
+                             _("Error closing directory '%s'"),
+                             svn_dirent_local_style(path, scratch_pool));
+
+  return svn_error_trace(err);
+}
+
+#elif defined(WIN32) && defined(FIND_FIRST_EX_LARGE_FETCH)
+/* Microseconds between the Windows FILETIME epoch (1601-01-01) and the
+ * APR one (1970-01-01). */
+#define FILETIME_EPOCH_DELTA APR_INT64_C(11644473600000000)
+
+/* Implement svn_io_get_dirents3 for Windows.
+ *
+ * Unlike APR, skip the short file names and let the system return the
+ * directory contents in large batches.  The file information comes with
+ * every entry.  Add the entries to DIRENTS.
+ */
+static svn_error_t *
+get_dirents_win(apr_hash_t *dirents,
+                const char *path,
+                svn_boolean_t only_check_type,
+                apr_pool_t *result_pool,
+                apr_pool_t *scratch_pool)
+{
+  const WCHAR *pattern;
+  WIN32_FIND_DATAW data;
+  HANDLE handle;
+  svn_error_t *err = SVN_NO_ERROR;
+
+  SVN_ERR(svn_io__utf8_to_unicode_longpath(&pattern,
+                                           svn_dirent_join(path, "*",
+                                                           scratch_pool),
+                                           scratch_pool));
+
+  handle = FindFirstFileExW(pattern, FindExInfoBasic, &data,
+                            FindExSearchNameMatch, NULL,
+                            FIND_FIRST_EX_LARGE_FETCH);
+  if (handle == INVALID_HANDLE_VALUE)
+    {
+      apr_status_t status = apr_get_os_error();
+
+      /* Root directories don't even contain "." and "..". */
+      if (status == APR_FROM_OS_ERROR(ERROR_FILE_NOT_FOUND))
+        return SVN_NO_ERROR;
+
+      return svn_error_wrap_apr(status, _("Can't open directory '%s'"),
+                                svn_dirent_local_style(path, scratch_pool));
+    }
+
+  do
+    {
+      svn_io_dirent2_t *dirent;
+      const char *name;
+
+      if ((data.cFileName[0] == L'.')
+          && ((data.cFileName[1] == L'\0')
+              || ((data.cFileName[1] == L'.')
+                  && (data.cFileName[2] == L'\0'))))
+        continue;
+
+      dirent = svn_io_dirent2_create(result_pool);
+      if ((data.dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT)
+          && data.dwReserved0 == IO_REPARSE_TAG_SYMLINK)
+        {
+          dirent->kind = svn_node_file;
+          dirent->special = TRUE;
+        }
+      else if (data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+        dirent->kind = svn_node_dir;
+      else if (data.dwFileAttributes & FILE_ATTRIBUTE_DEVICE)
+        dirent->kind = svn_node_unknown;
+      else
+        dirent->kind = svn_node_file;
+
+      if (!only_check_type)
+        {
+          dirent->filesize = ((apr_off_t)data.nFileSizeHigh << 32)
+                           | data.nFileSizeLow;
+          dirent->mtime = ((((apr_time_t)data.ftLastWriteTime.dwHighDateTime
+                             << 32)
+                            | data.ftLastWriteTime.dwLowDateTime) / 10)
+                        - FILETIME_EPOCH_DELTA;
+        }
+
+      err = io_unicode_to_utf8_path(&name, data.cFileName, result_pool);
+      if (err)
+        break;
+
+      svn_hash_sets(dirents, name, dirent);
+    }
+  while (FindNextFileW(handle, &data));
+
+  if (!err && GetLastError() != ERROR_NO_MORE_FILES)
+    err = svn_error_wrap_apr(apr_get_os_error(),
+                             _("Can't read directory '%s'"),
+                             svn_dirent_local_style(path, scratch_pool));
+
+  if (!FindClose(handle) && !err)
+    err = svn_error_wrap_apr(apr_get_os_error(),
+                             _("Error closing directory '%s'"),
+                             svn_dirent_local_style(path, scratch_pool));
+
+  return svn_error_trace(err);
+}
+
+#else
+/* Implement svn_io_get_dirents3 using APR.  Add the entries to DIRENTS.
+ */
+static svn_error_t *
+get_dirents_apr(apr_hash_t *dirents,
+                const char *path,
+                svn_boolean_t only_check_type,
+                apr_pool_t *result_pool,
+                apr_pool_t *scratch_pool)
 {
   apr_status_t status;
   apr_dir_t *this_dir;
@@ -2829,8 +3265,6 @@ svn_io_get_dirents3(apr_hash_t **dirents,
   if (!only_check_type)
     flags |= APR_FINFO_SIZE | APR_FINFO_MTIME;
 
-  *dirents = apr_hash_make(result_pool);
-
   SVN_ERR(svn_io_dir_open(&this_dir, path, scratch_pool));
 
   for (status = apr_dir_read(&this_entry, flags, this_dir);
@@ -2861,7 +3295,7 @@ svn_io_get_dirents3(apr_hash_t **dirents,
               dirent->mtime = this_entry.mtime;
             }
 
-          svn_hash_sets(*dirents, name, dirent);
+          svn_hash_sets(dirents, name, dirent);
         }
     }
 
@@ -2876,6 +3310,28 @@ svn_io_get_dirents3(apr_hash_t **dirents,
 
   return SVN_NO_ERROR;
 }
+#endif
+
+svn_error_t *
+svn_io_get_dirents3(apr_hash_t **dirents,
+                    const char *path,
+                    svn_boolean_t only_check_type,
+                    apr_pool_t *result_pool,
+                    apr_pool_t *scratch_pool)
+{
+  *dirents = apr_hash_make(result_pool);
+
+#if defined(SVN_IO__READDIR_AT)
+  return svn_error_trace(get_dirents_at(*dirents, path, only_check_type,
+                                        result_pool, scratch_pool));
+#elif defined(WIN32) && defined(FIND_FIRST_EX_LARGE_FETCH)
+  return svn_error_trace(get_dirents_win(*dirents, path, only_check_type,
+                                         result_pool, scratch_pool));
+#else
+  return svn_error_trace(get_dirents_apr(*dirents, path, only_check_type,
+                                         result_pool, scratch_pool));
+#endif
+}
 
 svn_error_t *
 svn_io_stat_dirent2(const svn_io_dirent2_t **dirent_p,
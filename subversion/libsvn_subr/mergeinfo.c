@@ -639,7 +639,7 @@ svn_error_t *
 svn_rangelist__canonicalize(svn_rangelist_t *rangelist,
                             apr_pool_t *scratch_pool)
 {
-  int i;
+  int i, last;
   svn_merge_range_t *range, *lastrange;
 
   if (svn_rangelist__is_canonical(rangelist))
@@ -647,6 +647,9 @@ svn_rangelist__canonicalize(svn_rangelist_t *rangelist,
 
   svn_sort__array(rangelist, svn_sort_compare_ranges);
 
+  /* Compact RANGELIST in a single pass:  Elements 0 .. LAST are the
+     combined ranges so far, LASTRANGE being the youngest of them. */
+  last = 0;
   lastrange = APR_ARRAY_IDX(rangelist, 0, svn_merge_range_t *);
 
   for (i = 1; i < rangelist->nelts; i++)
@@ -678,13 +681,16 @@ svn_rangelist__canonicalize(svn_rangelist_t *rangelist,
           if (lastrange->inheritable == range->inheritable)
             {
               lastrange->end = MAX(range->end, lastrange->end);
-              svn_sort__array_delete(rangelist, i, 1);
-              i--;
+              continue;
             }
         }
-      lastrange = APR_ARRAY_IDX(rangelist, i, svn_merge_range_t *);
+
+      APR_ARRAY_IDX(rangelist, ++last, svn_merge_range_t *) = range;
+      lastrange = range;
     }
 
+  rangelist->nelts = last + 1;
+
   return SVN_NO_ERROR;
 }
 
@@ -788,167 +794,231 @@ svn_mergeinfo_parse(svn_mergeinfo_t *mergeinfo,
   return err;
 }
 
-/* Cleanup after svn_rangelist_merge2 when it modifies the ending range of
-   a single rangelist element in-place.
+/* A rangelist in compact form:  Instead of individually allocated
+   svn_merge_range_t objects, the START, END and INHERITABLE fields of
+   all NELTS ranges are stored in parallel, contiguous arrays.  The ranges
+   follow the same rules as a canonical svn_rangelist_t.
 
-   If *RANGE_INDEX is not a valid element in RANGELIST do nothing.  Otherwise
-   ensure that RANGELIST[*RANGE_INDEX]->END does not adjoin or overlap any
-   subsequent ranges in RANGELIST.
+   The arrays have room for NALLOC ranges and grow in POOL as needed. */
+typedef struct packed_rangelist_t
+{
+  svn_revnum_t *start;
+  svn_revnum_t *end;
+  svn_boolean_t *inheritable;
+  int nelts;
+  int nalloc;
+  apr_pool_t *pool;
+} packed_rangelist_t;
 
-   If overlap is found, then remove, modify, and/or add elements to RANGELIST
-   as per the invariants for rangelists documented in svn_mergeinfo.h.  If
-   RANGELIST[*RANGE_INDEX]->END adjoins a subsequent element then combine the
-   elements if their inheritability permits -- The inheritance of intersecting
-   and adjoining ranges is handled as per svn_mergeinfo_merge2.  Upon return
-   set *RANGE_INDEX to the index of the youngest element modified, added, or
-   adjoined to RANGELIST[*RANGE_INDEX].
+/* Return an empty packed rangelist with room for NALLOC ranges,
+   allocated in POOL. */
+static packed_rangelist_t *
+packed_rangelist_create(int nalloc,
+                        apr_pool_t *pool)
+{
+  packed_rangelist_t *packed = apr_pcalloc(pool, sizeof(*packed));
+
+  packed->nalloc = MAX(nalloc, 4);
+  packed->start = apr_palloc(pool, packed->nalloc * sizeof(*packed->start));
+  packed->end = apr_palloc(pool, packed->nalloc * sizeof(*packed->end));
+  packed->inheritable = apr_palloc(pool, packed->nalloc
+                                         * sizeof(*packed->inheritable));
+  packed->pool = pool;
 
-   Note: Adjoining rangelist elements are those where the end rev of the older
-   element is equal to the start rev of the younger element.
+  return packed;
+}
 
-   Any new elements inserted into RANGELIST are allocated in  RESULT_POOL.*/
+/* Append the range START-END with the given INHERITABLE flag to PACKED,
+   combining it with the last range if the two adjoin and have the same
+   inheritability.  START must not be smaller than the end of the last
+   range in PACKED. */
 static void
-adjust_remaining_ranges(svn_rangelist_t *rangelist,
-                        int *range_index,
-                        apr_pool_t *result_pool)
+packed_rangelist_append(packed_rangelist_t *packed,
+                        svn_revnum_t start,
+                        svn_revnum_t end,
+                        svn_boolean_t inheritable)
 {
-  int i;
-  int starting_index;
-  int elements_to_delete = 0;
-  svn_merge_range_t *modified_range;
+  int last = packed->nelts - 1;
+
+  if (last >= 0
+      && packed->end[last] == start
+      && packed->inheritable[last] == inheritable)
+    {
+      packed->end[last] = end;
+      return;
+    }
 
-  if (*range_index >= rangelist->nelts)
-    return;
+  if (packed->nelts == packed->nalloc)
+    {
+      packed_rangelist_t *larger
+        = packed_rangelist_create(2 * packed->nalloc, packed->pool);
+
+      memcpy(larger->start, packed->start,
+             packed->nelts * sizeof(*packed->start));
+      memcpy(larger->end, packed->end,
+             packed->nelts * sizeof(*packed->end));
+      memcpy(larger->inheritable, packed->inheritable,
+             packed->nelts * sizeof(*packed->inheritable));
+
+      packed->start = larger->start;
+      packed->end = larger->end;
+      packed->inheritable = larger->inheritable;
+      packed->nalloc = larger->nalloc;
+    }
 
-  starting_index = *range_index + 1;
-  modified_range = APR_ARRAY_IDX(rangelist, *range_index, svn_merge_range_t *);
+  packed->start[packed->nelts] = start;
+  packed->end[packed->nelts] = end;
+  packed->inheritable[packed->nelts] = inheritable;
+  ++packed->nelts;
+}
 
-  for (i = *range_index + 1; i < rangelist->nelts; i++)
+/* Return the canonical RANGELIST in packed form, allocated in POOL. */
+static packed_rangelist_t *
+packed_rangelist_from_array(const svn_rangelist_t *rangelist,
+                            apr_pool_t *pool)
+{
+  packed_rangelist_t *packed = packed_rangelist_create(rangelist->nelts,
+                                                       pool);
+  int i;
+
+  for (i = 0; i < rangelist->nelts; ++i)
     {
-      svn_merge_range_t *next_range = APR_ARRAY_IDX(rangelist, i,
-                                                    svn_merge_range_t *);
+      const svn_merge_range_t *range
+        = APR_ARRAY_IDX(rangelist, i, const svn_merge_range_t *);
 
-      /* If MODIFIED_RANGE doesn't adjoin or overlap the next range in
-         RANGELIST then we are finished. */
-      if (modified_range->end < next_range->start)
-        break;
+      packed_rangelist_append(packed, range->start, range->end,
+                              range->inheritable);
+    }
 
-      /* Does MODIFIED_RANGE adjoin NEXT_RANGE? */
-      if (modified_range->end == next_range->start)
+  return packed;
+}
+
+/* Replace the contents of RANGELIST with the ranges in PACKED.  Re-use
+   the existing range objects in RANGELIST and allocate any additional
+   ones as a single block in RESULT_POOL. */
+static void
+packed_rangelist_to_array(svn_rangelist_t *rangelist,
+                          const packed_rangelist_t *packed,
+                          apr_pool_t *result_pool)
+{
+  int i;
+  int reused = MIN(rangelist->nelts, packed->nelts);
+  svn_merge_range_t *new_ranges = NULL;
+
+  if (packed->nelts > reused)
+    new_ranges = apr_palloc(result_pool,
+                            (packed->nelts - reused) * sizeof(*new_ranges));
+
+  rangelist->nelts = reused;
+  for (i = 0; i < packed->nelts; ++i)
+    {
+      svn_merge_range_t *range;
+
+      if (i < reused)
+        range = APR_ARRAY_IDX(rangelist, i, svn_merge_range_t *);
+      else
         {
-          if (modified_range->inheritable == next_range->inheritable)
-            {
-              /* Combine adjoining ranges with the same inheritability. */
-              modified_range->end = next_range->end;
-              elements_to_delete++;
-            }
-          else
-            {
-              /* Cannot join because inheritance differs. */
-              (*range_index)++;
-            }
-          break;
+          range = &new_ranges[i - reused];
+          APR_ARRAY_PUSH(rangelist, svn_merge_range_t *) = range;
         }
 
-      /* Alright, we know MODIFIED_RANGE overlaps NEXT_RANGE, but how? */
-      if (modified_range->end > next_range->end)
+      range->start = packed->start[i];
+      range->end = packed->end[i];
+      range->inheritable = packed->inheritable[i];
+    }
+}
+
+/* Set *MERGED to the union of the packed rangelists A and B, allocated in
+   POOL.  Revisions covered by both, A and B, are inheritable if they are
+   inheritable in at least one of them.
+
+   This runs in O(A->NELTS + B->NELTS) because both inputs are sorted and
+   free of overlaps:  We simply walk both lists in parallel and emit the
+   output ranges in order. */
+static void
+packed_rangelist_merge(packed_rangelist_t **merged,
+                       const packed_rangelist_t *a,
+                       const packed_rangelist_t *b,
+                       apr_pool_t *pool)
+{
+  packed_rangelist_t *result
+    = packed_rangelist_create(a->nelts + b->nelts, pool);
+  int i = 0;
+  int j = 0;
+
+  /* Start of the not yet processed parts of A[I] and B[J]. */
+  svn_revnum_t a_start = a->nelts ? a->start[0] : 0;
+  svn_revnum_t b_start = b->nelts ? b->start[0] : 0;
+
+  while (i < a->nelts && j < b->nelts)
+    {
+      svn_revnum_t a_end = a->end[i];
+      svn_revnum_t b_end = b->end[j];
+
+      if (a_start < b_start)
         {
-          /* NEXT_RANGE is a proper subset of MODIFIED_RANGE and the two
-             don't share the same end range. */
-          if (modified_range->inheritable
-              || (modified_range->inheritable == next_range->inheritable))
-            {
-              /* MODIFIED_RANGE absorbs NEXT_RANGE. */
-              elements_to_delete++;
-            }
-          else
-            {
-              /* NEXT_RANGE is a proper subset MODIFIED_RANGE but
-                 MODIFIED_RANGE is non-inheritable and NEXT_RANGE is
-                 inheritable.  This means MODIFIED_RANGE is truncated,
-                 NEXT_RANGE remains, and the portion of MODIFIED_RANGE
-                 younger than NEXT_RANGE is added as a separate range:
-                  ______________________________________________
-                 |                                              |
-                 M                 MODIFIED_RANGE               N
-                 |                 (!inheritable)               |
-                 |______________________________________________|
-                                  |              |
-                                  O  NEXT_RANGE  P
-                                  | (inheritable)|
-                                  |______________|
-                                         |
-                                         V
-                  _______________________________________________
-                 |                |              |               |
-                 M MODIFIED_RANGE O  NEXT_RANGE  P   NEW_RANGE   N
-                 | (!inheritable) | (inheritable)| (!inheritable)|
-                 |________________|______________|_______________|
-              */
-              svn_merge_range_t *new_modified_range =
-                apr_palloc(result_pool, sizeof(*new_modified_range));
-              new_modified_range->start = next_range->end;
-              new_modified_range->end = modified_range->end;
-              new_modified_range->inheritable = FALSE;
-              modified_range->end = next_range->start;
-              (*range_index) += 2 + elements_to_delete;
-              svn_sort__array_insert(rangelist, &new_modified_range,
-                                     *range_index);
-              /* Recurse with the new range. */
-              adjust_remaining_ranges(rangelist, range_index, result_pool);
-              break;
-            }
+          /* Emit the part of A[I] before B[J]. */
+          svn_revnum_t end = MIN(a_end, b_start);
+          packed_rangelist_append(result, a_start, end, a->inheritable[i]);
+          a_start = end;
         }
-      else if (modified_range->end == next_range->end)
+      else if (b_start < a_start)
         {
-          /* NEXT_RANGE is a proper subset MODIFIED_RANGE and share
-             the same end range. */
-          if (modified_range->inheritable
-              || (modified_range->inheritable == next_range->inheritable))
-            {
-              /* MODIFIED_RANGE absorbs NEXT_RANGE. */
-              elements_to_delete++;
-            }
-          else
-            {
-              /* The intersection between MODIFIED_RANGE and NEXT_RANGE is
-                 absorbed by the latter. */
-              modified_range->end = next_range->start;
-              (*range_index)++;
-            }
-          break;
+          /* Emit the part of B[J] before A[I]. */
+          svn_revnum_t end = MIN(b_end, a_start);
+          packed_rangelist_append(result, b_start, end, b->inheritable[j]);
+          b_start = end;
         }
       else
         {
-          /* NEXT_RANGE and MODIFIED_RANGE intersect but NEXT_RANGE is not
-             a proper subset of MODIFIED_RANGE, nor do the two share the
-             same end revision, i.e. they overlap. */
-          if (modified_range->inheritable == next_range->inheritable)
-            {
-              /* Combine overlapping ranges with the same inheritability. */
-              modified_range->end = next_range->end;
-              elements_to_delete++;
-            }
-          else if (modified_range->inheritable)
-            {
-              /* MODIFIED_RANGE absorbs the portion of NEXT_RANGE it overlaps
-                 and NEXT_RANGE is truncated. */
-              next_range->start = modified_range->end;
-              (*range_index)++;
-            }
-          else
-            {
-              /* NEXT_RANGE absorbs the portion of MODIFIED_RANGE it overlaps
-                 and MODIFIED_RANGE is truncated. */
-              modified_range->end = next_range->start;
-              (*range_index)++;
-            }
-          break;
+          /* Emit the overlap of A[I] and B[J]. */
+          svn_revnum_t end = MIN(a_end, b_end);
+          packed_rangelist_append(result, a_start, end,
+                                  a->inheritable[i] || b->inheritable[j]);
+          a_start = end;
+          b_start = end;
         }
+
+      if (a_start == a_end && ++i < a->nelts)
+        a_start = a->start[i];
+      if (b_start == b_end && ++j < b->nelts)
+        b_start = b->start[j];
+    }
+
+  /* At most one of the following loops will have anything left to do. */
+  for (; i < a->nelts; ++i)
+    {
+      packed_rangelist_append(result, MAX(a_start, a->start[i]), a->end[i],
+                              a->inheritable[i]);
+    }
+
+  for (; j < b->nelts; ++j)
+    {
+      packed_rangelist_append(result, MAX(b_start, b->start[j]), b->end[j],
+                              b->inheritable[j]);
     }
 
-  if (elements_to_delete)
-    svn_sort__array_delete(rangelist, starting_index, elements_to_delete);
+  *merged = result;
+}
+
+/* Return the rangelist CHANGES in packed form, allocated in POOL.
+   Canonicalize a copy of CHANGES first, if necessary. */
+static svn_error_t *
+packed_rangelist_from_changes(packed_rangelist_t **packed,
+                              const svn_rangelist_t *changes,
+                              apr_pool_t *pool)
+{
+  if (!svn_rangelist__is_canonical(changes))
+    {
+      /* We must not modify CHANGES, so canonicalize a copy. */
+      svn_rangelist_t *copy = svn_rangelist_dup(changes, pool);
+
+      SVN_ERR(svn_rangelist__canonicalize(copy, pool));
+      changes = copy;
+    }
+
+  *packed = packed_rangelist_from_array(changes, pool);
+  return SVN_NO_ERROR;
 }
 
 #if 0 /* Temporary debug helper code */
@@ -974,268 +1044,14 @@ svn_rangelist_merge2(svn_rangelist_t *rangelist,
                      apr_pool_t *result_pool,
                      apr_pool_t *scratch_pool)
 {
-  svn_rangelist_t *changes;
-  int i = 0;
-  int j;
+  packed_rangelist_t *packed, *changes;
 
   SVN_ERR(svn_rangelist__canonicalize(rangelist, scratch_pool));
+  SVN_ERR(packed_rangelist_from_changes(&changes, chg, scratch_pool));
 
-  /* We may modify CHANGES, so make a copy in SCRATCH_POOL. */
-  changes = svn_rangelist_dup(chg, scratch_pool);
-  SVN_ERR(svn_rangelist__canonicalize(changes, scratch_pool));
-
-  for (j = 0; j < changes->nelts; j++)
-    {
-      svn_merge_range_t *range;
-      svn_merge_range_t *change =
-        APR_ARRAY_IDX(changes, j, svn_merge_range_t *);
-      int res;
-
-      range = (i < rangelist->nelts)
-              ? APR_ARRAY_IDX(rangelist, i, svn_merge_range_t *)
-              : NULL;
-
-      if (!range || change->end < range->start)
-        {
-          /* No overlap, nor adjoin, copy change to result range */
-          svn_merge_range_t *chg_copy = svn_merge_range_dup(change,
-                                                            result_pool);
-          svn_sort__array_insert(rangelist, &chg_copy, i++);
-          continue;
-        }
-      else if ((change->start > range->end)
-               || (change->start == range->end
-                   && change->inheritable != range->inheritable))
-        {
-          /* No overlap, nor adjoin. Check next range item against change */
-          i++;
-          j--;
-          continue;
-        }
-
-      if (change->start < range->start
-          && range->inheritable != change->inheritable
-          && ! (change->inheritable && range_contains(change, range, FALSE))
-          && ! (range->inheritable && range_contains(range, change, FALSE)))
-        {
-          /* Can't fold change into existing range.
-             Insert new range before range */
-
-          svn_merge_range_t *chg_copy = svn_merge_range_dup(change,
-                                                            result_pool);
-
-          chg_copy->start = MIN(change->start, range->start);
-          if (! change->inheritable)
-            chg_copy->end = range->start;
-          else
-            range->start = change->end;
-
-          svn_sort__array_insert(rangelist, &chg_copy, i++);
-
-          change->start = chg_copy->end;
-          if (change->start >= change->end)
-            continue; /* No overlap with range left */
-        }
-      else
-        {
-          range->start = MIN(range->start, change->start);
-        }
-
-      SVN_ERR_ASSERT(change->start >= range->start);
-
-      res = svn_sort_compare_ranges(&range, &change);
-
-      if (res == 0)
-        {
-          /* Only when merging two non-inheritable ranges is the result also
-             non-inheritable.  In all other cases ensure an inheritable
-             result. */
-          if (range->inheritable || change->inheritable)
-            range->inheritable = TRUE;
-          i++;
-          continue;
-        }
-      else if (res < 0) /* CHANGE is younger than RANGE */
-        {
-          if (range->end == change->start)
-            {
-              /* RANGE and CHANGE adjoin */
-              if (range->inheritable == change->inheritable)
-                {
-                  /* RANGE and CHANGE have the same inheritability so
-                     RANGE expands to absord CHANGE. */
-                  range->end = change->end;
-                  adjust_remaining_ranges(rangelist, &i, result_pool);
-                  continue;
-                }
-              else
-                {
-                  /* RANGE and CHANGE adjoin, but have different
-                     inheritability.  Since RANGE is older, just
-                     move on to the next RANGE. */
-                  SVN_ERR_MALFUNCTION();
-                }
-            }
-          else
-            {
-              /* RANGE and CHANGE overlap, but how? */
-              if ((range->inheritable == change->inheritable)
-                  || range->inheritable)
-                {
-                  /* If CHANGE is a proper subset of RANGE, it absorbs RANGE
-                      with no adjustment otherwise only the intersection is
-                      absorbed and CHANGE is truncated. */
-                  if (range->end >= change->end)
-                    continue;
-                  else
-                    {
-                      change->start = range->end;
-                      j--;
-                      continue;
-                    }
-                }
-              else
-                {
-                  /* RANGE is non-inheritable and CHANGE is inheritable. */
-                  if (range->start < change->start)
-                    {
-                      /* CHANGE absorbs intersection with RANGE and RANGE
-                         is truncated. */
-                      svn_merge_range_t *range_copy =
-                        svn_merge_range_dup(range, result_pool);
-                      range_copy->end = change->start;
-                      range->start = change->start;
-                      svn_sort__array_insert(rangelist, &range_copy, i++);
-                      j--;
-                      continue;
-                    }
-                  else
-                    {
-                      /* CHANGE and RANGE share the same start rev, but
-                         RANGE is considered older because its end rev
-                         is older. */
-                      range->inheritable = TRUE;
-                      change->start = range->end;
-                      j--;
-                      continue;
-                    }
-                }
-            }
-        }
-      else /* res > 0, CHANGE is older than RANGE */
-        {
-          if (change->end == range->start)
-            {
-              /* RANGE and CHANGE adjoin */
-              if (range->inheritable == change->inheritable)
-                {
-                  /* RANGE and CHANGE have the same inheritability so we
-                     can simply combine the two in place. */
-                  range->start = change->start;
-                  continue;
-                }
-              else
-                {
-                  /* RANGE and CHANGE have different inheritability so insert
-                     a copy of CHANGE into RANGELIST. */
-                  SVN_ERR_MALFUNCTION(); /* Already handled */
-                }
-            }
-          else
-            {
-              /* RANGE and CHANGE overlap. */
-              if (range->inheritable == change->inheritable)
-                {
-                  /* RANGE and CHANGE have the same inheritability so we
-                     can simply combine the two in place... */
-                  range->start = change->start;
-                  if (range->end < change->end)
-                    {
-                      /* ...but if RANGE is expanded ensure that we don't
-                         violate any rangelist invariants. */
-                      range->end = change->end;
-                      adjust_remaining_ranges(rangelist, &i, result_pool);
-                    }
-                  continue;
-                }
-              else if (range->inheritable)
-                {
-                  if (change->start < range->start)
-                    {
-                      /* RANGE is inheritable so absorbs any part of CHANGE
-                         it overlaps.  CHANGE is truncated and the remainder
-                         inserted into RANGELIST. */
-                      SVN_ERR_MALFUNCTION(); /* Already handled */
-                    }
-                  else
-                    {
-                      /* CHANGE and RANGE share the same start rev, but
-                         CHANGE is considered older because CHANGE->END is
-                         older than RANGE->END. */
-                      continue;
-                    }
-                }
-              else
-                {
-                  /* RANGE is non-inheritable and CHANGE is inheritable. */
-                  if (change->start < range->start)
-                    {
-                      if (change->end == range->end)
-                        {
-                          /* RANGE is a proper subset of CHANGE and share the
-                             same end revision, so set RANGE equal to CHANGE. */
-                          range->start = change->start;
-                          range->inheritable = TRUE;
-                          continue;
-                        }
-                      else if (change->end > range->end)
-                        {
-                          /* RANGE is a proper subset of CHANGE and CHANGE has
-                             a younger end revision, so set RANGE equal to its
-                             intersection with CHANGE and truncate CHANGE. */
-                          range->start = change->start;
-                          range->inheritable = TRUE;
-                          change->start = range->end;
-                          j--;
-                          continue;
-                        }
-                      else
-                        {
-                          /* CHANGE and RANGE overlap. Set RANGE equal to its
-                             intersection with CHANGE and take the remainder
-                             of RANGE and insert it into RANGELIST. */
-                          svn_merge_range_t *range_copy =
-                            svn_merge_range_dup(range, result_pool);
-                          range_copy->start = change->end;
-                          range->start = change->start;
-                          range->end = change->end;
-                          range->inheritable = TRUE;
-                          svn_sort__array_insert(rangelist, &range_copy, ++i);
-                          continue;
-                        }
-                    }
-                  else
-                    {
-                      /* CHANGE and RANGE share the same start rev, but
-                         CHANGE is considered older because its end rev
-                         is older.
-
-                         Insert the intersection of RANGE and CHANGE into
-                         RANGELIST and then set RANGE to the non-intersecting
-                         portion of RANGE. */
-                      svn_merge_range_t *range_copy =
-                        svn_merge_range_dup(range, result_pool);
-                      range_copy->end = change->end;
-                      range_copy->inheritable = TRUE;
-                      range->start = change->end;
-                      svn_sort__array_insert(rangelist, &range_copy, i++);
-                      continue;
-                    }
-                }
-            }
-        }
-      SVN_ERR_MALFUNCTION(); /* Unreachable */
-    }
+  packed = packed_rangelist_from_array(rangelist, scratch_pool);
+  packed_rangelist_merge(&packed, packed, changes, scratch_pool);
+  packed_rangelist_to_array(rangelist, packed, result_pool);
 
 #ifdef SVN_DEBUG
   SVN_ERR_ASSERT(svn_rangelist__is_canonical(rangelist));
@@ -2697,20 +2513,27 @@ svn_rangelist__merge_many(svn_rangelist_t *merged_rangelist,
 {
   if (apr_hash_count(merge_history))
     {
-      apr_pool_t *iterpool = svn_pool_create(scratch_pool);
       apr_hash_index_t *hi;
+      packed_rangelist_t *packed;
+
+      /* Keep the intermediate results in packed form and convert them
+         back into MERGED_RANGELIST only once at the end. */
+      SVN_ERR(svn_rangelist__canonicalize(merged_rangelist, scratch_pool));
+      packed = packed_rangelist_from_array(merged_rangelist, scratch_pool);
 
       for (hi = apr_hash_first(scratch_pool, merge_history);
            hi;
            hi = apr_hash_next(hi))
         {
           svn_rangelist_t *subtree_rangelist = apr_hash_this_val(hi);
+          packed_rangelist_t *changes;
 
-          svn_pool_clear(iterpool);
-          SVN_ERR(svn_rangelist_merge2(merged_rangelist, subtree_rangelist,
-                                       result_pool, iterpool));
+          SVN_ERR(packed_rangelist_from_changes(&changes, subtree_rangelist,
+                                                scratch_pool));
+          packed_rangelist_merge(&packed, packed, changes, scratch_pool);
         }
-      svn_pool_destroy(iterpool);
+
+      packed_rangelist_to_array(merged_rangelist, packed, result_pool);
     }
   return SVN_NO_ERROR;
 }
@@ -0,0 +1,433 @@
+/*
+ * metrics.c: process-wide statistics for server monitoring
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include <apr_hash.h>
+
+#include "svn_hash.h"
+#include "svn_pools.h"
+#include "svn_sorts.h"
+
+#include "private/svn_atomic.h"
+#include "private/svn_cache.h"
+#include "private/svn_metrics.h"
+#include "private/svn_mutex.h"
+#include "private/svn_sorts_private.h"
+
+/* Upper bounds of the histogram buckets in microseconds and as exported
+ * in seconds.  Observations above the last bound only go into the
+ * implicit "+Inf" bucket. */
+static const struct
+{
+  apr_interval_time_t bound;
+  const char *text;
+} buckets[] =
+{
+  {      100, "0.0001" },
+  {      500, "0.0005" },
+  {     1000, "0.001" },
+  {     5000, "0.005" },
+  {    10000, "0.01" },
+  {    50000, "0.05" },
+  {   100000, "0.1" },
+  {   500000, "0.5" },
+  {  1000000, "1" },
+  {  5000000, "5" },
+  { 10000000, "10" }
+};
+
+#define BUCKET_COUNT (sizeof(buckets) / sizeof(buckets[0]))
+
+struct svn_metrics__t
+{
+  /* Label specification, "" if there are no labels. */
+  const char *labels;
+
+  /* Counter value or, for histograms, the number of observations. */
+  apr_uint64_t value;
+
+  /* Histograms only: sum of all observations in microseconds. */
+  apr_uint64_t sum;
+
+  /* Histograms only: number of observations per bucket, not including
+   * those of smaller buckets. */
+  apr_uint64_t buckets[BUCKET_COUNT];
+};
+
+/* All metrics of the same name. */
+typedef struct family_t
+{
+  const char *help;
+  svn_boolean_t histogram;
+
+  /* Label specification -> svn_metrics__t *. */
+  apr_hash_t *metrics;
+} family_t;
+
+/* Process-global registry, initialized by init_metrics(). */
+static volatile svn_atomic_t metrics_init_state = 0;
+static apr_pool_t *metrics_pool = NULL;
+static svn_mutex__t *metrics_mutex = NULL;
+
+/* Metric name -> family_t *. */
+static apr_hash_t *families = NULL;
+
+/* Implements svn_atomic__err_init_func_t. */
+static svn_error_t *
+init_metrics(void *baton,
+             apr_pool_t *pool)
+{
+  metrics_pool = svn_pool_create(NULL);
+  SVN_ERR(svn_mutex__init(&metrics_mutex, TRUE, metrics_pool));
+  families = apr_hash_make(metrics_pool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *METRIC to the metric NAME with LABELS, creating it and its family
+ * with HELP and HISTOGRAM as needed.  To be called with METRICS_MUTEX
+ * being held. */
+static svn_error_t *
+find_metric(svn_metrics__t **metric,
+            const char *name,
+            const char *labels,
+            const char *help,
+            svn_boolean_t histogram)
+{
+  family_t *family = svn_hash_gets(families, name);
+
+  if (!family)
+    {
+      family = apr_pcalloc(metrics_pool, sizeof(*family));
+      family->help = apr_pstrdup(metrics_pool, help);
+      family->histogram = histogram;
+      family->metrics = apr_hash_make(metrics_pool);
+      svn_hash_sets(families, apr_pstrdup(metrics_pool, name), family);
+    }
+  else if (family->histogram != histogram)
+    {
+      *metric = NULL;
+      return SVN_NO_ERROR;
+    }
+
+  *metric = svn_hash_gets(family->metrics, labels);
+  if (!*metric)
+    {
+      *metric = apr_pcalloc(metrics_pool, sizeof(**metric));
+      (*metric)->labels = apr_pstrdup(metrics_pool, labels);
+      svn_hash_sets(family->metrics, (*metric)->labels, *metric);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Thread-safe wrapper around find_metric(). */
+static svn_error_t *
+find_metric_locked(svn_metrics__t **metric,
+                   const char *name,
+                   const char *labels,
+                   const char *help,
+                   svn_boolean_t histogram)
+{
+  SVN_ERR(svn_atomic__init_once(&metrics_init_state, init_metrics,
+                                NULL, NULL));
+  SVN_MUTEX__WITH_LOCK(metrics_mutex,
+                       find_metric(metric, name, labels ? labels : "",
+                                   help, histogram));
+
+  return SVN_NO_ERROR;
+}
+
+/* Return the metric NAME with LABELS, HELP and HISTOGRAM, or NULL. */
+static svn_metrics__t *
+get_metric(const char *name,
+           const char *labels,
+           const char *help,
+           svn_boolean_t histogram)
+{
+  svn_metrics__t *metric = NULL;
+  svn_error_t *err = find_metric_locked(&metric, name, labels, help,
+                                        histogram);
+
+  if (err)
+    {
+      svn_error_clear(err);
+      return NULL;
+    }
+
+  return metric;
+}
+
+svn_metrics__t *
+svn_metrics__counter(const char *name,
+                     const char *labels,
+                     const char *help)
+{
+  return get_metric(name, labels, help, FALSE);
+}
+
+svn_metrics__t *
+svn_metrics__histogram(const char *name,
+                       const char *labels,
+                       const char *help)
+{
+  return get_metric(name, labels, help, TRUE);
+}
+
+void
+svn_metrics__add(svn_metrics__t *metric,
+                 apr_uint64_t value)
+{
+  if (metric)
+    metric->value += value;
+}
+
+void
+svn_metrics__observe(svn_metrics__t *metric,
+                     apr_interval_time_t duration)
+{
+  apr_size_t i;
+
+  if (!metric)
+    return;
+
+  if (duration < 0)
+    duration = 0;
+
+  metric->value++;
+  metric->sum += duration;
+
+  for (i = 0; i < BUCKET_COUNT; ++i)
+    if (duration <= buckets[i].bound)
+      {
+        metric->buckets[i]++;
+        break;
+      }
+}
+
+const char *
+svn_metrics__label(const char *name,
+                   const char *value,
+                   apr_pool_t *result_pool)
+{
+  svn_stringbuf_t *result = svn_stringbuf_create(name, result_pool);
+
+  svn_stringbuf_appendcstr(result, "=\"");
+  for (; *value; ++value)
+    {
+      if (*value == '\\' || *value == '"')
+        svn_stringbuf_appendbyte(result, '\\');
+      else if (*value == '\n')
+        {
+          svn_stringbuf_appendcstr(result, "\\n");
+          continue;
+        }
+
+      svn_stringbuf_appendbyte(result, *value);
+    }
+  svn_stringbuf_appendbyte(result, '"');
+
+  return result->data;
+}
+
+/* Append the help and type lines for the metric NAME to TEXT. */
+static void
+format_header(svn_stringbuf_t *text,
+              const char *name,
+              const char *help,
+              const char *type)
+{
+  svn_stringbuf_appendcstr(text, "# HELP ");
+  svn_stringbuf_appendcstr(text, name);
+  svn_stringbuf_appendbyte(text, ' ');
+  svn_stringbuf_appendcstr(text, help);
+  svn_stringbuf_appendcstr(text, "\n# TYPE ");
+  svn_stringbuf_appendcstr(text, name);
+  svn_stringbuf_appendbyte(text, ' ');
+  svn_stringbuf_appendcstr(text, type);
+  svn_stringbuf_appendbyte(text, '\n');
+}
+
+/* Append the sample NAME SUFFIX {LABELS, EXTRA_LABEL} VALUE to TEXT.
+ * LABELS and EXTRA_LABEL may be empty. */
+static void
+format_sample(svn_stringbuf_t *text,
+              const char *name,
+              const char *suffix,
+              const char *labels,
+              const char *extra_label,
+              const char *value)
+{
+  svn_stringbuf_appendcstr(text, name);
+  svn_stringbuf_appendcstr(text, suffix);
+  if (*labels || *extra_label)
+    {
+      svn_stringbuf_appendbyte(text, '{');
+      svn_stringbuf_appendcstr(text, labels);
+      if (*labels && *extra_label)
+        svn_stringbuf_appendbyte(text, ',');
+      svn_stringbuf_appendcstr(text, extra_label);
+      svn_stringbuf_appendbyte(text, '}');
+    }
+  svn_stringbuf_appendbyte(text, ' ');
+  svn_stringbuf_appendcstr(text, value);
+  svn_stringbuf_appendbyte(text, '\n');
+}
+
+/* Append the samples of METRIC of the family NAME to TEXT.  Use
+ * SCRATCH_POOL for temporary allocations. */
+static void
+format_metric(svn_stringbuf_t *text,
+              const char *name,
+              const family_t *family,
+              const svn_metrics__t *metric,
+              apr_pool_t *scratch_pool)
+{
+  if (family->histogram)
+    {
+      apr_uint64_t count = 0;
+      apr_size_t i;
+
+      for (i = 0; i < BUCKET_COUNT; ++i)
+        {
+          count += metric->buckets[i];
+          format_sample(text, name, "_bucket", metric->labels,
+                        apr_psprintf(scratch_pool, "le=\"%s\"",
+                                     buckets[i].text),
+                        apr_psprintf(scratch_pool, "%" APR_UINT64_T_FMT,
+                                     count));
+        }
+
+      format_sample(text, name, "_bucket", metric->labels, "le=\"+Inf\"",
+                    apr_psprintf(scratch_pool, "%" APR_UINT64_T_FMT,
+                                 metric->value));
+      format_sample(text, name, "_sum", metric->labels, "",
+                    apr_psprintf(scratch_pool,
+                                 "%" APR_UINT64_T_FMT ".%06" APR_UINT64_T_FMT,
+                                 metric->sum / APR_USEC_PER_SEC,
+                                 metric->sum % APR_USEC_PER_SEC));
+      format_sample(text, name, "_count", metric->labels, "",
+                    apr_psprintf(scratch_pool, "%" APR_UINT64_T_FMT,
+                                 metric->value));
+    }
+  else
+    {
+      format_sample(text, name, "", metric->labels, "",
+                    apr_psprintf(scratch_pool, "%" APR_UINT64_T_FMT,
+                                 metric->value));
+    }
+}
+
+/* Append all registered metrics to TEXT.  To be called with
+ * METRICS_MUTEX being held.  Use SCRATCH_POOL for temporary
+ * allocations. */
+static svn_error_t *
+format_registry(svn_stringbuf_t *text,
+                apr_pool_t *scratch_pool)
+{
+  apr_array_header_t *sorted_families;
+  int i, k;
+
+  sorted_families = svn_sort__hash(families,
+                                   svn_sort_compare_items_lexically,
+                                   scratch_pool);
+  for (i = 0; i < sorted_families->nelts; ++i)
+    {
+      svn_sort__item_t *item = &APR_ARRAY_IDX(sorted_families, i,
+                                              svn_sort__item_t);
+      const char *name = item->key;
+      const family_t *family = item->value;
+      apr_array_header_t *sorted_metrics;
+
+      format_header(text, name, family->help,
+                    family->histogram ? "histogram" : "counter");
+
+      sorted_metrics = svn_sort__hash(family->metrics,
+                                      svn_sort_compare_items_lexically,
+                                      scratch_pool);
+      for (k = 0; k < sorted_metrics->nelts; ++k)
+        format_metric(text, name, family,
+                      APR_ARRAY_IDX(sorted_metrics, k,
+                                    svn_sort__item_t).value,
+                      scratch_pool);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Append the single-valued metric NAME of TYPE described by HELP with
+ * VALUE to TEXT.  Use SCRATCH_POOL for temporary allocations. */
+static void
+format_value(svn_stringbuf_t *text,
+             const char *name,
+             const char *type,
+             const char *help,
+             apr_uint64_t value,
+             apr_pool_t *scratch_pool)
+{
+  format_header(text, name, help, type);
+  format_sample(text, name, "", "", "",
+                apr_psprintf(scratch_pool, "%" APR_UINT64_T_FMT, value));
+}
+
+svn_error_t *
+svn_metrics__format(svn_stringbuf_t **text,
+                    apr_pool_t *result_pool,
+                    apr_pool_t *scratch_pool)
+{
+  *text = svn_stringbuf_create_empty(result_pool);
+
+  /* The membuffer cache keeps its own global statistics. */
+  if (svn_cache__get_global_membuffer_cache())
+    {
+      svn_cache__info_t *info
+        = svn_cache__membuffer_get_global_info(scratch_pool);
+
+      format_value(*text, "svn_cache_membuffer_gets_total", "counter",
+                   "Lookups in the membuffer cache.",
+                   info->gets, scratch_pool);
+      format_value(*text, "svn_cache_membuffer_hits_total", "counter",
+                   "Lookups in the membuffer cache that found data.",
+                   info->hits, scratch_pool);
+      format_value(*text, "svn_cache_membuffer_sets_total", "counter",
+                   "Items written to the membuffer cache.",
+                   info->sets, scratch_pool);
+      format_value(*text, "svn_cache_membuffer_evictions_total", "counter",
+                   "Items evicted from the membuffer cache to make room.",
+                   info->evictions, scratch_pool);
+      format_value(*text, "svn_cache_membuffer_used_bytes", "gauge",
+                   "Size of the data in the membuffer cache.",
+                   info->used_size, scratch_pool);
+      format_value(*text, "svn_cache_membuffer_size_bytes", "gauge",
+                   "Total size of the membuffer cache.",
+                   info->total_size, scratch_pool);
+      format_value(*text, "svn_cache_membuffer_entries", "gauge",
+                   "Number of items in the membuffer cache.",
+                   info->used_entries, scratch_pool);
+    }
+
+  SVN_ERR(svn_atomic__init_once(&metrics_init_state, init_metrics,
+                                NULL, NULL));
+  SVN_MUTEX__WITH_LOCK(metrics_mutex, format_registry(*text, scratch_pool));
+
+  return SVN_NO_ERROR;
+}
@@ -22,11 +22,24 @@
  */
 
 #include <apr_portable.h>
+#include <apr_thread_proc.h>
+#include <apr_thread_rwlock.h>
 
 #include "svn_private_config.h"
 #include "private/svn_atomic.h"
+#include "private/svn_dep_compat.h"
 #include "private/svn_mutex.h"
 
+/* Upper limit to the number of attempts to get a busy svn_rwlock__t
+ * before blocking.
+ */
+#define MAX_SPIN_COUNT 100
+
+/* Number of attempts to get a busy svn_rwlock__t before blocking,
+ * in addition to the adaptive part.
+ */
+#define MIN_SPIN_COUNT 10
+
 /* With CHECKED set to TRUE, LOCKED and OWNER must be set *after* acquiring
  * the MUTEX and be reset *before* releasing it again.  This is sufficient
  * because we only want to check whether the current thread already holds
@@ -115,3 +128,141 @@ svn_mutex__get(svn_mutex__t *mutex)
 }
 
 #endif
+
+struct svn_rwlock__t
+{
+#if APR_HAS_THREADS
+
+  apr_thread_rwlock_t *lock;
+
+  /* If set, retry a busy lock before blocking. */
+  svn_boolean_t spin;
+
+  /* Running average of the number of retries that it took to get the
+   * lock.  This is only a hint, so we update it without synchronization.
+   */
+  int spins;
+
+#else
+
+  /* Truly empty structs are not allowed. */
+  int dummy;
+
+#endif
+};
+
+#if APR_HAS_THREADS
+
+/* Acquire LOCK using TRY_LOCK and, if that keeps reporting the lock as
+ * busy for a while, using BLOCKING_LOCK.  Between attempts, yield the CPU
+ * so that the current holder gets a chance to release the lock.
+ */
+static apr_status_t
+acquire_rwlock(svn_rwlock__t *lock,
+               apr_status_t (*try_lock)(apr_thread_rwlock_t *),
+               apr_status_t (*blocking_lock)(apr_thread_rwlock_t *))
+{
+  if (lock->spin)
+    {
+      int limit = lock->spins * 2 + MIN_SPIN_COUNT;
+      int count;
+      apr_status_t status = APR_SUCCESS;
+
+      if (limit > MAX_SPIN_COUNT)
+        limit = MAX_SPIN_COUNT;
+
+      for (count = 0; count < limit; ++count)
+        {
+          status = try_lock(lock->lock);
+          if (!SVN_LOCK_IS_BUSY(status))
+            break;
+
+          apr_thread_yield();
+        }
+
+      /* Adapt slowly, similar to what glibc does for adaptive mutexes. */
+      lock->spins += (count - lock->spins) / 8;
+
+      if (count < limit)
+        return status;
+    }
+
+  return blocking_lock(lock->lock);
+}
+
+#endif
+
+svn_error_t *
+svn_rwlock__init(svn_rwlock__t **lock_p,
+                 svn_boolean_t lock_required,
+                 svn_boolean_t spin,
+                 apr_pool_t *result_pool)
+{
+  *lock_p = NULL;
+
+  if (lock_required)
+    {
+      svn_rwlock__t *lock = apr_pcalloc(result_pool, sizeof(*lock));
+
+#if APR_HAS_THREADS
+      apr_status_t status = apr_thread_rwlock_create(&lock->lock,
+                                                     result_pool);
+      if (status)
+        return svn_error_wrap_apr(status, _("Can't create rwlock"));
+
+      lock->spin = spin;
+#endif
+
+      *lock_p = lock;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_rwlock__read_lock(svn_rwlock__t *lock)
+{
+  if (lock)
+    {
+#if APR_HAS_THREADS
+      apr_status_t status = acquire_rwlock(lock, apr_thread_rwlock_tryrdlock,
+                                           apr_thread_rwlock_rdlock);
+      if (status)
+        return svn_error_wrap_apr(status, _("Can't get read lock"));
+#endif
+    }
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_rwlock__write_lock(svn_rwlock__t *lock)
+{
+  if (lock)
+    {
+#if APR_HAS_THREADS
+      apr_status_t status = acquire_rwlock(lock, apr_thread_rwlock_trywrlock,
+                                           apr_thread_rwlock_wrlock);
+      if (status)
+        return svn_error_wrap_apr(status, _("Can't get write lock"));
+#endif
+    }
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_rwlock__unlock(svn_rwlock__t *lock,
+                   svn_error_t *err)
+{
+  if (lock)
+    {
+#if APR_HAS_THREADS
+      apr_status_t status = apr_thread_rwlock_unlock(lock->lock);
+      if (status && !err)
+        return svn_error_wrap_apr(status, _("Can't unlock rwlock"));
+#endif
+    }
+
+  return err;
+}
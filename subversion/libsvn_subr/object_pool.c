@@ -60,12 +60,13 @@ typedef struct object_ref_t
 } object_ref_t;
 
 
-/* Core data structure.  All access to it must be serialized using MUTEX.
+/* Core data structure.  All access to it must be serialized using LOCK.
  */
 struct svn_object_pool__t
 {
-  /* serialization object for all non-atomic data in this struct */
-  svn_mutex__t *mutex;
+  /* serialization object for all non-atomic data in this struct.
+   * Lookups only need a read lock as they don't modify OBJECTS. */
+  svn_rwlock__t *lock;
 
   /* object_ref_t.KEY -> object_ref_t* mapping.
    *
@@ -181,7 +182,9 @@ add_object_ref(object_ref_t *object_ref,
 
 /* Actual implementation of svn_object_pool__lookup.
  *
- * Requires external serialization on OBJECT_POOL.
+ * Requires at least a read lock on OBJECT_POOL.  Reference counting
+ * only uses atomic operations and unused objects get only removed while
+ * holding the write lock.
  */
 static svn_error_t *
 lookup(void **object,
@@ -274,7 +277,7 @@ svn_object_pool__create(svn_object_pool__t **object_pool,
    * cleanup and to prevent threading issues with the allocator
    */
   result = apr_pcalloc(pool, sizeof(*result));
-  SVN_ERR(svn_mutex__init(&result->mutex, thread_safe, pool));
+  SVN_ERR(svn_rwlock__init(&result->lock, thread_safe, TRUE, pool));
 
   result->pool = pool;
   result->objects = svn_hash__make(result->pool);
@@ -306,8 +309,8 @@ svn_object_pool__lookup(void **object,
                         apr_pool_t *result_pool)
 {
   *object = NULL;
-  SVN_MUTEX__WITH_LOCK(object_pool->mutex,
-                       lookup(object, object_pool, key, result_pool));
+  SVN_RWLOCK__WITH_READ_LOCK(object_pool->lock,
+                             lookup(object, object_pool, key, result_pool));
   return SVN_NO_ERROR;
 }
 
@@ -320,8 +323,8 @@ svn_object_pool__insert(void **object,
                         apr_pool_t *result_pool)
 {
   *object = NULL;
-  SVN_MUTEX__WITH_LOCK(object_pool->mutex,
-                       insert(object, object_pool, key, item, 
-                              item_pool, result_pool));
+  SVN_RWLOCK__WITH_WRITE_LOCK(object_pool->lock,
+                              insert(object, object_pool, key, item,
+                                     item_pool, result_pool));
   return SVN_NO_ERROR;
 }
@@ -31,6 +31,16 @@
 
 #include "svn_private_config.h"
 
+/* Encode and decode 7b/8b numbers of up to 8 bytes with a few 64 bit
+ * word operations instead of a loop over the individual bytes.  This
+ * requires a little-endian machine and the GCC bit-scan builtins. */
+#if SVN_UNALIGNED_ACCESS_IS_OK && defined(__GNUC__) \
+    && defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+#  define SVN_PACKED_WORD_CODEC 1
+#else
+#  define SVN_PACKED_WORD_CODEC 0
+#endif
+
 
 
 /* Private int stream data referenced by svn_packed__int_stream_t.
@@ -266,6 +276,31 @@ svn_packed__create_bytes_stream(svn_packed__data_root_t *root)
 static unsigned char *
 write_packed_uint_body(unsigned char *buffer, apr_uint64_t value)
 {
+#if SVN_PACKED_WORD_CODEC
+  /* Spread the 7 bit groups of numbers with up to 8 bytes of encoded
+     representation into a single word and terminate it. */
+  if (value >= 0x80 && value < APR_UINT64_C(0x100000000000000))
+    {
+      int len = (64 - __builtin_clzll(value) + 6) / 7;
+      apr_uint64_t word
+        = (value & 0x7f)
+        | ((value << 1) & APR_UINT64_C(0x7f00))
+        | ((value << 2) & APR_UINT64_C(0x7f0000))
+        | ((value << 3) & APR_UINT64_C(0x7f000000))
+        | ((value << 4) & APR_UINT64_C(0x7f00000000))
+        | ((value << 5) & APR_UINT64_C(0x7f0000000000))
+        | ((value << 6) & APR_UINT64_C(0x7f000000000000))
+        | ((value << 7) & APR_UINT64_C(0x7f00000000000000));
+
+      /* Set the "continue" bit in all but the last byte. */
+      word |= APR_UINT64_C(0x8080808080808080)
+            & ((APR_UINT64_C(1) << (8 * (len - 1))) - 1);
+
+      memcpy(buffer, &word, sizeof(word));
+      return buffer + len;
+    }
+#endif
+
   while (value >= 0x80)
     {
       *(buffer++) = (unsigned char)((value % 0x80) + 0x80);
@@ -721,6 +756,43 @@ read_packed_uint_body(unsigned char *p, apr_uint64_t *result)
   return ++p;
 }
 
+/* Like read_packed_uint_body but P must provide at least 8 bytes of
+ * readable data.
+ */
+static unsigned char *
+read_packed_uint_word(unsigned char *p, apr_uint64_t *result)
+{
+#if SVN_PACKED_WORD_CODEC
+  if (*p >= 0x80)
+    {
+      apr_uint64_t word, stop;
+      memcpy(&word, p, sizeof(word));
+
+      /* Bytes without the "continue" bit.  The first one ends the number.
+         There is none for numbers longer than 8 bytes. */
+      stop = ~word & APR_UINT64_C(0x8080808080808080);
+      if (stop)
+        {
+          /* Drop all bytes after the last one and collect the 7 bit
+             groups. */
+          word &= stop ^ (stop - 1);
+          *result = (word & 0x7f)
+                  | ((word >> 1) & APR_UINT64_C(0x3f80))
+                  | ((word >> 2) & APR_UINT64_C(0x1fc000))
+                  | ((word >> 3) & APR_UINT64_C(0xfe00000))
+                  | ((word >> 4) & APR_UINT64_C(0x7f0000000))
+                  | ((word >> 5) & APR_UINT64_C(0x3f800000000))
+                  | ((word >> 6) & APR_UINT64_C(0x1fc0000000000))
+                  | ((word >> 7) & APR_UINT64_C(0xfe000000000000));
+
+          return p + __builtin_ctzll(stop) / 8 + 1;
+        }
+    }
+#endif
+
+  return read_packed_uint_body(p, result);
+}
+
 /* Read one 7b/8b encoded value from STREAM and return it in *RESULT.
  *
  * Overflows will be detected in the sense that it will end parsing the
@@ -801,8 +873,10 @@ svn_packed__data_fill_buffer(svn_packed__int_stream_t *stream)
   else
     {
       /* use this local buffer only if the packed data is shorter than this.
-         The goal is that read_packed_uint_body doesn't need check for
-         overflows. */
+         The goal is that read_packed_uint_word doesn't need check for
+         overflows and may always read 8 bytes.  That is true because
+         each number takes at most 10 bytes, so the last one starts at
+         least 10 bytes before the end of the buffer. */
       unsigned char local_buffer[10 * SVN__PACKED_DATA_BUFFER_SIZE];
       unsigned char *p;
       unsigned char *start;
@@ -814,7 +888,7 @@ svn_packed__data_fill_buffer(svn_packed__int_stream_t *stream)
           memcpy(local_buffer,
                  private_data->packed->data,
                  private_data->packed->len);
-          memset(local_buffer + private_data->packed->len, 0, MIN(trail, end));
+          memset(local_buffer + private_data->packed->len, 0, trail);
 
           p = local_buffer;
         }
@@ -824,7 +898,7 @@ svn_packed__data_fill_buffer(svn_packed__int_stream_t *stream)
       /* unpack numbers */
       start = p;
       for (i = end; i > 0; --i)
-        p = read_packed_uint_body(p, &stream->buffer[i-1]);
+        p = read_packed_uint_word(p, &stream->buffer[i-1]);
 
       /* adjust remaining packed data buffer */
       packed_read = p - start;
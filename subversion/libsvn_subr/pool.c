@@ -32,9 +32,17 @@
 #include <apr_pools.h>
 
 #include "svn_pools.h"
+#include "svn_io.h"
+#include "svn_sorts.h"
+#include "private/svn_atomic.h"
+#include "private/svn_mutex.h"
+#include "private/svn_sorts_private.h"
+#include "private/svn_subr_private.h"
 
 #include "pools.h"
 
+#include "svn_private_config.h"
+
 #if APR_POOL_DEBUG
 /* file_line for the non-debug case. */
 static const char SVN_FILE_LINE_UNDEFINED[] = "svn:<undefined>";
@@ -66,6 +74,352 @@ abort_on_pool_failure(int retcode)
 }
 
 
+/*-----------------------------------------------------------------*/
+
+/* Pool profiling.
+ *
+ * With APR_POOL_DEBUG, APR counts the bytes allocated in every pool and
+ * svn_pool_create_ex_debug() gets told where the pool has been created.
+ * Once enabled, every new pool gets a tracker linked into the list of
+ * its creation site.  A pool cleanup records the pool's size when it
+ * gets cleared or destroyed and unlinks the tracker.  svn_pool_clear()
+ * then attaches a new tracker.
+ */
+
+#if APR_POOL_DEBUG
+
+/* Key of the pool_tracker_t in the pool's user data. */
+#define PROFILE_TRACKER_KEY "svn-pool-profile"
+
+struct pool_tracker_t;
+
+/* Statistics for all pools created at FILE_LINE. */
+typedef struct pool_site_t
+{
+  const char *file_line;
+
+  /* Number of pools created at this site. */
+  apr_uint64_t created;
+
+  /* Sum of the sizes of all pools at the time they got cleared or
+     destroyed. */
+  apr_uint64_t total_bytes;
+
+  /* Largest size of a single pool seen so far. */
+  apr_size_t peak_bytes;
+
+  /* Trackers of the pools currently alive. */
+  struct pool_tracker_t *first;
+} pool_site_t;
+
+/* Links a tracked POOL to its SITE.  Allocated in POOL itself. */
+typedef struct pool_tracker_t
+{
+  apr_pool_t *pool;
+  pool_site_t *site;
+  struct pool_tracker_t *previous;
+  struct pool_tracker_t *next;
+} pool_tracker_t;
+
+/* A per-site summary as reported by svn_pool__profile_format(). */
+typedef struct site_summary_t
+{
+  const char *file_line;
+  apr_uint64_t created;
+  apr_uint64_t live;
+  apr_uint64_t live_bytes;
+  apr_uint64_t total_bytes;
+  apr_size_t peak_bytes;
+} site_summary_t;
+
+/* Process-global profile, initialized by init_profile(). */
+static volatile svn_atomic_t profile_init_state = 0;
+static volatile svn_atomic_t profile_enabled = FALSE;
+static apr_pool_t *profile_pool = NULL;
+static svn_mutex__t *profile_mutex = NULL;
+
+/* const char * file_line -> pool_site_t * */
+static apr_hash_t *profile_sites = NULL;
+
+/* svn_atomic__init_once() callback creating the profile. */
+static svn_error_t *
+init_profile(void *baton,
+             apr_pool_t *pool)
+{
+  /* Profiling is not enabled yet, so this pool will not be tracked. */
+  profile_pool = svn_pool_create(NULL);
+  SVN_ERR(svn_mutex__init(&profile_mutex, TRUE, profile_pool));
+  profile_sites = apr_hash_make(profile_pool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Account for SIZE bytes held by a pool of SITE. */
+static void
+record_size(pool_site_t *site,
+            apr_size_t size)
+{
+  if (site->peak_bytes < size)
+    site->peak_bytes = size;
+}
+
+/* Link TRACKER into the list of site FILE_LINE.  If IS_NEW is set, count
+ * it as a newly created pool.  The caller must hold PROFILE_MUTEX. */
+static svn_error_t *
+link_tracker(pool_tracker_t *tracker,
+             const char *file_line,
+             svn_boolean_t is_new)
+{
+  apr_size_t len = strlen(file_line);
+  pool_site_t *site = apr_hash_get(profile_sites, file_line, len);
+  if (!site)
+    {
+      site = apr_pcalloc(profile_pool, sizeof(*site));
+      site->file_line = apr_pstrmemdup(profile_pool, file_line, len);
+      apr_hash_set(profile_sites, site->file_line, len, site);
+    }
+
+  if (is_new)
+    ++site->created;
+
+  tracker->site = site;
+  tracker->previous = NULL;
+  tracker->next = site->first;
+  if (site->first)
+    site->first->previous = tracker;
+  site->first = tracker;
+
+  return SVN_NO_ERROR;
+}
+
+/* Record the final size of the pool of TRACKER and remove the tracker
+ * from its site.  The caller must hold PROFILE_MUTEX. */
+static svn_error_t *
+unlink_tracker(pool_tracker_t *tracker)
+{
+  pool_site_t *site = tracker->site;
+  apr_size_t size = apr_pool_num_bytes(tracker->pool, 0);
+
+  record_size(site, size);
+  site->total_bytes += size;
+
+  if (tracker->previous)
+    tracker->previous->next = tracker->next;
+  else
+    site->first = tracker->next;
+  if (tracker->next)
+    tracker->next->previous = tracker->previous;
+
+  return SVN_NO_ERROR;
+}
+
+/* Pool cleanup function for the pool_tracker_t DATA. */
+static apr_status_t
+untrack_pool(void *data)
+{
+  svn_error_t *err = svn_mutex__lock(profile_mutex);
+  if (!err)
+    err = svn_mutex__unlock(profile_mutex, unlink_tracker(data));
+
+  svn_error_clear(err);
+  return APR_SUCCESS;
+}
+
+/* Start tracking POOL as created at FILE_LINE.  IS_NEW is as for
+ * link_tracker(). */
+static void
+track_pool(apr_pool_t *pool,
+           const char *file_line,
+           svn_boolean_t is_new)
+{
+  pool_tracker_t *tracker = apr_pcalloc(pool, sizeof(*tracker));
+  svn_error_t *err;
+
+  tracker->pool = pool;
+  err = svn_mutex__lock(profile_mutex);
+  if (!err)
+    err = svn_mutex__unlock(profile_mutex,
+                            link_tracker(tracker, file_line, is_new));
+  if (err)
+    {
+      svn_error_clear(err);
+      return;
+    }
+
+  apr_pool_userdata_setn(tracker, PROFILE_TRACKER_KEY, NULL, pool);
+  apr_pool_cleanup_register(pool, tracker, untrack_pool,
+                            apr_pool_cleanup_null);
+}
+
+/* Append summaries of all sites to the array of site_summary_t
+ * SUMMARIES.  The caller must hold PROFILE_MUTEX. */
+static svn_error_t *
+summarize_sites(apr_array_header_t *summaries)
+{
+  apr_hash_index_t *hi;
+
+  for (hi = apr_hash_first(NULL, profile_sites); hi; hi = apr_hash_next(hi))
+    {
+      pool_site_t *site = apr_hash_this_val(hi);
+      site_summary_t *summary = apr_array_push(summaries);
+      pool_tracker_t *tracker;
+
+      summary->file_line = site->file_line;
+      summary->created = site->created;
+      summary->live = 0;
+      summary->live_bytes = 0;
+      for (tracker = site->first; tracker; tracker = tracker->next)
+        {
+          apr_size_t size = apr_pool_num_bytes(tracker->pool, 0);
+          record_size(site, size);
+
+          ++summary->live;
+          summary->live_bytes += size;
+        }
+
+      summary->total_bytes = site->total_bytes;
+      summary->peak_bytes = site->peak_bytes;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Sort callback for site_summary_t, largest live and total sizes first.
+ */
+static int
+compare_summaries(const void *lhs,
+                  const void *rhs)
+{
+  const site_summary_t *lhs_summary = lhs;
+  const site_summary_t *rhs_summary = rhs;
+
+  if (lhs_summary->live_bytes != rhs_summary->live_bytes)
+    return lhs_summary->live_bytes > rhs_summary->live_bytes ? -1 : 1;
+  if (lhs_summary->total_bytes != rhs_summary->total_bytes)
+    return lhs_summary->total_bytes > rhs_summary->total_bytes ? -1 : 1;
+
+  return strcmp(lhs_summary->file_line, rhs_summary->file_line);
+}
+
+#endif /* APR_POOL_DEBUG */
+
+svn_error_t *
+svn_pool__profile_enable(void)
+{
+#if APR_POOL_DEBUG
+  SVN_ERR(svn_atomic__init_once(&profile_init_state, init_profile,
+                                NULL, NULL));
+  svn_atomic_set(&profile_enabled, TRUE);
+
+  return SVN_NO_ERROR;
+#else
+  return svn_error_create(SVN_ERR_UNSUPPORTED_FEATURE, NULL,
+                          _("Pool profiling requires APR pool debugging"));
+#endif
+}
+
+svn_boolean_t
+svn_pool__profile_enabled(void)
+{
+#if APR_POOL_DEBUG
+  return svn_atomic_read(&profile_enabled) != FALSE;
+#else
+  return FALSE;
+#endif
+}
+
+svn_error_t *
+svn_pool__profile_format(svn_stringbuf_t **text,
+                         apr_pool_t *result_pool,
+                         apr_pool_t *scratch_pool)
+{
+#if APR_POOL_DEBUG
+  apr_array_header_t *summaries;
+  int i;
+
+  if (!svn_pool__profile_enabled())
+    return svn_error_create(SVN_ERR_INCORRECT_PARAMS, NULL,
+                            _("Pool profiling has not been enabled"));
+
+  /* Take a snapshot under the lock and format it afterwards. */
+  summaries = apr_array_make(scratch_pool, apr_hash_count(profile_sites),
+                             sizeof(site_summary_t));
+  SVN_MUTEX__WITH_LOCK(profile_mutex, summarize_sites(summaries));
+  svn_sort__array(summaries, compare_summaries);
+
+  *text = svn_stringbuf_create_ensure(80 * (summaries->nelts + 1),
+                                      result_pool);
+  svn_stringbuf_appendcstr(*text,
+      "#   live-bytes   peak-bytes      total-bytes    created     live"
+      "  site\n");
+
+  for (i = 0; i < summaries->nelts; ++i)
+    {
+      const site_summary_t *summary
+        = &APR_ARRAY_IDX(summaries, i, site_summary_t);
+
+      svn_stringbuf_appendcstr(*text,
+          apr_psprintf(scratch_pool,
+                       "%14" APR_UINT64_T_FMT
+                       " %12" APR_SIZE_T_FMT
+                       " %16" APR_UINT64_T_FMT
+                       " %10" APR_UINT64_T_FMT
+                       " %8" APR_UINT64_T_FMT "  %s\n",
+                       summary->live_bytes, summary->peak_bytes,
+                       summary->total_bytes, summary->created,
+                       summary->live, summary->file_line));
+    }
+
+  return SVN_NO_ERROR;
+#else
+  return svn_error_trace(svn_pool__profile_enable());
+#endif
+}
+
+svn_error_t *
+svn_pool__profile_write(const char *path,
+                        apr_pool_t *scratch_pool)
+{
+  svn_stringbuf_t *text;
+
+  if (!svn_pool__profile_enabled())
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_pool__profile_format(&text, scratch_pool, scratch_pool));
+  SVN_ERR(svn_io_write_atomic2(path, text->data, text->len, NULL, FALSE,
+                               scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+void
+svn_pool__clear_debug(apr_pool_t *pool,
+                      const char *file_line)
+{
+#if APR_POOL_DEBUG
+  const char *site = NULL;
+
+  /* The tracker lives in POOL, so remember its site before clearing. */
+  if (svn_pool__profile_enabled())
+    {
+      void *tracker;
+      apr_pool_userdata_get(&tracker, PROFILE_TRACKER_KEY, pool);
+      if (tracker)
+        site = ((pool_tracker_t *)tracker)->site->file_line;
+    }
+
+  apr_pool_clear_debug(pool, file_line);
+
+  if (site)
+    track_pool(pool, site, FALSE);
+#else
+  apr_pool_clear(pool);
+#endif
+}
+
+
+/*-----------------------------------------------------------------*/
+
 #if APR_POOL_DEBUG
 #undef svn_pool_create_ex
 #endif /* APR_POOL_DEBUG */
@@ -97,6 +451,10 @@ svn_pool_create_ex_debug(apr_pool_t *parent_pool, apr_allocator_t *allocator,
   apr_pool_t *pool;
   apr_pool_create_ex_debug(&pool, parent_pool, abort_on_pool_failure,
                            allocator, file_line);
+
+  if (svn_pool__profile_enabled())
+    track_pool(pool, file_line, TRUE);
+
   return pool;
 }
 
@@ -21,6 +21,8 @@
  * ====================================================================
  */
 
+#include <apr_thread_proc.h>
+
 #include "svn_pools.h"
 
 #include "private/svn_subr_private.h"
@@ -36,8 +38,61 @@ struct svn_root_pools__t
   /* Mutex to serialize access to UNUSED_POOLS */
   svn_mutex__t *mutex;
 
+#if APR_HAS_THREADS
+  /* Per-thread cache holding at most one unused pool.  Worker threads that
+   * acquire and release pools repeatedly will usually get their previous
+   * pool back from here and never touch MUTEX.  May be NULL. */
+  apr_threadkey_t *thread_pool;
+#endif
 };
 
+#if APR_HAS_THREADS
+
+/* Thread exit handler for svn_root_pools__t.thread_pool.  Destroy the
+ * unused root pool DATA left behind by the thread. */
+static void
+thread_pool_destructor(void *data)
+{
+  if (data)
+    svn_pool_destroy(data);
+}
+
+/* Remove the unused pool cached for the current thread in POOLS and return
+ * it.  Return NULL if there is none. */
+static apr_pool_t *
+take_thread_pool(svn_root_pools__t *pools)
+{
+  void *data = NULL;
+
+  if (   pools->thread_pool == NULL
+      || apr_threadkey_private_get(&data, pools->thread_pool)
+      || data == NULL)
+    return NULL;
+
+  if (apr_threadkey_private_set(NULL, pools->thread_pool))
+    return NULL;
+
+  return data;
+}
+
+/* Try to cache the unused POOL for the current thread in POOLS.  Return
+ * TRUE upon success. */
+static svn_boolean_t
+put_thread_pool(svn_root_pools__t *pools,
+                apr_pool_t *pool)
+{
+  void *data = NULL;
+
+  if (   pools->thread_pool == NULL
+      || apr_threadkey_private_get(&data, pools->thread_pool)
+      || data != NULL)
+    return FALSE;
+
+  return apr_threadkey_private_set(pool, pools->thread_pool) == APR_SUCCESS;
+}
+
+#endif
+
 svn_error_t *
 svn_root_pools__create(svn_root_pools__t **pools)
 {
@@ -51,6 +106,13 @@ svn_root_pools__create(svn_root_pools__t **pools)
   SVN_ERR(svn_mutex__init(&result->mutex, TRUE, pool));
   result->unused_pools = apr_array_make(pool, 16, sizeof(apr_pool_t *));
 
+#if APR_HAS_THREADS
+  /* The per-thread cache is an optimization only. */
+  if (apr_threadkey_private_create(&result->thread_pool,
+                                   thread_pool_destructor, pool))
+    result->thread_pool = NULL;
+#endif
+
   /* done */
   *pools = result;
 
@@ -77,7 +139,15 @@ apr_pool_t *
 svn_root_pools__acquire_pool(svn_root_pools__t *pools)
 {
   apr_pool_t *pool;
-  svn_error_t *err = acquire_pool_internal(&pool, pools);
+  svn_error_t *err;
+
+#if APR_HAS_THREADS
+  pool = take_thread_pool(pools);
+  if (pool)
+    return pool;
+#endif
+
+  err = acquire_pool_internal(&pool, pools);
   if (err)
     {
       /* Mutex failure?!  Well, try to continue with unrecycled data. */
@@ -96,6 +166,11 @@ svn_root_pools__release_pool(apr_pool_t *pool,
 
   svn_pool_clear(pool);
 
+#if APR_HAS_THREADS
+  if (put_thread_pool(pools, pool))
+    return;
+#endif
+
   err = svn_mutex__lock(pools->mutex);
   if (err)
     {
@@ -0,0 +1,729 @@
+/*
+ * sha.c :  SHA-1 and SHA-256 routines with hardware acceleration
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include <string.h>
+#include <apr.h>
+
+#include "sha.h"
+#include "simd.h"
+
+/* Pick the hardware-accelerated block functions that this compiler can
+ * produce.  Whether the CPU actually supports them gets checked at
+ * runtime, see select_implementation().
+ */
+#if SVN_SIMD__X86
+#  define SVN_SHA_X86 1
+#  define SHA_X86_TARGET SVN_SIMD__TARGET("sha,sse4.1,ssse3")
+#  include <immintrin.h>
+#elif defined(__GNUC__) && defined(__aarch64__) \
+    && (defined(__ARM_FEATURE_CRYPTO) || defined(__ARM_FEATURE_SHA2))
+#  define SVN_SHA_ARM 1
+#  include <arm_neon.h>
+#  ifdef __linux__
+#    include <sys/auxv.h>
+#  endif
+#endif
+
+/* Process COUNT consecutive 64 byte blocks starting at DATA and update
+ * the hash STATE (5 words for SHA-1, 8 words for SHA-256) accordingly.
+ */
+typedef void (*blocks_func_t)(apr_uint32_t *state,
+                              const unsigned char *data,
+                              apr_size_t count);
+
+/* Size of the blocks that SHA-1 and SHA-256 process. */
+#define BLOCK_SIZE 64
+
+/* Rotate the 32 bit value X left by N bits. */
+#define ROTL32(x, n) (((x) << (n)) | ((x) >> (32 - (n))))
+#define ROTR32(x, n) (((x) >> (n)) | ((x) << (32 - (n))))
+
+/* Read the big-endian 32 bit value at DATA. */
+static APR_INLINE apr_uint32_t
+load_be32(const unsigned char *data)
+{
+  return ((apr_uint32_t)data[0] << 24)
+       | ((apr_uint32_t)data[1] << 16)
+       | ((apr_uint32_t)data[2] << 8)
+       |  (apr_uint32_t)data[3];
+}
+
+/* Write VALUE in big-endian byte order to DATA. */
+static APR_INLINE void
+store_be32(unsigned char *data, apr_uint32_t value)
+{
+  data[0] = (unsigned char)(value >> 24);
+  data[1] = (unsigned char)(value >> 16);
+  data[2] = (unsigned char)(value >> 8);
+  data[3] = (unsigned char)value;
+}
+
+/* SHA-256 round constants. */
+static const apr_uint32_t sha256_k[64] = {
+  0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5,
+  0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+  0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+  0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+  0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc,
+  0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+  0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7,
+  0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+  0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+  0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+  0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3,
+  0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+  0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5,
+  0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+  0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+  0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+
+/*** Portable implementations ***/
+
+/* Implements blocks_func_t for SHA-1 in plain C. */
+static void
+sha1_blocks_generic(apr_uint32_t *state,
+                    const unsigned char *data,
+                    apr_size_t count)
+{
+  for (; count; --count, data += BLOCK_SIZE)
+    {
+      apr_uint32_t w[80];
+      apr_uint32_t a = state[0];
+      apr_uint32_t b = state[1];
+      apr_uint32_t c = state[2];
+      apr_uint32_t d = state[3];
+      apr_uint32_t e = state[4];
+      int i;
+
+      for (i = 0; i < 16; ++i)
+        w[i] = load_be32(data + 4 * i);
+      for (; i < 80; ++i)
+        w[i] = ROTL32(w[i-3] ^ w[i-8] ^ w[i-14] ^ w[i-16], 1);
+
+      for (i = 0; i < 80; ++i)
+        {
+          apr_uint32_t f, k, temp;
+          if (i < 20)
+            {
+              f = (b & c) | (~b & d);
+              k = 0x5a827999;
+            }
+          else if (i < 40)
+            {
+              f = b ^ c ^ d;
+              k = 0x6ed9eba1;
+            }
+          else if (i < 60)
+            {
+              f = (b & c) | (b & d) | (c & d);
+              k = 0x8f1bbcdc;
+            }
+          else
+            {
+              f = b ^ c ^ d;
+              k = 0xca62c1d6;
+            }
+
+          temp = ROTL32(a, 5) + f + e + k + w[i];
+          e = d;
+          d = c;
+          c = ROTL32(b, 30);
+          b = a;
+          a = temp;
+        }
+
+      state[0] += a;
+      state[1] += b;
+      state[2] += c;
+      state[3] += d;
+      state[4] += e;
+    }
+}
+
+/* Implements blocks_func_t for SHA-256 in plain C. */
+static void
+sha256_blocks_generic(apr_uint32_t *state,
+                      const unsigned char *data,
+                      apr_size_t count)
+{
+  for (; count; --count, data += BLOCK_SIZE)
+    {
+      apr_uint32_t w[64];
+      apr_uint32_t a = state[0];
+      apr_uint32_t b = state[1];
+      apr_uint32_t c = state[2];
+      apr_uint32_t d = state[3];
+      apr_uint32_t e = state[4];
+      apr_uint32_t f = state[5];
+      apr_uint32_t g = state[6];
+      apr_uint32_t h = state[7];
+      int i;
+
+      for (i = 0; i < 16; ++i)
+        w[i] = load_be32(data + 4 * i);
+      for (; i < 64; ++i)
+        {
+          apr_uint32_t s0 = ROTR32(w[i-15], 7) ^ ROTR32(w[i-15], 18)
+                          ^ (w[i-15] >> 3);
+          apr_uint32_t s1 = ROTR32(w[i-2], 17) ^ ROTR32(w[i-2], 19)
+                          ^ (w[i-2] >> 10);
+          w[i] = w[i-16] + s0 + w[i-7] + s1;
+        }
+
+      for (i = 0; i < 64; ++i)
+        {
+          apr_uint32_t s1 = ROTR32(e, 6) ^ ROTR32(e, 11) ^ ROTR32(e, 25);
+          apr_uint32_t ch = (e & f) ^ (~e & g);
+          apr_uint32_t temp1 = h + s1 + ch + sha256_k[i] + w[i];
+          apr_uint32_t s0 = ROTR32(a, 2) ^ ROTR32(a, 13) ^ ROTR32(a, 22);
+          apr_uint32_t maj = (a & b) ^ (a & c) ^ (b & c);
+          apr_uint32_t temp2 = s0 + maj;
+
+          h = g;
+          g = f;
+          f = e;
+          e = d + temp1;
+          d = c;
+          c = b;
+          b = a;
+          a = temp1 + temp2;
+        }
+
+      state[0] += a;
+      state[1] += b;
+      state[2] += c;
+      state[3] += d;
+      state[4] += e;
+      state[5] += f;
+      state[6] += g;
+      state[7] += h;
+    }
+}
+
+
+#if SVN_SHA_X86
+
+/*** Intel SHA extensions (SHA-NI) ***/
+
+/* Return TRUE if the CPU supports the SHA extensions and the SSE levels
+ * that our block functions use as well. */
+static svn_boolean_t
+have_sha_ni(void)
+{
+  const apr_uint32_t required
+    = SVN_SIMD__SHA | SVN_SIMD__SSE4_1 | SVN_SIMD__SSSE3;
+
+  return (svn_simd__features() & required) == required;
+}
+
+/* Execute 5 groups of 4 SHA-1 rounds each, starting at group FIRST, using
+ * round function FUNC.  The local variables are those of
+ * sha1_blocks_sha_ni().
+ *
+ * The message schedule for group I>=4 is
+ *   W[I] = msg2(msg1(W[I-4], W[I-3]) ^ W[I-2], W[I-1])
+ * and kept in a ring buffer of 4 vectors.
+ */
+#define SHA1_NI_GROUPS(first, func)                                        \
+  for (i = (first); i < (first) + 5; ++i)                                  \
+    {                                                                      \
+      if (i < 4)                                                           \
+        msg[i] = _mm_shuffle_epi8(                                         \
+                   _mm_loadu_si128((const __m128i *)(data + 16 * i)),      \
+                   byte_mask);                                             \
+      else                                                                 \
+        msg[i & 3] = _mm_sha1msg2_epu32(                                   \
+                       _mm_xor_si128(_mm_sha1msg1_epu32(msg[i & 3],        \
+                                                        msg[(i+1) & 3]),   \
+                                     msg[(i+2) & 3]),                      \
+                       msg[(i+3) & 3]);                                    \
+                                                                           \
+      e1 = i ? _mm_sha1nexte_epu32(e0, msg[i & 3])                         \
+             : _mm_add_epi32(e0, msg[0]);                                  \
+      e0 = abcd;                                                           \
+      abcd = _mm_sha1rnds4_epu32(abcd, e1, func);                          \
+    }
+
+/* Implements blocks_func_t for SHA-1 using SHA-NI. */
+SHA_X86_TARGET
+static void
+sha1_blocks_sha_ni(apr_uint32_t *state,
+                   const unsigned char *data,
+                   apr_size_t count)
+{
+  /* Reverses the byte order within the whole vector, i.e. converts
+     to big-endian words in the reverse order that SHA-NI expects. */
+  const __m128i byte_mask = _mm_set_epi8(0, 1, 2, 3, 4, 5, 6, 7,
+                                         8, 9, 10, 11, 12, 13, 14, 15);
+  __m128i abcd, e0, e1, abcd_saved, e0_saved;
+  __m128i msg[4];
+  int i;
+
+  abcd = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *)state), 0x1b);
+  e0 = _mm_set_epi32((int)state[4], 0, 0, 0);
+
+  for (; count; --count, data += BLOCK_SIZE)
+    {
+      abcd_saved = abcd;
+      e0_saved = e0;
+
+      SHA1_NI_GROUPS(0, 0);
+      SHA1_NI_GROUPS(5, 1);
+      SHA1_NI_GROUPS(10, 2);
+      SHA1_NI_GROUPS(15, 3);
+
+      /* E0 holds the ABCD state before the last 4 rounds. */
+      e0 = _mm_sha1nexte_epu32(e0, e0_saved);
+      abcd = _mm_add_epi32(abcd, abcd_saved);
+    }
+
+  _mm_storeu_si128((__m128i *)state, _mm_shuffle_epi32(abcd, 0x1b));
+  state[4] = (apr_uint32_t)_mm_extract_epi32(e0, 3);
+}
+
+#undef SHA1_NI_GROUPS
+
+/* Implements blocks_func_t for SHA-256 using SHA-NI. */
+SHA_X86_TARGET
+static void
+sha256_blocks_sha_ni(apr_uint32_t *state,
+                     const unsigned char *data,
+                     apr_size_t count)
+{
+  /* Converts each 32 bit word to big-endian. */
+  const __m128i byte_mask = _mm_set_epi8(12, 13, 14, 15, 8, 9, 10, 11,
+                                         4, 5, 6, 7, 0, 1, 2, 3);
+  __m128i state0, state1, state0_saved, state1_saved, tmp;
+  __m128i msg[4];
+  int i;
+
+  /* SHA-NI wants the state as ABEF and CDGH. */
+  tmp = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *)&state[0]),
+                          0xb1);
+  state1 = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *)&state[4]),
+                             0x1b);
+  state0 = _mm_alignr_epi8(tmp, state1, 8);
+  state1 = _mm_blend_epi16(state1, tmp, 0xf0);
+
+  for (; count; --count, data += BLOCK_SIZE)
+    {
+      state0_saved = state0;
+      state1_saved = state1;
+
+      for (i = 0; i < 16; ++i)
+        {
+          /* W[I] = msg2(msg1(W[I-4], W[I-3]) + (W[I-1]:W[I-2] >> 32),
+                         W[I-1]) */
+          if (i < 4)
+            msg[i] = _mm_shuffle_epi8(
+                       _mm_loadu_si128((const __m128i *)(data + 16 * i)),
+                       byte_mask);
+          else
+            msg[i & 3] = _mm_sha256msg2_epu32(
+                           _mm_add_epi32(
+                             _mm_sha256msg1_epu32(msg[i & 3],
+                                                  msg[(i+1) & 3]),
+                             _mm_alignr_epi8(msg[(i+3) & 3],
+                                             msg[(i+2) & 3], 4)),
+                           msg[(i+3) & 3]);
+
+          tmp = _mm_add_epi32(msg[i & 3],
+                              _mm_loadu_si128((const __m128i *)
+                                              &sha256_k[4 * i]));
+          state1 = _mm_sha256rnds2_epu32(state1, state0, tmp);
+          tmp = _mm_shuffle_epi32(tmp, 0x0e);
+          state0 = _mm_sha256rnds2_epu32(state0, state1, tmp);
+        }
+
+      state0 = _mm_add_epi32(state0, state0_saved);
+      state1 = _mm_add_epi32(state1, state1_saved);
+    }
+
+  /* Back to ABCD and EFGH. */
+  tmp = _mm_shuffle_epi32(state0, 0x1b);
+  state1 = _mm_shuffle_epi32(state1, 0xb1);
+  _mm_storeu_si128((__m128i *)&state[0], _mm_blend_epi16(tmp, state1, 0xf0));
+  _mm_storeu_si128((__m128i *)&state[4], _mm_alignr_epi8(state1, tmp, 8));
+}
+
+#endif /* SVN_SHA_X86 */
+
+
+#if SVN_SHA_ARM
+
+/*** ARMv8 cryptography extensions ***/
+
+/* Return TRUE if the CPU supports the SHA-1 and SHA-256 instructions.
+ * Since the compiler was told to use the crypto extensions, assume that
+ * they are present where we can't check at runtime. */
+static svn_boolean_t
+have_arm_sha(void)
+{
+#if defined(__linux__) && defined(HWCAP_SHA1) && defined(HWCAP_SHA2)
+  unsigned long hwcap = getauxval(AT_HWCAP);
+  return (hwcap & HWCAP_SHA1) && (hwcap & HWCAP_SHA2);
+#else
+  return TRUE;
+#endif
+}
+
+/* Implements blocks_func_t for SHA-1 using ARMv8 crypto instructions. */
+static void
+sha1_blocks_arm(apr_uint32_t *state,
+                const unsigned char *data,
+                apr_size_t count)
+{
+  static const apr_uint32_t k[4]
+    = { 0x5a827999, 0x6ed9eba1, 0x8f1bbcdc, 0xca62c1d6 };
+
+  uint32x4_t abcd = vld1q_u32(state);
+  apr_uint32_t e0 = state[4];
+
+  for (; count; --count, data += BLOCK_SIZE)
+    {
+      uint32x4_t abcd_saved = abcd;
+      apr_uint32_t e0_saved = e0;
+      uint32x4_t msg[4];
+      int i;
+
+      for (i = 0; i < 20; ++i)
+        {
+          uint32x4_t tmp;
+          apr_uint32_t e1;
+
+          /* W[I] = su1(su0(W[I-4], W[I-3], W[I-2]), W[I-1]) */
+          if (i < 4)
+            msg[i] = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(data
+                                                              + 16 * i)));
+          else
+            msg[i & 3] = vsha1su1q_u32(vsha1su0q_u32(msg[i & 3],
+                                                     msg[(i+1) & 3],
+                                                     msg[(i+2) & 3]),
+                                       msg[(i+3) & 3]);
+
+          tmp = vaddq_u32(msg[i & 3], vdupq_n_u32(k[i / 5]));
+          e1 = vsha1h_u32(vgetq_lane_u32(abcd, 0));
+          if (i < 5)
+            abcd = vsha1cq_u32(abcd, e0, tmp);
+          else if (i >= 10 && i < 15)
+            abcd = vsha1mq_u32(abcd, e0, tmp);
+          else
+            abcd = vsha1pq_u32(abcd, e0, tmp);
+          e0 = e1;
+        }
+
+      abcd = vaddq_u32(abcd, abcd_saved);
+      e0 += e0_saved;
+    }
+
+  vst1q_u32(state, abcd);
+  state[4] = e0;
+}
+
+/* Implements blocks_func_t for SHA-256 using ARMv8 crypto instructions. */
+static void
+sha256_blocks_arm(apr_uint32_t *state,
+                  const unsigned char *data,
+                  apr_size_t count)
+{
+  uint32x4_t state0 = vld1q_u32(&state[0]);
+  uint32x4_t state1 = vld1q_u32(&state[4]);
+
+  for (; count; --count, data += BLOCK_SIZE)
+    {
+      uint32x4_t state0_saved = state0;
+      uint32x4_t state1_saved = state1;
+      uint32x4_t msg[4];
+      int i;
+
+      for (i = 0; i < 16; ++i)
+        {
+          uint32x4_t tmp, tmp2;
+
+          /* W[I] = su1(su0(W[I-4], W[I-3]), W[I-2], W[I-1]) */
+          if (i < 4)
+            msg[i] = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(data
+                                                              + 16 * i)));
+          else
+            msg[i & 3] = vsha256su1q_u32(vsha256su0q_u32(msg[i & 3],
+                                                         msg[(i+1) & 3]),
+                                         msg[(i+2) & 3],
+                                         msg[(i+3) & 3]);
+
+          tmp = vaddq_u32(msg[i & 3], vld1q_u32(&sha256_k[4 * i]));
+          tmp2 = state0;
+          state0 = vsha256hq_u32(state0, state1, tmp);
+          state1 = vsha256h2q_u32(state1, tmp2, tmp);
+        }
+
+      state0 = vaddq_u32(state0, state0_saved);
+      state1 = vaddq_u32(state1, state1_saved);
+    }
+
+  vst1q_u32(&state[0], state0);
+  vst1q_u32(&state[4], state1);
+}
+
+#endif /* SVN_SHA_ARM */
+
+
+/*** Runtime dispatch ***/
+
+/* The block functions to use and the name of that implementation. */
+typedef struct implementation_t
+{
+  blocks_func_t sha1_blocks;
+  blocks_func_t sha256_blocks;
+  const char *name;
+} implementation_t;
+
+static const implementation_t generic_implementation
+  = { sha1_blocks_generic, sha256_blocks_generic, "generic" };
+
+#if SVN_SHA_X86
+static const implementation_t sha_ni_implementation
+  = { sha1_blocks_sha_ni, sha256_blocks_sha_ni, "SHA-NI" };
+#endif
+
+#if SVN_SHA_ARM
+static const implementation_t arm_implementation
+  = { sha1_blocks_arm, sha256_blocks_arm, "ARMv8 crypto" };
+#endif
+
+/* The implementation selected for this CPU or NULL if not selected, yet.
+ * Concurrent initialization is harmless as all threads will select the
+ * same implementation. */
+static const implementation_t * volatile selected_implementation = NULL;
+
+/* Return the fastest implementation supported by this CPU. */
+static const implementation_t *
+select_implementation(void)
+{
+  const implementation_t *result = selected_implementation;
+  if (result)
+    return result;
+
+  result = &generic_implementation;
+#if SVN_SHA_X86
+  if (have_sha_ni())
+    result = &sha_ni_implementation;
+#elif SVN_SHA_ARM
+  if (have_arm_sha())
+    result = &arm_implementation;
+#endif
+
+  selected_implementation = result;
+  return result;
+}
+
+const char *
+svn_sha__implementation(void)
+{
+  return select_implementation()->name;
+}
+
+
+/*** Stream processing shared by SHA-1 and SHA-256 ***/
+
+/* Feed LEN bytes from DATA into the hash STATE using BLOCKS.  BUFFER holds
+ * partial blocks and *LENGTH is the total number of bytes processed so
+ * far; both will be updated.
+ */
+static void
+sha_update(apr_uint32_t *state,
+           unsigned char buffer[BLOCK_SIZE],
+           apr_uint64_t *length,
+           blocks_func_t blocks,
+           const void *data,
+           apr_size_t len)
+{
+  const unsigned char *input = data;
+  apr_size_t buffered = (apr_size_t)(*length % BLOCK_SIZE);
+
+  *length += len;
+
+  /* Complete a partial block from previous calls. */
+  if (buffered)
+    {
+      apr_size_t to_copy = BLOCK_SIZE - buffered;
+      if (to_copy > len)
+        {
+          memcpy(buffer + buffered, input, len);
+          return;
+        }
+
+      memcpy(buffer + buffered, input, to_copy);
+      blocks(state, buffer, 1);
+      input += to_copy;
+      len -= to_copy;
+    }
+
+  /* Process full blocks directly from the input. */
+  if (len >= BLOCK_SIZE)
+    {
+      blocks(state, input, len / BLOCK_SIZE);
+      input += len - len % BLOCK_SIZE;
+      len %= BLOCK_SIZE;
+    }
+
+  /* Keep the rest for later. */
+  if (len)
+    memcpy(buffer, input, len);
+}
+
+/* Apply the final padding to a copy of the hash STATE of STATE_WORDS
+ * words, given BUFFER and LENGTH as in sha_update, and write the
+ * resulting big-endian digest to DIGEST.
+ */
+static void
+sha_finalize(unsigned char *digest,
+             const apr_uint32_t *state,
+             int state_words,
+             const unsigned char buffer[BLOCK_SIZE],
+             apr_uint64_t length,
+             blocks_func_t blocks)
+{
+  apr_uint32_t final_state[8];
+  unsigned char tail[2 * BLOCK_SIZE];
+  apr_size_t buffered = (apr_size_t)(length % BLOCK_SIZE);
+  apr_size_t tail_len = buffered < BLOCK_SIZE - 8 ? BLOCK_SIZE
+                                                  : 2 * BLOCK_SIZE;
+  apr_uint64_t bits = length * 8;
+  int i;
+
+  memcpy(final_state, state, state_words * sizeof(*state));
+
+  memcpy(tail, buffer, buffered);
+  tail[buffered] = 0x80;
+  memset(tail + buffered + 1, 0, tail_len - buffered - 1 - 8);
+  store_be32(tail + tail_len - 8, (apr_uint32_t)(bits >> 32));
+  store_be32(tail + tail_len - 4, (apr_uint32_t)bits);
+
+  blocks(final_state, tail, tail_len / BLOCK_SIZE);
+
+  for (i = 0; i < state_words; ++i)
+    store_be32(digest + 4 * i, final_state[i]);
+}
+
+
+/*** SHA-1 ***/
+
+struct svn_sha1__context_t
+{
+  apr_uint32_t state[5];
+  apr_uint64_t length;
+  unsigned char buffer[BLOCK_SIZE];
+  blocks_func_t blocks;
+};
+
+svn_sha1__context_t *
+svn_sha1__context_create(apr_pool_t *pool)
+{
+  svn_sha1__context_t *context = apr_palloc(pool, sizeof(*context));
+  svn_sha1__context_reset(context);
+
+  return context;
+}
+
+void
+svn_sha1__context_reset(svn_sha1__context_t *context)
+{
+  context->state[0] = 0x67452301;
+  context->state[1] = 0xefcdab89;
+  context->state[2] = 0x98badcfe;
+  context->state[3] = 0x10325476;
+  context->state[4] = 0xc3d2e1f0;
+  context->length = 0;
+  context->blocks = select_implementation()->sha1_blocks;
+}
+
+void
+svn_sha1__update(svn_sha1__context_t *context,
+                 const void *data,
+                 apr_size_t len)
+{
+  sha_update(context->state, context->buffer, &context->length,
+             context->blocks, data, len);
+}
+
+void
+svn_sha1__finalize(unsigned char digest[SVN_SHA1__DIGESTSIZE],
+                   const svn_sha1__context_t *context)
+{
+  sha_finalize(digest, context->state, 5, context->buffer,
+               context->length, context->blocks);
+}
+
+
+/*** SHA-256 ***/
+
+struct svn_sha256__context_t
+{
+  apr_uint32_t state[8];
+  apr_uint64_t length;
+  unsigned char buffer[BLOCK_SIZE];
+  blocks_func_t blocks;
+};
+
+svn_sha256__context_t *
+svn_sha256__context_create(apr_pool_t *pool)
+{
+  svn_sha256__context_t *context = apr_palloc(pool, sizeof(*context));
+  svn_sha256__context_reset(context);
+
+  return context;
+}
+
+void
+svn_sha256__context_reset(svn_sha256__context_t *context)
+{
+  context->state[0] = 0x6a09e667;
+  context->state[1] = 0xbb67ae85;
+  context->state[2] = 0x3c6ef372;
+  context->state[3] = 0xa54ff53a;
+  context->state[4] = 0x510e527f;
+  context->state[5] = 0x9b05688c;
+  context->state[6] = 0x1f83d9ab;
+  context->state[7] = 0x5be0cd19;
+  context->length = 0;
+  context->blocks = select_implementation()->sha256_blocks;
+}
+
+void
+svn_sha256__update(svn_sha256__context_t *context,
+                   const void *data,
+                   apr_size_t len)
+{
+  sha_update(context->state, context->buffer, &context->length,
+             context->blocks, data, len);
+}
+
+void
+svn_sha256__finalize(unsigned char digest[SVN_SHA256__DIGESTSIZE],
+                     const svn_sha256__context_t *context)
+{
+  sha_finalize(digest, context->state, 8, context->buffer,
+               context->length, context->blocks);
+}
@@ -0,0 +1,107 @@
+/*
+ * sha.h :  SHA-1 and SHA-256 routines with hardware acceleration
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#ifndef SVN_LIBSVN_SUBR_SHA_H
+#define SVN_LIBSVN_SUBR_SHA_H
+
+#include <apr_pools.h>
+
+#include "svn_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/* Digest sizes in bytes. */
+#define SVN_SHA1__DIGESTSIZE 20
+#define SVN_SHA256__DIGESTSIZE 32
+
+/* Opaque SHA-1 checksum creation context type.
+ */
+typedef struct svn_sha1__context_t svn_sha1__context_t;
+
+/* Return a new SHA-1 checksum creation context allocated in POOL.
+ */
+svn_sha1__context_t *
+svn_sha1__context_create(apr_pool_t *pool);
+
+/* Reset the SHA-1 checksum CONTEXT to initial state.
+ */
+void
+svn_sha1__context_reset(svn_sha1__context_t *context);
+
+/* Feed LEN bytes from DATA into the SHA-1 checksum creation CONTEXT.
+ */
+void
+svn_sha1__update(svn_sha1__context_t *context,
+                 const void *data,
+                 apr_size_t len);
+
+/* Write the SHA-1 checksum over all data fed into CONTEXT to DIGEST.
+ * CONTEXT itself remains unchanged.
+ */
+void
+svn_sha1__finalize(unsigned char digest[SVN_SHA1__DIGESTSIZE],
+                   const svn_sha1__context_t *context);
+
+
+/* Opaque SHA-256 checksum creation context type.
+ */
+typedef struct svn_sha256__context_t svn_sha256__context_t;
+
+/* Return a new SHA-256 checksum creation context allocated in POOL.
+ */
+svn_sha256__context_t *
+svn_sha256__context_create(apr_pool_t *pool);
+
+/* Reset the SHA-256 checksum CONTEXT to initial state.
+ */
+void
+svn_sha256__context_reset(svn_sha256__context_t *context);
+
+/* Feed LEN bytes from DATA into the SHA-256 checksum creation CONTEXT.
+ */
+void
+svn_sha256__update(svn_sha256__context_t *context,
+                   const void *data,
+                   apr_size_t len);
+
+/* Write the SHA-256 checksum over all data fed into CONTEXT to DIGEST.
+ * CONTEXT itself remains unchanged.
+ */
+void
+svn_sha256__finalize(unsigned char digest[SVN_SHA256__DIGESTSIZE],
+                     const svn_sha256__context_t *context);
+
+
+/* Return a short description of the SHA implementation selected for the
+ * current CPU, e.g. "SHA-NI", "ARMv8 crypto" or "generic".
+ */
+const char *
+svn_sha__implementation(void);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* SVN_LIBSVN_SUBR_SHA_H */
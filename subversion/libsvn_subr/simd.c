@@ -0,0 +1,133 @@
+/*
+ * simd.c :  runtime detection of SIMD instruction set extensions
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include "simd.h"
+
+#if SVN_SIMD__X86
+#  ifdef _MSC_VER
+#    include <intrin.h>
+#    include <immintrin.h>
+#  else
+#    include <cpuid.h>
+#  endif
+#endif
+
+#if SVN_SIMD__X86
+
+/* Store the EAX, EBX, ECX and EDX values returned by the CPUID function
+ * LEAF, sub-leaf 0, in REGS. */
+static void
+cpuid(apr_uint32_t regs[4], unsigned leaf)
+{
+#ifdef _MSC_VER
+  int info[4];
+  __cpuidex(info, (int)leaf, 0);
+  regs[0] = (apr_uint32_t)info[0];
+  regs[1] = (apr_uint32_t)info[1];
+  regs[2] = (apr_uint32_t)info[2];
+  regs[3] = (apr_uint32_t)info[3];
+#else
+  unsigned int eax, ebx, ecx, edx;
+  __cpuid_count(leaf, 0, eax, ebx, ecx, edx);
+  regs[0] = eax;
+  regs[1] = ebx;
+  regs[2] = ecx;
+  regs[3] = edx;
+#endif
+}
+
+/* Return TRUE if the OS saves and restores the full YMM registers. */
+static svn_boolean_t
+os_supports_avx(void)
+{
+#ifdef _MSC_VER
+  return (_xgetbv(0) & 6) == 6;
+#else
+  unsigned int eax, edx;
+  __asm__ __volatile__("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+  return (eax & 6) == 6;
+#endif
+}
+
+/* Query the CPU for the features that we are interested in. */
+static apr_uint32_t
+detect_features(void)
+{
+  apr_uint32_t regs[4];
+  apr_uint32_t max_leaf;
+  apr_uint32_t result = 0;
+  svn_boolean_t avx = FALSE;
+
+  cpuid(regs, 0);
+  max_leaf = regs[0];
+  if (max_leaf < 1)
+    return 0;
+
+  cpuid(regs, 1);
+  if (regs[2] & (1 << 9))
+    result |= SVN_SIMD__SSSE3;
+  if (regs[2] & (1 << 19))
+    result |= SVN_SIMD__SSE4_1;
+
+  /* AVX is only usable if the OS enabled it (OSXSAVE + XCR0). */
+  if ((regs[2] & (1 << 27)) && (regs[2] & (1 << 28)))
+    avx = os_supports_avx();
+
+  if (max_leaf >= 7)
+    {
+      cpuid(regs, 7);
+      if (avx && (regs[1] & (1 << 5)))
+        result |= SVN_SIMD__AVX2;
+      if (regs[1] & (1 << 29))
+        result |= SVN_SIMD__SHA;
+    }
+
+  return result;
+}
+
+#endif /* SVN_SIMD__X86 */
+
+/* Marker bit telling that DETECTED_FEATURES has been initialized. */
+#define FEATURES_DETECTED 0x80000000
+
+/* The SVN_SIMD__* flags plus FEATURES_DETECTED or 0 if not detected, yet.
+ * Concurrent initialization is harmless as all threads will come to the
+ * same result. */
+static volatile apr_uint32_t detected_features = 0;
+
+apr_uint32_t
+svn_simd__features(void)
+{
+  apr_uint32_t result = detected_features;
+  if (result)
+    return result & ~FEATURES_DETECTED;
+
+#if SVN_SIMD__X86
+  result = detect_features();
+#else
+  result = 0;
+#endif
+
+  detected_features = result | FEATURES_DETECTED;
+  return result;
+}
@@ -0,0 +1,67 @@
+/*
+ * simd.h :  runtime detection of SIMD instruction set extensions
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+
+#ifndef SVN_LIBSVN_SUBR_SIMD_H
+#define SVN_LIBSVN_SUBR_SIMD_H
+
+#include <apr.h>
+
+#include "svn_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/* Pick the x86 instruction set extensions that this compiler can produce
+ * code for on a per-function basis.  Code using them must be guarded by
+ * SVN_SIMD__X86 and check svn_simd__features() at runtime.
+ */
+#if (defined(__GNUC__) && (__GNUC__ >= 5 || defined(__clang__))) \
+    && (defined(__x86_64__) || defined(__i386__))
+#  define SVN_SIMD__X86 1
+#  define SVN_SIMD__TARGET(isa) __attribute__((target(isa)))
+#elif defined(_MSC_VER) && (_MSC_VER >= 1900) \
+    && (defined(_M_X64) || defined(_M_IX86))
+#  define SVN_SIMD__X86 1
+#  define SVN_SIMD__TARGET(isa)
+#endif
+
+/* Flags returned by svn_simd__features(). */
+#define SVN_SIMD__SSSE3   0x0001
+#define SVN_SIMD__SSE4_1  0x0002
+#define SVN_SIMD__AVX2    0x0004
+#define SVN_SIMD__SHA     0x0008
+
+/* Return the set of SVN_SIMD__* flags for the instruction set extensions
+ * supported by the current CPU and enabled by the OS.  The result will
+ * be 0 on platforms other than x86 and x64.
+ */
+apr_uint32_t
+svn_simd__features(void);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* SVN_LIBSVN_SUBR_SIMD_H */
@@ -27,6 +27,7 @@
 #include "svn_pools.h"
 
 #include "private/svn_subr_private.h"
+#include "private/svn_io_private.h"
 
 
 struct memblock_t {
@@ -671,6 +672,53 @@ read_handler_spillbuf(void *baton, char *buffer, apr_size_t *len)
 }
 
 
+/* Implements svn_stream__borrow_fn_t.  Hand out the saved content or
+   the current spillbuf block directly. */
+static svn_error_t *
+borrow_handler_spillbuf(void *baton, const char **data, apr_size_t *len)
+{
+  struct spillbuf_baton *sb = baton;
+  svn_spillbuf_reader_t *reader = sb->reader;
+
+  if (reader->save_len > 0)
+    {
+      if (*len > reader->save_len)
+        *len = reader->save_len;
+
+      *data = reader->save_ptr + reader->save_pos;
+      reader->save_pos += *len;
+      reader->save_len -= *len;
+
+      return SVN_NO_ERROR;
+    }
+
+  if (reader->sb_len == 0)
+    {
+      SVN_ERR(svn_spillbuf__read(&reader->sb_ptr, &reader->sb_len,
+                                 reader->buf, sb->scratch_pool));
+      svn_pool_clear(sb->scratch_pool);
+
+      if (reader->sb_ptr == NULL)
+        {
+          reader->sb_len = 0;
+          *data = "";
+          *len = 0;
+
+          return SVN_NO_ERROR;
+        }
+    }
+
+  if (*len > reader->sb_len)
+    *len = reader->sb_len;
+
+  *data = reader->sb_ptr;
+  reader->sb_ptr += *len;
+  reader->sb_len -= *len;
+
+  return SVN_NO_ERROR;
+}
+
+
 static svn_error_t *
 write_handler_spillbuf(void *baton, const char *data, apr_size_t *len)
 {
@@ -700,6 +748,7 @@ svn_stream__from_spillbuf(svn_spillbuf_t *buf,
   svn_stream_set_read2(stream, NULL /* only full read support */,
                        read_handler_spillbuf);
   svn_stream_set_write(stream, write_handler_spillbuf);
+  svn_stream__set_borrow(stream, borrow_handler_spillbuf);
 
   return stream;
 }
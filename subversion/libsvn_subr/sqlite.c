@@ -142,6 +142,10 @@ struct svn_sqlite__db_t
   svn_sqlite__stmt_t **prepared_stmts;
   apr_pool_t *state_pool;
 
+  /* Set while svn_sqlite__begin_read_snapshot() keeps a read transaction
+     open.  Transactions then nest as savepoints. */
+  svn_boolean_t in_read_snapshot;
+
 #ifdef SVN_UNICODE_NORMALIZATION_FIXES
   /* Buffers for SQLite extensoins. */
   svn_membuf_t sqlext_buf1;
@@ -217,6 +221,10 @@ struct svn_sqlite__value_t
 /* Time (in milliseconds) to wait for sqlite locks before giving up. */
 #define BUSY_TIMEOUT 10000
 
+/* Bytes of a database opened read-only that SQLite may memory map (256 MB).
+   This must be a plain number as it gets pasted into a pragma. */
+#define READONLY_MMAP_SIZE 268435456
+
 
 /* Convenience wrapper around exec_sql2(). */
 #define exec_sql(db, sql) exec_sql2((db), (sql), SQLITE_OK)
@@ -781,6 +789,48 @@ svn_sqlite__read_schema_version(int *version,
 }
 
 
+/* Set *WAL to TRUE if DB uses write-ahead logging.  Use SCRATCH_POOL for
+   temporary allocations. */
+static svn_error_t *
+get_wal_mode(svn_boolean_t *wal,
+             svn_sqlite__db_t *db,
+             apr_pool_t *scratch_pool)
+{
+  svn_sqlite__stmt_t *stmt;
+  svn_error_t *err;
+
+  SVN_ERR(prepare_statement(&stmt, db, "PRAGMA journal_mode;", scratch_pool));
+  err = svn_sqlite__step_row(stmt);
+  if (!err)
+    *wal = strcmp(svn_sqlite__column_text(stmt, 0, NULL), "wal") == 0;
+
+  return svn_error_compose_create(err, svn_sqlite__finalize(stmt));
+}
+
+svn_error_t *
+svn_sqlite__set_wal_mode(svn_sqlite__db_t *db,
+                         svn_boolean_t enable,
+                         apr_pool_t *scratch_pool)
+{
+  svn_boolean_t wal;
+
+  SVN_ERR(get_wal_mode(&wal, db, scratch_pool));
+  if (wal == enable)
+    return SVN_NO_ERROR;
+
+  /* Don't let checkpoints leave a large WAL file behind. */
+  if (enable)
+    return svn_error_trace(exec_sql(db,
+                                    "PRAGMA journal_mode = WAL;"
+                                    "PRAGMA journal_size_limit = 4194304;"));
+
+  /* Leaving WAL mode fails while others are using the database.  We will
+     simply try again the next time. */
+  return svn_error_trace(exec_sql2(db, "PRAGMA journal_mode = TRUNCATE;",
+                                   SQLITE_BUSY));
+}
+
+
 static volatile svn_atomic_t sqlite_init_state = 0;
 
 /* If possible, verify that SQLite was compiled in a thread-safe
@@ -831,7 +881,15 @@ internal_open(svn_sqlite__db_t *db, const char *path, svn_sqlite__mode_t mode,
     int flags;
 
     if (mode == svn_sqlite__mode_readonly)
-      flags = SQLITE_OPEN_READONLY;
+      {
+        flags = SQLITE_OPEN_READONLY;
+
+        /* Readers should neither see nor disturb other connections'
+           cache state. */
+#ifdef SQLITE_OPEN_PRIVATECACHE
+        flags |= SQLITE_OPEN_PRIVATECACHE;
+#endif
+      }
     else if (mode == svn_sqlite__mode_readwrite)
       flags = SQLITE_OPEN_READWRITE;
     else if (mode == svn_sqlite__mode_rwcreate)
@@ -1164,11 +1222,20 @@ svn_sqlite__open(svn_sqlite__db_t **db, const char *path,
                  affects application(read: Subversion) performance/behavior. */
               "PRAGMA foreign_keys=OFF;"      /* SQLITE_DEFAULT_FOREIGN_KEYS*/
               "PRAGMA locking_mode = NORMAL;" /* SQLITE_DEFAULT_LOCKING_MODE */
-              /* Testing shows TRUNCATE is faster than DELETE on Windows. */
-              "PRAGMA journal_mode = TRUNCATE;"
               ),
                 *db);
 
+  /* Testing shows TRUNCATE is faster than DELETE on Windows.  Databases
+     switched to WAL by svn_sqlite__set_wal_mode() stay in that mode. */
+  {
+    svn_boolean_t wal;
+
+    SVN_SQLITE__ERR_CLOSE(get_wal_mode(&wal, *db, scratch_pool), *db);
+    if (!wal)
+      SVN_SQLITE__ERR_CLOSE(exec_sql(*db, "PRAGMA journal_mode = TRUNCATE;"),
+                            *db);
+  }
+
 #if defined(SVN_DEBUG)
   /* When running in debug mode, enable the checking of foreign key
      constraints.  This has possible performance implications, so we don't
@@ -1191,6 +1258,15 @@ svn_sqlite__open(svn_sqlite__db_t **db, const char *path,
      setting SQLITE_TEMP_STORE to 0 (always to disk) */
   svn_error_clear(exec_sql(*db, "PRAGMA temp_store = MEMORY;"));
 
+  /* Read-only connections may memory map the database file, sparing a
+     copy of every page read into SQLite's page cache.  Writers keep the
+     default because a mapping interacts badly with I/O errors during
+     writes.  Older SQLite versions simply ignore this pragma. */
+  if (mode == svn_sqlite__mode_readonly)
+    svn_error_clear(exec_sql(*db, "PRAGMA mmap_size = "
+                                  APR_STRINGIFY(READONLY_MMAP_SIZE)
+                                  ";"));
+
   /* Store the provided statements. */
   if (statements)
     {
@@ -1307,6 +1383,9 @@ svn_sqlite__begin_transaction(svn_sqlite__db_t *db)
 {
   svn_sqlite__stmt_t *stmt;
 
+  if (db->in_read_snapshot)
+    return svn_error_trace(svn_sqlite__begin_savepoint(db));
+
   SVN_ERR(get_internal_statement(&stmt, db,
                                  STMT_INTERNAL_BEGIN_TRANSACTION));
   SVN_ERR(svn_sqlite__step_done(stmt));
@@ -1318,6 +1397,10 @@ svn_sqlite__begin_immediate_transaction(svn_sqlite__db_t *db)
 {
   svn_sqlite__stmt_t *stmt;
 
+  /* Any write will fail with SVN_ERR_SQLITE_READONLY soon enough. */
+  if (db->in_read_snapshot)
+    return svn_error_trace(svn_sqlite__begin_savepoint(db));
+
   SVN_ERR(get_internal_statement(&stmt, db,
                                  STMT_INTERNAL_BEGIN_IMMEDIATE_TRANSACTION));
   SVN_ERR(svn_sqlite__step_done(stmt));
@@ -1335,12 +1418,43 @@ svn_sqlite__begin_savepoint(svn_sqlite__db_t *db)
   return SVN_NO_ERROR;
 }
 
+svn_error_t *
+svn_sqlite__begin_read_snapshot(svn_sqlite__db_t *db)
+{
+  SVN_ERR_ASSERT(!db->in_read_snapshot);
+
+  /* A deferred transaction only takes its SHARED lock with the first
+     read; do that read right away so that the snapshot starts now. */
+  SVN_ERR(exec_sql(db, "BEGIN DEFERRED TRANSACTION;"
+                       "SELECT count(*) FROM sqlite_master;"));
+  db->in_read_snapshot = TRUE;
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_sqlite__end_read_snapshot(svn_sqlite__db_t *db,
+                              svn_error_t *err)
+{
+  SVN_ERR_ASSERT(db->in_read_snapshot);
+  db->in_read_snapshot = FALSE;
+
+  /* Ending the read transaction requires all statements to be reset. */
+  err = reset_all_statements(db, err);
+
+  return svn_error_compose_create(err,
+                                  exec_sql(db, "COMMIT TRANSACTION;"));
+}
+
 svn_error_t *
 svn_sqlite__finish_transaction(svn_sqlite__db_t *db,
                                svn_error_t *err)
 {
   svn_sqlite__stmt_t *stmt;
 
+  if (db->in_read_snapshot)
+    return svn_error_trace(svn_sqlite__finish_savepoint(db, err));
+
   /* Commit or rollback the sqlite transaction. */
   if (err)
     {
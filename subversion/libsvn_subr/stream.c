@@ -62,6 +62,7 @@ struct svn_stream_t {
   svn_stream_seek_fn_t seek_fn;
   svn_stream_data_available_fn_t data_available_fn;
   svn_stream_readline_fn_t readline_fn;
+  svn_stream__borrow_fn_t borrow_fn;
   apr_file_t *file; /* Maybe NULL */
 };
 
@@ -145,6 +146,13 @@ svn_stream_set_readline(svn_stream_t *stream,
   stream->readline_fn = readline_fn;
 }
 
+void
+svn_stream__set_borrow(svn_stream_t *stream,
+                       svn_stream__borrow_fn_t borrow_fn)
+{
+  stream->borrow_fn = borrow_fn;
+}
+
 /* Standard implementation for svn_stream_read_full() based on
    multiple svn_stream_read2() calls (in separate function to make
    it more likely for svn_stream_read_full to be inlined) */
@@ -241,6 +249,23 @@ svn_stream_supports_reset(svn_stream_t *stream)
   return stream->seek_fn != NULL;
 }
 
+svn_boolean_t
+svn_stream__supports_borrow(svn_stream_t *stream)
+{
+  return stream->borrow_fn != NULL;
+}
+
+svn_error_t *
+svn_stream__borrow(svn_stream_t *stream,
+                   const char **data,
+                   apr_size_t *len)
+{
+  if (stream->borrow_fn == NULL)
+    return svn_error_create(SVN_ERR_STREAM_NOT_SUPPORTED, NULL, NULL);
+
+  return svn_error_trace(stream->borrow_fn(stream->baton, data, len));
+}
+
 svn_error_t *
 svn_stream_mark(svn_stream_t *stream, svn_stream_mark_t **mark,
                 apr_pool_t *pool)
@@ -397,18 +422,53 @@ svn_stream_readline(svn_stream_t *stream,
   return SVN_NO_ERROR;
 }
 
+/* Implement svn_stream_copy3 for a FROM stream that supports borrowing
+ * without closing any of the streams. */
+static svn_error_t *
+copy_borrowed(svn_stream_t *from,
+              svn_stream_t *to,
+              svn_cancel_func_t cancel_func,
+              void *cancel_baton)
+{
+  while (1)
+    {
+      const char *data;
+      apr_size_t len = SVN__STREAM_CHUNK_SIZE;
+
+      if (cancel_func)
+        SVN_ERR(cancel_func(cancel_baton));
+
+      SVN_ERR(svn_stream__borrow(from, &data, &len));
+      if (len == 0)
+        return SVN_NO_ERROR;
+
+      SVN_ERR(svn_stream_write(to, data, &len));
+    }
+}
+
 svn_error_t *svn_stream_copy3(svn_stream_t *from, svn_stream_t *to,
                               svn_cancel_func_t cancel_func,
                               void *cancel_baton,
                               apr_pool_t *scratch_pool)
 {
-  char *buf = apr_palloc(scratch_pool, SVN__STREAM_CHUNK_SIZE);
+  char *buf;
   svn_error_t *err;
   svn_error_t *err2;
 
+  /* Pass the source's own buffers on to TO if possible. */
+  if (svn_stream__supports_borrow(from))
+    {
+      err = copy_borrowed(from, to, cancel_func, cancel_baton);
+      err2 = svn_error_compose_create(svn_stream_close(from),
+                                      svn_stream_close(to));
+
+      return svn_error_compose_create(err, err2);
+    }
+
   /* Read and write chunks until we get a short read, indicating the
      end of the stream.  (We can't get a short write without an
      associated error.) */
+  buf = apr_palloc(scratch_pool, SVN__STREAM_CHUNK_SIZE);
   while (1)
     {
       apr_size_t len = SVN__STREAM_CHUNK_SIZE;
@@ -643,6 +703,12 @@ data_available_disown(void *baton, svn_boolean_t *data_available)
   return svn_error_trace(svn_stream_data_available(baton, data_available));
 }
 
+static svn_error_t *
+borrow_handler_disown(void *baton, const char **data, apr_size_t *len)
+{
+  return svn_error_trace(svn_stream__borrow(baton, data, len));
+}
+
 static svn_error_t *
 readline_handler_disown(void *baton,
                         svn_stringbuf_t **stringbuf,
@@ -666,6 +732,8 @@ svn_stream_disown(svn_stream_t *stream, apr_pool_t *pool)
   svn_stream_set_seek(s, seek_handler_disown);
   svn_stream_set_data_available(s, data_available_disown);
   svn_stream_set_readline(s, readline_handler_disown);
+  if (svn_stream__supports_borrow(stream))
+    svn_stream__set_borrow(s, borrow_handler_disown);
 
   return s;
 }
@@ -1363,9 +1431,17 @@ svn_stream_compressed(svn_stream_t *stream, apr_pool_t *pool)
 
 struct checksum_stream_baton
 {
-  svn_checksum_ctx_t *read_ctx, *write_ctx;
-  svn_checksum_t **read_checksum;  /* Output value. */
-  svn_checksum_t **write_checksum;  /* Output value. */
+  svn_checksum__multi_ctx_t *read_ctx, *write_ctx;
+  svn_checksum_t **read_md5_checksum;  /* Output value. */
+  svn_checksum_t **read_sha1_checksum;  /* Output value. */
+  svn_checksum_t **write_md5_checksum;  /* Output value. */
+  svn_checksum_t **write_sha1_checksum;  /* Output value. */
+
+  /* Output values for checksums of other kinds than MD5 or SHA-1. */
+  svn_checksum_kind_t other_kind;
+  svn_checksum_t **read_other_checksum;
+  svn_checksum_t **write_other_checksum;
+
   svn_stream_t *proxy;
 
   /* True if more data should be read when closing the stream. */
@@ -1382,8 +1458,8 @@ read_handler_checksum(void *baton, char *buffer, apr_size_t *len)
 
   SVN_ERR(svn_stream_read2(btn->proxy, buffer, len));
 
-  if (btn->read_checksum)
-    SVN_ERR(svn_checksum_update(btn->read_ctx, buffer, *len));
+  if (btn->read_ctx)
+    SVN_ERR(svn_checksum__multi_update(btn->read_ctx, buffer, *len));
 
   return SVN_NO_ERROR;
 }
@@ -1396,8 +1472,8 @@ read_full_handler_checksum(void *baton, char *buffer, apr_size_t *len)
 
   SVN_ERR(svn_stream_read_full(btn->proxy, buffer, len));
 
-  if (btn->read_checksum)
-    SVN_ERR(svn_checksum_update(btn->read_ctx, buffer, *len));
+  if (btn->read_ctx)
+    SVN_ERR(svn_checksum__multi_update(btn->read_ctx, buffer, *len));
 
   if (saved_len != *len)
     btn->read_more = FALSE;
@@ -1405,14 +1481,30 @@ read_full_handler_checksum(void *baton, char *buffer, apr_size_t *len)
   return SVN_NO_ERROR;
 }
 
+static svn_error_t *
+borrow_handler_checksum(void *baton, const char **data, apr_size_t *len)
+{
+  struct checksum_stream_baton *btn = baton;
+
+  SVN_ERR(svn_stream__borrow(btn->proxy, data, len));
+
+  if (btn->read_ctx)
+    SVN_ERR(svn_checksum__multi_update(btn->read_ctx, *data, *len));
+
+  if (*len == 0)
+    btn->read_more = FALSE;
+
+  return SVN_NO_ERROR;
+}
+
 
 static svn_error_t *
 write_handler_checksum(void *baton, const char *buffer, apr_size_t *len)
 {
   struct checksum_stream_baton *btn = baton;
 
-  if (btn->write_checksum && *len > 0)
-    SVN_ERR(svn_checksum_update(btn->write_ctx, buffer, *len));
+  if (btn->write_ctx && *len > 0)
+    SVN_ERR(svn_checksum__multi_update(btn->write_ctx, buffer, *len));
 
   return svn_error_trace(svn_stream_write(btn->proxy, buffer, len));
 }
@@ -1426,6 +1518,20 @@ data_available_handler_checksum(void *baton, svn_boolean_t *data_available)
                                                    data_available));
 }
 
+/* Store the checksum of KIND from CTX in *CHECKSUM, if CHECKSUM is not
+ * NULL.  Allocate the result in POOL. */
+static svn_error_t *
+final_checksum(svn_checksum_t **checksum,
+               const svn_checksum__multi_ctx_t *ctx,
+               svn_checksum_kind_t kind,
+               apr_pool_t *pool)
+{
+  if (checksum)
+    SVN_ERR(svn_checksum__multi_final(checksum, ctx, kind, pool));
+
+  return SVN_NO_ERROR;
+}
+
 static svn_error_t *
 close_handler_checksum(void *baton)
 {
@@ -1446,10 +1552,24 @@ close_handler_checksum(void *baton)
     }
 
   if (btn->read_ctx)
-    SVN_ERR(svn_checksum_final(btn->read_checksum, btn->read_ctx, btn->pool));
+    {
+      SVN_ERR(final_checksum(btn->read_md5_checksum, btn->read_ctx,
+                             svn_checksum_md5, btn->pool));
+      SVN_ERR(final_checksum(btn->read_sha1_checksum, btn->read_ctx,
+                             svn_checksum_sha1, btn->pool));
+      SVN_ERR(final_checksum(btn->read_other_checksum, btn->read_ctx,
+                             btn->other_kind, btn->pool));
+    }
 
   if (btn->write_ctx)
-    SVN_ERR(svn_checksum_final(btn->write_checksum, btn->write_ctx, btn->pool));
+    {
+      SVN_ERR(final_checksum(btn->write_md5_checksum, btn->write_ctx,
+                             svn_checksum_md5, btn->pool));
+      SVN_ERR(final_checksum(btn->write_sha1_checksum, btn->write_ctx,
+                             svn_checksum_sha1, btn->pool));
+      SVN_ERR(final_checksum(btn->write_other_checksum, btn->write_ctx,
+                             btn->other_kind, btn->pool));
+    }
 
   return svn_error_trace(svn_stream_close(btn->proxy));
 }
@@ -1468,10 +1588,10 @@ seek_handler_checksum(void *baton, const svn_stream_mark_t *mark)
   else
     {
       if (btn->read_ctx)
-        SVN_ERR(svn_checksum_ctx_reset(btn->read_ctx));
+        SVN_ERR(svn_checksum__multi_ctx_reset(btn->read_ctx));
 
       if (btn->write_ctx)
-        SVN_ERR(svn_checksum_ctx_reset(btn->write_ctx));
+        SVN_ERR(svn_checksum__multi_ctx_reset(btn->write_ctx));
 
       SVN_ERR(svn_stream_reset(btn->proxy));
     }
@@ -1479,34 +1599,60 @@ seek_handler_checksum(void *baton, const svn_stream_mark_t *mark)
   return SVN_NO_ERROR;
 }
 
+/* Return the mask of checksum kinds to calculate for the non-NULL
+ * checksum output pointers MD5, SHA1 and OTHER (of kind OTHER_KIND). */
+static unsigned
+checksum_kinds(svn_checksum_t **md5,
+               svn_checksum_t **sha1,
+               svn_checksum_t **other,
+               svn_checksum_kind_t other_kind)
+{
+  return (md5 ? SVN_CHECKSUM__KIND_FLAG(svn_checksum_md5) : 0)
+       | (sha1 ? SVN_CHECKSUM__KIND_FLAG(svn_checksum_sha1) : 0)
+       | (other ? SVN_CHECKSUM__KIND_FLAG(other_kind) : 0);
+}
 
-svn_stream_t *
-svn_stream_checksummed2(svn_stream_t *stream,
-                        svn_checksum_t **read_checksum,
-                        svn_checksum_t **write_checksum,
-                        svn_checksum_kind_t checksum_kind,
-                        svn_boolean_t read_all,
-                        apr_pool_t *pool)
+/* Common implementation of svn_stream_checksummed2 and
+ * svn_stream__checksummed_md5_sha1.  Checksums of OTHER_KIND will be
+ * returned in *READ_OTHER and *WRITE_OTHER; OTHER_KIND must be
+ * neither MD5 nor SHA-1 if those pointers are not NULL. */
+static svn_stream_t *
+checksummed_stream(svn_stream_t *stream,
+                   svn_checksum_t **read_md5,
+                   svn_checksum_t **read_sha1,
+                   svn_checksum_t **read_other,
+                   svn_checksum_t **write_md5,
+                   svn_checksum_t **write_sha1,
+                   svn_checksum_t **write_other,
+                   svn_checksum_kind_t other_kind,
+                   svn_boolean_t read_all,
+                   apr_pool_t *pool)
 {
   svn_stream_t *s;
   struct checksum_stream_baton *baton;
+  unsigned read_kinds = checksum_kinds(read_md5, read_sha1, read_other,
+                                       other_kind);
+  unsigned write_kinds = checksum_kinds(write_md5, write_sha1, write_other,
+                                        other_kind);
 
-  if (read_checksum == NULL && write_checksum == NULL)
+  if (read_kinds == 0 && write_kinds == 0)
     return stream;
 
   baton = apr_palloc(pool, sizeof(*baton));
-  if (read_checksum)
-    baton->read_ctx = svn_checksum_ctx_create(checksum_kind, pool);
-  else
-    baton->read_ctx = NULL;
-
-  if (write_checksum)
-    baton->write_ctx = svn_checksum_ctx_create(checksum_kind, pool);
-  else
-    baton->write_ctx = NULL;
-
-  baton->read_checksum = read_checksum;
-  baton->write_checksum = write_checksum;
+  baton->read_ctx = read_kinds
+                  ? svn_checksum__multi_ctx_create(read_kinds, pool)
+                  : NULL;
+  baton->write_ctx = write_kinds
+                   ? svn_checksum__multi_ctx_create(write_kinds, pool)
+                   : NULL;
+
+  baton->read_md5_checksum = read_md5;
+  baton->read_sha1_checksum = read_sha1;
+  baton->read_other_checksum = read_other;
+  baton->write_md5_checksum = write_md5;
+  baton->write_sha1_checksum = write_sha1;
+  baton->write_other_checksum = write_other;
+  baton->other_kind = other_kind;
   baton->proxy = stream;
   baton->read_more = read_all;
   baton->pool = pool;
@@ -1518,9 +1664,52 @@ svn_stream_checksummed2(svn_stream_t *stream,
   svn_stream_set_close(s, close_handler_checksum);
   if (svn_stream_supports_reset(stream))
     svn_stream_set_seek(s, seek_handler_checksum);
+  if (svn_stream__supports_borrow(stream))
+    svn_stream__set_borrow(s, borrow_handler_checksum);
   return s;
 }
 
+svn_stream_t *
+svn_stream_checksummed2(svn_stream_t *stream,
+                        svn_checksum_t **read_checksum,
+                        svn_checksum_t **write_checksum,
+                        svn_checksum_kind_t checksum_kind,
+                        svn_boolean_t read_all,
+                        apr_pool_t *pool)
+{
+  switch (checksum_kind)
+    {
+      case svn_checksum_md5:
+        return checksummed_stream(stream, read_checksum, NULL, NULL,
+                                  write_checksum, NULL, NULL,
+                                  checksum_kind, read_all, pool);
+
+      case svn_checksum_sha1:
+        return checksummed_stream(stream, NULL, read_checksum, NULL,
+                                  NULL, write_checksum, NULL,
+                                  checksum_kind, read_all, pool);
+
+      default:
+        return checksummed_stream(stream, NULL, NULL, read_checksum,
+                                  NULL, NULL, write_checksum,
+                                  checksum_kind, read_all, pool);
+    }
+}
+
+svn_stream_t *
+svn_stream__checksummed_md5_sha1(svn_stream_t *stream,
+                                 svn_checksum_t **read_md5_checksum,
+                                 svn_checksum_t **read_sha1_checksum,
+                                 svn_checksum_t **write_md5_checksum,
+                                 svn_checksum_t **write_sha1_checksum,
+                                 svn_boolean_t read_all,
+                                 apr_pool_t *pool)
+{
+  return checksummed_stream(stream, read_md5_checksum, read_sha1_checksum,
+                            NULL, write_md5_checksum, write_sha1_checksum,
+                            NULL, svn_checksum_fnv1a_32x4, read_all, pool);
+}
+
 /* Helper for svn_stream_contents_checksum() to compute checksum of
  * KIND of STREAM. This function doesn't close source stream. */
 static svn_error_t *
@@ -1531,8 +1720,26 @@ compute_stream_checksum(svn_checksum_t **checksum,
                         apr_pool_t *scratch_pool)
 {
   svn_checksum_ctx_t *ctx = svn_checksum_ctx_create(kind, scratch_pool);
-  char *buf = apr_palloc(scratch_pool, SVN__STREAM_CHUNK_SIZE);
+  char *buf;
+
+  /* Checksum the source's own buffers if possible. */
+  if (svn_stream__supports_borrow(stream))
+    {
+      const char *data;
+      apr_size_t len;
+
+      do
+        {
+          len = SVN__STREAM_CHUNK_SIZE;
+          SVN_ERR(svn_stream__borrow(stream, &data, &len));
+          SVN_ERR(svn_checksum_update(ctx, data, len));
+        }
+      while (len > 0);
 
+      return svn_error_trace(svn_checksum_final(checksum, ctx, result_pool));
+    }
+
+  buf = apr_palloc(scratch_pool, SVN__STREAM_CHUNK_SIZE);
   while (1)
     {
       apr_size_t len = SVN__STREAM_CHUNK_SIZE;
@@ -1633,6 +1840,18 @@ read_handler_stringbuf(void *baton, char *buffer, apr_size_t *len)
   return SVN_NO_ERROR;
 }
 
+static svn_error_t *
+borrow_handler_stringbuf(void *baton, const char **data, apr_size_t *len)
+{
+  struct stringbuf_stream_baton *btn = baton;
+  apr_size_t left_to_read = btn->str->len - btn->amt_read;
+
+  *len = (*len > left_to_read) ? left_to_read : *len;
+  *data = btn->str->data + btn->amt_read;
+  btn->amt_read += *len;
+  return SVN_NO_ERROR;
+}
+
 static svn_error_t *
 skip_handler_stringbuf(void *baton, apr_size_t len)
 {
@@ -1746,6 +1965,7 @@ svn_stream_from_stringbuf(svn_stringbuf_t *str,
   svn_stream_set_seek(stream, seek_handler_stringbuf);
   svn_stream_set_data_available(stream, data_available_handler_stringbuf);
   svn_stream_set_readline(stream, readline_handler_stringbuf);
+  svn_stream__set_borrow(stream, borrow_handler_stringbuf);
   return stream;
 }
 
@@ -1772,6 +1992,18 @@ read_handler_string(void *baton, char *buffer, apr_size_t *len)
   return SVN_NO_ERROR;
 }
 
+static svn_error_t *
+borrow_handler_string(void *baton, const char **data, apr_size_t *len)
+{
+  struct string_stream_baton *btn = baton;
+  apr_size_t left_to_read = btn->str->len - btn->amt_read;
+
+  *len = (*len > left_to_read) ? left_to_read : *len;
+  *data = btn->str->data + btn->amt_read;
+  btn->amt_read += *len;
+  return SVN_NO_ERROR;
+}
+
 static svn_error_t *
 mark_handler_string(void *baton, svn_stream_mark_t **mark, apr_pool_t *pool)
 {
@@ -1875,6 +2107,7 @@ svn_stream_from_string(const svn_string_t *str,
   svn_stream_set_skip(stream, skip_handler_string);
   svn_stream_set_data_available(stream, data_available_handler_string);
   svn_stream_set_readline(stream, readline_handler_string);
+  svn_stream__set_borrow(stream, borrow_handler_string);
   return stream;
 }
 
@@ -37,6 +37,19 @@
 
 #include "svn_private_config.h"
 
+/* Use 16 byte vector compares in svn_cstring__match_length and
+ * svn_cstring__reverse_match_length where the target guarantees them.
+ * SSE2 is part of the x86-64 base ISA and NEON is mandatory on AArch64,
+ * so no runtime detection is required. */
+#if defined(__GNUC__) && defined(__SSE2__)
+#  define SVN_MATCH_LENGTH_SSE2 1
+#  include <emmintrin.h>
+#elif defined(__GNUC__) && defined(__ARM_NEON) && defined(__aarch64__) \
+   && defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+#  define SVN_MATCH_LENGTH_NEON 1
+#  include <arm_neon.h>
+#endif
+
 
 
 /* Allocate the space for a memory buffer from POOL.
@@ -1508,6 +1521,38 @@ svn_cstring__match_length(const char *a,
 {
   apr_size_t pos = 0;
 
+#if SVN_MATCH_LENGTH_SSE2
+
+  /* Compare 16 bytes at a time.  The mask has one bit per byte with
+   * bit 0 corresponding to the first byte. */
+  for (; max_len - pos >= 16; pos += 16)
+    {
+      __m128i lhs = _mm_loadu_si128((const __m128i *)(a + pos));
+      __m128i rhs = _mm_loadu_si128((const __m128i *)(b + pos));
+      unsigned mask = _mm_movemask_epi8(_mm_cmpeq_epi8(lhs, rhs));
+
+      if (mask != 0xffff)
+        return pos + __builtin_ctz(~mask);
+    }
+
+#elif SVN_MATCH_LENGTH_NEON
+
+  /* Compare 16 bytes at a time.  Matching bytes become 0xff in EQ. */
+  for (; max_len - pos >= 16; pos += 16)
+    {
+      uint8x16_t eq = vceqq_u8(vld1q_u8((const uint8_t *)(a + pos)),
+                               vld1q_u8((const uint8_t *)(b + pos)));
+      uint64_t lo = ~vgetq_lane_u64(vreinterpretq_u64_u8(eq), 0);
+      uint64_t hi = ~vgetq_lane_u64(vreinterpretq_u64_u8(eq), 1);
+
+      if (lo)
+        return pos + __builtin_ctzll(lo) / 8;
+      if (hi)
+        return pos + 8 + __builtin_ctzll(hi) / 8;
+    }
+
+#endif
+
 #if SVN_UNALIGNED_ACCESS_IS_OK
 
   /* Chunky processing is so much faster ...
@@ -1536,6 +1581,38 @@ svn_cstring__reverse_match_length(const char *a,
 {
   apr_size_t pos = 0;
 
+#if SVN_MATCH_LENGTH_SSE2
+
+  /* Compare 16 bytes at a time, going backwards.  Bit 15 of the mask
+   * corresponds to the byte closest to A and B. */
+  for (; max_len - pos >= 16; pos += 16)
+    {
+      __m128i lhs = _mm_loadu_si128((const __m128i *)(a - pos - 16));
+      __m128i rhs = _mm_loadu_si128((const __m128i *)(b - pos - 16));
+      unsigned mask = _mm_movemask_epi8(_mm_cmpeq_epi8(lhs, rhs));
+
+      if (mask != 0xffff)
+        return pos + __builtin_clz(~mask << 16);
+    }
+
+#elif SVN_MATCH_LENGTH_NEON
+
+  /* Compare 16 bytes at a time, going backwards. */
+  for (; max_len - pos >= 16; pos += 16)
+    {
+      uint8x16_t eq = vceqq_u8(vld1q_u8((const uint8_t *)(a - pos - 16)),
+                               vld1q_u8((const uint8_t *)(b - pos - 16)));
+      uint64_t lo = ~vgetq_lane_u64(vreinterpretq_u64_u8(eq), 0);
+      uint64_t hi = ~vgetq_lane_u64(vreinterpretq_u64_u8(eq), 1);
+
+      if (hi)
+        return pos + __builtin_clzll(hi) / 8;
+      if (lo)
+        return pos + 8 + __builtin_clzll(lo) / 8;
+    }
+
+#endif
+
 #if SVN_UNALIGNED_ACCESS_IS_OK
 
   /* Chunky processing is so much faster ...
@@ -1544,7 +1621,7 @@ svn_cstring__reverse_match_length(const char *a,
    * because A and B will probably have different alignment. So, skipping
    * the first few chars until alignment is reached is not an option.
    */
-  for (pos = sizeof(apr_size_t); pos <= max_len; pos += sizeof(apr_size_t))
+  for (pos += sizeof(apr_size_t); pos <= max_len; pos += sizeof(apr_size_t))
     if (*(const apr_size_t*)(a - pos) != *(const apr_size_t*)(b - pos))
       break;
 
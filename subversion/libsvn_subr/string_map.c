@@ -0,0 +1,275 @@
+/*
+ * string_map.c :  implement a compact, open-addressing string map
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include <string.h>
+#include <apr_strings.h>
+
+#include "svn_hash.h"
+#include "private/svn_subr_private.h"
+
+/* Minimum number of entries to allocate.
+ */
+#define MIN_CAPACITY 8
+
+/* A key / value pair.  Removed entries have a NULL VALUE.
+ */
+typedef struct entry_t
+{
+  /* The key, allocated in the map's pool, and its length. */
+  const char *key;
+  apr_size_t len;
+
+  /* Hash value of KEY.  Stored to avoid re-hashing while growing. */
+  apr_uint32_t hash;
+
+  /* The value.  NULL for removed entries. */
+  void *value;
+} entry_t;
+
+/* The ENTRIES are stored in insertion order.  SLOTS is the actual hash
+ * table and uses linear probing.  Each used slot contains the index of an
+ * entry + 1, i.e. 0 marks an empty slot.
+ *
+ * SLOTS has twice as many elements as ENTRIES can hold, keeping the load
+ * factor at or below 50%.  Removed entries keep their slots;  they get
+ * only dropped when the ENTRIES array is full and gets compacted.
+ */
+struct svn_string_map__t
+{
+  /* Dense array of ENTRY_COUNT used elements out of CAPACITY. */
+  entry_t *entries;
+  apr_size_t entry_count;
+  apr_size_t capacity;
+
+  /* The hash table with MASK + 1 elements, a power of two. */
+  apr_uint32_t *slots;
+  apr_size_t mask;
+
+  /* Number of entries with a non-NULL value. */
+  apr_size_t count;
+
+  /* Allocate everything in here. */
+  apr_pool_t *pool;
+};
+
+/* Return the hash value for the LEN bytes long KEY.
+ */
+static apr_uint32_t
+hash_key(const char *key,
+         apr_size_t len)
+{
+  return svn__fnv1a_32x4(key, len);
+}
+
+/* Return the slot in MAP that either refers to the entry for the LEN bytes
+ * long KEY with the given HASH, or the empty slot where it should go.
+ */
+static apr_uint32_t *
+find_slot(const svn_string_map__t *map,
+          const char *key,
+          apr_size_t len,
+          apr_uint32_t hash)
+{
+  apr_size_t i = hash & map->mask;
+
+  while (map->slots[i])
+    {
+      const entry_t *entry = &map->entries[map->slots[i] - 1];
+      if (   entry->hash == hash
+          && entry->len == len
+          && memcmp(entry->key, key, len) == 0)
+        break;
+
+      i = (i + 1) & map->mask;
+    }
+
+  return &map->slots[i];
+}
+
+/* Allocate slots for MAP's current capacity and link all entries to them.
+ */
+static void
+rebuild_slots(svn_string_map__t *map)
+{
+  apr_size_t i;
+
+  map->mask = 2 * map->capacity - 1;
+  map->slots = apr_pcalloc(map->pool, (map->mask + 1) * sizeof(*map->slots));
+
+  for (i = 0; i < map->entry_count; ++i)
+    {
+      apr_size_t k = map->entries[i].hash & map->mask;
+      while (map->slots[k])
+        k = (k + 1) & map->mask;
+
+      map->slots[k] = (apr_uint32_t)(i + 1);
+    }
+}
+
+/* Make room for at least one more entry in MAP.
+ */
+static void
+grow(svn_string_map__t *map)
+{
+  /* Mostly removed entries?  Then just drop them. */
+  if (map->count < map->entry_count / 2)
+    {
+      apr_size_t i, k;
+      for (i = 0, k = 0; i < map->entry_count; ++i)
+        if (map->entries[i].value)
+          map->entries[k++] = map->entries[i];
+
+      map->entry_count = k;
+    }
+  else
+    {
+      entry_t *entries = apr_palloc(map->pool,
+                                    2 * map->capacity * sizeof(*entries));
+      memcpy(entries, map->entries, map->entry_count * sizeof(*entries));
+
+      map->entries = entries;
+      map->capacity *= 2;
+    }
+
+  rebuild_slots(map);
+}
+
+svn_string_map__t *
+svn_string_map__create(apr_size_t capacity,
+                       apr_pool_t *pool)
+{
+  svn_string_map__t *map = apr_pcalloc(pool, sizeof(*map));
+
+  map->capacity = MIN_CAPACITY;
+  while (map->capacity < capacity)
+    map->capacity *= 2;
+
+  map->pool = pool;
+  map->entries = apr_palloc(pool, map->capacity * sizeof(*map->entries));
+  rebuild_slots(map);
+
+  return map;
+}
+
+void *
+svn_string_map__get(const svn_string_map__t *map,
+                    const char *key,
+                    apr_size_t len)
+{
+  apr_uint32_t slot = *find_slot(map, key, len, hash_key(key, len));
+
+  return slot ? map->entries[slot - 1].value : NULL;
+}
+
+void
+svn_string_map__set(svn_string_map__t *map,
+                    const char *key,
+                    apr_size_t len,
+                    void *value)
+{
+  apr_uint32_t hash = hash_key(key, len);
+  apr_uint32_t *slot = find_slot(map, key, len, hash);
+  entry_t *entry;
+
+  /* Existing entries, removed or not, simply update their value. */
+  if (*slot)
+    {
+      entry = &map->entries[*slot - 1];
+      if (entry->value && !value)
+        --map->count;
+      else if (!entry->value && value)
+        ++map->count;
+
+      entry->value = value;
+      return;
+    }
+
+  /* Removing a non-existent key is a no-op. */
+  if (!value)
+    return;
+
+  if (map->entry_count == map->capacity)
+    {
+      grow(map);
+      slot = find_slot(map, key, len, hash);
+    }
+
+  entry = &map->entries[map->entry_count];
+  entry->key = apr_pstrmemdup(map->pool, key, len);
+  entry->len = len;
+  entry->hash = hash;
+  entry->value = value;
+
+  *slot = (apr_uint32_t)++map->entry_count;
+  ++map->count;
+}
+
+apr_size_t
+svn_string_map__count(const svn_string_map__t *map)
+{
+  return map->count;
+}
+
+svn_boolean_t
+svn_string_map__next(apr_size_t *idx,
+                     const char **key,
+                     apr_size_t *len,
+                     void **value,
+                     const svn_string_map__t *map)
+{
+  for (; *idx < map->entry_count; ++*idx)
+    {
+      const entry_t *entry = &map->entries[*idx];
+      if (entry->value)
+        {
+          if (key)
+            *key = entry->key;
+          if (len)
+            *len = entry->len;
+          if (value)
+            *value = entry->value;
+
+          ++*idx;
+          return TRUE;
+        }
+    }
+
+  return FALSE;
+}
+
+apr_hash_t *
+svn_string_map__to_hash(const svn_string_map__t *map,
+                        apr_pool_t *result_pool)
+{
+  apr_hash_t *hash = svn_hash__make(result_pool);
+  apr_size_t i;
+
+  for (i = 0; i < map->entry_count; ++i)
+    {
+      const entry_t *entry = &map->entries[i];
+      if (entry->value)
+        apr_hash_set(hash, entry->key, entry->len, entry->value);
+    }
+
+  return hash;
+}
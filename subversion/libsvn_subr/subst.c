@@ -51,6 +51,7 @@
 
 #include "private/svn_string_private.h"
 #include "private/svn_eol_private.h"
+#include "private/svn_subst_private.h"
 
 /**
  * The textual elements of a detranslated special file.  One of these
@@ -981,6 +982,118 @@ eol_unchanged(struct translation_baton *b,
 }
 
 
+/* Return TRUE if BUF of size LEN contains a byte that translating it to
+ * EOL_STR with KEYWORDS might change.  Either of them may be NULL.  LFs
+ * will not be reported if EOL_STR is "\n" and *HAS_LF will then be set
+ * to TRUE if there is at least one in BUF.
+ *
+ * The search uses memchr() and svn_eol__find_eol_start(), both of which
+ * are vectorized, rather than looking at the bytes one by one.
+ */
+static svn_boolean_t
+has_special_bytes(svn_boolean_t *has_lf,
+                  const char *buf,
+                  apr_size_t len,
+                  const char *eol_str,
+                  apr_hash_t *keywords)
+{
+  *has_lf = FALSE;
+
+  if (keywords && memchr(buf, '$', len))
+    return TRUE;
+
+  if (!eol_str)
+    return FALSE;
+
+  /* LF-terminated lines are unambiguous and need no translation to LF.
+   * For other EOL styles, just look for the absence of any EOL. */
+  if (eol_str[0] == '\n' && eol_str[1] == '\0')
+    {
+      if (memchr(buf, '\r', len))
+        return TRUE;
+
+      *has_lf = memchr(buf, '\n', len) != NULL;
+      return FALSE;
+    }
+
+  return svn_eol__find_eol_start((char *)buf, len) != NULL;
+}
+
+/* Return TRUE if translate_chunk() may pass BUF of size BUFLEN through
+ * as-is, given the state in baton B.  Update B as though BUF had been
+ * translated in that case.
+ */
+static svn_boolean_t
+pass_through_chunk(struct translation_baton *b,
+                   const char *buf,
+                   apr_size_t buflen)
+{
+  svn_boolean_t has_lf;
+
+  /* Partial EOLs or keywords from the previous chunk must be completed
+   * the normal way. */
+  if (b->newline_off || b->keyword_off)
+    return FALSE;
+
+  if (has_special_bytes(&has_lf, buf, buflen, b->eol_str, b->keywords))
+    return FALSE;
+
+  /* Unless repairing, the LFs must be consistent with earlier EOLs. */
+  if (has_lf)
+    {
+      if (b->src_format_len == 0)
+        {
+          b->src_format[0] = '\n';
+          b->src_format_len = 1;
+        }
+      else if (!b->repair
+               && (b->src_format_len != 1 || b->src_format[0] != '\n'))
+        return FALSE;
+    }
+
+  return TRUE;
+}
+
+svn_error_t *
+svn_subst__translation_is_noop(svn_boolean_t *noop,
+                               svn_stream_t *stream,
+                               const char *eol_str,
+                               apr_hash_t *keywords,
+                               apr_pool_t *scratch_pool)
+{
+  svn_boolean_t borrow = svn_stream__supports_borrow(stream);
+  char *buffer = borrow ? NULL
+                        : apr_palloc(scratch_pool, SVN__STREAM_CHUNK_SIZE);
+  apr_size_t len;
+
+  /* For efficiency, convert an empty set of keywords to NULL. */
+  if (keywords && (apr_hash_count(keywords) == 0))
+    keywords = NULL;
+
+  do
+    {
+      const char *data = buffer;
+      svn_boolean_t has_lf;
+
+      len = SVN__STREAM_CHUNK_SIZE;
+      if (borrow)
+        SVN_ERR(svn_stream__borrow(stream, &data, &len));
+      else
+        SVN_ERR(svn_stream_read_full(stream, buffer, &len));
+
+      /* LF-only content is consistent, so we may ignore HAS_LF. */
+      if (has_special_bytes(&has_lf, data, len, eol_str, keywords))
+        {
+          *noop = FALSE;
+          return SVN_NO_ERROR;
+        }
+    }
+  while (len == SVN__STREAM_CHUNK_SIZE || (borrow && len > 0));
+
+  *noop = TRUE;
+  return SVN_NO_ERROR;
+}
+
 /* Translate eols and keywords of a 'chunk' of characters BUF of size BUFLEN
  * according to the settings and state stored in baton B.
  *
@@ -1011,6 +1124,10 @@ translate_chunk(svn_stream_t *dst,
       const char *interesting = b->interesting;
       apr_size_t next_sign_off = 0;
 
+      /* Most chunks of most files need no translation at all. */
+      if (pass_through_chunk(b, buf, buflen))
+        return svn_error_trace(translate_write(dst, buf, buflen));
+
       /* At the beginning of this loop, assume that we might be in an
        * interesting state, i.e. with data in the newline or keyword
        * buffer.  First try to get to the boring state so we can copy
@@ -1125,24 +1242,17 @@ translate_chunk(svn_stream_t *dst,
 
               if (b->keywords)
                 {
-                  /* Check 4 bytes at once to allow for efficient pipelining
-                    and to reduce loop condition overhead. */
-                  while ((end - p) >= (len + 4))
-                    {
-                      if (interesting[(unsigned char)p[len]]
-                          || interesting[(unsigned char)p[len+1]]
-                          || interesting[(unsigned char)p[len+2]]
-                          || interesting[(unsigned char)p[len+3]])
-                        break;
-
-                      len += 4;
-                    }
-
-                  /* Found an interesting char or EOF in the next 4 bytes.
-                     Find its exact position. */
-                  while ((p + len) < end
-                         && !interesting[(unsigned char)p[len]])
-                    ++len;
+                  /* Find the next EOL or '$', whatever comes first.
+                     Without EOL translation, only '$' is interesting. */
+                  const char *start = p + len;
+                  const char *next
+                    = b->eol_str
+                    ? svn_eol__find_eol_or_keyword_start((char *)start,
+                                                         end - start)
+                    : memchr(start, '$', end - start);
+
+                  /* NEXT will be NULL if there is nothing interesting */
+                  len += (next ? next : end) - start;
                 }
               else
                 {
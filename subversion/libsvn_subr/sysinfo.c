@@ -129,6 +129,7 @@ svn_sysinfo__linked_libs(apr_pool_t *pool)
   svn_version_ext_linked_lib_t *lib;
   apr_array_header_t *array = apr_array_make(pool, 7, sizeof(*lib));
   int lz4_version = svn_lz4__runtime_version();
+  int zstd_version = svn_zstd__runtime_version();
 
   lib = &APR_ARRAY_PUSH(array, svn_version_ext_linked_lib_t);
   lib->name = "APR";
@@ -177,6 +178,18 @@ svn_sysinfo__linked_libs(apr_pool_t *pool)
                                       (lz4_version / 100) % 100,
                                       lz4_version % 100);
 
+  if (svn_zstd__compiled_version())
+    {
+      lib = &APR_ARRAY_PUSH(array, svn_version_ext_linked_lib_t);
+      lib->name = "Zstandard";
+      lib->compiled_version = apr_pstrdup(pool,
+                                          svn_zstd__compiled_version());
+      lib->runtime_version = apr_psprintf(pool, "%d.%d.%d",
+                                          zstd_version / 100 / 100,
+                                          (zstd_version / 100) % 100,
+                                          zstd_version % 100);
+    }
+
   return array;
 }
 
@@ -0,0 +1,442 @@
+/* tar.c : writing tar archives
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include <string.h>
+
+#include "svn_pools.h"
+#include "svn_sorts.h"
+#include "svn_string.h"
+#include "svn_subst.h"
+
+#include "private/svn_string_private.h"
+#include "private/svn_subr_private.h"
+#include "private/svn_tar.h"
+
+#include "svn_private_config.h"
+
+
+
+/* Archives consist of blocks of this size. */
+#define TAR_BLOCK_SIZE 512
+
+/* Offsets and sizes of the ustar header fields. */
+#define NAME_OFFSET       0
+#define NAME_SIZE         100
+#define MODE_OFFSET       100
+#define UID_OFFSET        108
+#define GID_OFFSET        116
+#define ID_SIZE           8
+#define SIZE_OFFSET       124
+#define SIZE_SIZE         12
+#define MTIME_OFFSET      136
+#define MTIME_SIZE        12
+#define CHKSUM_OFFSET     148
+#define CHKSUM_SIZE       8
+#define TYPEFLAG_OFFSET   156
+#define LINKNAME_OFFSET   157
+#define LINKNAME_SIZE     100
+#define MAGIC_OFFSET      257
+#define VERSION_OFFSET    263
+#define DEVMAJOR_OFFSET   329
+#define DEVMINOR_OFFSET   337
+
+/* Entry types. */
+#define TYPE_FILE         '0'
+#define TYPE_SYMLINK      '2'
+#define TYPE_DIRECTORY    '5'
+#define TYPE_PAX_HEADER   'x'
+
+/* Contents of unknown size get buffered in memory up to this size and
+   in a temporary file beyond that. */
+#define SPILL_SIZE        (1024 * 1024)
+
+struct svn_tar__writer_t
+{
+  /* Where the archive goes. */
+  svn_stream_t *output;
+
+  /* Set once the end-of-archive marker has been written. */
+  svn_boolean_t finished;
+};
+
+svn_tar__writer_t *
+svn_tar__writer_create(svn_stream_t *output,
+                       apr_pool_t *result_pool)
+{
+  svn_tar__writer_t *writer = apr_pcalloc(result_pool, sizeof(*writer));
+  writer->output = output;
+
+  return writer;
+}
+
+/* Return TRUE if VALUE can be written as octal number into a header field
+   of FIELD_SIZE bytes, which includes the terminating NUL. */
+static svn_boolean_t
+fits_octal(apr_uint64_t value,
+           apr_size_t field_size)
+{
+  return value < ((apr_uint64_t)1 << (3 * (field_size - 1)));
+}
+
+/* Write VALUE as zero-padded, NUL-terminated octal number into the
+   FIELD_SIZE bytes at FIELD. */
+static void
+put_octal(char *field,
+          apr_size_t field_size,
+          apr_uint64_t value)
+{
+  apr_size_t i = field_size - 1;
+
+  field[i] = '\0';
+  while (i > 0)
+    {
+      field[--i] = (char)('0' + (value & 7));
+      value >>= 3;
+    }
+}
+
+/* Copy up to FIELD_SIZE bytes of the string VALUE into FIELD. */
+static void
+put_string(char *field,
+           apr_size_t field_size,
+           const char *value)
+{
+  apr_size_t len = strlen(value);
+  memcpy(field, value, MIN(len, field_size));
+}
+
+/* Append the pax extended header record KEY=VALUE to BUFFER. */
+static void
+append_pax_record(svn_stringbuf_t *buffer,
+                  const char *key,
+                  const char *value)
+{
+  /* The record starts with its own length, including that number. */
+  apr_size_t len = strlen(key) + strlen(value) + 3;
+  apr_size_t total = len + 1;
+  char digits[SVN_INT64_BUFFER_SIZE];
+
+  while (svn__ui64toa(digits, total) + len != total)
+    total = svn__ui64toa(digits, total) + len;
+
+  svn_stringbuf_appendcstr(buffer, digits);
+  svn_stringbuf_appendbyte(buffer, ' ');
+  svn_stringbuf_appendcstr(buffer, key);
+  svn_stringbuf_appendbyte(buffer, '=');
+  svn_stringbuf_appendcstr(buffer, value);
+  svn_stringbuf_appendbyte(buffer, '\n');
+}
+
+/* Write the zero bytes that fill up the last block of an entry with SIZE
+   bytes of contents to WRITER. */
+static svn_error_t *
+write_padding(svn_tar__writer_t *writer,
+              svn_filesize_t size)
+{
+  static const char zeros[TAR_BLOCK_SIZE] = { 0 };
+  apr_size_t len = (apr_size_t)((TAR_BLOCK_SIZE - size % TAR_BLOCK_SIZE)
+                                % TAR_BLOCK_SIZE);
+
+  if (len)
+    SVN_ERR(svn_stream_write(writer->output, zeros, &len));
+
+  return SVN_NO_ERROR;
+}
+
+/* Write a single ustar header block for NAME of TYPEFLAG with MODE, SIZE,
+   MTIME and LINKNAME to WRITER.  Values that don't fit get truncated. */
+static svn_error_t *
+write_ustar_header(svn_tar__writer_t *writer,
+                   const char *name,
+                   char typeflag,
+                   int mode,
+                   svn_filesize_t size,
+                   apr_time_t mtime,
+                   const char *linkname)
+{
+  char header[TAR_BLOCK_SIZE] = { 0 };
+  apr_int64_t seconds = apr_time_sec(mtime);
+  apr_uint32_t checksum = 0;
+  apr_size_t len = sizeof(header);
+  apr_size_t i;
+
+  if (seconds < 0 || !fits_octal(seconds, MTIME_SIZE))
+    seconds = 0;
+  if (size < 0 || !fits_octal(size, SIZE_SIZE))
+    size = 0;
+
+  put_string(header + NAME_OFFSET, NAME_SIZE, name);
+  put_octal(header + MODE_OFFSET, ID_SIZE, mode);
+  put_octal(header + UID_OFFSET, ID_SIZE, 0);
+  put_octal(header + GID_OFFSET, ID_SIZE, 0);
+  put_octal(header + SIZE_OFFSET, SIZE_SIZE, size);
+  put_octal(header + MTIME_OFFSET, MTIME_SIZE, seconds);
+  header[TYPEFLAG_OFFSET] = typeflag;
+  put_string(header + LINKNAME_OFFSET, LINKNAME_SIZE, linkname);
+  memcpy(header + MAGIC_OFFSET, "ustar", 6);
+  memcpy(header + VERSION_OFFSET, "00", 2);
+  put_octal(header + DEVMAJOR_OFFSET, ID_SIZE, 0);
+  put_octal(header + DEVMINOR_OFFSET, ID_SIZE, 0);
+
+  /* The checksum is calculated with the checksum field set to blanks and
+     stored as six digits, a NUL and a blank. */
+  memset(header + CHKSUM_OFFSET, ' ', CHKSUM_SIZE);
+  for (i = 0; i < sizeof(header); i++)
+    checksum += (unsigned char)header[i];
+  put_octal(header + CHKSUM_OFFSET, CHKSUM_SIZE - 1, checksum);
+
+  return svn_error_trace(svn_stream_write(writer->output, header, &len));
+}
+
+/* Write the header of an entry for NAME of TYPEFLAG with MODE, SIZE,
+   MTIME and LINKNAME to WRITER, preceded by a pax extended header if any
+   of them doesn't fit into the ustar header.  Use SCRATCH_POOL for
+   temporary allocations. */
+static svn_error_t *
+write_header(svn_tar__writer_t *writer,
+             const char *name,
+             char typeflag,
+             int mode,
+             svn_filesize_t size,
+             apr_time_t mtime,
+             const char *linkname,
+             apr_pool_t *scratch_pool)
+{
+  svn_stringbuf_t *pax = svn_stringbuf_create_empty(scratch_pool);
+
+  if (writer->finished)
+    return svn_error_create(SVN_ERR_INCORRECT_PARAMS, NULL,
+                            _("Tar archive has already been finished"));
+
+  if (strlen(name) > NAME_SIZE)
+    append_pax_record(pax, "path", name);
+  if (strlen(linkname) > LINKNAME_SIZE)
+    append_pax_record(pax, "linkpath", linkname);
+  if (!fits_octal(size, SIZE_SIZE))
+    append_pax_record(pax, "size",
+                      apr_psprintf(scratch_pool, "%" SVN_FILESIZE_T_FMT,
+                                   size));
+
+  if (pax->len)
+    {
+      apr_size_t len = pax->len;
+
+      SVN_ERR(write_ustar_header(writer, "././@PaxHeader", TYPE_PAX_HEADER,
+                                 0644, pax->len, mtime, ""));
+      SVN_ERR(svn_stream_write(writer->output, pax->data, &len));
+      SVN_ERR(write_padding(writer, pax->len));
+    }
+
+  return svn_error_trace(write_ustar_header(writer, name, typeflag, mode,
+                                            size, mtime, linkname));
+}
+
+svn_error_t *
+svn_tar__add_directory(svn_tar__writer_t *writer,
+                       const char *relpath,
+                       apr_time_t mtime,
+                       apr_pool_t *scratch_pool)
+{
+  return svn_error_trace(write_header(writer,
+                                      apr_pstrcat(scratch_pool, relpath, "/",
+                                                  SVN_VA_NULL),
+                                      TYPE_DIRECTORY, 0755, 0, mtime, "",
+                                      scratch_pool));
+}
+
+svn_error_t *
+svn_tar__add_file(svn_tar__writer_t *writer,
+                  const char *relpath,
+                  svn_stream_t *contents,
+                  svn_filesize_t size,
+                  svn_boolean_t executable,
+                  apr_time_t mtime,
+                  svn_cancel_func_t cancel_func,
+                  void *cancel_baton,
+                  apr_pool_t *scratch_pool)
+{
+  int mode = executable ? 0755 : 0644;
+  char *buffer = apr_palloc(scratch_pool, SVN__STREAM_CHUNK_SIZE);
+  svn_filesize_t written = 0;
+  apr_size_t len;
+
+  if (size < 0)
+    {
+      /* The header needs the size, so buffer the contents first. */
+      svn_spillbuf_t *spill = svn_spillbuf__create(SVN__STREAM_CHUNK_SIZE,
+                                                   SPILL_SIZE,
+                                                   scratch_pool);
+      const char *data;
+
+      do
+        {
+          if (cancel_func)
+            SVN_ERR(cancel_func(cancel_baton));
+
+          len = SVN__STREAM_CHUNK_SIZE;
+          SVN_ERR(svn_stream_read_full(contents, buffer, &len));
+          SVN_ERR(svn_spillbuf__write(spill, buffer, len, scratch_pool));
+        }
+      while (len == SVN__STREAM_CHUNK_SIZE);
+
+      SVN_ERR(svn_stream_close(contents));
+
+      size = svn_spillbuf__get_size(spill);
+      SVN_ERR(write_header(writer, relpath, TYPE_FILE, mode, size, mtime,
+                           "", scratch_pool));
+
+      SVN_ERR(svn_spillbuf__read(&data, &len, spill, scratch_pool));
+      while (data)
+        {
+          SVN_ERR(svn_stream_write(writer->output, data, &len));
+          SVN_ERR(svn_spillbuf__read(&data, &len, spill, scratch_pool));
+        }
+    }
+  else
+    {
+      SVN_ERR(write_header(writer, relpath, TYPE_FILE, mode, size, mtime,
+                           "", scratch_pool));
+
+      do
+        {
+          if (cancel_func)
+            SVN_ERR(cancel_func(cancel_baton));
+
+          len = SVN__STREAM_CHUNK_SIZE;
+          SVN_ERR(svn_stream_read_full(contents, buffer, &len));
+
+          written += len;
+          if (written > size)
+            break;
+
+          SVN_ERR(svn_stream_write(writer->output, buffer, &len));
+        }
+      while (len == SVN__STREAM_CHUNK_SIZE);
+
+      /* A size mismatch would corrupt all following entries. */
+      if (written != size)
+        return svn_error_createf(SVN_ERR_STREAM_MALFORMED_DATA, NULL,
+                                 _("Contents of '%s' don't match their "
+                                   "size of %s bytes"),
+                                 relpath,
+                                 apr_psprintf(scratch_pool,
+                                              "%" SVN_FILESIZE_T_FMT, size));
+
+      SVN_ERR(svn_stream_close(contents));
+    }
+
+  return svn_error_trace(write_padding(writer, size));
+}
+
+svn_error_t *
+svn_tar__add_symlink(svn_tar__writer_t *writer,
+                     const char *relpath,
+                     const char *target,
+                     apr_time_t mtime,
+                     apr_pool_t *scratch_pool)
+{
+  return svn_error_trace(write_header(writer, relpath, TYPE_SYMLINK, 0777,
+                                      0, mtime, target, scratch_pool));
+}
+
+svn_error_t *
+svn_tar__add_versioned_file(svn_tar__writer_t *writer,
+                            const char *relpath,
+                            svn_stream_t *contents,
+                            svn_filesize_t size,
+                            const char *eol_style_val,
+                            const char *native_eol,
+                            apr_hash_t *keywords,
+                            svn_boolean_t special,
+                            svn_boolean_t executable,
+                            apr_time_t mtime,
+                            svn_cancel_func_t cancel_func,
+                            void *cancel_baton,
+                            apr_pool_t *scratch_pool)
+{
+  const char *eol = NULL;
+
+  if (special)
+    {
+      svn_string_t *text;
+
+      SVN_ERR(svn_string_from_stream2(&text, contents,
+                                      SVN__STREAM_CHUNK_SIZE,
+                                      scratch_pool));
+      if (strncmp(text->data, "link ", 5) == 0)
+        return svn_error_trace(svn_tar__add_symlink(writer, relpath,
+                                                    text->data + 5, mtime,
+                                                    scratch_pool));
+
+      /* Other special files get exported as they are. */
+      return svn_error_trace(svn_tar__add_file(writer, relpath,
+                                               svn_stream_from_string(
+                                                 text, scratch_pool),
+                                               text->len, executable, mtime,
+                                               cancel_func, cancel_baton,
+                                               scratch_pool));
+    }
+
+  if (eol_style_val)
+    {
+      svn_subst_eol_style_t style;
+
+      svn_subst_eol_style_from_value(&style, &eol, eol_style_val);
+      if (native_eol && style == svn_subst_eol_style_native)
+        {
+          svn_subst_eol_style_from_value(&style, &eol, native_eol);
+          if (style != svn_subst_eol_style_fixed)
+            return svn_error_createf(SVN_ERR_IO_UNKNOWN_EOL, NULL,
+                                     _("'%s' is not a valid EOL value"),
+                                     native_eol);
+        }
+    }
+
+  if (eol || keywords)
+    {
+      contents = svn_subst_stream_translated(contents, eol, TRUE, keywords,
+                                             TRUE, scratch_pool);
+      size = -1;
+    }
+
+  return svn_error_trace(svn_tar__add_file(writer, relpath, contents, size,
+                                           executable, mtime,
+                                           cancel_func, cancel_baton,
+                                           scratch_pool));
+}
+
+svn_error_t *
+svn_tar__writer_finish(svn_tar__writer_t *writer,
+                       apr_pool_t *scratch_pool)
+{
+  static const char zeros[2 * TAR_BLOCK_SIZE] = { 0 };
+  apr_size_t len = sizeof(zeros);
+
+  if (writer->finished)
+    return SVN_NO_ERROR;
+
+  /* Two empty blocks mark the end of the archive. */
+  SVN_ERR(svn_stream_write(writer->output, zeros, &len));
+  writer->finished = TRUE;
+
+  return SVN_NO_ERROR;
+}
@@ -42,6 +42,7 @@
 #include "win32_xlate.h"
 
 #include "private/svn_utf_private.h"
+#include "private/svn_atomic.h"
 #include "private/svn_dep_compat.h"
 #include "private/svn_string_private.h"
 #include "private/svn_mutex.h"
@@ -81,6 +82,9 @@ typedef struct xlate_handle_node_t {
   svn_boolean_t valid;
   /* The name of a char encoding or APR_LOCALE_CHARSET. */
   const char *frompage, *topage;
+  /* TRUE if HANDLE maps every 7-bit ASCII character to itself, i.e. if
+     pure ASCII strings need not be passed through HANDLE at all. */
+  svn_boolean_t ascii_identity;
   struct xlate_handle_node_t *next;
 } xlate_handle_node_t;
 
@@ -101,6 +105,13 @@ static apr_hash_t *xlate_handle_hash = NULL;
 static void * volatile xlat_ntou_static_handle = NULL;
 static void * volatile xlat_uton_static_handle = NULL;
 
+/* Non-zero once we found the standard conversion maps to leave ASCII
+ * strings unchanged.  svn_utf_cstring_to_utf8 and svn_utf_cstring_from_utf8
+ * then don't need to fetch a conversion map for pure ASCII input.
+ */
+static volatile svn_atomic_t ntou_ascii_identity = FALSE;
+static volatile svn_atomic_t uton_ascii_identity = FALSE;
+
 /* Clean up the xlate handle cache. */
 static apr_status_t
 xlate_cleanup(void *arg)
@@ -112,6 +123,8 @@ xlate_cleanup(void *arg)
   /* ensure no stale objects get accessed */
   xlat_ntou_static_handle = NULL;
   xlat_uton_static_handle = NULL;
+  svn_atomic_set(&ntou_ascii_identity, FALSE);
+  svn_atomic_set(&uton_ascii_identity, FALSE);
 
   return APR_SUCCESS;
 }
@@ -199,6 +212,39 @@ atomic_swap(void * volatile * mem, void *new_value)
 #endif
 }
 
+static svn_error_t *
+convert_to_stringbuf(xlate_handle_node_t *node,
+                     const char *src_data,
+                     apr_size_t src_length,
+                     svn_stringbuf_t **dest,
+                     apr_pool_t *pool);
+
+/* Return TRUE if converting all non-NUL 7-bit ASCII characters with
+   NODE->HANDLE does not change them.  Use SCRATCH_POOL for temporaries. */
+static svn_boolean_t
+is_ascii_identity(xlate_handle_node_t *node,
+                  apr_pool_t *scratch_pool)
+{
+  char ascii[0x7f];
+  svn_stringbuf_t *converted;
+  svn_error_t *err;
+  int i;
+
+  for (i = 0; i < sizeof(ascii); ++i)
+    ascii[i] = (char)(i + 1);
+
+  err = convert_to_stringbuf(node, ascii, sizeof(ascii), &converted,
+                             scratch_pool);
+  if (err)
+    {
+      svn_error_clear(err);
+      return FALSE;
+    }
+
+  return converted->len == sizeof(ascii)
+      && memcmp(converted->data, ascii, sizeof(ascii)) == 0;
+}
+
 /* Set *RET to a newly created handle node for converting from FROMPAGE
    to TOPAGE, If apr_xlate_open() returns APR_EINVAL or APR_ENOTIMPL, set
    (*RET)->handle to NULL.  If fail for any other reason, return the error.
@@ -268,8 +314,18 @@ xlate_alloc_handle(xlate_handle_node_t **ret,
                       ? apr_pstrdup(pool, frompage) : frompage);
   (*ret)->topage = ((topage != SVN_APR_LOCALE_CHARSET)
                     ? apr_pstrdup(pool, topage) : topage);
+  (*ret)->ascii_identity = FALSE;
   (*ret)->next = NULL;
 
+  /* Most encodings share the ASCII subset with UTF-8 but some, like
+     Shift_JIS or EBCDIC based ones, don't.  Find out once per handle. */
+  if (handle)
+    {
+      apr_pool_t *scratch_pool = svn_pool_create(pool);
+      (*ret)->ascii_identity = is_ascii_identity(*ret, scratch_pool);
+      svn_pool_destroy(scratch_pool);
+    }
+
   /* If we are called from inside a pool cleanup handler, the just created
      xlate handle will be closed when that handler returns by a newly
      registered cleanup handler, however, the handle is still cached by us.
@@ -453,11 +509,15 @@ put_xlate_handle_node(xlate_handle_node_t *node,
 static svn_error_t *
 get_ntou_xlate_handle_node(xlate_handle_node_t **ret, apr_pool_t *pool)
 {
-  return get_xlate_handle_node(ret, SVN_APR_UTF8_CHARSET,
-                               assume_native_charset_is_utf8
-                                 ? SVN_APR_UTF8_CHARSET
-                                 : SVN_APR_LOCALE_CHARSET,
-                               SVN_UTF_NTOU_XLATE_HANDLE, pool);
+  SVN_ERR(get_xlate_handle_node(ret, SVN_APR_UTF8_CHARSET,
+                                assume_native_charset_is_utf8
+                                  ? SVN_APR_UTF8_CHARSET
+                                  : SVN_APR_LOCALE_CHARSET,
+                                SVN_UTF_NTOU_XLATE_HANDLE, pool));
+  if ((*ret)->ascii_identity)
+    svn_atomic_set(&ntou_ascii_identity, TRUE);
+
+  return SVN_NO_ERROR;
 }
 
 
@@ -469,12 +529,16 @@ get_ntou_xlate_handle_node(xlate_handle_node_t **ret, apr_pool_t *pool)
 static svn_error_t *
 get_uton_xlate_handle_node(xlate_handle_node_t **ret, apr_pool_t *pool)
 {
-  return get_xlate_handle_node(ret,
-                               assume_native_charset_is_utf8
-                                 ? SVN_APR_UTF8_CHARSET
-                                 : SVN_APR_LOCALE_CHARSET,
-                               SVN_APR_UTF8_CHARSET,
-                               SVN_UTF_UTON_XLATE_HANDLE, pool);
+  SVN_ERR(get_xlate_handle_node(ret,
+                                assume_native_charset_is_utf8
+                                  ? SVN_APR_UTF8_CHARSET
+                                  : SVN_APR_LOCALE_CHARSET,
+                                SVN_APR_UTF8_CHARSET,
+                                SVN_UTF_UTON_XLATE_HANDLE, pool));
+  if ((*ret)->ascii_identity)
+    svn_atomic_set(&uton_ascii_identity, TRUE);
+
+  return SVN_NO_ERROR;
 }
 
 
@@ -489,15 +553,24 @@ convert_to_stringbuf(xlate_handle_node_t *node,
 {
 #ifdef WIN32
   apr_status_t apr_err;
-
-  apr_err = svn_subr__win32_xlate_to_stringbuf(node->handle, src_data,
-                                               src_length, dest, pool);
 #else
   apr_size_t buflen = src_length * 2;
   apr_status_t apr_err;
   apr_size_t srclen = src_length;
   apr_size_t destlen = buflen;
+#endif
 
+  /* Pure ASCII needs no conversion. */
+  if (node->ascii_identity && svn_utf__is_ascii(src_data, src_length))
+    {
+      *dest = svn_stringbuf_ncreate(src_data, src_length, pool);
+      return SVN_NO_ERROR;
+    }
+
+#ifdef WIN32
+  apr_err = svn_subr__win32_xlate_to_stringbuf(node->handle, src_data,
+                                               src_length, dest, pool);
+#else
   /* Initialize *DEST to an empty stringbuf.
      A 1:2 ratio of input bytes to output bytes (as assigned above)
      should be enough for most translations, and if it turns out not
@@ -776,6 +849,18 @@ svn_utf_cstring_to_utf8(const char **dest,
   xlate_handle_node_t *node;
   svn_error_t *err;
 
+  /* Paths, URLs and option values are usually plain ASCII.  Once we know
+     that the conversion would not change them, don't even fetch a map. */
+  if (svn_atomic_read(&ntou_ascii_identity))
+    {
+      apr_size_t len = strlen(src);
+      if (svn_utf__is_ascii(src, len))
+        {
+          *dest = apr_pstrmemdup(pool, src, len);
+          return SVN_NO_ERROR;
+        }
+    }
+
   SVN_ERR(get_ntou_xlate_handle_node(&node, pool));
   err = convert_cstring(dest, src, node, pool);
   SVN_ERR(svn_error_compose_create(err,
@@ -900,6 +985,17 @@ svn_utf_cstring_from_utf8(const char **dest,
   xlate_handle_node_t *node;
   svn_error_t *err;
 
+  /* As in svn_utf_cstring_to_utf8.  ASCII is valid UTF-8, too. */
+  if (svn_atomic_read(&uton_ascii_identity))
+    {
+      apr_size_t len = strlen(src);
+      if (svn_utf__is_ascii(src, len))
+        {
+          *dest = apr_pstrmemdup(pool, src, len);
+          return SVN_NO_ERROR;
+        }
+    }
+
   SVN_ERR(check_cstring_utf8(src, pool));
 
   SVN_ERR(get_uton_xlate_handle_node(&node, pool));
@@ -59,6 +59,18 @@
 #include "private/svn_utf_private.h"
 #include "private/svn_eol_private.h"
 #include "private/svn_dep_compat.h"
+#include "simd.h"
+
+/* Block validators that this compiler can produce.  SSSE3 support has
+ * to be checked at runtime, NEON is mandatory on AArch64.
+ */
+#if SVN_SIMD__X86
+#  define SVN_UTF_SSSE3 1
+#  include <immintrin.h>
+#elif defined(__GNUC__) && defined(__ARM_NEON) && defined(__aarch64__)
+#  define SVN_UTF_NEON 1
+#  include <arm_neon.h>
+#endif
 
 /* Lookup table to categorise each octet in the string. */
 static const char octet_category[256] = {
@@ -276,10 +288,254 @@ first_non_fsm_start_char(const char *data, apr_size_t max_len)
   return data;
 }
 
+
+#if SVN_UTF_SSSE3 || SVN_UTF_NEON
+
+/* The SIMD validators look up each pair of consecutive bytes in three
+ * 16-entry tables, indexed by the high and low nibble of the first byte
+ * and the high nibble of the second byte.  Each entry is a set of the
+ * following error flags and a pair is invalid iff a flag is set in all
+ * three lookups.  Only the "3rd and 4th byte" continuation rules need
+ * to look further back.  See Keiser & Lemire, "Validating UTF-8 In Less
+ * Than One Instruction Per Byte", Software: Practice and Experience 51(5).
+ */
+#define UTF8_TOO_SHORT    0x01  /* 11______ 0_______ or 11______ 11______ */
+#define UTF8_TOO_LONG     0x02  /* 0_______ 10______ */
+#define UTF8_OVERLONG_3   0x04  /* 11100000 100_____ */
+#define UTF8_TOO_LARGE    0x08  /* 11110100 1001____ or 11110101+ 10______ */
+#define UTF8_SURROGATE    0x10  /* 11101101 101_____ */
+#define UTF8_OVERLONG_2   0x20  /* 1100000_ 10______ */
+#define UTF8_TOO_LARGE_1000 0x40  /* 11110101+ 1000____ */
+#define UTF8_OVERLONG_4   0x40  /* 11110000 1000____ */
+#define UTF8_TWO_CONTS    0x80  /* 10______ 10______ */
+#define UTF8_CARRY        (UTF8_TOO_SHORT | UTF8_TOO_LONG | UTF8_TWO_CONTS)
+
+/* Lookup tables by high nibble of the first, low nibble of the first and
+ * high nibble of the second byte of a pair. */
+static const unsigned char utf8_byte_1_high[16] = {
+  UTF8_TOO_LONG, UTF8_TOO_LONG, UTF8_TOO_LONG, UTF8_TOO_LONG,
+  UTF8_TOO_LONG, UTF8_TOO_LONG, UTF8_TOO_LONG, UTF8_TOO_LONG,
+  UTF8_TWO_CONTS, UTF8_TWO_CONTS, UTF8_TWO_CONTS, UTF8_TWO_CONTS,
+  UTF8_TOO_SHORT | UTF8_OVERLONG_2,
+  UTF8_TOO_SHORT,
+  UTF8_TOO_SHORT | UTF8_OVERLONG_3 | UTF8_SURROGATE,
+  UTF8_TOO_SHORT | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000 | UTF8_OVERLONG_4
+};
+
+static const unsigned char utf8_byte_1_low[16] = {
+  UTF8_CARRY | UTF8_OVERLONG_3 | UTF8_OVERLONG_2 | UTF8_OVERLONG_4,
+  UTF8_CARRY | UTF8_OVERLONG_2,
+  UTF8_CARRY,
+  UTF8_CARRY,
+  UTF8_CARRY | UTF8_TOO_LARGE,
+  UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+  UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+  UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+  UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+  UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+  UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+  UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+  UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+  UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000 | UTF8_SURROGATE,
+  UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+  UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000
+};
+
+static const unsigned char utf8_byte_2_high[16] = {
+  UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT,
+  UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT,
+  UTF8_TOO_LONG | UTF8_OVERLONG_2 | UTF8_TWO_CONTS | UTF8_OVERLONG_3
+    | UTF8_TOO_LARGE_1000 | UTF8_OVERLONG_4,
+  UTF8_TOO_LONG | UTF8_OVERLONG_2 | UTF8_TWO_CONTS | UTF8_OVERLONG_3
+    | UTF8_TOO_LARGE,
+  UTF8_TOO_LONG | UTF8_OVERLONG_2 | UTF8_TWO_CONTS | UTF8_SURROGATE
+    | UTF8_TOO_LARGE,
+  UTF8_TOO_LONG | UTF8_OVERLONG_2 | UTF8_TWO_CONTS | UTF8_SURROGATE
+    | UTF8_TOO_LARGE,
+  UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT
+};
+
+/* A block validator.  It returns the offset of the first 16-byte block in
+ * DATA that contains or completes an invalid sequence, or LEN rounded
+ * down to a multiple of 16 if there is no such block.  Multi-byte chars
+ * may cross block boundaries, i.e. the last char validated may be
+ * incomplete.
+ */
+typedef apr_size_t (*validate_func_t)(const char *data, apr_size_t len);
+
+#endif /* SVN_UTF_SSSE3 || SVN_UTF_NEON */
+
+#if SVN_UTF_SSSE3
+
+SVN_SIMD__TARGET("ssse3")
+static apr_size_t
+validate_ssse3(const char *data, apr_size_t len)
+{
+  const __m128i byte_1_high
+    = _mm_loadu_si128((const __m128i *)utf8_byte_1_high);
+  const __m128i byte_1_low
+    = _mm_loadu_si128((const __m128i *)utf8_byte_1_low);
+  const __m128i byte_2_high
+    = _mm_loadu_si128((const __m128i *)utf8_byte_2_high);
+  const __m128i nibble = _mm_set1_epi8(0x0f);
+  const __m128i zero = _mm_setzero_si128();
+
+  /* Rejects a trailing lead byte that needs more bytes than the block
+   * has left. */
+  const __m128i max_complete
+    = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1,
+                    -1, -1, -1, -1, -1, (char)0xef, (char)0xdf, (char)0xbf);
+
+  __m128i prev = zero;
+  apr_size_t pos;
+
+  for (pos = 0; pos + 16 <= len; pos += 16)
+    {
+      __m128i input = _mm_loadu_si128((const __m128i *)(data + pos));
+      __m128i prev1, sc, must23, error;
+
+      /* All ASCII.  Only an incomplete char in PREV can make this fail. */
+      if (_mm_movemask_epi8(input) == 0)
+        {
+          error = _mm_subs_epu8(prev, max_complete);
+          if (_mm_movemask_epi8(_mm_cmpeq_epi8(error, zero)) != 0xffff)
+            break;
+
+          prev = input;
+          continue;
+        }
+
+      prev1 = _mm_alignr_epi8(input, prev, 15);
+      sc = _mm_and_si128(
+             _mm_and_si128(
+               _mm_shuffle_epi8(byte_1_high,
+                                _mm_and_si128(_mm_srli_epi16(prev1, 4),
+                                              nibble)),
+               _mm_shuffle_epi8(byte_1_low, _mm_and_si128(prev1, nibble))),
+             _mm_shuffle_epi8(byte_2_high,
+                              _mm_and_si128(_mm_srli_epi16(input, 4),
+                                            nibble)));
+
+      /* Bit 7 is set for every byte that must be the 3rd or 4th byte of
+       * a multi-byte char.  Those are precisely the TWO_CONTS that are
+       * not errors. */
+      must23 = _mm_or_si128(
+                 _mm_subs_epu8(_mm_alignr_epi8(input, prev, 14),
+                               _mm_set1_epi8((char)(0xe0 - 0x80))),
+                 _mm_subs_epu8(_mm_alignr_epi8(input, prev, 13),
+                               _mm_set1_epi8((char)(0xf0 - 0x80))));
+      error = _mm_xor_si128(_mm_and_si128(must23,
+                                          _mm_set1_epi8((char)0x80)),
+                            sc);
+
+      if (_mm_movemask_epi8(_mm_cmpeq_epi8(error, zero)) != 0xffff)
+        break;
+
+      prev = input;
+    }
+
+  return pos;
+}
+
+#endif /* SVN_UTF_SSSE3 */
+
+#if SVN_UTF_NEON
+
+static apr_size_t
+validate_neon(const char *data, apr_size_t len)
+{
+  const uint8x16_t byte_1_high = vld1q_u8(utf8_byte_1_high);
+  const uint8x16_t byte_1_low = vld1q_u8(utf8_byte_1_low);
+  const uint8x16_t byte_2_high = vld1q_u8(utf8_byte_2_high);
+  const uint8x16_t nibble = vdupq_n_u8(0x0f);
+  static const unsigned char max_complete_bytes[16] = {
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xef, 0xdf, 0xbf
+  };
+  const uint8x16_t max_complete = vld1q_u8(max_complete_bytes);
+
+  uint8x16_t prev = vdupq_n_u8(0);
+  apr_size_t pos;
+
+  for (pos = 0; pos + 16 <= len; pos += 16)
+    {
+      uint8x16_t input = vld1q_u8((const uint8_t *)(data + pos));
+      uint8x16_t prev1, sc, must23, error;
+
+      /* All ASCII.  Only an incomplete char in PREV can make this fail. */
+      if (vmaxvq_u8(input) < 0x80)
+        {
+          if (vmaxvq_u8(vqsubq_u8(prev, max_complete)))
+            break;
+
+          prev = input;
+          continue;
+        }
+
+      prev1 = vextq_u8(prev, input, 15);
+      sc = vandq_u8(vandq_u8(vqtbl1q_u8(byte_1_high, vshrq_n_u8(prev1, 4)),
+                             vqtbl1q_u8(byte_1_low, vandq_u8(prev1, nibble))),
+                    vqtbl1q_u8(byte_2_high, vshrq_n_u8(input, 4)));
+
+      /* Bit 7 is set for every byte that must be the 3rd or 4th byte of
+       * a multi-byte char.  Those are precisely the TWO_CONTS that are
+       * not errors. */
+      must23 = vorrq_u8(vqsubq_u8(vextq_u8(prev, input, 14),
+                                  vdupq_n_u8(0xe0 - 0x80)),
+                        vqsubq_u8(vextq_u8(prev, input, 13),
+                                  vdupq_n_u8(0xf0 - 0x80)));
+      error = veorq_u8(vandq_u8(must23, vdupq_n_u8(0x80)), sc);
+
+      if (vmaxvq_u8(error))
+        break;
+
+      prev = input;
+    }
+
+  return pos;
+}
+
+#endif /* SVN_UTF_NEON */
+
+/* Return a pointer into DATA of length LEN such that everything before it
+ * is a sequence of complete, valid UTF-8 chars.  This is a fast way to get
+ * to the point where the FSM has to take over.
+ */
+static const char *
+skip_valid_chars(const char *data, apr_size_t len)
+{
+#if SVN_UTF_SSSE3 || SVN_UTF_NEON
+  validate_func_t validate = NULL;
+
+#if SVN_UTF_SSSE3
+  if (svn_simd__features() & SVN_SIMD__SSSE3)
+    validate = validate_ssse3;
+#else
+  validate = validate_neon;
+#endif
+
+  if (validate && len >= 16)
+    {
+      const char *end = data + validate(data, len);
+      int i;
+
+      /* Back up to the start of the last char that we have seen since
+       * it may be incomplete. */
+      for (i = 1; i <= 3 && end - i >= data; ++i)
+        if ((end[-i] & 0xc0) != 0x80)
+          return end - i;
+
+      return end;
+    }
+#endif
+
+  return first_non_fsm_start_char(data, len);
+}
+
 const char *
 svn_utf__last_valid(const char *data, apr_size_t len)
 {
-  const char *start = first_non_fsm_start_char(data, len);
+  const char *start = skip_valid_chars(data, len);
   const char *end = data + len;
   int state = FSM_START;
 
@@ -295,6 +551,12 @@ svn_utf__last_valid(const char *data, apr_size_t len)
   return start;
 }
 
+svn_boolean_t
+svn_utf__is_ascii(const char *data, apr_size_t len)
+{
+  return first_non_fsm_start_char(data, len) == data + len;
+}
+
 svn_boolean_t
 svn_utf__cstring_is_valid(const char *data)
 {
@@ -313,7 +575,7 @@ svn_utf__is_valid(const char *data, apr_size_t len)
   if (!data)
     return FALSE;
 
-  data = first_non_fsm_start_char(data, len);
+  data = skip_valid_chars(data, len);
 
   while (data < end)
     {
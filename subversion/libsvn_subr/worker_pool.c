@@ -0,0 +1,834 @@
+/* worker_pool.c --- a set of worker threads running queued jobs
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include <apr_thread_cond.h>
+#include <apr_thread_proc.h>
+
+#include "svn_pools.h"
+#include "svn_private_config.h"
+
+#include "private/svn_mutex.h"
+#include "private/svn_worker_pool.h"
+
+#if APR_HAS_THREADS
+
+/* State of a svn_worker_pool__job_t. */
+typedef enum job_state_t
+{
+  /* Queued, not yet picked up by any worker. */
+  job_pending,
+
+  /* Some worker is running the job. */
+  job_running,
+
+  /* ERR has been set. */
+  job_done,
+
+  /* The job has been waited for, cancelled or was detached.  It is no
+     longer part of the pool's list. */
+  job_reaped
+} job_state_t;
+
+struct svn_worker_pool__job_t
+{
+  /* The pool this job has been posted to. */
+  svn_worker_pool__t *workers;
+
+  /* What to run. */
+  svn_worker_pool__func_t func;
+  void *baton;
+
+  /* The members below are protected by the pool's mutex. */
+  job_state_t state;
+
+  /* The result of FUNC, once STATE is job_done. */
+  svn_error_t *err;
+
+  /* Set if nobody will ever wait for this job. */
+  svn_boolean_t detached;
+
+  /* Neighbors in the pool's list of jobs. */
+  struct svn_worker_pool__job_t *previous;
+  struct svn_worker_pool__job_t *next;
+};
+
+struct svn_worker_pool__t
+{
+  /* Protects all members below as well as the jobs' state. */
+  svn_mutex__t *mutex;
+
+  /* Signaled whenever a job got queued or completed, upon
+     svn_worker_pool__notify() and when shutting down. */
+  apr_thread_cond_t *changed;
+
+  /* All jobs that have not been reaped yet, in the order they have been
+     posted. */
+  svn_worker_pool__job_t *first;
+  svn_worker_pool__job_t *last;
+
+  /* First job not picked up by any worker yet.  All jobs after it are
+     pending as well. */
+  svn_worker_pool__job_t *next_pending;
+
+  /* Set when the pool is about to be destroyed. */
+  svn_boolean_t stopping;
+
+  /* The worker threads and the thread-safe pool they live in. */
+  apr_thread_t **threads;
+  int thread_count;
+  apr_pool_t *thread_pool;
+};
+
+/* Remove JOB from its pool's list.  The caller must hold the mutex. */
+static void
+unlink_job(svn_worker_pool__job_t *job)
+{
+  svn_worker_pool__t *workers = job->workers;
+
+  if (workers->next_pending == job)
+    workers->next_pending = job->next;
+
+  if (job->previous)
+    job->previous->next = job->next;
+  else
+    workers->first = job->next;
+
+  if (job->next)
+    job->next->previous = job->previous;
+  else
+    workers->last = job->previous;
+
+  job->previous = NULL;
+  job->next = NULL;
+  job->state = job_reaped;
+}
+
+/* Thread entry function.  DATA is the svn_worker_pool__t. */
+static void * APR_THREAD_FUNC
+worker(apr_thread_t *tid,
+       void *data)
+{
+  svn_worker_pool__t *workers = data;
+  apr_pool_t *pool = apr_allocator_owner_get(svn_pool_create_allocator(FALSE));
+
+  svn_error_clear(svn_mutex__lock(workers->mutex));
+  while (!workers->stopping)
+    {
+      svn_worker_pool__job_t *job = workers->next_pending;
+      svn_error_t *err;
+
+      if (!job)
+        {
+          apr_thread_cond_wait(workers->changed,
+                               svn_mutex__get(workers->mutex));
+          continue;
+        }
+
+      workers->next_pending = job->next;
+      job->state = job_running;
+
+      svn_error_clear(svn_mutex__unlock(workers->mutex, SVN_NO_ERROR));
+      err = job->func(job->baton, pool);
+      svn_pool_clear(pool);
+      svn_error_clear(svn_mutex__lock(workers->mutex));
+
+      if (job->detached)
+        {
+          svn_error_clear(err);
+          unlink_job(job);
+        }
+      else
+        {
+          job->err = err;
+          job->state = job_done;
+        }
+
+      apr_thread_cond_broadcast(workers->changed);
+    }
+  svn_error_clear(svn_mutex__unlock(workers->mutex, SVN_NO_ERROR));
+
+  svn_pool_destroy(pool);
+
+  return NULL;
+}
+
+/* Pool pre-cleanup function stopping the svn_worker_pool__t in DATA and
+   releasing the results nobody waited for. */
+static apr_status_t
+stop_workers(void *data)
+{
+  svn_worker_pool__t *workers = data;
+  svn_worker_pool__job_t *job;
+  int i;
+
+  svn_error_clear(svn_mutex__lock(workers->mutex));
+  workers->stopping = TRUE;
+  apr_thread_cond_broadcast(workers->changed);
+  svn_error_clear(svn_mutex__unlock(workers->mutex, SVN_NO_ERROR));
+
+  for (i = 0; i < workers->thread_count; i++)
+    {
+      apr_status_t retval;
+      apr_thread_join(&retval, workers->threads[i]);
+    }
+
+  svn_pool_destroy(workers->thread_pool);
+
+  /* All workers are gone; no need for locking anymore. */
+  for (job = workers->first; job; job = job->next)
+    {
+      svn_error_clear(job->err);
+      job->err = SVN_NO_ERROR;
+    }
+
+  return APR_SUCCESS;
+}
+
+svn_error_t *
+svn_worker_pool__create(svn_worker_pool__t **workers,
+                        int threads,
+                        apr_pool_t *pool)
+{
+  svn_worker_pool__t *result = apr_pcalloc(pool, sizeof(*result));
+  apr_status_t status;
+  int i;
+
+  *workers = NULL;
+  if (threads <= 0)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_mutex__init(&result->mutex, TRUE, pool));
+  status = apr_thread_cond_create(&result->changed, pool);
+  if (status)
+    return svn_error_wrap_apr(status, _("Can't create condition variable"));
+
+  /* APR allocates the thread objects in sub-pools of this one.  Since the
+     caller keeps using POOL, use a separate, thread-safe root. */
+  result->thread_pool
+    = apr_allocator_owner_get(svn_pool_create_allocator(TRUE));
+  result->threads = apr_pcalloc(pool, threads * sizeof(*result->threads));
+
+  for (i = 0; i < threads; i++)
+    {
+      status = apr_thread_create(&result->threads[i], NULL, worker, result,
+                                 result->thread_pool);
+      if (status)
+        break;
+
+      result->thread_count++;
+    }
+
+  if (!result->thread_count)
+    {
+      svn_pool_destroy(result->thread_pool);
+      return SVN_NO_ERROR;
+    }
+
+  /* Pre-cleanups run before any sub-pool of POOL gets destroyed and
+     before any regular cleanup, including those of the mutex and the
+     condition variable.  Thus, no worker is left running on a job or
+     baton allocated there. */
+  apr_pool_pre_cleanup_register(pool, result, stop_workers);
+
+  *workers = result;
+
+  return SVN_NO_ERROR;
+}
+
+int
+svn_worker_pool__thread_count(const svn_worker_pool__t *workers)
+{
+  return workers->thread_count;
+}
+
+svn_error_t *
+svn_worker_pool__post(svn_worker_pool__job_t **job,
+                      svn_worker_pool__t *workers,
+                      svn_worker_pool__func_t func,
+                      void *baton,
+                      apr_pool_t *result_pool)
+{
+  svn_worker_pool__job_t *result = apr_pcalloc(result_pool, sizeof(*result));
+
+  result->workers = workers;
+  result->func = func;
+  result->baton = baton;
+  result->state = job_pending;
+  result->detached = (job == NULL);
+
+  SVN_ERR(svn_mutex__lock(workers->mutex));
+
+  result->previous = workers->last;
+  if (workers->last)
+    workers->last->next = result;
+  else
+    workers->first = result;
+  workers->last = result;
+
+  if (!workers->next_pending)
+    workers->next_pending = result;
+
+  apr_thread_cond_broadcast(workers->changed);
+  SVN_ERR(svn_mutex__unlock(workers->mutex, SVN_NO_ERROR));
+
+  if (job)
+    *job = result;
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_worker_pool__is_done(svn_boolean_t *done,
+                         svn_worker_pool__job_t *job)
+{
+  svn_worker_pool__t *workers = job->workers;
+
+  SVN_ERR(svn_mutex__lock(workers->mutex));
+  *done = job->state == job_done || job->state == job_reaped;
+
+  return svn_error_trace(svn_mutex__unlock(workers->mutex, SVN_NO_ERROR));
+}
+
+svn_error_t *
+svn_worker_pool__wait(svn_worker_pool__job_t *job)
+{
+  svn_worker_pool__t *workers = job->workers;
+  svn_error_t *err = SVN_NO_ERROR;
+
+  SVN_ERR(svn_mutex__lock(workers->mutex));
+
+  while (job->state == job_pending || job->state == job_running)
+    {
+      if (job->state == job_pending && workers->stopping)
+        {
+          err = svn_error_create(SVN_ERR_CANCELLED, NULL, NULL);
+          break;
+        }
+
+      apr_thread_cond_wait(workers->changed, svn_mutex__get(workers->mutex));
+    }
+
+  if (job->state == job_done)
+    {
+      err = job->err;
+      job->err = SVN_NO_ERROR;
+      unlink_job(job);
+    }
+
+  return svn_error_trace(svn_mutex__unlock(workers->mutex, err));
+}
+
+svn_error_t *
+svn_worker_pool__cancel(svn_boolean_t *cancelled,
+                        svn_worker_pool__job_t *job)
+{
+  svn_worker_pool__t *workers = job->workers;
+
+  SVN_ERR(svn_mutex__lock(workers->mutex));
+
+  *cancelled = job->state == job_pending;
+  if (*cancelled)
+    unlink_job(job);
+
+  SVN_ERR(svn_mutex__unlock(workers->mutex, SVN_NO_ERROR));
+
+  if (*cancelled)
+    return SVN_NO_ERROR;
+
+  return svn_error_trace(svn_worker_pool__wait(job));
+}
+
+svn_error_t *
+svn_worker_pool__lock(svn_worker_pool__t *workers)
+{
+  return svn_error_trace(svn_mutex__lock(workers->mutex));
+}
+
+svn_error_t *
+svn_worker_pool__unlock(svn_worker_pool__t *workers,
+                        svn_error_t *err)
+{
+  return svn_error_trace(svn_mutex__unlock(workers->mutex, err));
+}
+
+svn_error_t *
+svn_worker_pool__wait_for_change(svn_worker_pool__t *workers)
+{
+  apr_status_t status = apr_thread_cond_wait(workers->changed,
+                                             svn_mutex__get(workers->mutex));
+  if (status)
+    return svn_error_wrap_apr(status, _("Can't wait for condition variable"));
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_worker_pool__notify(svn_worker_pool__t *workers)
+{
+  apr_status_t status = apr_thread_cond_broadcast(workers->changed);
+  if (status)
+    return svn_error_wrap_apr(status, _("Can't broadcast condition variable"));
+
+  return SVN_NO_ERROR;
+}
+
+svn_boolean_t
+svn_worker_pool__stopping(svn_worker_pool__t *workers)
+{
+  return workers->stopping;
+}
+
+/* An item added to a svn_worker_pool__ordered_t. */
+typedef struct ordered_node_t
+{
+  void *item;
+
+  /* Set once ITEM has been processed. */
+  svn_boolean_t done;
+
+  /* The result of processing ITEM, once DONE is set. */
+  svn_error_t *err;
+
+  /* Next node in the queue or in the list of unused nodes. */
+  struct ordered_node_t *next;
+} ordered_node_t;
+
+struct svn_worker_pool__ordered_t
+{
+  /* As passed to svn_worker_pool__ordered_create(). */
+  svn_worker_pool__open_func_t open_func;
+  svn_worker_pool__item_func_t item_func;
+  svn_worker_pool__release_func_t release_func;
+  void *baton;
+  int capacity;
+
+  /* Runs one ordered_job() per thread.  Its mutex protects the members
+     further below. */
+  svn_worker_pool__t *workers;
+
+  /* Owns WORKERS.  NULL once the queue has been stopped. */
+  apr_pool_t *workers_pool;
+
+  /* Owns the nodes.  Only used by the thread adding items. */
+  apr_pool_t *pool;
+
+  /* All items that have not been taken yet, in the order in which they
+     have been added, and their number. */
+  ordered_node_t *first;
+  ordered_node_t *last;
+  int count;
+
+  /* First node not claimed by any thread yet.  All nodes after it are
+     unclaimed as well. */
+  ordered_node_t *next_unclaimed;
+
+  /* Nodes to recycle. */
+  ordered_node_t *unused;
+
+  /* If set, the threads shall exit ASAP. */
+  svn_boolean_t stop;
+
+  /* Error that prevented some thread from processing any item. */
+  svn_error_t *worker_err;
+};
+
+/* Implements svn_worker_pool__func_t.  BATON is the
+   svn_worker_pool__ordered_t whose items to process, one at a time, until
+   it stops. */
+static svn_error_t *
+ordered_job(void *baton,
+            apr_pool_t *scratch_pool)
+{
+  svn_worker_pool__ordered_t *queue = baton;
+  svn_worker_pool__t *workers = queue->workers;
+  void *thread_baton = queue->baton;
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  svn_error_t *err = SVN_NO_ERROR;
+
+  if (queue->open_func)
+    err = queue->open_func(&thread_baton, queue->baton, scratch_pool);
+
+  svn_error_clear(svn_mutex__lock(workers->mutex));
+
+  if (err)
+    {
+      if (queue->worker_err)
+        svn_error_clear(err);
+      else
+        queue->worker_err = err;
+
+      queue->stop = TRUE;
+      apr_thread_cond_broadcast(workers->changed);
+    }
+
+  while (!queue->stop && !workers->stopping)
+    {
+      ordered_node_t *node = queue->next_unclaimed;
+
+      if (!node)
+        {
+          apr_thread_cond_wait(workers->changed,
+                               svn_mutex__get(workers->mutex));
+          continue;
+        }
+
+      queue->next_unclaimed = node->next;
+
+      svn_error_clear(svn_mutex__unlock(workers->mutex, SVN_NO_ERROR));
+      svn_pool_clear(iterpool);
+      err = queue->item_func(node->item, thread_baton, iterpool);
+      svn_error_clear(svn_mutex__lock(workers->mutex));
+
+      node->err = err;
+      node->done = TRUE;
+      apr_thread_cond_broadcast(workers->changed);
+    }
+
+  svn_error_clear(svn_mutex__unlock(workers->mutex, SVN_NO_ERROR));
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Stop the threads of QUEUE, wait for them to exit and release all items
+   that have not been taken. */
+static void
+stop_ordered(svn_worker_pool__ordered_t *queue)
+{
+  svn_worker_pool__t *workers = queue->workers;
+
+  svn_error_clear(svn_mutex__lock(workers->mutex));
+  queue->stop = TRUE;
+  apr_thread_cond_broadcast(workers->changed);
+  svn_error_clear(svn_mutex__unlock(workers->mutex, SVN_NO_ERROR));
+
+  /* Waits for the running jobs to return. */
+  svn_pool_destroy(queue->workers_pool);
+  queue->workers_pool = NULL;
+  queue->workers = NULL;
+
+  while (queue->first)
+    {
+      ordered_node_t *node = queue->first;
+      queue->first = node->next;
+
+      svn_error_clear(node->err);
+      if (queue->release_func)
+        queue->release_func(node->item);
+    }
+
+  queue->last = NULL;
+  queue->count = 0;
+}
+
+/* Pool pre-cleanup function stopping the svn_worker_pool__ordered_t in
+   DATA unless that has been destroyed already. */
+static apr_status_t
+ordered_cleanup(void *data)
+{
+  svn_worker_pool__ordered_t *queue = data;
+
+  if (queue->workers_pool)
+    {
+      stop_ordered(queue);
+      svn_error_clear(queue->worker_err);
+      queue->worker_err = SVN_NO_ERROR;
+    }
+
+  return APR_SUCCESS;
+}
+
+svn_error_t *
+svn_worker_pool__ordered_create(svn_worker_pool__ordered_t **queue,
+                                int threads,
+                                int capacity,
+                                svn_worker_pool__open_func_t open_func,
+                                svn_worker_pool__item_func_t item_func,
+                                svn_worker_pool__release_func_t release_func,
+                                void *baton,
+                                apr_pool_t *pool)
+{
+  svn_worker_pool__ordered_t *result = apr_pcalloc(pool, sizeof(*result));
+  svn_error_t *err = SVN_NO_ERROR;
+  int i;
+
+  result->open_func = open_func;
+  result->item_func = item_func;
+  result->release_func = release_func;
+  result->baton = baton;
+  result->capacity = capacity;
+  result->pool = pool;
+
+  result->workers_pool = svn_pool_create(pool);
+  SVN_ERR(svn_worker_pool__create(&result->workers, threads,
+                                  result->workers_pool));
+  if (!result->workers)
+    {
+      svn_pool_destroy(result->workers_pool);
+      *queue = NULL;
+      return SVN_NO_ERROR;
+    }
+
+  /* The threads may still be using the items, so stop them before
+     anything in POOL gets destroyed. */
+  apr_pool_pre_cleanup_register(pool, result, ordered_cleanup);
+
+  for (i = 0; !err && i < result->workers->thread_count; ++i)
+    err = svn_worker_pool__post(NULL, result->workers, ordered_job, result,
+                                result->workers_pool);
+
+  if (err)
+    return svn_error_trace(svn_worker_pool__ordered_destroy(result, err));
+
+  *queue = result;
+  return SVN_NO_ERROR;
+}
+
+int
+svn_worker_pool__ordered_thread_count(const svn_worker_pool__ordered_t *queue)
+{
+  return queue->workers->thread_count;
+}
+
+svn_error_t *
+svn_worker_pool__ordered_add(svn_worker_pool__ordered_t *queue,
+                             void *item)
+{
+  ordered_node_t *node;
+
+  SVN_ERR(svn_mutex__lock(queue->workers->mutex));
+
+  node = queue->unused;
+  if (node)
+    queue->unused = node->next;
+  else
+    node = apr_palloc(queue->pool, sizeof(*node));
+
+  node->item = item;
+  node->done = FALSE;
+  node->err = SVN_NO_ERROR;
+  node->next = NULL;
+
+  if (queue->last)
+    queue->last->next = node;
+  else
+    queue->first = node;
+  queue->last = node;
+  queue->count++;
+
+  if (!queue->next_unclaimed)
+    queue->next_unclaimed = node;
+
+  apr_thread_cond_broadcast(queue->workers->changed);
+
+  return svn_error_trace(svn_mutex__unlock(queue->workers->mutex,
+                                           SVN_NO_ERROR));
+}
+
+svn_error_t *
+svn_worker_pool__ordered_take(void **item,
+                              svn_error_t **item_err,
+                              svn_worker_pool__ordered_t *queue,
+                              svn_boolean_t wait)
+{
+  svn_worker_pool__t *workers = queue->workers;
+  ordered_node_t *node;
+  svn_error_t *err = SVN_NO_ERROR;
+
+  *item = NULL;
+  *item_err = SVN_NO_ERROR;
+
+  SVN_ERR(svn_mutex__lock(workers->mutex));
+
+  node = queue->first;
+  while (   !err
+         && !queue->worker_err
+         && node
+         && !node->done
+         && (wait || queue->count > queue->capacity))
+    {
+      /* Nobody is going to process it anymore. */
+      if (queue->stop)
+        err = svn_error_create(SVN_ERR_CANCELLED, NULL, NULL);
+      else
+        err = svn_worker_pool__wait_for_change(workers);
+    }
+
+  if (!err && queue->worker_err)
+    {
+      err = queue->worker_err;
+      queue->worker_err = SVN_NO_ERROR;
+    }
+  else if (!err && node && node->done)
+    {
+      queue->first = node->next;
+      if (!queue->first)
+        queue->last = NULL;
+      queue->count--;
+
+      *item = node->item;
+      *item_err = node->err;
+
+      node->next = queue->unused;
+      queue->unused = node;
+    }
+
+  return svn_error_trace(svn_mutex__unlock(workers->mutex, err));
+}
+
+svn_error_t *
+svn_worker_pool__ordered_destroy(svn_worker_pool__ordered_t *queue,
+                                 svn_error_t *err)
+{
+  stop_ordered(queue);
+
+  err = svn_error_compose_create(err, queue->worker_err);
+  queue->worker_err = SVN_NO_ERROR;
+
+  return err;
+}
+
+#else /* !APR_HAS_THREADS */
+
+/* Without threads, there are never any pools to call the other functions
+   with. */
+
+svn_error_t *
+svn_worker_pool__create(svn_worker_pool__t **workers,
+                        int threads,
+                        apr_pool_t *pool)
+{
+  *workers = NULL;
+  return SVN_NO_ERROR;
+}
+
+int
+svn_worker_pool__thread_count(const svn_worker_pool__t *workers)
+{
+  return 0;
+}
+
+svn_error_t *
+svn_worker_pool__post(svn_worker_pool__job_t **job,
+                      svn_worker_pool__t *workers,
+                      svn_worker_pool__func_t func,
+                      void *baton,
+                      apr_pool_t *result_pool)
+{
+  return SVN_ERR_MALFUNCTION();
+}
+
+svn_error_t *
+svn_worker_pool__is_done(svn_boolean_t *done,
+                         svn_worker_pool__job_t *job)
+{
+  return SVN_ERR_MALFUNCTION();
+}
+
+svn_error_t *
+svn_worker_pool__wait(svn_worker_pool__job_t *job)
+{
+  return SVN_ERR_MALFUNCTION();
+}
+
+svn_error_t *
+svn_worker_pool__cancel(svn_boolean_t *cancelled,
+                        svn_worker_pool__job_t *job)
+{
+  return SVN_ERR_MALFUNCTION();
+}
+
+svn_error_t *
+svn_worker_pool__lock(svn_worker_pool__t *workers)
+{
+  return SVN_ERR_MALFUNCTION();
+}
+
+svn_error_t *
+svn_worker_pool__unlock(svn_worker_pool__t *workers,
+                        svn_error_t *err)
+{
+  return err;
+}
+
+svn_error_t *
+svn_worker_pool__wait_for_change(svn_worker_pool__t *workers)
+{
+  return SVN_ERR_MALFUNCTION();
+}
+
+svn_error_t *
+svn_worker_pool__notify(svn_worker_pool__t *workers)
+{
+  return SVN_ERR_MALFUNCTION();
+}
+
+svn_boolean_t
+svn_worker_pool__stopping(svn_worker_pool__t *workers)
+{
+  return TRUE;
+}
+
+svn_error_t *
+svn_worker_pool__ordered_create(svn_worker_pool__ordered_t **queue,
+                                int threads,
+                                int capacity,
+                                svn_worker_pool__open_func_t open_func,
+                                svn_worker_pool__item_func_t item_func,
+                                svn_worker_pool__release_func_t release_func,
+                                void *baton,
+                                apr_pool_t *pool)
+{
+  *queue = NULL;
+  return SVN_NO_ERROR;
+}
+
+int
+svn_worker_pool__ordered_thread_count(const svn_worker_pool__ordered_t *queue)
+{
+  return 0;
+}
+
+svn_error_t *
+svn_worker_pool__ordered_add(svn_worker_pool__ordered_t *queue,
+                             void *item)
+{
+  return SVN_ERR_MALFUNCTION();
+}
+
+svn_error_t *
+svn_worker_pool__ordered_take(void **item,
+                              svn_error_t **item_err,
+                              svn_worker_pool__ordered_t *queue,
+                              svn_boolean_t wait)
+{
+  return SVN_ERR_MALFUNCTION();
+}
+
+svn_error_t *
+svn_worker_pool__ordered_destroy(svn_worker_pool__ordered_t *queue,
+                                 svn_error_t *err)
+{
+  return err;
+}
+
+#endif /* APR_HAS_THREADS */
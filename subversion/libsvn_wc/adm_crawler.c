@@ -24,6 +24,7 @@
 /* ==================================================================== */
 
 
+#include <limits.h>
 #include <string.h>
 
 #include <apr_pools.h>
@@ -38,8 +39,10 @@
 #include "svn_delta.h"
 #include "svn_dirent_uri.h"
 #include "svn_path.h"
+#include "svn_sorts.h"
 
 #include "private/svn_wc_private.h"
+#include "private/svn_worker_pool.h"
 
 #include "wc.h"
 #include "adm_files.h"
@@ -1247,6 +1250,489 @@ svn_wc_transmit_text_deltas3(const svn_checksum_t **new_text_base_md5_checksum,
                                                scratch_pool);
 }
 
+
+/*** Concurrent text delta computation.
+ *
+ * Deltifying and checksumming the texts of many modified files keeps a
+ * commit CPU bound, yet the working copy DB and the commit editor may only
+ * be used by the thread driving the commit.  Therefore,
+ * svn_wc__text_delta_queue_add() opens all streams - which is where the DB
+ * gets read - in the caller's thread, worker threads then read them and
+ * compute the delta windows and checksums, and
+ * svn_wc__text_delta_queue_transmit() finally feeds the windows to the
+ * editor and installs the new pristine in the caller's thread again.
+ ***/
+
+/* Working files larger than this will not be deltified ahead of time
+ * because all their delta windows would have to be kept in memory. */
+#define DELTA_QUEUE_MAX_FILE_SIZE (16 * 1024 * 1024)
+
+/* Deltifying is limited by the disk beyond this many threads. */
+#define DELTA_QUEUE_MAX_THREADS 32
+
+/* A file to deltify. */
+typedef struct delta_job_t
+{
+  /* The file and the request to send a fulltext. */
+  const char *local_abspath;
+  svn_boolean_t fulltext;
+
+  /* If set, the file will be handled by
+     svn_wc__internal_transmit_text_deltas() upon transmission. */
+  svn_boolean_t sequential;
+
+  /* Delta source and target as well as their checksums, see
+     svn_wc__internal_transmit_text_deltas(). */
+  svn_stream_t *base_stream;
+  svn_stream_t *local_stream;
+  const svn_checksum_t *expected_md5_checksum;
+  svn_checksum_t *verify_checksum;
+  svn_checksum_t *local_md5_checksum;
+  svn_checksum_t *local_sha1_checksum;
+  svn_wc__db_install_data_t *install_data;
+
+  /* The svn_txdelta_window_t * computed by the worker and the error
+     it encountered while doing so, once the job has been taken from the
+     queue. */
+  apr_array_header_t *windows;
+  svn_error_t *err;
+
+  /* Root pool owned by this job.  It is only ever used by one thread at
+     a time. */
+  apr_pool_t *pool;
+
+  /* Next job in the order of addition, if there are no threads. */
+  struct delta_job_t *next;
+} delta_job_t;
+
+struct svn_wc__text_delta_queue_t
+{
+  svn_wc__db_t *db;
+
+  /* Computes the windows of all jobs that have not been transmitted yet,
+     in order of addition.  NULL if there are no threads. */
+  svn_worker_pool__ordered_t *jobs;
+
+  /* Without threads, all jobs that have not been transmitted yet. */
+  delta_job_t *first;
+  delta_job_t *last;
+};
+
+/* Read JOB's streams until their end, collecting the delta windows in
+ * JOB->WINDOWS, and close them.  Allocate everything in JOB->POOL.
+ */
+static svn_error_t *
+compute_delta_windows(delta_job_t *job)
+{
+  svn_txdelta_stream_t *txdelta_stream;
+  apr_pool_t *iterpool = svn_pool_create(job->pool);
+  svn_txdelta_window_t *window;
+  svn_error_t *err;
+  svn_error_t *err2;
+
+  job->windows = apr_array_make(job->pool, 4, sizeof(window));
+  svn_txdelta2(&txdelta_stream, job->base_stream, job->local_stream,
+               FALSE, job->pool);
+
+  do
+    {
+      svn_pool_clear(iterpool);
+      err = svn_txdelta_next_window(&window, txdelta_stream, iterpool);
+      if (!err && window)
+        APR_ARRAY_PUSH(job->windows, svn_txdelta_window_t *)
+          = svn_txdelta_window_dup(window, job->pool);
+    }
+  while (!err && window);
+
+  svn_pool_destroy(iterpool);
+
+  /* Close the two streams to force writing the digests. */
+  err2 = svn_stream_close(job->base_stream);
+  if (err2)
+    {
+      /* The checksum will be uninitialized in this case. */
+      job->verify_checksum = NULL;
+      err = svn_error_compose_create(err, err2);
+    }
+
+  return svn_error_compose_create(err, svn_stream_close(job->local_stream));
+}
+
+/* Implements svn_worker_pool__item_func_t.  ITEM is a delta_job_t. */
+static svn_error_t *
+delta_job(void *item,
+          void *thread_baton,
+          apr_pool_t *scratch_pool)
+{
+  delta_job_t *job = item;
+
+  if (job->sequential)
+    return SVN_NO_ERROR;
+
+  return svn_error_trace(compute_delta_windows(job));
+}
+
+/* Implements svn_worker_pool__release_func_t for delta_job_t. */
+static void
+release_delta_job(void *item)
+{
+  delta_job_t *job = item;
+
+  svn_pool_destroy(job->pool);
+}
+
+/* Pool cleanup function releasing all jobs of the
+   svn_wc__text_delta_queue_t in DATA that have not been transmitted. */
+static apr_status_t
+release_delta_jobs(void *data)
+{
+  svn_wc__text_delta_queue_t *queue = data;
+  delta_job_t *job;
+
+  for (job = queue->first; job; job = job->next)
+    release_delta_job(job);
+
+  queue->first = NULL;
+  queue->last = NULL;
+
+  return APR_SUCCESS;
+}
+
+svn_error_t *
+svn_wc__text_delta_queue_create(svn_wc__text_delta_queue_t **queue,
+                                svn_wc_context_t *wc_ctx,
+                                int threads,
+                                apr_pool_t *result_pool)
+{
+  svn_wc__text_delta_queue_t *result = apr_pcalloc(result_pool,
+                                                   sizeof(*result));
+  result->db = wc_ctx->db;
+
+  apr_pool_cleanup_register(result_pool, result, release_delta_jobs,
+                            apr_pool_cleanup_null);
+  /* The caller limits the number of jobs in the queue. */
+  if (threads > 1)
+    SVN_ERR(svn_worker_pool__ordered_create(&result->jobs,
+                                            MIN(threads,
+                                                DELTA_QUEUE_MAX_THREADS),
+                                            INT_MAX, NULL, delta_job,
+                                            release_delta_job, NULL,
+                                            result_pool));
+
+  *queue = result;
+  return SVN_NO_ERROR;
+}
+
+/* Open the streams of JOB in QUEUE along the lines of
+ * svn_wc__internal_transmit_text_deltas().  Allocate them in JOB->POOL.
+ */
+static svn_error_t *
+prepare_delta_job(delta_job_t *job,
+                  svn_wc__text_delta_queue_t *queue,
+                  apr_pool_t *scratch_pool)
+{
+  svn_stream_t *new_pristine_stream;
+
+  SVN_ERR(svn_wc__internal_translated_stream(&job->local_stream, queue->db,
+                                             job->local_abspath,
+                                             job->local_abspath,
+                                             SVN_WC_TRANSLATE_TO_NF,
+                                             job->pool, scratch_pool));
+
+  SVN_ERR(svn_wc__db_pristine_prepare_install(&new_pristine_stream,
+                                              &job->install_data,
+                                              &job->local_sha1_checksum,
+                                              NULL, queue->db,
+                                              job->local_abspath,
+                                              job->pool, scratch_pool));
+  job->local_stream = copying_stream(job->local_stream, new_pristine_stream,
+                                     job->pool);
+
+  if (! job->fulltext)
+    SVN_ERR(read_and_checksum_pristine_text(&job->base_stream,
+                                            &job->expected_md5_checksum,
+                                            &job->verify_checksum,
+                                            queue->db, job->local_abspath,
+                                            job->pool, scratch_pool));
+  else
+    job->base_stream = svn_stream_empty(job->pool);
+
+  job->local_stream = svn_stream_checksummed2(job->local_stream,
+                                              &job->local_md5_checksum,
+                                              NULL, svn_checksum_md5, TRUE,
+                                              job->pool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Return a new delta_job_t for LOCAL_ABSPATH and FULLTEXT, to be handled
+ * sequentially unless prepared otherwise, in its own root pool.
+ */
+static delta_job_t *
+create_delta_job(const char *local_abspath,
+                 svn_boolean_t fulltext)
+{
+  apr_pool_t *pool = apr_allocator_owner_get(svn_pool_create_allocator(FALSE));
+  delta_job_t *job = apr_pcalloc(pool, sizeof(*job));
+
+  job->pool = pool;
+  job->local_abspath = apr_pstrdup(pool, local_abspath);
+  job->fulltext = fulltext;
+  job->sequential = TRUE;
+
+  return job;
+}
+
+svn_error_t *
+svn_wc__text_delta_queue_add(svn_wc__text_delta_queue_t *queue,
+                             const char *local_abspath,
+                             svn_boolean_t fulltext,
+                             apr_pool_t *scratch_pool)
+{
+  delta_job_t *job = create_delta_job(local_abspath, fulltext);
+
+  if (queue->jobs)
+    {
+      const svn_io_dirent2_t *dirent;
+      svn_error_t *err;
+
+      /* Any error will simply be reported again when transmitting the
+         file sequentially. */
+      err = svn_io_stat_dirent2(&dirent, local_abspath, FALSE, TRUE,
+                                scratch_pool, scratch_pool);
+      if (!err && dirent->kind == svn_node_file
+          && dirent->filesize <= DELTA_QUEUE_MAX_FILE_SIZE)
+        {
+          err = prepare_delta_job(job, queue, scratch_pool);
+          if (err)
+            {
+              /* Release whatever the preparation managed to open. */
+              svn_pool_destroy(job->pool);
+              job = create_delta_job(local_abspath, fulltext);
+            }
+          else
+            job->sequential = FALSE;
+        }
+
+      svn_error_clear(err);
+    }
+
+  if (queue->jobs)
+    return svn_error_trace(svn_worker_pool__ordered_add(queue->jobs, job));
+
+  if (queue->last)
+    queue->last->next = job;
+  else
+    queue->first = job;
+  queue->last = job;
+
+  return SVN_NO_ERROR;
+}
+
+/* Baton for the svn_txdelta_stream_t replaying the windows of a
+   delta_job_t. */
+typedef struct replay_baton_t
+{
+  delta_job_t *job;
+  int next;
+} replay_baton_t;
+
+/* Implements svn_txdelta_next_window_fn_t. */
+static svn_error_t *
+replay_next_window(svn_txdelta_window_t **window,
+                   void *baton,
+                   apr_pool_t *pool)
+{
+  replay_baton_t *b = baton;
+
+  if (b->next < b->job->windows->nelts)
+    *window = APR_ARRAY_IDX(b->job->windows, b->next++,
+                            svn_txdelta_window_t *);
+  else
+    *window = NULL;
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_txdelta_md5_digest_fn_t. */
+static const unsigned char *
+replay_md5_digest(void *baton)
+{
+  replay_baton_t *b = baton;
+
+  return b->job->local_md5_checksum->digest;
+}
+
+/* Implements svn_txdelta_stream_open_func_t.  BATON is the delta_job_t. */
+static svn_error_t *
+open_replay_stream(svn_txdelta_stream_t **txdelta_stream_p,
+                   void *baton,
+                   apr_pool_t *result_pool,
+                   apr_pool_t *scratch_pool)
+{
+  replay_baton_t *b = apr_pcalloc(result_pool, sizeof(*b));
+
+  /* Every stream starts from the first window, so restarts come for
+     free. */
+  b->job = baton;
+  *txdelta_stream_p = svn_txdelta_stream_create(b, replay_next_window,
+                                                replay_md5_digest,
+                                                result_pool);
+  return SVN_NO_ERROR;
+}
+
+/* Send the delta windows of the completed JOB to EDITOR and FILE_BATON,
+ * unless EDITOR can take the new text by its checksum, install the new
+ * pristine and return the new checksums in
+ * *NEW_TEXT_BASE_MD5_CHECKSUM and *NEW_TEXT_BASE_SHA1_CHECKSUM.  Finally,
+ * close FILE_BATON.
+ */
+static svn_error_t *
+transmit_delta_job(const svn_checksum_t **new_text_base_md5_checksum,
+                   const svn_checksum_t **new_text_base_sha1_checksum,
+                   delta_job_t *job,
+                   const svn_delta_editor_t *editor,
+                   void *file_baton,
+                   apr_pool_t *result_pool,
+                   apr_pool_t *scratch_pool)
+{
+  svn_error_t *err = job->err;
+  svn_boolean_t applied = FALSE;
+  job->err = NULL;
+
+  /* If we have an error, it may be caused by a corrupt text base,
+     so check the checksum. */
+  if (job->expected_md5_checksum && job->verify_checksum
+      && !svn_checksum_match(job->expected_md5_checksum,
+                             job->verify_checksum))
+    {
+      err = svn_error_compose_create(
+              svn_checksum_mismatch_err(job->expected_md5_checksum,
+                                        job->verify_checksum, scratch_pool,
+                            _("Checksum mismatch for text base of '%s'"),
+                            svn_dirent_local_style(job->local_abspath,
+                                                   scratch_pool)),
+              err);
+
+      return svn_error_create(SVN_ERR_WC_CORRUPT_TEXT_BASE, err, NULL);
+    }
+
+  /* The repository may already have this very text, e.g. when reverting
+     to an older version or when copying between branches.  Then there is
+     no need to send it at all. */
+  if (!err && editor->apply_text_by_checksum)
+    err = editor->apply_text_by_checksum(&applied, editor, file_baton,
+                                         job->local_sha1_checksum,
+                                         scratch_pool);
+
+  if (!err && !applied)
+    {
+      const char *base_digest_hex = NULL;
+
+      if (job->expected_md5_checksum)
+        base_digest_hex
+          = svn_checksum_to_cstring_display(job->expected_md5_checksum,
+                                            scratch_pool);
+
+      err = editor->apply_textdelta_stream(editor, file_baton,
+                                           base_digest_hex,
+                                           open_replay_stream, job,
+                                           scratch_pool);
+    }
+
+  SVN_ERR_W(err, apr_psprintf(scratch_pool,
+                              _("While preparing '%s' for commit"),
+                              svn_dirent_local_style(job->local_abspath,
+                                                     scratch_pool)));
+
+  SVN_ERR(svn_wc__db_pristine_install(job->install_data,
+                                      job->local_sha1_checksum,
+                                      job->local_md5_checksum,
+                                      scratch_pool));
+
+  if (new_text_base_md5_checksum)
+    *new_text_base_md5_checksum = svn_checksum_dup(job->local_md5_checksum,
+                                                   result_pool);
+  if (new_text_base_sha1_checksum)
+    *new_text_base_sha1_checksum = svn_checksum_dup(job->local_sha1_checksum,
+                                                    result_pool);
+
+  return svn_error_trace(
+             editor->close_file(file_baton,
+                                svn_checksum_to_cstring(
+                                    job->local_md5_checksum, scratch_pool),
+                                scratch_pool));
+}
+
+svn_error_t *
+svn_wc__text_delta_queue_transmit(
+  const svn_checksum_t **new_text_base_md5_checksum,
+  const svn_checksum_t **new_text_base_sha1_checksum,
+  svn_wc__text_delta_queue_t *queue,
+  const char *local_abspath,
+  const svn_delta_editor_t *editor,
+  void *file_baton,
+  apr_pool_t *result_pool,
+  apr_pool_t *scratch_pool)
+{
+  delta_job_t *job;
+  svn_error_t *err;
+
+  if (queue->jobs)
+    {
+      void *item;
+
+      SVN_ERR(svn_worker_pool__ordered_take(&item, &err, queue->jobs,
+                                            TRUE));
+      job = item;
+      if (job)
+        job->err = err;
+    }
+  else
+    {
+      job = queue->first;
+      if (job)
+        {
+          queue->first = job->next;
+          if (!queue->first)
+            queue->last = NULL;
+        }
+    }
+
+  if (!job || strcmp(job->local_abspath, local_abspath) != 0)
+    {
+      if (job)
+        {
+          svn_error_clear(job->err);
+          release_delta_job(job);
+        }
+
+      return svn_error_createf(SVN_ERR_ASSERTION_FAIL, NULL,
+                               _("'%s' has not been queued for transmission"),
+                               svn_dirent_local_style(local_abspath,
+                                                      scratch_pool));
+    }
+
+  if (job->sequential)
+    err = svn_wc__internal_transmit_text_deltas(NULL,
+                                                new_text_base_md5_checksum,
+                                                new_text_base_sha1_checksum,
+                                                queue->db, local_abspath,
+                                                job->fulltext, editor,
+                                                file_baton, result_pool,
+                                                scratch_pool);
+  else
+    err = transmit_delta_job(new_text_base_md5_checksum,
+                             new_text_base_sha1_checksum,
+                             job, editor, file_baton,
+                             result_pool, scratch_pool);
+
+  svn_error_clear(job->err);
+  release_delta_job(job);
+
+  return svn_error_trace(err);
+}
+
 svn_error_t *
 svn_wc__internal_transmit_prop_deltas(svn_wc__db_t *db,
                                      const char *local_abspath,
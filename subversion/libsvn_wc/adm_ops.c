@@ -53,6 +53,7 @@
 #include "adm_files.h"
 #include "conflicts.h"
 #include "workqueue.h"
+#include "translate.h"
 
 #include "private/svn_dep_compat.h"
 #include "private/svn_sorts_private.h"
@@ -875,6 +876,13 @@ svn_wc__get_pristine_contents_by_checksum(svn_stream_t **contents,
       *contents = svn_stream_lazyopen_create(get_pristine_lazyopen_func,
                                              gpl_baton, FALSE, result_pool);
     }
+  else
+    {
+      /* Another working copy on this machine may have it. */
+      SVN_ERR(svn_wc__db_pristine_read_shared(contents, wc_ctx->db,
+                                              checksum, result_pool,
+                                              scratch_pool));
+    }
 
   return SVN_NO_ERROR;
 }
@@ -930,7 +938,7 @@ svn_wc_add_lock2(svn_wc_context_t *wc_ctx,
   SVN_ERR(err);
 
   if (needs_lock)
-    SVN_ERR(svn_io_set_file_read_write(local_abspath, FALSE, scratch_pool));
+    SVN_ERR(svn_wc__set_file_read_write(local_abspath, scratch_pool));
 
   return SVN_NO_ERROR;
 }
@@ -114,3 +114,27 @@ svn_wc_context_destroy(svn_wc_context_t *wc_ctx)
 
   return SVN_NO_ERROR;
 }
+
+
+void
+svn_wc__context_set_pristine_fetch(svn_wc_context_t *wc_ctx,
+                                   svn_wc__pristine_fetch_func_t fetch_func,
+                                   void *fetch_baton)
+{
+  svn_wc__db_set_pristine_fetch(wc_ctx->db, fetch_func, fetch_baton);
+}
+
+
+svn_error_t *
+svn_wc__get_store_pristine(svn_boolean_t *store_pristine,
+                           svn_wc_context_t *wc_ctx,
+                           const char *local_abspath,
+                           apr_pool_t *scratch_pool)
+{
+  SVN_ERR_ASSERT(svn_dirent_is_absolute(local_abspath));
+
+  return svn_error_trace(svn_wc__db_get_store_pristine(store_pristine,
+                                                       wc_ctx->db,
+                                                       local_abspath,
+                                                       scratch_pool));
+}
@@ -353,6 +353,7 @@ copy_versioned_dir(svn_wc__db_t *db,
   apr_hash_t *disk_children;
   apr_hash_index_t *hi;
   svn_node_kind_t disk_kind;
+  svn_boolean_t tree_copied = FALSE;
   apr_pool_t *iterpool;
 
   /* Prepare a temp copy of the single filesystem node (usually a dir). */
@@ -368,11 +369,22 @@ copy_versioned_dir(svn_wc__db_t *db,
                              scratch_pool, scratch_pool));
     }
 
+  /* When only the metadata is copied, try to copy the whole tree below the
+     operation root at once; large moves would otherwise spend most of their
+     time in one wc.db transaction per node.  This works for the common case
+     of an unmodified subtree and leaves everything else to the loop below,
+     so it isn't retried for every subdirectory. */
+  if (metadata_only && !strcmp(dst_abspath, dst_op_root_abspath))
+    SVN_ERR(svn_wc__db_op_copy_tree(&tree_copied, db, src_abspath,
+                                    dst_abspath, dst_op_root_abspath,
+                                    is_move, work_items, scratch_pool));
+
   /* Copy the (single) node's metadata, and move the new filesystem node
      into place. */
-  SVN_ERR(svn_wc__db_op_copy(db, src_abspath, dst_abspath,
-                             dst_op_root_abspath, is_move, work_items,
-                             scratch_pool));
+  if (!tree_copied)
+    SVN_ERR(svn_wc__db_op_copy(db, src_abspath, dst_abspath,
+                               dst_op_root_abspath, is_move, work_items,
+                               scratch_pool));
 
   if (notify_func)
     {
@@ -389,6 +401,9 @@ copy_versioned_dir(svn_wc__db_t *db,
       (*notify_func)(notify_baton, notify, scratch_pool);
     }
 
+  if (tree_copied)
+    return SVN_NO_ERROR;
+
   if (!metadata_only && disk_kind == svn_node_dir)
     /* All filesystem children, versioned and unversioned.  We're only
        interested in their names, so we can pass TRUE as the only_check_type
@@ -0,0 +1,236 @@
+/*
+ * fsmonitor.c :  querying a filesystem monitor for changed paths
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+
+
+#include "svn_dirent_uri.h"
+#include "svn_hash.h"
+#include "svn_io.h"
+#include "svn_path.h"
+#include "svn_pools.h"
+#include "svn_string.h"
+
+#include "wc.h"
+#include "adm_files.h"
+#include "fsmonitor.h"
+
+#include "svn_private_config.h"
+
+
+/* Name of the file below the admin dir that holds the last token. */
+#define FSMONITOR_TOKEN_FILE "fsmonitor"
+
+/* Set *TOKEN to the token stored for WCROOT_ABSPATH or to "" if there is
+   none.  Set *MODIFIED to the const char * paths, relative to
+   WCROOT_ABSPATH, that were stored with it.  Allocate the results in
+   RESULT_POOL. */
+static svn_error_t *
+read_token(const char **token,
+           apr_array_header_t **modified,
+           const char *wcroot_abspath,
+           apr_pool_t *result_pool,
+           apr_pool_t *scratch_pool)
+{
+  svn_stringbuf_t *contents;
+  svn_stringbuf_t *token_buf;
+  apr_array_header_t *lines;
+  int i;
+  svn_error_t *err;
+
+  err = svn_stringbuf_from_file2(&contents,
+                                 svn_wc__adm_child(wcroot_abspath,
+                                                   FSMONITOR_TOKEN_FILE,
+                                                   scratch_pool),
+                                 result_pool);
+  if (err && APR_STATUS_IS_ENOENT(err->apr_err))
+    {
+      svn_error_clear(err);
+      *token = "";
+      *modified = apr_array_make(result_pool, 0, sizeof(const char *));
+      return SVN_NO_ERROR;
+    }
+  SVN_ERR(err);
+
+  /* Paths may start or end with whitespace, tokens don't. */
+  lines = svn_cstring_split(contents->data, "\n", FALSE, result_pool);
+  if (lines->nelts == 0)
+    {
+      *token = "";
+      *modified = lines;
+      return SVN_NO_ERROR;
+    }
+
+  token_buf = svn_stringbuf_create(APR_ARRAY_IDX(lines, 0, const char *),
+                                   result_pool);
+  svn_stringbuf_strip_whitespace(token_buf);
+  *token = token_buf->data;
+  *modified = apr_array_make(result_pool, lines->nelts - 1,
+                             sizeof(const char *));
+  for (i = 1; i < lines->nelts; ++i)
+    APR_ARRAY_PUSH(*modified, const char *)
+      = APR_ARRAY_IDX(lines, i, const char *);
+
+  return SVN_NO_ERROR;
+}
+
+/* Mark the directories affected by a change of CHANGED_ABSPATH in
+   DIRTY_DIRS.  Allocate new keys in RESULT_POOL. */
+static void
+add_dirty_path(apr_hash_t *dirty_dirs,
+               const char *changed_abspath,
+               apr_pool_t *result_pool)
+{
+  /* The path itself may be a directory whose contents changed ... */
+  svn_hash_sets(dirty_dirs, changed_abspath, changed_abspath);
+
+  /* ... and its parent's listing changes if it got added or removed. */
+  changed_abspath = svn_dirent_dirname(changed_abspath, result_pool);
+  svn_hash_sets(dirty_dirs, changed_abspath, changed_abspath);
+}
+
+svn_error_t *
+svn_wc__fsmonitor_query(apr_hash_t **dirty_dirs,
+                        const char **new_token,
+                        svn_wc__db_t *db,
+                        const char *wcroot_abspath,
+                        apr_pool_t *result_pool,
+                        apr_pool_t *scratch_pool)
+{
+  const char *hook = svn_wc__db_get_fsmonitor_hook(db);
+  const char *args[4];
+  const char *token;
+  apr_array_header_t *modified;
+  const char *out_abspath;
+  apr_file_t *outfile;
+  svn_stringbuf_t *output;
+  apr_array_header_t *lines;
+  apr_hash_t *result;
+  int exitcode;
+  apr_exit_why_e exitwhy;
+  svn_error_t *err;
+  int i;
+
+  *dirty_dirs = NULL;
+  *new_token = NULL;
+
+  if (!hook)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(read_token(&token, &modified, wcroot_abspath,
+                     scratch_pool, scratch_pool));
+
+  args[0] = hook;
+  args[1] = svn_dirent_local_style(wcroot_abspath, scratch_pool);
+  args[2] = token;
+  args[3] = NULL;
+
+  SVN_ERR(svn_io_open_unique_file3(&outfile, &out_abspath, NULL,
+                                   svn_io_file_del_on_pool_cleanup,
+                                   scratch_pool, scratch_pool));
+
+  /* A failing monitor only costs us the speedup. */
+  err = svn_io_run_cmd(wcroot_abspath, hook, args, &exitcode, &exitwhy,
+                       TRUE, NULL, outfile, NULL, scratch_pool);
+  if (err || !APR_PROC_CHECK_EXIT(exitwhy) || exitcode != 0)
+    {
+      svn_error_clear(err);
+      return SVN_NO_ERROR;
+    }
+
+  SVN_ERR(svn_io_file_close(outfile, scratch_pool));
+  SVN_ERR(svn_stringbuf_from_file2(&output, out_abspath, scratch_pool));
+
+  lines = svn_cstring_split(output->data, "\r\n", FALSE, scratch_pool);
+  if (lines->nelts == 0)
+    return SVN_NO_ERROR;
+
+  *new_token = apr_pstrdup(result_pool, APR_ARRAY_IDX(lines, 0, const char *));
+
+  /* Without a previous token, the list is meaningless. */
+  if (!*token)
+    return SVN_NO_ERROR;
+
+  /* The hook won't report files again that were already modified when
+     we got the previous token. */
+  result = apr_hash_make(result_pool);
+  for (i = 0; i < modified->nelts; i++)
+    add_dirty_path(result,
+                   svn_dirent_join(wcroot_abspath,
+                                   APR_ARRAY_IDX(modified, i, const char *),
+                                   result_pool),
+                   result_pool);
+
+  for (i = 1; i < lines->nelts; i++)
+    {
+      const char *line = APR_ARRAY_IDX(lines, i, const char *);
+      const char *changed_abspath;
+
+      /* "Everything may have changed". */
+      if (strcmp(line, "/") == 0)
+        return SVN_NO_ERROR;
+
+      line = svn_dirent_internal_style(line, scratch_pool);
+      if (svn_dirent_is_absolute(line))
+        changed_abspath = apr_pstrdup(result_pool, line);
+      else
+        changed_abspath = svn_dirent_join(wcroot_abspath, line, result_pool);
+
+      add_dirty_path(result, changed_abspath, result_pool);
+    }
+
+  *dirty_dirs = result;
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_wc__fsmonitor_save_token(const char *wcroot_abspath,
+                             const char *token,
+                             const apr_array_header_t *modified_abspaths,
+                             apr_pool_t *scratch_pool)
+{
+  svn_stringbuf_t *contents = svn_stringbuf_createf(scratch_pool, "%s\n",
+                                                    token);
+  int i;
+
+  for (i = 0; i < modified_abspaths->nelts; i++)
+    {
+      const char *relpath
+        = svn_dirent_skip_ancestor(wcroot_abspath,
+                                   APR_ARRAY_IDX(modified_abspaths, i,
+                                                 const char *));
+
+      /* Externals live in their own working copies. */
+      if (relpath && *relpath)
+        {
+          svn_stringbuf_appendcstr(contents, relpath);
+          svn_stringbuf_appendbyte(contents, '\n');
+        }
+    }
+
+  return svn_error_trace(
+            svn_io_write_atomic2(svn_wc__adm_child(wcroot_abspath,
+                                                   FSMONITOR_TOKEN_FILE,
+                                                   scratch_pool),
+                                 contents->data, contents->len,
+                                 NULL, FALSE, scratch_pool));
+}
@@ -0,0 +1,94 @@
+/*
+ * fsmonitor.h :  querying a filesystem monitor for changed paths
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+
+#ifndef SVN_LIBSVN_WC_FSMONITOR_H
+#define SVN_LIBSVN_WC_FSMONITOR_H
+
+#include <apr_pools.h>
+#include <apr_hash.h>
+#include <apr_tables.h>
+#include "svn_types.h"
+
+#include "wc_db.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+
+/* The fsmonitor hook is an external command configured by the
+   [working-copy] fsmonitor-hook option and typically backed by a
+   notification service like inotify, FSEvents, ReadDirectoryChangesW or
+   watchman.  It gets invoked as
+
+       HOOK WCROOT_ABSPATH TOKEN
+
+   where TOKEN is the value the hook returned for the last complete
+   status walk of that working copy, or an empty string.  The hook must
+   print a new token on its first output line, followed by one line per
+   path (relative to WCROOT_ABSPATH or absolute) that has been created,
+   modified or removed since TOKEN.  A "/" line or a non-zero exit code
+   means that all paths have to be considered modified.
+
+   Files that had text modifications during the last complete walk are
+   stored along with the token, because the hook only reports changes
+   since then.  */
+
+/* Query the fsmonitor hook configured for DB for the paths changed in the
+   working copy at WCROOT_ABSPATH since the last token saved with
+   svn_wc__fsmonitor_save_token().
+
+   Set *DIRTY_DIRS to a hash whose const char * keys are the absolute
+   paths of all directories whose listing or immediate children may have
+   changed.  Set *DIRTY_DIRS to NULL if no hook is configured or all
+   directories have to be checked.  Set *NEW_TOKEN to the token to save
+   after the status of the whole working copy has been determined, or to
+   NULL if there is none.
+
+   Allocate the results in RESULT_POOL and use SCRATCH_POOL for temporary
+   allocations. */
+svn_error_t *
+svn_wc__fsmonitor_query(apr_hash_t **dirty_dirs,
+                        const char **new_token,
+                        svn_wc__db_t *db,
+                        const char *wcroot_abspath,
+                        apr_pool_t *result_pool,
+                        apr_pool_t *scratch_pool);
+
+/* Store TOKEN as the fsmonitor token for the working copy at
+   WCROOT_ABSPATH.  MODIFIED_ABSPATHS contains the const char * absolute
+   paths of all files with text modifications at that point in time.
+   Their directories will be considered changed by the next query. */
+svn_error_t *
+svn_wc__fsmonitor_save_token(const char *wcroot_abspath,
+                             const char *token,
+                             const apr_array_header_t *modified_abspaths,
+                             apr_pool_t *scratch_pool);
+
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* SVN_LIBSVN_WC_FSMONITOR_H */
@@ -877,6 +877,32 @@ svn_wc__node_get_md5_from_sha1(const svn_checksum_t **md5_checksum,
                                                      scratch_pool));
 }
 
+svn_error_t *
+svn_wc__node_get_pristine_sha1(const svn_checksum_t **sha1_checksum,
+                               svn_wc_context_t *wc_ctx,
+                               const char *local_abspath,
+                               apr_pool_t *result_pool,
+                               apr_pool_t *scratch_pool)
+{
+  svn_wc__db_status_t status;
+  svn_node_kind_t kind;
+
+  SVN_ERR(svn_wc__db_read_pristine_info(&status, &kind, NULL, NULL, NULL,
+                                        NULL, sha1_checksum, NULL, NULL,
+                                        NULL, wc_ctx->db, local_abspath,
+                                        result_pool, scratch_pool));
+
+  /* Simply added files have no checksum, copies have the copy source's. */
+  if (kind != svn_node_file
+      || status == svn_wc__db_status_not_present
+      || status == svn_wc__db_status_excluded
+      || status == svn_wc__db_status_server_excluded
+      || status == svn_wc__db_status_incomplete)
+    *sha1_checksum = NULL;
+
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *
 svn_wc__get_not_present_descendants(const apr_array_header_t **descendants,
                                     svn_wc_context_t *wc_ctx,
@@ -2079,6 +2079,84 @@ svn_wc_prop_set4(svn_wc_context_t *wc_ctx,
   return SVN_NO_ERROR;
 }
 
+svn_error_t *
+svn_wc__prop_delete_many(svn_wc_context_t *wc_ctx,
+                         const apr_array_header_t *targets,
+                         const char *name,
+                         apr_pool_t *scratch_pool)
+{
+  svn_wc__db_t *db = wc_ctx->db;
+  apr_array_header_t *abspaths;
+  apr_array_header_t *props;
+  apr_pool_t *iterpool;
+  int i;
+
+  /* Those would require work items or invalidate the recorded info. */
+  SVN_ERR_ASSERT(svn_property_kind2(name) == svn_prop_regular_kind
+                 && strcmp(name, SVN_PROP_EXECUTABLE) != 0
+                 && strcmp(name, SVN_PROP_NEEDS_LOCK) != 0
+                 && strcmp(name, SVN_PROP_KEYWORDS) != 0
+                 && strcmp(name, SVN_PROP_EOL_STYLE) != 0);
+
+  abspaths = apr_array_make(scratch_pool, targets->nelts,
+                            sizeof(const char *));
+  props = apr_array_make(scratch_pool, targets->nelts, sizeof(apr_hash_t *));
+
+  /* Do all the checks of svn_wc_prop_set4() up-front. */
+  iterpool = svn_pool_create(scratch_pool);
+  for (i = 0; i < targets->nelts; i++)
+    {
+      const char *local_abspath = APR_ARRAY_IDX(targets, i, const char *);
+      svn_wc__db_status_t status;
+      svn_node_kind_t kind;
+      apr_hash_t *prophash;
+
+      svn_pool_clear(iterpool);
+
+      SVN_ERR(svn_wc__db_read_info(&status, &kind, NULL, NULL, NULL, NULL,
+                                   NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+                                   NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+                                   NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+                                   db, local_abspath,
+                                   iterpool, iterpool));
+
+      if (status != svn_wc__db_status_normal
+          && status != svn_wc__db_status_added
+          && status != svn_wc__db_status_incomplete)
+        {
+          return svn_error_createf(SVN_ERR_WC_INVALID_SCHEDULE, NULL,
+                                   _("Can't set properties on '%s':"
+                                     " invalid status for updating "
+                                     "properties."),
+                                   svn_dirent_local_style(local_abspath,
+                                                          iterpool));
+        }
+
+      SVN_ERR(svn_wc__write_check(db,
+                                  kind == svn_node_dir
+                                    ? local_abspath
+                                    : svn_dirent_dirname(local_abspath,
+                                                         iterpool),
+                                  iterpool));
+
+      SVN_ERR_W(svn_wc__db_read_props(&prophash, db, local_abspath,
+                                      scratch_pool, iterpool),
+                _("Failed to load current properties"));
+
+      /* Deleting a non-existent property is a no-op. */
+      if (!svn_hash_gets(prophash, name))
+        continue;
+
+      svn_hash_sets(prophash, name, NULL);
+      APR_ARRAY_PUSH(abspaths, const char *) = local_abspath;
+      APR_ARRAY_PUSH(props, apr_hash_t *) = prophash;
+    }
+  svn_pool_destroy(iterpool);
+
+  return svn_error_trace(svn_wc__db_op_set_props_many(db, abspaths, props,
+                                                      scratch_pool));
+}
+
 /* Check that NAME names a regular prop. Return an error if it names an
  * entry prop or a WC prop. */
 static svn_error_t *
@@ -42,6 +42,7 @@
 #include "wc.h"
 #include "adm_files.h"
 #include "workqueue.h"
+#include "translate.h"
 
 #include "svn_private_config.h"
 #include "private/svn_io_private.h"
@@ -97,6 +98,12 @@
 */
 
 
+/* Recursive reverts run the work queue once this many file installs have
+   been queued, rather than once per directory.  That lets the installer
+   work on batches spanning many directories in parallel (see the
+   install-threads option) while the queue stays reasonably short. */
+#define REVERT_INSTALL_BATCH 1000
+
 /* Remove conflict file CONFLICT_ABSPATH, which may not exist, and set
  * *NOTIFY_REQUIRED to TRUE if the file was present and removed. */
 static svn_error_t *
@@ -248,7 +255,7 @@ revert_restore_handle_copied_dirs(svn_boolean_t *removed_self,
 
 /* Forward definition */
 static svn_error_t *
-revert_wc_data(svn_boolean_t *run_wq,
+revert_wc_data(int *queued_installs,
                svn_boolean_t *notify_required,
                svn_wc__db_t *db,
                const char *local_abspath,
@@ -271,14 +278,15 @@ revert_wc_data(svn_boolean_t *run_wq,
    REVERT_ROOT is true for explicit revert targets and FALSE for targets
    reached via recursion.
 
-   Sets *RUN_WQ to TRUE when the caller should (eventually) run the workqueue.
-   (The function sets it to FALSE when it has run the WQ itself)
+   Adds the number of file installs queued to *QUEUED_INSTALLS; the caller
+   should (eventually) run the workqueue if that is not 0.  (The function
+   resets it to 0 when it has run the WQ itself)
 
    If INFO is NULL, LOCAL_ABSPATH doesn't exist in DB. Otherwise INFO
    specifies the state of LOCAL_ABSPATH in DB.
  */
 static svn_error_t *
-revert_restore(svn_boolean_t *run_wq,
+revert_restore(int *queued_installs,
                svn_wc__db_t *db,
                const char *local_abspath,
                svn_depth_t depth,
@@ -384,7 +392,7 @@ revert_restore(svn_boolean_t *run_wq,
 
   if (!metadata_only)
     {
-      SVN_ERR(revert_wc_data(run_wq,
+      SVN_ERR(revert_wc_data(queued_installs,
                              &notify_required,
                              db, local_abspath, status, kind,
                              reverted_kind, recorded_size, recorded_time,
@@ -437,7 +445,7 @@ revert_restore(svn_boolean_t *run_wq,
 
           child_abspath = svn_dirent_join(local_abspath, child_name, iterpool);
 
-          SVN_ERR(revert_restore(run_wq,
+          SVN_ERR(revert_restore(queued_installs,
                                  db, child_abspath, depth, metadata_only,
                                  use_commit_times, FALSE /* revert root */,
                                  added_keep_local,
@@ -447,12 +455,12 @@ revert_restore(svn_boolean_t *run_wq,
                                  iterpool));
         }
 
-      /* Run the queue per directory */
-      if (*run_wq)
+      /* Run the queue every now and then */
+      if (*queued_installs >= REVERT_INSTALL_BATCH)
         {
           SVN_ERR(svn_wc__wq_run(db, local_abspath, cancel_func, cancel_baton,
                                  iterpool));
-          *run_wq = FALSE;
+          *queued_installs = 0;
         }
 
       svn_pool_destroy(iterpool);
@@ -467,7 +475,7 @@ revert_restore(svn_boolean_t *run_wq,
 
 /* Perform the in-working copy revert of LOCAL_ABSPATH, to what is stored in DB */
 static svn_error_t *
-revert_wc_data(svn_boolean_t *run_wq,
+revert_wc_data(int *queued_installs,
                svn_boolean_t *notify_required,
                svn_wc__db_t *db,
                const char *local_abspath,
@@ -648,9 +656,8 @@ revert_wc_data(svn_boolean_t *run_wq,
                         }
                       else if (!needs_lock_prop && read_only)
                         {
-                          SVN_ERR(svn_io_set_file_read_write(local_abspath,
-                                                             FALSE,
-                                                             scratch_pool));
+                          SVN_ERR(svn_wc__set_file_read_write(local_abspath,
+                                                              scratch_pool));
                           *notify_required = TRUE;
                         }
                     }
@@ -708,7 +715,7 @@ revert_wc_data(svn_boolean_t *run_wq,
                                                 scratch_pool, scratch_pool));
           SVN_ERR(svn_wc__db_wq_add(db, local_abspath, work_item,
                                     scratch_pool));
-          *run_wq = TRUE;
+          (*queued_installs)++;
         }
       *notify_required = TRUE;
     }
@@ -733,7 +740,7 @@ revert(svn_wc__db_t *db,
 {
   svn_error_t *err;
   const struct svn_wc__db_info_t *info = NULL;
-  svn_boolean_t run_queue = FALSE;
+  int queued_installs = 0;
 
   SVN_ERR_ASSERT(depth == svn_depth_empty || depth == svn_depth_infinity);
 
@@ -773,14 +780,15 @@ revert(svn_wc__db_t *db,
 
   if (!err)
     err = svn_error_trace(
-              revert_restore(&run_queue, db, local_abspath, depth, metadata_only,
-                             use_commit_times, TRUE /* revert root */,
+              revert_restore(&queued_installs, db, local_abspath, depth,
+                             metadata_only, use_commit_times,
+                             TRUE /* revert root */,
                              added_keep_local,
                              info, cancel_func, cancel_baton,
                              notify_func, notify_baton,
                              scratch_pool));
 
-  if (run_queue)
+  if (queued_installs)
     err = svn_error_compose_create(err,
                                    svn_wc__wq_run(db, local_abspath,
                                                   cancel_func, cancel_baton,
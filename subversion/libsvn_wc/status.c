@@ -46,11 +46,13 @@
 
 #include "wc.h"
 #include "props.h"
+#include "fsmonitor.h"
 
 #include "private/svn_sorts_private.h"
 #include "private/svn_wc_private.h"
 #include "private/svn_fspath.h"
 #include "private/svn_editor.h"
+#include "private/svn_worker_pool.h"
 
 
 /* The file internal variant of svn_wc_status3_t, with slightly more
@@ -75,6 +77,11 @@ typedef struct svn_wc__internal_status_t
 } svn_wc__internal_status_t;
 
 
+/* The maximum number of node rows the status walk reads ahead in a single
+   query; larger trees are read directory by directory to bound the
+   memory use. */
+#define PREFETCH_MAX_NODES 50000
+
 /*** Baton used for walking the local status */
 struct walk_status_baton
 {
@@ -91,6 +98,9 @@ struct walk_status_baton
   /* Scan the working copy for local modifications and missing nodes. */
   svn_boolean_t check_working_copy;
 
+  /* Don't report unversioned items other than the target. */
+  svn_boolean_t versioned_only;
+
   /* Externals info harvested during the status run. */
   apr_hash_t *externals;
 
@@ -100,6 +110,21 @@ struct walk_status_baton
 
   /* Repository locks, if set. */
   apr_hash_t *repos_locks;
+
+  /* Reads directory listings ahead of the walk, or NULL. */
+  struct dirent_prefetcher_t *prefetcher;
+
+  /* If not NULL, the filesystem monitor guarantees that the listings and
+     immediate children of all directories not in this set of const char *
+     abspaths are unchanged since the last complete status walk. */
+  apr_hash_t *fsmonitor_dirty_dirs;
+
+  /* If not NULL, the result of svn_wc__db_read_subtree_info() for
+     PREFETCH_ABSPATH, which is part of the working copy at
+     PREFETCH_WCROOT_ABSPATH. */
+  apr_hash_t *prefetched_dirs;
+  const char *prefetch_abspath;
+  const char *prefetch_wcroot_abspath;
 };
 
 /*** Editor batons ***/
@@ -1171,6 +1196,12 @@ one_child_status(const struct walk_status_baton *wb,
    * determined.  For example, in 'svn status', plain unversioned nodes show
    * as '?  C', where ignored ones show as 'I  C'. */
 
+  /* Reading the ignore properties is the expensive part of reporting
+     unversioned items, so don't bother if the caller doesn't want them. */
+  if (wb->versioned_only && ! conflicted
+      && strcmp(wb->target_abspath, local_abspath) != 0)
+    return SVN_NO_ERROR;
+
   if (ignore_patterns && ! *collected_ignore_patterns)
     SVN_ERR(collect_ignore_patterns(collected_ignore_patterns,
                                     wb->db, parent_abspath, ignore_patterns,
@@ -1188,6 +1219,281 @@ one_child_status(const struct walk_status_baton *wb,
   return SVN_NO_ERROR;
 }
 
+
+/*** Reading directory listings ahead of the status walk.
+ *
+ * Most of the time of a status walk over a large working copy on a
+ * network filesystem is spent waiting for the stat() results of every
+ * node.  The working copy DB may only be used by the walking thread, but
+ * the directory listings can be read by worker threads in advance: once
+ * a directory's children are known, we queue all its versioned
+ * sub-directories for prefetching in walk order.
+ *
+ * The walk itself and with it the order of all status callbacks remain
+ * unchanged.  The walker picks up prefetched listings when it reaches the
+ * respective directory, waits for listings currently being read and reads
+ * the listings of directories that are still queued itself.
+ ***/
+
+#if APR_HAS_THREADS
+
+/* Number of worker threads reading directory listings. */
+#define PREFETCH_THREADS 4
+
+/* Maximum number of directory listings read ahead of the walk. */
+#define PREFETCH_MAX_JOBS 1024
+
+/* The request to read a single directory listing. */
+typedef struct dirent_job_t
+{
+  /* Directory to read. */
+  const char *local_abspath;
+
+  /* Passed to svn_io_get_dirents3(). */
+  svn_boolean_t only_check_type;
+
+  /* The result from svn_io_get_dirents3(), once JOB has finished. */
+  apr_hash_t *dirents;
+
+  /* Root pool containing DIRENTS, created by the worker. */
+  apr_pool_t *pool;
+
+  /* The job reading the listing. */
+  svn_worker_pool__job_t *job;
+} dirent_job_t;
+
+/* The prefetcher.  Only used by the walker's thread. */
+typedef struct dirent_prefetcher_t
+{
+  /* Reads the listings. */
+  svn_worker_pool__t *workers;
+
+  /* Maps const char * abspaths to dirent_job_t * for all jobs that have
+     not been taken by the walker, yet. */
+  apr_hash_t *jobs;
+
+  /* Pool for the job structures and hash keys. */
+  apr_pool_t *pool;
+} dirent_prefetcher_t;
+
+/* Implements svn_worker_pool__func_t.  BATON is a dirent_job_t. */
+static svn_error_t *
+read_dirents_job(void *baton,
+                 apr_pool_t *scratch_pool)
+{
+  dirent_job_t *job = baton;
+
+  job->pool = apr_allocator_owner_get(svn_pool_create_allocator(FALSE));
+
+  return svn_error_trace(svn_io_get_dirents3(&job->dirents,
+                                             job->local_abspath,
+                                             job->only_check_type,
+                                             job->pool, scratch_pool));
+}
+
+/* Pool cleanup function releasing all results of the dirent_prefetcher_t
+   in DATA not picked up by the walker. */
+static apr_status_t
+release_prefetched_dirents(void *data)
+{
+  dirent_prefetcher_t *prefetcher = data;
+  apr_hash_index_t *hi;
+
+  /* Runs after the workers are gone. */
+  for (hi = apr_hash_first(prefetcher->pool, prefetcher->jobs);
+       hi;
+       hi = apr_hash_next(hi))
+    {
+      dirent_job_t *job = apr_hash_this_val(hi);
+
+      if (job->pool)
+        svn_pool_destroy(job->pool);
+    }
+
+  return APR_SUCCESS;
+}
+
+/* Pool cleanup function destroying the root pool DATA. */
+static apr_status_t
+destroy_root_pool(void *data)
+{
+  svn_pool_destroy(data);
+  return APR_SUCCESS;
+}
+
+/* Create a prefetcher for dirents and return it in *PREFETCHER.  It will
+ * be stopped when POOL gets cleaned up.  Set *PREFETCHER to NULL if no
+ * worker thread could be started.
+ */
+static svn_error_t *
+create_prefetcher(dirent_prefetcher_t **prefetcher,
+                  apr_pool_t *pool)
+{
+  dirent_prefetcher_t *result = apr_pcalloc(pool, sizeof(*result));
+
+  result->jobs = apr_hash_make(pool);
+  result->pool = pool;
+
+  apr_pool_cleanup_register(pool, result, release_prefetched_dirents,
+                            apr_pool_cleanup_null);
+  SVN_ERR(svn_worker_pool__create(&result->workers, PREFETCH_THREADS, pool));
+
+  /* Not being able to start threads is not fatal; we simply don't
+     prefetch anything. */
+  *prefetcher = result->workers ? result : NULL;
+
+  return SVN_NO_ERROR;
+}
+
+/* Queue the directory LOCAL_ABSPATH for prefetching with ONLY_CHECK_TYPE
+   in PREFETCHER unless too many prefetched listings are waiting already. */
+static svn_error_t *
+prefetch_dirents(dirent_prefetcher_t *prefetcher,
+                 const char *local_abspath,
+                 svn_boolean_t only_check_type)
+{
+  dirent_job_t *job;
+
+  if (apr_hash_count(prefetcher->jobs) >= PREFETCH_MAX_JOBS
+      || svn_hash_gets(prefetcher->jobs, local_abspath))
+    return SVN_NO_ERROR;
+
+  job = apr_pcalloc(prefetcher->pool, sizeof(*job));
+  job->local_abspath = apr_pstrdup(prefetcher->pool, local_abspath);
+  job->only_check_type = only_check_type;
+  svn_hash_sets(prefetcher->jobs, job->local_abspath, job);
+
+  return svn_error_trace(svn_worker_pool__post(&job->job,
+                                               prefetcher->workers,
+                                               read_dirents_job, job,
+                                               prefetcher->pool));
+}
+
+/* Take the results for LOCAL_ABSPATH from PREFETCHER.  If that directory
+ * has been read already or is being read, set *FOUND to TRUE and return
+ * the listing in *DIRENTS resp. the error status.  Otherwise, set *FOUND
+ * to FALSE; any queued job for LOCAL_ABSPATH will be dropped.  The listing
+ * will remain valid until RESULT_POOL gets cleaned up.
+ */
+static svn_error_t *
+take_prefetched_dirents(svn_boolean_t *found,
+                        apr_hash_t **dirents,
+                        dirent_prefetcher_t *prefetcher,
+                        const char *local_abspath,
+                        apr_pool_t *result_pool)
+{
+  dirent_job_t *job = svn_hash_gets(prefetcher->jobs, local_abspath);
+  svn_boolean_t cancelled;
+  svn_error_t *err;
+
+  *found = FALSE;
+  if (!job)
+    return SVN_NO_ERROR;
+
+  svn_hash_sets(prefetcher->jobs, local_abspath, NULL);
+  err = svn_worker_pool__cancel(&cancelled, job->job);
+  if (cancelled)
+    return SVN_NO_ERROR;
+
+  *found = TRUE;
+  *dirents = job->dirents;
+  if (job->pool)
+    apr_pool_cleanup_register(result_pool, job->pool, destroy_root_pool,
+                              apr_pool_cleanup_null);
+
+  return svn_error_trace(err);
+}
+
+#endif /* APR_HAS_THREADS */
+
+/* Return TRUE if the walk described by WB does not need to check the
+   children of directory LOCAL_ABSPATH for text modifications. */
+static svn_boolean_t
+skip_text_mods(const struct walk_status_baton *wb,
+               const char *local_abspath)
+{
+  return wb->ignore_text_mods
+         || (wb->fsmonitor_dirty_dirs
+             && !svn_hash_gets(wb->fsmonitor_dirty_dirs, local_abspath));
+}
+
+/* Set *DIRENTS to the directory listing of LOCAL_ABSPATH as returned
+   by svn_io_get_dirents3() for the walk described by WB.  Use the
+   prefetched data, if available. */
+static svn_error_t *
+read_dirents(apr_hash_t **dirents,
+             const struct walk_status_baton *wb,
+             const char *local_abspath,
+             apr_pool_t *result_pool,
+             apr_pool_t *scratch_pool)
+{
+#if APR_HAS_THREADS
+  if (wb->prefetcher)
+    {
+      svn_boolean_t found;
+
+      SVN_ERR(take_prefetched_dirents(&found, dirents, wb->prefetcher,
+                                      local_abspath, result_pool));
+      if (found)
+        return SVN_NO_ERROR;
+    }
+#endif
+
+  return svn_error_trace(svn_io_get_dirents3(dirents, local_abspath,
+                                             skip_text_mods(wb, local_abspath)
+                                               /* only_check_type */,
+                                             result_pool, scratch_pool));
+}
+
+/* Like svn_wc__db_read_children_info() for the walk described by WB,
+   but use the node information read ahead, if available. */
+static svn_error_t *
+read_children_info(apr_hash_t **nodes,
+                   apr_hash_t **conflicts,
+                   const struct walk_status_baton *wb,
+                   const char *local_abspath,
+                   apr_pool_t *result_pool,
+                   apr_pool_t *scratch_pool)
+{
+  const char *relpath = NULL;
+
+  if (wb->prefetched_dirs)
+    relpath = svn_dirent_skip_ancestor(wb->prefetch_abspath, local_abspath);
+
+  if (relpath)
+    {
+      const char *wcroot_abspath;
+
+      /* Nested working copies are not part of the prefetched data. */
+      SVN_ERR(svn_wc__db_get_wcroot(&wcroot_abspath, wb->db, local_abspath,
+                                    scratch_pool, scratch_pool));
+
+      if (strcmp(wcroot_abspath, wb->prefetch_wcroot_abspath) == 0)
+        {
+          svn_wc__db_children_info_t *dir;
+
+          dir = svn_hash_gets(wb->prefetched_dirs, relpath);
+          if (dir)
+            {
+              *nodes = dir->nodes;
+              *conflicts = dir->conflicts;
+            }
+          else
+            {
+              *nodes = apr_hash_make(result_pool);
+              *conflicts = apr_hash_make(result_pool);
+            }
+
+          return SVN_NO_ERROR;
+        }
+    }
+
+  return svn_error_trace(svn_wc__db_read_children_info(
+                           nodes, conflicts, wb->db, local_abspath,
+                           !wb->check_working_copy,
+                           result_pool, scratch_pool));
+}
+
 /* Send svn_wc_status3_t * structures for the directory LOCAL_ABSPATH and
    for all its child nodes (according to DEPTH) through STATUS_FUNC /
    STATUS_BATON.
@@ -1247,9 +1553,8 @@ get_dir_status(const struct walk_status_baton *wb,
 
   if (wb->check_working_copy)
     {
-      err = svn_io_get_dirents3(&dirents, local_abspath,
-                                wb->ignore_text_mods /* only_check_type*/,
-                                scratch_pool, iterpool);
+      err = read_dirents(&dirents, wb, local_abspath,
+                         scratch_pool, iterpool);
       if (err
           && (APR_STATUS_IS_ENOENT(err->apr_err)
               || SVN__APR_STATUS_IS_ENOTDIR(err->apr_err)))
@@ -1278,10 +1583,37 @@ get_dir_status(const struct walk_status_baton *wb,
   /* Create a hash containing all children.  The source hashes
      don't all map the same types, but only the keys of the result
      hash are subsequently used. */
-  SVN_ERR(svn_wc__db_read_children_info(&nodes, &conflicts,
-                                        wb->db, local_abspath,
-                                        !wb->check_working_copy,
-                                        scratch_pool, iterpool));
+  SVN_ERR(read_children_info(&nodes, &conflicts, wb, local_abspath,
+                             scratch_pool, iterpool));
+
+  /* If the filesystem monitor tells us that nothing changed here, the
+     files are still as recorded.  The listing doesn't contain sizes and
+     timestamps in that case, so fill them in to skip the text checks. */
+  if (wb->check_working_copy && !wb->ignore_text_mods
+      && skip_text_mods(wb, local_abspath))
+    {
+      apr_hash_index_t *hi;
+
+      for (hi = apr_hash_first(scratch_pool, nodes); hi;
+           hi = apr_hash_next(hi))
+        {
+          const char *name = apr_hash_this_key(hi);
+          const struct svn_wc__db_info_t *info = apr_hash_this_val(hi);
+          svn_io_dirent2_t *child_dirent = svn_hash_gets(dirents, name);
+
+          if (child_dirent
+              && child_dirent->kind == svn_node_file
+              && info->kind == svn_node_file
+              && info->recorded_size != SVN_INVALID_FILESIZE
+              && info->recorded_time != 0)
+            {
+              child_dirent = svn_io_dirent2_dup(child_dirent, scratch_pool);
+              child_dirent->filesize = info->recorded_size;
+              child_dirent->mtime = info->recorded_time;
+              svn_hash_sets(dirents, name, child_dirent);
+            }
+        }
+    }
 
   all_children = apr_hash_overlay(scratch_pool, nodes, dirents);
   if (apr_hash_count(conflicts) > 0)
@@ -1340,6 +1672,33 @@ get_dir_status(const struct walk_status_baton *wb,
   sorted_children = svn_sort__hash(all_children,
                                    svn_sort_compare_items_lexically,
                                    scratch_pool);
+
+#if APR_HAS_THREADS
+  /* Let the workers read the sub-directories we are going to descend
+     into while we report the status of this directory's children. */
+  if (wb->prefetcher && depth == svn_depth_infinity)
+    for (i = 0; i < sorted_children->nelts; i++)
+      {
+        svn_sort__item_t *item = &APR_ARRAY_IDX(sorted_children, i,
+                                                svn_sort__item_t);
+        const struct svn_wc__db_info_t *child_info;
+        const svn_io_dirent2_t *child_dirent;
+
+        child_info = apr_hash_get(nodes, item->key, item->klen);
+        child_dirent = apr_hash_get(dirents, item->key, item->klen);
+        if (child_info && child_info->has_descendants
+            && child_dirent && child_dirent->kind == svn_node_dir)
+          {
+            const char *child_abspath;
+
+            svn_pool_clear(iterpool);
+            child_abspath = svn_dirent_join(local_abspath, item->key,
+                                            iterpool);
+            SVN_ERR(prefetch_dirents(wb->prefetcher, child_abspath,
+                                     skip_text_mods(wb, child_abspath)));
+          }
+      }
+#endif
   for (i = 0; i < sorted_children->nelts; i++)
     {
       const void *key;
@@ -2511,8 +2870,11 @@ svn_wc__get_status_editor(const svn_delta_editor_t **editor,
   eb->wb.target_abspath   = eb->target_abspath;
   eb->wb.ignore_text_mods = !check_working_copy;
   eb->wb.check_working_copy = check_working_copy;
+  eb->wb.versioned_only   = FALSE;
   eb->wb.repos_locks      = NULL;
   eb->wb.repos_root       = NULL;
+  eb->wb.prefetcher       = NULL;
+  eb->wb.prefetched_dirs  = NULL;
 
   SVN_ERR(svn_wc__db_externals_defined_below(&eb->wb.externals,
                                              wc_ctx->db, eb->target_abspath,
@@ -2619,19 +2981,54 @@ stat_wc_dirent_case_sensitive(const svn_io_dirent2_t **dirent,
                                 result_pool, scratch_pool));
 }
 
-svn_error_t *
-svn_wc__internal_walk_status(svn_wc__db_t *db,
-                             const char *local_abspath,
-                             svn_depth_t depth,
-                             svn_boolean_t get_all,
-                             svn_boolean_t no_ignore,
-                             svn_boolean_t ignore_text_mods,
-                             const apr_array_header_t *ignore_patterns,
-                             svn_wc_status_func4_t status_func,
-                             void *status_baton,
-                             svn_cancel_func_t cancel_func,
-                             void *cancel_baton,
-                             apr_pool_t *scratch_pool)
+/* Baton for fsmonitor_status_func(). */
+struct fsmonitor_status_baton
+{
+  /* The const char * absolute paths of the files reported as modified. */
+  apr_array_header_t *modified_abspaths;
+
+  svn_wc_status_func4_t status_func;
+  void *status_baton;
+};
+
+/* Implements svn_wc_status_func4_t.  Remember the files whose text is
+   modified, or conflicted, before passing STATUS on to the wrapped
+   callback in BATON.  The filesystem monitor will not report them again. */
+static svn_error_t *
+fsmonitor_status_func(void *baton,
+                      const char *local_abspath,
+                      const svn_wc_status3_t *status,
+                      apr_pool_t *scratch_pool)
+{
+  struct fsmonitor_status_baton *fsb = baton;
+
+  if (status->kind == svn_node_file
+      && (status->node_status == svn_wc_status_conflicted
+          || status->text_status == svn_wc_status_modified
+          || status->text_status == svn_wc_status_conflicted))
+    APR_ARRAY_PUSH(fsb->modified_abspaths, const char *)
+      = apr_pstrdup(fsb->modified_abspaths->pool, local_abspath);
+
+  return svn_error_trace(fsb->status_func(fsb->status_baton, local_abspath,
+                                          status, scratch_pool));
+}
+
+/* Implement svn_wc__internal_walk_status() and
+   svn_wc__walk_versioned_status(), the latter if VERSIONED_ONLY is set. */
+static svn_error_t *
+walk_status(svn_wc__db_t *db,
+            const char *local_abspath,
+            svn_depth_t depth,
+            svn_boolean_t get_all,
+            svn_boolean_t no_ignore,
+            svn_boolean_t ignore_text_mods,
+            svn_boolean_t versioned_only,
+            const apr_array_header_t *ignore_patterns,
+            svn_wc_status_func4_t status_func,
+            void *status_baton,
+            svn_cancel_func_t cancel_func,
+            void *cancel_baton,
+            apr_pool_t *scratch_pool)
 {
   struct walk_status_baton wb;
   const svn_io_dirent2_t *dirent;
@@ -2642,8 +3039,12 @@ svn_wc__internal_walk_status(svn_wc__db_t *db,
   wb.target_abspath = local_abspath;
   wb.ignore_text_mods = ignore_text_mods;
   wb.check_working_copy = TRUE;
+  wb.versioned_only = versioned_only;
   wb.repos_root = NULL;
   wb.repos_locks = NULL;
+  wb.prefetcher = NULL;
+  wb.fsmonitor_dirty_dirs = NULL;
+  wb.prefetched_dirs = NULL;
 
   /* Use the caller-provided ignore patterns if provided; the build-time
      configured defaults otherwise. */
@@ -2690,6 +3091,51 @@ svn_wc__internal_walk_status(svn_wc__db_t *db,
       && info->status != svn_wc__db_status_excluded
       && info->status != svn_wc__db_status_server_excluded)
     {
+      const char *wcroot_abspath = NULL;
+      const char *fsmonitor_token = NULL;
+      struct fsmonitor_status_baton fsb;
+
+      if (!ignore_text_mods)
+        {
+          SVN_ERR(svn_wc__db_get_wcroot(&wcroot_abspath, db, local_abspath,
+                                        scratch_pool, scratch_pool));
+          SVN_ERR(svn_wc__fsmonitor_query(&wb.fsmonitor_dirty_dirs,
+                                          &fsmonitor_token, db,
+                                          wcroot_abspath,
+                                          scratch_pool, scratch_pool));
+        }
+
+      /* Collect what the next query has to treat as changed. */
+      if (fsmonitor_token)
+        {
+          fsb.modified_abspaths = apr_array_make(scratch_pool, 16,
+                                                 sizeof(const char *));
+          fsb.status_func = status_func;
+          fsb.status_baton = status_baton;
+          status_func = fsmonitor_status_func;
+          status_baton = &fsb;
+        }
+
+#if APR_HAS_THREADS
+      /* Reading directories ahead only pays off for deep walks. */
+      if (depth == svn_depth_infinity || depth == svn_depth_unknown)
+        SVN_ERR(create_prefetcher(&wb.prefetcher, scratch_pool));
+#endif
+
+      /* The same holds for reading the nodes of the whole tree at once. */
+      if (depth == svn_depth_infinity || depth == svn_depth_unknown)
+        {
+          SVN_ERR(svn_wc__db_read_subtree_info(&wb.prefetched_dirs, db,
+                                               local_abspath,
+                                               FALSE /* base_tree_only */,
+                                               PREFETCH_MAX_NODES,
+                                               scratch_pool, scratch_pool));
+          wb.prefetch_abspath = local_abspath;
+          SVN_ERR(svn_wc__db_get_wcroot(&wb.prefetch_wcroot_abspath, db,
+                                        local_abspath,
+                                        scratch_pool, scratch_pool));
+        }
+
       SVN_ERR(get_dir_status(&wb,
                              local_abspath,
                              FALSE /* skip_root */,
@@ -2703,6 +3149,14 @@ svn_wc__internal_walk_status(svn_wc__db_t *db,
                              status_func, status_baton,
                              cancel_func, cancel_baton,
                              scratch_pool));
+
+      /* Only a complete walk may start a new monitoring interval. */
+      if (fsmonitor_token
+          && (depth == svn_depth_infinity || depth == svn_depth_unknown)
+          && strcmp(wcroot_abspath, local_abspath) == 0)
+        SVN_ERR(svn_wc__fsmonitor_save_token(wcroot_abspath, fsmonitor_token,
+                                             fsb.modified_abspaths,
+                                             scratch_pool));
     }
   else
     {
@@ -2735,6 +3189,50 @@ svn_wc__internal_walk_status(svn_wc__db_t *db,
   return SVN_NO_ERROR;
 }
 
+svn_error_t *
+svn_wc__internal_walk_status(svn_wc__db_t *db,
+                             const char *local_abspath,
+                             svn_depth_t depth,
+                             svn_boolean_t get_all,
+                             svn_boolean_t no_ignore,
+                             svn_boolean_t ignore_text_mods,
+                             const apr_array_header_t *ignore_patterns,
+                             svn_wc_status_func4_t status_func,
+                             void *status_baton,
+                             svn_cancel_func_t cancel_func,
+                             void *cancel_baton,
+                             apr_pool_t *scratch_pool)
+{
+  return svn_error_trace(walk_status(db, local_abspath, depth, get_all,
+                                     no_ignore, ignore_text_mods,
+                                     FALSE /* versioned_only */,
+                                     ignore_patterns,
+                                     status_func, status_baton,
+                                     cancel_func, cancel_baton,
+                                     scratch_pool));
+}
+
+svn_error_t *
+svn_wc__walk_versioned_status(svn_wc_context_t *wc_ctx,
+                              const char *local_abspath,
+                              svn_depth_t depth,
+                              svn_boolean_t get_all,
+                              svn_wc_status_func4_t status_func,
+                              void *status_baton,
+                              svn_cancel_func_t cancel_func,
+                              void *cancel_baton,
+                              apr_pool_t *scratch_pool)
+{
+  return svn_error_trace(walk_status(wc_ctx->db, local_abspath, depth,
+                                     get_all, TRUE /* no_ignore */,
+                                     FALSE /* ignore_text_mods */,
+                                     TRUE /* versioned_only */,
+                                     NULL /* ignore_patterns */,
+                                     status_func, status_baton,
+                                     cancel_func, cancel_baton,
+                                     scratch_pool));
+}
+
 svn_error_t *
 svn_wc_walk_status(svn_wc_context_t *wc_ctx,
                    const char *local_abspath,
@@ -2764,6 +3262,27 @@ svn_wc_walk_status(svn_wc_context_t *wc_ctx,
                                         scratch_pool));
 }
 
+svn_error_t *
+svn_wc__begin_read_snapshot(svn_wc_context_t *wc_ctx,
+                            const char *local_abspath,
+                            apr_pool_t *scratch_pool)
+{
+  return svn_error_trace(svn_wc__db_begin_read_snapshot(wc_ctx->db,
+                                                        local_abspath,
+                                                        scratch_pool));
+}
+
+svn_error_t *
+svn_wc__end_read_snapshot(svn_wc_context_t *wc_ctx,
+                          const char *local_abspath,
+                          svn_error_t *err,
+                          apr_pool_t *scratch_pool)
+{
+  return svn_error_trace(svn_wc__db_end_read_snapshot(wc_ctx->db,
+                                                      local_abspath, err,
+                                                      scratch_pool));
+}
+
 
 svn_error_t *
 svn_wc_status_set_repos_locks(void *edit_baton,
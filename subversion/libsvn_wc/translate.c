@@ -348,6 +348,35 @@ svn_wc__expand_keywords(apr_hash_t **keywords,
   return SVN_NO_ERROR;
 }
 
+/* Give LOCAL_ABSPATH an inode of its own if it is a hard link, e.g. to
+   its pristine.  Files that may change must not share their contents or
+   mode with others. */
+static svn_error_t *
+break_hardlink(const char *local_abspath,
+               apr_pool_t *scratch_pool)
+{
+  apr_finfo_t finfo;
+
+  SVN_ERR(svn_io_stat(&finfo, local_abspath, APR_FINFO_NLINK, scratch_pool));
+
+  /* Copying to a temporary file and renaming it into place does that. */
+  if ((finfo.valid & APR_FINFO_NLINK) && finfo.nlink > 1)
+    SVN_ERR(svn_io_copy_file(local_abspath, local_abspath, TRUE,
+                             scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_wc__set_file_read_write(const char *local_abspath,
+                            apr_pool_t *scratch_pool)
+{
+  SVN_ERR(break_hardlink(local_abspath, scratch_pool));
+
+  return svn_error_trace(svn_io_set_file_read_write(local_abspath, FALSE,
+                                                    scratch_pool));
+}
+
 svn_error_t *
 svn_wc__sync_flags_with_props(svn_boolean_t *did_set,
                               svn_wc__db_t *db,
@@ -400,7 +429,7 @@ svn_wc__sync_flags_with_props(svn_boolean_t *did_set,
       || ! svn_hash_gets(props, SVN_PROP_NEEDS_LOCK)
       || lock)
     {
-      SVN_ERR(svn_io_set_file_read_write(local_abspath, FALSE, scratch_pool));
+      SVN_ERR(svn_wc__set_file_read_write(local_abspath, scratch_pool));
     }
   else
     {
@@ -434,8 +463,11 @@ svn_wc__sync_flags_with_props(svn_boolean_t *did_set,
                                          scratch_pool));
     }
   else
-    SVN_ERR(svn_io_set_file_executable(local_abspath, TRUE, FALSE,
-                                       scratch_pool));
+    {
+      SVN_ERR(break_hardlink(local_abspath, scratch_pool));
+      SVN_ERR(svn_io_set_file_executable(local_abspath, TRUE, FALSE,
+                                         scratch_pool));
+    }
 #endif
 
   return SVN_NO_ERROR;
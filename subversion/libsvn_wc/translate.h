@@ -158,6 +158,16 @@ svn_wc__sync_flags_with_props(svn_boolean_t *did_set,
                               const char *local_abspath,
                               apr_pool_t *scratch_pool);
 
+/* Make the working file LOCAL_ABSPATH read-write, like
+   svn_io_set_file_read_write().  If it is a hard link, e.g. to its pristine
+   (see the link-pristines option), replace it with a copy first.
+
+   Use SCRATCH_POOL for any temporary allocations.
+ */
+svn_error_t *
+svn_wc__set_file_read_write(const char *local_abspath,
+                            apr_pool_t *scratch_pool);
+
 /* Internal version of svn_wc_translated_stream2(), which see. */
 svn_error_t *
 svn_wc__internal_translated_stream(svn_stream_t **stream,
@@ -434,6 +434,11 @@ struct handler_baton
   /* A calculated SHA-1 of NEW_TEXT_BASE_TMP_ABSPATH, which we'll use for
      eventually writing the pristine. */
   svn_checksum_t * new_text_base_sha1_checksum;
+
+  /* Whether to write a copy of the new text for the working file while
+     writing the pristine, and where it is being written. */
+  svn_boolean_t write_working_copy;
+  const char *working_copy_abspath;
 };
 
 
@@ -743,6 +748,10 @@ struct file_baton
   const svn_checksum_t *new_text_base_md5_checksum;
   const svn_checksum_t *new_text_base_sha1_checksum;
 
+  /* If not NULL, a temporary file with the new text base, written along
+     with the pristine to become the working file of an added file. */
+  const char *new_text_working_copy_abspath;
+
   /* The checksum of the file before the update */
   const svn_checksum_t *original_checksum;
 
@@ -1014,6 +1023,9 @@ window_handler(svn_txdelta_window_t *window, void *baton)
           svn_error_clear(svn_wc__db_pristine_install_abort(hb->install_data,
                                                             hb->pool));
         }
+      if (hb->working_copy_abspath)
+        svn_error_clear(svn_io_remove_file2(hb->working_copy_abspath, TRUE,
+                                            hb->pool));
     }
   else
     {
@@ -1026,10 +1038,21 @@ window_handler(svn_txdelta_window_t *window, void *baton)
       /* Store the new pristine text in the pristine store now.  Later, in a
          single transaction we will update the BASE_NODE to include a
          reference to this pristine text's checksum. */
-      SVN_ERR(svn_wc__db_pristine_install(hb->install_data,
-                                          fb->new_text_base_sha1_checksum,
-                                          fb->new_text_base_md5_checksum,
-                                          hb->pool));
+      err = svn_wc__db_pristine_install(hb->install_data,
+                                        fb->new_text_base_sha1_checksum,
+                                        fb->new_text_base_md5_checksum,
+                                        hb->pool);
+
+      if (hb->working_copy_abspath)
+        {
+          if (err)
+            svn_error_clear(svn_io_remove_file2(hb->working_copy_abspath,
+                                                TRUE, hb->pool));
+          else
+            fb->new_text_working_copy_abspath
+              = apr_pstrdup(fb->pool, hb->working_copy_abspath);
+        }
+      SVN_ERR(err);
     }
 
   svn_pool_destroy(hb->pool);
@@ -3603,9 +3626,62 @@ lazy_open_target(svn_stream_t **stream,
 
   hb->install_data = install_data;
 
+  if (hb->write_working_copy)
+    {
+      svn_wc__db_t *db = hb->fb->edit_baton->db;
+      const char *tmpdir_abspath;
+      svn_stream_t *working_stream;
+
+      /* Write the working file in the same pass; its install will then
+         just move it into place.  Writing to the working copy's temporary
+         area keeps that move on one file system. */
+      SVN_ERR(svn_wc__db_temp_wcroot_tempdir(&tmpdir_abspath, db,
+                                             hb->fb->dir_baton->local_abspath,
+                                             scratch_pool, scratch_pool));
+      SVN_ERR(svn_stream_open_unique(&working_stream,
+                                     &hb->working_copy_abspath,
+                                     tmpdir_abspath, svn_io_file_del_none,
+                                     result_pool, scratch_pool));
+
+      *stream = svn_stream_tee(*stream, working_stream, result_pool);
+    }
+
   return SVN_NO_ERROR;
 }
 
+/* Return TRUE if the working file of the file in FB is likely to be
+   installed straight from its new pristine text, based on the property
+   changes received so far. */
+static svn_boolean_t
+install_untranslated_p(const struct file_baton *fb)
+{
+  int i;
+
+  if (!fb->adding_file || fb->add_existed || fb->shadowed
+      || fb->obstruction_found || fb->edit_obstructed)
+    return FALSE;
+
+  for (i = 0; i < fb->propchanges->nelts; i++)
+    {
+      const svn_prop_t *prop = &APR_ARRAY_IDX(fb->propchanges, i, svn_prop_t);
+
+      if (!prop->value)
+        continue;
+
+      if (!strcmp(prop->name, SVN_PROP_EOL_STYLE)
+          || !strcmp(prop->name, SVN_PROP_KEYWORDS)
+          || !strcmp(prop->name, SVN_PROP_SPECIAL))
+        return FALSE;
+
+      /* Read-only files may rather become hard links to their pristine. */
+      if (!strcmp(prop->name, SVN_PROP_NEEDS_LOCK)
+          && svn_wc__db_get_link_pristines(fb->edit_baton->db))
+        return FALSE;
+    }
+
+  return TRUE;
+}
+
 /* An svn_delta_editor_t function. */
 static svn_error_t *
 apply_textdelta(void *file_baton,
@@ -3714,6 +3790,7 @@ apply_textdelta(void *file_baton,
       hb->source_checksum_stream = source;
     }
 
+  hb->write_working_copy = install_untranslated_p(fb);
   target = svn_stream_lazyopen_create(lazy_open_target, hb, TRUE, handler_pool);
 
   /* Prepare to apply the delta.  */
@@ -4430,13 +4507,31 @@ close_file(void *file_baton,
              safety's sake).  */
           record_fileinfo = (install_from == NULL);
 
-          SVN_ERR(svn_wc__wq_build_file_install(&work_item,
+          if (install_from == NULL && fb->new_text_working_copy_abspath)
+            {
+              /* We already have the pristine contents as a temporary file,
+                 so install from that, and remove it afterwards if it
+                 wasn't moved into place. */
+              install_from = fb->new_text_working_copy_abspath;
+              fb->new_text_working_copy_abspath = NULL;
+
+              SVN_ERR(svn_wc__wq_build_file_install_from_copy(
+                                                &work_item,
                                                 eb->db,
                                                 fb->local_abspath,
                                                 install_from,
                                                 eb->use_commit_times,
-                                                record_fileinfo,
                                                 scratch_pool, scratch_pool));
+            }
+          else
+            SVN_ERR(svn_wc__wq_build_file_install(&work_item,
+                                                  eb->db,
+                                                  fb->local_abspath,
+                                                  install_from,
+                                                  eb->use_commit_times,
+                                                  record_fileinfo,
+                                                  scratch_pool,
+                                                  scratch_pool));
           all_work_items = svn_wc__wq_merge(all_work_items, work_item,
                                             scratch_pool);
         }
@@ -4507,6 +4602,11 @@ close_file(void *file_baton,
         content_state = svn_wc_notify_state_unchanged;
     }
 
+  /* The copy of the new text wasn't needed after all. */
+  if (fb->new_text_working_copy_abspath)
+    SVN_ERR(svn_io_remove_file2(fb->new_text_working_copy_abspath, TRUE,
+                                scratch_pool));
+
   /* Insert/replace the BASE node with all of the new metadata.  */
 
   /* Set the 'checksum' column of the file's BASE_NODE row to
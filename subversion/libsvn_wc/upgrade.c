@@ -41,6 +41,7 @@
 
 #include "svn_private_config.h"
 #include "private/svn_wc_private.h"
+#include "private/svn_io_private.h"
 #include "private/svn_sqlite.h"
 #include "private/svn_token.h"
 
@@ -1057,13 +1058,11 @@ migrate_text_bases(apr_hash_t **text_bases_info,
         SVN_ERR(svn_stream_open_readonly(&read_stream, text_base_path,
                                            iterpool, iterpool));
 
-        read_stream = svn_stream_checksummed2(read_stream, &md5_checksum,
-                                              NULL, svn_checksum_md5,
-                                              TRUE, iterpool);
-
-        read_stream = svn_stream_checksummed2(read_stream, &sha1_checksum,
-                                              NULL, svn_checksum_sha1,
-                                              TRUE, iterpool);
+        read_stream = svn_stream__checksummed_md5_sha1(read_stream,
+                                                       &md5_checksum,
+                                                       &sha1_checksum,
+                                                       NULL, NULL,
+                                                       TRUE, iterpool);
 
         /* This calculates the hash, creates a copy and closes the stream */
         SVN_ERR(svn_stream_copy3(read_stream, result_stream,
@@ -1696,9 +1695,15 @@ svn_wc__upgrade_sdb(int *result_format,
         /* FALLTHROUGH  */
 #endif
       case SVN_WC__VERSION:
+      case SVN_WC__STORE_PRISTINE_VERSION:
         /* already upgraded */
-        *result_format = SVN_WC__VERSION;
+        *result_format = start_format;
 
+        /* Also done for working copies that already have the current
+           format, e.g. to add the optional indexes. */
+        SVN_SQLITE__WITH_LOCK(
+            svn_wc__db_install_children_info_indexes(sdb, scratch_pool),
+            sdb);
         SVN_SQLITE__WITH_LOCK(
             svn_wc__db_install_schema_statistics(sdb, scratch_pool),
             sdb);
@@ -1933,7 +1938,7 @@ svn_wc_upgrade(svn_wc_context_t *wc_ctx,
       /* Auto-upgrade worked! */
       SVN_ERR(svn_wc__db_close(db));
 
-      SVN_ERR_ASSERT(result_format == SVN_WC__VERSION);
+      SVN_ERR_ASSERT(SVN_WC__IS_CURRENT_FORMAT(result_format));
 
       if (bumped_format && notify_func)
         {
@@ -600,6 +600,9 @@ INSERT INTO sqlite_stat1(tbl, idx, stat) VALUES
     ('NODES', 'sqlite_autoindex_NODES_1',               '8000 8000 2 1');
 INSERT INTO sqlite_stat1(tbl, idx, stat) VALUES
     ('NODES', 'I_NODES_PARENT',                         '8000 8000 10 2 1');
+INSERT INTO sqlite_stat1(tbl, idx, stat) VALUES
+    ('NODES', 'I_NODES_CHILDREN_INFO',
+     '8000 8000 10 2 1 1 1 1 1 1 1 1 1 1 1 1 1 1 1 1 1 1');
 /* Tell a lie: We ignore that 99.9% of all moved_to values are NULL */
 INSERT INTO sqlite_stat1(tbl, idx, stat) VALUES
     ('NODES', 'I_NODES_MOVED',                          '8000 8000 1 1');
@@ -608,6 +611,8 @@ INSERT INTO sqlite_stat1(tbl, idx, stat) VALUES
     ('ACTUAL_NODE', 'sqlite_autoindex_ACTUAL_NODE_1',   '8000 8000 1');
 INSERT INTO sqlite_stat1(tbl, idx, stat) VALUES
     ('ACTUAL_NODE', 'I_ACTUAL_PARENT',                  '8000 8000 10 1');
+INSERT INTO sqlite_stat1(tbl, idx, stat) VALUES
+    ('ACTUAL_NODE', 'I_ACTUAL_CHILDREN_INFO',           '8000 8000 10 1 1 1 1');
 
 INSERT INTO sqlite_stat1(tbl, idx, stat) VALUES
     ('LOCK', 'sqlite_autoindex_LOCK_1',                 '100 100 1');
@@ -624,6 +629,32 @@ INSERT INTO sqlite_stat1(tbl, idx, stat) VALUES
    a INTEGER PRIMARY KEY AUTOINCREMENT table */
 
 ANALYZE sqlite_master; /* Loads sqlite_stat1 data for query optimizer */
+
+/* ------------------------------------------------------------------------- */
+/* Covering indexes for reading the children of a directory, as done for
+   every directory by status and info.  They contain all columns used by
+   STMT_SELECT_NODE_CHILDREN_INFO, STMT_SELECT_BASE_NODE_CHILDREN_INFO,
+   STMT_SELECT_NODE_CHILDREN_WALKER_INFO and
+   STMT_SELECT_ACTUAL_CHILDREN_INFO, so these become a single range
+   scan of the index instead of an index scan plus a table lookup per row.
+
+   In effect, I_NODES_CHILDREN_INFO is a copy of the NODES table grouped
+   by directory.  SQLite keeps it up to date on every write, including
+   those of clients that don't know about it, so this doesn't need a
+   format bump.  It is created for new working copies and by 'svn upgrade'.
+ */
+-- STMT_CREATE_CHILDREN_INFO_INDEXES
+CREATE INDEX IF NOT EXISTS I_NODES_CHILDREN_INFO
+ON NODES (wc_id, parent_relpath, local_relpath, op_depth, presence, kind,
+          revision, repos_id, repos_path, checksum, translated_size,
+          changed_revision, changed_date, changed_author, depth,
+          symlink_target, last_mod_time, properties, moved_here, moved_to,
+          file_external);
+
+CREATE INDEX IF NOT EXISTS I_ACTUAL_CHILDREN_INFO
+ON ACTUAL_NODE (wc_id, parent_relpath, local_relpath, changelist,
+                properties, conflict_data);
+
 /* ------------------------------------------------------------------------- */
 
 /* Format 30 creates a new NODES index for move information, and a new
@@ -699,9 +730,11 @@ WHERE l.op_depth = 0
 
 
 /* ------------------------------------------------------------------------- */
-/* Format 32 ....  */
-/* -- STMT_UPGRADE_TO_32
-PRAGMA user_version = 32; */
+/* Format 32 has the schema of format 31.  It marks working copies that
+   don't store all pristine texts, such that older clients refuse to open
+   them.  See svn_wc__db_set_store_pristine(). */
+-- STMT_UPGRADE_TO_32
+PRAGMA user_version = 32;
 
 
 /* ------------------------------------------------------------------------- */
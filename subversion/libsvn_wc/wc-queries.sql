@@ -163,6 +163,32 @@ LEFT OUTER JOIN lock ON nodes.repos_id = lock.repos_id
 WHERE wc_id = ?1 AND parent_relpath = ?2 AND op_depth = 0
 ORDER BY local_relpath DESC
 
+-- STMT_SELECT_NODE_SUBTREE_INFO
+/* Like STMT_SELECT_NODE_CHILDREN_INFO, but for all descendants of ?2.
+   All rows of a node are still returned together and in the same
+   per-node order. */
+SELECT op_depth, nodes.repos_id, nodes.repos_path, presence, kind, revision,
+  checksum, translated_size, changed_revision, changed_date, changed_author,
+  depth, symlink_target, last_mod_time, properties, lock_token, lock_owner,
+  lock_comment, lock_date, local_relpath, moved_here, moved_to, file_external
+FROM nodes
+LEFT OUTER JOIN lock ON nodes.repos_id = lock.repos_id
+  AND nodes.repos_path = lock.repos_relpath AND nodes.op_depth = 0
+WHERE wc_id = ?1 AND IS_STRICT_DESCENDANT_OF(local_relpath, ?2)
+ORDER BY local_relpath DESC, op_depth DESC
+
+-- STMT_SELECT_BASE_NODE_SUBTREE_INFO
+SELECT op_depth, nodes.repos_id, nodes.repos_path, presence, kind, revision,
+  checksum, translated_size, changed_revision, changed_date, changed_author,
+  depth, symlink_target, last_mod_time, properties, lock_token, lock_owner,
+  lock_comment, lock_date, local_relpath, moved_here, moved_to, file_external
+FROM nodes
+LEFT OUTER JOIN lock ON nodes.repos_id = lock.repos_id
+  AND nodes.repos_path = lock.repos_relpath
+WHERE wc_id = ?1 AND IS_STRICT_DESCENDANT_OF(local_relpath, ?2)
+  AND op_depth = 0
+ORDER BY local_relpath DESC
+
 -- STMT_SELECT_NODE_CHILDREN_WALKER_INFO
 SELECT local_relpath, op_depth, presence, kind
 FROM nodes_current
@@ -174,6 +200,11 @@ SELECT local_relpath, changelist, properties, conflict_data
 FROM actual_node
 WHERE wc_id = ?1 AND parent_relpath = ?2
 
+-- STMT_SELECT_ACTUAL_SUBTREE_INFO
+SELECT local_relpath, changelist, properties, conflict_data
+FROM actual_node
+WHERE wc_id = ?1 AND IS_STRICT_DESCENDANT_OF(local_relpath, ?2)
+
 -- STMT_SELECT_REPOSITORY_BY_ID
 SELECT root, uuid FROM repository WHERE id = ?1
 
@@ -883,6 +914,12 @@ SELECT id, work FROM work_queue ORDER BY id LIMIT 1
 -- STMT_DELETE_WORK_ITEM
 DELETE FROM work_queue WHERE id = ?1
 
+-- STMT_SELECT_WORK_ITEMS
+SELECT id, work FROM work_queue ORDER BY id LIMIT ?1
+
+-- STMT_DELETE_WORK_ITEMS_UP_TO
+DELETE FROM work_queue WHERE id <= ?1
+
 -- STMT_INSERT_OR_IGNORE_PRISTINE
 INSERT OR IGNORE INTO pristine (checksum, md5_checksum, size, refcount)
 VALUES (?1, ?2, ?3, 0)
@@ -911,10 +948,27 @@ SELECT checksum
 FROM pristine
 WHERE refcount = 0
 
+-- STMT_DELETE_UNREFERENCED_PRISTINES
+DELETE FROM pristine
+WHERE refcount = 0
+
 -- STMT_DELETE_PRISTINE_IF_UNREFERENCED
 DELETE FROM pristine
 WHERE checksum = ?1 AND refcount = 0
 
+-- STMT_SELECT_PRISTINE_LOCATION
+/* Find a repository location from which the pristine text ?2 can be
+   fetched again.  Any node referencing the text will do. */
+SELECT r.root, n.repos_path, n.revision
+FROM nodes n
+JOIN repository r ON n.repos_id = r.id
+WHERE n.wc_id = ?1
+  AND n.checksum = ?2
+  AND n.repos_path IS NOT NULL
+  AND n.revision IS NOT NULL
+  AND presence in (MAP_NORMAL, MAP_INCOMPLETE)
+LIMIT 1
+
 -- STMT_SELECT_COPY_PRISTINES
 /* For the root itself */
 SELECT n.checksum, md5_checksum, size
@@ -1153,6 +1207,66 @@ SELECT wc_id, ?3 /*local_relpath*/, ?4 /*op_depth*/, ?5 /*parent_relpath*/,
 FROM nodes
 WHERE wc_id = ?1 AND local_relpath = ?2 AND op_depth = ?7
 
+/* Find a descendant of ?2 that svn_wc__db_op_copy_tree() can't copy with
+   STMT_INSERT_WORKING_SUBTREE_COPY_FROM: a node with a working layer above
+   op-depth ?3, anything at ?3 that is not present, a file external, switched
+   or at another revision than ?2 (which is at repos_id ?4, repos_path ?5 and
+   revision ?6), or a conflict. */
+-- STMT_SELECT_COPY_TREE_OBSTRUCTION
+SELECT local_relpath FROM nodes
+WHERE wc_id = ?1 AND IS_STRICT_DESCENDANT_OF(local_relpath, ?2)
+  AND (op_depth > ?3
+       OR (op_depth = ?3
+           AND (presence != MAP_NORMAL
+                OR file_external IS NOT NULL
+                OR moved_to IS NOT NULL
+                OR repos_id IS NOT ?4
+                OR revision IS NOT ?6
+                OR repos_path
+                     IS NOT RELPATH_SKIP_JOIN(?2, ?5, local_relpath))))
+UNION ALL
+SELECT local_relpath FROM actual_node
+WHERE wc_id = ?1 AND IS_STRICT_DESCENDANT_OF(local_relpath, ?2)
+  AND conflict_data IS NOT NULL
+LIMIT 1
+
+/* Copy all descendants of ?2 at op-depth ?4 below ?3 at op-depth ?5, like
+   STMT_INSERT_WORKING_NODE_COPY_FROM does for a single node. */
+-- STMT_INSERT_WORKING_SUBTREE_COPY_FROM
+INSERT OR REPLACE INTO nodes (
+    wc_id, local_relpath, op_depth, parent_relpath, repos_id,
+    repos_path, revision, presence, depth, moved_here, kind, changed_revision,
+    changed_date, changed_author, checksum, properties, translated_size,
+    last_mod_time, symlink_target, moved_to )
+SELECT s.wc_id, RELPATH_SKIP_JOIN(?2, ?3, s.local_relpath), ?5 /*op_depth*/,
+    RELPATH_SKIP_JOIN(?2, ?3, s.parent_relpath),
+    s.repos_id, s.repos_path, s.revision, MAP_NORMAL, s.depth,
+    CASE WHEN ?6 THEN 1 WHEN ?7 THEN s.moved_here END /*moved_here*/,
+    s.kind, s.changed_revision, s.changed_date,
+    s.changed_author, s.checksum, s.properties, s.translated_size,
+    s.last_mod_time, s.symlink_target,
+    (SELECT dst.moved_to FROM nodes AS dst
+                         WHERE dst.wc_id = ?1
+                         AND dst.local_relpath
+                                = RELPATH_SKIP_JOIN(?2, ?3, s.local_relpath)
+                         AND dst.op_depth > 0
+                         ORDER BY dst.op_depth DESC LIMIT 1)
+FROM nodes s
+WHERE s.wc_id = ?1 AND IS_STRICT_DESCENDANT_OF(s.local_relpath, ?2)
+  AND s.op_depth = ?4
+
+-- STMT_INSERT_ACTUAL_SUBTREE_COPY
+INSERT OR REPLACE INTO actual_node (
+  wc_id, local_relpath, parent_relpath, properties, changelist)
+SELECT a.wc_id, RELPATH_SKIP_JOIN(?2, ?3, a.local_relpath),
+  RELPATH_SKIP_JOIN(?2, ?3, a.parent_relpath), a.properties, a.changelist
+FROM actual_node a
+WHERE a.wc_id = ?1 AND IS_STRICT_DESCENDANT_OF(a.local_relpath, ?2)
+  AND (a.properties IS NOT NULL OR a.changelist IS NOT NULL)
+  AND EXISTS(SELECT 1 FROM nodes n
+             WHERE n.wc_id = ?1 AND n.local_relpath = a.local_relpath
+               AND n.op_depth = ?4)
+
 -- STMT_UPDATE_BASE_REVISION
 UPDATE nodes SET revision = ?3
 WHERE wc_id = ?1 AND local_relpath = ?2 AND op_depth = 0
@@ -1796,6 +1910,29 @@ WHERE wc_id = ?1
 SELECT 1 FROM sqlite_master WHERE name='sqlite_stat1' AND type='table'
 LIMIT 1
 
+/* The SETTINGS table holds per-WC options that must stay with the working
+   copy rather than with the client configuration.  It is only created once
+   such an option is set, so older clients never see it. */
+-- STMT_CREATE_SETTINGS
+CREATE TABLE IF NOT EXISTS SETTINGS (
+  wc_id  INTEGER NOT NULL REFERENCES WCROOT (id),
+  name  TEXT NOT NULL,
+  value,
+  PRIMARY KEY (wc_id, name)
+  );
+
+-- STMT_HAVE_SETTINGS_TABLE
+SELECT 1 FROM sqlite_master WHERE name='SETTINGS' AND type='table'
+LIMIT 1
+
+-- STMT_SELECT_SETTING
+SELECT value FROM settings
+WHERE wc_id = ?1 AND name = ?2
+
+-- STMT_INSERT_OR_REPLACE_SETTING
+INSERT OR REPLACE INTO settings (wc_id, name, value)
+VALUES (?1, ?2, ?3)
+
 /* ------------------------------------------------------------------------- */
 
 /* Grab all the statements related to the schema.  */
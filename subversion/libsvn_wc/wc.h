@@ -161,11 +161,24 @@ extern "C" {
  * == 1.9.x shipped with format 31
  * == 1.10.x shipped with format 31
  *
+ * Format 32 marks working copies that don't store all pristine texts
+ * (the store-pristine option).  The schema is that of format 31, but
+ * older clients must not open such working copies and take the missing
+ * texts for corruption.  All other working copies stay at format 31.
+ *
  * Please document any further format changes here.
  */
 
 #define SVN_WC__VERSION 31
 
+/* The format of working copies that fetch pristine texts on demand.
+   Also understood by this client, see SVN_WC__IS_CURRENT_FORMAT. */
+#define SVN_WC__STORE_PRISTINE_VERSION 32
+
+/* Return TRUE if FORMAT is usable without upgrading it.  */
+#define SVN_WC__IS_CURRENT_FORMAT(format) \
+  ((format) == SVN_WC__VERSION || (format) == SVN_WC__STORE_PRISTINE_VERSION)
+
 
 /* Formats <= this have no concept of "revert text-base/props".  */
 #define SVN_WC__NO_REVERT_FILES 4
@@ -1352,6 +1352,16 @@ svn_wc__db_install_schema_statistics(svn_sqlite__db_t *sdb,
   return SVN_NO_ERROR;
 }
 
+svn_error_t *
+svn_wc__db_install_children_info_indexes(svn_sqlite__db_t *sdb,
+                                         apr_pool_t *scratch_pool)
+{
+  SVN_ERR(svn_sqlite__exec_statements(sdb,
+                                      STMT_CREATE_CHILDREN_INFO_INDEXES));
+
+  return SVN_NO_ERROR;
+}
+
 /* Helper for create_db(). Initializes our wc.db schema.
  */
 static svn_error_t *
@@ -1372,6 +1382,7 @@ init_db(/* output values */
   /* Create the database's schema.  */
   SVN_ERR(svn_sqlite__exec_statements(db, STMT_CREATE_SCHEMA));
 
+  SVN_ERR(svn_wc__db_install_children_info_indexes(db, scratch_pool));
   SVN_ERR(svn_wc__db_install_schema_statistics(db, scratch_pool));
 
   /* Insert the repository. */
@@ -1523,6 +1534,10 @@ svn_wc__db_init(svn_wc__db_t *db,
   /* The WCROOT is complete. Stash it into DB.  */
   svn_hash_sets(db->dir_data, wcroot->abspath, wcroot);
 
+  if (! db->store_pristine)
+    SVN_ERR(svn_wc__db_set_store_pristine(db, wcroot->abspath, FALSE,
+                                          scratch_pool));
+
   return SVN_NO_ERROR;
 }
 
@@ -4857,6 +4872,136 @@ svn_wc__db_op_copy(svn_wc__db_t *db,
   return SVN_NO_ERROR;
 }
 
+/* The body of svn_wc__db_op_copy_tree(). */
+static svn_error_t *
+op_copy_tree_txn(svn_boolean_t *copied,
+                 svn_wc__db_wcroot_t *wcroot,
+                 struct op_copy_baton *ocb,
+                 apr_pool_t *scratch_pool)
+{
+  svn_sqlite__stmt_t *stmt;
+  svn_boolean_t have_row;
+  int src_op_depth;
+  int dst_op_depth;
+  apr_int64_t repos_id;
+  const char *repos_relpath;
+  svn_revnum_t revision;
+  svn_boolean_t moved_here;
+  int move_op_depth;
+
+  *copied = FALSE;
+
+  /* Only an unchanged, present directory layer can be copied in one go. */
+  SVN_ERR(svn_sqlite__get_statement(&stmt, wcroot->sdb,
+                                    STMT_SELECT_NODE_INFO));
+  SVN_ERR(svn_sqlite__bindf(stmt, "is", wcroot->wc_id, ocb->src_relpath));
+  SVN_ERR(svn_sqlite__step(&have_row, stmt));
+  if (!have_row
+      || svn_sqlite__column_token(stmt, 3, presence_map)
+                                        != svn_wc__db_status_normal
+      || svn_sqlite__column_token(stmt, 4, kind_map) != svn_node_dir
+      || svn_sqlite__column_is_null(stmt, 2))
+    return svn_error_trace(svn_sqlite__reset(stmt));
+
+  src_op_depth = svn_sqlite__column_int(stmt, 0);
+  repos_id = svn_sqlite__column_int64(stmt, 1);
+  repos_relpath = svn_sqlite__column_text(stmt, 2, scratch_pool);
+  revision = svn_sqlite__column_revnum(stmt, 5);
+  SVN_ERR(svn_sqlite__reset(stmt));
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, wcroot->sdb,
+                                    STMT_SELECT_COPY_TREE_OBSTRUCTION));
+  SVN_ERR(svn_sqlite__bindf(stmt, "isdisr", wcroot->wc_id, ocb->src_relpath,
+                            src_op_depth, repos_id, repos_relpath,
+                            revision));
+  SVN_ERR(svn_sqlite__step(&have_row, stmt));
+  SVN_ERR(svn_sqlite__reset(stmt));
+  if (have_row)
+    return SVN_NO_ERROR;
+
+  if (ocb->is_move)
+    move_op_depth = relpath_depth(ocb->dst_op_root_relpath);
+  else
+    move_op_depth = 0;
+
+  /* Copy the root like svn_wc__db_op_copy() does.  Its descendants are all
+     part of the same operation, so they get the same op-depth and, when
+     moving, the moved-here decision made for the root. */
+  SVN_ERR(db_op_copy(wcroot, ocb->src_relpath, wcroot, ocb->dst_relpath,
+                     ocb->work_items, move_op_depth, scratch_pool));
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, wcroot->sdb,
+                                    STMT_SELECT_NODE_INFO));
+  SVN_ERR(svn_sqlite__bindf(stmt, "is", wcroot->wc_id, ocb->dst_relpath));
+  SVN_ERR(svn_sqlite__step_row(stmt));
+  dst_op_depth = svn_sqlite__column_int(stmt, 0);
+  moved_here = svn_sqlite__column_boolean(stmt, 15);
+  SVN_ERR(svn_sqlite__reset(stmt));
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, wcroot->sdb,
+                                    STMT_INSERT_WORKING_SUBTREE_COPY_FROM));
+  SVN_ERR(svn_sqlite__bindf(stmt, "issdddd", wcroot->wc_id, ocb->src_relpath,
+                            ocb->dst_relpath, src_op_depth, dst_op_depth,
+                            moved_here, (move_op_depth > 0)));
+  SVN_ERR(svn_sqlite__step_done(stmt));
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, wcroot->sdb,
+                                    STMT_INSERT_ACTUAL_SUBTREE_COPY));
+  SVN_ERR(svn_sqlite__bindf(stmt, "issd", wcroot->wc_id, ocb->src_relpath,
+                            ocb->dst_relpath, src_op_depth));
+  SVN_ERR(svn_sqlite__step_done(stmt));
+
+  *copied = TRUE;
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_wc__db_op_copy_tree(svn_boolean_t *copied,
+                        svn_wc__db_t *db,
+                        const char *src_abspath,
+                        const char *dst_abspath,
+                        const char *dst_op_root_abspath,
+                        svn_boolean_t is_move,
+                        const svn_skel_t *work_items,
+                        apr_pool_t *scratch_pool)
+{
+  struct op_copy_baton ocb = {0};
+
+  SVN_ERR_ASSERT(svn_dirent_is_absolute(src_abspath));
+  SVN_ERR_ASSERT(svn_dirent_is_absolute(dst_abspath));
+  SVN_ERR_ASSERT(svn_dirent_is_absolute(dst_op_root_abspath));
+
+  SVN_ERR(svn_wc__db_wcroot_parse_local_abspath(&ocb.src_wcroot,
+                                                &ocb.src_relpath, db,
+                                                src_abspath,
+                                                scratch_pool, scratch_pool));
+  VERIFY_USABLE_WCROOT(ocb.src_wcroot);
+
+  SVN_ERR(svn_wc__db_wcroot_parse_local_abspath(&ocb.dst_wcroot,
+                                                &ocb.dst_relpath,
+                                                db, dst_abspath,
+                                                scratch_pool, scratch_pool));
+  VERIFY_USABLE_WCROOT(ocb.dst_wcroot);
+
+  /* The subtree statements work within a single database. */
+  if (ocb.src_wcroot != ocb.dst_wcroot)
+    {
+      *copied = FALSE;
+      return SVN_NO_ERROR;
+    }
+
+  ocb.work_items = work_items;
+  ocb.is_move = is_move;
+  ocb.dst_op_root_relpath = svn_dirent_skip_ancestor(ocb.dst_wcroot->abspath,
+                                                     dst_op_root_abspath);
+
+  SVN_WC__DB_WITH_TXN(op_copy_tree_txn(copied, ocb.src_wcroot, &ocb,
+                                       scratch_pool),
+                      ocb.src_wcroot);
+
+  return SVN_NO_ERROR;
+}
+
 /* Remove unneeded actual nodes for svn_wc__db_op_copy_layer_internal */
 static svn_error_t *
 clear_or_remove_actual(svn_wc__db_wcroot_t *wcroot,
@@ -6234,6 +6379,81 @@ svn_wc__db_op_set_props(svn_wc__db_t *db,
   return SVN_NO_ERROR;
 }
 
+/* The body of svn_wc__db_op_set_props_many().  Call set_props_txn() for
+   each LOCAL_RELPATHS[i], PROPS[i]. */
+static svn_error_t *
+set_props_many_txn(svn_wc__db_wcroot_t *wcroot,
+                   const apr_array_header_t *local_relpaths,
+                   const apr_array_header_t *props,
+                   apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  int i;
+
+  for (i = 0; i < local_relpaths->nelts; i++)
+    {
+      svn_pool_clear(iterpool);
+      SVN_ERR(set_props_txn(wcroot,
+                            APR_ARRAY_IDX(local_relpaths, i, const char *),
+                            APR_ARRAY_IDX(props, i, apr_hash_t *),
+                            FALSE, NULL, NULL, iterpool));
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_wc__db_op_set_props_many(svn_wc__db_t *db,
+                             const apr_array_header_t *targets,
+                             const apr_array_header_t *props,
+                             apr_pool_t *scratch_pool)
+{
+  svn_wc__db_wcroot_t *wcroot;
+  const char *local_relpath;
+  apr_array_header_t *local_relpaths;
+  int i;
+
+  SVN_ERR_ASSERT(targets->nelts == props->nelts);
+  if (targets->nelts == 0)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_wc__db_wcroot_parse_local_abspath(&wcroot, &local_relpath,
+                                                db,
+                                                APR_ARRAY_IDX(targets, 0,
+                                                              const char *),
+                                                scratch_pool, scratch_pool));
+  VERIFY_USABLE_WCROOT(wcroot);
+
+  local_relpaths = apr_array_make(scratch_pool, targets->nelts,
+                                  sizeof(const char *));
+  for (i = 0; i < targets->nelts; i++)
+    {
+      const char *local_abspath = APR_ARRAY_IDX(targets, i, const char *);
+      svn_wc__db_wcroot_t *target_wcroot;
+
+      SVN_ERR_ASSERT(svn_dirent_is_absolute(local_abspath));
+      SVN_ERR(svn_wc__db_wcroot_parse_local_abspath(&target_wcroot,
+                                                    &local_relpath, db,
+                                                    local_abspath,
+                                                    scratch_pool,
+                                                    scratch_pool));
+      VERIFY_USABLE_WCROOT(target_wcroot);
+
+      /* Assert that all targets are within the same working copy. */
+      SVN_ERR_ASSERT(strcmp(wcroot->abspath, target_wcroot->abspath) == 0);
+
+      APR_ARRAY_PUSH(local_relpaths, const char *) = local_relpath;
+    }
+
+  SVN_WC__DB_WITH_TXN(set_props_many_txn(wcroot, local_relpaths, props,
+                                         scratch_pool),
+                      wcroot);
+
+  return SVN_NO_ERROR;
+}
+
 
 svn_error_t *
 svn_wc__db_op_modified(svn_wc__db_t *db,
@@ -9271,27 +9491,97 @@ struct read_children_info_item_t
   svn_boolean_t was_dir;
 };
 
-/* Implementation of svn_wc__db_read_children_info */
+/* State of read_children_info() while reading a whole subtree. */
+struct read_subtree_baton_t
+{
+  /* Relpath below the subtree root -> svn_wc__db_children_info_t * */
+  apr_hash_t *dirs;
+
+  /* Stop after this many node rows and set OVERFLOWED. */
+  int max_rows;
+  svn_boolean_t overflowed;
+
+  /* The directory we found the last child in; siblings tend to come
+     in runs. */
+  const char *last_parent_relpath;
+  svn_wc__db_children_info_t *last_dir;
+};
+
+/* Set *NODES and *CONFLICTS to the hashes of SB for the parent directory
+   of CHILD_RELPATH, a strict descendant of DIR_RELPATH, creating them in
+   RESULT_POOL if necessary. */
+static void
+get_subtree_dir(apr_hash_t **nodes,
+                apr_hash_t **conflicts,
+                struct read_subtree_baton_t *sb,
+                const char *dir_relpath,
+                const char *child_relpath,
+                apr_pool_t *result_pool)
+{
+  const char *name = svn_relpath_basename(child_relpath, NULL);
+  apr_size_t parent_len = (name == child_relpath)
+                          ? 0 : (name - child_relpath - 1);
+
+  if (!sb->last_dir
+      || strlen(sb->last_parent_relpath) != parent_len
+      || strncmp(sb->last_parent_relpath, child_relpath, parent_len))
+    {
+      const char *parent_relpath = apr_pstrmemdup(result_pool, child_relpath,
+                                                  parent_len);
+      const char *key = svn_relpath_skip_ancestor(dir_relpath,
+                                                  parent_relpath);
+      svn_wc__db_children_info_t *dir = svn_hash_gets(sb->dirs, key);
+
+      if (!dir)
+        {
+          dir = apr_palloc(result_pool, sizeof(*dir));
+          dir->nodes = apr_hash_make(result_pool);
+          dir->conflicts = apr_hash_make(result_pool);
+          svn_hash_sets(sb->dirs, key, dir);
+        }
+
+      sb->last_parent_relpath = parent_relpath;
+      sb->last_dir = dir;
+    }
+
+  *nodes = sb->last_dir->nodes;
+  *conflicts = sb->last_dir->conflicts;
+}
+
+/* Implementation of svn_wc__db_read_children_info and
+   svn_wc__db_read_subtree_info.
+
+   If SB is NULL, add the children of DIR_RELPATH to NODES and CONFLICTS.
+   Otherwise ignore NODES and CONFLICTS and add all descendants of
+   DIR_RELPATH to SB, per parent directory. */
 static svn_error_t *
 read_children_info(svn_wc__db_wcroot_t *wcroot,
                    const char *dir_relpath,
                    apr_hash_t *conflicts,
                    apr_hash_t *nodes,
+                   struct read_subtree_baton_t *sb,
                    svn_boolean_t base_tree_only,
                    apr_pool_t *result_pool,
                    apr_pool_t *scratch_pool)
 {
   svn_sqlite__stmt_t *stmt;
   svn_boolean_t have_row;
+  int rows = 0;
   const char *repos_root_url = NULL;
   const char *repos_uuid = NULL;
   apr_int64_t last_repos_id = INVALID_REPOS_ID;
   const char *last_repos_root_url = NULL;
 
-  SVN_ERR(svn_sqlite__get_statement(&stmt, wcroot->sdb,
-                                    (base_tree_only
-                                     ? STMT_SELECT_BASE_NODE_CHILDREN_INFO
-                                     : STMT_SELECT_NODE_CHILDREN_INFO)));
+  if (sb)
+    SVN_ERR(svn_sqlite__get_statement(&stmt, wcroot->sdb,
+                                      (base_tree_only
+                                       ? STMT_SELECT_BASE_NODE_SUBTREE_INFO
+                                       : STMT_SELECT_NODE_SUBTREE_INFO)));
+  else
+    SVN_ERR(svn_sqlite__get_statement(&stmt, wcroot->sdb,
+                                      (base_tree_only
+                                       ? STMT_SELECT_BASE_NODE_CHILDREN_INFO
+                                       : STMT_SELECT_NODE_CHILDREN_INFO)));
   SVN_ERR(svn_sqlite__bindf(stmt, "is", wcroot->wc_id, dir_relpath));
   SVN_ERR(svn_sqlite__step(&have_row, stmt));
 
@@ -9306,6 +9596,18 @@ read_children_info(svn_wc__db_wcroot_t *wcroot,
       int op_depth;
       svn_boolean_t new_child;
 
+      if (sb)
+        {
+          if (++rows > sb->max_rows)
+            {
+              sb->overflowed = TRUE;
+              return svn_error_trace(svn_sqlite__reset(stmt));
+            }
+
+          get_subtree_dir(&nodes, &conflicts, sb, dir_relpath, child_relpath,
+                          result_pool);
+        }
+
       child_item = (base_tree_only ? NULL : svn_hash_gets(nodes, name));
       if (child_item)
         new_child = FALSE;
@@ -9518,7 +9820,8 @@ read_children_info(svn_wc__db_wcroot_t *wcroot,
   if (!base_tree_only)
     {
       SVN_ERR(svn_sqlite__get_statement(&stmt, wcroot->sdb,
-                                        STMT_SELECT_ACTUAL_CHILDREN_INFO));
+                                        sb ? STMT_SELECT_ACTUAL_SUBTREE_INFO
+                                           : STMT_SELECT_ACTUAL_CHILDREN_INFO));
       SVN_ERR(svn_sqlite__bindf(stmt, "is", wcroot->wc_id, dir_relpath));
       SVN_ERR(svn_sqlite__step(&have_row, stmt));
 
@@ -9529,6 +9832,10 @@ read_children_info(svn_wc__db_wcroot_t *wcroot,
           const char *child_relpath = svn_sqlite__column_text(stmt, 0, NULL);
           const char *name = svn_relpath_basename(child_relpath, NULL);
 
+          if (sb)
+            get_subtree_dir(&nodes, &conflicts, sb, dir_relpath,
+                            child_relpath, result_pool);
+
           child_item = svn_hash_gets(nodes, name);
           if (!child_item)
             {
@@ -9593,10 +9900,43 @@ svn_wc__db_read_children_info(apr_hash_t **nodes,
   VERIFY_USABLE_WCROOT(wcroot);
 
   SVN_WC__DB_WITH_TXN(
-    read_children_info(wcroot, dir_relpath, *conflicts, *nodes,
+    read_children_info(wcroot, dir_relpath, *conflicts, *nodes, NULL,
+                       base_tree_only, result_pool, scratch_pool),
+    wcroot);
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_wc__db_read_subtree_info(apr_hash_t **dirs,
+                             svn_wc__db_t *db,
+                             const char *dir_abspath,
+                             svn_boolean_t base_tree_only,
+                             int max_nodes,
+                             apr_pool_t *result_pool,
+                             apr_pool_t *scratch_pool)
+{
+  svn_wc__db_wcroot_t *wcroot;
+  const char *dir_relpath;
+  struct read_subtree_baton_t sb = { 0 };
+
+  SVN_ERR_ASSERT(svn_dirent_is_absolute(dir_abspath));
+
+  SVN_ERR(svn_wc__db_wcroot_parse_local_abspath(&wcroot, &dir_relpath, db,
+                                                dir_abspath,
+                                                scratch_pool, scratch_pool));
+  VERIFY_USABLE_WCROOT(wcroot);
+
+  sb.dirs = apr_hash_make(result_pool);
+  sb.max_rows = max_nodes;
+
+  SVN_WC__DB_WITH_TXN(
+    read_children_info(wcroot, dir_relpath, NULL, NULL, &sb,
                        base_tree_only, result_pool, scratch_pool),
     wcroot);
 
+  *dirs = sb.overflowed ? NULL : sb.dirs;
+
   return SVN_NO_ERROR;
 }
 
@@ -13596,6 +13936,88 @@ svn_wc__db_wq_record_and_fetch_next(apr_uint64_t *id,
   return SVN_NO_ERROR;
 }
 
+/* The body of svn_wc__db_wq_complete_and_fetch_batch().
+ */
+static svn_error_t *
+wq_complete_and_fetch_batch(apr_array_header_t **items,
+                            svn_wc__db_wcroot_t *wcroot,
+                            apr_uint64_t completed_id,
+                            apr_hash_t *record_map,
+                            int max_items,
+                            apr_pool_t *result_pool,
+                            apr_pool_t *scratch_pool)
+{
+  svn_sqlite__stmt_t *stmt;
+  svn_boolean_t have_row;
+
+  if (completed_id != 0)
+    {
+      SVN_ERR(svn_sqlite__get_statement(&stmt, wcroot->sdb,
+                                        STMT_DELETE_WORK_ITEMS_UP_TO));
+      SVN_ERR(svn_sqlite__bind_int64(stmt, 1, completed_id));
+
+      SVN_ERR(svn_sqlite__step_done(stmt));
+    }
+
+  if (record_map)
+    SVN_ERR(wq_record(wcroot, record_map, scratch_pool));
+
+  *items = apr_array_make(result_pool, 0, sizeof(svn_wc__db_wq_item_t *));
+  if (max_items <= 0)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, wcroot->sdb,
+                                    STMT_SELECT_WORK_ITEMS));
+  SVN_ERR(svn_sqlite__bind_int(stmt, 1, max_items));
+  SVN_ERR(svn_sqlite__step(&have_row, stmt));
+
+  while (have_row)
+    {
+      svn_wc__db_wq_item_t *item = apr_palloc(result_pool, sizeof(*item));
+      apr_size_t len;
+      const void *val;
+
+      item->id = svn_sqlite__column_int64(stmt, 0);
+
+      val = svn_sqlite__column_blob(stmt, 1, &len, result_pool);
+      item->work_item = svn_skel__parse(val, len, result_pool);
+
+      APR_ARRAY_PUSH(*items, svn_wc__db_wq_item_t *) = item;
+
+      SVN_ERR(svn_sqlite__step(&have_row, stmt));
+    }
+
+  return svn_error_trace(svn_sqlite__reset(stmt));
+}
+
+svn_error_t *
+svn_wc__db_wq_complete_and_fetch_batch(apr_array_header_t **items,
+                                       svn_wc__db_t *db,
+                                       const char *wri_abspath,
+                                       apr_uint64_t completed_id,
+                                       apr_hash_t *record_map,
+                                       int max_items,
+                                       apr_pool_t *result_pool,
+                                       apr_pool_t *scratch_pool)
+{
+  svn_wc__db_wcroot_t *wcroot;
+  const char *local_relpath;
+
+  SVN_ERR_ASSERT(items != NULL);
+  SVN_ERR_ASSERT(svn_dirent_is_absolute(wri_abspath));
+
+  SVN_ERR(svn_wc__db_wcroot_parse_local_abspath(&wcroot, &local_relpath, db,
+                              wri_abspath, scratch_pool, scratch_pool));
+  VERIFY_USABLE_WCROOT(wcroot);
+
+  SVN_WC__DB_WITH_TXN(
+    wq_complete_and_fetch_batch(items, wcroot, completed_id, record_map,
+                                max_items, result_pool, scratch_pool),
+    wcroot);
+
+  return SVN_NO_ERROR;
+}
+
 
 
 /* ### temporary API. remove before release.  */
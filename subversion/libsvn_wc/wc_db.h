@@ -269,6 +269,55 @@ svn_error_t *
 svn_wc__db_close(svn_wc__db_t *db);
 
 
+/* If DB was configured with SVN_CONFIG_OPTION_SQLITE_READ_SNAPSHOT,
+   make all following reads from the working copy containing LOCAL_ABSPATH
+   use a separate read-only connection that sees a single consistent
+   snapshot of the database, until the matching call of
+   svn_wc__db_end_read_snapshot().  Otherwise do nothing.
+
+   While the snapshot is active, any attempt to modify the working copy
+   database through DB fails and other clients can't modify it either.
+   Calls may be nested.
+
+   Use SCRATCH_POOL for temporary allocations.
+ */
+svn_error_t *
+svn_wc__db_begin_read_snapshot(svn_wc__db_t *db,
+                               const char *local_abspath,
+                               apr_pool_t *scratch_pool);
+
+/* End the snapshot started by svn_wc__db_begin_read_snapshot() for
+   LOCAL_ABSPATH in DB and return ERR, composed with any error that
+   occurred while doing so.
+
+   Use SCRATCH_POOL for temporary allocations.
+ */
+svn_error_t *
+svn_wc__db_end_read_snapshot(svn_wc__db_t *db,
+                             const char *local_abspath,
+                             svn_error_t *err,
+                             apr_pool_t *scratch_pool);
+
+
+/* Return the fsmonitor hook command configured for DB, or NULL if there
+   is none.  See fsmonitor.h. */
+const char *
+svn_wc__db_get_fsmonitor_hook(svn_wc__db_t *db);
+
+
+/* Return the number of threads that may install working files while
+   running the work queue of DB; 1 if they shall be installed sequentially.
+   See svn_wc__wq_run(). */
+int
+svn_wc__db_get_install_threads(svn_wc__db_t *db);
+
+
+/* Return TRUE if read-only working files in DB that need no translation
+   may be installed as hard links to their pristine. */
+svn_boolean_t
+svn_wc__db_get_link_pristines(svn_wc__db_t *db);
+
+
 /* Initialize the SDB for LOCAL_ABSPATH, which should be a working copy path.
 
    A REPOSITORY row will be constructed for the repository identified by
@@ -1040,6 +1089,20 @@ svn_wc__db_pristine_remove(svn_wc__db_t *db,
                            apr_pool_t *scratch_pool);
 
 
+/* Set *CONTENTS to a readable stream of the pristine text with SHA-1
+   checksum SHA1_CHECKSUM in the machine-wide shared pristine store
+   configured for DB.  Set *CONTENTS to NULL if no shared store has been
+   configured or it does not contain that text.
+
+   Allocate the stream in RESULT_POOL. */
+svn_error_t *
+svn_wc__db_pristine_read_shared(svn_stream_t **contents,
+                                svn_wc__db_t *db,
+                                const svn_checksum_t *sha1_checksum,
+                                apr_pool_t *result_pool,
+                                apr_pool_t *scratch_pool);
+
+
 /* Remove all unreferenced pristines in the WC of WRI_ABSPATH in DB. */
 svn_error_t *
 svn_wc__db_pristine_cleanup(svn_wc__db_t *db,
@@ -1057,6 +1120,52 @@ svn_wc__db_pristine_check(svn_boolean_t *present,
                           const svn_checksum_t *sha1_checksum,
                           apr_pool_t *scratch_pool);
 
+
+/* Set *STORE_PRISTINE to whether the working copy of WRI_ABSPATH in DB
+   stores a pristine copy of every file.  If not, its pristine store only
+   caches recently used texts and other texts get fetched on demand. */
+svn_error_t *
+svn_wc__db_get_store_pristine(svn_boolean_t *store_pristine,
+                              svn_wc__db_t *db,
+                              const char *wri_abspath,
+                              apr_pool_t *scratch_pool);
+
+/* Record in the working copy of WRI_ABSPATH in DB whether it stores a
+   pristine copy of every file.  Switching a working copy without stored
+   pristines back to storing them is not supported and returns
+   SVN_ERR_UNSUPPORTED_FEATURE. */
+svn_error_t *
+svn_wc__db_set_store_pristine(svn_wc__db_t *db,
+                              const char *wri_abspath,
+                              svn_boolean_t store_pristine,
+                              apr_pool_t *scratch_pool);
+
+/* Make DB call FETCH_FUNC with FETCH_BATON to obtain pristine texts that
+   are not stored locally. */
+void
+svn_wc__db_set_pristine_fetch(svn_wc__db_t *db,
+                              svn_wc__pristine_fetch_func_t fetch_func,
+                              void *fetch_baton);
+
+/* Ensure that the pristine text with SHA-1 checksum SHA1_CHECKSUM, which
+   must be in the pristine store of WRI_ABSPATH in DB, is available on disk.
+   In a working copy that stores pristines, this does nothing.  Otherwise
+   fetch the text if it is not cached locally and mark it as recently
+   used. */
+svn_error_t *
+svn_wc__db_pristine_hydrate(svn_wc__db_t *db,
+                            const char *wri_abspath,
+                            const svn_checksum_t *sha1_checksum,
+                            apr_pool_t *scratch_pool);
+
+/* In the working copy of WRI_ABSPATH in DB, if it does not store
+   pristines, remove the least recently used pristine texts from disk
+   until no more than the configured cache size remains. */
+svn_error_t *
+svn_wc__db_pristine_trim(svn_wc__db_t *db,
+                         const char *wri_abspath,
+                         apr_pool_t *scratch_pool);
+
 /* @defgroup svn_wc__db_external  External management
    @{ */
 
@@ -1332,6 +1441,7 @@ svn_wc__db_externals_gather_definitions(apr_hash_t **externals,
                                         apr_pool_t *result_pool,
                                         apr_pool_t *scratch_pool);
 
+
 /* @} */
 
 /* @defgroup svn_wc__db_op  Operations on WORKING tree
@@ -1359,6 +1469,26 @@ svn_wc__db_op_copy(svn_wc__db_t *db,
                    const svn_skel_t *work_items,
                    apr_pool_t *scratch_pool);
 
+/* Like svn_wc__db_op_copy(), but copy the directory SRC_ABSPATH together
+ * with all its versioned descendants, using a single transaction and
+ * set-based statements instead of one transaction per node.
+ *
+ * This is only possible if SRC_ABSPATH and DST_ABSPATH are in the same
+ * working copy and all descendants of SRC_ABSPATH are present, unswitched
+ * nodes at the revision and op-depth of SRC_ABSPATH without conflicts,
+ * file externals or further local operations.  Set *COPIED to TRUE if the
+ * tree was copied, or to FALSE, without changing anything, if the caller
+ * has to copy it node by node. */
+svn_error_t *
+svn_wc__db_op_copy_tree(svn_boolean_t *copied,
+                        svn_wc__db_t *db,
+                        const char *src_abspath,
+                        const char *dst_abspath,
+                        const char *dst_op_root_abspath,
+                        svn_boolean_t is_move,
+                        const svn_skel_t *work_items,
+                        apr_pool_t *scratch_pool);
+
 /* Checks if LOCAL_ABSPATH represents a move back to its original location,
  * and if it is reverts the move while keeping local changes after it has been
  * moved from MOVED_FROM_ABSPATH.
@@ -1539,6 +1669,19 @@ svn_wc__db_op_set_props(svn_wc__db_t *db,
                         const svn_skel_t *work_items,
                         apr_pool_t *scratch_pool);
 
+/* Like svn_wc__db_op_set_props() without CLEAR_RECORDED_INFO, CONFLICT
+   and WORK_ITEMS, but set the property hash at index I of PROPS on the
+   node at index I of the const char * array TARGETS, for all targets.
+
+   All targets must be within the same working copy.  Only one sqlite
+   transaction is used for all of them.
+*/
+svn_error_t *
+svn_wc__db_op_set_props_many(svn_wc__db_t *db,
+                             const apr_array_header_t *targets,
+                             const apr_array_header_t *props,
+                             apr_pool_t *scratch_pool);
+
 /* Mark LOCAL_ABSPATH, and all children, for deletion.
  *
  * This function removes the file externals (and if DELETE_DIR_EXTERNALS is
@@ -2047,6 +2190,38 @@ svn_wc__db_read_children_info(apr_hash_t **nodes,
                               apr_pool_t *result_pool,
                               apr_pool_t *scratch_pool);
 
+/* The information svn_wc__db_read_children_info() returns for one
+   directory, as contained in the result of svn_wc__db_read_subtree_info(). */
+typedef struct svn_wc__db_children_info_t
+{
+  apr_hash_t *nodes;     /* name -> struct svn_wc__db_info_t * */
+  apr_hash_t *conflicts; /* name -> "" */
+} svn_wc__db_children_info_t;
+
+/* Like calling svn_wc__db_read_children_info() on DIR_ABSPATH and on
+   every directory below it, but with a single query per table.
+
+   Set *DIRS to a hash mapping the path of each of these directories,
+   relative to DIR_ABSPATH ("" for DIR_ABSPATH itself), to a
+   svn_wc__db_children_info_t *.  Directories that have no children in
+   the database are not contained in *DIRS.  Only the working copy
+   containing DIR_ABSPATH is read; nested working copies are not.
+
+   If the subtree contains more than MAX_NODES node rows, set *DIRS to
+   NULL instead; the caller should then fall back to reading each directory
+   when it needs it.
+
+   BASE_TREE_ONLY is handled as in svn_wc__db_read_children_info().
+ */
+svn_error_t *
+svn_wc__db_read_subtree_info(apr_hash_t **dirs,
+                             svn_wc__db_t *db,
+                             const char *dir_abspath,
+                             svn_boolean_t base_tree_only,
+                             int max_nodes,
+                             apr_pool_t *result_pool,
+                             apr_pool_t *scratch_pool);
+
 /* Like svn_wc__db_read_children_info, but only gets an info node for the root
    element.
 
@@ -2923,6 +3098,16 @@ svn_error_t *
 svn_wc__db_install_schema_statistics(svn_sqlite__db_t *sdb,
                                      apr_pool_t *scratch_pool);
 
+/* Creates the covering indexes used for reading directory children, if
+   they don't exist yet.  They are optional; working copies without them
+   work just as well, only slower.
+
+   This function should be called on initializing the database and when
+   upgrading, before svn_wc__db_install_schema_statistics(). */
+svn_error_t *
+svn_wc__db_install_children_info_indexes(svn_sqlite__db_t *sdb,
+                                         apr_pool_t *scratch_pool);
+
 
 /* Create a new wc.db file for LOCAL_DIR_ABSPATH, which is going to be a
    working copy for the repository REPOS_ROOT_URL with uuid REPOS_UUID.
@@ -3028,6 +3213,35 @@ svn_wc__db_wq_record_and_fetch_next(apr_uint64_t *id,
                                     apr_pool_t *result_pool,
                                     apr_pool_t *scratch_pool);
 
+/* A work item returned by svn_wc__db_wq_complete_and_fetch_batch(). */
+typedef struct svn_wc__db_wq_item_t
+{
+  apr_uint64_t id;
+  svn_skel_t *work_item;
+} svn_wc__db_wq_item_t;
+
+/* Batched variant of svn_wc__db_wq_record_and_fetch_next().  In a single
+   transaction, mark all work items up to and including COMPLETED_ID as
+   completed, record the timestamps and sizes in RECORD_MAP, if not NULL,
+   and set *ITEMS to an array of the next (at most) MAX_ITEMS
+   svn_wc__db_wq_item_t * in the order in which they must be processed.
+   With MAX_ITEMS <= 0, *ITEMS will be empty.
+
+   Work items must remain restartable: after a crash, all items fetched
+   by one call that have not been marked as completed by the next call
+   will be run again.
+
+   RESULT_POOL will be used to allocate ITEMS, and SCRATCH_POOL
+   will be used for all temporary allocations.  */
+svn_error_t *
+svn_wc__db_wq_complete_and_fetch_batch(apr_array_header_t **items,
+                                       svn_wc__db_t *db,
+                                       const char *wri_abspath,
+                                       apr_uint64_t completed_id,
+                                       apr_hash_t *record_map,
+                                       int max_items,
+                                       apr_pool_t *result_pool,
+                                       apr_pool_t *scratch_pool);
 
 /* @} */
 
@@ -28,8 +28,13 @@
 #include "svn_pools.h"
 #include "svn_io.h"
 #include "svn_dirent_uri.h"
+#include "svn_path.h"
+#include "svn_string.h"
+#include "svn_sorts.h"
 
 #include "private/svn_io_private.h"
+#include "private/svn_sorts_private.h"
+#include "private/svn_worker_pool.h"
 
 #include "wc.h"
 #include "wc_db.h"
@@ -39,6 +44,12 @@
 #define PRISTINE_STORAGE_EXT ".svn-base"
 #define PRISTINE_STORAGE_RELPATH "pristine"
 #define PRISTINE_TEMPDIR_RELPATH "tmp"
+#define SHARED_PRISTINE_REFS_EXT ".refs"
+
+/* Number of threads removing unreferenced pristine files during cleanup,
+   and the number of files below which one thread does them all. */
+#define PRISTINE_REMOVE_THREADS 4
+#define PRISTINE_REMOVE_MIN_FILES 256
 
 
 
@@ -92,6 +103,426 @@ get_pristine_fname(const char **pristine_abspath,
   return SVN_NO_ERROR;
 }
 
+/* Return the absolute path to the temporary directory for pristine text
+   files within WCROOT. */
+static char *
+pristine_get_tempdir(svn_wc__db_wcroot_t *wcroot,
+                     apr_pool_t *result_pool,
+                     apr_pool_t *scratch_pool)
+{
+  return svn_dirent_join_many(result_pool, wcroot->abspath,
+                              svn_wc_get_adm_dir(scratch_pool),
+                              PRISTINE_TEMPDIR_RELPATH, SVN_VA_NULL);
+}
+
+
+/*** Working copies without stored pristines.
+ *
+ * A working copy created with the store-pristine option disabled records
+ * that in its SETTINGS table.  Its PRISTINE table still describes every
+ * referenced text, but the files in the pristine store only form a cache
+ * of recently used texts, bounded by the pristine-cache-size option.
+ * Texts missing from disk get fetched again, through the fetch callback
+ * of the DB, from the repository location of any node referencing them.
+ * The modification time of each cached file records its last use.
+ ***/
+
+/* Fetch the pristine text described by SHA1_CHECKSUM for WCROOT through
+ * the fetch callback of DB and store it at PRISTINE_ABSPATH.  Set *SIZE
+ * to its size in bytes.
+ */
+static svn_error_t *
+fetch_pristine(svn_filesize_t *size,
+               svn_wc__db_t *db,
+               svn_wc__db_wcroot_t *wcroot,
+               const svn_checksum_t *sha1_checksum,
+               const char *pristine_abspath,
+               apr_pool_t *scratch_pool)
+{
+  svn_sqlite__stmt_t *stmt;
+  svn_boolean_t have_row;
+  const char *repos_root_url = NULL;
+  const char *repos_relpath = NULL;
+  svn_revnum_t revision = SVN_INVALID_REVNUM;
+  const char *temp_abspath;
+  svn_stream_t *stream;
+  svn_checksum_t *actual_checksum;
+  apr_finfo_t finfo;
+  svn_error_t *err;
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, wcroot->sdb,
+                                    STMT_SELECT_PRISTINE_LOCATION));
+  SVN_ERR(svn_sqlite__bind_int64(stmt, 1, wcroot->wc_id));
+  SVN_ERR(svn_sqlite__bind_checksum(stmt, 2, sha1_checksum, scratch_pool));
+  SVN_ERR(svn_sqlite__step(&have_row, stmt));
+  if (have_row)
+    {
+      repos_root_url = svn_sqlite__column_text(stmt, 0, scratch_pool);
+      repos_relpath = svn_sqlite__column_text(stmt, 1, scratch_pool);
+      revision = svn_sqlite__column_revnum(stmt, 2);
+    }
+  SVN_ERR(svn_sqlite__reset(stmt));
+
+  if (!have_row)
+    return svn_error_createf(SVN_ERR_WC_PRISTINE_NOT_STORED, NULL,
+                             _("Pristine text '%s' is not stored locally "
+                               "and no repository location is known for it"),
+                             svn_checksum_to_cstring_display(sha1_checksum,
+                                                             scratch_pool));
+  if (!db->fetch_pristine_func)
+    return svn_error_createf(SVN_ERR_WC_PRISTINE_NOT_STORED, NULL,
+                             _("Pristine text of '%s' in r%ld is not stored "
+                               "locally"),
+                             svn_path_url_add_component2(repos_root_url,
+                                                         repos_relpath,
+                                                         scratch_pool),
+                             revision);
+
+  SVN_ERR(svn_stream_open_unique(&stream, &temp_abspath,
+                                 pristine_get_tempdir(wcroot, scratch_pool,
+                                                      scratch_pool),
+                                 svn_io_file_del_none,
+                                 scratch_pool, scratch_pool));
+  stream = svn_stream_checksummed2(stream, NULL, &actual_checksum,
+                                   svn_checksum_sha1, FALSE, scratch_pool);
+
+  err = db->fetch_pristine_func(db->fetch_pristine_baton, stream,
+                                repos_root_url, repos_relpath, revision,
+                                scratch_pool);
+  err = svn_error_compose_create(err, svn_stream_close(stream));
+  if (!err && !svn_checksum_match(sha1_checksum, actual_checksum))
+    err = svn_checksum_mismatch_err(
+            sha1_checksum, actual_checksum, scratch_pool,
+            _("Checksum mismatch for the pristine text of '%s' in r%ld"),
+            svn_path_url_add_component2(repos_root_url, repos_relpath,
+                                        scratch_pool),
+            revision);
+
+  /* Another process may be fetching the same text; the renames are
+     atomic and both texts are identical, so either one may win. */
+  if (!err)
+    err = svn_io_make_dir_recursively(svn_dirent_dirname(pristine_abspath,
+                                                         scratch_pool),
+                                      scratch_pool);
+  if (!err)
+    err = svn_io_file_rename2(temp_abspath, pristine_abspath, FALSE,
+                              scratch_pool);
+  if (err)
+    return svn_error_compose_create(
+             err, svn_io_remove_file2(temp_abspath, TRUE, scratch_pool));
+
+  SVN_ERR(svn_io_set_file_read_only(pristine_abspath, FALSE, scratch_pool));
+  SVN_ERR(svn_io_stat(&finfo, pristine_abspath, APR_FINFO_SIZE,
+                      scratch_pool));
+  *size = finfo.size;
+
+  return SVN_NO_ERROR;
+}
+
+/* A file in the pristine cache, as collected by trim_pristine_cache(). */
+typedef struct cached_pristine_t
+{
+  const char *abspath;
+  svn_filesize_t size;
+  apr_time_t mtime;
+} cached_pristine_t;
+
+/* Sort callback ordering cached_pristine_t pointers by their last use. */
+static int
+compare_cached_pristines(const void *a, const void *b)
+{
+  const cached_pristine_t *p1 = *(const cached_pristine_t *const *)a;
+  const cached_pristine_t *p2 = *(const cached_pristine_t *const *)b;
+
+  if (p1->mtime == p2->mtime)
+    return 0;
+
+  return p1->mtime < p2->mtime ? -1 : 1;
+}
+
+/* Remove the least recently used texts from the pristine cache of WCROOT
+ * until it holds no more than TARGET bytes, and update the estimated cache
+ * usage of WCROOT.  Never remove KEEP_ABSPATH, if not NULL, as a caller is
+ * about to use it.  The cache can always be refilled, so errors removing
+ * single texts are ignored.
+ */
+static svn_error_t *
+trim_pristine_cache(svn_wc__db_wcroot_t *wcroot,
+                    apr_int64_t target,
+                    const char *keep_abspath,
+                    apr_pool_t *scratch_pool)
+{
+  const char *base_dir_abspath;
+  apr_hash_t *subdirs;
+  apr_hash_index_t *hi;
+  apr_array_header_t *files;
+  apr_int64_t used = 0;
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  svn_error_t *err;
+  int i;
+
+  base_dir_abspath = svn_dirent_join_many(scratch_pool, wcroot->abspath,
+                                          svn_wc_get_adm_dir(scratch_pool),
+                                          PRISTINE_STORAGE_RELPATH,
+                                          SVN_VA_NULL);
+  err = svn_io_get_dirents3(&subdirs, base_dir_abspath, TRUE,
+                            scratch_pool, scratch_pool);
+  if (err && APR_STATUS_IS_ENOENT(err->apr_err))
+    {
+      svn_error_clear(err);
+      wcroot->pristine_cache_used = 0;
+      return SVN_NO_ERROR;
+    }
+  SVN_ERR(err);
+
+  files = apr_array_make(scratch_pool, 16, sizeof(cached_pristine_t *));
+  for (hi = apr_hash_first(scratch_pool, subdirs); hi; hi = apr_hash_next(hi))
+    {
+      const char *subdir = apr_hash_this_key(hi);
+      const svn_io_dirent2_t *dirent = apr_hash_this_val(hi);
+      const char *subdir_abspath;
+      apr_hash_t *entries;
+      apr_hash_index_t *hj;
+
+      if (dirent->kind != svn_node_dir || strlen(subdir) != 2)
+        continue;
+
+      svn_pool_clear(iterpool);
+      subdir_abspath = svn_dirent_join(base_dir_abspath, subdir, iterpool);
+      SVN_ERR(svn_io_get_dirents3(&entries, subdir_abspath, FALSE,
+                                  iterpool, iterpool));
+
+      for (hj = apr_hash_first(iterpool, entries); hj; hj = apr_hash_next(hj))
+        {
+          const char *name = apr_hash_this_key(hj);
+          const svn_io_dirent2_t *entry = apr_hash_this_val(hj);
+          cached_pristine_t *file;
+
+          if (entry->kind != svn_node_file
+              || strcmp(name + strlen(name) - strlen(PRISTINE_STORAGE_EXT),
+                        PRISTINE_STORAGE_EXT) != 0)
+            continue;
+
+          file = apr_palloc(scratch_pool, sizeof(*file));
+          file->abspath = svn_dirent_join(subdir_abspath, name, scratch_pool);
+          file->size = entry->filesize;
+          file->mtime = entry->mtime;
+          APR_ARRAY_PUSH(files, cached_pristine_t *) = file;
+          used += entry->filesize;
+        }
+    }
+
+  svn_sort__array(files, compare_cached_pristines);
+  for (i = 0; i < files->nelts && used > target; i++)
+    {
+      const cached_pristine_t *file = APR_ARRAY_IDX(files, i,
+                                                     cached_pristine_t *);
+
+      if (keep_abspath && strcmp(file->abspath, keep_abspath) == 0)
+        continue;
+
+      svn_pool_clear(iterpool);
+      err = svn_io_remove_file2(file->abspath, TRUE, iterpool);
+      if (err)
+        svn_error_clear(err);
+      else
+        used -= file->size;
+    }
+
+  svn_pool_destroy(iterpool);
+  wcroot->pristine_cache_used = used;
+
+  return SVN_NO_ERROR;
+}
+
+/* Account for the text at PRISTINE_ABSPATH, of SIZE bytes, added to the
+ * pristine cache of WCROOT and trim the cache if it grew beyond CACHE_SIZE.
+ * Trimming evicts down to three quarters of the limit, so that the store
+ * does not get scanned again on every new text.
+ */
+static svn_error_t *
+add_to_pristine_cache(svn_wc__db_wcroot_t *wcroot,
+                      apr_int64_t cache_size,
+                      const char *pristine_abspath,
+                      svn_filesize_t size,
+                      apr_pool_t *scratch_pool)
+{
+  if (wcroot->pristine_cache_used >= 0)
+    wcroot->pristine_cache_used += size;
+
+  if (wcroot->pristine_cache_used < 0
+      || wcroot->pristine_cache_used > cache_size)
+    SVN_ERR(trim_pristine_cache(wcroot, cache_size / 4 * 3, pristine_abspath,
+                                scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Make sure the text described by SHA1_CHECKSUM, whose location in the
+ * pristine store of WCROOT is PRISTINE_ABSPATH, is available on disk if
+ * the PRISTINE table knows it.  Mark the text as recently used.
+ *
+ * WCROOT must not store pristines.
+ */
+static svn_error_t *
+hydrate_pristine(svn_wc__db_t *db,
+                 svn_wc__db_wcroot_t *wcroot,
+                 const svn_checksum_t *sha1_checksum,
+                 const char *pristine_abspath,
+                 apr_pool_t *scratch_pool)
+{
+  svn_sqlite__stmt_t *stmt;
+  svn_boolean_t have_row;
+  svn_filesize_t size;
+  svn_error_t *err;
+
+  /* Touching the file also tells us whether it is there. */
+  err = svn_io_set_file_affected_time(apr_time_now(), pristine_abspath,
+                                      scratch_pool);
+  if (!err || !APR_STATUS_IS_ENOENT(err->apr_err))
+    return svn_error_trace(err);
+  svn_error_clear(err);
+
+  /* Leave reporting unknown texts to our callers. */
+  SVN_ERR(svn_sqlite__get_statement(&stmt, wcroot->sdb,
+                                    STMT_SELECT_PRISTINE));
+  SVN_ERR(svn_sqlite__bind_checksum(stmt, 1, sha1_checksum, scratch_pool));
+  SVN_ERR(svn_sqlite__step(&have_row, stmt));
+  SVN_ERR(svn_sqlite__reset(stmt));
+  if (!have_row)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(fetch_pristine(&size, db, wcroot, sha1_checksum, pristine_abspath,
+                         scratch_pool));
+
+  return svn_error_trace(add_to_pristine_cache(wcroot,
+                                               db->pristine_cache_size,
+                                               pristine_abspath, size,
+                                               scratch_pool));
+}
+
+svn_error_t *
+svn_wc__db_pristine_hydrate(svn_wc__db_t *db,
+                            const char *wri_abspath,
+                            const svn_checksum_t *sha1_checksum,
+                            apr_pool_t *scratch_pool)
+{
+  svn_wc__db_wcroot_t *wcroot;
+  const char *local_relpath;
+  const char *pristine_abspath;
+
+  SVN_ERR_ASSERT(svn_dirent_is_absolute(wri_abspath));
+  SVN_ERR_ASSERT(sha1_checksum->kind == svn_checksum_sha1);
+
+  SVN_ERR(svn_wc__db_wcroot_parse_local_abspath(&wcroot, &local_relpath, db,
+                              wri_abspath, scratch_pool, scratch_pool));
+  VERIFY_USABLE_WCROOT(wcroot);
+
+  if (wcroot->store_pristine)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(get_pristine_fname(&pristine_abspath, wcroot->abspath,
+                             sha1_checksum, scratch_pool, scratch_pool));
+
+  return svn_error_trace(hydrate_pristine(db, wcroot, sha1_checksum,
+                                          pristine_abspath, scratch_pool));
+}
+
+svn_error_t *
+svn_wc__db_pristine_trim(svn_wc__db_t *db,
+                         const char *wri_abspath,
+                         apr_pool_t *scratch_pool)
+{
+  svn_wc__db_wcroot_t *wcroot;
+  const char *local_relpath;
+
+  SVN_ERR_ASSERT(svn_dirent_is_absolute(wri_abspath));
+
+  SVN_ERR(svn_wc__db_wcroot_parse_local_abspath(&wcroot, &local_relpath, db,
+                              wri_abspath, scratch_pool, scratch_pool));
+  VERIFY_USABLE_WCROOT(wcroot);
+
+  if (wcroot->store_pristine)
+    return SVN_NO_ERROR;
+
+  return svn_error_trace(trim_pristine_cache(wcroot, db->pristine_cache_size,
+                                             NULL, scratch_pool));
+}
+
+svn_error_t *
+svn_wc__db_get_store_pristine(svn_boolean_t *store_pristine,
+                              svn_wc__db_t *db,
+                              const char *wri_abspath,
+                              apr_pool_t *scratch_pool)
+{
+  svn_wc__db_wcroot_t *wcroot;
+  const char *local_relpath;
+
+  SVN_ERR_ASSERT(svn_dirent_is_absolute(wri_abspath));
+
+  SVN_ERR(svn_wc__db_wcroot_parse_local_abspath(&wcroot, &local_relpath, db,
+                              wri_abspath, scratch_pool, scratch_pool));
+  VERIFY_USABLE_WCROOT(wcroot);
+
+  *store_pristine = wcroot->store_pristine;
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_wc__db_set_store_pristine(svn_wc__db_t *db,
+                              const char *wri_abspath,
+                              svn_boolean_t store_pristine,
+                              apr_pool_t *scratch_pool)
+{
+  svn_wc__db_wcroot_t *wcroot;
+  const char *local_relpath;
+  svn_sqlite__stmt_t *stmt;
+
+  SVN_ERR_ASSERT(svn_dirent_is_absolute(wri_abspath));
+
+  SVN_ERR(svn_wc__db_wcroot_parse_local_abspath(&wcroot, &local_relpath, db,
+                              wri_abspath, scratch_pool, scratch_pool));
+  VERIFY_USABLE_WCROOT(wcroot);
+
+  if (store_pristine == wcroot->store_pristine)
+    return SVN_NO_ERROR;
+
+  /* ### This would need to fetch every text that is not cached. */
+  if (store_pristine)
+    return svn_error_createf(SVN_ERR_UNSUPPORTED_FEATURE, NULL,
+                             _("Can't make the working copy at '%s' store "
+                               "pristine texts again"),
+                             svn_dirent_local_style(wcroot->abspath,
+                                                    scratch_pool));
+
+  /* Older clients would take the missing texts for corruption.  Bump the
+     format first, so they never see a working copy in that mode. */
+  SVN_ERR(svn_sqlite__exec_statements(wcroot->sdb, STMT_UPGRADE_TO_32));
+  wcroot->format = SVN_WC__STORE_PRISTINE_VERSION;
+
+  SVN_ERR(svn_sqlite__exec_statements(wcroot->sdb, STMT_CREATE_SETTINGS));
+  SVN_ERR(svn_sqlite__get_statement(&stmt, wcroot->sdb,
+                                    STMT_INSERT_OR_REPLACE_SETTING));
+  SVN_ERR(svn_sqlite__bindf(stmt, "isd", wcroot->wc_id,
+                            SVN_WC__SETTING_STORE_PRISTINE, 0));
+  SVN_ERR(svn_sqlite__update(NULL, stmt));
+
+  wcroot->store_pristine = FALSE;
+  wcroot->pristine_cache_used = -1;
+
+  return SVN_NO_ERROR;
+}
+
+void
+svn_wc__db_set_pristine_fetch(svn_wc__db_t *db,
+                              svn_wc__pristine_fetch_func_t fetch_func,
+                              void *fetch_baton)
+{
+  db->fetch_pristine_func = fetch_func;
+  db->fetch_pristine_baton = fetch_baton;
+}
+
 
 svn_error_t *
 svn_wc__db_pristine_get_path(const char **pristine_abspath,
@@ -121,6 +552,16 @@ svn_wc__db_pristine_get_path(const char **pristine_abspath,
                                              scratch_pool, scratch_pool));
   VERIFY_USABLE_WCROOT(wcroot);
 
+  if (! wcroot->store_pristine)
+    {
+      const char *cached_abspath;
+
+      SVN_ERR(get_pristine_fname(&cached_abspath, wcroot->abspath,
+                                 sha1_checksum, scratch_pool, scratch_pool));
+      SVN_ERR(hydrate_pristine(db, wcroot, sha1_checksum, cached_abspath,
+                               scratch_pool));
+    }
+
   SVN_ERR(svn_wc__db_pristine_check(&present, db, wri_abspath, sha1_checksum,
                                     scratch_pool));
   if (! present)
@@ -246,6 +687,9 @@ svn_wc__db_pristine_read(svn_stream_t **contents,
   SVN_ERR(get_pristine_fname(&pristine_abspath, wcroot->abspath,
                              sha1_checksum,
                              scratch_pool, scratch_pool));
+  if (! wcroot->store_pristine)
+    SVN_ERR(hydrate_pristine(db, wcroot, sha1_checksum, pristine_abspath,
+                             scratch_pool));
   SVN_WC__DB_WITH_TXN(
     pristine_read_txn(contents, size,
                       wcroot, sha1_checksum, pristine_abspath,
@@ -256,16 +700,249 @@ svn_wc__db_pristine_read(svn_stream_t **contents,
 }
 
 
-/* Return the absolute path to the temporary directory for pristine text
-   files within WCROOT. */
-static char *
-pristine_get_tempdir(svn_wc__db_wcroot_t *wcroot,
-                     apr_pool_t *result_pool,
-                     apr_pool_t *scratch_pool)
+/*** The machine-wide shared pristine store.
+ *
+ * If configured, the shared store lives in a directory outside of any
+ * working copy and uses the same XX/XXYYZZ...svn-base layout as the
+ * per-WC stores.  Next to each text, a XXYYZZ...refs file lists the
+ * absolute paths of all wcroots that currently have that text in their
+ * own store, one per line.  The text gets removed once that list becomes
+ * empty.  All modifications to a text and its list happen while holding
+ * an exclusive lock on the .refs file; the .refs file itself is never
+ * removed so that the lock remains usable for concurrent processes.
+ *
+ * The shared store is only an optimization.  Failures to update it are
+ * not reported to the caller.
+ ***/
+
+/* Set *CONTENT_ABSPATH and *REFS_ABSPATH to the location of the text
+   described by SHA1_CHECKSUM and its reference list in the shared store
+   at SHARED_ABSPATH, respectively.  REFS_ABSPATH may be NULL.  Allocate
+   the results in RESULT_POOL. */
+static svn_error_t *
+get_shared_pristine_fnames(const char **content_abspath,
+                           const char **refs_abspath,
+                           const char *shared_abspath,
+                           const svn_checksum_t *sha1_checksum,
+                           apr_pool_t *result_pool,
+                           apr_pool_t *scratch_pool)
 {
-  return svn_dirent_join_many(result_pool, wcroot->abspath,
-                              svn_wc_get_adm_dir(scratch_pool),
-                              PRISTINE_TEMPDIR_RELPATH, SVN_VA_NULL);
+  const char *hexdigest = svn_checksum_to_cstring(sha1_checksum, scratch_pool);
+  char subdir[3];
+  const char *base_abspath;
+
+  SVN_ERR_ASSERT(hexdigest != NULL);
+
+  subdir[0] = hexdigest[0];
+  subdir[1] = hexdigest[1];
+  subdir[2] = '\0';
+
+  base_abspath = svn_dirent_join_many(scratch_pool, shared_abspath, subdir,
+                                      hexdigest, SVN_VA_NULL);
+  *content_abspath = apr_pstrcat(result_pool, base_abspath,
+                                 PRISTINE_STORAGE_EXT, SVN_VA_NULL);
+  if (refs_abspath)
+    *refs_abspath = apr_pstrcat(result_pool, base_abspath,
+                                SHARED_PRISTINE_REFS_EXT, SVN_VA_NULL);
+
+  return SVN_NO_ERROR;
+}
+
+/* Open the reference list REFS_ABSPATH, creating it if CREATE is set, and
+   lock it exclusively.  Return the locked file in *FILE and its lines in
+   *REFS.  Set *FILE to NULL if the list does not exist and CREATE is not
+   set.  Allocate the results in RESULT_POOL. */
+static svn_error_t *
+open_shared_pristine_refs(apr_file_t **file,
+                          apr_array_header_t **refs,
+                          const char *refs_abspath,
+                          svn_boolean_t create,
+                          apr_pool_t *result_pool,
+                          apr_pool_t *scratch_pool)
+{
+  svn_stringbuf_t *contents;
+  svn_error_t *err;
+
+  err = svn_io_file_open(file, refs_abspath,
+                         APR_READ | APR_WRITE | (create ? APR_CREATE : 0),
+                         APR_OS_DEFAULT, result_pool);
+  if (err && APR_STATUS_IS_ENOENT(err->apr_err) && create)
+    {
+      /* Maybe the directory doesn't exist yet? */
+      svn_error_clear(err);
+      SVN_ERR(svn_io_make_dir_recursively(svn_dirent_dirname(refs_abspath,
+                                                             scratch_pool),
+                                          scratch_pool));
+      err = svn_io_file_open(file, refs_abspath,
+                             APR_READ | APR_WRITE | APR_CREATE,
+                             APR_OS_DEFAULT, result_pool);
+    }
+  else if (err && APR_STATUS_IS_ENOENT(err->apr_err))
+    {
+      svn_error_clear(err);
+      *file = NULL;
+      return SVN_NO_ERROR;
+    }
+  SVN_ERR(err);
+
+  SVN_ERR(svn_io_lock_open_file(*file, TRUE, FALSE, scratch_pool));
+  SVN_ERR(svn_stringbuf_from_aprfile(&contents, *file, scratch_pool));
+  *refs = svn_cstring_split(contents->data, "\n", TRUE, result_pool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Replace the contents of the locked reference list FILE with REFS and
+   release the lock. */
+static svn_error_t *
+close_shared_pristine_refs(apr_file_t *file,
+                           const apr_array_header_t *refs,
+                           apr_pool_t *scratch_pool)
+{
+  svn_stringbuf_t *contents = svn_stringbuf_create_empty(scratch_pool);
+  apr_off_t offset = 0;
+  int i;
+
+  for (i = 0; i < refs->nelts; i++)
+    {
+      svn_stringbuf_appendcstr(contents, APR_ARRAY_IDX(refs, i, const char *));
+      svn_stringbuf_appendbyte(contents, '\n');
+    }
+
+  SVN_ERR(svn_io_file_trunc(file, 0, scratch_pool));
+  SVN_ERR(svn_io_file_seek(file, APR_SET, &offset, scratch_pool));
+  SVN_ERR(svn_io_file_write_full(file, contents->data, contents->len, NULL,
+                                 scratch_pool));
+
+  /* Closing the file releases the lock as well. */
+  return svn_error_trace(svn_io_file_close(file, scratch_pool));
+}
+
+/* Return the index of WCROOT_ABSPATH in REFS or -1, if not found. */
+static int
+find_shared_pristine_ref(const apr_array_header_t *refs,
+                         const char *wcroot_abspath)
+{
+  int i;
+
+  for (i = 0; i < refs->nelts; i++)
+    if (strcmp(APR_ARRAY_IDX(refs, i, const char *), wcroot_abspath) == 0)
+      return i;
+
+  return -1;
+}
+
+/* Record that the wcroot at WCROOT_ABSPATH has the text described by
+ * SHA1_CHECKSUM, stored in PRISTINE_ABSPATH, in its pristine store.  Copy
+ * the text into the shared store at SHARED_ABSPATH, if it is not there
+ * yet.
+ */
+static svn_error_t *
+shared_pristine_add_ref(const char *shared_abspath,
+                        const char *wcroot_abspath,
+                        const svn_checksum_t *sha1_checksum,
+                        const char *pristine_abspath,
+                        apr_pool_t *scratch_pool)
+{
+  const char *content_abspath;
+  const char *refs_abspath;
+  apr_file_t *file;
+  apr_array_header_t *refs;
+  svn_node_kind_t kind;
+  svn_error_t *err;
+
+  SVN_ERR(get_shared_pristine_fnames(&content_abspath, &refs_abspath,
+                                     shared_abspath, sha1_checksum,
+                                     scratch_pool, scratch_pool));
+  SVN_ERR(open_shared_pristine_refs(&file, &refs, refs_abspath, TRUE,
+                                    scratch_pool, scratch_pool));
+
+  /* svn_io_copy_file() copies into a temporary file next to the target,
+     which is then renamed.  Hence, readers never see a partial text. */
+  err = svn_io_check_path(content_abspath, &kind, scratch_pool);
+  if (!err && kind == svn_node_none)
+    err = svn_io_copy_file(pristine_abspath, content_abspath, FALSE,
+                           scratch_pool);
+  if (!err && kind == svn_node_none)
+    err = svn_io_set_file_read_only(content_abspath, FALSE, scratch_pool);
+
+  if (!err && find_shared_pristine_ref(refs, wcroot_abspath) < 0)
+    APR_ARRAY_PUSH(refs, const char *) = wcroot_abspath;
+
+  return svn_error_compose_create(err,
+                                  close_shared_pristine_refs(file, refs,
+                                                             scratch_pool));
+}
+
+/* Record that the wcroot at WCROOT_ABSPATH no longer has the text
+ * described by SHA1_CHECKSUM in its pristine store.  Remove the text from
+ * the shared store at SHARED_ABSPATH, if no other wcroot references it.
+ */
+static svn_error_t *
+shared_pristine_remove_ref(const char *shared_abspath,
+                           const char *wcroot_abspath,
+                           const svn_checksum_t *sha1_checksum,
+                           apr_pool_t *scratch_pool)
+{
+  const char *content_abspath;
+  const char *refs_abspath;
+  apr_file_t *file;
+  apr_array_header_t *refs;
+  svn_error_t *err = SVN_NO_ERROR;
+  int idx;
+
+  SVN_ERR(get_shared_pristine_fnames(&content_abspath, &refs_abspath,
+                                     shared_abspath, sha1_checksum,
+                                     scratch_pool, scratch_pool));
+  SVN_ERR(open_shared_pristine_refs(&file, &refs, refs_abspath, FALSE,
+                                    scratch_pool, scratch_pool));
+  if (!file)
+    return SVN_NO_ERROR;
+
+  idx = find_shared_pristine_ref(refs, wcroot_abspath);
+  if (idx >= 0)
+    {
+      svn_sort__array_delete(refs, idx, 1);
+      if (refs->nelts == 0)
+        err = svn_io_remove_file2(content_abspath, TRUE, scratch_pool);
+    }
+
+  return svn_error_compose_create(err,
+                                  close_shared_pristine_refs(file, refs,
+                                                             scratch_pool));
+}
+
+svn_error_t *
+svn_wc__db_pristine_read_shared(svn_stream_t **contents,
+                                svn_wc__db_t *db,
+                                const svn_checksum_t *sha1_checksum,
+                                apr_pool_t *result_pool,
+                                apr_pool_t *scratch_pool)
+{
+  const char *content_abspath;
+  svn_error_t *err;
+
+  *contents = NULL;
+  if (!db->shared_pristine_abspath
+      || sha1_checksum->kind != svn_checksum_sha1)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(get_shared_pristine_fnames(&content_abspath, NULL,
+                                     db->shared_pristine_abspath,
+                                     sha1_checksum,
+                                     scratch_pool, scratch_pool));
+
+  /* Like with the per-WC store, the stream remains readable even if the
+     file gets removed from the store in the meantime. */
+  err = svn_stream_open_readonly(contents, content_abspath, result_pool,
+                                 scratch_pool);
+  if (err)
+    {
+      svn_error_clear(err);
+      *contents = NULL;
+    }
+
+  return SVN_NO_ERROR;
 }
 
 /* Install the pristine text described by BATON into the pristine store of
@@ -287,11 +964,15 @@ pristine_install_txn(svn_sqlite__db_t *sdb,
                      const svn_checksum_t *sha1_checksum,
                      /* The pristine text's MD-5 checksum. */
                      const svn_checksum_t *md5_checksum,
+                     /* Set to TRUE if the text was not in the store yet. */
+                     svn_boolean_t *installed,
                      apr_pool_t *scratch_pool)
 {
   svn_sqlite__stmt_t *stmt;
   svn_boolean_t have_row;
 
+  *installed = FALSE;
+
   /* If this pristine text is already present in the store, just keep it:
    * delete the new one and return. */
   SVN_ERR(svn_sqlite__get_statement(&stmt, sdb, STMT_SELECT_PRISTINE));
@@ -345,6 +1026,7 @@ pristine_install_txn(svn_sqlite__db_t *sdb,
     SVN_ERR(svn_sqlite__insert(NULL, stmt));
 
     SVN_ERR(svn_io_set_file_read_only(pristine_abspath, FALSE, scratch_pool));
+    *installed = TRUE;
   }
 
   return SVN_NO_ERROR;
@@ -354,6 +1036,12 @@ struct svn_wc__db_install_data_t
 {
   svn_wc__db_wcroot_t *wcroot;
   svn_stream_t *inner_stream;
+
+  /* The shared pristine store to register new texts with, or NULL. */
+  const char *shared_pristine_abspath;
+
+  /* The pristine cache size limit, if WCROOT does not store pristines. */
+  apr_int64_t pristine_cache_size;
 };
 
 svn_error_t *
@@ -380,6 +1068,8 @@ svn_wc__db_pristine_prepare_install(svn_stream_t **stream,
 
   *install_data = apr_pcalloc(result_pool, sizeof(**install_data));
   (*install_data)->wcroot = wcroot;
+  (*install_data)->shared_pristine_abspath = db->shared_pristine_abspath;
+  (*install_data)->pristine_cache_size = db->pristine_cache_size;
 
   SVN_ERR_W(svn_stream__create_for_install(stream,
                                            temp_dir_abspath,
@@ -388,12 +1078,9 @@ svn_wc__db_pristine_prepare_install(svn_stream_t **stream,
 
   (*install_data)->inner_stream = *stream;
 
-  if (md5_checksum)
-    *stream = svn_stream_checksummed2(*stream, NULL, md5_checksum,
-                                      svn_checksum_md5, FALSE, result_pool);
-  if (sha1_checksum)
-    *stream = svn_stream_checksummed2(*stream, NULL, sha1_checksum,
-                                      svn_checksum_sha1, FALSE, result_pool);
+  *stream = svn_stream__checksummed_md5_sha1(*stream, NULL, NULL,
+                                             md5_checksum, sha1_checksum,
+                                             FALSE, result_pool);
 
   return SVN_NO_ERROR;
 }
@@ -406,6 +1093,7 @@ svn_wc__db_pristine_install(svn_wc__db_install_data_t *install_data,
 {
   svn_wc__db_wcroot_t *wcroot = install_data->wcroot;
   const char *pristine_abspath;
+  svn_boolean_t installed;
 
   SVN_ERR_ASSERT(sha1_checksum != NULL);
   SVN_ERR_ASSERT(sha1_checksum->kind == svn_checksum_sha1);
@@ -421,10 +1109,26 @@ svn_wc__db_pristine_install(svn_wc__db_install_data_t *install_data,
   SVN_SQLITE__WITH_IMMEDIATE_TXN(
     pristine_install_txn(wcroot->sdb,
                          install_data->inner_stream, pristine_abspath,
-                         sha1_checksum, md5_checksum,
+                         sha1_checksum, md5_checksum, &installed,
                          scratch_pool),
     wcroot->sdb);
 
+  if (installed && install_data->shared_pristine_abspath)
+    svn_error_clear(shared_pristine_add_ref(
+                      install_data->shared_pristine_abspath, wcroot->abspath,
+                      sha1_checksum, pristine_abspath, scratch_pool));
+
+  if (installed && ! wcroot->store_pristine)
+    {
+      apr_finfo_t finfo;
+
+      SVN_ERR(svn_io_stat(&finfo, pristine_abspath, APR_FINFO_SIZE,
+                          scratch_pool));
+      SVN_ERR(add_to_pristine_cache(wcroot, install_data->pristine_cache_size,
+                                    pristine_abspath, finfo.size,
+                                    scratch_pool));
+    }
+
   return SVN_NO_ERROR;
 }
 
@@ -689,7 +1393,8 @@ svn_wc__db_pristine_transfer(svn_wc__db_t *db,
 
 /* If the pristine text referenced by SHA1_CHECKSUM in WCROOT/SDB, whose path
  * within the pristine store is PRISTINE_ABSPATH, has a reference count of
- * zero, delete it (both the database row and the disk file).
+ * zero, delete it (both the database row and the disk file).  Set *REMOVED
+ * to TRUE in that case and to FALSE otherwise.
  *
  * This function expects to be executed inside a SQLite txn that has already
  * acquired a 'RESERVED' lock.
@@ -699,6 +1404,7 @@ pristine_remove_if_unreferenced_txn(svn_sqlite__db_t *sdb,
                                     svn_wc__db_wcroot_t *wcroot,
                                     const svn_checksum_t *sha1_checksum,
                                     const char *pristine_abspath,
+                                    svn_boolean_t *removed,
                                     apr_pool_t *scratch_pool)
 {
   svn_sqlite__stmt_t *stmt;
@@ -709,6 +1415,7 @@ pristine_remove_if_unreferenced_txn(svn_sqlite__db_t *sdb,
                                     STMT_DELETE_PRISTINE_IF_UNREFERENCED));
   SVN_ERR(svn_sqlite__bind_checksum(stmt, 1, sha1_checksum, scratch_pool));
   SVN_ERR(svn_sqlite__update(&affected_rows, stmt));
+  *removed = (affected_rows > 0);
 
   /* If we removed the DB row, then remove the file. */
   if (affected_rows > 0)
@@ -717,7 +1424,7 @@ pristine_remove_if_unreferenced_txn(svn_sqlite__db_t *sdb,
        * point it no longer matters.  In a debug build, raise an error, but
        * in a release build, it is more helpful to ignore it and continue. */
 #ifdef SVN_DEBUG
-      svn_boolean_t ignore_enoent = FALSE;
+      svn_boolean_t ignore_enoent = ! wcroot->store_pristine;
 #else
       svn_boolean_t ignore_enoent = TRUE;
 #endif
@@ -731,15 +1438,18 @@ pristine_remove_if_unreferenced_txn(svn_sqlite__db_t *sdb,
 
 /* If the pristine text referenced by SHA1_CHECKSUM in WCROOT has a
  * reference count of zero, delete it (both the database row and the disk
- * file).
+ * file) and drop WCROOT's reference to it from the shared pristine store
+ * at SHARED_ABSPATH, unless that is NULL.
  *
  * Implements 'notes/wc-ng/pristine-store' section A-3(b). */
 static svn_error_t *
 pristine_remove_if_unreferenced(svn_wc__db_wcroot_t *wcroot,
+                                const char *shared_abspath,
                                 const svn_checksum_t *sha1_checksum,
                                 apr_pool_t *scratch_pool)
 {
   const char *pristine_abspath;
+  svn_boolean_t removed;
 
   SVN_ERR(get_pristine_fname(&pristine_abspath, wcroot->abspath,
                              sha1_checksum, scratch_pool, scratch_pool));
@@ -748,9 +1458,15 @@ pristine_remove_if_unreferenced(svn_wc__db_wcroot_t *wcroot,
    * at the disk, to ensure no concurrent pristine install/delete txn. */
   SVN_SQLITE__WITH_IMMEDIATE_TXN(
     pristine_remove_if_unreferenced_txn(
-      wcroot->sdb, wcroot, sha1_checksum, pristine_abspath, scratch_pool),
+      wcroot->sdb, wcroot, sha1_checksum, pristine_abspath, &removed,
+      scratch_pool),
     wcroot->sdb);
 
+  if (removed && shared_abspath)
+    svn_error_clear(shared_pristine_remove_ref(shared_abspath,
+                                               wcroot->abspath,
+                                               sha1_checksum, scratch_pool));
+
   return SVN_NO_ERROR;
 }
 
@@ -792,16 +1508,207 @@ svn_wc__db_pristine_remove(svn_wc__db_t *db,
   }
 
   /* If not referenced, remove the PRISTINE table row and the file. */
-  SVN_ERR(pristine_remove_if_unreferenced(wcroot, sha1_checksum, scratch_pool));
+  SVN_ERR(pristine_remove_if_unreferenced(wcroot, db->shared_pristine_abspath,
+                                          sha1_checksum, scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+
+/* Remove every STRIDE-th file of the const char * abspaths in PATHS,
+ * starting with the one at index FIRST.  Pass IGNORE_ENOENT to
+ * svn_io_remove_file2().  Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+remove_pristine_files(const apr_array_header_t *paths,
+                      int first,
+                      int stride,
+                      svn_boolean_t ignore_enoent,
+                      apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  int i;
+
+  for (i = first; i < paths->nelts; i += stride)
+    {
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_io_remove_file2(APR_ARRAY_IDX(paths, i, const char *),
+                                  ignore_enoent, iterpool));
+    }
+
+  svn_pool_destroy(iterpool);
 
   return SVN_NO_ERROR;
 }
 
+/* The share of the files that a single thread removes. */
+typedef struct pristine_remover_t
+{
+  /* Parameters to remove_pristine_files(). */
+  const apr_array_header_t *paths;
+  int first;
+  int stride;
+  svn_boolean_t ignore_enoent;
+
+  /* The job removing them or NULL if the caller does it. */
+  svn_worker_pool__job_t *job;
+} pristine_remover_t;
+
+/* Implements svn_worker_pool__func_t.  BATON is the pristine_remover_t. */
+static svn_error_t *
+pristine_remove_job(void *baton,
+                    apr_pool_t *scratch_pool)
+{
+  pristine_remover_t *remover = baton;
+
+  return svn_error_trace(remove_pristine_files(remover->paths,
+                                               remover->first,
+                                               remover->stride,
+                                               remover->ignore_enoent,
+                                               scratch_pool));
+}
+
+/* Remove all files of the const char * abspaths in PATHS, passing
+ * IGNORE_ENOENT to svn_io_remove_file2().  Large sets are removed by
+ * several threads concurrently, since most of the time goes into waiting
+ * for the filesystem.  Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+remove_pristine_files_concurrently(const apr_array_header_t *paths,
+                                   svn_boolean_t ignore_enoent,
+                                   apr_pool_t *scratch_pool)
+{
+  int count = MIN(PRISTINE_REMOVE_THREADS,
+                  paths->nelts / PRISTINE_REMOVE_MIN_FILES);
+
+  if (count > 1)
+    {
+      pristine_remover_t removers[PRISTINE_REMOVE_THREADS];
+      apr_pool_t *workers_pool = svn_pool_create(scratch_pool);
+      svn_worker_pool__t *workers;
+      svn_error_t *err = SVN_NO_ERROR;
+      int i;
+
+      SVN_ERR(svn_worker_pool__create(&workers, count - 1, workers_pool));
+
+      for (i = 0; i < count; i++)
+        {
+          removers[i].paths = paths;
+          removers[i].first = i;
+          removers[i].stride = count;
+          removers[i].ignore_enoent = ignore_enoent;
+          removers[i].job = NULL;
+        }
+
+      /* The first share is ours.  If a job can't be posted, we remove
+         its share ourselves. */
+      for (i = 1; workers && i < count; i++)
+        {
+          svn_error_t *post_err
+            = svn_worker_pool__post(&removers[i].job, workers,
+                                    pristine_remove_job, &removers[i],
+                                    workers_pool);
+          if (post_err)
+            {
+              svn_error_clear(post_err);
+              removers[i].job = NULL;
+            }
+        }
+
+      for (i = 0; i < count; i++)
+        if (!removers[i].job)
+          err = svn_error_compose_create(
+                  err,
+                  remove_pristine_files(paths, i, count, ignore_enoent,
+                                        scratch_pool));
+
+      for (i = 1; i < count; i++)
+        if (removers[i].job)
+          err = svn_error_compose_create(
+                  err, svn_worker_pool__wait(removers[i].job));
+
+      svn_pool_destroy(workers_pool);
+
+      return svn_error_trace(err);
+    }
+
+  return svn_error_trace(remove_pristine_files(paths, 0, 1, ignore_enoent,
+                                               scratch_pool));
+}
+
+/* Remove all pristine texts whose reference count in WCROOT's DB is zero,
+ * both the database rows and the disk files.  Set *REMOVED to the
+ * svn_checksum_t * SHA1 checksums of the removed texts, allocated in
+ * RESULT_POOL.
+ *
+ * This function expects to be executed inside a SQLite txn that has already
+ * acquired a 'RESERVED' lock.
+ */
+static svn_error_t *
+pristine_cleanup_txn(apr_array_header_t **removed,
+                     svn_wc__db_wcroot_t *wcroot,
+                     apr_pool_t *result_pool,
+                     apr_pool_t *scratch_pool)
+{
+  svn_sqlite__stmt_t *stmt;
+  apr_array_header_t *paths;
+  svn_boolean_t have_row;
+  int affected_rows;
+  /* See pristine_remove_if_unreferenced_txn(). */
+#ifdef SVN_DEBUG
+  svn_boolean_t ignore_enoent = ! wcroot->store_pristine;
+#else
+  svn_boolean_t ignore_enoent = TRUE;
+#endif
+
+  *removed = apr_array_make(result_pool, 0, sizeof(const svn_checksum_t *));
+  paths = apr_array_make(scratch_pool, 0, sizeof(const char *));
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, wcroot->sdb,
+                                    STMT_SELECT_UNREFERENCED_PRISTINES));
+  SVN_ERR(svn_sqlite__step(&have_row, stmt));
+  while (have_row)
+    {
+      const svn_checksum_t *sha1_checksum;
+      const char *pristine_abspath;
+      svn_error_t *err;
+
+      err = svn_sqlite__column_checksum(&sha1_checksum, stmt, 0,
+                                        result_pool);
+      if (!err)
+        err = get_pristine_fname(&pristine_abspath, wcroot->abspath,
+                                 sha1_checksum, scratch_pool, scratch_pool);
+      if (err)
+        return svn_error_compose_create(err, svn_sqlite__reset(stmt));
+
+      APR_ARRAY_PUSH(*removed, const svn_checksum_t *) = sha1_checksum;
+      APR_ARRAY_PUSH(paths, const char *) = pristine_abspath;
+
+      SVN_ERR(svn_sqlite__step(&have_row, stmt));
+    }
+  SVN_ERR(svn_sqlite__reset(stmt));
+
+  if ((*removed)->nelts == 0)
+    return SVN_NO_ERROR;
+
+  /* The RESERVED lock guarantees that this deletes exactly the rows found
+     above. */
+  SVN_ERR(svn_sqlite__get_statement(&stmt, wcroot->sdb,
+                                    STMT_DELETE_UNREFERENCED_PRISTINES));
+  SVN_ERR(svn_sqlite__update(&affected_rows, stmt));
+  SVN_ERR_ASSERT(affected_rows == (*removed)->nelts);
+
+  /* Still inside the txn, so no concurrent install of the same text can
+     get in between. */
+  return svn_error_trace(remove_pristine_files_concurrently(paths,
+                                                            ignore_enoent,
+                                                            scratch_pool));
+}
 
 /* Remove all unreferenced pristines in the WC DB in WCROOT.
  *
  * Look for pristine texts whose 'refcount' in the DB is zero, and remove
- * them from the 'pristine' table and from disk.
+ * them from the 'pristine' table and from disk, all in one transaction.
+ * Drop WCROOT's references to them from the shared pristine store at
+ * SHARED_ABSPATH, unless that is NULL.
  *
  * TODO: At least check that any zero refcount is really correct, before
  *       using it.  See dev@ email thread "Pristine text missing - cleanup
@@ -831,36 +1738,34 @@ svn_wc__db_pristine_remove(svn_wc__db_t *db,
  */
 static svn_error_t *
 pristine_cleanup_wcroot(svn_wc__db_wcroot_t *wcroot,
+                        const char *shared_abspath,
                         apr_pool_t *scratch_pool)
 {
-  svn_sqlite__stmt_t *stmt;
-  svn_error_t *err = NULL;
-  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
-
-  /* Find each unreferenced pristine in the DB and remove it. */
-  SVN_ERR(svn_sqlite__get_statement(&stmt, wcroot->sdb,
-                                    STMT_SELECT_UNREFERENCED_PRISTINES));
-  while (! err)
-    {
-      svn_boolean_t have_row;
-      const svn_checksum_t *sha1_checksum;
+  apr_array_header_t *removed;
 
-      svn_pool_clear(iterpool);
-
-      SVN_ERR(svn_sqlite__step(&have_row, stmt));
-      if (! have_row)
-        break;
+  SVN_SQLITE__WITH_IMMEDIATE_TXN(
+    pristine_cleanup_txn(&removed, wcroot, scratch_pool, scratch_pool),
+    wcroot->sdb);
 
-      SVN_ERR(svn_sqlite__column_checksum(&sha1_checksum, stmt, 0,
-                                          iterpool));
-      err = pristine_remove_if_unreferenced(wcroot, sha1_checksum,
-                                            iterpool);
+  if (shared_abspath)
+    {
+      apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+      int i;
+
+      for (i = 0; i < removed->nelts; i++)
+        {
+          svn_pool_clear(iterpool);
+          svn_error_clear(shared_pristine_remove_ref(
+                            shared_abspath, wcroot->abspath,
+                            APR_ARRAY_IDX(removed, i,
+                                          const svn_checksum_t *),
+                            iterpool));
+        }
+
+      svn_pool_destroy(iterpool);
     }
 
-  svn_pool_destroy(iterpool);
-
-  return svn_error_trace(
-      svn_error_compose_create(err, svn_sqlite__reset(stmt)));
+  return SVN_NO_ERROR;
 }
 
 svn_error_t *
@@ -877,7 +1782,12 @@ svn_wc__db_pristine_cleanup(svn_wc__db_t *db,
                               wri_abspath, scratch_pool, scratch_pool));
   VERIFY_USABLE_WCROOT(wcroot);
 
-  SVN_ERR(pristine_cleanup_wcroot(wcroot, scratch_pool));
+  SVN_ERR(pristine_cleanup_wcroot(wcroot, db->shared_pristine_abspath,
+                                  scratch_pool));
+
+  if (! wcroot->store_pristine)
+    SVN_ERR(trim_pristine_cache(wcroot, db->pristine_cache_size, NULL,
+                                scratch_pool));
 
   return SVN_NO_ERROR;
 }
@@ -32,6 +32,14 @@
 
 #include "wc_db.h"
 
+/* Name of the SETTINGS row recording whether a working copy stores a
+   pristine copy of every file. */
+#define SVN_WC__SETTING_STORE_PRISTINE "store-pristine"
+
+/* Default size in megabytes of the pristine cache of working copies
+   without stored pristines. */
+#define SVN_WC__DEFAULT_PRISTINE_CACHE_SIZE 256
+
 
 struct svn_wc__db_t {
   /* We need the config whenever we run into a new WC directory, in order
@@ -52,6 +60,35 @@ struct svn_wc__db_t {
   /* Busy timeout in ms., 0 for the libsvn_subr default. */
   apr_int32_t timeout;
 
+  /* Absolute path of the machine-wide shared pristine store, or NULL
+     if there is none. */
+  const char *shared_pristine_abspath;
+
+  /* Command reporting changed paths to the status walker, or NULL. */
+  const char *fsmonitor_hook;
+
+  /* Number of threads installing working files from the work queue. */
+  int install_threads;
+
+  /* Whether read-only working files may be hard links to pristines. */
+  svn_boolean_t link_pristines;
+
+  /* Whether new working copies store a pristine copy of every file. */
+  svn_boolean_t store_pristine;
+
+  /* Number of bytes of pristine texts that working copies without
+     stored pristines keep locally. */
+  apr_int64_t pristine_cache_size;
+
+  /* Whether svn_wc__db_begin_read_snapshot() should actually open a
+     read-only snapshot connection. */
+  svn_boolean_t read_snapshot;
+
+  /* Callback used to fetch pristine texts that are not stored locally,
+     or NULL. */
+  svn_wc__pristine_fetch_func_t fetch_pristine_func;
+  void *fetch_pristine_baton;
+
   /* Map a given working copy directory to its relevant data.
      const char *local_abspath -> svn_wc__db_wcroot_t *wcroot  */
   apr_hash_t *dir_data;
@@ -107,6 +144,23 @@ typedef struct svn_wc__db_wcroot_t {
      const char *local_abspath -> svn_wc_adm_access_t *adm_access */
   apr_hash_t *access_cache;
 
+  /* Whether the pristine store holds every text referenced by this
+     wcroot.  If not, it is only a cache of recently used texts and
+     missing ones get fetched through the DB's fetch_pristine_func. */
+  svn_boolean_t store_pristine;
+
+  /* Estimated number of bytes held by the pristine cache of a wcroot
+     without stored pristines, or -1 if not known yet. */
+  apr_int64_t pristine_cache_used;
+
+  /* While svn_wc__db_begin_read_snapshot() is in effect, SDB is a
+     read-only connection allocated in SNAPSHOT_POOL and the regular
+     connection is kept in WRITABLE_SDB.  SNAPSHOT_DEPTH counts the nested
+     begin calls.  All NULL / 0 otherwise. */
+  svn_sqlite__db_t *writable_sdb;
+  apr_pool_t *snapshot_pool;
+  int snapshot_depth;
+
 } svn_wc__db_wcroot_t;
 
 
@@ -155,7 +209,7 @@ svn_wc__db_verify_no_work(svn_sqlite__db_t *sdb);
 /* Assert that the given WCROOT is usable.
    NOTE: the expression is multiply-evaluated!!  */
 #define VERIFY_USABLE_WCROOT(wcroot)  SVN_ERR_ASSERT(               \
-    (wcroot) != NULL && (wcroot)->format == SVN_WC__VERSION)
+    (wcroot) != NULL && SVN_WC__IS_CURRENT_FORMAT((wcroot)->format))
 
 /* Check if the WCROOT is usable for light db operations such as path
    calculations */
@@ -192,6 +192,10 @@ close_wcroot(void *data)
   svn_wc__db_wcroot_t *wcroot = data;
   svn_error_t *err;
 
+  /* Drop an active read snapshot, putting the regular connection back. */
+  if (wcroot->snapshot_pool)
+    svn_pool_destroy(wcroot->snapshot_pool);
+
   SVN_ERR_ASSERT_NO_RETURN(wcroot->sdb != NULL);
 
 #if defined(VERIFY_ON_CLOSE) && defined(SVN_DEBUG)
@@ -232,6 +236,10 @@ svn_wc__db_open(svn_wc__db_t **db,
   (*db)->verify_format = !open_without_upgrade;
   (*db)->enforce_empty_wq = enforce_empty_wq;
   (*db)->dir_data = apr_hash_make(result_pool);
+  (*db)->install_threads = 1;
+  (*db)->store_pristine = TRUE;
+  (*db)->pristine_cache_size
+    = (apr_int64_t)SVN_WC__DEFAULT_PRISTINE_CACHE_SIZE * 1024 * 1024;
 
   (*db)->state_pool = result_pool;
 
@@ -241,6 +249,10 @@ svn_wc__db_open(svn_wc__db_t **db,
       svn_error_t *err;
       svn_boolean_t sqlite_exclusive = FALSE;
       apr_int64_t timeout;
+      const char *shared_pristine_dir;
+      const char *fsmonitor_hook;
+      apr_int64_t install_threads;
+      apr_int64_t cache_size;
 
       err = svn_config_get_bool(config, &sqlite_exclusive,
                                 SVN_CONFIG_SECTION_WORKING_COPY,
@@ -261,12 +273,100 @@ svn_wc__db_open(svn_wc__db_t **db,
         svn_error_clear(err);
       else
         (*db)->timeout = (apr_int32_t)timeout;
+
+      /* Relative paths would depend on the current working directory
+         and could not be shared reliably; ignore them. */
+      svn_config_get(config, &shared_pristine_dir,
+                     SVN_CONFIG_SECTION_WORKING_COPY,
+                     SVN_CONFIG_OPTION_SHARED_PRISTINE_DIR, NULL);
+      if (shared_pristine_dir && *shared_pristine_dir)
+        {
+          shared_pristine_dir = svn_dirent_internal_style(shared_pristine_dir,
+                                                          result_pool);
+          if (svn_dirent_is_absolute(shared_pristine_dir))
+            (*db)->shared_pristine_abspath = shared_pristine_dir;
+        }
+
+      svn_config_get(config, &fsmonitor_hook,
+                     SVN_CONFIG_SECTION_WORKING_COPY,
+                     SVN_CONFIG_OPTION_FSMONITOR_HOOK, NULL);
+      if (fsmonitor_hook && *fsmonitor_hook)
+        (*db)->fsmonitor_hook = apr_pstrdup(result_pool, fsmonitor_hook);
+
+      err = svn_config_get_int64(config, &install_threads,
+                                 SVN_CONFIG_SECTION_WORKING_COPY,
+                                 SVN_CONFIG_OPTION_INSTALL_THREADS,
+                                 1);
+      if (err || install_threads < 1 || install_threads > 64)
+        svn_error_clear(err);
+      else
+        (*db)->install_threads = (int)install_threads;
+
+      err = svn_config_get_bool(config, &(*db)->link_pristines,
+                                SVN_CONFIG_SECTION_WORKING_COPY,
+                                SVN_CONFIG_OPTION_LINK_PRISTINES,
+                                FALSE);
+      if (err)
+        {
+          svn_error_clear(err);
+          (*db)->link_pristines = FALSE;
+        }
+
+      err = svn_config_get_bool(config, &(*db)->read_snapshot,
+                                SVN_CONFIG_SECTION_WORKING_COPY,
+                                SVN_CONFIG_OPTION_SQLITE_READ_SNAPSHOT,
+                                FALSE);
+      if (err)
+        {
+          svn_error_clear(err);
+          (*db)->read_snapshot = FALSE;
+        }
+
+      err = svn_config_get_bool(config, &(*db)->store_pristine,
+                                SVN_CONFIG_SECTION_WORKING_COPY,
+                                SVN_CONFIG_OPTION_STORE_PRISTINE,
+                                TRUE);
+      if (err)
+        {
+          svn_error_clear(err);
+          (*db)->store_pristine = TRUE;
+        }
+
+      err = svn_config_get_int64(config, &cache_size,
+                                 SVN_CONFIG_SECTION_WORKING_COPY,
+                                 SVN_CONFIG_OPTION_PRISTINE_CACHE_SIZE,
+                                 SVN_WC__DEFAULT_PRISTINE_CACHE_SIZE);
+      if (err || cache_size < 0 || cache_size > APR_INT32_MAX)
+        svn_error_clear(err);
+      else
+        (*db)->pristine_cache_size = cache_size * 1024 * 1024;
     }
 
   return SVN_NO_ERROR;
 }
 
 
+const char *
+svn_wc__db_get_fsmonitor_hook(svn_wc__db_t *db)
+{
+  return db->fsmonitor_hook;
+}
+
+
+int
+svn_wc__db_get_install_threads(svn_wc__db_t *db)
+{
+  return db->install_threads;
+}
+
+
+svn_boolean_t
+svn_wc__db_get_link_pristines(svn_wc__db_t *db)
+{
+  return db->link_pristines;
+}
+
+
 svn_error_t *
 svn_wc__db_close(svn_wc__db_t *db)
 {
@@ -294,6 +394,36 @@ svn_wc__db_close(svn_wc__db_t *db)
 }
 
 
+/* Set *STORE_PRISTINE to the store-pristine setting of the working copy
+   WC_ID in SDB.  Working copies that never changed it store pristines. */
+static svn_error_t *
+read_store_pristine(svn_boolean_t *store_pristine,
+                    svn_sqlite__db_t *sdb,
+                    apr_int64_t wc_id,
+                    apr_pool_t *scratch_pool)
+{
+  svn_sqlite__stmt_t *stmt;
+  svn_boolean_t have_row;
+
+  *store_pristine = TRUE;
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, sdb, STMT_HAVE_SETTINGS_TABLE));
+  SVN_ERR(svn_sqlite__step(&have_row, stmt));
+  SVN_ERR(svn_sqlite__reset(stmt));
+  if (!have_row)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, sdb, STMT_SELECT_SETTING));
+  SVN_ERR(svn_sqlite__bindf(stmt, "is", wc_id,
+                            SVN_WC__SETTING_STORE_PRISTINE));
+  SVN_ERR(svn_sqlite__step(&have_row, stmt));
+  if (have_row && !svn_sqlite__column_is_null(stmt, 0))
+    *store_pristine = svn_sqlite__column_boolean(stmt, 0);
+
+  return svn_error_trace(svn_sqlite__reset(stmt));
+}
+
+
 svn_error_t *
 svn_wc__db_pdh_create_wcroot(svn_wc__db_wcroot_t **wcroot,
                              const char *wcroot_abspath,
@@ -321,7 +451,7 @@ svn_wc__db_pdh_create_wcroot(svn_wc__db_wcroot_t **wcroot,
     }
 
   /* If this working copy is from a future version, then bail out.  */
-  if (format > SVN_WC__VERSION)
+  if (format > SVN_WC__STORE_PRISTINE_VERSION)
     {
       return svn_error_createf(
         SVN_ERR_WC_UNSUPPORTED_FORMAT, NULL,
@@ -377,6 +507,12 @@ svn_wc__db_pdh_create_wcroot(svn_wc__db_wcroot_t **wcroot,
   (*wcroot)->owned_locks = apr_array_make(result_pool, 8,
                                           sizeof(svn_wc__db_wclock_t));
   (*wcroot)->access_cache = apr_hash_make(result_pool);
+  (*wcroot)->store_pristine = TRUE;
+  (*wcroot)->pristine_cache_used = -1;
+
+  if (sdb != NULL && SVN_WC__IS_CURRENT_FORMAT(format))
+    SVN_ERR(read_store_pristine(&(*wcroot)->store_pristine, sdb, wc_id,
+                                scratch_pool));
 
   /* SDB will be NULL for pre-NG working copies. We only need to run a
      cleanup when the SDB is present.  */
@@ -408,6 +544,119 @@ svn_wc__db_close_many_wcroots(apr_hash_t *roots,
 }
 
 
+/* Pool cleanup handler that puts the regular connection of the
+   svn_wc__db_wcroot_t in DATA back in place, after its snapshot
+   connection got closed. */
+static apr_status_t
+end_read_snapshot_cleanup(void *data)
+{
+  svn_wc__db_wcroot_t *wcroot = data;
+
+  wcroot->sdb = wcroot->writable_sdb;
+  wcroot->writable_sdb = NULL;
+  wcroot->snapshot_pool = NULL;
+  wcroot->snapshot_depth = 0;
+
+  return APR_SUCCESS;
+}
+
+svn_error_t *
+svn_wc__db_begin_read_snapshot(svn_wc__db_t *db,
+                               const char *local_abspath,
+                               apr_pool_t *scratch_pool)
+{
+  svn_wc__db_wcroot_t *wcroot;
+  const char *local_relpath;
+  svn_sqlite__db_t *snapshot_sdb;
+  apr_pool_t *snapshot_pool;
+  svn_error_t *err;
+
+  /* An exclusively locked database would also lock us out. */
+  if (!db->read_snapshot || db->exclusive)
+    return SVN_NO_ERROR;
+
+  /* The snapshot is only an optimization; leave reporting a missing or
+     unusable working copy to the actual operation. */
+  err = svn_wc__db_wcroot_parse_local_abspath(&wcroot, &local_relpath, db,
+                                              local_abspath,
+                                              scratch_pool, scratch_pool);
+  if (err || !wcroot || !SVN_WC__IS_CURRENT_FORMAT(wcroot->format))
+    {
+      svn_error_clear(err);
+      return SVN_NO_ERROR;
+    }
+
+  if (wcroot->snapshot_depth)
+    {
+      wcroot->snapshot_depth++;
+      return SVN_NO_ERROR;
+    }
+
+  snapshot_pool = svn_pool_create(db->state_pool);
+  err = svn_wc__db_util_open_db(&snapshot_sdb, wcroot->abspath, SDB_FILE,
+                                svn_sqlite__mode_readonly, FALSE,
+                                db->timeout, NULL,
+                                snapshot_pool, scratch_pool);
+  if (!err)
+    err = svn_sqlite__begin_read_snapshot(snapshot_sdb);
+  if (err)
+    {
+      svn_pool_destroy(snapshot_pool);
+      return svn_error_trace(err);
+    }
+
+  wcroot->writable_sdb = wcroot->sdb;
+  wcroot->sdb = snapshot_sdb;
+  wcroot->snapshot_pool = snapshot_pool;
+  wcroot->snapshot_depth = 1;
+
+  /* Registered after the connection's own cleanup, so this runs first. */
+  apr_pool_cleanup_register(snapshot_pool, wcroot, end_read_snapshot_cleanup,
+                            apr_pool_cleanup_null);
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_wc__db_end_read_snapshot(svn_wc__db_t *db,
+                             const char *local_abspath,
+                             svn_error_t *err,
+                             apr_pool_t *scratch_pool)
+{
+  svn_wc__db_wcroot_t *wcroot;
+  const char *local_relpath;
+  svn_sqlite__db_t *snapshot_sdb;
+  apr_pool_t *snapshot_pool;
+  svn_error_t *err2;
+
+  if (!db->read_snapshot || db->exclusive)
+    return svn_error_trace(err);
+
+  err2 = svn_wc__db_wcroot_parse_local_abspath(&wcroot, &local_relpath, db,
+                                               local_abspath,
+                                               scratch_pool, scratch_pool);
+  if (err2)
+    {
+      svn_error_clear(err2);
+      return svn_error_trace(err);
+    }
+
+  if (!wcroot || !wcroot->snapshot_depth || --wcroot->snapshot_depth)
+    return svn_error_trace(err);
+
+  snapshot_sdb = wcroot->sdb;
+  snapshot_pool = wcroot->snapshot_pool;
+
+  err = svn_sqlite__end_read_snapshot(snapshot_sdb, err);
+  err = svn_error_compose_create(err, svn_sqlite__close(snapshot_sdb));
+
+  /* Puts the regular connection back. */
+  svn_pool_destroy(snapshot_pool);
+
+  return svn_error_trace(err);
+}
+
+
 /* POOL may be NULL if the lifetime of LOCAL_ABSPATH is sufficient.  */
 static const char *
 compute_relpath(const svn_wc__db_wcroot_t *wcroot,
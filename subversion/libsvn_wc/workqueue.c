@@ -30,6 +30,7 @@
 #include "svn_subst.h"
 #include "svn_hash.h"
 #include "svn_io.h"
+#include "svn_sorts.h"
 
 #include "wc.h"
 #include "wc_db.h"
@@ -40,6 +41,8 @@
 
 #include "private/svn_io_private.h"
 #include "private/svn_skel.h"
+#include "private/svn_subst_private.h"
+#include "private/svn_worker_pool.h"
 
 
 /* Workqueue operation names.  */
@@ -66,6 +69,15 @@
 
 typedef struct work_item_baton_t work_item_baton_t;
 
+struct work_item_baton_t
+{
+  apr_pool_t *result_pool; /* Pool to allocate result in */
+
+  svn_boolean_t used; /* needs reset */
+
+  apr_hash_t *record_map; /* const char * -> svn_io_dirent2_t map */
+};
+
 struct work_item_dispatch {
   const char *name;
   svn_error_t *(*func)(work_item_baton_t *wqb,
@@ -75,15 +87,24 @@ struct work_item_dispatch {
                        svn_cancel_func_t cancel_func,
                        void *cancel_baton,
                        apr_pool_t *scratch_pool);
+
+  /* Whether FUNC writes to the working copy DB itself rather than only
+     through the work item baton. */
+  svn_boolean_t writes_db;
 };
 
-/* Forward definition */
+/* Forward definitions */
 static svn_error_t *
 get_and_record_fileinfo(work_item_baton_t *wqb,
                         const char *local_abspath,
                         svn_boolean_t ignore_enoent,
                         apr_pool_t *scratch_pool);
 
+static void
+record_dirent(work_item_baton_t *wqb,
+              const char *local_abspath,
+              const svn_io_dirent2_t *dirent);
+
 /* ------------------------------------------------------------------------ */
 /* OP_REMOVE_BASE  */
 
@@ -445,60 +466,106 @@ svn_wc__wq_build_postupgrade(svn_skel_t **work_item,
 
 /* OP_FILE_INSTALL */
 
-/* Process the OP_FILE_INSTALL work item WORK_ITEM.
- * See svn_wc__wq_build_file_install() which generates this work item.
- * Implements (struct work_item_dispatch).func. */
-static svn_error_t *
-run_file_install(work_item_baton_t *wqb,
-                 svn_wc__db_t *db,
-                 const svn_skel_t *work_item,
-                 const char *wri_abspath,
-                 svn_cancel_func_t cancel_func,
-                 void *cancel_baton,
-                 apr_pool_t *scratch_pool)
+/* The on-disk part of an OP_FILE_INSTALL work item, as determined from
+ * the working copy DB by prepare_file_install().  Carrying it out needs
+ * no DB access, so it may happen in any thread.
+ */
+typedef struct file_install_t
 {
-  const svn_skel_t *arg1 = work_item->children->next;
-  const svn_skel_t *arg4 = arg1->next->next->next;
-  const char *local_relpath;
+  /* The file to install and the pristine (or other) text to install it
+     from. */
   const char *local_abspath;
-  svn_boolean_t use_commit_times;
-  svn_boolean_t record_fileinfo;
-  svn_boolean_t special;
-  svn_stream_t *src_stream;
+  const char *source_abspath;
+
+  /* Translation of the source text. */
   svn_subst_eol_style_t style;
   const char *eol;
   apr_hash_t *keywords;
+  svn_boolean_t special;
+
+  /* Where to put the file while translating it. */
   const char *temp_dir_abspath;
-  svn_stream_t *dst_stream;
+
+  /* Flags and timestamp to set on the installed file; 0 for no
+     timestamp. */
+  svn_boolean_t set_executable;
+  svn_boolean_t set_read_only;
+  apr_time_t affected_time;
+
+  /* Whether the size and timestamp of the result shall be recorded. */
+  svn_boolean_t record_fileinfo;
+
+  /* Whether the file may be a hard link to its pristine. */
+  svn_boolean_t link_pristine;
+
+  /* Whether SOURCE_ABSPATH is a private copy of the pristine that may be
+     moved into place. */
+  svn_boolean_t move_source;
+} file_install_t;
+
+/* Read everything required to process the OP_FILE_INSTALL work item
+ * WORK_ITEM from DB and return it in *INSTALL, allocated in RESULT_POOL.
+ */
+static svn_error_t *
+prepare_file_install(file_install_t **install,
+                     svn_wc__db_t *db,
+                     const svn_skel_t *work_item,
+                     const char *wri_abspath,
+                     apr_pool_t *result_pool,
+                     apr_pool_t *scratch_pool)
+{
+  const svn_skel_t *arg1 = work_item->children->next;
+  const svn_skel_t *arg4 = arg1->next->next->next;
+  file_install_t *result = apr_pcalloc(result_pool, sizeof(*result));
+  const char *local_relpath;
+  svn_boolean_t use_commit_times;
   apr_int64_t val;
   const char *wcroot_abspath;
-  const char *source_abspath;
   const svn_checksum_t *checksum;
   apr_hash_t *props;
   apr_time_t changed_date;
 
   local_relpath = apr_pstrmemdup(scratch_pool, arg1->data, arg1->len);
-  SVN_ERR(svn_wc__db_from_relpath(&local_abspath, db, wri_abspath,
-                                  local_relpath, scratch_pool, scratch_pool));
+  SVN_ERR(svn_wc__db_from_relpath(&result->local_abspath, db, wri_abspath,
+                                  local_relpath, result_pool, scratch_pool));
 
   SVN_ERR(svn_skel__parse_int(&val, arg1->next, scratch_pool));
   use_commit_times = (val != 0);
   SVN_ERR(svn_skel__parse_int(&val, arg1->next->next, scratch_pool));
-  record_fileinfo = (val != 0);
+  result->record_fileinfo = (val != 0);
 
   SVN_ERR(svn_wc__db_read_node_install_info(&wcroot_abspath,
                                             &checksum, &props,
                                             &changed_date,
-                                            db, local_abspath, wri_abspath,
-                                            scratch_pool, scratch_pool));
+                                            db, result->local_abspath,
+                                            wri_abspath,
+                                            result_pool, scratch_pool));
 
   if (arg4 != NULL)
     {
       /* Use the provided path for the source.  */
       local_relpath = apr_pstrmemdup(scratch_pool, arg4->data, arg4->len);
-      SVN_ERR(svn_wc__db_from_relpath(&source_abspath, db, wri_abspath,
-                                      local_relpath,
-                                      scratch_pool, scratch_pool));
+      SVN_ERR(svn_wc__db_from_relpath(&result->source_abspath, db,
+                                      wri_abspath, local_relpath,
+                                      result_pool, scratch_pool));
+
+      if (arg4->next != NULL)
+        {
+          SVN_ERR(svn_skel__parse_int(&val, arg4->next, scratch_pool));
+          result->move_source = (val != 0);
+        }
+
+      if (result->move_source)
+        {
+          svn_node_kind_t kind;
+
+          /* If an earlier run of this item was interrupted after moving
+             the copy into place, install the file from itself. */
+          SVN_ERR(svn_io_check_path(result->source_abspath, &kind,
+                                    scratch_pool));
+          if (kind == svn_node_none)
+            result->source_abspath = result->local_abspath;
+        }
     }
   else if (! checksum)
     {
@@ -513,27 +580,204 @@ run_file_install(work_item_baton_t *wqb,
                                _("Can't install '%s' from pristine store, "
                                  "because no checksum is recorded for this "
                                  "file"),
-                               svn_dirent_local_style(local_abspath,
+                               svn_dirent_local_style(result->local_abspath,
                                                       scratch_pool));
     }
   else
     {
-      SVN_ERR(svn_wc__db_pristine_get_future_path(&source_abspath,
+      /* The install itself only touches the disk, so fetch the text now
+         if this working copy doesn't store it. */
+      SVN_ERR(svn_wc__db_pristine_hydrate(db, wcroot_abspath, checksum,
+                                          scratch_pool));
+      SVN_ERR(svn_wc__db_pristine_get_future_path(&result->source_abspath,
                                                   wcroot_abspath,
                                                   checksum,
-                                                  scratch_pool, scratch_pool));
+                                                  result_pool, scratch_pool));
+      result->link_pristine = svn_wc__db_get_link_pristines(db);
     }
 
-  SVN_ERR(svn_stream_open_readonly(&src_stream, source_abspath,
-                                   scratch_pool, scratch_pool));
-
   /* Fetch all the translation bits.  */
-  SVN_ERR(svn_wc__get_translate_info(&style, &eol,
-                                     &keywords,
-                                     &special, db, local_abspath,
+  SVN_ERR(svn_wc__get_translate_info(&result->style, &result->eol,
+                                     &result->keywords,
+                                     &result->special, db,
+                                     result->local_abspath,
                                      props, FALSE,
-                                     scratch_pool, scratch_pool));
-  if (special)
+                                     result_pool, scratch_pool));
+  if (result->special)
+    {
+      /* No need to set exec or read-only flags on special files.  */
+      *install = result;
+      return SVN_NO_ERROR;
+    }
+
+  /* Where is the Right Place to put a temp file in this working copy?  */
+  SVN_ERR(svn_wc__db_temp_wcroot_tempdir(&result->temp_dir_abspath,
+                                         db, wcroot_abspath,
+                                         result_pool, scratch_pool));
+
+#ifndef WIN32
+  result->set_executable = (props
+                            && svn_hash_gets(props, SVN_PROP_EXECUTABLE));
+#endif
+
+  /* Note that this explicitly checks the pristine properties, to make sure
+     that when the lock is locally set (=modification) it is not read only */
+  if (props && svn_hash_gets(props, SVN_PROP_NEEDS_LOCK))
+    {
+      svn_wc__db_status_t status;
+      svn_wc__db_lock_t *lock;
+      SVN_ERR(svn_wc__db_read_info(&status, NULL, NULL, NULL, NULL, NULL, NULL,
+                                   NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+                                   NULL, NULL, &lock, NULL, NULL, NULL, NULL,
+                                   NULL, NULL, NULL, NULL, NULL, NULL,
+                                   db, result->local_abspath,
+                                   scratch_pool, scratch_pool));
+
+      result->set_read_only = (!lock && status != svn_wc__db_status_added);
+    }
+
+  if (use_commit_times)
+    result->affected_time = changed_date;
+
+  *install = result;
+  return SVN_NO_ERROR;
+}
+
+/* Install the untranslated source of INSTALL as a hard link to it if that
+ * is allowed and possible.  Set *INSTALLED to FALSE if it is not.
+ *
+ * The link shares its mode and timestamps with the pristine and all other
+ * links to it.  That is fine for read-only files that need no tweaks, as
+ * long as svn_wc__set_file_read_write() breaks the link before the file
+ * may be modified.
+ */
+static svn_error_t *
+install_hardlink(svn_boolean_t *installed,
+                 const file_install_t *install,
+                 apr_pool_t *scratch_pool)
+{
+  const char *tmp_abspath;
+  svn_error_t *err;
+
+  *installed = FALSE;
+  if (!install->link_pristine || !install->set_read_only
+      || install->set_executable || install->affected_time)
+    return SVN_NO_ERROR;
+
+  /* Reserve a unique name for the link. */
+  SVN_ERR(svn_io_open_unique_file3(NULL, &tmp_abspath,
+                                   install->temp_dir_abspath,
+                                   svn_io_file_del_none,
+                                   scratch_pool, scratch_pool));
+  SVN_ERR(svn_io_remove_file2(tmp_abspath, FALSE, scratch_pool));
+
+  SVN_ERR(svn_io__create_hardlink(installed, install->source_abspath,
+                                  tmp_abspath, scratch_pool));
+  if (!*installed)
+    return SVN_NO_ERROR;
+
+  err = svn_io_file_rename2(tmp_abspath, install->local_abspath, FALSE,
+                            scratch_pool);
+  if (err && APR_STATUS_IS_ENOENT(err->apr_err))
+    {
+      svn_error_clear(err);
+      err = svn_io_make_dir_recursively(
+              svn_dirent_dirname(install->local_abspath, scratch_pool),
+              scratch_pool);
+      if (!err)
+        err = svn_io_file_rename2(tmp_abspath, install->local_abspath, FALSE,
+                                  scratch_pool);
+    }
+
+  if (err)
+    return svn_error_compose_create(
+                          err,
+                          svn_io_remove_file2(tmp_abspath, TRUE,
+                                              scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Copy the untranslated source of INSTALL into place.  This lets the
+ * kernel clone or copy the data where possible, see svn_io_copy_file().
+ */
+static svn_error_t *
+install_copy(const file_install_t *install,
+             apr_pool_t *scratch_pool)
+{
+  svn_error_t *err = svn_io_copy_file(install->source_abspath,
+                                      install->local_abspath, FALSE,
+                                      scratch_pool);
+
+  /* With a single db we might want to install files in a missing
+     directory, see perform_file_install(). */
+  if (err && APR_STATUS_IS_ENOENT(err->apr_err))
+    {
+      svn_error_clear(err);
+      SVN_ERR(svn_io_make_dir_recursively(
+                svn_dirent_dirname(install->local_abspath, scratch_pool),
+                scratch_pool));
+      err = svn_io_copy_file(install->source_abspath,
+                             install->local_abspath, FALSE, scratch_pool);
+    }
+
+  return svn_error_trace(err);
+}
+
+/* Move the untranslated source of INSTALL, a private copy of the pristine,
+ * into place.
+ */
+static svn_error_t *
+install_move(const file_install_t *install,
+             apr_pool_t *scratch_pool)
+{
+  svn_error_t *err;
+
+  /* Already done, see prepare_file_install(). */
+  if (!strcmp(install->source_abspath, install->local_abspath))
+    return SVN_NO_ERROR;
+
+  err = svn_io_file_rename2(install->source_abspath, install->local_abspath,
+                            FALSE, scratch_pool);
+
+  /* With a single db we might want to install files in a missing
+     directory, see perform_file_install(). */
+  if (err && APR_STATUS_IS_ENOENT(err->apr_err))
+    {
+      svn_error_clear(err);
+      SVN_ERR(svn_io_make_dir_recursively(
+                svn_dirent_dirname(install->local_abspath, scratch_pool),
+                scratch_pool));
+      err = svn_io_file_rename2(install->source_abspath,
+                                install->local_abspath, FALSE, scratch_pool);
+    }
+
+  return svn_error_trace(err);
+}
+
+/* Translate and move the file described by INSTALL into place.  If its
+ * file info shall be recorded, set *DIRENT to the installed file's
+ * dirent, allocated in RESULT_POOL, and to NULL otherwise.
+ */
+static svn_error_t *
+perform_file_install(const svn_io_dirent2_t **dirent,
+                     const file_install_t *install,
+                     svn_cancel_func_t cancel_func,
+                     void *cancel_baton,
+                     apr_pool_t *result_pool,
+                     apr_pool_t *scratch_pool)
+{
+  const char *local_abspath = install->local_abspath;
+  svn_stream_t *src_stream;
+  svn_stream_t *dst_stream;
+  svn_boolean_t translate = FALSE;
+
+  *dirent = NULL;
+
+  SVN_ERR(svn_stream_open_readonly(&src_stream, install->source_abspath,
+                                   scratch_pool, scratch_pool));
+
+  if (install->special)
     {
       /* When this stream is closed, the resulting special file will
          atomically be created/moved into place at LOCAL_ABSPATH.  */
@@ -546,87 +790,120 @@ run_file_install(work_item_baton_t *wqb,
                                cancel_func, cancel_baton,
                                scratch_pool));
 
-      /* No need to set exec or read-only flags on special files.  */
-
       /* ### Shouldn't this record a timestamp and size, etc.? */
       return SVN_NO_ERROR;
     }
 
-  if (svn_subst_translation_required(style, eol, keywords,
+  if (svn_subst_translation_required(install->style, install->eol,
+                                     install->keywords,
                                      FALSE /* special */,
                                      TRUE /* force_eol_check */))
+    {
+      svn_boolean_t noop;
+
+      /* Most files are already in their working form, e.g. LF-only text
+         with svn:eol-style=native on Unix.  Copy those as they are. */
+      SVN_ERR(svn_subst__translation_is_noop(&noop, src_stream,
+                                             install->eol, install->keywords,
+                                             scratch_pool));
+      translate = !noop;
+    }
+
+  if (translate)
     {
       /* Wrap it in a translating (expanding) stream.  */
-      src_stream = svn_subst_stream_translated(src_stream, eol,
+      SVN_ERR(svn_stream_reset(src_stream));
+      src_stream = svn_subst_stream_translated(src_stream, install->eol,
                                                TRUE /* repair */,
-                                               keywords,
+                                               install->keywords,
                                                TRUE /* expand */,
                                                scratch_pool);
+
+      /* Translate to a temporary file. We don't want the user seeing a
+         partial file, nor let them muck with it while we translate. We may
+         also need to get its TRANSLATED_SIZE before the user can monkey
+         it.  */
+      SVN_ERR(svn_stream__create_for_install(&dst_stream,
+                                             install->temp_dir_abspath,
+                                             scratch_pool, scratch_pool));
+
+      /* Copy from the source to the dest, translating as we go. This will
+         also close both streams.  */
+      SVN_ERR(svn_stream_copy3(src_stream, dst_stream,
+                               cancel_func, cancel_baton,
+                               scratch_pool));
+
+      /* All done. Move the file into place.  */
+      /* With a single db we might want to install files in a missing
+         directory.  Simply trying this scenario on error won't do any harm
+         and at least one user reported this problem on IRC. */
+      SVN_ERR(svn_stream__install_stream(dst_stream, local_abspath,
+                                         TRUE /* make_parents*/,
+                                         scratch_pool));
     }
+  else
+    {
+      /* The file's contents are the pristine's.  Share them if we may,
+         otherwise copy them, as cheaply as the OS allows. */
+      svn_boolean_t linked;
 
-  /* Where is the Right Place to put a temp file in this working copy?  */
-  SVN_ERR(svn_wc__db_temp_wcroot_tempdir(&temp_dir_abspath,
-                                         db, wcroot_abspath,
-                                         scratch_pool, scratch_pool));
-
-  /* Translate to a temporary file. We don't want the user seeing a partial
-     file, nor let them muck with it while we translate. We may also need to
-     get its TRANSLATED_SIZE before the user can monkey it.  */
-  SVN_ERR(svn_stream__create_for_install(&dst_stream, temp_dir_abspath,
-                                         scratch_pool, scratch_pool));
-
-  /* Copy from the source to the dest, translating as we go. This will also
-     close both streams.  */
-  SVN_ERR(svn_stream_copy3(src_stream, dst_stream,
-                           cancel_func, cancel_baton,
-                           scratch_pool));
-
-  /* All done. Move the file into place.  */
-  /* With a single db we might want to install files in a missing directory.
-     Simply trying this scenario on error won't do any harm and at least
-     one user reported this problem on IRC. */
-  SVN_ERR(svn_stream__install_stream(dst_stream, local_abspath,
-                                     TRUE /* make_parents*/, scratch_pool));
+      SVN_ERR(svn_stream_close(src_stream));
+      if (cancel_func)
+        SVN_ERR(cancel_func(cancel_baton));
+
+      if (install->move_source)
+        SVN_ERR(install_move(install, scratch_pool));
+      else
+        {
+          SVN_ERR(install_hardlink(&linked, install, scratch_pool));
+          if (!linked)
+            SVN_ERR(install_copy(install, scratch_pool));
+        }
+    }
 
   /* Tweak the on-disk file according to its properties.  */
-#ifndef WIN32
-  if (props && svn_hash_gets(props, SVN_PROP_EXECUTABLE))
+  if (install->set_executable)
     SVN_ERR(svn_io_set_file_executable(local_abspath, TRUE, FALSE,
                                        scratch_pool));
-#endif
-
-  /* Note that this explicitly checks the pristine properties, to make sure
-     that when the lock is locally set (=modification) it is not read only */
-  if (props && svn_hash_gets(props, SVN_PROP_NEEDS_LOCK))
-    {
-      svn_wc__db_status_t status;
-      svn_wc__db_lock_t *lock;
-      SVN_ERR(svn_wc__db_read_info(&status, NULL, NULL, NULL, NULL, NULL, NULL,
-                                   NULL, NULL, NULL, NULL, NULL, NULL, NULL,
-                                   NULL, NULL, &lock, NULL, NULL, NULL, NULL,
-                                   NULL, NULL, NULL, NULL, NULL, NULL,
-                                   db, local_abspath,
-                                   scratch_pool, scratch_pool));
 
-      if (!lock && status != svn_wc__db_status_added)
-        SVN_ERR(svn_io_set_file_read_only(local_abspath, FALSE, scratch_pool));
-    }
+  if (install->set_read_only)
+    SVN_ERR(svn_io_set_file_read_only(local_abspath, FALSE, scratch_pool));
 
-  if (use_commit_times)
-    {
-      if (changed_date)
-        SVN_ERR(svn_io_set_file_affected_time(changed_date,
-                                              local_abspath,
-                                              scratch_pool));
-    }
+  if (install->affected_time)
+    SVN_ERR(svn_io_set_file_affected_time(install->affected_time,
+                                          local_abspath,
+                                          scratch_pool));
 
   /* ### this should happen before we rename the file into place.  */
-  if (record_fileinfo)
-    {
-      SVN_ERR(get_and_record_fileinfo(wqb, local_abspath,
-                                      FALSE /* ignore_enoent */,
-                                      scratch_pool));
-    }
+  if (install->record_fileinfo)
+    SVN_ERR(svn_io_stat_dirent2(dirent, local_abspath, FALSE, FALSE,
+                                result_pool, scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Process the OP_FILE_INSTALL work item WORK_ITEM.
+ * See svn_wc__wq_build_file_install() which generates this work item.
+ * Implements (struct work_item_dispatch).func. */
+static svn_error_t *
+run_file_install(work_item_baton_t *wqb,
+                 svn_wc__db_t *db,
+                 const svn_skel_t *work_item,
+                 const char *wri_abspath,
+                 svn_cancel_func_t cancel_func,
+                 void *cancel_baton,
+                 apr_pool_t *scratch_pool)
+{
+  file_install_t *install;
+  const svn_io_dirent2_t *dirent;
+
+  SVN_ERR(prepare_file_install(&install, db, work_item, wri_abspath,
+                               scratch_pool, scratch_pool));
+  SVN_ERR(perform_file_install(&dirent, install, cancel_func, cancel_baton,
+                               wqb->result_pool, scratch_pool));
+
+  if (dirent)
+    record_dirent(wqb, install->local_abspath, dirent);
 
   return SVN_NO_ERROR;
 }
@@ -672,6 +949,26 @@ svn_wc__wq_build_file_install(svn_skel_t **work_item,
   return SVN_NO_ERROR;
 }
 
+svn_error_t *
+svn_wc__wq_build_file_install_from_copy(svn_skel_t **work_item,
+                                        svn_wc__db_t *db,
+                                        const char *local_abspath,
+                                        const char *copy_abspath,
+                                        svn_boolean_t use_commit_times,
+                                        apr_pool_t *result_pool,
+                                        apr_pool_t *scratch_pool)
+{
+  /* Older clients ignore the trailing flag and install from the copy. */
+  SVN_ERR(svn_wc__wq_build_file_install(work_item, db, local_abspath,
+                                        copy_abspath, use_commit_times,
+                                        TRUE /* record_fileinfo */,
+                                        result_pool, scratch_pool));
+  svn_skel__append(*work_item,
+                   svn_skel__str_atom("1", result_pool));
+
+  return SVN_NO_ERROR;
+}
+
 
 /* ------------------------------------------------------------------------ */
 
@@ -1385,7 +1682,7 @@ run_set_property_conflict_marker(work_item_baton_t *wqb,
 /* ------------------------------------------------------------------------ */
 
 static const struct work_item_dispatch dispatch_table[] = {
-  { OP_FILE_COMMIT, run_file_commit },
+  { OP_FILE_COMMIT, run_file_commit, TRUE },
   { OP_FILE_INSTALL, run_file_install },
   { OP_FILE_REMOVE, run_file_remove },
   { OP_FILE_MOVE, run_file_move },
@@ -1396,27 +1693,32 @@ static const struct work_item_dispatch dispatch_table[] = {
   { OP_DIRECTORY_INSTALL, run_dir_install },
 
   /* Upgrade steps */
-  { OP_POSTUPGRADE, run_postupgrade },
+  { OP_POSTUPGRADE, run_postupgrade, TRUE },
 
   /* Legacy workqueue items. No longer created */
-  { OP_BASE_REMOVE, run_base_remove },
+  { OP_BASE_REMOVE, run_base_remove, TRUE },
   { OP_RECORD_FILEINFO, run_record_fileinfo },
-  { OP_TMP_SET_TEXT_CONFLICT_MARKERS, run_set_text_conflict_markers },
-  { OP_TMP_SET_PROPERTY_CONFLICT_MARKER, run_set_property_conflict_marker },
+  { OP_TMP_SET_TEXT_CONFLICT_MARKERS, run_set_text_conflict_markers, TRUE },
+  { OP_TMP_SET_PROPERTY_CONFLICT_MARKER, run_set_property_conflict_marker, TRUE },
 
   /* Sentinel.  */
   { NULL }
 };
 
-struct work_item_baton_t
-{
-  apr_pool_t *result_pool; /* Pool to allocate result in */
 
-  svn_boolean_t used; /* needs reset */
+/* Return the dispatch table entry for WORK_ITEM, or NULL if there is
+   none. */
+static const struct work_item_dispatch *
+find_dispatch(const svn_skel_t *work_item)
+{
+  const struct work_item_dispatch *scan;
 
-  apr_hash_t *record_map; /* const char * -> svn_io_dirent2_t map */
-};
+  for (scan = &dispatch_table[0]; scan->name != NULL; ++scan)
+    if (svn_skel__matches_atom(work_item->children, scan->name))
+      return scan;
 
+  return NULL;
+}
 
 static svn_error_t *
 dispatch_work_item(work_item_baton_t *wqb,
@@ -1474,16 +1776,267 @@ dispatch_work_item(work_item_baton_t *wqb,
 }
 
 
-svn_error_t *
-svn_wc__wq_run(svn_wc__db_t *db,
+/* ------------------------------------------------------------------------ */
+
+/* Concurrent file installation.
+ *
+ * Checkouts and updates of large trees queue an OP_FILE_INSTALL for every
+ * file and then spend most of the time running them waiting for the disk
+ * to translate, write and rename the working files.  Consecutive installs
+ * of different files don't depend on each other, so svn_wc__wq_run()
+ * reads what it needs for them from the DB and lets worker threads carry
+ * them out while it looks further ahead in the queue.  Once the batch is
+ * complete, all its items get removed from the queue together with
+ * recording the file info, in a single DB transaction.  After a crash,
+ * they will simply be run again.
+ */
+
+#if APR_HAS_THREADS
+
+/* Upper limit to the number of worker threads of an installer. */
+#define INSTALL_MAX_THREADS 64
+
+/* An OP_FILE_INSTALL handed to the workers. */
+typedef struct install_job_t
+{
+  /* The work item and its id. */
+  apr_uint64_t id;
+  svn_skel_t *work_item;
+
+  /* What to do and the result of doing it, once JOB has finished. */
+  file_install_t *install;
+  const svn_io_dirent2_t *dirent;
+
+  /* Root pool owned by this job.  It is only ever used by one thread at
+     a time. */
+  apr_pool_t *pool;
+
+  /* The job performing the install. */
+  svn_worker_pool__job_t *job;
+
+  /* Next job in queue order. */
+  struct install_job_t *next;
+} install_job_t;
+
+/* The worker threads and the jobs in flight.  Only used by the thread
+   running the queue. */
+typedef struct file_installer_t
+{
+  /* Perform the installs. */
+  svn_worker_pool__t *workers;
+
+  /* All jobs in flight, in queue order. */
+  install_job_t *first;
+  install_job_t *last;
+
+  /* The const char * local_relpaths being installed, and the pool they
+     are allocated in. */
+  apr_hash_t *paths;
+  apr_pool_t *batch_pool;
+} file_installer_t;
+
+/* Implements svn_worker_pool__func_t.  BATON is an install_job_t. */
+static svn_error_t *
+install_job(void *baton,
+            apr_pool_t *scratch_pool)
+{
+  install_job_t *job = baton;
+
+  return svn_error_trace(perform_file_install(&job->dirent, job->install,
+                                              NULL, NULL, job->pool,
+                                              scratch_pool));
+}
+
+/* Pool cleanup function releasing the jobs of the file_installer_t in
+   DATA.  Jobs still in flight will have been completed but not
+   recorded. */
+static apr_status_t
+release_installs(void *data)
+{
+  file_installer_t *installer = data;
+  install_job_t *job;
+
+  /* Runs after the workers are gone. */
+  for (job = installer->first; job; job = job->next)
+    svn_pool_destroy(job->pool);
+
+  return APR_SUCCESS;
+}
+
+/* Start an installer with up to THREADS worker threads and return it in
+ * *INSTALLER.  It will be stopped when POOL gets cleaned up.  Set
+ * *INSTALLER to NULL if no worker thread could be started.
+ */
+static svn_error_t *
+create_installer(file_installer_t **installer,
+                 int threads,
+                 apr_pool_t *pool)
+{
+  file_installer_t *result = apr_pcalloc(pool, sizeof(*result));
+
+  result->batch_pool = svn_pool_create(pool);
+  result->paths = apr_hash_make(result->batch_pool);
+
+  apr_pool_cleanup_register(pool, result, release_installs,
+                            apr_pool_cleanup_null);
+  SVN_ERR(svn_worker_pool__create(&result->workers,
+                                  MIN(threads, INSTALL_MAX_THREADS), pool));
+
+  /* Not being able to start threads is not fatal; we simply install
+     all files sequentially. */
+  *installer = result->workers ? result : NULL;
+
+  return SVN_NO_ERROR;
+}
+
+/* Return TRUE if WORK_ITEM may be handed to INSTALLER's workers now, i.e.
+   if it is an OP_FILE_INSTALL of a file not being installed already. */
+static svn_boolean_t
+can_install_concurrently(file_installer_t *installer,
+                         const svn_skel_t *work_item)
+{
+  const svn_skel_t *arg1;
+
+  if (!svn_skel__matches_atom(work_item->children, OP_FILE_INSTALL))
+    return FALSE;
+
+  arg1 = work_item->children->next;
+  return apr_hash_get(installer->paths, arg1->data, arg1->len) == NULL;
+}
+
+/* Read what is needed for the OP_FILE_INSTALL work item WORK_ITEM with ID
+ * from DB and hand it to the workers of INSTALLER.  Use SCRATCH_POOL for
+ * temporary allocations.
+ */
+static svn_error_t *
+queue_install(file_installer_t *installer,
+              svn_wc__db_t *db,
+              const char *wri_abspath,
+              apr_uint64_t id,
+              const svn_skel_t *work_item,
+              apr_pool_t *scratch_pool)
+{
+  const svn_skel_t *arg1 = work_item->children->next;
+  apr_pool_t *pool = apr_allocator_owner_get(svn_pool_create_allocator(FALSE));
+  install_job_t *job = apr_pcalloc(pool, sizeof(*job));
+  svn_error_t *err;
+
+  job->id = id;
+  job->pool = pool;
+  job->work_item = svn_skel__dup(work_item, TRUE, pool);
+
+  err = prepare_file_install(&job->install, db, work_item, wri_abspath,
+                             pool, scratch_pool);
+  if (err)
+    {
+      svn_pool_destroy(pool);
+      return svn_error_trace(err);
+    }
+
+  apr_hash_set(installer->paths,
+               apr_pstrmemdup(installer->batch_pool, arg1->data, arg1->len),
+               arg1->len, job);
+
+  if (installer->last)
+    installer->last->next = job;
+  else
+    installer->first = job;
+  installer->last = job;
+
+  return svn_error_trace(svn_worker_pool__post(&job->job, installer->workers,
+                                               install_job, job, pool));
+}
+
+#endif
+
+/* Return the error to report for WORK_ITEM with ID in the queue of
+   WRI_ABSPATH having failed with ERR. */
+static svn_error_t *
+work_item_error(svn_error_t *err,
+                const char *wri_abspath,
+                apr_uint64_t id,
+                const svn_skel_t *work_item,
+                apr_pool_t *scratch_pool)
+{
+  const char *skel = svn_skel__unparse(work_item, scratch_pool)->data;
+
+  return svn_error_createf(SVN_ERR_WC_BAD_ADM_LOG, err,
+                           _("Failed to run the WC DB work queue "
+                             "associated with '%s', work item %d %s"),
+                           svn_dirent_local_style(wri_abspath,
+                                                  scratch_pool),
+                           (int)id, skel);
+}
+
+#if APR_HAS_THREADS
+
+/* Wait for all jobs of INSTALLER to finish, arrange for recording their
+ * file info in WQB and release them.  Return the error of the first job
+ * that failed, if any, in the form of work_item_error().
+ */
+static svn_error_t *
+finish_installs(file_installer_t *installer,
+                work_item_baton_t *wqb,
+                const char *wri_abspath,
+                apr_pool_t *scratch_pool)
+{
+  svn_error_t *err = SVN_NO_ERROR;
+
+  while (installer->first)
+    {
+      install_job_t *job = installer->first;
+      svn_error_t *job_err = svn_worker_pool__wait(job->job);
+
+      installer->first = job->next;
+
+      if (job_err && !err)
+        err = work_item_error(job_err, wri_abspath, job->id,
+                              job->work_item, scratch_pool);
+      else
+        svn_error_clear(job_err);
+
+      if (job->dirent && !err)
+        record_dirent(wqb, job->install->local_abspath,
+                      svn_io_dirent2_dup(job->dirent, wqb->result_pool));
+
+      svn_pool_destroy(job->pool);
+    }
+
+  installer->last = NULL;
+  svn_pool_clear(installer->batch_pool);
+  installer->paths = apr_hash_make(installer->batch_pool);
+
+  return err;
+}
+
+#endif
+
+/* Maximum number of work items fetched and marked as completed in a
+   single DB transaction. */
+#define WQ_BATCH_SIZE 256
+
+/* The body of svn_wc__wq_run().
+ *
+ * Rather than running and removing the work items one by one, each in
+ * its own DB transaction, fetch them in batches.  Items that completed
+ * get removed, and their file info recorded, in the same transaction as
+ * fetching the next batch.
+ */
+static svn_error_t *
+run_work_queue(svn_wc__db_t *db,
                const char *wri_abspath,
                svn_cancel_func_t cancel_func,
                void *cancel_baton,
                apr_pool_t *scratch_pool)
 {
+  apr_pool_t *batchpool = svn_pool_create(scratch_pool);
   apr_pool_t *iterpool = svn_pool_create(scratch_pool);
   apr_uint64_t last_id = 0;
   work_item_baton_t wib = { 0 };
+#if APR_HAS_THREADS
+  file_installer_t *installer = NULL;
+  int install_threads = svn_wc__db_get_install_threads(db);
+#endif
   wib.result_pool = svn_pool_create(scratch_pool);
 
 #ifdef SVN_DEBUG_WORK_QUEUE
@@ -1502,70 +2055,136 @@ svn_wc__wq_run(svn_wc__db_t *db,
 
   while (TRUE)
     {
-      apr_uint64_t id;
-      svn_skel_t *work_item;
-      svn_error_t *err;
-
-      svn_pool_clear(iterpool);
-
-      if (! wib.used)
-        {
-          /* Make sure to do this *early* in the loop iteration. There may
-             be a LAST_ID that needs to be marked as completed, *before* we
-             start worrying about anything else.  */
-          SVN_ERR(svn_wc__db_wq_fetch_next(&id, &work_item, db, wri_abspath,
-                                           last_id, iterpool, iterpool));
-        }
-      else
-        {
-          /* Make sure to do this *early* in the loop iteration. There may
-             be a LAST_ID that needs to be marked as completed, *before* we
-             start worrying about anything else.  */
-          SVN_ERR(svn_wc__db_wq_record_and_fetch_next(&id, &work_item,
-                                                      db, wri_abspath,
-                                                      last_id, wib.record_map,
-                                                      iterpool,
-                                                      wib.result_pool));
-
-          svn_pool_clear(wib.result_pool);
-          wib.record_map = NULL;
-          wib.used = FALSE;
-        }
-
-      /* Stop work queue processing, if requested. A future 'svn cleanup'
-         should be able to continue the processing. Note that we may
-         have WORK_ITEM, but we'll just skip its processing for now.  */
-      if (cancel_func)
-        SVN_ERR(cancel_func(cancel_baton));
-
-      /* If we have a WORK_ITEM, then process the sucker. Otherwise,
-         we're done.  */
-      if (work_item == NULL)
+      apr_array_header_t *items;
+      int i;
+
+      svn_pool_clear(batchpool);
+
+      /* Make sure to do this *early* in the loop iteration. There may
+         be items up to LAST_ID that need to be marked as completed,
+         *before* we start worrying about anything else.  */
+      SVN_ERR(svn_wc__db_wq_complete_and_fetch_batch(&items, db, wri_abspath,
+                                                     last_id, wib.record_map,
+                                                     WQ_BATCH_SIZE,
+                                                     batchpool,
+                                                     wib.result_pool));
+      svn_pool_clear(wib.result_pool);
+      wib.record_map = NULL;
+      wib.used = FALSE;
+      last_id = 0;
+
+      /* If we have no more work items, we're done.  */
+      if (items->nelts == 0)
         break;
 
-      err = dispatch_work_item(&wib, db, wri_abspath, work_item,
-                               cancel_func, cancel_baton, iterpool);
-      if (err)
+      for (i = 0; i < items->nelts; i++)
         {
-          const char *skel = svn_skel__unparse(work_item, scratch_pool)->data;
-
-          return svn_error_createf(SVN_ERR_WC_BAD_ADM_LOG, err,
-                                   _("Failed to run the WC DB work queue "
-                                     "associated with '%s', work item %d %s"),
-                                   svn_dirent_local_style(wri_abspath,
-                                                          scratch_pool),
-                                   (int)id, skel);
+          const svn_wc__db_wq_item_t *item
+            = APR_ARRAY_IDX(items, i, const svn_wc__db_wq_item_t *);
+          const struct work_item_dispatch *dispatch;
+          svn_error_t *err;
+
+          svn_pool_clear(iterpool);
+
+          /* Stop work queue processing, if requested. A future 'svn
+             cleanup' should be able to continue the processing.  The
+             items of this batch will simply be run again then.  */
+          if (cancel_func)
+            SVN_ERR(cancel_func(cancel_baton));
+
+          dispatch = find_dispatch(item->work_item);
+
+#if APR_HAS_THREADS
+          /* Start the workers once there is something for them to do. */
+          if (!installer && install_threads > 1
+              && svn_skel__matches_atom(item->work_item->children,
+                                        OP_FILE_INSTALL))
+            {
+              SVN_ERR(create_installer(&installer, install_threads,
+                                       scratch_pool));
+              if (!installer)
+                install_threads = 1;
+            }
+
+          /* Any other work item may depend on the installs in flight. */
+          if (installer && installer->first
+              && !can_install_concurrently(installer, item->work_item))
+            SVN_ERR(finish_installs(installer, &wib, wri_abspath, iterpool));
+
+          if (installer && can_install_concurrently(installer,
+                                                    item->work_item))
+            {
+              err = queue_install(installer, db, wri_abspath, item->id,
+                                  item->work_item, iterpool);
+              if (err)
+                return svn_error_trace(work_item_error(err, wri_abspath,
+                                                       item->id,
+                                                       item->work_item,
+                                                       scratch_pool));
+
+              last_id = item->id;
+              continue;
+            }
+#endif
+
+          /* Items writing to the DB on their own must not see, nor be
+             overwritten by, file info that is yet to be recorded. */
+          if (dispatch && dispatch->writes_db && wib.used)
+            {
+              apr_array_header_t *no_items;
+
+              SVN_ERR(svn_wc__db_wq_complete_and_fetch_batch(&no_items, db,
+                                                             wri_abspath,
+                                                             last_id,
+                                                             wib.record_map,
+                                                             0, iterpool,
+                                                             iterpool));
+              svn_pool_clear(wib.result_pool);
+              wib.record_map = NULL;
+              wib.used = FALSE;
+              last_id = 0;
+            }
+
+          err = dispatch_work_item(&wib, db, wri_abspath, item->work_item,
+                                   cancel_func, cancel_baton, iterpool);
+          if (err)
+            return svn_error_trace(work_item_error(err, wri_abspath,
+                                                   item->id, item->work_item,
+                                                   scratch_pool));
+
+          /* The work item finished without error. Mark it completed
+             with the next batch.  */
+          last_id = item->id;
         }
 
-      /* The work item finished without error. Mark it completed
-         in the next loop.  */
-      last_id = id;
+#if APR_HAS_THREADS
+      if (installer && installer->first)
+        SVN_ERR(finish_installs(installer, &wib, wri_abspath, iterpool));
+#endif
     }
 
   svn_pool_destroy(iterpool);
+  svn_pool_destroy(batchpool);
   return SVN_NO_ERROR;
 }
 
+svn_error_t *
+svn_wc__wq_run(svn_wc__db_t *db,
+               const char *wri_abspath,
+               svn_cancel_func_t cancel_func,
+               void *cancel_baton,
+               apr_pool_t *scratch_pool)
+{
+  apr_pool_t *run_pool = svn_pool_create(scratch_pool);
+  svn_error_t *err = run_work_queue(db, wri_abspath,
+                                    cancel_func, cancel_baton, run_pool);
+
+  /* Make sure no installs continue in the background once we return. */
+  svn_pool_destroy(run_pool);
+
+  return svn_error_trace(err);
+}
+
 
 svn_skel_t *
 svn_wc__wq_merge(svn_skel_t *work_item1,
@@ -1626,8 +2245,21 @@ get_and_record_fileinfo(work_item_baton_t *wqb,
   SVN_ERR(svn_io_stat_dirent2(&dirent, local_abspath, FALSE, ignore_enoent,
                               wqb->result_pool, scratch_pool));
 
+  record_dirent(wqb, local_abspath, dirent);
+
+  return SVN_NO_ERROR;
+}
+
+/* Arrange for the size and timestamp of DIRENT, which must be allocated
+   in WQB's result pool, to be recorded for LOCAL_ABSPATH unless it is not
+   a file. */
+static void
+record_dirent(work_item_baton_t *wqb,
+              const char *local_abspath,
+              const svn_io_dirent2_t *dirent)
+{
   if (dirent->kind != svn_node_file)
-    return SVN_NO_ERROR;
+    return;
 
   wqb->used = TRUE;
 
@@ -1636,6 +2268,4 @@ get_and_record_fileinfo(work_item_baton_t *wqb,
 
   svn_hash_sets(wqb->record_map, apr_pstrdup(wqb->result_pool, local_abspath),
                 dirent);
-
-  return SVN_NO_ERROR;
 }
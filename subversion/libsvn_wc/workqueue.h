@@ -116,6 +116,24 @@ svn_wc__wq_build_file_install(svn_skel_t **work_item,
                               apr_pool_t *result_pool,
                               apr_pool_t *scratch_pool);
 
+/* Like svn_wc__wq_build_file_install() with SOURCE_ABSPATH set to
+   COPY_ABSPATH, but for a COPY_ABSPATH that is a temporary file with
+   exactly the pristine contents of LOCAL_ABSPATH.  When no translation
+   is needed, the work item moves COPY_ABSPATH into place instead of
+   copying it, and it always records the file info.
+
+   The caller should queue an OP_FILE_REMOVE of COPY_ABSPATH after
+   *WORK_ITEM, as for any other source file.
+*/
+svn_error_t *
+svn_wc__wq_build_file_install_from_copy(svn_skel_t **work_item,
+                                        svn_wc__db_t *db,
+                                        const char *local_abspath,
+                                        const char *copy_abspath,
+                                        svn_boolean_t use_commit_times,
+                                        apr_pool_t *result_pool,
+                                        apr_pool_t *scratch_pool);
+
 
 /* Set *WORK_ITEM to a new work item that will remove a single
    file LOCAL_ABSPATH from the working copy identified by the pair DB,
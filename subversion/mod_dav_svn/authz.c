@@ -168,7 +168,7 @@ authz_read(svn_boolean_t *allowed,
 
   if (svn_fs_is_txn_root(root))
     {
-      /* This means svn_repos_dir_delta2 is comparing two txn trees,
+      /* This means svn_repos_dir_delta3 is comparing two txn trees,
          rather than a txn and revision.  It's probably updating a
          working copy that contains 'disjoint urls'.
 
@@ -243,3 +243,44 @@ dav_svn__allow_read_resource(const dav_resource *resource,
   return dav_svn__allow_read(resource->info->r, resource->info->repos,
                              resource->info->repos_path, rev, pool);
 }
+
+
+svn_boolean_t
+dav_svn__allow_lock(request_rec *r,
+                    const dav_svn_repos *repos,
+                    const char *path,
+                    apr_pool_t *pool)
+{
+  const char *uri;
+  request_rec *subreq;
+  svn_boolean_t allowed = FALSE;
+
+  /* Easy out:  if the admin has explicitly set 'SVNPathAuthz Off',
+     then this whole callback does nothing. */
+  if (! dav_svn__get_pathauthz_flag(r))
+    {
+      return TRUE;
+    }
+
+  if (path && path[0] != '/')
+    path = apr_pstrcat(pool, "/", path, SVN_VA_NULL);
+
+  /* Build a Public Resource uri representing PATH in HEAD. */
+  uri = dav_svn__build_uri(repos, DAV_SVN__BUILD_URI_PUBLIC,
+                           SVN_INVALID_REVNUM, path, FALSE /* add_href */,
+                           pool);
+
+  /* Check if LOCK would work against this uri.  Authz modules treat
+     LOCK and UNLOCK alike, so this covers both operations. */
+  subreq = ap_sub_req_method_uri("LOCK", uri, r, r->output_filters);
+
+  if (subreq)
+    {
+      if (subreq->status == HTTP_OK)
+        allowed = TRUE;
+
+      ap_destroy_sub_req(subreq);
+    }
+
+  return allowed;
+}
@@ -0,0 +1,370 @@
+/*
+ * bundle.c: cache the responses to checkout update-reports
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+/* A checkout of a popular (path, revision, depth) produces the very same
+ * update-report response for every client that asks for it.  Instead of
+ * driving the report for each of them, we record the response body the
+ * first time into a file named after a hash of all the request parameters
+ * that shape it -- a "bundle" -- and stream that file to later clients.
+ *
+ * Bundles are written to a temporary name and renamed into place once
+ * the response has been sent completely, so concurrent server processes
+ * never see partial bundles.  The modification time of a bundle gets
+ * bumped whenever it is served; when the directory exceeds its size limit,
+ * the least recently used bundles get removed first.
+ */
+
+#include <apr_buckets.h>
+#include <apr_file_io.h>
+#include <apr_strings.h>
+
+#include <httpd.h>
+#include <http_log.h>
+#include <util_filter.h>
+
+#include "svn_checksum.h"
+#include "svn_dirent_uri.h"
+#include "svn_hash.h"
+#include "svn_io.h"
+#include "svn_pools.h"
+#include "svn_sorts.h"
+
+#include "private/svn_sorts_private.h"
+
+#include "dav_svn.h"
+
+
+/* File name extension of complete bundles. */
+#define BUNDLE_EXT ".bundle"
+
+struct dav_svn__bundle_t
+{
+  /* The request whose response we record. */
+  request_rec *r;
+
+  /* Our instance of the "SVN-BUNDLE" filter. */
+  ap_filter_t *filter;
+
+  /* The cache directory, its size limit and the final name of the
+     bundle within it. */
+  const char *dir;
+  apr_uint64_t max_size;
+  const char *path;
+
+  /* The temporary file we write to, and its name. */
+  apr_file_t *file;
+  const char *tmp_path;
+
+  /* Bytes written so far. */
+  apr_uint64_t size;
+
+  /* Set when writing failed or the bundle became too large.  The bundle
+     will then be discarded. */
+  svn_boolean_t failed;
+
+  /* Lifetime of this structure. */
+  apr_pool_t *pool;
+};
+
+/* Return the path of the bundle identified by KEY in DIR, allocated in
+   RESULT_POOL. */
+static const char *
+bundle_path(const char *dir,
+            const char *key,
+            apr_pool_t *result_pool)
+{
+  svn_checksum_t *checksum;
+
+  /* SHA-1 cannot fail. */
+  svn_error_clear(svn_checksum(&checksum, svn_checksum_sha1,
+                               key, strlen(key), result_pool));
+
+  return svn_dirent_join(dir,
+                         apr_pstrcat(result_pool,
+                                     svn_checksum_to_cstring(checksum,
+                                                             result_pool),
+                                     BUNDLE_EXT, SVN_VA_NULL),
+                         result_pool);
+}
+
+/* Log and clear ERR, a failed bundle operation of request R.  A cache
+   that does not work must not fail the request. */
+static void
+log_bundle_error(request_rec *r,
+                 svn_error_t *err)
+{
+  dav_svn__log_err(r, dav_svn__convert_err(err, HTTP_INTERNAL_SERVER_ERROR,
+                                           "Checkout bundle cache error",
+                                           r->pool),
+                   APLOG_WARNING);
+}
+
+svn_error_t *
+dav_svn__bundle_send(svn_boolean_t *sent,
+                     request_rec *r,
+                     const char *key,
+                     dav_svn__output *output,
+                     apr_pool_t *pool)
+{
+  const char *dir = dav_svn__get_bundle_cache_dir(r);
+  const char *path;
+  apr_file_t *file;
+  apr_finfo_t finfo;
+  apr_bucket_brigade *bb;
+  svn_error_t *err;
+
+  *sent = FALSE;
+  if (!dir)
+    return SVN_NO_ERROR;
+
+  /* A bundle that has just been evicted by someone else is merely a
+     cache miss. */
+  path = bundle_path(dir, key, pool);
+  err = svn_io_file_open(&file, path, APR_READ | APR_BINARY, APR_OS_DEFAULT,
+                         pool);
+  if (!err)
+    {
+      err = svn_io_file_info_get(&finfo, APR_FINFO_SIZE, file, pool);
+      if (err)
+        svn_error_clear(svn_io_file_close(file, pool));
+    }
+
+  if (err)
+    {
+      svn_error_clear(err);
+      return SVN_NO_ERROR;
+    }
+
+  /* Mark it as recently used.  Failing to do so is not fatal. */
+  err = svn_io_set_file_affected_time(apr_time_now(), path, pool);
+  if (err)
+    log_bundle_error(r, err);
+
+  /* Once we started to send data, failures are real errors. */
+  bb = apr_brigade_create(pool, dav_svn__output_get_bucket_alloc(output));
+  apr_brigade_insert_file(bb, file, 0, finfo.size, pool);
+  SVN_ERR(dav_svn__output_pass_brigade(output, bb));
+
+  *sent = TRUE;
+  return SVN_NO_ERROR;
+}
+
+/* Discard BUNDLE's temporary file, if any. */
+static void
+discard_bundle(dav_svn__bundle_t *bundle)
+{
+  if (bundle->file)
+    {
+      svn_error_clear(svn_io_file_close(bundle->file, bundle->pool));
+      svn_error_clear(svn_io_remove_file2(bundle->tmp_path, TRUE,
+                                          bundle->pool));
+      bundle->file = NULL;
+    }
+}
+
+/* Pool cleanup function making sure that an aborted request does not
+   leave temporary files behind.  BATON is the dav_svn__bundle_t. */
+static apr_status_t
+cleanup_bundle(void *baton)
+{
+  discard_bundle(baton);
+  return APR_SUCCESS;
+}
+
+dav_svn__bundle_t *
+dav_svn__bundle_record(request_rec *r,
+                       const char *key,
+                       apr_pool_t *pool)
+{
+  const char *dir = dav_svn__get_bundle_cache_dir(r);
+  dav_svn__bundle_t *result;
+  svn_error_t *err;
+
+  if (!dir)
+    return NULL;
+
+  result = apr_pcalloc(pool, sizeof(*result));
+  result->r = r;
+  result->dir = dir;
+  result->max_size = dav_svn__get_bundle_cache_size(r);
+  result->path = bundle_path(dir, key, pool);
+  result->pool = pool;
+
+  /* If we can't create the bundle, just don't create it. */
+  err = svn_io_open_unique_file3(&result->file, &result->tmp_path, dir,
+                                 svn_io_file_del_none, pool, pool);
+  if (err)
+    {
+      log_bundle_error(r, err);
+      return NULL;
+    }
+
+  apr_pool_cleanup_register(pool, result, cleanup_bundle,
+                            apr_pool_cleanup_null);
+  result->filter = ap_add_output_filter("SVN-BUNDLE", result, r,
+                                        r->connection);
+
+  return result;
+}
+
+apr_status_t
+dav_svn__bundle_filter(ap_filter_t *f,
+                       apr_bucket_brigade *bb)
+{
+  dav_svn__bundle_t *bundle = f->ctx;
+  apr_bucket *bucket;
+
+  if (bundle->failed)
+    return ap_pass_brigade(f->next, bb);
+
+  for (bucket = APR_BRIGADE_FIRST(bb);
+       bucket != APR_BRIGADE_SENTINEL(bb);
+       bucket = APR_BUCKET_NEXT(bucket))
+    {
+      const char *data;
+      apr_size_t len;
+      apr_status_t status;
+
+      if (APR_BUCKET_IS_METADATA(bucket))
+        continue;
+
+      status = apr_bucket_read(bucket, &data, &len, APR_BLOCK_READ);
+      if (status)
+        return status;
+
+      bundle->size += len;
+      if (bundle->size > bundle->max_size
+          || apr_file_write_full(bundle->file, data, len, NULL))
+        {
+          bundle->failed = TRUE;
+          break;
+        }
+    }
+
+  return ap_pass_brigade(f->next, bb);
+}
+
+/* Sort svn_sort__item_t of svn_io_dirent2_t by modification time. */
+static int
+compare_mtime(const void *lhs,
+              const void *rhs)
+{
+  const svn_io_dirent2_t *a = ((const svn_sort__item_t *)lhs)->value;
+  const svn_io_dirent2_t *b = ((const svn_sort__item_t *)rhs)->value;
+
+  return a->mtime < b->mtime ? -1 : (a->mtime > b->mtime ? 1 : 0);
+}
+
+/* Remove the least recently used bundles from DIR until the remaining
+   ones take no more than MAX_SIZE bytes.  Use SCRATCH_POOL for temporary
+   allocations. */
+static svn_error_t *
+evict_bundles(const char *dir,
+              apr_uint64_t max_size,
+              apr_pool_t *scratch_pool)
+{
+  apr_hash_t *dirents;
+  apr_array_header_t *sorted;
+  apr_array_header_t *bundles;
+  apr_uint64_t total = 0;
+  apr_pool_t *iterpool;
+  int i;
+
+  SVN_ERR(svn_io_get_dirents3(&dirents, dir, FALSE, scratch_pool,
+                              scratch_pool));
+
+  /* Collect the complete bundles, ignoring temporaries. */
+  sorted = svn_sort__hash(dirents, svn_sort_compare_items_lexically,
+                          scratch_pool);
+  bundles = apr_array_make(scratch_pool, sorted->nelts,
+                           sizeof(svn_sort__item_t));
+  for (i = 0; i < sorted->nelts; ++i)
+    {
+      svn_sort__item_t *item = &APR_ARRAY_IDX(sorted, i, svn_sort__item_t);
+      const svn_io_dirent2_t *dirent = item->value;
+      const char *name = item->key;
+      apr_size_t len = strlen(name);
+
+      if (dirent->kind != svn_node_file
+          || len <= sizeof(BUNDLE_EXT) - 1
+          || strcmp(name + len - (sizeof(BUNDLE_EXT) - 1), BUNDLE_EXT))
+        continue;
+
+      APR_ARRAY_PUSH(bundles, svn_sort__item_t) = *item;
+      total += dirent->filesize;
+    }
+
+  if (total <= max_size)
+    return SVN_NO_ERROR;
+
+  svn_sort__array(bundles, compare_mtime);
+
+  /* Other processes may be evicting concurrently; ignore what they
+     removed already. */
+  iterpool = svn_pool_create(scratch_pool);
+  for (i = 0; i < bundles->nelts && total > max_size; ++i)
+    {
+      svn_sort__item_t *item = &APR_ARRAY_IDX(bundles, i, svn_sort__item_t);
+      const svn_io_dirent2_t *dirent = item->value;
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_io_remove_file2(svn_dirent_join(dir, item->key, iterpool),
+                                  TRUE, iterpool));
+      total -= dirent->filesize;
+    }
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+void
+dav_svn__bundle_finish(dav_svn__bundle_t *bundle,
+                       svn_boolean_t keep)
+{
+  svn_error_t *err;
+
+  if (!bundle)
+    return;
+
+  ap_remove_output_filter(bundle->filter);
+  if (!keep || bundle->failed || bundle->r->connection->aborted)
+    {
+      discard_bundle(bundle);
+      return;
+    }
+
+  err = svn_io_file_close(bundle->file, bundle->pool);
+  bundle->file = NULL;
+  if (!err)
+    err = svn_io_file_rename2(bundle->tmp_path, bundle->path, FALSE,
+                              bundle->pool);
+  if (!err)
+    err = evict_bundles(bundle->dir, bundle->max_size, bundle->pool);
+
+  if (err)
+    {
+      svn_error_clear(svn_io_remove_file2(bundle->tmp_path, TRUE,
+                                          bundle->pool));
+      log_bundle_error(bundle->r, err);
+    }
+}
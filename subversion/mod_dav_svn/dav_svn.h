@@ -52,6 +52,10 @@ extern "C" {
 /* a pool-key for the shared dav_svn_root used by autoversioning  */
 #define DAV_SVN__AUTOVERSIONING_ACTIVITY "svn-autoversioning-activity"
 
+/* Request pool user data key for the dav_svn__io_trace_t of a request
+   whose FS I/O is being traced. */
+#define DAV_SVN__IO_TRACE_KEY "mod_dav_svn:io-trace"
+
 /* Option values for SVNAllowBulkUpdates.  Note that
    it's important that CONF_BULKUPD_DEFAULT is 0 to make
    merge_dir_config in mod_dav_svn do the right thing. */
@@ -182,7 +186,9 @@ enum dav_svn_private_restype {
   DAV_SVN_RESTYPE_REV_COLLECTION,       /* .../!svn/rev/ */
   DAV_SVN_RESTYPE_REVROOT_COLLECTION,   /* .../!svn/rvr/ */
   DAV_SVN_RESTYPE_TXN_COLLECTION,       /* .../!svn/txn/ */
-  DAV_SVN_RESTYPE_TXNROOT_COLLECTION    /* .../!svn/txr/ */
+  DAV_SVN_RESTYPE_TXNROOT_COLLECTION,   /* .../!svn/txr/ */
+  DAV_SVN_RESTYPE_TEXT_COLLECTION,      /* .../!svn/txt/ */
+  DAV_SVN_RESTYPE_DELTA_COLLECTION      /* .../!svn/dlt/ */
 };
 
 
@@ -303,6 +309,12 @@ struct dav_resource_private {
   /* whether this resource parameters are fixed and won't change
      between requests. */
   svn_boolean_t idempotent;
+
+  /* For the content-addressed !svn/txt and !svn/dlt resources: the hex
+     SHA-1 digest of the file contents and, for deltas, the hex MD5
+     digest of the delta base, as given in the URI.  NULL otherwise. */
+  const char *text_sha1;
+  const char *text_base_md5;
 };
 
 
@@ -344,6 +356,36 @@ dav_svn__get_nodeprop_cache_flag(request_rec *r);
  * request? */
 svn_boolean_t dav_svn__get_block_read_flag(request_rec *r);
 
+/* has FS I/O tracing been enabled for the repository referred to by this
+ * request? */
+svn_boolean_t dav_svn__get_trace_io_flag(request_rec *r);
+
+/* Return the directory to write FS I/O event traces to, or NULL.  Comes
+   from the <SVNTraceIODirectory> directive. */
+const char *dav_svn__get_trace_io_dir(request_rec *r);
+
+/* has commit timing been enabled for the repository referred to by this
+ * request? */
+svn_boolean_t dav_svn__get_commit_timing_flag(request_rec *r);
+
+/* may clients request log reports in the binary encoding (see
+ * SVN_DAV_NS_DAV_SVN_BINARY_LOG) from the repository referred to by this
+ * request? */
+svn_boolean_t dav_svn__get_binary_reports_flag(request_rec *r);
+
+/* may clients GET file contents and deltas of the repository referred to
+ * by this request through content-addressed URIs (see
+ * SVN_DAV_TEXT_STUB_HEADER)? */
+svn_boolean_t dav_svn__get_content_urls_flag(request_rec *r);
+
+/* Return the directory to cache checkout bundles in, or NULL if bundles
+   are disabled.  Comes from the <SVNCheckoutBundleCache> directive. */
+const char *dav_svn__get_bundle_cache_dir(request_rec *r);
+
+/* Return the maximum number of bytes that the checkout bundles in the
+   directory returned by dav_svn__get_bundle_cache_dir() may take. */
+apr_uint64_t dav_svn__get_bundle_cache_size(request_rec *r);
+
 /* for the repository referred to by this request, are subrequests bypassed?
  * A function pointer if yes, NULL if not.
  */
@@ -413,6 +455,16 @@ const char *dav_svn__get_master_uri(request_rec *r);
    Comes from the <SVNMasterVersion> directive. */
 svn_version_t *dav_svn__get_master_version(request_rec *r);
 
+/* Return the program to run for synchronizing the slave after a commit,
+   iff a master URI is in place for this location; otherwise, return NULL.
+   Comes from the <SVNMasterSyncCommand> directive. */
+const char *dav_svn__get_master_sync_command(request_rec *r);
+
+/* Return how long a slave may wait for revisions that still need to be
+   synchronized from the master.  0 if it should not wait at all.  Comes
+   from the <SVNMasterSyncWait> directive. */
+apr_interval_time_t dav_svn__get_master_sync_wait(request_rec *r);
+
 /* Return the disk path to the activities db.
    Comes from the <SVNActivitiesDB> directive. */
 const char *dav_svn__get_activities_db(request_rec *r);
@@ -425,6 +477,20 @@ const char *dav_svn__get_root_dir(request_rec *r);
 /* Return the data compression level to be used over the wire. */
 int dav_svn__get_compression_level(request_rec *r);
 
+/* The maximum value accepted by the SVNUpdateEncoderThreads directive. */
+#define DAV_SVN__MAX_UPDATE_ENCODER_THREADS 64
+
+/* Return the number of worker threads that shall encode the text deltas
+   of update reports in "send-all" mode, 0 if they are to be encoded by
+   the request thread itself.  Comes from the <SVNUpdateEncoderThreads>
+   directive. */
+int dav_svn__get_update_encoder_threads(request_rec *r);
+
+/* Return the maximum number of changed paths to report per revision in
+   log responses, 0 for no limit.  Comes from the <SVNMaxChangedPaths>
+   directive. */
+unsigned dav_svn__get_max_changed_paths(request_rec *r);
+
 /* Return the hook script environment parsed from the configuration. */
 const char *dav_svn__get_hooks_env(request_rec *r);
 
@@ -453,6 +519,12 @@ const char *dav_svn__get_vtxn_stub(request_rec *r);
 /* For accessing transaction properties (typically "!svn/vtxr") */
 const char *dav_svn__get_vtxn_root_stub(request_rec *r);
 
+/* For accessing file contents by SHA-1 (typically "!svn/txt") */
+const char *dav_svn__get_text_stub(request_rec *r);
+
+/* For accessing deltas by base MD5 and SHA-1 (typically "!svn/dlt") */
+const char *dav_svn__get_delta_stub(request_rec *r);
+
 
 /*** Output helpers ***/
 
@@ -530,6 +602,31 @@ int dav_svn__method_post(request_rec *r);
 /* Request handler to GET Subversion internal status (FSFS cache). */
 int dav_svn__status(request_rec *r);
 
+/* Request handler to GET the server statistics in the Prometheus text
+   format. */
+int dav_svn__metrics(request_rec *r);
+
+/* Request handler to GET the pool profile of this process. */
+int dav_svn__pool_profile(request_rec *r);
+
+/* Implements the log_transaction hook: records the duration of requests
+   to Subversion repositories in the server statistics. */
+int dav_svn__log_metrics(request_rec *r);
+
+/* The FS I/O tracing state of a request, see DAV_SVN__IO_TRACE_KEY. */
+typedef struct dav_svn__io_trace_t
+{
+  /* The filesystem being traced. */
+  svn_fs_t *fs;
+
+  /* File receiving the item accesses or NULL. */
+  const char *path;
+} dav_svn__io_trace_t;
+
+/* Implements the log_transaction hook: sets the SVN-IO environment
+   variable to the FS I/O totals of the request, if traced. */
+int dav_svn__log_io_trace(request_rec *r);
+
 /*** repos.c ***/
 
 /* generate an ETag for RESOURCE and return it, allocated in POOL. */
@@ -594,6 +691,19 @@ dav_svn__attach_auto_revprops(svn_fs_txn_t *txn,
                               apr_pool_t *pool);
 
 
+/* Like svn_repos_fs_commit_txn() for the repository of request R.  If
+   enabled by the SVNLogCommitTiming directive, also put the duration of
+   each commit phase into the "SVN-COMMIT-TIMING" environment variable
+   of R, for mod_log_config. */
+svn_error_t *
+dav_svn__commit_txn(const char **conflict_p,
+                    svn_repos_t *repos,
+                    svn_revnum_t *new_rev,
+                    svn_fs_txn_t *txn,
+                    request_rec *r,
+                    apr_pool_t *pool);
+
+
 /* Hook function of types 'checkout' and 'checkin', as defined in
    mod_dav.h's versioning provider hooks table (see dav_hooks_vsn).  */
 dav_error *
@@ -702,6 +812,8 @@ static const dav_report_elem dav_svn__reports_list[] = {
   { SVN_XML_NAMESPACE, SVN_DAV__MERGEINFO_REPORT },
   { SVN_XML_NAMESPACE, SVN_DAV__INHERITED_PROPS_REPORT },
   { SVN_XML_NAMESPACE, "list-report" },
+  { SVN_XML_NAMESPACE, "stat-many-report" },
+  { SVN_XML_NAMESPACE, "rev-proplist-range-report" },
   { NULL, NULL },
 };
 
@@ -759,6 +871,16 @@ dav_svn__list_report(const dav_resource *resource,
                      const apr_xml_doc *doc,
                      dav_svn__output *output);
 
+dav_error *
+dav_svn__stat_many_report(const dav_resource *resource,
+                          const apr_xml_doc *doc,
+                          dav_svn__output *output);
+
+dav_error *
+dav_svn__rev_proplist_range_report(const dav_resource *resource,
+                                   const apr_xml_doc *doc,
+                                   dav_svn__output *output);
+
 /*** posts/ ***/
 
 /* The various POST handlers, defined in posts/, and used by repos.c.  */
@@ -770,6 +892,14 @@ dav_error *
 dav_svn__post_create_txn_with_props(const dav_resource *resource,
                                     svn_skel_t *request_skel,
                                     dav_svn__output *output);
+dav_error *
+dav_svn__post_lock_many(const dav_resource *resource,
+                        svn_skel_t *request_skel,
+                        dav_svn__output *output);
+dav_error *
+dav_svn__post_unlock_many(const dav_resource *resource,
+                          svn_skel_t *request_skel,
+                          dav_svn__output *output);
 
 /*** authz.c ***/
 
@@ -811,6 +941,18 @@ dav_svn__allow_read_resource(const dav_resource *resource,
                              svn_revnum_t rev,
                              apr_pool_t *pool);
 
+/* Return TRUE iff the current user (as determined by Apache's
+   authentication system) may lock or unlock PATH in REPOS.  This runs
+   a LOCK subrequest against the public URI of PATH and will therefore
+   invoke any authz modules loaded into Apache.  Use POOL for any
+   temporary allocation.
+*/
+svn_boolean_t
+dav_svn__allow_lock(request_rec *r,
+                    const dav_svn_repos *repos,
+                    const char *path,
+                    apr_pool_t *pool);
+
 
 /* Return TRUE iff the current user (as determined by Apache's
    authentication system) has permission to read repository REPOS_NAME.
@@ -993,6 +1135,12 @@ svn_error_t *dav_svn__brigade_printf(apr_bucket_brigade *bb,
                                      ...)
   __attribute__((format(printf, 3, 4)));
 
+/* Like dav_svn__brigade_printf() but takes a va_list instead of '...'. */
+svn_error_t *dav_svn__brigade_vprintf(apr_bucket_brigade *bb,
+                                      dav_svn__output *output,
+                                      const char *fmt,
+                                      va_list ap);
+
 /* Write an unspecified number of strings to OUTPUT using BB.  */
 svn_error_t *dav_svn__brigade_putstrs(apr_bucket_brigade *bb,
                                       dav_svn__output *output,
@@ -1129,6 +1277,46 @@ dav_svn__fuzzy_escape_author(const char *author,
                              apr_pool_t *result_pool,
                              apr_pool_t *scratch_pool);
 
+/*** bundle.c ***/
+
+/* A checkout bundle being recorded: the complete response body of an
+   update-report, stored for being sent again to later clients that send
+   the same request. */
+typedef struct dav_svn__bundle_t dav_svn__bundle_t;
+
+/* If the bundle cache of request R contains a bundle for KEY, send it to
+   OUTPUT and set *SENT.  Otherwise, set *SENT to FALSE and don't write
+   anything.  KEY must describe all the inputs that shape the response.
+   Use POOL for allocations. */
+svn_error_t *
+dav_svn__bundle_send(svn_boolean_t *sent,
+                     request_rec *r,
+                     const char *key,
+                     dav_svn__output *output,
+                     apr_pool_t *pool);
+
+/* Start recording the response body of request R as the bundle for KEY.
+   Return NULL if R has no bundle cache or the bundle cannot be created.
+   Allocate the result in POOL, which must live until the recording gets
+   finished with dav_svn__bundle_finish(). */
+dav_svn__bundle_t *
+dav_svn__bundle_record(request_rec *r,
+                       const char *key,
+                       apr_pool_t *pool);
+
+/* Stop recording BUNDLE.  If KEEP is set and the whole response has been
+   recorded, add it to the cache and evict the least recently used bundles
+   as needed.  Otherwise, discard it.  BUNDLE may be NULL. */
+void
+dav_svn__bundle_finish(dav_svn__bundle_t *bundle,
+                       svn_boolean_t keep);
+
+/* The Apache output filter F which records BB into the dav_svn__bundle_t
+   in F's context. */
+apr_status_t dav_svn__bundle_filter(ap_filter_t *f,
+                                    apr_bucket_brigade *bb);
+
+
 /*** mirror.c ***/
 
 /* Perform the fixup hook for the R request.  */
@@ -1153,6 +1341,29 @@ apr_status_t dav_svn__location_header_filter(ap_filter_t *f,
 apr_status_t dav_svn__location_body_filter(ap_filter_t *f,
                                            apr_bucket_brigade *bb);
 
+/* An Apache output filter F which picks the new revision from the
+ * response to a MERGE proxied to the master.  It makes the following
+ * requests on the same connection wait for that revision and starts the
+ * SVNMasterSyncCommand.  BB passes through unmodified. */
+apr_status_t dav_svn__merge_sync_filter(ap_filter_t *f,
+                                        apr_bucket_brigade *bb);
+
+/* If REPOS, opened for request R, is a slave and R's connection committed
+ * a revision that REPOS doesn't have yet, wait for it for no longer than
+ * SVNMasterSyncWait.  Use SCRATCH_POOL for temporary allocations. */
+svn_error_t *dav_svn__mirror_catch_up(dav_svn_repos *repos,
+                                      request_rec *r,
+                                      apr_pool_t *scratch_pool);
+
+/* Set *YOUNGEST to the youngest revision of REPOS, opened for request R.
+ * On a slave, wait for no longer than SVNMasterSyncWait for REVISION to
+ * appear before doing so.  Use SCRATCH_POOL for temporary allocations. */
+svn_error_t *dav_svn__mirror_wait_for_rev(svn_revnum_t *youngest,
+                                          dav_svn_repos *repos,
+                                          request_rec *r,
+                                          svn_revnum_t revision,
+                                          apr_pool_t *scratch_pool);
+
 
 #ifdef __cplusplus
 }
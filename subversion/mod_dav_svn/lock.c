@@ -747,8 +747,9 @@ append_locks(dav_lockdb *lockdb,
                                     "Could not create empty file.",
                                     resource->pool);
 
-      serr = svn_repos_fs_commit_txn(&conflict_msg, repos->repos,
-                                     &new_rev, txn, resource->pool);
+      serr = dav_svn__commit_txn(&conflict_msg, repos->repos,
+                                 &new_rev, txn, resource->info->r,
+                                 resource->pool);
       if (SVN_IS_VALID_REVNUM(new_rev))
         {
           /* ### Log an error in post commit FS processing? */
@@ -24,9 +24,16 @@
 #include <assert.h>
 
 #include <apr_strmatch.h>
+#include <apr_thread_proc.h>
 
 #include <httpd.h>
 #include <http_core.h>
+#include <http_log.h>
+
+#include "svn_dirent_uri.h"
+#include "svn_path.h"
+#include "svn_sorts.h"
+#include "svn_string.h"
 
 #include "private/svn_fspath.h"
 
@@ -120,6 +127,13 @@ int dav_svn__proxy_request_fixup(request_rec *r)
            MERGE, LOCK, UNLOCK, etc.) or any as-yet-unhandled request
            using a "special URI", we have to doctor it a bit for proxying. */
         seg = ap_strstr(r->uri, root_dir);
+        if (seg && r->method_number == M_MERGE
+            && (dav_svn__get_master_sync_command(r)
+                || dav_svn__get_master_sync_wait(r))) {
+            /* We need to read the new revision from the response. */
+            apr_table_unset(r->headers_in, "Accept-Encoding");
+            ap_add_output_filter("MergeSync", NULL, r, r->connection);
+        }
         if (seg && (r->method_number == M_MERGE ||
                     r->method_number == M_LOCK ||
                     r->method_number == M_UNLOCK ||
@@ -340,3 +354,243 @@ apr_status_t dav_svn__location_body_filter(ap_filter_t *f,
     }
     return ap_pass_brigade(f->next, bb);
 }
+
+/* Prefix of the connection pool userdata key under which we remember the
+   revision that the connection must see in the repository whose path
+   follows the prefix. */
+#define MUST_SEE_KEY "mod_dav_svn-must-see:"
+
+/* Don't look for the new revision beyond this many bytes of a MERGE
+   response.  It is part of the very first response element. */
+#define MERGE_SYNC_SCAN_LIMIT 0x10000
+
+/* Bounds of the delay between two checks for a new revision on a slave. */
+#define MIN_SYNC_POLL_DELAY apr_time_from_msec(10)
+#define MAX_SYNC_POLL_DELAY apr_time_from_msec(250)
+
+typedef struct merge_sync_ctx_t
+{
+    /* The first bytes of the MERGE response body. */
+    svn_stringbuf_t *head;
+
+    /* The new revision, once found in HEAD. */
+    svn_revnum_t revision;
+} merge_sync_ctx_t;
+
+/* Return the revision number in the first <D:version-name> element of
+   the partial MERGE response BODY, or SVN_INVALID_REVNUM if BODY doesn't
+   contain all of it yet. */
+static svn_revnum_t find_new_revision(const char *body)
+{
+    const char *start = strstr(body, "version-name>");
+    const char *end;
+    svn_revnum_t revision;
+    svn_error_t *err;
+
+    if (!start)
+        return SVN_INVALID_REVNUM;
+
+    start += sizeof("version-name>") - 1;
+    err = svn_revnum_parse(&revision, start, &end);
+    if (err) {
+        svn_error_clear(err);
+        return SVN_INVALID_REVNUM;
+    }
+
+    return *end == '<' ? revision : SVN_INVALID_REVNUM;
+}
+
+/* Return the path of the slave repository that request R, which has been
+   fixed up for proxying, refers to.  Return NULL if that's not clear. */
+static const char *slave_fs_path(request_rec *r)
+{
+    const char *fs_parent_path = dav_svn__get_fs_parent_path(r);
+    const char *root_dir = dav_svn__get_root_dir(r);
+    const char *seg, *end;
+
+    if (!fs_parent_path)
+        return dav_svn__get_fs_path(r);
+
+    /* With SVNParentPath, the repository name follows ROOT_DIR. */
+    seg = ap_strstr_c(r->uri, root_dir);
+    if (!seg)
+        return NULL;
+
+    seg += strlen(root_dir);
+    while (*seg == '/')
+        ++seg;
+
+    end = strchr(seg, '/');
+    if (!end)
+        end = seg + strlen(seg);
+    if (end == seg)
+        return NULL;
+
+    return svn_dirent_join(fs_parent_path,
+                           svn_path_uri_decode(apr_pstrmemdup(r->pool, seg,
+                                                              end - seg),
+                                               r->pool),
+                           r->pool);
+}
+
+/* Start the SVNMasterSyncCommand of request R for REVISION of the slave
+   repository at FS_PATH, without waiting for it to finish. */
+static void start_sync_command(request_rec *r,
+                               const char *command,
+                               const char *fs_path,
+                               svn_revnum_t revision)
+{
+    apr_procattr_t *attr;
+    apr_proc_t *proc = apr_pcalloc(r->pool, sizeof(*proc));
+    const char *args[4];
+    apr_status_t status;
+
+    args[0] = svn_dirent_local_style(command, r->pool);
+    args[1] = svn_dirent_local_style(fs_path, r->pool);
+    args[2] = apr_psprintf(r->pool, "%ld", revision);
+    args[3] = NULL;
+
+    /* The detached child daemonizes, so the process we started exits
+       right away and can be reaped at the end of the request. */
+    status = apr_procattr_create(&attr, r->pool);
+    if (!status)
+        status = apr_procattr_io_set(attr, APR_NO_PIPE, APR_NO_PIPE,
+                                     APR_NO_PIPE);
+    if (!status)
+        status = apr_procattr_cmdtype_set(attr, APR_PROGRAM);
+    if (!status)
+        status = apr_procattr_detach_set(attr, 1);
+    if (!status)
+        status = apr_proc_create(proc, args[0], args, NULL, attr, r->pool);
+
+    if (status) {
+        ap_log_rerror(APLOG_MARK, APLOG_WARNING, status, r,
+                      "Could not start SVNMasterSyncCommand '%s'", args[0]);
+        return;
+    }
+
+    apr_pool_note_subprocess(r->pool, proc, APR_JUST_WAIT);
+}
+
+/* The proxied commit of R created REVISION on the master.  Make the
+   slave catch up. */
+static void merge_committed(request_rec *r,
+                            svn_revnum_t revision)
+{
+    const char *fs_path = slave_fs_path(r);
+    const char *command = dav_svn__get_master_sync_command(r);
+
+    if (!fs_path)
+        return;
+
+    if (command)
+        start_sync_command(r, command, fs_path, revision);
+
+    if (dav_svn__get_master_sync_wait(r)) {
+        apr_pool_t *pool = r->connection->pool;
+        const char *key = apr_pstrcat(r->pool, MUST_SEE_KEY, fs_path,
+                                      SVN_VA_NULL);
+        void *data;
+        svn_revnum_t *must_see;
+
+        apr_pool_userdata_get(&data, key, pool);
+        must_see = data;
+        if (!must_see) {
+            must_see = apr_palloc(pool, sizeof(*must_see));
+            *must_see = SVN_INVALID_REVNUM;
+            apr_pool_userdata_set(must_see, key, NULL, pool);
+        }
+
+        if (!SVN_IS_VALID_REVNUM(*must_see) || *must_see < revision)
+            *must_see = revision;
+    }
+}
+
+apr_status_t dav_svn__merge_sync_filter(ap_filter_t *f,
+                                        apr_bucket_brigade *bb)
+{
+    request_rec *r = f->r;
+    merge_sync_ctx_t *ctx = f->ctx;
+    apr_bucket *bkt;
+
+    if (!ctx) {
+        ctx = f->ctx = apr_pcalloc(r->pool, sizeof(*ctx));
+        ctx->head = svn_stringbuf_create_empty(r->pool);
+        ctx->revision = SVN_INVALID_REVNUM;
+    }
+
+    for (bkt = APR_BRIGADE_FIRST(bb);
+         bkt != APR_BRIGADE_SENTINEL(bb);
+         bkt = APR_BUCKET_NEXT(bkt)) {
+
+        const char *data;
+        apr_size_t len;
+
+        if (APR_BUCKET_IS_EOS(bkt)) {
+            if (SVN_IS_VALID_REVNUM(ctx->revision) && r->status == HTTP_OK)
+                merge_committed(r, ctx->revision);
+            ap_remove_output_filter(f);
+            break;
+        }
+
+        if (APR_BUCKET_IS_METADATA(bkt)
+            || SVN_IS_VALID_REVNUM(ctx->revision)
+            || ctx->head->len > MERGE_SYNC_SCAN_LIMIT)
+            continue;
+
+        if (apr_bucket_read(bkt, &data, &len, APR_BLOCK_READ))
+            continue;
+
+        svn_stringbuf_appendbytes(ctx->head, data, len);
+        ctx->revision = find_new_revision(ctx->head->data);
+    }
+
+    return ap_pass_brigade(f->next, bb);
+}
+
+svn_error_t *dav_svn__mirror_wait_for_rev(svn_revnum_t *youngest,
+                                          dav_svn_repos *repos,
+                                          request_rec *r,
+                                          svn_revnum_t revision,
+                                          apr_pool_t *scratch_pool)
+{
+    apr_time_t deadline = apr_time_now() + dav_svn__get_master_sync_wait(r);
+    apr_interval_time_t delay = MIN_SYNC_POLL_DELAY;
+
+    SVN_ERR(svn_fs_youngest_rev(youngest, repos->fs, scratch_pool));
+    while (*youngest < revision && apr_time_now() < deadline) {
+        apr_sleep(delay);
+        delay = MIN(2 * delay, MAX_SYNC_POLL_DELAY);
+        SVN_ERR(svn_fs_youngest_rev(youngest, repos->fs, scratch_pool));
+    }
+
+    repos->youngest_rev = *youngest;
+    return SVN_NO_ERROR;
+}
+
+svn_error_t *dav_svn__mirror_catch_up(dav_svn_repos *repos,
+                                      request_rec *r,
+                                      apr_pool_t *scratch_pool)
+{
+    void *data;
+    svn_revnum_t *must_see;
+    svn_revnum_t youngest;
+
+    if (!dav_svn__get_master_uri(r))
+        return SVN_NO_ERROR;
+
+    apr_pool_userdata_get(&data,
+                          apr_pstrcat(scratch_pool, MUST_SEE_KEY,
+                                      repos->fs_path, SVN_VA_NULL),
+                          r->connection->pool);
+    must_see = data;
+    if (!must_see || !SVN_IS_VALID_REVNUM(*must_see))
+        return SVN_NO_ERROR;
+
+    SVN_ERR(dav_svn__mirror_wait_for_rev(&youngest, repos, r, *must_see,
+                                         scratch_pool));
+
+    /* Don't make further requests wait again, even if we gave up. */
+    *must_see = SVN_INVALID_REVNUM;
+    return SVN_NO_ERROR;
+}
@@ -42,7 +42,11 @@
 #include "svn_dso.h"
 #include "mod_dav_svn.h"
 
+#include "private/svn_atomic.h"
+#include "private/svn_cache.h"
+#include "private/svn_fs_private.h"
 #include "private/svn_fspath.h"
+#include "private/svn_repos_private.h"
 #include "private/svn_subr_private.h"
 
 #include "dav_svn.h"
@@ -101,13 +105,24 @@ typedef struct dir_conf_t {
   const char *root_dir;              /* our top-level directory */
   const char *master_uri;            /* URI to the master SVN repos */
   svn_version_t *master_version;     /* version of master server */
+  const char *master_sync_command;   /* program syncing the slave */
+  int master_sync_wait;              /* seconds to wait for the slave */
   const char *activities_db;         /* path to activities database(s) */
   enum conf_flag txdelta_cache;      /* whether to enable txdelta caching */
   enum conf_flag fulltext_cache;     /* whether to enable fulltext caching */
   enum conf_flag revprop_cache;      /* whether to enable revprop caching */
   enum conf_flag nodeprop_cache;     /* whether to enable nodeprop caching */
   enum conf_flag block_read;         /* whether to enable block read mode */
+  int update_encoder_threads;        /* svndiff encoders per update report */
+  unsigned max_changed_paths;        /* changed paths per log-item; 0=all */
   const char *hooks_env;             /* path to hook script env config file */
+  enum conf_flag trace_io;           /* whether to trace FS I/O per request */
+  const char *trace_io_dir;          /* where to write FS I/O event traces */
+  enum conf_flag commit_timing;      /* whether to time the commit phases */
+  enum conf_flag binary_reports;     /* whether to offer skel log reports */
+  enum conf_flag content_urls;       /* whether to offer !svn/txt URIs */
+  const char *bundle_cache_dir;      /* where to cache checkout bundles */
+  apr_uint64_t bundle_cache_size;    /* size limit of that directory */
 } dir_conf_t;
 
 
@@ -120,6 +135,19 @@ extern module AP_MODULE_DECLARE_DATA dav_svn_module;
 /* The authz_svn provider for bypassing path authz. */
 static authz_svn__subreq_bypass_func_t pathauthz_bypass_func = NULL;
 
+/* File to restore the cache contents from at startup and save them to
+ * periodically, see SVNCacheSnapshotFile.  NULL if not configured. */
+static const char *cache_snapshot_file = NULL;
+
+/* Minimum time between two updates of CACHE_SNAPSHOT_FILE. */
+static apr_interval_time_t cache_snapshot_interval = 300 * APR_USEC_PER_SEC;
+
+/* Non-zero while some thread of this process writes CACHE_SNAPSHOT_FILE. */
+static volatile svn_atomic_t cache_snapshot_writing = 0;
+
+/* When this process last wrote or read CACHE_SNAPSHOT_FILE. */
+static apr_time_t cache_snapshot_last_written = 0;
+
 static int
 init(apr_pool_t *p, apr_pool_t *plog, apr_pool_t *ptemp, server_rec *s)
 {
@@ -128,6 +156,20 @@ init(apr_pool_t *p, apr_pool_t *plog, apr_pool_t *ptemp, server_rec *s)
 
   ap_add_version_component(p, "SVN/" SVN_VER_NUMBER);
 
+  /* Pools created from here on, including those of the MPM's children,
+   * will be included in the pool profile. */
+  if (getenv(SVN_POOL__PROFILE_ENV) && !svn_pool__profile_enabled())
+    {
+      serr = svn_pool__profile_enable();
+      if (serr)
+        {
+          ap_log_perror(APLOG_MARK, APLOG_WARNING, serr->apr_err, p,
+                        "mod_dav_svn: can't enable pool profiling: '%s'",
+                        serr->message ? serr->message : "(no more info)");
+          svn_error_clear(serr);
+        }
+    }
+
   serr = svn_fs_initialize(p);
   if (serr)
     {
@@ -150,9 +192,63 @@ init(apr_pool_t *p, apr_pool_t *plog, apr_pool_t *ptemp, server_rec *s)
   conf = ap_get_module_config(s->module_config, &dav_svn_module);
   svn_utf_initialize2(conf->use_utf8, p);
 
+  /* A shared cache must be allocated before the MPM forks its children.
+   * This returns NULL if the cache has been disabled, so there is nothing
+   * to check. */
+  if (svn_cache__get_global_membuffer_shared())
+    svn_cache__get_global_membuffer_cache();
+
+  /* Forked children inherit the restored cache contents.  Failing to
+   * restore them only means starting with a cold cache. */
+  if (cache_snapshot_file)
+    {
+      serr = svn_fs__load_cache_snapshot(cache_snapshot_file, ptemp);
+      if (serr)
+        {
+          ap_log_perror(APLOG_MARK, APLOG_WARNING, serr->apr_err, p,
+                        "mod_dav_svn: can't load cache snapshot '%s': '%s'",
+                        cache_snapshot_file,
+                        serr->message ? serr->message : "(no more info)");
+          svn_error_clear(serr);
+        }
+
+      cache_snapshot_last_written = apr_time_now();
+    }
+
   return OK;
 }
 
+/* Implements the #log_transaction hook.  Save the cache contents to
+ * CACHE_SNAPSHOT_FILE at most once per CACHE_SNAPSHOT_INTERVAL. */
+static int
+save_cache_snapshot(request_rec *r)
+{
+  svn_error_t *serr;
+  apr_time_t now = apr_time_now();
+
+  if (   !cache_snapshot_file
+      || now - cache_snapshot_last_written < cache_snapshot_interval)
+    return DECLINED;
+
+  if (svn_atomic_cas(&cache_snapshot_writing, 1, 0) != 0)
+    return DECLINED;
+
+  cache_snapshot_last_written = now;
+  serr = svn_fs__save_cache_snapshot(cache_snapshot_file, r->pool);
+  if (serr)
+    {
+      ap_log_rerror(APLOG_MARK, APLOG_WARNING, serr->apr_err, r,
+                    "mod_dav_svn: can't save cache snapshot '%s': '%s'",
+                    cache_snapshot_file,
+                    serr->message ? serr->message : "(no more info)");
+      svn_error_clear(serr);
+    }
+
+  svn_atomic_set(&cache_snapshot_writing, 0);
+
+  return DECLINED;
+}
+
 static svn_error_t *
 malfunction_handler(svn_boolean_t can_return,
                     const char *file, int line,
@@ -269,6 +365,9 @@ merge_dir_config(apr_pool_t *p, void *base, void *overrides)
   newconf->fs_path = INHERIT_VALUE(parent, child, fs_path);
   newconf->master_uri = INHERIT_VALUE(parent, child, master_uri);
   newconf->master_version = INHERIT_VALUE(parent, child, master_version);
+  newconf->master_sync_command = INHERIT_VALUE(parent, child,
+                                               master_sync_command);
+  newconf->master_sync_wait = INHERIT_VALUE(parent, child, master_sync_wait);
   newconf->activities_db = INHERIT_VALUE(parent, child, activities_db);
   newconf->repo_name = INHERIT_VALUE(parent, child, repo_name);
   newconf->xslt_uri = INHERIT_VALUE(parent, child, xslt_uri);
@@ -283,8 +382,20 @@ merge_dir_config(apr_pool_t *p, void *base, void *overrides)
   newconf->revprop_cache = INHERIT_VALUE(parent, child, revprop_cache);
   newconf->nodeprop_cache = INHERIT_VALUE(parent, child, nodeprop_cache);
   newconf->block_read = INHERIT_VALUE(parent, child, block_read);
+  newconf->update_encoder_threads
+    = INHERIT_VALUE(parent, child, update_encoder_threads);
+  newconf->max_changed_paths
+    = INHERIT_VALUE(parent, child, max_changed_paths);
   newconf->root_dir = INHERIT_VALUE(parent, child, root_dir);
   newconf->hooks_env = INHERIT_VALUE(parent, child, hooks_env);
+  newconf->trace_io = INHERIT_VALUE(parent, child, trace_io);
+  newconf->trace_io_dir = INHERIT_VALUE(parent, child, trace_io_dir);
+  newconf->commit_timing = INHERIT_VALUE(parent, child, commit_timing);
+  newconf->binary_reports = INHERIT_VALUE(parent, child, binary_reports);
+  newconf->content_urls = INHERIT_VALUE(parent, child, content_urls);
+  newconf->bundle_cache_dir = INHERIT_VALUE(parent, child, bundle_cache_dir);
+  newconf->bundle_cache_size = INHERIT_VALUE(parent, child,
+                                             bundle_cache_size);
 
   if (parent->fs_path)
     ap_log_error(APLOG_MARK, APLOG_WARNING, 0, NULL,
@@ -357,6 +468,38 @@ SVNMasterVersion_cmd(cmd_parms *cmd, void *config, const char *arg1)
 }
 
 
+static const char *
+SVNMasterSyncCommand_cmd(cmd_parms *cmd, void *config, const char *arg1)
+{
+  dir_conf_t *conf = config;
+
+  conf->master_sync_command = svn_dirent_internal_style(arg1, cmd->pool);
+
+  return NULL;
+}
+
+
+static const char *
+SVNMasterSyncWait_cmd(cmd_parms *cmd, void *config, const char *arg1)
+{
+  dir_conf_t *conf = config;
+  int value = 0;
+  svn_error_t *err = svn_cstring_atoi(&value, arg1);
+  if (err)
+    {
+      svn_error_clear(err);
+      return "Invalid decimal number for the slave synchronization wait.";
+    }
+
+  if (value < 0)
+    return "The slave synchronization wait must not be negative.";
+
+  conf->master_sync_wait = value;
+
+  return NULL;
+}
+
+
 static const char *
 SVNActivitiesDB_cmd(cmd_parms *cmd, void *config, const char *arg1)
 {
@@ -604,6 +747,99 @@ SVNBlockRead_cmd(cmd_parms *cmd, void *config, int arg)
   return NULL;
 }
 
+static const char *
+SVNTraceIO_cmd(cmd_parms *cmd, void *config, int arg)
+{
+  dir_conf_t *conf = config;
+
+  if (arg)
+    conf->trace_io = CONF_FLAG_ON;
+  else
+    conf->trace_io = CONF_FLAG_OFF;
+
+  return NULL;
+}
+
+static const char *
+SVNTraceIODirectory_cmd(cmd_parms *cmd, void *config, const char *arg1)
+{
+  dir_conf_t *conf = config;
+
+  conf->trace_io_dir = svn_dirent_internal_style(arg1, cmd->pool);
+
+  return NULL;
+}
+
+static const char *
+SVNLogCommitTiming_cmd(cmd_parms *cmd, void *config, int arg)
+{
+  dir_conf_t *conf = config;
+
+  if (arg)
+    conf->commit_timing = CONF_FLAG_ON;
+  else
+    conf->commit_timing = CONF_FLAG_OFF;
+
+  return NULL;
+}
+
+static const char *
+SVNBinaryReports_cmd(cmd_parms *cmd, void *config, int arg)
+{
+  dir_conf_t *conf = config;
+
+  if (arg)
+    conf->binary_reports = CONF_FLAG_ON;
+  else
+    conf->binary_reports = CONF_FLAG_OFF;
+
+  return NULL;
+}
+
+static const char *
+SVNContentAddressedURLs_cmd(cmd_parms *cmd, void *config, int arg)
+{
+  dir_conf_t *conf = config;
+
+  if (arg)
+    conf->content_urls = CONF_FLAG_ON;
+  else
+    conf->content_urls = CONF_FLAG_OFF;
+
+  return NULL;
+}
+
+static const char *
+SVNCheckoutBundleCache_cmd(cmd_parms *cmd, void *config, const char *arg1)
+{
+  dir_conf_t *conf = config;
+
+  conf->bundle_cache_dir = svn_dirent_internal_style(arg1, cmd->pool);
+
+  return NULL;
+}
+
+static const char *
+SVNCheckoutBundleCacheSize_cmd(cmd_parms *cmd, void *config,
+                               const char *arg1)
+{
+  dir_conf_t *conf = config;
+  apr_uint64_t value = 0;
+  svn_error_t *err = svn_cstring_atoui64(&value, arg1);
+  if (err)
+    {
+      svn_error_clear(err);
+      return "Invalid decimal number for the checkout bundle cache size.";
+    }
+
+  if (value == 0)
+    return "The checkout bundle cache size must be at least 1 MB.";
+
+  conf->bundle_cache_size = value * 0x100000;
+
+  return NULL;
+}
+
 static const char *
 SVNInMemoryCacheSize_cmd(cmd_parms *cmd, void *config, const char *arg1)
 {
@@ -624,6 +860,110 @@ SVNInMemoryCacheSize_cmd(cmd_parms *cmd, void *config, const char *arg1)
   return NULL;
 }
 
+static const char *
+SVNInMemoryCacheShared_cmd(cmd_parms *cmd, void *config, int arg)
+{
+  svn_cache__set_global_membuffer_shared(arg);
+
+  return NULL;
+}
+
+static const char *
+SVNCacheOverflowFile_cmd(cmd_parms *cmd, void *config, const char *arg1,
+                         const char *arg2)
+{
+  apr_uint64_t value = 0;
+  svn_error_t *err = svn_cstring_atoui64(&value, arg2);
+  if (err)
+    {
+      svn_error_clear(err);
+      return "Invalid decimal number for the SVN cache overflow file size.";
+    }
+
+  svn_cache__set_global_membuffer_overflow(
+      svn_dirent_internal_style(arg1, cmd->pool), value * 0x400);
+
+  return NULL;
+}
+
+static const char *
+SVNCacheSnapshotFile_cmd(cmd_parms *cmd, void *config, const char *arg1,
+                         const char *arg2)
+{
+  if (arg2)
+    {
+      apr_uint64_t value = 0;
+      svn_error_t *err = svn_cstring_atoui64(&value, arg2);
+      if (err)
+        {
+          svn_error_clear(err);
+          return "Invalid decimal number for the SVN cache snapshot "
+                 "interval.";
+        }
+
+      cache_snapshot_interval = apr_time_from_sec(value);
+    }
+
+  cache_snapshot_file = svn_dirent_internal_style(
+                          ap_server_root_relative(cmd->pool, arg1),
+                          cmd->pool);
+
+  return NULL;
+}
+
+static const char *
+SVNAuthzCacheDir_cmd(cmd_parms *cmd, void *config, const char *arg1)
+{
+  /* Applies to mod_authz_svn as well since both use the same
+     libsvn_repos instance. */
+  svn_repos__authz_set_cache_dir(svn_dirent_internal_style(arg1,
+                                                           cmd->pool));
+
+  return NULL;
+}
+
+static const char *
+SVNUpdateEncoderThreads_cmd(cmd_parms *cmd, void *config, const char *arg1)
+{
+  dir_conf_t *conf = config;
+  int value = 0;
+  svn_error_t *err = svn_cstring_atoi(&value, arg1);
+  if (err)
+    {
+      svn_error_clear(err);
+      return "Invalid decimal number for the number of update encoder "
+             "threads.";
+    }
+
+  if (value < 0 || value > DAV_SVN__MAX_UPDATE_ENCODER_THREADS)
+    return apr_psprintf(cmd->pool,
+                        "%d is not a valid number of update encoder threads. "
+                        "The valid range is 0 .. %d.",
+                        value, DAV_SVN__MAX_UPDATE_ENCODER_THREADS);
+
+  conf->update_encoder_threads = value;
+
+  return NULL;
+}
+
+static const char *
+SVNMaxChangedPaths_cmd(cmd_parms *cmd, void *config, const char *arg1)
+{
+  dir_conf_t *conf = config;
+  unsigned value = 0;
+  svn_error_t *err = svn_cstring_atoui(&value, arg1);
+  if (err)
+    {
+      svn_error_clear(err);
+      return "Invalid decimal number for the maximum number of changed "
+             "paths.";
+    }
+
+  conf->max_changed_paths = value;
+
+  return NULL;
+}
+
 static const char *
 SVNCompressionLevel_cmd(cmd_parms *cmd, void *config, const char *arg1)
 {
@@ -800,6 +1140,28 @@ dav_svn__get_master_version(request_rec *r)
 }
 
 
+const char *
+dav_svn__get_master_sync_command(request_rec *r)
+{
+  dir_conf_t *conf;
+
+  conf = ap_get_module_config(r->per_dir_config, &dav_svn_module);
+  return conf->master_uri ? conf->master_sync_command : NULL;
+}
+
+
+apr_interval_time_t
+dav_svn__get_master_sync_wait(request_rec *r)
+{
+  dir_conf_t *conf;
+
+  conf = ap_get_module_config(r->per_dir_config, &dav_svn_module);
+
+  /* Slaves don't wait by default. */
+  return conf->master_uri ? apr_time_from_sec(conf->master_sync_wait) : 0;
+}
+
+
 const char *
 dav_svn__get_xslt_uri(request_rec *r)
 {
@@ -876,6 +1238,22 @@ dav_svn__get_vtxn_root_stub(request_rec *r)
 }
 
 
+const char *
+dav_svn__get_text_stub(request_rec *r)
+{
+  return apr_pstrcat(r->pool, dav_svn__get_special_uri(r), "/txt",
+                     SVN_VA_NULL);
+}
+
+
+const char *
+dav_svn__get_delta_stub(request_rec *r)
+{
+  return apr_pstrcat(r->pool, dav_svn__get_special_uri(r), "/dlt",
+                     SVN_VA_NULL);
+}
+
+
 svn_boolean_t
 dav_svn__get_autoversioning_flag(request_rec *r)
 {
@@ -1027,6 +1405,100 @@ dav_svn__get_block_read_flag(request_rec *r)
   return get_conf_flag(conf->block_read, FALSE);
 }
 
+svn_boolean_t
+dav_svn__get_trace_io_flag(request_rec *r)
+{
+  dir_conf_t *conf;
+
+  conf = ap_get_module_config(r->per_dir_config, &dav_svn_module);
+
+  /* I/O tracing is disabled by default. */
+  return get_conf_flag(conf->trace_io, FALSE);
+}
+
+const char *
+dav_svn__get_trace_io_dir(request_rec *r)
+{
+  dir_conf_t *conf;
+
+  conf = ap_get_module_config(r->per_dir_config, &dav_svn_module);
+  return conf->trace_io_dir;
+}
+
+svn_boolean_t
+dav_svn__get_commit_timing_flag(request_rec *r)
+{
+  dir_conf_t *conf;
+
+  conf = ap_get_module_config(r->per_dir_config, &dav_svn_module);
+
+  /* Commit timing is disabled by default. */
+  return get_conf_flag(conf->commit_timing, FALSE);
+}
+
+svn_boolean_t
+dav_svn__get_binary_reports_flag(request_rec *r)
+{
+  dir_conf_t *conf;
+
+  conf = ap_get_module_config(r->per_dir_config, &dav_svn_module);
+
+  /* Binary reports are disabled by default. */
+  return get_conf_flag(conf->binary_reports, FALSE);
+}
+
+svn_boolean_t
+dav_svn__get_content_urls_flag(request_rec *r)
+{
+  dir_conf_t *conf;
+
+  conf = ap_get_module_config(r->per_dir_config, &dav_svn_module);
+
+  /* Content-addressed URIs are disabled by default. */
+  return get_conf_flag(conf->content_urls, FALSE);
+}
+
+const char *
+dav_svn__get_bundle_cache_dir(request_rec *r)
+{
+  dir_conf_t *conf;
+
+  conf = ap_get_module_config(r->per_dir_config, &dav_svn_module);
+  return conf->bundle_cache_dir;
+}
+
+apr_uint64_t
+dav_svn__get_bundle_cache_size(request_rec *r)
+{
+  dir_conf_t *conf;
+
+  conf = ap_get_module_config(r->per_dir_config, &dav_svn_module);
+
+  /* 1 GB by default. */
+  return conf->bundle_cache_size ? conf->bundle_cache_size
+                                 : APR_UINT64_C(0x40000000);
+}
+
+int
+dav_svn__get_update_encoder_threads(request_rec *r)
+{
+  dir_conf_t *conf;
+
+  conf = ap_get_module_config(r->per_dir_config, &dav_svn_module);
+
+  /* parallel encoding is disabled by default. */
+  return conf->update_encoder_threads;
+}
+
+unsigned
+dav_svn__get_max_changed_paths(request_rec *r)
+{
+  dir_conf_t *conf;
+
+  conf = ap_get_module_config(r->per_dir_config, &dav_svn_module);
+  return conf->max_changed_paths;
+}
+
 int
 dav_svn__get_compression_level(request_rec *r)
 {
@@ -1327,6 +1799,21 @@ static const command_rec cmds[] =
                 "specifies the Subversion release version of a master "
                 "Subversion server "),
 
+  /* per directory/location */
+  AP_INIT_TAKE1("SVNMasterSyncCommand", SVNMasterSyncCommand_cmd, NULL,
+                ACCESS_CONF,
+                "specifies a program that a slave starts in the background "
+                "with the repository path and the new revision as "
+                "arguments whenever a commit has been proxied to the "
+                "master, e.g. a wrapper around 'svnsync sync'"),
+
+  /* per directory/location */
+  AP_INIT_TAKE1("SVNMasterSyncWait", SVNMasterSyncWait_cmd, NULL,
+                ACCESS_CONF,
+                "specifies how many seconds a slave waits for revisions "
+                "that a client has committed or reported but that have "
+                "not been synchronized yet (default is 0)."),
+
   /* per directory/location */
   AP_INIT_TAKE1("SVNActivitiesDB", SVNActivitiesDB_cmd, NULL, ACCESS_CONF,
                 "specifies the location in the filesystem in which the "
@@ -1363,10 +1850,9 @@ static const command_rec cmds[] =
   /* per directory/location */
   AP_INIT_FLAG("SVNCacheRevProps", SVNCacheRevProps_cmd, NULL,
                ACCESS_CONF|RSRC_CONF,
-               "speeds up 'svn ls -v', export and checkout operations"
-               "but should only be enabled under the conditions described"
-               "in the documentation"
-               "(default is Off)."),
+               "speeds up 'svn log', 'svn ls -v', export and checkout "
+               "operations by sharing cached revision properties between "
+               "requests (default is On)."),
 
   /* per directory/location */
   AP_INIT_FLAG("SVNCacheNodeProps", SVNCacheNodeProps_cmd, NULL,
@@ -1382,6 +1868,72 @@ static const command_rec cmds[] =
                "caches (see SVNInMemoryCacheSize) have been configured."
                "(default is Off)."),
 
+  /* per directory/location */
+  AP_INIT_FLAG("SVNTraceIO", SVNTraceIO_cmd, NULL,
+               ACCESS_CONF|RSRC_CONF,
+               "traces the repository I/O of each request and makes the "
+               "totals available to mod_log_config as %{SVN-IO}e "
+               "(default is Off)."),
+
+  /* per directory/location */
+  AP_INIT_TAKE1("SVNTraceIODirectory", SVNTraceIODirectory_cmd, NULL,
+                ACCESS_CONF|RSRC_CONF,
+                "specifies a directory in which SVNTraceIO writes a file "
+                "per request, listing every repository item accessed as "
+                "JSON lines."),
+
+  /* per directory/location */
+  AP_INIT_FLAG("SVNLogCommitTiming", SVNLogCommitTiming_cmd, NULL,
+               ACCESS_CONF|RSRC_CONF,
+               "measures how long the phases of each commit take and makes "
+               "them available to mod_log_config as %{SVN-COMMIT-TIMING}e "
+               "(default is Off)."),
+
+  /* per directory/location */
+  AP_INIT_FLAG("SVNBinaryReports", SVNBinaryReports_cmd, NULL,
+               ACCESS_CONF|RSRC_CONF,
+               "offers clients a compact binary encoding of log reports "
+               "instead of XML (default is Off)."),
+
+  /* per directory/location */
+  AP_INIT_FLAG("SVNContentAddressedURLs", SVNContentAddressedURLs_cmd, NULL,
+               ACCESS_CONF|RSRC_CONF,
+               "lets clients fetch file contents and deltas through URIs "
+               "that depend on their checksums only and may be cached by "
+               "shared HTTP caches.  Enable only if every user of such a "
+               "cache may read the whole repository (default is Off)."),
+
+  /* per directory/location */
+  AP_INIT_TAKE1("SVNCheckoutBundleCache", SVNCheckoutBundleCache_cmd, NULL,
+                ACCESS_CONF|RSRC_CONF,
+                "specifies a directory in which the responses to full "
+                "checkouts get recorded and from which they are served "
+                "again to clients requesting the same checkout.  Not used "
+                "for checkouts filtered by path-based authz.  Changes to "
+                "revision properties do not invalidate these bundles "
+                "(default is no cache)."),
+
+  /* per directory/location */
+  AP_INIT_TAKE1("SVNCheckoutBundleCacheSize", SVNCheckoutBundleCacheSize_cmd,
+                NULL, ACCESS_CONF|RSRC_CONF,
+                "specifies the maximum size in MB of the bundles in "
+                "SVNCheckoutBundleCache; least recently used ones get "
+                "removed first (default is 1024)."),
+
+  /* per directory/location */
+  AP_INIT_TAKE1("SVNUpdateEncoderThreads", SVNUpdateEncoderThreads_cmd, NULL,
+                ACCESS_CONF|RSRC_CONF,
+                "specifies the number of worker threads that compress and "
+                "encode file contents sent inline with update reports "
+                "(0 encodes them in the request thread, default is 0)."),
+
+  /* per directory/location */
+  AP_INIT_TAKE1("SVNMaxChangedPaths", SVNMaxChangedPaths_cmd, NULL,
+                ACCESS_CONF|RSRC_CONF,
+                "specifies the maximum number of changed paths reported "
+                "per revision in log responses; longer lists get truncated "
+                "(0 means no limit, default is 0)."),
+
   /* per server */
   AP_INIT_TAKE1("SVNInMemoryCacheSize", SVNInMemoryCacheSize_cmd, NULL,
                 RSRC_CONF,
@@ -1389,6 +1941,31 @@ static const command_rec cmds[] =
                 "in-memory object cache (default value is 16384; 0 switches "
                 "to dynamically sized caches)."),
   /* per server */
+  AP_INIT_FLAG("SVNInMemoryCacheShared", SVNInMemoryCacheShared_cmd, NULL,
+               RSRC_CONF,
+               "places Subversion's in-memory object cache in shared memory "
+               "such that all httpd child processes use the same cache "
+               "(default is Off)."),
+  /* per server */
+  AP_INIT_TAKE2("SVNCacheOverflowFile", SVNCacheOverflowFile_cmd, NULL,
+                RSRC_CONF,
+                "specifies a directory, e.g. on a local SSD, and the size in "
+                "kB per process of a temporary file that keeps items evicted "
+                "from the in-memory object cache (default is no file; not "
+                "used with SVNInMemoryCacheShared)."),
+  /* per server */
+  AP_INIT_TAKE12("SVNCacheSnapshotFile", SVNCacheSnapshotFile_cmd, NULL,
+                 RSRC_CONF,
+                 "specifies a file to restore the in-memory object cache "
+                 "from at startup and to save it to after requests, at most "
+                 "once per the optional number of seconds (default 300)."),
+  /* per server */
+  AP_INIT_TAKE1("SVNAuthzCacheDir", SVNAuthzCacheDir_cmd, NULL,
+                RSRC_CONF,
+                "specifies a directory in which compiled authz rules get "
+                "stored such that other httpd child processes don't need "
+                "to parse them again (default is unset)."),
+  /* per server */
   AP_INIT_TAKE1("SVNCompressionLevel", SVNCompressionLevel_cmd, NULL,
                 RSRC_CONF,
                 "specifies the compression level used before sending file "
@@ -1445,6 +2022,20 @@ register_hooks(apr_pool_t *pconf)
   /* Handler to GET Subversion's FSFS cache stats, a bit like mod_status. */
   ap_hook_handler(dav_svn__status, NULL, NULL, APR_HOOK_MIDDLE);
 
+  /* Same for monitoring systems, plus the data to feed it. */
+  ap_hook_handler(dav_svn__metrics, NULL, NULL, APR_HOOK_MIDDLE);
+  ap_hook_log_transaction(dav_svn__log_metrics, NULL, NULL, APR_HOOK_MIDDLE);
+
+  /* Memory usage per pool creation site, for debugging only. */
+  ap_hook_handler(dav_svn__pool_profile, NULL, NULL, APR_HOOK_MIDDLE);
+
+  /* Let the cache contents survive server restarts. */
+  ap_hook_log_transaction(save_cache_snapshot, NULL, NULL, APR_HOOK_LAST);
+
+  /* Provide the I/O totals before mod_log_config writes the log. */
+  ap_hook_log_transaction(dav_svn__log_io_trace, NULL, NULL,
+                          APR_HOOK_REALLY_FIRST);
+
   /* live property handling */
   dav_hook_gather_propsets(dav_svn__gather_propsets, NULL, NULL,
                            APR_HOOK_MIDDLE);
@@ -1458,6 +2049,12 @@ register_hooks(apr_pool_t *pconf)
                             NULL, AP_FTYPE_CONTENT_SET);
   ap_register_output_filter("ReposRewrite", dav_svn__location_body_filter,
                             NULL, AP_FTYPE_CONTENT_SET);
+  ap_register_output_filter("MergeSync", dav_svn__merge_sync_filter,
+                            NULL, AP_FTYPE_CONTENT_SET);
+
+  /* Checkout bundles record what we send, before any content encoding. */
+  ap_register_output_filter("SVN-BUNDLE", dav_svn__bundle_filter,
+                            NULL, AP_FTYPE_RESOURCE);
   ap_register_input_filter("IncomingRewrite", dav_svn__location_in_filter,
                            NULL, AP_FTYPE_CONTENT_SET);
   ap_hook_fixups(dav_svn__proxy_request_fixup, NULL, NULL, APR_HOOK_MIDDLE);
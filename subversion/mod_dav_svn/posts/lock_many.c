@@ -0,0 +1,502 @@
+/*
+ * lock_many.c: mod_dav_svn POST handlers for locking and unlocking
+ *              multiple paths in a single request
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include <httpd.h>
+#include <http_log.h>
+#include <mod_dav.h>
+
+#include "svn_dav.h"
+#include "svn_hash.h"
+#include "svn_pools.h"
+#include "svn_repos.h"
+#include "svn_time.h"
+
+#include "private/svn_fspath.h"
+#include "private/svn_log.h"
+#include "private/svn_skel.h"
+
+#include "../dav_svn.h"
+
+/* The lock-many and unlock-many POSTs let the client lock or unlock any
+ * number of paths with a single request.  The server hands all of them
+ * to the repository layer at once, so the filesystem takes its write
+ * lock only once per request instead of once per path.
+ *
+ * All paths are repository-relative FS paths.  The response, sent with
+ * content type SVN_SKEL_MIME_TYPE, contains one entry per requested path,
+ * in request order:
+ *
+ *   ( ( PATH success [LOCK] ) ... ( PATH failure ( APR-ERR MESSAGE ) ) ... )
+ *
+ * where LOCK is only present for lock-many and has the form
+ *
+ *   ( TOKEN OWNER ( [COMMENT] ) CREATION-DATE ( [EXPIRATION-DATE] ) )
+ */
+
+/* Baton for lock_many_cb(). */
+typedef struct lock_many_baton_t
+{
+  /* Maps const char * FS paths to their svn_skel_t * result entries. */
+  apr_hash_t *results;
+
+  /* Are we locking (as opposed to unlocking)? */
+  svn_boolean_t locking;
+
+  /* Where to allocate RESULTS' contents. */
+  apr_pool_t *pool;
+} lock_many_baton_t;
+
+/* Return a generic "malformed request" error, allocated in POOL. */
+static dav_error *
+malformed_request(apr_pool_t *pool)
+{
+  return dav_svn__new_error(pool, HTTP_BAD_REQUEST, 0, 0,
+                            "Malformatted request skel");
+}
+
+/* Set *STR to the contents of the optional string SKEL, i.e. either
+ * "( )" or "( STR )", allocated in POOL.  Set *STR to NULL for the
+ * empty list.  Return FALSE if SKEL is not of that form. */
+static svn_boolean_t
+parse_optional_str(const char **str,
+                   const svn_skel_t *skel,
+                   apr_pool_t *pool)
+{
+  int len = svn_skel__list_length(skel);
+
+  if (len == 0)
+    {
+      *str = NULL;
+      return TRUE;
+    }
+
+  if (len != 1 || !skel->children->is_atom)
+    return FALSE;
+
+  *str = apr_pstrmemdup(pool, skel->children->data, skel->children->len);
+  return TRUE;
+}
+
+/* Prepend the optional string STR to LIST, allocated in POOL. */
+static void
+prepend_optional_str(const char *str,
+                     svn_skel_t *list,
+                     apr_pool_t *pool)
+{
+  svn_skel_t *skel = svn_skel__make_empty_list(pool);
+
+  if (str)
+    svn_skel__prepend_str(str, skel, pool);
+
+  svn_skel__prepend(skel, list);
+}
+
+/* Return the result entry for a failed operation on PATH with error ERR,
+ * allocated in POOL. */
+static svn_skel_t *
+make_failure(const char *path,
+             svn_error_t *err,
+             apr_pool_t *pool)
+{
+  svn_skel_t *result = svn_skel__make_empty_list(pool);
+  svn_skel_t *error = svn_skel__make_empty_list(pool);
+  char buffer[1024];
+
+  svn_skel__prepend_str(apr_pstrdup(pool,
+                                    svn_err_best_message(err, buffer,
+                                                         sizeof(buffer))),
+                        error, pool);
+  svn_skel__prepend_int(err->apr_err, error, pool);
+
+  svn_skel__prepend(error, result);
+  svn_skel__prepend_str("failure", result, pool);
+  svn_skel__prepend_str(apr_pstrdup(pool, path), result, pool);
+
+  return result;
+}
+
+/* Return the result entry for a successful operation on PATH, allocated in
+ * POOL.  LOCK is the new lock for lock-many and NULL for unlock-many. */
+static svn_skel_t *
+make_success(const char *path,
+             const svn_lock_t *lock,
+             apr_pool_t *pool)
+{
+  svn_skel_t *result = svn_skel__make_empty_list(pool);
+
+  if (lock)
+    {
+      svn_skel_t *lock_skel = svn_skel__make_empty_list(pool);
+
+      prepend_optional_str(lock->expiration_date
+                             ? svn_time_to_cstring(lock->expiration_date,
+                                                   pool)
+                             : NULL,
+                           lock_skel, pool);
+      svn_skel__prepend_str(svn_time_to_cstring(lock->creation_date, pool),
+                            lock_skel, pool);
+      prepend_optional_str(apr_pstrdup(pool, lock->comment), lock_skel,
+                           pool);
+      svn_skel__prepend_str(apr_pstrdup(pool, lock->owner), lock_skel, pool);
+      svn_skel__prepend_str(apr_pstrdup(pool, lock->token), lock_skel, pool);
+
+      svn_skel__prepend(lock_skel, result);
+    }
+
+  svn_skel__prepend_str("success", result, pool);
+  svn_skel__prepend_str(apr_pstrdup(pool, path), result, pool);
+
+  return result;
+}
+
+/* Implements svn_fs_lock_callback_t. */
+static svn_error_t *
+lock_many_cb(void *baton,
+             const char *path,
+             const svn_lock_t *lock,
+             svn_error_t *fs_err,
+             apr_pool_t *pool)
+{
+  lock_many_baton_t *b = baton;
+  svn_skel_t *result;
+
+  if (fs_err)
+    result = make_failure(path, fs_err, b->pool);
+  else
+    result = make_success(path, b->locking ? lock : NULL, b->pool);
+
+  svn_hash_sets(b->results, apr_pstrdup(b->pool, path), result);
+
+  return SVN_NO_ERROR;
+}
+
+/* Parse the list of targets in TARGETS_SKEL.  Each target is a list
+ * whose first element is the PATH atom and whose second element gets
+ * parsed by the caller.  Append the canonical paths to PATHS and return
+ * the respective second elements in SECOND (parallel array).  Allocate
+ * everything in POOL. */
+static dav_error *
+parse_targets(apr_array_header_t *paths,
+              apr_array_header_t *second,
+              const svn_skel_t *targets_skel,
+              apr_pool_t *pool)
+{
+  const svn_skel_t *target;
+
+  if (svn_skel__list_length(targets_skel) < 0)
+    return malformed_request(pool);
+
+  for (target = targets_skel->children; target; target = target->next)
+    {
+      const char *path;
+
+      if (svn_skel__list_length(target) != 2 || !target->children->is_atom)
+        return malformed_request(pool);
+
+      path = apr_pstrmemdup(pool, target->children->data,
+                            target->children->len);
+      APR_ARRAY_PUSH(paths, const char *)
+        = svn_fspath__canonicalize(path, pool);
+      APR_ARRAY_PUSH(second, const svn_skel_t *) = target->children->next;
+    }
+
+  return NULL;
+}
+
+/* Send the per-path results from B for all PATHS to OUTPUT, in the same
+ * order as PATHS.  Paths without a result get reported as failed with
+ * OVERALL_ERR.  Use POOL for allocations. */
+static dav_error *
+send_results(lock_many_baton_t *b,
+             const apr_array_header_t *paths,
+             svn_error_t *overall_err,
+             request_rec *r,
+             dav_svn__output *output,
+             apr_pool_t *pool)
+{
+  svn_skel_t *response = svn_skel__make_empty_list(pool);
+  svn_stringbuf_t *response_str;
+  apr_bucket_brigade *bb;
+  svn_error_t *serr;
+  int i;
+
+  /* Prepending results in reverse order is cheaper than appending. */
+  for (i = paths->nelts - 1; i >= 0; --i)
+    {
+      const char *path = APR_ARRAY_IDX(paths, i, const char *);
+      svn_skel_t *result = svn_hash_gets(b->results, path);
+
+      if (!result)
+        {
+          svn_error_t *err = overall_err;
+          if (!err)
+            err = svn_error_createf(SVN_ERR_FS_GENERAL, NULL,
+                                    "No result for '%s'", path);
+
+          result = make_failure(path, err, pool);
+
+          if (err != overall_err)
+            svn_error_clear(err);
+        }
+
+      /* Duplicate paths share their result, so link a shallow copy. */
+      svn_skel__prepend(apr_pmemdup(pool, result, sizeof(*result)),
+                        response);
+    }
+
+  response_str = svn_skel__unparse(response, pool);
+
+  ap_set_content_type(r, SVN_SKEL_MIME_TYPE);
+  bb = apr_brigade_create(pool, dav_svn__output_get_bucket_alloc(output));
+  serr = dav_svn__brigade_write(bb, output, response_str->data,
+                                response_str->len);
+  if (serr)
+    return dav_svn__convert_err(serr, HTTP_INTERNAL_SERVER_ERROR,
+                                "Error writing POST response", pool);
+
+  return dav_svn__final_flush_or_error(r, bb, output, NULL, pool);
+}
+
+/* Log ERR, returned by the repository layer after the per-path callbacks,
+ * if it only reports a failed post-(un)lock hook and return NULL in that
+ * case.  Otherwise return ERR itself. */
+static svn_error_t *
+filter_post_hook_failure(svn_error_t *err,
+                         request_rec *r,
+                         apr_pool_t *pool)
+{
+  if (err && (err->apr_err == SVN_ERR_REPOS_POST_LOCK_HOOK_FAILED
+              || err->apr_err == SVN_ERR_REPOS_POST_UNLOCK_HOOK_FAILED))
+    {
+      /* The locks have been changed in the repository, so we report
+         the per-path results.  Log the hook failure for diagnostics.
+         This clears ERR. */
+      dav_svn__log_err(r,
+                       dav_svn__convert_err(err, HTTP_INTERNAL_SERVER_ERROR,
+                                            "Post (un)lock hook failure.",
+                                            pool),
+                       APLOG_WARNING);
+      return SVN_NO_ERROR;
+    }
+
+  return err;
+}
+
+/* Respond to a "lock-many" POST request.
+ *
+ * Syntax:  ( lock-many ( [COMMENT] ) STEAL-LOCK
+ *            ( ( PATH CURRENT-REV ) ... ) )
+ *
+ * STEAL-LOCK is 0 or 1.  CURRENT-REV may be -1 to skip the out-of-date
+ * check for that PATH.
+ */
+dav_error *
+dav_svn__post_lock_many(const dav_resource *resource,
+                        svn_skel_t *request_skel,
+                        dav_svn__output *output)
+{
+  request_rec *r = resource->info->r;
+  dav_svn_repos *repos = resource->info->repos;
+  apr_pool_t *pool = resource->pool;
+  apr_pool_t *iterpool;
+  const svn_skel_t *comment_skel, *steal_skel;
+  const char *comment;
+  apr_int64_t steal_lock;
+  apr_array_header_t *paths, *revs;
+  apr_hash_t *targets = apr_hash_make(pool);
+  lock_many_baton_t lmb;
+  dav_error *derr;
+  svn_error_t *serr;
+  int i;
+
+  /* We don't allow anonymous locks */
+  if (! repos->username)
+    return dav_svn__new_error(pool, HTTP_NOT_IMPLEMENTED,
+                              DAV_ERR_LOCK_SAVE_LOCK, 0,
+                              "Anonymous lock creation is not allowed.");
+
+  if (svn_skel__list_length(request_skel) != 4)
+    return malformed_request(pool);
+
+  comment_skel = request_skel->children->next;
+  steal_skel = comment_skel->next;
+
+  if (!parse_optional_str(&comment, comment_skel, pool)
+      || !steal_skel->is_atom)
+    return malformed_request(pool);
+
+  serr = svn_skel__parse_int(&steal_lock, steal_skel, pool);
+  if (serr)
+    return dav_svn__convert_err(serr, HTTP_BAD_REQUEST,
+                                "Malformatted request skel", pool);
+
+  paths = apr_array_make(pool, 16, sizeof(const char *));
+  revs = apr_array_make(pool, 16, sizeof(const svn_skel_t *));
+  derr = parse_targets(paths, revs, steal_skel->next, pool);
+  if (derr)
+    return derr;
+
+  lmb.results = apr_hash_make(pool);
+  lmb.locking = TRUE;
+  lmb.pool = pool;
+
+  /* Check authz and collect the lock targets. */
+  iterpool = svn_pool_create(pool);
+  for (i = 0; i < paths->nelts; ++i)
+    {
+      const char *path = APR_ARRAY_IDX(paths, i, const char *);
+      const svn_skel_t *rev_skel = APR_ARRAY_IDX(revs, i, const svn_skel_t *);
+      apr_int64_t rev;
+
+      svn_pool_clear(iterpool);
+
+      if (!rev_skel->is_atom)
+        return malformed_request(pool);
+
+      serr = svn_skel__parse_int(&rev, rev_skel, iterpool);
+      if (serr)
+        return dav_svn__convert_err(serr, HTTP_BAD_REQUEST,
+                                    "Malformatted request skel", pool);
+
+      if (dav_svn__allow_lock(r, repos, path, iterpool))
+        {
+          /* Duplicate paths get collapsed into a single target. */
+          svn_hash_sets(targets, path,
+                        svn_fs_lock_target_create(NULL, (svn_revnum_t)rev,
+                                                  pool));
+        }
+      else
+        {
+          serr = svn_error_createf(SVN_ERR_RA_NOT_AUTHORIZED, NULL,
+                                   "Access denied to '%s'", path);
+          svn_hash_sets(lmb.results, path, make_failure(path, serr, pool));
+          svn_error_clear(serr);
+        }
+    }
+  svn_pool_destroy(iterpool);
+
+  dav_svn__operational_log(resource->info,
+                           svn_log__lock(targets, steal_lock != 0, pool));
+
+  /* Lock all targets with a single filesystem operation. */
+  serr = svn_repos_fs_lock_many(repos->repos, targets, comment,
+                                FALSE /* is_dav_comment */,
+                                0 /* No expiration time. */,
+                                steal_lock != 0, lock_many_cb, &lmb,
+                                pool, pool);
+  serr = filter_post_hook_failure(serr, r, pool);
+
+  derr = send_results(&lmb, paths, serr, r, output, pool);
+  svn_error_clear(serr);
+
+  return derr;
+}
+
+/* Respond to an "unlock-many" POST request.
+ *
+ * Syntax:  ( unlock-many BREAK-LOCK ( ( PATH ( [TOKEN] ) ) ... ) )
+ *
+ * BREAK-LOCK is 0 or 1.
+ */
+dav_error *
+dav_svn__post_unlock_many(const dav_resource *resource,
+                          svn_skel_t *request_skel,
+                          dav_svn__output *output)
+{
+  request_rec *r = resource->info->r;
+  dav_svn_repos *repos = resource->info->repos;
+  apr_pool_t *pool = resource->pool;
+  apr_pool_t *iterpool;
+  const svn_skel_t *break_skel;
+  apr_int64_t break_lock;
+  apr_array_header_t *paths, *tokens;
+  apr_hash_t *targets = apr_hash_make(pool);
+  lock_many_baton_t lmb;
+  dav_error *derr;
+  svn_error_t *serr;
+  int i;
+
+  if (svn_skel__list_length(request_skel) != 3)
+    return malformed_request(pool);
+
+  break_skel = request_skel->children->next;
+  if (!break_skel->is_atom)
+    return malformed_request(pool);
+
+  serr = svn_skel__parse_int(&break_lock, break_skel, pool);
+  if (serr)
+    return dav_svn__convert_err(serr, HTTP_BAD_REQUEST,
+                                "Malformatted request skel", pool);
+
+  paths = apr_array_make(pool, 16, sizeof(const char *));
+  tokens = apr_array_make(pool, 16, sizeof(const svn_skel_t *));
+  derr = parse_targets(paths, tokens, break_skel->next, pool);
+  if (derr)
+    return derr;
+
+  lmb.results = apr_hash_make(pool);
+  lmb.locking = FALSE;
+  lmb.pool = pool;
+
+  /* Check authz and collect the unlock targets. */
+  iterpool = svn_pool_create(pool);
+  for (i = 0; i < paths->nelts; ++i)
+    {
+      const char *path = APR_ARRAY_IDX(paths, i, const char *);
+      const svn_skel_t *token_skel
+        = APR_ARRAY_IDX(tokens, i, const svn_skel_t *);
+      const char *token;
+
+      svn_pool_clear(iterpool);
+
+      if (!parse_optional_str(&token, token_skel, pool))
+        return malformed_request(pool);
+
+      if (dav_svn__allow_lock(r, repos, path, iterpool))
+        {
+          svn_hash_sets(targets, path, token ? token : "");
+        }
+      else
+        {
+          serr = svn_error_createf(SVN_ERR_RA_NOT_AUTHORIZED, NULL,
+                                   "Access denied to '%s'", path);
+          svn_hash_sets(lmb.results, path, make_failure(path, serr, pool));
+          svn_error_clear(serr);
+        }
+    }
+  svn_pool_destroy(iterpool);
+
+  dav_svn__operational_log(resource->info,
+                           svn_log__unlock(targets, break_lock != 0, pool));
+
+  /* Unlock all targets with a single filesystem operation. */
+  serr = svn_repos_fs_unlock_many(repos->repos, targets, break_lock != 0,
+                                  lock_many_cb, &lmb, pool, pool);
+  serr = filter_post_hook_failure(serr, r, pool);
+
+  derr = send_results(&lmb, paths, serr, r, output, pool);
+  svn_error_clear(serr);
+
+  return derr;
+}
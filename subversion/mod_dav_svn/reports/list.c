@@ -208,6 +208,7 @@ dav_svn__list_report(const dav_resource *resource,
 
   /* These get determined from the request document. */
   svn_revnum_t rev = SVN_INVALID_REVNUM;     /* defaults to HEAD */
+  svn_revnum_t since_rev = SVN_INVALID_REVNUM;
   apr_array_header_t *patterns = NULL;
 
   /* Sanity check. */
@@ -247,6 +248,9 @@ dav_svn__list_report(const dav_resource *resource,
         rev = SVN_STR_TO_REV(dav_xml_get_cdata(child, resource->pool, 1));
       else if (strcmp(child->name, "depth") == 0)
         depth = svn_depth_from_word(dav_xml_get_cdata(child, resource->pool, 1));
+      else if (strcmp(child->name, "since-revision") == 0)
+        since_rev = SVN_STR_TO_REV(dav_xml_get_cdata(child, resource->pool,
+                                                     1));
       else if (strcmp(child->name, "no-patterns") == 0)
         {
           /* specified but empty pattern list */
@@ -298,9 +302,10 @@ dav_svn__list_report(const dav_resource *resource,
     {
       /* Fetch the directory entries if requested and send them immediately. */
       path_info_only = (lrb.dirent_fields & ~SVN_DIRENT_KIND) == 0;
-      serr = svn_repos_list(root, full_path, patterns, depth, path_info_only,
-                            dav_svn__authz_read_func(&arb), &arb,
-                            list_receiver, &lrb, NULL, NULL, resource->pool);
+      serr = svn_repos_list2(root, full_path, patterns, depth, since_rev,
+                             path_info_only, dav_svn__authz_read_func(&arb),
+                             &arb, list_receiver, &lrb, NULL, NULL,
+                             resource->pool);
     }
 
   if (serr)
@@ -25,6 +25,7 @@
 #include <apr_strings.h>
 #include <apr_xml.h>
 
+#include <http_protocol.h>
 #include <mod_dav.h>
 
 #include "svn_repos.h"
@@ -39,6 +40,7 @@
 
 #include "private/svn_log.h"
 #include "private/svn_fspath.h"
+#include "private/svn_skel.h"
 
 #include "../dav_svn.h"
 
@@ -71,9 +73,18 @@ struct log_receiver_baton
   /* whether the client can handle encoded binary property values */
   svn_boolean_t encode_binary_props;
 
+  /* whether we send skel records (see SVN_DAV_NS_DAV_SVN_BINARY_LOG)
+     instead of XML */
+  svn_boolean_t binary;
+
   /* Helper variables to force early bucket brigade flushes */
   int result_count;
   int next_forced_flush;
+
+  /* Number of changed paths sent for the current revision and the
+     maximum number we will send per revision.  0 means unlimited. */
+  unsigned changes_sent;
+  unsigned max_changes;
 };
 
 
@@ -86,11 +97,13 @@ maybe_send_header(struct log_receiver_baton *lrb)
 {
   if (lrb->needs_header)
     {
-      SVN_ERR(dav_svn__brigade_puts(lrb->bb, lrb->output,
-                                    DAV_XML_HEADER DEBUG_CR
-                                    "<S:log-report xmlns:S=\""
-                                    SVN_XML_NAMESPACE "\" "
-                                    "xmlns:D=\"DAV:\">" DEBUG_CR));
+      /* Binary reports have no header. */
+      if (!lrb->binary)
+        SVN_ERR(dav_svn__brigade_puts(lrb->bb, lrb->output,
+                                      DAV_XML_HEADER DEBUG_CR
+                                      "<S:log-report xmlns:S=\""
+                                      SVN_XML_NAMESPACE "\" "
+                                      "xmlns:D=\"DAV:\">" DEBUG_CR));
       lrb->needs_header = FALSE;
     }
 
@@ -104,14 +117,145 @@ maybe_start_log_item(struct log_receiver_baton *lrb)
 {
   if (lrb->needs_log_item)
     {
-      SVN_ERR(dav_svn__brigade_printf(lrb->bb, lrb->output,
-                                      "<S:log-item>" DEBUG_CR));
+      /* Binary reports send all log-item data in a single record. */
+      if (!lrb->binary)
+        SVN_ERR(dav_svn__brigade_printf(lrb->bb, lrb->output,
+                                        "<S:log-item>" DEBUG_CR));
       lrb->needs_log_item = FALSE;
     }
 
   return SVN_NO_ERROR;
 }
 
+/* Send SKEL as a record of a binary log report to LRB's output.
+   Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+send_record(struct log_receiver_baton *lrb,
+            const svn_skel_t *skel,
+            apr_pool_t *scratch_pool)
+{
+  svn_stringbuf_t *data = svn_skel__unparse(skel, scratch_pool);
+
+  SVN_ERR(dav_svn__brigade_printf(lrb->bb, lrb->output,
+                                  "%" APR_SIZE_T_FMT "\n", data->len));
+  return svn_error_trace(dav_svn__brigade_write(lrb->bb, lrb->output,
+                                                data->data, data->len));
+}
+
+/* Send CHANGE as a "change" record to LRB's output.  Use SCRATCH_POOL
+   for temporary allocations. */
+static svn_error_t *
+send_change_record(struct log_receiver_baton *lrb,
+                   svn_repos_path_change_t *change,
+                   apr_pool_t *scratch_pool)
+{
+  svn_skel_t *skel = svn_skel__make_empty_list(scratch_pool);
+  const char *action;
+
+  switch (change->change_kind)
+    {
+    case svn_fs_path_change_add:
+      action = "A";
+      break;
+
+    case svn_fs_path_change_replace:
+      action = "R";
+      break;
+
+    case svn_fs_path_change_delete:
+      action = "D";
+      break;
+
+    case svn_fs_path_change_modify:
+      action = "M";
+      break;
+
+    default:
+      return SVN_NO_ERROR;
+    }
+
+  /* Build the list back to front. */
+  if ((change->change_kind == svn_fs_path_change_add
+       || change->change_kind == svn_fs_path_change_replace)
+      && change->copyfrom_path
+      && SVN_IS_VALID_REVNUM(change->copyfrom_rev))
+    {
+      svn_skel__prepend_int(change->copyfrom_rev, skel, scratch_pool);
+      svn_skel__prepend_str(change->copyfrom_path, skel, scratch_pool);
+    }
+
+  svn_skel__prepend_str(change->prop_mod ? "true" : "false", skel,
+                        scratch_pool);
+  svn_skel__prepend_str(change->text_mod ? "true" : "false", skel,
+                        scratch_pool);
+  svn_skel__prepend_str(svn_node_kind_to_word(change->node_kind), skel,
+                        scratch_pool);
+  svn_skel__prepend_str(action, skel, scratch_pool);
+  svn_skel__prepend(svn_skel__mem_atom(change->path.data, change->path.len,
+                                       scratch_pool),
+                    skel);
+  svn_skel__prepend_str("change", skel, scratch_pool);
+
+  return svn_error_trace(send_record(lrb, skel, scratch_pool));
+}
+
+/* Send the revision info of LOG_ENTRY as a "log-item" record to LRB's
+   output.  Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+send_log_item_record(struct log_receiver_baton *lrb,
+                     svn_repos_log_entry_t *log_entry,
+                     apr_pool_t *scratch_pool)
+{
+  svn_skel_t *skel = svn_skel__make_empty_list(scratch_pool);
+  svn_skel_t *proplist;
+
+  if (log_entry->subtractive_merge)
+    svn_skel__prepend_str("subtractive-merge", skel, scratch_pool);
+  if (log_entry->has_children)
+    svn_skel__prepend_str("has-children", skel, scratch_pool);
+
+  SVN_ERR(svn_skel__unparse_proplist(&proplist,
+                                     log_entry->revprops
+                                       ? log_entry->revprops
+                                       : apr_hash_make(scratch_pool),
+                                     scratch_pool));
+  svn_skel__prepend(proplist, skel);
+  svn_skel__prepend_int(log_entry->revision, skel, scratch_pool);
+  svn_skel__prepend_str("log-item", skel, scratch_pool);
+
+  return svn_error_trace(send_record(lrb, skel, scratch_pool));
+}
+
+/* Send ERR as a "failure" record to LRB's output.  Use SCRATCH_POOL for
+   temporary allocations. */
+static svn_error_t *
+send_failure_record(struct log_receiver_baton *lrb,
+                    svn_error_t *err,
+                    apr_pool_t *scratch_pool)
+{
+  svn_skel_t *skel = svn_skel__make_empty_list(scratch_pool);
+  char buffer[1024];
+
+  svn_skel__prepend_str(svn_err_best_message(err, buffer, sizeof(buffer)),
+                        skel, scratch_pool);
+  svn_skel__prepend_int(err->apr_err, skel, scratch_pool);
+  svn_skel__prepend_str("failure", skel, scratch_pool);
+
+  return svn_error_trace(send_record(lrb, skel, scratch_pool));
+}
+
+/* Send the "done" record that ends a binary log report to LRB's output.
+   Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+send_done_record(struct log_receiver_baton *lrb,
+                 apr_pool_t *scratch_pool)
+{
+  svn_skel_t *skel = svn_skel__make_empty_list(scratch_pool);
+
+  svn_skel__prepend_str("done", skel, scratch_pool);
+  return svn_error_trace(send_record(lrb, skel, scratch_pool));
+}
+
 /* Utility for log_receiver opening a new XML element in LRB's brigade
    for LOG_ITEM and return the element's name in *ELEMENT.  Use POOL for
    temporary allocations.
@@ -155,25 +299,15 @@ start_path_with_copy_from(const char **element,
 }
 
 
-/* This implements `svn_repos_path_change_receiver_t'.
-   BATON is a `struct log_receiver_baton *'.  */
+/* Send CHANGE as a changed-path element to LRB's output.  Use
+   SCRATCH_POOL for temporary allocations. */
 static svn_error_t *
-log_change_receiver(void *baton,
-                    svn_repos_path_change_t *change,
-                    apr_pool_t *scratch_pool)
+send_change_xml(struct log_receiver_baton *lrb,
+                svn_repos_path_change_t *change,
+                apr_pool_t *scratch_pool)
 {
-  struct log_receiver_baton *lrb = baton;
   const char *close_element = NULL;
 
-  /* We must open the XML nodes for the report and log-item before
-     sending the first changed path.
-
-     Note that we can't get here for empty revisions that log() injects
-     to indicate the end of a recursive merged rev sequence.
-   */
-  SVN_ERR(maybe_send_header(lrb));
-  SVN_ERR(maybe_start_log_item(lrb));
-
   /* ### todo: is there a D: namespace equivalent for
       `changed-path'?  Should use it if so. */
   switch (change->change_kind)
@@ -217,33 +351,14 @@ log_change_receiver(void *baton,
   return SVN_NO_ERROR;
 }
 
-/* This implements `svn_repos_log_entry_receiver_t'.
-   BATON is a `struct log_receiver_baton *'.  */
+/* Send the revision info of LOG_ENTRY as child elements of the current
+   log-item element and close that element.  Use SCRATCH_POOL for
+   temporary allocations. */
 static svn_error_t *
-log_revision_receiver(void *baton,
-                      svn_repos_log_entry_t *log_entry,
-                      apr_pool_t *scratch_pool)
+send_log_item_xml(struct log_receiver_baton *lrb,
+                  svn_repos_log_entry_t *log_entry,
+                  apr_pool_t *scratch_pool)
 {
-  struct log_receiver_baton *lrb = baton;
-
-  SVN_ERR(maybe_send_header(lrb));
-
-  if (log_entry->revision == SVN_INVALID_REVNUM)
-    {
-      /* If the stack depth is zero, we've seen the last revision, so don't
-         send it, just return.  The footer will be sent later. */
-      if (lrb->stack_depth == 0)
-        return SVN_NO_ERROR;
-      else
-        lrb->stack_depth--;
-    }
-
-  /* If we have not received any path changes, the log-item XML node
-     still needs to be opened.  Also, reset the controlling flag to
-     prepare it for the next revision - if there should be one. */
-  SVN_ERR(maybe_start_log_item(lrb));
-  lrb->needs_log_item = TRUE;
-
   /* Path changes have been processed already. 
      Now send the remaining per-revision info. */
   SVN_ERR(dav_svn__brigade_printf(lrb->bb, lrb->output,
@@ -311,10 +426,7 @@ log_revision_receiver(void *baton,
     }
 
   if (log_entry->has_children)
-    {
-      SVN_ERR(dav_svn__brigade_puts(lrb->bb, lrb->output, "<S:has-children/>"));
-      lrb->stack_depth++;
-    }
+    SVN_ERR(dav_svn__brigade_puts(lrb->bb, lrb->output, "<S:has-children/>"));
 
   if (log_entry->subtractive_merge)
     SVN_ERR(dav_svn__brigade_puts(lrb->bb, lrb->output,
@@ -323,6 +435,75 @@ log_revision_receiver(void *baton,
   SVN_ERR(dav_svn__brigade_puts(lrb->bb, lrb->output,
                                 "</S:log-item>" DEBUG_CR));
 
+  return SVN_NO_ERROR;
+}
+
+/* This implements `svn_repos_path_change_receiver_t'.
+   BATON is a `struct log_receiver_baton *'.  */
+static svn_error_t *
+log_change_receiver(void *baton,
+                    svn_repos_path_change_t *change,
+                    apr_pool_t *scratch_pool)
+{
+  struct log_receiver_baton *lrb = baton;
+
+  /* We must open the XML nodes for the report and log-item before
+     sending the first changed path.
+
+     Note that we can't get here for empty revisions that log() injects
+     to indicate the end of a recursive merged rev sequence.
+   */
+  SVN_ERR(maybe_send_header(lrb));
+  SVN_ERR(maybe_start_log_item(lrb));
+
+  if (lrb->binary)
+    SVN_ERR(send_change_record(lrb, change, scratch_pool));
+  else
+    SVN_ERR(send_change_xml(lrb, change, scratch_pool));
+
+  /* Truncate huge changed paths lists. */
+  if (lrb->max_changes && ++lrb->changes_sent >= lrb->max_changes)
+    return svn_error_create(SVN_ERR_CEASE_INVOCATION, NULL, NULL);
+
+  return SVN_NO_ERROR;
+}
+
+/* This implements `svn_repos_log_entry_receiver_t'.
+   BATON is a `struct log_receiver_baton *'.  */
+static svn_error_t *
+log_revision_receiver(void *baton,
+                      svn_repos_log_entry_t *log_entry,
+                      apr_pool_t *scratch_pool)
+{
+  struct log_receiver_baton *lrb = baton;
+
+  SVN_ERR(maybe_send_header(lrb));
+
+  if (log_entry->revision == SVN_INVALID_REVNUM)
+    {
+      /* If the stack depth is zero, we've seen the last revision, so don't
+         send it, just return.  The footer will be sent later. */
+      if (lrb->stack_depth == 0)
+        return SVN_NO_ERROR;
+      else
+        lrb->stack_depth--;
+    }
+
+  /* If we have not received any path changes, the log-item XML node
+     still needs to be opened.  Also, reset the controlling flag to
+     prepare it for the next revision - if there should be one. */
+  SVN_ERR(maybe_start_log_item(lrb));
+  lrb->needs_log_item = TRUE;
+  lrb->changes_sent = 0;
+
+  if (lrb->binary)
+    SVN_ERR(send_log_item_record(lrb, log_entry, scratch_pool));
+  else
+    SVN_ERR(send_log_item_xml(lrb, log_entry, scratch_pool));
+
+  if (log_entry->has_children)
+    lrb->stack_depth++;
+
   /* In general APR will flush the brigade every 8000 bytes through the filter
      stack, but log items may not be generated that fast, especially in
      combination with authz and busy servers. We now explictly flush after
@@ -402,6 +583,7 @@ dav_svn__log_report(const dav_resource *resource,
 
   lrb.requested_custom_revprops = FALSE;
   lrb.encode_binary_props = FALSE;
+  lrb.binary = FALSE;
   for (child = doc->root->first_child; child != NULL; child = child->next)
     {
       /* if this element isn't one of ours, then skip it */
@@ -431,6 +613,8 @@ dav_svn__log_report(const dav_resource *resource,
         include_merged_revisions = TRUE; /* presence indicates positivity */
       else if (strcmp(child->name, "encode-binary-props") == 0)
         lrb.encode_binary_props = TRUE; /* presence indicates positivity */
+      else if (strcmp(child->name, "binary-report") == 0)
+        lrb.binary = dav_svn__get_binary_reports_flag(resource->info->r);
       else if (strcmp(child->name, "all-revprops") == 0)
         {
           revprops = NULL; /* presence indicates fetch all revprops */
@@ -499,6 +683,14 @@ dav_svn__log_report(const dav_resource *resource,
   lrb.result_count = 0;
   lrb.next_forced_flush = 4;
 
+  lrb.changes_sent = 0;
+  lrb.max_changes = dav_svn__get_max_changed_paths(resource->info->r);
+
+  /* Errors before the first record still get the usual error response,
+     which comes with its own content type. */
+  if (lrb.binary)
+    ap_set_content_type(resource->info->r, SVN_SKEL_MIME_TYPE);
+
   /* Our svn_log_entry_receiver_t sends the <S:log-report> header in
      a lazy fashion.  Before writing the first log message, it assures
      that the header has already been sent (checking the needs_header
@@ -523,6 +715,11 @@ dav_svn__log_report(const dav_resource *resource,
                              resource->pool);
   if (serr)
     {
+      /* Once we started sending records, the client can't see the
+         HTTP status anymore.  Tell it what went wrong. */
+      if (lrb.binary && !lrb.needs_header)
+        svn_error_clear(send_failure_record(&lrb, serr, resource->pool));
+
       derr = dav_svn__convert_err(serr, HTTP_BAD_REQUEST, NULL,
                                   resource->pool);
       goto cleanup;
@@ -536,8 +733,12 @@ dav_svn__log_report(const dav_resource *resource,
       goto cleanup;
     }
 
-  if ((serr = dav_svn__brigade_puts(lrb.bb, lrb.output,
-                                    "</S:log-report>" DEBUG_CR)))
+  if (lrb.binary)
+    serr = send_done_record(&lrb, resource->pool);
+  else
+    serr = dav_svn__brigade_puts(lrb.bb, lrb.output,
+                                 "</S:log-report>" DEBUG_CR);
+  if (serr)
     {
       derr = dav_svn__convert_err(serr, HTTP_INTERNAL_SERVER_ERROR,
                                   "Error ending REPORT response.",
@@ -0,0 +1,190 @@
+/*
+ * rev-proplist-range.c: mod_dav_svn REPORT handler for fetching the
+ *                       revision properties of many revisions
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include <apr_pools.h>
+#include <apr_strings.h>
+#include <apr_xml.h>
+
+#include <mod_dav.h>
+
+#include "svn_repos.h"
+#include "svn_types.h"
+#include "svn_xml.h"
+#include "svn_dav.h"
+#include "svn_pools.h"
+#include "svn_base64.h"
+
+#include "../dav_svn.h"
+
+/* Send the S:revprops element for REVISION with PROPS to OUTPUT through
+   BB.  Use POOL for temporary allocations. */
+static svn_error_t *
+send_revprops(apr_bucket_brigade *bb,
+              dav_svn__output *output,
+              svn_revnum_t revision,
+              apr_hash_t *props,
+              apr_pool_t *pool)
+{
+  apr_hash_index_t *hi;
+
+  SVN_ERR(dav_svn__brigade_printf(bb, output,
+                                  "<S:revprops rev=\"%ld\">" DEBUG_CR,
+                                  revision));
+
+  for (hi = apr_hash_first(pool, props); hi; hi = apr_hash_next(hi))
+    {
+      const char *name = apr_hash_this_key(hi);
+      const svn_string_t *value = apr_hash_this_val(hi);
+
+      name = apr_xml_quote_string(pool, name, 1);
+      if (svn_xml_is_xml_safe(value->data, value->len))
+        {
+          svn_stringbuf_t *tmp = NULL;
+
+          svn_xml_escape_cdata_string(&tmp, value, pool);
+          SVN_ERR(dav_svn__brigade_printf(bb, output,
+                                          "<S:prop name=\"%s\">%s</S:prop>"
+                                          DEBUG_CR, name, tmp->data));
+        }
+      else
+        {
+          SVN_ERR(dav_svn__brigade_printf(
+                    bb, output,
+                    "<S:prop name=\"%s\" encoding=\"base64\">%s</S:prop>"
+                    DEBUG_CR, name,
+                    svn_base64_encode_string2(value, TRUE, pool)->data));
+        }
+    }
+
+  return svn_error_trace(dav_svn__brigade_puts(bb, output,
+                                               "</S:revprops>" DEBUG_CR));
+}
+
+dav_error *
+dav_svn__rev_proplist_range_report(const dav_resource *resource,
+                                   const apr_xml_doc *doc,
+                                   dav_svn__output *output)
+{
+  svn_error_t *serr = SVN_NO_ERROR;
+  dav_error *derr = NULL;
+  apr_xml_elem *child;
+  apr_bucket_brigade *bb;
+  const dav_svn_repos *repos = resource->info->repos;
+  dav_svn__authz_read_baton arb;
+  svn_revnum_t start_rev = SVN_INVALID_REVNUM;
+  svn_revnum_t end_rev = SVN_INVALID_REVNUM;
+  svn_revnum_t youngest, rev;
+  apr_pool_t *iterpool;
+  int ns;
+
+  ns = dav_svn__find_ns(doc->namespaces, SVN_XML_NAMESPACE);
+  if (ns == -1)
+    {
+      return dav_svn__new_error_svn(resource->pool, HTTP_BAD_REQUEST, 0, 0,
+                                    "The request does not contain the 'svn:' "
+                                    "namespace, so it is not going to have "
+                                    "certain required elements");
+    }
+
+  /* The report doesn't depend on the resource it is run against. */
+  for (child = doc->root->first_child; child != NULL; child = child->next)
+    {
+      /* if this element isn't one of ours, then skip it */
+      if (child->ns != ns)
+        continue;
+
+      if (strcmp(child->name, "start-revision") == 0)
+        start_rev = SVN_STR_TO_REV(
+                      dav_xml_get_cdata(child, resource->pool, 1));
+      else if (strcmp(child->name, "end-revision") == 0)
+        end_rev = SVN_STR_TO_REV(
+                    dav_xml_get_cdata(child, resource->pool, 1));
+      /* else unknown element; skip it */
+    }
+
+  if (!SVN_IS_VALID_REVNUM(start_rev) || !SVN_IS_VALID_REVNUM(end_rev)
+      || start_rev > end_rev)
+    return dav_svn__new_error_svn(resource->pool, HTTP_BAD_REQUEST, 0, 0,
+                                  "The request does not contain a valid "
+                                  "revision range");
+
+  /* Check the range before anything has been sent, so we can still return
+     a proper status code. */
+  serr = svn_fs_youngest_rev(&youngest, repos->fs, resource->pool);
+  if (serr)
+    return dav_svn__convert_err(serr, HTTP_INTERNAL_SERVER_ERROR,
+                                "Could not determine youngest revision",
+                                resource->pool);
+  if (end_rev > youngest)
+    return dav_svn__convert_err(svn_error_createf(
+                                  SVN_ERR_FS_NO_SUCH_REVISION, NULL,
+                                  "No such revision %ld", end_rev),
+                                HTTP_BAD_REQUEST, NULL, resource->pool);
+
+  /* Like a PROPFIND on each of the revisions, hide the properties of
+     revisions that are not readable. */
+  arb.r = resource->info->r;
+  arb.repos = resource->info->repos;
+
+  bb = apr_brigade_create(resource->pool,
+                          dav_svn__output_get_bucket_alloc(output));
+
+  serr = dav_svn__brigade_puts(bb, output,
+                               DAV_XML_HEADER DEBUG_CR
+                               "<S:rev-proplist-range-report xmlns:S=\""
+                               SVN_XML_NAMESPACE "\" "
+                               "xmlns:D=\"DAV:\">" DEBUG_CR);
+
+  iterpool = svn_pool_create(resource->pool);
+  for (rev = start_rev; !serr && rev <= end_rev; rev++)
+    {
+      apr_hash_t *props;
+
+      svn_pool_clear(iterpool);
+
+      serr = svn_repos_fs_revision_proplist(&props, repos->repos, rev,
+                                            dav_svn__authz_read_func(&arb),
+                                            &arb, iterpool);
+      if (!serr)
+        serr = send_revprops(bb, output, rev, props, iterpool);
+    }
+  svn_pool_destroy(iterpool);
+
+  if (!serr)
+    serr = dav_svn__brigade_puts(bb, output,
+                                 "</S:rev-proplist-range-report>" DEBUG_CR);
+
+  if (serr)
+    derr = dav_svn__convert_err(serr, HTTP_INTERNAL_SERVER_ERROR,
+                                "Error writing REPORT response.",
+                                resource->pool);
+
+  dav_svn__operational_log(resource->info,
+                           apr_psprintf(resource->pool,
+                                        "rev-proplist-range r%ld:%ld",
+                                        start_rev, end_rev));
+
+  return dav_svn__final_flush_or_error(resource->info->r, bb, output,
+                                       derr, resource->pool);
+}
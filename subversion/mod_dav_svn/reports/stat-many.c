@@ -0,0 +1,245 @@
+/*
+ * stat-many.c: mod_dav_svn REPORT handler for stat'ing many paths
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include <apr_pools.h>
+#include <apr_strings.h>
+#include <apr_xml.h>
+
+#include <mod_dav.h>
+
+#include "svn_repos.h"
+#include "svn_types.h"
+#include "svn_xml.h"
+#include "svn_path.h"
+#include "svn_dav.h"
+#include "svn_pools.h"
+#include "svn_time.h"
+
+#include "private/svn_fspath.h"
+
+#include "../dav_svn.h"
+
+/* Send the S:entry element for PATH in REVISION with DIRENT, which is NULL
+   if PATH does not exist, to OUTPUT through BB.  IS_SVN_CLIENT tells
+   whether to escape the author like for SVN clients.  Use POOL for
+   temporary allocations. */
+static svn_error_t *
+send_entry(apr_bucket_brigade *bb,
+           dav_svn__output *output,
+           const char *path,
+           svn_revnum_t revision,
+           const svn_dirent_t *dirent,
+           svn_boolean_t is_svn_client,
+           apr_pool_t *pool)
+{
+  const char *attr_date = "";
+  const char *tag_author = "";
+
+  if (!dirent)
+    return svn_error_trace(dav_svn__brigade_printf(bb, output,
+                                 "<S:entry rev=\"%ld\" node-kind=\"none\">"
+                                 "%s</S:entry>" DEBUG_CR,
+                                 revision,
+                                 apr_xml_quote_string(pool, path, 0)));
+
+  if (dirent->time != (apr_time_t) -1)
+    {
+      const char *ctime = svn_time_to_cstring(dirent->time, pool);
+      attr_date = apr_psprintf(pool, " date=\"%s\"",
+                               apr_xml_quote_string(pool, ctime, 0));
+    }
+
+  if (dirent->last_author)
+    {
+      const char *author = dav_svn__fuzzy_escape_author(dirent->last_author,
+                                                        is_svn_client,
+                                                        pool, pool);
+      tag_author = apr_psprintf(pool,
+                                "<D:creator-displayname>%s"
+                                "</D:creator-displayname>",
+                                apr_xml_quote_string(pool, author, 1));
+    }
+
+  return svn_error_trace(dav_svn__brigade_printf(bb, output,
+                                 "<S:entry"
+                                 " rev=\"%ld\""
+                                 " node-kind=\"%s\""
+                                 " size=\"%" SVN_FILESIZE_T_FMT "\""
+                                 " has-props=\"%s\""
+                                 " created-rev=\"%ld\""
+                                 "%s>%s%s</S:entry>" DEBUG_CR,
+                                 revision,
+                                 svn_node_kind_to_word(dirent->kind),
+                                 dirent->size,
+                                 dirent->has_props ? "true" : "false",
+                                 dirent->created_rev,
+                                 attr_date,
+                                 apr_xml_quote_string(pool, path, 0),
+                                 tag_author));
+}
+
+dav_error *
+dav_svn__stat_many_report(const dav_resource *resource,
+                          const apr_xml_doc *doc,
+                          dav_svn__output *output)
+{
+  svn_error_t *serr = SVN_NO_ERROR;
+  dav_error *derr = NULL;
+  apr_xml_elem *child;
+  apr_bucket_brigade *bb;
+  const dav_svn_repos *repos = resource->info->repos;
+  apr_array_header_t *paths, *full_paths, *revisions;
+  svn_revnum_t youngest = SVN_INVALID_REVNUM;
+  svn_revnum_t root_rev = SVN_INVALID_REVNUM;
+  svn_fs_root_t *root = NULL;
+  apr_pool_t *root_pool, *iterpool;
+  int ns;
+  int i;
+
+  ns = dav_svn__find_ns(doc->namespaces, SVN_XML_NAMESPACE);
+  if (ns == -1)
+    {
+      return dav_svn__new_error_svn(resource->pool, HTTP_BAD_REQUEST, 0, 0,
+                                    "The request does not contain the 'svn:' "
+                                    "namespace, so it is not going to have "
+                                    "certain required elements");
+    }
+
+  paths = apr_array_make(resource->pool, 16, sizeof(const char *));
+  full_paths = apr_array_make(resource->pool, 16, sizeof(const char *));
+  revisions = apr_array_make(resource->pool, 16, sizeof(svn_revnum_t));
+
+  /* Each entry is a path relative to the repository root, with an
+     optional revision.  The report doesn't depend on the resource it is
+     run against. */
+  for (child = doc->root->first_child; child != NULL; child = child->next)
+    {
+      /* if this element isn't one of ours, then skip it */
+      if (child->ns != ns)
+        continue;
+
+      if (strcmp(child->name, "entry") == 0)
+        {
+          const char *rel_path = dav_xml_get_cdata(child, resource->pool, 0);
+          const char *rev_str = dav_find_attr_val(child, "rev");
+
+          if ((derr = dav_svn__test_canonical(rel_path, resource->pool)))
+            return derr;
+
+          APR_ARRAY_PUSH(paths, const char *) = rel_path;
+          APR_ARRAY_PUSH(full_paths, const char *)
+            = svn_fspath__join("/",
+                               svn_relpath_canonicalize(rel_path,
+                                                        resource->pool),
+                               resource->pool);
+          APR_ARRAY_PUSH(revisions, svn_revnum_t)
+            = rev_str ? SVN_STR_TO_REV(rev_str) : SVN_INVALID_REVNUM;
+        }
+      /* else unknown element; skip it */
+    }
+
+  /* Like a PROPFIND on each of the paths would, refuse the whole request
+     if one of them is unreadable.  This happens before anything has been
+     sent, so we can still return a proper status code. */
+  for (i = 0; i < full_paths->nelts; i++)
+    {
+      svn_revnum_t rev = APR_ARRAY_IDX(revisions, i, svn_revnum_t);
+
+      if (!SVN_IS_VALID_REVNUM(rev))
+        {
+          if (!SVN_IS_VALID_REVNUM(youngest))
+            {
+              serr = svn_fs_youngest_rev(&youngest, repos->fs,
+                                         resource->pool);
+              if (serr)
+                return dav_svn__convert_err(serr, HTTP_INTERNAL_SERVER_ERROR,
+                                            "Could not determine youngest "
+                                            "revision", resource->pool);
+            }
+          APR_ARRAY_IDX(revisions, i, svn_revnum_t) = rev = youngest;
+        }
+
+      if (!dav_svn__allow_read(resource->info->r, repos,
+                               APR_ARRAY_IDX(full_paths, i, const char *),
+                               rev, resource->pool))
+        return dav_svn__new_error(resource->pool, HTTP_FORBIDDEN, 0, 0,
+                                  "Access to one of the requested paths "
+                                  "forbidden");
+    }
+
+  bb = apr_brigade_create(resource->pool,
+                          dav_svn__output_get_bucket_alloc(output));
+
+  serr = dav_svn__brigade_puts(bb, output,
+                               DAV_XML_HEADER DEBUG_CR
+                               "<S:stat-many-report xmlns:S=\""
+                               SVN_XML_NAMESPACE "\" "
+                               "xmlns:D=\"DAV:\">" DEBUG_CR);
+
+  /* Consecutive entries tend to be in the same revision, so keep the last
+     revision root around. */
+  root_pool = svn_pool_create(resource->pool);
+  iterpool = svn_pool_create(resource->pool);
+  for (i = 0; !serr && i < full_paths->nelts; i++)
+    {
+      svn_revnum_t rev = APR_ARRAY_IDX(revisions, i, svn_revnum_t);
+      svn_dirent_t *dirent;
+
+      svn_pool_clear(iterpool);
+
+      if (rev != root_rev)
+        {
+          svn_pool_clear(root_pool);
+          root_rev = SVN_INVALID_REVNUM;
+          serr = svn_fs_revision_root(&root, repos->fs, rev, root_pool);
+          if (serr)
+            break;
+          root_rev = rev;
+        }
+
+      serr = svn_repos_stat(&dirent, root,
+                            APR_ARRAY_IDX(full_paths, i, const char *),
+                            iterpool);
+      if (!serr)
+        serr = send_entry(bb, output, APR_ARRAY_IDX(paths, i, const char *),
+                          rev, dirent, repos->is_svn_client, iterpool);
+    }
+  svn_pool_destroy(iterpool);
+  svn_pool_destroy(root_pool);
+
+  if (!serr)
+    serr = dav_svn__brigade_puts(bb, output,
+                                 "</S:stat-many-report>" DEBUG_CR);
+
+  if (serr)
+    derr = dav_svn__convert_err(serr, HTTP_INTERNAL_SERVER_ERROR,
+                                "Error writing REPORT response.",
+                                resource->pool);
+
+  dav_svn__operational_log(resource->info,
+                           apr_psprintf(resource->pool, "stat-many %d",
+                                        full_paths->nelts));
+
+  return dav_svn__final_flush_or_error(resource->info->r, bb, output,
+                                       derr, resource->pool);
+}
@@ -42,6 +42,7 @@
 
 #include "private/svn_log.h"
 #include "private/svn_fspath.h"
+#include "private/svn_worker_pool.h"
 
 #include "../dav_svn.h"
 
@@ -96,6 +97,10 @@ typedef struct update_ctx_t {
      resource" and are we advertising support for as much? */
   svn_boolean_t enable_v2_response;
 
+  /* If not NULL, text deltas get encoded by worker threads and all output
+     has to go through this queue. */
+  struct output_pipeline_t *pipeline;
+
 } update_ctx_t;
 
 
@@ -137,6 +142,362 @@ typedef struct item_baton_t {
 #define DIR_OR_FILE(is_dir) ((is_dir) ? "directory" : "file")
 
 
+/*** Parallel encoding of text deltas. ***/
+
+/* In "send-all" mode, most of the CPU time goes into compressing text
+   delta windows into svndiff.  If SVNUpdateEncoderThreads is set, hand
+   the windows to a set of worker threads instead while the tree walk
+   goes on.  The response must keep its order, though, so all output is
+   queued behind the first window that is still in progress.  The
+   request thread sends queued items in order as soon as they become
+   available.  Only the request thread touches the brigade. */
+
+/* svndiff streams start with a 4 byte signature ("SVN" + version). */
+#define SVNDIFF_HEADER_SIZE 4
+
+/* What an output_item_t contains. */
+typedef enum output_kind_t
+{
+  /* Literal XML text. */
+  output_kind_text,
+
+  /* A text delta window to be sent in svndiff format. */
+  output_kind_window,
+
+  /* The end of a text delta.  Close the base64 encoder. */
+  output_kind_close
+} output_kind_t;
+
+/* An item in the ordered output queue of an output_pipeline_t. */
+typedef struct output_item_t
+{
+  /* The next item in output order. */
+  struct output_item_t *next;
+
+  output_kind_t kind;
+
+  /* The text to send or the encoded svndiff data.  For windows, only
+     valid after JOB has finished. */
+  svn_stringbuf_t *data;
+
+  /* The window to encode.  NULL for the end of an empty text delta. */
+  svn_txdelta_window_t *window;
+
+  /* Whether DATA shall start with the svndiff header. */
+  svn_boolean_t keep_header;
+
+  /* Encoder for the svndiff data of windows and close items. */
+  svn_stream_t *base64;
+
+  /* The pipeline that the window belongs to and the encode_job() that
+     fills DATA. */
+  struct output_pipeline_t *pipeline;
+  svn_worker_pool__job_t *job;
+
+  /* Owns this item.  For windows, this is a root pool that the worker
+     threads may allocate from. */
+  apr_pool_t *pool;
+} output_item_t;
+
+/* The queue and worker threads through which all output of an update
+   report passes in parallel encoding mode.  */
+typedef struct output_pipeline_t
+{
+  /* Pool for text items and base64 encoders.  Request thread only. */
+  apr_pool_t *pool;
+
+  /* The output queue in send order.  Request thread only. */
+  output_item_t *head;
+  output_item_t *tail;
+
+  /* Number of window items in the output queue and the limit up to
+     which we keep queueing without waiting for the workers. */
+  int pending;
+  int capacity;
+
+  /* Parameters for svn_txdelta_to_svndiff3(). */
+  int svndiff_version;
+  int compression_level;
+
+  /* Encodes the windows. */
+  svn_worker_pool__t *workers;
+
+  /* Owns WORKERS. */
+  apr_pool_t *workers_pool;
+} output_pipeline_t;
+
+/* Implements svn_worker_pool__func_t.  BATON is the output_item_t.
+   Encode its window into its DATA using the svndiff parameters of its
+   pipeline. */
+static svn_error_t *
+encode_job(void *baton,
+           apr_pool_t *scratch_pool)
+{
+  output_item_t *item = baton;
+  output_pipeline_t *p = item->pipeline;
+  svn_txdelta_window_handler_t handler;
+  void *handler_baton;
+
+  item->data = svn_stringbuf_create_empty(item->pool);
+  svn_txdelta_to_svndiff3(&handler, &handler_baton,
+                          svn_stream_from_stringbuf(item->data, item->pool),
+                          p->svndiff_version, p->compression_level,
+                          item->pool);
+  SVN_ERR(handler(item->window, handler_baton));
+
+  /* Each window got its own svndiff stream but only the first one of
+     each text delta may have a header. */
+  if (!item->keep_header)
+    svn_stringbuf_leftchop(item->data, SVNDIFF_HEADER_SIZE);
+
+  return SVN_NO_ERROR;
+}
+
+/* Stop the workers of P and release all items that have not been
+   sent. */
+static void
+pipeline_stop(output_pipeline_t *p)
+{
+  output_item_t *item, *next;
+
+  /* Waits for the running jobs to return. */
+  svn_pool_destroy(p->workers_pool);
+
+  /* Window items are root pools, everything else lives in P->POOL. */
+  for (item = p->head; item; item = next)
+    {
+      next = item->next;
+      if (item->kind == output_kind_window)
+        svn_pool_destroy(item->pool);
+    }
+
+  svn_pool_destroy(p->pool);
+}
+
+/* Start a pipeline with THREADS workers, encoding to svndiff format
+   SVNDIFF_VERSION at COMPRESSION_LEVEL, and return it in *PIPELINE.
+   Set *PIPELINE to NULL if no worker could be started.  Allocate it in
+   POOL. */
+static svn_error_t *
+pipeline_start(output_pipeline_t **pipeline,
+               int threads,
+               int svndiff_version,
+               int compression_level,
+               apr_pool_t *pool)
+{
+  output_pipeline_t *p = apr_pcalloc(pool, sizeof(*p));
+
+  p->workers_pool = svn_pool_create(pool);
+  SVN_ERR(svn_worker_pool__create(&p->workers, threads, p->workers_pool));
+  if (!p->workers)
+    {
+      svn_pool_destroy(p->workers_pool);
+      *pipeline = NULL;
+      return SVN_NO_ERROR;
+    }
+
+  p->pool = svn_pool_create(pool);
+  p->svndiff_version = svndiff_version;
+  p->compression_level = compression_level;
+
+  /* Keep all workers busy while the request thread waits for the
+     oldest window. */
+  p->capacity = 2 * svn_worker_pool__thread_count(p->workers);
+
+  *pipeline = p;
+
+  return SVN_NO_ERROR;
+}
+
+/* Append ITEM to the output queue of P. */
+static void
+pipeline_append(output_pipeline_t *p,
+                output_item_t *item)
+{
+  if (p->tail)
+    p->tail->next = item;
+  else
+    p->head = item;
+
+  p->tail = item;
+}
+
+/* Send all items at the head of the output queue of P that are ready to
+   BB and OUTPUT.  If ALL is set, wait for the workers until the queue is
+   empty.  Otherwise, wait only while the queue contains more windows
+   than its capacity. */
+static svn_error_t *
+pipeline_flush(output_pipeline_t *p,
+               apr_bucket_brigade *bb,
+               dav_svn__output *output,
+               svn_boolean_t all)
+{
+  while (p->head)
+    {
+      output_item_t *item = p->head;
+
+      if (item->kind == output_kind_window)
+        {
+          svn_boolean_t done = TRUE;
+          apr_size_t len;
+
+          if (!all && p->pending < p->capacity)
+            SVN_ERR(svn_worker_pool__is_done(&done, item->job));
+
+          if (!done)
+            break;
+
+          SVN_ERR(svn_worker_pool__wait(item->job));
+
+          len = item->data->len;
+          SVN_ERR(svn_stream_write(item->base64, item->data->data, &len));
+          p->pending--;
+        }
+      else if (item->kind == output_kind_text)
+        {
+          SVN_ERR(dav_svn__brigade_write(bb, output, item->data->data,
+                                         item->data->len));
+        }
+      else
+        {
+          /* This also releases the encoder. */
+          SVN_ERR(svn_stream_close(item->base64));
+        }
+
+      p->head = item->next;
+      if (!p->head)
+        p->tail = NULL;
+
+      svn_pool_destroy(item->pool);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Queue a copy of WINDOW, to be sent through BASE64, in P.  If
+   KEEP_HEADER is set, send the svndiff header as well. */
+static svn_error_t *
+pipeline_queue_window(output_pipeline_t *p,
+                      apr_bucket_brigade *bb,
+                      dav_svn__output *output,
+                      svn_txdelta_window_t *window,
+                      svn_boolean_t keep_header,
+                      svn_stream_t *base64)
+{
+  apr_pool_t *pool
+    = apr_allocator_owner_get(svn_pool_create_allocator(FALSE));
+  output_item_t *item = apr_pcalloc(pool, sizeof(*item));
+  svn_error_t *err;
+
+  item->kind = output_kind_window;
+  item->pool = pool;
+  item->window = window ? svn_txdelta_window_dup(window, pool) : NULL;
+  item->keep_header = keep_header;
+  item->base64 = base64;
+  item->pipeline = p;
+
+  err = svn_worker_pool__post(&item->job, p->workers, encode_job, item,
+                              pool);
+  if (err)
+    {
+      svn_pool_destroy(pool);
+      return svn_error_trace(err);
+    }
+
+  pipeline_append(p, item);
+  p->pending++;
+
+  return svn_error_trace(pipeline_flush(p, bb, output, FALSE));
+}
+
+/* Close the BASE64 encoder, which may still be referenced by queued
+   windows in P, and release POOL afterwards.  POOL must be a sub-pool of
+   P->POOL that contains BASE64 and nothing else still in use. */
+static svn_error_t *
+pipeline_queue_close(output_pipeline_t *p,
+                     svn_stream_t *base64,
+                     apr_pool_t *pool)
+{
+  output_item_t *item;
+
+  if (!p->head)
+    {
+      SVN_ERR(svn_stream_close(base64));
+      svn_pool_destroy(pool);
+
+      return SVN_NO_ERROR;
+    }
+
+  item = apr_pcalloc(pool, sizeof(*item));
+  item->kind = output_kind_close;
+  item->pool = pool;
+  item->base64 = base64;
+
+  pipeline_append(p, item);
+
+  return SVN_NO_ERROR;
+}
+
+/* Return the text item at the end of P's output queue to append to.
+   Create a new one if necessary. */
+static svn_stringbuf_t *
+pipeline_tail_text(output_pipeline_t *p)
+{
+  output_item_t *item = p->tail;
+
+  if (item->kind != output_kind_text)
+    {
+      apr_pool_t *pool = svn_pool_create(p->pool);
+
+      item = apr_pcalloc(pool, sizeof(*item));
+      item->kind = output_kind_text;
+      item->pool = pool;
+      item->data = svn_stringbuf_create_empty(pool);
+
+      pipeline_append(p, item);
+    }
+
+  return item->data;
+}
+
+/* Send STR to the response of UC, behind any output still queued. */
+static svn_error_t *
+send_puts(update_ctx_t *uc,
+          const char *str)
+{
+  if (uc->pipeline && uc->pipeline->head)
+    {
+      svn_stringbuf_appendcstr(pipeline_tail_text(uc->pipeline), str);
+      return SVN_NO_ERROR;
+    }
+
+  return svn_error_trace(dav_svn__brigade_puts(uc->bb, uc->output, str));
+}
+
+/* Like send_puts() but format the text using FMT. */
+static svn_error_t *
+send_printf(update_ctx_t *uc,
+            const char *fmt,
+            ...)
+{
+  svn_error_t *err;
+  va_list ap;
+
+  va_start(ap, fmt);
+  if (uc->pipeline && uc->pipeline->head)
+    {
+      svn_stringbuf_t *text = pipeline_tail_text(uc->pipeline);
+      svn_stringbuf_appendcstr(text, apr_pvsprintf(text->pool, fmt, ap));
+      err = SVN_NO_ERROR;
+    }
+  else
+    err = dav_svn__brigade_vprintf(uc->bb, uc->output, fmt, ap);
+  va_end(ap);
+
+  return svn_error_trace(err);
+}
+
+
 /* add PATH to the pathmap HASH with a repository path of LINKPATH.
    if LINKPATH is NULL, PATH will map to itself. */
 static void
@@ -262,10 +623,9 @@ send_vsn_url(item_baton_t *baton, apr_pool_t *pool)
                                 revision, path, FALSE /* add_href */, pool);
     }
 
-  return dav_svn__brigade_printf(baton->uc->bb, baton->uc->output,
-                                 "<D:checked-in><D:href>%s</D:href>"
-                                 "</D:checked-in>" DEBUG_CR,
-                                 apr_xml_quote_string(pool, href, 1));
+  return send_printf(baton->uc, "<D:checked-in><D:href>%s</D:href>"
+                     "</D:checked-in>" DEBUG_CR,
+                     apr_xml_quote_string(pool, href, 1));
 }
 
 
@@ -279,9 +639,8 @@ absent_helper(svn_boolean_t is_dir,
 
   if (! uc->resource_walk)
     {
-      SVN_ERR(dav_svn__brigade_printf
-              (uc->bb, uc->output,
-               "<S:absent-%s name=\"%s\"/>" DEBUG_CR,
+      SVN_ERR(send_printf
+              (uc, "<S:absent-%s name=\"%s\"/>" DEBUG_CR,
                DIR_OR_FILE(is_dir),
                apr_xml_quote_string(pool,
                                     svn_relpath_basename(path, NULL),
@@ -323,10 +682,8 @@ add_helper(svn_boolean_t is_dir,
 
   if (uc->resource_walk)
     {
-      SVN_ERR(dav_svn__brigade_printf(child->uc->bb, child->uc->output,
-                                      "<S:resource path=\"%s\">" DEBUG_CR,
-                                      apr_xml_quote_string(pool, child->path3,
-                                                           1)));
+      SVN_ERR(send_printf(child->uc, "<S:resource path=\"%s\">" DEBUG_CR,
+                          apr_xml_quote_string(pool, child->path3, 1)));
     }
   else
     {
@@ -403,14 +760,13 @@ add_helper(svn_boolean_t is_dir,
          placeholders.  For example, "this%20dir" is a valid printf()
          format string that means "this[insert an integer of width 20
          here]ir". */
-      SVN_ERR(dav_svn__brigade_puts(child->uc->bb, child->uc->output, elt));
+      SVN_ERR(send_puts(child->uc, elt));
     }
 
   SVN_ERR(send_vsn_url(child, pool));
 
   if (uc->resource_walk)
-    SVN_ERR(dav_svn__brigade_puts(child->uc->bb, child->uc->output,
-                                  "</S:resource>" DEBUG_CR));
+    SVN_ERR(send_puts(child->uc, "</S:resource>" DEBUG_CR));
 
   *child_baton = child;
 
@@ -429,10 +785,9 @@ open_helper(svn_boolean_t is_dir,
   item_baton_t *child = make_child_baton(parent, path, pool);
   const char *qname = apr_xml_quote_string(pool, child->name, 1);
 
-  SVN_ERR(dav_svn__brigade_printf(child->uc->bb, child->uc->output,
-                                  "<S:open-%s name=\"%s\""
-                                  " rev=\"%ld\">" DEBUG_CR,
-                                  DIR_OR_FILE(is_dir), qname, base_revision));
+  SVN_ERR(send_printf(child->uc, "<S:open-%s name=\"%s\""
+                      " rev=\"%ld\">" DEBUG_CR,
+                      DIR_OR_FILE(is_dir), qname, base_revision));
   SVN_ERR(send_vsn_url(child, pool));
   *child_baton = child;
   return SVN_NO_ERROR;
@@ -456,21 +811,18 @@ close_helper(svn_boolean_t is_dir, item_baton_t *baton, apr_pool_t *pool)
         {
           qname = APR_ARRAY_IDX(baton->removed_props, i, const char *);
           qname = apr_xml_quote_string(pool, qname, 1);
-          SVN_ERR(dav_svn__brigade_printf(baton->uc->bb, baton->uc->output,
-                                          "<S:remove-prop name=\"%s\"/>"
-                                          DEBUG_CR, qname));
+          SVN_ERR(send_printf(baton->uc, "<S:remove-prop name=\"%s\"/>"
+                              DEBUG_CR, qname));
         }
     }
 
   /* Let's tie it off, nurse. */
   if (baton->added)
-    SVN_ERR(dav_svn__brigade_printf(baton->uc->bb, baton->uc->output,
-                                    "</S:add-%s>" DEBUG_CR,
-                                    DIR_OR_FILE(is_dir)));
+    SVN_ERR(send_printf(baton->uc, "</S:add-%s>" DEBUG_CR,
+                        DIR_OR_FILE(is_dir)));
   else
-    SVN_ERR(dav_svn__brigade_printf(baton->uc->bb, baton->uc->output,
-                                    "</S:open-%s>" DEBUG_CR,
-                                    DIR_OR_FILE(is_dir)));
+    SVN_ERR(send_printf(baton->uc, "</S:open-%s>" DEBUG_CR,
+                        DIR_OR_FILE(is_dir)));
   return SVN_NO_ERROR;
 }
 
@@ -482,8 +834,8 @@ maybe_start_update_report(update_ctx_t *uc)
 {
   if ((! uc->resource_walk) && (! uc->started_update))
     {
-      SVN_ERR(dav_svn__brigade_printf(
-                  uc->bb, uc->output,
+      SVN_ERR(send_printf(
+                  uc,
                   DAV_XML_HEADER DEBUG_CR "<S:update-report xmlns:S=\""
                   SVN_XML_NAMESPACE "\" xmlns:V=\"" SVN_DAV_PROP_NS_DAV "\" "
                   "xmlns:D=\"DAV:\" %s %s>" DEBUG_CR,
@@ -507,9 +859,8 @@ upd_set_target_revision(void *edit_baton,
   SVN_ERR(maybe_start_update_report(uc));
 
   if (! uc->resource_walk)
-    SVN_ERR(dav_svn__brigade_printf(uc->bb, uc->output,
-                                    "<S:target-revision rev=\"%ld\"/>"
-                                    DEBUG_CR, target_revision));
+    SVN_ERR(send_printf(uc, "<S:target-revision rev=\"%ld\"/>"
+                        DEBUG_CR, target_revision));
 
   return SVN_NO_ERROR;
 }
@@ -538,13 +889,11 @@ upd_open_root(void *edit_baton,
   SVN_ERR(maybe_start_update_report(uc));
 
   if (uc->resource_walk)
-    SVN_ERR(dav_svn__brigade_printf(uc->bb, uc->output,
-                                    "<S:resource path=\"%s\">" DEBUG_CR,
-                                    apr_xml_quote_string(pool, b->path3, 1)));
+    SVN_ERR(send_printf(uc, "<S:resource path=\"%s\">" DEBUG_CR,
+                        apr_xml_quote_string(pool, b->path3, 1)));
   else
-    SVN_ERR(dav_svn__brigade_printf(uc->bb, uc->output,
-                                    "<S:open-directory rev=\"%ld\">" DEBUG_CR,
-                                    base_revision));
+    SVN_ERR(send_printf(uc, "<S:open-directory rev=\"%ld\">" DEBUG_CR,
+                        base_revision));
 
   /* Only transmit the root directory's Version Resource URL if
      there's no target. */
@@ -552,8 +901,7 @@ upd_open_root(void *edit_baton,
     SVN_ERR(send_vsn_url(b, pool));
 
   if (uc->resource_walk)
-    SVN_ERR(dav_svn__brigade_puts(uc->bb, uc->output,
-                                  "</S:resource>" DEBUG_CR));
+    SVN_ERR(send_puts(uc, "</S:resource>" DEBUG_CR));
 
   return SVN_NO_ERROR;
 }
@@ -569,9 +917,8 @@ upd_delete_entry(const char *path,
   const char *qname = apr_xml_quote_string(pool,
                                            svn_relpath_basename(path, NULL),
                                            1);
-  return dav_svn__brigade_printf(parent->uc->bb, parent->uc->output,
-                                 "<S:delete-entry name=\"%s\" rev=\"%ld\"/>"
-                                   DEBUG_CR, qname, revision);
+  return send_printf(parent->uc, "<S:delete-entry name=\"%s\" rev=\"%ld\"/>"
+                     DEBUG_CR, qname, revision);
 }
 
 
@@ -621,29 +968,25 @@ send_propchange(item_baton_t *b,
           svn_stringbuf_t *tmp = NULL;
           svn_xml_escape_cdata_string(&tmp, value, pool);
           qval = tmp->data;
-          SVN_ERR(dav_svn__brigade_printf(b->uc->bb, b->uc->output,
-                                          "<S:set-prop name=\"%s\">",
-                                          qname));
+          SVN_ERR(send_printf(b->uc, "<S:set-prop name=\"%s\">",
+                              qname));
         }
       else
         {
           qval = svn_base64_encode_string2(value, TRUE, pool)->data;
-          SVN_ERR(dav_svn__brigade_printf(b->uc->bb, b->uc->output,
-                                          "<S:set-prop name=\"%s\" "
-                                          "encoding=\"base64\">" DEBUG_CR,
-                                          qname));
+          SVN_ERR(send_printf(b->uc, "<S:set-prop name=\"%s\" "
+                              "encoding=\"base64\">" DEBUG_CR,
+                              qname));
         }
 
-      SVN_ERR(dav_svn__brigade_puts(b->uc->bb, b->uc->output, qval));
-      SVN_ERR(dav_svn__brigade_puts(b->uc->bb, b->uc->output,
-                                    "</S:set-prop>" DEBUG_CR));
+      SVN_ERR(send_puts(b->uc, qval));
+      SVN_ERR(send_puts(b->uc, "</S:set-prop>" DEBUG_CR));
     }
   else  /* value is null, so this is a prop removal */
     {
-      SVN_ERR(dav_svn__brigade_printf(b->uc->bb, b->uc->output,
-                                      "<S:remove-prop name=\"%s\"/>"
-                                      DEBUG_CR,
-                                      qname));
+      SVN_ERR(send_printf(b->uc, "<S:remove-prop name=\"%s\"/>"
+                          DEBUG_CR,
+                          qname));
     }
 
   return SVN_NO_ERROR;
@@ -749,10 +1092,52 @@ upd_open_file(const char *path,
 }
 
 
-/* We have our own window handler and baton as a simple wrapper around
-   the real handler (which converts txdelta windows to base64-encoded
-   svndiff data).  The wrapper is responsible for sending the opening
-   and closing XML tags around the svndiff data. */
+/* Send the opening S:txdelta tag for a text delta against a base with
+   BASE_CHECKSUM (may be NULL) to UC. */
+static svn_error_t *
+send_txdelta_open_tag(update_ctx_t *uc,
+                      const char *base_checksum)
+{
+  if (!base_checksum)
+    return svn_error_trace(send_puts(uc, "<S:txdelta>"));
+
+  return svn_error_trace(send_printf(uc, "<S:txdelta base-checksum=\"%s\">",
+                                     base_checksum));
+}
+
+/* Baton for the output stream of svndiff encoders.  It feeds the base64
+   encoder and sends the closing XML tag once the svndiff stream is
+   complete. */
+struct txdelta_stream_baton
+{
+  update_ctx_t *uc;
+  svn_stream_t *base64;
+};
+
+/* Implements svn_write_fn_t. */
+static svn_error_t *
+txdelta_stream_write(void *baton,
+                     const char *data,
+                     apr_size_t *len)
+{
+  struct txdelta_stream_baton *sb = baton;
+  return svn_error_trace(svn_stream_write(sb->base64, data, len));
+}
+
+/* Implements svn_close_fn_t. */
+static svn_error_t *
+txdelta_stream_close(void *baton)
+{
+  struct txdelta_stream_baton *sb = baton;
+
+  SVN_ERR(svn_stream_close(sb->base64));
+  return svn_error_trace(send_puts(sb->uc, "</S:txdelta>"));
+}
+
+/* In parallel encoding mode, we have our own window handler and baton,
+   which queue the windows for the encoder threads.  The handler is also
+   responsible for sending the opening and closing XML tags around the
+   svndiff data. */
 struct window_handler_baton
 {
   svn_boolean_t seen_first_window;  /* False until first window seen. */
@@ -760,9 +1145,10 @@ struct window_handler_baton
 
   const char *base_checksum; /* For transfer as part of the S:txdelta element */
 
-  /* The _real_ window handler and baton. */
-  svn_txdelta_window_handler_t handler;
-  void *handler_baton;
+  /* The encoded windows get sent through BASE64, allocated in
+     STREAM_POOL.  Both live until the last queued window has been sent. */
+  svn_stream_t *base64;
+  apr_pool_t *stream_pool;
 };
 
 
@@ -771,26 +1157,25 @@ static svn_error_t *
 window_handler(svn_txdelta_window_t *window, void *baton)
 {
   struct window_handler_baton *wb = baton;
+  update_ctx_t *uc = wb->uc;
+  svn_boolean_t first_window = ! wb->seen_first_window;
 
-  if (! wb->seen_first_window)
+  if (first_window)
     {
       wb->seen_first_window = TRUE;
-
-      if (!wb->base_checksum)
-        SVN_ERR(dav_svn__brigade_puts(wb->uc->bb, wb->uc->output,
-                                      "<S:txdelta>"));
-      else
-        SVN_ERR(dav_svn__brigade_printf(wb->uc->bb, wb->uc->output,
-                                        "<S:txdelta base-checksum=\"%s\">",
-                                        wb->base_checksum));
+      SVN_ERR(send_txdelta_open_tag(uc, wb->base_checksum));
     }
 
-  SVN_ERR(wb->handler(window, wb->handler_baton));
+  /* Even an empty delta needs the svndiff header. */
+  if (window || first_window)
+    SVN_ERR(pipeline_queue_window(uc->pipeline, uc->bb, uc->output,
+                                  window, first_window, wb->base64));
 
   if (window == NULL)
     {
-      SVN_ERR(dav_svn__brigade_puts(wb->uc->bb, wb->uc->output,
-                                    "</S:txdelta>"));
+      SVN_ERR(pipeline_queue_close(uc->pipeline, wb->base64,
+                                   wb->stream_pool));
+      SVN_ERR(send_puts(uc, "</S:txdelta>"));
     }
 
   return SVN_NO_ERROR;
@@ -804,8 +1189,8 @@ upd_apply_textdelta(void *file_baton,
                     void **handler_baton)
 {
   item_baton_t *file = file_baton;
-  struct window_handler_baton *wb;
-  svn_stream_t *base64_stream;
+  struct txdelta_stream_baton *sb;
+  svn_stream_t *svndiff_stream;
 
   /* Store the base checksum and the fact the file's text changed. */
   file->base_checksum = apr_pstrdup(file->pool, base_checksum);
@@ -820,20 +1205,41 @@ upd_apply_textdelta(void *file_baton,
       return SVN_NO_ERROR;
     }
 
-  wb = apr_palloc(file->pool, sizeof(*wb));
-  wb->seen_first_window = FALSE;
-  wb->uc = file->uc;
-  wb->base_checksum = file->base_checksum;
-  base64_stream = dav_svn__make_base64_output_stream(wb->uc->bb,
-                                                     wb->uc->output,
-                                                     file->pool);
+  if (file->uc->pipeline)
+    {
+      struct window_handler_baton *wb = apr_palloc(file->pool, sizeof(*wb));
+      wb->seen_first_window = FALSE;
+      wb->uc = file->uc;
+      wb->base_checksum = file->base_checksum;
+
+      /* The file baton may be gone before the encoded windows get sent. */
+      wb->stream_pool = svn_pool_create(wb->uc->pipeline->pool);
+      wb->base64 = dav_svn__make_base64_output_stream(wb->uc->bb,
+                                                      wb->uc->output,
+                                                      wb->stream_pool);
+      *handler = window_handler;
+      *handler_baton = wb;
 
-  svn_txdelta_to_svndiff3(&(wb->handler), &(wb->handler_baton),
-                          base64_stream, file->uc->svndiff_version,
-                          file->uc->compression_level, file->pool);
+      return SVN_NO_ERROR;
+    }
 
-  *handler = window_handler;
-  *handler_baton = wb;
+  /* Hand out the svndiff encoder itself, such that svndiff windows
+     stored in the repository may get forwarded verbatim.  Therefore,
+     start the S:txdelta element right away. */
+  SVN_ERR(send_txdelta_open_tag(file->uc, file->base_checksum));
+
+  sb = apr_palloc(file->pool, sizeof(*sb));
+  sb->uc = file->uc;
+  sb->base64 = dav_svn__make_base64_output_stream(file->uc->bb,
+                                                  file->uc->output,
+                                                  file->pool);
+  svndiff_stream = svn_stream_create(sb, file->pool);
+  svn_stream_set_write(svndiff_stream, txdelta_stream_write);
+  svn_stream_set_close(svndiff_stream, txdelta_stream_close);
+
+  svn_txdelta_to_svndiff3(handler, handler_baton,
+                          svndiff_stream, file->uc->svndiff_version,
+                          file->uc->compression_level, file->pool);
 
   return SVN_NO_ERROR;
 }
@@ -860,9 +1266,8 @@ upd_close_file(void *file_baton, const char *text_checksum, apr_pool_t *pool)
       if (sha1_checksum)
         sha1_digest = svn_checksum_to_cstring(sha1_checksum, pool);
 
-      SVN_ERR(dav_svn__brigade_printf
-              (file->uc->bb, file->uc->output,
-               "<S:fetch-file%s%s%s%s%s%s/>" DEBUG_CR,
+      SVN_ERR(send_printf
+              (file->uc, "<S:fetch-file%s%s%s%s%s%s/>" DEBUG_CR,
                file->base_checksum ? " base-checksum=\"" : "",
                file->base_checksum ? file->base_checksum : "",
                file->base_checksum ? "\"" : "",
@@ -873,11 +1278,10 @@ upd_close_file(void *file_baton, const char *text_checksum, apr_pool_t *pool)
 
   if (text_checksum)
     {
-      SVN_ERR(dav_svn__brigade_printf(file->uc->bb, file->uc->output,
-                                      "<S:prop>"
-                                      "<V:md5-checksum>%s</V:md5-checksum>"
-                                      "</S:prop>",
-                                      text_checksum));
+      SVN_ERR(send_printf(file->uc, "<S:prop>"
+                          "<V:md5-checksum>%s</V:md5-checksum>"
+                          "</S:prop>",
+                          text_checksum));
     }
 
   return close_helper(FALSE /* is_dir */, file, pool);
@@ -891,7 +1295,13 @@ upd_close_edit(void *edit_baton, apr_pool_t *pool)
 
   /* Our driver will unconditionally close the update report... So if
      the report hasn't even been started yet, start it now. */
-  return maybe_start_update_report(uc);
+  SVN_ERR(maybe_start_update_report(uc));
+
+  /* Anything after this point gets written straight to the brigade. */
+  if (uc->pipeline)
+    SVN_ERR(pipeline_flush(uc->pipeline, uc->bb, uc->output, TRUE));
+
+  return SVN_NO_ERROR;
 }
 
 
@@ -915,7 +1325,10 @@ malformed_element_error(const char *tagname, apr_pool_t *pool)
    the related contexts that just means "the youngest revision".)
 
    REVTYPE is just a string describing the type/purpose of REVISION,
-   used in the generated error string.  */
+   used in the generated error string.
+
+   If this is a slave server, give it some time to receive REVISION from
+   the master first (see SVNMasterSyncWait).  */
 static dav_error *
 validate_input_revision(svn_revnum_t revision,
                         svn_revnum_t youngest,
@@ -925,6 +1338,21 @@ validate_input_revision(svn_revnum_t revision,
   if (! SVN_IS_VALID_REVNUM(revision))
     return NULL;
 
+  if (revision > youngest && dav_svn__get_master_uri(resource->info->r))
+    {
+      /* The client may have got REVISION from the master just now. */
+      svn_error_t *serr = dav_svn__mirror_wait_for_rev(&youngest,
+                                                       resource->info->repos,
+                                                       resource->info->r,
+                                                       revision,
+                                                       resource->pool);
+      if (serr)
+        return dav_svn__convert_err(serr, HTTP_INTERNAL_SERVER_ERROR,
+                                    "Could not determine the youngest "
+                                    "revision for the update process.",
+                                    resource->pool);
+    }
+
   if (revision > youngest)
     {
       svn_error_t *serr;
@@ -950,6 +1378,38 @@ validate_input_revision(svn_revnum_t revision,
   return NULL;
 }
 
+/* Return the checkout bundle key for the response UC will produce when
+   checking out REVNUM of UC->ANCHOR / UC->TARGET, whose working copy got
+   reported as one empty directory at ENTRY_REV with ENTRY_DEPTH.  The
+   other parameters are those of svn_repos_begin_report3().  Allocate the
+   result in POOL. */
+static const char *
+make_bundle_key(const update_ctx_t *uc,
+                svn_revnum_t revnum,
+                svn_revnum_t entry_rev,
+                svn_depth_t entry_depth,
+                svn_boolean_t text_deltas,
+                svn_depth_t requested_depth,
+                svn_boolean_t ignore_ancestry,
+                svn_boolean_t send_copyfrom_args,
+                apr_pool_t *pool)
+{
+  const dav_resource *resource = uc->resource;
+
+  return apr_psprintf(pool,
+                      "%s\n%s\n%ld\n%s\n%s\n%ld\n%s\n%s\n"
+                      "%d%d%d%d%d%d %d %d",
+                      resource->info->repos->fs_path,
+                      resource->info->repos->root_path,
+                      revnum, uc->anchor, uc->target,
+                      entry_rev, svn_depth_to_word(entry_depth),
+                      svn_depth_to_word(requested_depth),
+                      uc->send_all, uc->include_props, text_deltas,
+                      ignore_ancestry, send_copyfrom_args,
+                      uc->enable_v2_response,
+                      uc->svndiff_version, uc->compression_level);
+}
+
 
 dav_error *
 dav_svn__update_report(const dav_resource *resource,
@@ -966,6 +1426,11 @@ dav_svn__update_report(const dav_resource *resource,
   /* entry_counter and entry_is_empty are for operational logging. */
   int entry_counter = 0;
   svn_boolean_t entry_is_empty = FALSE;
+  /* Only the reports of plain checkouts qualify for checkout bundles. */
+  svn_boolean_t bundle_eligible = TRUE;
+  svn_revnum_t bundle_rev = SVN_INVALID_REVNUM;
+  svn_depth_t bundle_depth = svn_depth_unknown;
+  dav_svn__bundle_t *bundle = NULL;
   svn_error_t *serr;
   dav_error *derr = NULL;
   const char *src_path = NULL;
@@ -1216,7 +1681,7 @@ dav_svn__update_report(const dav_resource *resource,
              telescoping dst_path be. */
           uc.dst_path = svn_fspath__dirname(dst_path, resource->pool);
 
-          /* Also, the svn_repos_dir_delta2() is going to preserve our
+          /* Also, the svn_repos_dir_delta3() is going to preserve our
              target's name, so we need a pathmap entry for that. */
           if (! uc.pathmap)
             uc.pathmap = apr_hash_make(resource->pool);
@@ -1352,6 +1817,11 @@ dav_svn__update_report(const dav_resource *resource,
             if (strcmp(path, "") == 0)
               from_revnum = rev;
 
+            if (*path || linkpath || locktoken || ! start_empty)
+              bundle_eligible = FALSE;
+            bundle_rev = rev;
+            bundle_depth = depth;
+
             if (! linkpath)
               serr = svn_repos_set_path3(rbaton, path, rev, depth,
                                          start_empty, locktoken, subpool);
@@ -1384,6 +1854,7 @@ dav_svn__update_report(const dav_resource *resource,
           {
             /* get cdata, stripping whitespace */
             const char *path = dav_xml_get_cdata(child, subpool, 0);
+            bundle_eligible = FALSE;
             serr = svn_repos_delete_path(rbaton, path, subpool);
             if (serr != NULL)
               {
@@ -1407,7 +1878,7 @@ dav_svn__update_report(const dav_resource *resource,
     else
       spath = src_path;
 
-    /* If a second path was passed to svn_repos_dir_delta2(), then it
+    /* If a second path was passed to svn_repos_dir_delta3(), then it
        must have been switch, diff, or merge.  */
     if (dst_path)
       {
@@ -1444,6 +1915,59 @@ dav_svn__update_report(const dav_resource *resource,
     dav_svn__operational_log(resource->info, action);
   }
 
+  /* Serve repeated checkouts from the bundle cache, or record the
+     response we are about to send into it.  Path-based authz may filter
+     the response differently for each request, e.g. after the rules got
+     changed, and nothing in the key could tell us about that. */
+  if (bundle_eligible && entry_counter == 1 && ! dst_path && ! resource_walk
+      && dav_svn__authz_read_func(&arb) == NULL)
+    {
+      svn_boolean_t sent;
+      const char *key
+        = make_bundle_key(&uc, revnum, bundle_rev, bundle_depth,
+                          text_deltas, requested_depth, ignore_ancestry,
+                          send_copyfrom_args, resource->pool);
+
+      serr = dav_svn__bundle_send(&sent, resource->info->r, key, output,
+                                  resource->pool);
+      if (serr)
+        {
+          derr = dav_svn__convert_err(serr, HTTP_INTERNAL_SERVER_ERROR,
+                                      "Unable to send the checkout bundle",
+                                      resource->pool);
+          goto cleanup;
+        }
+
+      if (sent)
+        {
+          svn_error_clear(svn_repos_abort_report(rbaton, resource->pool));
+          rbaton = NULL;
+          goto cleanup;
+        }
+
+      bundle = dav_svn__bundle_record(resource->info->r, key,
+                                      resource->pool);
+    }
+
+  /* Offload the svndiff encoding if so configured. */
+  if (uc.send_all)
+    {
+      int threads = dav_svn__get_update_encoder_threads(resource->info->r);
+      if (threads > 0)
+        {
+          serr = pipeline_start(&uc.pipeline, threads, uc.svndiff_version,
+                                uc.compression_level, resource->pool);
+          if (serr)
+            {
+              derr = dav_svn__convert_err(serr, HTTP_INTERNAL_SERVER_ERROR,
+                                          "Unable to start the update "
+                                          "encoder threads",
+                                          resource->pool);
+              goto cleanup;
+            }
+        }
+    }
+
   /* this will complete the report, and then drive our editor to generate
      the response to the client. */
   serr = svn_repos_finish_report(rbaton, resource->pool);
@@ -1514,7 +2038,7 @@ dav_svn__update_report(const dav_resource *resource,
       /* Compare subtree DST_PATH within a pristine revision to
          revision 0.  This should result in nothing but 'add' calls
          to the editor. */
-      serr = svn_repos_dir_delta2(zero_root, "", target,
+      serr = svn_repos_dir_delta3(zero_root, "", target,
                                   uc.rev_root, dst_path,
                                   /* re-use the editor */
                                   editor, &uc,
@@ -1523,6 +2047,7 @@ dav_svn__update_report(const dav_resource *resource,
                                   requested_depth,
                                   TRUE /* entryprops */,
                                   FALSE /* ignore-ancestry */,
+                                  1 /* jobs */,
                                   resource->pool);
 
       if (serr)
@@ -1565,9 +2090,17 @@ dav_svn__update_report(const dav_resource *resource,
   if (derr && rbaton)
     svn_error_clear(svn_repos_abort_report(rbaton, resource->pool));
 
+  if (uc.pipeline)
+    pipeline_stop(uc.pipeline);
+
   /* Destroy our subpool. */
   svn_pool_destroy(subpool);
 
-  return dav_svn__final_flush_or_error(resource->info->r, uc.bb, output,
+  derr = dav_svn__final_flush_or_error(resource->info->r, uc.bb, output,
                                        derr, resource->pool);
+
+  /* Keep the bundle only if the client got the complete response. */
+  dav_svn__bundle_finish(bundle, derr == NULL);
+
+  return derr;
 }
@@ -26,6 +26,8 @@
 #include <apr_strings.h>
 #include <apr_hash.h>
 #include <apr_lib.h>
+#include <apr_md5.h>
+#include <apr_sha1.h>
 
 #include <httpd.h>
 #include <http_request.h>
@@ -55,6 +57,7 @@
 #include "svn_dirent_uri.h"
 #include "private/svn_log.h"
 #include "private/svn_fspath.h"
+#include "private/svn_fs_private.h"
 #include "private/svn_repos_private.h"
 #include "private/svn_sorts_private.h"
 
@@ -597,6 +600,125 @@ parse_vtxnroot_uri(dav_resource_combined *comb,
 }
 
 
+/* Return TRUE if the first LEN bytes at DIGEST are lower-case hex digits.
+   Accepting only one spelling of each digest keeps shared caches from
+   storing the same text twice. */
+static svn_boolean_t
+is_hex_digest(const char *digest, apr_size_t len)
+{
+  apr_size_t i;
+
+  for (i = 0; i < len; ++i)
+    if (! svn_ctype_isdigit(digest[i])
+        && (digest[i] < 'a' || digest[i] > 'f'))
+      return FALSE;
+
+  return TRUE;
+}
+
+
+/* Take the location of the text requested through a content-addressed
+   URI from the SVN_DAV_TEXT_LOCATION_HEADER of the request and use it
+   as the revision root and path of COMB.  Return TRUE if that fails. */
+static int
+parse_text_location(dav_resource_combined *comb)
+{
+  dav_svn__uri_info info;
+  svn_error_t *serr;
+  const char *location = apr_table_get(comb->priv.r->headers_in,
+                                       SVN_DAV_TEXT_LOCATION_HEADER);
+
+  /* The response must not depend on anything but the URI.  So there is
+     no room for e.g. keyword expansion. */
+  if (location == NULL || comb->priv.r->parsed_uri.query != NULL
+      || ! dav_svn__get_content_urls_flag(comb->priv.r))
+    return TRUE;
+
+  serr = dav_svn__simple_parse_uri(&info, &comb->res, location,
+                                   comb->res.pool);
+  if (serr != NULL)
+    {
+      svn_error_clear(serr);
+      return TRUE;
+    }
+
+  if (! SVN_IS_VALID_REVNUM(info.rev) || info.repos_path == NULL)
+    return TRUE;
+
+  comb->res.type = DAV_RESOURCE_TYPE_REGULAR;
+  comb->res.versioned = TRUE;
+  comb->priv.root.rev = info.rev;
+  comb->priv.repos_path = info.repos_path;
+
+  return FALSE;
+}
+
+
+static int
+parse_text_uri(dav_resource_combined *comb,
+               const char *path,
+               const char *label,
+               int use_checked_in)
+{
+  /* format: !svn/txt/SHA1
+
+     In HTTP protocol v2, this represents the contents of any file with
+     the given SHA-1 digest.  They are read from the location named in
+     the SVN_DAV_TEXT_LOCATION_HEADER after checking the digest.
+   */
+
+  if (! is_hex_digest(path, APR_SHA1_DIGESTSIZE * 2)
+      || path[APR_SHA1_DIGESTSIZE * 2] != '\0')
+    return TRUE;
+
+  if (parse_text_location(comb))
+    return TRUE;
+
+  /* Always send the fulltext. */
+  comb->priv.delta_base = NULL;
+  comb->priv.text_sha1 = apr_pstrdup(comb->res.pool, path);
+
+  return FALSE;
+}
+
+
+static int
+parse_delta_uri(dav_resource_combined *comb,
+                const char *path,
+                const char *label,
+                int use_checked_in)
+{
+  /* format: !svn/dlt/BASE-MD5/SHA1
+
+     In HTTP protocol v2, this represents an svndiff that turns the
+     file contents with the given MD5 digest into those with the given
+     SHA-1 digest.  They are read from the locations named in the
+     SVN_DAV_DELTA_BASE_HEADER and the SVN_DAV_TEXT_LOCATION_HEADER
+     after checking the digests.
+   */
+
+  const char *sha1;
+
+  if (! is_hex_digest(path, APR_MD5_DIGESTSIZE * 2)
+      || path[APR_MD5_DIGESTSIZE * 2] != '/')
+    return TRUE;
+
+  sha1 = path + APR_MD5_DIGESTSIZE * 2 + 1;
+  if (! is_hex_digest(sha1, APR_SHA1_DIGESTSIZE * 2)
+      || sha1[APR_SHA1_DIGESTSIZE * 2] != '\0')
+    return TRUE;
+
+  if (comb->priv.delta_base == NULL || parse_text_location(comb))
+    return TRUE;
+
+  comb->priv.text_base_md5 = apr_pstrndup(comb->res.pool, path,
+                                          APR_MD5_DIGESTSIZE * 2);
+  comb->priv.text_sha1 = apr_pstrdup(comb->res.pool, sha1);
+
+  return FALSE;
+}
+
+
 static int
 parse_wrk_baseline_uri(dav_resource_combined *comb,
                        const char *path,
@@ -678,6 +800,8 @@ static const struct special_defn
   { "txr", parse_txnroot_uri, 1, TRUE, DAV_SVN_RESTYPE_TXNROOT_COLLECTION},
   { "vtxn", parse_vtxnstub_uri, 1, FALSE, DAV_SVN_RESTYPE_TXN_COLLECTION},
   { "vtxr", parse_vtxnroot_uri, 1, TRUE, DAV_SVN_RESTYPE_TXNROOT_COLLECTION},
+  { "txt", parse_text_uri, 1, FALSE, DAV_SVN_RESTYPE_TEXT_COLLECTION },
+  { "dlt", parse_delta_uri, 2, FALSE, DAV_SVN_RESTYPE_DELTA_COLLECTION },
 
   { NULL } /* sentinel */
 };
@@ -795,6 +919,107 @@ parse_uri(dav_resource_combined *comb,
 }
 
 
+/* Return an error unless the file at PATH in REVISION is readable and
+   its contents have the hex digest DIGEST of kind KIND.  WHAT names the
+   file in error messages.  Use COMB for the repository and the request
+   and POOL for allocations. */
+static dav_error *
+check_text_digest(dav_resource_combined *comb,
+                  svn_fs_root_t *root,
+                  const char *path,
+                  svn_checksum_kind_t kind,
+                  const char *digest,
+                  const char *what,
+                  apr_pool_t *pool)
+{
+  svn_error_t *serr;
+  svn_node_kind_t node_kind;
+  svn_checksum_t *expected, *actual;
+
+  if (! dav_svn__allow_read(comb->priv.r, comb->priv.repos, path,
+                            svn_fs_revision_root_revision(root), pool))
+    return dav_svn__new_error(pool, HTTP_FORBIDDEN, 0, 0,
+                              apr_psprintf(pool, "Access to the %s "
+                                           "location is forbidden", what));
+
+  serr = svn_fs_check_path(&node_kind, root, path, pool);
+  if (serr != NULL)
+    return dav_svn__convert_err(serr, HTTP_INTERNAL_SERVER_ERROR,
+                                "Could not check the text location", pool);
+  if (node_kind != svn_node_file)
+    return dav_svn__new_error(pool, HTTP_NOT_FOUND, 0, 0,
+                              apr_psprintf(pool, "The %s location is not "
+                                           "a file", what));
+
+  serr = svn_checksum_parse_hex(&expected, kind, digest, pool);
+  if (serr == NULL)
+    serr = svn_fs_file_checksum(&actual, kind, root, path, TRUE, pool);
+  if (serr != NULL)
+    return dav_svn__convert_err(serr, HTTP_INTERNAL_SERVER_ERROR,
+                                "Could not determine the checksum", pool);
+
+  if (! svn_checksum_match(expected, actual))
+    return dav_svn__new_error(pool, HTTP_NOT_FOUND, 0, 0,
+                              apr_psprintf(pool, "The %s location does not "
+                                           "contain the requested text",
+                                           what));
+
+  return NULL;
+}
+
+
+/* Verify that the location of the content-addressed resource COMB and,
+   if it is a delta, its delta base match the digests in the URI. */
+static dav_error *
+check_text_address(dav_resource_combined *comb)
+{
+  apr_pool_t *pool = comb->res.pool;
+  dav_error *derr;
+
+  if (comb->priv.r->method_number != M_GET)
+    return dav_svn__new_error(pool, HTTP_METHOD_NOT_ALLOWED, 0, 0,
+                              "Content-addressed texts can only be "
+                              "fetched");
+
+  derr = check_text_digest(comb, comb->priv.root.root, comb->priv.repos_path,
+                           svn_checksum_sha1, comb->priv.text_sha1, "text",
+                           pool);
+  if (derr != NULL)
+    return derr;
+
+  if (comb->priv.text_base_md5)
+    {
+      dav_svn__uri_info info;
+      svn_fs_root_t *base_root;
+      svn_error_t *serr;
+
+      serr = dav_svn__simple_parse_uri(&info, &comb->res,
+                                       comb->priv.delta_base, pool);
+      if (serr == NULL && ! SVN_IS_VALID_REVNUM(info.rev))
+        serr = svn_error_create(SVN_ERR_APMOD_MALFORMED_URI, NULL,
+                                "The delta base has no revision");
+      if (serr != NULL)
+        return dav_svn__convert_err(serr, HTTP_BAD_REQUEST,
+                                    "Could not parse the delta base", pool);
+
+      serr = svn_fs_revision_root(&base_root, comb->priv.repos->fs,
+                                  info.rev, pool);
+      if (serr != NULL)
+        return dav_svn__convert_err(serr, HTTP_NOT_FOUND,
+                                    "Could not open a root for the base",
+                                    pool);
+
+      derr = check_text_digest(comb, base_root, info.repos_path,
+                               svn_checksum_md5, comb->priv.text_base_md5,
+                               "delta base", pool);
+      if (derr != NULL)
+        return derr;
+    }
+
+  return NULL;
+}
+
+
 static dav_error *
 prep_regular(dav_resource_combined *comb)
 {
@@ -862,6 +1087,9 @@ prep_regular(dav_resource_combined *comb)
   if (! comb->res.exists)
     comb->priv.r->path_info = (char *) "";
 
+  if (comb->priv.text_sha1)
+    return check_text_address(comb);
+
   return NULL;
 }
 
@@ -1741,7 +1969,9 @@ static int sort_encoding_pref(const void *accept_rec1, const void *accept_rec2)
 
 static int get_svndiff_version(const struct accept_rec *rec)
 {
-  if (strcmp(rec->name, "svndiff2") == 0)
+  if (strcmp(rec->name, "svndiff3") == 0)
+    return 3;
+  else if (strcmp(rec->name, "svndiff2") == 0)
     return 2;
   else if (strcmp(rec->name, "svndiff1") == 0)
     return 1;
@@ -2488,6 +2718,42 @@ get_resource(request_rec *r,
   /* capture warnings during cleanup of the FS */
   svn_fs_set_warning_func(repos->fs, log_warning, r);
 
+  /* a slave should show clients at least what they just committed */
+  serr = dav_svn__mirror_catch_up(repos, r, r->pool);
+  if (serr)
+    return dav_svn__sanitize_error(serr, "Could not wait for the slave "
+                                   "to synchronize with the master",
+                                   HTTP_INTERNAL_SERVER_ERROR, r);
+
+  /* trace the FS I/O of this request, unless already done for an earlier
+     resource of the same request */
+  if (dav_svn__get_trace_io_flag(r))
+    {
+      void *data;
+
+      apr_pool_userdata_get(&data, DAV_SVN__IO_TRACE_KEY, r->pool);
+      if (!data)
+        {
+          dav_svn__io_trace_t *trace = apr_pcalloc(r->pool, sizeof(*trace));
+          const char *trace_dir = dav_svn__get_trace_io_dir(r);
+          svn_stream_t *events = NULL;
+
+          trace->fs = repos->fs;
+          serr = SVN_NO_ERROR;
+          if (trace_dir)
+            serr = svn_stream_open_unique(&events, &trace->path, trace_dir,
+                                          svn_io_file_del_none,
+                                          r->pool, r->pool);
+          if (!serr)
+            serr = svn_fs__io_trace_start(repos->fs, events, r->pool);
+          if (serr)
+            return dav_svn__sanitize_error(serr, "Could not start I/O trace",
+                                           HTTP_INTERNAL_SERVER_ERROR, r);
+
+          apr_pool_userdata_set(trace, DAV_SVN__IO_TRACE_KEY, NULL, r->pool);
+        }
+    }
+
   /* if an authenticated username is present, attach it to the FS */
   if (r->user)
     {
@@ -3186,8 +3452,22 @@ set_headers(request_rec *r, const dav_resource *resource)
     return NULL;
 
   /* generate our etag and place it into the output */
-  apr_table_setn(r->headers_out, "ETag",
-                 dav_svn__getetag(resource, resource->pool));
+  if (resource->info->text_sha1)
+    {
+      /* Content-addressed texts never change, no matter where they are
+         stored.  Let shared caches keep them. */
+      apr_table_setn(r->headers_out, "Cache-Control",
+                     "public, max-age=31536000, immutable");
+      apr_table_setn(r->headers_out, "ETag",
+                     apr_psprintf(resource->pool, "\"%s%s%s\"",
+                                  resource->info->text_base_md5
+                                    ? resource->info->text_base_md5 : "",
+                                  resource->info->text_base_md5 ? "/" : "",
+                                  resource->info->text_sha1));
+    }
+  else
+    apr_table_setn(r->headers_out, "ETag",
+                   dav_svn__getetag(resource, resource->pool));
 
   /* we accept byte-ranges */
   apr_table_setn(r->headers_out, "Accept-Ranges", "bytes");
@@ -3227,6 +3507,32 @@ set_headers(request_rec *r, const dav_resource *resource)
       svn_error_clear(serr);
     }
 
+  /* A content-addressed text is the same whatever node it came from,
+     so it can't have the MIME type of that node.  The base of a delta
+     is given by the URI and echoing its location would hand that of
+     the first client to everyone served from a cache.  Only the svndiff
+     version may vary. */
+  if (resource->info->text_sha1)
+    {
+      apr_table_unset(r->headers_out, SVN_DAV_DELTA_BASE_HEADER);
+      apr_table_setn(r->headers_out, "Vary", "Accept-Encoding");
+
+      if (mimetype == NULL)
+        {
+          mimetype = "application/octet-stream";
+
+          serr = svn_fs_file_length(&length,
+                                    resource->info->root.root,
+                                    resource->info->repos_path,
+                                    resource->pool);
+          if (serr != NULL)
+            return dav_svn__convert_err(serr, HTTP_INTERNAL_SERVER_ERROR,
+                                        "could not fetch the resource length",
+                                        resource->pool);
+          ap_set_content_length(r, (apr_off_t) length);
+        }
+    }
+
   if ((mimetype == NULL)
       && ((resource->type == DAV_RESOURCE_TYPE_VERSION)
           || (resource->type == DAV_RESOURCE_TYPE_REGULAR))
@@ -4811,6 +5117,14 @@ handle_post_request(request_rec *r,
       return dav_svn__post_create_txn_with_props(resource,
                                                  request_skel, output);
     }
+  else if (svn_skel__matches_atom(post_skel, "lock-many"))
+    {
+      return dav_svn__post_lock_many(resource, request_skel, output);
+    }
+  else if (svn_skel__matches_atom(post_skel, "unlock-many"))
+    {
+      return dav_svn__post_unlock_many(resource, request_skel, output);
+    }
 
   return dav_svn__new_error(pool, HTTP_BAD_REQUEST, 0, 0,
                             "Unsupported skel POST request flavor.");
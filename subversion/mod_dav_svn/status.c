@@ -24,10 +24,14 @@
 #include <http_config.h>
 #include <http_request.h>
 #include <http_protocol.h>
+#include <http_log.h>
 
 #include "dav_svn.h"
 #include "private/svn_cache.h"
 #include "private/svn_fs_private.h"
+#include "private/svn_metrics.h"
+#include "private/svn_subr_private.h"
+#include "svn_path.h"
 
 #ifdef HAVE_UNISTD_H
 #include <unistd.h>   /* For getpid() */
@@ -117,3 +121,123 @@ int dav_svn__status(request_rec *r)
 
   return 0;
 }
+
+/* Like svn-status, but for monitoring systems:
+
+     <Location /svn-metrics>
+       SetHandler svn-metrics
+     </Location>
+
+  returns the statistics of the process that handles the request in the
+  Prometheus text format.  As above, that is a single process out of
+  possibly many.
+*/
+int dav_svn__metrics(request_rec *r)
+{
+  svn_stringbuf_t *text;
+  svn_error_t *err;
+
+  if (r->method_number != M_GET || strcmp(r->handler, "svn-metrics"))
+    return DECLINED;
+
+  err = svn_metrics__format(&text, r->pool, r->pool);
+  if (err)
+    {
+      ap_log_rerror(APLOG_MARK, APLOG_ERR, err->apr_err, r,
+                    "%s", svn_error_purge_tracing(err)->message);
+      svn_error_clear(err);
+      return HTTP_INTERNAL_SERVER_ERROR;
+    }
+
+  ap_set_content_type(r, SVN_METRICS__CONTENT_TYPE);
+  ap_rwrite(text->data, (int)text->len, r);
+
+  return OK;
+}
+
+/* For finding memory hogs in APR_POOL_DEBUG builds, start httpd with
+   the SVN_POOL_PROFILE environment variable set and configure
+
+     <Location /svn-pool-profile>
+       SetHandler svn-pool-profile
+     </Location>
+
+  to get the memory usage per pool creation site in the process that
+  handles the request.
+*/
+int dav_svn__pool_profile(request_rec *r)
+{
+  svn_stringbuf_t *text;
+  svn_error_t *err;
+
+  if (r->method_number != M_GET || strcmp(r->handler, "svn-pool-profile"))
+    return DECLINED;
+
+  if (!svn_pool__profile_enabled())
+    return HTTP_NOT_FOUND;
+
+  err = svn_pool__profile_format(&text, r->pool, r->pool);
+  if (err)
+    {
+      ap_log_rerror(APLOG_MARK, APLOG_ERR, err->apr_err, r,
+                    "%s", svn_error_purge_tracing(err)->message);
+      svn_error_clear(err);
+      return HTTP_INTERNAL_SERVER_ERROR;
+    }
+
+  ap_set_content_type(r, "text/plain; charset=utf-8");
+  ap_rwrite(text->data, (int)text->len, r);
+
+  return OK;
+}
+
+int dav_svn__log_metrics(request_rec *r)
+{
+  const char *method;
+
+  /* Only record requests to Subversion repositories. */
+  if (!dav_svn__get_fs_path(r) && !dav_svn__get_fs_parent_path(r))
+    return DECLINED;
+
+  /* Don't let arbitrary client-provided method names become labels. */
+  method = r->method_number == M_INVALID ? "other" : r->method;
+
+  svn_metrics__observe(
+      svn_metrics__histogram("svn_dav_request_duration_seconds",
+                             svn_metrics__label("method", method, r->pool),
+                             "Time spent processing mod_dav_svn requests."),
+      apr_time_now() - r->request_time);
+
+  return DECLINED;
+}
+
+int dav_svn__log_io_trace(request_rec *r)
+{
+  void *data;
+  dav_svn__io_trace_t *trace;
+  const svn_fs__io_stats_t *stats;
+
+  apr_pool_userdata_get(&data, DAV_SVN__IO_TRACE_KEY, r->pool);
+  trace = data;
+  if (!trace)
+    return DECLINED;
+
+  stats = svn_fs__io_trace_stats(trace->fs);
+  if (!stats)
+    return DECLINED;
+
+  apr_table_set(r->subprocess_env, "SVN-IO",
+                apr_psprintf(r->pool,
+                             "files=%" APR_UINT64_T_FMT
+                             " items=%" APR_UINT64_T_FMT
+                             " bytes=%" APR_UINT64_T_FMT
+                             " cache-hits=%" APR_UINT64_T_FMT "%s%s",
+                             stats->files_opened, stats->items_read,
+                             stats->bytes_read, stats->cache_hits,
+                             trace->path ? " trace=" : "",
+                             trace->path
+                               ? svn_path_uri_encode(trace->path, r->pool)
+                               : ""));
+
+  return DECLINED;
+}
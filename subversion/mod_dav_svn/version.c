@@ -39,6 +39,7 @@
 #include "svn_dav.h"
 #include "svn_base64.h"
 #include "svn_version.h"
+#include "private/svn_fs_private.h"
 #include "private/svn_repos_private.h"
 #include "private/svn_subr_private.h"
 #include "private/svn_dav_protocol.h"
@@ -79,6 +80,55 @@ dav_svn__attach_auto_revprops(svn_fs_txn_t *txn,
 }
 
 
+/* Implements svn_fs__commit_timing_func_t.  Append PHASE and DURATION
+   to the svn_stringbuf_t *BATON. */
+static void
+collect_commit_timing(void *baton,
+                      const char *phase,
+                      apr_interval_time_t duration,
+                      apr_pool_t *scratch_pool)
+{
+  svn_stringbuf_t *timings = baton;
+
+  if (timings->len)
+    svn_stringbuf_appendbyte(timings, ' ');
+  svn_stringbuf_appendcstr(timings,
+                           apr_psprintf(scratch_pool, "%s=%.3fms", phase,
+                                        duration / 1000.0));
+}
+
+
+svn_error_t *
+dav_svn__commit_txn(const char **conflict_p,
+                    svn_repos_t *repos,
+                    svn_revnum_t *new_rev,
+                    svn_fs_txn_t *txn,
+                    request_rec *r,
+                    apr_pool_t *pool)
+{
+  svn_fs_t *fs = svn_repos_fs(repos);
+  svn_stringbuf_t *timings;
+  svn_error_t *serr;
+
+  if (! dav_svn__get_commit_timing_flag(r))
+    return svn_repos_fs_commit_txn(conflict_p, repos, new_rev, txn, pool);
+
+  timings = svn_stringbuf_create_empty(pool);
+  svn_fs__set_commit_timing_func(fs, collect_commit_timing, timings);
+  serr = svn_repos_fs_commit_txn(conflict_p, repos, new_rev, txn, pool);
+  svn_fs__set_commit_timing_func(fs, NULL, NULL);
+
+  if (timings->len)
+    apr_table_set(r->subprocess_env, "SVN-COMMIT-TIMING",
+                  SVN_IS_VALID_REVNUM(*new_rev)
+                    ? apr_psprintf(r->pool, "r%ld %s", *new_rev,
+                                   timings->data)
+                    : apr_pstrdup(r->pool, timings->data));
+
+  return serr;
+}
+
+
 /* Helper: attach an auto-generated svn:log property to a txn within
    an auto-checked-out working resource. */
 static dav_error *
@@ -153,6 +203,9 @@ get_vsn_options(apr_pool_t *p, apr_text_header *phdr)
   apr_text_append(p, phdr, SVN_DAV_NS_DAV_SVN_INLINE_PROPS);
   apr_text_append(p, phdr, SVN_DAV_NS_DAV_SVN_REVERSE_FILE_REVS);
   apr_text_append(p, phdr, SVN_DAV_NS_DAV_SVN_LIST);
+  apr_text_append(p, phdr, SVN_DAV_NS_DAV_SVN_LIST_SINCE);
+  apr_text_append(p, phdr, SVN_DAV_NS_DAV_SVN_STAT_MANY);
+  apr_text_append(p, phdr, SVN_DAV_NS_DAV_SVN_REV_PROPLIST_RANGE);
   /* Mergeinfo is a special case: here we merely say that the server
    * knows how to handle mergeinfo -- whether the repository does too
    * is a separate matter.
@@ -197,6 +250,7 @@ get_option(const dav_resource *resource,
     { SVN_DAV_NS_DAV_SVN_EPHEMERAL_TXNPROPS,  { 1,  8, 0, ""} },
     { SVN_DAV_NS_DAV_SVN_SVNDIFF1,            { 1, 10, 0, ""} },
     { SVN_DAV_NS_DAV_SVN_SVNDIFF2,            { 1, 10, 0, ""} },
+    { SVN_DAV_NS_DAV_SVN_SVNDIFF3,            { 1, 11, 0, ""} },
     { SVN_DAV_NS_DAV_SVN_PUT_RESULT_CHECKSUM, { 1, 10, 0, ""} },
   };
 
@@ -300,6 +354,8 @@ get_option(const dav_resource *resource,
       } posts_versions[] = {
         { "create-txn",             { 1, 7, 0, "" } },
         { "create-txn-with-props",  { 1, 8, 0, "" } },
+        { "lock-many",              { 1, 11, 0, "" } },
+        { "unlock-many",            { 1, 11, 0, "" } },
       };
 
       /* Add the header which indicates that this server can handle
@@ -336,6 +392,18 @@ get_option(const dav_resource *resource,
                     bulk_upd_conf == CONF_BULKUPD_ON ? "On" :
                       bulk_upd_conf == CONF_BULKUPD_OFF ? "Off" : "Prefer");
 
+      /* GETs are always served locally, so this doesn't depend on the
+         master version. */
+      if (dav_svn__get_content_urls_flag(r))
+        {
+          apr_table_set(r->headers_out, SVN_DAV_TEXT_STUB_HEADER,
+                        apr_pstrcat(r->pool, repos_root_uri, "/",
+                                    dav_svn__get_text_stub(r), SVN_VA_NULL));
+          apr_table_set(r->headers_out, SVN_DAV_DELTA_STUB_HEADER,
+                        apr_pstrcat(r->pool, repos_root_uri, "/",
+                                    dav_svn__get_delta_stub(r), SVN_VA_NULL));
+        }
+
       /* Report the supported POST types. */
       for (i = 0; i < sizeof(posts_versions)/sizeof(posts_versions[0]); ++i)
         {
@@ -370,6 +438,11 @@ get_option(const dav_resource *resource,
                      apr_pstrdup(r->pool, capabilities[i].capability_name));
     }
 
+  /* Log reports are always served locally, so this doesn't depend on
+     the master version. */
+  if (dav_svn__get_binary_reports_flag(r))
+    apr_table_addn(r->headers_out, "DAV", SVN_DAV_NS_DAV_SVN_BINARY_LOG);
+
   return NULL;
 }
 
@@ -988,11 +1061,12 @@ dav_svn__checkin(dav_resource *resource,
       if (err)
         return err;
 
-      serr = svn_repos_fs_commit_txn(&conflict_msg,
-                                     resource->info->repos->repos,
-                                     &new_rev,
-                                     resource->info->root.txn,
-                                     resource->pool);
+      serr = dav_svn__commit_txn(&conflict_msg,
+                                 resource->info->repos->repos,
+                                 &new_rev,
+                                 resource->info->root.txn,
+                                 resource->info->r,
+                                 resource->pool);
 
       if (SVN_IS_VALID_REVNUM(new_rev))
         {
@@ -1180,6 +1254,14 @@ deliver_report(request_rec *r,
         {
           return dav_svn__list_report(resource, doc, output);
         }
+      else if (strcmp(doc->root->name, "stat-many-report") == 0)
+        {
+          return dav_svn__stat_many_report(resource, doc, output);
+        }
+      else if (strcmp(doc->root->name, "rev-proplist-range-report") == 0)
+        {
+          return dav_svn__rev_proplist_range_report(resource, doc, output);
+        }
       /* NOTE: if you add a report, don't forget to add it to the
        *       dav_svn__reports_list[] array.
        */
@@ -1509,8 +1591,8 @@ merge(dav_resource *target,
     return err;
 
   /* all righty... commit the bugger. */
-  serr = svn_repos_fs_commit_txn(&conflict, source->info->repos->repos,
-                                 &new_rev, txn, pool);
+  serr = dav_svn__commit_txn(&conflict, source->info->repos->repos,
+                             &new_rev, txn, source->info->r, pool);
 
   /* ### TODO: Figure out if the MERGE response can grow a means by
      which to marshal back both the success of the commit (and its
@@ -1153,6 +1153,59 @@ print_info_item(void *baton,
   return SVN_NO_ERROR;
 }
 
+/* The baton for info_many_receiver(). */
+typedef struct info_many_baton_t
+{
+  /* The receiver to forward the info on existing URLs to. */
+  svn_client_info_receiver2_t receiver;
+  void *receiver_baton;
+
+  /* Set when a URL turned out not to exist. */
+  svn_boolean_t seen_nonexistent_target;
+} info_many_baton_t;
+
+/* A callback of type svn_client_info_receiver2_t for
+   svn_client_info_many().  Warn about URLs that don't exist and pass
+   everything else on to the receiver in the info_many_baton_t BATON. */
+static svn_error_t *
+info_many_receiver(void *baton,
+                   const char *abspath_or_url,
+                   const svn_client_info2_t *info,
+                   apr_pool_t *pool)
+{
+  info_many_baton_t *b = baton;
+  svn_error_t *err;
+
+  if (info->kind != svn_node_none)
+    return svn_error_trace(b->receiver(b->receiver_baton, abspath_or_url,
+                                       info, pool));
+
+  /* Same as what svn_client_info4() would have returned. */
+  err = svn_error_createf(SVN_ERR_RA_ILLEGAL_URL, NULL,
+                          _("URL '%s' non-existent in revision %ld"),
+                          info->URL, info->rev);
+  svn_handle_warning2(stderr, err, "svn: ");
+  svn_error_clear(err);
+  svn_error_clear(svn_cmdline_fprintf(stderr, pool, "\n"));
+
+  b->seen_nonexistent_target = TRUE;
+  return SVN_NO_ERROR;
+}
+
+/* Return TRUE if the peg revisions A and B are the same. */
+static svn_boolean_t
+same_peg_revision(const svn_opt_revision_t *a,
+                  const svn_opt_revision_t *b)
+{
+  if (a->kind != b->kind)
+    return FALSE;
+  if (a->kind == svn_opt_revision_number)
+    return a->value.number == b->value.number;
+  if (a->kind == svn_opt_revision_date)
+    return a->value.date == b->value.date;
+
+  return TRUE;
+}
 
 /* This implements the `svn_opt_subcommand_t' interface. */
 svn_error_t *
@@ -1170,6 +1223,7 @@ svn_cl__info(apr_getopt_t *os,
   svn_opt_revision_t peg_revision;
   svn_client_info_receiver2_t receiver;
   print_info_baton_t receiver_baton = { 0 };
+  info_many_baton_t many_baton = { 0 };
 
   SVN_ERR(svn_cl__args_to_target_array_print_reserved(&targets, os,
                                                       opt_state->targets,
@@ -1244,6 +1298,9 @@ svn_cl__info(apr_getopt_t *os,
 
   SVN_ERR(svn_dirent_get_absolute(&receiver_baton.path_prefix, "", pool));
 
+  many_baton.receiver = receiver;
+  many_baton.receiver_baton = &receiver_baton;
+
   for (i = 0; i < targets->nelts; i++)
     {
       const char *truepath;
@@ -1261,6 +1318,41 @@ svn_cl__info(apr_getopt_t *os,
           if (peg_revision.kind == svn_opt_revision_unspecified)
             peg_revision.kind = svn_opt_revision_head;
           receiver_baton.target_is_path = FALSE;
+
+          /* Look up runs of URLs in the same revision together, with one
+             request per repository rather than several per target. */
+          if (opt_state->start_revision.kind == svn_opt_revision_unspecified)
+            {
+              apr_array_header_t *urls = apr_array_make(subpool, 1,
+                                                        sizeof(const char *));
+
+              APR_ARRAY_PUSH(urls, const char *) = truepath;
+              while (i + 1 < targets->nelts)
+                {
+                  svn_opt_revision_t next_peg;
+                  const char *next_path;
+
+                  SVN_ERR(svn_opt_parse_path(&next_peg, &next_path,
+                                             APR_ARRAY_IDX(targets, i + 1,
+                                                           const char *),
+                                             subpool));
+                  if (!svn_path_is_url(next_path))
+                    break;
+                  if (next_peg.kind == svn_opt_revision_unspecified)
+                    next_peg.kind = svn_opt_revision_head;
+                  if (!same_peg_revision(&next_peg, &peg_revision))
+                    break;
+
+                  APR_ARRAY_PUSH(urls, const char *) = next_path;
+                  i++;
+                }
+
+              SVN_ERR(svn_client_info_many(urls, &peg_revision,
+                                           opt_state->depth,
+                                           info_many_receiver, &many_baton,
+                                           ctx, subpool));
+              continue;
+            }
         }
       else
         {
@@ -1300,6 +1392,9 @@ svn_cl__info(apr_getopt_t *os,
     }
   svn_pool_destroy(subpool);
 
+  if (many_baton.seen_nonexistent_target)
+    seen_nonexistent_target = TRUE;
+
   if (opt_state->xml && (! opt_state->incremental))
     SVN_ERR(svn_cl__xml_print_footer("info", pool));
   else if (opt_state->show_item && !opt_state->no_newline
@@ -402,9 +402,9 @@ svn_cl__list(apr_getopt_t *os,
             }
         }
 
-      err = svn_client_list4(truepath, &peg_revision,
+      err = svn_client_list5(truepath, &peg_revision,
                              &(opt_state->start_revision), patterns,
-                             opt_state->depth,
+                             opt_state->depth, SVN_INVALID_REVNUM,
                              dirent_fields,
                              (opt_state->xml || opt_state->verbose),
                              opt_state->include_externals,
@@ -48,6 +48,7 @@
 #include "private/svn_sorts_private.h"
 #include "private/svn_subr_private.h"
 #include "private/svn_cmdline_private.h"
+#include "private/svn_fs_private.h"
 #include "private/svn_fspath.h"
 
 #include "svn_private_config.h"
@@ -95,6 +96,7 @@ check_lib_versions(void)
 /** Subcommands. **/
 
 static svn_opt_subcommand_t
+  subcommand_build_log_index,
   subcommand_crashtest,
   subcommand_create,
   subcommand_delrevprop,
@@ -121,7 +123,8 @@ static svn_opt_subcommand_t
   subcommand_setuuid,
   subcommand_unlock,
   subcommand_upgrade,
-  subcommand_verify;
+  subcommand_verify,
+  subcommand_warm_cache;
 
 enum svnadmin__cmdline_options_t
   {
@@ -151,11 +154,15 @@ enum svnadmin__cmdline_options_t
     svnadmin__compatible_version,
     svnadmin__check_normalization,
     svnadmin__metadata_only,
+    svnadmin__jobs,
     svnadmin__no_flush_to_disk,
+    svnadmin__pipelined,
     svnadmin__normalize_props,
     svnadmin__exclude,
     svnadmin__include,
-    svnadmin__glob
+    svnadmin__glob,
+    svnadmin__snapshot_file,
+    svnadmin__skip_verified
   };
 
 /* Option codes and descriptions.
@@ -274,10 +281,18 @@ static const apr_getopt_option_t options_table[] =
         "                             checking against external corruption in\n"
         "                             Subversion 1.9+ format repositories.\n")},
 
+    {"jobs", svnadmin__jobs, 1,
+     N_("process up to ARG revisions in parallel.\n"
+        "                             Default: 1.")},
+
     {"no-flush-to-disk", svnadmin__no_flush_to_disk, 0,
      N_("disable flushing to disk during the operation\n"
         "                             (faster, but unsafe on power off)")},
 
+    {"pipelined", svnadmin__pipelined, 0,
+     N_("parse the dump stream in a separate thread\n"
+        "                             while committing revisions")},
+
     {"normalize-props", svnadmin__normalize_props, 0,
      N_("normalize property values found in the dumpstream\n"
         "                             (currently, only translates non-LF line endings)")},
@@ -294,6 +309,15 @@ static const apr_getopt_option_t options_table[] =
         "                             Character '/' is not treated specially, so\n"
         "                             pattern /*/foo matches paths /a/foo and /a/b/foo.") },
 
+    {"snapshot-file", svnadmin__snapshot_file, 1,
+     N_("write the cache contents to file ARG for servers\n"
+        "                             to load at startup")},
+
+    {"skip-verified", svnadmin__skip_verified, 0,
+     N_("skip revisions that the repository has verified\n"
+        "                             successfully after their commit (FSFS with\n"
+        "                             verify-after-commit enabled only)")},
+
     {NULL}
   };
 
@@ -303,6 +327,16 @@ static const apr_getopt_option_t options_table[] =
  */
 static const svn_opt_subcommand_desc3_t cmd_table[] =
 {
+  {"build-log-index", subcommand_build_log_index, {0}, {N_(
+    "usage: svnadmin build-log-index REPOS_PATH\n"
+    "\n"), N_(
+    "Create or update the changed-paths index of the repository at\n"
+    "REPOS_PATH.  'svn log' uses it to find the revisions that changed a\n"
+    "path without walking the path's history.  Once created, the index is\n"
+    "kept up to date with every commit.\n"
+   )},
+   {'q'} },
+
   {"crashtest", subcommand_crashtest, {0}, {N_(
     "usage: svnadmin crashtest REPOS_PATH\n"
     "\n"), N_(
@@ -367,9 +401,12 @@ static const svn_opt_subcommand_desc3_t cmd_table[] =
     "Using --exclude or --include gives results equivalent to authz-based\n"
     "path exclusions. In particular, when the source of a copy is\n"
     "excluded, the copy is transformed into an add (unlike in 'svndumpfilter').\n"
+    "\n"), N_(
+    "With --jobs, ranges of revisions are dumped concurrently.  The output\n"
+    "is the same as without that option.\n"
    )},
   {'r', svnadmin__incremental, svnadmin__deltas, 'q', 'M', 'F',
-   svnadmin__exclude, svnadmin__include, svnadmin__glob },
+   svnadmin__exclude, svnadmin__include, svnadmin__glob, svnadmin__jobs },
   {{'F', N_("write to file ARG instead of stdout")}} },
 
   {"dump-revprops", subcommand_dump_revprops, {0}, {N_(
@@ -456,7 +493,7 @@ static const svn_opt_subcommand_desc3_t cmd_table[] =
     svnadmin__use_pre_commit_hook, svnadmin__use_post_commit_hook,
     svnadmin__parent_dir, svnadmin__normalize_props,
     svnadmin__bypass_prop_validation, 'M',
-    svnadmin__no_flush_to_disk, 'F'},
+    svnadmin__no_flush_to_disk, svnadmin__pipelined, 'F'},
    {{'F', N_("read from file ARG instead of stdin")}} },
 
   {"load-revprops", subcommand_load_revprops, {0}, {N_(
@@ -605,7 +642,19 @@ static const svn_opt_subcommand_desc3_t cmd_table[] =
     "Verify the data stored in the repository.\n"
    )},
    {'t', 'r', 'q', svnadmin__keep_going, 'M',
-    svnadmin__check_normalization, svnadmin__metadata_only} },
+    svnadmin__check_normalization, svnadmin__metadata_only,
+    svnadmin__jobs, svnadmin__skip_verified} },
+
+  {"warm-cache", subcommand_warm_cache, {0}, {N_(
+    "usage: svnadmin warm-cache REPOS_PATH [PATH...]\n"
+    "\n"), N_(
+    "Read the directories, properties and file contents below the given\n"
+    "PATHs (default: the whole tree) in the youngest revision into the\n"
+    "in-memory cache.  With --snapshot-file, save the cache contents such\n"
+    "that svnserve --cache-snapshot or mod_dav_svn's SVNCacheSnapshotFile\n"
+    "start with a warm cache.  Use -M to set the cache size.\n"
+   )},
+   {'q', 'M', svnadmin__snapshot_file} },
 
   { NULL, NULL, {0}, {NULL}, {0} }
 };
@@ -639,15 +688,19 @@ struct svnadmin_opt_state
   svn_boolean_t bypass_prop_validation;             /* --bypass-prop-validation */
   svn_boolean_t ignore_dates;                       /* --ignore-dates */
   svn_boolean_t no_flush_to_disk;                   /* --no-flush-to-disk */
+  svn_boolean_t pipelined;                          /* --pipelined */
   svn_boolean_t normalize_props;                    /* --normalize_props */
   enum svn_repos_load_uuid uuid_action;             /* --ignore-uuid,
                                                        --force-uuid */
   apr_uint64_t memory_cache_size;                   /* --memory-cache-size M */
+  int jobs;                                         /* --jobs */
   const char *parent_dir;                           /* --parent-dir */
   const char *file;                                 /* --file */
   apr_array_header_t *exclude;                      /* --exclude */
   apr_array_header_t *include;                      /* --include */
   svn_boolean_t glob;                               /* --pattern */
+  const char *snapshot_file;                        /* --snapshot-file */
+  svn_boolean_t skip_verified;                      /* --skip-verified */
 
   const char *config_dir;    /* Overriding Configuration Directory */
 };
@@ -990,7 +1043,7 @@ struct repos_verify_callback_baton
 };
 
 /* Implementation of svn_repos_verify_callback_t to handle errors coming
-   from svn_repos_verify_fs3(). */
+   from svn_repos_verify_fs4(). */
 static svn_error_t *
 repos_verify_callback(void *baton,
                       svn_revnum_t revision,
@@ -1256,6 +1309,12 @@ repos_notify_handler(void *baton,
                         notify->new_revision));
       return;
 
+    case svn_repos_notify_log_index_rev:
+      svn_error_clear(svn_stream_printf(feedback_stream, scratch_pool,
+                                        _("* Indexed revision %ld.\n"),
+                                        notify->revision));
+      return;
+
     default:
       return;
   }
@@ -1451,9 +1510,9 @@ subcommand_dump(apr_getopt_t *os, void *baton, apr_pool_t *pool)
                                  "cannot be used simultaneously"));
     }
 
-  SVN_ERR(svn_repos_dump_fs4(repos, out_stream, lower, upper,
+  SVN_ERR(svn_repos_dump_fs5(repos, out_stream, lower, upper,
                              opt_state->incremental, opt_state->use_deltas,
-                             TRUE, TRUE,
+                             TRUE, TRUE, opt_state->jobs,
                              !opt_state->quiet ? repos_notify_handler : NULL,
                              feedback_stream,
                              filter_baton.prefixes ? dump_filter_func : NULL,
@@ -1497,8 +1556,8 @@ subcommand_dump_revprops(apr_getopt_t *os, void *baton, apr_pool_t *pool)
   if (! opt_state->quiet)
     feedback_stream = recode_stream_create(stderr, pool);
 
-  SVN_ERR(svn_repos_dump_fs4(repos, out_stream, lower, upper,
-                             FALSE, FALSE, TRUE, FALSE,
+  SVN_ERR(svn_repos_dump_fs5(repos, out_stream, lower, upper,
+                             FALSE, FALSE, TRUE, FALSE, 1,
                              !opt_state->quiet ? repos_notify_handler : NULL,
                              feedback_stream, NULL, NULL,
                              check_cancel, NULL, pool));
@@ -1707,13 +1766,14 @@ subcommand_load(apr_getopt_t *os, void *baton, apr_pool_t *pool)
   if (! opt_state->quiet)
     feedback_stream = recode_stream_create(stdout, pool);
 
-  err = svn_repos_load_fs6(repos, in_stream, lower, upper,
+  err = svn_repos_load_fs7(repos, in_stream, lower, upper,
                            opt_state->uuid_action, opt_state->parent_dir,
                            opt_state->use_pre_commit_hook,
                            opt_state->use_post_commit_hook,
                            !opt_state->bypass_prop_validation,
                            opt_state->ignore_dates,
                            opt_state->normalize_props,
+                           opt_state->pipelined,
                            opt_state->quiet ? NULL : repos_notify_handler,
                            feedback_stream, check_cancel, NULL, pool);
 
@@ -2163,6 +2223,30 @@ subcommand_setlog(apr_getopt_t *os, void *baton, apr_pool_t *pool)
 }
 
 
+/* This implements 'svn_opt_subcommand_t'. */
+static svn_error_t *
+subcommand_build_log_index(apr_getopt_t *os, void *baton, apr_pool_t *pool)
+{
+  struct svnadmin_opt_state *opt_state = baton;
+  svn_repos_t *repos;
+  svn_stream_t *feedback_stream = NULL;
+
+  /* Expect no more arguments. */
+  SVN_ERR(parse_args(NULL, os, 0, 0, pool));
+
+  SVN_ERR(open_repos(&repos, opt_state->repository_path, opt_state, pool));
+
+  /* Progress feedback goes to STDOUT, unless they asked to suppress it. */
+  if (! opt_state->quiet)
+    feedback_stream = recode_stream_create(stdout, pool);
+
+  return svn_error_trace(
+    svn_repos_build_log_index(repos,
+                              !opt_state->quiet ? repos_notify_handler : NULL,
+                              feedback_stream, check_cancel, NULL, pool));
+}
+
+
 /* This implements 'svn_opt_subcommand_t'. */
 static svn_error_t *
 subcommand_pack(apr_getopt_t *os, void *baton, apr_pool_t *pool)
@@ -2196,10 +2280,19 @@ subcommand_verify(apr_getopt_t *os, void *baton, apr_pool_t *pool)
   svn_revnum_t youngest, lower, upper;
   svn_stream_t *feedback_stream = NULL;
   struct repos_verify_callback_baton verify_baton = { 0 };
+  apr_array_header_t *verified;
+  int i;
 
   /* Expect no more arguments. */
   SVN_ERR(parse_args(NULL, os, 0, 0, pool));
 
+  if (opt_state->skip_verified && opt_state->check_normalization)
+    {
+      return svn_error_createf(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
+                               _("--skip-verified and --check-normalization "
+                                 "are mutually exclusive"));
+    }
+
   if (opt_state->txn_id
       && (opt_state->start_revision.kind != svn_opt_revision_unspecified
           || opt_state->end_revision.kind != svn_opt_revision_unspecified))
@@ -2247,14 +2340,42 @@ subcommand_verify(apr_getopt_t *os, void *baton, apr_pool_t *pool)
     apr_array_make(pool, 0, sizeof(struct verification_error *));
   verify_baton.result_pool = pool;
 
-  SVN_ERR(svn_repos_verify_fs3(repos, lower, upper,
-                               opt_state->check_normalization,
-                               opt_state->metadata_only,
-                               !opt_state->quiet
-                                 ? repos_notify_handler : NULL,
-                               feedback_stream,
-                               repos_verify_callback, &verify_baton,
-                               check_cancel, NULL, pool));
+  /* Revisions that passed the verification after commit need not be
+     verified again. */
+  if (opt_state->skip_verified)
+    SVN_ERR(svn_fs__get_verified_revisions(&verified, fs, lower, upper,
+                                           pool, pool));
+  else
+    verified = apr_array_make(pool, 0, sizeof(svn_revnum_t));
+
+  /* Verify the ranges between the already verified revisions. */
+  for (i = 0; i <= verified->nelts; ++i)
+    {
+      svn_revnum_t range_end = i < verified->nelts
+                             ? APR_ARRAY_IDX(verified, i, svn_revnum_t) - 1
+                             : upper;
+
+      if (lower <= range_end)
+        SVN_ERR(svn_repos_verify_fs4(repos, lower, range_end,
+                                     opt_state->check_normalization,
+                                     opt_state->metadata_only,
+                                     opt_state->jobs,
+                                     !opt_state->quiet
+                                       ? repos_notify_handler : NULL,
+                                     feedback_stream,
+                                     repos_verify_callback, &verify_baton,
+                                     check_cancel, NULL, pool));
+
+      if (i < verified->nelts)
+        {
+          lower = range_end + 2;
+          if (!opt_state->quiet)
+            SVN_ERR(svn_stream_printf(feedback_stream, pool,
+                                      _("* Revision %ld has been verified "
+                                        "after commit.\n"),
+                                      range_end + 1));
+        }
+    }
 
   /* Show the --keep-going error summary. */
   if (!opt_state->quiet
@@ -2264,7 +2385,6 @@ subcommand_verify(apr_getopt_t *os, void *baton, apr_pool_t *pool)
       int rev_maxlength;
       svn_revnum_t end_revnum;
       apr_pool_t *iterpool;
-      int i;
 
       svn_error_clear(
         svn_stream_puts(feedback_stream,
@@ -2328,6 +2448,118 @@ subcommand_verify(apr_getopt_t *os, void *baton, apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+
+/* Read the properties and contents of the node at PATH in ROOT and, for
+   directories, of all nodes below it, such that they end up in the
+   caches.  Add the number of files read to *FILE_COUNT.  Use
+   SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+warm_cache_node(int *file_count,
+                svn_fs_root_t *root,
+                const char *path,
+                apr_pool_t *scratch_pool)
+{
+  svn_node_kind_t kind;
+  apr_hash_t *props;
+
+  SVN_ERR(check_cancel(NULL));
+  SVN_ERR(svn_fs_check_path(&kind, root, path, scratch_pool));
+  SVN_ERR(svn_fs_node_proplist(&props, root, path, scratch_pool));
+
+  if (kind == svn_node_dir)
+    {
+      apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+      apr_hash_t *entries;
+      apr_hash_index_t *hi;
+
+      SVN_ERR(svn_fs_dir_entries(&entries, root, path, scratch_pool));
+      for (hi = apr_hash_first(scratch_pool, entries);
+           hi;
+           hi = apr_hash_next(hi))
+        {
+          svn_pool_clear(iterpool);
+          SVN_ERR(warm_cache_node(file_count, root,
+                                  svn_fspath__join(path,
+                                                   apr_hash_this_key(hi),
+                                                   iterpool),
+                                  iterpool));
+        }
+
+      svn_pool_destroy(iterpool);
+    }
+  else if (kind == svn_node_file)
+    {
+      svn_stream_t *contents;
+
+      SVN_ERR(svn_fs_file_contents(&contents, root, path, scratch_pool));
+      SVN_ERR(svn_stream_copy3(contents, svn_stream_empty(scratch_pool),
+                               check_cancel, NULL, scratch_pool));
+      ++*file_count;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* This implements `svn_opt_subcommand_t'. */
+static svn_error_t *
+subcommand_warm_cache(apr_getopt_t *os, void *baton, apr_pool_t *pool)
+{
+  struct svnadmin_opt_state *opt_state = baton;
+  apr_array_header_t *args;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  apr_hash_t *fs_config = apr_hash_make(pool);
+  svn_repos_t *repos;
+  svn_fs_t *fs;
+  svn_fs_root_t *root;
+  svn_revnum_t youngest;
+  int file_count = 0;
+  int i;
+
+  SVN_ERR(parse_args(&args, os, 0, -1, pool));
+  if (args->nelts == 0)
+    APR_ARRAY_PUSH(args, const char *) = "/";
+
+  /* Unlike open_repos(), use the default cache namespace of the servers
+     or they would not find our cache entries. */
+  svn_hash_sets(fs_config, SVN_FS_CONFIG_FSFS_CACHE_DELTAS, "1");
+  svn_hash_sets(fs_config, SVN_FS_CONFIG_FSFS_CACHE_FULLTEXTS, "1");
+  svn_hash_sets(fs_config, SVN_FS_CONFIG_FSFS_CACHE_NODEPROPS, "1");
+  svn_hash_sets(fs_config, SVN_FS_CONFIG_FSFS_BLOCK_READ,
+                svn_cache_config_get()->cache_size
+                  > BLOCK_READ_CACHE_THRESHOLD ? "1" : "0");
+
+  SVN_ERR(svn_repos_open3(&repos, opt_state->repository_path, fs_config,
+                          pool, pool));
+  fs = svn_repos_fs(repos);
+  svn_fs_set_warning_func(fs, warning_func, NULL);
+
+  SVN_ERR(svn_fs_youngest_rev(&youngest, fs, pool));
+  SVN_ERR(svn_fs_revision_root(&root, fs, youngest, pool));
+
+  for (i = 0; i < args->nelts; i++)
+    {
+      const char *path;
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(target_arg_to_fspath(&path, APR_ARRAY_IDX(args, i,
+                                                        const char *),
+                                   iterpool, iterpool));
+      SVN_ERR(warm_cache_node(&file_count, root, path, iterpool));
+    }
+
+  svn_pool_destroy(iterpool);
+
+  if (opt_state->snapshot_file)
+    SVN_ERR(svn_fs__save_cache_snapshot(opt_state->snapshot_file, pool));
+
+  if (! opt_state->quiet)
+    SVN_ERR(svn_cmdline_printf(pool,
+                               _("Read %d files of revision %ld.\n"),
+                               file_count, youngest));
+
+  return SVN_NO_ERROR;
+}
+
 /* This implements `svn_opt_subcommand_t'. */
 svn_error_t *
 subcommand_hotcopy(apr_getopt_t *os, void *baton, apr_pool_t *pool)
@@ -2887,6 +3119,7 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
   opt_state.start_revision.kind = svn_opt_revision_unspecified;
   opt_state.end_revision.kind = svn_opt_revision_unspecified;
   opt_state.memory_cache_size = svn_cache_config_get()->cache_size;
+  opt_state.jobs = 1;
 
   /* Parse options. */
   SVN_ERR(svn_cmdline__getopt_init(&os, argc, argv, pool));
@@ -3031,6 +3264,13 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
       case svnadmin__metadata_only:
         opt_state.metadata_only = TRUE;
         break;
+      case svnadmin__jobs:
+        SVN_ERR(svn_cstring_atoi(&opt_state.jobs, opt_arg));
+        if (opt_state.jobs < 1)
+          return svn_error_createf(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
+                                   _("Invalid number of jobs '%s'"),
+                                   opt_arg);
+        break;
       case svnadmin__fs_type:
         SVN_ERR(svn_utf_cstring_to_utf8(&opt_state.fs_type, opt_arg, pool));
         break;
@@ -3081,6 +3321,9 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
       case svnadmin__no_flush_to_disk:
         opt_state.no_flush_to_disk = TRUE;
         break;
+      case svnadmin__pipelined:
+        opt_state.pipelined = TRUE;
+        break;
       case svnadmin__normalize_props:
         opt_state.normalize_props = TRUE;
         break;
@@ -3101,6 +3344,14 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
       case svnadmin__glob:
         opt_state.glob = TRUE;
         break;
+      case svnadmin__snapshot_file:
+        SVN_ERR(svn_utf_cstring_to_utf8(&utf8_opt_arg, opt_arg, pool));
+        SVN_ERR(target_arg_to_dirent(&opt_state.snapshot_file,
+                                     utf8_opt_arg, pool));
+        break;
+      case svnadmin__skip_verified:
+        opt_state.skip_verified = TRUE;
+        break;
       default:
         {
           SVN_ERR(subcommand_help(NULL, NULL, pool));
@@ -3228,7 +3479,11 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
     svn_cache_config_t settings = *svn_cache_config_get();
 
     settings.cache_size = opt_state.memory_cache_size;
-    settings.single_threaded = TRUE;
+
+    /* Multiple jobs need thread-safe caches.  The number of pack jobs
+     * is configured per repository, so we have to assume the worst. */
+    settings.single_threaded =    opt_state.jobs <= 1
+                               && subcommand->cmd_func != subcommand_pack;
 
     svn_cache_config_set(&settings);
   }
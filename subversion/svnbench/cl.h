@@ -109,10 +109,18 @@ typedef struct svn_cl__cmd_baton_t
 /* Declare all the command procedures */
 svn_opt_subcommand_t
   svn_cl__help,
+  svn_cl__fs_cat,
+  svn_cl__fs_changes,
+  svn_cl__fs_commit,
+  svn_cl__fs_history,
+  svn_cl__fs_list,
   svn_cl__null_blame,
+  svn_cl__null_diff,
   svn_cl__null_export,
   svn_cl__null_list,
   svn_cl__null_log,
+  svn_cl__null_status,
+  svn_cl__null_update,
   svn_cl__null_info;
 
 
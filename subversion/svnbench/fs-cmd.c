@@ -0,0 +1,654 @@
+/*
+ * fs-cmd.c -- Benchmark the repository filesystem layer directly
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include <stdlib.h>
+
+#include "svn_cmdline.h"
+#include "svn_dirent_uri.h"
+#include "svn_error.h"
+#include "svn_fs.h"
+#include "svn_hash.h"
+#include "svn_opt.h"
+#include "svn_path.h"
+#include "svn_pools.h"
+#include "svn_props.h"
+#include "svn_repos.h"
+#include "svn_sorts.h"
+#include "svn_time.h"
+#include "svn_utf.h"
+
+#include "cl.h"
+
+#include "svn_private_config.h"
+#include "private/svn_cache.h"
+#include "private/svn_fspath.h"
+#include "private/svn_sorts_private.h"
+#include "private/svn_string_private.h"
+
+
+
+/*** Shared infrastructure. ***/
+
+/* Everything the FS benchmarks need to know about the repository and
+   the command line. */
+typedef struct fs_bench_t
+{
+  svn_repos_t *repos;
+  svn_fs_t *fs;
+  svn_revnum_t youngest;
+
+  /* Canonical fspaths to operate on.  Never empty. */
+  apr_array_header_t *paths;
+
+  /* Operation latencies as apr_interval_time_t, in order of execution. */
+  apr_array_header_t *latencies;
+
+  /* Global membuffer cache counters before the measurement started. */
+  svn_cache__info_t cache_before;
+
+  svn_cl__opt_state_t *opt_state;
+} fs_bench_t;
+
+/* Return the global membuffer cache statistics in *INFO.  Zero all
+   counters if there is no such cache.  Use SCRATCH_POOL for temporary
+   allocations. */
+static void
+get_cache_info(svn_cache__info_t *info,
+               apr_pool_t *scratch_pool)
+{
+  if (svn_cache__get_global_membuffer_cache())
+    *info = *svn_cache__membuffer_get_global_info(scratch_pool);
+  else
+    memset(info, 0, sizeof(*info));
+}
+
+/* Parse the "REPOS_PATH [PATH...]" arguments from OS and open the
+   repository.  Return the result in *BENCH, allocated in POOL. */
+static svn_error_t *
+open_bench(fs_bench_t **bench,
+           apr_getopt_t *os,
+           svn_cl__opt_state_t *opt_state,
+           apr_pool_t *pool)
+{
+  fs_bench_t *b = apr_pcalloc(pool, sizeof(*b));
+  apr_array_header_t *args;
+  const char *repos_path;
+  int i;
+
+  SVN_ERR(svn_opt_parse_all_args(&args, os, pool));
+  if (args->nelts < 1)
+    return svn_error_create(SVN_ERR_CL_INSUFFICIENT_ARGS, 0, NULL);
+
+  repos_path = APR_ARRAY_IDX(args, 0, const char *);
+  if (svn_path_is_url(repos_path))
+    return svn_error_createf(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
+                             _("'%s' is a URL when it should be a "
+                               "local path"), repos_path);
+
+  repos_path = svn_dirent_internal_style(repos_path, pool);
+  SVN_ERR(svn_repos_open3(&b->repos, repos_path, NULL, pool, pool));
+  b->fs = svn_repos_fs(b->repos);
+  SVN_ERR(svn_fs_youngest_rev(&b->youngest, b->fs, pool));
+
+  b->paths = apr_array_make(pool, args->nelts, sizeof(const char *));
+  for (i = 1; i < args->nelts; ++i)
+    APR_ARRAY_PUSH(b->paths, const char *)
+      = svn_fspath__canonicalize(APR_ARRAY_IDX(args, i, const char *),
+                                 pool);
+
+  if (b->paths->nelts == 0)
+    APR_ARRAY_PUSH(b->paths, const char *) = "/";
+
+  b->latencies = apr_array_make(pool, 1024, sizeof(apr_interval_time_t));
+  b->opt_state = opt_state;
+
+  *bench = b;
+  return SVN_NO_ERROR;
+}
+
+/* Return the revision number given by REVISION in *REV, defaulting to
+   the youngest revision in BENCH.  Use POOL for temporary allocations. */
+static svn_error_t *
+resolve_revision(svn_revnum_t *rev,
+                 const svn_opt_revision_t *revision,
+                 fs_bench_t *bench,
+                 apr_pool_t *pool)
+{
+  switch (revision->kind)
+    {
+      case svn_opt_revision_unspecified:
+      case svn_opt_revision_head:
+        *rev = bench->youngest;
+        break;
+
+      case svn_opt_revision_number:
+        *rev = revision->value.number;
+        if (*rev > bench->youngest)
+          return svn_error_createf(SVN_ERR_FS_NO_SUCH_REVISION, NULL,
+                                   _("No such revision %ld"), *rev);
+        break;
+
+      case svn_opt_revision_date:
+        SVN_ERR(svn_repos_dated_revision(rev, bench->repos,
+                                         revision->value.date, pool));
+        break;
+
+      default:
+        return svn_error_create(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
+                                _("Revision type requires a working copy"));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Start measuring BENCH's cache usage. */
+static void
+start_measurement(fs_bench_t *bench,
+                  apr_pool_t *scratch_pool)
+{
+  get_cache_info(&bench->cache_before, scratch_pool);
+}
+
+/* Add a latency sample of the operation that started at START to BENCH. */
+static void
+add_sample(fs_bench_t *bench,
+           apr_time_t start)
+{
+  APR_ARRAY_PUSH(bench->latencies, apr_interval_time_t)
+    = apr_time_now() - start;
+}
+
+/* qsort-compatible comparison function for apr_interval_time_t. */
+static int
+compare_latencies(const void *lhs,
+                  const void *rhs)
+{
+  apr_interval_time_t lhs_value = *(const apr_interval_time_t *)lhs;
+  apr_interval_time_t rhs_value = *(const apr_interval_time_t *)rhs;
+
+  return lhs_value < rhs_value ? -1 : (lhs_value > rhs_value ? 1 : 0);
+}
+
+/* Return the latency at PERCENTILE within the sorted array LATENCIES.
+   The array must not be empty. */
+static double
+get_percentile(const apr_array_header_t *latencies,
+               int percentile)
+{
+  int idx = (int)(((apr_int64_t)latencies->nelts * percentile + 99) / 100);
+  idx = MAX(idx, 1) - 1;
+
+  return APR_ARRAY_IDX(latencies, idx, apr_interval_time_t) / 1.0e3;
+}
+
+/* Print the latency distribution and cache usage of BENCH,
+   describing each operation as OPERATION.  Use POOL for temporary
+   allocations. */
+static svn_error_t *
+print_results(fs_bench_t *bench,
+              const char *operation,
+              apr_pool_t *pool)
+{
+  svn_cache__info_t cache_after;
+  apr_uint64_t gets, hits;
+
+  if (bench->opt_state->quiet)
+    return SVN_NO_ERROR;
+
+  get_cache_info(&cache_after, pool);
+  gets = cache_after.gets - bench->cache_before.gets;
+  hits = cache_after.hits - bench->cache_before.hits;
+
+  SVN_ERR(svn_cmdline_printf(pool, "%15s %s\n",
+                             svn__ui64toa_sep(bench->latencies->nelts, ',',
+                                              pool),
+                             operation));
+
+  if (bench->latencies->nelts)
+    {
+      qsort(bench->latencies->elts, bench->latencies->nelts,
+            bench->latencies->elt_size, compare_latencies);
+
+      SVN_ERR(svn_cmdline_printf(pool,
+                                 _("%15.3f ms median latency\n"
+                                   "%15.3f ms 90th percentile latency\n"
+                                   "%15.3f ms 99th percentile latency\n"
+                                   "%15.3f ms maximum latency\n"),
+                                 get_percentile(bench->latencies, 50),
+                                 get_percentile(bench->latencies, 90),
+                                 get_percentile(bench->latencies, 99),
+                                 get_percentile(bench->latencies, 100)));
+    }
+
+  SVN_ERR(svn_cmdline_printf(pool, _("%15s cache lookups\n"),
+                             svn__ui64toa_sep(gets, ',', pool)));
+  if (gets)
+    SVN_ERR(svn_cmdline_printf(pool, _("%14.1f%% cache hit rate\n"),
+                               100.0 * hits / gets));
+
+  return SVN_NO_ERROR;
+}
+
+/* Add all files and directories at or below PATH in ROOT to FILES and
+   DIRS, respectively, if those are not NULL.  If BENCH is not NULL, add
+   a latency sample for each directory listing to it.  Allocate the paths
+   in RESULT_POOL and use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+walk_tree(apr_array_header_t *files,
+          apr_array_header_t *dirs,
+          fs_bench_t *bench,
+          svn_fs_root_t *root,
+          const char *path,
+          apr_pool_t *result_pool,
+          apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  apr_array_header_t *sorted;
+  apr_hash_t *entries;
+  svn_node_kind_t kind;
+  apr_time_t start;
+  int i;
+
+  SVN_ERR(svn_fs_check_path(&kind, root, path, scratch_pool));
+  if (kind == svn_node_none)
+    return svn_error_createf(SVN_ERR_FS_NOT_FOUND, NULL,
+                             _("Path '%s' does not exist"), path);
+
+  if (kind == svn_node_file)
+    {
+      if (files)
+        APR_ARRAY_PUSH(files, const char *) = apr_pstrdup(result_pool, path);
+      return SVN_NO_ERROR;
+    }
+
+  if (dirs)
+    APR_ARRAY_PUSH(dirs, const char *) = apr_pstrdup(result_pool, path);
+
+  start = apr_time_now();
+  SVN_ERR(svn_fs_dir_entries(&entries, root, path, scratch_pool));
+  if (bench)
+    add_sample(bench, start);
+
+  /* Walk in a reproducible order. */
+  sorted = svn_sort__hash(entries, svn_sort_compare_items_lexically,
+                          scratch_pool);
+  for (i = 0; i < sorted->nelts; ++i)
+    {
+      const svn_sort__item_t *item = &APR_ARRAY_IDX(sorted, i,
+                                                    svn_sort__item_t);
+      svn_fs_dirent_t *dirent = item->value;
+      const char *sub_path;
+
+      svn_pool_clear(iterpool);
+      if (svn_cl__check_cancel)
+        SVN_ERR(svn_cl__check_cancel(NULL));
+
+      sub_path = svn_fspath__join(path, dirent->name, iterpool);
+      if (dirent->kind == svn_node_file)
+        {
+          if (files)
+            APR_ARRAY_PUSH(files, const char *)
+              = apr_pstrdup(result_pool, sub_path);
+        }
+      else
+        {
+          SVN_ERR(walk_tree(files, dirs, bench, root, sub_path,
+                            result_pool, iterpool));
+        }
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Return a pseudo-random number in [0, LIMIT) based on *STATE.
+   We use a fixed sequence to make runs reproducible. */
+static int
+next_random(apr_uint32_t *state,
+            int limit)
+{
+  *state = *state * 1103515245 + 12345;
+  return (int)((*state >> 8) % (apr_uint32_t)limit);
+}
+
+
+/*** Subcommands. ***/
+
+/* This implements the `svn_opt_subcommand_t' interface. */
+svn_error_t *
+svn_cl__fs_cat(apr_getopt_t *os,
+               void *baton,
+               apr_pool_t *pool)
+{
+  svn_cl__opt_state_t *opt_state = ((svn_cl__cmd_baton_t *) baton)->opt_state;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  fs_bench_t *bench;
+  svn_fs_root_t *root;
+  svn_revnum_t rev;
+  apr_array_header_t *files = apr_array_make(pool, 1024, sizeof(const char *));
+  apr_uint32_t random_state = 0;
+  apr_uint64_t bytes = 0;
+  char *buffer = apr_palloc(pool, SVN__STREAM_CHUNK_SIZE);
+  int count;
+  int i;
+
+  SVN_ERR(open_bench(&bench, os, opt_state, pool));
+  SVN_ERR(resolve_revision(&rev, &opt_state->start_revision, bench, pool));
+  SVN_ERR(svn_fs_revision_root(&root, bench->fs, rev, pool));
+
+  for (i = 0; i < bench->paths->nelts; ++i)
+    SVN_ERR(walk_tree(files, NULL, NULL, root,
+                      APR_ARRAY_IDX(bench->paths, i, const char *),
+                      pool, iterpool));
+
+  if (files->nelts == 0)
+    return svn_error_create(SVN_ERR_FS_NOT_FILE, NULL,
+                            _("No files found to read"));
+
+  /* Read as many randomly chosen files as requested, defaulting to as
+     many as there are. */
+  count = opt_state->limit ? opt_state->limit : files->nelts;
+
+  start_measurement(bench, pool);
+  for (i = 0; i < count; ++i)
+    {
+      const char *path = APR_ARRAY_IDX(files,
+                                       next_random(&random_state,
+                                                   files->nelts),
+                                       const char *);
+      svn_stream_t *contents;
+      apr_size_t len;
+      apr_time_t start;
+
+      svn_pool_clear(iterpool);
+      if (svn_cl__check_cancel)
+        SVN_ERR(svn_cl__check_cancel(NULL));
+
+      start = apr_time_now();
+      SVN_ERR(svn_fs_file_contents(&contents, root, path, iterpool));
+      do
+        {
+          len = SVN__STREAM_CHUNK_SIZE;
+          SVN_ERR(svn_stream_read_full(contents, buffer, &len));
+          bytes += len;
+        }
+      while (len == SVN__STREAM_CHUNK_SIZE);
+      add_sample(bench, start);
+    }
+
+  svn_pool_destroy(iterpool);
+
+  SVN_ERR(print_results(bench, _("file reads"), pool));
+  if (!opt_state->quiet)
+    SVN_ERR(svn_cmdline_printf(pool, _("%15s bytes read\n"),
+                               svn__ui64toa_sep(bytes, ',', pool)));
+
+  return SVN_NO_ERROR;
+}
+
+/* This implements the `svn_opt_subcommand_t' interface. */
+svn_error_t *
+svn_cl__fs_list(apr_getopt_t *os,
+                void *baton,
+                apr_pool_t *pool)
+{
+  svn_cl__opt_state_t *opt_state = ((svn_cl__cmd_baton_t *) baton)->opt_state;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  fs_bench_t *bench;
+  svn_fs_root_t *root;
+  svn_revnum_t rev;
+  int i;
+
+  SVN_ERR(open_bench(&bench, os, opt_state, pool));
+  SVN_ERR(resolve_revision(&rev, &opt_state->start_revision, bench, pool));
+  SVN_ERR(svn_fs_revision_root(&root, bench->fs, rev, pool));
+
+  /* Time the directory listings as we walk the tree for the first time
+     such that caching effects become visible in the results. */
+  start_measurement(bench, pool);
+  for (i = 0; i < bench->paths->nelts; ++i)
+    {
+      svn_pool_clear(iterpool);
+      SVN_ERR(walk_tree(NULL, NULL, bench, root,
+                        APR_ARRAY_IDX(bench->paths, i, const char *),
+                        iterpool, iterpool));
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return svn_error_trace(print_results(bench, _("directory listings"),
+                                       pool));
+}
+
+/* This implements the `svn_opt_subcommand_t' interface. */
+svn_error_t *
+svn_cl__fs_history(apr_getopt_t *os,
+                   void *baton,
+                   apr_pool_t *pool)
+{
+  svn_cl__opt_state_t *opt_state = ((svn_cl__cmd_baton_t *) baton)->opt_state;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  fs_bench_t *bench;
+  svn_fs_root_t *root;
+  svn_revnum_t rev;
+  int i;
+
+  SVN_ERR(open_bench(&bench, os, opt_state, pool));
+  SVN_ERR(resolve_revision(&rev, &opt_state->start_revision, bench, pool));
+  SVN_ERR(svn_fs_revision_root(&root, bench->fs, rev, pool));
+
+  start_measurement(bench, pool);
+  for (i = 0; i < bench->paths->nelts; ++i)
+    {
+      const char *path = APR_ARRAY_IDX(bench->paths, i, const char *);
+      apr_pool_t *history_pool = svn_pool_create(iterpool);
+      svn_fs_history_t *history;
+      int steps = 0;
+
+      SVN_ERR(svn_fs_node_history2(&history, root, path, history_pool,
+                                   iterpool));
+      while (history && (!opt_state->limit || steps < opt_state->limit))
+        {
+          svn_fs_history_t *prev;
+          apr_pool_t *prev_pool = svn_pool_create(iterpool);
+          apr_time_t start;
+
+          if (svn_cl__check_cancel)
+            SVN_ERR(svn_cl__check_cancel(NULL));
+
+          start = apr_time_now();
+          SVN_ERR(svn_fs_history_prev2(&prev, history,
+                                       !opt_state->stop_on_copy,
+                                       prev_pool, prev_pool));
+          if (prev)
+            {
+              const char *history_path;
+              svn_revnum_t history_rev;
+
+              SVN_ERR(svn_fs_history_location(&history_path, &history_rev,
+                                              prev, prev_pool));
+              add_sample(bench, start);
+            }
+
+          /* Keep only the latest history object around. */
+          svn_pool_destroy(history_pool);
+          history_pool = prev_pool;
+          history = prev;
+          ++steps;
+        }
+
+      svn_pool_clear(iterpool);
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return svn_error_trace(print_results(bench, _("history steps"), pool));
+}
+
+/* This implements the `svn_opt_subcommand_t' interface. */
+svn_error_t *
+svn_cl__fs_changes(apr_getopt_t *os,
+                   void *baton,
+                   apr_pool_t *pool)
+{
+  svn_cl__opt_state_t *opt_state = ((svn_cl__cmd_baton_t *) baton)->opt_state;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  fs_bench_t *bench;
+  svn_revnum_t start_rev, end_rev, rev;
+  apr_uint64_t changes = 0;
+
+  SVN_ERR(open_bench(&bench, os, opt_state, pool));
+  if (bench->paths->nelts > 1
+      || strcmp(APR_ARRAY_IDX(bench->paths, 0, const char *), "/"))
+    return svn_error_create(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
+                            _("'fs-changes' does not accept any paths"));
+
+  /* Default to all revisions. */
+  if (opt_state->start_revision.kind == svn_opt_revision_unspecified)
+    start_rev = 1;
+  else
+    SVN_ERR(resolve_revision(&start_rev, &opt_state->start_revision, bench,
+                             pool));
+
+  SVN_ERR(resolve_revision(&end_rev, &opt_state->end_revision, bench,
+                           pool));
+  if (start_rev > end_rev)
+    {
+      rev = start_rev;
+      start_rev = end_rev;
+      end_rev = rev;
+    }
+
+  start_measurement(bench, pool);
+  for (rev = start_rev; rev <= end_rev; ++rev)
+    {
+      svn_fs_root_t *root;
+      svn_fs_path_change_iterator_t *iterator;
+      svn_fs_path_change3_t *change;
+      apr_time_t start;
+
+      svn_pool_clear(iterpool);
+      if (svn_cl__check_cancel)
+        SVN_ERR(svn_cl__check_cancel(NULL));
+
+      start = apr_time_now();
+      SVN_ERR(svn_fs_revision_root(&root, bench->fs, rev, iterpool));
+      SVN_ERR(svn_fs_paths_changed3(&iterator, root, iterpool, iterpool));
+      SVN_ERR(svn_fs_path_change_get(&change, iterator));
+      while (change)
+        {
+          ++changes;
+          SVN_ERR(svn_fs_path_change_get(&change, iterator));
+        }
+      add_sample(bench, start);
+    }
+
+  svn_pool_destroy(iterpool);
+
+  SVN_ERR(print_results(bench, _("revisions scanned"), pool));
+  if (!opt_state->quiet)
+    SVN_ERR(svn_cmdline_printf(pool, _("%15s changed paths\n"),
+                               svn__ui64toa_sep(changes, ',', pool)));
+
+  return SVN_NO_ERROR;
+}
+
+/* This implements the `svn_opt_subcommand_t' interface. */
+svn_error_t *
+svn_cl__fs_commit(apr_getopt_t *os,
+                  void *baton,
+                  apr_pool_t *pool)
+{
+  svn_cl__opt_state_t *opt_state = ((svn_cl__cmd_baton_t *) baton)->opt_state;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  const svn_string_t *log_msg = svn_string_create("svnbench fs-commit",
+                                                  pool);
+  fs_bench_t *bench;
+  const char *parent;
+  int count = opt_state->limit ? opt_state->limit : 100;
+  int i;
+
+  SVN_ERR(open_bench(&bench, os, opt_state, pool));
+  if (bench->paths->nelts > 1)
+    return svn_error_create(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
+                            _("'fs-commit' accepts at most one path"));
+
+  parent = APR_ARRAY_IDX(bench->paths, 0, const char *);
+  if (svn_fspath__is_root(parent, strlen(parent)))
+    parent = "/svnbench-commit";
+
+  start_measurement(bench, pool);
+  for (i = 0; i < count; ++i)
+    {
+      svn_fs_txn_t *txn;
+      svn_fs_root_t *txn_root;
+      svn_node_kind_t kind;
+      svn_stream_t *contents;
+      svn_revnum_t youngest, new_rev;
+      const char *conflict;
+      const char *path;
+      apr_time_t start;
+
+      svn_pool_clear(iterpool);
+      if (svn_cl__check_cancel)
+        SVN_ERR(svn_cl__check_cancel(NULL));
+
+      /* Cycle through a small set of files such that we get a mix of
+         additions and modifications. */
+      path = svn_fspath__join(parent,
+                              apr_psprintf(iterpool, "file-%d", i % 16),
+                              iterpool);
+
+      start = apr_time_now();
+      SVN_ERR(svn_fs_youngest_rev(&youngest, bench->fs, iterpool));
+      SVN_ERR(svn_fs_begin_txn2(&txn, bench->fs, youngest, 0, iterpool));
+      SVN_ERR(svn_fs_change_txn_prop(txn, SVN_PROP_REVISION_LOG, log_msg,
+                                     iterpool));
+      SVN_ERR(svn_fs_txn_root(&txn_root, txn, iterpool));
+
+      SVN_ERR(svn_fs_check_path(&kind, txn_root, parent, iterpool));
+      if (kind == svn_node_none)
+        SVN_ERR(svn_fs_make_dir(txn_root, parent, iterpool));
+
+      SVN_ERR(svn_fs_check_path(&kind, txn_root, path, iterpool));
+      if (kind == svn_node_none)
+        SVN_ERR(svn_fs_make_file(txn_root, path, iterpool));
+
+      SVN_ERR(svn_fs_apply_text(&contents, txn_root, path, NULL, iterpool));
+      SVN_ERR(svn_stream_printf(contents, iterpool,
+                                "svnbench fs-commit %d\n", i));
+      SVN_ERR(svn_stream_close(contents));
+
+      SVN_ERR(svn_fs_commit_txn(&conflict, &new_rev, txn, iterpool));
+      if (!SVN_IS_VALID_REVNUM(new_rev))
+        return svn_error_createf(SVN_ERR_FS_CONFLICT, NULL,
+                                 _("Conflict at '%s'"), conflict);
+      add_sample(bench, start);
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return svn_error_trace(print_results(bench, _("revisions committed"),
+                                       pool));
+}
@@ -152,9 +152,9 @@ svn_cl__null_list(apr_getopt_t *os,
             }
         }
 
-      err = svn_client_list4(truepath, &peg_revision,
+      err = svn_client_list5(truepath, &peg_revision,
                              &(opt_state->start_revision), patterns,
-                             opt_state->depth,
+                             opt_state->depth, SVN_INVALID_REVNUM,
                              dirent_fields,
                              opt_state->verbose,
                              FALSE, /* include externals */
@@ -0,0 +1,415 @@
+/*
+ * null-update-cmd.c -- Subversion null-update, null-status and null-diff
+ *                      commands
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+/* ==================================================================== */
+
+
+
+/*** Includes. ***/
+
+#include "svn_client.h"
+#include "svn_error.h"
+#include "svn_path.h"
+#include "svn_cmdline.h"
+#include "cl.h"
+
+#include "svn_private_config.h"
+#include "private/svn_string_private.h"
+#include "private/svn_client_private.h"
+
+/*** The counting editor. ***/
+
+/* The operation to benchmark. */
+typedef enum null_op_t
+{
+  null_op_update,
+  null_op_status,
+  null_op_diff
+} null_op_t;
+
+/* Used as edit, directory and file baton alike. */
+typedef struct edit_baton_t
+{
+  apr_int64_t file_count;
+  apr_int64_t dir_count;
+  apr_int64_t delete_count;
+  apr_int64_t byte_count;
+  apr_int64_t prop_count;
+  apr_int64_t prop_byte_count;
+} edit_baton_t;
+
+static svn_error_t *
+open_root(void *edit_baton,
+          svn_revnum_t base_revision,
+          apr_pool_t *pool,
+          void **root_baton)
+{
+  *root_baton = edit_baton;
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+delete_entry(const char *path,
+             svn_revnum_t revision,
+             void *parent_baton,
+             apr_pool_t *pool)
+{
+  edit_baton_t *eb = parent_baton;
+  eb->delete_count++;
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+add_directory(const char *path,
+              void *parent_baton,
+              const char *copyfrom_path,
+              svn_revnum_t copyfrom_revision,
+              apr_pool_t *pool,
+              void **baton)
+{
+  edit_baton_t *eb = parent_baton;
+  eb->dir_count++;
+
+  *baton = parent_baton;
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+open_directory(const char *path,
+               void *parent_baton,
+               svn_revnum_t base_revision,
+               apr_pool_t *pool,
+               void **baton)
+{
+  edit_baton_t *eb = parent_baton;
+  eb->dir_count++;
+
+  *baton = parent_baton;
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+add_file(const char *path,
+         void *parent_baton,
+         const char *copyfrom_path,
+         svn_revnum_t copyfrom_revision,
+         apr_pool_t *pool,
+         void **baton)
+{
+  edit_baton_t *eb = parent_baton;
+  eb->file_count++;
+
+  *baton = parent_baton;
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+open_file(const char *path,
+          void *parent_baton,
+          svn_revnum_t base_revision,
+          apr_pool_t *pool,
+          void **baton)
+{
+  edit_baton_t *eb = parent_baton;
+  eb->file_count++;
+
+  *baton = parent_baton;
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+window_handler(svn_txdelta_window_t *window, void *baton)
+{
+  edit_baton_t *eb = baton;
+  if (window != NULL)
+    eb->byte_count += window->tview_len;
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+apply_textdelta(void *file_baton,
+                const char *base_checksum,
+                apr_pool_t *pool,
+                svn_txdelta_window_handler_t *handler,
+                void **handler_baton)
+{
+  *handler_baton = file_baton;
+  *handler = window_handler;
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+change_prop(void *baton,
+            const char *name,
+            const svn_string_t *value,
+            apr_pool_t *pool)
+{
+  edit_baton_t *eb = baton;
+  eb->prop_count++;
+  if (value)
+    eb->prop_byte_count += value->len;
+
+  return SVN_NO_ERROR;
+}
+
+/*** Public Interfaces ***/
+
+/* Drive the OP for FROM_PATH_OR_URL at PEG_REVISION against our counting
+ * editor in EB.  Report the tree as it exists in BASE_REVISION or, if that
+ * is unspecified, as empty.  The tree is updated to / compared with
+ * REVISION.  Set *ELAPSED to the time it took to send the report and
+ * receive the editor drive.  Use POOL for allocations.
+ */
+static svn_error_t *
+bench_null_op(apr_interval_time_t *elapsed,
+              null_op_t op,
+              const char *from_path_or_url,
+              svn_opt_revision_t *peg_revision,
+              const svn_opt_revision_t *base_revision,
+              svn_opt_revision_t *revision,
+              svn_depth_t depth,
+              edit_baton_t *eb,
+              svn_client_ctx_t *ctx,
+              apr_pool_t *pool)
+{
+  svn_client__pathrev_t *loc;
+  svn_ra_session_t *ra_session;
+  svn_node_kind_t kind;
+  svn_revnum_t base_rev = SVN_INVALID_REVNUM;
+  const svn_ra_reporter3_t *reporter;
+  void *report_baton;
+  const svn_delta_editor_t *null_editor;
+  void *edit_baton;
+  apr_time_t start;
+  svn_delta_editor_t *editor = svn_delta_default_editor(pool);
+
+  if (peg_revision->kind == svn_opt_revision_unspecified)
+    peg_revision->kind = svn_path_is_url(from_path_or_url)
+                       ? svn_opt_revision_head
+                       : svn_opt_revision_working;
+
+  if (revision->kind == svn_opt_revision_unspecified)
+    revision->kind = svn_opt_revision_head;
+
+  /* Get the RA connection. */
+  SVN_ERR(svn_client__ra_session_from_path2(&ra_session, &loc,
+                                            from_path_or_url, NULL,
+                                            peg_revision, revision,
+                                            ctx, pool));
+
+  SVN_ERR(svn_ra_check_path(ra_session, "", loc->rev, &kind, pool));
+  if (kind == svn_node_none)
+    return svn_error_createf(SVN_ERR_RA_ILLEGAL_URL, NULL,
+                             _("URL '%s' doesn't exist"), from_path_or_url);
+  if (kind != svn_node_dir)
+    return svn_error_createf(SVN_ERR_FS_NOT_DIRECTORY, NULL,
+                             _("URL '%s' is not a directory"),
+                             from_path_or_url);
+
+  if (base_revision->kind != svn_opt_revision_unspecified)
+    SVN_ERR(svn_client__get_revision_number(&base_rev, NULL, ctx->wc_ctx,
+                                            NULL, ra_session, base_revision,
+                                            pool));
+
+  editor->open_root = open_root;
+  editor->delete_entry = delete_entry;
+  editor->add_directory = add_directory;
+  editor->open_directory = open_directory;
+  editor->change_dir_prop = change_prop;
+  editor->add_file = add_file;
+  editor->open_file = open_file;
+  editor->apply_textdelta = apply_textdelta;
+  editor->change_file_prop = change_prop;
+
+  SVN_ERR(svn_delta_get_cancellation_editor(ctx->cancel_func,
+                                            ctx->cancel_baton,
+                                            editor, eb,
+                                            &null_editor, &edit_baton,
+                                            pool));
+
+  start = apr_time_now();
+  switch (op)
+    {
+      case null_op_update:
+        SVN_ERR(svn_ra_do_update3(ra_session, &reporter, &report_baton,
+                                  loc->rev, "", depth,
+                                  FALSE, /* don't want copyfrom-args */
+                                  FALSE, /* don't want ignore_ancestry */
+                                  null_editor, edit_baton, pool, pool));
+        break;
+
+      case null_op_status:
+        SVN_ERR(svn_ra_do_status2(ra_session, &reporter, &report_baton,
+                                  "", loc->rev, depth,
+                                  null_editor, edit_baton, pool));
+        break;
+
+      case null_op_diff:
+        SVN_ERR(svn_ra_do_diff3(ra_session, &reporter, &report_baton,
+                                loc->rev, "", depth,
+                                TRUE, /* ignore ancestry */
+                                TRUE, /* text deltas */
+                                loc->url, null_editor, edit_baton, pool));
+        break;
+    }
+
+  /* Manufacture a report that claims the whole tree to be at BASE_REV,
+   * or an empty directory if there is no BASE_REV. */
+  if (SVN_IS_VALID_REVNUM(base_rev))
+    SVN_ERR(reporter->set_path(report_baton, "", base_rev, depth,
+                               FALSE, NULL, pool));
+  else
+    SVN_ERR(reporter->set_path(report_baton, "", loc->rev,
+                               /* Depth is irrelevant, as we're
+                                  passing start_empty=TRUE anyway. */
+                               svn_depth_infinity,
+                               TRUE, /* "help, my dir is empty!" */
+                               NULL, pool));
+
+  SVN_ERR(reporter->finish_report(report_baton, pool));
+  *elapsed = apr_time_now() - start;
+
+  return SVN_NO_ERROR;
+}
+
+/* Return VALUE per second of ELAPSED time as a string allocated in POOL. */
+static const char *
+per_second(apr_int64_t value,
+           apr_interval_time_t elapsed,
+           apr_pool_t *pool)
+{
+  apr_uint64_t rate = elapsed > 0
+                    ? (apr_uint64_t)(value * (double)APR_USEC_PER_SEC
+                                     / elapsed)
+                    : 0;
+
+  return svn__ui64toa_sep(rate, ',', pool);
+}
+
+/* Parse the command line for OP, run it and print the statistics.
+ * OS, BATON and POOL are as for svn_opt_subcommand_t.
+ */
+static svn_error_t *
+run_null_op(null_op_t op,
+            apr_getopt_t *os,
+            void *baton,
+            apr_pool_t *pool)
+{
+  svn_cl__opt_state_t *opt_state = ((svn_cl__cmd_baton_t *) baton)->opt_state;
+  svn_client_ctx_t *ctx = ((svn_cl__cmd_baton_t *) baton)->ctx;
+  apr_array_header_t *targets;
+  svn_opt_revision_t peg_revision;
+  svn_opt_revision_t base_revision, revision;
+  const char *truefrom;
+  apr_interval_time_t elapsed = 0;
+  apr_int64_t node_count;
+  svn_error_t *err;
+  edit_baton_t eb = { 0 };
+
+  SVN_ERR(svn_cl__args_to_target_array_print_reserved(&targets, os,
+                                                      opt_state->targets,
+                                                      ctx, FALSE, pool));
+
+  /* We want exactly 1 target for this subcommand. */
+  if (targets->nelts < 1)
+    return svn_error_create(SVN_ERR_CL_INSUFFICIENT_ARGS, 0, NULL);
+  if (targets->nelts > 1)
+    return svn_error_create(SVN_ERR_CL_ARG_PARSING_ERROR, 0, NULL);
+
+  /* Get the peg revision if present. */
+  SVN_ERR(svn_opt_parse_path(&peg_revision, &truefrom,
+                             APR_ARRAY_IDX(targets, 0, const char *),
+                             pool));
+
+  /* -r N compares an empty tree with N, -r M:N compares M with N. */
+  if (opt_state->end_revision.kind == svn_opt_revision_unspecified)
+    {
+      base_revision.kind = svn_opt_revision_unspecified;
+      revision = opt_state->start_revision;
+    }
+  else
+    {
+      base_revision = opt_state->start_revision;
+      revision = opt_state->end_revision;
+    }
+
+  if (opt_state->depth == svn_depth_unknown)
+    opt_state->depth = svn_depth_infinity;
+
+  err = bench_null_op(&elapsed, op, truefrom, &peg_revision,
+                      &base_revision, &revision, opt_state->depth, &eb,
+                      ctx, pool);
+
+  node_count = eb.dir_count + eb.file_count + eb.delete_count;
+  if (!opt_state->quiet)
+    SVN_ERR(svn_cmdline_printf(pool,
+                               _("%15s directories\n"
+                                 "%15s files\n"
+                                 "%15s deleted entries\n"
+                                 "%15s bytes in files\n"
+                                 "%15s properties\n"
+                                 "%15s bytes in properties\n"
+                                 "%15s nodes per second\n"
+                                 "%15s bytes per second\n"),
+                               svn__ui64toa_sep(eb.dir_count, ',', pool),
+                               svn__ui64toa_sep(eb.file_count, ',', pool),
+                               svn__ui64toa_sep(eb.delete_count, ',', pool),
+                               svn__ui64toa_sep(eb.byte_count, ',', pool),
+                               svn__ui64toa_sep(eb.prop_count, ',', pool),
+                               svn__ui64toa_sep(eb.prop_byte_count, ',', pool),
+                               per_second(node_count, elapsed, pool),
+                               per_second(eb.byte_count, elapsed, pool)));
+
+  return svn_error_trace(err);
+}
+
+/* This implements the `svn_opt_subcommand_t' interface. */
+svn_error_t *
+svn_cl__null_update(apr_getopt_t *os,
+                    void *baton,
+                    apr_pool_t *pool)
+{
+  return svn_error_trace(run_null_op(null_op_update, os, baton, pool));
+}
+
+/* This implements the `svn_opt_subcommand_t' interface. */
+svn_error_t *
+svn_cl__null_status(apr_getopt_t *os,
+                    void *baton,
+                    apr_pool_t *pool)
+{
+  return svn_error_trace(run_null_op(null_op_status, os, baton, pool));
+}
+
+/* This implements the `svn_opt_subcommand_t' interface. */
+svn_error_t *
+svn_cl__null_diff(apr_getopt_t *os,
+                  void *baton,
+                  apr_pool_t *pool)
+{
+  return svn_error_trace(run_null_op(null_op_diff, os, baton, pool));
+}
@@ -32,7 +32,10 @@
 
 #include "svn_cmdline.h"
 #include "svn_dirent_uri.h"
+#include "svn_cache_config.h"
+#include "svn_fs.h"
 #include "svn_pools.h"
+#include "svn_repos.h"
 #include "svn_utf.h"
 #include "svn_version.h"
 
@@ -70,7 +73,8 @@ typedef enum svn_cl__longopt_t {
   opt_trust_server_cert,
   opt_trust_server_cert_failures,
   opt_changelist,
-  opt_search
+  opt_search,
+  opt_cache_size
 } svn_cl__longopt_t;
 
 
@@ -171,6 +175,10 @@ const apr_getopt_option_t svn_cl__options[] =
                        "history")},
   {"search", opt_search, 1,
                        N_("use ARG as search pattern (glob syntax)")},
+  {"memory-cache-size", opt_cache_size, 1,
+                    N_("size of the in-memory cache in MiB used for\n"
+                       "                             "
+                       "fs-* subcommands (default: 16)")},
 
   /* Long-opt Aliases
    *
@@ -215,6 +223,70 @@ const svn_opt_subcommand_desc3_t svn_cl__cmd_table[] =
     {0} },
   /* This command is also invoked if we see option "--help", "-h" or "-?". */
 
+  { "fs-cat", svn_cl__fs_cat, {0}, {N_(
+     "Read file contents directly from a local repository.\n"
+     "usage: fs-cat [-r REV] [-l COUNT] REPOS_PATH [PATH...]\n"
+     "\n"), N_(
+     "  Read COUNT randomly chosen files (default: all) at or below the\n"
+     "  repository PATHs (default: '/') in revision REV (default: HEAD)\n"
+     "  through the filesystem layer.  The random sequence is the same for\n"
+     "  every run.\n"
+     "\n"), N_(
+     "  Report the latency distribution of the file reads and the hit rate\n"
+     "  of the process-wide cache.\n"
+    )},
+    {'r', 'l', 'q', opt_cache_size},
+    {{'l', N_("number of files to read")}} },
+
+  { "fs-changes", svn_cl__fs_changes, {0}, {N_(
+     "Fetch the changed paths lists directly from a local repository.\n"
+     "usage: fs-changes [-r M[:N]] REPOS_PATH\n"
+     "\n"), N_(
+     "  Retrieve the list of changed paths for every revision in M:N\n"
+     "  (default: 1:HEAD) through the filesystem layer and report the\n"
+     "  latency distribution and cache hit rate.\n"
+    )},
+    {'r', 'q', opt_cache_size} },
+
+  { "fs-commit", svn_cl__fs_commit, {0}, {N_(
+     "Commit directly to a local repository.\n"
+     "usage: fs-commit [-l COUNT] REPOS_PATH [PATH]\n"
+     "\n"), N_(
+     "  Commit COUNT (default: 100) new revisions through the filesystem\n"
+     "  layer, each one adding or modifying a file in the repository\n"
+     "  directory PATH (default: '/svnbench-commit').  No hooks are run.\n"
+     "\n"), N_(
+     "  Report the latency distribution of the commits and the hit rate\n"
+     "  of the process-wide cache.\n"
+     "\n"), N_(
+     "  WARNING: This permanently adds revisions to the repository.\n"
+    )},
+    {'l', 'q', opt_cache_size},
+    {{'l', N_("number of revisions to commit")}} },
+
+  { "fs-history", svn_cl__fs_history, {0}, {N_(
+     "Walk node histories directly in a local repository.\n"
+     "usage: fs-history [-r REV] [-l COUNT] REPOS_PATH [PATH...]\n"
+     "\n"), N_(
+     "  Trace the history of each repository PATH (default: '/') back from\n"
+     "  revision REV (default: HEAD) through the filesystem layer, taking\n"
+     "  at most COUNT steps per PATH.  Report the latency distribution of\n"
+     "  the history steps and the cache hit rate.\n"
+    )},
+    {'r', 'l', 'q', opt_stop_on_copy, opt_cache_size},
+    {{'l', N_("maximum number of history steps per path")}} },
+
+  { "fs-list", svn_cl__fs_list, {0}, {N_(
+     "List directories directly in a local repository.\n"
+     "usage: fs-list [-r REV] REPOS_PATH [PATH...]\n"
+     "\n"), N_(
+     "  List every directory at or below the repository PATHs (default:\n"
+     "  '/') in revision REV (default: HEAD) through the filesystem layer.\n"
+     "  Report the latency distribution of the listings and the cache hit\n"
+     "  rate.\n"
+    )},
+    {'r', 'q', opt_cache_size} },
+
   { "null-blame", svn_cl__null_blame, {0}, {N_(
      "Fetch all versions of a file in a batch.\n"
      "usage: null-blame [-rM:N] TARGET[@REV]...\n"
@@ -236,6 +308,20 @@ const svn_opt_subcommand_desc3_t svn_cl__cmd_table[] =
     )},
     {'r', 'g'} },
 
+  { "null-diff", svn_cl__null_diff, {0}, {N_(
+     "Receive the differences between two revisions of a tree.\n"
+     "usage: null-diff [-r [M:]N] URL[@PEGREV]\n"
+     "\n"), N_(
+     "  Reports URL as being at revision M and receives the changes up to\n"
+     "  revision N including all text deltas, like 'svn diff -r M:N URL'\n"
+     "  does.  Without M, everything in N is reported as added.  N defaults\n"
+     "  to HEAD.  Nothing gets written to disk.\n"
+     "\n"), N_(
+     "  If specified, PEGREV determines in which revision the target is first\n"
+     "  looked up.\n"
+    )},
+    {'r', 'q', opt_depth} },
+
   { "null-export", svn_cl__null_export, {0}, {N_(
      "Create an unversioned copy of a tree.\n"
      "usage: null-export [-r REV] URL[@PEGREV]\n"
@@ -305,6 +391,34 @@ const svn_opt_subcommand_desc3_t svn_cl__cmd_table[] =
     {{opt_with_revprop, N_("retrieve revision property ARG")},
      {'c', N_("the change made in revision ARG")}} },
 
+  { "null-status", svn_cl__null_status, {0}, {N_(
+     "Receive the out-of-date information for a tree.\n"
+     "usage: null-status [-r [M:]N] URL[@PEGREV]\n"
+     "\n"), N_(
+     "  Reports URL as being at revision M and receives the list of items\n"
+     "  changed up to revision N, like 'svn status -u' does for a working\n"
+     "  copy at M.  Without M, everything in N is reported as added.  N\n"
+     "  defaults to HEAD.\n"
+     "\n"), N_(
+     "  If specified, PEGREV determines in which revision the target is first\n"
+     "  looked up.\n"
+    )},
+    {'r', 'q', opt_depth} },
+
+  { "null-update", svn_cl__null_update, {0}, {N_(
+     "Receive an update for a tree.\n"
+     "usage: null-update [-r [M:]N] URL[@PEGREV]\n"
+     "\n"), N_(
+     "  Reports URL as being at revision M and receives the editor drive\n"
+     "  that would update a working copy to revision N.  Without M, an\n"
+     "  empty directory is reported, i.e. this is a checkout of N.  N\n"
+     "  defaults to HEAD.  Nothing gets written to disk.\n"
+     "\n"), N_(
+     "  If specified, PEGREV determines in which revision the target is first\n"
+     "  looked up.\n"
+    )},
+    {'r', 'q', opt_depth} },
+
   { "null-info", svn_cl__null_info, {0}, {N_(
      "Display information about a local or remote item.\n"
      "usage: null-info [TARGET[@REV]...]\n"
@@ -330,6 +444,8 @@ check_lib_versions(void)
       { "svn_client", svn_client_version },
       { "svn_wc",     svn_wc_version },
       { "svn_ra",     svn_ra_version },
+      { "svn_repos",  svn_repos_version },
+      { "svn_fs",     svn_fs_version },
       { "svn_delta",  svn_delta_version },
       { NULL, NULL }
     };
@@ -405,6 +521,7 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
   ra_progress_baton_t ra_progress_baton = {0};
   svn_membuf_t buf;
   svn_boolean_t read_pass_from_stdin = FALSE;
+  svn_cache_config_t settings = *svn_cache_config_get();
 
   received_opts = apr_array_make(pool, SVN_OPT_MAX_OPTIONS, sizeof(int));
 
@@ -696,6 +813,15 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
       case 'g':
         opt_state.use_merge_history = TRUE;
         break;
+      case opt_cache_size:
+        {
+          apr_uint64_t size;
+
+          SVN_ERR(svn_cstring_atoui64(&size, opt_arg));
+          settings.cache_size = size * 0x100000;
+          svn_cache_config_set(&settings);
+        }
+        break;
       case opt_search:
         SVN_ERR(svn_utf_cstring_to_utf8(&utf8_opt_arg, opt_arg, pool));
         SVN_ERR(svn_utf__xfrm(&utf8_opt_arg, utf8_opt_arg,
@@ -887,7 +1013,8 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
   /* Only a few commands can accept a revision range; the rest can take at
      most one revision number. */
   if (subcommand->cmd_func != svn_cl__null_blame
-      && subcommand->cmd_func != svn_cl__null_log)
+      && subcommand->cmd_func != svn_cl__null_log
+      && subcommand->cmd_func != svn_cl__fs_changes)
     {
       if (opt_state.end_revision.kind != svn_opt_revision_unspecified)
         {
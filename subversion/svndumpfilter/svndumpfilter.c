@@ -199,6 +199,10 @@ struct parse_baton_t
   /* The oldest original revision, greater than r0, in the input
      stream which was not filtered. */
   svn_revnum_t oldest_original_rev;
+
+  /* With --index, the original revisions whose dropped nodes are not
+     part of IN_STREAM (svn_revnum_t -> non-NULL); NULL otherwise. */
+  apr_hash_t *revs_with_dropped_nodes;
 };
 
 struct revision_baton_t
@@ -319,6 +323,12 @@ new_revision_record(void **revision_baton,
   rev_orig = svn_hash_gets(headers, SVN_REPOS_DUMPFILE_REVISION_NUMBER);
   rb->rev_orig = SVN_STR_TO_REV(rev_orig);
 
+  /* The index may have filtered out nodes already. */
+  if (rb->pb->revs_with_dropped_nodes
+      && apr_hash_get(rb->pb->revs_with_dropped_nodes, &rb->rev_orig,
+                      sizeof(rb->rev_orig)))
+    rb->had_dropped_nodes = TRUE;
+
   if (rb->pb->do_renumber_revs)
     rb->rev_actual = rb->rev_orig - rb->pb->rev_drop_count;
   else
@@ -929,6 +939,7 @@ enum
     svndumpfilter__preserve_revprops,
     svndumpfilter__skip_missing_merge_sources,
     svndumpfilter__targets,
+    svndumpfilter__index,
     svndumpfilter__quiet,
     svndumpfilter__glob,
     svndumpfilter__version
@@ -970,6 +981,12 @@ static const apr_getopt_option_t options_table[] =
     {"targets", svndumpfilter__targets, 1,
      N_("Read additional prefixes, one per line, from\n"
         "                             file ARG.")},
+    {"index", svndumpfilter__index, 1,
+     N_("Use the index file ARG of the dump file offsets\n"
+        "                             of all records to read only the records\n"
+        "                             that are kept, creating or updating it\n"
+        "                             first if needed.  The dumpstream must be\n"
+        "                             redirected from a file.")},
     {NULL}
   };
 
@@ -986,8 +1003,8 @@ static const svn_opt_subcommand_desc3_t cmd_table[] =
      {svndumpfilter__drop_empty_revs, svndumpfilter__drop_all_empty_revs,
       svndumpfilter__renumber_revs,
       svndumpfilter__skip_missing_merge_sources, svndumpfilter__targets,
-      svndumpfilter__preserve_revprops, svndumpfilter__quiet,
-      svndumpfilter__glob} },
+      svndumpfilter__index, svndumpfilter__preserve_revprops,
+      svndumpfilter__quiet, svndumpfilter__glob} },
 
     {"include", subcommand_include, {0}, {N_(
         "Filter out nodes without given prefixes from dumpstream.\n"
@@ -996,8 +1013,8 @@ static const svn_opt_subcommand_desc3_t cmd_table[] =
      {svndumpfilter__drop_empty_revs, svndumpfilter__drop_all_empty_revs,
       svndumpfilter__renumber_revs,
       svndumpfilter__skip_missing_merge_sources, svndumpfilter__targets,
-      svndumpfilter__preserve_revprops, svndumpfilter__quiet,
-      svndumpfilter__glob} },
+      svndumpfilter__index, svndumpfilter__preserve_revprops,
+      svndumpfilter__quiet, svndumpfilter__glob} },
 
     {"help", subcommand_help, {"?", "h"}, {N_(
         "Describe the usage of this program or its subcommands.\n"
@@ -1025,10 +1042,382 @@ struct svndumpfilter_opt_state
   svn_boolean_t skip_missing_merge_sources;
                                          /* --skip-missing-merge-sources */
   const char *targets_file;              /* --targets-file       */
+  const char *index_file;                /* --index              */
   apr_array_header_t *prefixes;          /* mainargs.           */
 };
 
 
+/*** Dump file index. ***/
+
+/* With --index, svndumpfilter keeps a file that lists the offset of
+   every record in the dump file, together with the revision number or
+   node path it describes:
+
+     SVNDUMPFILTER-INDEX 1
+     <dump file size> <dump file mtime>
+     H <offset>
+     R <offset> <revision>
+     N <offset> <node path>
+     ...
+
+   "H" entries are records that always get passed through, like the
+   format version and the UUID.  Each record extends up to the offset of
+   the next one.  Filtering the same dump file again then only needs to
+   read the records that it keeps. */
+#define INDEX_FORMAT_LINE "SVNDUMPFILTER-INDEX 1"
+
+/* A range of bytes of the dump file that we pass to the parser. */
+typedef struct dump_range_t
+{
+  apr_off_t start;
+  apr_off_t end;
+} dump_range_t;
+
+/* Baton for read_ranges(). */
+typedef struct ranges_baton_t
+{
+  apr_file_t *file;
+
+  /* The dump_range_t to read, ascending. */
+  apr_array_header_t *ranges;
+
+  /* The range being read and the current offset within FILE. */
+  int current;
+  apr_off_t offset;
+
+  apr_pool_t *pool;
+} ranges_baton_t;
+
+/* Implements svn_read_fn_t.  Read the ranges of the ranges_baton_t
+   BATON one after the other. */
+static svn_error_t *
+read_ranges(void *baton, char *buffer, apr_size_t *len)
+{
+  ranges_baton_t *b = baton;
+  apr_size_t remaining = *len;
+
+  *len = 0;
+  while (remaining && b->current < b->ranges->nelts)
+    {
+      const dump_range_t *range = &APR_ARRAY_IDX(b->ranges, b->current,
+                                                 dump_range_t);
+      apr_size_t to_read;
+      apr_size_t bytes_read;
+      svn_boolean_t eof;
+
+      if (b->offset < range->start)
+        {
+          apr_off_t offset = range->start;
+
+          SVN_ERR(svn_io_file_seek(b->file, APR_SET, &offset, b->pool));
+          b->offset = range->start;
+        }
+      else if (b->offset == range->end)
+        {
+          b->current++;
+          continue;
+        }
+
+      to_read = range->end - b->offset > (apr_off_t)remaining
+              ? remaining
+              : (apr_size_t)(range->end - b->offset);
+      SVN_ERR(svn_io_file_read_full2(b->file, buffer, to_read, &bytes_read,
+                                     &eof, b->pool));
+      if (bytes_read != to_read)
+        return svn_error_create(SVN_ERR_INCOMPLETE_DATA, NULL,
+                                _("Premature end of content data in "
+                                  "dumpstream"));
+
+      buffer += bytes_read;
+      remaining -= bytes_read;
+      *len += bytes_read;
+      b->offset += bytes_read;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Write the index of the dump file FILE with the properties FINFO to
+   INDEX_PATH.  Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+build_index(const char *index_path,
+            apr_file_t *file,
+            const apr_finfo_t *finfo,
+            apr_pool_t *scratch_pool)
+{
+  svn_stream_t *index;
+  const char *tmp_path;
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  apr_off_t offset = 0;
+  svn_boolean_t eof = FALSE;
+
+  SVN_ERR(svn_io_file_seek(file, APR_SET, &offset, scratch_pool));
+  SVN_ERR(svn_stream_open_unique(&index, &tmp_path,
+                                 svn_dirent_dirname(index_path, scratch_pool),
+                                 svn_io_file_del_none,
+                                 scratch_pool, scratch_pool));
+  SVN_ERR(svn_stream_printf(index, scratch_pool,
+                            INDEX_FORMAT_LINE "\n"
+                            "%" APR_OFF_T_FMT " %" APR_TIME_T_FMT "\n",
+                            finfo->size, finfo->mtime));
+
+  while (!eof)
+    {
+      svn_stringbuf_t *line;
+      const char *eol;
+      apr_off_t record_start;
+      const char *revision = NULL;
+      const char *node_path = NULL;
+      svn_boolean_t has_subblocks = FALSE;
+      apr_int64_t content_length = -1;
+
+      svn_pool_clear(iterpool);
+
+      /* Skip the blank lines between records. */
+      do
+        {
+          SVN_ERR(svn_io_file_get_offset(&record_start, file, iterpool));
+          SVN_ERR(svn_io_file_readline(file, &line, &eol, &eof,
+                                       APR_SIZE_MAX, iterpool, iterpool));
+        }
+      while (!eof && line->len == 0);
+
+      if (line->len == 0)
+        break;
+
+      /* Read the headers of this record. */
+      while (line->len)
+        {
+          const char *value = strstr(line->data, ": ");
+
+          if (!value)
+            return svn_error_createf(SVN_ERR_STREAM_MALFORMED_DATA, NULL,
+                                     _("Dump stream contains a malformed "
+                                       "header (with no ':') at '%.20s'"),
+                                     line->data);
+
+          line->data[value - line->data] = '\0';
+          value += 2;
+
+          if (!strcmp(line->data, SVN_REPOS_DUMPFILE_REVISION_NUMBER))
+            revision = value;
+          else if (!strcmp(line->data, SVN_REPOS_DUMPFILE_NODE_PATH))
+            node_path = value;
+          else if (!strcmp(line->data, SVN_REPOS_DUMPFILE_CONTENT_LENGTH))
+            SVN_ERR(svn_cstring_atoi64(&content_length, value));
+          else if (!strcmp(line->data,
+                           SVN_REPOS_DUMPFILE_PROP_CONTENT_LENGTH)
+                   || !strcmp(line->data,
+                              SVN_REPOS_DUMPFILE_TEXT_CONTENT_LENGTH))
+            has_subblocks = TRUE;
+
+          if (eof)
+            break;
+
+          SVN_ERR(svn_io_file_readline(file, &line, &eol, &eof,
+                                       APR_SIZE_MAX, iterpool, iterpool));
+        }
+
+      /* Old dump files may omit the total length of a record. */
+      if (has_subblocks && content_length < 0)
+        return svn_error_create(SVN_ERR_UNSUPPORTED_FEATURE, NULL,
+                                _("Can't index dump streams with records "
+                                  "that lack a Content-length header"));
+
+      if (revision)
+        SVN_ERR(svn_stream_printf(index, iterpool,
+                                  "R %" APR_OFF_T_FMT " %s\n",
+                                  record_start, revision));
+      else if (node_path)
+        SVN_ERR(svn_stream_printf(index, iterpool,
+                                  "N %" APR_OFF_T_FMT " %s\n",
+                                  record_start, node_path));
+      else
+        SVN_ERR(svn_stream_printf(index, iterpool,
+                                  "H %" APR_OFF_T_FMT "\n", record_start));
+
+      if (content_length > 0)
+        {
+          offset = content_length;
+          SVN_ERR(svn_io_file_seek(file, APR_CUR, &offset, iterpool));
+        }
+    }
+
+  svn_pool_destroy(iterpool);
+  SVN_ERR(svn_stream_close(index));
+  SVN_ERR(svn_io_file_rename2(tmp_path, index_path, FALSE, scratch_pool));
+
+  offset = 0;
+  return svn_error_trace(svn_io_file_seek(file, APR_SET, &offset,
+                                          scratch_pool));
+}
+
+/* Set *INDEX to the index file at INDEX_PATH, positioned after its
+   header, or to NULL if there is no such file or if it does not
+   describe a dump file with the properties FINFO.  Allocate *INDEX in
+   RESULT_POOL and use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+open_index(svn_stream_t **index,
+           const char *index_path,
+           const apr_finfo_t *finfo,
+           apr_pool_t *result_pool,
+           apr_pool_t *scratch_pool)
+{
+  svn_stringbuf_t *line;
+  svn_boolean_t eof;
+  svn_error_t *err;
+
+  err = svn_stream_open_readonly(index, index_path, result_pool,
+                                 scratch_pool);
+  if (err && APR_STATUS_IS_ENOENT(err->apr_err))
+    {
+      svn_error_clear(err);
+      *index = NULL;
+      return SVN_NO_ERROR;
+    }
+  SVN_ERR(err);
+
+  SVN_ERR(svn_stream_readline(*index, &line, "\n", &eof, scratch_pool));
+  if (strcmp(line->data, INDEX_FORMAT_LINE))
+    return svn_error_compose_create(
+             svn_error_createf(SVN_ERR_BAD_VERSION_FILE_FORMAT, NULL,
+                               _("'%s' is not an svndumpfilter index file"),
+                               svn_dirent_local_style(index_path,
+                                                      scratch_pool)),
+             svn_stream_close(*index));
+
+  SVN_ERR(svn_stream_readline(*index, &line, "\n", &eof, scratch_pool));
+  if (strcmp(line->data,
+             apr_psprintf(scratch_pool,
+                          "%" APR_OFF_T_FMT " %" APR_TIME_T_FMT,
+                          finfo->size, finfo->mtime)))
+    {
+      /* The dump file has changed since the index was written. */
+      SVN_ERR(svn_stream_close(*index));
+      *index = NULL;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Make PB read only the records of the dump file FILE with the
+   properties FINFO that the filter keeps, using the index file at
+   INDEX_PATH.  Create or update the index file first if necessary.
+   Note the nodes that get left out in PB.  Use POOL for allocations. */
+static svn_error_t *
+use_index(struct parse_baton_t *pb,
+          apr_file_t *file,
+          const apr_finfo_t *finfo,
+          const char *index_path,
+          apr_pool_t *pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  svn_stream_t *index;
+  ranges_baton_t *baton = apr_pcalloc(pool, sizeof(*baton));
+  svn_revnum_t revision = SVN_INVALID_REVNUM;
+  apr_off_t range_start = -1;
+  svn_boolean_t eof = FALSE;
+
+  SVN_ERR(open_index(&index, index_path, finfo, pool, iterpool));
+  if (!index)
+    {
+      SVN_ERR(build_index(index_path, file, finfo, iterpool));
+      SVN_ERR(open_index(&index, index_path, finfo, pool, iterpool));
+      SVN_ERR_ASSERT(index);
+    }
+
+  baton->file = file;
+  baton->ranges = apr_array_make(pool, 16, sizeof(dump_range_t));
+  baton->pool = pool;
+  pb->revs_with_dropped_nodes = apr_hash_make(pool);
+
+  while (!eof)
+    {
+      svn_stringbuf_t *line;
+      const char *value;
+      apr_int64_t offset;
+      svn_boolean_t keep = TRUE;
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_stream_readline(index, &line, "\n", &eof, iterpool));
+      if (eof && line->len == 0)
+        break;
+
+      /* Get the offset and the optional value after it. */
+      value = strchr(line->data + 2, ' ');
+      if (value)
+        line->data[value++ - line->data] = '\0';
+
+      if (line->len < 3 || line->data[1] != ' '
+          || (line->data[0] != 'H' && !value))
+        return svn_error_createf(SVN_ERR_MALFORMED_FILE, NULL,
+                                 _("Index file '%s' is corrupt"),
+                                 svn_dirent_local_style(index_path, pool));
+      SVN_ERR(svn_cstring_atoi64(&offset, line->data + 2));
+
+      if (line->data[0] == 'R')
+        {
+          revision = SVN_STR_TO_REV(value);
+        }
+      else if (line->data[0] == 'N')
+        {
+          const char *node_path = value;
+
+          /* Ensure that paths start with a leading '/'. */
+          if (node_path[0] != '/')
+            node_path = apr_pstrcat(iterpool, "/", node_path, SVN_VA_NULL);
+
+          keep = !skip_path(node_path, pb->prefixes, pb->do_exclude,
+                            pb->glob);
+          if (!keep)
+            {
+              svn_revnum_t *key = apr_palloc(pool, sizeof(*key));
+
+              svn_hash_sets(pb->dropped_nodes,
+                            apr_pstrdup(apr_hash_pool_get(pb->dropped_nodes),
+                                        node_path),
+                            (void *)1);
+
+              *key = revision;
+              apr_hash_set(pb->revs_with_dropped_nodes, key, sizeof(*key),
+                           key);
+            }
+        }
+
+      /* Start or end a range of consecutive records that we keep. */
+      if (keep && range_start < 0)
+        {
+          range_start = offset;
+        }
+      else if (!keep && range_start >= 0)
+        {
+          dump_range_t *range = apr_array_push(baton->ranges);
+
+          range->start = range_start;
+          range->end = offset;
+          range_start = -1;
+        }
+    }
+
+  if (range_start >= 0)
+    {
+      dump_range_t *range = apr_array_push(baton->ranges);
+
+      range->start = range_start;
+      range->end = finfo->size;
+    }
+
+  svn_pool_destroy(iterpool);
+  SVN_ERR(svn_stream_close(index));
+
+  pb->in_stream = svn_stream_create(baton, pool);
+  svn_stream_set_read2(pb->in_stream, NULL /* only full read support */,
+                       read_ranges);
+
+  return SVN_NO_ERROR;
+}
+
+
 static svn_error_t *
 parse_baton_initialize(struct parse_baton_t **pb,
                        struct svndumpfilter_opt_state *opt_state,
@@ -1036,9 +1425,27 @@ parse_baton_initialize(struct parse_baton_t **pb,
                        apr_pool_t *pool)
 {
   struct parse_baton_t *baton = apr_palloc(pool, sizeof(*baton));
+  apr_file_t *stdin_file;
+  apr_finfo_t finfo;
+  apr_status_t apr_err;
 
-  /* Read the stream from STDIN.  Users can redirect a file. */
-  SVN_ERR(svn_stream_for_stdin2(&baton->in_stream, TRUE, pool));
+  /* Read the stream from STDIN.  Users can redirect a file, which lets
+     us seek over the contents of the nodes that we skip. */
+  apr_err = apr_file_open_flags_stdin(&stdin_file, APR_BUFFERED, pool);
+  if (apr_err)
+    return svn_error_wrap_apr(apr_err, _("Can't open stdin"));
+
+  SVN_ERR(svn_io_file_info_get(&finfo, APR_FINFO_TYPE | APR_FINFO_SIZE
+                                       | APR_FINFO_MTIME,
+                               stdin_file, pool));
+  if (finfo.filetype == APR_REG)
+    baton->in_stream = svn_stream_from_aprfile2(stdin_file, TRUE, pool);
+  else if (opt_state->index_file)
+    return svn_error_create(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
+                            _("--index requires the dumpstream to be "
+                              "redirected from a file"));
+  else
+    SVN_ERR(svn_stream_for_stdin2(&baton->in_stream, TRUE, pool));
 
   /* Have the parser dump results to STDOUT. Users can redirect a file. */
   SVN_ERR(svn_stream_for_stdout(&baton->out_stream, pool));
@@ -1064,6 +1471,11 @@ parse_baton_initialize(struct parse_baton_t **pb,
   baton->last_live_revision = SVN_INVALID_REVNUM;
   baton->oldest_original_rev = SVN_INVALID_REVNUM;
   baton->allow_deltas = FALSE;
+  baton->revs_with_dropped_nodes = NULL;
+
+  if (opt_state->index_file)
+    SVN_ERR(use_index(baton, stdin_file, &finfo, opt_state->index_file,
+                      pool));
 
   *pb = baton;
   return SVN_NO_ERROR;
@@ -1378,6 +1790,12 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
           SVN_ERR(svn_utf_cstring_to_utf8(&opt_state.targets_file,
                                           opt_arg, pool));
           break;
+        case svndumpfilter__index:
+          SVN_ERR(svn_utf_cstring_to_utf8(&opt_state.index_file,
+                                          opt_arg, pool));
+          opt_state.index_file = svn_dirent_internal_style(
+                                   opt_state.index_file, pool);
+          break;
         default:
           {
             SVN_ERR(subcommand_help(NULL, NULL, pool));
@@ -0,0 +1,76 @@
+/* convert-locks-cmd.c -- implements the convert-locks sub-command.
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include "svn_cmdline.h"
+#include "svn_fs.h"
+#include "svn_pools.h"
+
+#include "private/svn_fs_fs_private.h"
+
+#include "svn_private_config.h"
+
+#include "svnfsfs.h"
+
+/* Names of the lock storage types as used on the command line. */
+#define STORAGE_LOG "log"
+#define STORAGE_DIGEST "digest"
+
+/* This implements `svn_opt_subcommand_t'. */
+svn_error_t *
+subcommand__convert_locks(apr_getopt_t *os, void *baton, apr_pool_t *pool)
+{
+  svnfsfs__opt_state *opt_state = baton;
+  apr_array_header_t *args;
+  svn_boolean_t use_log;
+  svn_fs_t *fs;
+
+  SVN_ERR(svn_opt_parse_all_args(&args, os, pool));
+  if (args->nelts > 1)
+    return svn_error_create(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
+                            _("Too many arguments given"));
+
+  SVN_ERR(open_fs(&fs, opt_state->repository_path, pool));
+
+  /* Convert only if a target storage has been given. */
+  if (args->nelts == 1)
+    {
+      const char *storage = APR_ARRAY_IDX(args, 0, const char *);
+
+      if (strcmp(storage, STORAGE_LOG) == 0)
+        use_log = TRUE;
+      else if (strcmp(storage, STORAGE_DIGEST) == 0)
+        use_log = FALSE;
+      else
+        return svn_error_createf(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
+                                 _("Unknown lock storage '%s'"), storage);
+
+      SVN_ERR(svn_fs_fs__convert_locks(fs, use_log, check_cancel, NULL,
+                                       pool));
+    }
+
+  SVN_ERR(svn_fs_fs__uses_lock_log(&use_log, fs, pool));
+  if (! opt_state->quiet)
+    SVN_ERR(svn_cmdline_printf(pool, _("Lock storage: %s\n"),
+                               use_log ? STORAGE_LOG : STORAGE_DIGEST));
+
+  return SVN_NO_ERROR;
+}
@@ -0,0 +1,123 @@
+/* repack-cmd.c -- implements the repack sub-command.
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include "svn_cmdline.h"
+#include "svn_pools.h"
+#include "private/svn_fs_fs_private.h"
+
+#include "svn_private_config.h"
+
+#include "svnfsfs.h"
+
+/* Repack the packed shards of the repository at PATH.  If REVISION is
+ * valid, only repack the shard containing it.  Print progress unless
+ * QUIET is set.  Use POOL for allocations.
+ */
+static svn_error_t *
+repack(const char *path,
+       svn_revnum_t revision,
+       svn_boolean_t quiet,
+       apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  const svn_fs_info_placeholder_t *fs_info;
+  const svn_fs_fsfs_info_t *info;
+  apr_int64_t first_shard, end_shard, shard;
+  apr_pool_t *iterpool;
+
+  /* Check repository type and open it. */
+  SVN_ERR(open_fs(&fs, path, pool));
+  SVN_ERR(svn_fs_info(&fs_info, fs, pool, pool));
+  info = (const svn_fs_fsfs_info_t *)fs_info;
+
+  if (!info->log_addressing)
+    return svn_error_create(SVN_ERR_FS_UNSUPPORTED_FORMAT, NULL,
+                            _("Only repositories using logical addressing "
+                              "can be repacked"));
+
+  if (info->shard_size == 0 || info->min_unpacked_rev < info->shard_size)
+    {
+      if (SVN_IS_VALID_REVNUM(revision))
+        return svn_error_createf(SVN_ERR_FS_NO_SUCH_REVISION, NULL,
+                                 _("Revision %ld has not been packed"),
+                                 revision);
+
+      return SVN_NO_ERROR;
+    }
+
+  /* Determine the shards to process. */
+  end_shard = info->min_unpacked_rev / info->shard_size;
+  if (SVN_IS_VALID_REVNUM(revision))
+    {
+      if (revision >= info->min_unpacked_rev)
+        return svn_error_createf(SVN_ERR_FS_NO_SUCH_REVISION, NULL,
+                                 _("Revision %ld has not been packed"),
+                                 revision);
+
+      first_shard = revision / info->shard_size;
+      end_shard = first_shard + 1;
+    }
+  else
+    {
+      first_shard = 0;
+    }
+
+  iterpool = svn_pool_create(pool);
+  for (shard = first_shard; shard < end_shard; ++shard)
+    {
+      svn_pool_clear(iterpool);
+
+      if (!quiet)
+        SVN_ERR(svn_cmdline_printf(iterpool,
+                                   _("Repacking shard %" APR_INT64_T_FMT
+                                     "..."), shard));
+
+      SVN_ERR(svn_fs_fs__repack_shard(fs, shard, 0, check_cancel, NULL,
+                                      iterpool));
+
+      if (!quiet)
+        SVN_ERR(svn_cmdline_printf(iterpool, _("done.\n")));
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* This implements `svn_opt_subcommand_t'. */
+svn_error_t *
+subcommand__repack(apr_getopt_t *os, void *baton, apr_pool_t *pool)
+{
+  svnfsfs__opt_state *opt_state = baton;
+  svn_revnum_t revision = SVN_INVALID_REVNUM;
+
+  if (opt_state->start_revision.kind == svn_opt_revision_number)
+    revision = opt_state->start_revision.value.number;
+  else if (opt_state->start_revision.kind != svn_opt_revision_unspecified)
+    return svn_error_create(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
+                            _("Revision must be a number"));
+
+  SVN_ERR(repack(opt_state->repository_path, revision, opt_state->quiet,
+                 pool));
+
+  return SVN_NO_ERROR;
+}
@@ -0,0 +1,69 @@
+/* reshard-cmd.c -- implements the reshard sub-command.
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include "svn_cmdline.h"
+#include "svn_fs.h"
+#include "svn_pools.h"
+#include "svn_string.h"
+
+#include "private/svn_fs_fs_private.h"
+
+#include "svn_private_config.h"
+
+#include "svnfsfs.h"
+
+/* This implements `svn_opt_subcommand_t'. */
+svn_error_t *
+subcommand__reshard(apr_getopt_t *os, void *baton, apr_pool_t *pool)
+{
+  svnfsfs__opt_state *opt_state = baton;
+  apr_array_header_t *args;
+  apr_int64_t shard_size;
+  svn_fs_t *fs;
+
+  SVN_ERR(svn_opt_parse_all_args(&args, os, pool));
+  if (args->nelts < 1)
+    return svn_error_create(SVN_ERR_CL_INSUFFICIENT_ARGS, NULL,
+                            _("Missing shard size"));
+  if (args->nelts > 1)
+    return svn_error_create(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
+                            _("Too many arguments given"));
+
+  SVN_ERR(svn_cstring_strtoi64(&shard_size,
+                               APR_ARRAY_IDX(args, 0, const char *),
+                               0, APR_INT32_MAX, 10));
+
+  SVN_ERR(open_fs(&fs, opt_state->repository_path, pool));
+  SVN_ERR(svn_fs_fs__reshard(fs, (int)shard_size, opt_state->jobs,
+                             check_cancel, NULL, pool));
+
+  if (! opt_state->quiet)
+    {
+      if (shard_size)
+        SVN_ERR(svn_cmdline_printf(pool, _("Shard size: %d\n"),
+                                   (int)shard_size));
+      else
+        SVN_ERR(svn_cmdline_printf(pool, _("Shard size: linear\n")));
+    }
+
+  return SVN_NO_ERROR;
+}
@@ -397,6 +397,15 @@ print_stats(svn_fs_fs__stats_t *stats,
                          pool),
          svn__ui64toa_sep(stats->total_rep_stats.expanded_size, ',', pool));
 
+  printf("\nPack statistics:\n");
+  printf(_("%20s bytes in %12s packed revisions\n"
+           "%20s bytes in %12s non-packed revisions\n"),
+         svn__ui64toa_sep(stats->packed_size, ',', pool),
+         svn__ui64toa_sep(stats->packed_revision_count, ',', pool),
+         svn__ui64toa_sep(stats->total_size - stats->packed_size, ',', pool),
+         svn__ui64toa_sep(stats->revision_count
+                          - stats->packed_revision_count, ',', pool));
+
   printf("\nNoderev statistics:\n");
   printf(_("%20s bytes in %12s nodes total\n"
            "%20s bytes in %12s directory noderevs\n"
@@ -483,6 +492,213 @@ print_stats(svn_fs_fs__stats_t *stats,
   print_histograms_by_extension(stats, pool);
 }
 
+/* Return STR as a quoted JSON string literal, allocated in POOL.
+ */
+static const char *
+json_string(const char *str,
+            apr_pool_t *pool)
+{
+  svn_stringbuf_t *result = svn_stringbuf_create_ensure(strlen(str) + 2,
+                                                        pool);
+  const unsigned char *p;
+
+  svn_stringbuf_appendbyte(result, '"');
+  for (p = (const unsigned char *)str; *p; ++p)
+    {
+      if (*p == '"' || *p == '\\')
+        {
+          svn_stringbuf_appendbyte(result, '\\');
+          svn_stringbuf_appendbyte(result, *p);
+        }
+      else if (*p < 0x20)
+        svn_stringbuf_appendcstr(result, apr_psprintf(pool, "\\u%04x", *p));
+      else
+        svn_stringbuf_appendbyte(result, *p);
+    }
+  svn_stringbuf_appendbyte(result, '"');
+
+  return result->data;
+}
+
+/* Print HISTOGRAM as JSON object to console.  Only the non-zero lines
+ * will be listed, each with its inclusive lower and exclusive upper
+ * bound.  Use POOL for allocations.
+ */
+static void
+print_json_histogram(svn_fs_fs__histogram_t *histogram,
+                     apr_pool_t *pool)
+{
+  int i;
+  svn_boolean_t first = TRUE;
+
+  printf("{\"count\": %" APR_UINT64_T_FMT ", \"sum\": %" APR_UINT64_T_FMT
+         ", \"lines\": [",
+         histogram->total.count, histogram->total.sum);
+
+  for (i = 0; i < 64; ++i)
+    if (histogram->lines[i].count)
+      {
+        printf("%s{\"min\": %" APR_UINT64_T_FMT ", \"max\": %"
+               APR_UINT64_T_FMT ", \"count\": %" APR_UINT64_T_FMT
+               ", \"sum\": %" APR_UINT64_T_FMT "}",
+               first ? "" : ", ",
+               i ? (apr_uint64_t)1 << (i - 1) : 0,
+               (apr_uint64_t)1 << i,
+               histogram->lines[i].count, histogram->lines[i].sum);
+        first = FALSE;
+      }
+
+  printf("]}");
+}
+
+/* Print STATS as JSON object to console.
+ */
+static void
+print_json_rep_pack_stats(svn_fs_fs__rep_pack_stats_t *stats)
+{
+  printf("{\"count\": %" APR_UINT64_T_FMT
+         ", \"packed_size\": %" APR_UINT64_T_FMT
+         ", \"expanded_size\": %" APR_UINT64_T_FMT
+         ", \"overhead_size\": %" APR_UINT64_T_FMT "}",
+         stats->count, stats->packed_size, stats->expanded_size,
+         stats->overhead_size);
+}
+
+/* Print STATS as JSON object to console.  Use POOL for allocations.
+ */
+static void
+print_json_rep_stats(svn_fs_fs__representation_stats_t *stats,
+                     apr_pool_t *pool)
+{
+  printf("{\"total\": ");
+  print_json_rep_pack_stats(&stats->total);
+  printf(", \"uniques\": ");
+  print_json_rep_pack_stats(&stats->uniques);
+  printf(", \"shared\": ");
+  print_json_rep_pack_stats(&stats->shared);
+  printf(", \"references\": %" APR_UINT64_T_FMT
+         ", \"expanded_size_without_sharing\": %" APR_UINT64_T_FMT
+         ", \"chain_length_sum\": %" APR_UINT64_T_FMT
+         ", \"chain_length_histogram\": ",
+         stats->references, stats->expanded_size, stats->chain_len);
+  print_json_histogram(&stats->chain_len_histogram, pool);
+  printf("}");
+}
+
+/* Print STATS as JSON object to console.
+ */
+static void
+print_json_node_stats(svn_fs_fs__node_stats_t *stats)
+{
+  printf("{\"count\": %" APR_UINT64_T_FMT ", \"size\": %" APR_UINT64_T_FMT
+         "}", stats->count, stats->size);
+}
+
+/* Print the contents of STATS as a single JSON object to the console.
+ * Use POOL for allocations.
+ */
+static void
+print_json_stats(svn_fs_fs__stats_t *stats,
+                 apr_pool_t *pool)
+{
+  apr_array_header_t *extensions;
+  apr_size_t i;
+  int k;
+
+  printf("{\n\"revisions\": %" APR_UINT64_T_FMT
+         ",\n\"total_size\": %" APR_UINT64_T_FMT
+         ",\n\"changes\": {\"count\": %" APR_UINT64_T_FMT
+         ", \"size\": %" APR_UINT64_T_FMT "}",
+         stats->revision_count, stats->total_size,
+         stats->change_count, stats->change_len);
+
+  /* Pack effectiveness. */
+  printf(",\n\"packing\": {\"packed_revisions\": %" APR_UINT64_T_FMT
+         ", \"packed_size\": %" APR_UINT64_T_FMT
+         ", \"unpacked_revisions\": %" APR_UINT64_T_FMT
+         ", \"unpacked_size\": %" APR_UINT64_T_FMT "}",
+         stats->packed_revision_count, stats->packed_size,
+         stats->revision_count - stats->packed_revision_count,
+         stats->total_size - stats->packed_size);
+
+  printf(",\n\"noderevs\": {\"total\": ");
+  print_json_node_stats(&stats->total_node_stats);
+  printf(", \"dir\": ");
+  print_json_node_stats(&stats->dir_node_stats);
+  printf(", \"file\": ");
+  print_json_node_stats(&stats->file_node_stats);
+  printf("}");
+
+  printf(",\n\"representations\": {\n  \"total\": ");
+  print_json_rep_stats(&stats->total_rep_stats, pool);
+  printf(",\n  \"dir\": ");
+  print_json_rep_stats(&stats->dir_rep_stats, pool);
+  printf(",\n  \"file\": ");
+  print_json_rep_stats(&stats->file_rep_stats, pool);
+  printf(",\n  \"dir_props\": ");
+  print_json_rep_stats(&stats->dir_prop_rep_stats, pool);
+  printf(",\n  \"file_props\": ");
+  print_json_rep_stats(&stats->file_prop_rep_stats, pool);
+  printf("}");
+
+  printf(",\n\"largest_changes\": [");
+  for (i = 0; i < stats->largest_changes->count
+              && stats->largest_changes->changes[i]->size; ++i)
+    {
+      svn_fs_fs__large_change_info_t *info
+        = stats->largest_changes->changes[i];
+      printf("%s\n  {\"size\": %" APR_UINT64_T_FMT
+             ", \"revision\": %ld, \"path\": %s}",
+             i ? "," : "", info->size, info->revision,
+             json_string(info->path->data, pool));
+    }
+  printf("]");
+
+  /* All extensions, most frequent first. */
+  extensions = svn_sort__hash(stats->by_extension, compare_count, pool);
+  printf(",\n\"extensions\": [");
+  for (k = 0; k < extensions->nelts; ++k)
+    {
+      svn_fs_fs__extension_info_t *info
+        = APR_ARRAY_IDX(extensions, k, svn_sort__item_t).value;
+      printf("%s\n  {\"extension\": %s, \"node_histogram\": ",
+             k ? "," : "", json_string(info->extension, pool));
+      print_json_histogram(&info->node_histogram, pool);
+      printf(", \"rep_histogram\": ");
+      print_json_histogram(&info->rep_histogram, pool);
+      printf("}");
+    }
+  printf("]");
+
+  printf(",\n\"histograms\": {\n  \"node_size\": ");
+  print_json_histogram(&stats->node_size_histogram, pool);
+  printf(",\n  \"rep_size\": ");
+  print_json_histogram(&stats->rep_size_histogram, pool);
+  printf(",\n  \"added_node_size\": ");
+  print_json_histogram(&stats->added_node_size_histogram, pool);
+  printf(",\n  \"added_rep_size\": ");
+  print_json_histogram(&stats->added_rep_size_histogram, pool);
+  printf(",\n  \"unused_rep_size\": ");
+  print_json_histogram(&stats->unused_rep_histogram, pool);
+  printf(",\n  \"file_size\": ");
+  print_json_histogram(&stats->file_histogram, pool);
+  printf(",\n  \"file_rep_size\": ");
+  print_json_histogram(&stats->file_rep_histogram, pool);
+  printf(",\n  \"file_prop_size\": ");
+  print_json_histogram(&stats->file_prop_histogram, pool);
+  printf(",\n  \"file_prop_rep_size\": ");
+  print_json_histogram(&stats->file_prop_rep_histogram, pool);
+  printf(",\n  \"dir_size\": ");
+  print_json_histogram(&stats->dir_histogram, pool);
+  printf(",\n  \"dir_rep_size\": ");
+  print_json_histogram(&stats->dir_rep_histogram, pool);
+  printf(",\n  \"dir_prop_size\": ");
+  print_json_histogram(&stats->dir_prop_histogram, pool);
+  printf(",\n  \"dir_prop_rep_size\": ");
+  print_json_histogram(&stats->dir_prop_rep_histogram, pool);
+  printf("}\n}\n");
+}
+
 /* Our progress function simply prints the REVISION number and makes it
  * appear immediately.
  */
@@ -503,12 +719,20 @@ subcommand__stats(apr_getopt_t *os, void *baton, apr_pool_t *pool)
   svn_fs_fs__stats_t *stats;
   svn_fs_t *fs;
 
-  printf("Reading revisions\n");
+  /* Keep the JSON output clean of progress info. */
+  if (!opt_state->json)
+    printf("Reading revisions\n");
+
   SVN_ERR(open_fs(&fs, opt_state->repository_path, pool));
-  SVN_ERR(svn_fs_fs__get_stats(&stats, fs, print_progress, NULL,
+  SVN_ERR(svn_fs_fs__get_stats(&stats, fs, opt_state->jobs, open_fs_func,
+                               (void *)opt_state->repository_path,
+                               opt_state->json ? NULL : print_progress, NULL,
                                check_cancel, NULL, pool, pool));
 
-  print_stats(stats, pool);
+  if (opt_state->json)
+    print_json_stats(stats, pool);
+  else
+    print_stats(stats, pool);
 
   return SVN_NO_ERROR;
 }
@@ -76,7 +76,9 @@ check_lib_versions(void)
 
 enum svnfsfs__cmdline_options_t
   {
-    svnfsfs__version = SVN_OPT_FIRST_LONGOPT_ID
+    svnfsfs__version = SVN_OPT_FIRST_LONGOPT_ID,
+    svnfsfs__jobs,
+    svnfsfs__format
   };
 
 /* Option codes and descriptions.
@@ -104,6 +106,15 @@ static const apr_getopt_option_t options_table[] =
      N_("size of the extra in-memory cache in MB used to\n"
         "                             minimize redundant operations. Default: 16.")},
 
+    {"jobs",          svnfsfs__jobs, 1,
+     N_("number of rev / pack files to read concurrently.\n"
+        "                             Default: 1.")},
+
+    {"format",        svnfsfs__format, 1,
+     N_("output format ARG.  Must be one of:\n"
+        "                                'text' (default)\n"
+        "                                'json'")},
+
     {NULL}
   };
 
@@ -120,6 +131,21 @@ static const svn_opt_subcommand_desc3_t cmd_table[] =
    )},
    {0} },
 
+  {"convert-locks", subcommand__convert_locks, {0}, {N_(
+    "usage: svnfsfs convert-locks REPOS_PATH [log|digest]\n"
+    "\n"), N_(
+    "Convert the lock storage of the repository to the given type and print\n"
+    "the type being used.  Expired locks are removed in the process.\n"
+    "\n"), N_(
+    "   digest ... One file per locked path and per parent folder of locked\n"
+    "              paths.  This is the default for new repositories.\n"
+    "   log ...... A single append-only file that servers keep indexed in\n"
+    "              memory.  This is much faster with many locks.\n"
+    "\n"), N_(
+    "The repository remains accessible during the conversion.\n"
+   )},
+   {'q', 'M'} },
+
   {"dump-index", subcommand__dump_index, {0}, {N_(
     "usage: svnfsfs dump-index REPOS_PATH -r REV\n"
     "\n"), N_(
@@ -162,12 +188,47 @@ static const svn_opt_subcommand_desc3_t cmd_table[] =
    )},
    {'M'} },
 
+  {"repack", subcommand__repack, {0}, {N_(
+    "usage: svnfsfs repack REPOS_PATH [-r REV]\n"
+    "\n"), N_(
+    "Rewrite the pack files of the repository, placing their items as if the\n"
+    "whole shard had been packed in one go.  This improves the data locality of\n"
+    "shards that were packed with little memory or by older releases.  With -r,\n"
+    "only repack the shard containing revision REV.  This is only available for\n"
+    "FSFS format 7 (SVN 1.9+) repositories.\n"
+    "\n"), N_(
+    "Each pack file gets replaced atomically.  Still, servers may have cached\n"
+    "index data of the old pack files and should be restarted afterwards.\n"
+   )},
+   {'r', 'q', 'M'} },
+
+  {"reshard", subcommand__reshard, {0}, {N_(
+    "usage: svnfsfs reshard REPOS_PATH SHARD_SIZE\n"
+    "\n"), N_(
+    "Change the number of revisions per shard to SHARD_SIZE.  0 selects the\n"
+    "linear layout, which is not available with logical addressing.  This is\n"
+    "only available for FSFS format 4 (SVN 1.6+) repositories without packed\n"
+    "shards.\n"
+    "\n"), N_(
+    "The repository stays online.  The revision and revprop files get hard-\n"
+    "linked into the new layout where possible and commits are only blocked\n"
+    "while switching to it.  With --jobs N, use up to N threads.\n"
+   )},
+   {'q', 'M', svnfsfs__jobs} },
+
   {"stats", subcommand__stats, {0}, {N_(
     "usage: svnfsfs stats REPOS_PATH\n"
     "\n"), N_(
     "Write object size statistics to console.\n"
+    "\n"), N_(
+    "With --jobs N, read up to N rev / pack files concurrently.  This\n"
+    "requires a format 7 repository.  The results are the same as for a\n"
+    "single job.\n"
+    "\n"), N_(
+    "With --format json, write a single JSON object instead of the\n"
+    "human-readable tables.\n"
    )},
-   {'M'} },
+   {'M', svnfsfs__jobs, svnfsfs__format} },
 
   { NULL, NULL, {0}, {NULL}, {0} }
 };
@@ -195,6 +256,14 @@ open_fs(svn_fs_t **fs,
   return SVN_NO_ERROR;
 }
 
+svn_error_t *
+open_fs_func(svn_fs_t **fs,
+             void *baton,
+             apr_pool_t *result_pool)
+{
+  return svn_error_trace(open_fs(fs, baton, result_pool));
+}
+
 /* This implements `svn_opt_subcommand_t'. */
 svn_error_t *
 subcommand__help(apr_getopt_t *os, void *baton, apr_pool_t *pool)
@@ -259,6 +328,7 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
   opt_state.start_revision.kind = svn_opt_revision_unspecified;
   opt_state.end_revision.kind = svn_opt_revision_unspecified;
   opt_state.memory_cache_size = svn_cache_config_get()->cache_size;
+  opt_state.jobs = 1;
 
   /* Parse options. */
   SVN_ERR(svn_cmdline__getopt_init(&os, argc, argv, pool));
@@ -323,6 +393,23 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
       case svnfsfs__version:
         opt_state.version = TRUE;
         break;
+      case svnfsfs__jobs:
+        {
+          apr_int64_t jobs;
+          SVN_ERR(svn_cstring_strtoi64(&jobs, opt_arg, 1, 256, 10));
+
+          opt_state.jobs = (int)jobs;
+        }
+        break;
+      case svnfsfs__format:
+        if (strcmp(opt_arg, "json") == 0)
+          opt_state.json = TRUE;
+        else if (strcmp(opt_arg, "text") == 0)
+          opt_state.json = FALSE;
+        else
+          return svn_error_createf(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
+                                   _("Unknown output format '%s'"), opt_arg);
+        break;
       default:
         {
           SVN_ERR(subcommand__help(NULL, NULL, pool));
@@ -444,12 +531,13 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
   check_cancel = svn_cmdline__setup_cancellation_handler();
 
   /* Configure FSFS caches for maximum efficiency with svnfsfs.
-   * Also, apply the respective command line parameters, if given. */
+   * Also, apply the respective command line parameters, if given.
+   * Concurrent stats jobs share the caches between threads. */
   {
     svn_cache_config_t settings = *svn_cache_config_get();
 
     settings.cache_size = opt_state.memory_cache_size;
-    settings.single_threaded = TRUE;
+    settings.single_threaded = opt_state.jobs <= 1;
 
     svn_cache_config_set(&settings);
   }
@@ -484,7 +572,8 @@ main(int argc, const char *argv[])
     return EXIT_FAILURE;
 
   /* Create our top-level pool.  Use a separate mutexless allocator,
-   * given this application is single threaded.
+   * given that only the main thread uses it.  Worker threads bring their
+   * own root pools.
    */
   pool = apr_allocator_owner_get(svn_pool_create_allocator(FALSE));
 
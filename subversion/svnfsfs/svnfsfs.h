@@ -45,13 +45,18 @@ typedef struct svnfsfs__opt_state
   svn_boolean_t version;                            /* --version */
   svn_boolean_t quiet;                              /* --quiet */
   apr_uint64_t memory_cache_size;                   /* --memory-cache-size M */
+  int jobs;                                         /* --jobs ARG */
+  svn_boolean_t json;                               /* --format json */
 } svnfsfs__opt_state;
 
 /* Declare all the command procedures */
 svn_opt_subcommand_t
   subcommand__help,
+  subcommand__convert_locks,
   subcommand__dump_index,
   subcommand__load_index,
+  subcommand__repack,
+  subcommand__reshard,
   subcommand__stats;
 
 
@@ -62,6 +67,13 @@ open_fs(svn_fs_t **fs,
         const char *path,
         apr_pool_t *pool);
 
+/* Implements svn_fs_fs__open_fs_func_t for the repository at path BATON
+ * using open_fs(). */
+svn_error_t *
+open_fs_func(svn_fs_t **fs,
+             void *baton,
+             apr_pool_t *result_pool);
+
 /* Our cancellation callback. */
 extern svn_cancel_func_t check_cancel;
 
@@ -70,8 +70,10 @@
 
 static svn_opt_subcommand_t
   subcommand_author,
+  subcommand_batch,
   subcommand_cat,
   subcommand_changed,
+  subcommand_changed_details,
   subcommand_date,
   subcommand_diff,
   subcommand_dirschanged,
@@ -83,6 +85,7 @@ static svn_opt_subcommand_t
   subcommand_log,
   subcommand_pget,
   subcommand_plist,
+  subcommand_tar,
   subcommand_tree,
   subcommand_uuid,
   subcommand_youngest;
@@ -221,6 +224,29 @@ static const svn_opt_subcommand_desc3_t cmd_table[] =
    )},
    {'r', 't'} },
 
+  {"batch", subcommand_batch, {0}, {N_(
+      "usage: svnlook batch REPOS_PATH\n"
+      "\n"), N_(
+      "Answer queries about a revision or transaction read from standard\n"
+      "input, one per line, without reopening the repository for each of\n"
+      "them.  This is meant for hook scripts that need many lookups.\n"
+      "Paths and property names are UTF-8.  The queries are:\n"
+      "\n"
+      "  cat PATH             file contents\n"
+      "  filesize PATH        file size in bytes\n"
+      "  kind PATH            'file', 'dir' or 'none'\n"
+      "  proplist PATH        node properties as a hash dump\n"
+      "  propget NAME PATH    raw value of a node property\n"
+      "  revprop NAME         raw value of a revision property\n"
+      "  changed              the output of 'svnlook changed-details'\n"
+      "  quit                 end the session (so does end of input)\n"
+      "\n"
+      "Every answer starts with a line 'ok LENGTH' or 'error LENGTH',\n"
+      "followed by LENGTH bytes of data or error message and a newline.\n"
+      "A missing property is reported as an error.\n"
+   )},
+   {'r', 't'} },
+
   {"cat", subcommand_cat, {0}, {N_(
       "usage: svnlook cat REPOS_PATH FILE_PATH\n"
       "\n"), N_(
@@ -235,6 +261,33 @@ static const svn_opt_subcommand_desc3_t cmd_table[] =
    )},
    {'r', 't', svnlook__copy_info} },
 
+  {"changed-details", subcommand_changed_details, {0}, {N_(
+      "usage: svnlook changed-details REPOS_PATH\n"
+      "\n"), N_(
+      "Print the paths that were changed together with their node kind,\n"
+      "copy source, properties and, for files, size and checksums, all in\n"
+      "one pass.  Each path gets a record like this, which ends with\n"
+      "an empty line and leaves out the details of deleted paths:\n"
+      "\n"
+      "  U   trunk/file\n"
+      "  Node-kind: file\n"
+      "  Node-copyfrom-path: branches/file\n"
+      "  Node-copyfrom-rev: 5\n"
+      "  Text-content-length: 12\n"
+      "  Text-content-md5: ...\n"
+      "  Text-content-sha1: ...\n"
+      "  K 13\n"
+      "  svn:eol-style\n"
+      "  V 6\n"
+      "  native\n"
+      "  PROPS-END\n"
+      "\n"
+      "The first line shows the change like 'svnlook changed' does, with\n"
+      "'R' for replacements.  The properties follow the dump file format.\n"
+      "Paths are UTF-8.\n"
+   )},
+   {'r', 't'} },
+
   {"date", subcommand_date, {0}, {N_(
       "usage: svnlook date REPOS_PATH\n"
       "\n"), N_(
@@ -327,6 +380,17 @@ static const svn_opt_subcommand_desc3_t cmd_table[] =
    {'r', 't', 'v', svnlook__revprop_opt, svnlook__xml_opt,
     svnlook__show_inherited_props} },
 
+  {"tar", subcommand_tar, {0}, {N_(
+      "usage: svnlook tar REPOS_PATH [PATH_IN_REPOS]\n"
+      "\n"), N_(
+      "Write the tree at PATH_IN_REPOS (if supplied, at the root of the\n"
+      "tree otherwise) to standard output as a tar archive, with line\n"
+      "endings and keywords translated as 'svn export' would do.  The\n"
+      "archive's top-level directory is named after the last component of\n"
+      "PATH_IN_REPOS, or after the repository.  Externals are not included.\n"
+   )},
+   {'r', 't', 'N', 'M'} },
+
   {"tree", subcommand_tree, {0}, {N_(
       "usage: svnlook tree REPOS_PATH [PATH_IN_REPOS]\n"
       "\n"), N_(
@@ -2061,6 +2125,411 @@ do_tree(svnlook_ctxt_t *c,
   return SVN_NO_ERROR;
 }
 
+/* Write the tree at PATH as tar archive to stdout, recursively unless
+   RECURSE is FALSE. */
+static svn_error_t *
+do_tar(svnlook_ctxt_t *c,
+       const char *path,
+       svn_boolean_t recurse,
+       apr_pool_t *pool)
+{
+  svn_fs_root_t *root;
+  svn_stream_t *stdout_stream;
+  const char *repos_abspath;
+  const char *repos_root_url;
+  const char *archive_root;
+
+  SVN_ERR(svn_dirent_get_absolute(&repos_abspath,
+                                  svn_repos_path(c->repos, pool), pool));
+  SVN_ERR(svn_uri_get_file_url_from_dirent(&repos_root_url, repos_abspath,
+                                           pool));
+
+  path = svn_fspath__canonicalize(path, pool);
+  if (svn_fspath__is_root(path, strlen(path)))
+    archive_root = svn_dirent_basename(repos_abspath, pool);
+  else
+    archive_root = svn_fspath__basename(path, pool);
+
+  SVN_ERR(get_root(&root, c, pool));
+  SVN_ERR(svn_stream_for_stdout(&stdout_stream, pool));
+
+  return svn_error_trace(svn_repos_export_tar(stdout_stream, root, path,
+                                              archive_root,
+                                              recurse ? svn_depth_infinity
+                                                      : svn_depth_files,
+                                              FALSE, NULL, repos_root_url,
+                                              NULL, NULL,
+                                              check_cancel, NULL, pool));
+}
+
+
+/* Write the record of CHANGE in ROOT to OUT, in the format described
+   in the help text of 'svnlook changed-details'. */
+static svn_error_t *
+write_change_details(svn_stream_t *out,
+                     svn_fs_root_t *root,
+                     const svn_fs_path_change3_t *change,
+                     apr_pool_t *pool)
+{
+  const char *path = change->path.data;
+  svn_node_kind_t kind = change->node_kind;
+  char status[4] = "_  ";
+  apr_hash_t *props;
+
+  switch (change->change_kind)
+    {
+      case svn_fs_path_change_add:
+        status[0] = 'A';
+        break;
+      case svn_fs_path_change_delete:
+        status[0] = 'D';
+        break;
+      case svn_fs_path_change_replace:
+        status[0] = 'R';
+        break;
+      default:
+        if (change->text_mod)
+          status[0] = 'U';
+        break;
+    }
+  if (change->prop_mod && change->change_kind != svn_fs_path_change_delete)
+    status[1] = 'U';
+
+  if (change->change_kind != svn_fs_path_change_delete
+      && kind == svn_node_unknown)
+    SVN_ERR(svn_fs_check_path(&kind, root, path, pool));
+
+  /* Remove the leading slash for consistency with 'svnlook changed'. */
+  SVN_ERR(svn_stream_printf(out, pool, "%s %s%s\n", status,
+                            path[0] == '/' ? path + 1 : path,
+                            kind == svn_node_dir ? "/" : ""));
+
+  if (change->change_kind == svn_fs_path_change_delete)
+    return svn_error_trace(svn_stream_puts(out, "\n"));
+
+  SVN_ERR(svn_stream_printf(out, pool, "%s: %s\n",
+                            SVN_REPOS_DUMPFILE_NODE_KIND,
+                            kind == svn_node_dir ? "dir" : "file"));
+
+  if (change->change_kind == svn_fs_path_change_add
+      || change->change_kind == svn_fs_path_change_replace)
+    {
+      svn_revnum_t copyfrom_rev = change->copyfrom_rev;
+      const char *copyfrom_path = change->copyfrom_path;
+
+      if (!change->copyfrom_known)
+        SVN_ERR(svn_fs_copied_from(&copyfrom_rev, &copyfrom_path, root, path,
+                                   pool));
+
+      if (copyfrom_path)
+        SVN_ERR(svn_stream_printf(out, pool, "%s: %s\n%s: %ld\n",
+                                  SVN_REPOS_DUMPFILE_NODE_COPYFROM_PATH,
+                                  copyfrom_path[0] == '/'
+                                    ? copyfrom_path + 1 : copyfrom_path,
+                                  SVN_REPOS_DUMPFILE_NODE_COPYFROM_REV,
+                                  copyfrom_rev));
+    }
+
+  if (kind == svn_node_file)
+    {
+      svn_filesize_t length;
+      svn_checksum_t *md5;
+      svn_checksum_t *sha1;
+
+      SVN_ERR(svn_fs_file_length(&length, root, path, pool));
+      SVN_ERR(svn_fs_file_checksum(&md5, svn_checksum_md5, root, path,
+                                   TRUE, pool));
+      SVN_ERR(svn_fs_file_checksum(&sha1, svn_checksum_sha1, root, path,
+                                   TRUE, pool));
+      SVN_ERR(svn_stream_printf(out, pool,
+                                "%s: %" SVN_FILESIZE_T_FMT "\n"
+                                "%s: %s\n%s: %s\n",
+                                SVN_REPOS_DUMPFILE_TEXT_CONTENT_LENGTH,
+                                length,
+                                SVN_REPOS_DUMPFILE_TEXT_CONTENT_MD5,
+                                svn_checksum_to_cstring_display(md5, pool),
+                                SVN_REPOS_DUMPFILE_TEXT_CONTENT_SHA1,
+                                svn_checksum_to_cstring_display(sha1, pool)));
+    }
+
+  SVN_ERR(svn_fs_node_proplist(&props, root, path, pool));
+  SVN_ERR(svn_hash_write2(props, out, SVN_HASH_TERMINATOR, pool));
+
+  return svn_error_trace(svn_stream_puts(out, "\n"));
+}
+
+/* Write the records of all paths changed in the revision or transaction
+   of C to OUT, sorted by path. */
+static svn_error_t *
+write_changed_details(svn_stream_t *out,
+                      svnlook_ctxt_t *c,
+                      apr_pool_t *pool)
+{
+  svn_fs_root_t *root;
+  svn_fs_path_change_iterator_t *iterator;
+  svn_fs_path_change3_t *change;
+  apr_hash_t *changes = apr_hash_make(pool);
+  apr_array_header_t *sorted;
+  apr_pool_t *iterpool;
+  int i;
+
+  SVN_ERR(get_root(&root, c, pool));
+  SVN_ERR(svn_fs_paths_changed3(&iterator, root, pool, pool));
+
+  SVN_ERR(svn_fs_path_change_get(&change, iterator));
+  while (change)
+    {
+      change = svn_fs_path_change3_dup(change, pool);
+      svn_hash_sets(changes, change->path.data, change);
+      SVN_ERR(svn_fs_path_change_get(&change, iterator));
+    }
+
+  sorted = svn_sort__hash(changes, svn_sort_compare_items_as_paths, pool);
+
+  iterpool = svn_pool_create(pool);
+  for (i = 0; i < sorted->nelts; i++)
+    {
+      svn_pool_clear(iterpool);
+      SVN_ERR(check_cancel(NULL));
+
+      change = APR_ARRAY_IDX(sorted, i, svn_sort__item_t).value;
+      SVN_ERR(write_change_details(out, root, change, iterpool));
+    }
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Print the details of all paths changed in the revision or transaction
+   of C. */
+static svn_error_t *
+do_changed_details(svnlook_ctxt_t *c, apr_pool_t *pool)
+{
+  svn_stream_t *stdout_stream;
+
+  SVN_ERR(svn_stream_for_stdout(&stdout_stream, pool));
+
+  return svn_error_trace(write_changed_details(stdout_stream, c, pool));
+}
+
+/* Write a 'svnlook batch' answer with STATUS and the LEN bytes of DATA to
+   OUT. */
+static svn_error_t *
+write_batch_answer(svn_stream_t *out,
+                   const char *status,
+                   const char *data,
+                   apr_size_t len,
+                   apr_pool_t *pool)
+{
+  SVN_ERR(svn_stream_printf(out, pool, "%s %" APR_SIZE_T_FMT "\n",
+                            status, len));
+  SVN_ERR(svn_stream_write(out, data, &len));
+
+  return svn_error_trace(svn_stream_puts(out, "\n"));
+}
+
+/* Return the canonical fspath for the user-supplied PATH. */
+static const char *
+batch_path(const char *path,
+           apr_pool_t *pool)
+{
+  if (!*path)
+    path = "/";
+
+  return svn_fspath__canonicalize(path, pool);
+}
+
+/* Run the 'svnlook batch' QUERY with ARGS against ROOT of C.  Put the
+   answer into ANSWER, unless *WRITTEN gets set; in that case, the
+   answer has been written to OUT already.  Errors returned while
+   *WRITTEN is set leave OUT in an undefined state. */
+static svn_error_t *
+run_batch_query(svn_stringbuf_t *answer,
+                svn_boolean_t *written,
+                svn_stream_t *out,
+                svnlook_ctxt_t *c,
+                svn_fs_root_t *root,
+                const char *query,
+                const char *args,
+                apr_pool_t *pool)
+{
+  svn_node_kind_t kind;
+
+  *written = FALSE;
+
+  if (strcmp(query, "cat") == 0)
+    {
+      const char *path = batch_path(args, pool);
+      svn_stream_t *contents;
+      svn_filesize_t length;
+
+      SVN_ERR(verify_path(&kind, root, path, pool));
+      if (kind != svn_node_file)
+        return svn_error_createf(SVN_ERR_FS_NOT_FILE, NULL,
+                                 _("Path '%s' is not a file"), path);
+
+      SVN_ERR(svn_fs_file_length(&length, root, path, pool));
+      SVN_ERR(svn_fs_file_contents(&contents, root, path, pool));
+
+      *written = TRUE;
+      SVN_ERR(svn_stream_printf(out, pool, "ok %" SVN_FILESIZE_T_FMT "\n",
+                                length));
+      SVN_ERR(svn_stream_copy3(contents, svn_stream_disown(out, pool),
+                               check_cancel, NULL, pool));
+      SVN_ERR(svn_stream_puts(out, "\n"));
+    }
+  else if (strcmp(query, "filesize") == 0)
+    {
+      const char *path = batch_path(args, pool);
+      svn_filesize_t length;
+
+      SVN_ERR(verify_path(&kind, root, path, pool));
+      if (kind != svn_node_file)
+        return svn_error_createf(SVN_ERR_FS_NOT_FILE, NULL,
+                                 _("Path '%s' is not a file"), path);
+
+      SVN_ERR(svn_fs_file_length(&length, root, path, pool));
+      svn_stringbuf_appendcstr(answer,
+                               apr_psprintf(pool, "%" SVN_FILESIZE_T_FMT,
+                                            length));
+    }
+  else if (strcmp(query, "kind") == 0)
+    {
+      SVN_ERR(svn_fs_check_path(&kind, root, batch_path(args, pool), pool));
+      svn_stringbuf_appendcstr(answer, svn_node_kind_to_word(kind));
+    }
+  else if (strcmp(query, "proplist") == 0)
+    {
+      const char *path = batch_path(args, pool);
+      apr_hash_t *props;
+
+      SVN_ERR(verify_path(&kind, root, path, pool));
+      SVN_ERR(svn_fs_node_proplist(&props, root, path, pool));
+      SVN_ERR(svn_hash_write2(props, svn_stream_from_stringbuf(answer, pool),
+                              SVN_HASH_TERMINATOR, pool));
+    }
+  else if (strcmp(query, "propget") == 0)
+    {
+      const char *name;
+      const char *path = strchr(args, ' ');
+      svn_string_t *value;
+
+      if (!path)
+        return svn_error_create(SVN_ERR_CL_INSUFFICIENT_ARGS, NULL,
+                                _("Missing property name or path"));
+
+      name = apr_pstrmemdup(pool, args, path - args);
+      path = batch_path(path + 1, pool);
+
+      SVN_ERR(verify_path(&kind, root, path, pool));
+      SVN_ERR(svn_fs_node_prop(&value, root, path, name, pool));
+      if (!value)
+        return svn_error_createf(SVN_ERR_PROPERTY_NOT_FOUND, NULL,
+                                 _("Property '%s' not found on path '%s'"),
+                                 name, path);
+
+      svn_stringbuf_appendbytes(answer, value->data, value->len);
+    }
+  else if (strcmp(query, "revprop") == 0)
+    {
+      svn_string_t *value;
+
+      SVN_ERR(get_property(&value, c, args, pool));
+      if (!value)
+        return svn_error_createf(SVN_ERR_PROPERTY_NOT_FOUND, NULL,
+                                 _("Property '%s' not found"), args);
+
+      svn_stringbuf_appendbytes(answer, value->data, value->len);
+    }
+  else if (strcmp(query, "changed") == 0)
+    {
+      SVN_ERR(write_changed_details(svn_stream_from_stringbuf(answer, pool),
+                                    c, pool));
+    }
+  else
+    {
+      return svn_error_createf(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
+                               _("Unknown query '%s'"), query);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Answer the queries read from stdin about the revision or transaction
+   of C, as described in the help text of 'svnlook batch'. */
+static svn_error_t *
+do_batch(svnlook_ctxt_t *c, apr_pool_t *pool)
+{
+  svn_stream_t *in;
+  svn_stream_t *out;
+  svn_fs_root_t *root;
+  svn_stringbuf_t *answer = svn_stringbuf_create_empty(pool);
+  apr_pool_t *iterpool = svn_pool_create(pool);
+
+  SVN_ERR(svn_stream_for_stdin2(&in, TRUE, pool));
+  SVN_ERR(svn_stream_for_stdout(&out, pool));
+  SVN_ERR(get_root(&root, c, pool));
+
+  while (TRUE)
+    {
+      svn_stringbuf_t *line;
+      svn_boolean_t eof;
+      svn_boolean_t written;
+      char *space;
+      const char *args = "";
+      svn_error_t *err;
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(check_cancel(NULL));
+
+      SVN_ERR(svn_stream_readline(in, &line, "\n", &eof, iterpool));
+      if (eof && !line->len)
+        break;
+
+      /* Tolerate CRLF input. */
+      if (line->len && line->data[line->len - 1] == '\r')
+        svn_stringbuf_chop(line, 1);
+      if (!line->len)
+        continue;
+      if (strcmp(line->data, "quit") == 0)
+        break;
+
+      space = strchr(line->data, ' ');
+      if (space)
+        {
+          *space = '\0';
+          args = space + 1;
+        }
+
+      svn_stringbuf_setempty(answer);
+      err = run_batch_query(answer, &written, out, c, root, line->data,
+                            args, iterpool);
+      if (err && (written || err->apr_err == SVN_ERR_CANCELLED))
+        return svn_error_trace(err);
+
+      if (err)
+        {
+          char buf[256];
+          const char *message
+            = apr_psprintf(iterpool, "svnlook: E%06d: %s", err->apr_err,
+                           svn_err_best_message(err, buf, sizeof(buf)));
+
+          svn_error_clear(err);
+          SVN_ERR(write_batch_answer(out, "error", message, strlen(message),
+                                     iterpool));
+        }
+      else if (!written)
+        SVN_ERR(write_batch_answer(out, "ok", answer->data, answer->len,
+                                   iterpool));
+
+      if (eof)
+        break;
+    }
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
 
 /* Custom filesystem warning function. */
 static void
@@ -2148,6 +2617,20 @@ subcommand_author(apr_getopt_t *os, void *baton, apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+/* This implements `svn_opt_subcommand_t'. */
+static svn_error_t *
+subcommand_batch(apr_getopt_t *os, void *baton, apr_pool_t *pool)
+{
+  struct svnlook_opt_state *opt_state = baton;
+  svnlook_ctxt_t *c;
+
+  SVN_ERR(check_number_of_args(opt_state, 0));
+
+  SVN_ERR(get_ctxt_baton(&c, opt_state, pool));
+  SVN_ERR(do_batch(c, pool));
+  return SVN_NO_ERROR;
+}
+
 /* This implements `svn_opt_subcommand_t'. */
 static svn_error_t *
 subcommand_cat(apr_getopt_t *os, void *baton, apr_pool_t *pool)
@@ -2176,6 +2659,20 @@ subcommand_changed(apr_getopt_t *os, void *baton, apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+/* This implements `svn_opt_subcommand_t'. */
+static svn_error_t *
+subcommand_changed_details(apr_getopt_t *os, void *baton, apr_pool_t *pool)
+{
+  struct svnlook_opt_state *opt_state = baton;
+  svnlook_ctxt_t *c;
+
+  SVN_ERR(check_number_of_args(opt_state, 0));
+
+  SVN_ERR(get_ctxt_baton(&c, opt_state, pool));
+  SVN_ERR(do_changed_details(c, pool));
+  return SVN_NO_ERROR;
+}
+
 /* This implements `svn_opt_subcommand_t'. */
 static svn_error_t *
 subcommand_date(apr_getopt_t *os, void *baton, apr_pool_t *pool)
@@ -2425,6 +2922,23 @@ subcommand_tree(apr_getopt_t *os, void *baton, apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+/* This implements `svn_opt_subcommand_t'. */
+static svn_error_t *
+subcommand_tar(apr_getopt_t *os, void *baton, apr_pool_t *pool)
+{
+  struct svnlook_opt_state *opt_state = baton;
+  svnlook_ctxt_t *c;
+
+  if (opt_state->arg2 != NULL)
+    return svn_error_create(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
+                            _("Too many arguments given"));
+
+  SVN_ERR(get_ctxt_baton(&c, opt_state, pool));
+  SVN_ERR(do_tar(c, opt_state->arg1 ? opt_state->arg1 : "/",
+                 ! opt_state->non_recursive, pool));
+  return SVN_NO_ERROR;
+}
+
 /* This implements `svn_opt_subcommand_t'. */
 static svn_error_t *
 subcommand_youngest(apr_getopt_t *os, void *baton, apr_pool_t *pool)
@@ -138,101 +138,111 @@ struct action {
   const svn_string_t *prop_value;
 };
 
+/* Baton for open_put_source(). */
+struct put_source_baton {
+  const char *path;
+};
+
+/* Implements svn_stream_lazyopen_func_t.  Open the local file of a put,
+   so that bulk puts don't keep all their files open until the commit. */
 static svn_error_t *
-execute(const apr_array_header_t *actions,
-        const char *anchor,
-        apr_hash_t *revprops,
-        svn_revnum_t base_revision,
-        svn_client_ctx_t *ctx,
-        apr_pool_t *pool)
+open_put_source(svn_stream_t **stream,
+                void *baton,
+                apr_pool_t *result_pool,
+                apr_pool_t *scratch_pool)
 {
-  svn_client__mtcc_t *mtcc;
-  apr_pool_t *iterpool = svn_pool_create(pool);
-  svn_error_t *err;
-  int i;
+  struct put_source_baton *psb = baton;
 
-  SVN_ERR(svn_client__mtcc_create(&mtcc, anchor,
-                                  SVN_IS_VALID_REVNUM(base_revision)
-                                     ? base_revision
-                                     : SVN_INVALID_REVNUM,
-                                  ctx, pool, iterpool));
+  return svn_error_trace(svn_stream_open_readonly(stream, psb->path,
+                                                  result_pool,
+                                                  scratch_pool));
+}
 
-  for (i = 0; i < actions->nelts; ++i)
-    {
-      struct action *action = APR_ARRAY_IDX(actions, i, struct action *);
-      const char *path1, *path2;
-      svn_node_kind_t kind;
+/* Add ACTION to MTCC, whose URLs are relative to ANCHOR.  Allocate what
+   needs to live until the commit in RESULT_POOL and use SCRATCH_POOL for
+   temporary allocations. */
+static svn_error_t *
+execute_action(const struct action *action,
+               const char *anchor,
+               svn_client__mtcc_t *mtcc,
+               apr_pool_t *result_pool,
+               apr_pool_t *scratch_pool)
+{
+  const char *path1, *path2 = NULL;
+  svn_node_kind_t kind;
 
-      svn_pool_clear(iterpool);
+  path1 = subtract_anchor(anchor, action->path[0], scratch_pool);
+  if (action->action == ACTION_MV || action->action == ACTION_CP)
+    path2 = subtract_anchor(anchor, action->path[1], scratch_pool);
+
+  if (!path1 || ((action->action == ACTION_MV || action->action == ACTION_CP)
+                 && !path2))
+    return svn_error_createf(SVN_ERR_INCORRECT_PARAMS, NULL,
+                             "URLs in the action list must be within "
+                             "'%s'", anchor);
 
-      switch (action->action)
+  switch (action->action)
+    {
+    case ACTION_MV:
+      SVN_ERR(svn_client__mtcc_add_move(path1, path2, mtcc, scratch_pool));
+      break;
+    case ACTION_CP:
+      SVN_ERR(svn_client__mtcc_add_copy(path1, action->rev, path2,
+                                        mtcc, scratch_pool));
+      break;
+    case ACTION_RM:
+      SVN_ERR(svn_client__mtcc_add_delete(path1, mtcc, scratch_pool));
+      break;
+    case ACTION_MKDIR:
+      SVN_ERR(svn_client__mtcc_add_mkdir(path1, mtcc, scratch_pool));
+      break;
+    case ACTION_PUT:
+      SVN_ERR(svn_client__mtcc_check_path(&kind, path1, TRUE, mtcc,
+                                          scratch_pool));
+
+      if (kind == svn_node_dir)
         {
-        case ACTION_MV:
-          path1 = subtract_anchor(anchor, action->path[0], pool);
-          path2 = subtract_anchor(anchor, action->path[1], pool);
-          SVN_ERR(svn_client__mtcc_add_move(path1, path2, mtcc, iterpool));
-          break;
-        case ACTION_CP:
-          path1 = subtract_anchor(anchor, action->path[0], pool);
-          path2 = subtract_anchor(anchor, action->path[1], pool);
-          SVN_ERR(svn_client__mtcc_add_copy(path1, action->rev, path2,
-                                            mtcc, iterpool));
-          break;
-        case ACTION_RM:
-          path1 = subtract_anchor(anchor, action->path[0], pool);
-          SVN_ERR(svn_client__mtcc_add_delete(path1, mtcc, iterpool));
-          break;
-        case ACTION_MKDIR:
-          path1 = subtract_anchor(anchor, action->path[0], pool);
-          SVN_ERR(svn_client__mtcc_add_mkdir(path1, mtcc, iterpool));
-          break;
-        case ACTION_PUT:
-          path1 = subtract_anchor(anchor, action->path[0], pool);
-          SVN_ERR(svn_client__mtcc_check_path(&kind, path1, TRUE, mtcc, pool));
+          SVN_ERR(svn_client__mtcc_add_delete(path1, mtcc, scratch_pool));
+          kind = svn_node_none;
+        }
 
-          if (kind == svn_node_dir)
-            {
-              SVN_ERR(svn_client__mtcc_add_delete(path1, mtcc, pool));
-              kind = svn_node_none;
-            }
+      {
+        svn_stream_t *src;
 
+        if (strcmp(action->path[1], "-") != 0)
           {
-            svn_stream_t *src;
-
-            if (strcmp(action->path[1], "-") != 0)
-              SVN_ERR(svn_stream_open_readonly(&src, action->path[1],
-                                               pool, iterpool));
-            else
-              SVN_ERR(svn_stream_for_stdin2(&src, TRUE, pool));
-
-
-            if (kind == svn_node_file)
-              SVN_ERR(svn_client__mtcc_add_update_file(path1, src, NULL,
-                                                       NULL, NULL,
-                                                       mtcc, iterpool));
-            else if (kind == svn_node_none)
-              SVN_ERR(svn_client__mtcc_add_add_file(path1, src, NULL,
-                                                    mtcc, iterpool));
+            struct put_source_baton *psb = apr_palloc(result_pool,
+                                                      sizeof(*psb));
+
+            psb->path = apr_pstrdup(result_pool, action->path[1]);
+            src = svn_stream_lazyopen_create(open_put_source, psb, FALSE,
+                                             result_pool);
           }
-          break;
-        case ACTION_PROPSET:
-        case ACTION_PROPDEL:
-          path1 = subtract_anchor(anchor, action->path[0], pool);
-          SVN_ERR(svn_client__mtcc_add_propset(path1, action->prop_name,
-                                               action->prop_value, FALSE,
-                                               mtcc, iterpool));
-          break;
-        case ACTION_PROPSETF:
-        default:
-          SVN_ERR_MALFUNCTION_NO_RETURN();
-        }
+        else
+          SVN_ERR(svn_stream_for_stdin2(&src, TRUE, result_pool));
+
+
+        if (kind == svn_node_file)
+          SVN_ERR(svn_client__mtcc_add_update_file(path1, src, NULL,
+                                                   NULL, NULL,
+                                                   mtcc, scratch_pool));
+        else if (kind == svn_node_none)
+          SVN_ERR(svn_client__mtcc_add_add_file(path1, src, NULL,
+                                                mtcc, scratch_pool));
+      }
+      break;
+    case ACTION_PROPSET:
+    case ACTION_PROPDEL:
+      SVN_ERR(svn_client__mtcc_add_propset(path1, action->prop_name,
+                                           action->prop_value, FALSE,
+                                           mtcc, scratch_pool));
+      break;
+    case ACTION_PROPSETF:
+    default:
+      SVN_ERR_MALFUNCTION_NO_RETURN();
     }
 
-  err = svn_client__mtcc_commit(revprops, commit_callback, NULL,
-                                mtcc, iterpool);
-
-  svn_pool_destroy(iterpool);
-  return svn_error_trace(err);
+  return SVN_NO_ERROR;
 }
 
 static svn_error_t *
@@ -318,6 +328,10 @@ help(FILE *stream, apr_pool_t *pool)
       "                           separately classified certificate errors).\n"
       "  -X [--extra-args] ARG  : append arguments from file ARG (one per line;\n"
       "                           use \"-\" to read from standard input)\n"
+      "  --manifest ARG         : like --extra-args, but add the actions while\n"
+      "                           reading ARG instead of reading it first;\n"
+      "                           requires --root-url, which must contain all\n"
+      "                           URLs, and is intended for very large commits\n"
       "  --config-dir ARG       : use ARG to override the config directory\n"
       "  --config-option ARG    : use ARG to override a configuration option\n"
       "  --no-auth-cache        : do not cache authentication tokens\n"
@@ -402,6 +416,342 @@ sanitize_log_sources(const char **final_message,
   return SVN_NO_ERROR;
 }
 
+/* Parse the action starting at index *INDEX of ACTION_ARGS into a new
+   action in *ACTION_P and advance *INDEX past its arguments.  Set
+   *ACTION_P to NULL if the action is a request for help.  Resolve URLs
+   relative to ROOT_URL, if not NULL.  If ANCHOR is not NULL, update
+   *ANCHOR to the common ancestor of the URLs seen so far.  Allocate
+   everything in POOL. */
+static svn_error_t *
+parse_action(struct action **action_p,
+             const apr_array_header_t *action_args,
+             int *index,
+             const char *root_url,
+             const char **anchor,
+             apr_pool_t *pool)
+{
+  int i = *index;
+  int j, num_url_args;
+  const char *action_string = APR_ARRAY_IDX(action_args, i, const char *);
+  struct action *action = apr_pcalloc(pool, sizeof(*action));
+
+  /* First, parse the action. */
+  if (! strcmp(action_string, "mv"))
+    action->action = ACTION_MV;
+  else if (! strcmp(action_string, "cp"))
+    action->action = ACTION_CP;
+  else if (! strcmp(action_string, "mkdir"))
+    action->action = ACTION_MKDIR;
+  else if (! strcmp(action_string, "rm"))
+    action->action = ACTION_RM;
+  else if (! strcmp(action_string, "put"))
+    action->action = ACTION_PUT;
+  else if (! strcmp(action_string, "propset"))
+    action->action = ACTION_PROPSET;
+  else if (! strcmp(action_string, "propsetf"))
+    action->action = ACTION_PROPSETF;
+  else if (! strcmp(action_string, "propdel"))
+    action->action = ACTION_PROPDEL;
+  else if (! strcmp(action_string, "?") || ! strcmp(action_string, "h")
+           || ! strcmp(action_string, "help"))
+    {
+      *action_p = NULL;
+      *index = i + 1;
+      return SVN_NO_ERROR;
+    }
+  else
+    return svn_error_createf(SVN_ERR_INCORRECT_PARAMS, NULL,
+                             "'%s' is not an action\n",
+                             action_string);
+  if (++i == action_args->nelts)
+    return insufficient();
+
+  /* For copies, there should be a revision number next. */
+  if (action->action == ACTION_CP)
+    {
+      const char *rev_str = APR_ARRAY_IDX(action_args, i, const char *);
+      if (strcmp(rev_str, "head") == 0)
+        action->rev = SVN_INVALID_REVNUM;
+      else if (strcmp(rev_str, "HEAD") == 0)
+        action->rev = SVN_INVALID_REVNUM;
+      else
+        {
+          char *end;
+
+          while (*rev_str == 'r')
+            ++rev_str;
+
+          action->rev = strtol(rev_str, &end, 0);
+          if (*end)
+            return svn_error_createf(SVN_ERR_INCORRECT_PARAMS, NULL,
+                                     "'%s' is not a revision\n",
+                                     rev_str);
+        }
+      if (++i == action_args->nelts)
+        return insufficient();
+    }
+  else
+    {
+      action->rev = SVN_INVALID_REVNUM;
+    }
+
+  /* For puts, there should be a local file next. */
+  if (action->action == ACTION_PUT)
+    {
+      action->path[1] =
+        svn_dirent_internal_style(APR_ARRAY_IDX(action_args, i,
+                                                const char *), pool);
+      if (++i == action_args->nelts)
+        return insufficient();
+    }
+
+  /* For propset, propsetf, and propdel, a property name (and
+     maybe a property value or file which contains one) comes next. */
+  if ((action->action == ACTION_PROPSET)
+      || (action->action == ACTION_PROPSETF)
+      || (action->action == ACTION_PROPDEL))
+    {
+      action->prop_name = APR_ARRAY_IDX(action_args, i, const char *);
+      if (++i == action_args->nelts)
+        return insufficient();
+
+      if (action->action == ACTION_PROPDEL)
+        {
+          action->prop_value = NULL;
+        }
+      else if (action->action == ACTION_PROPSET)
+        {
+          action->prop_value =
+            svn_string_create(APR_ARRAY_IDX(action_args, i,
+                                            const char *), pool);
+          if (++i == action_args->nelts)
+            return insufficient();
+        }
+      else
+        {
+          const char *propval_file =
+            svn_dirent_internal_style(APR_ARRAY_IDX(action_args, i,
+                                                    const char *), pool);
+
+          if (++i == action_args->nelts)
+            return insufficient();
+
+          SVN_ERR(read_propvalue_file(&(action->prop_value),
+                                      propval_file, pool));
+
+          action->action = ACTION_PROPSET;
+        }
+
+      if (action->prop_value
+          && svn_prop_needs_translation(action->prop_name))
+        {
+          svn_string_t *translated_value;
+          SVN_ERR_W(svn_subst_translate_string2(&translated_value, NULL,
+                                                NULL, action->prop_value,
+                                                NULL, FALSE, pool, pool),
+                    "Error normalizing property value");
+          action->prop_value = translated_value;
+        }
+    }
+
+  /* How many URLs does this action expect? */
+  if (action->action == ACTION_RM
+      || action->action == ACTION_MKDIR
+      || action->action == ACTION_PUT
+      || action->action == ACTION_PROPSET
+      || action->action == ACTION_PROPSETF /* shouldn't see this one */
+      || action->action == ACTION_PROPDEL)
+    num_url_args = 1;
+  else
+    num_url_args = 2;
+
+  /* Parse the required number of URLs. */
+  for (j = 0; j < num_url_args; ++j)
+    {
+      const char *url = APR_ARRAY_IDX(action_args, i, const char *);
+
+      /* If there's a ROOT_URL, we expect URL to be a path
+         relative to ROOT_URL (and we build a full url from the
+         combination of the two).  Otherwise, it should be a full
+         url. */
+      if (! svn_path_is_url(url))
+        {
+          if (! root_url)
+            return svn_error_createf(SVN_ERR_INCORRECT_PARAMS, NULL,
+                                     "'%s' is not a URL, and "
+                                     "--root-url (-U) not provided\n",
+                                     url);
+          /* ### These relpaths are already URI-encoded. */
+          url = apr_pstrcat(pool, root_url, "/",
+                            svn_relpath_canonicalize(url, pool),
+                            SVN_VA_NULL);
+        }
+      url = sanitize_url(url, pool);
+      action->path[j] = url;
+
+      if (anchor)
+        {
+          /* The first URL arguments to 'cp', 'pd', 'ps' could be the
+             anchor, but the other URLs should be children of the anchor. */
+          if (! (action->action == ACTION_CP && j == 0)
+              && action->action != ACTION_PROPDEL
+              && action->action != ACTION_PROPSET
+              && action->action != ACTION_PROPSETF)
+            url = svn_uri_dirname(url, pool);
+          if (! *anchor)
+            *anchor = url;
+          else
+            {
+              *anchor = svn_uri_get_longest_ancestor(*anchor, url, pool);
+              if (!*anchor || !(*anchor)[0])
+                return svn_error_createf(SVN_ERR_INCORRECT_PARAMS, NULL,
+                                         "URLs in the action list do not "
+                                         "share a common ancestor");
+            }
+        }
+
+      if ((++i == action_args->nelts) && (j + 1 < num_url_args))
+        return insufficient();
+    }
+
+  *action_p = action;
+  *index = i;
+  return SVN_NO_ERROR;
+}
+
+/* Return the number of arguments that follow ACTION_STRING in an action
+   list, or -1 if ACTION_STRING is not an action. */
+static int
+action_arg_count(const char *action_string)
+{
+  if (! strcmp(action_string, "mkdir") || ! strcmp(action_string, "rm"))
+    return 1;
+  else if (! strcmp(action_string, "mv") || ! strcmp(action_string, "put")
+           || ! strcmp(action_string, "propdel"))
+    return 2;
+  else if (! strcmp(action_string, "cp")
+           || ! strcmp(action_string, "propset")
+           || ! strcmp(action_string, "propsetf"))
+    return 3;
+  else
+    return -1;
+}
+
+/* Read the next action from the MANIFEST stream into *ACTION_P, or set
+   *ACTION_P to NULL at the end of the stream.  The manifest uses the same
+   format as --extra-args: one argument per line, in the native encoding,
+   with empty lines being ignored.  Resolve URLs relative to ROOT_URL.
+   Allocate the result in RESULT_POOL and use SCRATCH_POOL for temporary
+   allocations. */
+static svn_error_t *
+read_manifest_action(struct action **action_p,
+                     svn_stream_t *manifest,
+                     const char *root_url,
+                     apr_pool_t *result_pool,
+                     apr_pool_t *scratch_pool)
+{
+  apr_array_header_t *args = apr_array_make(scratch_pool, 4,
+                                            sizeof(const char *));
+  int count = 0;
+  int i = 0;
+
+  *action_p = NULL;
+  while (args->nelts <= count)
+    {
+      svn_stringbuf_t *line;
+      svn_boolean_t eof;
+      const char *arg;
+
+      SVN_ERR(svn_stream_readline(manifest, &line, "\n", &eof,
+                                  scratch_pool));
+      if (line->len && line->data[line->len - 1] == '\r')
+        svn_stringbuf_chop(line, 1);
+
+      if (line->len)
+        {
+          SVN_ERR(svn_utf_cstring_to_utf8(&arg, line->data, result_pool));
+          if (args->nelts == 0)
+            {
+              count = action_arg_count(arg);
+              if (count < 0)
+                return svn_error_createf(SVN_ERR_INCORRECT_PARAMS, NULL,
+                                         "'%s' is not an action\n", arg);
+            }
+          APR_ARRAY_PUSH(args, const char *) = arg;
+        }
+      else if (eof)
+        {
+          if (args->nelts)
+            return insufficient();
+
+          return SVN_NO_ERROR;
+        }
+    }
+
+  return svn_error_trace(parse_action(action_p, args, &i, root_url, NULL,
+                                      result_pool));
+}
+
+static svn_error_t *
+execute(const apr_array_header_t *actions,
+        svn_stream_t *manifest,
+        const char *anchor,
+        apr_hash_t *revprops,
+        svn_revnum_t base_revision,
+        svn_client_ctx_t *ctx,
+        apr_pool_t *pool)
+{
+  svn_client__mtcc_t *mtcc;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  svn_error_t *err;
+  int i;
+
+  SVN_ERR(svn_client__mtcc_create(&mtcc, anchor,
+                                  SVN_IS_VALID_REVNUM(base_revision)
+                                     ? base_revision
+                                     : SVN_INVALID_REVNUM,
+                                  ctx, pool, iterpool));
+
+  for (i = 0; i < actions->nelts; ++i)
+    {
+      struct action *action = APR_ARRAY_IDX(actions, i, struct action *);
+
+      svn_pool_clear(iterpool);
+
+      SVN_ERR(execute_action(action, anchor, mtcc, pool, iterpool));
+    }
+
+  /* Add the manifest's actions as we read them, so that only the
+     operation tree has to be kept in memory. */
+  while (manifest)
+    {
+      struct action *action;
+
+      svn_pool_clear(iterpool);
+
+      if (ctx->cancel_func)
+        SVN_ERR(ctx->cancel_func(ctx->cancel_baton));
+
+      SVN_ERR(read_manifest_action(&action, manifest, anchor,
+                                   iterpool, iterpool));
+      if (! action)
+        break;
+
+      if (action->action == ACTION_PUT && ! strcmp(action->path[1], "-"))
+        return svn_error_create(SVN_ERR_INCORRECT_PARAMS, NULL,
+                                "Can't read file contents from standard "
+                                "input in a manifest");
+
+      SVN_ERR(execute_action(action, anchor, mtcc, pool, iterpool));
+    }
+
+  err = svn_client__mtcc_commit(revprops, commit_callback, NULL,
+                                mtcc, iterpool);
+
+  svn_pool_destroy(iterpool);
+  return svn_error_trace(err);
+}
+
 /* Baton for log_message_func */
 struct log_message_baton
 {
@@ -482,7 +832,8 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
     force_interactive_opt,
     trust_server_cert_opt,
     trust_server_cert_failures_opt,
-    password_from_stdin_opt
+    password_from_stdin_opt,
+    manifest_opt
   };
   static const apr_getopt_option_t options[] = {
     {"message", 'm', 1, ""},
@@ -494,6 +845,7 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
     {"revision", 'r', 1, ""},
     {"with-revprop",  with_revprop_opt, 1, ""},
     {"extra-args", 'X', 1, ""},
+    {"manifest", manifest_opt, 1, ""},
     {"help", 'h', 0, ""},
     {NULL, '?', 0, ""},
     {"non-interactive", non_interactive_opt, 0, ""},
@@ -510,6 +862,8 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
   svn_stringbuf_t *filedata = NULL;
   const char *username = NULL, *password = NULL;
   const char *root_url = NULL, *extra_args_file = NULL;
+  const char *manifest_file = NULL;
+  svn_stream_t *manifest = NULL;
   const char *config_dir = NULL;
   apr_array_header_t *config_options;
   svn_boolean_t non_interactive = FALSE;
@@ -607,6 +961,9 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
         case 'X':
           SVN_ERR(svn_utf_cstring_to_utf8(&extra_args_file, arg, pool));
           break;
+        case manifest_opt:
+          SVN_ERR(svn_utf_cstring_to_utf8(&manifest_file, arg, pool));
+          break;
         case non_interactive_opt:
           non_interactive = TRUE;
           break;
@@ -711,6 +1068,29 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
                                FALSE, pool);
     }
 
+  /* The manifest gets read while building the commit, so its URLs can't
+     contribute to the anchor; anchor the commit at the root URL. */
+  if (manifest_file)
+    {
+      if (! root_url)
+        return svn_error_create(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
+                                _("--manifest requires --root-url (-U)"));
+
+      if (strcmp(manifest_file, "-") != 0)
+        SVN_ERR(svn_stream_open_readonly(&manifest,
+                                         svn_dirent_internal_style(
+                                           manifest_file, pool),
+                                         pool, pool));
+      else if (read_pass_from_stdin
+               || (extra_args_file && ! strcmp(extra_args_file, "-")))
+        return svn_error_create(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
+                                _("Only one of --manifest, --extra-args "
+                                  "and --password-from-stdin can read "
+                                  "from standard input"));
+      else
+        SVN_ERR(svn_stream_for_stdin2(&manifest, TRUE, pool));
+    }
+
   /* Now initialize the client context */
 
   err = svn_config_get_config(&cfg_hash, config_dir, pool);
@@ -775,196 +1155,29 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
   /* Now, we iterate over the combined set of arguments -- our actions. */
   for (i = 0; i < action_args->nelts; )
     {
-      int j, num_url_args;
-      const char *action_string = APR_ARRAY_IDX(action_args, i, const char *);
-      struct action *action = apr_pcalloc(pool, sizeof(*action));
-
-      /* First, parse the action. */
-      if (! strcmp(action_string, "mv"))
-        action->action = ACTION_MV;
-      else if (! strcmp(action_string, "cp"))
-        action->action = ACTION_CP;
-      else if (! strcmp(action_string, "mkdir"))
-        action->action = ACTION_MKDIR;
-      else if (! strcmp(action_string, "rm"))
-        action->action = ACTION_RM;
-      else if (! strcmp(action_string, "put"))
-        action->action = ACTION_PUT;
-      else if (! strcmp(action_string, "propset"))
-        action->action = ACTION_PROPSET;
-      else if (! strcmp(action_string, "propsetf"))
-        action->action = ACTION_PROPSETF;
-      else if (! strcmp(action_string, "propdel"))
-        action->action = ACTION_PROPDEL;
-      else if (! strcmp(action_string, "?") || ! strcmp(action_string, "h")
-               || ! strcmp(action_string, "help"))
+      struct action *action;
+
+      SVN_ERR(parse_action(&action, action_args, &i, root_url, &anchor,
+                           pool));
+      if (! action)
         {
           help(stdout, pool);
           return SVN_NO_ERROR;
         }
-      else
-        return svn_error_createf(SVN_ERR_INCORRECT_PARAMS, NULL,
-                                 "'%s' is not an action\n",
-                                 action_string);
-      if (++i == action_args->nelts)
-        return insufficient();
-
-      /* For copies, there should be a revision number next. */
-      if (action->action == ACTION_CP)
-        {
-          const char *rev_str = APR_ARRAY_IDX(action_args, i, const char *);
-          if (strcmp(rev_str, "head") == 0)
-            action->rev = SVN_INVALID_REVNUM;
-          else if (strcmp(rev_str, "HEAD") == 0)
-            action->rev = SVN_INVALID_REVNUM;
-          else
-            {
-              char *end;
-
-              while (*rev_str == 'r')
-                ++rev_str;
-
-              action->rev = strtol(rev_str, &end, 0);
-              if (*end)
-                return svn_error_createf(SVN_ERR_INCORRECT_PARAMS, NULL,
-                                         "'%s' is not a revision\n",
-                                         rev_str);
-            }
-          if (++i == action_args->nelts)
-            return insufficient();
-        }
-      else
-        {
-          action->rev = SVN_INVALID_REVNUM;
-        }
-
-      /* For puts, there should be a local file next. */
-      if (action->action == ACTION_PUT)
-        {
-          action->path[1] =
-            svn_dirent_internal_style(APR_ARRAY_IDX(action_args, i,
-                                                    const char *), pool);
-          if (++i == action_args->nelts)
-            return insufficient();
-        }
-
-      /* For propset, propsetf, and propdel, a property name (and
-         maybe a property value or file which contains one) comes next. */
-      if ((action->action == ACTION_PROPSET)
-          || (action->action == ACTION_PROPSETF)
-          || (action->action == ACTION_PROPDEL))
-        {
-          action->prop_name = APR_ARRAY_IDX(action_args, i, const char *);
-          if (++i == action_args->nelts)
-            return insufficient();
-
-          if (action->action == ACTION_PROPDEL)
-            {
-              action->prop_value = NULL;
-            }
-          else if (action->action == ACTION_PROPSET)
-            {
-              action->prop_value =
-                svn_string_create(APR_ARRAY_IDX(action_args, i,
-                                                const char *), pool);
-              if (++i == action_args->nelts)
-                return insufficient();
-            }
-          else
-            {
-              const char *propval_file =
-                svn_dirent_internal_style(APR_ARRAY_IDX(action_args, i,
-                                                        const char *), pool);
-
-              if (++i == action_args->nelts)
-                return insufficient();
-
-              SVN_ERR(read_propvalue_file(&(action->prop_value),
-                                          propval_file, pool));
-
-              action->action = ACTION_PROPSET;
-            }
-
-          if (action->prop_value
-              && svn_prop_needs_translation(action->prop_name))
-            {
-              svn_string_t *translated_value;
-              SVN_ERR_W(svn_subst_translate_string2(&translated_value, NULL,
-                                                    NULL, action->prop_value,
-                                                    NULL, FALSE, pool, pool),
-                        "Error normalizing property value");
-              action->prop_value = translated_value;
-            }
-        }
-
-      /* How many URLs does this action expect? */
-      if (action->action == ACTION_RM
-          || action->action == ACTION_MKDIR
-          || action->action == ACTION_PUT
-          || action->action == ACTION_PROPSET
-          || action->action == ACTION_PROPSETF /* shouldn't see this one */
-          || action->action == ACTION_PROPDEL)
-        num_url_args = 1;
-      else
-        num_url_args = 2;
-
-      /* Parse the required number of URLs. */
-      for (j = 0; j < num_url_args; ++j)
-        {
-          const char *url = APR_ARRAY_IDX(action_args, i, const char *);
-
-          /* If there's a ROOT_URL, we expect URL to be a path
-             relative to ROOT_URL (and we build a full url from the
-             combination of the two).  Otherwise, it should be a full
-             url. */
-          if (! svn_path_is_url(url))
-            {
-              if (! root_url)
-                return svn_error_createf(SVN_ERR_INCORRECT_PARAMS, NULL,
-                                         "'%s' is not a URL, and "
-                                         "--root-url (-U) not provided\n",
-                                         url);
-              /* ### These relpaths are already URI-encoded. */
-              url = apr_pstrcat(pool, root_url, "/",
-                                svn_relpath_canonicalize(url, pool),
-                                SVN_VA_NULL);
-            }
-          url = sanitize_url(url, pool);
-          action->path[j] = url;
-
-          /* The first URL arguments to 'cp', 'pd', 'ps' could be the anchor,
-             but the other URLs should be children of the anchor. */
-          if (! (action->action == ACTION_CP && j == 0)
-              && action->action != ACTION_PROPDEL
-              && action->action != ACTION_PROPSET
-              && action->action != ACTION_PROPSETF)
-            url = svn_uri_dirname(url, pool);
-          if (! anchor)
-            anchor = url;
-          else
-            {
-              anchor = svn_uri_get_longest_ancestor(anchor, url, pool);
-              if (!anchor || !anchor[0])
-                return svn_error_createf(SVN_ERR_INCORRECT_PARAMS, NULL,
-                                         "URLs in the action list do not "
-                                         "share a common ancestor");
-            }
-
-          if ((++i == action_args->nelts) && (j + 1 < num_url_args))
-            return insufficient();
-        }
 
       APR_ARRAY_PUSH(actions, struct action *) = action;
     }
 
-  if (! actions->nelts)
+  if (manifest)
+    anchor = root_url;
+  else if (! actions->nelts)
     {
       *exit_code = EXIT_FAILURE;
       help(stderr, pool);
       return SVN_NO_ERROR;
     }
 
-  if ((err = execute(actions, anchor, revprops, base_revision, ctx, pool)))
+  if ((err = execute(actions, manifest, anchor, revprops, base_revision, ctx, pool)))
     {
       if (err->apr_err == SVN_ERR_AUTHN_FAILED && non_interactive)
         err = svn_error_quick_wrap(err,
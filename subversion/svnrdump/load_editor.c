@@ -36,28 +36,77 @@
 #include "private/svn_ra_private.h"
 #include "private/svn_mergeinfo_private.h"
 #include "private/svn_fspath.h"
+#include "private/svn_delta_private.h"
+#include "private/svn_worker_pool.h"
 
 #include "svnrdump.h"
 
 #define SVNRDUMP_PROP_LOCK SVN_PROP_PREFIX "rdump-lock"
 
+/* Amount of text delta data per parsed revision to keep in memory while
+   it waits to be committed.  Anything beyond that goes to a temporary
+   file. */
+#define LOAD_SPOOL_MEMORY_SIZE (1024 * 1024)
+
+/* Number of parsed revisions that may wait for the commit of the
+   revisions before them. */
+#define LOAD_PIPELINE_DEPTH 8
+
 #define ARE_VALID_COPY_ARGS(p,r) ((p) && SVN_IS_VALID_REVNUM(r))
 
 
+struct revision_baton;
+
+/* Shared state of the dump stream parser and the committing thread.  All
+   members are protected by the mutex of WORKERS. */
+typedef struct commit_pipeline_t
+{
+  /* Ring buffer of LOAD_PIPELINE_DEPTH parsed revisions waiting to be
+     committed, the oldest one at index FIRST. */
+  struct revision_baton *revs[LOAD_PIPELINE_DEPTH];
+  int first;
+  int count;
+
+  /* If set, the committing thread shall exit once REVS is empty. */
+  svn_boolean_t stop;
+
+  /* Set once the committing thread has finished, with its error. */
+  svn_boolean_t finished;
+  svn_error_t *commit_err;
+
+  /* Runs the commit_job().  Notified whenever any of the above has been
+     changed. */
+  svn_worker_pool__t *workers;
+
+  /* Owns WORKERS. */
+  apr_pool_t *workers_pool;
+} commit_pipeline_t;
+
 /**
  * General baton used by the parser functions.
  */
 struct parse_baton
 {
-  /* Commit editor and baton used to transfer loaded revisions to
-     the target repository. */
+  /* Editor and baton recording the revision being parsed. */
   const svn_delta_editor_t *commit_editor;
   void *commit_edit_baton;
 
-  /* RA session(s) for committing to the target repository. */
+  /* RA session(s) for committing to the target repository.  While
+     revisions are waiting to be committed, they are used by the
+     committing thread only. */
   svn_ra_session_t *session;
   svn_ra_session_t *aux_session;
 
+  /* The youngest revision of the target repository once all parsed
+     revisions have been committed. */
+  svn_revnum_t head_rev;
+
+  /* The revision being parsed, if any. */
+  struct revision_baton *current_rb;
+
+  /* Commits the parsed revisions in the background, or NULL. */
+  commit_pipeline_t *pipeline;
+
   /* To bleep, or not to bleep?  (What kind of question is that?) */
   svn_boolean_t quiet;
 
@@ -149,8 +198,20 @@ struct revision_baton
   const svn_string_t *datestamp;
   const svn_string_t *author;
 
+  /* The recorded editor drive of this revision, or NULL if it has no
+     nodes. */
+  svn_delta__spool_t *spool;
+
+  /* The target repository revision that this one will become, or
+     SVN_INVALID_REVNUM if nothing gets committed. */
+  svn_revnum_t committed_rev;
+
   struct parse_baton *pb;
   struct directory_baton *db;
+
+  /* Owns this structure and everything related to the revision.  It has
+     its own allocator, so it can be used and destroyed by the committing
+     thread. */
   apr_pool_t *pool;
 };
 
@@ -182,21 +243,15 @@ get_revision_mapping(apr_hash_t *rev_map,
 }
 
 
-static svn_error_t *
-commit_callback(const svn_commit_info_t *commit_info,
-                void *baton,
-                apr_pool_t *pool)
+/* Record in PB that the dump stream revision REV becomes revision
+   COMMITTED_REV in the target repository. */
+static void
+map_committed_revision(struct parse_baton *pb,
+                       svn_revnum_t rev,
+                       svn_revnum_t committed_rev)
 {
-  struct revision_baton *rb = baton;
-  struct parse_baton *pb = rb->pb;
-
-  /* ### Don't print directly; generate a notification. */
-  if (! pb->quiet)
-    SVN_ERR(svn_cmdline_printf(pool, "* Loaded revision %ld.\n",
-                               commit_info->revision));
-
   /* Add the mapping of the dumpstream revision to the committed revision. */
-  set_revision_mapping(pb->rev_map, rb->rev, commit_info->revision);
+  set_revision_mapping(pb->rev_map, rev, committed_rev);
 
   /* If the incoming dump stream has non-contiguous revisions (e.g. from
      using svndumpfilter --drop-empty-revs without --renumber-revs) then
@@ -204,18 +259,42 @@ commit_callback(const svn_commit_info_t *commit_info,
      might not be able to map all mergeinfo source revisions to the correct
      revisions in the target repos. */
   if ((pb->last_rev_mapped != SVN_INVALID_REVNUM)
-      && (rb->rev != pb->last_rev_mapped + 1))
+      && (rev != pb->last_rev_mapped + 1))
     {
       svn_revnum_t i;
 
-      for (i = pb->last_rev_mapped + 1; i < rb->rev; i++)
+      for (i = pb->last_rev_mapped + 1; i < rev; i++)
         {
           set_revision_mapping(pb->rev_map, i, pb->last_rev_mapped);
         }
     }
 
   /* Update our "last revision mapped". */
-  pb->last_rev_mapped = rb->rev;
+  pb->last_rev_mapped = rev;
+}
+
+static svn_error_t *
+commit_callback(const svn_commit_info_t *commit_info,
+                void *baton,
+                apr_pool_t *pool)
+{
+  struct revision_baton *rb = baton;
+  struct parse_baton *pb = rb->pb;
+
+  /* The parser has already mapped the revision numbers for the revisions
+     after this one.  That only works if nobody else commits. */
+  if (commit_info->revision != rb->committed_rev)
+    return svn_error_createf(SVN_ERR_RA_OUT_OF_DATE, NULL,
+                             _("Revision %ld was committed as r%ld instead "
+                               "of r%ld; the target repository has been "
+                               "changed during the load"),
+                             rb->rev, commit_info->revision,
+                             rb->committed_rev);
+
+  /* ### Don't print directly; generate a notification. */
+  if (! pb->quiet)
+    SVN_ERR(svn_cmdline_printf(pool, "* Loaded revision %ld.\n",
+                               commit_info->revision));
 
   return SVN_NO_ERROR;
 }
@@ -383,6 +462,287 @@ get_lock(const svn_string_t **lock_string_p,
                                       cancel_func, cancel_baton, pool);
 }
 
+/* Commit the parsed revision RB to the target repository and set its
+ * svn:date and svn:author.  Destroy RB->POOL afterwards.
+ */
+static svn_error_t *
+commit_revision(struct revision_baton *rb)
+{
+  svn_error_t *err = SVN_NO_ERROR;
+
+  /* Fake revision 0 */
+  if (rb->rev == 0)
+    {
+      /* ### Don't print directly; generate a notification. */
+      if (! rb->pb->quiet)
+        err = svn_cmdline_printf(rb->pool, "* Loaded revision 0.\n");
+    }
+  else
+    {
+      const svn_delta_editor_t *commit_editor;
+      void *commit_edit_baton;
+
+      if (rb->spool)
+        err = svn_ra__register_editor_shim_callbacks(rb->pb->session,
+                                    get_shim_callbacks(rb, rb->pool));
+      if (!err)
+        err = svn_ra_get_commit_editor3(rb->pb->session, &commit_editor,
+                                        &commit_edit_baton, rb->revprop_table,
+                                        commit_callback, rb,
+                                        NULL, FALSE, rb->pool);
+      if (err)
+        {
+          svn_pool_destroy(rb->pool);
+          return svn_error_trace(err);
+        }
+
+      if (rb->spool)
+        {
+          err = svn_delta__replay_spool(rb->spool, commit_editor,
+                                        commit_edit_baton, rb->pool);
+        }
+      else
+        {
+          svn_revnum_t head_rev_before_commit = rb->rev - rb->rev_offset - 1;
+          void *child_baton;
+
+          /* Legitimate revision with no node information */
+          err = commit_editor->open_root(commit_edit_baton,
+                                         head_rev_before_commit,
+                                         rb->pool, &child_baton);
+          if (!err)
+            err = commit_editor->close_directory(child_baton, rb->pool);
+        }
+
+      if (!err)
+        err = commit_editor->close_edit(commit_edit_baton, rb->pool);
+      else
+        err = svn_error_compose_create(
+                err, commit_editor->abort_edit(commit_edit_baton, rb->pool));
+    }
+
+  /* svn_fs_commit_txn() rewrites the datestamp and author properties;
+     we'll rewrite them again by hand after closing the commit_editor.
+     The only time we don't do this is for revision 0 when loaded into
+     a non-empty repository.  */
+  if (!err && SVN_IS_VALID_REVNUM(rb->committed_rev))
+    {
+      if (!svn_hash_gets(rb->pb->skip_revprops, SVN_PROP_REVISION_DATE))
+        {
+          err = svn_repos__validate_prop(SVN_PROP_REVISION_DATE,
+                                         rb->datestamp, rb->pool);
+          if (!err)
+            err = svn_ra_change_rev_prop2(rb->pb->session, rb->committed_rev,
+                                          SVN_PROP_REVISION_DATE,
+                                          NULL, rb->datestamp, rb->pool);
+        }
+      if (!err
+          && !svn_hash_gets(rb->pb->skip_revprops, SVN_PROP_REVISION_AUTHOR))
+        {
+          err = svn_repos__validate_prop(SVN_PROP_REVISION_AUTHOR,
+                                         rb->author, rb->pool);
+          if (!err)
+            err = svn_ra_change_rev_prop2(rb->pb->session, rb->committed_rev,
+                                          SVN_PROP_REVISION_AUTHOR,
+                                          NULL, rb->author, rb->pool);
+        }
+    }
+
+  svn_pool_destroy(rb->pool);
+
+  return svn_error_trace(err);
+}
+
+/* Implements svn_worker_pool__func_t.  BATON is the commit_pipeline_t.
+ * Commit the queued revisions in order until told to stop or a commit
+ * fails.
+ */
+static svn_error_t *
+commit_job(void *baton,
+           apr_pool_t *scratch_pool)
+{
+  commit_pipeline_t *pl = baton;
+  svn_error_t *err = SVN_NO_ERROR;
+
+  while (!err)
+    {
+      struct revision_baton *rb;
+
+      err = svn_worker_pool__lock(pl->workers);
+      if (err)
+        break;
+
+      while (!err && !pl->count && !pl->stop
+             && !svn_worker_pool__stopping(pl->workers))
+        err = svn_worker_pool__wait_for_change(pl->workers);
+      rb = (!err && pl->count) ? pl->revs[pl->first] : NULL;
+      err = svn_worker_pool__unlock(pl->workers, err);
+
+      if (err || !rb)
+        break;
+
+      err = commit_revision(rb);
+
+      svn_error_clear(svn_worker_pool__lock(pl->workers));
+      pl->revs[pl->first] = NULL;
+      pl->first = (pl->first + 1) % LOAD_PIPELINE_DEPTH;
+      pl->count--;
+      svn_error_clear(svn_worker_pool__notify(pl->workers));
+      svn_error_clear(svn_worker_pool__unlock(pl->workers, SVN_NO_ERROR));
+    }
+
+  SVN_ERR(svn_worker_pool__lock(pl->workers));
+  pl->commit_err = err;
+  pl->finished = TRUE;
+
+  return svn_error_trace(svn_worker_pool__unlock(pl->workers,
+                           svn_worker_pool__notify(pl->workers)));
+}
+
+/* Start the committing thread of PB, allocating the pipeline in POOL.
+ * Leave PB->PIPELINE NULL if no thread could be started.
+ */
+static svn_error_t *
+start_commit_pipeline(struct parse_baton *pb,
+                      apr_pool_t *pool)
+{
+  commit_pipeline_t *pl = apr_pcalloc(pool, sizeof(*pl));
+  svn_error_t *err;
+
+  pl->workers_pool = svn_pool_create(pool);
+  SVN_ERR(svn_worker_pool__create(&pl->workers, 1, pl->workers_pool));
+  if (!pl->workers)
+    {
+      svn_pool_destroy(pl->workers_pool);
+      return SVN_NO_ERROR;
+    }
+
+  err = svn_worker_pool__post(NULL, pl->workers, commit_job, pl,
+                              pl->workers_pool);
+  if (err)
+    {
+      svn_pool_destroy(pl->workers_pool);
+      return svn_error_trace(err);
+    }
+
+  pb->pipeline = pl;
+  return SVN_NO_ERROR;
+}
+
+/* Let the committing thread of PB commit all queued revisions and wait
+ * for it to exit.  Return ERR, unless the thread failed; its error is
+ * the root cause then.
+ */
+static svn_error_t *
+stop_commit_pipeline(struct parse_baton *pb,
+                     svn_error_t *err)
+{
+  commit_pipeline_t *pl = pb->pipeline;
+
+  if (!pl)
+    return err;
+
+  svn_error_clear(svn_worker_pool__lock(pl->workers));
+  pl->stop = TRUE;
+  svn_error_clear(svn_worker_pool__notify(pl->workers));
+  svn_error_clear(svn_worker_pool__unlock(pl->workers, SVN_NO_ERROR));
+
+  /* Waits for the running job to return. */
+  svn_pool_destroy(pl->workers_pool);
+  pb->pipeline = NULL;
+
+  /* Release what a failed commit left behind. */
+  while (pl->count)
+    {
+      svn_pool_destroy(pl->revs[pl->first]->pool);
+      pl->first = (pl->first + 1) % LOAD_PIPELINE_DEPTH;
+      pl->count--;
+    }
+
+  if (pl->commit_err)
+    {
+      svn_error_clear(err);
+      return pl->commit_err;
+    }
+
+  return err;
+}
+
+/* Hand the completely parsed revision RB over to be committed.  If
+ * there is a committing thread in PB, wait until there is room in its
+ * queue; otherwise, commit RB right away.
+ */
+static svn_error_t *
+queue_revision(struct parse_baton *pb,
+               struct revision_baton *rb)
+{
+  commit_pipeline_t *pl = pb->pipeline;
+
+  if (pl)
+    {
+      svn_boolean_t failed;
+      svn_error_t *err = svn_worker_pool__lock(pl->workers);
+
+      if (err)
+        {
+          svn_pool_destroy(rb->pool);
+          return svn_error_trace(err);
+        }
+
+      while (!err && pl->count == LOAD_PIPELINE_DEPTH && !pl->finished)
+        err = svn_worker_pool__wait_for_change(pl->workers);
+
+      failed = err || pl->finished;
+      if (!failed)
+        {
+          pl->revs[(pl->first + pl->count) % LOAD_PIPELINE_DEPTH] = rb;
+          pl->count++;
+          err = svn_worker_pool__notify(pl->workers);
+        }
+      err = svn_worker_pool__unlock(pl->workers, err);
+
+      /* The committing thread only finishes early when it failed.
+         stop_commit_pipeline() will return its error. */
+      if (failed)
+        {
+          svn_pool_destroy(rb->pool);
+          if (!err)
+            err = svn_error_create(SVN_ERR_CANCELLED, NULL, NULL);
+        }
+
+      return svn_error_trace(err);
+    }
+
+  return svn_error_trace(commit_revision(rb));
+}
+
+/* Wait until all revisions handed over by queue_revision() have been
+ * committed, so that the RA sessions of PB reflect them and may be
+ * used by the parser.
+ */
+static svn_error_t *
+wait_for_commits(struct parse_baton *pb)
+{
+  commit_pipeline_t *pl = pb->pipeline;
+
+  if (pl)
+    {
+      svn_boolean_t failed;
+      svn_error_t *err = SVN_NO_ERROR;
+
+      SVN_ERR(svn_worker_pool__lock(pl->workers));
+      while (!err && pl->count && !pl->finished)
+        err = svn_worker_pool__wait_for_change(pl->workers);
+      failed = pl->finished;
+      SVN_ERR(svn_worker_pool__unlock(pl->workers, err));
+
+      if (failed)
+        return svn_error_create(SVN_ERR_CANCELLED, NULL, NULL);
+    }
+
+  return SVN_NO_ERROR;
+}
+
 static svn_error_t *
 new_revision_record(void **revision_baton,
                     apr_hash_t *headers,
@@ -392,25 +752,27 @@ new_revision_record(void **revision_baton,
   struct revision_baton *rb;
   struct parse_baton *pb;
   const char *rev_str;
-  svn_revnum_t head_rev;
+  apr_pool_t *rev_pool;
 
-  rb = apr_pcalloc(pool, sizeof(*rb));
+  rev_pool = apr_allocator_owner_get(svn_pool_create_allocator(FALSE));
+  rb = apr_pcalloc(rev_pool, sizeof(*rb));
   pb = parse_baton;
-  rb->pool = svn_pool_create(pool);
+  rb->pool = rev_pool;
   rb->pb = pb;
   rb->db = NULL;
+  rb->committed_rev = SVN_INVALID_REVNUM;
+  pb->current_rb = rb;
 
   rev_str = svn_hash_gets(headers, SVN_REPOS_DUMPFILE_REVISION_NUMBER);
   if (rev_str)
     rb->rev = SVN_STR_TO_REV(rev_str);
 
-  SVN_ERR(svn_ra_get_latest_revnum(pb->session, &head_rev, pool));
-
   /* FIXME: This is a lame fallback loading multiple segments of dump in
      several separate operations. It is highly susceptible to race conditions.
      Calculate the revision 'offset' for finding copyfrom sources.
-     It might be positive or negative. */
-  rb->rev_offset = (apr_int32_t) ((rb->rev) - (head_rev + 1));
+     It might be positive or negative.  PB->HEAD_REV already accounts for
+     the revisions still waiting to be committed. */
+  rb->rev_offset = (apr_int32_t) ((rb->rev) - (pb->head_rev + 1));
 
   /* Stash the oldest (non-zero) dumpstream revision seen. */
   if ((rb->rev > 0) && (!SVN_IS_VALID_REVNUM(pb->oldest_dumpstream_rev)))
@@ -512,21 +874,20 @@ new_node_record(void **node_baton,
   if (!commit_editor)
     {
       /* The revprop_table should have been filled in with important
-         information like svn:log in set_revision_property. We can now
-         use it all this information to create our commit_editor. But
+         information like svn:log in set_revision_property. It will be
+         used to create the real commit_editor in commit_revision(). But
          first, clear revprops that we aren't allowed to set with the
          commit_editor. We'll set them separately using the RA API
-         after closing the editor (see close_revision). */
+         after closing the editor (see commit_revision). */
 
       svn_hash_sets(rb->revprop_table, SVN_PROP_REVISION_AUTHOR, NULL);
       svn_hash_sets(rb->revprop_table, SVN_PROP_REVISION_DATE, NULL);
 
-      SVN_ERR(svn_ra__register_editor_shim_callbacks(rb->pb->session,
-                                    get_shim_callbacks(rb, rb->pool)));
-      SVN_ERR(svn_ra_get_commit_editor3(rb->pb->session, &commit_editor,
-                                        &commit_edit_baton, rb->revprop_table,
-                                        commit_callback, revision_baton,
-                                        NULL, FALSE, rb->pool));
+      /* Record the edit, so the parser can continue with the next
+         revision while this one is being committed. */
+      SVN_ERR(svn_delta__get_spool_editor(&commit_editor, &commit_edit_baton,
+                                          &rb->spool, LOAD_SPOOL_MEMORY_SIZE,
+                                          rb->pool));
 
       rb->pb->commit_editor = commit_editor;
       rb->pb->commit_edit_baton = commit_edit_baton;
@@ -729,6 +1090,7 @@ set_revision_property(void *baton,
       /* Special case: set revision 0 properties directly (which is
          safe because the commit_editor hasn't been created yet), but
          only when loading into an 'empty' filesystem. */
+      SVN_ERR(wait_for_commits(rb->pb));
       SVN_ERR(svn_ra_change_rev_prop2(rb->pb->session, 0,
                                       name, NULL, value, rb->pool));
     }
@@ -856,6 +1218,9 @@ remove_node_props(void *baton)
     /* Add-without-history; no "old" properties to worry about. */
     return SVN_NO_ERROR;
 
+  /* The original node may be part of a revision not committed yet. */
+  SVN_ERR(wait_for_commits(rb->pb));
+
   if (nb->kind == svn_node_file)
     {
       SVN_ERR(svn_ra_get_file(nb->rb->pb->aux_session,
@@ -956,21 +1321,13 @@ static svn_error_t *
 close_revision(void *baton)
 {
   struct revision_baton *rb = baton;
-  const svn_delta_editor_t *commit_editor = rb->pb->commit_editor;
-  void *commit_edit_baton = rb->pb->commit_edit_baton;
-  svn_revnum_t committed_rev = SVN_INVALID_REVNUM;
+  struct parse_baton *pb = rb->pb;
+  const svn_delta_editor_t *commit_editor = pb->commit_editor;
 
-  /* Fake revision 0 */
-  if (rb->rev == 0)
+  if (rb->rev > 0 && commit_editor)
     {
-      /* ### Don't print directly; generate a notification. */
-      if (! rb->pb->quiet)
-        SVN_ERR(svn_cmdline_printf(rb->pool, "* Loaded revision 0.\n"));
-    }
-  else if (commit_editor)
-    {
-      /* Close all pending open directories, and then close the edit
-         session itself */
+      /* Close all pending open directories; commit_revision() closes the
+         edit session itself */
       while (rb->db && rb->db->parent)
         {
           SVN_ERR(commit_editor->close_directory(rb->db->baton, rb->pool));
@@ -978,63 +1335,26 @@ close_revision(void *baton)
         }
       /* root dir's baton */
       SVN_ERR(commit_editor->close_directory(rb->db->baton, rb->pool));
-      SVN_ERR(commit_editor->close_edit(commit_edit_baton, rb->pool));
     }
-  else
-    {
-      svn_revnum_t head_rev_before_commit = rb->rev - rb->rev_offset - 1;
-      void *child_baton;
-
-      /* Legitimate revision with no node information */
-      SVN_ERR(svn_ra_get_commit_editor3(rb->pb->session, &commit_editor,
-                                        &commit_edit_baton, rb->revprop_table,
-                                        commit_callback, baton,
-                                        NULL, FALSE, rb->pool));
 
-      SVN_ERR(commit_editor->open_root(commit_edit_baton,
-                                       head_rev_before_commit,
-                                       rb->pool, &child_baton));
-
-      SVN_ERR(commit_editor->close_directory(child_baton, rb->pool));
-      SVN_ERR(commit_editor->close_edit(commit_edit_baton, rb->pool));
-    }
-
-  /* svn_fs_commit_txn() rewrites the datestamp and author properties;
-     we'll rewrite them again by hand after closing the commit_editor.
-     The only time we don't do this is for revision 0 when loaded into
-     a non-empty repository.  */
+  /* Every revision but 0 becomes the next one of the target repository.
+     Map it now, so that the following revisions can refer to it
+     before it has actually been committed. */
   if (rb->rev > 0)
     {
-      committed_rev = get_revision_mapping(rb->pb->rev_map, rb->rev);
+      rb->committed_rev = ++pb->head_rev;
+      map_committed_revision(pb, rb->rev, rb->committed_rev);
     }
   else if (rb->rev_offset == -1)
     {
-      committed_rev = 0;
-    }
-
-  if (SVN_IS_VALID_REVNUM(committed_rev))
-    {
-      if (!svn_hash_gets(rb->pb->skip_revprops, SVN_PROP_REVISION_DATE))
-        {
-          SVN_ERR(svn_repos__validate_prop(SVN_PROP_REVISION_DATE,
-                                           rb->datestamp, rb->pool));
-          SVN_ERR(svn_ra_change_rev_prop2(rb->pb->session, committed_rev,
-                                          SVN_PROP_REVISION_DATE,
-                                          NULL, rb->datestamp, rb->pool));
-        }
-      if (!svn_hash_gets(rb->pb->skip_revprops, SVN_PROP_REVISION_AUTHOR))
-        {
-          SVN_ERR(svn_repos__validate_prop(SVN_PROP_REVISION_AUTHOR,
-                                           rb->author, rb->pool));
-          SVN_ERR(svn_ra_change_rev_prop2(rb->pb->session, committed_rev,
-                                          SVN_PROP_REVISION_AUTHOR,
-                                          NULL, rb->author, rb->pool));
-        }
+      rb->committed_rev = 0;
     }
 
-  svn_pool_destroy(rb->pool);
+  pb->commit_editor = NULL;
+  pb->commit_edit_baton = NULL;
+  pb->current_rb = NULL;
 
-  return SVN_NO_ERROR;
+  return svn_error_trace(queue_revision(pb, rb));
 }
 
 svn_error_t *
@@ -1088,9 +1408,19 @@ svn_rdump__load_dumpstream(svn_stream_t *stream,
   parse_baton->oldest_dumpstream_rev = SVN_INVALID_REVNUM;
   parse_baton->skip_revprops = skip_revprops;
 
+  SVN_ERR(svn_ra_get_latest_revnum(session, &parse_baton->head_rev, pool));
+
+  SVN_ERR(start_commit_pipeline(parse_baton, pool));
+
   err = svn_repos_parse_dumpstream3(stream, parser, parse_baton, FALSE,
                                     cancel_func, cancel_baton, pool);
 
+  /* A revision that hasn't been parsed completely won't be committed. */
+  if (parse_baton->current_rb)
+    svn_pool_destroy(parse_baton->current_rb->pool);
+
+  err = stop_commit_pipeline(parse_baton, err);
+
   /* If all goes well, or if we're cancelled cleanly, don't leave a
      stray lock behind. */
   if ((! err) || (err && (err->apr_err == SVN_ERR_CANCELLED)))
@@ -49,12 +49,16 @@
 #include "svn_config.h"
 #include "svn_props.h"
 #include "svn_mergeinfo.h"
+#include "svn_sorts.h"
 #include "svn_user.h"
 
 #include "private/svn_log.h"
 #include "private/svn_mergeinfo_private.h"
 #include "private/svn_ra_svn_private.h"
+#include "private/svn_repos_private.h"
 #include "private/svn_fspath.h"
+#include "private/svn_fs_private.h"
+#include "private/svn_sorts_private.h"
 
 #ifdef HAVE_UNISTD_H
 #include <unistd.h>   /* For getpid() */
@@ -90,6 +94,11 @@ typedef struct log_baton_t {
 
   /* Set to TRUE when at least one changed path has been sent. */
   svn_boolean_t started;
+
+  /* Number of changed paths sent for the current revision and the
+     maximum number we will send per revision.  0 means unlimited. */
+  unsigned changes_sent;
+  unsigned max_changes;
 } log_baton_t;
 
 typedef struct file_revs_baton_t {
@@ -173,6 +182,80 @@ static svn_error_t *log_command(server_baton_t *b,
   return logger__write(b->logger, line, nbytes);
 }
 
+/* Start tracing the FS I/O of the connection served by B, if requested
+ * by PARAMS.  Tracing ends with CONN_POOL.  Use SCRATCH_POOL for
+ * temporary allocations. */
+static svn_error_t *
+start_io_trace(server_baton_t *b,
+               serve_params_t *params,
+               apr_pool_t *conn_pool,
+               apr_pool_t *scratch_pool)
+{
+  svn_stream_t *events = NULL;
+
+  if (!params->trace_io)
+    return SVN_NO_ERROR;
+
+  if (params->trace_io_dir)
+    SVN_ERR(svn_stream_open_unique(&events, &b->io_trace_path,
+                                   params->trace_io_dir, svn_io_file_del_none,
+                                   conn_pool, scratch_pool));
+
+  return svn_error_trace(svn_fs__io_trace_start(b->repository->fs, events,
+                                                conn_pool));
+}
+
+/* Log the FS I/O totals of the connection served by B, if it has been
+ * traced. */
+static svn_error_t *
+log_io_trace(server_baton_t *b,
+             svn_ra_svn_conn_t *conn,
+             apr_pool_t *pool)
+{
+  const svn_fs__io_stats_t *stats;
+
+  if (!b->repository->fs)
+    return SVN_NO_ERROR;
+
+  stats = svn_fs__io_trace_stats(b->repository->fs);
+  if (!stats)
+    return SVN_NO_ERROR;
+
+  return svn_error_trace(log_command(b, conn, pool,
+                                     "io-stats files=%" APR_UINT64_T_FMT
+                                     " items=%" APR_UINT64_T_FMT
+                                     " bytes=%" APR_UINT64_T_FMT
+                                     " cache-hits=%" APR_UINT64_T_FMT "%s%s",
+                                     stats->files_opened, stats->items_read,
+                                     stats->bytes_read, stats->cache_hits,
+                                     b->io_trace_path ? " trace=" : "",
+                                     b->io_trace_path
+                                       ? svn_path_uri_encode(b->io_trace_path,
+                                                             pool)
+                                       : ""));
+}
+
+/* Log the network transfer totals of CONN, served by B. */
+static svn_error_t *
+log_conn_stats(server_baton_t *b,
+               svn_ra_svn_conn_t *conn,
+               apr_pool_t *pool)
+{
+  const svn_ra_svn__conn_stats_t *stats = svn_ra_svn__get_conn_stats(conn);
+
+  return svn_error_trace(log_command(b, conn, pool,
+                                     "conn-stats writes=%" APR_UINT64_T_FMT
+                                     " bytes-out=%" APR_UINT64_T_FMT
+                                     " direct-writes=%" APR_UINT64_T_FMT
+                                     " reads=%" APR_UINT64_T_FMT
+                                     " bytes-in=%" APR_UINT64_T_FMT
+                                     " write-buffer=%" APR_SIZE_T_FMT,
+                                     stats->writes, stats->bytes_written,
+                                     stats->direct_writes, stats->reads,
+                                     stats->bytes_read,
+                                     stats->write_buf_size));
+}
+
 /* Log an authz failure */
 static svn_error_t *
 log_authz_denied(const char *path,
@@ -1281,6 +1364,115 @@ rev_proplist(svn_ra_svn_conn_t *conn,
   return SVN_NO_ERROR;
 }
 
+static svn_error_t *
+rev_proplist_range(svn_ra_svn_conn_t *conn,
+                   apr_pool_t *pool,
+                   svn_ra_svn__list_t *params,
+                   void *baton)
+{
+  server_baton_t *b = baton;
+  svn_revnum_t start_rev, end_rev, rev;
+  apr_pool_t *iterpool;
+  svn_error_t *err = SVN_NO_ERROR, *write_err;
+  authz_baton_t ab;
+
+  ab.server = b;
+  ab.conn = conn;
+
+  SVN_ERR(svn_ra_svn__parse_tuple(params, "rr", &start_rev, &end_rev));
+  SVN_ERR(log_command(b, conn, pool, "rev-proplist-range r%ld:%ld",
+                      start_rev, end_rev));
+
+  SVN_ERR(trivial_auth_request(conn, pool, b));
+  if (start_rev > end_rev)
+    SVN_CMD_ERR(svn_error_createf(SVN_ERR_INCORRECT_PARAMS, NULL,
+                                  "Invalid revision range r%ld:%ld",
+                                  start_rev, end_rev));
+
+  /* Send the entries as we go, like rev-proplist would for each of the
+     revisions. */
+  iterpool = svn_pool_create(pool);
+  for (rev = start_rev; rev <= end_rev; rev++)
+    {
+      apr_hash_t *props;
+
+      svn_pool_clear(iterpool);
+
+      err = svn_repos_fs_revision_proplist(&props, b->repository->repos,
+                                           rev,
+                                           authz_check_access_cb_func(b),
+                                           &ab, iterpool);
+      if (err)
+        break;
+
+      SVN_ERR(svn_ra_svn__write_tuple(conn, iterpool, "r(!", rev));
+      SVN_ERR(svn_ra_svn__write_proplist(conn, iterpool, props));
+      SVN_ERR(svn_ra_svn__write_tuple(conn, iterpool, "!))"));
+    }
+  svn_pool_destroy(iterpool);
+
+  /* Finish response. */
+  write_err = svn_ra_svn__write_word(conn, pool, "done");
+  if (write_err)
+    {
+      svn_error_clear(err);
+      return write_err;
+    }
+  SVN_CMD_ERR(err);
+
+  return svn_error_trace(svn_ra_svn__write_cmd_response(conn, pool, ""));
+}
+
+static svn_error_t *
+change_rev_props(svn_ra_svn_conn_t *conn,
+                 apr_pool_t *pool,
+                 svn_ra_svn__list_t *params,
+                 void *baton)
+{
+  server_baton_t *b = baton;
+  svn_revnum_t rev;
+  svn_ra_svn__list_t *change_list;
+  apr_pool_t *iterpool;
+  authz_baton_t ab;
+  int i;
+
+  ab.server = b;
+  ab.conn = conn;
+
+  SVN_ERR(svn_ra_svn__parse_tuple(params, "rl", &rev, &change_list));
+
+  SVN_ERR(must_have_access(conn, pool, b, svn_authz_write, NULL, FALSE));
+  SVN_ERR(log_command(b, conn, pool, "change-rev-props r%ld %d",
+                      rev, change_list->nelts));
+
+  /* Like a change-rev-prop for each of the changes, stopping at the
+     first one that fails. */
+  iterpool = svn_pool_create(pool);
+  for (i = 0; i < change_list->nelts; i++)
+    {
+      svn_ra_svn__item_t *elt = &SVN_RA_SVN__LIST_ITEM(change_list, i);
+      const char *name;
+      svn_string_t *value;
+
+      svn_pool_clear(iterpool);
+
+      if (elt->kind != SVN_RA_SVN_LIST)
+        return svn_error_create(SVN_ERR_RA_SVN_MALFORMED_DATA, NULL,
+                                _("Revprop change not a list"));
+
+      SVN_ERR(svn_ra_svn__parse_tuple(&elt->u.list, "c(?s)", &name, &value));
+      SVN_CMD_ERR(svn_repos_fs_change_rev_prop4(b->repository->repos, rev,
+                                                b->client_info->user,
+                                                name, NULL, value,
+                                                TRUE, TRUE,
+                                                authz_check_access_cb_func(b),
+                                                &ab, iterpool));
+    }
+  svn_pool_destroy(iterpool);
+
+  return svn_error_trace(svn_ra_svn__write_cmd_response(conn, pool, ""));
+}
+
 static svn_error_t *
 rev_prop(svn_ra_svn_conn_t *conn,
          apr_pool_t *pool,
@@ -1436,6 +1628,21 @@ unlock_paths(const svn_ra_svn__list_t *lock_tokens,
   return SVN_NO_ERROR;
 }
 
+/* Implements svn_fs__commit_timing_func_t.  Append PHASE and DURATION
+ * to the svn_stringbuf_t *BATON. */
+static void
+collect_commit_timing(void *baton,
+                      const char *phase,
+                      apr_interval_time_t duration,
+                      apr_pool_t *scratch_pool)
+{
+  svn_stringbuf_t *timings = baton;
+
+  svn_stringbuf_appendcstr(timings,
+                           apr_psprintf(scratch_pool, " %s=%.3fms", phase,
+                                        duration / 1000.0));
+}
+
 static svn_error_t *
 commit(svn_ra_svn_conn_t *conn,
        apr_pool_t *pool,
@@ -1457,6 +1664,8 @@ commit(svn_ra_svn_conn_t *conn,
   commit_callback_baton_t ccb;
   svn_revnum_t new_rev;
   authz_baton_t ab;
+  svn_stringbuf_t *timings = NULL;
+  svn_error_t *err;
 
   ab.server = b;
   ab.conn = conn;
@@ -1520,14 +1729,30 @@ commit(svn_ra_svn_conn_t *conn,
                svn_path_uri_decode(b->repository->repos_url, pool),
                b->repository->fs_path->data, revprop_table,
                commit_done, &ccb,
-               authz_commit_cb, &ab, pool));
+               b->repository->authzdb ? authz_commit_cb : NULL, &ab, pool));
   SVN_ERR(svn_ra_svn__write_cmd_response(conn, pool, ""));
-  SVN_ERR(svn_ra_svn_drive_editor2(conn, pool, editor, edit_baton,
-                                   &aborted, FALSE));
+
+  /* The commit itself happens while driving the editor. */
+  if (b->log_commit_timing && b->logger)
+    {
+      timings = svn_stringbuf_create_empty(pool);
+      svn_fs__set_commit_timing_func(b->repository->fs,
+                                     collect_commit_timing, timings);
+    }
+
+  err = svn_ra_svn_drive_editor2(conn, pool, editor, edit_baton,
+                                 &aborted, FALSE);
+  if (timings)
+    svn_fs__set_commit_timing_func(b->repository->fs, NULL, NULL);
+  SVN_ERR(err);
+
   if (!aborted)
     {
       SVN_ERR(log_command(b, conn, pool, "%s",
                           svn_log__commit(new_rev, pool)));
+      if (timings && timings->len)
+        SVN_ERR(log_command(b, conn, pool, "commit-timing r%ld%s",
+                            new_rev, timings->data));
       SVN_ERR(trivial_auth_request(conn, pool, b));
 
       /* In tunnel mode, deltify before answering the client, because
@@ -1551,6 +1776,130 @@ commit(svn_ra_svn_conn_t *conn,
   return SVN_NO_ERROR;
 }
 
+/* Baton type to be passed into send_zero_copy_contents().
+ */
+typedef struct zero_copy_baton_t
+{
+  /* The connection to send the data to. */
+  svn_ra_svn_conn_t *conn;
+
+  /* Don't process data larger than this limit. */
+  apr_size_t zero_copy_limit;
+
+  /* Return value: will be set to TRUE, if the data was sent. */
+  svn_boolean_t zero_copy_succeeded;
+} zero_copy_baton_t;
+
+/* Implement svn_fs_process_contents_func_t.  If LEN is smaller than the
+ * limit given in *BATON, send the CONTENTS as a single string to the
+ * connection given in BATON and set the ZERO_COPY_SUCCEEDED flag in that
+ * BATON.  Otherwise, reset it to FALSE.
+ * Use SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+send_zero_copy_contents(const unsigned char *contents,
+                        apr_size_t len,
+                        void *baton,
+                        apr_pool_t *scratch_pool)
+{
+  zero_copy_baton_t *zero_copy_baton = baton;
+
+  /* We are being called while the cache is locked.  If the item is too
+     large, the caller must revert to the traditional streaming code. */
+  if (len > zero_copy_baton->zero_copy_limit)
+    {
+      zero_copy_baton->zero_copy_succeeded = FALSE;
+      return SVN_NO_ERROR;
+    }
+
+  /* Empty files don't need a chunk. */
+  if (len > 0)
+    {
+      svn_string_t write_str;
+
+      write_str.data = (const char *)contents;
+      write_str.len = len;
+      SVN_ERR(svn_ra_svn__write_string(zero_copy_baton->conn, scratch_pool,
+                                       &write_str));
+    }
+
+  zero_copy_baton->zero_copy_succeeded = TRUE;
+  return SVN_NO_ERROR;
+}
+
+/* Send the CONTENTS of the file at FULL_PATH in ROOT over CONN as file
+ * contents chunks, terminated by an empty chunk, and close CONTENTS.
+ * Set *READ_ERR to the error reading the contents, if any.  The contents
+ * have been terminated in that case as well, and the caller should report
+ * *READ_ERR to the client.  Return connection errors directly.
+ * Use SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+write_file_contents(svn_error_t **read_err,
+                    svn_ra_svn_conn_t *conn,
+                    svn_fs_root_t *root,
+                    const char *full_path,
+                    svn_stream_t *contents,
+                    apr_pool_t *scratch_pool)
+{
+  zero_copy_baton_t zero_copy_baton;
+  svn_string_t write_str;
+  svn_error_t *err, *write_err;
+  char *buf;
+  apr_size_t len;
+
+  zero_copy_baton.conn = conn;
+  zero_copy_baton.zero_copy_limit = svn_ra_svn_zero_copy_limit(conn);
+  zero_copy_baton.zero_copy_succeeded = FALSE;
+
+  /* Small, cached fulltexts can be sent straight from the cache
+     without copying them into our buffer first. */
+  err = SVN_NO_ERROR;
+  if (zero_copy_baton.zero_copy_limit > 0)
+    {
+      svn_boolean_t called = FALSE;
+
+      err = svn_fs_try_process_file_contents(&called, root, full_path,
+                                             send_zero_copy_contents,
+                                             &zero_copy_baton, scratch_pool);
+      if (!err && called && zero_copy_baton.zero_copy_succeeded)
+        err = svn_stream_close(contents);
+      else
+        zero_copy_baton.zero_copy_succeeded = FALSE;
+    }
+
+  /* Chunks of this size bypass the connection's write buffer. */
+  buf = apr_palloc(scratch_pool, SVN__STREAM_CHUNK_SIZE);
+  while (!err && !zero_copy_baton.zero_copy_succeeded)
+    {
+      len = SVN__STREAM_CHUNK_SIZE;
+      err = svn_stream_read_full(contents, buf, &len);
+      if (err)
+        break;
+      if (len > 0)
+        {
+          write_str.data = buf;
+          write_str.len = len;
+          SVN_ERR(svn_ra_svn__write_string(conn, scratch_pool, &write_str));
+        }
+      if (len < SVN__STREAM_CHUNK_SIZE)
+        {
+          err = svn_stream_close(contents);
+          break;
+        }
+    }
+
+  write_err = svn_ra_svn__write_cstring(conn, scratch_pool, "");
+  if (write_err)
+    {
+      svn_error_clear(err);
+      return write_err;
+    }
+
+  *read_err = err;
+  return SVN_NO_ERROR;
+}
+
 static svn_error_t *
 get_file(svn_ra_svn_conn_t *conn,
          apr_pool_t *pool,
@@ -1564,13 +1913,10 @@ get_file(svn_ra_svn_conn_t *conn,
   svn_stream_t *contents;
   apr_hash_t *props = NULL;
   apr_array_header_t *inherited_props;
-  svn_string_t write_str;
-  char buf[4096];
-  apr_size_t len;
   svn_boolean_t want_props, want_contents;
   apr_uint64_t wants_inherited_props;
   svn_checksum_t *checksum;
-  svn_error_t *err, *write_err;
+  svn_error_t *err;
   int i;
   authz_baton_t ab;
 
@@ -1646,36 +1992,151 @@ get_file(svn_ra_svn_conn_t *conn,
   /* Now send the file's contents. */
   if (want_contents)
     {
-      err = SVN_NO_ERROR;
-      while (1)
+      SVN_ERR(write_file_contents(&err, conn, root, full_path, contents,
+                                  pool));
+      SVN_CMD_ERR(err);
+      SVN_ERR(svn_ra_svn__write_cmd_response(conn, pool, ""));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+get_files(svn_ra_svn_conn_t *conn,
+          apr_pool_t *pool,
+          svn_ra_svn__list_t *params,
+          void *baton)
+{
+  server_baton_t *b = baton;
+  svn_ra_svn__list_t *entry_list;
+  svn_boolean_t want_props;
+  apr_array_header_t *full_paths, *revisions;
+  const char *auth_path;
+  svn_revnum_t youngest = SVN_INVALID_REVNUM;
+  svn_revnum_t root_rev = SVN_INVALID_REVNUM;
+  svn_fs_root_t *root = NULL;
+  apr_pool_t *root_pool, *iterpool;
+  svn_error_t *err = SVN_NO_ERROR, *write_err;
+  authz_baton_t ab;
+  int i;
+
+  ab.server = b;
+  ab.conn = conn;
+
+  SVN_ERR(svn_ra_svn__parse_tuple(params, "lb", &entry_list, &want_props));
+
+  full_paths = apr_array_make(pool, entry_list->nelts, sizeof(const char *));
+  revisions = apr_array_make(pool, entry_list->nelts, sizeof(svn_revnum_t));
+  for (i = 0; i < entry_list->nelts; i++)
+    {
+      svn_ra_svn__item_t *elt = &SVN_RA_SVN__LIST_ITEM(entry_list, i);
+      const char *path;
+      svn_revnum_t rev;
+
+      if (elt->kind != SVN_RA_SVN_LIST)
+        return svn_error_create(SVN_ERR_RA_SVN_MALFORMED_DATA, NULL,
+                                _("File entry not a list"));
+
+      SVN_ERR(svn_ra_svn__parse_tuple(&elt->u.list, "c(?r)", &path, &rev));
+      APR_ARRAY_PUSH(full_paths, const char *)
+        = svn_fspath__join(b->repository->fs_path->data,
+                           svn_relpath_canonicalize(path, pool), pool);
+      APR_ARRAY_PUSH(revisions, svn_revnum_t) = rev;
+    }
+
+  /* As in stat_many(), use the one auth exchange for the first path the
+     user may not read and require the others to be readable. */
+  auth_path = b->repository->fs_path->data;
+  for (i = 0; i < full_paths->nelts; i++)
+    if (!lookup_access(pool, b, svn_authz_read,
+                       APR_ARRAY_IDX(full_paths, i, const char *), FALSE))
+      {
+        auth_path = APR_ARRAY_IDX(full_paths, i, const char *);
+        break;
+      }
+
+  SVN_ERR(must_have_access(conn, pool, b, svn_authz_read, auth_path, FALSE));
+
+  for (; i < full_paths->nelts; i++)
+    if (!lookup_access(pool, b, svn_authz_read,
+                       APR_ARRAY_IDX(full_paths, i, const char *), FALSE))
+      return svn_error_create(SVN_ERR_RA_SVN_CMD_ERR,
+                              error_create_and_log(SVN_ERR_RA_NOT_AUTHORIZED,
+                                                   NULL, NULL, b),
+                              NULL);
+
+  SVN_ERR(log_command(b, conn, pool, "get-files %d", full_paths->nelts));
+
+  /* Send the files in request order, tagged with their index.  Keep the
+     last revision root around for the next file. */
+  root_pool = svn_pool_create(pool);
+  iterpool = svn_pool_create(pool);
+  for (i = 0; i < full_paths->nelts; i++)
+    {
+      const char *full_path = APR_ARRAY_IDX(full_paths, i, const char *);
+      svn_revnum_t rev = APR_ARRAY_IDX(revisions, i, svn_revnum_t);
+      svn_checksum_t *checksum;
+      apr_hash_t *props = NULL;
+      svn_stream_t *contents;
+
+      svn_pool_clear(iterpool);
+
+      if (!SVN_IS_VALID_REVNUM(rev))
         {
-          len = sizeof(buf);
-          err = svn_stream_read_full(contents, buf, &len);
-          if (err)
-            break;
-          if (len > 0)
-            {
-              write_str.data = buf;
-              write_str.len = len;
-              SVN_ERR(svn_ra_svn__write_string(conn, pool, &write_str));
-            }
-          if (len < sizeof(buf))
+          if (!SVN_IS_VALID_REVNUM(youngest))
             {
-              err = svn_stream_close(contents);
-              break;
+              err = svn_fs_youngest_rev(&youngest, b->repository->fs, pool);
+              if (err)
+                break;
             }
+          rev = youngest;
         }
-      write_err = svn_ra_svn__write_cstring(conn, pool, "");
-      if (write_err)
+
+      if (rev != root_rev)
         {
-          svn_error_clear(err);
-          return write_err;
+          svn_pool_clear(root_pool);
+          root_rev = SVN_INVALID_REVNUM;
+          err = svn_fs_revision_root(&root, b->repository->fs, rev,
+                                     root_pool);
+          if (err)
+            break;
+          root_rev = rev;
         }
-      SVN_CMD_ERR(err);
-      SVN_ERR(svn_ra_svn__write_cmd_response(conn, pool, ""));
+
+      err = svn_fs_file_checksum(&checksum, svn_checksum_md5, root,
+                                 full_path, TRUE, iterpool);
+      if (!err && want_props)
+        err = get_props(&props, NULL, &ab, root, full_path, iterpool);
+      if (!err)
+        err = svn_fs_file_contents(&contents, root, full_path, iterpool);
+      if (err)
+        break;
+
+      SVN_ERR(svn_ra_svn__write_tuple(conn, iterpool, "(nr(?c)(!",
+                                      (apr_uint64_t) i, rev,
+                                      svn_checksum_to_cstring_display(
+                                        checksum, iterpool)));
+      SVN_ERR(svn_ra_svn__write_proplist(conn, iterpool, props));
+      SVN_ERR(svn_ra_svn__write_tuple(conn, iterpool, "!))"));
+
+      SVN_ERR(write_file_contents(&err, conn, root, full_path, contents,
+                                  iterpool));
+      if (err)
+        break;
     }
+  svn_pool_destroy(iterpool);
+  svn_pool_destroy(root_pool);
 
-  return SVN_NO_ERROR;
+  /* Finish response. */
+  write_err = svn_ra_svn__write_word(conn, pool, "done");
+  if (write_err)
+    {
+      svn_error_clear(err);
+      return write_err;
+    }
+  SVN_CMD_ERR(err);
+
+  return svn_error_trace(svn_ra_svn__write_cmd_response(conn, pool, ""));
 }
 
 /* Translate all the words in DIRENT_FIELDS_LIST into the flags in
@@ -2250,6 +2711,152 @@ get_mergeinfo(svn_ra_svn_conn_t *conn,
   return SVN_NO_ERROR;
 }
 
+static svn_error_t *
+get_merge_plan(svn_ra_svn_conn_t *conn,
+               apr_pool_t *pool,
+               svn_ra_svn__list_t *params,
+               void *baton)
+{
+  server_baton_t *b = baton;
+  const char *source_path, *target_path;
+  svn_revnum_t source_peg_rev, source_youngest_rev, source_oldest_rev;
+  svn_revnum_t target_rev;
+  svn_boolean_t want_target_history, include_descendants;
+  svn_mergeinfo_t source_history, target_history;
+  svn_mergeinfo_catalog_t catalog;
+  svn_string_t *source_history_str;
+  svn_string_t *target_history_str = NULL;
+  apr_hash_index_t *hi;
+  apr_pool_t *iterpool;
+  authz_baton_t ab;
+
+  ab.server = b;
+  ab.conn = conn;
+
+  SVN_ERR(svn_ra_svn__parse_tuple(params, "cr(?r)(?r)crbb",
+                                  &source_path, &source_peg_rev,
+                                  &source_youngest_rev, &source_oldest_rev,
+                                  &target_path, &target_rev,
+                                  &want_target_history,
+                                  &include_descendants));
+  source_path = svn_fspath__join(b->repository->fs_path->data,
+                                 svn_relpath_canonicalize(source_path, pool),
+                                 pool);
+  target_path = svn_fspath__join(b->repository->fs_path->data,
+                                 svn_relpath_canonicalize(target_path, pool),
+                                 pool);
+
+  SVN_ERR(log_command(b, conn, pool, "get-merge-plan %s@%ld %s@%ld",
+                      svn_path_uri_encode(source_path, pool), source_peg_rev,
+                      svn_path_uri_encode(target_path, pool), target_rev));
+
+  SVN_ERR(trivial_auth_request(conn, pool, b));
+
+  SVN_CMD_ERR(svn_repos__get_merge_plan(&source_history,
+                                        want_target_history
+                                          ? &target_history : NULL,
+                                        &catalog, b->repository->repos,
+                                        source_path, source_peg_rev,
+                                        source_youngest_rev,
+                                        source_oldest_rev,
+                                        target_path, target_rev,
+                                        include_descendants,
+                                        authz_check_access_cb_func(b), &ab,
+                                        pool, pool));
+
+  SVN_ERR(svn_mergeinfo_to_string(&source_history_str, source_history,
+                                  pool));
+  if (want_target_history)
+    SVN_ERR(svn_mergeinfo_to_string(&target_history_str, target_history,
+                                    pool));
+
+  SVN_ERR(svn_ra_svn__write_tuple(conn, pool, "w(s(?s)(!", "success",
+                                  source_history_str, target_history_str));
+
+  iterpool = svn_pool_create(pool);
+  for (hi = catalog ? apr_hash_first(pool, catalog) : NULL;
+       hi;
+       hi = apr_hash_next(hi))
+    {
+      svn_string_t *mergeinfo_string;
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_mergeinfo_to_string(&mergeinfo_string,
+                                      apr_hash_this_val(hi), iterpool));
+      SVN_ERR(svn_ra_svn__write_tuple(conn, iterpool, "cs",
+                                      apr_hash_this_key(hi),
+                                      mergeinfo_string));
+    }
+  svn_pool_destroy(iterpool);
+
+  SVN_ERR(svn_ra_svn__write_tuple(conn, pool, "!))"));
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+get_changes_summary(svn_ra_svn_conn_t *conn,
+                    apr_pool_t *pool,
+                    svn_ra_svn__list_t *params,
+                    void *baton)
+{
+  server_baton_t *b = baton;
+  const char *path, *depth_word;
+  svn_revnum_t start_rev, end_rev;
+  apr_hash_t *changes;
+  apr_array_header_t *sorted;
+  apr_pool_t *iterpool;
+  authz_baton_t ab;
+  int i;
+
+  ab.server = b;
+  ab.conn = conn;
+
+  SVN_ERR(svn_ra_svn__parse_tuple(params, "crrw", &path, &start_rev,
+                                  &end_rev, &depth_word));
+  path = svn_fspath__join(b->repository->fs_path->data,
+                          svn_relpath_canonicalize(path, pool), pool);
+
+  SVN_ERR(log_command(b, conn, pool, "get-changes-summary %s r%ld:%ld",
+                      svn_path_uri_encode(path, pool), start_rev, end_rev));
+
+  SVN_ERR(trivial_auth_request(conn, pool, b));
+  if (start_rev > end_rev)
+    SVN_CMD_ERR(svn_error_createf(SVN_ERR_INCORRECT_PARAMS, NULL,
+                                  "Invalid revision range r%ld:%ld",
+                                  start_rev, end_rev));
+
+  SVN_CMD_ERR(svn_repos__get_changes_summary(&changes,
+                                             b->repository->repos, path,
+                                             start_rev, end_rev,
+                                             svn_depth_from_word(depth_word),
+                                             authz_check_access_cb_func(b),
+                                             &ab, NULL, NULL, pool, pool));
+
+  SVN_ERR(svn_ra_svn__write_tuple(conn, pool, "w((!", "success"));
+
+  sorted = svn_sort__hash(changes, svn_sort_compare_items_as_paths, pool);
+  iterpool = svn_pool_create(pool);
+  for (i = 0; i < sorted->nelts; i++)
+    {
+      svn_sort__item_t *item = &APR_ARRAY_IDX(sorted, i, svn_sort__item_t);
+      const svn_log_changed_path2_t *change = item->value;
+      const char action[2] = { change->action, '\0' };
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_ra_svn__write_tuple(
+                conn, iterpool, "(cwwbb)", item->key, action,
+                svn_node_kind_to_word(change->node_kind),
+                change->text_modified == svn_tristate_true,
+                change->props_modified == svn_tristate_true));
+    }
+  svn_pool_destroy(iterpool);
+
+  SVN_ERR(svn_ra_svn__write_tuple(conn, pool, "!))"));
+
+  return SVN_NO_ERROR;
+}
+
 /* Send a changed paths list entry to the client.
    This implements svn_repos_path_change_receiver_t. */
 static svn_error_t *
@@ -2290,6 +2897,10 @@ path_change_receiver(void *baton,
               change->text_mod,
               change->prop_mod));
 
+  /* Truncate huge changed paths lists. */
+  if (b->max_changes && ++b->changes_sent >= b->max_changes)
+    return svn_error_create(SVN_ERR_CEASE_INVOCATION, NULL, NULL);
+
   return SVN_NO_ERROR;
 }
 
@@ -2349,6 +2960,7 @@ revision_receiver(void *baton,
   /* Close LOG_ENTRY->CHANGED_PATHS. */
   SVN_ERR(svn_ra_svn__end_list(conn, scratch_pool));
   b->started = FALSE;
+  b->changes_sent = 0;
 
   /* send LOG_ENTRY main members */
   SVN_ERR(svn_ra_svn__write_data_log_entry(conn, scratch_pool,
@@ -2466,6 +3078,8 @@ log_cmd(svn_ra_svn_conn_t *conn,
   lb.conn = conn;
   lb.stack_depth = 0;
   lb.started = FALSE;
+  lb.changes_sent = 0;
+  lb.max_changes = b->repository->max_changed_paths;
   err = svn_repos_get_logs5(b->repository->repos, full_paths, start_rev,
                             end_rev, (int) limit,
                             strict_node, include_merged_revisions,
@@ -2568,6 +3182,149 @@ stat_cmd(svn_ra_svn_conn_t *conn,
   return SVN_NO_ERROR;
 }
 
+static svn_error_t *
+stat_many(svn_ra_svn_conn_t *conn,
+          apr_pool_t *pool,
+          svn_ra_svn__list_t *params,
+          void *baton)
+{
+  server_baton_t *b = baton;
+  svn_ra_svn__list_t *entry_list;
+  svn_boolean_t want_locks;
+  apr_array_header_t *paths, *full_paths, *revisions;
+  const char *auth_path;
+  svn_revnum_t youngest = SVN_INVALID_REVNUM;
+  svn_revnum_t root_rev = SVN_INVALID_REVNUM;
+  svn_fs_root_t *root = NULL;
+  apr_pool_t *root_pool, *iterpool;
+  svn_error_t *err = SVN_NO_ERROR, *write_err;
+  int i;
+
+  SVN_ERR(svn_ra_svn__parse_tuple(params, "lb", &entry_list, &want_locks));
+
+  paths = apr_array_make(pool, entry_list->nelts, sizeof(const char *));
+  full_paths = apr_array_make(pool, entry_list->nelts, sizeof(const char *));
+  revisions = apr_array_make(pool, entry_list->nelts, sizeof(svn_revnum_t));
+  for (i = 0; i < entry_list->nelts; i++)
+    {
+      svn_ra_svn__item_t *elt = &SVN_RA_SVN__LIST_ITEM(entry_list, i);
+      const char *path;
+      svn_revnum_t rev;
+
+      if (elt->kind != SVN_RA_SVN_LIST)
+        return svn_error_create(SVN_ERR_RA_SVN_MALFORMED_DATA, NULL,
+                                _("Stat entry not a list"));
+
+      SVN_ERR(svn_ra_svn__parse_tuple(&elt->u.list, "c(?r)", &path, &rev));
+      APR_ARRAY_PUSH(paths, const char *) = path;
+      APR_ARRAY_PUSH(full_paths, const char *)
+        = svn_fspath__join(b->repository->fs_path->data,
+                           svn_relpath_canonicalize(path, pool), pool);
+      APR_ARRAY_PUSH(revisions, svn_revnum_t) = rev;
+    }
+
+  /* There is only one auth exchange per command.  Use it for the first
+     path the user may not read, if any, so that anonymous users get the
+     chance to authenticate.  The other paths must then be readable as
+     well, just as if they had been stat'ed one by one. */
+  auth_path = b->repository->fs_path->data;
+  for (i = 0; i < full_paths->nelts; i++)
+    if (!lookup_access(pool, b, svn_authz_read,
+                       APR_ARRAY_IDX(full_paths, i, const char *), FALSE))
+      {
+        auth_path = APR_ARRAY_IDX(full_paths, i, const char *);
+        break;
+      }
+
+  SVN_ERR(must_have_access(conn, pool, b, svn_authz_read, auth_path, FALSE));
+
+  for (; i < full_paths->nelts; i++)
+    if (!lookup_access(pool, b, svn_authz_read,
+                       APR_ARRAY_IDX(full_paths, i, const char *), FALSE))
+      return svn_error_create(SVN_ERR_RA_SVN_CMD_ERR,
+                              error_create_and_log(SVN_ERR_RA_NOT_AUTHORIZED,
+                                                   NULL, NULL, b),
+                              NULL);
+
+  SVN_ERR(log_command(b, conn, pool, "stat-many %d", full_paths->nelts));
+
+  /* Send the entries as we go.  Consecutive entries tend to be in the
+     same revision, so keep the last revision root around. */
+  root_pool = svn_pool_create(pool);
+  iterpool = svn_pool_create(pool);
+  for (i = 0; i < full_paths->nelts; i++)
+    {
+      const char *full_path = APR_ARRAY_IDX(full_paths, i, const char *);
+      svn_revnum_t rev = APR_ARRAY_IDX(revisions, i, svn_revnum_t);
+      svn_dirent_t *dirent;
+      svn_lock_t *l = NULL;
+
+      svn_pool_clear(iterpool);
+
+      if (!SVN_IS_VALID_REVNUM(rev))
+        {
+          if (!SVN_IS_VALID_REVNUM(youngest))
+            {
+              err = svn_fs_youngest_rev(&youngest, b->repository->fs, pool);
+              if (err)
+                break;
+            }
+          rev = youngest;
+        }
+
+      if (rev != root_rev)
+        {
+          svn_pool_clear(root_pool);
+          root_rev = SVN_INVALID_REVNUM;
+          err = svn_fs_revision_root(&root, b->repository->fs, rev,
+                                     root_pool);
+          if (err)
+            break;
+          root_rev = rev;
+        }
+
+      err = svn_repos_stat(&dirent, root, full_path, iterpool);
+      if (!err && dirent && want_locks)
+        err = svn_fs_get_lock(&l, b->repository->fs, full_path, iterpool);
+      if (err)
+        break;
+
+      SVN_ERR(svn_ra_svn__write_tuple(conn, iterpool, "(cr(!",
+                                      APR_ARRAY_IDX(paths, i, const char *),
+                                      rev));
+      if (dirent)
+        {
+          /* Like "stat" does. */
+          const char *cdate = (dirent->time == (time_t) -1) ? NULL
+            : svn_time_to_cstring(dirent->time, iterpool);
+
+          SVN_ERR(svn_ra_svn__write_tuple(conn, iterpool, "wnbr(?c)(?c)",
+                                          svn_node_kind_to_word(dirent->kind),
+                                          (apr_uint64_t) dirent->size,
+                                          dirent->has_props,
+                                          dirent->created_rev,
+                                          cdate, dirent->last_author));
+        }
+      SVN_ERR(svn_ra_svn__write_tuple(conn, iterpool, "!)(!"));
+      if (l)
+        SVN_ERR(write_lock(conn, iterpool, l));
+      SVN_ERR(svn_ra_svn__write_tuple(conn, iterpool, "!))"));
+    }
+  svn_pool_destroy(iterpool);
+  svn_pool_destroy(root_pool);
+
+  /* Finish response. */
+  write_err = svn_ra_svn__write_word(conn, pool, "done");
+  if (write_err)
+    {
+      svn_error_clear(err);
+      return write_err;
+    }
+  SVN_CMD_ERR(err);
+
+  return svn_error_trace(svn_ra_svn__write_cmd_response(conn, pool, ""));
+}
+
 static svn_error_t *
 get_locations(svn_ra_svn_conn_t *conn,
               apr_pool_t *pool,
@@ -3617,6 +4374,8 @@ list(svn_ra_svn_conn_t *conn,
   svn_boolean_t path_info_only;
   svn_ra_svn__list_t *dirent_fields_list = NULL;
   svn_ra_svn__list_t *patterns_list = NULL;
+  svn_revnum_t since_rev;
+  svn_boolean_t no_patterns;
   int i;
   list_receiver_baton_t rb;
   svn_error_t *err, *write_err;
@@ -3626,9 +4385,13 @@ list(svn_ra_svn_conn_t *conn,
   ab.conn = conn;
 
   /* Read the command parameters. */
-  SVN_ERR(svn_ra_svn__parse_tuple(params, "c(?r)w?l?l", &path, &rev,
+  SVN_ERR(svn_ra_svn__parse_tuple(params, "c(?r)w?l?l(?r)b", &path, &rev,
                                   &depth_word, &dirent_fields_list,
-                                  &patterns_list));
+                                  &patterns_list, &since_rev, &no_patterns));
+
+  /* The pattern list only was a placeholder for SINCE_REV. */
+  if (no_patterns)
+    patterns_list = NULL;
 
   rb.conn = conn;
   SVN_ERR(parse_dirent_fields(&rb.dirent_fields, dirent_fields_list));
@@ -3669,9 +4432,9 @@ list(svn_ra_svn_conn_t *conn,
 
   /* Fetch the directory entries if requested and send them immediately. */
   path_info_only = (rb.dirent_fields & ~SVN_DIRENT_KIND) == 0;
-  err = svn_repos_list(root, full_path, patterns, depth, path_info_only,
-                       authz_check_access_cb_func(b), &ab, list_receiver,
-                       &rb, NULL, NULL, pool);
+  err = svn_repos_list2(root, full_path, patterns, depth, since_rev,
+                        path_info_only, authz_check_access_cb_func(b), &ab,
+                        list_receiver, &rb, NULL, NULL, pool);
 
 
   /* Finish response. */
@@ -3693,29 +4456,35 @@ static const svn_ra_svn__cmd_entry_t main_commands[] = {
   { "change-rev-prop", change_rev_prop },
   { "change-rev-prop2",change_rev_prop2 },
   { "rev-proplist",    rev_proplist },
+  { "rev-proplist-range", rev_proplist_range },
+  { "change-rev-props", change_rev_props },
   { "rev-prop",        rev_prop },
   { "commit",          commit },
   { "get-file",        get_file },
   { "get-dir",         get_dir },
-  { "update",          update },
-  { "switch",          switch_cmd },
-  { "status",          status },
-  { "diff",            diff },
+  { "update",          update, NULL, FALSE, TRUE },
+  { "switch",          switch_cmd, NULL, FALSE, TRUE },
+  { "status",          status, NULL, FALSE, TRUE },
+  { "diff",            diff, NULL, FALSE, TRUE },
   { "get-mergeinfo",   get_mergeinfo },
-  { "log",             log_cmd },
+  { "get-merge-plan",  get_merge_plan },
+  { "get-changes-summary", get_changes_summary },
+  { "log",             log_cmd, NULL, FALSE, TRUE },
   { "check-path",      check_path },
   { "stat",            stat_cmd },
+  { "stat-many",       stat_many },
+  { "get-files",       get_files, NULL, FALSE, TRUE },
   { "get-locations",   get_locations },
   { "get-location-segments",   get_location_segments },
-  { "get-file-revs",   get_file_revs },
+  { "get-file-revs",   get_file_revs, NULL, FALSE, TRUE },
   { "lock",            lock },
   { "lock-many",       lock_many },
   { "unlock",          unlock },
   { "unlock-many",     unlock_many },
   { "get-lock",        get_lock },
   { "get-locks",       get_locks },
-  { "replay",          replay },
-  { "replay-range",    replay_range },
+  { "replay",          replay, NULL, FALSE, TRUE },
+  { "replay-range",    replay_range, NULL, FALSE, TRUE },
   { "get-deleted-rev", get_deleted_rev },
   { "get-iprops",      get_inherited_props },
   { "list",            list },
@@ -3792,11 +4561,14 @@ find_repos(const char *url,
            svn_config_t *cfg,
            repository_t *repository,
            svn_repos__config_pool_t *config_pool,
+           svn_repos__repos_pool_t *repos_pool,
            apr_hash_t *fs_config,
            apr_pool_t *result_pool,
            apr_pool_t *scratch_pool)
 {
   const char *path, *full_path, *fs_path, *hooks_env;
+  const char *compression;
+  const char *max_changed_paths;
   svn_stringbuf_t *url_buf;
   svn_boolean_t sasl_requested;
 
@@ -3832,8 +4604,11 @@ find_repos(const char *url,
                              "No repository found in '%s'", url);
 
   /* Open the repository and fill in b with the resulting information. */
-  SVN_ERR(svn_repos_open3(&repository->repos, repository->repos_root,
-                          fs_config, result_pool, scratch_pool));
+  /* Open the repository or re-use an instance from an earlier
+     connection. */
+  SVN_ERR(svn_repos__repos_pool_get(&repository->repos, repos_pool,
+                                    repository->repos_root, fs_config,
+                                    result_pool, scratch_pool));
   SVN_ERR(svn_repos_remember_client_capabilities(repository->repos,
                                                  repository->capabilities));
   repository->fs = svn_repos_fs(repository->repos);
@@ -3924,6 +4699,33 @@ find_repos(const char *url,
   SVN_ERR(svn_repos_hooks_setenv(repository->repos, hooks_env, scratch_pool));
   repository->hooks_env = apr_pstrdup(result_pool, hooks_env);
 
+  /* Compress the whole connection?  SASL security layers take over
+     the connection stream during authentication, so we don't mix the
+     two. */
+  svn_config_get(cfg, &compression, SVN_CONFIG_SECTION_GENERAL,
+                 SVN_CONFIG_OPTION_STREAM_COMPRESSION, "none");
+  if (svn_cstring_casecmp(compression, "none") == 0)
+    repository->stream_compression = NULL;
+  else if (svn_cstring_casecmp(compression, "lz4") == 0)
+    repository->stream_compression = SVN_RA_SVN_CAP_COMPRESS_LZ4;
+  else if (svn_cstring_casecmp(compression, "zlib") == 0)
+    repository->stream_compression = SVN_RA_SVN_CAP_COMPRESS_ZLIB;
+  else
+    return svn_error_createf(SVN_ERR_BAD_CONFIG_VALUE, NULL,
+                             _("Invalid value '%s' for option '%s'; "
+                               "expected 'none', 'lz4' or 'zlib'"),
+                             compression,
+                             SVN_CONFIG_OPTION_STREAM_COMPRESSION);
+
+  if (repository->use_sasl)
+    repository->stream_compression = NULL;
+
+  /* Limit the number of changed paths per revision in log responses. */
+  svn_config_get(cfg, &max_changed_paths, SVN_CONFIG_SECTION_GENERAL,
+                 SVN_CONFIG_OPTION_MAX_CHANGED_PATHS, "0");
+  SVN_ERR(svn_cstring_atoui(&repository->max_changed_paths,
+                            max_changed_paths));
+
   return SVN_NO_ERROR;
 }
 
@@ -4121,6 +4923,7 @@ construct_server_baton(server_baton_t **baton,
   b->read_only = params->read_only;
   b->pool = conn_pool;
   b->vhost = params->vhost;
+  b->log_commit_timing = params->log_commit_timing;
 
   b->logger = params->logger;
   b->client_info = get_client_info(conn, params, conn_pool);
@@ -4129,11 +4932,12 @@ construct_server_baton(server_baton_t **baton,
    * send an empty mechlist. */
   if (params->compression_level > 0)
     SVN_ERR(svn_ra_svn__write_cmd_response(conn, scratch_pool,
-                                           "nn()(wwwwwwwwwwwww)",
+                                           "nn()(wwwwwwwwwwwwwwwwwwww)",
                                            (apr_uint64_t) 2, (apr_uint64_t) 2,
                                            SVN_RA_SVN_CAP_EDIT_PIPELINE,
                                            SVN_RA_SVN_CAP_SVNDIFF1,
                                            SVN_RA_SVN_CAP_SVNDIFF2_ACCEPTED,
+                                           SVN_RA_SVN_CAP_SVNDIFF3_ACCEPTED,
                                            SVN_RA_SVN_CAP_ABSENT_ENTRIES,
                                            SVN_RA_SVN_CAP_COMMIT_REVPROPS,
                                            SVN_RA_SVN_CAP_DEPTH,
@@ -4143,11 +4947,17 @@ construct_server_baton(server_baton_t **baton,
                                            SVN_RA_SVN_CAP_INHERITED_PROPS,
                                            SVN_RA_SVN_CAP_EPHEMERAL_TXNPROPS,
                                            SVN_RA_SVN_CAP_GET_FILE_REVS_REVERSE,
-                                           SVN_RA_SVN_CAP_LIST
+                                           SVN_RA_SVN_CAP_LIST,
+                                           SVN_RA_SVN_CAP_LIST_SINCE,
+                                           SVN_RA_SVN_CAP_STAT_MANY,
+                                           SVN_RA_SVN_CAP_GET_FILES,
+                                           SVN_RA_SVN_CAP_REV_PROPLIST_RANGE,
+                                           SVN_RA_SVN_CAP_CHANGE_REV_PROPS,
+                                           SVN_RA_SVN_CAP_APPLY_TEXT_BY_CHECKSUM
                                            ));
   else
     SVN_ERR(svn_ra_svn__write_cmd_response(conn, scratch_pool,
-                                           "nn()(wwwwwwwwwww)",
+                                           "nn()(wwwwwwwwwwwwwwwww)",
                                            (apr_uint64_t) 2, (apr_uint64_t) 2,
                                            SVN_RA_SVN_CAP_EDIT_PIPELINE,
                                            SVN_RA_SVN_CAP_ABSENT_ENTRIES,
@@ -4159,7 +4969,13 @@ construct_server_baton(server_baton_t **baton,
                                            SVN_RA_SVN_CAP_INHERITED_PROPS,
                                            SVN_RA_SVN_CAP_EPHEMERAL_TXNPROPS,
                                            SVN_RA_SVN_CAP_GET_FILE_REVS_REVERSE,
-                                           SVN_RA_SVN_CAP_LIST
+                                           SVN_RA_SVN_CAP_LIST,
+                                           SVN_RA_SVN_CAP_LIST_SINCE,
+                                           SVN_RA_SVN_CAP_STAT_MANY,
+                                           SVN_RA_SVN_CAP_GET_FILES,
+                                           SVN_RA_SVN_CAP_REV_PROPLIST_RANGE,
+                                           SVN_RA_SVN_CAP_CHANGE_REV_PROPS,
+                                           SVN_RA_SVN_CAP_APPLY_TEXT_BY_CHECKSUM
                                            ));
 
   /* Read client response, which we assume to be in version 2 format:
@@ -4217,6 +5033,7 @@ construct_server_baton(server_baton_t **baton,
   err = handle_config_error(find_repos(client_url, params->root, b->vhost,
                                        b->read_only, params->cfg,
                                        b->repository, params->config_pool,
+                                       params->repos_pool,
                                        params->fs_config,
                                        conn_pool, scratch_pool),
                             b);
@@ -4248,6 +5065,7 @@ construct_server_baton(server_baton_t **baton,
 
   SVN_ERR(svn_fs_get_uuid(b->repository->fs, &b->repository->uuid,
                           conn_pool));
+  SVN_ERR(start_io_trace(b, params, conn_pool, scratch_pool));
 
   /* We can't claim mergeinfo capability until we know whether the
      repository supports mergeinfo (i.e., is not a 1.4 repository),
@@ -4257,19 +5075,40 @@ construct_server_baton(server_baton_t **baton,
      the client has sent the url. */
   {
     svn_boolean_t supports_mergeinfo;
+    const char *compression = NULL;
     SVN_ERR(svn_repos_has_capability(b->repository->repos,
                                      &supports_mergeinfo,
                                      SVN_REPOS_CAPABILITY_MERGEINFO,
                                      scratch_pool));
 
+    /* Only compress the connection if the client can handle it. */
+    if (b->repository->stream_compression)
+      {
+        const char *accepted
+          = strcmp(b->repository->stream_compression,
+                   SVN_RA_SVN_CAP_COMPRESS_LZ4) == 0
+          ? SVN_RA_SVN_CAP_COMPRESS_LZ4_ACCEPTED
+          : SVN_RA_SVN_CAP_COMPRESS_ZLIB_ACCEPTED;
+
+        if (svn_ra_svn_has_capability(conn, accepted))
+          compression = b->repository->stream_compression;
+      }
+
     SVN_ERR(svn_ra_svn__write_tuple(conn, scratch_pool, "w(cc(!",
                                     "success", b->repository->uuid,
                                     b->repository->repos_url));
     if (supports_mergeinfo)
       SVN_ERR(svn_ra_svn__write_word(conn, scratch_pool,
                                      SVN_RA_SVN_CAP_MERGEINFO));
+    if (compression)
+      SVN_ERR(svn_ra_svn__write_word(conn, scratch_pool, compression));
     SVN_ERR(svn_ra_svn__write_tuple(conn, scratch_pool, "!))"));
     SVN_ERR(svn_ra_svn__flush(conn, scratch_pool));
+
+    /* Everything after this response is compressed. */
+    if (compression)
+      SVN_ERR(svn_ra_svn__enable_compression(conn, compression,
+                                             scratch_pool));
   }
 
   /* Log the open. */
@@ -4313,11 +5152,13 @@ construct_server_baton(server_baton_t **baton,
 
 svn_error_t *
 serve_interruptable(svn_boolean_t *terminate_p,
+                    svn_boolean_t *idle_p,
                     connection_t *connection,
                     svn_boolean_t (* is_busy)(connection_t *),
                     apr_pool_t *pool)
 {
   svn_boolean_t terminate = FALSE;
+  svn_boolean_t idle = FALSE;
   svn_error_t *err = NULL;
   const svn_ra_svn__cmd_entry_t *command;
   apr_pool_t *iterpool = svn_pool_create(pool);
@@ -4383,6 +5224,8 @@ serve_interruptable(svn_boolean_t *terminate_p,
                                              connection->baton,
                                              connection->conn,
                                              FALSE, iterpool);
+          else if (!err)
+            idle = !terminate;
 
           break;
         }
@@ -4402,8 +5245,17 @@ serve_interruptable(svn_boolean_t *terminate_p,
 
   /* error or normal end of session. Close the connection */
   svn_pool_destroy(iterpool);
+  if ((terminate || err) && connection->baton)
+    {
+      svn_error_clear(log_io_trace(connection->baton, connection->conn,
+                                   pool));
+      svn_error_clear(log_conn_stats(connection->baton, connection->conn,
+                                     pool));
+    }
   if (terminate_p)
     *terminate_p = terminate;
+  if (idle_p)
+    *idle_p = idle;
 
   return svn_error_trace(err);
 }
@@ -4413,7 +5265,11 @@ svn_error_t *serve(svn_ra_svn_conn_t *conn,
                    apr_pool_t *pool)
 {
   server_baton_t *baton = NULL;
+  svn_error_t *err;
 
   SVN_ERR(construct_server_baton(&baton, conn, params, pool));
-  return svn_ra_svn__handle_commands2(conn, pool, main_commands, baton, FALSE);
+  err = svn_ra_svn__handle_commands2(conn, pool, main_commands, baton, FALSE);
+  svn_error_clear(log_conn_stats(baton, conn, pool));
+
+  return svn_error_trace(err);
 }
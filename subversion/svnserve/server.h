@@ -73,6 +73,10 @@ typedef struct repository_t {
   enum access_type auth_access; /* access granted to authenticated users */
   enum access_type anon_access; /* access granted to annonymous users */
 
+  const char *stream_compression; /* SVN_RA_SVN_CAP_COMPRESS_* or NULL */
+  unsigned max_changed_paths; /* Max. changed paths sent per revision
+                                 in log responses; 0 = unlimited */
+
 } repository_t;
 
 typedef struct client_info_t {
@@ -90,6 +94,8 @@ typedef struct server_baton_t {
                               May be NULL even if log_file is not. */
   svn_boolean_t read_only; /* Disallow write access (global flag) */
   svn_boolean_t vhost;     /* Use virtual-host-based path to repo. */
+  const char *io_trace_path; /* File receiving the FS I/O trace or NULL. */
+  svn_boolean_t log_commit_timing; /* Log the duration of commit phases. */
   apr_pool_t *pool;
 } server_baton_t;
 
@@ -127,6 +133,9 @@ typedef struct serve_params_t {
   /* all configurations should be opened through this factory */
   svn_repos__config_pool_t *config_pool;
 
+  /* all repositories should be opened through this factory */
+  svn_repos__repos_pool_t *repos_pool;
+
   /* The FS configuration to be applied to all repositories.
      It mainly contains things like cache settings. */
   apr_hash_t *fs_config;
@@ -159,6 +168,16 @@ typedef struct serve_params_t {
 
   /* Use virtual-host-based path to repo. */
   svn_boolean_t vhost;
+
+  /* Trace the FS I/O of each connection and log the totals. */
+  svn_boolean_t trace_io;
+
+  /* If not NULL, also write a file with all FS item accesses for each
+     connection into this directory. */
+  const char *trace_io_dir;
+
+  /* Log how long the individual phases of each commit took. */
+  svn_boolean_t log_commit_timing;
 } serve_params_t;
 
 /* This structure contains all data that describes a client / server
@@ -181,6 +200,10 @@ typedef struct connection_t
   /* memory pool for objects with connection lifetime */
   apr_pool_t *pool;
 
+  /* Whether POOL has been acquired from the recycled root pools and shall
+     be released there instead of being destroyed. */
+  svn_boolean_t recycle_pool;
+
   /* Number of threads using the pool.
      The pool passed to apr_thread_create can only be released when both
 
@@ -192,6 +215,10 @@ typedef struct connection_t
      released.  */
   svn_atomic_t ref_count;
 
+  /* Descriptor used to wait for the next command on an idle connection
+     in event-driven mode.  NULL until first used. */
+  struct apr_pollfd_t *poll_descriptor;
+
 } connection_t;
 
 /* Return a client_info_t structure allocated in POOL and initialize it
@@ -208,7 +235,9 @@ svn_error_t *serve(svn_ra_svn_conn_t *conn, serve_params_t *params,
    return TRUE.  If IS_BUSY is NULL, serve the connection until it
    either gets terminated or there is an error.  If TERMINATE_P is
    not NULL, set *TERMINATE_P to TRUE if the connection got
-   terminated.
+   terminated.  If IDLE_P is not NULL, set *IDLE_P to TRUE if we
+   returned because of IS_BUSY and there was no command waiting to be
+   processed, i.e. the next one has not been received yet.
 
    For the first call, CONNECTION->CONN may be NULL in which case we
    will create an ra_svn connection object.  Subsequent calls will
@@ -217,6 +246,7 @@ svn_error_t *serve(svn_ra_svn_conn_t *conn, serve_params_t *params,
  */
 svn_error_t *
 serve_interruptable(svn_boolean_t *terminate_p,
+                    svn_boolean_t *idle_p,
                     connection_t *connection,
                     svn_boolean_t (* is_busy)(connection_t *),
                     apr_pool_t *pool);
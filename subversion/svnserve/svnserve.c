@@ -55,10 +55,14 @@
 #include "private/svn_dep_compat.h"
 #include "private/svn_cmdline_private.h"
 #include "private/svn_atomic.h"
+#include "private/svn_cache.h"
+#include "private/svn_fs_private.h"
+#include "private/svn_metrics.h"
 #include "private/svn_mutex.h"
 #include "private/svn_subr_private.h"
 
 #if APR_HAS_THREADS
+#    include <apr_poll.h>
 #    include <apr_thread_pool.h>
 #endif
 
@@ -145,6 +149,13 @@ enum run_mode {
  */
 #define THREADPOOL_THREAD_IDLE_LIMIT 1000000
 
+/* Maximum number of idle connections that the event-driven mode will
+ * hand over to worker threads in one go.  More may become ready at the
+ * same time; they will simply be picked up in the next round.  With epoll
+ * and kqueue, this does not limit the number of idle connections.
+ */
+#define REACTOR_BATCH_SIZE 1024
+
 /* Number of client to server connections that may concurrently in the
  * TCP 3-way handshake state, i.e. are in the process of being created.
  *
@@ -222,6 +233,17 @@ void winservice_notify_stop(void)
 #define SVNSERVE_OPT_MAX_REQUEST     274
 #define SVNSERVE_OPT_MAX_RESPONSE    275
 #define SVNSERVE_OPT_CACHE_NODEPROPS 276
+#define SVNSERVE_OPT_SHARED_CACHE    277
+#define SVNSERVE_OPT_EVENT_DRIVEN    278
+#define SVNSERVE_OPT_AUTHZ_CACHE_DIR 279
+#define SVNSERVE_OPT_METRICS_FILE    280
+#define SVNSERVE_OPT_TRACE_IO        281
+#define SVNSERVE_OPT_TRACE_IO_DIR    282
+#define SVNSERVE_OPT_COMMIT_TIMING   283
+#define SVNSERVE_OPT_OVERFLOW_DIR    284
+#define SVNSERVE_OPT_OVERFLOW_SIZE   285
+#define SVNSERVE_OPT_CACHE_SNAPSHOT  286
+#define SVNSERVE_OPT_SNAPSHOT_INTERVAL 287
 
 /* Text macro because we can't use #ifdef sections inside a N_("...")
    macro expansion. */
@@ -297,6 +319,46 @@ static const apr_getopt_option_t svnserve__options[] =
         "0 switches to dynamically sized caches.\n"
         "                             "
         "[used for FSFS and FSX repositories only]")},
+    {"shared-memory-cache", SVNSERVE_OPT_SHARED_CACHE, 1,
+     N_("share the in-memory cache between all forked\n"
+        "                             "
+        "worker processes instead of keeping one cache\n"
+        "                             "
+        "per connection process.\n"
+        "                             "
+        "Default is no.\n"
+        "                             "
+        "[mode: daemon; used for FSFS and FSX only]")},
+    {"cache-overflow-dir", SVNSERVE_OPT_OVERFLOW_DIR, 1,
+     N_("keep items evicted from the in-memory cache in a\n"
+        "                             "
+        "temporary file in directory ARG, e.g. on a local\n"
+        "                             "
+        "SSD.  Requires --cache-overflow-size.\n"
+        "                             "
+        "[mode: threads; used for FSFS and FSX only]")},
+    {"cache-overflow-size", SVNSERVE_OPT_OVERFLOW_SIZE, 1,
+     N_("size of the cache overflow file in MB.\n"
+        "                             "
+        "Default is 0, i.e. no overflow file.")},
+    {"cache-snapshot", SVNSERVE_OPT_CACHE_SNAPSHOT, 1,
+     N_("restore the in-memory cache from file ARG at\n"
+        "                             "
+        "startup and save it there after connections,\n"
+        "                             "
+        "see --cache-snapshot-interval.  Not with\n"
+        "                             "
+        "fork-based handling.\n"
+        "                             "
+        "[mode: daemon, listen-once, service;\n"
+        "                             "
+        " used for FSFS and FSX only]")},
+    {"cache-snapshot-interval", SVNSERVE_OPT_SNAPSHOT_INTERVAL, 1,
+     N_("save the cache snapshot at most once per ARG\n"
+        "                             "
+        "seconds.\n"
+        "                             "
+        "Default is 300.")},
     {"cache-txdeltas", SVNSERVE_OPT_CACHE_TXDELTAS, 1,
      N_("enable or disable caching of deltas between older\n"
         "                             "
@@ -312,11 +374,11 @@ static const apr_getopt_option_t svnserve__options[] =
         "                             "
         "[used for FSFS and FSX repositories only]")},
     {"cache-revprops", SVNSERVE_OPT_CACHE_REVPROPS, 1,
-     N_("enable or disable caching of revision properties.\n"
+     N_("enable or disable caching of revision properties\n"
         "                             "
-        "Consult the documentation before activating this.\n"
+        "across requests and connections.\n"
         "                             "
-        "Default is no.\n"
+        "Default is yes.\n"
         "                             "
         "[used for FSFS and FSX repositories only]")},
     {"cache-nodeprops", SVNSERVE_OPT_CACHE_NODEPROPS, 1,
@@ -325,6 +387,12 @@ static const apr_getopt_option_t svnserve__options[] =
         "Default is yes.\n"
         "                             "
         "[used for FSFS repositories only]")},
+    {"authz-cache-dir", SVNSERVE_OPT_AUTHZ_CACHE_DIR, 1,
+     N_("store compiled authz rules in directory ARG such\n"
+        "                             "
+        "that other server processes don't need to parse\n"
+        "                             "
+        "the same rules again.")},
     {"client-speed", SVNSERVE_OPT_CLIENT_SPEED, 1,
      N_("Optimize network handling based on the assumption\n"
         "                             "
@@ -362,6 +430,15 @@ static const apr_getopt_option_t svnserve__options[] =
         "                             "
         "Default is " APR_STRINGIFY(THREADPOOL_MAX_SIZE) "."
         ONLY_AVAILABLE_WITH_THEADS)},
+    {"event-driven",     SVNSERVE_OPT_EVENT_DRIVEN, 0,
+     N_("Release the server thread while a connection waits\n"
+        "                             "
+        "for its next command.  Idle connections get parked\n"
+        "                             "
+        "in an event queue (epoll, kqueue etc.) such that\n"
+        "                             "
+        "a few threads can serve many mostly idle clients."
+        ONLY_AVAILABLE_WITH_THEADS)},
 #endif
     {"max-request-size", SVNSERVE_OPT_MAX_REQUEST, 1,
      N_("Maximum acceptable size of a client request in MB.\n"
@@ -396,6 +473,30 @@ static const apr_getopt_option_t svnserve__options[] =
         "process (useful for debugging)")},
     {"log-file",         SVNSERVE_OPT_LOG_FILE, 1,
      N_("svnserve log file")},
+    {"metrics-file",     SVNSERVE_OPT_METRICS_FILE, 1,
+     N_("write server statistics in the Prometheus text\n"
+        "                             "
+        "format to file ARG after connections, at most\n"
+        "                             "
+        "once per second.  Not with fork-based handling.\n"
+        "                             "
+        "[mode: daemon, listen-once, service]")},
+    {"trace-io",         SVNSERVE_OPT_TRACE_IO, 0,
+     N_("log the repository I/O totals of each connection\n"
+        "                             "
+        "[used for FSFS repositories only]")},
+    {"trace-io-dir",     SVNSERVE_OPT_TRACE_IO_DIR, 1,
+     N_("like --trace-io and also write every repository\n"
+        "                             "
+        "item access of each connection as JSON lines to a\n"
+        "                             "
+        "new file in directory ARG\n"
+        "                             "
+        "[used for FSFS repositories only]")},
+    {"log-commit-timing", SVNSERVE_OPT_COMMIT_TIMING, 0,
+     N_("log how long the phases of each commit took,\n"
+        "                             "
+        "e.g. waiting for the write lock or running hooks")},
     {"pid-file",         SVNSERVE_OPT_PID_FILE, 1,
 #ifdef WIN32
      N_("write server process ID to file ARG\n"
@@ -513,6 +614,56 @@ static apr_status_t redirect_stdout(void *arg)
   return apr_file_dup2(out_file, err_file, pool);
 }
 
+#if APR_HAS_THREADS
+
+/* allocate and recycle root pools for connection objects.
+   There should be at most THREADPOOL_MAX_SIZE such pools. */
+static svn_root_pools__t *connection_pools;
+
+#endif
+
+#ifdef SIGUSR1
+/* File to write the pool profile to on SIGUSR1.  NULL if not enabled. */
+static const char *pool_profile_filename = NULL;
+
+/* Set by sigusr1_handler() until the pool profile has been written. */
+static volatile sig_atomic_t pool_profile_requested = FALSE;
+
+static void sigusr1_handler(int signo)
+{
+  /* Interrupts the accept(); the main loop does the actual work. */
+  pool_profile_requested = TRUE;
+}
+#endif
+
+/* Write the pool profile to POOL_PROFILE_FILENAME if that has been
+ * requested since the last call.  Errors are logged to LOGGER.  Use a
+ * sub-pool of POOL for temporary allocations.
+ */
+static void
+write_pool_profile(logger_t *logger,
+                   apr_pool_t *pool)
+{
+#ifdef SIGUSR1
+  apr_pool_t *subpool;
+  svn_error_t *err;
+
+  if (!pool_profile_requested || !pool_profile_filename)
+    return;
+
+  pool_profile_requested = FALSE;
+  subpool = svn_pool_create(pool);
+  err = svn_pool__profile_write(pool_profile_filename, subpool);
+  if (err)
+    {
+      logger__log_error(logger, err, NULL, NULL);
+      svn_error_clear(err);
+    }
+
+  svn_pool_destroy(subpool);
+#endif
+}
+
 /* Wait for the next client connection to come in from SOCK.  Allocate
  * the connection in a root pool from CONNECTION_POOLS and assign PARAMS.
  * Return the connection object in *CONNECTION.
@@ -532,9 +683,29 @@ accept_connection(connection_t **connection,
    *         the connection threads so it cannot clean up after each one.  So
    *         separate pools that can be cleared at thread exit are used. */
 
-  apr_pool_t *connection_pool = svn_pool_create(pool);
+  apr_pool_t *connection_pool;
+  svn_boolean_t recycle_pool = FALSE;
+
+#if APR_HAS_THREADS
+  /* Worker threads allocate connection-lifetime data, most notably the
+   * repository and FS objects, in the connection pool.  A sub-pool of POOL
+   * would have them all contend for its thread-safe allocator.  Use
+   * a recycled root pool with its own, unshared allocator instead.
+   * Only one thread at a time will be serving the connection. */
+  if (handling_mode == connection_mode_thread)
+    {
+      connection_pool = svn_root_pools__acquire_pool(connection_pools);
+      recycle_pool = TRUE;
+    }
+  else
+#endif
+    {
+      connection_pool = svn_pool_create(pool);
+    }
+
   *connection = apr_pcalloc(connection_pool, sizeof(**connection));
   (*connection)->pool = connection_pool;
+  (*connection)->recycle_pool = recycle_pool;
   (*connection)->params = params;
   (*connection)->ref_count = 1;
 
@@ -547,6 +718,7 @@ accept_connection(connection_t **connection,
 
       status = apr_socket_accept(&(*connection)->usock, sock,
                                  connection_pool);
+      write_pool_profile(params->logger, pool);
       if (handling_mode == connection_mode_fork)
         {
           apr_proc_t proc;
@@ -583,7 +755,102 @@ close_connection(connection_t *connection)
 {
   /* this will automatically close USOCK */
   if (svn_atomic_dec(&connection->ref_count) == 0)
-    svn_pool_destroy(connection->pool);
+    {
+#if APR_HAS_THREADS
+      if (connection->recycle_pool)
+        {
+          svn_root_pools__release_pool(connection->pool, connection_pools);
+          return;
+        }
+#endif
+
+      svn_pool_destroy(connection->pool);
+    }
+}
+
+/* File to write the server statistics to.  NULL if not requested. */
+static const char *metrics_filename = NULL;
+
+/* Non-zero while some thread is writing METRICS_FILENAME. */
+static volatile svn_atomic_t metrics_writing = 0;
+
+/* When we last wrote METRICS_FILENAME. */
+static apr_time_t metrics_last_written = 0;
+
+/* Update METRICS_FILENAME, if set, unless it has been written during the
+ * last second or is being written right now.  The file gets replaced
+ * atomically.  Errors are logged to LOGGER.  Use POOL for temporary
+ * allocations.
+ */
+static void
+write_metrics_file(logger_t *logger,
+                   apr_pool_t *pool)
+{
+  svn_stringbuf_t *text;
+  svn_error_t *err;
+  apr_time_t now = apr_time_now();
+
+  if (   !metrics_filename
+      || now - metrics_last_written < apr_time_from_sec(1))
+    return;
+
+  if (svn_atomic_cas(&metrics_writing, 1, 0) != 0)
+    return;
+
+  metrics_last_written = now;
+  err = svn_metrics__format(&text, pool, pool);
+  if (!err)
+    err = svn_io_write_atomic2(metrics_filename, text->data, text->len,
+                               NULL, FALSE, pool);
+
+  if (err)
+    {
+      logger__log_error(logger, err, NULL, NULL);
+      svn_error_clear(err);
+    }
+
+  svn_atomic_set(&metrics_writing, 0);
+}
+
+/* File to save the cache contents to.  NULL if not requested. */
+static const char *cache_snapshot_filename = NULL;
+
+/* Minimum time between two updates of CACHE_SNAPSHOT_FILENAME. */
+static apr_interval_time_t cache_snapshot_interval
+  = 300 * APR_USEC_PER_SEC;
+
+/* Non-zero while some thread is writing CACHE_SNAPSHOT_FILENAME. */
+static volatile svn_atomic_t cache_snapshot_writing = 0;
+
+/* When we last wrote or read CACHE_SNAPSHOT_FILENAME. */
+static apr_time_t cache_snapshot_last_written = 0;
+
+/* Like write_metrics_file but save the cache contents to
+ * CACHE_SNAPSHOT_FILENAME at most once per CACHE_SNAPSHOT_INTERVAL.
+ */
+static void
+write_cache_snapshot(logger_t *logger,
+                     apr_pool_t *pool)
+{
+  svn_error_t *err;
+  apr_time_t now = apr_time_now();
+
+  if (   !cache_snapshot_filename
+      || now - cache_snapshot_last_written < cache_snapshot_interval)
+    return;
+
+  if (svn_atomic_cas(&cache_snapshot_writing, 1, 0) != 0)
+    return;
+
+  cache_snapshot_last_written = now;
+  err = svn_fs__save_cache_snapshot(cache_snapshot_filename, pool);
+  if (err)
+    {
+      logger__log_error(logger, err, NULL, NULL);
+      svn_error_clear(err);
+    }
+
+  svn_atomic_set(&cache_snapshot_writing, 0);
 }
 
 /* Wrapper around serve() that takes a socket instead of a connection.
@@ -596,21 +863,21 @@ serve_socket(connection_t *connection,
              apr_pool_t *pool)
 {
   /* process the actual request and log errors */
-  svn_error_t *err = serve_interruptable(NULL, connection, NULL, pool);
+  svn_error_t *err = serve_interruptable(NULL, NULL, connection, NULL,
+                                         pool);
   if (err)
     logger__log_error(connection->params->logger, err, NULL,
                       get_client_info(connection->conn, connection->params,
                                       pool));
 
+  write_metrics_file(connection->params->logger, pool);
+  write_cache_snapshot(connection->params->logger, pool);
+
   return svn_error_trace(err);
 }
 
 #if APR_HAS_THREADS
 
-/* allocate and recycle root pools for connection objects.
-   There should be at most THREADPOOL_MAX_SIZE such pools. */
-static svn_root_pools__t *connection_pools;
-
 /* The global thread pool serving all connections. */
 static apr_thread_pool_t *threads;
 
@@ -624,19 +891,112 @@ is_busy(connection_t *connection)
        > apr_thread_pool_thread_max_get(threads);
 }
 
+/* In event-driven mode, the set of idle connections waiting for their
+   next command.  NULL otherwise. */
+static apr_pollset_t *idle_connections;
+
+/* The thread dispatching the IDLE_CONNECTIONS to THREADS and whether it
+   has been asked to terminate. */
+static apr_thread_t *reactor;
+static volatile svn_atomic_t reactor_stopping = FALSE;
+
+/* Load determination callback for serve_interruptable in event-driven
+   mode:  Never wait for the next command in a worker thread. */
+static svn_boolean_t
+always_busy(connection_t *connection)
+{
+  return TRUE;
+}
+
+static void * APR_THREAD_FUNC serve_thread(apr_thread_t *tid, void *data);
+
+/* Add the idle CONNECTION to IDLE_CONNECTIONS.  The reactor thread will
+   hand it over to THREADS again once the next command comes in. */
+static void
+park_connection(connection_t *connection)
+{
+  apr_status_t status;
+
+  if (!connection->poll_descriptor)
+    {
+      apr_pollfd_t *descriptor = apr_pcalloc(connection->pool,
+                                             sizeof(*descriptor));
+      descriptor->p = connection->pool;
+      descriptor->desc_type = APR_POLL_SOCKET;
+      descriptor->reqevents = APR_POLLIN;
+      descriptor->desc.s = connection->usock;
+      descriptor->client_data = connection;
+
+      connection->poll_descriptor = descriptor;
+    }
+
+  status = apr_pollset_add(idle_connections, connection->poll_descriptor);
+
+  /* Fall back to simple round-robin. */
+  if (status)
+    apr_thread_pool_push(threads, serve_thread, connection, 0, NULL);
+}
+
+/* Thread function waiting for client activity on IDLE_CONNECTIONS and
+   passing the respective connections on to THREADS.  DATA is the
+   serve_params_t. */
+static void * APR_THREAD_FUNC reactor_thread(apr_thread_t *tid, void *data)
+{
+  serve_params_t *params = data;
+
+  while (!svn_atomic_read(&reactor_stopping))
+    {
+      const apr_pollfd_t *ready;
+      apr_int32_t count, i;
+      apr_status_t status;
+
+      status = apr_pollset_poll(idle_connections, -1, &count, &ready);
+      if (APR_STATUS_IS_EINTR(status) || APR_STATUS_IS_TIMEUP(status))
+        continue;
+
+      if (status)
+        {
+          svn_error_t *err = svn_error_wrap_apr(status,
+                                                _("Can't poll connections"));
+          logger__log_error(params->logger, err, NULL, NULL);
+          svn_error_clear(err);
+
+          /* Don't spin on persistent errors. */
+          apr_sleep(APR_USEC_PER_SEC / 10);
+          continue;
+        }
+
+      for (i = 0; i < count; ++i)
+        {
+          connection_t *connection = ready[i].client_data;
+
+          apr_pollset_remove(idle_connections, connection->poll_descriptor);
+          if (apr_thread_pool_push(threads, serve_thread, connection, 0,
+                                   NULL))
+            close_connection(connection);
+        }
+    }
+
+  return NULL;
+}
+
 /* Serve the connection given by DATA.  Under high load, serve only
    the current command (if any) and then put the connection back into
-   THREAD's task pool. */
+   THREAD's task pool.  In event-driven mode, always serve at most one
+   command and park the connection while it is idle. */
 static void * APR_THREAD_FUNC serve_thread(apr_thread_t *tid, void *data)
 {
   svn_boolean_t done;
+  svn_boolean_t idle;
   connection_t *connection = data;
   svn_error_t *err;
 
   apr_pool_t *pool = svn_root_pools__acquire_pool(connection_pools);
 
   /* process the actual request and log errors */
-  err = serve_interruptable(&done, connection, is_busy, pool);
+  err = serve_interruptable(&done, &idle, connection,
+                            idle_connections ? always_busy : is_busy,
+                            pool);
   if (err)
     {
       logger__log_error(connection->params->logger, err, NULL,
@@ -647,9 +1007,11 @@ static void * APR_THREAD_FUNC serve_thread(apr_thread_t *tid, void *data)
     }
   svn_root_pools__release_pool(pool, connection_pools);
 
-  /* Close or re-schedule connection. */
+  /* Close, park or re-schedule connection. */
   if (done)
     close_connection(connection);
+  else if (idle && idle_connections)
+    park_connection(connection);
   else
     apr_thread_pool_push(threads, serve_thread, connection, 0, NULL);
 
@@ -723,7 +1085,10 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
   svn_boolean_t cache_fulltexts = TRUE;
   svn_boolean_t cache_nodeprops = TRUE;
   svn_boolean_t cache_txdeltas = TRUE;
-  svn_boolean_t cache_revprops = FALSE;
+  svn_boolean_t cache_revprops = TRUE;
+  svn_boolean_t shared_cache = FALSE;
+  const char *cache_overflow_dir = NULL;
+  apr_uint64_t cache_overflow_size = 0;
   svn_boolean_t use_block_read = FALSE;
   apr_uint16_t port = SVN_RA_SVN_PORT;
   const char *host = NULL;
@@ -737,11 +1102,13 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
   int mode_opt_count = 0;
   int handling_opt_count = 0;
   const char *config_filename = NULL;
+  const char *authz_cache_dir = NULL;
   const char *pid_filename = NULL;
   const char *log_filename = NULL;
   svn_node_kind_t kind;
   apr_size_t min_thread_count = THREADPOOL_MIN_SIZE;
   apr_size_t max_thread_count = THREADPOOL_MAX_SIZE;
+  svn_boolean_t event_driven = FALSE;
 #ifdef SVN_HAVE_SASL
   SVN_ERR(cyrus_init(pool));
 #endif
@@ -766,6 +1133,7 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
   params.compression_level = SVN_DELTA_COMPRESSION_LEVEL_DEFAULT;
   params.logger = NULL;
   params.config_pool = NULL;
+  params.repos_pool = NULL;
   params.fs_config = NULL;
   params.vhost = FALSE;
   params.username_case = CASE_ASIS;
@@ -774,6 +1142,9 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
   params.error_check_interval = 4096;
   params.max_request_size = MAX_REQUEST_SIZE * 0x100000;
   params.max_response_size = 0;
+  params.trace_io = FALSE;
+  params.trace_io_dir = NULL;
+  params.log_commit_timing = FALSE;
 
   while (1)
     {
@@ -909,6 +1280,45 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
           }
           break;
 
+        case SVNSERVE_OPT_SHARED_CACHE:
+          shared_cache = svn_tristate__from_word(arg) == svn_tristate_true;
+          break;
+
+        case SVNSERVE_OPT_OVERFLOW_DIR:
+          SVN_ERR(svn_utf_cstring_to_utf8(&cache_overflow_dir, arg, pool));
+          cache_overflow_dir = svn_dirent_internal_style(cache_overflow_dir,
+                                                         pool);
+          SVN_ERR(svn_dirent_get_absolute(&cache_overflow_dir,
+                                          cache_overflow_dir, pool));
+          break;
+
+        case SVNSERVE_OPT_OVERFLOW_SIZE:
+          {
+            apr_uint64_t sz_val;
+            SVN_ERR(svn_cstring_atoui64(&sz_val, arg));
+
+            cache_overflow_size = 0x100000 * sz_val;
+          }
+          break;
+
+        case SVNSERVE_OPT_CACHE_SNAPSHOT:
+          SVN_ERR(svn_utf_cstring_to_utf8(&cache_snapshot_filename, arg,
+                                          pool));
+          cache_snapshot_filename
+            = svn_dirent_internal_style(cache_snapshot_filename, pool);
+          SVN_ERR(svn_dirent_get_absolute(&cache_snapshot_filename,
+                                          cache_snapshot_filename, pool));
+          break;
+
+        case SVNSERVE_OPT_SNAPSHOT_INTERVAL:
+          {
+            apr_uint64_t interval;
+            SVN_ERR(svn_cstring_atoui64(&interval, arg));
+
+            cache_snapshot_interval = apr_time_from_sec(interval);
+          }
+          break;
+
         case SVNSERVE_OPT_CACHE_TXDELTAS:
           cache_txdeltas = svn_tristate__from_word(arg) == svn_tristate_true;
           break;
@@ -962,6 +1372,10 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
           max_thread_count = (apr_size_t)apr_strtoi64(arg, NULL, 0);
           break;
 
+        case SVNSERVE_OPT_EVENT_DRIVEN:
+          event_driven = TRUE;
+          break;
+
 #ifdef WIN32
         case SVNSERVE_OPT_SERVICE:
           if (run_mode != run_mode_service)
@@ -995,6 +1409,38 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
           SVN_ERR(svn_dirent_get_absolute(&log_filename, log_filename, pool));
           break;
 
+        case SVNSERVE_OPT_AUTHZ_CACHE_DIR:
+          SVN_ERR(svn_utf_cstring_to_utf8(&authz_cache_dir, arg, pool));
+          authz_cache_dir = svn_dirent_internal_style(authz_cache_dir, pool);
+          SVN_ERR(svn_dirent_get_absolute(&authz_cache_dir, authz_cache_dir,
+                                          pool));
+          break;
+
+        case SVNSERVE_OPT_TRACE_IO:
+          params.trace_io = TRUE;
+          break;
+
+        case SVNSERVE_OPT_TRACE_IO_DIR:
+          SVN_ERR(svn_utf_cstring_to_utf8(&params.trace_io_dir, arg, pool));
+          params.trace_io_dir = svn_dirent_internal_style(params.trace_io_dir,
+                                                          pool);
+          SVN_ERR(svn_dirent_get_absolute(&params.trace_io_dir,
+                                          params.trace_io_dir, pool));
+          params.trace_io = TRUE;
+          break;
+
+        case SVNSERVE_OPT_COMMIT_TIMING:
+          params.log_commit_timing = TRUE;
+          break;
+
+        case SVNSERVE_OPT_METRICS_FILE:
+          SVN_ERR(svn_utf_cstring_to_utf8(&metrics_filename, arg, pool));
+          metrics_filename = svn_dirent_internal_style(metrics_filename,
+                                                       pool);
+          SVN_ERR(svn_dirent_get_absolute(&metrics_filename, metrics_filename,
+                                          pool));
+          break;
+
         }
     }
 
@@ -1036,6 +1482,46 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
       return SVN_NO_ERROR;
     }
 
+  if (event_driven && handling_mode != connection_mode_thread)
+    {
+      svn_error_clear(svn_cmdline_fputs(
+                      _("Option --event-driven requires -T\n"),
+                      stderr, pool));
+      usage(argv[0], pool);
+      *exit_code = EXIT_FAILURE;
+      return SVN_NO_ERROR;
+    }
+
+  /* Forked workers would overwrite each other's statistics. */
+  if (metrics_filename && handling_mode == connection_mode_fork
+      && run_mode == run_mode_daemon)
+    {
+      svn_error_clear(svn_cmdline_fputs(
+                      _("Option --metrics-file requires -T or "
+                        "--single-thread\n"),
+                      stderr, pool));
+      usage(argv[0], pool);
+      *exit_code = EXIT_FAILURE;
+      return SVN_NO_ERROR;
+    }
+
+  /* Forked workers would not share a common save schedule. */
+  if (cache_snapshot_filename && handling_mode == connection_mode_fork
+      && run_mode == run_mode_daemon)
+    {
+      svn_error_clear(svn_cmdline_fputs(
+                      _("Option --cache-snapshot requires -T or "
+                        "--single-thread\n"),
+                      stderr, pool));
+      usage(argv[0], pool);
+      *exit_code = EXIT_FAILURE;
+      return SVN_NO_ERROR;
+    }
+
+  /* Share compiled authz rules with other server processes. */
+  if (authz_cache_dir)
+    svn_repos__authz_set_cache_dir(authz_cache_dir);
+
   /* construct object pools */
   is_multi_threaded = handling_mode == connection_mode_thread;
   params.fs_config = apr_hash_make(pool);
@@ -1053,6 +1539,9 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
   SVN_ERR(svn_repos__config_pool_create(&params.config_pool,
                                         is_multi_threaded,
                                         pool));
+  SVN_ERR(svn_repos__repos_pool_create(&params.repos_pool,
+                                       is_multi_threaded,
+                                       pool));
 
   /* If a configuration file is specified, load it and any referenced
    * password and authorization files. */
@@ -1236,6 +1725,21 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
       return svn_error_wrap_apr(status, _("Can't listen on server socket"));
     }
 
+#ifdef SIGUSR1
+  /* Let SIGUSR1 dump the pool profile to the file named in the
+   * environment.  Resolve the path before we daemonize. */
+  if (svn_pool__profile_enabled())
+    {
+      SVN_ERR(svn_utf_cstring_to_utf8(&pool_profile_filename,
+                                      getenv(SVN_POOL__PROFILE_ENV), pool));
+      pool_profile_filename = svn_dirent_internal_style(pool_profile_filename,
+                                                        pool);
+      SVN_ERR(svn_dirent_get_absolute(&pool_profile_filename,
+                                      pool_profile_filename, pool));
+      apr_signal(SIGUSR1, sigusr1_handler);
+    }
+#endif
+
 #if APR_HAS_FORK
   if (run_mode != run_mode_listen_once && !foreground)
     /* ### ignoring errors... */
@@ -1295,6 +1799,34 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
       }
 
     svn_cache_config_set(&settings);
+
+    /* Every process has its own overflow file, so only threads may use
+     * them without multiplying the disk usage. */
+    if (cache_overflow_dir && handling_mode == connection_mode_thread)
+      svn_cache__set_global_membuffer_overflow(cache_overflow_dir,
+                                               cache_overflow_size);
+
+    /* Workers forked from this process will only share the cache if it
+     * gets created before the first fork.  Threads share it anyway. */
+    if (shared_cache && handling_mode == connection_mode_fork)
+      {
+        svn_cache__set_global_membuffer_shared(TRUE);
+        svn_cache__get_global_membuffer_cache();
+      }
+
+    /* Start with the cache contents of our previous incarnation.  We may
+     * still serve requests with a cold cache if that fails. */
+    if (cache_snapshot_filename)
+      {
+        err = svn_fs__load_cache_snapshot(cache_snapshot_filename, pool);
+        if (err)
+          {
+            logger__log_error(params.logger, err, NULL, NULL);
+            svn_error_clear(err);
+          }
+
+        cache_snapshot_last_written = apr_time_now();
+      }
   }
 
 #if APR_HAS_THREADS
@@ -1323,6 +1855,24 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
 
       /* don't queue requests unless we reached the worker thread limit */
       apr_thread_pool_threshold_set(threads, 0);
+
+      if (event_driven)
+        {
+          /* Idle connections get added and removed by worker threads
+             while the reactor thread waits for them. */
+          status = apr_pollset_create(&idle_connections, REACTOR_BATCH_SIZE,
+                                      pool,
+                                      APR_POLLSET_THREADSAFE
+                                      | APR_POLLSET_WAKEABLE);
+          if (status)
+            return svn_error_wrap_apr(status,
+                                      _("Can't create event queue"));
+
+          status = apr_thread_create(&reactor, NULL, reactor_thread,
+                                     &params, pool);
+          if (status)
+            return svn_error_wrap_apr(status, _("Can't create thread"));
+        }
     }
   else
     {
@@ -1349,9 +1899,26 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
           status = apr_proc_fork(&proc, connection->pool);
           if (status == APR_INCHILD)
             {
+              svn_membuffer_t *membuffer;
+
               /* the child would't listen to the main server's socket */
               apr_socket_close(sock);
 
+              /* A shared cache is useless if we can't lock it. */
+              membuffer = svn_cache__get_global_membuffer_cache();
+              if (membuffer)
+                {
+                  err = svn_cache__membuffer_child_init(membuffer,
+                                                        connection->pool);
+                  if (err)
+                    {
+                      logger__log_error(params.logger, err, NULL, NULL);
+                      svn_error_clear(err);
+                      close_connection(connection);
+                      return SVN_NO_ERROR;
+                    }
+                }
+
               /* serve_socket() logs any error it returns, so ignore it. */
               svn_error_clear(serve_socket(connection, connection->pool));
               close_connection(connection);
@@ -1424,6 +1991,15 @@ main(int argc, const char *argv[])
   /* Explicitly wait for all threads to exit.  As we found out with similar
      code in our C test framework, the memory pool cleanup below cannot be
      trusted to do the right thing. */
+  if (reactor)
+    {
+      apr_status_t retval;
+
+      svn_atomic_set(&reactor_stopping, TRUE);
+      apr_pollset_wakeup(idle_connections);
+      apr_thread_join(&retval, reactor);
+    }
+
   if (threads)
     apr_thread_pool_destroy(threads);
 #endif
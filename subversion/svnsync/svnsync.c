@@ -26,18 +26,23 @@
 #include "svn_delta.h"
 #include "svn_dirent_uri.h"
 #include "svn_path.h"
+#include "svn_sorts.h"
 #include "svn_props.h"
 #include "svn_auth.h"
 #include "svn_opt.h"
 #include "svn_ra.h"
+#include "svn_repos.h"
 #include "svn_utf.h"
 #include "svn_subst.h"
 #include "svn_string.h"
 #include "svn_version.h"
 
+#include "private/svn_fs_private.h"
 #include "private/svn_opt_private.h"
 #include "private/svn_ra_private.h"
 #include "private/svn_cmdline_private.h"
+#include "private/svn_delta_private.h"
+#include "private/svn_worker_pool.h"
 
 #include "sync.h"
 
@@ -71,7 +76,8 @@ enum svnsync__opt {
   svnsync_opt_trust_server_cert_failures_dst,
   svnsync_opt_allow_non_empty,
   svnsync_opt_skip_unchanged,
-  svnsync_opt_steal_lock
+  svnsync_opt_steal_lock,
+  svnsync_opt_fs_copy
 };
 
 #define SVNSYNC_OPTS_DEFAULT svnsync_opt_non_interactive, \
@@ -129,9 +135,17 @@ static const svn_opt_subcommand_desc3_t svnsync_cmd_table[] =
          "source URL.  Specifying SOURCE_URL is recommended in particular\n"
          "if untrusted users/administrators may have write access to the\n"
          "DEST_URL repository.\n"
+         "\n"), N_(
+         "If both repositories are local FSFS repositories of the same format\n"
+         "and SOURCE_URL is the root of its repository, --fs-copy copies the\n"
+         "revisions' files directly instead of replaying them.  This also\n"
+         "copies their revision properties unchanged and bypasses the hooks\n"
+         "of the destination.  It can only be used as long as all revisions\n"
+         "of the destination have been copied that way.\n"
       )},
       { SVNSYNC_OPTS_DEFAULT, svnsync_opt_source_prop_encoding, 'q',
-        svnsync_opt_disable_locking, svnsync_opt_steal_lock, 'M' } },
+        svnsync_opt_disable_locking, svnsync_opt_steal_lock,
+        svnsync_opt_fs_copy, 'M' } },
     { "copy-revprops", copy_revprops_cmd, { 0 }, {N_(
          "usage:\n"
          "\n"), N_(
@@ -191,6 +205,10 @@ static const apr_getopt_option_t svnsync_options[] =
                        N_("allow a non-empty destination repository") },
     {"skip-unchanged", svnsync_opt_skip_unchanged, 0,
                        N_("don't copy unchanged revision properties") },
+    {"fs-copy",        svnsync_opt_fs_copy, 0,
+                       N_("copy revisions between local repositories at\n"
+                          "                             "
+                          "the filesystem level") },
     {"non-interactive", svnsync_opt_non_interactive, 0,
                        N_("do no interactive prompting (default is to prompt\n"
                           "                             "
@@ -316,6 +334,7 @@ typedef struct opt_baton_t {
   svn_boolean_t quiet;
   svn_boolean_t allow_non_empty;
   svn_boolean_t skip_unchanged;
+  svn_boolean_t fs_copy;
   svn_boolean_t version;
   svn_boolean_t help;
   svn_opt_revision_t start_rev;
@@ -340,6 +359,8 @@ check_lib_versions(void)
       { "svn_subr",  svn_subr_version },
       { "svn_delta", svn_delta_version },
       { "svn_ra",    svn_ra_version },
+      { "svn_fs",    svn_fs_version },
+      { "svn_repos", svn_repos_version },
       { NULL, NULL }
     };
   SVN_VERSION_DEFINE(my_version);
@@ -425,6 +446,7 @@ typedef struct subcommand_baton_t {
 
   /* synchronize only */
   svn_revnum_t committed_rev;
+  svn_boolean_t fs_copy;
 
   /* copy-revprops only */
   svn_revnum_t start_rev;
@@ -509,6 +531,8 @@ remove_props_not_in_source(svn_ra_session_t *session,
                            apr_pool_t *pool)
 {
   apr_pool_t *subpool = svn_pool_create(pool);
+  apr_array_header_t *changes = apr_array_make(subpool, 0,
+                                               sizeof(svn_prop_t));
   apr_hash_index_t *hi;
 
   for (hi = apr_hash_first(pool, target_props);
@@ -517,18 +541,23 @@ remove_props_not_in_source(svn_ra_session_t *session,
     {
       const char *propname = apr_hash_this_key(hi);
 
-      svn_pool_clear(subpool);
-
       if (rev == 0 && !strncmp(propname, SVNSYNC_PROP_PREFIX,
                                sizeof(SVNSYNC_PROP_PREFIX) - 1))
         continue;
 
       /* Delete property if the name can't be found in SOURCE_PROPS. */
       if (! svn_hash_gets(source_props, propname))
-        SVN_ERR(svn_ra_change_rev_prop2(session, rev, propname, NULL,
-                                        NULL, subpool));
+        {
+          svn_prop_t *prop = apr_array_push(changes);
+
+          prop->name = propname;
+          prop->value = NULL;
+        }
     }
 
+  /* Send all deletions at once. */
+  SVN_ERR(svn_ra__change_rev_props(session, rev, changes, subpool));
+
   svn_pool_destroy(subpool);
 
   return SVN_NO_ERROR;
@@ -589,6 +618,8 @@ filter_props(int *filtered_count, apr_hash_t *props,
  * Note that this implies that hook scripts won't be triggered anymore for
  * those revprops that did not change.
  *
+ * All properties get written in a single request if SESSION supports it.
+ *
  * All allocations will be done in a subpool of POOL.
  */
 static svn_error_t *
@@ -600,6 +631,9 @@ write_revprops(int *filtered_count,
                apr_pool_t *pool)
 {
   apr_pool_t *subpool = svn_pool_create(pool);
+  apr_array_header_t *changes = apr_array_make(subpool,
+                                               apr_hash_count(rev_props),
+                                               sizeof(svn_prop_t));
   apr_hash_index_t *hi;
 
   *filtered_count = 0;
@@ -608,8 +642,7 @@ write_revprops(int *filtered_count,
     {
       const char *propname = apr_hash_this_key(hi);
       const svn_string_t *propval = apr_hash_this_val(hi);
-
-      svn_pool_clear(subpool);
+      svn_prop_t *prop;
 
       if (strncmp(propname, SVNSYNC_PROP_PREFIX,
                   sizeof(SVNSYNC_PROP_PREFIX) - 1) != 0)
@@ -625,8 +658,9 @@ write_revprops(int *filtered_count,
                 continue;
             }
 
-          SVN_ERR(svn_ra_change_rev_prop2(session, rev, propname, NULL,
-                                          propval, subpool));
+          prop = apr_array_push(changes);
+          prop->name = propname;
+          prop->value = propval;
         }
       else
         {
@@ -634,6 +668,8 @@ write_revprops(int *filtered_count,
         }
     }
 
+  SVN_ERR(svn_ra__change_rev_props(session, rev, changes, subpool));
+
   svn_pool_destroy(subpool);
 
   return SVN_NO_ERROR;
@@ -678,17 +714,17 @@ log_properties_normalized(int normalized_rev_props_count,
 }
 
 
-/* Copy all the revision properties, except for those that have the
- * "svn:sync-" prefix, from revision REV of the repository associated
- * with RA session FROM_SESSION, to the repository associated with RA
- * session TO_SESSION.
+/* Copy the revision properties REV_PROPS of revision REV of the source
+ * repository, except for those that have the "svn:sync-" prefix, to
+ * the repository associated with RA session TO_SESSION.
  *
- * If SYNC is TRUE, then properties on the destination revision that
- * do not exist on the source revision will be removed.
+ * If EXISTING_PROPS is not NULL, it contains the current properties of
+ * the destination revision.  Those of them that do not exist in
+ * REV_PROPS will be removed.
  *
  * If SKIP_UNCHANGED is TRUE, skip any no-op revprop changes. This also
  * prevents hook scripts from firing for those unchanged revprops.  Has
- * no effect if SYNC is FALSE.
+ * no effect if EXISTING_PROPS is NULL.
  *
  * If QUIET is FALSE, then log_properties_copied() is called to log that
  * properties were copied for revision REV.
@@ -698,6 +734,50 @@ log_properties_normalized(int normalized_rev_props_count,
  * of properties that were normalized is returned in *NORMALIZED_COUNT.
  */
 static svn_error_t *
+apply_revprops(svn_ra_session_t *to_session,
+               svn_revnum_t rev,
+               apr_hash_t *rev_props,
+               apr_hash_t *existing_props,
+               svn_boolean_t skip_unchanged,
+               svn_boolean_t quiet,
+               const char *source_prop_encoding,
+               int *normalized_count,
+               apr_pool_t *pool)
+{
+  int filtered_count = 0;
+
+  /* If necessary, normalize encoding and line ending style and return the count
+     of EOL-normalized properties in int *NORMALIZED_COUNT. */
+  SVN_ERR(svnsync_normalize_revprops(rev_props, normalized_count,
+                                     source_prop_encoding, pool));
+
+  /* Copy all but the svn:svnsync properties. */
+  SVN_ERR(write_revprops(&filtered_count, to_session, rev, rev_props,
+                         skip_unchanged ? existing_props : NULL, pool));
+
+  /* Delete those properties that were in TARGET but not in SOURCE */
+  if (existing_props)
+    SVN_ERR(remove_props_not_in_source(to_session, rev,
+                                       rev_props, existing_props, pool));
+
+  if (! quiet)
+    SVN_ERR(log_properties_copied(filtered_count > 0, rev, pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Copy all the revision properties, except for those that have the
+ * "svn:sync-" prefix, from revision REV of the repository associated
+ * with RA session FROM_SESSION, to the repository associated with RA
+ * session TO_SESSION.
+ *
+ * If SYNC is TRUE, then properties on the destination revision that
+ * do not exist on the source revision will be removed.
+ *
+ * SKIP_UNCHANGED, QUIET, SOURCE_PROP_ENCODING and NORMALIZED_COUNT are
+ * as for apply_revprops().
+ */
+static svn_error_t *
 copy_revprops(svn_ra_session_t *from_session,
               svn_ra_session_t *to_session,
               svn_revnum_t rev,
@@ -710,7 +790,6 @@ copy_revprops(svn_ra_session_t *from_session,
 {
   apr_pool_t *subpool = svn_pool_create(pool);
   apr_hash_t *existing_props, *rev_props;
-  int filtered_count = 0;
 
   /* Get the list of revision properties on REV of TARGET. We're only interested
      in the property names, but we'll get the values 'for free'. */
@@ -722,24 +801,69 @@ copy_revprops(svn_ra_session_t *from_session,
   /* Get the list of revision properties on REV of SOURCE. */
   SVN_ERR(svn_ra_rev_proplist(from_session, rev, &rev_props, subpool));
 
-  /* If necessary, normalize encoding and line ending style and return the count
-     of EOL-normalized properties in int *NORMALIZED_COUNT. */
-  SVN_ERR(svnsync_normalize_revprops(rev_props, normalized_count,
-                                     source_prop_encoding, pool));
+  SVN_ERR(apply_revprops(to_session, rev, rev_props, existing_props,
+                         skip_unchanged, quiet, source_prop_encoding,
+                         normalized_count, pool));
 
-  /* Copy all but the svn:svnsync properties. */
-  SVN_ERR(write_revprops(&filtered_count, to_session, rev, rev_props,
-                         skip_unchanged ? existing_props : NULL, pool));
+  svn_pool_destroy(subpool);
 
-  /* Delete those properties that were in TARGET but not in SOURCE */
-  if (sync)
-    SVN_ERR(remove_props_not_in_source(to_session, rev,
-                                       rev_props, existing_props, pool));
+  return SVN_NO_ERROR;
+}
 
-  if (! quiet)
-    SVN_ERR(log_properties_copied(filtered_count > 0, rev, pool));
+/* Number of revisions whose revision properties copy-revprops fetches
+   with a single request. */
+#define COPY_REVPROPS_BATCH_SIZE 1000
 
-  svn_pool_destroy(subpool);
+/* Baton for revprops_receiver(). */
+typedef struct revprops_baton_t
+{
+  /* The apr_hash_t * revision properties received so far, in order. */
+  apr_array_header_t *props;
+
+  /* Pool to allocate the properties in. */
+  apr_pool_t *pool;
+} revprops_baton_t;
+
+/* Implements svn_ra_rev_proplist_receiver_t, collecting a copy of PROPS
+   in the revprops_baton_t BATON. */
+static svn_error_t *
+revprops_receiver(svn_revnum_t revision,
+                  apr_hash_t *props,
+                  void *baton,
+                  apr_pool_t *scratch_pool)
+{
+  revprops_baton_t *b = baton;
+
+  APR_ARRAY_PUSH(b->props, apr_hash_t *) = svn_prop_hash_dup(props, b->pool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *PROPS to an array of the apr_hash_t * revision properties of the
+ * revisions START_REV to END_REV of the repository associated with RA
+ * session SESSION, in ascending order.
+ *
+ * Allocate the result in RESULT_POOL and use SCRATCH_POOL for temporary
+ * allocations.
+ */
+static svn_error_t *
+fetch_revprops(apr_array_header_t **props,
+               svn_ra_session_t *session,
+               svn_revnum_t start_rev,
+               svn_revnum_t end_rev,
+               apr_pool_t *result_pool,
+               apr_pool_t *scratch_pool)
+{
+  revprops_baton_t baton;
+
+  baton.props = apr_array_make(result_pool, (int)(end_rev - start_rev + 1),
+                               sizeof(apr_hash_t *));
+  baton.pool = result_pool;
+
+  SVN_ERR(svn_ra_rev_proplist_range(session, start_rev, end_rev,
+                                    revprops_receiver, &baton,
+                                    scratch_pool));
+  *props = baton.props;
 
   return SVN_NO_ERROR;
 }
@@ -767,6 +891,7 @@ make_subcommand_baton(opt_baton_t *opt_baton,
   b->quiet = opt_baton->quiet;
   b->skip_unchanged = opt_baton->skip_unchanged;
   b->allow_non_empty = opt_baton->allow_non_empty;
+  b->fs_copy = opt_baton->fs_copy;
   b->to_url = to_url;
   b->source_prop_encoding = opt_baton->source_prop_encoding;
   b->from_url = from_url;
@@ -1424,6 +1549,369 @@ replay_rev_finished(svn_revnum_t revision,
   return SVN_NO_ERROR;
 }
 
+/* Number of source revisions that may be spooled ahead of the one being
+   committed to the destination. */
+#define SYNC_PIPELINE_DEPTH 8
+
+/* Amount of text delta data per spooled revision to keep in memory.
+   Anything beyond that goes to a temporary file. */
+#define SYNC_SPOOL_MEMORY_SIZE (1024 * 1024)
+
+/* A source revision replayed into a local spool. */
+typedef struct spooled_rev_t
+{
+  /* Recorded replay and the revision properties that came with it. */
+  svn_delta__spool_t *spool;
+  apr_hash_t *rev_props;
+
+  /* Set when the replay of this revision has been completely spooled. */
+  svn_boolean_t done;
+
+  /* Owns everything above.  Has its own allocator, so it can be
+     destroyed by the consuming thread. */
+  apr_pool_t *pool;
+} spooled_rev_t;
+
+/* Shared state of the replaying thread and the committing thread.  All
+   members following FROM_SESSION are protected by the mutex of WORKERS. */
+typedef struct replay_pipeline_t
+{
+  /* Session to the source repository.  Used by the replaying thread
+     exclusively while the pipeline is running. */
+  svn_ra_session_t *from_session;
+
+  /* Range of revisions to replay. */
+  svn_revnum_t start_revision;
+  svn_revnum_t end_revision;
+
+  /* Ring buffer of SYNC_PIPELINE_DEPTH entries.  Revision REV uses
+     entry (REV - START_REVISION) % SYNC_PIPELINE_DEPTH. */
+  spooled_rev_t *revs;
+
+  /* Oldest revision not yet committed. */
+  svn_revnum_t committing_rev;
+
+  /* Set once the replaying thread has finished, with its error. */
+  svn_boolean_t finished;
+  svn_error_t *replay_err;
+
+  /* If set, the replaying thread shall exit ASAP. */
+  svn_boolean_t stop;
+
+  /* Runs the replay_job().  Notified whenever any of the above has been
+     changed. */
+  svn_worker_pool__t *workers;
+
+  /* Owns WORKERS. */
+  apr_pool_t *workers_pool;
+} replay_pipeline_t;
+
+/* Return the spooled_rev_t entry for REVISION in PL. */
+static spooled_rev_t *
+get_spooled_rev(replay_pipeline_t *pl,
+                svn_revnum_t revision)
+{
+  return &pl->revs[(revision - pl->start_revision) % SYNC_PIPELINE_DEPTH];
+}
+
+/* Callback function for svn_ra_replay_range, invoked in the replaying
+ * thread when starting to parse a replay report.  Wait for room in the
+ * pipeline and return an editor that spools the revision.
+ */
+static svn_error_t *
+spool_rev_started(svn_revnum_t revision,
+                  void *replay_baton,
+                  const svn_delta_editor_t **editor,
+                  void **edit_baton,
+                  apr_hash_t *rev_props,
+                  apr_pool_t *pool)
+{
+  replay_pipeline_t *pl = replay_baton;
+  spooled_rev_t *spooled;
+  svn_error_t *err = SVN_NO_ERROR;
+
+  SVN_ERR(check_cancel(NULL));
+
+  SVN_ERR(svn_worker_pool__lock(pl->workers));
+  while (!err && !pl->stop && !svn_worker_pool__stopping(pl->workers)
+         && revision >= pl->committing_rev + SYNC_PIPELINE_DEPTH)
+    err = svn_worker_pool__wait_for_change(pl->workers);
+
+  if (!err && (pl->stop || svn_worker_pool__stopping(pl->workers)))
+    err = svn_error_create(SVN_ERR_CANCELLED, NULL, NULL);
+
+  SVN_ERR(svn_worker_pool__unlock(pl->workers, err));
+
+  /* The committing thread does not look at this entry before we mark
+     it as done. */
+  spooled = get_spooled_rev(pl, revision);
+  spooled->pool = apr_allocator_owner_get(svn_pool_create_allocator(FALSE));
+  spooled->rev_props = svn_prop_hash_dup(rev_props, spooled->pool);
+
+  return svn_error_trace(svn_delta__get_spool_editor(editor, edit_baton,
+                                                     &spooled->spool,
+                                                     SYNC_SPOOL_MEMORY_SIZE,
+                                                     spooled->pool));
+}
+
+/* Callback function for svn_ra_replay_range, invoked in the replaying
+ * thread when finishing parsing a replay report.  Hand the spooled
+ * revision over to the committing thread.
+ */
+static svn_error_t *
+spool_rev_finished(svn_revnum_t revision,
+                   void *replay_baton,
+                   const svn_delta_editor_t *editor,
+                   void *edit_baton,
+                   apr_hash_t *rev_props,
+                   apr_pool_t *pool)
+{
+  replay_pipeline_t *pl = replay_baton;
+
+  SVN_ERR(svn_worker_pool__lock(pl->workers));
+  get_spooled_rev(pl, revision)->done = TRUE;
+
+  return svn_error_trace(svn_worker_pool__unlock(pl->workers,
+                           svn_worker_pool__notify(pl->workers)));
+}
+
+/* Implements svn_worker_pool__func_t.  BATON is the replay_pipeline_t. */
+static svn_error_t *
+replay_job(void *baton,
+           apr_pool_t *scratch_pool)
+{
+  replay_pipeline_t *pl = baton;
+  svn_error_t *err;
+
+  err = svn_ra_replay_range(pl->from_session, pl->start_revision,
+                            pl->end_revision, 0, TRUE,
+                            spool_rev_started, spool_rev_finished, pl,
+                            scratch_pool);
+
+  SVN_ERR(svn_worker_pool__lock(pl->workers));
+  pl->replay_err = err;
+  pl->finished = TRUE;
+
+  return svn_error_trace(svn_worker_pool__unlock(pl->workers,
+                           svn_worker_pool__notify(pl->workers)));
+}
+
+/* Tell the replaying thread of PL to stop, wait for it to exit and
+ * release all spooled revisions not committed yet.  Return ERR or, if
+ * there is none, the error of the replaying thread.
+ */
+static svn_error_t *
+stop_replay_pipeline(replay_pipeline_t *pl,
+                     svn_error_t *err)
+{
+  int i;
+
+  svn_error_clear(svn_worker_pool__lock(pl->workers));
+  pl->stop = TRUE;
+  svn_error_clear(svn_worker_pool__notify(pl->workers));
+  svn_error_clear(svn_worker_pool__unlock(pl->workers, SVN_NO_ERROR));
+
+  /* Waits for the running job to return. */
+  svn_pool_destroy(pl->workers_pool);
+
+  for (i = 0; i < SYNC_PIPELINE_DEPTH; ++i)
+    if (pl->revs[i].pool)
+      {
+        svn_pool_destroy(pl->revs[i].pool);
+        pl->revs[i].pool = NULL;
+      }
+
+  /* The replaying thread just followed our request to stop. */
+  if (err)
+    {
+      svn_error_clear(pl->replay_err);
+      return err;
+    }
+
+  return pl->replay_err;
+}
+
+/* Copy the revisions START_REVISION to END_REVISION from the source
+ * repository of RB to its destination, like svn_ra_replay_range() would
+ * do it when passed replay_rev_started() and replay_rev_finished().
+ * Replay the source revisions in a separate thread though, spooling up
+ * to SYNC_PIPELINE_DEPTH of them locally while the older ones get
+ * committed.  The commits are made strictly in revision order.  Set
+ * *REPLAYED to FALSE if no thread could be started and nothing has been
+ * done.  Use POOL for allocations.
+ */
+static svn_error_t *
+replay_range_pipelined(svn_boolean_t *replayed,
+                       replay_baton_t *rb,
+                       svn_revnum_t start_revision,
+                       svn_revnum_t end_revision,
+                       apr_pool_t *pool)
+{
+  replay_pipeline_t *pl = apr_pcalloc(pool, sizeof(*pl));
+  apr_pool_t *iterpool;
+  svn_revnum_t revision;
+  svn_error_t *err = SVN_NO_ERROR;
+
+  pl->workers_pool = svn_pool_create(pool);
+  SVN_ERR(svn_worker_pool__create(&pl->workers, 1, pl->workers_pool));
+  if (!pl->workers)
+    {
+      svn_pool_destroy(pl->workers_pool);
+      *replayed = FALSE;
+      return SVN_NO_ERROR;
+    }
+
+  *replayed = TRUE;
+  iterpool = svn_pool_create(pool);
+
+  pl->from_session = rb->from_session;
+  pl->start_revision = start_revision;
+  pl->end_revision = end_revision;
+  pl->revs = apr_pcalloc(pool, SYNC_PIPELINE_DEPTH * sizeof(*pl->revs));
+  pl->committing_rev = start_revision;
+
+  err = svn_worker_pool__post(NULL, pl->workers, replay_job, pl,
+                              pl->workers_pool);
+  if (err)
+    return svn_error_trace(stop_replay_pipeline(pl, err));
+
+  for (revision = start_revision; revision <= end_revision; ++revision)
+    {
+      spooled_rev_t *spooled = get_spooled_rev(pl, revision);
+      const svn_delta_editor_t *editor;
+      void *edit_baton;
+
+      svn_pool_clear(iterpool);
+
+      err = svn_worker_pool__lock(pl->workers);
+      while (!err && !spooled->done && !pl->finished)
+        err = svn_worker_pool__wait_for_change(pl->workers);
+      err = svn_worker_pool__unlock(pl->workers, err);
+      if (err)
+        return svn_error_trace(stop_replay_pipeline(pl, err));
+
+      /* The replay failed or ended early. */
+      if (!spooled->done)
+        break;
+
+      err = replay_rev_started(revision, rb, &editor, &edit_baton,
+                               spooled->rev_props, iterpool);
+      if (!err)
+        err = svn_delta__replay_spool(spooled->spool, editor, edit_baton,
+                                      iterpool);
+      if (!err)
+        err = replay_rev_finished(revision, rb, editor, edit_baton,
+                                  spooled->rev_props, iterpool);
+
+      svn_pool_destroy(spooled->pool);
+      spooled->pool = NULL;
+
+      svn_error_clear(svn_worker_pool__lock(pl->workers));
+      spooled->done = FALSE;
+      pl->committing_rev = revision + 1;
+      svn_error_clear(svn_worker_pool__notify(pl->workers));
+      svn_error_clear(svn_worker_pool__unlock(pl->workers, SVN_NO_ERROR));
+
+      if (err)
+        return svn_error_trace(stop_replay_pipeline(pl, err));
+    }
+
+  svn_pool_destroy(iterpool);
+
+  SVN_ERR(stop_replay_pipeline(pl, SVN_NO_ERROR));
+
+  /* A replay that ended without error must have brought all revisions. */
+  if (revision <= end_revision)
+    return svn_error_createf(APR_EINVAL, NULL,
+                             _("Replay of the source repository ended "
+                               "before r%ld"), revision);
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_fs_hotcopy_notify_t. */
+static void
+fs_copy_notify(void *baton,
+               svn_revnum_t start_revision,
+               svn_revnum_t end_revision,
+               apr_pool_t *scratch_pool)
+{
+  if (start_revision == end_revision)
+    svn_error_clear(svn_cmdline_printf(scratch_pool,
+                                       _("Copied revision %ld.\n"),
+                                       start_revision));
+  else
+    svn_error_clear(svn_cmdline_printf(scratch_pool,
+                                       _("Copied revisions %ld through "
+                                         "%ld.\n"),
+                                       start_revision, end_revision));
+}
+
+/* Open the local repository at the root of RA session SESSION
+ * in *REPOS_P.  Allocate it in POOL.
+ */
+static svn_error_t *
+open_local_repos(svn_repos_t **repos_p,
+                 svn_ra_session_t *session,
+                 apr_pool_t *pool)
+{
+  const char *url;
+  const char *path;
+
+  SVN_ERR(svn_ra_get_session_url(session, &url, pool));
+  SVN_ERR(check_if_session_is_at_repos_root(session, url, pool));
+  SVN_ERR(svn_error_quick_wrapf(svn_uri_get_dirent_from_file_url(&path, url,
+                                                                  pool),
+                                _("--fs-copy requires local repositories")));
+
+  return svn_error_trace(svn_repos_open3(repos_p, path, NULL, pool, pool));
+}
+
+/* Copy the revisions following the HEAD of the repository associated
+ * with RA session TO_SESSION up to END_REVISION at the filesystem level
+ * from the repository associated with FROM_SESSION, using information
+ * found in BATON.  Update the svnsync state on revision 0 accordingly.
+ */
+static svn_error_t *
+copy_revisions_locally(svn_ra_session_t *from_session,
+                       svn_ra_session_t *to_session,
+                       svn_revnum_t end_revision,
+                       subcommand_baton_t *baton,
+                       apr_pool_t *pool)
+{
+  svn_repos_t *from_repos;
+  svn_repos_t *to_repos;
+  svn_string_t *end_rev_str = svn_string_createf(pool, "%ld", end_revision);
+
+  SVN_ERR(open_local_repos(&from_repos, from_session, pool));
+  SVN_ERR(open_local_repos(&to_repos, to_session, pool));
+
+  /* The copy may publish revisions before it completes.  Mark the whole
+     range as being copied, so we can tell an interrupted copy from
+     commits made without using svnsync.  */
+  SVN_ERR(svn_ra_change_rev_prop2(to_session, 0,
+                                  SVNSYNC_PROP_CURRENTLY_COPYING,
+                                  NULL, end_rev_str, pool));
+
+  SVN_ERR(svn_fs__copy_revisions(svn_repos_fs(to_repos),
+                                 svn_repos_fs(from_repos), end_revision,
+                                 baton->quiet ? NULL : fs_copy_notify, NULL,
+                                 check_cancel, NULL, pool));
+
+  /* As in replay_rev_finished(), the order here is significant. */
+  SVN_ERR(svn_ra_change_rev_prop2(to_session, 0,
+                                  SVNSYNC_PROP_FS_COPIED_REV,
+                                  NULL, end_rev_str, pool));
+  SVN_ERR(svn_ra_change_rev_prop2(to_session, 0,
+                                  SVNSYNC_PROP_LAST_MERGED_REV,
+                                  NULL, end_rev_str, pool));
+  SVN_ERR(svn_ra_change_rev_prop2(to_session, 0,
+                                  SVNSYNC_PROP_CURRENTLY_COPYING,
+                                  NULL, NULL, pool));
+
+  return SVN_NO_ERROR;
+}
+
 /* Synchronize the repository associated with RA session TO_SESSION,
  * using information found in BATON.
  *
@@ -1438,10 +1926,12 @@ do_synchronize(svn_ra_session_t *to_session,
   svn_revnum_t from_latest;
   svn_ra_session_t *from_session;
   svn_string_t *currently_copying;
-  svn_revnum_t to_latest, copying, last_merged;
+  svn_string_t *fs_copied_rev;
+  svn_revnum_t to_latest, copying, last_merged, fs_copied;
   svn_revnum_t start_revision, end_revision;
   replay_baton_t *rb;
   int normalized_rev_props_count = 0;
+  svn_boolean_t replayed = FALSE;
 
   SVN_ERR(open_source_session(&from_session, &last_merged_rev,
                               baton->from_url, to_session,
@@ -1470,15 +1960,26 @@ do_synchronize(svn_ra_session_t *to_session,
   SVN_ERR(svn_ra_rev_prop(to_session, 0, SVNSYNC_PROP_CURRENTLY_COPYING,
                           &currently_copying, pool));
 
+  SVN_ERR(svn_ra_rev_prop(to_session, 0, SVNSYNC_PROP_FS_COPIED_REV,
+                          &fs_copied_rev, pool));
+
   SVN_ERR(svn_ra_get_latest_revnum(to_session, &to_latest, pool));
 
   last_merged = SVN_STR_TO_REV(last_merged_rev->data);
+  fs_copied = fs_copied_rev ? SVN_STR_TO_REV(fs_copied_rev->data) : 0;
 
   if (currently_copying)
     {
       copying = SVN_STR_TO_REV(currently_copying->data);
 
-      if ((copying < last_merged)
+      if (baton->fs_copy && (fs_copied == last_merged)
+          && (copying > last_merged)
+          && (to_latest >= last_merged) && (to_latest <= copying))
+        {
+          /* An interrupted copy at the filesystem level may have left
+             any number of revisions behind.  Simply continue it below. */
+        }
+      else if ((copying < last_merged)
           || (copying > (last_merged + 1))
           || ((to_latest != last_merged) && (to_latest != copying)))
         {
@@ -1535,6 +2036,21 @@ do_synchronize(svn_ra_session_t *to_session,
   if (from_latest <= last_merged)
     return SVN_NO_ERROR;
 
+  /* Reusing the source's revision files is only safe if all revisions
+     in the destination have been created that way. */
+  if (baton->fs_copy)
+    {
+      if (fs_copied != last_merged)
+        return svn_error_createf
+          (APR_EINVAL, NULL,
+           _("Destination revisions after r%ld have not been copied "
+             "with --fs-copy"), fs_copied);
+
+      return svn_error_trace(copy_revisions_locally(from_session, to_session,
+                                                    from_latest, baton,
+                                                    pool));
+    }
+
   /* Ok, so there are new revisions, iterate over them copying them
      into the destination repository. */
   SVN_ERR(make_replay_baton(&rb, from_session, to_session, baton, pool));
@@ -1556,9 +2072,15 @@ do_synchronize(svn_ra_session_t *to_session,
 
   SVN_ERR(check_cancel(NULL));
 
-  SVN_ERR(svn_ra_replay_range(from_session, start_revision, end_revision,
-                              0, TRUE, replay_rev_started,
-                              replay_rev_finished, rb, pool));
+  /* Fetch the next revisions while committing the current one. */
+  if (start_revision < end_revision)
+    SVN_ERR(replay_range_pipelined(&replayed, rb, start_revision,
+                                   end_revision, pool));
+
+  if (!replayed)
+    SVN_ERR(svn_ra_replay_range(from_session, start_revision, end_revision,
+                                0, TRUE, replay_rev_started,
+                                replay_rev_finished, rb, pool));
 
   SVN_ERR(log_properties_normalized(rb->normalized_rev_props_count
                                       + normalized_rev_props_count,
@@ -1636,6 +2158,7 @@ do_copy_revprops(svn_ra_session_t *to_session,
   svn_revnum_t i;
   svn_revnum_t step = 1;
   int normalized_rev_props_count = 0;
+  apr_pool_t *batch_pool, *iterpool;
 
   SVN_ERR(open_source_session(&from_session, &last_merged_rev,
                               baton->from_url, to_session,
@@ -1660,18 +2183,56 @@ do_copy_revprops(svn_ra_session_t *to_session,
        _("Cannot copy revprops for a revision (%ld) that has not "
          "been synchronized yet"), baton->end_rev);
 
-  /* Now, copy all the requested revisions, in the requested order. */
+  /* Now, copy all the requested revisions, in the requested order.
+     Fetch the source and destination properties in batches, so we don't
+     have to wait for two round trips per revision. */
   step = (baton->start_rev > baton->end_rev) ? -1 : 1;
-  for (i = baton->start_rev; i != baton->end_rev + step; i = i + step)
+  batch_pool = svn_pool_create(pool);
+  iterpool = svn_pool_create(pool);
+  for (i = baton->start_rev; i != baton->end_rev + step; )
     {
-      int normalized_count;
+      apr_array_header_t *rev_props, *existing_props;
+      svn_revnum_t low, high;
+
+      svn_pool_clear(batch_pool);
+
+      if (step > 0)
+        {
+          low = i;
+          high = MIN(i + COPY_REVPROPS_BATCH_SIZE - 1, baton->end_rev);
+        }
+      else
+        {
+          low = MAX(i - COPY_REVPROPS_BATCH_SIZE + 1, baton->end_rev);
+          high = i;
+        }
+
       SVN_ERR(check_cancel(NULL));
-      SVN_ERR(copy_revprops(from_session, to_session, i, TRUE,
-                            baton->skip_unchanged, baton->quiet,
-                            baton->source_prop_encoding, &normalized_count,
-                            pool));
-      normalized_rev_props_count += normalized_count;
+      SVN_ERR(fetch_revprops(&rev_props, from_session, low, high,
+                             batch_pool, batch_pool));
+      SVN_ERR(fetch_revprops(&existing_props, to_session, low, high,
+                             batch_pool, batch_pool));
+
+      for (; i >= low && i <= high; i = i + step)
+        {
+          int normalized_count;
+
+          svn_pool_clear(iterpool);
+
+          SVN_ERR(check_cancel(NULL));
+          SVN_ERR(apply_revprops(to_session, i,
+                                 APR_ARRAY_IDX(rev_props, i - low,
+                                               apr_hash_t *),
+                                 APR_ARRAY_IDX(existing_props, i - low,
+                                               apr_hash_t *),
+                                 baton->skip_unchanged, baton->quiet,
+                                 baton->source_prop_encoding,
+                                 &normalized_count, iterpool));
+          normalized_rev_props_count += normalized_count;
+        }
     }
+  svn_pool_destroy(iterpool);
+  svn_pool_destroy(batch_pool);
 
   /* Notify about normalized props, if any. */
   SVN_ERR(log_properties_normalized(normalized_rev_props_count, 0, pool));
@@ -2130,6 +2691,10 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
             opt_baton.skip_unchanged = TRUE;
             break;
 
+          case svnsync_opt_fs_copy:
+            opt_baton.fs_copy = TRUE;
+            break;
+
           case 'q':
             opt_baton.quiet = TRUE;
             break;
@@ -2412,10 +2977,10 @@ main(int argc, const char *argv[])
   if (svn_cmdline_init("svnsync", stderr) != EXIT_SUCCESS)
     return EXIT_FAILURE;
 
-  /* Create our top-level pool.  Use a separate mutexless allocator,
-   * given this application is single threaded.
+  /* Create our top-level pool.  Use a thread-safe allocator, since
+   * 'svnsync sync' replays source revisions in a second thread.
    */
-  pool = apr_allocator_owner_get(svn_pool_create_allocator(FALSE));
+  pool = apr_allocator_owner_get(svn_pool_create_allocator(TRUE));
 
   err = sub_main(&exit_code, argc, argv, pool);
 
@@ -1663,6 +1663,40 @@ def remove_access_after_commit(sbox):
                                         expected_status,
                                         [], True)
 
+@Skip(svntest.main.is_ra_type_file)
+def checkout_after_authz_change(sbox):
+  "checkout again after the authz rules changed"
+
+  # Over DAV, run with BUNDLE_CACHE=1 to check that the second checkout
+  # does not get served from the checkout bundle cache.
+  sbox.build(create_wc = False)
+  write_restrictive_svnserve_conf(sbox.repo_dir)
+  write_authz_file(sbox, {'/' : '* = r'})
+
+  expected_output = svntest.main.greek_state.copy()
+  expected_output.wc_dir = sbox.wc_dir
+  expected_output.tweak(status='A ', contents=None)
+  svntest.actions.run_and_verify_checkout(sbox.repo_url, sbox.wc_dir,
+                                          expected_output,
+                                          svntest.main.greek_state.copy())
+
+  # Revoke read access to A/B and check out the same tree again.
+  write_authz_file(sbox, {'/'     : '* = r',
+                          '/A/B'  : '* =', })
+
+  other_wc = sbox.add_wc_path('other')
+  expected_output = svntest.main.greek_state.copy()
+  expected_output.wc_dir = other_wc
+  expected_output.tweak(status='A ', contents=None)
+  expected_output.remove('A/B', 'A/B/E', 'A/B/E/alpha', 'A/B/E/beta',
+                         'A/B/F', 'A/B/lambda')
+  expected_wc = svntest.main.greek_state.copy()
+  expected_wc.remove('A/B', 'A/B/E', 'A/B/E/alpha', 'A/B/E/beta',
+                     'A/B/F', 'A/B/lambda')
+  svntest.actions.run_and_verify_checkout(sbox.repo_url, other_wc,
+                                          expected_output,
+                                          expected_wc)
+
 
 ########################################################################
 # Run the tests
@@ -1700,6 +1734,7 @@ test_list = [ None,
               authz_file_external_to_authz,
               authz_log_censor_revprops,
               remove_access_after_commit,
+              checkout_after_authz_change,
              ]
 serial_only = True
 
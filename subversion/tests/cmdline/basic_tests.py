@@ -25,7 +25,7 @@
 ######################################################################
 
 # General modules
-import shutil, stat, re, os, logging
+import shutil, stat, re, os, logging, socket
 
 logger = logging.getLogger()
 
@@ -3234,6 +3234,89 @@ def filtered_ls_top_level_path(sbox):
       [], [], 'ls', f_path, '--search=*/*', *extra_opts)
 
 
+def read_ra_svn_item(f):
+  """Read the next ra_svn protocol item from the binary file object F and
+     return it as a bytes object or, for a tuple, as a list of items."""
+  c = f.read(1)
+  while c.isspace():
+    c = f.read(1)
+  if not c:
+    raise svntest.Failure("Connection closed by svnserve")
+
+  if c == b'(':
+    items = []
+    item = read_ra_svn_item(f)
+    while item is not None:
+      items.append(item)
+      item = read_ra_svn_item(f)
+    return items
+  if c == b')':
+    return None
+
+  # A word, a number or the length of a string, followed by a space or ':'.
+  token = b''
+  while c.isalnum() or c == b'-':
+    token += c
+    c = f.read(1)
+  if c == b':':
+    return f.read(int(token))
+  return token
+
+def open_idle_ra_svn_connection(url):
+  """Connect to the svnserve serving URL, open an anonymous session and
+     return the socket and a binary file object reading from it."""
+  parsed = svntest.main.urlparse(url)
+  sock = socket.create_connection((parsed.hostname, parsed.port or 3690))
+  f = sock.makefile('rb')
+
+  url = url.encode()
+  greeting = read_ra_svn_item(f)
+  if greeting[0] != b'success':
+    raise svntest.Failure("Unexpected greeting %s" % greeting)
+  sock.sendall(b'( 2 ( edit-pipeline ) %d:%s ) ' % (len(url), url))
+
+  mechs = read_ra_svn_item(f)
+  if mechs[0] != b'success' or b'ANONYMOUS' not in mechs[1][0]:
+    raise svntest.Failure("No anonymous access: %s" % mechs)
+  sock.sendall(b'( ANONYMOUS ( 0: ) ) ')
+  if read_ra_svn_item(f) != [b'success', []]:
+    raise svntest.Failure("Anonymous authentication failed")
+
+  repos_info = read_ra_svn_item(f)
+  if repos_info[0] != b'success':
+    raise svntest.Failure("Unexpected repository info %s" % repos_info)
+
+  return sock, f
+
+@SkipUnless(svntest.main.is_ra_type_svn)
+def basic_idle_svn_connections(sbox):
+  "idle svn:// connections don't block others"
+
+  sbox.build(create_wc=False, read_only=True)
+
+  # More connections than a threaded svnserve has worker threads, each
+  # of them waiting for its next command.
+  connections = [open_idle_ra_svn_connection(sbox.repo_url)
+                 for i in range(300)]
+
+  # Other clients are served nevertheless ...
+  expected_output = svntest.verify.UnorderedOutput(
+    ['A/\n', 'iota\n'])
+  svntest.actions.run_and_verify_svn(expected_output, [],
+                                     'ls', sbox.repo_url)
+
+  # ... and so are the idle connections once they become active again.
+  for sock, f in reversed(connections):
+    sock.sendall(b'( get-latest-rev ( ) ) ')
+    if read_ra_svn_item(f) != [b'success', [[], b'']]:
+      raise svntest.Failure("Unexpected auth request")
+    if read_ra_svn_item(f) != [b'success', [b'1']]:
+      raise svntest.Failure("Unexpected youngest revision")
+
+  for sock, f in connections:
+    f.close()
+    sock.close()
+
 ########################################################################
 # Run the tests
 
@@ -3308,6 +3391,7 @@ test_list = [ None,
               null_update_last_changed_revision,
               null_prop_update_last_changed_revision,
               filtered_ls_top_level_path,
+              basic_idle_svn_connections,
              ]
 
 if __name__ == '__main__':
@@ -1187,6 +1187,41 @@ def checkout_wc_from_drive(sbox):
 
 #----------------------------------------------------------------------
 
+def checkout_concurrent(sbox):
+  "checkout with several checkout threads"
+
+  sbox.build(create_wc = False, read_only = True)
+  wc_dir = sbox.wc_dir
+  A_url = sbox.repo_url + '/A'
+
+  expected_disk = svntest.main.greek_state.subtree('A')
+
+  expected_output = expected_disk.copy(wc_dir)
+  expected_output.tweak(contents=None, status='A ')
+
+  svntest.actions.run_and_verify_checkout(A_url, wc_dir,
+                                          expected_output, expected_disk,
+                                          [],
+                                          '--config-option',
+                                          'config:miscellany:'
+                                          'checkout-threads=4')
+
+  # All directories must be complete and at depth infinity, such that
+  # an update has nothing to do.
+  for path in ['', 'B', 'B/E', 'C', 'D/G', 'D/H']:
+    svntest.actions.run_and_verify_svn(['infinity\n'], [],
+                                       'info', '--show-item', 'depth',
+                                       os.path.join(wc_dir, path))
+
+  expected_status = svntest.actions.get_virginal_state(wc_dir, 1)
+  expected_status = expected_status.subtree('A')
+  expected_status.wc_dir = wc_dir
+  expected_status.add({'' : Item(status='  ', wc_rev=1)})
+  svntest.actions.run_and_verify_update(wc_dir, wc.State(wc_dir, {}),
+                                        expected_disk, expected_status)
+
+#----------------------------------------------------------------------
+
 # list all tests here, starting with None:
 test_list = [ None,
               checkout_with_obstructions,
@@ -1202,7 +1237,8 @@ test_list = [ None,
               checkout_peg_rev,
               checkout_peg_rev_date,
               co_with_obstructing_local_adds,
-              checkout_wc_from_drive
+              checkout_wc_from_drive,
+              checkout_concurrent,
             ]
 
 if __name__ == "__main__":
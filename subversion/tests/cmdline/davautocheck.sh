@@ -72,6 +72,10 @@
 #
 #  make davautocheck BLOCK_READ=1           # sets SVNBlockRead on
 #
+#  make davautocheck BUNDLE_CACHE=1         # sets SVNCheckoutBundleCache
+#
+#  make davautocheck BINARY_REPORTS=1       # sets SVNBinaryReports on
+#
 #  make davautocheck USE_SSL=1              # run over https
 #
 #  make davautocheck USE_HTTPV1=1           # sets SVNAdvertiseV2Protocol off
@@ -229,6 +233,11 @@ if [ ${BLOCK_READ:+set} ]; then
   BLOCK_READ_SETTING=on
 fi
 
+BINARY_REPORTS_SETTING=off
+if [ ${BINARY_REPORTS:+set} ]; then
+  BINARY_REPORTS_SETTING=on
+fi
+
 if [ ${MODULE_PATH:+set} ]; then
     MOD_DAV_SVN="$MODULE_PATH/mod_dav_svn.so"
     MOD_AUTHZ_SVN="$MODULE_PATH/mod_authz_svn.so"
@@ -493,6 +502,14 @@ cat >> "$HTTPD_CFG" <<__EOF__
 DavLockDB "$HTTPD_DAV/lock.db"
 __EOF__
 
+BUNDLE_CACHE_LINE=""
+if [ ${BUNDLE_CACHE:+set} ]; then
+  HTTPD_BUNDLES="$HTTPD_ROOT/bundles"
+  mkdir "$HTTPD_BUNDLES" \
+      || fail "couldn't create checkout bundle directory '$HTTPD_BUNDLES'"
+  BUNDLE_CACHE_LINE="SVNCheckoutBundleCache \"$HTTPD_BUNDLES\""
+fi
+
 if [ ${USE_SSL:+set} ]; then
 cat >> "$HTTPD_CFG" <<__EOF__
 SSLEngine on
@@ -558,6 +575,8 @@ cat >> "$HTTPD_CFG" <<__EOF__
   SVNCacheRevProps  ${CACHE_REVPROPS_SETTING}
   SVNListParentPath On
   SVNBlockRead      ${BLOCK_READ_SETTING}
+  SVNBinaryReports  ${BINARY_REPORTS_SETTING}
+  ${BUNDLE_CACHE_LINE}
 __EOF__
 }
 location_common
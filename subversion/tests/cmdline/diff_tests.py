@@ -5218,6 +5218,29 @@ def diff_file_replaced_by_symlink(sbox):
   expected_output = svntest.verify.AnyOutput
   svntest.actions.run_and_verify_svn(expected_output, [], 'diff', wc_dir)
 
+def diff_local_concurrent(sbox):
+  "diff base vs working with several diff threads"
+  sbox.build()
+  wc_dir = sbox.wc_dir
+
+  # Enough files to keep several threads busy, with eol translation,
+  # property changes, additions and deletions in between.
+  for name in ['iota', 'A/mu', 'A/B/lambda', 'A/D/gamma', 'A/D/G/pi',
+               'A/D/G/rho', 'A/D/G/tau', 'A/D/H/chi', 'A/D/H/psi']:
+    sbox.simple_append(name, 'More text in %s\n' % name)
+  sbox.simple_propset('svn:eol-style', 'CRLF', 'A/D/G/rho')
+  sbox.simple_propset('prop', 'val', 'A/D/H/omega', 'A/C')
+  sbox.simple_add_text('New file\n', 'A/D/H/new')
+  sbox.simple_rm('A/B/E/alpha')
+
+  exit_code, expected_output, err = svntest.main.run_svn(None, 'diff',
+                                                         wc_dir)
+
+  svntest.actions.run_and_verify_svn(expected_output, [],
+                                     'diff', wc_dir,
+                                     '--config-option',
+                                     'config:miscellany:diff-threads=4')
+
 ########################################################################
 #Run the tests
 
@@ -5317,6 +5340,7 @@ test_list = [ None,
               diff_summary_repo_wc_local_copy,
               diff_summary_repo_wc_local_copy_unmodified,
               diff_file_replaced_by_symlink,
+              diff_local_concurrent,
               ]
 
 if __name__ == '__main__':
@@ -591,6 +591,53 @@ def import_inherited_ignores(sbox):
      'Updated to revision 6.\n'])
   svntest.actions.run_and_verify_svn(expected_output, [], 'up', wc_dir)
 
+#----------------------------------------------------------------------
+def import_concurrent(sbox):
+  "import preparing files in several threads"
+
+  sbox.build(create_wc = False)
+
+  config_contents = '''\
+[auth]
+password-stores =
+
+[miscellany]
+enable-auto-props = yes
+import-threads = 4
+
+[auto-props]
+*.txt = svn:eol-style=native
+'''
+  config_dir = sbox.create_config_dir(config_contents)
+
+  # Enough files to keep all threads busy and the queue filled.
+  import_dir = sbox.ospath('import')
+  expected = {}
+  for d in range(3):
+    dir_path = os.path.join(import_dir, 'dir%d' % d)
+    os.makedirs(dir_path)
+    for f in range(20):
+      name = 'dir%d/file%d.txt' % (d, f)
+      svntest.main.file_write(os.path.join(import_dir, name),
+                              'line %d\r\n' % f * (f + 1), 'wb')
+      expected[name] = 'line %d\n' % f * (f + 1)
+
+  svntest.actions.run_and_verify_svn(None, [], 'import',
+                                     '--config-dir', config_dir,
+                                     '-m', 'Log message for new import',
+                                     import_dir, sbox.repo_url + '/imported')
+
+  # Everything arrived in a single revision, detranslated.
+  svntest.actions.run_and_verify_svn(['2\n'], [], 'info',
+                                     '--show-item', 'last-changed-revision',
+                                     sbox.repo_url + '/imported')
+  for name, contents in expected.items():
+    exit_code, output, errput = svntest.main.run_svn(
+                                  None, 'cat',
+                                  sbox.repo_url + '/imported/' + name)
+    if ''.join(output) != contents:
+      raise svntest.Failure("Unexpected contents of '%s'" % name)
+
 #----------------------------------------------------------------------
 
 ########################################################################
@@ -606,6 +653,7 @@ test_list = [ None,
               import_eol_style,
               import_into_foreign_repo,
               import_inherited_ignores,
+              import_concurrent,
              ]
 
 if __name__ == '__main__':
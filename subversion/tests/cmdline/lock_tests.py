@@ -2480,6 +2480,83 @@ def replace_dir_with_lots_of_locked_files(sbox):
   # This problem was introduced on the 1.8.x branch in r1606976.
   sbox.simple_commit()
 
+#----------------------------------------------------------------------
+@SkipUnless(svntest.main.is_ra_type_dav)
+def dav_lock_many_failures(sbox):
+  "per-path failures in one DAV lock request"
+
+  sbox.build()
+  wc_dir = sbox.wc_dir
+
+  # Locking needs write access.
+  svntest.main.write_authz_file(sbox, { '/'      : '* = rw',
+                                        '/A/B/E' : '* = r' })
+
+  # 'iota' is locked by somebody else and 'A/mu' is out of date.
+  svntest.actions.run_and_verify_svn(None, [], 'lock',
+                                     '--username', svntest.main.wc_author2,
+                                     sbox.repo_url + '/iota')
+  svntest.actions.run_and_verify_svn(None, [], 'propset', 'p', 'v',
+                                     '-m', 'mu changed',
+                                     sbox.repo_url + '/A/mu')
+
+  # Each path fails for its own reason while the others get locked.
+  expected_stderr = svntest.verify.UnorderedRegexListOutput([
+    "svn: warning: W160035: .*'/iota'.*",
+    "svn: warning: W160042: .*'/A/mu'.*",
+    "svn: warning: W170001: .*'/A/B/E/alpha'.*",
+    "svn: E200009: One or more locks could not be obtained",
+  ])
+  expected_stdout = svntest.verify.UnorderedOutput([
+    "'rho' locked by user '%s'.\n" % svntest.main.wc_author,
+    "'pi' locked by user '%s'.\n" % svntest.main.wc_author,
+  ])
+  svntest.actions.run_and_verify_svn(expected_stdout, expected_stderr,
+                                     'lock',
+                                     sbox.ospath('iota'),
+                                     sbox.ospath('A/mu'),
+                                     sbox.ospath('A/B/E/alpha'),
+                                     sbox.ospath('A/D/G/rho'),
+                                     sbox.ospath('A/D/G/pi'))
+
+  expected_status = svntest.actions.get_virginal_state(wc_dir, 1)
+  expected_status.tweak('iota', writelocked='O')
+  expected_status.tweak('A/D/G/rho', 'A/D/G/pi', writelocked='K')
+  svntest.actions.run_and_verify_status(wc_dir, expected_status)
+
+#----------------------------------------------------------------------
+@SkipUnless(svntest.main.is_ra_type_dav)
+def dav_break_many_locks(sbox):
+  "break locks in one DAV request without tokens"
+
+  sbox.build()
+  wc_dir = sbox.wc_dir
+
+  svntest.actions.run_and_verify_svn(".* locked by user", [], 'lock',
+                                     sbox.ospath('iota'),
+                                     sbox.ospath('A/mu'))
+
+  # Somebody else breaks both locks by URL, i.e. without knowing the
+  # tokens.  The unlocked 'A/B/lambda' doesn't keep that from happening.
+  expected_stderr = svntest.verify.UnorderedRegexListOutput([
+    "svn: warning: W160040: .*'/A/B/lambda'.*",
+    "svn: E200009: One or more locks could not be released",
+  ])
+  expected_stdout = svntest.verify.UnorderedOutput([
+    "'iota' unlocked.\n",
+    "'mu' unlocked.\n",
+  ])
+  svntest.actions.run_and_verify_svn(expected_stdout, expected_stderr,
+                                     'unlock', '--force',
+                                     '--username', svntest.main.wc_author2,
+                                     sbox.repo_url + '/iota',
+                                     sbox.repo_url + '/A/mu',
+                                     sbox.repo_url + '/A/B/lambda')
+
+  expected_status = svntest.actions.get_virginal_state(wc_dir, 1)
+  expected_status.tweak('iota', 'A/mu', writelocked='B')
+  svntest.actions.run_and_verify_status(wc_dir, expected_status)
+
 ########################################################################
 # Run the tests
 
@@ -2548,6 +2625,8 @@ test_list = [ None,
               delete_dir_with_lots_of_locked_files,
               delete_locks_on_depth_commit,
               replace_dir_with_lots_of_locked_files,
+              dav_lock_many_failures,
+              dav_break_many_locks,
             ]
 
 if __name__ == '__main__':
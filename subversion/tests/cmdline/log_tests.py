@@ -2779,6 +2779,70 @@ def log_on_deleted_deep(sbox):
                                      '',
                                      '-q', '-c', '1-2')
 
+def log_xml_from(url, *args):
+  """Return exit code, stdout and stderr of 'svn log -v --xml' on URL
+  with additional ARGS."""
+
+  return svntest.main.run_svn(1, 'log', '-v', '--xml', url, *args)
+
+@SkipUnless(svntest.main.is_ra_type_dav)
+def log_xml_unsafe_revprops_dav(sbox):
+  "log --xml over DAV with non-XML-safe revprops"
+
+  # The binary log report (SVNBinaryReports) sends values unescaped.
+  # The output must be the same as when reading the repository locally.
+  sbox.build()
+  svntest.actions.enable_revprop_changes(sbox.repo_dir)
+
+  sbox.simple_append('iota', 'more\n')
+  sbox.simple_commit(message='<log> & "escaping"\n')
+
+  value_path = sbox.get_tempname()
+  svntest.main.file_write(value_path, 'a\x01b\x1f\n', 'wb')
+  svntest.actions.run_and_verify_svn(None, [], 'propset', '--revprop',
+                                     '-r', '2', 'x:unsafe', '-F', value_path,
+                                     sbox.repo_url)
+
+  exit_code, dav_out, dav_err = log_xml_from(sbox.repo_url,
+                                             '--with-all-revprops')
+  exit_code, local_out, local_err = log_xml_from(sbox.file_protocol_repo_url(),
+                                                 '--with-all-revprops')
+  if dav_err or local_err:
+    raise svntest.Failure("Unexpected error output")
+
+  if not [line for line in dav_out if 'encoding="base64"' in line]:
+    raise svntest.Failure("Non-XML-safe revprop not encoded")
+
+  svntest.verify.compare_and_display_lines("Log over DAV differs",
+                                           'STDOUT', local_out, dav_out)
+
+@SkipUnless(svntest.main.is_ra_type_dav)
+@SkipUnless(svntest.main.is_fs_type_fsfs)
+def log_xml_late_error_dav(sbox):
+  "log --xml over DAV failing after the first entry"
+
+  # Keep the server from ever seeing r1 intact, so it can't be cached.
+  sbox.build(create_wc=False)
+  svntest.actions.run_and_verify_svn(None, [], 'mkdir', '-m', 'r2',
+                                     sbox.file_protocol_repo_url() + '/X')
+
+  rev_file = os.path.join(sbox.repo_dir, 'db', 'revs', '0', '1')
+  if not os.path.exists(rev_file):
+    raise svntest.Skip('Revision file not found')
+  os.remove(rev_file)
+
+  # r2 gets reported, then the server fails on r1.
+  exit_code, dav_out, dav_err = log_xml_from(sbox.repo_url)
+  exit_code, local_out, local_err = log_xml_from(sbox.file_protocol_repo_url())
+  if not dav_err or not local_err:
+    raise svntest.Failure("Missing error for the damaged revision")
+
+  if not [line for line in dav_out if 'revision="2"' in line]:
+    raise svntest.Failure("Log entry before the error is missing")
+
+  svntest.verify.compare_and_display_lines("Log over DAV differs",
+                                           'STDOUT', local_out, dav_out)
+
 
 ########################################################################
 # Run the tests
@@ -2830,6 +2894,8 @@ test_list = [ None,
               merge_sensitive_log_xml_reverse_merges,
               log_revision_move_copy,
               log_on_deleted_deep,
+              log_xml_unsafe_revprops_dav,
+              log_xml_late_error_dav,
              ]
 
 if __name__ == '__main__':
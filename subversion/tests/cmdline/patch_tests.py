@@ -8010,6 +8010,129 @@ def patch_git_wcroot2(sbox):
 
   svntest.actions.check_prop('p', wc_dir, [value.encode()])
 
+def patch_offset_many_candidates(sbox):
+  "patch hunks far away among repeated lines"
+
+  sbox.build(read_only=True)
+  wc_dir = sbox.wc_dir
+
+  patch_file_path = os.path.abspath(sbox.get_tempname('my.patch'))
+  iota_path = sbox.ospath('iota')
+  mu_path = sbox.ospath('A/mu')
+
+  # Every "filler" line is a candidate for the first line of the first
+  # hunk, but only one of them is followed by the rest of it.
+  filler = [ "filler\n" ] * 1000
+  iota_contents = filler + [
+    "alpha\n",
+    "beta\n",
+    "gamma\n",
+    "delta\n",
+    "epsilon\n",
+  ] + filler + [
+    "kappa\n",
+    "lambda\n",
+    "mu\n",
+    "nu\n",
+    "omicron\n",
+    "pi\n",
+    "rho\n",
+  ] + filler[:3]
+
+  # Only the whitespace differs from the hunk.
+  mu_contents = filler[:500] + [
+    "some   spaced\n",
+    "  text\n",
+    "here\n",
+  ] + filler[:2]
+
+  svntest.main.file_write(iota_path, ''.join(iota_contents))
+  svntest.main.file_write(mu_path, ''.join(mu_contents))
+
+  iota_patch = [
+    "Index: iota\n",
+    "===================================================================\n",
+    "--- iota\t(revision 1)\n",
+    "+++ iota\t(working copy)\n",
+    "@@ -3,6 +3,6 @@\n",
+    " filler\n",
+    " alpha\n",
+    " beta\n",
+    "-gamma\n",
+    "+GAMMA\n",
+    " delta\n",
+    " epsilon\n",
+    # The first and the last context line need fuzz.
+    "@@ -20,7 +20,7 @@\n",
+    " KAPPA\n",
+    " lambda\n",
+    " mu\n",
+    "-nu\n",
+    "+NU\n",
+    " omicron\n",
+    " pi\n",
+    " RHO\n",
+  ]
+  svntest.main.file_write(patch_file_path, ''.join(iota_patch))
+
+  iota_contents[1002] = "GAMMA\n"
+  iota_contents[2008] = "NU\n"
+
+  expected_output = [
+    'U         %s\n' % iota_path,
+    '>         applied hunk @@ -3,6 +3,6 @@ with offset 997\n',
+    '>         applied hunk @@ -20,7 +20,7 @@ with offset 1986 and fuzz 1\n',
+  ]
+
+  expected_disk = svntest.main.greek_state.copy()
+  expected_disk.tweak('iota', contents=''.join(iota_contents))
+  expected_disk.tweak('A/mu', contents=''.join(mu_contents))
+
+  expected_status = svntest.actions.get_virginal_state(wc_dir, 1)
+  expected_status.tweak('iota', 'A/mu', status='M ')
+
+  expected_skip = wc.State(wc_dir, { })
+
+  svntest.actions.run_and_verify_patch(wc_dir, patch_file_path,
+                                       expected_output,
+                                       expected_disk,
+                                       expected_status,
+                                       expected_skip,
+                                       None, # expected err
+                                       1, # check-props
+                                       1) # dry-run
+
+  mu_patch = [
+    "Index: A/mu\n",
+    "===================================================================\n",
+    "--- A/mu\t(revision 1)\n",
+    "+++ A/mu\t(working copy)\n",
+    "@@ -1,3 +1,3 @@\n",
+    " some spaced\n",
+    " text\n",
+    "-here\n",
+    "+there\n",
+  ]
+  svntest.main.file_write(patch_file_path, ''.join(mu_patch))
+
+  mu_contents[502] = "there\n"
+
+  expected_output = [
+    'U         %s\n' % mu_path,
+    '>         applied hunk @@ -1,3 +1,3 @@ with offset 500\n',
+  ]
+  expected_disk.tweak('A/mu', contents=''.join(mu_contents))
+
+  svntest.actions.run_and_verify_patch(wc_dir, patch_file_path,
+                                       expected_output,
+                                       expected_disk,
+                                       expected_status,
+                                       expected_skip,
+                                       None, # expected err
+                                       1, # check-props
+                                       1, # dry-run
+                                       "--ignore-whitespace")
+
 ########################################################################
 #Run the tests
 
@@ -8097,6 +8220,7 @@ test_list = [ None,
               patch_empty_prop,
               patch_git_wcroot,
               patch_git_wcroot2,
+              patch_offset_many_candidates,
             ]
 
 if __name__ == '__main__':
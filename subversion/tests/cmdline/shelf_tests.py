@@ -25,7 +25,7 @@
 ######################################################################
 
 # General modules
-import shutil, stat, re, os, logging
+import shutil, stat, re, os, logging, hashlib
 
 logger = logging.getLogger()
 
@@ -949,6 +949,81 @@ def shelf_diff_simple(sbox):
   run_and_verify_shelf_diff_summarize(expected_diff, 'foo')
 
 
+#----------------------------------------------------------------------
+
+def shelf_storage_deltas(sbox):
+  "shelf versions share base texts and store deltas"
+
+  sbox.build()
+  was_cwd = os.getcwd()
+  os.chdir(sbox.wc_dir)
+  sbox.wc_dir = ''
+
+  shelves_dir = os.path.join(svntest.main.get_admin_name(), 'shelves')
+  pristine_dir = os.path.join(shelves_dir, '666f6f.pristine')  # "foo"
+  mu_base = svntest.main.greek_state.desc['A/mu'].contents
+  iota_base = svntest.main.greek_state.desc['iota'].contents
+
+  def sha1(text):
+    return hashlib.sha1(text.encode()).hexdigest()
+
+  def expect_stored(version, relpath, base_text):
+    files_dir = os.path.join(shelves_dir, '666f6f-%03d.d' % version)
+    stored = os.path.join(files_dir, relpath)
+    for old_suffix in ['.base', '.work']:
+      if os.path.exists(stored + old_suffix):
+        raise svntest.Failure("full text '%s' stored" % (relpath + old_suffix))
+    if not os.path.isfile(stored + '.delta'):
+      raise svntest.Failure("no delta stored for '%s'" % relpath)
+    if open(stored + '.base-ref').read() != sha1(base_text):
+      raise svntest.Failure("wrong base text reference for '%s'" % relpath)
+
+  sbox.simple_append('A/mu', 'appended mu text\n')
+  sbox.simple_append('iota', 'appended iota text\n')
+  svntest.actions.run_and_verify_svn(None, [], 'shelf-save', 'foo')
+  sbox.simple_append('A/mu', 'more mu text\n')
+  svntest.actions.run_and_verify_svn(None, [], 'shelf-save', 'foo')
+
+  # Both versions refer to the same two base texts.
+  for version in [1, 2]:
+    expect_stored(version, 'A/mu', mu_base)
+    expect_stored(version, 'iota', iota_base)
+  if sorted(os.listdir(pristine_dir)) != sorted([sha1(mu_base),
+                                                  sha1(iota_base)]):
+    raise svntest.Failure("unexpected pristine store contents")
+  if open(os.path.join(pristine_dir, sha1(mu_base))).read() != mu_base:
+    raise svntest.Failure("wrong base text stored for 'A/mu'")
+
+  # The working texts get reconstructed from the deltas.
+  svntest.actions.run_and_verify_svn(None, [], 'revert', '-R', '.')
+  svntest.actions.run_and_verify_svn(None, [], 'unshelve', 'foo', '1')
+  if open(sbox.ospath('A/mu')).read() != mu_base + 'appended mu text\n':
+    raise svntest.Failure("wrong working text of 'A/mu' in version 1")
+
+  svntest.actions.run_and_verify_svn(None, [], 'revert', '-R', '.')
+  svntest.actions.run_and_verify_svn(None, [], 'unshelve', 'foo', '2')
+  if (open(sbox.ospath('A/mu')).read()
+      != mu_base + 'appended mu text\nmore mu text\n'):
+    raise svntest.Failure("wrong working text of 'A/mu' in version 2")
+
+  # Versions stored as full texts by older clients are still readable.
+  stored = os.path.join(shelves_dir, '666f6f-002.d', 'A', 'mu')
+  os.remove(stored + '.base-ref')
+  os.remove(stored + '.delta')
+  svntest.main.file_write(stored + '.base', mu_base)
+  svntest.main.file_write(stored + '.work', mu_base + 'old format text\n')
+  svntest.actions.run_and_verify_svn(None, [], 'revert', '-R', '.')
+  svntest.actions.run_and_verify_svn(None, [], 'unshelve', 'foo', '2')
+  if open(sbox.ospath('A/mu')).read() != mu_base + 'old format text\n':
+    raise svntest.Failure("wrong working text of 'A/mu' in old format")
+
+  # Dropping the shelf removes its pristine store.
+  svntest.actions.run_and_verify_svn(None, [], 'shelf-drop', 'foo')
+  if os.path.exists(pristine_dir):
+    raise svntest.Failure("pristine store not removed")
+
+  os.chdir(was_cwd)
+
 ########################################################################
 # Run the tests
 
@@ -985,6 +1060,7 @@ test_list = [ None,
               unshelve_text_prop_merge,
               unshelve_text_prop_conflict,
               shelf_diff_simple,
+              shelf_storage_deltas,
              ]
 
 if __name__ == '__main__':
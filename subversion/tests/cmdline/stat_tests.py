@@ -2301,6 +2301,73 @@ def status_missing_conflicts(sbox):
   # But not in status!
   svntest.actions.run_and_verify_status(wc_dir, expected_status)
 
+@SkipUnless(svntest.main.is_posix_os)
+def status_fsmonitor_hook(sbox):
+  "status with an fsmonitor hook"
+
+  sbox.build(read_only = True)
+  wc_dir = sbox.wc_dir
+
+  # The hook prints whatever the test put into REPORT and fails on demand.
+  report = sbox.get_tempname('fsmonitor-report')
+  hook = sbox.get_tempname('fsmonitor-hook')
+  svntest.main.create_python_hook_script(hook,
+    'import sys\n'
+    'report = open(%r).read()\n'
+    'if report.startswith("FAIL"):\n'
+    '  sys.exit(1)\n'
+    'sys.stdout.write(report)\n' % report)
+
+  def status(report_contents, expected):
+    svntest.main.file_write(report, report_contents)
+    svntest.actions.run_and_verify_svn(
+      UnorderedOutput(expected), [],
+      'status', wc_dir,
+      '--config-option',
+      'config:working-copy:fsmonitor-hook=%s' % hook)
+
+  mu = sbox.ospath('A/mu')
+  lambda_path = sbox.ospath('A/B/lambda')
+  new_path = sbox.ospath('A/D/G/new')
+
+  # Without a previous token, everything gets checked.
+  sbox.simple_append('A/mu', 'appended mu text\n')
+  status('t1\n', ['M       %s\n' % mu])
+  token_file = os.path.join(wc_dir, svntest.main.get_admin_name(),
+                            'fsmonitor')
+  if open(token_file).readline() != 't1\n':
+    raise svntest.Failure("fsmonitor token not saved")
+
+  # Only reported directories are checked for text changes.  A/mu is
+  # not reported again but has been modified before.  Unversioned
+  # items are always found.
+  sbox.simple_append('A/B/lambda', 'appended lambda text\n')
+  svntest.main.file_write(new_path, 'new\n')
+  status('t2\n', ['M       %s\n' % mu,
+                  '?       %s\n' % new_path])
+
+  status('t3\nA/B/lambda\n', ['M       %s\n' % mu,
+                               'M       %s\n' % lambda_path,
+                               '?       %s\n' % new_path])
+
+  # A reverted file is reported by the monitor and is clean again.
+  svntest.main.run_svn(None, 'revert', mu)
+  status('t4\nA/mu\n', ['M       %s\n' % lambda_path,
+                         '?       %s\n' % new_path])
+
+  # "/" and failing hooks require a full scan.
+  sbox.simple_append('A/D/gamma', 'appended gamma text\n')
+  gamma = sbox.ospath('A/D/gamma')
+  status('t5\n/\n', ['M       %s\n' % lambda_path,
+                      'M       %s\n' % gamma,
+                      '?       %s\n' % new_path])
+
+  svntest.main.file_write(sbox.ospath('A/C/new2'), 'new2\n')
+  status('FAIL', ['M       %s\n' % lambda_path,
+                  'M       %s\n' % gamma,
+                  '?       %s\n' % new_path,
+                  '?       %s\n' % sbox.ospath('A/C/new2')])
+
 
 
 
@@ -2355,6 +2422,7 @@ test_list = [ None,
               status_move_missing_direct,
               status_move_missing_direct_base,
               status_missing_conflicts,
+              status_fsmonitor_hook,
              ]
 
 if __name__ == '__main__':
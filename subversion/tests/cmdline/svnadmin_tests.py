@@ -3826,6 +3826,43 @@ def load_issue4725(sbox):
   sbox2.build(create_wc=False, empty=True)
   load_and_verify_dumpstream(sbox2, None, [], None, False, dump, '-M100')
 
+@SkipUnless(svntest.main.is_fs_type_fsfs)
+def verify_skip_verified(sbox):
+  "verify --skip-verified after verify-after-commit"
+
+  sbox.build(create_wc=False, empty=True)
+
+  # Verify the contents of every new revision in the background.  The
+  # committing process finishes the verification before it exits.
+  with open(os.path.join(sbox.repo_dir, 'db', 'fsfs.conf'), 'a') as conf:
+    conf.write('\n[debug]\nverify-after-commit = true\n')
+
+  svntest.actions.run_and_verify_svn(None, [], 'mkdir', '-m', 'r1',
+                                     sbox.repo_url + '/A')
+  svntest.actions.run_and_verify_svn(None, [], 'mkdir', '-m', 'r2',
+                                     sbox.repo_url + '/B')
+
+  with open(os.path.join(sbox.repo_dir, 'db', 'verify-log')) as log:
+    if sorted(log.readlines()) != ['1 ok\n', '2 ok\n']:
+      raise svntest.Failure
+
+  # Only r0 remains to be verified.
+  exit_code, output, errput = svntest.actions.run_and_verify_svnadmin(
+                                 None, [], 'verify', '--skip-verified',
+                                 sbox.repo_dir)
+  expected = ["* Verified revision 0.\n",
+              "* Revision 1 has been verified after commit.\n",
+              "* Revision 2 has been verified after commit.\n"]
+  if [line for line in output if 'Verifying metadata' not in line] \
+     != expected:
+    raise svntest.Failure
+
+  # The background verification doesn't look for normalization issues.
+  svntest.actions.run_and_verify_svnadmin(None, ".*mutually exclusive.*",
+                                          'verify', '--skip-verified',
+                                          '--check-normalization',
+                                          sbox.repo_dir)
+
 ########################################################################
 # Run the tests
 
@@ -3900,6 +3937,7 @@ test_list = [ None,
               dump_exclude_all_rev_changes,
               dump_invalid_filtering_option,
               load_issue4725,
+              verify_skip_verified,
              ]
 
 if __name__ == '__main__':
@@ -761,6 +761,40 @@ def drop_all_empty_revisions(sbox):
       "Actual svndumpfilter stderr does not agree with expected stderr",
       None, filtered_err, None, expected_err)
 
+def filter_with_index(sbox):
+  "filter a dump file using an index"
+
+  dumpfile_location = os.path.join(os.path.dirname(sys.argv[0]),
+                                   'svndumpfilter_tests_data',
+                                   'with_merges.dump')
+  dump_contents = svntest.actions.load_dumpfile(dumpfile_location)
+  args = ["exclude", "branch1", "--drop-empty-revs", "--renumber-revs"]
+
+  expected_out, expected_err = filter_and_return_output(dump_contents,
+                                                        8192, *args)
+
+  sbox.build(empty=True)
+  index_file = sbox.get_tempname()
+
+  # The first run writes the index, the second one uses it.
+  for i in range(2):
+    dump_in = open(dumpfile_location, 'rb')
+    infile, outfile, errfile, kid = svntest.main.open_pipe(
+      [svntest.main.svndumpfilter_binary] + args + ["--index", index_file],
+      stdin=dump_in)
+    output, errput, exit_code = svntest.main.wait_on_pipe(kid, True)
+    dump_in.close()
+
+    if exit_code:
+      raise svntest.Failure("svndumpfilter failed: %s" % ''.join(errput))
+    if not os.path.exists(index_file):
+      raise svntest.Failure("svndumpfilter did not write an index")
+    if output != expected_out:
+      raise svntest.Failure("Filtering with an index changed the output")
+    svntest.verify.verify_outputs(
+      "Actual svndumpfilter stderr does not agree with expected stderr",
+      None, errput, None, expected_err)
+
 
 ########################################################################
 # Run the tests
@@ -778,6 +812,7 @@ test_list = [ None,
               accepts_deltas,
               dumpfilter_targets_expect_leading_slash_prefixes,
               drop_all_empty_revisions,
+              filter_with_index,
               ]
 
 if __name__ == '__main__':
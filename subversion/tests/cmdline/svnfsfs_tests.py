@@ -311,6 +311,76 @@ def load_index_sharded(sbox):
   svntest.actions.run_and_verify_svnadmin(expected_output, [],
                                           "verify", sbox.repo_dir)
 
+@SkipUnless(svntest.main.is_fs_type_fsfs)
+@SkipUnless(svntest.main.fs_has_pack)
+@SkipUnless(svntest.main.is_fs_log_addressing)
+def repack_sharded(sbox):
+  "repack packed shards"
+
+  # Configure two files per shard to trigger packing.
+  sbox.build(create_wc=False)
+  patch_format(sbox.repo_dir, shard_size=2)
+
+  expected_output = ["Packing revisions in shard 0...done.\n"]
+  svntest.actions.run_and_verify_svnadmin(expected_output, [],
+                                          "pack", sbox.repo_dir)
+
+  # Repack all shards and then just the one containing r1.
+  svntest.actions.run_and_verify_svnfsfs(["Repacking shard 0...done.\n"],
+                                         [], "repack", sbox.repo_dir)
+  svntest.actions.run_and_verify_svnfsfs([], [], "repack", "-q", "-r1",
+                                         sbox.repo_dir)
+
+  # The unpacked revision cannot be repacked.
+  svntest.actions.run_and_verify_svnfsfs(None, ".*not been packed.*",
+                                         "repack", "-r2", sbox.repo_dir)
+
+  # Run verify to see whether we broke anything.
+  expected_output = ["* Verifying metadata at revision 0 ...\n",
+                     "* Verifying repository metadata ...\n",
+                     "* Verified revision 0.\n",
+                     "* Verified revision 1.\n"]
+  svntest.actions.run_and_verify_svnadmin(expected_output, [],
+                                          "verify", sbox.repo_dir)
+
+@SkipUnless(svntest.main.is_fs_type_fsfs)
+@SkipUnless(svntest.main.fs_has_pack)
+def reshard(sbox):
+  "change the shard size"
+
+  # Packed shards cannot be resharded
+  if svntest.main.options.fsfs_packing:
+    raise svntest.Skip('fsfs packing set')
+
+  sbox.build(create_wc=False)
+  for i in range(3):
+    svntest.main.run_svnmucc('-m', 'log msg', 'mkdir',
+                             sbox.repo_url + '/dir%d' % i)
+
+  svntest.actions.run_and_verify_svnfsfs(["Shard size: 2\n"], [],
+                                         "reshard", sbox.repo_dir, "2")
+  svntest.actions.run_and_verify_svnfsfs([], [], "reshard", "-q",
+                                         "--jobs", "2", sbox.repo_dir, "3")
+
+  format = open(os.path.join(sbox.repo_dir, "db", "format")).read()
+  if "layout sharded 3\n" not in format:
+    raise svntest.Failure("Unexpected format file:\n" + format)
+  for subdir in ["revs", "revprops"]:
+    if not os.path.isfile(os.path.join(sbox.repo_dir, "db", subdir,
+                                       "1", "4")):
+      raise svntest.Failure("r4 missing from db/%s/1" % subdir)
+    if os.path.exists(os.path.join(sbox.repo_dir, "db", subdir + ".old")):
+      raise svntest.Failure("db/%s.old has not been removed" % subdir)
+
+  # The repository must still be readable and writable.
+  svntest.main.run_svnmucc('-m', 'log msg', 'mkdir', sbox.repo_url + '/dir3')
+  svntest.actions.run_and_verify_svnadmin(None, [], "verify", sbox.repo_dir)
+
+  # Packed shards cannot be resharded.
+  svntest.actions.run_and_verify_svnadmin(None, [], "pack", sbox.repo_dir)
+  svntest.actions.run_and_verify_svnfsfs(None, ".*packed shards.*",
+                                         "reshard", sbox.repo_dir, "4")
+
 @SkipUnless(svntest.main.is_fs_type_fsfs)
 def test_stats_on_empty_repo(sbox):
   "stats on empty repo shall not crash"
@@ -328,6 +398,8 @@ def test_stats_on_empty_repo(sbox):
 test_list = [ None,
               test_stats,
               load_index_sharded,
+              repack_sharded,
+              reshard,
               test_stats_on_empty_repo,
              ]
 
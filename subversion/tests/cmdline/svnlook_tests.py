@@ -25,7 +25,7 @@
 ######################################################################
 
 # General modules
-import re, os, logging
+import re, os, logging, hashlib
 
 logger = logging.getLogger()
 
@@ -718,6 +718,69 @@ def property_delete(sbox):
   svntest.actions.run_and_verify_svnlook(["_U  A/mu\n"], [],
                                          'changed', repo_dir)
 
+def changed_details_and_batch(sbox):
+  "svnlook changed-details and batch"
+
+  sbox.build()
+  repo_dir = sbox.repo_dir
+
+  sbox.simple_propset('foo', 'bar', 'A/mu')
+  sbox.simple_copy('iota', 'iota2')
+  sbox.simple_rm('A/B/lambda')
+  sbox.simple_commit()
+
+  def text_headers(text):
+    text = text.encode()
+    return ["Text-content-length: %d\n" % len(text),
+            "Text-content-md5: %s\n" % hashlib.md5(text).hexdigest(),
+            "Text-content-sha1: %s\n" % hashlib.sha1(text).hexdigest()]
+
+  expected_output = (["D   A/B/lambda\n",
+                      "\n",
+                      "_U  A/mu\n",
+                      "Node-kind: file\n"]
+                     + text_headers("This is the file 'mu'.\n")
+                     + ["K 3\n", "foo\n", "V 3\n", "bar\n",
+                        "PROPS-END\n",
+                        "\n",
+                        "A   iota2\n",
+                        "Node-kind: file\n",
+                        "Node-copyfrom-path: iota\n",
+                        "Node-copyfrom-rev: 1\n"]
+                     + text_headers("This is the file 'iota'.\n")
+                     + ["PROPS-END\n",
+                        "\n"])
+  svntest.actions.run_and_verify_svnlook(expected_output, [],
+                                         'changed-details', repo_dir)
+
+  queries = ["cat iota\n",
+             "kind A\n",
+             "kind A/nonexistent\n",
+             "propget foo A/mu\n",
+             "propget nonexistent A/mu\n",
+             "revprop svn:author\n",
+             "quit\n",
+             "kind iota\n"]
+  exit_code, output, errput = svntest.main.run_command_stdin(
+    svntest.main.svnlook_binary, False, -1, False, queries, 'batch', repo_dir)
+
+  expected_output = ["ok 25\n", "This is the file 'iota'.\n", "\n",
+                     "ok 3\n", "dir\n",
+                     "ok 4\n", "none\n",
+                     "ok 3\n", "bar\n"]
+  if output[:len(expected_output)] != expected_output:
+    raise svntest.Failure("Unexpected 'svnlook batch' output: %s" % output)
+
+  # The error message, followed by the remaining answers.  Nothing gets
+  # answered after 'quit'.
+  rest = output[len(expected_output):]
+  if (len(rest) != 4
+      or not re.match(r'^error \d+$', rest[0].rstrip())
+      or not re.match(r"^svnlook: E200017: .*'nonexistent'", rest[1])
+      or int(rest[0].split()[1]) != len(rest[1]) - 1
+      or rest[2:] != ["ok 7\n", "jrandom\n"]):
+    raise svntest.Failure("Unexpected 'svnlook batch' output: %s" % output)
+
 
 ########################################################################
 # Run the tests
@@ -738,6 +801,7 @@ test_list = [ None,
               test_filesize,
               test_txn_flag,
               property_delete,
+              changed_details_and_batch,
              ]
 
 if __name__ == '__main__':
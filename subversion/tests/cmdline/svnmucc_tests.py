@@ -588,6 +588,48 @@ def svnmucc_propset_and_put(sbox):
                 'put', sbox.ospath('file'), 't1',
                 'put', sbox.ospath('file'), 't1')
 
+def svnmucc_manifest(sbox):
+  "actions read from a manifest"
+
+  sbox.build(create_wc=False)
+
+  file = sbox.ospath('file')
+  svntest.main.file_append(file, 'file contents')
+
+  # Enough puts into one existing directory to have its entries listed
+  # instead of checked one by one.
+  lines = ['mkdir', 'newdir',
+           'put', file, 'newdir/f',
+           'put', file, 'iota',
+           'propset', 'p', 'v', 'A/mu',
+           'cp', '1', 'A/D', 'A/D2']
+  expected = ['A /newdir', 'A /newdir/f', 'M /iota', 'M /A/mu',
+              'A /A/D2 (from /A/D:1)']
+  for i in range(20):
+    lines += ['', 'put', file, 'A/B/f%d' % i]
+    expected.append('A /A/B/f%d' % i)
+
+  manifest = sbox.get_tempname('manifest')
+  svntest.main.file_write(manifest, '\n'.join(lines) + '\n')
+
+  test_svnmucc(sbox.repo_url, expected,
+               '-m', 'log msg', '--manifest', manifest)
+
+  # Existing nodes are still detected after listing their directory.
+  manifest_lines = []
+  for i in range(10):
+    manifest_lines += ['mkdir', 'A/B/f%d' % i]
+  svntest.main.file_write(manifest, '\n'.join(manifest_lines) + '\n')
+  xtest_svnmucc(sbox.repo_url,
+                ["svnmucc: E160020: Path 'A/B/f0' already exists"],
+                '-m', 'log msg', '--manifest', manifest)
+
+  # Incomplete actions are rejected.
+  svntest.main.file_write(manifest, 'mkdir\n')
+  xtest_svnmucc(sbox.repo_url,
+                ["svnmucc: E200004: insufficient arguments"],
+                '-m', 'log msg', '--manifest', manifest)
+
 
 ######################################################################
 
@@ -601,6 +643,7 @@ test_list = [ None,
               prohibited_deletes_and_moves,
               svnmucc_type_errors,
               svnmucc_propset_and_put,
+              svnmucc_manifest,
             ]
 
 if __name__ == '__main__':
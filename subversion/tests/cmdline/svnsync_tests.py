@@ -587,6 +587,52 @@ def up_to_date_sync(sbox):
   svntest.actions.run_and_verify_svnsync([], [],
                                          "synchronize", dest_sbox.repo_url)
 
+@SkipUnless(svntest.main.is_fs_type_fsfs)
+def fs_copy_sync(sbox):
+  "sync local repositories with --fs-copy"
+
+  sbox.build()
+  dest_sbox = sbox.clone_dependent()
+  dest_sbox.build(create_wc=False, empty=True)
+
+  exit_code, output, errput = svntest.main.run_svnlook("uuid", sbox.repo_dir)
+  src_uuid = output[0].strip()
+  svntest.actions.run_and_verify_svnadmin2(None, None, 0,
+                                           'setuuid', dest_sbox.repo_dir,
+                                           src_uuid)
+  svntest.actions.enable_revprop_changes(dest_sbox.repo_dir)
+
+  src_url = sbox.file_protocol_repo_url()
+  dest_url = dest_sbox.file_protocol_repo_url()
+  run_init(dest_url, src_url)
+  svntest.actions.run_and_verify_svnsync(['Copied revision 1.\n'], [],
+                                         "synchronize", "--fs-copy",
+                                         dest_url, src_url)
+
+  # Later runs continue where the last one stopped.
+  sbox.simple_append('A/mu', 'appended mu text\n')
+  sbox.simple_commit()
+  sbox.simple_mkdir('A/new_dir')
+  sbox.simple_commit()
+  svntest.actions.run_and_verify_svnsync(['Copied revisions 2 through 3.\n'],
+                                         [],
+                                         "synchronize", "--fs-copy",
+                                         dest_url, src_url)
+
+  run_info(dest_url, ['Source URL: %s\n' % src_url,
+                      'Source Repository UUID: %s\n' % src_uuid,
+                      'Last Merged Revision: 3\n'])
+
+  # The mirror has the same revisions, including their revprops.
+  exit_code, src_dump, errput = svntest.actions.run_and_verify_svnadmin(
+    AnyOutput, [], 'dump', '--quiet', '-r1:HEAD', sbox.repo_dir)
+  exit_code, dest_dump, errput = svntest.actions.run_and_verify_svnadmin(
+    AnyOutput, [], 'dump', '--quiet', '-r1:HEAD', dest_sbox.repo_dir)
+  svntest.verify.compare_dump_files(
+    "Dump files", "DUMP", src_dump, dest_dump)
+  svntest.actions.run_and_verify_svnadmin(None, [], 'verify', '--quiet',
+                                          dest_sbox.repo_dir)
+
 
 ########################################################################
 # Run the tests
@@ -625,6 +671,7 @@ test_list = [ None,
               fd_leak_sync_from_serf_to_local, # calls setrlimit
               mergeinfo_contains_r0,
               up_to_date_sync,
+              fs_copy_sync,
              ]
 
 if __name__ == '__main__':
@@ -1408,6 +1408,56 @@ test_copy_pin_externals_select_subtree(const svn_test_opts_t *opts, apr_pool_t *
   return SVN_NO_ERROR;
 }
 
+static svn_error_t *
+test_ra_session_pool(const svn_test_opts_t *opts,
+                     apr_pool_t *pool)
+{
+  const char *repos_url;
+  const char *session_url;
+  svn_client_ctx_t *ctx;
+  svn_ra_session_t *session1, *session2, *session3;
+  apr_pool_t *pool1 = svn_pool_create(pool);
+  apr_pool_t *pool2 = svn_pool_create(pool);
+  int i;
+
+  SVN_ERR(create_greek_repos(&repos_url, "ra-session-pool", opts, pool));
+  SVN_ERR(svn_client_create_context(&ctx, pool));
+
+  /* Two sessions held at the same time must be distinct. */
+  SVN_ERR(svn_client__ra_session_acquire(&session1, repos_url, ctx,
+                                         pool1, pool));
+  SVN_ERR(svn_client__ra_session_acquire(&session2,
+                                         svn_path_url_add_component2(
+                                           repos_url, "A", pool),
+                                         ctx, pool2, pool));
+  SVN_TEST_ASSERT(session1 != session2);
+
+  /* Released sessions get handed out again, reparented as requested. */
+  svn_pool_clear(pool1);
+  SVN_ERR(svn_client__ra_session_acquire(&session3,
+                                         svn_path_url_add_component2(
+                                           repos_url, "A/B", pool),
+                                         ctx, pool1, pool));
+  SVN_TEST_ASSERT(session3 == session1);
+  SVN_ERR(svn_ra_get_session_url(session3, &session_url, pool));
+  SVN_TEST_STRING_ASSERT(session_url,
+                         svn_path_url_add_component2(repos_url, "A/B",
+                                                     pool));
+
+  svn_pool_clear(pool1);
+  svn_pool_clear(pool2);
+
+  /* The number of idle sessions is bounded. */
+  for (i = 0; i < 2 * SVN_CLIENT__MAX_IDLE_RA_SESSIONS; ++i)
+    SVN_ERR(svn_client__ra_session_acquire(&session1, repos_url, ctx,
+                                           pool1, pool));
+  svn_pool_clear(pool1);
+  SVN_TEST_ASSERT(svn_client__get_private_ctx(ctx)->idle_ra_sessions->nelts
+                  == SVN_CLIENT__MAX_IDLE_RA_SESSIONS);
+
+  return SVN_NO_ERROR;
+}
+
 /* ========================================================================== */
 
 
@@ -1436,6 +1486,8 @@ static struct svn_test_descriptor_t test_funcs[] =
                        "test svn_client_copy7 with externals_to_pin"),
     SVN_TEST_OPTS_PASS(test_copy_pin_externals_select_subtree,
                        "pin externals on selected subtrees only"),
+    SVN_TEST_OPTS_PASS(test_ra_session_pool,
+                       "test reuse of pooled RA sessions"),
     SVN_TEST_NULL
   };
 
@@ -37,6 +37,7 @@
 #include "svn_pools.h"
 #include "svn_error.h"
 
+#include "private/svn_delta_private.h"
 #include "../../libsvn_delta/delta.h"
 #include "delta-window-test.h"
 
@@ -48,6 +49,10 @@
 #define SEEDS 50
 #define MAXSEQ 100
 
+#ifndef MIN
+#define MIN(a, b) ((a) < (b) ? (a) : (b))
+#endif
+
 
 /* Initialize parameters for the random tests. */
 extern int test_argc;
@@ -330,7 +335,7 @@ do_random_test(apr_pool_t *pool,
 
       /* Make stage 2: encode the text delta in svndiff format using
                        varying svndiff versions and compression levels. */
-      svn_txdelta_to_svndiff3(&handler, &handler_baton, stream, i % 3,
+      svn_txdelta_to_svndiff3(&handler, &handler_baton, stream, i % 4,
                               i % 10, delta_pool);
 
       /* Make stage 1: create the text delta.  */
@@ -426,7 +431,7 @@ do_random_combine_test(apr_pool_t *pool,
 
       /* Make stage 2: encode the text delta in svndiff format using
                        varying svndiff versions and compression levels. */
-      svn_txdelta_to_svndiff3(&handler, &handler_baton, stream, i % 3,
+      svn_txdelta_to_svndiff3(&handler, &handler_baton, stream, i % 4,
                               i % 10, delta_pool);
 
       /* Make stage 1: create the text deltas.  */
@@ -569,7 +574,7 @@ do_random_txdelta_to_svndiff_stream_test(apr_pool_t *pool,
                    svn_stream_from_aprfile2(source, TRUE, iterpool),
                    svn_stream_from_aprfile2(target, TRUE, iterpool),
                    FALSE, iterpool);
-      delta_stream = svn_txdelta_to_svndiff_stream(txstream, i % 3, i % 10,
+      delta_stream = svn_txdelta_to_svndiff_stream(txstream, i % 4, i % 10,
                                                    iterpool);
 
       /* Apply it to a copy of the source file to see if we get the
@@ -605,6 +610,303 @@ random_txdelta_to_svndiff_stream_test(apr_pool_t *pool)
   return err;
 }
 
+/* Return LEN bytes of incompressible data generated from SEED. */
+static svn_stringbuf_t *
+random_data(apr_size_t len, apr_uint32_t seed, apr_pool_t *pool)
+{
+  svn_stringbuf_t *data = svn_stringbuf_create_ensure(len, pool);
+  apr_size_t i;
+
+  for (i = 0; i < len; i++)
+    data->data[i] = (char)svn_test_rand(&seed);
+
+  data->data[len] = '\0';
+  data->len = len;
+
+  return data;
+}
+
+/* Return a readable stream over a copy of DATA, allocated in POOL. */
+static svn_stream_t *
+read_copy(const svn_stringbuf_t *data, apr_pool_t *pool)
+{
+  return svn_stream_from_stringbuf(svn_stringbuf_dup(data, pool), pool);
+}
+
+/* Delta TARGET against SOURCE, using large windows if LARGE is set, encode
+ * it as svndiff SVNDIFF_VERSION, decode and apply it, and verify that the
+ * result matches TARGET.  Return the size of the encoded delta in *SIZE.
+ */
+static svn_error_t *
+large_window_roundtrip(apr_size_t *size,
+                       const svn_stringbuf_t *source,
+                       const svn_stringbuf_t *target,
+                       svn_boolean_t large,
+                       int svndiff_version,
+                       apr_pool_t *pool)
+{
+  svn_stringbuf_t *svndiff = svn_stringbuf_create_empty(pool);
+  svn_stringbuf_t *result = svn_stringbuf_create_empty(pool);
+  svn_txdelta_stream_t *txdelta_stream;
+  svn_txdelta_window_handler_t handler;
+  void *handler_baton;
+  svn_stream_t *stream;
+
+  /* Create and encode the delta. */
+  svn_txdelta_to_svndiff3(&handler, &handler_baton,
+                          svn_stream_from_stringbuf(svndiff, pool),
+                          svndiff_version,
+                          SVN_DELTA_COMPRESSION_LEVEL_DEFAULT, pool);
+  if (large)
+    svn_txdelta__large(&txdelta_stream, read_copy(source, pool),
+                       read_copy(target, pool), FALSE, pool);
+  else
+    svn_txdelta2(&txdelta_stream, read_copy(source, pool),
+                 read_copy(target, pool), FALSE, pool);
+  SVN_ERR(svn_txdelta_send_txstream(txdelta_stream, handler, handler_baton,
+                                    pool));
+  *size = svndiff->len;
+
+  /* Decode and apply it. */
+  svn_txdelta_apply(read_copy(source, pool),
+                    svn_stream_from_stringbuf(result, pool),
+                    NULL, NULL, pool, &handler, &handler_baton);
+  stream = svn_txdelta_parse_svndiff(handler, handler_baton, TRUE, pool);
+  SVN_ERR(svn_stream_write(stream, svndiff->data, &svndiff->len));
+  SVN_ERR(svn_stream_close(stream));
+
+  SVN_TEST_ASSERT(svn_stringbuf_compare(result, target));
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_test_driver_t. */
+static svn_error_t *
+large_window_test(apr_pool_t *pool)
+{
+  /* The target is the source with a block inserted near the start that
+   * is larger than a standard window but smaller than the overlap of
+   * large windows.  Large windows only need to add that block. */
+  const apr_size_t source_len = 3 * 1024 * 1024;
+  const apr_size_t insert_len = 200 * 1024;
+  svn_stringbuf_t *source = random_data(source_len, 1, pool);
+  svn_stringbuf_t *insert = random_data(insert_len, 2, pool);
+  svn_stringbuf_t *target = svn_stringbuf_dup(source, pool);
+  svn_stringbuf_t *svndiff = svn_stringbuf_create_empty(pool);
+  apr_size_t standard_size, large_size, len;
+  svn_txdelta_window_handler_t handler;
+  void *handler_baton;
+  svn_stream_t *stream;
+  svn_error_t *err;
+
+  svn_stringbuf_insert(target, 100, insert->data, insert->len);
+
+  SVN_ERR(large_window_roundtrip(&standard_size, source, target, FALSE, 3,
+                                 pool));
+  SVN_ERR(large_window_roundtrip(&large_size, source, target, TRUE, 3,
+                                 pool));
+  SVN_TEST_ASSERT(large_size < insert_len + insert_len / 10);
+  SVN_TEST_ASSERT(large_size * 4 < standard_size);
+
+  /* Target push must create the same windows. */
+  svn_txdelta_to_svndiff3(&handler, &handler_baton,
+                          svn_stream_from_stringbuf(svndiff, pool), 3,
+                          SVN_DELTA_COMPRESSION_LEVEL_DEFAULT, pool);
+  stream = svn_txdelta__target_push_large(handler, handler_baton,
+                                          read_copy(source, pool), pool);
+  len = target->len;
+  SVN_ERR(svn_stream_write(stream, target->data, &len));
+  SVN_ERR(svn_stream_close(stream));
+  SVN_TEST_ASSERT(svndiff->len == large_size);
+
+  /* Older svndiff versions must refuse large windows. */
+  err = large_window_roundtrip(&large_size, source, target, TRUE, 1, pool);
+  SVN_TEST_ASSERT_ERROR(err, SVN_ERR_SVNDIFF_CORRUPT_WINDOW);
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_test_driver_t. */
+static svn_error_t *
+block_checksum_test(apr_pool_t *pool)
+{
+  /* Shifting the target by a few bytes means that xdelta only finds the
+   * source blocks if the checksums of whole blocks match the rolling
+   * checksums it uses while scanning the target.  Random data is
+   * incompressible, so any missed match shows in the delta size. */
+  const apr_size_t source_len = 64 * 1024;
+  svn_stringbuf_t *source = random_data(source_len, 3, pool);
+  svn_stringbuf_t *target = svn_stringbuf_dup(source, pool);
+  apr_size_t size;
+
+  svn_stringbuf_insert(target, 1000, "\xff\x80\x01", 3);
+  SVN_ERR(large_window_roundtrip(&size, source, target, FALSE, 0, pool));
+  SVN_TEST_ASSERT(size < source_len / 16);
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *NEXT to a new revision of TEXT, as a user would produce it by a
+ * few local edits.  Besides insertions and deletions, some edits copy
+ * existing data around, which makes the deltas refer to their source
+ * out of order.  Use and update *SEED.  Allocate *NEXT in POOL. */
+static svn_stringbuf_t *
+edit_text(const svn_stringbuf_t *text, apr_uint32_t *seed, apr_pool_t *pool)
+{
+  svn_stringbuf_t *next = svn_stringbuf_dup(text, pool);
+  int i;
+
+  for (i = 0; i < 8; ++i)
+    {
+      apr_size_t pos = svn_test_rand(seed) % next->len;
+      apr_size_t len = svn_test_rand(seed) % 200 + 1;
+      apr_size_t from;
+
+      switch (svn_test_rand(seed) % 3)
+        {
+          case 0:
+            if (next->len + len < SVN_DELTA_WINDOW_SIZE)
+              {
+                svn_stringbuf_t *data
+                  = random_data(len, svn_test_rand(seed), pool);
+                svn_stringbuf_insert(next, pos, data->data, data->len);
+                break;
+              }
+            /* Fall through and make room instead. */
+
+          case 1:
+            svn_stringbuf_remove(next, pos, len);
+            break;
+
+          default:
+            from = svn_test_rand(seed) % next->len;
+            len = MIN(len, next->len - from);
+            pos = MIN(pos, next->len - len);
+            svn_stringbuf_replace(next, pos, len, next->data + from, len);
+            break;
+        }
+    }
+
+  return next;
+}
+
+/* Return the delta window that turns SOURCE into TARGET.  Both must fit
+ * into a single window.  Allocate it in POOL. */
+static svn_error_t *
+single_window(svn_txdelta_window_t **window,
+              const svn_stringbuf_t *source,
+              const svn_stringbuf_t *target,
+              apr_pool_t *pool)
+{
+  svn_txdelta_stream_t *stream;
+  svn_txdelta_window_t *last;
+
+  svn_txdelta2(&stream, read_copy(source, pool), read_copy(target, pool),
+               FALSE, pool);
+  SVN_ERR(svn_txdelta_next_window(window, stream, pool));
+  SVN_ERR(svn_txdelta_next_window(&last, stream, pool));
+  SVN_TEST_ASSERT(*window && !last);
+
+  return SVN_NO_ERROR;
+}
+
+/* Combine the linear delta chain WINDOWS as FSFS does when reading a
+ * representation, i.e. starting with the latest delta.  Use the flat
+ * range index if FLAT_INDEX is set.  Return the result in *COMBINED,
+ * allocated in POOL. */
+static void
+combine_chain(svn_txdelta_window_t **combined,
+              apr_array_header_t *windows,
+              svn_boolean_t flat_index,
+              apr_pool_t *pool)
+{
+  svn_txdelta_window_t *window
+    = APR_ARRAY_IDX(windows, windows->nelts - 1, svn_txdelta_window_t *);
+  int i;
+
+  for (i = windows->nelts - 2; i >= 0 && window->src_ops; --i)
+    window = svn_txdelta__compose_windows(
+                 APR_ARRAY_IDX(windows, i, svn_txdelta_window_t *),
+                 window, flat_index, pool);
+
+  *combined = window;
+}
+
+/* Implements svn_test_driver_t. */
+static svn_error_t *
+compose_chain_test(apr_pool_t *pool)
+{
+  enum { REVISIONS = 200, REPEAT = 10 };
+  apr_uint32_t seed = 42;
+  svn_stringbuf_t *base = random_data(90 * 1024, seed, pool);
+  svn_stringbuf_t *text = base;
+  apr_array_header_t *windows
+    = apr_array_make(pool, REVISIONS, sizeof(svn_txdelta_window_t *));
+  svn_txdelta_window_t *flat_window, *tree_window;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  apr_time_t start, flat_time, tree_time;
+  char *result;
+  apr_size_t len;
+  int i;
+
+  /* Create a history of small edits and its delta chain. */
+  for (i = 0; i < REVISIONS; ++i)
+    {
+      svn_stringbuf_t *next = edit_text(text, &seed, pool);
+      svn_txdelta_window_t *window;
+
+      SVN_ERR(single_window(&window, text, next, pool));
+      APR_ARRAY_PUSH(windows, svn_txdelta_window_t *) = window;
+      text = next;
+    }
+
+  /* Both range index implementations must produce the same result. */
+  start = apr_time_now();
+  for (i = 0; i < REPEAT; ++i)
+    {
+      svn_pool_clear(iterpool);
+      combine_chain(&flat_window, windows, TRUE, iterpool);
+    }
+  flat_time = apr_time_now() - start;
+
+  start = apr_time_now();
+  for (i = 0; i < REPEAT; ++i)
+    {
+      svn_pool_clear(iterpool);
+      combine_chain(&tree_window, windows, FALSE, iterpool);
+    }
+  tree_time = apr_time_now() - start;
+
+  combine_chain(&flat_window, windows, TRUE, pool);
+  SVN_TEST_ASSERT(flat_window->num_ops == tree_window->num_ops);
+  for (i = 0; i < flat_window->num_ops; ++i)
+    {
+      const svn_txdelta_op_t *flat_op = &flat_window->ops[i];
+      const svn_txdelta_op_t *tree_op = &tree_window->ops[i];
+
+      SVN_TEST_ASSERT(flat_op->action_code == tree_op->action_code);
+      SVN_TEST_ASSERT(flat_op->offset == tree_op->offset);
+      SVN_TEST_ASSERT(flat_op->length == tree_op->length);
+    }
+  SVN_TEST_ASSERT(svn_string_compare(flat_window->new_data,
+                                     tree_window->new_data));
+
+  /* And that result must reproduce the latest revision. */
+  len = flat_window->tview_len;
+  result = apr_palloc(pool, len);
+  svn_txdelta_apply_instructions(flat_window, base->data, result, &len);
+  SVN_TEST_ASSERT(len == text->len);
+  SVN_TEST_ASSERT(memcmp(result, text->data, len) == 0);
+
+  printf("Combining %d deltas into %d ops, %d times:\n",
+         REVISIONS, flat_window->num_ops, REPEAT);
+  printf("  flat range index: %" APR_TIME_T_FMT " musecs\n", flat_time);
+  printf("  splay tree:       %" APR_TIME_T_FMT " musecs\n", tree_time);
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
 /* Change to 1 to enable the unit test for the delta combiner's range index: */
 #if 0
 #include "range-index-test.h"
@@ -625,6 +927,12 @@ static struct svn_test_descriptor_t test_funcs[] =
                    "random combine delta test"),
     SVN_TEST_PASS2(random_txdelta_to_svndiff_stream_test,
                    "random txdelta to svndiff stream test"),
+    SVN_TEST_PASS2(large_window_test,
+                   "svndiff3 with large sliding windows"),
+    SVN_TEST_PASS2(block_checksum_test,
+                   "find matches at unaligned offsets"),
+    SVN_TEST_PASS2(compose_chain_test,
+                   "combine delta chains using a flat range index"),
 #ifdef SVN_RANGE_INDEX_TEST_H
     SVN_TEST_PASS2(random_range_index_test,
                    "random range index test"),
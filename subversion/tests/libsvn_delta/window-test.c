@@ -96,6 +96,94 @@ stream_window_test(apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+/* Apply WINDOW to an empty source through an svndiff stream of version
+ * SVNDIFF_VERSION, as a client would when receiving it, and return the
+ * result in *RESULT. */
+static svn_error_t *
+apply_svndiff(svn_stringbuf_t **result,
+              svn_txdelta_window_t *window,
+              int svndiff_version,
+              apr_pool_t *pool)
+{
+  svn_txdelta_window_handler_t handler;
+  void *baton;
+  svn_stream_t *stream;
+
+  *result = svn_stringbuf_create_empty(pool);
+  svn_txdelta_apply(svn_stream_empty(pool),
+                    svn_stream_from_stringbuf(*result, pool),
+                    NULL, NULL, pool, &handler, &baton);
+  stream = svn_txdelta_parse_svndiff(handler, baton, TRUE, pool);
+  svn_txdelta_to_svndiff3(&handler, &baton, stream, svndiff_version,
+                          SVN_DELTA_COMPRESSION_LEVEL_DEFAULT, pool);
+  SVN_ERR(handler(window, baton));
+
+  return handler(NULL, baton);
+}
+
+static svn_error_t *
+patterning_copy_test(apr_pool_t *pool)
+{
+  enum { PREFIX = 64, LEN = 5000 };
+  char data[PREFIX];
+  char expected[PREFIX + LEN];
+  char target[PREFIX + LEN];
+  svn_txdelta_op_t ops[2];
+  svn_string_t new_data;
+  svn_txdelta_window_t window = { 0 };
+  apr_size_t period, i, len;
+  int version;
+
+  for (i = 0; i < PREFIX; ++i)
+    data[i] = (char)('a' + i % 26);
+
+  new_data.data = data;
+  new_data.len = PREFIX;
+
+  ops[0].action_code = svn_txdelta_new;
+  ops[0].offset = 0;
+  ops[0].length = PREFIX;
+
+  window.ops = ops;
+  window.num_ops = 2;
+  window.new_data = &new_data;
+  window.tview_len = PREFIX + LEN;
+
+  /* Copy the last PERIOD bytes of the prefix over and over again. */
+  for (period = 1; period <= PREFIX; ++period)
+    {
+      ops[1].action_code = svn_txdelta_target;
+      ops[1].offset = PREFIX - period;
+      ops[1].length = LEN;
+
+      memcpy(expected, data, PREFIX);
+      for (i = PREFIX; i < PREFIX + LEN; ++i)
+        expected[i] = expected[i - period];
+
+      len = window.tview_len;
+      svn_txdelta_apply_instructions(&window, NULL, target, &len);
+      SVN_TEST_ASSERT(len == PREFIX + LEN);
+      SVN_TEST_ASSERT(memcmp(target, expected, len) == 0);
+
+      /* The svndiff parser applies such windows without creating
+       * svn_txdelta_window_t for them. */
+      for (version = 0; version <= 4; ++version)
+        {
+          svn_stringbuf_t *result;
+
+          /* Svndiff4 requires Zstandard support. */
+          if (version == 4 && !svn_zstd__compiled_version())
+            continue;
+
+          SVN_ERR(apply_svndiff(&result, &window, version, pool));
+          SVN_TEST_ASSERT(result->len == PREFIX + LEN);
+          SVN_TEST_ASSERT(memcmp(result->data, expected, result->len) == 0);
+        }
+    }
+
+  return SVN_NO_ERROR;
+}
+
 
 
 /* The test table.  */
@@ -107,6 +195,8 @@ static struct svn_test_descriptor_t test_funcs[] =
     SVN_TEST_NULL,
     SVN_TEST_PASS2(stream_window_test,
                    "txdelta stream and windows test"),
+    SVN_TEST_PASS2(patterning_copy_test,
+                   "apply overlapping target copies"),
     SVN_TEST_NULL
   };
 
@@ -2251,9 +2251,11 @@ random_trivial_merge(apr_pool_t *pool)
    for each selected line either adding an additional line, replacing the
    line, or deleting the line.  The two subsets are chosen so that each
    selected line is distinct and no two selected lines are adjacent. This
-   means the two sets of changes should merge without conflict.  */
+   means the two sets of changes should merge without conflict.  Use
+   OPTIONS for all diffs. */
 static svn_error_t *
-random_three_way_merge(apr_pool_t *pool)
+do_random_three_way_merge(const svn_diff_file_options_t *options,
+                          apr_pool_t *pool)
 {
   int i;
   apr_pool_t *subpool = svn_pool_create(pool);
@@ -2307,12 +2309,12 @@ random_three_way_merge(apr_pool_t *pool)
 
       SVN_ERR(three_way_merge(base_filename1, base_filename2, base_filename3,
                               original->data, modified1->data,
-                              modified2->data, combined->data, NULL,
+                              modified2->data, combined->data, options,
                               svn_diff_conflict_display_modified_latest,
                               subpool));
       SVN_ERR(three_way_merge(base_filename1, base_filename3, base_filename2,
                               original->data, modified2->data,
-                              modified1->data, combined->data, NULL,
+                              modified1->data, combined->data, options,
                               svn_diff_conflict_display_modified_latest,
                               subpool));
 
@@ -2325,6 +2327,21 @@ random_three_way_merge(apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+static svn_error_t *
+random_three_way_merge(apr_pool_t *pool)
+{
+  return do_random_three_way_merge(NULL, pool);
+}
+
+static svn_error_t *
+random_three_way_merge_patience(apr_pool_t *pool)
+{
+  svn_diff_file_options_t *diff_opts = svn_diff_file_options_create(pool);
+
+  diff_opts->algorithm = svn_diff_file_algorithm_patience;
+  return do_random_three_way_merge(diff_opts, pool);
+}
+
 /* This is similar to random_three_way_merge above, except this time half
    of the original-to-modified1 changes are already present in modified2
    (or, equivalently, half the original-to-modified2 changes are already
@@ -2693,6 +2710,61 @@ test_token_compare(apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+/* The merge output reads its input files in chunks of CHUNK_SIZE
+   from ../../libsvn_diff/diff_file.c.  Check lines that are longer than
+   a chunk and a CRLF that has its CR at the end of the first chunk. */
+static svn_error_t *
+test_merge_chunk_boundary(apr_pool_t *pool)
+{
+  apr_size_t chunk_size = 1 << 17;
+  svn_stringbuf_t *first = svn_stringbuf_create_empty(pool);
+  svn_stringbuf_t *longest = svn_stringbuf_create_empty(pool);
+  const char *original, *modified, *latest;
+
+  /* The CR will be the last byte of the first chunk. */
+  svn_stringbuf_appendfill(first, 'y', chunk_size - 1);
+  svn_stringbuf_appendcstr(first, "\r\n");
+
+  svn_stringbuf_appendfill(longest, 'x', chunk_size * 2 + 100);
+  svn_stringbuf_appendcstr(longest, "\n");
+
+  original = apr_pstrcat(pool, first->data, "b\n", longest->data,
+                         "c\nd\n", SVN_VA_NULL);
+  modified = apr_pstrcat(pool, first->data, "bMOD\n", longest->data,
+                         "c\nd\n", SVN_VA_NULL);
+  latest = apr_pstrcat(pool, first->data, "b\n", longest->data,
+                       "c\ndLAT\n", SVN_VA_NULL);
+
+  SVN_ERR(three_way_merge("chunk-merge1", "chunk-merge2", "chunk-merge3",
+                          original, modified, latest,
+                          apr_pstrcat(pool, first->data, "bMOD\n",
+                                      longest->data, "c\ndLAT\n",
+                                      SVN_VA_NULL),
+                          NULL,
+                          svn_diff_conflict_display_modified_latest,
+                          pool));
+
+  latest = apr_pstrcat(pool, first->data, "bLAT\n", longest->data,
+                       "c\nd\n", SVN_VA_NULL);
+
+  /* The conflict markers use the CRLF of the modified file. */
+  SVN_ERR(three_way_merge("chunk-merge4", "chunk-merge5", "chunk-merge6",
+                          original, modified, latest,
+                          apr_pstrcat(pool, first->data,
+                                      "<<<<<<< chunk-merge5\r\n"
+                                      "bMOD\n"
+                                      "=======\r\n"
+                                      "bLAT\n"
+                                      ">>>>>>> chunk-merge6\r\n",
+                                      longest->data, "c\nd\n",
+                                      SVN_VA_NULL),
+                          NULL,
+                          svn_diff_conflict_display_modified_latest,
+                          pool));
+
+  return SVN_NO_ERROR;
+}
+
 static svn_error_t *
 two_way_issue_3362_v1(apr_pool_t *pool)
 {
@@ -3065,6 +3137,61 @@ three_way_double_add(apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+/* Moving a function past another one.  LCS prefers to keep the body of
+   the first function aligned; patience diff anchors on the lines that
+   are unique in both versions and keeps each signature with its body. */
+static svn_error_t *
+two_way_patience(apr_pool_t *pool)
+{
+  svn_diff_file_options_t *diff_opts = svn_diff_file_options_create(pool);
+  apr_array_header_t *args = apr_array_make(pool, 1, sizeof(const char *));
+
+  APR_ARRAY_PUSH(args, const char *) = "--patience";
+  SVN_ERR(svn_diff_file_options_parse(diff_opts, args, pool));
+  SVN_TEST_ASSERT(diff_opts->algorithm == svn_diff_file_algorithm_patience);
+
+  SVN_ERR(two_way_diff("patience1", "patience2",
+                       "#include <a.h>\n"
+                       "int f(void)\n"
+                       "{\n"
+                       "  return 1;\n"
+                       "}\n"
+                       "int g(void)\n"
+                       "{\n"
+                       "  return 2;\n"
+                       "}\n",
+
+                       "#include <a.h>\n"
+                       "int g(void)\n"
+                       "{\n"
+                       "  return 2;\n"
+                       "}\n"
+                       "int f(void)\n"
+                       "{\n"
+                       "  return 1;\n"
+                       "}\n",
+
+                       "--- patience1"         NL
+                       "+++ patience2"         NL
+                       "@@ -1,9 +1,9 @@"       NL
+                       " #include <a.h>\n"
+                       "-int f(void)\n"
+                       "-{\n"
+                       "-  return 1;\n"
+                       "-}\n"
+                       " int g(void)\n"
+                       " {\n"
+                       "   return 2;\n"
+                       "+}\n"
+                       "+int f(void)\n"
+                       "+{\n"
+                       "+  return 1;\n"
+                       " }\n",
+                       diff_opts, pool));
+
+  return SVN_NO_ERROR;
+}
+
 /* ========================================================================== */
 
 
@@ -3103,12 +3230,18 @@ static struct svn_test_descriptor_t test_funcs[] =
                    "identical suffix starts at the boundary of a chunk"),
     SVN_TEST_PASS2(test_token_compare,
                    "compare tokens at the chunk boundary"),
+    SVN_TEST_PASS2(test_merge_chunk_boundary,
+                   "3-way merge output across chunk boundaries"),
     SVN_TEST_PASS2(two_way_issue_3362_v1,
                    "2-way issue #3362 test v1"),
     SVN_TEST_PASS2(two_way_issue_3362_v2,
                    "2-way issue #3362 test v2"),
     SVN_TEST_XFAIL2(three_way_double_add,
                    "3-way merge, double add"),
+    SVN_TEST_PASS2(random_three_way_merge_patience,
+                   "random 3-way merge using patience diff"),
+    SVN_TEST_PASS2(two_way_patience,
+                   "2-way diff using patience diff"),
     SVN_TEST_NULL
   };
 
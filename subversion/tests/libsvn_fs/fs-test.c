@@ -7369,6 +7369,171 @@ closest_copy_test_svn_4677(const svn_test_opts_t *opts,
   return SVN_NO_ERROR;
 }
 
+static svn_error_t *
+test_apply_text_by_checksum(const svn_test_opts_t *opts,
+                            apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root, *rev_root;
+  svn_revnum_t new_rev;
+  svn_checksum_t *sha1, *md5, *actual_md5;
+  svn_stringbuf_t *contents;
+  svn_boolean_t applied;
+  svn_fs_path_change_iterator_t *iterator;
+  svn_fs_path_change3_t *change;
+  const char *text = "text shared between branches\n";
+
+  /* Bail (with success) on known-untestable scenarios */
+  if (strcmp(opts->fs_type, SVN_FS_TYPE_FSFS) != 0)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "this will test FSFS repositories only");
+
+  if (opts->server_minor_version && (opts->server_minor_version < 6))
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "pre-1.6 SVN doesn't support rep-sharing");
+
+  SVN_ERR(svn_test__create_fs(&fs, "test-apply-text-by-checksum",
+                              opts, pool));
+  SVN_ERR(svn_checksum(&sha1, svn_checksum_sha1, text, strlen(text), pool));
+  SVN_ERR(svn_checksum(&md5, svn_checksum_md5, text, strlen(text), pool));
+
+  /* r1: /foo with TEXT, /bar with something else. */
+  SVN_ERR(svn_fs_begin_txn2(&txn, fs, 0, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_fs_make_file(txn_root, "foo", pool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "foo", text, pool));
+  SVN_ERR(svn_fs_make_file(txn_root, "bar", pool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "bar", "other\n", pool));
+
+  /* Not committed yet, so nothing to share. */
+  SVN_ERR(svn_fs_apply_text_by_checksum(&applied, txn_root, "bar", sha1,
+                                        pool));
+  SVN_TEST_ASSERT(!applied);
+  SVN_ERR(test_commit_txn(&new_rev, txn, NULL, pool));
+  SVN_TEST_INT_ASSERT(new_rev, 1);
+
+  /* r2: give /bar the text of /foo without sending it. */
+  SVN_ERR(svn_fs_begin_txn2(&txn, fs, new_rev, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_fs_apply_text_by_checksum(&applied, txn_root, "bar", sha1,
+                                        pool));
+  SVN_TEST_ASSERT(applied);
+
+  /* Unknown texts are left alone. */
+  SVN_ERR(svn_checksum(&sha1, svn_checksum_sha1, "unknown", 7, pool));
+  SVN_ERR(svn_fs_apply_text_by_checksum(&applied, txn_root, "foo", sha1,
+                                        pool));
+  SVN_TEST_ASSERT(!applied);
+
+  /* The change must be recorded like any text modification. */
+  SVN_ERR(svn_fs_paths_changed3(&iterator, txn_root, pool, pool));
+  SVN_ERR(svn_fs_path_change_get(&change, iterator));
+  SVN_TEST_ASSERT(change);
+  SVN_TEST_STRING_ASSERT(change->path.data, "/bar");
+  SVN_TEST_ASSERT(change->text_mod);
+  SVN_ERR(svn_fs_path_change_get(&change, iterator));
+  SVN_TEST_ASSERT(change == NULL);
+
+  SVN_ERR(test_commit_txn(&new_rev, txn, NULL, pool));
+  SVN_TEST_INT_ASSERT(new_rev, 2);
+
+  SVN_ERR(svn_fs_revision_root(&rev_root, fs, new_rev, pool));
+  SVN_ERR(svn_test__get_file_contents(rev_root, "bar", &contents, pool));
+  SVN_TEST_STRING_ASSERT(contents->data, text);
+  SVN_ERR(svn_fs_file_checksum(&actual_md5, svn_checksum_md5, rev_root,
+                               "bar", TRUE, pool));
+  SVN_TEST_ASSERT(svn_checksum_match(md5, actual_md5));
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_stat_paths(const svn_test_opts_t *opts,
+                apr_pool_t *pool)
+{
+  /* Unsorted, with duplicates, non-canonical and missing paths. */
+  static const char *const paths[]
+    = { "/A/D/G/rho", "/A/B", "A/D/G/pi", "/", "/A/D/H/missing",
+        "/iota/missing", "/A/D/G/rho", "/A/B/E/", "/iota", "/missing",
+        "/A/D/gamma" };
+
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root, *rev_root;
+  svn_revnum_t new_rev;
+  apr_array_header_t *path_array = apr_array_make(pool, 0,
+                                                  sizeof(const char *));
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  int i, k;
+
+  SVN_ERR(svn_test__create_fs(&fs, "test-repo-stat-paths", opts, pool));
+
+  SVN_ERR(svn_fs_begin_txn2(&txn, fs, 0, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_test__create_greek_tree(txn_root, pool));
+  SVN_ERR(svn_fs_change_node_prop(txn_root, "A/B", "prop",
+                                  svn_string_create("value", pool), pool));
+  SVN_ERR(test_commit_txn(&new_rev, txn, NULL, pool));
+  SVN_TEST_INT_ASSERT(new_rev, 1);
+
+  SVN_ERR(svn_fs_begin_txn2(&txn, fs, new_rev, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "iota", "changed", pool));
+  SVN_ERR(svn_fs_revision_root(&rev_root, fs, new_rev, pool));
+
+  for (i = 0; i < (int)(sizeof(paths) / sizeof(paths[0])); ++i)
+    APR_ARRAY_PUSH(path_array, const char *) = paths[i];
+
+  /* The results must match those of the individual lookups,
+     for revision as well as txn roots. */
+  for (k = 0; k < 2; ++k)
+    {
+      svn_fs_root_t *root = k ? txn_root : rev_root;
+      apr_array_header_t *stats;
+
+      SVN_ERR(svn_fs_stat_paths(&stats, root, path_array, pool, pool));
+      SVN_TEST_INT_ASSERT(stats->nelts, path_array->nelts);
+
+      for (i = 0; i < stats->nelts; ++i)
+        {
+          const char *path = paths[i];
+          const svn_fs_path_stat_t *stat
+            = APR_ARRAY_IDX(stats, i, const svn_fs_path_stat_t *);
+          svn_node_kind_t kind;
+          svn_boolean_t has_props;
+          svn_revnum_t created_rev;
+
+          svn_pool_clear(iterpool);
+          SVN_ERR(svn_fs_check_path(&kind, root, path, iterpool));
+          SVN_TEST_INT_ASSERT(stat->kind, kind);
+          if (kind == svn_node_none)
+            continue;
+
+          if (kind == svn_node_file)
+            {
+              svn_filesize_t size;
+              SVN_ERR(svn_fs_file_length(&size, root, path, iterpool));
+              SVN_TEST_ASSERT(stat->size == size);
+            }
+          else
+            {
+              SVN_TEST_ASSERT(stat->size == SVN_INVALID_FILESIZE);
+            }
+
+          SVN_ERR(svn_fs_node_has_props(&has_props, root, path, iterpool));
+          SVN_TEST_ASSERT(!stat->has_props == !has_props);
+          SVN_ERR(svn_fs_node_created_rev(&created_rev, root, path,
+                                          iterpool));
+          SVN_TEST_INT_ASSERT(stat->created_rev, created_rev);
+        }
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
 /* ------------------------------------------------------------------------ */
 
 /* The test table.  */
@@ -7513,6 +7678,10 @@ static struct svn_test_descriptor_t test_funcs[] =
                        "test rep-sharing on content rather than SHA1"),
     SVN_TEST_OPTS_PASS(closest_copy_test_svn_4677,
                        "test issue SVN-4677 regression"),
+    SVN_TEST_OPTS_PASS(test_apply_text_by_checksum,
+                       "test setting file contents by SHA1 checksum"),
+    SVN_TEST_OPTS_PASS(test_stat_paths,
+                       "look up multiple paths at once"),
     SVN_TEST_NULL
   };
 
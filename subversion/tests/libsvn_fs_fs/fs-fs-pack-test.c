@@ -23,20 +23,30 @@
 #include <stdlib.h>
 #include <string.h>
 #include <apr_pools.h>
+#include <apr_thread_proc.h>
 
 #include "../svn_test.h"
 #include "../../libsvn_fs/fs-loader.h"
+#include "../../libsvn_fs_fs/cached_data.h"
 #include "../../libsvn_fs_fs/fs.h"
 #include "../../libsvn_fs_fs/fs_fs.h"
+#include "../../libsvn_fs_fs/index.h"
 #include "../../libsvn_fs_fs/low_level.h"
 #include "../../libsvn_fs_fs/pack.h"
+#include "../../libsvn_fs_fs/rep-cache.h"
+#include "../../libsvn_fs_fs/revprops.h"
+#include "../../libsvn_fs_fs/transaction.h"
+#include "../../libsvn_fs_fs/tree.h"
 #include "../../libsvn_fs_fs/util.h"
 
 #include "svn_hash.h"
 #include "svn_pools.h"
 #include "svn_props.h"
 #include "svn_fs.h"
+#include "svn_delta.h"
+#include "private/svn_fs_private.h"
 #include "private/svn_string_private.h"
+#include "private/svn_subr_private.h"
 
 #include "../svn_test_fs.h"
 
@@ -1796,7 +1806,7 @@ pack_with_limited_memory(const svn_test_opts_t *opts,
       /* Pack it with a narrow memory budget. */
       SVN_ERR(svn_fs_open2(&fs, dir, NULL, iterpool, iterpool));
       SVN_ERR(svn_fs_fs__pack(fs, max_mem, NULL, NULL, NULL, NULL,
-                              iterpool));
+                              NULL, NULL, iterpool));
 
       /* To be sure: Verify that we didn't break the repo. */
       SVN_ERR(svn_fs_verify(dir, NULL, 0, MAX_REV, NULL, NULL, NULL, NULL,
@@ -1887,8 +1897,2216 @@ large_delta_against_plain(const svn_test_opts_t *opts,
 
 #undef REPO_NAME
 
+/* ------------------------------------------------------------------------ */
+
+#define REPO_NAME "test-repo-prefetch_delta_chain"
+#define SHARD_SIZE 4
+#define MAX_REV 9
+
+static svn_error_t *
+prefetch_delta_chain(const svn_test_opts_t *opts,
+                     apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  fs_fs_data_t *ffd;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *root;
+  svn_revnum_t rev;
+  svn_stringbuf_t *contents;
+  apr_array_header_t *expected;
+  int i;
+  apr_hash_t *fs_config;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+
+  if (strcmp(opts->fs_type, "fsfs") != 0)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL, NULL);
+
+  fs_config = apr_hash_make(pool);
+  svn_hash_sets(fs_config, SVN_FS_CONFIG_FSFS_SHARD_SIZE,
+                apr_itoa(pool, SHARD_SIZE));
+  SVN_ERR(svn_test__create_fs2(&fs, REPO_NAME, opts, fs_config, pool));
+
+  /* Multi-window contents such that each rev deltifies against an older
+   * one.  In r5, the head of the file gets replaced entirely, i.e. its
+   * first window will not depend on the rest of the chain. */
+  contents = svn_stringbuf_create_empty(pool);
+  for (i = 0; contents->len < 3 * 102400; ++i)
+    svn_stringbuf_appendcstr(contents, apr_psprintf(pool, "line %d\n", i));
+
+  expected = apr_array_make(pool, MAX_REV + 1, sizeof(const char *));
+  APR_ARRAY_PUSH(expected, const char *) = NULL;
+
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+  SVN_ERR(svn_fs_make_file(root, "foo", pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+  APR_ARRAY_PUSH(expected, const char *) = "";
+
+  for (rev = 2; rev <= MAX_REV; ++rev)
+    {
+      svn_pool_clear(iterpool);
+
+      if (rev == 5)
+        memset(contents->data, 'x', 102400);
+      else
+        contents->data[rev * 997] = (char)('a' + rev);
+
+      SVN_ERR(svn_fs_begin_txn(&txn, fs, rev - 1, iterpool));
+      SVN_ERR(svn_fs_txn_root(&root, txn, iterpool));
+      SVN_ERR(svn_test__set_file_contents(root, "foo", contents->data,
+                                          iterpool));
+      SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, iterpool));
+
+      APR_ARRAY_PUSH(expected, const char *)
+        = apr_pstrmemdup(pool, contents->data, contents->len);
+    }
+
+  SVN_ERR(svn_fs_pack(REPO_NAME, NULL, NULL, NULL, NULL, pool));
+
+  /* Read all revisions with prefetching enabled.  To make sure we
+   * actually read from disk, use a new FS instance with disjoint caches. */
+  fs_config = apr_hash_make(pool);
+  svn_hash_sets(fs_config, SVN_FS_CONFIG_FSFS_CACHE_NS,
+                           svn_uuid_generate(pool));
+  SVN_ERR(svn_fs_open2(&fs, REPO_NAME, fs_config, pool, pool));
+
+  ffd = fs->fsap_data;
+  ffd->prefetch_delta_chain = TRUE;
+
+  for (rev = MAX_REV; rev > 0; --rev)
+    {
+      svn_pool_clear(iterpool);
+
+      SVN_ERR(svn_fs_revision_root(&root, fs, rev, iterpool));
+      SVN_ERR(svn_test__get_file_contents(root, "foo", &contents, iterpool));
+      SVN_TEST_STRING_ASSERT(contents->data,
+                             APR_ARRAY_IDX(expected, rev, const char *));
+    }
+
+  /* Again with fresh caches, but this time only the first windows of the
+   * reps before r5 are in cache.  Reading the newer revisions must not
+   * get confused by the cached windows beyond the end of the first chunk's
+   * chain. */
+  svn_hash_sets(fs_config, SVN_FS_CONFIG_FSFS_CACHE_NS,
+                           svn_uuid_generate(pool));
+  SVN_ERR(svn_fs_open2(&fs, REPO_NAME, fs_config, pool, pool));
+
+  ffd = fs->fsap_data;
+  ffd->prefetch_delta_chain = TRUE;
+
+  for (rev = 2; rev < 5; ++rev)
+    {
+      svn_stream_t *stream;
+      char buffer[100];
+      apr_size_t len = sizeof(buffer);
+
+      svn_pool_clear(iterpool);
+
+      SVN_ERR(svn_fs_revision_root(&root, fs, rev, iterpool));
+      SVN_ERR(svn_fs_file_contents(&stream, root, "foo", iterpool));
+      SVN_ERR(svn_stream_read_full(stream, buffer, &len));
+      SVN_ERR(svn_stream_close(stream));
+    }
+
+  for (rev = MAX_REV; rev > 4; --rev)
+    {
+      svn_pool_clear(iterpool);
+
+      SVN_ERR(svn_fs_revision_root(&root, fs, rev, iterpool));
+      SVN_ERR(svn_test__get_file_contents(root, "foo", &contents, iterpool));
+      SVN_TEST_STRING_ASSERT(contents->data,
+                             APR_ARRAY_IDX(expected, rev, const char *));
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+#undef REPO_NAME
+#undef SHARD_SIZE
+#undef MAX_REV
+
+/* ------------------------------------------------------------------------ */
+
+#define REPO_NAME "test-repo-pack_in_parallel"
+#define SHARD_SIZE 4
+#define MAX_REV 41
+
+static svn_error_t *
+pack_in_parallel(const svn_test_opts_t *opts,
+                 apr_pool_t *pool)
+{
+  struct pack_notify_baton pnb;
+  apr_file_t *file;
+  const char *conf = "\n[pack]\njobs = 3\n";
+  svn_fs_t *fs;
+  svn_fs_root_t *root;
+  svn_stringbuf_t *contents;
+
+  SVN_ERR(create_non_packed_filesystem(REPO_NAME, opts, MAX_REV, SHARD_SIZE,
+                                       pool));
+
+  /* Allow for concurrent pack jobs. */
+  SVN_ERR(svn_io_file_open(&file,
+                           svn_dirent_join(REPO_NAME, "fsfs.conf", pool),
+                           APR_WRITE | APR_APPEND, APR_OS_DEFAULT, pool));
+  SVN_ERR(svn_io_file_write_full(file, conf, strlen(conf), NULL, pool));
+  SVN_ERR(svn_io_file_close(file, pool));
+
+  /* Notifications must still arrive shard by shard. */
+  pnb.expected_shard = 0;
+  pnb.expected_action = svn_fs_pack_notify_start;
+  SVN_ERR(svn_fs_pack(REPO_NAME, pack_notify, &pnb, NULL, NULL, pool));
+  SVN_TEST_ASSERT(pnb.expected_shard == (MAX_REV + 1) / SHARD_SIZE);
+
+  /* The result must be a valid, fully packed repository. */
+  SVN_ERR(svn_fs_verify(REPO_NAME, NULL, 0, MAX_REV, NULL, NULL, NULL, NULL,
+                        pool));
+
+  SVN_ERR(svn_fs_open2(&fs, REPO_NAME, NULL, pool, pool));
+  SVN_TEST_ASSERT(((fs_fs_data_t *)fs->fsap_data)->min_unpacked_rev
+                  == (MAX_REV + 1) / SHARD_SIZE * SHARD_SIZE);
+
+  SVN_ERR(svn_fs_revision_root(&root, fs, MAX_REV, pool));
+  SVN_ERR(svn_test__get_file_contents(root, "iota", &contents, pool));
+  SVN_TEST_STRING_ASSERT(contents->data, get_rev_contents(MAX_REV, pool));
+
+  return SVN_NO_ERROR;
+}
+
+#undef REPO_NAME
+#undef SHARD_SIZE
+#undef MAX_REV
 
 
+/* ------------------------------------------------------------------------ */
+
+#define REPO_NAME "test-repo-hotcopy_in_parallel"
+#define SHARD_SIZE 4
+#define MAX_REV 41
+
+/* Implements svn_fs_hotcopy_notify_t.  BATON is the svn_revnum_t of the
+   last revision reported so far. */
+static void
+hotcopy_notify(void *baton,
+               svn_revnum_t start_revision,
+               svn_revnum_t end_revision,
+               apr_pool_t *scratch_pool)
+{
+  svn_revnum_t *last_rev = baton;
+
+  /* Revisions must be reported in order and only once. */
+  if (start_revision <= *last_rev || end_revision < start_revision)
+    *last_rev = SVN_INVALID_REVNUM - 1;
+  else
+    *last_rev = end_revision;
+}
+
+static svn_error_t *
+hotcopy_in_parallel(const svn_test_opts_t *opts,
+                    apr_pool_t *pool)
+{
+  struct pack_notify_baton pnb;
+  apr_file_t *file;
+  const char *conf = "\n[hotcopy]\njobs = 3\n";
+  const char *dst = REPO_NAME "-copy";
+  svn_revnum_t last_rev;
+  svn_fs_t *fs;
+  svn_fs_root_t *root;
+  svn_stringbuf_t *contents;
+  svn_revnum_t youngest;
+
+  SVN_ERR(create_non_packed_filesystem(REPO_NAME, opts, MAX_REV, SHARD_SIZE,
+                                       pool));
+
+  /* Allow for concurrent hotcopy jobs. */
+  SVN_ERR(svn_io_file_open(&file,
+                           svn_dirent_join(REPO_NAME, "fsfs.conf", pool),
+                           APR_WRITE | APR_APPEND, APR_OS_DEFAULT, pool));
+  SVN_ERR(svn_io_file_write_full(file, conf, strlen(conf), NULL, pool));
+  SVN_ERR(svn_io_file_close(file, pool));
+
+  /* Copy the non-packed shards. */
+  SVN_ERR(svn_io_remove_dir2(dst, TRUE, NULL, NULL, pool));
+  last_rev = -1;
+  SVN_ERR(svn_fs_hotcopy3(REPO_NAME, dst, FALSE, FALSE,
+                          hotcopy_notify, &last_rev, NULL, NULL, pool));
+  SVN_TEST_ASSERT(last_rev == MAX_REV);
+  SVN_ERR(svn_fs_verify(dst, NULL, 0, MAX_REV, NULL, NULL, NULL, NULL,
+                        pool));
+
+  /* Pack the source and copy the packed shards incrementally. */
+  pnb.expected_shard = 0;
+  pnb.expected_action = svn_fs_pack_notify_start;
+  SVN_ERR(svn_fs_pack(REPO_NAME, pack_notify, &pnb, NULL, NULL, pool));
+
+  last_rev = -1;
+  SVN_ERR(svn_fs_hotcopy3(REPO_NAME, dst, FALSE, TRUE,
+                          hotcopy_notify, &last_rev, NULL, NULL, pool));
+  SVN_TEST_ASSERT(last_rev != SVN_INVALID_REVNUM - 1);
+  SVN_ERR(svn_fs_verify(dst, NULL, 0, MAX_REV, NULL, NULL, NULL, NULL,
+                        pool));
+
+  /* The copy must be equivalent to the source. */
+  SVN_ERR(svn_fs_open2(&fs, dst, NULL, pool, pool));
+  SVN_TEST_ASSERT(((fs_fs_data_t *)fs->fsap_data)->min_unpacked_rev
+                  == (MAX_REV + 1) / SHARD_SIZE * SHARD_SIZE);
+  SVN_ERR(svn_fs_youngest_rev(&youngest, fs, pool));
+  SVN_TEST_ASSERT(youngest == MAX_REV);
+
+  SVN_ERR(svn_fs_revision_root(&root, fs, MAX_REV, pool));
+  SVN_ERR(svn_test__get_file_contents(root, "iota", &contents, pool));
+  SVN_TEST_STRING_ASSERT(contents->data, get_rev_contents(MAX_REV, pool));
+
+  return SVN_NO_ERROR;
+}
+
+#undef REPO_NAME
+#undef SHARD_SIZE
+#undef MAX_REV
+
+/* ------------------------------------------------------------------------ */
+
+#define REPO_NAME "test-repo-read_mapped_packed_fs"
+#define SHARD_SIZE 4
+#define MAX_REV 13
+
+static svn_error_t *
+read_mapped_packed_fs(const svn_test_opts_t *opts,
+                      apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  svn_revnum_t rev;
+  apr_hash_t *fs_config;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+
+  SVN_ERR(create_packed_filesystem(REPO_NAME, opts, MAX_REV, SHARD_SIZE,
+                                   pool));
+
+  /* Use disjoint caches to make sure all data comes from the files. */
+  fs_config = apr_hash_make(pool);
+  svn_hash_sets(fs_config, SVN_FS_CONFIG_FSFS_CACHE_NS,
+                svn_uuid_generate(pool));
+  SVN_ERR(svn_fs_open2(&fs, REPO_NAME, fs_config, pool, pool));
+  ((fs_fs_data_t *)fs->fsap_data)->mmap_packed_files = TRUE;
+
+  /* Packed and non-packed revisions must read the same. */
+  for (rev = MAX_REV; rev > 1; --rev)
+    {
+      svn_fs_root_t *root;
+      svn_stringbuf_t *contents;
+
+      svn_pool_clear(iterpool);
+
+      SVN_ERR(svn_fs_revision_root(&root, fs, rev, iterpool));
+      SVN_ERR(svn_test__get_file_contents(root, "iota", &contents,
+                                          iterpool));
+      SVN_TEST_STRING_ASSERT(contents->data, get_rev_contents(rev, iterpool));
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+#undef REPO_NAME
+#undef SHARD_SIZE
+#undef MAX_REV
+
+
+/* ------------------------------------------------------------------------ */
+
+#define REPO_NAME "test-repo-forward_stored_windows"
+
+static svn_error_t *
+forward_stored_windows(const svn_test_opts_t *opts,
+                       apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *root;
+  svn_fs_root_t *root1;
+  svn_fs_root_t *root2;
+  svn_revnum_t rev;
+  svn_stringbuf_t *contents1;
+  svn_stringbuf_t *contents2;
+  apr_hash_t *fs_config;
+  int version;
+  apr_size_t i;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+
+  if (strcmp(opts->fs_type, "fsfs") != 0)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL, NULL);
+
+  SVN_ERR(svn_test__create_fs(&fs, REPO_NAME, opts, pool));
+
+  /* Construct contents larger than 2 txdelta windows. */
+  contents1 = svn_stringbuf_create("0123456789abcdef\n", pool);
+  while (contents1->len <= 2 * 102400)
+    svn_stringbuf_appendstr(contents1, contents1);
+
+  /* Revision 1: create the file. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+  SVN_ERR(svn_fs_make_file(root, "f", pool));
+  SVN_ERR(svn_test__set_file_contents(root, "f", contents1->data, pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+
+  /* Revision 2: change it in a few places.  It will be stored as a delta
+   * against revision 1. */
+  contents2 = svn_stringbuf_dup(contents1, pool);
+  for (i = 0; i < contents2->len; i += 50000)
+    contents2->data[i] = 'X';
+
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 1, pool));
+  SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+  SVN_ERR(svn_test__set_file_contents(root, "f", contents2->data, pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+
+  /* Use disjoint caches to make sure the windows come from the files. */
+  fs_config = apr_hash_make(pool);
+  svn_hash_sets(fs_config, SVN_FS_CONFIG_FSFS_CACHE_NS,
+                svn_uuid_generate(pool));
+  SVN_ERR(svn_fs_open2(&fs, REPO_NAME, fs_config, pool, pool));
+  SVN_ERR(svn_fs_revision_root(&root1, fs, 1, pool));
+  SVN_ERR(svn_fs_revision_root(&root2, fs, 2, pool));
+
+  /* Whether the stored windows match the encoder's svndiff version or
+   * not, the encoded delta must reconstruct the target. */
+  for (version = 0; version <= 2; ++version)
+    {
+      svn_txdelta_stream_t *delta_stream;
+      svn_txdelta_window_handler_t apply_handler, encoder;
+      void *apply_baton, *encoder_baton;
+      svn_stream_t *source;
+      svn_stream_t *svndiff;
+      svn_stringbuf_t *result;
+
+      svn_pool_clear(iterpool);
+      result = svn_stringbuf_create_empty(iterpool);
+
+      SVN_ERR(svn_fs_file_contents(&source, root1, "f", iterpool));
+      svn_txdelta_apply(source, svn_stream_from_stringbuf(result, iterpool),
+                        NULL, NULL, iterpool, &apply_handler, &apply_baton);
+      svndiff = svn_txdelta_parse_svndiff(apply_handler, apply_baton, TRUE,
+                                          iterpool);
+      svn_txdelta_to_svndiff3(&encoder, &encoder_baton, svndiff, version,
+                              SVN_DELTA_COMPRESSION_LEVEL_DEFAULT, iterpool);
+
+      SVN_ERR(svn_fs_get_file_delta_stream(&delta_stream, root1, "f",
+                                           root2, "f", iterpool));
+      SVN_ERR(svn_txdelta_send_txstream(delta_stream, encoder, encoder_baton,
+                                        iterpool));
+
+      SVN_TEST_ASSERT(svn_stringbuf_compare(result, contents2));
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+#undef REPO_NAME
+
+
+/* ------------------------------------------------------------------------ */
+
+#define REPO_NAME "test-repo-commit_out_of_date_txn"
+
+static svn_error_t *
+commit_out_of_date_txn(const svn_test_opts_t *opts,
+                       apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn1, *txn2;
+  svn_fs_root_t *root;
+  svn_revnum_t rev;
+  svn_error_t *err;
+  svn_stringbuf_t *contents;
+
+  if (strcmp(opts->fs_type, "fsfs") != 0)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL, NULL);
+
+  SVN_ERR(svn_test__create_fs(&fs, REPO_NAME, opts, pool));
+
+  /* Two concurrent txns modifying different nodes. */
+  SVN_ERR(svn_fs_begin_txn(&txn1, fs, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&root, txn1, pool));
+  SVN_ERR(svn_fs_make_dir(root, "A", pool));
+  SVN_ERR(svn_fs_make_file(root, "A/f", pool));
+  SVN_ERR(svn_test__set_file_contents(root, "A/f", "f1", pool));
+
+  SVN_ERR(svn_fs_begin_txn(&txn2, fs, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&root, txn2, pool));
+  SVN_ERR(svn_fs_make_dir(root, "B", pool));
+  SVN_ERR(svn_fs_make_file(root, "B/g", pool));
+  SVN_ERR(svn_test__set_file_contents(root, "B/g", "g1", pool));
+
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn1, pool));
+  SVN_TEST_ASSERT(rev == 1);
+
+  /* The final revision data for TXN2 gets written speculatively as r1,
+     which is already taken.  That must fail without damaging TXN2. */
+  err = svn_fs_fs__commit(&rev, fs, txn2, NULL, NULL, pool);
+  SVN_TEST_ASSERT_ERROR(err, SVN_ERR_FS_TXN_OUT_OF_DATE);
+
+  /* Merging and committing it must still work. */
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn2, pool));
+  SVN_TEST_ASSERT(rev == 2);
+
+  SVN_ERR(svn_fs_verify(REPO_NAME, NULL, 0, 2, NULL, NULL, NULL, NULL,
+                        pool));
+
+  SVN_ERR(svn_fs_revision_root(&root, fs, 2, pool));
+  SVN_ERR(svn_test__get_file_contents(root, "A/f", &contents, pool));
+  SVN_TEST_STRING_ASSERT(contents->data, "f1");
+  SVN_ERR(svn_test__get_file_contents(root, "B/g", &contents, pool));
+  SVN_TEST_STRING_ASSERT(contents->data, "g1");
+
+  return SVN_NO_ERROR;
+}
+
+#undef REPO_NAME
+
+
+/* ------------------------------------------------------------------------ */
+
+#define REPO_NAME "test-repo-group_commit"
+#define COMMITTERS 8
+
+#if APR_HAS_THREADS
+
+/* Baton for group_commit_worker(). */
+typedef struct group_commit_baton_t
+{
+  /* Directory to add. */
+  const char *dir;
+
+  /* Outcome of the commit. */
+  svn_revnum_t new_rev;
+  svn_error_t *err;
+} group_commit_baton_t;
+
+/* Thread function adding BATON->DIR with a file in it to REPO_NAME in
+   a commit of its own, using a separate filesystem object. */
+static void * APR_THREAD_FUNC
+group_commit_worker(apr_thread_t *tid,
+                    void *data)
+{
+  group_commit_baton_t *baton = data;
+  apr_pool_t *pool
+    = apr_allocator_owner_get(svn_pool_create_allocator(FALSE));
+  const char *path = apr_pstrcat(pool, baton->dir, "/file", SVN_VA_NULL);
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *root;
+
+  baton->err = svn_fs_open2(&fs, REPO_NAME, NULL, pool, pool);
+  if (!baton->err)
+    baton->err = svn_fs_begin_txn(&txn, fs, 0, pool);
+  if (!baton->err)
+    baton->err = svn_fs_txn_root(&root, txn, pool);
+  if (!baton->err)
+    baton->err = svn_fs_make_dir(root, baton->dir, pool);
+  if (!baton->err)
+    baton->err = svn_fs_make_file(root, path, pool);
+  if (!baton->err)
+    baton->err = svn_test__set_file_contents(root, path, baton->dir, pool);
+  if (!baton->err)
+    baton->err = svn_fs_commit_txn(NULL, &baton->new_rev, txn, pool);
+
+  svn_pool_destroy(pool);
+  apr_thread_exit(tid, 0);
+  return NULL;
+}
+
+#endif
+
+static svn_error_t *
+group_commit(const svn_test_opts_t *opts,
+             apr_pool_t *pool)
+{
+#if APR_HAS_THREADS
+  const char *conf = "\n[io]\ngroup-commit = true\n";
+  group_commit_baton_t batons[COMMITTERS];
+  apr_thread_t *threads[COMMITTERS];
+  svn_boolean_t seen[COMMITTERS + 1] = { FALSE };
+  apr_file_t *file;
+  svn_fs_t *fs;
+  svn_fs_root_t *root;
+  svn_revnum_t youngest;
+  apr_status_t status;
+  int i;
+
+  if (strcmp(opts->fs_type, "fsfs") != 0)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL, NULL);
+
+  SVN_ERR(svn_test__create_fs(&fs, REPO_NAME, opts, pool));
+
+  SVN_ERR(svn_io_file_open(&file,
+                           svn_dirent_join(REPO_NAME, "fsfs.conf", pool),
+                           APR_WRITE | APR_APPEND, APR_OS_DEFAULT, pool));
+  SVN_ERR(svn_io_file_write_full(file, conf, strlen(conf), NULL, pool));
+  SVN_ERR(svn_io_file_close(file, pool));
+
+  /* Concurrent commits, all based on r0 and all without conflicts. */
+  for (i = 0; i < COMMITTERS; ++i)
+    {
+      batons[i].dir = apr_psprintf(pool, "dir%d", i);
+      batons[i].new_rev = SVN_INVALID_REVNUM;
+      batons[i].err = SVN_NO_ERROR;
+
+      status = apr_thread_create(&threads[i], NULL, group_commit_worker,
+                                 &batons[i], pool);
+      if (status)
+        return svn_error_wrap_apr(status, "Can't create thread");
+    }
+
+  for (i = 0; i < COMMITTERS; ++i)
+    {
+      apr_status_t child_status;
+
+      status = apr_thread_join(&child_status, threads[i]);
+      if (status)
+        return svn_error_wrap_apr(status, "Can't join thread");
+    }
+
+  /* Each commit must have produced a revision of its own. */
+  for (i = 0; i < COMMITTERS; ++i)
+    {
+      SVN_ERR(batons[i].err);
+      SVN_TEST_ASSERT(   batons[i].new_rev > 0
+                      && batons[i].new_rev <= COMMITTERS);
+      SVN_TEST_ASSERT(!seen[batons[i].new_rev]);
+      seen[batons[i].new_rev] = TRUE;
+    }
+
+  /* ... and HEAD must contain all of them. */
+  SVN_ERR(svn_fs_open2(&fs, REPO_NAME, NULL, pool, pool));
+  SVN_ERR(svn_fs_youngest_rev(&youngest, fs, pool));
+  SVN_TEST_ASSERT(youngest == COMMITTERS);
+
+  SVN_ERR(svn_fs_revision_root(&root, fs, youngest, pool));
+  for (i = 0; i < COMMITTERS; ++i)
+    {
+      svn_stringbuf_t *contents;
+      const char *path = apr_pstrcat(pool, batons[i].dir, "/file",
+                                     SVN_VA_NULL);
+
+      SVN_ERR(svn_test__get_file_contents(root, path, &contents, pool));
+      SVN_TEST_STRING_ASSERT(contents->data, batons[i].dir);
+    }
+
+  SVN_ERR(svn_fs_verify(REPO_NAME, NULL, 0, youngest, NULL, NULL, NULL,
+                        NULL, pool));
+
+  return SVN_NO_ERROR;
+#else
+  return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL, "no thread support");
+#endif
+}
+
+#undef REPO_NAME
+#undef COMMITTERS
+
+/* ------------------------------------------------------------------------ */
+
+#define REPO_NAME "test-repo-rep_cache_filter"
+#define FILE_COUNT 1500
+
+/* Set *CHECKSUM to the SHA1 of the contents of the I-th file added in
+   revision REV.  Allocate the result in POOL. */
+static svn_error_t *
+filter_test_checksum(svn_checksum_t **checksum,
+                     svn_revnum_t rev,
+                     int i,
+                     apr_pool_t *pool)
+{
+  const char *contents = apr_psprintf(pool, "r%ld file %d", rev, i);
+
+  return svn_error_trace(svn_checksum(checksum, svn_checksum_sha1,
+                                      contents, strlen(contents), pool));
+}
+
+static svn_error_t *
+rep_cache_filter(const svn_test_opts_t *opts,
+                 apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  fs_fs_data_t *ffd;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *root;
+  svn_revnum_t rev, new_rev;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  int i;
+
+  if (strcmp(opts->fs_type, "fsfs") != 0)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL, NULL);
+
+  SVN_ERR(svn_test__create_fs(&fs, REPO_NAME, opts, pool));
+
+  ffd = fs->fsap_data;
+  if (ffd->format < SVN_FS_FS__MIN_REP_SHARING_FORMAT)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL, NULL);
+
+  /* Add enough files in r1 for the filter to be built during the commit
+     and more of them in r2, which extends the filter. */
+  for (rev = 1; rev <= 2; ++rev)
+    {
+      SVN_ERR(svn_fs_begin_txn(&txn, fs, rev - 1, pool));
+      SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+
+      for (i = 0; i < FILE_COUNT; ++i)
+        {
+          const char *path;
+
+          svn_pool_clear(iterpool);
+          path = apr_psprintf(iterpool, "r%ld-%d", rev, i);
+          SVN_ERR(svn_fs_make_file(root, path, iterpool));
+          SVN_ERR(svn_test__set_file_contents(root, path,
+                                              apr_psprintf(iterpool,
+                                                           "r%ld file %d",
+                                                           rev, i),
+                                              iterpool));
+        }
+
+      SVN_ERR(svn_fs_commit_txn(NULL, &new_rev, txn, pool));
+      SVN_TEST_ASSERT(new_rev == rev);
+    }
+
+  /* Look up all of them through a new FS instance, which shares the
+     filter, as well as checksums that must not be found. */
+  SVN_ERR(svn_fs_open2(&fs, REPO_NAME, NULL, pool, pool));
+  SVN_ERR(svn_fs_youngest_rev(&rev, fs, pool));
+  SVN_TEST_ASSERT(rev == 2);
+
+  for (rev = 1; rev <= 3; ++rev)
+    for (i = 0; i < FILE_COUNT; ++i)
+      {
+        svn_checksum_t *checksum;
+        representation_t *rep;
+
+        svn_pool_clear(iterpool);
+        SVN_ERR(filter_test_checksum(&checksum, rev, i, iterpool));
+        SVN_ERR(svn_fs_fs__get_rep_reference(&rep, fs, checksum, iterpool));
+
+        if (rev <= 2)
+          SVN_TEST_ASSERT(rep && rep->revision == rev);
+        else
+          SVN_TEST_ASSERT(rep == NULL);
+      }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+#undef REPO_NAME
+#undef FILE_COUNT
+
+/* ------------------------------------------------------------------------ */
+
+#define REPO_NAME "test-repo-rep_cache_batches"
+#define BATCH_SIZE 10
+
+/* Commit a new revision on top of *REV in FS, adding COUNT files.  Update
+   *REV.  Use POOL for temporary allocations. */
+static svn_error_t *
+commit_batch_files(svn_revnum_t *rev,
+                   svn_fs_t *fs,
+                   int count,
+                   apr_pool_t *pool)
+{
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *root;
+  int i;
+
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, *rev, pool));
+  SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+
+  for (i = 0; i < count; ++i)
+    {
+      const char *path = apr_psprintf(pool, "r%ld-%d", *rev + 1, i);
+
+      SVN_ERR(svn_fs_make_file(root, path, pool));
+      SVN_ERR(svn_test__set_file_contents(root, path,
+                                          apr_psprintf(pool, "r%ld file %d",
+                                                       *rev + 1, i),
+                                          pool));
+    }
+
+  return svn_error_trace(svn_fs_commit_txn(NULL, rev, txn, pool));
+}
+
+static svn_error_t *
+rep_cache_batches(const svn_test_opts_t *opts,
+                  apr_pool_t *pool)
+{
+  const char *conf = apr_psprintf(pool,
+                                  "\n[rep-sharing]\nrep-cache-wal = true\n"
+                                  "rep-cache-batch-size = %d\n", BATCH_SIZE);
+  apr_pool_t *subpool = svn_pool_create(pool);
+  svn_fs_t *fs, *fs2;
+  fs_fs_data_t *ffd;
+  apr_file_t *file;
+  svn_checksum_t *checksum;
+  representation_t *rep;
+  svn_node_kind_t kind;
+  svn_revnum_t rev = 0;
+
+  if (strcmp(opts->fs_type, "fsfs") != 0)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL, NULL);
+
+  SVN_ERR(svn_test__create_fs(&fs, REPO_NAME, opts, pool));
+
+  ffd = fs->fsap_data;
+  if (ffd->format < SVN_FS_FS__MIN_REP_SHARING_FORMAT)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL, NULL);
+
+  SVN_ERR(svn_io_file_open(&file,
+                           svn_dirent_join(REPO_NAME, "fsfs.conf", pool),
+                           APR_WRITE | APR_APPEND, APR_OS_DEFAULT, pool));
+  SVN_ERR(svn_io_file_write_full(file, conf, strlen(conf), NULL, pool));
+  SVN_ERR(svn_io_file_close(file, pool));
+
+  SVN_ERR(svn_fs_open2(&fs, REPO_NAME, NULL, subpool, subpool));
+  SVN_ERR(svn_fs_open2(&fs2, REPO_NAME, NULL, pool, pool));
+  ffd = fs->fsap_data;
+
+  /* A small commit only gets queued but is visible to FS itself. */
+  SVN_ERR(commit_batch_files(&rev, fs, 3, pool));
+  SVN_TEST_ASSERT(ffd->rep_queue && ffd->rep_queue->nelts == 3);
+
+  SVN_ERR(filter_test_checksum(&checksum, 1, 2, pool));
+  SVN_ERR(svn_fs_fs__get_rep_reference(&rep, fs, checksum, pool));
+  SVN_TEST_ASSERT(rep && rep->revision == 1);
+  SVN_ERR(svn_fs_fs__get_rep_reference(&rep, fs2, checksum, pool));
+  SVN_TEST_ASSERT(rep == NULL);
+
+  /* Filling the queue writes it. */
+  SVN_ERR(commit_batch_files(&rev, fs, BATCH_SIZE, pool));
+  SVN_TEST_ASSERT(ffd->rep_queue->nelts == 0);
+
+  SVN_ERR(svn_fs_fs__get_rep_reference(&rep, fs2, checksum, pool));
+  SVN_TEST_ASSERT(rep && rep->revision == 1);
+  SVN_ERR(svn_io_check_path(svn_dirent_join(REPO_NAME, "rep-cache.db-wal",
+                                            pool),
+                            &kind, pool));
+  SVN_TEST_ASSERT(kind == svn_node_file);
+
+  /* Closing FS writes whatever is left. */
+  SVN_ERR(commit_batch_files(&rev, fs, 1, pool));
+  SVN_TEST_ASSERT(ffd->rep_queue->nelts == 1);
+  svn_pool_destroy(subpool);
+
+  SVN_ERR(filter_test_checksum(&checksum, 3, 0, pool));
+  SVN_ERR(svn_fs_fs__get_rep_reference(&rep, fs2, checksum, pool));
+  SVN_TEST_ASSERT(rep && rep->revision == 3);
+
+  return SVN_NO_ERROR;
+}
+
+#undef REPO_NAME
+#undef BATCH_SIZE
+
+/* ------------------------------------------------------------------------ */
+
+#define REPO_NAME "test-repo-packed_revprop_reads"
+#define SHARD_SIZE 4
+#define MAX_REV 11
+
+/* Verify that the log message of every revision in FS matches the one
+   set by packed_revprop_reads.  REFRESH is being passed through to the
+   FS API.  Use POOL for allocations. */
+static svn_error_t *
+verify_packed_revprop_logs(svn_fs_t *fs,
+                           svn_boolean_t refresh,
+                           apr_pool_t *pool)
+{
+  svn_revnum_t rev;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+
+  for (rev = 0; rev <= MAX_REV; ++rev)
+    {
+      svn_string_t *value;
+      apr_hash_t *props;
+      apr_size_t len = (rev == 5 || rev == 9) ? 2000 : 800;
+
+      svn_pool_clear(iterpool);
+
+      SVN_ERR(svn_fs_revision_prop2(&value, fs, rev, SVN_PROP_REVISION_LOG,
+                                    refresh, iterpool, iterpool));
+      SVN_TEST_STRING_ASSERT(value->data,
+                             large_log(rev, len, iterpool)->data);
+
+      SVN_ERR(svn_fs_revision_proplist2(&props, fs, rev, refresh,
+                                        iterpool, iterpool));
+      value = svn_hash_gets(props, SVN_PROP_REVISION_LOG);
+      SVN_TEST_ASSERT(value);
+      SVN_TEST_STRING_ASSERT(value->data,
+                             large_log(rev, len, iterpool)->data);
+      SVN_TEST_ASSERT(svn_hash_gets(props, SVN_PROP_REVISION_DATE));
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+packed_revprop_reads(const svn_test_opts_t *opts,
+                     apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  svn_fs_t *fs2;
+  svn_revnum_t rev;
+
+  /* Create the packed FS and open a second instance of it. */
+  SVN_ERR(prepare_revprop_repo(&fs, REPO_NAME, MAX_REV, SHARD_SIZE, opts,
+                               pool));
+  SVN_ERR(svn_fs_open2(&fs2, REPO_NAME, NULL, pool, pool));
+
+  for (rev = 0; rev <= MAX_REV; ++rev)
+    SVN_ERR(svn_fs_change_rev_prop(fs, rev, SVN_PROP_REVISION_LOG,
+                                   large_log(rev, 800, pool),
+                                   pool));
+
+  /* Populate the caches of the other instance, including the manifests. */
+  SVN_ERR(verify_packed_revprop_logs(fs2, FALSE, pool));
+
+  /* Grow revprops in the middle of packs.  This splits them and changes
+   * their manifests behind the back of FS2. */
+  SVN_ERR(svn_fs_change_rev_prop(fs, 5, SVN_PROP_REVISION_LOG,
+                                 large_log(5, 2000, pool),
+                                 pool));
+  SVN_ERR(svn_fs_change_rev_prop(fs, 9, SVN_PROP_REVISION_LOG,
+                                 large_log(9, 2000, pool),
+                                 pool));
+
+  /* Reading single revprops directly from the packs as well as through
+   * the caches must give the latest contents. */
+  SVN_ERR(verify_packed_revprop_logs(fs, TRUE, pool));
+  SVN_ERR(verify_packed_revprop_logs(fs, FALSE, pool));
+  SVN_ERR(verify_packed_revprop_logs(fs2, TRUE, pool));
+  SVN_ERR(verify_packed_revprop_logs(fs2, FALSE, pool));
+
+  return SVN_NO_ERROR;
+}
+
+#undef REPO_NAME
+#undef SHARD_SIZE
+#undef MAX_REV
+
+/* ------------------------------------------------------------------------ */
+
+#define REPO_NAME "test-repo-revprop_generation"
+#define SHARD_SIZE 4
+#define MAX_REV 7
+
+/* Assert that the log message of REV in FS is EXPECTED after refreshing
+   the revprops.  Use POOL for allocations. */
+static svn_error_t *
+check_refreshed_log(svn_fs_t *fs,
+                    svn_revnum_t rev,
+                    svn_string_t *expected,
+                    apr_pool_t *pool)
+{
+  svn_string_t *value;
+
+  SVN_ERR(svn_fs_refresh_revision_props(fs, pool));
+  SVN_ERR(svn_fs_revision_prop2(&value, fs, rev, SVN_PROP_REVISION_LOG,
+                                FALSE, pool, pool));
+  SVN_TEST_STRING_ASSERT(value->data, expected->data);
+
+  SVN_ERR(svn_fs_revision_prop2(&value, fs, rev, SVN_PROP_REVISION_LOG,
+                                TRUE, pool, pool));
+  SVN_TEST_STRING_ASSERT(value->data, expected->data);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+revprop_generation(const svn_test_opts_t *opts,
+                   apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  svn_fs_t *fs2;
+  svn_fs_t *fs3;
+  svn_revnum_t rev;
+  svn_node_kind_t kind;
+  apr_hash_t *fs_config = apr_hash_make(pool);
+  fs_fs_data_t *ffd;
+
+  SVN_ERR(prepare_revprop_repo(&fs, REPO_NAME, MAX_REV, SHARD_SIZE, opts,
+                               pool));
+  SVN_ERR(svn_fs_open2(&fs2, REPO_NAME, NULL, pool, pool));
+
+  /* Revprop caches are bound to the revprop generation by default. */
+  ffd = fs2->fsap_data;
+  SVN_TEST_ASSERT(ffd->use_revprop_generation);
+  SVN_ERR(svn_io_check_path(svn_fs_fs__path_revprop_counter(fs, pool),
+                            &kind, pool));
+  SVN_TEST_ASSERT(kind == svn_node_file);
+
+  /* Fill the caches. */
+  for (rev = 0; rev <= MAX_REV + 1; ++rev)
+    SVN_ERR(svn_fs_change_rev_prop(fs, rev, SVN_PROP_REVISION_LOG,
+                                   default_log(rev, pool), pool));
+  for (rev = 0; rev <= MAX_REV + 1; ++rev)
+    SVN_ERR(check_refreshed_log(fs2, rev, default_log(rev, pool), pool));
+
+  /* Changes made through FS must be visible through FS2 after the next
+   * sync barrier - for packed and non-packed revprops. */
+  SVN_ERR(svn_fs_change_rev_prop(fs, 2, SVN_PROP_REVISION_LOG,
+                                 large_log(2, 100, pool), pool));
+  SVN_ERR(check_refreshed_log(fs2, 2, large_log(2, 100, pool), pool));
+
+  SVN_ERR(svn_fs_change_rev_prop(fs, MAX_REV + 1, SVN_PROP_REVISION_LOG,
+                                 large_log(MAX_REV + 1, 100, pool), pool));
+  SVN_ERR(check_refreshed_log(fs2, MAX_REV + 1,
+                              large_log(MAX_REV + 1, 100, pool), pool));
+
+  /* While a change is in progress, reading still works. */
+  SVN_ERR(svn_fs_fs__begin_revprop_change(fs, pool));
+  SVN_ERR(check_refreshed_log(fs2, 2, large_log(2, 100, pool), pool));
+  SVN_ERR(svn_fs_fs__end_revprop_change(fs, pool));
+  SVN_ERR(check_refreshed_log(fs2, 2, large_log(2, 100, pool), pool));
+
+  /* Same with generations disabled. */
+  svn_hash_sets(fs_config, SVN_FS_CONFIG_FSFS_CACHE_REVPROPS, "0");
+  SVN_ERR(svn_fs_open2(&fs3, REPO_NAME, fs_config, pool, pool));
+  ffd = fs3->fsap_data;
+  SVN_TEST_ASSERT(!ffd->use_revprop_generation);
+
+  SVN_ERR(check_refreshed_log(fs3, 2, large_log(2, 100, pool), pool));
+  SVN_ERR(svn_fs_change_rev_prop(fs, 2, SVN_PROP_REVISION_LOG,
+                                 large_log(2, 200, pool), pool));
+  SVN_ERR(check_refreshed_log(fs3, 2, large_log(2, 200, pool), pool));
+  SVN_ERR(check_refreshed_log(fs2, 2, large_log(2, 200, pool), pool));
+
+  return SVN_NO_ERROR;
+}
+
+#undef REPO_NAME
+#undef SHARD_SIZE
+#undef MAX_REV
+
+
+/* ------------------------------------------------------------------------ */
+
+#define REPO_NAME "test-repo-paths_changed_range"
+#define SHARD_SIZE 4
+#define MAX_REV 9
+
+/* Baton type for compare_changes. */
+typedef struct compare_changes_baton_t
+{
+  svn_fs_t *fs;
+  svn_revnum_t next_rev;
+  int step;
+} compare_changes_baton_t;
+
+/* Implement svn_fs_paths_changed_receiver_t.  Verify that ITERATOR
+   reports the same changes as svn_fs_paths_changed3 for REVISION and
+   that REVISION is the one expected next by BATON. */
+static svn_error_t *
+compare_changes(void *baton,
+                svn_revnum_t revision,
+                svn_fs_path_change_iterator_t *iterator,
+                apr_pool_t *scratch_pool)
+{
+  compare_changes_baton_t *b = baton;
+  svn_fs_root_t *root;
+  svn_fs_path_change_iterator_t *expected_iterator;
+  svn_fs_path_change3_t *change;
+  apr_hash_t *expected = apr_hash_make(scratch_pool);
+
+  SVN_TEST_ASSERT(revision == b->next_rev);
+  b->next_rev += b->step;
+
+  SVN_ERR(svn_fs_revision_root(&root, b->fs, revision, scratch_pool));
+  SVN_ERR(svn_fs_paths_changed3(&expected_iterator, root, scratch_pool,
+                                scratch_pool));
+  SVN_ERR(svn_fs_path_change_get(&change, expected_iterator));
+  while (change)
+    {
+      svn_hash_sets(expected, apr_pstrdup(scratch_pool, change->path.data),
+                    svn_fs_path_change3_dup(change, scratch_pool));
+      SVN_ERR(svn_fs_path_change_get(&change, expected_iterator));
+    }
+
+  SVN_ERR(svn_fs_path_change_get(&change, iterator));
+  while (change)
+    {
+      svn_fs_path_change3_t *expected_change
+        = svn_hash_gets(expected, change->path.data);
+
+      SVN_TEST_ASSERT(expected_change);
+      SVN_TEST_ASSERT(expected_change->change_kind == change->change_kind);
+      svn_hash_sets(expected, change->path.data, NULL);
+
+      SVN_ERR(svn_fs_path_change_get(&change, iterator));
+    }
+
+  SVN_TEST_ASSERT(apr_hash_count(expected) == 0);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+paths_changed_range(const svn_test_opts_t *opts,
+                    apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  compare_changes_baton_t baton;
+
+  /* Mix packed and non-packed revisions. */
+  SVN_ERR(prepare_revprop_repo(&fs, REPO_NAME, MAX_REV, SHARD_SIZE, opts,
+                               pool));
+  baton.fs = fs;
+
+  /* Ascending. */
+  baton.next_rev = 0;
+  baton.step = 1;
+  SVN_ERR(svn_fs_paths_changed_range(fs, 0, MAX_REV + 1, compare_changes,
+                                     &baton, NULL, NULL, pool));
+  SVN_TEST_ASSERT(baton.next_rev == MAX_REV + 2);
+
+  /* Descending, starting and ending in the middle of shards. */
+  baton.next_rev = MAX_REV;
+  baton.step = -1;
+  SVN_ERR(svn_fs_paths_changed_range(fs, MAX_REV, 2, compare_changes,
+                                     &baton, NULL, NULL, pool));
+  SVN_TEST_ASSERT(baton.next_rev == 1);
+
+  /* Single revision. */
+  baton.next_rev = 5;
+  baton.step = 1;
+  SVN_ERR(svn_fs_paths_changed_range(fs, 5, 5, compare_changes,
+                                     &baton, NULL, NULL, pool));
+  SVN_TEST_ASSERT(baton.next_rev == 6);
+
+  /* Invalid range. */
+  SVN_TEST_ASSERT_ERROR(svn_fs_paths_changed_range(fs, 0, MAX_REV + 2,
+                                                   compare_changes, &baton,
+                                                   NULL, NULL, pool),
+                        SVN_ERR_FS_NO_SUCH_REVISION);
+
+  return SVN_NO_ERROR;
+}
+
+#undef REPO_NAME
+#undef SHARD_SIZE
+#undef MAX_REV
+
+/* ------------------------------------------------------------------------ */
+
+#define REPO_NAME "test-repo-large_delta_windows"
+
+/* Return LEN bytes of printable, pseudo-random text generated from SEED. */
+static svn_stringbuf_t *
+random_text(apr_size_t len, apr_uint32_t seed, apr_pool_t *pool)
+{
+  svn_stringbuf_t *text = svn_stringbuf_create_ensure(len, pool);
+  apr_size_t i;
+
+  for (i = 0; i < len; i++)
+    svn_stringbuf_appendbyte(text, (char)('a' + svn_test_rand(&seed) % 26));
+
+  return text;
+}
+
+static svn_error_t *
+large_delta_windows(const svn_test_opts_t *opts,
+                    apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  fs_fs_data_t *ffd;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *root, *root1, *root2;
+  svn_revnum_t rev;
+  svn_stringbuf_t *contents1, *contents2, *insert, *result, *format;
+  svn_txdelta_stream_t *delta_stream;
+  svn_txdelta_window_handler_t apply_handler, encoder;
+  void *apply_baton, *encoder_baton;
+  svn_stream_t *source, *svndiff;
+  apr_hash_t *fs_config = apr_hash_make(pool);
+  apr_finfo_t finfo;
+
+  if (strcmp(opts->fs_type, "fsfs") != 0)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL, NULL);
+
+  if (opts->server_minor_version && (opts->server_minor_version < 11))
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "pre-1.11 SVN doesn't support svndiff3");
+
+  svn_hash_sets(fs_config, SVN_FS_CONFIG_FSFS_LARGE_DELTA_WINDOWS, "true");
+  SVN_ERR(svn_test__create_fs2(&fs, REPO_NAME, opts, fs_config, pool));
+  ffd = fs->fsap_data;
+  SVN_TEST_ASSERT(ffd->large_delta_windows);
+
+  /* The format file must tell older releases to stay away. */
+  SVN_ERR(svn_stringbuf_from_file2(&format,
+                                   svn_dirent_join(REPO_NAME, "db/format",
+                                                   pool),
+                                   pool));
+  SVN_TEST_ASSERT(strstr(format->data, "deltas large-windows\n"));
+
+  /* Revision 1: a file much larger than a large window. */
+  contents1 = random_text(3 * 1024 * 1024, 1, pool);
+
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+  SVN_ERR(svn_fs_make_file(root, "f", pool));
+  SVN_ERR(svn_test__set_file_contents(root, "f", contents1->data, pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+
+  /* Revision 2: insert a block that shifts the data by more than
+   * a standard window. */
+  insert = random_text(200 * 1024, 2, pool);
+  contents2 = svn_stringbuf_dup(contents1, pool);
+  svn_stringbuf_insert(contents2, 100, insert->data, insert->len);
+
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 1, pool));
+  SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+  SVN_ERR(svn_test__set_file_contents(root, "f", contents2->data, pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+
+  /* Only the inserted block should have been stored. */
+  SVN_ERR(svn_io_stat(&finfo, svn_fs_fs__path_rev_absolute(fs, rev, pool),
+                      APR_FINFO_SIZE, pool));
+  SVN_TEST_ASSERT(finfo.size < 2 * insert->len);
+
+  /* Read the contents back from disk, using disjoint caches. */
+  fs_config = apr_hash_make(pool);
+  svn_hash_sets(fs_config, SVN_FS_CONFIG_FSFS_CACHE_NS,
+                svn_uuid_generate(pool));
+  SVN_ERR(svn_fs_open2(&fs, REPO_NAME, fs_config, pool, pool));
+  SVN_ERR(svn_fs_revision_root(&root1, fs, 1, pool));
+  SVN_ERR(svn_fs_revision_root(&root2, fs, 2, pool));
+
+  SVN_ERR(svn_test__get_file_contents(root2, "f", &result, pool));
+  SVN_TEST_ASSERT(svn_stringbuf_compare(result, contents2));
+
+  /* Deltas handed out must still be encodable as svndiff0. */
+  result = svn_stringbuf_create_empty(pool);
+  SVN_ERR(svn_fs_file_contents(&source, root1, "f", pool));
+  svn_txdelta_apply(source, svn_stream_from_stringbuf(result, pool),
+                    NULL, NULL, pool, &apply_handler, &apply_baton);
+  svndiff = svn_txdelta_parse_svndiff(apply_handler, apply_baton, TRUE,
+                                      pool);
+  svn_txdelta_to_svndiff3(&encoder, &encoder_baton, svndiff, 0,
+                          SVN_DELTA_COMPRESSION_LEVEL_NONE, pool);
+  SVN_ERR(svn_fs_get_file_delta_stream(&delta_stream, root1, "f",
+                                       root2, "f", pool));
+  SVN_ERR(svn_txdelta_send_txstream(delta_stream, encoder, encoder_baton,
+                                    pool));
+  SVN_TEST_ASSERT(svn_stringbuf_compare(result, contents2));
+
+  return SVN_NO_ERROR;
+}
+
+#undef REPO_NAME
+
+/* ------------------------------------------------------------------------ */
+
+#define REPO_NAME "test-repo-chunked_reps"
+
+static svn_error_t *
+chunked_reps(const svn_test_opts_t *opts,
+             apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  fs_fs_data_t *ffd;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *root;
+  svn_revnum_t rev;
+  svn_stringbuf_t *contents1, *contents2, *result, *format;
+  const svn_fs_id_t *id;
+  node_revision_t *noderev;
+  apr_array_header_t *chunks;
+  apr_hash_t *fs_config = apr_hash_make(pool);
+  apr_finfo_t finfo;
+
+  if (strcmp(opts->fs_type, "fsfs") != 0)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL, NULL);
+
+  if (opts->server_minor_version && (opts->server_minor_version < 11))
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "pre-1.11 SVN doesn't support chunked reps");
+
+  /* r0 .. r2 will form a complete shard that we can pack. */
+  svn_hash_sets(fs_config, SVN_FS_CONFIG_FSFS_SHARD_SIZE, "3");
+  svn_hash_sets(fs_config, SVN_FS_CONFIG_FSFS_CHUNKED_REPS, "true");
+  SVN_ERR(svn_test__create_fs2(&fs, REPO_NAME, opts, fs_config, pool));
+  ffd = fs->fsap_data;
+  SVN_TEST_ASSERT(ffd->chunked_reps);
+
+  /* The format file must tell older releases to stay away. */
+  SVN_ERR(svn_stringbuf_from_file2(&format,
+                                   svn_dirent_join(REPO_NAME, "db/format",
+                                                   pool),
+                                   pool));
+  SVN_TEST_ASSERT(strstr(format->data, "reps chunked\n"));
+
+  /* Revision 1: a file above the default chunking threshold. */
+  contents1 = random_text(6 * 1024 * 1024, 1, pool);
+
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+  SVN_ERR(svn_fs_make_file(root, "f", pool));
+  SVN_ERR(svn_test__set_file_contents(root, "f", contents1->data, pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+
+  /* Revision 2: the same file with a few bytes inserted up front. */
+  contents2 = svn_stringbuf_dup(contents1, pool);
+  svn_stringbuf_insert(contents2, 10, "inserted", 8);
+
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 1, pool));
+  SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+  SVN_ERR(svn_test__set_file_contents(root, "f", contents2->data, pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+
+  /* All but the first chunk should have been shared with r1. */
+  SVN_ERR(svn_io_stat(&finfo, svn_fs_fs__path_rev_absolute(fs, rev, pool),
+                      APR_FINFO_SIZE, pool));
+  SVN_TEST_ASSERT(finfo.size < 2 * SVN_FS_FS__CHUNKED_REP_MIN_THRESHOLD);
+
+  /* Read the contents back from disk, using disjoint caches. */
+  fs_config = apr_hash_make(pool);
+  svn_hash_sets(fs_config, SVN_FS_CONFIG_FSFS_CACHE_NS,
+                svn_uuid_generate(pool));
+  SVN_ERR(svn_fs_open2(&fs, REPO_NAME, fs_config, pool, pool));
+  SVN_ERR(svn_fs_revision_root(&root, fs, 2, pool));
+
+  SVN_ERR(svn_test__get_file_contents(root, "f", &result, pool));
+  SVN_TEST_ASSERT(svn_stringbuf_compare(result, contents2));
+
+  SVN_ERR(svn_fs_node_id(&id, root, "f", pool));
+  SVN_ERR(svn_fs_fs__get_node_revision(&noderev, fs, id, pool, pool));
+  SVN_ERR(svn_fs_fs__get_rep_chunks(&chunks, fs, noderev->data_rep,
+                                    pool, pool));
+  SVN_TEST_ASSERT(chunks && chunks->nelts > 1);
+
+  SVN_ERR(svn_fs_revision_root(&root, fs, 1, pool));
+  SVN_ERR(svn_test__get_file_contents(root, "f", &result, pool));
+  SVN_TEST_ASSERT(svn_stringbuf_compare(result, contents1));
+
+  /* Packing must keep the chunks that only the chunk lists refer to. */
+  SVN_ERR(svn_fs_pack(REPO_NAME, NULL, NULL, NULL, NULL, pool));
+  SVN_ERR(svn_fs_open2(&fs, REPO_NAME, NULL, pool, pool));
+  SVN_ERR(svn_fs_revision_root(&root, fs, 2, pool));
+  SVN_ERR(svn_test__get_file_contents(root, "f", &result, pool));
+  SVN_TEST_ASSERT(svn_stringbuf_compare(result, contents2));
+
+  return SVN_NO_ERROR;
+}
+
+#undef REPO_NAME
+
+/* ------------------------------------------------------------------------ */
+
+#define REPO_NAME "test-repo-indexed_dirs"
+
+static svn_error_t *
+indexed_dirs(const svn_test_opts_t *opts,
+             apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  fs_fs_data_t *ffd;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *root;
+  svn_revnum_t rev;
+  svn_stringbuf_t *format;
+  svn_node_kind_t kind;
+  const svn_fs_id_t *id;
+  node_revision_t *noderev;
+  apr_array_header_t *blocks, *names;
+  apr_hash_t *entries;
+  apr_hash_t *fs_config = apr_hash_make(pool);
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  int i, reused;
+
+  if (strcmp(opts->fs_type, "fsfs") != 0)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL, NULL);
+
+  if (opts->server_minor_version && (opts->server_minor_version < 11))
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "pre-1.11 SVN doesn't support indexed dirs");
+
+  /* r0 .. r2 will form a complete shard that we can pack. */
+  svn_hash_sets(fs_config, SVN_FS_CONFIG_FSFS_SHARD_SIZE, "3");
+  svn_hash_sets(fs_config, SVN_FS_CONFIG_FSFS_INDEXED_DIRS, "true");
+  SVN_ERR(svn_test__create_fs2(&fs, REPO_NAME, opts, fs_config, pool));
+  ffd = fs->fsap_data;
+  SVN_TEST_ASSERT(ffd->indexed_dirs);
+
+  /* The format file must tell older releases to stay away. */
+  SVN_ERR(svn_stringbuf_from_file2(&format,
+                                   svn_dirent_join(REPO_NAME, "db/format",
+                                                   pool),
+                                   pool));
+  SVN_TEST_ASSERT(strstr(format->data, "dirs indexed\n"));
+
+  /* Revision 1: a directory well above the indexing threshold. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+  SVN_ERR(svn_fs_make_dir(root, "big", pool));
+  for (i = 0; i < 10000; ++i)
+    {
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_fs_make_file(root,
+                               apr_psprintf(iterpool, "big/file-%05d", i),
+                               iterpool));
+    }
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+
+  /* Revision 2: add a single entry. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 1, pool));
+  SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+  SVN_ERR(svn_fs_make_file(root, "big/file-05000x", pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+
+  /* Read the directory back from disk, using disjoint caches. */
+  fs_config = apr_hash_make(pool);
+  svn_hash_sets(fs_config, SVN_FS_CONFIG_FSFS_CACHE_NS,
+                svn_uuid_generate(pool));
+  SVN_ERR(svn_fs_open2(&fs, REPO_NAME, fs_config, pool, pool));
+  SVN_ERR(svn_fs_revision_root(&root, fs, 2, pool));
+
+  /* Only the block that received the new entry should have changed. */
+  SVN_ERR(svn_fs_node_id(&id, root, "big", pool));
+  SVN_ERR(svn_fs_fs__get_node_revision(&noderev, fs, id, pool, pool));
+  SVN_ERR(svn_fs_fs__get_dir_index(&blocks, &names, fs, noderev->data_rep,
+                                   pool, pool));
+  SVN_TEST_ASSERT(blocks && blocks->nelts > 2);
+  SVN_TEST_STRING_ASSERT(APR_ARRAY_IDX(names, 0, const char *),
+                         "file-00000");
+
+  for (i = 0, reused = 0; i < blocks->nelts; ++i)
+    if (APR_ARRAY_IDX(blocks, i, representation_t *)->revision == 1)
+      ++reused;
+  SVN_TEST_ASSERT(reused >= blocks->nelts - 2);
+
+  /* Single-entry lookups. */
+  SVN_ERR(svn_fs_check_path(&kind, root, "big/file-00000", pool));
+  SVN_TEST_ASSERT(kind == svn_node_file);
+  SVN_ERR(svn_fs_check_path(&kind, root, "big/file-05000x", pool));
+  SVN_TEST_ASSERT(kind == svn_node_file);
+  SVN_ERR(svn_fs_check_path(&kind, root, "big/file-09999", pool));
+  SVN_TEST_ASSERT(kind == svn_node_file);
+  SVN_ERR(svn_fs_check_path(&kind, root, "big/a", pool));
+  SVN_TEST_ASSERT(kind == svn_node_none);
+  SVN_ERR(svn_fs_check_path(&kind, root, "big/file-10000", pool));
+  SVN_TEST_ASSERT(kind == svn_node_none);
+
+  /* Full listings. */
+  SVN_ERR(svn_fs_dir_entries(&entries, root, "big", pool));
+  SVN_TEST_ASSERT(apr_hash_count(entries) == 10001);
+
+  SVN_ERR(svn_fs_revision_root(&root, fs, 1, pool));
+  SVN_ERR(svn_fs_dir_entries(&entries, root, "big", pool));
+  SVN_TEST_ASSERT(apr_hash_count(entries) == 10000);
+
+  /* Packing must keep the blocks that only the indexes refer to. */
+  SVN_ERR(svn_fs_pack(REPO_NAME, NULL, NULL, NULL, NULL, pool));
+  SVN_ERR(svn_fs_open2(&fs, REPO_NAME, NULL, pool, pool));
+  SVN_ERR(svn_fs_revision_root(&root, fs, 2, pool));
+  SVN_ERR(svn_fs_check_path(&kind, root, "big/file-07777", pool));
+  SVN_TEST_ASSERT(kind == svn_node_file);
+  SVN_ERR(svn_fs_dir_entries(&entries, root, "big", pool));
+  SVN_TEST_ASSERT(apr_hash_count(entries) == 10001);
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+#undef REPO_NAME
+
+/* ------------------------------------------------------------------------ */
+
+#define REPO_NAME "test-repo-staged_txns"
+
+/* Set *EXISTS to whether the file NAME exists in the directory of
+   transaction TXN.  Use POOL for allocations. */
+static svn_error_t *
+txn_file_exists(svn_boolean_t *exists,
+                svn_fs_txn_t *txn,
+                const char *name,
+                apr_pool_t *pool)
+{
+  svn_node_kind_t kind;
+  const char *txn_dir = svn_fs_fs__path_txn_dir(txn->fs,
+                                                svn_fs_fs__txn_get_id(txn),
+                                                pool);
+
+  SVN_ERR(svn_io_check_path(svn_dirent_join(txn_dir, name, pool), &kind,
+                            pool));
+  *exists = kind == svn_node_file;
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+staged_txns(const svn_test_opts_t *opts,
+            apr_pool_t *pool)
+{
+  const char *conf = "\n[io]\ntxn-staging-size = 16\n";
+  svn_fs_t *fs, *fs2;
+  svn_fs_txn_t *txn, *txn2;
+  svn_fs_root_t *root;
+  svn_revnum_t rev;
+  svn_boolean_t exists;
+  svn_stringbuf_t *contents;
+  apr_hash_t *changes;
+  apr_file_t *file;
+  const char *txn_name;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  int i;
+
+  if (strcmp(opts->fs_type, "fsfs") != 0)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL, NULL);
+
+  SVN_ERR(svn_test__create_fs(&fs, REPO_NAME, opts, pool));
+
+  SVN_ERR(svn_io_file_open(&file,
+                           svn_dirent_join(REPO_NAME, "fsfs.conf", pool),
+                           APR_WRITE | APR_APPEND, APR_OS_DEFAULT, pool));
+  SVN_ERR(svn_io_file_write_full(file, conf, strlen(conf), NULL, pool));
+  SVN_ERR(svn_io_file_close(file, pool));
+  SVN_ERR(svn_fs_open2(&fs, REPO_NAME, NULL, pool, pool));
+
+  /* A small commit never touches the txn directory with its noderevs. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+  SVN_ERR(svn_fs_make_file(root, "version", pool));
+  SVN_ERR(svn_test__set_file_contents(root, "version", "1.0\n", pool));
+
+  SVN_ERR(txn_file_exists(&exists, txn, "changes", pool));
+  SVN_TEST_ASSERT(!exists);
+  SVN_ERR(txn_file_exists(&exists, txn, "node.0.0", pool));
+  SVN_TEST_ASSERT(!exists);
+
+  /* Other svn_fs_t of the same process see the staged data. */
+  SVN_ERR(svn_fs_txn_name(&txn_name, txn, pool));
+  SVN_ERR(svn_fs_open2(&fs2, REPO_NAME, NULL, pool, pool));
+  SVN_ERR(svn_fs_open_txn(&txn2, fs2, txn_name, pool));
+  SVN_ERR(svn_fs_txn_root(&root, txn2, pool));
+  SVN_ERR(svn_fs_paths_changed2(&changes, root, pool));
+  SVN_TEST_ASSERT(apr_hash_count(changes) == 1);
+  SVN_ERR(svn_test__get_file_contents(root, "version", &contents, pool));
+  SVN_TEST_STRING_ASSERT(contents->data, "1.0\n");
+
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+  SVN_TEST_ASSERT(rev == 1);
+
+  /* Flushing makes the txn available to other processes. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 1, pool));
+  SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+  SVN_ERR(svn_test__set_file_contents(root, "version", "1.1\n", pool));
+  SVN_ERR(svn_fs__flush_txn(txn, pool));
+
+  SVN_ERR(txn_file_exists(&exists, txn, "changes", pool));
+  SVN_TEST_ASSERT(exists);
+  SVN_ERR(txn_file_exists(&exists, txn, "node.0.0", pool));
+  SVN_TEST_ASSERT(exists);
+
+  SVN_ERR(svn_test__set_file_contents(root, "version", "1.2\n", pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+  SVN_TEST_ASSERT(rev == 2);
+
+  /* Large transactions spill over to disk. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 2, pool));
+  SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+  for (i = 0; i < 200; ++i)
+    {
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_fs_make_file(root, apr_psprintf(iterpool, "file-%03d", i),
+                               iterpool));
+    }
+
+  SVN_ERR(txn_file_exists(&exists, txn, "changes", pool));
+  SVN_TEST_ASSERT(exists);
+
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+  SVN_TEST_ASSERT(rev == 3);
+
+  /* Verify the results from disk, using disjoint caches. */
+  SVN_ERR(svn_fs_open2(&fs, REPO_NAME, NULL, pool, pool));
+  SVN_ERR(svn_fs_revision_root(&root, fs, 1, pool));
+  SVN_ERR(svn_test__get_file_contents(root, "version", &contents, pool));
+  SVN_TEST_STRING_ASSERT(contents->data, "1.0\n");
+  SVN_ERR(svn_fs_revision_root(&root, fs, 3, pool));
+  SVN_ERR(svn_test__get_file_contents(root, "version", &contents, pool));
+  SVN_TEST_STRING_ASSERT(contents->data, "1.2\n");
+  SVN_ERR(svn_fs_paths_changed2(&changes, root, pool));
+  SVN_TEST_ASSERT(apr_hash_count(changes) == 200);
+  SVN_ERR(svn_fs_verify(REPO_NAME, NULL, 0, SVN_INVALID_REVNUM, NULL, NULL,
+                        NULL, NULL, pool));
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+#undef REPO_NAME
+
+/* ------------------------------------------------------------------------ */
+
+#define REPO_NAME "test-repo-sampled_delta_bases"
+
+static svn_error_t *
+sampled_delta_bases(const svn_test_opts_t *opts,
+                    apr_pool_t *pool)
+{
+  const char *conf = "\n[deltification]\nsample-delta-bases = true\n";
+  const char *old_contents = random_text(20000, 1, pool)->data;
+  const char *new_contents = random_text(20000, 2, pool)->data;
+  const char *reverted = apr_pstrcat(pool, old_contents, "x", SVN_VA_NULL);
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *root;
+  svn_revnum_t rev;
+  apr_file_t *file;
+  const svn_fs_id_t *id;
+  node_revision_t *noderev;
+  svn_stringbuf_t *contents;
+
+  if (strcmp(opts->fs_type, "fsfs") != 0)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL, NULL);
+
+  if (opts->server_minor_version && (opts->server_minor_version < 8))
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "pre-1.8 SVN doesn't support deltification "
+                            "options");
+
+  SVN_ERR(svn_test__create_fs(&fs, REPO_NAME, opts, pool));
+
+  SVN_ERR(svn_io_file_open(&file,
+                           svn_dirent_join(REPO_NAME, "fsfs.conf", pool),
+                           APR_WRITE | APR_APPEND, APR_OS_DEFAULT, pool));
+  SVN_ERR(svn_io_file_write_full(file, conf, strlen(conf), NULL, pool));
+  SVN_ERR(svn_io_file_close(file, pool));
+  SVN_ERR(svn_fs_open2(&fs, REPO_NAME, NULL, pool, pool));
+
+  /* r1 and r2 have unrelated contents, r3 goes back to the r1 state. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+  SVN_ERR(svn_fs_make_file(root, "file", pool));
+  SVN_ERR(svn_test__set_file_contents(root, "file", old_contents, pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 1, pool));
+  SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+  SVN_ERR(svn_test__set_file_contents(root, "file", new_contents, pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 2, pool));
+  SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+  SVN_ERR(svn_test__set_file_contents(root, "file", reverted, pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+
+  /* The standard choice would have been r2.  Only r1 gives a tiny delta. */
+  SVN_ERR(svn_fs_revision_root(&root, fs, rev, pool));
+  SVN_ERR(svn_fs_node_id(&id, root, "file", pool));
+  SVN_ERR(svn_fs_fs__get_node_revision(&noderev, fs, id, pool, pool));
+  SVN_TEST_ASSERT(noderev->data_rep->size < 1000);
+
+  SVN_ERR(svn_test__get_file_contents(root, "file", &contents, pool));
+  SVN_TEST_STRING_ASSERT(contents->data, reverted);
+
+  return SVN_NO_ERROR;
+}
+
+#undef REPO_NAME
+
+/* ------------------------------------------------------------------------ */
+
+#define REPO_NAME "test-repo-ancestor_skip_pointers"
+
+/* Set *NODEREV to the node-revision of PATH in REVISION of FS. */
+static svn_error_t *
+get_noderev(node_revision_t **noderev,
+            svn_fs_t *fs,
+            svn_revnum_t revision,
+            const char *path,
+            apr_pool_t *pool)
+{
+  svn_fs_root_t *root;
+  const svn_fs_id_t *id;
+
+  SVN_ERR(svn_fs_revision_root(&root, fs, revision, pool));
+  SVN_ERR(svn_fs_node_id(&id, root, path, pool));
+  SVN_ERR(svn_fs_fs__get_node_revision(noderev, fs, id, pool, pool));
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+ancestor_skip_pointers(const svn_test_opts_t *opts,
+                       apr_pool_t *pool)
+{
+  const char *conf = "\n[deltification]\nancestor-skip-pointers = true\n";
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *root;
+  svn_revnum_t rev;
+  apr_file_t *file;
+  node_revision_t *noderev, *ancestor;
+  svn_stringbuf_t *contents;
+  apr_hash_t *fs_config;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  int i;
+
+  if (strcmp(opts->fs_type, "fsfs") != 0)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL, NULL);
+
+  if (opts->server_minor_version && (opts->server_minor_version < 8))
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "pre-1.8 SVN doesn't support deltification "
+                            "options");
+
+  SVN_ERR(svn_test__create_fs(&fs, REPO_NAME, opts, pool));
+
+  SVN_ERR(svn_io_file_open(&file,
+                           svn_dirent_join(REPO_NAME, "fsfs.conf", pool),
+                           APR_WRITE | APR_APPEND, APR_OS_DEFAULT, pool));
+  SVN_ERR(svn_io_file_write_full(file, conf, strlen(conf), NULL, pool));
+  SVN_ERR(svn_io_file_close(file, pool));
+  SVN_ERR(svn_fs_open2(&fs, REPO_NAME, NULL, pool, pool));
+
+  /* r1 adds the file, r2 .. r33 give it predecessor counts 1 .. 32. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+  SVN_ERR(svn_fs_make_file(root, "file", pool));
+  SVN_ERR(svn_test__set_file_contents(root, "file", "r1", pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+
+  for (i = 2; i <= 33; ++i)
+    {
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_fs_begin_txn(&txn, fs, rev, iterpool));
+      SVN_ERR(svn_fs_txn_root(&root, txn, iterpool));
+      SVN_ERR(svn_test__set_file_contents(root, "file",
+                                          apr_psprintf(iterpool, "r%d", i),
+                                          iterpool));
+      SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, iterpool));
+    }
+  svn_pool_destroy(iterpool);
+
+  /* Read the node-revs back from disk, using disjoint caches. */
+  fs_config = apr_hash_make(pool);
+  svn_hash_sets(fs_config, SVN_FS_CONFIG_FSFS_CACHE_NS,
+                svn_uuid_generate(pool));
+  SVN_ERR(svn_fs_open2(&fs, REPO_NAME, fs_config, pool, pool));
+
+  /* Count 8 points to count 0, count 12 to count 8 and odd counts to
+   * their immediate predecessor, i.e. nothing gets recorded. */
+  SVN_ERR(get_noderev(&noderev, fs, 9, "/file", pool));
+  SVN_TEST_ASSERT(noderev->predecessor_count == 8);
+  SVN_TEST_ASSERT(noderev->skip_id);
+  SVN_TEST_ASSERT(svn_fs_fs__id_rev(noderev->skip_id) == 1);
+
+  SVN_ERR(get_noderev(&noderev, fs, 13, "/file", pool));
+  SVN_TEST_ASSERT(noderev->skip_id);
+  SVN_TEST_ASSERT(svn_fs_fs__id_rev(noderev->skip_id) == 9);
+
+  SVN_ERR(get_noderev(&noderev, fs, 14, "/file", pool));
+  SVN_TEST_ASSERT(noderev->skip_id == NULL);
+
+  /* Walking to arbitrary ancestors must find the right ones. */
+  SVN_ERR(get_noderev(&noderev, fs, 33, "/file", pool));
+  for (i = 0; i <= 32; ++i)
+    {
+      SVN_ERR(svn_fs_fs__get_ancestor(&ancestor, fs, noderev, i, pool,
+                                      pool));
+      SVN_TEST_ASSERT(ancestor->predecessor_count == i);
+      SVN_TEST_ASSERT(svn_fs_fs__id_rev(ancestor->id) == i + 1);
+    }
+
+  /* The data is unaffected. */
+  SVN_ERR(svn_fs_revision_root(&root, fs, 33, pool));
+  SVN_ERR(svn_test__get_file_contents(root, "file", &contents, pool));
+  SVN_TEST_STRING_ASSERT(contents->data, "r33");
+
+  return SVN_NO_ERROR;
+}
+
+#undef REPO_NAME
+
+/* ------------------------------------------------------------------------ */
+
+#define REPO_NAME "test-repo-zstd_compression"
+
+static svn_error_t *
+zstd_compression(const svn_test_opts_t *opts,
+                 apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  fs_fs_data_t *ffd;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *root;
+  svn_revnum_t rev;
+  svn_stringbuf_t *contents, *result, *format, *rev_file;
+  apr_hash_t *fs_config = apr_hash_make(pool);
+
+  if (strcmp(opts->fs_type, "fsfs") != 0)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL, NULL);
+
+  if (opts->server_minor_version && (opts->server_minor_version < 11))
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "pre-1.11 SVN doesn't support svndiff4");
+
+  if (!svn_zstd__compiled_version())
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "Zstandard support has not been compiled in");
+
+  svn_hash_sets(fs_config, SVN_FS_CONFIG_FSFS_ZSTD_COMPRESSION, "true");
+  SVN_ERR(svn_test__create_fs2(&fs, REPO_NAME, opts, fs_config, pool));
+  ffd = fs->fsap_data;
+  SVN_TEST_ASSERT(ffd->zstd_compression);
+  SVN_TEST_ASSERT(ffd->delta_compression_type == compression_type_zstd);
+
+  /* The format file must tell older releases to stay away. */
+  SVN_ERR(svn_stringbuf_from_file2(&format,
+                                   svn_dirent_join(REPO_NAME, "db/format",
+                                                   pool),
+                                   pool));
+  SVN_TEST_ASSERT(strstr(format->data, "compression zstd\n"));
+
+  /* Revision 1: a well compressible file. */
+  contents = random_text(256 * 1024, 1, pool);
+
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+  SVN_ERR(svn_fs_make_file(root, "f", pool));
+  SVN_ERR(svn_test__set_file_contents(root, "f", contents->data, pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+
+  /* The contents must have been stored as compressed svndiff4.  They are
+   * the first item in the revision file. */
+  SVN_ERR(svn_stringbuf_from_file2(&rev_file,
+                                   svn_fs_fs__path_rev_absolute(fs, rev,
+                                                                pool),
+                                   pool));
+  SVN_TEST_ASSERT(rev_file->len < contents->len);
+  SVN_TEST_ASSERT(memcmp(rev_file->data, "DELTA\nSVN\4", 10) == 0);
+
+  /* Read the contents back from disk, using disjoint caches. */
+  fs_config = apr_hash_make(pool);
+  svn_hash_sets(fs_config, SVN_FS_CONFIG_FSFS_CACHE_NS,
+                svn_uuid_generate(pool));
+  SVN_ERR(svn_fs_open2(&fs, REPO_NAME, fs_config, pool, pool));
+  SVN_ERR(svn_fs_revision_root(&root, fs, rev, pool));
+
+  SVN_ERR(svn_test__get_file_contents(root, "f", &result, pool));
+  SVN_TEST_ASSERT(svn_stringbuf_compare(result, contents));
+
+  return SVN_NO_ERROR;
+}
+
+#undef REPO_NAME
+
+/* ------------------------------------------------------------------------ */
+
+#define REPO_NAME "test-repo-item_offsets"
+#define SHARD_SIZE 4
+#define MAX_REV 10
+
+/* Check that svn_fs_fs__item_offsets returns the same offsets as
+ * svn_fs_fs__item_offset for all items of the COUNT revisions starting
+ * at START in FS. */
+static svn_error_t *
+check_item_offsets(svn_fs_t *fs,
+                   svn_revnum_t start,
+                   int count,
+                   apr_pool_t *pool)
+{
+  svn_fs_fs__revision_file_t *rev_file;
+  apr_array_header_t *max_ids = NULL;
+  apr_array_header_t *items = apr_array_make(pool, 16,
+                                             sizeof(svn_fs_fs__id_part_t));
+  apr_array_header_t *offsets;
+  int i;
+
+  SVN_ERR(svn_fs_fs__open_pack_or_rev_file(&rev_file, fs, start, pool,
+                                           pool));
+  if (svn_fs_fs__use_log_addressing(fs))
+    SVN_ERR(svn_fs_fs__l2p_get_max_ids(&max_ids, fs, start, count, pool,
+                                       pool));
+
+  /* Request the items in reverse order, so they must get sorted. */
+  for (i = count - 1; i >= 0; --i)
+    {
+      apr_uint64_t k = max_ids ? APR_ARRAY_IDX(max_ids, i, apr_uint64_t)
+                               : 10;
+      while (k-- > 0)
+        {
+          svn_fs_fs__id_part_t *item = apr_array_push(items);
+          item->revision = start + i;
+          item->number = k;
+        }
+    }
+
+  SVN_ERR(svn_fs_fs__item_offsets(&offsets, fs, rev_file, items, TRUE,
+                                  pool, pool));
+  SVN_TEST_ASSERT(offsets->nelts == items->nelts);
+
+  for (i = 0; i < items->nelts; ++i)
+    {
+      const svn_fs_fs__id_part_t *item
+        = &APR_ARRAY_IDX(items, i, svn_fs_fs__id_part_t);
+      apr_off_t offset;
+
+      SVN_ERR(svn_fs_fs__item_offset(&offset, fs, rev_file, item->revision,
+                                     NULL, item->number, pool));
+      SVN_TEST_ASSERT(offset == APR_ARRAY_IDX(offsets, i, apr_off_t));
+    }
+
+  return svn_error_trace(svn_fs_fs__close_revision_file(rev_file));
+}
+
+static svn_error_t *
+item_offsets(const svn_test_opts_t *opts,
+             apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+
+  if (strcmp(opts->fs_type, "fsfs") != 0)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL, NULL);
+
+  SVN_ERR(create_packed_filesystem(REPO_NAME, opts, MAX_REV, SHARD_SIZE,
+                                   pool));
+  SVN_ERR(svn_fs_open2(&fs, REPO_NAME, NULL, pool, pool));
+
+  /* A packed shard and a single revision. */
+  SVN_ERR(check_item_offsets(fs, SHARD_SIZE, SHARD_SIZE, pool));
+  SVN_ERR(check_item_offsets(fs, MAX_REV, 1, pool));
+
+  return SVN_NO_ERROR;
+}
+
+#undef REPO_NAME
+#undef SHARD_SIZE
+#undef MAX_REV
+
+/* ------------------------------------------------------------------------ */
+
+#define REPO_NAME "test-repo-shared_pack_mappings"
+#define SHARD_SIZE 4
+#define MAX_REV 10
+
+/* Open the pack file containing REVISION through a new svn_fs_t for the
+ * repository at REPO_NAME that maps pack files into memory.  Return it in
+ * *REV_FILE and the svn_fs_t in *FS.  Allocate both in POOL. */
+static svn_error_t *
+open_mapped_pack(svn_fs_fs__revision_file_t **rev_file,
+                 svn_fs_t **fs,
+                 svn_revnum_t revision,
+                 apr_pool_t *pool)
+{
+  SVN_ERR(svn_fs_open2(fs, REPO_NAME, NULL, pool, pool));
+  ((fs_fs_data_t *)(*fs)->fsap_data)->mmap_packed_files = TRUE;
+
+  return svn_error_trace(svn_fs_fs__open_pack_or_rev_file(rev_file, *fs,
+                                                          revision, pool,
+                                                          pool));
+}
+
+static svn_error_t *
+shared_pack_mappings(const svn_test_opts_t *opts,
+                     apr_pool_t *pool)
+{
+  svn_fs_t *fs1, *fs2;
+  svn_fs_fs__revision_file_t *file1, *file2;
+  svn_revnum_t rev;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+
+  if (strcmp(opts->fs_type, "fsfs") != 0)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL, NULL);
+
+  SVN_ERR(create_packed_filesystem(REPO_NAME, opts, MAX_REV, SHARD_SIZE,
+                                   pool));
+
+  /* Both instances must use the same mapping of the same pack file. */
+  SVN_ERR(open_mapped_pack(&file1, &fs1, 1, pool));
+  SVN_ERR(open_mapped_pack(&file2, &fs2, 2, pool));
+  SVN_TEST_ASSERT(file1->is_packed && file2->is_packed);
+  SVN_TEST_ASSERT(file1->mapped_data == file2->mapped_data);
+  SVN_TEST_ASSERT(file1->mapped_size == file2->mapped_size);
+
+  /* The footer read through one of them is known to the other. */
+  if (svn_fs_fs__use_log_addressing(fs1))
+    {
+      SVN_ERR(svn_fs_fs__auto_read_footer(file1));
+      SVN_ERR(svn_fs_fs__close_revision_file(file2));
+      SVN_ERR(svn_fs_fs__open_pack_or_rev_file(&file2, fs2, 3, pool, pool));
+      SVN_ERR(svn_fs_fs__auto_read_footer(file2));
+      SVN_TEST_ASSERT(file1->l2p_offset == file2->l2p_offset);
+      SVN_TEST_ASSERT(file1->p2l_offset == file2->p2l_offset);
+      SVN_TEST_ASSERT(file1->footer_offset == file2->footer_offset);
+    }
+
+  SVN_ERR(svn_fs_fs__close_revision_file(file1));
+  SVN_ERR(svn_fs_fs__close_revision_file(file2));
+
+  /* Contents read through the shared mappings must be correct. */
+  for (rev = MAX_REV; rev > 1; --rev)
+    {
+      svn_fs_root_t *root;
+      svn_stringbuf_t *contents;
+
+      svn_pool_clear(iterpool);
+
+      SVN_ERR(svn_fs_revision_root(&root, rev % 2 ? fs1 : fs2, rev,
+                                   iterpool));
+      SVN_ERR(svn_test__get_file_contents(root, "iota", &contents,
+                                          iterpool));
+      SVN_TEST_STRING_ASSERT(contents->data, get_rev_contents(rev, iterpool));
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+#undef REPO_NAME
+#undef SHARD_SIZE
+#undef MAX_REV
+
+/* ------------------------------------------------------------------------ */
+
+#define REPO_NAME "test-repo-shared_youngest"
+
+/* Create an FSFS repository at PATH whose processes share the youngest
+   revision through files in SHARED_DIR.  Add a directory in r1 through
+   one svn_fs_t and check that a second instance opened beforehand sees
+   it.  Use POOL for allocations. */
+static svn_error_t *
+commit_with_shared_youngest(const char *path,
+                            const char *shared_dir,
+                            const svn_test_opts_t *opts,
+                            apr_pool_t *pool)
+{
+  const char *conf = apr_psprintf(pool, "\n[io]\nshared-youngest-dir = %s\n",
+                                  shared_dir);
+  apr_file_t *file;
+  svn_fs_t *fs1, *fs2;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root;
+  svn_revnum_t youngest;
+
+  SVN_ERR(svn_test__create_fs(&fs1, path, opts, pool));
+
+  SVN_ERR(svn_io_file_open(&file,
+                           svn_dirent_join(path, "fsfs.conf", pool),
+                           APR_WRITE | APR_APPEND, APR_OS_DEFAULT, pool));
+  SVN_ERR(svn_io_file_write_full(file, conf, strlen(conf), NULL, pool));
+  SVN_ERR(svn_io_file_close(file, pool));
+
+  SVN_ERR(svn_fs_open2(&fs1, path, NULL, pool, pool));
+  SVN_ERR(svn_fs_open2(&fs2, path, NULL, pool, pool));
+
+  SVN_ERR(svn_fs_youngest_rev(&youngest, fs2, pool));
+  SVN_TEST_ASSERT(youngest == 0);
+
+  SVN_ERR(svn_fs_begin_txn2(&txn, fs1, 0, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_fs_make_dir(txn_root, "A", pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &youngest, txn, pool));
+  SVN_TEST_ASSERT(youngest == 1);
+
+  SVN_ERR(svn_fs_youngest_rev(&youngest, fs2, pool));
+  SVN_TEST_ASSERT(youngest == 1);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+shared_youngest(const svn_test_opts_t *opts,
+                apr_pool_t *pool)
+{
+  const char *shared_dir;
+  const char *name;
+  apr_hash_t *dirents;
+  svn_stringbuf_t *contents;
+  svn_atomic_t published;
+
+  if (strcmp(opts->fs_type, "fsfs") != 0)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL, NULL);
+
+  SVN_ERR(svn_dirent_get_absolute(&shared_dir, REPO_NAME "-shared", pool));
+  SVN_ERR(svn_io_remove_dir2(shared_dir, TRUE, NULL, NULL, pool));
+  SVN_ERR(svn_io_make_dir_recursively(shared_dir, pool));
+  svn_test_add_dir_cleanup(shared_dir);
+
+  SVN_ERR(commit_with_shared_youngest(REPO_NAME, shared_dir, opts, pool));
+
+  /* The repository's single shared file must hold the new HEAD. */
+  SVN_ERR(svn_io_get_dirents3(&dirents, shared_dir, TRUE, pool, pool));
+  SVN_TEST_INT_ASSERT(apr_hash_count(dirents), 1);
+  name = apr_hash_this_key(apr_hash_first(pool, dirents));
+  SVN_ERR(svn_stringbuf_from_file2(&contents,
+                                   svn_dirent_join(shared_dir, name, pool),
+                                   pool));
+  SVN_TEST_ASSERT(contents->len == sizeof(published));
+  memcpy(&published, contents->data, sizeof(published));
+  SVN_TEST_INT_ASSERT(published, 2);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+shared_youngest_fallback(const svn_test_opts_t *opts,
+                         apr_pool_t *pool)
+{
+  const char *shared_dir;
+  svn_node_kind_t kind;
+
+  if (strcmp(opts->fs_type, "fsfs") != 0)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL, NULL);
+
+  /* The shared file can't be created in a missing directory.  All
+     instances must then read 'current' instead. */
+  SVN_ERR(svn_dirent_get_absolute(&shared_dir, REPO_NAME "-missing", pool));
+  SVN_ERR(svn_io_remove_dir2(shared_dir, TRUE, NULL, NULL, pool));
+
+  SVN_ERR(commit_with_shared_youngest(REPO_NAME "-fallback", shared_dir,
+                                      opts, pool));
+
+  SVN_ERR(svn_io_check_path(shared_dir, &kind, pool));
+  SVN_TEST_ASSERT(kind == svn_node_none);
+
+  return SVN_NO_ERROR;
+}
+
+#undef REPO_NAME
+
+/* ------------------------------------------------------------------------ */
+
+#define REPO_NAME "test-repo-shared_dag_nodes"
+
+/* Create a repository at PATH with the Greek tree in r1, whose 'iota'
+   has the given CONTENTS.  Return the repository in *FS.  Use POOL for
+   allocations. */
+static svn_error_t *
+create_greek_repo(svn_fs_t **fs,
+                  const char *path,
+                  const char *contents,
+                  const svn_test_opts_t *opts,
+                  apr_pool_t *pool)
+{
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root;
+  svn_revnum_t rev;
+
+  SVN_ERR(svn_test__create_fs(fs, path, opts, pool));
+  SVN_ERR(svn_fs_begin_txn2(&txn, *fs, 0, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_test__create_greek_tree(txn_root, pool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "iota", contents, pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+  SVN_TEST_ASSERT(rev == 1);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+shared_dag_nodes(const svn_test_opts_t *opts,
+                 apr_pool_t *pool)
+{
+  svn_fs_t *fs1, *fs2;
+  svn_fs_root_t *root1, *root2;
+  const svn_fs_id_t *id1, *id2;
+  dag_node_t *node;
+  svn_stringbuf_t *contents;
+
+  if (strcmp(opts->fs_type, "fsfs") != 0)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL, NULL);
+
+  SVN_ERR(create_greek_repo(&fs1, REPO_NAME, "shared iota\n", opts, pool));
+  SVN_ERR(svn_fs_open2(&fs1, REPO_NAME, NULL, pool, pool));
+  SVN_ERR(svn_fs_open2(&fs2, REPO_NAME, NULL, pool, pool));
+
+  /* Nothing has been looked up yet. */
+  SVN_ERR(svn_fs_fs__shared_dag_cache_lookup(&node, fs2, 1, "/A/B/E/alpha",
+                                             pool));
+  SVN_TEST_ASSERT(node == NULL);
+
+  /* Walking the path through one instance makes its nodes known to the
+     other one, without tying them to either. */
+  SVN_ERR(svn_fs_revision_root(&root1, fs1, 1, pool));
+  SVN_ERR(svn_fs_node_id(&id1, root1, "A/B/E/alpha", pool));
+
+  SVN_ERR(svn_fs_fs__shared_dag_cache_lookup(&node, fs2, 1, "/A/B/E/alpha",
+                                             pool));
+  SVN_TEST_ASSERT(node != NULL);
+  SVN_TEST_ASSERT(svn_fs_fs__dag_get_fs(node) == NULL);
+  SVN_TEST_ASSERT(svn_fs_fs__id_eq(svn_fs_fs__dag_get_id(node), id1));
+
+  /* The other instance gets the node for its own use. */
+  SVN_ERR(svn_fs_revision_root(&root2, fs2, 1, pool));
+  SVN_ERR(svn_fs_node_id(&id2, root2, "A/B/E/alpha", pool));
+  SVN_TEST_ASSERT(svn_fs_fs__id_eq(id1, id2));
+  SVN_ERR(svn_test__get_file_contents(root2, "A/B/E/alpha", &contents,
+                                      pool));
+  SVN_TEST_STRING_ASSERT(contents->data, "This is the file 'alpha'.\n");
+  SVN_ERR(svn_test__get_file_contents(root2, "iota", &contents, pool));
+  SVN_TEST_STRING_ASSERT(contents->data, "shared iota\n");
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+shared_dag_nodes_replaced(const svn_test_opts_t *opts,
+                          apr_pool_t *pool)
+{
+  svn_fs_t *fs, *old_fs;
+  svn_fs_root_t *root;
+  svn_stringbuf_t *contents;
+  dag_node_t *node;
+  const char *uuid;
+
+  if (strcmp(opts->fs_type, "fsfs") != 0)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL, NULL);
+
+  /* Fill the shared cache for r1 of the original repository. */
+  SVN_ERR(create_greek_repo(&old_fs, REPO_NAME "-replaced", "old iota\n",
+                            opts, pool));
+  SVN_ERR(svn_fs_open2(&old_fs, REPO_NAME "-replaced", NULL, pool, pool));
+  SVN_ERR(svn_fs_get_uuid(old_fs, &uuid, pool));
+  SVN_ERR(svn_fs_revision_root(&root, old_fs, 1, pool));
+  SVN_ERR(svn_test__get_file_contents(root, "iota", &contents, pool));
+  SVN_TEST_STRING_ASSERT(contents->data, "old iota\n");
+
+  SVN_ERR(svn_fs_fs__shared_dag_cache_lookup(&node, old_fs, 1, "/iota",
+                                             pool));
+  SVN_TEST_ASSERT(node != NULL);
+
+  /* Replace it the way a dump / load cycle would: Same path, same UUID
+     and different contents in r1.  Only the instance ID changes. */
+  SVN_ERR(svn_io_remove_dir2(REPO_NAME "-replaced", FALSE, NULL, NULL,
+                             pool));
+  SVN_ERR(create_greek_repo(&fs, REPO_NAME "-replaced", "new iota\n", opts,
+                            pool));
+  SVN_ERR(svn_fs_set_uuid(fs, uuid, pool));
+
+  SVN_ERR(svn_fs_open2(&fs, REPO_NAME "-replaced", NULL, pool, pool));
+  SVN_ERR(svn_fs_fs__shared_dag_cache_lookup(&node, fs, 1, "/iota", pool));
+  SVN_TEST_ASSERT(node == NULL);
+
+  SVN_ERR(svn_fs_revision_root(&root, fs, 1, pool));
+  SVN_ERR(svn_test__get_file_contents(root, "iota", &contents, pool));
+  SVN_TEST_STRING_ASSERT(contents->data, "new iota\n");
+
+  return SVN_NO_ERROR;
+}
+
+#undef REPO_NAME
+
+
 /* The test table.  */
 
 static int max_threads = 4;
@@ -1942,6 +4160,56 @@ static struct svn_test_descriptor_t test_funcs[] =
                        "pack with limited memory for metadata"),
     SVN_TEST_OPTS_PASS(large_delta_against_plain,
                        "large deltas against PLAIN, issue #4658"),
+    SVN_TEST_OPTS_PASS(prefetch_delta_chain,
+                       "read delta chains in file order"),
+    SVN_TEST_OPTS_PASS(pack_in_parallel,
+                       "pack shards in parallel"),
+    SVN_TEST_OPTS_PASS(hotcopy_in_parallel,
+                       "hotcopy shards in parallel"),
+    SVN_TEST_OPTS_PASS(read_mapped_packed_fs,
+                       "read from memory-mapped pack files"),
+    SVN_TEST_OPTS_PASS(forward_stored_windows,
+                       "forward stored svndiff windows verbatim"),
+    SVN_TEST_OPTS_PASS(commit_out_of_date_txn,
+                       "retry commit after speculative write failed"),
+    SVN_TEST_OPTS_PASS(group_commit,
+                       "concurrent commits with group commit enabled"),
+    SVN_TEST_OPTS_PASS(rep_cache_filter,
+                       "rep-cache lookups through the in-memory filter"),
+    SVN_TEST_OPTS_PASS(packed_revprop_reads,
+                       "read single revprops from packs"),
+    SVN_TEST_OPTS_PASS(revprop_generation,
+                       "share revprop caches across sync barriers"),
+    SVN_TEST_OPTS_PASS(paths_changed_range,
+                       "changed paths lists for revision ranges"),
+    SVN_TEST_OPTS_PASS(large_delta_windows,
+                       "store svndiff3 deltas with large windows"),
+    SVN_TEST_OPTS_PASS(chunked_reps,
+                       "store large files as shared chunks"),
+    SVN_TEST_OPTS_PASS(indexed_dirs,
+                       "store large directories as indexed blocks"),
+    SVN_TEST_OPTS_PASS(staged_txns,
+                       "stage small transactions in memory"),
+    SVN_TEST_OPTS_PASS(sampled_delta_bases,
+                       "pick delta bases by sampling delta sizes"),
+    SVN_TEST_OPTS_PASS(ancestor_skip_pointers,
+                       "walk node history through skip-list pointers"),
+    SVN_TEST_OPTS_PASS(zstd_compression,
+                       "compress deltas with Zstandard"),
+    SVN_TEST_OPTS_PASS(item_offsets,
+                       "look up many item offsets at once"),
+    SVN_TEST_OPTS_PASS(shared_pack_mappings,
+                       "share pack file mappings between instances"),
+    SVN_TEST_OPTS_PASS(rep_cache_batches,
+                       "queue rep-cache writes in batches"),
+    SVN_TEST_OPTS_PASS(shared_youngest,
+                       "share the youngest revision between instances"),
+    SVN_TEST_OPTS_PASS(shared_youngest_fallback,
+                       "read 'current' if youngest can't be shared"),
+    SVN_TEST_OPTS_PASS(shared_dag_nodes,
+                       "share revision DAG nodes between instances"),
+    SVN_TEST_OPTS_PASS(shared_dag_nodes_replaced,
+                       "no stale DAG nodes from a replaced repository"),
     SVN_TEST_NULL
   };
 
@@ -32,6 +32,7 @@
 
 #include "private/svn_string_private.h"
 #include "private/svn_fs_fs_private.h"
+#include "private/svn_fs_private.h"
 #include "private/svn_subr_private.h"
 
 #include "../../libsvn_fs_fs/index.h"
@@ -211,8 +212,8 @@ get_repo_stats(const svn_test_opts_t *opts,
   SVN_ERR(create_greek_repo(&repos, &rev, opts, REPO_NAME, pool, pool));
 
   /* Gather statistics info on that repo. */
-  SVN_ERR(svn_fs_fs__get_stats(&stats, svn_repos_fs(repos), NULL, NULL,
-                               NULL, NULL, pool, pool));
+  SVN_ERR(svn_fs_fs__get_stats(&stats, svn_repos_fs(repos), 1, NULL, NULL,
+                               NULL, NULL, NULL, NULL, pool, pool));
 
   /* Check that the stats make sense. */
   SVN_TEST_ASSERT(stats->total_size > 1000 && stats->total_size < 10000);
@@ -262,6 +263,116 @@ get_repo_stats(const svn_test_opts_t *opts,
   SVN_ERR(verify_histogram(&extension_info->rep_histogram));
   SVN_ERR(verify_histogram(&extension_info->node_histogram));
 
+  /* Every rep has a delta chain of at least 1. */
+  SVN_TEST_ASSERT(stats->total_rep_stats.chain_len_histogram.total.count
+                  == stats->total_rep_stats.total.count);
+  SVN_TEST_ASSERT(stats->total_rep_stats.chain_len_histogram.total.sum
+                  == stats->total_rep_stats.chain_len);
+
+  return SVN_NO_ERROR;
+}
+
+#undef REPO_NAME
+
+/* ------------------------------------------------------------------------ */
+
+#define REPO_NAME "test-repo-get-repo-stats-parallel-test"
+
+/* Implements svn_fs_fs__open_fs_func_t.  BATON is the FS path. */
+static svn_error_t *
+open_fs_instance(svn_fs_t **fs,
+                 void *baton,
+                 apr_pool_t *result_pool)
+{
+  return svn_error_trace(svn_fs_open2(fs, baton, NULL, result_pool,
+                                      result_pool));
+}
+
+/* Compare the basic fields of LHS and RHS. */
+static svn_error_t *
+compare_rep_stats(const svn_fs_fs__representation_stats_t *lhs,
+                  const svn_fs_fs__representation_stats_t *rhs)
+{
+  SVN_TEST_ASSERT(lhs->total.count == rhs->total.count);
+  SVN_TEST_ASSERT(lhs->total.packed_size == rhs->total.packed_size);
+  SVN_TEST_ASSERT(lhs->total.expanded_size == rhs->total.expanded_size);
+  SVN_TEST_ASSERT(lhs->total.overhead_size == rhs->total.overhead_size);
+  SVN_TEST_ASSERT(lhs->shared.count == rhs->shared.count);
+  SVN_TEST_ASSERT(lhs->references == rhs->references);
+  SVN_TEST_ASSERT(lhs->expanded_size == rhs->expanded_size);
+  SVN_TEST_ASSERT(lhs->chain_len == rhs->chain_len);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+get_repo_stats_parallel(const svn_test_opts_t *opts,
+                        apr_pool_t *pool)
+{
+  svn_repos_t *repos;
+  svn_revnum_t rev;
+  svn_fs_t *fs;
+  apr_size_t i;
+  svn_fs_fs__stats_t *stats, *parallel_stats;
+
+  /* Bail (with success) on known-untestable scenarios */
+  if (strcmp(opts->fs_type, "fsfs") != 0)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "this will test FSFS repositories only");
+
+  /* Create a filesystem with a few more revisions. */
+  SVN_ERR(create_greek_repo(&repos, &rev, opts, REPO_NAME, pool, pool));
+  fs = svn_repos_fs(repos);
+  for (i = 0; i < 5; ++i)
+    {
+      svn_fs_txn_t *txn;
+      svn_fs_root_t *txn_root;
+
+      SVN_ERR(svn_fs_begin_txn(&txn, fs, rev, pool));
+      SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+      SVN_ERR(svn_test__set_file_contents(txn_root, "A/mu",
+                                          apr_psprintf(pool, "mu %d.\n",
+                                                       (int)i),
+                                          pool));
+      SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+    }
+
+  /* Gather statistics sequentially and in parallel. */
+  SVN_ERR(svn_fs_fs__get_stats(&stats, fs, 1, NULL, NULL,
+                               NULL, NULL, NULL, NULL, pool, pool));
+  SVN_ERR(svn_fs_fs__get_stats(&parallel_stats, fs, 4, open_fs_instance,
+                               (void *)svn_fs_path(fs, pool),
+                               NULL, NULL, NULL, NULL, pool, pool));
+
+  /* The results must not depend on the number of jobs. */
+  SVN_TEST_ASSERT(stats->revision_count == parallel_stats->revision_count);
+  SVN_TEST_ASSERT(stats->total_size == parallel_stats->total_size);
+  SVN_TEST_ASSERT(stats->change_count == parallel_stats->change_count);
+  SVN_TEST_ASSERT(stats->change_len == parallel_stats->change_len);
+  SVN_TEST_ASSERT(stats->packed_size == parallel_stats->packed_size);
+  SVN_TEST_ASSERT(stats->total_node_stats.count
+                  == parallel_stats->total_node_stats.count);
+  SVN_TEST_ASSERT(stats->total_node_stats.size
+                  == parallel_stats->total_node_stats.size);
+
+  SVN_ERR(compare_rep_stats(&stats->total_rep_stats,
+                            &parallel_stats->total_rep_stats));
+  SVN_ERR(compare_rep_stats(&stats->file_rep_stats,
+                            &parallel_stats->file_rep_stats));
+  SVN_ERR(compare_rep_stats(&stats->dir_rep_stats,
+                            &parallel_stats->dir_rep_stats));
+
+  for (i = 0; i < stats->largest_changes->count; ++i)
+    {
+      svn_fs_fs__large_change_info_t *lhs = stats->largest_changes->changes[i];
+      svn_fs_fs__large_change_info_t *rhs
+        = parallel_stats->largest_changes->changes[i];
+
+      SVN_TEST_ASSERT(lhs->size == rhs->size);
+      SVN_TEST_ASSERT(lhs->revision == rhs->revision);
+      SVN_TEST_STRING_ASSERT(lhs->path->data, rhs->path->data);
+    }
+
   return SVN_NO_ERROR;
 }
 
@@ -405,15 +516,291 @@ load_index(const svn_test_opts_t *opts, apr_pool_t *pool)
   APR_ARRAY_PUSH(alt_entries, svn_fs_fs__p2l_entry_t *) = &entry;
 
   SVN_ERR(svn_fs_fs__load_index(svn_repos_fs(repos), rev, alt_entries, pool));
-  SVN_TEST_ASSERT_ERROR(svn_repos_verify_fs3(repos, rev, rev, FALSE, FALSE,
-                                             NULL, NULL, NULL, NULL, NULL,
+  SVN_TEST_ASSERT_ERROR(svn_repos_verify_fs4(repos, rev, rev, FALSE, FALSE,
+                                             1, NULL, NULL, NULL, NULL, NULL,
                                              NULL, pool),
                         SVN_ERR_FS_INDEX_CORRUPTION);
 
   /* Restore the original index. */
   SVN_ERR(svn_fs_fs__load_index(svn_repos_fs(repos), rev, entries, pool));
-  SVN_ERR(svn_repos_verify_fs3(repos, rev, rev, FALSE, FALSE, NULL, NULL,
-                               NULL, NULL, NULL, NULL, pool));
+  SVN_ERR(svn_repos_verify_fs4(repos, rev, rev, FALSE, FALSE, 1, NULL,
+                               NULL, NULL, NULL, NULL, NULL, pool));
+
+  return SVN_NO_ERROR;
+}
+
+#undef REPO_NAME
+
+/* ------------------------------------------------------------------------ */
+
+#define REPO_NAME "test-repo-lock-log-test"
+
+/* Implements svn_fs_get_locks_callback_t, counting the locks in the
+ * int * BATON. */
+static svn_error_t *
+count_locks(void *baton,
+            svn_lock_t *lock,
+            apr_pool_t *pool)
+{
+  int *count = baton;
+  ++*count;
+
+  return SVN_NO_ERROR;
+}
+
+/* Verify that there are EXPECTED locks at or below PATH in FS. */
+static svn_error_t *
+verify_lock_count(svn_fs_t *fs,
+                  const char *path,
+                  int expected,
+                  apr_pool_t *pool)
+{
+  int count = 0;
+  SVN_ERR(svn_fs_get_locks2(fs, path, svn_depth_infinity, count_locks,
+                            &count, pool));
+  SVN_TEST_INT_ASSERT(count, expected);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+lock_log(const svn_test_opts_t *opts,
+         apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root;
+  svn_revnum_t rev;
+  svn_fs_access_t *access;
+  svn_lock_t *lock;
+  svn_boolean_t uses_lock_log;
+  svn_stringbuf_t *format;
+  apr_hash_t *fs_config = apr_hash_make(pool);
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  int i;
+
+  /* Bail (with success) on known-untestable scenarios */
+  if (strcmp(opts->fs_type, "fsfs") != 0)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "this will test FSFS repositories only");
+
+  if (opts->server_minor_version && (opts->server_minor_version < 11))
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "pre-1.11 SVN doesn't have lock logs");
+
+  /* Create a filesystem that uses a lock log. */
+  svn_hash_sets(fs_config, SVN_FS_CONFIG_FSFS_LOCK_STORAGE, "log");
+  SVN_ERR(svn_test__create_fs2(&fs, REPO_NAME, opts, fs_config, pool));
+  SVN_ERR(svn_fs_fs__uses_lock_log(&uses_lock_log, fs, pool));
+  SVN_TEST_ASSERT(uses_lock_log);
+
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_test__create_greek_tree(txn_root, pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+  SVN_TEST_ASSERT(SVN_IS_VALID_REVNUM(rev));
+
+  SVN_ERR(svn_fs_create_access(&access, "bubba", pool));
+  SVN_ERR(svn_fs_set_access(fs, access));
+
+  /* Lock and query. */
+  SVN_ERR(svn_fs_lock(&lock, fs, "/A/mu", NULL, "", 0, 0, rev, FALSE, pool));
+  SVN_ERR(svn_fs_lock(&lock, fs, "/A/B/lambda", NULL, "", 0, 0, rev, FALSE,
+                      pool));
+  SVN_ERR(svn_fs_lock(&lock, fs, "/A/D/G/pi", NULL, "", 0, 0, rev, FALSE,
+                      pool));
+  SVN_ERR(svn_fs_lock(&lock, fs, "/iota", NULL, "a comment", FALSE, 0, rev,
+                      FALSE, pool));
+
+  SVN_ERR(verify_lock_count(fs, "/", 4, pool));
+  SVN_ERR(verify_lock_count(fs, "/A", 3, pool));
+  SVN_ERR(verify_lock_count(fs, "/A/D", 1, pool));
+  SVN_ERR(verify_lock_count(fs, "/A/C", 0, pool));
+
+  SVN_ERR(svn_fs_get_lock(&lock, fs, "/iota", pool));
+  SVN_TEST_ASSERT(lock);
+  SVN_TEST_STRING_ASSERT(lock->owner, "bubba");
+  SVN_TEST_STRING_ASSERT(lock->comment, "a comment");
+
+  /* Unlock iota.  Re-lock and unlock A/mu often enough for the log to get
+   * compacted. */
+  SVN_ERR(svn_fs_unlock(fs, "/iota", lock->token, FALSE, pool));
+  for (i = 0; i < 600; ++i)
+    {
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_fs_get_lock(&lock, fs, "/A/mu", iterpool));
+      SVN_ERR(svn_fs_unlock(fs, "/A/mu", lock->token, FALSE, iterpool));
+      SVN_ERR(svn_fs_lock(&lock, fs, "/A/mu", NULL, "", 0, 0, rev, FALSE,
+                          iterpool));
+    }
+
+  SVN_ERR(verify_lock_count(fs, "/", 3, pool));
+  SVN_ERR(svn_fs_get_lock(&lock, fs, "/iota", pool));
+  SVN_TEST_ASSERT(!lock);
+
+  /* Another FS instance must see the same locks. */
+  SVN_ERR(svn_fs_open2(&fs, REPO_NAME, fs_config, pool, pool));
+  SVN_ERR(svn_fs_set_access(fs, access));
+  SVN_ERR(verify_lock_count(fs, "/A", 3, pool));
+
+  /* Convert to digest files and back. */
+  SVN_ERR(svn_fs_fs__convert_locks(fs, FALSE, NULL, NULL, pool));
+  SVN_ERR(svn_fs_fs__uses_lock_log(&uses_lock_log, fs, pool));
+  SVN_TEST_ASSERT(!uses_lock_log);
+  SVN_ERR(verify_lock_count(fs, "/", 3, pool));
+  SVN_ERR(verify_lock_count(fs, "/A/D", 1, pool));
+
+  SVN_ERR(svn_fs_fs__convert_locks(fs, TRUE, NULL, NULL, pool));
+  SVN_ERR(svn_fs_fs__uses_lock_log(&uses_lock_log, fs, pool));
+  SVN_TEST_ASSERT(uses_lock_log);
+  SVN_ERR(verify_lock_count(fs, "/", 3, pool));
+
+  SVN_ERR(svn_fs_get_lock(&lock, fs, "/A/B/lambda", pool));
+  SVN_TEST_ASSERT(lock);
+  SVN_ERR(svn_fs_unlock(fs, "/A/B/lambda", lock->token, FALSE, pool));
+  SVN_ERR(verify_lock_count(fs, "/A/B", 0, pool));
+
+  /* The format file must tell older releases about the lock log. */
+  SVN_ERR(svn_stringbuf_from_file2(&format,
+                                   svn_dirent_join(REPO_NAME, "format",
+                                                   pool),
+                                   pool));
+  SVN_TEST_ASSERT(strstr(format->data, "\nlocks log\n"));
+
+  /* Formats that can't record it don't support lock logs. */
+  svn_hash_sets(fs_config, SVN_FS_CONFIG_COMPATIBLE_VERSION, "1.9");
+  SVN_TEST_ASSERT_ERROR(svn_test__create_fs2(&fs, REPO_NAME "-1.9", opts,
+                                             fs_config, pool),
+                        SVN_ERR_UNSUPPORTED_FEATURE);
+
+  svn_hash_sets(fs_config, SVN_FS_CONFIG_FSFS_LOCK_STORAGE, NULL);
+  SVN_ERR(svn_test__create_fs2(&fs, REPO_NAME "-1.9", opts, fs_config,
+                               pool));
+  SVN_TEST_ASSERT_ERROR(svn_fs_fs__convert_locks(fs, TRUE, NULL, NULL, pool),
+                        SVN_ERR_UNSUPPORTED_FEATURE);
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+#undef REPO_NAME
+
+/* ------------------------------------------------------------------------ */
+
+#define REPO_NAME "test-repo-io-trace"
+
+static svn_error_t *
+io_trace(const svn_test_opts_t *opts,
+         apr_pool_t *pool)
+{
+  svn_repos_t *repos;
+  svn_revnum_t rev;
+  svn_fs_t *fs;
+  svn_fs_root_t *root;
+  svn_stream_t *contents;
+  svn_stringbuf_t *events = svn_stringbuf_create_empty(pool);
+  const svn_fs__io_stats_t *stats;
+  apr_pool_t *trace_pool = svn_pool_create(pool);
+
+  /* Bail (with success) on known-untestable scenarios */
+  if (strcmp(opts->fs_type, "fsfs") != 0)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "this will test FSFS repositories only");
+
+  SVN_ERR(create_greek_repo(&repos, &rev, opts, REPO_NAME, pool, pool));
+  fs = svn_repos_fs(repos);
+
+  /* Not tracing yet. */
+  SVN_TEST_ASSERT(svn_fs__io_trace_stats(fs) == NULL);
+
+  SVN_ERR(svn_fs__io_trace_start(fs, svn_stream_from_stringbuf(events, pool),
+                                 trace_pool));
+  stats = svn_fs__io_trace_stats(fs);
+  SVN_TEST_ASSERT(stats);
+  SVN_TEST_ASSERT(stats->items_read == 0 && stats->cache_hits == 0);
+
+  /* Every item access must be accounted for, hit or miss. */
+  SVN_ERR(svn_fs_revision_root(&root, fs, rev, pool));
+  SVN_ERR(svn_fs_file_contents(&contents, root, "A/mu", pool));
+  SVN_ERR(svn_stream_close(contents));
+
+  SVN_TEST_ASSERT(stats->items_read + stats->cache_hits > 0);
+  SVN_TEST_ASSERT(strstr(events->data, "\"type\":\"noderev\""));
+  SVN_TEST_ASSERT(events->data[events->len - 1] == '\n');
+
+  /* Clearing the pool ends the trace. */
+  svn_pool_destroy(trace_pool);
+  SVN_TEST_ASSERT(svn_fs__io_trace_stats(fs) == NULL);
+
+  return SVN_NO_ERROR;
+}
+
+#undef REPO_NAME
+
+/* ------------------------------------------------------------------------ */
+
+#define REPO_NAME "test-repo-commit-timing"
+
+/* Implements svn_fs__commit_timing_func_t.  Append PHASE to the
+   svn_stringbuf_t *BATON. */
+static void
+collect_phases(void *baton,
+               const char *phase,
+               apr_interval_time_t duration,
+               apr_pool_t *scratch_pool)
+{
+  svn_stringbuf_t *phases = baton;
+
+  svn_stringbuf_appendcstr(phases, phase);
+  svn_stringbuf_appendbyte(phases, ' ');
+}
+
+static svn_error_t *
+commit_timing(const svn_test_opts_t *opts,
+              apr_pool_t *pool)
+{
+  svn_repos_t *repos;
+  svn_revnum_t rev;
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root;
+  svn_stringbuf_t *phases = svn_stringbuf_create_empty(pool);
+
+  /* Bail (with success) on known-untestable scenarios */
+  if (strcmp(opts->fs_type, "fsfs") != 0)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "this will test FSFS repositories only");
+
+  SVN_ERR(create_greek_repo(&repos, &rev, opts, REPO_NAME, pool, pool));
+  fs = svn_repos_fs(repos);
+
+  svn_fs__set_commit_timing_func(fs, collect_phases, phases);
+  SVN_ERR(svn_repos_fs_begin_txn_for_commit2(&txn, repos, rev,
+                                             apr_hash_make(pool), pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "A/mu", "changed\n", pool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &rev, txn, pool));
+  SVN_TEST_ASSERT(rev == 2);
+
+  /* The FS and the repository layer both contribute. */
+  SVN_TEST_ASSERT(strstr(phases->data, "pre-commit-hook "));
+  SVN_TEST_ASSERT(strstr(phases->data, "merge "));
+  SVN_TEST_ASSERT(strstr(phases->data, "fs-commit "));
+  SVN_TEST_ASSERT(strstr(phases->data, "post-commit-hook "));
+  SVN_TEST_ASSERT(   strstr(phases->data, "current ")
+                  || strstr(phases->data, "group-commit "));
+
+  /* Nothing gets reported once disabled. */
+  svn_fs__set_commit_timing_func(fs, NULL, NULL);
+  svn_stringbuf_setempty(phases);
+  SVN_ERR(svn_repos_fs_begin_txn_for_commit2(&txn, repos, rev,
+                                             apr_hash_make(pool), pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "A/mu", "again\n", pool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &rev, txn, pool));
+  SVN_TEST_ASSERT(rev == 3);
+  SVN_TEST_ASSERT(phases->len == 0);
 
   return SVN_NO_ERROR;
 }
@@ -431,10 +818,18 @@ static struct svn_test_descriptor_t test_funcs[] =
     SVN_TEST_NULL,
     SVN_TEST_OPTS_PASS(get_repo_stats,
                        "get statistics on a FSFS filesystem"),
+    SVN_TEST_OPTS_PASS(get_repo_stats_parallel,
+                       "get FSFS statistics using multiple threads"),
     SVN_TEST_OPTS_PASS(dump_index,
                        "dump the P2L index"),
     SVN_TEST_OPTS_PASS(load_index,
                        "load the P2L index"),
+    SVN_TEST_OPTS_PASS(lock_log,
+                       "store locks in a lock log"),
+    SVN_TEST_OPTS_PASS(io_trace,
+                       "trace FSFS I/O"),
+    SVN_TEST_OPTS_PASS(commit_timing,
+                       "report FSFS commit phase durations"),
     SVN_TEST_NULL
   };
 
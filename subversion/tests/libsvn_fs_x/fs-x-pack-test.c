@@ -25,7 +25,6 @@
 #include <apr_pools.h>
 
 #include "../svn_test.h"
-#include "../../libsvn_fs_x/batch_fsync.h"
 #include "../../libsvn_fs_x/fs.h"
 #include "../../libsvn_fs_x/reps.h"
 
@@ -845,89 +844,109 @@ pack_shard_size_one(const svn_test_opts_t *opts,
 #undef SHARD_SIZE
 #undef MAX_REV
 /* ------------------------------------------------------------------------ */
-#define REPO_NAME "test-repo-fsx-batch-fsync"
+#define REPO_NAME "test-repo-fsx-pack-parallel-containers"
+#define SHARD_SIZE 4
+#define MAX_REV 8
+
+/* Return the value of property "prop" on PATH in revision REV.
+ * Allocate it in POOL. */
+static const char *
+get_prop_value(svn_revnum_t rev,
+               const char *path,
+               apr_pool_t *pool)
+{
+  return apr_psprintf(pool, "%s value for %s in r%ld",
+                      get_rev_contents(rev, pool), path, rev);
+}
+
 static svn_error_t *
-test_batch_fsync(const svn_test_opts_t *opts,
-                 apr_pool_t *pool)
+pack_parallel_containers(const svn_test_opts_t *opts,
+                         apr_pool_t *pool)
 {
-  const char *abspath;
-  svn_fs_x__batch_fsync_t *batch;
+  static const char *const paths[]
+    = { "iota", "A/mu", "A/B/lambda", "A/D/gamma", "A/D/G/pi", "A/D" };
+
+  const char *conf = "\n[pack]\njobs = 3\nadaptive-containers = true\n";
+  apr_file_t *file;
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *root;
+  const char *conflict;
+  svn_revnum_t rev;
+  int version;
   int i;
+  apr_pool_t *iterpool = svn_pool_create(pool);
 
-  /* Disable this test for non FSX backends because it has no relevance to
-   * them. */
+  /* Bail (with success) on known-untestable scenarios */
   if (strcmp(opts->fs_type, "fsx") != 0)
-      return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
-      "this will test FSX repositories only");
-
-  /* Create an empty working directory and let it be cleaned up by the test
-   * harness. */
-  SVN_ERR(svn_dirent_get_absolute(&abspath, REPO_NAME, pool));
-
-  SVN_ERR(svn_io_remove_dir2(abspath, TRUE, NULL, NULL, pool));
-  SVN_ERR(svn_io_make_dir_recursively(abspath, pool));
-  svn_test_add_dir_cleanup(abspath);
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "this will test FSX repositories only");
 
-  /* Initialize infrastructure with a pool that lives as long as this
-   * application. */
-  SVN_ERR(svn_fs_x__batch_fsync_init(pool));
+  SVN_ERR(svn_test__create_fs(&fs, REPO_NAME, opts, pool));
+  SVN_ERR(svn_io_read_version_file(&version,
+                                   svn_dirent_join(REPO_NAME, "format", pool),
+                                   pool));
+  SVN_ERR(write_format(REPO_NAME, version, SHARD_SIZE, pool));
 
-  /* We use and re-use the same batch object throughout this test. */
-  SVN_ERR(svn_fs_x__batch_fsync_create(&batch, TRUE, pool));
+  /* Build the props containers using multiple threads. */
+  SVN_ERR(svn_io_file_open(&file,
+                           svn_dirent_join(REPO_NAME, "fsx.conf", pool),
+                           APR_WRITE | APR_APPEND, APR_OS_DEFAULT, pool));
+  SVN_ERR(svn_io_file_write_full(file, conf, strlen(conf), NULL, pool));
+  SVN_ERR(svn_io_file_close(file, pool));
 
-  /* The working directory is new. */
-  SVN_ERR(svn_fs_x__batch_fsync_new_path(batch, abspath, pool));
+  /* r1 is the Greek tree, all later revisions change similar props. */
+  SVN_ERR(svn_fs_open2(&fs, REPO_NAME, NULL, pool, pool));
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+  SVN_ERR(svn_test__create_greek_tree(root, pool));
+  SVN_ERR(svn_fs_commit_txn(&conflict, &rev, txn, pool));
+  SVN_TEST_ASSERT(SVN_IS_VALID_REVNUM(rev));
 
-  /* 1st run: Has to fire up worker threads etc. */
-  for (i = 0; i < 10; ++i)
+  while (rev < MAX_REV)
     {
-      apr_file_t *file;
-      const char *path = svn_dirent_join(abspath,
-                                         apr_psprintf(pool, "file%i", i),
-                                         pool);
-      apr_size_t len = strlen(path);
-
-      SVN_ERR(svn_fs_x__batch_fsync_open_file(&file, batch, path, pool));
-
-      SVN_ERR(svn_io_file_write(file, path, &len, pool));
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_fs_begin_txn(&txn, fs, rev, iterpool));
+      SVN_ERR(svn_fs_txn_root(&root, txn, iterpool));
+      for (i = 0; i < (int)(sizeof(paths) / sizeof(paths[0])); ++i)
+        SVN_ERR(svn_fs_change_node_prop(root, paths[i], "prop",
+                          svn_string_create(get_prop_value(rev + 1, paths[i],
+                                                           iterpool),
+                                            iterpool),
+                          iterpool));
+      SVN_ERR(svn_fs_commit_txn(&conflict, &rev, txn, iterpool));
+      SVN_TEST_ASSERT(SVN_IS_VALID_REVNUM(rev));
     }
 
-  SVN_ERR(svn_fs_x__batch_fsync_run(batch, pool));
+  SVN_ERR(svn_fs_pack(REPO_NAME, NULL, NULL, NULL, NULL, pool));
+  SVN_ERR(svn_fs_verify(REPO_NAME, NULL, 0, MAX_REV, NULL, NULL, NULL, NULL,
+                        pool));
 
-  /* 2nd run: Running a batch must leave the container in an empty,
-   * re-usable state. Hence, try to re-use it. */
-  for (i = 0; i < 10; ++i)
+  /* Read the props back from the packed shards. */
+  SVN_ERR(svn_fs_open2(&fs, REPO_NAME, NULL, pool, pool));
+  for (rev = 2; rev <= MAX_REV; ++rev)
     {
-      apr_file_t *file;
-      const char *path = svn_dirent_join(abspath,
-                                         apr_psprintf(pool, "new%i", i),
-                                         pool);
-      apr_size_t len = strlen(path);
-
-      SVN_ERR(svn_fs_x__batch_fsync_open_file(&file, batch, path, pool));
-
-      SVN_ERR(svn_io_file_write(file, path, &len, pool));
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_fs_revision_root(&root, fs, rev, iterpool));
+      for (i = 0; i < (int)(sizeof(paths) / sizeof(paths[0])); ++i)
+        {
+          svn_string_t *value;
+          SVN_ERR(svn_fs_node_prop(&value, root, paths[i], "prop",
+                                   iterpool));
+          SVN_TEST_ASSERT(value);
+          SVN_TEST_STRING_ASSERT(value->data,
+                                 get_prop_value(rev, paths[i], iterpool));
+        }
     }
 
-  SVN_ERR(svn_fs_x__batch_fsync_run(batch, pool));
-
-  /* 3rd run: Schedule but don't execute. POOL cleanup shall not fail. */
-  for (i = 0; i < 10; ++i)
-    {
-      apr_file_t *file;
-      const char *path = svn_dirent_join(abspath,
-                                         apr_psprintf(pool, "another%i", i),
-                                         pool);
-      apr_size_t len = strlen(path);
-
-      SVN_ERR(svn_fs_x__batch_fsync_open_file(&file, batch, path, pool));
-
-      SVN_ERR(svn_io_file_write(file, path, &len, pool));
-    }
+  svn_pool_destroy(iterpool);
 
   return SVN_NO_ERROR;
 }
+
 #undef REPO_NAME
+#undef SHARD_SIZE
+#undef MAX_REV
 /* ------------------------------------------------------------------------ */
 
 /* The test table.  */
@@ -961,8 +980,8 @@ static struct svn_test_descriptor_t test_funcs[] =
                        "test representations container"),
     SVN_TEST_OPTS_PASS(pack_shard_size_one,
                        "test packing with shard size = 1"),
-    SVN_TEST_OPTS_PASS(test_batch_fsync,
-                       "test batch fsync"),
+    SVN_TEST_OPTS_PASS(pack_parallel_containers,
+                       "pack props containers in parallel"),
     SVN_TEST_NULL
   };
 
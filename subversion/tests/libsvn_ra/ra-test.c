@@ -36,6 +36,10 @@
 #include "svn_cmdline.h"
 #include "svn_dirent_uri.h"
 #include "svn_hash.h"
+#include "svn_props.h"
+#include "svn_sorts.h"
+#include "private/svn_ra_private.h"
+#include "private/svn_sorts_private.h"
 
 #include "../svn_test.h"
 #include "../svn_test_fs.h"
@@ -620,6 +624,245 @@ get_dir_test(const svn_test_opts_t *opts,
   return SVN_NO_ERROR;
 }
 
+/* Test svn_ra__stat_many(). */
+static svn_error_t *
+stat_many_test(const svn_test_opts_t *opts,
+               apr_pool_t *pool)
+{
+  svn_ra_session_t *session;
+  apr_array_header_t *paths;
+  apr_hash_t *dirents, *locks;
+  svn_dirent_t *ent;
+
+  SVN_ERR(make_and_open_repos(&session, "test-stat-many", opts, pool));
+  SVN_ERR(commit_changes(session, pool));
+
+  paths = apr_array_make(pool, 3, sizeof(const char *));
+  APR_ARRAY_PUSH(paths, const char *) = "A";
+  APR_ARRAY_PUSH(paths, const char *) = "non/existing/relpath";
+  APR_ARRAY_PUSH(paths, const char *) = "";
+
+  SVN_ERR(svn_ra__stat_many(&dirents, &locks, session, paths,
+                            SVN_INVALID_REVNUM, pool, pool));
+  SVN_TEST_INT_ASSERT(apr_hash_count(dirents), 2);
+  SVN_TEST_INT_ASSERT(apr_hash_count(locks), 0);
+
+  ent = svn_hash_gets(dirents, "A");
+  SVN_TEST_ASSERT(ent);
+  SVN_TEST_ASSERT(ent->kind == svn_node_dir);
+  SVN_TEST_INT_ASSERT(ent->created_rev, 1);
+
+  ent = svn_hash_gets(dirents, "");
+  SVN_TEST_ASSERT(ent);
+  SVN_TEST_ASSERT(ent->kind == svn_node_dir);
+
+  /* "A" doesn't exist in r0. */
+  SVN_ERR(svn_ra__stat_many(&dirents, NULL, session, paths, 0, pool, pool));
+  SVN_TEST_INT_ASSERT(apr_hash_count(dirents), 1);
+  SVN_TEST_ASSERT(svn_hash_gets(dirents, "") != NULL);
+
+  return SVN_NO_ERROR;
+}
+
+/* Baton for stat_receiver(). */
+typedef struct stat_receiver_baton_t
+{
+  /* Number of entries received so far. */
+  int count;
+
+  /* Expected revision and node kind per entry. */
+  const svn_revnum_t *revisions;
+  const svn_node_kind_t *kinds;
+} stat_receiver_baton_t;
+
+/* Implements svn_ra_stat_receiver_t. */
+static svn_error_t *
+stat_receiver(const char *path,
+              svn_revnum_t revision,
+              svn_dirent_t *dirent,
+              void *baton,
+              apr_pool_t *scratch_pool)
+{
+  stat_receiver_baton_t *b = baton;
+
+  SVN_TEST_INT_ASSERT(revision, b->revisions[b->count]);
+  SVN_TEST_ASSERT((dirent ? dirent->kind : svn_node_none)
+                  == b->kinds[b->count]);
+  b->count++;
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+stat_many_revisions_test(const svn_test_opts_t *opts,
+                         apr_pool_t *pool)
+{
+  svn_ra_session_t *session;
+  apr_array_header_t *paths, *revisions;
+  static const svn_revnum_t expected_revs[] = { 1, 0, 1, 0 };
+  static const svn_node_kind_t expected_kinds[] = {
+    svn_node_dir, svn_node_none, svn_node_dir, svn_node_dir
+  };
+  stat_receiver_baton_t b = { 0 };
+
+  SVN_ERR(make_and_open_repos(&session, "test-stat-many-revisions", opts,
+                              pool));
+  SVN_ERR(commit_changes(session, pool));
+
+  paths = apr_array_make(pool, 4, sizeof(const char *));
+  revisions = apr_array_make(pool, 4, sizeof(svn_revnum_t));
+  APR_ARRAY_PUSH(paths, const char *) = "A";
+  APR_ARRAY_PUSH(revisions, svn_revnum_t) = SVN_INVALID_REVNUM;
+  APR_ARRAY_PUSH(paths, const char *) = "A";
+  APR_ARRAY_PUSH(revisions, svn_revnum_t) = 0;
+  APR_ARRAY_PUSH(paths, const char *) = "";
+  APR_ARRAY_PUSH(revisions, svn_revnum_t) = 1;
+  APR_ARRAY_PUSH(paths, const char *) = "";
+  APR_ARRAY_PUSH(revisions, svn_revnum_t) = 0;
+
+  b.revisions = expected_revs;
+  b.kinds = expected_kinds;
+  SVN_ERR(svn_ra_stat_many(session, paths, revisions, stat_receiver, &b,
+                           pool));
+  SVN_TEST_INT_ASSERT(b.count, 4);
+
+  return SVN_NO_ERROR;
+}
+
+/* Baton for file_receiver(). */
+typedef struct file_receiver_baton_t
+{
+  /* The const char * paths received so far. */
+  apr_array_header_t *paths;
+
+  /* Pool to allocate the paths in. */
+  apr_pool_t *pool;
+} file_receiver_baton_t;
+
+/* Implements svn_ra_file_receiver_t. */
+static svn_error_t *
+file_receiver(svn_stream_t **stream,
+              const char *path,
+              svn_revnum_t revision,
+              apr_hash_t *props,
+              void *baton,
+              apr_pool_t *result_pool)
+{
+  file_receiver_baton_t *b = baton;
+
+  SVN_TEST_INT_ASSERT(revision, 1);
+  SVN_TEST_ASSERT(props != NULL);
+  SVN_TEST_ASSERT(svn_hash_gets(props, SVN_PROP_ENTRY_COMMITTED_REV));
+
+  APR_ARRAY_PUSH(b->paths, const char *) = apr_pstrdup(b->pool, path);
+  *stream = svn_stream_empty(result_pool);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+get_files_test(const svn_test_opts_t *opts,
+               apr_pool_t *pool)
+{
+  svn_ra_session_t *session;
+  apr_array_header_t *paths, *revisions;
+  file_receiver_baton_t b;
+
+  SVN_ERR(make_and_open_repos(&session, "test-get-files", opts, pool));
+  SVN_ERR(commit_tree(session, pool));
+
+  paths = apr_array_make(pool, 3, sizeof(const char *));
+  revisions = apr_array_make(pool, 3, sizeof(svn_revnum_t));
+  APR_ARRAY_PUSH(paths, const char *) = "A/BB/g";
+  APR_ARRAY_PUSH(revisions, svn_revnum_t) = SVN_INVALID_REVNUM;
+  APR_ARRAY_PUSH(paths, const char *) = "A/B/f";
+  APR_ARRAY_PUSH(revisions, svn_revnum_t) = 1;
+  APR_ARRAY_PUSH(paths, const char *) = "A/B/g";
+  APR_ARRAY_PUSH(revisions, svn_revnum_t) = SVN_INVALID_REVNUM;
+
+  b.paths = apr_array_make(pool, 3, sizeof(const char *));
+  b.pool = pool;
+  SVN_ERR(svn_ra_get_files(session, paths, revisions, TRUE, file_receiver,
+                           &b, pool));
+
+  /* The files may arrive in any order. */
+  svn_sort__array(b.paths, svn_sort_compare_paths);
+  SVN_TEST_INT_ASSERT(b.paths->nelts, 3);
+  SVN_TEST_STRING_ASSERT(APR_ARRAY_IDX(b.paths, 0, const char *), "A/B/f");
+  SVN_TEST_STRING_ASSERT(APR_ARRAY_IDX(b.paths, 1, const char *), "A/B/g");
+  SVN_TEST_STRING_ASSERT(APR_ARRAY_IDX(b.paths, 2, const char *), "A/BB/g");
+
+  /* Directories can't be fetched. */
+  APR_ARRAY_PUSH(paths, const char *) = "A/B";
+  APR_ARRAY_PUSH(revisions, svn_revnum_t) = 1;
+  apr_array_clear(b.paths);
+  SVN_TEST_ASSERT_ANY_ERROR(svn_ra_get_files(session, paths, revisions,
+                                             TRUE, file_receiver, &b, pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_ra_rev_proplist_receiver_t.  BATON is the svn_revnum_t
+   expected next. */
+static svn_error_t *
+revprops_receiver(svn_revnum_t revision,
+                  apr_hash_t *props,
+                  void *baton,
+                  apr_pool_t *scratch_pool)
+{
+  svn_revnum_t *next_rev = baton;
+
+  SVN_TEST_INT_ASSERT(revision, *next_rev);
+  SVN_TEST_ASSERT(svn_hash_gets(props, SVN_PROP_REVISION_DATE));
+  (*next_rev)++;
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+rev_proplist_range_test(const svn_test_opts_t *opts,
+                        apr_pool_t *pool)
+{
+  svn_ra_session_t *session;
+  svn_revnum_t next_rev;
+  apr_array_header_t *changes;
+  svn_prop_t *prop;
+
+  SVN_ERR(make_and_open_repos(&session, "test-rev-proplist-range", opts,
+                              pool));
+  SVN_ERR(commit_tree(session, pool));
+
+  next_rev = 0;
+  SVN_ERR(svn_ra_rev_proplist_range(session, 0, 1, revprops_receiver,
+                                    &next_rev, pool));
+  SVN_TEST_INT_ASSERT(next_rev, 2);
+
+  next_rev = 1;
+  SVN_ERR(svn_ra_rev_proplist_range(session, 1, 1, revprops_receiver,
+                                    &next_rev, pool));
+  SVN_TEST_INT_ASSERT(next_rev, 2);
+
+  /* Revisions beyond HEAD don't exist. */
+  next_rev = 1;
+  SVN_TEST_ASSERT_ERROR(svn_ra_rev_proplist_range(session, 1, 2,
+                                                  revprops_receiver,
+                                                  &next_rev, pool),
+                        SVN_ERR_FS_NO_SUCH_REVISION);
+
+  /* Without a pre-revprop-change hook, the first change fails. */
+  changes = apr_array_make(pool, 2, sizeof(svn_prop_t));
+  prop = apr_array_push(changes);
+  prop->name = "prop1";
+  prop->value = svn_string_create("value1", pool);
+  prop = apr_array_push(changes);
+  prop->name = "prop2";
+  prop->value = NULL;
+  SVN_TEST_ASSERT_ERROR(svn_ra__change_rev_props(session, 1, changes, pool),
+                        SVN_ERR_REPOS_DISABLED_FEATURE);
+
+  return SVN_NO_ERROR;
+}
+
 /* Implements svn_commit_callback2_t for commit_callback_failure() */
 static svn_error_t *
 commit_callback_with_failure(const svn_commit_info_t *info,
@@ -1785,6 +2028,92 @@ commit_locked_file(const svn_test_opts_t *opts, apr_pool_t *pool)
 }
 
 
+/* Test ra_svn sessions using compressed connections. */
+static svn_error_t *
+tunnel_compressed_session(const svn_test_opts_t *opts,
+                          apr_pool_t *pool)
+{
+  static const char *methods[] = { "lz4", "zlib" };
+  apr_pool_t *scratch_pool = svn_pool_create(pool);
+  svn_stringbuf_t *contents;
+  apr_size_t i;
+
+  /* Make sure the data spans multiple compressed frames. */
+  contents = svn_stringbuf_create("This is a line of text.\n", pool);
+  while (contents->len < 200000)
+    svn_stringbuf_appendstr(contents, contents);
+
+  for (i = 0; i < sizeof(methods) / sizeof(methods[0]); ++i)
+    {
+      tunnel_baton_t *b = apr_pcalloc(pool, sizeof(*b));
+      const char *repos_name;
+      const char *url;
+      const char *conf;
+      svn_repos_t *repos;
+      svn_ra_callbacks2_t *cbtable;
+      svn_ra_session_t *session;
+      apr_hash_t *revprop_table = apr_hash_make(pool);
+      const svn_delta_editor_t *editor;
+      void *edit_baton, *root_baton, *file_baton;
+      svn_txdelta_window_handler_t handler;
+      void *handler_baton;
+      svn_stringbuf_t *result = svn_stringbuf_create_empty(pool);
+
+      b->magic = TUNNEL_MAGIC;
+      repos_name = apr_pstrcat(pool, "test-repo-compressed-", methods[i],
+                               SVN_VA_NULL);
+      SVN_ERR(svn_test__create_repos(&repos, repos_name, opts,
+                                     scratch_pool));
+      conf = apr_psprintf(pool, "[general]\nstream-compression = %s\n",
+                          methods[i]);
+      SVN_ERR(svn_io_file_create(svn_repos_svnserve_conf(repos, pool), conf,
+                                 pool));
+
+      /* Immediately close the repository to avoid race condition with
+         svnserve (and then the cleanup code) with BDB when our pool is
+         cleared. */
+      svn_pool_clear(scratch_pool);
+
+      url = apr_pstrcat(pool, "svn+test://localhost/", repos_name,
+                        SVN_VA_NULL);
+      SVN_ERR(svn_ra_create_callbacks(&cbtable, pool));
+      cbtable->check_tunnel_func = check_tunnel;
+      cbtable->open_tunnel_func = open_tunnel;
+      cbtable->tunnel_baton = b;
+      SVN_ERR(svn_test__init_auth_baton(&cbtable->auth_baton, pool));
+
+      SVN_ERR(svn_ra_open4(&session, NULL, url, NULL, cbtable, NULL, NULL,
+                           pool));
+
+      /* Send the contents to the server ... */
+      SVN_ERR(svn_ra_get_commit_editor3(session, &editor, &edit_baton,
+                                        revprop_table,
+                                        NULL, NULL, NULL, TRUE, pool));
+      SVN_ERR(editor->open_root(edit_baton, SVN_INVALID_REVNUM,
+                                pool, &root_baton));
+      SVN_ERR(editor->add_file("f", root_baton, NULL, SVN_INVALID_REVNUM,
+                               pool, &file_baton));
+      SVN_ERR(editor->apply_textdelta(file_baton, NULL, pool,
+                                      &handler, &handler_baton));
+      SVN_ERR(svn_txdelta_send_string(svn_string_create_from_buf(contents,
+                                                                 pool),
+                                      handler, handler_baton, pool));
+      SVN_ERR(editor->close_file(file_baton, NULL, pool));
+      SVN_ERR(editor->close_directory(root_baton, pool));
+      SVN_ERR(editor->close_edit(edit_baton, pool));
+
+      /* ... and read them back. */
+      SVN_ERR(svn_ra_get_file(session, "f", 1,
+                              svn_stream_from_stringbuf(result, pool),
+                              NULL, NULL, pool));
+      SVN_TEST_ASSERT(svn_stringbuf_compare(result, contents));
+    }
+
+  svn_pool_destroy(scratch_pool);
+
+  return SVN_NO_ERROR;
+}
+
 /* The test table.  */
 
 static int max_threads = 4;
@@ -1802,6 +2131,14 @@ static struct svn_test_descriptor_t test_funcs[] =
                        "lock multiple paths"),
     SVN_TEST_OPTS_PASS(get_dir_test,
                        "test ra_get_dir2"),
+    SVN_TEST_OPTS_PASS(stat_many_test,
+                       "test ra__stat_many"),
+    SVN_TEST_OPTS_PASS(stat_many_revisions_test,
+                       "test ra_stat_many with many revisions"),
+    SVN_TEST_OPTS_PASS(get_files_test,
+                       "test ra_get_files"),
+    SVN_TEST_OPTS_PASS(rev_proplist_range_test,
+                       "test ra_rev_proplist_range"),
     SVN_TEST_OPTS_PASS(commit_callback_failure,
                        "commit callback failure"),
     SVN_TEST_OPTS_PASS(base_revision_above_youngest,
@@ -1820,6 +2157,8 @@ static struct svn_test_descriptor_t test_funcs[] =
                        "check how last change applies to empty commit"),
     SVN_TEST_OPTS_PASS(commit_locked_file,
                        "check commit editor for a locked file"),
+    SVN_TEST_OPTS_PASS(tunnel_compressed_session,
+                       "verify compressed ra_svn connections"),
     SVN_TEST_NULL
   };
 
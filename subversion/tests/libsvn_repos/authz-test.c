@@ -511,6 +511,98 @@ reposful_reposless_stanzas_inherit(apr_pool_t *pool)
    return SVN_NO_ERROR;
 }
 
+static svn_error_t *
+test_authz_serialize(const svn_test_opts_t *opts,
+                     apr_pool_t *pool)
+{
+  const char *srcdir;
+  apr_file_t *rules_file;
+  apr_file_t *groups_file;
+  authz_full_t *authz;
+  authz_full_t *copy;
+  svn_stringbuf_t *serialized;
+  svn_error_t *err;
+  int i, j, k;
+
+  const char *users[] = { NULL, "wunga", "bloop", "fred", "unknown" };
+  const char *repos[] = { "", "bloop", "repo", "unknown" };
+
+  SVN_ERR(svn_test_get_srcdir(&srcdir, opts, pool));
+  SVN_ERR(svn_io_file_open(&rules_file,
+                           svn_dirent_join(srcdir, "authz.rules", pool),
+                           APR_READ, APR_OS_DEFAULT, pool));
+  SVN_ERR(svn_io_file_open(&groups_file,
+                           svn_dirent_join(srcdir, "authz.groups", pool),
+                           APR_READ, APR_OS_DEFAULT, pool));
+  SVN_ERR(svn_authz__parse(&authz,
+                           svn_stream_from_aprfile2(rules_file, FALSE, pool),
+                           svn_stream_from_aprfile2(groups_file, FALSE, pool),
+                           pool, pool));
+
+  SVN_ERR(svn_authz__serialize(&serialized, authz, pool, pool));
+  SVN_ERR(svn_authz__deserialize(&copy, serialized->data, serialized->len,
+                                 pool));
+
+  /* The copy must grant exactly the same rights. */
+  SVN_TEST_ASSERT(copy->acls->nelts == authz->acls->nelts);
+  SVN_TEST_ASSERT(copy->has_anon_rights == authz->has_anon_rights);
+  SVN_TEST_ASSERT(copy->has_authn_rights == authz->has_authn_rights);
+  SVN_TEST_ASSERT(apr_hash_count(copy->user_rights)
+                  == apr_hash_count(authz->user_rights));
+
+  for (i = 0; i < sizeof(users) / sizeof(users[0]); ++i)
+    for (j = 0; j < sizeof(repos) / sizeof(repos[0]); ++j)
+      {
+        authz_rights_t expected = { authz_access_none, authz_access_none };
+        authz_rights_t actual = { authz_access_none, authz_access_none };
+        svn_boolean_t expected_found
+          = svn_authz__get_global_rights(&expected, authz,
+                                         users[i], repos[j]);
+        svn_boolean_t actual_found
+          = svn_authz__get_global_rights(&actual, copy,
+                                         users[i], repos[j]);
+
+        SVN_TEST_ASSERT(expected_found == actual_found);
+        SVN_TEST_ASSERT(expected.min_access == actual.min_access);
+        SVN_TEST_ASSERT(expected.max_access == actual.max_access);
+
+        for (k = 0; k < authz->acls->nelts; ++k)
+          {
+            const authz_acl_t *acl
+              = &APR_ARRAY_IDX(authz->acls, k, authz_acl_t);
+            const authz_acl_t *acl_copy
+              = &APR_ARRAY_IDX(copy->acls, k, authz_acl_t);
+            authz_access_t expected_access = authz_access_none;
+            authz_access_t actual_access = authz_access_none;
+
+            SVN_TEST_ASSERT(acl->sequence_number
+                            == acl_copy->sequence_number);
+            SVN_TEST_STRING_ASSERT(acl->rule.repos, acl_copy->rule.repos);
+            SVN_TEST_STRING_ASSERT(rule_string((authz_rule_t *)&acl->rule,
+                                               pool),
+                                   rule_string(
+                                     (authz_rule_t *)&acl_copy->rule,
+                                     pool));
+            SVN_TEST_ASSERT(
+                svn_authz__get_acl_access(&expected_access, acl,
+                                          users[i], repos[j])
+                == svn_authz__get_acl_access(&actual_access, acl_copy,
+                                             users[i], repos[j]));
+            SVN_TEST_ASSERT(expected_access == actual_access);
+          }
+      }
+
+  /* Truncated or corrupted data must be rejected. */
+  err = svn_authz__deserialize(&copy, serialized->data,
+                               serialized->len / 2, pool);
+  SVN_TEST_ASSERT_ERROR(err, SVN_ERR_MALFORMED_FILE);
+
+  err = svn_authz__deserialize(&copy, "garbage", 7, pool);
+  SVN_TEST_ASSERT_ERROR(err, SVN_ERR_MALFORMED_FILE);
+
+  return SVN_NO_ERROR;
+}
+
 static int max_threads = 4;
 
 static struct svn_test_descriptor_t test_funcs[] =
@@ -524,6 +616,8 @@ static struct svn_test_descriptor_t test_funcs[] =
                    "issue 4741 groups"),
     SVN_TEST_XFAIL2(reposful_reposless_stanzas_inherit,
                     "[foo:/] inherits [/]"),
+    SVN_TEST_OPTS_PASS(test_authz_serialize,
+                       "test svn_authz__serialize"),
     SVN_TEST_NULL
   };
 
@@ -26,6 +26,7 @@
 
 #include "svn_pools.h"
 #include "svn_error.h"
+#include "svn_dirent_uri.h"
 #include "svn_fs.h"
 #include "svn_repos.h"
 #include "private/svn_repos_private.h"
@@ -76,8 +77,8 @@ test_dump_bad_props(svn_stringbuf_t **dump_data_p,
   SVN_TEST_ASSERT(SVN_IS_VALID_REVNUM(youngest_rev));
 
   /* Test that a dump completes without error. */
-  SVN_ERR(svn_repos_dump_fs4(repos, stream, start_rev, end_rev,
-                             FALSE, FALSE, TRUE, TRUE,
+  SVN_ERR(svn_repos_dump_fs5(repos, stream, start_rev, end_rev,
+                             FALSE, FALSE, TRUE, TRUE, 1,
                              notify_func, notify_baton,
                              NULL, NULL, NULL, NULL,
                              pool));
@@ -120,7 +121,7 @@ test_load_bad_props(svn_stringbuf_t *dump_data,
   svn_revnum_t youngest_rev;
   svn_string_t *loaded_prop_val;
 
-  SVN_ERR(svn_repos_load_fs6(repos, stream,
+  SVN_ERR(svn_repos_load_fs7(repos, stream,
                              SVN_INVALID_REVNUM, SVN_INVALID_REVNUM,
                              svn_repos_load_uuid_default,
                              parent_fspath,
@@ -128,6 +129,7 @@ test_load_bad_props(svn_stringbuf_t *dump_data,
                              validate_props,
                              FALSE /*ignore_dates*/,
                              FALSE /*normalize_props*/,
+                             FALSE /*pipelined*/,
                              notify_func, notify_baton,
                              NULL, NULL, /*cancellation*/
                              pool));
@@ -273,6 +275,278 @@ test_load_r0_mergeinfo(const svn_test_opts_t *opts,
   return SVN_NO_ERROR;
 }
 
+/* Dump all of REPOS with deltas into *DUMP_DATA_P, using JOBS threads. */
+static svn_error_t *
+dump_with_deltas(svn_stringbuf_t **dump_data_p,
+                 svn_repos_t *repos,
+                 int jobs,
+                 apr_pool_t *pool)
+{
+  svn_stringbuf_t *dump_data = svn_stringbuf_create_empty(pool);
+  svn_stream_t *stream = svn_stream_from_stringbuf(dump_data, pool);
+
+  SVN_ERR(svn_repos_dump_fs5(repos, stream,
+                             SVN_INVALID_REVNUM, SVN_INVALID_REVNUM,
+                             FALSE, TRUE /*use_deltas*/, TRUE, TRUE, jobs,
+                             NULL, NULL, NULL, NULL, NULL, NULL,
+                             pool));
+  SVN_ERR(svn_stream_close(stream));
+
+  *dump_data_p = dump_data;
+  return SVN_NO_ERROR;
+}
+
+/* Loading with a separate parser thread must produce the same
+   repository as the normal load. */
+static svn_error_t *
+test_load_pipelined(const svn_test_opts_t *opts,
+                    apr_pool_t *pool)
+{
+  svn_repos_t *repos;
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root;
+  svn_revnum_t youngest_rev = 0;
+  svn_stringbuf_t *dump_data, *reloaded_data;
+  int i;
+
+  SVN_ERR(svn_test__create_repos(&repos, "test-repo-load-pipelined-1",
+                                 opts, pool));
+  fs = svn_repos_fs(repos);
+
+  /* r1: the Greek tree. */
+  SVN_ERR(svn_fs_begin_txn2(&txn, fs, youngest_rev, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_test__create_greek_tree(txn_root, pool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, pool));
+  SVN_TEST_ASSERT(SVN_IS_VALID_REVNUM(youngest_rev));
+
+  /* r2 .. r11: text and property changes, i.e. deltas in the dump. */
+  for (i = 0; i < 10; i++)
+    {
+      svn_stringbuf_t *contents = svn_stringbuf_create_empty(pool);
+      int k;
+
+      for (k = 0; k <= i * 1000; k++)
+        svn_stringbuf_appendcstr(contents, apr_psprintf(pool, "%d %d\n",
+                                                        i, k));
+
+      SVN_ERR(svn_fs_begin_txn2(&txn, fs, youngest_rev, 0, pool));
+      SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+      SVN_ERR(svn_test__set_file_contents(txn_root, "iota", contents->data,
+                                          pool));
+      SVN_ERR(svn_fs_change_node_prop(txn_root, "A", "prop",
+                                      svn_string_createf(pool, "%d", i),
+                                      pool));
+      SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn,
+                                      pool));
+      SVN_TEST_ASSERT(SVN_IS_VALID_REVNUM(youngest_rev));
+    }
+
+  /* r12: a copy. */
+  SVN_ERR(svn_fs_begin_txn2(&txn, fs, youngest_rev, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_fs_copy(txn_root, "A", txn_root, "B", pool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, pool));
+  SVN_TEST_ASSERT(SVN_IS_VALID_REVNUM(youngest_rev));
+
+  SVN_ERR(dump_with_deltas(&dump_data, repos, 1, pool));
+
+  /* Load it in pipelined mode and compare the result. */
+  SVN_ERR(svn_test__create_repos(&repos, "test-repo-load-pipelined-2",
+                                 opts, pool));
+  SVN_ERR(svn_repos_load_fs7(repos,
+                             svn_stream_from_stringbuf(dump_data, pool),
+                             SVN_INVALID_REVNUM, SVN_INVALID_REVNUM,
+                             svn_repos_load_uuid_default, NULL,
+                             FALSE, FALSE, /*use_*_commit_hook*/
+                             TRUE /*validate_props*/,
+                             FALSE /*ignore_dates*/,
+                             FALSE /*normalize_props*/,
+                             TRUE /*pipelined*/,
+                             NULL, NULL, NULL, NULL, pool));
+
+  SVN_ERR(dump_with_deltas(&reloaded_data, repos, 1, pool));
+  SVN_TEST_ASSERT(svn_stringbuf_compare(dump_data, reloaded_data));
+
+  /* Parser errors must still be reported. */
+  svn_stringbuf_chop(dump_data, dump_data->len / 2);
+  SVN_ERR(svn_test__create_repos(&repos, "test-repo-load-pipelined-3",
+                                 opts, pool));
+  SVN_TEST_ASSERT_ANY_ERROR(svn_repos_load_fs7(repos,
+                             svn_stream_from_stringbuf(dump_data, pool),
+                             SVN_INVALID_REVNUM, SVN_INVALID_REVNUM,
+                             svn_repos_load_uuid_default, NULL,
+                             FALSE, FALSE, TRUE, FALSE, FALSE, TRUE,
+                             NULL, NULL, NULL, NULL, pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Deltas that FSFS stores against the dumped base must be passed into
+   the dump as they are and still load correctly. */
+static svn_error_t *
+test_dump_stored_deltas(const svn_test_opts_t *opts,
+                        apr_pool_t *pool)
+{
+  const char *repos_name = "test-repo-dump-stored-deltas";
+  const char *conf = "\n[deltification]\ncompression = zlib\n";
+  svn_repos_t *repos;
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root, *root;
+  svn_revnum_t youngest_rev = 0;
+  svn_stringbuf_t *dump_data, *contents, *expected;
+  apr_file_t *file;
+  apr_size_t offset;
+  int i;
+
+  if (strcmp(opts->fs_type, "fsfs") != 0)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "this test requires FSFS");
+
+  /* Make FSFS write svndiff1 deltas. */
+  SVN_ERR(svn_test__create_repos(&repos, repos_name, opts, pool));
+  SVN_ERR(svn_io_file_open(&file,
+                           svn_dirent_join(svn_fs_path(svn_repos_fs(repos),
+                                                       pool),
+                                           "fsfs.conf", pool),
+                           APR_WRITE | APR_APPEND, APR_OS_DEFAULT, pool));
+  SVN_ERR(svn_io_file_write_full(file, conf, strlen(conf), NULL, pool));
+  SVN_ERR(svn_io_file_close(file, pool));
+  SVN_ERR(svn_repos_open3(&repos, repos_name, NULL, pool, pool));
+  fs = svn_repos_fs(repos);
+
+  /* r1: the Greek tree.  r2: a change to iota, stored as a delta
+     against r1. */
+  SVN_ERR(svn_fs_begin_txn2(&txn, fs, youngest_rev, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_test__create_greek_tree(txn_root, pool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, pool));
+  SVN_TEST_ASSERT(SVN_IS_VALID_REVNUM(youngest_rev));
+
+  expected = svn_stringbuf_create_empty(pool);
+  for (i = 0; i < 1000; i++)
+    svn_stringbuf_appendcstr(expected, apr_psprintf(pool, "line %d\n", i));
+
+  SVN_ERR(svn_fs_begin_txn2(&txn, fs, youngest_rev, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "iota", expected->data,
+                                      pool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, pool));
+  SVN_TEST_ASSERT(SVN_IS_VALID_REVNUM(youngest_rev));
+
+  /* The delta for iota in r2 comes straight from the repository.
+     Our own encoder writes svndiff0 only. */
+  SVN_ERR(dump_with_deltas(&dump_data, repos, 1, pool));
+  for (offset = 0; offset + 4 <= dump_data->len; offset++)
+    if (memcmp(dump_data->data + offset, "SVN\1", 4) == 0)
+      break;
+  SVN_TEST_ASSERT(offset + 4 <= dump_data->len);
+
+  /* It must load like any other dump. */
+  SVN_ERR(svn_test__create_repos(&repos, "test-repo-dump-stored-deltas-2",
+                                 opts, pool));
+  SVN_ERR(svn_repos_load_fs7(repos,
+                             svn_stream_from_stringbuf(dump_data, pool),
+                             SVN_INVALID_REVNUM, SVN_INVALID_REVNUM,
+                             svn_repos_load_uuid_default, NULL,
+                             FALSE, FALSE, TRUE, FALSE, FALSE, FALSE,
+                             NULL, NULL, NULL, NULL, pool));
+
+  SVN_ERR(svn_fs_revision_root(&root, svn_repos_fs(repos), 2, pool));
+  SVN_ERR(svn_test__get_file_contents(root, "iota", &contents, pool));
+  SVN_TEST_STRING_ASSERT(contents->data, expected->data);
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_repos_notify_func_t.  Append a line describing NOTIFY
+   to the svn_stringbuf_t BATON. */
+static void
+notify_to_stringbuf(void *baton,
+                    const svn_repos_notify_t *notify,
+                    apr_pool_t *scratch_pool)
+{
+  svn_stringbuf_t *log = baton;
+
+  svn_stringbuf_appendcstr(log,
+                           apr_psprintf(scratch_pool, "%d %ld %s\n",
+                                        (int)notify->action,
+                                        notify->revision,
+                                        notify->warning_str
+                                          ? notify->warning_str : ""));
+}
+
+/* A dump generated by several threads must be identical to the serial
+   one, including the progress notifications. */
+static svn_error_t *
+test_dump_parallel(const svn_test_opts_t *opts,
+                   apr_pool_t *pool)
+{
+  svn_repos_t *repos;
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root;
+  svn_revnum_t youngest_rev = 0;
+  svn_stringbuf_t *serial_data, *parallel_data;
+  svn_stringbuf_t *serial_log, *parallel_log;
+  int i;
+
+  SVN_ERR(svn_test__create_repos(&repos, "test-repo-dump-parallel",
+                                 opts, pool));
+  fs = svn_repos_fs(repos);
+
+  /* r1: the Greek tree. */
+  SVN_ERR(svn_fs_begin_txn2(&txn, fs, youngest_rev, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_test__create_greek_tree(txn_root, pool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, pool));
+  SVN_TEST_ASSERT(SVN_IS_VALID_REVNUM(youngest_rev));
+
+  /* r2 .. r51: several ranges worth of changes, with copies from
+     earlier ranges. */
+  for (i = 0; i < 50; i++)
+    {
+      SVN_ERR(svn_fs_begin_txn2(&txn, fs, youngest_rev, 0, pool));
+      SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+      SVN_ERR(svn_test__set_file_contents(txn_root, "iota",
+                                          apr_psprintf(pool, "%d\n", i),
+                                          pool));
+      if (i % 10 == 9)
+        SVN_ERR(svn_fs_copy(txn_root, "A", txn_root,
+                            apr_psprintf(pool, "A%d", i), pool));
+      SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn,
+                                      pool));
+      SVN_TEST_ASSERT(SVN_IS_VALID_REVNUM(youngest_rev));
+    }
+
+  SVN_ERR(dump_with_deltas(&serial_data, repos, 1, pool));
+  SVN_ERR(dump_with_deltas(&parallel_data, repos, 4, pool));
+  SVN_TEST_ASSERT(svn_stringbuf_compare(serial_data, parallel_data));
+
+  /* Same for a partial dump without deltas, which also reports copies
+     from outside the dumped range. */
+  serial_data = svn_stringbuf_create_empty(pool);
+  parallel_data = svn_stringbuf_create_empty(pool);
+  serial_log = svn_stringbuf_create_empty(pool);
+  parallel_log = svn_stringbuf_create_empty(pool);
+  SVN_ERR(svn_repos_dump_fs5(repos,
+                             svn_stream_from_stringbuf(serial_data, pool),
+                             5, youngest_rev, FALSE, FALSE, TRUE, TRUE, 1,
+                             notify_to_stringbuf, serial_log,
+                             NULL, NULL, NULL, NULL, pool));
+  SVN_ERR(svn_repos_dump_fs5(repos,
+                             svn_stream_from_stringbuf(parallel_data, pool),
+                             5, youngest_rev, FALSE, FALSE, TRUE, TRUE, 3,
+                             notify_to_stringbuf, parallel_log,
+                             NULL, NULL, NULL, NULL, pool));
+  SVN_TEST_ASSERT(svn_stringbuf_compare(serial_data, parallel_data));
+  SVN_TEST_STRING_ASSERT(serial_log->data, parallel_log->data);
+
+  return SVN_NO_ERROR;
+}
+
 /* The test table.  */
 
 static int max_threads = 4;
@@ -284,6 +558,12 @@ static struct svn_test_descriptor_t test_funcs[] =
                        "test dumping with r0 mergeinfo"),
     SVN_TEST_OPTS_PASS(test_load_r0_mergeinfo,
                        "test loading with r0 mergeinfo"),
+    SVN_TEST_OPTS_PASS(test_load_pipelined,
+                       "test loading with a separate parser thread"),
+    SVN_TEST_OPTS_PASS(test_dump_parallel,
+                       "test dumping revision ranges in parallel"),
+    SVN_TEST_OPTS_PASS(test_dump_stored_deltas,
+                       "test dumping stored deltas as they are"),
     SVN_TEST_NULL
   };
 
@@ -0,0 +1,1041 @@
+/* repos-perf.c --- performance regression suite for the repository layer
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+/* Create deterministic, synthetic repositories with typical worst-case
+ * shapes -- deep trees, huge directories, long delta chains and heavy
+ * mergeinfo -- and time a set of FS, repos, delta and diff operations on
+ * them.  The results get written to stdout as a JSON document such that
+ * the output of two builds can be compared by a script.
+ *
+ * Per operation, we report the latency distribution and the membuffer
+ * cache usage.  "pool_bytes" is the peak pool memory use of a single run
+ * and requires APR to be built with pool debugging;  it is 0 otherwise.
+ *
+ * This is not part of 'make check'.  Use 'make perfcheck' or run the
+ * binary directly.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <apr_getopt.h>
+#include <apr_strings.h>
+
+#include "svn_cache_config.h"
+#include "svn_cmdline.h"
+#include "svn_delta.h"
+#include "svn_diff.h"
+#include "svn_dirent_uri.h"
+#include "svn_fs.h"
+#include "svn_hash.h"
+#include "svn_io.h"
+#include "svn_pools.h"
+#include "svn_props.h"
+#include "svn_repos.h"
+#include "svn_sorts.h"
+#include "svn_utf.h"
+#include "svn_version.h"
+
+#include "private/svn_cache.h"
+#include "private/svn_cmdline_private.h"
+#include "private/svn_fspath.h"
+#include "private/svn_string_private.h"
+
+#include "svn_private_config.h"
+
+/* Default multiplier for all scenario sizes. */
+#define DEFAULT_SCALE 1
+
+/* Default size of the membuffer cache in MB. */
+#define DEFAULT_CACHE_SIZE 64
+
+
+
+/*** Measurement infrastructure. ***/
+
+/* An operation to measure.  BATON is operation specific.  Use SCRATCH_POOL
+ * for all allocations;  it gets cleared after each run. */
+typedef svn_error_t *(*operation_t)(void *baton,
+                                    apr_pool_t *scratch_pool);
+
+/* Collects the results. */
+typedef struct perf_t
+{
+  /* The "operations" array of the JSON output, without the brackets. */
+  svn_stringbuf_t *json;
+
+  /* Number of entries in JSON. */
+  int count;
+} perf_t;
+
+/* Return the global membuffer cache statistics in *INFO.  Zero all
+ * counters if there is no such cache.  Use SCRATCH_POOL for temporary
+ * allocations. */
+static void
+get_cache_info(svn_cache__info_t *info,
+               apr_pool_t *scratch_pool)
+{
+  if (svn_cache__get_global_membuffer_cache())
+    *info = *svn_cache__membuffer_get_global_info(scratch_pool);
+  else
+    memset(info, 0, sizeof(*info));
+}
+
+/* qsort-compatible comparison function for apr_interval_time_t. */
+static int
+compare_times(const void *lhs,
+              const void *rhs)
+{
+  apr_interval_time_t lhs_value = *(const apr_interval_time_t *)lhs;
+  apr_interval_time_t rhs_value = *(const apr_interval_time_t *)rhs;
+
+  return lhs_value < rhs_value ? -1 : (lhs_value > rhs_value ? 1 : 0);
+}
+
+/* Run OPERATION with BATON ITERATIONS times and add its results to PERF
+ * under NAME.  Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+measure(perf_t *perf,
+        const char *name,
+        int iterations,
+        operation_t operation,
+        void *baton,
+        apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  apr_interval_time_t *times = apr_palloc(scratch_pool,
+                                          iterations * sizeof(*times));
+  apr_interval_time_t total = 0;
+  apr_size_t max_pool_bytes = 0;
+  svn_cache__info_t before, after;
+  int i;
+
+  get_cache_info(&before, scratch_pool);
+  for (i = 0; i < iterations; ++i)
+    {
+      apr_time_t start;
+
+      svn_pool_clear(iterpool);
+      start = apr_time_now();
+      SVN_ERR(operation(baton, iterpool));
+      times[i] = apr_time_now() - start;
+      total += times[i];
+
+#if APR_POOL_DEBUG
+      max_pool_bytes = MAX(max_pool_bytes, apr_pool_num_bytes(iterpool, 1));
+#endif
+    }
+  get_cache_info(&after, scratch_pool);
+  svn_pool_destroy(iterpool);
+
+  qsort(times, iterations, sizeof(*times), compare_times);
+
+  svn_stringbuf_appendcstr(perf->json,
+    apr_psprintf(scratch_pool,
+                 "%s\n    { \"name\": \"%s\", \"iterations\": %d,"
+                 " \"total_ms\": %.3f, \"min_ms\": %.3f,"
+                 " \"median_ms\": %.3f, \"max_ms\": %.3f,"
+                 " \"pool_bytes\": %" APR_SIZE_T_FMT ","
+                 " \"cache_gets\": %" APR_UINT64_T_FMT ","
+                 " \"cache_hits\": %" APR_UINT64_T_FMT ","
+                 " \"cache_sets\": %" APR_UINT64_T_FMT " }",
+                 perf->count ? "," : "",
+                 name, iterations,
+                 total / 1.0e3,
+                 times[0] / 1.0e3,
+                 times[iterations / 2] / 1.0e3,
+                 times[iterations - 1] / 1.0e3,
+                 max_pool_bytes,
+                 after.gets - before.gets,
+                 after.hits - before.hits,
+                 after.sets - before.sets));
+  ++perf->count;
+
+  return SVN_NO_ERROR;
+}
+
+
+
+/*** Repository helpers. ***/
+
+/* The repository and its FS plus the scenario size multiplier. */
+typedef struct bench_repos_t
+{
+  svn_repos_t *repos;
+  svn_fs_t *fs;
+  int scale;
+} bench_repos_t;
+
+/* Set the contents of the file PATH in ROOT to CONTENTS.  Use
+ * SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+set_file_contents(svn_fs_root_t *root,
+                  const char *path,
+                  const char *contents,
+                  apr_pool_t *scratch_pool)
+{
+  svn_stream_t *stream;
+
+  SVN_ERR(svn_fs_apply_text(&stream, root, path, NULL, scratch_pool));
+  SVN_ERR(svn_stream_puts(stream, contents));
+
+  return svn_error_trace(svn_stream_close(stream));
+}
+
+/* Begin a transaction on top of HEAD in B and return it in *TXN along
+ * with its root in *ROOT.  Allocate both in POOL. */
+static svn_error_t *
+begin_txn(svn_fs_txn_t **txn,
+          svn_fs_root_t **root,
+          bench_repos_t *b,
+          apr_pool_t *pool)
+{
+  svn_revnum_t youngest;
+
+  SVN_ERR(svn_fs_youngest_rev(&youngest, b->fs, pool));
+  SVN_ERR(svn_fs_begin_txn2(txn, b->fs, youngest, 0, pool));
+
+  return svn_error_trace(svn_fs_txn_root(root, *txn, pool));
+}
+
+/* Commit TXN to the repository in B.  Use SCRATCH_POOL for temporary
+ * allocations. */
+static svn_error_t *
+commit_txn(bench_repos_t *b,
+           svn_fs_txn_t *txn,
+           apr_pool_t *scratch_pool)
+{
+  svn_revnum_t new_rev;
+
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, b->repos, &new_rev, txn,
+                                  scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Return the HEAD root of the repository in B in *ROOT, allocated in
+ * POOL. */
+static svn_error_t *
+head_root(svn_fs_root_t **root,
+          bench_repos_t *b,
+          apr_pool_t *pool)
+{
+  svn_revnum_t youngest;
+
+  SVN_ERR(svn_fs_youngest_rev(&youngest, b->fs, pool));
+
+  return svn_error_trace(svn_fs_revision_root(root, b->fs, youngest, pool));
+}
+
+/* Return LINES lines of pseudo-random, but reproducible text allocated in
+ * POOL.  Lines with a number divisible by CHANGE_EVERY get the text
+ * VARIANT, if CHANGE_EVERY is not 0. */
+static svn_stringbuf_t *
+make_text(int lines,
+          int change_every,
+          const char *variant,
+          apr_pool_t *pool)
+{
+  svn_stringbuf_t *text = svn_stringbuf_create_ensure(lines * 40, pool);
+  apr_uint32_t seed = 1;
+  int i;
+
+  for (i = 0; i < lines; ++i)
+    {
+      seed = seed * 1103515245 + 12345;
+      if (change_every && i % change_every == 0)
+        svn_stringbuf_appendcstr(text, apr_psprintf(pool, "%s %d\n",
+                                                    variant, i));
+      else
+        svn_stringbuf_appendcstr(text, apr_psprintf(pool,
+                                                    "line %d: %08x %08x\n",
+                                                    i, seed, ~seed));
+    }
+
+  return text;
+}
+
+/* Implements svn_repos_log_entry_receiver_t, ignoring everything. */
+static svn_error_t *
+null_log_receiver(void *baton,
+                  svn_repos_log_entry_t *log_entry,
+                  apr_pool_t *scratch_pool)
+{
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_file_rev_handler_t, consuming all deltas. */
+static svn_error_t *
+null_file_rev_handler(void *baton,
+                      const char *path,
+                      svn_revnum_t rev,
+                      apr_hash_t *rev_props,
+                      svn_boolean_t result_of_merge,
+                      svn_txdelta_window_handler_t *delta_handler,
+                      void **delta_baton,
+                      apr_array_header_t *prop_diffs,
+                      apr_pool_t *pool)
+{
+  if (delta_handler)
+    {
+      *delta_handler = svn_delta_noop_window_handler;
+      *delta_baton = NULL;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_fs_mergeinfo_receiver_t, counting the paths in the
+ * apr_int64_t BATON. */
+static svn_error_t *
+count_mergeinfo(const char *path,
+                svn_mergeinfo_t mergeinfo,
+                void *baton,
+                apr_pool_t *scratch_pool)
+{
+  apr_int64_t *count = baton;
+  ++*count;
+
+  return SVN_NO_ERROR;
+}
+
+/* Get the log for PATH in B.  Use SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+get_log(bench_repos_t *b,
+        const char *path,
+        apr_pool_t *scratch_pool)
+{
+  apr_array_header_t *paths = apr_array_make(scratch_pool, 1,
+                                             sizeof(const char *));
+  svn_revnum_t youngest;
+
+  SVN_ERR(svn_fs_youngest_rev(&youngest, b->fs, scratch_pool));
+  APR_ARRAY_PUSH(paths, const char *) = path;
+
+  return svn_error_trace(svn_repos_get_logs5(b->repos, paths, youngest, 0,
+                                             0, FALSE, FALSE, NULL,
+                                             NULL, NULL,
+                                             NULL, NULL,
+                                             null_log_receiver, NULL,
+                                             scratch_pool));
+}
+
+
+
+/*** Deep tree scenario. ***/
+
+/* Return the path of the leaf file in the deep tree of B. */
+static const char *
+deep_leaf(bench_repos_t *b,
+          apr_pool_t *pool)
+{
+  const char *path = "/deep";
+  int i;
+
+  for (i = 0; i < 32 * b->scale; ++i)
+    path = apr_psprintf(pool, "%s/d%d", path, i);
+
+  return svn_fspath__join(path, "leaf", pool);
+}
+
+static svn_error_t *
+deep_tree_create(void *baton,
+                 apr_pool_t *scratch_pool)
+{
+  bench_repos_t *b = baton;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *root;
+  const char *path = "/deep";
+  int i;
+
+  SVN_ERR(begin_txn(&txn, &root, b, scratch_pool));
+  SVN_ERR(svn_fs_make_dir(root, path, scratch_pool));
+  for (i = 0; i < 32 * b->scale; ++i)
+    {
+      path = apr_psprintf(scratch_pool, "%s/d%d", path, i);
+      SVN_ERR(svn_fs_make_dir(root, path, scratch_pool));
+    }
+
+  path = svn_fspath__join(path, "leaf", scratch_pool);
+  SVN_ERR(svn_fs_make_file(root, path, scratch_pool));
+  SVN_ERR(set_file_contents(root, path, "leaf\n", scratch_pool));
+
+  return svn_error_trace(commit_txn(b, txn, scratch_pool));
+}
+
+static svn_error_t *
+deep_tree_modify_leaf(void *baton,
+                      apr_pool_t *scratch_pool)
+{
+  bench_repos_t *b = baton;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *root;
+  const char *leaf = deep_leaf(b, scratch_pool);
+  svn_stringbuf_t *contents;
+  svn_stream_t *stream;
+
+  SVN_ERR(begin_txn(&txn, &root, b, scratch_pool));
+  SVN_ERR(svn_fs_file_contents(&stream, root, leaf, scratch_pool));
+  SVN_ERR(svn_stringbuf_from_stream(&contents, stream, 0, scratch_pool));
+  svn_stringbuf_appendcstr(contents, "more\n");
+  SVN_ERR(set_file_contents(root, leaf, contents->data, scratch_pool));
+
+  return svn_error_trace(commit_txn(b, txn, scratch_pool));
+}
+
+static svn_error_t *
+deep_tree_check_leaf(void *baton,
+                     apr_pool_t *scratch_pool)
+{
+  bench_repos_t *b = baton;
+  svn_fs_root_t *root;
+  svn_node_kind_t kind;
+
+  SVN_ERR(head_root(&root, b, scratch_pool));
+  SVN_ERR(svn_fs_check_path(&kind, root, deep_leaf(b, scratch_pool),
+                            scratch_pool));
+  SVN_ERR_ASSERT(kind == svn_node_file);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+deep_tree_log_leaf(void *baton,
+                   apr_pool_t *scratch_pool)
+{
+  bench_repos_t *b = baton;
+
+  return svn_error_trace(get_log(b, deep_leaf(b, scratch_pool),
+                                 scratch_pool));
+}
+
+/* Create the deep tree in B and measure operations on it.  Add the
+ * results to PERF.  Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+bench_deep_tree(perf_t *perf,
+                bench_repos_t *b,
+                apr_pool_t *scratch_pool)
+{
+  SVN_ERR(measure(perf, "deep_tree.create", 1, deep_tree_create, b,
+                  scratch_pool));
+  SVN_ERR(measure(perf, "deep_tree.modify_leaf", 20, deep_tree_modify_leaf,
+                  b, scratch_pool));
+  SVN_ERR(measure(perf, "deep_tree.check_leaf", 100, deep_tree_check_leaf,
+                  b, scratch_pool));
+  SVN_ERR(measure(perf, "deep_tree.log_leaf", 10, deep_tree_log_leaf, b,
+                  scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+
+
+/*** Huge directory scenario. ***/
+
+/* Number of files in the huge directory of B. */
+#define HUGE_DIR_SIZE(b) (5000 * (b)->scale)
+
+static svn_error_t *
+huge_dir_create(void *baton,
+                apr_pool_t *scratch_pool)
+{
+  bench_repos_t *b = baton;
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *root;
+  int i;
+
+  SVN_ERR(begin_txn(&txn, &root, b, scratch_pool));
+  SVN_ERR(svn_fs_make_dir(root, "/huge", scratch_pool));
+  for (i = 0; i < HUGE_DIR_SIZE(b); ++i)
+    {
+      const char *path;
+
+      svn_pool_clear(iterpool);
+      path = apr_psprintf(iterpool, "/huge/file-%d", i);
+      SVN_ERR(svn_fs_make_file(root, path, iterpool));
+      SVN_ERR(set_file_contents(root, path, path, iterpool));
+    }
+  svn_pool_destroy(iterpool);
+
+  return svn_error_trace(commit_txn(b, txn, scratch_pool));
+}
+
+/* Counter for huge_dir_modify_one such that every run touches another
+ * file. */
+static int huge_dir_modifications = 0;
+
+static svn_error_t *
+huge_dir_modify_one(void *baton,
+                    apr_pool_t *scratch_pool)
+{
+  bench_repos_t *b = baton;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *root;
+  const char *path;
+
+  path = apr_psprintf(scratch_pool, "/huge/file-%d",
+                      (huge_dir_modifications++ * 97) % HUGE_DIR_SIZE(b));
+
+  SVN_ERR(begin_txn(&txn, &root, b, scratch_pool));
+  SVN_ERR(set_file_contents(root, path, "modified", scratch_pool));
+
+  return svn_error_trace(commit_txn(b, txn, scratch_pool));
+}
+
+static svn_error_t *
+huge_dir_list(void *baton,
+              apr_pool_t *scratch_pool)
+{
+  bench_repos_t *b = baton;
+  svn_fs_root_t *root;
+  apr_hash_t *entries;
+
+  SVN_ERR(head_root(&root, b, scratch_pool));
+  SVN_ERR(svn_fs_dir_entries(&entries, root, "/huge", scratch_pool));
+  SVN_ERR_ASSERT(apr_hash_count(entries) == HUGE_DIR_SIZE(b));
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+huge_dir_stat_all(void *baton,
+                  apr_pool_t *scratch_pool)
+{
+  bench_repos_t *b = baton;
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  svn_fs_root_t *root;
+  int i;
+
+  SVN_ERR(head_root(&root, b, scratch_pool));
+  for (i = 0; i < HUGE_DIR_SIZE(b); ++i)
+    {
+      svn_filesize_t length;
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_fs_file_length(&length, root,
+                                 apr_psprintf(iterpool, "/huge/file-%d", i),
+                                 iterpool));
+    }
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Create the huge directory in B and measure operations on it.  Add the
+ * results to PERF.  Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+bench_huge_dir(perf_t *perf,
+               bench_repos_t *b,
+               apr_pool_t *scratch_pool)
+{
+  SVN_ERR(measure(perf, "huge_dir.create", 1, huge_dir_create, b,
+                  scratch_pool));
+  SVN_ERR(measure(perf, "huge_dir.modify_one", 20, huge_dir_modify_one, b,
+                  scratch_pool));
+  SVN_ERR(measure(perf, "huge_dir.list", 20, huge_dir_list, b,
+                  scratch_pool));
+  SVN_ERR(measure(perf, "huge_dir.stat_all", 3, huge_dir_stat_all, b,
+                  scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+
+
+/*** Long delta chain scenario. ***/
+
+/* Counter for delta_chain_commit such that every run makes another
+ * change. */
+static int delta_chain_length = 0;
+
+static svn_error_t *
+delta_chain_commit(void *baton,
+                   apr_pool_t *scratch_pool)
+{
+  bench_repos_t *b = baton;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *root;
+  svn_stringbuf_t *text;
+
+  SVN_ERR(begin_txn(&txn, &root, b, scratch_pool));
+  if (delta_chain_length++ == 0)
+    SVN_ERR(svn_fs_make_file(root, "/chain", scratch_pool));
+
+  /* Change every 100th line, another set of lines each time. */
+  text = make_text(2000, 100,
+                   apr_psprintf(scratch_pool, "change %d",
+                                delta_chain_length),
+                   scratch_pool);
+  SVN_ERR(set_file_contents(root, "/chain", text->data, scratch_pool));
+
+  return svn_error_trace(commit_txn(b, txn, scratch_pool));
+}
+
+static svn_error_t *
+delta_chain_read_head(void *baton,
+                      apr_pool_t *scratch_pool)
+{
+  bench_repos_t *b = baton;
+  svn_fs_root_t *root;
+  svn_stream_t *contents;
+
+  SVN_ERR(head_root(&root, b, scratch_pool));
+  SVN_ERR(svn_fs_file_contents(&contents, root, "/chain", scratch_pool));
+
+  return svn_error_trace(svn_stream_copy3(contents,
+                                          svn_stream_empty(scratch_pool),
+                                          NULL, NULL, scratch_pool));
+}
+
+static svn_error_t *
+delta_chain_file_revs(void *baton,
+                      apr_pool_t *scratch_pool)
+{
+  bench_repos_t *b = baton;
+  svn_revnum_t youngest;
+
+  SVN_ERR(svn_fs_youngest_rev(&youngest, b->fs, scratch_pool));
+
+  return svn_error_trace(svn_repos_get_file_revs2(b->repos, "/chain", 0,
+                                                  youngest, FALSE,
+                                                  NULL, NULL,
+                                                  null_file_rev_handler,
+                                                  NULL, scratch_pool));
+}
+
+static svn_error_t *
+delta_chain_log(void *baton,
+                apr_pool_t *scratch_pool)
+{
+  return svn_error_trace(get_log(baton, "/chain", scratch_pool));
+}
+
+/* Create the long delta chain in B and measure operations on it.  Add the
+ * results to PERF.  Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+bench_delta_chain(perf_t *perf,
+                  bench_repos_t *b,
+                  apr_pool_t *scratch_pool)
+{
+  SVN_ERR(measure(perf, "delta_chain.commit", 200 * b->scale,
+                  delta_chain_commit, b, scratch_pool));
+  SVN_ERR(measure(perf, "delta_chain.read_head", 20, delta_chain_read_head,
+                  b, scratch_pool));
+  SVN_ERR(measure(perf, "delta_chain.file_revs", 3, delta_chain_file_revs,
+                  b, scratch_pool));
+  SVN_ERR(measure(perf, "delta_chain.log", 10, delta_chain_log, b,
+                  scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+
+
+/*** Heavy mergeinfo scenario. ***/
+
+/* Number of sub-directories of /trunk with their own mergeinfo. */
+#define MERGEINFO_SUBDIRS 20
+
+/* Counter for mergeinfo_branch such that every run creates another
+ * branch. */
+static int mergeinfo_branches = 0;
+
+static svn_error_t *
+mergeinfo_create_trunk(void *baton,
+                       apr_pool_t *scratch_pool)
+{
+  bench_repos_t *b = baton;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *root;
+  int i;
+
+  SVN_ERR(begin_txn(&txn, &root, b, scratch_pool));
+  SVN_ERR(svn_fs_make_dir(root, "/trunk", scratch_pool));
+  SVN_ERR(svn_fs_make_dir(root, "/branches", scratch_pool));
+  for (i = 0; i < MERGEINFO_SUBDIRS; ++i)
+    {
+      const char *dir = apr_psprintf(scratch_pool, "/trunk/sub-%d", i);
+      const char *file = svn_fspath__join(dir, "file", scratch_pool);
+
+      SVN_ERR(svn_fs_make_dir(root, dir, scratch_pool));
+      SVN_ERR(svn_fs_make_file(root, file, scratch_pool));
+      SVN_ERR(set_file_contents(root, file, file, scratch_pool));
+    }
+
+  return svn_error_trace(commit_txn(b, txn, scratch_pool));
+}
+
+/* Return the mergeinfo for a merge of all branches created before into
+ * the /trunk sub-tree SUB_PATH, which is "" for /trunk itself.  Branch J
+ * has been created in revision TRUNK_REV + 1 + J.  Allocate the result in
+ * POOL. */
+static svn_string_t *
+make_mergeinfo(const char *sub_path,
+               svn_revnum_t trunk_rev,
+               apr_pool_t *pool)
+{
+  svn_stringbuf_t *mergeinfo = svn_stringbuf_create_empty(pool);
+  int i;
+
+  for (i = 0; i < mergeinfo_branches; ++i)
+    svn_stringbuf_appendcstr(mergeinfo,
+                             apr_psprintf(pool, "%s/branches/b%d%s:%ld",
+                                          i ? "\n" : "", i, sub_path,
+                                          trunk_rev + 1 + i));
+
+  return svn_stringbuf__morph_into_string(mergeinfo);
+}
+
+/* Create another branch of /trunk and record a merge of all previous
+ * branches back into /trunk and, as sub-tree mergeinfo, into all its
+ * sub-directories. */
+static svn_error_t *
+mergeinfo_branch(void *baton,
+                 apr_pool_t *scratch_pool)
+{
+  bench_repos_t *b = baton;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *root, *head;
+  svn_revnum_t trunk_rev;
+  const char *branch;
+  int i;
+
+  SVN_ERR(head_root(&head, b, scratch_pool));
+  SVN_ERR(svn_fs_node_created_rev(&trunk_rev, head, "/trunk/sub-0/file",
+                                  scratch_pool));
+
+  SVN_ERR(begin_txn(&txn, &root, b, scratch_pool));
+  if (mergeinfo_branches)
+    SVN_ERR(svn_fs_change_node_prop(root, "/trunk", SVN_PROP_MERGEINFO,
+                                    make_mergeinfo("", trunk_rev,
+                                                   scratch_pool),
+                                    scratch_pool));
+  for (i = 0; mergeinfo_branches && i < MERGEINFO_SUBDIRS; ++i)
+    {
+      const char *sub_path = apr_psprintf(scratch_pool, "/sub-%d", i);
+
+      SVN_ERR(svn_fs_change_node_prop(
+                root, svn_fspath__join("/trunk", sub_path + 1, scratch_pool),
+                SVN_PROP_MERGEINFO,
+                make_mergeinfo(sub_path, trunk_rev, scratch_pool),
+                scratch_pool));
+    }
+
+  branch = apr_psprintf(scratch_pool, "/branches/b%d",
+                        mergeinfo_branches++);
+  SVN_ERR(svn_fs_copy(head, "/trunk", root, branch, scratch_pool));
+
+  return svn_error_trace(commit_txn(b, txn, scratch_pool));
+}
+
+/* Read all mergeinfo at and below PATH in HEAD of B, inherited or not. */
+static svn_error_t *
+get_mergeinfo(bench_repos_t *b,
+              const char *path,
+              apr_pool_t *scratch_pool)
+{
+  apr_array_header_t *paths = apr_array_make(scratch_pool, 1,
+                                             sizeof(const char *));
+  svn_fs_root_t *root;
+  apr_int64_t count = 0;
+
+  SVN_ERR(head_root(&root, b, scratch_pool));
+  APR_ARRAY_PUSH(paths, const char *) = path;
+
+  SVN_ERR(svn_fs_get_mergeinfo3(root, paths, svn_mergeinfo_inherited, TRUE,
+                                TRUE, count_mergeinfo, &count,
+                                scratch_pool));
+  SVN_ERR_ASSERT(count > 0);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+mergeinfo_get_trunk(void *baton,
+                    apr_pool_t *scratch_pool)
+{
+  return svn_error_trace(get_mergeinfo(baton, "/trunk", scratch_pool));
+}
+
+static svn_error_t *
+mergeinfo_get_branch(void *baton,
+                     apr_pool_t *scratch_pool)
+{
+  return svn_error_trace(get_mergeinfo(baton, "/branches/b1/sub-0",
+                                       scratch_pool));
+}
+
+static svn_error_t *
+mergeinfo_log(void *baton,
+              apr_pool_t *scratch_pool)
+{
+  bench_repos_t *b = baton;
+  apr_array_header_t *paths = apr_array_make(scratch_pool, 1,
+                                             sizeof(const char *));
+  svn_revnum_t youngest;
+
+  SVN_ERR(svn_fs_youngest_rev(&youngest, b->fs, scratch_pool));
+  APR_ARRAY_PUSH(paths, const char *) = "/trunk";
+
+  return svn_error_trace(svn_repos_get_logs5(b->repos, paths, youngest, 0,
+                                             0, FALSE, TRUE, NULL,
+                                             NULL, NULL,
+                                             NULL, NULL,
+                                             null_log_receiver, NULL,
+                                             scratch_pool));
+}
+
+/* Create the mergeinfo-heavy tree in B and measure operations on it.
+ * Add the results to PERF.  Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+bench_mergeinfo(perf_t *perf,
+                bench_repos_t *b,
+                apr_pool_t *scratch_pool)
+{
+  SVN_ERR(measure(perf, "mergeinfo.create_trunk", 1, mergeinfo_create_trunk,
+                  b, scratch_pool));
+  SVN_ERR(measure(perf, "mergeinfo.branch", 50 * b->scale, mergeinfo_branch,
+                  b, scratch_pool));
+  SVN_ERR(measure(perf, "mergeinfo.get_trunk", 10, mergeinfo_get_trunk, b,
+                  scratch_pool));
+  SVN_ERR(measure(perf, "mergeinfo.get_branch", 100, mergeinfo_get_branch,
+                  b, scratch_pool));
+  SVN_ERR(measure(perf, "mergeinfo.log_merged", 3, mergeinfo_log, b,
+                  scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+
+
+/*** Delta and diff scenarios. ***/
+
+/* Two versions of a text for the delta and diff benchmarks. */
+typedef struct text_pair_t
+{
+  svn_string_t *source;
+  svn_string_t *target;
+} text_pair_t;
+
+static svn_error_t *
+delta_texts(void *baton,
+            apr_pool_t *scratch_pool)
+{
+  text_pair_t *texts = baton;
+  svn_txdelta_stream_t *delta;
+
+  svn_txdelta2(&delta,
+               svn_stream_from_string(texts->source, scratch_pool),
+               svn_stream_from_string(texts->target, scratch_pool),
+               FALSE, scratch_pool);
+
+  return svn_error_trace(svn_txdelta_send_txstream(
+                           delta, svn_delta_noop_window_handler, NULL,
+                           scratch_pool));
+}
+
+static svn_error_t *
+diff_texts(void *baton,
+           apr_pool_t *scratch_pool)
+{
+  text_pair_t *texts = baton;
+  svn_diff_file_options_t *options
+    = svn_diff_file_options_create(scratch_pool);
+  svn_diff_t *diff;
+
+  SVN_ERR(svn_diff_mem_string_diff(&diff, texts->source, texts->target,
+                                   options, scratch_pool));
+  SVN_ERR_ASSERT(svn_diff_contains_diffs(diff));
+
+  return SVN_NO_ERROR;
+}
+
+/* Measure the delta and diff scenarios, scaled by SCALE.  Add the results
+ * to PERF.  Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+bench_texts(perf_t *perf,
+            int scale,
+            apr_pool_t *scratch_pool)
+{
+  text_pair_t texts;
+  int lines = 20000 * scale;
+
+  texts.source = svn_stringbuf__morph_into_string(
+                   make_text(lines, 0, NULL, scratch_pool));
+  texts.target = svn_stringbuf__morph_into_string(
+                   make_text(lines, 50, "modified", scratch_pool));
+
+  SVN_ERR(measure(perf, "delta.txdelta", 10, delta_texts, &texts,
+                  scratch_pool));
+  SVN_ERR(measure(perf, "diff.mem_string", 10, diff_texts, &texts,
+                  scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+
+
+/*** Main. ***/
+
+static const apr_getopt_option_t options[] =
+{
+  {"fs-type", 'f', 1, "repository back-end type (default: fsfs)"},
+  {"scale", 's', 1, "multiply all scenario sizes by ARG (default: 1)"},
+  {"memory-cache-size", 'M', 1, "size of the membuffer cache in MB"},
+  {"help", 'h', 0, "show this help"},
+  {0, 0, 0, 0}
+};
+
+/* Print the usage message to stdout.  Use POOL for allocations. */
+static svn_error_t *
+print_usage(apr_pool_t *pool)
+{
+  int i;
+
+  SVN_ERR(svn_cmdline_fputs("usage: repos-perf [OPTIONS] DIR\n"
+                            "\n"
+                            "Create repositories below DIR and write "
+                            "timings as JSON to stdout.\n"
+                            "\n"
+                            "Options:\n", stdout, pool));
+  for (i = 0; options[i].name; ++i)
+    SVN_ERR(svn_cmdline_printf(pool, "  --%-20s %s\n", options[i].name,
+                               options[i].description));
+
+  return SVN_NO_ERROR;
+}
+
+/* Parse the command line in ARGC, ARGV and run all benchmarks.  Use POOL
+ * for allocations. */
+static svn_error_t *
+sub_main(int argc,
+         const char *argv[],
+         apr_pool_t *pool)
+{
+  apr_getopt_t *os;
+  const char *fs_type = "fsfs";
+  const char *dir;
+  int scale = DEFAULT_SCALE;
+  apr_uint64_t cache_size = DEFAULT_CACHE_SIZE;
+  svn_cache_config_t settings;
+  apr_hash_t *fs_config = apr_hash_make(pool);
+  bench_repos_t b;
+  perf_t perf;
+  apr_status_t status;
+  const char *repos_path;
+
+  SVN_ERR(svn_cmdline__getopt_init(&os, argc, argv, pool));
+  os->interleave = 1;
+  while (1)
+    {
+      int opt;
+      const char *arg;
+
+      status = apr_getopt_long(os, options, &opt, &arg);
+      if (APR_STATUS_IS_EOF(status))
+        break;
+      if (status != APR_SUCCESS)
+        return svn_error_wrap_apr(status, NULL);
+
+      switch (opt)
+        {
+          case 'f':
+            fs_type = arg;
+            break;
+          case 's':
+            SVN_ERR(svn_cstring_atoi(&scale, arg));
+            break;
+          case 'M':
+            SVN_ERR(svn_cstring_atoui64(&cache_size, arg));
+            break;
+          case 'h':
+            return svn_error_trace(print_usage(pool));
+        }
+    }
+
+  if (os->ind + 1 != argc || scale < 1)
+    {
+      SVN_ERR(print_usage(pool));
+      return svn_error_create(SVN_ERR_CL_ARG_PARSING_ERROR, NULL, NULL);
+    }
+
+  SVN_ERR(svn_utf_cstring_to_utf8(&dir, os->argv[os->ind], pool));
+  dir = svn_dirent_internal_style(dir, pool);
+
+  settings = *svn_cache_config_get();
+  settings.cache_size = cache_size * 0x100000;
+  svn_cache_config_set(&settings);
+
+  /* Start from scratch every time to keep the results comparable. */
+  repos_path = svn_dirent_join(dir, "repos-perf", pool);
+  SVN_ERR(svn_io_remove_dir2(repos_path, TRUE, NULL, NULL, pool));
+  SVN_ERR(svn_io_make_dir_recursively(dir, pool));
+
+  svn_hash_sets(fs_config, SVN_FS_CONFIG_FS_TYPE, fs_type);
+  SVN_ERR(svn_repos_create(&b.repos, repos_path, NULL, NULL, NULL,
+                           fs_config, pool));
+  b.fs = svn_repos_fs(b.repos);
+  b.scale = scale;
+
+  perf.json = svn_stringbuf_create_empty(pool);
+  perf.count = 0;
+
+  SVN_ERR(bench_deep_tree(&perf, &b, pool));
+  SVN_ERR(bench_huge_dir(&perf, &b, pool));
+  SVN_ERR(bench_delta_chain(&perf, &b, pool));
+  SVN_ERR(bench_mergeinfo(&perf, &b, pool));
+  SVN_ERR(bench_texts(&perf, scale, pool));
+
+  SVN_ERR(svn_cmdline_printf(pool,
+                             "{\n"
+                             "  \"version\": \"%s\",\n"
+                             "  \"fs_type\": \"%s\",\n"
+                             "  \"scale\": %d,\n"
+                             "  \"cache_size_mb\": %" APR_UINT64_T_FMT ",\n"
+                             "  \"operations\": [%s\n"
+                             "  ]\n"
+                             "}\n",
+                             SVN_VERSION, fs_type, scale, cache_size,
+                             perf.json->data));
+
+  return svn_error_trace(svn_repos_delete(repos_path, pool));
+}
+
+int
+main(int argc, const char *argv[])
+{
+  apr_pool_t *pool;
+  svn_error_t *err;
+
+  if (svn_cmdline_init("repos-perf", stderr) != EXIT_SUCCESS)
+    return EXIT_FAILURE;
+
+  pool = svn_pool_create(NULL);
+  err = sub_main(argc, argv, pool);
+  if (err)
+    return svn_cmdline_handle_exit_error(err, pool, "repos-perf: ");
+
+  svn_pool_destroy(pool);
+  return EXIT_SUCCESS;
+}
@@ -40,6 +40,7 @@
 #include "svn_sorts.h"
 #include "svn_version.h"
 #include "private/svn_repos_private.h"
+#include "private/svn_mergeinfo_private.h"
 #include "private/svn_dep_compat.h"
 
 /* be able to look into svn_config_t */
@@ -74,7 +75,7 @@ dir_deltas(const svn_test_opts_t *opts,
   svn_repos_t *repos;
   svn_fs_t *fs;
   svn_fs_txn_t *txn;
-  svn_fs_root_t *txn_root, *revision_root;
+  svn_fs_root_t *txn_root, *revision_root, *source_root;
   svn_revnum_t youngest_rev;
   void *edit_baton;
   const svn_delta_editor_t *editor;
@@ -85,13 +86,13 @@ dir_deltas(const svn_test_opts_t *opts,
 
   /* The Test Plan
 
-     The filesystem function svn_repos_dir_delta2 exists to drive an
+     The filesystem function svn_repos_dir_delta3 exists to drive an
      editor in such a way that given a source tree S and a target tree
      T, that editor manipulation will transform S into T, insomuch as
      directories and files, and their contents and properties, go.
      The general notion of the test plan will be to create pairs of
      trees (S, T), and an editor that edits a copy of tree S, run them
-     through svn_repos_dir_delta2, and then verify that the edited copy of
+     through svn_repos_dir_delta3, and then verify that the edited copy of
      S is identical to T when it is all said and done.  */
 
   /* Create a filesystem and repository. */
@@ -334,7 +335,7 @@ dir_deltas(const svn_test_opts_t *opts,
       for (j = 0; j < revision_count; j++)
         {
           /* Prepare a txn that will receive the changes from
-             svn_repos_dir_delta2 */
+             svn_repos_dir_delta3 */
           SVN_ERR(svn_fs_begin_txn(&txn, fs, i, subpool));
           SVN_ERR(svn_fs_txn_root(&txn_root, txn, subpool));
 
@@ -348,7 +349,7 @@ dir_deltas(const svn_test_opts_t *opts,
 
           /* Here's the kicker...do the directory delta. */
           SVN_ERR(svn_fs_revision_root(&revision_root, fs, j, subpool));
-          SVN_ERR(svn_repos_dir_delta2(txn_root,
+          SVN_ERR(svn_repos_dir_delta3(txn_root,
                                        "",
                                        "",
                                        revision_root,
@@ -361,6 +362,7 @@ dir_deltas(const svn_test_opts_t *opts,
                                        svn_depth_infinity,
                                        FALSE,
                                        FALSE,
+                                       1,
                                        subpool));
 
           /* Hopefully at this point our transaction has been modified
@@ -374,6 +376,31 @@ dir_deltas(const svn_test_opts_t *opts,
              transaction...so we'll abort it (good for software, bad
              bad bad for society). */
           svn_error_clear(svn_fs_abort_txn(txn, subpool));
+
+          /* Same again, but compare revision roots with several threads.
+             The editor must still see a valid, ordered sequence of calls. */
+          SVN_ERR(svn_fs_begin_txn(&txn, fs, i, subpool));
+          SVN_ERR(svn_fs_txn_root(&txn_root, txn, subpool));
+          SVN_ERR(svn_fs_revision_root(&source_root, fs, i, subpool));
+          SVN_ERR(dir_delta_get_editor(&editor,
+                                       &edit_baton,
+                                       fs,
+                                       txn_root,
+                                       "",
+                                       subpool));
+          SVN_ERR(svn_repos_dir_delta3(source_root, "", "",
+                                       revision_root, "",
+                                       editor, edit_baton,
+                                       NULL, NULL,
+                                       TRUE, svn_depth_infinity,
+                                       FALSE, FALSE,
+                                       4,
+                                       subpool));
+          SVN_ERR(svn_test__validate_tree
+                  (txn_root, expected_trees[j].entries,
+                   expected_trees[j].num_entries, subpool));
+          svn_error_clear(svn_fs_abort_txn(txn, subpool));
+
           svn_pool_clear(subpool);
         }
     }
@@ -1177,8 +1204,23 @@ struct check_access_tests {
   const svn_boolean_t expected;
 };
 
+/* Return TRUE, iff tests A and B only differ in their paths.
+ * Either repository name or user may be NULL. */
+static svn_boolean_t
+same_check_access_params(const struct check_access_tests *a,
+                         const struct check_access_tests *b)
+{
+  return a->required == b->required
+      && (a->repo_name == b->repo_name
+          || (a->repo_name && b->repo_name
+              && !strcmp(a->repo_name, b->repo_name)))
+      && (a->user == b->user
+          || (a->user && b->user && !strcmp(a->user, b->user)));
+}
+
 /* Helper for the authz test.  Runs a set of tests against AUTHZ_CFG
- * as defined in TESTS. */
+ * as defined in TESTS.  Consecutive tests with the same parameters
+ * get checked with svn_repos_authz_check_access_many() first. */
 static svn_error_t *
 authz_check_access(svn_authz_t *authz_cfg,
                    const struct check_access_tests *tests,
@@ -1186,6 +1228,50 @@ authz_check_access(svn_authz_t *authz_cfg,
 {
   int i;
   svn_boolean_t access_granted;
+  apr_array_header_t *paths = apr_array_make(pool, 16, sizeof(const char *));
+
+  /* Batch check runs of tests whose paths are all set. */
+  for (i = 0; !(tests[i].path == NULL
+               && tests[i].required == svn_authz_none); )
+    {
+      apr_array_header_t *granted;
+      int first = i;
+      int k;
+
+      apr_array_clear(paths);
+      for (; tests[i].path && same_check_access_params(&tests[first],
+                                                       &tests[i]); ++i)
+        APR_ARRAY_PUSH(paths, const char *) = tests[i].path;
+
+      if (paths->nelts == 0)
+        {
+          ++i;
+          continue;
+        }
+
+      SVN_ERR(svn_repos_authz_check_access_many(&granted, authz_cfg,
+                                                tests[first].repo_name,
+                                                paths, tests[first].user,
+                                                tests[first].required,
+                                                pool, pool));
+      SVN_TEST_ASSERT(granted->nelts == paths->nelts);
+
+      for (k = 0; k < paths->nelts; ++k)
+        if (APR_ARRAY_IDX(granted, k, svn_boolean_t)
+            != tests[first + k].expected)
+          return svn_error_createf(SVN_ERR_TEST_FAILED, NULL,
+                                   "Batched authz check incorrectly %s "
+                                   "access to %s%s%s for user %s",
+                                   tests[first + k].expected
+                                   ? "denies" : "grants",
+                                   tests[first].repo_name ?
+                                   tests[first].repo_name : "",
+                                   tests[first].repo_name ?
+                                   ":" : "",
+                                   tests[first + k].path,
+                                   tests[first].user ?
+                                   tests[first].user : "-");
+    }
 
   /* Loop over the test array and test each case. */
   for (i = 0; !(tests[i].path == NULL
@@ -3074,6 +3160,15 @@ node_location_segments(const svn_test_opts_t *opts,
                                       subtest->segments, pool));
     }
 
+  /* The changed-paths index must produce the same segments. */
+  SVN_ERR(svn_repos_build_log_index(repos, NULL, NULL, NULL, NULL, pool));
+  for (subtest = subtests; subtest->path; subtest++)
+    {
+      SVN_ERR(check_location_segments(repos, subtest->path, subtest->peg,
+                                      subtest->start, subtest->end,
+                                      subtest->segments, pool));
+    }
+
   return SVN_NO_ERROR;
 }
 
@@ -3564,7 +3659,7 @@ test_get_file_revs(const svn_test_opts_t *opts,
   svn_fs_t *fs;
   svn_revnum_t youngest_rev = 0;
   apr_pool_t *subpool = svn_pool_create(pool);
-  int i;
+  int i, pass;
 
   file_revs_t trunk_results[] = {
     { 2, "/trunk/A/mu", FALSE, "initial" },
@@ -3583,22 +3678,9 @@ test_get_file_revs(const svn_test_opts_t *opts,
     { 6, "/branches/1.0.x/A/mu", FALSE, "user-branch" },
     { 7, "/branches/1.0.x/A/mu", FALSE, "user-merge1" },
   };
-  apr_hash_t *ht_trunk_results = apr_hash_make(subpool);
-  apr_hash_t *ht_branch_results = apr_hash_make(subpool);
-  apr_hash_t *ht_reverse_results = apr_hash_make(subpool);
-
-  for (i = 0; i < sizeof(trunk_results) / sizeof(trunk_results[0]); i++)
-    apr_hash_set(ht_trunk_results, &trunk_results[i].rev,
-                 sizeof(trunk_results[i].rev), &trunk_results[i]);
-
-  for (i = 0; i < sizeof(branch_results) / sizeof(branch_results[0]); i++)
-    apr_hash_set(ht_branch_results, &branch_results[i].rev,
-                 sizeof(branch_results[i].rev), &branch_results[i]);
-
-  for (i = 0; i < sizeof(trunk_results) / sizeof(trunk_results[0]); i++)
-    if (!trunk_results[i].result_of_merge)
-      apr_hash_set(ht_reverse_results, &trunk_results[i].rev,
-                   sizeof(trunk_results[i].rev), &trunk_results[i]);
+  apr_hash_t *ht_trunk_results;
+  apr_hash_t *ht_branch_results;
+  apr_hash_t *ht_reverse_results;
 
   /* Check for feature support */
   if (opts->server_minor_version && (opts->server_minor_version < 5))
@@ -3612,31 +3694,59 @@ test_get_file_revs(const svn_test_opts_t *opts,
 
   SVN_ERR(svn_fs_youngest_rev(&youngest_rev, fs, subpool));
 
-  /* Verify blame of /trunk/A/mu */
-  SVN_ERR(svn_repos_get_file_revs2(repos, "/trunk/A/mu", 0, youngest_rev,
-                                   TRUE, NULL, NULL,
-                                   file_rev_handler,
-                                   ht_trunk_results,
-                                   subpool));
-  SVN_TEST_ASSERT(apr_hash_count(ht_trunk_results) == 0);
-
-  /* Verify blame of /branches/1.0.x/A/mu */
-  SVN_ERR(svn_repos_get_file_revs2(repos, "/branches/1.0.x/A/mu", 0,
-                                   youngest_rev,
-                                   TRUE, NULL, NULL,
-                                   file_rev_handler,
-                                   ht_branch_results,
-                                   subpool));
-  SVN_TEST_ASSERT(apr_hash_count(ht_branch_results) == 0);
+  /* The second pass takes history and mergeinfo from the changed-paths
+     index. */
+  for (pass = 0; pass < 2; pass++)
+    {
+      if (pass == 1)
+        SVN_ERR(svn_repos_build_log_index(repos, NULL, NULL, NULL, NULL,
+                                          subpool));
+
+      ht_trunk_results = apr_hash_make(subpool);
+      ht_branch_results = apr_hash_make(subpool);
+      ht_reverse_results = apr_hash_make(subpool);
+
+      for (i = 0; i < sizeof(trunk_results) / sizeof(trunk_results[0]); i++)
+        apr_hash_set(ht_trunk_results, &trunk_results[i].rev,
+                     sizeof(trunk_results[i].rev), &trunk_results[i]);
+
+      for (i = 0; i < sizeof(branch_results) / sizeof(branch_results[0]);
+           i++)
+        apr_hash_set(ht_branch_results, &branch_results[i].rev,
+                     sizeof(branch_results[i].rev), &branch_results[i]);
+
+      for (i = 0; i < sizeof(trunk_results) / sizeof(trunk_results[0]); i++)
+        if (!trunk_results[i].result_of_merge)
+          apr_hash_set(ht_reverse_results, &trunk_results[i].rev,
+                       sizeof(trunk_results[i].rev), &trunk_results[i]);
+
+      /* Verify blame of /trunk/A/mu */
+      SVN_ERR(svn_repos_get_file_revs2(repos, "/trunk/A/mu", 0,
+                                       youngest_rev,
+                                       TRUE, NULL, NULL,
+                                       file_rev_handler,
+                                       ht_trunk_results,
+                                       subpool));
+      SVN_TEST_ASSERT(apr_hash_count(ht_trunk_results) == 0);
+
+      /* Verify blame of /branches/1.0.x/A/mu */
+      SVN_ERR(svn_repos_get_file_revs2(repos, "/branches/1.0.x/A/mu", 0,
+                                       youngest_rev,
+                                       TRUE, NULL, NULL,
+                                       file_rev_handler,
+                                       ht_branch_results,
+                                       subpool));
+      SVN_TEST_ASSERT(apr_hash_count(ht_branch_results) == 0);
 
-  /* ### TODO: Verify blame of /branches/1.0.x/A/mu in range 6-7 */
+      /* ### TODO: Verify blame of /branches/1.0.x/A/mu in range 6-7 */
 
-  SVN_ERR(svn_repos_get_file_revs2(repos, "/trunk/A/mu", youngest_rev, 0,
-                                   FALSE, NULL, NULL,
-                                   file_rev_handler,
-                                   ht_reverse_results,
-                                   subpool));
-  SVN_TEST_ASSERT(apr_hash_count(ht_reverse_results) == 0);
+      SVN_ERR(svn_repos_get_file_revs2(repos, "/trunk/A/mu", youngest_rev,
+                                       0, FALSE, NULL, NULL,
+                                       file_rev_handler,
+                                       ht_reverse_results,
+                                       subpool));
+      SVN_TEST_ASSERT(apr_hash_count(ht_reverse_results) == 0);
+    }
 
   svn_pool_destroy(subpool);
 
@@ -4458,14 +4568,1171 @@ test_list(const svn_test_opts_t *opts,
   patterns = apr_array_make(pool, 1, sizeof(const char *));
   APR_ARRAY_PUSH(patterns, const char *) = "*a*";
   SVN_ERR(svn_fs_revision_root(&rev_root, fs, youngest_rev, pool));
-  SVN_ERR(svn_repos_list(rev_root, "/A", patterns, svn_depth_infinity, FALSE,
-                         NULL, NULL, list_callback, &counter, NULL, NULL,
-                         pool));
+  SVN_ERR(svn_repos_list2(rev_root, "/A", patterns, svn_depth_infinity,
+                          SVN_INVALID_REVNUM, FALSE, NULL, NULL,
+                          list_callback, &counter, NULL, NULL, pool));
   SVN_TEST_ASSERT(counter == 7);
 
   return SVN_NO_ERROR;
 }
 
+/* Implements svn_repos_dirent_receiver_t, appending PATH to the
+   svn_stringbuf_t in BATON. */
+static svn_error_t *
+list_path_collector(const char *path,
+                    svn_dirent_t *dirent,
+                    void *baton,
+                    apr_pool_t *pool)
+{
+  svn_stringbuf_t *paths = baton;
+
+  svn_stringbuf_appendbyte(paths, ' ');
+  svn_stringbuf_appendcstr(paths, path);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_list_since(const svn_test_opts_t *opts,
+                apr_pool_t *pool)
+{
+  svn_repos_t *repos;
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root, *rev_root;
+  svn_revnum_t youngest_rev;
+  svn_stringbuf_t *paths = svn_stringbuf_create_empty(pool);
+  apr_array_header_t *patterns;
+
+  SVN_ERR(svn_test__create_repos(&repos, "test-repo-list-since", opts,
+                                 pool));
+  fs = svn_repos_fs(repos);
+
+  /* Revision 1:  Add the Greek tree. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_test__create_greek_tree(txn_root, pool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, pool));
+
+  /* Revision 2:  Tweak A/D/G/pi. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "A/D/G/pi", "Revision 2",
+                                      pool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, pool));
+  SVN_ERR(svn_fs_revision_root(&rev_root, fs, youngest_rev, pool));
+
+  /* Everything changed since r1. */
+  SVN_ERR(svn_repos_list2(rev_root, "/A/D/G", NULL, svn_depth_infinity, 1,
+                          TRUE, NULL, NULL, list_path_collector, paths,
+                          NULL, NULL, pool));
+  SVN_TEST_STRING_ASSERT(paths->data,
+                         " /A/D/G /A/D/G/pi /A/D/G/rho /A/D/G/tau");
+
+  /* Only the path to pi changed in r2. */
+  svn_stringbuf_setempty(paths);
+  SVN_ERR(svn_repos_list2(rev_root, "/", NULL, svn_depth_infinity, 2,
+                          FALSE, NULL, NULL, list_path_collector, paths,
+                          NULL, NULL, pool));
+  SVN_TEST_STRING_ASSERT(paths->data, " / /A /A/D /A/D/G /A/D/G/pi");
+
+  /* Combine that with patterns. */
+  patterns = apr_array_make(pool, 1, sizeof(const char *));
+  APR_ARRAY_PUSH(patterns, const char *) = "*i*";
+  svn_stringbuf_setempty(paths);
+  SVN_ERR(svn_repos_list2(rev_root, "/", patterns, svn_depth_infinity, 2,
+                          TRUE, NULL, NULL, list_path_collector, paths,
+                          NULL, NULL, pool));
+  SVN_TEST_STRING_ASSERT(paths->data, " /A/D/G/pi");
+
+  /* Unchanged sub-trees yield nothing at all. */
+  svn_stringbuf_setempty(paths);
+  SVN_ERR(svn_repos_list2(rev_root, "/A/B", NULL, svn_depth_infinity, 2,
+                          TRUE, NULL, NULL, list_path_collector, paths,
+                          NULL, NULL, pool));
+  SVN_TEST_STRING_ASSERT(paths->data, "");
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_repos_notify_func_t.  Append the revision of each
+   svn_repos_notify_verify_rev_end notification to the array in BATON. */
+static void
+verify_notify_collector(void *baton,
+                        const svn_repos_notify_t *notify,
+                        apr_pool_t *scratch_pool)
+{
+  apr_array_header_t *revisions = baton;
+
+  if (notify->action == svn_repos_notify_verify_rev_end)
+    APR_ARRAY_PUSH(revisions, svn_revnum_t) = notify->revision;
+}
+
+static svn_error_t *
+test_verify_parallel(const svn_test_opts_t *opts,
+                     apr_pool_t *pool)
+{
+  svn_repos_t *repos;
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root;
+  svn_revnum_t youngest_rev;
+  apr_array_header_t *revisions;
+  int i;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+
+  SVN_ERR(svn_test__create_repos(&repos, "test-repo-verify-parallel",
+                                 opts, pool));
+  fs = svn_repos_fs(repos);
+
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_test__create_greek_tree(txn_root, pool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, pool));
+
+  for (i = 0; i < 20; ++i)
+    {
+      svn_pool_clear(iterpool);
+
+      SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, iterpool));
+      SVN_ERR(svn_fs_txn_root(&txn_root, txn, iterpool));
+      SVN_ERR(svn_test__set_file_contents(txn_root, "A/mu",
+                                          apr_psprintf(iterpool,
+                                                       "Change %d\n", i),
+                                          iterpool));
+      SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn,
+                                      iterpool));
+    }
+  svn_pool_destroy(iterpool);
+
+  /* Notifications must arrive in revision order, regardless of the number
+     of workers. */
+  revisions = apr_array_make(pool, youngest_rev + 1, sizeof(svn_revnum_t));
+  SVN_ERR(svn_repos_verify_fs4(repos, 0, youngest_rev, FALSE, FALSE, 3,
+                               verify_notify_collector, revisions,
+                               NULL, NULL, NULL, NULL, pool));
+
+  SVN_TEST_INT_ASSERT(revisions->nelts, youngest_rev + 1);
+  for (i = 0; i < revisions->nelts; ++i)
+    SVN_TEST_INT_ASSERT(APR_ARRAY_IDX(revisions, i, svn_revnum_t), i);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_repos_pool(const svn_test_opts_t *opts,
+                apr_pool_t *pool)
+{
+  svn_repos__repos_pool_t *repos_pool;
+  svn_repos_t *repos, *repos1, *repos2;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root;
+  svn_revnum_t rev;
+  const char *path;
+  apr_pool_t *subpool1 = svn_pool_create(pool);
+  apr_pool_t *subpool2 = svn_pool_create(pool);
+
+  SVN_ERR(svn_test__create_repos(&repos, "test-repo-repos-pool", opts,
+                                 pool));
+  SVN_ERR(svn_dirent_get_absolute(&path, "test-repo-repos-pool", pool));
+  SVN_ERR(svn_repos__repos_pool_create(&repos_pool, TRUE, pool));
+
+  /* Concurrent users get separate instances. */
+  SVN_ERR(svn_repos__repos_pool_get(&repos1, repos_pool, path, NULL,
+                                    subpool1, pool));
+  SVN_ERR(svn_repos__repos_pool_get(&repos2, repos_pool, path, NULL,
+                                    subpool2, pool));
+  SVN_TEST_ASSERT(repos1 != repos2);
+
+  /* Released instances get re-used. */
+  svn_pool_clear(subpool1);
+  SVN_ERR(svn_repos__repos_pool_get(&repos, repos_pool, path, NULL,
+                                    subpool1, pool));
+  SVN_TEST_ASSERT(repos == repos1);
+
+  /* Commit through one instance while the other one is idle. */
+  svn_pool_clear(subpool2);
+  SVN_ERR(svn_fs_begin_txn2(&txn, svn_repos_fs(repos1), 0, 0, subpool1));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, subpool1));
+  SVN_ERR(svn_test__create_greek_tree(txn_root, subpool1));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos1, &rev, txn, subpool1));
+  SVN_TEST_INT_ASSERT(rev, 1);
+
+  /* The idle instance must see the new revision. */
+  SVN_ERR(svn_repos__repos_pool_get(&repos, repos_pool, path, NULL,
+                                    subpool2, pool));
+  SVN_TEST_ASSERT(repos == repos2);
+  SVN_ERR(svn_fs_youngest_rev(&rev, svn_repos_fs(repos), pool));
+  SVN_TEST_INT_ASSERT(rev, 1);
+
+  /* Non-existent repositories are an error. */
+  SVN_TEST_ASSERT_ANY_ERROR(svn_repos__repos_pool_get(
+                              &repos, repos_pool,
+                              svn_dirent_join(path, "no-repo", pool),
+                              NULL, subpool1, pool));
+
+  svn_pool_destroy(subpool1);
+  svn_pool_destroy(subpool2);
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_repos_log_entry_receiver_t, collecting the revision
+ * numbers in the apr_array_header_t BATON. */
+static svn_error_t *
+log_rev_collector(void *baton,
+                  svn_repos_log_entry_t *log_entry,
+                  apr_pool_t *scratch_pool)
+{
+  apr_array_header_t *revisions = baton;
+  APR_ARRAY_PUSH(revisions, svn_revnum_t) = log_entry->revision;
+  return SVN_NO_ERROR;
+}
+
+/* Set *REVISIONS to the revisions that svn_repos_get_logs5 reports for
+ * PATH in REPOS between START and END with the given LIMIT.  Allocate the
+ * result in POOL. */
+static svn_error_t *
+collect_log_revs(apr_array_header_t **revisions,
+                 svn_repos_t *repos,
+                 const char *path,
+                 svn_boolean_t strict_node_history,
+                 svn_revnum_t start,
+                 svn_revnum_t end,
+                 int limit,
+                 apr_pool_t *pool)
+{
+  apr_array_header_t *paths = apr_array_make(pool, 1, sizeof(const char *));
+
+  *revisions = apr_array_make(pool, 8, sizeof(svn_revnum_t));
+  APR_ARRAY_PUSH(paths, const char *) = path;
+  SVN_ERR(svn_repos_get_logs5(repos, paths, start, end, limit,
+                              strict_node_history, FALSE, NULL, NULL, NULL,
+                              NULL, NULL, log_rev_collector, *revisions,
+                              pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Verify that the ascending log for PATH in REPOS, with and without a
+ * limit, reports the revisions of the descending log in reverse order.
+ * Use POOL for allocations. */
+static svn_error_t *
+verify_ascending_log(svn_repos_t *repos,
+                     const char *path,
+                     svn_boolean_t strict_node_history,
+                     apr_pool_t *pool)
+{
+  apr_array_header_t *descending, *ascending, *limited;
+  int i;
+
+  SVN_ERR(collect_log_revs(&descending, repos, path, strict_node_history,
+                           SVN_INVALID_REVNUM, 0, 0, pool));
+  SVN_ERR(collect_log_revs(&ascending, repos, path, strict_node_history,
+                           0, SVN_INVALID_REVNUM, 0, pool));
+  SVN_ERR(collect_log_revs(&limited, repos, path, strict_node_history,
+                           0, SVN_INVALID_REVNUM, 1, pool));
+
+  SVN_TEST_INT_ASSERT(ascending->nelts, descending->nelts);
+  for (i = 0; i < descending->nelts; ++i)
+    SVN_TEST_INT_ASSERT(APR_ARRAY_IDX(ascending, i, svn_revnum_t),
+                        APR_ARRAY_IDX(descending, descending->nelts - i - 1,
+                                      svn_revnum_t));
+
+  SVN_TEST_INT_ASSERT(limited->nelts, descending->nelts ? 1 : 0);
+  if (limited->nelts)
+    SVN_TEST_INT_ASSERT(APR_ARRAY_IDX(limited, 0, svn_revnum_t),
+                        APR_ARRAY_IDX(ascending, 0, svn_revnum_t));
+
+  return SVN_NO_ERROR;
+}
+
+/* Return the revisions that svn_repos_get_logs5 reports for PATH in
+ * REPOS, separated by spaces.  Allocate the result in POOL. */
+static svn_error_t *
+get_log_revs(const char **result,
+             svn_repos_t *repos,
+             const char *path,
+             svn_boolean_t strict_node_history,
+             apr_pool_t *pool)
+{
+  apr_array_header_t *revisions;
+  svn_stringbuf_t *buf = svn_stringbuf_create_empty(pool);
+  int i;
+
+  SVN_ERR(collect_log_revs(&revisions, repos, path, strict_node_history,
+                           SVN_INVALID_REVNUM, 0, 0, pool));
+
+  for (i = 0; i < revisions->nelts; ++i)
+    svn_stringbuf_appendcstr(buf,
+                             apr_psprintf(pool, " %ld",
+                                          APR_ARRAY_IDX(revisions, i,
+                                                        svn_revnum_t)));
+
+  *result = buf->data;
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_log_index(const svn_test_opts_t *opts,
+               apr_pool_t *pool)
+{
+  svn_repos_t *repos;
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root, *rev_root;
+  svn_revnum_t youngest_rev = 0;
+  apr_hash_t *expected = apr_hash_make(pool);
+  const char *paths[] = { "/A2/mu", "/A2/B", "/A2", "/A/D/G/pi", "/iota",
+                          NULL };
+  const char **path;
+  apr_pool_t *subpool = svn_pool_create(pool);
+
+  SVN_ERR(svn_test__create_repos(&repos, "test-repo-log-index",
+                                 opts, pool));
+  fs = svn_repos_fs(repos);
+
+  /* Revision 1:  Add the Greek tree. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, subpool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, subpool));
+  SVN_ERR(svn_test__create_greek_tree(txn_root, subpool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, subpool));
+
+  /* Revision 2:  Tweak A/mu. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, subpool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, subpool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "A/mu", "Revision 2",
+                                      subpool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, subpool));
+
+  /* Revision 3:  Copy A to A2. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, subpool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, subpool));
+  SVN_ERR(svn_fs_revision_root(&rev_root, fs, youngest_rev, subpool));
+  SVN_ERR(svn_fs_copy(rev_root, "A", txn_root, "A2", subpool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, subpool));
+
+  /* Revision 4:  Tweak A2/mu and A/D/G/pi. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, subpool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, subpool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "A2/mu", "Revision 4",
+                                      subpool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "A/D/G/pi", "Revision 4",
+                                      subpool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, subpool));
+
+  /* Revision 5:  Replace A2/B with a plain directory. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, subpool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, subpool));
+  SVN_ERR(svn_fs_delete(txn_root, "A2/B", subpool));
+  SVN_ERR(svn_fs_make_dir(txn_root, "A2/B", subpool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, subpool));
+
+  /* Record what the history walk reports. */
+  for (path = paths; *path; ++path)
+    {
+      const char *revs;
+
+      SVN_ERR(get_log_revs(&revs, repos, *path, FALSE, pool));
+      svn_hash_sets(expected, *path, revs);
+      SVN_ERR(get_log_revs(&revs, repos, *path, TRUE, pool));
+      svn_hash_sets(expected, apr_pstrcat(pool, *path, "@strict", SVN_VA_NULL),
+                    revs);
+
+      /* Buffered ascending logs from the history walk. */
+      SVN_ERR(verify_ascending_log(repos, *path, FALSE, pool));
+      SVN_ERR(verify_ascending_log(repos, *path, TRUE, pool));
+    }
+
+  /* The index must produce the same results ... */
+  SVN_ERR(svn_repos_build_log_index(repos, NULL, NULL, NULL, NULL, pool));
+
+  /* ... and pick up new commits.  Revision 6:  Tweak A2/mu again. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, subpool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, subpool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "A2/mu", "Revision 6",
+                                      subpool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, subpool));
+  svn_hash_sets(expected, "/A2/mu",
+                apr_pstrcat(pool, " 6", svn_hash_gets(expected, "/A2/mu"),
+                            SVN_VA_NULL));
+  svn_hash_sets(expected, "/A2/mu@strict",
+                apr_pstrcat(pool, " 6",
+                            svn_hash_gets(expected, "/A2/mu@strict"),
+                            SVN_VA_NULL));
+  svn_hash_sets(expected, "/A2",
+                apr_pstrcat(pool, " 6", svn_hash_gets(expected, "/A2"),
+                            SVN_VA_NULL));
+  svn_hash_sets(expected, "/A2@strict",
+                apr_pstrcat(pool, " 6", svn_hash_gets(expected, "/A2@strict"),
+                            SVN_VA_NULL));
+
+  for (path = paths; *path; ++path)
+    {
+      const char *revs;
+
+      SVN_ERR(get_log_revs(&revs, repos, *path, FALSE, pool));
+      SVN_TEST_STRING_ASSERT(revs, svn_hash_gets(expected, *path));
+      SVN_ERR(get_log_revs(&revs, repos, *path, TRUE, pool));
+      SVN_TEST_STRING_ASSERT(revs,
+                             svn_hash_gets(expected,
+                                           apr_pstrcat(pool, *path, "@strict",
+                                                       SVN_VA_NULL)));
+
+      /* Streamed ascending logs from the index. */
+      SVN_ERR(verify_ascending_log(repos, *path, FALSE, pool));
+      SVN_ERR(verify_ascending_log(repos, *path, TRUE, pool));
+    }
+
+  svn_pool_destroy(subpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_repos_mergeinfo_receiver_t, collecting the results
+ * in the svn_mergeinfo_catalog_t BATON. */
+static svn_error_t *
+mergeinfo_collector(const char *path,
+                    svn_mergeinfo_t mergeinfo,
+                    void *baton,
+                    apr_pool_t *scratch_pool)
+{
+  svn_mergeinfo_catalog_t catalog = baton;
+  apr_pool_t *result_pool = apr_hash_pool_get(catalog);
+
+  svn_hash_sets(catalog, apr_pstrdup(result_pool, path),
+                svn_mergeinfo_dup(mergeinfo, result_pool));
+  return SVN_NO_ERROR;
+}
+
+/* Set *RESULTS to a mapping of query descriptions to the formatted
+ * results of svn_repos_fs_get_mergeinfo2 in REPOS for all revisions,
+ * the given PATHS and all inheritance modes.  Allocate the results in
+ * POOL. */
+static svn_error_t *
+get_all_mergeinfo(apr_hash_t **results,
+                  svn_repos_t *repos,
+                  const char **paths,
+                  apr_pool_t *pool)
+{
+  svn_revnum_t youngest, rev;
+  const char **path;
+
+  *results = apr_hash_make(pool);
+  SVN_ERR(svn_fs_youngest_rev(&youngest, svn_repos_fs(repos), pool));
+
+  for (rev = 0; rev <= youngest; ++rev)
+    for (path = paths; *path; ++path)
+      {
+        svn_fs_root_t *root;
+        svn_node_kind_t kind;
+        svn_mergeinfo_inheritance_t inherit;
+        int include_descendants;
+
+        SVN_ERR(svn_fs_revision_root(&root, svn_repos_fs(repos), rev, pool));
+        SVN_ERR(svn_fs_check_path(&kind, root, *path, pool));
+        if (kind == svn_node_none)
+          continue;
+
+        for (inherit = svn_mergeinfo_explicit;
+             inherit <= svn_mergeinfo_nearest_ancestor;
+             ++inherit)
+          for (include_descendants = 0; include_descendants < 2;
+               ++include_descendants)
+            {
+              apr_array_header_t *query
+                = apr_array_make(pool, 1, sizeof(const char *));
+              svn_mergeinfo_catalog_t catalog = apr_hash_make(pool);
+              svn_string_t *formatted;
+
+              APR_ARRAY_PUSH(query, const char *) = *path;
+              SVN_ERR(svn_repos_fs_get_mergeinfo2(repos, query, rev, inherit,
+                                                  include_descendants,
+                                                  NULL, NULL,
+                                                  mergeinfo_collector,
+                                                  catalog, pool));
+              SVN_ERR(svn_mergeinfo__catalog_to_formatted_string(
+                        &formatted, catalog, "", "  ", pool));
+              svn_hash_sets(*results,
+                            apr_psprintf(pool, "%s@%ld %d %d", *path, rev,
+                                         inherit, include_descendants),
+                            formatted->data);
+            }
+      }
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_log_index_mergeinfo(const svn_test_opts_t *opts,
+                         apr_pool_t *pool)
+{
+  svn_repos_t *repos;
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root, *rev_root;
+  svn_revnum_t youngest_rev = 0;
+  apr_hash_t *expected, *actual;
+  apr_hash_index_t *hi;
+  const char *paths[] = { "/", "/A", "/A/C", "/A/D/G/pi", "/A2", "/A2/B",
+                          "/A2/B/G", "/A2/B/G/rho", "/A2/D/H", NULL };
+  apr_pool_t *subpool = svn_pool_create(pool);
+
+  SVN_ERR(svn_test__create_repos(&repos, "test-repo-log-index-mergeinfo",
+                                 opts, pool));
+  fs = svn_repos_fs(repos);
+
+  /* Revision 1:  Add the Greek tree. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, subpool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, subpool));
+  SVN_ERR(svn_test__create_greek_tree(txn_root, subpool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, subpool));
+
+  /* Revision 2:  Add mergeinfo, some of it non-inheritable or invalid. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, subpool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, subpool));
+  SVN_ERR(svn_fs_change_node_prop(txn_root, "A", SVN_PROP_MERGEINFO,
+                                  svn_string_create("/X:1,3-4\n/Z:2*",
+                                                    subpool),
+                                  subpool));
+  SVN_ERR(svn_fs_change_node_prop(txn_root, "A/D/G", SVN_PROP_MERGEINFO,
+                                  svn_string_create("/Y:1", subpool),
+                                  subpool));
+  SVN_ERR(svn_fs_change_node_prop(txn_root, "A/C", SVN_PROP_MERGEINFO,
+                                  svn_string_create("garbage", subpool),
+                                  subpool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, subpool));
+
+  /* Revision 3:  Copy A to A2. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, subpool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, subpool));
+  SVN_ERR(svn_fs_revision_root(&rev_root, fs, youngest_rev, subpool));
+  SVN_ERR(svn_fs_copy(rev_root, "A", txn_root, "A2", subpool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, subpool));
+
+  /* Revision 4:  Delete A2/D/G, change the mergeinfo on A2. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, subpool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, subpool));
+  SVN_ERR(svn_fs_delete(txn_root, "A2/D/G", subpool));
+  SVN_ERR(svn_fs_change_node_prop(txn_root, "A2", SVN_PROP_MERGEINFO,
+                                  svn_string_create("/X:1-5", subpool),
+                                  subpool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, subpool));
+
+  /* Revision 5:  Replace A2/B with a copy of A/D and remove the mergeinfo
+     from A2. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, subpool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, subpool));
+  SVN_ERR(svn_fs_revision_root(&rev_root, fs, youngest_rev, subpool));
+  SVN_ERR(svn_fs_delete(txn_root, "A2/B", subpool));
+  SVN_ERR(svn_fs_copy(rev_root, "A/D", txn_root, "A2/B", subpool));
+  SVN_ERR(svn_fs_change_node_prop(txn_root, "A2", SVN_PROP_MERGEINFO, NULL,
+                                  subpool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, subpool));
+  svn_pool_clear(subpool);
+
+  /* The index must give the same answers as the FS. */
+  SVN_ERR(get_all_mergeinfo(&expected, repos, paths, pool));
+  SVN_ERR(svn_repos_build_log_index(repos, NULL, NULL, NULL, NULL, pool));
+  SVN_ERR(get_all_mergeinfo(&actual, repos, paths, pool));
+
+  SVN_TEST_INT_ASSERT(apr_hash_count(actual), apr_hash_count(expected));
+  for (hi = apr_hash_first(pool, expected); hi; hi = apr_hash_next(hi))
+    {
+      const char *query = apr_hash_this_key(hi);
+      const char *result = svn_hash_gets(actual, query);
+
+      if (!result || strcmp(result, apr_hash_this_val(hi)))
+        return svn_error_createf(SVN_ERR_TEST_FAILED, NULL,
+                                 "Mergeinfo for '%s' is '%s' instead of '%s'",
+                                 query, result ? result : "(null)",
+                                 (const char *)apr_hash_this_val(hi));
+    }
+
+  svn_pool_destroy(subpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Verify that svn_repos__get_blame() returns the NUM_LINES revisions
+   in EXPECTED for PATH in REVISION of REPOS. */
+static svn_error_t *
+check_blame(svn_repos_t *repos,
+            const char *path,
+            svn_revnum_t revision,
+            const svn_revnum_t *expected,
+            int num_lines,
+            apr_pool_t *pool)
+{
+  apr_array_header_t *revisions;
+  int i;
+
+  SVN_ERR(svn_repos__get_blame(&revisions, repos, path, revision,
+                               NULL, NULL, NULL, NULL, pool, pool));
+
+  SVN_TEST_INT_ASSERT(revisions->nelts, num_lines);
+  for (i = 0; i < num_lines; ++i)
+    if (APR_ARRAY_IDX(revisions, i, svn_revnum_t) != expected[i])
+      return svn_error_createf(SVN_ERR_TEST_FAILED, NULL,
+                               "Line %d of '%s@%ld' blamed on r%ld "
+                               "instead of r%ld", i, path, revision,
+                               APR_ARRAY_IDX(revisions, i, svn_revnum_t),
+                               expected[i]);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_blame(const svn_test_opts_t *opts,
+           apr_pool_t *pool)
+{
+  svn_repos_t *repos;
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root, *rev_root;
+  svn_revnum_t youngest_rev = 0;
+  const svn_revnum_t iota_3[] = { 2, 3, 2, 3 };
+  const svn_revnum_t iota2_6[] = { 6, 2, 3, 2, 3 };
+  const svn_revnum_t iota2_7[] = { 6, 2, 3, 7 };
+  apr_pool_t *subpool = svn_pool_create(pool);
+
+  SVN_ERR(svn_test__create_repos(&repos, "test-repo-blame", opts, pool));
+  fs = svn_repos_fs(repos);
+
+  /* Revision 1:  Add the Greek tree. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, subpool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, subpool));
+  SVN_ERR(svn_test__create_greek_tree(txn_root, subpool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, subpool));
+
+  /* Revisions 2 and 3:  Replace and then edit the contents of iota. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, subpool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, subpool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "iota", "a\nb\nc\n",
+                                      subpool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, subpool));
+
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, subpool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, subpool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "iota", "a\nB\nc\nd\n",
+                                      subpool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, subpool));
+
+  /* Revision 4:  Change a property only. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, subpool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, subpool));
+  SVN_ERR(svn_fs_change_node_prop(txn_root, "iota", "prop",
+                                  svn_string_create("value", subpool),
+                                  subpool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, subpool));
+
+  /* Revisions 5 and 6:  Copy iota to iota2 and edit the copy. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, subpool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, subpool));
+  SVN_ERR(svn_fs_revision_root(&rev_root, fs, youngest_rev, subpool));
+  SVN_ERR(svn_fs_copy(rev_root, "iota", txn_root, "iota2", subpool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, subpool));
+
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, subpool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, subpool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "iota2",
+                                      "x\na\nB\nc\nd\n", subpool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, subpool));
+  svn_pool_clear(subpool);
+
+  /* Without an index. */
+  SVN_ERR(check_blame(repos, "/iota", 3, iota_3, 4, pool));
+  SVN_ERR(check_blame(repos, "/iota2", 6, iota2_6, 5, pool));
+
+  /* Fill the cache, then use it for the copy and for itself. */
+  SVN_ERR(svn_repos_build_log_index(repos, NULL, NULL, NULL, NULL, pool));
+  SVN_ERR(check_blame(repos, "/iota", 4, iota_3, 4, pool));
+  SVN_ERR(check_blame(repos, "/iota2", 6, iota2_6, 5, pool));
+  SVN_ERR(check_blame(repos, "/iota2", 6, iota2_6, 5, pool));
+
+  /* Revision 7:  Continue from a cached annotation. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, subpool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, subpool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "iota2",
+                                      "x\na\nB\nz\n", subpool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, subpool));
+
+  SVN_ERR(check_blame(repos, "/iota2", 7, iota2_7, 4, pool));
+
+  svn_pool_destroy(subpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Baton for the truncating log receivers below. */
+typedef struct truncated_log_baton_t
+{
+  /* Stop receiving changes after this many per revision. */
+  int max_changes;
+
+  /* Changes received for the current revision. */
+  int changes;
+
+  /* Space-separated "REV:CHANGES" list of all revisions reported. */
+  svn_stringbuf_t *result;
+} truncated_log_baton_t;
+
+/* Implements svn_repos_path_change_receiver_t. */
+static svn_error_t *
+truncating_change_receiver(void *baton,
+                           svn_repos_path_change_t *change,
+                           apr_pool_t *scratch_pool)
+{
+  truncated_log_baton_t *b = baton;
+
+  /* We must not be called again after telling the looper to cease. */
+  SVN_TEST_ASSERT(b->changes < b->max_changes);
+  if (++b->changes == b->max_changes)
+    return svn_error_create(SVN_ERR_CEASE_INVOCATION, NULL, NULL);
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_repos_log_entry_receiver_t. */
+static svn_error_t *
+truncating_revision_receiver(void *baton,
+                             svn_repos_log_entry_t *log_entry,
+                             apr_pool_t *scratch_pool)
+{
+  truncated_log_baton_t *b = baton;
+
+  /* The revision must still be fully readable. */
+  if (log_entry->revision > 0)
+    SVN_TEST_ASSERT(svn_hash_gets(log_entry->revprops,
+                                  SVN_PROP_REVISION_LOG));
+
+  svn_stringbuf_appendcstr(b->result,
+                           apr_psprintf(scratch_pool, " %ld:%d",
+                                        log_entry->revision, b->changes));
+  b->changes = 0;
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_repos_authz_func_t, granting access to everything. */
+static svn_error_t *
+allow_all_authz(svn_boolean_t *allowed,
+                svn_fs_root_t *root,
+                const char *path,
+                void *baton,
+                apr_pool_t *pool)
+{
+  *allowed = TRUE;
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_log_truncated_changes(const svn_test_opts_t *opts,
+                           apr_pool_t *pool)
+{
+  svn_repos_t *repos;
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root;
+  svn_revnum_t youngest_rev = 0;
+  apr_array_header_t *paths = apr_array_make(pool, 1, sizeof(const char *));
+  apr_array_header_t *revprops = apr_array_make(pool, 1,
+                                                sizeof(const char *));
+  truncated_log_baton_t baton;
+  int i;
+
+  SVN_ERR(svn_test__create_repos(&repos, "test-repo-log-truncated",
+                                 opts, pool));
+  fs = svn_repos_fs(repos);
+
+  /* r1: The Greek tree, i.e. many changed paths. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_test__create_greek_tree(txn_root, pool));
+  SVN_ERR(svn_fs_change_txn_prop(txn, SVN_PROP_REVISION_LOG,
+                                 svn_string_create("r1", pool), pool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, pool));
+
+  /* r2: Just two changes. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "A/mu", "r2", pool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "iota", "r2", pool));
+  SVN_ERR(svn_fs_change_txn_prop(txn, SVN_PROP_REVISION_LOG,
+                                 svn_string_create("r2", pool), pool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, pool));
+
+  APR_ARRAY_PUSH(paths, const char *) = "";
+  APR_ARRAY_PUSH(revprops, const char *) = SVN_PROP_REVISION_LOG;
+
+  /* Without and with authz, the looper must continue with the next
+     revision after the receiver ceased. */
+  for (i = 0; i < 2; ++i)
+    {
+      baton.max_changes = 3;
+      baton.changes = 0;
+      baton.result = svn_stringbuf_create_empty(pool);
+
+      SVN_ERR(svn_repos_get_logs5(repos, paths, youngest_rev, 0, 0,
+                                  FALSE, FALSE, revprops,
+                                  i ? allow_all_authz : NULL, NULL,
+                                  truncating_change_receiver, &baton,
+                                  truncating_revision_receiver, &baton,
+                                  pool));
+      SVN_TEST_STRING_ASSERT(baton.result->data, " 2:2 1:3 0:0");
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Return the revisions that svn_repos_get_logs5 reports for PATHS in
+ * REPOS between START and END with the given LIMIT, separated by spaces.
+ * Use AUTHZ_READ_FUNC, if not NULL, for authz.  Allocate the result in
+ * POOL. */
+static svn_error_t *
+get_multi_path_log_revs(const char **result,
+                        svn_repos_t *repos,
+                        const apr_array_header_t *paths,
+                        svn_revnum_t start,
+                        svn_revnum_t end,
+                        int limit,
+                        svn_repos_authz_func_t authz_read_func,
+                        apr_pool_t *pool)
+{
+  apr_array_header_t *revisions = apr_array_make(pool, 8,
+                                                 sizeof(svn_revnum_t));
+  svn_stringbuf_t *buf = svn_stringbuf_create_empty(pool);
+  int i;
+
+  SVN_ERR(svn_repos_get_logs5(repos, paths, start, end, limit,
+                              FALSE, FALSE, NULL, authz_read_func, NULL,
+                              NULL, NULL, log_rev_collector, revisions,
+                              pool));
+
+  for (i = 0; i < revisions->nelts; ++i)
+    svn_stringbuf_appendcstr(buf,
+                             apr_psprintf(pool, " %ld",
+                                          APR_ARRAY_IDX(revisions, i,
+                                                        svn_revnum_t)));
+
+  *result = buf->data;
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_log_multiple_paths(const svn_test_opts_t *opts,
+                        apr_pool_t *pool)
+{
+  svn_repos_t *repos;
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root;
+  svn_revnum_t youngest_rev = 0;
+  apr_array_header_t *paths = apr_array_make(pool, 3, sizeof(const char *));
+  const char *revs;
+  int i;
+
+  SVN_ERR(svn_test__create_repos(&repos, "test-repo-log-multiple-paths",
+                                 opts, pool));
+  fs = svn_repos_fs(repos);
+
+  /* r1: The Greek tree. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_test__create_greek_tree(txn_root, pool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, pool));
+
+  /* r2: Change A/mu. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "A/mu", "r2", pool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, pool));
+
+  /* r3: Change A/B/E/alpha and A/B/E/beta together. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "A/B/E/alpha", "r3", pool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "A/B/E/beta", "r3", pool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, pool));
+
+  /* r4: Change an unrelated file. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "iota", "r4", pool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, pool));
+
+  /* r5: Change A/B/E/beta. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "A/B/E/beta", "r5", pool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, pool));
+
+  APR_ARRAY_PUSH(paths, const char *) = "A/mu";
+  APR_ARRAY_PUSH(paths, const char *) = "A/B/E/alpha";
+  APR_ARRAY_PUSH(paths, const char *) = "A/B/E/beta";
+
+  /* Revisions shared by several paths must be reported only once. */
+  for (i = 0; i < 2; ++i)
+    {
+      svn_repos_authz_func_t authz_read_func = i ? allow_all_authz : NULL;
+
+      SVN_ERR(get_multi_path_log_revs(&revs, repos, paths, youngest_rev, 0,
+                                      0, authz_read_func, pool));
+      SVN_TEST_STRING_ASSERT(revs, " 5 3 2 1");
+
+      SVN_ERR(get_multi_path_log_revs(&revs, repos, paths, youngest_rev, 0,
+                                      2, authz_read_func, pool));
+      SVN_TEST_STRING_ASSERT(revs, " 5 3");
+
+      SVN_ERR(get_multi_path_log_revs(&revs, repos, paths, 0, youngest_rev,
+                                      2, authz_read_func, pool));
+      SVN_TEST_STRING_ASSERT(revs, " 1 2");
+
+      SVN_ERR(get_multi_path_log_revs(&revs, repos, paths, 4, 2,
+                                      0, authz_read_func, pool));
+      SVN_TEST_STRING_ASSERT(revs, " 3 2");
+    }
+
+  return SVN_NO_ERROR;
+}
+
+
+/* Verify that MERGEINFO serializes to EXPECTED. */
+static svn_error_t *
+check_mergeinfo_string(svn_mergeinfo_t mergeinfo,
+                       const char *expected,
+                       apr_pool_t *pool)
+{
+  svn_string_t *actual;
+
+  SVN_ERR(svn_mergeinfo_to_string(&actual, mergeinfo, pool));
+  SVN_TEST_STRING_ASSERT(actual->data, expected);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_merge_plan(const svn_test_opts_t *opts,
+                apr_pool_t *pool)
+{
+  svn_repos_t *repos;
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root, *rev_root;
+  svn_revnum_t youngest_rev = 0;
+  svn_mergeinfo_t source_history, target_history;
+  svn_mergeinfo_catalog_t catalog;
+  apr_pool_t *subpool = svn_pool_create(pool);
+
+  SVN_ERR(svn_test__create_repos(&repos, "test-repo-merge-plan", opts,
+                                 pool));
+  fs = svn_repos_fs(repos);
+
+  /* Revision 1:  Add the Greek tree. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, subpool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, subpool));
+  SVN_ERR(svn_test__create_greek_tree(txn_root, subpool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, subpool));
+
+  /* Revision 2:  Branch A to A_copy. */
+  svn_pool_clear(subpool);
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, subpool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, subpool));
+  SVN_ERR(svn_fs_revision_root(&rev_root, fs, youngest_rev, subpool));
+  SVN_ERR(svn_fs_copy(rev_root, "A", txn_root, "A_copy", subpool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, subpool));
+
+  /* Revision 3:  Change A/mu. */
+  svn_pool_clear(subpool);
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, subpool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, subpool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "A/mu", "new mu\n",
+                                      subpool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, subpool));
+
+  /* Revision 4:  Record r3 as merged into A_copy and into A_copy/B. */
+  svn_pool_clear(subpool);
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, subpool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, subpool));
+  SVN_ERR(svn_fs_change_node_prop(txn_root, "A_copy", SVN_PROP_MERGEINFO,
+                                  svn_string_create("/A:3", subpool),
+                                  subpool));
+  SVN_ERR(svn_fs_change_node_prop(txn_root, "A_copy/B", SVN_PROP_MERGEINFO,
+                                  svn_string_create("/A/B:3", subpool),
+                                  subpool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, subpool));
+  svn_pool_clear(subpool);
+
+  /* Full histories and the mergeinfo of the whole target tree. */
+  SVN_ERR(svn_repos__get_merge_plan(&source_history, &target_history,
+                                    &catalog, repos, "/A", youngest_rev,
+                                    SVN_INVALID_REVNUM, SVN_INVALID_REVNUM,
+                                    "/A_copy", youngest_rev, TRUE,
+                                    NULL, NULL, pool, subpool));
+  SVN_ERR(check_mergeinfo_string(source_history, "/A:1-4", pool));
+  SVN_ERR(check_mergeinfo_string(target_history, "/A:1\n/A_copy:2-4",
+                                 pool));
+  SVN_TEST_ASSERT(catalog && apr_hash_count(catalog) == 2);
+  SVN_ERR(check_mergeinfo_string(svn_hash_gets(catalog, "/A_copy"),
+                                 "/A:3", pool));
+  SVN_ERR(check_mergeinfo_string(svn_hash_gets(catalog, "/A_copy/B"),
+                                 "/A/B:3", pool));
+
+  /* A limited source range, no target history, target root only. */
+  SVN_ERR(svn_repos__get_merge_plan(&source_history, NULL, &catalog,
+                                    repos, "/A", youngest_rev, 3, 2,
+                                    "/A_copy/B", youngest_rev, FALSE,
+                                    NULL, NULL, pool, subpool));
+  SVN_ERR(check_mergeinfo_string(source_history, "/A:2-3", pool));
+  SVN_TEST_ASSERT(catalog && apr_hash_count(catalog) == 1);
+  SVN_ERR(check_mergeinfo_string(svn_hash_gets(catalog, "/A_copy/B"),
+                                 "/A/B:3", pool));
+
+  /* No mergeinfo at all. */
+  SVN_ERR(svn_repos__get_merge_plan(&source_history, NULL, &catalog,
+                                    repos, "/A_copy", youngest_rev,
+                                    SVN_INVALID_REVNUM, SVN_INVALID_REVNUM,
+                                    "/A", youngest_rev, TRUE,
+                                    NULL, NULL, pool, subpool));
+  SVN_TEST_ASSERT(catalog == NULL);
+
+  svn_pool_destroy(subpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Verify that CHANGES contains an entry for RELPATH with ACTION, KIND,
+   TEXT_MOD and PROP_MOD. */
+static svn_error_t *
+check_summary_entry(apr_hash_t *changes,
+                    const char *relpath,
+                    char action,
+                    svn_node_kind_t kind,
+                    svn_boolean_t text_mod,
+                    svn_boolean_t prop_mod)
+{
+  svn_log_changed_path2_t *change = svn_hash_gets(changes, relpath);
+
+  if (!change)
+    return svn_error_createf(SVN_ERR_TEST_FAILED, NULL,
+                             "No summary entry for '%s'", relpath);
+
+  SVN_TEST_ASSERT(change->action == action);
+  SVN_TEST_ASSERT(change->node_kind == kind);
+  SVN_TEST_ASSERT((change->text_modified == svn_tristate_true) == text_mod);
+  SVN_TEST_ASSERT((change->props_modified == svn_tristate_true) == prop_mod);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_changes_summary(const svn_test_opts_t *opts,
+                     apr_pool_t *pool)
+{
+  svn_repos_t *repos;
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root, *rev_root;
+  svn_revnum_t youngest_rev = 0;
+  apr_hash_t *changes;
+  apr_pool_t *subpool = svn_pool_create(pool);
+
+  SVN_ERR(svn_test__create_repos(&repos, "test-repo-changes-summary", opts,
+                                 pool));
+  fs = svn_repos_fs(repos);
+
+  /* Revision 1:  Add the Greek tree. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, subpool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, subpool));
+  SVN_ERR(svn_test__create_greek_tree(txn_root, subpool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, subpool));
+
+  /* Revision 2:  Change A/mu and the props of A/B, add A/new and
+     delete A/D/H. */
+  svn_pool_clear(subpool);
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, subpool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, subpool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "A/mu", "new mu\n",
+                                      subpool));
+  SVN_ERR(svn_fs_change_node_prop(txn_root, "A/B", "prop",
+                                  svn_string_create("value", subpool),
+                                  subpool));
+  SVN_ERR(svn_fs_make_file(txn_root, "A/new", subpool));
+  SVN_ERR(svn_fs_delete(txn_root, "A/D/H", subpool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, subpool));
+
+  /* Revision 3:  Revert A/mu and change A/B/lambda. */
+  svn_pool_clear(subpool);
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, subpool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, subpool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "A/mu",
+                                      "This is the file 'mu'.\n",
+                                      subpool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "A/B/lambda",
+                                      "new lambda\n", subpool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, subpool));
+
+  /* Revision 4:  Copy A/C to A/C_copy. */
+  svn_pool_clear(subpool);
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, subpool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, subpool));
+  SVN_ERR(svn_fs_revision_root(&rev_root, fs, youngest_rev, subpool));
+  SVN_ERR(svn_fs_copy(rev_root, "A/C", txn_root, "A/C_copy", subpool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, subpool));
+  svn_pool_clear(subpool);
+
+  /* The net changes, including the whole deleted sub-tree. */
+  SVN_ERR(svn_repos__get_changes_summary(&changes, repos, "/A", 1, 3,
+                                         svn_depth_infinity, NULL, NULL,
+                                         NULL, NULL, pool, subpool));
+  SVN_TEST_ASSERT(apr_hash_count(changes) == 7);
+  SVN_ERR(check_summary_entry(changes, "B", 'M', svn_node_dir,
+                              FALSE, TRUE));
+  SVN_ERR(check_summary_entry(changes, "B/lambda", 'M', svn_node_file,
+                              TRUE, FALSE));
+  SVN_ERR(check_summary_entry(changes, "new", 'A', svn_node_file,
+                              TRUE, FALSE));
+  SVN_ERR(check_summary_entry(changes, "D/H", 'D', svn_node_dir,
+                              FALSE, FALSE));
+  SVN_ERR(check_summary_entry(changes, "D/H/chi", 'D', svn_node_file,
+                              FALSE, FALSE));
+  SVN_ERR(check_summary_entry(changes, "D/H/psi", 'D', svn_node_file,
+                              FALSE, FALSE));
+  SVN_ERR(check_summary_entry(changes, "D/H/omega", 'D', svn_node_file,
+                              FALSE, FALSE));
+
+  /* Limited depth. */
+  SVN_ERR(svn_repos__get_changes_summary(&changes, repos, "/A", 1, 3,
+                                         svn_depth_immediates, NULL, NULL,
+                                         NULL, NULL, pool, subpool));
+  SVN_TEST_ASSERT(apr_hash_count(changes) == 2);
+  SVN_TEST_ASSERT(svn_hash_gets(changes, "B") != NULL);
+  SVN_TEST_ASSERT(svn_hash_gets(changes, "new") != NULL);
+
+  /* A file target. */
+  SVN_ERR(svn_repos__get_changes_summary(&changes, repos, "/A/B/lambda",
+                                         1, 4, svn_depth_infinity,
+                                         NULL, NULL, NULL, NULL,
+                                         pool, subpool));
+  SVN_TEST_ASSERT(apr_hash_count(changes) == 1);
+  SVN_ERR(check_summary_entry(changes, "", 'M', svn_node_file,
+                              TRUE, FALSE));
+
+  /* Copies require a full tree comparison. */
+  SVN_TEST_ASSERT_ERROR(svn_repos__get_changes_summary(&changes, repos,
+                                                       "/A", 1, 4,
+                                                       svn_depth_infinity,
+                                                       NULL, NULL,
+                                                       NULL, NULL,
+                                                       pool, subpool),
+                        SVN_ERR_UNSUPPORTED_FEATURE);
+
+  svn_pool_destroy(subpool);
+
+  return SVN_NO_ERROR;
+}
+
+
 /* The test table.  */
 
 static int max_threads = 4;
@@ -4474,7 +5741,7 @@ static struct svn_test_descriptor_t test_funcs[] =
   {
     SVN_TEST_NULL,
     SVN_TEST_OPTS_PASS(dir_deltas,
-                       "test svn_repos_dir_delta2"),
+                       "test svn_repos_dir_delta3"),
     SVN_TEST_OPTS_PASS(node_tree_delete_under_copy,
                        "test deletions under copies in node_tree code"),
     SVN_TEST_OPTS_PASS(revisions_changed,
@@ -4537,6 +5804,26 @@ static struct svn_test_descriptor_t test_funcs[] =
                    "optional authz wildcard performance test"),
     SVN_TEST_OPTS_PASS(test_list,
                        "test svn_repos_list"),
+    SVN_TEST_OPTS_PASS(test_list_since,
+                       "test svn_repos_list2 with since_rev"),
+    SVN_TEST_OPTS_PASS(test_verify_parallel,
+                       "test svn_repos_verify_fs4 with multiple jobs"),
+    SVN_TEST_OPTS_PASS(test_repos_pool,
+                       "test the repository object pool"),
+    SVN_TEST_OPTS_PASS(test_log_index,
+                       "test the changed-paths index for svn log"),
+    SVN_TEST_OPTS_PASS(test_log_index_mergeinfo,
+                       "test mergeinfo lookups via the changed-paths index"),
+    SVN_TEST_OPTS_PASS(test_blame,
+                       "test svn_repos__get_blame"),
+    SVN_TEST_OPTS_PASS(test_log_truncated_changes,
+                       "test truncating changed paths lists in logs"),
+    SVN_TEST_OPTS_PASS(test_log_multiple_paths,
+                       "test svn_repos_get_logs with several paths"),
+    SVN_TEST_OPTS_PASS(test_merge_plan,
+                       "test svn_repos__get_merge_plan"),
+    SVN_TEST_OPTS_PASS(test_changes_summary,
+                       "test svn_repos__get_changes_summary"),
     SVN_TEST_NULL
   };
 
@@ -25,11 +25,18 @@
 #include <string.h>
 #include <apr_general.h>
 #include <apr_lib.h>
+#include <apr_thread_proc.h>
 #include <apr_time.h>
 
+#if APR_HAS_FORK
+#include <unistd.h>  /* for _exit() */
+#endif
+
 #include "svn_pools.h"
 
+#include "private/svn_atomic.h"
 #include "private/svn_cache.h"
+#include "private/svn_metrics.h"
 #include "svn_private_config.h"
 
 #include "../svn_test.h"
@@ -107,6 +114,7 @@ basic_cache_test(svn_cache__t *cache,
 {
   svn_boolean_t found;
   svn_revnum_t twenty = 20, thirty = 30, *answer;
+  apr_array_header_t *keys, *values;
   apr_pool_t *subpool;
 
   /* We use a subpool for all calls in this test and aggressively
@@ -143,6 +151,18 @@ basic_cache_test(svn_cache__t *cache,
     return svn_error_createf(SVN_ERR_TEST_FAILED, NULL,
                              "expected 30 but found '%ld'", *answer);
 
+  /* Batch lookups report hits and misses per key. */
+  keys = apr_array_make(subpool, 3, sizeof(const void *));
+  APR_ARRAY_PUSH(keys, const void *) = "forty";
+  APR_ARRAY_PUSH(keys, const void *) = NULL;
+  APR_ARRAY_PUSH(keys, const void *) = "thirty";
+  SVN_ERR(svn_cache__get_many(&values, cache, keys, subpool));
+  SVN_TEST_ASSERT(values->nelts == 3);
+  SVN_TEST_ASSERT(APR_ARRAY_IDX(values, 0, void *) == NULL);
+  SVN_TEST_ASSERT(APR_ARRAY_IDX(values, 1, void *) == NULL);
+  answer = APR_ARRAY_IDX(values, 2, svn_revnum_t *);
+  SVN_TEST_ASSERT(answer && *answer == 30);
+
   if (size_is_one)
     {
       SVN_ERR(svn_cache__get((void **) &answer, &found, cache, "twenty", subpool));
@@ -210,7 +230,7 @@ test_membuffer_cache_basic(apr_pool_t *pool)
   svn_membuffer_t *membuffer;
 
   SVN_ERR(svn_cache__membuffer_cache_create(&membuffer, 10*1024, 1, 0,
-                                            TRUE, TRUE, pool));
+                                            TRUE, TRUE, FALSE, pool));
 
   /* Create a cache with just one entry. */
   SVN_ERR(svn_cache__create_membuffer_cache(&cache,
@@ -227,6 +247,161 @@ test_membuffer_cache_basic(apr_pool_t *pool)
   return basic_cache_test(cache, FALSE, pool);
 }
 
+static svn_error_t *
+test_membuffer_cache_shared_memory(apr_pool_t *pool)
+{
+  svn_cache__t *cache;
+  svn_membuffer_t *membuffer;
+  svn_error_t *err;
+
+  err = svn_cache__membuffer_cache_create(&membuffer, 10*1024, 1, 0,
+                                          TRUE, TRUE, TRUE, pool);
+  if (err && err->apr_err == SVN_ERR_UNSUPPORTED_FEATURE)
+    {
+      svn_error_clear(err);
+      return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                              "shared memory not supported");
+    }
+  SVN_ERR(err);
+
+  /* Create a cache with string keys.  These cannot use the prefix pool,
+   * which is disabled for shared memory caches anyway. */
+  SVN_ERR(svn_cache__create_membuffer_cache(&cache,
+                                            membuffer,
+                                            serialize_revnum,
+                                            deserialize_revnum,
+                                            APR_HASH_KEY_STRING,
+                                            "cache:",
+                                            SVN_CACHE__MEMBUFFER_DEFAULT_PRIORITY,
+                                            TRUE,
+                                            FALSE,
+                                            pool, pool));
+  SVN_ERR(basic_cache_test(cache, FALSE, pool));
+
+  /* Fixed-size keys would normally use the prefix pool. */
+  SVN_ERR(svn_cache__create_membuffer_cache(&cache,
+                                            membuffer,
+                                            serialize_revnum,
+                                            deserialize_revnum,
+                                            8,
+                                            "fixed:",
+                                            SVN_CACHE__MEMBUFFER_DEFAULT_PRIORITY,
+                                            TRUE,
+                                            FALSE,
+                                            pool, pool));
+  {
+    svn_revnum_t value = 42;
+    svn_revnum_t *result;
+    svn_boolean_t found;
+    const char key[8] = "shared!";
+
+    SVN_ERR(svn_cache__set(cache, key, &value, pool));
+    SVN_ERR(svn_cache__get((void **)&result, &found, cache, key, pool));
+    SVN_TEST_ASSERT(found);
+    SVN_TEST_ASSERT(*result == value);
+  }
+
+  return SVN_NO_ERROR;
+}
+
+#if APR_HAS_FORK
+/* In a child process forked after MEMBUFFER has been created, attach to
+ * it and check that KEY maps to EXPECTED in CACHE.  Then, map KEY to
+ * EXPECTED + 1.  Use POOL for allocations.
+ */
+static svn_error_t *
+shared_memory_child(svn_membuffer_t *membuffer,
+                    svn_cache__t *cache,
+                    const char *key,
+                    svn_revnum_t expected,
+                    apr_pool_t *pool)
+{
+  svn_revnum_t *result;
+  svn_boolean_t found;
+  svn_revnum_t value = expected + 1;
+
+  SVN_ERR(svn_cache__membuffer_child_init(membuffer, pool));
+
+  SVN_ERR(svn_cache__get((void **)&result, &found, cache, key, pool));
+  SVN_TEST_ASSERT(found);
+  SVN_TEST_ASSERT(*result == expected);
+
+  SVN_ERR(svn_cache__set(cache, key, &value, pool));
+
+  return SVN_NO_ERROR;
+}
+#endif
+
+static svn_error_t *
+test_membuffer_cache_shared_fork(apr_pool_t *pool)
+{
+#if APR_HAS_FORK
+  svn_cache__t *cache;
+  svn_membuffer_t *membuffer;
+  svn_error_t *err;
+  apr_proc_t proc;
+  apr_status_t status;
+  int exitcode;
+  apr_exit_why_e exitwhy;
+  svn_revnum_t value = 42;
+  svn_revnum_t *result;
+  svn_boolean_t found;
+  const char *key = "shared";
+
+  err = svn_cache__membuffer_cache_create(&membuffer, 10*1024, 1, 0,
+                                          TRUE, TRUE, TRUE, pool);
+  if (err && err->apr_err == SVN_ERR_UNSUPPORTED_FEATURE)
+    {
+      svn_error_clear(err);
+      return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                              "shared memory not supported");
+    }
+  SVN_ERR(err);
+
+  SVN_ERR(svn_cache__create_membuffer_cache(&cache,
+                                            membuffer,
+                                            serialize_revnum,
+                                            deserialize_revnum,
+                                            APR_HASH_KEY_STRING,
+                                            "fork:",
+                                            SVN_CACHE__MEMBUFFER_DEFAULT_PRIORITY,
+                                            TRUE,
+                                            FALSE,
+                                            pool, pool));
+  SVN_ERR(svn_cache__set(cache, key, &value, pool));
+
+  status = apr_proc_fork(&proc, pool);
+  if (status == APR_INCHILD)
+    {
+      /* Don't run the parent's pool cleanups, they would remove the
+       * lock files. */
+      err = shared_memory_child(membuffer, cache, key, value, pool);
+      _exit(err ? 1 : 0);
+    }
+  else if (status != APR_INPARENT)
+    {
+      return svn_error_wrap_apr(status, "apr_proc_fork");
+    }
+
+  status = apr_proc_wait(&proc, &exitcode, &exitwhy, APR_WAIT);
+  if (status != APR_CHILD_DONE)
+    return svn_error_wrap_apr(status, "apr_proc_wait");
+
+  SVN_TEST_ASSERT(APR_PROC_CHECK_EXIT(exitwhy));
+  SVN_TEST_INT_ASSERT(exitcode, 0);
+
+  /* The child's update must be visible here. */
+  SVN_ERR(svn_cache__get((void **)&result, &found, cache, key, pool));
+  SVN_TEST_ASSERT(found);
+  SVN_TEST_ASSERT(*result == value + 1);
+
+  return SVN_NO_ERROR;
+#else
+  return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                          "fork() not supported");
+#endif
+}
+
 /* Implements svn_cache__deserialize_func_t */
 static svn_error_t *
 raise_error_deserialize_func(void **out,
@@ -268,7 +443,7 @@ test_membuffer_serializer_error_handling(apr_pool_t *pool)
   void *val;
 
   SVN_ERR(svn_cache__membuffer_cache_create(&membuffer, 10*1024, 1, 0,
-                                            TRUE, TRUE, pool));
+                                            TRUE, TRUE, FALSE, pool));
 
   /* Create a cache with just one entry. */
   SVN_ERR(svn_cache__create_membuffer_cache(&cache,
@@ -300,7 +475,7 @@ test_membuffer_serializer_error_handling(apr_pool_t *pool)
 
   /* Create a new cache. */
   SVN_ERR(svn_cache__membuffer_cache_create(&membuffer, 10*1024, 1, 0,
-                                            TRUE, TRUE, pool));
+                                            TRUE, TRUE, FALSE, pool));
   SVN_ERR(svn_cache__create_membuffer_cache(&cache,
                                             membuffer,
                                             serialize_revnum,
@@ -387,7 +562,7 @@ test_membuffer_cache_clearing(apr_pool_t *pool)
 
   /* Create a simple cache for strings, keyed by strings. */
   SVN_ERR(svn_cache__membuffer_cache_create(&membuffer, 10*1024, 1, 0,
-                                            TRUE, TRUE, pool));
+                                            TRUE, TRUE, FALSE, pool));
   SVN_ERR(svn_cache__create_membuffer_cache(&cache,
                                             membuffer,
                                             serialize_revnum,
@@ -505,7 +680,7 @@ test_membuffer_unaligned_string_keys(apr_pool_t *pool)
   const char *unaligned_prefix = apr_pstrdup(pool, "_cache:") + 1;
 
   SVN_ERR(svn_cache__membuffer_cache_create(&membuffer, 10*1024, 1, 0,
-                                            TRUE, TRUE, pool));
+                                            TRUE, TRUE, FALSE, pool));
 
   /* Create a cache with just one entry. */
   SVN_ERR(svn_cache__create_membuffer_cache(
@@ -555,7 +730,7 @@ test_membuffer_unaligned_fixed_keys(apr_pool_t *pool)
   const char *unaligned_prefix = apr_pstrdup(pool, "_cache:") + 1;
 
   SVN_ERR(svn_cache__membuffer_cache_create(&membuffer, 10*1024, 1, 0,
-                                            TRUE, TRUE, pool));
+                                            TRUE, TRUE, FALSE, pool));
 
   /* Create a cache with just one entry. */
   SVN_ERR(svn_cache__create_membuffer_cache(
@@ -589,6 +764,580 @@ test_membuffer_unaligned_fixed_keys(apr_pool_t *pool)
 
   return SVN_NO_ERROR;
 }
+static svn_error_t *
+test_membuffer_scan_resistance(apr_pool_t *pool)
+{
+  svn_cache__t *hot_cache;
+  svn_cache__t *scan_cache;
+  svn_membuffer_t *membuffer;
+  svn_stringbuf_t *value;
+  svn_stringbuf_t *scan_value;
+  svn_boolean_t found;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  int i;
+
+  SVN_ERR(svn_cache__membuffer_cache_create(&membuffer, 256*1024, 64*1024,
+                                            1, FALSE, FALSE, FALSE, pool));
+
+  /* Frequently used data of default priority ... */
+  SVN_ERR(svn_cache__create_membuffer_cache(&hot_cache, membuffer,
+                                            NULL, NULL,
+                                            APR_HASH_KEY_STRING, "hot:",
+                                            SVN_CACHE__MEMBUFFER_DEFAULT_PRIORITY,
+                                            FALSE, FALSE, pool, pool));
+  SVN_ERR(svn_cache__set(hot_cache, "data",
+                         svn_stringbuf_create("hot", pool), pool));
+  for (i = 0; i < 10; ++i)
+    {
+      SVN_ERR(svn_cache__get((void **)&value, &found, hot_cache, "data",
+                             pool));
+      SVN_TEST_ASSERT(found);
+    }
+
+  /* ... must survive a scan through more than twice the cache size,
+   * even though the scan data has a higher priority. */
+  SVN_ERR(svn_cache__create_membuffer_cache(&scan_cache, membuffer,
+                                            NULL, NULL,
+                                            APR_HASH_KEY_STRING, "scan:",
+                                            SVN_CACHE__MEMBUFFER_HIGH_PRIORITY,
+                                            FALSE, FALSE, pool, pool));
+  scan_value = svn_stringbuf_create_ensure(1000, pool);
+  svn_stringbuf_appendfill(scan_value, 'x', 1000);
+  for (i = 0; i < 500; ++i)
+    {
+      const char *key;
+
+      svn_pool_clear(iterpool);
+      key = apr_psprintf(iterpool, "%d", i);
+
+      SVN_ERR(svn_cache__get((void **)&value, &found, scan_cache, key,
+                             iterpool));
+      SVN_ERR(svn_cache__set(scan_cache, key, scan_value, iterpool));
+    }
+
+  SVN_ERR(svn_cache__get((void **)&value, &found, hot_cache, "data", pool));
+  SVN_TEST_ASSERT(found);
+  SVN_TEST_STRING_ASSERT(value->data, "hot");
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_membuffer_overflow(apr_pool_t *pool)
+{
+  svn_cache__t *cache;
+  svn_membuffer_t *membuffer;
+  svn_stringbuf_t *value;
+  svn_stringbuf_t *old_value;
+  svn_stringbuf_t *new_value;
+  svn_boolean_t found;
+  const char *dir;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  int i;
+
+  SVN_ERR(svn_test_make_sandbox_dir(&dir, "cache-overflow", pool));
+  SVN_ERR(svn_cache__membuffer_cache_create(&membuffer, 256*1024, 64*1024,
+                                            1, FALSE, FALSE, FALSE, pool));
+  SVN_ERR(svn_cache__membuffer_attach_overflow(membuffer, dir, 1024*1024,
+                                               FALSE, pool));
+  SVN_ERR(svn_cache__create_membuffer_cache(&cache, membuffer,
+                                            NULL, NULL,
+                                            APR_HASH_KEY_STRING, "test:",
+                                            SVN_CACHE__MEMBUFFER_DEFAULT_PRIORITY,
+                                            FALSE, FALSE, pool, pool));
+
+  old_value = svn_stringbuf_create_ensure(1000, pool);
+  svn_stringbuf_appendfill(old_value, 'x', 1000);
+  new_value = svn_stringbuf_create_ensure(1000, pool);
+  svn_stringbuf_appendfill(new_value, 'y', 1000);
+
+  /* Write about twice as much data as the membuffer can hold. */
+  for (i = 0; i < 500; ++i)
+    {
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_cache__set(cache, apr_psprintf(iterpool, "%d", i),
+                             old_value, iterpool));
+    }
+
+  /* The first items have been evicted but still come back from disk. */
+  SVN_ERR(svn_cache__get((void **)&value, &found, cache, "0", pool));
+  SVN_TEST_ASSERT(found);
+  SVN_TEST_STRING_ASSERT(value->data, old_value->data);
+
+  /* Modified items must not return older versions from disk. */
+  SVN_ERR(svn_cache__set(cache, "1", new_value, pool));
+  for (i = 500; i < 1000; ++i)
+    {
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_cache__set(cache, apr_psprintf(iterpool, "%d", i),
+                             old_value, iterpool));
+    }
+
+  SVN_ERR(svn_cache__get((void **)&value, &found, cache, "1", pool));
+  SVN_TEST_ASSERT(found);
+  SVN_TEST_STRING_ASSERT(value->data, new_value->data);
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Store the numbers 0 .. N-1 in CACHE under the N KEYS using
+ * svn_cache__set_many and read them back with svn_cache__get_many.
+ */
+static svn_error_t *
+batch_access_test(svn_cache__t *cache,
+                  const apr_array_header_t *keys,
+                  apr_pool_t *pool)
+{
+  apr_array_header_t *values = apr_array_make(pool, keys->nelts,
+                                              sizeof(void *));
+  apr_array_header_t *lookup_keys = apr_array_copy(pool, keys);
+  apr_array_header_t *found;
+  svn_revnum_t *revs = apr_palloc(pool, keys->nelts * sizeof(*revs));
+  int i;
+
+  for (i = 0; i < keys->nelts; ++i)
+    {
+      revs[i] = i;
+      APR_ARRAY_PUSH(values, void *) = &revs[i];
+    }
+
+  SVN_ERR(svn_cache__set_many(cache, keys, values, pool));
+
+  /* Replace the first key with NULL and ask for it later again. */
+  APR_ARRAY_PUSH(lookup_keys, const void *) = NULL;
+  APR_ARRAY_PUSH(lookup_keys, const void *)
+    = APR_ARRAY_IDX(keys, 0, const void *);
+  APR_ARRAY_IDX(lookup_keys, 0, const void *) = NULL;
+
+  SVN_ERR(svn_cache__get_many(&found, cache, lookup_keys, pool));
+  SVN_TEST_ASSERT(found->nelts == keys->nelts + 2);
+  SVN_TEST_ASSERT(APR_ARRAY_IDX(found, 0, void *) == NULL);
+  SVN_TEST_ASSERT(APR_ARRAY_IDX(found, keys->nelts, void *) == NULL);
+  SVN_TEST_ASSERT(*APR_ARRAY_IDX(found, keys->nelts + 1, svn_revnum_t *)
+                  == 0);
+
+  for (i = 1; i < keys->nelts; ++i)
+    {
+      svn_revnum_t *answer = APR_ARRAY_IDX(found, i, svn_revnum_t *);
+      SVN_TEST_ASSERT(answer && *answer == i);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_membuffer_batch_access(apr_pool_t *pool)
+{
+  svn_cache__t *cache;
+  svn_membuffer_t *membuffer;
+  apr_array_header_t *string_keys = apr_array_make(pool, 100,
+                                                   sizeof(const void *));
+  apr_array_header_t *revnum_keys = apr_array_make(pool, 100,
+                                                   sizeof(const void *));
+  int i;
+
+  for (i = 0; i < 100; ++i)
+    {
+      svn_revnum_t *rev = apr_palloc(pool, sizeof(*rev));
+      *rev = i;
+
+      APR_ARRAY_PUSH(string_keys, const void *)
+        = apr_psprintf(pool, "key-%d", i);
+      APR_ARRAY_PUSH(revnum_keys, const void *) = rev;
+    }
+
+  /* Use several segments to exercise the per-segment batching. */
+  SVN_ERR(svn_cache__membuffer_cache_create(&membuffer, 1024*1024, 64*1024, 4,
+                                            TRUE, TRUE, FALSE, pool));
+
+  SVN_ERR(svn_cache__create_membuffer_cache(&cache,
+                                            membuffer,
+                                            serialize_revnum,
+                                            deserialize_revnum,
+                                            APR_HASH_KEY_STRING,
+                                            "string:",
+                                            SVN_CACHE__MEMBUFFER_DEFAULT_PRIORITY,
+                                            TRUE,
+                                            FALSE,
+                                            pool, pool));
+  SVN_ERR(batch_access_test(cache, string_keys, pool));
+
+  SVN_ERR(svn_cache__create_membuffer_cache(&cache,
+                                            membuffer,
+                                            serialize_revnum,
+                                            deserialize_revnum,
+                                            sizeof(svn_revnum_t),
+                                            "revnum:",
+                                            SVN_CACHE__MEMBUFFER_DEFAULT_PRIORITY,
+                                            FALSE,
+                                            FALSE,
+                                            pool, pool));
+  SVN_ERR(batch_access_test(cache, revnum_keys, pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Check pinned access to CACHE, which must have been created with the
+ * revnum (de-)serializers.  If EXPECT_PIN is set, CACHE must return pins
+ * for cached entries.  Use POOL for allocations. */
+static svn_error_t *
+pinned_access_test(svn_cache__t *cache,
+                   svn_boolean_t expect_pin,
+                   apr_pool_t *pool)
+{
+  apr_pool_t *subpool = svn_pool_create(pool);
+  svn_revnum_t twenty = 20, thirty = 30;
+  svn_revnum_t *answer;
+  svn_cache__pinned_t *pin;
+  const void *data;
+  apr_size_t data_len;
+  svn_boolean_t found;
+
+  SVN_ERR(svn_cache__get_pinned(&data, &data_len, &found, &pin, cache,
+                                "twenty", pool));
+  SVN_TEST_ASSERT(!found && data == NULL && pin == NULL);
+
+  SVN_ERR(svn_cache__set(cache, "twenty", &twenty, pool));
+  SVN_ERR(svn_cache__get_pinned(&data, &data_len, &found, &pin, cache,
+                                "twenty", pool));
+  SVN_TEST_ASSERT(found);
+  SVN_TEST_ASSERT(expect_pin == (pin != NULL));
+  SVN_TEST_ASSERT(data_len == sizeof(twenty));
+  SVN_TEST_ASSERT(*(const svn_revnum_t *)data == 20);
+  SVN_ERR(svn_cache__unpin(pin));
+
+  /* A pin that does not get released explicitly will be released with
+   * its pool.  Otherwise, the write below would block. */
+  SVN_ERR(svn_cache__get_pinned(&data, &data_len, &found, &pin, cache,
+                                "twenty", subpool));
+  SVN_TEST_ASSERT(found);
+  svn_pool_destroy(subpool);
+
+  SVN_ERR(svn_cache__set(cache, "twenty", &thirty, pool));
+  SVN_ERR(svn_cache__get((void **)&answer, &found, cache, "twenty", pool));
+  SVN_TEST_ASSERT(found && *answer == 30);
+
+  /* Releasing "no pin" is a no-op. */
+  SVN_ERR(svn_cache__unpin(NULL));
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_membuffer_pinned_access(apr_pool_t *pool)
+{
+  svn_cache__t *cache;
+  svn_membuffer_t *membuffer;
+
+  SVN_ERR(svn_cache__membuffer_cache_create(&membuffer, 10*1024, 1, 0,
+                                            TRUE, TRUE, FALSE, pool));
+
+  SVN_ERR(svn_cache__create_membuffer_cache(&cache,
+                                            membuffer,
+                                            serialize_revnum,
+                                            deserialize_revnum,
+                                            APR_HASH_KEY_STRING,
+                                            "cache:",
+                                            SVN_CACHE__MEMBUFFER_DEFAULT_PRIORITY,
+                                            TRUE,
+                                            FALSE,
+                                            pool, pool));
+  SVN_ERR(pinned_access_test(cache, TRUE, pool));
+
+  /* Caches that don't support pinning return copies. */
+  SVN_ERR(svn_cache__create_inprocess(&cache,
+                                      serialize_revnum,
+                                      deserialize_revnum,
+                                      APR_HASH_KEY_STRING,
+                                      1, 1, TRUE, "", pool));
+  SVN_ERR(pinned_access_test(cache, FALSE, pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_cache__prefix_filter_t.  Reject the "skip:" prefix. */
+static svn_error_t *
+snapshot_filter(svn_boolean_t *keep,
+                void *baton,
+                const char *prefix,
+                apr_pool_t *scratch_pool)
+{
+  *keep = strcmp(prefix, "skip:") != 0;
+  return SVN_NO_ERROR;
+}
+
+/* Create caches for string and revnum keys as well as a cache to be
+ * filtered out in MEMBUFFER and return them in *STRINGS, *REVNUMS and
+ * *SKIPPED, respectively. */
+static svn_error_t *
+create_snapshot_caches(svn_cache__t **strings,
+                       svn_cache__t **revnums,
+                       svn_cache__t **skipped,
+                       svn_membuffer_t *membuffer,
+                       apr_pool_t *pool)
+{
+  SVN_ERR(svn_cache__create_membuffer_cache(strings, membuffer,
+                                            serialize_revnum,
+                                            deserialize_revnum,
+                                            APR_HASH_KEY_STRING,
+                                            "string:",
+                                            SVN_CACHE__MEMBUFFER_DEFAULT_PRIORITY,
+                                            TRUE, FALSE, pool, pool));
+  SVN_ERR(svn_cache__create_membuffer_cache(revnums, membuffer,
+                                            serialize_revnum,
+                                            deserialize_revnum,
+                                            sizeof(svn_revnum_t),
+                                            "revnum:",
+                                            SVN_CACHE__MEMBUFFER_DEFAULT_PRIORITY,
+                                            FALSE, FALSE, pool, pool));
+  SVN_ERR(svn_cache__create_membuffer_cache(skipped, membuffer,
+                                            serialize_revnum,
+                                            deserialize_revnum,
+                                            sizeof(svn_revnum_t),
+                                            "skip:",
+                                            SVN_CACHE__MEMBUFFER_DEFAULT_PRIORITY,
+                                            FALSE, FALSE, pool, pool));
+
+  return SVN_NO_ERROR;
+}
+
+#if APR_HAS_THREADS
+/* Baton for lock_free_get_thread. */
+typedef struct lock_free_get_baton_t
+{
+  /* Cache to read "thirty" from. */
+  svn_cache__t *cache;
+
+  /* Private pool of the thread. */
+  apr_pool_t *pool;
+
+  /* Value read and error returned by svn_cache__get. */
+  svn_revnum_t value;
+  svn_boolean_t found;
+  svn_error_t *err;
+
+  /* Set once the thread is done. */
+  volatile svn_atomic_t done;
+} lock_free_get_baton_t;
+
+static void *
+APR_THREAD_FUNC lock_free_get_thread(apr_thread_t *tid, void *data)
+{
+  lock_free_get_baton_t *baton = data;
+  svn_revnum_t *answer;
+
+  baton->err = svn_cache__get((void **)&answer, &baton->found, baton->cache,
+                              "thirty", baton->pool);
+  if (!baton->err && baton->found)
+    baton->value = *answer;
+
+  svn_atomic_set(&baton->done, TRUE);
+  apr_thread_exit(tid, APR_SUCCESS);
+
+  return NULL;
+}
+#endif
+
+static svn_error_t *
+test_membuffer_lock_free_hits(apr_pool_t *pool)
+{
+#if APR_HAS_THREADS
+  svn_cache__t *cache;
+  svn_membuffer_t *membuffer;
+  svn_cache__info_t info = { 0 };
+  svn_cache__pinned_t *pin;
+  lock_free_get_baton_t baton = { 0 };
+  apr_thread_t *thread;
+  apr_status_t status, retval;
+  apr_time_t deadline;
+  svn_revnum_t twenty = 20, thirty = 30;
+  svn_revnum_t *answer;
+  const void *data;
+  apr_size_t data_len;
+  svn_boolean_t found, served_while_locked;
+  svn_error_t *err;
+
+  /* Shared memory segments use an exclusive lock for readers as well.
+   * So, only a lock-free reader can get past a pinned entry. */
+  err = svn_cache__membuffer_cache_create(&membuffer, 10*1024, 1, 1,
+                                          TRUE, TRUE, TRUE, pool);
+  if (err && err->apr_err == SVN_ERR_UNSUPPORTED_FEATURE)
+    {
+      svn_error_clear(err);
+      return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                              "shared memory not supported");
+    }
+  SVN_ERR(err);
+
+  SVN_ERR(svn_cache__create_membuffer_cache(&cache,
+                                            membuffer,
+                                            serialize_revnum,
+                                            deserialize_revnum,
+                                            APR_HASH_KEY_STRING,
+                                            "cache:",
+                                            SVN_CACHE__MEMBUFFER_DEFAULT_PRIORITY,
+                                            TRUE,
+                                            FALSE,
+                                            pool, pool));
+  SVN_ERR(svn_cache__set(cache, "twenty", &twenty, pool));
+  SVN_ERR(svn_cache__set(cache, "thirty", &thirty, pool));
+
+  /* Hits on an unlocked segment must not need the lock either. */
+  SVN_ERR(svn_cache__get((void **)&answer, &found, cache, "thirty", pool));
+  SVN_TEST_ASSERT(found && *answer == 30);
+  SVN_ERR(svn_cache__get_info(cache, &info, FALSE, pool));
+  if (info.lock_free_hits == 0)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "lock-free reads not supported");
+
+  /* Keep the segment locked while another thread reads from it. */
+  SVN_ERR(svn_cache__get_pinned(&data, &data_len, &found, &pin, cache,
+                                "twenty", pool));
+  SVN_TEST_ASSERT(found && pin != NULL);
+
+  baton.cache = cache;
+  baton.pool = svn_pool_create(pool);
+  status = apr_thread_create(&thread, NULL, lock_free_get_thread, &baton,
+                             pool);
+  if (status)
+    return svn_error_compose_create(svn_error_wrap_apr(status, NULL),
+                                    svn_cache__unpin(pin));
+
+  deadline = apr_time_now() + apr_time_from_sec(10);
+  while (!svn_atomic_read(&baton.done) && apr_time_now() < deadline)
+    apr_sleep(1000);
+  served_while_locked = svn_atomic_read(&baton.done);
+
+  /* Let a blocked reader finish before we check anything. */
+  SVN_ERR(svn_cache__unpin(pin));
+  status = apr_thread_join(&retval, thread);
+  if (status)
+    return svn_error_wrap_apr(status, NULL);
+
+  SVN_ERR(baton.err);
+  SVN_TEST_ASSERT(baton.found && baton.value == 30);
+  SVN_TEST_ASSERT(served_while_locked);
+#endif
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_membuffer_snapshot(apr_pool_t *pool)
+{
+  svn_membuffer_t *membuffer;
+  svn_cache__t *strings, *revnums, *skipped;
+  svn_stringbuf_t *snapshot = svn_stringbuf_create_empty(pool);
+  svn_stream_t *stream = svn_stream_from_stringbuf(snapshot, pool);
+  svn_revnum_t i;
+  svn_error_t *err;
+
+  SVN_ERR(svn_cache__membuffer_cache_create(&membuffer, 1024*1024, 64*1024, 4,
+                                            TRUE, TRUE, FALSE, pool));
+  SVN_ERR(create_snapshot_caches(&strings, &revnums, &skipped, membuffer,
+                                 pool));
+
+  for (i = 0; i < 100; ++i)
+    {
+      svn_revnum_t value = 1000 + i;
+      SVN_ERR(svn_cache__set(strings, apr_psprintf(pool, "key-%ld", i),
+                             &value, pool));
+      SVN_ERR(svn_cache__set(revnums, &i, &value, pool));
+      SVN_ERR(svn_cache__set(skipped, &i, &value, pool));
+    }
+
+  err = svn_cache__membuffer_save(membuffer, stream, snapshot_filter, NULL,
+                                  pool);
+  if (err && err->apr_err == SVN_ERR_UNSUPPORTED_FEATURE)
+    {
+      svn_error_clear(err);
+      return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                              "cache snapshots not supported");
+    }
+  SVN_ERR(err);
+
+  /* Restore into a different cache layout. */
+  SVN_ERR(svn_cache__membuffer_cache_create(&membuffer, 1024*1024, 16*1024, 2,
+                                            TRUE, TRUE, FALSE, pool));
+  SVN_ERR(svn_cache__membuffer_load(membuffer, stream, NULL, NULL, pool));
+  SVN_ERR(create_snapshot_caches(&strings, &revnums, &skipped, membuffer,
+                                 pool));
+
+  for (i = 0; i < 100; ++i)
+    {
+      svn_revnum_t *value;
+      svn_boolean_t found;
+
+      SVN_ERR(svn_cache__get((void **)&value, &found, strings,
+                             apr_psprintf(pool, "key-%ld", i), pool));
+      SVN_TEST_ASSERT(found && *value == 1000 + i);
+
+      SVN_ERR(svn_cache__get((void **)&value, &found, revnums, &i, pool));
+      SVN_TEST_ASSERT(found && *value == 1000 + i);
+
+      SVN_ERR(svn_cache__get((void **)&value, &found, skipped, &i, pool));
+      SVN_TEST_ASSERT(!found);
+    }
+
+  /* Garbage must be detected. */
+  stream = svn_stream_from_string(svn_string_create("garbage", pool), pool);
+  SVN_TEST_ASSERT_ERROR(svn_cache__membuffer_load(membuffer, stream, NULL,
+                                                  NULL, pool),
+                        SVN_ERR_MALFORMED_FILE);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_metrics_format(apr_pool_t *pool)
+{
+  svn_metrics__t *counter;
+  svn_metrics__t *histogram;
+  svn_stringbuf_t *text;
+  const char *label = svn_metrics__label("name", "a\"b", pool);
+
+  SVN_TEST_STRING_ASSERT(label, "name=\"a\\\"b\"");
+
+  counter = svn_metrics__counter("svn_test_items_total", label,
+                                 "Test counter");
+  SVN_TEST_ASSERT(counter);
+  SVN_TEST_ASSERT(counter == svn_metrics__counter("svn_test_items_total",
+                                                  label, "Test counter"));
+  svn_metrics__add(counter, 3);
+  svn_metrics__add(counter, 4);
+
+  histogram = svn_metrics__histogram("svn_test_duration_seconds", NULL,
+                                     "Test histogram");
+  SVN_TEST_ASSERT(histogram);
+  svn_metrics__observe(histogram, 2000);
+  svn_metrics__observe(histogram, 20000000);
+
+  /* NULL metrics are silently ignored. */
+  svn_metrics__add(NULL, 1);
+  svn_metrics__observe(NULL, 1);
+
+  SVN_ERR(svn_metrics__format(&text, pool, pool));
+
+  SVN_TEST_ASSERT(strstr(text->data,
+                         "# TYPE svn_test_items_total counter\n"
+                         "svn_test_items_total{name=\"a\\\"b\"} 7\n"));
+  SVN_TEST_ASSERT(strstr(text->data,
+                         "# TYPE svn_test_duration_seconds histogram\n"));
+  SVN_TEST_ASSERT(strstr(text->data,
+                         "svn_test_duration_seconds_bucket{le=\"0.001\"} 0\n"
+                         "svn_test_duration_seconds_bucket{le=\"0.005\"} 1"));
+  SVN_TEST_ASSERT(strstr(text->data,
+                         "svn_test_duration_seconds_bucket{le=\"10\"} 1\n"
+                         "svn_test_duration_seconds_bucket{le=\"+Inf\"} 2\n"
+                         "svn_test_duration_seconds_sum 20.002000\n"
+                         "svn_test_duration_seconds_count 2\n"));
+
+  return SVN_NO_ERROR;
+}
 
 
 /* The test table.  */
@@ -616,6 +1365,25 @@ static struct svn_test_descriptor_t test_funcs[] =
                    "test membuffer cache with unaligned string keys"),
     SVN_TEST_PASS2(test_membuffer_unaligned_fixed_keys,
                    "test membuffer cache with unaligned fixed keys"),
+    SVN_TEST_PASS2(test_membuffer_cache_shared_memory,
+                   "test membuffer cache in shared memory"),
+    SVN_TEST_PASS2(test_membuffer_cache_shared_fork,
+                   "test shared memory cache in a forked child"),
+    SVN_TEST_PASS2(test_metrics_format,
+                   "server statistics in Prometheus format"),
+    SVN_TEST_PASS2(test_membuffer_scan_resistance,
+                   "scans don't evict frequently used membuffer data"),
+    SVN_TEST_PASS2(test_membuffer_overflow,
+                   "membuffer cache overflowing to disk"),
+    SVN_TEST_PASS2(test_membuffer_batch_access,
+                   "batch reads and writes of a membuffer svn_cache"),
+    SVN_TEST_PASS2(test_membuffer_snapshot,
+                   "save and restore membuffer cache contents"),
+    SVN_TEST_PASS2(test_membuffer_pinned_access,
+                   "pinned access to membuffer cache entries"),
+    SVN_TEST_SKIP2(test_membuffer_lock_free_hits,
+                   ! APR_HAS_THREADS,
+                   "lock-free hits don't wait for locked segments"),
     SVN_TEST_NULL
   };
 
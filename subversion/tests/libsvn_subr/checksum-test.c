@@ -27,8 +27,13 @@
 
 #include "svn_error.h"
 #include "svn_io.h"
+#include "svn_sorts.h"
+#include "private/svn_adler32.h"
+#include "private/svn_io_private.h"
+#include "private/svn_subr_private.h"
 
 #include "../svn_test.h"
+#include "../../libsvn_subr/sha.h"
 
 /* Verify that DIGEST of checksum type KIND can be parsed and
  * converted back to a string matching DIGEST.  NAME will be used
@@ -364,6 +369,349 @@ test_checksummed_stream_reset(apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+/* Return the hex representation of the LEN bytes in DIGEST, allocated
+ * in POOL. */
+static const char *
+digest_to_hex(const unsigned char *digest,
+              apr_size_t len,
+              apr_pool_t *pool)
+{
+  svn_stringbuf_t *result = svn_stringbuf_create_empty(pool);
+  apr_size_t i;
+
+  for (i = 0; i < len; ++i)
+    svn_stringbuf_appendcstr(result, apr_psprintf(pool, "%02x", digest[i]));
+
+  return result->data;
+}
+
+static svn_error_t *
+test_sha_vectors(apr_pool_t *pool)
+{
+  /* Standard test vectors; the last one gets repeated REPEAT times. */
+  static const struct
+    {
+      const char *data;
+      int repeat;
+      const char *sha1;
+      const char *sha256;
+    } vectors[] =
+    {
+      { "", 1,
+        "da39a3ee5e6b4b0d3255bfef95601890afd80709",
+        "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855" },
+      { "abc", 1,
+        "a9993e364706816aba3e25717850c26c9cd0d89d",
+        "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad" },
+      { "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq", 1,
+        "84983e441c3bd26ebaae4aa1f95129e5e54670f1",
+        "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1" },
+      { "a", 1000000,
+        "34aa973cd4c4daa4f61eeb2bdbad27316534016f",
+        "cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0" }
+    };
+  int i, k;
+
+  for (i = 0; i < (int)(sizeof(vectors) / sizeof(vectors[0])); ++i)
+    {
+      svn_sha1__context_t *sha1 = svn_sha1__context_create(pool);
+      svn_sha256__context_t *sha256 = svn_sha256__context_create(pool);
+      unsigned char digest[SVN_SHA256__DIGESTSIZE];
+      apr_size_t len = strlen(vectors[i].data);
+
+      for (k = 0; k < vectors[i].repeat; ++k)
+        {
+          svn_sha1__update(sha1, vectors[i].data, len);
+          svn_sha256__update(sha256, vectors[i].data, len);
+        }
+
+      svn_sha1__finalize(digest, sha1);
+      SVN_TEST_STRING_ASSERT(digest_to_hex(digest, SVN_SHA1__DIGESTSIZE,
+                                           pool),
+                             vectors[i].sha1);
+
+      svn_sha256__finalize(digest, sha256);
+      SVN_TEST_STRING_ASSERT(digest_to_hex(digest, SVN_SHA256__DIGESTSIZE,
+                                           pool),
+                             vectors[i].sha256);
+
+      /* Finalization does not modify the context. */
+      svn_sha1__update(sha1, "", 0);
+      svn_sha1__finalize(digest, sha1);
+      SVN_TEST_STRING_ASSERT(digest_to_hex(digest, SVN_SHA1__DIGESTSIZE,
+                                           pool),
+                             vectors[i].sha1);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Fill the LEN bytes at DATA with pseudo-random data. */
+static void
+fill_buffer(unsigned char *data,
+            apr_size_t len)
+{
+  apr_uint32_t seed = 12345;
+  apr_size_t i;
+
+  for (i = 0; i < len; ++i)
+    {
+      seed = seed * 1103515245 + 12345;
+      data[i] = (unsigned char)(seed >> 16);
+    }
+}
+
+static svn_error_t *
+test_multi_checksum(apr_pool_t *pool)
+{
+  enum { DATA_SIZE = 100000 };
+  unsigned char *data = apr_palloc(pool, DATA_SIZE);
+  svn_checksum__multi_ctx_t *ctx;
+  svn_checksum_kind_t kind;
+  apr_size_t pos, chunk;
+  unsigned kinds = 0;
+
+  fill_buffer(data, DATA_SIZE);
+  for (kind = svn_checksum_md5; kind <= svn_checksum_fnv1a_32x4; ++kind)
+    kinds |= SVN_CHECKSUM__KIND_FLAG(kind);
+
+  ctx = svn_checksum__multi_ctx_create(kinds, pool);
+
+  /* Feed the data twice, reset in between, in chunks of various sizes. */
+  SVN_ERR(svn_checksum__multi_update(ctx, data, 1000));
+  SVN_ERR(svn_checksum__multi_ctx_reset(ctx));
+  for (pos = 0, chunk = 1; pos < DATA_SIZE; pos += chunk, chunk = chunk * 3)
+    SVN_ERR(svn_checksum__multi_update(ctx, data + pos,
+                                       MIN(chunk, DATA_SIZE - pos)));
+
+  for (kind = svn_checksum_md5; kind <= svn_checksum_fnv1a_32x4; ++kind)
+    {
+      svn_checksum_t *expected, *actual;
+
+      SVN_ERR(svn_checksum(&expected, kind, data, DATA_SIZE, pool));
+      SVN_ERR(svn_checksum__multi_final(&actual, ctx, kind, pool));
+      SVN_TEST_ASSERT(svn_checksum_match(expected, actual));
+    }
+
+  /* Kinds not selected are not available. */
+  ctx = svn_checksum__multi_ctx_create(
+          SVN_CHECKSUM__KIND_FLAG(svn_checksum_sha1), pool);
+  SVN_TEST_ASSERT(svn_checksum__multi_ctx_get(ctx, svn_checksum_md5) == NULL);
+  SVN_TEST_ASSERT(svn_checksum__multi_ctx_get(ctx, svn_checksum_sha1));
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_checksummed_stream_md5_sha1(apr_pool_t *pool)
+{
+  enum { DATA_SIZE = 70000 };
+  unsigned char *data = apr_palloc(pool, DATA_SIZE);
+  svn_string_t *str;
+  svn_stringbuf_t *copy = svn_stringbuf_create_empty(pool);
+  svn_checksum_t *md5, *sha1, *read_md5, *read_sha1;
+  svn_checksum_t *write_md5, *write_sha1;
+  svn_stream_t *stream;
+
+  fill_buffer(data, DATA_SIZE);
+  str = svn_string_ncreate((const char *)data, DATA_SIZE, pool);
+  SVN_ERR(svn_checksum(&md5, svn_checksum_md5, data, DATA_SIZE, pool));
+  SVN_ERR(svn_checksum(&sha1, svn_checksum_sha1, data, DATA_SIZE, pool));
+
+  /* Read side, relying on READ_ALL. */
+  stream = svn_stream__checksummed_md5_sha1(svn_stream_from_string(str,
+                                                                   pool),
+                                            &read_md5, &read_sha1,
+                                            NULL, NULL, TRUE, pool);
+  SVN_ERR(svn_stream_close(stream));
+  SVN_TEST_ASSERT(svn_checksum_match(md5, read_md5));
+  SVN_TEST_ASSERT(svn_checksum_match(sha1, read_sha1));
+
+  /* Write side. */
+  stream = svn_stream__checksummed_md5_sha1(svn_stream_from_stringbuf(copy,
+                                                                      pool),
+                                            NULL, NULL,
+                                            &write_md5, &write_sha1,
+                                            FALSE, pool);
+  SVN_ERR(svn_stream_copy3(svn_stream_from_string(str, pool), stream,
+                           NULL, NULL, pool));
+  SVN_TEST_ASSERT(svn_checksum_match(md5, write_md5));
+  SVN_TEST_ASSERT(svn_checksum_match(sha1, write_sha1));
+  SVN_TEST_ASSERT(copy->len == DATA_SIZE);
+  SVN_TEST_ASSERT(memcmp(copy->data, data, DATA_SIZE) == 0);
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *LENS to COUNT item sizes with a distribution similar to the items
+ * in FSFS rev and pack files: mostly noderevs and small deltas of a few
+ * hundred bytes and some larger representations.  Allocate it in POOL and
+ * return the sum of all sizes.
+ */
+static apr_size_t
+item_sizes(apr_size_t **lens,
+           int count,
+           apr_pool_t *pool)
+{
+  apr_uint32_t seed = 54321;
+  apr_size_t total = 0;
+  int i;
+
+  *lens = apr_palloc(pool, count * sizeof(**lens));
+  for (i = 0; i < count; ++i)
+    {
+      seed = seed * 1103515245 + 12345;
+      if (i % 50 == 0)
+        (*lens)[i] = 1000 + (seed >> 8) % 15000;
+      else if (i % 7 == 0)
+        (*lens)[i] = (seed >> 8) % 8;
+      else
+        (*lens)[i] = 40 + (seed >> 8) % 400;
+
+      total += (*lens)[i];
+    }
+
+  return total;
+}
+
+/* Set INPUTS to the start addresses of the consecutive buffers of LENS
+ * bytes, respectively, at DATA.  COUNT is the number of buffers. */
+static void
+split_buffer(const void **inputs,
+             const unsigned char *data,
+             const apr_size_t *lens,
+             int count)
+{
+  int i;
+  for (i = 0; i < count; ++i)
+    {
+      inputs[i] = data;
+      data += lens[i];
+    }
+}
+
+static svn_error_t *
+test_fnv1a_multi(apr_pool_t *pool)
+{
+  enum { COUNT = 1000 };
+  apr_size_t *lens;
+  apr_size_t total = item_sizes(&lens, COUNT, pool);
+  unsigned char *data = apr_palloc(pool, total);
+  const void **inputs = apr_palloc(pool, COUNT * sizeof(*inputs));
+  apr_uint32_t *checksums = apr_palloc(pool, COUNT * sizeof(*checksums));
+  int count, i;
+
+  fill_buffer(data, total);
+  split_buffer(inputs, data, lens, COUNT);
+
+  /* Small batches exercise the fallback code and partially filled slots,
+   * larger ones the slot refill logic. */
+  for (count = 0; count <= COUNT; count += (count < 40 ? 1 : 321))
+    {
+      svn__fnv1a_32x4_multi(checksums, inputs, lens, count);
+      for (i = 0; i < count; ++i)
+        SVN_TEST_ASSERT(checksums[i] == svn__fnv1a_32x4(inputs[i], lens[i]));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Reference implementation of svn__adler32. */
+static apr_uint32_t
+adler32_reference(apr_uint32_t checksum,
+                  const unsigned char *data,
+                  apr_size_t len)
+{
+  apr_uint32_t s1 = checksum & 0xFFFF;
+  apr_uint32_t s2 = checksum >> 16;
+  apr_size_t i;
+
+  for (i = 0; i < len; ++i)
+    {
+      s1 = (s1 + data[i]) % 65521;
+      s2 = (s2 + s1) % 65521;
+    }
+
+  return (s2 << 16) | s1;
+}
+
+static svn_error_t *
+test_adler32(apr_pool_t *pool)
+{
+  enum { DATA_SIZE = 20000 };
+  unsigned char *data = apr_palloc(pool, DATA_SIZE + 16);
+  const apr_uint32_t starts[] = { 1, 0xfff0fff0, 0x12345678 };
+  apr_size_t len;
+  int i, offset;
+
+  /* Use data that will make the sums grow quickly. */
+  fill_buffer(data, DATA_SIZE + 16);
+  for (i = 0; i < DATA_SIZE; i += 3)
+    data[i] = 0xff;
+
+  for (len = 0; len < DATA_SIZE; len += (len < 200 ? 1 : 997))
+    for (offset = 0; offset < 3; ++offset)
+      for (i = 0; i < (int)(sizeof(starts) / sizeof(starts[0])); ++i)
+        SVN_TEST_ASSERT(svn__adler32(starts[i], (const char *)data + offset,
+                                     len)
+                        == adler32_reference(starts[i], data + offset, len));
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_checksum_performance(apr_pool_t *pool)
+{
+  enum { COUNT = 100000, TOKEN_COUNT = 1000000, REPEAT = 5 };
+  apr_size_t *lens;
+  apr_size_t total = item_sizes(&lens, COUNT, pool);
+  unsigned char *data = apr_palloc(pool, total);
+  const void **inputs = apr_palloc(pool, COUNT * sizeof(*inputs));
+  apr_uint32_t *checksums = apr_palloc(pool, COUNT * sizeof(*checksums));
+  apr_uint32_t sum = 0;
+  apr_time_t start, scalar, multi, svn_adler, zlib_adler;
+  int i, k;
+
+  SVN_TEST_ASSERT(total > TOKEN_COUNT + 120);
+  fill_buffer(data, total);
+  split_buffer(inputs, data, lens, COUNT);
+
+  /* FNV-1a over items as found in rev / pack files. */
+  start = apr_time_now();
+  for (k = 0; k < REPEAT; ++k)
+    for (i = 0; i < COUNT; ++i)
+      checksums[i] = svn__fnv1a_32x4(inputs[i], lens[i]);
+  scalar = apr_time_now() - start;
+
+  start = apr_time_now();
+  for (k = 0; k < REPEAT; ++k)
+    svn__fnv1a_32x4_multi(checksums, inputs, lens, COUNT);
+  multi = apr_time_now() - start;
+
+  printf("FNV-1a x4 over %d items, %" APR_SIZE_T_FMT " bytes:\n",
+         COUNT, total);
+  printf("  scalar:       %" APR_TIME_T_FMT " musecs\n", scalar);
+  printf("  multi (%s): %" APR_TIME_T_FMT " musecs\n",
+         svn__fnv1a_32x4_implementation(), multi);
+
+  /* Adler-32 over line-sized tokens as they are being hashed in diff. */
+  start = apr_time_now();
+  for (i = 0; i < TOKEN_COUNT; ++i)
+    sum += svn__adler32(1, (const char *)data + i, 10 + i % 110);
+  svn_adler = apr_time_now() - start;
+
+  start = apr_time_now();
+  for (i = 0; i < TOKEN_COUNT; ++i)
+    sum += (apr_uint32_t)adler32(1, data + i, 10 + i % 110);
+  zlib_adler = apr_time_now() - start;
+
+  printf("Adler-32 over %d tokens (checksum %x):\n", TOKEN_COUNT, sum);
+  printf("  svn__adler32: %" APR_TIME_T_FMT " musecs\n", svn_adler);
+  printf("  zlib:         %" APR_TIME_T_FMT " musecs\n", zlib_adler);
+
+  return SVN_NO_ERROR;
+}
+
 /* An array of all test functions */
 
 static int max_threads = 1;
@@ -389,6 +737,18 @@ static struct svn_test_descriptor_t test_funcs[] =
                    "read from checksummed stream"),
     SVN_TEST_PASS2(test_checksummed_stream_reset,
                    "reset checksummed stream"),
+    SVN_TEST_PASS2(test_sha_vectors,
+                   "SHA-1 and SHA-256 test vectors"),
+    SVN_TEST_PASS2(test_multi_checksum,
+                   "multi-checksum context"),
+    SVN_TEST_PASS2(test_checksummed_stream_md5_sha1,
+                   "MD5 and SHA-1 checksummed stream"),
+    SVN_TEST_PASS2(test_fnv1a_multi,
+                   "multi-buffer FNV-1a"),
+    SVN_TEST_PASS2(test_adler32,
+                   "Adler-32 against reference implementation"),
+    SVN_TEST_SKIP2(test_checksum_performance, TRUE,
+                   "optional checksum performance test"),
     SVN_TEST_NULL
   };
 
@@ -36,6 +36,8 @@
 #include "svn_dirent_uri.h"
 #include "svn_error.h"
 #include "svn_config.h"
+#include "svn_hash.h"
+#include "svn_io.h"
 #include "private/svn_subr_private.h"
 #include "private/svn_config_private.h"
 
@@ -458,6 +460,84 @@ test_serialization(apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+/* Write CONTENTS to the file PATH and make it look a while old. */
+static svn_error_t *
+write_old_file(const char *path,
+               const char *contents,
+               apr_pool_t *pool)
+{
+  SVN_ERR(svn_io_remove_file2(path, TRUE, pool));
+  SVN_ERR(svn_io_file_create(path, contents, pool));
+  SVN_ERR(svn_io_set_file_affected_time(apr_time_now()
+                                        - apr_time_from_sec(60),
+                                        path, pool));
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_config_cache(apr_pool_t *pool)
+{
+  const char *config_dir, *config_path, *cache_path;
+  apr_hash_t *cfg_hash;
+  svn_config_t *cfg;
+  const char *value;
+  svn_node_kind_t kind;
+  apr_finfo_t finfo;
+
+  SVN_ERR(svn_test_make_sandbox_dir(&config_dir, "config-test-cache", pool));
+  config_path = svn_dirent_join(config_dir, SVN_CONFIG_CATEGORY_CONFIG,
+                                pool);
+  cache_path = apr_pstrcat(pool, config_path, ".cache", SVN_VA_NULL);
+
+  /* Files modified just now don't get cached. */
+  SVN_ERR(svn_io_file_create(config_path, "[Section]\nOption = one\n",
+                             pool));
+  SVN_ERR(svn_config_get_config(&cfg_hash, config_dir, pool));
+  SVN_ERR(svn_io_check_path(cache_path, &kind, pool));
+  SVN_TEST_ASSERT(kind == svn_node_none);
+
+  /* Reading older ones creates the cache. */
+  SVN_ERR(write_old_file(config_path, "[Section]\nOption = two\n", pool));
+  SVN_ERR(svn_config_get_config(&cfg_hash, config_dir, pool));
+  SVN_ERR(svn_io_check_path(cache_path, &kind, pool));
+  SVN_TEST_ASSERT(kind == svn_node_file);
+
+  cfg = svn_hash_gets(cfg_hash, SVN_CONFIG_CATEGORY_CONFIG);
+  svn_config_get(cfg, &value, "section", "option", NULL);
+  SVN_TEST_STRING_ASSERT(value, "two");
+
+  /* Reading it again uses the cache, as long as the file stamp stays
+     the same.  So, replace the file contents behind its back. */
+  SVN_ERR(svn_io_stat(&finfo, config_path, APR_FINFO_MTIME, pool));
+  SVN_ERR(write_old_file(config_path, "[Section]\nOption = 2nd\n", pool));
+  SVN_ERR(svn_io_set_file_affected_time(finfo.mtime, config_path, pool));
+
+  SVN_ERR(svn_config_get_config(&cfg_hash, config_dir, pool));
+  cfg = svn_hash_gets(cfg_hash, SVN_CONFIG_CATEGORY_CONFIG);
+  svn_config_get(cfg, &value, "section", "option", NULL);
+  SVN_TEST_STRING_ASSERT(value, "two");
+
+  /* Any other modification invalidates the cache. */
+  SVN_ERR(write_old_file(config_path, "[Section]\nOption = three\n",
+                         pool));
+  SVN_ERR(svn_config_get_config(&cfg_hash, config_dir, pool));
+  cfg = svn_hash_gets(cfg_hash, SVN_CONFIG_CATEGORY_CONFIG);
+  svn_config_get(cfg, &value, "section", "option", NULL);
+  SVN_TEST_STRING_ASSERT(value, "three");
+
+  /* A broken cache is ignored. */
+  SVN_ERR(svn_io_remove_file2(cache_path, FALSE, pool));
+  SVN_ERR(svn_io_file_create(cache_path, "svn-config-cache 1\n9999",
+                             pool));
+  SVN_ERR(svn_config_get_config(&cfg_hash, config_dir, pool));
+  cfg = svn_hash_gets(cfg_hash, SVN_CONFIG_CATEGORY_CONFIG);
+  svn_config_get(cfg, &value, "section", "option", NULL);
+  SVN_TEST_STRING_ASSERT(value, "three");
+
+  return SVN_NO_ERROR;
+}
+
 /*
    ====================================================================
    If you add a new test to this file, update this array.
@@ -494,6 +574,8 @@ static struct svn_test_descriptor_t test_funcs[] =
                    "test parsing config file with invalid BOM"),
     SVN_TEST_PASS2(test_serialization,
                    "test writing a config"),
+    SVN_TEST_PASS2(test_config_cache,
+                   "test the run-time configuration cache"),
     SVN_TEST_NULL
   };
 
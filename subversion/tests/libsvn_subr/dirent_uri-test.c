@@ -1172,6 +1172,13 @@ test_relpath_is_canonical(apr_pool_t *pool)
     { "dirA",                  TRUE },
     { "foo/dirA",              TRUE },
     { "foo/./bar",             FALSE },
+    { "foo/.bar",              TRUE },
+    { "foo/.../bar",           TRUE },
+    { "foo/bar/.",             FALSE },
+    { "foo/bar/./",            FALSE },
+    { "foo/bar//",             FALSE },
+    { "a/b/c/d/e/f/g/h/i/j/k/l/m/n/o/p",     TRUE },
+    { "a/b/c/d/e/f/g/h/i/j/k/l/m/n/o//p",    FALSE },
     { "http://hst",            FALSE },
     { "http://hst/foo/../bar", FALSE },
     { "http://HST/",           FALSE },
@@ -28,6 +28,7 @@
 #include <apr.h>
 #include <apr_version.h>
 
+#include "svn_hash.h"
 #include "svn_pools.h"
 #include "svn_string.h"
 #include "svn_io.h"
@@ -1147,6 +1148,190 @@ test_apr_trunc_workaround(apr_pool_t *pool)
   return SVN_NO_ERROR;  
 }
 
+static svn_error_t *
+test_batch_fsync(apr_pool_t *pool)
+{
+  const char *abspath;
+  svn_io__batch_fsync_t *batch;
+  int i;
+
+  /* Create an empty working directory and let it be cleaned up by the test
+   * harness. */
+  SVN_ERR(svn_dirent_get_absolute(&abspath, "test_batch_fsync", pool));
+
+  SVN_ERR(svn_io_remove_dir2(abspath, TRUE, NULL, NULL, pool));
+  SVN_ERR(svn_io_make_dir_recursively(abspath, pool));
+  svn_test_add_dir_cleanup(abspath);
+
+  /* Initialize infrastructure with a pool that lives as long as this
+   * application. */
+  SVN_ERR(svn_io__batch_fsync_init(pool));
+
+  /* We use and re-use the same batch object throughout this test. */
+  SVN_ERR(svn_io__batch_fsync_create(&batch, TRUE, pool));
+
+  /* The working directory is new. */
+  SVN_ERR(svn_io__batch_fsync_new_path(batch, abspath, pool));
+
+  /* 1st run: Has to fire up worker threads etc. */
+  for (i = 0; i < 10; ++i)
+    {
+      apr_file_t *file;
+      const char *path = svn_dirent_join(abspath,
+                                         apr_psprintf(pool, "file%i", i),
+                                         pool);
+      apr_size_t len = strlen(path);
+
+      SVN_ERR(svn_io__batch_fsync_open_file(&file, batch, path, pool));
+
+      SVN_ERR(svn_io_file_write(file, path, &len, pool));
+    }
+
+  SVN_ERR(svn_io__batch_fsync_run(batch, pool));
+
+  /* 2nd run: Running a batch must leave the container in an empty,
+   * re-usable state. Hence, try to re-use it.  Also, schedule the
+   * existing files from the 1st run. */
+  for (i = 0; i < 10; ++i)
+    {
+      apr_file_t *file;
+      const char *path = svn_dirent_join(abspath,
+                                         apr_psprintf(pool, "new%i", i),
+                                         pool);
+      apr_size_t len = strlen(path);
+
+      SVN_ERR(svn_io__batch_fsync_open_file(&file, batch, path, pool));
+
+      SVN_ERR(svn_io_file_write(file, path, &len, pool));
+
+      path = svn_dirent_join(abspath, apr_psprintf(pool, "file%i", i), pool);
+      SVN_ERR(svn_io__batch_fsync_add_file(batch, path, pool));
+    }
+
+  SVN_ERR(svn_io__batch_fsync_run(batch, pool));
+
+#ifdef SVN_ON_POSIX
+  /* Read-only files can be flushed on POSIX. */
+  for (i = 0; i < 10; ++i)
+    {
+      const char *path = svn_dirent_join(abspath,
+                                         apr_psprintf(pool, "file%i", i),
+                                         pool);
+
+      SVN_ERR(svn_io_set_file_read_only(path, FALSE, pool));
+      SVN_ERR(svn_io__batch_fsync_add_file(batch, path, pool));
+    }
+
+  SVN_ERR(svn_io__batch_fsync_run(batch, pool));
+#endif
+
+  /* Last run: Schedule but don't execute. POOL cleanup shall not fail. */
+  for (i = 0; i < 10; ++i)
+    {
+      apr_file_t *file;
+      const char *path = svn_dirent_join(abspath,
+                                         apr_psprintf(pool, "another%i", i),
+                                         pool);
+      apr_size_t len = strlen(path);
+
+      SVN_ERR(svn_io__batch_fsync_open_file(&file, batch, path, pool));
+
+      SVN_ERR(svn_io_file_write(file, path, &len, pool));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_create_hardlink(apr_pool_t *pool)
+{
+  const char *tmp_dir;
+  const char *foo_path;
+  const char *bar_path;
+  svn_stringbuf_t *actual_content;
+  svn_boolean_t linked;
+  apr_finfo_t finfo;
+
+  SVN_ERR(svn_test_make_sandbox_dir(&tmp_dir, "test_create_hardlink", pool));
+
+  foo_path = svn_dirent_join(tmp_dir, "foo", pool);
+  bar_path = svn_dirent_join(tmp_dir, "bar", pool);
+  SVN_ERR(svn_io_file_create(foo_path, "file content", pool));
+
+  SVN_ERR(svn_io__create_hardlink(&linked, foo_path, bar_path, pool));
+  if (!linked)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "Hard links are not supported here");
+
+  SVN_ERR(svn_stringbuf_from_file2(&actual_content, bar_path, pool));
+  SVN_TEST_STRING_ASSERT(actual_content->data, "file content");
+  SVN_ERR(svn_io_stat(&finfo, bar_path, APR_FINFO_NLINK, pool));
+  SVN_TEST_ASSERT(finfo.nlink == 2);
+
+  /* The target must not exist. */
+  SVN_TEST_ASSERT_ANY_ERROR(svn_io__create_hardlink(&linked, foo_path,
+                                                    bar_path, pool));
+
+  /* Copying a file onto itself gives it an inode of its own. */
+  SVN_ERR(svn_io_copy_file(bar_path, bar_path, TRUE, pool));
+  SVN_ERR(svn_io_stat(&finfo, foo_path, APR_FINFO_NLINK, pool));
+  SVN_TEST_ASSERT(finfo.nlink == 1);
+  SVN_ERR(svn_stringbuf_from_file2(&actual_content, bar_path, pool));
+  SVN_TEST_STRING_ASSERT(actual_content->data, "file content");
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_get_dirents(apr_pool_t *pool)
+{
+  const char *tmp_dir;
+  const char *file_path;
+  apr_hash_t *dirents;
+  const svn_io_dirent2_t *dirent;
+  const svn_io_dirent2_t *expected;
+  svn_error_t *err;
+
+  SVN_ERR(svn_test_make_sandbox_dir(&tmp_dir, "test_get_dirents", pool));
+
+  file_path = svn_dirent_join(tmp_dir, "file", pool);
+  SVN_ERR(svn_io_file_create(file_path, "12345", pool));
+  SVN_ERR(svn_io_dir_make(svn_dirent_join(tmp_dir, "dir", pool),
+                          APR_OS_DEFAULT, pool));
+
+  /* Type information only. */
+  SVN_ERR(svn_io_get_dirents3(&dirents, tmp_dir, TRUE, pool, pool));
+  SVN_TEST_ASSERT(apr_hash_count(dirents) == 2);
+
+  dirent = svn_hash_gets(dirents, "file");
+  SVN_TEST_ASSERT(dirent && dirent->kind == svn_node_file);
+  SVN_TEST_ASSERT(!dirent->special);
+  SVN_TEST_ASSERT(dirent->filesize == SVN_INVALID_FILESIZE);
+
+  dirent = svn_hash_gets(dirents, "dir");
+  SVN_TEST_ASSERT(dirent && dirent->kind == svn_node_dir);
+
+  /* Full information must match what a separate stat returns. */
+  SVN_ERR(svn_io_get_dirents3(&dirents, tmp_dir, FALSE, pool, pool));
+  SVN_TEST_ASSERT(apr_hash_count(dirents) == 2);
+  SVN_ERR(svn_io_stat_dirent2(&expected, file_path, FALSE, FALSE,
+                              pool, pool));
+
+  dirent = svn_hash_gets(dirents, "file");
+  SVN_TEST_ASSERT(dirent && dirent->kind == svn_node_file);
+  SVN_TEST_ASSERT(dirent->filesize == 5);
+  SVN_TEST_ASSERT(dirent->mtime == expected->mtime);
+
+  /* Missing directories are reported as such. */
+  err = svn_io_get_dirents3(&dirents,
+                            svn_dirent_join(tmp_dir, "missing", pool),
+                            TRUE, pool, pool);
+  SVN_TEST_ASSERT(err && APR_STATUS_IS_ENOENT(err->apr_err));
+  svn_error_clear(err);
+
+  return SVN_NO_ERROR;
+}
+
 /* The test table.  */
 
 static int max_threads = 3;
@@ -1184,6 +1369,12 @@ static struct svn_test_descriptor_t test_funcs[] =
                    "test svn_io_open_uniquely_named()"),
     SVN_TEST_PASS2(test_apr_trunc_workaround,
                    "test workaround for APR in svn_io_file_trunc"),
+    SVN_TEST_PASS2(test_batch_fsync,
+                   "test batch fsync"),
+    SVN_TEST_PASS2(test_create_hardlink,
+                   "test svn_io__create_hardlink()"),
+    SVN_TEST_PASS2(test_get_dirents,
+                   "test svn_io_get_dirents3()"),
     SVN_TEST_NULL
   };
 
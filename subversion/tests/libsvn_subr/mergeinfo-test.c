@@ -1083,6 +1083,90 @@ test_rangelist_intersect_randomly(apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+/* Set *RANGELIST to a rangelist representing the revisions REVS, an array
+ * of RANDOM_REV_ARRAY_LENGTH elements that are 0 for revisions not in the
+ * rangelist, 1 for inheritable and 2 for non-inheritable revisions. */
+static svn_error_t *
+inheritance_array_to_rangelist(svn_rangelist_t **rangelist,
+                               int *revs,
+                               apr_pool_t *pool)
+{
+  svn_stringbuf_t *buf = svn_stringbuf_create_empty(pool);
+  int i;
+
+  for (i = 0; i < RANDOM_REV_ARRAY_LENGTH; i++)
+    {
+      if (revs[i])
+        {
+          if (buf->len)
+            svn_stringbuf_appendbyte(buf, ',');
+          svn_stringbuf_appendcstr(buf, apr_psprintf(pool, "%d%s", i,
+                                                     revs[i] == 2 ? "*"
+                                                                  : ""));
+        }
+    }
+
+  return svn_error_trace(svn_rangelist__parse(rangelist, buf->data, pool));
+}
+
+static svn_error_t *
+test_rangelist_merge_randomly(apr_pool_t *pool)
+{
+  int i;
+  apr_pool_t *iterpool;
+
+  random_rev_array_seed = (apr_uint32_t) apr_time_now();
+
+  iterpool = svn_pool_create(pool);
+
+  for (i = 0; i < 200; i++)
+    {
+      int first_revs[RANDOM_REV_ARRAY_LENGTH],
+        second_revs[RANDOM_REV_ARRAY_LENGTH],
+        expected_revs[RANDOM_REV_ARRAY_LENGTH];
+      svn_rangelist_t *first_rangelist, *second_rangelist,
+        *expected_rangelist;
+      svn_string_t *expected_string, *actual_string;
+      int j;
+
+      svn_pool_clear(iterpool);
+
+      /* There is no change numbered "r0".  Inheritable wins when both
+         rangelists contain a revision. */
+      for (j = 0; j < RANDOM_REV_ARRAY_LENGTH; j++)
+        {
+          first_revs[j] = j ? svn_test_rand(&random_rev_array_seed) % 3 : 0;
+          second_revs[j] = j ? svn_test_rand(&random_rev_array_seed) % 3 : 0;
+
+          if (first_revs[j] == 1 || second_revs[j] == 1)
+            expected_revs[j] = 1;
+          else
+            expected_revs[j] = first_revs[j] ? first_revs[j] : second_revs[j];
+        }
+
+      SVN_ERR(inheritance_array_to_rangelist(&first_rangelist, first_revs,
+                                             iterpool));
+      SVN_ERR(inheritance_array_to_rangelist(&second_rangelist, second_revs,
+                                             iterpool));
+      SVN_ERR(inheritance_array_to_rangelist(&expected_rangelist,
+                                             expected_revs, iterpool));
+
+      SVN_ERR(svn_rangelist_merge2(first_rangelist, second_rangelist,
+                                   iterpool, iterpool));
+
+      SVN_TEST_ASSERT(svn_rangelist__is_canonical(first_rangelist));
+      SVN_ERR(svn_rangelist_to_string(&expected_string, expected_rangelist,
+                                      iterpool));
+      SVN_ERR(svn_rangelist_to_string(&actual_string, first_rangelist,
+                                      iterpool));
+      SVN_TEST_STRING_ASSERT(actual_string->data, expected_string->data);
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
 /* ### Share code with test_diff_mergeinfo() and test_remove_rangelist(). */
 static svn_error_t *
 test_remove_mergeinfo(apr_pool_t *pool)
@@ -1811,6 +1895,8 @@ static struct svn_test_descriptor_t test_funcs[] =
                    "intersection of rangelists"),
     SVN_TEST_PASS2(test_rangelist_intersect_randomly,
                    "test rangelist intersect with random data"),
+    SVN_TEST_PASS2(test_rangelist_merge_randomly,
+                   "test rangelist merge with random data"),
     SVN_TEST_PASS2(test_diff_mergeinfo,
                    "diff of mergeinfo"),
     SVN_TEST_PASS2(test_merge_mergeinfo,
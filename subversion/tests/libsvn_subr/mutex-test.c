@@ -0,0 +1,290 @@
+/*
+ * mutex-test.c:  a collection of svn_rwlock__* tests
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include <apr_pools.h>
+#include <apr_thread_proc.h>
+#include <apr_time.h>
+
+#include "svn_pools.h"
+#include "private/svn_atomic.h"
+#include "private/svn_mutex.h"
+
+#include "../svn_test.h"
+
+#define APR_ERR(expr)                           \
+  do {                                          \
+    apr_status_t status = (expr);               \
+    if (status)                                 \
+      return svn_error_wrap_apr(status, NULL);  \
+  } while (0)
+
+/* Number of threads to run concurrently in each test. */
+#define THREAD_COUNT 8
+
+/* Number of times each thread acquires the lock in test_rwlock_writers. */
+#define ITERATIONS 2000
+
+/* How long the readers in test_rwlock_readers wait for each other. */
+#define READER_TIMEOUT apr_time_from_sec(30)
+
+/* State shared by the lock test threads. */
+typedef struct lock_baton_t
+{
+  svn_rwlock__t *lock;
+
+  /* Number of threads holding a read or write lock, respectively. */
+  volatile svn_atomic_t readers;
+  volatile svn_atomic_t writers;
+
+  /* Set if any thread saw a lock being shared that must be exclusive. */
+  volatile svn_atomic_t violations;
+
+  /* Set if all threads held the read lock at the same time. */
+  volatile svn_atomic_t all_readers;
+
+  /* Number of readers in test_rwlock_readers that are ready to leave. */
+  volatile svn_atomic_t leaving;
+
+  /* Incremented by writers only, so no atomics are needed. */
+  int counter;
+} lock_baton_t;
+
+/* Per-thread baton. */
+typedef struct thread_baton_t
+{
+  lock_baton_t *shared;
+
+  /* Whether this thread takes write locks. */
+  svn_boolean_t writer;
+
+  /* Error returned by the lock functions. */
+  svn_error_t *err;
+} thread_baton_t;
+
+/* Hold a read lock on the lock in TB until all THREAD_COUNT threads got
+   one as well or READER_TIMEOUT has passed. */
+static svn_error_t *
+concurrent_reader(thread_baton_t *tb)
+{
+  lock_baton_t *lb = tb->shared;
+  apr_time_t deadline = apr_time_now() + READER_TIMEOUT;
+
+  SVN_ERR(svn_rwlock__read_lock(lb->lock));
+  svn_atomic_inc(&lb->readers);
+
+  while (svn_atomic_read(&lb->readers) < THREAD_COUNT
+         && apr_time_now() < deadline)
+    apr_sleep(1000);
+
+  if (svn_atomic_read(&lb->readers) == THREAD_COUNT)
+    svn_atomic_set(&lb->all_readers, TRUE);
+
+  /* Nobody leaves before everybody had the chance to see all others. */
+  svn_atomic_inc(&lb->leaving);
+  while (svn_atomic_read(&lb->leaving) < THREAD_COUNT
+         && apr_time_now() < deadline)
+    apr_sleep(1000);
+
+  return svn_error_trace(svn_rwlock__unlock(lb->lock, SVN_NO_ERROR));
+}
+
+/* Take the lock in TB ITERATIONS times, checking that write locks are
+   never shared with any other thread. */
+static svn_error_t *
+exclusive_writer(thread_baton_t *tb)
+{
+  lock_baton_t *lb = tb->shared;
+  int i;
+
+  for (i = 0; i < ITERATIONS; ++i)
+    {
+      if (tb->writer)
+        {
+          SVN_ERR(svn_rwlock__write_lock(lb->lock));
+          if (svn_atomic_inc(&lb->writers) != 0
+              || svn_atomic_read(&lb->readers) != 0)
+            svn_atomic_set(&lb->violations, TRUE);
+
+          ++lb->counter;
+
+          svn_atomic_dec(&lb->writers);
+        }
+      else
+        {
+          SVN_ERR(svn_rwlock__read_lock(lb->lock));
+          svn_atomic_inc(&lb->readers);
+          if (svn_atomic_read(&lb->writers) != 0)
+            svn_atomic_set(&lb->violations, TRUE);
+
+          svn_atomic_dec(&lb->readers);
+        }
+
+      SVN_ERR(svn_rwlock__unlock(lb->lock, SVN_NO_ERROR));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+#if APR_HAS_THREADS
+static void *
+APR_THREAD_FUNC reader_thread(apr_thread_t *tid, void *data)
+{
+  thread_baton_t *tb = data;
+
+  tb->err = concurrent_reader(tb);
+  apr_thread_exit(tid, APR_SUCCESS);
+
+  return NULL;
+}
+
+static void *
+APR_THREAD_FUNC writer_thread(apr_thread_t *tid, void *data)
+{
+  thread_baton_t *tb = data;
+
+  /* give all threads a good chance to get started by the scheduler */
+  apr_thread_yield();
+
+  tb->err = exclusive_writer(tb);
+  apr_thread_exit(tid, APR_SUCCESS);
+
+  return NULL;
+}
+
+/* Run THREAD_COUNT threads executing FUNC on a new lock with the given
+   SPIN setting and return the shared state in *LB.  Every other thread
+   will be a writer.  Use POOL for allocations. */
+static svn_error_t *
+run_threads(lock_baton_t **lb,
+            apr_thread_start_t func,
+            svn_boolean_t spin,
+            apr_pool_t *pool)
+{
+  apr_thread_t *threads[THREAD_COUNT];
+  thread_baton_t batons[THREAD_COUNT];
+  svn_error_t *err = SVN_NO_ERROR;
+  int i;
+
+  *lb = apr_pcalloc(pool, sizeof(**lb));
+  SVN_ERR(svn_rwlock__init(&(*lb)->lock, TRUE, spin, pool));
+
+  for (i = 0; i < THREAD_COUNT; ++i)
+    {
+      batons[i].shared = *lb;
+      batons[i].writer = (i % 2 == 0);
+      batons[i].err = SVN_NO_ERROR;
+      APR_ERR(apr_thread_create(&threads[i], NULL, func, &batons[i], pool));
+    }
+
+  /* wait for the threads to finish */
+  for (i = 0; i < THREAD_COUNT; ++i)
+    {
+      apr_status_t retval;
+      APR_ERR(apr_thread_join(&retval, threads[i]));
+      APR_ERR(retval);
+
+      err = svn_error_compose_create(err, batons[i].err);
+    }
+
+  return svn_error_trace(err);
+}
+#endif
+
+static svn_error_t *
+test_rwlock_disabled(apr_pool_t *pool)
+{
+  svn_rwlock__t *lock;
+
+  /* Without LOCK_REQUIRED, everything is a no-op. */
+  SVN_ERR(svn_rwlock__init(&lock, FALSE, TRUE, pool));
+  SVN_TEST_ASSERT(lock == NULL);
+
+  SVN_RWLOCK__WITH_READ_LOCK(lock, SVN_NO_ERROR);
+  SVN_RWLOCK__WITH_WRITE_LOCK(lock, SVN_NO_ERROR);
+
+  /* Errors are passed through. */
+  SVN_TEST_ASSERT_ERROR(svn_rwlock__unlock(lock,
+                                           svn_error_create(
+                                             SVN_ERR_TEST_FAILED, NULL,
+                                             NULL)),
+                        SVN_ERR_TEST_FAILED);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_rwlock_readers(apr_pool_t *pool)
+{
+#if APR_HAS_THREADS
+  lock_baton_t *lb;
+
+  /* Readers must not block each other. */
+  SVN_ERR(run_threads(&lb, reader_thread, FALSE, pool));
+  SVN_TEST_ASSERT(svn_atomic_read(&lb->all_readers));
+
+  SVN_ERR(run_threads(&lb, reader_thread, TRUE, pool));
+  SVN_TEST_ASSERT(svn_atomic_read(&lb->all_readers));
+#endif
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_rwlock_writers(apr_pool_t *pool)
+{
+#if APR_HAS_THREADS
+  lock_baton_t *lb;
+
+  /* Writers exclude everybody else, with and without spinning. */
+  SVN_ERR(run_threads(&lb, writer_thread, FALSE, pool));
+  SVN_TEST_ASSERT(!svn_atomic_read(&lb->violations));
+  SVN_TEST_INT_ASSERT(lb->counter, THREAD_COUNT / 2 * ITERATIONS);
+
+  SVN_ERR(run_threads(&lb, writer_thread, TRUE, pool));
+  SVN_TEST_ASSERT(!svn_atomic_read(&lb->violations));
+  SVN_TEST_INT_ASSERT(lb->counter, THREAD_COUNT / 2 * ITERATIONS);
+#endif
+
+  return SVN_NO_ERROR;
+}
+
+
+/* The test table.  */
+
+static int max_threads = THREAD_COUNT;
+
+static struct svn_test_descriptor_t test_funcs[] =
+  {
+    SVN_TEST_NULL,
+    SVN_TEST_PASS2(test_rwlock_disabled,
+                   "test disabled rwlocks"),
+    SVN_TEST_SKIP2(test_rwlock_readers,
+                   ! APR_HAS_THREADS,
+                   "test concurrent rwlock readers"),
+    SVN_TEST_SKIP2(test_rwlock_writers,
+                   ! APR_HAS_THREADS,
+                   "test rwlock writer exclusion"),
+    SVN_TEST_NULL
+  };
+
+SVN_TEST_MAIN
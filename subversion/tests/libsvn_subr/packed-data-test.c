@@ -553,6 +553,33 @@ test_full_structure(apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+static svn_error_t *
+test_uint_encoding_lengths(apr_pool_t *pool)
+{
+  /* Values just below, at and above every power of two, i.e. numbers
+     of all encoded lengths and around all 7 bit group boundaries. */
+  enum { COUNT = 3 * 64 };
+  apr_uint64_t values[COUNT];
+  int i;
+
+  for (i = 0; i < 64; ++i)
+    {
+      apr_uint64_t value = APR_UINT64_C(1) << i;
+      values[3 * i] = value - 1;
+      values[3 * i + 1] = value;
+      values[3 * i + 2] = value + 1;
+    }
+
+  SVN_ERR(verify_uint_stream(values, COUNT, FALSE, pool));
+  SVN_ERR(verify_uint_stream(values, COUNT, TRUE, pool));
+
+  /* Short streams get decoded from a local, zero-padded buffer. */
+  for (i = 0; i + 10 <= COUNT; i += 10)
+    SVN_ERR(verify_uint_stream(values + i, 10, FALSE, pool));
+
+  return SVN_NO_ERROR;
+}
+
 /* An array of all test functions */
 
 static int max_threads = 1;
@@ -572,6 +599,8 @@ static struct svn_test_descriptor_t test_funcs[] =
                    "test empty, nested structure"),
     SVN_TEST_PASS2(test_full_structure,
                    "test nested structure"),
+    SVN_TEST_PASS2(test_uint_encoding_lengths,
+                   "test uints of all encoded lengths"),
     SVN_TEST_NULL
   };
 
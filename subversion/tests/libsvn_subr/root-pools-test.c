@@ -82,6 +82,33 @@ test_root_pool(apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+static svn_error_t *
+test_root_pool_thread_cache(apr_pool_t *pool)
+{
+  svn_root_pools__t *pools;
+  apr_pool_t *pool1, *pool2;
+  SVN_ERR(svn_root_pools__create(&pools));
+
+  /* A released pool will be cached for the current thread and the next
+     request from this thread will return it. */
+  pool1 = svn_root_pools__acquire_pool(pools);
+  pool2 = svn_root_pools__acquire_pool(pools);
+  SVN_TEST_ASSERT(pool1 != pool2);
+
+  svn_root_pools__release_pool(pool1, pools);
+  svn_root_pools__release_pool(pool2, pools);
+
+  /* POOL2 did not fit into the per-thread cache but became available
+     as well. */
+  SVN_TEST_ASSERT(svn_root_pools__acquire_pool(pools) == pool1);
+  SVN_TEST_ASSERT(svn_root_pools__acquire_pool(pools) == pool2);
+
+  svn_root_pools__release_pool(pool2, pools);
+  svn_root_pools__release_pool(pool1, pools);
+
+  return SVN_NO_ERROR;
+}
+
 #define APR_ERR(expr)                           \
   do {                                          \
     apr_status_t status = (expr);               \
@@ -128,6 +155,9 @@ static struct svn_test_descriptor_t test_funcs[] =
     SVN_TEST_NULL,
     SVN_TEST_PASS2(test_root_pool,
                    "test root pool recycling"),
+    SVN_TEST_SKIP2(test_root_pool_thread_cache,
+                   ! APR_HAS_THREADS,
+                   "test per-thread root pool caching"),
     SVN_TEST_SKIP2(test_root_pool_concurrency,
                    ! APR_HAS_THREADS,
                    "test concurrent root pool recycling"),
@@ -29,6 +29,8 @@
 #include <apr_general.h>
 
 #include "private/svn_io_private.h"
+#include "private/svn_subr_private.h"
+#include "private/svn_tar.h"
 
 #include "../svn_test.h"
 
@@ -1000,6 +1002,211 @@ test_stream_readline_file_crlf(apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+/* Borrow from STREAM until EOF, with at most CHUNK bytes per call, and
+ * return the concatenated data in *RESULT. */
+static svn_error_t *
+borrow_all(svn_stringbuf_t **result,
+           svn_stream_t *stream,
+           apr_size_t chunk,
+           apr_pool_t *pool)
+{
+  *result = svn_stringbuf_create_empty(pool);
+  while (TRUE)
+    {
+      const char *data;
+      apr_size_t len = chunk;
+
+      SVN_ERR(svn_stream__borrow(stream, &data, &len));
+      SVN_TEST_ASSERT(len <= chunk);
+      if (len == 0)
+        break;
+
+      svn_stringbuf_appendbytes(*result, data, len);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_stream_borrow(apr_pool_t *pool)
+{
+  const char *text = "The quick brown fox jumps over the lazy dog";
+  svn_string_t *str = svn_string_create(text, pool);
+  svn_stringbuf_t *result;
+  svn_stream_t *stream;
+  svn_spillbuf_t *buf;
+  svn_checksum_t *md5;
+  const char *data;
+  char buffer[10];
+  apr_size_t len;
+  int i;
+
+  /* Borrowing and copying reads may be mixed. */
+  stream = svn_stream_from_string(str, pool);
+  SVN_TEST_ASSERT(svn_stream__supports_borrow(stream));
+  len = 4;
+  SVN_ERR(svn_stream__borrow(stream, &data, &len));
+  SVN_TEST_ASSERT(len == 4 && data == str->data);
+  len = sizeof(buffer);
+  SVN_ERR(svn_stream_read_full(stream, buffer, &len));
+  SVN_TEST_ASSERT(len == sizeof(buffer) && !memcmp(buffer, text + 4, len));
+  SVN_ERR(borrow_all(&result, stream, 7, pool));
+  SVN_TEST_STRING_ASSERT(result->data, text + 14);
+
+  stream = svn_stream_from_stringbuf(svn_stringbuf_create(text, pool), pool);
+  SVN_TEST_ASSERT(svn_stream__supports_borrow(stream));
+  SVN_ERR(borrow_all(&result, stream, 5, pool));
+  SVN_TEST_STRING_ASSERT(result->data, text);
+
+  /* Pass-through streams lend their source's data and still see it. */
+  stream = svn_stream_checksummed2(svn_stream_from_string(str, pool),
+                                   &md5, NULL, svn_checksum_md5, FALSE,
+                                   pool);
+  SVN_TEST_ASSERT(svn_stream__supports_borrow(stream));
+  SVN_ERR(borrow_all(&result, svn_stream_disown(stream, pool), 3, pool));
+  SVN_TEST_STRING_ASSERT(result->data, text);
+  SVN_ERR(svn_stream_close(stream));
+  SVN_TEST_STRING_ASSERT("9e107d9d372bb6826bd81d3542a419d6",
+                         svn_checksum_to_cstring(md5, pool));
+
+  /* Streams without a buffer of their own can't lend one. */
+  stream = svn_stream_compressed(svn_stream_from_string(str, pool), pool);
+  SVN_TEST_ASSERT(!svn_stream__supports_borrow(stream));
+  len = 1;
+  SVN_TEST_ASSERT_ERROR(svn_stream__borrow(stream, &data, &len),
+                        SVN_ERR_STREAM_NOT_SUPPORTED);
+
+  /* Spill buffers lend their memory blocks as well as data read back
+     from the spill file. */
+  buf = svn_spillbuf__create(8, 16, pool);
+  stream = svn_stream__from_spillbuf(buf, pool);
+  SVN_TEST_ASSERT(svn_stream__supports_borrow(stream));
+  for (i = 0; i < 3; ++i)
+    {
+      len = str->len;
+      SVN_ERR(svn_stream_write(stream, text, &len));
+    }
+  SVN_ERR(borrow_all(&result, stream, 5, pool));
+  SVN_TEST_STRING_ASSERT(result->data,
+                         apr_pstrcat(pool, text, text, text, SVN_VA_NULL));
+
+  /* Copying uses the lent buffers. */
+  result = svn_stringbuf_create_empty(pool);
+  SVN_ERR(svn_stream_copy3(svn_stream_from_string(str, pool),
+                           svn_stream_from_stringbuf(result, pool),
+                           NULL, NULL, pool));
+  SVN_TEST_STRING_ASSERT(result->data, text);
+
+  return SVN_NO_ERROR;
+}
+
+/* Verify that the tar header block at HEADER describes NAME of TYPEFLAG
+   with SIZE bytes of contents and has a valid checksum. */
+static svn_error_t *
+check_tar_header(const char *header,
+                 const char *name,
+                 char typeflag,
+                 apr_uint64_t size)
+{
+  apr_uint64_t checksum = 0;
+  int i;
+
+  for (i = 0; i < 512; i++)
+    checksum += (i >= 148 && i < 156) ? ' ' : (unsigned char)header[i];
+
+  SVN_TEST_ASSERT(strncmp(header, name, 100) == 0);
+  SVN_TEST_ASSERT(header[156] == typeflag);
+  SVN_TEST_ASSERT(apr_strtoi64(header + 124, NULL, 8) == (apr_int64_t)size);
+  SVN_TEST_ASSERT(apr_strtoi64(header + 148, NULL, 8)
+                  == (apr_int64_t)checksum);
+  SVN_TEST_ASSERT(memcmp(header + 257, "ustar", 6) == 0);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_tar_writer(apr_pool_t *pool)
+{
+  svn_stringbuf_t *archive = svn_stringbuf_create_empty(pool);
+  svn_tar__writer_t *tar
+    = svn_tar__writer_create(svn_stream_from_stringbuf(archive, pool), pool);
+  const char *long_name = "dir/"
+                          "012345678901234567890123456789012345678901234567"
+                          "012345678901234567890123456789012345678901234567"
+                          "012345678901234567890123";
+  const char *block;
+  char *pax_record;
+  apr_hash_t *keywords;
+  apr_size_t i;
+
+  SVN_ERR(svn_subst_build_keywords3(&keywords, "Rev", "42", NULL, NULL, 0,
+                                    NULL, pool));
+
+  SVN_ERR(svn_tar__add_directory(tar, "dir", apr_time_from_sec(1), pool));
+  SVN_ERR(svn_tar__add_versioned_file(
+            tar, "dir/file",
+            svn_stream_from_string(svn_string_create("$Rev$\nb\n", pool),
+                                   pool),
+            8, "native", "CRLF", keywords, FALSE, TRUE, 0, NULL, NULL,
+            pool));
+  SVN_ERR(svn_tar__add_versioned_file(
+            tar, "dir/link",
+            svn_stream_from_string(svn_string_create("link file", pool),
+                                   pool),
+            9, NULL, NULL, NULL, TRUE, FALSE, 0, NULL, NULL, pool));
+  SVN_ERR(svn_tar__add_file(tar, long_name,
+                            svn_stream_from_string(svn_string_create("x",
+                                                                     pool),
+                                                   pool),
+                            1, FALSE, 0, NULL, NULL, pool));
+  SVN_ERR(svn_tar__writer_finish(tar, pool));
+
+  /* Everything is made of whole blocks. */
+  SVN_TEST_ASSERT(archive->len == 10 * 512);
+  block = archive->data;
+
+  SVN_ERR(check_tar_header(block, "dir/", '5', 0));
+  SVN_TEST_ASSERT(apr_strtoi64(block + 136, NULL, 8) == 1);
+  SVN_TEST_STRING_ASSERT(block + 100, "0000755");
+  block += 512;
+
+  /* Keywords and line endings got translated. */
+  SVN_ERR(check_tar_header(block, "dir/file", '0', 15));
+  SVN_TEST_STRING_ASSERT(block + 100, "0000755");
+  block += 512;
+  SVN_TEST_ASSERT(memcmp(block, "$Rev: 42 $\r\nb\r\n", 15) == 0);
+  for (i = 15; i < 512; i++)
+    SVN_TEST_ASSERT(block[i] == 0);
+  block += 512;
+
+  SVN_ERR(check_tar_header(block, "dir/link", '2', 0));
+  SVN_TEST_STRING_ASSERT(block + 157, "file");
+  block += 512;
+
+  /* The long name is in a pax extended header. */
+  pax_record = apr_psprintf(pool, "%d path=%s\n",
+                            (int)strlen(long_name) + 10, long_name);
+  SVN_ERR(check_tar_header(block, "././@PaxHeader", 'x',
+                           strlen(pax_record)));
+  block += 512;
+  SVN_TEST_ASSERT(memcmp(block, pax_record, strlen(pax_record)) == 0);
+  block += 512;
+  SVN_ERR(check_tar_header(block, long_name, '0', 1));
+  block += 512;
+  SVN_TEST_ASSERT(block[0] == 'x');
+  block += 512;
+
+  /* Two empty blocks end the archive. */
+  for (i = 0; i < 1024; i++)
+    SVN_TEST_ASSERT(block[i] == 0);
+
+  /* Nothing can be added afterwards. */
+  SVN_TEST_ASSERT_ERROR(svn_tar__add_directory(tar, "late", 0, pool),
+                        SVN_ERR_INCORRECT_PARAMS);
+
+  return SVN_NO_ERROR;
+}
+
 /* The test table.  */
 
 static int max_threads = 1;
@@ -1037,6 +1244,10 @@ static struct svn_test_descriptor_t test_funcs[] =
                    "test reading LF-terminated lines from file"),
     SVN_TEST_PASS2(test_stream_readline_file_crlf,
                    "test reading CRLF-terminated lines from file"),
+    SVN_TEST_PASS2(test_stream_borrow,
+                   "test borrowing stream buffers"),
+    SVN_TEST_PASS2(test_tar_writer,
+                   "test writing tar archives"),
     SVN_TEST_NULL
   };
 
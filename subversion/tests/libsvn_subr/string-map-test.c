@@ -0,0 +1,225 @@
+/*
+ * string-map-test.c:  a collection of svn_string_map__* tests
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+/* ====================================================================
+   To add tests, look toward the bottom of this file.
+
+*/
+
+
+
+#include <stdio.h>
+#include <string.h>
+#include <apr_pools.h>
+#include <apr_strings.h>
+
+#include "../svn_test.h"
+
+#include "svn_error.h"
+#include "svn_hash.h"
+#include "svn_string.h"   /* This includes <apr_*.h> */
+#include "private/svn_subr_private.h"
+
+/* Number of keys to use in the larger tests.  Large enough to trigger
+ * several growth steps. */
+#define KEY_COUNT 10000
+
+/* Return the key for index I, allocated in POOL. */
+static const char *
+make_key(int i,
+         apr_pool_t *pool)
+{
+  return apr_psprintf(pool, "/trunk/subdir/%d/file-%d.c", i % 17, i);
+}
+
+static svn_error_t *
+test_empty(apr_pool_t *pool)
+{
+  svn_string_map__t *map = svn_string_map__create(0, pool);
+  apr_size_t idx = 0;
+
+  SVN_TEST_ASSERT(svn_string_map__count(map) == 0);
+  SVN_TEST_ASSERT(svn_string_map__get(map, "", 0) == NULL);
+  SVN_TEST_ASSERT(svn_string_map__get(map, "foo", 3) == NULL);
+  SVN_TEST_ASSERT(!svn_string_map__next(&idx, NULL, NULL, NULL, map));
+
+  /* Removing what is not there is a no-op. */
+  svn_string_map__set(map, "foo", 3, NULL);
+  SVN_TEST_ASSERT(svn_string_map__count(map) == 0);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_get_set(apr_pool_t *pool)
+{
+  svn_string_map__t *map = svn_string_map__create(0, pool);
+  char key[] = "foo";
+  int a = 1, b = 2;
+
+  svn_string_map__set(map, key, 3, &a);
+  svn_string_map__set(map, "", 0, &b);
+
+  /* The map must have copied the key. */
+  key[0] = 'b';
+  SVN_TEST_ASSERT(svn_string_map__get(map, "foo", 3) == &a);
+  SVN_TEST_ASSERT(svn_string_map__get(map, "boo", 3) == NULL);
+  SVN_TEST_ASSERT(svn_string_map__get(map, "fo", 2) == NULL);
+  SVN_TEST_ASSERT(svn_string_map__get(map, "", 0) == &b);
+  SVN_TEST_ASSERT(svn_string_map__count(map) == 2);
+
+  /* Overwrite and remove. */
+  svn_string_map__set(map, "foo", 3, &b);
+  SVN_TEST_ASSERT(svn_string_map__get(map, "foo", 3) == &b);
+  SVN_TEST_ASSERT(svn_string_map__count(map) == 2);
+
+  svn_string_map__set(map, "foo", 3, NULL);
+  SVN_TEST_ASSERT(svn_string_map__get(map, "foo", 3) == NULL);
+  SVN_TEST_ASSERT(svn_string_map__count(map) == 1);
+
+  svn_string_map__set(map, "foo", 3, &a);
+  SVN_TEST_ASSERT(svn_string_map__get(map, "foo", 3) == &a);
+  SVN_TEST_ASSERT(svn_string_map__count(map) == 2);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_many_keys(apr_pool_t *pool)
+{
+  svn_string_map__t *map = svn_string_map__create(0, pool);
+  apr_hash_t *hash;
+  int *values = apr_palloc(pool, KEY_COUNT * sizeof(*values));
+  int i;
+
+  for (i = 0; i < KEY_COUNT; ++i)
+    {
+      const char *key = make_key(i, pool);
+
+      values[i] = i;
+      svn_string_map__set(map, key, strlen(key), &values[i]);
+    }
+
+  SVN_TEST_ASSERT(svn_string_map__count(map) == KEY_COUNT);
+
+  /* Remove every other key.  Growing the map later will compact it. */
+  for (i = 0; i < KEY_COUNT; i += 2)
+    {
+      const char *key = make_key(i, pool);
+      svn_string_map__set(map, key, strlen(key), NULL);
+    }
+
+  SVN_TEST_ASSERT(svn_string_map__count(map) == KEY_COUNT / 2);
+
+  for (i = KEY_COUNT; i < 2 * KEY_COUNT; ++i)
+    {
+      const char *key = make_key(i, pool);
+      svn_string_map__set(map, key, strlen(key), &values[i % KEY_COUNT]);
+    }
+
+  for (i = 0; i < 2 * KEY_COUNT; ++i)
+    {
+      const char *key = make_key(i, pool);
+      int *value = svn_string_map__get(map, key, strlen(key));
+
+      if (i < KEY_COUNT && i % 2 == 0)
+        SVN_TEST_ASSERT(value == NULL);
+      else
+        SVN_TEST_ASSERT(value == &values[i % KEY_COUNT]);
+    }
+
+  hash = svn_string_map__to_hash(map, pool);
+  SVN_TEST_ASSERT(apr_hash_count(hash) == svn_string_map__count(map));
+  SVN_TEST_ASSERT(svn_hash_gets(hash, make_key(1, pool)) == &values[1]);
+  SVN_TEST_ASSERT(svn_hash_gets(hash, make_key(2, pool)) == NULL);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_iteration_order(apr_pool_t *pool)
+{
+  svn_string_map__t *map = svn_string_map__create(0, pool);
+  int *values = apr_palloc(pool, KEY_COUNT * sizeof(*values));
+  apr_size_t idx = 0;
+  const char *key;
+  apr_size_t len;
+  void *value;
+  int i;
+
+  for (i = 0; i < KEY_COUNT; ++i)
+    {
+      key = make_key(i, pool);
+      values[i] = i;
+      svn_string_map__set(map, key, strlen(key), &values[i]);
+    }
+
+  /* Removing entries while iterating is allowed. */
+  i = 0;
+  while (svn_string_map__next(&idx, &key, &len, &value, map))
+    {
+      SVN_TEST_STRING_ASSERT(key, make_key(i, pool));
+      SVN_TEST_ASSERT(len == strlen(key));
+      SVN_TEST_ASSERT(value == &values[i]);
+
+      if (i % 3 == 0)
+        svn_string_map__set(map, key, len, NULL);
+
+      ++i;
+    }
+
+  SVN_TEST_ASSERT(i == KEY_COUNT);
+
+  /* Only the remaining entries get reported, still in insertion order. */
+  idx = 0;
+  i = 1;
+  while (svn_string_map__next(&idx, &key, NULL, NULL, map))
+    {
+      SVN_TEST_STRING_ASSERT(key, make_key(i, pool));
+      i += (i % 3 == 1) ? 1 : 2;
+    }
+
+  SVN_TEST_ASSERT(i >= KEY_COUNT);
+
+  return SVN_NO_ERROR;
+}
+
+/* An array of all test functions */
+
+static int max_threads = 1;
+
+static struct svn_test_descriptor_t test_funcs[] =
+  {
+    SVN_TEST_NULL,
+    SVN_TEST_PASS2(test_empty,
+                   "operations on an empty map"),
+    SVN_TEST_PASS2(test_get_set,
+                   "get / set / remove entries"),
+    SVN_TEST_PASS2(test_many_keys,
+                   "grow and compact the map"),
+    SVN_TEST_PASS2(test_iteration_order,
+                   "iterate in insertion order"),
+    SVN_TEST_NULL
+  };
+
+SVN_TEST_MAIN
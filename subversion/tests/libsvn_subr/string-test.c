@@ -849,6 +849,16 @@ test_string_matching(apr_pool_t *pool)
       {"x_234567890abcdef", "x1234567890abcdef", 1, 15},
       {"1234567890abcdefx", "1234567890abcdex", 15, 1},
 
+      /* matches spanning several 16 byte chunks */
+      {"0123456789abcdef0123456789abcdef0123456789abcdef",
+       "0123456789abcdef0123456789abcdef0123456789abcdef", 48, 48},
+      {"0123456789abcdef0123456789abcdef_123456789abcdef",
+       "0123456789abcdef0123456789abcdef0123456789abcdef", 32, 15},
+      {"0123456789abcdef0123456789abcde_0123456789abcdef",
+       "0123456789abcdef0123456789abcdef0123456789abcdef", 31, 16},
+      {"x0123456789abcdef0123456789abcdef",
+       "y0123456789abcdef0123456789abcdef", 0, 32},
+
       /* list terminator */
       {NULL}
     };
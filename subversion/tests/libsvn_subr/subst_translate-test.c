@@ -32,6 +32,8 @@
 #include "svn_subst.h"
 #include "svn_hash.h"
 
+#include "private/svn_subst_private.h"
+
 #define ARRAY_LEN(ary) ((sizeof (ary)) / (sizeof ((ary)[0])))
 
 /* Test inputs and expected output for svn_subst_translate_string2(). */
@@ -500,6 +502,94 @@ test_svn_subst_long_keywords(apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+/* Translate CHUNKS, a NULL-terminated array, one write at a time through
+ * svn_subst_stream_translated() with EOL_STR, REPAIR and KEYWORDS.  Return
+ * the result in *RESULT. */
+static svn_error_t *
+translate_chunks(const char **result,
+                 const char *const *chunks,
+                 const char *eol_str,
+                 svn_boolean_t repair,
+                 apr_hash_t *keywords,
+                 apr_pool_t *pool)
+{
+  svn_stringbuf_t *buf = svn_stringbuf_create_empty(pool);
+  svn_stream_t *stream
+    = svn_subst_stream_translated(svn_stream_from_stringbuf(buf, pool),
+                                  eol_str, repair, keywords, TRUE, pool);
+
+  for (; *chunks; ++chunks)
+    SVN_ERR(svn_stream_puts(stream, *chunks));
+
+  SVN_ERR(svn_stream_close(stream));
+  *result = buf->data;
+
+  return SVN_NO_ERROR;
+}
+
+/* Check whether svn_subst__translation_is_noop() returns EXPECTED for
+ * SOURCE, EOL_STR and KEYWORDS. */
+static svn_error_t *
+check_noop(svn_boolean_t expected,
+           const char *source,
+           const char *eol_str,
+           apr_hash_t *keywords,
+           apr_pool_t *pool)
+{
+  svn_boolean_t noop;
+  svn_stream_t *stream
+    = svn_stream_from_string(svn_string_create(source, pool), pool);
+
+  SVN_ERR(svn_subst__translation_is_noop(&noop, stream, eol_str, keywords,
+                                         pool));
+  SVN_TEST_ASSERT(noop == expected);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_svn_subst_pass_through(apr_pool_t *pool)
+{
+  static const char *const lf_then_crlf[] = { "a\nb\n", "c\r\nd", NULL };
+  static const char *const crlf_then_lf[] = { "a\r\n", "b\nc\n", NULL };
+  static const char *const cr_split[] = { "a\r", "\nb\n", NULL };
+  static const char *const keyword[] = { "a\nb\n", "$Rev$\n", "c\n", NULL };
+  apr_hash_t *keywords = apr_hash_make(pool);
+  const char *result;
+
+  svn_hash_sets(keywords, "Rev", svn_string_create("42", pool));
+
+  /* Chunks passed through must still count for EOL consistency. */
+  SVN_TEST_ASSERT_ERROR(translate_chunks(&result, lf_then_crlf, "\n", FALSE,
+                                         NULL, pool),
+                        SVN_ERR_IO_INCONSISTENT_EOL);
+  SVN_TEST_ASSERT_ERROR(translate_chunks(&result, crlf_then_lf, "\n", FALSE,
+                                         NULL, pool),
+                        SVN_ERR_IO_INCONSISTENT_EOL);
+
+  SVN_ERR(translate_chunks(&result, lf_then_crlf, "\n", TRUE, NULL, pool));
+  SVN_TEST_STRING_ASSERT(result, "a\nb\nc\nd");
+  SVN_ERR(translate_chunks(&result, crlf_then_lf, "\n", TRUE, NULL, pool));
+  SVN_TEST_STRING_ASSERT(result, "a\nb\nc\n");
+  SVN_ERR(translate_chunks(&result, cr_split, "\n", TRUE, NULL, pool));
+  SVN_TEST_STRING_ASSERT(result, "a\nb\n");
+  SVN_ERR(translate_chunks(&result, lf_then_crlf, "\r\n", TRUE, NULL, pool));
+  SVN_TEST_STRING_ASSERT(result, "a\r\nb\r\nc\r\nd");
+  SVN_ERR(translate_chunks(&result, keyword, "\n", FALSE, keywords, pool));
+  SVN_TEST_STRING_ASSERT(result, "a\nb\n$Rev: 42 $\nc\n");
+
+  SVN_ERR(check_noop(TRUE, "a\nb\n", "\n", NULL, pool));
+  SVN_ERR(check_noop(TRUE, "a\nb\n", "\n", keywords, pool));
+  SVN_ERR(check_noop(TRUE, "a $Rev$\r\n", NULL, NULL, pool));
+  SVN_ERR(check_noop(TRUE, "no EOL", "\r\n", keywords, pool));
+  SVN_ERR(check_noop(FALSE, "a\nb\n", "\r\n", NULL, pool));
+  SVN_ERR(check_noop(FALSE, "a\r\nb\r\n", "\n", NULL, pool));
+  SVN_ERR(check_noop(FALSE, "a $Rev$\n", "\n", keywords, pool));
+  SVN_ERR(check_noop(FALSE, "a $Rev$", NULL, keywords, pool));
+
+  return SVN_NO_ERROR;
+}
+
 static int max_threads = 1;
 
 static struct svn_test_descriptor_t test_funcs[] =
@@ -519,6 +609,8 @@ static struct svn_test_descriptor_t test_funcs[] =
                    "test truncated keywords (issue 4349)"),
     SVN_TEST_PASS2(test_svn_subst_long_keywords,
                    "test long keywords (issue 4350)"),
+    SVN_TEST_PASS2(test_svn_subst_pass_through,
+                   "test translation of chunks that need none"),
     SVN_TEST_NULL
   };
 
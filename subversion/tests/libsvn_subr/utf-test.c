@@ -215,6 +215,89 @@ utf_validate2(apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+/* Append a random valid UTF-8 char to STR. */
+static void
+append_random_char(svn_stringbuf_t *str)
+{
+  apr_uint32_t cp;
+  char buf[4];
+
+  switch (range_rand(0, 4))
+    {
+      case 0:
+        svn_stringbuf_appendbyte(str, (char)range_rand(0, 0x7f));
+        return;
+
+      case 1:
+        cp = range_rand(0x80, 0x7ff);
+        buf[0] = (char)(0xc0 | (cp >> 6));
+        buf[1] = (char)(0x80 | (cp & 0x3f));
+        svn_stringbuf_appendbytes(str, buf, 2);
+        return;
+
+      case 2:
+        do
+          cp = range_rand(0x800, 0xffff);
+        while (cp >= 0xd800 && cp <= 0xdfff);
+
+        buf[0] = (char)(0xe0 | (cp >> 12));
+        buf[1] = (char)(0x80 | ((cp >> 6) & 0x3f));
+        buf[2] = (char)(0x80 | (cp & 0x3f));
+        svn_stringbuf_appendbytes(str, buf, 3);
+        return;
+
+      default:
+        cp = range_rand(0x10000, 0x10ffff);
+        buf[0] = (char)(0xf0 | (cp >> 18));
+        buf[1] = (char)(0x80 | ((cp >> 12) & 0x3f));
+        buf[2] = (char)(0x80 | ((cp >> 6) & 0x3f));
+        buf[3] = (char)(0x80 | (cp & 0x3f));
+        svn_stringbuf_appendbytes(str, buf, 4);
+        return;
+    }
+}
+
+/* Compare the two different implementations using long, mostly valid
+   strings such that the block-wise validation gets exercised. */
+static svn_error_t *
+utf_validate3(apr_pool_t *pool)
+{
+  svn_stringbuf_t *str = svn_stringbuf_create_empty(pool);
+  int i;
+
+  seed_val();
+
+  for (i = 0; i < 20000; ++i)
+    {
+      apr_size_t len = range_rand(0, 200);
+      int errors = range_rand(0, 3);
+      const char *last;
+
+      svn_stringbuf_setempty(str);
+      while (str->len < len)
+        append_random_char(str);
+
+      /* Damage the string in random places or cut it short. */
+      while (errors-- > 0 && str->len)
+        {
+          apr_size_t pos = range_rand(0, (apr_uint32_t)str->len - 1);
+          if (range_rand(0, 2) == 0)
+            str->data[pos] = (char)range_rand(0, 255);
+          else
+            svn_stringbuf_chop(str, str->len - pos);
+        }
+
+      last = svn_utf__last_valid2(str->data, str->len);
+      if (svn_utf__last_valid(str->data, str->len) != last
+          || svn_utf__is_valid(str->data, str->len)
+               != (last == str->data + str->len))
+        return svn_error_createf
+          (SVN_ERR_TEST_FAILED, NULL, "is_valid3 test %d failed", i);
+    }
+
+  return SVN_NO_ERROR;
+}
+
 /* Test conversion from different codepages to utf8. */
 static svn_error_t *
 test_utf_cstring_to_utf8_ex2(apr_pool_t *pool)
@@ -295,6 +378,57 @@ test_utf_cstring_from_utf8_ex2(apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+/* Test the ASCII detection and the conversion short-cut built on it. */
+static svn_error_t *
+test_utf_is_ascii(apr_pool_t *pool)
+{
+  char buffer[64];
+  apr_size_t len, pos;
+  const char *dest;
+
+  for (len = 0; len < sizeof(buffer); ++len)
+    {
+      memset(buffer, 'a', sizeof(buffer));
+      SVN_TEST_ASSERT(svn_utf__is_ascii(buffer, len));
+
+      /* Exactly one non-ASCII byte anywhere, with word-aligned or
+         unaligned start addresses. */
+      for (pos = 0; pos < len; ++pos)
+        {
+          buffer[pos] = '\x80';
+          SVN_TEST_ASSERT(!svn_utf__is_ascii(buffer, len));
+          SVN_TEST_ASSERT(pos == 0 || svn_utf__is_ascii(buffer, pos));
+          SVN_TEST_ASSERT(svn_utf__is_ascii(buffer + pos + 1,
+                                            len - pos - 1));
+          buffer[pos] = 0x7f;
+          SVN_TEST_ASSERT(svn_utf__is_ascii(buffer, len));
+        }
+    }
+
+  /* Mixing ASCII and non-ASCII strings on the same conversion map
+     must not mix up their results. */
+  for (pos = 0; pos < 3; ++pos)
+    {
+      SVN_ERR(svn_utf_cstring_from_utf8_ex2(&dest, "plain ascii",
+                                            "ISO-8859-1", pool));
+      SVN_TEST_STRING_ASSERT(dest, "plain ascii");
+      SVN_ERR(svn_utf_cstring_from_utf8_ex2(&dest, "Edelwei\xc3\x9f",
+                                            "ISO-8859-1", pool));
+      SVN_TEST_STRING_ASSERT(dest, "Edelwei\xdf");
+      SVN_ERR(svn_utf_cstring_to_utf8_ex2(&dest, "Edelwei\xdf",
+                                          "ISO-8859-1", pool));
+      SVN_TEST_STRING_ASSERT(dest, "Edelwei\xc3\x9f");
+    }
+
+  /* Control characters take the short-cut as well. */
+  SVN_ERR(svn_utf_cstring_to_utf8(&dest, "tab\there", pool));
+  SVN_TEST_STRING_ASSERT(dest, "tab\there");
+  SVN_ERR(svn_utf_cstring_from_utf8(&dest, "tab\there", pool));
+  SVN_TEST_STRING_ASSERT(dest, "tab\there");
+
+  return SVN_NO_ERROR;
+}
+
 /* Test normalization-independent UTF-8 string comparison */
 static svn_error_t *
 test_utf_collated_compare(apr_pool_t *pool)
@@ -1010,6 +1144,8 @@ static struct svn_test_descriptor_t test_funcs[] =
                    "test is_valid/last_valid"),
     SVN_TEST_PASS2(utf_validate2,
                    "test last_valid/last_valid2"),
+    SVN_TEST_PASS2(utf_validate3,
+                   "test last_valid/last_valid2 with long strings"),
     SVN_TEST_PASS2(test_utf_cstring_to_utf8_ex2,
                    "test svn_utf_cstring_to_utf8_ex2"),
     SVN_TEST_PASS2(test_utf_cstring_from_utf8_ex2,
@@ -1028,6 +1164,8 @@ static struct svn_test_descriptor_t test_funcs[] =
                    "test svn_utf__normalize"),
     SVN_TEST_PASS2(test_utf_xfrm,
                    "test svn_utf__xfrm"),
+    SVN_TEST_PASS2(test_utf_is_ascii,
+                   "test svn_utf__is_ascii"),
     SVN_TEST_NULL
   };
 
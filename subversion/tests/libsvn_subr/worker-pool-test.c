@@ -0,0 +1,483 @@
+/*
+ * worker-pool-test.c:  a collection of svn_worker_pool__* tests
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include <apr_pools.h>
+
+#include "svn_pools.h"
+#include "private/svn_worker_pool.h"
+
+#include "../svn_test.h"
+
+/* Baton for square_job(). */
+typedef struct square_baton_t
+{
+  int value;
+  int result;
+  svn_boolean_t fail;
+} square_baton_t;
+
+/* Implements svn_worker_pool__func_t. */
+static svn_error_t *
+square_job(void *baton,
+           apr_pool_t *scratch_pool)
+{
+  square_baton_t *sb = baton;
+
+  sb->result = sb->value * sb->value;
+  if (sb->fail)
+    return svn_error_create(SVN_ERR_TEST_FAILED, NULL, NULL);
+
+  return SVN_NO_ERROR;
+}
+
+/* Baton for blocking_job(). */
+typedef struct blocking_baton_t
+{
+  svn_worker_pool__t *workers;
+
+  /* Protected by the mutex of WORKERS. */
+  svn_boolean_t release;
+  svn_boolean_t started;
+} blocking_baton_t;
+
+/* Implements svn_worker_pool__func_t.  Block until released. */
+static svn_error_t *
+blocking_job(void *baton,
+             apr_pool_t *scratch_pool)
+{
+  blocking_baton_t *bb = baton;
+  svn_error_t *err = SVN_NO_ERROR;
+
+  SVN_ERR(svn_worker_pool__lock(bb->workers));
+  bb->started = TRUE;
+  err = svn_worker_pool__notify(bb->workers);
+
+  while (!err && !bb->release && !svn_worker_pool__stopping(bb->workers))
+    err = svn_worker_pool__wait_for_change(bb->workers);
+
+  return svn_error_trace(svn_worker_pool__unlock(bb->workers, err));
+}
+
+/* Wait until the blocking job BB is running. */
+static svn_error_t *
+wait_until_started(blocking_baton_t *bb)
+{
+  svn_error_t *err = SVN_NO_ERROR;
+
+  SVN_ERR(svn_worker_pool__lock(bb->workers));
+  while (!err && !bb->started)
+    err = svn_worker_pool__wait_for_change(bb->workers);
+
+  return svn_error_trace(svn_worker_pool__unlock(bb->workers, err));
+}
+
+/* Let the blocking job BB finish. */
+static svn_error_t *
+release(blocking_baton_t *bb)
+{
+  SVN_ERR(svn_worker_pool__lock(bb->workers));
+  bb->release = TRUE;
+
+  return svn_error_trace(svn_worker_pool__unlock(bb->workers,
+                           svn_worker_pool__notify(bb->workers)));
+}
+
+static svn_error_t *
+test_job_results(apr_pool_t *pool)
+{
+  enum { JOB_COUNT = 100 };
+  svn_worker_pool__t *workers;
+  svn_worker_pool__job_t *jobs[JOB_COUNT];
+  square_baton_t batons[JOB_COUNT];
+  int i;
+
+  SVN_ERR(svn_worker_pool__create(&workers, 4, pool));
+  SVN_TEST_ASSERT(workers);
+  SVN_TEST_ASSERT(svn_worker_pool__thread_count(workers) == 4);
+
+  for (i = 0; i < JOB_COUNT; ++i)
+    {
+      batons[i].value = i;
+      batons[i].result = -1;
+      batons[i].fail = (i % 10 == 3);
+      SVN_ERR(svn_worker_pool__post(&jobs[i], workers, square_job,
+                                    &batons[i], pool));
+    }
+
+  for (i = 0; i < JOB_COUNT; ++i)
+    {
+      svn_boolean_t done;
+      svn_error_t *err = svn_worker_pool__wait(jobs[i]);
+
+      if (batons[i].fail)
+        SVN_TEST_ASSERT_ERROR(err, SVN_ERR_TEST_FAILED);
+      else
+        SVN_ERR(err);
+
+      SVN_TEST_INT_ASSERT(batons[i].result, i * i);
+
+      /* The error is only reported once. */
+      SVN_ERR(svn_worker_pool__wait(jobs[i]));
+      SVN_ERR(svn_worker_pool__is_done(&done, jobs[i]));
+      SVN_TEST_ASSERT(done);
+    }
+
+  /* Nothing to run with. */
+  SVN_ERR(svn_worker_pool__create(&workers, 0, pool));
+  SVN_TEST_ASSERT(workers == NULL);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_cancel(apr_pool_t *pool)
+{
+  svn_worker_pool__t *workers;
+  svn_worker_pool__job_t *blocking, *pending;
+  blocking_baton_t bb = { 0 };
+  square_baton_t sb = { 2, -1, FALSE };
+  svn_boolean_t done, cancelled;
+
+  SVN_ERR(svn_worker_pool__create(&workers, 1, pool));
+  SVN_TEST_ASSERT(workers);
+
+  /* The only worker is busy, so the second job can't start. */
+  bb.workers = workers;
+  SVN_ERR(svn_worker_pool__post(&blocking, workers, blocking_job, &bb,
+                                pool));
+  SVN_ERR(svn_worker_pool__post(&pending, workers, square_job, &sb, pool));
+  SVN_ERR(wait_until_started(&bb));
+
+  SVN_ERR(svn_worker_pool__is_done(&done, pending));
+  SVN_TEST_ASSERT(!done);
+  SVN_ERR(svn_worker_pool__cancel(&cancelled, pending));
+  SVN_TEST_ASSERT(cancelled);
+
+  /* Running jobs can't be cancelled; we get their result instead. */
+  SVN_ERR(release(&bb));
+  SVN_ERR(svn_worker_pool__cancel(&cancelled, blocking));
+  SVN_TEST_ASSERT(!cancelled);
+
+  SVN_TEST_INT_ASSERT(sb.result, -1);
+
+  return SVN_NO_ERROR;
+}
+
+/* Number of count_job() runs, protected by the workers' mutex. */
+static int counter;
+
+/* Implements svn_worker_pool__func_t.  BATON is the svn_worker_pool__t
+   that runs the job. */
+static svn_error_t *
+count_job(void *baton,
+          apr_pool_t *scratch_pool)
+{
+  svn_worker_pool__t *workers = baton;
+
+  SVN_ERR(svn_worker_pool__lock(workers));
+  ++counter;
+
+  return svn_error_trace(svn_worker_pool__unlock(workers, SVN_NO_ERROR));
+}
+
+static svn_error_t *
+test_shared_state(apr_pool_t *pool)
+{
+  enum { JOB_COUNT = 50 };
+  svn_worker_pool__t *workers;
+  svn_error_t *err = SVN_NO_ERROR;
+  int i;
+
+  SVN_ERR(svn_worker_pool__create(&workers, 3, pool));
+  SVN_TEST_ASSERT(workers);
+
+  /* Nobody waits for these jobs; completing them signals the change. */
+  counter = 0;
+  for (i = 0; i < JOB_COUNT; ++i)
+    SVN_ERR(svn_worker_pool__post(NULL, workers, count_job, workers, pool));
+
+  SVN_ERR(svn_worker_pool__lock(workers));
+  while (!err && counter < JOB_COUNT)
+    err = svn_worker_pool__wait_for_change(workers);
+  SVN_ERR(svn_worker_pool__unlock(workers, err));
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_stop(apr_pool_t *pool)
+{
+  apr_pool_t *workers_pool = svn_pool_create(pool);
+  svn_worker_pool__t *workers;
+  svn_worker_pool__job_t *failed, *pending;
+  blocking_baton_t bb = { 0 };
+  square_baton_t failing = { 3, -1, TRUE };
+  square_baton_t sb = { 4, -1, FALSE };
+
+  SVN_ERR(svn_worker_pool__create(&workers, 1, workers_pool));
+  SVN_TEST_ASSERT(workers);
+
+  /* A failed job that nobody waits for, a running job that must give up
+     and a job that never gets started. */
+  bb.workers = workers;
+  SVN_ERR(svn_worker_pool__post(&failed, workers, square_job, &failing,
+                                workers_pool));
+  SVN_ERR(svn_worker_pool__post(NULL, workers, blocking_job, &bb,
+                                workers_pool));
+  SVN_ERR(svn_worker_pool__post(&pending, workers, square_job, &sb,
+                                workers_pool));
+  SVN_ERR(wait_until_started(&bb));
+
+  svn_pool_destroy(workers_pool);
+
+  SVN_TEST_INT_ASSERT(failing.result, 9);
+  SVN_TEST_INT_ASSERT(sb.result, -1);
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_worker_pool__open_func_t.  BATON is the offset to add
+   to the squares, unless it is negative. */
+static svn_error_t *
+open_offset(void **thread_baton,
+            void *baton,
+            apr_pool_t *thread_pool)
+{
+  const int *offset = baton;
+
+  if (*offset < 0)
+    return svn_error_create(SVN_ERR_TEST_FAILED, NULL, NULL);
+
+  *thread_baton = apr_pmemdup(thread_pool, offset, sizeof(*offset));
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_worker_pool__item_func_t.  ITEM is a square_baton_t,
+   THREAD_BATON the offset set by open_offset(). */
+static svn_error_t *
+square_item(void *item,
+            void *thread_baton,
+            apr_pool_t *scratch_pool)
+{
+  square_baton_t *sb = item;
+  const int *offset = thread_baton;
+
+  SVN_ERR(square_job(sb, scratch_pool));
+  sb->result += *offset;
+
+  return SVN_NO_ERROR;
+}
+
+/* Number of release_item() calls.  Only the adding thread releases
+   items. */
+static int released;
+
+/* Implements svn_worker_pool__release_func_t. */
+static void
+release_item(void *item)
+{
+  ++released;
+}
+
+static svn_error_t *
+test_ordered_results(apr_pool_t *pool)
+{
+  enum { ITEM_COUNT = 100, CAPACITY = 8 };
+  svn_worker_pool__ordered_t *queue;
+  square_baton_t batons[ITEM_COUNT];
+  int offset = 1;
+  int added, taken = 0;
+
+  SVN_ERR(svn_worker_pool__ordered_create(&queue, 4, CAPACITY, open_offset,
+                                          square_item, release_item,
+                                          &offset, pool));
+  SVN_TEST_ASSERT(queue);
+  SVN_TEST_ASSERT(svn_worker_pool__ordered_thread_count(queue) == 4);
+
+  released = 0;
+  for (added = 0; added < ITEM_COUNT || taken < ITEM_COUNT; )
+    {
+      void *item;
+      svn_error_t *item_err;
+
+      if (added < ITEM_COUNT)
+        {
+          batons[added].value = added;
+          batons[added].result = -1;
+          batons[added].fail = (added % 10 == 3);
+          SVN_ERR(svn_worker_pool__ordered_add(queue, &batons[added]));
+          added++;
+        }
+
+      /* Once everything has been added, wait for the rest. */
+      SVN_ERR(svn_worker_pool__ordered_take(&item, &item_err, queue,
+                                            added == ITEM_COUNT));
+      if (!item)
+        {
+          SVN_TEST_ASSERT(added - taken <= CAPACITY);
+          continue;
+        }
+
+      /* Items come back in order, each with its own error. */
+      SVN_TEST_ASSERT(item == &batons[taken]);
+      if (batons[taken].fail)
+        SVN_TEST_ASSERT_ERROR(item_err, SVN_ERR_TEST_FAILED);
+      else
+        SVN_ERR(item_err);
+
+      SVN_TEST_INT_ASSERT(batons[taken].result, taken * taken + 1);
+      taken++;
+    }
+
+  /* Nothing left to wait for. */
+  {
+    void *item;
+    svn_error_t *item_err;
+
+    SVN_ERR(svn_worker_pool__ordered_take(&item, &item_err, queue, TRUE));
+    SVN_TEST_ASSERT(item == NULL);
+  }
+
+  SVN_ERR(svn_worker_pool__ordered_destroy(queue, SVN_NO_ERROR));
+  SVN_TEST_INT_ASSERT(released, 0);
+
+  /* Nothing to run with. */
+  SVN_ERR(svn_worker_pool__ordered_create(&queue, 0, CAPACITY, NULL,
+                                          square_item, NULL, &offset, pool));
+  SVN_TEST_ASSERT(queue == NULL);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_ordered_open_failure(apr_pool_t *pool)
+{
+  enum { ITEM_COUNT = 10 };
+  svn_worker_pool__ordered_t *queue;
+  square_baton_t batons[ITEM_COUNT];
+  int offset = -1;
+  void *item;
+  svn_error_t *item_err;
+  int i;
+
+  SVN_ERR(svn_worker_pool__ordered_create(&queue, 2, ITEM_COUNT,
+                                          open_offset, square_item,
+                                          release_item, &offset, pool));
+  SVN_TEST_ASSERT(queue);
+
+  released = 0;
+  for (i = 0; i < ITEM_COUNT; ++i)
+    {
+      batons[i].value = i;
+      batons[i].result = -1;
+      batons[i].fail = FALSE;
+      SVN_ERR(svn_worker_pool__ordered_add(queue, &batons[i]));
+    }
+
+  /* No thread could process anything. */
+  SVN_TEST_ASSERT_ERROR(svn_worker_pool__ordered_take(&item, &item_err,
+                                                      queue, TRUE),
+                        SVN_ERR_TEST_FAILED);
+
+  /* The error has been reported already; the items get released. */
+  SVN_ERR(svn_worker_pool__ordered_destroy(queue, SVN_NO_ERROR));
+  SVN_TEST_INT_ASSERT(released, ITEM_COUNT);
+
+  for (i = 0; i < ITEM_COUNT; ++i)
+    SVN_TEST_INT_ASSERT(batons[i].result, -1);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_ordered_cleanup(apr_pool_t *pool)
+{
+  enum { ITEM_COUNT = 50 };
+  apr_pool_t *queue_pool = svn_pool_create(pool);
+  svn_worker_pool__ordered_t *queue;
+  square_baton_t batons[ITEM_COUNT];
+  int offset = 0;
+  void *item;
+  svn_error_t *item_err;
+  int i;
+
+  SVN_ERR(svn_worker_pool__ordered_create(&queue, 3, ITEM_COUNT,
+                                          open_offset, square_item,
+                                          release_item, &offset,
+                                          queue_pool));
+  SVN_TEST_ASSERT(queue);
+
+  released = 0;
+  for (i = 0; i < ITEM_COUNT; ++i)
+    {
+      batons[i].value = i;
+      batons[i].result = -1;
+      batons[i].fail = TRUE;
+      SVN_ERR(svn_worker_pool__ordered_add(queue, &batons[i]));
+    }
+
+  SVN_ERR(svn_worker_pool__ordered_take(&item, &item_err, queue, TRUE));
+  SVN_TEST_ASSERT(item == &batons[0]);
+  SVN_TEST_ASSERT_ERROR(item_err, SVN_ERR_TEST_FAILED);
+
+  /* Whether processed or not, every item that has not been taken gets
+     released exactly once, along with its error. */
+  svn_pool_destroy(queue_pool);
+  SVN_TEST_INT_ASSERT(released, ITEM_COUNT - 1);
+
+  return SVN_NO_ERROR;
+}
+
+
+/* The test table.  */
+
+static int max_threads = 1;
+
+static struct svn_test_descriptor_t test_funcs[] =
+  {
+    SVN_TEST_NULL,
+    SVN_TEST_SKIP2(test_job_results,
+                   ! APR_HAS_THREADS,
+                   "test job results and errors"),
+    SVN_TEST_SKIP2(test_cancel,
+                   ! APR_HAS_THREADS,
+                   "test cancelling jobs"),
+    SVN_TEST_SKIP2(test_shared_state,
+                   ! APR_HAS_THREADS,
+                   "test sharing state with jobs"),
+    SVN_TEST_SKIP2(test_stop,
+                   ! APR_HAS_THREADS,
+                   "test stopping a worker pool"),
+    SVN_TEST_SKIP2(test_ordered_results,
+                   ! APR_HAS_THREADS,
+                   "test the order of ordered queue results"),
+    SVN_TEST_SKIP2(test_ordered_open_failure,
+                   ! APR_HAS_THREADS,
+                   "test ordered queue thread setup failures"),
+    SVN_TEST_SKIP2(test_ordered_cleanup,
+                   ! APR_HAS_THREADS,
+                   "test releasing ordered queue items"),
+    SVN_TEST_NULL
+  };
+
+SVN_TEST_MAIN
@@ -35,6 +35,7 @@
 #include "svn_io.h"
 
 #include "svn_dirent_uri.h"
+#include "svn_hash.h"
 #include "svn_pools.h"
 
 #include "private/svn_sqlite.h"
@@ -772,6 +773,121 @@ test_children(apr_pool_t *pool)
 }
 
 
+/* Verify that the information in DIRS, as returned by
+   svn_wc__db_read_subtree_info() for ROOT_ABSPATH, matches that of
+   svn_wc__db_read_children_info() for DIR_ABSPATH and all directories
+   below it.  Increment *DIRS_SEEN for each directory with children. */
+static svn_error_t *
+verify_subtree_info(int *dirs_seen,
+                    apr_hash_t *dirs,
+                    svn_wc__db_t *db,
+                    const char *root_abspath,
+                    const char *dir_abspath,
+                    apr_pool_t *pool)
+{
+  apr_hash_t *nodes, *conflicts;
+  svn_wc__db_children_info_t *dir;
+  apr_hash_index_t *hi;
+
+  SVN_ERR(svn_wc__db_read_children_info(&nodes, &conflicts, db, dir_abspath,
+                                        FALSE, pool, pool));
+  dir = svn_hash_gets(dirs, svn_dirent_skip_ancestor(root_abspath,
+                                                     dir_abspath));
+  if (!apr_hash_count(nodes) && !apr_hash_count(conflicts))
+    {
+      SVN_TEST_ASSERT(dir == NULL);
+      return SVN_NO_ERROR;
+    }
+
+  SVN_TEST_ASSERT(dir != NULL);
+  SVN_TEST_INT_ASSERT(apr_hash_count(dir->nodes), apr_hash_count(nodes));
+  SVN_TEST_INT_ASSERT(apr_hash_count(dir->conflicts),
+                      apr_hash_count(conflicts));
+  (*dirs_seen)++;
+
+  for (hi = apr_hash_first(pool, nodes); hi; hi = apr_hash_next(hi))
+    {
+      const char *name = apr_hash_this_key(hi);
+      const struct svn_wc__db_info_t *info = apr_hash_this_val(hi);
+      const struct svn_wc__db_info_t *prefetched;
+
+      prefetched = svn_hash_gets(dir->nodes, name);
+      SVN_TEST_ASSERT(prefetched != NULL);
+      SVN_TEST_ASSERT(prefetched->status == info->status);
+      SVN_TEST_ASSERT(prefetched->kind == info->kind);
+      SVN_TEST_ASSERT(prefetched->revnum == info->revnum);
+      SVN_TEST_STRING_ASSERT(prefetched->repos_relpath, info->repos_relpath);
+      SVN_TEST_ASSERT(prefetched->op_root == info->op_root);
+      SVN_TEST_ASSERT(prefetched->have_base == info->have_base);
+      SVN_TEST_ASSERT(prefetched->have_more_work == info->have_more_work);
+      SVN_TEST_ASSERT(prefetched->conflicted == info->conflicted);
+
+      if (info->kind == svn_node_dir)
+        SVN_ERR(verify_subtree_info(dirs_seen, dirs, db, root_abspath,
+                                    svn_dirent_join(dir_abspath, name, pool),
+                                    pool));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_subtree_info(apr_pool_t *pool)
+{
+  const char *local_abspath;
+  svn_wc__db_t *db;
+  apr_hash_t *dirs;
+  apr_hash_index_t *hi;
+  int dirs_seen = 0;
+
+  SVN_ERR(create_open(&db, &local_abspath, "test_subtree_info", pool));
+
+  SVN_ERR(svn_wc__db_read_subtree_info(&dirs, db, local_abspath, FALSE,
+                                       100000, pool, pool));
+  SVN_TEST_ASSERT(dirs != NULL);
+  SVN_ERR(verify_subtree_info(&dirs_seen, dirs, db, local_abspath,
+                              local_abspath, pool));
+  SVN_TEST_ASSERT(dirs_seen > 1);
+
+  /* Directories only reachable through lower layers are included too. */
+  for (hi = apr_hash_first(pool, dirs); hi; hi = apr_hash_next(hi))
+    {
+      const char *relpath = apr_hash_this_key(hi);
+      svn_wc__db_children_info_t *dir = apr_hash_this_val(hi);
+      apr_hash_t *nodes, *conflicts;
+
+      SVN_ERR(svn_wc__db_read_children_info(&nodes, &conflicts, db,
+                                            svn_dirent_join(local_abspath,
+                                                            relpath, pool),
+                                            FALSE, pool, pool));
+      SVN_TEST_INT_ASSERT(apr_hash_count(dir->nodes),
+                          apr_hash_count(nodes));
+      SVN_TEST_INT_ASSERT(apr_hash_count(dir->conflicts),
+                          apr_hash_count(conflicts));
+    }
+
+  /* Below the root */
+  dirs_seen = 0;
+  SVN_ERR(svn_wc__db_read_subtree_info(&dirs, db,
+                                       svn_dirent_join(local_abspath, "J",
+                                                       pool),
+                                       FALSE, 100000, pool, pool));
+  SVN_TEST_ASSERT(dirs != NULL);
+  SVN_ERR(verify_subtree_info(&dirs_seen, dirs, db,
+                              svn_dirent_join(local_abspath, "J", pool),
+                              svn_dirent_join(local_abspath, "J", pool),
+                              pool));
+  SVN_TEST_ASSERT(dirs_seen > 1);
+
+  /* Too large a tree */
+  SVN_ERR(svn_wc__db_read_subtree_info(&dirs, db, local_abspath, FALSE,
+                                       3, pool, pool));
+  SVN_TEST_ASSERT(dirs == NULL);
+
+  return SVN_NO_ERROR;
+}
+
+
 static svn_error_t *
 test_working_info(apr_pool_t *pool)
 {
@@ -1536,6 +1652,8 @@ static struct svn_test_descriptor_t test_funcs[] =
                    "insert different nodes into wc.db"),
     SVN_TEST_PASS2(test_children,
                    "getting the list of BASE or WORKING children"),
+    SVN_TEST_PASS2(test_subtree_info,
+                   "reading the information of a whole subtree"),
     SVN_TEST_PASS2(test_working_info,
                    "reading information about the WORKING tree"),
     SVN_TEST_PASS2(test_pdh,
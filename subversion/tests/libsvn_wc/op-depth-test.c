@@ -1826,6 +1826,58 @@ test_wc_move(const svn_test_opts_t *opts, apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+/* Moves of unmodified trees are recorded with a few set-based statements
+   instead of node by node.  Check that the result is the same. */
+static svn_error_t *
+test_wc_move_tree(const svn_test_opts_t *opts, apr_pool_t *pool)
+{
+  svn_test__sandbox_t b;
+  const svn_string_t *value;
+
+  SVN_ERR(svn_test__sandbox_create(&b, "wc_move_tree", opts, pool));
+  SVN_ERR(sbox_wc_mkdir(&b, "A"));
+  SVN_ERR(sbox_wc_mkdir(&b, "A/B"));
+  SVN_ERR(sbox_wc_mkdir(&b, "A/B/C"));
+  SVN_ERR(sbox_file_write(&b, "A/f", "f\n"));
+  SVN_ERR(sbox_wc_add(&b, "A/f"));
+  SVN_ERR(sbox_file_write(&b, "A/B/g", "g\n"));
+  SVN_ERR(sbox_wc_add(&b, "A/B/g"));
+  SVN_ERR(sbox_wc_commit(&b, ""));
+  SVN_ERR(sbox_wc_update(&b, "", 1));
+  SVN_ERR(sbox_wc_propset(&b, "p", "v", "A/B/g"));
+
+  SVN_ERR(sbox_wc_move(&b, "A", "X"));
+  {
+    nodes_row_t rows[] = {
+      { 0, "",        "normal",       1, "" },
+      { 0, "A",       "normal",       1, "A" },
+      { 0, "A/B",     "normal",       1, "A/B" },
+      { 0, "A/B/C",   "normal",       1, "A/B/C" },
+      { 0, "A/B/g",   "normal",       1, "A/B/g" },
+      { 0, "A/f",     "normal",       1, "A/f" },
+      { 1, "A",       "base-deleted", NO_COPY_FROM, "X" },
+      { 1, "A/B",     "base-deleted", NO_COPY_FROM },
+      { 1, "A/B/C",   "base-deleted", NO_COPY_FROM },
+      { 1, "A/B/g",   "base-deleted", NO_COPY_FROM },
+      { 1, "A/f",     "base-deleted", NO_COPY_FROM },
+      { 1, "X",       "normal",       1, "A", MOVED_HERE },
+      { 1, "X/B",     "normal",       1, "A/B", MOVED_HERE },
+      { 1, "X/B/C",   "normal",       1, "A/B/C", MOVED_HERE },
+      { 1, "X/B/g",   "normal",       1, "A/B/g", MOVED_HERE },
+      { 1, "X/f",     "normal",       1, "A/f", MOVED_HERE },
+      { 0 }
+    };
+    SVN_ERR(check_db_rows(&b, "", rows));
+  }
+
+  /* The local property change moved along. */
+  SVN_ERR(svn_wc_prop_get2(&value, b.wc_ctx, sbox_wc_path(&b, "X/B/g"),
+                           "p", pool, pool));
+  SVN_TEST_ASSERT(value && !strcmp(value->data, "v"));
+
+  return SVN_NO_ERROR;
+}
+
 static svn_error_t *
 test_mixed_rev_copy(const svn_test_opts_t *opts, apr_pool_t *pool)
 {
@@ -11913,6 +11965,8 @@ static struct svn_test_descriptor_t test_funcs[] =
                        "test_db_make_copy"),
     SVN_TEST_OPTS_PASS(test_wc_move,
                        "test_wc_move"),
+    SVN_TEST_OPTS_PASS(test_wc_move_tree,
+                       "test_wc_move_tree"),
     SVN_TEST_OPTS_PASS(test_mixed_rev_copy,
                         "test_mixed_rev_copy"),
     SVN_TEST_OPTS_PASS(test_delete_of_replace,
@@ -34,6 +34,7 @@
 #define SVN_DEPRECATED
 #include "svn_io.h"
 
+#include "svn_config.h"
 #include "svn_dirent_uri.h"
 #include "svn_pools.h"
 #include "svn_repos.h"
@@ -233,6 +234,215 @@ pristine_delete_while_open(const svn_test_opts_t *opts,
   return SVN_NO_ERROR;
 }
 
+/* Install DATA into the pristine store of the WC at WC_ABSPATH in DB and
+ * return its SHA-1 checksum in *DATA_SHA1. */
+static svn_error_t *
+install_text(svn_checksum_t **data_sha1,
+             svn_wc__db_t *db,
+             const char *wc_abspath,
+             const char *data,
+             apr_pool_t *pool)
+{
+  svn_wc__db_install_data_t *install_data;
+  svn_stream_t *pristine_stream;
+  svn_checksum_t *data_md5;
+  apr_size_t sz = strlen(data);
+
+  SVN_ERR(svn_wc__db_pristine_prepare_install(&pristine_stream,
+                                              &install_data,
+                                              data_sha1, &data_md5,
+                                              db, wc_abspath,
+                                              pool, pool));
+  SVN_ERR(svn_stream_write(pristine_stream, data, &sz));
+  SVN_ERR(svn_stream_close(pristine_stream));
+
+  return svn_error_trace(svn_wc__db_pristine_install(install_data,
+                                                     *data_sha1, data_md5,
+                                                     pool));
+}
+
+/* Test that texts get shared between working copies through the
+ * machine-wide pristine store and removed once no WC needs them. */
+static svn_error_t *
+shared_pristine_store(const svn_test_opts_t *opts,
+                      apr_pool_t *pool)
+{
+  svn_wc__db_t *db, *ignored_db;
+  const char *wc1_abspath, *wc2_abspath;
+  const char *shared_abspath;
+  svn_config_t *config;
+  svn_checksum_t *data_sha1;
+  svn_stream_t *contents;
+
+  const char data[] = "Blah";
+  svn_string_t *data_string = svn_string_create(data, pool);
+
+  SVN_ERR(create_repos_and_wc(&wc1_abspath, &ignored_db,
+                              "shared_pristine_store_1", opts, pool));
+  SVN_ERR(create_repos_and_wc(&wc2_abspath, &ignored_db,
+                              "shared_pristine_store_2", opts, pool));
+
+  SVN_ERR(svn_dirent_get_absolute(&shared_abspath,
+                                  svn_test_data_path("shared_pristine_store",
+                                                     pool),
+                                  pool));
+  SVN_ERR(svn_io_remove_dir2(shared_abspath, TRUE, NULL, NULL, pool));
+  SVN_ERR(svn_io_make_dir_recursively(shared_abspath, pool));
+  svn_test_add_dir_cleanup(shared_abspath);
+
+  SVN_ERR(svn_config_create2(&config, FALSE, FALSE, pool));
+  svn_config_set(config, SVN_CONFIG_SECTION_WORKING_COPY,
+                 SVN_CONFIG_OPTION_SHARED_PRISTINE_DIR, shared_abspath);
+  SVN_ERR(svn_wc__db_open(&db, config, FALSE, TRUE, pool, pool));
+
+  /* Installing into the first WC makes the text available to everyone. */
+  SVN_ERR(install_text(&data_sha1, db, wc1_abspath, data, pool));
+  SVN_ERR(svn_wc__db_pristine_read_shared(&contents, db, data_sha1,
+                                          pool, pool));
+  SVN_TEST_ASSERT(contents != NULL);
+  {
+    svn_boolean_t same;
+
+    SVN_ERR(svn_stream_contents_same2(&same, contents,
+                                      svn_stream_from_string(data_string,
+                                                             pool),
+                                      pool));
+    SVN_TEST_ASSERT(same);
+  }
+
+  /* The text must survive as long as any WC still references it. */
+  SVN_ERR(install_text(&data_sha1, db, wc2_abspath, data, pool));
+  SVN_ERR(svn_wc__db_pristine_remove(db, wc1_abspath, data_sha1, pool));
+  SVN_ERR(svn_wc__db_pristine_read_shared(&contents, db, data_sha1,
+                                          pool, pool));
+  SVN_TEST_ASSERT(contents != NULL);
+  SVN_ERR(svn_stream_close(contents));
+
+  SVN_ERR(svn_wc__db_pristine_remove(db, wc2_abspath, data_sha1, pool));
+  SVN_ERR(svn_wc__db_pristine_read_shared(&contents, db, data_sha1,
+                                          pool, pool));
+  SVN_TEST_ASSERT(contents == NULL);
+
+  return svn_error_trace(svn_wc__db_close(db));
+}
+
+/* Baton for fake_fetch_pristine(). */
+typedef struct fake_fetch_baton_t
+{
+  const char *repos_url;
+  const char *data;
+  int calls;
+} fake_fetch_baton_t;
+
+/* Implements svn_wc__pristine_fetch_func_t, serving the text of "A" in
+ * r1 without contacting the repository. */
+static svn_error_t *
+fake_fetch_pristine(void *baton,
+                    svn_stream_t *contents,
+                    const char *repos_root_url,
+                    const char *repos_relpath,
+                    svn_revnum_t revision,
+                    apr_pool_t *scratch_pool)
+{
+  fake_fetch_baton_t *ffb = baton;
+  apr_size_t len = strlen(ffb->data);
+
+  SVN_TEST_STRING_ASSERT(repos_root_url, ffb->repos_url);
+  SVN_TEST_STRING_ASSERT(repos_relpath, "A");
+  SVN_TEST_ASSERT(revision == 1);
+
+  ffb->calls++;
+  return svn_error_trace(svn_stream_write(contents, ffb->data, &len));
+}
+
+/* Test that a working copy without stored pristines evicts texts from its
+ * pristine cache and fetches them again when they are read. */
+static svn_error_t *
+pristine_fetch_on_demand(const svn_test_opts_t *opts,
+                         apr_pool_t *pool)
+{
+  svn_test__sandbox_t b;
+  svn_wc__db_t *db;
+  svn_config_t *config;
+  svn_checksum_t *data_sha1;
+  svn_stream_t *contents;
+  svn_boolean_t store_pristine;
+  svn_boolean_t present;
+  int format;
+  fake_fetch_baton_t ffb;
+
+  const char data[] = "Blah\n";
+  svn_string_t *data_string = svn_string_create(data, pool);
+
+  SVN_ERR(svn_test__sandbox_create(&b, "pristine_fetch_on_demand", opts,
+                                   pool));
+  SVN_ERR(sbox_file_write(&b, "A", data));
+  SVN_ERR(sbox_wc_add(&b, "A"));
+  SVN_ERR(sbox_wc_commit(&b, ""));
+  SVN_ERR(svn_checksum(&data_sha1, svn_checksum_sha1, data, strlen(data),
+                       pool));
+
+  /* A cache size of zero makes every trim evict everything. */
+  SVN_ERR(svn_config_create2(&config, FALSE, FALSE, pool));
+  svn_config_set(config, SVN_CONFIG_SECTION_WORKING_COPY,
+                 SVN_CONFIG_OPTION_PRISTINE_CACHE_SIZE, "0");
+  SVN_ERR(svn_wc__db_open(&db, config, FALSE, TRUE, pool, pool));
+
+  SVN_ERR(svn_wc__db_get_store_pristine(&store_pristine, db, b.wc_abspath,
+                                        pool));
+  SVN_TEST_ASSERT(store_pristine);
+  SVN_ERR(svn_wc__db_set_store_pristine(db, b.wc_abspath, FALSE, pool));
+
+  SVN_ERR(svn_wc__db_pristine_trim(db, b.wc_abspath, pool));
+  SVN_ERR(svn_wc__db_pristine_check(&present, db, b.wc_abspath, data_sha1,
+                                    pool));
+  SVN_TEST_ASSERT(! present);
+
+  /* Without a way to fetch it, the text is gone. */
+  SVN_TEST_ASSERT_ERROR(svn_wc__db_pristine_read(&contents, NULL, db,
+                                                 b.wc_abspath, data_sha1,
+                                                 pool, pool),
+                        SVN_ERR_WC_PRISTINE_NOT_STORED);
+
+  ffb.repos_url = b.repos_url;
+  ffb.data = data;
+  ffb.calls = 0;
+  svn_wc__db_set_pristine_fetch(db, fake_fetch_pristine, &ffb);
+
+  SVN_ERR(svn_wc__db_pristine_read(&contents, NULL, db, b.wc_abspath,
+                                   data_sha1, pool, pool));
+  {
+    svn_boolean_t same;
+
+    SVN_ERR(svn_stream_contents_same2(&same, contents,
+                                      svn_stream_from_string(data_string,
+                                                             pool),
+                                      pool));
+    SVN_TEST_ASSERT(same);
+  }
+  SVN_TEST_ASSERT(ffb.calls == 1);
+
+  /* The text stays cached until the next trim. */
+  SVN_ERR(svn_wc__db_pristine_hydrate(db, b.wc_abspath, data_sha1, pool));
+  SVN_TEST_ASSERT(ffb.calls == 1);
+
+  /* The mode is a property of the working copy, not of the DB handle. */
+  SVN_ERR(svn_wc__db_close(db));
+  SVN_ERR(svn_wc__db_open(&db, NULL, FALSE, TRUE, pool, pool));
+  SVN_ERR(svn_wc__db_get_store_pristine(&store_pristine, db, b.wc_abspath,
+                                        pool));
+  SVN_TEST_ASSERT(! store_pristine);
+  SVN_TEST_ASSERT_ERROR(svn_wc__db_set_store_pristine(db, b.wc_abspath,
+                                                      TRUE, pool),
+                        SVN_ERR_UNSUPPORTED_FEATURE);
+
+  /* Older clients must refuse such a working copy. */
+  SVN_ERR(svn_wc__db_temp_get_format(&format, db, b.wc_abspath, pool));
+  SVN_TEST_ASSERT(format == SVN_WC__STORE_PRISTINE_VERSION);
+
+  return svn_error_trace(svn_wc__db_close(db));
+}
+
 /* Check that the store rejects an attempt to replace an existing pristine
  * text with different text.
  *
@@ -306,6 +516,60 @@ reject_mismatching_text(const svn_test_opts_t *opts,
 #endif
 }
 
+/* Test that cleanup removes many unreferenced texts at once, which makes
+ * it use several threads for deleting the files. */
+static svn_error_t *
+pristine_cleanup_many(const svn_test_opts_t *opts,
+                      apr_pool_t *pool)
+{
+  svn_wc__db_t *db;
+  const char *wc_abspath;
+  apr_array_header_t *checksums;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  int i;
+
+  SVN_ERR(create_repos_and_wc(&wc_abspath, &db,
+                              "pristine_cleanup_many", opts, pool));
+
+  checksums = apr_array_make(pool, 1000, sizeof(svn_checksum_t *));
+  for (i = 0; i < 1000; i++)
+    {
+      svn_checksum_t *data_sha1;
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(install_text(&data_sha1, db, wc_abspath,
+                           apr_psprintf(iterpool, "text %d", i), pool));
+      APR_ARRAY_PUSH(checksums, svn_checksum_t *) = data_sha1;
+    }
+
+  SVN_ERR(svn_wc__db_pristine_cleanup(db, wc_abspath, pool));
+
+  for (i = 0; i < checksums->nelts; i++)
+    {
+      svn_boolean_t present;
+      const char *pristine_abspath;
+      svn_node_kind_t kind;
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_wc__db_pristine_check(&present, db, wc_abspath,
+                                        APR_ARRAY_IDX(checksums, i,
+                                                      svn_checksum_t *),
+                                        iterpool));
+      SVN_TEST_ASSERT(!present);
+
+      SVN_ERR(svn_wc__db_pristine_get_future_path(
+                &pristine_abspath, wc_abspath,
+                APR_ARRAY_IDX(checksums, i, svn_checksum_t *),
+                iterpool, iterpool));
+      SVN_ERR(svn_io_check_path(pristine_abspath, &kind, iterpool));
+      SVN_TEST_ASSERT(kind == svn_node_none);
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
 
 static int max_threads = -1;
 
@@ -318,6 +582,12 @@ static struct svn_test_descriptor_t test_funcs[] =
                        "pristine_delete_while_open"),
     SVN_TEST_OPTS_PASS(reject_mismatching_text,
                        "reject_mismatching_text"),
+    SVN_TEST_OPTS_PASS(shared_pristine_store,
+                       "machine-wide shared pristine store"),
+    SVN_TEST_OPTS_PASS(pristine_fetch_on_demand,
+                       "fetch pristines not stored locally"),
+    SVN_TEST_OPTS_PASS(pristine_cleanup_many,
+                       "remove many unreferenced pristines at once"),
     SVN_TEST_NULL
   };
 
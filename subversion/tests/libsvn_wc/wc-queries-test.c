@@ -70,7 +70,9 @@ static const int schema_statements[] =
 {
   /* Usual tables */
   STMT_CREATE_SCHEMA,
+  STMT_CREATE_CHILDREN_INFO_INDEXES,
   STMT_INSTALL_SCHEMA_STATISTICS,
+  STMT_CREATE_SETTINGS,
   /* Memory tables */
   STMT_CREATE_TARGETS_LIST,
   STMT_CREATE_CHANGELIST_LIST,
@@ -108,6 +110,10 @@ static const int slow_statements[] =
    * STMT_DELETE_PRISTINE_IF_UNREFERENCED,
    */
   STMT_HAVE_STAT1_TABLE, /* Queries sqlite_master which has no index */
+  STMT_HAVE_SETTINGS_TABLE, /* Queries sqlite_master which has no index */
+
+  /* Only used when fetching a pristine that is not stored locally */
+  STMT_SELECT_PRISTINE_LOCATION,
 
   -1 /* final marker */
 };
@@ -993,6 +999,80 @@ test_schema_statistics(apr_pool_t *scratch_pool)
   return SVN_NO_ERROR;
 }
 
+/* Verify that the directory children queries are answered from their
+   covering indexes alone. */
+static svn_error_t *
+test_children_info_covered(apr_pool_t *scratch_pool)
+{
+  static const struct
+    {
+      int stmt_idx;
+      const char *index;
+    } expectations[] =
+    {
+      { STMT_SELECT_NODE_CHILDREN_INFO, "I_NODES_CHILDREN_INFO" },
+      { STMT_SELECT_BASE_NODE_CHILDREN_INFO, "I_NODES_CHILDREN_INFO" },
+      { STMT_SELECT_ACTUAL_CHILDREN_INFO, "I_ACTUAL_CHILDREN_INFO" },
+    };
+  sqlite3 *sdb;
+  svn_boolean_t supports_query_info;
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  int i;
+
+  SVN_ERR(create_memory_db(&sdb, scratch_pool));
+
+  SVN_ERR(supported_explain_query_plan(&supports_query_info, sdb,
+                                       scratch_pool));
+  if (!supports_query_info)
+    {
+      SQLITE_ERR(sqlite3_close(sdb));
+      return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                              "Sqlite doesn't support EXPLAIN QUERY PLAN");
+    }
+
+  for (i = 0; i < sizeof(expectations) / sizeof(expectations[0]); i++)
+    {
+      sqlite3_stmt *stmt;
+      const char *needle;
+      svn_boolean_t covered = FALSE;
+
+      svn_pool_clear(iterpool);
+
+      SQLITE_ERR(sqlite3_prepare_v2(sdb,
+                                    apr_pstrcat(iterpool,
+                                                "EXPLAIN QUERY PLAN ",
+                                                wc_queries[expectations[i]
+                                                             .stmt_idx],
+                                                SVN_VA_NULL),
+                                    -1, &stmt, NULL));
+
+      /* The wording of the explanation differs between Sqlite versions
+         but always contains this. */
+      needle = apr_pstrcat(iterpool, "USING COVERING INDEX ",
+                           expectations[i].index, SVN_VA_NULL);
+      while (sqlite3_step(stmt) == SQLITE_ROW)
+        {
+          const char *detail = (const char *)sqlite3_column_text(stmt, 3);
+
+          if (detail && strstr(detail, needle))
+            covered = TRUE;
+        }
+
+      SQLITE_ERR(sqlite3_finalize(stmt));
+
+      if (!covered)
+        return svn_error_createf(SVN_ERR_TEST_FAILED, NULL,
+                                 "%s: Not covered by %s",
+                                 wc_query_info[expectations[i].stmt_idx][0],
+                                 expectations[i].index);
+    }
+
+  svn_pool_destroy(iterpool);
+  SQLITE_ERR(sqlite3_close(sdb));
+
+  return SVN_NO_ERROR;
+}
+
 /* An SQLite application defined function that allows SQL queries to
    use "relpath_depth(local_relpath)".  */
 static void relpath_depth_sqlite(sqlite3_context* context,
@@ -1061,6 +1141,8 @@ static struct svn_test_descriptor_t test_funcs[] =
                    "test query duplicates"),
     SVN_TEST_PASS2(test_schema_statistics,
                    "test schema statistics"),
+    SVN_TEST_PASS2(test_children_info_covered,
+                   "children info queries use covering indexes"),
     SVN_TEST_PASS2(test_verify_parsable,
                    "verify queries are parsable"),
     SVN_TEST_NULL
@@ -35,6 +35,7 @@
 #include "svn_wc.h"
 #include "svn_client.h"
 #include "svn_hash.h"
+#include "svn_props.h"
 
 #include "utils.h"
 
@@ -493,6 +494,159 @@ test_internal_file_modified(const svn_test_opts_t *opts, apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+static svn_error_t *
+test_prop_delete_many(const svn_test_opts_t *opts, apr_pool_t *pool)
+{
+  svn_test__sandbox_t b;
+  apr_array_header_t *targets;
+  const svn_string_t *value;
+
+  SVN_ERR(svn_test__sandbox_create(&b, "prop_delete_many", opts, pool));
+  SVN_ERR(sbox_add_and_commit_greek_tree(&b));
+
+  SVN_ERR(sbox_wc_propset(&b, SVN_PROP_MERGEINFO, "/X:1", "A"));
+  SVN_ERR(sbox_wc_propset(&b, SVN_PROP_MERGEINFO, "/X/B:1", "A/B"));
+  SVN_ERR(sbox_wc_propset(&b, "p", "v", "A/B"));
+  SVN_ERR(sbox_wc_propset(&b, SVN_PROP_MERGEINFO, "/X/D/G:1", "A/D/G"));
+  SVN_ERR(sbox_wc_propset(&b, SVN_PROP_MERGEINFO, "/X/mu:1", "A/mu"));
+  SVN_ERR(sbox_wc_commit(&b, "A/mu"));
+
+  /* Deleting a property that is not there is a no-op. */
+  targets = apr_array_make(pool, 4, sizeof(const char *));
+  APR_ARRAY_PUSH(targets, const char *) = sbox_wc_path(&b, "A/B");
+  APR_ARRAY_PUSH(targets, const char *) = sbox_wc_path(&b, "A/D/G");
+  APR_ARRAY_PUSH(targets, const char *) = sbox_wc_path(&b, "A/mu");
+  APR_ARRAY_PUSH(targets, const char *) = sbox_wc_path(&b, "iota");
+
+  SVN_WC__CALL_WITH_WRITE_LOCK(
+    svn_wc__prop_delete_many(b.wc_ctx, targets, SVN_PROP_MERGEINFO, pool),
+    b.wc_ctx, b.wc_abspath, FALSE, pool);
+
+  SVN_ERR(svn_wc_prop_get2(&value, b.wc_ctx, sbox_wc_path(&b, "A"),
+                           SVN_PROP_MERGEINFO, pool, pool));
+  SVN_TEST_STRING_ASSERT(value ? value->data : NULL, "/X:1");
+  SVN_ERR(svn_wc_prop_get2(&value, b.wc_ctx, sbox_wc_path(&b, "A/B"),
+                           SVN_PROP_MERGEINFO, pool, pool));
+  SVN_TEST_ASSERT(value == NULL);
+  SVN_ERR(svn_wc_prop_get2(&value, b.wc_ctx, sbox_wc_path(&b, "A/B"),
+                           "p", pool, pool));
+  SVN_TEST_STRING_ASSERT(value ? value->data : NULL, "v");
+  SVN_ERR(svn_wc_prop_get2(&value, b.wc_ctx, sbox_wc_path(&b, "A/D/G"),
+                           SVN_PROP_MERGEINFO, pool, pool));
+  SVN_TEST_ASSERT(value == NULL);
+
+  /* A committed property gets deleted locally. */
+  SVN_ERR(svn_wc_prop_get2(&value, b.wc_ctx, sbox_wc_path(&b, "A/mu"),
+                           SVN_PROP_MERGEINFO, pool, pool));
+  SVN_TEST_ASSERT(value == NULL);
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_wc_status_func4_t.  Add LOCAL_ABSPATH to the hash in
+   BATON, mapping it to a copy of its node status. */
+static svn_error_t *
+collect_node_status(void *baton,
+                    const char *local_abspath,
+                    const svn_wc_status3_t *status,
+                    apr_pool_t *scratch_pool)
+{
+  apr_hash_t *statuses = baton;
+  apr_pool_t *pool = apr_hash_pool_get(statuses);
+
+  svn_hash_sets(statuses, apr_pstrdup(pool, local_abspath),
+                apr_pmemdup(pool, &status->node_status,
+                            sizeof(status->node_status)));
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_walk_versioned_status(const svn_test_opts_t *opts, apr_pool_t *pool)
+{
+  svn_test__sandbox_t b;
+  apr_hash_t *statuses = apr_hash_make(pool);
+  enum svn_wc_status_kind *node_status;
+
+  SVN_ERR(svn_test__sandbox_create(&b, "walk_versioned_status", opts, pool));
+  SVN_ERR(sbox_add_and_commit_greek_tree(&b));
+
+  SVN_ERR(sbox_file_write(&b, "iota", "new iota"));
+  SVN_ERR(sbox_file_write(&b, "A/unversioned", "text"));
+  SVN_ERR(sbox_file_write(&b, "A/B/E/ignored.o", "object"));
+  SVN_ERR(svn_io_make_dir_recursively(sbox_wc_path(&b, "A/D/new"), pool));
+  SVN_ERR(sbox_wc_mkdir(&b, "A/C/added"));
+
+  SVN_ERR(svn_wc__walk_versioned_status(b.wc_ctx, b.wc_abspath,
+                                        svn_depth_infinity, FALSE,
+                                        collect_node_status, statuses,
+                                        NULL, NULL, pool));
+
+  SVN_TEST_INT_ASSERT(apr_hash_count(statuses), 2);
+  node_status = svn_hash_gets(statuses, sbox_wc_path(&b, "iota"));
+  SVN_TEST_ASSERT(node_status && *node_status == svn_wc_status_modified);
+  node_status = svn_hash_gets(statuses, sbox_wc_path(&b, "A/C/added"));
+  SVN_TEST_ASSERT(node_status && *node_status == svn_wc_status_added);
+
+  /* An unversioned target is still reported. */
+  statuses = apr_hash_make(pool);
+  SVN_ERR(svn_wc__walk_versioned_status(b.wc_ctx,
+                                        sbox_wc_path(&b, "A/unversioned"),
+                                        svn_depth_infinity, FALSE,
+                                        collect_node_status, statuses,
+                                        NULL, NULL, pool));
+  SVN_TEST_INT_ASSERT(apr_hash_count(statuses), 1);
+  node_status = svn_hash_gets(statuses, sbox_wc_path(&b, "A/unversioned"));
+  SVN_TEST_ASSERT(node_status && *node_status == svn_wc_status_unversioned);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_update_add_files(const svn_test_opts_t *opts, apr_pool_t *pool)
+{
+  svn_test__sandbox_t b;
+  svn_boolean_t modified;
+  svn_stringbuf_t *contents;
+  const char *tmpdir_abspath;
+  apr_hash_t *dirents;
+
+  SVN_ERR(svn_test__sandbox_create(&b, "update_add_files", opts, pool));
+  SVN_ERR(sbox_add_and_commit_greek_tree(&b));
+  SVN_ERR(sbox_wc_propset(&b, SVN_PROP_EOL_STYLE, "CRLF", "A/mu"));
+  SVN_ERR(sbox_wc_commit(&b, ""));
+
+  /* Let the update editor add all files again, most of them written
+     along with their pristine text. */
+  SVN_ERR(sbox_wc_update(&b, "", 0));
+  SVN_ERR(sbox_wc_update(&b, "", 2));
+
+  SVN_ERR(svn_wc__internal_file_modified_p(&modified, b.wc_ctx->db,
+                                           sbox_wc_path(&b, "iota"), TRUE,
+                                           pool));
+  SVN_TEST_ASSERT(!modified);
+  SVN_ERR(svn_stringbuf_from_file2(&contents, sbox_wc_path(&b, "iota"),
+                                   pool));
+  SVN_TEST_STRING_ASSERT(contents->data, "This is the file 'iota'.\n");
+
+  /* Files that need translation are still installed from the pristine. */
+  SVN_ERR(svn_wc__internal_file_modified_p(&modified, b.wc_ctx->db,
+                                           sbox_wc_path(&b, "A/mu"), TRUE,
+                                           pool));
+  SVN_TEST_ASSERT(!modified);
+  SVN_ERR(svn_stringbuf_from_file2(&contents, sbox_wc_path(&b, "A/mu"),
+                                   pool));
+  SVN_TEST_STRING_ASSERT(contents->data, "This is the file 'mu'.\r\n");
+
+  /* No temporary copies are left behind. */
+  SVN_ERR(svn_wc__db_temp_wcroot_tempdir(&tmpdir_abspath, b.wc_ctx->db,
+                                         b.wc_abspath, pool, pool));
+  SVN_ERR(svn_io_get_dirents3(&dirents, tmpdir_abspath, TRUE, pool, pool));
+  SVN_TEST_INT_ASSERT(apr_hash_count(dirents), 0);
+
+  return SVN_NO_ERROR;
+}
+
 /* ---------------------------------------------------------------------- */
 /* The list of test functions */
 
@@ -515,6 +669,12 @@ static struct svn_test_descriptor_t test_funcs[] =
                        "test legacy commit2"),
     SVN_TEST_OPTS_PASS(test_internal_file_modified,
                        "test internal_file_modified"),
+    SVN_TEST_OPTS_PASS(test_prop_delete_many,
+                       "test svn_wc__prop_delete_many"),
+    SVN_TEST_OPTS_PASS(test_walk_versioned_status,
+                       "test svn_wc__walk_versioned_status"),
+    SVN_TEST_OPTS_PASS(test_update_add_files,
+                       "add files during an update"),
     SVN_TEST_NULL
   };
 
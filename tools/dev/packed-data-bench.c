@@ -0,0 +1,288 @@
+/* packed-data-bench.c -- time svn_packed__*, string tables and the
+ *                         temp serializer
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+/* These are the building blocks of FSX containers and of most cached
+ * objects.  Encode and decode integer streams with value distributions
+ * similar to those found in noderevs and changed paths lists, build
+ * string tables from paths with many duplicates and (de-)serialize the
+ * resulting tables like the membuffer cache does.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <apr_strings.h>
+
+#include "svn_pools.h"
+#include "svn_cmdline.h"
+#include "svn_io.h"
+#include "svn_string.h"
+
+#include "private/svn_packed_data.h"
+#include "private/svn_temp_serializer.h"
+
+#include "../../subversion/libsvn_fs_x/string_table.h"
+
+#include "svn_private_config.h"
+
+/* Value distributions for the integer streams. */
+typedef enum distribution_t
+{
+  /* Single byte values, e.g. node kinds and flags. */
+  dist_small,
+
+  /* Increasing values, e.g. revision numbers.  Stored deltified. */
+  dist_ascending,
+
+  /* Values of up to 20 bits, e.g. item offsets and sizes. */
+  dist_medium,
+
+  /* Arbitrary 64 bit values, e.g. checksums and timestamps. */
+  dist_large
+} distribution_t;
+
+static const char * const distribution_names[] =
+  { "small", "ascending", "medium", "large" };
+
+/* Simple LCG to get reproducible pseudo-random numbers. */
+static apr_uint64_t
+next_random(apr_uint64_t *seed)
+{
+  *seed = *seed * APR_UINT64_C(6364136223846793005)
+        + APR_UINT64_C(1442695040888963407);
+  return *seed;
+}
+
+/* Return the I-th value of distribution DIST.  SEED is the state of the
+ * random number generator. */
+static apr_uint64_t
+make_value(distribution_t dist,
+           int i,
+           apr_uint64_t *seed)
+{
+  switch (dist)
+    {
+      case dist_small:
+        return next_random(seed) >> 58;
+      case dist_ascending:
+        return (apr_uint64_t)i * 3 + (next_random(seed) >> 62);
+      case dist_medium:
+        return next_random(seed) >> 44;
+      default:
+        return next_random(seed);
+    }
+}
+
+/* Add COUNT values of distribution DIST to a new packed data container,
+ * write it, read it back and fetch all values.  Add the time it took to
+ * *WRITE_TIME and *READ_TIME, respectively, and the size of the packed
+ * data to *SIZE.  Use SCRATCH_POOL for all allocations. */
+static svn_error_t *
+bench_packed(apr_interval_time_t *write_time,
+             apr_interval_time_t *read_time,
+             apr_size_t *size,
+             distribution_t dist,
+             int count,
+             apr_pool_t *scratch_pool)
+{
+  svn_stringbuf_t *buffer = svn_stringbuf_create_empty(scratch_pool);
+  svn_packed__data_root_t *root;
+  svn_packed__int_stream_t *stream;
+  apr_uint64_t seed = 0;
+  apr_uint64_t total = 0;
+  apr_time_t start;
+  int i;
+
+  start = apr_time_now();
+  root = svn_packed__data_create_root(scratch_pool);
+  stream = svn_packed__create_int_stream(root, dist == dist_ascending,
+                                         FALSE);
+  for (i = 0; i < count; ++i)
+    svn_packed__add_uint(stream, make_value(dist, i, &seed));
+
+  SVN_ERR(svn_packed__data_write(svn_stream_from_stringbuf(buffer,
+                                                           scratch_pool),
+                                 root, scratch_pool));
+  *write_time += apr_time_now() - start;
+  *size += buffer->len;
+
+  start = apr_time_now();
+  SVN_ERR(svn_packed__data_read(&root,
+                                svn_stream_from_stringbuf(buffer,
+                                                          scratch_pool),
+                                scratch_pool, scratch_pool));
+  stream = svn_packed__first_int_stream(root);
+  for (i = 0; i < count; ++i)
+    total += svn_packed__get_uint(stream);
+
+  /* Use TOTAL such that the loop can't be optimized away. */
+  *read_time += total ? apr_time_now() - start : 0;
+
+  return SVN_NO_ERROR;
+}
+
+/* Root struct for the serialized string table, like the containers have. */
+typedef struct table_holder_t
+{
+  string_table_t *table;
+} table_holder_t;
+
+/* Add COUNT paths, each of them several times, to a string table builder
+ * and create the table.  Then serialize and deserialize it and get all
+ * strings.  Add the respective times to *BUILD_TIME, *SERIALIZE_TIME and
+ * *GET_TIME.  Use SCRATCH_POOL for all allocations. */
+static void
+bench_string_table(apr_interval_time_t *build_time,
+                   apr_interval_time_t *serialize_time,
+                   apr_interval_time_t *get_time,
+                   int count,
+                   apr_pool_t *scratch_pool)
+{
+  apr_size_t *indexes = apr_palloc(scratch_pool, count * sizeof(*indexes));
+  const char **paths = apr_palloc(scratch_pool, count * sizeof(*paths));
+  string_table_builder_t *builder;
+  table_holder_t holder;
+  table_holder_t *copy;
+  svn_temp_serializer__context_t *context;
+  svn_stringbuf_t *serialized;
+  apr_size_t total = 0;
+  apr_time_t start;
+  int i;
+
+  /* Typical changed paths lists have many repeated directory names. */
+  for (i = 0; i < count; ++i)
+    paths[i] = apr_psprintf(scratch_pool, "/trunk/subversion/libsvn_%d/%s",
+                            i % 23, i % 3 ? "include" : "tests");
+
+  start = apr_time_now();
+  builder = svn_fs_x__string_table_builder_create(scratch_pool);
+  for (i = 0; i < count; ++i)
+    indexes[i] = svn_fs_x__string_table_builder_add(builder, paths[i], 0);
+
+  holder.table = svn_fs_x__string_table_create(builder, scratch_pool);
+  *build_time += apr_time_now() - start;
+
+  start = apr_time_now();
+  context = svn_temp_serializer__init(&holder, sizeof(holder), 1024,
+                                      scratch_pool);
+  svn_fs_x__serialize_string_table(context, &holder.table);
+  serialized = svn_temp_serializer__get(context);
+
+  copy = apr_pmemdup(scratch_pool, serialized->data, serialized->len);
+  svn_fs_x__deserialize_string_table(copy, &copy->table);
+  *serialize_time += apr_time_now() - start;
+
+  start = apr_time_now();
+  for (i = 0; i < count; ++i)
+    {
+      apr_size_t len;
+      svn_fs_x__string_table_get(copy->table, indexes[i], &len,
+                                 scratch_pool);
+      total += len;
+    }
+
+  *get_time += total ? apr_time_now() - start : 0;
+}
+
+/* Parse the command line in ARGC, ARGV and run the benchmark.  Use POOL
+ * for allocations.
+ */
+static svn_error_t *
+sub_main(int argc,
+         const char *argv[],
+         apr_pool_t *pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  apr_interval_time_t build_time = 0, serialize_time = 0, get_time = 0;
+  int count = 100000;
+  int iterations = 10;
+  int dist, i;
+
+  if (argc > 1)
+    SVN_ERR(svn_cstring_atoi(&count, argv[1]));
+  if (argc > 2)
+    SVN_ERR(svn_cstring_atoi(&iterations, argv[2]));
+  if (argc > 3 || count < 1 || iterations < 1)
+    return svn_error_create(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
+                            _("Usage: packed-data-bench "
+                              "[COUNT [ITERATIONS]]"));
+
+  SVN_ERR(svn_cmdline_printf(pool, "%d values, %d iterations\n",
+                             count, iterations));
+
+  for (dist = dist_small; dist <= dist_large; ++dist)
+    {
+      apr_interval_time_t write_time = 0, read_time = 0;
+      apr_size_t size = 0;
+
+      for (i = 0; i < iterations; ++i)
+        {
+          svn_pool_clear(iterpool);
+          SVN_ERR(bench_packed(&write_time, &read_time, &size, dist, count,
+                               iterpool));
+        }
+
+      SVN_ERR(svn_cmdline_printf(pool,
+                                 "  packed %-9s   write: %8.3f ms"
+                                 "  read: %8.3f ms  %.2f bytes/value\n",
+                                 distribution_names[dist],
+                                 write_time / 1000.0 / iterations,
+                                 read_time / 1000.0 / iterations,
+                                 (double)size / count / iterations));
+    }
+
+  for (i = 0; i < iterations; ++i)
+    {
+      svn_pool_clear(iterpool);
+      bench_string_table(&build_time, &serialize_time, &get_time, count,
+                         iterpool);
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return svn_cmdline_printf(pool,
+                            "  string table build:     %8.3f ms\n"
+                            "  string table serialize: %8.3f ms\n"
+                            "  string table get:       %8.3f ms\n",
+                            build_time / 1000.0 / iterations,
+                            serialize_time / 1000.0 / iterations,
+                            get_time / 1000.0 / iterations);
+}
+
+int
+main(int argc, const char *argv[])
+{
+  apr_pool_t *pool;
+  svn_error_t *err;
+
+  if (svn_cmdline_init("packed-data-bench", stderr) != EXIT_SUCCESS)
+    return EXIT_FAILURE;
+
+  pool = svn_pool_create(NULL);
+  err = sub_main(argc, argv, pool);
+  if (err)
+    return svn_cmdline_handle_exit_error(err, pool, "packed-data-bench: ");
+
+  svn_pool_destroy(pool);
+  return EXIT_SUCCESS;
+}
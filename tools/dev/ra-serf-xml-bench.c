@@ -0,0 +1,235 @@
+/* ra-serf-xml-bench.c -- measure the XML parser of ra_serf
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+/* Run captured response bodies, e.g. of update-report, log-report or
+ * replay requests, through the ra_serf XML state machine and report the
+ * parser throughput.  The bodies can be captured with any HTTP proxy or
+ * by enabling serf's debug output.
+ *
+ * Every element enters a generic state.  Cdata gets collected and the
+ * closed callback gets invoked for all elements, which is close to what
+ * the report parsers do.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "svn_pools.h"
+#include "svn_cmdline.h"
+#include "svn_dirent_uri.h"
+#include "svn_io.h"
+#include "svn_sorts.h"
+#include "svn_string.h"
+#include "svn_utf.h"
+
+#include "private/svn_sorts_private.h"
+
+#include "../../subversion/libsvn_ra_serf/ra_serf.h"
+
+#include "svn_private_config.h"
+
+/* The states of our transition table.  */
+enum
+{
+  INITIAL = XML_STATE_INITIAL,
+  ELEMENT
+};
+
+static const svn_ra_serf__xml_transition_t bench_ttable[] = {
+  { INITIAL, "", "*", ELEMENT, TRUE, { NULL }, TRUE },
+  { ELEMENT, "", "*", ELEMENT, TRUE, { NULL }, TRUE },
+  { 0 }
+};
+
+/* Statistics of a parser run.  */
+typedef struct bench_baton_t
+{
+  apr_int64_t elements;
+  apr_int64_t cdata_bytes;
+} bench_baton_t;
+
+/* Implements svn_ra_serf__xml_closed_t.  */
+static svn_error_t *
+bench_closed(svn_ra_serf__xml_estate_t *xes,
+             void *baton,
+             int leaving_state,
+             const svn_string_t *cdata,
+             apr_hash_t *attrs,
+             apr_pool_t *scratch_pool)
+{
+  bench_baton_t *bb = baton;
+
+  ++bb->elements;
+  if (cdata)
+    bb->cdata_bytes += cdata->len;
+
+  return SVN_NO_ERROR;
+}
+
+/* Parse BODY once and add the statistics to BB.  Set *DURATION to the
+ * time it took.  Use SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+parse_once(apr_interval_time_t *duration,
+           bench_baton_t *bb,
+           const svn_stringbuf_t *body,
+           apr_pool_t *scratch_pool)
+{
+  svn_ra_serf__xml_context_t *xmlctx;
+  svn_string_t data;
+  apr_time_t start = apr_time_now();
+
+  data.data = body->data;
+  data.len = body->len;
+
+  xmlctx = svn_ra_serf__xml_context_create(bench_ttable, NULL, bench_closed,
+                                           NULL, bb, scratch_pool);
+  SVN_ERR(svn_ra_serf__xml_parse_stream(xmlctx,
+                                        svn_stream_from_string(&data,
+                                                               scratch_pool),
+                                        scratch_pool));
+
+  *duration = apr_time_now() - start;
+  return SVN_NO_ERROR;
+}
+
+/* Implements the comparison function of svn_sort__array.  */
+static int
+compare_durations(const void *lhs,
+                  const void *rhs)
+{
+  apr_interval_time_t a = *(const apr_interval_time_t *)lhs;
+  apr_interval_time_t b = *(const apr_interval_time_t *)rhs;
+
+  return a < b ? -1 : (a > b ? 1 : 0);
+}
+
+/* Parse the file at PATH ITERATIONS times and print the results.  Use
+ * SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+bench_file(const char *path,
+           int iterations,
+           apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  apr_array_header_t *durations
+    = apr_array_make(scratch_pool, iterations, sizeof(apr_interval_time_t));
+  svn_stringbuf_t *body;
+  bench_baton_t bb = { 0 };
+  apr_interval_time_t median;
+  double seconds;
+  int i;
+
+  SVN_ERR(svn_stringbuf_from_file2(&body, path, scratch_pool));
+
+  for (i = 0; i < iterations; ++i)
+    {
+      apr_interval_time_t duration;
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(parse_once(&duration, &bb, body, iterpool));
+      APR_ARRAY_PUSH(durations, apr_interval_time_t) = duration;
+    }
+
+  svn_pool_destroy(iterpool);
+
+  svn_sort__array(durations, compare_durations);
+  median = APR_ARRAY_IDX(durations, iterations / 2, apr_interval_time_t);
+  seconds = median > 0 ? (double)median / APR_USEC_PER_SEC : 1e-6;
+
+  SVN_ERR(svn_cmdline_printf(scratch_pool,
+                             "%s: %" APR_SIZE_T_FMT " bytes, "
+                             "%" APR_INT64_T_FMT " elements, "
+                             "%" APR_INT64_T_FMT " cdata bytes\n"
+                             "  median %.3f ms, min %.3f ms, "
+                             "%.1f MB/s, %.0f elements/s\n",
+                             svn_dirent_local_style(path, scratch_pool),
+                             body->len,
+                             bb.elements / iterations,
+                             bb.cdata_bytes / iterations,
+                             median / 1000.0,
+                             APR_ARRAY_IDX(durations, 0,
+                                           apr_interval_time_t) / 1000.0,
+                             body->len / seconds / 0x100000,
+                             (bb.elements / iterations) / seconds));
+
+  return SVN_NO_ERROR;
+}
+
+/* Parse the command line in ARGC, ARGV and run the benchmark.  Use POOL
+ * for allocations.
+ */
+static svn_error_t *
+sub_main(int argc,
+         const char *argv[],
+         apr_pool_t *pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  int iterations = 10;
+  int i = 1;
+
+  if (argc > 2 && strcmp(argv[1], "-n") == 0)
+    {
+      SVN_ERR(svn_cstring_atoi(&iterations, argv[2]));
+      if (iterations < 1)
+        return svn_error_create(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
+                                _("Number of iterations must be positive"));
+      i = 3;
+    }
+
+  if (i == argc)
+    return svn_error_create(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
+                            _("Usage: ra-serf-xml-bench [-n ITERATIONS] "
+                              "FILE..."));
+
+  for (; i < argc; ++i)
+    {
+      const char *path;
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_utf_cstring_to_utf8(&path, argv[i], iterpool));
+      SVN_ERR(bench_file(svn_dirent_internal_style(path, iterpool),
+                         iterations, iterpool));
+    }
+
+  svn_pool_destroy(iterpool);
+  return SVN_NO_ERROR;
+}
+
+int
+main(int argc, const char *argv[])
+{
+  apr_pool_t *pool;
+  svn_error_t *err;
+
+  if (svn_cmdline_init("ra-serf-xml-bench", stderr) != EXIT_SUCCESS)
+    return EXIT_FAILURE;
+
+  pool = svn_pool_create(NULL);
+  err = sub_main(argc, argv, pool);
+  if (err)
+    return svn_cmdline_handle_exit_error(err, pool, "ra-serf-xml-bench: ");
+
+  svn_pool_destroy(pool);
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,187 @@
+/* string-map-bench.c -- compare svn_string_map__t against apr_hash_t
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+/* Insert, look up and iterate over a set of repository-like paths, once
+ * using an apr_hash_t as created by svn_hash__make and once using an
+ * svn_string_map__t.  This is the access pattern of e.g. folding the
+ * changed paths of a large transaction.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <apr_strings.h>
+
+#include "svn_pools.h"
+#include "svn_cmdline.h"
+#include "svn_hash.h"
+#include "svn_string.h"
+
+#include "private/svn_subr_private.h"
+
+#include "svn_private_config.h"
+
+/* Return COUNT paths of a typical source tree, allocated in POOL. */
+static apr_array_header_t *
+make_paths(int count,
+           apr_pool_t *pool)
+{
+  apr_array_header_t *paths = apr_array_make(pool, count, sizeof(char *));
+  int i;
+
+  for (i = 0; i < count; ++i)
+    APR_ARRAY_PUSH(paths, const char *)
+      = apr_psprintf(pool, "/trunk/subversion/libsvn_%d/dir-%d/file-%d.c",
+                     i % 23, (i / 23) % 41, i);
+
+  return paths;
+}
+
+/* Run the access pattern using an apr_hash_t for PATHS and return the
+ * time it took.  Use SCRATCH_POOL for all allocations. */
+static apr_interval_time_t
+bench_apr_hash(const apr_array_header_t *paths,
+               apr_pool_t *scratch_pool)
+{
+  apr_time_t start = apr_time_now();
+  apr_hash_t *hash = svn_hash__make(scratch_pool);
+  apr_hash_index_t *hi;
+  apr_size_t total = 0;
+  int i;
+
+  for (i = 0; i < paths->nelts; ++i)
+    {
+      const char *path = APR_ARRAY_IDX(paths, i, const char *);
+      apr_size_t len = strlen(path);
+
+      if (!apr_hash_get(hash, path, len))
+        apr_hash_set(hash, apr_pstrmemdup(scratch_pool, path, len), len,
+                     path);
+    }
+
+  for (i = 0; i < paths->nelts; ++i)
+    {
+      const char *path = APR_ARRAY_IDX(paths, i, const char *);
+      total += apr_hash_get(hash, path, strlen(path)) != NULL;
+    }
+
+  for (hi = apr_hash_first(scratch_pool, hash); hi; hi = apr_hash_next(hi))
+    total += apr_hash_this_key_len(hi);
+
+  return total ? apr_time_now() - start : 0;
+}
+
+/* Same as bench_apr_hash but use a svn_string_map__t. */
+static apr_interval_time_t
+bench_string_map(const apr_array_header_t *paths,
+                 apr_pool_t *scratch_pool)
+{
+  apr_time_t start = apr_time_now();
+  svn_string_map__t *map = svn_string_map__create(0, scratch_pool);
+  apr_size_t total = 0;
+  apr_size_t idx = 0;
+  apr_size_t len;
+  int i;
+
+  for (i = 0; i < paths->nelts; ++i)
+    {
+      const char *path = APR_ARRAY_IDX(paths, i, const char *);
+      len = strlen(path);
+
+      if (!svn_string_map__get(map, path, len))
+        svn_string_map__set(map, path, len, (void *)path);
+    }
+
+  for (i = 0; i < paths->nelts; ++i)
+    {
+      const char *path = APR_ARRAY_IDX(paths, i, const char *);
+      total += svn_string_map__get(map, path, strlen(path)) != NULL;
+    }
+
+  while (svn_string_map__next(&idx, NULL, &len, NULL, map))
+    total += len;
+
+  return total ? apr_time_now() - start : 0;
+}
+
+/* Parse the command line in ARGC, ARGV and run the benchmark.  Use POOL
+ * for allocations.
+ */
+static svn_error_t *
+sub_main(int argc,
+         const char *argv[],
+         apr_pool_t *pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  apr_interval_time_t hash_time = 0, map_time = 0;
+  apr_array_header_t *paths;
+  int count = 100000;
+  int iterations = 10;
+  int i;
+
+  if (argc > 1)
+    SVN_ERR(svn_cstring_atoi(&count, argv[1]));
+  if (argc > 2)
+    SVN_ERR(svn_cstring_atoi(&iterations, argv[2]));
+  if (argc > 3 || count < 1 || iterations < 1)
+    return svn_error_create(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
+                            _("Usage: string-map-bench "
+                              "[PATHS [ITERATIONS]]"));
+
+  paths = make_paths(count, pool);
+  for (i = 0; i < iterations; ++i)
+    {
+      svn_pool_clear(iterpool);
+      hash_time += bench_apr_hash(paths, iterpool);
+
+      svn_pool_clear(iterpool);
+      map_time += bench_string_map(paths, iterpool);
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return svn_cmdline_printf(pool,
+                            "%d paths, %d iterations\n"
+                            "  apr_hash_t:        %.3f ms\n"
+                            "  svn_string_map__t: %.3f ms\n",
+                            count, iterations,
+                            hash_time / 1000.0 / iterations,
+                            map_time / 1000.0 / iterations);
+}
+
+int
+main(int argc, const char *argv[])
+{
+  apr_pool_t *pool;
+  svn_error_t *err;
+
+  if (svn_cmdline_init("string-map-bench", stderr) != EXIT_SUCCESS)
+    return EXIT_FAILURE;
+
+  pool = svn_pool_create(NULL);
+  err = sub_main(argc, argv, pool);
+  if (err)
+    return svn_cmdline_handle_exit_error(err, pool, "string-map-bench: ");
+
+  svn_pool_destroy(pool);
+  return EXIT_SUCCESS;
+}